@@ -0,0 +1,455 @@
+#include "BenchmarkRunner.hpp"
+#include "../Engine/Core/Engine.hpp"
+#include "../Engine/Renderer/Renderer.hpp"
+#include "../Engine/Scene/Scene.hpp"
+#include "../Engine/Scene/SceneManager.hpp"
+#include "../Engine/Components/Camera.hpp"
+#include "../Engine/ECS/Entity.hpp"
+#include "../Engine/ECS/Transform.hpp"
+#include "../Engine/Project/Project.hpp"
+#include "../../ThirdParty/nlohmann/json.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#ifdef __APPLE__
+#include <Foundation/Foundation.hpp>
+#endif
+
+namespace Crescent {
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Recorded frames when neither a frame count nor a camera path sets one.
+    constexpr uint32_t kDefaultFrameCount = 600;
+
+    float ElapsedMs(Clock::time_point start, Clock::time_point end) {
+        return std::chrono::duration<float, std::milli>(end - start).count();
+    }
+
+    bool ReadVector3(const nlohmann::json& value, Math::Vector3& out) {
+        if (!value.is_array() || value.size() != 3) {
+            return false;
+        }
+        out = Math::Vector3(value[0].get<float>(), value[1].get<float>(), value[2].get<float>());
+        return true;
+    }
+
+    Math::Vector3 CatmullRom(const Math::Vector3& p0, const Math::Vector3& p1,
+                             const Math::Vector3& p2, const Math::Vector3& p3, float t) {
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+        return (p1 * 2.0f
+                + (p2 - p0) * t
+                + (p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3) * t2
+                + (p1 * 3.0f - p0 - p2 * 3.0f + p3) * t3) * 0.5f;
+    }
+
+    struct Summary {
+        float mean = 0.0f;
+        float p50 = 0.0f;
+        float p95 = 0.0f;
+        float p99 = 0.0f;
+        float max = 0.0f;
+    };
+
+    Summary Summarize(std::vector<float> values) {
+        Summary summary;
+        if (values.empty()) {
+            return summary;
+        }
+        std::sort(values.begin(), values.end());
+        double sum = 0.0;
+        for (float value : values) {
+            sum += value;
+        }
+        auto percentile = [&values](float p) {
+            size_t index = static_cast<size_t>(std::ceil(p * static_cast<float>(values.size()))) - 1;
+            return values[std::min(index, values.size() - 1)];
+        };
+        summary.mean = static_cast<float>(sum / static_cast<double>(values.size()));
+        summary.p50 = percentile(0.5f);
+        summary.p95 = percentile(0.95f);
+        summary.p99 = percentile(0.99f);
+        summary.max = values.back();
+        return summary;
+    }
+
+    nlohmann::json SummaryJson(const Summary& summary) {
+        return {
+            {"mean", summary.mean},
+            {"p50", summary.p50},
+            {"p95", summary.p95},
+            {"p99", summary.p99},
+            {"max", summary.max}
+        };
+    }
+}
+
+bool BenchmarkPath::load(const std::string& path, std::string& error) {
+    m_Keys.clear();
+    m_Input.clear();
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+    nlohmann::json root = nlohmann::json::parse(file, nullptr, false);
+    if (root.is_discarded() || !root.is_object()) {
+        error = path + " is not a JSON object";
+        return false;
+    }
+
+    for (const auto& entry : root.value("keys", nlohmann::json::array())) {
+        Key key;
+        key.time = entry.value("time", 0.0f);
+        if (!entry.contains("position") || !ReadVector3(entry["position"], key.position)) {
+            error = "camera key without a position";
+            return false;
+        }
+        Math::Vector3 euler;
+        if (entry.contains("rotation") && entry["rotation"].is_array() && entry["rotation"].size() == 4) {
+            const auto& q = entry["rotation"];
+            key.rotation = Math::Quaternion(q[0].get<float>(), q[1].get<float>(),
+                                            q[2].get<float>(), q[3].get<float>()).normalized();
+        } else if (entry.contains("euler") && ReadVector3(entry["euler"], euler)) {
+            key.rotation = Math::Quaternion::FromEulerAngles(euler * Math::DEG_TO_RAD);
+        }
+        m_Keys.push_back(key);
+    }
+    std::stable_sort(m_Keys.begin(), m_Keys.end(), [](const Key& a, const Key& b) { return a.time < b.time; });
+
+    for (const auto& entry : root.value("input", nlohmann::json::array())) {
+        InputEvent event;
+        event.time = entry.value("time", 0.0f);
+        if (entry.contains("mouseDelta") && entry["mouseDelta"].is_array() && entry["mouseDelta"].size() == 2) {
+            event.type = InputEvent::Type::MouseMove;
+            event.mouseDelta = Math::Vector2(entry["mouseDelta"][0].get<float>(), entry["mouseDelta"][1].get<float>());
+        } else if (entry.contains("key")) {
+            event.type = InputEvent::Type::Key;
+            event.keyCode = entry["key"].get<unsigned short>();
+            event.pressed = entry.value("pressed", true);
+        } else {
+            error = "input event without a key or mouseDelta";
+            return false;
+        }
+        m_Input.push_back(event);
+    }
+    std::stable_sort(m_Input.begin(), m_Input.end(),
+                     [](const InputEvent& a, const InputEvent& b) { return a.time < b.time; });
+    return true;
+}
+
+void BenchmarkPath::sample(float time, Math::Vector3& outPosition, Math::Quaternion& outRotation) const {
+    if (m_Keys.empty()) {
+        return;
+    }
+    if (time <= m_Keys.front().time || m_Keys.size() == 1) {
+        outPosition = m_Keys.front().position;
+        outRotation = m_Keys.front().rotation;
+        return;
+    }
+    if (time >= m_Keys.back().time) {
+        outPosition = m_Keys.back().position;
+        outRotation = m_Keys.back().rotation;
+        return;
+    }
+    auto upper = std::upper_bound(m_Keys.begin(), m_Keys.end(), time,
+                                  [](float t, const Key& key) { return t < key.time; });
+    const size_t i1 = static_cast<size_t>(upper - m_Keys.begin());
+    const size_t i0 = i1 - 1;
+    const Key& k0 = m_Keys[i0];
+    const Key& k1 = m_Keys[i1];
+    const Key& kPrev = m_Keys[i0 > 0 ? i0 - 1 : i0];
+    const Key& kNext = m_Keys[std::min(i1 + 1, m_Keys.size() - 1)];
+    const float span = k1.time - k0.time;
+    const float t = span > 0.0f ? (time - k0.time) / span : 0.0f;
+    outPosition = CatmullRom(kPrev.position, k0.position, k1.position, kNext.position, t);
+    outRotation = Math::Quaternion::Slerp(k0.rotation, k1.rotation, t);
+}
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkOptions& options)
+    : m_Options(options) {
+}
+
+bool BenchmarkRunner::ApplyPreset(const std::string& preset, Scene* scene) {
+    if (!scene) {
+        return false;
+    }
+    if (preset == "scene") {
+        return true;
+    }
+    SceneSettings settings = scene->getSettings();
+    SceneQualitySettings& quality = settings.quality;
+    ScenePostProcessSettings& post = settings.postProcess;
+    if (preset == "low") {
+        quality.shadowQuality = 0;
+        quality.shadowResolution = 1024;
+        quality.anisotropy = 2;
+        quality.lodBias = 1.0f;
+        quality.textureQuality = 0;
+        quality.ssaoResolution = 2;
+        post.ssao = false;
+        post.ssr = false;
+        post.taa = false;
+        post.fxaa = true;
+        post.motionBlur = false;
+        post.depthOfField = false;
+    } else if (preset == "high") {
+        quality.shadowQuality = 3;
+        quality.shadowResolution = 4096;
+        quality.anisotropy = 16;
+        quality.lodBias = 0.0f;
+        quality.textureQuality = 3;
+        quality.ssaoResolution = 0;
+        post.enabled = true;
+        post.ssao = true;
+        post.ssr = true;
+        post.taa = true;
+        post.fxaa = false;
+        post.bloom = true;
+        post.toneMapping = true;
+    } else {
+        return false;
+    }
+    // Fixed output size and no frame-time feedback, so runs stay comparable.
+    quality.overrideProject = true;
+    quality.msaaSamples = 1;
+    quality.renderScale = 1.0f;
+    quality.upscaler = 0;
+    quality.frameInterpolation = false;
+    quality.dynamicResolution = false;
+    scene->setSettings(settings);
+    scene->applySettings();
+    return true;
+}
+
+int BenchmarkRunner::run(Engine& engine, void* layer) {
+    std::string error;
+    if (!m_Options.pathFile.empty() && !m_Path.load(m_Options.pathFile, error)) {
+        std::cerr << "Benchmark: invalid camera path: " << error << std::endl;
+        return 2;
+    }
+    if (!ProjectManager::getInstance().openProject(m_Options.projectPath)) {
+        std::cerr << "Benchmark: failed to open project " << m_Options.projectPath << std::endl;
+        return 1;
+    }
+    engine.setPipelinedRendering(false);
+    if (!m_Options.pipelineArchivePath.empty()
+        && !engine.getRenderer()->loadPipelineArchive(m_Options.pipelineArchivePath)) {
+        std::cerr << "Benchmark: pipeline archive not loaded; pipelines compile during warmup" << std::endl;
+    }
+
+    SceneManager& sceneManager = SceneManager::getInstance();
+    Scene* scene = sceneManager.getActiveScene();
+    if (!scene) {
+        std::cerr << "Benchmark: no active scene" << std::endl;
+        return 1;
+    }
+    scene->deserialize(m_Options.scenePath);
+    if (!ApplyPreset(m_Options.preset, scene)) {
+        std::cerr << "Benchmark: unknown preset " << m_Options.preset << std::endl;
+        return 2;
+    }
+
+    engine.setGameMetalLayer(layer);
+    engine.resizeGame(static_cast<float>(m_Options.width), static_cast<float>(m_Options.height));
+    sceneManager.setViewMode(SceneManager::ViewMode::Game);
+    sceneManager.enterPlayMode();
+
+    const float dt = m_Options.fixedDeltaTime;
+    uint32_t frameCount = m_Options.frameCount;
+    if (frameCount == 0) {
+        frameCount = m_Path.hasCamera()
+            ? std::max(1u, static_cast<uint32_t>(std::ceil(m_Path.getDuration() / dt)) + 1)
+            : kDefaultFrameCount;
+    }
+    const uint32_t totalFrames = m_Options.warmupFrames + frameCount;
+    m_Frames.clear();
+    m_Frames.reserve(frameCount);
+    m_NextInput = 0;
+
+    float lastPathTime = -1.0f;
+    for (uint32_t i = 0; i < totalFrames; ++i) {
+#ifdef __APPLE__
+        NS::AutoreleasePool* pool = NS::AutoreleasePool::alloc()->init();
+#endif
+        // Warmup holds the path at its start; recorded frames advance it by the fixed step.
+        const bool recording = i >= m_Options.warmupFrames;
+        const float pathTime = recording ? static_cast<float>(i - m_Options.warmupFrames) * dt : 0.0f;
+        if (recording) {
+            applyInput(engine, lastPathTime, pathTime);
+            lastPathTime = pathTime;
+        }
+
+        const Clock::time_point updateStart = Clock::now();
+        engine.update(dt);
+        const Clock::time_point updateEnd = Clock::now();
+
+        if (m_Path.hasCamera()) {
+            if (Camera* camera = sceneManager.getGameCamera()) {
+                Math::Vector3 position;
+                Math::Quaternion rotation;
+                m_Path.sample(pathTime, position, rotation);
+                camera->getEntity()->getTransform()->setPositionAndRotation(position, rotation);
+            }
+        }
+
+        const Clock::time_point renderStart = Clock::now();
+        engine.render();
+        const Clock::time_point renderEnd = Clock::now();
+
+        if (recording) {
+            recordFrame(engine, i - m_Options.warmupFrames, pathTime,
+                        ElapsedMs(updateStart, updateEnd), ElapsedMs(renderStart, renderEnd));
+        }
+#ifdef __APPLE__
+        pool->release();
+#endif
+    }
+
+    if (Renderer* renderer = engine.getRenderer()) {
+        m_PassTimesMs = renderer->getStats().gpuPassTimeMs;
+    }
+    sceneManager.exitPlayMode();
+
+    const std::string csvPath = m_Options.outputPath + ".csv";
+    const std::string jsonPath = m_Options.outputPath + ".json";
+    if (!writeCsv(csvPath) || !writeJson(jsonPath)) {
+        std::cerr << "Benchmark: failed to write " << m_Options.outputPath << ".{csv,json}" << std::endl;
+        return 1;
+    }
+    std::cout << "Benchmark: " << m_Frames.size() << " frames written to " << csvPath << " and " << jsonPath << std::endl;
+    return 0;
+}
+
+void BenchmarkRunner::applyInput(Engine& engine, float fromTime, float toTime) {
+    const auto& input = m_Path.getInput();
+    while (m_NextInput < input.size() && input[m_NextInput].time <= toTime) {
+        const BenchmarkPath::InputEvent& event = input[m_NextInput++];
+        if (event.time <= fromTime) {
+            continue;
+        }
+        if (event.type == BenchmarkPath::InputEvent::Type::MouseMove) {
+            engine.handleMouseMove(event.mouseDelta.x, event.mouseDelta.y);
+        } else if (event.pressed) {
+            engine.handleKeyDown(event.keyCode);
+        } else {
+            engine.handleKeyUp(event.keyCode);
+        }
+    }
+}
+
+void BenchmarkRunner::recordFrame(Engine& engine, uint32_t frame, float time, float updateMs, float renderMs) {
+    FrameSample sample;
+    sample.frame = frame;
+    sample.time = time;
+    sample.cpuUpdateMs = updateMs;
+    sample.cpuRenderMs = renderMs;
+    if (Renderer* renderer = engine.getRenderer()) {
+        const Renderer::RenderStats& stats = renderer->getStats();
+        sample.gpuMs = stats.gpuLastFrameTimeMs;
+        sample.drawCalls = stats.drawCalls;
+        sample.triangles = stats.triangles;
+        sample.instanceVisible = stats.instanceVisible;
+        sample.occlusionOccluded = stats.occlusionOccluded;
+        sample.parallelEncoders = stats.parallelEncoders;
+        sample.shadowPagesRendered = stats.shadowPagesRendered;
+        sample.pipelinesCompiling = stats.pipelinesCompiling;
+        sample.pipelineFallbackDraws = stats.pipelineFallbackDraws;
+        sample.renderScale = stats.renderScale;
+    }
+    m_Frames.push_back(sample);
+}
+
+bool BenchmarkRunner::writeCsv(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "frame,time,cpuUpdateMs,cpuRenderMs,cpuFrameMs,gpuMs,drawCalls,triangles,instanceVisible,"
+            "occlusionOccluded,parallelEncoders,shadowPagesRendered,pipelinesCompiling,pipelineFallbackDraws,renderScale\n";
+    file << std::fixed << std::setprecision(4);
+    for (const FrameSample& sample : m_Frames) {
+        file << sample.frame << ',' << sample.time << ','
+             << sample.cpuUpdateMs << ',' << sample.cpuRenderMs << ','
+             << sample.cpuUpdateMs + sample.cpuRenderMs << ',' << sample.gpuMs << ','
+             << sample.drawCalls << ',' << sample.triangles << ',' << sample.instanceVisible << ','
+             << sample.occlusionOccluded << ',' << sample.parallelEncoders << ','
+             << sample.shadowPagesRendered << ',' << sample.pipelinesCompiling << ','
+             << sample.pipelineFallbackDraws << ',' << sample.renderScale << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+bool BenchmarkRunner::writeJson(const std::string& path) const {
+    std::vector<float> update;
+    std::vector<float> render;
+    std::vector<float> frame;
+    std::vector<float> gpu;
+    update.reserve(m_Frames.size());
+    render.reserve(m_Frames.size());
+    frame.reserve(m_Frames.size());
+    nlohmann::json samples = nlohmann::json::array();
+    for (const FrameSample& sample : m_Frames) {
+        update.push_back(sample.cpuUpdateMs);
+        render.push_back(sample.cpuRenderMs);
+        frame.push_back(sample.cpuUpdateMs + sample.cpuRenderMs);
+        if (sample.gpuMs > 0.0f) {
+            gpu.push_back(sample.gpuMs);
+        }
+        samples.push_back({
+            {"frame", sample.frame},
+            {"time", sample.time},
+            {"cpuUpdateMs", sample.cpuUpdateMs},
+            {"cpuRenderMs", sample.cpuRenderMs},
+            {"gpuMs", sample.gpuMs},
+            {"drawCalls", sample.drawCalls},
+            {"triangles", sample.triangles},
+            {"instanceVisible", sample.instanceVisible},
+            {"occlusionOccluded", sample.occlusionOccluded},
+            {"parallelEncoders", sample.parallelEncoders},
+            {"shadowPagesRendered", sample.shadowPagesRendered},
+            {"pipelinesCompiling", sample.pipelinesCompiling},
+            {"pipelineFallbackDraws", sample.pipelineFallbackDraws},
+            {"renderScale", sample.renderScale}
+        });
+    }
+
+    nlohmann::json passes = nlohmann::json::object();
+    for (size_t pass = 0; pass < kGPUPassCount; ++pass) {
+        passes[GPUPassName(static_cast<GPUPass>(pass))] = m_PassTimesMs[pass];
+    }
+
+    nlohmann::json root = {
+        {"scene", m_Options.scenePath},
+        {"path", m_Options.pathFile},
+        {"preset", m_Options.preset},
+        {"width", m_Options.width},
+        {"height", m_Options.height},
+        {"fixedDeltaTime", m_Options.fixedDeltaTime},
+        {"warmupFrames", m_Options.warmupFrames},
+        {"frames", m_Frames.size()},
+        {"summary", {
+            {"cpuUpdateMs", SummaryJson(Summarize(update))},
+            {"cpuRenderMs", SummaryJson(Summarize(render))},
+            {"cpuFrameMs", SummaryJson(Summarize(frame))},
+            {"gpuMs", SummaryJson(Summarize(gpu))}
+        }},
+        // Smoothed over the last frames of the run.
+        {"gpuPassMs", passes},
+        {"samples", samples}
+    };
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << root.dump(2);
+    return static_cast<bool>(file);
+}
+
+} // namespace Crescent
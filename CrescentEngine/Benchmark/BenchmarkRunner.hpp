@@ -0,0 +1,112 @@
+#pragma once
+
+#include "../Engine/Math/Math.hpp"
+#include "../Engine/Renderer/GPUPassProfiler.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Crescent {
+
+class Engine;
+class Scene;
+
+// Recorded camera and input track for a benchmark run, read from JSON:
+//   { "keys":  [ { "time": 0.0, "position": [x, y, z], "rotation": [x, y, z, w] }, ... ],
+//     "input": [ { "time": 1.5, "key": 13, "pressed": true },
+//                { "time": 2.0, "mouseDelta": [dx, dy] }, ... ] }
+// A key may give "euler": [pitch, yaw, roll] in degrees instead of "rotation". Positions follow a
+// Catmull-Rom curve through the keys and rotations are slerped. Key codes are macOS virtual key
+// codes, as the player forwards them. Input events fire on the first frame at or past their time.
+class BenchmarkPath {
+public:
+    struct Key {
+        float time = 0.0f;
+        Math::Vector3 position = Math::Vector3::Zero;
+        Math::Quaternion rotation = Math::Quaternion::Identity;
+    };
+    struct InputEvent {
+        enum class Type : uint8_t { Key, MouseMove };
+        float time = 0.0f;
+        Type type = Type::Key;
+        unsigned short keyCode = 0;
+        bool pressed = false;
+        Math::Vector2 mouseDelta = Math::Vector2::Zero;
+    };
+
+    bool load(const std::string& path, std::string& error);
+
+    bool hasCamera() const { return !m_Keys.empty(); }
+    float getDuration() const { return m_Keys.empty() ? 0.0f : m_Keys.back().time; }
+    void sample(float time, Math::Vector3& outPosition, Math::Quaternion& outRotation) const;
+    const std::vector<InputEvent>& getInput() const { return m_Input; }
+
+private:
+    std::vector<Key> m_Keys;
+    std::vector<InputEvent> m_Input; // sorted by time
+};
+
+struct BenchmarkOptions {
+    std::string projectPath;
+    std::string scenePath; // cooked runtime scene
+    std::string pathFile; // optional BenchmarkPath; without it the scene's own cameras run
+    std::string pipelineArchivePath;
+    std::string outputPath; // <outputPath>.csv and <outputPath>.json
+    std::string preset = "high"; // "low", "high" or "scene" to keep the scene's quality settings
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    float fixedDeltaTime = 1.0f / 60.0f;
+    uint32_t warmupFrames = 120; // rendered but not recorded: pipeline compiles, streaming
+    uint32_t frameCount = 0; // recorded frames; 0 covers the camera path once
+};
+
+// Plays a cooked scene through Engine::update/render at a fixed timestep into a caller-provided
+// offscreen layer, and records per-frame CPU times, the GPU time of the game view and the render
+// stats. GPU times land when their command buffer has finished, a few frames after the CPU work
+// of the same frame, so per-frame GPU columns are shifted by the frames in flight; summaries are
+// unaffected. Rendering is kept serial (no pipelined frames) so CPU update and render times are
+// separable.
+class BenchmarkRunner {
+public:
+    struct FrameSample {
+        uint32_t frame = 0;
+        float time = 0.0f;
+        float cpuUpdateMs = 0.0f;
+        float cpuRenderMs = 0.0f;
+        float gpuMs = 0.0f; // game view GPU time that finished this frame, 0 if none did
+        uint32_t drawCalls = 0;
+        uint32_t triangles = 0;
+        uint32_t instanceVisible = 0;
+        uint32_t occlusionOccluded = 0;
+        uint32_t parallelEncoders = 0;
+        uint32_t shadowPagesRendered = 0;
+        uint32_t pipelinesCompiling = 0;
+        uint32_t pipelineFallbackDraws = 0;
+        float renderScale = 1.0f;
+    };
+
+    explicit BenchmarkRunner(const BenchmarkOptions& options);
+
+    // layer is a CA::MetalLayer the renderer may draw into; it is never presented on screen.
+    // Returns a process exit code; failures are reported on stderr.
+    int run(Engine& engine, void* layer);
+
+    // Quality preset by name; false for unknown names.
+    static bool ApplyPreset(const std::string& preset, Scene* scene);
+
+private:
+    void applyInput(Engine& engine, float fromTime, float toTime);
+    void recordFrame(Engine& engine, uint32_t frame, float time, float updateMs, float renderMs);
+    bool writeCsv(const std::string& path) const;
+    bool writeJson(const std::string& path) const;
+
+    BenchmarkOptions m_Options;
+    BenchmarkPath m_Path;
+    std::vector<FrameSample> m_Frames;
+    // Smoothed GPU pass times at the end of the run.
+    std::array<float, kGPUPassCount> m_PassTimesMs{};
+    size_t m_NextInput = 0;
+};
+
+} // namespace Crescent
@@ -0,0 +1,504 @@
+#include "KernelBenchmarks.hpp"
+#include "../Engine/Animation/AnimationClip.hpp"
+#include "../Engine/Animation/AnimationPose.hpp"
+#include "../Engine/Animation/Skeleton.hpp"
+#include "../Engine/Core/JobSystem.hpp"
+#include "../Engine/Core/TaskGraph.hpp"
+#include "../Engine/ECS/Entity.hpp"
+#include "../Engine/ECS/Transform.hpp"
+#include "../Engine/Math/Frustum.hpp"
+#include "../Engine/Math/Math.hpp"
+#include "../Engine/Rendering/Mesh.hpp"
+#include "../Engine/Scene/Scene.hpp"
+#include "../Engine/Scene/SceneSerializer.hpp"
+#include "../../ThirdParty/basisu/transcoder/basisu_transcoder.h"
+#include "../../ThirdParty/nlohmann/json.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace Crescent {
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t kMatrixCount = 1024; // power of two, indexed with a mask
+    constexpr size_t kSphereCount = 65536;
+    constexpr size_t kCullGrain = 1024;
+    constexpr uint32_t kBoneCounts[] = {32, 64, 128, 256};
+    constexpr uint32_t kClipKeys = 31; // one second at 30 ticks per second
+    constexpr size_t kJobsPerBatch = 64;
+    constexpr size_t kGraphFanOut = 14;
+    constexpr uint32_t kSceneEntities = 2048;
+
+    // Keeps the compiler from discarding a result the loop never reads.
+    template <typename T>
+    inline void KeepAlive(const T& value) {
+        asm volatile("" : : "r"(&value) : "memory");
+    }
+
+    double ElapsedSeconds(Clock::time_point start, Clock::time_point end) {
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    Math::Quaternion RandomRotation(std::mt19937& rng) {
+        std::uniform_real_distribution<float> angle(-Math::PI, Math::PI);
+        return Math::Quaternion::FromEulerAngles(Math::Vector3(angle(rng), angle(rng), angle(rng)));
+    }
+
+    Math::Matrix4x4 RandomTransform(std::mt19937& rng) {
+        std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+        std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+        return Math::Matrix4x4::TRS(Math::Vector3(position(rng), position(rng), position(rng)),
+                                    RandomRotation(rng),
+                                    Math::Vector3(scale(rng), scale(rng), scale(rng)));
+    }
+
+    // A binary tree of bones with every channel keyed, the worst case for sampling.
+    void BuildSyntheticRig(uint32_t boneCount, std::mt19937& rng, Skeleton& skeleton, AnimationClip& clip) {
+        const Math::Vector3 offset(0.0f, 0.1f, 0.0f);
+        for (uint32_t bone = 0; bone < boneCount; ++bone) {
+            const int parent = bone == 0 ? -1 : static_cast<int>((bone - 1) / 2);
+            skeleton.addBone("Bone" + std::to_string(bone), parent,
+                             Math::Matrix4x4::Translate(offset), Math::Matrix4x4::Identity);
+        }
+
+        clip.setName("Synthetic");
+        clip.setTicksPerSecond(30.0f);
+        clip.setDurationTicks(static_cast<float>(kClipKeys - 1));
+        std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+        for (uint32_t bone = 0; bone < boneCount; ++bone) {
+            AnimationChannel channel;
+            channel.boneName = "Bone" + std::to_string(bone);
+            for (uint32_t key = 0; key < kClipKeys; ++key) {
+                const float time = static_cast<float>(key);
+                channel.positionKeys.push_back({time, offset + Math::Vector3(jitter(rng), jitter(rng), jitter(rng))});
+                channel.rotationKeys.push_back({time, RandomRotation(rng)});
+                channel.scaleKeys.push_back({time, Math::Vector3::One});
+            }
+            clip.addChannel(channel);
+        }
+        clip.rebindToSkeleton(skeleton);
+    }
+
+    // Starts the shared scheduler with threads - 1 workers for the lifetime of the scope.
+    class ScopedWorkers {
+    public:
+        explicit ScopedWorkers(uint32_t threads) {
+            if (threads > 1) {
+                m_Jobs.start(threads - 1);
+            }
+        }
+        JobSystem& jobs() { return m_Jobs; }
+
+    private:
+        JobSystem m_Jobs;
+    };
+}
+
+KernelBenchmarks::KernelBenchmarks(const KernelBenchmarkOptions& options)
+    : m_Options(options) {
+    if (m_Options.threadCounts.empty()) {
+        m_Options.threadCounts.push_back(1);
+    }
+}
+
+int KernelBenchmarks::run() {
+    runMath();
+    runCulling();
+    runAnimation();
+    runJobs();
+    runMeshDecode();
+    runSceneDecode();
+    runTextureTranscode();
+
+    if (m_Results.empty()) {
+        std::cerr << "No kernel matches \"" << m_Options.filter << "\"" << std::endl;
+        return 1;
+    }
+    if (!m_Options.outputPath.empty() && !writeJson(m_Options.outputPath)) {
+        std::cerr << "Failed to write " << m_Options.outputPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+bool KernelBenchmarks::selected(const std::string& name) const {
+    return m_Options.filter.empty() || name.find(m_Options.filter) != std::string::npos;
+}
+
+void KernelBenchmarks::measure(const std::string& name, const std::string& unit, uint32_t threads, const Body& body) {
+    // Doubles the iterations until one run is long enough to time, then scales to minSeconds.
+    uint64_t iterations = 1;
+    double seconds = 0.0;
+    const double calibrationSeconds = m_Options.minSeconds * 0.1;
+    for (;;) {
+        const Clock::time_point start = Clock::now();
+        body(iterations);
+        seconds = ElapsedSeconds(start, Clock::now());
+        if (seconds >= calibrationSeconds || iterations >= (1ull << 40)) {
+            break;
+        }
+        iterations *= 2;
+    }
+    if (seconds > 0.0) {
+        iterations = std::max<uint64_t>(1, static_cast<uint64_t>(iterations * m_Options.minSeconds / seconds));
+    }
+
+    std::vector<double> nsPerOp;
+    uint64_t ops = 0;
+    for (uint32_t repetition = 0; repetition < kRepetitions; ++repetition) {
+        const Clock::time_point start = Clock::now();
+        ops = body(iterations);
+        const double elapsed = ElapsedSeconds(start, Clock::now());
+        nsPerOp.push_back(ops > 0 ? elapsed * 1e9 / static_cast<double>(ops) : 0.0);
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+
+    Result result;
+    result.name = name;
+    result.unit = unit;
+    result.threads = threads;
+    result.opsPerRepetition = ops;
+    result.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+    result.minNsPerOp = nsPerOp.front();
+    std::printf("%-36s %3u thr %14.2f ns/%-8s (min %.2f)\n", name.c_str(), threads, result.nsPerOp,
+                unit.c_str(), result.minNsPerOp);
+    std::fflush(stdout);
+    m_Results.push_back(result);
+}
+
+void KernelBenchmarks::runMath() {
+    std::mt19937 rng(1);
+    std::vector<Math::Matrix4x4> a(kMatrixCount);
+    std::vector<Math::Matrix4x4> b(kMatrixCount);
+    std::vector<Math::Matrix4x4> out(kMatrixCount);
+    for (size_t i = 0; i < kMatrixCount; ++i) {
+        a[i] = RandomTransform(rng);
+        b[i] = RandomTransform(rng);
+    }
+
+    if (selected("math.multiply")) {
+        measure("math.multiply", "matrix", 1, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const size_t index = i & (kMatrixCount - 1);
+                out[index] = a[index] * b[(index + 1) & (kMatrixCount - 1)];
+            }
+            KeepAlive(out);
+            return iterations;
+        });
+    }
+    if (selected("math.inverse")) {
+        measure("math.inverse", "matrix", 1, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const size_t index = i & (kMatrixCount - 1);
+                out[index] = a[index].inversed();
+            }
+            KeepAlive(out);
+            return iterations;
+        });
+    }
+    if (selected("math.inverseAffine")) {
+        measure("math.inverseAffine", "matrix", 1, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const size_t index = i & (kMatrixCount - 1);
+                out[index] = a[index].inversedAffine();
+            }
+            KeepAlive(out);
+            return iterations;
+        });
+    }
+}
+
+void KernelBenchmarks::runCulling() {
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> radius(0.5f, 5.0f);
+    std::vector<Math::Vector4> spheres(kSphereCount);
+    for (Math::Vector4& sphere : spheres) {
+        sphere = Math::Vector4(position(rng), position(rng), position(rng), radius(rng));
+    }
+    std::vector<uint8_t> visible(kSphereCount);
+    const Math::Matrix4x4 view = Math::Matrix4x4::LookAt(Math::Vector3(0.0f, 10.0f, 0.0f),
+                                                         Math::Vector3(100.0f, 0.0f, -100.0f),
+                                                         Math::Vector3::Up);
+    const Math::Matrix4x4 projection = Math::Matrix4x4::Perspective(Math::PI / 3.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    const Math::FrustumPlanes planes = Math::ExtractFrustumPlanes(projection * view);
+
+    if (selected("cull.sphere")) {
+        measure("cull.sphere", "sphere", 1, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                for (size_t s = 0; s < kSphereCount; ++s) {
+                    const Math::Vector4& sphere = spheres[s];
+                    visible[s] = Math::IsSphereInFrustum(planes, Math::Vector3(sphere.x, sphere.y, sphere.z), sphere.w) ? 1 : 0;
+                }
+            }
+            KeepAlive(visible);
+            return iterations * kSphereCount;
+        });
+    }
+    if (selected("cull.spheresMany")) {
+        measure("cull.spheresMany", "sphere", 1, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                Math::SpheresInFrustumMany(planes, spheres.data(), kSphereCount, visible.data());
+            }
+            KeepAlive(visible);
+            return iterations * kSphereCount;
+        });
+    }
+    if (selected("cull.parallelFor")) {
+        for (uint32_t threads : m_Options.threadCounts) {
+            ScopedWorkers workers(threads);
+            TaskGraph graph;
+            graph.addParallelFor("Cull", []() { return kSphereCount; },
+                                 [&](size_t begin, size_t end) {
+                                     Math::SpheresInFrustumMany(planes, spheres.data() + begin, end - begin,
+                                                                visible.data() + begin);
+                                 },
+                                 kCullGrain);
+            graph.compile();
+            measure("cull.parallelFor", "sphere", threads, [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    workers.jobs().wait(graph.run(workers.jobs()));
+                }
+                KeepAlive(visible);
+                return iterations * kSphereCount;
+            });
+        }
+    }
+}
+
+void KernelBenchmarks::runAnimation() {
+    const bool sample = selected("anim.sampleLocalPose");
+    const bool skin = selected("anim.buildSkinMatrices");
+    if (!sample && !skin) {
+        return;
+    }
+    std::mt19937 rng(3);
+    for (uint32_t boneCount : kBoneCounts) {
+        Skeleton skeleton;
+        AnimationClip clip;
+        BuildSyntheticRig(boneCount, rng, skeleton, clip);
+        AnimationLocalPose pose;
+        AnimationSampleCursor cursor;
+        std::vector<Math::Matrix4x4> skinMatrices;
+        const std::string suffix = "/" + std::to_string(boneCount);
+
+        // Time advances a frame per sample, as an animator playing the clip does.
+        float time = 0.0f;
+        if (sample) {
+            measure("anim.sampleLocalPose" + suffix, "pose", 1, [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    SampleLocalPose(skeleton, &clip, time, true, pose, &cursor);
+                    time += 1.0f / 60.0f;
+                }
+                KeepAlive(pose);
+                return iterations;
+            });
+        }
+        if (skin) {
+            SampleLocalPose(skeleton, &clip, 0.5f, true, pose, &cursor);
+            measure("anim.buildSkinMatrices" + suffix, "pose", 1, [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    BuildSkinMatrices(skeleton, pose, skinMatrices);
+                }
+                KeepAlive(skinMatrices);
+                return iterations;
+            });
+        }
+    }
+}
+
+void KernelBenchmarks::runJobs() {
+    const bool submit = selected("jobs.submitWait");
+    const bool graphRun = selected("taskgraph.run");
+    if (!submit && !graphRun) {
+        return;
+    }
+    for (uint32_t threads : m_Options.threadCounts) {
+        ScopedWorkers workers(threads);
+        JobSystem& jobs = workers.jobs();
+        std::atomic<uint64_t> counter{0};
+
+        if (submit) {
+            // Empty jobs: what is left is queueing, stealing and the fence.
+            measure("jobs.submitWait", "job", threads, [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    JobSystem::JobHandle handle = jobs.createHandle();
+                    for (size_t job = 0; job < kJobsPerBatch; ++job) {
+                        jobs.submit([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); }, handle);
+                    }
+                    jobs.wait(handle);
+                }
+                return iterations * kJobsPerBatch;
+            });
+        }
+        if (graphRun) {
+            // Root, a fan of independent tasks, and a sink: the shape of the frame graph.
+            TaskGraph graph;
+            auto body = [&counter]() { counter.fetch_add(1, std::memory_order_relaxed); };
+            const TaskGraph::TaskId root = graph.addTask("Root", body);
+            const TaskGraph::TaskId sink = graph.addTask("Sink", body);
+            for (size_t task = 0; task < kGraphFanOut; ++task) {
+                const TaskGraph::TaskId id = graph.addTask("Fan" + std::to_string(task), body);
+                graph.addDependency(id, root);
+                graph.addDependency(sink, id);
+            }
+            graph.compile();
+            measure("taskgraph.run", "graph", threads, [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    jobs.wait(graph.run(jobs));
+                }
+                return iterations;
+            });
+        }
+        KeepAlive(counter);
+    }
+}
+
+void KernelBenchmarks::runMeshDecode() {
+    const bool compressed = selected("mesh.decodeCompressed");
+    const bool gpuLayout = selected("mesh.decodeGpuLayout");
+    if (!compressed && !gpuLayout) {
+        return;
+    }
+    std::shared_ptr<Mesh> mesh = Mesh::CreateSphere(0.5f, 256, 128);
+    const uint64_t vertexCount = mesh->getVertices().size();
+
+    auto decode = [&](const std::string& name, bool layout) {
+        const std::vector<uint8_t> bytes = SceneSerializer::SerializeCookedMesh(*mesh, layout);
+        if (bytes.empty()) {
+            std::cerr << name << ": cooked mesh encoding is unavailable in this build" << std::endl;
+            return;
+        }
+        measure(name, "vertex", 1, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                std::shared_ptr<Mesh> decoded = SceneSerializer::DeserializeCookedMesh(bytes);
+                KeepAlive(decoded);
+            }
+            return iterations * vertexCount;
+        });
+    };
+    if (compressed) {
+        decode("mesh.decodeCompressed", false);
+    }
+    if (gpuLayout) {
+        decode("mesh.decodeGpuLayout", true);
+    }
+}
+
+void KernelBenchmarks::runSceneDecode() {
+    if (!selected("scene.deserializeBinary")) {
+        return;
+    }
+    // Chains of eight under each root, so parenting is part of the cost.
+    Scene scene("KernelBenchmark");
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    Entity* parent = nullptr;
+    for (uint32_t i = 0; i < kSceneEntities; ++i) {
+        Entity* entity = scene.createEntity("Entity" + std::to_string(i));
+        Transform* transform = entity->getTransform();
+        if (parent && i % 8 != 0) {
+            transform->setParent(parent->getTransform(), false);
+        }
+        transform->setLocalPosition(Math::Vector3(position(rng), position(rng), position(rng)));
+        transform->setLocalRotation(RandomRotation(rng));
+        parent = entity;
+    }
+    const std::vector<uint8_t> bytes = SceneSerializer::SerializeCookedRuntimeSceneBinary(&scene);
+    if (bytes.empty()) {
+        std::cerr << "scene.deserializeBinary: failed to encode the synthetic scene" << std::endl;
+        return;
+    }
+
+    // Deserializing replaces the scene's entities, so one scene is reused.
+    measure("scene.deserializeBinary", "entity", 1, [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            SceneSerializer::DeserializeSceneBinary(&scene, bytes);
+        }
+        return iterations * kSceneEntities;
+    });
+}
+
+void KernelBenchmarks::runTextureTranscode() {
+    const bool astc = selected("texture.transcodeASTC");
+    const bool bc7 = selected("texture.transcodeBC7");
+    if ((!astc && !bc7) || m_Options.ktx2Path.empty()) {
+        return;
+    }
+    std::ifstream file(m_Options.ktx2Path, std::ios::binary);
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    basist::basisu_transcoder_init();
+    basist::ktx2_transcoder transcoder;
+    if (bytes.empty() || !transcoder.init(bytes.data(), static_cast<uint32_t>(bytes.size()))
+        || !transcoder.start_transcoding()) {
+        std::cerr << "Invalid KTX2 file: " << m_Options.ktx2Path << std::endl;
+        return;
+    }
+
+    // Every level of layer 0, face 0, as the texture loader uploads them.
+    const uint32_t levels = std::max(1u, transcoder.get_levels());
+    uint64_t texels = 0;
+    for (uint32_t level = 0; level < levels; ++level) {
+        basist::ktx2_image_level_info info{};
+        if (transcoder.get_image_level_info(info, level, 0, 0)) {
+            texels += static_cast<uint64_t>(info.m_orig_width) * info.m_orig_height;
+        }
+    }
+    std::vector<uint8_t> blocks;
+    auto transcode = [&](const std::string& name, basist::transcoder_texture_format format) {
+        const uint32_t bytesPerBlock = basist::basis_get_bytes_per_block_or_pixel(format);
+        measure(name, "texel", 1, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                for (uint32_t level = 0; level < levels; ++level) {
+                    basist::ktx2_image_level_info info{};
+                    transcoder.get_image_level_info(info, level, 0, 0);
+                    const uint32_t blockCount = std::max(1u, info.m_num_blocks_x * info.m_num_blocks_y);
+                    blocks.resize(static_cast<size_t>(blockCount) * bytesPerBlock);
+                    transcoder.transcode_image_level(level, 0, 0, blocks.data(), blockCount, format, 0,
+                                                     info.m_num_blocks_x);
+                }
+            }
+            KeepAlive(blocks);
+            return iterations * texels;
+        });
+    };
+    if (astc) {
+        transcode("texture.transcodeASTC", basist::transcoder_texture_format::cTFASTC_LDR_4x4_RGBA);
+    }
+    if (bc7) {
+        transcode("texture.transcodeBC7", basist::transcoder_texture_format::cTFBC7_RGBA);
+    }
+}
+
+bool KernelBenchmarks::writeJson(const std::string& path) const {
+    nlohmann::json results = nlohmann::json::array();
+    for (const Result& result : m_Results) {
+        results.push_back({
+            {"name", result.name},
+            {"unit", result.unit},
+            {"threads", result.threads},
+            {"opsPerRepetition", result.opsPerRepetition},
+            {"nsPerOp", result.nsPerOp},
+            {"minNsPerOp", result.minNsPerOp}
+        });
+    }
+    nlohmann::json root = {
+        {"repetitions", kRepetitions},
+        {"minSeconds", m_Options.minSeconds},
+        {"results", results}
+    };
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << root.dump(2) << std::endl;
+    return static_cast<bool>(file);
+}
+
+} // namespace Crescent
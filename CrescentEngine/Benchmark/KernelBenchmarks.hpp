@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Crescent {
+
+struct KernelBenchmarkOptions {
+    std::string filter; // substring of the kernel names to run; empty runs all
+    std::vector<uint32_t> threadCounts = {1, 2, 4, 8}; // for the kernels that scale with threads
+    std::string ktx2Path; // texture.transcode kernels only run with a KTX2 file to decode
+    std::string outputPath; // optional JSON report
+    double minSeconds = 0.2; // per repetition; each kernel runs kRepetitions of these
+};
+
+// Timed loops over the engine's hot CPU kernels on synthetic data: matrix math, frustum culling,
+// pose sampling and skinning, job and task graph overhead, cooked mesh and scene decoding, and
+// texture transcoding. Each kernel is calibrated to run for minSeconds, repeated, and reported as
+// the median nanoseconds per operation, where the unit of an operation is named in the output.
+// Kernels that depend on the job scheduler run once per thread count; a thread count of N is the
+// calling thread plus N - 1 workers, and 1 runs every job inline. The scheduler must not be in use
+// by anything else, so this runs without an initialized engine.
+class KernelBenchmarks {
+public:
+    static constexpr uint32_t kRepetitions = 5;
+
+    struct Result {
+        std::string name;
+        std::string unit;
+        uint32_t threads = 1;
+        uint64_t opsPerRepetition = 0;
+        double nsPerOp = 0.0;
+        double minNsPerOp = 0.0;
+    };
+
+    explicit KernelBenchmarks(const KernelBenchmarkOptions& options);
+
+    // Returns a process exit code; failures are reported on stderr.
+    int run();
+
+private:
+    // Runs the kernel `iterations` times and returns the operations it performed.
+    using Body = std::function<uint64_t(uint64_t iterations)>;
+
+    bool selected(const std::string& name) const;
+    void measure(const std::string& name, const std::string& unit, uint32_t threads, const Body& body);
+
+    void runMath();
+    void runCulling();
+    void runAnimation();
+    void runJobs();
+    void runMeshDecode();
+    void runSceneDecode();
+    void runTextureTranscode();
+
+    bool writeJson(const std::string& path) const;
+
+    KernelBenchmarkOptions m_Options;
+    std::vector<Result> m_Results;
+};
+
+} // namespace Crescent
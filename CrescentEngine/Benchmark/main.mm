@@ -0,0 +1,155 @@
+#import <Foundation/Foundation.h>
+#import <QuartzCore/QuartzCore.h>
+
+#include "BenchmarkRunner.hpp"
+#include "KernelBenchmarks.hpp"
+#include "../Engine/Core/CPUProfiler.hpp"
+#include "../Engine/Core/Engine.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+void PrintUsage() {
+    fputs("Usage: CrescentBenchmark <Project.cproj> <Scene.ccscene> --output <prefix>\n"
+          "         [--path <CameraPath.json>] [--preset low|high|scene]\n"
+          "         [--width <px>] [--height <px>] [--frames <n>] [--warmup <n>] [--dt <seconds>]\n"
+          "         [--pipelines <Pipelines.metalarchive>] [--trace <Trace.json>]\n"
+          "       CrescentBenchmark --kernels [--filter <name>] [--threads 1,2,4,8]\n"
+          "         [--ktx2 <Texture.ktx2>] [--seconds <per repetition>] [--output <Results.json>]\n", stderr);
+}
+
+int RunKernels(int argc, const char* argv[]) {
+    Crescent::KernelBenchmarkOptions options;
+    for (int i = 2; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (i + 1 >= argc) {
+            PrintUsage();
+            return 2;
+        }
+        const char* value = argv[++i];
+        if (std::strcmp(arg, "--filter") == 0) {
+            options.filter = value;
+        } else if (std::strcmp(arg, "--threads") == 0) {
+            options.threadCounts.clear();
+            for (const char* cursor = value; *cursor;) {
+                char* end = nullptr;
+                const unsigned long threads = std::strtoul(cursor, &end, 10);
+                if (end == cursor || threads == 0) {
+                    PrintUsage();
+                    return 2;
+                }
+                options.threadCounts.push_back(static_cast<uint32_t>(threads));
+                cursor = *end == ',' ? end + 1 : end;
+            }
+        } else if (std::strcmp(arg, "--ktx2") == 0) {
+            options.ktx2Path = value;
+        } else if (std::strcmp(arg, "--seconds") == 0) {
+            options.minSeconds = std::strtod(value, nullptr);
+        } else if (std::strcmp(arg, "--output") == 0) {
+            options.outputPath = value;
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (!(options.minSeconds > 0.0)) {
+        PrintUsage();
+        return 2;
+    }
+    // No engine: the kernels own the job scheduler and need no GPU.
+    Crescent::KernelBenchmarks kernels(options);
+    return kernels.run();
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    @autoreleasepool {
+        if (argc >= 2 && std::strcmp(argv[1], "--kernels") == 0) {
+            return RunKernels(argc, argv);
+        }
+        if (argc < 3) {
+            PrintUsage();
+            return 2;
+        }
+
+        Crescent::BenchmarkOptions options;
+        options.projectPath = argv[1];
+        options.scenePath = argv[2];
+        std::string tracePath;
+        for (int i = 3; i < argc; ++i) {
+            const char* arg = argv[i];
+            if (i + 1 >= argc) {
+                PrintUsage();
+                return 2;
+            }
+            const char* value = argv[++i];
+            if (std::strcmp(arg, "--output") == 0) {
+                options.outputPath = value;
+            } else if (std::strcmp(arg, "--path") == 0) {
+                options.pathFile = value;
+            } else if (std::strcmp(arg, "--preset") == 0) {
+                options.preset = value;
+            } else if (std::strcmp(arg, "--width") == 0) {
+                options.width = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            } else if (std::strcmp(arg, "--height") == 0) {
+                options.height = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            } else if (std::strcmp(arg, "--frames") == 0) {
+                options.frameCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            } else if (std::strcmp(arg, "--warmup") == 0) {
+                options.warmupFrames = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            } else if (std::strcmp(arg, "--dt") == 0) {
+                options.fixedDeltaTime = std::strtof(value, nullptr);
+            } else if (std::strcmp(arg, "--pipelines") == 0) {
+                options.pipelineArchivePath = value;
+            } else if (std::strcmp(arg, "--trace") == 0) {
+                tracePath = value;
+            } else {
+                PrintUsage();
+                return 2;
+            }
+        }
+        if (options.outputPath.empty() || options.width == 0 || options.height == 0
+            || !(options.fixedDeltaTime > 0.0f)) {
+            PrintUsage();
+            return 2;
+        }
+
+        // A built game's GameData runs from its cooked content only, as the player does.
+        NSString* projectDir = [[NSString stringWithUTF8String:options.projectPath.c_str()] stringByDeletingLastPathComponent];
+        NSString* manifestPath = [projectDir stringByAppendingPathComponent:@"BuildManifest.json"];
+        if ([[NSFileManager defaultManager] fileExistsAtPath:manifestPath]) {
+            setenv("CRESCENT_REQUIRE_COOKED_TEXTURES", "1", 1);
+            setenv("CRESCENT_PREFER_COOKED_SCENES", "1", 1);
+            setenv("CRESCENT_REQUIRE_COOKED_SCENES", "1", 1);
+            setenv("CRESCENT_SKIP_ASSET_RESCAN", "1", 1);
+            setenv("CRESCENT_DIRECT_RUNTIME_PLAY", "1", 1);
+        }
+
+        Crescent::Engine& engine = Crescent::Engine::getInstance();
+        if (!engine.initialize()) {
+            fputs("Failed to initialize the engine.\n", stderr);
+            return 1;
+        }
+
+        // Never attached to a window: frames render into its drawables and are presented nowhere.
+        CAMetalLayer* layer = [CAMetalLayer layer];
+        layer.drawableSize = CGSizeMake(options.width, options.height);
+        layer.displaySyncEnabled = NO;
+
+        if (!tracePath.empty()) {
+            Crescent::CPUProfiler::getInstance().beginCapture();
+        }
+        Crescent::BenchmarkRunner runner(options);
+        int status = runner.run(engine, (__bridge void*)layer);
+        if (!tracePath.empty() && !Crescent::CPUProfiler::getInstance().writeChromeTrace(tracePath)) {
+            fprintf(stderr, "Failed to write CPU trace %s\n", tracePath.c_str());
+        }
+
+        engine.shutdown();
+        return status;
+    }
+}
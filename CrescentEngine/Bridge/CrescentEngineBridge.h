@@ -3,6 +3,13 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+// Transform fields of the batched reads and queued edits, in buffer order.
+typedef NS_OPTIONS(NSUInteger, CrescentTransformFields) {
+    CrescentTransformFieldPosition = 1 << 0, // world position
+    CrescentTransformFieldRotation = 1 << 1, // local euler angles, degrees
+    CrescentTransformFieldScale = 1 << 2     // local scale
+};
+
 @interface CrescentEngineBridge : NSObject
 
 + (instancetype)shared;
@@ -12,6 +19,9 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)update:(float)deltaTime;
 - (void)render;
 - (BOOL)tick:(float)deltaTime NS_SWIFT_NAME(tick(deltaTime:));
+// targetTimestamp is the display link's presentation time for the frame (CACurrentMediaTime base);
+// when successive ones are known the simulation steps by their interval instead of deltaTime.
+- (BOOL)tick:(float)deltaTime targetTimestamp:(CFTimeInterval)targetTimestamp NS_SWIFT_NAME(tick(deltaTime:targetTimestamp:));
 - (void)setMetalLayer:(CAMetalLayer *)layer;
 - (void)resizeWithWidth:(float)width height:(float)height;
 - (void)setSceneMetalLayer:(CAMetalLayer *)layer;
@@ -29,11 +39,12 @@ NS_ASSUME_NONNULL_BEGIN
 - (NSString *)createAnimationPreviewCloneFromUUID:(NSString *)uuid NS_SWIFT_NAME(createAnimationPreviewClone(sourceUUID:));
 - (void)destroyAnimationPreviewCloneUUID:(NSString *)uuid NS_SWIFT_NAME(destroyAnimationPreviewClone(uuid:));
 
-// Input handling
-- (void)handleKeyDown:(unsigned short)keyCode;
-- (void)handleKeyUp:(unsigned short)keyCode;
-- (void)handleMouseMoveWithDeltaX:(float)deltaX deltaY:(float)deltaY;
-- (void)handleMouseButton:(int)button pressed:(BOOL)pressed;
+// Input handling. Timestamps are NSEvent timestamps; 0 stamps the event on arrival. Events are
+// queued without waiting for the engine thread and applied at the start of the next update.
+- (void)handleKeyDown:(unsigned short)keyCode timestamp:(NSTimeInterval)timestamp;
+- (void)handleKeyUp:(unsigned short)keyCode timestamp:(NSTimeInterval)timestamp;
+- (void)handleMouseMoveWithDeltaX:(float)deltaX deltaY:(float)deltaY timestamp:(NSTimeInterval)timestamp;
+- (void)handleMouseButton:(int)button pressed:(BOOL)pressed timestamp:(NSTimeInterval)timestamp;
 
 // Scene editing commands
 - (void)createCube;
@@ -51,11 +62,19 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)createEmpty;
 - (BOOL)importModelAtPath:(NSString *)path NS_SWIFT_NAME(importModel(path:));
 - (BOOL)importModelAtPath:(NSString *)path options:(NSDictionary *)options NS_SWIFT_NAME(importModel(path:options:));
+- (BOOL)importModelAsyncAtPath:(NSString *)path options:(NSDictionary *)options NS_SWIFT_NAME(importModelAsync(path:options:));
+- (NSArray<NSDictionary *> *)getModelImportProgress NS_SWIFT_NAME(getModelImportProgress()); // Returns array of {id, path, stage, progress}
 - (void)deleteEntitiesByUUID:(NSArray<NSString *> *)uuids NS_SWIFT_NAME(deleteEntities(uuids:));
 - (NSArray<NSString *> *)duplicateEntitiesByUUID:(NSArray<NSString *> *)uuids NS_SWIFT_NAME(duplicateEntities(uuids:));
 
 // Scene query
 - (NSArray<NSDictionary *> *)getAllEntityInfo; // Returns array of {uuid, name, parent}
+// Rows of the active scene's entities [offset, offset + count) in scene order, hidden helpers
+// skipped. Returns {entities, total, version, scene}; version is where getEntityChangesSince picks up.
+- (NSDictionary *)getEntityInfoPageFrom:(NSInteger)offset count:(NSInteger)count NS_SWIFT_NAME(getEntityInfoPage(from:count:));
+// Entities touched since version: {reset, version, scene, changed (rows), removed (uuids)}. reset is
+// set when the scene changed or the log no longer reaches back that far; resync with pages then.
+- (NSDictionary *)getEntityChangesSince:(uint64_t)version scene:(NSString *)sceneUUID NS_SWIFT_NAME(getEntityChanges(since:scene:));
 - (NSString *)getSelectedEntityUUID NS_SWIFT_NAME(getSelectedEntityUUID());
 - (NSArray<NSString *> *)getAllSelectedEntityUUIDs NS_SWIFT_NAME(getAllSelectedUUIDs()); // Returns ALL selected UUIDs
 - (void)setSelectionByUUID:(NSArray<NSString *> *)uuids NS_SWIFT_NAME(setSelection(uuids:));
@@ -64,6 +83,10 @@ NS_ASSUME_NONNULL_BEGIN
 - (BOOL)setEntityParent:(NSString *)childUUID parent:(NSString *)parentUUID NS_SWIFT_NAME(setEntityParent(child:parent:));
 - (BOOL)setEntityName:(NSString *)uuid name:(NSString *)name NS_SWIFT_NAME(setEntityName(uuid:name:));
 - (NSString *)buildHLODFromSelection:(NSArray<NSString *> *)uuids NS_SWIFT_NAME(buildHLOD(from:));
+// Regenerates the scene's HLOD cluster hierarchy. Options: cellSize, levels, minSources, staticOnly,
+// atlasMaterials. Returns {sourceRendererCount, proxyCount, removedProxyCount, atlasedMaterialCount,
+// sourceTriangles, proxyTriangles}.
+- (NSDictionary *)buildHLODClusters:(nullable NSDictionary *)options NS_SWIFT_NAME(buildHLODClusters(options:));
 
 // Entity transform query (by UUID)
 - (NSArray<NSNumber *> *)getEntityPositionByUUID:(NSString *)uuid NS_SWIFT_NAME(getPosition(uuid:));
@@ -72,11 +95,22 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)setEntityPositionByUUID:(NSString *)uuid x:(float)x y:(float)y z:(float)z NS_SWIFT_NAME(setPosition(uuid:x:y:z:));
 - (void)setEntityRotationByUUID:(NSString *)uuid x:(float)x y:(float)y z:(float)z NS_SWIFT_NAME(setRotation(uuid:x:y:z:));
 - (void)setEntityScaleByUUID:(NSString *)uuid x:(float)x y:(float)y z:(float)z NS_SWIFT_NAME(setScale(uuid:x:y:z:));
+// Reads the fields of several entities in one engine call. Packed floats, per entity in order: 1
+// if it was found (0 otherwise, its fields then hold defaults), then x, y, z of each requested field.
+- (NSData *)readTransformsForUUIDs:(NSArray<NSString *> *)uuids fields:(CrescentTransformFields)fields NS_SWIFT_NAME(readTransforms(uuids:fields:));
+// Queued edits, applied together at the start of the next engine frame. Repeated sets of a field
+// keep the last value and offsets add up, so a drag costs one engine hop per frame however many
+// events it sends. Offsets apply after sets; exactly one field bit per call.
+- (void)queueTransformField:(CrescentTransformFields)field uuid:(NSString *)uuid x:(float)x y:(float)y z:(float)z NS_SWIFT_NAME(queueTransform(field:uuid:x:y:z:));
+- (void)queueTransformOffset:(CrescentTransformFields)field uuids:(NSArray<NSString *> *)uuids axis:(NSInteger)axis delta:(float)delta NS_SWIFT_NAME(queueTransformOffset(field:uuids:axis:delta:));
 
 // Mouse picking and gizmo interaction
 - (void)handleMouseClickAtX:(float)x y:(float)y screenWidth:(float)width screenHeight:(float)height additive:(BOOL)additive;
 - (void)handleMouseDragAtX:(float)x y:(float)y screenWidth:(float)width screenHeight:(float)height;
 - (void)handleMouseUpEvent;
+- (BOOL)isGizmoManipulating;
+// Selects what a scene view rectangle shows, in the same coordinates as clicks.
+- (void)handleMarqueeSelectFromX:(float)x0 y:(float)y0 toX:(float)x1 y:(float)y1 screenWidth:(float)width screenHeight:(float)height additive:(BOOL)additive;
 - (void)beginTerrainPaintForEntity:(NSString *)uuid
                                   x:(float)x
                                   y:(float)y
@@ -153,6 +187,8 @@ NS_ASSUME_NONNULL_BEGIN
 - (NSDictionary *)buildSceneStaticLightingLayout NS_SWIFT_NAME(buildSceneStaticLightingLayout());
 - (NSDictionary *)bakeSceneStaticLightmaps NS_SWIFT_NAME(bakeSceneStaticLightmaps());
 - (NSDictionary *)bakeSceneStaticLighting NS_SWIFT_NAME(bakeSceneStaticLighting());
+- (NSDictionary *)getStaticLightmapBakeProgress NS_SWIFT_NAME(getStaticLightmapBakeProgress()); // {active, progress}; callable while a bake runs
+- (void)cancelStaticLightmapBake NS_SWIFT_NAME(cancelStaticLightmapBake());
 
 // Material assets
 - (NSString *)createMaterialAssetFromEntity:(NSString *)uuid name:(NSString *)name NS_SWIFT_NAME(createMaterialAssetFromEntity(_:name:));
@@ -161,12 +197,15 @@ NS_ASSUME_NONNULL_BEGIN
 
 // Render stats
 - (NSDictionary *)getRenderStats NS_SWIFT_NAME(getRenderStats());
+- (NSDictionary *)getPhysicsStats NS_SWIFT_NAME(getPhysicsStats());
 
 // Environment / IBL controls
 - (NSDictionary *)getEnvironmentSettings;
 - (BOOL)loadEnvironmentMap:(NSString *)path;
 - (BOOL)cookEnvironmentMap:(NSString *)path outputPath:(NSString *)outputPath NS_SWIFT_NAME(cookEnvironmentMap(path:outputPath:));
 - (BOOL)cookStaticLightmap:(NSString *)path outputPath:(NSString *)outputPath NS_SWIFT_NAME(cookStaticLightmap(path:outputPath:));
+- (BOOL)cookPipelineArchive:(NSArray<NSString *> *)scenePaths outputPath:(NSString *)outputPath NS_SWIFT_NAME(cookPipelineArchive(scenePaths:outputPath:));
+- (BOOL)loadPipelineArchive:(NSString *)path NS_SWIFT_NAME(loadPipelineArchive(path:));
 - (void)resetEnvironment;
 - (void)setEnvironmentExposure:(float)ev;
 - (void)setEnvironmentIBLIntensity:(float)intensity;
@@ -195,6 +234,11 @@ NS_ASSUME_NONNULL_BEGIN
 - (BOOL)saveSceneAtPath:(NSString *)path NS_SWIFT_NAME(saveScene(path:));
 - (BOOL)saveCookedRuntimeSceneAtPath:(NSString *)path includeEditorOnly:(BOOL)includeEditorOnly NS_SWIFT_NAME(saveCookedRuntimeScene(path:includeEditorOnly:));
 - (BOOL)loadSceneAtPath:(NSString *)path NS_SWIFT_NAME(loadScene(path:));
+// Level transitions without a loading screen: the scene loads beside the active one, and once
+// preloadedSceneState reports ready (0 none, 1 loading, 2 ready, 3 failed) replaces it in a frame.
+- (BOOL)preloadSceneAtPath:(NSString *)path NS_SWIFT_NAME(preloadScene(path:));
+- (int)preloadedSceneState NS_SWIFT_NAME(preloadedSceneState());
+- (BOOL)activatePreloadedScene NS_SWIFT_NAME(activatePreloadedScene());
 - (void)enterPlayMode NS_SWIFT_NAME(enterPlayMode());
 - (void)exitPlayMode NS_SWIFT_NAME(exitPlayMode());
 - (BOOL)isPlaying NS_SWIFT_NAME(isPlaying());
@@ -289,6 +333,26 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)setDebugDrawShadowAtlas:(BOOL)enabled;
 - (void)setDebugDrawCascades:(BOOL)enabled;
 - (void)setDebugDrawPointFrusta:(BOOL)enabled;
+- (void)setDebugDrawGPUPasses:(BOOL)enabled;
+
+// CPU profiler capture, written as a Chrome trace (Perfetto, chrome://tracing).
+- (void)beginCPUProfileCapture NS_SWIFT_NAME(beginCPUProfileCapture());
+- (BOOL)endCPUProfileCaptureToPath:(NSString *)path NS_SWIFT_NAME(endCPUProfileCapture(path:));
+
+// Memory accounting: bytes, peak, allocations and budget per category ("Textures", "Meshes", ...)
+// plus the device and process totals. Budgets are in MB, 0 removes one; the device budget defaults
+// to the recommended working set.
+- (NSDictionary *)getMemoryReport NS_SWIFT_NAME(getMemoryReport());
+- (BOOL)setMemoryBudgetMB:(double)megabytes forCategory:(NSString *)category NS_SWIFT_NAME(setMemoryBudget(megabytes:category:));
+- (void)setDeviceMemoryBudgetMB:(double)megabytes NS_SWIFT_NAME(setDeviceMemoryBudget(megabytes:));
+- (void)logMemoryReport NS_SWIFT_NAME(logMemoryReport());
+
+// Performance lint of the active scene, most severe first. Options override the limits
+// (maxTrianglesWithoutLods, minInstancingDuplicates, maxPointShadowOverlap, maxTextureSize,
+// maxBones) and the order (sortBy: "severity", "kind" or "entity"). Each issue carries kind,
+// severity, cost, entity, entityName, asset, occurrences and message; overlapping lights also
+// carry relatedEntity.
+- (NSArray<NSDictionary *> *)analyzeScenePerformance:(nullable NSDictionary *)options NS_SWIFT_NAME(analyzeScenePerformance(options:));
 
 @end
 
@@ -9,10 +9,13 @@
 #include "../Engine/Scene/SceneManager.hpp"
 #include "../Engine/Scene/SceneCommands.hpp"
 #include "../Engine/Scene/SceneSerializer.hpp"
+#include "../Engine/Scene/SceneAnalyzer.hpp"
 #include "../Engine/Scene/Scene.hpp"
 #include "../Engine/Components/MeshRenderer.hpp"
 #include "../Engine/Components/SkinnedMeshRenderer.hpp"
 #include "../Engine/Components/InstancedMeshRenderer.hpp"
+#include "../Engine/Components/FoliageScatter.hpp"
+#include "../Engine/Components/TerrainRenderer.hpp"
 #include "../Engine/Components/PrimitiveMesh.hpp"
 #include "../Engine/Components/Animator.hpp"
 #include "../Engine/Components/IKConstraint.hpp"
@@ -27,6 +30,8 @@
 #include "../Engine/Components/AudioSource.hpp"
 #include "../Engine/ECS/Transform.hpp"
 #include "../Engine/Assets/AssetDatabase.hpp"
+#include "../Engine/Core/CPUProfiler.hpp"
+#include "../Engine/Core/MemoryTracker.hpp"
 #include "../Engine/Animation/AnimationClip.hpp"
 #include "../Engine/Project/Project.hpp"
 #include "../Engine/Components/CameraController.hpp"
@@ -52,6 +57,7 @@
 #include <chrono>
 #include <filesystem>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <cstring>
 #include "../../../ThirdParty/miniaudio/miniaudio.h"
@@ -344,6 +350,11 @@ static bool ApplyMaterialJson(const nlohmann::json& j,
             material->setRenderMode(static_cast<Material::RenderMode>(mode));
         }
         if (p.contains("alphaCutoff")) material->setAlphaCutoff(p["alphaCutoff"].get<float>());
+        if (p.contains("transparencyMode")) {
+            int mode = p["transparencyMode"].get<int>();
+            mode = std::max(0, std::min(2, mode));
+            material->setTransparencyMode(static_cast<Material::TransparencyMode>(mode));
+        }
         if (p.contains("cullMode")) {
             int mode = p["cullMode"].get<int>();
             mode = std::max(0, std::min(2, mode));
@@ -495,6 +506,30 @@ static std::shared_ptr<Material> GetPrimaryMaterialForEntityUUID(const std::stri
     return nullptr;
 }
 
+static Crescent::SceneCommands::ModelImportOptions ModelImportOptionsFromDictionary(NSDictionary* options) {
+    Crescent::SceneCommands::ModelImportOptions importOptions;
+    if (!options) {
+        return importOptions;
+    }
+    NSNumber* scale = options[@"scale"];
+    if (scale) {
+        importOptions.scale = std::max(0.0001f, scale.floatValue);
+    }
+    NSNumber* flipUVs = options[@"flipUVs"];
+    if (flipUVs) {
+        importOptions.flipUVs = flipUVs.boolValue;
+    }
+    NSNumber* onlyLOD0 = options[@"onlyLOD0"];
+    if (onlyLOD0) {
+        importOptions.onlyLOD0 = onlyLOD0.boolValue;
+    }
+    NSNumber* mergeStatic = options[@"mergeStaticMeshes"];
+    if (mergeStatic) {
+        importOptions.mergeStaticMeshes = mergeStatic.boolValue;
+    }
+    return importOptions;
+}
+
 static void EnsureUniqueMaterialsForEntity(Entity* entity) {
     if (!entity) {
         return;
@@ -554,6 +589,10 @@ static void ApplyMaterialScalar(const std::shared_ptr<Material>& material,
         int mode = std::max(0, std::min(2, static_cast<int>(std::round(value))));
         material->setRenderMode(static_cast<Material::RenderMode>(mode));
     }
+    else if (prop == "transparencyMode") {
+        int mode = std::max(0, std::min(2, static_cast<int>(std::round(value))));
+        material->setTransparencyMode(static_cast<Material::TransparencyMode>(mode));
+    }
     else if (prop == "twoSided") {
         material->setTwoSided(value >= 0.5f);
     } else if (prop == "alphaToCoverage") {
@@ -720,6 +759,84 @@ struct TerrainPaintTarget {
     std::shared_ptr<Material> material;
 };
 
+// Foliage grown on the terrain and its GPU renderer read its heights again.
+static void RefreshTerrainFoliage(const TerrainPaintTarget& target) {
+    FoliageScatter* scatter = target.binding.entity ? target.binding.entity->getComponent<FoliageScatter>() : nullptr;
+    if (scatter) {
+        scatter->refresh();
+    }
+    TerrainRenderer* terrain = target.binding.entity ? target.binding.entity->getComponent<TerrainRenderer>() : nullptr;
+    if (terrain) {
+        terrain->refresh();
+    }
+}
+
+// Hierarchy row of an entity, or nil for the editor helpers the hierarchy hides.
+static NSDictionary* EntityInfoDictionary(Entity* entity) {
+    const std::string& entityName = entity->getName();
+    if (entityName == "Editor Gizmo" || entity->isEditorOnly()) {
+        return nil;
+    }
+
+    std::string uuidStr = entity->getUUID().toString();
+    auto* skinned = entity->getComponent<SkinnedMeshRenderer>();
+    bool hasAnimator = entity->getComponent<Animator>() != nullptr;
+    int clipCount = skinned ? static_cast<int>(skinned->getAnimationClips().size()) : 0;
+
+    std::string parentUuidStr;
+    if (auto* transform = entity->getTransform()) {
+        if (auto* parent = transform->getParent()) {
+            if (auto* parentEntity = parent->getEntity()) {
+                parentUuidStr = parentEntity->getUUID().toString();
+            }
+        }
+    }
+
+    return @{
+        @"uuid": [NSString stringWithUTF8String:uuidStr.c_str()],
+        @"name": [NSString stringWithUTF8String:entityName.c_str()],
+        @"skinned": @(skinned != nullptr),
+        @"animator": @(hasAnimator),
+        @"clipCount": @(clipCount),
+        @"parent": [NSString stringWithUTF8String:parentUuidStr.c_str()]
+    };
+}
+
+// Edits of one entity queued by queueTransformField/queueTransformOffset, indexed by field
+// (position, rotation, scale).
+struct PendingTransformEdit {
+    Math::Vector3 value[3];
+    Math::Vector3 offset[3];
+    bool hasValue[3] = {false, false, false};
+    bool hasOffset[3] = {false, false, false};
+};
+
+static int TransformFieldIndex(CrescentTransformFields field) {
+    switch (field) {
+        case CrescentTransformFieldPosition: return 0;
+        case CrescentTransformFieldRotation: return 1;
+        case CrescentTransformFieldScale: return 2;
+        default: return -1;
+    }
+}
+
+// Rotation travels in degrees, as the inspector shows it.
+static Math::Vector3 ReadTransformField(Transform* transform, int field) {
+    switch (field) {
+        case 0: return transform->getPosition();
+        case 1: return transform->getLocalEulerAngles() * Math::RAD_TO_DEG;
+        default: return transform->getLocalScale();
+    }
+}
+
+static void WriteTransformField(Transform* transform, int field, const Math::Vector3& value) {
+    switch (field) {
+        case 0: transform->setPosition(value); break;
+        case 1: transform->setLocalEulerAngles(value * Math::DEG_TO_RAD); break;
+        default: transform->setLocalScale(value); break;
+    }
+}
+
 struct TerrainBrushParams {
     int layer = 0;
     float radius = 1.0f;
@@ -1007,6 +1124,7 @@ static bool ApplyTerrainVertexHeights(const TerrainPaintTarget& target,
     target.mesh->calculateNormals();
     target.mesh->calculateTangents();
     target.binding.renderer->setMesh(target.mesh);
+    RefreshTerrainFoliage(target);
     return true;
 }
 
@@ -1395,6 +1513,7 @@ static bool EnsureTerrainControlPaintData(TerrainPaintStrokeState& state,
 
     target.material->setTerrainControlTexture(texture);
     target.material->setTerrainEnabled(true);
+    renderer->invalidateTerrainVirtualTexture(target.material.get());
     state.entityUUID = target.binding.entity->getUUID().toString();
     state.texturePath = texturePath;
     state.width = width;
@@ -1532,15 +1651,7 @@ static bool ResolveTerrainPaintTargetAtCursor(const std::string& preferredEntity
         camera
     );
 
-    std::vector<Entity*> entities;
-    const auto& allEntities = scene->getAllEntities();
-    entities.reserve(allEntities.size());
-    for (const auto& entry : allEntities) {
-        if (entry) {
-            entities.push_back(entry.get());
-        }
-    }
-    RaycastHit hit = SelectionSystem::raycastAll(ray, entities);
+    RaycastHit hit = SelectionSystem::raycastScene(ray, scene);
     if (!hit.hit || !hit.entity) {
         return false;
     }
@@ -1786,6 +1897,8 @@ static void UploadTerrainPaintTextureIfNeeded(TerrainPaintStrokeState& state,
         state.height,
         true
     );
+    // The control map changed in place, which the virtual texture cannot see by itself.
+    renderer->invalidateTerrainVirtualTexture(target.material.get());
     state.lastUploadTimeSeconds = now;
     state.uploadPending = false;
 }
@@ -1931,6 +2044,7 @@ static void ApplyTerrainSculptSample(TerrainPaintTarget& target,
     target.mesh->calculateNormals();
     target.mesh->calculateTangents();
     target.binding.renderer->setMesh(target.mesh);
+    RefreshTerrainFoliage(target);
 }
 
 static void ApplyTerrainSculptStroke(TerrainSculptStrokeState& sculptState,
@@ -2319,14 +2433,12 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
     dispatch_queue_t _engineQueue;
     std::atomic_bool _frameInFlight;
     std::mutex _inputMutex;
-    float _pendingMouseDeltaX;
-    float _pendingMouseDeltaY;
-    bool _hasPendingMouseDelta;
     float _pendingMouseDragX;
     float _pendingMouseDragY;
     float _pendingMouseDragW;
     float _pendingMouseDragH;
     bool _hasPendingMouseDrag;
+    std::unordered_map<std::string, PendingTransformEdit> _pendingTransformEdits;
     TerrainPaintStrokeState _terrainPaintState;
     std::unordered_map<std::string, TerrainPaintHistoryState> _terrainPaintHistory;
     TerrainSculptStrokeState _terrainSculptState;
@@ -2356,9 +2468,6 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
         _engineQueue = dispatch_queue_create("com.crescent.engine.queue", attr);
         dispatch_queue_set_specific(_engineQueue, kEngineQueueKey, (void *)kEngineQueueKey, nullptr);
         _frameInFlight.store(false);
-        _pendingMouseDeltaX = 0.0f;
-        _pendingMouseDeltaY = 0.0f;
-        _hasPendingMouseDelta = false;
         _pendingMouseDragX = 0.0f;
         _pendingMouseDragY = 0.0f;
         _pendingMouseDragW = 0.0f;
@@ -2372,7 +2481,31 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
     return dispatch_get_specific(kEngineQueueKey) != nullptr;
 }
 
+// Frame work (tick/update/render) runs through here; everything else the editor sends is assumed to
+// mutate the scene and marks the editor views for a redraw. Sync queries that only read
+// (performSyncObject/Float/Int) do not.
+- (void)performFrame:(dispatch_block_t)block {
+    if ([self isOnEngineQueue]) {
+        @autoreleasepool {
+            block();
+        }
+        return;
+    }
+    dispatch_async(_engineQueue, ^{
+        @autoreleasepool {
+            block();
+        }
+    });
+}
+
+- (void)requestEditorRedraw {
+    if (_engine) {
+        _engine->requestEditorRedraw();
+    }
+}
+
 - (void)performAsync:(dispatch_block_t)block {
+    [self requestEditorRedraw];
     if ([self isOnEngineQueue]) {
         @autoreleasepool {
             block();
@@ -2387,6 +2520,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
 }
 
 - (void)performSync:(dispatch_block_t)block {
+    [self requestEditorRedraw];
     if ([self isOnEngineQueue]) {
         @autoreleasepool {
             block();
@@ -2416,6 +2550,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
 }
 
 - (BOOL)performSyncBool:(BOOL (^)(void))block {
+    [self requestEditorRedraw];
     if ([self isOnEngineQueue]) {
         @autoreleasepool {
             return block();
@@ -2464,24 +2599,15 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
     if (!_engine) {
         return;
     }
-    float deltaX = 0.0f;
-    float deltaY = 0.0f;
-    bool hasDelta = false;
     float dragX = 0.0f;
     float dragY = 0.0f;
     float dragW = 0.0f;
     float dragH = 0.0f;
     bool hasDrag = false;
+    std::unordered_map<std::string, PendingTransformEdit> transformEdits;
     {
         std::lock_guard<std::mutex> lock(_inputMutex);
-        if (_hasPendingMouseDelta) {
-            deltaX = _pendingMouseDeltaX;
-            deltaY = _pendingMouseDeltaY;
-            _pendingMouseDeltaX = 0.0f;
-            _pendingMouseDeltaY = 0.0f;
-            _hasPendingMouseDelta = false;
-            hasDelta = true;
-        }
+        transformEdits.swap(_pendingTransformEdits);
         if (_hasPendingMouseDrag) {
             dragX = _pendingMouseDragX;
             dragY = _pendingMouseDragY;
@@ -2491,8 +2617,27 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             hasDrag = true;
         }
     }
-    if (hasDelta) {
-        _engine->handleMouseMove(deltaX, deltaY);
+    if (!transformEdits.empty()) {
+        if (Scene* scene = SceneManager::getInstance().getActiveScene()) {
+            for (const auto& [uuid, edit] : transformEdits) {
+                Entity* entity = SceneCommands::getEntityByUUID(scene, uuid);
+                Transform* transform = entity ? entity->getTransform() : nullptr;
+                if (!transform) {
+                    continue;
+                }
+                for (int field = 0; field < 3; ++field) {
+                    if (!edit.hasValue[field] && !edit.hasOffset[field]) {
+                        continue;
+                    }
+                    Math::Vector3 value = edit.hasValue[field] ? edit.value[field] : ReadTransformField(transform, field);
+                    if (edit.hasOffset[field]) {
+                        value = value + edit.offset[field];
+                    }
+                    WriteTransformField(transform, field, value);
+                }
+            }
+        }
+        _engine->requestEditorRedraw();
     }
     if (hasDrag) {
         _engine->handleMouseDrag(dragX, dragY, dragW, dragH);
@@ -2517,7 +2662,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
 }
 
 - (void)update:(float)deltaTime {
-    [self performAsync:^{
+    [self performFrame:^{
         if (_engine) {
             [self applyPendingInput];
             _engine->update(deltaTime);
@@ -2526,7 +2671,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
 }
 
 - (void)render {
-    [self performAsync:^{
+    [self performFrame:^{
         if (_engine) {
             _engine->render();
         }
@@ -2534,6 +2679,10 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
 }
 
 - (BOOL)tick:(float)deltaTime {
+    return [self tick:deltaTime targetTimestamp:0.0];
+}
+
+- (BOOL)tick:(float)deltaTime targetTimestamp:(CFTimeInterval)targetTimestamp {
     if (!_engine) {
         return NO;
     }
@@ -2541,10 +2690,10 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
     if (!_frameInFlight.compare_exchange_strong(expected, true)) {
         return NO;
     }
-    [self performAsync:^{
+    [self performFrame:^{
         if (_engine) {
             [self applyPendingInput];
-            _engine->update(deltaTime);
+            _engine->update(deltaTime, targetTimestamp);
             _engine->render();
         }
         _frameInFlight.store(false);
@@ -2771,35 +2920,28 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
     }];
 }
 
-- (void)handleKeyDown:(unsigned short)keyCode {
-    [self performAsync:^{
-        if (_engine) {
-            _engine->handleKeyDown(keyCode);
-        }
-    }];
+- (void)handleKeyDown:(unsigned short)keyCode timestamp:(NSTimeInterval)timestamp {
+    if (_engine) {
+        _engine->handleKeyDown(keyCode, timestamp);
+    }
 }
 
-- (void)handleKeyUp:(unsigned short)keyCode {
-    [self performAsync:^{
-        if (_engine) {
-            _engine->handleKeyUp(keyCode);
-        }
-    }];
+- (void)handleKeyUp:(unsigned short)keyCode timestamp:(NSTimeInterval)timestamp {
+    if (_engine) {
+        _engine->handleKeyUp(keyCode, timestamp);
+    }
 }
 
-- (void)handleMouseMoveWithDeltaX:(float)deltaX deltaY:(float)deltaY {
-    std::lock_guard<std::mutex> lock(_inputMutex);
-    _pendingMouseDeltaX += deltaX;
-    _pendingMouseDeltaY += deltaY;
-    _hasPendingMouseDelta = true;
+- (void)handleMouseMoveWithDeltaX:(float)deltaX deltaY:(float)deltaY timestamp:(NSTimeInterval)timestamp {
+    if (_engine) {
+        _engine->handleMouseMove(deltaX, deltaY, timestamp);
+    }
 }
 
-- (void)handleMouseButton:(int)button pressed:(BOOL)pressed {
-    [self performAsync:^{
-        if (_engine) {
-            _engine->handleMouseButton(button, pressed);
-        }
-    }];
+- (void)handleMouseButton:(int)button pressed:(BOOL)pressed timestamp:(NSTimeInterval)timestamp {
+    if (_engine) {
+        _engine->handleMouseButton(button, pressed, timestamp);
+    }
 }
 
 // MARK: - Scene Editing Commands
@@ -2939,31 +3081,38 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
         if (!scene || !path) {
             return NO;
         }
-        Crescent::SceneCommands::ModelImportOptions importOptions;
-        if (options) {
-            NSNumber* scale = options[@"scale"];
-            if (scale) {
-                importOptions.scale = std::max(0.0001f, scale.floatValue);
-            }
-            NSNumber* flipUVs = options[@"flipUVs"];
-            if (flipUVs) {
-                importOptions.flipUVs = flipUVs.boolValue;
-            }
-            NSNumber* onlyLOD0 = options[@"onlyLOD0"];
-            if (onlyLOD0) {
-                importOptions.onlyLOD0 = onlyLOD0.boolValue;
-            }
-            NSNumber* mergeStatic = options[@"mergeStaticMeshes"];
-            if (mergeStatic) {
-                importOptions.mergeStaticMeshes = mergeStatic.boolValue;
-            }
-        }
+        Crescent::SceneCommands::ModelImportOptions importOptions = ModelImportOptionsFromDictionary(options);
         std::string modelPath = [path UTF8String];
         Crescent::Entity* entity = Crescent::SceneCommands::importModel(scene, modelPath, importOptions);
         return entity != nullptr;
     }];
 }
 
+- (BOOL)importModelAsyncAtPath:(NSString *)path options:(NSDictionary *)options {
+    return [self performSyncBool:^BOOL {
+        if (!path) {
+            return NO;
+        }
+        Crescent::SceneCommands::ModelImportOptions importOptions = ModelImportOptionsFromDictionary(options);
+        return Crescent::SceneCommands::importModelAsync([path UTF8String], importOptions) != 0;
+    }];
+}
+
+- (NSArray<NSDictionary *> *)getModelImportProgress {
+    return (NSArray<NSDictionary *> *)[self performSyncObject:^id{
+        NSMutableArray<NSDictionary *>* result = [NSMutableArray array];
+        for (const auto& entry : Crescent::SceneCommands::getModelImportProgress()) {
+            [result addObject:@{
+                @"id": @(entry.id),
+                @"path": [NSString stringWithUTF8String:entry.path.c_str()],
+                @"stage": [NSString stringWithUTF8String:entry.stage.c_str()],
+                @"progress": @(entry.progress)
+            }];
+        }
+        return result;
+    }];
+}
+
 - (void)deleteEntitiesByUUID:(NSArray<NSString *> *)uuids {
     [self performAsync:^{
         Crescent::Scene* scene = Crescent::SceneManager::getInstance().getActiveScene();
@@ -3024,45 +3173,9 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             auto entities = Crescent::SceneCommands::getAllEntities(scene);
             
             for (auto* entity : entities) {
-                std::string entityName = entity->getName();
-                
-                // Skip editor-only helper
-                if (entityName == "Editor Gizmo") {
-                    continue;
-                }
-                if (entity->isEditorOnly()) {
-                    continue;
+                if (NSDictionary *info = EntityInfoDictionary(entity)) {
+                    [entityInfos addObject:info];
                 }
-                
-                std::string uuidStr = entity->getUUID().toString();
-                bool hasSkinned = entity->getComponent<SkinnedMeshRenderer>() != nullptr;
-                bool hasAnimator = entity->getComponent<Animator>() != nullptr;
-                int clipCount = 0;
-                if (hasSkinned) {
-                    auto* skinned = entity->getComponent<SkinnedMeshRenderer>();
-                    if (skinned) {
-                        clipCount = static_cast<int>(skinned->getAnimationClips().size());
-                    }
-                }
-
-                std::string parentUuidStr;
-                if (auto* transform = entity->getTransform()) {
-                    if (auto* parent = transform->getParent()) {
-                        if (auto* parentEntity = parent->getEntity()) {
-                            parentUuidStr = parentEntity->getUUID().toString();
-                        }
-                    }
-                }
-                
-                NSDictionary *info = @{
-                    @"uuid": [NSString stringWithUTF8String:uuidStr.c_str()],
-                    @"name": [NSString stringWithUTF8String:entityName.c_str()],
-                    @"skinned": @(hasSkinned),
-                    @"animator": @(hasAnimator),
-                    @"clipCount": @(clipCount),
-                    @"parent": [NSString stringWithUTF8String:parentUuidStr.c_str()]
-                };
-                [entityInfos addObject:info];
             }
         }
         
@@ -3070,6 +3183,68 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
     }];
 }
 
+- (NSDictionary *)getEntityInfoPageFrom:(NSInteger)offset count:(NSInteger)count {
+    return (NSDictionary *)[self performSyncObject:^id{
+        NSMutableArray<NSDictionary *> *entityInfos = [NSMutableArray array];
+        Crescent::Scene* scene = Crescent::SceneManager::getInstance().getActiveScene();
+        if (!scene) {
+            return @{@"entities": entityInfos, @"total": @0, @"version": @0, @"scene": @""};
+        }
+        const auto& entities = scene->getAllEntities();
+        const size_t begin = static_cast<size_t>(std::max<NSInteger>(0, offset));
+        const size_t end = std::min(entities.size(), begin + static_cast<size_t>(std::max<NSInteger>(0, count)));
+        for (size_t i = begin; i < end; ++i) {
+            if (NSDictionary *info = EntityInfoDictionary(entities[i].get())) {
+                [entityInfos addObject:info];
+            }
+        }
+        return @{
+            @"entities": entityInfos,
+            @"total": @(entities.size()),
+            @"version": @(scene->getChangeLog().getVersion()),
+            @"scene": [NSString stringWithUTF8String:scene->getUUID().toString().c_str()]
+        };
+    }];
+}
+
+- (NSDictionary *)getEntityChangesSince:(uint64_t)version scene:(NSString *)sceneUUID {
+    return (NSDictionary *)[self performSyncObject:^id{
+        Crescent::Scene* scene = Crescent::SceneManager::getInstance().getActiveScene();
+        if (!scene) {
+            return @{@"reset": @YES, @"version": @0, @"scene": @""};
+        }
+        NSString *activeScene = [NSString stringWithUTF8String:scene->getUUID().toString().c_str()];
+        const uint64_t current = scene->getChangeLog().getVersion();
+        std::vector<Crescent::SceneChangeLog::Change> changes;
+        if (![activeScene isEqualToString:sceneUUID] || !scene->getChangeLog().collect(version, changes)) {
+            return @{@"reset": @YES, @"version": @(current), @"scene": activeScene};
+        }
+
+        // Several edits of one entity collapse into its current row, or its removal.
+        NSMutableArray<NSDictionary *> *changed = [NSMutableArray array];
+        NSMutableArray<NSString *> *removed = [NSMutableArray array];
+        std::unordered_set<Crescent::UUID> seen;
+        for (auto it = changes.rbegin(); it != changes.rend(); ++it) {
+            if (!seen.insert(it->entity).second) {
+                continue;
+            }
+            Entity* entity = scene->findEntity(it->entity);
+            if (!entity) {
+                [removed addObject:[NSString stringWithUTF8String:it->entity.toString().c_str()]];
+            } else if (NSDictionary *info = EntityInfoDictionary(entity)) {
+                [changed addObject:info];
+            }
+        }
+        return @{
+            @"reset": @NO,
+            @"version": @(current),
+            @"scene": activeScene,
+            @"changed": changed,
+            @"removed": removed
+        };
+    }];
+}
+
 - (NSString *)getSelectedEntityUUID {
     return (NSString *)[self performSyncObject:^id{
         const auto& selection = Crescent::SelectionSystem::getSelection();
@@ -3178,6 +3353,53 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
     }];
 }
 
+static Crescent::SceneCommands::HLODClusterSettings HLODClusterSettingsFromDictionary(NSDictionary* options) {
+    Crescent::SceneCommands::HLODClusterSettings settings;
+    if (!options) {
+        return settings;
+    }
+    NSNumber* cellSize = options[@"cellSize"];
+    if (cellSize) {
+        settings.cellSize = std::max(1.0f, cellSize.floatValue);
+    }
+    NSNumber* levels = options[@"levels"];
+    if (levels) {
+        settings.levels = std::clamp(levels.unsignedIntValue, 1u, 8u);
+    }
+    NSNumber* minSources = options[@"minSources"];
+    if (minSources) {
+        settings.minSources = std::max(2u, minSources.unsignedIntValue);
+    }
+    NSNumber* staticOnly = options[@"staticOnly"];
+    if (staticOnly) {
+        settings.staticOnly = staticOnly.boolValue;
+    }
+    NSNumber* atlasMaterials = options[@"atlasMaterials"];
+    if (atlasMaterials) {
+        settings.atlasMaterials = atlasMaterials.boolValue;
+    }
+    return settings;
+}
+
+- (NSDictionary *)buildHLODClusters:(NSDictionary *)options {
+    return (NSDictionary *)[self performSyncObject:^id{
+        Crescent::Scene* scene = Crescent::SceneManager::getInstance().getActiveScene();
+        if (!scene) {
+            return @{};
+        }
+        Crescent::SceneCommands::HLODClusterStats stats =
+            Crescent::SceneCommands::buildHLODClusters(scene, HLODClusterSettingsFromDictionary(options));
+        return @{
+            @"sourceRendererCount": @(stats.sourceRendererCount),
+            @"proxyCount": @(stats.proxyCount),
+            @"removedProxyCount": @(stats.removedProxyCount),
+            @"atlasedMaterialCount": @(stats.atlasedMaterialCount),
+            @"sourceTriangles": @(stats.sourceTriangles),
+            @"proxyTriangles": @(stats.proxyTriangles)
+        };
+    }];
+}
+
 // MARK: - Entity Transform Query (by UUID)
 
 - (NSArray<NSNumber *> *)getEntityPositionByUUID:(NSString *)uuid {
@@ -3265,6 +3487,67 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
     }];
 }
 
+- (NSData *)readTransformsForUUIDs:(NSArray<NSString *> *)uuids fields:(CrescentTransformFields)fields {
+    return (NSData *)[self performSyncObject:^id{
+        int fieldIndices[3];
+        int fieldCount = 0;
+        for (int field = 0; field < 3; ++field) {
+            if (fields & (1u << field)) {
+                fieldIndices[fieldCount++] = field;
+            }
+        }
+        const size_t stride = 1 + 3 * static_cast<size_t>(fieldCount);
+        NSMutableData *data = [NSMutableData dataWithLength:uuids.count * stride * sizeof(float)];
+        float* out = static_cast<float*>(data.mutableBytes);
+        Scene* scene = SceneManager::getInstance().getActiveScene();
+        for (NSString* uuid in uuids) {
+            Entity* entity = scene ? SceneCommands::getEntityByUUID(scene, uuid.UTF8String) : nullptr;
+            Transform* transform = entity ? entity->getTransform() : nullptr;
+            out[0] = transform ? 1.0f : 0.0f;
+            for (int i = 0; i < fieldCount; ++i) {
+                const int field = fieldIndices[i];
+                const Math::Vector3 value = transform ? ReadTransformField(transform, field)
+                                                      : Math::Vector3(field == 2 ? 1.0f : 0.0f);
+                out[1 + i * 3 + 0] = value.x;
+                out[1 + i * 3 + 1] = value.y;
+                out[1 + i * 3 + 2] = value.z;
+            }
+            out += stride;
+        }
+        return data;
+    }];
+}
+
+- (void)queueTransformField:(CrescentTransformFields)field uuid:(NSString *)uuid x:(float)x y:(float)y z:(float)z {
+    const int index = TransformFieldIndex(field);
+    if (index < 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_inputMutex);
+    PendingTransformEdit& edit = _pendingTransformEdits[uuid.UTF8String];
+    edit.value[index] = Math::Vector3(x, y, z);
+    edit.hasValue[index] = true;
+    // A set replaces whatever was added before it.
+    edit.offset[index] = Math::Vector3::Zero;
+    edit.hasOffset[index] = false;
+}
+
+- (void)queueTransformOffset:(CrescentTransformFields)field uuids:(NSArray<NSString *> *)uuids axis:(NSInteger)axis delta:(float)delta {
+    const int index = TransformFieldIndex(field);
+    if (index < 0 || axis < 0 || axis > 2) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_inputMutex);
+    for (NSString* uuid in uuids) {
+        PendingTransformEdit& edit = _pendingTransformEdits[uuid.UTF8String];
+        Math::Vector3& offset = edit.hasValue[index] ? edit.value[index] : edit.offset[index];
+        if (axis == 0) offset.x += delta;
+        if (axis == 1) offset.y += delta;
+        if (axis == 2) offset.z += delta;
+        edit.hasOffset[index] = edit.hasOffset[index] || !edit.hasValue[index];
+    }
+}
+
 // MARK: - Mouse Picking & Gizmo Interaction
 
 - (void)handleMouseClickAtX:(float)x y:(float)y screenWidth:(float)width screenHeight:(float)height additive:(BOOL)additive {
@@ -3275,6 +3558,14 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
     }];
 }
 
+- (void)handleMarqueeSelectFromX:(float)x0 y:(float)y0 toX:(float)x1 y:(float)y1 screenWidth:(float)width screenHeight:(float)height additive:(BOOL)additive {
+    [self performAsync:^{
+        if (_engine) {
+            _engine->handleMarqueeSelect(x0, y0, x1, y1, width, height, additive);
+        }
+    }];
+}
+
 - (void)handleMouseDragAtX:(float)x y:(float)y screenWidth:(float)width screenHeight:(float)height {
     std::lock_guard<std::mutex> lock(_inputMutex);
     _pendingMouseDragX = x;
@@ -3284,6 +3575,12 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
     _hasPendingMouseDrag = true;
 }
 
+- (BOOL)isGizmoManipulating {
+    return [self performSyncBool:^BOOL {
+        return _engine && _engine->isGizmoManipulating();
+    }];
+}
+
 - (void)handleMouseUpEvent {
     [self performAsync:^{
         if (_engine) {
@@ -3725,6 +4022,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
                     _terrainPaintState.height,
                     true
                 );
+                renderer->invalidateTerrainVirtualTexture(target.material.get());
             }
             CommitTerrainPaintState(_terrainPaintState);
             return YES;
@@ -3818,6 +4116,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
                     _terrainPaintState.height,
                     true
                 );
+                renderer->invalidateTerrainVirtualTexture(target.material.get());
             }
             CommitTerrainPaintState(_terrainPaintState);
             return YES;
@@ -4014,6 +4313,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             @"heightInvert": @(material->getHeightInvert() ? 1 : 0),
             @"renderMode": @(static_cast<int>(material->getRenderMode())),
             @"alphaCutoff": @(material->getAlphaCutoff()),
+            @"transparencyMode": @(static_cast<int>(material->getTransparencyMode())),
             @"twoSided": @(material->isTwoSided() ? 1 : 0),
             @"alphaToCoverage": @(material->getAlphaToCoverage() ? 1 : 0),
             @"windEnabled": @(material->getWindEnabled() ? 1 : 0),
@@ -4312,29 +4612,49 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             return NO;
         }
 
-        std::string outputPath;
-        auto tex = _engine->getRenderer()->bakeImpostorAtlas(mesh.get(), material.get(),
-                                                            static_cast<uint32_t>(std::max<NSInteger>(1, rows)),
-                                                            static_cast<uint32_t>(std::max<NSInteger>(1, cols)),
-                                                            static_cast<uint32_t>(std::max<NSInteger>(32, tileSize)),
-                                                            &outputPath);
-        if (!tex) {
-            return NO;
-        }
+        // The material switches to the impostor once the atlas is back, a few frames later.
+        ImpostorBakeRequest request;
+        request.mesh = mesh;
+        request.material = material;
+        request.rows = static_cast<uint32_t>(std::max<NSInteger>(1, rows));
+        request.cols = static_cast<uint32_t>(std::max<NSInteger>(1, cols));
+        request.tileSize = static_cast<uint32_t>(std::max<NSInteger>(32, tileSize));
+        request.onComplete = [material, rows, cols](const std::shared_ptr<Texture2D>& tex, const std::string&) {
+            if (!tex) {
+                return;
+            }
+            material->setAlbedoTexture(tex);
+            material->setImpostorEnabled(true);
+            material->setImpostorRows(static_cast<int>(rows));
+            material->setImpostorCols(static_cast<int>(cols));
+            material->setBillboardEnabled(true);
+            if (material->getRenderMode() != Material::RenderMode::Cutout) {
+                material->setRenderMode(Material::RenderMode::Cutout);
+                material->setAlphaCutoff(0.3f);
+            }
+            material->setAlpha(1.0f);
+        };
+        std::vector<ImpostorBakeRequest> requests;
+        requests.push_back(std::move(request));
+        return _engine->getRenderer()->bakeImpostorAtlases(std::move(requests)) > 0 ? YES : NO;
+    }];
+}
 
-        material->setAlbedoTexture(tex);
-        material->setImpostorEnabled(true);
-        material->setImpostorRows(static_cast<int>(rows));
-        material->setImpostorCols(static_cast<int>(cols));
-        material->setBillboardEnabled(true);
-        if (material->getRenderMode() != Material::RenderMode::Cutout) {
-            material->setRenderMode(Material::RenderMode::Cutout);
-            material->setAlphaCutoff(0.3f);
+// The bake holds the engine thread, so it renders the viewport itself between slices of work
+// and reloads the lightmaps whenever a progressive bake writes a preview.
+- (SceneCommands::StaticLightmapBakeHooks)staticLightmapBakeHooks {
+    SceneCommands::StaticLightmapBakeHooks hooks;
+    hooks.onFrame = [self]() {
+        if (_engine) {
+            _engine->render();
         }
-        material->setAlpha(1.0f);
-
-        return YES;
-    }];
+    };
+    hooks.onPreview = [self]() {
+        if (_engine && _engine->getRenderer()) {
+            _engine->getRenderer()->invalidateStaticLightingResources();
+        }
+    };
+    return hooks;
 }
 
 - (NSDictionary *)bakeSceneStaticLighting {
@@ -4343,7 +4663,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
         if (!scene) {
             return @{};
         }
-        SceneCommands::StaticLightmapBakeStats stats = SceneCommands::bakeStaticLightmaps(scene);
+        SceneCommands::StaticLightmapBakeStats stats = SceneCommands::bakeStaticLightmaps(scene, "", [self staticLightmapBakeHooks]);
         if (_engine && _engine->getRenderer()) {
             _engine->getRenderer()->invalidateStaticLightingResources();
         }
@@ -4356,7 +4676,9 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             @"layoutRendererCount": @(stats.layoutRendererCount),
             @"layoutSkippedRendererCount": @(stats.layoutSkippedRendererCount),
             @"generatedUVRendererCount": @(stats.generatedUVRendererCount),
-            @"reusedUVRendererCount": @(stats.reusedUVRendererCount)
+            @"reusedUVRendererCount": @(stats.reusedUVRendererCount),
+            @"skippedAtlasCount": @(stats.skippedAtlasCount),
+            @"cancelled": @(stats.cancelled)
         };
     }];
 }
@@ -4373,7 +4695,8 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             @"atlasCount": @(stats.atlasCount),
             @"generatedUVRendererCount": @(stats.generatedUVRendererCount),
             @"reusedUVRendererCount": @(stats.reusedUVRendererCount),
-            @"skippedRendererCount": @(stats.skippedRendererCount)
+            @"skippedRendererCount": @(stats.skippedRendererCount),
+            @"atlasUtilization": @(stats.atlasUtilization)
         };
     }];
 }
@@ -4384,7 +4707,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
         if (!scene) {
             return @{};
         }
-        SceneCommands::StaticLightmapBakeStats stats = SceneCommands::bakeStaticLightmaps(scene);
+        SceneCommands::StaticLightmapBakeStats stats = SceneCommands::bakeStaticLightmaps(scene, "", [self staticLightmapBakeHooks]);
         if (_engine && _engine->getRenderer()) {
             _engine->getRenderer()->invalidateStaticLightingResources();
         }
@@ -4397,11 +4720,26 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             @"layoutRendererCount": @(stats.layoutRendererCount),
             @"layoutSkippedRendererCount": @(stats.layoutSkippedRendererCount),
             @"generatedUVRendererCount": @(stats.generatedUVRendererCount),
-            @"reusedUVRendererCount": @(stats.reusedUVRendererCount)
+            @"reusedUVRendererCount": @(stats.reusedUVRendererCount),
+            @"skippedAtlasCount": @(stats.skippedAtlasCount),
+            @"cancelled": @(stats.cancelled)
         };
     }];
 }
 
+// Not routed through the engine thread, which is busy for the whole bake.
+- (NSDictionary *)getStaticLightmapBakeProgress {
+    SceneCommands::StaticLightmapBakeProgress progress = SceneCommands::getStaticLightmapBakeProgress();
+    return @{
+        @"active": @(progress.active),
+        @"progress": @(progress.progress)
+    };
+}
+
+- (void)cancelStaticLightmapBake {
+    SceneCommands::cancelStaticLightmapBake();
+}
+
 // MARK: - Material Assets
 
 - (NSString *)createMaterialAssetFromEntity:(NSString *)uuid name:(NSString *)name {
@@ -4483,6 +4821,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
         props["heightInvert"] = material->getHeightInvert();
         props["renderMode"] = static_cast<int>(material->getRenderMode());
         props["alphaCutoff"] = material->getAlphaCutoff();
+        props["transparencyMode"] = static_cast<int>(material->getTransparencyMode());
         props["cullMode"] = static_cast<int>(material->getCullMode());
         props["twoSided"] = material->isTwoSided();
         props["alphaToCoverage"] = material->getAlphaToCoverage();
@@ -4650,13 +4989,152 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             return @{};
         }
         const auto& stats = _engine->getRenderer()->getStats();
+        const InputManager::LatencyStats inputLatency = InputManager::getInstance().getLatencyStats();
+        NSMutableArray<NSNumber *>* compileHistogram = [NSMutableArray arrayWithCapacity:stats.pipelineCompileHistogram.size()];
+        for (uint32_t count : stats.pipelineCompileHistogram) {
+            [compileHistogram addObject:@(count)];
+        }
+        NSMutableDictionary<NSString *, NSNumber *>* gpuPassTimes = [NSMutableDictionary dictionaryWithCapacity:kGPUPassCount];
+        for (size_t pass = 0; pass < kGPUPassCount; ++pass) {
+            gpuPassTimes[[NSString stringWithUTF8String:GPUPassName(static_cast<GPUPass>(pass))]] = @(stats.gpuPassTimeMs[pass]);
+        }
+        NSMutableArray<NSNumber *>* cullLodDraws = [NSMutableArray arrayWithCapacity:stats.cullLodDraws.size()];
+        for (uint32_t count : stats.cullLodDraws) {
+            [cullLodDraws addObject:@(count)];
+        }
+        NSMutableDictionary<NSString *, NSDictionary *>* passWork = [NSMutableDictionary dictionaryWithCapacity:kGPUPassCount];
+        for (size_t pass = 0; pass < kGPUPassCount; ++pass) {
+            const GPUPassWork& work = stats.passWork[pass];
+            if (work.encoders == 0) {
+                continue;
+            }
+            passWork[[NSString stringWithUTF8String:GPUPassName(static_cast<GPUPass>(pass))]] = @{
+                @"encoders": @(work.encoders),
+                @"draws": @(work.draws),
+                @"pipelineBinds": @(work.pipelineBinds),
+                @"bufferBinds": @(work.bufferBinds),
+                @"textureBinds": @(work.textureBinds),
+                @"inlineBytes": @(work.inlineBytes),
+                @"ringBytes": @(work.ringBytes)
+            };
+        }
+        NSMutableArray<NSDictionary *>* shadowLightDraws = [NSMutableArray arrayWithCapacity:stats.shadowLightDraws.size()];
+        for (const ShadowLightStats& light : stats.shadowLightDraws) {
+            [shadowLightDraws addObject:@{
+                @"light": [NSString stringWithUTF8String:light.light.toString().c_str()],
+                @"draws": @(light.draws)
+            }];
+        }
         return @{
             @"drawCalls": @(stats.drawCalls),
             @"triangles": @(stats.triangles),
             @"vertices": @(stats.vertices),
             @"instanceInput": @(stats.instanceInput),
             @"instanceVisible": @(stats.instanceVisible),
-            @"frameTimeMs": @(stats.frameTime)
+            @"instancesCached": @(stats.instancesCached),
+            @"foliageTilesScattered": @(stats.foliageTilesScattered),
+            @"foliageTilesResident": @(stats.foliageTilesResident),
+            @"terrainVirtualPagesComposited": @(stats.terrainVirtualPagesComposited),
+            @"terrainVirtualPagesResident": @(stats.terrainVirtualPagesResident),
+            @"particleEmitters": @(stats.particleEmitters),
+            @"particleEmittersSimulated": @(stats.particleEmittersSimulated),
+            @"particleCapacity": @(stats.particleCapacity),
+            @"skyLutBakes": @(stats.skyLutBakes),
+            @"skyLightingFaces": @(stats.skyLightingFaces),
+            @"frameViews": @(stats.frameViews),
+            @"pickDraws": @(stats.pickDraws),
+            @"weightedTransparentDraws": @(stats.weightedTransparentDraws),
+            @"lowResTransparentDraws": @(stats.lowResTransparentDraws),
+            @"occlusionVisible": @(stats.occlusionVisible),
+            @"occlusionOccluded": @(stats.occlusionOccluded),
+            @"cullCandidates": @(stats.cullCandidates),
+            @"cullFrustumVisible": @(stats.cullFrustumVisible),
+            @"cullOcclusionTested": @(stats.cullOcclusionTested),
+            @"cullLodDraws": cullLodDraws,
+            @"passWork": passWork,
+            @"shadowLightDraws": shadowLightDraws,
+            @"commandBuffers": @(stats.commandBuffers),
+            @"uniformBytesUploaded": @(stats.uniformBytesUploaded),
+            @"uniformRingOverflows": @(stats.uniformRingOverflows),
+            @"skinningBytesUploaded": @(stats.skinningBytesUploaded),
+            @"instanceBytesUploaded": @(stats.instanceBytesUploaded),
+            @"skinningCacheMeshes": @(stats.skinningCacheMeshes),
+            @"crowdInstances": @(stats.crowdInstances),
+            @"parallelEncoders": @(stats.parallelEncoders),
+            @"asyncComputePasses": @(stats.asyncComputePasses),
+            @"fogFroxels": @(stats.fogFroxels),
+            @"fogFroxelsLit": @(stats.fogFroxelsLit),
+            @"drawStateBinds": @(stats.drawStateBinds),
+            @"drawStateBindsSkipped": @(stats.drawStateBindsSkipped),
+            @"shadowViewsCached": @(stats.shadowViewsCached),
+            @"shadowViewsRefreshed": @(stats.shadowViewsRefreshed),
+            @"shadowPagesCached": @(stats.shadowPagesCached),
+            @"shadowPagesRendered": @(stats.shadowPagesRendered),
+            @"shadowTilesDowngraded": @(stats.shadowTilesDowngraded),
+            @"shadowViewsDeferred": @(stats.shadowViewsDeferred),
+            @"shadowViewsRestored": @(stats.shadowViewsRestored),
+            @"clustersActive": @(stats.clustersActive),
+            @"clustersOverflowed": @(stats.clustersOverflowed),
+            @"clusterLightsDropped": @(stats.clusterLightsDropped),
+            @"clusterTileLightsDropped": @(stats.clusterTileLightsDropped),
+            @"lightRecordsUploaded": @(stats.lightRecordsUploaded),
+            @"materialTableEntries": @(stats.materialTableEntries),
+            @"residentResources": @(stats.residentResources),
+            @"renderTargetHeapBytes": @(stats.renderTargetHeapBytes),
+            @"renderTargetAliasedBytes": @(stats.renderTargetAliasedBytes),
+            @"transientAllocations": @(stats.transientAllocations),
+            @"pipelineCompileHistogram": compileHistogram,
+            @"pipelinesCompiling": @(stats.pipelinesCompiling),
+            @"texturesStreaming": @(stats.texturesStreaming),
+            @"mipStreamedTextures": @(stats.mipStreamedTextures),
+            @"mipStreamedBytes": @(stats.mipStreamedBytes),
+            @"mipLoadsInFlight": @(stats.mipLoadsInFlight),
+            @"pipelineFallbackDraws": @(stats.pipelineFallbackDraws),
+            @"slowestPipelineKey": @(stats.slowestPipelineKey),
+            @"slowestPipelineCompileMs": @(stats.slowestPipelineCompileMs),
+            @"interpolatedFrames": @(stats.interpolatedFrames),
+            @"lateLatchedFrames": @(stats.lateLatchedFrames),
+            @"gpuFrameTimeMs": @(stats.gpuFrameTimeMs),
+            @"gpuLastFrameTimeMs": @(stats.gpuLastFrameTimeMs),
+            @"frameSlotWaitMs": @(stats.frameSlotWaitMs),
+            @"drawableWaitMs": @(stats.drawableWaitMs),
+            @"drawableHoldMs": @(stats.drawableHoldMs),
+            @"gpuPassTimesMs": gpuPassTimes,
+            @"renderScale": @(stats.renderScale),
+            @"shadedPixelRatio": @(stats.shadedPixelRatio),
+            @"frameTimeMs": @(stats.frameTime),
+            @"inputToUpdateMs": @(inputLatency.eventToUpdateMs),
+            @"inputToPhotonMs": @(inputLatency.eventToPresentMs),
+            @"inputToPhotonLastMs": @(inputLatency.lastEventToPresentMs),
+            @"inputEventsProcessed": @(inputLatency.eventsProcessed),
+            @"inputEventsDropped": @(inputLatency.eventsDropped)
+        };
+    }];
+}
+
+- (NSDictionary *)getPhysicsStats {
+    return (NSDictionary *)[self performSyncObject:^id{
+        Scene* scene = SceneManager::getInstance().getActiveScene();
+        if (!scene || !scene->getPhysicsWorld()) {
+            return @{};
+        }
+        const auto& stats = scene->getPhysicsWorld()->getStats();
+        return @{
+            @"stepTimeMs": @(stats.stepTimeMs),
+            @"collisionSteps": @(stats.collisionSteps),
+            @"bodies": @(stats.bodies),
+            @"activeBodies": @(stats.activeBodies),
+            @"broadphasePairs": @(stats.broadphasePairs),
+            @"maxBodyPairs": @(stats.maxBodyPairs),
+            @"contactConstraints": @(stats.contactConstraints),
+            @"maxContactConstraints": @(stats.maxContactConstraints),
+            @"raycasts": @(stats.raycasts),
+            @"sphereCasts": @(stats.sphereCasts),
+            @"boxCasts": @(stats.boxCasts),
+            @"capsuleCasts": @(stats.capsuleCasts),
+            @"overlapSpheres": @(stats.overlapSpheres),
+            @"overlapBoxes": @(stats.overlapBoxes),
+            @"scaleRebuilds": @(stats.scaleRebuilds)
         };
     }];
 }
@@ -4690,7 +5168,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
         if (!_engine || !_engine->getRenderer()) {
             return NO;
         }
-        bool ok = _engine->getRenderer()->loadEnvironmentMap([path UTF8String]);
+        bool ok = _engine->getRenderer()->requestEnvironmentMap([path UTF8String]);
         Scene* scene = SceneManager::getInstance().getActiveScene();
         if (scene && ok && path) {
             scene->getSettings().environment.skyboxPath = [path UTF8String];
@@ -4717,6 +5195,33 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
     }];
 }
 
+- (BOOL)cookPipelineArchive:(NSArray<NSString *> *)scenePaths outputPath:(NSString *)outputPath {
+    return [self performSyncBool:^BOOL {
+        Scene* scene = SceneManager::getInstance().getActiveScene();
+        if (!_engine || !_engine->getRenderer() || !scene || !scenePaths || !outputPath) {
+            return NO;
+        }
+        Renderer* renderer = _engine->getRenderer();
+        if (!renderer->beginPipelineArchive()) {
+            return NO;
+        }
+        for (NSString* scenePath in scenePaths) {
+            scene->deserialize(scenePath.UTF8String);
+            renderer->recordScenePipelines(scene);
+        }
+        return renderer->writePipelineArchive(outputPath.UTF8String) ? YES : NO;
+    }];
+}
+
+- (BOOL)loadPipelineArchive:(NSString *)path {
+    return [self performSyncBool:^BOOL {
+        if (!_engine || !_engine->getRenderer() || !path) {
+            return NO;
+        }
+        return _engine->getRenderer()->loadPipelineArchive(path.UTF8String) ? YES : NO;
+    }];
+}
+
 - (void)resetEnvironment {
     [self performAsync:^{
         if (_engine && _engine->getRenderer()) {
@@ -4871,8 +5376,8 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
         if (!scene || !path) {
             return NO;
         }
-        scene->serialize(path.UTF8String);
-        return YES;
+        // Only the snapshot holds the engine thread; the file is written in the background.
+        return SceneSerializer::SaveSceneAsync(scene, path.UTF8String) ? YES : NO;
     }];
 }
 
@@ -4901,6 +5406,29 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
     }];
 }
 
+- (BOOL)preloadSceneAtPath:(NSString *)path {
+    return [self performSyncBool:^BOOL {
+        if (!path) {
+            return NO;
+        }
+        return SceneManager::getInstance().preloadScene(path.UTF8String);
+    }];
+}
+
+- (int)preloadedSceneState {
+    return [self performSyncInt:^int {
+        return static_cast<int>(SceneManager::getInstance().getPreloadState());
+    }];
+}
+
+- (BOOL)activatePreloadedScene {
+    return [self performSyncBool:^BOOL {
+        [self finishActiveTerrainStrokeInternal];
+        [self clearTerrainBrushPreviewInternal];
+        return SceneManager::getInstance().activatePreloadedScene() != nullptr;
+    }];
+}
+
 - (void)enterPlayMode {
     [self performAsync:^{
         [self finishActiveTerrainStrokeInternal];
@@ -4977,6 +5505,11 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             return NO;
         }
         auto project = ProjectManager::getInstance().createProject(path.UTF8String, name.UTF8String);
+        if (project && _engine) {
+            _engine->setPipelinedRendering(project->getSettings().pipelinedRendering);
+            _engine->setEditorRedrawOnDemand(project->getSettings().editorRedrawOnDemand);
+            _engine->setLowLatencyPresentation(project->getSettings().lowLatencyPresentation);
+        }
         return project != nullptr;
     }];
 }
@@ -4987,6 +5520,11 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             return NO;
         }
         auto project = ProjectManager::getInstance().openProject(path.UTF8String);
+        if (project && _engine) {
+            _engine->setPipelinedRendering(project->getSettings().pipelinedRendering);
+            _engine->setEditorRedrawOnDemand(project->getSettings().editorRedrawOnDemand);
+            _engine->setLowLatencyPresentation(project->getSettings().lowLatencyPresentation);
+        }
         return project != nullptr;
     }];
 }
@@ -5035,7 +5573,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
                 db.getRecordForPath(pathStr, record);
             }
         }
-        if (record.guid.empty()) {
+        if (!record.guid.isValid()) {
             return @{};
         }
 
@@ -5050,7 +5588,8 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             @"generateMipmaps": @(record.textureSettings.generateMipmaps),
             @"flipY": @(record.textureSettings.flipY),
             @"maxSize": @(record.textureSettings.maxSize),
-            @"normalMap": @(record.textureSettings.normalMap)
+            @"normalMap": @(record.textureSettings.normalMap),
+            @"blockSize": @(record.textureSettings.blockSize)
         };
         NSDictionary* hdri = @{
             @"flipY": @(record.hdriSettings.flipY),
@@ -5058,7 +5597,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
         };
 
         return @{
-            @"guid": [NSString stringWithUTF8String:record.guid.c_str()],
+            @"guid": [NSString stringWithUTF8String:record.guid.toString().c_str()],
             @"type": [NSString stringWithUTF8String:record.type.c_str()],
             @"model": model,
             @"texture": texture,
@@ -5096,11 +5635,13 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
         NSNumber* flipY = settings[@"flipY"];
         NSNumber* maxSize = settings[@"maxSize"];
         NSNumber* normalMap = settings[@"normalMap"];
+        NSNumber* blockSize = settings[@"blockSize"];
         if (srgb) imported.srgb = srgb.boolValue;
         if (generateMipmaps) imported.generateMipmaps = generateMipmaps.boolValue;
         if (flipY) imported.flipY = flipY.boolValue;
         if (maxSize) imported.maxSize = maxSize.intValue;
         if (normalMap) imported.normalMap = normalMap.boolValue;
+        if (blockSize) imported.blockSize = blockSize.intValue;
         return AssetDatabase::getInstance().updateTextureImportSettings(guid.UTF8String, imported);
     }];
 }
@@ -5184,7 +5725,24 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
                 @"renderScale": @(quality.renderScale),
                 @"lodBias": @(quality.lodBias),
                 @"textureQuality": @(quality.textureQuality),
-                @"upscaler": @(quality.upscaler)
+                @"upscaler": @(quality.upscaler),
+                @"frameInterpolation": @(quality.frameInterpolation),
+                @"shadowCascadeUpdateIntervals": @[@(quality.shadowCascadeUpdateIntervals[0]), @(quality.shadowCascadeUpdateIntervals[1]),
+                                                   @(quality.shadowCascadeUpdateIntervals[2]), @(quality.shadowCascadeUpdateIntervals[3])],
+                @"shadowUpdateBudget": @(quality.shadowUpdateBudget),
+                @"asyncClusterBuild": @(quality.asyncClusterBuild),
+                @"asyncFogVolume": @(quality.asyncFogVolume),
+                @"ssaoResolution": @(quality.ssaoResolution),
+                @"dynamicResolution": @(quality.dynamicResolution),
+                @"dynamicResolutionTargetMs": @(quality.dynamicResolutionTargetMs),
+                @"dynamicResolutionMinScale": @(quality.dynamicResolutionMinScale),
+                @"variableRateShading": @(quality.variableRateShading),
+                @"variableRateShadingPeriphery": @(quality.variableRateShadingPeriphery),
+                @"particleBudget": @(quality.particleBudget),
+                @"particleCollision": @(quality.particleCollision),
+                @"halfPrecisionShading": @(quality.halfPrecisionShading),
+                @"visibilityBuffer": @(quality.visibilityBuffer),
+                @"compactRenderTargets": @(quality.compactRenderTargets)
             };
         };
         NSMutableArray* assetPaths = [NSMutableArray array];
@@ -5222,9 +5780,23 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             @"bundleIdentifier": [NSString stringWithUTF8String:settings.bundleIdentifier.c_str()],
             @"startupScene": [NSString stringWithUTF8String:settings.startupScene.c_str()],
             @"assetPaths": assetPaths,
+            @"pipelinedRendering": @(settings.pipelinedRendering),
+            @"editorRedrawOnDemand": @(settings.editorRedrawOnDemand),
+            @"lowLatencyPresentation": @(settings.lowLatencyPresentation),
             @"renderProfiles": renderProfiles,
             @"qualityPresets": qualityPresets,
-            @"inputBindings": inputBindings
+            @"inputBindings": inputBindings,
+            @"physics": @{
+                @"fixedTimeStep": @(settings.physics.fixedTimeStep),
+                @"maxBodies": @(settings.physics.maxBodies),
+                @"maxBodyPairs": @(settings.physics.maxBodyPairs),
+                @"maxContactConstraints": @(settings.physics.maxContactConstraints),
+                @"tempAllocatorMB": @(settings.physics.tempAllocatorMB)
+            },
+            @"audio": @{
+                @"maxRealVoices": @(settings.audio.maxRealVoices),
+                @"audibilityThreshold": @(settings.audio.audibilityThreshold)
+            }
         };
     }];
 }
@@ -5250,6 +5822,27 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             if (dict[@"lodBias"]) quality.lodBias = [dict[@"lodBias"] floatValue];
             if (dict[@"textureQuality"]) quality.textureQuality = [dict[@"textureQuality"] intValue];
             if (dict[@"upscaler"]) quality.upscaler = [dict[@"upscaler"] intValue];
+            if (dict[@"frameInterpolation"]) quality.frameInterpolation = [dict[@"frameInterpolation"] boolValue];
+            NSArray* intervals = dict[@"shadowCascadeUpdateIntervals"];
+            if ([intervals isKindOfClass:[NSArray class]]) {
+                for (NSUInteger i = 0; i < MIN(4, intervals.count); ++i) {
+                    quality.shadowCascadeUpdateIntervals[i] = [intervals[i] intValue];
+                }
+            }
+            if (dict[@"shadowUpdateBudget"]) quality.shadowUpdateBudget = [dict[@"shadowUpdateBudget"] intValue];
+            if (dict[@"asyncClusterBuild"]) quality.asyncClusterBuild = [dict[@"asyncClusterBuild"] boolValue];
+            if (dict[@"asyncFogVolume"]) quality.asyncFogVolume = [dict[@"asyncFogVolume"] boolValue];
+            if (dict[@"ssaoResolution"]) quality.ssaoResolution = [dict[@"ssaoResolution"] intValue];
+            if (dict[@"dynamicResolution"]) quality.dynamicResolution = [dict[@"dynamicResolution"] boolValue];
+            if (dict[@"dynamicResolutionTargetMs"]) quality.dynamicResolutionTargetMs = [dict[@"dynamicResolutionTargetMs"] floatValue];
+            if (dict[@"dynamicResolutionMinScale"]) quality.dynamicResolutionMinScale = [dict[@"dynamicResolutionMinScale"] floatValue];
+            if (dict[@"variableRateShading"]) quality.variableRateShading = [dict[@"variableRateShading"] boolValue];
+            if (dict[@"variableRateShadingPeriphery"]) quality.variableRateShadingPeriphery = [dict[@"variableRateShadingPeriphery"] floatValue];
+            if (dict[@"particleBudget"]) quality.particleBudget = [dict[@"particleBudget"] intValue];
+            if (dict[@"particleCollision"]) quality.particleCollision = [dict[@"particleCollision"] boolValue];
+            if (dict[@"halfPrecisionShading"]) quality.halfPrecisionShading = [dict[@"halfPrecisionShading"] boolValue];
+            if (dict[@"visibilityBuffer"]) quality.visibilityBuffer = [dict[@"visibilityBuffer"] boolValue];
+            if (dict[@"compactRenderTargets"]) quality.compactRenderTargets = [dict[@"compactRenderTargets"] boolValue];
             return quality;
         };
         if (settings[@"defaultRenderProfile"]) {
@@ -5279,6 +5872,15 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
                 updated.assetPaths.emplace_back("Assets");
             }
         }
+        if (settings[@"pipelinedRendering"]) {
+            updated.pipelinedRendering = [settings[@"pipelinedRendering"] boolValue];
+        }
+        if (settings[@"editorRedrawOnDemand"]) {
+            updated.editorRedrawOnDemand = [settings[@"editorRedrawOnDemand"] boolValue];
+        }
+        if (settings[@"lowLatencyPresentation"]) {
+            updated.lowLatencyPresentation = [settings[@"lowLatencyPresentation"] boolValue];
+        }
         if (settings[@"renderProfiles"] && [settings[@"renderProfiles"] isKindOfClass:[NSArray class]]) {
             NSArray* profiles = settings[@"renderProfiles"];
             if (profiles.count > 0) {
@@ -5336,8 +5938,28 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
                 updated.inputBindings.push_back(binding);
             }
         }
+        if (settings[@"physics"] && [settings[@"physics"] isKindOfClass:[NSDictionary class]]) {
+            // Applies to worlds created from here on, i.e. the next scene load or play session.
+            NSDictionary* physics = (NSDictionary *)settings[@"physics"];
+            if (physics[@"fixedTimeStep"]) updated.physics.fixedTimeStep = std::clamp([physics[@"fixedTimeStep"] floatValue], 0.001f, 0.1f);
+            if (physics[@"maxBodies"]) updated.physics.maxBodies = std::max(1u, [physics[@"maxBodies"] unsignedIntValue]);
+            if (physics[@"maxBodyPairs"]) updated.physics.maxBodyPairs = std::max(1u, [physics[@"maxBodyPairs"] unsignedIntValue]);
+            if (physics[@"maxContactConstraints"]) updated.physics.maxContactConstraints = std::max(1u, [physics[@"maxContactConstraints"] unsignedIntValue]);
+            if (physics[@"tempAllocatorMB"]) updated.physics.tempAllocatorMB = std::max(1u, [physics[@"tempAllocatorMB"] unsignedIntValue]);
+        }
+        if (settings[@"audio"] && [settings[@"audio"] isKindOfClass:[NSDictionary class]]) {
+            // Read by the audio system every frame, so it applies right away.
+            NSDictionary* audio = (NSDictionary *)settings[@"audio"];
+            if (audio[@"maxRealVoices"]) updated.audio.maxRealVoices = std::max(1u, [audio[@"maxRealVoices"] unsignedIntValue]);
+            if (audio[@"audibilityThreshold"]) updated.audio.audibilityThreshold = std::max(0.0f, [audio[@"audibilityThreshold"] floatValue]);
+        }
         project->setSettings(updated);
         project->save();
+        if (_engine) {
+            _engine->setPipelinedRendering(updated.pipelinedRendering);
+            _engine->setEditorRedrawOnDemand(updated.editorRedrawOnDemand);
+            _engine->setLowLatencyPresentation(updated.lowLatencyPresentation);
+        }
     }];
 }
 
@@ -5401,7 +6023,8 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             @"volumetricScattering": @(settings.fog.volumetricScattering),
             @"volumetricAnisotropy": @(settings.fog.volumetricAnisotropy),
             @"volumetricHistoryWeight": @(settings.fog.volumetricHistoryWeight),
-            @"volumetricQuality": @(settings.fog.volumetricQuality)
+            @"volumetricQuality": @(settings.fog.volumetricQuality),
+            @"volumetricUpdateRate": @(settings.fog.volumetricUpdateRate)
         };
 
         NSDictionary* postProcess = @{
@@ -5448,7 +6071,24 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             @"renderScale": @(settings.quality.renderScale),
             @"lodBias": @(settings.quality.lodBias),
             @"textureQuality": @(settings.quality.textureQuality),
-            @"upscaler": @(settings.quality.upscaler)
+            @"upscaler": @(settings.quality.upscaler),
+            @"frameInterpolation": @(settings.quality.frameInterpolation),
+            @"shadowCascadeUpdateIntervals": @[@(settings.quality.shadowCascadeUpdateIntervals[0]), @(settings.quality.shadowCascadeUpdateIntervals[1]),
+                                               @(settings.quality.shadowCascadeUpdateIntervals[2]), @(settings.quality.shadowCascadeUpdateIntervals[3])],
+            @"shadowUpdateBudget": @(settings.quality.shadowUpdateBudget),
+            @"asyncClusterBuild": @(settings.quality.asyncClusterBuild),
+            @"asyncFogVolume": @(settings.quality.asyncFogVolume),
+            @"ssaoResolution": @(settings.quality.ssaoResolution),
+            @"dynamicResolution": @(settings.quality.dynamicResolution),
+            @"dynamicResolutionTargetMs": @(settings.quality.dynamicResolutionTargetMs),
+            @"dynamicResolutionMinScale": @(settings.quality.dynamicResolutionMinScale),
+            @"variableRateShading": @(settings.quality.variableRateShading),
+            @"variableRateShadingPeriphery": @(settings.quality.variableRateShadingPeriphery),
+            @"particleBudget": @(settings.quality.particleBudget),
+            @"particleCollision": @(settings.quality.particleCollision),
+            @"halfPrecisionShading": @(settings.quality.halfPrecisionShading),
+            @"visibilityBuffer": @(settings.quality.visibilityBuffer),
+            @"compactRenderTargets": @(settings.quality.compactRenderTargets)
         };
 
         NSDictionary* staticLighting = @{
@@ -5460,6 +6100,11 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             @"samplesPerTexel": @(settings.staticLighting.samplesPerTexel),
             @"indirectBounces": @(settings.staticLighting.indirectBounces),
             @"denoise": @(settings.staticLighting.denoise),
+            @"gpuBake": @(settings.staticLighting.gpuBake),
+            @"progressiveBake": @(settings.staticLighting.progressiveBake),
+            @"progressivePasses": @(settings.staticLighting.progressivePasses),
+            @"progressivePreviewSeconds": @(settings.staticLighting.progressivePreviewSeconds),
+            @"progressiveFrameBudgetMs": @(settings.staticLighting.progressiveFrameBudgetMs),
             @"bakeDirectLighting": @(settings.staticLighting.bakeDirectLighting),
             @"directionalLightmaps": @(settings.staticLighting.directionalLightmaps),
             @"shadowmask": @(settings.staticLighting.shadowmask),
@@ -5470,12 +6115,31 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             @"lastBakeHash": [NSString stringWithUTF8String:settings.staticLighting.lastBakeHash.c_str()]
         };
 
+        NSDictionary* streaming = @{
+            @"enabled": @(settings.streaming.enabled),
+            @"cellSize": @(settings.streaming.cellSize),
+            @"loadRadius": @(settings.streaming.loadRadius),
+            @"unloadRadius": @(settings.streaming.unloadRadius),
+            @"activationBudgetMs": @(settings.streaming.activationBudgetMs)
+        };
+
+        NSDictionary* navigation = @{
+            @"enabled": @(settings.navigation.enabled),
+            @"cellSize": @(settings.navigation.cellSize),
+            @"agentRadius": @(settings.navigation.agentRadius),
+            @"agentHeight": @(settings.navigation.agentHeight),
+            @"maxSlopeDegrees": @(settings.navigation.maxSlopeDegrees),
+            @"stepHeight": @(settings.navigation.stepHeight)
+        };
+
         return @{
             @"environment": environment,
             @"fog": fog,
             @"postProcess": postProcess,
             @"quality": quality,
-            @"staticLighting": staticLighting
+            @"staticLighting": staticLighting,
+            @"streaming": streaming,
+            @"navigation": navigation
         };
     }];
 }
@@ -5582,6 +6246,9 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             if (fog[@"volumetricQuality"]) {
                 updated.fog.volumetricQuality = [fog[@"volumetricQuality"] intValue];
             }
+            if (fog[@"volumetricUpdateRate"]) {
+                updated.fog.volumetricUpdateRate = [fog[@"volumetricUpdateRate"] intValue];
+            }
         }
         if (settings[@"postProcess"] && [settings[@"postProcess"] isKindOfClass:[NSDictionary class]]) {
             NSDictionary* post = settings[@"postProcess"];
@@ -5634,6 +6301,27 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             if (quality[@"lodBias"]) updated.quality.lodBias = [quality[@"lodBias"] floatValue];
             if (quality[@"textureQuality"]) updated.quality.textureQuality = [quality[@"textureQuality"] intValue];
             if (quality[@"upscaler"]) updated.quality.upscaler = [quality[@"upscaler"] intValue];
+            if (quality[@"frameInterpolation"]) updated.quality.frameInterpolation = [quality[@"frameInterpolation"] boolValue];
+            NSArray* intervals = quality[@"shadowCascadeUpdateIntervals"];
+            if ([intervals isKindOfClass:[NSArray class]]) {
+                for (NSUInteger i = 0; i < MIN(4, intervals.count); ++i) {
+                    updated.quality.shadowCascadeUpdateIntervals[i] = [intervals[i] intValue];
+                }
+            }
+            if (quality[@"shadowUpdateBudget"]) updated.quality.shadowUpdateBudget = [quality[@"shadowUpdateBudget"] intValue];
+            if (quality[@"asyncClusterBuild"]) updated.quality.asyncClusterBuild = [quality[@"asyncClusterBuild"] boolValue];
+            if (quality[@"asyncFogVolume"]) updated.quality.asyncFogVolume = [quality[@"asyncFogVolume"] boolValue];
+            if (quality[@"ssaoResolution"]) updated.quality.ssaoResolution = [quality[@"ssaoResolution"] intValue];
+            if (quality[@"dynamicResolution"]) updated.quality.dynamicResolution = [quality[@"dynamicResolution"] boolValue];
+            if (quality[@"dynamicResolutionTargetMs"]) updated.quality.dynamicResolutionTargetMs = [quality[@"dynamicResolutionTargetMs"] floatValue];
+            if (quality[@"dynamicResolutionMinScale"]) updated.quality.dynamicResolutionMinScale = [quality[@"dynamicResolutionMinScale"] floatValue];
+            if (quality[@"variableRateShading"]) updated.quality.variableRateShading = [quality[@"variableRateShading"] boolValue];
+            if (quality[@"variableRateShadingPeriphery"]) updated.quality.variableRateShadingPeriphery = [quality[@"variableRateShadingPeriphery"] floatValue];
+            if (quality[@"particleBudget"]) updated.quality.particleBudget = [quality[@"particleBudget"] intValue];
+            if (quality[@"particleCollision"]) updated.quality.particleCollision = [quality[@"particleCollision"] boolValue];
+            if (quality[@"halfPrecisionShading"]) updated.quality.halfPrecisionShading = [quality[@"halfPrecisionShading"] boolValue];
+            if (quality[@"visibilityBuffer"]) updated.quality.visibilityBuffer = [quality[@"visibilityBuffer"] boolValue];
+            if (quality[@"compactRenderTargets"]) updated.quality.compactRenderTargets = [quality[@"compactRenderTargets"] boolValue];
         }
         if (settings[@"staticLighting"] && [settings[@"staticLighting"] isKindOfClass:[NSDictionary class]]) {
             NSDictionary* staticLighting = settings[@"staticLighting"];
@@ -5645,6 +6333,11 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
             if (staticLighting[@"samplesPerTexel"]) updated.staticLighting.samplesPerTexel = [staticLighting[@"samplesPerTexel"] intValue];
             if (staticLighting[@"indirectBounces"]) updated.staticLighting.indirectBounces = [staticLighting[@"indirectBounces"] intValue];
             if (staticLighting[@"denoise"]) updated.staticLighting.denoise = [staticLighting[@"denoise"] boolValue];
+            if (staticLighting[@"gpuBake"]) updated.staticLighting.gpuBake = [staticLighting[@"gpuBake"] boolValue];
+            if (staticLighting[@"progressiveBake"]) updated.staticLighting.progressiveBake = [staticLighting[@"progressiveBake"] boolValue];
+            if (staticLighting[@"progressivePasses"]) updated.staticLighting.progressivePasses = std::max(1, [staticLighting[@"progressivePasses"] intValue]);
+            if (staticLighting[@"progressivePreviewSeconds"]) updated.staticLighting.progressivePreviewSeconds = std::max(0.0f, [staticLighting[@"progressivePreviewSeconds"] floatValue]);
+            if (staticLighting[@"progressiveFrameBudgetMs"]) updated.staticLighting.progressiveFrameBudgetMs = std::max(1.0f, [staticLighting[@"progressiveFrameBudgetMs"] floatValue]);
             if (staticLighting[@"bakeDirectLighting"]) updated.staticLighting.bakeDirectLighting = [staticLighting[@"bakeDirectLighting"] boolValue];
             if (staticLighting[@"directionalLightmaps"]) updated.staticLighting.directionalLightmaps = [staticLighting[@"directionalLightmaps"] boolValue];
             if (staticLighting[@"shadowmask"]) updated.staticLighting.shadowmask = [staticLighting[@"shadowmask"] boolValue];
@@ -5669,6 +6362,25 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
                 }
             }
         }
+        if (settings[@"streaming"] && [settings[@"streaming"] isKindOfClass:[NSDictionary class]]) {
+            NSDictionary* streaming = settings[@"streaming"];
+            if (streaming[@"enabled"]) updated.streaming.enabled = [streaming[@"enabled"] boolValue];
+            if (streaming[@"cellSize"]) updated.streaming.cellSize = std::max(1.0f, [streaming[@"cellSize"] floatValue]);
+            if (streaming[@"loadRadius"]) updated.streaming.loadRadius = std::max(0.0f, [streaming[@"loadRadius"] floatValue]);
+            if (streaming[@"unloadRadius"]) updated.streaming.unloadRadius = [streaming[@"unloadRadius"] floatValue];
+            if (streaming[@"activationBudgetMs"]) updated.streaming.activationBudgetMs = std::max(0.1f, [streaming[@"activationBudgetMs"] floatValue]);
+            updated.streaming.unloadRadius = std::max(updated.streaming.unloadRadius, updated.streaming.loadRadius);
+        }
+        if (settings[@"navigation"] && [settings[@"navigation"] isKindOfClass:[NSDictionary class]]) {
+            NSDictionary* navigation = settings[@"navigation"];
+            if (navigation[@"enabled"]) updated.navigation.enabled = [navigation[@"enabled"] boolValue];
+            if (navigation[@"cellSize"]) updated.navigation.cellSize = std::max(0.05f, [navigation[@"cellSize"] floatValue]);
+            if (navigation[@"agentRadius"]) updated.navigation.agentRadius = std::max(0.05f, [navigation[@"agentRadius"] floatValue]);
+            if (navigation[@"agentHeight"]) updated.navigation.agentHeight = [navigation[@"agentHeight"] floatValue];
+            if (navigation[@"maxSlopeDegrees"]) updated.navigation.maxSlopeDegrees = std::clamp([navigation[@"maxSlopeDegrees"] floatValue], 0.0f, 89.0f);
+            if (navigation[@"stepHeight"]) updated.navigation.stepHeight = std::max(0.0f, [navigation[@"stepHeight"] floatValue]);
+            updated.navigation.agentHeight = std::max(updated.navigation.agentHeight, updated.navigation.agentRadius * 2.0f);
+        }
         scene->setSettings(updated);
         scene->applySettings();
     }];
@@ -5727,6 +6439,7 @@ static AnimatorBlendTreeType AnimatorBlendTreeTypeFromString(NSString* type) {
                     staticLighting.lightmapPath.clear();
                     staticLighting.directionalLightmapPath.clear();
                     staticLighting.shadowmaskPath.clear();
+                    staticLighting.bakeHash.clear();
                 }
             }
             if (NSNumber* contributeGI = info[@"contributeGI"]) {
@@ -5828,6 +6541,8 @@ static Crescent::Decal* GetDecalByUUID(const std::string& uuidStr) {
         NSMutableArray* splits = [NSMutableArray array];
         for (float s : light->getCascadeSplits()) { [splits addObject:@(s)]; }
         dict[@"cascadeSplits"] = splits;
+        dict[@"shadowPageCache"] = @(light->getShadowPageCache());
+        dict[@"shadowUpdateInterval"] = @(light->getShadowUpdateInterval());
         dict[@"cookieIndex"] = @(light->getCookieIndex());
         dict[@"iesIndex"] = @(light->getIESProfileIndex());
         dict[@"volumetric"] = @(light->getVolumetric());
@@ -5935,6 +6650,12 @@ static Crescent::Decal* GetDecalByUUID(const std::string& uuidStr) {
             }
             light->setCascadeSplits(s);
         }
+        if (NSNumber* pageCache = info[@"shadowPageCache"]) {
+            light->setShadowPageCache(pageCache.boolValue);
+        }
+        if (NSNumber* updateInterval = info[@"shadowUpdateInterval"]) {
+            light->setShadowUpdateInterval(updateInterval.unsignedIntValue);
+        }
         if (NSNumber* cookie = info[@"cookieIndex"]) {
             light->setCookieIndex(cookie.intValue);
         }
@@ -6697,7 +7418,11 @@ static Crescent::Decal* GetDecalByUUID(const std::string& uuidStr) {
         Animator* animator = GetAnimatorByUUID(uuid.UTF8String);
         if (!animator) return @[];
         NSMutableArray* events = [NSMutableArray array];
-        for (const auto& evt : animator->getFiredEvents()) {
+        const AnimationEventRing& fired = animator->getFiredEvents();
+        for (size_t i = 0; i < fired.size(); ++i) {
+            const AnimationEvent* firedEvent = fired[i].get();
+            if (!firedEvent) continue;
+            const AnimationEvent& evt = *firedEvent;
             [events addObject:@{
                 @"time": @(evt.time),
                 @"name": [NSString stringWithUTF8String:evt.name.c_str()],
@@ -6860,6 +7585,7 @@ static NSString* ColliderShapeToString(PhysicsCollider::ShapeType type) {
     case PhysicsCollider::ShapeType::Sphere: return @"Sphere";
     case PhysicsCollider::ShapeType::Capsule: return @"Capsule";
     case PhysicsCollider::ShapeType::Mesh: return @"Mesh";
+    case PhysicsCollider::ShapeType::Terrain: return @"Terrain";
     case PhysicsCollider::ShapeType::Box:
     default:
         return @"Box";
@@ -6871,6 +7597,7 @@ static PhysicsCollider::ShapeType ColliderShapeFromString(NSString* value) {
     if ([value isEqualToString:@"Sphere"]) return PhysicsCollider::ShapeType::Sphere;
     if ([value isEqualToString:@"Capsule"]) return PhysicsCollider::ShapeType::Capsule;
     if ([value isEqualToString:@"Mesh"]) return PhysicsCollider::ShapeType::Mesh;
+    if ([value isEqualToString:@"Terrain"]) return PhysicsCollider::ShapeType::Terrain;
     return PhysicsCollider::ShapeType::Box;
 }
 
@@ -7847,6 +8574,7 @@ static PhysicsCollider::CombineMode CombineModeFromString(NSString* value) {
             @"spatial": @(audio->isSpatial()),
             @"bus": [NSString stringWithUTF8String: AudioSystem::audioBusToString(audio->getBus())],
             @"stream": @(audio->isStreaming()),
+            @"loadMode": [NSString stringWithUTF8String: AudioSystem::audioLoadModeToString(audio->getLoadMode())],
             @"minDistance": @(audio->getMinDistance()),
             @"maxDistance": @(audio->getMaxDistance()),
             @"rolloff": @(audio->getRolloff())
@@ -7886,7 +8614,9 @@ static PhysicsCollider::CombineMode CombineModeFromString(NSString* value) {
         if (NSString* bus = info[@"bus"]) {
             audio->setBus(AudioSystem::audioBusFromString(bus.UTF8String));
         }
-        if (NSNumber* stream = info[@"stream"]) {
+        if (NSString* loadMode = info[@"loadMode"]) {
+            audio->setLoadMode(AudioSystem::audioLoadModeFromString(loadMode.UTF8String));
+        } else if (NSNumber* stream = info[@"stream"]) {
             audio->setStreaming(stream.boolValue);
         }
         if (NSNumber* minDistance = info[@"minDistance"]) {
@@ -7957,6 +8687,136 @@ static PhysicsCollider::CombineMode CombineModeFromString(NSString* value) {
     }];
 }
 
+- (void)setDebugDrawGPUPasses:(BOOL)enabled {
+    [self performAsync:^{
+        if (_engine && _engine->getRenderer()) {
+            _engine->getRenderer()->setDebugDrawGPUPasses(enabled);
+        }
+    }];
+}
+
+- (void)beginCPUProfileCapture {
+    Crescent::CPUProfiler::getInstance().beginCapture();
+}
+
+- (BOOL)endCPUProfileCaptureToPath:(NSString *)path {
+    if (!path) {
+        Crescent::CPUProfiler::getInstance().endCapture();
+        return NO;
+    }
+    return Crescent::CPUProfiler::getInstance().writeChromeTrace(std::string([path UTF8String])) ? YES : NO;
+}
+
+- (NSDictionary *)getMemoryReport {
+    const Crescent::MemoryTracker::Report report = Crescent::MemoryTracker::getInstance().getReport();
+    NSMutableDictionary* categories = [NSMutableDictionary dictionary];
+    for (size_t i = 0; i < Crescent::kMemoryCategoryCount; ++i) {
+        const auto category = static_cast<Crescent::MemoryCategory>(i);
+        const auto& stats = report.categories[i];
+        categories[[NSString stringWithUTF8String:Crescent::MemoryCategoryName(category)]] = @{
+            @"bytes": @(stats.bytes),
+            @"peakBytes": @(stats.peakBytes),
+            @"allocations": @(stats.allocations),
+            @"budgetBytes": @(stats.budgetBytes),
+            @"gpu": @(Crescent::IsGPUMemoryCategory(category))
+        };
+    }
+    return @{
+        @"categories": categories,
+        @"trackedGPUBytes": @(report.trackedGPUBytes),
+        @"trackedCPUBytes": @(report.trackedCPUBytes),
+        @"deviceAllocatedBytes": @(report.deviceAllocatedBytes),
+        @"deviceWorkingSetBytes": @(report.deviceWorkingSetBytes),
+        @"deviceBudgetBytes": @(report.deviceBudgetBytes),
+        @"processFootprintBytes": @(report.processFootprintBytes)
+    };
+}
+
+- (BOOL)setMemoryBudgetMB:(double)megabytes forCategory:(NSString *)category {
+    if (!category || megabytes < 0.0) {
+        return NO;
+    }
+    const std::string name([category UTF8String]);
+    for (size_t i = 0; i < Crescent::kMemoryCategoryCount; ++i) {
+        const auto memoryCategory = static_cast<Crescent::MemoryCategory>(i);
+        if (name == Crescent::MemoryCategoryName(memoryCategory)) {
+            Crescent::MemoryTracker::getInstance().setBudget(memoryCategory, static_cast<uint64_t>(megabytes * 1024.0 * 1024.0));
+            return YES;
+        }
+    }
+    return NO;
+}
+
+- (void)setDeviceMemoryBudgetMB:(double)megabytes {
+    Crescent::MemoryTracker::getInstance().setDeviceBudget(static_cast<uint64_t>(std::max(megabytes, 0.0) * 1024.0 * 1024.0));
+}
+
+- (void)logMemoryReport {
+    Crescent::MemoryTracker::getInstance().logReport("editor request");
+}
+
+static Crescent::SceneAnalysisSettings SceneAnalysisSettingsFromDictionary(NSDictionary* options) {
+    Crescent::SceneAnalysisSettings settings;
+    if (!options) {
+        return settings;
+    }
+    NSNumber* maxTriangles = options[@"maxTrianglesWithoutLods"];
+    if (maxTriangles) {
+        settings.maxTrianglesWithoutLods = maxTriangles.unsignedIntValue;
+    }
+    NSNumber* minDuplicates = options[@"minInstancingDuplicates"];
+    if (minDuplicates) {
+        settings.minInstancingDuplicates = std::max(2u, minDuplicates.unsignedIntValue);
+    }
+    NSNumber* maxOverlap = options[@"maxPointShadowOverlap"];
+    if (maxOverlap) {
+        settings.maxPointShadowOverlap = std::clamp(maxOverlap.floatValue, 0.0f, 1.0f);
+    }
+    NSNumber* maxTextureSize = options[@"maxTextureSize"];
+    if (maxTextureSize) {
+        settings.maxTextureSize = maxTextureSize.unsignedIntValue;
+    }
+    NSNumber* maxBones = options[@"maxBones"];
+    if (maxBones) {
+        settings.maxBones = maxBones.unsignedIntValue;
+    }
+    return settings;
+}
+
+- (NSArray<NSDictionary *> *)analyzeScenePerformance:(NSDictionary *)options {
+    return (NSArray *)[self performSyncObject:^id{
+        Scene* scene = SceneManager::getInstance().getActiveScene();
+        if (!scene) {
+            return @[];
+        }
+        std::vector<Crescent::SceneIssue> issues = Crescent::SceneAnalyzer::analyze(*scene, SceneAnalysisSettingsFromDictionary(options));
+        NSString* sortBy = options[@"sortBy"];
+        if ([sortBy isEqualToString:@"kind"]) {
+            Crescent::SceneAnalyzer::sort(issues, Crescent::SceneIssueSortKey::Kind);
+        } else if ([sortBy isEqualToString:@"entity"]) {
+            Crescent::SceneAnalyzer::sort(issues, Crescent::SceneIssueSortKey::Entity);
+        }
+        NSMutableArray<NSDictionary *>* result = [NSMutableArray arrayWithCapacity:issues.size()];
+        for (const Crescent::SceneIssue& issue : issues) {
+            NSMutableDictionary* entry = [@{
+                @"kind": [NSString stringWithUTF8String:Crescent::SceneIssueKindName(issue.kind)],
+                @"severity": [NSString stringWithUTF8String:Crescent::SceneIssueSeverityName(issue.severity)],
+                @"cost": @(issue.cost),
+                @"entity": [NSString stringWithUTF8String:issue.entity.toString().c_str()],
+                @"entityName": [NSString stringWithUTF8String:issue.entityName.c_str()],
+                @"asset": [NSString stringWithUTF8String:issue.asset.c_str()],
+                @"occurrences": @(issue.occurrences),
+                @"message": [NSString stringWithUTF8String:issue.message.c_str()]
+            } mutableCopy];
+            if (issue.related.isValid()) {
+                entry[@"relatedEntity"] = [NSString stringWithUTF8String:issue.related.toString().c_str()];
+            }
+            [result addObject:entry];
+        }
+        return result;
+    }];
+}
+
 - (void)setDebugDrawPointFrusta:(BOOL)enabled {
     [self performAsync:^{
         if (_engine && _engine->getRenderer()) {
@@ -1133,6 +1133,18 @@ private struct AssetImportSettingsPanel: View {
                 set: { textureOptions.normalMap = $0 }
             ))
             .font(EditorTheme.fontBody)
+
+            Picker("Compression", selection: Binding(
+                get: { textureOptions.blockSize },
+                set: { textureOptions.blockSize = $0 }
+            )) {
+                Text("Auto").tag(0)
+                Text("ASTC 4x4").tag(4)
+                Text("ASTC 6x6").tag(6)
+                Text("ASTC 8x8").tag(8)
+            }
+            .pickerStyle(.menu)
+            .font(EditorTheme.fontBody)
         }
     }
 
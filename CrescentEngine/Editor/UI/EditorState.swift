@@ -64,6 +64,7 @@ struct TextureImportOptions: Hashable {
     var flipY: Bool = false
     var maxSize: Int = 4096
     var normalMap: Bool = false
+    var blockSize: Int = 0
 
     func toDictionary() -> [String: Any] {
         [
@@ -71,7 +72,8 @@ struct TextureImportOptions: Hashable {
             "generateMipmaps": generateMipmaps,
             "flipY": flipY,
             "maxSize": maxSize,
-            "normalMap": normalMap
+            "normalMap": normalMap,
+            "blockSize": blockSize
         ]
     }
 
@@ -83,6 +85,7 @@ struct TextureImportOptions: Hashable {
         flipY = (dictionary["flipY"] as? NSNumber)?.boolValue ?? false
         maxSize = (dictionary["maxSize"] as? NSNumber)?.intValue ?? 4096
         normalMap = (dictionary["normalMap"] as? NSNumber)?.boolValue ?? false
+        blockSize = (dictionary["blockSize"] as? NSNumber)?.intValue ?? 0
     }
 }
 
@@ -216,6 +219,7 @@ class EditorState: ObservableObject {
     @Published var settingsWindowRequested: Bool = false
     @Published var isBuildingGame: Bool = false
     @Published var lastBuiltAppURL: URL?
+    @Published var modelImportProgress: [[AnyHashable: Any]] = []
     @Published var terrainPaintEnabled: Bool = false
     @Published var terrainBrushMode: TerrainBrushMode = .paint
     @Published var terrainPaintLayer: Int = 0
@@ -230,6 +234,11 @@ class EditorState: ObservableObject {
     @Published var terrainBrushAutoNormalize: Bool = true
     
     private var entityRefreshTimer: Timer?
+    // Scene and change-log version entityList mirrors; refreshes apply the engine's deltas since.
+    private var entityListScene: String = ""
+    private var entityListVersion: UInt64 = 0
+    private static let entityPageSize = 1024
+    private var hasPendingModelImport: Bool = false
     private var selectionRefreshTimer: Timer?
     private var lastEngineSelectionUUIDs: Set<String> = []  // Track engine selection changes
     private var assetRootAccessActive: Bool = false
@@ -274,11 +283,12 @@ class EditorState: ObservableObject {
         addLog(.info, "Crescent Engine Editor Started")
         addLog(.info, "Initializing Metal Renderer...")
         
-        // Keep selection responsive, but refresh the full hierarchy less aggressively.
+        // Keep selection responsive; hierarchy refreshes only fetch what changed, but still poll less often.
         selectionRefreshTimer = Timer.scheduledTimer(withTimeInterval: 0.2, repeats: true) { [weak self] _ in
             self?.refreshSelectionState()
+            self?.refreshModelImports()
         }
-        entityRefreshTimer = Timer.scheduledTimer(withTimeInterval: 1.25, repeats: true) { [weak self] _ in
+        entityRefreshTimer = Timer.scheduledTimer(withTimeInterval: 0.5, repeats: true) { [weak self] _ in
             self?.refreshEntityList()
         }
 
@@ -299,18 +309,66 @@ class EditorState: ObservableObject {
         }
     }
     
+    private static func makeEntityInfo(_ info: [String: Any]) -> EntityInfo {
+        let uuid = info["uuid"] as? String ?? ""
+        let name = info["name"] as? String ?? "Entity"
+        let parentUUID = info["parent"] as? String ?? ""
+        let hasSkinned = (info["skinned"] as? NSNumber)?.boolValue ?? false
+        let hasAnimator = (info["animator"] as? NSNumber)?.boolValue ?? false
+        let clipCount = (info["clipCount"] as? NSNumber)?.intValue ?? 0
+        return EntityInfo(uuid: uuid, name: name, parentUUID: parentUUID, hasSkinned: hasSkinned, hasAnimator: hasAnimator, clipCount: clipCount)
+    }
+
+    // Re-reads the whole hierarchy a page per engine call, so a large scene never holds the engine
+    // thread for the full list at once. Edits between pages arrive with the next delta.
+    private func fetchEntityPages(_ bridge: CrescentEngineBridge) -> [EntityInfo] {
+        var list: [EntityInfo] = []
+        var offset = 0
+        var total = 1
+        var first = true
+        while offset < total {
+            let page = bridge.getEntityInfoPage(from: offset, count: EditorState.entityPageSize) as! [String: Any]
+            if first {
+                entityListScene = page["scene"] as? String ?? ""
+                entityListVersion = (page["version"] as? NSNumber)?.uint64Value ?? 0
+                first = false
+            }
+            total = (page["total"] as? NSNumber)?.intValue ?? 0
+            let infos = page["entities"] as? [[String: Any]] ?? []
+            list.append(contentsOf: infos.map(EditorState.makeEntityInfo))
+            offset += EditorState.entityPageSize
+        }
+        return list
+    }
+
     func refreshEntityList() {
         let bridge = CrescentEngineBridge.shared()
-        let entityInfos = bridge.getAllEntityInfo() as! [[String: Any]]
-        
-        let newEntityList = entityInfos.map { info in
-            let uuid = info["uuid"] as? String ?? ""
-            let name = info["name"] as? String ?? "Entity"
-            let parentUUID = info["parent"] as? String ?? ""
-            let hasSkinned = (info["skinned"] as? NSNumber)?.boolValue ?? false
-            let hasAnimator = (info["animator"] as? NSNumber)?.boolValue ?? false
-            let clipCount = (info["clipCount"] as? NSNumber)?.intValue ?? 0
-            return EntityInfo(uuid: uuid, name: name, parentUUID: parentUUID, hasSkinned: hasSkinned, hasAnimator: hasAnimator, clipCount: clipCount)
+        let delta = bridge.getEntityChanges(since: entityListVersion, scene: entityListScene) as! [String: Any]
+
+        var newEntityList: [EntityInfo]
+        if (delta["reset"] as? NSNumber)?.boolValue ?? true {
+            newEntityList = fetchEntityPages(bridge)
+        } else {
+            entityListVersion = (delta["version"] as? NSNumber)?.uint64Value ?? entityListVersion
+            let removed = Set(delta["removed"] as? [String] ?? [])
+            let changed = (delta["changed"] as? [[String: Any]] ?? []).map(EditorState.makeEntityInfo)
+            if removed.isEmpty && changed.isEmpty {
+                refreshSelectionState()
+                return
+            }
+            newEntityList = removed.isEmpty ? entityList : entityList.filter { !removed.contains($0.uuid) }
+            var rowIndex: [String: Int] = [:]
+            for (index, entity) in newEntityList.enumerated() {
+                rowIndex[entity.uuid] = index
+            }
+            for entity in changed.reversed() {
+                if let index = rowIndex[entity.uuid] {
+                    newEntityList[index] = entity
+                } else {
+                    rowIndex[entity.uuid] = newEntityList.count
+                    newEntityList.append(entity)
+                }
+            }
         }
         
         // Only update if list actually changed
@@ -467,14 +525,14 @@ class EditorState: ObservableObject {
         if keyDownMonitor == nil {
             keyDownMonitor = NSEvent.addLocalMonitorForEvents(matching: [.keyDown]) { event in
                 guard self.shouldCaptureKeyboardEvent() else { return event }
-                CrescentEngineBridge.shared().handleKeyDown(event.keyCode)
+                CrescentEngineBridge.shared().handleKeyDown(event.keyCode, timestamp: event.timestamp)
                 return nil
             }
         }
         if keyUpMonitor == nil {
             keyUpMonitor = NSEvent.addLocalMonitorForEvents(matching: [.keyUp]) { event in
                 guard self.shouldCaptureKeyboardEvent() else { return event }
-                CrescentEngineBridge.shared().handleKeyUp(event.keyCode)
+                CrescentEngineBridge.shared().handleKeyUp(event.keyCode, timestamp: event.timestamp)
                 return nil
             }
         }
@@ -522,27 +580,27 @@ class EditorState: ObservableObject {
         switch event.keyCode {
         case 56, 60:
             if event.modifierFlags.contains(.shift) {
-                CrescentEngineBridge.shared().handleKeyDown(event.keyCode)
+                CrescentEngineBridge.shared().handleKeyDown(event.keyCode, timestamp: event.timestamp)
             } else {
-                CrescentEngineBridge.shared().handleKeyUp(event.keyCode)
+                CrescentEngineBridge.shared().handleKeyUp(event.keyCode, timestamp: event.timestamp)
             }
         case 59, 62:
             if event.modifierFlags.contains(.control) {
-                CrescentEngineBridge.shared().handleKeyDown(event.keyCode)
+                CrescentEngineBridge.shared().handleKeyDown(event.keyCode, timestamp: event.timestamp)
             } else {
-                CrescentEngineBridge.shared().handleKeyUp(event.keyCode)
+                CrescentEngineBridge.shared().handleKeyUp(event.keyCode, timestamp: event.timestamp)
             }
         case 58, 61:
             if event.modifierFlags.contains(.option) {
-                CrescentEngineBridge.shared().handleKeyDown(event.keyCode)
+                CrescentEngineBridge.shared().handleKeyDown(event.keyCode, timestamp: event.timestamp)
             } else {
-                CrescentEngineBridge.shared().handleKeyUp(event.keyCode)
+                CrescentEngineBridge.shared().handleKeyUp(event.keyCode, timestamp: event.timestamp)
             }
         case 55, 54:
             if event.modifierFlags.contains(.command) {
-                CrescentEngineBridge.shared().handleKeyDown(event.keyCode)
+                CrescentEngineBridge.shared().handleKeyDown(event.keyCode, timestamp: event.timestamp)
             } else {
-                CrescentEngineBridge.shared().handleKeyUp(event.keyCode)
+                CrescentEngineBridge.shared().handleKeyUp(event.keyCode, timestamp: event.timestamp)
             }
         default:
             break
@@ -814,10 +872,13 @@ class EditorState: ObservableObject {
         if !FileManager.default.fileExists(atPath: path) {
             addLog(.error, "Model not found at path: \(path)")
         } else {
-            let ok = CrescentEngineBridge.shared().importModel(path: path, options: options.toDictionary())
+            // Entities are created on the engine queue once the background import finishes.
+            let ok = CrescentEngineBridge.shared().importModelAsync(path: path, options: options.toDictionary())
             if ok {
-                addLog(.info, "Imported model: \(resolvedURL.lastPathComponent)")
+                addLog(.info, "Importing model: \(resolvedURL.lastPathComponent)")
                 trackAsset(name: resolvedURL.lastPathComponent, path: path, type: .model)
+                hasPendingModelImport = true
+                refreshModelImports()
             } else {
                 addLog(.error, "Model import failed: \(resolvedURL.lastPathComponent)")
             }
@@ -826,7 +887,19 @@ class EditorState: ObservableObject {
         if accessed {
             resolvedURL.stopAccessingSecurityScopedResource()
         }
-        refreshEntityList()
+    }
+
+    private func refreshModelImports() {
+        let wasImporting = !modelImportProgress.isEmpty
+        if !wasImporting && !hasPendingModelImport {
+            return
+        }
+        hasPendingModelImport = false
+        let progress = CrescentEngineBridge.shared().getModelImportProgress()
+        if progress.isEmpty && wasImporting {
+            refreshEntityList()
+        }
+        modelImportProgress = progress
     }
 
     func togglePlay() {
@@ -1104,6 +1177,7 @@ class EditorState: ObservableObject {
         let layoutSkippedCount = (result["layoutSkippedRendererCount"] as? NSNumber)?.intValue ?? 0
         let generatedUVRendererCount = (result["generatedUVRendererCount"] as? NSNumber)?.intValue ?? 0
         let reusedUVRendererCount = (result["reusedUVRendererCount"] as? NSNumber)?.intValue ?? 0
+        let skippedAtlasCount = (result["skippedAtlasCount"] as? NSNumber)?.intValue ?? 0
 
         if lightCount == 0 {
             addLog(.warning, "No lights are marked to contribute to static bake.")
@@ -1111,6 +1185,9 @@ class EditorState: ObservableObject {
             addLog(.warning, "Static bake produced no output. Static meshes: \(staticGeometryCount), layout-ready: \(layoutRendererCount), skipped: \(layoutSkippedCount), reused UVs: \(reusedUVRendererCount), generated UVs: \(generatedUVRendererCount). Mark a mesh as Material > Static Lighting > Static Geometry.")
         } else {
             addLog(.info, "Baked \(atlasCount) atlases for \(rendererCount) renderers from \(lightCount) static lights (\(texelCount) texels).")
+            if skippedAtlasCount > 0 {
+                addLog(.info, "Kept \(skippedAtlasCount) unchanged atlases from the previous bake.")
+            }
         }
 
         refreshEntityList()
@@ -143,6 +143,19 @@ struct EditorToolbar: View {
                 }
 
                 ToolbarCluster {
+                    if let modelImport = editorState.modelImportProgress.first {
+                        let stage = modelImport["stage"] as? String ?? "Importing"
+                        let progress = (modelImport["progress"] as? NSNumber)?.floatValue ?? 0
+                        let path = modelImport["path"] as? String ?? ""
+                        ToolbarPillLabel(
+                            title: editorState.modelImportProgress.count > 1 ? "Importing \(editorState.modelImportProgress.count)" : "Importing",
+                            value: "\(stage) \(Int(progress * 100))%",
+                            systemImage: "cube.transparent",
+                            accent: EditorTheme.warning
+                        )
+                        .help("Importing \((path as NSString).lastPathComponent)")
+                    }
+
                     Button(action: {
                         editorState.bakeLighting()
                     }) {
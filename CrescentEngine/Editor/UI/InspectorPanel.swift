@@ -195,22 +195,19 @@ struct TransformInspector: View {
         guard let firstUUID = selectedUUIDs.first else { return }
         let bridge = CrescentEngineBridge.shared()
         
-        if let pos = bridge.getPosition(uuid: firstUUID) as? [NSNumber] {
-            position = pos.map { $0.floatValue }
-        }
+        // One engine call for all three fields: found flag, then position, rotation, scale.
+        let data = bridge.readTransforms(uuids: [firstUUID], fields: [.position, .rotation, .scale])
+        let values: [Float] = data.withUnsafeBytes { Array($0.bindMemory(to: Float.self)) }
+        guard values.count >= 10, values[0] != 0 else { return }
         
-        if let rot = bridge.getRotation(uuid: firstUUID) as? [NSNumber], rot.count >= 3 {
-            let newRot = rot.map { $0.floatValue }
-            rotation = [
-                stabilizeAngle(newRot[0], rotation[safe: 0] ?? newRot[0]),
-                stabilizeAngle(newRot[1], rotation[safe: 1] ?? newRot[1]),
-                stabilizeAngle(newRot[2], rotation[safe: 2] ?? newRot[2])
-            ]
-        }
-        
-        if let scl = bridge.getScale(uuid: firstUUID) as? [NSNumber] {
-            scale = scl.map { $0.floatValue }
-        }
+        position = Array(values[1...3])
+        let newRot = Array(values[4...6])
+        rotation = [
+            stabilizeAngle(newRot[0], rotation[safe: 0] ?? newRot[0]),
+            stabilizeAngle(newRot[1], rotation[safe: 1] ?? newRot[1]),
+            stabilizeAngle(newRot[2], rotation[safe: 2] ?? newRot[2])
+        ]
+        scale = Array(values[7...9])
     }
 
     private func stabilizeAngle(_ value: Float, _ current: Float) -> Float {
@@ -1074,7 +1071,7 @@ struct PhysicsInspector: View {
 
     private let timer = Timer.publish(every: 1.0, on: .main, in: .common).autoconnect()
     private let bodyTypes = ["Static", "Dynamic", "Kinematic"]
-    private let shapeTypes = ["Box", "Sphere", "Capsule", "Mesh"]
+    private let shapeTypes = ["Box", "Sphere", "Capsule", "Mesh", "Terrain"]
     private let combineModes = ["Average", "Min", "Multiply", "Max"]
     private let textureExtensions: Set<String> = [
         "png", "jpg", "jpeg", "tga", "bmp", "gif", "tif", "tiff", "ktx", "ktx2", "dds", "cube"
@@ -2450,7 +2447,7 @@ struct AudioInspector: View {
     @State private var playOnStart: Bool = false
     @State private var spatial: Bool = true
     @State private var bus: String = "SFX"
-    @State private var stream: Bool = false
+    @State private var loadMode: String = "Decoded"
     @State private var minDistance: Float = 1.0
     @State private var maxDistance: Float = 50.0
     @State private var rolloff: Float = 1.0
@@ -2578,13 +2575,23 @@ struct AudioInspector: View {
                     .frame(width: 120)
                 }
 
-                Toggle("Stream From Disk", isOn: Binding(
-                    get: { stream },
-                    set: { newVal in
-                        stream = newVal
-                        pushAudioSource()
-                    }))
-                .font(EditorTheme.font(size: 11, weight: .medium))
+                HStack {
+                    Text("Load")
+                        .font(EditorTheme.font(size: 11, weight: .medium))
+                    Spacer()
+                    Picker("", selection: Binding(
+                        get: { loadMode },
+                        set: { newVal in
+                            loadMode = newVal
+                            pushAudioSource()
+                        })) {
+                        Text("Decoded").tag("Decoded")
+                        Text("Stream From Disk").tag("Streaming")
+                        Text("Compressed In Memory").tag("Compressed")
+                    }
+                    .pickerStyle(.menu)
+                    .frame(width: 160)
+                }
 
                 if spatial {
                     SliderRow(title: "Min Distance", value: $minDistance, range: 0.1...50, step: 0.1) { _ in
@@ -2620,7 +2627,7 @@ struct AudioInspector: View {
             playOnStart = (info["playOnStart"] as? NSNumber)?.boolValue ?? playOnStart
             spatial = (info["spatial"] as? NSNumber)?.boolValue ?? spatial
             bus = info["bus"] as? String ?? bus
-            stream = (info["stream"] as? NSNumber)?.boolValue ?? stream
+            loadMode = info["loadMode"] as? String ?? loadMode
             minDistance = (info["minDistance"] as? NSNumber)?.floatValue ?? minDistance
             maxDistance = (info["maxDistance"] as? NSNumber)?.floatValue ?? maxDistance
             rolloff = (info["rolloff"] as? NSNumber)?.floatValue ?? rolloff
@@ -2633,7 +2640,7 @@ struct AudioInspector: View {
             playOnStart = false
             spatial = true
             bus = "SFX"
-            stream = false
+            loadMode = "Decoded"
             minDistance = 1.0
             maxDistance = 50.0
             rolloff = 1.0
@@ -2649,7 +2656,7 @@ struct AudioInspector: View {
             "playOnStart": playOnStart,
             "spatial": spatial,
             "bus": bus,
-            "stream": stream,
+            "loadMode": loadMode,
             "minDistance": minDistance,
             "maxDistance": maxDistance,
             "rolloff": rolloff
@@ -2827,41 +2834,14 @@ struct VectorField: View {
         let delta = values[changedIndex] - oldValue
         if abs(delta) < 0.00001 { return }
         
-        // Apply to ALL selected entities
-        for uuid in selectedUUIDs {
-            switch transformType {
-            case .position:
-                if let pos = bridge.getPosition(uuid: uuid) as? [NSNumber], pos.count >= 3 {
-                    var x = pos[0].floatValue
-                    var y = pos[1].floatValue
-                    var z = pos[2].floatValue
-                    if changedIndex == 0 { x += delta }
-                    if changedIndex == 1 { y += delta }
-                    if changedIndex == 2 { z += delta }
-                    bridge.setPosition(uuid: uuid, x: x, y: y, z: z)
-                }
-            case .rotation:
-                if let rot = bridge.getRotation(uuid: uuid) as? [NSNumber], rot.count >= 3 {
-                    var x = rot[0].floatValue
-                    var y = rot[1].floatValue
-                    var z = rot[2].floatValue
-                    if changedIndex == 0 { x += delta }
-                    if changedIndex == 1 { y += delta }
-                    if changedIndex == 2 { z += delta }
-                    bridge.setRotation(uuid: uuid, x: x, y: y, z: z)
-                }
-            case .scale:
-                if let scl = bridge.getScale(uuid: uuid) as? [NSNumber], scl.count >= 3 {
-                    var x = scl[0].floatValue
-                    var y = scl[1].floatValue
-                    var z = scl[2].floatValue
-                    if changedIndex == 0 { x += delta }
-                    if changedIndex == 1 { y += delta }
-                    if changedIndex == 2 { z += delta }
-                    bridge.setScale(uuid: uuid, x: x, y: y, z: z)
-                }
-            }
+        // Apply to ALL selected entities; the engine folds a drag's deltas into one edit per frame.
+        let field: CrescentTransformFields
+        switch transformType {
+        case .position: field = .position
+        case .rotation: field = .rotation
+        case .scale: field = .scale
         }
+        bridge.queueTransformOffset(field: field, uuids: Array(selectedUUIDs), axis: changedIndex, delta: delta)
     }
 }
 
@@ -2993,6 +2973,7 @@ struct MaterialInspector: View {
     @State private var heightInvert: Bool = false
     @State private var renderMode: Int = 0
     @State private var alphaCutoff: Float = 0.5
+    @State private var transparencyMode: Int = 0
     @State private var twoSided: Bool = false
     @State private var alphaToCoverage: Bool = false
     @State private var windEnabled: Bool = false
@@ -3171,6 +3152,25 @@ struct MaterialInspector: View {
                 .pickerStyle(.segmented)
             }
 
+            if renderMode == 1 {
+                VStack(alignment: .leading, spacing: 6) {
+                    Text("Transparency")
+                        .font(EditorTheme.font(size: 11, weight: .medium))
+                        .foregroundColor(EditorTheme.textPrimary)
+                    Picker("", selection: Binding(
+                        get: { transparencyMode },
+                        set: { newVal in
+                            transparencyMode = newVal
+                            sendScalar(property: "transparencyMode", value: Float(newVal))
+                        })) {
+                        Text("Sorted").tag(0)
+                        Text("Weighted").tag(1)
+                        Text("Low Res").tag(2)
+                    }
+                    .pickerStyle(.segmented)
+                }
+            }
+
             if renderMode == 2 {
                 SliderRow(title: "Alpha Cutoff", value: Binding(
                     get: { alphaCutoff },
@@ -3732,6 +3732,9 @@ struct MaterialInspector: View {
         if let cutoffVal = info["alphaCutoff"] as? NSNumber {
             alphaCutoff = cutoffVal.floatValue
         }
+        if let transparencyVal = info["transparencyMode"] as? NSNumber {
+            transparencyMode = transparencyVal.intValue
+        }
         if let twoSidedVal = info["twoSided"] as? NSNumber {
             twoSided = twoSidedVal.intValue != 0
         }
@@ -28,6 +28,8 @@ struct LightInspector: View {
     @State private var contactShadows: Bool = false
     @State private var cascadeCount: Int = 4
     @State private var cascadeSplits: [Float] = [0.08, 0.22, 0.5, 1.0]
+    @State private var shadowPageCache: Bool = false
+    @State private var shadowUpdateInterval: Int = 1
     @State private var volumetric: Bool = false
     @State private var contributeToStaticBake: Bool = false
     @State private var mobility: Int = 2
@@ -128,6 +130,7 @@ struct LightInspector: View {
                         push(["shadowNearPlane": shadowNear, "shadowFarPlane": $0])
                     }
                     Stepper("Cascades: \(cascadeCount)", value: $cascadeCount, in: 1...4, onEditingChanged: { _ in push(["cascadeCount": cascadeCount]) })
+                    Toggle("Shadow Page Cache", isOn: Binding(get: { shadowPageCache }, set: { shadowPageCache = $0; push(["shadowPageCache": $0]) }))
                     VStack(alignment: .leading) {
                         Text("Cascade Splits")
                         .font(EditorTheme.font(size: 11, weight: .medium))
@@ -138,6 +141,8 @@ struct LightInspector: View {
                             ), range: 0...1, step: 0.01) { _ in }
                         }
                     }
+                } else {
+                    Stepper("Shadow Update: every \(shadowUpdateInterval) frame(s)", value: $shadowUpdateInterval, in: 1...8, onEditingChanged: { _ in push(["shadowUpdateInterval": shadowUpdateInterval]) })
                 }
             }
             Toggle("Volumetric", isOn: Binding(get: { volumetric }, set: { volumetric = $0; push(["volumetric": $0]) }))
@@ -195,6 +200,8 @@ struct LightInspector: View {
         if let splits = info["cascadeSplits"] as? [NSNumber], splits.count == 4 {
             cascadeSplits = splits.map { $0.floatValue }
         }
+        shadowPageCache = (info["shadowPageCache"] as? NSNumber)?.boolValue ?? shadowPageCache
+        shadowUpdateInterval = (info["shadowUpdateInterval"] as? NSNumber)?.intValue ?? shadowUpdateInterval
         volumetric = (info["volumetric"] as? NSNumber)?.boolValue ?? volumetric
         contributeToStaticBake = (info["contributeToStaticBake"] as? NSNumber)?.boolValue
             ?? (info["bakeToVertexLighting"] as? NSNumber)?.boolValue
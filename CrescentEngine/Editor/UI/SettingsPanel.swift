@@ -11,6 +11,22 @@ struct QualitySettings: Hashable {
     var lodBias: Double = 0.0
     var textureQuality: Int = 2
     var upscaler: Int = 0
+    var frameInterpolation: Bool = false
+    var shadowCascadeUpdateIntervals: [Int] = [1, 1, 1, 1]
+    var shadowUpdateBudget: Int = 0
+    var asyncClusterBuild: Bool = true
+    var asyncFogVolume: Bool = true
+    var ssaoResolution: Int = 1
+    var dynamicResolution: Bool = false
+    var dynamicResolutionTargetMs: Double = 16.6
+    var dynamicResolutionMinScale: Double = 0.5
+    var variableRateShading: Bool = false
+    var variableRateShadingPeriphery: Double = 0.5
+    var particleBudget: Int = 262144
+    var particleCollision: Bool = true
+    var halfPrecisionShading: Bool = false
+    var visibilityBuffer: Bool = false
+    var compactRenderTargets: Bool = false
     
     init() {}
     
@@ -39,6 +55,24 @@ struct QualitySettings: Hashable {
         lodBias = dict["lodBias"] as? Double ?? lodBias
         textureQuality = dict["textureQuality"] as? Int ?? textureQuality
         upscaler = dict["upscaler"] as? Int ?? upscaler
+        frameInterpolation = dict["frameInterpolation"] as? Bool ?? frameInterpolation
+        if let intervals = dict["shadowCascadeUpdateIntervals"] as? [Int], intervals.count == 4 {
+            shadowCascadeUpdateIntervals = intervals
+        }
+        shadowUpdateBudget = dict["shadowUpdateBudget"] as? Int ?? shadowUpdateBudget
+        asyncClusterBuild = dict["asyncClusterBuild"] as? Bool ?? asyncClusterBuild
+        asyncFogVolume = dict["asyncFogVolume"] as? Bool ?? asyncFogVolume
+        ssaoResolution = dict["ssaoResolution"] as? Int ?? ssaoResolution
+        dynamicResolution = dict["dynamicResolution"] as? Bool ?? dynamicResolution
+        dynamicResolutionTargetMs = dict["dynamicResolutionTargetMs"] as? Double ?? dynamicResolutionTargetMs
+        dynamicResolutionMinScale = dict["dynamicResolutionMinScale"] as? Double ?? dynamicResolutionMinScale
+        variableRateShading = dict["variableRateShading"] as? Bool ?? variableRateShading
+        variableRateShadingPeriphery = dict["variableRateShadingPeriphery"] as? Double ?? variableRateShadingPeriphery
+        particleBudget = dict["particleBudget"] as? Int ?? particleBudget
+        particleCollision = dict["particleCollision"] as? Bool ?? particleCollision
+        halfPrecisionShading = dict["halfPrecisionShading"] as? Bool ?? halfPrecisionShading
+        visibilityBuffer = dict["visibilityBuffer"] as? Bool ?? visibilityBuffer
+        compactRenderTargets = dict["compactRenderTargets"] as? Bool ?? compactRenderTargets
     }
     
     func toDictionary() -> [String: Any] {
@@ -50,7 +84,23 @@ struct QualitySettings: Hashable {
             "renderScale": renderScale,
             "lodBias": lodBias,
             "textureQuality": textureQuality,
-            "upscaler": upscaler
+            "upscaler": upscaler,
+            "frameInterpolation": frameInterpolation,
+            "shadowCascadeUpdateIntervals": shadowCascadeUpdateIntervals,
+            "shadowUpdateBudget": shadowUpdateBudget,
+            "asyncClusterBuild": asyncClusterBuild,
+            "asyncFogVolume": asyncFogVolume,
+            "ssaoResolution": ssaoResolution,
+            "dynamicResolution": dynamicResolution,
+            "dynamicResolutionTargetMs": dynamicResolutionTargetMs,
+            "dynamicResolutionMinScale": dynamicResolutionMinScale,
+            "variableRateShading": variableRateShading,
+            "variableRateShadingPeriphery": variableRateShadingPeriphery,
+            "particleBudget": particleBudget,
+            "particleCollision": particleCollision,
+            "halfPrecisionShading": halfPrecisionShading,
+            "visibilityBuffer": visibilityBuffer,
+            "compactRenderTargets": compactRenderTargets
         ]
     }
 }
@@ -83,6 +133,16 @@ final class ProjectSettingsViewModel: ObservableObject {
     @Published var bundleIdentifier: String = ""
     @Published var startupScene: String = ""
     @Published var assetPaths: [String] = []
+    @Published var pipelinedRendering: Bool = false
+    @Published var editorRedrawOnDemand: Bool = true
+    @Published var lowLatencyPresentation: Bool = false
+    @Published var physicsRate: Int = 60
+    @Published var physicsMaxBodies: Int = 65536
+    @Published var physicsMaxBodyPairs: Int = 65536
+    @Published var physicsMaxContactConstraints: Int = 10240
+    @Published var physicsTempAllocatorMB: Int = 10
+    @Published var audioMaxRealVoices: Int = 64
+    @Published var audioAudibilityThreshold: Double = 0.001
     @Published var renderProfiles: [RenderProfileItem] = []
     @Published var qualityPresets: [QualityPresetItem] = []
     @Published var inputBindings: [InputBindingItem] = []
@@ -104,6 +164,22 @@ final class ProjectSettingsViewModel: ObservableObject {
         bundleIdentifier = dict["bundleIdentifier"] as? String ?? bundleIdentifier
         startupScene = dict["startupScene"] as? String ?? startupScene
         assetPaths = dict["assetPaths"] as? [String] ?? assetPaths
+        pipelinedRendering = dict["pipelinedRendering"] as? Bool ?? pipelinedRendering
+        editorRedrawOnDemand = dict["editorRedrawOnDemand"] as? Bool ?? editorRedrawOnDemand
+        lowLatencyPresentation = dict["lowLatencyPresentation"] as? Bool ?? lowLatencyPresentation
+        if let physics = dict["physics"] as? [String: Any] {
+            if let step = physics["fixedTimeStep"] as? Double, step > 0 {
+                physicsRate = Int((1.0 / step).rounded())
+            }
+            physicsMaxBodies = physics["maxBodies"] as? Int ?? physicsMaxBodies
+            physicsMaxBodyPairs = physics["maxBodyPairs"] as? Int ?? physicsMaxBodyPairs
+            physicsMaxContactConstraints = physics["maxContactConstraints"] as? Int ?? physicsMaxContactConstraints
+            physicsTempAllocatorMB = physics["tempAllocatorMB"] as? Int ?? physicsTempAllocatorMB
+        }
+        if let audio = dict["audio"] as? [String: Any] {
+            audioMaxRealVoices = audio["maxRealVoices"] as? Int ?? audioMaxRealVoices
+            audioAudibilityThreshold = audio["audibilityThreshold"] as? Double ?? audioAudibilityThreshold
+        }
         if assetPaths.isEmpty {
             assetPaths = ["Assets"]
         }
@@ -158,6 +234,20 @@ final class ProjectSettingsViewModel: ObservableObject {
             "bundleIdentifier": bundleIdentifier,
             "startupScene": startupScene,
             "assetPaths": assetPaths,
+            "pipelinedRendering": pipelinedRendering,
+            "editorRedrawOnDemand": editorRedrawOnDemand,
+            "lowLatencyPresentation": lowLatencyPresentation,
+            "physics": [
+                "fixedTimeStep": 1.0 / Double(max(physicsRate, 10)),
+                "maxBodies": physicsMaxBodies,
+                "maxBodyPairs": physicsMaxBodyPairs,
+                "maxContactConstraints": physicsMaxContactConstraints,
+                "tempAllocatorMB": physicsTempAllocatorMB
+            ],
+            "audio": [
+                "maxRealVoices": audioMaxRealVoices,
+                "audibilityThreshold": audioAudibilityThreshold
+            ],
             "renderProfiles": renderProfiles.map { ["name": $0.name, "quality": $0.quality.toDictionary()] },
             "qualityPresets": qualityPresets.map { ["name": $0.name, "quality": $0.quality.toDictionary()] },
             "inputBindings": inputBindings.map {
@@ -344,6 +434,7 @@ final class SceneSettingsViewModel: ObservableObject {
     @Published var fogAnisotropy: Double = 0.4
     @Published var fogHistoryWeight: Double = 0.9
     @Published var fogQuality: Int = 1
+    @Published var fogUpdateRate: Int = 1
     
     @Published var postEnabled: Bool = true
     @Published var shadowDebugMode: Int = 0
@@ -385,7 +476,36 @@ final class SceneSettingsViewModel: ObservableObject {
     @Published var lodBias: Double = 0.0
     @Published var textureQuality: Int = 2
     @Published var upscaler: Int = 0
+    @Published var frameInterpolation: Bool = false
+    @Published var shadowCascadeUpdateIntervals: [Int] = [1, 1, 1, 1]
+    @Published var shadowUpdateBudget: Int = 0
+    @Published var asyncClusterBuild: Bool = true
+    @Published var asyncFogVolume: Bool = true
+    @Published var ssaoResolution: Int = 1
+    @Published var dynamicResolution: Bool = false
+    @Published var dynamicResolutionTargetMs: Double = 16.6
+    @Published var dynamicResolutionMinScale: Double = 0.5
+    @Published var variableRateShading: Bool = false
+    @Published var variableRateShadingPeriphery: Double = 0.5
+    @Published var particleBudget: Int = 262144
+    @Published var particleCollision: Bool = true
+    @Published var halfPrecisionShading: Bool = false
+    @Published var visibilityBuffer: Bool = false
+    @Published var compactRenderTargets: Bool = false
     @Published var bakeDirectLighting: Bool = false
+
+    @Published var streamingEnabled: Bool = false
+    @Published var streamingCellSize: Double = 64.0
+    @Published var streamingLoadRadius: Double = 160.0
+    @Published var streamingUnloadRadius: Double = 200.0
+    @Published var streamingActivationBudgetMs: Double = 2.0
+
+    @Published var navigationEnabled: Bool = false
+    @Published var navigationCellSize: Double = 0.5
+    @Published var navigationAgentRadius: Double = 0.4
+    @Published var navigationAgentHeight: Double = 1.8
+    @Published var navigationMaxSlope: Double = 45.0
+    @Published var navigationStepHeight: Double = 0.4
     
     private weak var editorState: EditorState?
     private var isLoading = false
@@ -442,6 +562,7 @@ final class SceneSettingsViewModel: ObservableObject {
             fogAnisotropy = fog["volumetricAnisotropy"] as? Double ?? fogAnisotropy
             fogHistoryWeight = fog["volumetricHistoryWeight"] as? Double ?? fogHistoryWeight
             fogQuality = fog["volumetricQuality"] as? Int ?? fogQuality
+            fogUpdateRate = fog["volumetricUpdateRate"] as? Int ?? fogUpdateRate
         }
         if let post = dict["postProcess"] as? [String: Any] {
             shadowDebugMode = post["shadowDebugMode"] as? Int ?? shadowDebugMode
@@ -485,10 +606,43 @@ final class SceneSettingsViewModel: ObservableObject {
             lodBias = quality["lodBias"] as? Double ?? lodBias
             textureQuality = quality["textureQuality"] as? Int ?? textureQuality
             upscaler = quality["upscaler"] as? Int ?? upscaler
+            frameInterpolation = quality["frameInterpolation"] as? Bool ?? frameInterpolation
+            if let intervals = quality["shadowCascadeUpdateIntervals"] as? [Int], intervals.count == 4 {
+                shadowCascadeUpdateIntervals = intervals
+            }
+            shadowUpdateBudget = quality["shadowUpdateBudget"] as? Int ?? shadowUpdateBudget
+            asyncClusterBuild = quality["asyncClusterBuild"] as? Bool ?? asyncClusterBuild
+            asyncFogVolume = quality["asyncFogVolume"] as? Bool ?? asyncFogVolume
+            ssaoResolution = quality["ssaoResolution"] as? Int ?? ssaoResolution
+            dynamicResolution = quality["dynamicResolution"] as? Bool ?? dynamicResolution
+            dynamicResolutionTargetMs = quality["dynamicResolutionTargetMs"] as? Double ?? dynamicResolutionTargetMs
+            dynamicResolutionMinScale = quality["dynamicResolutionMinScale"] as? Double ?? dynamicResolutionMinScale
+            variableRateShading = quality["variableRateShading"] as? Bool ?? variableRateShading
+            variableRateShadingPeriphery = quality["variableRateShadingPeriphery"] as? Double ?? variableRateShadingPeriphery
+            particleBudget = quality["particleBudget"] as? Int ?? particleBudget
+            particleCollision = quality["particleCollision"] as? Bool ?? particleCollision
+            halfPrecisionShading = quality["halfPrecisionShading"] as? Bool ?? halfPrecisionShading
+            visibilityBuffer = quality["visibilityBuffer"] as? Bool ?? visibilityBuffer
+            compactRenderTargets = quality["compactRenderTargets"] as? Bool ?? compactRenderTargets
         }
         if let staticLighting = dict["staticLighting"] as? [String: Any] {
             bakeDirectLighting = staticLighting["bakeDirectLighting"] as? Bool ?? bakeDirectLighting
         }
+        if let streaming = dict["streaming"] as? [String: Any] {
+            streamingEnabled = streaming["enabled"] as? Bool ?? streamingEnabled
+            streamingCellSize = streaming["cellSize"] as? Double ?? streamingCellSize
+            streamingLoadRadius = streaming["loadRadius"] as? Double ?? streamingLoadRadius
+            streamingUnloadRadius = streaming["unloadRadius"] as? Double ?? streamingUnloadRadius
+            streamingActivationBudgetMs = streaming["activationBudgetMs"] as? Double ?? streamingActivationBudgetMs
+        }
+        if let navigation = dict["navigation"] as? [String: Any] {
+            navigationEnabled = navigation["enabled"] as? Bool ?? navigationEnabled
+            navigationCellSize = navigation["cellSize"] as? Double ?? navigationCellSize
+            navigationAgentRadius = navigation["agentRadius"] as? Double ?? navigationAgentRadius
+            navigationAgentHeight = navigation["agentHeight"] as? Double ?? navigationAgentHeight
+            navigationMaxSlope = navigation["maxSlopeDegrees"] as? Double ?? navigationMaxSlope
+            navigationStepHeight = navigation["stepHeight"] as? Double ?? navigationStepHeight
+        }
     }
     
     func apply() {
@@ -525,7 +679,8 @@ final class SceneSettingsViewModel: ObservableObject {
                 "volumetricScattering": fogScattering,
                 "volumetricAnisotropy": fogAnisotropy,
                 "volumetricHistoryWeight": fogHistoryWeight,
-                "volumetricQuality": fogQuality
+                "volumetricQuality": fogQuality,
+                "volumetricUpdateRate": fogUpdateRate
             ],
             "postProcess": [
                 "shadowDebugMode": shadowDebugMode,
@@ -568,10 +723,41 @@ final class SceneSettingsViewModel: ObservableObject {
                 "renderScale": renderScale,
                 "lodBias": lodBias,
                 "textureQuality": textureQuality,
-                "upscaler": upscaler
+                "upscaler": upscaler,
+                "frameInterpolation": frameInterpolation,
+                "shadowCascadeUpdateIntervals": shadowCascadeUpdateIntervals,
+                "shadowUpdateBudget": shadowUpdateBudget,
+                "asyncClusterBuild": asyncClusterBuild,
+                "asyncFogVolume": asyncFogVolume,
+                "ssaoResolution": ssaoResolution,
+                "dynamicResolution": dynamicResolution,
+                "dynamicResolutionTargetMs": dynamicResolutionTargetMs,
+                "dynamicResolutionMinScale": dynamicResolutionMinScale,
+                "variableRateShading": variableRateShading,
+                "variableRateShadingPeriphery": variableRateShadingPeriphery,
+                "particleBudget": particleBudget,
+                "particleCollision": particleCollision,
+                "halfPrecisionShading": halfPrecisionShading,
+                "visibilityBuffer": visibilityBuffer,
+                "compactRenderTargets": compactRenderTargets
             ],
             "staticLighting": [
                 "bakeDirectLighting": bakeDirectLighting
+            ],
+            "streaming": [
+                "enabled": streamingEnabled,
+                "cellSize": streamingCellSize,
+                "loadRadius": streamingLoadRadius,
+                "unloadRadius": max(streamingUnloadRadius, streamingLoadRadius),
+                "activationBudgetMs": streamingActivationBudgetMs
+            ],
+            "navigation": [
+                "enabled": navigationEnabled,
+                "cellSize": navigationCellSize,
+                "agentRadius": navigationAgentRadius,
+                "agentHeight": navigationAgentHeight,
+                "maxSlopeDegrees": navigationMaxSlope,
+                "stepHeight": navigationStepHeight
             ]
         ]
         CrescentEngineBridge.shared().setSceneSettings(settings: info)
@@ -757,6 +943,78 @@ private struct ProjectSettingsPanel: View {
                     .controlSize(.small)
                 }
             }
+
+            SettingsRow(title: "Pipelined Rendering") {
+                Toggle("", isOn: $viewModel.pipelinedRendering)
+                    .labelsHidden()
+                    .onChange(of: viewModel.pipelinedRendering) { _ in
+                        viewModel.apply()
+                    }
+            }
+
+            SettingsRow(title: "Redraw Scene View On Demand") {
+                Toggle("", isOn: $viewModel.editorRedrawOnDemand)
+                    .labelsHidden()
+                    .onChange(of: viewModel.editorRedrawOnDemand) { _ in
+                        viewModel.apply()
+                    }
+            }
+
+            SettingsRow(title: "Low-Latency Presentation") {
+                Toggle("", isOn: $viewModel.lowLatencyPresentation)
+                    .labelsHidden()
+                    .onChange(of: viewModel.lowLatencyPresentation) { _ in
+                        viewModel.apply()
+                    }
+            }
+
+            SettingsRow(title: "Physics Rate") {
+                Stepper(value: $viewModel.physicsRate, in: 10...240, step: 5) {
+                    Text("\(viewModel.physicsRate) Hz")
+                        .font(EditorTheme.fontBody)
+                }
+                .onChange(of: viewModel.physicsRate) { _ in viewModel.apply() }
+            }
+
+            SettingsRow(title: "Physics Max Bodies") {
+                Stepper(value: $viewModel.physicsMaxBodies, in: 1024...262144, step: 1024) {
+                    Text("\(viewModel.physicsMaxBodies)")
+                        .font(EditorTheme.fontBody)
+                }
+                .onChange(of: viewModel.physicsMaxBodies) { _ in viewModel.apply() }
+            }
+
+            SettingsRow(title: "Physics Max Body Pairs") {
+                Stepper(value: $viewModel.physicsMaxBodyPairs, in: 1024...262144, step: 1024) {
+                    Text("\(viewModel.physicsMaxBodyPairs)")
+                        .font(EditorTheme.fontBody)
+                }
+                .onChange(of: viewModel.physicsMaxBodyPairs) { _ in viewModel.apply() }
+            }
+
+            SettingsRow(title: "Physics Max Contacts") {
+                Stepper(value: $viewModel.physicsMaxContactConstraints, in: 1024...131072, step: 1024) {
+                    Text("\(viewModel.physicsMaxContactConstraints)")
+                        .font(EditorTheme.fontBody)
+                }
+                .onChange(of: viewModel.physicsMaxContactConstraints) { _ in viewModel.apply() }
+            }
+
+            SettingsRow(title: "Physics Temp Memory") {
+                Stepper(value: $viewModel.physicsTempAllocatorMB, in: 1...256, step: 1) {
+                    Text("\(viewModel.physicsTempAllocatorMB) MB")
+                        .font(EditorTheme.fontBody)
+                }
+                .onChange(of: viewModel.physicsTempAllocatorMB) { _ in viewModel.apply() }
+            }
+
+            SettingsRow(title: "Audio Real Voices") {
+                Stepper(value: $viewModel.audioMaxRealVoices, in: 8...512, step: 8) {
+                    Text("\(viewModel.audioMaxRealVoices)")
+                        .font(EditorTheme.fontBody)
+                }
+                .onChange(of: viewModel.audioMaxRealVoices) { _ in viewModel.apply() }
+            }
             
             VStack(alignment: .leading, spacing: 6) {
                 HStack {
@@ -995,6 +1253,15 @@ private struct SceneSettingsPanel: View {
                     .frame(width: 220)
                     .onChange(of: viewModel.fogQuality) { _ in viewModel.apply() }
                 }
+                SettingsRow(title: "Volumetric Update") {
+                    Picker("", selection: $viewModel.fogUpdateRate) {
+                        Text("Every Froxel").tag(0)
+                        Text("Half").tag(1)
+                        Text("Quarter").tag(2)
+                    }
+                    .frame(width: 220)
+                    .onChange(of: viewModel.fogUpdateRate) { _ in viewModel.apply() }
+                }
             }
             
             SettingsGroup(title: "Post-Process") {
@@ -1165,6 +1432,25 @@ private struct SceneSettingsPanel: View {
                 SettingsSlider(title: "LOD Bias", value: $viewModel.lodBias, range: -2...2) {
                     viewModel.apply()
                 }
+
+                Toggle("Dynamic Resolution", isOn: $viewModel.dynamicResolution)
+                    .onChange(of: viewModel.dynamicResolution) { _ in viewModel.apply() }
+                if viewModel.dynamicResolution {
+                    SettingsSlider(title: "Target GPU Time (ms)", value: $viewModel.dynamicResolutionTargetMs, range: 4...50) {
+                        viewModel.apply()
+                    }
+                    SettingsSlider(title: "Min Render Scale", value: $viewModel.dynamicResolutionMinScale, range: 0.5...1) {
+                        viewModel.apply()
+                    }
+                }
+
+                Toggle("Variable Rate Shading", isOn: $viewModel.variableRateShading)
+                    .onChange(of: viewModel.variableRateShading) { _ in viewModel.apply() }
+                if viewModel.variableRateShading {
+                    SettingsSlider(title: "Edge Shading Rate", value: $viewModel.variableRateShadingPeriphery, range: 0.25...1) {
+                        viewModel.apply()
+                    }
+                }
                 
                 SettingsRow(title: "Texture Quality") {
                     Picker("", selection: $viewModel.textureQuality) {
@@ -1182,11 +1468,70 @@ private struct SceneSettingsPanel: View {
                     Picker("", selection: $viewModel.upscaler) {
                         Text("Off").tag(0)
                         Text("MetalFX Temporal").tag(1)
+                        Text("MetalFX Spatial").tag(2)
                     }
                     .labelsHidden()
                     .frame(width: 180)
                     .onChange(of: viewModel.upscaler) { _ in viewModel.apply() }
                 }
+                if viewModel.upscaler == 1 {
+                    Toggle("Frame Interpolation", isOn: $viewModel.frameInterpolation)
+                        .onChange(of: viewModel.frameInterpolation) { _ in viewModel.apply() }
+                }
+
+                ForEach(0..<4, id: \.self) { idx in
+                    SettingsRow(title: "Cascade \(idx + 1) Update") {
+                        Stepper(value: $viewModel.shadowCascadeUpdateIntervals[idx], in: 1...8, step: 1) {
+                            Text("every \(viewModel.shadowCascadeUpdateIntervals[idx])")
+                                .font(EditorTheme.fontBody)
+                        }
+                    }
+                }
+                .onChange(of: viewModel.shadowCascadeUpdateIntervals) { _ in viewModel.apply() }
+
+                SettingsRow(title: "Shadow Draw Budget") {
+                    Stepper(value: $viewModel.shadowUpdateBudget, in: 0...20000, step: 250) {
+                        Text(viewModel.shadowUpdateBudget == 0 ? "Unlimited" : "\(viewModel.shadowUpdateBudget)")
+                            .font(EditorTheme.fontBody)
+                    }
+                    .onChange(of: viewModel.shadowUpdateBudget) { _ in viewModel.apply() }
+                }
+
+                SettingsRow(title: "Particle Budget") {
+                    Stepper(value: $viewModel.particleBudget, in: 0...4_194_304, step: 16384) {
+                        Text(viewModel.particleBudget == 0 ? "Off" : "\(viewModel.particleBudget)")
+                            .font(EditorTheme.fontBody)
+                    }
+                    .onChange(of: viewModel.particleBudget) { _ in viewModel.apply() }
+                }
+
+                Toggle("Particle Collision", isOn: $viewModel.particleCollision)
+                    .onChange(of: viewModel.particleCollision) { _ in viewModel.apply() }
+
+                Toggle("Half Precision Shading", isOn: $viewModel.halfPrecisionShading)
+                    .onChange(of: viewModel.halfPrecisionShading) { _ in viewModel.apply() }
+
+                Toggle("Visibility Buffer", isOn: $viewModel.visibilityBuffer)
+                    .onChange(of: viewModel.visibilityBuffer) { _ in viewModel.apply() }
+
+                Toggle("Compact Render Targets", isOn: $viewModel.compactRenderTargets)
+                    .onChange(of: viewModel.compactRenderTargets) { _ in viewModel.apply() }
+
+                SettingsRow(title: "SSAO Resolution") {
+                    Picker("", selection: $viewModel.ssaoResolution) {
+                        Text("Full").tag(0)
+                        Text("Half").tag(1)
+                        Text("Quarter").tag(2)
+                    }
+                    .labelsHidden()
+                    .frame(width: 140)
+                    .onChange(of: viewModel.ssaoResolution) { _ in viewModel.apply() }
+                }
+
+                Toggle("Async Cluster Build", isOn: $viewModel.asyncClusterBuild)
+                    .onChange(of: viewModel.asyncClusterBuild) { _ in viewModel.apply() }
+                Toggle("Async Fog Volume", isOn: $viewModel.asyncFogVolume)
+                    .onChange(of: viewModel.asyncFogVolume) { _ in viewModel.apply() }
             }
 
             SettingsGroup(title: "Static Lighting") {
@@ -1200,6 +1545,47 @@ private struct SceneSettingsPanel: View {
                     .onChange(of: viewModel.bakeDirectLighting) { _ in viewModel.apply() }
                 }
             }
+
+            SettingsGroup(title: "World Streaming") {
+                Toggle("Partition Cooked Scene", isOn: $viewModel.streamingEnabled)
+                    .onChange(of: viewModel.streamingEnabled) { _ in viewModel.apply() }
+                if viewModel.streamingEnabled {
+                    SettingsSlider(title: "Cell Size", value: $viewModel.streamingCellSize, range: 16...512) {
+                        viewModel.apply()
+                    }
+                    SettingsSlider(title: "Load Radius", value: $viewModel.streamingLoadRadius, range: 16...2000) {
+                        viewModel.apply()
+                    }
+                    SettingsSlider(title: "Unload Radius", value: $viewModel.streamingUnloadRadius, range: 16...2500) {
+                        viewModel.apply()
+                    }
+                    SettingsSlider(title: "Activation Budget (ms)", value: $viewModel.streamingActivationBudgetMs, range: 0.5...8) {
+                        viewModel.apply()
+                    }
+                }
+            }
+
+            SettingsGroup(title: "Navigation") {
+                Toggle("Bake Navigation Grid", isOn: $viewModel.navigationEnabled)
+                    .onChange(of: viewModel.navigationEnabled) { _ in viewModel.apply() }
+                if viewModel.navigationEnabled {
+                    SettingsSlider(title: "Cell Size", value: $viewModel.navigationCellSize, range: 0.1...2) {
+                        viewModel.apply()
+                    }
+                    SettingsSlider(title: "Agent Radius", value: $viewModel.navigationAgentRadius, range: 0.1...2) {
+                        viewModel.apply()
+                    }
+                    SettingsSlider(title: "Agent Height", value: $viewModel.navigationAgentHeight, range: 0.5...4) {
+                        viewModel.apply()
+                    }
+                    SettingsSlider(title: "Max Slope", value: $viewModel.navigationMaxSlope, range: 0...80) {
+                        viewModel.apply()
+                    }
+                    SettingsSlider(title: "Step Height", value: $viewModel.navigationStepHeight, range: 0...1) {
+                        viewModel.apply()
+                    }
+                }
+            }
         }
     }
 }
@@ -1453,6 +1839,7 @@ private struct QualitySettingsEditor: View {
                 Picker("", selection: $quality.upscaler) {
                     Text("Off").tag(0)
                     Text("MetalFX Temporal").tag(1)
+                    Text("MetalFX Spatial").tag(2)
                 }
                 .labelsHidden()
                 .frame(width: 180)
@@ -1,7 +1,55 @@
 #include "AnimationClip.hpp"
+#include "AnimationCompression.hpp"
 #include "Skeleton.hpp"
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
 
 namespace Crescent {
+namespace {
+
+struct AnimationEventNameTable {
+    std::mutex mutex;
+    // A deque keeps the strings in place as the table grows.
+    std::deque<std::string> names{std::string()};
+    std::unordered_map<std::string, AnimationEventId> ids{{std::string(), kInvalidAnimationEventId}};
+};
+
+AnimationEventNameTable& GetEventNameTable() {
+    static AnimationEventNameTable table;
+    return table;
+}
+
+std::string ToLowerAscii(const std::string& value) {
+    std::string lower = value;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return lower;
+}
+
+} // namespace
+
+AnimationEventId InternAnimationEventName(const std::string& value) {
+    AnimationEventNameTable& table = GetEventNameTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.ids.find(value);
+    if (it != table.ids.end()) {
+        return it->second;
+    }
+    const AnimationEventId id = static_cast<AnimationEventId>(table.names.size());
+    table.names.push_back(value);
+    table.ids.emplace(value, id);
+    return id;
+}
+
+const std::string& GetAnimationEventName(AnimationEventId id) {
+    AnimationEventNameTable& table = GetEventNameTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return id < table.names.size() ? table.names[id] : table.names.front();
+}
 
 AnimationClip::AnimationClip()
     : m_Name("")
@@ -22,7 +70,15 @@ void AnimationClip::addChannel(const AnimationChannel& channel) {
 }
 
 void AnimationClip::addEvent(const AnimationEvent& event) {
-    m_Events.push_back(event);
+    AnimationEvent& added = m_Events.emplace_back(event);
+    added.nameId = InternAnimationEventName(ToLowerAscii(event.name));
+    if (!event.eventType.empty()) {
+        added.typeId = InternAnimationEventName(ToLowerAscii(event.eventType));
+    } else {
+        added.typeId = event.payload.empty() ? kInvalidAnimationEventId : InternAnimationEventName("audio");
+    }
+    added.tagId = event.eventTag.empty() ? added.nameId : InternAnimationEventName(ToLowerAscii(event.eventTag));
+    added.payloadId = InternAnimationEventName(event.payload);
 }
 
 AnimationChannel* AnimationClip::findChannelByBoneIndex(int boneIndex) {
@@ -61,6 +117,26 @@ const AnimationChannel* AnimationClip::findChannelByBoneIndex(int boneIndex) con
     return nullptr;
 }
 
+bool AnimationClip::getPositionRange(const AnimationChannel& channel, Math::Vector3& outMin, Math::Vector3& outMax) const {
+    if (!channel.positionKeys.empty()) {
+        outMin = outMax = channel.positionKeys.front().value;
+        for (const auto& key : channel.positionKeys) {
+            outMin = Math::Vector3::Min(outMin, key.value);
+            outMax = Math::Vector3::Max(outMax, key.value);
+        }
+        return true;
+    }
+    const size_t index = static_cast<size_t>(&channel - m_Channels.data());
+    if (!m_Compressed || index >= m_Compressed->channels.size() ||
+        m_Compressed->channels[index].position.frames.empty()) {
+        return false;
+    }
+    const CompressedVectorTrack& track = m_Compressed->channels[index].position;
+    outMin = track.rangeMin;
+    outMax = track.rangeMin + track.rangeExtent;
+    return true;
+}
+
 void AnimationClip::rebindToSkeleton(const Skeleton& skeleton) {
     for (auto& channel : m_Channels) {
         if (!channel.boneName.empty()) {
@@ -1,11 +1,24 @@
 #pragma once
 
 #include "../Math/Math.hpp"
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace Crescent {
 
+struct CompressedAnimationData;
+
+// Event strings are interned once, when the event is added to a clip, so runtime dispatch compares
+// numbers. Id 0 is the empty string.
+using AnimationEventId = uint32_t;
+constexpr AnimationEventId kInvalidAnimationEventId = 0;
+
+AnimationEventId InternAnimationEventName(const std::string& value);
+// The interned string; the reference stays valid for the life of the program.
+const std::string& GetAnimationEventName(AnimationEventId id);
+
 struct AnimationEvent {
     float time = 0.0f;
     std::string name;
@@ -16,6 +29,14 @@ struct AnimationEvent {
     float pitchMin = 1.0f;
     float pitchMax = 1.0f;
     bool spatial = true;
+
+    // Filled by AnimationClip::addEvent. The type and tag are lowercased: the type falls back to
+    // "audio" when the event has a payload and the tag falls back to the name. The payload keeps
+    // its case, it is a path.
+    AnimationEventId nameId = kInvalidAnimationEventId;
+    AnimationEventId typeId = kInvalidAnimationEventId;
+    AnimationEventId tagId = kInvalidAnimationEventId;
+    AnimationEventId payloadId = kInvalidAnimationEventId;
 };
 
 struct VectorKeyframe {
@@ -67,6 +88,14 @@ public:
 
     void rebindToSkeleton(const class Skeleton& skeleton);
 
+    // Set on clips from CompressAnimationClip or a cooked clip binary, whose channels carry no
+    // keys; sampling reads the compressed tracks instead.
+    const std::shared_ptr<const CompressedAnimationData>& getCompressedData() const { return m_Compressed; }
+    void setCompressedData(std::shared_ptr<const CompressedAnimationData> data) { m_Compressed = std::move(data); }
+
+    // Bounds of a channel's position keys, raw or compressed. False when it has none.
+    bool getPositionRange(const AnimationChannel& channel, Math::Vector3& outMin, Math::Vector3& outMax) const;
+
 private:
     std::string m_Name;
     float m_DurationTicks;
@@ -74,6 +103,7 @@ private:
     std::vector<AnimationChannel> m_Channels;
     std::vector<AnimationEvent> m_Events;
     std::vector<int> m_ChannelIndexByBone;
+    std::shared_ptr<const CompressedAnimationData> m_Compressed;
 };
 
 } // namespace Crescent
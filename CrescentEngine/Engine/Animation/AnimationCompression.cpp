@@ -0,0 +1,469 @@
+#include "AnimationCompression.hpp"
+#include "AnimationClip.hpp"
+#include "Skeleton.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace Crescent {
+namespace {
+
+constexpr uint32_t kClipBinaryVersion = 1;
+constexpr size_t kMaxFrames = 65535;
+constexpr float kVectorScale = 65535.0f;
+constexpr uint64_t kRotationMask = (1ull << 20) - 1;
+constexpr float kRotationScale = static_cast<float>(kRotationMask);
+// The three smaller components of a unit quaternion lie within +-1/sqrt(2).
+constexpr float kRotationRange = 0.70710678f;
+// Kept frames a sampling hint may step forward through before the search falls back to bisection.
+constexpr size_t kCursorScanFrames = 4;
+
+template <typename Key, typename Value, typename Interpolate>
+Value SampleRawKeys(const std::vector<Key>& keys, float time, const Value& fallback, Interpolate interpolate) {
+    if (keys.empty()) {
+        return fallback;
+    }
+    if (keys.size() == 1 || time <= keys.front().time) {
+        return keys.front().value;
+    }
+    if (time >= keys.back().time) {
+        return keys.back().value;
+    }
+    auto upper = std::upper_bound(keys.begin(), keys.end(), time,
+                                  [](float value, const Key& key) { return value < key.time; });
+    const Key& a = *(upper - 1);
+    const Key& b = *upper;
+    const float span = b.time - a.time;
+    return interpolate(a.value, b.value, span > 0.0f ? (time - a.time) / span : 0.0f);
+}
+
+float VectorError(const Math::Vector3& a, const Math::Vector3& b) {
+    return std::max({std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z)});
+}
+
+float RotationError(const Math::Quaternion& a, const Math::Quaternion& b) {
+    return 2.0f * std::acos(std::min(1.0f, std::abs(a.dot(b))));
+}
+
+// Greedy key reduction: from each kept frame, reach for the furthest frame whose interpolation
+// still reproduces every sample in between. A track that never leaves the tolerance of its first
+// sample keeps that frame alone.
+template <typename Value, typename Interpolate, typename Error>
+std::vector<uint16_t> ReduceFrames(const std::vector<Value>& samples, float tolerance,
+                                   Interpolate interpolate, Error error) {
+    std::vector<uint16_t> kept;
+    if (samples.empty()) {
+        return kept;
+    }
+    kept.push_back(0);
+    const bool constant = std::all_of(samples.begin(), samples.end(), [&](const Value& sample) {
+        return error(sample, samples.front()) <= tolerance;
+    });
+    if (constant) {
+        return kept;
+    }
+    size_t anchor = 0;
+    while (anchor + 1 < samples.size()) {
+        size_t next = anchor + 1;
+        for (size_t candidate = anchor + 2; candidate < samples.size(); ++candidate) {
+            bool fits = true;
+            const float span = static_cast<float>(candidate - anchor);
+            for (size_t i = anchor + 1; i < candidate && fits; ++i) {
+                const Value value = interpolate(samples[anchor], samples[candidate], static_cast<float>(i - anchor) / span);
+                fits = error(value, samples[i]) <= tolerance;
+            }
+            if (!fits) {
+                break;
+            }
+            next = candidate;
+        }
+        kept.push_back(static_cast<uint16_t>(next));
+        anchor = next;
+    }
+    return kept;
+}
+
+std::vector<uint16_t> AllFrames(size_t count) {
+    std::vector<uint16_t> frames(count);
+    for (size_t i = 0; i < count; ++i) {
+        frames[i] = static_cast<uint16_t>(i);
+    }
+    return frames;
+}
+
+uint16_t QuantizeUnit(float value) {
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * kVectorScale));
+}
+
+CompressedVectorTrack BuildVectorTrack(const std::vector<Math::Vector3>& samples, float tolerance, bool uniform) {
+    CompressedVectorTrack track;
+    track.frames = uniform ? AllFrames(samples.size())
+                           : ReduceFrames(samples, tolerance, Math::Vector3::Lerp, VectorError);
+    if (track.frames.empty()) {
+        return track;
+    }
+    Math::Vector3 rangeMax = samples[track.frames.front()];
+    track.rangeMin = rangeMax;
+    for (uint16_t frame : track.frames) {
+        track.rangeMin = Math::Vector3::Min(track.rangeMin, samples[frame]);
+        rangeMax = Math::Vector3::Max(rangeMax, samples[frame]);
+    }
+    track.rangeExtent = rangeMax - track.rangeMin;
+    auto normalize = [](float value, float min, float extent) {
+        return extent > 0.0f ? (value - min) / extent : 0.0f;
+    };
+    track.values.reserve(track.frames.size() * 3);
+    for (uint16_t frame : track.frames) {
+        const Math::Vector3& value = samples[frame];
+        track.values.push_back(QuantizeUnit(normalize(value.x, track.rangeMin.x, track.rangeExtent.x)));
+        track.values.push_back(QuantizeUnit(normalize(value.y, track.rangeMin.y, track.rangeExtent.y)));
+        track.values.push_back(QuantizeUnit(normalize(value.z, track.rangeMin.z, track.rangeExtent.z)));
+    }
+    return track;
+}
+
+uint64_t EncodeRotation(const Math::Quaternion& rotation) {
+    const Math::Quaternion q = rotation.normalized();
+    const float components[4] = {q.x, q.y, q.z, q.w};
+    uint64_t largest = 0;
+    for (uint64_t i = 1; i < 4; ++i) {
+        if (std::abs(components[i]) > std::abs(components[largest])) {
+            largest = i;
+        }
+    }
+    // q and -q are the same rotation, so the dropped component is always made positive.
+    const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    uint64_t bits = largest;
+    int shift = 2;
+    for (uint64_t i = 0; i < 4; ++i) {
+        if (i == largest) {
+            continue;
+        }
+        const float unit = (components[i] * sign / kRotationRange + 1.0f) * 0.5f;
+        const uint64_t value = static_cast<uint64_t>(std::lround(std::clamp(unit, 0.0f, 1.0f) * kRotationScale));
+        bits |= value << shift;
+        shift += 20;
+    }
+    return bits;
+}
+
+Math::Quaternion DecodeRotation(uint64_t bits) {
+    const uint64_t largest = bits & 3ull;
+    float components[4] = {};
+    float sumSquares = 0.0f;
+    int shift = 2;
+    for (uint64_t i = 0; i < 4; ++i) {
+        if (i == largest) {
+            continue;
+        }
+        const float unit = static_cast<float>((bits >> shift) & kRotationMask) / kRotationScale;
+        components[i] = (unit * 2.0f - 1.0f) * kRotationRange;
+        sumSquares += components[i] * components[i];
+        shift += 20;
+    }
+    components[largest] = std::sqrt(std::max(0.0f, 1.0f - sumSquares));
+    return Math::Quaternion(components[0], components[1], components[2], components[3]);
+}
+
+Math::Vector3 DecodeVector(const CompressedVectorTrack& track, size_t key) {
+    const uint16_t* value = &track.values[key * 3];
+    return Math::Vector3(track.rangeMin.x + track.rangeExtent.x * (value[0] / kVectorScale),
+                         track.rangeMin.y + track.rangeExtent.y * (value[1] / kVectorScale),
+                         track.rangeMin.z + track.rangeExtent.z * (value[2] / kVectorScale));
+}
+
+// Index of the last kept frame at or before the given frame, and the blend towards the next one.
+// A track that kept every frame is indexed directly; otherwise the search starts from the hint.
+size_t FindFrameKey(const std::vector<uint16_t>& frames, float frame, float& outBlend, uint32_t* hint) {
+    outBlend = 0.0f;
+    size_t index = 0;
+    if (frames.size() == 1 || frame <= frames.front()) {
+        index = 0;
+    } else if (frame >= frames.back()) {
+        index = frames.size() - 1;
+    } else if (static_cast<size_t>(frames.back()) + 1 == frames.size()) {
+        index = static_cast<size_t>(frame);
+        outBlend = frame - static_cast<float>(index);
+    } else {
+        index = hint ? std::min<size_t>(*hint, frames.size() - 2) : 0;
+        bool found = false;
+        if (hint && frames[index] <= frame) {
+            for (size_t step = 0; step < kCursorScanFrames && !found; ++step) {
+                found = frame < frames[index + 1];
+                if (!found) {
+                    ++index;
+                }
+            }
+        }
+        if (!found) {
+            auto upper = std::upper_bound(frames.begin(), frames.end(), frame,
+                                          [](float value, uint16_t key) { return value < static_cast<float>(key); });
+            index = static_cast<size_t>(std::distance(frames.begin(), upper) - 1);
+        }
+        const float span = static_cast<float>(frames[index + 1] - frames[index]);
+        outBlend = (frame - frames[index]) / span;
+    }
+    if (hint) {
+        *hint = static_cast<uint32_t>(index);
+    }
+    return index;
+}
+
+std::vector<float> BoneToleranceScales(const Skeleton* skeleton) {
+    std::vector<float> scales;
+    if (!skeleton) {
+        return scales;
+    }
+    const auto& bones = skeleton->getBones();
+    std::vector<size_t> chainBelow(bones.size(), 0);
+    for (size_t i = 0; i < bones.size(); ++i) {
+        size_t depth = 1;
+        for (int parent = bones[i].parentIndex;
+             parent >= 0 && static_cast<size_t>(parent) < bones.size() && depth <= bones.size();
+             parent = bones[static_cast<size_t>(parent)].parentIndex, ++depth) {
+            chainBelow[static_cast<size_t>(parent)] = std::max(chainBelow[static_cast<size_t>(parent)], depth);
+        }
+    }
+    scales.resize(bones.size());
+    for (size_t i = 0; i < bones.size(); ++i) {
+        scales[i] = 1.0f / static_cast<float>(chainBelow[i] + 1);
+    }
+    return scales;
+}
+
+class ClipBinaryWriter {
+public:
+    template <typename T>
+    void write(const T& value) {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+        m_Bytes.insert(m_Bytes.end(), bytes, bytes + sizeof(T));
+    }
+    template <typename T>
+    void writeArray(const std::vector<T>& values) {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(values.data());
+        m_Bytes.insert(m_Bytes.end(), bytes, bytes + values.size() * sizeof(T));
+    }
+    void writeString(const std::string& value) {
+        write(static_cast<uint32_t>(value.size()));
+        m_Bytes.insert(m_Bytes.end(), value.begin(), value.end());
+    }
+    std::vector<uint8_t>& bytes() { return m_Bytes; }
+
+private:
+    std::vector<uint8_t> m_Bytes;
+};
+
+class ClipBinaryReader {
+public:
+    ClipBinaryReader(const uint8_t* data, size_t size) : m_Data(data), m_Size(size) {}
+
+    template <typename T>
+    bool read(T& outValue) {
+        if (m_Size - m_Offset < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&outValue, m_Data + m_Offset, sizeof(T));
+        m_Offset += sizeof(T);
+        return true;
+    }
+    template <typename T>
+    bool readArray(std::vector<T>& outValues, size_t count) {
+        if (count > (m_Size - m_Offset) / sizeof(T)) {
+            return false;
+        }
+        outValues.resize(count);
+        std::memcpy(outValues.data(), m_Data + m_Offset, count * sizeof(T));
+        m_Offset += count * sizeof(T);
+        return true;
+    }
+    bool readString(std::string& outValue) {
+        uint32_t length = 0;
+        if (!read(length) || length > m_Size - m_Offset) {
+            return false;
+        }
+        outValue.assign(reinterpret_cast<const char*>(m_Data + m_Offset), length);
+        m_Offset += length;
+        return true;
+    }
+
+private:
+    const uint8_t* m_Data;
+    size_t m_Size;
+    size_t m_Offset = 0;
+};
+
+void WriteVectorTrack(ClipBinaryWriter& writer, const CompressedVectorTrack& track) {
+    writer.write(static_cast<uint32_t>(track.frames.size()));
+    writer.write(track.rangeMin);
+    writer.write(track.rangeExtent);
+    writer.writeArray(track.frames);
+    writer.writeArray(track.values);
+}
+
+bool ReadVectorTrack(ClipBinaryReader& reader, CompressedVectorTrack& track) {
+    uint32_t count = 0;
+    return reader.read(count) && reader.read(track.rangeMin) && reader.read(track.rangeExtent) &&
+           reader.readArray(track.frames, count) && reader.readArray(track.values, size_t(count) * 3);
+}
+
+} // namespace
+
+std::shared_ptr<AnimationClip> CompressAnimationClip(const AnimationClip& clip,
+                                                     const Skeleton* skeleton,
+                                                     const AnimationCompressionSettings& settings) {
+    auto compressed = std::make_shared<AnimationClip>();
+    compressed->setName(clip.getName());
+    compressed->setDurationTicks(clip.getDurationTicks());
+    compressed->setTicksPerSecond(clip.getTicksPerSecond());
+    for (const AnimationEvent& event : clip.getEvents()) {
+        compressed->addEvent(event);
+    }
+
+    // The grid spans exactly [0, duration], which is all playback ever samples.
+    const float ticksPerSecond = clip.getTicksPerSecond() > 0.0f ? clip.getTicksPerSecond() : 25.0f;
+    const float duration = std::max(0.0f, clip.getDurationTicks());
+    const float targetFrameTicks = ticksPerSecond / std::max(1.0f, settings.sampleRate);
+    const size_t frameCount = duration > 0.0f
+        ? std::min(kMaxFrames, static_cast<size_t>(std::ceil(duration / targetFrameTicks)) + 1)
+        : 1;
+    auto data = std::make_shared<CompressedAnimationData>();
+    data->frameTicks = frameCount > 1 ? duration / static_cast<float>(frameCount - 1) : 1.0f;
+
+    const std::vector<float> boneScales = BoneToleranceScales(skeleton);
+    std::vector<Math::Vector3> positions(frameCount);
+    std::vector<Math::Quaternion> rotations(frameCount);
+    std::vector<Math::Vector3> scales(frameCount);
+    for (const AnimationChannel& channel : clip.getChannels()) {
+        AnimationChannel names;
+        names.boneName = channel.boneName;
+        names.boneIndex = channel.boneIndex;
+        compressed->addChannel(names);
+
+        float scale = 1.0f;
+        if (channel.boneIndex >= 0 && static_cast<size_t>(channel.boneIndex) < boneScales.size()) {
+            scale = boneScales[static_cast<size_t>(channel.boneIndex)];
+        }
+        CompressedAnimationChannel tracks;
+        for (size_t frame = 0; frame < frameCount; ++frame) {
+            const float time = std::min(duration, static_cast<float>(frame) * data->frameTicks);
+            positions[frame] = SampleRawKeys(channel.positionKeys, time, Math::Vector3(0.0f), Math::Vector3::Lerp);
+            scales[frame] = SampleRawKeys(channel.scaleKeys, time, Math::Vector3(1.0f), Math::Vector3::Lerp);
+            Math::Quaternion rotation = SampleRawKeys(channel.rotationKeys, time, Math::Quaternion::Identity,
+                                                      Math::Quaternion::Slerp).normalized();
+            // Neighbouring samples stay in one hemisphere so interpolating the kept ones is short.
+            if (frame > 0 && rotation.dot(rotations[frame - 1]) < 0.0f) {
+                rotation = rotation * -1.0f;
+            }
+            rotations[frame] = rotation;
+        }
+        if (!channel.positionKeys.empty()) {
+            tracks.position = BuildVectorTrack(positions, settings.positionTolerance * scale, settings.uniform);
+        }
+        if (!channel.scaleKeys.empty()) {
+            tracks.scale = BuildVectorTrack(scales, settings.scaleTolerance * scale, settings.uniform);
+        }
+        if (!channel.rotationKeys.empty()) {
+            tracks.rotation.frames = settings.uniform
+                ? AllFrames(rotations.size())
+                : ReduceFrames(rotations, settings.rotationTolerance * scale, Math::Quaternion::Slerp, RotationError);
+            tracks.rotation.values.reserve(tracks.rotation.frames.size());
+            for (uint16_t frame : tracks.rotation.frames) {
+                tracks.rotation.values.push_back(EncodeRotation(rotations[frame]));
+            }
+        }
+        data->channels.push_back(std::move(tracks));
+    }
+    compressed->setCompressedData(std::move(data));
+    return compressed;
+}
+
+Math::Vector3 SampleCompressedTrack(const CompressedVectorTrack& track, float frame, const Math::Vector3& fallback,
+                                    uint32_t* hint) {
+    if (track.frames.empty()) {
+        return fallback;
+    }
+    float blend = 0.0f;
+    const size_t key = FindFrameKey(track.frames, frame, blend, hint);
+    if (blend <= 0.0f) {
+        return DecodeVector(track, key);
+    }
+    return Math::Vector3::Lerp(DecodeVector(track, key), DecodeVector(track, key + 1), blend);
+}
+
+Math::Quaternion SampleCompressedTrack(const CompressedRotationTrack& track, float frame, const Math::Quaternion& fallback,
+                                       uint32_t* hint) {
+    if (track.frames.empty()) {
+        return fallback;
+    }
+    float blend = 0.0f;
+    const size_t key = FindFrameKey(track.frames, frame, blend, hint);
+    if (blend <= 0.0f) {
+        return DecodeRotation(track.values[key]);
+    }
+    return Math::Quaternion::Slerp(DecodeRotation(track.values[key]), DecodeRotation(track.values[key + 1]), blend);
+}
+
+std::vector<uint8_t> WriteCompressedClipBinary(const AnimationClip& clip) {
+    const auto& data = clip.getCompressedData();
+    if (!data || data->channels.size() != clip.getChannels().size()) {
+        return {};
+    }
+    ClipBinaryWriter writer;
+    writer.write(static_cast<uint32_t>(0x4D4E4143)); // "CANM"
+    writer.write(kClipBinaryVersion);
+    writer.write(data->frameTicks);
+    writer.write(static_cast<uint32_t>(data->channels.size()));
+    for (size_t i = 0; i < data->channels.size(); ++i) {
+        const AnimationChannel& channel = clip.getChannels()[i];
+        const CompressedAnimationChannel& tracks = data->channels[i];
+        writer.writeString(channel.boneName);
+        writer.write(static_cast<int32_t>(channel.boneIndex));
+        WriteVectorTrack(writer, tracks.position);
+        writer.write(static_cast<uint32_t>(tracks.rotation.frames.size()));
+        writer.writeArray(tracks.rotation.frames);
+        writer.writeArray(tracks.rotation.values);
+        WriteVectorTrack(writer, tracks.scale);
+    }
+    return std::move(writer.bytes());
+}
+
+bool ReadCompressedClipBinary(const uint8_t* data, size_t size, AnimationClip& outClip) {
+    if (!data) {
+        return false;
+    }
+    ClipBinaryReader reader(data, size);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t channelCount = 0;
+    auto compressed = std::make_shared<CompressedAnimationData>();
+    if (!reader.read(magic) || magic != 0x4D4E4143 || !reader.read(version) || version != kClipBinaryVersion ||
+        !reader.read(compressed->frameTicks) || !reader.read(channelCount)) {
+        return false;
+    }
+    std::vector<AnimationChannel> channels;
+    for (uint32_t i = 0; i < channelCount; ++i) {
+        AnimationChannel channel;
+        CompressedAnimationChannel tracks;
+        int32_t boneIndex = -1;
+        uint32_t rotationCount = 0;
+        if (!reader.readString(channel.boneName) || !reader.read(boneIndex) ||
+            !ReadVectorTrack(reader, tracks.position) ||
+            !reader.read(rotationCount) ||
+            !reader.readArray(tracks.rotation.frames, rotationCount) ||
+            !reader.readArray(tracks.rotation.values, rotationCount) ||
+            !ReadVectorTrack(reader, tracks.scale)) {
+            return false;
+        }
+        channel.boneIndex = boneIndex;
+        channels.push_back(std::move(channel));
+        compressed->channels.push_back(std::move(tracks));
+    }
+    for (const AnimationChannel& channel : channels) {
+        outClip.addChannel(channel);
+    }
+    outClip.setCompressedData(std::move(compressed));
+    return true;
+}
+
+} // namespace Crescent
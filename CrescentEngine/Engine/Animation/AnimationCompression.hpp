@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../Math/Math.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Crescent {
+
+class AnimationClip;
+class Skeleton;
+
+// Error budget for CompressAnimationClip. Tolerances are bone-local (scene units for position and
+// scale, radians for rotation); a bone with a chain of N bones below it gets 1 / (N + 1) of them,
+// since its error moves every descendant.
+struct AnimationCompressionSettings {
+    float sampleRate = 30.0f;
+    float positionTolerance = 0.0005f;
+    float rotationTolerance = 0.0005f;
+    float scaleTolerance = 0.0005f;
+    // Keep every frame of the grid instead of reducing keys. Clips get larger, but sampling then
+    // indexes frames directly instead of searching for them.
+    bool uniform = false;
+};
+
+// A track resampled on the clip's uniform frame grid, keeping only the frames that key reduction
+// could not interpolate. Each component is quantized to 16 bits inside the track's range. A track
+// that kept every frame (frames[i] == i) is sampled by direct indexing.
+struct CompressedVectorTrack {
+    std::vector<uint16_t> frames;
+    std::vector<uint16_t> values; // three per frame
+    Math::Vector3 rangeMin = Math::Vector3(0.0f);
+    Math::Vector3 rangeExtent = Math::Vector3(0.0f);
+};
+
+// Rotations use the smallest-three encoding: the index of the largest component in two bits and
+// the other three in 20 bits each, the largest one being rebuilt from the unit length.
+struct CompressedRotationTrack {
+    std::vector<uint16_t> frames;
+    std::vector<uint64_t> values;
+};
+
+struct CompressedAnimationChannel {
+    CompressedVectorTrack position;
+    CompressedRotationTrack rotation;
+    CompressedVectorTrack scale;
+};
+
+// The compressed keys of a clip, one channel per AnimationChannel of the clip it is attached to.
+// Sampled in place; nothing is expanded back to full keyframes.
+struct CompressedAnimationData {
+    float frameTicks = 1.0f;
+    std::vector<CompressedAnimationChannel> channels;
+
+    size_t getByteSize() const;
+};
+
+// Offline: resamples every track of the clip on a uniform grid, drops the frames interpolation
+// reproduces within the settings' tolerances and quantizes the rest. The result keeps the clip's
+// channel names, indices and events but no raw keys.
+std::shared_ptr<AnimationClip> CompressAnimationClip(const AnimationClip& clip,
+                                                     const Skeleton* skeleton,
+                                                     const AnimationCompressionSettings& settings = {});
+
+// hint, when given, is the key the previous sample of this track used and receives this one's.
+Math::Vector3 SampleCompressedTrack(const CompressedVectorTrack& track, float frame, const Math::Vector3& fallback,
+                                    uint32_t* hint = nullptr);
+Math::Quaternion SampleCompressedTrack(const CompressedRotationTrack& track, float frame, const Math::Quaternion& fallback,
+                                       uint32_t* hint = nullptr);
+
+// Cooked clip format: "CANM", a version, the frame spacing and the compressed channels with their
+// bone names and indices. Name, duration and events travel with the clip's other fields.
+std::vector<uint8_t> WriteCompressedClipBinary(const AnimationClip& clip);
+bool ReadCompressedClipBinary(const uint8_t* data, size_t size, AnimationClip& outClip);
+
+} // namespace Crescent
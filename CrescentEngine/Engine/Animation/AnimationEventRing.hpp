@@ -0,0 +1,62 @@
+#pragma once
+
+#include "AnimationClip.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+
+namespace Crescent {
+
+// A fired clip event: the clip it belongs to and its index there. The clip is held so the event
+// stays readable until it is consumed, even when the clip is swapped out in between.
+struct FiredAnimationEvent {
+    std::shared_ptr<const AnimationClip> clip;
+    uint32_t index = 0;
+
+    // Null when the clip's events were replaced since the event fired.
+    const AnimationEvent* get() const {
+        if (!clip || index >= clip->getEvents().size()) {
+            return nullptr;
+        }
+        return &clip->getEvents()[index];
+    }
+};
+
+// Fixed-capacity queue of fired events, so firing never allocates. When the consumer falls behind
+// the oldest events are dropped.
+class AnimationEventRing {
+public:
+    static constexpr size_t kCapacity = 32;
+
+    void push(const std::shared_ptr<const AnimationClip>& clip, uint32_t index) {
+        FiredAnimationEvent& slot = m_Slots[(m_Head + m_Count) % kCapacity];
+        slot.clip = clip;
+        slot.index = index;
+        if (m_Count < kCapacity) {
+            ++m_Count;
+        } else {
+            m_Head = (m_Head + 1) % kCapacity;
+        }
+    }
+
+    bool empty() const { return m_Count == 0; }
+    size_t size() const { return m_Count; }
+    // Oldest first.
+    const FiredAnimationEvent& operator[](size_t i) const { return m_Slots[(m_Head + i) % kCapacity]; }
+
+    // Releases the held clips as well.
+    void clear() {
+        for (size_t i = 0; i < m_Count; ++i) {
+            m_Slots[(m_Head + i) % kCapacity].clip.reset();
+        }
+        m_Head = 0;
+        m_Count = 0;
+    }
+
+private:
+    std::array<FiredAnimationEvent, kCapacity> m_Slots;
+    size_t m_Head = 0;
+    size_t m_Count = 0;
+};
+
+} // namespace Crescent
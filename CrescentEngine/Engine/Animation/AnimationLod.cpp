@@ -0,0 +1,115 @@
+#include "AnimationLod.hpp"
+#include "Skeleton.hpp"
+#include <algorithm>
+
+namespace Crescent {
+namespace {
+
+constexpr uint32_t kMaxUpdateInterval = 8;
+// Reads without a new report before the coverage counts as unknown.
+constexpr uint32_t kMaxStaleCoverageReads = 8;
+
+} // namespace
+
+void ScreenCoverageFeedback::report(float pixels) {
+    m_Pixels.store(pixels, std::memory_order_relaxed);
+    m_Reports.fetch_add(1, std::memory_order_release);
+}
+
+float ScreenCoverageFeedback::read() {
+    const uint32_t reports = m_Reports.load(std::memory_order_acquire);
+    if (reports != m_SeenReports) {
+        m_SeenReports = reports;
+        m_StaleReads = 0;
+    } else if (m_StaleReads < kMaxStaleCoverageReads) {
+        ++m_StaleReads;
+    }
+    if (reports == 0 || m_StaleReads >= kMaxStaleCoverageReads) {
+        return -1.0f;
+    }
+    return m_Pixels.load(std::memory_order_relaxed);
+}
+
+AnimationLodThrottle::Step AnimationLodThrottle::advance(const AnimationLodSettings& settings,
+                                                         float coverage,
+                                                         float deltaTime,
+                                                         const Skeleton* skeleton) {
+    Step step;
+    step.deltaTime = deltaTime;
+    if (!settings.enabled || coverage < 0.0f) {
+        m_Interval = 1;
+        m_FramesSinceUpdate = 0;
+        m_PendingDelta = 0.0f;
+        return step;
+    }
+
+    const bool culled = coverage <= 0.0f;
+    if (culled && !settings.updateWhenCulled) {
+        step.frozen = true;
+        step.evaluate = false;
+        step.skin = false;
+        return step;
+    }
+    if (coverage < settings.reducedBonePixels) {
+        step.boneMask = resolveBoneMask(settings, skeleton);
+    }
+    step.skin = !culled;
+
+    uint32_t interval = kMaxUpdateInterval;
+    if (!culled) {
+        const float fullRate = std::max(settings.fullRatePixels, 0.0f);
+        interval = 1;
+        while (interval < kMaxUpdateInterval && coverage < fullRate / static_cast<float>(interval)) {
+            interval *= 2;
+        }
+    }
+    if (interval == 1) {
+        m_Interval = 1;
+        m_FramesSinceUpdate = 0;
+        m_PendingDelta = 0.0f;
+        return step;
+    }
+    if (interval != m_Interval) {
+        // Spread instances over the interval so they do not all evaluate on the same frame.
+        m_FramesSinceUpdate = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(this) >> 6) % interval;
+        m_Interval = interval;
+    }
+
+    step.throttled = true;
+    m_PendingDelta += deltaTime;
+    if (++m_FramesSinceUpdate >= interval) {
+        step.evaluate = true;
+        step.deltaTime = m_PendingDelta;
+        m_PendingDelta = 0.0f;
+        m_FramesSinceUpdate = 0;
+    } else {
+        step.evaluate = false;
+        step.deltaTime = 0.0f;
+    }
+    step.blend = static_cast<float>(m_FramesSinceUpdate) / static_cast<float>(interval);
+    return step;
+}
+
+const std::vector<uint8_t>* AnimationLodThrottle::resolveBoneMask(const AnimationLodSettings& settings,
+                                                                  const Skeleton* skeleton) {
+    if (!skeleton || settings.reducedBoneDepth <= 0) {
+        return nullptr;
+    }
+    const auto& bones = skeleton->getBones();
+    if (m_MaskSkeleton == skeleton && m_MaskDepth == settings.reducedBoneDepth && m_BoneMask.size() == bones.size()) {
+        return &m_BoneMask;
+    }
+    std::vector<int> depth(bones.size(), 0);
+    m_BoneMask.assign(bones.size(), 0);
+    for (size_t i = 0; i < bones.size(); ++i) {
+        int parent = bones[i].parentIndex;
+        // Parents come first; anything else is treated as a root.
+        depth[i] = (parent >= 0 && static_cast<size_t>(parent) < i) ? depth[static_cast<size_t>(parent)] + 1 : 0;
+        m_BoneMask[i] = depth[i] <= settings.reducedBoneDepth ? 1 : 0;
+    }
+    m_MaskSkeleton = skeleton;
+    m_MaskDepth = settings.reducedBoneDepth;
+    return &m_BoneMask;
+}
+
+} // namespace Crescent
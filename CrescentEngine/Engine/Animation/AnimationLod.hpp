@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Crescent {
+
+class Skeleton;
+
+// Animation LOD, set on a SkinnedMeshRenderer and followed by the Animator driving it. It is
+// keyed on the renderer's screen coverage of the mesh: its bounding radius in pixels in the game
+// view, 0 while culled.
+struct AnimationLodSettings {
+    bool enabled = false;
+    // Coverage at and above which the pose updates every frame. Each halving below it halves the
+    // update rate, down to every eighth frame; skipped frames interpolate the last two poses.
+    float fullRatePixels = 96.0f;
+    // Below this coverage only bones up to reducedBoneDepth levels under a root are sampled and
+    // the rest hold their bind pose. 0 keeps every bone; the depth must reach the root motion bone.
+    float reducedBonePixels = 24.0f;
+    int reducedBoneDepth = 0;
+    // Culled meshes freeze unless this is set; then state, events and root motion keep updating at
+    // the lowest rate, without skinning.
+    bool updateWhenCulled = false;
+};
+
+// Coverage feedback from the renderer. report() runs on the render thread and read() on the
+// animation side, once per frame; copies start without a report.
+class ScreenCoverageFeedback {
+public:
+    ScreenCoverageFeedback() = default;
+    ScreenCoverageFeedback(const ScreenCoverageFeedback&) {}
+    ScreenCoverageFeedback& operator=(const ScreenCoverageFeedback&) { return *this; }
+
+    void report(float pixels);
+    // Latest coverage, or -1 when nothing was reported over the last few reads (the game view is
+    // not rendering), which animation LOD treats as fully visible.
+    float read();
+
+private:
+    std::atomic<float> m_Pixels{-1.0f};
+    std::atomic<uint32_t> m_Reports{0};
+    uint32_t m_SeenReports = 0;
+    uint32_t m_StaleReads = 0;
+};
+
+// Per-instance state of the LOD: decides each frame whether the pose is evaluated, gathers the
+// time of skipped frames and keeps the reduced bone mask.
+class AnimationLodThrottle {
+public:
+    struct Step {
+        // Frozen: nothing advances or skins this frame.
+        bool frozen = false;
+        // Advance and sample now. When throttled, as one step of deltaTime (the time gathered over
+        // the skipped frames) instead of the fixed-step loop.
+        bool evaluate = true;
+        bool throttled = false;
+        float deltaTime = 0.0f;
+        // How far between the previous and the current evaluated pose to show while throttled.
+        float blend = 1.0f;
+        bool skin = true;
+        // Bones to sample, one entry per skeleton bone; null samples all of them.
+        const std::vector<uint8_t>* boneMask = nullptr;
+    };
+
+    Step advance(const AnimationLodSettings& settings, float coverage, float deltaTime, const Skeleton* skeleton);
+
+private:
+    const std::vector<uint8_t>* resolveBoneMask(const AnimationLodSettings& settings, const Skeleton* skeleton);
+
+    uint32_t m_Interval = 1;
+    uint32_t m_FramesSinceUpdate = 0;
+    float m_PendingDelta = 0.0f;
+    std::vector<uint8_t> m_BoneMask;
+    const Skeleton* m_MaskSkeleton = nullptr;
+    int m_MaskDepth = 0;
+};
+
+} // namespace Crescent
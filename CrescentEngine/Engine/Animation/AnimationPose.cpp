@@ -1,6 +1,8 @@
 #include "AnimationPose.hpp"
+#include "AnimationCompression.hpp"
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace Crescent {
 namespace {
@@ -57,9 +59,42 @@ static void DecomposeTRS(const Math::Matrix4x4& matrix,
     outRot.normalize();
 }
 
+// Keys a cursor may step forward through before the search falls back to bisection.
+constexpr size_t kCursorScanKeys = 4;
+
+// Index of the key pair around a time strictly inside the track, starting from the hint.
+template <typename Key>
+size_t FindKeyIndex(const std::vector<Key>& keys, float time, uint32_t* hint) {
+    if (hint) {
+        size_t index = std::min<size_t>(*hint, keys.size() - 2);
+        if (keys[index].time <= time) {
+            for (size_t step = 0; step < kCursorScanKeys; ++step) {
+                if (time < keys[index + 1].time) {
+                    *hint = static_cast<uint32_t>(index);
+                    return index;
+                }
+                ++index;
+            }
+        }
+    }
+    auto upper = std::upper_bound(keys.begin(), keys.end(), time,
+                                  [](float value, const Key& key) {
+                                      return value < key.time;
+                                  });
+    size_t index = 0;
+    if (upper != keys.begin()) {
+        index = static_cast<size_t>(std::distance(keys.begin(), upper) - 1);
+    }
+    if (hint) {
+        *hint = static_cast<uint32_t>(index);
+    }
+    return index;
+}
+
 static Math::Vector3 SampleVectorKeys(const std::vector<VectorKeyframe>& keys,
                                       float time,
-                                      const Math::Vector3& fallback) {
+                                      const Math::Vector3& fallback,
+                                      uint32_t* hint) {
     if (keys.empty()) {
         return fallback;
     }
@@ -72,14 +107,7 @@ static Math::Vector3 SampleVectorKeys(const std::vector<VectorKeyframe>& keys,
     if (time >= keys.back().time) {
         return keys.back().value;
     }
-    auto upper = std::upper_bound(keys.begin(), keys.end(), time,
-                                  [](float value, const VectorKeyframe& key) {
-                                      return value < key.time;
-                                  });
-    size_t index = 0;
-    if (upper != keys.begin()) {
-        index = static_cast<size_t>(std::distance(keys.begin(), upper) - 1);
-    }
+    size_t index = FindKeyIndex(keys, time, hint);
     const auto& a = keys[index];
     const auto& b = keys[index + 1];
     float span = b.time - a.time;
@@ -89,7 +117,8 @@ static Math::Vector3 SampleVectorKeys(const std::vector<VectorKeyframe>& keys,
 
 static Math::Quaternion SampleRotationKeys(const std::vector<QuaternionKeyframe>& keys,
                                            float time,
-                                           const Math::Quaternion& fallback) {
+                                           const Math::Quaternion& fallback,
+                                           uint32_t* hint) {
     if (keys.empty()) {
         return fallback;
     }
@@ -102,14 +131,7 @@ static Math::Quaternion SampleRotationKeys(const std::vector<QuaternionKeyframe>
     if (time >= keys.back().time) {
         return keys.back().value;
     }
-    auto upper = std::upper_bound(keys.begin(), keys.end(), time,
-                                  [](float value, const QuaternionKeyframe& key) {
-                                      return value < key.time;
-                                  });
-    size_t index = 0;
-    if (upper != keys.begin()) {
-        index = static_cast<size_t>(std::distance(keys.begin(), upper) - 1);
-    }
+    size_t index = FindKeyIndex(keys, time, hint);
     const auto& a = keys[index];
     const auto& b = keys[index + 1];
     float span = b.time - a.time;
@@ -146,7 +168,9 @@ void SampleLocalPose(const Skeleton& skeleton,
                      const AnimationClip* clip,
                      float timeSeconds,
                      bool looping,
-                     AnimationLocalPose& outPose) {
+                     AnimationLocalPose& outPose,
+                     AnimationSampleCursor* cursor,
+                     const std::vector<uint8_t>* boneMask) {
     const auto& bones = skeleton.getBones();
     if (bones.empty()) {
         outPose.resize(0);
@@ -155,6 +179,12 @@ void SampleLocalPose(const Skeleton& skeleton,
 
     outPose.resize(bones.size());
     float timeTicks = ResolveClipTimeTicks(clip, timeSeconds, looping);
+    const CompressedAnimationData* compressed = clip ? clip->getCompressedData().get() : nullptr;
+    const float frame = compressed && compressed->frameTicks > 0.0f ? timeTicks / compressed->frameTicks : 0.0f;
+    if (cursor && clip && (cursor->clip != clip || cursor->keys.size() != clip->getChannels().size() * 3)) {
+        cursor->clip = clip;
+        cursor->keys.assign(clip->getChannels().size() * 3, 0);
+    }
 
     for (size_t i = 0; i < bones.size(); ++i) {
         const Bone& bone = bones[i];
@@ -163,11 +193,22 @@ void SampleLocalPose(const Skeleton& skeleton,
         Math::Vector3 baseScale;
         DecomposeTRS(bone.localBind, basePos, baseRot, baseScale);
 
-        const AnimationChannel* channel = clip ? clip->findChannelByBoneIndex(static_cast<int>(i)) : nullptr;
-        if (channel) {
-            outPose.positions[i] = SampleVectorKeys(channel->positionKeys, timeTicks, basePos);
-            outPose.rotations[i] = SampleRotationKeys(channel->rotationKeys, timeTicks, baseRot);
-            outPose.scales[i] = SampleVectorKeys(channel->scaleKeys, timeTicks, baseScale);
+        const bool sampled = !boneMask || (i < boneMask->size() && (*boneMask)[i] != 0);
+        const AnimationChannel* channel = clip && sampled ? clip->findChannelByBoneIndex(static_cast<int>(i)) : nullptr;
+        const size_t channelIndex = channel ? static_cast<size_t>(channel - clip->getChannels().data()) : 0;
+        uint32_t* hints = channel && cursor ? &cursor->keys[channelIndex * 3] : nullptr;
+        uint32_t* positionHint = hints;
+        uint32_t* rotationHint = hints ? hints + 1 : nullptr;
+        uint32_t* scaleHint = hints ? hints + 2 : nullptr;
+        if (channel && compressed && channelIndex < compressed->channels.size()) {
+            const CompressedAnimationChannel& tracks = compressed->channels[channelIndex];
+            outPose.positions[i] = SampleCompressedTrack(tracks.position, frame, basePos, positionHint);
+            outPose.rotations[i] = SampleCompressedTrack(tracks.rotation, frame, baseRot, rotationHint);
+            outPose.scales[i] = SampleCompressedTrack(tracks.scale, frame, baseScale, scaleHint);
+        } else if (channel) {
+            outPose.positions[i] = SampleVectorKeys(channel->positionKeys, timeTicks, basePos, positionHint);
+            outPose.rotations[i] = SampleRotationKeys(channel->rotationKeys, timeTicks, baseRot, rotationHint);
+            outPose.scales[i] = SampleVectorKeys(channel->scaleKeys, timeTicks, baseScale, scaleHint);
         } else {
             outPose.positions[i] = basePos;
             outPose.rotations[i] = baseRot;
@@ -187,41 +228,166 @@ void BlendLocalPose(const AnimationLocalPose& a,
     }
     float blend = Math::Clamp(t, 0.0f, 1.0f);
     outPose.resize(count);
+    // Positions and scales are packed float triples, so both lerp as flat float streams.
+    static_assert(sizeof(Math::Vector3) == sizeof(float) * 3, "Vector3 must stay packed");
+    auto lerpStream = [blend](const Math::Vector3* from, const Math::Vector3* to, Math::Vector3* out, size_t vectors) {
+        const float* x = &from->x;
+        const float* y = &to->x;
+        float* result = &out->x;
+        for (size_t i = 0; i < vectors * 3; ++i) {
+            result[i] = x[i] + (y[i] - x[i]) * blend;
+        }
+    };
+    lerpStream(a.positions.data(), b.positions.data(), outPose.positions.data(), count);
+    lerpStream(a.scales.data(), b.scales.data(), outPose.scales.data(), count);
     for (size_t i = 0; i < count; ++i) {
-        outPose.positions[i] = Math::Vector3::Lerp(a.positions[i], b.positions[i], blend);
+#if defined(__APPLE__)
+        outPose.rotations[i] = Math::Quaternion(simd_slerp(a.rotations[i].toSIMD(), b.rotations[i].toSIMD(), blend));
+#else
         outPose.rotations[i] = Math::Quaternion::Slerp(a.rotations[i], b.rotations[i], blend);
-        outPose.scales[i] = Math::Vector3::Lerp(a.scales[i], b.scales[i], blend);
+#endif
     }
 }
 
-void BuildSkinMatrices(const Skeleton& skeleton,
-                       const AnimationLocalPose& pose,
-                       std::vector<Math::Matrix4x4>& outMatrices) {
+namespace {
+
+// Union of skinned bone boxes. Skin matrices are affine, so each box takes the center/extent
+// transform without the corner fallback of Matrix4x4::transformAABB.
+class SkinBoundsAccumulator {
+public:
+    SkinBoundsAccumulator() {
+#if defined(__APPLE__)
+        const float high = std::numeric_limits<float>::max();
+        const float low = std::numeric_limits<float>::lowest();
+        m_Min = simd_make_float4(high, high, high, high);
+        m_Max = simd_make_float4(low, low, low, low);
+#else
+        m_Min = Math::Vector3(std::numeric_limits<float>::max());
+        m_Max = Math::Vector3(std::numeric_limits<float>::lowest());
+#endif
+    }
+
+    void add(const Math::Matrix4x4& skin, const SkinBoneBox& box) {
+        if (!box.isValid()) {
+            return;
+        }
+#if defined(__APPLE__)
+        const simd_float4 center = skin.simd.columns[0] * box.center.x + skin.simd.columns[1] * box.center.y
+                                 + skin.simd.columns[2] * box.center.z + skin.simd.columns[3];
+        const simd_float4 extent = simd_abs(skin.simd.columns[0]) * box.extent.x
+                                 + simd_abs(skin.simd.columns[1]) * box.extent.y
+                                 + simd_abs(skin.simd.columns[2]) * box.extent.z;
+        m_Min = simd_min(m_Min, center - extent);
+        m_Max = simd_max(m_Max, center + extent);
+#else
+        const Math::Vector3 center = skin.transformPointAffine(box.center);
+        const Math::Vector3 extent(
+            std::abs(skin.m[0]) * box.extent.x + std::abs(skin.m[4]) * box.extent.y + std::abs(skin.m[8]) * box.extent.z,
+            std::abs(skin.m[1]) * box.extent.x + std::abs(skin.m[5]) * box.extent.y + std::abs(skin.m[9]) * box.extent.z,
+            std::abs(skin.m[2]) * box.extent.x + std::abs(skin.m[6]) * box.extent.y + std::abs(skin.m[10]) * box.extent.z);
+        m_Min = Math::Vector3::Min(m_Min, center - extent);
+        m_Max = Math::Vector3::Max(m_Max, center + extent);
+#endif
+        m_Valid = true;
+    }
+
+    void store(SkinBounds& outBounds) const {
+        outBounds.valid = m_Valid;
+        if (!m_Valid) {
+            return;
+        }
+#if defined(__APPLE__)
+        outBounds.min = Math::Vector3(m_Min[0], m_Min[1], m_Min[2]);
+        outBounds.max = Math::Vector3(m_Max[0], m_Max[1], m_Max[2]);
+#else
+        outBounds.min = m_Min;
+        outBounds.max = m_Max;
+#endif
+    }
+
+private:
+#if defined(__APPLE__)
+    simd_float4 m_Min;
+    simd_float4 m_Max;
+#else
+    Math::Vector3 m_Min;
+    Math::Vector3 m_Max;
+#endif
+    bool m_Valid = false;
+};
+
+// Bones are stored parents first, so one forward pass resolves every global transform. The
+// globals are built in the output and turned into skin matrices in place; a bone's box is
+// refit right after its skin matrix while the matrix is still in registers.
+void BuildSkinMatricesWithBoxes(const Skeleton& skeleton,
+                                const AnimationLocalPose& pose,
+                                const std::vector<SkinBoneBox>* boneBoxes,
+                                std::vector<Math::Matrix4x4>& outMatrices,
+                                SkinBounds* outBounds) {
     const auto& bones = skeleton.getBones();
     size_t boneCount = bones.size();
     if (boneCount == 0) {
         outMatrices.clear();
+        if (outBounds) {
+            *outBounds = SkinBounds{};
+        }
         return;
     }
     const Math::Matrix4x4& globalInverse = skeleton.getGlobalInverse();
 
-    std::vector<Math::Matrix4x4> globalPose(boneCount);
-
+    outMatrices.resize(boneCount);
     for (size_t i = 0; i < boneCount; ++i) {
         const Bone& bone = bones[i];
         Math::Matrix4x4 localPose = Math::Matrix4x4::TRS(pose.positions[i], pose.rotations[i], pose.scales[i]);
         if (bone.parentIndex < 0) {
-            globalPose[i] = localPose;
+            outMatrices[i] = localPose;
         } else {
             size_t parentIndex = static_cast<size_t>(bone.parentIndex);
-            globalPose[i] = globalPose[parentIndex] * localPose;
+            outMatrices[i] = outMatrices[parentIndex] * localPose;
         }
     }
-
-    outMatrices.resize(boneCount);
+    if (!boneBoxes || !outBounds) {
+        for (size_t i = 0; i < boneCount; ++i) {
+            outMatrices[i] = globalInverse * (outMatrices[i] * bones[i].inverseBind);
+        }
+        return;
+    }
+    SkinBoundsAccumulator bounds;
+    const size_t boxCount = std::min(boneCount, boneBoxes->size());
     for (size_t i = 0; i < boneCount; ++i) {
-        outMatrices[i] = globalInverse * globalPose[i] * bones[i].inverseBind;
+        outMatrices[i] = globalInverse * (outMatrices[i] * bones[i].inverseBind);
+        if (i < boxCount) {
+            bounds.add(outMatrices[i], (*boneBoxes)[i]);
+        }
+    }
+    bounds.store(*outBounds);
+}
+
+} // namespace
+
+void BuildSkinMatrices(const Skeleton& skeleton,
+                       const AnimationLocalPose& pose,
+                       std::vector<Math::Matrix4x4>& outMatrices) {
+    BuildSkinMatricesWithBoxes(skeleton, pose, nullptr, outMatrices, nullptr);
+}
+
+void BuildSkinMatricesAndBounds(const Skeleton& skeleton,
+                                const AnimationLocalPose& pose,
+                                const std::vector<SkinBoneBox>& boneBoxes,
+                                std::vector<Math::Matrix4x4>& outMatrices,
+                                SkinBounds& outBounds) {
+    BuildSkinMatricesWithBoxes(skeleton, pose, &boneBoxes, outMatrices, &outBounds);
+}
+
+void ComputeSkinBounds(const std::vector<Math::Matrix4x4>& skinMatrices,
+                       const std::vector<SkinBoneBox>& boneBoxes,
+                       SkinBounds& outBounds) {
+    SkinBoundsAccumulator bounds;
+    const size_t count = std::min(skinMatrices.size(), boneBoxes.size());
+    for (size_t i = 0; i < count; ++i) {
+        bounds.add(skinMatrices[i], boneBoxes[i]);
     }
+    bounds.store(outBounds);
 }
 
 void BuildGlobalPose(const Skeleton& skeleton,
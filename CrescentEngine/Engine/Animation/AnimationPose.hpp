@@ -3,6 +3,7 @@
 #include "Skeleton.hpp"
 #include "AnimationClip.hpp"
 #include "../Math/Math.hpp"
+#include <cstdint>
 #include <vector>
 
 namespace Crescent {
@@ -19,11 +20,22 @@ struct AnimationLocalPose {
     }
 };
 
+// Playback state kept by a sampler between frames: the key each track sampled last, three per
+// channel (position, rotation, scale). Sampling starts its search there, so playback moving
+// forward finds its keys in constant time. A cursor handed a different clip starts over.
+struct AnimationSampleCursor {
+    const AnimationClip* clip = nullptr;
+    std::vector<uint32_t> keys;
+};
+
+// boneMask, when given, has one entry per bone; bones with a zero entry hold their bind pose.
 void SampleLocalPose(const Skeleton& skeleton,
                      const AnimationClip* clip,
                      float timeSeconds,
                      bool looping,
-                     AnimationLocalPose& outPose);
+                     AnimationLocalPose& outPose,
+                     AnimationSampleCursor* cursor = nullptr,
+                     const std::vector<uint8_t>* boneMask = nullptr);
 
 void BlendLocalPose(const AnimationLocalPose& a,
                     const AnimationLocalPose& b,
@@ -34,6 +46,35 @@ void BuildSkinMatrices(const Skeleton& skeleton,
                        const AnimationLocalPose& pose,
                        std::vector<Math::Matrix4x4>& outMatrices);
 
+// Bind-space box around the vertices one bone influences, kept as center and half extent for the
+// affine box transform. A negative extent marks a bone that influences no vertex.
+struct SkinBoneBox {
+    Math::Vector3 center = Math::Vector3::Zero;
+    Math::Vector3 extent = Math::Vector3(-1.0f);
+
+    bool isValid() const { return extent.x >= 0.0f; }
+};
+
+// Mesh-space union of the skinned bone boxes; invalid when no bone has a box.
+struct SkinBounds {
+    Math::Vector3 min = Math::Vector3::Zero;
+    Math::Vector3 max = Math::Vector3::Zero;
+    bool valid = false;
+};
+
+// BuildSkinMatrices that also refits the bounds: each bone's box (indexed like the bones) is
+// transformed by its skin matrix as soon as that is built, so the bounds need no second pass.
+void BuildSkinMatricesAndBounds(const Skeleton& skeleton,
+                                const AnimationLocalPose& pose,
+                                const std::vector<SkinBoneBox>& boneBoxes,
+                                std::vector<Math::Matrix4x4>& outMatrices,
+                                SkinBounds& outBounds);
+
+// The same bounds for skin matrices built elsewhere.
+void ComputeSkinBounds(const std::vector<Math::Matrix4x4>& skinMatrices,
+                       const std::vector<SkinBoneBox>& boneBoxes,
+                       SkinBounds& outBounds);
+
 void BuildGlobalPose(const Skeleton& skeleton,
                      const AnimationLocalPose& pose,
                      std::vector<Math::Matrix4x4>& outMatrices);
@@ -19,6 +19,10 @@ uint32_t Skeleton::addBone(const std::string& name,
     bone.inverseBind = inverseBind;
     m_Bones.push_back(bone);
     m_BoneLookup[name] = index;
+    std::string normalized = NormalizeBoneName(name);
+    if (!normalized.empty()) {
+        m_NormalizedBoneLookup.emplace(std::move(normalized), index);
+    }
     if (m_RootIndex == InvalidIndex && parentIndex < 0) {
         m_RootIndex = index;
     }
@@ -40,4 +44,32 @@ int Skeleton::getBoneIndex(const std::string& name) const {
     return static_cast<int>(it->second);
 }
 
-} // namespace Crescent
+int Skeleton::findBoneIndex(const std::string& name) const {
+    if (name.empty()) {
+        return -1;
+    }
+    int exact = getBoneIndex(name);
+    if (exact >= 0) {
+        return exact;
+    }
+    auto it = m_NormalizedBoneLookup.find(NormalizeBoneName(name));
+    if (it == m_NormalizedBoneLookup.end()) {
+        return -1;
+    }
+    return static_cast<int>(it->second);
+}
+
+std::string Skeleton::NormalizeBoneName(const std::string& name) {
+    std::string normalized;
+    normalized.reserve(name.size());
+    for (char c : name) {
+        if (c >= 'A' && c <= 'Z') {
+            normalized.push_back(static_cast<char>(c - 'A' + 'a'));
+        } else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+            normalized.push_back(c);
+        }
+    }
+    return normalized;
+}
+
+} // namespace Crescent
\ No newline at end of file
@@ -41,10 +41,17 @@ public:
     const std::vector<Bone>& getBones() const { return m_Bones; }
     const Bone* getBone(uint32_t index) const;
     int getBoneIndex(const std::string& name) const;
+    // Exact name first, then a match that ignores case and punctuation ("mixamorig:RightHand"
+    // finds "mixamorig_righthand"). The first bone wins when several normalize to the same name.
+    int findBoneIndex(const std::string& name) const;
+
+    // Lowercase letters and digits only.
+    static std::string NormalizeBoneName(const std::string& name);
 
 private:
     std::vector<Bone> m_Bones;
     std::unordered_map<std::string, uint32_t> m_BoneLookup;
+    std::unordered_map<std::string, uint32_t> m_NormalizedBoneLookup;
     uint32_t m_RootIndex;
     Math::Matrix4x4 m_GlobalInverse;
 };
@@ -0,0 +1,238 @@
+#include "TwoBoneIK.hpp"
+#include "AnimationPose.hpp"
+#include "Skeleton.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__APPLE__)
+#include <simd/simd.h>
+#endif
+
+namespace Crescent {
+namespace {
+
+#if defined(__APPLE__)
+using Lanes = simd_float4;
+#else
+typedef float Lanes __attribute__((vector_size(16)));
+#endif
+
+constexpr size_t kLaneCount = 4;
+constexpr float kMinWeight = 0.0001f;
+constexpr float kMinLength = 0.0001f;
+constexpr float kMinAxisLengthSq = 1e-10f;
+
+Lanes Splat(float value) {
+    return Lanes{value, value, value, value};
+}
+
+template <typename Fn>
+Lanes PerLane(Lanes value, Fn fn) {
+    for (size_t i = 0; i < kLaneCount; ++i) {
+        value[i] = fn(value[i]);
+    }
+    return value;
+}
+
+Lanes Max(Lanes a, Lanes b) {
+    for (size_t i = 0; i < kLaneCount; ++i) {
+        a[i] = std::max(a[i], b[i]);
+    }
+    return a;
+}
+
+Lanes Min(Lanes a, Lanes b) {
+    for (size_t i = 0; i < kLaneCount; ++i) {
+        a[i] = std::min(a[i], b[i]);
+    }
+    return a;
+}
+
+Lanes SafeAcos(Lanes value) {
+    return PerLane(value, [](float v) { return std::acos(std::clamp(v, -1.0f, 1.0f)); });
+}
+
+// Four vectors, one per lane, stored by component.
+struct Vector3Lanes {
+    Lanes x;
+    Lanes y;
+    Lanes z;
+
+    Vector3Lanes operator-(const Vector3Lanes& other) const { return {x - other.x, y - other.y, z - other.z}; }
+    Vector3Lanes operator*(Lanes scale) const { return {x * scale, y * scale, z * scale}; }
+};
+
+Lanes Dot(const Vector3Lanes& a, const Vector3Lanes& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+Vector3Lanes Cross(const Vector3Lanes& a, const Vector3Lanes& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+Lanes Length(const Vector3Lanes& v) {
+    return PerLane(Dot(v, v), [](float v2) { return std::sqrt(v2); });
+}
+
+Vector3Lanes Normalize(const Vector3Lanes& v, Lanes length) {
+    return v * (Splat(1.0f) / Max(length, Splat(kMinLength)));
+}
+
+Math::Vector3 Lane(const Vector3Lanes& v, size_t lane) {
+    return Math::Vector3(v.x[lane], v.y[lane], v.z[lane]);
+}
+
+} // namespace
+
+void TwoBoneIKBatch::solve() {
+    m_Chains.clear();
+    for (const TwoBoneIKJob& job : m_Jobs) {
+        ChainState chain;
+        if (gatherChain(job, chain)) {
+            m_Chains.push_back(chain);
+        }
+    }
+    for (size_t first = 0; first < m_Chains.size(); first += kLaneCount) {
+        solveGroup(&m_Chains[first], std::min(kLaneCount, m_Chains.size() - first));
+    }
+    m_Jobs.clear();
+}
+
+bool TwoBoneIKBatch::gatherChain(const TwoBoneIKJob& job, ChainState& out) {
+    if (!job.skeleton || !job.pose || job.weight <= kMinWeight) {
+        return false;
+    }
+    const auto& bones = job.skeleton->getBones();
+    const AnimationLocalPose& pose = *job.pose;
+    const int count = static_cast<int>(std::min({bones.size(), pose.positions.size(),
+                                                 pose.rotations.size(), pose.scales.size()}));
+    if (job.root < 0 || job.mid < 0 || job.end < 0 ||
+        job.root >= count || job.mid >= count || job.end >= count ||
+        job.root == job.mid || job.mid == job.end) {
+        return false;
+    }
+
+    // The end and everything above it, up to the top of the skeleton; the mid has to be met before
+    // the root.
+    m_Path.clear();
+    bool passedMid = false;
+    bool passedRoot = false;
+    for (int idx = job.end; idx >= 0; idx = bones[static_cast<size_t>(idx)].parentIndex) {
+        if (idx >= count || m_Path.size() >= static_cast<size_t>(count)) {
+            return false;
+        }
+        if (idx == job.mid) {
+            passedMid = true;
+        } else if (idx == job.root) {
+            if (!passedMid) {
+                return false;
+            }
+            passedRoot = true;
+        }
+        m_Path.push_back(idx);
+    }
+    if (!passedRoot) {
+        return false;
+    }
+
+    Math::Matrix4x4 global = Math::Matrix4x4::Identity;
+    Math::Quaternion rotation = Math::Quaternion::Identity;
+    for (auto it = m_Path.rbegin(); it != m_Path.rend(); ++it) {
+        const size_t idx = static_cast<size_t>(*it);
+        global = global * Math::Matrix4x4::TRS(pose.positions[idx], pose.rotations[idx], pose.scales[idx]);
+        rotation = rotation * pose.rotations[idx];
+        if (*it == job.root) {
+            out.root = Math::Vector3(global.m[12], global.m[13], global.m[14]);
+            out.rootRotation = rotation;
+        } else if (*it == job.mid) {
+            out.mid = Math::Vector3(global.m[12], global.m[13], global.m[14]);
+            out.midRotation = rotation;
+        }
+    }
+    out.end = Math::Vector3(global.m[12], global.m[13], global.m[14]);
+    out.job = &job;
+    return true;
+}
+
+// Analytic solve: bend the root and mid about the chain's plane normal until the root-end distance
+// matches the target distance (the root-end direction is unchanged by the bend), then swing the root
+// so that direction points at the target.
+void TwoBoneIKBatch::solveGroup(const ChainState* chains, size_t count) {
+    Vector3Lanes a{};
+    Vector3Lanes b{};
+    Vector3Lanes c{};
+    Vector3Lanes t{};
+    for (size_t lane = 0; lane < kLaneCount; ++lane) {
+        // Unused lanes repeat the first chain so they stay finite.
+        const ChainState& chain = chains[lane < count ? lane : 0];
+        const Math::Vector3& target = chain.job->target;
+        a.x[lane] = chain.root.x; a.y[lane] = chain.root.y; a.z[lane] = chain.root.z;
+        b.x[lane] = chain.mid.x; b.y[lane] = chain.mid.y; b.z[lane] = chain.mid.z;
+        c.x[lane] = chain.end.x; c.y[lane] = chain.end.y; c.z[lane] = chain.end.z;
+        t.x[lane] = target.x; t.y[lane] = target.y; t.z[lane] = target.z;
+    }
+
+    const Vector3Lanes ab = b - a;
+    const Vector3Lanes bc = c - b;
+    const Vector3Lanes ac = c - a;
+    const Vector3Lanes at = t - a;
+    const Lanes lab = Length(ab);
+    const Lanes lbc = Length(bc);
+    const Lanes lac = Length(ac);
+    const Lanes eps = Splat(kMinLength);
+    const Lanes lat = Min(Max(Length(at), PerLane(lab - lbc, [](float v) { return std::abs(v); }) + eps),
+                          Max(lab + lbc - eps, eps));
+
+    const Vector3Lanes nab = Normalize(ab, lab);
+    const Vector3Lanes nbc = Normalize(bc, lbc);
+    const Vector3Lanes nac = Normalize(ac, lac);
+    const Vector3Lanes nat = Normalize(at, Length(at));
+
+    const Lanes rootAngle = SafeAcos(Dot(nac, nab));
+    const Lanes midAngle = SafeAcos(Splat(0.0f) - Dot(nab, nbc));
+    const Lanes swingAngle = SafeAcos(Dot(nac, nat));
+    const Lanes safeLab = Max(lab, eps);
+    const Lanes safeLbc = Max(lbc, eps);
+    const Lanes rootTarget = SafeAcos((lbc * lbc - lab * lab - lat * lat) / (Splat(-2.0f) * safeLab * lat));
+    const Lanes midTarget = SafeAcos((lat * lat - lab * lab - lbc * lbc) / (Splat(-2.0f) * safeLab * safeLbc));
+    const Lanes rootBend = rootTarget - rootAngle;
+    const Lanes midBend = midTarget - midAngle;
+    const Vector3Lanes bendAxes = Cross(ac, ab);
+    const Vector3Lanes swingAxes = Cross(ac, at);
+
+    for (size_t lane = 0; lane < count; ++lane) {
+        const ChainState& chain = chains[lane];
+        const TwoBoneIKJob& job = *chain.job;
+        if (lab[lane] <= kMinLength || lbc[lane] <= kMinLength) {
+            continue;
+        }
+        Math::Vector3 bendAxis = Lane(bendAxes, lane);
+        const Math::Vector3 swingAxis = Lane(swingAxes, lane);
+        // A straight chain bends towards the target.
+        if (bendAxis.lengthSquared() <= kMinAxisLengthSq) {
+            bendAxis = swingAxis;
+        }
+
+        // World rotations are applied to the local rotations in each bone's own frame.
+        const Math::Quaternion rootInverse = chain.rootRotation.inverse();
+        Math::Quaternion rootDelta = Math::Quaternion::Identity;
+        Math::Quaternion midDelta = Math::Quaternion::Identity;
+        if (bendAxis.lengthSquared() > kMinAxisLengthSq) {
+            rootDelta = Math::Quaternion::FromAxisAngle(rootInverse * bendAxis, rootBend[lane]);
+            midDelta = Math::Quaternion::FromAxisAngle(chain.midRotation.inverse() * bendAxis, midBend[lane]);
+        }
+        if (swingAxis.lengthSquared() > kMinAxisLengthSq) {
+            rootDelta = Math::Quaternion::FromAxisAngle(rootInverse * swingAxis, swingAngle[lane]) * rootDelta;
+        }
+
+        const float weight = std::min(job.weight, 1.0f);
+        Math::Quaternion& rootLocal = job.pose->rotations[static_cast<size_t>(job.root)];
+        Math::Quaternion& midLocal = job.pose->rotations[static_cast<size_t>(job.mid)];
+        const Math::Quaternion solvedRoot = (rootLocal * rootDelta).normalized();
+        const Math::Quaternion solvedMid = (midLocal * midDelta).normalized();
+        rootLocal = weight >= 1.0f ? solvedRoot : Math::Quaternion::Slerp(rootLocal, solvedRoot, weight).normalized();
+        midLocal = weight >= 1.0f ? solvedMid : Math::Quaternion::Slerp(midLocal, solvedMid, weight).normalized();
+    }
+}
+
+} // namespace Crescent
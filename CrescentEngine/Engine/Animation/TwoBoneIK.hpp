@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../Math/Math.hpp"
+#include <vector>
+
+namespace Crescent {
+
+class Skeleton;
+struct AnimationLocalPose;
+
+// A two-bone chain for the IK stage: root, mid and end bone indices (the mid under the root and
+// the end under the mid, possibly through other bones) and a target in skeleton space, the space
+// of BuildGlobalPose.
+struct TwoBoneIKJob {
+    const Skeleton* skeleton = nullptr;
+    AnimationLocalPose* pose = nullptr;
+    int root = -1;
+    int mid = -1;
+    int end = -1;
+    Math::Vector3 target = Math::Vector3::Zero;
+    float weight = 1.0f;
+};
+
+// The frame's IK stage. Chains are gathered after the pose phase and solved together: the globals
+// of each chain come from walking only its own ancestors, and the analytic solve runs four chains
+// per SIMD lane group. Only the local rotations of the root and mid bones change; the end keeps
+// its local rotation. Every chain is read before any is written, so chains of one batch must not
+// share bones.
+class TwoBoneIKBatch {
+public:
+    void add(const TwoBoneIKJob& job) { m_Jobs.push_back(job); }
+    bool empty() const { return m_Jobs.empty(); }
+    size_t size() const { return m_Jobs.size(); }
+
+    // Solves every queued chain into its pose and clears the queue. Chains whose bones are missing
+    // or not a parent chain are skipped.
+    void solve();
+
+private:
+    struct ChainState {
+        const TwoBoneIKJob* job = nullptr;
+        Math::Vector3 root;
+        Math::Vector3 mid;
+        Math::Vector3 end;
+        Math::Quaternion rootRotation;
+        Math::Quaternion midRotation;
+    };
+
+    bool gatherChain(const TwoBoneIKJob& job, ChainState& out);
+    void solveGroup(const ChainState* chains, size_t count);
+
+    std::vector<TwoBoneIKJob> m_Jobs;
+    std::vector<ChainState> m_Chains;
+    std::vector<int> m_Path;
+};
+
+} // namespace Crescent
@@ -0,0 +1,168 @@
+#include "VertexAnimationTexture.hpp"
+#include "AnimationClip.hpp"
+#include "AnimationPose.hpp"
+#include "Skeleton.hpp"
+#include "../Components/SkinnedMeshRenderer.hpp"
+#include "../Rendering/Mesh.hpp"
+#include "../Rendering/Texture.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace Crescent {
+namespace {
+
+constexpr uint32_t kMaxTextureSize = 16384;
+constexpr uint32_t kMaxVertexColumns = 4096;
+
+// Octahedral encoding in [0, 1], the inverse of decodeOctNormal in Common.metal.h after a remap
+// to [-1, 1].
+Math::Vector2 EncodeOctUnorm(const Math::Vector3& normal) {
+    Math::Vector3 n = normal;
+    float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (sum <= 0.0f) {
+        return Math::Vector2(0.5f, 1.0f);
+    }
+    n = n * (1.0f / sum);
+    Math::Vector2 e(n.x, n.y);
+    if (n.z < 0.0f) {
+        e = Math::Vector2((1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                          (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+    }
+    return Math::Vector2(e.x * 0.5f + 0.5f, e.y * 0.5f + 0.5f);
+}
+
+uint8_t QuantizeUnorm8(float value) {
+    return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+} // namespace
+
+bool BakeVertexAnimationTexture(const Mesh& mesh,
+                                const Skeleton& skeleton,
+                                const AnimationClip& clip,
+                                const VertexAnimationBakeSettings& settings,
+                                const std::string& outputPath,
+                                VertexAnimationTexture& outTexture) {
+    const std::vector<Vertex>& vertices = mesh.getVertices();
+    const std::vector<SkinWeight>& weights = mesh.getSkinWeights();
+    if (vertices.empty() || weights.size() != vertices.size() || skeleton.getBoneCount() == 0 || outputPath.empty()) {
+        std::cerr << "[VertexAnimation] " << mesh.getName() << " has no CPU skin weights to bake" << std::endl;
+        return false;
+    }
+
+    const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    // Columns stay a multiple of the 4x4 compression block, so a block never mixes the position
+    // and normal halves.
+    const uint32_t vertexColumns = std::min((vertexCount + 3u) & ~3u, kMaxVertexColumns);
+    const uint32_t rowsPerFrame = (vertexCount + vertexColumns - 1) / vertexColumns;
+    const uint32_t maxFrames = kMaxTextureSize / rowsPerFrame;
+    if (maxFrames < 2) {
+        std::cerr << "[VertexAnimation] " << mesh.getName() << " has too many vertices to bake" << std::endl;
+        return false;
+    }
+    const float duration = std::max(clip.getDurationSeconds(), 0.0f);
+    uint32_t frameCount = static_cast<uint32_t>(std::ceil(duration * std::max(settings.sampleRate, 1.0f))) + 1;
+    frameCount = std::clamp(frameCount, 2u, maxFrames);
+
+    std::vector<Math::Vector3> positions(static_cast<size_t>(vertexCount) * frameCount);
+    std::vector<Math::Vector3> normals(positions.size());
+    Math::Vector3 boundsMin(std::numeric_limits<float>::max());
+    Math::Vector3 boundsMax(-std::numeric_limits<float>::max());
+
+    AnimationLocalPose pose;
+    AnimationSampleCursor cursor;
+    std::vector<Math::Matrix4x4> skin;
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        const float time = duration * static_cast<float>(frame) / static_cast<float>(frameCount - 1);
+        SampleLocalPose(skeleton, &clip, time, false, pose, &cursor);
+        BuildSkinMatrices(skeleton, pose, skin);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            const SkinWeight& weight = weights[v];
+            float total = weight.weights[0] + weight.weights[1] + weight.weights[2] + weight.weights[3];
+            Math::Vector3 position = vertices[v].position;
+            Math::Vector3 normal = vertices[v].normal;
+            if (total > 0.0f) {
+                Math::Vector3 skinnedPosition = Math::Vector3::Zero;
+                Math::Vector3 skinnedNormal = Math::Vector3::Zero;
+                for (int i = 0; i < 4; ++i) {
+                    const float w = weight.weights[i] / total;
+                    if (w <= 0.0f || weight.indices[i] >= skin.size()) {
+                        continue;
+                    }
+                    const Math::Matrix4x4& m = skin[weight.indices[i]];
+                    skinnedPosition = skinnedPosition + m.transformPointAffine(position) * w;
+                    skinnedNormal = skinnedNormal + m.transformDirection(normal) * w;
+                }
+                position = skinnedPosition;
+                normal = skinnedNormal;
+            }
+            const size_t index = static_cast<size_t>(frame) * vertexCount + v;
+            positions[index] = position;
+            normals[index] = normal.normalized();
+            boundsMin = Math::Vector3::Min(boundsMin, position);
+            boundsMax = Math::Vector3::Max(boundsMax, position);
+        }
+    }
+
+    const Math::Vector3 extent = boundsMax - boundsMin;
+    const Math::Vector3 invExtent(extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+                                  extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+                                  extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+    const uint32_t width = vertexColumns * 2;
+    const uint32_t height = rowsPerFrame * frameCount;
+    std::vector<unsigned char> rgba(static_cast<size_t>(width) * height * 4, 0);
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            const size_t index = static_cast<size_t>(frame) * vertexCount + v;
+            const uint32_t x = v % vertexColumns;
+            const uint32_t y = frame * rowsPerFrame + v / vertexColumns;
+            unsigned char* position = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+            const Math::Vector3 p = positions[index] - boundsMin;
+            position[0] = QuantizeUnorm8(p.x * invExtent.x);
+            position[1] = QuantizeUnorm8(p.y * invExtent.y);
+            position[2] = QuantizeUnorm8(p.z * invExtent.z);
+            position[3] = 255;
+            unsigned char* normal = position + static_cast<size_t>(vertexColumns) * 4;
+            const Math::Vector2 oct = EncodeOctUnorm(normals[index]);
+            normal[0] = QuantizeUnorm8(oct.x);
+            normal[1] = QuantizeUnorm8(oct.y);
+            normal[2] = 0;
+            normal[3] = 255;
+        }
+    }
+
+    if (!CookDataTextureToKTX2(rgba.data(), static_cast<int>(width), static_cast<int>(height), outputPath)) {
+        std::cerr << "[VertexAnimation] Failed to cook " << outputPath << std::endl;
+        return false;
+    }
+
+    outTexture = VertexAnimationTexture{};
+    outTexture.texturePath = outputPath;
+    outTexture.vertexCount = vertexCount;
+    outTexture.frameCount = frameCount;
+    outTexture.vertexColumns = vertexColumns;
+    outTexture.rowsPerFrame = rowsPerFrame;
+    outTexture.durationSeconds = duration;
+    outTexture.looping = settings.looping;
+    outTexture.boundsMin = boundsMin;
+    outTexture.boundsMax = boundsMax;
+    return true;
+}
+
+bool BakeVertexAnimationTexture(const SkinnedMeshRenderer& renderer,
+                                const AnimationClip& clip,
+                                const VertexAnimationBakeSettings& settings,
+                                const std::string& outputPath,
+                                VertexAnimationTexture& outTexture) {
+    std::shared_ptr<Mesh> mesh = renderer.getMesh();
+    std::shared_ptr<Skeleton> skeleton = renderer.getSkeleton();
+    if (!mesh || !skeleton) {
+        return false;
+    }
+    return BakeVertexAnimationTexture(*mesh, *skeleton, clip, settings, outputPath, outTexture);
+}
+
+} // namespace Crescent
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../Math/Math.hpp"
+#include <cstdint>
+#include <string>
+
+namespace Crescent {
+
+class AnimationClip;
+class Mesh;
+class Skeleton;
+class SkinnedMeshRenderer;
+
+// A clip baked into a vertex animation texture (VAT): the skinned position and normal of every
+// vertex at every frame, so instances play the animation with texture fetches instead of skinning.
+// Frame f of vertex v sits at (v % vertexColumns, f * rowsPerFrame + v / vertexColumns); its
+// position is in the left half of the texture, normalized to the bounds, and its octahedral
+// normal in the right half at the same offset. The texture is linear RGBA8, cooked to KTX2
+// without mips.
+struct VertexAnimationTexture {
+    std::string texturePath;
+    uint32_t vertexCount = 0;
+    uint32_t frameCount = 0;
+    uint32_t vertexColumns = 0;
+    uint32_t rowsPerFrame = 0;
+    // Frames are spaced evenly over the clip; the first and last frame are its ends.
+    float durationSeconds = 0.0f;
+    bool looping = true;
+    Math::Vector3 boundsMin = Math::Vector3::Zero;
+    Math::Vector3 boundsMax = Math::Vector3::Zero;
+
+    bool isValid() const { return !texturePath.empty() && vertexCount > 0 && frameCount > 1 && vertexColumns > 0; }
+};
+
+struct VertexAnimationBakeSettings {
+    float sampleRate = 30.0f;
+    bool looping = true;
+};
+
+// Offline: samples the clip on the skeleton, skins the mesh on the CPU at every frame and cooks
+// the result to outputPath (a .ktx2). The frame rate drops when the clip would not fit the
+// texture size limit. Returns false when the mesh has no skin weights or the cook fails.
+bool BakeVertexAnimationTexture(const Mesh& mesh,
+                                const Skeleton& skeleton,
+                                const AnimationClip& clip,
+                                const VertexAnimationBakeSettings& settings,
+                                const std::string& outputPath,
+                                VertexAnimationTexture& outTexture);
+// Bakes the renderer's mesh and skeleton with one of its clips.
+bool BakeVertexAnimationTexture(const SkinnedMeshRenderer& renderer,
+                                const AnimationClip& clip,
+                                const VertexAnimationBakeSettings& settings,
+                                const std::string& outputPath,
+                                VertexAnimationTexture& outTexture);
+
+} // namespace Crescent
@@ -1,11 +1,20 @@
 #include "AssetDatabase.hpp"
-#include "../Core/UUID.hpp"
+#include "AssetWatcher.hpp"
+#include "../Core/CPUProfiler.hpp"
+#include "../Core/StartupTrace.hpp"
 #include "../../../ThirdParty/nlohmann/json.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cstdlib>
+#include <cstring>
 #include <chrono>
+#include <condition_variable>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
 #include <unordered_set>
 
 namespace Crescent {
@@ -15,6 +24,14 @@ using json = nlohmann::json;
 
 constexpr int kMetaVersion = 1;
 
+// Library/AssetIndex.bin: header, root path, entry count, then per asset its relative path, guid
+// (both halves), type, file stamp and every import settings struct field by field. Bump the
+// version whenever AssetRecord or an import settings struct changes.
+constexpr uint32_t kIndexMagic = 0x58494143u; // "CAIX"
+constexpr uint32_t kIndexVersion = 2;
+constexpr uint32_t kIndexMaxString = 4096;
+constexpr unsigned kMaxScanThreads = 8;
+
 std::string ToLower(std::string value) {
     for (char& c : value) {
         c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
@@ -39,6 +56,78 @@ uint64_t ToUnixTimestamp(const std::filesystem::file_time_type& time) {
     return static_cast<uint64_t>(seconds.count());
 }
 
+uint64_t FileTimeTicks(const std::filesystem::file_time_type& time) {
+    return static_cast<uint64_t>(time.time_since_epoch().count());
+}
+
+unsigned ScanThreadCount() {
+    return std::max(1u, std::min(std::thread::hardware_concurrency(), kMaxScanThreads));
+}
+
+// No empty, "." or ".." components and no leading or trailing separator, so joining the path
+// to the root by hand gives what lexically_normal would.
+bool IsNormalRelativePath(const std::string& path) {
+    if (path.empty() || path.front() == '/' || path.back() == '/') {
+        return false;
+    }
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        const size_t length = end - start;
+        if (length == 0 || (length == 1 && path[start] == '.') ||
+            (length == 2 && path[start] == '.' && path[start + 1] == '.')) {
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+bool IsSkippedFile(const std::filesystem::path& path) {
+    return path.extension() == ".cmeta" || path.extension() == ".meta" || path.filename() == ".DS_Store";
+}
+
+template <typename T>
+void WriteIndexValue(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void WriteIndexString(std::string& out, const std::string& value) {
+    WriteIndexValue(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+// Reads the index from memory; any short read leaves ok false and the index is ignored.
+struct IndexReader {
+    const std::string& data;
+    size_t offset = 0;
+    bool ok = true;
+
+    template <typename T>
+    void read(T& value) {
+        if (!ok || data.size() - offset < sizeof(T)) {
+            ok = false;
+            return;
+        }
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        offset += sizeof(T);
+    }
+
+    void readString(std::string& value) {
+        uint32_t length = 0;
+        read(length);
+        if (!ok || length > kIndexMaxString || data.size() - offset < length) {
+            ok = false;
+            return;
+        }
+        value.assign(data.data() + offset, length);
+        offset += length;
+    }
+};
+
 json SerializeModelSettings(const ModelImportSettings& settings) {
     return {
         {"scale", settings.scale},
@@ -66,7 +155,8 @@ json SerializeTextureSettings(const TextureImportSettings& settings) {
         {"generateMipmaps", settings.generateMipmaps},
         {"flipY", settings.flipY},
         {"maxSize", settings.maxSize},
-        {"normalMap", settings.normalMap}
+        {"normalMap", settings.normalMap},
+        {"blockSize", settings.blockSize}
     };
 }
 
@@ -80,6 +170,7 @@ TextureImportSettings DeserializeTextureSettings(const json& j, const TextureImp
     settings.flipY = j.value("flipY", settings.flipY);
     settings.maxSize = j.value("maxSize", settings.maxSize);
     settings.normalMap = j.value("normalMap", settings.normalMap);
+    settings.blockSize = j.value("blockSize", settings.blockSize);
     return settings;
 }
 
@@ -107,9 +198,27 @@ AssetDatabase& AssetDatabase::getInstance() {
     return instance;
 }
 
+AssetDatabase::AssetDatabase()
+    : m_Watcher(std::make_unique<AssetWatcher>()) {
+}
+
+AssetDatabase::~AssetDatabase() = default;
+
 void AssetDatabase::setRootPath(const std::string& path) {
-    m_RootPath = normalizePath(path);
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    std::string normalized = normalizePath(path);
+    // A watched root is already current; loading it again only needs the pending changes.
+    if (!normalized.empty() && normalized == m_RootPath && m_Watcher->isRunning()) {
+        processFileChanges();
+        return;
+    }
+    m_RootPath = normalized;
+    m_Watcher->stop();
     if (!EnvEnabled("CRESCENT_SKIP_ASSET_RESCAN")) {
+        // Started first so nothing changed during the scan is missed.
+        if (!m_RootPath.empty()) {
+            m_Watcher->start(m_RootPath);
+        }
         rescan();
     } else {
         clear();
@@ -117,6 +226,7 @@ void AssetDatabase::setRootPath(const std::string& path) {
 }
 
 void AssetDatabase::setLibraryPath(const std::string& path) {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
     m_LibraryPath = normalizePath(path);
     if (m_LibraryPath.empty()) {
         return;
@@ -127,11 +237,106 @@ void AssetDatabase::setLibraryPath(const std::string& path) {
 }
 
 void AssetDatabase::clear() {
-    m_GuidToRecord.clear();
-    m_PathToGuid.clear();
+    m_Assets.clear();
+    m_FreeAssets.clear();
+    m_GuidIndex.clear();
+    m_PathIds.clear();
+    m_Paths.clear();
+    m_PathEntries.clear();
+}
+
+uint32_t AssetDatabase::findPathId(const std::string& normalizedPath) const {
+    auto it = m_PathIds.find(std::string_view(normalizedPath));
+    return it != m_PathIds.end() ? it->second : kNone;
+}
+
+uint32_t AssetDatabase::lookupPath(const std::string& absolutePath) const {
+    uint32_t pathId = findPathId(absolutePath);
+    if (pathId == kNone && !absolutePath.empty()) {
+        pathId = findPathId(normalizePath(absolutePath));
+    }
+    return pathId;
+}
+
+uint32_t AssetDatabase::internPath(const std::string& normalizedPath) {
+    uint32_t pathId = findPathId(normalizedPath);
+    if (pathId != kNone) {
+        return pathId;
+    }
+    pathId = static_cast<uint32_t>(m_Paths.size());
+    m_Paths.push_back(normalizedPath);
+    m_PathIds.emplace(std::string_view(m_Paths.back()), pathId);
+    m_PathEntries.emplace_back();
+    return pathId;
+}
+
+uint32_t AssetDatabase::findAssetAtPath(const std::string& absolutePath) const {
+    const uint32_t pathId = lookupPath(absolutePath);
+    if (pathId == kNone) {
+        return kNone;
+    }
+    return findAsset(m_PathEntries[pathId].guid);
+}
+
+void AssetDatabase::storeAsset(AssetRecord&& record, uint32_t pathId) {
+    PathEntry& entry = m_PathEntries[pathId];
+    if (entry.guid.isValid() && entry.guid != record.guid) {
+        const uint32_t previous = findAsset(entry.guid);
+        if (previous != kNone && m_Assets[previous].pathId == pathId) {
+            releaseAsset(previous);
+        }
+    }
+    uint32_t asset = findAsset(record.guid);
+    if (asset == kNone) {
+        if (!m_FreeAssets.empty()) {
+            asset = m_FreeAssets.back();
+            m_FreeAssets.pop_back();
+        } else {
+            asset = static_cast<uint32_t>(m_Assets.size());
+            m_Assets.emplace_back();
+        }
+        m_GuidIndex.insert(record.guid, asset);
+    }
+    StoredAsset& stored = m_Assets[asset];
+    stored.guid = record.guid;
+    stored.pathId = pathId;
+    stored.type = std::move(record.type);
+    stored.modelSettings = record.modelSettings;
+    stored.textureSettings = record.textureSettings;
+    stored.hdriSettings = record.hdriSettings;
+    entry.guid = record.guid;
+}
+
+void AssetDatabase::releaseAsset(uint32_t asset) {
+    m_GuidIndex.erase(m_Assets[asset].guid);
+    m_Assets[asset] = StoredAsset();
+    m_FreeAssets.push_back(asset);
+}
+
+std::string AssetDatabase::relativePathFor(uint32_t pathId) const {
+    const std::string& path = m_Paths[pathId];
+    const size_t rootLength = m_RootPath.size();
+    if (rootLength > 0 && path.size() > rootLength + 1 && path[rootLength] == '/' &&
+        path.compare(0, rootLength, m_RootPath) == 0) {
+        return path.substr(rootLength + 1);
+    }
+    return getRelativePath(path);
+}
+
+AssetRecord AssetDatabase::toRecord(const StoredAsset& asset) const {
+    AssetRecord record;
+    record.guid = asset.guid;
+    record.relativePath = relativePathFor(asset.pathId);
+    record.type = asset.type;
+    record.modelSettings = asset.modelSettings;
+    record.textureSettings = asset.textureSettings;
+    record.hdriSettings = asset.hdriSettings;
+    return record;
 }
 
 void AssetDatabase::rescan() {
+    StartupTraceScope trace("assets", "AssetDatabase::rescan");
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
     clear();
     if (m_RootPath.empty()) {
         return;
@@ -142,39 +347,427 @@ void AssetDatabase::rescan() {
         return;
     }
 
-    std::filesystem::recursive_directory_iterator it(root, ec);
-    if (ec) {
-        return;
+    std::unordered_map<std::string, IndexEntry> index;
+    loadIndex(index);
+    std::vector<ScannedFile> files;
+    scanFiles(files);
+
+    // Unchanged files reuse their indexed record; the rest parse or create their .cmeta, which is
+    // what a cold scan spends its time on, so that runs on the scan threads too.
+    std::vector<AssetRecord> records(files.size());
+    std::atomic<size_t> next{0};
+    const std::string rootPrefix = m_RootPath + "/";
+    auto resolve = [&]() {
+        for (size_t i = next++; i < files.size(); i = next++) {
+            ScannedFile& file = files[i];
+            // Walked paths sit under the root as-is, which spares getRelativePath's canonicalization.
+            std::string relativePath = file.absolutePath.rfind(rootPrefix, 0) == 0
+                ? file.absolutePath.substr(rootPrefix.size())
+                : getRelativePath(file.absolutePath);
+            auto indexed = index.find(relativePath);
+            if (indexed != index.end() && indexed->second.stamp == file.stamp &&
+                indexed->second.record.type == file.type) {
+                records[i] = indexed->second.record;
+                continue;
+            }
+            records[i] = loadOrCreateRecord(file.absolutePath, file.type);
+            std::error_code statEc;
+            auto metaTime = std::filesystem::last_write_time(metaPathForAsset(file.absolutePath), statEc);
+            file.stamp.metaTime = statEc ? 0 : FileTimeTicks(metaTime);
+        }
+    };
+    std::vector<std::thread> threads;
+    const size_t threadCount = std::min<size_t>(ScanThreadCount(), std::max<size_t>(files.size() / 64, 1));
+    for (size_t i = 1; i < threadCount; ++i) {
+        threads.emplace_back(resolve);
+    }
+    resolve();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    m_Assets.reserve(files.size());
+    m_PathEntries.reserve(files.size());
+    m_PathIds.reserve(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        AssetRecord& record = records[i];
+        if (!record.guid.isValid()) {
+            continue;
+        }
+        const uint32_t pathId = internPath(files[i].absolutePath);
+        storeAsset(std::move(record), pathId);
+        m_PathEntries[pathId].stamp = files[i].stamp;
+        m_PathEntries[pathId].hasStamp = true;
     }
+    saveIndex();
+}
 
-    for (const auto& entry : it) {
-        if (!entry.is_regular_file(ec)) {
+void AssetDatabase::refreshPaths(const std::vector<std::string>& paths) {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    if (m_RootPath.empty()) {
+        return;
+    }
+    std::unordered_set<std::string> visited;
+    bool changed = false;
+    for (const std::string& path : paths) {
+        std::string normalized = normalizePath(path);
+        if (!isUnderRoot(normalized) || !visited.insert(normalized).second) {
             continue;
         }
-        std::filesystem::path path = entry.path();
-        if (path.extension() == ".cmeta" || path.extension() == ".meta") {
+        std::filesystem::path fsPath(normalized);
+        if (fsPath.extension() == ".cmeta") {
+            changed |= refreshFile(normalized.substr(0, normalized.size() - std::strlen(".cmeta")));
             continue;
         }
-        if (path.filename() == ".DS_Store") {
+        std::error_code ec;
+        if (std::filesystem::is_directory(fsPath, ec)) {
+            // Known assets under the directory may be gone, new ones may have appeared.
+            std::vector<std::string> targets;
+            const std::string prefix = normalized + "/";
+            for (uint32_t pathId = 0; pathId < m_PathEntries.size(); ++pathId) {
+                if (m_PathEntries[pathId].guid.isValid() && m_Paths[pathId].rfind(prefix, 0) == 0) {
+                    targets.push_back(m_Paths[pathId]);
+                }
+            }
+            std::filesystem::recursive_directory_iterator it(fsPath, ec), end;
+            for (; !ec && it != end; it.increment(ec)) {
+                if (it->is_regular_file(ec) && !IsSkippedFile(it->path())) {
+                    targets.push_back(it->path().string());
+                }
+            }
+            for (const std::string& target : targets) {
+                if (visited.insert(target).second) {
+                    changed |= refreshFile(target);
+                }
+            }
+        } else if (std::filesystem::exists(fsPath, ec)) {
+            changed |= refreshFile(normalized);
+        } else {
+            // A removed file, or a removed directory and everything that was under it.
+            changed |= removePath(normalized);
+            const std::string prefix = normalized + "/";
+            std::vector<std::string> removed;
+            for (uint32_t pathId = 0; pathId < m_PathEntries.size(); ++pathId) {
+                if (m_PathEntries[pathId].guid.isValid() && m_Paths[pathId].rfind(prefix, 0) == 0) {
+                    removed.push_back(m_Paths[pathId]);
+                }
+            }
+            for (const std::string& target : removed) {
+                changed |= removePath(target);
+            }
+        }
+    }
+    if (changed) {
+        saveIndex();
+    }
+}
+
+void AssetDatabase::processFileChanges() {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    if (!m_Watcher->isRunning()) {
+        return;
+    }
+    std::vector<std::string> changes;
+    if (m_Watcher->takeChanges(changes)) {
+        rescan();
+        return;
+    }
+    if (!changes.empty()) {
+        refreshPaths(changes);
+    }
+}
+
+bool AssetDatabase::refreshFile(const std::string& absolutePath) {
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(absolutePath, ec)) {
+        return removePath(absolutePath);
+    }
+    std::string type;
+    std::string ext = ToLower(std::filesystem::path(absolutePath).extension().string());
+    if (!isAssetFile(ext, type)) {
+        return false;
+    }
+    FileStamp stamp;
+    if (!statAsset(absolutePath, stamp)) {
+        return false;
+    }
+    const uint32_t knownId = findPathId(absolutePath);
+    if (knownId != kNone) {
+        const PathEntry& known = m_PathEntries[knownId];
+        if (known.guid.isValid() && known.hasStamp && known.stamp == stamp) {
+            return false;
+        }
+    }
+    AssetRecord record = loadOrCreateRecord(absolutePath, type);
+    if (!record.guid.isValid()) {
+        return false;
+    }
+    statAsset(absolutePath, stamp);
+    const uint32_t pathId = internPath(absolutePath);
+    storeAsset(std::move(record), pathId);
+    m_PathEntries[pathId].stamp = stamp;
+    m_PathEntries[pathId].hasStamp = true;
+    return true;
+}
+
+bool AssetDatabase::removePath(const std::string& absolutePath) {
+    const uint32_t pathId = findPathId(absolutePath);
+    if (pathId == kNone || !m_PathEntries[pathId].guid.isValid()) {
+        return false;
+    }
+    // A moved asset may already be registered at its new path under the same guid.
+    const uint32_t asset = findAsset(m_PathEntries[pathId].guid);
+    if (asset != kNone && m_Assets[asset].pathId == pathId) {
+        releaseAsset(asset);
+    }
+    m_PathEntries[pathId] = PathEntry();
+    return true;
+}
+
+void AssetDatabase::scanFiles(std::vector<ScannedFile>& outFiles) const {
+    // Directories are handed out one at a time so both deep and wide trees spread across threads.
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::filesystem::path> pending{std::filesystem::path(m_RootPath)};
+    size_t busy = 0;
+
+    auto walk = [&]() {
+        std::vector<ScannedFile> found;
+        std::vector<std::filesystem::path> subdirs;
+        std::unordered_map<std::string, uint64_t> metaTimes;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&]() { return !pending.empty() || busy == 0; });
+            if (pending.empty()) {
+                break;
+            }
+            std::filesystem::path dir = std::move(pending.back());
+            pending.pop_back();
+            ++busy;
+            lock.unlock();
+
+            const size_t firstFile = found.size();
+            subdirs.clear();
+            metaTimes.clear();
+            std::error_code ec;
+            std::filesystem::directory_iterator it(dir, std::filesystem::directory_options::skip_permission_denied, ec), end;
+            for (; !ec && it != end; it.increment(ec)) {
+                const std::filesystem::directory_entry& entry = *it;
+                std::error_code entryEc;
+                if (entry.is_symlink(entryEc) && entry.is_directory(entryEc)) {
+                    continue;
+                }
+                if (entry.is_directory(entryEc)) {
+                    subdirs.push_back(entry.path());
+                    continue;
+                }
+                if (!entry.is_regular_file(entryEc)) {
+                    continue;
+                }
+                const std::filesystem::path& path = entry.path();
+                if (path.extension() == ".cmeta") {
+                    auto time = entry.last_write_time(entryEc);
+                    if (!entryEc) {
+                        metaTimes[path.filename().string()] = FileTimeTicks(time);
+                    }
+                    continue;
+                }
+                if (IsSkippedFile(path)) {
+                    continue;
+                }
+                ScannedFile file;
+                std::string ext = ToLower(path.extension().string());
+                if (!isAssetFile(ext, file.type)) {
+                    continue;
+                }
+                // Walked paths are already canonical below the root; only symlinked files need
+                // resolving.
+                file.absolutePath = entry.is_symlink(entryEc) ? normalizePath(path.string()) : path.string();
+                file.stamp.assetSize = entry.file_size(entryEc);
+                file.stamp.assetTime = FileTimeTicks(entry.last_write_time(entryEc));
+                found.push_back(std::move(file));
+            }
+            for (size_t i = firstFile; i < found.size(); ++i) {
+                auto meta = metaTimes.find(std::filesystem::path(found[i].absolutePath).filename().string() + ".cmeta");
+                found[i].stamp.metaTime = meta != metaTimes.end() ? meta->second : 0;
+            }
+
+            lock.lock();
+            --busy;
+            pending.insert(pending.end(), std::make_move_iterator(subdirs.begin()), std::make_move_iterator(subdirs.end()));
+            wake.notify_all();
+        }
+        outFiles.insert(outFiles.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < ScanThreadCount(); ++i) {
+        threads.emplace_back(walk);
+    }
+    walk();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+bool AssetDatabase::statAsset(const std::string& absolutePath, FileStamp& outStamp) const {
+    std::error_code ec;
+    auto assetTime = std::filesystem::last_write_time(absolutePath, ec);
+    if (ec) {
+        return false;
+    }
+    auto assetSize = std::filesystem::file_size(absolutePath, ec);
+    if (ec) {
+        return false;
+    }
+    outStamp.assetTime = FileTimeTicks(assetTime);
+    outStamp.assetSize = static_cast<uint64_t>(assetSize);
+    auto metaTime = std::filesystem::last_write_time(metaPathForAsset(absolutePath), ec);
+    outStamp.metaTime = ec ? 0 : FileTimeTicks(metaTime);
+    return true;
+}
+
+std::string AssetDatabase::indexPath() const {
+    if (m_LibraryPath.empty()) {
+        return "";
+    }
+    return (std::filesystem::path(m_LibraryPath) / "AssetIndex.bin").string();
+}
+
+bool AssetDatabase::loadIndex(std::unordered_map<std::string, IndexEntry>& outEntries) const {
+    const std::string path = indexPath();
+    if (path.empty()) {
+        return false;
+    }
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    IndexReader reader{data};
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    std::string root;
+    uint32_t count = 0;
+    reader.read(magic);
+    reader.read(version);
+    reader.readString(root);
+    reader.read(count);
+    // An index written for another root (a scene pointing elsewhere) says nothing about this one.
+    if (!reader.ok || magic != kIndexMagic || version != kIndexVersion || root != m_RootPath) {
+        return false;
+    }
+    outEntries.reserve(count);
+    for (uint32_t i = 0; i < count && reader.ok; ++i) {
+        IndexEntry entry;
+        AssetRecord& record = entry.record;
+        reader.readString(record.relativePath);
+        reader.read(record.guid.high);
+        reader.read(record.guid.low);
+        reader.readString(record.type);
+        reader.read(entry.stamp.assetTime);
+        reader.read(entry.stamp.assetSize);
+        reader.read(entry.stamp.metaTime);
+        reader.read(record.modelSettings.scale);
+        reader.read(record.modelSettings.flipUVs);
+        reader.read(record.modelSettings.onlyLOD0);
+        reader.read(record.modelSettings.mergeStaticMeshes);
+        reader.read(record.textureSettings.srgb);
+        reader.read(record.textureSettings.generateMipmaps);
+        reader.read(record.textureSettings.flipY);
+        reader.read(record.textureSettings.maxSize);
+        reader.read(record.textureSettings.normalMap);
+        reader.read(record.textureSettings.blockSize);
+        reader.read(record.hdriSettings.flipY);
+        reader.read(record.hdriSettings.maxSize);
+        if (reader.ok) {
+            std::string key = record.relativePath;
+            outEntries.emplace(std::move(key), std::move(entry));
+        }
+    }
+    if (!reader.ok) {
+        outEntries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool AssetDatabase::saveIndex() const {
+    const std::string path = indexPath();
+    if (path.empty() || m_RootPath.empty()) {
+        return false;
+    }
+    std::string data;
+    data.reserve(64 + m_Assets.size() * 128);
+    WriteIndexValue(data, kIndexMagic);
+    WriteIndexValue(data, kIndexVersion);
+    WriteIndexString(data, m_RootPath);
+    const size_t countOffset = data.size();
+    uint32_t count = 0;
+    WriteIndexValue(data, count);
+    for (uint32_t pathId = 0; pathId < m_PathEntries.size(); ++pathId) {
+        const PathEntry& entry = m_PathEntries[pathId];
+        const uint32_t asset = findAsset(entry.guid);
+        // A path sharing its guid with the asset's own path (a copied .cmeta) is left to the scan.
+        if (asset == kNone || m_Assets[asset].pathId != pathId) {
             continue;
         }
-        std::string type;
-        std::string ext = ToLower(path.extension().string());
-        if (!isAssetFile(ext, type)) {
+        const StoredAsset& record = m_Assets[asset];
+        const std::string relativePath = relativePathFor(pathId);
+        if (relativePath.empty() || std::filesystem::path(relativePath).is_absolute()) {
             continue;
         }
-        std::string absPath = normalizePath(path.string());
-        AssetRecord record = loadOrCreateRecord(absPath, type);
-        if (record.guid.empty()) {
+        FileStamp stamp;
+        if (entry.hasStamp) {
+            stamp = entry.stamp;
+        } else if (!statAsset(m_Paths[pathId], stamp)) {
             continue;
         }
-        record.relativePath = getRelativePath(absPath);
-        m_GuidToRecord[record.guid] = record;
-        m_PathToGuid[absPath] = record.guid;
+        WriteIndexString(data, relativePath);
+        WriteIndexValue(data, record.guid.high);
+        WriteIndexValue(data, record.guid.low);
+        WriteIndexString(data, record.type);
+        WriteIndexValue(data, stamp.assetTime);
+        WriteIndexValue(data, stamp.assetSize);
+        WriteIndexValue(data, stamp.metaTime);
+        WriteIndexValue(data, record.modelSettings.scale);
+        WriteIndexValue(data, record.modelSettings.flipUVs);
+        WriteIndexValue(data, record.modelSettings.onlyLOD0);
+        WriteIndexValue(data, record.modelSettings.mergeStaticMeshes);
+        WriteIndexValue(data, record.textureSettings.srgb);
+        WriteIndexValue(data, record.textureSettings.generateMipmaps);
+        WriteIndexValue(data, record.textureSettings.flipY);
+        WriteIndexValue(data, record.textureSettings.maxSize);
+        WriteIndexValue(data, record.textureSettings.normalMap);
+        WriteIndexValue(data, record.textureSettings.blockSize);
+        WriteIndexValue(data, record.hdriSettings.flipY);
+        WriteIndexValue(data, record.hdriSettings.maxSize);
+        ++count;
+    }
+    std::memcpy(&data[countOffset], &count, sizeof(count));
+
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
     }
+    return true;
 }
 
 std::string AssetDatabase::registerAsset(const std::string& absolutePath, const std::string& type) {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
     if (m_RootPath.empty()) {
         return "";
     }
@@ -182,9 +775,9 @@ std::string AssetDatabase::registerAsset(const std::string& absolutePath, const
     if (!isUnderRoot(normalized)) {
         return "";
     }
-    auto it = m_PathToGuid.find(normalized);
-    if (it != m_PathToGuid.end()) {
-        return it->second;
+    const uint32_t knownId = findPathId(normalized);
+    if (knownId != kNone && m_PathEntries[knownId].guid.isValid()) {
+        return m_PathEntries[knownId].guid.toString();
     }
     std::string assetType = type;
     if (assetType.empty()) {
@@ -194,17 +787,24 @@ std::string AssetDatabase::registerAsset(const std::string& absolutePath, const
         }
     }
     AssetRecord record = loadOrCreateRecord(normalized, assetType);
-    if (record.guid.empty()) {
+    if (!record.guid.isValid()) {
         return "";
     }
-    record.relativePath = getRelativePath(normalized);
-    m_GuidToRecord[record.guid] = record;
-    m_PathToGuid[normalized] = record.guid;
-    recordImportForGuid(record.guid);
-    return record.guid;
+    const AssetGuid guid = record.guid;
+    const uint32_t pathId = internPath(normalized);
+    storeAsset(std::move(record), pathId);
+    FileStamp stamp;
+    if (statAsset(normalized, stamp)) {
+        m_PathEntries[pathId].stamp = stamp;
+        m_PathEntries[pathId].hasStamp = true;
+    }
+    recordImportForGuid(guid);
+    return guid.toString();
 }
 
 std::string AssetDatabase::importAsset(const std::string& sourcePath, const std::string& type) {
+    CRESCENT_PROFILE_SCOPE("AssetDatabase::importAsset");
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
     if (sourcePath.empty()) {
         return "";
     }
@@ -266,19 +866,27 @@ std::string AssetDatabase::importAsset(const std::string& sourcePath, const std:
 }
 
 std::string AssetDatabase::getGuidForPath(const std::string& absolutePath) const {
-    auto it = m_PathToGuid.find(normalizePath(absolutePath));
-    if (it != m_PathToGuid.end()) {
-        return it->second;
-    }
-    return "";
+    AssetGuid guid = findGuidForPath(absolutePath);
+    return guid.isValid() ? guid.toString() : std::string();
+}
+
+AssetGuid AssetDatabase::findGuidForPath(const std::string& absolutePath) const {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    const uint32_t pathId = lookupPath(absolutePath);
+    return pathId != kNone ? m_PathEntries[pathId].guid : AssetGuid();
 }
 
 std::string AssetDatabase::getPathForGuid(const std::string& guid) const {
-    auto it = m_GuidToRecord.find(guid);
-    if (it == m_GuidToRecord.end()) {
+    return getPathForGuid(AssetGuid::Parse(guid));
+}
+
+std::string AssetDatabase::getPathForGuid(const AssetGuid& guid) const {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    const uint32_t asset = findAsset(guid);
+    if (asset == kNone) {
         return "";
     }
-    return resolvePath(it->second.relativePath);
+    return m_Paths[m_Assets[asset].pathId];
 }
 
 std::string AssetDatabase::getRelativePath(const std::string& absolutePath) const {
@@ -299,8 +907,19 @@ std::string AssetDatabase::resolvePath(const std::string& storedPath) const {
     if (storedPath.empty()) {
         return "";
     }
+    if (storedPath.front() == '/' || m_RootPath.empty()) {
+        return storedPath;
+    }
+    // Stored paths are normally already normal; joining those by hand skips lexically_normal's
+    // per-component allocations, which scene loads pay for every reference.
+    if (m_RootPath.back() != '/' && IsNormalRelativePath(storedPath)) {
+        std::string resolved;
+        resolved.reserve(m_RootPath.size() + 1 + storedPath.size());
+        resolved.append(m_RootPath).append(1, '/').append(storedPath);
+        return resolved;
+    }
     std::filesystem::path path(storedPath);
-    if (path.is_absolute() || m_RootPath.empty()) {
+    if (path.is_absolute()) {
         return storedPath;
     }
     std::filesystem::path root(m_RootPath);
@@ -308,6 +927,7 @@ std::string AssetDatabase::resolvePath(const std::string& storedPath) const {
 }
 
 bool AssetDatabase::moveAsset(const std::string& sourcePath, const std::string& targetPath, bool overwrite) {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
     if (m_RootPath.empty()) {
         return false;
     }
@@ -372,23 +992,17 @@ bool AssetDatabase::moveAsset(const std::string& sourcePath, const std::string&
     }
 
     AssetRecord record;
-    auto guidIt = m_PathToGuid.find(source);
-    if (guidIt != m_PathToGuid.end()) {
-        auto recordIt = m_GuidToRecord.find(guidIt->second);
-        if (recordIt != m_GuidToRecord.end()) {
-            record = recordIt->second;
-        }
-    } else {
-        record = loadOrCreateRecord(source, targetType);
+    const uint32_t sourceAsset = findAssetAtPath(source);
+    if (sourceAsset != kNone) {
+        record = toRecord(m_Assets[sourceAsset]);
     }
-    if (record.guid.empty()) {
+    if (!record.guid.isValid()) {
         record = loadOrCreateRecord(source, targetType);
     }
-    if (record.guid.empty()) {
+    if (!record.guid.isValid()) {
         return false;
     }
     record.type = targetType;
-    record.relativePath = getRelativePath(target);
 
     std::filesystem::rename(sourcePathFs, targetPathFs, ec);
     if (ec) {
@@ -428,98 +1042,110 @@ bool AssetDatabase::moveAsset(const std::string& sourcePath, const std::string&
         }
     }
 
-    m_PathToGuid.erase(source);
-    m_PathToGuid[target] = record.guid;
-    m_GuidToRecord[record.guid] = record;
-    recordImportForGuid(record.guid);
+    const uint32_t sourceId = findPathId(source);
+    if (sourceId != kNone) {
+        m_PathEntries[sourceId] = PathEntry();
+    }
+    const AssetGuid guid = record.guid;
+    const uint32_t targetId = internPath(target);
+    storeAsset(std::move(record), targetId);
+    FileStamp stamp;
+    if (statAsset(target, stamp)) {
+        m_PathEntries[targetId].stamp = stamp;
+        m_PathEntries[targetId].hasStamp = true;
+    }
+    recordImportForGuid(guid);
     return true;
 }
 
 bool AssetDatabase::getRecordForGuid(const std::string& guid, AssetRecord& outRecord) const {
-    auto it = m_GuidToRecord.find(guid);
-    if (it == m_GuidToRecord.end()) {
+    return getRecordForGuid(AssetGuid::Parse(guid), outRecord);
+}
+
+bool AssetDatabase::getRecordForGuid(const AssetGuid& guid, AssetRecord& outRecord) const {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    const uint32_t asset = findAsset(guid);
+    if (asset == kNone) {
         return false;
     }
-    outRecord = it->second;
+    outRecord = toRecord(m_Assets[asset]);
     return true;
 }
 
 bool AssetDatabase::getRecordForPath(const std::string& absolutePath, AssetRecord& outRecord) const {
-    auto it = m_PathToGuid.find(normalizePath(absolutePath));
-    if (it == m_PathToGuid.end()) {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    const uint32_t asset = findAssetAtPath(absolutePath);
+    if (asset == kNone) {
         return false;
     }
-    return getRecordForGuid(it->second, outRecord);
+    outRecord = toRecord(m_Assets[asset]);
+    return true;
 }
 
 bool AssetDatabase::updateModelImportSettings(const std::string& guid, const ModelImportSettings& settings) {
-    auto it = m_GuidToRecord.find(guid);
-    if (it == m_GuidToRecord.end()) {
-        return false;
-    }
-    it->second.modelSettings = settings;
-    std::string assetPath = getPathForGuid(guid);
-    if (assetPath.empty()) {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    const uint32_t asset = findAsset(AssetGuid::Parse(guid));
+    if (asset == kNone) {
         return false;
     }
-    if (!saveMeta(metaPathForAsset(assetPath), it->second)) {
+    StoredAsset& stored = m_Assets[asset];
+    stored.modelSettings = settings;
+    if (!saveMeta(metaPathForAsset(m_Paths[stored.pathId]), toRecord(stored))) {
         return false;
     }
-    recordImportForGuid(guid);
+    recordImportForGuid(stored.guid);
     return true;
 }
 
 bool AssetDatabase::updateTextureImportSettings(const std::string& guid, const TextureImportSettings& settings) {
-    auto it = m_GuidToRecord.find(guid);
-    if (it == m_GuidToRecord.end()) {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    const uint32_t asset = findAsset(AssetGuid::Parse(guid));
+    if (asset == kNone) {
         return false;
     }
-    it->second.textureSettings = settings;
-    std::string assetPath = getPathForGuid(guid);
-    if (assetPath.empty()) {
+    StoredAsset& stored = m_Assets[asset];
+    stored.textureSettings = settings;
+    if (!saveMeta(metaPathForAsset(m_Paths[stored.pathId]), toRecord(stored))) {
         return false;
     }
-    if (!saveMeta(metaPathForAsset(assetPath), it->second)) {
-        return false;
-    }
-    recordImportForGuid(guid);
+    recordImportForGuid(stored.guid);
     return true;
 }
 
 bool AssetDatabase::updateHdriImportSettings(const std::string& guid, const HdriImportSettings& settings) {
-    auto it = m_GuidToRecord.find(guid);
-    if (it == m_GuidToRecord.end()) {
-        return false;
-    }
-    it->second.hdriSettings = settings;
-    std::string assetPath = getPathForGuid(guid);
-    if (assetPath.empty()) {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    const uint32_t asset = findAsset(AssetGuid::Parse(guid));
+    if (asset == kNone) {
         return false;
     }
-    if (!saveMeta(metaPathForAsset(assetPath), it->second)) {
+    StoredAsset& stored = m_Assets[asset];
+    stored.hdriSettings = settings;
+    if (!saveMeta(metaPathForAsset(m_Paths[stored.pathId]), toRecord(stored))) {
         return false;
     }
-    recordImportForGuid(guid);
+    recordImportForGuid(stored.guid);
     return true;
 }
 
 bool AssetDatabase::recordImportForGuid(const std::string& guid) {
-    if (guid.empty() || m_LibraryPath.empty()) {
-        return false;
-    }
-    auto it = m_GuidToRecord.find(guid);
-    if (it == m_GuidToRecord.end()) {
+    return recordImportForGuid(AssetGuid::Parse(guid));
+}
+
+bool AssetDatabase::recordImportForGuid(const AssetGuid& guid) {
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    if (!guid.isValid() || m_LibraryPath.empty()) {
         return false;
     }
-    std::string sourcePath = getPathForGuid(guid);
-    if (sourcePath.empty()) {
+    const uint32_t asset = findAsset(guid);
+    if (asset == kNone) {
         return false;
     }
+    const StoredAsset& stored = m_Assets[asset];
     std::string cachePath = importCachePathForGuid(guid);
     if (cachePath.empty()) {
         return false;
     }
-    return saveImportCache(cachePath, it->second, sourcePath);
+    return saveImportCache(cachePath, toRecord(stored), m_Paths[stored.pathId]);
 }
 
 bool AssetDatabase::isAssetFile(const std::string& extension, std::string& outType) const {
@@ -589,17 +1215,17 @@ std::string AssetDatabase::metaPathForAsset(const std::string& absolutePath) con
     return absolutePath + ".cmeta";
 }
 
-std::string AssetDatabase::importCachePathForGuid(const std::string& guid) const {
-    if (m_LibraryPath.empty() || guid.empty()) {
+std::string AssetDatabase::importCachePathForGuid(const AssetGuid& guid) const {
+    if (m_LibraryPath.empty() || !guid.isValid()) {
         return "";
     }
-    return (std::filesystem::path(m_LibraryPath) / "ImportCache" / (guid + ".json")).string();
+    return (std::filesystem::path(m_LibraryPath) / "ImportCache" / (guid.toString() + ".json")).string();
 }
 
 bool AssetDatabase::saveImportCache(const std::string& cachePath,
                                     const AssetRecord& record,
                                     const std::string& sourcePath) const {
-    if (cachePath.empty() || record.guid.empty() || sourcePath.empty()) {
+    if (cachePath.empty() || !record.guid.isValid() || sourcePath.empty()) {
         return false;
     }
     std::error_code ec;
@@ -613,7 +1239,7 @@ bool AssetDatabase::saveImportCache(const std::string& cachePath,
 
     json cache;
     cache["version"] = kMetaVersion;
-    cache["guid"] = record.guid;
+    cache["guid"] = record.guid.toString();
     cache["type"] = record.type;
     cache["source"] = getRelativePath(sourcePath);
     cache["sourceTimestamp"] = timestamp;
@@ -648,9 +1274,8 @@ AssetRecord AssetDatabase::loadOrCreateRecord(const std::string& absolutePath, c
         loaded = loadMeta(metaPathForAsset(absolutePath), record, needsSave);
         dirty = needsSave;
     }
-    if (record.guid.empty()) {
-        UUID uuid;
-        record.guid = uuid.toString();
+    if (!record.guid.isValid()) {
+        record.guid = AssetGuid::Generate();
         dirty = true;
     }
     if (record.type.empty() && !type.empty()) {
@@ -680,7 +1305,11 @@ bool AssetDatabase::loadMeta(const std::string& metaPath, AssetRecord& outRecord
     if (version != kMetaVersion) {
         outNeedsSave = true;
     }
-    outRecord.guid = meta.value("guid", outRecord.guid);
+    // A guid that does not parse is treated as missing and replaced.
+    auto guid = meta.find("guid");
+    if (guid != meta.end() && guid->is_string()) {
+        outRecord.guid = AssetGuid::Parse(guid->get_ref<const std::string&>());
+    }
     outRecord.type = meta.value("type", outRecord.type);
     if (meta.contains("import") && meta["import"].is_object()) {
         const json& import = meta["import"];
@@ -709,7 +1338,7 @@ bool AssetDatabase::loadMeta(const std::string& metaPath, AssetRecord& outRecord
 }
 
 bool AssetDatabase::saveMeta(const std::string& metaPath, const AssetRecord& record) const {
-    if (metaPath.empty() || record.guid.empty()) {
+    if (metaPath.empty() || !record.guid.isValid()) {
         return false;
     }
     std::filesystem::path metaDir = std::filesystem::path(metaPath).parent_path();
@@ -718,7 +1347,7 @@ bool AssetDatabase::saveMeta(const std::string& metaPath, const AssetRecord& rec
 
     json meta;
     meta["version"] = kMetaVersion;
-    meta["guid"] = record.guid;
+    meta["guid"] = record.guid.toString();
     meta["type"] = record.type;
 
     json import;
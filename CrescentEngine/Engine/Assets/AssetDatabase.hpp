@@ -1,14 +1,20 @@
 #pragma once
 
+#include "AssetGuid.hpp"
 #include "AssetImportSettings.hpp"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 namespace Crescent {
 
 struct AssetRecord {
-    std::string guid;
+    AssetGuid guid;
     std::string relativePath;
     std::string type;
     ModelImportSettings modelSettings;
@@ -16,6 +22,15 @@ struct AssetRecord {
     HdriImportSettings hdriSettings;
 };
 
+class AssetWatcher;
+
+// Public calls lock the database, so texture streaming threads can look records up while the
+// engine thread applies file changes.
+//
+// Assets live in a flat array found through an open-addressing guid index, and every normalized
+// absolute path is interned once and named by its id, so resolving a scene's references hashes a
+// guid or looks a path up without building strings. The string overloads parse or spell the guid
+// at the boundary.
 class AssetDatabase {
 public:
     static AssetDatabase& getInstance();
@@ -25,24 +40,78 @@ public:
     void setLibraryPath(const std::string& path);
     const std::string& getLibraryPath() const { return m_LibraryPath; }
 
+    // Walks the root on several threads. Files whose size, timestamps and .cmeta are unchanged
+    // since the last scan come from Library/AssetIndex.bin instead of having their .cmeta parsed.
     void rescan();
+    // Brings the given files or directories up to date without walking the rest of the root.
+    void refreshPaths(const std::vector<std::string>& paths);
+    // Applies what the file watcher reported since the last call; cheap when nothing changed.
+    void processFileChanges();
 
     std::string registerAsset(const std::string& absolutePath, const std::string& type = "");
     std::string importAsset(const std::string& sourcePath, const std::string& type = "");
     std::string getGuidForPath(const std::string& absolutePath) const;
+    AssetGuid findGuidForPath(const std::string& absolutePath) const;
     std::string getPathForGuid(const std::string& guid) const;
+    std::string getPathForGuid(const AssetGuid& guid) const;
     std::string getRelativePath(const std::string& absolutePath) const;
     std::string resolvePath(const std::string& storedPath) const;
     bool moveAsset(const std::string& sourcePath, const std::string& targetPath, bool overwrite = false);
     bool getRecordForGuid(const std::string& guid, AssetRecord& outRecord) const;
+    bool getRecordForGuid(const AssetGuid& guid, AssetRecord& outRecord) const;
     bool getRecordForPath(const std::string& absolutePath, AssetRecord& outRecord) const;
     bool updateModelImportSettings(const std::string& guid, const ModelImportSettings& settings);
     bool updateTextureImportSettings(const std::string& guid, const TextureImportSettings& settings);
     bool updateHdriImportSettings(const std::string& guid, const HdriImportSettings& settings);
     bool recordImportForGuid(const std::string& guid);
+    bool recordImportForGuid(const AssetGuid& guid);
 
 private:
-    AssetDatabase() = default;
+    static constexpr uint32_t kNone = ~0u;
+
+    struct FileStamp {
+        uint64_t assetTime = 0;
+        uint64_t assetSize = 0;
+        uint64_t metaTime = 0; // 0 when the asset has no .cmeta yet
+
+        bool operator==(const FileStamp& other) const {
+            return assetTime == other.assetTime && assetSize == other.assetSize && metaTime == other.metaTime;
+        }
+    };
+
+    struct ScannedFile {
+        std::string absolutePath;
+        std::string type;
+        FileStamp stamp;
+    };
+
+    struct IndexEntry {
+        AssetRecord record;
+        FileStamp stamp;
+    };
+
+    // What the database keeps per asset. The relative path is derived from the interned absolute
+    // one when a record is handed out rather than stored twice.
+    struct StoredAsset {
+        AssetGuid guid;
+        uint32_t pathId = kNone;
+        std::string type;
+        ModelImportSettings modelSettings;
+        TextureImportSettings textureSettings;
+        HdriImportSettings hdriSettings;
+    };
+
+    // One per interned path: the guid registered there, if any, and the stamp it was read at. A
+    // path keeps its id until the root is rescanned, so ids stay valid across removals; it names
+    // the guid rather than an asset slot because released slots are reused.
+    struct PathEntry {
+        AssetGuid guid;
+        bool hasStamp = false;
+        FileStamp stamp;
+    };
+
+    AssetDatabase();
+    ~AssetDatabase();
     AssetDatabase(const AssetDatabase&) = delete;
     AssetDatabase& operator=(const AssetDatabase&) = delete;
 
@@ -50,17 +119,45 @@ private:
     bool isUnderRoot(const std::string& path) const;
     std::string normalizePath(const std::string& path) const;
     std::string metaPathForAsset(const std::string& absolutePath) const;
-    std::string importCachePathForGuid(const std::string& guid) const;
+    std::string importCachePathForGuid(const AssetGuid& guid) const;
     bool saveImportCache(const std::string& cachePath, const AssetRecord& record, const std::string& sourcePath) const;
     AssetRecord loadOrCreateRecord(const std::string& absolutePath, const std::string& type);
     bool loadMeta(const std::string& metaPath, AssetRecord& outRecord, bool& outNeedsSave) const;
     bool saveMeta(const std::string& metaPath, const AssetRecord& record) const;
     void clear();
+    void scanFiles(std::vector<ScannedFile>& outFiles) const;
+    bool statAsset(const std::string& absolutePath, FileStamp& outStamp) const;
+    bool refreshFile(const std::string& absolutePath);
+    bool removePath(const std::string& absolutePath);
+    std::string indexPath() const;
+    bool loadIndex(std::unordered_map<std::string, IndexEntry>& outEntries) const;
+    bool saveIndex() const;
+
+    uint32_t findPathId(const std::string& normalizedPath) const;
+    // The path's id, trying it as given before normalizing it: interned paths are normalized, so
+    // a caller passing one back skips weakly_canonical's filesystem calls.
+    uint32_t lookupPath(const std::string& absolutePath) const;
+    uint32_t internPath(const std::string& normalizedPath);
+    uint32_t findAsset(const AssetGuid& guid) const { return m_GuidIndex.find(guid); }
+    uint32_t findAssetAtPath(const std::string& absolutePath) const;
+    // Stores the record under its guid at the path. A different guid registered at the path
+    // before (its .cmeta was replaced) is dropped if that asset still lives there.
+    void storeAsset(AssetRecord&& record, uint32_t pathId);
+    void releaseAsset(uint32_t asset);
+    std::string relativePathFor(uint32_t pathId) const;
+    AssetRecord toRecord(const StoredAsset& asset) const;
 
     std::string m_RootPath;
     std::string m_LibraryPath;
-    std::unordered_map<std::string, AssetRecord> m_GuidToRecord;
-    std::unordered_map<std::string, std::string> m_PathToGuid;
+    std::vector<StoredAsset> m_Assets;
+    std::vector<uint32_t> m_FreeAssets;
+    AssetGuidIndex m_GuidIndex;
+    // Interned paths; a deque so the views keying m_PathIds survive growth.
+    std::deque<std::string> m_Paths;
+    std::unordered_map<std::string_view, uint32_t> m_PathIds;
+    std::vector<PathEntry> m_PathEntries;
+    std::unique_ptr<AssetWatcher> m_Watcher;
+    mutable std::recursive_mutex m_Mutex;
 };
 
 } // namespace Crescent
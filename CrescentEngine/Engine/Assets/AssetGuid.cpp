@@ -0,0 +1,134 @@
+#include "AssetGuid.hpp"
+#include "../Core/UUID.hpp"
+
+namespace Crescent {
+
+AssetGuid AssetGuid::Parse(std::string_view text) {
+    if (text.empty() || text.size() > 32) {
+        return {};
+    }
+    AssetGuid guid;
+    for (char c : text) {
+        uint64_t digit = 0;
+        if (c >= '0' && c <= '9') {
+            digit = static_cast<uint64_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            digit = static_cast<uint64_t>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            digit = static_cast<uint64_t>(c - 'A' + 10);
+        } else {
+            return {};
+        }
+        guid.high = (guid.high << 4) | (guid.low >> 60);
+        guid.low = (guid.low << 4) | digit;
+    }
+    return guid;
+}
+
+AssetGuid AssetGuid::Generate() {
+    AssetGuid guid;
+    guid.high = static_cast<uint64_t>(UUID());
+    guid.low = static_cast<uint64_t>(UUID());
+    if (guid.high == 0) {
+        guid.high = 1;
+    }
+    return guid;
+}
+
+std::string AssetGuid::toString() const {
+    static const char kDigits[] = "0123456789abcdef";
+    const size_t digits = high != 0 ? 32 : 16;
+    std::string text(digits, '0');
+    uint64_t lo = low;
+    uint64_t hi = high;
+    for (size_t i = digits; i-- > 0;) {
+        text[i] = kDigits[lo & 0xF];
+        lo = (lo >> 4) | (hi << 60);
+        hi >>= 4;
+    }
+    return text;
+}
+
+uint32_t AssetGuidIndex::find(const AssetGuid& guid) const {
+    if (m_Slots.empty() || !guid.isValid()) {
+        return kNotFound;
+    }
+    const size_t mask = m_Slots.size() - 1;
+    for (size_t i = AssetGuidHash()(guid) & mask;; i = (i + 1) & mask) {
+        const Slot& slot = m_Slots[i];
+        if (slot.guid == guid) {
+            return slot.value;
+        }
+        if (!slot.guid.isValid()) {
+            return kNotFound;
+        }
+    }
+}
+
+void AssetGuidIndex::insert(const AssetGuid& guid, uint32_t value) {
+    if (!guid.isValid()) {
+        return;
+    }
+    if ((m_Count + 1) * 4 > m_Slots.size() * 3) {
+        grow();
+    }
+    const size_t mask = m_Slots.size() - 1;
+    for (size_t i = AssetGuidHash()(guid) & mask;; i = (i + 1) & mask) {
+        Slot& slot = m_Slots[i];
+        if (slot.guid == guid) {
+            slot.value = value;
+            return;
+        }
+        if (!slot.guid.isValid()) {
+            slot.guid = guid;
+            slot.value = value;
+            ++m_Count;
+            return;
+        }
+    }
+}
+
+bool AssetGuidIndex::erase(const AssetGuid& guid) {
+    if (m_Slots.empty() || !guid.isValid()) {
+        return false;
+    }
+    const size_t mask = m_Slots.size() - 1;
+    size_t hole = AssetGuidHash()(guid) & mask;
+    while (!(m_Slots[hole].guid == guid)) {
+        if (!m_Slots[hole].guid.isValid()) {
+            return false;
+        }
+        hole = (hole + 1) & mask;
+    }
+    // Pull later members of the probe run back into the hole so finds never stop short of them.
+    for (size_t i = (hole + 1) & mask; m_Slots[i].guid.isValid(); i = (i + 1) & mask) {
+        const size_t home = AssetGuidHash()(m_Slots[i].guid) & mask;
+        const bool movable = hole <= i ? (home <= hole || home > i) : (home <= hole && home > i);
+        if (movable) {
+            m_Slots[hole] = m_Slots[i];
+            hole = i;
+        }
+    }
+    m_Slots[hole] = Slot{};
+    --m_Count;
+    return true;
+}
+
+void AssetGuidIndex::clear() {
+    m_Slots.clear();
+    m_Count = 0;
+}
+
+void AssetGuidIndex::grow() {
+    std::vector<Slot> old;
+    old.swap(m_Slots);
+    m_Slots.resize(old.empty() ? 64 : old.size() * 2);
+    m_Count = 0;
+    for (const Slot& slot : old) {
+        if (slot.guid.isValid()) {
+            insert(slot.guid, slot.value);
+        }
+    }
+}
+
+} // namespace Crescent
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Crescent {
+
+// 128-bit asset identifier as the .cmeta files spell it in hex. Guids written before the type
+// existed are 16 digits (a UUID) and keep that spelling: toString writes 16 digits while the high
+// half is zero, which Generate never leaves it.
+struct AssetGuid {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    bool isValid() const { return high != 0 || low != 0; }
+    // 1 to 32 hex digits; invalid for anything else, including the empty string.
+    static AssetGuid Parse(std::string_view text);
+    static AssetGuid Generate();
+    std::string toString() const;
+
+    bool operator==(const AssetGuid& other) const { return high == other.high && low == other.low; }
+    bool operator!=(const AssetGuid& other) const { return !(*this == other); }
+    bool operator<(const AssetGuid& other) const {
+        return high != other.high ? high < other.high : low < other.low;
+    }
+};
+
+struct AssetGuidHash {
+    size_t operator()(const AssetGuid& guid) const {
+        // The halves are random already; the multiply only spreads sequential test guids.
+        uint64_t h = (guid.high ^ (guid.low * 0x9E3779B97F4A7C15ull));
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+};
+
+// Open-addressing map from guid to a 32-bit value (linear probing, backward-shift erase), so a
+// lookup is one hash and a probe through a flat array. The invalid guid marks empty slots and
+// cannot be a key.
+class AssetGuidIndex {
+public:
+    static constexpr uint32_t kNotFound = ~0u;
+
+    uint32_t find(const AssetGuid& guid) const;
+    void insert(const AssetGuid& guid, uint32_t value);
+    bool erase(const AssetGuid& guid);
+    void clear();
+    size_t size() const { return m_Count; }
+
+private:
+    struct Slot {
+        AssetGuid guid;
+        uint32_t value = 0;
+    };
+
+    void grow();
+
+    std::vector<Slot> m_Slots; // power of two, at most 3/4 full
+    size_t m_Count = 0;
+};
+
+} // namespace Crescent
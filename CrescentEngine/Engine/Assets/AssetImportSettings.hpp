@@ -15,6 +15,7 @@ struct TextureImportSettings {
     bool flipY = false;
     int maxSize = 4096;
     bool normalMap = false;
+    int blockSize = 0; // ASTC footprint: 0 picks one from the texture's use, else 4, 6 or 8
 };
 
 struct HdriImportSettings {
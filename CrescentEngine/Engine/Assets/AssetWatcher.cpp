@@ -0,0 +1,120 @@
+#include "AssetWatcher.hpp"
+#include <CoreServices/CoreServices.h>
+#include <dispatch/dispatch.h>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    // Coalesces the burst of events one save or copy produces into a single batch.
+    constexpr CFTimeInterval kEventLatency = 0.25;
+
+    constexpr FSEventStreamEventFlags kRescanFlags =
+        kFSEventStreamEventFlagMustScanSubDirs |
+        kFSEventStreamEventFlagUserDropped |
+        kFSEventStreamEventFlagKernelDropped |
+        kFSEventStreamEventFlagRootChanged;
+
+    void OnStreamEvents(ConstFSEventStreamRef,
+                        void* info,
+                        size_t count,
+                        void* paths,
+                        const FSEventStreamEventFlags flags[],
+                        const FSEventStreamEventId[]) {
+        static_cast<AssetWatcher*>(info)->collect(count, static_cast<const char* const*>(paths), flags);
+    }
+}
+
+AssetWatcher::AssetWatcher()
+    : m_stream(nullptr)
+    , m_queue(nullptr)
+    , m_needsRescan(false) {
+}
+
+AssetWatcher::~AssetWatcher() {
+    stop();
+}
+
+bool AssetWatcher::start(const std::string& rootPath) {
+    stop();
+    if (rootPath.empty()) {
+        return false;
+    }
+    CFStringRef path = CFStringCreateWithCString(kCFAllocatorDefault, rootPath.c_str(), kCFStringEncodingUTF8);
+    if (!path) {
+        return false;
+    }
+    const void* values[] = { path };
+    CFArrayRef pathsToWatch = CFArrayCreate(kCFAllocatorDefault, values, 1, &kCFTypeArrayCallBacks);
+    CFRelease(path);
+
+    FSEventStreamContext context{};
+    context.info = this;
+    FSEventStreamRef stream = FSEventStreamCreate(kCFAllocatorDefault,
+                                                  &OnStreamEvents,
+                                                  &context,
+                                                  pathsToWatch,
+                                                  kFSEventStreamEventIdSinceNow,
+                                                  kEventLatency,
+                                                  kFSEventStreamCreateFlagFileEvents | kFSEventStreamCreateFlagWatchRoot);
+    CFRelease(pathsToWatch);
+    if (!stream) {
+        std::cerr << "AssetWatcher: failed to create event stream for " << rootPath << "\n";
+        return false;
+    }
+
+    dispatch_queue_t queue = dispatch_queue_create("com.crescent.assets.watcher", DISPATCH_QUEUE_SERIAL);
+    FSEventStreamSetDispatchQueue(stream, queue);
+    if (!FSEventStreamStart(stream)) {
+        std::cerr << "AssetWatcher: failed to start event stream for " << rootPath << "\n";
+        FSEventStreamInvalidate(stream);
+        FSEventStreamRelease(stream);
+        dispatch_release(queue);
+        return false;
+    }
+    m_stream = stream;
+    m_queue = queue;
+    return true;
+}
+
+void AssetWatcher::stop() {
+    if (m_stream) {
+        FSEventStreamRef stream = static_cast<FSEventStreamRef>(m_stream);
+        FSEventStreamStop(stream);
+        FSEventStreamInvalidate(stream);
+        FSEventStreamRelease(stream);
+        m_stream = nullptr;
+    }
+    if (m_queue) {
+        // Lets a batch already running on the queue finish before the watcher can go away.
+        dispatch_queue_t queue = static_cast<dispatch_queue_t>(m_queue);
+        dispatch_sync_f(queue, nullptr, [](void*) {});
+        dispatch_release(queue);
+        m_queue = nullptr;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_changes.clear();
+    m_needsRescan = false;
+}
+
+bool AssetWatcher::takeChanges(std::vector<std::string>& outPaths) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    outPaths.swap(m_changes);
+    m_changes.clear();
+    const bool needsRescan = m_needsRescan;
+    m_needsRescan = false;
+    return needsRescan;
+}
+
+void AssetWatcher::collect(size_t count, const char* const* paths, const uint32_t* flags) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < count; ++i) {
+        if (flags[i] & kRescanFlags) {
+            m_needsRescan = true;
+            continue;
+        }
+        m_changes.emplace_back(paths[i]);
+    }
+}
+
+} // namespace Crescent
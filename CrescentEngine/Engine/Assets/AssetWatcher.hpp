@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Crescent {
+
+// Watches an asset root through FSEvents and collects the paths that changed under it. Events
+// arrive on the watcher's own queue; the database drains them from its own thread, so nothing
+// here touches AssetDatabase state.
+class AssetWatcher {
+public:
+    AssetWatcher();
+    ~AssetWatcher();
+
+    bool start(const std::string& rootPath);
+    void stop();
+    bool isRunning() const { return m_stream != nullptr; }
+
+    // Moves the collected paths into outPaths. Returns true when FSEvents could not say what
+    // changed (dropped events, a moved root), in which case the whole root needs a rescan.
+    bool takeChanges(std::vector<std::string>& outPaths);
+
+    // Called on the watcher's queue with one FSEvents batch.
+    void collect(size_t count, const char* const* paths, const uint32_t* flags);
+
+private:
+    // FSEventStreamRef and dispatch_queue_t, kept opaque so CoreServices stays out of the header.
+    void* m_stream;
+    void* m_queue;
+    std::mutex m_mutex;
+    std::vector<std::string> m_changes;
+    bool m_needsRescan;
+};
+
+} // namespace Crescent
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../Math/Vector3.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+struct ma_sound;
+
+namespace Crescent {
+
+enum class AudioCommandType : uint8_t {
+    Listener,
+    EmitterPose,
+    EmitterParams,
+    EmitterStart,
+    EmitterStop
+};
+
+// One change for the mixer. Listener commands use the position, velocity, forward and up; emitter
+// commands address their sound and use the fields of their type.
+struct AudioCommand {
+    AudioCommandType type = AudioCommandType::Listener;
+    bool looping = false;
+    bool spatial = false;
+    ma_sound* sound = nullptr;
+    Math::Vector3 position;
+    Math::Vector3 velocity;
+    Math::Vector3 forward;
+    Math::Vector3 up;
+    float volume = 1.0f;
+    float pitch = 1.0f;
+    float minDistance = 1.0f;
+    float maxDistance = 1.0f;
+    float rolloff = 1.0f;
+    // Where an EmitterStart resumes, in frames of the sound.
+    uint64_t frame = 0;
+};
+
+// Single-producer single-consumer ring from the game side to the audio thread: the frame's audio
+// task pushes, the mixer drains between periods. Pushing never blocks or allocates; a full ring
+// refuses the command and the producer retries on a later frame.
+class AudioCommandQueue {
+public:
+    static constexpr uint32_t kCapacity = 1024;
+
+    uint32_t freeSlots() const {
+        return kCapacity - (m_Write.load(std::memory_order_relaxed) - m_Read.load(std::memory_order_acquire));
+    }
+    bool empty() const {
+        return m_Read.load(std::memory_order_acquire) == m_Write.load(std::memory_order_acquire);
+    }
+
+    bool push(const AudioCommand& command) {
+        if (freeSlots() == 0) {
+            return false;
+        }
+        const uint32_t write = m_Write.load(std::memory_order_relaxed);
+        m_Slots[write % kCapacity] = command;
+        m_Write.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side: a ticket for everything pushed so far, consumed once the audio thread has
+    // applied all of it.
+    uint32_t ticket() const { return m_Write.load(std::memory_order_relaxed); }
+    bool isConsumed(uint32_t ticket) const {
+        return static_cast<int32_t>(m_Read.load(std::memory_order_acquire) - ticket) >= 0;
+    }
+
+    // Consumer side.
+    template <typename Fn>
+    void drain(Fn&& apply) {
+        uint32_t read = m_Read.load(std::memory_order_relaxed);
+        const uint32_t write = m_Write.load(std::memory_order_acquire);
+        for (; read != write; ++read) {
+            apply(m_Slots[read % kCapacity]);
+        }
+        m_Read.store(read, std::memory_order_release);
+    }
+
+    // Only while neither side is running.
+    void reset() {
+        m_Write.store(0, std::memory_order_relaxed);
+        m_Read.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<AudioCommand, kCapacity> m_Slots;
+    std::atomic<uint32_t> m_Write{0};
+    std::atomic<uint32_t> m_Read{0};
+};
+
+} // namespace Crescent
@@ -1,15 +1,54 @@
 #include "AudioSystem.hpp"
+#include "../Components/AudioSource.hpp"
 #include "../Components/Camera.hpp"
 #include "../ECS/Entity.hpp"
 #include "../ECS/Transform.hpp"
+#include "../Project/Project.hpp"
 #include <algorithm>
 #include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <thread>
 
 #define MINIAUDIO_IMPLEMENTATION
 #include "../../../ThirdParty/miniaudio/miniaudio.h"
 
 namespace Crescent {
+namespace {
+
+// A source keeps its mixer voice until it is this much quieter than the sources replacing it, so
+// emitters near the cut do not flip every frame.
+constexpr float kRealVoiceHysteresis = 2.0f;
+// The most commands one emitter queues in a frame: parameters, pose and a start or stop.
+constexpr uint32_t kMaxEmitterCommands = 3;
+// The device and every decoded page run at this rate, so decoded pages need no resampling in the
+// mixer.
+constexpr ma_uint32 kMixSampleRate = 48000;
+
+// miniaudio's heap (decoded pages, decoders, the node graph), counted under MemoryCategory::Audio.
+void* AudioAllocate(size_t size, void* /*userData*/) {
+    return MemoryTracker::allocate(MemoryCategory::Audio, size);
+}
+
+void* AudioReallocate(void* block, size_t size, void* /*userData*/) {
+    return MemoryTracker::reallocate(MemoryCategory::Audio, block, size);
+}
+
+void AudioFree(void* block, void* /*userData*/) {
+    MemoryTracker::release(MemoryCategory::Audio, block);
+}
+
+ma_allocation_callbacks TrackedAllocationCallbacks() {
+    ma_allocation_callbacks callbacks{};
+    callbacks.onMalloc = AudioAllocate;
+    callbacks.onRealloc = AudioReallocate;
+    callbacks.onFree = AudioFree;
+    return callbacks;
+}
+
+} // namespace
 
 const char* AudioSystem::audioBusToString(AudioBus bus) {
     switch (bus) {
@@ -36,33 +75,291 @@ AudioBus AudioSystem::audioBusFromString(const std::string& value) {
     return AudioBus::SFX;
 }
 
+const char* AudioSystem::audioLoadModeToString(AudioLoadMode mode) {
+    switch (mode) {
+        case AudioLoadMode::Decoded: return "Decoded";
+        case AudioLoadMode::Streaming: return "Streaming";
+        case AudioLoadMode::Compressed: return "Compressed";
+    }
+    return "Decoded";
+}
+
+AudioLoadMode AudioSystem::audioLoadModeFromString(const std::string& value) {
+    std::string lower = value;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    if (lower == "streaming" || lower == "stream") return AudioLoadMode::Streaming;
+    if (lower == "compressed") return AudioLoadMode::Compressed;
+    return AudioLoadMode::Decoded;
+}
+
+struct AudioSystem::ResidentVFS {
+    // First, as miniaudio calls through the ma_vfs pointer.
+    ma_vfs_callbacks callbacks;
+    ma_default_vfs disk;
+    AudioSystem* owner = nullptr;
+
+    // A resident file is read in place; anything else is a disk file.
+    struct File {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        size_t cursor = 0;
+        ma_vfs_file disk = nullptr;
+    };
+
+    static ResidentVFS* self(ma_vfs* vfs) { return static_cast<ResidentVFS*>(vfs); }
+
+    static ma_result open(ma_vfs* vfs, const char* path, ma_uint32 openMode, ma_vfs_file* outFile) {
+        ResidentVFS* fs = self(vfs);
+        File* file = new File();
+        if ((openMode & MA_OPEN_MODE_WRITE) == 0) {
+            std::lock_guard<std::mutex> lock(fs->owner->m_ResidentMutex);
+            auto it = fs->owner->m_ResidentFiles.find(path);
+            if (it != fs->owner->m_ResidentFiles.end()) {
+                // The bytes stay put until the last release, which follows the sound's uninit.
+                file->data = it->second.bytes.data();
+                file->size = it->second.bytes.size();
+            }
+        }
+        if (!file->data) {
+            ma_result result = ma_vfs_open(&fs->disk, path, openMode, &file->disk);
+            if (result != MA_SUCCESS) {
+                delete file;
+                return result;
+            }
+        }
+        *outFile = file;
+        return MA_SUCCESS;
+    }
+
+    static ma_result openW(ma_vfs* vfs, const wchar_t* path, ma_uint32 openMode, ma_vfs_file* outFile) {
+        File* file = new File();
+        ma_result result = ma_vfs_open_w(&self(vfs)->disk, path, openMode, &file->disk);
+        if (result != MA_SUCCESS) {
+            delete file;
+            return result;
+        }
+        *outFile = file;
+        return MA_SUCCESS;
+    }
+
+    static ma_result close(ma_vfs* vfs, ma_vfs_file handle) {
+        File* file = static_cast<File*>(handle);
+        ma_result result = file->disk ? ma_vfs_close(&self(vfs)->disk, file->disk) : MA_SUCCESS;
+        delete file;
+        return result;
+    }
+
+    static ma_result read(ma_vfs* vfs, ma_vfs_file handle, void* dst, size_t sizeInBytes, size_t* bytesRead) {
+        File* file = static_cast<File*>(handle);
+        if (file->disk) {
+            return ma_vfs_read(&self(vfs)->disk, file->disk, dst, sizeInBytes, bytesRead);
+        }
+        const size_t count = std::min(sizeInBytes, file->size - file->cursor);
+        std::memcpy(dst, file->data + file->cursor, count);
+        file->cursor += count;
+        if (bytesRead) {
+            *bytesRead = count;
+        }
+        return count == 0 && sizeInBytes > 0 ? MA_AT_END : MA_SUCCESS;
+    }
+
+    static ma_result write(ma_vfs* vfs, ma_vfs_file handle, const void* src, size_t sizeInBytes, size_t* bytesWritten) {
+        File* file = static_cast<File*>(handle);
+        if (file->disk) {
+            return ma_vfs_write(&self(vfs)->disk, file->disk, src, sizeInBytes, bytesWritten);
+        }
+        return MA_ACCESS_DENIED;
+    }
+
+    static ma_result seek(ma_vfs* vfs, ma_vfs_file handle, ma_int64 offset, ma_seek_origin origin) {
+        File* file = static_cast<File*>(handle);
+        if (file->disk) {
+            return ma_vfs_seek(&self(vfs)->disk, file->disk, offset, origin);
+        }
+        ma_int64 base = 0;
+        if (origin == ma_seek_origin_current) {
+            base = static_cast<ma_int64>(file->cursor);
+        } else if (origin == ma_seek_origin_end) {
+            base = static_cast<ma_int64>(file->size);
+        }
+        const ma_int64 target = base + offset;
+        if (target < 0 || target > static_cast<ma_int64>(file->size)) {
+            return MA_BAD_SEEK;
+        }
+        file->cursor = static_cast<size_t>(target);
+        return MA_SUCCESS;
+    }
+
+    static ma_result tell(ma_vfs* vfs, ma_vfs_file handle, ma_int64* cursor) {
+        File* file = static_cast<File*>(handle);
+        if (file->disk) {
+            return ma_vfs_tell(&self(vfs)->disk, file->disk, cursor);
+        }
+        *cursor = static_cast<ma_int64>(file->cursor);
+        return MA_SUCCESS;
+    }
+
+    static ma_result info(ma_vfs* vfs, ma_vfs_file handle, ma_file_info* outInfo) {
+        File* file = static_cast<File*>(handle);
+        if (file->disk) {
+            return ma_vfs_info(&self(vfs)->disk, file->disk, outInfo);
+        }
+        outInfo->sizeInBytes = file->size;
+        return MA_SUCCESS;
+    }
+};
+
 AudioSystem& AudioSystem::getInstance() {
     static AudioSystem instance;
     return instance;
 }
 
-void AudioSystem::cleanupFinishedOneShots() {
-    if (m_ActiveOneShots.empty()) {
+void AudioSystem::onVoiceEnd(void* userData, ma_sound* sound) {
+    // Audio thread.
+    AudioSystem* audio = static_cast<AudioSystem*>(userData);
+    const uint32_t index = static_cast<uint32_t>(sound - audio->m_VoiceSounds);
+    const uint32_t write = audio->m_FinishedWrite.load(std::memory_order_relaxed);
+    if (write - audio->m_FinishedRead.load(std::memory_order_acquire) >= kMaxVoices) {
         return;
     }
+    audio->m_FinishedVoices[write % kMaxVoices].store(index, std::memory_order_relaxed);
+    audio->m_FinishedWrite.store(write + 1, std::memory_order_release);
+}
 
-    auto it = m_ActiveOneShots.begin();
-    while (it != m_ActiveOneShots.end()) {
-        ma_sound* sound = *it;
-        if (!sound) {
-            it = m_ActiveOneShots.erase(it);
-            continue;
+void AudioSystem::onEngineProcess(void* userData, float*, unsigned long long) {
+    // Audio thread, after each mix.
+    AudioSystem* audio = static_cast<AudioSystem*>(userData);
+    audio->m_Commands.drain([audio](const AudioCommand& command) { audio->applyCommand(command); });
+}
+
+void AudioSystem::applyCommand(const AudioCommand& command) {
+    ma_sound* sound = command.sound;
+    switch (command.type) {
+        case AudioCommandType::Listener:
+            ma_engine_listener_set_position(m_Engine, 0, command.position.x, command.position.y, command.position.z);
+            ma_engine_listener_set_velocity(m_Engine, 0, command.velocity.x, command.velocity.y, command.velocity.z);
+            ma_engine_listener_set_direction(m_Engine, 0, command.forward.x, command.forward.y, command.forward.z);
+            ma_engine_listener_set_world_up(m_Engine, 0, command.up.x, command.up.y, command.up.z);
+            break;
+        case AudioCommandType::EmitterPose:
+            ma_sound_set_position(sound, command.position.x, command.position.y, command.position.z);
+            ma_sound_set_velocity(sound, command.velocity.x, command.velocity.y, command.velocity.z);
+            break;
+        case AudioCommandType::EmitterParams:
+            ma_sound_set_volume(sound, command.volume);
+            ma_sound_set_pitch(sound, command.pitch);
+            ma_sound_set_looping(sound, command.looping ? MA_TRUE : MA_FALSE);
+            ma_sound_set_spatialization_enabled(sound, command.spatial ? MA_TRUE : MA_FALSE);
+            ma_sound_set_attenuation_model(sound, command.spatial ? ma_attenuation_model_inverse : ma_attenuation_model_none);
+            ma_sound_set_min_distance(sound, command.minDistance);
+            ma_sound_set_max_distance(sound, command.maxDistance);
+            ma_sound_set_rolloff(sound, command.rolloff);
+            break;
+        case AudioCommandType::EmitterStart:
+            // Restarts a playing sound at the frame as well.
+            ma_sound_seek_to_pcm_frame(sound, command.frame);
+            ma_sound_start(sound);
+            break;
+        case AudioCommandType::EmitterStop:
+            ma_sound_stop(sound);
+            break;
+    }
+}
+
+void AudioSystem::flushCommands(uint32_t ticket) {
+    if (m_Commands.isConsumed(ticket)) {
+        return;
+    }
+    ma_device* device = m_Engine ? ma_engine_get_device(m_Engine) : nullptr;
+    if (device && ma_device_is_started(device) == MA_TRUE) {
+        // At most one period.
+        while (!m_Commands.isConsumed(ticket)) {
+            std::this_thread::yield();
         }
+        return;
+    }
+    // Nothing mixes, so nothing else drains.
+    m_Commands.drain([this](const AudioCommand& command) { applyCommand(command); });
+}
 
-        if (ma_sound_is_playing(sound) == MA_TRUE) {
-            ++it;
-            continue;
+void AudioSystem::recycleFinishedVoices() {
+    uint32_t read = m_FinishedRead.load(std::memory_order_relaxed);
+    const uint32_t write = m_FinishedWrite.load(std::memory_order_acquire);
+    for (; read != write; ++read) {
+        const uint32_t index = m_FinishedVoices[read % kMaxVoices].load(std::memory_order_relaxed);
+        Voice& voice = m_Voices[index];
+        // A voice stolen after it ended is playing again and stays taken.
+        if (voice.active && ma_sound_at_end(&m_VoiceSounds[index]) == MA_TRUE) {
+            voice.active = false;
+            m_FreeVoices.push_back(index);
+        }
+    }
+    m_FinishedRead.store(read, std::memory_order_release);
+}
+
+void AudioSystem::releaseVoices() {
+    if (m_VoiceSounds) {
+        for (size_t i = 0; i < m_Voices.size(); ++i) {
+            if (m_Voices[i].clip != kInvalidAudioClip) {
+                ma_sound_uninit(&m_VoiceSounds[i]);
+            }
         }
+        delete[] m_VoiceSounds;
+        m_VoiceSounds = nullptr;
+    }
+    m_Voices.clear();
+    m_FreeVoices.clear();
+    m_FinishedWrite.store(0, std::memory_order_relaxed);
+    m_FinishedRead.store(0, std::memory_order_relaxed);
+}
+
+bool AudioSystem::initResourceManager() {
+    m_VFS = new ResidentVFS();
+    m_VFS->callbacks.onOpen = &ResidentVFS::open;
+    m_VFS->callbacks.onOpenW = &ResidentVFS::openW;
+    m_VFS->callbacks.onClose = &ResidentVFS::close;
+    m_VFS->callbacks.onRead = &ResidentVFS::read;
+    m_VFS->callbacks.onWrite = &ResidentVFS::write;
+    m_VFS->callbacks.onSeek = &ResidentVFS::seek;
+    m_VFS->callbacks.onTell = &ResidentVFS::tell;
+    m_VFS->callbacks.onInfo = &ResidentVFS::info;
+    ma_default_vfs_init(&m_VFS->disk, nullptr);
+    m_VFS->owner = this;
 
-        ma_sound_uninit(sound);
-        delete sound;
-        it = m_ActiveOneShots.erase(it);
+    // What ma_engine would set up itself, with a pool of decoder threads instead of one.
+    ma_resource_manager_config config = ma_resource_manager_config_init();
+    config.decodedFormat = ma_format_f32;
+    config.decodedChannels = 0;
+    config.decodedSampleRate = kMixSampleRate;
+    config.jobThreadCount = kDecoderThreads;
+    config.pVFS = m_VFS;
+    config.allocationCallbacks = TrackedAllocationCallbacks();
+
+    m_ResourceManager = new ma_resource_manager();
+    ma_result result = ma_resource_manager_init(&config, m_ResourceManager);
+    if (result != MA_SUCCESS) {
+        std::cerr << "Failed to initialize audio resource manager (" << result << ")" << std::endl;
+        delete m_ResourceManager;
+        m_ResourceManager = nullptr;
+        delete m_VFS;
+        m_VFS = nullptr;
+        return false;
     }
+    return true;
+}
+
+void AudioSystem::releaseResourceManager() {
+    if (m_ResourceManager) {
+        ma_resource_manager_uninit(m_ResourceManager);
+        delete m_ResourceManager;
+        m_ResourceManager = nullptr;
+    }
+    delete m_VFS;
+    m_VFS = nullptr;
+    std::lock_guard<std::mutex> lock(m_ResidentMutex);
+    m_ResidentFiles.clear();
 }
 
 bool AudioSystem::initialize() {
@@ -70,18 +367,28 @@ bool AudioSystem::initialize() {
         return true;
     }
 
+    if (!initResourceManager()) {
+        return false;
+    }
+
     if (!m_Engine) {
         m_Engine = new ma_engine();
     }
 
     ma_engine_config config = ma_engine_config_init();
     config.listenerCount = 1;
+    config.sampleRate = kMixSampleRate;
+    config.pResourceManager = m_ResourceManager;
+    config.allocationCallbacks = TrackedAllocationCallbacks();
+    config.onProcess = &AudioSystem::onEngineProcess;
+    config.pProcessUserData = this;
 
     ma_result result = ma_engine_init(&config, m_Engine);
     if (result != MA_SUCCESS) {
         std::cerr << "Failed to initialize audio engine (" << result << ")" << std::endl;
         delete m_Engine;
         m_Engine = nullptr;
+        releaseResourceManager();
         return false;
     }
 
@@ -116,9 +423,17 @@ bool AudioSystem::initialize() {
         ma_engine_uninit(m_Engine);
         delete m_Engine;
         m_Engine = nullptr;
+        releaseResourceManager();
         return false;
     }
 
+    m_VoiceSounds = new ma_sound[kMaxVoices]();
+    m_Voices.assign(kMaxVoices, Voice{});
+    m_FreeVoices.reserve(kMaxVoices);
+    for (uint32_t i = kMaxVoices; i > 0; --i) {
+        m_FreeVoices.push_back(i - 1);
+    }
+
     m_Initialized = true;
     return true;
 }
@@ -128,14 +443,15 @@ void AudioSystem::shutdown() {
         return;
     }
 
-    for (ma_sound* sound : m_ActiveOneShots) {
-        if (!sound) {
-            continue;
-        }
-        ma_sound_uninit(sound);
-        delete sound;
+    for (AudioSource* source : m_Emitters) {
+        source->m_EmitterIndex = AudioSource::kNoEmitterIndex;
     }
-    m_ActiveOneShots.clear();
+    m_Emitters.clear();
+    m_HasUpdateTime = false;
+    m_HasListenerPosition = false;
+    // Voices are copies of the clip sources, so they go first.
+    releaseVoices();
+    releaseClipSources();
 
     if (m_UIGroup) { ma_sound_group_uninit(m_UIGroup); delete m_UIGroup; m_UIGroup = nullptr; }
     if (m_AmbienceGroup) { ma_sound_group_uninit(m_AmbienceGroup); delete m_AmbienceGroup; m_AmbienceGroup = nullptr; }
@@ -149,6 +465,9 @@ void AudioSystem::shutdown() {
         delete m_Engine;
         m_Engine = nullptr;
     }
+    // After the engine, which does not own it.
+    releaseResourceManager();
+    m_Commands.reset();
 
     m_Initialized = false;
 }
@@ -160,25 +479,32 @@ void AudioSystem::updateListener(const Math::Vector3& position,
         return;
     }
 
-    cleanupFinishedOneShots();
+    recycleFinishedVoices();
+    const float deltaTime = advanceClock();
 
-    ma_engine_listener_set_position(m_Engine, 0, position.x, position.y, position.z);
-    ma_engine_listener_set_direction(m_Engine, 0, forward.x, forward.y, forward.z);
-    ma_engine_listener_set_world_up(m_Engine, 0, up.x, up.y, up.z);
+    AudioCommand command;
+    command.type = AudioCommandType::Listener;
+    command.position = position;
+    command.forward = forward;
+    command.up = up;
+    if (m_HasListenerPosition && deltaTime > 0.0f) {
+        command.velocity = (position - m_ListenerPosition) / deltaTime;
+    }
+    // A full ring drops the pose; the next frame sends a newer one.
+    m_Commands.push(command);
+    m_ListenerPosition = position;
+    m_HasListenerPosition = true;
+    updateEmitters(deltaTime);
 }
 
 void AudioSystem::updateListenerFromCamera(const Camera* camera) {
-    if (!camera) {
-        return;
-    }
-
-    const Entity* entity = camera->getEntity();
-    if (!entity) {
-        return;
-    }
-
-    const Transform* transform = entity->getTransform();
+    const Entity* entity = camera ? camera->getEntity() : nullptr;
+    const Transform* transform = entity ? entity->getTransform() : nullptr;
     if (!transform) {
+        // Emitters still play and virtualize around the last listener position.
+        if (m_Initialized) {
+            updateEmitters(advanceClock());
+        }
         return;
     }
 
@@ -216,31 +542,175 @@ float AudioSystem::getBusVolume(AudioBus bus) const {
     return 0.0f;
 }
 
-bool AudioSystem::playOneShot(const std::string& filePath,
-                              float volume,
-                              float pitch) {
-    return playOneShot(filePath, AudioBus::SFX, volume, pitch);
+AudioClipHandle AudioSystem::loadClip(const std::string& filePath) {
+    if (filePath.empty()) {
+        return kInvalidAudioClip;
+    }
+    auto it = m_ClipLookup.find(filePath);
+    if (it != m_ClipLookup.end()) {
+        return it->second;
+    }
+    ClipSource clip;
+    clip.path = filePath;
+    m_Clips.push_back(std::move(clip));
+    const AudioClipHandle handle = static_cast<AudioClipHandle>(m_Clips.size());
+    m_ClipLookup.emplace(filePath, handle);
+    return handle;
 }
 
-bool AudioSystem::playOneShot(const std::string& filePath,
-                              AudioBus bus,
-                              float volume,
-                              float pitch) {
-    if (!m_Initialized || !m_Engine || filePath.empty()) {
-        return false;
+bool AudioSystem::retainCompressedFile(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(m_ResidentMutex);
+    auto it = m_ResidentFiles.find(filePath);
+    if (it == m_ResidentFiles.end()) {
+        std::ifstream stream(filePath, std::ios::binary | std::ios::ate);
+        if (!stream) {
+            std::cerr << "Failed to read compressed audio " << filePath << std::endl;
+            return false;
+        }
+        ResidentFile file;
+        file.bytes.resize(static_cast<size_t>(stream.tellg()));
+        stream.seekg(0);
+        if (!stream.read(reinterpret_cast<char*>(file.bytes.data()), static_cast<std::streamsize>(file.bytes.size()))) {
+            std::cerr << "Failed to read compressed audio " << filePath << std::endl;
+            return false;
+        }
+        file.memory.reset(MemoryCategory::Audio, file.bytes.size());
+        it = m_ResidentFiles.emplace(filePath, std::move(file)).first;
     }
+    ++it->second.references;
+    return true;
+}
 
-    cleanupFinishedOneShots();
+void AudioSystem::releaseCompressedFile(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(m_ResidentMutex);
+    auto it = m_ResidentFiles.find(filePath);
+    if (it != m_ResidentFiles.end() && --it->second.references == 0) {
+        m_ResidentFiles.erase(it);
+    }
+}
 
-    ma_sound* sound = new ma_sound();
-    ma_result result = ma_sound_init_from_file(m_Engine,
-                                               filePath.c_str(),
-                                               MA_SOUND_FLAG_DECODE,
-                                               getBusGroup(bus),
-                                               nullptr,
-                                               sound);
-    if (result != MA_SUCCESS) {
-        delete sound;
+void AudioSystem::releaseClipSources() {
+    for (ClipSource& clip : m_Clips) {
+        if (clip.source) {
+            ma_sound_uninit(clip.source);
+            delete clip.source;
+            clip.source = nullptr;
+        }
+        clip.failed = false;
+    }
+}
+
+bool AudioSystem::preloadClip(AudioClipHandle clip) {
+    return ensureClipSource(clip) != nullptr;
+}
+
+ma_sound* AudioSystem::ensureClipSource(AudioClipHandle clip) {
+    if (!m_Initialized || !m_Engine || clip == kInvalidAudioClip || clip > m_Clips.size()) {
+        return nullptr;
+    }
+
+    ClipSource& source = m_Clips[clip - 1];
+    if (!source.source) {
+        // A file that failed to load is not retried until the next initialize.
+        if (source.failed) {
+            return nullptr;
+        }
+        source.source = new ma_sound();
+        ma_result result = ma_sound_init_from_file(m_Engine,
+                                                   source.path.c_str(),
+                                                   MA_SOUND_FLAG_DECODE,
+                                                   nullptr,
+                                                   nullptr,
+                                                   source.source);
+        if (result != MA_SUCCESS) {
+            std::cerr << "Failed to load audio clip " << source.path << " (" << result << ")" << std::endl;
+            delete source.source;
+            source.source = nullptr;
+            source.failed = true;
+            return nullptr;
+        }
+    }
+    return source.source;
+}
+
+ma_sound* AudioSystem::acquireVoice(AudioClipHandle clip, AudioBus bus, int priority, float audibility) {
+    ma_sound* source = ensureClipSource(clip);
+    if (!source || m_Voices.empty()) {
+        return nullptr;
+    }
+
+    recycleFinishedVoices();
+
+    uint32_t index = 0;
+    if (!m_FreeVoices.empty()) {
+        index = m_FreeVoices.back();
+        m_FreeVoices.pop_back();
+    } else {
+        uint32_t victim = 0;
+        for (uint32_t i = 1; i < m_Voices.size(); ++i) {
+            const Voice& candidate = m_Voices[i];
+            const Voice& current = m_Voices[victim];
+            if (candidate.priority < current.priority ||
+                (candidate.priority == current.priority && candidate.audibility < current.audibility)) {
+                victim = i;
+            }
+        }
+        const Voice& stolen = m_Voices[victim];
+        if (stolen.priority > priority || (stolen.priority == priority && stolen.audibility > audibility)) {
+            return nullptr;
+        }
+        ma_sound_stop(&m_VoiceSounds[victim]);
+        index = victim;
+    }
+
+    Voice& voice = m_Voices[index];
+    ma_sound* sound = &m_VoiceSounds[index];
+    if (voice.clip == clip && voice.bus == bus) {
+        ma_sound_seek_to_pcm_frame(sound, 0);
+    } else {
+        if (voice.clip != kInvalidAudioClip) {
+            ma_sound_uninit(sound);
+            voice.clip = kInvalidAudioClip;
+        }
+        // Copies share the decoded data of the resident source.
+        ma_result result = ma_sound_init_copy(m_Engine, source, 0, getBusGroup(bus), sound);
+        if (result != MA_SUCCESS) {
+            voice.active = false;
+            m_FreeVoices.push_back(index);
+            return nullptr;
+        }
+        ma_sound_set_end_callback(sound, &AudioSystem::onVoiceEnd, this);
+        voice.clip = clip;
+        voice.bus = bus;
+    }
+    voice.priority = priority;
+    voice.audibility = audibility;
+    voice.active = true;
+    return sound;
+}
+
+void AudioSystem::releaseVoice(ma_sound* sound) {
+    const uint32_t index = static_cast<uint32_t>(sound - m_VoiceSounds);
+    if (m_Voices[index].active) {
+        m_Voices[index].active = false;
+        m_FreeVoices.push_back(index);
+    }
+}
+
+float AudioSystem::estimateAudibility(const Math::Vector3& position, float volume, float minDistance,
+                                      float maxDistance, float rolloff) const {
+    const float nearDistance = std::max(0.01f, minDistance);
+    const float range = (position - m_ListenerPosition).length();
+    if (range > std::max(nearDistance, maxDistance)) {
+        return 0.0f;
+    }
+    const float distance = std::max(range, nearDistance);
+    const float gain = nearDistance / (nearDistance + std::max(0.0f, rolloff) * (distance - nearDistance));
+    return std::max(0.0f, volume) * gain;
+}
+
+bool AudioSystem::start2D(ma_sound* sound, float volume, float pitch) {
+    if (!sound) {
         return false;
     }
 
@@ -248,73 +718,140 @@ bool AudioSystem::playOneShot(const std::string& filePath,
     ma_sound_set_volume(sound, std::max(0.0f, volume));
     ma_sound_set_pitch(sound, std::max(0.01f, pitch));
 
-    result = ma_sound_start(sound);
+    ma_result result = ma_sound_start(sound);
     if (result != MA_SUCCESS) {
-        ma_sound_uninit(sound);
-        delete sound;
+        releaseVoice(sound);
         return false;
     }
-
-    m_ActiveOneShots.push_back(sound);
     return true;
 }
 
-bool AudioSystem::playOneShot3D(const std::string& filePath,
-                                const Math::Vector3& position,
-                                float volume,
-                                float pitch,
-                                float minDistance,
-                                float maxDistance,
-                                float rolloff) {
-    return playOneShot3D(filePath, position, AudioBus::SFX, volume, pitch, minDistance, maxDistance, rolloff);
-}
-
-bool AudioSystem::playOneShot3D(const std::string& filePath,
-                                const Math::Vector3& position,
-                                AudioBus bus,
-                                float volume,
-                                float pitch,
-                                float minDistance,
-                                float maxDistance,
-                                float rolloff) {
-    if (!m_Initialized || !m_Engine || filePath.empty()) {
+bool AudioSystem::start3D(ma_sound* sound,
+                          const Math::Vector3& position,
+                          float volume,
+                          float pitch,
+                          float minDistance,
+                          float maxDistance,
+                          float rolloff) {
+    if (!sound) {
         return false;
     }
 
-    cleanupFinishedOneShots();
+    ma_sound_set_spatialization_enabled(sound, MA_TRUE);
+    ma_sound_set_attenuation_model(sound, ma_attenuation_model_inverse);
+    ma_sound_set_position(sound, position.x, position.y, position.z);
+    // The voice may have played a directional sound before.
+    ma_sound_set_cone(sound, 6.283185f, 6.283185f, 1.0f);
+    ma_sound_set_min_distance(sound, std::max(0.01f, minDistance));
+    ma_sound_set_max_distance(sound, std::max(minDistance, maxDistance));
+    ma_sound_set_rolloff(sound, std::max(0.0f, rolloff));
+    ma_sound_set_volume(sound, std::max(0.0f, volume));
+    ma_sound_set_pitch(sound, std::max(0.01f, pitch));
 
-    ma_sound* sound = new ma_sound();
-    ma_result result = ma_sound_init_from_file(m_Engine,
-                                               filePath.c_str(),
-                                               MA_SOUND_FLAG_DECODE,
-                                               getBusGroup(bus),
-                                               nullptr,
-                                               sound);
+    ma_result result = ma_sound_start(sound);
     if (result != MA_SUCCESS) {
-        delete sound;
+        releaseVoice(sound);
+        return false;
+    }
+    return true;
+}
+
+bool AudioSystem::start3DDirectional(ma_sound* sound,
+                                     const Math::Vector3& position,
+                                     const Math::Vector3& direction,
+                                     float volume,
+                                     float pitch,
+                                     float minDistance,
+                                     float maxDistance,
+                                     float rolloff,
+                                     float innerConeRadians,
+                                     float outerConeRadians,
+                                     float outerGain,
+                                     float directionalAttenuationFactor) {
+    if (!sound) {
         return false;
     }
 
+    Math::Vector3 dir = direction.lengthSquared() > Math::EPSILON
+        ? direction.normalized()
+        : Math::Vector3(0.0f, 0.0f, -1.0f);
+
     ma_sound_set_spatialization_enabled(sound, MA_TRUE);
     ma_sound_set_attenuation_model(sound, ma_attenuation_model_inverse);
     ma_sound_set_position(sound, position.x, position.y, position.z);
+    ma_sound_set_direction(sound, dir.x, dir.y, dir.z);
+    ma_sound_set_cone(sound, innerConeRadians, outerConeRadians, outerGain);
+    ma_sound_set_directional_attenuation_factor(sound, std::max(0.0f, directionalAttenuationFactor));
     ma_sound_set_min_distance(sound, std::max(0.01f, minDistance));
     ma_sound_set_max_distance(sound, std::max(minDistance, maxDistance));
     ma_sound_set_rolloff(sound, std::max(0.0f, rolloff));
     ma_sound_set_volume(sound, std::max(0.0f, volume));
     ma_sound_set_pitch(sound, std::max(0.01f, pitch));
 
-    result = ma_sound_start(sound);
+    ma_result result = ma_sound_start(sound);
     if (result != MA_SUCCESS) {
-        ma_sound_uninit(sound);
-        delete sound;
+        releaseVoice(sound);
         return false;
     }
-
-    m_ActiveOneShots.push_back(sound);
     return true;
 }
 
+bool AudioSystem::playOneShot(const std::string& filePath,
+                              float volume,
+                              float pitch) {
+    return playOneShot(filePath, AudioBus::SFX, volume, pitch);
+}
+
+bool AudioSystem::playOneShot(const std::string& filePath,
+                              AudioBus bus,
+                              float volume,
+                              float pitch) {
+    return playOneShot(loadClip(filePath), bus, volume, pitch);
+}
+
+bool AudioSystem::playOneShot(AudioClipHandle clip,
+                              AudioBus bus,
+                              float volume,
+                              float pitch,
+                              int priority) {
+    return start2D(acquireVoice(clip, bus, priority, std::max(0.0f, volume)), volume, pitch);
+}
+
+bool AudioSystem::playOneShot3D(const std::string& filePath,
+                                const Math::Vector3& position,
+                                float volume,
+                                float pitch,
+                                float minDistance,
+                                float maxDistance,
+                                float rolloff) {
+    return playOneShot3D(filePath, position, AudioBus::SFX, volume, pitch, minDistance, maxDistance, rolloff);
+}
+
+bool AudioSystem::playOneShot3D(const std::string& filePath,
+                                const Math::Vector3& position,
+                                AudioBus bus,
+                                float volume,
+                                float pitch,
+                                float minDistance,
+                                float maxDistance,
+                                float rolloff) {
+    return playOneShot3D(loadClip(filePath), position, bus, volume, pitch, minDistance, maxDistance, rolloff);
+}
+
+bool AudioSystem::playOneShot3D(AudioClipHandle clip,
+                                const Math::Vector3& position,
+                                AudioBus bus,
+                                float volume,
+                                float pitch,
+                                float minDistance,
+                                float maxDistance,
+                                float rolloff,
+                                int priority) {
+    const float audibility = estimateAudibility(position, volume, minDistance, maxDistance, rolloff);
+    return start3D(acquireVoice(clip, bus, priority, audibility), position, volume, pitch,
+                   minDistance, maxDistance, rolloff);
+}
+
 bool AudioSystem::playOneShot3DDirectional(const std::string& filePath,
                                            const Math::Vector3& position,
                                            const Math::Vector3& direction,
@@ -355,49 +892,183 @@ bool AudioSystem::playOneShot3DDirectional(const std::string& filePath,
                                            float outerConeRadians,
                                            float outerGain,
                                            float directionalAttenuationFactor) {
-    if (!m_Initialized || !m_Engine || filePath.empty()) {
-        return false;
+    return playOneShot3DDirectional(loadClip(filePath), position, direction, bus, volume, pitch,
+                                    minDistance, maxDistance, rolloff, innerConeRadians, outerConeRadians,
+                                    outerGain, directionalAttenuationFactor);
+}
+
+bool AudioSystem::playOneShot3DDirectional(AudioClipHandle clip,
+                                           const Math::Vector3& position,
+                                           const Math::Vector3& direction,
+                                           AudioBus bus,
+                                           float volume,
+                                           float pitch,
+                                           float minDistance,
+                                           float maxDistance,
+                                           float rolloff,
+                                           float innerConeRadians,
+                                           float outerConeRadians,
+                                           float outerGain,
+                                           float directionalAttenuationFactor,
+                                           int priority) {
+    const float audibility = estimateAudibility(position, volume, minDistance, maxDistance, rolloff);
+    return start3DDirectional(acquireVoice(clip, bus, priority, audibility), position, direction, volume, pitch,
+                              minDistance, maxDistance, rolloff, innerConeRadians, outerConeRadians,
+                              outerGain, directionalAttenuationFactor);
+}
+
+void AudioSystem::registerEmitter(AudioSource* source) {
+    if (!source || source->m_EmitterIndex != AudioSource::kNoEmitterIndex) {
+        return;
+    }
+    source->m_EmitterIndex = m_Emitters.size();
+    source->m_CommandTicket = m_Commands.ticket();
+    m_Emitters.push_back(source);
+}
+
+void AudioSystem::unregisterEmitter(AudioSource* source) {
+    if (!source) {
+        return;
+    }
+    const size_t index = source->m_EmitterIndex;
+    source->m_EmitterIndex = AudioSource::kNoEmitterIndex;
+    if (index >= m_Emitters.size() || m_Emitters[index] != source) {
+        return;
     }
+    flushCommands(source->m_CommandTicket);
+    m_Emitters[index] = m_Emitters.back();
+    m_Emitters[index]->m_EmitterIndex = index;
+    m_Emitters.pop_back();
+}
 
-    cleanupFinishedOneShots();
+float AudioSystem::advanceClock() {
+    const auto now = std::chrono::steady_clock::now();
+    const float deltaTime = m_HasUpdateTime
+        ? std::chrono::duration<float>(now - m_LastUpdateTime).count()
+        : 0.0f;
+    m_LastUpdateTime = now;
+    m_HasUpdateTime = true;
+    return deltaTime;
+}
 
-    ma_sound* sound = new ma_sound();
-    ma_result result = ma_sound_init_from_file(m_Engine,
-                                               filePath.c_str(),
-                                               MA_SOUND_FLAG_DECODE,
-                                               getBusGroup(bus),
-                                               nullptr,
-                                               sound);
-    if (result != MA_SUCCESS) {
-        delete sound;
-        return false;
+void AudioSystem::updateEmitters(float deltaTime) {
+    if (m_Emitters.empty()) {
+        return;
     }
 
-    Math::Vector3 dir = direction.lengthSquared() > Math::EPSILON
-        ? direction.normalized()
-        : Math::Vector3(0.0f, 0.0f, -1.0f);
+    ProjectSettings::AudioSettings settings;
+    if (auto project = ProjectManager::getInstance().getActiveProject()) {
+        settings = project->getSettings().audio;
+    }
 
-    ma_sound_set_spatialization_enabled(sound, MA_TRUE);
-    ma_sound_set_attenuation_model(sound, ma_attenuation_model_inverse);
-    ma_sound_set_position(sound, position.x, position.y, position.z);
-    ma_sound_set_direction(sound, dir.x, dir.y, dir.z);
-    ma_sound_set_cone(sound, innerConeRadians, outerConeRadians, outerGain);
-    ma_sound_set_directional_attenuation_factor(sound, std::max(0.0f, directionalAttenuationFactor));
-    ma_sound_set_min_distance(sound, std::max(0.01f, minDistance));
-    ma_sound_set_max_distance(sound, std::max(minDistance, maxDistance));
-    ma_sound_set_rolloff(sound, std::max(0.0f, rolloff));
-    ma_sound_set_volume(sound, std::max(0.0f, volume));
-    ma_sound_set_pitch(sound, std::max(0.01f, pitch));
+    m_EmitterRanks.clear();
+    for (AudioSource* source : m_Emitters) {
+        if (!source->m_Playing) {
+            continue;
+        }
+        if (source->m_Virtual) {
+            source->advanceVirtualCursor(deltaTime);
+            if (!source->m_Playing) {
+                continue;
+            }
+        } else if (source->m_VoiceStarted && m_Commands.isConsumed(source->m_StartTicket) &&
+                   ma_sound_at_end(source->m_Sound) == MA_TRUE) {
+            // Ended on its own; there is nothing to stop.
+            source->m_Playing = false;
+            source->m_VoiceStarted = false;
+            continue;
+        }
+        float audibility = source->m_Volume;
+        if (source->m_Spatial) {
+            audibility = estimateAudibility(source->getEmitterPosition(), source->m_Volume,
+                                            source->m_MinDistance, source->m_MaxDistance, source->m_Rolloff);
+        }
+        m_EmitterRanks.push_back({source->m_Virtual ? audibility : audibility * kRealVoiceHysteresis, source});
+    }
 
-    result = ma_sound_start(sound);
-    if (result != MA_SUCCESS) {
-        ma_sound_uninit(sound);
-        delete sound;
-        return false;
+    // The loudest within the budget keep or get a mixer voice.
+    const size_t budget = std::min<size_t>(std::max(settings.maxRealVoices, 1u), m_EmitterRanks.size());
+    if (budget < m_EmitterRanks.size()) {
+        std::nth_element(m_EmitterRanks.begin(), m_EmitterRanks.begin() + budget, m_EmitterRanks.end(),
+                         [](const EmitterRank& a, const EmitterRank& b) { return a.rank > b.rank; });
+    }
+    for (size_t i = 0; i < m_EmitterRanks.size(); ++i) {
+        const EmitterRank& entry = m_EmitterRanks[i];
+        const bool real = i < budget && entry.rank > 0.0f && entry.rank >= settings.audibilityThreshold;
+        AudioSource* source = entry.source;
+        if (real && source->m_Virtual) {
+            // The sync below starts the sound at the cursor.
+            source->m_Virtual = false;
+        } else if (!real && !source->m_Virtual) {
+            // Until its start is applied the sound's own cursor is stale, and the virtual cursor
+            // still holds the start frame.
+            if (source->m_VoiceStarted && m_Commands.isConsumed(source->m_StartTicket)) {
+                ma_uint64 cursor = 0;
+                ma_sound_get_cursor_in_pcm_frames(source->m_Sound, &cursor);
+                source->m_VirtualCursor = static_cast<double>(cursor);
+            }
+            source->m_Virtual = true;
+        }
     }
 
-    m_ActiveOneShots.push_back(sound);
-    return true;
+    for (AudioSource* source : m_Emitters) {
+        syncEmitter(source, deltaTime);
+    }
+}
+
+void AudioSystem::syncEmitter(AudioSource* source, float deltaTime) {
+    const bool running = source->m_Playing && !source->m_Virtual;
+    const bool startVoice = running && (!source->m_VoiceStarted || source->m_Restart);
+    const bool stopVoice = !running && source->m_VoiceStarted;
+    const bool sendPose = running && source->m_Spatial;
+    if (!source->m_ParamsDirty && !startVoice && !stopVoice && !sendPose) {
+        source->m_HasLastPosition = false;
+        source->m_Restart = false;
+        return;
+    }
+    // Left pending for the next frame when the mixer falls behind.
+    if (m_Commands.freeSlots() < kMaxEmitterCommands) {
+        return;
+    }
+
+    AudioCommand command;
+    command.sound = source->m_Sound;
+    if (source->m_ParamsDirty) {
+        command.type = AudioCommandType::EmitterParams;
+        command.volume = source->m_Volume;
+        command.pitch = source->m_Pitch;
+        command.looping = source->m_Looping;
+        command.spatial = source->m_Spatial;
+        command.minDistance = source->m_MinDistance;
+        command.maxDistance = source->m_MaxDistance;
+        command.rolloff = source->m_Rolloff;
+        m_Commands.push(command);
+        source->m_ParamsDirty = false;
+    }
+    if (sendPose) {
+        const Math::Vector3 position = source->getEmitterPosition();
+        command.type = AudioCommandType::EmitterPose;
+        command.position = position;
+        command.velocity = source->m_HasLastPosition && deltaTime > 0.0f
+            ? (position - source->m_LastPosition) / deltaTime
+            : Math::Vector3::Zero;
+        m_Commands.push(command);
+        source->m_LastPosition = position;
+    }
+    source->m_HasLastPosition = sendPose;
+    if (startVoice) {
+        command.type = AudioCommandType::EmitterStart;
+        command.frame = static_cast<uint64_t>(source->m_VirtualCursor);
+        m_Commands.push(command);
+        source->m_VoiceStarted = true;
+        source->m_StartTicket = m_Commands.ticket();
+    } else if (stopVoice) {
+        command.type = AudioCommandType::EmitterStop;
+        m_Commands.push(command);
+        source->m_VoiceStarted = false;
+    }
+    source->m_Restart = false;
+    source->m_CommandTicket = m_Commands.ticket();
 }
 
 } // namespace Crescent
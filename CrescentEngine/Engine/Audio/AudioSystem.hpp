@@ -1,14 +1,24 @@
 #pragma once
 
+#include "AudioCommandQueue.hpp"
 #include "../Math/Vector3.hpp"
+#include "../Core/MemoryTracker.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 struct ma_engine;
+struct ma_resource_manager;
 struct ma_sound;
 
 namespace Crescent {
 
+class AudioSource;
 class Camera;
 enum class AudioBus {
     Master = 0,
@@ -19,16 +29,40 @@ enum class AudioBus {
     UI
 };
 
+// How an AudioSource holds its clip. Decoded keeps the whole clip resident as PCM. Streaming reads
+// the file from disk a page at a time, and Compressed keeps the encoded file resident and reads its
+// pages from memory; both decode their pages ahead of the mixer on the shared decoder threads.
+enum class AudioLoadMode {
+    Decoded = 0,
+    Streaming,
+    Compressed
+};
+
+// A clip registered with AudioSystem::loadClip. Its decoded data stays resident, so playing it does
+// not touch the file system. 0 is no clip.
+using AudioClipHandle = uint32_t;
+constexpr AudioClipHandle kInvalidAudioClip = 0;
+
 class AudioSystem {
 public:
+    // One-shots play on a fixed pool of voices. When every voice is busy the least important one
+    // is stolen: lowest priority first, then the quietest at the listener.
+    static constexpr uint32_t kMaxVoices = 32;
+    // Threads of the resource manager, decoding stream pages for every streaming source.
+    static constexpr uint32_t kDecoderThreads = 2;
+
     static AudioSystem& getInstance();
     static const char* audioBusToString(AudioBus bus);
     static AudioBus audioBusFromString(const std::string& value);
+    static const char* audioLoadModeToString(AudioLoadMode mode);
+    static AudioLoadMode audioLoadModeFromString(const std::string& value);
 
     bool initialize();
     void shutdown();
     bool isInitialized() const { return m_Initialized; }
 
+    // The frame's audio pass, run by one task: queues the listener pose and the emitter changes
+    // for the mixer, which applies them between periods. Nothing here waits on the audio thread.
     void updateListener(const Math::Vector3& position,
                         const Math::Vector3& forward,
                         const Math::Vector3& up);
@@ -83,11 +117,123 @@ public:
                                   float outerGain,
                                   float directionalAttenuationFactor);
 
+    // Registers a file for handle playback; the same path gives the same handle. The file is
+    // decoded on first play, or by preloadClip. Invalid for an empty path. The path overloads of
+    // the one-shots go through here as well.
+    AudioClipHandle loadClip(const std::string& filePath);
+    // Decodes the clip now, so its first play does not hitch. False when it cannot be loaded.
+    bool preloadClip(AudioClipHandle clip);
+    bool playOneShot(AudioClipHandle clip,
+                     AudioBus bus,
+                     float volume,
+                     float pitch,
+                     int priority = 0);
+    bool playOneShot3D(AudioClipHandle clip,
+                       const Math::Vector3& position,
+                       AudioBus bus,
+                       float volume,
+                       float pitch,
+                       float minDistance,
+                       float maxDistance,
+                       float rolloff,
+                       int priority = 0);
+    bool playOneShot3DDirectional(AudioClipHandle clip,
+                                  const Math::Vector3& position,
+                                  const Math::Vector3& direction,
+                                  AudioBus bus,
+                                  float volume,
+                                  float pitch,
+                                  float minDistance,
+                                  float maxDistance,
+                                  float rolloff,
+                                  float innerConeRadians,
+                                  float outerConeRadians,
+                                  float outerGain,
+                                  float directionalAttenuationFactor,
+                                  int priority = 0);
+
+    // AudioSource emitters, virtualized by the listener update: past the project's real-voice
+    // budget or audibility threshold a playing source stops its sound and only advances a cursor,
+    // resuming from it once audible again. Their position, velocity and parameters reach the mixer
+    // through the command queue. Unregistering waits until the mixer is done with the source's
+    // queued commands, so its sound can be released right after.
+    void registerEmitter(AudioSource* source);
+    void unregisterEmitter(AudioSource* source);
+    // Volume at the listener under the inverse distance model the sounds use; 0 past maxDistance.
+    float estimateAudibility(const Math::Vector3& position, float volume, float minDistance,
+                             float maxDistance, float rolloff) const;
+
+    // Compressed sources: keeps the file's encoded bytes resident, shared by every retain of the
+    // path, so its streams read pages from memory. False when the file cannot be read.
+    bool retainCompressedFile(const std::string& filePath);
+    void releaseCompressedFile(const std::string& filePath);
+
     ma_engine* getEngine() const { return m_Engine; }
     ma_sound* getBusGroup(AudioBus bus) const;
 
 private:
-    void cleanupFinishedOneShots();
+    struct ClipSource {
+        std::string path;
+        ma_sound* source = nullptr;
+        bool failed = false;
+    };
+
+    struct ResidentFile {
+        std::vector<uint8_t> bytes;
+        uint32_t references = 0;
+        TrackedMemory memory;
+    };
+    // File system of the resource manager: resident files from memory, the rest from disk.
+    struct ResidentVFS;
+
+    struct Voice {
+        // The clip the voice's sound is a copy of; invalid while the sound is uninitialized.
+        AudioClipHandle clip = kInvalidAudioClip;
+        AudioBus bus = AudioBus::SFX;
+        int priority = 0;
+        // Volume at the listener when the voice started, for stealing.
+        float audibility = 0.0f;
+        bool active = false;
+    };
+
+    static void onVoiceEnd(void* userData, ma_sound* sound);
+    static void onEngineProcess(void* userData, float* frames, unsigned long long frameCount);
+    void applyCommand(const AudioCommand& command);
+    void flushCommands(uint32_t ticket);
+    void recycleFinishedVoices();
+    void releaseVoices();
+    void releaseClipSources();
+    bool initResourceManager();
+    void releaseResourceManager();
+    ma_sound* ensureClipSource(AudioClipHandle clip);
+    // A voice holding a copy of the clip on the bus, ready to start. Null when the clip cannot be
+    // loaded or every voice outranks the new sound.
+    ma_sound* acquireVoice(AudioClipHandle clip, AudioBus bus, int priority, float audibility);
+    void releaseVoice(ma_sound* sound);
+    // Seconds since the previous audio pass, on the wall clock the mixer follows.
+    float advanceClock();
+    void updateEmitters(float deltaTime);
+    void syncEmitter(AudioSource* source, float deltaTime);
+    bool start2D(ma_sound* sound, float volume, float pitch);
+    bool start3D(ma_sound* sound,
+                 const Math::Vector3& position,
+                 float volume,
+                 float pitch,
+                 float minDistance,
+                 float maxDistance,
+                 float rolloff);
+    bool start3DDirectional(ma_sound* sound,
+                            const Math::Vector3& position,
+                            const Math::Vector3& direction,
+                            float volume,
+                            float pitch,
+                            float minDistance,
+                            float maxDistance,
+                            float rolloff,
+                            float innerConeRadians,
+                            float outerConeRadians,
+                            float outerGain,
+                            float directionalAttenuationFactor);
 
     AudioSystem() = default;
     ~AudioSystem() = default;
@@ -95,13 +241,40 @@ private:
     AudioSystem& operator=(const AudioSystem&) = delete;
 
     ma_engine* m_Engine = nullptr;
+    ma_resource_manager* m_ResourceManager = nullptr;
+    ResidentVFS* m_VFS = nullptr;
+    // Read by the decoder threads when they open a stream.
+    std::mutex m_ResidentMutex;
+    std::unordered_map<std::string, ResidentFile> m_ResidentFiles;
     ma_sound* m_MasterGroup = nullptr;
     ma_sound* m_SfxGroup = nullptr;
     ma_sound* m_VocalGroup = nullptr;
     ma_sound* m_MusicGroup = nullptr;
     ma_sound* m_AmbienceGroup = nullptr;
     ma_sound* m_UIGroup = nullptr;
-    std::vector<ma_sound*> m_ActiveOneShots;
+    // Voice sounds live in one array, indexed like m_Voices.
+    ma_sound* m_VoiceSounds = nullptr;
+    std::vector<Voice> m_Voices;
+    std::vector<uint32_t> m_FreeVoices;
+    // Voices that reached their end, pushed by the audio thread and drained on the main thread.
+    // Each voice is queued at most once between drains, so the ring never fills.
+    std::array<std::atomic<uint32_t>, kMaxVoices> m_FinishedVoices{};
+    std::atomic<uint32_t> m_FinishedWrite{0};
+    std::atomic<uint32_t> m_FinishedRead{0};
+    AudioCommandQueue m_Commands;
+    Math::Vector3 m_ListenerPosition = Math::Vector3::Zero;
+    bool m_HasListenerPosition = false;
+    struct EmitterRank {
+        float rank;
+        AudioSource* source;
+    };
+    std::vector<AudioSource*> m_Emitters;
+    std::vector<EmitterRank> m_EmitterRanks;
+    std::chrono::steady_clock::time_point m_LastUpdateTime;
+    bool m_HasUpdateTime = false;
+    // Indexed by handle - 1.
+    std::vector<ClipSource> m_Clips;
+    std::unordered_map<std::string, AudioClipHandle> m_ClipLookup;
     bool m_Initialized = false;
 };
 
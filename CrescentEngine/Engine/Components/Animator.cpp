@@ -2,9 +2,11 @@
 #include "../ECS/Entity.hpp"
 #include "../ECS/Transform.hpp"
 #include "../Animation/AnimationPose.hpp"
+#include "../Animation/TwoBoneIK.hpp"
 #include "../Components/IKConstraint.hpp"
+#include "../Core/CPUProfiler.hpp"
 #include "../Core/Time.hpp"
-#include "../Scene/SceneCommands.hpp"
+#include "../Scene/Scene.hpp"
 #include <algorithm>
 #include <cctype>
 #include <cmath>
@@ -200,96 +202,33 @@ static void ResetLikelyRootMotionTranslationsToBind(const Skeleton& skeleton,
     }
 }
 
-static void CollectEvents(const AnimationClip* clip,
+static void CollectEvents(const std::shared_ptr<AnimationClip>& clip,
                           float prevTime,
                           float currentTime,
                           bool looping,
-                          std::vector<AnimationEvent>& outEvents) {
+                          AnimationEventRing& outEvents) {
     if (!clip) return;
     const auto& events = clip->getEvents();
     if (events.empty()) return;
     float duration = clip->getDurationSeconds();
     if (duration <= 0.0f) return;
 
-    if (!looping || currentTime >= prevTime) {
-        for (const auto& evt : events) {
-            if (evt.time > prevTime && evt.time <= currentTime) {
-                outEvents.push_back(evt);
-            }
-        }
-    } else {
-        for (const auto& evt : events) {
-            if (evt.time > prevTime || evt.time <= currentTime) {
-                outEvents.push_back(evt);
-            }
+    const bool wrapped = looping && currentTime < prevTime;
+    for (size_t i = 0; i < events.size(); ++i) {
+        const float time = events[i].time;
+        const bool crossed = wrapped
+            ? (time > prevTime || time <= currentTime)
+            : (time > prevTime && time <= currentTime);
+        if (crossed) {
+            outEvents.push(clip, static_cast<uint32_t>(i));
         }
     }
 }
 
-static void ApplyTwoBoneIK(const Skeleton& skeleton,
-                           AnimationLocalPose& pose,
-                           int rootIdx,
-                           int midIdx,
-                           int endIdx,
-                           const Math::Vector3& targetWorld,
-                           float weight) {
-    if (rootIdx < 0 || midIdx < 0 || endIdx < 0) {
-        return;
-    }
-    if (rootIdx >= static_cast<int>(pose.positions.size()) ||
-        midIdx >= static_cast<int>(pose.positions.size()) ||
-        endIdx >= static_cast<int>(pose.positions.size())) {
-        return;
-    }
-    float w = Math::Clamp(weight, 0.0f, 1.0f);
-    if (w <= 0.0001f) {
-        return;
-    }
-
-    std::vector<Math::Matrix4x4> globals;
-    for (int iter = 0; iter < 4; ++iter) {
-        BuildGlobalPose(skeleton, pose, globals);
-
-        auto applyBone = [&](int boneIdx) {
-            const Math::Matrix4x4& boneM = globals[static_cast<size_t>(boneIdx)];
-            const Math::Matrix4x4& endM = globals[static_cast<size_t>(endIdx)];
-            Math::Vector3 bonePos(boneM.m[12], boneM.m[13], boneM.m[14]);
-            Math::Vector3 endPos(endM.m[12], endM.m[13], endM.m[14]);
-            Math::Vector3 toEnd = (endPos - bonePos).normalized();
-            Math::Vector3 toTarget = (targetWorld - bonePos).normalized();
-            float cosAngle = Math::Clamp(toEnd.dot(toTarget), -1.0f, 1.0f);
-            if (cosAngle > 0.9995f) {
-                return;
-            }
-            Math::Vector3 axis = toEnd.cross(toTarget);
-            if (axis.length() < 0.0001f) {
-                return;
-            }
-            float angle = std::acos(cosAngle) * w;
-            Math::Quaternion delta = Math::Quaternion::FromAxisAngle(axis.normalized(), angle);
-
-            Math::Vector3 dummyPos;
-            Math::Quaternion boneRot;
-            Math::Vector3 dummyScale;
-            DecomposeTRS(boneM, dummyPos, boneRot, dummyScale);
-
-            Math::Quaternion parentRot = Math::Quaternion::Identity;
-            int parentIdx = skeleton.getBones()[static_cast<size_t>(boneIdx)].parentIndex;
-            if (parentIdx >= 0) {
-                const Math::Matrix4x4& parentM = globals[static_cast<size_t>(parentIdx)];
-                DecomposeTRS(parentM, dummyPos, parentRot, dummyScale);
-            }
-
-            Math::Quaternion newGlobal = delta * boneRot;
-            Math::Quaternion newLocal = parentRot.inverse() * newGlobal;
-            newLocal.normalize();
-            pose.rotations[static_cast<size_t>(boneIdx)] = newLocal;
-        };
-
-        applyBone(midIdx);
-        applyBone(rootIdx);
-    }
-}
+// The frame's IK stage: animators queue their chains in OnAnimationFinalize and
+// Animator::SolvePendingIK solves them together once the finalize pass is done.
+static TwoBoneIKBatch s_IKStage;
+static std::vector<Animator*> s_IKAnimators;
 
 static void CollectSkinnedTargets(Entity* entity,
                                   const Animator* owner,
@@ -340,6 +279,27 @@ Animator::Animator()
     , m_SmoothedDelta(0.0f) {
 }
 
+std::unique_ptr<Component> Animator::clone() const {
+    // Only the graph and its settings carry over. An autoplaying copy re-enters its current state
+    // in OnCreate; otherwise the skinned renderer's cloned clip and time already match it.
+    auto copy = std::make_unique<Animator>();
+    copy->m_States = m_States;
+    copy->m_Transitions = m_Transitions;
+    copy->m_BlendTrees = m_BlendTrees;
+    copy->m_Parameters = m_Parameters;
+    for (AnimatorParameter& param : copy->m_Parameters) {
+        param.triggerValue = false;
+    }
+    copy->m_AutoPlay = m_AutoPlay;
+    copy->m_DefaultBlendDuration = m_DefaultBlendDuration;
+    copy->m_RootMotionEnabled = m_RootMotionEnabled;
+    copy->m_RootMotionApplyPosition = m_RootMotionApplyPosition;
+    copy->m_RootMotionApplyRotation = m_RootMotionApplyRotation;
+    copy->m_CurrentStateIndex = m_CurrentStateIndex;
+    copy->m_NeedsApply = m_CurrentStateIndex >= 0;
+    return detachClone(std::move(copy));
+}
+
 void Animator::setStates(const std::vector<AnimatorState>& states) {
     m_States = states;
     if (m_States.empty()) {
@@ -436,14 +396,30 @@ void Animator::OnCreate() {
 }
 
 void Animator::OnUpdate(float deltaTime) {
-    std::vector<SkinnedMeshRenderer*> targets;
-    SkinnedMeshRenderer* skinned = ResolveSkinnedWithTargets(targets);
+    OnAnimationEvaluate(deltaTime);
+    OnAnimationFinalize();
+    SolvePendingIK();
+}
+
+void Animator::OnAnimationEvaluate(float deltaTime) {
+    CRESCENT_PROFILE_SCOPE("Animator::evaluate");
+    m_HasPendingRootMotion = false;
+    m_PendingRootPosition = Math::Vector3::Zero;
+    m_PendingRootRotation = Math::Quaternion::Identity;
+    m_PendingIK = false;
+    SkinnedMeshRenderer* skinned = ResolveSkinnedWithTargets(m_Targets);
     if (!skinned || m_States.empty()) {
         return;
     }
     if (!skinned->getSkeleton()) {
         return;
     }
+    const AnimationLodThrottle::Step lod = m_AnimationLodThrottle.advance(
+        skinned->getAnimationLod(), skinned->readScreenCoverage(), deltaTime, skinned->getSkeleton().get());
+    if (lod.frozen) {
+        return;
+    }
+    m_BoneMask = lod.boneMask;
 
     constexpr float kMaxAnimDelta = 0.05f;
     constexpr float kAnimSmoothing = 0.2f;
@@ -459,10 +435,12 @@ void Animator::OnUpdate(float deltaTime) {
     const Skeleton& skeleton = *skinned->getSkeleton();
     const auto& clips = skinned->getAnimationClips();
     float fixedStep = std::max(0.0001f, Time::fixedDeltaTime());
-    m_AnimAccumulator += animDelta;
-    float maxAccumulator = fixedStep * static_cast<float>(kMaxAnimSteps);
-    if (m_AnimAccumulator > maxAccumulator) {
-        m_AnimAccumulator = maxAccumulator;
+    if (!lod.throttled) {
+        m_AnimAccumulator += animDelta;
+        float maxAccumulator = fixedStep * static_cast<float>(kMaxAnimSteps);
+        if (m_AnimAccumulator > maxAccumulator) {
+            m_AnimAccumulator = maxAccumulator;
+        }
     }
 
     auto stepAnimation = [&](float stepDelta) {
@@ -554,14 +532,13 @@ void Animator::OnUpdate(float deltaTime) {
                     } else {
                         Math::Vector3 deltaPos = currentPos - m_PrevRootPos;
                         Math::Quaternion deltaRot = currentRot * m_PrevRootRot.inverse();
-                        Transform* transform = getEntity() ? getEntity()->getTransform() : nullptr;
-                        if (transform) {
-                            if (m_RootMotionApplyPosition) {
-                                transform->translate(deltaPos, true);
-                            }
-                            if (m_RootMotionApplyRotation) {
-                                transform->rotate(deltaRot, true);
-                            }
+                        if (m_RootMotionApplyPosition) {
+                            m_PendingRootPosition += m_PendingRootRotation * deltaPos;
+                            m_HasPendingRootMotion = true;
+                        }
+                        if (m_RootMotionApplyRotation) {
+                            m_PendingRootRotation = m_PendingRootRotation * deltaRot;
+                            m_HasPendingRootMotion = true;
                         }
                         m_PrevRootPos = currentPos;
                         m_PrevRootRot = currentRot;
@@ -573,27 +550,6 @@ void Animator::OnUpdate(float deltaTime) {
             }
         }
 
-        if (outputPose) {
-            Entity* entity = getEntity();
-            IKConstraint* ik = entity ? entity->getComponent<IKConstraint>() : nullptr;
-            if (ik && ik->isEnabled()) {
-                int rootIdx = skeleton.getBoneIndex(ik->getRootBone());
-                int midIdx = skeleton.getBoneIndex(ik->getMidBone());
-                int endIdx = skeleton.getBoneIndex(ik->getEndBone());
-                Math::Vector3 target = ik->getTargetPosition();
-                if (entity && !ik->getTargetEntityUUID().empty()) {
-                    if (Entity* targetEntity = SceneCommands::getEntityByUUID(entity->getScene(), ik->getTargetEntityUUID())) {
-                        if (Transform* targetTransform = targetEntity->getTransform()) {
-                            target = targetTransform->getWorldMatrix().transformPoint(ik->getTargetOffset());
-                        }
-                    }
-                } else if (!ik->getTargetInWorld() && entity) {
-                    target = entity->getTransform()->getWorldMatrix().transformPoint(target);
-                }
-                ApplyTwoBoneIK(skeleton, *outputPose, rootIdx, midIdx, endIdx, target, ik->getWeight());
-            }
-        }
-
         if (outputPose) {
             if (!m_HasPose) {
                 m_CurrentPose = *outputPose;
@@ -606,40 +562,136 @@ void Animator::OnUpdate(float deltaTime) {
         }
 
         // Fire events
-        const AnimationClip* activeClip = nullptr;
         if (state.type == AnimatorStateType::Clip && state.clipIndex >= 0 && state.clipIndex < static_cast<int>(clips.size())) {
-            activeClip = clips[static_cast<size_t>(state.clipIndex)].get();
-        }
-        if (activeClip) {
+            const std::shared_ptr<AnimationClip>& activeClip = clips[static_cast<size_t>(state.clipIndex)];
             CollectEvents(activeClip, m_PrevStateTime, m_StateTime, state.loop && skinned->isLooping(), m_FiredEvents);
         }
     };
 
-    int steps = 0;
-    while (m_AnimAccumulator >= fixedStep && steps < kMaxAnimSteps) {
-        m_AnimAccumulator -= fixedStep;
-        stepAnimation(fixedStep);
-        steps++;
-    }
-    if (!m_HasPose) {
-        stepAnimation(0.0f);
+    bool stepped = true;
+    if (lod.throttled) {
+        // One step covers the frames the LOD skipped; frames in between interpolate towards it.
+        stepped = lod.evaluate || !m_HasPose;
+        if (stepped) {
+            stepAnimation(lod.deltaTime);
+        }
+    } else {
+        int steps = 0;
+        while (m_AnimAccumulator >= fixedStep && steps < kMaxAnimSteps) {
+            m_AnimAccumulator -= fixedStep;
+            stepAnimation(fixedStep);
+            steps++;
+        }
+        if (!m_HasPose) {
+            stepAnimation(0.0f);
+        }
     }
 
-    float alpha = fixedStep > 0.0f ? (m_AnimAccumulator / fixedStep) : 0.0f;
-    if (m_HasPose) {
+    float alpha = lod.throttled ? lod.blend : (fixedStep > 0.0f ? (m_AnimAccumulator / fixedStep) : 0.0f);
+    if (m_HasPose && lod.skin) {
         BlendLocalPose(m_PrevPose, m_CurrentPose, alpha, m_RenderPose);
-        BuildSkinMatrices(skeleton, m_RenderPose, m_WorkMatrices);
-        for (auto* target : targets) {
-            if (target) {
-                target->applyBoneMatrices(m_WorkMatrices);
-            }
+        // IK reads other entities' transforms, so an IK-driven pose is skinned in the finalize pass.
+        Entity* entity = getEntity();
+        IKConstraint* ik = entity ? entity->getComponent<IKConstraint>() : nullptr;
+        m_PendingIK = ik && ik->isEnabled();
+        if (!m_PendingIK) {
+            SkinTargets(skeleton);
         }
     }
 
-    ResetTriggers();
+    // Triggers set during frames the LOD skips wait for the next step, which checks transitions.
+    if (stepped) {
+        ResetTriggers();
+    }
     skinned->setTimeSeconds(m_StateTime);
 }
 
+void Animator::OnAnimationFinalize() {
+    CRESCENT_PROFILE_SCOPE("Animator::finalize");
+    Entity* entity = getEntity();
+    if (!entity) {
+        return;
+    }
+    if (m_HasPendingRootMotion) {
+        if (Transform* transform = entity->getTransform()) {
+            transform->translate(m_PendingRootPosition, true);
+            transform->rotate(m_PendingRootRotation, true);
+        }
+        m_HasPendingRootMotion = false;
+    }
+
+    if (!m_PendingIK) {
+        return;
+    }
+    m_PendingIK = false;
+    SkinnedMeshRenderer* skinned = m_Targets.empty() ? nullptr : m_Targets.front();
+    IKConstraint* ik = entity->getComponent<IKConstraint>();
+    if (!skinned || !skinned->getSkeleton() || !ik) {
+        return;
+    }
+    const Skeleton& skeleton = *skinned->getSkeleton();
+    const IKConstraint::BoneBinding& binding = ik->bind(skeleton);
+    Entity* sourceEntity = skinned->getEntity();
+    if (!sourceEntity || !sourceEntity->getTransform()) {
+        SkinTargets(skeleton);
+        return;
+    }
+    Math::Vector3 target = ik->getTargetPosition();
+    if (!ik->getTargetEntityUUID().empty()) {
+        Scene* scene = entity->getScene();
+        Entity* targetEntity = scene && ik->getTargetEntityId().isValid() ? scene->findEntity(ik->getTargetEntityId()) : nullptr;
+        if (targetEntity) {
+            if (Transform* targetTransform = targetEntity->getTransform()) {
+                target = targetTransform->getWorldMatrix().transformPoint(ik->getTargetOffset());
+            }
+        }
+    } else if (!ik->getTargetInWorld()) {
+        target = entity->getTransform()->getWorldMatrix().transformPoint(target);
+    }
+
+    // The pose is in the space of the skinned entity, so the world target is brought into it.
+    TwoBoneIKJob job;
+    job.skeleton = &skeleton;
+    job.pose = &m_RenderPose;
+    job.root = binding.root;
+    job.mid = binding.mid;
+    job.end = binding.end;
+    job.target = sourceEntity->getTransform()->getWorldMatrix().inversed().transformPoint(target);
+    job.weight = ik->getWeight();
+    s_IKStage.add(job);
+    s_IKAnimators.push_back(this);
+}
+
+void Animator::SolvePendingIK() {
+    if (s_IKAnimators.empty()) {
+        return;
+    }
+    s_IKStage.solve();
+    for (Animator* animator : s_IKAnimators) {
+        SkinnedMeshRenderer* skinned = animator->m_Targets.empty() ? nullptr : animator->m_Targets.front();
+        if (skinned && skinned->getSkeleton()) {
+            animator->SkinTargets(*skinned->getSkeleton());
+        }
+    }
+    s_IKAnimators.clear();
+}
+
+// Skins the first target in place; further targets share its skeleton and copy its matrices.
+void Animator::SkinTargets(const Skeleton& skeleton) {
+    const std::vector<Math::Matrix4x4>* skinMatrices = nullptr;
+    for (auto* target : m_Targets) {
+        if (!target) {
+            continue;
+        }
+        if (!skinMatrices) {
+            target->skinPose(skeleton, m_RenderPose);
+            skinMatrices = &target->getBoneMatrices();
+        } else {
+            target->applyBoneMatrices(*skinMatrices);
+        }
+    }
+}
+
 bool Animator::ApplyState(int index, float blendDurationSeconds, bool restart) {
     if (index < 0 || index >= static_cast<int>(m_States.size())) {
         return false;
@@ -775,15 +827,15 @@ void Animator::EvaluateStatePose(const AnimatorState& state,
                                  const std::vector<std::shared_ptr<AnimationClip>>& clips,
                                  const Skeleton& skeleton,
                                  float timeSeconds,
-                                 AnimationLocalPose& outPose) const {
+                                 AnimationLocalPose& outPose) {
     if (state.type == AnimatorStateType::BlendTree) {
         if (state.blendTreeIndex < 0 || state.blendTreeIndex >= static_cast<int>(m_BlendTrees.size())) {
-            SampleLocalPose(skeleton, nullptr, timeSeconds, state.loop, outPose);
+            SampleLocalPose(skeleton, nullptr, timeSeconds, state.loop, outPose, nullptr, m_BoneMask);
             return;
         }
         const AnimatorBlendTree& tree = m_BlendTrees[static_cast<size_t>(state.blendTreeIndex)];
         if (tree.motions.empty()) {
-            SampleLocalPose(skeleton, nullptr, timeSeconds, state.loop, outPose);
+            SampleLocalPose(skeleton, nullptr, timeSeconds, state.loop, outPose, nullptr, m_BoneMask);
             return;
         }
 
@@ -796,7 +848,7 @@ void Animator::EvaluateStatePose(const AnimatorState& state,
         if (motions.size() == 1) {
             int idx = motions[0].clipIndex;
             const AnimationClip* clip = (idx >= 0 && idx < static_cast<int>(clips.size())) ? clips[static_cast<size_t>(idx)].get() : nullptr;
-            SampleLocalPose(skeleton, clip, timeSeconds, state.loop, outPose);
+            SampleLocalPose(skeleton, clip, timeSeconds, state.loop, outPose, ClipCursor(idx, clips.size()), m_BoneMask);
             return;
         }
 
@@ -811,7 +863,7 @@ void Animator::EvaluateStatePose(const AnimatorState& state,
         if (upper == 0) {
             int idx = motions[0].clipIndex;
             const AnimationClip* clip = (idx >= 0 && idx < static_cast<int>(clips.size())) ? clips[static_cast<size_t>(idx)].get() : nullptr;
-            SampleLocalPose(skeleton, clip, timeSeconds, state.loop, outPose);
+            SampleLocalPose(skeleton, clip, timeSeconds, state.loop, outPose, ClipCursor(idx, clips.size()), m_BoneMask);
             return;
         }
         size_t lower = upper - 1;
@@ -823,11 +875,9 @@ void Animator::EvaluateStatePose(const AnimatorState& state,
             ? clips[static_cast<size_t>(a.clipIndex)].get() : nullptr;
         const AnimationClip* clipB = (b.clipIndex >= 0 && b.clipIndex < static_cast<int>(clips.size()))
             ? clips[static_cast<size_t>(b.clipIndex)].get() : nullptr;
-        AnimationLocalPose poseA;
-        AnimationLocalPose poseB;
-        SampleLocalPose(skeleton, clipA, timeSeconds, state.loop, poseA);
-        SampleLocalPose(skeleton, clipB, timeSeconds, state.loop, poseB);
-        BlendLocalPose(poseA, poseB, t, outPose);
+        SampleLocalPose(skeleton, clipA, timeSeconds, state.loop, m_MotionPoseA, ClipCursor(a.clipIndex, clips.size()), m_BoneMask);
+        SampleLocalPose(skeleton, clipB, timeSeconds, state.loop, m_MotionPoseB, ClipCursor(b.clipIndex, clips.size()), m_BoneMask);
+        BlendLocalPose(m_MotionPoseA, m_MotionPoseB, t, outPose);
         return;
     }
 
@@ -835,7 +885,17 @@ void Animator::EvaluateStatePose(const AnimatorState& state,
     if (state.clipIndex >= 0 && state.clipIndex < static_cast<int>(clips.size())) {
         clip = clips[static_cast<size_t>(state.clipIndex)].get();
     }
-    SampleLocalPose(skeleton, clip, timeSeconds, state.loop, outPose);
+    SampleLocalPose(skeleton, clip, timeSeconds, state.loop, outPose, ClipCursor(state.clipIndex, clips.size()), m_BoneMask);
+}
+
+AnimationSampleCursor* Animator::ClipCursor(int clipIndex, size_t clipCount) {
+    if (clipIndex < 0 || static_cast<size_t>(clipIndex) >= clipCount) {
+        return nullptr;
+    }
+    if (m_ClipCursors.size() != clipCount) {
+        m_ClipCursors.resize(clipCount);
+    }
+    return &m_ClipCursors[static_cast<size_t>(clipIndex)];
 }
 
 float Animator::ResolveStateDuration(const AnimatorState& state,
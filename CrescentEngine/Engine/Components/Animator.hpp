@@ -2,6 +2,7 @@
 
 #include "../ECS/Component.hpp"
 #include "../Components/SkinnedMeshRenderer.hpp"
+#include "../Animation/AnimationEventRing.hpp"
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -124,11 +125,19 @@ public:
     bool getApplyRootMotionRotation() const { return m_RootMotionApplyRotation; }
     void setApplyRootMotionRotation(bool enabled) { m_RootMotionApplyRotation = enabled; }
 
-    const std::vector<AnimationEvent>& getFiredEvents() const { return m_FiredEvents; }
+    // Events crossed since the last clear, oldest first.
+    const AnimationEventRing& getFiredEvents() const { return m_FiredEvents; }
     void clearFiredEvents() { m_FiredEvents.clear(); }
 
+    std::unique_ptr<Component> clone() const override;
     void OnCreate() override;
     void OnUpdate(float deltaTime) override;
+    bool hasAnimationPhase() const override { return true; }
+    void OnAnimationEvaluate(float deltaTime) override;
+    void OnAnimationFinalize() override;
+    // Solves the IK chains queued by this frame's OnAnimationFinalize calls as one batch and skins
+    // their animators. Runs after the finalize pass.
+    static void SolvePendingIK();
 
 private:
     bool ApplyState(int index, float blendDurationSeconds, bool restart);
@@ -138,7 +147,9 @@ private:
                            const std::vector<std::shared_ptr<AnimationClip>>& clips,
                            const Skeleton& skeleton,
                            float timeSeconds,
-                           AnimationLocalPose& outPose) const;
+                           AnimationLocalPose& outPose);
+    AnimationSampleCursor* ClipCursor(int clipIndex, size_t clipCount);
+    void SkinTargets(const Skeleton& skeleton);
     float ResolveStateDuration(const AnimatorState& state,
                                const std::vector<std::shared_ptr<AnimationClip>>& clips) const;
     float GetParameterFloat(const std::string& name, float fallback) const;
@@ -179,8 +190,22 @@ private:
     AnimationLocalPose m_StatePose;
     AnimationLocalPose m_NextPose;
     AnimationLocalPose m_BlendPose;
-    std::vector<Math::Matrix4x4> m_WorkMatrices;
-    std::vector<AnimationEvent> m_FiredEvents;
+    AnimationLocalPose m_MotionPoseA;
+    AnimationLocalPose m_MotionPoseB;
+    // One sampling cursor per clip of the skinned renderer, indexed like its clip list.
+    std::vector<AnimationSampleCursor> m_ClipCursors;
+    // Animation LOD, following the settings and screen coverage of the first skinned target.
+    AnimationLodThrottle m_AnimationLodThrottle;
+    const std::vector<uint8_t>* m_BoneMask = nullptr;
+    AnimationEventRing m_FiredEvents;
+
+    // Left by OnAnimationEvaluate for OnAnimationFinalize. Root motion of the frame's steps is
+    // folded into one move in the frame of the transform as it was before them.
+    std::vector<SkinnedMeshRenderer*> m_Targets;
+    bool m_HasPendingRootMotion = false;
+    Math::Vector3 m_PendingRootPosition = Math::Vector3::Zero;
+    Math::Quaternion m_PendingRootRotation = Math::Quaternion::Identity;
+    bool m_PendingIK = false;
 };
 
 } // namespace Crescent
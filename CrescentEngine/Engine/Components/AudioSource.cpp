@@ -3,6 +3,7 @@
 #include "../ECS/Entity.hpp"
 #include "../ECS/Transform.hpp"
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include "../../../ThirdParty/miniaudio/miniaudio.h"
@@ -15,6 +16,22 @@ AudioSource::~AudioSource() {
     unloadSound();
 }
 
+std::unique_ptr<Component> AudioSource::clone() const {
+    // The sound belongs to the source; the copy loads its own in OnCreate.
+    auto copy = std::make_unique<AudioSource>(*this);
+    copy->m_Sound = nullptr;
+    copy->m_Loaded = false;
+    copy->m_CompressedPath.clear();
+    copy->m_Playing = false;
+    copy->m_Virtual = false;
+    copy->m_EmitterIndex = kNoEmitterIndex;
+    copy->m_ParamsDirty = false;
+    copy->m_Restart = false;
+    copy->m_VoiceStarted = false;
+    copy->m_HasLastPosition = false;
+    return detachClone(std::move(copy));
+}
+
 void AudioSource::OnCreate() {
     loadSound();
 }
@@ -25,10 +42,6 @@ void AudioSource::OnStart() {
     }
 }
 
-void AudioSource::OnUpdate(float) {
-    updateSpatial();
-}
-
 void AudioSource::OnDisable() {
     stop();
 }
@@ -47,38 +60,29 @@ void AudioSource::setFilePath(const std::string& path) {
 
 void AudioSource::setVolume(float value) {
     m_Volume = std::max(0.0f, value);
-    if (m_Sound && m_Loaded) {
-        ma_sound_set_volume(m_Sound, m_Volume);
-    }
+    m_ParamsDirty = true;
 }
 
 void AudioSource::setPitch(float value) {
     m_Pitch = std::max(0.01f, value);
-    if (m_Sound && m_Loaded) {
-        ma_sound_set_pitch(m_Sound, m_Pitch);
-    }
+    m_ParamsDirty = true;
 }
 
 void AudioSource::setLooping(bool loop) {
     m_Looping = loop;
-    if (m_Sound && m_Loaded) {
-        ma_sound_set_looping(m_Sound, m_Looping);
-    }
+    m_ParamsDirty = true;
 }
 
 void AudioSource::setSpatial(bool value) {
     m_Spatial = value;
-    if (m_Sound && m_Loaded) {
-        ma_sound_set_spatialization_enabled(m_Sound, m_Spatial);
-        ma_sound_set_attenuation_model(m_Sound, m_Spatial ? ma_attenuation_model_inverse : ma_attenuation_model_none);
-    }
+    m_ParamsDirty = true;
 }
 
-void AudioSource::setStreaming(bool value) {
-    if (m_Stream == value) {
+void AudioSource::setLoadMode(AudioLoadMode value) {
+    if (m_LoadMode == value) {
         return;
     }
-    m_Stream = value;
+    m_LoadMode = value;
     loadSound();
 }
 
@@ -95,31 +99,17 @@ void AudioSource::setMinDistance(float value) {
     if (m_MaxDistance < m_MinDistance) {
         m_MaxDistance = m_MinDistance;
     }
-    if (m_Sound && m_Loaded) {
-        ma_sound_set_min_distance(m_Sound, m_MinDistance);
-        ma_sound_set_max_distance(m_Sound, m_MaxDistance);
-    }
+    m_ParamsDirty = true;
 }
 
 void AudioSource::setMaxDistance(float value) {
     m_MaxDistance = std::max(m_MinDistance, value);
-    if (m_Sound && m_Loaded) {
-        ma_sound_set_max_distance(m_Sound, m_MaxDistance);
-    }
+    m_ParamsDirty = true;
 }
 
 void AudioSource::setRolloff(float value) {
     m_Rolloff = std::max(0.0f, value);
-    if (m_Sound && m_Loaded) {
-        ma_sound_set_rolloff(m_Sound, m_Rolloff);
-    }
-}
-
-bool AudioSource::isPlaying() const {
-    if (!m_Sound || !m_Loaded) {
-        return false;
-    }
-    return ma_sound_is_playing(m_Sound) == MA_TRUE;
+    m_ParamsDirty = true;
 }
 
 void AudioSource::play() {
@@ -132,17 +122,21 @@ void AudioSource::play() {
         return;
     }
 
-    ma_sound_stop(m_Sound);
-    ma_sound_seek_to_pcm_frame(m_Sound, 0);
-    updateSpatial();
-    ma_sound_start(m_Sound);
+    m_Playing = true;
+    m_Restart = true;
+    m_VirtualCursor = 0.0;
+    // Out of range sources start virtual; the budget and threshold are applied by the next
+    // emitter update.
+    const float audibility = m_Spatial
+        ? AudioSystem::getInstance().estimateAudibility(getEmitterPosition(), m_Volume,
+                                                        m_MinDistance, m_MaxDistance, m_Rolloff)
+        : m_Volume;
+    m_Virtual = audibility <= 0.0f;
 }
 
 void AudioSource::stop() {
-    if (!m_Sound || !m_Loaded) {
-        return;
-    }
-    ma_sound_stop(m_Sound);
+    m_Playing = false;
+    m_Virtual = false;
 }
 
 bool AudioSource::loadSound() {
@@ -162,8 +156,19 @@ bool AudioSource::loadSound() {
         return false;
     }
 
+    ma_uint32 flags = MA_SOUND_FLAG_DECODE;
+    if (m_LoadMode == AudioLoadMode::Streaming) {
+        flags = MA_SOUND_FLAG_STREAM;
+    } else if (m_LoadMode == AudioLoadMode::Compressed) {
+        // A stream whose pages come from the resident encoded file rather than the disk.
+        if (!audio.retainCompressedFile(m_FilePath)) {
+            return false;
+        }
+        m_CompressedPath = m_FilePath;
+        flags = MA_SOUND_FLAG_STREAM;
+    }
+
     m_Sound = new ma_sound();
-    ma_uint32 flags = m_Stream ? MA_SOUND_FLAG_STREAM : MA_SOUND_FLAG_DECODE;
     ma_result result = ma_sound_init_from_file(engine,
                                                m_FilePath.c_str(),
                                                flags,
@@ -174,22 +179,44 @@ bool AudioSource::loadSound() {
         std::cerr << "Failed to load audio: " << m_FilePath << " (" << result << ")" << std::endl;
         delete m_Sound;
         m_Sound = nullptr;
+        if (!m_CompressedPath.empty()) {
+            audio.releaseCompressedFile(m_CompressedPath);
+            m_CompressedPath.clear();
+        }
         return false;
     }
 
     m_Loaded = true;
+    ma_uint64 lengthFrames = 0;
+    ma_sound_get_length_in_pcm_frames(m_Sound, &lengthFrames);
+    ma_uint32 sampleRate = 0;
+    ma_sound_get_data_format(m_Sound, nullptr, nullptr, &sampleRate, nullptr, 0);
+    m_LengthFrames = lengthFrames;
+    m_SampleRate = sampleRate;
+    // Not started yet, so the mixer does not read the sound and it is set up directly.
     applySettings();
-    updateSpatial();
+    audio.registerEmitter(this);
     return true;
 }
 
 void AudioSource::unloadSound() {
+    AudioSystem::getInstance().unregisterEmitter(this);
+    m_Playing = false;
+    m_Virtual = false;
+    m_ParamsDirty = false;
+    m_Restart = false;
+    m_VoiceStarted = false;
+    m_HasLastPosition = false;
     if (m_Sound && m_Loaded) {
         ma_sound_uninit(m_Sound);
     }
     delete m_Sound;
     m_Sound = nullptr;
     m_Loaded = false;
+    if (!m_CompressedPath.empty()) {
+        AudioSystem::getInstance().releaseCompressedFile(m_CompressedPath);
+        m_CompressedPath.clear();
+    }
 }
 
 void AudioSource::applySettings() {
@@ -205,21 +232,29 @@ void AudioSource::applySettings() {
     ma_sound_set_min_distance(m_Sound, m_MinDistance);
     ma_sound_set_max_distance(m_Sound, m_MaxDistance);
     ma_sound_set_rolloff(m_Sound, m_Rolloff);
+    const Math::Vector3 position = getEmitterPosition();
+    ma_sound_set_position(m_Sound, position.x, position.y, position.z);
+    m_ParamsDirty = false;
 }
 
-void AudioSource::updateSpatial() {
-    if (!m_Sound || !m_Loaded || !m_Spatial) {
-        return;
-    }
-    if (!m_Entity) {
+Math::Vector3 AudioSource::getEmitterPosition() const {
+    const Transform* transform = m_Entity ? m_Entity->getTransform() : nullptr;
+    return transform ? transform->getPosition() : Math::Vector3::Zero;
+}
+
+void AudioSource::advanceVirtualCursor(float deltaTime) {
+    m_VirtualCursor += static_cast<double>(deltaTime) * m_SampleRate * m_Pitch;
+    // Streams of unknown length keep going until stopped.
+    if (m_LengthFrames == 0 || m_VirtualCursor < static_cast<double>(m_LengthFrames)) {
         return;
     }
-    Transform* transform = m_Entity->getTransform();
-    if (!transform) {
-        return;
+    if (m_Looping) {
+        m_VirtualCursor = std::fmod(m_VirtualCursor, static_cast<double>(m_LengthFrames));
+    } else {
+        m_Playing = false;
+        m_Virtual = false;
+        m_VirtualCursor = 0.0;
     }
-    Math::Vector3 position = transform->getPosition();
-    ma_sound_set_position(m_Sound, position.x, position.y, position.z);
 }
 
 } // namespace Crescent
@@ -2,6 +2,8 @@
 
 #include "../ECS/Component.hpp"
 #include "../Audio/AudioSystem.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 struct ma_sound;
@@ -33,8 +35,10 @@ public:
     bool isSpatial() const { return m_Spatial; }
     void setSpatial(bool value);
 
-    bool isStreaming() const { return m_Stream; }
-    void setStreaming(bool value);
+    AudioLoadMode getLoadMode() const { return m_LoadMode; }
+    void setLoadMode(AudioLoadMode value);
+    bool isStreaming() const { return m_LoadMode == AudioLoadMode::Streaming; }
+    void setStreaming(bool value) { setLoadMode(value ? AudioLoadMode::Streaming : AudioLoadMode::Decoded); }
 
     AudioBus getBus() const { return m_Bus; }
     void setBus(AudioBus value);
@@ -48,21 +52,30 @@ public:
     float getRolloff() const { return m_Rolloff; }
     void setRolloff(float value);
 
-    bool isPlaying() const;
+    // Playing includes playing virtually, with no mixer voice; see AudioSystem::registerEmitter.
+    // Setters, play and stop only record the change; the frame's audio pass queues it for the mixer.
+    bool isPlaying() const { return m_Playing; }
+    bool isVirtual() const { return m_Playing && m_Virtual; }
     void play();
     void stop();
 
+    std::unique_ptr<Component> clone() const override;
+
     void OnCreate() override;
     void OnStart() override;
-    void OnUpdate(float deltaTime) override;
     void OnDisable() override;
     void OnDestroy() override;
 
 private:
+    friend class AudioSystem;
+    static constexpr size_t kNoEmitterIndex = SIZE_MAX;
+
     bool loadSound();
     void unloadSound();
     void applySettings();
-    void updateSpatial();
+    Math::Vector3 getEmitterPosition() const;
+    // Called by AudioSystem's emitter update.
+    void advanceVirtualCursor(float deltaTime);
 
     std::string m_FilePath;
     float m_Volume = 1.0f;
@@ -70,7 +83,7 @@ private:
     bool m_Looping = false;
     bool m_PlayOnStart = false;
     bool m_Spatial = true;
-    bool m_Stream = false;
+    AudioLoadMode m_LoadMode = AudioLoadMode::Decoded;
     AudioBus m_Bus = AudioBus::SFX;
     float m_MinDistance = 1.0f;
     float m_MaxDistance = 50.0f;
@@ -78,6 +91,24 @@ private:
 
     ma_sound* m_Sound = nullptr;
     bool m_Loaded = false;
+    // The file the sound keeps resident, in Compressed mode.
+    std::string m_CompressedPath;
+    bool m_Playing = false;
+    bool m_Virtual = false;
+    // In frames of the sound's own sample rate.
+    double m_VirtualCursor = 0.0;
+    uint64_t m_LengthFrames = 0;
+    uint32_t m_SampleRate = 0;
+    size_t m_EmitterIndex = kNoEmitterIndex;
+    // Mixer sync, owned by AudioSystem's emitter update. The voice is started as far as the queued
+    // commands go; the tickets mark its last start and its last queued command.
+    bool m_ParamsDirty = false;
+    bool m_Restart = false;
+    bool m_VoiceStarted = false;
+    bool m_HasLastPosition = false;
+    Math::Vector3 m_LastPosition = Math::Vector3::Zero;
+    uint32_t m_StartTicket = 0;
+    uint32_t m_CommandTicket = 0;
 };
 
 } // namespace Crescent
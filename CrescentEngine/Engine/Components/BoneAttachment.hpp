@@ -20,12 +20,17 @@ public:
     virtual ~BoneAttachment() = default;
 
     COMPONENT_TYPE(BoneAttachment)
+    COMPONENT_CLONE_BY_COPY(BoneAttachment)
 
     const std::string& getBoneName() const { return m_BoneName; }
-    void setBoneName(const std::string& boneName) { m_BoneName = boneName; }
+    void setBoneName(const std::string& boneName) { m_BoneName = boneName; m_BoundSkeleton = nullptr; }
 
     const std::string& getSourceEntityUUID() const { return m_SourceEntityUUID; }
-    void setSourceEntityUUID(const std::string& uuid) { m_SourceEntityUUID = uuid; }
+    void setSourceEntityUUID(const std::string& uuid) {
+        m_SourceEntityUUID = uuid;
+        m_BoundSource = UUID::Invalid();
+        m_RebindCountdown = 0;
+    }
 
     const Math::Vector3& getPositionOffset() const { return m_PositionOffset; }
     void setPositionOffset(const Math::Vector3& value) { m_PositionOffset = value; }
@@ -40,7 +45,7 @@ public:
     void setInheritBoneScale(bool value) { m_InheritBoneScale = value; }
 
     std::string getResolvedSourceEntityName() const {
-        if (const SkinnedMeshRenderer* skinned = resolveSourceRenderer()) {
+        if (const SkinnedMeshRenderer* skinned = boundSourceRenderer()) {
             if (Entity* source = skinned->getEntity()) {
                 return source->getName();
             }
@@ -104,25 +109,6 @@ private:
         outRot.normalize();
     }
 
-    static std::string Lowercase(const std::string& value) {
-        std::string lowered = value;
-        std::transform(lowered.begin(), lowered.end(), lowered.begin(),
-                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-        return lowered;
-    }
-
-    static std::string NormalizeBoneName(const std::string& value) {
-        std::string lowered = Lowercase(value);
-        std::string normalized;
-        normalized.reserve(lowered.size());
-        for (char c : lowered) {
-            if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
-                normalized.push_back(c);
-            }
-        }
-        return normalized;
-    }
-
     static const SkinnedMeshRenderer* FindSkinnedInHierarchy(Transform* root, const Transform* excludedSubtreeRoot) {
         if (!root || root == excludedSubtreeRoot) {
             return nullptr;
@@ -150,7 +136,7 @@ private:
 
         if (!m_SourceEntityUUID.empty()) {
             if (Scene* scene = m_Entity->getScene()) {
-                if (Entity* sourceEntity = SceneCommands::getEntityByUUID(scene, m_SourceEntityUUID)) {
+                if (Entity* sourceEntity = scene->findEntity(UUID::fromString(m_SourceEntityUUID))) {
                     if (auto* skinned = sourceEntity->getComponent<SkinnedMeshRenderer>()) {
                         return skinned;
                     }
@@ -202,34 +188,56 @@ private:
         return m_Entity->getComponent<SkinnedMeshRenderer>();
     }
 
-    int resolveBoneIndex(const Skeleton& skeleton) const {
-        if (m_BoneName.empty()) {
-            return -1;
+    // The source found by resolveSourceRenderer, kept by UUID so a frame only does a map lookup.
+    // The search runs again when the source is gone or the attachment is reparented, at most
+    // every kRebindRetryFrames while nothing is found.
+    const SkinnedMeshRenderer* boundSourceRenderer() const {
+        static constexpr int kRebindRetryFrames = 30;
+        if (!m_Entity) {
+            return nullptr;
         }
-
-        int exact = skeleton.getBoneIndex(m_BoneName);
-        if (exact >= 0) {
-            return exact;
+        Scene* scene = m_Entity->getScene();
+        Transform* transform = m_Entity->getTransform();
+        Transform* parent = transform ? transform->getParent() : nullptr;
+        if (parent != m_BoundParent) {
+            m_BoundParent = parent;
+            m_BoundSource = UUID::Invalid();
+            m_RebindCountdown = 0;
         }
-
-        const std::string needle = Lowercase(m_BoneName);
-        const std::string normalizedNeedle = NormalizeBoneName(m_BoneName);
-        const auto& bones = skeleton.getBones();
-        for (size_t i = 0; i < bones.size(); ++i) {
-            if (Lowercase(bones[i].name) == needle) {
-                return static_cast<int>(i);
-            }
-            if (!normalizedNeedle.empty() && NormalizeBoneName(bones[i].name) == normalizedNeedle) {
-                return static_cast<int>(i);
+        if (m_BoundSource.isValid() && scene) {
+            if (Entity* source = scene->findEntity(m_BoundSource)) {
+                if (auto* skinned = source->getComponent<SkinnedMeshRenderer>()) {
+                    return skinned;
+                }
             }
+            m_BoundSource = UUID::Invalid();
+            m_RebindCountdown = 0;
+        }
+        if (m_RebindCountdown > 0) {
+            --m_RebindCountdown;
+            return nullptr;
+        }
+        const SkinnedMeshRenderer* skinned = resolveSourceRenderer();
+        Entity* source = skinned ? skinned->getEntity() : nullptr;
+        if (!source) {
+            m_RebindCountdown = kRebindRetryFrames;
+            return nullptr;
         }
+        m_BoundSource = source->getUUID();
+        return skinned;
+    }
 
+    int resolveBoneIndex(const Skeleton& skeleton) const {
+        int index = skeleton.findBoneIndex(m_BoneName);
+        if (index >= 0 || m_BoneName.empty()) {
+            return index;
+        }
+
+        const std::string normalizedNeedle = Skeleton::NormalizeBoneName(m_BoneName);
         if (normalizedNeedle == "righthand" || normalizedNeedle == "lefthand") {
-            const bool wantRight = normalizedNeedle == "righthand";
+            const auto& bones = skeleton.getBones();
             for (size_t i = 0; i < bones.size(); ++i) {
-                std::string normalized = NormalizeBoneName(bones[i].name);
-                if ((wantRight && normalized.find("righthand") != std::string::npos) ||
-                    (!wantRight && normalized.find("lefthand") != std::string::npos)) {
+                if (Skeleton::NormalizeBoneName(bones[i].name).find(normalizedNeedle) != std::string::npos) {
                     return static_cast<int>(i);
                 }
             }
@@ -238,12 +246,22 @@ private:
         return -1;
     }
 
+    // resolveBoneIndex, rerun only when the source's skeleton or the bone name changes.
+    int boundBoneIndex(const Skeleton& skeleton) const {
+        if (m_BoundSkeleton != &skeleton || m_BoundBoneCount != skeleton.getBoneCount()) {
+            m_BoundSkeleton = &skeleton;
+            m_BoundBoneCount = skeleton.getBoneCount();
+            m_BoundBoneIndex = resolveBoneIndex(skeleton);
+        }
+        return m_BoundBoneIndex;
+    }
+
     void syncAttachment() {
         if (!m_Entity) {
             return;
         }
 
-        const SkinnedMeshRenderer* skinned = resolveSourceRenderer();
+        const SkinnedMeshRenderer* skinned = boundSourceRenderer();
         if (!skinned || !skinned->isEnabled()) {
             return;
         }
@@ -258,7 +276,7 @@ private:
             return;
         }
 
-        int boneIndex = resolveBoneIndex(*skeleton);
+        int boneIndex = boundBoneIndex(*skeleton);
         if (boneIndex < 0) {
             return;
         }
@@ -311,6 +329,13 @@ private:
     Math::Vector3 m_RotationOffsetDegrees = Math::Vector3::Zero;
     Math::Vector3 m_ScaleOffset = Math::Vector3::One;
     bool m_InheritBoneScale = false;
+
+    mutable UUID m_BoundSource = UUID::Invalid();
+    mutable Transform* m_BoundParent = nullptr;
+    mutable int m_RebindCountdown = 0;
+    mutable const Skeleton* m_BoundSkeleton = nullptr;
+    mutable uint32_t m_BoundBoneCount = 0;
+    mutable int m_BoundBoneIndex = -1;
 };
 
 } // namespace Crescent
@@ -56,6 +56,19 @@ void Camera::setFarClip(float farClip) {
 }
 
 void Camera::setAspectRatio(float aspect) {
+    // The render job fits the camera to its viewport; update owns the live value meanwhile.
+    if (RenderSnapshot::isReading()) {
+        if (m_RenderState.aspectRatio != aspect) {
+            m_RenderState.aspectRatio = aspect;
+            m_RenderState.projectionMatrix = buildProjectionMatrix(m_RenderState.projectionType,
+                                                                   m_RenderState.fieldOfView,
+                                                                   m_RenderState.orthographicSize,
+                                                                   aspect,
+                                                                   m_RenderState.nearClip,
+                                                                   m_RenderState.farClip);
+        }
+        return;
+    }
     if (m_AspectRatio != aspect) {
         m_AspectRatio = aspect;
         m_ProjectionDirty = true;
@@ -67,32 +80,52 @@ void Camera::setViewport(const Math::Vector4& viewport) {
 }
 
 Math::Matrix4x4 Camera::getProjectionMatrix() const {
+    if (RenderSnapshot::isReading()) {
+        return m_RenderState.projectionMatrix;
+    }
     if (m_ProjectionDirty) {
         const_cast<Camera*>(this)->updateProjectionMatrix();
     }
     return m_ProjectionMatrix;
 }
 
-void Camera::updateProjectionMatrix() {
-    if (m_ProjectionType == ProjectionType::Perspective) {
-        m_ProjectionMatrix = Math::Matrix4x4::Perspective(
-            m_FieldOfView,
-            m_AspectRatio,
-            m_NearClip,
-            m_FarClip
-        );
-    } else {
-        float height = m_OrthographicSize;
-        float width = height * m_AspectRatio;
-        m_ProjectionMatrix = Math::Matrix4x4::Orthographic(
-            -width, width,
-            -height, height,
-            m_NearClip, m_FarClip
-        );
+Math::Matrix4x4 Camera::buildProjectionMatrix(ProjectionType type,
+                                              float fieldOfView,
+                                              float orthographicSize,
+                                              float aspectRatio,
+                                              float nearClip,
+                                              float farClip) {
+    if (type == ProjectionType::Perspective) {
+        return Math::Matrix4x4::Perspective(fieldOfView, aspectRatio, nearClip, farClip);
     }
+    float height = orthographicSize;
+    float width = height * aspectRatio;
+    return Math::Matrix4x4::Orthographic(
+        -width, width,
+        -height, height,
+        nearClip, farClip
+    );
+}
+
+void Camera::updateProjectionMatrix() {
+    m_ProjectionMatrix = buildProjectionMatrix(m_ProjectionType, m_FieldOfView, m_OrthographicSize,
+                                               m_AspectRatio, m_NearClip, m_FarClip);
     m_ProjectionDirty = false;
 }
 
+void Camera::publishRenderState() {
+    m_RenderState.projectionType = m_ProjectionType;
+    m_RenderState.fieldOfView = m_FieldOfView;
+    m_RenderState.orthographicSize = m_OrthographicSize;
+    m_RenderState.nearClip = m_NearClip;
+    m_RenderState.farClip = m_FarClip;
+    m_RenderState.aspectRatio = m_AspectRatio;
+    m_RenderState.viewport = m_Viewport;
+    m_RenderState.clearColor = m_ClearColor;
+    m_RenderState.clearDepth = m_ClearDepth;
+    m_RenderState.projectionMatrix = getProjectionMatrix();
+}
+
 Math::Matrix4x4 Camera::getViewMatrix() const {
     if (!m_Entity) {
         return Math::Matrix4x4::Identity;
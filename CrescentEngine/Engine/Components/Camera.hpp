@@ -1,7 +1,9 @@
 #pragma once
 
 #include "../ECS/Component.hpp"
+#include "../ECS/RenderSnapshot.hpp"
 #include "../Math/Math.hpp"
+#include <cstdint>
 
 namespace Crescent {
 
@@ -17,47 +19,71 @@ public:
     virtual ~Camera() = default;
     
     COMPONENT_TYPE(Camera)
+    COMPONENT_CLONE_BY_COPY(Camera)
     
     // Projection
-    ProjectionType getProjectionType() const { return m_ProjectionType; }
+    ProjectionType getProjectionType() const {
+        return RenderSnapshot::isReading() ? m_RenderState.projectionType : m_ProjectionType;
+    }
     void setProjectionType(ProjectionType type);
     
     // Perspective settings
-    float getFieldOfView() const { return m_FieldOfView; }
+    float getFieldOfView() const { return RenderSnapshot::isReading() ? m_RenderState.fieldOfView : m_FieldOfView; }
     void setFieldOfView(float fov);
     
     // Orthographic settings
-    float getOrthographicSize() const { return m_OrthographicSize; }
+    float getOrthographicSize() const {
+        return RenderSnapshot::isReading() ? m_RenderState.orthographicSize : m_OrthographicSize;
+    }
     void setOrthographicSize(float size);
     
     // Common settings
-    float getNearClip() const { return m_NearClip; }
+    float getNearClip() const { return RenderSnapshot::isReading() ? m_RenderState.nearClip : m_NearClip; }
     void setNearClip(float nearClip);
     
-    float getFarClip() const { return m_FarClip; }
+    float getFarClip() const { return RenderSnapshot::isReading() ? m_RenderState.farClip : m_FarClip; }
     void setFarClip(float farClip);
     
-    float getAspectRatio() const { return m_AspectRatio; }
+    float getAspectRatio() const { return RenderSnapshot::isReading() ? m_RenderState.aspectRatio : m_AspectRatio; }
     void setAspectRatio(float aspect);
     
     // Viewport
-    Math::Vector4 getViewport() const { return m_Viewport; }
+    Math::Vector4 getViewport() const { return RenderSnapshot::isReading() ? m_RenderState.viewport : m_Viewport; }
     void setViewport(const Math::Vector4& viewport);
     
     // Clear settings
-    const Math::Vector4& getClearColor() const { return m_ClearColor; }
+    const Math::Vector4& getClearColor() const {
+        return RenderSnapshot::isReading() ? m_RenderState.clearColor : m_ClearColor;
+    }
     void setClearColor(const Math::Vector4& color) { m_ClearColor = color; }
     
-    bool getClearDepth() const { return m_ClearDepth; }
+    bool getClearDepth() const { return RenderSnapshot::isReading() ? m_RenderState.clearDepth : m_ClearDepth; }
     void setClearDepth(bool clear) { m_ClearDepth = clear; }
 
     bool isEditorCamera() const { return m_IsEditorCamera; }
     void setEditorCamera(bool editorCamera) { m_IsEditorCamera = editorCamera; }
+
+    // How the controller aiming this camera turns mouse motion into yaw and pitch, so low-latency
+    // presentation can re-aim a frame at motion that arrived after its update. Controllers refresh
+    // it every update; the engine ignores a latch not set during the frame's update.
+    struct LookLatch {
+        float yawPerUnit = 0.0f;   // radians about world up per unit of mouse x
+        float pitchPerUnit = 0.0f; // radians about the camera's right per unit of mouse y
+        float pitch = 0.0f;        // pitch the update left the camera at
+        float minPitch = 0.0f;
+        float maxPitch = 0.0f;
+        uint64_t frame = 0;        // Time::frameCount() of the update that set it
+    };
+    const LookLatch& getLookLatch() const { return m_LookLatch; }
+    void setLookLatch(const LookLatch& latch) { m_LookLatch = latch; }
     
     // Matrices
     Math::Matrix4x4 getProjectionMatrix() const;
     Math::Matrix4x4 getViewMatrix() const;
     Math::Matrix4x4 getViewProjectionMatrix() const;
+
+    // Copies the projection settings into the render snapshot (see RenderSnapshot).
+    void publishRenderState();
     
     // World to screen
     Math::Vector3 worldToScreenPoint(const Math::Vector3& worldPoint) const;
@@ -71,6 +97,12 @@ public:
     void OnDestroy() override;
     
 private:
+    static Math::Matrix4x4 buildProjectionMatrix(ProjectionType type,
+                                                 float fieldOfView,
+                                                 float orthographicSize,
+                                                 float aspectRatio,
+                                                 float nearClip,
+                                                 float farClip);
     void updateProjectionMatrix();
     
 private:
@@ -94,10 +126,26 @@ private:
     Math::Vector4 m_ClearColor;
     bool m_ClearDepth;
     bool m_IsEditorCamera;
+    LookLatch m_LookLatch;
     
     // Cached matrices
     mutable Math::Matrix4x4 m_ProjectionMatrix;
     mutable bool m_ProjectionDirty;
+
+    // Published copy read by the pipelined render job
+    struct RenderState {
+        ProjectionType projectionType = ProjectionType::Perspective;
+        float fieldOfView = Math::PI / 3.0f;
+        float orthographicSize = 5.0f;
+        float nearClip = 0.1f;
+        float farClip = 1000.0f;
+        float aspectRatio = 16.0f / 9.0f;
+        Math::Vector4 viewport = Math::Vector4(0.0f, 0.0f, 1.0f, 1.0f);
+        Math::Vector4 clearColor = Math::Vector4(0.1f, 0.1f, 0.15f, 1.0f);
+        bool clearDepth = true;
+        Math::Matrix4x4 projectionMatrix;
+    };
+    RenderState m_RenderState;
     
     // Main camera
     static Camera* s_MainCamera;
@@ -8,6 +8,7 @@ namespace Crescent {
 class CameraController : public Component {
 public:
     COMPONENT_TYPE(CameraController)
+    COMPONENT_CLONE_BY_COPY(CameraController)
     
     CameraController();
     
@@ -40,6 +40,18 @@ public:
         , m_CollisionMask(PhysicsWorld::kAllLayersMask) {
     }
 
+    std::unique_ptr<Component> clone() const override {
+        auto copy = std::make_unique<CharacterController>(*this);
+        copy->m_IsGrounded = false;
+        copy->m_GroundNormal = Math::Vector3::Up;
+        copy->m_Velocity = Math::Vector3::Zero;
+        copy->m_MoveInput = Math::Vector2::Zero;
+        copy->m_WorldMoveDirection = Math::Vector3::Zero;
+        copy->m_UseWorldMoveDirection = false;
+        copy->m_JumpQueued = false;
+        return detachClone(std::move(copy));
+    }
+
     float getRadius() const { return m_Radius; }
     void setRadius(float radius) { m_Radius = std::max(0.01f, radius); }
 
@@ -138,24 +150,27 @@ public:
             gatherInput();
         }
 
-        Scene* scene = m_Entity->getScene();
-        PhysicsWorld* physics = scene ? scene->getPhysicsWorld() : nullptr;
+        PhysicsWorld* physics = getPhysicsWorld();
         if (!physics) {
             return;
         }
 
-        Math::Vector3 position = transform->getPosition();
-        Math::Vector3 groundNormal = Math::Vector3::Up;
-        bool groundHit = probeGround(physics, position, groundNormal);
-        bool grounded = groundHit && isWalkable(groundNormal);
-        m_IsGrounded = grounded;
-        m_GroundNormal = grounded ? groundNormal : Math::Vector3::Up;
-
-        if (groundHit && !grounded && m_EnableSlopeLimit) {
-            applySlopeSlide(groundNormal, deltaTime);
+        // Ground and velocity as the last move left them; this frame's move runs with the other
+        // characters in PhysicsWorld::updateCharacters.
+        PhysicsCharacterState state;
+        if (physics->getCharacterState(m_Entity, state)) {
+            m_Velocity = state.velocity;
+            m_IsGrounded = state.grounded;
+            m_GroundNormal = state.grounded ? state.groundNormal : Math::Vector3::Up;
+            if (m_IsGrounded && m_Velocity.y < 0.0f) {
+                m_Velocity.y = 0.0f;
+            }
+            if (state.onSteepGround && m_EnableSlopeLimit) {
+                applySlopeSlide(state.groundNormal, deltaTime);
+            }
         }
 
-        if (m_JumpQueued && grounded) {
+        if (m_JumpQueued && m_IsGrounded) {
             m_Velocity.y = m_JumpSpeed;
             m_IsGrounded = false;
         }
@@ -190,33 +205,12 @@ public:
             }
         }
 
-        Math::Vector3 startPosition = position;
-        Math::Vector3 horizontalMove = Math::Vector3(m_Velocity.x, 0.0f, m_Velocity.z) * deltaTime;
-        position = moveHorizontal(physics, position, horizontalMove);
-
-        Math::Vector3 verticalMove = Math::Vector3(0.0f, m_Velocity.y * deltaTime, 0.0f);
-        position = moveVertical(physics, position, verticalMove);
-
-        Math::Vector3 postNormal = Math::Vector3::Up;
-        bool postHit = probeGround(physics, position, postNormal);
-        bool postGrounded = postHit && isWalkable(postNormal);
-        if (postGrounded) {
-            if (!m_IsGrounded && m_Velocity.y < 0.0f) {
-                m_Velocity.y = 0.0f;
-            }
-            m_IsGrounded = true;
-            m_GroundNormal = postNormal;
-        } else {
-            m_IsGrounded = false;
-            m_GroundNormal = Math::Vector3::Up;
-        }
-
-        transform->setPosition(position);
+        physics->moveCharacter(m_Entity, buildCharacterSettings(), m_Velocity, deltaTime);
+    }
 
-        Math::Vector3 actualDelta = position - startPosition;
-        m_Velocity = actualDelta / deltaTime;
-        if (m_IsGrounded && m_Velocity.y < 0.0f) {
-            m_Velocity.y = 0.0f;
+    void OnDestroy() override {
+        if (PhysicsWorld* physics = getPhysicsWorld()) {
+            physics->removeCharacter(m_Entity);
         }
     }
 
@@ -285,34 +279,10 @@ private:
         return current + delta * (maxDelta / length);
     }
 
-    bool isWalkable(const Math::Vector3& normal) const {
-        if (!m_EnableSlopeLimit) {
-            return true;
-        }
-        float cosLimit = std::cos(m_SlopeLimit * Math::DEG_TO_RAD);
-        return normal.dot(Math::Vector3::Up) >= cosLimit;
-    }
-
     Math::Vector3 projectOnPlane(const Math::Vector3& v, const Math::Vector3& normal) const {
         return v - normal * v.dot(normal);
     }
 
-    bool probeGround(PhysicsWorld* physics,
-                     const Math::Vector3& position,
-                     Math::Vector3& outNormal) const {
-        if (!physics) {
-            return false;
-        }
-        PhysicsRaycastHit hit;
-        float distance = m_GroundCheckDistance + m_SkinWidth;
-        bool hasHit = physics->capsuleCast(position, m_Radius, m_Height, Math::Vector3::Down,
-                                           distance, hit, m_CollisionMask, false, m_Entity);
-        if (hasHit) {
-            outNormal = hit.normal;
-        }
-        return hasHit;
-    }
-
     void applySlopeSlide(const Math::Vector3& normal, float deltaTime) {
         if (m_SlopeSlideSpeed <= 0.0f) {
             return;
@@ -326,124 +296,22 @@ private:
         m_Velocity += slideDir * (m_SlopeSlideSpeed * deltaTime);
     }
 
-    Math::Vector3 moveHorizontal(PhysicsWorld* physics,
-                                 const Math::Vector3& position,
-                                 const Math::Vector3& move) {
-        if (!physics) {
-            return position + move;
-        }
-        float distance = move.length();
-        if (distance <= Math::EPSILON) {
-            return position;
-        }
-
-        Math::Vector3 dir = move / distance;
-        PhysicsRaycastHit hit;
-        if (!physics->capsuleCast(position, m_Radius, m_Height, dir, distance + m_SkinWidth,
-                                  hit, m_CollisionMask, false, m_Entity)) {
-            return position + move;
-        }
-
-        float travel = std::max(0.0f, hit.distance - m_SkinWidth);
-        Math::Vector3 newPos = position + dir * travel;
-        float remaining = distance - travel;
-
-        if (m_EnableStep && m_IsGrounded && remaining > 0.0f && hit.normal.y < 0.4f) {
-            Math::Vector3 stepped = newPos;
-            if (tryStep(physics, newPos, dir, remaining, stepped)) {
-                return stepped;
-            }
-        }
-
-        Math::Vector3 slide = move - dir * travel;
-        slide = slide - hit.normal * slide.dot(hit.normal);
-        float slideDist = slide.length();
-        if (slideDist > Math::EPSILON) {
-            Math::Vector3 slideDir = slide / slideDist;
-            PhysicsRaycastHit slideHit;
-            if (physics->capsuleCast(newPos, m_Radius, m_Height, slideDir, slideDist + m_SkinWidth,
-                                     slideHit, m_CollisionMask, false, m_Entity)) {
-                float slideTravel = std::max(0.0f, slideHit.distance - m_SkinWidth);
-                newPos += slideDir * slideTravel;
-            } else {
-                newPos += slide;
-            }
-        }
-
-        return newPos;
-    }
-
-    Math::Vector3 moveVertical(PhysicsWorld* physics,
-                               const Math::Vector3& position,
-                               const Math::Vector3& move) {
-        if (!physics) {
-            return position + move;
-        }
-        float distance = std::abs(move.y);
-        if (distance <= Math::EPSILON) {
-            return position;
-        }
-
-        Math::Vector3 dir = (move.y > 0.0f) ? Math::Vector3::Up : Math::Vector3::Down;
-        PhysicsRaycastHit hit;
-        if (!physics->capsuleCast(position, m_Radius, m_Height, dir, distance + m_SkinWidth,
-                                  hit, m_CollisionMask, false, m_Entity)) {
-            return position + move;
-        }
-
-        float travel = std::max(0.0f, hit.distance - m_SkinWidth);
-        Math::Vector3 newPos = position + dir * travel;
-        if (dir.y > 0.0f) {
-            m_Velocity.y = 0.0f;
-        }
-        return newPos;
+    PhysicsWorld* getPhysicsWorld() const {
+        Scene* scene = m_Entity ? m_Entity->getScene() : nullptr;
+        return scene ? scene->getPhysicsWorld() : nullptr;
     }
 
-    bool tryStep(PhysicsWorld* physics,
-                 const Math::Vector3& position,
-                 const Math::Vector3& dir,
-                 float distance,
-                 Math::Vector3& outPosition) {
-        float stepHeight = std::min(m_StepOffset, m_Height * 0.5f);
-        if (stepHeight <= Math::EPSILON) {
-            return false;
-        }
-
-        PhysicsRaycastHit upHit;
-        if (physics->capsuleCast(position, m_Radius, m_Height, Math::Vector3::Up,
-                                 stepHeight + m_SkinWidth, upHit, m_CollisionMask, false, m_Entity)) {
-            return false;
-        }
-
-        Math::Vector3 stepPos = position + Math::Vector3::Up * stepHeight;
-        PhysicsRaycastHit forwardHit;
-        if (physics->capsuleCast(stepPos, m_Radius, m_Height, dir, distance + m_SkinWidth,
-                                 forwardHit, m_CollisionMask, false, m_Entity)) {
-            float travel = std::max(0.0f, forwardHit.distance - m_SkinWidth);
-            stepPos += dir * travel;
-            if (travel <= Math::EPSILON) {
-                return false;
-            }
-        } else {
-            stepPos += dir * distance;
-        }
-
-        PhysicsRaycastHit downHit;
-        float downDist = stepHeight + m_GroundCheckDistance + m_SkinWidth;
-        if (physics->capsuleCast(stepPos, m_Radius, m_Height, Math::Vector3::Down,
-                                 downDist, downHit, m_CollisionMask, false, m_Entity)) {
-            if (!isWalkable(downHit.normal)) {
-                return false;
-            }
-            float descend = std::max(0.0f, downHit.distance - m_SkinWidth);
-            stepPos += Math::Vector3::Down * descend;
-            outPosition = stepPos;
-            m_IsGrounded = true;
-            m_GroundNormal = downHit.normal;
-            return true;
-        }
-
-        return false;
+    PhysicsCharacterSettings buildCharacterSettings() const {
+        PhysicsCharacterSettings settings;
+        settings.radius = m_Radius;
+        settings.height = m_Height;
+        settings.padding = m_SkinWidth;
+        settings.maxSlopeDegrees = m_EnableSlopeLimit ? m_SlopeLimit : 90.0f;
+        settings.stepHeight = m_EnableStep ? std::min(m_StepOffset, m_Height * 0.5f) : 0.0f;
+        settings.stickToFloorDistance = m_SnapToGround ? std::max(m_StepOffset, m_GroundCheckDistance) : 0.0f;
+        settings.gravity = m_UseGravity ? m_Gravity : 0.0f;
+        settings.layerMask = m_CollisionMask;
+        return settings;
     }
 
     void ensureRigidbodyCompatibility() {
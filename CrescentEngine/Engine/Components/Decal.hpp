@@ -14,6 +14,7 @@ public:
     virtual ~Decal() = default;
 
     COMPONENT_TYPE(Decal)
+    COMPONENT_CLONE_BY_COPY(Decal)
 
     const Math::Vector4& getTint() const { return m_Tint; }
     void setTint(const Math::Vector4& tint) { m_Tint = tint; }
@@ -12,7 +12,9 @@
 #include "../ECS/Entity.hpp"
 #include "../ECS/Transform.hpp"
 #include "../Math/Math.hpp"
+#include "../Navigation/NavigationSystem.hpp"
 #include "../Physics/PhysicsWorld.hpp"
+#include "../Scene/AIUpdateScheduler.hpp"
 #include "../Scene/Scene.hpp"
 #include "../Scene/SceneManager.hpp"
 #include <algorithm>
@@ -21,6 +23,7 @@
 #include <iostream>
 #include <limits>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -74,6 +77,26 @@ public:
     bool getDebugLogging() const { return m_DebugLogging; }
     void setDebugLogging(bool value) { m_DebugLogging = value; }
 
+    // Settings only; the copy finds its own health, controller and animator in OnCreate.
+    std::unique_ptr<Component> clone() const override {
+        auto copy = std::make_unique<EnemyController>();
+        copy->m_DetectionRange = m_DetectionRange;
+        copy->m_LoseRange = m_LoseRange;
+        copy->m_AttackRange = m_AttackRange;
+        copy->m_ChaseSpeed = m_ChaseSpeed;
+        copy->m_RotationSmoothSpeed = m_RotationSmoothSpeed;
+        copy->m_AttackCooldown = m_AttackCooldown;
+        copy->m_AttackDamage = m_AttackDamage;
+        copy->m_AttackHitRadius = m_AttackHitRadius;
+        copy->m_AttackForwardOffset = m_AttackForwardOffset;
+        copy->m_AttackUpOffset = m_AttackUpOffset;
+        copy->m_AttackMask = m_AttackMask;
+        copy->m_AttackHitTriggers = m_AttackHitTriggers;
+        copy->m_DeathDespawnDelay = m_DeathDespawnDelay;
+        copy->m_DebugLogging = m_DebugLogging;
+        return detachClone(std::move(copy));
+    }
+
     void OnCreate() override {
         findDependencies();
         resolveClipMapping();
@@ -96,7 +119,14 @@ public:
         playStateClip(State::Idle, true, true);
     }
 
+    void OnStart() override {
+        preloadEventAudio();
+    }
+
     void OnDestroy() override {
+        AIUpdateScheduler::getInstance().unregisterAgent(m_AIAgent);
+        m_AIAgent = AIUpdateScheduler::kInvalidAgent;
+        clearChasePath();
         if (m_Controller) {
             m_Controller->clearWorldMoveDirection();
             m_Controller->setMoveSpeed(m_OriginalControllerMoveSpeed);
@@ -122,6 +152,20 @@ public:
             return;
         }
 
+        // Idle agents far from the player think at a reduced rate; the controller keeps the last
+        // move direction in between and the skipped time is spent as one longer step.
+        AIUpdateScheduler& scheduler = AIUpdateScheduler::getInstance();
+        if (m_AIAgent == AIUpdateScheduler::kInvalidAgent) {
+            m_AIAgent = scheduler.registerAgent();
+        }
+        m_PendingThinkTime += deltaTime;
+        const bool engaged = m_State != State::Idle || m_AttackHitWindowActive;
+        if (!scheduler.beginTick(m_AIAgent, m_Entity->getScene(), m_BodyTransform->getPosition(), 1.5f, engaged)) {
+            return;
+        }
+        deltaTime = m_PendingThinkTime;
+        m_PendingThinkTime = 0.0f;
+
         if (m_Controller) {
             m_Controller->setUseInput(false);
             m_Controller->setMoveSpeed(m_ChaseSpeed);
@@ -154,6 +198,7 @@ public:
         processClipEvents(deltaTime);
         updateAttackHitTrace(deltaTime);
         emitDebugLog();
+        scheduler.endTick(m_AIAgent);
     }
 
 private:
@@ -175,6 +220,14 @@ private:
         std::vector<int> hits;
     };
 
+    struct EventTraits {
+        AudioBus bus = AudioBus::SFX;
+        bool directional = false;
+        bool jump = false;
+        // 1 opens the attack hit window, -1 closes it.
+        int hitWindow = 0;
+    };
+
     static std::string ToLower(std::string value) {
         std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) {
             return static_cast<char>(std::tolower(c));
@@ -337,11 +390,20 @@ private:
         m_PrimarySkinned = m_SkinnedTargets.empty() ? nullptr : m_SkinnedTargets.front();
     }
 
+    // An enemy missing a dependency looks for it again at most every kDependencyRetryFrames, since
+    // the search walks the hierarchy and re-matches every clip name.
     void ensureDependencies() {
-        if (!m_BodyTransform || !m_Controller || !m_Health || !m_PrimarySkinned) {
-            findDependencies();
-            resolveClipMapping();
+        static constexpr int kDependencyRetryFrames = 30;
+        if (m_BodyTransform && m_Controller && m_Health && m_PrimarySkinned) {
+            return;
         }
+        if (m_DependencyRetryFrames > 0) {
+            --m_DependencyRetryFrames;
+            return;
+        }
+        m_DependencyRetryFrames = kDependencyRetryFrames;
+        findDependencies();
+        resolveClipMapping();
     }
 
     std::shared_ptr<AnimationClip> getClipShared(int clipIndex) const {
@@ -452,16 +514,22 @@ private:
 
     Entity* findPlayerEntity() const;
 
+    // The player is kept by UUID and checked with a map lookup each frame; the scene is only
+    // scanned when it is lost, and then at most every 0.35s until one turns up.
     void updatePlayerTarget(float deltaTime) {
         m_PlayerRefreshTimer -= deltaTime;
-        bool refresh = m_PlayerRefreshTimer <= 0.0f ||
-                       !m_Player ||
-                       !m_Player->isActiveInHierarchy() ||
-                       !m_Player->getScene() ||
-                       m_Player->getScene() != (m_Entity ? m_Entity->getScene() : nullptr);
-        if (refresh) {
+        Scene* scene = m_Entity ? m_Entity->getScene() : nullptr;
+        Entity* player = scene && m_PlayerId.isValid() ? scene->findEntity(m_PlayerId) : nullptr;
+        if (player && !player->isActiveInHierarchy()) {
+            player = nullptr;
+        }
+        if (!player && (m_Player || m_PlayerRefreshTimer <= 0.0f)) {
             m_PlayerRefreshTimer = 0.35f;
-            m_Player = findPlayerEntity();
+            player = findPlayerEntity();
+            m_PlayerId = player ? player->getUUID() : UUID::Invalid();
+        }
+        if (player != m_Player) {
+            m_Player = player;
             m_PlayerTransform = m_Player ? m_Player->getTransform() : nullptr;
             m_PlayerHealth = m_Player ? m_Player->getComponent<Health>() : nullptr;
         } else if (!m_PlayerTransform && m_Player) {
@@ -498,21 +566,63 @@ private:
         return std::filesystem::exists(candidate) ? candidate.string() : std::string();
     }
 
-    static std::string getEventTypeLower(const AnimationEvent& event) {
-        if (!event.eventType.empty()) {
-            return ToLower(event.eventType);
+    static bool isAudioEvent(const AnimationEvent& event) {
+        static const AnimationEventId kAudioType = InternAnimationEventName("audio");
+        return event.typeId == kAudioType || event.payloadId != kInvalidAnimationEventId;
+    }
+
+    // Dispatch traits of an event's tag, worked out on first sight of the tag.
+    const EventTraits& resolveEventTraits(const AnimationEvent& event) {
+        auto it = m_EventTraits.find(event.tagId);
+        if (it != m_EventTraits.end()) {
+            return it->second;
+        }
+        const std::string& tag = GetAnimationEventName(event.tagId);
+        EventTraits traits;
+        if (ContainsAnyToken(tag, {"vocal", "grunt", "man", "voice"})) {
+            traits.bus = AudioBus::Vocal;
+        }
+        traits.directional = ContainsAnyToken(tag, {"swing", "whoosh", "attack"});
+        traits.jump = ContainsAnyToken(tag, {"jump"});
+        if (MatchesAnyTag(tag, {"attack_window_open", "melee_window_open", "hitbox_on", "damage_window_open"})) {
+            traits.hitWindow = 1;
+        } else if (MatchesAnyTag(tag, {"attack_window_close", "melee_window_close", "hitbox_off", "damage_window_close"})) {
+            traits.hitWindow = -1;
+        }
+        return m_EventTraits.emplace(event.tagId, traits).first->second;
+    }
+
+    // The payload's clip, resolved against the project once per payload.
+    AudioClipHandle resolveEventAudioClip(const AnimationEvent& event) {
+        if (event.payloadId == kInvalidAnimationEventId) {
+            return kInvalidAudioClip;
         }
-        if (!event.payload.empty()) {
-            return "audio";
+        auto it = m_EventAudioClips.find(event.payloadId);
+        if (it != m_EventAudioClips.end()) {
+            return it->second;
         }
-        return {};
+        AudioClipHandle clip = AudioSystem::getInstance().loadClip(resolveEventAudioPath(event.payload));
+        m_EventAudioClips.emplace(event.payloadId, clip);
+        return clip;
     }
 
-    static std::string getEventTagLower(const AnimationEvent& event) {
-        if (!event.eventTag.empty()) {
-            return ToLower(event.eventTag);
+    // Decodes every clip the animation events can play when play starts, so the first of each does
+    // not hitch mid-game.
+    void preloadEventAudio() {
+        AudioSystem& audio = AudioSystem::getInstance();
+        if (!audio.isInitialized() || !m_PrimarySkinned) {
+            return;
+        }
+        for (const auto& clip : m_PrimarySkinned->getAnimationClips()) {
+            if (!clip) {
+                continue;
+            }
+            for (const auto& event : clip->getEvents()) {
+                if (isAudioEvent(event)) {
+                    audio.preloadClip(resolveEventAudioClip(event));
+                }
+            }
         }
-        return ToLower(event.name);
     }
 
     float nextAudioJitter(float amplitude) {
@@ -530,30 +640,21 @@ private:
         return std::max(0.01f, center + nextAudioJitter(amplitude));
     }
 
-    AudioBus resolveEventBus(const AnimationEvent& event) const {
-        std::string tag = getEventTagLower(event);
-        if (ContainsAnyToken(tag, {"vocal", "grunt", "man", "voice"})) {
-            return AudioBus::Vocal;
-        }
-        return AudioBus::SFX;
-    }
-
-    bool playConfiguredEventAudio(const AnimationEvent& event) {
-        std::string path = resolveEventAudioPath(event.payload);
-        if (path.empty()) {
+    bool playConfiguredEventAudio(const AnimationEvent& event, const EventTraits& traits) {
+        AudioClipHandle clip = resolveEventAudioClip(event);
+        if (clip == kInvalidAudioClip) {
             return false;
         }
         float volume = std::max(0.0f, event.volume);
         float pitch = resolveEventPitch(event);
-        AudioBus bus = resolveEventBus(event);
-        std::string tag = getEventTagLower(event);
+        AudioBus bus = traits.bus;
         if (!event.spatial) {
-            return AudioSystem::getInstance().playOneShot(path, bus, volume, pitch);
+            return AudioSystem::getInstance().playOneShot(clip, bus, volume, pitch);
         }
-        if (ContainsAnyToken(tag, {"swing", "whoosh", "attack"})) {
+        if (traits.directional) {
             Math::Vector3 forward = m_BodyTransform ? FlattenDirection(m_BodyTransform->forward()) : Math::Vector3(0.0f, 0.0f, -1.0f);
             return AudioSystem::getInstance().playOneShot3DDirectional(
-                path,
+                clip,
                 getAudioOrigin(1.1f),
                 forward,
                 bus,
@@ -568,8 +669,8 @@ private:
                 0.7f);
         }
         return AudioSystem::getInstance().playOneShot3D(
-            path,
-            getAudioOrigin(ContainsAnyToken(tag, {"jump"}) ? 1.0f : 1.1f),
+            clip,
+            getAudioOrigin(traits.jump ? 1.0f : 1.1f),
             bus,
             volume,
             pitch,
@@ -597,15 +698,14 @@ private:
     }
 
     void dispatchClipEvent(const AnimationEvent& event, int clipIndex) {
-        std::string type = getEventTypeLower(event);
-        std::string tag = getEventTagLower(event);
-        if (MatchesAnyTag(tag, {"attack_window_open", "melee_window_open", "hitbox_on", "damage_window_open"})) {
+        const EventTraits& traits = resolveEventTraits(event);
+        if (traits.hitWindow > 0) {
             beginAttackHitWindow();
-        } else if (MatchesAnyTag(tag, {"attack_window_close", "melee_window_close", "hitbox_off", "damage_window_close"})) {
+        } else if (traits.hitWindow < 0) {
             endAttackHitWindow();
         }
-        if (type == "audio" || !event.payload.empty()) {
-            playConfiguredEventAudio(event);
+        if (isAudioEvent(event)) {
+            playConfiguredEventAudio(event, traits);
         }
         (void)clipIndex;
     }
@@ -654,8 +754,7 @@ private:
             return false;
         }
         for (const auto& event : clip->getEvents()) {
-            std::string tag = getEventTagLower(event);
-            if (ContainsAnyToken(tag, tokens)) {
+            if (ContainsAnyToken(GetAnimationEventName(event.tagId), tokens)) {
                 return true;
             }
         }
@@ -827,15 +926,15 @@ private:
             if (m_Controller) {
                 m_Controller->clearWorldMoveDirection();
             }
+            clearChasePath();
             playStateClip(State::Idle, false, m_State != State::Idle);
             m_CurrentClipElapsed += deltaTime * m_CurrentClipPlaybackSpeed;
             m_StateElapsed += deltaTime;
             return;
         }
 
-        rotateToward(toPlayer, deltaTime);
-
         if (distance <= m_AttackRange && m_AttackCooldownTimer <= 0.0f && !m_ClipMapping.attacks.empty()) {
+            rotateToward(toPlayer, deltaTime);
             if (m_Controller) {
                 m_Controller->clearWorldMoveDirection();
             }
@@ -846,14 +945,18 @@ private:
         }
 
         if (distance <= m_DetectionRange || m_State == State::Chase) {
+            const Math::Vector3 moveDirection = chaseDirection(toPlayer, deltaTime);
+            rotateToward(moveDirection, deltaTime);
             if (m_Controller) {
-                m_Controller->setWorldMoveDirection(FlattenDirection(toPlayer, m_BodyTransform->forward()));
+                m_Controller->setWorldMoveDirection(moveDirection);
             }
             playStateClip(State::Chase, false, m_State != State::Chase);
         } else {
+            rotateToward(toPlayer, deltaTime);
             if (m_Controller) {
                 m_Controller->clearWorldMoveDirection();
             }
+            clearChasePath();
             playStateClip(State::Idle, false, m_State != State::Idle);
         }
 
@@ -861,6 +964,61 @@ private:
         m_StateElapsed += deltaTime;
     }
 
+    // Where to move while chasing: along a navigation path to the player when the scene has a
+    // grid, else straight at them, bent around nearby agents by the crowd. A path is requested
+    // again at most twice a second, once the player is a metre from where the last one led.
+    Math::Vector3 chaseDirection(const Math::Vector3& toPlayer, float deltaTime) {
+        NavigationSystem& navigation = NavigationSystem::getInstance();
+        Scene* scene = m_Entity->getScene();
+        const Math::Vector3 position = m_BodyTransform->getPosition();
+        Math::Vector3 direction = toPlayer;
+        if (navigation.getGrid(scene)) {
+            if (m_PathRequest != NavigationSystem::kInvalidPathRequest) {
+                std::vector<Math::Vector3> path;
+                const NavigationSystem::PathStatus status = navigation.takePath(m_PathRequest, path);
+                if (status != NavigationSystem::PathStatus::Pending) {
+                    m_PathRequest = NavigationSystem::kInvalidPathRequest;
+                    m_ChasePath = status == NavigationSystem::PathStatus::Ready ? std::move(path)
+                                                                                : std::vector<Math::Vector3>();
+                    m_ChasePathIndex = 1;
+                }
+            }
+            m_PathRefreshTimer -= deltaTime;
+            const Math::Vector3 goal = m_PlayerTransform->getPosition();
+            const Math::Vector3 goalOffset(goal.x - m_ChasePathGoal.x, 0.0f, goal.z - m_ChasePathGoal.z);
+            if (m_PathRequest == NavigationSystem::kInvalidPathRequest && m_PathRefreshTimer <= 0.0f &&
+                (m_ChasePath.empty() || goalOffset.lengthSquared() > 1.0f)) {
+                m_PathRequest = navigation.requestPath(scene, position, goal);
+                m_ChasePathGoal = goal;
+                m_PathRefreshTimer = 0.5f;
+            }
+            while (m_ChasePathIndex < m_ChasePath.size()) {
+                const Math::Vector3& waypoint = m_ChasePath[m_ChasePathIndex];
+                const Math::Vector3 offset(waypoint.x - position.x, 0.0f, waypoint.z - position.z);
+                if (offset.lengthSquared() > 0.25f || m_ChasePathIndex + 1 == m_ChasePath.size()) {
+                    direction = offset;
+                    break;
+                }
+                ++m_ChasePathIndex;
+            }
+        }
+        direction = FlattenDirection(direction, FlattenDirection(m_BodyTransform->forward()));
+        const float radius = m_Controller ? m_Controller->getRadius() : 0.4f;
+        const Math::Vector3 steered =
+            navigation.steerCrowdAgent(this, scene, position, direction * m_ChaseSpeed, radius);
+        return FlattenDirection(steered, direction);
+    }
+
+    void clearChasePath() {
+        if (m_PathRequest != NavigationSystem::kInvalidPathRequest) {
+            NavigationSystem::getInstance().cancelPath(m_PathRequest);
+            m_PathRequest = NavigationSystem::kInvalidPathRequest;
+        }
+        m_ChasePath.clear();
+        m_ChasePathIndex = 0;
+        m_PathRefreshTimer = 0.0f;
+    }
+
     void updateHit(float deltaTime) {
         Math::Vector3 toPlayer = Math::Vector3::Zero;
         horizontalDistanceToPlayer(&toPlayer);
@@ -904,44 +1062,21 @@ private:
         }
     }
 
-    std::string resolveSkeletonBoneName(const Skeleton& skeleton,
-                                        const std::vector<std::string>& candidates) const {
-        const auto& bones = skeleton.getBones();
-        for (const auto& candidate : candidates) {
-            std::string desired = ToLower(candidate);
-            std::string normalizedDesired;
-            for (char c : desired) {
-                if (std::isalnum(static_cast<unsigned char>(c))) {
-                    normalizedDesired.push_back(c);
-                }
-            }
-            for (const auto& bone : bones) {
-                std::string boneLower = ToLower(bone.name);
-                if (boneLower == desired) {
-                    return bone.name;
-                }
-                std::string normalizedBone;
-                for (char c : boneLower) {
-                    if (std::isalnum(static_cast<unsigned char>(c))) {
-                        normalizedBone.push_back(c);
-                    }
-                }
-                if (!normalizedDesired.empty() && normalizedBone == normalizedDesired) {
-                    return bone.name;
-                }
-            }
-        }
-        return {};
-    }
-
+    // Resolved once per skeleton.
     int resolveAttackBoneIndex(const Skeleton& skeleton) const {
-        std::string boneName = resolveSkeletonBoneName(
-            skeleton,
-            {"mixamorig:RightHand", "RightHand", "Hand_R", "righthand", "weapon_r", "mixamorig:RightForeArm", "RightForeArm"});
-        if (boneName.empty()) {
-            return -1;
+        if (m_AttackBoneSkeleton == &skeleton && m_AttackBoneCount == skeleton.getBoneCount()) {
+            return m_AttackBoneIndex;
+        }
+        m_AttackBoneSkeleton = &skeleton;
+        m_AttackBoneCount = skeleton.getBoneCount();
+        m_AttackBoneIndex = -1;
+        for (const char* candidate : {"mixamorig:RightHand", "RightHand", "Hand_R", "weapon_r", "mixamorig:RightForeArm", "RightForeArm"}) {
+            m_AttackBoneIndex = skeleton.findBoneIndex(candidate);
+            if (m_AttackBoneIndex >= 0) {
+                break;
+            }
         }
-        return skeleton.getBoneIndex(boneName);
+        return m_AttackBoneIndex;
     }
 
     bool computeAttackBoneWorld(Math::Matrix4x4& outBoneWorld) const {
@@ -1016,42 +1151,54 @@ private:
         return m_State == State::Attack && !m_AttackWindowUsesEvents;
     }
 
-    void applyAttackHitAtPoint(const Math::Vector3& point) {
-        if (!m_Entity || !m_Entity->getScene()) {
+    // Queues an overlap at one point of the attack sweep; applyAttackHits runs them.
+    void queueAttackHitAtPoint(const Math::Vector3& point) {
+        m_AttackHitQueries.addOverlapSphere(point,
+                                            m_AttackHitRadius,
+                                            m_AttackMask,
+                                            m_AttackHitTriggers,
+                                            resolveDamageTarget(m_Entity));
+    }
+
+    // Runs the queued sweep points as one batch and damages what they touched, in sweep order.
+    void applyAttackHits() {
+        if (m_AttackHitQueries.empty()) {
             return;
         }
-
-        std::vector<PhysicsOverlapHit> hits;
-        if (m_Entity->getScene()->getPhysicsWorld()->overlapSphere(
-                point,
-                m_AttackHitRadius,
-                hits,
-                m_AttackMask,
-                m_AttackHitTriggers,
-                resolveDamageTarget(m_Entity)) <= 0) {
+        if (!m_Entity || !m_Entity->getScene() || !m_Entity->getScene()->getPhysicsWorld()) {
+            m_AttackHitQueries.clear();
             return;
         }
+        m_Entity->getScene()->getPhysicsWorld()->runQueries(m_AttackHitQueries);
 
         Entity* selfEntity = resolveDamageTarget(m_Entity);
-        for (const auto& hit : hits) {
-            Entity* target = resolveDamageTarget(hit.entity);
-            if (!target || target == selfEntity) {
-                continue;
+        for (uint32_t query = 0; query < m_AttackHitQueries.size(); ++query) {
+            const PhysicsOverlapHit* hits = m_AttackHitQueries.getOverlapHits(query);
+            for (uint32_t h = 0; h < m_AttackHitQueries.getHitCount(query); ++h) {
+                applyAttackHitTo(hits[h].entity, selfEntity);
             }
+        }
+        m_AttackHitQueries.clear();
+    }
 
-            UUID targetUUID = target->getUUID();
-            if (m_AttackVictims.find(targetUUID) != m_AttackVictims.end()) {
-                continue;
-            }
+    void applyAttackHitTo(Entity* hitEntity, Entity* selfEntity) {
+        Entity* target = resolveDamageTarget(hitEntity);
+        if (!target || target == selfEntity) {
+            return;
+        }
 
-            Health* health = target->getComponent<Health>();
-            if (!health || health->isDead()) {
-                continue;
-            }
+        UUID targetUUID = target->getUUID();
+        if (m_AttackVictims.find(targetUUID) != m_AttackVictims.end()) {
+            return;
+        }
 
-            m_AttackVictims.insert(targetUUID);
-            health->applyDamage(m_AttackDamage);
+        Health* health = target->getComponent<Health>();
+        if (!health || health->isDead()) {
+            return;
         }
+
+        m_AttackVictims.insert(targetUUID);
+        health->applyDamage(m_AttackDamage);
     }
 
     void updateAttackHitTrace(float deltaTime) {
@@ -1084,8 +1231,9 @@ private:
         int steps = std::max(1, static_cast<int>(std::ceil(distance / std::max(0.05f, m_AttackHitRadius * 0.5f))));
         for (int i = 1; i <= steps; ++i) {
             float t = static_cast<float>(i) / static_cast<float>(steps);
-            applyAttackHitAtPoint(Math::Vector3::Lerp(m_AttackPreviousCenter, center, t));
+            queueAttackHitAtPoint(Math::Vector3::Lerp(m_AttackPreviousCenter, center, t));
         }
+        applyAttackHits();
 
         m_AttackPreviousCenter = center;
         (void)deltaTime;
@@ -1140,8 +1288,13 @@ private:
     Animator* m_Animator = nullptr;
     SkinnedMeshRenderer* m_PrimarySkinned = nullptr;
     std::vector<SkinnedMeshRenderer*> m_SkinnedTargets;
+    int m_DependencyRetryFrames = 0;
+    mutable const Skeleton* m_AttackBoneSkeleton = nullptr;
+    mutable uint32_t m_AttackBoneCount = 0;
+    mutable int m_AttackBoneIndex = -1;
 
     Entity* m_Player = nullptr;
+    UUID m_PlayerId = UUID::Invalid();
     Transform* m_PlayerTransform = nullptr;
     Health* m_PlayerHealth = nullptr;
     float m_PlayerRefreshTimer = 0.0f;
@@ -1168,6 +1321,8 @@ private:
     int m_HitClipCursor = 0;
 
     int m_EventClipIndex = -1;
+    std::unordered_map<AnimationEventId, EventTraits> m_EventTraits;
+    std::unordered_map<AnimationEventId, AudioClipHandle> m_EventAudioClips;
     float m_EventClipPrevTime = 0.0f;
     float m_EventClipTime = 0.0f;
     bool m_EventClipLooping = false;
@@ -1178,7 +1333,17 @@ private:
     bool m_AttackHitSweepInitialized = false;
     Math::Vector3 m_AttackPreviousCenter = Math::Vector3::Zero;
     std::unordered_set<UUID> m_AttackVictims;
+    PhysicsQueryBatch m_AttackHitQueries;
     int m_AudioVariationCounter = 0;
+
+    AIUpdateScheduler::AgentId m_AIAgent = AIUpdateScheduler::kInvalidAgent;
+    float m_PendingThinkTime = 0.0f;
+
+    NavigationSystem::PathRequestId m_PathRequest = NavigationSystem::kInvalidPathRequest;
+    std::vector<Math::Vector3> m_ChasePath;
+    size_t m_ChasePathIndex = 0;
+    Math::Vector3 m_ChasePathGoal = Math::Vector3::Zero;
+    float m_PathRefreshTimer = 0.0f;
 };
 
 inline Entity* EnemyController::findPlayerEntity() const {
@@ -1189,17 +1354,9 @@ inline Entity* EnemyController::findPlayerEntity() const {
     if (!scene) {
         return nullptr;
     }
-
-    for (const auto& handle : scene->getAllEntities()) {
-        Entity* entity = handle.get();
-        if (!entity || entity == m_Entity || !entity->isActiveInHierarchy()) {
-            continue;
-        }
-        if (entity->getComponent<ThirdPersonController>()) {
-            return entity;
-        }
-    }
-    return nullptr;
+    // One lookup shared by every enemy in the frame.
+    Entity* player = AIUpdateScheduler::getInstance().findPlayer(scene);
+    return player != m_Entity ? player : nullptr;
 }
 
 } // namespace Crescent
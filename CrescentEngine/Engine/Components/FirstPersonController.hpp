@@ -17,6 +17,7 @@
 #include "../Components/Light.hpp"
 #include "../Components/MeshRenderer.hpp"
 #include "../Core/Engine.hpp"
+#include "../Core/Time.hpp"
 #include "../Renderer/Renderer.hpp"
 #include "../Rendering/Material.hpp"
 #include "../Rendering/Mesh.hpp"
@@ -134,6 +135,34 @@ public:
         loadMuzzleTexture();
     }
 
+    // Settings only; dependencies, look angles and the muzzle flash are set up again in OnCreate.
+    std::unique_ptr<Component> clone() const override {
+        auto copy = std::make_unique<FirstPersonController>();
+        copy->m_MouseSensitivity = m_MouseSensitivity;
+        copy->m_InvertY = m_InvertY;
+        copy->m_RequireLookButton = m_RequireLookButton;
+        copy->m_LookButton = m_LookButton;
+        copy->m_MinPitch = m_MinPitch;
+        copy->m_MaxPitch = m_MaxPitch;
+        copy->m_WalkSpeed = m_WalkSpeed;
+        copy->m_SprintMultiplier = m_SprintMultiplier;
+        copy->m_EnableSprint = m_EnableSprint;
+        copy->m_EnableCrouch = m_EnableCrouch;
+        copy->m_CrouchHeight = m_CrouchHeight;
+        copy->m_CrouchEyeHeight = m_CrouchEyeHeight;
+        copy->m_CrouchSpeed = m_CrouchSpeed;
+        copy->m_EyeHeight = m_EyeHeight;
+        copy->m_UseEyeHeight = m_UseEyeHeight;
+        copy->m_DriveCharacterController = m_DriveCharacterController;
+        copy->m_FireCooldown = m_FireCooldown;
+        copy->m_FireDamage = m_FireDamage;
+        copy->m_FireRange = m_FireRange;
+        copy->m_FireHitMask = m_FireHitMask;
+        copy->m_FireHitTriggers = m_FireHitTriggers;
+        copy->m_MuzzleTexturePath = m_MuzzleTexturePath;
+        return detachClone(std::move(copy));
+    }
+
     void OnCreate() override {
         findDependencies();
         initializeLook();
@@ -208,6 +237,7 @@ public:
         }
 
         applyRotation();
+        updateLookLatch(lookAllowed);
         applyCameraHeight(deltaTime, input);
         driveCharacter(deltaTime, input);
         updateAnimation(deltaTime, input);
@@ -540,7 +570,17 @@ private:
     }
 
     void updateAnimation(float deltaTime, InputManager& input) {
-        if (!m_AnimInitialized || (!m_Animator && m_AnimTargets.empty())) {
+        // Targets are bound once; a rig without any is searched for again at most every
+        // kAnimRetryFrames, since the search walks the hierarchy and re-matches every clip name.
+        static constexpr int kAnimRetryFrames = 30;
+        if (!m_AnimInitialized) {
+            refreshAnimationTargets();
+        } else if (!m_Animator && m_AnimTargets.empty()) {
+            if (m_AnimRetryFrames > 0) {
+                --m_AnimRetryFrames;
+                return;
+            }
+            m_AnimRetryFrames = kAnimRetryFrames;
             refreshAnimationTargets();
         }
         if (!m_Animator && m_AnimTargets.empty()) {
@@ -1119,6 +1159,23 @@ private:
         m_CameraTransform->setLocalRotation(pitchQuat);
     }
 
+    void updateLookLatch(bool lookAllowed) {
+        Camera* camera = m_CameraTransform->getEntity() ? m_CameraTransform->getEntity()->getComponent<Camera>() : nullptr;
+        if (!camera) {
+            return;
+        }
+        Camera::LookLatch latch;
+        if (lookAllowed) {
+            latch.yawPerUnit = -m_MouseSensitivity;
+            latch.pitchPerUnit = -m_MouseSensitivity * (m_InvertY ? -1.0f : 1.0f);
+            latch.pitch = m_Pitch;
+            latch.minPitch = m_MinPitch * Math::DEG_TO_RAD;
+            latch.maxPitch = m_MaxPitch * Math::DEG_TO_RAD;
+            latch.frame = Time::frameCount();
+        }
+        camera->setLookLatch(latch);
+    }
+
     void applyCameraHeight(float deltaTime, InputManager& input) {
         if (!m_Controller || !m_CameraTransform || !m_UseEyeHeight) {
             return;
@@ -1216,6 +1273,7 @@ private:
     bool m_LeftMouseWasDown = false;
     inline static std::atomic<uint64_t> s_FireEventCounter{0};
     bool m_AnimInitialized = false;
+    int m_AnimRetryFrames = 0;
     bool m_AnimatorParamsResolved = false;
     bool m_AnimatorHasMoveParam = false;
     bool m_AnimatorHasFireParam = false;
@@ -0,0 +1,60 @@
+#include "FoliageScatter.hpp"
+#include <algorithm>
+
+namespace Crescent {
+
+FoliageScatter::FoliageScatter()
+    : m_Density(0.5f)
+    , m_TileSize(16.0f)
+    , m_ViewDistance(80.0f)
+    , m_MinScale(0.8f)
+    , m_MaxScale(1.2f)
+    , m_MaxSlopeDegrees(35.0f)
+    , m_AlignToNormal(0.0f)
+    , m_Seed(1)
+    , m_CastShadows(false)
+    , m_ReceiveShadows(true)
+    , m_Version(1) {}
+
+void FoliageScatter::setMesh(std::shared_ptr<Mesh> mesh) {
+    m_Mesh = std::move(mesh);
+    ++m_Version;
+}
+
+void FoliageScatter::setDensity(float density) {
+    m_Density = std::max(0.0f, density);
+    ++m_Version;
+}
+
+void FoliageScatter::setDensityMap(const std::shared_ptr<Texture2D>& texture) {
+    m_DensityMap = texture;
+    ++m_Version;
+}
+
+void FoliageScatter::setTileSize(float size) {
+    m_TileSize = std::max(1.0f, size);
+    ++m_Version;
+}
+
+void FoliageScatter::setScaleRange(float minScale, float maxScale) {
+    m_MinScale = std::max(0.01f, minScale);
+    m_MaxScale = std::max(m_MinScale, maxScale);
+    ++m_Version;
+}
+
+void FoliageScatter::setMaxSlopeDegrees(float degrees) {
+    m_MaxSlopeDegrees = Math::Clamp(degrees, 0.0f, 90.0f);
+    ++m_Version;
+}
+
+void FoliageScatter::setAlignToNormal(float align) {
+    m_AlignToNormal = Math::Clamp(align, 0.0f, 1.0f);
+    ++m_Version;
+}
+
+void FoliageScatter::setSeed(uint32_t seed) {
+    m_Seed = seed;
+    ++m_Version;
+}
+
+} // namespace Crescent
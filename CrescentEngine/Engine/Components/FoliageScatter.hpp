@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../ECS/Component.hpp"
+#include "../Rendering/Mesh.hpp"
+#include "../Rendering/Material.hpp"
+#include "../Rendering/Texture.hpp"
+#include <cstdint>
+#include <memory>
+
+namespace Crescent {
+
+// FoliageScatter - vegetation grown on the entity's terrain (its MeshRenderer holds a sculpted
+// terrain plane, see BuildTerrainHeightField). There are no instance lists: the renderer scatters
+// instances on the GPU tile by tile around the camera (Renderer/FoliageSystem.hpp), places them on
+// the terrain heights and picks mesh or billboard per instance while culling. The material's
+// billboard range, when set, is where instances switch to the impostor quad.
+class FoliageScatter : public Component {
+public:
+    FoliageScatter();
+    virtual ~FoliageScatter() = default;
+
+    COMPONENT_TYPE(FoliageScatter)
+    COMPONENT_CLONE_BY_COPY(FoliageScatter)
+
+    std::shared_ptr<Mesh> getMesh() const { return m_Mesh; }
+    void setMesh(std::shared_ptr<Mesh> mesh);
+
+    std::shared_ptr<Material> getMaterial() const { return m_Material; }
+    void setMaterial(std::shared_ptr<Material> material) { m_Material = std::move(material); }
+
+    // Instances per square metre where the density map is white.
+    float getDensity() const { return m_Density; }
+    void setDensity(float density);
+
+    // Red channel scales the density across the terrain's extent; none means uniform.
+    const std::shared_ptr<Texture2D>& getDensityMap() const { return m_DensityMap; }
+    void setDensityMap(const std::shared_ptr<Texture2D>& texture);
+
+    // Side of a streamed tile, in terrain units.
+    float getTileSize() const { return m_TileSize; }
+    void setTileSize(float size);
+
+    // Instances farther from the camera are not drawn, and tiles beyond it are not kept.
+    float getViewDistance() const { return m_ViewDistance; }
+    void setViewDistance(float distance) { m_ViewDistance = std::max(1.0f, distance); }
+
+    float getMinScale() const { return m_MinScale; }
+    float getMaxScale() const { return m_MaxScale; }
+    void setScaleRange(float minScale, float maxScale);
+
+    // Steepest terrain slope that still grows instances.
+    float getMaxSlopeDegrees() const { return m_MaxSlopeDegrees; }
+    void setMaxSlopeDegrees(float degrees);
+
+    // 0 grows straight up, 1 along the terrain normal.
+    float getAlignToNormal() const { return m_AlignToNormal; }
+    void setAlignToNormal(float align);
+
+    uint32_t getSeed() const { return m_Seed; }
+    void setSeed(uint32_t seed);
+
+    // Shadows draw the full mesh for every resident instance, so they are off by default.
+    bool getCastShadows() const { return m_CastShadows; }
+    void setCastShadows(bool cast) { m_CastShadows = cast; }
+
+    bool getReceiveShadows() const { return m_ReceiveShadows; }
+    void setReceiveShadows(bool receive) { m_ReceiveShadows = receive; }
+
+    // Changes with every setting that moves instances; the renderer scatters its tiles again.
+    uint64_t getVersion() const { return m_Version; }
+    // For terrain edits: the heights are read again and every tile is scattered again.
+    void refresh() { ++m_Version; }
+
+private:
+    std::shared_ptr<Mesh> m_Mesh;
+    std::shared_ptr<Material> m_Material;
+    std::shared_ptr<Texture2D> m_DensityMap;
+    float m_Density;
+    float m_TileSize;
+    float m_ViewDistance;
+    float m_MinScale;
+    float m_MaxScale;
+    float m_MaxSlopeDegrees;
+    float m_AlignToNormal;
+    uint32_t m_Seed;
+    bool m_CastShadows;
+    bool m_ReceiveShadows;
+    uint64_t m_Version;
+};
+
+} // namespace Crescent
@@ -1,4 +1,6 @@
 #include "HLODProxy.hpp"
+#include "../ECS/Entity.hpp"
+#include "../Scene/Scene.hpp"
 
 namespace Crescent {
 
@@ -8,4 +10,36 @@ HLODProxy::HLODProxy()
     , m_Enabled(true) {
 }
 
+void HLODProxy::setSourceUuids(const std::vector<UUID>& uuids) {
+    m_SourceUuids = uuids;
+    markSwitchDirty();
+}
+
+void HLODProxy::addSourceUuid(UUID uuid) {
+    m_SourceUuids.push_back(uuid);
+    markSwitchDirty();
+}
+
+void HLODProxy::setLodStart(float start) {
+    m_LodStart = start;
+    markSwitchDirty();
+}
+
+void HLODProxy::setLodEnd(float end) {
+    m_LodEnd = end;
+    markSwitchDirty();
+}
+
+void HLODProxy::setEnabled(bool enabled) {
+    m_Enabled = enabled;
+    markSwitchDirty();
+}
+
+void HLODProxy::markSwitchDirty() {
+    Entity* entity = getEntity();
+    if (entity && entity->getScene()) {
+        entity->getScene()->markHLODDirty();
+    }
+}
+
 } // namespace Crescent
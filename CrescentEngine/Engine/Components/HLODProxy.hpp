@@ -1,7 +1,8 @@
 #pragma once
 
+#include "../Core/UUID.hpp"
 #include "../ECS/Component.hpp"
-#include <string>
+#include <cstdint>
 #include <vector>
 
 namespace Crescent {
@@ -12,26 +13,41 @@ public:
     virtual ~HLODProxy() = default;
 
     COMPONENT_TYPE(HLODProxy)
+    COMPONENT_POOLED(HLODProxy)
+    COMPONENT_CLONE_BY_COPY(HLODProxy)
 
-    void setSourceUuids(const std::vector<std::string>& uuids) { m_SourceUuids = uuids; }
-    const std::vector<std::string>& getSourceUuids() const { return m_SourceUuids; }
+    // The entities the proxy's merged mesh stands in for, hidden while it is active. Sources may
+    // be proxies of a lower level themselves. Setters mark the scene's HLODSwitch for a rebuild.
+    void setSourceUuids(const std::vector<UUID>& uuids);
+    const std::vector<UUID>& getSourceUuids() const { return m_SourceUuids; }
 
-    void addSourceUuid(const std::string& uuid) { m_SourceUuids.push_back(uuid); }
+    void addSourceUuid(UUID uuid);
 
-    void setLodStart(float start) { m_LodStart = start; }
+    void setLodStart(float start);
     float getLodStart() const { return m_LodStart; }
 
-    void setLodEnd(float end) { m_LodEnd = end; }
+    void setLodEnd(float end);
     float getLodEnd() const { return m_LodEnd; }
 
-    void setEnabled(bool enabled) { m_Enabled = enabled; }
+    // The camera distance from the proxy's bounds centre beyond which it replaces its sources.
+    float getActivationDistance() const { return m_LodEnd > m_LodStart + 0.01f ? m_LodEnd : m_LodStart; }
+
+    void setEnabled(bool enabled);
     bool isEnabled() const { return m_Enabled; }
 
+    // 0 for proxies built by hand (SceneCommands::buildHLOD); 1 and up for the levels of the
+    // cluster hierarchy SceneCommands::buildHLODClusters generates and replaces.
+    void setLevel(uint32_t level) { m_Level = level; }
+    uint32_t getLevel() const { return m_Level; }
+
 private:
-    std::vector<std::string> m_SourceUuids;
+    void markSwitchDirty();
+
+    std::vector<UUID> m_SourceUuids;
     float m_LodStart;
     float m_LodEnd;
     bool m_Enabled;
+    uint32_t m_Level = 0;
 };
 
 } // namespace Crescent
@@ -10,6 +10,7 @@ namespace Crescent {
 class Health : public Component {
 public:
     COMPONENT_TYPE(Health)
+    COMPONENT_CLONE_BY_COPY(Health)
 
     Health() = default;
     virtual ~Health() = default;
@@ -1,4 +1,5 @@
 #include "IKConstraint.hpp"
+#include "../Animation/Skeleton.hpp"
 
 namespace Crescent {
 
@@ -8,9 +9,27 @@ IKConstraint::IKConstraint()
     , m_EndBone("")
     , m_TargetPosition(0.0f, 0.0f, 0.0f)
     , m_TargetEntityUUID("")
+    , m_TargetEntityId(UUID::Invalid())
     , m_TargetOffset(0.0f, 0.0f, 0.0f)
     , m_TargetInWorld(true)
     , m_Weight(1.0f) {
 }
 
+void IKConstraint::setTargetEntityUUID(const std::string& uuid) {
+    m_TargetEntityUUID = uuid;
+    m_TargetEntityId = uuid.empty() ? UUID::Invalid() : UUID::fromString(uuid);
+}
+
+const IKConstraint::BoneBinding& IKConstraint::bind(const Skeleton& skeleton) {
+    if (m_Binding.skeleton == &skeleton && m_Binding.boneCount == skeleton.getBoneCount()) {
+        return m_Binding;
+    }
+    m_Binding.skeleton = &skeleton;
+    m_Binding.boneCount = skeleton.getBoneCount();
+    m_Binding.root = skeleton.getBoneIndex(m_RootBone);
+    m_Binding.mid = skeleton.getBoneIndex(m_MidBone);
+    m_Binding.end = skeleton.getBoneIndex(m_EndBone);
+    return m_Binding;
+}
+
 } // namespace Crescent
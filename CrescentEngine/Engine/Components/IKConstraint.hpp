@@ -1,32 +1,39 @@
 #pragma once
 
 #include "../ECS/Component.hpp"
+#include "../Core/UUID.hpp"
 #include "../Math/Math.hpp"
+#include <cstdint>
 #include <string>
 
 namespace Crescent {
 
+class Skeleton;
+
 class IKConstraint : public Component {
 public:
     IKConstraint();
     virtual ~IKConstraint() = default;
 
     COMPONENT_TYPE(IKConstraint)
+    COMPONENT_CLONE_BY_COPY(IKConstraint)
 
     const std::string& getRootBone() const { return m_RootBone; }
-    void setRootBone(const std::string& name) { m_RootBone = name; }
+    void setRootBone(const std::string& name) { m_RootBone = name; m_Binding.skeleton = nullptr; }
 
     const std::string& getMidBone() const { return m_MidBone; }
-    void setMidBone(const std::string& name) { m_MidBone = name; }
+    void setMidBone(const std::string& name) { m_MidBone = name; m_Binding.skeleton = nullptr; }
 
     const std::string& getEndBone() const { return m_EndBone; }
-    void setEndBone(const std::string& name) { m_EndBone = name; }
+    void setEndBone(const std::string& name) { m_EndBone = name; m_Binding.skeleton = nullptr; }
 
     const Math::Vector3& getTargetPosition() const { return m_TargetPosition; }
     void setTargetPosition(const Math::Vector3& position) { m_TargetPosition = position; }
 
     const std::string& getTargetEntityUUID() const { return m_TargetEntityUUID; }
-    void setTargetEntityUUID(const std::string& uuid) { m_TargetEntityUUID = uuid; }
+    void setTargetEntityUUID(const std::string& uuid);
+    // The target entity parsed once from its UUID string; invalid when no target is set.
+    UUID getTargetEntityId() const { return m_TargetEntityId; }
 
     const Math::Vector3& getTargetOffset() const { return m_TargetOffset; }
     void setTargetOffset(const Math::Vector3& offset) { m_TargetOffset = offset; }
@@ -37,15 +44,29 @@ public:
     float getWeight() const { return m_Weight; }
     void setWeight(float weight) { m_Weight = Math::Clamp(weight, 0.0f, 1.0f); }
 
+    // Bone indices of the chain on one skeleton; -1 for a bone the skeleton lacks.
+    struct BoneBinding {
+        const Skeleton* skeleton = nullptr;
+        uint32_t boneCount = 0;
+        int root = -1;
+        int mid = -1;
+        int end = -1;
+    };
+    // Resolves the bone names the first time a skeleton is seen and after a name changes, so the
+    // per-frame solve only compares a pointer.
+    const BoneBinding& bind(const Skeleton& skeleton);
+
 private:
     std::string m_RootBone;
     std::string m_MidBone;
     std::string m_EndBone;
     Math::Vector3 m_TargetPosition;
     std::string m_TargetEntityUUID;
+    UUID m_TargetEntityId;
     Math::Vector3 m_TargetOffset;
     bool m_TargetInWorld;
     float m_Weight;
+    BoneBinding m_Binding;
 };
 
 } // namespace Crescent
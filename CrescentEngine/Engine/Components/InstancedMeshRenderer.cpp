@@ -1,12 +1,26 @@
 #include "InstancedMeshRenderer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 
 namespace Crescent {
 
+namespace {
+    uint64_t NextInstanceVersion() {
+        static std::atomic<uint64_t> version{0};
+        return version.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+}
+
 InstancedMeshRenderer::InstancedMeshRenderer()
     : m_Mesh(nullptr)
+    , m_VertexAnimationSpeed(1.0f)
+    , m_VertexAnimationTimeSpread(1.0f)
+    , m_InstanceVersion(NextInstanceVersion())
     , m_CastShadows(true)
     , m_ReceiveShadows(true) {
     m_Materials.push_back(Material::CreateDefault());
+    m_DirtyInstances.sinceVersion = m_InstanceVersion;
 }
 
 void InstancedMeshRenderer::setMesh(std::shared_ptr<Mesh> mesh) {
@@ -37,18 +51,173 @@ std::shared_ptr<Material> InstancedMeshRenderer::getMaterial(uint32_t index) con
 
 void InstancedMeshRenderer::clearInstances() {
     m_Instances.clear();
+    m_CrowdStates.clear();
+    markInstancesDirty(0, 0);
 }
 
 void InstancedMeshRenderer::addInstance(const Math::Matrix4x4& localTransform) {
     m_Instances.push_back(localTransform);
+    m_CrowdStates.resize(m_Instances.size());
+    markInstancesDirty(getInstanceCount() - 1, getInstanceCount());
 }
 
 void InstancedMeshRenderer::setInstances(const std::vector<Math::Matrix4x4>& localTransforms) {
     m_Instances = localTransforms;
+    m_CrowdStates.resize(m_Instances.size());
+    markInstancesDirty(0, getInstanceCount());
+}
+
+void InstancedMeshRenderer::setInstance(uint32_t index, const Math::Matrix4x4& localTransform) {
+    if (index >= m_Instances.size()) {
+        return;
+    }
+    m_Instances[index] = localTransform;
+    markInstancesDirty(index, index + 1);
+}
+
+void InstancedMeshRenderer::clearDirtyInstances() {
+    m_DirtyInstances = InstanceDirtyRange{};
+    m_DirtyInstances.sinceVersion = m_InstanceVersion;
+}
+
+void InstancedMeshRenderer::markInstancesDirty(uint32_t begin, uint32_t end) {
+    m_InstanceVersion = NextInstanceVersion();
+    if (m_DirtyInstances.begin == m_DirtyInstances.end) {
+        m_DirtyInstances.begin = begin;
+        m_DirtyInstances.end = end;
+    } else if (begin < end) {
+        m_DirtyInstances.begin = std::min(m_DirtyInstances.begin, begin);
+        m_DirtyInstances.end = std::max(m_DirtyInstances.end, end);
+    }
+}
+
+void InstancedMeshRenderer::setSkeleton(std::shared_ptr<Skeleton> skeleton) {
+    m_Skeleton = skeleton;
+    if (m_Skeleton) {
+        for (const auto& clip : m_Clips) {
+            if (clip) {
+                clip->rebindToSkeleton(*m_Skeleton);
+            }
+        }
+    }
+}
+
+void InstancedMeshRenderer::setAnimationClips(const std::vector<std::shared_ptr<AnimationClip>>& clips) {
+    m_Clips = clips;
+    const int clipCount = static_cast<int>(m_Clips.size());
+    for (auto& state : m_CrowdStates) {
+        if (state.clip >= clipCount) {
+            state.clip = -1;
+        }
+        if (state.previousClip >= clipCount) {
+            state.previousClip = -1;
+            state.fade = 1.0f;
+        }
+    }
+    setSkeleton(m_Skeleton);
+}
+
+bool InstancedMeshRenderer::hasCrowdAnimation() const {
+    return m_Skeleton && m_Skeleton->getBoneCount() > 0 && !m_Clips.empty() && m_Mesh && m_Mesh->hasSkinWeights();
+}
+
+void InstancedMeshRenderer::playInstanceClip(uint32_t instance, int clip, float fadeSeconds, float startTime) {
+    if (instance >= m_CrowdStates.size() || clip >= static_cast<int>(m_Clips.size())) {
+        return;
+    }
+    CrowdInstanceState& state = m_CrowdStates[instance];
+    if (fadeSeconds > 0.0f && state.clip >= 0 && state.clip != clip) {
+        state.previousClip = state.clip;
+        state.previousTime = state.time;
+        state.fade = 0.0f;
+        state.fadeDuration = fadeSeconds;
+    } else {
+        state.previousClip = -1;
+        state.fade = 1.0f;
+    }
+    state.clip = clip;
+    state.time = startTime;
+}
+
+void InstancedMeshRenderer::playClipOnAll(int clip, float fadeSeconds, float timeSpread) {
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_CrowdStates.size()); ++i) {
+        // Golden-ratio sequence: evenly spread offsets whatever the instance count.
+        const float offset = timeSpread * std::fmod(static_cast<float>(i) * 0.6180339887f, 1.0f);
+        playInstanceClip(i, clip, fadeSeconds, offset);
+    }
+}
+
+void InstancedMeshRenderer::setInstanceSpeed(uint32_t instance, float speed) {
+    if (instance < m_CrowdStates.size()) {
+        m_CrowdStates[instance].speed = speed;
+    }
+}
+
+void InstancedMeshRenderer::setVertexAnimation(const VertexAnimationTexture& animation) {
+    m_VertexAnimation = animation;
+    markInstancesDirty(0, getInstanceCount());
+}
+
+void InstancedMeshRenderer::setVertexAnimationSpeed(float speed) {
+    m_VertexAnimationSpeed = speed;
+    markInstancesDirty(0, getInstanceCount());
+}
+
+void InstancedMeshRenderer::setVertexAnimationTimeSpread(float spread) {
+    m_VertexAnimationTimeSpread = spread;
+    markInstancesDirty(0, getInstanceCount());
+}
+
+bool InstancedMeshRenderer::hasVertexAnimation() const {
+    // The texture is indexed by vertex, so it only fits the mesh it was baked from.
+    return m_VertexAnimation.isValid() && m_Mesh && m_Mesh->getVertexCount() == m_VertexAnimation.vertexCount;
+}
+
+float InstancedMeshRenderer::getVertexAnimationOffset(uint32_t instance) const {
+    const float spread = std::clamp(m_VertexAnimationTimeSpread, 0.0f, 1.0f);
+    return spread * m_VertexAnimation.durationSeconds * std::fmod(static_cast<float>(instance) * 0.6180339887f, 1.0f);
 }
 
 void InstancedMeshRenderer::OnCreate() {}
 
 void InstancedMeshRenderer::OnDestroy() {}
 
+void InstancedMeshRenderer::OnUpdate(float deltaTime) {
+    OnAnimationEvaluate(deltaTime);
+}
+
+void InstancedMeshRenderer::OnAnimationEvaluate(float deltaTime) {
+    if (!hasCrowdAnimation()) {
+        return;
+    }
+    // Looping times wrap here so they keep their precision over long sessions; the GPU resolves
+    // them to frames.
+    auto advance = [&](int clipIndex, float& time, float step, bool looping) {
+        time += step;
+        const AnimationClip* clip = m_Clips[static_cast<size_t>(clipIndex)].get();
+        const float duration = clip ? clip->getDurationSeconds() : 0.0f;
+        if (looping && duration > 0.0f && (time >= duration || time < 0.0f)) {
+            time = std::fmod(time, duration);
+            if (time < 0.0f) {
+                time += duration;
+            }
+        }
+    };
+    for (auto& state : m_CrowdStates) {
+        if (state.clip < 0) {
+            continue;
+        }
+        const float step = deltaTime * state.speed;
+        advance(state.clip, state.time, step, state.looping);
+        if (state.previousClip >= 0) {
+            advance(state.previousClip, state.previousTime, step, state.looping);
+            state.fade = state.fadeDuration > 0.0f ? state.fade + deltaTime / state.fadeDuration : 1.0f;
+            if (state.fade >= 1.0f) {
+                state.fade = 1.0f;
+                state.previousClip = -1;
+            }
+        }
+    }
+}
+
 } // namespace Crescent
@@ -3,11 +3,27 @@
 #include "../ECS/Component.hpp"
 #include "../Rendering/Mesh.hpp"
 #include "../Rendering/Material.hpp"
+#include "../Animation/Skeleton.hpp"
+#include "../Animation/AnimationClip.hpp"
+#include "../Animation/VertexAnimationTexture.hpp"
 #include <vector>
 #include <memory>
 
 namespace Crescent {
 
+// Playback of one instance of an animated crowd. Times are in seconds.
+struct CrowdInstanceState {
+    int clip = -1; // index into the renderer's clips; -1 holds the bind pose
+    float time = 0.0f;
+    float speed = 1.0f;
+    bool looping = true;
+    // Clip faded out by the last playInstanceClip(), and how far the fade is (1 when done).
+    int previousClip = -1;
+    float previousTime = 0.0f;
+    float fade = 1.0f;
+    float fadeDuration = 0.0f;
+};
+
 // InstancedMeshRenderer - renders many instances of the same mesh/material set.
 // Instance transforms are local to the entity (entity transform is applied as parent).
 class InstancedMeshRenderer : public Component {
@@ -16,6 +32,7 @@ public:
     virtual ~InstancedMeshRenderer() = default;
 
     COMPONENT_TYPE(InstancedMeshRenderer)
+    COMPONENT_CLONE_BY_COPY(InstancedMeshRenderer)
 
     // Mesh
     std::shared_ptr<Mesh> getMesh() const { return m_Mesh; }
@@ -40,17 +57,76 @@ public:
     void clearInstances();
     void addInstance(const Math::Matrix4x4& localTransform);
     void setInstances(const std::vector<Math::Matrix4x4>& localTransforms);
+    void setInstance(uint32_t index, const Math::Matrix4x4& localTransform);
     const std::vector<Math::Matrix4x4>& getInstances() const { return m_Instances; }
     uint32_t getInstanceCount() const { return static_cast<uint32_t>(m_Instances.size()); }
 
+    // Change tracking for the renderer's persistent instance copies (Renderer/InstanceCache.hpp).
+    // The version is unique across all renderers and changes with every edit of the instances or
+    // the vertex animation settings baked into them. The dirty range holds the instances edited
+    // since clearDirtyInstances, which was called at version sinceVersion.
+    struct InstanceDirtyRange {
+        uint64_t sinceVersion = 0;
+        uint32_t begin = 0;
+        uint32_t end = 0;
+    };
+    uint64_t getInstanceVersion() const { return m_InstanceVersion; }
+    const InstanceDirtyRange& getDirtyInstances() const { return m_DirtyInstances; }
+    void clearDirtyInstances();
+
+    // Crowd animation. With a skeleton, clips and a skin-weighted mesh, each instance plays one of
+    // the clips; the renderer samples and skins every pose on the GPU (Renderer/CrowdAnimation.hpp)
+    // and this component only advances the playback times.
+    std::shared_ptr<Skeleton> getSkeleton() const { return m_Skeleton; }
+    void setSkeleton(std::shared_ptr<Skeleton> skeleton);
+    const std::vector<std::shared_ptr<AnimationClip>>& getAnimationClips() const { return m_Clips; }
+    void setAnimationClips(const std::vector<std::shared_ptr<AnimationClip>>& clips);
+    bool hasCrowdAnimation() const;
+
+    // Cross-fades the instance to the clip over fadeSeconds, starting it at startTime.
+    void playInstanceClip(uint32_t instance, int clip, float fadeSeconds = 0.2f, float startTime = 0.0f);
+    // Plays the clip on every instance; timeSpread staggers the start times so they do not move
+    // in lockstep.
+    void playClipOnAll(int clip, float fadeSeconds = 0.2f, float timeSpread = 0.0f);
+    void setInstanceSpeed(uint32_t instance, float speed);
+    const std::vector<CrowdInstanceState>& getCrowdStates() const { return m_CrowdStates; }
+
+    // Vertex animation. A baked texture (BakeVertexAnimationTexture) of this renderer's mesh plays
+    // on every instance through the instanced pipeline with no skinning at all; crowd animation
+    // takes precedence when both are set. timeSpread, a fraction of the clip, staggers the
+    // instances so they do not move in lockstep.
+    const VertexAnimationTexture& getVertexAnimation() const { return m_VertexAnimation; }
+    void setVertexAnimation(const VertexAnimationTexture& animation);
+    bool hasVertexAnimation() const;
+    float getVertexAnimationSpeed() const { return m_VertexAnimationSpeed; }
+    void setVertexAnimationSpeed(float speed);
+    float getVertexAnimationTimeSpread() const { return m_VertexAnimationTimeSpread; }
+    void setVertexAnimationTimeSpread(float spread);
+    // Start offset of the instance in seconds.
+    float getVertexAnimationOffset(uint32_t instance) const;
+
     // Lifecycle
     void OnCreate() override;
     void OnDestroy() override;
+    void OnUpdate(float deltaTime) override;
+
+    bool hasAnimationPhase() const override { return hasCrowdAnimation(); }
+    void OnAnimationEvaluate(float deltaTime) override;
 
 private:
+    void markInstancesDirty(uint32_t begin, uint32_t end);
+
     std::shared_ptr<Mesh> m_Mesh;
     std::vector<std::shared_ptr<Material>> m_Materials;
     std::vector<Math::Matrix4x4> m_Instances;
+    std::shared_ptr<Skeleton> m_Skeleton;
+    std::vector<std::shared_ptr<AnimationClip>> m_Clips;
+    std::vector<CrowdInstanceState> m_CrowdStates; // one per instance
+    VertexAnimationTexture m_VertexAnimation;
+    float m_VertexAnimationSpeed;
+    float m_VertexAnimationTimeSpread;
+    uint64_t m_InstanceVersion;
+    InstanceDirtyRange m_DirtyInstances;
 
     bool m_CastShadows;
     bool m_ReceiveShadows;
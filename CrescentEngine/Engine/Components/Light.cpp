@@ -31,6 +31,8 @@ Light::Light()
     , m_ShadowQuality(ShadowQuality::High)
     , m_ShadowMapResolution(1024)
     , m_CascadeCount(4)
+    , m_ShadowPageCache(false)
+    , m_ShadowUpdateInterval(1)
     , m_ConstantAttenuation(1.0f)
     , m_LinearAttenuation(0.09f)
     , m_QuadraticAttenuation(0.032f)
@@ -51,7 +53,8 @@ float Light::calculateAttenuation(float distance) const {
         return 1.0f; // No attenuation for directional lights
     }
     
-    if (distance > m_Range) {
+    const float range = getRange();
+    if (distance > range) {
         return 0.0f;
     }
     
@@ -63,7 +66,7 @@ float Light::calculateAttenuation(float distance) const {
                       m_QuadraticAttenuation * distance * distance;
         attenuation = (denom > Math::EPSILON) ? 1.0f / denom : 0.0f;
     } else {
-        attenuation = Math::Clamp(1.0f - (distance / m_Range), 0.0f, 1.0f);
+        attenuation = Math::Clamp(1.0f - (distance / range), 0.0f, 1.0f);
     }
     
     return attenuation;
@@ -148,6 +151,10 @@ void Light::setCascadeCount(uint8_t cascades) {
     m_CascadeCount = std::max<uint8_t>(1, std::min<uint8_t>(4, cascades));
 }
 
+void Light::setShadowUpdateInterval(uint32_t frames) {
+    m_ShadowUpdateInterval = std::max<uint32_t>(1, std::min<uint32_t>(8, frames));
+}
+
 void Light::setCascadeSplits(const std::array<float, 4>& splits) {
     m_CascadeSplits = splits;
     // Ensure monotonically increasing and clamped to [0,1]
@@ -185,7 +192,7 @@ Math::Vector3 Light::KelvinToRGB(float temperatureK) {
 }
 
 Math::Vector3 Light::getEffectiveColor() const {
-    return m_Color; // temperature baked into color when setColorTemperature called
+    return getColor(); // temperature baked into color when setColorTemperature called
 }
 
 } // namespace Crescent
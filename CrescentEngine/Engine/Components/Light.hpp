@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../ECS/Component.hpp"
+#include "../ECS/RenderSnapshot.hpp"
 #include "../Math/Math.hpp"
 #include <array>
 #include <cstdint>
@@ -50,13 +51,17 @@ public:
     virtual ~Light() = default;
     
     COMPONENT_TYPE(Light)
+    COMPONENT_POOLED(Light)
+    COMPONENT_CLONE_BY_COPY(Light)
     
     // Light type
     Type getType() const { return m_Type; }
     void setType(Type type) { m_Type = type; }
     
     // Color and intensity
-    const Math::Vector3& getColor() const { return m_Color; }
+    const Math::Vector3& getColor() const {
+        return RenderSnapshot::isReading() ? m_RenderState.color : m_Color;
+    }
     void setColor(const Math::Vector3& color) { m_Color = color; }
     
     float getColorTemperature() const { return m_ColorTemperature; }
@@ -65,11 +70,15 @@ public:
     IntensityUnit getIntensityUnit() const { return m_IntensityUnit; }
     void setIntensityUnit(IntensityUnit unit) { m_IntensityUnit = unit; }
     
-    float getIntensity() const { return m_Intensity; }
+    float getIntensity() const {
+        return RenderSnapshot::isReading() ? m_RenderState.intensity : m_Intensity;
+    }
     void setIntensity(float intensity) { m_Intensity = std::max(0.0f, intensity); }
     
     // Range (for point and spot lights)
-    float getRange() const { return m_Range; }
+    float getRange() const {
+        return RenderSnapshot::isReading() ? m_RenderState.range : m_Range;
+    }
     void setRange(float range) { m_Range = std::max(0.0f, range); }
     
     // Spot light properties
@@ -112,6 +121,14 @@ public:
     void setCascadeCount(uint8_t cascades);
     const std::array<float, 4>& getCascadeSplits() const { return m_CascadeSplits; }
     void setCascadeSplits(const std::array<float, 4>& splits);
+    // Directional only: cascades snap to light-space pages and only re-render pages that scrolled
+    // in or whose static casters changed.
+    bool getShadowPageCache() const { return m_ShadowPageCache; }
+    void setShadowPageCache(bool enabled) { m_ShadowPageCache = enabled; }
+    // Point/spot/area only: frames between shadow map refreshes (1-8). Skipped frames reuse the
+    // last result; directional cascades take their cadence from the quality settings.
+    uint32_t getShadowUpdateInterval() const { return m_ShadowUpdateInterval; }
+    void setShadowUpdateInterval(uint32_t frames);
     float getShadowNearPlane() const { return m_ShadowNearPlane; }
     float getShadowFarPlane() const { return m_ShadowFarPlane; }
     void setShadowRange(float nearPlane, float farPlane);
@@ -150,6 +167,13 @@ public:
     int getShadowmaskChannel() const { return m_ShadowmaskChannel; }
     void setShadowmaskChannel(int channel) { m_ShadowmaskChannel = std::max(-1, std::min(3, channel)); }
     
+    // Copies the values gameplay animates (color, intensity, range) into the render snapshot.
+    void publishRenderState() {
+        m_RenderState.color = m_Color;
+        m_RenderState.intensity = m_Intensity;
+        m_RenderState.range = m_Range;
+    }
+
     // Calculate attenuation at distance
     float calculateAttenuation(float distance) const;
     
@@ -218,6 +242,8 @@ private:
     uint32_t m_ShadowMapResolution;
     uint8_t m_CascadeCount;
     std::array<float, 4> m_CascadeSplits;
+    bool m_ShadowPageCache;
+    uint32_t m_ShadowUpdateInterval;
     
     // Attenuation
     float m_ConstantAttenuation;
@@ -234,6 +260,14 @@ private:
     bool m_ContributeToStaticBake;
     Mobility m_Mobility;
     int m_ShadowmaskChannel;
+
+    // Published copy read by the pipelined render job
+    struct RenderState {
+        Math::Vector3 color = Math::Vector3(1.0f, 1.0f, 1.0f);
+        float intensity = 1.0f;
+        float range = 10.0f;
+    };
+    RenderState m_RenderState;
     
     // Main light
     static Light* s_MainLight;
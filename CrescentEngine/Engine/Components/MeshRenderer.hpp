@@ -22,12 +22,16 @@ public:
         std::string lightmapPath;
         std::string directionalLightmapPath;
         std::string shadowmaskPath;
+        // SceneSerializer::HashStaticLightingContents of the renderer when its atlas was baked.
+        std::string bakeHash;
     };
 
     MeshRenderer();
     virtual ~MeshRenderer() = default;
     
     COMPONENT_TYPE(MeshRenderer)
+    COMPONENT_POOLED(MeshRenderer)
+    COMPONENT_CLONE_BY_COPY(MeshRenderer)
     
     // Mesh
     std::shared_ptr<Mesh> getMesh() const { return m_Mesh; }
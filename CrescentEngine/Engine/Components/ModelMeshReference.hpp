@@ -11,6 +11,7 @@ public:
     ModelMeshReference() = default;
 
     COMPONENT_TYPE(ModelMeshReference)
+    COMPONENT_CLONE_BY_COPY(ModelMeshReference)
 
     const std::string& getSourcePath() const { return m_SourcePath; }
     void setSourcePath(const std::string& path) { m_SourcePath = path; }
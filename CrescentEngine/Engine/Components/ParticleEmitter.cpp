@@ -0,0 +1,57 @@
+#include "ParticleEmitter.hpp"
+
+namespace Crescent {
+
+ParticleEmitter::ParticleEmitter()
+    : m_MaxParticles(4096)
+    , m_EmissionRate(100.0f)
+    , m_BurstCount(100)
+    , m_Emitting(true)
+    , m_MinLifetime(1.5f)
+    , m_MaxLifetime(3.0f)
+    , m_MinSpeed(1.0f)
+    , m_MaxSpeed(2.5f)
+    , m_StartSize(0.2f)
+    , m_EndSize(0.05f)
+    , m_StartColor(1.0f, 1.0f, 1.0f, 1.0f)
+    , m_EndColor(1.0f, 1.0f, 1.0f, 0.0f)
+    , m_Intensity(1.0f)
+    , m_Lit(false)
+    , m_Gravity(0.0f, -2.0f, 0.0f)
+    , m_Drag(0.1f)
+    , m_Shape(Shape::Cone)
+    , m_ShapeRadius(0.1f)
+    , m_ConeAngle(25.0f)
+    , m_Collision(false)
+    , m_Bounce(0.4f)
+    , m_CollisionLifetimeLoss(0.0f)
+    , m_BlendMode(BlendMode::Alpha)
+    , m_Seed(1)
+    , m_BurstVersion(0)
+    , m_ClearVersion(0) {}
+
+void ParticleEmitter::setLifetimeRange(float minLifetime, float maxLifetime) {
+    m_MinLifetime = std::max(0.01f, minLifetime);
+    m_MaxLifetime = std::max(m_MinLifetime, maxLifetime);
+}
+
+void ParticleEmitter::setSpeedRange(float minSpeed, float maxSpeed) {
+    m_MinSpeed = std::max(0.0f, minSpeed);
+    m_MaxSpeed = std::max(m_MinSpeed, maxSpeed);
+}
+
+void ParticleEmitter::setSizeRange(float startSize, float endSize) {
+    m_StartSize = std::max(0.0f, startSize);
+    m_EndSize = std::max(0.0f, endSize);
+}
+
+void ParticleEmitter::setTexture(const std::shared_ptr<Texture2D>& texture) {
+    m_Texture = texture;
+    if (texture) {
+        m_TexturePath = texture->getPath();
+    } else {
+        m_TexturePath.clear();
+    }
+}
+
+} // namespace Crescent
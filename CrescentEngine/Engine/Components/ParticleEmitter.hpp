@@ -0,0 +1,153 @@
+#pragma once
+
+#include "../ECS/Component.hpp"
+#include "../Math/Math.hpp"
+#include "../Rendering/Texture.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Crescent {
+
+// ParticleEmitter - camera-facing sprites emitted, simulated and drawn entirely on the GPU
+// (Renderer/ParticleSystem.hpp). The component only holds settings; particle state never comes
+// back to the CPU. Particles spawn in world space at the entity's transform and keep moving when it
+// does. Alpha-blended emitters are sorted back to front every frame, additive ones are not.
+class ParticleEmitter : public Component {
+public:
+    enum class Shape {
+        Point,
+        Sphere,
+        Cone
+    };
+
+    enum class BlendMode {
+        Alpha,
+        Additive
+    };
+
+    ParticleEmitter();
+    virtual ~ParticleEmitter() = default;
+
+    COMPONENT_TYPE(ParticleEmitter)
+    COMPONENT_CLONE_BY_COPY(ParticleEmitter)
+
+    // Particles alive at once; emission stalls while the pool is full. The scene's particle budget
+    // can lower it further.
+    uint32_t getMaxParticles() const { return m_MaxParticles; }
+    void setMaxParticles(uint32_t count) { m_MaxParticles = std::clamp(count, 1u, 1u << 20); }
+
+    // Particles per second while emitting.
+    float getEmissionRate() const { return m_EmissionRate; }
+    void setEmissionRate(float rate) { m_EmissionRate = std::max(0.0f, rate); }
+
+    // Particles emitted at once by the next burst() call.
+    uint32_t getBurstCount() const { return m_BurstCount; }
+    void setBurstCount(uint32_t count) { m_BurstCount = count; }
+    void burst() { ++m_BurstVersion; }
+    uint64_t getBurstVersion() const { return m_BurstVersion; }
+
+    bool isEmitting() const { return m_Emitting; }
+    void setEmitting(bool emitting) { m_Emitting = emitting; }
+
+    float getMinLifetime() const { return m_MinLifetime; }
+    float getMaxLifetime() const { return m_MaxLifetime; }
+    void setLifetimeRange(float minLifetime, float maxLifetime);
+
+    float getMinSpeed() const { return m_MinSpeed; }
+    float getMaxSpeed() const { return m_MaxSpeed; }
+    void setSpeedRange(float minSpeed, float maxSpeed);
+
+    // Sprite size in world units at birth and at death.
+    float getStartSize() const { return m_StartSize; }
+    float getEndSize() const { return m_EndSize; }
+    void setSizeRange(float startSize, float endSize);
+
+    // Linear colour and opacity at birth and at death; rgb is multiplied by the intensity.
+    const Math::Vector4& getStartColor() const { return m_StartColor; }
+    void setStartColor(const Math::Vector4& color) { m_StartColor = color; }
+    const Math::Vector4& getEndColor() const { return m_EndColor; }
+    void setEndColor(const Math::Vector4& color) { m_EndColor = color; }
+    float getIntensity() const { return m_Intensity; }
+    void setIntensity(float intensity) { m_Intensity = std::max(0.0f, intensity); }
+
+    // Scene lights shade the sprites; unlit ones show their colour as is.
+    bool isLit() const { return m_Lit; }
+    void setLit(bool lit) { m_Lit = lit; }
+
+    // World-space acceleration, e.g. (0, -9.81, 0).
+    const Math::Vector3& getGravity() const { return m_Gravity; }
+    void setGravity(const Math::Vector3& gravity) { m_Gravity = gravity; }
+
+    // Fraction of velocity lost per second.
+    float getDrag() const { return m_Drag; }
+    void setDrag(float drag) { m_Drag = std::max(0.0f, drag); }
+
+    // Emission shape around the entity. Cones open along the entity's forward (-Z) axis.
+    Shape getShape() const { return m_Shape; }
+    void setShape(Shape shape) { m_Shape = shape; }
+    float getShapeRadius() const { return m_ShapeRadius; }
+    void setShapeRadius(float radius) { m_ShapeRadius = std::max(0.0f, radius); }
+    float getConeAngle() const { return m_ConeAngle; }
+    void setConeAngle(float degrees) { m_ConeAngle = Math::Clamp(degrees, 0.0f, 180.0f); }
+
+    // Bounce off the opaque scene as seen in the depth buffer. Surfaces off screen or hidden behind
+    // others do not collide.
+    bool getCollision() const { return m_Collision; }
+    void setCollision(bool collision) { m_Collision = collision; }
+    // Fraction of the normal velocity kept by a bounce.
+    float getBounce() const { return m_Bounce; }
+    void setBounce(float bounce) { m_Bounce = Math::Clamp(bounce, 0.0f, 1.0f); }
+    // Fraction of lifetime lost by a bounce.
+    float getCollisionLifetimeLoss() const { return m_CollisionLifetimeLoss; }
+    void setCollisionLifetimeLoss(float loss) { m_CollisionLifetimeLoss = Math::Clamp(loss, 0.0f, 1.0f); }
+
+    BlendMode getBlendMode() const { return m_BlendMode; }
+    void setBlendMode(BlendMode mode) { m_BlendMode = mode; }
+
+    // Alpha is multiplied into the colour; none draws a soft round sprite.
+    const std::shared_ptr<Texture2D>& getTexture() const { return m_Texture; }
+    void setTexture(const std::shared_ptr<Texture2D>& texture);
+    const std::string& getTexturePath() const { return m_TexturePath; }
+    void setTexturePath(const std::string& path) { m_TexturePath = path; }
+
+    uint32_t getSeed() const { return m_Seed; }
+    void setSeed(uint32_t seed) { m_Seed = seed; }
+
+    // Kills every live particle on the next frame.
+    void clear() { ++m_ClearVersion; }
+    uint64_t getClearVersion() const { return m_ClearVersion; }
+
+private:
+    uint32_t m_MaxParticles;
+    float m_EmissionRate;
+    uint32_t m_BurstCount;
+    bool m_Emitting;
+    float m_MinLifetime;
+    float m_MaxLifetime;
+    float m_MinSpeed;
+    float m_MaxSpeed;
+    float m_StartSize;
+    float m_EndSize;
+    Math::Vector4 m_StartColor;
+    Math::Vector4 m_EndColor;
+    float m_Intensity;
+    bool m_Lit;
+    Math::Vector3 m_Gravity;
+    float m_Drag;
+    Shape m_Shape;
+    float m_ShapeRadius;
+    float m_ConeAngle;
+    bool m_Collision;
+    float m_Bounce;
+    float m_CollisionLifetimeLoss;
+    BlendMode m_BlendMode;
+    std::shared_ptr<Texture2D> m_Texture;
+    std::string m_TexturePath;
+    uint32_t m_Seed;
+    uint64_t m_BurstVersion;
+    uint64_t m_ClearVersion;
+};
+
+} // namespace Crescent
@@ -19,7 +19,9 @@ PhysicsCollider::PhysicsCollider()
     , m_FrictionCombine(CombineMode::Average)
     , m_RestitutionCombine(CombineMode::Average)
     , m_CollisionLayer(0)
-    , m_CollisionMask(kAllLayersMask) {
+    , m_CollisionMask(kAllLayersMask)
+    , m_CookedShapeConvex(false)
+    , m_CookedShapeTransform(Math::Matrix4x4::Identity) {
 }
 
 void PhysicsCollider::setShapeType(ShapeType type) {
@@ -128,6 +130,18 @@ void PhysicsCollider::setCollisionMask(uint32_t mask) {
     notifyChanged();
 }
 
+void PhysicsCollider::setCookedShape(const std::string& path, bool convex, const Math::Matrix4x4& transform) {
+    m_CookedShapePath = path;
+    m_CookedShapeConvex = convex;
+    m_CookedShapeTransform = transform;
+    notifyChanged();
+}
+
+void PhysicsCollider::setCookedHeightField(const std::string& path) {
+    m_CookedHeightFieldPath = path;
+    notifyChanged();
+}
+
 void PhysicsCollider::OnCreate() {
     if (Entity* entity = getEntity()) {
         std::shared_ptr<Mesh> mesh;
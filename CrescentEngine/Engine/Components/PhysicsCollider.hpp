@@ -3,6 +3,7 @@
 #include "../ECS/Component.hpp"
 #include "../Math/Math.hpp"
 #include <cstdint>
+#include <string>
 
 namespace Crescent {
 
@@ -12,7 +13,10 @@ public:
         Box,
         Sphere,
         Capsule,
-        Mesh
+        Mesh,
+        // Static height field over the entity's sculpted terrain plane, in tiles that page in and
+        // out around the streaming focus. Falls back to Mesh for other meshes.
+        Terrain
     };
 
     enum class CombineMode {
@@ -29,6 +33,7 @@ public:
     ~PhysicsCollider() override = default;
 
     COMPONENT_TYPE(PhysicsCollider)
+    COMPONENT_CLONE_BY_COPY(PhysicsCollider)
 
     ShapeType getShapeType() const { return m_Shape; }
     void setShapeType(ShapeType type);
@@ -66,6 +71,18 @@ public:
     uint32_t getCollisionMask() const { return m_CollisionMask; }
     void setCollisionMask(uint32_t mask);
 
+    // Set by cooked scenes on mesh colliders: a Jolt shape blob baked from the collider mesh, the
+    // body kind (convex hull or static mesh) and the mesh-to-body transform it was baked with.
+    // Physics restores it instead of building from the mesh while both still match.
+    const std::string& getCookedShapePath() const { return m_CookedShapePath; }
+    bool isCookedShapeConvex() const { return m_CookedShapeConvex; }
+    const Math::Matrix4x4& getCookedShapeTransform() const { return m_CookedShapeTransform; }
+    void setCookedShape(const std::string& path, bool convex, const Math::Matrix4x4& transform);
+    // Set by cooked scenes on terrain colliders: the cooked height texture the tiles are built
+    // from, so the terrain mesh is never read back.
+    const std::string& getCookedHeightFieldPath() const { return m_CookedHeightFieldPath; }
+    void setCookedHeightField(const std::string& path);
+
     void OnCreate() override;
     void OnDestroy() override;
 
@@ -85,6 +102,10 @@ private:
     CombineMode m_RestitutionCombine;
     uint32_t m_CollisionLayer;
     uint32_t m_CollisionMask;
+    std::string m_CookedShapePath;
+    bool m_CookedShapeConvex;
+    Math::Matrix4x4 m_CookedShapeTransform;
+    std::string m_CookedHeightFieldPath;
 };
 
 } // namespace Crescent
@@ -21,6 +21,7 @@ public:
         : m_Type(type) {}
 
     COMPONENT_TYPE(PrimitiveMesh)
+    COMPONENT_CLONE_BY_COPY(PrimitiveMesh)
 
     PrimitiveType getType() const { return m_Type; }
     void setType(PrimitiveType type) { m_Type = type; }
@@ -17,6 +17,8 @@ public:
     ~Rigidbody() override = default;
 
     COMPONENT_TYPE(Rigidbody)
+    COMPONENT_POOLED(Rigidbody)
+    COMPONENT_CLONE_BY_COPY(Rigidbody)
 
     RigidbodyType getType() const { return m_Type; }
     void setType(RigidbodyType type);
@@ -220,6 +220,22 @@ SkinnedMeshRenderer::SkinnedMeshRenderer()
     , m_DrivenByAnimator(false) {
 }
 
+std::unique_ptr<Component> SkinnedMeshRenderer::clone() const {
+    // Keeps the pose and the bone bounds cache, which a mesh without CPU data could not rebuild;
+    // blends and root motion restart, and the animator claims the copy again in its OnCreate.
+    auto copy = std::make_unique<SkinnedMeshRenderer>(*this);
+    copy->m_BlendClip.reset();
+    copy->m_BlendTimeSeconds = 0.0f;
+    copy->m_BlendDuration = 0.0f;
+    copy->m_BlendElapsed = 0.0f;
+    copy->m_BlendClipIndex = -1;
+    copy->m_SmoothedDelta = 0.0f;
+    copy->m_AnimAccumulator = 0.0f;
+    copy->m_RootMotionValid = false;
+    copy->m_DrivenByAnimator = false;
+    return detachClone(std::move(copy));
+}
+
 void SkinnedMeshRenderer::setMesh(std::shared_ptr<Mesh> mesh) {
     m_Mesh = mesh;
     invalidateBoneBoundsCache();
@@ -439,13 +455,16 @@ std::shared_ptr<Material> SkinnedMeshRenderer::getMaterial(uint32_t index) const
 }
 
 void SkinnedMeshRenderer::applyBoneMatrices(const std::vector<Math::Matrix4x4>& matrices) {
-    if (!m_BoneMatrices.empty()) {
-        m_PrevBoneMatrices = m_BoneMatrices;
-    } else if (m_Skeleton) {
+    beginBoneMatrixUpdate().assign(matrices.begin(), matrices.end());
+    endBoneMatrixUpdate();
+}
+
+std::vector<Math::Matrix4x4>& SkinnedMeshRenderer::beginBoneMatrixUpdate() {
+    m_PrevBoneMatrices.swap(m_BoneMatrices);
+    if (m_PrevBoneMatrices.empty() && m_Skeleton) {
         m_PrevBoneMatrices.assign(m_Skeleton->getBoneCount(), Math::Matrix4x4::Identity);
     }
-    m_BoneMatrices = matrices;
-    updateDynamicBounds();
+    return m_BoneMatrices;
 }
 
 void SkinnedMeshRenderer::getWorldBounds(Math::Vector3& outMin, Math::Vector3& outMax) const {
@@ -454,17 +473,30 @@ void SkinnedMeshRenderer::getWorldBounds(Math::Vector3& outMin, Math::Vector3& o
         outMax = Math::Vector3::Zero;
         return;
     }
+    const bool reading = RenderSnapshot::isReading();
+    const bool hasDynamicBounds = reading ? m_RenderState.hasDynamicBounds : m_HasDynamicBounds;
+    const Math::Vector3 localMin = !hasDynamicBounds ? m_Mesh->getBoundsMin()
+        : (reading ? m_RenderState.localBoundsMin : m_LocalBoundsMin);
+    const Math::Vector3 localMax = !hasDynamicBounds ? m_Mesh->getBoundsMax()
+        : (reading ? m_RenderState.localBoundsMax : m_LocalBoundsMax);
     Transform* transform = m_Entity ? m_Entity->getTransform() : nullptr;
     if (!transform) {
-        outMin = m_HasDynamicBounds ? m_LocalBoundsMin : m_Mesh->getBoundsMin();
-        outMax = m_HasDynamicBounds ? m_LocalBoundsMax : m_Mesh->getBoundsMax();
+        outMin = localMin;
+        outMax = localMax;
         return;
     }
-    const Math::Vector3 localMin = m_HasDynamicBounds ? m_LocalBoundsMin : m_Mesh->getBoundsMin();
-    const Math::Vector3 localMax = m_HasDynamicBounds ? m_LocalBoundsMax : m_Mesh->getBoundsMax();
     ComputeWorldAABBFromLocalBounds(localMin, localMax, transform->getWorldMatrix(), outMin, outMax);
 }
 
+void SkinnedMeshRenderer::publishRenderState() {
+    // assign() reuses the snapshot's capacity, so steady-state publishing does not allocate.
+    m_RenderState.boneMatrices.assign(m_BoneMatrices.begin(), m_BoneMatrices.end());
+    m_RenderState.prevBoneMatrices.assign(m_PrevBoneMatrices.begin(), m_PrevBoneMatrices.end());
+    m_RenderState.localBoundsMin = m_LocalBoundsMin;
+    m_RenderState.localBoundsMax = m_LocalBoundsMax;
+    m_RenderState.hasDynamicBounds = m_HasDynamicBounds;
+}
+
 Math::Vector3 SkinnedMeshRenderer::getBoundsMin() const {
     Math::Vector3 worldMin;
     Math::Vector3 worldMax;
@@ -517,7 +549,9 @@ void SkinnedMeshRenderer::rebuildBoneBoundsCache() {
         return;
     }
 
-    m_BoneBoundsCache.resize(boneCount);
+    std::vector<Math::Vector3> boneMin(boneCount, Math::Vector3(std::numeric_limits<float>::max()));
+    std::vector<Math::Vector3> boneMax(boneCount, Math::Vector3(std::numeric_limits<float>::lowest()));
+    std::vector<uint8_t> influenced(boneCount, 0);
     for (size_t vertexIndex = 0; vertexIndex < vertices.size(); ++vertexIndex) {
         const Math::Vector3& localPos = vertices[vertexIndex].position;
         const SkinWeight& weights = skinWeights[vertexIndex];
@@ -527,18 +561,20 @@ void SkinnedMeshRenderer::rebuildBoneBoundsCache() {
             if (weight <= 0.0f || boneIndex >= boneCount) {
                 continue;
             }
+            boneMin[boneIndex] = Math::Vector3::Min(boneMin[boneIndex], localPos);
+            boneMax[boneIndex] = Math::Vector3::Max(boneMax[boneIndex], localPos);
+            influenced[boneIndex] = 1;
+        }
+    }
 
-            BoneInfluenceBounds& boneBounds = m_BoneBoundsCache[boneIndex];
-            if (!boneBounds.valid) {
-                boneBounds.localMin = localPos;
-                boneBounds.localMax = localPos;
-                boneBounds.valid = true;
-            } else {
-                boneBounds.localMin = Math::Vector3::Min(boneBounds.localMin, localPos);
-                boneBounds.localMax = Math::Vector3::Max(boneBounds.localMax, localPos);
-            }
+    m_BoneBoundsCache.resize(boneCount);
+    for (size_t boneIndex = 0; boneIndex < boneCount; ++boneIndex) {
+        if (influenced[boneIndex]) {
+            m_BoneBoundsCache[boneIndex].center = (boneMin[boneIndex] + boneMax[boneIndex]) * 0.5f;
+            m_BoneBoundsCache[boneIndex].extent = (boneMax[boneIndex] - boneMin[boneIndex]) * 0.5f;
         }
     }
+    m_Mesh->releaseCpuData();
 }
 
 bool SkinnedMeshRenderer::updateDynamicBoundsFromVertices() {
@@ -594,6 +630,33 @@ bool SkinnedMeshRenderer::updateDynamicBoundsFromVertices() {
 }
 
 void SkinnedMeshRenderer::updateDynamicBounds() {
+    SkinBounds bounds;
+    if (m_Mesh && m_Mesh->hasSkinWeights() && !m_BoneMatrices.empty()) {
+        if (m_BoneBoundsCacheDirty) {
+            rebuildBoneBoundsCache();
+        }
+        ComputeSkinBounds(m_BoneMatrices, m_BoneBoundsCache, bounds);
+    }
+    applyDynamicBounds(bounds);
+}
+
+void SkinnedMeshRenderer::skinPose(const Skeleton& skeleton, const AnimationLocalPose& pose) {
+    std::vector<Math::Matrix4x4>& matrices = beginBoneMatrixUpdate();
+    SkinBounds bounds;
+    if (m_Mesh && m_Mesh->hasSkinWeights()) {
+        if (m_BoneBoundsCacheDirty) {
+            rebuildBoneBoundsCache();
+        }
+        BuildSkinMatricesAndBounds(skeleton, pose, m_BoneBoundsCache, matrices, bounds);
+    } else {
+        BuildSkinMatrices(skeleton, pose, matrices);
+    }
+    applyDynamicBounds(bounds);
+}
+
+// Takes the refit bone boxes, or falls back to the bind bounds refined by skinning the CPU
+// vertices when no bone has a box.
+void SkinnedMeshRenderer::applyDynamicBounds(const SkinBounds& bounds) {
     if (!m_Mesh) {
         m_LocalBoundsMin = Math::Vector3::Zero;
         m_LocalBoundsMax = Math::Vector3::Zero;
@@ -601,48 +664,19 @@ void SkinnedMeshRenderer::updateDynamicBounds() {
         return;
     }
 
-    m_LocalBoundsMin = m_Mesh->getBoundsMin();
-    m_LocalBoundsMax = m_Mesh->getBoundsMax();
     m_HasDynamicBounds = true;
-
-    if (!m_Mesh->hasSkinWeights() || m_BoneMatrices.empty()) {
+    const Math::Vector3 padding(0.05f, 0.05f, 0.05f);
+    if (bounds.valid) {
+        m_LocalBoundsMin = bounds.min - padding;
+        m_LocalBoundsMax = bounds.max + padding;
         return;
     }
 
-    if (m_BoneBoundsCacheDirty) {
-        rebuildBoneBoundsCache();
-    }
-
-    const size_t boneCount = std::min(m_BoneBoundsCache.size(), m_BoneMatrices.size());
-    Math::Vector3 localMin(std::numeric_limits<float>::max());
-    Math::Vector3 localMax(std::numeric_limits<float>::lowest());
-    bool hasValidBoneBounds = false;
-
-    for (size_t boneIndex = 0; boneIndex < boneCount; ++boneIndex) {
-        const BoneInfluenceBounds& boneBounds = m_BoneBoundsCache[boneIndex];
-        if (!boneBounds.valid) {
-            continue;
-        }
-
-        Math::Vector3 transformedMin;
-        Math::Vector3 transformedMax;
-        m_BoneMatrices[boneIndex].transformAABB(boneBounds.localMin,
-                                                boneBounds.localMax,
-                                                transformedMin,
-                                                transformedMax);
-        localMin = Math::Vector3::Min(localMin, transformedMin);
-        localMax = Math::Vector3::Max(localMax, transformedMax);
-        hasValidBoneBounds = true;
-    }
-
-    if (hasValidBoneBounds) {
-        const Math::Vector3 padding(0.05f, 0.05f, 0.05f);
-        m_LocalBoundsMin = localMin - padding;
-        m_LocalBoundsMax = localMax + padding;
-        return;
+    m_LocalBoundsMin = m_Mesh->getBoundsMin();
+    m_LocalBoundsMax = m_Mesh->getBoundsMax();
+    if (m_Mesh->hasSkinWeights() && !m_BoneMatrices.empty()) {
+        updateDynamicBoundsFromVertices();
     }
-
-    updateDynamicBoundsFromVertices();
 }
 
 void SkinnedMeshRenderer::applyRootMotion(AnimationLocalPose& pose, float sampleTime) {
@@ -677,14 +711,13 @@ void SkinnedMeshRenderer::applyRootMotion(AnimationLocalPose& pose, float sample
         } else {
             Math::Vector3 deltaPos = currentPos - m_PrevRootPos;
             Math::Quaternion deltaRot = currentRot * m_PrevRootRot.inverse();
-            Transform* transform = getEntity() ? getEntity()->getTransform() : nullptr;
-            if (transform) {
-                if (m_RootMotionApplyPosition) {
-                    transform->translate(deltaPos, true);
-                }
-                if (m_RootMotionApplyRotation) {
-                    transform->rotate(deltaRot, true);
-                }
+            if (m_RootMotionApplyPosition) {
+                m_PendingRootPosition += m_PendingRootRotation * deltaPos;
+                m_HasPendingRootMotion = true;
+            }
+            if (m_RootMotionApplyRotation) {
+                m_PendingRootRotation = m_PendingRootRotation * deltaRot;
+                m_HasPendingRootMotion = true;
             }
             m_PrevRootPos = currentPos;
             m_PrevRootRot = currentRot;
@@ -697,14 +730,32 @@ void SkinnedMeshRenderer::applyRootMotion(AnimationLocalPose& pose, float sample
 }
 
 void SkinnedMeshRenderer::OnUpdate(float deltaTime) {
-    if (m_DrivenByAnimator) {
+    OnAnimationEvaluate(deltaTime);
+    OnAnimationFinalize();
+}
+
+void SkinnedMeshRenderer::OnAnimationFinalize() {
+    if (!m_HasPendingRootMotion) {
         return;
     }
+    m_HasPendingRootMotion = false;
+    if (Transform* transform = getEntity() ? getEntity()->getTransform() : nullptr) {
+        transform->translate(m_PendingRootPosition, true);
+        transform->rotate(m_PendingRootRotation, true);
+    }
+}
 
-    if (!m_BoneMatrices.empty()) {
-        m_PrevBoneMatrices = m_BoneMatrices;
-    } else if (m_Skeleton) {
-        m_PrevBoneMatrices.assign(m_Skeleton->getBoneCount(), Math::Matrix4x4::Identity);
+void SkinnedMeshRenderer::OnAnimationEvaluate(float deltaTime) {
+    m_HasPendingRootMotion = false;
+    m_PendingRootPosition = Math::Vector3::Zero;
+    m_PendingRootRotation = Math::Quaternion::Identity;
+    if (m_DrivenByAnimator) {
+        return;
+    }
+    const AnimationLodThrottle::Step lod =
+        m_AnimationLodThrottle.advance(m_AnimationLod, readScreenCoverage(), deltaTime, m_Skeleton.get());
+    if (lod.frozen) {
+        return;
     }
 
     constexpr float kMaxAnimDelta = 0.05f;
@@ -719,10 +770,12 @@ void SkinnedMeshRenderer::OnUpdate(float deltaTime) {
     animDelta = m_SmoothedDelta;
 
     float fixedStep = std::max(0.0001f, Time::fixedDeltaTime());
-    m_AnimAccumulator += animDelta;
-    float maxAccumulator = fixedStep * static_cast<float>(kMaxAnimSteps);
-    if (m_AnimAccumulator > maxAccumulator) {
-        m_AnimAccumulator = maxAccumulator;
+    if (!lod.throttled) {
+        m_AnimAccumulator += animDelta;
+        float maxAccumulator = fixedStep * static_cast<float>(kMaxAnimSteps);
+        if (m_AnimAccumulator > maxAccumulator) {
+            m_AnimAccumulator = maxAccumulator;
+        }
     }
 
     if (!m_Skeleton) {
@@ -773,13 +826,16 @@ void SkinnedMeshRenderer::OnUpdate(float deltaTime) {
             float blend = (m_BlendDuration > 0.0f)
                 ? Math::Clamp(m_BlendElapsed / m_BlendDuration, 0.0f, 1.0f)
                 : 1.0f;
-            SampleLocalPose(*m_Skeleton, m_Clip.get(), m_TimeSeconds, m_Looping, m_LocalPose);
-            SampleLocalPose(*m_Skeleton, m_BlendClip.get(), m_BlendTimeSeconds, m_Looping, m_BlendPose);
+            SampleLocalPose(*m_Skeleton, m_Clip.get(), m_TimeSeconds, m_Looping, m_LocalPose, &m_ClipCursor,
+                            lod.boneMask);
+            SampleLocalPose(*m_Skeleton, m_BlendClip.get(), m_BlendTimeSeconds, m_Looping, m_BlendPose,
+                            &m_BlendClipCursor, lod.boneMask);
             BlendLocalPose(m_LocalPose, m_BlendPose, blend, m_BlendResultPose);
             applyRootMotion(m_BlendResultPose, m_TimeSeconds);
             outputPose = &m_BlendResultPose;
             if (blend >= 0.999f) {
                 m_Clip = m_BlendClip;
+                std::swap(m_ClipCursor, m_BlendClipCursor);
                 m_ActiveClipIndex = m_BlendClipIndex;
                 m_TimeSeconds = m_BlendTimeSeconds;
                 m_BlendClip.reset();
@@ -788,7 +844,8 @@ void SkinnedMeshRenderer::OnUpdate(float deltaTime) {
                 m_BlendClipIndex = -1;
             }
         } else {
-            SampleLocalPose(*m_Skeleton, m_Clip.get(), m_TimeSeconds, m_Looping, m_LocalPose);
+            SampleLocalPose(*m_Skeleton, m_Clip.get(), m_TimeSeconds, m_Looping, m_LocalPose, &m_ClipCursor,
+                            lod.boneMask);
             applyRootMotion(m_LocalPose, m_TimeSeconds);
             outputPose = &m_LocalPose;
         }
@@ -805,21 +862,27 @@ void SkinnedMeshRenderer::OnUpdate(float deltaTime) {
         }
     };
 
-    int steps = 0;
-    while (m_AnimAccumulator >= fixedStep && steps < kMaxAnimSteps) {
-        m_AnimAccumulator -= fixedStep;
-        stepAnimation(fixedStep);
-        steps++;
-    }
-    if (!m_HasPose) {
-        stepAnimation(0.0f);
+    if (lod.throttled) {
+        // One step covers the frames the LOD skipped; frames in between interpolate towards it.
+        if (lod.evaluate || !m_HasPose) {
+            stepAnimation(lod.deltaTime);
+        }
+    } else {
+        int steps = 0;
+        while (m_AnimAccumulator >= fixedStep && steps < kMaxAnimSteps) {
+            m_AnimAccumulator -= fixedStep;
+            stepAnimation(fixedStep);
+            steps++;
+        }
+        if (!m_HasPose) {
+            stepAnimation(0.0f);
+        }
     }
 
-    float alpha = fixedStep > 0.0f ? (m_AnimAccumulator / fixedStep) : 0.0f;
-    if (m_HasPose) {
+    float alpha = lod.throttled ? lod.blend : (fixedStep > 0.0f ? (m_AnimAccumulator / fixedStep) : 0.0f);
+    if (m_HasPose && lod.skin) {
         BlendLocalPose(m_PrevPose, m_CurrentPose, alpha, m_RenderPose);
-        BuildSkinMatrices(*m_Skeleton, m_RenderPose, m_BoneMatrices);
-        updateDynamicBounds();
+        skinPose(*m_Skeleton, m_RenderPose);
     }
 }
 
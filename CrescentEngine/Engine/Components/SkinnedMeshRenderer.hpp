@@ -1,11 +1,13 @@
 #pragma once
 
 #include "../ECS/Component.hpp"
+#include "../ECS/RenderSnapshot.hpp"
 #include "../Rendering/Mesh.hpp"
 #include "../Rendering/Material.hpp"
 #include "../Animation/Skeleton.hpp"
 #include "../Animation/AnimationClip.hpp"
 #include "../Animation/AnimationPose.hpp"
+#include "../Animation/AnimationLod.hpp"
 #include <vector>
 #include <memory>
 
@@ -54,6 +56,12 @@ public:
     bool setActiveClipIndex(int index);
     bool crossFadeToClip(int index, float durationSeconds, bool restart = true);
     void applyBoneMatrices(const std::vector<Math::Matrix4x4>& matrices);
+    // In-place alternative to applyBoneMatrices: the current matrices become the previous ones and
+    // the returned buffer is overwritten by the caller, then endBoneMatrixUpdate refits the bounds.
+    std::vector<Math::Matrix4x4>& beginBoneMatrixUpdate();
+    void endBoneMatrixUpdate() { updateDynamicBounds(); }
+    // Builds the skin matrices from a pose and refits the bounds in the same pass over the bones.
+    void skinPose(const Skeleton& skeleton, const AnimationLocalPose& pose);
     void getWorldBounds(Math::Vector3& outMin, Math::Vector3& outMax) const;
     Math::Vector3 getBoundsMin() const;
     Math::Vector3 getBoundsMax() const;
@@ -82,25 +90,39 @@ public:
     bool getApplyRootMotionRotation() const { return m_RootMotionApplyRotation; }
     void setApplyRootMotionRotation(bool value) { m_RootMotionApplyRotation = value; }
 
-    const std::vector<Math::Matrix4x4>& getBoneMatrices() const { return m_BoneMatrices; }
+    // Animation LOD (see AnimationLodSettings); an Animator driving this renderer follows it too.
+    const AnimationLodSettings& getAnimationLod() const { return m_AnimationLod; }
+    void setAnimationLod(const AnimationLodSettings& settings) { m_AnimationLod = settings; }
+    // Called by the renderer for the game view: the mesh's bounding radius in pixels, 0 if culled.
+    void reportScreenCoverage(float pixels) { m_ScreenCoverage.report(pixels); }
+    // Latest reported coverage, -1 when unknown; read once a frame by whatever animates the mesh.
+    float readScreenCoverage() { return m_ScreenCoverage.read(); }
+
+    const std::vector<Math::Matrix4x4>& getBoneMatrices() const {
+        return RenderSnapshot::isReading() ? m_RenderState.boneMatrices : m_BoneMatrices;
+    }
     void setBoneMatrices(const std::vector<Math::Matrix4x4>& matrices) { applyBoneMatrices(matrices); }
-    const std::vector<Math::Matrix4x4>& getPreviousBoneMatrices() const { return m_PrevBoneMatrices; }
+    const std::vector<Math::Matrix4x4>& getPreviousBoneMatrices() const {
+        return RenderSnapshot::isReading() ? m_RenderState.prevBoneMatrices : m_PrevBoneMatrices;
+    }
+
+    // Copies the current pose and bounds into the render snapshot (see RenderSnapshot).
+    void publishRenderState();
 
+    std::unique_ptr<Component> clone() const override;
     void OnUpdate(float deltaTime) override;
+    bool hasAnimationPhase() const override { return !m_DrivenByAnimator; }
+    void OnAnimationEvaluate(float deltaTime) override;
+    void OnAnimationFinalize() override;
 
 private:
-    struct BoneInfluenceBounds {
-        Math::Vector3 localMin = Math::Vector3::Zero;
-        Math::Vector3 localMax = Math::Vector3::Zero;
-        bool valid = false;
-    };
-
     void applyRootMotion(AnimationLocalPose& pose, float sampleTime);
     void rebuildAnimationClipList(bool resetPlayback);
     void invalidateBoneBoundsCache();
     void rebuildBoneBoundsCache();
     bool updateDynamicBoundsFromVertices();
     void updateDynamicBounds();
+    void applyDynamicBounds(const SkinBounds& bounds);
 
     std::shared_ptr<Mesh> m_Mesh;
     std::shared_ptr<Skeleton> m_Skeleton;
@@ -125,6 +147,11 @@ private:
     AnimationLocalPose m_PrevPose;
     AnimationLocalPose m_CurrentPose;
     AnimationLocalPose m_RenderPose;
+    AnimationSampleCursor m_ClipCursor;
+    AnimationSampleCursor m_BlendClipCursor;
+    AnimationLodSettings m_AnimationLod;
+    AnimationLodThrottle m_AnimationLodThrottle;
+    ScreenCoverageFeedback m_ScreenCoverage;
 
     bool m_Playing;
     bool m_Looping;
@@ -139,11 +166,25 @@ private:
     float m_PrevRootTime = 0.0f;
     Math::Vector3 m_PrevRootPos = Math::Vector3::Zero;
     Math::Quaternion m_PrevRootRot = Math::Quaternion::Identity;
+    // Root motion gathered by OnAnimationEvaluate, applied to the transform by OnAnimationFinalize.
+    bool m_HasPendingRootMotion = false;
+    Math::Vector3 m_PendingRootPosition = Math::Vector3::Zero;
+    Math::Quaternion m_PendingRootRotation = Math::Quaternion::Identity;
     Math::Vector3 m_LocalBoundsMin = Math::Vector3::Zero;
     Math::Vector3 m_LocalBoundsMax = Math::Vector3::Zero;
     bool m_HasDynamicBounds = false;
-    std::vector<BoneInfluenceBounds> m_BoneBoundsCache;
+    // Per bone, the bind-space box of the vertices it influences.
+    std::vector<SkinBoneBox> m_BoneBoundsCache;
     bool m_BoneBoundsCacheDirty = true;
+
+    struct RenderState {
+        std::vector<Math::Matrix4x4> boneMatrices;
+        std::vector<Math::Matrix4x4> prevBoneMatrices;
+        Math::Vector3 localBoundsMin = Math::Vector3::Zero;
+        Math::Vector3 localBoundsMax = Math::Vector3::Zero;
+        bool hasDynamicBounds = false;
+    };
+    RenderState m_RenderState;
 };
 
 } // namespace Crescent
@@ -0,0 +1,34 @@
+#include "TerrainRenderer.hpp"
+#include "../ECS/Entity.hpp"
+#include "../Scene/Scene.hpp"
+#include <algorithm>
+
+namespace Crescent {
+
+TerrainRenderer::TerrainRenderer()
+    : m_LodDistance(4.0f)
+    , m_CastShadows(true)
+    , m_ShadowLodBias(1)
+    , m_Version(1) {}
+
+// The render world leaves the terrain mesh out of the mesh passes only while this is enabled.
+void TerrainRenderer::markRenderWorldDirty() {
+    if (m_Entity && m_Entity->getScene()) {
+        m_Entity->getScene()->markRenderWorldDirty();
+    }
+}
+
+void TerrainRenderer::OnEnable() {
+    markRenderWorldDirty();
+}
+
+void TerrainRenderer::OnDisable() {
+    markRenderWorldDirty();
+}
+
+void TerrainRenderer::setLodDistance(float distance) {
+    // Below 3 a patch can border one two levels coarser, which the vertex morph cannot close.
+    m_LodDistance = std::clamp(distance, 3.0f, 6.0f);
+}
+
+} // namespace Crescent
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../ECS/Component.hpp"
+#include <cstdint>
+
+namespace Crescent {
+
+// TerrainRenderer - draws the entity's sculpted terrain plane (its MeshRenderer, with the terrain
+// material) from its heights instead of its triangles. The renderer keeps the heights as a stack
+// of clipmap levels streamed around the camera, picks quadtree patches by camera distance every
+// frame and displaces one shared grid patch in the vertex shader (Renderer/TerrainSystem.hpp), so
+// triangle density follows the view rather than the sculpt resolution. While enabled, the mesh
+// itself is left out of every mesh pass; the MeshRenderer's enable state still hides the terrain.
+class TerrainRenderer : public Component {
+public:
+    TerrainRenderer();
+    virtual ~TerrainRenderer() = default;
+
+    COMPONENT_TYPE(TerrainRenderer)
+    COMPONENT_CLONE_BY_COPY(TerrainRenderer)
+
+    void OnEnable() override;
+    void OnDisable() override;
+
+    // Range of each level in patches of that level; higher keeps finer patches farther out.
+    float getLodDistance() const { return m_LodDistance; }
+    void setLodDistance(float distance);
+
+    bool getCastShadows() const { return m_CastShadows; }
+    void setCastShadows(bool cast) { m_CastShadows = cast; }
+
+    // Levels dropped per sun shadow cascade: cascade i draws no patch finer than (i + 1) * bias.
+    uint32_t getShadowLodBias() const { return m_ShadowLodBias; }
+    void setShadowLodBias(uint32_t bias) { m_ShadowLodBias = bias > 4u ? 4u : bias; }
+
+    // Changes with every setting that rebuilds the heights; the renderer streams them again.
+    uint64_t getVersion() const { return m_Version; }
+    // For terrain edits: the heights are read again from the mesh.
+    void refresh() { ++m_Version; }
+
+private:
+    void markRenderWorldDirty();
+
+    float m_LodDistance;
+    bool m_CastShadows;
+    uint32_t m_ShadowLodBias;
+    uint64_t m_Version;
+};
+
+} // namespace Crescent
@@ -24,6 +24,7 @@
 #include <iostream>
 #include <random>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -164,6 +165,44 @@ public:
     bool getDebugLogging() const { return m_DebugLogging; }
     void setDebugLogging(bool value) { m_DebugLogging = value; }
 
+    // Settings only; dependencies, the orbit and the animation targets are resolved again in OnCreate.
+    std::unique_ptr<Component> clone() const override {
+        auto copy = std::make_unique<ThirdPersonController>();
+        copy->m_MouseSensitivity = m_MouseSensitivity;
+        copy->m_InvertY = m_InvertY;
+        copy->m_RequireLookButton = m_RequireLookButton;
+        copy->m_LookButton = m_LookButton;
+        copy->m_MinPitch = m_MinPitch;
+        copy->m_MaxPitch = m_MaxPitch;
+        copy->m_PivotHeight = m_PivotHeight;
+        copy->m_LookAhead = m_LookAhead;
+        copy->m_ShoulderOffset = m_ShoulderOffset;
+        copy->m_CameraDistance = m_CameraDistance;
+        copy->m_TargetCameraDistance = m_CameraDistance;
+        copy->m_MinDistance = m_MinDistance;
+        copy->m_MaxDistance = m_MaxDistance;
+        copy->m_ZoomSpeed = m_ZoomSpeed;
+        copy->m_CameraCollisionRadius = m_CameraCollisionRadius;
+        copy->m_PositionSmoothSpeed = m_PositionSmoothSpeed;
+        copy->m_RotationSmoothSpeed = m_RotationSmoothSpeed;
+        copy->m_CameraSmoothSpeed = m_CameraSmoothSpeed;
+        copy->m_WalkSpeed = m_WalkSpeed;
+        copy->m_RunSpeed = m_RunSpeed;
+        copy->m_SprintSpeed = m_SprintSpeed;
+        copy->m_EnableSprint = m_EnableSprint;
+        copy->m_DriveCharacterController = m_DriveCharacterController;
+        copy->m_MeleeHitDamage = m_MeleeHitDamage;
+        copy->m_MeleeHitRadius = m_MeleeHitRadius;
+        copy->m_MeleeHitForwardOffset = m_MeleeHitForwardOffset;
+        copy->m_MeleeHitUpOffset = m_MeleeHitUpOffset;
+        copy->m_MeleeHitMask = m_MeleeHitMask;
+        copy->m_MeleeHitTriggers = m_MeleeHitTriggers;
+        copy->m_WeaponGripPositionOffset = m_WeaponGripPositionOffset;
+        copy->m_WeaponGripRotationOffsetDegrees = m_WeaponGripRotationOffsetDegrees;
+        copy->m_WeaponSupportHandOffset = m_WeaponSupportHandOffset;
+        return detachClone(std::move(copy));
+    }
+
     void OnCreate() override {
         findDependencies();
         initializeOrbitFromCurrentCamera();
@@ -176,6 +215,10 @@ public:
         }
     }
 
+    void OnStart() override {
+        preloadEventAudio();
+    }
+
     void OnDestroy() override {
         if (m_Controller && m_DriveCharacterController) {
             m_Controller->setEnabled(true);
@@ -282,6 +325,14 @@ private:
         int fall = -1;
     };
 
+    struct EventTraits {
+        AudioBus bus = AudioBus::SFX;
+        bool directional = false;
+        bool jump = false;
+        // 1 opens the melee hit window, -1 closes it.
+        int hitWindow = 0;
+    };
+
     struct AnimatorMapping {
         int idleState = -1;
         int aimIdleState = -1;
@@ -480,21 +531,74 @@ private:
         return std::filesystem::exists(candidate) ? candidate.string() : std::string();
     }
 
-    static std::string getEventTypeLower(const AnimationEvent& event) {
-        if (!event.eventType.empty()) {
-            return ToLower(event.eventType);
+    static bool isAudioEvent(const AnimationEvent& event) {
+        static const AnimationEventId kAudioType = InternAnimationEventName("audio");
+        return event.typeId == kAudioType || event.payloadId != kInvalidAnimationEventId;
+    }
+
+    // Dispatch traits of an event's tag and name, worked out on first sight of the pair.
+    const EventTraits& resolveEventTraits(const AnimationEvent& event) {
+        const uint64_t key = (static_cast<uint64_t>(event.tagId) << 32) | event.nameId;
+        auto it = m_EventTraits.find(key);
+        if (it != m_EventTraits.end()) {
+            return it->second;
         }
-        if (!event.payload.empty()) {
-            return "audio";
+        const std::string& tag = GetAnimationEventName(event.tagId);
+        EventTraits traits;
+        if (ContainsAnyToken(tag, {"vocal", "grunt", "man", "voice"})) {
+            traits.bus = AudioBus::Vocal;
+        } else if (ContainsAnyToken(tag, {"ui"})) {
+            traits.bus = AudioBus::UI;
+        } else if (ContainsAnyToken(tag, {"music"})) {
+            traits.bus = AudioBus::Music;
+        } else if (ContainsAnyToken(tag, {"ambience", "ambient"})) {
+            traits.bus = AudioBus::Ambience;
+        }
+        traits.directional = ContainsAnyToken(tag, {"swing", "whoosh", "attack"});
+        traits.jump = ContainsAnyToken(GetAnimationEventName(event.nameId), {"jump"});
+        if (MatchesAnyTag(tag, {"attack_window_open", "melee_window_open", "hitbox_on", "damage_window_open"})) {
+            traits.hitWindow = 1;
+        } else if (MatchesAnyTag(tag, {"attack_window_close", "melee_window_close", "hitbox_off", "damage_window_close"})) {
+            traits.hitWindow = -1;
         }
-        return {};
+        return m_EventTraits.emplace(key, traits).first->second;
     }
 
-    static std::string getEventTagLower(const AnimationEvent& event) {
-        if (!event.eventTag.empty()) {
-            return ToLower(event.eventTag);
+    // The payload's clip, resolved against the project once per payload.
+    AudioClipHandle resolveEventAudioClip(const AnimationEvent& event) {
+        if (event.payloadId == kInvalidAnimationEventId) {
+            return kInvalidAudioClip;
+        }
+        auto it = m_EventAudioClips.find(event.payloadId);
+        if (it != m_EventAudioClips.end()) {
+            return it->second;
+        }
+        AudioClipHandle clip = AudioSystem::getInstance().loadClip(resolveEventAudioPath(event.payload));
+        m_EventAudioClips.emplace(event.payloadId, clip);
+        return clip;
+    }
+
+    // Decodes every clip the animation events and footsteps can play when play starts, so the first of each does
+    // not hitch mid-game.
+    void preloadEventAudio() {
+        AudioSystem& audio = AudioSystem::getInstance();
+        if (!audio.isInitialized() || !m_PrimarySkinned) {
+            return;
+        }
+        for (const auto& clip : m_PrimarySkinned->getAnimationClips()) {
+            if (!clip) {
+                continue;
+            }
+            for (const auto& event : clip->getEvents()) {
+                if (isAudioEvent(event)) {
+                    audio.preloadClip(resolveEventAudioClip(event));
+                }
+            }
+        }
+        ensureFootstepAudioResolved();
+        for (const std::string& path : m_FootstepAudioPaths) {
+            audio.preloadClip(audio.loadClip(path));
         }
-        return ToLower(event.name);
     }
 
     float resolveEventPitch(const AnimationEvent& event) {
@@ -505,44 +609,22 @@ private:
         return std::max(0.01f, center + nextAudioJitter(amplitude));
     }
 
-    AudioBus resolveEventBus(const AnimationEvent& event) const {
-        std::string tag = getEventTagLower(event);
-        if (ContainsAnyToken(tag, {"vocal", "grunt", "man", "voice"})) {
-            return AudioBus::Vocal;
-        }
-        if (ContainsAnyToken(tag, {"ui"})) {
-            return AudioBus::UI;
-        }
-        if (ContainsAnyToken(tag, {"music"})) {
-            return AudioBus::Music;
-        }
-        if (ContainsAnyToken(tag, {"ambience", "ambient"})) {
-            return AudioBus::Ambience;
-        }
-        return AudioBus::SFX;
-    }
-
-    bool playConfiguredEventAudio(const AnimationEvent& event,
-                                  const std::string& fallbackPath,
-                                  bool directional) {
-        std::string path = resolveEventAudioPath(event.payload);
-        if (path.empty()) {
-            path = fallbackPath;
-        }
-        if (path.empty()) {
+    bool playConfiguredEventAudio(const AnimationEvent& event, const EventTraits& traits) {
+        AudioClipHandle clip = resolveEventAudioClip(event);
+        if (clip == kInvalidAudioClip) {
             return false;
         }
 
         float volume = std::max(0.0f, event.volume);
         float pitch = resolveEventPitch(event);
-        AudioBus bus = resolveEventBus(event);
+        AudioBus bus = traits.bus;
         if (!event.spatial) {
-            return AudioSystem::getInstance().playOneShot(path, bus, volume, pitch);
+            return AudioSystem::getInstance().playOneShot(clip, bus, volume, pitch);
         }
-        if (directional) {
+        if (traits.directional) {
             Math::Vector3 forward = m_BodyTransform ? FlattenDirection(m_BodyTransform->forward()) : Math::Vector3(0.0f, 0.0f, -1.0f);
             return AudioSystem::getInstance().playOneShot3DDirectional(
-                path,
+                clip,
                 getAudioOrigin(1.1f),
                 forward,
                 bus,
@@ -557,8 +639,8 @@ private:
                 0.8f);
         }
         return AudioSystem::getInstance().playOneShot3D(
-            path,
-            getAudioOrigin(ContainsAnyToken(ToLower(event.name), {"jump"}) ? 1.0f : 1.15f),
+            clip,
+            getAudioOrigin(traits.jump ? 1.0f : 1.15f),
             bus,
             volume,
             pitch,
@@ -754,8 +836,7 @@ private:
             return false;
         }
         for (const auto& event : clip->getEvents()) {
-            std::string tag = getEventTagLower(event);
-            if (ContainsAnyToken(tag, tokens)) {
+            if (ContainsAnyToken(GetAnimationEventName(event.tagId), tokens)) {
                 return true;
             }
         }
@@ -768,10 +849,8 @@ private:
             return false;
         }
         for (const auto& event : clip->getEvents()) {
-            std::string type = getEventTypeLower(event);
-            std::string tag = getEventTagLower(event);
-            if (type == "audio" || !event.payload.empty() ||
-                ContainsAnyToken(tag, {"foot", "step", "swing", "whoosh", "attack", "vocal", "grunt", "man", "jump", "impact", "hit"})) {
+            if (isAudioEvent(event) ||
+                ContainsAnyToken(GetAnimationEventName(event.tagId), {"foot", "step", "swing", "whoosh", "attack", "vocal", "grunt", "man", "jump", "impact", "hit"})) {
                 return true;
             }
         }
@@ -989,16 +1068,14 @@ private:
     }
 
     void dispatchClipEvent(const AnimationEvent& event, int clipIndex) {
-        std::string type = getEventTypeLower(event);
-        std::string tag = getEventTagLower(event);
-        if (MatchesAnyTag(tag, {"attack_window_open", "melee_window_open", "hitbox_on", "damage_window_open"})) {
+        const EventTraits& traits = resolveEventTraits(event);
+        if (traits.hitWindow > 0) {
             beginMeleeHitWindow();
-        } else if (MatchesAnyTag(tag, {"attack_window_close", "melee_window_close", "hitbox_off", "damage_window_close"})) {
+        } else if (traits.hitWindow < 0) {
             endMeleeHitWindow();
         }
-        if (type == "audio" || !event.payload.empty()) {
-            bool directional = ContainsAnyToken(tag, {"swing", "whoosh", "attack"});
-            playConfiguredEventAudio(event, {}, directional);
+        if (isAudioEvent(event)) {
+            playConfiguredEventAudio(event, traits);
         }
         (void)clipIndex;
     }
@@ -1028,27 +1105,18 @@ private:
             currentTime = std::min(currentTime, duration);
         }
 
-        std::vector<AnimationEvent> firedEvents;
-        const auto& events = clip->getEvents();
-        if (!m_EventClipLooping || currentTime >= previousTime) {
-            for (const auto& evt : events) {
-                if (evt.time > previousTime && evt.time <= currentTime) {
-                    firedEvents.push_back(evt);
-                }
-            }
-        } else {
-            for (const auto& evt : events) {
-                if (evt.time > previousTime || evt.time <= currentTime) {
-                    firedEvents.push_back(evt);
-                }
-            }
-        }
-
         m_EventClipPrevTime = previousTime;
         m_EventClipTime = currentTime;
 
-        for (const auto& evt : firedEvents) {
-            dispatchClipEvent(evt, m_EventClipIndex);
+        // The local clip reference keeps the events alive while they dispatch.
+        const bool wrapped = m_EventClipLooping && currentTime < previousTime;
+        for (const auto& evt : clip->getEvents()) {
+            const bool crossed = wrapped
+                ? (evt.time > previousTime || evt.time <= currentTime)
+                : (evt.time > previousTime && evt.time <= currentTime);
+            if (crossed) {
+                dispatchClipEvent(evt, m_EventClipIndex);
+            }
         }
     }
 
@@ -1061,8 +1129,10 @@ private:
             return;
         }
         int clipIndex = m_ActionClipIndex >= 0 ? m_ActionClipIndex : m_EventClipIndex;
-        for (const auto& evt : fired) {
-            dispatchClipEvent(evt, clipIndex);
+        for (size_t i = 0; i < fired.size(); ++i) {
+            if (const AnimationEvent* evt = fired[i].get()) {
+                dispatchClipEvent(*evt, clipIndex);
+            }
         }
         animator->clearFiredEvents();
     }
@@ -1452,73 +1522,55 @@ private:
         }
     }
 
+    // Resolved once per skeleton; the name is fixed for the controller's lifetime.
     int resolveWeaponBoneIndex(const Skeleton& skeleton) const {
-        if (m_WeaponBoneName.empty()) {
-            return -1;
+        if (m_WeaponBoneSkeleton != &skeleton || m_WeaponBoneCount != skeleton.getBoneCount()) {
+            m_WeaponBoneSkeleton = &skeleton;
+            m_WeaponBoneCount = skeleton.getBoneCount();
+            m_WeaponBoneIndex = skeleton.findBoneIndex(m_WeaponBoneName);
         }
-
-        int exact = skeleton.getBoneIndex(m_WeaponBoneName);
-        if (exact >= 0) {
-            return exact;
-        }
-
-        std::string desired = ToLower(m_WeaponBoneName);
-        std::string normalizedDesired;
-        for (char c : desired) {
-            if (std::isalnum(static_cast<unsigned char>(c))) {
-                normalizedDesired.push_back(c);
-            }
-        }
-
-        const auto& bones = skeleton.getBones();
-        for (size_t i = 0; i < bones.size(); ++i) {
-            std::string boneLower = ToLower(bones[i].name);
-            if (boneLower == desired) {
-                return static_cast<int>(i);
-            }
-            std::string normalizedBone;
-            for (char c : boneLower) {
-                if (std::isalnum(static_cast<unsigned char>(c))) {
-                    normalizedBone.push_back(c);
-                }
-            }
-            if (!normalizedDesired.empty() && normalizedBone == normalizedDesired) {
-                return static_cast<int>(i);
-            }
-        }
-
-        return -1;
+        return m_WeaponBoneIndex;
     }
 
     std::string resolveSkeletonBoneName(const Skeleton& skeleton,
                                         const std::vector<std::string>& candidates) const {
-        const auto& bones = skeleton.getBones();
         for (const auto& candidate : candidates) {
-            std::string desired = ToLower(candidate);
-            std::string normalizedDesired;
-            for (char c : desired) {
-                if (std::isalnum(static_cast<unsigned char>(c))) {
-                    normalizedDesired.push_back(c);
-                }
+            int index = skeleton.findBoneIndex(candidate);
+            if (index >= 0) {
+                return skeleton.getBones()[static_cast<size_t>(index)].name;
             }
+        }
+        return {};
+    }
 
-            for (const auto& bone : bones) {
-                std::string boneLower = ToLower(bone.name);
-                if (boneLower == desired) {
-                    return bone.name;
-                }
-                std::string normalizedBone;
-                for (char c : boneLower) {
-                    if (std::isalnum(static_cast<unsigned char>(c))) {
-                        normalizedBone.push_back(c);
-                    }
-                }
-                if (!normalizedDesired.empty() && normalizedBone == normalizedDesired) {
-                    return bone.name;
-                }
+    // The named prop is searched for once and then followed by UUID, so a frame does a map lookup
+    // instead of a case-insensitive scan of the scene. A missing prop is searched for again at most
+    // every kWeaponPropRetryFrames.
+    Entity* bindWeaponProp() {
+        static constexpr int kWeaponPropRetryFrames = 30;
+        Scene* scene = m_Entity ? m_Entity->getScene() : nullptr;
+        if (!scene) {
+            return nullptr;
+        }
+        if (m_WeaponPropId.isValid()) {
+            if (Entity* prop = scene->findEntity(m_WeaponPropId)) {
+                return prop;
             }
+            m_WeaponPropId = UUID::Invalid();
+            m_WeaponPropRetryFrames = 0;
         }
-        return {};
+        if (m_WeaponPropRetryFrames > 0) {
+            --m_WeaponPropRetryFrames;
+            return nullptr;
+        }
+        Entity* prop = findEntityByNameInsensitive(m_WeaponPropName);
+        if (!prop) {
+            m_WeaponPropRetryFrames = kWeaponPropRetryFrames;
+            return nullptr;
+        }
+        m_WeaponPropId = prop->getUUID();
+        m_WeaponPropBindingInitialized = false;
+        return prop;
     }
 
     bool computeWeaponBoneWorld(Math::Matrix4x4& outBoneWorld) const {
@@ -1636,11 +1688,7 @@ private:
             return;
         }
 
-        if (!m_WeaponPropEntity || ToLower(m_WeaponPropEntity->getName()) != ToLower(m_WeaponPropName)) {
-            m_WeaponPropEntity = findEntityByNameInsensitive(m_WeaponPropName);
-            m_WeaponPropBindingInitialized = false;
-        }
-
+        m_WeaponPropEntity = bindWeaponProp();
         if (!m_WeaponPropEntity) {
             ik->setWeight(0.0f);
             return;
@@ -1661,11 +1709,7 @@ private:
             return;
         }
 
-        if (!m_WeaponPropEntity || ToLower(m_WeaponPropEntity->getName()) != ToLower(m_WeaponPropName)) {
-            m_WeaponPropEntity = findEntityByNameInsensitive(m_WeaponPropName);
-            m_WeaponPropBindingInitialized = false;
-        }
-
+        m_WeaponPropEntity = bindWeaponProp();
         if (!m_WeaponPropEntity || m_WeaponPropEntity == m_Entity) {
             return;
         }
@@ -1747,41 +1791,6 @@ private:
         m_BodyTransform->setRotation(yawRotation * m_BodyRotationOffset);
     }
 
-    Math::Vector3 sweepFallbackMove(const Math::Vector3& startPosition,
-                                    const Math::Vector3& move) const {
-        if (!m_Controller || !m_BodyTransform) {
-            return startPosition + move;
-        }
-
-        Scene* scene = m_Entity ? m_Entity->getScene() : nullptr;
-        PhysicsWorld* physics = scene ? scene->getPhysicsWorld() : nullptr;
-        if (!physics) {
-            return startPosition + move;
-        }
-
-        float distance = move.length();
-        if (distance <= Math::EPSILON) {
-            return startPosition;
-        }
-
-        Math::Vector3 dir = move / distance;
-        PhysicsRaycastHit hit{};
-        if (!physics->capsuleCast(startPosition,
-                                  m_Controller->getRadius(),
-                                  m_Controller->getHeight(),
-                                  dir,
-                                  distance + m_Controller->getSkinWidth(),
-                                  hit,
-                                  m_Controller->getCollisionMask(),
-                                  false,
-                                  m_BodyTransform->getEntity())) {
-            return startPosition + move;
-        }
-
-        float travel = std::max(0.0f, hit.distance - m_Controller->getSkinWidth());
-        return startPosition + dir * travel;
-    }
-
     static const char* AnimActionName(AnimAction action) {
         switch (action) {
             case AnimAction::Idle: return "Idle";
@@ -2008,27 +2017,15 @@ private:
 
             for (const auto& channel : clip->getChannels()) {
                 std::string boneName = ToLower(channel.boneName);
-                if (!IsLikelyMotionBoneName(boneName) || channel.positionKeys.empty()) {
+                Math::Vector3 minPos;
+                Math::Vector3 maxPos;
+                if (!IsLikelyMotionBoneName(boneName) || !clip->getPositionRange(channel, minPos, maxPos)) {
                     continue;
                 }
 
                 hasMotionChannel = true;
-                float minY = channel.positionKeys.front().value.y;
-                float maxY = minY;
-                float minX = channel.positionKeys.front().value.x;
-                float maxX = minX;
-                float minZ = channel.positionKeys.front().value.z;
-                float maxZ = minZ;
-                for (const auto& key : channel.positionKeys) {
-                    minY = std::min(minY, key.value.y);
-                    maxY = std::max(maxY, key.value.y);
-                    minX = std::min(minX, key.value.x);
-                    maxX = std::max(maxX, key.value.x);
-                    minZ = std::min(minZ, key.value.z);
-                    maxZ = std::max(maxZ, key.value.z);
-                }
-                verticalRange = std::max(verticalRange, maxY - minY);
-                planarRange = std::max(planarRange, std::max(maxX - minX, maxZ - minZ));
+                verticalRange = std::max(verticalRange, maxPos.y - minPos.y);
+                planarRange = std::max(planarRange, std::max(maxPos.x - minPos.x, maxPos.z - minPos.z));
             }
 
             if (!hasMotionChannel) {
@@ -2704,40 +2701,53 @@ private:
                !m_MeleeWindowUsesEvents;
     }
 
-    void applyMeleeHitAtPoint(const Math::Vector3& center) {
+    // Queues an overlap at one point of the melee sweep; applyMeleeHits runs them.
+    void queueMeleeHitAtPoint(const Math::Vector3& center) {
+        m_MeleeHitQueries.addOverlapSphere(center,
+                                           m_MeleeHitRadius,
+                                           m_MeleeHitMask,
+                                           m_MeleeHitTriggers,
+                                           resolveBodyEntity());
+    }
+
+    // Runs the queued sweep points as one batch and damages what they touched, in sweep order.
+    void applyMeleeHits() {
+        if (m_MeleeHitQueries.empty()) {
+            return;
+        }
         Scene* scene = m_Entity ? m_Entity->getScene() : nullptr;
         PhysicsWorld* physics = scene ? scene->getPhysicsWorld() : nullptr;
         if (!physics) {
+            m_MeleeHitQueries.clear();
             return;
         }
-
-        std::vector<PhysicsOverlapHit> hits;
-        if (physics->overlapSphere(center,
-                                   m_MeleeHitRadius,
-                                   hits,
-                                   m_MeleeHitMask,
-                                   m_MeleeHitTriggers,
-                                   resolveBodyEntity()) <= 0) {
-            return;
-        }
+        physics->runQueries(m_MeleeHitQueries);
 
         Entity* selfEntity = resolveBodyEntity();
-        for (const auto& hit : hits) {
-            Entity* target = resolveDamageTarget(hit.entity);
-            if (!target || target == selfEntity) {
-                continue;
-            }
-            UUID targetUUID = target->getUUID();
-            if (m_MeleeHitVictims.find(targetUUID) != m_MeleeHitVictims.end()) {
-                continue;
-            }
-            Health* health = target->getComponent<Health>();
-            if (!health || health->isDead()) {
-                continue;
+        for (uint32_t query = 0; query < m_MeleeHitQueries.size(); ++query) {
+            const PhysicsOverlapHit* hits = m_MeleeHitQueries.getOverlapHits(query);
+            for (uint32_t h = 0; h < m_MeleeHitQueries.getHitCount(query); ++h) {
+                applyMeleeHitTo(hits[h].entity, selfEntity);
             }
-            m_MeleeHitVictims.insert(targetUUID);
-            health->applyDamage(m_MeleeHitDamage);
         }
+        m_MeleeHitQueries.clear();
+    }
+
+    void applyMeleeHitTo(Entity* hitEntity, Entity* selfEntity) {
+        Entity* target = resolveDamageTarget(hitEntity);
+        if (!target || target == selfEntity) {
+            return;
+        }
+        UUID targetUUID = target->getUUID();
+        if (m_MeleeHitVictims.find(targetUUID) != m_MeleeHitVictims.end()) {
+            return;
+        }
+        Health* health = target->getComponent<Health>();
+        if (!health || health->isDead()) {
+            return;
+        }
+        m_MeleeHitVictims.insert(targetUUID);
+        health->applyDamage(m_MeleeHitDamage);
     }
 
     void updateMeleeHitTrace(float deltaTime) {
@@ -2772,7 +2782,8 @@ private:
         if (!m_MeleeHitSweepInitialized) {
             m_MeleeHitPreviousCenter = center;
             m_MeleeHitSweepInitialized = true;
-            applyMeleeHitAtPoint(center);
+            queueMeleeHitAtPoint(center);
+            applyMeleeHits();
             return;
         }
 
@@ -2781,8 +2792,9 @@ private:
         int steps = std::max(1, static_cast<int>(std::ceil(distance / std::max(0.05f, m_MeleeHitRadius * 0.5f))));
         for (int i = 1; i <= steps; ++i) {
             float t = static_cast<float>(i) / static_cast<float>(steps);
-            applyMeleeHitAtPoint(Math::Vector3::Lerp(m_MeleeHitPreviousCenter, center, t));
+            queueMeleeHitAtPoint(Math::Vector3::Lerp(m_MeleeHitPreviousCenter, center, t));
         }
+        applyMeleeHits();
         m_MeleeHitPreviousCenter = center;
     }
 
@@ -3005,30 +3017,9 @@ private:
             }
         }
 
-        Math::Vector3 preMovePosition = m_BodyTransform->getPosition();
         if (m_DriveCharacterController) {
             m_Controller->OnUpdate(deltaTime);
         }
-
-        if (desiredMagnitude > Math::EPSILON && desiredSpeed > Math::EPSILON) {
-            Math::Vector3 postMovePosition = m_BodyTransform->getPosition();
-            Math::Vector3 actualDelta = postMovePosition - preMovePosition;
-            Math::Vector3 actualHorizontal(actualDelta.x, 0.0f, actualDelta.z);
-            float expectedDistance = desiredSpeed * deltaTime;
-            if (actualHorizontal.length() < expectedDistance * 0.2f) {
-                Math::Vector3 fallbackMove = desiredMove * expectedDistance;
-                Math::Vector3 fallbackPosition = sweepFallbackMove(postMovePosition, fallbackMove);
-                Math::Vector3 fallbackDelta = fallbackPosition - postMovePosition;
-                Math::Vector3 fallbackHorizontal(fallbackDelta.x, 0.0f, fallbackDelta.z);
-                if (fallbackHorizontal.lengthSquared() > Math::EPSILON) {
-                    m_BodyTransform->setPosition(fallbackPosition);
-                    Math::Vector3 velocity = m_Controller->getVelocity();
-                    velocity.x = fallbackDelta.x / deltaTime;
-                    velocity.z = fallbackDelta.z / deltaTime;
-                    m_Controller->setVelocity(velocity);
-                }
-            }
-        }
     }
 
     void updateAnimation(float deltaTime) {
@@ -3519,6 +3510,11 @@ private:
     std::string m_WeaponPropName = "low poly";
     std::string m_WeaponBoneName = "mixamorig:RightHand";
     Entity* m_WeaponPropEntity = nullptr;
+    UUID m_WeaponPropId = UUID::Invalid();
+    int m_WeaponPropRetryFrames = 0;
+    mutable const Skeleton* m_WeaponBoneSkeleton = nullptr;
+    mutable uint32_t m_WeaponBoneCount = 0;
+    mutable int m_WeaponBoneIndex = -1;
     bool m_WeaponPropBindingInitialized = false;
     Math::Vector3 m_WeaponGripPositionOffset = Math::Vector3(0.06f, -0.14f, -0.10f);
     Math::Vector3 m_WeaponGripRotationOffsetDegrees = Math::Vector3(-95.0f, 5.0f, -100.0f);
@@ -3532,7 +3528,10 @@ private:
     bool m_MeleeHitSweepInitialized = false;
     Math::Vector3 m_MeleeHitPreviousCenter = Math::Vector3::Zero;
     std::unordered_set<UUID> m_MeleeHitVictims;
+    PhysicsQueryBatch m_MeleeHitQueries;
     int m_EventClipIndex = -1;
+    std::unordered_map<uint64_t, EventTraits> m_EventTraits;
+    std::unordered_map<AnimationEventId, AudioClipHandle> m_EventAudioClips;
     float m_EventClipPrevTime = 0.0f;
     float m_EventClipTime = 0.0f;
     bool m_EventClipLooping = false;
@@ -0,0 +1,83 @@
+#include "AsyncIO.hpp"
+#include <Metal/Metal.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    constexpr size_t kPrefetchStride = 16 * 1024; // Apple silicon page size
+}
+
+MappedFile::MappedFile(std::string path, const uint8_t* data, size_t size)
+    : m_path(std::move(path))
+    , m_data(data)
+    , m_size(size) {
+}
+
+MappedFile::~MappedFile() {
+    if (m_data && m_size > 0) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path, bool prefetch) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "MappedFile: failed to open " << path << "\n";
+        return nullptr;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return std::shared_ptr<MappedFile>(new MappedFile(path, nullptr, 0));
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping holds its own reference to the file.
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "MappedFile: failed to map " << path << "\n";
+        return nullptr;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(mapping);
+    if (prefetch) {
+        // WILLNEED starts readahead for the whole range; touching each page then waits for it here
+        // rather than on whichever thread first decodes the data.
+        madvise(mapping, size, MADV_WILLNEED);
+        volatile uint8_t sink = 0;
+        for (size_t offset = 0; offset < size; offset += kPrefetchStride) {
+            sink = sink ^ bytes[offset];
+        }
+        (void)sink;
+    }
+    return std::shared_ptr<MappedFile>(new MappedFile(path, bytes, size));
+}
+
+Task<std::shared_ptr<MappedFile>> ReadFileAsync(std::string path) {
+    co_await ResumeOn{JobPriority::Background};
+    co_return MappedFile::open(path, true);
+}
+
+void CommandBufferCompletion::await_suspend(std::coroutine_handle<> handle) {
+    // Once committed the handler may resume the coroutine and destroy this awaiter before
+    // commit() returns, so nothing below touches members after the handler is installed.
+    MTL::CommandBuffer* commandBuffer = m_commandBuffer;
+    const JobPriority priority = m_priority;
+    bool* completed = &m_completed;
+    commandBuffer->addCompletedHandler([handle, priority, completed](MTL::CommandBuffer* finished) {
+        // Completion handlers run on a Metal-owned thread; hop to the scheduler before resuming.
+        *completed = finished->status() == MTL::CommandBufferStatusCompleted;
+        JobScheduler::getInstance().schedule(JobFunction([handle]() { handle.resume(); }), nullptr, priority);
+    });
+    commandBuffer->commit();
+}
+
+} // namespace Crescent
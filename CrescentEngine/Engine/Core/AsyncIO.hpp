@@ -0,0 +1,64 @@
+#pragma once
+
+#include "AsyncTask.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace MTL {
+class CommandBuffer;
+}
+
+namespace Crescent {
+
+// Read-only mapping of a whole file. Pages come from the unified buffer cache, so a decoder
+// reads them in place instead of copying through an ifstream.
+class MappedFile {
+public:
+    // Null when the file cannot be opened or mapped. prefetch faults every page in up front so
+    // the thread that consumes the mapping never stalls on disk.
+    static std::shared_ptr<MappedFile> open(const std::string& path, bool prefetch);
+
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    const std::string& path() const { return m_path; }
+
+private:
+    MappedFile(std::string path, const uint8_t* data, size_t size);
+
+    std::string m_path;
+    const uint8_t* m_data;
+    size_t m_size;
+};
+
+// Maps and prefetches the file on the background lane; the awaiting coroutine continues there.
+Task<std::shared_ptr<MappedFile>> ReadFileAsync(std::string path);
+
+// Commits the command buffer and suspends until the GPU has completed it, then resumes on a
+// worker of the lane. Yields false when the command buffer ended in an error.
+class CommandBufferCompletion {
+public:
+    CommandBufferCompletion(MTL::CommandBuffer* commandBuffer, JobPriority priority)
+        : m_commandBuffer(commandBuffer), m_priority(priority) {}
+
+    bool await_ready() const noexcept { return !m_commandBuffer; }
+    void await_suspend(std::coroutine_handle<> handle);
+    bool await_resume() const { return m_completed; }
+
+private:
+    MTL::CommandBuffer* m_commandBuffer;
+    JobPriority m_priority;
+    bool m_completed = true;
+};
+
+inline CommandBufferCompletion CommitAndAwait(MTL::CommandBuffer* commandBuffer,
+                                              JobPriority priority = JobPriority::Background) {
+    return CommandBufferCompletion(commandBuffer, priority);
+}
+
+} // namespace Crescent
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "JobScheduler.hpp"
+#include <coroutine>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace Crescent {
+
+// Coroutine task on top of the JobScheduler, so a loader can read, decode and upload in one
+// linear function while every step runs off the calling thread:
+//
+//     Task<Mesh*> loadMesh(std::string path) {
+//         std::shared_ptr<MappedFile> file = co_await ReadFileAsync(path); // background lane
+//         auto decoded = decode(file->data(), file->size());
+//         ... encode the upload ...
+//         co_await CommitAndAwait(commandBuffer);                          // GPU done
+//         co_return mesh;
+//     }
+//
+// Tasks are lazy: nothing runs until the task is awaited, handed to Spawn or SyncWait. A task
+// resumes wherever the thing it awaited completed (a worker of the lane, or the GPU completion
+// handler's resume job); co_await ResumeOn{} moves it explicitly. Exceptions travel to the
+// awaiting coroutine.
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    Task<T> get_return_object() noexcept;
+    template <typename U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+    T take() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*value);
+    }
+
+    std::optional<T> value;
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+    void take() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+} // namespace detail
+
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(Handle handle) : m_handle(handle) {}
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { destroy(); }
+
+    bool valid() const { return static_cast<bool>(m_handle); }
+
+    bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+    T await_resume() { return m_handle.promise().take(); }
+
+private:
+    void destroy() {
+        if (m_handle) {
+            m_handle.destroy();
+            m_handle = {};
+        }
+    }
+
+    Handle m_handle;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Eager, self-destroying coroutine that drives a Task to completion.
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+inline DetachedTask RunDetached(Task<void> task) {
+    try {
+        co_await task;
+    } catch (const std::exception& e) {
+        std::cerr << "Task: spawned task failed: " << e.what() << "\n";
+    } catch (...) {
+        std::cerr << "Task: spawned task failed\n";
+    }
+}
+
+template <typename T>
+DetachedTask RunAndSignal(Task<T> task, std::optional<T>* result, std::exception_ptr* error,
+                          std::shared_ptr<JobFence> fence) {
+    try {
+        result->emplace(co_await task);
+    } catch (...) {
+        *error = std::current_exception();
+    }
+    fence->signal();
+}
+
+inline DetachedTask RunAndSignal(Task<void> task, std::exception_ptr* error, std::shared_ptr<JobFence> fence) {
+    try {
+        co_await task;
+    } catch (...) {
+        *error = std::current_exception();
+    }
+    fence->signal();
+}
+
+} // namespace detail
+
+// Resumes the awaiting coroutine on a worker of the lane (inline when the pool is not running).
+struct ResumeOn {
+    JobPriority priority = JobPriority::Frame;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const {
+        JobScheduler::getInstance().schedule(JobFunction([handle]() { handle.resume(); }), nullptr, priority);
+    }
+    void await_resume() const noexcept {}
+};
+
+// Starts the task and lets it finish on its own; a failure is logged.
+inline void Spawn(Task<void> task) {
+    detail::RunDetached(std::move(task));
+}
+
+// Runs the task to completion from synchronous code. The caller helps run frame jobs while it
+// waits, like JobScheduler::wait; do not call it from a job the task itself needs.
+template <typename T>
+T SyncWait(Task<T> task) {
+    // Shared with the driver: signal() still touches the fence after the waiter may have returned.
+    auto fence = std::make_shared<JobFence>();
+    fence->remaining.store(1, std::memory_order_relaxed);
+    std::exception_ptr error;
+    if constexpr (std::is_void_v<T>) {
+        detail::RunAndSignal(std::move(task), &error, fence);
+        JobScheduler::getInstance().wait(*fence);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    } else {
+        std::optional<T> result;
+        detail::RunAndSignal(std::move(task), &result, &error, fence);
+        JobScheduler::getInstance().wait(*fence);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*result);
+    }
+}
+
+} // namespace Crescent
@@ -0,0 +1,110 @@
+#include "CPUProfiler.hpp"
+#include "../../../ThirdParty/nlohmann/json.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    thread_local void* t_ring = nullptr;
+}
+
+CPUProfiler& CPUProfiler::getInstance() {
+    static CPUProfiler instance;
+    return instance;
+}
+
+CPUProfiler::CPUProfiler()
+    : m_Origin(Clock::now()) {
+}
+
+CPUProfiler::ThreadRing& CPUProfiler::threadRing() {
+    if (t_ring) {
+        return *static_cast<ThreadRing*>(t_ring);
+    }
+    auto ring = std::make_unique<ThreadRing>();
+    ring->events = std::make_unique<Event[]>(kRingCapacity);
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ring->index = static_cast<uint32_t>(m_Rings.size());
+    t_ring = ring.get();
+    m_Rings.push_back(std::move(ring));
+    return *m_Rings.back();
+}
+
+void CPUProfiler::beginCapture() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto& ring : m_Rings) {
+            ring->written.store(0, std::memory_order_relaxed);
+        }
+    }
+    m_Capturing.store(true, std::memory_order_release);
+}
+
+void CPUProfiler::endCapture() {
+    m_Capturing.store(false, std::memory_order_release);
+}
+
+void CPUProfiler::setThreadName(const std::string& name) {
+    ThreadRing& ring = threadRing();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ring.name = name;
+}
+
+const char* CPUProfiler::intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Names.insert(name).first->c_str();
+}
+
+void CPUProfiler::record(const char* name, int64_t startNs, int64_t endNs) {
+    ThreadRing& ring = threadRing();
+    const uint64_t slot = ring.written.load(std::memory_order_relaxed);
+    Event& event = ring.events[slot % kRingCapacity];
+    event.name = name;
+    event.startNs = startNs;
+    event.endNs = endNs;
+    ring.written.store(slot + 1, std::memory_order_release);
+}
+
+bool CPUProfiler::writeChromeTrace(const std::string& path) {
+    using nlohmann::json;
+    endCapture();
+    const int pid = 1;
+    json events = json::array();
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (const auto& ring : m_Rings) {
+            const std::string threadName = ring->name.empty()
+                ? "Thread " + std::to_string(ring->index)
+                : ring->name;
+            events.push_back({
+                {"name", "thread_name"}, {"ph", "M"}, {"pid", pid}, {"tid", ring->index},
+                {"args", {{"name", threadName}}}
+            });
+            const uint64_t written = ring->written.load(std::memory_order_acquire);
+            const uint64_t first = written > kRingCapacity ? written - kRingCapacity : 0;
+            for (uint64_t i = first; i < written; ++i) {
+                const Event& event = ring->events[i % kRingCapacity];
+                if (!event.name) {
+                    continue;
+                }
+                events.push_back({
+                    {"name", event.name}, {"cat", "cpu"}, {"ph", "X"}, {"pid", pid}, {"tid", ring->index},
+                    {"ts", static_cast<double>(event.startNs) * 1.0e-3},
+                    {"dur", static_cast<double>(std::max<int64_t>(event.endNs - event.startNs, 0)) * 1.0e-3}
+                });
+            }
+        }
+    }
+    json root = {{"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}};
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        std::cerr << "CPUProfiler: failed to write " << path << std::endl;
+        return false;
+    }
+    out << root.dump();
+    return true;
+}
+
+} // namespace Crescent
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Builds without CRESCENT_PROFILING compile every CRESCENT_PROFILE_* macro to nothing.
+#ifndef CRESCENT_PROFILING
+#define CRESCENT_PROFILING 1
+#endif
+
+namespace Crescent {
+
+// Hierarchical CPU scopes of the frame, written to the Chrome trace event format for Perfetto and
+// chrome://tracing. Every thread records into its own ring of the most recent kRingCapacity
+// scopes, so recording takes no lock and a long capture keeps its last few seconds. Scopes on one
+// thread nest by time; the trace viewer rebuilds the hierarchy from that. Names must outlive the
+// capture: string literals, or intern() for names built at runtime.
+class CPUProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr uint32_t kRingCapacity = 16384;
+
+    static CPUProfiler& getInstance();
+
+    bool isCapturing() const { return m_Capturing.load(std::memory_order_relaxed); }
+    // Empties every ring and starts recording.
+    void beginCapture();
+    void endCapture();
+    // Writes what the rings hold; recording stops first. Returns false if the file can't be written.
+    bool writeChromeTrace(const std::string& path);
+
+    // Labels the calling thread in the trace.
+    void setThreadName(const std::string& name);
+    // Stable copy of name for scopes whose name is not a literal.
+    const char* intern(const std::string& name);
+
+    void record(const char* name, int64_t startNs, int64_t endNs);
+    int64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_Origin).count();
+    }
+
+private:
+    struct Event {
+        const char* name = nullptr;
+        int64_t startNs = 0;
+        int64_t endNs = 0;
+    };
+    struct ThreadRing {
+        std::unique_ptr<Event[]> events;
+        // Total events written; the ring holds the last kRingCapacity of them.
+        std::atomic<uint64_t> written{0};
+        std::string name;
+        uint32_t index = 0;
+    };
+
+    CPUProfiler();
+    ThreadRing& threadRing();
+
+    std::atomic<bool> m_Capturing{false};
+    Clock::time_point m_Origin;
+    std::mutex m_Mutex;
+    std::vector<std::unique_ptr<ThreadRing>> m_Rings;
+    std::unordered_set<std::string> m_Names;
+};
+
+// Records the enclosing block; a relaxed flag load when no capture is running.
+class CPUProfileScope {
+public:
+    explicit CPUProfileScope(const char* name)
+        : m_Name(name)
+        , m_Start(CPUProfiler::getInstance().isCapturing() ? CPUProfiler::getInstance().now() : -1) {}
+    ~CPUProfileScope() {
+        if (m_Start >= 0) {
+            CPUProfiler& profiler = CPUProfiler::getInstance();
+            profiler.record(m_Name, m_Start, profiler.now());
+        }
+    }
+
+    // Closes the current span and opens the next one, for phases of one long function.
+    void next(const char* name) {
+        CPUProfiler& profiler = CPUProfiler::getInstance();
+        const int64_t now = m_Start >= 0 || profiler.isCapturing() ? profiler.now() : -1;
+        if (m_Start >= 0) {
+            profiler.record(m_Name, m_Start, now);
+        }
+        m_Name = name;
+        m_Start = profiler.isCapturing() ? now : -1;
+    }
+
+    CPUProfileScope(const CPUProfileScope&) = delete;
+    CPUProfileScope& operator=(const CPUProfileScope&) = delete;
+
+private:
+    const char* m_Name;
+    int64_t m_Start;
+};
+
+} // namespace Crescent
+
+#define CRESCENT_PROFILE_CONCAT_INNER(a, b) a##b
+#define CRESCENT_PROFILE_CONCAT(a, b) CRESCENT_PROFILE_CONCAT_INNER(a, b)
+
+#if CRESCENT_PROFILING
+#define CRESCENT_PROFILE_SCOPE(name) \
+    ::Crescent::CPUProfileScope CRESCENT_PROFILE_CONCAT(crescentProfileScope, __LINE__)(name)
+// A named scope whose span can be handed on with CRESCENT_PROFILE_NEXT.
+#define CRESCENT_PROFILE_PHASE(var, name) ::Crescent::CPUProfileScope var(name)
+#define CRESCENT_PROFILE_NEXT(var, name) var.next(name)
+#define CRESCENT_PROFILE_THREAD(name) ::Crescent::CPUProfiler::getInstance().setThreadName(name)
+#else
+#define CRESCENT_PROFILE_SCOPE(name) ((void)0)
+#define CRESCENT_PROFILE_PHASE(var, name) ((void)0)
+#define CRESCENT_PROFILE_NEXT(var, name) ((void)0)
+#define CRESCENT_PROFILE_THREAD(name) ((void)0)
+#endif
@@ -1,5 +1,7 @@
 #include "Engine.hpp"
+#include "CPUProfiler.hpp"
 #include "SelectionSystem.hpp"
+#include "StartupTrace.hpp"
 #include "TaskGraph.hpp"
 #include "Time.hpp"
 #include "../Renderer/Renderer.hpp"
@@ -7,23 +9,56 @@
 #include "../Scene/SceneManager.hpp"
 #include "../Scene/SceneCommands.hpp"
 #include "../Scene/SceneSerializer.hpp"
+#include "../Scene/SceneStreamer.hpp"
 #include "../Components/Camera.hpp"
 #include "../Components/CameraController.hpp"
 #include "../Components/Animator.hpp"
 #include "../Components/MeshRenderer.hpp"
 #include "../Components/SkinnedMeshRenderer.hpp"
 #include "../Components/Light.hpp"
+#include "../Assets/AssetDatabase.hpp"
 #include "../Audio/AudioSystem.hpp"
 #include "../Physics/PhysicsWorld.hpp"
 #include "../ECS/Entity.hpp"
+#include "../ECS/RenderSnapshot.hpp"
 #include "../ECS/Transform.hpp"
 #include "../Input/InputManager.hpp"
+#include <cstring>
 #include <iostream>
 #include <limits>
+#include <unordered_map>
 
 namespace {
 constexpr bool kInputDebug = false;
 
+static Crescent::KeyCode MapPlatformKeyCode(unsigned short keyCode) {
+    using namespace Crescent;
+    // Map macOS key codes to our KeyCode enum
+    KeyCode key = KeyCode::Unknown;
+    
+    switch (keyCode) {
+        case 13: key = KeyCode::W; break;
+        case 0:  key = KeyCode::A; break;
+        case 1:  key = KeyCode::S; break;
+        case 2:  key = KeyCode::D; break;
+        case 12: key = KeyCode::Q; break;
+        case 14: key = KeyCode::E; break;
+        case 15: key = KeyCode::R; break;
+        case 49: key = KeyCode::Space; break;
+        case 56: key = KeyCode::Shift; break;
+        case 60: key = KeyCode::Shift; break;
+        case 59: key = KeyCode::Control; break;
+        case 62: key = KeyCode::Control; break;
+        case 58: key = KeyCode::Alt; break;
+        case 61: key = KeyCode::Alt; break;
+        case 55: key = KeyCode::Command; break;
+        case 54: key = KeyCode::Command; break;
+        case 53: key = KeyCode::Escape; break;
+        default: break;
+    }
+    return key;
+}
+
 static void EncapsulateTransformedLocalAABB(const Crescent::Math::Matrix4x4& worldMatrix,
                                             const Crescent::Math::Vector3& localMin,
                                             const Crescent::Math::Vector3& localMax,
@@ -222,6 +257,8 @@ bool Engine::initialize() {
         std::cout << "Engine already initialized!" << std::endl;
         return true;
     }
+    StartupTraceScope trace("engine", "Engine::initialize");
+    CRESCENT_PROFILE_THREAD("Main");
     
     std::cout << "============================================" << std::endl;
     std::cout << "   Initializing Crescent Engine..." << std::endl;
@@ -270,10 +307,10 @@ bool Engine::initialize() {
         std::cout << "Gizmo system initialized (Translate, World space)" << std::endl;
     }
 
+    // Roles share the engine-wide JobScheduler; the first start() sizes the worker pool.
     m_updateJobs.start();
-    m_physicsJobs.start(1);
-    m_audioJobs.start(1);
-    m_renderJobs.start(1);
+    m_physicsJobs.start();
+    m_renderJobs.start();
     m_framePacer.setMaxDelta(0.05f);
     m_framePacer.setMaxSteps(5);
     m_framePacer.setMaxAccumulatorMultiplier(2.0f);
@@ -296,8 +333,11 @@ void Engine::shutdown() {
     
     std::cout << "Shutting down Crescent Engine..." << std::endl;
 
+    setPipelinedRendering(false);
+    // Background scene saves and preloads finish before the workers that run them go away.
+    SceneSerializer::WaitForPendingSaves();
+    SceneManager::getInstance().cancelPreload();
     m_renderJobs.stop();
-    m_audioJobs.stop();
     m_physicsJobs.stop();
     m_updateJobs.stop();
     
@@ -316,12 +356,25 @@ void Engine::shutdown() {
     std::cout << "Crescent Engine shutdown complete." << std::endl;
 }
 
-void Engine::update(float deltaTime) {
+void Engine::update(float deltaTime, double targetPresentationTime) {
     if (!m_isInitialized) {
         return;
     }
+    CRESCENT_PROFILE_SCOPE("Engine::update");
     
+    {
+        CRESCENT_PROFILE_SCOPE("Engine::processAssetChanges");
+        // Assets added, edited or removed on disk since the last frame.
+        AssetDatabase::getInstance().processFileChanges();
+        // Background model imports that finished reading since the last frame.
+        SceneCommands::processModelImports(SceneManager::getInstance().getActiveScene());
+    }
+    updateSceneStreaming();
+    SceneManager::getInstance().updatePreload();
+    applyPickResults();
+
     InputManager& input = InputManager::getInstance();
+    input.processEvents(InputManager::hostTime());
     if (SceneManager::getInstance().isSceneView()) {
         // Handle gizmo shortcuts
         if (input.isKeyDown(KeyCode::Q)) {
@@ -345,12 +398,16 @@ void Engine::update(float deltaTime) {
     }
 
     bool isPlaying = sceneManager.isPlaying();
+    if (!isPlaying) {
+        // Edit-mode updates touch editor and physics state the frame may still be reading.
+        waitForRenderFrame();
+    }
     if (isPlaying != m_lastPlaying) {
         m_framePacer.reset();
         m_lastPlaying = isPlaying;
     }
 
-    float unscaledDelta = m_framePacer.prepareDelta(deltaTime);
+    float unscaledDelta = m_framePacer.prepareDelta(deltaTime, targetPresentationTime);
     sceneManager.beginFrame();
 
     if (isPlaying && sceneManager.isSceneView()) {
@@ -359,12 +416,7 @@ void Engine::update(float deltaTime) {
 
     if (!isPlaying) {
         sceneManager.updateEditor(unscaledDelta);
-        JobSystem::JobHandle handle = m_audioJobs.createHandle();
-        m_audioJobs.submit([&sceneManager]() {
-            Camera* listenerCamera = sceneManager.getSceneCamera();
-            AudioSystem::getInstance().updateListenerFromCamera(listenerCamera);
-        }, handle);
-        m_audioJobs.wait(handle);
+        AudioSystem::getInstance().updateListenerFromCamera(sceneManager.getSceneCamera());
         input.update();
         return;
     }
@@ -372,61 +424,177 @@ void Engine::update(float deltaTime) {
     Time::update(unscaledDelta);
 
     float fixedStep = sceneManager.getFixedTimeStep();
-    FramePacer::Result pacing = m_framePacer.advance(Time::deltaTime(), fixedStep);
-    float scaledDelta = Time::deltaTime();
+    m_framePacing = m_framePacer.advance(Time::deltaTime(), fixedStep);
+    m_frameScaledDelta = Time::deltaTime();
+    input.prepareFixedSteps(m_framePacing.fixedSteps);
+
+    if (!m_updateGraph.isCompiled()) {
+        buildUpdateGraph();
+    }
+    JobSystem::JobHandle handle = m_updateGraph.run(m_updateJobs);
+    m_updateJobs.wait(handle);
+
+    input.update();
+}
+
+void Engine::updateSceneStreaming() {
+    SceneManager& sceneManager = SceneManager::getInstance();
+    Scene* scene = sceneManager.getActiveScene();
+    SceneStreamer* streamer = scene ? scene->getStreamer() : nullptr;
+    if (!streamer || !streamer->isConfigured()) {
+        return;
+    }
+    // Cells follow whichever camera the scene is being seen through.
+    Camera* camera = sceneManager.isPlaying() ? sceneManager.getGameCamera() : nullptr;
+    if (!camera) {
+        camera = sceneManager.getSceneCamera();
+    }
+    if (camera && camera->getEntity()) {
+        streamer->update(camera->getEntity()->getTransform()->getPosition());
+    }
+}
+
+void Engine::buildUpdateGraph() {
+    SceneManager& sceneManager = SceneManager::getInstance();
+    TaskGraph& graph = m_updateGraph;
+    m_physicsFrameHandle = m_physicsJobs.createHandle();
 
-    TaskGraph graph;
     auto startTask = graph.addTask("Start", [&sceneManager]() {
         sceneManager.updateStart();
     });
-    auto physicsTask = graph.addTask("FixedPhysics", [this, &sceneManager, pacing]() {
-        if (pacing.fixedSteps <= 0) {
+    auto physicsTask = graph.addTask("FixedPhysics", [this, &sceneManager]() {
+        if (m_framePacing.fixedSteps <= 0) {
             return;
         }
-        JobSystem::JobHandle handle = m_physicsJobs.createHandle();
-        m_physicsJobs.submit([&sceneManager, pacing]() {
-            sceneManager.updateFixedPhysics(pacing.fixedStep, pacing.fixedSteps);
-        }, handle);
-        m_physicsJobs.wait(handle);
+        m_physicsJobs.submit([this, &sceneManager]() {
+            sceneManager.updateFixedPhysics(m_framePacing.fixedStep, m_framePacing.fixedSteps);
+        }, m_physicsFrameHandle);
+        m_physicsJobs.wait(m_physicsFrameHandle);
+    });
+    auto fixedComponentsTask = graph.addTask("FixedUpdate", [this, &sceneManager]() {
+        sceneManager.updateFixedComponents(m_framePacing.fixedStep, m_framePacing.fixedSteps, &m_updateJobs);
     });
-    auto fixedComponentsTask = graph.addTask("FixedUpdate", [&sceneManager, pacing]() {
-        sceneManager.updateFixedComponents(pacing.fixedStep, pacing.fixedSteps);
+    // Runs every frame, stepped or not: alpha moves on even when no step was due.
+    // Also the sync point for the fixed phases' recorded structural changes.
+    auto interpolateTask = graph.addTask("PhysicsInterpolate", [this, &sceneManager]() {
+        sceneManager.playbackStructuralChanges();
+        sceneManager.interpolatePhysics(m_framePacing.alpha);
     });
-    auto updateTask = graph.addTask("Update", [&sceneManager, scaledDelta]() {
-        sceneManager.updateVariable(scaledDelta);
+    // Moves queued by last frame's gameplay, so this frame's sees where characters ended up.
+    auto charactersTask = graph.addTask("Characters", [&sceneManager]() {
+        sceneManager.updateCharacters();
     });
+    auto updateTask = graph.addTask("Update", [this, &sceneManager]() {
+        sceneManager.updateVariable(m_frameScaledDelta, true);
+    });
+    auto updateParallelTask = graph.addParallelFor("UpdateParallel",
+        [&sceneManager]() { return sceneManager.getDeferredVariableCount(); },
+        [&sceneManager](size_t begin, size_t end) {
+            sceneManager.updateDeferredVariable(begin, end);
+        });
     graph.addDependency(physicsTask, startTask);
     graph.addDependency(fixedComponentsTask, physicsTask);
-    graph.addDependency(updateTask, fixedComponentsTask);
-
-    auto audioTask = graph.addTask("Audio", [this, &sceneManager]() {
-        JobSystem::JobHandle handle = m_audioJobs.createHandle();
-        m_audioJobs.submit([&sceneManager]() {
-            Camera* listenerCamera = nullptr;
-            if (sceneManager.isPlaying()) {
-                listenerCamera = sceneManager.getGameCamera();
-            }
-            if (!listenerCamera) {
-                listenerCamera = sceneManager.getSceneCamera();
-            }
-            AudioSystem::getInstance().updateListenerFromCamera(listenerCamera);
-        }, handle);
-        m_audioJobs.wait(handle);
+    graph.addDependency(interpolateTask, fixedComponentsTask);
+    graph.addDependency(charactersTask, interpolateTask);
+    graph.addDependency(updateTask, charactersTask);
+    // Animation runs after gameplay so root motion and IK see this frame's transforms.
+    auto animationTask = graph.addParallelFor("AnimationEvaluate",
+        [&sceneManager]() { return sceneManager.getDeferredAnimationCount(); },
+        [&sceneManager](size_t begin, size_t end) {
+            sceneManager.updateDeferredAnimation(begin, end);
+        });
+    auto animationFinalizeTask = graph.addTask("AnimationFinalize", [&sceneManager]() {
+        sceneManager.finalizeDeferredAnimation();
+        sceneManager.playbackStructuralChanges();
+    });
+    graph.addDependency(updateParallelTask, updateTask);
+    graph.addDependency(animationTask, updateParallelTask);
+    graph.addDependency(animationFinalizeTask, animationTask);
+
+    // Only queues the frame's listener and emitter changes; the mixer applies them on its own
+    // thread.
+    auto audioTask = graph.addTask("Audio", [&sceneManager]() {
+        Camera* listenerCamera = nullptr;
+        if (sceneManager.isPlaying()) {
+            listenerCamera = sceneManager.getGameCamera();
+        }
+        if (!listenerCamera) {
+            listenerCamera = sceneManager.getSceneCamera();
+        }
+        AudioSystem::getInstance().updateListenerFromCamera(listenerCamera);
     });
-    graph.addDependency(audioTask, updateTask);
+    graph.addDependency(audioTask, animationFinalizeTask);
 
-    JobSystem::JobHandle handle = graph.run(m_updateJobs);
-    m_updateJobs.wait(handle);
+    graph.compile();
+}
 
-    input.update();
+Renderer* Engine::getRenderer() const {
+    if (m_pipelinedRendering && !RenderSnapshot::isReading()) {
+        waitForRenderFrame();
+    }
+    return m_renderer.get();
+}
+
+void Engine::setPipelinedRendering(bool enabled) {
+    if (m_pipelinedRendering == enabled) {
+        return;
+    }
+    waitForRenderFrame();
+    m_pipelinedRendering = enabled;
+    if (enabled) {
+        RenderSnapshot::setStructuralBarrier([this]() { waitForRenderFrame(); });
+    } else {
+        RenderSnapshot::setStructuralBarrier(nullptr);
+    }
+}
+
+void Engine::waitForRenderFrame() const {
+    if (!m_renderJobs.isComplete(m_renderFrameHandle)) {
+        m_renderJobs.wait(m_renderFrameHandle);
+    }
 }
 
 void Engine::render() {
     if (!m_isInitialized || !m_renderer) {
         return;
     }
+
+    CRESCENT_PROFILE_SCOPE("Engine::render");
+
+    // The previous frame must be done with the snapshot before it is overwritten.
+    waitForRenderFrame();
+    m_renderer->beginEngineFrame();
+    const bool useSnapshot = m_pipelinedRendering;
+    const bool overlapUpdate = useSnapshot && SceneManager::getInstance().isPlaying();
+    Scene* frameScene = SceneManager::getInstance().getActiveScene();
+    if (frameScene) {
+        frameScene->updateTransforms();
+        if (useSnapshot) {
+            frameScene->publishRenderState();
+        }
+    }
+    prepareAnimationPreview(frameScene, useSnapshot);
+
+    // The game camera's look latch and the input the update applied, taken before the next update
+    // can overlap the frame.
+    Renderer::RenderOptions::LateLatch lateLatch;
+    if (m_lowLatencyPresentation && SceneManager::getInstance().isPlaying()) {
+        Camera* gameCamera = SceneManager::getInstance().getGameCamera();
+        if (gameCamera && gameCamera->getLookLatch().frame != 0 && gameCamera->getLookLatch().frame == Time::frameCount()) {
+            const Camera::LookLatch& look = gameCamera->getLookLatch();
+            lateLatch.enabled = true;
+            lateLatch.yawPerUnit = look.yawPerUnit;
+            lateLatch.pitchPerUnit = look.pitchPerUnit;
+            lateLatch.pitch = look.pitch;
+            lateLatch.minPitch = look.minPitch;
+            lateLatch.maxPitch = look.maxPitch;
+            InputManager::getInstance().getAppliedMotion(lateLatch.appliedMotionX, lateLatch.appliedMotionY);
+        }
+    }
     
-    JobSystem::JobHandle handle = m_renderJobs.submit([this]() {
+    m_renderFrameHandle = m_renderJobs.submit([this, useSnapshot, overlapUpdate, lateLatch]() {
+        CRESCENT_PROFILE_SCOPE("Engine::renderFrame");
+        RenderSnapshot::ReadScope snapshotScope(useSnapshot);
         Scene* activeScene = SceneManager::getInstance().getActiveScene();
         if (!activeScene) {
             return;
@@ -448,9 +616,15 @@ void Engine::render() {
 
         auto* debugRenderer = m_renderer->getDebugRenderer();
         const auto& selection = SelectionSystem::getSelection();
+        bool viewRendered = false;
 
-        // Scene view render (editor camera)
+        SceneRedraw sceneRedraw = SceneRedraw::Skip;
         if (renderSceneSurface) {
+            sceneRedraw = evaluateSceneRedraw(activeScene, SceneManager::getInstance().getSceneCamera());
+        }
+
+        // Scene view render (editor camera)
+        if (sceneRedraw != SceneRedraw::Skip) {
             m_renderer->setRenderTargetPool(Renderer::RenderTargetPool::Scene);
             m_renderer->setMetalLayer(m_sceneSurface.layer, false);
             m_renderer->setViewportSize(m_sceneSurface.width, m_sceneSurface.height, true);
@@ -476,16 +650,24 @@ void Engine::render() {
                 }
             }
 
-            if (activeScene && debugRenderer) {
+            // Jolt bodies are not snapshotted; skip the overlay while update steps physics.
+            if (activeScene && debugRenderer && !overlapUpdate) {
                 if (auto* physics = activeScene->getPhysicsWorld()) {
                     physics->debugDraw(debugRenderer);
                 }
             }
 
+            // Refinement frames accumulate TAA/SSR/SSAO history from a clean start; animation LOD
+            // stays driven by the game view.
+            const bool refine = sceneRedraw == SceneRedraw::Refine;
             Renderer::RenderOptions sceneOptions;
-            sceneOptions.allowTemporal = false;
-            sceneOptions.updateHistory = false;
+            sceneOptions.allowTemporal = refine;
+            sceneOptions.updateHistory = refine;
+            sceneOptions.resetHistory = refine && !m_sceneHistoryLive;
+            sceneOptions.driveAnimationLod = false;
+            m_sceneHistoryLive = refine;
             m_renderer->renderScene(activeScene, sceneCamera, sceneOptions);
+            viewRendered = true;
         }
 
         // Game view render (runtime camera)
@@ -503,36 +685,123 @@ void Engine::render() {
                 Renderer::RenderOptions gameOptions;
                 gameOptions.allowTemporal = true;
                 gameOptions.updateHistory = true;
+                gameOptions.lateLatch = lateLatch;
                 m_renderer->renderScene(activeScene, gameCamera, gameOptions);
+                viewRendered = true;
             }
         }
 
-        if (renderPreviewSurface) {
-            Scene* previewScene = ensureAnimationPreviewScene(activeScene);
-            Camera* previewCamera = ensureAnimationPreviewCamera(previewScene);
-            Entity* previewTarget = resolveAnimationPreviewTarget(previewScene);
-            if (previewCamera && previewTarget) {
-                applyAnimationPreviewPlayback(previewTarget);
-                frameAnimationPreviewCamera(previewCamera, previewTarget);
-                m_renderer->setRenderTargetPool(Renderer::RenderTargetPool::Preview);
-                m_renderer->setMetalLayer(m_previewSurface.layer, false);
-                m_renderer->setViewportSize(m_previewSurface.width, m_previewSurface.height, true);
-                if (debugRenderer) {
-                    debugRenderer->setGridEnabled(false);
-                    debugRenderer->clear();
-                }
-
-                Renderer::RenderOptions previewOptions;
-                previewOptions.allowTemporal = false;
-                previewOptions.updateHistory = false;
-                m_renderer->renderScene(previewScene, previewCamera, previewOptions);
+        // Set up and published by prepareAnimationPreview before the job was queued.
+        if (renderPreviewSurface && m_previewFrameScene) {
+            m_renderer->setRenderTargetPool(Renderer::RenderTargetPool::Preview);
+            m_renderer->setMetalLayer(m_previewSurface.layer, false);
+            m_renderer->setViewportSize(m_previewSurface.width, m_previewSurface.height, true);
+            if (debugRenderer) {
+                debugRenderer->setGridEnabled(false);
+                debugRenderer->clear();
             }
+
+            Renderer::RenderOptions previewOptions;
+            previewOptions.allowTemporal = false;
+            previewOptions.updateHistory = false;
+            m_renderer->renderScene(m_previewFrameScene, m_previewFrameCamera, previewOptions);
+            viewRendered = true;
+        }
+
+        // With every view idle, streaming, pipeline compiles and bakes still need servicing; any
+        // of them finishing changes what the views would show.
+        if (!viewRendered && m_renderer->updateIdleFrame()) {
+            requestEditorRedraw();
         }
     });
-    m_renderJobs.wait(handle);
+    if (!overlapUpdate) {
+        m_renderJobs.wait(m_renderFrameHandle);
+    }
+}
+
+void Engine::setLowLatencyPresentation(bool enabled) {
+    waitForRenderFrame();
+    m_lowLatencyPresentation = enabled;
+    if (m_renderer) {
+        m_renderer->setLowLatencyPresentation(enabled);
+    }
+}
+
+void Engine::setEditorRedrawOnDemand(bool enabled) {
+    waitForRenderFrame();
+    m_editorRedrawOnDemand = enabled;
+    requestEditorRedraw();
+}
+
+void Engine::requestEditorRedraw() {
+    m_sceneRedrawRequested.store(true, std::memory_order_relaxed);
+    m_previewRedrawRequested.store(true, std::memory_order_relaxed);
+}
+
+Engine::SceneRedraw Engine::evaluateSceneRedraw(Scene* scene, Camera* camera) {
+    constexpr uint32_t kRefineFrames = 8;
+    constexpr auto kIdleRefresh = std::chrono::seconds(1);
+
+    const bool requested = m_sceneRedrawRequested.exchange(false, std::memory_order_relaxed);
+    if (!m_editorRedrawOnDemand || SceneManager::getInstance().isPlaying() || !camera) {
+        m_sceneViewSignature.valid = false;
+        return SceneRedraw::Draw;
+    }
+
+    SceneViewSignature current;
+    current.scene = scene;
+    current.sceneVersion = scene ? scene->getChangeLog().getVersion() : 0;
+    current.view = camera->getViewMatrix();
+    current.projection = camera->getProjectionMatrix();
+    current.selection = SelectionSystem::getSelection();
+    current.layer = m_sceneSurface.layer;
+    current.width = m_sceneSurface.width;
+    current.height = m_sceneSurface.height;
+    current.valid = true;
+
+    const SceneViewSignature& last = m_sceneViewSignature;
+    const bool changed = requested
+        || !last.valid
+        || current.scene != last.scene
+        || current.sceneVersion != last.sceneVersion
+        || std::memcmp(&current.view, &last.view, sizeof(Math::Matrix4x4)) != 0
+        || std::memcmp(&current.projection, &last.projection, sizeof(Math::Matrix4x4)) != 0
+        || current.selection != last.selection
+        || current.layer != last.layer
+        || current.width != last.width
+        || current.height != last.height
+        || (m_gizmoSystem && m_gizmoSystem->isManipulating());
+    m_sceneViewSignature = std::move(current);
+
+    const auto now = std::chrono::steady_clock::now();
+    if (changed) {
+        m_sceneRefineFrames = kRefineFrames;
+        m_lastSceneRedraw = now;
+        return SceneRedraw::Draw;
+    }
+    if (m_sceneRefineFrames > 0) {
+        --m_sceneRefineFrames;
+        m_lastSceneRedraw = now;
+        return SceneRedraw::Refine;
+    }
+    // A slow heartbeat catches edits that bypass the change log (asset reloads, material tweaks).
+    if (now - m_lastSceneRedraw >= kIdleRefresh) {
+        m_lastSceneRedraw = now;
+        return SceneRedraw::Refine;
+    }
+    return SceneRedraw::Skip;
+}
+
+bool Engine::evaluatePreviewRedraw() {
+    const bool requested = m_previewRedrawRequested.exchange(false, std::memory_order_relaxed);
+    if (!m_editorRedrawOnDemand || SceneManager::getInstance().isPlaying()) {
+        return true;
+    }
+    return requested || m_animationPreviewPlaybackState.playing || m_animationPreviewSceneDirty;
 }
 
 void Engine::setSceneMetalLayer(void* layer) {
+    waitForRenderFrame();
     m_sceneSurface.layer = layer;
     if (m_renderer && layer) {
         m_renderer->setRenderTargetPool(Renderer::RenderTargetPool::Scene);
@@ -541,6 +810,7 @@ void Engine::setSceneMetalLayer(void* layer) {
 }
 
 void Engine::setGameMetalLayer(void* layer) {
+    waitForRenderFrame();
     m_gameSurface.layer = layer;
     if (m_renderer && layer) {
         m_renderer->setRenderTargetPool(Renderer::RenderTargetPool::Game);
@@ -549,7 +819,9 @@ void Engine::setGameMetalLayer(void* layer) {
 }
 
 void Engine::setPreviewMetalLayer(void* layer) {
+    waitForRenderFrame();
     m_previewSurface.layer = layer;
+    m_previewRedrawRequested.store(true, std::memory_order_relaxed);
     if (m_renderer && layer) {
         m_renderer->setRenderTargetPool(Renderer::RenderTargetPool::Preview);
         m_renderer->setMetalLayer(layer, true);
@@ -557,29 +829,37 @@ void Engine::setPreviewMetalLayer(void* layer) {
 }
 
 void Engine::resizeScene(float width, float height) {
+    waitForRenderFrame();
     m_sceneSurface.width = width;
     m_sceneSurface.height = height;
 }
 
 void Engine::resizeGame(float width, float height) {
+    waitForRenderFrame();
     m_gameSurface.width = width;
     m_gameSurface.height = height;
 }
 
 void Engine::resizePreview(float width, float height) {
+    waitForRenderFrame();
     m_previewSurface.width = width;
     m_previewSurface.height = height;
+    m_previewRedrawRequested.store(true, std::memory_order_relaxed);
 }
 
 void Engine::setAnimationPreviewTargetUUID(const std::string& uuid) {
+    waitForRenderFrame();
     if (m_animationPreviewTargetUUID != uuid) {
         m_animationPreviewSceneDirty = true;
     }
     m_animationPreviewTargetUUID = uuid;
+    m_previewRedrawRequested.store(true, std::memory_order_relaxed);
 }
 
 void Engine::setAnimationPreviewPlaybackState(const AnimationPreviewPlaybackState& state) {
+    waitForRenderFrame();
     m_animationPreviewPlaybackState = state;
+    m_previewRedrawRequested.store(true, std::memory_order_relaxed);
 }
 
 Entity* Engine::ensureAnimationPreviewCameraEntity(Scene* scene) {
@@ -649,6 +929,28 @@ static Crescent::Entity* EnsureAnimationPreviewLightEntity(Crescent::Scene* scen
     return lightEntity;
 }
 
+void Engine::prepareAnimationPreview(Scene* activeScene, bool publish) {
+    m_previewFrameScene = nullptr;
+    m_previewFrameCamera = nullptr;
+    if (!activeScene || !m_previewSurface.isValid() || !evaluatePreviewRedraw()) {
+        return;
+    }
+    Scene* previewScene = ensureAnimationPreviewScene(activeScene);
+    Camera* previewCamera = ensureAnimationPreviewCamera(previewScene);
+    Entity* previewTarget = resolveAnimationPreviewTarget(previewScene);
+    if (!previewCamera || !previewTarget) {
+        return;
+    }
+    applyAnimationPreviewPlayback(previewTarget);
+    frameAnimationPreviewCamera(previewCamera, previewTarget);
+    previewScene->updateTransforms();
+    if (publish) {
+        previewScene->publishRenderState();
+    }
+    m_previewFrameScene = previewScene;
+    m_previewFrameCamera = previewCamera;
+}
+
 Camera* Engine::ensureAnimationPreviewCamera(Scene* scene) {
     Entity* entity = ensureAnimationPreviewCameraEntity(scene);
     return entity ? entity->getComponent<Camera>() : nullptr;
@@ -753,93 +1055,53 @@ void Engine::frameAnimationPreviewCamera(Camera* camera, Entity* targetEntity) {
 // INPUT HANDLING
 // ============================================================================
 
-void Engine::handleKeyDown(unsigned short keyCode) {
-    InputManager& input = InputManager::getInstance();
-    
-    // Map macOS key codes to our KeyCode enum
-    KeyCode key = KeyCode::Unknown;
-    
-    switch (keyCode) {
-        case 13: key = KeyCode::W; break;
-        case 0:  key = KeyCode::A; break;
-        case 1:  key = KeyCode::S; break;
-        case 2:  key = KeyCode::D; break;
-        case 12: key = KeyCode::Q; break;
-        case 14: key = KeyCode::E; break;
-        case 15: key = KeyCode::R; break;
-        case 49: key = KeyCode::Space; break;
-        case 56: key = KeyCode::Shift; break;
-        case 60: key = KeyCode::Shift; break;
-        case 59: key = KeyCode::Control; break;
-        case 62: key = KeyCode::Control; break;
-        case 58: key = KeyCode::Alt; break;
-        case 61: key = KeyCode::Alt; break;
-        case 55: key = KeyCode::Command; break;
-        case 54: key = KeyCode::Command; break;
-        case 53: key = KeyCode::Escape; break;
-        default: break;
-    }
-    
-    if (key != KeyCode::Unknown) {
-        input.setKeyPressed(key, true);
+void Engine::handleKeyDown(unsigned short keyCode, double timestamp) {
+    KeyCode key = MapPlatformKeyCode(keyCode);
+    if (key == KeyCode::Unknown) {
+        return;
     }
-
+    InputEvent event;
+    event.type = InputEventType::KeyDown;
+    event.code = static_cast<int>(key);
+    event.timestamp = timestamp;
+    InputManager::getInstance().queueEvent(event);
+    requestEditorRedraw();
 }
 
-void Engine::handleKeyUp(unsigned short keyCode) {
-    InputManager& input = InputManager::getInstance();
-    
-    // Map macOS key codes to our KeyCode enum
-    KeyCode key = KeyCode::Unknown;
-    
-    switch (keyCode) {
-        case 13: key = KeyCode::W; break;
-        case 0:  key = KeyCode::A; break;
-        case 1:  key = KeyCode::S; break;
-        case 2:  key = KeyCode::D; break;
-        case 12: key = KeyCode::Q; break;
-        case 14: key = KeyCode::E; break;
-        case 15: key = KeyCode::R; break;
-        case 49: key = KeyCode::Space; break;
-        case 56: key = KeyCode::Shift; break;
-        case 60: key = KeyCode::Shift; break;
-        case 59: key = KeyCode::Control; break;
-        case 62: key = KeyCode::Control; break;
-        case 58: key = KeyCode::Alt; break;
-        case 61: key = KeyCode::Alt; break;
-        case 55: key = KeyCode::Command; break;
-        case 54: key = KeyCode::Command; break;
-        case 53: key = KeyCode::Escape; break;
-        default: break;
-    }
-    
-    if (key != KeyCode::Unknown) {
-        input.setKeyPressed(key, false);
+void Engine::handleKeyUp(unsigned short keyCode, double timestamp) {
+    KeyCode key = MapPlatformKeyCode(keyCode);
+    if (key == KeyCode::Unknown) {
+        return;
     }
-
+    InputEvent event;
+    event.type = InputEventType::KeyUp;
+    event.code = static_cast<int>(key);
+    event.timestamp = timestamp;
+    InputManager::getInstance().queueEvent(event);
+    requestEditorRedraw();
 }
 
-void Engine::handleMouseMove(float deltaX, float deltaY) {
-    InputManager& input = InputManager::getInstance();
-    
-    // Accumulate mouse delta (will be cleared after scene update)
-    Math::Vector2 currentDelta = input.getMouseDelta();
-    input.setMouseDelta(Math::Vector2(currentDelta.x + deltaX, currentDelta.y + deltaY));
+void Engine::handleMouseMove(float deltaX, float deltaY, double timestamp) {
+    InputEvent event;
+    event.type = InputEventType::MouseMove;
+    event.deltaX = deltaX;
+    event.deltaY = deltaY;
+    event.timestamp = timestamp;
+    // Accumulated into the mouse delta when the next update applies it
+    InputManager::getInstance().queueEvent(event);
+    requestEditorRedraw();
     
     if (kInputDebug) {
-        static int debugCount = 0;
+        static std::atomic<int> debugCount{0};
         if (debugCount < 10 && (deltaX != 0.0f || deltaY != 0.0f)) {
             std::cout << "[ENGINE] Mouse delta: (" << deltaX << ", " << deltaY
-                      << ") | Total accumulated: (" << (currentDelta.x + deltaX)
-                      << ", " << (currentDelta.y + deltaY) << ")" << std::endl;
+                      << ") at " << timestamp << std::endl;
             debugCount++;
         }
     }
 }
 
-void Engine::handleMouseButton(int button, bool pressed) {
-    InputManager& input = InputManager::getInstance();
-    
+void Engine::handleMouseButton(int button, bool pressed, double timestamp) {
     MouseButton mouseBtn = MouseButton::Left;
     switch (button) {
         case 0: mouseBtn = MouseButton::Left; break;
@@ -848,10 +1110,15 @@ void Engine::handleMouseButton(int button, bool pressed) {
         default: return;
     }
     
-    input.setMouseButtonPressed(mouseBtn, pressed);
+    InputEvent event;
+    event.type = pressed ? InputEventType::MouseButtonDown : InputEventType::MouseButtonUp;
+    event.code = static_cast<int>(mouseBtn);
+    event.timestamp = timestamp;
+    InputManager::getInstance().queueEvent(event);
+    requestEditorRedraw();
     
     if (kInputDebug) {
-        static int buttonDebugCount = 0;
+        static std::atomic<int> buttonDebugCount{0};
         if (buttonDebugCount < 5) {
             std::cout << "[ENGINE] Mouse button " << button << " "
                       << (pressed ? "PRESSED" : "RELEASED") << std::endl;
@@ -903,7 +1170,34 @@ void Engine::handleMouseClick(float x, float y, float screenWidth, float screenH
         }
     }
     
-    // No gizmo interaction, do entity selection
+    // No gizmo interaction, do entity selection. The GPU pick resolves the exact pixel under the
+    // cursor in a frame or two; without it, raycast the entities' bounds now.
+    Renderer* renderer = m_renderer.get();
+    if (renderer && renderer->isPickingAvailable()) {
+        EntityPicker::Request request;
+        request.x0 = request.x1 = x;
+        request.y0 = request.y1 = y;
+        request.viewportWidth = screenWidth;
+        request.viewportHeight = screenHeight;
+        m_pickRequestId = renderer->requestPick(request);
+        m_pickAdditive = additive;
+        m_pickMarquee = false;
+        m_pickClick = Math::Vector4(x, y, screenWidth, screenHeight);
+        // The pick pass rides on the scene view's next render.
+        m_sceneRedrawRequested.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    selectByRaycast(x, y, screenWidth, screenHeight, additive);
+}
+
+void Engine::selectByRaycast(float x, float y, float screenWidth, float screenHeight, bool additive) {
+    Scene* activeScene = SceneManager::getInstance().getActiveScene();
+    Camera* mainCamera = Camera::getMainCamera();
+    if (!activeScene || !mainCamera) {
+        return;
+    }
+
     Ray ray = SelectionSystem::screenPointToRay(
         Math::Vector2(x, y),
         Math::Vector2(screenWidth, screenHeight),
@@ -915,14 +1209,12 @@ void Engine::handleMouseClick(float x, float y, float screenWidth, float screenH
                   << " dir=(" << ray.direction.x << "," << ray.direction.y << "," << ray.direction.z << ")" << std::endl;
     }
     
-    // Get all entities from scene
-    std::vector<Entity*> entities = SceneCommands::getAllEntities(activeScene);
     if (kInputDebug) {
-        std::cout << "[RAYCAST] Testing against " << entities.size() << " entities" << std::endl;
+        std::cout << "[RAYCAST] Testing against " << activeScene->getSpatialIndex().size() << " indexed entities" << std::endl;
     }
     
     // Raycast
-    RaycastHit hit = SelectionSystem::raycastAll(ray, entities);
+    RaycastHit hit = SelectionSystem::raycastScene(ray, activeScene);
     
     if (hit.hit) {
         if (additive) {
@@ -942,6 +1234,96 @@ void Engine::handleMouseClick(float x, float y, float screenWidth, float screenH
     }
 }
 
+void Engine::handleMarqueeSelect(float x0, float y0, float x1, float y1, float screenWidth, float screenHeight, bool additive) {
+    if (!SceneManager::getInstance().isSceneView() || SceneManager::getInstance().isPlaying()) {
+        return;
+    }
+    // A drag that started on the gizmo manipulated it instead.
+    if (m_gizmoSystem && m_gizmoSystem->isManipulating()) {
+        return;
+    }
+    Renderer* renderer = m_renderer.get();
+    if (!renderer || !renderer->isPickingAvailable()) {
+        return;
+    }
+    EntityPicker::Request request;
+    request.x0 = x0;
+    request.y0 = y0;
+    request.x1 = x1;
+    request.y1 = y1;
+    request.viewportWidth = screenWidth;
+    request.viewportHeight = screenHeight;
+    m_pickRequestId = renderer->requestPick(request);
+    m_pickAdditive = additive;
+    m_pickMarquee = true;
+    m_sceneRedrawRequested.store(true, std::memory_order_relaxed);
+}
+
+void Engine::applyPickResults() {
+    if (!m_renderer) {
+        return;
+    }
+    EntityPicker::Result result;
+    while (m_renderer->takePickResult(result)) {
+        // Only the latest request counts; a click superseded by another is dropped.
+        if (result.id == 0 || result.id != m_pickRequestId) {
+            continue;
+        }
+        m_pickRequestId = 0;
+        Scene* activeScene = SceneManager::getInstance().getActiveScene();
+        if (!activeScene || SceneManager::getInstance().isPlaying()) {
+            continue;
+        }
+
+        // One pass over the scene maps the dense indices back, keeping the pick's coverage order.
+        std::unordered_map<uint32_t, size_t> slots;
+        slots.reserve(result.entityIndices.size());
+        for (size_t i = 0; i < result.entityIndices.size(); ++i) {
+            slots.emplace(result.entityIndices[i], i);
+        }
+        std::vector<Entity*> resolved(result.entityIndices.size(), nullptr);
+        for (const auto& entity : activeScene->getAllEntities()) {
+            auto slot = entity ? slots.find(entity->getIndex()) : slots.end();
+            if (slot != slots.end() && SelectionSystem::isPickable(entity.get())) {
+                resolved[slot->second] = entity.get();
+            }
+        }
+        std::vector<Entity*> picked;
+        picked.reserve(resolved.size());
+        for (Entity* entity : resolved) {
+            if (entity) {
+                picked.push_back(entity);
+            }
+        }
+
+        if (m_pickMarquee) {
+            if (m_pickAdditive) {
+                std::vector<Entity*> selection = SelectionSystem::getSelection();
+                for (Entity* entity : picked) {
+                    if (std::find(selection.begin(), selection.end(), entity) == selection.end()) {
+                        selection.push_back(entity);
+                    }
+                }
+                SelectionSystem::setSelection(selection);
+            } else {
+                SelectionSystem::setSelection(picked);
+            }
+        } else if (!picked.empty()) {
+            if (m_pickAdditive) {
+                SelectionSystem::toggleSelection(picked.front());
+            } else {
+                SelectionSystem::setSelectedEntity(picked.front());
+            }
+            if (kInputDebug) {
+                std::cout << "[PICK] Selected: " << picked.front()->getName() << std::endl;
+            }
+        } else {
+            // The ID pass leaves out instanced and foliage draws; their bounds may still be hit.
+            selectByRaycast(m_pickClick.x, m_pickClick.y, m_pickClick.z, m_pickClick.w, m_pickAdditive);
+        }
+    }
+}
+
 void Engine::handleMouseDrag(float x, float y, float screenWidth, float screenHeight) {
     if (!SceneManager::getInstance().isSceneView()) {
         return;
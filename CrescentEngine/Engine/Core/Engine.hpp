@@ -1,10 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
 #include "GizmoSystem.hpp"
 #include "JobSystem.hpp"
+#include "TaskGraph.hpp"
 #include "FramePacer.hpp"
 
 namespace Crescent {
@@ -37,7 +40,8 @@ public:
     void shutdown();
     
     // Update engine per frame
-    void update(float deltaTime);
+    // targetPresentationTime: when the display link will present this frame, 0 if unknown.
+    void update(float deltaTime, double targetPresentationTime = 0.0);
     
     // Render frame
     void render();
@@ -52,16 +56,21 @@ public:
     void setAnimationPreviewTargetUUID(const std::string& uuid);
     void setAnimationPreviewPlaybackState(const AnimationPreviewPlaybackState& state);
     
-    // Input handling
-    void handleKeyDown(unsigned short keyCode);
-    void handleKeyUp(unsigned short keyCode);
-    void handleMouseMove(float deltaX, float deltaY);
-    void handleMouseButton(int button, bool pressed);
+    // Input handling. Thread safe: events are queued with their host timestamps (0 stamps the event
+    // on arrival) and applied at the start of the next update.
+    void handleKeyDown(unsigned short keyCode, double timestamp = 0.0);
+    void handleKeyUp(unsigned short keyCode, double timestamp = 0.0);
+    void handleMouseMove(float deltaX, float deltaY, double timestamp = 0.0);
+    void handleMouseButton(int button, bool pressed, double timestamp = 0.0);
     
     // Mouse picking and gizmo interaction
     void handleMouseClick(float x, float y, float screenWidth, float screenHeight, bool additive);
     void handleMouseDrag(float x, float y, float screenWidth, float screenHeight);
     void handleMouseUp();
+    bool isGizmoManipulating() const { return m_gizmoSystem && m_gizmoSystem->isManipulating(); }
+    // Selects the pickable entities a scene view rectangle shows (the coordinates handleMouseClick
+    // takes), adding to the selection when additive. Resolved from a GPU pick a frame or two later.
+    void handleMarqueeSelect(float x0, float y0, float x1, float y1, float screenWidth, float screenHeight, bool additive);
     
     // Gizmo controls
     void setGizmoMode(GizmoMode mode);
@@ -70,8 +79,27 @@ public:
     void toggleGizmoSpace(); // E key - toggle world/local
     GizmoSystem* getGizmoSystem() const { return m_gizmoSystem.get(); }
     
-    // Get renderer instance
-    Renderer* getRenderer() const { return m_renderer.get(); }
+    // Get renderer instance. With pipelined rendering this first waits for the frame that is
+    // still encoding, so callers never touch renderer state concurrently with it.
+    Renderer* getRenderer() const;
+
+    // Opt-in pipelined frames: render() publishes a render snapshot and returns while the frame
+    // encodes, so the next update() overlaps it (play mode only; edit mode stays serial).
+    void setPipelinedRendering(bool enabled);
+    bool isPipelinedRendering() const { return m_pipelinedRendering; }
+
+    // Edit-mode redraw on demand: the scene view only renders when its camera, selection, surface or
+    // scene changed (or a gizmo is being dragged), then refines its temporal effects over a few
+    // frames after it settles. The animation preview only renders while playing or after an edit.
+    void setEditorRedrawOnDemand(bool enabled);
+    bool isEditorRedrawOnDemand() const { return m_editorRedrawOnDemand; }
+    // Marks the editor views dirty for the next render(); safe to call from any thread.
+    void requestEditorRedraw();
+
+    // Low-latency presentation: fewer drawables queued, paced presents, and the game view re-aimed
+    // at mouse motion that arrived after the update just before the frame is committed.
+    void setLowLatencyPresentation(bool enabled);
+    bool isLowLatencyPresentation() const { return m_lowLatencyPresentation; }
     
     // Get singleton instance
     static Engine& getInstance();
@@ -100,6 +128,15 @@ private:
     float m_lastMouseX;
     float m_lastMouseY;
 
+    // Outstanding GPU pick (0 when none) and how its result is applied to the selection.
+    uint64_t m_pickRequestId = 0;
+    bool m_pickAdditive = false;
+    bool m_pickMarquee = false;
+    // The click behind a point pick, raycast instead when the pick finds nothing.
+    Math::Vector4 m_pickClick;
+    void applyPickResults();
+    void selectByRaycast(float x, float y, float screenWidth, float screenHeight, bool additive);
+
     RenderSurface m_sceneSurface;
     RenderSurface m_gameSurface;
     RenderSurface m_previewSurface;
@@ -108,20 +145,67 @@ private:
     std::unique_ptr<Scene> m_animationPreviewScene;
     Scene* m_animationPreviewSourceScene = nullptr;
     bool m_animationPreviewSceneDirty = true;
+    // What prepareAnimationPreview set up for the frame being encoded; null when the preview
+    // view is idle.
+    Scene* m_previewFrameScene = nullptr;
+    class Camera* m_previewFrameCamera = nullptr;
 
     JobSystem m_updateJobs;
     JobSystem m_physicsJobs;
-    JobSystem m_audioJobs;
     JobSystem m_renderJobs;
     FramePacer m_framePacer;
     bool m_lastPlaying = false;
 
+    // Play-mode frame graph, built once and replayed each update with the pacing below.
+    TaskGraph m_updateGraph;
+    FramePacer::Result m_framePacing;
+    float m_frameScaledDelta = 0.0f;
+    JobSystem::JobHandle m_physicsFrameHandle;
+    void buildUpdateGraph();
+    // Streams the active scene's world partition cells around the viewing camera.
+    void updateSceneStreaming();
+
+    bool m_pipelinedRendering = false;
+    JobSystem::JobHandle m_renderFrameHandle;
+    void waitForRenderFrame() const;
+
+    // What the scene view last rendered; a difference means it is stale.
+    struct SceneViewSignature {
+        const Scene* scene = nullptr;
+        uint64_t sceneVersion = 0;
+        Math::Matrix4x4 view;
+        Math::Matrix4x4 projection;
+        std::vector<Entity*> selection;
+        void* layer = nullptr;
+        float width = 0.0f;
+        float height = 0.0f;
+        bool valid = false;
+    };
+    enum class SceneRedraw {
+        Skip,   // nothing changed; the drawable keeps the last image
+        Draw,   // changed this frame: draw without temporal history
+        Refine  // settled: accumulate temporal history for a few frames
+    };
+    bool m_editorRedrawOnDemand = true;
+    bool m_lowLatencyPresentation = false;
+    std::atomic<bool> m_sceneRedrawRequested{true};
+    std::atomic<bool> m_previewRedrawRequested{true};
+    SceneViewSignature m_sceneViewSignature;
+    uint32_t m_sceneRefineFrames = 0;
+    bool m_sceneHistoryLive = false;
+    std::chrono::steady_clock::time_point m_lastSceneRedraw;
+    SceneRedraw evaluateSceneRedraw(Scene* scene, Camera* camera);
+    bool evaluatePreviewRedraw();
+
     class Camera* ensureAnimationPreviewCamera(Scene* scene);
     class Entity* ensureAnimationPreviewCameraEntity(Scene* scene);
     class Entity* resolveAnimationPreviewTarget(Scene* scene);
     void frameAnimationPreviewCamera(class Camera* camera, class Entity* targetEntity);
     class Scene* ensureAnimationPreviewScene(Scene* sourceScene);
     void applyAnimationPreviewPlayback(class Entity* targetEntity);
+    // Builds, poses and frames the preview scene on the update side of a frame and publishes it
+    // alongside the active scene, so the render job only reads it.
+    void prepareAnimationPreview(Scene* activeScene, bool publish);
     
     // Singleton instance
     static Engine* s_instance;
@@ -0,0 +1,80 @@
+#include "FrameArena.hpp"
+#include <algorithm>
+
+namespace Crescent {
+
+namespace {
+constexpr size_t kMinBlockSize = 64 * 1024;
+
+size_t AlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+FrameArena::FrameArena(size_t initialCapacity) {
+    m_blocks.reserve(8);
+    if (initialCapacity > 0) {
+        addBlock(initialCapacity);
+    }
+    // The first block is not a per-frame allocation.
+    m_heapAllocations = 0;
+}
+
+size_t FrameArena::capacity() const {
+    size_t total = 0;
+    for (const auto& block : m_blocks) {
+        total += block.size;
+    }
+    return total;
+}
+
+void FrameArena::addBlock(size_t minBytes) {
+    const size_t previous = m_blocks.empty() ? 0 : m_blocks.back().size;
+    const size_t size = std::max({minBytes, previous * 2, kMinBlockSize});
+    Block block;
+    block.data.reset(new std::byte[size]);
+    block.size = size;
+    m_blocks.push_back(std::move(block));
+    m_block = m_blocks.size() - 1;
+    m_offset = 0;
+    m_heapAllocations++;
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    if (bytes == 0) {
+        bytes = 1;
+    }
+    alignment = std::max<size_t>(alignment, 1);
+    while (m_block < m_blocks.size()) {
+        Block& block = m_blocks[m_block];
+        const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        const size_t start = AlignUp(base + m_offset, alignment) - base;
+        if (start + bytes <= block.size) {
+            m_used += (start - m_offset) + bytes;
+            m_offset = start + bytes;
+            return block.data.get() + start;
+        }
+        if (m_block + 1 >= m_blocks.size()) {
+            break;
+        }
+        m_block++;
+        m_offset = 0;
+    }
+    addBlock(bytes + alignment);
+    return allocate(bytes, alignment);
+}
+
+void FrameArena::reset() {
+    m_highWater = std::max(m_highWater, m_used);
+    if (m_blocks.size() > 1) {
+        // Replace the spilled chain with one block that holds the whole frame.
+        m_blocks.clear();
+        addBlock(m_highWater + m_highWater / 4);
+    }
+    m_block = 0;
+    m_offset = 0;
+    m_used = 0;
+    m_heapAllocations = 0;
+}
+
+} // namespace Crescent
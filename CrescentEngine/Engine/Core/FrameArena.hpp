@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace Crescent {
+
+// Linear allocator for CPU data that lives for one frame. Allocation bumps an offset and
+// deallocation is a no-op; reset() rewinds everything at once. When a frame outgrows the
+// arena it spills into extra heap blocks, and the next reset() folds them into a single block
+// sized to the high-water mark, so a warmed-up arena stops touching the heap.
+class FrameArena {
+public:
+    static constexpr size_t kDefaultCapacity = 256 * 1024;
+
+    explicit FrameArena(size_t initialCapacity = kDefaultCapacity);
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+    void reset();
+
+    size_t bytesUsed() const { return m_used; }
+    size_t capacity() const;
+    // Heap blocks requested since the last reset(); zero in steady state.
+    uint32_t heapAllocations() const { return m_heapAllocations; }
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size = 0;
+    };
+
+    void addBlock(size_t minBytes);
+
+    std::vector<Block> m_blocks;
+    size_t m_block = 0;
+    size_t m_offset = 0;
+    size_t m_used = 0;
+    size_t m_highWater = 0;
+    uint32_t m_heapAllocations = 0;
+};
+
+// Standard allocator over a FrameArena, for containers that must not outlive the frame.
+template <typename T>
+class FrameAllocator {
+public:
+    using value_type = T;
+
+    FrameAllocator(FrameArena& arena) noexcept : m_arena(&arena) {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& other) noexcept : m_arena(other.arena()) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) noexcept {}
+
+    FrameArena* arena() const noexcept { return m_arena; }
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U>& other) const noexcept { return m_arena == other.arena(); }
+    template <typename U>
+    bool operator!=(const FrameAllocator<U>& other) const noexcept { return m_arena != other.arena(); }
+
+private:
+    FrameArena* m_arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+template <typename T, typename Hash = std::hash<T>>
+using FrameUnorderedSet = std::unordered_set<T, Hash, std::equal_to<T>, FrameAllocator<T>>;
+
+template <typename K, typename V, typename Hash = std::hash<K>>
+using FrameUnorderedMap = std::unordered_map<K, V, Hash, std::equal_to<K>, FrameAllocator<std::pair<const K, V>>>;
+
+} // namespace Crescent
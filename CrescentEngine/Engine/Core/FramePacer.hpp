@@ -26,6 +26,19 @@ public:
         return clamped;
     }
 
+    // With the display's target presentation time for the frame, the delta is the interval
+    // between successive presentations, which is what the frame is on screen for; the measured
+    // delta is only used until two timestamps are in or when the timestamps do not advance.
+    float prepareDelta(float unscaledDelta, double targetPresentationTime) {
+        if (targetPresentationTime > 0.0) {
+            if (m_lastPresentationTime > 0.0 && targetPresentationTime > m_lastPresentationTime) {
+                unscaledDelta = static_cast<float>(targetPresentationTime - m_lastPresentationTime);
+            }
+            m_lastPresentationTime = targetPresentationTime;
+        }
+        return prepareDelta(unscaledDelta);
+    }
+
     Result advance(float scaledDelta, float fixedStep) {
         Result result;
         result.scaledDelta = std::max(0.0f, scaledDelta);
@@ -51,6 +64,7 @@ public:
     void reset() {
         m_accumulator = 0.0f;
         m_smoothedDelta = 0.0f;
+        m_lastPresentationTime = 0.0;
     }
 
     void setMaxDelta(float maxDelta) { m_maxDelta = std::max(0.0f, maxDelta); }
@@ -67,6 +81,7 @@ private:
     float m_maxAccumulatorMultiplier = 4.0f;
     float m_smoothing = 0.0f;
     float m_smoothedDelta = 0.0f;
+    double m_lastPresentationTime = 0.0;
 };
 
 } // namespace Crescent
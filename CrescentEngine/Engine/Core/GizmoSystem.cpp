@@ -226,11 +226,18 @@ void GizmoSystem::drawMeshWire(Entity* entity, MeshRenderer* meshRenderer, const
     auto mesh = meshRenderer->getMesh();
     if (!mesh) return;
     
+    Math::Matrix4x4 world = entity->getTransform()->getWorldMatrix();
+
+    // The GPU shades the edges of the mesh's own triangles, at any triangle count and without
+    // reading the CPU lists back.
+    if (m_debugRenderer->supportsMeshWireframes() && mesh->isUploaded()) {
+        m_debugRenderer->drawMeshWireframe(mesh, world, color);
+        return;
+    }
+
     const auto& verts = mesh->getVertices();
     const auto& indices = mesh->getIndices();
     if (verts.empty() || indices.empty()) return;
-    
-    Math::Matrix4x4 world = entity->getTransform()->getWorldMatrix();
 
     static constexpr size_t kMaxWireframeTriangles = 20000;
     size_t triangleCount = indices.size() / 3;
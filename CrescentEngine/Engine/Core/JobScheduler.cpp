@@ -0,0 +1,403 @@
+#include "JobScheduler.hpp"
+#include "CPUProfiler.hpp"
+#include "ThreadQoS.hpp"
+#include "../ECS/RenderSnapshot.hpp"
+#include <algorithm>
+
+#ifdef __APPLE__
+#include <Foundation/Foundation.hpp>
+#endif
+
+namespace Crescent {
+
+namespace {
+thread_local JobScheduler* t_scheduler = nullptr;
+thread_local size_t t_workerIndex = 0;
+}
+
+JobScheduler& JobScheduler::getInstance() {
+    static JobScheduler instance;
+    return instance;
+}
+
+JobScheduler::~JobScheduler() {
+    stopWorkers();
+}
+
+bool JobScheduler::WorkQueue::pushBack(JobItem& item) {
+    lock();
+    if (m_count == m_items.size()) {
+        unlock();
+        return false;
+    }
+    m_items[(m_head + m_count) % m_items.size()] = std::move(item);
+    m_count++;
+    unlock();
+    return true;
+}
+
+bool JobScheduler::WorkQueue::popBack(JobItem& out) {
+    lock();
+    if (m_count == 0) {
+        unlock();
+        return false;
+    }
+    m_count--;
+    out = std::move(m_items[(m_head + m_count) % m_items.size()]);
+    unlock();
+    return true;
+}
+
+bool JobScheduler::WorkQueue::stealFront(JobItem& out) {
+    lock();
+    if (m_count == 0) {
+        unlock();
+        return false;
+    }
+    out = std::move(m_items[m_head]);
+    m_head = (m_head + 1) % m_items.size();
+    m_count--;
+    unlock();
+    return true;
+}
+
+bool JobScheduler::WorkQueue::takeMatching(const JobFence* fence, JobItem& out) {
+    lock();
+    const size_t capacity = m_items.size();
+    for (size_t i = m_count; i-- > 0;) {
+        JobItem& candidate = m_items[(m_head + i) % capacity];
+        if (candidate.fence.get() != fence) {
+            continue;
+        }
+        out = std::move(candidate);
+        for (size_t j = i + 1; j < m_count; ++j) {
+            m_items[(m_head + j - 1) % capacity] = std::move(m_items[(m_head + j) % capacity]);
+        }
+        m_count--;
+        unlock();
+        return true;
+    }
+    unlock();
+    return false;
+}
+
+void JobScheduler::acquire(size_t workerCount) {
+    std::lock_guard<std::mutex> lock(m_lifetimeMutex);
+    if (m_refCount++ == 0) {
+        startWorkers(workerCount);
+    }
+}
+
+void JobScheduler::release() {
+    std::lock_guard<std::mutex> lock(m_lifetimeMutex);
+    if (m_refCount <= 0) {
+        return;
+    }
+    if (--m_refCount == 0) {
+        stopWorkers();
+    }
+}
+
+void JobScheduler::startWorkers(size_t workerCount) {
+    if (m_running.load()) {
+        return;
+    }
+    if (workerCount == 0) {
+        size_t detected = std::thread::hardware_concurrency();
+        workerCount = detected > 1 ? detected - 1 : 1;
+    }
+    m_queues.clear();
+    m_queues.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+    m_running.store(true, std::memory_order_release);
+    m_threads.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        m_threads.emplace_back([this, i]() { workerLoop(i); });
+    }
+    const size_t backgroundCount = std::max<size_t>(1, workerCount / kFrameWorkersPerBackgroundWorker);
+    m_backgroundThreads.reserve(backgroundCount);
+    for (size_t i = 0; i < backgroundCount; ++i) {
+        m_backgroundThreads.emplace_back([this]() { backgroundWorkerLoop(); });
+    }
+}
+
+void JobScheduler::stopWorkers() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_sleepCv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_backgroundMutex);
+        m_backgroundCv.notify_all();
+    }
+    for (auto& thread : m_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    for (auto& thread : m_backgroundThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    m_threads.clear();
+    m_backgroundThreads.clear();
+    // Jobs left queued still run, frame and background alike, so nobody waits on their fences
+    // forever. With m_running cleared, anything they schedule runs inline.
+    JobItem item;
+    for (auto& queue : m_queues) {
+        while (queue->stealFront(item)) {
+            m_pending.fetch_sub(1);
+            execute(item);
+        }
+    }
+    m_queues.clear();
+    m_pending.store(0);
+    std::deque<JobItem> leftover;
+    {
+        std::lock_guard<std::mutex> lock(m_backgroundMutex);
+        leftover.swap(m_backgroundQueue);
+    }
+    for (JobItem& item : leftover) {
+        execute(item);
+    }
+}
+
+bool JobScheduler::isWorkerThread() const {
+    return t_scheduler == this;
+}
+
+size_t JobScheduler::currentThreadSlot() const {
+    return isWorkerThread() ? t_workerIndex + 1 : 0;
+}
+
+void JobScheduler::schedule(JobFunction job, std::shared_ptr<JobFence> fence, JobPriority priority) {
+    JobItem item{std::move(job), std::move(fence)};
+    if (priority == JobPriority::Background && m_running.load(std::memory_order_acquire)) {
+        {
+            std::lock_guard<std::mutex> lock(m_backgroundMutex);
+            m_backgroundQueue.push_back(std::move(item));
+        }
+        m_backgroundCv.notify_one();
+        return;
+    }
+    if (!m_running.load(std::memory_order_acquire) || !enqueue(item)) {
+        // No pool, or every deque is full: run on the submitting thread.
+        execute(item);
+        return;
+    }
+    wakeOne();
+}
+
+bool JobScheduler::enqueue(JobItem& item) {
+    const size_t queueCount = m_queues.size();
+    if (queueCount == 0) {
+        return false;
+    }
+    m_pending.fetch_add(1);
+    size_t start = isWorkerThread()
+        ? t_workerIndex
+        : m_submitCursor.fetch_add(1, std::memory_order_relaxed) % queueCount;
+    for (size_t i = 0; i < queueCount; ++i) {
+        if (m_queues[(start + i) % queueCount]->pushBack(item)) {
+            return true;
+        }
+    }
+    m_pending.fetch_sub(1);
+    return false;
+}
+
+void JobScheduler::wakeOne() {
+    if (m_sleeping.load() > 0) {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_sleepCv.notify_one();
+    }
+}
+
+bool JobScheduler::tryRunOne(size_t index) {
+    const size_t queueCount = m_queues.size();
+    if (queueCount == 0) {
+        return false;
+    }
+    JobItem item;
+    bool found = m_queues[index]->popBack(item);
+    for (size_t i = 1; !found && i < queueCount; ++i) {
+        found = m_queues[(index + i) % queueCount]->stealFront(item);
+    }
+    if (!found) {
+        return false;
+    }
+    m_pending.fetch_sub(1);
+    execute(item);
+    return true;
+}
+
+void JobScheduler::execute(JobItem& item) {
+#ifdef __APPLE__
+    NS::AutoreleasePool* pool = NS::AutoreleasePool::alloc()->init();
+#endif
+    if (item.job) {
+        RenderSnapshot::ForeignJobScope scope;
+        item.job();
+    }
+    item.job.reset();
+    if (item.fence) {
+        item.fence->signal();
+        item.fence.reset();
+    }
+#ifdef __APPLE__
+    pool->release();
+#endif
+}
+
+bool JobScheduler::tryHelp() {
+    if (isWorkerThread()) {
+        return tryRunOne(t_workerIndex);
+    }
+    if (!m_running.load(std::memory_order_acquire) || m_pending.load() == 0) {
+        return false;
+    }
+    const size_t queueCount = m_queues.size();
+    if (queueCount == 0) {
+        return false;
+    }
+    // External threads only steal; they have no deque of their own.
+    JobItem item;
+    size_t start = m_submitCursor.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < queueCount; ++i) {
+        if (m_queues[(start + i) % queueCount]->stealFront(item)) {
+            m_pending.fetch_sub(1);
+            execute(item);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobScheduler::tryHelpWith(const JobFence& fence) {
+    if (!m_running.load(std::memory_order_acquire) || m_pending.load() == 0) {
+        return false;
+    }
+    const size_t queueCount = m_queues.size();
+    const size_t start = isWorkerThread() ? t_workerIndex : 0;
+    JobItem item;
+    for (size_t i = 0; i < queueCount; ++i) {
+        if (m_queues[(start + i) % queueCount]->takeMatching(&fence, item)) {
+            m_pending.fetch_sub(1);
+            execute(item);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobScheduler::wait(JobFence& fence, bool ownJobsOnly) {
+    const bool worker = isWorkerThread();
+    while (!fence.isComplete()) {
+        if (ownJobsOnly) {
+            if (tryHelpWith(fence)) {
+                continue;
+            }
+            for (int spin = 0; spin < kWaitSpins && !fence.isComplete(); ++spin) {
+                CpuRelax();
+            }
+            if (fence.isComplete()) {
+                break;
+            }
+            // The rest of the fence's jobs are running elsewhere, or still queued behind other
+            // work; re-check the queues after a short park.
+            std::unique_lock<std::mutex> lock(fence.mutex);
+            fence.parked.fetch_add(1, std::memory_order_seq_cst);
+            fence.cv.wait_for(lock, kWorkerParkTimeout, [&]() { return fence.isComplete(); });
+            fence.parked.fetch_sub(1, std::memory_order_seq_cst);
+            continue;
+        }
+        if (tryHelp()) {
+            continue;
+        }
+
+        bool completed = false;
+        for (int spin = 0; spin < kWaitSpins; ++spin) {
+            if (fence.isComplete()) {
+                completed = true;
+                break;
+            }
+            if (m_pending.load(std::memory_order_relaxed) > 0) {
+                break;
+            }
+            CpuRelax();
+        }
+        if (completed) {
+            break;
+        }
+        if (m_pending.load(std::memory_order_relaxed) > 0) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(fence.mutex);
+        fence.parked.fetch_add(1, std::memory_order_seq_cst);
+        if (worker) {
+            fence.cv.wait_for(lock, kWorkerParkTimeout, [&]() { return fence.isComplete(); });
+        } else {
+            fence.cv.wait(lock, [&]() { return fence.isComplete(); });
+        }
+        fence.parked.fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+
+void JobScheduler::workerLoop(size_t index) {
+    t_scheduler = this;
+    t_workerIndex = index;
+    SetCurrentThreadQoS(ThreadQoS::Interactive);
+    CRESCENT_PROFILE_THREAD("Worker " + std::to_string(index));
+    int idleSpins = 0;
+    while (true) {
+        if (tryRunOne(index)) {
+            idleSpins = 0;
+            continue;
+        }
+        if (!m_running.load(std::memory_order_acquire)) {
+            break;
+        }
+        if (++idleSpins < kIdleSpins) {
+            std::this_thread::yield();
+            continue;
+        }
+        idleSpins = 0;
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleeping.fetch_add(1);
+        m_sleepCv.wait(lock, [&]() {
+            return m_pending.load() > 0 || !m_running.load();
+        });
+        m_sleeping.fetch_sub(1);
+    }
+    t_scheduler = nullptr;
+}
+
+void JobScheduler::backgroundWorkerLoop() {
+    // Not a pool worker: a background job that waits on frame work helps like any outside thread.
+    SetCurrentThreadQoS(ThreadQoS::Utility);
+    CRESCENT_PROFILE_THREAD("Background Worker");
+    while (true) {
+        JobItem item;
+        {
+            std::unique_lock<std::mutex> lock(m_backgroundMutex);
+            m_backgroundCv.wait(lock, [&]() {
+                return !m_backgroundQueue.empty() || !m_running.load();
+            });
+            if (m_backgroundQueue.empty()) {
+                break;
+            }
+            item = std::move(m_backgroundQueue.front());
+            m_backgroundQueue.pop_front();
+        }
+        execute(item);
+    }
+}
+
+} // namespace Crescent
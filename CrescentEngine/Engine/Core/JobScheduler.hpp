@@ -0,0 +1,235 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Crescent {
+
+// Move-only callable with inline storage. Submitting a job never touches the heap; a capture
+// that does not fit in kInlineSize is a compile error instead of a hidden allocation.
+class JobFunction {
+public:
+    static constexpr size_t kInlineSize = 64;
+
+    JobFunction() = default;
+
+    template <typename F,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, JobFunction>>>
+    JobFunction(F&& fn) {
+        using Fn = std::decay_t<F>;
+        static_assert(sizeof(Fn) <= kInlineSize, "Job capture does not fit in JobFunction inline storage");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "Job capture is over-aligned");
+        ::new (static_cast<void*>(m_storage)) Fn(std::forward<F>(fn));
+        m_ops = OpsFor<Fn>::table();
+    }
+
+    JobFunction(JobFunction&& other) noexcept { moveFrom(other); }
+
+    JobFunction& operator=(JobFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    JobFunction(const JobFunction&) = delete;
+    JobFunction& operator=(const JobFunction&) = delete;
+
+    ~JobFunction() { reset(); }
+
+    explicit operator bool() const { return m_ops != nullptr; }
+
+    void operator()() {
+        if (m_ops) {
+            m_ops->invoke(m_storage);
+        }
+    }
+
+    void reset() {
+        if (m_ops) {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void*);
+    };
+
+    template <typename Fn>
+    struct OpsFor {
+        static void invoke(void* p) { (*static_cast<Fn*>(p))(); }
+        static void move(void* dst, void* src) {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        }
+        static void destroy(void* p) { static_cast<Fn*>(p)->~Fn(); }
+        static const Ops* table() {
+            static constexpr Ops kOps{&invoke, &move, &destroy};
+            return &kOps;
+        }
+    };
+
+    void moveFrom(JobFunction& other) {
+        if (other.m_ops) {
+            other.m_ops->move(m_storage, other.m_storage);
+            m_ops = other.m_ops;
+            other.m_ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char m_storage[kInlineSize];
+    const Ops* m_ops = nullptr;
+};
+
+inline void CpuRelax() {
+#if defined(__aarch64__) || defined(__arm64__)
+    __asm__ __volatile__("yield");
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+struct JobFence {
+    std::atomic<int> remaining{0};
+    std::atomic<int> parked{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    bool isComplete() const { return remaining.load(std::memory_order_acquire) == 0; }
+
+    // Retires one job. The mutex/notify is only paid when a waiter actually parked.
+    void signal() {
+        if (remaining.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+            parked.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cv.notify_all();
+        }
+    }
+};
+
+// Lanes a job can be scheduled on. Frame jobs run on the work-stealing pool at interactive QoS.
+// Background jobs (bakes, encodes, cooking) go to a few utility-QoS workers with one shared FIFO
+// that never take frame work, and the frame workers never take theirs, so a long background job
+// cannot occupy a worker the frame is waiting for.
+enum class JobPriority : uint8_t {
+    Frame,
+    Background
+};
+
+// Engine-wide work-stealing scheduler. Every JobSystem role and the Jolt job adapter feed the
+// same worker pool: workers push and pop their own deque LIFO and steal FIFO from the others,
+// so one hot queue lock no longer serializes the whole engine.
+class JobScheduler {
+public:
+    static JobScheduler& getInstance();
+
+    // Reference counted so roles can start/stop independently. workerCount only applies when
+    // the call actually spins up the pool (0 = hardware_concurrency - 1).
+    void acquire(size_t workerCount = 0);
+    void release();
+
+    // Queues a job. Without a running pool the job executes inline on the caller.
+    void schedule(JobFunction job, std::shared_ptr<JobFence> fence, JobPriority priority = JobPriority::Frame);
+
+    // Waits for the fence to drain while helping: any waiting thread, worker or not, runs
+    // queued jobs first, then spins briefly, and only parks once there is nothing to help with.
+    // Workers park with a short timeout so new work is never stranded behind blocked waiters.
+    // With ownJobsOnly the waiter only runs queued jobs that signal this fence, for callers
+    // whose stack must not pick up unrelated work; it parks with the short timeout either way.
+    void wait(JobFence& fence, bool ownJobsOnly = false);
+
+    bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+    size_t workerCount() const { return m_threads.size(); }
+    size_t backgroundWorkerCount() const { return m_backgroundThreads.size(); }
+    bool isWorkerThread() const;
+    // 1 + the calling worker's index, or 0 on a thread outside the pool; for per-thread buffers
+    // of workerCount() + 1 slots, where slot 0 may be shared by several outside threads.
+    size_t currentThreadSlot() const;
+
+private:
+    JobScheduler() = default;
+    ~JobScheduler();
+    JobScheduler(const JobScheduler&) = delete;
+    JobScheduler& operator=(const JobScheduler&) = delete;
+
+    static constexpr size_t kQueueCapacity = 4096;
+    static constexpr int kIdleSpins = 64;
+    static constexpr int kWaitSpins = 256;
+    static constexpr auto kWorkerParkTimeout = std::chrono::microseconds(200);
+    // One background worker per this many frame workers, at least one.
+    static constexpr size_t kFrameWorkersPerBackgroundWorker = 4;
+
+    struct JobItem {
+        JobFunction job;
+        std::shared_ptr<JobFence> fence;
+    };
+
+    class WorkQueue {
+    public:
+        WorkQueue() : m_items(kQueueCapacity) {}
+
+        bool pushBack(JobItem& item);
+        bool popBack(JobItem& out);
+        bool stealFront(JobItem& out);
+        // Removes the newest queued job that signals fence.
+        bool takeMatching(const JobFence* fence, JobItem& out);
+
+    private:
+        void lock() {
+            while (m_lock.test_and_set(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+        void unlock() { m_lock.clear(std::memory_order_release); }
+
+        std::vector<JobItem> m_items;
+        size_t m_head = 0;
+        size_t m_count = 0;
+        std::atomic_flag m_lock = ATOMIC_FLAG_INIT;
+    };
+
+    void startWorkers(size_t workerCount);
+    void stopWorkers();
+    void workerLoop(size_t index);
+    void backgroundWorkerLoop();
+    bool tryRunOne(size_t index);
+    bool tryHelp();
+    bool tryHelpWith(const JobFence& fence);
+    bool enqueue(JobItem& item);
+    void wakeOne();
+    static void execute(JobItem& item);
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_lifetimeMutex;
+    int m_refCount = 0;
+    std::atomic<bool> m_running{false};
+    std::atomic<size_t> m_pending{0};
+    std::atomic<size_t> m_submitCursor{0};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCv;
+    std::atomic<int> m_sleeping{0};
+
+    std::vector<std::thread> m_backgroundThreads;
+    std::deque<JobItem> m_backgroundQueue;
+    std::mutex m_backgroundMutex;
+    std::condition_variable m_backgroundCv;
+};
+
+} // namespace Crescent
@@ -1,25 +1,18 @@
 #pragma once
 
+#include "JobScheduler.hpp"
 #include <atomic>
-#include <condition_variable>
-#include <functional>
 #include <memory>
-#include <mutex>
-#include <queue>
-#include <thread>
-#include <vector>
-
-#ifdef __APPLE__
-#include <Foundation/Foundation.hpp>
-#endif
 
 namespace Crescent {
 
+// A named role (update, physics, audio, render) on top of the shared JobScheduler.
+// Roles no longer own threads; they only gate submission and hold a scheduler reference.
 class JobSystem {
-    struct Fence;
+    using Fence = JobFence;
 
 public:
-    using Job = std::function<void()>;
+    using Job = JobFunction;
 
     struct JobHandle {
         std::shared_ptr<Fence> fence;
@@ -28,33 +21,21 @@ public:
 
     JobSystem() = default;
     ~JobSystem() { stop(); }
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
 
     void start(size_t workerCount = 0) {
-        if (m_running.load()) {
+        if (m_running.exchange(true)) {
             return;
         }
-        size_t detected = std::thread::hardware_concurrency();
-        if (workerCount == 0) {
-            workerCount = detected > 1 ? detected - 1 : 1;
-        }
-        m_running.store(true);
-        m_workers.reserve(workerCount);
-        for (size_t i = 0; i < workerCount; ++i) {
-            m_workers.emplace_back([this]() { workerLoop(); });
-        }
+        JobScheduler::getInstance().acquire(workerCount);
     }
 
     void stop() {
         if (!m_running.exchange(false)) {
             return;
         }
-        m_queueCv.notify_all();
-        for (auto& worker : m_workers) {
-            if (worker.joinable()) {
-                worker.join();
-            }
-        }
-        m_workers.clear();
+        JobScheduler::getInstance().release();
     }
 
     JobHandle createHandle() const {
@@ -79,82 +60,27 @@ public:
             if (job) {
                 job();
             }
-            if (handle.fence->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                std::lock_guard<std::mutex> lock(handle.fence->mutex);
-                handle.fence->cv.notify_all();
-            }
+            handle.fence->signal();
             return;
         }
-        {
-            std::lock_guard<std::mutex> lock(m_queueMutex);
-            m_queue.push(JobItem{std::move(job), handle.fence});
-        }
-        m_queueCv.notify_one();
+        JobScheduler::getInstance().schedule(std::move(job), handle.fence);
+    }
+
+    bool isComplete(const JobHandle& handle) const {
+        return !handle.fence || handle.fence->isComplete();
     }
 
+    // Helps run queued jobs until the handle completes; see JobScheduler::wait.
     void wait(const JobHandle& handle) const {
         if (!handle.fence) {
             return;
         }
-        if (handle.fence->remaining.load(std::memory_order_acquire) == 0) {
-            return;
-        }
-        std::unique_lock<std::mutex> lock(handle.fence->mutex);
-        handle.fence->cv.wait(lock, [&]() {
-            return handle.fence->remaining.load(std::memory_order_acquire) == 0;
-        });
+        JobScheduler::getInstance().wait(*handle.fence);
     }
 
-    size_t workerCount() const { return m_workers.size(); }
+    size_t workerCount() const { return JobScheduler::getInstance().workerCount(); }
 
 private:
-    struct Fence {
-        std::atomic<int> remaining{0};
-        mutable std::mutex mutex;
-        mutable std::condition_variable cv;
-    };
-
-    struct JobItem {
-        Job job;
-        std::shared_ptr<Fence> fence;
-    };
-
-    void workerLoop() {
-        while (true) {
-            JobItem item;
-            {
-                std::unique_lock<std::mutex> lock(m_queueMutex);
-                m_queueCv.wait(lock, [&]() {
-                    return !m_running.load() || !m_queue.empty();
-                });
-                if (!m_running.load() && m_queue.empty()) {
-                    break;
-                }
-                item = std::move(m_queue.front());
-                m_queue.pop();
-            }
-#ifdef __APPLE__
-            NS::AutoreleasePool* pool = NS::AutoreleasePool::alloc()->init();
-#endif
-            if (item.job) {
-                item.job();
-            }
-            if (item.fence) {
-                if (item.fence->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                    std::lock_guard<std::mutex> lock(item.fence->mutex);
-                    item.fence->cv.notify_all();
-                }
-            }
-#ifdef __APPLE__
-            pool->release();
-#endif
-        }
-    }
-
-    std::vector<std::thread> m_workers;
-    std::queue<JobItem> m_queue;
-    mutable std::mutex m_queueMutex;
-    std::condition_variable m_queueCv;
     std::atomic<bool> m_running{false};
 };
 
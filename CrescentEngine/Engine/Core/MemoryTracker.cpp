@@ -0,0 +1,282 @@
+#include "MemoryTracker.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+namespace Crescent {
+
+namespace {
+    constexpr const char* kCategoryNames[kMemoryCategoryCount] = {
+        "Textures",
+        "Meshes",
+        "RenderTargets",
+        "Skinning",
+        "Instances",
+        "Shadows",
+        "Probes",
+        "Physics",
+        "Audio"
+    };
+
+    // In front of every counted heap block: its size and, for aligned blocks, the malloc'd base.
+    struct alignas(16) BlockHeader {
+        size_t bytes;
+        void* base;
+    };
+    static_assert(sizeof(BlockHeader) == 16, "heap blocks must stay 16-byte aligned");
+
+    BlockHeader* HeaderOf(void* block) {
+        return reinterpret_cast<BlockHeader*>(static_cast<uint8_t*>(block) - sizeof(BlockHeader));
+    }
+
+    double ToMB(uint64_t bytes) {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+
+    // A crossed budget warns again only once usage fell below this share of it.
+    bool UpdateOverBudget(bool& overBudget, uint64_t bytes, uint64_t budget) {
+        if (budget == 0) {
+            overBudget = false;
+            return false;
+        }
+        if (!overBudget && bytes > budget) {
+            overBudget = true;
+            return true;
+        }
+        if (overBudget && bytes < budget / 10 * 9) {
+            overBudget = false;
+        }
+        return false;
+    }
+
+    uint64_t ProcessFootprintBytes() {
+#ifdef __APPLE__
+        task_vm_info_data_t info{};
+        mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+        if (task_info(mach_task_self(), TASK_VM_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS) {
+            return info.phys_footprint;
+        }
+#endif
+        return 0;
+    }
+}
+
+const char* MemoryCategoryName(MemoryCategory category) {
+    const size_t index = static_cast<size_t>(category);
+    return index < kMemoryCategoryCount ? kCategoryNames[index] : "Unknown";
+}
+
+bool IsGPUMemoryCategory(MemoryCategory category) {
+    return category != MemoryCategory::Physics && category != MemoryCategory::Audio;
+}
+
+MemoryTracker& MemoryTracker::getInstance() {
+    // Never destroyed: singletons holding TrackedMemory release it during static destruction.
+    static MemoryTracker* instance = new MemoryTracker();
+    return *instance;
+}
+
+MemoryTracker::MemoryTracker() {
+    loadBudgetsFromEnvironment();
+}
+
+void MemoryTracker::loadBudgetsFromEnvironment() {
+    const char* value = std::getenv("CRESCENT_MEMORY_BUDGETS");
+    if (!value || !*value) {
+        return;
+    }
+    std::stringstream stream(value);
+    std::string entry;
+    while (std::getline(stream, entry, ',')) {
+        const size_t equals = entry.find('=');
+        if (equals == std::string::npos) {
+            continue;
+        }
+        const std::string name = entry.substr(0, equals);
+        const uint64_t bytes = std::strtoull(entry.c_str() + equals + 1, nullptr, 10) * 1024ull * 1024ull;
+        if (name == "Device") {
+            setDeviceBudget(bytes);
+            continue;
+        }
+        bool known = false;
+        for (size_t i = 0; i < kMemoryCategoryCount; ++i) {
+            if (name == kCategoryNames[i]) {
+                setBudget(static_cast<MemoryCategory>(i), bytes);
+                known = true;
+                break;
+            }
+        }
+        if (!known) {
+            std::cerr << "[Memory] Unknown budget category: " << name << std::endl;
+        }
+    }
+}
+
+void MemoryTracker::add(MemoryCategory category, uint64_t bytes) {
+    Counter& counter = m_Counters[static_cast<size_t>(category)];
+    const uint64_t total = counter.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    counter.allocations.fetch_add(1, std::memory_order_relaxed);
+    uint64_t peak = counter.peakBytes.load(std::memory_order_relaxed);
+    while (total > peak && !counter.peakBytes.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {
+    }
+}
+
+void MemoryTracker::remove(MemoryCategory category, uint64_t bytes) {
+    Counter& counter = m_Counters[static_cast<size_t>(category)];
+    counter.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    counter.allocations.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void* MemoryTracker::allocate(MemoryCategory category, size_t bytes) {
+    auto* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + bytes));
+    if (!header) {
+        return nullptr;
+    }
+    header->bytes = bytes;
+    header->base = header;
+    getInstance().add(category, bytes);
+    return header + 1;
+}
+
+void* MemoryTracker::reallocate(MemoryCategory category, void* block, size_t bytes) {
+    if (!block) {
+        return allocate(category, bytes);
+    }
+    const size_t previous = HeaderOf(block)->bytes;
+    auto* header = static_cast<BlockHeader*>(std::realloc(HeaderOf(block), sizeof(BlockHeader) + bytes));
+    if (!header) {
+        return nullptr;
+    }
+    header->bytes = bytes;
+    header->base = header;
+    MemoryTracker& tracker = getInstance();
+    tracker.add(category, bytes);
+    tracker.remove(category, previous);
+    return header + 1;
+}
+
+void MemoryTracker::release(MemoryCategory category, void* block) {
+    if (!block) {
+        return;
+    }
+    BlockHeader* header = HeaderOf(block);
+    getInstance().remove(category, header->bytes);
+    std::free(header);
+}
+
+void* MemoryTracker::allocateAligned(MemoryCategory category, size_t bytes, size_t alignment) {
+    alignment = std::max(alignment, alignof(BlockHeader));
+    void* base = std::malloc(bytes + alignment + sizeof(BlockHeader));
+    if (!base) {
+        return nullptr;
+    }
+    const uintptr_t first = reinterpret_cast<uintptr_t>(base) + sizeof(BlockHeader);
+    void* block = reinterpret_cast<void*>((first + alignment - 1) & ~(uintptr_t(alignment) - 1));
+    BlockHeader* header = HeaderOf(block);
+    header->bytes = bytes;
+    header->base = base;
+    getInstance().add(category, bytes);
+    return block;
+}
+
+void MemoryTracker::releaseAligned(MemoryCategory category, void* block) {
+    if (!block) {
+        return;
+    }
+    BlockHeader* header = HeaderOf(block);
+    getInstance().remove(category, header->bytes);
+    std::free(header->base);
+}
+
+void MemoryTracker::setBudget(MemoryCategory category, uint64_t bytes) {
+    m_Counters[static_cast<size_t>(category)].budget.store(bytes, std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::getBudget(MemoryCategory category) const {
+    return m_Counters[static_cast<size_t>(category)].budget.load(std::memory_order_relaxed);
+}
+
+void MemoryTracker::setDeviceBudget(uint64_t bytes) {
+    m_DeviceBudget.store(bytes, std::memory_order_relaxed);
+}
+
+void MemoryTracker::setDeviceUsage(uint64_t allocatedBytes, uint64_t workingSetBytes) {
+    m_DeviceAllocated.store(allocatedBytes, std::memory_order_relaxed);
+    m_DeviceWorkingSet.store(workingSetBytes, std::memory_order_relaxed);
+}
+
+void MemoryTracker::checkBudgets() {
+    for (size_t i = 0; i < kMemoryCategoryCount; ++i) {
+        Counter& counter = m_Counters[i];
+        const uint64_t bytes = counter.bytes.load(std::memory_order_relaxed);
+        const uint64_t budget = counter.budget.load(std::memory_order_relaxed);
+        if (UpdateOverBudget(counter.overBudget, bytes, budget)) {
+            std::cerr << "[Memory] " << kCategoryNames[i] << " over budget: "
+                      << std::fixed << std::setprecision(1) << ToMB(bytes) << " MB of "
+                      << ToMB(budget) << " MB" << std::endl;
+        }
+    }
+
+    uint64_t deviceBudget = m_DeviceBudget.load(std::memory_order_relaxed);
+    if (deviceBudget == 0) {
+        deviceBudget = m_DeviceWorkingSet.load(std::memory_order_relaxed);
+    }
+    const uint64_t deviceBytes = m_DeviceAllocated.load(std::memory_order_relaxed);
+    if (UpdateOverBudget(m_DeviceOverBudget, deviceBytes, deviceBudget)) {
+        std::cerr << "[Memory] GPU allocations over budget: "
+                  << std::fixed << std::setprecision(1) << ToMB(deviceBytes) << " MB of "
+                  << ToMB(deviceBudget) << " MB" << std::endl;
+        logReport("device over budget");
+    }
+}
+
+MemoryTracker::Report MemoryTracker::getReport() const {
+    Report report;
+    for (size_t i = 0; i < kMemoryCategoryCount; ++i) {
+        const Counter& counter = m_Counters[i];
+        CategoryStats& stats = report.categories[i];
+        stats.bytes = counter.bytes.load(std::memory_order_relaxed);
+        stats.peakBytes = counter.peakBytes.load(std::memory_order_relaxed);
+        stats.allocations = counter.allocations.load(std::memory_order_relaxed);
+        stats.budgetBytes = counter.budget.load(std::memory_order_relaxed);
+        if (IsGPUMemoryCategory(static_cast<MemoryCategory>(i))) {
+            report.trackedGPUBytes += stats.bytes;
+        } else {
+            report.trackedCPUBytes += stats.bytes;
+        }
+    }
+    report.deviceAllocatedBytes = m_DeviceAllocated.load(std::memory_order_relaxed);
+    report.deviceWorkingSetBytes = m_DeviceWorkingSet.load(std::memory_order_relaxed);
+    report.deviceBudgetBytes = m_DeviceBudget.load(std::memory_order_relaxed);
+    report.processFootprintBytes = ProcessFootprintBytes();
+    return report;
+}
+
+void MemoryTracker::logReport(const std::string& reason) const {
+    const Report report = getReport();
+    std::cerr << std::fixed << std::setprecision(2)
+              << "[Memory] " << reason
+              << " device=" << ToMB(report.deviceAllocatedBytes) << " MB"
+              << " trackedGPU=" << ToMB(report.trackedGPUBytes) << " MB"
+              << " trackedCPU=" << ToMB(report.trackedCPUBytes) << " MB"
+              << " footprint=" << ToMB(report.processFootprintBytes) << " MB" << std::endl;
+    for (size_t i = 0; i < kMemoryCategoryCount; ++i) {
+        const CategoryStats& stats = report.categories[i];
+        std::cerr << "  [Memory] " << kCategoryNames[i]
+                  << " " << ToMB(stats.bytes) << " MB"
+                  << " peak=" << ToMB(stats.peakBytes) << " MB"
+                  << " allocations=" << stats.allocations;
+        if (stats.budgetBytes > 0) {
+            std::cerr << " budget=" << ToMB(stats.budgetBytes) << " MB";
+        }
+        std::cerr << std::endl;
+    }
+}
+
+} // namespace Crescent
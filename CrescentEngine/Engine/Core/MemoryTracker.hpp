@@ -0,0 +1,153 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Crescent {
+
+// What tracked memory is spent on. Physics and Audio are CPU heaps, the rest GPU allocations.
+enum class MemoryCategory : uint8_t {
+    Textures,
+    Meshes,        // geometry arenas
+    RenderTargets, // Scene, Game and Preview target pools and the transient target heap
+    Skinning,      // skinning cache and crowd palettes
+    Instances,     // per-draw instance, uniform ring, culling and indirect buffers
+    Shadows,       // shadow atlas, point light cubes and the shadow culling buffers
+    Probes,        // probe volume records and dynamic probe GI
+    Physics,
+    Audio,
+    Count
+};
+constexpr size_t kMemoryCategoryCount = static_cast<size_t>(MemoryCategory::Count);
+
+const char* MemoryCategoryName(MemoryCategory category);
+bool IsGPUMemoryCategory(MemoryCategory category);
+
+// Live bytes per category, counted by the owners of each allocation through TrackedMemory, with
+// optional budgets. The Metal device's own total is sampled by the renderer every frame, so the
+// report also shows what the categories do not cover (pipelines, uniforms, drawables). Budgets
+// come from setBudget or CRESCENT_MEMORY_BUDGETS ("Textures=1024,Meshes=256,Device=6144", in MB);
+// a category that crosses its budget warns once, and again only after it fell below 90% of it.
+class MemoryTracker {
+public:
+    struct CategoryStats {
+        uint64_t bytes = 0;
+        uint64_t peakBytes = 0;
+        uint64_t allocations = 0;
+        uint64_t budgetBytes = 0; // 0 = none
+    };
+    struct Report {
+        std::array<CategoryStats, kMemoryCategoryCount> categories{};
+        uint64_t trackedGPUBytes = 0;
+        uint64_t trackedCPUBytes = 0;
+        uint64_t deviceAllocatedBytes = 0;  // MTL::Device::currentAllocatedSize
+        uint64_t deviceWorkingSetBytes = 0; // MTL::Device::recommendedMaxWorkingSetSize
+        uint64_t deviceBudgetBytes = 0;     // 0 = the recommended working set
+        uint64_t processFootprintBytes = 0; // physical footprint of the process, 0 if unknown
+    };
+
+    static MemoryTracker& getInstance();
+
+    void add(MemoryCategory category, uint64_t bytes);
+    void remove(MemoryCategory category, uint64_t bytes);
+
+    // Counted heap blocks for libraries that take an allocator (Jolt, miniaudio). Every block
+    // carries its size in a header in front of it, so it must go back through the same category.
+    static void* allocate(MemoryCategory category, size_t bytes);
+    static void* reallocate(MemoryCategory category, void* block, size_t bytes);
+    static void release(MemoryCategory category, void* block);
+    static void* allocateAligned(MemoryCategory category, size_t bytes, size_t alignment);
+    static void releaseAligned(MemoryCategory category, void* block);
+
+    void setBudget(MemoryCategory category, uint64_t bytes);
+    uint64_t getBudget(MemoryCategory category) const;
+    void setDeviceBudget(uint64_t bytes);
+    uint64_t getDeviceBudget() const { return m_DeviceBudget.load(std::memory_order_relaxed); }
+
+    void setDeviceUsage(uint64_t allocatedBytes, uint64_t workingSetBytes);
+    // Warns about budgets crossed since the last call; once per frame.
+    void checkBudgets();
+    // Whether the last checkBudgets found the category (or the device) over budget; it stays so
+    // until usage falls below 90% of the budget. Read on the thread that calls checkBudgets.
+    bool isOverBudget(MemoryCategory category) const {
+        return m_Counters[static_cast<size_t>(category)].overBudget;
+    }
+    bool isDeviceOverBudget() const { return m_DeviceOverBudget; }
+
+    Report getReport() const;
+    void logReport(const std::string& reason) const;
+
+private:
+    struct Counter {
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> peakBytes{0};
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> budget{0};
+        bool overBudget = false; // checkBudgets only
+    };
+
+    MemoryTracker();
+    void loadBudgetsFromEnvironment();
+
+    std::array<Counter, kMemoryCategoryCount> m_Counters;
+    std::atomic<uint64_t> m_DeviceAllocated{0};
+    std::atomic<uint64_t> m_DeviceWorkingSet{0};
+    std::atomic<uint64_t> m_DeviceBudget{0};
+    bool m_DeviceOverBudget = false;
+};
+
+// One tracked allocation, kept next to the resource it accounts for: reset it with the new size
+// whenever the resource is replaced and without arguments when it is released. Move-only; the
+// destructor removes whatever it still counts.
+class TrackedMemory {
+public:
+    TrackedMemory() = default;
+    TrackedMemory(MemoryCategory category, uint64_t bytes) { reset(category, bytes); }
+    ~TrackedMemory() { reset(); }
+
+    TrackedMemory(TrackedMemory&& other) noexcept
+        : m_Category(other.m_Category)
+        , m_Bytes(other.m_Bytes) {
+        other.m_Bytes = 0;
+    }
+    TrackedMemory& operator=(TrackedMemory&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_Category = other.m_Category;
+            m_Bytes = other.m_Bytes;
+            other.m_Bytes = 0;
+        }
+        return *this;
+    }
+    TrackedMemory(const TrackedMemory&) = delete;
+    TrackedMemory& operator=(const TrackedMemory&) = delete;
+
+    void reset(MemoryCategory category, uint64_t bytes) {
+        MemoryTracker& tracker = MemoryTracker::getInstance();
+        if (bytes > 0) {
+            tracker.add(category, bytes);
+        }
+        if (m_Bytes > 0) {
+            tracker.remove(m_Category, m_Bytes);
+        }
+        m_Category = category;
+        m_Bytes = bytes;
+    }
+    void reset() {
+        if (m_Bytes > 0) {
+            MemoryTracker::getInstance().remove(m_Category, m_Bytes);
+            m_Bytes = 0;
+        }
+    }
+
+    uint64_t bytes() const { return m_Bytes; }
+
+private:
+    MemoryCategory m_Category = MemoryCategory::Textures;
+    uint64_t m_Bytes = 0;
+};
+
+} // namespace Crescent
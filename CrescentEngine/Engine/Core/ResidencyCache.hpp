@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace Crescent {
+
+// Keeps recently used assets alive after their last user lets go, so reloading one that was just
+// dropped (play mode exited, a level switched away and back) is a lookup instead of a decode and
+// upload. Entries are strong references in recency order; an entry nothing else references is
+// "released" and counts against the budget, and trim evicts the least recently used released
+// entries until they fit. Entries still in use are never evicted and do not count. Thread-safe.
+template <typename T>
+class ResidencyCache {
+public:
+    using SizeFunction = std::function<uint64_t(const T&)>;
+
+    ResidencyCache(uint64_t budgetBytes, SizeFunction size)
+        : m_Size(std::move(size))
+        , m_Budget(budgetBytes) {}
+
+    // Inserts or refreshes key as the most recently used entry.
+    void retain(const std::string& key, const std::shared_ptr<T>& value) {
+        if (!value) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (auto it = m_Index.find(key); it != m_Index.end()) {
+            it->second->second = value;
+            m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+            return;
+        }
+        m_Entries.emplace_front(key, value);
+        m_Index[key] = m_Entries.begin();
+    }
+
+    // The entry for key, refreshed as most recently used, or null.
+    std::shared_ptr<T> find(const std::string& key) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Index.find(key);
+        if (it == m_Index.end()) {
+            return nullptr;
+        }
+        m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+        return it->second->second;
+    }
+
+    void erase(const std::string& key) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (auto it = m_Index.find(key); it != m_Index.end()) {
+            m_Entries.erase(it->second);
+            m_Index.erase(it);
+        }
+    }
+
+    // Evicts released entries, oldest first, until the released ones fit the budget. Returns the
+    // bytes evicted.
+    uint64_t trim() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return evictReleased(m_Budget);
+    }
+
+    // Evicts every released entry; the memory pressure response.
+    uint64_t purge() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return evictReleased(0);
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Index.clear();
+        m_Entries.clear();
+    }
+
+    void setBudget(uint64_t bytes) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Budget = bytes;
+        evictReleased(m_Budget);
+    }
+    uint64_t getBudget() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Budget;
+    }
+
+    // Bytes held only by the cache.
+    uint64_t getReleasedBytes() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        uint64_t bytes = 0;
+        for (const auto& entry : m_Entries) {
+            if (entry.second.use_count() == 1) {
+                bytes += m_Size(*entry.second);
+            }
+        }
+        return bytes;
+    }
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<T>>;
+
+    // The walk goes newest to oldest: released entries stay until the first one that does not fit,
+    // and it and every older released entry go.
+    uint64_t evictReleased(uint64_t budget) {
+        uint64_t kept = 0;
+        uint64_t evicted = 0;
+        bool full = false;
+        for (auto it = m_Entries.begin(); it != m_Entries.end();) {
+            if (it->second.use_count() != 1) {
+                ++it;
+                continue;
+            }
+            const uint64_t bytes = m_Size(*it->second);
+            full = full || kept + bytes > budget;
+            if (!full) {
+                kept += bytes;
+                ++it;
+                continue;
+            }
+            evicted += bytes;
+            m_Index.erase(it->first);
+            it = m_Entries.erase(it);
+        }
+        return evicted;
+    }
+
+    SizeFunction m_Size;
+    std::list<Entry> m_Entries; // most recently used first
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> m_Index;
+    uint64_t m_Budget = 0;
+    mutable std::mutex m_Mutex;
+};
+
+} // namespace Crescent
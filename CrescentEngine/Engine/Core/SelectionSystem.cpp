@@ -4,6 +4,7 @@
 #include "../Components/MeshRenderer.hpp"
 #include "../ECS/Entity.hpp"
 #include "../ECS/Transform.hpp"
+#include "../Scene/Scene.hpp"
 #include <iostream>
 #include <limits>
 #include <algorithm>
@@ -122,46 +123,76 @@ bool SelectionSystem::raycastEntity(const Ray& ray, Entity* entity, RaycastHit&
     return false;
 }
 
-RaycastHit SelectionSystem::raycastAll(const Ray& ray, const std::vector<Entity*>& entities) {
-    RaycastHit closestHit;
-    closestHit.distance = std::numeric_limits<float>::max();
-    
+bool SelectionSystem::isPickable(Entity* entity) {
     static int skipDebugCount = 0;
+
+    if (!entity || !entity->isActiveInHierarchy()) return false;
+    if (entity->isEditorOnly()) {
+        return false;
+    }
     
-    for (Entity* entity : entities) {
-        if (!entity || !entity->isActiveInHierarchy()) continue;
-        if (entity->isEditorOnly()) {
-            continue;
+    // CRITICAL: Skip scene entities - they should never be selectable!
+    const std::string& entityName = entity->getName();
+    if (entityName == "Main Camera" || entityName == "Directional Light" || entityName == "Editor Gizmo") {
+        if (kSelectionDebug && skipDebugCount < 3) {
+            std::cout << "[RAYCAST] Skipping scene entity: " << entityName << std::endl;
+            skipDebugCount++;
         }
-        
-        // CRITICAL: Skip scene entities - they should never be selectable!
-        std::string entityName = entity->getName();
-        if (entityName == "Main Camera" || entityName == "Directional Light" || entityName == "Editor Gizmo") {
-            if (kSelectionDebug && skipDebugCount < 3) {
-                std::cout << "[RAYCAST] Skipping scene entity: " << entityName << std::endl;
-                skipDebugCount++;
-            }
-            continue;
+        return false;
+    }
+    
+    // Also skip by component check
+    if (entity->hasComponent<Camera>()) {
+        if (kSelectionDebug && skipDebugCount < 3) {
+            std::cout << "[RAYCAST] Skipping camera: " << entityName << std::endl;
         }
-        
-        // Also skip by component check
-        if (entity->hasComponent<Camera>()) {
-            if (kSelectionDebug && skipDebugCount < 3) {
-                std::cout << "[RAYCAST] Skipping camera: " << entityName << std::endl;
-            }
-            continue;
+        return false;
+    }
+    
+    // Optional: Skip light entities (no visual representation)
+    if (entity->hasComponent<Light>() && !entity->hasComponent<MeshRenderer>()) {
+        if (kSelectionDebug && skipDebugCount < 3) {
+            std::cout << "[RAYCAST] Skipping light: " << entityName << std::endl;
         }
+        return false;
+    }
+    return true;
+}
+
+RaycastHit SelectionSystem::raycastAll(const Ray& ray, const std::vector<Entity*>& entities) {
+    RaycastHit closestHit;
+    closestHit.distance = std::numeric_limits<float>::max();
+    
+    for (Entity* entity : entities) {
+        if (!isPickable(entity)) continue;
         
-        // Optional: Skip light entities (no visual representation)
-        if (entity->hasComponent<Light>() && !entity->hasComponent<MeshRenderer>()) {
-            if (kSelectionDebug && skipDebugCount < 3) {
-                std::cout << "[RAYCAST] Skipping light: " << entityName << std::endl;
+        RaycastHit hit;
+        if (raycastEntity(ray, entity, hit)) {
+            if (hit.distance < closestHit.distance) {
+                closestHit = hit;
             }
-            continue;
         }
+    }
+    
+    return closestHit;
+}
+
+RaycastHit SelectionSystem::raycastScene(const Ray& ray, Scene* scene) {
+    RaycastHit closestHit;
+    closestHit.distance = std::numeric_limits<float>::max();
+    if (!scene) {
+        return closestHit;
+    }
+    
+    // The index boxes can lag the live bounds by a frame, so candidates are re-tested exactly.
+    std::vector<SpatialRayHit> candidates;
+    scene->getSpatialIndex().raycast(ray.origin, ray.direction.normalized(),
+                                     std::numeric_limits<float>::max(), candidates);
+    for (const SpatialRayHit& candidate : candidates) {
+        if (!isPickable(candidate.entity)) continue;
         
         RaycastHit hit;
-        if (raycastEntity(ray, entity, hit)) {
+        if (raycastEntity(ray, candidate.entity, hit)) {
             if (hit.distance < closestHit.distance) {
                 closestHit = hit;
             }
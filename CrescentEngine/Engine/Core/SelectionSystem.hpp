@@ -8,6 +8,7 @@ namespace Crescent {
 // Forward declarations
 class Entity;
 class Camera;
+class Scene;
 
 // Ray for raycasting
 struct Ray {
@@ -83,6 +84,9 @@ public:
     
     // Raycast against multiple entities, return closest
     static RaycastHit raycastAll(const Ray& ray, const std::vector<Entity*>& entities);
+    // Same as raycastAll over the scene's entities, testing only those its spatial index puts on
+    // the ray.
+    static RaycastHit raycastScene(const Ray& ray, Scene* scene);
     
     // Get world-space AABB for entity
     static AABB getEntityBounds(Entity* entity);
@@ -95,8 +99,12 @@ public:
     static Entity* getSelectedEntity();
     static const std::vector<Entity*>& getSelection();
     static void clearSelection();
+
+    // Whether clicks may select the entity: active, not editor-only and not a camera or light.
+    static bool isPickable(Entity* entity);
     
 private:
+
     static std::vector<Entity*> s_selectedEntities;
 };
 
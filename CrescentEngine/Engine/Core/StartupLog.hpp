@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace Crescent {
+
+// Startup timing trace, printed only when CRESCENT_RUNTIME_STARTUP_LOG is set to something other
+// than "0".
+inline bool StartupLogEnabled() {
+    static const bool enabled = [] {
+        const char* value = std::getenv("CRESCENT_RUNTIME_STARTUP_LOG");
+        return value && *value && !(value[0] == '0' && value[1] == '\0');
+    }();
+    return enabled;
+}
+
+inline void StartupLog(const std::string& message) {
+    if (StartupLogEnabled()) {
+        std::cout << "[RuntimeStartup] " << message << std::endl;
+    }
+}
+
+} // namespace Crescent
@@ -0,0 +1,199 @@
+#include "StartupTrace.hpp"
+#include "../../../ThirdParty/nlohmann/json.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace Crescent {
+
+namespace {
+    std::string ResolveTracePath() {
+        const char* value = std::getenv("CRESCENT_STARTUP_TRACE");
+        if (!value || !*value || (value[0] == '0' && value[1] == '\0')) {
+            return std::string();
+        }
+        if (value[0] == '1' && value[1] == '\0') {
+            std::error_code ec;
+            std::filesystem::path temp = std::filesystem::temp_directory_path(ec);
+            return (ec ? std::filesystem::path(".") : temp).append("crescent_startup_trace.json").string();
+        }
+        return value;
+    }
+
+    // Time from the kernel starting the process to now, which covers dyld and static
+    // initialisation; zero where the start time is unknown.
+    int64_t MicrosecondsSinceLaunch() {
+#ifdef __APPLE__
+        int mib[4] = {CTL_KERN, KERN_PROC, KERN_PROC_PID, static_cast<int>(getpid())};
+        struct kinfo_proc info{};
+        size_t size = sizeof(info);
+        if (sysctl(mib, 4, &info, &size, nullptr, 0) != 0) {
+            return 0;
+        }
+        struct timeval now{};
+        gettimeofday(&now, nullptr);
+        const struct timeval& start = info.kp_proc.p_starttime;
+        const int64_t elapsed = (static_cast<int64_t>(now.tv_sec) - start.tv_sec) * 1000000 +
+                                (static_cast<int64_t>(now.tv_usec) - start.tv_usec);
+        return elapsed > 0 ? elapsed : 0;
+#else
+        return 0;
+#endif
+    }
+
+    // Starts the clock during static initialisation rather than at the first traced call.
+    const bool s_TraceStarted = (StartupTrace::getInstance(), true);
+}
+
+StartupTrace& StartupTrace::getInstance() {
+    static StartupTrace instance;
+    return instance;
+}
+
+StartupTrace::StartupTrace()
+    : m_OutputPath(ResolveTracePath())
+    , m_Origin(Clock::now()) {
+    if (m_OutputPath.empty()) {
+        return;
+    }
+    m_LaunchOffsetUs = MicrosecondsSinceLaunch();
+    m_Events.reserve(1024);
+    if (m_LaunchOffsetUs > 0) {
+        Event launch;
+        launch.category = "process";
+        launch.name = "ProcessLaunch";
+        launch.durationUs = m_LaunchOffsetUs;
+        launch.thread = threadIndex();
+        m_Events.push_back(std::move(launch));
+    }
+    m_Recording.store(true, std::memory_order_relaxed);
+}
+
+uint32_t StartupTrace::threadIndex() {
+    auto inserted = m_Threads.emplace(std::this_thread::get_id(), static_cast<uint32_t>(m_Threads.size()));
+    return inserted.first->second;
+}
+
+int64_t StartupTrace::toMicroseconds(Clock::time_point time) const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - m_Origin).count() + m_LaunchOffsetUs;
+}
+
+void StartupTrace::addSpan(const char* category, const std::string& name, Clock::time_point start,
+                           Clock::time_point end, const std::string& detail) {
+    if (!isRecording()) {
+        return;
+    }
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.detail = detail;
+    event.startUs = toMicroseconds(start);
+    event.durationUs = std::max<int64_t>(toMicroseconds(end) - event.startUs, 0);
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!isRecording()) {
+        return;
+    }
+    event.thread = threadIndex();
+    m_Events.push_back(std::move(event));
+}
+
+void StartupTrace::addInstant(const char* category, const std::string& name) {
+    if (!isRecording()) {
+        return;
+    }
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.startUs = toMicroseconds(Clock::now());
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!isRecording()) {
+        return;
+    }
+    event.thread = threadIndex();
+    m_Events.push_back(std::move(event));
+}
+
+void StartupTrace::markFirstFrame() {
+    if (!isRecording()) {
+        return;
+    }
+    const int64_t firstFrameUs = toMicroseconds(Clock::now());
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_Recording.exchange(false)) {
+            return;
+        }
+        Event event;
+        event.category = "frame";
+        event.name = "FirstFrame";
+        event.startUs = firstFrameUs;
+        event.thread = threadIndex();
+        m_Events.push_back(std::move(event));
+    }
+    write();
+    std::cout << "StartupTrace: first frame at " << (firstFrameUs / 1000) << "ms, trace written to "
+              << m_OutputPath << std::endl;
+}
+
+void StartupTrace::write() {
+    using nlohmann::json;
+    const int pid = 1;
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    json events = json::array();
+    for (const auto& [id, index] : m_Threads) {
+        events.push_back({
+            {"name", "thread_name"}, {"ph", "M"}, {"pid", pid}, {"tid", index},
+            {"args", {{"name", index == 0 ? std::string("Main") : "Worker " + std::to_string(index)}}}
+        });
+    }
+    for (const Event& event : m_Events) {
+        json entry = {
+            {"name", event.name}, {"cat", event.category}, {"pid", pid}, {"tid", event.thread}, {"ts", event.startUs}
+        };
+        if (event.durationUs >= 0) {
+            entry["ph"] = "X";
+            entry["dur"] = event.durationUs;
+        } else {
+            entry["ph"] = "i";
+            entry["s"] = "g";
+        }
+        if (!event.detail.empty()) {
+            entry["args"] = {{"detail", event.detail}};
+        }
+        events.push_back(std::move(entry));
+    }
+    json root = {{"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}};
+    std::ofstream out(m_OutputPath, std::ios::trunc);
+    if (!out) {
+        std::cerr << "StartupTrace: failed to write " << m_OutputPath << std::endl;
+        return;
+    }
+    out << root.dump();
+    m_Events.clear();
+    m_Events.shrink_to_fit();
+}
+
+StartupTraceScope::StartupTraceScope(const char* category, std::string name, std::string detail)
+    : m_Category(category)
+    , m_Active(StartupTrace::getInstance().isRecording()) {
+    if (m_Active) {
+        m_Name = std::move(name);
+        m_Detail = std::move(detail);
+        m_Start = StartupTrace::Clock::now();
+    }
+}
+
+StartupTraceScope::~StartupTraceScope() {
+    if (m_Active) {
+        StartupTrace::getInstance().addSpan(m_Category, m_Name, m_Start, StartupTrace::Clock::now(), m_Detail);
+    }
+}
+
+} // namespace Crescent
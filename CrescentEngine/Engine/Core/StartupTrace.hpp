@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Crescent {
+
+// Cold-start trace in the Chrome trace event format, readable by Perfetto and chrome://tracing.
+// Recording starts with the process when CRESCENT_STARTUP_TRACE is set, to an output path or to
+// "1" for crescent_startup_trace.json in the temp directory, and ends when the first frame's
+// command buffer completes; the file is written then, so the last event marks time-to-first-frame.
+class StartupTrace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static StartupTrace& getInstance();
+
+    bool isRecording() const { return m_Recording.load(std::memory_order_relaxed); }
+
+    // Thread-safe. Spans overlapping on one thread must nest, as they do from StartupTraceScope.
+    void addSpan(const char* category, const std::string& name, Clock::time_point start, Clock::time_point end,
+                 const std::string& detail = std::string());
+    void addInstant(const char* category, const std::string& name);
+
+    // Stops recording and writes the trace; later calls do nothing.
+    void markFirstFrame();
+
+private:
+    struct Event {
+        const char* category = "";
+        std::string name;
+        std::string detail;
+        int64_t startUs = 0;
+        int64_t durationUs = -1; // instant when negative
+        uint32_t thread = 0;
+    };
+
+    StartupTrace();
+    uint32_t threadIndex();
+    int64_t toMicroseconds(Clock::time_point time) const;
+    void write();
+
+    std::atomic<bool> m_Recording{false};
+    std::string m_OutputPath;
+    Clock::time_point m_Origin;
+    int64_t m_LaunchOffsetUs = 0; // process launch, before m_Origin
+    std::mutex m_Mutex;
+    std::vector<Event> m_Events;
+    std::unordered_map<std::thread::id, uint32_t> m_Threads;
+};
+
+// Records the enclosing block as one span; costs a single flag check when the trace is off.
+class StartupTraceScope {
+public:
+    StartupTraceScope(const char* category, std::string name, std::string detail = std::string());
+    ~StartupTraceScope();
+
+    StartupTraceScope(const StartupTraceScope&) = delete;
+    StartupTraceScope& operator=(const StartupTraceScope&) = delete;
+
+    void setDetail(std::string detail) { m_Detail = std::move(detail); }
+
+private:
+    const char* m_Category;
+    std::string m_Name;
+    std::string m_Detail;
+    StartupTrace::Clock::time_point m_Start;
+    bool m_Active;
+};
+
+} // namespace Crescent
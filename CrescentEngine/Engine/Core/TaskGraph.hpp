@@ -1,18 +1,52 @@
 #pragma once
 
+#include "CPUProfiler.hpp"
 #include "JobSystem.hpp"
+#include <algorithm>
 #include <atomic>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace Crescent {
 
+// Dependency graph of frame tasks. The topology is built once, frozen by compile(), and then
+// replayed every frame: run() only resets counters and queues jobs, so steady-state frames do
+// not allocate. Per-frame inputs are read by the task bodies (capture `this` and read members).
 class TaskGraph {
 public:
     using TaskId = size_t;
+    using Task = std::function<void()>;
+    using RangeTask = std::function<void(size_t begin, size_t end)>;
+    using RangeCount = std::function<size_t()>;
+
+    TaskGraph() = default;
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    TaskId addTask(const std::string& name, Task task) {
+        m_compiled = false;
+        TaskDef def;
+        def.name = name;
+        def.profileName = CPUProfiler::getInstance().intern(name);
+        def.task = std::move(task);
+        m_tasks.push_back(std::move(def));
+        return m_tasks.size() - 1;
+    }
 
-    TaskId addTask(const std::string& name, JobSystem::Job task) {
-        m_tasks.push_back(TaskDef{name, std::move(task), {}});
+    // Parallel-for node: count() is evaluated when the node becomes ready, the range is split
+    // into chunks of at least grainSize across the workers, and dependents run once every
+    // chunk has finished.
+    TaskId addParallelFor(const std::string& name, RangeCount count, RangeTask body, size_t grainSize = 32) {
+        m_compiled = false;
+        TaskDef def;
+        def.name = name;
+        def.profileName = CPUProfiler::getInstance().intern(name);
+        def.rangeCount = std::move(count);
+        def.rangeBody = std::move(body);
+        def.grainSize = std::max<size_t>(1, grainSize);
+        m_tasks.push_back(std::move(def));
         return m_tasks.size() - 1;
     }
 
@@ -20,91 +54,145 @@ public:
         if (task >= m_tasks.size() || dependsOn >= m_tasks.size() || task == dependsOn) {
             return;
         }
+        m_compiled = false;
         m_tasks[task].dependencies.push_back(dependsOn);
     }
 
-    JobSystem::JobHandle run(JobSystem& jobSystem) const {
-        auto state = std::make_shared<GraphState>();
-        state->nodes.resize(m_tasks.size());
+    size_t taskCount() const { return m_tasks.size(); }
+    const std::string& taskName(TaskId id) const { return m_tasks[id].name; }
+    bool isCompiled() const { return m_compiled; }
 
-        for (size_t i = 0; i < m_tasks.size(); ++i) {
-            state->nodes[i].task = m_tasks[i].task;
-            state->nodes[i].pendingDeps.store(static_cast<int>(m_tasks[i].dependencies.size()),
-                                              std::memory_order_relaxed);
+    void compile() {
+        const size_t count = m_tasks.size();
+        m_initialPending.assign(count, 0);
+        m_dependentOffsets.assign(count + 1, 0);
+        for (size_t i = 0; i < count; ++i) {
+            m_initialPending[i] = static_cast<int>(m_tasks[i].dependencies.size());
+            for (TaskId dependency : m_tasks[i].dependencies) {
+                m_dependentOffsets[dependency + 1]++;
+            }
         }
-
-        for (size_t i = 0; i < m_tasks.size(); ++i) {
+        for (size_t i = 0; i < count; ++i) {
+            m_dependentOffsets[i + 1] += m_dependentOffsets[i];
+        }
+        m_dependents.assign(m_dependentOffsets[count], 0);
+        std::vector<size_t> cursor(m_dependentOffsets.begin(), m_dependentOffsets.end() - 1);
+        for (size_t i = 0; i < count; ++i) {
             for (TaskId dependency : m_tasks[i].dependencies) {
-                if (dependency < state->nodes.size()) {
-                    state->nodes[dependency].dependents.push_back(i);
-                }
+                m_dependents[cursor[dependency]++] = i;
             }
         }
-
-        JobSystem::JobHandle handle = jobSystem.createHandle();
-        state->handle = handle;
-
-        for (TaskId i = 0; i < state->nodes.size(); ++i) {
-            if (state->nodes[i].pendingDeps.load(std::memory_order_relaxed) == 0) {
-                scheduleTask(i, state, jobSystem);
+        m_roots.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (m_initialPending[i] == 0) {
+                m_roots.push_back(i);
             }
         }
+        m_pending = std::make_unique<std::atomic<int>[]>(count);
+        m_chunksRemaining = std::make_unique<std::atomic<size_t>[]>(count);
+        if (!m_handle.fence) {
+            m_handle.fence = std::make_shared<JobFence>();
+        }
+        m_compiled = true;
+    }
+
+    // Replays the graph. The returned handle is owned by the graph and reused between runs;
+    // a run that overlaps an unfinished one waits for it first.
+    JobSystem::JobHandle run(JobSystem& jobSystem) {
+        if (!m_compiled) {
+            compile();
+        }
+        if (!m_handle.fence->isComplete()) {
+            jobSystem.wait(m_handle);
+        }
+        m_jobSystem = &jobSystem;
+        for (size_t i = 0; i < m_tasks.size(); ++i) {
+            m_pending[i].store(m_initialPending[i], std::memory_order_relaxed);
+        }
 
-        return handle;
+        // Hold the fence while seeding roots so a fast root cannot complete it early.
+        m_handle.fence->remaining.fetch_add(1, std::memory_order_relaxed);
+        for (TaskId root : m_roots) {
+            scheduleTask(root);
+        }
+        m_handle.fence->signal();
+        return m_handle;
     }
 
 private:
     struct TaskDef {
         std::string name;
-        JobSystem::Job task;
+        // Interned copy of name for profiler scopes.
+        const char* profileName = nullptr;
+        Task task;
+        RangeCount rangeCount;
+        RangeTask rangeBody;
+        size_t grainSize = 1;
         std::vector<TaskId> dependencies;
     };
 
-    struct GraphState {
-        struct Node {
-            JobSystem::Job task;
-            std::vector<TaskId> dependents;
-            std::atomic<int> pendingDeps{0};
-            Node() = default;
-            Node(const Node&) = delete;
-            Node& operator=(const Node&) = delete;
-            Node(Node&& other) noexcept
-                : task(std::move(other.task))
-                , dependents(std::move(other.dependents)) {
-                pendingDeps.store(other.pendingDeps.load(std::memory_order_relaxed),
-                                  std::memory_order_relaxed);
-            }
-            Node& operator=(Node&& other) noexcept {
-                if (this != &other) {
-                    task = std::move(other.task);
-                    dependents = std::move(other.dependents);
-                    pendingDeps.store(other.pendingDeps.load(std::memory_order_relaxed),
-                                      std::memory_order_relaxed);
-                }
-                return *this;
+    void scheduleTask(TaskId id) {
+        m_jobSystem->submit([this, id]() { executeTask(id); }, m_handle);
+    }
+
+    void executeTask(TaskId id) {
+        TaskDef& def = m_tasks[id];
+        if (!def.rangeBody) {
+            if (def.task) {
+                CRESCENT_PROFILE_SCOPE(def.profileName);
+                def.task();
             }
-        };
+            finishTask(id);
+            return;
+        }
 
-        std::vector<Node> nodes;
-        JobSystem::JobHandle handle;
-    };
+        const size_t count = def.rangeCount ? def.rangeCount() : 0;
+        if (count == 0) {
+            finishTask(id);
+            return;
+        }
+        const size_t maxChunks = m_jobSystem->workerCount() + 1;
+        const size_t chunkSize = std::max(def.grainSize, (count + maxChunks - 1) / maxChunks);
+        const size_t chunks = (count + chunkSize - 1) / chunkSize;
+        m_chunksRemaining[id].store(chunks, std::memory_order_relaxed);
+        for (size_t chunk = 1; chunk < chunks; ++chunk) {
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(count, begin + chunkSize);
+            m_jobSystem->submit([this, id, begin, end]() { runChunk(id, begin, end); }, m_handle);
+        }
+        runChunk(id, 0, std::min(count, chunkSize));
+    }
 
-    static void scheduleTask(TaskId id,
-                             const std::shared_ptr<GraphState>& state,
-                             JobSystem& jobSystem) {
-        jobSystem.submit([state, id, &jobSystem]() {
-            if (state->nodes[id].task) {
-                state->nodes[id].task();
-            }
-            for (TaskId dependent : state->nodes[id].dependents) {
-                if (state->nodes[dependent].pendingDeps.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                    scheduleTask(dependent, state, jobSystem);
-                }
+    void runChunk(TaskId id, size_t begin, size_t end) {
+        {
+            CRESCENT_PROFILE_SCOPE(m_tasks[id].profileName);
+            m_tasks[id].rangeBody(begin, end);
+        }
+        if (m_chunksRemaining[id].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            finishTask(id);
+        }
+    }
+
+    void finishTask(TaskId id) {
+        for (size_t i = m_dependentOffsets[id]; i < m_dependentOffsets[id + 1]; ++i) {
+            TaskId dependent = m_dependents[i];
+            if (m_pending[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                scheduleTask(dependent);
             }
-        }, state->handle);
+        }
     }
 
     std::vector<TaskDef> m_tasks;
+    bool m_compiled = false;
+
+    std::vector<int> m_initialPending;
+    std::vector<size_t> m_dependentOffsets;
+    std::vector<TaskId> m_dependents;
+    std::vector<TaskId> m_roots;
+    std::unique_ptr<std::atomic<int>[]> m_pending;
+    std::unique_ptr<std::atomic<size_t>[]> m_chunksRemaining;
+    JobSystem::JobHandle m_handle;
+    JobSystem* m_jobSystem = nullptr;
 };
 
 } // namespace Crescent
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef __APPLE__
+#include <pthread.h>
+#include <pthread/qos.h>
+#endif
+
+namespace Crescent {
+
+// Quality-of-service class of an engine thread. On Apple silicon the kernel places threads by it:
+// interactive work gets the performance cores, utility and background work stays on the
+// efficiency cores unless they are saturated and the performance cores are idle.
+enum class ThreadQoS : uint8_t {
+    Interactive,   // the frame: update, render and their jobs
+    UserInitiated, // work the user is waiting on, such as an import they started
+    Utility,       // streaming, baking, cooking
+    Background     // thumbnails and other work nobody is waiting on
+};
+
+// Applies to the calling thread only; threads it creates afterwards inherit the class.
+inline void SetCurrentThreadQoS(ThreadQoS qos) {
+#ifdef __APPLE__
+    qos_class_t qosClass = QOS_CLASS_USER_INTERACTIVE;
+    switch (qos) {
+        case ThreadQoS::Interactive: qosClass = QOS_CLASS_USER_INTERACTIVE; break;
+        case ThreadQoS::UserInitiated: qosClass = QOS_CLASS_USER_INITIATED; break;
+        case ThreadQoS::Utility: qosClass = QOS_CLASS_UTILITY; break;
+        case ThreadQoS::Background: qosClass = QOS_CLASS_BACKGROUND; break;
+    }
+    pthread_set_qos_class_self_np(qosClass, 0);
+#else
+    (void)qos;
+#endif
+}
+
+} // namespace Crescent
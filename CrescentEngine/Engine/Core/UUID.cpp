@@ -1,15 +1,24 @@
 #include "UUID.hpp"
 #include <sstream>
 #include <iomanip>
+#include <cstdlib>
+#include <mutex>
 
 namespace Crescent {
 
 static std::random_device s_RandomDevice;
 static std::mt19937_64 s_Engine(s_RandomDevice());
 static std::uniform_int_distribution<uint64_t> s_UniformDistribution;
+static std::mutex s_EngineMutex;
+
+static uint64_t NextRandom() {
+    // Asset scans create guids from several threads at once.
+    std::lock_guard<std::mutex> lock(s_EngineMutex);
+    return s_UniformDistribution(s_Engine);
+}
 
 UUID::UUID()
-    : m_UUID(s_UniformDistribution(s_Engine)) {
+    : m_UUID(NextRandom()) {
 }
 
 UUID::UUID(uint64_t uuid)
@@ -22,4 +31,16 @@ std::string UUID::toString() const {
     return ss.str();
 }
 
+UUID UUID::fromString(const std::string& value) {
+    if (value.empty()) {
+        return Invalid();
+    }
+    char* end = nullptr;
+    const unsigned long long parsed = std::strtoull(value.c_str(), &end, 16);
+    if (!end || *end != '\0') {
+        return Invalid();
+    }
+    return UUID(static_cast<uint64_t>(parsed));
+}
+
 } // namespace Crescent
@@ -18,6 +18,8 @@ public:
     
     bool isValid() const { return m_UUID != 0; }
     std::string toString() const;
+    // Parses the hex form written by toString(); returns Invalid() for malformed input.
+    static UUID fromString(const std::string& value);
     
     bool operator==(const UUID& other) const { return m_UUID == other.m_UUID; }
     bool operator!=(const UUID& other) const { return m_UUID != other.m_UUID; }
@@ -1,4 +1,7 @@
 #include "Component.hpp"
+#include "Entity.hpp"
+#include "../Components/HLODProxy.hpp"
+#include "../Scene/Scene.hpp"
 
 namespace Crescent {
 
@@ -6,6 +9,10 @@ void Component::setEnabled(bool enabled) {
     if (m_Enabled == enabled) return;
     
     m_Enabled = enabled;
+    // The HLOD switch reads its proxies' enable state when it rebuilds.
+    if (m_Entity && m_Entity->getScene() && m_Entity->getComponent<HLODProxy>()) {
+        m_Entity->getScene()->markHLODDirty();
+    }
     
     if (m_Enabled) {
         OnEnable();
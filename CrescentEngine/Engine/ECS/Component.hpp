@@ -1,7 +1,11 @@
 #pragma once
 
+#include "ComponentPool.hpp"
+#include "RenderSnapshot.hpp"
+#include <cstdint>
 #include <string>
 #include <typeindex>
+#include <type_traits>
 #include <memory>
 
 namespace Crescent {
@@ -10,6 +14,16 @@ namespace Crescent {
 class Entity;
 struct PhysicsContact;
 
+// Per-frame hooks a component type overrides. The scene keeps a list per type and only walks the
+// types that have the hook (see Scene::OnUpdate).
+enum ComponentUpdateHook : uint32_t {
+    kComponentHookUpdate = 1u << 0,
+    kComponentHookFixedUpdate = 1u << 1,
+    kComponentHookEditorUpdate = 1u << 2,
+    kComponentHookAnimation = 1u << 3,
+    kComponentHookAll = 0xFu
+};
+
 // Base component class - all components inherit from this
 class Component {
 public:
@@ -26,7 +40,24 @@ public:
     virtual void OnFixedUpdate(float deltaTime) {}
     virtual void OnEditorUpdate(float deltaTime) {}
 
-    // Physics callbacks
+    // Opt-in for the frame graph's parallel-for phases. Returning true promises that OnUpdate and
+    // OnFixedUpdate only touch this component's own entity, so they may run concurrently with
+    // other parallel components (and after the serial components of the same phase). Structural
+    // changes (spawning, destroying, adding or removing components, reparenting) go through the
+    // scene's EntityCommandBuffer instead and land at the next sync point.
+    virtual bool supportsParallelUpdate() const { return false; }
+
+    // Opt-in for the frame graph's animation phase, which replaces OnUpdate for the component.
+    // OnAnimationEvaluate runs concurrently with the other animated components and may only touch
+    // this component's own state and the skinned renderers it drives; anything that reaches other
+    // entities or transforms (root motion, IK, events) goes in OnAnimationFinalize, run serially.
+    virtual bool hasAnimationPhase() const { return false; }
+    virtual void OnAnimationEvaluate(float deltaTime) {}
+    virtual void OnAnimationFinalize() {}
+
+    // Physics callbacks. Stay fires every step for every touching pair, so OnCollisionStay and
+    // OnTriggerStay only reach components that opt in.
+    virtual bool wantsContactStay() const { return false; }
     virtual void OnCollisionEnter(const PhysicsContact& contact) {}
     virtual void OnCollisionStay(const PhysicsContact& contact) {}
     virtual void OnCollisionExit(const PhysicsContact& contact) {}
@@ -37,14 +68,18 @@ public:
     // Get component type name (for reflection)
     virtual std::string getTypeName() const = 0;
     virtual std::type_index getTypeIndex() const = 0;
+    // ComponentUpdateHook bits, filled in by COMPONENT_TYPE. Types without it get every hook.
+    virtual uint32_t getUpdateHooks() const { return kComponentHookAll; }
     
     // Entity reference
     Entity* getEntity() const { return m_Entity; }
     void setEntity(Entity* entity) { m_Entity = entity; }
     
     // Enable/Disable
-    bool isEnabled() const { return m_Enabled; }
+    bool isEnabled() const { return RenderSnapshot::isReading() ? m_PublishedEnabled : m_Enabled; }
     void setEnabled(bool enabled);
+    // Copies the enable state into the render snapshot (see RenderSnapshot).
+    void publishEnabled() { m_PublishedEnabled = m_Enabled; }
 
     bool hasStarted() const { return m_HasStarted; }
     void markStarted(bool started) { m_HasStarted = started; }
@@ -52,17 +87,58 @@ public:
     // Component serialization interface
     virtual void serialize(class Serializer& serializer) {}
     virtual void deserialize(class Deserializer& deserializer) {}
+
+    // Copy for the play-mode scene (see Scene::cloneFrom). Meshes, materials, textures and clips
+    // are shared rather than reloaded; the copy comes back detached and enabled, the state a
+    // component read from a scene file starts in. nullptr means the type cannot be cloned and the
+    // scene goes through the serializer instead.
+    virtual std::unique_ptr<Component> clone() const { return nullptr; }
     
 protected:
+    // Clears what a copy constructor brought over from the source's entity and lifecycle.
+    static std::unique_ptr<Component> detachClone(std::unique_ptr<Component> copy) {
+        copy->m_Entity = nullptr;
+        copy->m_Enabled = true;
+        copy->m_PublishedEnabled = true;
+        copy->m_HasStarted = false;
+        return copy;
+    }
+
     Entity* m_Entity = nullptr;
     bool m_Enabled = true;
+    bool m_PublishedEnabled = true;
     bool m_HasStarted = false;
 };
 
+// The hooks T overrides, read off the member pointer types: an inherited default still has
+// Component as its class.
+template <typename T>
+constexpr uint32_t DetectComponentUpdateHooks() {
+    uint32_t hooks = 0;
+    if (!std::is_same_v<decltype(&T::OnUpdate), void (Component::*)(float)>) {
+        hooks |= kComponentHookUpdate;
+    }
+    if (!std::is_same_v<decltype(&T::OnFixedUpdate), void (Component::*)(float)>) {
+        hooks |= kComponentHookFixedUpdate;
+    }
+    if (!std::is_same_v<decltype(&T::OnEditorUpdate), void (Component::*)(float)>) {
+        hooks |= kComponentHookEditorUpdate;
+    }
+    if (!std::is_same_v<decltype(&T::hasAnimationPhase), bool (Component::*)() const>) {
+        hooks |= kComponentHookAnimation;
+    }
+    return hooks;
+}
+
 // Macro to help implement component type info
 #define COMPONENT_TYPE(Type) \
     std::string getTypeName() const override { return #Type; } \
     std::type_index getTypeIndex() const override { return std::type_index(typeid(Type)); } \
+    uint32_t getUpdateHooks() const override { return DetectComponentUpdateHooks<Type>(); } \
     static std::type_index StaticTypeIndex() { return std::type_index(typeid(Type)); }
 
+// Clone for components whose members are all settings or shared assets.
+#define COMPONENT_CLONE_BY_COPY(Type) \
+    std::unique_ptr<Component> clone() const override { return detachClone(std::make_unique<Type>(*this)); }
+
 } // namespace Crescent
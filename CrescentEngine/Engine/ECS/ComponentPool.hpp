@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace Crescent {
+
+// Chunked, densely packed storage for one hot component type. Components stay individually
+// owned by their Entity (unique_ptr, virtual destructor), but their memory comes from fixed-size
+// chunks of contiguous slots instead of separate heap blocks, so walking every instance of the
+// type touches memory linearly. Slot addresses are stable for the component's lifetime.
+//
+// Types opt in with COMPONENT_POOLED(Type), which routes their class operator new/delete here.
+// Allocation is serialised; forEach() must not race structural changes, which already go
+// through RenderSnapshot::syncStructuralChange().
+template <typename T>
+class ComponentPool {
+public:
+    static constexpr size_t kChunkSize = 256;
+
+    static ComponentPool& getInstance() {
+        // Never destroyed: components owned by other singletons may be released during exit.
+        static ComponentPool* pool = new ComponentPool();
+        return *pool;
+    }
+
+    void* allocate() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_FreeSlots.empty()) {
+            addChunk();
+        }
+        SlotRef ref = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+        Chunk& chunk = *m_Chunks[ref.chunk];
+        chunk.live.set(ref.slot);
+        m_LiveCount++;
+        return chunk.slots[ref.slot].storage;
+    }
+
+    void release(void* ptr) {
+        if (!ptr) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        const auto* bytes = static_cast<const std::byte*>(ptr);
+        // The chunk starting at or below the address. A scene unload releases every instance,
+        // so the lookup stays logarithmic in the chunk count rather than scanning the chunks.
+        auto it = std::upper_bound(m_ChunksByAddress.begin(), m_ChunksByAddress.end(), bytes,
+            [](const std::byte* address, const ChunkAddress& chunk) { return address < chunk.first; });
+        if (it == m_ChunksByAddress.begin()) {
+            return;
+        }
+        --it;
+        Chunk& chunk = *m_Chunks[it->chunk];
+        if (bytes > chunk.slots[kChunkSize - 1].storage) {
+            return;
+        }
+        const size_t slot = static_cast<size_t>(bytes - it->first) / sizeof(Slot);
+        chunk.live.reset(slot);
+        m_LiveCount--;
+        m_FreeSlots.push_back({it->chunk, static_cast<uint32_t>(slot)});
+    }
+
+    // Visits every live instance in storage order.
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& chunkPtr : m_Chunks) {
+            const Chunk& chunk = *chunkPtr;
+            if (chunk.live.none()) {
+                continue;
+            }
+            for (size_t slot = 0; slot < kChunkSize; ++slot) {
+                if (chunk.live.test(slot)) {
+                    fn(*std::launder(reinterpret_cast<T*>(const_cast<std::byte*>(chunk.slots[slot].storage))));
+                }
+            }
+        }
+    }
+
+    size_t size() const { return m_LiveCount; }
+
+private:
+    struct Slot {
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    struct Chunk {
+        std::array<Slot, kChunkSize> slots;
+        std::bitset<kChunkSize> live;
+    };
+
+    struct SlotRef {
+        uint32_t chunk;
+        uint32_t slot;
+    };
+
+    struct ChunkAddress {
+        const std::byte* first;
+        uint32_t chunk;
+    };
+
+    void addChunk() {
+        const uint32_t chunkIndex = static_cast<uint32_t>(m_Chunks.size());
+        m_Chunks.push_back(std::make_unique<Chunk>());
+        const ChunkAddress address{m_Chunks.back()->slots[0].storage, chunkIndex};
+        m_ChunksByAddress.insert(std::upper_bound(m_ChunksByAddress.begin(), m_ChunksByAddress.end(), address,
+            [](const ChunkAddress& a, const ChunkAddress& b) { return a.first < b.first; }), address);
+        m_FreeSlots.reserve(m_FreeSlots.size() + kChunkSize);
+        // Pushed in reverse so slots are handed out front to back.
+        for (size_t slot = kChunkSize; slot > 0; --slot) {
+            m_FreeSlots.push_back({chunkIndex, static_cast<uint32_t>(slot - 1)});
+        }
+    }
+
+    std::vector<std::unique_ptr<Chunk>> m_Chunks;
+    std::vector<ChunkAddress> m_ChunksByAddress; // sorted by first slot
+    std::vector<SlotRef> m_FreeSlots;
+    size_t m_LiveCount = 0;
+    std::mutex m_Mutex;
+};
+
+// Routes a component's allocations through ComponentPool<Type>. Derived classes that do not
+// opt in themselves fall back to the global heap because their size differs.
+#define COMPONENT_POOLED(Type) \
+    static constexpr bool kPooledStorage = true; \
+    static void* operator new(std::size_t size) { \
+        return size == sizeof(Type) ? ::Crescent::ComponentPool<Type>::getInstance().allocate() : ::operator new(size); \
+    } \
+    static void operator delete(void* ptr, std::size_t size) { \
+        if (size == sizeof(Type)) { \
+            ::Crescent::ComponentPool<Type>::getInstance().release(ptr); \
+        } else { \
+            ::operator delete(ptr); \
+        } \
+    }
+
+} // namespace Crescent
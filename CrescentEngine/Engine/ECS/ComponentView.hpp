@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ComponentPool.hpp"
+#include "Entity.hpp"
+#include "Transform.hpp"
+#include <type_traits>
+
+namespace Crescent {
+
+class Scene;
+
+// Typed iteration over the components of one scene: scene->view<MeshRenderer, Transform>()
+// walks ComponentPool<MeshRenderer> in storage order and resolves the remaining types on the
+// owning entity. The first type must be pooled (COMPONENT_POOLED); put the rarest type first.
+template <typename T, typename... Others>
+class ComponentView {
+public:
+    static_assert(T::kPooledStorage, "The first view type must use COMPONENT_POOLED storage");
+
+    explicit ComponentView(const Scene* scene) : m_Scene(scene) {}
+
+    // fn(Entity&, T&, Others&...) for every entity of the scene that has all the types.
+    // Disabled components and inactive entities are included; filter in fn when needed.
+    template <typename Fn>
+    void each(Fn&& fn) const {
+        ComponentPool<T>::getInstance().forEach([&](T& component) {
+            Entity* entity = component.getEntity();
+            if (!entity || entity->getScene() != m_Scene) {
+                return;
+            }
+            invoke(fn, *entity, component, resolve<Others>(*entity)...);
+        });
+    }
+
+    // Upper bound on the number of visited components across all scenes.
+    size_t capacityHint() const { return ComponentPool<T>::getInstance().size(); }
+
+private:
+    template <typename U>
+    static U* resolve(Entity& entity) {
+        if constexpr (std::is_same_v<U, Transform>) {
+            return entity.getTransform();
+        } else {
+            return entity.getComponent<U>();
+        }
+    }
+
+    template <typename Fn, typename... Ptrs>
+    static void invoke(Fn& fn, Entity& entity, T& component, Ptrs*... others) {
+        if ((... && (others != nullptr))) {
+            fn(entity, component, *others...);
+        }
+    }
+
+    const Scene* m_Scene;
+};
+
+} // namespace Crescent
@@ -1,5 +1,8 @@
 #include "Entity.hpp"
 #include "Transform.hpp"
+#include "../Components/Light.hpp"
+#include "../Components/MeshRenderer.hpp"
+#include "../Components/Rigidbody.hpp"
 #include "../Physics/PhysicsTypes.hpp"
 #include "../Scene/Scene.hpp"
 #include "../Scene/SceneManager.hpp"
@@ -18,6 +21,11 @@ std::unordered_multimap<std::string, Entity*>& Entity::getTagRegistry(Scene* sce
     return s_TagRegistry[scene];
 }
 
+void Entity::releaseRegistries(Scene* scene) {
+    s_NameRegistry.erase(scene);
+    s_TagRegistry.erase(scene);
+}
+
 std::string Entity::makeUniqueName(const std::string& desired, const Entity* self, Scene* scene) {
     std::string baseName = desired.empty() ? "Entity" : desired;
     if (!scene) {
@@ -76,20 +84,24 @@ Entity::~Entity() {
         OnDestroy();
     }
 
-    // Unregister from registries
+    // Unregister from registries, unless the scene already released them whole
     if (m_Scene) {
-        auto& nameRegistry = getNameRegistry(m_Scene);
-        auto nameIt = nameRegistry.find(m_Name);
-        if (nameIt != nameRegistry.end() && nameIt->second == this) {
-            nameRegistry.erase(nameIt);
+        auto names = s_NameRegistry.find(m_Scene);
+        if (names != s_NameRegistry.end()) {
+            auto nameIt = names->second.find(m_Name);
+            if (nameIt != names->second.end() && nameIt->second == this) {
+                names->second.erase(nameIt);
+            }
         }
         
-        auto& tagRegistry = getTagRegistry(m_Scene);
-        auto range = tagRegistry.equal_range(m_Tag);
-        for (auto it = range.first; it != range.second; ++it) {
-            if (it->second == this) {
-                tagRegistry.erase(it);
-                break;
+        auto tags = s_TagRegistry.find(m_Scene);
+        if (tags != s_TagRegistry.end()) {
+            auto range = tags->second.equal_range(m_Tag);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == this) {
+                    tags->second.erase(it);
+                    break;
+                }
             }
         }
     }
@@ -123,9 +135,15 @@ void Entity::setScene(Scene* scene) {
     m_Scene = scene;
     
     if (m_Scene) {
-        m_Name = makeUniqueName(m_Name, this, m_Scene);
         auto& nameRegistry = getNameRegistry(m_Scene);
-        nameRegistry[m_Name] = this;
+        if (m_KeepName) {
+            // Finding a free suffix walks every earlier copy; a spawned copy is only findable by
+            // name while it is the first of its name.
+            nameRegistry.emplace(m_Name, this);
+        } else {
+            m_Name = makeUniqueName(m_Name, this, m_Scene);
+            nameRegistry[m_Name] = this;
+        }
         getTagRegistry(m_Scene).insert({m_Tag, this});
     }
 }
@@ -146,6 +164,7 @@ void Entity::setName(const std::string& name) {
     if (m_Scene) {
         auto& nameRegistry = getNameRegistry(m_Scene);
         nameRegistry[m_Name] = this;
+        m_Scene->getChangeLog().record(SceneChangeLog::Kind::Renamed, m_UUID);
     }
 }
 
@@ -155,6 +174,9 @@ void Entity::setActive(bool active) {
     }
     
     m_IsActive = active;
+    if (m_Scene) {
+        m_Scene->markHLODDirty();
+    }
     
     if (!m_Scene || !m_Scene->isActive()) {
         return;
@@ -176,12 +198,19 @@ void Entity::setActive(bool active) {
     }
 }
 
+void Entity::publishRenderState() {
+    m_PublishedActive = m_IsActive;
+    for (auto& component : m_Components) {
+        component->publishEnabled();
+    }
+}
+
 bool Entity::isSceneActive() const {
     return m_Scene && m_Scene->isActive();
 }
 
 bool Entity::isActiveInHierarchy() const {
-    if (!m_IsActive) return false;
+    if (!isActive()) return false;
     
     Transform* parent = m_Transform->getParent();
     while (parent) {
@@ -218,14 +247,44 @@ void Entity::setTag(const std::string& tag) {
     }
 }
 
+Component* Entity::adoptComponent(std::unique_ptr<Component> component) {
+    if (!component) {
+        return nullptr;
+    }
+    std::type_index typeIndex = component->getTypeIndex();
+    auto existing = m_ComponentMap.find(typeIndex);
+    if (existing != m_ComponentMap.end()) {
+        return existing->second;
+    }
+
+    RenderSnapshot::syncStructuralChange();
+    Component* componentPtr = component.get();
+    component->setEntity(this);
+    m_ComponentMap[typeIndex] = componentPtr;
+    m_Components.push_back(std::move(component));
+    onComponentSetChanged();
+
+    if (m_HasCreated) {
+        componentPtr->OnCreate();
+        if (m_IsActive && isSceneActive() && componentPtr->isEnabled()) {
+            componentPtr->OnEnable();
+        }
+    }
+    return componentPtr;
+}
+
 void Entity::removeComponent(Component* component) {
     if (!component) return;
+    RenderSnapshot::syncStructuralChange();
     
     // Call lifecycle
     if (component->isEnabled()) {
         component->OnDisable();
     }
     component->OnDestroy();
+    if (m_Scene) {
+        m_Scene->forgetComponent(component);
+    }
     
     // Remove from map
     m_ComponentMap.erase(component->getTypeIndex());
@@ -239,9 +298,11 @@ void Entity::removeComponent(Component* component) {
     if (it != m_Components.end()) {
         m_Components.erase(it);
     }
+    onComponentSetChanged();
 }
 
 void Entity::removeAllComponents() {
+    RenderSnapshot::syncStructuralChange();
     removeAllComponentsInternal(true);
 }
 
@@ -253,12 +314,42 @@ void Entity::removeAllComponentsInternal(bool callLifecycle) {
                 component->OnDisable();
             }
             component->OnDestroy();
+            if (m_Scene) {
+                m_Scene->forgetComponent(component.get());
+            }
         }
     }
     
     m_Components.clear();
     m_ComponentMap.clear();
     m_Transform = nullptr;
+    if (m_Scene && m_Scene->isTearingDown()) {
+        // The scene resets its render world, lists and change log once for all its entities.
+        refreshHotComponents();
+        return;
+    }
+    onComponentSetChanged();
+}
+
+void Entity::onComponentSetChanged() {
+    refreshHotComponents();
+    if (m_Scene) {
+        m_Scene->markRenderWorldDirty();
+        m_Scene->markUpdateListsDirty();
+        m_Scene->markSpatialBoundsDirty(this);
+        m_Scene->getChangeLog().record(SceneChangeLog::Kind::ComponentsChanged, m_UUID);
+    }
+}
+
+void Entity::refreshHotComponents() {
+    auto find = [this](const std::type_index& typeIndex) -> Component* {
+        auto it = m_ComponentMap.find(typeIndex);
+        return it != m_ComponentMap.end() ? it->second : nullptr;
+    };
+    m_Transform = static_cast<Transform*>(find(Transform::StaticTypeIndex()));
+    m_MeshRenderer = static_cast<MeshRenderer*>(find(MeshRenderer::StaticTypeIndex()));
+    m_Light = static_cast<Light*>(find(Light::StaticTypeIndex()));
+    m_Rigidbody = static_cast<Rigidbody*>(find(Rigidbody::StaticTypeIndex()));
 }
 
 void Entity::OnCreate() {
@@ -301,36 +392,23 @@ void Entity::OnDestroy() {
     }
 }
 
-void Entity::OnUpdate(float deltaTime) {
-    if (!m_IsActive) return;
-    
-    for (auto& component : m_Components) {
-        if (component->isEnabled()) {
-            component->OnUpdate(deltaTime);
-        }
-    }
-}
-
-void Entity::OnFixedUpdate(float deltaTime) {
-    if (!m_IsActive) {
+void Entity::destroyForTeardown() {
+    if (m_Destroyed) {
         return;
     }
+    m_Destroyed = true;
     for (auto& component : m_Components) {
-        if (component->isEnabled()) {
-            component->OnFixedUpdate(deltaTime);
-        }
+        component->OnDestroy();
     }
 }
 
-void Entity::OnEditorUpdate(float deltaTime) {
-    if (!m_IsActive) {
-        return;
-    }
-    for (auto& component : m_Components) {
-        if (component->isEnabled()) {
-            component->OnEditorUpdate(deltaTime);
+bool Entity::wantsContactStay() const {
+    for (const auto& component : m_Components) {
+        if (component->isEnabled() && component->wantsContactStay()) {
+            return true;
         }
     }
+    return false;
 }
 
 void Entity::OnCollisionEnter(const PhysicsContact& contact) {
@@ -349,7 +427,7 @@ void Entity::OnCollisionStay(const PhysicsContact& contact) {
         return;
     }
     for (auto& component : m_Components) {
-        if (component->isEnabled()) {
+        if (component->isEnabled() && component->wantsContactStay()) {
             component->OnCollisionStay(contact);
         }
     }
@@ -382,7 +460,7 @@ void Entity::OnTriggerStay(const PhysicsContact& contact) {
         return;
     }
     for (auto& component : m_Components) {
-        if (component->isEnabled()) {
+        if (component->isEnabled() && component->wantsContactStay()) {
             component->OnTriggerStay(contact);
         }
     }
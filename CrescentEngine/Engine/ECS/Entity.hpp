@@ -2,17 +2,23 @@
 
 #include "../Core/UUID.hpp"
 #include "Component.hpp"
+#include "RenderSnapshot.hpp"
 #include "Transform.hpp"
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstdint>
 #include <unordered_map>
 #include <typeindex>
+#include <type_traits>
 
 namespace Crescent {
 
 // Forward declaration
 class Scene;
+class MeshRenderer;
+class Light;
+class Rigidbody;
 struct PhysicsContact;
 
 // Entity (GameObject) - container for components
@@ -24,6 +30,11 @@ public:
     
     // Unique identifier
     UUID getUUID() const { return m_UUID; }
+
+    // Dense index in the owning scene, stable for the entity's lifetime and reused after it is
+    // destroyed; kNoIndex outside a scene. Indexes per-frame entity sets such as EntityBitset.
+    static constexpr uint32_t kNoIndex = UINT32_MAX;
+    uint32_t getIndex() const { return m_Index; }
     
     // Name
     const std::string& getName() const { return m_Name; }
@@ -37,10 +48,12 @@ public:
     void setLayer(int layer) { m_Layer = layer; }
     
     // Active state
-    bool isActive() const { return m_IsActive; }
+    bool isActive() const { return RenderSnapshot::isReading() ? m_PublishedActive : m_IsActive; }
     void setActive(bool active);
-    bool isActiveSelf() const { return m_IsActive; }
+    bool isActiveSelf() const { return isActive(); }
     bool isActiveInHierarchy() const;
+    // Copies the active flag and the components' enable state into the render snapshot.
+    void publishRenderState();
 
     // Editor-only flag (not included in play mode)
     bool isEditorOnly() const { return m_EditorOnly; }
@@ -53,7 +66,8 @@ public:
     // Transform (every entity has a transform)
     Transform* getTransform() const { return m_Transform; }
     
-    // Component management
+    // Component management. getComponent of the hot types (Transform, MeshRenderer, Light and
+    // Rigidbody) reads a cached pointer instead of the type map.
     template<typename T, typename... Args>
     T* addComponent(Args&&... args);
     
@@ -66,6 +80,10 @@ public:
     template<typename T>
     void removeComponent();
     
+    // Attaches a component made elsewhere, such as a Component::clone(), with the same lifecycle as
+    // addComponent. Returns the existing component instead if the type is already attached.
+    Component* adoptComponent(std::unique_ptr<Component> component);
+
     void removeComponent(Component* component);
     void removeAllComponents();
     
@@ -77,9 +95,8 @@ public:
     void OnCreate();
     void OnStart();
     void OnDestroy();
-    void OnUpdate(float deltaTime);
-    void OnFixedUpdate(float deltaTime);
-    void OnEditorUpdate(float deltaTime);
+    // Whether an enabled component takes OnCollisionStay/OnTriggerStay (see Component).
+    bool wantsContactStay() const;
     void OnCollisionEnter(const PhysicsContact& contact);
     void OnCollisionStay(const PhysicsContact& contact);
     void OnCollisionExit(const PhysicsContact& contact);
@@ -97,8 +114,17 @@ public:
     static std::vector<Entity*> FindAllWithTag(const std::string& tag);
     
 private:
+    friend class Scene;
+
     void addComponentInternal(std::unique_ptr<Component> component);
     void removeAllComponentsInternal(bool callLifecycle);
+    // OnDestroy for Scene::destroyAllEntities: the scene is going with the entity, so components
+    // are not switched off first.
+    void destroyForTeardown();
+    // Drops the scene's name and tag registries whole ahead of its entities.
+    static void releaseRegistries(Scene* scene);
+    void onComponentSetChanged();
+    void refreshHotComponents();
     static std::string makeUniqueName(const std::string& desired, const Entity* self, Scene* scene);
     static std::unordered_map<std::string, Entity*>& getNameRegistry(Scene* scene);
     static std::unordered_multimap<std::string, Entity*>& getTagRegistry(Scene* scene);
@@ -106,16 +132,26 @@ private:
     
 private:
     UUID m_UUID;
+    uint32_t m_Index = kNoIndex;
     std::string m_Name;
     std::string m_Tag;
     int m_Layer;
     bool m_IsActive;
+    bool m_PublishedActive = true;
     bool m_Destroyed;
     bool m_HasCreated;
     bool m_EditorOnly;
+    // Runtime spawns keep their name as given instead of getting a unique one.
+    bool m_KeepName = false;
+    // Root of a prefab instance, and whether it is parked in the scene's pool.
+    const class EntityPrefab* m_Prefab = nullptr;
+    bool m_Pooled = false;
     
     Scene* m_Scene;
     Transform* m_Transform; // Cached for fast access
+    MeshRenderer* m_MeshRenderer = nullptr;
+    Light* m_Light = nullptr;
+    Rigidbody* m_Rigidbody = nullptr;
     
     std::vector<std::unique_ptr<Component>> m_Components;
     std::unordered_map<std::type_index, Component*> m_ComponentMap;
@@ -137,6 +173,7 @@ T* Entity::addComponent(Args&&... args) {
     }
     
     // Create new component
+    RenderSnapshot::syncStructuralChange();
     auto component = std::make_unique<T>(std::forward<Args>(args)...);
     T* componentPtr = component.get();
     
@@ -147,6 +184,7 @@ T* Entity::addComponent(Args&&... args) {
     
     // Add to vector
     m_Components.push_back(std::move(component));
+    onComponentSetChanged();
     
     // Call lifecycle
     if (m_HasCreated) {
@@ -162,13 +200,23 @@ T* Entity::addComponent(Args&&... args) {
 template<typename T>
 T* Entity::getComponent() const {
     static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
-    
-    std::type_index typeIndex = T::StaticTypeIndex();
-    auto it = m_ComponentMap.find(typeIndex);
-    if (it != m_ComponentMap.end()) {
-        return static_cast<T*>(it->second);
+
+    if constexpr (std::is_same_v<T, Transform>) {
+        return m_Transform;
+    } else if constexpr (std::is_same_v<T, MeshRenderer>) {
+        return m_MeshRenderer;
+    } else if constexpr (std::is_same_v<T, Light>) {
+        return m_Light;
+    } else if constexpr (std::is_same_v<T, Rigidbody>) {
+        return m_Rigidbody;
+    } else {
+        std::type_index typeIndex = T::StaticTypeIndex();
+        auto it = m_ComponentMap.find(typeIndex);
+        if (it != m_ComponentMap.end()) {
+            return static_cast<T*>(it->second);
+        }
+        return nullptr;
     }
-    return nullptr;
 }
 
 template<typename T>
@@ -183,31 +231,9 @@ template<typename T>
 void Entity::removeComponent() {
     static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
     
-    std::type_index typeIndex = T::StaticTypeIndex();
-    auto mapIt = m_ComponentMap.find(typeIndex);
-    if (mapIt == m_ComponentMap.end()) {
-        return;
-    }
-    
-    Component* component = mapIt->second;
-    
-    // Call lifecycle
-    if (component->isEnabled()) {
-        component->OnDisable();
-    }
-    component->OnDestroy();
-    
-    // Remove from map
-    m_ComponentMap.erase(mapIt);
-    
-    // Remove from vector
-    auto it = std::find_if(m_Components.begin(), m_Components.end(),
-        [component](const std::unique_ptr<Component>& c) {
-            return c.get() == component;
-        });
-    
-    if (it != m_Components.end()) {
-        m_Components.erase(it);
+    auto mapIt = m_ComponentMap.find(T::StaticTypeIndex());
+    if (mapIt != m_ComponentMap.end()) {
+        removeComponent(mapIt->second);
     }
 }
 
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Crescent {
+
+// A set of entities of one scene, one bit per dense entity index (Entity::getIndex). Words is the
+// backing container, a FrameVector<uint64_t> for sets that live for one frame.
+template <typename Words = std::vector<uint64_t>>
+class EntityBitset {
+public:
+    EntityBitset() = default;
+    explicit EntityBitset(Words words) : m_Words(std::move(words)) {}
+
+    // Empties the set and sizes it for indices below indexCount (Scene::getEntityIndexCount).
+    void reset(uint32_t indexCount) {
+        m_Words.assign((static_cast<size_t>(indexCount) + 63) / 64, 0);
+        m_Any = false;
+    }
+
+    // Indices past the size given to reset are ignored.
+    void set(uint32_t index) {
+        const size_t word = index >> 6;
+        if (word < m_Words.size()) {
+            m_Words[word] |= uint64_t(1) << (index & 63);
+            m_Any = true;
+        }
+    }
+    bool test(uint32_t index) const {
+        const size_t word = index >> 6;
+        return word < m_Words.size() && ((m_Words[word] >> (index & 63)) & 1u) != 0;
+    }
+    bool any() const { return m_Any; }
+
+private:
+    Words m_Words;
+    bool m_Any = false;
+};
+
+} // namespace Crescent
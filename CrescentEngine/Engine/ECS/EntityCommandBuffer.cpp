@@ -0,0 +1,107 @@
+#include "EntityCommandBuffer.hpp"
+#include "Entity.hpp"
+#include "Transform.hpp"
+#include "../Scene/Scene.hpp"
+#include <typeindex>
+
+namespace Crescent {
+
+UUID EntityCommandBuffer::createEntity(const std::string& name, UUID parent) {
+    EntityCommand command;
+    command.type = EntityCommandType::CreateEntity;
+    command.entity = UUID();
+    command.parent = parent;
+    command.name = name;
+    const UUID uuid = command.entity;
+    record(std::move(command));
+    return uuid;
+}
+
+void EntityCommandBuffer::destroyEntity(UUID entity) {
+    EntityCommand command;
+    command.type = EntityCommandType::DestroyEntity;
+    command.entity = entity;
+    record(std::move(command));
+}
+
+void EntityCommandBuffer::setParent(UUID entity, UUID parent, bool worldPositionStays) {
+    EntityCommand command;
+    command.type = EntityCommandType::SetParent;
+    command.entity = entity;
+    command.parent = parent;
+    command.worldPositionStays = worldPositionStays;
+    record(std::move(command));
+}
+
+bool EntityCommandBuffer::empty() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Commands.empty();
+}
+
+void EntityCommandBuffer::record(EntityCommand command) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Commands.push_back(std::move(command));
+}
+
+void EntityCommandBuffer::clear() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Commands.clear();
+}
+
+void EntityCommandBuffer::playback(Scene& scene) {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Commands.empty()) {
+            return;
+        }
+        m_Playing.swap(m_Commands);
+    }
+    for (EntityCommand& command : m_Playing) {
+        Entity* entity = command.type == EntityCommandType::CreateEntity ? nullptr : scene.findEntity(command.entity);
+        switch (command.type) {
+            case EntityCommandType::CreateEntity: {
+                entity = scene.createEntityWithUUID(command.entity, command.name);
+                Entity* parent = command.parent.isValid() ? scene.findEntity(command.parent) : nullptr;
+                if (parent && entity->getTransform()) {
+                    entity->getTransform()->setParent(parent->getTransform(), false);
+                }
+                break;
+            }
+            case EntityCommandType::DestroyEntity:
+                if (entity) {
+                    scene.destroyEntity(entity);
+                }
+                break;
+            case EntityCommandType::AddComponent:
+                if (entity) {
+                    entity->adoptComponent(std::move(command.component));
+                }
+                break;
+            case EntityCommandType::RemoveComponent: {
+                if (!entity) {
+                    break;
+                }
+                const std::type_index type(*command.componentType);
+                for (const auto& component : entity->getAllComponents()) {
+                    if (component->getTypeIndex() == type) {
+                        entity->removeComponent(component.get());
+                        break;
+                    }
+                }
+                break;
+            }
+            case EntityCommandType::SetParent: {
+                if (!entity || !entity->getTransform()) {
+                    break;
+                }
+                Entity* parent = command.parent.isValid() ? scene.findEntity(command.parent) : nullptr;
+                entity->getTransform()->setParent(parent ? parent->getTransform() : nullptr,
+                                                  command.worldPositionStays);
+                break;
+            }
+        }
+    }
+    m_Playing.clear();
+}
+
+} // namespace Crescent
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Component.hpp"
+#include "../Core/UUID.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace Crescent {
+
+class Scene;
+
+enum class EntityCommandType : uint8_t {
+    CreateEntity,
+    DestroyEntity,
+    AddComponent,
+    RemoveComponent,
+    SetParent
+};
+
+// One recorded structural change. Entities are addressed by UUID so a command can name an entity
+// created earlier in the same buffer.
+struct EntityCommand {
+    EntityCommandType type = EntityCommandType::CreateEntity;
+    UUID entity = UUID::Invalid();
+    // Parent for CreateEntity and SetParent; invalid means the scene root.
+    UUID parent = UUID::Invalid();
+    std::string name;
+    std::unique_ptr<Component> component;
+    const std::type_info* componentType = nullptr;
+    bool worldPositionStays = true;
+};
+
+// Structural changes recorded during the parallel phases and applied at the frame's sync points
+// (see SceneManager::playbackStructuralChanges). Recording is safe from any worker; the scene's
+// entity and component lists only change on playback, so parallel components can spawn, destroy,
+// attach and reparent without touching them directly. Components passed to addComponent are
+// constructed on the recording thread and must not reach shared state in their constructor.
+class EntityCommandBuffer {
+public:
+    // Returns the UUID the entity will get, usable by later commands right away.
+    UUID createEntity(const std::string& name = "Entity", UUID parent = UUID::Invalid());
+    void destroyEntity(UUID entity);
+
+    template <typename T, typename... Args>
+    void addComponent(UUID entity, Args&&... args) {
+        static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
+        EntityCommand command;
+        command.type = EntityCommandType::AddComponent;
+        command.entity = entity;
+        command.component = std::make_unique<T>(std::forward<Args>(args)...);
+        record(std::move(command));
+    }
+
+    template <typename T>
+    void removeComponent(UUID entity) {
+        static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
+        EntityCommand command;
+        command.type = EntityCommandType::RemoveComponent;
+        command.entity = entity;
+        command.componentType = &typeid(T);
+        record(std::move(command));
+    }
+
+    void setParent(UUID entity, UUID parent, bool worldPositionStays = true);
+
+    bool empty() const;
+
+    // Main thread, outside any scene iteration. Applies the commands in the order they were
+    // recorded; commands whose entity no longer exists are dropped. Commands recorded while
+    // playing back wait for the next playback.
+    void playback(Scene& scene);
+    void clear();
+
+private:
+    void record(EntityCommand command);
+
+    mutable std::mutex m_Mutex;
+    std::vector<EntityCommand> m_Commands;
+    std::vector<EntityCommand> m_Playing;
+};
+
+} // namespace Crescent
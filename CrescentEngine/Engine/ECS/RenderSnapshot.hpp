@@ -0,0 +1,69 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+
+namespace Crescent {
+
+// Frame-boundary copy of the simulation state the renderer reads. Components that update
+// writes every frame (Transform, SkinnedMeshRenderer, Light) keep a published copy next to
+// their live state; publishRenderState() refreshes it between frames. Code running inside a
+// ReadScope (the pipelined render job) sees the published copy and everything else sees live
+// state, so frame N can be encoded while update already writes frame N+1.
+//
+// Structural changes (creating/destroying entities, adding/removing components) cannot be
+// double-buffered; they call syncStructuralChange(), which waits for the in-flight frame.
+class RenderSnapshot {
+public:
+    class ReadScope {
+    public:
+        explicit ReadScope(bool enabled = true) : m_previous(t_reading) { t_reading = m_previous || enabled; }
+        ~ReadScope() { t_reading = m_previous; }
+        ReadScope(const ReadScope&) = delete;
+        ReadScope& operator=(const ReadScope&) = delete;
+
+    private:
+        bool m_previous;
+    };
+
+    // Runs a job with live-state reads regardless of the thread's current scope. The scheduler
+    // wraps every job in one, so a thread that helps while waiting inside a ReadScope does not
+    // hand its read state (or its skipped structural barrier) to unrelated jobs.
+    class ForeignJobScope {
+    public:
+        ForeignJobScope() : m_previous(t_reading) { t_reading = false; }
+        ~ForeignJobScope() { t_reading = m_previous; }
+        ForeignJobScope(const ForeignJobScope&) = delete;
+        ForeignJobScope& operator=(const ForeignJobScope&) = delete;
+
+    private:
+        bool m_previous;
+    };
+
+    static bool isReading() { return t_reading; }
+
+    // Installed by the engine while pipelined rendering is enabled; empty otherwise.
+    static void setStructuralBarrier(std::function<void()> barrier) {
+        structuralBarrier() = std::move(barrier);
+    }
+
+    static void syncStructuralChange() {
+        if (t_reading) {
+            return;
+        }
+        const auto& barrier = structuralBarrier();
+        if (barrier) {
+            barrier();
+        }
+    }
+
+private:
+    static std::function<void()>& structuralBarrier() {
+        static std::function<void()> barrier;
+        return barrier;
+    }
+
+    static inline thread_local bool t_reading = false;
+};
+
+} // namespace Crescent
@@ -1,5 +1,7 @@
 #include "Transform.hpp"
 #include "Entity.hpp"
+#include "TransformHierarchy.hpp"
+#include "../Scene/Scene.hpp"
 #include <algorithm>
 #include <cmath>
 
@@ -62,22 +64,35 @@ void Transform::setRotation(const Math::Quaternion& rotation) {
     markDirty();
 }
 
+void Transform::setPositionAndRotation(const Math::Vector3& position, const Math::Quaternion& rotation) {
+    if (m_Parent) {
+        Math::Matrix4x4 parentWorldInv = m_Parent->getWorldMatrix().inversed();
+        m_LocalPosition = parentWorldInv.transformPoint(position);
+        m_LocalRotation = m_Parent->getRotation().inverse() * rotation;
+    } else {
+        m_LocalPosition = position;
+        m_LocalRotation = rotation;
+    }
+    m_LocalEulerAngles = m_LocalRotation.toEulerAngles();
+    markDirty();
+}
+
 void Transform::setEulerAngles(const Math::Vector3& euler) {
     setRotation(Math::Quaternion::FromEulerAngles(euler));
 }
 
 Math::Vector3 Transform::getPosition() const {
     if (m_Parent) {
-        return m_Parent->getWorldMatrix().transformPoint(m_LocalPosition);
+        return m_Parent->getWorldMatrix().transformPoint(getLocalPosition());
     }
-    return m_LocalPosition;
+    return getLocalPosition();
 }
 
 Math::Quaternion Transform::getRotation() const {
     if (m_Parent) {
-        return m_Parent->getRotation() * m_LocalRotation;
+        return m_Parent->getRotation() * getLocalRotation();
     }
-    return m_LocalRotation;
+    return getLocalRotation();
 }
 
 Math::Vector3 Transform::getEulerAngles() const {
@@ -85,22 +100,26 @@ Math::Vector3 Transform::getEulerAngles() const {
 }
 
 Math::Vector3 Transform::getScale() const {
+    const Math::Vector3& localScale = getLocalScale();
     if (m_Parent) {
         Math::Vector3 parentScale = m_Parent->getScale();
         return Math::Vector3(
-            m_LocalScale.x * parentScale.x,
-            m_LocalScale.y * parentScale.y,
-            m_LocalScale.z * parentScale.z
+            localScale.x * parentScale.x,
+            localScale.y * parentScale.y,
+            localScale.z * parentScale.z
         );
     }
-    return m_LocalScale;
+    return localScale;
 }
 
 Math::Matrix4x4 Transform::getLocalMatrix() const {
-    return Math::Matrix4x4::TRS(m_LocalPosition, m_LocalRotation, m_LocalScale);
+    return Math::Matrix4x4::TRS(getLocalPosition(), getLocalRotation(), getLocalScale());
 }
 
 Math::Matrix4x4 Transform::getWorldMatrix() const {
+    if (RenderSnapshot::isReading()) {
+        return m_RenderState.worldMatrix;
+    }
     if (m_IsDirty) {
         updateWorldMatrix();
     }
@@ -108,6 +127,9 @@ Math::Matrix4x4 Transform::getWorldMatrix() const {
 }
 
 Math::Matrix4x4 Transform::getPreviousWorldMatrix() const {
+    if (RenderSnapshot::isReading()) {
+        return m_RenderState.prevWorldMatrix;
+    }
     if (!m_HasPrevWorldMatrix) {
         return getWorldMatrix();
     }
@@ -119,6 +141,14 @@ void Transform::capturePreviousWorldMatrix() {
     m_HasPrevWorldMatrix = true;
 }
 
+void Transform::publishRenderState() {
+    m_RenderState.localPosition = m_LocalPosition;
+    m_RenderState.localRotation = m_LocalRotation;
+    m_RenderState.localScale = m_LocalScale;
+    m_RenderState.worldMatrix = getWorldMatrix();
+    m_RenderState.prevWorldMatrix = m_HasPrevWorldMatrix ? m_PrevWorldMatrix : m_RenderState.worldMatrix;
+}
+
 void Transform::updateWorldMatrix() const {
     if (m_Parent) {
         m_WorldMatrix = m_Parent->getWorldMatrix() * getLocalMatrix();
@@ -191,6 +221,8 @@ void Transform::lookAt(const Math::Vector3& target, const Math::Vector3& up) {
 
 void Transform::setParent(Transform* parent, bool worldPositionStays) {
     if (m_Parent == parent) return;
+    // The render job walks the hierarchy through m_Parent and m_Children.
+    RenderSnapshot::syncStructuralChange();
     
     // Store world transform if needed
     Math::Vector3 worldPos;
@@ -242,6 +274,13 @@ void Transform::setParent(Transform* parent, bool worldPositionStays) {
         }
     }
     
+    if (m_Hierarchy) {
+        m_Hierarchy->markStructureDirty();
+    }
+    Entity* entity = getEntity();
+    if (entity && entity->getScene()) {
+        entity->getScene()->getChangeLog().record(SceneChangeLog::Kind::Reparented, entity->getUUID());
+    }
     markDirty();
 }
 
@@ -275,7 +314,15 @@ Transform* Transform::find(const std::string& name) const {
 }
 
 void Transform::markDirty() {
+    // World matrices are only cleaned parent-first, so every descendant of a dirty transform is
+    // already dirty and the subtree walk can stop here.
+    if (m_IsDirty) {
+        return;
+    }
     m_IsDirty = true;
+    if (m_Hierarchy) {
+        m_Hierarchy->noteDirty(m_HierarchyIndex);
+    }
     markChildrenDirty();
 }
 
@@ -304,6 +351,18 @@ void Transform::OnCreate() {
 }
 
 void Transform::OnDestroy() {
+    if (m_Entity && m_Entity->getScene() && m_Entity->getScene()->isTearingDown()) {
+        // Parent and children go with this transform; links are dropped, not unpicked.
+        m_Hierarchy = nullptr;
+        m_Parent = nullptr;
+        m_Children.clear();
+        return;
+    }
+    if (m_Hierarchy) {
+        m_Hierarchy->markStructureDirty();
+        m_Hierarchy = nullptr;
+    }
+
     // Remove from parent
     if (m_Parent) {
         m_Parent->removeChild(this);
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "Component.hpp"
+#include "RenderSnapshot.hpp"
 #include "../Math/Math.hpp"
+#include <cstdint>
 #include <vector>
 
 namespace Crescent {
 
+class TransformHierarchy;
+
 // Transform component - handles position, rotation, scale, and parent-child hierarchy
 class Transform : public Component {
 public:
@@ -13,6 +17,7 @@ public:
     virtual ~Transform() = default;
     
     COMPONENT_TYPE(Transform)
+    COMPONENT_POOLED(Transform)
     
     // Local transform (relative to parent)
     void setLocalPosition(const Math::Vector3& position);
@@ -20,15 +25,23 @@ public:
     void setLocalEulerAngles(const Math::Vector3& euler);
     void setLocalScale(const Math::Vector3& scale);
     
-    const Math::Vector3& getLocalPosition() const { return m_LocalPosition; }
-    const Math::Quaternion& getLocalRotation() const { return m_LocalRotation; }
+    const Math::Vector3& getLocalPosition() const {
+        return RenderSnapshot::isReading() ? m_RenderState.localPosition : m_LocalPosition;
+    }
+    const Math::Quaternion& getLocalRotation() const {
+        return RenderSnapshot::isReading() ? m_RenderState.localRotation : m_LocalRotation;
+    }
     Math::Vector3 getLocalEulerAngles() const { return m_LocalEulerAngles; }
-    const Math::Vector3& getLocalScale() const { return m_LocalScale; }
+    const Math::Vector3& getLocalScale() const {
+        return RenderSnapshot::isReading() ? m_RenderState.localScale : m_LocalScale;
+    }
     
     // World transform (absolute)
     void setPosition(const Math::Vector3& position);
     void setRotation(const Math::Quaternion& rotation);
     void setEulerAngles(const Math::Vector3& euler);
+    // Both at once: the parent is inverted once and the subtree is dirtied once.
+    void setPositionAndRotation(const Math::Vector3& position, const Math::Quaternion& rotation);
     
     Math::Vector3 getPosition() const;
     Math::Quaternion getRotation() const;
@@ -41,6 +54,9 @@ public:
     Math::Matrix4x4 getPreviousWorldMatrix() const;
     void capturePreviousWorldMatrix();
     bool hasPreviousWorldMatrix() const { return m_HasPrevWorldMatrix; }
+
+    // Copies the live transform into the render snapshot (see RenderSnapshot).
+    void publishRenderState();
     
     // Transform directions
     Math::Vector3 forward() const;
@@ -76,6 +92,8 @@ public:
     void OnDestroy() override;
     
 private:
+    friend class TransformHierarchy;
+
     void updateWorldMatrix() const;
     void addChild(Transform* child);
     void removeChild(Transform* child);
@@ -93,10 +111,24 @@ private:
     mutable bool m_IsDirty;
     Math::Matrix4x4 m_PrevWorldMatrix;
     bool m_HasPrevWorldMatrix;
+
+    // Published copy read by the pipelined render job
+    struct RenderState {
+        Math::Vector3 localPosition = Math::Vector3::Zero;
+        Math::Quaternion localRotation = Math::Quaternion::Identity;
+        Math::Vector3 localScale = Math::Vector3::One;
+        Math::Matrix4x4 worldMatrix = Math::Matrix4x4::Identity;
+        Math::Matrix4x4 prevWorldMatrix = Math::Matrix4x4::Identity;
+    };
+    RenderState m_RenderState;
     
     // Hierarchy
     Transform* m_Parent;
     std::vector<Transform*> m_Children;
+
+    // Slot in the owning scene's propagation pass (see TransformHierarchy)
+    TransformHierarchy* m_Hierarchy = nullptr;
+    uint32_t m_HierarchyIndex = UINT32_MAX;
 };
 
 } // namespace Crescent
@@ -0,0 +1,85 @@
+#include "TransformHierarchy.hpp"
+#include "Entity.hpp"
+#include "Transform.hpp"
+#include <algorithm>
+
+namespace Crescent {
+
+void TransformHierarchy::noteDirty(uint32_t index) {
+    if (index >= m_Nodes.size()) {
+        return;
+    }
+    uint32_t begin = m_DirtyBegin.load(std::memory_order_relaxed);
+    while (index < begin && !m_DirtyBegin.compare_exchange_weak(begin, index, std::memory_order_relaxed)) {
+    }
+    uint32_t end = m_DirtyEnd.load(std::memory_order_relaxed);
+    while (index + 1 > end && !m_DirtyEnd.compare_exchange_weak(end, index + 1, std::memory_order_relaxed)) {
+    }
+    m_Moved[index >> 6].fetch_or(uint64_t(1) << (index & 63), std::memory_order_relaxed);
+}
+
+void TransformHierarchy::rebuild(const std::vector<std::unique_ptr<Entity>>& entities) {
+    m_Nodes.clear();
+    m_Parents.clear();
+    m_Nodes.reserve(entities.size());
+    m_Parents.reserve(entities.size());
+
+    // Roots in scene order, then breadth-first, so every parent lands before its children.
+    for (const auto& entity : entities) {
+        Transform* transform = entity ? entity->getTransform() : nullptr;
+        if (transform && !transform->getParent()) {
+            transform->m_Hierarchy = this;
+            transform->m_HierarchyIndex = static_cast<uint32_t>(m_Nodes.size());
+            m_Nodes.push_back(transform);
+            m_Parents.push_back(kInvalidIndex);
+        }
+    }
+    for (size_t i = 0; i < m_Nodes.size(); ++i) {
+        for (Transform* child : m_Nodes[i]->getChildren()) {
+            if (!child || child->m_Hierarchy == this) {
+                continue;
+            }
+            child->m_Hierarchy = this;
+            child->m_HierarchyIndex = static_cast<uint32_t>(m_Nodes.size());
+            m_Nodes.push_back(child);
+            m_Parents.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    // Every slot may now hold a different transform, so all of them count as moved.
+    const size_t wordCount = (m_Nodes.size() + 63) / 64;
+    m_Moved.reset(new std::atomic<uint64_t>[wordCount]);
+    for (size_t word = 0; word < wordCount; ++word) {
+        m_Moved[word].store(~uint64_t(0), std::memory_order_relaxed);
+    }
+}
+
+void TransformHierarchy::update(const std::vector<std::unique_ptr<Entity>>& entities) {
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    if (m_StructureDirty.exchange(false, std::memory_order_relaxed)) {
+        rebuild(entities);
+        end = static_cast<uint32_t>(m_Nodes.size());
+    } else {
+        begin = m_DirtyBegin.load(std::memory_order_relaxed);
+        end = std::min<uint32_t>(m_DirtyEnd.load(std::memory_order_relaxed), static_cast<uint32_t>(m_Nodes.size()));
+    }
+    m_DirtyBegin.store(UINT32_MAX, std::memory_order_relaxed);
+    m_DirtyEnd.store(0, std::memory_order_relaxed);
+
+    for (uint32_t i = begin; i < end; ++i) {
+        Transform* transform = m_Nodes[i];
+        if (!transform->m_IsDirty) {
+            continue;
+        }
+        // A dirty parent sits earlier in the array and has already been resolved this sweep.
+        const uint32_t parent = m_Parents[i];
+        Math::Matrix4x4 local = Math::Matrix4x4::TRS(transform->m_LocalPosition,
+                                                     transform->m_LocalRotation,
+                                                     transform->m_LocalScale);
+        transform->m_WorldMatrix = parent == kInvalidIndex ? local : m_Nodes[parent]->m_WorldMatrix * local;
+        transform->m_IsDirty = false;
+    }
+}
+
+} // namespace Crescent
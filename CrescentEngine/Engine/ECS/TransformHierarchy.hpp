@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Crescent {
+
+class Entity;
+class Transform;
+
+// Once-per-frame world-matrix propagation for one scene. Transforms are kept in a depth-sorted
+// array (every parent before its children) with parent indices, so update() recomputes dirty
+// world matrices in a single forward sweep instead of each getWorldMatrix() recursing up its
+// parent chain. Setters report their slot here, and only the [first, last] dirty range is
+// swept. After update() every world matrix in the scene is clean and getWorldMatrix() is a
+// plain load; the lazy path in Transform stays as the fallback for queries between passes.
+class TransformHierarchy {
+public:
+    static constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+    TransformHierarchy() = default;
+    TransformHierarchy(const TransformHierarchy&) = delete;
+    TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+    // Parenting changed or entities were added/removed; the order is rebuilt on the next update.
+    void markStructureDirty() { m_StructureDirty.store(true, std::memory_order_relaxed); }
+
+    // Called when the transform in slot index goes from clean to dirty. Safe from job workers.
+    void noteDirty(uint32_t index);
+
+    void update(const std::vector<std::unique_ptr<Entity>>& entities);
+
+    size_t size() const { return m_Nodes.size(); }
+
+    // Calls fn for every transform that went dirty since the last call (all of them after a
+    // rebuild) and clears the record. Run after update() so world matrices are resolved.
+    template <typename Fn>
+    void consumeMoved(Fn&& fn) {
+        const size_t wordCount = (m_Nodes.size() + 63) / 64;
+        for (size_t word = 0; word < wordCount; ++word) {
+            uint64_t bits = m_Moved[word].exchange(0, std::memory_order_relaxed);
+            while (bits != 0) {
+                const size_t index = word * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+                bits &= bits - 1;
+                if (index < m_Nodes.size()) {
+                    fn(m_Nodes[index]);
+                }
+            }
+        }
+    }
+
+private:
+    void rebuild(const std::vector<std::unique_ptr<Entity>>& entities);
+
+    std::vector<Transform*> m_Nodes;
+    std::vector<uint32_t> m_Parents;
+    // One bit per slot, set by noteDirty from any thread.
+    std::unique_ptr<std::atomic<uint64_t>[]> m_Moved;
+    std::atomic<uint32_t> m_DirtyBegin{UINT32_MAX};
+    std::atomic<uint32_t> m_DirtyEnd{0};
+    std::atomic<bool> m_StructureDirty{true};
+};
+
+} // namespace Crescent
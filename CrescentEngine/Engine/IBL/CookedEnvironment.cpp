@@ -0,0 +1,226 @@
+#include "CookedEnvironment.hpp"
+#include "../Renderer/ProbeVolumeData.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <Metal/Metal.hpp>
+
+namespace Crescent {
+
+namespace {
+// Version 3 stores every level as RGB9E5, half the size of version 2's RGBA16F, which still loads.
+constexpr uint32_t kCookedEnvironmentVersion = 3;
+constexpr uint32_t kCookedEnvironmentRGBA16FVersion = 2;
+constexpr size_t kRGBA16FPixelBytes = sizeof(uint16_t) * 4;
+constexpr size_t kRGB9E5PixelBytes = sizeof(uint32_t);
+
+struct CookedEnvironmentHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t cubemapSize;
+    uint32_t cubemapMipLevels;
+    uint32_t prefilteredSize;
+    uint32_t prefilteredMipLevels;
+    uint32_t irradianceSize;
+    uint32_t irradianceMipLevels;
+};
+
+bool WriteExact(std::ostream& stream, const void* src, size_t size) {
+    stream.write(static_cast<const char*>(src), static_cast<std::streamsize>(size));
+    return stream.good();
+}
+
+float HalfBitsToFloat(uint16_t bits) {
+    __fp16 value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return static_cast<float>(value);
+}
+
+// Writes every mip and face of an RGBA16F cube as RGB9E5.
+bool WriteCubeTexture(std::ostream& stream, MTL::Texture* texture) {
+    if (!texture) {
+        return false;
+    }
+
+    const uint32_t mipLevels = static_cast<uint32_t>(texture->mipmapLevelCount());
+    for (uint32_t mip = 0; mip < mipLevels; ++mip) {
+        const uint32_t mipSize = std::max(1u, static_cast<uint32_t>(texture->width()) >> mip);
+        const size_t pixelCount = static_cast<size_t>(mipSize) * mipSize;
+        const size_t bytesPerRow = static_cast<size_t>(mipSize) * kRGBA16FPixelBytes;
+        const size_t bytesPerImage = bytesPerRow * mipSize;
+        std::vector<uint16_t> faceData(pixelCount * 4);
+        std::vector<uint32_t> packed(pixelCount);
+        MTL::Region region = MTL::Region::Make2D(0, 0, mipSize, mipSize);
+
+        for (uint32_t face = 0; face < 6; ++face) {
+            texture->getBytes(faceData.data(),
+                              static_cast<NS::UInteger>(bytesPerRow),
+                              static_cast<NS::UInteger>(bytesPerImage),
+                              region,
+                              static_cast<NS::UInteger>(mip),
+                              static_cast<NS::UInteger>(face));
+            for (size_t i = 0; i < pixelCount; ++i) {
+                packed[i] = PackRGB9E5(HalfBitsToFloat(faceData[i * 4 + 0]),
+                                       HalfBitsToFloat(faceData[i * 4 + 1]),
+                                       HalfBitsToFloat(faceData[i * 4 + 2]));
+            }
+            if (!WriteExact(stream, packed.data(), packed.size() * sizeof(uint32_t))) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Creates a cube and fills it straight from the mapped blob, advancing offset past its levels.
+MTL::Texture* CreateCubeTexture(MTL::Device* device,
+                                const uint8_t* data,
+                                size_t dataSize,
+                                size_t& offset,
+                                uint32_t size,
+                                uint32_t mipLevels,
+                                MTL::PixelFormat pixelFormat,
+                                size_t pixelBytes) {
+    if (!device || size == 0 || mipLevels == 0 || mipLevels > 16) {
+        return nullptr;
+    }
+
+    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+    desc->setTextureType(MTL::TextureTypeCube);
+    desc->setPixelFormat(pixelFormat);
+    desc->setWidth(size);
+    desc->setHeight(size);
+    desc->setMipmapLevelCount(mipLevels);
+    desc->setUsage(MTL::TextureUsageShaderRead);
+    desc->setStorageMode(MTL::StorageModeShared);
+    MTL::Texture* texture = device->newTexture(desc);
+    desc->release();
+    if (!texture) {
+        return nullptr;
+    }
+
+    for (uint32_t mip = 0; mip < mipLevels; ++mip) {
+        const uint32_t mipSize = std::max(1u, size >> mip);
+        const size_t bytesPerRow = static_cast<size_t>(mipSize) * pixelBytes;
+        const size_t bytesPerImage = bytesPerRow * mipSize;
+        MTL::Region region = MTL::Region::Make2D(0, 0, mipSize, mipSize);
+
+        for (uint32_t face = 0; face < 6; ++face) {
+            if (bytesPerImage > dataSize - offset) {
+                texture->release();
+                return nullptr;
+            }
+            texture->replaceRegion(region,
+                                   static_cast<NS::UInteger>(mip),
+                                   static_cast<NS::UInteger>(face),
+                                   data + offset,
+                                   static_cast<NS::UInteger>(bytesPerRow),
+                                   static_cast<NS::UInteger>(bytesPerImage));
+            offset += bytesPerImage;
+        }
+    }
+
+    return texture;
+}
+} // namespace
+
+bool WriteCookedEnvironmentBlob(const std::string& outputPath,
+                                MTL::Texture* cubemap,
+                                MTL::Texture* prefiltered,
+                                MTL::Texture* irradiance) {
+    if (!cubemap || !prefiltered || !irradiance) {
+        return false;
+    }
+
+    std::filesystem::path output(outputPath);
+    std::error_code ec;
+    std::filesystem::create_directories(output.parent_path(), ec);
+
+    std::ofstream stream(output, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+        return false;
+    }
+
+    CookedEnvironmentHeader header{
+        {'C', 'E', 'N', 'V'},
+        kCookedEnvironmentVersion,
+        static_cast<uint32_t>(cubemap->width()),
+        static_cast<uint32_t>(cubemap->mipmapLevelCount()),
+        static_cast<uint32_t>(prefiltered->width()),
+        static_cast<uint32_t>(prefiltered->mipmapLevelCount()),
+        static_cast<uint32_t>(irradiance->width()),
+        static_cast<uint32_t>(irradiance->mipmapLevelCount())
+    };
+
+    return WriteExact(stream, &header, sizeof(header)) &&
+           WriteCubeTexture(stream, cubemap) &&
+           WriteCubeTexture(stream, prefiltered) &&
+           WriteCubeTexture(stream, irradiance) &&
+           stream.good();
+}
+
+bool LoadCookedEnvironmentBlob(const std::string& cookedPath,
+                               MTL::Device* device,
+                               MTL::Texture*& outCubemap,
+                               MTL::Texture*& outPrefiltered,
+                               MTL::Texture*& outIrradiance) {
+    int fd = open(cookedPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(CookedEnvironmentHeader))) {
+        close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(mapped);
+
+    CookedEnvironmentHeader header{};
+    std::memcpy(&header, data, sizeof(header));
+    const bool current = header.version == kCookedEnvironmentVersion;
+    if (std::memcmp(header.magic, "CENV", 4) != 0 ||
+        (!current && header.version != kCookedEnvironmentRGBA16FVersion)) {
+        munmap(mapped, size);
+        return false;
+    }
+    const MTL::PixelFormat pixelFormat = current ? MTL::PixelFormatRGB9E5Float : MTL::PixelFormatRGBA16Float;
+    const size_t pixelBytes = current ? kRGB9E5PixelBytes : kRGBA16FPixelBytes;
+
+    size_t offset = sizeof(header);
+    MTL::Texture* cubemap = CreateCubeTexture(device, data, size, offset, header.cubemapSize,
+                                              header.cubemapMipLevels, pixelFormat, pixelBytes);
+    MTL::Texture* prefiltered = cubemap ? CreateCubeTexture(device, data, size, offset, header.prefilteredSize,
+                                                            header.prefilteredMipLevels, pixelFormat, pixelBytes)
+                                        : nullptr;
+    MTL::Texture* irradiance = prefiltered ? CreateCubeTexture(device, data, size, offset, header.irradianceSize,
+                                                               header.irradianceMipLevels, pixelFormat, pixelBytes)
+                                           : nullptr;
+    munmap(mapped, size);
+    if (!cubemap || !prefiltered || !irradiance) {
+        if (cubemap) cubemap->release();
+        if (prefiltered) prefiltered->release();
+        if (irradiance) irradiance->release();
+        return false;
+    }
+
+    outCubemap = cubemap;
+    outPrefiltered = prefiltered;
+    outIrradiance = irradiance;
+    return true;
+}
+
+} // namespace Crescent
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+namespace MTL {
+    class Device;
+    class Texture;
+}
+
+namespace Crescent {
+
+// Cooked environment blob (.cenv): "CENV", a version, the three cubes' sizes and mip counts, then
+// every level and face of the cubemap, prefiltered and irradiance cubes in that order. Both calls
+// only touch the device and the file, so they are safe on any thread.
+bool WriteCookedEnvironmentBlob(const std::string& outputPath,
+                                MTL::Texture* cubemap,
+                                MTL::Texture* prefiltered,
+                                MTL::Texture* irradiance);
+// Maps the blob and fills new shared cubes from it; the caller owns the returned textures.
+bool LoadCookedEnvironmentBlob(const std::string& cookedPath,
+                               MTL::Device* device,
+                               MTL::Texture*& outCubemap,
+                               MTL::Texture*& outPrefiltered,
+                               MTL::Texture*& outIrradiance);
+
+} // namespace Crescent
@@ -1,6 +1,12 @@
 #include "IBLGenerator.hpp"
+#include "../Renderer/ShaderLibrary.hpp"
+#include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
 #include <Metal/Metal.hpp>
 
 namespace Crescent {
@@ -13,6 +19,17 @@ struct PrefilteredParams {
     uint32_t face;
 };
 
+namespace {
+    constexpr uint32_t kCookedBRDFLUTVersion = 1;
+    constexpr size_t kRG16FPixelBytes = sizeof(uint16_t) * 2;
+
+    struct CookedBRDFLUTHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t size;
+    };
+}
+
 IBLGenerator::IBLGenerator() = default;
 
 IBLGenerator::~IBLGenerator() {
@@ -32,12 +49,6 @@ bool IBLGenerator::initialize(MTL::Device* device, MTL::CommandQueue* queue) {
     
     std::cout << "Initializing IBL Generator..." << std::endl;
     
-    // Load compute shaders
-    if (!loadComputeShaders()) {
-        std::cerr << "IBLGenerator: Failed to load compute shaders!" << std::endl;
-        return false;
-    }
-    
     // Create linear sampler
     MTL::SamplerDescriptor* samplerDesc = MTL::SamplerDescriptor::alloc()->init();
     samplerDesc->setMinFilter(MTL::SamplerMinMagFilterLinear);
@@ -49,14 +60,6 @@ bool IBLGenerator::initialize(MTL::Device* device, MTL::CommandQueue* queue) {
     m_linearSampler = m_device->newSamplerState(samplerDesc);
     samplerDesc->release();
     
-    // Generate BRDF LUT at startup
-    std::cout << "Generating BRDF LUT..." << std::endl;
-    m_brdfLUT = generateBRDFLUT();
-    if (!m_brdfLUT) {
-        std::cerr << "IBLGenerator: Failed to generate BRDF LUT!" << std::endl;
-        return false;
-    }
-    
     m_initialized = true;
     std::cout << "IBL Generator initialized successfully!" << std::endl;
     return true;
@@ -99,13 +102,101 @@ void IBLGenerator::shutdown() {
     }
     
     m_initialized = false;
+    m_shadersRequested = false;
+}
+
+bool IBLGenerator::ensureComputeShaders() {
+    if (!m_shadersRequested) {
+        m_shadersRequested = true;
+        if (!loadComputeShaders()) {
+            std::cerr << "IBLGenerator: Failed to load compute shaders!" << std::endl;
+        }
+    }
+    return m_brdfLUTPipeline && m_equirectToCubePipeline && m_prefilteredPipeline && m_irradiancePipeline;
+}
+
+MTL::Texture* IBLGenerator::getBRDFLUT() {
+    if (!m_brdfLUT && m_initialized) {
+        std::cout << "Generating BRDF LUT..." << std::endl;
+        m_brdfLUT = generateBRDFLUT();
+        if (!m_brdfLUT) {
+            std::cerr << "IBLGenerator: Failed to generate BRDF LUT!" << std::endl;
+        }
+    }
+    return m_brdfLUT;
+}
+
+bool IBLGenerator::loadBRDFLUT(const std::string& path) {
+    if (!m_device || path.empty()) {
+        return false;
+    }
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open()) {
+        return false;
+    }
+    CookedBRDFLUTHeader header{};
+    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!stream.good() || std::memcmp(header.magic, "CBRD", 4) != 0 ||
+        header.version != kCookedBRDFLUTVersion || header.size == 0 || header.size > 4096) {
+        return false;
+    }
+    const size_t bytesPerRow = static_cast<size_t>(header.size) * kRG16FPixelBytes;
+    std::vector<uint8_t> texels(bytesPerRow * header.size);
+    stream.read(reinterpret_cast<char*>(texels.data()), static_cast<std::streamsize>(texels.size()));
+    if (!stream.good()) {
+        return false;
+    }
+
+    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+    desc->setTextureType(MTL::TextureType2D);
+    desc->setPixelFormat(MTL::PixelFormatRG16Float);
+    desc->setWidth(header.size);
+    desc->setHeight(header.size);
+    desc->setUsage(MTL::TextureUsageShaderRead);
+    desc->setStorageMode(MTL::StorageModeShared);
+    MTL::Texture* brdfLUT = m_device->newTexture(desc);
+    desc->release();
+    if (!brdfLUT) {
+        return false;
+    }
+    brdfLUT->replaceRegion(MTL::Region::Make2D(0, 0, header.size, header.size), 0, texels.data(),
+                           static_cast<NS::UInteger>(bytesPerRow));
+
+    if (m_brdfLUT) {
+        m_brdfLUT->release();
+    }
+    m_brdfLUT = brdfLUT;
+    return true;
+}
+
+bool IBLGenerator::saveBRDFLUT(const std::string& path) {
+    MTL::Texture* brdfLUT = getBRDFLUT();
+    if (!brdfLUT || path.empty()) {
+        return false;
+    }
+    const uint32_t size = static_cast<uint32_t>(brdfLUT->width());
+    const size_t bytesPerRow = static_cast<size_t>(size) * kRG16FPixelBytes;
+    std::vector<uint8_t> texels(bytesPerRow * size);
+    brdfLUT->getBytes(texels.data(), static_cast<NS::UInteger>(bytesPerRow),
+                      MTL::Region::Make2D(0, 0, size, size), 0);
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+        return false;
+    }
+    CookedBRDFLUTHeader header{{'C', 'B', 'R', 'D'}, kCookedBRDFLUTVersion, size};
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(texels.data()), static_cast<std::streamsize>(texels.size()));
+    return stream.good();
 }
 
 bool IBLGenerator::loadComputeShaders() {
     NS::Error* error = nullptr;
     
-    // Get default library (contains all .metal files)
-    m_library = m_device->newDefaultLibrary();
+    // Shared library for the IBL kernels (the default library unless Lighting.metallib ships)
+    m_library = ShaderLibrary::getInstance().acquire(m_device, ShaderLibrary::Module::Lighting);
     if (!m_library) {
         std::cerr << "IBLGenerator: Failed to load shader library!" << std::endl;
         return false;
@@ -171,6 +262,7 @@ bool IBLGenerator::loadComputeShaders() {
 }
 
 MTL::Texture* IBLGenerator::generateBRDFLUT() {
+    ensureComputeShaders();
     if (!m_brdfLUTPipeline) return nullptr;
     
     const uint32_t size = 512;
@@ -210,6 +302,7 @@ MTL::Texture* IBLGenerator::generateBRDFLUT() {
 }
 
 MTL::Texture* IBLGenerator::equirectToCubemap(MTL::Texture* equirect, uint32_t resolution) {
+    ensureComputeShaders();
     if (!m_equirectToCubePipeline || !equirect) return nullptr;
 
     const uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(resolution))) + 1;
@@ -264,6 +357,7 @@ MTL::Texture* IBLGenerator::equirectToCubemap(MTL::Texture* equirect, uint32_t r
 }
 
 MTL::Texture* IBLGenerator::generatePrefilteredEnvMap(MTL::Texture* cubemap, uint32_t resolution) {
+    ensureComputeShaders();
     if (!m_prefilteredPipeline || !cubemap) return nullptr;
     
     const uint32_t maxMipLevels = 6; // 6 roughness levels for better specular quality
@@ -332,7 +426,40 @@ MTL::Texture* IBLGenerator::generatePrefilteredEnvMap(MTL::Texture* cubemap, uin
     return prefiltered;
 }
 
+bool IBLGenerator::encodePrefilteredEnvMap(MTL::CommandBuffer* commandBuffer,
+                                           MTL::Texture* cubemap,
+                                           MTL::Texture* const* mipViews,
+                                           uint32_t mipCount,
+                                           uint32_t resolution,
+                                           uint32_t sampleCount) {
+    ensureComputeShaders();
+    if (!m_prefilteredPipeline || !commandBuffer || !cubemap || !mipViews || mipCount == 0) {
+        return false;
+    }
+
+    MTL::ComputeCommandEncoder* encoder = commandBuffer->computeCommandEncoder();
+    encoder->setComputePipelineState(m_prefilteredPipeline);
+    encoder->setTexture(cubemap, 0);
+    encoder->setSamplerState(m_linearSampler, 0);
+    for (uint32_t mip = 0; mip < mipCount; ++mip) {
+        const uint32_t mipSize = std::max(resolution >> mip, 1u);
+        encoder->setTexture(mipViews[mip], 1);
+        for (uint32_t face = 0; face < 6; ++face) {
+            PrefilteredParams params;
+            params.roughness = mipCount > 1 ? float(mip) / float(mipCount - 1) : 0.0f;
+            params.resolution = mipSize;
+            params.sampleCount = sampleCount;
+            params.face = face;
+            encoder->setBytes(&params, sizeof(params), 0);
+            encoder->dispatchThreads(MTL::Size::Make(mipSize, mipSize, 1), MTL::Size::Make(8, 8, 1));
+        }
+    }
+    encoder->endEncoding();
+    return true;
+}
+
 MTL::Texture* IBLGenerator::generateIrradianceMap(MTL::Texture* cubemap, uint32_t resolution) {
+    ensureComputeShaders();
     if (!m_irradiancePipeline || !cubemap) return nullptr;
     
     // Create irradiance cubemap
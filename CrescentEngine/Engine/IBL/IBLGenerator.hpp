@@ -7,6 +7,7 @@
 namespace MTL {
     class Device;
     class CommandQueue;
+    class CommandBuffer;
     class ComputePipelineState;
     class Texture;
     class Library;
@@ -28,16 +29,24 @@ class Texture2D;
  */
 class IBLGenerator {
 public:
+    // Written next to the cooked environments of a build; the LUT depends on nothing else.
+    static constexpr const char* kCookedBRDFLUTFileName = "brdf_lut_v1.cbrdf";
+
     IBLGenerator();
     ~IBLGenerator();
     
-    // Initialize with Metal device
+    // Initialize with Metal device. Compute pipelines are built on first use, so a build
+    // that only loads cooked environments never compiles them.
     bool initialize(MTL::Device* device, MTL::CommandQueue* queue);
     void shutdown();
     
-    // Generate BRDF LUT (call once at startup)
+    // Generate BRDF LUT
     // Returns 512x512 RG16Float texture
     MTL::Texture* generateBRDFLUT();
+
+    // Cooked BRDF LUT: "CBRD", a version, the size and the RG16Float texels
+    bool loadBRDFLUT(const std::string& path);
+    bool saveBRDFLUT(const std::string& path);
     
     // Convert equirectangular HDR to cubemap
     // Returns cubemap texture (6 faces)
@@ -46,6 +55,15 @@ public:
     // Generate prefiltered environment map for specular IBL
     // Input: cubemap, Output: cubemap with mips for different roughness levels
     MTL::Texture* generatePrefilteredEnvMap(MTL::Texture* cubemap, uint32_t resolution = 512);
+    // The same filter encoded into commandBuffer without waiting, for cubes captured at runtime:
+    // level i of the output is mipViews[i], a cube view the caller keeps alive until the buffer
+    // completes, filtered for roughness i / (mipCount - 1). cubemap needs its mips generated.
+    bool encodePrefilteredEnvMap(MTL::CommandBuffer* commandBuffer,
+                                 MTL::Texture* cubemap,
+                                 MTL::Texture* const* mipViews,
+                                 uint32_t mipCount,
+                                 uint32_t resolution,
+                                 uint32_t sampleCount);
     
     // Generate irradiance map for diffuse IBL
     // Input: cubemap, Output: small cubemap (32x32)
@@ -59,13 +77,15 @@ public:
     };
     IBLTextures processEnvironmentMap(MTL::Texture* equirect);
     
-    // Get BRDF LUT (generated at init)
-    MTL::Texture* getBRDFLUT() const { return m_brdfLUT; }
+    // Get BRDF LUT: the loaded one, or one generated on first call
+    MTL::Texture* getBRDFLUT();
+    bool hasBRDFLUT() const { return m_brdfLUT != nullptr; }
     
     bool isInitialized() const { return m_initialized; }
     
 private:
     bool loadComputeShaders();
+    bool ensureComputeShaders();
     
     MTL::Device* m_device = nullptr;
     MTL::CommandQueue* m_commandQueue = nullptr;
@@ -84,6 +104,7 @@ private:
     MTL::Texture* m_brdfLUT = nullptr;
     
     bool m_initialized = false;
+    bool m_shadersRequested = false;
 };
 
 } // namespace Crescent
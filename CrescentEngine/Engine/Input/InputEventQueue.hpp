@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Crescent {
+
+enum class InputEventType : uint8_t {
+    KeyDown,
+    KeyUp,
+    MouseMove,
+    MouseButtonDown,
+    MouseButtonUp
+};
+
+struct InputEvent {
+    InputEventType type = InputEventType::MouseMove;
+    int code = 0;           // KeyCode or MouseButton
+    float deltaX = 0.0f;
+    float deltaY = 0.0f;
+    double timestamp = 0.0; // host time in seconds, the NSEvent timestamp base
+};
+
+// Bounded ring of input events with any number of producers and one consumer. The UI thread (and
+// the benchmark's scripted input) push as events arrive and the engine thread pops them when it
+// samples input; nobody blocks. Each slot carries a sequence number saying whose turn it is, so a
+// producer claims a slot with one compare-exchange and the consumer never reads a half-written
+// event. When the engine falls a whole ring behind, new events are dropped and counted.
+template <size_t Capacity>
+class InputEventQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    InputEventQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const InputEvent& event) {
+        size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        for (;;) {
+            slot = &m_slots[position & (Capacity - 1)];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const intptr_t turn = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (turn == 0) {
+                if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (turn < 0) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = m_enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        slot->event = event;
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only.
+    bool pop(InputEvent& event) {
+        Slot& slot = m_slots[m_dequeuePosition & (Capacity - 1)];
+        const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != m_dequeuePosition + 1) {
+            return false;
+        }
+        event = slot.event;
+        slot.sequence.store(m_dequeuePosition + Capacity, std::memory_order_release);
+        ++m_dequeuePosition;
+        return true;
+    }
+
+    uint32_t getDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        InputEvent event;
+    };
+
+    std::array<Slot, Capacity> m_slots;
+    alignas(64) std::atomic<size_t> m_enqueuePosition{0};
+    alignas(64) size_t m_dequeuePosition = 0;
+    std::atomic<uint32_t> m_dropped{0};
+};
+
+} // namespace Crescent
@@ -1,7 +1,23 @@
 #include "InputManager.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <time.h>
+
 namespace Crescent {
 
+namespace {
+
+thread_local int t_fixedStep = -1;
+
+void AtomicAdd(std::atomic<double>& total, double value) {
+    double current = total.load(std::memory_order_relaxed);
+    while (!total.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
 void InputManager::setKeyPressed(KeyCode key, bool pressed) {
     m_keyStates[key] = pressed;
 }
@@ -15,14 +31,14 @@ bool InputManager::isKeyDown(KeyCode key) const {
     bool currentlyPressed = isKeyPressed(key);
     auto it = m_keyStatesPrevious.find(key);
     bool previouslyPressed = it != m_keyStatesPrevious.end() && it->second;
-    return currentlyPressed && !previouslyPressed;
+    return (currentlyPressed && !previouslyPressed) || m_keysPressedThisFrame.count(key) > 0;
 }
 
 bool InputManager::isKeyUp(KeyCode key) const {
     bool currentlyPressed = isKeyPressed(key);
     auto it = m_keyStatesPrevious.find(key);
     bool previouslyPressed = it != m_keyStatesPrevious.end() && it->second;
-    return !currentlyPressed && previouslyPressed;
+    return (!currentlyPressed && previouslyPressed) || m_keysReleasedThisFrame.count(key) > 0;
 }
 
 void InputManager::setMouseButtonPressed(MouseButton button, bool pressed) {
@@ -39,7 +55,13 @@ void InputManager::setMousePosition(const Math::Vector2& position) {
 }
 
 void InputManager::setMouseDelta(const Math::Vector2& delta) {
+    // Overrides the frame's motion, so the per-step split follows it.
     m_mouseDelta = delta;
+    m_motionSamples.clear();
+    if (delta.x != 0.0f || delta.y != 0.0f) {
+        m_motionSamples.push_back({m_frameTime, delta});
+    }
+    m_fixedMouseDeltas.clear();
 }
 
 void InputManager::setMouseScrollDelta(float delta) {
@@ -51,6 +73,10 @@ void InputManager::update() {
     m_mouseButtonStatesPrevious = m_mouseButtonStates;
     m_mouseDelta = Math::Vector2(0.0f, 0.0f);
     m_mouseScrollDelta = 0.0f;
+    m_keysPressedThisFrame.clear();
+    m_keysReleasedThisFrame.clear();
+    m_motionSamples.clear();
+    m_fixedMouseDeltas.clear();
 }
 
 void InputManager::clear() {
@@ -61,6 +87,174 @@ void InputManager::clear() {
     m_mousePosition = Math::Vector2(0.0f, 0.0f);
     m_mouseDelta = Math::Vector2(0.0f, 0.0f);
     m_mouseScrollDelta = 0.0f;
+    m_keysPressedThisFrame.clear();
+    m_keysReleasedThisFrame.clear();
+    InputEvent discarded;
+    while (m_queue.pop(discarded)) {
+    }
+    m_deferredEvents.clear();
+    m_motionSamples.clear();
+    m_fixedMouseDeltas.clear();
+    m_motionAppliedX = m_motionQueuedX.load(std::memory_order_relaxed);
+    m_motionAppliedY = m_motionQueuedY.load(std::memory_order_relaxed);
+}
+
+void InputManager::queueEvent(const InputEvent& event) {
+    InputEvent stamped = event;
+    if (stamped.timestamp <= 0.0) {
+        stamped.timestamp = hostTime();
+    }
+    // Counted before the push, so the total never trails what an update has already applied.
+    const bool motion = stamped.type == InputEventType::MouseMove;
+    if (motion) {
+        AtomicAdd(m_motionQueuedX, stamped.deltaX);
+        AtomicAdd(m_motionQueuedY, stamped.deltaY);
+    }
+    if (!m_queue.push(stamped) && motion) {
+        AtomicAdd(m_motionQueuedX, -stamped.deltaX);
+        AtomicAdd(m_motionQueuedY, -stamped.deltaY);
+    }
+}
+
+void InputManager::processEvents(double frameTime) {
+    m_previousFrameTime = m_frameTime > 0.0 ? m_frameTime : frameTime;
+    m_frameTime = frameTime;
+
+    std::vector<InputEvent> events;
+    events.swap(m_deferredEvents);
+    InputEvent event;
+    while (m_queue.pop(event)) {
+        events.push_back(event);
+    }
+    // Producers on different threads can interleave, so order by when the events happened.
+    std::stable_sort(events.begin(), events.end(), [](const InputEvent& a, const InputEvent& b) {
+        return a.timestamp < b.timestamp;
+    });
+
+    double oldest = 0.0;
+    m_eventsProcessed = 0;
+    for (const InputEvent& queued : events) {
+        if (queued.timestamp > frameTime) {
+            m_deferredEvents.push_back(queued);
+            continue;
+        }
+        if (oldest == 0.0) {
+            oldest = queued.timestamp;
+        }
+        applyEvent(queued);
+        m_eventsProcessed++;
+    }
+
+    m_eventToUpdateMs = oldest > 0.0 ? static_cast<float>((frameTime - oldest) * 1000.0) : 0.0f;
+    if (oldest > 0.0) {
+        // Keep the earliest input not yet shown, should a frame be skipped before presenting.
+        double pending = m_presentInputTime.load(std::memory_order_relaxed);
+        while ((pending == 0.0 || oldest < pending) &&
+               !m_presentInputTime.compare_exchange_weak(pending, oldest, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+void InputManager::applyEvent(const InputEvent& event) {
+    switch (event.type) {
+        case InputEventType::KeyDown: {
+            KeyCode key = static_cast<KeyCode>(event.code);
+            if (!isKeyPressed(key)) {
+                m_keysPressedThisFrame.insert(key);
+            }
+            m_keyStates[key] = true;
+            break;
+        }
+        case InputEventType::KeyUp: {
+            KeyCode key = static_cast<KeyCode>(event.code);
+            if (isKeyPressed(key)) {
+                m_keysReleasedThisFrame.insert(key);
+            }
+            m_keyStates[key] = false;
+            break;
+        }
+        case InputEventType::MouseMove: {
+            Math::Vector2 delta(event.deltaX, event.deltaY);
+            m_mouseDelta = Math::Vector2(m_mouseDelta.x + delta.x, m_mouseDelta.y + delta.y);
+            m_motionSamples.push_back({event.timestamp, delta});
+            m_motionAppliedX += delta.x;
+            m_motionAppliedY += delta.y;
+            break;
+        }
+        case InputEventType::MouseButtonDown:
+            m_mouseButtonStates[static_cast<MouseButton>(event.code)] = true;
+            break;
+        case InputEventType::MouseButtonUp:
+            m_mouseButtonStates[static_cast<MouseButton>(event.code)] = false;
+            break;
+    }
+}
+
+void InputManager::prepareFixedSteps(int steps) {
+    m_fixedMouseDeltas.assign(static_cast<size_t>(std::max(steps, 0)), Math::Vector2(0.0f, 0.0f));
+    if (steps <= 0) {
+        return;
+    }
+    const double span = m_frameTime - m_previousFrameTime;
+    for (const MotionSample& sample : m_motionSamples) {
+        // Motion from before the previous update (a late event) lands in the first step.
+        int step = steps - 1;
+        if (span > 0.0) {
+            double t = (sample.timestamp - m_previousFrameTime) / span;
+            step = std::clamp(static_cast<int>(t * steps), 0, steps - 1);
+        }
+        Math::Vector2& delta = m_fixedMouseDeltas[static_cast<size_t>(step)];
+        delta = Math::Vector2(delta.x + sample.delta.x, delta.y + sample.delta.y);
+    }
+}
+
+void InputManager::setFixedStep(int step) {
+    t_fixedStep = step;
+}
+
+Math::Vector2 InputManager::getFixedMouseDelta() const {
+    if (t_fixedStep >= 0 && static_cast<size_t>(t_fixedStep) < m_fixedMouseDeltas.size()) {
+        return m_fixedMouseDeltas[static_cast<size_t>(t_fixedStep)];
+    }
+    return m_mouseDelta;
+}
+
+Math::Vector2 InputManager::getMotionSince(double appliedX, double appliedY) const {
+    return Math::Vector2(static_cast<float>(m_motionQueuedX.load(std::memory_order_relaxed) - appliedX),
+                         static_cast<float>(m_motionQueuedY.load(std::memory_order_relaxed) - appliedY));
+}
+
+double InputManager::takePresentInputTime() {
+    return m_presentInputTime.exchange(0.0, std::memory_order_relaxed);
+}
+
+void InputManager::recordPresented(double inputTime, double presentedTime) {
+    if (inputTime <= 0.0 || presentedTime <= inputTime) {
+        return;
+    }
+    float latencyMs = static_cast<float>((presentedTime - inputTime) * 1000.0);
+    float smoothed = m_eventToPresentMs.load(std::memory_order_relaxed);
+    smoothed = smoothed > 0.0f ? smoothed + (latencyMs - smoothed) * 0.1f : latencyMs;
+    m_eventToPresentMs.store(smoothed, std::memory_order_relaxed);
+    m_lastEventToPresentMs.store(latencyMs, std::memory_order_relaxed);
+}
+
+InputManager::LatencyStats InputManager::getLatencyStats() const {
+    LatencyStats stats;
+    stats.eventToUpdateMs = m_eventToUpdateMs;
+    stats.eventToPresentMs = m_eventToPresentMs.load(std::memory_order_relaxed);
+    stats.lastEventToPresentMs = m_lastEventToPresentMs.load(std::memory_order_relaxed);
+    stats.eventsProcessed = m_eventsProcessed;
+    stats.eventsDropped = m_queue.getDroppedCount();
+    return stats;
+}
+
+double InputManager::hostTime() {
+#if defined(__APPLE__)
+    return static_cast<double>(clock_gettime_nsec_np(CLOCK_UPTIME_RAW)) * 1e-9;
+#else
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
 }
 
 KeyCode InputManager::stringToKeyCode(const std::string& keyString) {
@@ -1,8 +1,13 @@
 #pragma once
 
+#include "InputEventQueue.hpp"
 #include "../Math/Vector2.hpp"
+#include <atomic>
+#include <cstdint>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
+#include <vector>
 
 namespace Crescent {
 
@@ -18,8 +23,21 @@ enum class MouseButton {
     Left, Right, Middle
 };
 
+// Input state the simulation reads. Platform events are queued with their host timestamps from any
+// thread and applied on the engine thread by processEvents() at the start of each update, so a key
+// tapped and released within one frame still reads as down and up. Mouse motion is also kept per
+// event, which lets each fixed step of the frame read the motion that happened during its share of
+// the frame instead of the whole frame's delta.
 class InputManager {
 public:
+    struct LatencyStats {
+        float eventToUpdateMs = 0.0f;   // oldest event applied by the last update, to that update
+        float eventToPresentMs = 0.0f;  // smoothed, oldest event of a frame to its drawable on screen
+        float lastEventToPresentMs = 0.0f;
+        uint32_t eventsProcessed = 0;   // by the last update
+        uint32_t eventsDropped = 0;     // since launch, because the queue was full
+    };
+
     static InputManager& getInstance() {
         static InputManager instance;
         return instance;
@@ -44,7 +62,34 @@ public:
     
     void update();
     void clear();
-    
+
+    // Thread safe. A timestamp of 0 stamps the event on arrival.
+    void queueEvent(const InputEvent& event);
+    // Applies the queued events that happened up to frameTime; later ones wait for the next frame.
+    void processEvents(double frameTime);
+
+    // Splits the motion of the frame processEvents() just applied evenly across the frame's fixed
+    // steps. While setFixedStep() names a step on the calling thread, getFixedMouseDelta() returns
+    // that step's share; outside fixed steps it returns the frame's delta.
+    void prepareFixedSteps(int steps);
+    static void setFixedStep(int step);
+    Math::Vector2 getFixedMouseDelta() const;
+
+    // Host time of the oldest event the last update applied, handed once to the first frame that
+    // presents after it; 0 if there is none.
+    double takePresentInputTime();
+    // Called from the drawable's presented handler, on any thread.
+    void recordPresented(double inputTime, double presentedTime);
+    LatencyStats getLatencyStats() const;
+
+    // Running totals of mouse motion: applied by updates so far, and queued so far (thread safe).
+    // Their difference from a frame's applied total is the motion that arrived after its update,
+    // which low-latency presentation latches into the view before commit.
+    void getAppliedMotion(double& x, double& y) const { x = m_motionAppliedX; y = m_motionAppliedY; }
+    Math::Vector2 getMotionSince(double appliedX, double appliedY) const;
+
+    // Seconds on the clock NSEvent timestamps, CACurrentMediaTime and presentedTime use.
+    static double hostTime();
     static KeyCode stringToKeyCode(const std::string& keyString);
     
 private:
@@ -52,7 +97,14 @@ private:
     ~InputManager() = default;
     InputManager(const InputManager&) = delete;
     InputManager& operator=(const InputManager&) = delete;
-    
+
+    struct MotionSample {
+        double timestamp = 0.0;
+        Math::Vector2 delta;
+    };
+
+    void applyEvent(const InputEvent& event);
+
     std::unordered_map<KeyCode, bool> m_keyStates;
     std::unordered_map<KeyCode, bool> m_keyStatesPrevious;
     std::unordered_map<MouseButton, bool> m_mouseButtonStates;
@@ -61,6 +113,28 @@ private:
     Math::Vector2 m_mousePosition{0.0f, 0.0f};
     Math::Vector2 m_mouseDelta{0.0f, 0.0f};
     float m_mouseScrollDelta = 0.0f;
+
+    // Transitions of the current frame, so taps shorter than a frame are not lost.
+    std::unordered_set<KeyCode> m_keysPressedThisFrame;
+    std::unordered_set<KeyCode> m_keysReleasedThisFrame;
+
+    InputEventQueue<1024> m_queue;
+    std::vector<InputEvent> m_deferredEvents; // popped, but newer than the frame that popped them
+    std::vector<MotionSample> m_motionSamples;
+    std::vector<Math::Vector2> m_fixedMouseDeltas;
+    double m_frameTime = 0.0;
+    double m_previousFrameTime = 0.0;
+
+    double m_motionAppliedX = 0.0;
+    double m_motionAppliedY = 0.0;
+    std::atomic<double> m_motionQueuedX{0.0};
+    std::atomic<double> m_motionQueuedY{0.0};
+
+    std::atomic<double> m_presentInputTime{0.0};
+    std::atomic<float> m_eventToPresentMs{0.0f};
+    std::atomic<float> m_lastEventToPresentMs{0.0f};
+    float m_eventToUpdateMs = 0.0f;
+    uint32_t m_eventsProcessed = 0;
 };
 
 } // namespace Crescent
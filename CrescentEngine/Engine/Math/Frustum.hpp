@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Vector3.hpp"
+#include "Vector4.hpp"
+#include "Matrix4x4.hpp"
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#if defined(__APPLE__)
+#include <simd/simd.h>
+#endif
+
+namespace Crescent {
+namespace Math {
+
+// Normalized clip planes (xyz = inward normal, w = distance): left, right, bottom, top, near, far.
+using FrustumPlanes = std::array<Vector4, 6>;
+
+inline FrustumPlanes ExtractFrustumPlanes(const Matrix4x4& viewProjection) {
+    auto row = [&](int r) {
+        return Vector4(viewProjection(r, 0), viewProjection(r, 1), viewProjection(r, 2), viewProjection(r, 3));
+    };
+    const Vector4 r0 = row(0);
+    const Vector4 r1 = row(1);
+    const Vector4 r2 = row(2);
+    const Vector4 r3 = row(3);
+
+    FrustumPlanes planes = {
+        r3 + r0, // left
+        r3 - r0, // right
+        r3 + r1, // bottom
+        r3 - r1, // top
+        r3 + r2, // near
+        r3 - r2  // far
+    };
+    for (auto& p : planes) {
+        float len = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+        if (len > 0.0f) {
+            p.x /= len;
+            p.y /= len;
+            p.z /= len;
+            p.w /= len;
+        }
+    }
+    return planes;
+}
+
+inline bool IsSphereInFrustum(const FrustumPlanes& planes, const Vector3& center, float radius) {
+    for (const auto& p : planes) {
+        float dist = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+        if (dist < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Tests count spheres (xyz = center, w = radius) and writes 1/0 per sphere into outVisible.
+// On Apple platforms four spheres are tested per iteration against each plane.
+inline void SpheresInFrustumMany(const FrustumPlanes& planes,
+                                 const Vector4* spheres,
+                                 size_t count,
+                                 uint8_t* outVisible) {
+    size_t i = 0;
+#if defined(__APPLE__)
+    for (; i + 4 <= count; i += 4) {
+        const simd_float4 cx = simd_make_float4(spheres[i].x, spheres[i + 1].x, spheres[i + 2].x, spheres[i + 3].x);
+        const simd_float4 cy = simd_make_float4(spheres[i].y, spheres[i + 1].y, spheres[i + 2].y, spheres[i + 3].y);
+        const simd_float4 cz = simd_make_float4(spheres[i].z, spheres[i + 1].z, spheres[i + 2].z, spheres[i + 3].z);
+        const simd_float4 negRadius = -simd_make_float4(spheres[i].w, spheres[i + 1].w, spheres[i + 2].w, spheres[i + 3].w);
+        simd_int4 inside = simd_make_int4(-1, -1, -1, -1);
+        for (const auto& p : planes) {
+            const simd_float4 dist = cx * p.x + cy * p.y + cz * p.z + p.w;
+            inside &= (dist >= negRadius);
+        }
+        for (size_t lane = 0; lane < 4; ++lane) {
+            outVisible[i + lane] = inside[lane] != 0 ? 1 : 0;
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const Vector4& s = spheres[i];
+        outVisible[i] = IsSphereInFrustum(planes, Vector3(s.x, s.y, s.z), s.w) ? 1 : 0;
+    }
+}
+
+} // namespace Math
+} // namespace Crescent
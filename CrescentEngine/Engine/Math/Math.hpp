@@ -7,6 +7,7 @@
 #include "Vector4.hpp"
 #include "Quaternion.hpp"
 #include "Matrix4x4.hpp"
+#include "Frustum.hpp"
 
 namespace Crescent {
 namespace Math {
@@ -4,6 +4,7 @@
 #include "Vector4.hpp"
 #include "Quaternion.hpp"
 #include <cmath>
+#include <cstddef>
 #include <ostream>
 #include <cstring>
 #if defined(__APPLE__)
@@ -13,9 +14,18 @@
 namespace Crescent {
 namespace Math {
 
-struct Matrix4x4 {
-    // Column-major order (like OpenGL/Metal)
+// Column-major order (like OpenGL/Metal). On Apple platforms the floats share storage with a
+// simd_float4x4, so the SIMD paths work on the matrix in place, and the 16-byte alignment lets
+// arrays of matrices be copied straight into Metal buffers as float4x4.
+struct alignas(16) Matrix4x4 {
+#if defined(__APPLE__)
+    union {
+        float m[16];
+        simd_float4x4 simd;
+    };
+#else
     float m[16];
+#endif
     
     // Constructors
     Matrix4x4() {
@@ -51,28 +61,11 @@ struct Matrix4x4 {
     const float& operator()(int row, int col) const { return m[col * 4 + row]; }
 
 #if defined(__APPLE__)
-private:
-    static simd_float4x4 ToSIMD(const Matrix4x4& matrix) {
-        simd_float4x4 result;
-        result.columns[0] = simd_make_float4(matrix.m[0], matrix.m[1], matrix.m[2], matrix.m[3]);
-        result.columns[1] = simd_make_float4(matrix.m[4], matrix.m[5], matrix.m[6], matrix.m[7]);
-        result.columns[2] = simd_make_float4(matrix.m[8], matrix.m[9], matrix.m[10], matrix.m[11]);
-        result.columns[3] = simd_make_float4(matrix.m[12], matrix.m[13], matrix.m[14], matrix.m[15]);
-        return result;
-    }
+    explicit Matrix4x4(const simd_float4x4& value) : simd(value) {}
 
-    static Matrix4x4 FromSIMD(const simd_float4x4& matrix) {
-        Matrix4x4 result(0.0f);
-        result.m[0] = matrix.columns[0].x; result.m[1] = matrix.columns[0].y;
-        result.m[2] = matrix.columns[0].z; result.m[3] = matrix.columns[0].w;
-        result.m[4] = matrix.columns[1].x; result.m[5] = matrix.columns[1].y;
-        result.m[6] = matrix.columns[1].z; result.m[7] = matrix.columns[1].w;
-        result.m[8] = matrix.columns[2].x; result.m[9] = matrix.columns[2].y;
-        result.m[10] = matrix.columns[2].z; result.m[11] = matrix.columns[2].w;
-        result.m[12] = matrix.columns[3].x; result.m[13] = matrix.columns[3].y;
-        result.m[14] = matrix.columns[3].z; result.m[15] = matrix.columns[3].w;
-        return result;
-    }
+private:
+    static const simd_float4x4& ToSIMD(const Matrix4x4& matrix) { return matrix.simd; }
+    static Matrix4x4 FromSIMD(const simd_float4x4& matrix) { return Matrix4x4(matrix); }
 #endif
 
 public:
@@ -117,8 +110,7 @@ public:
     
     Vector4 operator*(const Vector4& v) const {
 #if defined(__APPLE__)
-        simd_float4 result = simd_mul(ToSIMD(*this), simd_make_float4(v.x, v.y, v.z, v.w));
-        return Vector4(result.x, result.y, result.z, result.w);
+        return Vector4(simd_mul(simd, v.toSIMD()));
 #else
         return Vector4(
             m[0] * v.x + m[4] * v.y + m[8]  * v.z + m[12] * v.w,
@@ -131,12 +123,13 @@ public:
     
     Vector3 transformPoint(const Vector3& point) const {
 #if defined(__APPLE__)
-        simd_float4 v = simd_mul(ToSIMD(*this), simd_make_float4(point.x, point.y, point.z, 1.0f));
-        if (std::abs(v.w) > 1e-8f) {
-            float invW = 1.0f / v.w;
-            return Vector3(v.x * invW, v.y * invW, v.z * invW);
+        const simd_float4 v = simd.columns[0] * point.x + simd.columns[1] * point.y
+                            + simd.columns[2] * point.z + simd.columns[3];
+        if (std::abs(v[3]) > 1e-8f) {
+            const float invW = 1.0f / v[3];
+            return Vector3(v[0] * invW, v[1] * invW, v[2] * invW);
         }
-        return Vector3(v.x, v.y, v.z);
+        return Vector3(v[0], v[1], v[2]);
 #else
         Vector4 v = (*this) * Vector4(point.x, point.y, point.z, 1.0f);
         if (v.w != 0.0f) {
@@ -148,8 +141,8 @@ public:
     
     Vector3 transformDirection(const Vector3& dir) const {
 #if defined(__APPLE__)
-        simd_float4 v = simd_mul(ToSIMD(*this), simd_make_float4(dir.x, dir.y, dir.z, 0.0f));
-        return Vector3(v.x, v.y, v.z);
+        const simd_float4 v = simd.columns[0] * dir.x + simd.columns[1] * dir.y + simd.columns[2] * dir.z;
+        return Vector3(v[0], v[1], v[2]);
 #else
         Vector4 v = (*this) * Vector4(dir.x, dir.y, dir.z, 0.0f);
         return Vector3(v.x, v.y, v.z);
@@ -164,11 +157,27 @@ public:
     }
 
     Vector3 transformPointAffine(const Vector3& point) const {
+#if defined(__APPLE__)
+        const simd_float4 v = simd.columns[0] * point.x + simd.columns[1] * point.y
+                            + simd.columns[2] * point.z + simd.columns[3];
+        return Vector3(v[0], v[1], v[2]);
+#else
         return Vector3(
             m[0] * point.x + m[4] * point.y + m[8] * point.z + m[12],
             m[1] * point.x + m[5] * point.y + m[9] * point.z + m[13],
             m[2] * point.x + m[6] * point.y + m[10] * point.z + m[14]
         );
+#endif
+    }
+
+    // Batched transformPointAffine/transformDirection; on Apple platforms four inputs are
+    // transformed per iteration. Outputs may alias the inputs.
+    void transformPointsAffine(const Vector3* points, Vector3* out, size_t count) const {
+        transformMany(points, out, count, 1.0f);
+    }
+
+    void transformDirections(const Vector3* dirs, Vector3* out, size_t count) const {
+        transformMany(dirs, out, count, 0.0f);
     }
 
     Matrix4x4 inversedAffine() const {
@@ -278,6 +287,17 @@ public:
 
         const Vector3 center = (localMin + localMax) * 0.5f;
         const Vector3 extents = (localMax - localMin) * 0.5f;
+#if defined(__APPLE__)
+        const simd_float4 worldCenter = simd.columns[0] * center.x + simd.columns[1] * center.y
+                                      + simd.columns[2] * center.z + simd.columns[3];
+        const simd_float4 worldExtents = simd_abs(simd.columns[0]) * extents.x
+                                       + simd_abs(simd.columns[1]) * extents.y
+                                       + simd_abs(simd.columns[2]) * extents.z;
+        const simd_float4 worldMin = worldCenter - worldExtents;
+        const simd_float4 worldMax = worldCenter + worldExtents;
+        outMin = Vector3(worldMin[0], worldMin[1], worldMin[2]);
+        outMax = Vector3(worldMax[0], worldMax[1], worldMax[2]);
+#else
         const Vector3 worldCenter = transformPointAffine(center);
         const Vector3 worldExtents(
             std::abs(m[0]) * extents.x + std::abs(m[4]) * extents.y + std::abs(m[8]) * extents.z,
@@ -286,6 +306,31 @@ public:
         );
         outMin = worldCenter - worldExtents;
         outMax = worldCenter + worldExtents;
+#endif
+    }
+
+    // Batched forms for hot loops (culling, skinning palettes). out may alias rhs.
+    static void MultiplyMany(const Matrix4x4& lhs, const Matrix4x4* rhs, Matrix4x4* out, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = lhs * rhs[i];
+        }
+    }
+
+    static void MultiplyMany(const Matrix4x4* lhs, const Matrix4x4* rhs, Matrix4x4* out, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = lhs[i] * rhs[i];
+        }
+    }
+
+    static void TransformAABBMany(const Matrix4x4* matrices,
+                                  const Vector3* localMin,
+                                  const Vector3* localMax,
+                                  Vector3* outMin,
+                                  Vector3* outMax,
+                                  size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            matrices[i].transformAABB(localMin[i], localMax[i], outMin[i], outMax[i]);
+        }
     }
     
     // Transpose
@@ -490,8 +535,18 @@ public:
         return result;
     }
     
+    // Same result as Translate * Rotate * Scale, built directly instead of with two multiplies.
     static Matrix4x4 TRS(const Vector3& translation, const Quaternion& rotation, const Vector3& scale) {
-        return Translate(translation) * Rotate(rotation) * Scale(scale);
+        Matrix4x4 result = Rotate(rotation);
+        for (int i = 0; i < 3; ++i) {
+            result.m[i] *= scale.x;
+            result.m[4 + i] *= scale.y;
+            result.m[8 + i] *= scale.z;
+        }
+        result.m[12] = translation.x;
+        result.m[13] = translation.y;
+        result.m[14] = translation.z;
+        return result;
     }
     
     // ==========================================================================
@@ -588,6 +643,31 @@ public:
         os << ")";
         return os;
     }
+
+private:
+    // w = 1 applies the translation, w = 0 skips it.
+    void transformMany(const Vector3* in, Vector3* out, size_t count, float w) const {
+        size_t i = 0;
+#if defined(__APPLE__)
+        for (; i + 4 <= count; i += 4) {
+            const simd_float4 x = simd_make_float4(in[i].x, in[i + 1].x, in[i + 2].x, in[i + 3].x);
+            const simd_float4 y = simd_make_float4(in[i].y, in[i + 1].y, in[i + 2].y, in[i + 3].y);
+            const simd_float4 z = simd_make_float4(in[i].z, in[i + 1].z, in[i + 2].z, in[i + 3].z);
+            const simd_float4 rx = x * m[0] + y * m[4] + z * m[8] + m[12] * w;
+            const simd_float4 ry = x * m[1] + y * m[5] + z * m[9] + m[13] * w;
+            const simd_float4 rz = x * m[2] + y * m[6] + z * m[10] + m[14] * w;
+            for (size_t lane = 0; lane < 4; ++lane) {
+                out[i + lane] = Vector3(rx[lane], ry[lane], rz[lane]);
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            const Vector3 v = in[i];
+            out[i] = Vector3(m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12] * w,
+                             m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13] * w,
+                             m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14] * w);
+        }
+    }
 };
 
 // Static member definitions
@@ -3,6 +3,9 @@
 #include "Vector3.hpp"
 #include <cmath>
 #include <ostream>
+#if defined(__APPLE__)
+#include <simd/simd.h>
+#endif
 
 namespace Crescent {
 namespace Math {
@@ -10,12 +13,18 @@ namespace Math {
 // Forward declaration
 struct Matrix4x4;
 
-struct Quaternion {
+// Same x, y, z, w layout as simd_quatf, 16-byte aligned so it loads as one vector.
+struct alignas(16) Quaternion {
     float x, y, z, w;
     
     // Constructors
     Quaternion() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
     Quaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+#if defined(__APPLE__)
+    explicit Quaternion(simd_quatf q) : x(q.vector[0]), y(q.vector[1]), z(q.vector[2]), w(q.vector[3]) {}
+    simd_quatf toSIMD() const { return simd_quaternion(x, y, z, w); }
+#endif
     
     // Static constants
     static const Quaternion Identity;
@@ -34,19 +43,31 @@ struct Quaternion {
     }
     
     Quaternion operator*(const Quaternion& other) const {
+#if defined(__APPLE__)
+        return Quaternion(simd_mul(toSIMD(), other.toSIMD()));
+#else
         return Quaternion(
             w * other.x + x * other.w + y * other.z - z * other.y,
             w * other.y + y * other.w + z * other.x - x * other.z,
             w * other.z + z * other.w + x * other.y - y * other.x,
             w * other.w - x * other.x - y * other.y - z * other.z
         );
+#endif
     }
     
     Vector3 operator*(const Vector3& v) const {
+#if defined(__APPLE__)
+        const simd_float3 qvec = simd_make_float3(x, y, z);
+        const simd_float3 sv = v.toSIMD();
+        const simd_float3 uv = simd_cross(qvec, sv);
+        const simd_float3 uuv = simd_cross(qvec, uv);
+        return Vector3(sv + (uv * w + uuv) * 2.0f);
+#else
         Vector3 qvec(x, y, z);
         Vector3 uv = qvec.cross(v);
         Vector3 uuv = qvec.cross(uv);
         return v + ((uv * w) + uuv) * 2.0f;
+#endif
     }
     
     Quaternion& operator*=(const Quaternion& other) {
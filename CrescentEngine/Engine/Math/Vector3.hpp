@@ -2,10 +2,15 @@
 
 #include <cmath>
 #include <ostream>
+#if defined(__APPLE__)
+#include <simd/simd.h>
+#endif
 
 namespace Crescent {
 namespace Math {
 
+// Stays a packed 12-byte type: vertex layouts and packed_float3 shader data depend on it.
+// SIMD code widens it with toSIMD() instead.
 struct Vector3 {
     float x, y, z;
     
@@ -13,6 +18,11 @@ struct Vector3 {
     Vector3() : x(0.0f), y(0.0f), z(0.0f) {}
     Vector3(float scalar) : x(scalar), y(scalar), z(scalar) {}
     Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+#if defined(__APPLE__)
+    explicit Vector3(simd_float3 v) : x(v[0]), y(v[1]), z(v[2]) {}
+    simd_float3 toSIMD() const { return simd_make_float3(x, y, z); }
+#endif
     
     // Static constants
     static const Vector3 Zero;
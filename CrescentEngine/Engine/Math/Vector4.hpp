@@ -2,17 +2,26 @@
 
 #include <cmath>
 #include <ostream>
+#if defined(__APPLE__)
+#include <simd/simd.h>
+#endif
 
 namespace Crescent {
 namespace Math {
 
-struct Vector4 {
+// 16-byte aligned to match float4 in Metal buffers and load as a single simd_float4.
+struct alignas(16) Vector4 {
     float x, y, z, w;
     
     // Constructors
     Vector4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
     Vector4(float scalar) : x(scalar), y(scalar), z(scalar), w(scalar) {}
     Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+#if defined(__APPLE__)
+    explicit Vector4(simd_float4 v) : x(v[0]), y(v[1]), z(v[2]), w(v[3]) {}
+    simd_float4 toSIMD() const { return simd_make_float4(x, y, z, w); }
+#endif
     
     // Static constants
     static const Vector4 Zero;
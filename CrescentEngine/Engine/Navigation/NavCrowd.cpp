@@ -0,0 +1,184 @@
+#include "NavCrowd.hpp"
+#include <algorithm>
+#include <cmath>
+#if defined(__APPLE__)
+#include <simd/simd.h>
+#endif
+
+namespace Crescent {
+
+namespace {
+    // Overlapping agents are pushed apart at this many metres per second per metre of overlap.
+    constexpr float kSeparationGain = 4.0f;
+    constexpr float kMinTime = 0.1f;
+    constexpr float kEpsilon = 1e-6f;
+
+    // Avoidance push of one neighbour on the agent, from the neighbour's offset (rx, rz), the
+    // closing velocity (vx, vz) and the summed radius.
+    void AvoidanceLane(float rx, float rz, float vx, float vz, float combinedRadius,
+                       float horizon, float strength, float& fx, float& fz) {
+        const float dist2 = rx * rx + rz * rz;
+        const float r2 = combinedRadius * combinedRadius;
+        if (dist2 < r2) {
+            const float d = std::sqrt(std::max(dist2, kEpsilon));
+            const float scale = -(combinedRadius - d) / d * kSeparationGain;
+            fx += rx * scale;
+            fz += rz * scale;
+            return;
+        }
+        const float a = vx * vx + vz * vz;
+        const float b = rx * vx + rz * vz;
+        const float disc = b * b - a * (dist2 - r2);
+        if (a <= kEpsilon || b <= 0.0f || disc <= 0.0f) {
+            return;
+        }
+        const float t = (b - std::sqrt(disc)) / a;
+        if (t <= 0.0f || t >= horizon) {
+            return;
+        }
+        const float cx = rx - vx * t;
+        const float cz = rz - vz * t;
+        const float length = std::sqrt(std::max(cx * cx + cz * cz, kEpsilon));
+        const float scale = -strength * (horizon - t) / (horizon * std::max(t, kMinTime)) / length;
+        fx += cx * scale;
+        fz += cz * scale;
+    }
+}
+
+void NavCrowd::clear() {
+    m_PosX.clear();
+    m_PosY.clear();
+    m_PosZ.clear();
+    m_PrefX.clear();
+    m_PrefZ.clear();
+    m_Radius.clear();
+    m_OutX.clear();
+    m_OutZ.clear();
+}
+
+uint32_t NavCrowd::add(const Math::Vector3& position, const Math::Vector3& preferredVelocity, float radius) {
+    m_PosX.push_back(position.x);
+    m_PosY.push_back(position.y);
+    m_PosZ.push_back(position.z);
+    m_PrefX.push_back(preferredVelocity.x);
+    m_PrefZ.push_back(preferredVelocity.z);
+    m_Radius.push_back(std::max(0.05f, radius));
+    return static_cast<uint32_t>(m_PosX.size() - 1);
+}
+
+Math::Vector3 NavCrowd::getVelocity(uint32_t index) const {
+    if (index >= m_OutX.size()) {
+        return Math::Vector3::Zero;
+    }
+    return Math::Vector3(m_OutX[index], 0.0f, m_OutZ[index]);
+}
+
+void NavCrowd::solve(const Settings& settings) {
+    const size_t count = m_PosX.size();
+    m_OutX.assign(m_PrefX.begin(), m_PrefX.end());
+    m_OutZ.assign(m_PrefZ.begin(), m_PrefZ.end());
+    if (count < 2) {
+        return;
+    }
+
+    const float cellSize = std::max(0.5f, settings.neighbourRadius);
+    for (auto& entry : m_Cells) {
+        entry.second.clear();
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        const int32_t cx = static_cast<int32_t>(std::floor(m_PosX[i] / cellSize));
+        const int32_t cz = static_cast<int32_t>(std::floor(m_PosZ[i] / cellSize));
+        m_Cells[CellKey(cx, cz)].push_back(i);
+    }
+
+    const float horizon = std::max(0.1f, settings.timeHorizon);
+    const float strength = std::max(0.0f, settings.avoidanceStrength);
+    const float neighbour2 = settings.neighbourRadius * settings.neighbourRadius;
+    for (uint32_t i = 0; i < count; ++i) {
+        m_NX.clear();
+        m_NZ.clear();
+        m_NVX.clear();
+        m_NVZ.clear();
+        m_NR.clear();
+        const int32_t cx = static_cast<int32_t>(std::floor(m_PosX[i] / cellSize));
+        const int32_t cz = static_cast<int32_t>(std::floor(m_PosZ[i] / cellSize));
+        for (int32_t z = cz - 1; z <= cz + 1; ++z) {
+            for (int32_t x = cx - 1; x <= cx + 1; ++x) {
+                auto it = m_Cells.find(CellKey(x, z));
+                if (it == m_Cells.end()) {
+                    continue;
+                }
+                for (uint32_t j : it->second) {
+                    const float rx = m_PosX[j] - m_PosX[i];
+                    const float rz = m_PosZ[j] - m_PosZ[i];
+                    // Other floors of the level do not crowd each other.
+                    if (j == i || rx * rx + rz * rz > neighbour2 || std::abs(m_PosY[j] - m_PosY[i]) > 2.0f) {
+                        continue;
+                    }
+                    m_NX.push_back(rx);
+                    m_NZ.push_back(rz);
+                    m_NVX.push_back(m_PrefX[i] - m_PrefX[j]);
+                    m_NVZ.push_back(m_PrefZ[i] - m_PrefZ[j]);
+                    m_NR.push_back(m_Radius[i] + m_Radius[j]);
+                }
+            }
+        }
+
+        float fx = 0.0f;
+        float fz = 0.0f;
+        const size_t neighbours = m_NX.size();
+        size_t n = 0;
+#if defined(__APPLE__)
+        simd_float4 sumX = 0.0f;
+        simd_float4 sumZ = 0.0f;
+        const simd_float4 zero = 0.0f;
+        for (; n + 4 <= neighbours; n += 4) {
+            const simd_float4 rx = simd_make_float4(m_NX[n], m_NX[n + 1], m_NX[n + 2], m_NX[n + 3]);
+            const simd_float4 rz = simd_make_float4(m_NZ[n], m_NZ[n + 1], m_NZ[n + 2], m_NZ[n + 3]);
+            const simd_float4 vx = simd_make_float4(m_NVX[n], m_NVX[n + 1], m_NVX[n + 2], m_NVX[n + 3]);
+            const simd_float4 vz = simd_make_float4(m_NVZ[n], m_NVZ[n + 1], m_NVZ[n + 2], m_NVZ[n + 3]);
+            const simd_float4 radius = simd_make_float4(m_NR[n], m_NR[n + 1], m_NR[n + 2], m_NR[n + 3]);
+
+            const simd_float4 dist2 = rx * rx + rz * rz;
+            const simd_float4 r2 = radius * radius;
+            const simd_int4 overlapping = dist2 < r2;
+            const simd_float4 d = simd::sqrt(simd_max(dist2, kEpsilon));
+            const simd_float4 separation = simd_select(zero, -(radius - d) / d * kSeparationGain, overlapping);
+
+            const simd_float4 a = vx * vx + vz * vz;
+            const simd_float4 b = rx * vx + rz * vz;
+            const simd_float4 disc = b * b - a * (dist2 - r2);
+            const simd_float4 t = (b - simd::sqrt(simd_max(disc, zero))) / simd_max(a, kEpsilon);
+            const simd_int4 approaching = ~overlapping & (a > kEpsilon) & (b > 0.0f) & (disc > 0.0f) &
+                                          (t > 0.0f) & (t < horizon);
+            const simd_float4 cxl = rx - vx * t;
+            const simd_float4 czl = rz - vz * t;
+            const simd_float4 length = simd::sqrt(simd_max(cxl * cxl + czl * czl, kEpsilon));
+            const simd_float4 push = -strength * (horizon - t) / (horizon * simd_max(t, kMinTime)) / length;
+            const simd_float4 avoidance = simd_select(zero, push, approaching);
+
+            sumX += rx * separation + cxl * avoidance;
+            sumZ += rz * separation + czl * avoidance;
+        }
+        fx = simd_reduce_add(sumX);
+        fz = simd_reduce_add(sumZ);
+#endif
+        for (; n < neighbours; ++n) {
+            AvoidanceLane(m_NX[n], m_NZ[n], m_NVX[n], m_NVZ[n], m_NR[n], horizon, strength, fx, fz);
+        }
+
+        const float preferredSpeed = std::sqrt(m_PrefX[i] * m_PrefX[i] + m_PrefZ[i] * m_PrefZ[i]);
+        float vx = m_PrefX[i] + fx;
+        float vz = m_PrefZ[i] + fz;
+        const float maxSpeed = std::max(preferredSpeed * settings.maxSpeedScale, 0.5f);
+        const float speed = std::sqrt(vx * vx + vz * vz);
+        if (speed > maxSpeed) {
+            vx *= maxSpeed / speed;
+            vz *= maxSpeed / speed;
+        }
+        m_OutX[i] = vx;
+        m_OutZ[i] = vz;
+    }
+}
+
+} // namespace Crescent
@@ -0,0 +1,431 @@
+#include "NavGrid.hpp"
+#include "../Components/Rigidbody.hpp"
+#include "../ECS/Entity.hpp"
+#include "../Physics/PhysicsQueryBatch.hpp"
+#include "../Physics/PhysicsWorld.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <queue>
+
+namespace Crescent {
+
+namespace {
+    constexpr uint32_t kNavGridMagic = 0x56414E43; // "CNAV"
+    constexpr uint32_t kNavGridVersion = 1;
+    constexpr uint32_t kMaxCellsPerAxis = 4096;
+    constexpr float kDiagonalCost = 1.41421356f;
+
+    struct NavGridHeader {
+        uint32_t magic = kNavGridMagic;
+        uint32_t version = kNavGridVersion;
+        uint32_t width = 0;
+        uint32_t depth = 0;
+        float origin[3] = {0.0f, 0.0f, 0.0f};
+        float cellSize = 0.0f;
+        float stepHeight = 0.0f;
+    };
+
+    // Moving bodies are not part of the level: rays see through them and overlaps ignore them.
+    bool IsStaticGeometry(const Entity* entity) {
+        if (!entity) {
+            return false;
+        }
+        const Rigidbody* body = entity->getComponent<Rigidbody>();
+        return !body || body->getType() == RigidbodyType::Static;
+    }
+
+    // Per-thread A* state, sized to the largest grid searched on the thread. A cell's g and parent
+    // are only valid when its stamp matches the current search.
+    struct SearchScratch {
+        std::vector<float> g;
+        std::vector<uint32_t> parent;
+        std::vector<uint32_t> stamp;
+        uint32_t search = 0;
+
+        void begin(size_t cellCount) {
+            if (stamp.size() < cellCount) {
+                g.resize(cellCount);
+                parent.resize(cellCount);
+                stamp.assign(cellCount, 0);
+                search = 0;
+            }
+            if (++search == 0) {
+                std::fill(stamp.begin(), stamp.end(), 0u);
+                search = 1;
+            }
+        }
+    };
+
+    float OctileDistance(int dx, int dz) {
+        dx = std::abs(dx);
+        dz = std::abs(dz);
+        const int lo = std::min(dx, dz);
+        const int hi = std::max(dx, dz);
+        return static_cast<float>(hi - lo) + kDiagonalCost * static_cast<float>(lo);
+    }
+}
+
+bool NavGrid::beginBake(const NavGridBuildSettings& settings) {
+    m_BuildSettings = settings;
+    m_CellSize = std::max(0.05f, settings.cellSize);
+    m_StepHeight = std::max(0.0f, settings.stepHeight);
+    m_Origin = settings.boundsMin;
+    const float sizeX = settings.boundsMax.x - settings.boundsMin.x;
+    const float sizeZ = settings.boundsMax.z - settings.boundsMin.z;
+    if (!(sizeX > 0.0f) || !(sizeZ > 0.0f)) {
+        m_Width = m_Depth = 0;
+        m_Heights.clear();
+        return false;
+    }
+    m_Width = std::min(kMaxCellsPerAxis, static_cast<uint32_t>(std::ceil(sizeX / m_CellSize)));
+    m_Depth = std::min(kMaxCellsPerAxis, static_cast<uint32_t>(std::ceil(sizeZ / m_CellSize)));
+    m_Heights.assign(static_cast<size_t>(m_Width) * m_Depth, std::numeric_limits<float>::quiet_NaN());
+    return true;
+}
+
+void NavGrid::bakeRows(const PhysicsWorld& physics, uint32_t rowBegin, uint32_t rowEnd) {
+    rowEnd = std::min(rowEnd, m_Depth);
+    if (rowBegin >= rowEnd) {
+        return;
+    }
+    const NavGridBuildSettings& s = m_BuildSettings;
+    const float top = s.boundsMax.y + s.agentHeight;
+    const float rayLength = top - s.boundsMin.y + 1.0f;
+    const float minFloorNormalY = std::cos(std::clamp(s.maxSlopeDegrees, 0.0f, 89.0f) * Math::DEG_TO_RAD);
+    const float radius = std::max(0.05f, s.agentRadius);
+
+    // Floors: every hit down the column, so a ray can pass through moving bodies to the level.
+    PhysicsQueryBatch floors;
+    for (uint32_t z = rowBegin; z < rowEnd; ++z) {
+        for (uint32_t x = 0; x < m_Width; ++x) {
+            const Math::Vector3 origin(m_Origin.x + (x + 0.5f) * m_CellSize, top, m_Origin.z + (z + 0.5f) * m_CellSize);
+            floors.addRaycast(origin, Math::Vector3::Down, rayLength, s.layerMask, false, nullptr, true);
+        }
+    }
+    physics.runQueries(floors);
+
+    std::vector<uint32_t> candidates;
+    std::vector<float> candidateHeights;
+    for (uint32_t query = 0; query < floors.size(); ++query) {
+        const PhysicsRaycastHit* hits = floors.getCastHits(query);
+        const uint32_t hitCount = floors.getHitCount(query);
+        for (uint32_t h = 0; h < hitCount; ++h) {
+            if (!hits[h].hit || !IsStaticGeometry(hits[h].entity)) {
+                continue;
+            }
+            if (hits[h].normal.y >= minFloorNormalY) {
+                candidates.push_back(rowBegin * m_Width + query);
+                candidateHeights.push_back(hits[h].point.y);
+            }
+            break;
+        }
+    }
+
+    // Clearance: a sphere resting one step above the floor and one at head height.
+    PhysicsQueryBatch clearance;
+    const float lowCenter = m_StepHeight + radius;
+    const float highCenter = std::max(lowCenter, s.agentHeight - radius);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        Math::Vector3 center = cellCenter(candidates[i]);
+        center.y = candidateHeights[i] + lowCenter;
+        clearance.addOverlapSphere(center, radius, s.layerMask, false, nullptr);
+        center.y = candidateHeights[i] + highCenter;
+        clearance.addOverlapSphere(center, radius, s.layerMask, false, nullptr);
+    }
+    physics.runQueries(clearance);
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        bool clear = true;
+        for (uint32_t query = static_cast<uint32_t>(i * 2); query < i * 2 + 2 && clear; ++query) {
+            const PhysicsOverlapHit* hits = clearance.getOverlapHits(query);
+            const uint32_t hitCount = clearance.getHitCount(query);
+            for (uint32_t h = 0; h < hitCount; ++h) {
+                if (IsStaticGeometry(hits[h].entity)) {
+                    clear = false;
+                    break;
+                }
+            }
+        }
+        if (clear) {
+            m_Heights[candidates[i]] = candidateHeights[i];
+        }
+    }
+}
+
+bool NavGrid::bake(const PhysicsWorld& physics, const NavGridBuildSettings& settings) {
+    if (!beginBake(settings)) {
+        return false;
+    }
+    // Rows in slices keep the query batches' hit buffers bounded.
+    const uint32_t rowsPerSlice = std::max(1u, 65536u / std::max(1u, m_Width));
+    for (uint32_t row = 0; row < m_Depth; row += rowsPerSlice) {
+        bakeRows(physics, row, row + rowsPerSlice);
+    }
+    return true;
+}
+
+bool NavGrid::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "NavGrid: failed to write " << path << "\n";
+        return false;
+    }
+    NavGridHeader header;
+    header.width = m_Width;
+    header.depth = m_Depth;
+    header.origin[0] = m_Origin.x;
+    header.origin[1] = m_Origin.y;
+    header.origin[2] = m_Origin.z;
+    header.cellSize = m_CellSize;
+    header.stepHeight = m_StepHeight;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(m_Heights.data()),
+              static_cast<std::streamsize>(m_Heights.size() * sizeof(float)));
+    return out.good();
+}
+
+bool NavGrid::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::vector<uint8_t> bytes(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return in.good() && loadFromMemory(bytes.data(), bytes.size());
+}
+
+bool NavGrid::loadFromMemory(const uint8_t* data, size_t size) {
+    NavGridHeader header;
+    if (!data || size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != kNavGridMagic || header.version != kNavGridVersion ||
+        header.width > kMaxCellsPerAxis || header.depth > kMaxCellsPerAxis) {
+        std::cerr << "NavGrid: unsupported grid data\n";
+        return false;
+    }
+    const size_t cellCount = static_cast<size_t>(header.width) * header.depth;
+    if (size - sizeof(header) < cellCount * sizeof(float)) {
+        return false;
+    }
+    m_Width = header.width;
+    m_Depth = header.depth;
+    m_Origin = Math::Vector3(header.origin[0], header.origin[1], header.origin[2]);
+    m_CellSize = header.cellSize;
+    m_StepHeight = header.stepHeight;
+    m_Heights.resize(cellCount);
+    std::memcpy(m_Heights.data(), data + sizeof(header), cellCount * sizeof(float));
+    return true;
+}
+
+size_t NavGrid::getWalkableCount() const {
+    size_t count = 0;
+    for (float height : m_Heights) {
+        count += height == height ? 1 : 0;
+    }
+    return count;
+}
+
+uint32_t NavGrid::cellAt(const Math::Vector3& position) const {
+    if (m_Heights.empty()) {
+        return kInvalidCell;
+    }
+    const float fx = std::floor((position.x - m_Origin.x) / m_CellSize);
+    const float fz = std::floor((position.z - m_Origin.z) / m_CellSize);
+    if (fx < 0.0f || fz < 0.0f || fx >= static_cast<float>(m_Width) || fz >= static_cast<float>(m_Depth)) {
+        return kInvalidCell;
+    }
+    return static_cast<uint32_t>(fz) * m_Width + static_cast<uint32_t>(fx);
+}
+
+Math::Vector3 NavGrid::cellCenter(uint32_t cell) const {
+    const uint32_t x = cell % m_Width;
+    const uint32_t z = cell / m_Width;
+    const float height = isWalkable(cell) ? m_Heights[cell] : m_Origin.y;
+    return Math::Vector3(m_Origin.x + (x + 0.5f) * m_CellSize, height, m_Origin.z + (z + 0.5f) * m_CellSize);
+}
+
+uint32_t NavGrid::findNearestWalkable(const Math::Vector3& position, uint32_t maxRings) const {
+    if (m_Heights.empty()) {
+        return kInvalidCell;
+    }
+    const int cx = static_cast<int>(std::floor((position.x - m_Origin.x) / m_CellSize));
+    const int cz = static_cast<int>(std::floor((position.z - m_Origin.z) / m_CellSize));
+    for (int ring = 0; ring <= static_cast<int>(maxRings); ++ring) {
+        uint32_t best = kInvalidCell;
+        float bestDistance = std::numeric_limits<float>::max();
+        for (int z = cz - ring; z <= cz + ring; ++z) {
+            for (int x = cx - ring; x <= cx + ring; ++x) {
+                if (std::max(std::abs(x - cx), std::abs(z - cz)) != ring ||
+                    x < 0 || z < 0 || x >= static_cast<int>(m_Width) || z >= static_cast<int>(m_Depth)) {
+                    continue;
+                }
+                const uint32_t cell = static_cast<uint32_t>(z) * m_Width + static_cast<uint32_t>(x);
+                if (!isWalkable(cell)) {
+                    continue;
+                }
+                const float distance = (cellCenter(cell) - position).lengthSquared();
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = cell;
+                }
+            }
+        }
+        if (best != kInvalidCell) {
+            return best;
+        }
+    }
+    return kInvalidCell;
+}
+
+bool NavGrid::connected(uint32_t from, uint32_t to) const {
+    if (!isWalkable(from) || !isWalkable(to)) {
+        return false;
+    }
+    const int dx = static_cast<int>(to % m_Width) - static_cast<int>(from % m_Width);
+    const int dz = static_cast<int>(to / m_Width) - static_cast<int>(from / m_Width);
+    if (std::abs(m_Heights[to] - m_Heights[from]) > m_StepHeight) {
+        return false;
+    }
+    if (dx == 0 || dz == 0) {
+        return true;
+    }
+    // No corner cutting: the two cells the diagonal passes between must be walkable too.
+    const uint32_t sideX = static_cast<uint32_t>(static_cast<int>(from) + dx);
+    const uint32_t sideZ = static_cast<uint32_t>(static_cast<int>(from) + dz * static_cast<int>(m_Width));
+    return isWalkable(sideX) && isWalkable(sideZ) &&
+           std::abs(m_Heights[sideX] - m_Heights[from]) <= m_StepHeight &&
+           std::abs(m_Heights[sideZ] - m_Heights[from]) <= m_StepHeight;
+}
+
+bool NavGrid::hasLineOfWalk(uint32_t from, uint32_t to) const {
+    if (!isWalkable(from) || !isWalkable(to)) {
+        return false;
+    }
+    int x = static_cast<int>(from % m_Width);
+    int z = static_cast<int>(from / m_Width);
+    const int x1 = static_cast<int>(to % m_Width);
+    const int z1 = static_cast<int>(to / m_Width);
+    const int dx = std::abs(x1 - x);
+    const int dz = std::abs(z1 - z);
+    const int sx = x < x1 ? 1 : -1;
+    const int sz = z < z1 ? 1 : -1;
+    int error = dx - dz;
+    uint32_t cell = from;
+    while (cell != to) {
+        const int doubled = error * 2;
+        int nx = x;
+        int nz = z;
+        if (doubled > -dz) {
+            error -= dz;
+            nx += sx;
+        }
+        if (doubled < dx) {
+            error += dx;
+            nz += sz;
+        }
+        const uint32_t next = static_cast<uint32_t>(nz) * m_Width + static_cast<uint32_t>(nx);
+        if (!connected(cell, next)) {
+            return false;
+        }
+        x = nx;
+        z = nz;
+        cell = next;
+    }
+    return true;
+}
+
+bool NavGrid::findPath(const Math::Vector3& start, const Math::Vector3& goal, std::vector<Math::Vector3>& outPath) const {
+    outPath.clear();
+    const uint32_t startCell = findNearestWalkable(start);
+    const uint32_t goalCell = findNearestWalkable(goal);
+    if (startCell == kInvalidCell || goalCell == kInvalidCell) {
+        return false;
+    }
+
+    thread_local SearchScratch scratch;
+    scratch.begin(m_Heights.size());
+    const int goalX = static_cast<int>(goalCell % m_Width);
+    const int goalZ = static_cast<int>(goalCell / m_Width);
+    auto heuristic = [&](uint32_t cell) {
+        return OctileDistance(static_cast<int>(cell % m_Width) - goalX, static_cast<int>(cell / m_Width) - goalZ);
+    };
+
+    using OpenEntry = std::pair<float, uint32_t>;
+    std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>> open;
+    scratch.g[startCell] = 0.0f;
+    scratch.parent[startCell] = kInvalidCell;
+    scratch.stamp[startCell] = scratch.search;
+    open.emplace(heuristic(startCell), startCell);
+
+    bool found = false;
+    while (!open.empty()) {
+        const auto [f, cell] = open.top();
+        open.pop();
+        if (cell == goalCell) {
+            found = true;
+            break;
+        }
+        // Stale entry: the cell was reached more cheaply after this was queued.
+        if (f > scratch.g[cell] + heuristic(cell) + 1e-4f) {
+            continue;
+        }
+        const int x = static_cast<int>(cell % m_Width);
+        const int z = static_cast<int>(cell / m_Width);
+        for (int dz = -1; dz <= 1; ++dz) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                const int nx = x + dx;
+                const int nz = z + dz;
+                if ((dx == 0 && dz == 0) || nx < 0 || nz < 0 ||
+                    nx >= static_cast<int>(m_Width) || nz >= static_cast<int>(m_Depth)) {
+                    continue;
+                }
+                const uint32_t next = static_cast<uint32_t>(nz) * m_Width + static_cast<uint32_t>(nx);
+                if (!connected(cell, next)) {
+                    continue;
+                }
+                const float g = scratch.g[cell] + (dx != 0 && dz != 0 ? kDiagonalCost : 1.0f);
+                if (scratch.stamp[next] == scratch.search && g >= scratch.g[next]) {
+                    continue;
+                }
+                scratch.stamp[next] = scratch.search;
+                scratch.g[next] = g;
+                scratch.parent[next] = cell;
+                open.emplace(g + heuristic(next), next);
+            }
+        }
+    }
+    if (!found) {
+        return false;
+    }
+
+    std::vector<uint32_t> cells;
+    for (uint32_t cell = goalCell; cell != kInvalidCell; cell = scratch.parent[cell]) {
+        cells.push_back(cell);
+    }
+    std::reverse(cells.begin(), cells.end());
+
+    // String pulling: keep a corner only where the straight line from the last kept one breaks.
+    Math::Vector3 first = start;
+    first.y = m_Heights[startCell];
+    outPath.push_back(first);
+    size_t anchor = 0;
+    for (size_t i = 2; i < cells.size(); ++i) {
+        if (!hasLineOfWalk(cells[anchor], cells[i])) {
+            anchor = i - 1;
+            outPath.push_back(cellCenter(cells[anchor]));
+        }
+    }
+    Math::Vector3 last = goal;
+    last.y = m_Heights[goalCell];
+    outPath.push_back(last);
+    return true;
+}
+
+} // namespace Crescent
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../Math/Math.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Crescent {
+
+class PhysicsWorld;
+
+// Parameters of a navigation grid bake, in metres and degrees.
+struct NavGridBuildSettings {
+    Math::Vector3 boundsMin = Math::Vector3::Zero;
+    Math::Vector3 boundsMax = Math::Vector3::Zero;
+    float cellSize = 0.5f;
+    float agentRadius = 0.4f;
+    float agentHeight = 1.8f;
+    float maxSlopeDegrees = 45.0f;
+    float stepHeight = 0.4f;
+    uint32_t layerMask = 0xFFFFFFFFu;
+};
+
+// Walkable surface of a level as a 2.5D grid on the XZ plane: each cell holds the height of the
+// floor an agent stands on there, or is blocked. It is baked from the static colliders with
+// physics queries, one downward ray per cell for the floor and two overlap spheres for the
+// agent's clearance, so walls already push the walkable area back by the agent radius. Two
+// neighbouring cells connect when their floors are within stepHeight; diagonals also need both
+// cells they pass between. The grid is immutable once baked, so path queries read it from any
+// thread without locks.
+class NavGrid {
+public:
+    static constexpr uint32_t kInvalidCell = 0xFFFFFFFFu;
+
+    // Sizes the grid over the bounds and blocks every cell; bakeRows then fills it in. A bake can
+    // be split over frames by baking a few rows at a time.
+    bool beginBake(const NavGridBuildSettings& settings);
+    // Bakes rows [rowBegin, rowEnd) with one query batch. Physics must not step meanwhile.
+    void bakeRows(const PhysicsWorld& physics, uint32_t rowBegin, uint32_t rowEnd);
+    bool bake(const PhysicsWorld& physics, const NavGridBuildSettings& settings);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+    bool loadFromMemory(const uint8_t* data, size_t size);
+
+    bool empty() const { return m_Heights.empty(); }
+    uint32_t getWidth() const { return m_Width; }
+    uint32_t getDepth() const { return m_Depth; }
+    float getCellSize() const { return m_CellSize; }
+    size_t getWalkableCount() const;
+
+    uint32_t cellAt(const Math::Vector3& position) const;
+    bool isWalkable(uint32_t cell) const { return cell < m_Heights.size() && m_Heights[cell] == m_Heights[cell]; }
+    Math::Vector3 cellCenter(uint32_t cell) const;
+    // Closest walkable cell within maxRings rings of cells around the position.
+    uint32_t findNearestWalkable(const Math::Vector3& position, uint32_t maxRings = 4) const;
+
+    // A* over the cells, string-pulled so the path only turns where a straight line would leave
+    // walkable ground. The path runs from start to goal, both included. False when either end is
+    // off the grid or the goal is unreachable.
+    bool findPath(const Math::Vector3& start, const Math::Vector3& goal, std::vector<Math::Vector3>& outPath) const;
+    // True when an agent walks from one cell to the other in a straight line on walkable ground.
+    bool hasLineOfWalk(uint32_t from, uint32_t to) const;
+
+private:
+    bool connected(uint32_t from, uint32_t to) const;
+
+    Math::Vector3 m_Origin = Math::Vector3::Zero;
+    float m_CellSize = 0.5f;
+    float m_StepHeight = 0.4f;
+    uint32_t m_Width = 0;
+    uint32_t m_Depth = 0;
+    // Floor height per cell, row-major by z; NaN where blocked.
+    std::vector<float> m_Heights;
+    NavGridBuildSettings m_BuildSettings;
+};
+
+} // namespace Crescent
@@ -0,0 +1,275 @@
+#include "NavigationSystem.hpp"
+#include "../Components/MeshRenderer.hpp"
+#include "../Components/PhysicsCollider.hpp"
+#include "../Components/Rigidbody.hpp"
+#include "../Core/AsyncIO.hpp"
+#include "../Core/JobScheduler.hpp"
+#include "../Core/Time.hpp"
+#include "../ECS/Entity.hpp"
+#include "../Physics/PhysicsWorld.hpp"
+#include "../Scene/Scene.hpp"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace Crescent {
+
+namespace {
+    constexpr size_t kPathCacheCapacity = 256;
+    // Cells baked per frame while a scene without a cooked grid plays.
+    constexpr uint32_t kBakeCellsPerFrame = 16384;
+}
+
+NavigationSystem& NavigationSystem::getInstance() {
+    // Never destroyed: path jobs on the background lane may outlive the scene.
+    static NavigationSystem* instance = new NavigationSystem();
+    return *instance;
+}
+
+NavGridBuildSettings NavigationSystem::MakeBuildSettings(const Scene* scene) {
+    NavGridBuildSettings build;
+    if (!scene) {
+        return build;
+    }
+    const SceneNavigationSettings& settings = scene->getSettings().navigation;
+    build.cellSize = settings.cellSize;
+    build.agentRadius = settings.agentRadius;
+    build.agentHeight = settings.agentHeight;
+    build.maxSlopeDegrees = settings.maxSlopeDegrees;
+    build.stepHeight = settings.stepHeight;
+
+    Math::Vector3 boundsMin(std::numeric_limits<float>::max());
+    Math::Vector3 boundsMax(-std::numeric_limits<float>::max());
+    bool any = false;
+    for (const auto& handle : scene->getAllEntities()) {
+        const Entity* entity = handle.get();
+        if (!entity || !entity->isActiveInHierarchy() || !entity->getComponent<PhysicsCollider>()) {
+            continue;
+        }
+        const Rigidbody* body = entity->getComponent<Rigidbody>();
+        const MeshRenderer* renderer = entity->getComponent<MeshRenderer>();
+        if ((body && body->getType() != RigidbodyType::Static) || !renderer) {
+            continue;
+        }
+        Math::Vector3 rendererMin;
+        Math::Vector3 rendererMax;
+        renderer->getWorldBounds(rendererMin, rendererMax);
+        boundsMin = Math::Vector3(std::min(boundsMin.x, rendererMin.x), std::min(boundsMin.y, rendererMin.y),
+                                  std::min(boundsMin.z, rendererMin.z));
+        boundsMax = Math::Vector3(std::max(boundsMax.x, rendererMax.x), std::max(boundsMax.y, rendererMax.y),
+                                  std::max(boundsMax.z, rendererMax.z));
+        any = true;
+    }
+    if (any) {
+        build.boundsMin = boundsMin;
+        build.boundsMax = boundsMax;
+    }
+    return build;
+}
+
+bool NavigationSystem::CookSceneNavGrid(Scene* scene, const std::string& path) {
+    if (!scene || !scene->getPhysicsWorld() || !scene->getSettings().navigation.enabled) {
+        return false;
+    }
+    NavGrid grid;
+    if (!grid.bake(*scene->getPhysicsWorld(), MakeBuildSettings(scene)) || grid.getWalkableCount() == 0) {
+        std::cerr << "NavigationSystem: nothing walkable to cook in " << scene->getName() << "\n";
+        return false;
+    }
+    return grid.save(path);
+}
+
+void NavigationSystem::beginScene(Scene* scene) {
+    m_Scene = scene;
+    m_Grid.reset();
+    m_Baking.reset();
+    m_BakeRow = 0;
+    m_Crowd.clear();
+    m_CrowdIndices.clear();
+    m_CrowdVelocities.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ++m_Generation;
+        m_LoadedGrid.reset();
+        m_CookedLoadFailed = false;
+        m_PathCache.clear();
+        m_PathCacheOrder.clear();
+    }
+    if (!scene || !scene->getSettings().navigation.enabled) {
+        return;
+    }
+    const std::string& cookedPath = scene->getSettings().navigation.cookedGridPath;
+    if (!cookedPath.empty()) {
+        Spawn(loadCookedGrid(cookedPath, m_Generation));
+        return;
+    }
+    m_Baking = std::make_unique<NavGrid>();
+    if (!m_Baking->beginBake(MakeBuildSettings(scene))) {
+        m_Baking.reset();
+    }
+}
+
+Task<void> NavigationSystem::loadCookedGrid(std::string path, uint64_t generation) {
+    std::shared_ptr<MappedFile> file = co_await ReadFileAsync(path);
+    auto grid = std::make_shared<NavGrid>();
+    const bool loaded = file && grid->loadFromMemory(file->data(), file->size());
+    if (!loaded) {
+        std::cerr << "NavigationSystem: failed to load " << path << ", baking instead\n";
+    }
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (generation != m_Generation) {
+        co_return;
+    }
+    m_CookedLoadFailed = !loaded;
+    if (loaded) {
+        m_LoadedGrid = std::move(grid);
+    }
+}
+
+void NavigationSystem::advanceBake() {
+    if (!m_Baking || !m_Scene || !m_Scene->getPhysicsWorld()) {
+        return;
+    }
+    const uint32_t rows = std::max(1u, kBakeCellsPerFrame / std::max(1u, m_Baking->getWidth()));
+    m_Baking->bakeRows(*m_Scene->getPhysicsWorld(), m_BakeRow, m_BakeRow + rows);
+    m_BakeRow += rows;
+    if (m_BakeRow >= m_Baking->getDepth()) {
+        m_Grid = std::shared_ptr<const NavGrid>(std::move(m_Baking));
+        m_Baking.reset();
+    }
+}
+
+void NavigationSystem::refreshFrame(Scene* scene) {
+    if (scene != m_Scene) {
+        beginScene(scene);
+    }
+    const uint64_t frame = Time::frameCount();
+    if (frame == m_Frame) {
+        return;
+    }
+    m_Frame = frame;
+
+    if (!m_Grid) {
+        bool bakeInstead = false;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_LoadedGrid) {
+                m_Grid = std::move(m_LoadedGrid);
+            } else if (m_CookedLoadFailed) {
+                m_CookedLoadFailed = false;
+                bakeInstead = true;
+            }
+        }
+        if (bakeInstead && m_Scene) {
+            m_Baking = std::make_unique<NavGrid>();
+            m_BakeRow = 0;
+            if (!m_Baking->beginBake(MakeBuildSettings(m_Scene))) {
+                m_Baking.reset();
+            }
+        }
+        advanceBake();
+    }
+
+    // Last frame's submissions become this frame's avoidance velocities.
+    m_CrowdVelocities.clear();
+    if (m_Crowd.size() > 0) {
+        m_Crowd.solve(m_CrowdSettings);
+        for (const auto& [owner, index] : m_CrowdIndices) {
+            m_CrowdVelocities[owner] = m_Crowd.getVelocity(index);
+        }
+    }
+    m_Crowd.clear();
+    m_CrowdIndices.clear();
+}
+
+std::shared_ptr<const NavGrid> NavigationSystem::getGrid(Scene* scene) {
+    refreshFrame(scene);
+    return m_Grid;
+}
+
+NavigationSystem::PathRequestId NavigationSystem::requestPath(Scene* scene, const Math::Vector3& start,
+                                                              const Math::Vector3& goal) {
+    refreshFrame(scene);
+    if (!m_Grid) {
+        return kInvalidPathRequest;
+    }
+    const uint32_t startCell = m_Grid->findNearestWalkable(start);
+    const uint32_t goalCell = m_Grid->findNearestWalkable(goal);
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const PathRequestId id = m_NextRequestId++;
+    if (m_NextRequestId == kInvalidPathRequest) {
+        m_NextRequestId = 1;
+    }
+    PathRequest& request = m_Requests[id];
+    if (startCell == NavGrid::kInvalidCell || goalCell == NavGrid::kInvalidCell) {
+        request.status = PathStatus::Failed;
+        return id;
+    }
+    auto cached = m_PathCache.find(PathCacheKey(startCell, goalCell));
+    if (cached != m_PathCache.end() && cached->second.path && !cached->second.path->empty()) {
+        request.status = PathStatus::Ready;
+        request.path = *cached->second.path;
+        // Same cells, not the same points: the ends follow this request.
+        request.path.front() = Math::Vector3(start.x, request.path.front().y, start.z);
+        request.path.back() = Math::Vector3(goal.x, request.path.back().y, goal.z);
+        return id;
+    }
+    std::shared_ptr<const NavGrid> grid = m_Grid;
+    const uint64_t generation = m_Generation;
+    JobScheduler::getInstance().schedule(JobFunction([grid, generation, id, start, goal]() {
+        NavigationSystem::getInstance().runPathQuery(grid, generation, id, start, goal);
+    }), nullptr, JobPriority::Background);
+    return id;
+}
+
+void NavigationSystem::runPathQuery(std::shared_ptr<const NavGrid> grid, uint64_t generation, PathRequestId id,
+                                    Math::Vector3 start, Math::Vector3 goal) {
+    std::vector<Math::Vector3> path;
+    const bool found = grid->findPath(start, goal, path);
+    const uint64_t key = PathCacheKey(grid->findNearestWalkable(start), grid->findNearestWalkable(goal));
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (found && generation == m_Generation && m_PathCache.find(key) == m_PathCache.end()) {
+        if (m_PathCacheOrder.size() >= kPathCacheCapacity) {
+            m_PathCache.erase(m_PathCacheOrder.front());
+            m_PathCacheOrder.pop_front();
+        }
+        m_PathCache[key].path = std::make_shared<const std::vector<Math::Vector3>>(path);
+        m_PathCacheOrder.push_back(key);
+    }
+    auto it = m_Requests.find(id);
+    if (it == m_Requests.end()) {
+        return; // cancelled
+    }
+    it->second.status = found ? PathStatus::Ready : PathStatus::Failed;
+    it->second.path = std::move(path);
+}
+
+NavigationSystem::PathStatus NavigationSystem::takePath(PathRequestId id, std::vector<Math::Vector3>& outPath) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Requests.find(id);
+    if (it == m_Requests.end()) {
+        return PathStatus::Unknown;
+    }
+    const PathStatus status = it->second.status;
+    if (status != PathStatus::Pending) {
+        outPath = std::move(it->second.path);
+        m_Requests.erase(it);
+    }
+    return status;
+}
+
+void NavigationSystem::cancelPath(PathRequestId id) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Requests.erase(id);
+}
+
+Math::Vector3 NavigationSystem::steerCrowdAgent(const void* owner, Scene* scene, const Math::Vector3& position,
+                                                const Math::Vector3& preferredVelocity, float radius) {
+    refreshFrame(scene);
+    m_CrowdIndices[owner] = m_Crowd.add(position, preferredVelocity, radius);
+    auto it = m_CrowdVelocities.find(owner);
+    return it != m_CrowdVelocities.end() ? it->second : preferredVelocity;
+}
+
+} // namespace Crescent
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "NavCrowd.hpp"
+#include "NavGrid.hpp"
+#include "../Core/AsyncTask.hpp"
+#include "../Math/Math.hpp"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Crescent {
+
+class Scene;
+
+// Navigation for the active scene: its grid, path queries and crowd avoidance.
+//
+// The grid of a cooked scene is cooked alongside it (SceneSerializer::SaveCookedRuntimeScene)
+// and mapped in on the background lane when the scene loads. An uncooked scene with navigation
+// enabled in its settings is baked from its static colliders on the main thread, a slice of rows
+// per frame, while the game runs. Path requests run A* on the background lane against the grid
+// they were made on; a finished path is cached by its start and goal cells, so agents chasing the
+// same target mostly share one search. Crowd agents submit their preferred velocity each frame
+// and get back the avoidance velocity solved from the previous frame's submissions.
+//
+// Main-thread API; the first call in a frame advances the bake, collects cooked loads and solves
+// the crowd.
+class NavigationSystem {
+public:
+    using PathRequestId = uint32_t;
+    static constexpr PathRequestId kInvalidPathRequest = 0;
+
+    enum class PathStatus {
+        Pending,
+        Ready,
+        Failed,
+        Unknown
+    };
+
+    static NavigationSystem& getInstance();
+
+    // Bake parameters from the scene's navigation settings, over the bounds of its static
+    // colliders' render geometry.
+    static NavGridBuildSettings MakeBuildSettings(const Scene* scene);
+    // Bakes the scene's grid and writes it to path; false when navigation is off or nothing baked.
+    static bool CookSceneNavGrid(Scene* scene, const std::string& path);
+
+    // Null until the scene's grid is loaded or baked.
+    std::shared_ptr<const NavGrid> getGrid(Scene* scene);
+
+    PathRequestId requestPath(Scene* scene, const Math::Vector3& start, const Math::Vector3& goal);
+    // Once Ready or Failed the request is consumed and its id becomes Unknown.
+    PathStatus takePath(PathRequestId id, std::vector<Math::Vector3>& outPath);
+    void cancelPath(PathRequestId id);
+
+    // Avoidance velocity for the owner's agent, solved last frame; the preferred velocity when the
+    // agent was not in the last solve.
+    Math::Vector3 steerCrowdAgent(const void* owner, Scene* scene, const Math::Vector3& position,
+                                  const Math::Vector3& preferredVelocity, float radius);
+
+    const NavCrowd::Settings& getCrowdSettings() const { return m_CrowdSettings; }
+    void setCrowdSettings(const NavCrowd::Settings& settings) { m_CrowdSettings = settings; }
+
+private:
+    struct PathRequest {
+        PathStatus status = PathStatus::Pending;
+        std::vector<Math::Vector3> path;
+    };
+
+    struct CachedPath {
+        std::shared_ptr<const std::vector<Math::Vector3>> path;
+    };
+
+    NavigationSystem() = default;
+
+    void refreshFrame(Scene* scene);
+    void beginScene(Scene* scene);
+    void advanceBake();
+    Task<void> loadCookedGrid(std::string path, uint64_t generation);
+    void runPathQuery(std::shared_ptr<const NavGrid> grid, uint64_t generation, PathRequestId id,
+                      Math::Vector3 start, Math::Vector3 goal);
+    static uint64_t PathCacheKey(uint32_t startCell, uint32_t goalCell) {
+        return (static_cast<uint64_t>(startCell) << 32) | goalCell;
+    }
+
+    uint64_t m_Frame = ~uint64_t(0);
+    Scene* m_Scene = nullptr;
+    uint64_t m_Generation = 0;
+    std::shared_ptr<const NavGrid> m_Grid;
+    std::unique_ptr<NavGrid> m_Baking;
+    uint32_t m_BakeRow = 0;
+
+    // Guards the cooked load hand-off, the path requests and the cache.
+    std::mutex m_Mutex;
+    std::shared_ptr<const NavGrid> m_LoadedGrid;
+    bool m_CookedLoadFailed = false;
+    PathRequestId m_NextRequestId = 1;
+    std::unordered_map<PathRequestId, PathRequest> m_Requests;
+    std::unordered_map<uint64_t, CachedPath> m_PathCache;
+    std::deque<uint64_t> m_PathCacheOrder;
+
+    NavCrowd m_Crowd;
+    NavCrowd::Settings m_CrowdSettings;
+    std::unordered_map<const void*, uint32_t> m_CrowdIndices;
+    std::unordered_map<const void*, Math::Vector3> m_CrowdVelocities;
+};
+
+} // namespace Crescent
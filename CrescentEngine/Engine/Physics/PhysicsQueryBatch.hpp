@@ -0,0 +1,113 @@
+#pragma once
+
+#include "PhysicsTypes.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Crescent {
+
+enum class PhysicsQueryType : uint8_t {
+    Raycast,
+    SphereCast,
+    BoxCast,
+    CapsuleCast,
+    OverlapSphere,
+    OverlapBox
+};
+constexpr size_t kPhysicsQueryTypeCount = 6;
+
+// One scene query of a batch, with the parameters of the matching PhysicsWorld call. Casts
+// report the closest hit unless allHits is set, in which case every hit comes back sorted by
+// distance.
+struct PhysicsQuery {
+    PhysicsQueryType type = PhysicsQueryType::Raycast;
+    // Ray origin or shape center.
+    Math::Vector3 origin = Math::Vector3::Zero;
+    Math::Vector3 direction = Math::Vector3::Forward;
+    Math::Vector3 halfExtents = Math::Vector3::Zero;
+    float radius = 0.0f;
+    float height = 0.0f;
+    float maxDistance = 0.0f;
+    uint32_t layerMask = 0xFFFFFFFFu;
+    bool includeTriggers = true;
+    bool allHits = false;
+    const Entity* ignore = nullptr;
+};
+
+// Queries gathered over a frame and run together by PhysicsWorld::runQueries, which spreads them
+// over the job system. Hits land in two flat buffers, casts and overlaps, with each query's hits
+// contiguous and in query order. Keep the batch around: its buffers are reused.
+class PhysicsQueryBatch {
+public:
+    void clear() {
+        m_Queries.clear();
+        m_Ranges.clear();
+        m_CastHits.clear();
+        m_OverlapHits.clear();
+    }
+
+    // Returns the query's index in the batch.
+    uint32_t add(const PhysicsQuery& query) {
+        m_Queries.push_back(query);
+        return static_cast<uint32_t>(m_Queries.size() - 1);
+    }
+    uint32_t addRaycast(const Math::Vector3& origin, const Math::Vector3& direction, float maxDistance,
+                        uint32_t layerMask, bool includeTriggers, const Entity* ignore, bool allHits = false) {
+        PhysicsQuery query;
+        query.type = PhysicsQueryType::Raycast;
+        query.origin = origin;
+        query.direction = direction;
+        query.maxDistance = maxDistance;
+        query.layerMask = layerMask;
+        query.includeTriggers = includeTriggers;
+        query.ignore = ignore;
+        query.allHits = allHits;
+        return add(query);
+    }
+    uint32_t addOverlapSphere(const Math::Vector3& center, float radius,
+                              uint32_t layerMask, bool includeTriggers, const Entity* ignore) {
+        PhysicsQuery query;
+        query.type = PhysicsQueryType::OverlapSphere;
+        query.origin = center;
+        query.radius = radius;
+        query.layerMask = layerMask;
+        query.includeTriggers = includeTriggers;
+        query.ignore = ignore;
+        return add(query);
+    }
+
+    size_t size() const { return m_Queries.size(); }
+    bool empty() const { return m_Queries.empty(); }
+    const PhysicsQuery& getQuery(uint32_t index) const { return m_Queries[index]; }
+
+    // Results, valid after runQueries until the next clear. Casts fill the cast hits, overlaps the
+    // overlap hits.
+    uint32_t getHitCount(uint32_t index) const { return index < m_Ranges.size() ? m_Ranges[index].count : 0; }
+    const PhysicsRaycastHit* getCastHits(uint32_t index) const { return m_CastHits.data() + m_Ranges[index].first; }
+    const PhysicsOverlapHit* getOverlapHits(uint32_t index) const { return m_OverlapHits.data() + m_Ranges[index].first; }
+
+private:
+    friend class PhysicsWorld;
+
+    struct HitRange {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    // Hits of one job, for a run of consecutive queries; the ranges it writes are local to it
+    // until the merge.
+    struct JobHits {
+        std::vector<PhysicsRaycastHit> castHits;
+        std::vector<PhysicsOverlapHit> overlapHits;
+        std::vector<PhysicsRaycastHit> castScratch;
+        std::vector<PhysicsOverlapHit> overlapScratch;
+    };
+
+    std::vector<PhysicsQuery> m_Queries;
+    std::vector<HitRange> m_Ranges;
+    std::vector<PhysicsRaycastHit> m_CastHits;
+    std::vector<PhysicsOverlapHit> m_OverlapHits;
+    std::vector<JobHits> m_JobHits;
+};
+
+} // namespace Crescent
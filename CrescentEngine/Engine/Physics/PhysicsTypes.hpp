@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Math/Math.hpp"
+#include <cstdint>
 
 namespace Crescent {
 
@@ -31,4 +32,36 @@ struct PhysicsContact {
     bool isTrigger = false;
 };
 
+// Shape and movement limits of a PhysicsWorld character: an upright capsule of the given total
+// height, centered on the entity's position.
+struct PhysicsCharacterSettings {
+    float radius = 0.5f;
+    float height = 2.0f;
+    // Gap kept between the capsule and what it touches.
+    float padding = 0.02f;
+    // Steepest ground that still counts as floor.
+    float maxSlopeDegrees = 50.0f;
+    // Highest stair step walked onto; 0 disables stepping.
+    float stepHeight = 0.4f;
+    // How far the character is pulled down to stay on sloped or stepped ground; 0 disables it.
+    float stickToFloorDistance = 0.1f;
+    // Downward acceleration pressing the character onto what it stands on.
+    float gravity = 20.0f;
+    uint32_t layerMask = 0xFFFFFFFFu;
+};
+
+// Where a character ended up after its last move.
+struct PhysicsCharacterState {
+    Math::Vector3 position = Math::Vector3::Zero;
+    // Actual displacement of the last move over its time step.
+    Math::Vector3 velocity = Math::Vector3::Zero;
+    Math::Vector3 groundNormal = Math::Vector3::Up;
+    // Standing on walkable ground.
+    bool grounded = false;
+    // Touching ground steeper than the slope limit, with nothing walkable below.
+    bool onSteepGround = false;
+    // The height the capsule has; lags the requested one while there is no room to grow.
+    float height = 0.0f;
+};
+
 } // namespace Crescent
@@ -14,12 +14,19 @@
 #include "../Components/Rigidbody.hpp"
 #include "../Components/PhysicsCollider.hpp"
 #include "../Components/MeshRenderer.hpp"
+#include "../Core/CPUProfiler.hpp"
+#include "../Core/JobScheduler.hpp"
+#include "../Core/MemoryTracker.hpp"
+#include "../Core/StartupTrace.hpp"
+#include "../Project/Project.hpp"
+#include "TerrainHeightField.hpp"
 
 #include <Jolt/Core/Factory.h>
 #include <Jolt/Core/Memory.h>
 #include <Jolt/RegisterTypes.h>
 #include <Jolt/Core/TempAllocator.h>
-#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
 #include <Jolt/Physics/PhysicsSystem.h>
 #include <Jolt/Physics/Collision/ObjectLayer.h>
 #include <Jolt/Physics/Collision/CollisionGroup.h>
@@ -35,17 +42,27 @@
 #include <Jolt/Physics/Collision/Shape/CapsuleShape.h>
 #include <Jolt/Physics/Collision/Shape/ConvexHullShape.h>
 #include <Jolt/Physics/Collision/Shape/MeshShape.h>
+#include <Jolt/Physics/Collision/Shape/HeightFieldShape.h>
 #include <Jolt/Physics/Collision/Shape/RotatedTranslatedShape.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Body/BodyInterface.h>
 #include <Jolt/Physics/Body/Body.h>
 #include <Jolt/Physics/Body/BodyLock.h>
+#include <Jolt/Physics/Character/CharacterVirtual.h>
 #include <Jolt/Core/HashCombine.h>
+#include <Jolt/Core/StreamWrapper.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cctype>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <sstream>
 #include <mutex>
 #include <thread>
 
@@ -55,6 +72,77 @@ namespace {
 static bool g_JoltInitialized = false;
 static int g_JoltRefCount = 0;
 
+// Jolt's heap, counted under MemoryCategory::Physics.
+void* JoltAllocate(size_t size) {
+    return MemoryTracker::allocate(MemoryCategory::Physics, size);
+}
+
+void* JoltReallocate(void* block, size_t /*oldSize*/, size_t newSize) {
+    return MemoryTracker::reallocate(MemoryCategory::Physics, block, newSize);
+}
+
+void JoltFree(void* block) {
+    MemoryTracker::release(MemoryCategory::Physics, block);
+}
+
+void* JoltAlignedAllocate(size_t size, size_t alignment) {
+    return MemoryTracker::allocateAligned(MemoryCategory::Physics, size, alignment);
+}
+
+void JoltAlignedFree(void* block) {
+    MemoryTracker::releaseAligned(MemoryCategory::Physics, block);
+}
+
+void RegisterTrackedJoltAllocator() {
+    JPH::Allocate = JoltAllocate;
+    JPH::Reallocate = JoltReallocate;
+    JPH::Free = JoltFree;
+    JPH::AlignedAllocate = JoltAlignedAllocate;
+    JPH::AlignedFree = JoltAlignedFree;
+}
+
+// Rebuild batches at least this large, a scene load or a streamed cell, create all their bodies
+// first and insert them in bulk. A few rebuilds from edits go in one by one.
+constexpr size_t kBulkAddBatch = 16;
+// Terrain tiles share their edge samples, so 64 samples cover 63 quads per side.
+constexpr uint32_t kTerrainTileSamples = 64;
+// Tile bodies paged in per update, so crossing into new terrain spreads over a few frames.
+constexpr size_t kMaxTerrainTilesPerUpdate = 4;
+
+// Identifies a collider shape by everything buildShape reads: the collider parameters, the
+// entity's scale and, for mesh colliders, the mesh and its transform into the collider. Scenes
+// full of identical props then share one shape.
+struct ShapeCacheKey {
+    uint32_t type = 0;
+    bool convexHull = false;
+    float params[14] = {};
+    const Mesh* mesh = nullptr;
+    float meshTransform[16] = {};
+
+    bool operator==(const ShapeCacheKey& other) const {
+        return type == other.type && convexHull == other.convexHull && mesh == other.mesh &&
+               std::memcmp(params, other.params, sizeof(params)) == 0 &&
+               std::memcmp(meshTransform, other.meshTransform, sizeof(meshTransform)) == 0;
+    }
+};
+
+struct ShapeCacheKeyHash {
+    size_t operator()(const ShapeCacheKey& key) const {
+        uint64_t hash = JPH::HashBytes(key.params, sizeof(key.params));
+        hash = JPH::HashBytes(key.meshTransform, sizeof(key.meshTransform), hash);
+        return static_cast<size_t>(JPH::HashCombineArgs(hash,
+                                                        static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key.mesh)),
+                                                        key.type,
+                                                        static_cast<uint32_t>(key.convexHull)));
+    }
+};
+
+struct ShapeCacheEntry {
+    JPH::RefConst<JPH::Shape> shape;
+    // Guards against a new mesh reusing a freed one's address.
+    std::weak_ptr<const Mesh> mesh;
+};
+
 namespace Layers {
     static constexpr JPH::ObjectLayer NonMoving = 0;
     static constexpr JPH::ObjectLayer Moving = 1;
@@ -335,6 +423,98 @@ bool ComputeMeshBounds(const Mesh& mesh,
     return true;
 }
 
+constexpr size_t kMaxHullPoints = 1024;
+
+// The collider shape of a mesh: a static mesh shape, or a convex hull for bodies that move. Null
+// when the mesh has no CPU geometry or Jolt rejects it.
+JPH::RefConst<JPH::Shape> BuildMeshColliderShape(const Mesh& mesh,
+                                                 const Math::Matrix4x4& transform,
+                                                 bool convex) {
+    if (!convex) {
+        JPH::VertexList vertices;
+        JPH::IndexedTriangleList indexedTriangles;
+        if (BuildMeshIndexed(mesh, transform, vertices, indexedTriangles)) {
+            JPH::MeshShapeSettings settings(std::move(vertices), std::move(indexedTriangles));
+            auto result = settings.Create();
+            if (result.HasError()) {
+                std::cout << "[Physics] Mesh collider error: "
+                          << result.GetError() << std::endl;
+                return nullptr;
+            }
+            return result.Get();
+        }
+        JPH::TriangleList triangles;
+        if (BuildMeshTriangles(mesh, transform, triangles)) {
+            JPH::MeshShapeSettings settings(triangles);
+            auto result = settings.Create();
+            if (result.HasError()) {
+                std::cout << "[Physics] Mesh collider error: "
+                          << result.GetError() << std::endl;
+                return nullptr;
+            }
+            return result.Get();
+        }
+        return nullptr;
+    }
+
+    std::vector<JPH::Vec3> points;
+    if (!BuildConvexPoints(mesh, transform, points, kMaxHullPoints)) {
+        return nullptr;
+    }
+    JPH::ConvexHullShapeSettings settings(points.data(),
+                                          static_cast<int>(points.size()),
+                                          JPH::cDefaultConvexRadius);
+    auto result = settings.Create();
+    if (result.HasError()) {
+        std::cout << "[Physics] Convex hull collider error: "
+                  << result.GetError() << std::endl;
+        return nullptr;
+    }
+    return result.Get();
+}
+
+// Cooked shape files: this header, then the shape as Shape::SaveWithChildren writes it. Jolt's
+// binary state is tied to its version, so that is part of the header and a mismatch rebuilds.
+constexpr uint32_t kCookedShapeMagic = 0x4853434Au; // "JCSH"
+constexpr uint32_t kCookedShapeVersion = 1;
+constexpr uint32_t kCookedShapeJoltVersion = (JPH_VERSION_MAJOR << 16) | (JPH_VERSION_MINOR << 8) | JPH_VERSION_PATCH;
+
+struct CookedShapeHeader {
+    uint32_t magic = kCookedShapeMagic;
+    uint32_t version = kCookedShapeVersion;
+    uint32_t joltVersion = kCookedShapeJoltVersion;
+};
+
+JPH::RefConst<JPH::Shape> RestoreCookedShape(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    CookedShapeHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != kCookedShapeMagic || header.version != kCookedShapeVersion ||
+        header.joltVersion != kCookedShapeJoltVersion) {
+        return nullptr;
+    }
+    JPH::StreamInWrapper stream(in);
+    JPH::Shape::IDToShapeMap shapeMap;
+    JPH::Shape::IDToMaterialMap materialMap;
+    auto result = JPH::Shape::sRestoreWithChildren(stream, shapeMap, materialMap);
+    if (result.HasError()) {
+        std::cout << "[Physics] Cooked shape error in " << path << ": " << result.GetError() << std::endl;
+        return nullptr;
+    }
+    return result.Get();
+}
+
+// The cook bakes the transform in; scenes loaded as cooked reproduce it up to float noise.
+bool MatchesCookedTransform(const Math::Matrix4x4& a, const Math::Matrix4x4& b) {
+    constexpr float kTolerance = 1e-4f;
+    for (int i = 0; i < 16; ++i) {
+        if (std::abs(a.m[i] - b.m[i]) > kTolerance * std::max(1.0f, std::abs(a.m[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
 struct BodyPairKey {
     JPH::BodyID body1;
     JPH::BodyID body2;
@@ -344,13 +524,6 @@ struct BodyPairKey {
     }
 };
 
-struct BodyPairKeyHash {
-    size_t operator()(const BodyPairKey& key) const {
-        return static_cast<size_t>(JPH::HashCombineArgs(key.body1.GetIndexAndSequenceNumber(),
-                                                        key.body2.GetIndexAndSequenceNumber()));
-    }
-};
-
 inline BodyPairKey MakeBodyPairKey(const JPH::BodyID& a, const JPH::BodyID& b) {
     if (a < b) {
         return {a, b};
@@ -358,6 +531,125 @@ inline BodyPairKey MakeBodyPairKey(const JPH::BodyID& a, const JPH::BodyID& b) {
     return {b, a};
 }
 
+inline uint64_t PackBodyPair(const BodyPairKey& key) {
+    return (static_cast<uint64_t>(key.body1.GetIndexAndSequenceNumber()) << 32) |
+           key.body2.GetIndexAndSequenceNumber();
+}
+
+// Open-addressing map from a packed body pair to a small value: linear probing, backward-shift
+// deletion, power-of-two capacity. Contact bookkeeping hits it for every event of a step, so it
+// avoids the per-node allocation of std::unordered_map.
+class ContactPairTable {
+public:
+    uint8_t* find(uint64_t key) {
+        if (m_Count == 0) {
+            return nullptr;
+        }
+        for (size_t i = slotOf(key);; i = (i + 1) & mask()) {
+            if (m_Slots[i].key == key) {
+                return &m_Slots[i].value;
+            }
+            if (m_Slots[i].key == kEmpty) {
+                return nullptr;
+            }
+        }
+    }
+
+    // Inserts the key with a zero value when missing.
+    uint8_t& operator[](uint64_t key) {
+        if ((m_Count + 1) * 4 > m_Slots.size() * 3) {
+            grow();
+        }
+        size_t i = slotOf(key);
+        while (m_Slots[i].key != kEmpty && m_Slots[i].key != key) {
+            i = (i + 1) & mask();
+        }
+        if (m_Slots[i].key == kEmpty) {
+            m_Slots[i].key = key;
+            m_Slots[i].value = 0;
+            ++m_Count;
+        }
+        return m_Slots[i].value;
+    }
+
+    bool erase(uint64_t key) {
+        if (m_Count == 0) {
+            return false;
+        }
+        size_t i = slotOf(key);
+        while (m_Slots[i].key != key) {
+            if (m_Slots[i].key == kEmpty) {
+                return false;
+            }
+            i = (i + 1) & mask();
+        }
+        // Pull later entries of the probe run back over the hole.
+        for (size_t j = (i + 1) & mask(); m_Slots[j].key != kEmpty; j = (j + 1) & mask()) {
+            const size_t home = slotOf(m_Slots[j].key);
+            if (((j - home) & mask()) >= ((j - i) & mask())) {
+                m_Slots[i] = m_Slots[j];
+                i = j;
+            }
+        }
+        m_Slots[i] = Slot{};
+        --m_Count;
+        return true;
+    }
+
+    // Drops every pair that includes the body.
+    void eraseBody(const JPH::BodyID& body) {
+        const uint32_t id = body.GetIndexAndSequenceNumber();
+        m_Scratch.clear();
+        for (const Slot& slot : m_Slots) {
+            if (slot.key != kEmpty &&
+                (static_cast<uint32_t>(slot.key >> 32) == id || static_cast<uint32_t>(slot.key) == id)) {
+                m_Scratch.push_back(slot.key);
+            }
+        }
+        for (uint64_t key : m_Scratch) {
+            erase(key);
+        }
+    }
+
+    void clear() {
+        std::fill(m_Slots.begin(), m_Slots.end(), Slot{});
+        m_Count = 0;
+    }
+
+private:
+    // Both halves of a key are valid BodyIDs, never all ones.
+    static constexpr uint64_t kEmpty = ~0ull;
+
+    struct Slot {
+        uint64_t key = kEmpty;
+        uint8_t value = 0;
+    };
+
+    size_t mask() const { return m_Slots.size() - 1; }
+    size_t slotOf(uint64_t key) const {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return static_cast<size_t>(key) & mask();
+    }
+
+    void grow() {
+        std::vector<Slot> old;
+        old.swap(m_Slots);
+        m_Slots.assign(std::max<size_t>(64, old.size() * 2), Slot{});
+        m_Count = 0;
+        for (const Slot& slot : old) {
+            if (slot.key != kEmpty) {
+                (*this)[slot.key] = slot.value;
+            }
+        }
+    }
+
+    std::vector<Slot> m_Slots;
+    std::vector<uint64_t> m_Scratch;
+    size_t m_Count = 0;
+};
+
 inline PhysicsCollider::CombineMode ResolveCombineMode(PhysicsCollider::CombineMode a,
                                                        PhysicsCollider::CombineMode b) {
     return (static_cast<int>(a) >= static_cast<int>(b)) ? a : b;
@@ -431,6 +723,73 @@ struct ContactEvent {
     ContactEventType type;
 };
 
+// Runs Jolt jobs on the engine-wide JobScheduler instead of a private JobSystemThreadPool,
+// so physics shares worker threads with the update/render/audio roles.
+class EngineJobSystem final : public JPH::JobSystemWithBarrier {
+public:
+    EngineJobSystem(JPH::uint maxJobs, JPH::uint maxBarriers)
+        : JPH::JobSystemWithBarrier(maxBarriers) {
+        m_Jobs.Init(maxJobs, maxJobs);
+        JobScheduler::getInstance().acquire();
+    }
+
+    ~EngineJobSystem() override {
+        JobScheduler::getInstance().release();
+    }
+
+    int GetMaxConcurrency() const override {
+        return static_cast<int>(JobScheduler::getInstance().workerCount()) + 1;
+    }
+
+    JobHandle CreateJob(const char* name,
+                        JPH::ColorArg color,
+                        const JPH::JobSystem::JobFunction& jobFunction,
+                        JPH::uint32 numDependencies = 0) override {
+        JPH::uint32 index;
+        for (;;) {
+            index = m_Jobs.ConstructObject(name, color, this, jobFunction, numDependencies);
+            if (index != AvailableJobs::cInvalidObjectIndex) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+        Job* job = &m_Jobs.Get(index);
+        JobHandle handle(job);
+        if (numDependencies == 0) {
+            QueueJob(job);
+        }
+        return handle;
+    }
+
+protected:
+    void QueueJob(Job* job) override {
+        job->AddRef();
+        JobScheduler::getInstance().schedule([job]() {
+            job->Execute();
+            job->Release();
+        }, nullptr);
+    }
+
+    void QueueJobs(Job** jobs, JPH::uint numJobs) override {
+        for (JPH::uint i = 0; i < numJobs; ++i) {
+            QueueJob(jobs[i]);
+        }
+    }
+
+    void FreeJob(Job* job) override {
+        m_Jobs.DestructObject(job);
+    }
+
+private:
+    using AvailableJobs = JPH::FixedSizeFreeList<Job>;
+    AvailableJobs m_Jobs;
+};
+
+// Shared by every world, editor and play copies alike, and torn down with Jolt. Each world
+// stepping at the same time holds its own barriers, hence the headroom.
+constexpr JPH::uint kSharedPhysicsBarriers = JPH::cMaxPhysicsBarriers * 4;
+EngineJobSystem* g_JobSystem = nullptr;
+
 } // namespace
 
 struct PhysicsWorld::BodyRecord {
@@ -440,10 +799,17 @@ struct PhysicsWorld::BodyRecord {
     Math::Quaternion lastRotation;
     Math::Vector3 lastScale;
     bool isSensor;
+    // The owner, cached at creation; the record goes away with its collider or rigidbody.
+    Entity* entity = nullptr;
+    Transform* transform = nullptr;
+    // Index into the interpolation buffer once the body has been simulated.
+    uint32_t interpolationSlot = UINT32_MAX;
 };
 
 class PhysicsWorld::PhysicsWorldImpl {
 public:
+    struct ContactEventBuffer;
+
     class ContactListenerImpl final : public JPH::ContactListener {
     public:
         explicit ContactListenerImpl(PhysicsWorldImpl& impl)
@@ -453,6 +819,7 @@ public:
                                               const JPH::Body& inBody2,
                                               JPH::RVec3Arg,
                                               const JPH::CollideShapeResult&) override {
+            count(&ContactEventBuffer::bodyPairs);
             const PhysicsCollider* collider1 = GetColliderFromBody(inBody1);
             const PhysicsCollider* collider2 = GetColliderFromBody(inBody2);
             if (!collider1 || !collider2) {
@@ -489,27 +856,15 @@ public:
             recordEvent(inBody1, inBody2, inManifold, ContactEventType::Stay);
         }
 
+        // Whether the pair was a trigger is only known from its Enter, so the merge after the step
+        // fills that in.
         void OnContactRemoved(const JPH::SubShapeIDPair& inSubShapePair) override {
             BodyPairKey key = MakeBodyPairKey(inSubShapePair.GetBody1ID(), inSubShapePair.GetBody2ID());
-            bool isTrigger = false;
-            {
-                std::lock_guard<std::mutex> lock(m_Impl.eventMutex);
-                auto it = m_Impl.activeContacts.find(key);
-                if (it != m_Impl.activeContacts.end()) {
-                    isTrigger = it->second;
-                    m_Impl.activeContacts.erase(it);
-                }
-            }
-
             ContactEvent event{};
             event.body1 = key.body1;
             event.body2 = key.body2;
-            event.isTrigger = isTrigger;
             event.type = ContactEventType::Exit;
-            {
-                std::lock_guard<std::mutex> lock(m_Impl.eventMutex);
-                m_Impl.pendingEvents.push_back(event);
-            }
+            pushEvent(event);
         }
 
     private:
@@ -521,6 +876,9 @@ public:
             event.body1 = body1.GetID();
             event.body2 = body2.GetID();
             event.isTrigger = body1.IsSensor() || body2.IsSensor();
+            if (!event.isTrigger) {
+                count(&ContactEventBuffer::contactManifolds);
+            }
             event.normal = ToCrescent(manifold.mWorldSpaceNormal);
             event.penetration = manifold.mPenetrationDepth;
 
@@ -536,12 +894,28 @@ public:
             }
 
             event.type = type;
-            BodyPairKey key = MakeBodyPairKey(event.body1, event.body2);
-            {
-                std::lock_guard<std::mutex> lock(m_Impl.eventMutex);
-                m_Impl.activeContacts[key] = event.isTrigger;
-                m_Impl.pendingEvents.push_back(event);
+            pushEvent(event);
+        }
+
+        // Workers append to their own buffer without a lock; threads outside the pool share slot 0.
+        void pushEvent(const ContactEvent& event) {
+            const size_t slot = JobScheduler::getInstance().currentThreadSlot();
+            if (slot != 0 && slot < m_Impl.eventBuffers.size()) {
+                m_Impl.eventBuffers[slot].events.push_back(event);
+                return;
+            }
+            std::lock_guard<std::mutex> lock(m_Impl.sharedEventMutex);
+            m_Impl.eventBuffers[0].events.push_back(event);
+        }
+
+        void count(uint32_t ContactEventBuffer::*counter) {
+            const size_t slot = JobScheduler::getInstance().currentThreadSlot();
+            if (slot != 0 && slot < m_Impl.eventBuffers.size()) {
+                ++(m_Impl.eventBuffers[slot].*counter);
+                return;
             }
+            std::lock_guard<std::mutex> lock(m_Impl.sharedEventMutex);
+            ++(m_Impl.eventBuffers[0].*counter);
         }
 
         PhysicsWorldImpl& m_Impl;
@@ -551,19 +925,102 @@ public:
     ObjectVsBroadPhaseLayerFilterImpl objectVsBroadphaseLayerFilter;
     ObjectLayerPairFilterImpl objectLayerPairFilter;
     JPH::PhysicsSystem physicsSystem;
-    std::unique_ptr<JPH::TempAllocatorImpl> tempAllocator;
-    std::unique_ptr<JPH::JobSystemThreadPool> jobSystem;
+    std::unique_ptr<JPH::TempAllocatorImplWithMallocFallback> tempAllocator;
     std::unique_ptr<ContactListenerImpl> contactListener;
-    std::mutex eventMutex;
-    std::vector<ContactEvent> pendingEvents;
-    std::unordered_map<BodyPairKey, bool, BodyPairKeyHash> activeContacts;
+    // A step's contact events, one buffer per JobScheduler thread slot (see pushEvent), merged
+    // by dispatchContactEvents.
+    struct alignas(64) ContactEventBuffer {
+        std::vector<ContactEvent> events;
+        // For the stats, reset after every step.
+        uint32_t bodyPairs = 0;
+        uint32_t contactManifolds = 0;
+    };
+    std::vector<ContactEventBuffer> eventBuffers;
+    // Queries may come from any thread, hence the atomics. Indexed by PhysicsQueryType.
+    std::array<std::atomic<uint32_t>, kPhysicsQueryTypeCount> queryCounts{};
+    uint32_t scaleRebuilds = 0;
+    void countQuery(PhysicsQueryType type) {
+        queryCounts[static_cast<size_t>(type)].fetch_add(1, std::memory_order_relaxed);
+    }
+    std::mutex sharedEventMutex;
+    std::vector<ContactEvent> mergedEvents;
+    // Touching pairs, valued 1 for triggers; only read and written between steps.
+    ContactPairTable activeContacts;
+    // Event types already dispatched per pair this step, as bits.
+    ContactPairTable dispatchedEvents;
+    // Records by BodyID index, for the active-body sync. Map nodes keep their address.
+    std::vector<BodyRecord*> recordsByBodyIndex;
+    struct DynamicWriteback {
+        Transform* transform;
+        Math::Vector3 position;
+        Math::Quaternion rotation;
+    };
+    std::vector<DynamicWriteback> dynamicWriteback;
+    // The last two simulated poses of every dynamic body that has moved, packed for the per-frame
+    // blend. step is the simulation step that last moved the body; settled ones were already
+    // written at their final pose.
+    struct InterpolatedBody {
+        BodyRecord* record;
+        Math::Vector3 previousPosition;
+        Math::Vector3 currentPosition;
+        Math::Quaternion previousRotation;
+        Math::Quaternion currentRotation;
+        uint64_t step;
+        bool settled;
+    };
+    std::vector<InterpolatedBody> interpolated;
+    uint64_t stepCount = 0;
+    struct CharacterRecord {
+        UUID entity;
+        JPH::Ref<JPH::CharacterVirtual> character;
+        // As last requested; the shape may still have the previous size (see state.height).
+        PhysicsCharacterSettings settings;
+        float shapeRadius = 0.0f;
+        float shapeHeight = 0.0f;
+        Math::Vector3 velocity = Math::Vector3::Zero;
+        float deltaTime = 0.0f;
+        bool queued = false;
+        // The entity's position when the move starts.
+        Math::Vector3 startCenter = Math::Vector3::Zero;
+        PhysicsCharacterState state;
+        Transform* transform = nullptr;
+    };
+    std::unordered_map<UUID, CharacterRecord> characters;
+    std::vector<CharacterRecord*> characterMoves;
+    // One per character job and reused every frame: a temp allocator is a stack, so it serves a
+    // single thread at a time.
+    std::vector<std::unique_ptr<JPH::TempAllocator>> characterAllocators;
+    struct TerrainTile {
+        // Invalid while the tile is paged out.
+        JPH::BodyID id;
+        uint32_t firstColumn = 0;
+        uint32_t firstRow = 0;
+        // Bounding sphere in the entity's unrotated space.
+        Math::Vector3 center = Math::Vector3::Zero;
+        float radius = 0.0f;
+    };
+    struct TerrainRecord {
+        Entity* entity = nullptr;
+        Transform* transform = nullptr;
+        TerrainHeightField field;
+        Math::Vector3 scale = Math::Vector3::One;
+        Math::Vector3 colliderCenter = Math::Vector3::Zero;
+        Math::Vector3 lastPosition = Math::Vector3::Zero;
+        Math::Quaternion lastRotation = Math::Quaternion::Identity;
+        std::vector<TerrainTile> tiles;
+    };
+    std::unordered_map<UUID, TerrainRecord> terrains;
+    bool hasStreamingFocus = false;
+    Math::Vector3 streamingFocus = Math::Vector3::Zero;
+    float streamingLoadRadius = 0.0f;
+    float streamingUnloadRadius = 0.0f;
+    std::unordered_map<ShapeCacheKey, ShapeCacheEntry, ShapeCacheKeyHash> shapeCache;
 };
 
 PhysicsWorld::PhysicsWorld(Scene* scene)
     : m_Scene(scene)
     , m_Gravity(0.0f, -9.81f, 0.0f)
     , m_FixedTimeStep(1.0f / 60.0f)
-    , m_TimeAccumulator(0.0f)
     , m_DebugDraw(false)
     , m_Initialized(false) {
 }
@@ -578,31 +1035,33 @@ bool PhysicsWorld::initialize() {
     }
 
     if (!g_JoltInitialized) {
-        JPH::RegisterDefaultAllocator();
+        RegisterTrackedJoltAllocator();
         JPH::Factory::sInstance = new JPH::Factory();
         JPH::RegisterTypes();
+        g_JobSystem = new EngineJobSystem(JPH::cMaxPhysicsJobs, kSharedPhysicsBarriers);
         g_JoltInitialized = true;
     }
     g_JoltRefCount++;
 
+    ProjectSettings::PhysicsSettings limits;
+    if (auto project = ProjectManager::getInstance().getActiveProject()) {
+        limits = project->getSettings().physics;
+    }
+
+    setFixedTimeStep(limits.fixedTimeStep);
+
     m_Impl = std::make_unique<PhysicsWorldImpl>();
-    m_Impl->tempAllocator = std::make_unique<JPH::TempAllocatorImpl>(10 * 1024 * 1024);
-    uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
-    uint32_t workerCount = (threadCount > 1) ? (threadCount - 1) : 1;
-    m_Impl->jobSystem = std::make_unique<JPH::JobSystemThreadPool>(
-        JPH::cMaxPhysicsJobs,
-        JPH::cMaxPhysicsBarriers,
-        workerCount
-    );
-
-    const uint32_t maxBodies = 65536;
+    m_Impl->tempAllocator = std::make_unique<JPH::TempAllocatorImplWithMallocFallback>(
+        std::max(limits.tempAllocatorMB, 1u) * 1024u * 1024u);
+
     const uint32_t numBodyMutexes = 0;
-    const uint32_t maxBodyPairs = 65536;
-    const uint32_t maxContactConstraints = 10240;
-    m_Impl->physicsSystem.Init(maxBodies,
+    m_Stats = PhysicsStats{};
+    m_Stats.maxBodyPairs = std::max(limits.maxBodyPairs, 1u);
+    m_Stats.maxContactConstraints = std::max(limits.maxContactConstraints, 1u);
+    m_Impl->physicsSystem.Init(std::max(limits.maxBodies, 1u),
                                numBodyMutexes,
-                               maxBodyPairs,
-                               maxContactConstraints,
+                               std::max(limits.maxBodyPairs, 1u),
+                               std::max(limits.maxContactConstraints, 1u),
                                m_Impl->broadphaseLayerInterface,
                                m_Impl->objectVsBroadphaseLayerFilter,
                                m_Impl->objectLayerPairFilter);
@@ -617,12 +1076,8 @@ bool PhysicsWorld::initialize() {
     m_DebugDraw = false;
     m_Pending.clear();
     m_Bodies.clear();
-    {
-        std::lock_guard<std::mutex> lock(m_Impl->eventMutex);
-        m_Impl->pendingEvents.clear();
-        m_Impl->activeContacts.clear();
-    }
-    m_TimeAccumulator = 0.0f;
+    m_Impl->eventBuffers.resize(1);
+    m_Impl->activeContacts.clear();
 
     return true;
 }
@@ -634,58 +1089,130 @@ void PhysicsWorld::shutdown() {
 
     if (m_Impl) {
         JPH::BodyInterface& bodyInterface = m_Impl->physicsSystem.GetBodyInterface();
+        while (!m_Impl->terrains.empty()) {
+            removeTerrain(m_Impl->terrains.begin()->first);
+        }
         for (auto& entry : m_Bodies) {
             bodyInterface.RemoveBody(entry.second.id);
             bodyInterface.DestroyBody(entry.second.id);
         }
         m_Bodies.clear();
+        m_Impl->characterMoves.clear();
+        m_Impl->characters.clear();
+        m_Impl->recordsByBodyIndex.clear();
+        m_Impl->interpolated.clear();
+        m_Impl->shapeCache.clear();
         m_Pending.clear();
         m_Impl->physicsSystem.SetContactListener(nullptr);
         m_Impl->contactListener.reset();
-        {
-            std::lock_guard<std::mutex> lock(m_Impl->eventMutex);
-            m_Impl->pendingEvents.clear();
-            m_Impl->activeContacts.clear();
-        }
+        m_Impl->eventBuffers.clear();
+        m_Impl->activeContacts.clear();
     }
 
+    // The world goes before the shared job system and Jolt's type registry it was built on.
+    m_Impl.reset();
+    m_Initialized = false;
+
     if (--g_JoltRefCount == 0) {
+        delete g_JobSystem;
+        g_JobSystem = nullptr;
         JPH::UnregisterTypes();
         delete JPH::Factory::sInstance;
         JPH::Factory::sInstance = nullptr;
         g_JoltInitialized = false;
     }
-
-    m_Impl.reset();
-    m_Initialized = false;
 }
 
 void PhysicsWorld::update(float deltaTime, bool simulate) {
     if (!m_Initialized) {
         return;
     }
+    CRESCENT_PROFILE_SCOPE("PhysicsWorld::update");
 
     if (!m_Impl) {
         return;
     }
 
     flushPending();
+    pageTerrainTiles();
+    auto takeQueries = [this](PhysicsQueryType type) {
+        return m_Impl->queryCounts[static_cast<size_t>(type)].exchange(0, std::memory_order_relaxed);
+    };
+    m_Stats.raycasts = takeQueries(PhysicsQueryType::Raycast);
+    m_Stats.sphereCasts = takeQueries(PhysicsQueryType::SphereCast);
+    m_Stats.boxCasts = takeQueries(PhysicsQueryType::BoxCast);
+    m_Stats.capsuleCasts = takeQueries(PhysicsQueryType::CapsuleCast);
+    m_Stats.overlapSpheres = takeQueries(PhysicsQueryType::OverlapSphere);
+    m_Stats.overlapBoxes = takeQueries(PhysicsQueryType::OverlapBox);
+    // Rebuilds are queued by the syncs below and counted at the next update.
+    m_Stats.scaleRebuilds = m_Impl->scaleRebuilds;
+    m_Impl->scaleRebuilds = 0;
     if (!simulate) {
         syncEditorBodies();
         return;
     }
+    if (deltaTime <= 0.0f) {
+        return;
+    }
     syncKinematicBodies();
+    // One contact buffer per thread that can run a Jolt job; sized before the step since the
+    // listener never grows it.
+    const size_t eventSlots = JobScheduler::getInstance().workerCount() + 1;
+    if (m_Impl->eventBuffers.size() < eventSlots) {
+        m_Impl->eventBuffers.resize(eventSlots);
+    }
+    const auto stepStart = std::chrono::steady_clock::now();
+    const int collisionSteps = 1;
+    m_Impl->physicsSystem.Update(deltaTime, collisionSteps, m_Impl->tempAllocator.get(), g_JobSystem);
+    m_Stats.stepTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - stepStart).count();
+    m_Stats.collisionSteps = collisionSteps;
+    m_Stats.bodies = m_Impl->physicsSystem.GetNumBodies();
+    m_Stats.activeBodies = m_Impl->physicsSystem.GetNumActiveBodies(JPH::EBodyType::RigidBody);
+    m_Stats.broadphasePairs = 0;
+    m_Stats.contactConstraints = 0;
+    for (auto& buffer : m_Impl->eventBuffers) {
+        m_Stats.broadphasePairs += buffer.bodyPairs;
+        m_Stats.contactConstraints += buffer.contactManifolds;
+        buffer.bodyPairs = 0;
+        buffer.contactManifolds = 0;
+    }
+    ++m_Impl->stepCount;
+    syncDynamicBodies();
+    dispatchContactEvents();
+}
 
-    m_TimeAccumulator += deltaTime;
-    int steps = 0;
-    while (m_TimeAccumulator >= m_FixedTimeStep && steps < 4) {
-        m_Impl->physicsSystem.Update(m_FixedTimeStep, 1, m_Impl->tempAllocator.get(), m_Impl->jobSystem.get());
-        m_TimeAccumulator -= m_FixedTimeStep;
-        steps++;
+void PhysicsWorld::interpolateBodies(float alpha) {
+    if (!m_Initialized || !m_Impl) {
+        return;
+    }
+    alpha = std::clamp(alpha, 0.0f, 1.0f);
+    auto& writeback = m_Impl->dynamicWriteback;
+    writeback.clear();
+    for (auto& body : m_Impl->interpolated) {
+        if (body.step == m_Impl->stepCount) {
+            writeback.push_back({body.record->transform,
+                                 Math::Vector3::Lerp(body.previousPosition, body.currentPosition, alpha),
+                                 Math::Quaternion::Slerp(body.previousRotation, body.currentRotation, alpha)});
+            body.settled = false;
+        } else if (!body.settled) {
+            // Asleep since the last step: land on the final pose once.
+            writeback.push_back({body.record->transform, body.currentPosition, body.currentRotation});
+            body.settled = true;
+        }
     }
 
-    syncDynamicBodies();
-    dispatchContactEvents();
+    // Root transforms take the pose as is; parented ones go second so a dynamic parent already
+    // holds its new pose when the child is brought into its space.
+    for (const auto& entry : writeback) {
+        if (!entry.transform->getParent()) {
+            entry.transform->setPositionAndRotation(entry.position, entry.rotation);
+        }
+    }
+    for (const auto& entry : writeback) {
+        if (entry.transform->getParent()) {
+            entry.transform->setPositionAndRotation(entry.position, entry.rotation);
+        }
+    }
 }
 
 void PhysicsWorld::setGravity(const Math::Vector3& gravity) {
@@ -705,10 +1232,20 @@ void PhysicsWorld::queueBodyRebuild(Entity* entity) {
     m_Pending.insert(entity->getUUID());
 }
 
+void PhysicsWorld::createPendingBodies() {
+    if (!m_Initialized) {
+        return;
+    }
+    flushPending();
+}
+
 void PhysicsWorld::removeBody(Entity* entity) {
     if (!entity || !m_Initialized) {
         return;
     }
+    if (m_Impl) {
+        removeTerrain(entity->getUUID());
+    }
     auto it = m_Bodies.find(entity->getUUID());
     if (it == m_Bodies.end()) {
         return;
@@ -719,19 +1256,282 @@ void PhysicsWorld::removeBody(Entity* entity) {
     }
     JPH::BodyInterface& bodyInterface = m_Impl->physicsSystem.GetBodyInterface();
     JPH::BodyID bodyID = it->second.id;
+    if (bodyID.GetIndex() < m_Impl->recordsByBodyIndex.size()) {
+        m_Impl->recordsByBodyIndex[bodyID.GetIndex()] = nullptr;
+    }
+    releaseInterpolationSlot(it->second);
     bodyInterface.RemoveBody(it->second.id);
     bodyInterface.DestroyBody(it->second.id);
-    {
-        std::lock_guard<std::mutex> lock(m_Impl->eventMutex);
-        for (auto pairIt = m_Impl->activeContacts.begin(); pairIt != m_Impl->activeContacts.end(); ) {
-            if (pairIt->first.body1 == bodyID || pairIt->first.body2 == bodyID) {
-                pairIt = m_Impl->activeContacts.erase(pairIt);
-            } else {
-                ++pairIt;
+    m_Impl->activeContacts.eraseBody(bodyID);
+    m_Bodies.erase(it);
+}
+
+void PhysicsWorld::removeAllBodies() {
+    m_Pending.clear();
+    if (!m_Initialized || !m_Impl) {
+        m_Bodies.clear();
+        return;
+    }
+    JPH::BodyInterface& bodyInterface = m_Impl->physicsSystem.GetBodyInterface();
+    std::vector<JPH::BodyID> ids;
+    ids.reserve(m_Bodies.size());
+    for (const auto& entry : m_Bodies) {
+        ids.push_back(entry.second.id);
+    }
+    for (const auto& [uuid, terrain] : m_Impl->terrains) {
+        for (const auto& tile : terrain.tiles) {
+            if (!tile.id.IsInvalid()) {
+                ids.push_back(tile.id);
             }
         }
     }
-    m_Bodies.erase(it);
+    // Bodies waiting on a rebuild were created but never added.
+    std::vector<JPH::BodyID> added;
+    added.reserve(ids.size());
+    for (const JPH::BodyID& id : ids) {
+        if (bodyInterface.IsAdded(id)) {
+            added.push_back(id);
+        }
+    }
+    if (!added.empty()) {
+        bodyInterface.RemoveBodies(added.data(), static_cast<int>(added.size()));
+    }
+    if (!ids.empty()) {
+        bodyInterface.DestroyBodies(ids.data(), static_cast<int>(ids.size()));
+    }
+    m_Bodies.clear();
+    m_Impl->terrains.clear();
+    m_Impl->characterMoves.clear();
+    m_Impl->characters.clear();
+    std::fill(m_Impl->recordsByBodyIndex.begin(), m_Impl->recordsByBodyIndex.end(), nullptr);
+    m_Impl->interpolated.clear();
+    m_Impl->activeContacts.clear();
+}
+
+void PhysicsWorld::setStreamingFocus(const Math::Vector3& focus, float loadRadius, float unloadRadius) {
+    if (!m_Impl) {
+        return;
+    }
+    m_Impl->hasStreamingFocus = true;
+    m_Impl->streamingFocus = focus;
+    m_Impl->streamingLoadRadius = std::max(loadRadius, 0.0f);
+    m_Impl->streamingUnloadRadius = std::max(unloadRadius, m_Impl->streamingLoadRadius);
+}
+
+bool PhysicsWorld::createTerrain(Entity* entity, const PhysicsCollider& collider) {
+    Transform* transform = entity->getTransform();
+    if (!transform) {
+        return false;
+    }
+    PhysicsWorldImpl::TerrainRecord record;
+    const std::string& cookedPath = collider.getCookedHeightFieldPath();
+    if (cookedPath.empty() || !LoadTerrainHeightField(cookedPath, record.field)) {
+        MeshRenderer* renderer = FindMeshRendererForCollider(entity);
+        Math::Matrix4x4 meshTransform;
+        if (!renderer || !renderer->getMesh() || !BuildMeshTransform(entity, renderer, meshTransform) ||
+            !BuildTerrainHeightField(*renderer->getMesh(), meshTransform, record.field)) {
+            return false;
+        }
+        renderer->getMesh()->releaseCpuData();
+    }
+
+    const Math::Vector3 scale = transform->getScale();
+    record.entity = entity;
+    record.transform = transform;
+    record.scale = Math::Vector3(std::abs(scale.x), std::abs(scale.y), std::abs(scale.z));
+    record.colliderCenter = collider.getCenter();
+    record.lastPosition = transform->getPosition();
+    record.lastRotation = transform->getRotation();
+
+    const TerrainHeightField& field = record.field;
+    const uint32_t quadsPerTile = kTerrainTileSamples - 1;
+    const uint32_t tilesPerSide = (field.sampleCount - 1 + quadsPerTile - 1) / quadsPerTile;
+    record.tiles.reserve(static_cast<size_t>(tilesPerSide) * tilesPerSide);
+    for (uint32_t tileRow = 0; tileRow < tilesPerSide; ++tileRow) {
+        for (uint32_t tileColumn = 0; tileColumn < tilesPerSide; ++tileColumn) {
+            PhysicsWorldImpl::TerrainTile tile;
+            tile.firstColumn = tileColumn * quadsPerTile;
+            tile.firstRow = tileRow * quadsPerTile;
+            const uint32_t lastColumn = std::min(tile.firstColumn + quadsPerTile, field.sampleCount - 1);
+            const uint32_t lastRow = std::min(tile.firstRow + quadsPerTile, field.sampleCount - 1);
+            float minHeight = std::numeric_limits<float>::max();
+            float maxHeight = -std::numeric_limits<float>::max();
+            for (uint32_t row = tile.firstRow; row <= lastRow; ++row) {
+                for (uint32_t column = tile.firstColumn; column <= lastColumn; ++column) {
+                    const float height = field.heights[static_cast<size_t>(row) * field.sampleCount + column];
+                    minHeight = std::min(minHeight, height);
+                    maxHeight = std::max(maxHeight, height);
+                }
+            }
+            const Math::Vector3 tileMin(field.origin.x + tile.firstColumn * field.spacingX,
+                                        field.origin.y + minHeight,
+                                        field.origin.z + tile.firstRow * field.spacingZ);
+            const Math::Vector3 tileMax(field.origin.x + lastColumn * field.spacingX,
+                                        field.origin.y + maxHeight,
+                                        field.origin.z + lastRow * field.spacingZ);
+            const Math::Vector3 scaledMin(tileMin.x * record.scale.x, tileMin.y * record.scale.y, tileMin.z * record.scale.z);
+            const Math::Vector3 scaledMax(tileMax.x * record.scale.x, tileMax.y * record.scale.y, tileMax.z * record.scale.z);
+            tile.center = (scaledMin + scaledMax) * 0.5f + record.colliderCenter;
+            tile.radius = (scaledMax - scaledMin).length() * 0.5f;
+            record.tiles.push_back(tile);
+        }
+    }
+    m_Impl->terrains[entity->getUUID()] = std::move(record);
+    return true;
+}
+
+void PhysicsWorld::removeTerrain(const UUID& uuid) {
+    auto it = m_Impl->terrains.find(uuid);
+    if (it == m_Impl->terrains.end()) {
+        return;
+    }
+    JPH::BodyInterface& bodyInterface = m_Impl->physicsSystem.GetBodyInterface();
+    for (const auto& tile : it->second.tiles) {
+        if (tile.id.IsInvalid()) {
+            continue;
+        }
+        bodyInterface.RemoveBody(tile.id);
+        bodyInterface.DestroyBody(tile.id);
+        m_Impl->activeContacts.eraseBody(tile.id);
+    }
+    m_Impl->terrains.erase(it);
+}
+
+void PhysicsWorld::pageTerrainTiles() {
+    if (m_Impl->terrains.empty()) {
+        return;
+    }
+    JPH::BodyInterface& bodyInterface = m_Impl->physicsSystem.GetBodyInterface();
+    const bool hasFocus = m_Impl->hasStreamingFocus;
+    const Math::Vector3 focus = m_Impl->streamingFocus;
+
+    struct TilePageIn {
+        float distance;
+        PhysicsWorldImpl::TerrainRecord* terrain;
+        PhysicsWorldImpl::TerrainTile* tile;
+    };
+    std::vector<TilePageIn> pageIns;
+    std::vector<Entity*> rebuilds;
+    for (auto& entry : m_Impl->terrains) {
+        PhysicsWorldImpl::TerrainRecord& terrain = entry.second;
+        const Math::Vector3 scale = terrain.transform->getScale();
+        if (Math::Vector3(std::abs(scale.x), std::abs(scale.y), std::abs(scale.z)) != terrain.scale) {
+            rebuilds.push_back(terrain.entity);
+            ++m_Impl->scaleRebuilds;
+            continue;
+        }
+        const Math::Vector3 position = terrain.transform->getPosition();
+        const Math::Quaternion rotation = terrain.transform->getRotation();
+        const bool moved = position != terrain.lastPosition || rotation != terrain.lastRotation;
+        terrain.lastPosition = position;
+        terrain.lastRotation = rotation;
+
+        for (auto& tile : terrain.tiles) {
+            const bool resident = !tile.id.IsInvalid();
+            float distance = 0.0f;
+            if (hasFocus) {
+                const Math::Vector3 center = position + rotation * tile.center;
+                distance = std::max((center - focus).length() - tile.radius, 0.0f);
+            }
+            if (resident) {
+                if (hasFocus && distance > m_Impl->streamingUnloadRadius) {
+                    bodyInterface.RemoveBody(tile.id);
+                    bodyInterface.DestroyBody(tile.id);
+                    m_Impl->activeContacts.eraseBody(tile.id);
+                    tile.id = JPH::BodyID();
+                } else if (moved) {
+                    bodyInterface.SetPositionAndRotation(tile.id,
+                                                         JPH::RVec3(position.x, position.y, position.z),
+                                                         ToJolt(rotation),
+                                                         JPH::EActivation::DontActivate);
+                }
+            } else if (!hasFocus || distance <= m_Impl->streamingLoadRadius) {
+                pageIns.push_back({distance, &terrain, &tile});
+            }
+        }
+    }
+
+    // Without a focus the whole terrain is needed at once; with one the nearest tiles come first.
+    if (hasFocus && pageIns.size() > kMaxTerrainTilesPerUpdate) {
+        std::partial_sort(pageIns.begin(), pageIns.begin() + kMaxTerrainTilesPerUpdate, pageIns.end(),
+                          [](const TilePageIn& a, const TilePageIn& b) { return a.distance < b.distance; });
+        pageIns.resize(kMaxTerrainTilesPerUpdate);
+    }
+    std::vector<float> samples(static_cast<size_t>(kTerrainTileSamples) * kTerrainTileSamples);
+    for (const TilePageIn& pageIn : pageIns) {
+        PhysicsWorldImpl::TerrainRecord& terrain = *pageIn.terrain;
+        PhysicsWorldImpl::TerrainTile& tile = *pageIn.tile;
+        const TerrainHeightField& field = terrain.field;
+        for (uint32_t row = 0; row < kTerrainTileSamples; ++row) {
+            for (uint32_t column = 0; column < kTerrainTileSamples; ++column) {
+                const uint32_t fieldColumn = tile.firstColumn + column;
+                const uint32_t fieldRow = tile.firstRow + row;
+                samples[static_cast<size_t>(row) * kTerrainTileSamples + column] =
+                    fieldColumn < field.sampleCount && fieldRow < field.sampleCount
+                        ? field.heights[static_cast<size_t>(fieldRow) * field.sampleCount + fieldColumn]
+                        : JPH::HeightFieldShapeConstants::cNoCollisionValue;
+            }
+        }
+        const Math::Vector3 offset(
+            (field.origin.x + tile.firstColumn * field.spacingX) * terrain.scale.x + terrain.colliderCenter.x,
+            field.origin.y * terrain.scale.y + terrain.colliderCenter.y,
+            (field.origin.z + tile.firstRow * field.spacingZ) * terrain.scale.z + terrain.colliderCenter.z);
+        JPH::HeightFieldShapeSettings shapeSettings(samples.data(),
+                                                    JPH::Vec3(offset.x, offset.y, offset.z),
+                                                    JPH::Vec3(field.spacingX * terrain.scale.x,
+                                                              terrain.scale.y,
+                                                              field.spacingZ * terrain.scale.z),
+                                                    kTerrainTileSamples);
+        JPH::ShapeSettings::ShapeResult result = shapeSettings.Create();
+        if (result.HasError()) {
+            std::cout << "[Physics] Terrain tile failed for entity " << terrain.entity->getName()
+                      << ": " << result.GetError().c_str() << std::endl;
+            continue;
+        }
+
+        const PhysicsCollider* collider = terrain.entity->getComponent<PhysicsCollider>();
+        JPH::BodyCreationSettings settings(result.Get(),
+                                           JPH::RVec3(terrain.lastPosition.x, terrain.lastPosition.y, terrain.lastPosition.z),
+                                           ToJolt(terrain.lastRotation),
+                                           JPH::EMotionType::Static,
+                                           Layers::NonMoving);
+        if (collider) {
+            const uint32_t collisionLayer = std::min(collider->getCollisionLayer(), PhysicsCollider::kMaxLayers - 1);
+            settings.mCollisionGroup.SetGroupID(collisionLayer);
+            settings.mCollisionGroup.SetSubGroupID(collider->getCollisionMask());
+            settings.mIsSensor = collider->isTrigger();
+            settings.mFriction = collider->getFriction();
+            settings.mRestitution = collider->getRestitution();
+        }
+        settings.mUserData = reinterpret_cast<uint64_t>(terrain.entity);
+        tile.id = bodyInterface.CreateAndAddBody(settings, JPH::EActivation::DontActivate);
+    }
+
+    for (Entity* entity : rebuilds) {
+        queueBodyRebuild(entity);
+    }
+}
+
+std::vector<uint8_t> PhysicsWorld::cookTerrainHeightField(const Entity* entity) const {
+    if (!entity) {
+        return {};
+    }
+    const PhysicsCollider* collider = entity->getComponent<PhysicsCollider>();
+    if (!collider || collider->getShapeType() != PhysicsCollider::ShapeType::Terrain) {
+        return {};
+    }
+    TerrainHeightField field;
+    const std::string& cookedPath = collider->getCookedHeightFieldPath();
+    if (!cookedPath.empty() && LoadTerrainHeightField(cookedPath, field)) {
+        return EncodeTerrainHeightField(field);
+    }
+    MeshRenderer* renderer = FindMeshRendererForCollider(entity);
+    Math::Matrix4x4 meshTransform;
+    if (!renderer || !renderer->getMesh() || !BuildMeshTransform(entity, renderer, meshTransform) ||
+        !BuildTerrainHeightField(*renderer->getMesh(), meshTransform, field)) {
+        return {};
+    }
+    return EncodeTerrainHeightField(field);
 }
 
 void PhysicsWorld::debugDraw(DebugRenderer* renderer) {
@@ -793,6 +1593,7 @@ void PhysicsWorld::debugDraw(DebugRenderer* renderer) {
             renderer->drawLine(top - Math::Vector3(0, 0, radius), bottom - Math::Vector3(0, 0, radius), color);
             break;
         }
+        case PhysicsCollider::ShapeType::Terrain:
         case PhysicsCollider::ShapeType::Mesh: {
             MeshRenderer* meshRenderer = FindMeshRendererForCollider(entity);
             if (meshRenderer && meshRenderer->getMesh()) {
@@ -838,26 +1639,112 @@ void PhysicsWorld::flushPending() {
     }
     std::unordered_set<UUID> pending = std::move(m_Pending);
     m_Pending.clear();
+    StartupTraceScope trace("physics", "Create physics bodies", std::to_string(pending.size()) + " entities");
+    if (!m_Impl || pending.size() < kBulkAddBatch) {
+        for (const UUID& uuid : pending) {
+            Entity* entity = m_Scene->findEntity(uuid);
+            if (!entity) {
+                continue;
+            }
+            rebuildBody(entity);
+        }
+        if (m_Impl) {
+            pruneShapeCache();
+        }
+        return;
+    }
+
+    // Bulk path: create every body first, then insert each activation group with one
+    // AddBodiesPrepare/AddBodiesFinalize. Jolt builds a balanced subtree for the group and swaps it
+    // in, so the broadphase needs no OptimizeBroadPhase afterwards.
+    std::vector<std::pair<Entity*, BodyRecord>> created;
+    created.reserve(pending.size());
+    std::vector<JPH::BodyID> activeIds;
+    std::vector<JPH::BodyID> inactiveIds;
     for (const UUID& uuid : pending) {
         Entity* entity = m_Scene->findEntity(uuid);
         if (!entity) {
             continue;
         }
-        rebuildBody(entity);
+        BodyRecord record;
+        if (!createBody(entity, record)) {
+            continue;
+        }
+        (record.type == RigidbodyType::Dynamic ? activeIds : inactiveIds).push_back(record.id);
+        created.emplace_back(entity, record);
     }
-    if (m_Impl) {
-        m_Impl->physicsSystem.OptimizeBroadPhase();
+
+    JPH::BodyInterface& bodyInterface = m_Impl->physicsSystem.GetBodyInterface();
+    auto addGroup = [&](std::vector<JPH::BodyID>& ids, JPH::EActivation activation) {
+        if (ids.empty()) {
+            return;
+        }
+        const int count = static_cast<int>(ids.size());
+        JPH::BodyInterface::AddState state = bodyInterface.AddBodiesPrepare(ids.data(), count);
+        bodyInterface.AddBodiesFinalize(ids.data(), count, state, activation);
+    };
+    addGroup(inactiveIds, JPH::EActivation::DontActivate);
+    addGroup(activeIds, JPH::EActivation::Activate);
+    for (const auto& entry : created) {
+        registerBody(entry.first, entry.second);
     }
+    pruneShapeCache();
 }
 
 void PhysicsWorld::rebuildBody(Entity* entity) {
-    if (!entity || !m_Initialized) {
+    BodyRecord record;
+    if (!createBody(entity, record)) {
+        return;
+    }
+    JPH::EActivation activation = record.type == RigidbodyType::Dynamic
+        ? JPH::EActivation::Activate
+        : JPH::EActivation::DontActivate;
+    m_Impl->physicsSystem.GetBodyInterface().AddBody(record.id, activation);
+    registerBody(entity, record);
+}
+
+void PhysicsWorld::registerBody(Entity* entity, const BodyRecord& record) {
+    BodyRecord& stored = m_Bodies[entity->getUUID()];
+    stored = record;
+    const uint32_t bodyIndex = record.id.GetIndex();
+    if (bodyIndex >= m_Impl->recordsByBodyIndex.size()) {
+        m_Impl->recordsByBodyIndex.resize(bodyIndex + 1, nullptr);
+    }
+    m_Impl->recordsByBodyIndex[bodyIndex] = &stored;
+}
+
+void PhysicsWorld::releaseInterpolationSlot(BodyRecord& record) {
+    const uint32_t slot = record.interpolationSlot;
+    auto& interpolated = m_Impl->interpolated;
+    if (slot >= interpolated.size()) {
         return;
     }
+    interpolated[slot] = interpolated.back();
+    interpolated[slot].record->interpolationSlot = slot;
+    interpolated.pop_back();
+    record.interpolationSlot = UINT32_MAX;
+}
+
+void PhysicsWorld::pruneShapeCache() {
+    // Entries nothing but the cache holds on to.
+    auto& cache = m_Impl->shapeCache;
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (!it->second.shape || it->second.shape->GetRefCount() <= 1) {
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool PhysicsWorld::createBody(Entity* entity, BodyRecord& outRecord) {
+    if (!entity || !m_Initialized) {
+        return false;
+    }
     PhysicsCollider* collider = entity->getComponent<PhysicsCollider>();
     if (!collider) {
         removeBody(entity);
-        return;
+        return false;
     }
 
     Rigidbody* rb = entity->getComponent<Rigidbody>();
@@ -866,12 +1753,15 @@ void PhysicsWorld::rebuildBody(Entity* entity) {
     removeBody(entity);
 
     if (!m_Impl) {
-        return;
+        return false;
+    }
+    if (collider->getShapeType() == PhysicsCollider::ShapeType::Terrain && createTerrain(entity, *collider)) {
+        return false;
     }
 
     Transform* transform = entity->getTransform();
     if (!transform) {
-        return;
+        return false;
     }
 
     Math::Vector3 pos = transform->getPosition();
@@ -880,7 +1770,7 @@ void PhysicsWorld::rebuildBody(Entity* entity) {
 
     JPH::RefConst<JPH::Shape> shape = buildShape(*collider, scale, entity, type);
     if (!shape) {
-        return;
+        return false;
     }
 
     JPH::EMotionType motionType = JPH::EMotionType::Static;
@@ -928,21 +1818,18 @@ void PhysicsWorld::rebuildBody(Entity* entity) {
     JPH::BodyInterface& bodyInterface = m_Impl->physicsSystem.GetBodyInterface();
     JPH::Body* body = bodyInterface.CreateBody(settings);
     if (!body) {
-        return;
+        return false;
     }
-    JPH::EActivation activation = (motionType == JPH::EMotionType::Dynamic)
-        ? JPH::EActivation::Activate
-        : JPH::EActivation::DontActivate;
-    bodyInterface.AddBody(body->GetID(), activation);
 
-    BodyRecord record;
-    record.id = body->GetID();
-    record.type = type;
-    record.lastPosition = pos;
-    record.lastRotation = rot;
-    record.lastScale = scale;
-    record.isSensor = collider->isTrigger();
-    m_Bodies[entity->getUUID()] = record;
+    outRecord.id = body->GetID();
+    outRecord.type = type;
+    outRecord.lastPosition = pos;
+    outRecord.lastRotation = rot;
+    outRecord.lastScale = scale;
+    outRecord.isSensor = collider->isTrigger();
+    outRecord.entity = entity;
+    outRecord.transform = transform;
+    return true;
 }
 
 void PhysicsWorld::syncKinematicBodies() {
@@ -968,6 +1855,7 @@ void PhysicsWorld::syncKinematicBodies() {
         Math::Vector3 scale = transform->getScale();
         if (scale != entry.second.lastScale) {
             queueBodyRebuild(entity);
+            ++m_Impl->scaleRebuilds;
             continue;
         }
         updateBodyTransform(entry.second, entity);
@@ -987,32 +1875,46 @@ void PhysicsWorld::syncDynamicBodies() {
     if (!m_Impl) {
         return;
     }
-    JPH::BodyInterface& bodyInterface = m_Impl->physicsSystem.GetBodyInterface();
-    for (auto& entry : m_Bodies) {
-        if (entry.second.type != RigidbodyType::Dynamic) {
+    // Only awake bodies can have moved, so the sync walks Jolt's active list instead of every
+    // dynamic body. The simulation is not running here, so the lock-free interfaces are safe.
+    const JPH::PhysicsSystem& physicsSystem = m_Impl->physicsSystem;
+    const JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterfaceNoLock();
+    const JPH::BodyID* activeBodies = physicsSystem.GetActiveBodiesUnsafe(JPH::EBodyType::RigidBody);
+    const uint32_t activeCount = physicsSystem.GetNumActiveBodies(JPH::EBodyType::RigidBody);
+    const auto& recordsByIndex = m_Impl->recordsByBodyIndex;
+    auto& interpolated = m_Impl->interpolated;
+    for (uint32_t i = 0; i < activeCount; ++i) {
+        const JPH::BodyID id = activeBodies[i];
+        BodyRecord* record = id.GetIndex() < recordsByIndex.size() ? recordsByIndex[id.GetIndex()] : nullptr;
+        if (!record || record->id != id || record->type != RigidbodyType::Dynamic || !record->transform) {
             continue;
         }
-        Entity* entity = m_Scene->findEntity(entry.first);
-        if (!entity) {
+        if (record->transform->getScale() != record->lastScale) {
+            queueBodyRebuild(record->entity);
+            ++m_Impl->scaleRebuilds;
             continue;
         }
-        Transform* transform = entity->getTransform();
-        if (transform && transform->getScale() != entry.second.lastScale) {
-            queueBodyRebuild(entity);
-            continue;
+        // A body's first step blends from the pose it was created at.
+        if (record->interpolationSlot == UINT32_MAX) {
+            record->interpolationSlot = static_cast<uint32_t>(interpolated.size());
+            interpolated.push_back({record, record->lastPosition, record->lastPosition,
+                                    record->lastRotation, record->lastRotation, 0, false});
         }
-        JPH::RVec3 pos = bodyInterface.GetPosition(entry.second.id);
-        JPH::Quat rot = bodyInterface.GetRotation(entry.second.id);
-        Math::Vector3 newPos = Math::Vector3(static_cast<float>(pos.GetX()),
+        JPH::RVec3 pos;
+        JPH::Quat rot;
+        bodyInterface.GetPositionAndRotation(id, pos, rot);
+        record->lastPosition = Math::Vector3(static_cast<float>(pos.GetX()),
                                              static_cast<float>(pos.GetY()),
                                              static_cast<float>(pos.GetZ()));
-        Math::Quaternion newRot = ToCrescent(rot);
-        if (transform) {
-            transform->setPosition(newPos);
-            transform->setRotation(newRot);
-        }
-        entry.second.lastPosition = newPos;
-        entry.second.lastRotation = newRot;
+        record->lastRotation = ToCrescent(rot);
+
+        // Transforms are only written by interpolateBodies, once per frame.
+        auto& body = interpolated[record->interpolationSlot];
+        body.previousPosition = body.currentPosition;
+        body.previousRotation = body.currentRotation;
+        body.currentPosition = record->lastPosition;
+        body.currentRotation = record->lastRotation;
+        body.step = m_Impl->stepCount;
     }
 }
 
@@ -1036,6 +1938,7 @@ void PhysicsWorld::syncEditorBodies() {
         Math::Vector3 scale = transform->getScale();
         if (scale != entry.second.lastScale) {
             queueBodyRebuild(entity);
+            ++m_Impl->scaleRebuilds;
             continue;
         }
         updateBodyTransform(entry.second, entity);
@@ -1067,6 +1970,50 @@ JPH::RefConst<JPH::Shape> PhysicsWorld::buildShape(const PhysicsCollider& collid
     Math::Vector3 shapeOffset(0.0f, 0.0f, 0.0f);
     JPH::RefConst<JPH::Shape> shape;
 
+    MeshRenderer* renderer = nullptr;
+    Math::Matrix4x4 meshTransform;
+    ShapeCacheKey cacheKey;
+    cacheKey.type = static_cast<uint32_t>(collider.getShapeType());
+    const Math::Vector3 size = collider.getSize();
+    const Math::Vector3 colliderCenter = collider.getCenter();
+    const float params[14] = {size.x, size.y, size.z, collider.getRadius(), collider.getHeight(),
+                              colliderCenter.x, colliderCenter.y, colliderCenter.z,
+                              absScale.x, absScale.y, absScale.z, 0.0f, 0.0f, 0.0f};
+    std::memcpy(cacheKey.params, params, sizeof(params));
+    bool cacheable = true;
+    // A terrain only gets here when it is not a height grid, and is then a plain mesh collider.
+    if (collider.getShapeType() == PhysicsCollider::ShapeType::Mesh ||
+        collider.getShapeType() == PhysicsCollider::ShapeType::Terrain) {
+        renderer = FindMeshRendererForCollider(entity);
+        if (renderer && renderer->getMesh() && BuildMeshTransform(entity, renderer, meshTransform)) {
+            cacheKey.mesh = renderer->getMesh().get();
+            cacheKey.convexHull = bodyType != RigidbodyType::Static;
+            std::memcpy(cacheKey.meshTransform, meshTransform.m, sizeof(cacheKey.meshTransform));
+        } else {
+            cacheable = false;
+        }
+    }
+    if (cacheable && m_Impl) {
+        auto cached = m_Impl->shapeCache.find(cacheKey);
+        if (cached != m_Impl->shapeCache.end()) {
+            if (!cacheKey.mesh || !cached->second.mesh.expired()) {
+                return cached->second.shape;
+            }
+            m_Impl->shapeCache.erase(cached);
+        }
+    }
+    auto cacheShape = [&](const JPH::RefConst<JPH::Shape>& built) {
+        if (cacheable && built && m_Impl) {
+            ShapeCacheEntry entry;
+            entry.shape = built;
+            if (renderer) {
+                entry.mesh = renderer->getMesh();
+            }
+            m_Impl->shapeCache[cacheKey] = std::move(entry);
+        }
+        return built;
+    };
+
     switch (collider.getShapeType()) {
     case PhysicsCollider::ShapeType::Sphere: {
         float radius = collider.getRadius() * std::max({absScale.x, absScale.y, absScale.z});
@@ -1085,64 +2032,33 @@ JPH::RefConst<JPH::Shape> PhysicsWorld::buildShape(const PhysicsCollider& collid
         }
         break;
     }
+    case PhysicsCollider::ShapeType::Terrain:
     case PhysicsCollider::ShapeType::Mesh: {
-        MeshRenderer* renderer = FindMeshRendererForCollider(entity);
         if (!renderer || !renderer->getMesh()) {
             std::cout << "[Physics] Mesh collider missing MeshRenderer on entity: "
                       << (entity ? entity->getName() : "Unknown") << std::endl;
             break;
         }
         const Mesh& mesh = *renderer->getMesh();
-        Math::Matrix4x4 meshTransform;
-        if (!BuildMeshTransform(entity, renderer, meshTransform)) {
+        if (!cacheable) {
             std::cout << "[Physics] Mesh collider failed to compute transform for entity: "
                       << (entity ? entity->getName() : "Unknown") << std::endl;
             break;
         }
         Math::Matrix4x4 scaledTransform = Math::Matrix4x4::Scale(absScale) * meshTransform;
-
-        if (bodyType == RigidbodyType::Static) {
-            JPH::VertexList vertices;
-            JPH::IndexedTriangleList indexedTriangles;
-            if (BuildMeshIndexed(mesh, scaledTransform, vertices, indexedTriangles)) {
-                JPH::MeshShapeSettings settings(std::move(vertices), std::move(indexedTriangles));
-                auto result = settings.Create();
-                if (result.HasError()) {
-                    std::cout << "[Physics] Mesh collider error: "
-                              << result.GetError() << std::endl;
-                } else {
-                    shape = result.Get();
-                }
-            } else {
-                JPH::TriangleList triangles;
-                if (BuildMeshTriangles(mesh, scaledTransform, triangles)) {
-                    JPH::MeshShapeSettings settings(triangles);
-                    auto result = settings.Create();
-                    if (result.HasError()) {
-                        std::cout << "[Physics] Mesh collider error: "
-                                  << result.GetError() << std::endl;
-                    } else {
-                        shape = result.Get();
-                    }
-                }
-            }
-        } else {
-            std::vector<JPH::Vec3> points;
-            constexpr size_t kMaxHullPoints = 1024;
-            if (BuildConvexPoints(mesh, scaledTransform, points, kMaxHullPoints)) {
-                JPH::ConvexHullShapeSettings settings(points.data(),
-                                                      static_cast<int>(points.size()),
-                                                      JPH::cDefaultConvexRadius);
-                auto result = settings.Create();
-                if (result.HasError()) {
-                    std::cout << "[Physics] Convex hull collider error: "
-                              << result.GetError() << std::endl;
-                } else {
-                    shape = result.Get();
-                }
+        const bool convex = bodyType != RigidbodyType::Static;
+
+        // A cooked shape needs no CPU geometry, so the mesh is not read back for it.
+        const std::string& cookedPath = collider.getCookedShapePath();
+        if (!cookedPath.empty() && collider.isCookedShapeConvex() == convex &&
+            MatchesCookedTransform(scaledTransform, collider.getCookedShapeTransform())) {
+            shape = RestoreCookedShape(cookedPath);
+            if (shape) {
+                break;
             }
         }
 
+        shape = BuildMeshColliderShape(mesh, scaledTransform, convex);
         if (!shape) {
             Math::Vector3 boundsMin;
             Math::Vector3 boundsMax;
@@ -1155,6 +2071,8 @@ JPH::RefConst<JPH::Shape> PhysicsWorld::buildShape(const PhysicsCollider& collid
                 }
             }
         }
+        // The shape holds its own copy; reloadable meshes rebuild the lists if asked again.
+        renderer->getMesh()->releaseCpuData();
         break;
     }
     case PhysicsCollider::ShapeType::Box:
@@ -1174,7 +2092,54 @@ JPH::RefConst<JPH::Shape> PhysicsWorld::buildShape(const PhysicsCollider& collid
                                                 JPH::Quat::sIdentity(),
                                                 shape);
     }
-    return shape;
+    return cacheShape(shape);
+}
+
+std::vector<uint8_t> PhysicsWorld::cookMeshColliderShape(const Entity* entity,
+                                                         Math::Matrix4x4& outTransform,
+                                                         bool& outConvex) const {
+    std::vector<uint8_t> blob;
+    // Jolt's allocator is installed by initialize.
+    if (!m_Initialized || !entity) {
+        return blob;
+    }
+    const PhysicsCollider* collider = entity->getComponent<PhysicsCollider>();
+    const Transform* transform = entity->getTransform();
+    if (!collider || !transform || collider->getShapeType() != PhysicsCollider::ShapeType::Mesh) {
+        return blob;
+    }
+    MeshRenderer* renderer = FindMeshRendererForCollider(entity);
+    Math::Matrix4x4 meshTransform;
+    if (!renderer || !renderer->getMesh() || !BuildMeshTransform(entity, renderer, meshTransform)) {
+        return blob;
+    }
+    const Rigidbody* rb = entity->getComponent<Rigidbody>();
+    const bool convex = rb && rb->getType() != RigidbodyType::Static;
+    const Math::Vector3 scale = transform->getScale();
+    const Math::Vector3 absScale(std::abs(scale.x), std::abs(scale.y), std::abs(scale.z));
+    const Math::Matrix4x4 scaledTransform = Math::Matrix4x4::Scale(absScale) * meshTransform;
+
+    JPH::RefConst<JPH::Shape> shape = BuildMeshColliderShape(*renderer->getMesh(), scaledTransform, convex);
+    if (!shape) {
+        return blob;
+    }
+    std::ostringstream out(std::ios::binary);
+    CookedShapeHeader header;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    {
+        JPH::StreamOutWrapper stream(out);
+        JPH::Shape::ShapeToIDMap shapeMap;
+        JPH::Shape::MaterialToIDMap materialMap;
+        shape->SaveWithChildren(stream, shapeMap, materialMap);
+        if (stream.IsFailed()) {
+            return blob;
+        }
+    }
+    const std::string bytes = out.str();
+    blob.assign(bytes.begin(), bytes.end());
+    outTransform = scaledTransform;
+    outConvex = convex;
+    return blob;
 }
 
 Entity* PhysicsWorld::resolveEntity(const JPH::BodyID& bodyID) const {
@@ -1194,39 +2159,47 @@ void PhysicsWorld::dispatchContactEvents() {
     if (!m_Impl) {
         return;
     }
-    std::vector<ContactEvent> events;
-    {
-        std::lock_guard<std::mutex> lock(m_Impl->eventMutex);
-        if (m_Impl->pendingEvents.empty()) {
-            return;
-        }
-        events.swap(m_Impl->pendingEvents);
+    // The step is over, so every buffer is safe to read without locks.
+    std::vector<ContactEvent>& events = m_Impl->mergedEvents;
+    events.clear();
+    for (auto& buffer : m_Impl->eventBuffers) {
+        events.insert(events.end(), buffer.events.begin(), buffer.events.end());
+        buffer.events.clear();
+    }
+    if (events.empty()) {
+        return;
     }
 
-    struct EventKey {
-        BodyPairKey pair;
-        ContactEventType type;
-
-        bool operator==(const EventKey& other) const {
-            return pair == other.pair && type == other.type;
-        }
-    };
+    // Enters and stays first, so their pairs are known as touching before the exits are matched.
+    ContactPairTable& active = m_Impl->activeContacts;
+    ContactPairTable& dispatched = m_Impl->dispatchedEvents;
+    dispatched.clear();
+    std::stable_partition(events.begin(), events.end(), [](const ContactEvent& event) {
+        return event.type != ContactEventType::Exit;
+    });
 
-    struct EventKeyHash {
-        size_t operator()(const EventKey& key) const {
-            return static_cast<size_t>(JPH::HashCombineArgs(
-                static_cast<uint64_t>(BodyPairKeyHash{}(key.pair)),
-                static_cast<uint32_t>(key.type)));
+    for (auto& event : events) {
+        const uint64_t pair = PackBodyPair(MakeBodyPairKey(event.body1, event.body2));
+        const uint8_t typeBit = static_cast<uint8_t>(1u << static_cast<uint32_t>(event.type));
+        uint8_t& seen = dispatched[pair];
+        if (event.type == ContactEventType::Exit) {
+            // Another sub-shape pair of the two bodies still touches.
+            if (seen & ~typeBit) {
+                continue;
+            }
+            const uint8_t* trigger = active.find(pair);
+            if (!trigger) {
+                continue;
+            }
+            event.isTrigger = *trigger != 0;
+            active.erase(pair);
+        } else {
+            active[pair] = event.isTrigger ? 1 : 0;
         }
-    };
-
-    std::unordered_set<EventKey, EventKeyHash> seen;
-    for (const auto& event : events) {
-        BodyPairKey pair = MakeBodyPairKey(event.body1, event.body2);
-        EventKey key{pair, event.type};
-        if (!seen.insert(key).second) {
+        if (seen & typeBit) {
             continue;
         }
+        seen |= typeBit;
 
         Entity* entity1 = resolveEntity(event.body1);
         Entity* entity2 = resolveEntity(event.body2);
@@ -1236,6 +2209,10 @@ void PhysicsWorld::dispatchContactEvents() {
         if (!entity1->isActiveInHierarchy() || !entity2->isActiveInHierarchy()) {
             continue;
         }
+        if (event.type == ContactEventType::Stay &&
+            !entity1->wantsContactStay() && !entity2->wantsContactStay()) {
+            continue;
+        }
 
         PhysicsContact contact1;
         contact1.other = entity2;
@@ -1365,6 +2342,7 @@ bool PhysicsWorld::raycast(const Math::Vector3& origin,
     if (!m_Impl || maxDistance <= 0.0f) {
         return false;
     }
+    m_Impl->countQuery(PhysicsQueryType::Raycast);
 
     Math::Vector3 dir = direction.normalized();
     if (dir.lengthSquared() == 0.0f) {
@@ -1418,6 +2396,7 @@ int PhysicsWorld::raycastAll(const Math::Vector3& origin,
     if (!m_Impl || maxDistance <= 0.0f) {
         return 0;
     }
+    m_Impl->countQuery(PhysicsQueryType::Raycast);
 
     Math::Vector3 dir = direction.normalized();
     if (dir.lengthSquared() == 0.0f) {
@@ -1480,6 +2459,7 @@ bool PhysicsWorld::sphereCast(const Math::Vector3& center,
     if (!m_Impl || radius <= 0.0f || maxDistance <= 0.0f) {
         return false;
     }
+    m_Impl->countQuery(PhysicsQueryType::SphereCast);
 
     Math::Vector3 dir = direction.normalized();
     if (dir.lengthSquared() == 0.0f) {
@@ -1519,6 +2499,7 @@ int PhysicsWorld::sphereCastAll(const Math::Vector3& center,
     if (!m_Impl || radius <= 0.0f || maxDistance <= 0.0f) {
         return 0;
     }
+    m_Impl->countQuery(PhysicsQueryType::SphereCast);
 
     Math::Vector3 dir = direction.normalized();
     if (dir.lengthSquared() == 0.0f) {
@@ -1568,6 +2549,7 @@ bool PhysicsWorld::boxCast(const Math::Vector3& center,
     if (!m_Impl || maxDistance <= 0.0f) {
         return false;
     }
+    m_Impl->countQuery(PhysicsQueryType::BoxCast);
     if (halfExtents.x <= 0.0f || halfExtents.y <= 0.0f || halfExtents.z <= 0.0f) {
         return false;
     }
@@ -1612,6 +2594,7 @@ int PhysicsWorld::boxCastAll(const Math::Vector3& center,
     if (!m_Impl || maxDistance <= 0.0f) {
         return 0;
     }
+    m_Impl->countQuery(PhysicsQueryType::BoxCast);
     if (halfExtents.x <= 0.0f || halfExtents.y <= 0.0f || halfExtents.z <= 0.0f) {
         return 0;
     }
@@ -1668,6 +2651,7 @@ bool PhysicsWorld::capsuleCast(const Math::Vector3& center,
     if (!m_Impl || radius <= 0.0f || maxDistance <= 0.0f) {
         return false;
     }
+    m_Impl->countQuery(PhysicsQueryType::CapsuleCast);
 
     radius = std::max(radius, kMinShapeDimension);
     float halfHeight = (height * 0.5f) - radius;
@@ -1713,6 +2697,7 @@ int PhysicsWorld::capsuleCastAll(const Math::Vector3& center,
     if (!m_Impl || radius <= 0.0f || maxDistance <= 0.0f) {
         return 0;
     }
+    m_Impl->countQuery(PhysicsQueryType::CapsuleCast);
 
     radius = std::max(radius, kMinShapeDimension);
     float halfHeight = (height * 0.5f) - radius;
@@ -1764,6 +2749,7 @@ int PhysicsWorld::overlapSphere(const Math::Vector3& center,
     if (!m_Impl || radius <= 0.0f) {
         return 0;
     }
+    m_Impl->countQuery(PhysicsQueryType::OverlapSphere);
 
     JPH::SphereShape shape(radius);
     JPH::RMat44 transform = JPH::RMat44::sTranslation(JPH::RVec3(center.x, center.y, center.z));
@@ -1824,6 +2810,7 @@ int PhysicsWorld::overlapBox(const Math::Vector3& center,
     if (!m_Impl) {
         return 0;
     }
+    m_Impl->countQuery(PhysicsQueryType::OverlapBox);
 
     Math::Vector3 clamped(std::max(0.001f, halfExtents.x),
                           std::max(0.001f, halfExtents.y),
@@ -1877,4 +2864,342 @@ int PhysicsWorld::overlapBox(const Math::Vector3& center,
     return static_cast<int>(outHits.size());
 }
 
+namespace {
+
+// Below this many queries per job, spreading a batch costs more than it saves.
+constexpr size_t kMinQueriesPerJob = 4;
+// A character move is a dozen or so collision queries, worth a job of its own sooner.
+constexpr size_t kMinCharactersPerJob = 2;
+constexpr size_t kCharacterTempAllocatorSize = 256 * 1024;
+constexpr float kMinCharacterDimension = 0.001f;
+
+// The capsule stands on the character's position, which is its lowest point; the entity position
+// is the capsule's center, this far above.
+float CharacterCenterOffset(float radius, float height) {
+    return std::max(radius, height * 0.5f);
+}
+
+JPH::RefConst<JPH::Shape> BuildCharacterShape(float radius, float height) {
+    radius = std::max(radius, kMinCharacterDimension);
+    const float halfCylinder = height * 0.5f - radius;
+    JPH::RefConst<JPH::Shape> capsule = halfCylinder <= kMinCharacterDimension
+        ? JPH::RefConst<JPH::Shape>(new JPH::SphereShape(radius))
+        : JPH::RefConst<JPH::Shape>(new JPH::CapsuleShape(halfCylinder, radius));
+    return new JPH::RotatedTranslatedShape(JPH::Vec3(0.0f, CharacterCenterOffset(radius, height), 0.0f),
+                                           JPH::Quat::sIdentity(),
+                                           capsule);
+}
+
+float CharacterSlopeRadians(const PhysicsCharacterSettings& settings) {
+    return std::clamp(settings.maxSlopeDegrees, 0.0f, 89.0f) * Math::DEG_TO_RAD;
+}
+
+} // namespace
+
+void PhysicsWorld::runQuery(const PhysicsQuery& query,
+                            PhysicsQueryBatch::JobHits& hits,
+                            PhysicsQueryBatch::HitRange& outRange) const {
+    const bool overlap = query.type == PhysicsQueryType::OverlapSphere || query.type == PhysicsQueryType::OverlapBox;
+    outRange.first = static_cast<uint32_t>(overlap ? hits.overlapHits.size() : hits.castHits.size());
+    outRange.count = 0;
+
+    if (overlap) {
+        if (query.type == PhysicsQueryType::OverlapSphere) {
+            overlapSphere(query.origin, query.radius, hits.overlapScratch,
+                          query.layerMask, query.includeTriggers, query.ignore);
+        } else {
+            overlapBox(query.origin, query.halfExtents, hits.overlapScratch,
+                       query.layerMask, query.includeTriggers, query.ignore);
+        }
+        hits.overlapHits.insert(hits.overlapHits.end(), hits.overlapScratch.begin(), hits.overlapScratch.end());
+        outRange.count = static_cast<uint32_t>(hits.overlapScratch.size());
+        return;
+    }
+
+    if (query.allHits) {
+        std::vector<PhysicsRaycastHit>& scratch = hits.castScratch;
+        switch (query.type) {
+        case PhysicsQueryType::Raycast:
+            raycastAll(query.origin, query.direction, query.maxDistance, scratch,
+                       query.layerMask, query.includeTriggers, query.ignore);
+            break;
+        case PhysicsQueryType::SphereCast:
+            sphereCastAll(query.origin, query.radius, query.direction, query.maxDistance, scratch,
+                          query.layerMask, query.includeTriggers, query.ignore);
+            break;
+        case PhysicsQueryType::BoxCast:
+            boxCastAll(query.origin, query.halfExtents, query.direction, query.maxDistance, scratch,
+                       query.layerMask, query.includeTriggers, query.ignore);
+            break;
+        case PhysicsQueryType::CapsuleCast:
+            capsuleCastAll(query.origin, query.radius, query.height, query.direction, query.maxDistance, scratch,
+                           query.layerMask, query.includeTriggers, query.ignore);
+            break;
+        default:
+            scratch.clear();
+            break;
+        }
+        hits.castHits.insert(hits.castHits.end(), scratch.begin(), scratch.end());
+        outRange.count = static_cast<uint32_t>(scratch.size());
+        return;
+    }
+
+    PhysicsRaycastHit hit;
+    bool found = false;
+    switch (query.type) {
+    case PhysicsQueryType::Raycast:
+        found = raycast(query.origin, query.direction, query.maxDistance, hit,
+                        query.layerMask, query.includeTriggers, query.ignore);
+        break;
+    case PhysicsQueryType::SphereCast:
+        found = sphereCast(query.origin, query.radius, query.direction, query.maxDistance, hit,
+                           query.layerMask, query.includeTriggers, query.ignore);
+        break;
+    case PhysicsQueryType::BoxCast:
+        found = boxCast(query.origin, query.halfExtents, query.direction, query.maxDistance, hit,
+                        query.layerMask, query.includeTriggers, query.ignore);
+        break;
+    case PhysicsQueryType::CapsuleCast:
+        found = capsuleCast(query.origin, query.radius, query.height, query.direction, query.maxDistance, hit,
+                            query.layerMask, query.includeTriggers, query.ignore);
+        break;
+    default:
+        break;
+    }
+    if (found) {
+        hits.castHits.push_back(hit);
+        outRange.count = 1;
+    }
+}
+
+void PhysicsWorld::runQueries(PhysicsQueryBatch& batch) const {
+    const size_t count = batch.m_Queries.size();
+    batch.m_Ranges.assign(count, {});
+    batch.m_CastHits.clear();
+    batch.m_OverlapHits.clear();
+    if (count == 0 || !m_Impl) {
+        return;
+    }
+
+    // Each job runs a contiguous run of queries into its own hit buffers; the narrow phase query
+    // and body locks are safe to use from several threads at once.
+    JobScheduler& scheduler = JobScheduler::getInstance();
+    const size_t workers = scheduler.isRunning() ? scheduler.workerCount() : 0;
+    const size_t jobCount = std::max<size_t>(1, std::min(workers + 1, count / kMinQueriesPerJob));
+    const size_t chunkSize = (count + jobCount - 1) / jobCount;
+    if (batch.m_JobHits.size() < jobCount) {
+        batch.m_JobHits.resize(jobCount);
+    }
+    auto runJob = [this, &batch, count, chunkSize](size_t job) {
+        PhysicsQueryBatch::JobHits& hits = batch.m_JobHits[job];
+        hits.castHits.clear();
+        hits.overlapHits.clear();
+        const size_t end = std::min(count, (job + 1) * chunkSize);
+        for (size_t i = job * chunkSize; i < end; ++i) {
+            runQuery(batch.m_Queries[i], hits, batch.m_Ranges[i]);
+        }
+    };
+    if (jobCount > 1) {
+        auto fence = std::make_shared<JobFence>();
+        for (size_t job = 1; job < jobCount; ++job) {
+            fence->remaining.fetch_add(1, std::memory_order_relaxed);
+            scheduler.schedule([&runJob, job]() { runJob(job); }, fence);
+        }
+        runJob(0);
+        scheduler.wait(*fence);
+    } else {
+        runJob(0);
+    }
+
+    // Merge in job order, so the flat buffers follow query order.
+    for (size_t job = 0; job < jobCount; ++job) {
+        const PhysicsQueryBatch::JobHits& hits = batch.m_JobHits[job];
+        const uint32_t castBase = static_cast<uint32_t>(batch.m_CastHits.size());
+        const uint32_t overlapBase = static_cast<uint32_t>(batch.m_OverlapHits.size());
+        const size_t end = std::min(count, (job + 1) * chunkSize);
+        for (size_t i = job * chunkSize; i < end; ++i) {
+            const PhysicsQueryType type = batch.m_Queries[i].type;
+            const bool overlap = type == PhysicsQueryType::OverlapSphere || type == PhysicsQueryType::OverlapBox;
+            batch.m_Ranges[i].first += overlap ? overlapBase : castBase;
+        }
+        batch.m_CastHits.insert(batch.m_CastHits.end(), hits.castHits.begin(), hits.castHits.end());
+        batch.m_OverlapHits.insert(batch.m_OverlapHits.end(), hits.overlapHits.begin(), hits.overlapHits.end());
+    }
+}
+
+void PhysicsWorld::moveCharacter(const Entity* entity,
+                                 const PhysicsCharacterSettings& settings,
+                                 const Math::Vector3& velocity,
+                                 float deltaTime) {
+    if (!entity || !m_Impl || deltaTime <= 0.0f) {
+        return;
+    }
+    Transform* transform = entity->getTransform();
+    if (!transform) {
+        return;
+    }
+    auto& record = m_Impl->characters[entity->getUUID()];
+    // Padding is fixed when a CharacterVirtual is made; anything else can change in place.
+    if (!record.character || record.settings.padding != settings.padding) {
+        const Math::Vector3 center = transform->getPosition();
+        JPH::CharacterVirtualSettings characterSettings;
+        characterSettings.mShape = BuildCharacterShape(settings.radius, settings.height);
+        characterSettings.mUp = JPH::Vec3::sAxisY();
+        characterSettings.mMaxSlopeAngle = CharacterSlopeRadians(settings);
+        characterSettings.mCharacterPadding = std::max(settings.padding, kMinCharacterDimension);
+        // Only contacts on the lower hemisphere can hold the character up.
+        characterSettings.mSupportingVolume = JPH::Plane(JPH::Vec3::sAxisY(), -std::max(settings.radius, kMinCharacterDimension));
+        const float offset = CharacterCenterOffset(settings.radius, settings.height);
+        record.entity = entity->getUUID();
+        record.character = new JPH::CharacterVirtual(&characterSettings,
+                                                     JPH::RVec3(center.x, center.y - offset, center.z),
+                                                     JPH::Quat::sIdentity(),
+                                                     0,
+                                                     &m_Impl->physicsSystem);
+        record.shapeRadius = settings.radius;
+        record.shapeHeight = settings.height;
+        record.state = PhysicsCharacterState{};
+        record.state.position = center;
+        record.state.height = settings.height;
+    }
+    record.settings = settings;
+    record.velocity = velocity;
+    record.deltaTime = deltaTime;
+    record.transform = transform;
+    if (!record.queued) {
+        record.queued = true;
+        m_Impl->characterMoves.push_back(&record);
+    }
+}
+
+bool PhysicsWorld::getCharacterState(const Entity* entity, PhysicsCharacterState& outState) const {
+    if (!entity || !m_Impl) {
+        return false;
+    }
+    auto it = m_Impl->characters.find(entity->getUUID());
+    if (it == m_Impl->characters.end()) {
+        return false;
+    }
+    outState = it->second.state;
+    return true;
+}
+
+void PhysicsWorld::removeCharacter(const Entity* entity) {
+    if (!entity || !m_Impl) {
+        return;
+    }
+    auto it = m_Impl->characters.find(entity->getUUID());
+    if (it == m_Impl->characters.end()) {
+        return;
+    }
+    auto& moves = m_Impl->characterMoves;
+    moves.erase(std::remove(moves.begin(), moves.end(), &it->second), moves.end());
+    m_Impl->characters.erase(it);
+}
+
+void PhysicsWorld::updateCharacters() {
+    if (!m_Impl || m_Impl->characterMoves.empty()) {
+        return;
+    }
+    CRESCENT_PROFILE_SCOPE("PhysicsWorld::updateCharacters");
+    auto& moves = m_Impl->characterMoves;
+    // Moves start from wherever the entity is now, so teleports and edits since the last move
+    // are kept.
+    for (auto* record : moves) {
+        const Math::Vector3 center = record->transform->getPosition();
+        const float offset = CharacterCenterOffset(record->shapeRadius, record->shapeHeight);
+        record->startCenter = center;
+        record->character->SetPosition(JPH::RVec3(center.x, center.y - offset, center.z));
+    }
+
+    // Characters only read the world and push dynamic bodies through the locking body interface,
+    // so moves of different characters can run side by side.
+    const size_t count = moves.size();
+    JobScheduler& scheduler = JobScheduler::getInstance();
+    const size_t workers = scheduler.isRunning() ? scheduler.workerCount() : 0;
+    const size_t jobCount = std::max<size_t>(1, std::min(workers + 1, count / kMinCharactersPerJob));
+    const size_t chunkSize = (count + jobCount - 1) / jobCount;
+    auto& allocators = m_Impl->characterAllocators;
+    while (allocators.size() < jobCount) {
+        allocators.push_back(std::make_unique<JPH::TempAllocatorImplWithMallocFallback>(kCharacterTempAllocatorSize));
+    }
+    auto runJob = [this, &moves, count, chunkSize](size_t job) {
+        JPH::TempAllocator& allocator = *m_Impl->characterAllocators[job];
+        const size_t end = std::min(count, (job + 1) * chunkSize);
+        for (size_t i = job * chunkSize; i < end; ++i) {
+            PhysicsWorldImpl::CharacterRecord& record = *moves[i];
+            JPH::CharacterVirtual& character = *record.character;
+            const PhysicsCharacterSettings& settings = record.settings;
+            // Ignores the entity's own kinematic body, if it has one.
+            QueryBodyFilter bodyFilter(settings.layerMask, false, record.transform->getEntity());
+            const JPH::BroadPhaseLayerFilter broadPhaseFilter;
+            const JPH::ObjectLayerFilter objectLayerFilter;
+            const JPH::ShapeFilter shapeFilter;
+
+            // A taller capsule only fits where there is room; until then the old size stays.
+            if (settings.radius != record.shapeRadius || settings.height != record.shapeHeight) {
+                const float oldOffset = CharacterCenterOffset(record.shapeRadius, record.shapeHeight);
+                const float newOffset = CharacterCenterOffset(settings.radius, settings.height);
+                const JPH::RVec3 feet = character.GetPosition();
+                character.SetPosition(feet + JPH::Vec3(0.0f, oldOffset - newOffset, 0.0f));
+                if (character.SetShape(BuildCharacterShape(settings.radius, settings.height),
+                                       1.5f * character.GetCharacterPadding(),
+                                       broadPhaseFilter, objectLayerFilter, bodyFilter, shapeFilter, allocator)) {
+                    record.shapeRadius = settings.radius;
+                    record.shapeHeight = settings.height;
+                } else {
+                    character.SetPosition(feet);
+                }
+            }
+            character.SetMaxSlopeAngle(CharacterSlopeRadians(settings));
+
+            const float offset = CharacterCenterOffset(record.shapeRadius, record.shapeHeight);
+            JPH::CharacterVirtual::ExtendedUpdateSettings updateSettings;
+            updateSettings.mStickToFloorStepDown = JPH::Vec3(0.0f, -std::max(settings.stickToFloorDistance, 0.0f), 0.0f);
+            updateSettings.mWalkStairsStepUp = JPH::Vec3(0.0f, std::max(settings.stepHeight, 0.0f), 0.0f);
+            character.SetLinearVelocity(ToJolt(record.velocity));
+            character.ExtendedUpdate(record.deltaTime,
+                                     JPH::Vec3(0.0f, -settings.gravity, 0.0f),
+                                     updateSettings,
+                                     broadPhaseFilter,
+                                     objectLayerFilter,
+                                     bodyFilter,
+                                     shapeFilter,
+                                     allocator);
+
+            const JPH::RVec3 end = character.GetPosition();
+            PhysicsCharacterState& state = record.state;
+            state.position = Math::Vector3(static_cast<float>(end.GetX()),
+                                           static_cast<float>(end.GetY()) + offset,
+                                           static_cast<float>(end.GetZ()));
+            state.velocity = (state.position - record.startCenter) / record.deltaTime;
+            const JPH::CharacterVirtual::EGroundState ground = character.GetGroundState();
+            state.grounded = ground == JPH::CharacterVirtual::EGroundState::OnGround;
+            state.onSteepGround = ground == JPH::CharacterVirtual::EGroundState::OnSteepGround;
+            state.groundNormal = (state.grounded || state.onSteepGround)
+                ? ToCrescent(character.GetGroundNormal())
+                : Math::Vector3::Up;
+            state.height = record.shapeHeight;
+        }
+    };
+    if (jobCount > 1) {
+        auto fence = std::make_shared<JobFence>();
+        for (size_t job = 1; job < jobCount; ++job) {
+            fence->remaining.fetch_add(1, std::memory_order_relaxed);
+            scheduler.schedule([&runJob, job]() { runJob(job); }, fence);
+        }
+        runJob(0);
+        scheduler.wait(*fence);
+    } else {
+        runJob(0);
+    }
+
+    for (auto* record : moves) {
+        record->transform->setPosition(record->state.position);
+        record->transform = nullptr;
+        record->queued = false;
+    }
+    moves.clear();
+}
+
 } // namespace Crescent
@@ -2,10 +2,12 @@
 
 #include "../Core/UUID.hpp"
 #include "../Math/Math.hpp"
+#include "PhysicsQueryBatch.hpp"
 #include "PhysicsTypes.hpp"
 #include <Jolt/Jolt.h>
 #include <Jolt/Core/Reference.h>
 #include <Jolt/Physics/Collision/Shape/Shape.h>
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
 #include <memory>
@@ -27,16 +29,55 @@ public:
 
     static constexpr uint32_t kAllLayersMask = 0xFFFFFFFFu;
 
+    // Statistics of the latest update. Step figures come from the last simulated step; query and
+    // rebuild counts cover everything since the update before.
+    struct PhysicsStats {
+        float stepTimeMs = 0.0f; // PhysicsSystem::Update of the last step
+        uint32_t collisionSteps = 0; // collision steps that Update ran
+        uint32_t bodies = 0;
+        uint32_t activeBodies = 0; // awake rigid bodies after the step
+        uint32_t broadphasePairs = 0; // body pairs from the broadphase whose shapes touched
+        uint32_t maxBodyPairs = 0;
+        uint32_t contactConstraints = 0; // contact manifolds between solid bodies
+        uint32_t maxContactConstraints = 0;
+        uint32_t raycasts = 0;
+        uint32_t sphereCasts = 0;
+        uint32_t boxCasts = 0;
+        uint32_t capsuleCasts = 0;
+        uint32_t overlapSpheres = 0;
+        uint32_t overlapBoxes = 0;
+        uint32_t scaleRebuilds = 0; // bodies queued for a rebuild because their scale changed
+    };
+    const PhysicsStats& getStats() const { return m_Stats; }
+
     bool initialize();
     void shutdown();
+    // With simulate set, advances the simulation by exactly one step of deltaTime; the engine's
+    // fixed-step clock decides how many steps a frame runs. Otherwise only follows editor moves.
     void update(float deltaTime, bool simulate);
+    // Poses dynamic bodies' transforms between their last two simulated poses, alpha being the
+    // fraction of a step the clock has accumulated past the last one. Once per frame, after the
+    // frame's steps.
+    void interpolateBodies(float alpha);
 
     void setGravity(const Math::Vector3& gravity);
     Math::Vector3 getGravity() const { return m_Gravity; }
     float getFixedTimeStep() const { return m_FixedTimeStep; }
+    void setFixedTimeStep(float step) { m_FixedTimeStep = std::max(step, 0.001f); }
 
     void queueBodyRebuild(Entity* entity);
+    // Builds the queued bodies now rather than at the next update, for a scene preloaded while
+    // another one runs (SceneManager::preloadScene), which is not updated until it activates.
+    void createPendingBodies();
     void removeBody(Entity* entity);
+    // Every body, terrain tile and character at once, for a scene unloading all its entities:
+    // Jolt takes the removals as one batch instead of a broadphase update per body, and the
+    // per-entity removeBody and removeCharacter calls that follow find nothing left to do.
+    void removeAllBodies();
+    // Pages terrain tiles with the world partition: tiles within loadRadius of the focus get
+    // bodies, a few per update, and tiles past unloadRadius drop them. Until a focus is set every
+    // tile is resident.
+    void setStreamingFocus(const Math::Vector3& focus, float loadRadius, float unloadRadius);
 
     void setDebugDrawEnabled(bool enabled) { m_DebugDraw = enabled; }
     bool isDebugDrawEnabled() const { return m_DebugDraw; }
@@ -119,11 +160,52 @@ public:
                    bool includeTriggers = true,
                    const Entity* ignore = nullptr) const;
 
+    // Runs every query of the batch, in parallel on the job system, and fills its hit buffers.
+    // Same results as issuing the queries one by one.
+    void runQueries(PhysicsQueryBatch& batch) const;
+
+    // Characters: capsules moved by JPH::CharacterVirtual, which slide along walls, walk up steps
+    // and stick to the floor without being simulated bodies. A move is queued here and carried
+    // out by the next updateCharacters; the character is created on first use and follows
+    // changes to its settings.
+    void moveCharacter(const Entity* entity,
+                       const PhysicsCharacterSettings& settings,
+                       const Math::Vector3& velocity,
+                       float deltaTime);
+    // The character after its last move; false when the entity has none.
+    bool getCharacterState(const Entity* entity, PhysicsCharacterState& outState) const;
+    void removeCharacter(const Entity* entity);
+    // Runs every queued move, in parallel on the job system, starting each character from its
+    // entity's current position and writing the result back to the transform. Once per frame,
+    // before the variable update.
+    void updateCharacters();
+
+    // Bakes the entity's mesh collider into a cooked shape blob, the static mesh or convex hull
+    // buildShape would make for its current body type. outTransform and outConvex receive what the
+    // blob was baked for, to be handed back through PhysicsCollider::setCookedShape. Empty when the
+    // entity has no mesh collider or the shape cannot be built.
+    std::vector<uint8_t> cookMeshColliderShape(const Entity* entity,
+                                               Math::Matrix4x4& outTransform,
+                                               bool& outConvex) const;
+    // The cooked height texture of the entity's terrain collider, to be handed back through
+    // PhysicsCollider::setCookedHeightField. Empty when the terrain mesh is not a height grid.
+    std::vector<uint8_t> cookTerrainHeightField(const Entity* entity) const;
+
 private:
     struct BodyRecord;
     class PhysicsWorldImpl;
 
     void rebuildBody(Entity* entity);
+    // Creates the entity's body, replacing any old one, without adding it to the simulation.
+    bool createBody(Entity* entity, BodyRecord& outRecord);
+    void registerBody(Entity* entity, const BodyRecord& record);
+    // Terrain colliders get one static height field body per resident tile instead of a record in
+    // m_Bodies.
+    bool createTerrain(Entity* entity, const PhysicsCollider& collider);
+    void removeTerrain(const UUID& uuid);
+    void pageTerrainTiles();
+    void releaseInterpolationSlot(BodyRecord& record);
+    void pruneShapeCache();
     void syncKinematicBodies();
     void syncDynamicBodies();
     void syncEditorBodies();
@@ -136,6 +218,9 @@ private:
                                          const Entity* entity,
                                          RigidbodyType bodyType) const;
     void updateBodyTransform(BodyRecord& record, Entity* entity);
+    void runQuery(const PhysicsQuery& query,
+                  PhysicsQueryBatch::JobHits& hits,
+                  PhysicsQueryBatch::HitRange& outRange) const;
 
 private:
     Scene* m_Scene;
@@ -143,9 +228,9 @@ private:
     std::unordered_set<UUID> m_Pending;
     Math::Vector3 m_Gravity;
     float m_FixedTimeStep;
-    float m_TimeAccumulator;
     bool m_DebugDraw;
     bool m_Initialized;
+    PhysicsStats m_Stats;
     std::unique_ptr<PhysicsWorldImpl> m_Impl;
 };
 
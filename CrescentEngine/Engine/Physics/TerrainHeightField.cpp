@@ -0,0 +1,133 @@
+#include "TerrainHeightField.hpp"
+#include "../Rendering/Mesh.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace Crescent {
+namespace {
+
+constexpr uint32_t kHeightFieldMagic = 0x5447484Au; // 'JHGT'
+constexpr uint32_t kHeightFieldVersion = 1;
+constexpr uint32_t kMaxSampleCount = 8192;
+
+struct HeightFieldHeader {
+    uint32_t magic = kHeightFieldMagic;
+    uint32_t version = kHeightFieldVersion;
+    uint32_t sampleCount = 0;
+    float originX = 0.0f;
+    float originY = 0.0f;
+    float originZ = 0.0f;
+    float spacingX = 1.0f;
+    float spacingZ = 1.0f;
+    float minHeight = 0.0f;
+    float heightRange = 0.0f;
+};
+
+} // namespace
+
+bool BuildTerrainHeightField(const Mesh& mesh, const Math::Matrix4x4& meshTransform, TerrainHeightField& out) {
+    const std::vector<Vertex>& vertices = mesh.getVertices();
+    const uint32_t n = static_cast<uint32_t>(std::lround(std::sqrt(static_cast<double>(vertices.size()))));
+    if (n < 2 || n > kMaxSampleCount || static_cast<size_t>(n) * n != vertices.size()) {
+        return false;
+    }
+
+    // Vertex (i, j) is vertices[j * n + i]. Find which grid direction runs along X and which way
+    // each one points, so the field can be walked with positive spacings.
+    auto at = [&](uint32_t i, uint32_t j) {
+        return meshTransform.transformPoint(vertices[static_cast<size_t>(j) * n + i].position);
+    };
+    const Math::Vector3 corner = at(0, 0);
+    const Math::Vector3 stepI = (at(n - 1, 0) - corner) / static_cast<float>(n - 1);
+    const Math::Vector3 stepJ = (at(0, n - 1) - corner) / static_cast<float>(n - 1);
+    const bool iAlongX = std::abs(stepI.x) >= std::abs(stepI.z);
+    const float stepIX = iAlongX ? stepI.x : stepI.z;
+    const float stepJZ = iAlongX ? stepJ.z : stepJ.x;
+    const float tolerance = 1e-3f * std::max(std::abs(stepIX), std::abs(stepJZ));
+    if (std::abs(stepIX) <= Math::EPSILON || std::abs(stepJZ) <= Math::EPSILON ||
+        std::abs(iAlongX ? stepI.z : stepI.x) > tolerance ||
+        std::abs(iAlongX ? stepJ.x : stepJ.z) > tolerance) {
+        return false;
+    }
+
+    TerrainHeightField field;
+    field.sampleCount = n;
+    field.spacingX = std::abs(stepIX);
+    field.spacingZ = std::abs(stepJZ);
+    field.heights.resize(static_cast<size_t>(n) * n);
+    for (uint32_t j = 0; j < n; ++j) {
+        for (uint32_t i = 0; i < n; ++i) {
+            const Math::Vector3 p = at(i, j);
+            const Math::Vector3 expected = corner + stepI * static_cast<float>(i) + stepJ * static_cast<float>(j);
+            if (std::abs(p.x - expected.x) > tolerance || std::abs(p.z - expected.z) > tolerance) {
+                return false;
+            }
+            const uint32_t column = stepIX > 0.0f ? i : n - 1 - i;
+            const uint32_t row = stepJZ > 0.0f ? j : n - 1 - j;
+            field.heights[static_cast<size_t>(iAlongX ? row : column) * n + (iAlongX ? column : row)] = p.y;
+        }
+    }
+    const Math::Vector3 far = at(n - 1, n - 1);
+    field.origin = Math::Vector3(std::min(corner.x, far.x), 0.0f, std::min(corner.z, far.z));
+    out = std::move(field);
+    return true;
+}
+
+std::vector<uint8_t> EncodeTerrainHeightField(const TerrainHeightField& field) {
+    std::vector<uint8_t> bytes;
+    if (!field.isValid()) {
+        return bytes;
+    }
+    const auto range = std::minmax_element(field.heights.begin(), field.heights.end());
+    HeightFieldHeader header;
+    header.sampleCount = field.sampleCount;
+    header.originX = field.origin.x;
+    header.originY = field.origin.y;
+    header.originZ = field.origin.z;
+    header.spacingX = field.spacingX;
+    header.spacingZ = field.spacingZ;
+    header.minHeight = *range.first;
+    header.heightRange = *range.second - *range.first;
+
+    bytes.resize(sizeof(header) + field.heights.size() * sizeof(uint16_t));
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    const float scale = header.heightRange > 0.0f ? 65535.0f / header.heightRange : 0.0f;
+    uint8_t* samples = bytes.data() + sizeof(header);
+    for (size_t i = 0; i < field.heights.size(); ++i) {
+        const uint16_t quantized = static_cast<uint16_t>(std::lround((field.heights[i] - header.minHeight) * scale));
+        std::memcpy(samples + i * sizeof(uint16_t), &quantized, sizeof(uint16_t));
+    }
+    return bytes;
+}
+
+bool LoadTerrainHeightField(const std::string& path, TerrainHeightField& out) {
+    std::ifstream in(path, std::ios::binary);
+    HeightFieldHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != kHeightFieldMagic || header.version != kHeightFieldVersion ||
+        header.sampleCount < 2 || header.sampleCount > kMaxSampleCount) {
+        std::cerr << "[Physics] Invalid cooked height field: " << path << std::endl;
+        return false;
+    }
+    const size_t count = static_cast<size_t>(header.sampleCount) * header.sampleCount;
+    std::vector<uint16_t> quantized(count);
+    if (!in.read(reinterpret_cast<char*>(quantized.data()), static_cast<std::streamsize>(count * sizeof(uint16_t)))) {
+        std::cerr << "[Physics] Truncated cooked height field: " << path << std::endl;
+        return false;
+    }
+    out.sampleCount = header.sampleCount;
+    out.origin = Math::Vector3(header.originX, header.originY, header.originZ);
+    out.spacingX = header.spacingX;
+    out.spacingZ = header.spacingZ;
+    out.heights.resize(count);
+    const float step = header.heightRange / 65535.0f;
+    for (size_t i = 0; i < count; ++i) {
+        out.heights[i] = header.minHeight + static_cast<float>(quantized[i]) * step;
+    }
+    return true;
+}
+
+} // namespace Crescent
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../Math/Math.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Crescent {
+
+class Mesh;
+
+// A terrain's heights on a square grid in the collider's space: sample (column, row) sits at
+// origin + (column * spacingX, height, row * spacingZ).
+struct TerrainHeightField {
+    uint32_t sampleCount = 0;
+    Math::Vector3 origin = Math::Vector3::Zero;
+    float spacingX = 1.0f;
+    float spacingZ = 1.0f;
+    // Row-major, sampleCount * sampleCount.
+    std::vector<float> heights;
+
+    bool isValid() const {
+        return sampleCount >= 2 && heights.size() == static_cast<size_t>(sampleCount) * sampleCount;
+    }
+};
+
+// Reads the heights of a sculpted terrain plane: a square, regular vertex grid once put through
+// meshTransform. False for any other mesh, or when the transform turns the grid off the XZ axes.
+bool BuildTerrainHeightField(const Mesh& mesh, const Math::Matrix4x4& meshTransform, TerrainHeightField& out);
+
+// The cooked height texture: a small header and 16-bit heights over the field's height range.
+std::vector<uint8_t> EncodeTerrainHeightField(const TerrainHeightField& field);
+bool LoadTerrainHeightField(const std::string& path, TerrainHeightField& out);
+
+} // namespace Crescent
@@ -1,6 +1,7 @@
 #include "Project.hpp"
 #include "../Assets/AssetDatabase.hpp"
 #include "../../../ThirdParty/nlohmann/json.hpp"
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 
@@ -199,6 +200,9 @@ std::shared_ptr<Project> Project::Load(const std::string& projectFilePath) {
         std::string("com.crescentengine.") + SanitizeIdentifierComponent(project->m_Name)
     );
     project->m_Settings.startupScene = data.value("startupScene", std::string());
+    project->m_Settings.pipelinedRendering = data.value("pipelinedRendering", false);
+    project->m_Settings.editorRedrawOnDemand = data.value("editorRedrawOnDemand", true);
+    project->m_Settings.lowLatencyPresentation = data.value("lowLatencyPresentation", false);
     if (data.contains("assetPaths") && data["assetPaths"].is_array()) {
         project->m_Settings.assetPaths.clear();
         for (const auto& entry : data["assetPaths"]) {
@@ -276,6 +280,22 @@ std::shared_ptr<Project> Project::Load(const std::string& projectFilePath) {
         project->m_Settings.inputBindings = DefaultInputBindings();
     }
 
+    if (data.contains("physics") && data["physics"].is_object()) {
+        const json& physics = data["physics"];
+        ProjectSettings::PhysicsSettings& limits = project->m_Settings.physics;
+        limits.fixedTimeStep = std::clamp(physics.value("fixedTimeStep", limits.fixedTimeStep), 0.001f, 0.1f);
+        limits.maxBodies = std::max(physics.value("maxBodies", limits.maxBodies), 1u);
+        limits.maxBodyPairs = std::max(physics.value("maxBodyPairs", limits.maxBodyPairs), 1u);
+        limits.maxContactConstraints = std::max(physics.value("maxContactConstraints", limits.maxContactConstraints), 1u);
+        limits.tempAllocatorMB = std::max(physics.value("tempAllocatorMB", limits.tempAllocatorMB), 1u);
+    }
+    if (data.contains("audio") && data["audio"].is_object()) {
+        const json& audio = data["audio"];
+        ProjectSettings::AudioSettings& voices = project->m_Settings.audio;
+        voices.maxRealVoices = std::max(audio.value("maxRealVoices", voices.maxRealVoices), 1u);
+        voices.audibilityThreshold = std::max(audio.value("audibilityThreshold", voices.audibilityThreshold), 0.0f);
+    }
+
     std::error_code ec;
     std::filesystem::create_directories(project->m_AssetsPath, ec);
     std::filesystem::create_directories(project->m_ScenesPath, ec);
@@ -304,7 +324,10 @@ bool Project::save() const {
                 ? (std::string("com.crescentengine.") + SanitizeIdentifierComponent(m_Name))
                 : m_Settings.bundleIdentifier},
         {"startupScene", m_Settings.startupScene},
-        {"assetPaths", m_Settings.assetPaths}
+        {"assetPaths", m_Settings.assetPaths},
+        {"pipelinedRendering", m_Settings.pipelinedRendering},
+        {"editorRedrawOnDemand", m_Settings.editorRedrawOnDemand},
+        {"lowLatencyPresentation", m_Settings.lowLatencyPresentation}
     };
     if (!m_Settings.renderProfiles.empty()) {
         json profiles = json::array();
@@ -339,6 +362,17 @@ bool Project::save() const {
         }
         data["inputBindings"] = bindings;
     }
+    data["physics"] = {
+        {"fixedTimeStep", m_Settings.physics.fixedTimeStep},
+        {"maxBodies", m_Settings.physics.maxBodies},
+        {"maxBodyPairs", m_Settings.physics.maxBodyPairs},
+        {"maxContactConstraints", m_Settings.physics.maxContactConstraints},
+        {"tempAllocatorMB", m_Settings.physics.tempAllocatorMB}
+    };
+    data["audio"] = {
+        {"maxRealVoices", m_Settings.audio.maxRealVoices},
+        {"audibilityThreshold", m_Settings.audio.audibilityThreshold}
+    };
     std::ofstream out(m_ProjectFilePath);
     if (!out.is_open()) {
         return false;
@@ -355,8 +389,9 @@ ProjectManager& ProjectManager::getInstance() {
 std::shared_ptr<Project> ProjectManager::createProject(const std::string& rootPath, const std::string& name) {
     m_ActiveProject = Project::Create(rootPath, name);
     if (m_ActiveProject) {
-        AssetDatabase::getInstance().setRootPath(m_ActiveProject->getAssetsPath());
+        // Library first: the rescan reads and writes the asset index there.
         AssetDatabase::getInstance().setLibraryPath(m_ActiveProject->getLibraryPath());
+        AssetDatabase::getInstance().setRootPath(m_ActiveProject->getAssetsPath());
     }
     return m_ActiveProject;
 }
@@ -364,8 +399,9 @@ std::shared_ptr<Project> ProjectManager::createProject(const std::string& rootPa
 std::shared_ptr<Project> ProjectManager::openProject(const std::string& projectFilePath) {
     m_ActiveProject = Project::Load(projectFilePath);
     if (m_ActiveProject) {
-        AssetDatabase::getInstance().setRootPath(m_ActiveProject->getAssetsPath());
+        // Library first: the rescan reads and writes the asset index there.
         AssetDatabase::getInstance().setLibraryPath(m_ActiveProject->getLibraryPath());
+        AssetDatabase::getInstance().setRootPath(m_ActiveProject->getAssetsPath());
     }
     return m_ActiveProject;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Scene/SceneSettings.hpp"
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -13,6 +14,12 @@ struct ProjectSettings {
     std::string bundleIdentifier;
     std::string startupScene;
     std::vector<std::string> assetPaths = {"Assets"};
+    // Overlap play-mode update with encoding of the previous frame (see Engine).
+    bool pipelinedRendering = false;
+    // Redraw the editor's scene view only when something it shows changed (see Engine).
+    bool editorRedrawOnDemand = true;
+    // Two drawables, paced presents and a late camera update for the game view (see Engine).
+    bool lowLatencyPresentation = false;
     
     struct RenderProfile {
         std::string name = "High";
@@ -31,10 +38,32 @@ struct ProjectSettings {
         float scale = 1.0f;
         bool invert = false;
     };
+
+    // Sizes every scene's PhysicsWorld, read when the world initializes. Jolt drops contacts past
+    // maxContactConstraints, so dense scenes need it raised; the temp allocator spills to the heap
+    // rather than failing when a step outgrows it. Rendering interpolates between steps, so the
+    // step can be well above a frame.
+    struct PhysicsSettings {
+        float fixedTimeStep = 1.0f / 60.0f;
+        uint32_t maxBodies = 65536;
+        uint32_t maxBodyPairs = 65536;
+        uint32_t maxContactConstraints = 10240;
+        uint32_t tempAllocatorMB = 10;
+    };
+
+    // Caps the AudioSource emitters mixed at once. The rest, and any fainter than
+    // audibilityThreshold at the listener or past their max distance, play virtually: only their
+    // cursor advances until they are audible again.
+    struct AudioSettings {
+        uint32_t maxRealVoices = 64;
+        float audibilityThreshold = 0.001f;
+    };
     
     std::vector<RenderProfile> renderProfiles;
     std::vector<QualityPreset> qualityPresets;
     std::vector<InputBinding> inputBindings;
+    PhysicsSettings physics;
+    AudioSettings audio;
 };
 
 } // namespace Crescent
@@ -0,0 +1,69 @@
+#include "AsyncComputeQueue.hpp"
+#include <Metal/Metal.hpp>
+
+namespace Crescent {
+
+AsyncComputeQueue::AsyncComputeQueue()
+    : m_queue(nullptr)
+    , m_event(nullptr)
+    , m_value(0) {
+}
+
+AsyncComputeQueue::~AsyncComputeQueue() {
+    shutdown();
+}
+
+bool AsyncComputeQueue::initialize(MTL::Device* device) {
+    if (!device) {
+        return false;
+    }
+    m_event = device->newSharedEvent();
+    m_queue = device->newCommandQueue();
+    if (!m_event || !m_queue) {
+        shutdown();
+        return false;
+    }
+    m_queue->setLabel(NS::String::string("Async Compute", NS::UTF8StringEncoding));
+    m_value = 0;
+    return true;
+}
+
+void AsyncComputeQueue::shutdown() {
+    if (m_queue) {
+        m_queue->release();
+        m_queue = nullptr;
+    }
+    if (m_event) {
+        m_event->release();
+        m_event = nullptr;
+    }
+    m_value = 0;
+}
+
+MTL::CommandBuffer* AsyncComputeQueue::begin(MTL::CommandBuffer* graphics) {
+    if (!m_queue || !graphics) {
+        return nullptr;
+    }
+    MTL::CommandBuffer* async = m_queue->commandBuffer();
+    if (!async) {
+        return nullptr;
+    }
+    const uint64_t ready = ++m_value;
+    graphics->encodeSignalEvent(m_event, ready);
+    async->encodeWait(m_event, ready);
+    return async;
+}
+
+void AsyncComputeQueue::join(MTL::CommandBuffer* async, MTL::CommandBuffer* graphics) {
+    if (!async) {
+        return;
+    }
+    const uint64_t done = ++m_value;
+    async->encodeSignalEvent(m_event, done);
+    async->commit();
+    if (graphics) {
+        graphics->encodeWait(m_event, done);
+    }
+}
+
+} // namespace Crescent
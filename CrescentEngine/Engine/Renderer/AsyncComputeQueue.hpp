@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+namespace MTL {
+    class Device;
+    class CommandQueue;
+    class CommandBuffer;
+    class SharedEvent;
+}
+
+namespace Crescent {
+
+// Second command queue for compute passes that can overlap the frame's raster work. A section is
+// opened at the point of the frame's command buffer whose results it needs and joined at the point
+// that consumes its own results; the GPU runs it in between, alongside whatever the frame encodes
+// there. Both hand-offs go through one shared event whose value only increases, so sections of a
+// frame must be joined before the next frame begins any.
+class AsyncComputeQueue {
+public:
+    AsyncComputeQueue();
+    ~AsyncComputeQueue();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_queue != nullptr; }
+
+    // A command buffer on the async queue that starts once `graphics` has finished the work
+    // encoded into it so far. Null if the queue is unavailable.
+    MTL::CommandBuffer* begin(MTL::CommandBuffer* graphics);
+    // Commits `async`; work encoded into `graphics` after this waits for it.
+    void join(MTL::CommandBuffer* async, MTL::CommandBuffer* graphics);
+
+private:
+    MTL::CommandQueue* m_queue;
+    MTL::SharedEvent* m_event;
+    uint64_t m_value;
+};
+
+} // namespace Crescent
@@ -1,4 +1,6 @@
 #include "ClusteredLightingPass.hpp"
+#include "ShaderLibrary.hpp"
+#include "GPUPassProfiler.hpp"
 #include <Metal/Metal.hpp>
 #include <iostream>
 #include <cstring>
@@ -12,6 +14,31 @@ namespace {
         uint32_t _pad0;
         uint32_t _pad1;
     };
+
+    // Mirrors ClusterCullStats in ClusterBuild.metal.
+    struct ClusterCullStats {
+        uint32_t indexCursor;
+        uint32_t activeClusters;
+        uint32_t overflowLights;
+        uint32_t overflowClusters;
+        uint32_t tileOverflowLights;
+        uint32_t _pad[3];
+    };
+
+    MTL::ComputePipelineState* newClusterPipeline(MTL::Device* device, MTL::Library* lib, const char* name) {
+        MTL::Function* func = lib->newFunction(NS::String::string(name, NS::UTF8StringEncoding));
+        if (!func) {
+            std::cerr << "ClusteredLightingPass: missing " << name << " shader\n";
+            return nullptr;
+        }
+        NS::Error* error = nullptr;
+        MTL::ComputePipelineState* pipeline = device->newComputePipelineState(func, &error);
+        func->release();
+        if (!pipeline && error) {
+            std::cerr << "ClusteredLightingPass: pipeline error " << error->localizedDescription()->utf8String() << "\n";
+        }
+        return pipeline;
+    }
 }
 
 ClusteredLightingPass::ClusteredLightingPass()
@@ -35,30 +62,18 @@ bool ClusteredLightingPass::initialize(MTL::Device* device, uint32_t clusterX, u
     m_device = device;
     setGrid(clusterX, clusterY, clusterZ, m_maxLightsPerCluster);
     
-    NS::Error* error = nullptr;
-    MTL::Library* lib = m_device->newDefaultLibrary();
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_device, ShaderLibrary::Module::Lighting);
     if (!lib) {
         std::cerr << "ClusteredLightingPass: missing default Metal library\n";
         return false;
     }
     
-    MTL::Function* func = lib->newFunction(NS::String::string("cluster_build", NS::UTF8StringEncoding));
-    if (!func) {
-        std::cerr << "ClusteredLightingPass: missing cluster_build shader\n";
-        lib->release();
-        return false;
-    }
-    
-    m_pipeline = m_device->newComputePipelineState(func, &error);
-    func->release();
+    m_pipeline = newClusterPipeline(m_device, lib, "cluster_build");
+    m_tileLightsPipeline = newClusterPipeline(m_device, lib, "cluster_tile_lights");
+    m_tileDepthPipeline = newClusterPipeline(m_device, lib, "cluster_tile_depth");
     lib->release();
     
-    if (error) {
-        std::cerr << "ClusteredLightingPass: pipeline error " << error->localizedDescription()->utf8String() << "\n";
-        return false;
-    }
-    
-    return m_pipeline != nullptr;
+    return m_pipeline != nullptr && m_tileLightsPipeline != nullptr;
 }
 
 void ClusteredLightingPass::setGrid(uint32_t clusterX, uint32_t clusterY, uint32_t clusterZ, uint32_t maxLightsPerCluster) {
@@ -79,14 +94,25 @@ void ClusteredLightingPass::setFrameSlot(uint32_t frameSlot) {
 void ClusteredLightingPass::allocateBuffers() {
     if (!m_device) return;
     size_t headersSize = sizeof(ClusterHeader) * m_clusterCount;
+    // Compacted, but sized for the worst case of every cluster at the cap.
     size_t indicesSize = sizeof(uint32_t) * m_clusterCount * m_maxLightsPerCluster;
+    const size_t tileCount = size_t(m_clusterX) * size_t(m_clusterY);
 
     for (uint32_t i = 0; i < kMaxFramesInFlight; ++i) {
         if (m_clusterHeadersRing[i]) { m_clusterHeadersRing[i]->release(); m_clusterHeadersRing[i] = nullptr; }
         if (m_clusterIndicesRing[i]) { m_clusterIndicesRing[i]->release(); m_clusterIndicesRing[i] = nullptr; }
+        if (m_statsRing[i]) { m_statsRing[i]->release(); m_statsRing[i] = nullptr; }
         m_clusterHeadersRing[i] = m_device->newBuffer(headersSize, MTL::ResourceStorageModeShared);
         m_clusterIndicesRing[i] = m_device->newBuffer(indicesSize, MTL::ResourceStorageModeShared);
+        m_statsRing[i] = m_device->newBuffer(sizeof(ClusterCullStats), MTL::ResourceStorageModeShared);
+        std::memset(m_statsRing[i]->contents(), 0, sizeof(ClusterCullStats));
     }
+    if (m_tileMaxDepth) { m_tileMaxDepth->release(); }
+    if (m_tileIndices) { m_tileIndices->release(); }
+    if (m_tileCounts) { m_tileCounts->release(); }
+    m_tileMaxDepth = m_device->newBuffer(sizeof(float) * tileCount, MTL::ResourceStorageModePrivate);
+    m_tileIndices = m_device->newBuffer(sizeof(uint32_t) * tileCount * kMaxLightsPerTile, MTL::ResourceStorageModePrivate);
+    m_tileCounts = m_device->newBuffer(sizeof(uint32_t) * tileCount, MTL::ResourceStorageModePrivate);
     m_clusterHeaders = m_clusterHeadersRing[m_frameSlot];
     m_clusterIndices = m_clusterIndicesRing[m_frameSlot];
 }
@@ -95,10 +121,28 @@ void ClusteredLightingPass::shutdown() {
     for (uint32_t i = 0; i < kMaxFramesInFlight; ++i) {
         if (m_clusterHeadersRing[i]) { m_clusterHeadersRing[i]->release(); m_clusterHeadersRing[i] = nullptr; }
         if (m_clusterIndicesRing[i]) { m_clusterIndicesRing[i]->release(); m_clusterIndicesRing[i] = nullptr; }
+        if (m_statsRing[i]) { m_statsRing[i]->release(); m_statsRing[i] = nullptr; }
     }
     m_clusterHeaders = nullptr;
     m_clusterIndices = nullptr;
+    if (m_tileMaxDepth) { m_tileMaxDepth->release(); m_tileMaxDepth = nullptr; }
+    if (m_tileIndices) { m_tileIndices->release(); m_tileIndices = nullptr; }
+    if (m_tileCounts) { m_tileCounts->release(); m_tileCounts = nullptr; }
     if (m_pipeline) { m_pipeline->release(); m_pipeline = nullptr; }
+    if (m_tileLightsPipeline) { m_tileLightsPipeline->release(); m_tileLightsPipeline = nullptr; }
+    if (m_tileDepthPipeline) { m_tileDepthPipeline->release(); m_tileDepthPipeline = nullptr; }
+}
+
+void ClusteredLightingPass::readStats() {
+    MTL::Buffer* buffer = m_statsRing[m_frameSlot];
+    if (!buffer) {
+        return;
+    }
+    const auto* stats = static_cast<const ClusterCullStats*>(buffer->contents());
+    m_activeClusters = stats->activeClusters;
+    m_overflowClusters = stats->overflowClusters;
+    m_overflowLights = stats->overflowLights;
+    m_tileOverflowLights = stats->tileOverflowLights;
 }
 
 void ClusteredLightingPass::dispatch(MTL::CommandBuffer* cmdBuffer,
@@ -108,20 +152,15 @@ void ClusteredLightingPass::dispatch(MTL::CommandBuffer* cmdBuffer,
                                      float farPlane,
                                      uint32_t viewportWidth,
                                      uint32_t viewportHeight,
-                                     MTL::Buffer* lightBuffer) {
-    if (!cmdBuffer || !m_pipeline || !lightBuffer) return;
-    
-    MTL::ComputeCommandEncoder* enc = cmdBuffer->computeCommandEncoder();
-    enc->setComputePipelineState(m_pipeline);
-    
-    enc->setBuffer(lightBuffer, 0, 0);
-    enc->setBuffer(m_clusterHeaders, 0, 1);
-    enc->setBuffer(m_clusterIndices, 0, 2);
-    // Overflow counter at buffer 3
-    static const uint32_t zero = 0;
-    MTL::Buffer* overflow = m_device->newBuffer(sizeof(uint32_t), MTL::ResourceStorageModeShared);
-    memcpy(overflow->contents(), &zero, sizeof(uint32_t));
-    enc->setBuffer(overflow, 0, 3);
+                                     MTL::Buffer* lightBuffer,
+                                     MTL::Texture* depthTexture) {
+    if (!cmdBuffer || !m_pipeline || !m_tileLightsPipeline || !lightBuffer) return;
+    MTL::Buffer* statsBuffer = m_statsRing[m_frameSlot];
+    if (!statsBuffer || !m_tileMaxDepth || !m_tileIndices || !m_tileCounts) return;
+
+    // The renderer waited for this slot's previous frame, so its counters are final.
+    readStats();
+    std::memset(statsBuffer->contents(), 0, sizeof(ClusterCullStats));
     
     // Upload constants
     struct Params {
@@ -135,6 +174,9 @@ void ClusteredLightingPass::dispatch(MTL::CommandBuffer* cmdBuffer,
         float nearPlane;
         float farPlane;
         float _pad[3]; // pad to 16-byte multiple (Metal expects 176 bytes)
+        uint32_t maxLightsPerTile;
+        uint32_t hasDepthBounds;
+        uint32_t _pad1[2];
     } params;
     params.projection = projection;
     params.projectionInv = projection.inversed();
@@ -147,21 +189,48 @@ void ClusteredLightingPass::dispatch(MTL::CommandBuffer* cmdBuffer,
     params.screenHeight = static_cast<float>(viewportHeight);
     params.nearPlane = nearPlane;
     params.farPlane = farPlane;
+    params.maxLightsPerTile = kMaxLightsPerTile;
+    params.hasDepthBounds = (depthTexture && m_tileDepthPipeline) ? 1u : 0u;
     
+    MTL::ComputeCommandEncoder* enc = m_passProfiler
+        ? m_passProfiler->computeEncoder(cmdBuffer, GPUPass::ClusterBuild)
+        : cmdBuffer->computeCommandEncoder();
+
+    // Farthest prepass depth per screen tile.
+    if (params.hasDepthBounds) {
+        enc->setComputePipelineState(m_tileDepthPipeline);
+        enc->setTexture(depthTexture, 0);
+        enc->setBuffer(m_tileMaxDepth, 0, 0);
+        enc->setBytes(&params, sizeof(Params), 1);
+        enc->dispatchThreadgroups(MTL::Size::Make(m_clusterX, m_clusterY, 1), MTL::Size::Make(16, 16, 1));
+    }
+
+    // Coarse tile light lists.
+    enc->setComputePipelineState(m_tileLightsPipeline);
+    enc->setBuffer(lightBuffer, 0, 0);
+    enc->setBuffer(m_tileMaxDepth, 0, 1);
+    enc->setBuffer(m_tileIndices, 0, 2);
+    enc->setBuffer(m_tileCounts, 0, 3);
+    enc->setBuffer(statsBuffer, 0, 4);
+    enc->setBytes(&params, sizeof(Params), 5);
+    enc->dispatchThreadgroups(MTL::Size::Make((m_clusterX + 7) / 8, (m_clusterY + 7) / 8, 1), MTL::Size::Make(8, 8, 1));
+
+    // Clusters from their tile's list.
+    enc->setComputePipelineState(m_pipeline);
+    enc->setBuffer(lightBuffer, 0, 0);
+    enc->setBuffer(m_clusterHeaders, 0, 1);
+    enc->setBuffer(m_clusterIndices, 0, 2);
+    enc->setBuffer(statsBuffer, 0, 3);
     enc->setBytes(&params, sizeof(Params), 4);
+    enc->setBuffer(m_tileMaxDepth, 0, 5);
+    enc->setBuffer(m_tileIndices, 0, 6);
+    enc->setBuffer(m_tileCounts, 0, 7);
     
     MTL::Size tgSize = MTL::Size::Make(8, 8, 1);
     MTL::Size grid = MTL::Size::Make((m_clusterX + 7) / 8, (m_clusterY + 7) / 8, m_clusterZ);
     enc->dispatchThreadgroups(grid, tgSize);
     
     enc->endEncoding();
-    
-    // Diagnostics
-    uint32_t* overflowPtr = reinterpret_cast<uint32_t*>(overflow->contents());
-    if (overflowPtr && *overflowPtr > 0) {
-        std::cerr << "ClusteredLightingPass: overflowed lights in clusters: " << *overflowPtr << std::endl;
-    }
-    overflow->release();
 }
 
 } // namespace Crescent
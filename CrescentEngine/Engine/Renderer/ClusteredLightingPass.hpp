@@ -10,14 +10,20 @@ namespace MTL {
     class CommandBuffer;
     class ComputePipelineState;
     class Buffer;
+    class Texture;
 }
 
 namespace Crescent {
 
+class GPUPassProfiler;
+
 // Builds cluster headers + light index lists for Forward+/clustered lighting.
+// Two levels: lights are first culled per screen tile (bounded by the prepass depth), then each
+// cluster tests only its tile's lights and takes a compacted range of the index list.
 class ClusteredLightingPass {
 public:
     static constexpr uint32_t kMaxFramesInFlight = 4;
+    static constexpr uint32_t kMaxLightsPerTile = 256;
     ClusteredLightingPass();
     ~ClusteredLightingPass();
     
@@ -26,7 +32,9 @@ public:
     
     void setGrid(uint32_t clusterX, uint32_t clusterY, uint32_t clusterZ, uint32_t maxLightsPerCluster = 64);
     void setFrameSlot(uint32_t frameSlot);
+    void setPassProfiler(GPUPassProfiler* profiler) { m_passProfiler = profiler; }
     
+    // depthTexture is the finished prepass depth; without it clusters span the full depth range.
     void dispatch(MTL::CommandBuffer* cmdBuffer,
                   const LightingSystem& lighting,
                   const Math::Matrix4x4& projection,
@@ -34,7 +42,8 @@ public:
                   float farPlane,
                   uint32_t viewportWidth,
                   uint32_t viewportHeight,
-                  MTL::Buffer* lightBuffer);
+                  MTL::Buffer* lightBuffer,
+                  MTL::Texture* depthTexture = nullptr);
     
     MTL::Buffer* getClusterHeaders() const { return m_clusterHeaders; }
     MTL::Buffer* getClusterIndices() const { return m_clusterIndices; }
@@ -43,13 +52,22 @@ public:
     uint32_t getClusterX() const { return m_clusterX; }
     uint32_t getClusterY() const { return m_clusterY; }
     uint32_t getMaxLightsPerCluster() const { return m_maxLightsPerCluster; }
+
+    // Build results of the latest frame the GPU finished with the current frame slot.
+    uint32_t getActiveClusterCount() const { return m_activeClusters; }
+    uint32_t getOverflowClusterCount() const { return m_overflowClusters; }
+    uint32_t getOverflowLightCount() const { return m_overflowLights; }
+    uint32_t getTileOverflowLightCount() const { return m_tileOverflowLights; }
     
 private:
     void allocateBuffers();
+    void readStats();
     
 private:
     MTL::Device* m_device;
     MTL::ComputePipelineState* m_pipeline;
+    MTL::ComputePipelineState* m_tileDepthPipeline = nullptr;
+    MTL::ComputePipelineState* m_tileLightsPipeline = nullptr;
     MTL::Buffer* m_clusterHeaders; // offset/count per cluster
     MTL::Buffer* m_clusterIndices; // flat light indices
     uint32_t m_clusterX;
@@ -58,8 +76,18 @@ private:
     uint32_t m_clusterCount;
     uint32_t m_maxLightsPerCluster;
     uint32_t m_frameSlot;
+    GPUPassProfiler* m_passProfiler = nullptr;
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_clusterHeadersRing{};
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_clusterIndicesRing{};
+    std::array<MTL::Buffer*, kMaxFramesInFlight> m_statsRing{};
+    // GPU-only scratch of the coarse level.
+    MTL::Buffer* m_tileMaxDepth = nullptr;
+    MTL::Buffer* m_tileIndices = nullptr;
+    MTL::Buffer* m_tileCounts = nullptr;
+    uint32_t m_activeClusters = 0;
+    uint32_t m_overflowClusters = 0;
+    uint32_t m_overflowLights = 0;
+    uint32_t m_tileOverflowLights = 0;
 };
 
 } // namespace Crescent
@@ -0,0 +1,453 @@
+#include "CrowdAnimation.hpp"
+#include "ShaderLibrary.hpp"
+#include "../Components/InstancedMeshRenderer.hpp"
+#include "../Animation/AnimationCompression.hpp"
+#include "../Animation/AnimationPose.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    // Match CrowdSkeletonHeader, CrowdBone and CrowdTrack in PBR.metal.
+    struct SkeletonHeaderGPU {
+        Math::Matrix4x4 globalInverse;
+        uint32_t boneCount;
+        uint32_t _pad[3];
+    };
+    static_assert(sizeof(SkeletonHeaderGPU) == 80, "SkeletonHeaderGPU must match the Metal layout");
+
+    struct BoneGPU {
+        Math::Matrix4x4 inverseBind;
+        float bindPosition[4];
+        float bindRotation[4];
+        float bindScale[4];
+        int32_t parent;
+        int32_t _pad[3];
+    };
+    static_assert(sizeof(BoneGPU) == 128, "BoneGPU must match the Metal layout");
+
+    // Per track: byte offsets of its frames and values in the library, and its key count.
+    struct TrackGPU {
+        uint32_t position[4];
+        uint32_t rotation[4];
+        uint32_t scale[4];
+        float positionMin[4];
+        float positionExtent[4];
+        float scaleMin[4];
+        float scaleExtent[4];
+    };
+    static_assert(sizeof(TrackGPU) == 112, "TrackGPU must match the Metal layout");
+
+    constexpr size_t kLibraryAlignment = 16;
+    constexpr size_t kMinPaletteBytes = 256u * 1024u;
+    constexpr size_t kMinInstanceBytes = 16u * 1024u;
+    constexpr uint64_t kRetireFrames = CrowdAnimation::kMaxFramesInFlight + 1;
+    // Frames a skeleton or clip may go unused before it leaves the library.
+    constexpr uint64_t kEvictFrames = 600;
+
+    size_t GrowCapacity(size_t current, size_t required, size_t minimum) {
+        size_t capacity = std::max(current, minimum);
+        while (capacity < required) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    size_t Append(std::vector<uint8_t>& bytes, const void* data, size_t size) {
+        const size_t offset = (bytes.size() + kLibraryAlignment - 1) & ~(kLibraryAlignment - 1);
+        bytes.resize(offset + size);
+        if (size > 0) {
+            std::memcpy(bytes.data() + offset, data, size);
+        }
+        return offset;
+    }
+
+    template <typename T>
+    size_t AppendArray(std::vector<uint8_t>& bytes, const std::vector<T>& values) {
+        return Append(bytes, values.data(), values.size() * sizeof(T));
+    }
+
+    void StoreVector(float out[4], const Math::Vector3& value) {
+        out[0] = value.x;
+        out[1] = value.y;
+        out[2] = value.z;
+        out[3] = 0.0f;
+    }
+
+    // Clip time to a frame of the compressed grid, the way SampleLocalPose resolves it.
+    float ResolveFrame(const AnimationClip& clip, float frameTicks, float timeSeconds, bool looping) {
+        const float ticksPerSecond = clip.getTicksPerSecond() > 0.0f ? clip.getTicksPerSecond() : 25.0f;
+        float ticks = timeSeconds * ticksPerSecond;
+        const float duration = clip.getDurationTicks();
+        if (duration > 0.0f) {
+            if (looping) {
+                ticks = std::fmod(ticks, duration);
+                if (ticks < 0.0f) {
+                    ticks += duration;
+                }
+            } else {
+                ticks = std::clamp(ticks, 0.0f, duration);
+            }
+        }
+        return frameTicks > 0.0f ? ticks / frameTicks : 0.0f;
+    }
+}
+
+CrowdAnimation::CrowdAnimation()
+    : m_device(nullptr)
+    , m_pipeline(nullptr)
+    , m_frameSlot(0)
+    , m_frame(0)
+    , m_library(nullptr)
+    , m_libraryDirty(false) {
+}
+
+CrowdAnimation::~CrowdAnimation() {
+    shutdown();
+}
+
+bool CrowdAnimation::initialize(MTL::Device* device) {
+    m_device = device;
+    if (!m_device) {
+        return false;
+    }
+
+    NS::Error* error = nullptr;
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_device, ShaderLibrary::Module::Core);
+    if (!lib) {
+        std::cerr << "CrowdAnimation: missing default Metal library\n";
+        return false;
+    }
+
+    MTL::Function* func = lib->newFunction(NS::String::string("crowd_sample_pose", NS::UTF8StringEncoding));
+    if (!func) {
+        std::cerr << "CrowdAnimation: missing crowd_sample_pose shader\n";
+        lib->release();
+        return false;
+    }
+
+    m_pipeline = m_device->newComputePipelineState(func, &error);
+    func->release();
+    lib->release();
+
+    if (!m_pipeline) {
+        if (error) {
+            std::cerr << "CrowdAnimation: pipeline error " << error->localizedDescription()->utf8String() << "\n";
+        }
+        return false;
+    }
+    return true;
+}
+
+void CrowdAnimation::shutdown() {
+    for (Slot& slot : m_slots) {
+        if (slot.palettes) { slot.palettes->release(); slot.palettes = nullptr; }
+        if (slot.instanceBuffer) { slot.instanceBuffer->release(); slot.instanceBuffer = nullptr; }
+        slot.pending.clear();
+        slot.paletteCount = 0;
+        slot.dispatched = false;
+        slot.paletteMemory.reset();
+        slot.instanceMemory.reset();
+    }
+    if (m_library) { m_library->release(); m_library = nullptr; }
+    m_libraryMemory.reset();
+    releaseRetired(true);
+    m_skeletons.clear();
+    m_clips.clear();
+    m_libraryBytes.clear();
+    m_libraryDirty = false;
+    if (m_pipeline) { m_pipeline->release(); m_pipeline = nullptr; }
+    m_device = nullptr;
+}
+
+void CrowdAnimation::beginFrame(uint32_t frameSlot) {
+    ++m_frame;
+    m_frameSlot = frameSlot % kMaxFramesInFlight;
+    Slot& slot = m_slots[m_frameSlot];
+    slot.pending.clear();
+    slot.paletteCount = 0;
+    slot.dispatched = false;
+    releaseRetired(false);
+    evictUnused();
+}
+
+CrowdAnimation::SkeletonEntry* CrowdAnimation::findSkeleton(const std::shared_ptr<Skeleton>& skeleton) {
+    if (!skeleton || skeleton->getBoneCount() == 0) {
+        return nullptr;
+    }
+    auto it = m_skeletons.find(skeleton.get());
+    if (it == m_skeletons.end()) {
+        SkeletonEntry entry;
+        entry.skeleton = skeleton;
+        it = m_skeletons.emplace(skeleton.get(), entry).first;
+        m_libraryDirty = true;
+    }
+    it->second.lastUsedFrame = m_frame;
+    return &it->second;
+}
+
+CrowdAnimation::ClipEntry* CrowdAnimation::findClip(const std::shared_ptr<AnimationClip>& clip,
+                                                    const std::shared_ptr<Skeleton>& skeleton) {
+    if (!clip || !skeleton) {
+        return nullptr;
+    }
+    const auto key = std::make_pair(static_cast<const AnimationClip*>(clip.get()),
+                                    static_cast<const Skeleton*>(skeleton.get()));
+    auto it = m_clips.find(key);
+    if (it == m_clips.end()) {
+        ClipEntry entry;
+        entry.clip = clip;
+        entry.skeleton = skeleton;
+        // The GPU only samples the compressed format; raw clips are compressed once on upload.
+        entry.compressed = clip->getCompressedData() ? std::shared_ptr<const AnimationClip>(clip)
+                                                     : CompressAnimationClip(*clip, skeleton.get());
+        const CompressedAnimationData* data = entry.compressed ? entry.compressed->getCompressedData().get() : nullptr;
+        if (!data) {
+            return nullptr;
+        }
+        entry.frameTicks = data->frameTicks;
+        it = m_clips.emplace(key, std::move(entry)).first;
+        m_libraryDirty = true;
+    }
+    it->second.lastUsedFrame = m_frame;
+    return &it->second;
+}
+
+uint32_t CrowdAnimation::add(const InstancedMeshRenderer* renderer) {
+    if (!m_pipeline || !renderer || !renderer->hasCrowdAnimation()) {
+        return kNoPalette;
+    }
+    Slot& slot = m_slots[m_frameSlot];
+    const auto& states = renderer->getCrowdStates();
+    if (slot.dispatched || states.empty()) {
+        return kNoPalette;
+    }
+    const std::shared_ptr<Skeleton>& skeleton = renderer->getSkeleton();
+    const SkeletonEntry* skeletonEntry = findSkeleton(skeleton);
+    if (!skeletonEntry) {
+        return kNoPalette;
+    }
+
+    const auto& clips = renderer->getAnimationClips();
+    m_clipScratch.assign(clips.size(), nullptr);
+    for (size_t i = 0; i < clips.size(); ++i) {
+        m_clipScratch[i] = findClip(clips[i], skeleton);
+    }
+    auto clipAt = [&](int index) -> const ClipEntry* {
+        return index >= 0 && static_cast<size_t>(index) < m_clipScratch.size() ? m_clipScratch[static_cast<size_t>(index)] : nullptr;
+    };
+
+    const uint32_t boneCount = skeleton->getBoneCount();
+    const uint32_t first = slot.paletteCount;
+    slot.pending.reserve(slot.pending.size() + states.size());
+    for (size_t i = 0; i < states.size(); ++i) {
+        const CrowdInstanceState& state = states[i];
+        PendingInstance instance;
+        instance.skeleton = skeletonEntry;
+        instance.palette = first + static_cast<uint32_t>(i) * boneCount;
+        instance.clip = clipAt(state.clip);
+        if (instance.clip) {
+            instance.frame = ResolveFrame(*instance.clip->compressed, instance.clip->frameTicks, state.time, state.looping);
+        }
+        instance.previousClip = state.fade < 1.0f ? clipAt(state.previousClip) : nullptr;
+        if (instance.previousClip) {
+            instance.previousFrame = ResolveFrame(*instance.previousClip->compressed, instance.previousClip->frameTicks,
+                                                  state.previousTime, state.looping);
+            instance.fade = std::clamp(state.fade, 0.0f, 1.0f);
+        }
+        slot.pending.push_back(instance);
+    }
+    slot.paletteCount += static_cast<uint32_t>(states.size()) * boneCount;
+    return first;
+}
+
+void CrowdAnimation::dispatch(MTL::CommandBuffer* cmdBuffer) {
+    Slot& slot = m_slots[m_frameSlot];
+    if (!cmdBuffer || !m_pipeline || slot.dispatched || slot.pending.empty()) {
+        return;
+    }
+    if (m_libraryDirty) {
+        rebuildLibrary();
+    }
+
+    const size_t paletteBytes = static_cast<size_t>(slot.paletteCount) * sizeof(Math::Matrix4x4);
+    if (!slot.palettes || slot.palettes->length() < paletteBytes) {
+        size_t capacity = GrowCapacity(slot.palettes ? slot.palettes->length() : 0, paletteBytes, kMinPaletteBytes);
+        if (slot.palettes) { slot.palettes->release(); }
+        slot.palettes = m_device->newBuffer(capacity, MTL::ResourceStorageModePrivate);
+        if (slot.palettes) {
+            slot.palettes->setLabel(NS::String::string("Crowd Palettes", NS::UTF8StringEncoding));
+        }
+    }
+    const size_t instanceBytes = slot.pending.size() * sizeof(InstanceGPU);
+    if (!slot.instanceBuffer || slot.instanceBuffer->length() < instanceBytes) {
+        size_t capacity = GrowCapacity(slot.instanceBuffer ? slot.instanceBuffer->length() : 0, instanceBytes, kMinInstanceBytes);
+        if (slot.instanceBuffer) { slot.instanceBuffer->release(); }
+        slot.instanceBuffer = m_device->newBuffer(capacity, MTL::ResourceStorageModeShared);
+    }
+    slot.paletteMemory.reset(MemoryCategory::Skinning, slot.palettes ? slot.palettes->length() : 0);
+    slot.instanceMemory.reset(MemoryCategory::Instances, slot.instanceBuffer ? slot.instanceBuffer->length() : 0);
+    if (!m_library || !slot.palettes || !slot.instanceBuffer) {
+        slot.pending.clear();
+        slot.paletteCount = 0;
+        return;
+    }
+
+    auto* instances = static_cast<InstanceGPU*>(slot.instanceBuffer->contents());
+    for (size_t i = 0; i < slot.pending.size(); ++i) {
+        const PendingInstance& pending = slot.pending[i];
+        InstanceGPU& gpu = instances[i];
+        gpu.skeleton = pending.skeleton->offset;
+        gpu.clip = pending.clip ? pending.clip->offset : kNoPalette;
+        gpu.previousClip = pending.previousClip ? pending.previousClip->offset : kNoPalette;
+        gpu.palette = pending.palette;
+        gpu.frame = pending.frame;
+        gpu.previousFrame = pending.previousFrame;
+        gpu.fade = pending.fade;
+        gpu._pad = 0;
+    }
+
+    const uint32_t instanceCount = static_cast<uint32_t>(slot.pending.size());
+    MTL::ComputeCommandEncoder* enc = cmdBuffer->computeCommandEncoder();
+    enc->setLabel(NS::String::string("Crowd Animation", NS::UTF8StringEncoding));
+    enc->setComputePipelineState(m_pipeline);
+    enc->setBuffer(m_library, 0, 0);
+    enc->setBuffer(slot.instanceBuffer, 0, 1);
+    enc->setBuffer(slot.palettes, 0, 2);
+    enc->setBytes(&instanceCount, sizeof(instanceCount), 3);
+    const NS::UInteger threadWidth = std::min<NS::UInteger>(64, m_pipeline->maxTotalThreadsPerThreadgroup());
+    enc->dispatchThreads(MTL::Size(instanceCount, 1, 1), MTL::Size(threadWidth, 1, 1));
+    enc->endEncoding();
+    slot.dispatched = true;
+}
+
+void CrowdAnimation::evictUnused() {
+    auto stale = [&](uint64_t lastUsedFrame) {
+        return lastUsedFrame + kEvictFrames < m_frame;
+    };
+    for (auto it = m_clips.begin(); it != m_clips.end();) {
+        if (stale(it->second.lastUsedFrame)) {
+            it = m_clips.erase(it);
+            m_libraryDirty = true;
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = m_skeletons.begin(); it != m_skeletons.end();) {
+        if (stale(it->second.lastUsedFrame)) {
+            it = m_skeletons.erase(it);
+            m_libraryDirty = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Lays every skeleton and clip out again and replaces the buffer. Only runs when an entry came or
+// went, so a clip is uploaded once for as long as crowds keep playing it.
+void CrowdAnimation::rebuildLibrary() {
+    m_libraryDirty = false;
+    m_libraryBytes.clear();
+
+    AnimationLocalPose bindPose;
+    for (auto& pair : m_skeletons) {
+        SkeletonEntry& entry = pair.second;
+        const Skeleton& skeleton = *entry.skeleton;
+        const auto& bones = skeleton.getBones();
+        SampleLocalPose(skeleton, nullptr, 0.0f, false, bindPose);
+
+        SkeletonHeaderGPU header{};
+        header.globalInverse = skeleton.getGlobalInverse();
+        header.boneCount = static_cast<uint32_t>(bones.size());
+        std::vector<BoneGPU> gpuBones(bones.size());
+        for (size_t i = 0; i < bones.size(); ++i) {
+            BoneGPU& bone = gpuBones[i];
+            bone.inverseBind = bones[i].inverseBind;
+            StoreVector(bone.bindPosition, bindPose.positions[i]);
+            const Math::Quaternion& rotation = bindPose.rotations[i];
+            bone.bindRotation[0] = rotation.x;
+            bone.bindRotation[1] = rotation.y;
+            bone.bindRotation[2] = rotation.z;
+            bone.bindRotation[3] = rotation.w;
+            StoreVector(bone.bindScale, bindPose.scales[i]);
+            // The kernel resolves parents in one forward pass, so anything else counts as a root.
+            const int parent = bones[i].parentIndex;
+            bone.parent = (parent >= 0 && static_cast<size_t>(parent) < i) ? parent : -1;
+        }
+        entry.offset = static_cast<uint32_t>(Append(m_libraryBytes, &header, sizeof(header)));
+        AppendArray(m_libraryBytes, gpuBones);
+    }
+
+    std::vector<TrackGPU> tracks;
+    for (auto& pair : m_clips) {
+        ClipEntry& entry = pair.second;
+        const AnimationClip& clip = *entry.compressed;
+        const CompressedAnimationData& data = *clip.getCompressedData();
+        const uint32_t boneCount = entry.skeleton->getBoneCount();
+        tracks.assign(boneCount, TrackGPU{});
+        // Tracks go first so the clip's offset is its track table; the keys follow.
+        const size_t tableOffset = Append(m_libraryBytes, tracks.data(), tracks.size() * sizeof(TrackGPU));
+        for (uint32_t bone = 0; bone < boneCount; ++bone) {
+            const AnimationChannel* channel = clip.findChannelByBoneIndex(static_cast<int>(bone));
+            const size_t channelIndex = channel ? static_cast<size_t>(channel - clip.getChannels().data()) : 0;
+            if (!channel || channelIndex >= data.channels.size()) {
+                continue;
+            }
+            const CompressedAnimationChannel& source = data.channels[channelIndex];
+            TrackGPU& track = tracks[bone];
+            auto storeVectorTrack = [&](const CompressedVectorTrack& vector, uint32_t out[4], float outMin[4], float outExtent[4]) {
+                if (vector.frames.empty()) {
+                    return;
+                }
+                out[0] = static_cast<uint32_t>(AppendArray(m_libraryBytes, vector.frames));
+                out[1] = static_cast<uint32_t>(AppendArray(m_libraryBytes, vector.values));
+                out[2] = static_cast<uint32_t>(vector.frames.size());
+                StoreVector(outMin, vector.rangeMin);
+                StoreVector(outExtent, vector.rangeExtent);
+            };
+            storeVectorTrack(source.position, track.position, track.positionMin, track.positionExtent);
+            storeVectorTrack(source.scale, track.scale, track.scaleMin, track.scaleExtent);
+            if (!source.rotation.frames.empty()) {
+                track.rotation[0] = static_cast<uint32_t>(AppendArray(m_libraryBytes, source.rotation.frames));
+                track.rotation[1] = static_cast<uint32_t>(AppendArray(m_libraryBytes, source.rotation.values));
+                track.rotation[2] = static_cast<uint32_t>(source.rotation.frames.size());
+            }
+        }
+        std::memcpy(m_libraryBytes.data() + tableOffset, tracks.data(), tracks.size() * sizeof(TrackGPU));
+        entry.offset = static_cast<uint32_t>(tableOffset);
+    }
+
+    retire(m_library);
+    m_library = nullptr;
+    if (!m_libraryBytes.empty()) {
+        m_library = m_device->newBuffer(m_libraryBytes.data(), m_libraryBytes.size(), MTL::ResourceStorageModeShared);
+        if (m_library) {
+            m_library->setLabel(NS::String::string("Crowd Animation Library", NS::UTF8StringEncoding));
+        }
+    }
+    m_libraryMemory.reset(MemoryCategory::Skinning, m_library ? m_library->length() : 0);
+}
+
+void CrowdAnimation::retire(MTL::Buffer* buffer) {
+    if (buffer) {
+        m_retired.emplace_back(m_frame, buffer);
+    }
+}
+
+void CrowdAnimation::releaseRetired(bool all) {
+    auto due = [&](const std::pair<uint64_t, MTL::Buffer*>& retired) {
+        return all || retired.first + kRetireFrames <= m_frame;
+    };
+    for (auto& retired : m_retired) {
+        if (due(retired)) {
+            retired.second->release();
+        }
+    }
+    m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(), due), m_retired.end());
+}
+
+} // namespace Crescent
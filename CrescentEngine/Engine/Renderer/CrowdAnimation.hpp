@@ -0,0 +1,138 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class CommandBuffer;
+    class ComputePipelineState;
+    class Buffer;
+}
+
+namespace Crescent {
+
+class AnimationClip;
+class InstancedMeshRenderer;
+class Skeleton;
+
+// GPU crowd animation for InstancedMeshRenderer. Skeletons and compressed clips are uploaded once
+// into a shared library buffer, and every frame crowd_sample_pose in PBR.metal samples, blends and
+// skins the pose of each animated instance straight into a palette buffer. The instanced skinned
+// pipelines (vertex_skinned_instanced and its prepass and shadow variants) then read an
+// instance's palette from the offset stored in its InstanceData.
+class CrowdAnimation {
+public:
+    static constexpr uint32_t kMaxFramesInFlight = 4;
+    static constexpr uint32_t kNoPalette = 0xFFFFFFFFu;
+
+    CrowdAnimation();
+    ~CrowdAnimation();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_pipeline != nullptr; }
+
+    // The slot's previous command buffer must have completed.
+    void beginFrame(uint32_t frameSlot);
+    // Queues every instance of the crowd and returns the palette index of the first one; instance i
+    // uses the skeleton's bone count of matrices from there on. kNoPalette when the renderer has no
+    // crowd animation.
+    uint32_t add(const InstancedMeshRenderer* renderer);
+    // Uploads new library entries and the instance table and encodes the sampling pass.
+    void dispatch(MTL::CommandBuffer* cmdBuffer);
+
+    MTL::Buffer* getPaletteBuffer() const { return m_slots[m_frameSlot].palettes; }
+    size_t getInstanceCount() const { return m_slots[m_frameSlot].pending.size(); }
+    size_t getLibraryBytes() const { return m_libraryBytes.size(); }
+
+private:
+    // Matches CrowdInstanceData in PBR.metal. Offsets are byte offsets into the library.
+    struct InstanceGPU {
+        uint32_t skeleton;
+        uint32_t clip;
+        uint32_t previousClip;
+        uint32_t palette;
+        float frame;
+        float previousFrame;
+        float fade;
+        uint32_t _pad;
+    };
+
+    struct SkeletonEntry {
+        std::shared_ptr<const Skeleton> skeleton;
+        uint32_t offset = 0;
+        uint64_t lastUsedFrame = 0;
+    };
+
+    struct ClipEntry {
+        std::shared_ptr<const AnimationClip> clip;
+        // The clip the tracks come from: clip itself, or a copy compressed for the upload.
+        std::shared_ptr<const AnimationClip> compressed;
+        std::shared_ptr<const Skeleton> skeleton;
+        float frameTicks = 1.0f;
+        uint32_t offset = 0;
+        uint64_t lastUsedFrame = 0;
+    };
+
+    struct ClipKeyHash {
+        size_t operator()(const std::pair<const AnimationClip*, const Skeleton*>& key) const {
+            size_t h = reinterpret_cast<size_t>(key.first);
+            h ^= reinterpret_cast<size_t>(key.second) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+
+    // A queued instance. Library offsets are only final once dispatch() has rebuilt the library,
+    // so the entries are resolved there.
+    struct PendingInstance {
+        const SkeletonEntry* skeleton = nullptr;
+        const ClipEntry* clip = nullptr;
+        const ClipEntry* previousClip = nullptr;
+        uint32_t palette = 0;
+        float frame = 0.0f;
+        float previousFrame = 0.0f;
+        float fade = 1.0f;
+    };
+
+    struct Slot {
+        MTL::Buffer* palettes = nullptr; // GPU-only skin matrices
+        MTL::Buffer* instanceBuffer = nullptr;
+        std::vector<PendingInstance> pending;
+        uint32_t paletteCount = 0;
+        bool dispatched = false;
+        TrackedMemory paletteMemory;
+        TrackedMemory instanceMemory;
+    };
+
+    SkeletonEntry* findSkeleton(const std::shared_ptr<Skeleton>& skeleton);
+    ClipEntry* findClip(const std::shared_ptr<AnimationClip>& clip, const std::shared_ptr<Skeleton>& skeleton);
+    void evictUnused();
+    void rebuildLibrary();
+    void retire(MTL::Buffer* buffer);
+    void releaseRetired(bool all);
+
+    MTL::Device* m_device;
+    MTL::ComputePipelineState* m_pipeline;
+    std::array<Slot, kMaxFramesInFlight> m_slots;
+    uint32_t m_frameSlot;
+    uint64_t m_frame;
+
+    std::unordered_map<const Skeleton*, SkeletonEntry> m_skeletons;
+    std::unordered_map<std::pair<const AnimationClip*, const Skeleton*>, ClipEntry, ClipKeyHash> m_clips;
+    std::vector<const ClipEntry*> m_clipScratch;
+    std::vector<uint8_t> m_libraryBytes;
+    MTL::Buffer* m_library;
+    TrackedMemory m_libraryMemory;
+    bool m_libraryDirty;
+    // Library buffers the GPU may still be reading, with the frame they were replaced in.
+    std::vector<std::pair<uint64_t, MTL::Buffer*>> m_retired;
+};
+
+} // namespace Crescent
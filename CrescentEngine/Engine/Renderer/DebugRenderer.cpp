@@ -1,5 +1,7 @@
 #include "DebugRenderer.hpp"
 #include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <cmath>
 
@@ -12,15 +14,32 @@ struct alignas(16) DebugUniforms {
     Math::Vector4 cameraPosition;         // 16 bytes (offset 80) - w unused
     Math::Vector4 gridParams;             // 16 bytes (offset 96)  - (gridSize, gridFadeStart, gridFadeEnd, gridCellSize)
     Math::Vector2 gridOrigin;             // 8 bytes  (offset 112) - snapped origin in XZ
-    Math::Vector2 padding;                // 8 bytes  (offset 120) - keep 128-byte size
+    Math::Vector2 padding;                // 8 bytes  (offset 120)
+    Math::Vector4 lineParams;             // 16 bytes (offset 128) - (viewportWidth, viewportHeight, lineWidth, unused)
 };
 
-static_assert(sizeof(DebugUniforms) == 128, "DebugUniforms size must match Metal side");
+static_assert(sizeof(DebugUniforms) == 144, "DebugUniforms size must match Metal side");
+static_assert(sizeof(DebugLineGPU) == 48, "DebugLineGPU size must match Metal side");
+static_assert(sizeof(DebugShapeGPU) == 96, "DebugShapeGPU size must match Metal side");
+
+namespace {
+// Offsets inside a slot buffer stay 256-byte aligned for constant-buffer binds.
+constexpr size_t kSlotAlignment = 256;
+constexpr uint32_t kBoxEdges = 12;
+
+size_t AlignSlotOffset(size_t offset) {
+    return (offset + kSlotAlignment - 1) & ~(kSlotAlignment - 1);
+}
+} // namespace
 
 DebugRenderer::DebugRenderer()
-    : m_lineBuffer(nullptr)
+    : m_maxSphereSegments(0)
+    , m_lineWidth(1.5f)
     , m_linePipelineState(nullptr)
-    , m_lineBufferCapacity(10000)
+    , m_frameSlot(0)
+    , m_gridOffset(0)
+    , m_lineOffset(0)
+    , m_shapeOffset(0)
     , m_gridEnabled(true)
     , m_gridSize(400.0f)           // World grid span
     , m_gridCellSize(1.0f)         // 1 meter cells
@@ -29,10 +48,8 @@ DebugRenderer::DebugRenderer()
     , m_gridFadeEnd(80.0f)
     , m_gridOriginX(0.0f)
     , m_gridOriginZ(0.0f)
-    , m_gridVertexBuffer(nullptr)
     , m_gridPipelineState(nullptr)
     , m_gridVertexCount(0)
-    , m_debugUniformBuffer(nullptr)
     , m_device(nullptr)
     , m_initialized(false) {
 }
@@ -56,26 +73,17 @@ bool DebugRenderer::initialize(MTL::Device* device) {
     
     std::cout << "Initializing DebugRenderer..." << std::endl;
     
-    // Create line buffer (dynamic)
-    m_lineBuffer = device->newBuffer(
-        m_lineBufferCapacity * sizeof(DebugVertex),
-        MTL::ResourceStorageModeShared
-    );
-    
-    if (!m_lineBuffer) {
-        std::cerr << "Failed to create debug line buffer!" << std::endl;
-        return false;
+    // Slot buffers start small and grow with the geometry the views record
+    for (FrameSlot& slot : m_slots) {
+        if (!reserveSlot(slot, 64 * 1024)) {
+            std::cerr << "Failed to create debug frame buffers!" << std::endl;
+            return false;
+        }
     }
     
     // Create initial grid geometry at origin
     updateGridGeometry(Math::Vector3::Zero);
     
-    // Create uniform buffer
-    m_debugUniformBuffer = device->newBuffer(
-        sizeof(DebugUniforms),
-        MTL::ResourceStorageModeShared
-    );
-    
     m_initialized = true;
     std::cout << "DebugRenderer initialized successfully" << std::endl;
     std::cout << "  Grid enabled: " << (m_gridEnabled ? "Yes" : "No") << std::endl;
@@ -86,33 +94,26 @@ bool DebugRenderer::initialize(MTL::Device* device) {
 }
 
 void DebugRenderer::shutdown() {
-    if (!m_initialized) return;
-    
-    if (m_lineBuffer) {
-        m_lineBuffer->release();
-        m_lineBuffer = nullptr;
+    for (FrameSlot& slot : m_slots) {
+        if (slot.buffer) {
+            slot.buffer->release();
+            slot.buffer = nullptr;
+        }
+        slot.capacity = 0;
+        slot.memory.reset();
     }
+    if (!m_initialized) return;
     
     if (m_linePipelineState) {
         m_linePipelineState->release();
         m_linePipelineState = nullptr;
     }
     
-    if (m_gridVertexBuffer) {
-        m_gridVertexBuffer->release();
-        m_gridVertexBuffer = nullptr;
-    }
-    
     if (m_gridPipelineState) {
         m_gridPipelineState->release();
         m_gridPipelineState = nullptr;
     }
     
-    if (m_debugUniformBuffer) {
-        m_debugUniformBuffer->release();
-        m_debugUniformBuffer = nullptr;
-    }
-    
     m_initialized = false;
     std::cout << "DebugRenderer shutdown complete" << std::endl;
 }
@@ -127,8 +128,6 @@ void DebugRenderer::createGridGeometry() {
 }
 
 void DebugRenderer::updateGridGeometry(const Math::Vector3& cameraPosition) {
-    if (!m_device) return;
-    
     // World-locked quad (XZ plane) centered around snapped origin
     float halfSize = m_gridSize * 0.5f;
     float targetOriginX = std::floor(cameraPosition.x / m_gridCellSize) * m_gridCellSize;
@@ -147,7 +146,7 @@ void DebugRenderer::updateGridGeometry(const Math::Vector3& cameraPosition) {
     
     Math::Vector4 quadColor(1.0f, 1.0f, 1.0f, 1.0f); // actual tint handled in shader via uniforms
     
-    std::vector<DebugVertex> verts = {
+    m_gridVertices = {
         // Triangle 1
         DebugVertex(bl, quadColor),
         DebugVertex(br, quadColor),
@@ -157,40 +156,78 @@ void DebugRenderer::updateGridGeometry(const Math::Vector3& cameraPosition) {
         DebugVertex(br, quadColor),
         DebugVertex(tr, quadColor)
     };
-    
-    m_gridVertexCount = verts.size();
-    
-    size_t requiredSize = m_gridVertexCount * sizeof(DebugVertex);
-    if (!m_gridVertexBuffer || requiredSize > m_gridVertexBuffer->length()) {
-        if (m_gridVertexBuffer) {
-            m_gridVertexBuffer->release();
-        }
-        m_gridVertexBuffer = m_device->newBuffer(
-            requiredSize,
-            MTL::ResourceStorageModeShared
-        );
-        std::cout << "Grid buffer resized to " << m_gridVertexCount << " vertices" << std::endl;
+    m_gridVertexCount = m_gridVertices.size();
+}
+
+bool DebugRenderer::reserveSlot(FrameSlot& slot, size_t bytes) {
+    if (slot.buffer && slot.capacity >= bytes) {
+        return true;
     }
-    
-    memcpy(m_gridVertexBuffer->contents(), verts.data(), requiredSize);
+    // Grow with headroom so a scene whose debug geometry creeps up does not reallocate every frame
+    size_t capacity = std::max(bytes + bytes / 2, slot.capacity * 2);
+    MTL::Buffer* buffer = m_device->newBuffer(capacity, MTL::ResourceStorageModeShared);
+    if (!buffer) {
+        return false;
+    }
+    if (slot.buffer) {
+        slot.buffer->release();
+    }
+    slot.buffer = buffer;
+    slot.capacity = capacity;
+    slot.memory.reset(MemoryCategory::Instances, capacity);
+    return true;
 }
 
 void DebugRenderer::clear() {
     m_lines.clear();
+    m_boxes.clear();
+    m_spheres.clear();
+    m_meshWires.clear();
+    m_maxSphereSegments = 0;
+}
+
+void DebugRenderer::drawMeshWireframe(const std::shared_ptr<Mesh>& mesh, const Math::Matrix4x4& transform,
+                                      const Math::Vector4& color) {
+    if (!mesh) {
+        return;
+    }
+    m_meshWires.push_back({mesh, {transform, color}});
 }
 
-void DebugRenderer::render(MTL::RenderCommandEncoder* encoder,
+void DebugRenderer::render(uint32_t frameSlot,
                            const Math::Matrix4x4& viewMatrix,
                            const Math::Matrix4x4& projectionMatrix,
-                           const Math::Vector3& cameraPosition) {
+                           const Math::Vector3& cameraPosition,
+                           float viewportWidth,
+                           float viewportHeight) {
     if (!m_initialized) return;
     
-    // Upload line data to GPU buffer
-    uploadLineData();
-    
     // Rebuild grid around the camera each frame
     updateGridGeometry(cameraPosition);
     
+    // Layout: uniforms, grid quad, line records, box then sphere instances
+    const size_t gridBytes = m_gridVertexCount * sizeof(DebugVertex);
+    const size_t lineBytes = m_lines.size() * sizeof(DebugLineGPU);
+    const size_t shapeBytes = (m_boxes.size() + m_spheres.size()) * sizeof(DebugShapeGPU);
+    m_gridOffset = AlignSlotOffset(sizeof(DebugUniforms));
+    m_lineOffset = AlignSlotOffset(m_gridOffset + gridBytes);
+    m_shapeOffset = AlignSlotOffset(m_lineOffset + lineBytes);
+    
+    m_frameSlot = frameSlot % kMaxFramesInFlight;
+    FrameSlot& slot = m_slots[m_frameSlot];
+    if (!reserveSlot(slot, m_shapeOffset + shapeBytes)) {
+        // Out of memory: draw the grid alone this frame
+        m_lines.clear();
+        m_boxes.clear();
+        m_spheres.clear();
+        if (!slot.buffer || slot.capacity < m_lineOffset) {
+            m_gridVertexCount = 0;
+            m_shapeBatches = {};
+            return;
+        }
+    }
+    uint8_t* contents = static_cast<uint8_t*>(slot.buffer->contents());
+    
     // Upload uniform data
     DebugUniforms uniforms{};
     uniforms.viewProjectionMatrix = projectionMatrix * viewMatrix;
@@ -201,139 +238,73 @@ void DebugRenderer::render(MTL::RenderCommandEncoder* encoder,
     uniforms.gridParams = Math::Vector4(m_gridSize, m_gridFadeStart, m_gridFadeEnd, m_gridCellSize);
     uniforms.gridOrigin = Math::Vector2(m_gridOriginX, m_gridOriginZ);
     uniforms.padding = Math::Vector2(0.0f, 0.0f);
+    uniforms.lineParams = Math::Vector4(std::max(viewportWidth, 1.0f), std::max(viewportHeight, 1.0f), m_lineWidth, 0.0f);
+    memcpy(contents, &uniforms, sizeof(DebugUniforms));
     
-    memcpy(m_debugUniformBuffer->contents(), &uniforms, sizeof(DebugUniforms));
-    
-    // Render will be handled in Renderer class
-}
-
-void DebugRenderer::renderLines(MTL::RenderCommandEncoder* encoder,
-                                const Math::Matrix4x4& viewMatrix,
-                                const Math::Matrix4x4& projectionMatrix) {
-    uploadLineData();
-}
-
-void DebugRenderer::renderGrid(MTL::RenderCommandEncoder* encoder,
-                               const Math::Matrix4x4& viewMatrix,
-                               const Math::Matrix4x4& projectionMatrix) {
-}
-
-void DebugRenderer::uploadLineData() {
-    if (m_lines.empty()) return;
-    
-    size_t requiredSize = m_lines.size() * sizeof(DebugVertex);
-    if (requiredSize > m_lineBuffer->length()) {
-        m_lineBuffer->release();
-        m_lineBufferCapacity = m_lines.size() * 2;
-        m_lineBuffer = m_device->newBuffer(
-            m_lineBufferCapacity * sizeof(DebugVertex),
-            MTL::ResourceStorageModeShared
-        );
-        std::cout << "Debug line buffer resized to " << m_lineBufferCapacity << " vertices" << std::endl;
+    memcpy(contents + m_gridOffset, m_gridVertices.data(), gridBytes);
+    if (!m_lines.empty()) {
+        memcpy(contents + m_lineOffset, m_lines.data(), lineBytes);
+    }
+    if (!m_boxes.empty()) {
+        memcpy(contents + m_shapeOffset, m_boxes.data(), m_boxes.size() * sizeof(DebugShapeGPU));
+    }
+    if (!m_spheres.empty()) {
+        memcpy(contents + m_shapeOffset + m_boxes.size() * sizeof(DebugShapeGPU),
+               m_spheres.data(), m_spheres.size() * sizeof(DebugShapeGPU));
     }
     
-    memcpy(m_lineBuffer->contents(), m_lines.data(), requiredSize);
+    ShapeBatch& boxes = m_shapeBatches[static_cast<uint32_t>(ShapeKind::Box)];
+    boxes.firstInstance = 0;
+    boxes.instanceCount = static_cast<uint32_t>(m_boxes.size());
+    boxes.edgesPerInstance = kBoxEdges;
+    ShapeBatch& spheres = m_shapeBatches[static_cast<uint32_t>(ShapeKind::Sphere)];
+    spheres.firstInstance = boxes.instanceCount;
+    spheres.instanceCount = static_cast<uint32_t>(m_spheres.size());
+    // Instances with fewer segments than the batch's largest emit degenerate edges for the rest
+    spheres.edgesPerInstance = 3 * m_maxSphereSegments;
+    
+    // Render will be handled in Renderer class
 }
 
 void DebugRenderer::drawLine(const Math::Vector3& start, const Math::Vector3& end,
                              const Math::Vector4& color) {
-    m_lines.push_back(DebugVertex(start, color));
-    m_lines.push_back(DebugVertex(end, color));
+    DebugLineGPU line;
+    line.start = Math::Vector4(start.x, start.y, start.z, 1.0f);
+    line.end = Math::Vector4(end.x, end.y, end.z, 1.0f);
+    line.color = color;
+    m_lines.push_back(line);
 }
 
 void DebugRenderer::drawBox(const Math::Vector3& center, const Math::Vector3& size,
                             const Math::Vector4& color) {
-    Math::Vector3 halfSize = size * 0.5f;
-    
-    Math::Vector3 v0 = center + Math::Vector3(-halfSize.x, -halfSize.y, -halfSize.z);
-    Math::Vector3 v1 = center + Math::Vector3( halfSize.x, -halfSize.y, -halfSize.z);
-    Math::Vector3 v2 = center + Math::Vector3( halfSize.x, -halfSize.y,  halfSize.z);
-    Math::Vector3 v3 = center + Math::Vector3(-halfSize.x, -halfSize.y,  halfSize.z);
-    
-    Math::Vector3 v4 = center + Math::Vector3(-halfSize.x, halfSize.y, -halfSize.z);
-    Math::Vector3 v5 = center + Math::Vector3( halfSize.x, halfSize.y, -halfSize.z);
-    Math::Vector3 v6 = center + Math::Vector3( halfSize.x, halfSize.y,  halfSize.z);
-    Math::Vector3 v7 = center + Math::Vector3(-halfSize.x, halfSize.y,  halfSize.z);
-    
-    // Bottom face
-    drawLine(v0, v1, color);
-    drawLine(v1, v2, color);
-    drawLine(v2, v3, color);
-    drawLine(v3, v0, color);
-    
-    // Top face
-    drawLine(v4, v5, color);
-    drawLine(v5, v6, color);
-    drawLine(v6, v7, color);
-    drawLine(v7, v4, color);
-    
-    // Vertical edges
-    drawLine(v0, v4, color);
-    drawLine(v1, v5, color);
-    drawLine(v2, v6, color);
-    drawLine(v3, v7, color);
+    DebugShapeGPU box;
+    box.transform = Math::Matrix4x4::Translate(center) * Math::Matrix4x4::Scale(size * 0.5f);
+    box.color = color;
+    box.params = Math::Vector4(0.0f);
+    m_boxes.push_back(box);
 }
 
 void DebugRenderer::drawSphere(const Math::Vector3& center, float radius,
                                const Math::Vector4& color, int segments) {
-    float angleStep = Math::TWO_PI / segments;
-    
-    // XY plane
-    for (int i = 0; i < segments; ++i) {
-        float angle1 = i * angleStep;
-        float angle2 = (i + 1) * angleStep;
-        
-        Math::Vector3 p1 = center + Math::Vector3(
-            std::cos(angle1) * radius,
-            std::sin(angle1) * radius,
-            0
-        );
-        Math::Vector3 p2 = center + Math::Vector3(
-            std::cos(angle2) * radius,
-            std::sin(angle2) * radius,
-            0
-        );
-        
-        drawLine(p1, p2, color);
-    }
-    
-    // XZ plane
-    for (int i = 0; i < segments; ++i) {
-        float angle1 = i * angleStep;
-        float angle2 = (i + 1) * angleStep;
-        
-        Math::Vector3 p1 = center + Math::Vector3(
-            std::cos(angle1) * radius,
-            0,
-            std::sin(angle1) * radius
-        );
-        Math::Vector3 p2 = center + Math::Vector3(
-            std::cos(angle2) * radius,
-            0,
-            std::sin(angle2) * radius
-        );
-        
-        drawLine(p1, p2, color);
-    }
-    
-    // YZ plane
-    for (int i = 0; i < segments; ++i) {
-        float angle1 = i * angleStep;
-        float angle2 = (i + 1) * angleStep;
-        
-        Math::Vector3 p1 = center + Math::Vector3(
-            0,
-            std::cos(angle1) * radius,
-            std::sin(angle1) * radius
-        );
-        Math::Vector3 p2 = center + Math::Vector3(
-            0,
-            std::cos(angle2) * radius,
-            std::sin(angle2) * radius
-        );
-        
-        drawLine(p1, p2, color);
-    }
+    // XY, XZ and YZ rings, as the GPU expands them
+    const uint32_t ringSegments = static_cast<uint32_t>(std::max(segments, 3));
+    DebugShapeGPU sphere;
+    sphere.transform = Math::Matrix4x4::Translate(center) * Math::Matrix4x4::Scale(Math::Vector3(radius));
+    sphere.color = color;
+    sphere.params = Math::Vector4(static_cast<float>(ringSegments), 0.0f, 0.0f, 0.0f);
+    m_spheres.push_back(sphere);
+    m_maxSphereSegments = std::max(m_maxSphereSegments, ringSegments);
+}
+
+void DebugRenderer::drawFrustum(const Math::Matrix4x4& viewProjection, const Math::Vector4& color) {
+    // The template cube spans z in [-1,1]; clip space depth is [0,1]
+    const Math::Matrix4x4 cubeToClip = Math::Matrix4x4::Translate(Math::Vector3(0.0f, 0.0f, 0.5f))
+        * Math::Matrix4x4::Scale(Math::Vector3(1.0f, 1.0f, 0.5f));
+    DebugShapeGPU frustum;
+    frustum.transform = viewProjection.inversed() * cubeToClip;
+    frustum.color = color;
+    frustum.params = Math::Vector4(0.0f);
+    m_boxes.push_back(frustum);
 }
 
 void DebugRenderer::drawAxes(const Math::Vector3& position, float size) {
@@ -1,6 +1,9 @@
 #pragma once
 
+#include "../Core/MemoryTracker.hpp"
 #include "../Math/Math.hpp"
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <memory>
 
@@ -14,6 +17,8 @@ namespace MTL {
 
 namespace Crescent {
 
+class Mesh;
+
 // Debug line vertex
 struct DebugVertex {
     Math::Vector3 position;
@@ -24,20 +29,68 @@ struct DebugVertex {
         : position(pos), color(col) {}
 };
 
-// Debug rendering system for lines, grids, bounding boxes, axes
+// Debug line segment as the GPU reads it (must match DebugLine in Debug.metal)
+struct DebugLineGPU {
+    Math::Vector4 start; // xyz, w unused
+    Math::Vector4 end;
+    Math::Vector4 color;
+};
+
+// One box, sphere or frustum instance (must match DebugShape in Debug.metal). The transform maps
+// the shape's template (the [-1,1] cube's edges or three unit rings) to world space; a frustum is
+// the cube through an inverse view-projection.
+struct DebugShapeGPU {
+    Math::Matrix4x4 transform;
+    Math::Vector4 color;
+    Math::Vector4 params; // x = ring segments for spheres
+};
+
+// Per-draw data of a mesh wireframe (must match DebugMeshWire in Debug.metal)
+struct DebugMeshWireGPU {
+    Math::Matrix4x4 transform;
+    Math::Vector4 color;
+};
+
+// Debug rendering system for lines, grids, bounding boxes, axes.
+//
+// Everything is recorded on the CPU as one record per line or shape and copied once per view into
+// that frame slot's persistent buffer, which only ever grows. The GPU expands each segment, and
+// each edge of a shape instance, into a screen-space quad of the line width.
 class DebugRenderer {
 public:
+    // Instanced shape templates, drawn one batch per kind.
+    enum class ShapeKind : uint32_t {
+        Box = 0,    // 12 cube edges
+        Sphere = 1  // three rings of params.x segments
+    };
+    struct ShapeBatch {
+        uint32_t firstInstance = 0;
+        uint32_t instanceCount = 0;
+        uint32_t edgesPerInstance = 0;
+    };
+    // An uploaded mesh drawn as its triangles' edges. The GPU shades the edges from barycentric
+    // coordinates, so no edge list is built on the CPU.
+    struct MeshWire {
+        std::shared_ptr<Mesh> mesh;
+        DebugMeshWireGPU params;
+    };
+
+    static constexpr uint32_t kMaxFramesInFlight = 4;
+
     DebugRenderer();
     ~DebugRenderer();
     
     bool initialize(MTL::Device* device);
     void shutdown();
     
-    // Render all debug geometry
-    void render(MTL::RenderCommandEncoder* encoder, 
+    // Uploads this view's debug geometry and uniforms into the frame slot's buffer; the slot's
+    // previous command buffer must have completed. Viewport size is in pixels.
+    void render(uint32_t frameSlot,
                 const Math::Matrix4x4& viewMatrix,
                 const Math::Matrix4x4& projectionMatrix,
-                const Math::Vector3& cameraPosition);
+                const Math::Vector3& cameraPosition,
+                float viewportWidth,
+                float viewportHeight);
     
     // Clear all debug geometry (called each frame)
     void clear();
@@ -56,6 +109,19 @@ public:
     void drawSphere(const Math::Vector3& center, float radius,
                     const Math::Vector4& color = Math::Vector4(1, 1, 1, 1),
                     int segments = 16);
+
+    // Draw the edges of the volume a view-projection matrix sees (Metal clip space, z in [0,1])
+    void drawFrustum(const Math::Matrix4x4& viewProjection,
+                     const Math::Vector4& color = Math::Vector4(1, 1, 1, 1));
+    
+    // Draw every triangle edge of an uploaded mesh. Only valid while supportsMeshWireframes();
+    // otherwise draw the mesh's getWireframeEdges() as lines.
+    void drawMeshWireframe(const std::shared_ptr<Mesh>& mesh, const Math::Matrix4x4& transform,
+                           const Math::Vector4& color = Math::Vector4(1, 1, 1, 1));
+    bool supportsMeshWireframes() const { return m_meshWireframes; }
+    // Set by the renderer once its barycentric wireframe pipeline exists.
+    void setMeshWireframesSupported(bool supported) { m_meshWireframes = supported; }
+    const std::vector<MeshWire>& getMeshWires() const { return m_meshWires; }
     
     // Draw transform axes (X=red, Y=green, Z=blue)
     void drawAxes(const Math::Vector3& position, float size = 1.0f);
@@ -78,32 +144,50 @@ public:
     void setGridFadeStart(float distance) { m_gridFadeStart = distance; }
     void setGridFadeEnd(float distance) { m_gridFadeEnd = distance; }
     
-    // Get buffers for rendering
-    MTL::Buffer* getLineBuffer() { return m_lineBuffer; }
-    MTL::Buffer* getGridBuffer() { return m_gridVertexBuffer; }
-    MTL::Buffer* getUniformBuffer() { return m_debugUniformBuffer; }
+    // Screen-space width of lines and shape edges, in pixels
+    void setLineWidth(float pixels) { m_lineWidth = pixels; }
+    float getLineWidth() const { return m_lineWidth; }
+    
+    // Buffers of the slot last passed to render(); everything lives in one buffer at these offsets
+    MTL::Buffer* getFrameBuffer() const { return m_slots[m_frameSlot].buffer; }
+    size_t getUniformOffset() const { return 0; }
+    size_t getGridOffset() const { return m_gridOffset; }
+    size_t getLineOffset() const { return m_lineOffset; }
+    size_t getShapeOffset() const { return m_shapeOffset; }
     size_t getLineCount() const { return m_lines.size(); }
     size_t getGridVertexCount() const { return m_gridVertexCount; }
+    const ShapeBatch& getShapeBatch(ShapeKind kind) const { return m_shapeBatches[static_cast<uint32_t>(kind)]; }
     
 private:
+    struct FrameSlot {
+        MTL::Buffer* buffer = nullptr;
+        size_t capacity = 0;
+        TrackedMemory memory;
+    };
+
     void createPipelineStates(MTL::Device* device);
-    void renderLines(MTL::RenderCommandEncoder* encoder,
-                     const Math::Matrix4x4& viewMatrix,
-                     const Math::Matrix4x4& projectionMatrix);
-    void renderGrid(MTL::RenderCommandEncoder* encoder,
-                    const Math::Matrix4x4& viewMatrix,
-                    const Math::Matrix4x4& projectionMatrix);
-    
-    void uploadLineData();
     void createGridGeometry();
     void updateGridGeometry(const Math::Vector3& cameraPosition);
+    bool reserveSlot(FrameSlot& slot, size_t bytes);
     
 private:
-    // Line rendering
-    std::vector<DebugVertex> m_lines;
-    MTL::Buffer* m_lineBuffer;
+    // Line and shape records, rebuilt every frame
+    std::vector<DebugLineGPU> m_lines;
+    std::vector<DebugShapeGPU> m_boxes;
+    std::vector<DebugShapeGPU> m_spheres;
+    std::vector<MeshWire> m_meshWires;
+    bool m_meshWireframes = false;
+    uint32_t m_maxSphereSegments;
+    float m_lineWidth;
     MTL::RenderPipelineState* m_linePipelineState;
-    size_t m_lineBufferCapacity;
+
+    // Per-frame-slot upload buffers and this frame's layout in them
+    std::array<FrameSlot, kMaxFramesInFlight> m_slots;
+    uint32_t m_frameSlot;
+    size_t m_gridOffset;
+    size_t m_lineOffset;
+    size_t m_shapeOffset;
+    std::array<ShapeBatch, 2> m_shapeBatches;
     
     // Grid rendering
     bool m_gridEnabled;
@@ -115,13 +199,10 @@ private:
     float m_gridOriginX;
     float m_gridOriginZ;
     
-    MTL::Buffer* m_gridVertexBuffer;
+    std::array<DebugVertex, 6> m_gridVertices;
     MTL::RenderPipelineState* m_gridPipelineState;
     size_t m_gridVertexCount;
     
-    // Uniform buffers
-    MTL::Buffer* m_debugUniformBuffer;
-    
     MTL::Device* m_device;
     bool m_initialized;
 };
@@ -0,0 +1,810 @@
+#include "DynamicProbeGI.hpp"
+#include "ShaderLibrary.hpp"
+#include "../IBL/IBLGenerator.hpp"
+#include "../Rendering/Mesh.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+
+// Matches DynamicProbeParams in PBR.metal.
+struct DynamicProbeParamsGPU {
+    float boundsMin[4] = {};
+    float boundsMax[4] = {};
+    uint32_t counts[4] = {};  // xyz probes per axis, w probe count
+    uint32_t update[4] = {};  // x first probe, y probes updated, z rays per probe, w seed
+    uint32_t records[4] = {}; // x first grid record, y light count
+    float blend[4] = {};      // x hysteresis, y max ray distance
+};
+static_assert(sizeof(DynamicProbeParamsGPU) == 96, "DynamicProbeParamsGPU must match DynamicProbeParams in PBR.metal");
+
+// Matches DynamicProbeInstance in PBR.metal.
+struct DynamicProbeInstanceGPU {
+    float normalMatrix[3][4] = {};
+    uint32_t triangleOffset = 0;
+    uint32_t materialOffset = 0;
+    uint32_t materialCount = 0;
+    uint32_t pad = 0;
+};
+static_assert(sizeof(DynamicProbeInstanceGPU) == 64, "DynamicProbeInstanceGPU must match DynamicProbeInstance in PBR.metal");
+
+// Matches DynamicReflectionParams in PBR.metal.
+struct DynamicReflectionParamsGPU {
+    float position[4] = {}; // xyz capture point, w max ray distance
+    uint32_t face[4] = {};  // x cube face, y resolution, z light count
+};
+static_assert(sizeof(DynamicReflectionParamsGPU) == 32, "DynamicReflectionParamsGPU must match DynamicReflectionParams in PBR.metal");
+
+constexpr NS::UInteger kThreadsPerProbe = 64;
+constexpr uint32_t kHistoryStride = 18; // float4s per probe, see kDynamicProbeHistoryStride
+// Frames the renderer can have in flight; dropped structures outlive them before release.
+constexpr uint64_t kRetireFrames = 4;
+
+// Instance masks: shadow rays trace kMaskShadow, probe rays kMaskAll (see PBR.metal).
+constexpr uint32_t kMaskShadow = 1u;
+constexpr uint32_t kMaskAll = 2u;
+
+// A capture is a handful of texels per face, so a light filter is enough.
+constexpr uint32_t kReflectionPrefilterSamples = 64;
+// Reflection slots only look for grid points this many cells around the camera's.
+constexpr int kReflectionSearchCells = 2;
+
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint32_t ResolveSubmeshMaterial(const Mesh& mesh, size_t triangleFirstIndex) {
+    for (const Submesh& submesh : mesh.getSubmeshes()) {
+        if (triangleFirstIndex >= submesh.indexStart &&
+            triangleFirstIndex < static_cast<size_t>(submesh.indexStart + submesh.indexCount)) {
+            return submesh.materialIndex;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+DynamicProbeGI::DynamicProbeGI()
+    : m_device(nullptr)
+    , m_pipeline(nullptr)
+    , m_reflectionPipeline(nullptr)
+    , m_sceneStructure(nullptr)
+    , m_instanceBuffer(nullptr)
+    , m_triangleBuffer(nullptr)
+    , m_materialBuffer(nullptr)
+    , m_historyBuffer(nullptr)
+    , m_sceneHash(0)
+    , m_frame(0)
+    , m_boundsMin(Math::Vector3::Zero)
+    , m_boundsMax(Math::Vector3::Zero)
+    , m_counts{0, 0, 0}
+    , m_probeCount(0)
+    , m_cursor(0)
+    , m_reflectionSlotData{}
+    , m_reflectionPrefiltered(nullptr)
+    , m_reflectionResolution(0)
+    , m_reflectionMipCount(0)
+    , m_reflectionSlotCount(0) {
+}
+
+DynamicProbeGI::~DynamicProbeGI() {
+    shutdown();
+}
+
+bool DynamicProbeGI::initialize(MTL::Device* device) {
+    m_device = device;
+    if (!m_device || !m_device->supportsRaytracing()) {
+        return false;
+    }
+
+    MTL::Library* library = ShaderLibrary::getInstance().acquire(m_device, ShaderLibrary::Module::Lighting);
+    if (!library) {
+        std::cerr << "DynamicProbeGI: missing default Metal library\n";
+        return false;
+    }
+    MTL::Function* function = library->newFunction(NS::String::string("dynamic_probe_update", NS::UTF8StringEncoding));
+    MTL::Function* reflectionFunction =
+        library->newFunction(NS::String::string("dynamic_reflection_capture", NS::UTF8StringEncoding));
+    library->release();
+    if (!function) {
+        std::cerr << "DynamicProbeGI: missing dynamic_probe_update shader\n";
+        if (reflectionFunction) {
+            reflectionFunction->release();
+        }
+        return false;
+    }
+
+    NS::Error* error = nullptr;
+    m_pipeline = m_device->newComputePipelineState(function, &error);
+    function->release();
+    if (!m_pipeline) {
+        if (error) {
+            std::cerr << "DynamicProbeGI: pipeline error " << error->localizedDescription()->utf8String() << "\n";
+        }
+        if (reflectionFunction) {
+            reflectionFunction->release();
+        }
+        return false;
+    }
+    // Reflection captures are optional; the probes work without them.
+    if (reflectionFunction) {
+        error = nullptr;
+        m_reflectionPipeline = m_device->newComputePipelineState(reflectionFunction, &error);
+        reflectionFunction->release();
+        if (!m_reflectionPipeline && error) {
+            std::cerr << "DynamicProbeGI: reflection pipeline error " << error->localizedDescription()->utf8String() << "\n";
+        }
+    }
+    return true;
+}
+
+void DynamicProbeGI::shutdown() {
+    for (auto& [mesh, entry] : m_meshes) {
+        if (entry.structure) {
+            entry.structure->release();
+        }
+    }
+    m_meshes.clear();
+    m_sceneMeshStructures.clear();
+    if (m_sceneStructure) { m_sceneStructure->release(); m_sceneStructure = nullptr; }
+    MTL::Buffer** buffers[] = {&m_instanceBuffer, &m_triangleBuffer, &m_materialBuffer, &m_historyBuffer};
+    for (MTL::Buffer** buffer : buffers) {
+        if (*buffer) { (*buffer)->release(); *buffer = nullptr; }
+    }
+    releaseReflections();
+    releaseRetired(true);
+    if (m_pipeline) { m_pipeline->release(); m_pipeline = nullptr; }
+    if (m_reflectionPipeline) { m_reflectionPipeline->release(); m_reflectionPipeline = nullptr; }
+    m_sceneHash = 0;
+    m_probeCount = 0;
+    m_cursor = 0;
+    m_device = nullptr;
+    m_memory.reset();
+}
+
+void DynamicProbeGI::retire(MTL::Resource* resource) {
+    if (resource) {
+        m_retired.emplace_back(m_frame, resource);
+    }
+}
+
+void DynamicProbeGI::releaseRetired(bool all) {
+    auto due = [&](const std::pair<uint64_t, MTL::Resource*>& retired) {
+        return all || retired.first + kRetireFrames <= m_frame;
+    };
+    for (auto& retired : m_retired) {
+        if (due(retired)) {
+            retired.second->release();
+        }
+    }
+    m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(), due), m_retired.end());
+}
+
+MTL::Buffer* DynamicProbeGI::newBuffer(const void* data, size_t bytes) {
+    MTL::Buffer* buffer = m_device->newBuffer(std::max<size_t>(bytes, 16), MTL::ResourceStorageModeShared);
+    if (buffer && data && bytes > 0) {
+        std::memcpy(buffer->contents(), data, bytes);
+    }
+    return buffer;
+}
+
+void DynamicProbeGI::updateMemoryUsage() {
+    uint64_t bytes = 0;
+    for (const auto& [mesh, entry] : m_meshes) {
+        bytes += entry.structure ? entry.structure->allocatedSize() : 0;
+    }
+    const MTL::Resource* resources[] = {m_sceneStructure, m_instanceBuffer, m_triangleBuffer, m_materialBuffer, m_historyBuffer,
+                                        m_reflectionPrefiltered};
+    for (const MTL::Resource* resource : resources) {
+        bytes += resource ? resource->allocatedSize() : 0;
+    }
+    for (const ReflectionSlot& slot : m_reflectionSlots) {
+        bytes += slot.capture ? slot.capture->allocatedSize() : 0;
+    }
+    m_memory.reset(MemoryCategory::Probes, bytes);
+}
+
+void DynamicProbeGI::setGrid(const Math::Vector3& boundsMin, const Math::Vector3& boundsMax,
+                             uint32_t countX, uint32_t countY, uint32_t countZ) {
+    const uint32_t probeCount = countX * countY * countZ;
+    if (m_historyBuffer && probeCount == m_probeCount &&
+        countX == m_counts[0] && countY == m_counts[1] && countZ == m_counts[2] &&
+        boundsMin == m_boundsMin && boundsMax == m_boundsMax) {
+        return;
+    }
+
+    m_boundsMin = boundsMin;
+    m_boundsMax = boundsMax;
+    m_counts[0] = countX;
+    m_counts[1] = countY;
+    m_counts[2] = countZ;
+    m_probeCount = probeCount;
+    m_cursor = 0;
+    // Slots name grid points, which now sit elsewhere.
+    for (uint32_t slot = 0; slot < kMaxReflectionCaptures; ++slot) {
+        m_reflectionSlots[slot].probe = ~0u;
+        m_reflectionSlots[slot].prefiltered = false;
+        m_reflectionSlotData[slot] = Math::Vector4::Zero;
+    }
+    if (m_historyBuffer) {
+        m_historyBuffer->release();
+        m_historyBuffer = nullptr;
+    }
+    if (!m_device || probeCount == 0) {
+        m_probeCount = 0;
+        return;
+    }
+    const size_t bytes = static_cast<size_t>(probeCount) * kHistoryStride * sizeof(float) * 4u;
+    m_historyBuffer = newBuffer(nullptr, bytes);
+    if (!m_historyBuffer) {
+        m_probeCount = 0;
+        return;
+    }
+    std::memset(m_historyBuffer->contents(), 0, bytes);
+}
+
+bool DynamicProbeGI::buildMeshStructure(MTL::AccelerationStructureCommandEncoder* encoder, MeshStructure& entry) {
+    const Mesh& mesh = *entry.mesh;
+    const auto& vertices = mesh.getVertices();
+    const auto& indices = mesh.getIndices();
+    std::vector<float> positions;
+    positions.reserve(vertices.size() * 3u);
+    for (const Vertex& vertex : vertices) {
+        positions.push_back(vertex.position.x);
+        positions.push_back(vertex.position.y);
+        positions.push_back(vertex.position.z);
+    }
+    // Only valid triangles are kept, so a hit's primitive id indexes the triangle data directly.
+    std::vector<uint32_t> triangleIndices;
+    triangleIndices.reserve(indices.size());
+    entry.triangles.clear();
+    for (size_t tri = 0; tri + 2 < indices.size(); tri += 3) {
+        const uint32_t i0 = indices[tri + 0];
+        const uint32_t i1 = indices[tri + 1];
+        const uint32_t i2 = indices[tri + 2];
+        if (i0 >= vertices.size() || i1 >= vertices.size() || i2 >= vertices.size()) {
+            continue;
+        }
+        triangleIndices.insert(triangleIndices.end(), {i0, i1, i2});
+        const Math::Vector3& p0 = vertices[i0].position;
+        Math::Vector3 normal = (vertices[i1].position - p0).cross(vertices[i2].position - p0).normalized();
+        entry.triangles.insert(entry.triangles.end(),
+                               {normal.x, normal.y, normal.z, static_cast<float>(ResolveSubmeshMaterial(mesh, tri))});
+    }
+    entry.mesh->releaseCpuData();
+    if (triangleIndices.empty()) {
+        return false;
+    }
+
+    MTL::Buffer* vertexBuffer = newBuffer(positions.data(), positions.size() * sizeof(float));
+    MTL::Buffer* indexBuffer = newBuffer(triangleIndices.data(), triangleIndices.size() * sizeof(uint32_t));
+    if (!vertexBuffer || !indexBuffer) {
+        if (vertexBuffer) vertexBuffer->release();
+        if (indexBuffer) indexBuffer->release();
+        return false;
+    }
+
+    MTL::AccelerationStructureTriangleGeometryDescriptor* geometry =
+        MTL::AccelerationStructureTriangleGeometryDescriptor::alloc()->init();
+    geometry->setVertexBuffer(vertexBuffer);
+    geometry->setVertexStride(sizeof(float) * 3u);
+    geometry->setVertexFormat(MTL::AttributeFormatFloat3);
+    geometry->setIndexBuffer(indexBuffer);
+    geometry->setIndexType(MTL::IndexTypeUInt32);
+    geometry->setTriangleCount(triangleIndices.size() / 3u);
+    geometry->setOpaque(true);
+    MTL::PrimitiveAccelerationStructureDescriptor* descriptor = MTL::PrimitiveAccelerationStructureDescriptor::alloc()->init();
+    const NS::Object* geometries[] = {geometry};
+    descriptor->setGeometryDescriptors(NS::Array::array(geometries, 1));
+    geometry->release();
+
+    MTL::AccelerationStructureSizes sizes = m_device->accelerationStructureSizes(descriptor);
+    entry.structure = m_device->newAccelerationStructure(sizes.accelerationStructureSize);
+    MTL::Buffer* scratch = m_device->newBuffer(std::max<NS::UInteger>(sizes.buildScratchBufferSize, 16), MTL::ResourceStorageModePrivate);
+    const bool built = entry.structure && scratch;
+    if (built) {
+        encoder->buildAccelerationStructure(entry.structure, descriptor, scratch, 0);
+    } else if (entry.structure) {
+        entry.structure->release();
+        entry.structure = nullptr;
+    }
+    descriptor->release();
+    // The build reads these until the frame completes.
+    retire(vertexBuffer);
+    retire(indexBuffer);
+    retire(scratch);
+    return built;
+}
+
+void DynamicProbeGI::updateScene(MTL::CommandBuffer* commandBuffer,
+                                 const std::vector<Instance>& instances,
+                                 const std::vector<Material>& materials) {
+    ++m_frame;
+    releaseRetired(false);
+    updateMemoryUsage();
+    if (!m_pipeline || !commandBuffer) {
+        return;
+    }
+
+    uint64_t hash = 14695981039346656037ull;
+    for (const Instance& instance : instances) {
+        const Mesh* mesh = instance.mesh.get();
+        hash = HashBytes(hash, &mesh, sizeof(mesh));
+        hash = HashBytes(hash, instance.worldMatrix.m, sizeof(instance.worldMatrix.m));
+        const uint32_t flags[3] = {instance.castShadows ? 1u : 0u, instance.materialOffset, instance.materialCount};
+        hash = HashBytes(hash, flags, sizeof(flags));
+    }
+    hash = HashBytes(hash, materials.data(), materials.size() * sizeof(Material));
+
+    // New meshes get their primitive structure in one encoder ahead of the instance build.
+    bool meshesChanged = false;
+    MTL::AccelerationStructureCommandEncoder* meshEncoder = nullptr;
+    for (const Instance& instance : instances) {
+        if (!instance.mesh) {
+            continue;
+        }
+        auto found = m_meshes.find(instance.mesh.get());
+        if (found == m_meshes.end()) {
+            if (!meshEncoder) {
+                meshEncoder = commandBuffer->accelerationStructureCommandEncoder();
+            }
+            MeshStructure entry;
+            entry.mesh = instance.mesh;
+            buildMeshStructure(meshEncoder, entry);
+            found = m_meshes.emplace(instance.mesh.get(), std::move(entry)).first;
+            meshesChanged = true;
+        }
+        found->second.lastUsedFrame = m_frame;
+    }
+    if (meshEncoder) {
+        meshEncoder->endEncoding();
+    }
+    if (!meshesChanged && hash == m_sceneHash && m_sceneStructure) {
+        return;
+    }
+    m_sceneHash = hash;
+
+    // A rebuild drops the meshes no instance uses any more.
+    for (auto it = m_meshes.begin(); it != m_meshes.end();) {
+        if (it->second.lastUsedFrame != m_frame) {
+            retire(it->second.structure);
+            it = m_meshes.erase(it);
+            meshesChanged = true;
+        } else {
+            ++it;
+        }
+    }
+
+    std::unordered_map<const Mesh*, uint32_t> structureIndices;
+    m_sceneMeshStructures.clear();
+    std::vector<float> triangles;
+    for (auto& [mesh, entry] : m_meshes) {
+        if (!entry.structure) {
+            continue;
+        }
+        entry.triangleOffset = static_cast<uint32_t>(triangles.size() / 4u);
+        triangles.insert(triangles.end(), entry.triangles.begin(), entry.triangles.end());
+        structureIndices.emplace(mesh, static_cast<uint32_t>(m_sceneMeshStructures.size()));
+        m_sceneMeshStructures.push_back(entry.structure);
+    }
+
+    std::vector<DynamicProbeInstanceGPU> instanceData;
+    std::vector<MTL::AccelerationStructureInstanceDescriptor> instanceDescriptors;
+    for (const Instance& instance : instances) {
+        auto found = structureIndices.find(instance.mesh.get());
+        if (found == structureIndices.end()) {
+            continue;
+        }
+        DynamicProbeInstanceGPU data;
+        const Math::Matrix4x4 normalMatrix = instance.worldMatrix.normalMatrix();
+        for (int column = 0; column < 3; ++column) {
+            for (int row = 0; row < 3; ++row) {
+                data.normalMatrix[column][row] = normalMatrix(row, column);
+            }
+        }
+        data.triangleOffset = m_meshes[instance.mesh.get()].triangleOffset;
+        data.materialOffset = instance.materialOffset;
+        data.materialCount = instance.materialCount;
+        instanceData.push_back(data);
+
+        MTL::AccelerationStructureInstanceDescriptor descriptor{};
+        for (int column = 0; column < 4; ++column) {
+            descriptor.transformationMatrix.columns[column] = MTL::PackedFloat3(
+                instance.worldMatrix(0, column), instance.worldMatrix(1, column), instance.worldMatrix(2, column));
+        }
+        descriptor.options = MTL::AccelerationStructureInstanceOptionOpaque |
+                             MTL::AccelerationStructureInstanceOptionDisableTriangleCulling;
+        descriptor.mask = instance.castShadows ? (kMaskShadow | kMaskAll) : kMaskAll;
+        descriptor.intersectionFunctionTableOffset = 0;
+        descriptor.accelerationStructureIndex = found->second;
+        instanceDescriptors.push_back(descriptor);
+    }
+
+    retire(m_sceneStructure);
+    m_sceneStructure = nullptr;
+    retire(m_instanceBuffer);
+    m_instanceBuffer = nullptr;
+    retire(m_materialBuffer);
+    m_materialBuffer = nullptr;
+    if (meshesChanged || !m_triangleBuffer) {
+        retire(m_triangleBuffer);
+        m_triangleBuffer = newBuffer(triangles.data(), triangles.size() * sizeof(float));
+    }
+    if (instanceDescriptors.empty()) {
+        return;
+    }
+
+    const Material fallbackMaterial;
+    m_instanceBuffer = newBuffer(instanceData.data(), instanceData.size() * sizeof(DynamicProbeInstanceGPU));
+    m_materialBuffer = materials.empty()
+        ? newBuffer(&fallbackMaterial, sizeof(Material))
+        : newBuffer(materials.data(), materials.size() * sizeof(Material));
+    MTL::Buffer* descriptorBuffer = newBuffer(instanceDescriptors.data(),
+                                              instanceDescriptors.size() * sizeof(MTL::AccelerationStructureInstanceDescriptor));
+    std::vector<const NS::Object*> structures(m_sceneMeshStructures.begin(), m_sceneMeshStructures.end());
+    MTL::InstanceAccelerationStructureDescriptor* sceneDescriptor = MTL::InstanceAccelerationStructureDescriptor::alloc()->init();
+    sceneDescriptor->setInstancedAccelerationStructures(NS::Array::array(structures.data(), structures.size()));
+    sceneDescriptor->setInstanceCount(instanceDescriptors.size());
+    sceneDescriptor->setInstanceDescriptorBuffer(descriptorBuffer);
+    sceneDescriptor->setInstanceDescriptorType(MTL::AccelerationStructureInstanceDescriptorTypeDefault);
+
+    MTL::AccelerationStructureSizes sizes = m_device->accelerationStructureSizes(sceneDescriptor);
+    m_sceneStructure = m_device->newAccelerationStructure(sizes.accelerationStructureSize);
+    MTL::Buffer* scratch = m_device->newBuffer(std::max<NS::UInteger>(sizes.buildScratchBufferSize, 16), MTL::ResourceStorageModePrivate);
+    if (m_sceneStructure && scratch && descriptorBuffer && m_instanceBuffer && m_materialBuffer && m_triangleBuffer) {
+        MTL::AccelerationStructureCommandEncoder* sceneEncoder = commandBuffer->accelerationStructureCommandEncoder();
+        sceneEncoder->buildAccelerationStructure(m_sceneStructure, sceneDescriptor, scratch, 0);
+        sceneEncoder->endEncoding();
+    } else {
+        std::cerr << "DynamicProbeGI: Failed to build the scene acceleration structure!" << std::endl;
+        retire(m_sceneStructure);
+        m_sceneStructure = nullptr;
+    }
+    sceneDescriptor->release();
+    retire(descriptorBuffer);
+    retire(scratch);
+}
+
+uint32_t DynamicProbeGI::dispatch(MTL::CommandBuffer* commandBuffer, const FrameInputs& inputs) {
+    if (!m_pipeline || !commandBuffer || !m_sceneStructure || !m_historyBuffer || m_probeCount == 0 ||
+        !inputs.probes || !inputs.probeVolumeUniforms || !inputs.camera || !inputs.environment ||
+        !inputs.shadowAtlas || !inputs.environmentMap || !inputs.linearSampler) {
+        return 0;
+    }
+
+    const uint32_t probes = std::min(std::max(inputs.probesPerFrame, 1u), m_probeCount);
+    const Math::Vector3 extent = m_boundsMax - m_boundsMin;
+    DynamicProbeParamsGPU params;
+    params.boundsMin[0] = m_boundsMin.x;
+    params.boundsMin[1] = m_boundsMin.y;
+    params.boundsMin[2] = m_boundsMin.z;
+    params.boundsMax[0] = m_boundsMax.x;
+    params.boundsMax[1] = m_boundsMax.y;
+    params.boundsMax[2] = m_boundsMax.z;
+    params.counts[0] = m_counts[0];
+    params.counts[1] = m_counts[1];
+    params.counts[2] = m_counts[2];
+    params.counts[3] = m_probeCount;
+    params.update[0] = m_cursor;
+    params.update[1] = probes;
+    params.update[2] = std::min(std::max(inputs.raysPerProbe, 1u), kMaxRaysPerProbe);
+    params.update[3] = static_cast<uint32_t>(HashBytes(14695981039346656037ull, &m_frame, sizeof(m_frame)));
+    params.records[0] = inputs.firstProbeRecord;
+    params.records[1] = (inputs.lights && inputs.shadows) ? inputs.lightCount : 0u;
+    params.blend[0] = Math::Clamp(inputs.hysteresis, 0.0f, 0.99f);
+    params.blend[1] = std::max(extent.length(), 1.0f);
+
+    MTL::ComputeCommandEncoder* encoder = commandBuffer->computeCommandEncoder();
+    encoder->setComputePipelineState(m_pipeline);
+    encoder->setBuffer(inputs.probes, 0, 0);
+    encoder->setBuffer(m_historyBuffer, 0, 1);
+    encoder->setBytes(&params, sizeof(params), 2);
+    encoder->setBuffer(inputs.camera, 0, 3);
+    // Without lights the light and shadow slots only need something bound.
+    encoder->setBuffer(params.records[1] > 0 ? inputs.lights : m_historyBuffer, 0, 4);
+    encoder->setBuffer(params.records[1] > 0 ? inputs.shadows : m_historyBuffer, 0, 5);
+    encoder->setBuffer(inputs.environment, 0, 6);
+    encoder->setBytes(inputs.probeVolumeUniforms, inputs.probeVolumeUniformsSize, 7);
+    encoder->setBuffer(m_instanceBuffer, 0, 8);
+    encoder->setBuffer(m_triangleBuffer, 0, 9);
+    encoder->setBuffer(m_materialBuffer, 0, 10);
+    encoder->setAccelerationStructure(m_sceneStructure, 11);
+    for (MTL::AccelerationStructure* structure : m_sceneMeshStructures) {
+        encoder->useResource(structure, MTL::ResourceUsageRead);
+    }
+    encoder->setTexture(inputs.shadowAtlas, 0);
+    encoder->setTexture(inputs.environmentMap, 1);
+    encoder->setSamplerState(inputs.linearSampler, 0);
+    encoder->setSamplerState(inputs.linearSampler, 1);
+    encoder->dispatchThreadgroups(MTL::Size(probes, 1, 1), MTL::Size(kThreadsPerProbe, 1, 1));
+    encoder->endEncoding();
+
+    m_cursor = (m_cursor + probes) % m_probeCount;
+    return probes;
+}
+
+Math::Vector3 DynamicProbeGI::gridPoint(uint32_t probe) const {
+    const uint32_t coord[3] = {probe % m_counts[0], (probe / m_counts[0]) % m_counts[1], probe / (m_counts[0] * m_counts[1])};
+    Math::Vector3 point;
+    for (int axis = 0; axis < 3; ++axis) {
+        const float step = (m_boundsMax[axis] - m_boundsMin[axis]) / static_cast<float>(std::max(m_counts[axis], 2u) - 1u);
+        point[axis] = m_boundsMin[axis] + step * static_cast<float>(coord[axis]);
+    }
+    return point;
+}
+
+float DynamicProbeGI::getReflectionRadius() const {
+    if (m_probeCount == 0) {
+        return 0.0f;
+    }
+    Math::Vector3 spacing;
+    for (int axis = 0; axis < 3; ++axis) {
+        spacing[axis] = (m_boundsMax[axis] - m_boundsMin[axis]) / static_cast<float>(std::max(m_counts[axis], 2u) - 1u);
+    }
+    return spacing.length();
+}
+
+void DynamicProbeGI::releaseReflections() {
+    for (uint32_t slot = 0; slot < kMaxReflectionCaptures; ++slot) {
+        retire(m_reflectionSlots[slot].capture);
+        m_reflectionSlots[slot] = ReflectionSlot{};
+        m_reflectionSlotData[slot] = Math::Vector4::Zero;
+    }
+    for (MTL::Texture* view : m_reflectionMipViews) {
+        retire(view);
+    }
+    m_reflectionMipViews.clear();
+    retire(m_reflectionPrefiltered);
+    m_reflectionPrefiltered = nullptr;
+    m_reflectionResolution = 0;
+    m_reflectionMipCount = 0;
+    m_reflectionSlotCount = 0;
+}
+
+bool DynamicProbeGI::ensureReflectionTargets(uint32_t resolution) {
+    if (m_reflectionPrefiltered && resolution == m_reflectionResolution) {
+        return true;
+    }
+    releaseReflections();
+
+    uint32_t levels = 1;
+    while ((resolution >> levels) > 0) {
+        ++levels;
+    }
+    const uint32_t mipCount = std::min(kReflectionMipCount, levels);
+    MTL::TextureDescriptor* descriptor = MTL::TextureDescriptor::alloc()->init();
+    descriptor->setTextureType(MTL::TextureTypeCubeArray);
+    descriptor->setPixelFormat(MTL::PixelFormatRGBA16Float);
+    descriptor->setWidth(resolution);
+    descriptor->setHeight(resolution);
+    descriptor->setArrayLength(kMaxReflectionCaptures);
+    descriptor->setMipmapLevelCount(mipCount);
+    descriptor->setUsage(MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
+    descriptor->setStorageMode(MTL::StorageModePrivate);
+    m_reflectionPrefiltered = m_device->newTexture(descriptor);
+    // The captures keep a full chain, which the prefilter reads to stay free of aliasing.
+    descriptor->setTextureType(MTL::TextureTypeCube);
+    descriptor->setArrayLength(1);
+    descriptor->setMipmapLevelCount(levels);
+    bool created = m_reflectionPrefiltered != nullptr;
+    for (ReflectionSlot& slot : m_reflectionSlots) {
+        slot.capture = created ? m_device->newTexture(descriptor) : nullptr;
+        created = created && slot.capture;
+    }
+    descriptor->release();
+    if (!created) {
+        std::cerr << "DynamicProbeGI: Failed to create the reflection capture textures!" << std::endl;
+        releaseReflections();
+        return false;
+    }
+
+    m_reflectionMipViews.reserve(kMaxReflectionCaptures * mipCount);
+    for (uint32_t slot = 0; slot < kMaxReflectionCaptures; ++slot) {
+        for (uint32_t mip = 0; mip < mipCount; ++mip) {
+            m_reflectionMipViews.push_back(m_reflectionPrefiltered->newTextureView(
+                MTL::PixelFormatRGBA16Float, MTL::TextureTypeCube, NS::Range::Make(mip, 1), NS::Range::Make(slot * 6u, 6)));
+        }
+    }
+    m_reflectionResolution = resolution;
+    m_reflectionMipCount = mipCount;
+    return true;
+}
+
+void DynamicProbeGI::assignReflectionSlots(const Math::Vector3& cameraPosition, uint32_t captureCount) {
+    // Candidates are the grid points a few cells around the one nearest the camera.
+    int nearest[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        const int count = static_cast<int>(m_counts[axis]);
+        const float step = (m_boundsMax[axis] - m_boundsMin[axis]) / static_cast<float>(std::max(count, 2) - 1);
+        const float coord = step > 0.0f ? (cameraPosition[axis] - m_boundsMin[axis]) / step : 0.0f;
+        nearest[axis] = std::clamp(static_cast<int>(std::lround(coord)), 0, count - 1);
+    }
+    std::vector<std::pair<float, uint32_t>> candidates;
+    for (int dz = -kReflectionSearchCells; dz <= kReflectionSearchCells; ++dz) {
+        for (int dy = -kReflectionSearchCells; dy <= kReflectionSearchCells; ++dy) {
+            for (int dx = -kReflectionSearchCells; dx <= kReflectionSearchCells; ++dx) {
+                const int x = nearest[0] + dx;
+                const int y = nearest[1] + dy;
+                const int z = nearest[2] + dz;
+                if (x < 0 || y < 0 || z < 0 || x >= static_cast<int>(m_counts[0]) ||
+                    y >= static_cast<int>(m_counts[1]) || z >= static_cast<int>(m_counts[2])) {
+                    continue;
+                }
+                const uint32_t probe = static_cast<uint32_t>(x) + m_counts[0] * (static_cast<uint32_t>(y) + m_counts[1] * static_cast<uint32_t>(z));
+                candidates.emplace_back(gridPoint(probe).distanceSquared(cameraPosition), probe);
+            }
+        }
+    }
+    const size_t wanted = std::min<size_t>(captureCount, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + wanted, candidates.end());
+    candidates.resize(wanted);
+
+    // Slots keep the points that are still wanted; the others take the points left over.
+    std::vector<bool> held(wanted, false);
+    std::vector<uint32_t> freeSlots;
+    for (uint32_t slot = 0; slot < kMaxReflectionCaptures; ++slot) {
+        ReflectionSlot& entry = m_reflectionSlots[slot];
+        bool keep = false;
+        if (slot < captureCount) {
+            for (size_t i = 0; i < wanted && !keep; ++i) {
+                if (!held[i] && candidates[i].second == entry.probe) {
+                    held[i] = true;
+                    keep = true;
+                }
+            }
+        }
+        if (!keep) {
+            entry.probe = ~0u;
+            entry.prefiltered = false;
+            if (slot < captureCount) {
+                freeSlots.push_back(slot);
+            }
+        }
+    }
+    size_t nextFree = 0;
+    for (size_t i = 0; i < wanted && nextFree < freeSlots.size(); ++i) {
+        if (held[i]) {
+            continue;
+        }
+        ReflectionSlot& entry = m_reflectionSlots[freeSlots[nextFree++]];
+        entry.probe = candidates[i].second;
+        entry.nextFace = 0;
+        entry.cycleStart = m_frame;
+        entry.prefiltered = false;
+    }
+    m_reflectionSlotCount = captureCount;
+}
+
+uint32_t DynamicProbeGI::dispatchReflections(MTL::CommandBuffer* commandBuffer,
+                                             const FrameInputs& inputs,
+                                             IBLGenerator& prefilter,
+                                             const Math::Vector3& cameraPosition,
+                                             uint32_t captureCount,
+                                             uint32_t resolution,
+                                             uint32_t facesPerFrame) {
+    if (!m_reflectionPipeline || !commandBuffer || !m_sceneStructure || m_probeCount == 0 ||
+        !inputs.probes || !inputs.probeVolumeUniforms || !inputs.camera || !inputs.environment ||
+        !inputs.shadowAtlas || !inputs.environmentMap || !inputs.linearSampler) {
+        return 0;
+    }
+    captureCount = std::clamp(captureCount, 1u, kMaxReflectionCaptures);
+    if (!ensureReflectionTargets(std::clamp(resolution, 16u, 256u))) {
+        return 0;
+    }
+    assignReflectionSlots(cameraPosition, captureCount);
+
+    DynamicReflectionParamsGPU params;
+    params.position[3] = std::max((m_boundsMax - m_boundsMin).length(), 1.0f);
+    params.face[1] = m_reflectionResolution;
+    params.face[2] = (inputs.lights && inputs.shadows) ? inputs.lightCount : 0u;
+
+    std::vector<uint32_t> completed;
+    MTL::ComputeCommandEncoder* encoder = nullptr;
+    uint32_t traced = 0;
+    for (uint32_t budget = std::max(facesPerFrame, 1u); budget > 0; --budget) {
+        // Slots without a capture go first, then the stalest; nearer slots win either way.
+        int best = -1;
+        float bestPriority = -1.0f;
+        for (uint32_t slot = 0; slot < m_reflectionSlotCount; ++slot) {
+            const ReflectionSlot& entry = m_reflectionSlots[slot];
+            if (entry.probe == ~0u) {
+                continue;
+            }
+            const float nearness = 1.0f / (1.0f + (gridPoint(entry.probe) - cameraPosition).length());
+            float priority = static_cast<float>(m_frame - entry.cycleStart + 1) * nearness;
+            if (!entry.prefiltered) {
+                priority += 1e6f * nearness;
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = static_cast<int>(slot);
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+
+        if (!encoder) {
+            encoder = commandBuffer->computeCommandEncoder();
+            encoder->setComputePipelineState(m_reflectionPipeline);
+            encoder->setBuffer(inputs.camera, 0, 1);
+            // Without lights the light and shadow slots only need something bound.
+            encoder->setBuffer(params.face[2] > 0 ? inputs.lights : m_instanceBuffer, 0, 2);
+            encoder->setBuffer(params.face[2] > 0 ? inputs.shadows : m_instanceBuffer, 0, 3);
+            encoder->setBuffer(inputs.environment, 0, 4);
+            encoder->setBuffer(inputs.probes, 0, 5);
+            encoder->setBytes(inputs.probeVolumeUniforms, inputs.probeVolumeUniformsSize, 6);
+            encoder->setBuffer(m_instanceBuffer, 0, 7);
+            encoder->setBuffer(m_triangleBuffer, 0, 8);
+            encoder->setBuffer(m_materialBuffer, 0, 9);
+            encoder->setAccelerationStructure(m_sceneStructure, 10);
+            for (MTL::AccelerationStructure* structure : m_sceneMeshStructures) {
+                encoder->useResource(structure, MTL::ResourceUsageRead);
+            }
+            encoder->setTexture(inputs.shadowAtlas, 1);
+            encoder->setTexture(inputs.environmentMap, 2);
+            encoder->setSamplerState(inputs.linearSampler, 0);
+            encoder->setSamplerState(inputs.linearSampler, 1);
+        }
+
+        ReflectionSlot& entry = m_reflectionSlots[best];
+        const Math::Vector3 point = gridPoint(entry.probe);
+        params.position[0] = point.x;
+        params.position[1] = point.y;
+        params.position[2] = point.z;
+        params.face[0] = entry.nextFace;
+        encoder->setTexture(entry.capture, 0);
+        encoder->setBytes(&params, sizeof(params), 0);
+        encoder->dispatchThreads(MTL::Size(m_reflectionResolution, m_reflectionResolution, 1), MTL::Size(8, 8, 1));
+        ++traced;
+        if (++entry.nextFace == 6) {
+            // Prefiltered below, ahead of the main pass that reads it.
+            entry.nextFace = 0;
+            entry.cycleStart = m_frame;
+            entry.prefiltered = true;
+            completed.push_back(static_cast<uint32_t>(best));
+        }
+    }
+    if (encoder) {
+        encoder->endEncoding();
+    }
+
+    if (!completed.empty()) {
+        MTL::BlitCommandEncoder* blit = commandBuffer->blitCommandEncoder();
+        for (uint32_t slot : completed) {
+            blit->generateMipmaps(m_reflectionSlots[slot].capture);
+        }
+        blit->endEncoding();
+        for (uint32_t slot : completed) {
+            if (!prefilter.encodePrefilteredEnvMap(commandBuffer, m_reflectionSlots[slot].capture,
+                                                   &m_reflectionMipViews[slot * m_reflectionMipCount], m_reflectionMipCount,
+                                                   m_reflectionResolution, kReflectionPrefilterSamples)) {
+                m_reflectionSlots[slot].prefiltered = false;
+            }
+        }
+    }
+
+    for (uint32_t slot = 0; slot < kMaxReflectionCaptures; ++slot) {
+        const ReflectionSlot& entry = m_reflectionSlots[slot];
+        if (slot < m_reflectionSlotCount && entry.probe != ~0u) {
+            const Math::Vector3 point = gridPoint(entry.probe);
+            m_reflectionSlotData[slot] = Math::Vector4(point.x, point.y, point.z, entry.prefiltered ? 1.0f : 0.0f);
+        } else {
+            m_reflectionSlotData[slot] = Math::Vector4::Zero;
+        }
+    }
+    return traced;
+}
+
+} // namespace Crescent
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include "../Math/Math.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class CommandBuffer;
+    class ComputePipelineState;
+    class AccelerationStructure;
+    class AccelerationStructureCommandEncoder;
+    class Resource;
+    class Buffer;
+    class Texture;
+    class SamplerState;
+}
+
+namespace Crescent {
+
+class IBLGenerator;
+class Mesh;
+
+// Real-time diffuse GI on the probe volume (SceneStaticLightingSettings::dynamicProbes). Keeps a
+// ray tracing structure over the scene's mesh renderers, rebuilt when one of them moves, and
+// every frame re-traces a slice of the probes with dynamic_probe_update in PBR.metal. Rays are
+// lit with the frame's lights and shadow atlas plus the probes themselves, and each probe blends
+// the result into a float history before packing itself into the renderer's probe buffer, so the
+// main pass samples the grid through the usual probe volume path.
+//
+// The same structure feeds runtime reflection captures (dispatchReflections): cubes at the grid
+// points nearest the camera, re-traced a face at a time and prefiltered with IBLGenerator's kernel
+// into one cube array the main pass blends over the baked reflections.
+class DynamicProbeGI {
+public:
+    static constexpr uint32_t kMaxRaysPerProbe = 256;
+    // Slots of the reflection cube array; matches ProbeVolumeUniforms::dynamicReflections.
+    static constexpr uint32_t kMaxReflectionCaptures = 8;
+    // Prefiltered roughness levels, fewer when the resolution runs out first.
+    static constexpr uint32_t kReflectionMipCount = 5;
+
+    // Matches DynamicProbeMaterial in PBR.metal.
+    struct Material {
+        float albedo[4] = {0.7f, 0.7f, 0.7f, 1.0f};
+        float emission[4] = {};
+    };
+
+    struct Instance {
+        std::shared_ptr<Mesh> mesh;
+        Math::Matrix4x4 worldMatrix = Math::Matrix4x4::Identity;
+        bool castShadows = true;
+        // Range of the materials passed alongside, one per submesh material slot.
+        uint32_t materialOffset = 0;
+        uint32_t materialCount = 0;
+    };
+
+    // What the update reads from the renderer's frame. The probe buffer uses ProbeVolumeData.hpp's
+    // layout with every cell on the coarse grid; firstProbeRecord is where that grid starts.
+    struct FrameInputs {
+        MTL::Buffer* probes = nullptr;
+        uint32_t firstProbeRecord = 0;
+        const void* probeVolumeUniforms = nullptr; // ProbeVolumeUniformsGPU
+        size_t probeVolumeUniformsSize = 0;
+        MTL::Buffer* camera = nullptr;
+        MTL::Buffer* lights = nullptr;
+        uint32_t lightCount = 0;
+        MTL::Buffer* shadows = nullptr;
+        MTL::Texture* shadowAtlas = nullptr;
+        MTL::Buffer* environment = nullptr;
+        MTL::Texture* environmentMap = nullptr;
+        MTL::SamplerState* linearSampler = nullptr;
+        uint32_t probesPerFrame = 0;
+        uint32_t raysPerProbe = 0;
+        float hysteresis = 0.0f;
+    };
+
+    DynamicProbeGI();
+    ~DynamicProbeGI();
+
+    // False when the device cannot ray trace; the renderer keeps the baked probes then.
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_pipeline != nullptr; }
+
+    // Probe lattice of countX * countY * countZ points spanning the bounds. Clears the history
+    // when the grid changes, so every probe takes its first update as is.
+    void setGrid(const Math::Vector3& boundsMin, const Math::Vector3& boundsMax,
+                 uint32_t countX, uint32_t countY, uint32_t countZ);
+    uint32_t getProbeCount() const { return m_probeCount; }
+
+    // Encodes the structure builds this frame needs: new meshes get a primitive structure (their
+    // CPU lists are released afterwards), and the instance structure is rebuilt whenever the
+    // instances, their transforms or their materials changed.
+    void updateScene(MTL::CommandBuffer* commandBuffer,
+                     const std::vector<Instance>& instances,
+                     const std::vector<Material>& materials);
+    // Encodes the update of the next probesPerFrame probes; returns how many it scheduled.
+    uint32_t dispatch(MTL::CommandBuffer* commandBuffer, const FrameInputs& inputs);
+
+    // Moves the captureCount reflection slots to the grid points nearest cameraPosition and
+    // re-traces facesPerFrame cube faces at resolution, capture slots that have none yet first,
+    // then the stalest relative to their distance. A slot is prefiltered once all six of its faces
+    // are traced again. Reads the same inputs as dispatch, except for the probe counts. Returns
+    // the faces traced.
+    uint32_t dispatchReflections(MTL::CommandBuffer* commandBuffer,
+                                 const FrameInputs& inputs,
+                                 IBLGenerator& prefilter,
+                                 const Math::Vector3& cameraPosition,
+                                 uint32_t captureCount,
+                                 uint32_t resolution,
+                                 uint32_t facesPerFrame);
+    void releaseReflections();
+    // Cube array with one prefiltered capture per slot, null until dispatchReflections ran.
+    MTL::Texture* getReflectionCaptures() const { return m_reflectionPrefiltered; }
+    // Per slot: xyz capture point, w 1 once the slot holds a prefiltered capture of that point.
+    const std::array<Math::Vector4, kMaxReflectionCaptures>& getReflectionSlots() const { return m_reflectionSlotData; }
+    uint32_t getReflectionSlotCount() const { return m_reflectionSlotCount; }
+    uint32_t getReflectionMipCount() const { return m_reflectionMipCount; }
+    // How far from its capture point a slot is blended in: one cell diagonal of the grid.
+    float getReflectionRadius() const;
+
+private:
+    struct MeshStructure {
+        std::shared_ptr<Mesh> mesh;
+        MTL::AccelerationStructure* structure = nullptr;
+        std::vector<float> triangles; // xyz object-space face normal, w submesh material slot
+        uint32_t triangleOffset = 0;
+        uint64_t lastUsedFrame = 0;
+    };
+
+    struct ReflectionSlot {
+        uint32_t probe = ~0u;    // grid point captured, ~0u for none
+        uint32_t nextFace = 0;   // face the next trace writes
+        uint64_t cycleStart = 0; // frame the current round of six faces began
+        bool prefiltered = false;
+        MTL::Texture* capture = nullptr; // raw cube with mips, the prefilter's source
+    };
+
+    bool buildMeshStructure(MTL::AccelerationStructureCommandEncoder* encoder, MeshStructure& entry);
+    bool ensureReflectionTargets(uint32_t resolution);
+    Math::Vector3 gridPoint(uint32_t probe) const;
+    void assignReflectionSlots(const Math::Vector3& cameraPosition, uint32_t captureCount);
+    void retire(MTL::Resource* resource);
+    void releaseRetired(bool all);
+    MTL::Buffer* newBuffer(const void* data, size_t bytes);
+    void updateMemoryUsage();
+
+    MTL::Device* m_device;
+    MTL::ComputePipelineState* m_pipeline;
+    MTL::ComputePipelineState* m_reflectionPipeline;
+    std::unordered_map<const Mesh*, MeshStructure> m_meshes;
+    MTL::AccelerationStructure* m_sceneStructure;
+    std::vector<MTL::AccelerationStructure*> m_sceneMeshStructures;
+    MTL::Buffer* m_instanceBuffer;
+    MTL::Buffer* m_triangleBuffer;
+    MTL::Buffer* m_materialBuffer;
+    MTL::Buffer* m_historyBuffer;
+    TrackedMemory m_memory; // recounted every updateScene
+    // Structures and build inputs the GPU may still be using, with the frame they were dropped in.
+    std::vector<std::pair<uint64_t, MTL::Resource*>> m_retired;
+    uint64_t m_sceneHash;
+    uint64_t m_frame;
+    Math::Vector3 m_boundsMin;
+    Math::Vector3 m_boundsMax;
+    uint32_t m_counts[3];
+    uint32_t m_probeCount;
+    uint32_t m_cursor;
+    std::array<ReflectionSlot, kMaxReflectionCaptures> m_reflectionSlots;
+    std::array<Math::Vector4, kMaxReflectionCaptures> m_reflectionSlotData;
+    MTL::Texture* m_reflectionPrefiltered;
+    std::vector<MTL::Texture*> m_reflectionMipViews; // slot * m_reflectionMipCount + mip, cube views
+    uint32_t m_reflectionResolution;
+    uint32_t m_reflectionMipCount;
+    uint32_t m_reflectionSlotCount;
+};
+
+} // namespace Crescent
@@ -0,0 +1,72 @@
+#include "DynamicResolution.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Crescent {
+
+namespace {
+
+constexpr float kGpuTimeSmoothing = 0.2f;
+// Drop as soon as the target is missed; only climb back with clear headroom so the scale does
+// not oscillate around the target.
+constexpr float kOverBudget = 1.02f;
+constexpr float kUnderBudget = 0.85f;
+constexpr float kMaxStepDown = 0.2f;
+constexpr float kMaxStepUp = 0.1f;
+
+} // namespace
+
+DynamicResolution::DynamicResolution()
+    : m_enabled(false)
+    , m_targetMs(16.6f)
+    , m_minScale(0.5f)
+    , m_maxScale(1.0f)
+    , m_scale(1.0f)
+    , m_gpuTimeMs(0.0f)
+    , m_samples(0) {
+}
+
+void DynamicResolution::configure(bool enabled, float targetMs, float minScale, float maxScale) {
+    const bool restart = enabled != m_enabled || std::abs(maxScale - m_maxScale) > 0.001f;
+    m_enabled = enabled;
+    m_targetMs = std::max(1.0f, targetMs);
+    m_maxScale = maxScale;
+    m_minScale = std::min(minScale, maxScale);
+    if (restart) {
+        m_scale = m_maxScale;
+        m_samples = 0;
+    }
+    m_scale = std::max(m_minScale, std::min(m_maxScale, m_scale));
+}
+
+void DynamicResolution::addGpuTime(float gpuMs) {
+    if (gpuMs <= 0.0f) {
+        return;
+    }
+    m_gpuTimeMs = m_samples == 0 ? gpuMs : m_gpuTimeMs + (gpuMs - m_gpuTimeMs) * kGpuTimeSmoothing;
+    ++m_samples;
+    if (!m_enabled || m_samples < kAdjustInterval) {
+        return;
+    }
+
+    float desired = m_scale;
+    if (m_gpuTimeMs > m_targetMs * kOverBudget) {
+        // GPU time follows the pixel count, which goes with the square of the scale.
+        desired = std::max(m_scale - kMaxStepDown, m_scale * std::sqrt(m_targetMs / m_gpuTimeMs));
+        desired = std::floor(desired / kScaleStep + 0.001f) * kScaleStep;
+    } else if (m_gpuTimeMs < m_targetMs * kUnderBudget) {
+        desired = std::min(m_scale + kMaxStepUp, m_scale * std::sqrt(m_targetMs * kUnderBudget / m_gpuTimeMs));
+        desired = std::floor(desired / kScaleStep + 0.001f) * kScaleStep;
+    }
+    desired = std::max(m_minScale, std::min(m_maxScale, desired));
+    if (std::abs(desired - m_scale) < 0.001f) {
+        return;
+    }
+
+    const float ratio = desired / m_scale;
+    m_gpuTimeMs *= ratio * ratio;
+    m_scale = desired;
+    m_samples = 1;
+}
+
+} // namespace Crescent
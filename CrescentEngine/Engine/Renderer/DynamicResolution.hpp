@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Crescent {
+
+// Picks the game view's render scale from the GPU time of its finished frames. Samples are
+// smoothed and the scale is only re-evaluated every few frames, in fixed steps, so render targets
+// sized from it change rarely; each change estimates the new cost from the pixel count so the
+// controller does not overshoot while the first samples at the new size are still in flight.
+class DynamicResolution {
+public:
+    static constexpr uint32_t kAdjustInterval = 8; // samples between scale changes
+    static constexpr float kScaleStep = 0.05f;
+
+    DynamicResolution();
+
+    // maxScale is the static render scale; the controller never renders above it.
+    void configure(bool enabled, float targetMs, float minScale, float maxScale);
+    void addGpuTime(float gpuMs);
+
+    bool isEnabled() const { return m_enabled; }
+    float getScale() const { return m_enabled ? m_scale : m_maxScale; }
+    float getMinScale() const { return m_minScale; }
+    float getGpuTimeMs() const { return m_gpuTimeMs; }
+
+private:
+    bool m_enabled;
+    float m_targetMs;
+    float m_minScale;
+    float m_maxScale;
+    float m_scale;
+    float m_gpuTimeMs;
+    uint32_t m_samples;
+};
+
+} // namespace Crescent
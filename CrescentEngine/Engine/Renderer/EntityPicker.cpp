@@ -0,0 +1,271 @@
+#include "EntityPicker.hpp"
+#include "ShaderLibrary.hpp"
+#include "GeometryBuffer.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+
+namespace Crescent {
+
+EntityPicker::~EntityPicker() {
+    shutdown();
+}
+
+bool EntityPicker::initialize(MTL::Device* device) {
+    m_Device = device;
+    if (!m_Device) {
+        return false;
+    }
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_Device, ShaderLibrary::Module::Tools);
+    if (!lib) {
+        std::cerr << "EntityPicker: missing default Metal library\n";
+        return false;
+    }
+    MTL::Function* vertexFunction = lib->newFunction(NS::String::string("vertex_prepass", NS::UTF8StringEncoding));
+    MTL::Function* fragmentFunction = lib->newFunction(NS::String::string("fragment_pick", NS::UTF8StringEncoding));
+    lib->release();
+    if (!vertexFunction || !fragmentFunction) {
+        std::cerr << "EntityPicker: missing vertex_prepass / fragment_pick shaders\n";
+        if (vertexFunction) vertexFunction->release();
+        if (fragmentFunction) fragmentFunction->release();
+        return false;
+    }
+
+    MTL::RenderPipelineDescriptor* descriptor = MTL::RenderPipelineDescriptor::alloc()->init();
+    descriptor->setVertexFunction(vertexFunction);
+    descriptor->setFragmentFunction(fragmentFunction);
+    MTL::VertexDescriptor* vertexDescriptor = GeometryBuffer::NewVertexDescriptor(GeometryBuffer::VertexStreams::Full, false);
+    descriptor->setVertexDescriptor(vertexDescriptor);
+    descriptor->colorAttachments()->object(0)->setPixelFormat(MTL::PixelFormatR32Uint);
+    descriptor->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
+    NS::Error* error = nullptr;
+    m_Pipeline = m_Device->newRenderPipelineState(descriptor, &error);
+    if (!m_Pipeline && error) {
+        std::cerr << "EntityPicker: pipeline error " << error->localizedDescription()->utf8String() << "\n";
+    }
+    vertexDescriptor->release();
+    descriptor->release();
+    vertexFunction->release();
+    fragmentFunction->release();
+
+    MTL::DepthStencilDescriptor* depthDesc = MTL::DepthStencilDescriptor::alloc()->init();
+    depthDesc->setDepthCompareFunction(MTL::CompareFunctionLess);
+    depthDesc->setDepthWriteEnabled(true);
+    m_DepthState = m_Device->newDepthStencilState(depthDesc);
+    depthDesc->release();
+
+    if (!m_Pipeline || !m_DepthState) {
+        shutdown();
+        return false;
+    }
+    return true;
+}
+
+void EntityPicker::shutdown() {
+    releaseTargets();
+    if (m_Pipeline) {
+        m_Pipeline->release();
+        m_Pipeline = nullptr;
+    }
+    if (m_DepthState) {
+        m_DepthState->release();
+        m_DepthState = nullptr;
+    }
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    // A pick still in flight leaves its small buffer behind rather than racing its completed handler.
+    for (auto& readback : m_Readbacks) {
+        if (readback->done.load(std::memory_order_acquire) && readback->buffer) {
+            readback->buffer->release();
+            readback->buffer = nullptr;
+        }
+    }
+    m_Readbacks.clear();
+    m_HasRequest = false;
+    m_Device = nullptr;
+}
+
+uint64_t EntityPicker::request(const Request& request) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Request = request;
+    m_HasRequest = true;
+    m_RequestId = m_NextId++;
+    return m_RequestId;
+}
+
+bool EntityPicker::hasPendingRequest() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_HasRequest;
+}
+
+bool EntityPicker::ensureTargets(uint32_t width, uint32_t height) {
+    if (m_IdTexture && m_IdTexture->width() == width && m_IdTexture->height() == height) {
+        return true;
+    }
+    releaseTargets();
+    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+    desc->setTextureType(MTL::TextureType2D);
+    desc->setWidth(width);
+    desc->setHeight(height);
+    desc->setStorageMode(MTL::StorageModePrivate);
+    desc->setUsage(MTL::TextureUsageRenderTarget);
+    desc->setPixelFormat(MTL::PixelFormatR32Uint);
+    m_IdTexture = m_Device->newTexture(desc);
+    desc->setPixelFormat(MTL::PixelFormatDepth32Float);
+    m_DepthTexture = m_Device->newTexture(desc);
+    desc->release();
+    if (!m_IdTexture || !m_DepthTexture) {
+        std::cerr << "EntityPicker: failed to allocate " << width << "x" << height << " pick targets\n";
+        releaseTargets();
+        return false;
+    }
+    m_Memory.reset(MemoryCategory::RenderTargets, static_cast<uint64_t>(width) * height * 8);
+    return true;
+}
+
+void EntityPicker::releaseTargets() {
+    if (m_IdTexture) {
+        m_IdTexture->release();
+        m_IdTexture = nullptr;
+    }
+    if (m_DepthTexture) {
+        m_DepthTexture->release();
+        m_DepthTexture = nullptr;
+    }
+    m_Memory.reset();
+}
+
+MTL::RenderCommandEncoder* EntityPicker::begin(MTL::CommandBuffer* commandBuffer, uint32_t width, uint32_t height) {
+    if (!commandBuffer || !m_Pipeline || width == 0 || height == 0) {
+        return nullptr;
+    }
+    Request request;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_HasRequest) {
+            return nullptr;
+        }
+        request = m_Request;
+        m_HasRequest = false;
+    }
+    if (!ensureTargets(width, height)) {
+        return nullptr;
+    }
+
+    // Points from the bottom left to pixels from the top left, at least one pixel.
+    const float sx = static_cast<float>(width) / std::max(request.viewportWidth, 1.0f);
+    const float sy = static_cast<float>(height) / std::max(request.viewportHeight, 1.0f);
+    const float left = std::min(request.x0, request.x1) * sx;
+    const float right = std::max(request.x0, request.x1) * sx;
+    const float top = static_cast<float>(height) - std::max(request.y0, request.y1) * sy;
+    const float bottom = static_cast<float>(height) - std::min(request.y0, request.y1) * sy;
+    auto clampPixel = [](float value, uint32_t limit) {
+        return static_cast<uint32_t>(std::clamp(value, 0.0f, static_cast<float>(limit - 1)));
+    };
+    m_RectX = clampPixel(std::floor(left), width);
+    m_RectY = clampPixel(std::floor(top), height);
+    m_RectWidth = std::max(1u, std::min(width - m_RectX, static_cast<uint32_t>(std::ceil(right - left))));
+    m_RectHeight = std::max(1u, std::min(height - m_RectY, static_cast<uint32_t>(std::ceil(bottom - top))));
+
+    MTL::RenderPassDescriptor* pass = MTL::RenderPassDescriptor::alloc()->init();
+    pass->colorAttachments()->object(0)->setTexture(m_IdTexture);
+    pass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
+    pass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
+    pass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 0.0));
+    pass->depthAttachment()->setTexture(m_DepthTexture);
+    pass->depthAttachment()->setLoadAction(MTL::LoadActionClear);
+    pass->depthAttachment()->setStoreAction(MTL::StoreActionDontCare);
+    pass->depthAttachment()->setClearDepth(1.0);
+    MTL::RenderCommandEncoder* encoder = commandBuffer->renderCommandEncoder(pass);
+    pass->release();
+    if (!encoder) {
+        return nullptr;
+    }
+    encoder->setLabel(NS::String::string("Entity Pick", NS::UTF8StringEncoding));
+    encoder->setRenderPipelineState(m_Pipeline);
+    encoder->setDepthStencilState(m_DepthState);
+    encoder->setFrontFacingWinding(MTL::WindingCounterClockwise);
+    // Back faces pick too, as a click on an open mesh's inside should.
+    encoder->setCullMode(MTL::CullModeNone);
+    encoder->setViewport(MTL::Viewport{0.0, 0.0, static_cast<double>(width), static_cast<double>(height), 0.0, 1.0});
+    encoder->setScissorRect(MTL::ScissorRect{m_RectX, m_RectY, m_RectWidth, m_RectHeight});
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto readback = std::make_shared<Readback>();
+    readback->id = m_RequestId;
+    readback->width = m_RectWidth;
+    readback->height = m_RectHeight;
+    m_Readbacks.push_back(std::move(readback));
+    return encoder;
+}
+
+void EntityPicker::end(MTL::CommandBuffer* commandBuffer, MTL::RenderCommandEncoder* encoder) {
+    if (!encoder) {
+        return;
+    }
+    encoder->endEncoding();
+
+    std::shared_ptr<Readback> readback;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        readback = m_Readbacks.back();
+    }
+    const NS::UInteger bytesPerRow = static_cast<NS::UInteger>(readback->width) * sizeof(uint32_t);
+    readback->buffer = m_Device->newBuffer(bytesPerRow * readback->height, MTL::ResourceStorageModeShared);
+    if (!readback->buffer) {
+        readback->failed = true;
+        readback->done.store(true, std::memory_order_release);
+        return;
+    }
+    MTL::BlitCommandEncoder* blit = commandBuffer->blitCommandEncoder();
+    blit->copyFromTexture(m_IdTexture, 0, 0, MTL::Origin::Make(m_RectX, m_RectY, 0),
+                          MTL::Size::Make(readback->width, readback->height, 1),
+                          readback->buffer, 0, bytesPerRow, bytesPerRow * readback->height);
+    blit->endEncoding();
+    commandBuffer->addCompletedHandler([readback](MTL::CommandBuffer* completed) {
+        readback->failed = completed->status() != MTL::CommandBufferStatusCompleted;
+        readback->done.store(true, std::memory_order_release);
+    });
+}
+
+bool EntityPicker::takeResult(Result& out) {
+    std::shared_ptr<Readback> readback;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Readbacks.empty() || !m_Readbacks.front()->done.load(std::memory_order_acquire)) {
+            return false;
+        }
+        readback = std::move(m_Readbacks.front());
+        m_Readbacks.erase(m_Readbacks.begin());
+    }
+
+    out.id = readback->id;
+    out.entityIndices.clear();
+    if (!readback->failed && readback->buffer) {
+        const auto* ids = static_cast<const uint32_t*>(readback->buffer->contents());
+        const size_t count = static_cast<size_t>(readback->width) * readback->height;
+        std::unordered_map<uint32_t, uint32_t> coverage;
+        for (size_t i = 0; i < count; ++i) {
+            if (ids[i] != 0) {
+                ++coverage[ids[i] - 1];
+            }
+        }
+        out.entityIndices.reserve(coverage.size());
+        for (const auto& entry : coverage) {
+            out.entityIndices.push_back(entry.first);
+        }
+        std::sort(out.entityIndices.begin(), out.entityIndices.end(), [&](uint32_t a, uint32_t b) {
+            const uint32_t ca = coverage[a];
+            const uint32_t cb = coverage[b];
+            return ca != cb ? ca > cb : a < b;
+        });
+    }
+    if (readback->buffer) {
+        readback->buffer->release();
+        readback->buffer = nullptr;
+    }
+    return true;
+}
+
+} // namespace Crescent
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class Buffer;
+    class Texture;
+    class CommandBuffer;
+    class RenderCommandEncoder;
+    class RenderPipelineState;
+    class DepthStencilState;
+}
+
+namespace Crescent {
+
+// GPU picking for the editor's scene view. A request (a click's pixel or a marquee rectangle) makes
+// the next scene-view frame draw its pickable mesh renderers into an R32Uint target holding each
+// pixel's dense entity index + 1, scissored to the rectangle, and copy that rectangle into a shared
+// buffer in the same command buffer. Its completed handler marks the pick done and takeResult()
+// hands it over a frame or two later; nothing waits on the GPU. Picking is pixel-exact, and skinned
+// meshes pick in their animated pose once the skinning cache holds them.
+class EntityPicker {
+public:
+    // Rectangle corners in viewport points with the origin at the bottom left, as
+    // SelectionSystem::screenPointToRay takes them.
+    struct Request {
+        float x0 = 0.0f;
+        float y0 = 0.0f;
+        float x1 = 0.0f;
+        float y1 = 0.0f;
+        float viewportWidth = 1.0f;
+        float viewportHeight = 1.0f;
+    };
+    struct Result {
+        uint64_t id = 0;
+        // Dense entity indices (Entity::getIndex) covering the rectangle, most pixels first. A
+        // click's rectangle is one pixel, so it holds the entity under the cursor if any.
+        std::vector<uint32_t> entityIndices;
+    };
+
+    EntityPicker() = default;
+    ~EntityPicker();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_Pipeline != nullptr; }
+
+    // Replaces any request not yet rendered; returns the id its Result will carry.
+    uint64_t request(const Request& request);
+    bool hasPendingRequest() const;
+    // Starts the pending request's pass over a width x height view, set up for draws through the
+    // prepass vertex functions (buffers 1-4) with the entity id as fragment bytes at index 0.
+    // Returns null when nothing is pending. Close it with end() on the same command buffer.
+    MTL::RenderCommandEncoder* begin(MTL::CommandBuffer* commandBuffer, uint32_t width, uint32_t height);
+    void end(MTL::CommandBuffer* commandBuffer, MTL::RenderCommandEncoder* encoder);
+    // Oldest finished pick, if any.
+    bool takeResult(Result& out);
+
+private:
+    struct Readback {
+        uint64_t id = 0;
+        MTL::Buffer* buffer = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::atomic<bool> done{false};
+        bool failed = false;
+    };
+
+    bool ensureTargets(uint32_t width, uint32_t height);
+    void releaseTargets();
+
+    MTL::Device* m_Device = nullptr;
+    MTL::RenderPipelineState* m_Pipeline = nullptr;
+    MTL::DepthStencilState* m_DepthState = nullptr;
+    MTL::Texture* m_IdTexture = nullptr;
+    MTL::Texture* m_DepthTexture = nullptr;
+    TrackedMemory m_Memory;
+
+    mutable std::mutex m_Mutex;
+    Request m_Request;
+    bool m_HasRequest = false;
+    uint64_t m_RequestId = 0;
+    uint64_t m_NextId = 1;
+    // Rectangle of the pass being encoded, in pixels from the top left.
+    uint32_t m_RectX = 0;
+    uint32_t m_RectY = 0;
+    uint32_t m_RectWidth = 0;
+    uint32_t m_RectHeight = 0;
+    std::vector<std::shared_ptr<Readback>> m_Readbacks;
+};
+
+} // namespace Crescent
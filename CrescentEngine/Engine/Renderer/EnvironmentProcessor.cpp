@@ -0,0 +1,240 @@
+#include "EnvironmentProcessor.hpp"
+#include "../IBL/CookedEnvironment.hpp"
+#include "../IBL/IBLGenerator.hpp"
+#include "../Rendering/Texture.hpp"
+#include "../Core/CPUProfiler.hpp"
+#include "../Core/ThreadQoS.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace Crescent {
+
+namespace {
+    constexpr uint64_t kFNVOffset = 1469598103934665603ull;
+    constexpr uint64_t kFNVPrime = 1099511628211ull;
+
+    uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= kFNVPrime;
+        }
+        return hash;
+    }
+
+    // FNV-1a over the file's bytes, so a renamed or touched source still hits the cache.
+    bool HashFile(const std::string& path, uint64_t& outHash) {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream.is_open()) {
+            return false;
+        }
+        std::vector<char> chunk(1 << 20);
+        uint64_t hash = kFNVOffset;
+        while (stream) {
+            stream.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            hash = HashBytes(hash, chunk.data(), static_cast<size_t>(stream.gcount()));
+        }
+        outHash = hash;
+        return stream.eof();
+    }
+}
+
+EnvironmentProcessor::EnvironmentProcessor() = default;
+
+EnvironmentProcessor::~EnvironmentProcessor() {
+    shutdown();
+}
+
+bool EnvironmentProcessor::initialize(MTL::Device* device, TextureLoader* loader) {
+    if (isAvailable()) {
+        return true;
+    }
+    if (!device || !loader) {
+        return false;
+    }
+    m_Device = device;
+    m_Loader = loader;
+    m_Queue = device->newCommandQueue();
+    if (!m_Queue) {
+        return false;
+    }
+    m_Queue->setLabel(NS::String::string("Environment Processing", NS::UTF8StringEncoding));
+    m_Generator = std::make_unique<IBLGenerator>();
+    if (!m_Generator->initialize(device, m_Queue)) {
+        m_Generator.reset();
+        m_Queue->release();
+        m_Queue = nullptr;
+        return false;
+    }
+    m_Stopping = false;
+    m_Worker = std::thread([this]() { workerLoop(); });
+    return true;
+}
+
+void EnvironmentProcessor::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+        m_HasQueued = false;
+    }
+    m_Wake.notify_all();
+    if (m_Worker.joinable()) {
+        m_Worker.join();
+    }
+    if (m_HasCompleted) {
+        releaseTextures(m_Completed);
+        m_Completed = Result();
+        m_HasCompleted = false;
+    }
+    m_CurrentId = 0;
+    m_CompletedId = 0;
+    if (m_Generator) {
+        m_Generator->shutdown();
+        m_Generator.reset();
+    }
+    if (m_Queue) {
+        m_Queue->release();
+        m_Queue = nullptr;
+    }
+}
+
+uint64_t EnvironmentProcessor::request(Request request) {
+    uint64_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        id = m_NextId++;
+        m_Queued = std::move(request);
+        m_HasQueued = true;
+        m_CurrentId = id;
+        if (m_HasCompleted) {
+            releaseTextures(m_Completed);
+            m_Completed = Result();
+            m_HasCompleted = false;
+        }
+    }
+    m_Wake.notify_one();
+    return id;
+}
+
+void EnvironmentProcessor::cancel() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_HasQueued = false;
+    m_CurrentId = 0;
+    if (m_HasCompleted) {
+        releaseTextures(m_Completed);
+        m_Completed = Result();
+        m_HasCompleted = false;
+    }
+}
+
+bool EnvironmentProcessor::collect(Result& out) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_HasCompleted) {
+        return false;
+    }
+    out = std::move(m_Completed);
+    m_Completed = Result();
+    m_HasCompleted = false;
+    return true;
+}
+
+uint64_t EnvironmentProcessor::getPendingId() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_CurrentId != m_CompletedId ? m_CurrentId : 0;
+}
+
+void EnvironmentProcessor::releaseTextures(Result& result) {
+    for (MTL::Texture** texture : {&result.cubemap, &result.prefiltered, &result.irradiance}) {
+        if (*texture) {
+            (*texture)->release();
+            *texture = nullptr;
+        }
+    }
+    result.equirect.reset();
+}
+
+void EnvironmentProcessor::workerLoop() {
+    TextureLoader::markLoadingThread();
+    SetCurrentThreadQoS(ThreadQoS::Utility);
+    CRESCENT_PROFILE_THREAD("Environment Processing");
+    while (true) {
+        Request request;
+        uint64_t id = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wake.wait(lock, [this]() { return m_Stopping || m_HasQueued; });
+            if (m_Stopping) {
+                return;
+            }
+            request = std::move(m_Queued);
+            m_HasQueued = false;
+            id = m_CurrentId;
+        }
+
+        Result result = process(id, request);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (id != m_CurrentId) {
+            releaseTextures(result);
+            continue;
+        }
+        m_Completed = std::move(result);
+        m_HasCompleted = true;
+        m_CompletedId = id;
+    }
+}
+
+EnvironmentProcessor::Result EnvironmentProcessor::process(uint64_t id, const Request& request) {
+    CRESCENT_PROFILE_SCOPE("EnvironmentProcessor::process");
+    NS::AutoreleasePool* pool = NS::AutoreleasePool::alloc()->init();
+    Result result;
+    result.id = id;
+    result.path = request.path;
+
+    std::string cachePath;
+    uint64_t key = 0;
+    if (!request.cacheDirectory.empty() && HashFile(request.path, key)) {
+        const uint8_t flipY = request.settings.flipY ? 1 : 0;
+        const int32_t maxSize = request.settings.maxSize;
+        key = HashBytes(key, &flipY, sizeof(flipY));
+        key = HashBytes(key, &maxSize, sizeof(maxSize));
+        char name[64];
+        std::snprintf(name, sizeof(name), "environment_%016llx_%s.cenv",
+                      static_cast<unsigned long long>(key), kCacheVersion);
+        cachePath = (std::filesystem::path(request.cacheDirectory) / name).string();
+    }
+
+    std::error_code ec;
+    if (!cachePath.empty() && std::filesystem::exists(cachePath, ec) &&
+        LoadCookedEnvironmentBlob(cachePath, m_Device, result.cubemap, result.prefiltered, result.irradiance)) {
+        result.fromCache = true;
+        pool->release();
+        return result;
+    }
+
+    result.equirect = m_Loader->decodeEnvironmentTexture(request.path, request.settings.flipY,
+                                                         static_cast<uint32_t>(std::max(0, request.settings.maxSize)));
+    MTL::Texture* equirect = result.equirect ? static_cast<MTL::Texture*>(result.equirect->getHandle()) : nullptr;
+    if (equirect) {
+        IBLGenerator::IBLTextures ibl = m_Generator->processEnvironmentMap(equirect);
+        result.cubemap = ibl.cubemap;
+        result.prefiltered = ibl.prefiltered;
+        result.irradiance = ibl.irradiance;
+    }
+    if (!result.isComplete()) {
+        std::cerr << "[EnvironmentProcessor] Failed to process environment: " << request.path << std::endl;
+        releaseTextures(result);
+    } else if (!cachePath.empty() &&
+               !WriteCookedEnvironmentBlob(cachePath, result.cubemap, result.prefiltered, result.irradiance)) {
+        std::cerr << "[EnvironmentProcessor] Failed to cache environment: " << cachePath << std::endl;
+    }
+    pool->release();
+    return result;
+}
+
+} // namespace Crescent
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../Assets/AssetImportSettings.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace MTL {
+    class Device;
+    class CommandQueue;
+    class Texture;
+}
+
+namespace Crescent {
+
+class IBLGenerator;
+class Texture2D;
+class TextureLoader;
+
+// Background decode and IBL prefilter for environment maps. One worker thread takes the newest
+// request (a newer one replaces a queued one), decodes the HDR/EXR at its import settings and runs
+// its own IBLGenerator on its own command queue, so the frame never waits on either. Prefiltered
+// results are cached under the library's ImportCache as cooked environment blobs keyed by a hash
+// of the source's bytes and the import settings; a cache hit also skips the decode, and the skybox
+// then samples the cubemap. collect(), called by the renderer each frame, hands the newest
+// finished result over; results of cancelled or replaced requests are dropped.
+class EnvironmentProcessor {
+public:
+    static constexpr const char* kCacheVersion = "v1";
+
+    struct Request {
+        std::string path;
+        HdriImportSettings settings;
+        std::string cacheDirectory; // empty disables the cache
+    };
+
+    struct Result {
+        uint64_t id = 0;
+        std::string path;
+        std::shared_ptr<Texture2D> equirect; // null when the result came from the cache
+        MTL::Texture* cubemap = nullptr;     // owned by whoever collected the result
+        MTL::Texture* prefiltered = nullptr;
+        MTL::Texture* irradiance = nullptr;
+        bool fromCache = false;
+        bool isComplete() const { return cubemap && prefiltered && irradiance; }
+    };
+
+    EnvironmentProcessor();
+    ~EnvironmentProcessor();
+    EnvironmentProcessor(const EnvironmentProcessor&) = delete;
+    EnvironmentProcessor& operator=(const EnvironmentProcessor&) = delete;
+
+    bool initialize(MTL::Device* device, TextureLoader* loader);
+    void shutdown();
+    bool isAvailable() const { return m_Worker.joinable(); }
+
+    // Queues a request and returns its id; any earlier request is superseded.
+    uint64_t request(Request request);
+    // Drops the queued request and the result of the one in flight.
+    void cancel();
+    // Takes the newest finished result of the current request. A failed one comes back with no
+    // textures.
+    bool collect(Result& out);
+    // The current request's id while it is queued or processing, else 0.
+    uint64_t getPendingId() const;
+
+    static void releaseTextures(Result& result);
+
+private:
+    void workerLoop();
+    Result process(uint64_t id, const Request& request);
+
+    MTL::Device* m_Device = nullptr;
+    MTL::CommandQueue* m_Queue = nullptr;
+    TextureLoader* m_Loader = nullptr;
+    std::unique_ptr<IBLGenerator> m_Generator; // worker thread only
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    std::thread m_Worker;
+    bool m_Stopping = false;
+    bool m_HasQueued = false;
+    Request m_Queued;
+    uint64_t m_NextId = 1;
+    uint64_t m_CurrentId = 0;   // newest request; older results are dropped
+    uint64_t m_CompletedId = 0; // newest request a result was produced for
+    Result m_Completed;
+    bool m_HasCompleted = false;
+};
+
+} // namespace Crescent
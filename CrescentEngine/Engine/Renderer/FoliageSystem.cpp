@@ -0,0 +1,350 @@
+#include "FoliageSystem.hpp"
+#include "ShaderLibrary.hpp"
+#include "../Components/FoliageScatter.hpp"
+#include "../ECS/Entity.hpp"
+#include "../Physics/TerrainHeightField.hpp"
+#include "../Rendering/Mesh.hpp"
+#include "../Rendering/Texture.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    // Matches InstanceData in PBR.metal.
+    constexpr size_t kRecordBytes = sizeof(float) * 32;
+    constexpr uint32_t kMaxCellsPerSide = 64;
+    // Records of one scatter across all its slots (64 MB); denser settings get fewer cells per tile.
+    constexpr uint64_t kMaxRecords = 1u << 19;
+    constexpr uint32_t kMaxScattersPerFrame = 32;
+    constexpr uint64_t kEvictFrames = 300;
+
+    uint32_t HashTile(int32_t x, int32_t z, uint32_t seed) {
+        uint32_t h = seed * 0x9E3779B9u;
+        h ^= static_cast<uint32_t>(x) * 0x85EBCA6Bu;
+        h = (h << 13) | (h >> 19);
+        h ^= static_cast<uint32_t>(z) * 0xC2B2AE35u;
+        h ^= h >> 16;
+        h *= 0x7FEB352Du;
+        h ^= h >> 15;
+        return h;
+    }
+
+    float MaxAxisScale(const Math::Matrix4x4& m) {
+        const float x = Math::Vector3(m.m[0], m.m[1], m.m[2]).length();
+        const float y = Math::Vector3(m.m[4], m.m[5], m.m[6]).length();
+        const float z = Math::Vector3(m.m[8], m.m[9], m.m[10]).length();
+        return std::max(x, std::max(y, z));
+    }
+}
+
+FoliageSystem::~FoliageSystem() {
+    shutdown();
+}
+
+bool FoliageSystem::initialize(MTL::Device* device) {
+    m_Device = device;
+    if (!m_Device) {
+        return false;
+    }
+
+    NS::Error* error = nullptr;
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_Device, ShaderLibrary::Module::Core);
+    if (!lib) {
+        std::cerr << "FoliageSystem: missing default Metal library\n";
+        return false;
+    }
+
+    MTL::Function* func = lib->newFunction(NS::String::string("foliage_scatter", NS::UTF8StringEncoding));
+    if (!func) {
+        std::cerr << "FoliageSystem: missing foliage_scatter shader\n";
+        lib->release();
+        return false;
+    }
+
+    m_Pipeline = m_Device->newComputePipelineState(func, &error);
+    func->release();
+    lib->release();
+
+    if (!m_Pipeline) {
+        if (error) {
+            std::cerr << "FoliageSystem: pipeline error " << error->localizedDescription()->utf8String() << "\n";
+        }
+        return false;
+    }
+    return true;
+}
+
+void FoliageSystem::shutdown() {
+    for (auto& [scatter, entry] : m_Entries) {
+        releaseEntry(entry);
+    }
+    m_Entries.clear();
+    m_Scatters.clear();
+    m_Clears.clear();
+    if (m_Pipeline) {
+        m_Pipeline->release();
+        m_Pipeline = nullptr;
+    }
+    m_Device = nullptr;
+}
+
+void FoliageSystem::releaseEntry(Entry& entry) {
+    if (entry.buffer) {
+        entry.buffer->release();
+        entry.buffer = nullptr;
+    }
+    if (entry.heights) {
+        entry.heights->release();
+        entry.heights = nullptr;
+    }
+    entry.memory.reset();
+    entry.heightMemory.reset();
+    entry.tiles.clear();
+    entry.freeSlots.clear();
+    entry.slotCount = 0;
+}
+
+size_t FoliageSystem::getResidentTileCount() const {
+    size_t count = 0;
+    for (const auto& [scatter, entry] : m_Entries) {
+        count += entry.tiles.size();
+    }
+    return count;
+}
+
+void FoliageSystem::beginFrame() {
+    ++m_Frame;
+    m_Scatters.clear();
+    m_Clears.clear();
+    m_TilesScattered = 0;
+    for (auto it = m_Entries.begin(); it != m_Entries.end();) {
+        if (it->second.lastUsedFrame + kEvictFrames < m_Frame) {
+            releaseEntry(it->second);
+            it = m_Entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool FoliageSystem::rebuild(Entry& entry, FoliageScatter& scatter, const Mesh& terrainMesh,
+                            const Math::Matrix4x4& terrainWorld) {
+    entry.tiles.clear();
+    entry.freeSlots.clear();
+    entry.terrainMesh = &terrainMesh;
+    entry.terrainVertexCount = terrainMesh.getVertices().size();
+
+    TerrainHeightField field;
+    if (!BuildTerrainHeightField(terrainMesh, Math::Matrix4x4::Identity, field)) {
+        releaseEntry(entry);
+        return false;
+    }
+    if (!entry.heights || entry.sampleCount != field.sampleCount) {
+        if (entry.heights) {
+            entry.heights->release();
+            entry.heights = nullptr;
+        }
+        MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+        desc->setTextureType(MTL::TextureType2D);
+        desc->setPixelFormat(MTL::PixelFormatR32Float);
+        desc->setWidth(field.sampleCount);
+        desc->setHeight(field.sampleCount);
+        desc->setUsage(MTL::TextureUsageShaderRead);
+        desc->setStorageMode(MTL::StorageModeShared);
+        entry.heights = m_Device->newTexture(desc);
+        desc->release();
+        if (!entry.heights) {
+            releaseEntry(entry);
+            return false;
+        }
+        entry.heightMemory.reset(MemoryCategory::Instances, field.heights.size() * sizeof(float));
+    }
+    entry.heights->replaceRegion(MTL::Region::Make2D(0, 0, field.sampleCount, field.sampleCount), 0,
+                                 field.heights.data(), static_cast<NS::UInteger>(field.sampleCount * sizeof(float)));
+    entry.fieldOrigin = field.origin;
+    entry.spacingX = field.spacingX;
+    entry.spacingZ = field.spacingZ;
+    entry.sampleCount = field.sampleCount;
+
+    // The window is sized in terrain units, so it shrinks with a terrain scaled up.
+    const float worldScale = MaxAxisScale(terrainWorld);
+    const float viewDistance = scatter.getViewDistance() / std::max(worldScale, 1e-4f);
+    const float tileSize = scatter.getTileSize();
+    entry.tileRadius = static_cast<int32_t>(std::ceil(viewDistance / tileSize));
+    const uint32_t side = static_cast<uint32_t>(entry.tileRadius) * 2 + 1;
+    const uint32_t slotCount = side * side;
+
+    const float density = scatter.getDensity() * worldScale * worldScale;
+    uint32_t cellsPerSide = static_cast<uint32_t>(std::ceil(tileSize * std::sqrt(density)));
+    cellsPerSide = std::clamp(cellsPerSide, 1u, kMaxCellsPerSide);
+    const uint32_t budget = static_cast<uint32_t>(std::sqrt(static_cast<double>(kMaxRecords) / slotCount));
+    if (cellsPerSide > budget) {
+        std::cerr << "[Foliage] Density of " << (scatter.getEntity() ? scatter.getEntity()->getName() : "scatter")
+                  << " capped to fit " << kMaxRecords << " instances within the view distance\n";
+        cellsPerSide = std::max(1u, budget);
+    }
+    entry.cellsPerSide = cellsPerSide;
+    entry.cellSize = tileSize / static_cast<float>(cellsPerSide);
+    entry.keepProbability = std::min(1.0f, density * entry.cellSize * entry.cellSize);
+
+    const size_t bytes = static_cast<size_t>(slotCount) * cellsPerSide * cellsPerSide * kRecordBytes;
+    if (!entry.buffer || entry.buffer->length() < bytes) {
+        if (entry.buffer) {
+            entry.buffer->release();
+        }
+        entry.buffer = m_Device->newBuffer(bytes, MTL::ResourceStorageModePrivate);
+        if (!entry.buffer) {
+            releaseEntry(entry);
+            return false;
+        }
+        entry.memory.reset(MemoryCategory::Instances, entry.buffer->length());
+    }
+    entry.slotCount = slotCount;
+    entry.freeSlots.reserve(slotCount);
+    for (uint32_t slot = slotCount; slot-- > 0;) {
+        entry.freeSlots.push_back(slot);
+    }
+    m_Clears.push_back({entry.buffer, 0, bytes});
+    return true;
+}
+
+MTL::Buffer* FoliageSystem::update(FoliageScatter& scatter, const Mesh& terrainMesh, const Math::Matrix4x4& terrainWorld,
+                                   const Math::Vector3& cameraPosition, uint32_t& count) {
+    count = 0;
+    if (!m_Pipeline) {
+        return nullptr;
+    }
+    Entry& entry = m_Entries[&scatter];
+    entry.lastUsedFrame = m_Frame;
+    if (entry.version != scatter.getVersion() || entry.terrainMesh != &terrainMesh
+        || entry.terrainVertexCount != terrainMesh.getVertices().size()) {
+        entry.version = scatter.getVersion();
+        if (!rebuild(entry, scatter, terrainMesh, terrainWorld)) {
+            return nullptr;
+        }
+    }
+    if (!entry.buffer) {
+        return nullptr;
+    }
+
+    const uint32_t tileRecords = entry.cellsPerSide * entry.cellsPerSide;
+    const float tileSize = scatter.getTileSize();
+    const Math::Vector3 camera = terrainWorld.inversed().transformPoint(cameraPosition);
+    const int32_t cameraX = static_cast<int32_t>(std::floor(camera.x / tileSize));
+    const int32_t cameraZ = static_cast<int32_t>(std::floor(camera.z / tileSize));
+    const float fieldMaxX = entry.fieldOrigin.x + entry.spacingX * static_cast<float>(entry.sampleCount - 1);
+    const float fieldMaxZ = entry.fieldOrigin.z + entry.spacingZ * static_cast<float>(entry.sampleCount - 1);
+    const float reach = static_cast<float>(entry.tileRadius) * tileSize;
+
+    // Tiles of the window that touch the terrain and lie within reach, nearest first.
+    struct Wanted {
+        int32_t x;
+        int32_t z;
+        float distanceSq;
+    };
+    std::vector<Wanted> missing;
+    for (int32_t z = cameraZ - entry.tileRadius; z <= cameraZ + entry.tileRadius; ++z) {
+        for (int32_t x = cameraX - entry.tileRadius; x <= cameraX + entry.tileRadius; ++x) {
+            const float minX = static_cast<float>(x) * tileSize;
+            const float minZ = static_cast<float>(z) * tileSize;
+            if (minX > fieldMaxX || minX + tileSize < entry.fieldOrigin.x
+                || minZ > fieldMaxZ || minZ + tileSize < entry.fieldOrigin.z) {
+                continue;
+            }
+            const float dx = std::max(0.0f, std::max(minX - camera.x, camera.x - (minX + tileSize)));
+            const float dz = std::max(0.0f, std::max(minZ - camera.z, camera.z - (minZ + tileSize)));
+            const float distanceSq = dx * dx + dz * dz;
+            if (distanceSq > reach * reach) {
+                continue;
+            }
+            auto it = entry.tiles.find(tileKey(x, z));
+            if (it != entry.tiles.end()) {
+                it->second.lastWantedFrame = m_Frame;
+            } else {
+                missing.push_back({x, z, distanceSq});
+            }
+        }
+    }
+
+    for (auto it = entry.tiles.begin(); it != entry.tiles.end();) {
+        if (it->second.lastWantedFrame != m_Frame) {
+            m_Clears.push_back({entry.buffer, static_cast<size_t>(it->second.slot) * tileRecords * kRecordBytes,
+                                static_cast<size_t>(tileRecords) * kRecordBytes});
+            entry.freeSlots.push_back(it->second.slot);
+            it = entry.tiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::sort(missing.begin(), missing.end(), [](const Wanted& a, const Wanted& b) {
+        return a.distanceSq < b.distanceSq;
+    });
+    Texture2D* densityMap = scatter.getDensityMap().get();
+    MTL::Texture* densityHandle = densityMap ? densityMap->getHandle() : nullptr;
+    const float cosMaxSlope = std::cos(scatter.getMaxSlopeDegrees() * Math::DEG_TO_RAD);
+    for (const Wanted& wanted : missing) {
+        if (entry.freeSlots.empty() || m_TilesScattered >= kMaxScattersPerFrame) {
+            break;
+        }
+        Tile tile;
+        tile.slot = entry.freeSlots.back();
+        tile.lastWantedFrame = m_Frame;
+        entry.freeSlots.pop_back();
+        entry.tiles.emplace(tileKey(wanted.x, wanted.z), tile);
+
+        Scatter work;
+        work.target = entry.buffer;
+        work.heights = entry.heights;
+        work.densityMap = densityHandle ? densityHandle : entry.heights;
+        work.params.terrainToWorld = terrainWorld;
+        work.params.tileOrigin = Math::Vector4(static_cast<float>(wanted.x) * tileSize, static_cast<float>(wanted.z) * tileSize,
+                                               entry.cellSize, entry.keepProbability);
+        work.params.fieldOrigin = Math::Vector4(entry.fieldOrigin.x, entry.fieldOrigin.y, entry.fieldOrigin.z, entry.spacingX);
+        work.params.fieldInfo = Math::Vector4(entry.spacingZ, static_cast<float>(entry.sampleCount), 0.0f, 0.0f);
+        work.params.placement = Math::Vector4(scatter.getMinScale(), scatter.getMaxScale(), cosMaxSlope, scatter.getAlignToNormal());
+        work.params.tileHash = HashTile(wanted.x, wanted.z, scatter.getSeed());
+        work.params.cellsPerSide = entry.cellsPerSide;
+        work.params.outputOffset = tile.slot * tileRecords;
+        work.params.hasDensityMap = densityHandle ? 1u : 0u;
+        m_Scatters.push_back(work);
+        ++m_TilesScattered;
+    }
+
+    count = entry.slotCount * tileRecords;
+    return entry.buffer;
+}
+
+void FoliageSystem::encode(MTL::CommandBuffer* commandBuffer) {
+    if (!commandBuffer || (m_Clears.empty() && m_Scatters.empty())) {
+        return;
+    }
+    // A slot can be freed and handed to a new tile in the same frame, so clears go first.
+    if (!m_Clears.empty()) {
+        MTL::BlitCommandEncoder* blit = commandBuffer->blitCommandEncoder();
+        for (const Clear& clear : m_Clears) {
+            blit->fillBuffer(clear.target, NS::Range::Make(clear.offset, clear.length), 0);
+        }
+        blit->endEncoding();
+    }
+    if (!m_Scatters.empty()) {
+        MTL::ComputeCommandEncoder* encoder = commandBuffer->computeCommandEncoder();
+        encoder->setComputePipelineState(m_Pipeline);
+        for (const Scatter& work : m_Scatters) {
+            encoder->setTexture(work.heights, 0);
+            encoder->setTexture(work.densityMap, 1);
+            encoder->setBuffer(work.target, 0, 0);
+            encoder->setBytes(&work.params, sizeof(ScatterParamsGPU), 1);
+            const uint32_t cells = work.params.cellsPerSide;
+            encoder->dispatchThreads(MTL::Size(cells, cells, 1), MTL::Size(8, 8, 1));
+        }
+        encoder->endEncoding();
+    }
+    m_Clears.clear();
+    m_Scatters.clear();
+}
+
+} // namespace Crescent
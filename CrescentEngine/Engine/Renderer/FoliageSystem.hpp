@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include "../Math/Math.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class Buffer;
+    class Texture;
+    class CommandBuffer;
+    class ComputePipelineState;
+}
+
+namespace Crescent {
+
+class FoliageScatter;
+class Mesh;
+
+// GPU scattering for FoliageScatter components. Each scatter keeps a private buffer of tile slots
+// covering a square window of tiles around the camera. A tile entering the window gets a free
+// slot, and foliage_scatter (Foliage.metal) fills every candidate of it: one jittered point per
+// cell, kept by the density (and density map), placed on the terrain heights and rejected on steep
+// slopes. Rejected candidates and freed slots hold zero matrices, which the instance cull kernels
+// skip, so the whole buffer is a cull input of fixed size that never goes back to the CPU. The
+// tile hash is derived from its coordinates, so a tile streaming back in grows the same instances.
+class FoliageSystem {
+public:
+    FoliageSystem() = default;
+    ~FoliageSystem();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_Pipeline != nullptr; }
+
+    // Drops the scatters not drawn for a while.
+    void beginFrame();
+    // Streams the scatter's tiles around the camera and returns the buffer of its tile slots, with
+    // the number of records in count; null when the terrain is not a height field or the buffer
+    // could not be allocated.
+    MTL::Buffer* update(FoliageScatter& scatter, const Mesh& terrainMesh, const Math::Matrix4x4& terrainWorld,
+                        const Math::Vector3& cameraPosition, uint32_t& count);
+    // Clears freed slots and scatters this frame's new tiles. Encode before anything reads them.
+    void encode(MTL::CommandBuffer* commandBuffer);
+
+    uint32_t getTilesScattered() const { return m_TilesScattered; }
+    size_t getResidentTileCount() const;
+
+private:
+    // Matches FoliageScatterParams in Foliage.metal.
+    struct ScatterParamsGPU {
+        Math::Matrix4x4 terrainToWorld;
+        Math::Vector4 tileOrigin;  // xy tile corner on the terrain XZ, z cell size, w keep probability
+        Math::Vector4 fieldOrigin; // xyz height field origin, w spacing X
+        Math::Vector4 fieldInfo;   // x spacing Z, y sample count
+        Math::Vector4 placement;   // x min scale, y max scale, z cos of the max slope, w normal alignment
+        uint32_t tileHash;
+        uint32_t cellsPerSide;
+        uint32_t outputOffset;     // first record of the tile's slot
+        uint32_t hasDensityMap;
+    };
+    struct Tile {
+        uint32_t slot = 0;
+        uint64_t lastWantedFrame = 0;
+    };
+    struct Entry {
+        MTL::Buffer* buffer = nullptr;
+        MTL::Texture* heights = nullptr;
+        TrackedMemory memory;
+        TrackedMemory heightMemory;
+        uint64_t version = 0;
+        const Mesh* terrainMesh = nullptr;
+        size_t terrainVertexCount = 0;
+        Math::Vector3 fieldOrigin;
+        float spacingX = 1.0f;
+        float spacingZ = 1.0f;
+        uint32_t sampleCount = 0;
+        uint32_t cellsPerSide = 0;
+        float cellSize = 1.0f;
+        float keepProbability = 0.0f;
+        int32_t tileRadius = 0;
+        uint32_t slotCount = 0;
+        std::unordered_map<int64_t, Tile> tiles;
+        std::vector<uint32_t> freeSlots;
+        uint64_t lastUsedFrame = 0;
+    };
+    struct Scatter {
+        MTL::Buffer* target = nullptr;
+        MTL::Texture* heights = nullptr;
+        MTL::Texture* densityMap = nullptr;
+        ScatterParamsGPU params;
+    };
+    struct Clear {
+        MTL::Buffer* target = nullptr;
+        size_t offset = 0;
+        size_t length = 0;
+    };
+
+    bool rebuild(Entry& entry, FoliageScatter& scatter, const Mesh& terrainMesh, const Math::Matrix4x4& terrainWorld);
+    void releaseEntry(Entry& entry);
+    static int64_t tileKey(int32_t x, int32_t z) {
+        return (static_cast<int64_t>(x) << 32) ^ static_cast<uint32_t>(z);
+    }
+
+    MTL::Device* m_Device = nullptr;
+    MTL::ComputePipelineState* m_Pipeline = nullptr;
+    std::unordered_map<const FoliageScatter*, Entry> m_Entries;
+    std::vector<Scatter> m_Scatters;
+    std::vector<Clear> m_Clears;
+    uint64_t m_Frame = 0;
+    uint32_t m_TilesScattered = 0;
+};
+
+} // namespace Crescent
@@ -0,0 +1,502 @@
+#include "GPULightBaker.hpp"
+#include "ShaderLibrary.hpp"
+#include "../Rendering/Mesh.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace Crescent {
+
+namespace {
+
+// Kept short so one command buffer stays well under the GPU watchdog on display GPUs.
+constexpr size_t kQueriesPerBatch = 4096;
+constexpr NS::UInteger kThreadsPerGroup = 64;
+
+// Instance masks: shadow rays trace kMaskShadow, bounce rays kMaskAll (see LightBake.metal).
+constexpr uint32_t kMaskShadow = 1u;
+constexpr uint32_t kMaskAll = 2u;
+
+struct GPULightBakeInstanceData {
+    float normalMatrix[3][4] = {};
+    uint32_t triangleOffset = 0;
+    uint32_t materialOffset = 0;
+    uint32_t materialCount = 0;
+    uint32_t contributeGI = 1;
+};
+static_assert(sizeof(GPULightBakeInstanceData) == 64, "GPULightBakeInstanceData must match LightBakeInstance in LightBake.metal");
+
+struct GPULightBakeTriangleData {
+    float normal[4] = {};
+    float uv0[2] = {};
+    float uv1[2] = {};
+    float uv2[2] = {};
+    uint32_t material = 0;
+    uint32_t pad = 0;
+};
+static_assert(sizeof(GPULightBakeTriangleData) == 48, "GPULightBakeTriangleData must match LightBakeTriangle in LightBake.metal");
+
+struct GPULightBakeTextureData {
+    uint32_t offset = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t pad = 0;
+};
+
+uint32_t ResolveSubmeshMaterial(const Mesh& mesh, size_t triangleFirstIndex) {
+    for (const Submesh& submesh : mesh.getSubmeshes()) {
+        if (triangleFirstIndex >= submesh.indexStart &&
+            triangleFirstIndex < static_cast<size_t>(submesh.indexStart + submesh.indexCount)) {
+            return submesh.materialIndex;
+        }
+    }
+    return 0;
+}
+
+// Appends the texture, box-filtered down until it fits kMaxTextureSize.
+void AppendTexels(const GPULightBaker::Texture& texture,
+                  std::vector<uint32_t>& texels,
+                  GPULightBakeTextureData& outData) {
+    int factor = 1;
+    while (texture.width / factor > GPULightBaker::kMaxTextureSize ||
+           texture.height / factor > GPULightBaker::kMaxTextureSize) {
+        factor *= 2;
+    }
+    const int width = std::max(1, texture.width / factor);
+    const int height = std::max(1, texture.height / factor);
+    outData.offset = static_cast<uint32_t>(texels.size());
+    outData.width = static_cast<uint32_t>(width);
+    outData.height = static_cast<uint32_t>(height);
+    texels.reserve(texels.size() + static_cast<size_t>(width) * static_cast<size_t>(height));
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint32_t sum[4] = {};
+            int taps = 0;
+            for (int sy = y * factor; sy < std::min(texture.height, (y + 1) * factor); ++sy) {
+                for (int sx = x * factor; sx < std::min(texture.width, (x + 1) * factor); ++sx) {
+                    const unsigned char* pixel = texture.rgba + (static_cast<size_t>(sy) * static_cast<size_t>(texture.width) + static_cast<size_t>(sx)) * 4u;
+                    for (int channel = 0; channel < 4; ++channel) {
+                        sum[channel] += pixel[channel];
+                    }
+                    ++taps;
+                }
+            }
+            uint32_t packed = 0;
+            for (int channel = 0; channel < 4; ++channel) {
+                uint32_t value = taps > 0 ? (sum[channel] + static_cast<uint32_t>(taps / 2)) / static_cast<uint32_t>(taps) : 255u;
+                packed |= std::min(value, 255u) << (channel * 8);
+            }
+            texels.push_back(packed);
+        }
+    }
+}
+
+} // namespace
+
+GPULightBaker::GPULightBaker() = default;
+
+GPULightBaker::~GPULightBaker() {
+    shutdown();
+}
+
+bool GPULightBaker::initialize() {
+    if (m_pipeline) {
+        return true;
+    }
+
+    NS::AutoreleasePool* pool = NS::AutoreleasePool::alloc()->init();
+    m_device = MTL::CreateSystemDefaultDevice();
+    if (!m_device || !m_device->supportsRaytracing()) {
+        pool->release();
+        shutdown();
+        return false;
+    }
+
+    MTL::Library* library = ShaderLibrary::getInstance().acquire(m_device, ShaderLibrary::Module::Tools);
+    MTL::Function* function = library
+        ? library->newFunction(NS::String::string("lightBakeKernel", NS::UTF8StringEncoding))
+        : nullptr;
+    if (function) {
+        NS::Error* error = nullptr;
+        m_pipeline = m_device->newComputePipelineState(function, &error);
+        if (error) {
+            std::cerr << "GPULightBaker: Pipeline error: " << error->localizedDescription()->utf8String() << std::endl;
+        }
+        function->release();
+    } else {
+        std::cerr << "GPULightBaker: lightBakeKernel not found!" << std::endl;
+    }
+    if (library) {
+        library->release();
+    }
+    m_queue = m_pipeline ? m_device->newCommandQueue() : nullptr;
+    pool->release();
+
+    if (!m_pipeline || !m_queue) {
+        shutdown();
+        return false;
+    }
+    return true;
+}
+
+void GPULightBaker::shutdown() {
+    releaseScene();
+    if (m_pipeline) { m_pipeline->release(); m_pipeline = nullptr; }
+    if (m_queue) { m_queue->release(); m_queue = nullptr; }
+    if (m_device) { m_device->release(); m_device = nullptr; }
+}
+
+void GPULightBaker::releaseScene() {
+    for (MTL::AccelerationStructure* structure : m_meshStructures) {
+        structure->release();
+    }
+    m_meshStructures.clear();
+    if (m_sceneStructure) { m_sceneStructure->release(); m_sceneStructure = nullptr; }
+    MTL::Buffer** buffers[] = {
+        &m_lightBuffer, &m_emitterBuffer, &m_aliasBuffer, &m_lightNodeBuffer, &m_instanceBuffer,
+        &m_triangleBuffer, &m_materialBuffer, &m_textureBuffer, &m_texelBuffer
+    };
+    for (MTL::Buffer** buffer : buffers) {
+        if (*buffer) { (*buffer)->release(); *buffer = nullptr; }
+    }
+    m_params = GPULightBakeParams();
+}
+
+// Shared storage; empty inputs still get a small buffer so every kernel slot is bound.
+MTL::Buffer* GPULightBaker::newBuffer(const void* data, size_t bytes) {
+    MTL::Buffer* buffer = m_device->newBuffer(std::max<size_t>(bytes, 16), MTL::ResourceStorageModeShared);
+    if (buffer && data && bytes > 0) {
+        std::memcpy(buffer->contents(), data, bytes);
+    }
+    return buffer;
+}
+
+bool GPULightBaker::buildScene(const SceneDesc& scene) {
+    // The kernel reads one alias entry per emitter.
+    if (!m_pipeline || scene.aliasTable.size() != scene.emitters.size()) {
+        return false;
+    }
+    releaseScene();
+
+    NS::AutoreleasePool* pool = NS::AutoreleasePool::alloc()->init();
+
+    // One primitive structure per distinct mesh, in its local space.
+    std::unordered_map<const Mesh*, uint32_t> meshSlots;
+    std::vector<uint32_t> meshTriangleOffsets;
+    std::vector<GPULightBakeTriangleData> triangles;
+    std::vector<MTL::PrimitiveAccelerationStructureDescriptor*> meshDescriptors;
+    std::vector<MTL::Buffer*> geometryBuffers;
+    std::vector<uint32_t> instanceMeshSlots;
+    instanceMeshSlots.reserve(scene.instances.size());
+    for (const Instance& instance : scene.instances) {
+        const Mesh* mesh = instance.mesh.get();
+        auto found = mesh ? meshSlots.find(mesh) : meshSlots.end();
+        if (!mesh || found != meshSlots.end()) {
+            instanceMeshSlots.push_back(mesh ? found->second : 0xffffffffu);
+            continue;
+        }
+
+        const auto& vertices = mesh->getVertices();
+        const auto& indices = mesh->getIndices();
+        std::vector<float> positions;
+        positions.reserve(vertices.size() * 3u);
+        for (const Vertex& vertex : vertices) {
+            positions.push_back(vertex.position.x);
+            positions.push_back(vertex.position.y);
+            positions.push_back(vertex.position.z);
+        }
+        // Only valid triangles are kept, so a hit's primitive id indexes the triangle data directly.
+        std::vector<uint32_t> triangleIndices;
+        triangleIndices.reserve(indices.size());
+        const uint32_t triangleOffset = static_cast<uint32_t>(triangles.size());
+        for (size_t tri = 0; tri + 2 < indices.size(); tri += 3) {
+            const uint32_t i0 = indices[tri + 0];
+            const uint32_t i1 = indices[tri + 1];
+            const uint32_t i2 = indices[tri + 2];
+            if (i0 >= vertices.size() || i1 >= vertices.size() || i2 >= vertices.size()) {
+                continue;
+            }
+            triangleIndices.insert(triangleIndices.end(), {i0, i1, i2});
+
+            const Vertex& v0 = vertices[i0];
+            const Vertex& v1 = vertices[i1];
+            const Vertex& v2 = vertices[i2];
+            Math::Vector3 normal = (v1.position - v0.position).cross(v2.position - v0.position).normalized();
+            GPULightBakeTriangleData data;
+            data.normal[0] = normal.x;
+            data.normal[1] = normal.y;
+            data.normal[2] = normal.z;
+            data.uv0[0] = v0.texCoord.x;
+            data.uv0[1] = v0.texCoord.y;
+            data.uv1[0] = v1.texCoord.x;
+            data.uv1[1] = v1.texCoord.y;
+            data.uv2[0] = v2.texCoord.x;
+            data.uv2[1] = v2.texCoord.y;
+            data.material = ResolveSubmeshMaterial(*mesh, tri);
+            triangles.push_back(data);
+        }
+        if (triangleIndices.empty()) {
+            meshSlots.emplace(mesh, 0xffffffffu);
+            instanceMeshSlots.push_back(0xffffffffu);
+            continue;
+        }
+
+        MTL::Buffer* vertexBuffer = newBuffer(positions.data(), positions.size() * sizeof(float));
+        MTL::Buffer* indexBuffer = newBuffer(triangleIndices.data(), triangleIndices.size() * sizeof(uint32_t));
+        geometryBuffers.push_back(vertexBuffer);
+        geometryBuffers.push_back(indexBuffer);
+
+        MTL::AccelerationStructureTriangleGeometryDescriptor* geometry =
+            MTL::AccelerationStructureTriangleGeometryDescriptor::alloc()->init();
+        geometry->setVertexBuffer(vertexBuffer);
+        geometry->setVertexStride(sizeof(float) * 3u);
+        geometry->setVertexFormat(MTL::AttributeFormatFloat3);
+        geometry->setIndexBuffer(indexBuffer);
+        geometry->setIndexType(MTL::IndexTypeUInt32);
+        geometry->setTriangleCount(triangleIndices.size() / 3u);
+        geometry->setOpaque(true);
+        MTL::PrimitiveAccelerationStructureDescriptor* descriptor = MTL::PrimitiveAccelerationStructureDescriptor::alloc()->init();
+        const NS::Object* geometries[] = {geometry};
+        descriptor->setGeometryDescriptors(NS::Array::array(geometries, 1));
+        geometry->release();
+
+        const uint32_t slot = static_cast<uint32_t>(meshDescriptors.size());
+        meshSlots.emplace(mesh, slot);
+        meshDescriptors.push_back(descriptor);
+        meshTriangleOffsets.push_back(triangleOffset);
+        instanceMeshSlots.push_back(slot);
+    }
+
+    std::vector<GPULightBakeInstanceData> instanceData;
+    std::vector<MTL::AccelerationStructureInstanceDescriptor> instanceDescriptors;
+    for (size_t index = 0; index < scene.instances.size(); ++index) {
+        const Instance& instance = scene.instances[index];
+        const uint32_t slot = instanceMeshSlots[index];
+        if (slot == 0xffffffffu) {
+            continue;
+        }
+
+        GPULightBakeInstanceData data;
+        const Math::Matrix4x4 normalMatrix = instance.worldMatrix.normalMatrix();
+        for (int column = 0; column < 3; ++column) {
+            for (int row = 0; row < 3; ++row) {
+                data.normalMatrix[column][row] = normalMatrix(row, column);
+            }
+        }
+        data.triangleOffset = meshTriangleOffsets[slot];
+        data.materialOffset = instance.materialOffset;
+        data.materialCount = instance.materialCount;
+        data.contributeGI = instance.contributeGI ? 1u : 0u;
+        instanceData.push_back(data);
+
+        MTL::AccelerationStructureInstanceDescriptor descriptor{};
+        for (int column = 0; column < 4; ++column) {
+            descriptor.transformationMatrix.columns[column] = MTL::PackedFloat3(
+                instance.worldMatrix(0, column), instance.worldMatrix(1, column), instance.worldMatrix(2, column));
+        }
+        descriptor.options = MTL::AccelerationStructureInstanceOptionOpaque |
+                             MTL::AccelerationStructureInstanceOptionDisableTriangleCulling;
+        descriptor.mask = instance.castShadows ? (kMaskShadow | kMaskAll) : kMaskAll;
+        descriptor.intersectionFunctionTableOffset = 0;
+        descriptor.accelerationStructureIndex = slot;
+        instanceDescriptors.push_back(descriptor);
+    }
+
+    bool built = !instanceDescriptors.empty();
+    MTL::CommandBuffer* commandBuffer = built ? m_queue->commandBuffer() : nullptr;
+    MTL::AccelerationStructureCommandEncoder* encoder = commandBuffer ? commandBuffer->accelerationStructureCommandEncoder() : nullptr;
+    std::vector<MTL::Buffer*> scratchBuffers;
+    built = encoder != nullptr;
+    for (size_t slot = 0; built && slot < meshDescriptors.size(); ++slot) {
+        MTL::AccelerationStructureSizes sizes = m_device->accelerationStructureSizes(meshDescriptors[slot]);
+        MTL::AccelerationStructure* structure = m_device->newAccelerationStructure(sizes.accelerationStructureSize);
+        MTL::Buffer* scratch = m_device->newBuffer(std::max<NS::UInteger>(sizes.buildScratchBufferSize, 16), MTL::ResourceStorageModePrivate);
+        if (!structure || !scratch) {
+            if (structure) structure->release();
+            if (scratch) scratch->release();
+            built = false;
+            break;
+        }
+        encoder->buildAccelerationStructure(structure, meshDescriptors[slot], scratch, 0);
+        m_meshStructures.push_back(structure);
+        scratchBuffers.push_back(scratch);
+    }
+    if (encoder) {
+        encoder->endEncoding();
+    }
+
+    // The instance structure reads the primitive ones, so it is built once they have completed.
+    MTL::Buffer* instanceDescriptorBuffer = nullptr;
+    MTL::InstanceAccelerationStructureDescriptor* sceneDescriptor = nullptr;
+    if (built) {
+        commandBuffer->commit();
+        commandBuffer->waitUntilCompleted();
+        built = commandBuffer->status() == MTL::CommandBufferStatusCompleted;
+    }
+    if (built) {
+        instanceDescriptorBuffer = newBuffer(instanceDescriptors.data(),
+                                             instanceDescriptors.size() * sizeof(MTL::AccelerationStructureInstanceDescriptor));
+        std::vector<const NS::Object*> structures(m_meshStructures.begin(), m_meshStructures.end());
+        sceneDescriptor = MTL::InstanceAccelerationStructureDescriptor::alloc()->init();
+        sceneDescriptor->setInstancedAccelerationStructures(NS::Array::array(structures.data(), structures.size()));
+        sceneDescriptor->setInstanceCount(instanceDescriptors.size());
+        sceneDescriptor->setInstanceDescriptorBuffer(instanceDescriptorBuffer);
+        sceneDescriptor->setInstanceDescriptorType(MTL::AccelerationStructureInstanceDescriptorTypeDefault);
+
+        MTL::AccelerationStructureSizes sizes = m_device->accelerationStructureSizes(sceneDescriptor);
+        m_sceneStructure = m_device->newAccelerationStructure(sizes.accelerationStructureSize);
+        MTL::Buffer* scratch = m_device->newBuffer(std::max<NS::UInteger>(sizes.buildScratchBufferSize, 16), MTL::ResourceStorageModePrivate);
+        if (m_sceneStructure && scratch) {
+            MTL::CommandBuffer* sceneCommands = m_queue->commandBuffer();
+            MTL::AccelerationStructureCommandEncoder* sceneEncoder = sceneCommands->accelerationStructureCommandEncoder();
+            sceneEncoder->buildAccelerationStructure(m_sceneStructure, sceneDescriptor, scratch, 0);
+            sceneEncoder->endEncoding();
+            sceneCommands->commit();
+            sceneCommands->waitUntilCompleted();
+            built = sceneCommands->status() == MTL::CommandBufferStatusCompleted;
+        } else {
+            built = false;
+        }
+        if (scratch) {
+            scratch->release();
+        }
+    }
+
+    for (MTL::Buffer* scratch : scratchBuffers) {
+        scratch->release();
+    }
+    for (MTL::Buffer* buffer : geometryBuffers) {
+        buffer->release();
+    }
+    for (MTL::PrimitiveAccelerationStructureDescriptor* descriptor : meshDescriptors) {
+        descriptor->release();
+    }
+    if (sceneDescriptor) {
+        sceneDescriptor->release();
+    }
+    if (instanceDescriptorBuffer) {
+        instanceDescriptorBuffer->release();
+    }
+    pool->release();
+
+    if (!built) {
+        std::cerr << "GPULightBaker: Failed to build acceleration structures!" << std::endl;
+        releaseScene();
+        return false;
+    }
+
+    std::vector<uint32_t> texels;
+    std::vector<GPULightBakeTextureData> textures(scene.textures.size());
+    for (size_t index = 0; index < scene.textures.size(); ++index) {
+        const Texture& texture = scene.textures[index];
+        if (texture.rgba && texture.width > 0 && texture.height > 0) {
+            AppendTexels(texture, texels, textures[index]);
+        } else {
+            // A single white texel, as the CPU baker reads a missing image.
+            textures[index].offset = static_cast<uint32_t>(texels.size());
+            textures[index].width = 1;
+            textures[index].height = 1;
+            texels.push_back(0xffffffffu);
+        }
+    }
+
+    m_params = scene.params;
+    m_params.lightCount = static_cast<uint32_t>(scene.lights.size());
+    m_params.emitterCount = static_cast<uint32_t>(scene.emitters.size());
+    m_params.totalEmitterWeight = scene.emitters.empty() ? 0.0f : scene.emitters.back().p2[3];
+    m_params.lightNodeCount = static_cast<uint32_t>(scene.lightTree.size());
+    m_params.hasCutout = 0;
+    for (const GPULightBakeMaterial& material : scene.materials) {
+        if (material.alpha[0] > 0.0f) {
+            m_params.hasCutout = 1;
+            break;
+        }
+    }
+
+    m_lightBuffer = newBuffer(scene.lights.data(), scene.lights.size() * sizeof(GPULightBakeLight));
+    m_emitterBuffer = newBuffer(scene.emitters.data(), scene.emitters.size() * sizeof(GPULightBakeEmitter));
+    m_aliasBuffer = newBuffer(scene.aliasTable.data(), scene.aliasTable.size() * sizeof(GPULightBakeAliasEntry));
+    m_lightNodeBuffer = newBuffer(scene.lightTree.data(), scene.lightTree.size() * sizeof(GPULightBakeLightNode));
+    m_instanceBuffer = newBuffer(instanceData.data(), instanceData.size() * sizeof(GPULightBakeInstanceData));
+    m_triangleBuffer = newBuffer(triangles.data(), triangles.size() * sizeof(GPULightBakeTriangleData));
+    m_materialBuffer = newBuffer(scene.materials.data(), scene.materials.size() * sizeof(GPULightBakeMaterial));
+    m_textureBuffer = newBuffer(textures.data(), textures.size() * sizeof(GPULightBakeTextureData));
+    m_texelBuffer = newBuffer(texels.data(), texels.size() * sizeof(uint32_t));
+    if (!m_lightBuffer || !m_emitterBuffer || !m_aliasBuffer || !m_lightNodeBuffer || !m_instanceBuffer ||
+        !m_triangleBuffer || !m_materialBuffer || !m_textureBuffer || !m_texelBuffer) {
+        releaseScene();
+        return false;
+    }
+    return true;
+}
+
+bool GPULightBaker::trace(const std::vector<GPULightBakeQuery>& queries,
+                          std::vector<GPULightBakeResult>& outResults,
+                          const std::function<bool(size_t)>& onBatch) {
+    outResults.clear();
+    if (!m_sceneStructure) {
+        return false;
+    }
+    if (queries.empty()) {
+        return true;
+    }
+
+    MTL::Buffer* queryBuffer = newBuffer(queries.data(), queries.size() * sizeof(GPULightBakeQuery));
+    MTL::Buffer* resultBuffer = newBuffer(nullptr, queries.size() * sizeof(GPULightBakeResult));
+    bool completed = queryBuffer && resultBuffer;
+
+    for (size_t offset = 0; completed && offset < queries.size(); offset += kQueriesPerBatch) {
+        NS::AutoreleasePool* pool = NS::AutoreleasePool::alloc()->init();
+        GPULightBakeParams params = m_params;
+        params.queryOffset = static_cast<uint32_t>(offset);
+        params.queryCount = static_cast<uint32_t>(std::min(kQueriesPerBatch, queries.size() - offset));
+
+        MTL::CommandBuffer* commandBuffer = m_queue->commandBuffer();
+        MTL::ComputeCommandEncoder* encoder = commandBuffer->computeCommandEncoder();
+        encoder->setComputePipelineState(m_pipeline);
+        encoder->setBuffer(queryBuffer, 0, 0);
+        encoder->setBuffer(resultBuffer, 0, 1);
+        encoder->setBytes(&params, sizeof(params), 2);
+        encoder->setBuffer(m_lightBuffer, 0, 3);
+        encoder->setBuffer(m_emitterBuffer, 0, 4);
+        encoder->setBuffer(m_instanceBuffer, 0, 5);
+        encoder->setBuffer(m_triangleBuffer, 0, 6);
+        encoder->setBuffer(m_materialBuffer, 0, 7);
+        encoder->setBuffer(m_textureBuffer, 0, 8);
+        encoder->setBuffer(m_texelBuffer, 0, 9);
+        encoder->setAccelerationStructure(m_sceneStructure, 10);
+        encoder->setBuffer(m_aliasBuffer, 0, 11);
+        encoder->setBuffer(m_lightNodeBuffer, 0, 12);
+        for (MTL::AccelerationStructure* structure : m_meshStructures) {
+            encoder->useResource(structure, MTL::ResourceUsageRead);
+        }
+        encoder->dispatchThreads(MTL::Size(params.queryCount, 1, 1), MTL::Size(kThreadsPerGroup, 1, 1));
+        encoder->endEncoding();
+        commandBuffer->commit();
+        commandBuffer->waitUntilCompleted();
+        completed = commandBuffer->status() == MTL::CommandBufferStatusCompleted;
+        pool->release();
+
+        if (!completed) {
+            std::cerr << "GPULightBaker: Bake command buffer failed!" << std::endl;
+        } else if (onBatch && !onBatch(offset + params.queryCount)) {
+            completed = false;
+        }
+    }
+
+    if (completed) {
+        const auto* results = static_cast<const GPULightBakeResult*>(resultBuffer->contents());
+        outResults.assign(results, results + queries.size());
+    }
+    if (queryBuffer) {
+        queryBuffer->release();
+    }
+    if (resultBuffer) {
+        resultBuffer->release();
+    }
+    return completed;
+}
+
+} // namespace Crescent
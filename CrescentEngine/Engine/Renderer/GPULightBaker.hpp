@@ -0,0 +1,194 @@
+#pragma once
+
+#include "../Math/Math.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class CommandQueue;
+    class ComputePipelineState;
+    class AccelerationStructure;
+    class Buffer;
+}
+
+namespace Crescent {
+
+class Mesh;
+
+// The structs below mirror LightBake.metal. The CPU baker fills them from the same lights,
+// materials and emissive triangles it traces itself, so both backends see one scene.
+
+struct GPULightBakeParams {
+    float ambient[4] = {};
+    float tint[4] = {};
+    float intensities[4] = {}; // x sky, y IBL
+    uint32_t lightCount = 0;
+    uint32_t emitterCount = 0;
+    int32_t indirectBounces = 0;
+    int32_t samplesPerTexel = 0;
+    float totalEmitterWeight = 0.0f;
+    uint32_t queryOffset = 0;
+    uint32_t queryCount = 0;
+    uint32_t hasCutout = 0;
+    uint32_t lightNodeCount = 0; // zero: emitters are picked through the alias table
+    uint32_t pad[3] = {};
+};
+static_assert(sizeof(GPULightBakeParams) == 96, "GPULightBakeParams must match LightBakeParams in LightBake.metal");
+
+struct GPULightBakeLight {
+    float positionRange[4] = {};
+    float directionIntensity[4] = {};
+    float color[4] = {};
+    float shadow[4] = {};   // x bias, y normal bias, z distance
+    float spot[4] = {};     // x cos inner, y cos outer
+    int32_t flags[4] = {};  // x Light::Type, y stationary, z casts shadows, w shadowmask channel
+};
+static_assert(sizeof(GPULightBakeLight) == 96, "GPULightBakeLight must match LightBakeLight in LightBake.metal");
+
+struct GPULightBakeEmitter {
+    float p0[4] = {};       // w area
+    float p1[4] = {};       // w weight
+    float p2[4] = {};       // w cumulative weight
+    float n0[4] = {};       // w two-sided
+    float n1[4] = {};
+    float n2[4] = {};
+    float uv01[4] = {};
+    float uv2[4] = {};
+    uint32_t material = 0xffffffffu;
+    uint32_t pad[3] = {};
+};
+static_assert(sizeof(GPULightBakeEmitter) == 144, "GPULightBakeEmitter must match LightBakeEmitter in LightBake.metal");
+
+// The CPU baker's emitter samplers, one alias entry per emitter and the light tree's nodes.
+struct GPULightBakeAliasEntry {
+    float probability = 1.0f;
+    uint32_t alias = 0;
+    uint32_t pad[2] = {};
+};
+static_assert(sizeof(GPULightBakeAliasEntry) == 16, "GPULightBakeAliasEntry must match LightBakeAliasEntry in LightBake.metal");
+
+struct GPULightBakeLightNode {
+    float boundsMin[4] = {}; // w weight
+    float boundsMax[4] = {}; // w cone angle
+    float coneAxis[4] = {};
+    uint32_t child = 0;
+    uint32_t leaf = 0;
+    uint32_t pad[2] = {};
+};
+static_assert(sizeof(GPULightBakeLightNode) == 64, "GPULightBakeLightNode must match LightBakeLightNode in LightBake.metal");
+
+struct GPULightBakeMaterial {
+    float albedo[4] = {0.7f, 0.7f, 0.7f, 1.0f};
+    float emission[4] = {0.0f, 0.0f, 0.0f, 1.0f}; // w AO
+    float uvTransform[4] = {1.0f, 1.0f, 0.0f, 0.0f};
+    int32_t textures[4] = {-1, -1, -1, -1};       // albedo, emission, AO, opacity
+    float alpha[4] = {};                          // x cutoff
+};
+static_assert(sizeof(GPULightBakeMaterial) == 80, "GPULightBakeMaterial must match LightBakeMaterial in LightBake.metal");
+
+// One lightmap texel sample or probe face.
+struct GPULightBakeQuery {
+    enum Mode : uint32_t {
+        Texel = 0,
+        ProbeIrradiance = 1,
+        ProbeSpecular = 2
+    };
+
+    float position[4] = {};       // w primary emission luminance
+    float geometryNormal[4] = {}; // w primary AO
+    float shadingNormal[4] = {};
+    uint32_t control[4] = {};     // x mode, y receive GI, z probe sample count
+    uint32_t seeds[4] = {};       // x emissive (probes: the only seed), y indirect
+};
+static_assert(sizeof(GPULightBakeQuery) == 80, "GPULightBakeQuery must match LightBakeQuery in LightBake.metal");
+
+struct GPULightBakeResult {
+    float direct[4] = {};
+    float indirect[4] = {};   // w 1 when dominant is set
+    float dominant[4] = {};   // w reference NdotL
+    float shadowmask[4] = {}; // negative for channels the texel did not trace
+};
+static_assert(sizeof(GPULightBakeResult) == 64, "GPULightBakeResult must match LightBakeResult in LightBake.metal");
+
+// Hardware ray traced backend of the static lighting bake. Builds one primitive acceleration
+// structure per mesh and an instance structure over the scene, then runs lightBakeKernel over
+// query lists the CPU baker prepares and accumulates. Uses its own device and queue, so it works
+// in the cooker as well as the editor.
+class GPULightBaker {
+public:
+    // RGBA8, borrowed until buildScene returns.
+    struct Texture {
+        const unsigned char* rgba = nullptr;
+        int width = 0;
+        int height = 0;
+    };
+
+    struct Instance {
+        std::shared_ptr<Mesh> mesh;
+        Math::Matrix4x4 worldMatrix = Math::Matrix4x4::Identity;
+        bool castShadows = true;
+        bool contributeGI = true;
+        // Range of SceneDesc::materials for the instance's submesh material slots.
+        uint32_t materialOffset = 0;
+        uint32_t materialCount = 0;
+    };
+
+    struct SceneDesc {
+        GPULightBakeParams params; // counts and query range are filled in by the baker
+        std::vector<GPULightBakeLight> lights;
+        std::vector<GPULightBakeEmitter> emitters;
+        std::vector<GPULightBakeAliasEntry> aliasTable;
+        std::vector<GPULightBakeLightNode> lightTree;
+        std::vector<GPULightBakeMaterial> materials;
+        std::vector<Texture> textures;
+        std::vector<Instance> instances;
+    };
+
+    // Larger textures are box-filtered down to this size on upload.
+    static constexpr int kMaxTextureSize = 1024;
+
+    GPULightBaker();
+    ~GPULightBaker();
+
+    // False when the device cannot ray trace or the kernel is missing; callers bake on the CPU.
+    bool initialize();
+    void shutdown();
+    bool isInitialized() const { return m_pipeline != nullptr; }
+
+    bool buildScene(const SceneDesc& scene);
+    // Overrides SceneDesc::params.samplesPerTexel for later traces; progressive bakes trace in slices.
+    void setSamplesPerTexel(int32_t samplesPerTexel) { m_params.samplesPerTexel = samplesPerTexel; }
+
+    // Runs the queries in order, a few thousand per command buffer. onBatch gets the number of
+    // queries finished so far and stops the trace by returning false.
+    bool trace(const std::vector<GPULightBakeQuery>& queries,
+               std::vector<GPULightBakeResult>& outResults,
+               const std::function<bool(size_t)>& onBatch);
+
+private:
+    void releaseScene();
+    MTL::Buffer* newBuffer(const void* data, size_t bytes);
+
+    MTL::Device* m_device = nullptr;
+    MTL::CommandQueue* m_queue = nullptr;
+    MTL::ComputePipelineState* m_pipeline = nullptr;
+
+    std::vector<MTL::AccelerationStructure*> m_meshStructures;
+    MTL::AccelerationStructure* m_sceneStructure = nullptr;
+    MTL::Buffer* m_lightBuffer = nullptr;
+    MTL::Buffer* m_emitterBuffer = nullptr;
+    MTL::Buffer* m_aliasBuffer = nullptr;
+    MTL::Buffer* m_lightNodeBuffer = nullptr;
+    MTL::Buffer* m_instanceBuffer = nullptr;
+    MTL::Buffer* m_triangleBuffer = nullptr;
+    MTL::Buffer* m_materialBuffer = nullptr;
+    MTL::Buffer* m_textureBuffer = nullptr;
+    MTL::Buffer* m_texelBuffer = nullptr;
+    GPULightBakeParams m_params;
+};
+
+} // namespace Crescent
@@ -0,0 +1,305 @@
+#include "GPUPassProfiler.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    constexpr float kPassTimeSmoothing = 0.1f;
+    // Device timestamp pairs are taken at least this far apart for the tick rate.
+    constexpr uint64_t kCalibrationIntervalNs = 500000000ull;
+
+    MTL::CounterSet* FindTimestampCounterSet(MTL::Device* device) {
+        NS::Array* sets = device->counterSets();
+        if (!sets) {
+            return nullptr;
+        }
+        for (NS::UInteger i = 0; i < sets->count(); ++i) {
+            MTL::CounterSet* set = sets->object<MTL::CounterSet>(i);
+            if (set && set->name() && set->name()->isEqualToString(MTL::CommonCounterSetTimestamp)) {
+                return set;
+            }
+        }
+        return nullptr;
+    }
+}
+
+const char* GPUPassName(GPUPass pass) {
+    switch (pass) {
+        case GPUPass::Culling: return "Culling";
+        case GPUPass::Prepass: return "Prepass";
+        case GPUPass::HZB: return "HZB";
+        case GPUPass::ShadowDirectional: return "ShadowDirectional";
+        case GPUPass::ShadowLocal: return "ShadowLocal";
+        case GPUPass::ShadowPoint: return "ShadowPoint";
+        case GPUPass::ClusterBuild: return "ClusterBuild";
+        case GPUPass::SSAO: return "SSAO";
+        case GPUPass::Decals: return "Decals";
+        case GPUPass::Velocity: return "Velocity";
+        case GPUPass::Main: return "Main";
+        case GPUPass::SSR: return "SSR";
+        case GPUPass::Fog: return "Fog";
+        case GPUPass::Upscale: return "Upscale";
+        case GPUPass::MotionBlur: return "MotionBlur";
+        case GPUPass::DepthOfField: return "DepthOfField";
+        case GPUPass::Bloom: return "Bloom";
+        case GPUPass::Post: return "Post";
+        case GPUPass::Count: break;
+    }
+    return "Unknown";
+}
+
+GPUPassProfiler::GPUPassProfiler()
+    : m_device(nullptr)
+    , m_computePass(nullptr)
+    , m_blitPass(nullptr)
+    , m_recordingSlot(0)
+    , m_recording(false)
+    , m_nsPerTick(0.0)
+    , m_calibrationCpu(0)
+    , m_calibrationGpu(0) {
+}
+
+GPUPassProfiler::~GPUPassProfiler() {
+    shutdown();
+}
+
+bool GPUPassProfiler::initialize(MTL::Device* device, uint32_t frameSlots) {
+    shutdown();
+    m_device = device;
+    if (!m_device || frameSlots == 0) {
+        return false;
+    }
+    if (!m_device->supportsCounterSampling(MTL::CounterSamplingPointAtStageBoundary)) {
+        std::cerr << "GPUPassProfiler: stage boundary counter sampling is not supported on this device\n";
+        return false;
+    }
+    MTL::CounterSet* timestamps = FindTimestampCounterSet(m_device);
+    if (!timestamps) {
+        std::cerr << "GPUPassProfiler: device has no timestamp counter set\n";
+        return false;
+    }
+
+    MTL::CounterSampleBufferDescriptor* desc = MTL::CounterSampleBufferDescriptor::alloc()->init();
+    desc->setCounterSet(timestamps);
+    desc->setSampleCount(kMaxIntervals * 2);
+    desc->setStorageMode(MTL::StorageModePrivate);
+    std::vector<FrameSlot> slots(frameSlots);
+    bool ok = true;
+    for (FrameSlot& slot : slots) {
+        NS::Error* error = nullptr;
+        slot.samples = m_device->newCounterSampleBuffer(desc, &error);
+        slot.results = m_device->newBuffer(sizeof(MTL::CounterResultTimestamp) * kMaxIntervals * 2,
+                                           MTL::ResourceStorageModeShared);
+        slot.intervals.reserve(kMaxIntervals);
+        if (!slot.samples || !slot.results) {
+            if (error && error->localizedDescription()) {
+                std::cerr << "GPUPassProfiler: " << error->localizedDescription()->utf8String() << "\n";
+            }
+            ok = false;
+        }
+    }
+    desc->release();
+    if (!ok) {
+        for (FrameSlot& slot : slots) {
+            if (slot.samples) { slot.samples->release(); }
+            if (slot.results) { slot.results->release(); }
+        }
+        m_device = nullptr;
+        return false;
+    }
+
+    m_slots = std::move(slots);
+    m_computePass = MTL::ComputePassDescriptor::alloc()->init();
+    m_blitPass = MTL::BlitPassDescriptor::alloc()->init();
+    calibrate();
+    return true;
+}
+
+void GPUPassProfiler::shutdown() {
+    for (FrameSlot& slot : m_slots) {
+        if (slot.samples) { slot.samples->release(); }
+        if (slot.results) { slot.results->release(); }
+    }
+    m_slots.clear();
+    if (m_computePass) { m_computePass->release(); m_computePass = nullptr; }
+    if (m_blitPass) { m_blitPass->release(); m_blitPass = nullptr; }
+    m_recording = false;
+    m_nsPerTick = 0.0;
+    m_calibrationCpu = 0;
+    m_calibrationGpu = 0;
+    m_passTimesMs = {};
+    m_device = nullptr;
+}
+
+void GPUPassProfiler::calibrate() {
+    MTL::Timestamp cpu = 0;
+    MTL::Timestamp gpu = 0;
+    m_device->sampleTimestamps(&cpu, &gpu);
+    if (m_calibrationCpu == 0) {
+        m_calibrationCpu = cpu;
+        m_calibrationGpu = gpu;
+        return;
+    }
+    if (cpu - m_calibrationCpu < kCalibrationIntervalNs || gpu <= m_calibrationGpu) {
+        return;
+    }
+    m_nsPerTick = static_cast<double>(cpu - m_calibrationCpu) / static_cast<double>(gpu - m_calibrationGpu);
+    m_calibrationCpu = cpu;
+    m_calibrationGpu = gpu;
+}
+
+void GPUPassProfiler::resolve(uint32_t slot, bool gameView) {
+    if (slot >= m_slots.size()) {
+        return;
+    }
+    FrameSlot& frame = m_slots[slot];
+    const uint32_t count = frame.resolvedIntervals;
+    frame.resolvedIntervals = 0;
+    calibrate();
+    if (m_nsPerTick <= 0.0) {
+        return;
+    }
+
+    std::array<uint64_t, kGPUPassCount> ticks{};
+    const auto* timestamps = static_cast<const MTL::CounterResultTimestamp*>(frame.results->contents());
+    for (uint32_t i = 0; i < count && i < frame.intervals.size(); ++i) {
+        const uint64_t start = timestamps[i * 2].timestamp;
+        const uint64_t end = timestamps[i * 2 + 1].timestamp;
+        // Stages that never ran, such as the vertex stage of a clear-only pass, report an error
+        // value or zero.
+        if (start == MTL::CounterErrorValue || end == MTL::CounterErrorValue
+            || start == 0 || end == 0 || end < start) {
+            continue;
+        }
+        ticks[static_cast<size_t>(frame.intervals[i])] += end - start;
+    }
+
+    std::array<float, kGPUPassCount>& times = m_passTimesMs[gameView ? 1 : 0];
+    for (size_t pass = 0; pass < kGPUPassCount; ++pass) {
+        const float ms = static_cast<float>(static_cast<double>(ticks[pass]) * m_nsPerTick * 1.0e-6);
+        times[pass] += (ms - times[pass]) * kPassTimeSmoothing;
+    }
+}
+
+void GPUPassProfiler::beginFrame(uint32_t slot) {
+    {
+        std::lock_guard<std::mutex> lock(m_workMutex);
+        m_work.fill(GPUPassWork{});
+    }
+    if (slot >= m_slots.size()) {
+        m_recording = false;
+        return;
+    }
+    m_recordingSlot = slot;
+    m_slots[slot].intervals.clear();
+    m_slots[slot].resolvedIntervals = 0;
+    m_recording = true;
+}
+
+void GPUPassProfiler::endFrame(MTL::CommandBuffer* commandBuffer) {
+    if (!m_recording) {
+        return;
+    }
+    m_recording = false;
+    FrameSlot& frame = m_slots[m_recordingSlot];
+    if (frame.intervals.empty() || !commandBuffer) {
+        return;
+    }
+    const NS::UInteger count = static_cast<NS::UInteger>(frame.intervals.size());
+    MTL::BlitCommandEncoder* blit = commandBuffer->blitCommandEncoder();
+    blit->resolveCounters(frame.samples, NS::Range::Make(0, count * 2), frame.results, 0);
+    blit->endEncoding();
+    frame.resolvedIntervals = static_cast<uint32_t>(count);
+}
+
+bool GPUPassProfiler::reserve(GPUPass pass, uint32_t& outSample) {
+    if (!m_recording) {
+        return false;
+    }
+    FrameSlot& frame = m_slots[m_recordingSlot];
+    if (frame.intervals.size() >= kMaxIntervals) {
+        return false;
+    }
+    outSample = static_cast<uint32_t>(frame.intervals.size()) * 2;
+    frame.intervals.push_back(pass);
+    return true;
+}
+
+void GPUPassProfiler::attach(MTL::RenderPassDescriptor* descriptor, GPUPass pass) {
+    GPUPassWork opened;
+    opened.encoders = 1;
+    recordWork(pass, opened);
+    uint32_t sample = 0;
+    if (!descriptor || !reserve(pass, sample)) {
+        return;
+    }
+    MTL::RenderPassSampleBufferAttachmentDescriptor* attachment = descriptor->sampleBufferAttachments()->object(0);
+    attachment->setSampleBuffer(m_slots[m_recordingSlot].samples);
+    attachment->setStartOfVertexSampleIndex(sample);
+    attachment->setEndOfVertexSampleIndex(MTL::CounterDontSample);
+    attachment->setStartOfFragmentSampleIndex(MTL::CounterDontSample);
+    attachment->setEndOfFragmentSampleIndex(sample + 1);
+}
+
+void GPUPassProfiler::detach(MTL::RenderPassDescriptor* descriptor) {
+    if (descriptor && isAvailable()) {
+        descriptor->sampleBufferAttachments()->object(0)->setSampleBuffer(nullptr);
+    }
+}
+
+void GPUPassProfiler::recordWork(GPUPass pass, const GPUPassWork& work) {
+    std::lock_guard<std::mutex> lock(m_workMutex);
+    m_work[static_cast<size_t>(pass)] += work;
+}
+
+std::array<GPUPassWork, kGPUPassCount> GPUPassProfiler::getWork() const {
+    std::lock_guard<std::mutex> lock(m_workMutex);
+    return m_work;
+}
+
+MTL::RenderCommandEncoder* GPUPassProfiler::renderEncoder(MTL::CommandBuffer* commandBuffer,
+                                                          MTL::RenderPassDescriptor* descriptor,
+                                                          GPUPass pass) {
+    attach(descriptor, pass);
+    MTL::RenderCommandEncoder* encoder = commandBuffer->renderCommandEncoder(descriptor);
+    detach(descriptor);
+    return encoder;
+}
+
+MTL::ComputeCommandEncoder* GPUPassProfiler::computeEncoder(MTL::CommandBuffer* commandBuffer, GPUPass pass) {
+    GPUPassWork opened;
+    opened.encoders = 1;
+    recordWork(pass, opened);
+    uint32_t sample = 0;
+    if (!reserve(pass, sample)) {
+        return commandBuffer->computeCommandEncoder();
+    }
+    MTL::ComputePassSampleBufferAttachmentDescriptor* attachment = m_computePass->sampleBufferAttachments()->object(0);
+    attachment->setSampleBuffer(m_slots[m_recordingSlot].samples);
+    attachment->setStartOfEncoderSampleIndex(sample);
+    attachment->setEndOfEncoderSampleIndex(sample + 1);
+    MTL::ComputeCommandEncoder* encoder = commandBuffer->computeCommandEncoder(m_computePass);
+    attachment->setSampleBuffer(nullptr);
+    return encoder;
+}
+
+MTL::BlitCommandEncoder* GPUPassProfiler::blitEncoder(MTL::CommandBuffer* commandBuffer, GPUPass pass) {
+    GPUPassWork opened;
+    opened.encoders = 1;
+    recordWork(pass, opened);
+    uint32_t sample = 0;
+    if (!reserve(pass, sample)) {
+        return commandBuffer->blitCommandEncoder();
+    }
+    MTL::BlitPassSampleBufferAttachmentDescriptor* attachment = m_blitPass->sampleBufferAttachments()->object(0);
+    attachment->setSampleBuffer(m_slots[m_recordingSlot].samples);
+    attachment->setStartOfEncoderSampleIndex(sample);
+    attachment->setEndOfEncoderSampleIndex(sample + 1);
+    MTL::BlitCommandEncoder* encoder = commandBuffer->blitCommandEncoder(m_blitPass);
+    attachment->setSampleBuffer(nullptr);
+    return encoder;
+}
+
+} // namespace Crescent
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class Buffer;
+    class CommandBuffer;
+    class CounterSampleBuffer;
+    class RenderPassDescriptor;
+    class ComputePassDescriptor;
+    class BlitPassDescriptor;
+    class RenderCommandEncoder;
+    class ComputeCommandEncoder;
+    class BlitCommandEncoder;
+}
+
+namespace Crescent {
+
+// Render passes timed by GPUPassProfiler. Transparent draws share the main pass encoder and are
+// part of Main; Upscale covers the TAA resolve and the MetalFX copies around the scaler.
+enum class GPUPass : uint8_t {
+    Culling,
+    Prepass,
+    HZB,
+    ShadowDirectional,
+    ShadowLocal,
+    ShadowPoint,
+    ClusterBuild,
+    SSAO,
+    Decals,
+    Velocity,
+    Main,
+    SSR,
+    Fog,
+    Upscale,
+    MotionBlur,
+    DepthOfField,
+    Bloom,
+    Post,
+    Count
+};
+constexpr size_t kGPUPassCount = static_cast<size_t>(GPUPass::Count);
+
+const char* GPUPassName(GPUPass pass);
+
+// CPU-side work recorded into one pass in a frame. Encoders are the ones opened for the pass,
+// without parallel sub-encoders; the rest is reported by the per-draw loops that encode it.
+struct GPUPassWork {
+    uint32_t encoders = 0;
+    uint32_t draws = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t bufferBinds = 0; // buffers and inline bytes
+    uint32_t textureBinds = 0;
+    uint64_t inlineBytes = 0; // uniforms passed with setVertexBytes/setFragmentBytes
+    uint64_t ringBytes = 0;   // uniforms written to the per-frame uniform ring
+
+    GPUPassWork& operator+=(const GPUPassWork& other) {
+        encoders += other.encoders;
+        draws += other.draws;
+        pipelineBinds += other.pipelineBinds;
+        bufferBinds += other.bufferBinds;
+        textureBinds += other.textureBinds;
+        inlineBytes += other.inlineBytes;
+        ringBytes += other.ringBytes;
+        return *this;
+    }
+};
+
+// GPU time per render pass from timestamp counters sampled at encoder boundaries: start of vertex
+// and end of fragment work for render encoders, start and end of the encoder for compute and blit.
+// Each frame slot owns a sample buffer that the end of its frame resolves into a shared buffer on
+// the GPU, read once the slot's command buffer has completed, so results are a few frames behind
+// and never stall. A pass made of several encoders is the sum of their times, so other work
+// encoded between them does not count towards it. Devices without stage-boundary sampling create
+// plain encoders and report zeros.
+class GPUPassProfiler {
+public:
+    static constexpr uint32_t kMaxIntervals = 256; // sampled encoders per frame
+
+    GPUPassProfiler();
+    ~GPUPassProfiler();
+
+    bool initialize(MTL::Device* device, uint32_t frameSlots);
+    void shutdown();
+    bool isAvailable() const { return !m_slots.empty(); }
+
+    // Folds the timestamps of the slot's finished frame into the pass times of its view kind.
+    // Only after the slot's command buffer has completed.
+    void resolve(uint32_t slot, bool gameView);
+    // Starts recording a new frame into the slot.
+    void beginFrame(uint32_t slot);
+    // Last encoder of the frame: copies the recorded samples out for resolve.
+    void endFrame(MTL::CommandBuffer* commandBuffer);
+
+    MTL::RenderCommandEncoder* renderEncoder(MTL::CommandBuffer* commandBuffer,
+                                             MTL::RenderPassDescriptor* descriptor, GPUPass pass);
+    MTL::ComputeCommandEncoder* computeEncoder(MTL::CommandBuffer* commandBuffer, GPUPass pass);
+    MTL::BlitCommandEncoder* blitEncoder(MTL::CommandBuffer* commandBuffer, GPUPass pass);
+    // For render passes opened elsewhere (ParallelPassEncoder): attach before the encoder is
+    // created, detach right after.
+    void attach(MTL::RenderPassDescriptor* descriptor, GPUPass pass);
+    void detach(MTL::RenderPassDescriptor* descriptor);
+
+    // Adds draws and binds to the pass's work for this frame; safe from encoding jobs.
+    void recordWork(GPUPass pass, const GPUPassWork& work);
+    // Work per pass since beginFrame. Encoders are counted with or without timestamp sampling.
+    std::array<GPUPassWork, kGPUPassCount> getWork() const;
+
+    // Smoothed milliseconds per pass; passes that stopped running decay towards zero.
+    const std::array<float, kGPUPassCount>& getPassTimesMs(bool gameView) const {
+        return m_passTimesMs[gameView ? 1 : 0];
+    }
+
+private:
+    struct FrameSlot {
+        MTL::CounterSampleBuffer* samples = nullptr;
+        MTL::Buffer* results = nullptr;
+        // Pass of each interval; interval i owns samples 2i and 2i + 1.
+        std::vector<GPUPass> intervals;
+        // Intervals copied into results by endFrame.
+        uint32_t resolvedIntervals = 0;
+    };
+
+    // Index of the interval's first sample, or false when sampling is off or the slot is full.
+    bool reserve(GPUPass pass, uint32_t& outSample);
+    void calibrate();
+
+    MTL::Device* m_device;
+    MTL::ComputePassDescriptor* m_computePass;
+    MTL::BlitPassDescriptor* m_blitPass;
+    std::vector<FrameSlot> m_slots;
+    uint32_t m_recordingSlot;
+    bool m_recording;
+    // CPU nanoseconds per GPU timestamp tick, from pairs of device timestamps; zero until the
+    // first calibration.
+    double m_nsPerTick;
+    uint64_t m_calibrationCpu;
+    uint64_t m_calibrationGpu;
+    std::array<std::array<float, kGPUPassCount>, 2> m_passTimesMs{};
+    mutable std::mutex m_workMutex;
+    std::array<GPUPassWork, kGPUPassCount> m_work{};
+};
+
+} // namespace Crescent
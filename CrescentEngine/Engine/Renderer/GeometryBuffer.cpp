@@ -0,0 +1,444 @@
+#include "GeometryBuffer.hpp"
+#include "../Rendering/Mesh.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+
+struct SkinWeightGPU {
+    uint32_t indices[4];
+    float weights[4];
+};
+
+constexpr size_t kInitialVertexBytes = 8ull * 1024ull * 1024ull;
+constexpr size_t kInitialAttributeBytes = 16ull * 1024ull * 1024ull;
+constexpr size_t kInitialIndexBytes = 16ull * 1024ull * 1024ull;
+constexpr size_t kInitialSkinWeightBytes = 4ull * 1024ull * 1024ull;
+constexpr size_t kInitialMeshletBytes = 4ull * 1024ull * 1024ull;
+// An arena is compacted once holes make up this fraction of its used span and exceed the floor.
+constexpr size_t kCompactHoleDivisor = 4;
+constexpr size_t kCompactMinHoleBytes = 1ull * 1024ull * 1024ull;
+
+size_t AlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+GeometryBuffer& GeometryBuffer::getInstance() {
+    // Never destroyed: meshes owned by other singletons may be released during exit.
+    static GeometryBuffer* instance = new GeometryBuffer();
+    return *instance;
+}
+
+MTL::VertexDescriptor* GeometryBuffer::NewVertexDescriptor(VertexStreams streams, bool skinned) {
+    MTL::VertexDescriptor* descriptor = MTL::VertexDescriptor::alloc()->init();
+    auto setAttribute = [descriptor](NS::UInteger index, MTL::VertexFormat format, size_t offset, uint32_t bufferIndex) {
+        descriptor->attributes()->object(index)->setFormat(format);
+        descriptor->attributes()->object(index)->setOffset(static_cast<NS::UInteger>(offset));
+        descriptor->attributes()->object(index)->setBufferIndex(bufferIndex);
+    };
+
+    // Position (attribute 0)
+    setAttribute(0, MTL::VertexFormatFloat3, 0, kPositionBufferIndex);
+    descriptor->layouts()->object(kPositionBufferIndex)->setStride(sizeof(float) * 3);
+    descriptor->layouts()->object(kPositionBufferIndex)->setStepFunction(MTL::VertexStepFunctionPerVertex);
+
+    if (streams != VertexStreams::Position) {
+        // TexCoord (attribute 2)
+        setAttribute(2, MTL::VertexFormatHalf2, offsetof(PackedVertexAttributes, texCoord), kAttributeBufferIndex);
+        if (streams == VertexStreams::Full) {
+            // Octahedral normal (attribute 1), tangent + bitangent sign (attribute 3), color (attribute 5),
+            // lightmap TexCoord (attribute 6)
+            setAttribute(1, MTL::VertexFormatShort2Normalized, offsetof(PackedVertexAttributes, normal), kAttributeBufferIndex);
+            setAttribute(3, MTL::VertexFormatInt1010102Normalized, offsetof(PackedVertexAttributes, tangent), kAttributeBufferIndex);
+            setAttribute(5, MTL::VertexFormatUChar4Normalized, offsetof(PackedVertexAttributes, color), kAttributeBufferIndex);
+            setAttribute(6, MTL::VertexFormatHalf2, offsetof(PackedVertexAttributes, texCoord1), kAttributeBufferIndex);
+        }
+        descriptor->layouts()->object(kAttributeBufferIndex)->setStride(sizeof(PackedVertexAttributes));
+        descriptor->layouts()->object(kAttributeBufferIndex)->setStepFunction(MTL::VertexStepFunctionPerVertex);
+    }
+
+    if (skinned) {
+        // Bone indices (attribute 7) and weights (attribute 8)
+        setAttribute(7, MTL::VertexFormatUInt4, offsetof(SkinWeightGPU, indices), kSkinWeightBufferIndex);
+        setAttribute(8, MTL::VertexFormatFloat4, offsetof(SkinWeightGPU, weights), kSkinWeightBufferIndex);
+        descriptor->layouts()->object(kSkinWeightBufferIndex)->setStride(sizeof(SkinWeightGPU));
+        descriptor->layouts()->object(kSkinWeightBufferIndex)->setStepFunction(MTL::VertexStepFunctionPerVertex);
+    }
+    return descriptor;
+}
+
+bool GeometryBuffer::initialize(MTL::Device* device) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_device) {
+        return true;
+    }
+    if (!device) {
+        return false;
+    }
+    m_device = device;
+    m_arenas[Vertices].minCapacity = kInitialVertexBytes;
+    m_arenas[Attributes].minCapacity = kInitialAttributeBytes;
+    m_arenas[Indices].minCapacity = kInitialIndexBytes;
+    m_arenas[SkinWeights].minCapacity = kInitialSkinWeightBytes;
+    m_arenas[Meshlets].minCapacity = kInitialMeshletBytes;
+    for (uint32_t kind = 0; kind < ArenaCount; ++kind) {
+        if (!reallocate(static_cast<ArenaKind>(kind), m_arenas[kind].minCapacity)) {
+            std::cerr << "GeometryBuffer: failed to allocate arena " << kind << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void GeometryBuffer::shutdown() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Meshes may outlive the renderer; clear their bindings so a later device re-uploads them.
+    for (auto& [mesh, allocation] : m_allocations) {
+        mesh->setVertexBuffer(nullptr);
+        mesh->setAttributeBuffer(nullptr);
+        mesh->setIndexBuffer(nullptr);
+        mesh->setSkinWeightBuffer(nullptr);
+        mesh->setMeshletBuffer(nullptr);
+        mesh->setUploaded(false);
+    }
+    m_allocations.clear();
+    for (auto& retired : m_retired) {
+        retired.buffer->release();
+    }
+    m_retired.clear();
+    for (auto& arena : m_arenas) {
+        if (arena.buffer) {
+            arena.buffer->release();
+        }
+        arena = Arena{};
+    }
+    m_device = nullptr;
+}
+
+bool GeometryBuffer::upload(Mesh* mesh) {
+    if (!mesh) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_device) {
+        return false;
+    }
+    releaseLocked(mesh);
+
+    const size_t vertexCount = mesh->getVertexCount();
+    if (vertexCount == 0 || mesh->getIndexCount() == 0) {
+        return false;
+    }
+
+    Allocation allocation;
+    bool ok = true;
+    if (const MeshStreamSource* streams = mesh->getStreamSource()) {
+        // Cooked streams are already in GPU layout, base and LOD indices back to back, so they
+        // go into the arenas straight from the mapped file.
+        ok = allocate(Vertices, streams->positions, vertexCount * sizeof(float) * 3, allocation.ranges[Vertices]);
+        ok = ok && allocate(Attributes, streams->attributes, vertexCount * sizeof(PackedVertexAttributes),
+                            allocation.ranges[Attributes]);
+        ok = ok && allocate(Indices, streams->indices,
+                            (static_cast<size_t>(streams->indexCount) + streams->lodIndexCount) * sizeof(uint32_t),
+                            allocation.ranges[Indices]);
+    } else {
+        const auto& vertices = mesh->getVertices();
+        const auto& indices = mesh->getIndices();
+        if (vertices.empty() || indices.empty()) {
+            // GPU-only meshes have nothing left to upload from.
+            return false;
+        }
+        std::vector<float> positions(vertices.size() * 3);
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            positions[i * 3 + 0] = vertices[i].position.x;
+            positions[i * 3 + 1] = vertices[i].position.y;
+            positions[i * 3 + 2] = vertices[i].position.z;
+        }
+        const auto& attributes = mesh->getPackedAttributes();
+
+        ok = allocate(Vertices, positions.data(), positions.size() * sizeof(float), allocation.ranges[Vertices]);
+        ok = ok && allocate(Attributes, attributes.data(), attributes.size() * sizeof(PackedVertexAttributes),
+                            allocation.ranges[Attributes]);
+        // LOD index lists follow the base indices in the same range (see Mesh::getLodIndexBufferOffset).
+        const auto& lodIndices = mesh->getLodIndices();
+        if (lodIndices.empty()) {
+            ok = ok && allocate(Indices, indices.data(), indices.size() * sizeof(uint32_t), allocation.ranges[Indices]);
+        } else {
+            std::vector<uint32_t> combined;
+            combined.reserve(indices.size() + lodIndices.size());
+            combined.insert(combined.end(), indices.begin(), indices.end());
+            combined.insert(combined.end(), lodIndices.begin(), lodIndices.end());
+            ok = ok && allocate(Indices, combined.data(), combined.size() * sizeof(uint32_t), allocation.ranges[Indices]);
+        }
+    }
+
+    if (ok && mesh->hasSkinWeights()) {
+        const auto& skinWeights = mesh->getSkinWeights();
+        if (skinWeights.size() == vertexCount) {
+            std::vector<SkinWeightGPU> packed(skinWeights.size());
+            for (size_t i = 0; i < skinWeights.size(); ++i) {
+                for (int j = 0; j < 4; ++j) {
+                    packed[i].indices[j] = skinWeights[i].indices[j];
+                    packed[i].weights[j] = skinWeights[i].weights[j];
+                }
+            }
+            ok = allocate(SkinWeights, packed.data(), packed.size() * sizeof(SkinWeightGPU), allocation.ranges[SkinWeights]);
+        } else {
+            std::cerr << "Skin weights size mismatch for mesh: " << mesh->getName() << std::endl;
+        }
+    }
+
+    if (ok && mesh->hasMeshlets()) {
+        // One range per mesh: meshlet table, vertex list, triangle list (see Mesh::getMeshlet*Offset).
+        const auto& meshlets = mesh->getMeshlets();
+        const auto& meshletVertices = mesh->getMeshletVertices();
+        const auto& meshletTriangles = mesh->getMeshletTriangles();
+        const size_t tableBytes = meshlets.size() * sizeof(Meshlet);
+        const size_t vertexBytes = meshletVertices.size() * sizeof(uint32_t);
+        std::vector<uint8_t> packed(tableBytes + vertexBytes + meshletTriangles.size());
+        std::memcpy(packed.data(), meshlets.data(), tableBytes);
+        std::memcpy(packed.data() + tableBytes, meshletVertices.data(), vertexBytes);
+        std::memcpy(packed.data() + tableBytes + vertexBytes, meshletTriangles.data(), meshletTriangles.size());
+        ok = allocate(Meshlets, packed.data(), packed.size(), allocation.ranges[Meshlets]);
+    }
+
+    if (!ok) {
+        for (uint32_t kind = 0; kind < ArenaCount; ++kind) {
+            if (allocation.ranges[kind].size > 0) {
+                free(static_cast<ArenaKind>(kind), allocation.ranges[kind]);
+            }
+        }
+        std::cerr << "GeometryBuffer: out of memory uploading mesh: " << mesh->getName() << std::endl;
+        return false;
+    }
+
+    m_allocations[mesh] = allocation;
+    applyToMesh(mesh, allocation);
+    return true;
+}
+
+void GeometryBuffer::release(Mesh* mesh) {
+    if (!mesh) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    releaseLocked(mesh);
+}
+
+void GeometryBuffer::releaseLocked(Mesh* mesh) {
+    auto it = m_allocations.find(mesh);
+    if (it == m_allocations.end()) {
+        return;
+    }
+    for (uint32_t kind = 0; kind < ArenaCount; ++kind) {
+        if (it->second.ranges[kind].size > 0) {
+            free(static_cast<ArenaKind>(kind), it->second.ranges[kind]);
+        }
+    }
+    m_allocations.erase(it);
+    mesh->setVertexBuffer(nullptr);
+    mesh->setAttributeBuffer(nullptr);
+    mesh->setIndexBuffer(nullptr);
+    mesh->setSkinWeightBuffer(nullptr);
+    mesh->setMeshletBuffer(nullptr);
+}
+
+void GeometryBuffer::beginFrame(uint64_t frameIndex) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frameIndex = frameIndex;
+
+    auto retiredEnd = std::remove_if(m_retired.begin(), m_retired.end(), [&](const RetiredBuffer& retired) {
+        if (retired.frame + kRetireFrames > frameIndex) {
+            return false;
+        }
+        retired.buffer->release();
+        return true;
+    });
+    m_retired.erase(retiredEnd, m_retired.end());
+
+    for (uint32_t kind = 0; kind < ArenaCount; ++kind) {
+        Arena& arena = m_arenas[kind];
+        // Freed ranges only become reusable once no in-flight frame can still be drawing them.
+        auto pendingEnd = std::remove_if(arena.pending.begin(), arena.pending.end(), [&](const PendingRange& pending) {
+            if (pending.frame + kRetireFrames > frameIndex) {
+                return false;
+            }
+            insertHole(arena, pending.range);
+            return true;
+        });
+        arena.pending.erase(pendingEnd, arena.pending.end());
+
+        if (arena.compactRequested) {
+            arena.compactRequested = false;
+            maybeCompact(static_cast<ArenaKind>(kind));
+        }
+    }
+}
+
+size_t GeometryBuffer::getResidentBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t bytes = 0;
+    for (const auto& arena : m_arenas) {
+        bytes += arena.liveBytes;
+    }
+    return bytes;
+}
+
+size_t GeometryBuffer::getCapacityBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t bytes = 0;
+    for (const auto& arena : m_arenas) {
+        bytes += arena.capacity;
+    }
+    return bytes;
+}
+
+bool GeometryBuffer::allocate(ArenaKind kind, const void* data, size_t bytes, Range& outRange) {
+    Arena& arena = m_arenas[kind];
+    const size_t size = AlignUp(std::max<size_t>(bytes, 1), kAlignment);
+
+    bool placed = false;
+    for (size_t i = 0; i < arena.holes.size(); ++i) {
+        Range& hole = arena.holes[i];
+        if (hole.size < size) {
+            continue;
+        }
+        outRange = {hole.offset, size};
+        hole.offset += size;
+        hole.size -= size;
+        if (hole.size == 0) {
+            arena.holes.erase(arena.holes.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+        placed = true;
+        break;
+    }
+
+    if (!placed) {
+        if (arena.tail + size > arena.capacity) {
+            // Growth doubles the arena and compacts into the new buffer in the same copy.
+            size_t capacity = std::max(arena.capacity, arena.minCapacity);
+            while (capacity < arena.liveBytes + size) {
+                capacity *= 2;
+            }
+            if (!reallocate(kind, capacity)) {
+                return false;
+            }
+            if (arena.tail + size > arena.capacity) {
+                return false;
+            }
+        }
+        outRange = {arena.tail, size};
+        arena.tail += size;
+    }
+
+    std::memcpy(static_cast<uint8_t*>(arena.buffer->contents()) + outRange.offset, data, bytes);
+    arena.liveBytes += size;
+    return true;
+}
+
+void GeometryBuffer::free(ArenaKind kind, const Range& range) {
+    Arena& arena = m_arenas[kind];
+    arena.liveBytes -= range.size;
+    arena.pending.push_back({range, m_frameIndex});
+    const size_t holeBytes = arena.tail - arena.liveBytes;
+    if (holeBytes >= kCompactMinHoleBytes && holeBytes * kCompactHoleDivisor >= arena.tail) {
+        arena.compactRequested = true;
+    }
+}
+
+void GeometryBuffer::insertHole(Arena& arena, Range range) {
+    auto it = std::lower_bound(arena.holes.begin(), arena.holes.end(), range.offset,
+                               [](const Range& hole, size_t offset) { return hole.offset < offset; });
+    it = arena.holes.insert(it, range);
+    auto next = it + 1;
+    if (next != arena.holes.end() && it->offset + it->size == next->offset) {
+        it->size += next->size;
+        arena.holes.erase(next);
+    }
+    if (it != arena.holes.begin()) {
+        auto prev = it - 1;
+        if (prev->offset + prev->size == it->offset) {
+            prev->size += it->size;
+            it = arena.holes.erase(it) - 1;
+        }
+    }
+    if (it->offset + it->size == arena.tail) {
+        arena.tail = it->offset;
+        arena.holes.erase(it);
+    }
+}
+
+void GeometryBuffer::maybeCompact(ArenaKind kind) {
+    Arena& arena = m_arenas[kind];
+    const size_t holeBytes = arena.tail - arena.liveBytes;
+    if (holeBytes < kCompactMinHoleBytes || holeBytes * kCompactHoleDivisor < arena.tail) {
+        return;
+    }
+    // Shrink alongside compaction when the arena is mostly empty, but never below its start size.
+    size_t capacity = arena.capacity;
+    while (capacity / 2 >= arena.minCapacity && capacity / 2 >= arena.liveBytes * 2) {
+        capacity /= 2;
+    }
+    reallocate(kind, capacity);
+}
+
+bool GeometryBuffer::reallocate(ArenaKind kind, size_t capacity) {
+    Arena& arena = m_arenas[kind];
+    MTL::Buffer* buffer = m_device->newBuffer(capacity, MTL::ResourceStorageModeShared);
+    if (!buffer) {
+        return false;
+    }
+
+    // Pack live ranges to the front of the new buffer; the old one keeps serving in-flight frames.
+    size_t cursor = 0;
+    if (arena.buffer) {
+        const auto* src = static_cast<const uint8_t*>(arena.buffer->contents());
+        auto* dst = static_cast<uint8_t*>(buffer->contents());
+        for (auto& [mesh, allocation] : m_allocations) {
+            Range& range = allocation.ranges[kind];
+            if (range.size == 0) {
+                continue;
+            }
+            std::memcpy(dst + cursor, src + range.offset, range.size);
+            range.offset = cursor;
+            cursor += range.size;
+        }
+        m_retired.push_back({arena.buffer, m_frameIndex});
+        m_compactions++;
+    }
+
+    arena.buffer = buffer;
+    arena.capacity = capacity;
+    arena.memory.reset(MemoryCategory::Meshes, capacity);
+    arena.tail = cursor;
+    arena.liveBytes = cursor;
+    arena.holes.clear();
+    arena.pending.clear();
+
+    for (auto& [mesh, allocation] : m_allocations) {
+        applyToMesh(mesh, allocation);
+    }
+    return true;
+}
+
+void GeometryBuffer::applyToMesh(Mesh* mesh, const Allocation& allocation) const {
+    const Range& vertices = allocation.ranges[Vertices];
+    const Range& attributes = allocation.ranges[Attributes];
+    const Range& indices = allocation.ranges[Indices];
+    const Range& skinWeights = allocation.ranges[SkinWeights];
+    const Range& meshlets = allocation.ranges[Meshlets];
+    mesh->setVertexBuffer(vertices.size > 0 ? m_arenas[Vertices].buffer : nullptr, vertices.offset);
+    mesh->setAttributeBuffer(attributes.size > 0 ? m_arenas[Attributes].buffer : nullptr, attributes.offset);
+    mesh->setIndexBuffer(indices.size > 0 ? m_arenas[Indices].buffer : nullptr, indices.offset);
+    mesh->setSkinWeightBuffer(skinWeights.size > 0 ? m_arenas[SkinWeights].buffer : nullptr, skinWeights.offset);
+    mesh->setMeshletBuffer(meshlets.size > 0 ? m_arenas[Meshlets].buffer : nullptr, meshlets.offset);
+}
+
+} // namespace Crescent
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class Buffer;
+    class VertexDescriptor;
+}
+
+namespace Crescent {
+
+class Mesh;
+
+// Shared vertex, index and skin-weight storage for every uploaded mesh. Each mesh sub-allocates
+// a byte range in large MTL::Buffers (float3 positions, PackedVertexAttributes, indices, skin
+// weights, meshlets) instead of owning buffers of its own, so passes bind
+// the same buffer for every draw and only move the offset. Meshes keep non-owning pointers to
+// the arena buffers plus their offsets; whenever an arena is reallocated (growth or compaction)
+// every resident mesh is repointed.
+//
+// Replaced arena buffers stay alive for kRetireFrames frames so command buffers and indirect
+// command tables already encoded against them stay valid. release() may be called from any
+// thread (Mesh destructors); upload() and beginFrame() run on the render thread.
+class GeometryBuffer {
+public:
+    static constexpr size_t kAlignment = 256;
+    static constexpr uint64_t kRetireFrames = 4;
+
+    // Vertex buffer slots of the mesh streams. Slots 1-7 carry per-draw data in the mesh shaders.
+    static constexpr uint32_t kPositionBufferIndex = 0;
+    static constexpr uint32_t kSkinWeightBufferIndex = 4;
+    static constexpr uint32_t kAttributeBufferIndex = 8;
+
+    // Which streams a pipeline reads: depth-only passes fetch positions alone, alpha-tested depth
+    // passes add UVs from the attribute stream, shading passes read everything.
+    enum class VertexStreams {
+        Position,
+        PositionUV,
+        Full
+    };
+
+    // Stage-in layout for mesh pipelines; the caller releases it.
+    static MTL::VertexDescriptor* NewVertexDescriptor(VertexStreams streams, bool skinned);
+
+    static GeometryBuffer& getInstance();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isInitialized() const { return m_device != nullptr; }
+
+    // Copies the mesh's CPU data into the arenas and points the mesh at its ranges. Any previous
+    // allocation for the mesh is released first.
+    bool upload(Mesh* mesh);
+    // Frees the mesh's ranges and clears its buffer pointers. Compacts an arena once enough of it
+    // is holes.
+    void release(Mesh* mesh);
+
+    // Releases retired arena buffers the GPU can no longer be reading.
+    void beginFrame(uint64_t frameIndex);
+
+    MTL::Buffer* getVertexBuffer() const { return m_arenas[Vertices].buffer; }
+    MTL::Buffer* getAttributeBuffer() const { return m_arenas[Attributes].buffer; }
+    MTL::Buffer* getIndexBuffer() const { return m_arenas[Indices].buffer; }
+    MTL::Buffer* getSkinWeightBuffer() const { return m_arenas[SkinWeights].buffer; }
+    MTL::Buffer* getMeshletBuffer() const { return m_arenas[Meshlets].buffer; }
+
+    size_t getResidentBytes() const;
+    size_t getCapacityBytes() const;
+    size_t getCompactionCount() const { return m_compactions; }
+
+private:
+    enum ArenaKind : uint32_t {
+        Vertices = 0,
+        Attributes,
+        Indices,
+        SkinWeights,
+        Meshlets,
+        ArenaCount
+    };
+
+    struct Range {
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    struct Allocation {
+        Range ranges[ArenaCount];
+    };
+
+    struct PendingRange {
+        Range range;
+        uint64_t frame = 0;
+    };
+
+    struct Arena {
+        MTL::Buffer* buffer = nullptr;
+        size_t capacity = 0;
+        size_t minCapacity = 0;
+        size_t tail = 0;                   // end of the highest allocated range
+        size_t liveBytes = 0;
+        std::vector<Range> holes;          // reusable ranges below tail, sorted by offset
+        std::vector<PendingRange> pending; // freed ranges still visible to in-flight frames
+        bool compactRequested = false;
+        TrackedMemory memory;
+    };
+
+    struct RetiredBuffer {
+        MTL::Buffer* buffer = nullptr;
+        uint64_t frame = 0;
+    };
+
+    GeometryBuffer() = default;
+
+    bool allocate(ArenaKind kind, const void* data, size_t bytes, Range& outRange);
+    void free(ArenaKind kind, const Range& range);
+    void insertHole(Arena& arena, Range range);
+    bool reallocate(ArenaKind kind, size_t capacity);
+    void maybeCompact(ArenaKind kind);
+    void applyToMesh(Mesh* mesh, const Allocation& allocation) const;
+    void releaseLocked(Mesh* mesh);
+
+    MTL::Device* m_device = nullptr;
+    Arena m_arenas[ArenaCount];
+    std::unordered_map<Mesh*, Allocation> m_allocations;
+    std::vector<RetiredBuffer> m_retired;
+    uint64_t m_frameIndex = 0;
+    size_t m_compactions = 0;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace Crescent
@@ -0,0 +1,172 @@
+#include "ImpostorBaker.hpp"
+#include "../Core/JobScheduler.hpp"
+#include "../Rendering/Texture.hpp"
+#include "../Rendering/stb_image_write.h"
+#include <Metal/Metal.hpp>
+#include <iostream>
+#include <thread>
+
+namespace Crescent {
+
+namespace {
+    constexpr size_t kNotSaved = SIZE_MAX;
+    constexpr size_t kReadbackAlignment = 256;
+}
+
+ImpostorBaker::~ImpostorBaker() {
+    // Completion handlers and encode jobs hold their batch; only the readback and textures are
+    // released here once they are done.
+    std::vector<std::shared_ptr<Batch>> batches;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        batches.swap(m_Batches);
+    }
+    for (const std::shared_ptr<Batch>& batch : batches) {
+        while (!batch->gpuDone.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        JobScheduler::getInstance().wait(*batch->encodes);
+        release(*batch);
+    }
+}
+
+void ImpostorBaker::release(Batch& batch) {
+    for (Atlas& atlas : batch.atlases) {
+        if (atlas.texture) {
+            atlas.texture->release();
+            atlas.texture = nullptr;
+        }
+    }
+    if (batch.readback) {
+        batch.readback->release();
+        batch.readback = nullptr;
+    }
+}
+
+void ImpostorBaker::submit(MTL::Device* device, MTL::CommandBuffer* commandBuffer, std::vector<Atlas> atlases) {
+    if (!device || !commandBuffer || atlases.empty()) {
+        return;
+    }
+    auto batch = std::make_shared<Batch>();
+    batch->atlases = std::move(atlases);
+    batch->encodes = std::make_shared<JobFence>();
+    batch->readbackOffsets.assign(batch->atlases.size(), kNotSaved);
+    batch->written.assign(batch->atlases.size(), 0);
+
+    size_t readbackBytes = 0;
+    for (size_t i = 0; i < batch->atlases.size(); ++i) {
+        const Atlas& atlas = batch->atlases[i];
+        if (!atlas.request.saveToDisk || !atlas.texture) {
+            continue;
+        }
+        batch->readbackOffsets[i] = readbackBytes;
+        readbackBytes += (static_cast<size_t>(atlas.width) * atlas.height * 4 + kReadbackAlignment - 1)
+            & ~(kReadbackAlignment - 1);
+    }
+    if (readbackBytes > 0) {
+        batch->readback = device->newBuffer(readbackBytes, MTL::ResourceStorageModeShared);
+        if (!batch->readback) {
+            std::cerr << "[Impostor] Could not allocate " << readbackBytes << " bytes of readback, atlases are not saved\n";
+            batch->readbackOffsets.assign(batch->atlases.size(), kNotSaved);
+        }
+    }
+    if (batch->readback) {
+        MTL::BlitCommandEncoder* blit = commandBuffer->blitCommandEncoder();
+        for (size_t i = 0; i < batch->atlases.size(); ++i) {
+            if (batch->readbackOffsets[i] == kNotSaved) {
+                continue;
+            }
+            const Atlas& atlas = batch->atlases[i];
+            blit->copyFromTexture(atlas.texture, 0, 0, MTL::Origin::Make(0, 0, 0),
+                                  MTL::Size::Make(atlas.width, atlas.height, 1),
+                                  batch->readback, batch->readbackOffsets[i],
+                                  static_cast<NS::UInteger>(atlas.width) * 4,
+                                  static_cast<NS::UInteger>(atlas.width) * atlas.height * 4);
+        }
+        blit->endEncoding();
+    }
+
+    commandBuffer->addCompletedHandler([batch](MTL::CommandBuffer* completed) {
+        if (completed->status() != MTL::CommandBufferStatusCompleted) {
+            batch->gpuFailed = true;
+        } else {
+            for (size_t i = 0; i < batch->atlases.size(); ++i) {
+                if (batch->readbackOffsets[i] == kNotSaved) {
+                    continue;
+                }
+                Batch* raw = batch.get();
+                batch->encodes->remaining.fetch_add(1, std::memory_order_relaxed);
+                JobScheduler::getInstance().schedule(JobFunction([raw, i]() { encodeAtlas(raw, i); }), batch->encodes,
+                                                     JobPriority::Background);
+            }
+        }
+        batch->gpuDone.store(true, std::memory_order_release);
+    });
+
+    m_PendingAtlases.fetch_add(batch->atlases.size(), std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Batches.push_back(std::move(batch));
+}
+
+void ImpostorBaker::encodeAtlas(Batch* batch, size_t index) {
+    const Atlas& atlas = batch->atlases[index];
+    const uint8_t* pixels = static_cast<const uint8_t*>(batch->readback->contents()) + batch->readbackOffsets[index];
+    const int stride = static_cast<int>(atlas.width * 4);
+    if (stbi_write_png(atlas.outputPath.c_str(), static_cast<int>(atlas.width), static_cast<int>(atlas.height), 4,
+                       pixels, stride) != 0) {
+        batch->written[index] = 1;
+    } else {
+        std::cerr << "[Impostor] Failed to write " << atlas.outputPath << "\n";
+    }
+}
+
+void ImpostorBaker::collect(TextureLoader* loader) {
+    std::vector<std::shared_ptr<Batch>> finished;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto it = m_Batches.begin(); it != m_Batches.end();) {
+            Batch& batch = **it;
+            if (batch.gpuDone.load(std::memory_order_acquire) && batch.encodes->isComplete()) {
+                finished.push_back(std::move(*it));
+                it = m_Batches.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (const std::shared_ptr<Batch>& batch : finished) {
+        for (size_t i = 0; i < batch->atlases.size(); ++i) {
+            Atlas& atlas = batch->atlases[i];
+            std::shared_ptr<Texture2D> result;
+            std::string path;
+            if (!batch->gpuFailed && atlas.texture) {
+                if (atlas.request.saveToDisk) {
+                    if (batch->written[i] && loader) {
+                        path = atlas.outputPath;
+                        result = loader->loadTexture(path, true, false);
+                    }
+                } else {
+                    // The atlas holds sRGB-encoded colour like a saved one; sample it through an
+                    // sRGB view of the rendered texture.
+                    MTL::Texture* view = atlas.texture->newTextureView(MTL::PixelFormatRGBA8Unorm_sRGB);
+                    if (view) {
+                        result = std::make_shared<Texture2D>();
+                        result->setHandle(view); // takes the view's reference
+                        result->setDimensions(atlas.width, atlas.height);
+                        result->setColorSpace(Texture2D::ColorSpace::SRGB);
+                        result->setMipLevelCount(1);
+                        result->setApproximateBytes(static_cast<uint64_t>(atlas.width) * atlas.height * 4);
+                    }
+                }
+            }
+            if (atlas.request.onComplete) {
+                atlas.request.onComplete(result, path);
+            }
+        }
+        m_PendingAtlases.fetch_sub(batch->atlases.size(), std::memory_order_relaxed);
+        release(*batch);
+    }
+}
+
+} // namespace Crescent
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MTL {
+    class Buffer;
+    class CommandBuffer;
+    class Device;
+    class Texture;
+}
+
+namespace Crescent {
+
+class Material;
+class Mesh;
+class Texture2D;
+class TextureLoader;
+struct JobFence;
+
+// One impostor atlas to bake: rows x cols views of the mesh around its bounds, tileSize pixels each.
+struct ImpostorBakeRequest {
+    std::shared_ptr<Mesh> mesh;
+    std::shared_ptr<Material> material;
+    uint32_t rows = 8;
+    uint32_t cols = 8;
+    uint32_t tileSize = 128;
+    // Writes Assets/Generated/Impostors/<mesh>_<material>_impostor.png and returns the atlas
+    // loaded from it. Without saving, the rendered texture is returned as is and never read back.
+    bool saveToDisk = true;
+    // Runs on the render thread once the atlas is ready; atlas is null when the bake failed.
+    std::function<void(const std::shared_ptr<Texture2D>& atlas, const std::string& path)> onComplete;
+};
+
+// Completion side of Renderer::bakeImpostorAtlases. A submission's atlases render in one command
+// buffer; the ones to save are copied into a single shared readback buffer by a blit in the same
+// command buffer. Its completed handler queues one PNG encode per atlas on the JobScheduler's
+// background lane, and collect(), called by the renderer every frame, hands finished atlases to
+// their callbacks. Nothing waits for the GPU or the encoders.
+class ImpostorBaker {
+public:
+    struct Atlas {
+        ImpostorBakeRequest request;
+        MTL::Texture* texture = nullptr; // owned; RGBA8, rendered by the caller
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::string outputPath;          // empty unless request.saveToDisk
+    };
+
+    ImpostorBaker() = default;
+    ~ImpostorBaker();
+    ImpostorBaker(const ImpostorBaker&) = delete;
+    ImpostorBaker& operator=(const ImpostorBaker&) = delete;
+
+    // Encodes the readback of the atlases to save into commandBuffer and hooks its completion.
+    // Call before the command buffer is committed.
+    void submit(MTL::Device* device, MTL::CommandBuffer* commandBuffer, std::vector<Atlas> atlases);
+    // Runs the callbacks of every finished bake. Saved atlases are loaded through loader.
+    void collect(TextureLoader* loader);
+
+    size_t getPendingCount() const { return m_PendingAtlases.load(std::memory_order_relaxed); }
+
+private:
+    struct Batch {
+        std::vector<Atlas> atlases;
+        std::vector<size_t> readbackOffsets;  // per atlas; SIZE_MAX when not saved
+        std::vector<uint8_t> written;         // per atlas; 1 when its PNG was written
+        MTL::Buffer* readback = nullptr;
+        std::shared_ptr<JobFence> encodes;
+        std::atomic<bool> gpuDone{false};
+        bool gpuFailed = false;
+    };
+
+    static void encodeAtlas(Batch* batch, size_t index);
+    static void release(Batch& batch);
+
+    std::mutex m_Mutex;
+    std::vector<std::shared_ptr<Batch>> m_Batches;
+    std::atomic<size_t> m_PendingAtlases{0};
+};
+
+} // namespace Crescent
@@ -0,0 +1,185 @@
+#include "InstanceCache.hpp"
+#include "../Components/InstancedMeshRenderer.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace Crescent {
+
+namespace {
+    constexpr uint32_t kMinInstances = 256;
+    constexpr size_t kMinStagingBytes = 256u * 1024u;
+    // Renderers not drawn for this many frames (hidden, disabled or destroyed) give their buffer back.
+    constexpr uint64_t kEvictFrames = 300;
+
+    size_t GrowCapacity(size_t current, size_t required, size_t minimum) {
+        size_t capacity = std::max(current, minimum);
+        while (capacity < required) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+}
+
+InstanceCache::~InstanceCache() {
+    shutdown();
+}
+
+bool InstanceCache::initialize(MTL::Device* device) {
+    if (!device) {
+        return false;
+    }
+    m_Device = device;
+    return true;
+}
+
+void InstanceCache::shutdown() {
+    for (auto& [renderer, entry] : m_Entries) {
+        releaseEntry(entry);
+    }
+    m_Entries.clear();
+    for (StagingSlot& slot : m_Staging) {
+        if (slot.buffer) { slot.buffer->release(); slot.buffer = nullptr; }
+        slot.capacity = 0;
+        slot.memory.reset();
+    }
+    m_Pending.clear();
+    m_Uploads.clear();
+    m_Device = nullptr;
+}
+
+void InstanceCache::releaseEntry(Entry& entry) {
+    if (entry.buffer) {
+        entry.buffer->release();
+        entry.buffer = nullptr;
+    }
+    entry.capacity = 0;
+    entry.count = 0;
+    entry.memory.reset();
+}
+
+void InstanceCache::beginFrame(uint32_t frameSlot) {
+    m_FrameSlot = frameSlot % kMaxFramesInFlight;
+    ++m_Frame;
+    m_Pending.clear();
+    m_Uploads.clear();
+    m_UploadedBytes = 0;
+    for (auto it = m_Entries.begin(); it != m_Entries.end();) {
+        if (it->second.lastUsedFrame + kEvictFrames < m_Frame) {
+            releaseEntry(it->second);
+            it = m_Entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+MTL::Buffer* InstanceCache::update(InstancedMeshRenderer& renderer, const Math::Matrix4x4& parentMatrix,
+                                   bool vertexAnimation) {
+    if (!m_Device) {
+        return nullptr;
+    }
+    Entry& entry = m_Entries[&renderer];
+    entry.lastUsedFrame = m_Frame;
+
+    const auto& instances = renderer.getInstances();
+    const uint32_t count = static_cast<uint32_t>(instances.size());
+    const uint64_t version = renderer.getInstanceVersion();
+    const bool sameParent = entry.buffer && std::memcmp(entry.parentMatrix.m, parentMatrix.m, sizeof(parentMatrix.m)) == 0;
+    if (entry.buffer && version == entry.version && sameParent && vertexAnimation == entry.vertexAnimation) {
+        return entry.buffer;
+    }
+
+    // The dirty range is enough when it covers every edit since the last upload and nothing
+    // baked into all records changed.
+    uint32_t begin = 0;
+    uint32_t end = count;
+    const InstancedMeshRenderer::InstanceDirtyRange& dirty = renderer.getDirtyInstances();
+    if (entry.buffer && sameParent && vertexAnimation == entry.vertexAnimation && dirty.sinceVersion == entry.version
+        && count <= entry.capacity) {
+        begin = std::min(dirty.begin, count);
+        end = std::min(dirty.end, count);
+    }
+
+    if (!entry.buffer || count > entry.capacity) {
+        const uint32_t capacity = static_cast<uint32_t>(GrowCapacity(entry.capacity, count, kMinInstances));
+        MTL::Buffer* buffer = m_Device->newBuffer(static_cast<size_t>(capacity) * sizeof(Record), MTL::ResourceStorageModePrivate);
+        if (!buffer) {
+            return nullptr;
+        }
+        releaseEntry(entry);
+        entry.buffer = buffer;
+        entry.capacity = capacity;
+        entry.memory.reset(MemoryCategory::Instances, buffer->length());
+        begin = 0;
+        end = count;
+    }
+
+    if (begin < end) {
+        Upload upload;
+        upload.target = entry.buffer;
+        upload.targetOffset = static_cast<size_t>(begin) * sizeof(Record);
+        upload.stagingOffset = m_Pending.size();
+        upload.count = end - begin;
+        m_Pending.resize(m_Pending.size() + upload.count);
+        Record* records = m_Pending.data() + upload.stagingOffset;
+        const float vertexAnimationSpeed = renderer.getVertexAnimationSpeed();
+        for (uint32_t i = begin; i < end; ++i) {
+            Record& record = records[i - begin];
+            record.modelMatrix = parentMatrix * instances[i];
+            record.normalMatrix = record.modelMatrix.normalMatrix();
+            if (vertexAnimation) {
+                record.normalMatrix(2, 3) = renderer.getVertexAnimationOffset(i);
+                record.normalMatrix(3, 3) = vertexAnimationSpeed;
+            }
+        }
+        m_Uploads.push_back(upload);
+    }
+
+    entry.count = count;
+    entry.version = version;
+    entry.parentMatrix = parentMatrix;
+    entry.vertexAnimation = vertexAnimation;
+    renderer.clearDirtyInstances();
+    return entry.buffer;
+}
+
+void InstanceCache::encodeUploads(MTL::CommandBuffer* commandBuffer) {
+    if (m_Uploads.empty() || !commandBuffer) {
+        return;
+    }
+    StagingSlot& slot = m_Staging[m_FrameSlot];
+    const size_t bytes = m_Pending.size() * sizeof(Record);
+    if (!slot.buffer || slot.capacity < bytes) {
+        const size_t capacity = GrowCapacity(slot.capacity, bytes, kMinStagingBytes);
+        MTL::Buffer* buffer = m_Device->newBuffer(capacity, MTL::ResourceStorageModeShared);
+        if (!buffer) {
+            // Nothing was copied; the renderers upload everything again next frame.
+            for (auto& [renderer, entry] : m_Entries) {
+                entry.version = 0;
+            }
+            m_Pending.clear();
+            m_Uploads.clear();
+            return;
+        }
+        if (slot.buffer) {
+            slot.buffer->release();
+        }
+        slot.buffer = buffer;
+        slot.capacity = buffer->length();
+        slot.memory.reset(MemoryCategory::Instances, slot.capacity);
+    }
+    std::memcpy(slot.buffer->contents(), m_Pending.data(), bytes);
+
+    MTL::BlitCommandEncoder* blit = commandBuffer->blitCommandEncoder();
+    for (const Upload& upload : m_Uploads) {
+        blit->copyFromBuffer(slot.buffer, upload.stagingOffset * sizeof(Record),
+                             upload.target, upload.targetOffset, upload.count * sizeof(Record));
+    }
+    blit->endEncoding();
+    m_UploadedBytes += bytes;
+    m_Pending.clear();
+    m_Uploads.clear();
+}
+
+} // namespace Crescent
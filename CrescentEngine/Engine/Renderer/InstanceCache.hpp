@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include "../Math/Math.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class Buffer;
+    class CommandBuffer;
+}
+
+namespace Crescent {
+
+class InstancedMeshRenderer;
+
+// Persistent GPU copies of InstancedMeshRenderer instances, for renderers whose instances need no
+// per-frame CPU work (no crowd poses, no billboard switching by camera distance). Each renderer
+// keeps its world-space instance records (InstanceData in PBR.metal) in a private buffer that the
+// instance culling and shadow passes read directly. A frame uploads only what changed: the
+// renderer's dirty instance range, or every instance after its transform, instance count or
+// vertex animation changed. Uploads are staged in the frame slot's shared buffer and copied with
+// one blit encoder before any pass reads the instances.
+class InstanceCache {
+public:
+    static constexpr uint32_t kMaxFramesInFlight = 4;
+
+    InstanceCache() = default;
+    ~InstanceCache();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_Device != nullptr; }
+
+    // Rewinds the slot's staging buffer, whose command buffer must have completed, and drops the
+    // renderers not drawn for a while.
+    void beginFrame(uint32_t frameSlot);
+    // Brings the renderer's records up to date for this parent transform and returns the buffer
+    // holding them, or null when it could not be allocated. vertexAnimation tells whether the
+    // renderer draws with its baked vertex animation, whose per-instance offsets the records hold.
+    MTL::Buffer* update(InstancedMeshRenderer& renderer, const Math::Matrix4x4& parentMatrix, bool vertexAnimation);
+    // Copies this frame's updates into the renderers' buffers.
+    void encodeUploads(MTL::CommandBuffer* commandBuffer);
+
+    uint64_t getUploadedBytes() const { return m_UploadedBytes; }
+    size_t getRendererCount() const { return m_Entries.size(); }
+
+private:
+    struct Record {
+        Math::Matrix4x4 modelMatrix;
+        Math::Matrix4x4 normalMatrix;
+    };
+    struct Entry {
+        MTL::Buffer* buffer = nullptr;
+        uint32_t capacity = 0;
+        uint32_t count = 0;
+        uint64_t version = 0;
+        Math::Matrix4x4 parentMatrix;
+        bool vertexAnimation = false;
+        uint64_t lastUsedFrame = 0;
+        TrackedMemory memory;
+    };
+    struct Upload {
+        MTL::Buffer* target = nullptr;
+        size_t targetOffset = 0;
+        size_t stagingOffset = 0; // into m_Pending, in records
+        size_t count = 0;
+    };
+    struct StagingSlot {
+        MTL::Buffer* buffer = nullptr;
+        size_t capacity = 0;
+        TrackedMemory memory;
+    };
+
+    void releaseEntry(Entry& entry);
+
+    MTL::Device* m_Device = nullptr;
+    std::unordered_map<const InstancedMeshRenderer*, Entry> m_Entries;
+    std::array<StagingSlot, kMaxFramesInFlight> m_Staging;
+    uint32_t m_FrameSlot = 0;
+    uint64_t m_Frame = 0;
+    std::vector<Record> m_Pending;
+    std::vector<Upload> m_Uploads;
+    uint64_t m_UploadedBytes = 0;
+};
+
+} // namespace Crescent
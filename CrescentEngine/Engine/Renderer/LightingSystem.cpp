@@ -4,9 +4,11 @@
 #include "../ECS/Transform.hpp"
 #include "../Components/Camera.hpp"
 #include "DebugRenderer.hpp"
+#include "../Core/CPUProfiler.hpp"
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <limits>
 #include <unordered_map>
 #include <vector>
@@ -21,6 +23,10 @@ constexpr uint32_t kLightFlagVolumetric = 1u << 2u;
 constexpr uint32_t kLightFlagBakedDirect = 1u << 3u;
 constexpr uint32_t kLightMobilityShift = 4u;
 constexpr uint32_t kLightShadowmaskShift = 6u;
+// Light::ShadowQuality, the filter tier PBR.metal maps to PCF sample counts.
+constexpr uint32_t kLightShadowFilterShift = 9u;
+// The shadow atlas has min/max depth mips this frame (ShadowRenderPass::getDepthBounds).
+constexpr uint32_t kLightFlagShadowDepthBounds = 1u << 11u;
 
 std::array<float, 4> BuildCascadeSplitDistances(const Light* light, uint8_t cascadeCount) {
     std::array<float, 4> authoredSplits = light
@@ -81,88 +87,385 @@ uint32_t ComputeCascadeResolution(uint32_t requestedRes,
     return std::min(alignedRes, atlasResolution);
 }
 
+// Fraction of the view height covered by a light's range sphere; 1 once the camera is inside it.
+float ComputeShadowScreenCoverage(const Math::Vector3& center, float radius, Camera* camera) {
+    Transform* camTransform = camera->getEntity()->getTransform();
+    const float distance = (center - camTransform->getPosition()).length();
+    if (distance <= radius) {
+        return 1.0f;
+    }
+    const float halfHeight = camera->getProjectionType() == Camera::ProjectionType::Orthographic
+        ? camera->getOrthographicSize()
+        : distance * std::tan(camera->getFieldOfView() * 0.5f);
+    return std::min(1.0f, radius / std::max(halfHeight, 1e-4f));
+}
+
+// Full, half or quarter of the authored resolution by screen coverage. A light leaves the tier it
+// held last frame only once coverage clears the boundary by 15%, so tiles don't flip every frame.
+uint32_t ResolveLocalShadowResolution(uint32_t requested, float coverage, uint32_t previousSize) {
+    const float thresholds[2] = {0.30f, 0.10f};
+    const float hysteresis = 0.15f;
+    uint32_t tier = coverage >= thresholds[0] ? 0u : (coverage >= thresholds[1] ? 1u : 2u);
+    if (previousSize != 0) {
+        uint32_t previousTier = previousSize >= requested ? 0u : (previousSize >= requested / 2u ? 1u : 2u);
+        if (tier < previousTier && coverage < thresholds[tier] * (1.0f + hysteresis)) {
+            tier = previousTier;
+        } else if (tier > previousTier && coverage >= thresholds[previousTier] * (1.0f - hysteresis)) {
+            tier = previousTier;
+        }
+    }
+    return std::max(requested >> tier, std::min(requested, ShadowAtlas::kMinTileSize));
+}
+
+template <typename T>
+uint64_t HashShadowInput(uint64_t hash, const T& value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+constexpr uint64_t kShadowInputSeed = 14695981039346656037ull;
+
+// Bumps the version of every record whose bytes differ from last frame's, so per-frame-slot
+// buffers only re-upload stale records.
+template <typename Record>
+void TrackRecordVersions(const std::vector<Record>& current,
+                         std::vector<Record>& previous,
+                         std::vector<uint64_t>& versions,
+                         uint64_t& versionCounter) {
+    const size_t kept = std::min(current.size(), previous.size());
+    versions.resize(current.size(), 0);
+    for (size_t i = 0; i < current.size(); ++i) {
+        if (i >= kept || std::memcmp(&current[i], &previous[i], sizeof(Record)) != 0) {
+            versions[i] = ++versionCounter;
+        }
+    }
+    previous = current;
+}
+
 } // namespace
 
 ShadowAtlas::ShadowAtlas(uint32_t resolution, uint32_t layers)
     : m_resolution(resolution)
-    , m_layers(layers)
-    , m_cursorX(0)
-    , m_cursorY(0)
-    , m_rowHeight(0) {
-    reset();
+    , m_layers(std::max(1u, layers))
+    , m_maxLevel(0)
+    , m_nodesPerLayer(1)
+    , m_freeArea(0)
+    , m_repackPending(false)
+    , m_framesSinceRepack(0)
+    , m_lastFrame(0)
+    , m_downgradedCount(0) {
+    // Six levels take an 8k atlas down to 128 texel tiles.
+    while (m_maxLevel < 6 && (m_resolution >> (m_maxLevel + 1)) >= kMinTileSize) {
+        ++m_maxLevel;
+    }
+    m_nodesPerLayer = ((1u << (2u * (m_maxLevel + 1u))) - 1u) / 3u;
+    clear();
 }
 
-void ShadowAtlas::reset() {
-    m_cursorX = 0;
-    m_cursorY = 0;
-    m_rowHeight = 0;
-    m_tiles.clear();
+uint64_t ShadowAtlas::MakeKey(const Light* light, uint32_t view) {
+    return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(light)) ^ (static_cast<uint64_t>(view) << 56);
 }
 
-ShadowAtlasTile ShadowAtlas::allocate(uint32_t size) {
-    ShadowAtlasTile tile{};
-    if (size == 0) {
-        return tile;
+void ShadowAtlas::clear() {
+    m_nodes.assign(static_cast<size_t>(m_nodesPerLayer) * m_layers, NodeState::Free);
+    m_allocations.clear();
+    m_freeArea = static_cast<uint64_t>(m_resolution) * m_resolution * m_layers;
+}
+
+uint32_t ShadowAtlas::levelForSize(uint32_t size) const {
+    uint32_t level = 0;
+    while (level < m_maxLevel && nodeSize(level + 1) >= size) {
+        ++level;
     }
-    
-    size = std::min(size, m_resolution);
-    
-    // Simple skyline row allocation
-    if (m_cursorX + size > m_resolution) {
-        m_cursorX = 0;
-        m_cursorY += m_rowHeight;
-        m_rowHeight = 0;
+    return level;
+}
+
+int32_t ShadowAtlas::findNode(uint32_t base, uint32_t local, uint32_t level, uint32_t targetLevel) const {
+    const NodeState state = m_nodes[base + local];
+    if (level == targetLevel) {
+        return state == NodeState::Free ? static_cast<int32_t>(local) : -1;
     }
-    
-    if (m_cursorY + size > m_resolution) {
-        return tile; // invalid
+    if (state != NodeState::Split) {
+        return -1;
     }
-    
+    for (uint32_t child = 0; child < 4; ++child) {
+        int32_t found = findNode(base, local * 4 + 1 + child, level + 1, targetLevel);
+        if (found >= 0) {
+            return found;
+        }
+    }
+    return -1;
+}
+
+bool ShadowAtlas::acquireNode(uint32_t level, uint32_t& outNode) {
+    // Best fit: split the smallest free block that holds the tile, preferring lower layers.
+    for (int32_t from = static_cast<int32_t>(level); from >= 0; --from) {
+        for (uint32_t layer = 0; layer < m_layers; ++layer) {
+            const uint32_t base = layer * m_nodesPerLayer;
+            int32_t found = findNode(base, 0, 0, static_cast<uint32_t>(from));
+            if (found < 0) {
+                continue;
+            }
+            uint32_t local = static_cast<uint32_t>(found);
+            for (uint32_t l = static_cast<uint32_t>(from); l < level; ++l) {
+                m_nodes[base + local] = NodeState::Split;
+                local = local * 4 + 1;
+            }
+            m_nodes[base + local] = NodeState::Used;
+            m_freeArea -= static_cast<uint64_t>(nodeSize(level)) * nodeSize(level);
+            outNode = base + local;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShadowAtlas::releaseNode(uint32_t node) {
+    const uint32_t base = (node / m_nodesPerLayer) * m_nodesPerLayer;
+    uint32_t local = node - base;
+    uint32_t level = 0;
+    for (uint32_t n = local; n > 0; n = (n - 1) >> 2) {
+        ++level;
+    }
+    m_nodes[node] = NodeState::Free;
+    m_freeArea += static_cast<uint64_t>(nodeSize(level)) * nodeSize(level);
+    // Merge back up while all four siblings are free.
+    while (local > 0) {
+        const uint32_t parent = (local - 1) >> 2;
+        const uint32_t first = base + parent * 4 + 1;
+        if (m_nodes[first] != NodeState::Free || m_nodes[first + 1] != NodeState::Free ||
+            m_nodes[first + 2] != NodeState::Free || m_nodes[first + 3] != NodeState::Free) {
+            break;
+        }
+        m_nodes[base + parent] = NodeState::Free;
+        local = parent;
+    }
+}
+
+ShadowAtlasTile ShadowAtlas::tileForNode(uint32_t node, uint32_t level, uint32_t size) const {
+    ShadowAtlasTile tile{};
     tile.valid = true;
-    tile.x = m_cursorX;
-    tile.y = m_cursorY;
+    tile.layer = node / m_nodesPerLayer;
     tile.size = size;
-    tile.layer = 0;
-    
-    m_tiles.push_back(tile);
-    
-    m_cursorX += size;
-    m_rowHeight = std::max(m_rowHeight, size);
-    
+    uint32_t local = node - tile.layer * m_nodesPerLayer;
+    for (uint32_t l = level; local > 0; --l) {
+        const uint32_t child = (local - 1) & 3u;
+        tile.x += (child & 1u) * nodeSize(l);
+        tile.y += (child >> 1) * nodeSize(l);
+        local = (local - 1) >> 2;
+    }
     return tile;
 }
 
+uint32_t ShadowAtlas::largestFreeSize() const {
+    for (uint32_t level = 0, first = 0; level <= m_maxLevel; first += 1u << (2u * level), ++level) {
+        const uint32_t count = 1u << (2u * level);
+        for (uint32_t layer = 0; layer < m_layers; ++layer) {
+            const uint32_t base = layer * m_nodesPerLayer;
+            for (uint32_t local = first; local < first + count; ++local) {
+                // A free node under a free parent was already counted as part of the parent.
+                if (m_nodes[base + local] == NodeState::Free &&
+                    (local == 0 || m_nodes[base + ((local - 1) >> 2)] != NodeState::Free)) {
+                    return nodeSize(level);
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+float ShadowAtlas::getFragmentation() const {
+    if (m_freeArea == 0) {
+        return 0.0f;
+    }
+    const uint64_t largest = largestFreeSize();
+    return 1.0f - static_cast<float>(static_cast<double>(largest * largest) / static_cast<double>(m_freeArea));
+}
+
+uint32_t ShadowAtlas::getTileSize(uint64_t key) const {
+    auto it = m_allocations.find(key);
+    return it != m_allocations.end() ? it->second.size : 0u;
+}
+
+void ShadowAtlas::allocate(std::vector<ShadowAtlasRequest>& requests, uint64_t frame) {
+    if (frame != m_lastFrame) {
+        if (m_repackPending && m_framesSinceRepack >= kRepackIntervalFrames) {
+            clear();
+            m_repackPending = false;
+            m_framesSinceRepack = 0;
+        }
+        ++m_framesSinceRepack;
+        m_lastFrame = frame;
+    }
+    m_tiles.clear();
+    m_downgradedCount = 0;
+    for (auto& entry : m_allocations) {
+        entry.second.requested = false;
+    }
+
+    m_order.resize(requests.size());
+    for (uint32_t i = 0; i < m_order.size(); ++i) {
+        m_order[i] = i;
+    }
+    std::stable_sort(m_order.begin(), m_order.end(), [&](uint32_t a, uint32_t b) {
+        return requests[a].importance > requests[b].importance;
+    });
+
+    // Keep every tile whose key still asks for the same level.
+    for (uint32_t index : m_order) {
+        ShadowAtlasRequest& request = requests[index];
+        request.tile = ShadowAtlasTile{};
+        if (request.size == 0) {
+            continue;
+        }
+        auto it = m_allocations.find(request.key);
+        const uint32_t level = levelForSize(request.size);
+        if (it == m_allocations.end() || it->second.requested) {
+            continue;
+        }
+        if (it->second.requestedLevel != level) {
+            // Resized: the old tile goes back now rather than with the expired keys.
+            releaseNode(it->second.node);
+            m_allocations.erase(it);
+            continue;
+        }
+        Allocation& allocation = it->second;
+        allocation.requested = true;
+        allocation.lastFrame = frame;
+        allocation.size = allocation.level == level
+            ? std::min(request.size, nodeSize(level))
+            : nodeSize(allocation.level);
+        request.tile = tileForNode(allocation.node, allocation.level, allocation.size);
+    }
+
+    // Keys another view of this frame or of the previous one still asked for keep their tiles.
+    for (auto it = m_allocations.begin(); it != m_allocations.end();) {
+        if (!it->second.requested && it->second.lastFrame + 1 < frame) {
+            releaseNode(it->second.node);
+            it = m_allocations.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Place new and resized tiles, stepping down a level at a time while the atlas is full.
+    for (uint32_t index : m_order) {
+        ShadowAtlasRequest& request = requests[index];
+        if (request.tile.valid || request.size == 0 || m_allocations.count(request.key) != 0) {
+            continue;
+        }
+        const uint32_t level = levelForSize(request.size);
+        for (uint32_t l = level; l <= m_maxLevel; ++l) {
+            uint32_t node = 0;
+            if (acquireNode(l, node)) {
+                Allocation allocation;
+                allocation.node = node;
+                allocation.level = l;
+                allocation.requestedLevel = level;
+                allocation.size = l == level ? std::min(request.size, nodeSize(l)) : nodeSize(l);
+                allocation.lastFrame = frame;
+                allocation.requested = true;
+                m_allocations.emplace(request.key, allocation);
+                request.tile = tileForNode(node, l, allocation.size);
+                break;
+            }
+            // The free area could hold the tile but no single block can: repack next frame.
+            const uint64_t needed = static_cast<uint64_t>(nodeSize(l)) * nodeSize(l);
+            if (l == level && m_freeArea >= needed && getFragmentation() > kRepackFragmentation) {
+                m_repackPending = true;
+            }
+        }
+    }
+
+    // Move downgraded tiles back up once their full level fits again.
+    for (uint32_t index : m_order) {
+        ShadowAtlasRequest& request = requests[index];
+        auto it = request.tile.valid ? m_allocations.find(request.key) : m_allocations.end();
+        if (it == m_allocations.end() || it->second.level == it->second.requestedLevel) {
+            continue;
+        }
+        Allocation& allocation = it->second;
+        uint32_t node = 0;
+        if (!acquireNode(allocation.requestedLevel, node)) {
+            continue;
+        }
+        releaseNode(allocation.node);
+        allocation.node = node;
+        allocation.level = allocation.requestedLevel;
+        allocation.size = std::min(request.size, nodeSize(allocation.level));
+        request.tile = tileForNode(node, allocation.level, allocation.size);
+    }
+
+    for (const auto& request : requests) {
+        if (!request.tile.valid) {
+            continue;
+        }
+        m_tiles.push_back(request.tile);
+        if (request.tile.size < std::min(request.size, m_resolution)) {
+            ++m_downgradedCount;
+        }
+    }
+}
+
 LightingSystem::LightingSystem()
     : m_shadowAtlas(4096, 1)
     , m_viewportWidth(1)
     , m_viewportHeight(1)
     , m_debugDrawAtlas(false)
     , m_bakeDirectLighting(false)
-    , m_pointCubeCounts({0,0,0,0}) {
+    , m_shadowDepthBounds(false)
+    , m_pointCubeCounts({0,0,0,0})
+    , m_cascadeUpdateIntervals({1,1,1,1})
+    , m_shadowDrawBudget(0)
+    , m_shadowUpdateFrame(0)
+    , m_deferredShadowViews(0) {
 }
 
 void LightingSystem::configureShadowAtlas(uint32_t resolution, uint32_t layers) {
     m_shadowAtlas = ShadowAtlas(resolution, layers);
 }
 
-void LightingSystem::beginFrame(Scene* scene, Camera* camera, uint32_t viewportWidth, uint32_t viewportHeight) {
+void LightingSystem::setShadowUpdateCadence(const std::array<int, 4>& cascadeIntervals, uint32_t drawBudget) {
+    for (size_t i = 0; i < cascadeIntervals.size(); ++i) {
+        m_cascadeUpdateIntervals[i] = static_cast<uint32_t>(
+            std::max(1, std::min(static_cast<int>(kMaxShadowUpdateInterval), cascadeIntervals[i])));
+    }
+    m_shadowDrawBudget = drawBudget;
+}
+
+void LightingSystem::setShadowViewDrawCounts(const std::unordered_map<uint64_t, uint32_t>& drawCounts) {
+    for (const auto& [key, draws] : drawCounts) {
+        auto it = m_shadowUpdates.find(key);
+        if (it != m_shadowUpdates.end()) {
+            it->second.drawCount = draws;
+        }
+    }
+}
+
+void LightingSystem::beginFrame(Scene* scene, Camera* camera, uint32_t viewportWidth, uint32_t viewportHeight, uint64_t frame) {
+    CRESCENT_PROFILE_SCOPE("LightingSystem::beginFrame");
     m_viewportWidth = viewportWidth;
     m_viewportHeight = viewportHeight;
+    m_shadowUpdateFrame = frame;
     m_preparedLights.clear();
     m_gpuLights.clear();
     m_gpuShadows.clear();
     m_cascades.clear();
-    m_shadowAtlas.reset();
     m_pointCubeCounts = {0,0,0,0};
+    m_deferredShadowViews = 0;
     m_bakeDirectLighting = scene ? scene->getSettings().staticLighting.bakeDirectLighting : false;
     
-    if (!scene || !camera) {
-        return;
+    if (scene && camera) {
+        gatherLights(scene, camera);
+        allocateShadows(camera);
+        fillGPUBuffers();
     }
-    
-    gatherLights(scene, camera);
-    allocateShadows();
-    fillGPUBuffers();
+    TrackRecordVersions(m_gpuLights, m_lastGpuLights, m_gpuLightVersions, m_recordVersionCounter);
+    TrackRecordVersions(m_gpuShadows, m_lastGpuShadows, m_gpuShadowVersions, m_recordVersionCounter);
 }
 
 void LightingSystem::gatherLights(Scene* scene, Camera* camera) {
@@ -170,33 +473,41 @@ void LightingSystem::gatherLights(Scene* scene, Camera* camera) {
         return;
     }
     
-    const auto& entities = scene->getAllEntities();
     Math::Matrix4x4 view = camera->getViewMatrix();
     
-    for (const auto& entityPtr : entities) {
-        Entity* entity = entityPtr.get();
-        if (!entity || !entity->isActiveInHierarchy()) {
+    m_lightPositionsScratch.clear();
+    m_lightDirectionsScratch.clear();
+    for (const auto& lightProxy : scene->getRenderWorld().getLights()) {
+        Entity* entity = lightProxy.entity;
+        if (!entity->isActiveInHierarchy()) {
             continue;
         }
         
-        Light* light = entity->getComponent<Light>();
-        if (!light) {
-            continue;
-        }
+        Light* light = lightProxy.light;
         Transform* transform = entity->getTransform();
         PreparedLight prepared;
         prepared.light = light;
         prepared.positionWS = transform->getPosition();
         prepared.directionWS = transform->forward();
-        prepared.positionVS = view.transformPoint(prepared.positionWS);
-        prepared.directionVS = view.transformDirection(prepared.directionWS).normalized();
         prepared.range = light->getRange();
         prepared.shadowStart = UINT32_MAX;
         prepared.shadowCount = 0;
         
         m_preparedLights.push_back(prepared);
+        m_lightPositionsScratch.push_back(prepared.positionWS);
+        m_lightDirectionsScratch.push_back(prepared.directionWS);
+    }
+
+    // View-space transforms for every light in one batch.
+    const size_t lightCount = m_preparedLights.size();
+    view.transformPointsAffine(m_lightPositionsScratch.data(), m_lightPositionsScratch.data(), lightCount);
+    view.transformDirections(m_lightDirectionsScratch.data(), m_lightDirectionsScratch.data(), lightCount);
+    for (size_t i = 0; i < lightCount; ++i) {
+        PreparedLight& prepared = m_preparedLights[i];
+        prepared.positionVS = m_lightPositionsScratch[i];
+        prepared.directionVS = m_lightDirectionsScratch[i].normalized();
         
-        if (light->getCastShadows() && light->getType() == Light::Type::Directional) {
+        if (prepared.light->getCastShadows() && prepared.light->getType() == Light::Type::Directional) {
             buildDirectionalCascades(prepared, camera);
         }
     }
@@ -259,6 +570,12 @@ void LightingSystem::buildDirectionalCascades(const PreparedLight& light, Camera
 
         uint32_t cascadeRes = ComputeCascadeResolution(lightResolution, atlasResolution, cascadeCount, cascadeIdx);
 
+        if (light.light->getShadowPageCache() && cascadeRes % kShadowPagesPerAxis == 0) {
+            buildPagedCascade(light, cascadeIdx, cascadeRes, center, radius, up, cascadeNear, cascadeFar);
+            prevSplit = split;
+            continue;
+        }
+
         float lightDistance = radius + 5.0f;
         Math::Vector3 lightPos = center - lightDir * lightDistance;
         Math::Matrix4x4 view = Math::Matrix4x4::LookAt(lightPos, center, up);
@@ -329,7 +646,65 @@ void LightingSystem::buildDirectionalCascades(const PreparedLight& light, Camera
     }
 }
 
-void LightingSystem::allocateShadows() {
+void LightingSystem::buildPagedCascade(const PreparedLight& light,
+                                       uint8_t cascadeIdx,
+                                       uint32_t cascadeRes,
+                                       const Math::Vector3& center,
+                                       float radius,
+                                       const Math::Vector3& up,
+                                       float cascadeNear,
+                                       float cascadeFar) {
+    const Math::Vector3 lightDir = light.directionWS.normalized();
+    const float pageCount = static_cast<float>(kShadowPagesPerAxis);
+
+    // The snapped center strays up to half a page from the slice center, so widen the extent by
+    // that much: extent = radius * 1.03 + extent / pageCount.
+    const float stableExtent = std::max(radius, 0.1f);
+    const float orthoExtent = stableExtent * 1.03f / (1.0f - 1.0f / pageCount);
+    const float pageWorldSize = (orthoExtent * 2.0f) / pageCount;
+    const float depthQuant = std::max(1.0f, stableExtent * 0.5f);
+
+    // Snap in a rotation-only light basis so page coordinates are absolute: a world point keeps
+    // its page (and depth) while the camera moves, and only pages scrolling in need rendering.
+    Math::Matrix4x4 basis = Math::Matrix4x4::LookAt(Math::Vector3::Zero, lightDir, up);
+    Math::Vector3 centerLS = basis.transformPoint(center);
+    const int32_t pageX = static_cast<int32_t>(std::round(centerLS.x / pageWorldSize));
+    const int32_t pageY = static_cast<int32_t>(std::round(centerLS.y / pageWorldSize));
+    const int32_t depthIndex = static_cast<int32_t>(std::round(centerLS.z / depthQuant));
+    Math::Vector3 snappedLS(pageX * pageWorldSize, pageY * pageWorldSize, depthIndex * depthQuant);
+    Math::Vector3 snappedCenter = basis.inversed().transformPoint(snappedLS);
+
+    // Depth is fixed relative to the snapped center instead of fitted to the slice corners.
+    const float casterPadding = std::max(8.0f, stableExtent * 0.85f);
+    const float receiverPadding = std::max(3.0f, stableExtent * 0.35f);
+    const float lightDistance = radius + depthQuant * 0.5f + casterPadding;
+    const float lightNear = 0.01f;
+    const float lightFar = lightDistance + radius + depthQuant * 0.5f + receiverPadding;
+    Math::Vector3 lightPos = snappedCenter - lightDir * lightDistance;
+    Math::Matrix4x4 view = Math::Matrix4x4::LookAt(lightPos, snappedCenter, up);
+    Math::Matrix4x4 proj = Math::Matrix4x4::Orthographic(-orthoExtent, orthoExtent, -orthoExtent, orthoExtent,
+                                                         lightNear, lightFar);
+
+    CascadedSlice slice;
+    slice.view = view;
+    slice.proj = proj;
+    slice.viewProj = proj * view;
+    slice.owner = light.light;
+    slice.cascadeIndex = cascadeIdx;
+    slice.resolution = cascadeRes;
+    slice.texelWorldSize = (orthoExtent * 2.0f) / static_cast<float>(cascadeRes);
+    slice.depthSpan = lightFar - lightNear;
+    slice.splitNear = cascadeNear;
+    slice.splitFar = cascadeFar;
+    slice.pageCount = kShadowPagesPerAxis;
+    // Light-space +y is the top of the tile, so texture rows run along -y.
+    slice.pageOriginX = pageX - static_cast<int32_t>(kShadowPagesPerAxis / 2);
+    slice.pageOriginY = -pageY - static_cast<int32_t>(kShadowPagesPerAxis / 2);
+    slice.pageDepthOrigin = depthIndex;
+    m_cascades.push_back(slice);
+}
+
+void LightingSystem::allocateShadows(Camera* camera) {
     const Light* primaryDirectional = nullptr;
     for (const auto& prepared : m_preparedLights) {
         if (prepared.light && prepared.light->getType() == Light::Type::Directional && prepared.light->getCastShadows()) {
@@ -344,14 +719,76 @@ void LightingSystem::allocateShadows() {
     const float biasScale = 1.0f;
     const float normalBiasScale = 1.5f;
 
+    // Atlas requests: cascades outrank every local light, which rank by screen coverage.
+    std::vector<ShadowAtlasRequest> atlasRequests;
+    atlasRequests.reserve(m_cascades.size() + m_preparedLights.size());
+    for (const auto& slice : m_cascades) {
+        ShadowAtlasRequest request;
+        request.key = ShadowAtlas::MakeKey(slice.owner, slice.cascadeIndex + 1u);
+        request.size = std::max(256u, std::min<uint32_t>(8192u, slice.resolution));
+        request.importance = 16.0f - static_cast<float>(slice.cascadeIndex);
+        atlasRequests.push_back(request);
+    }
+    std::vector<uint32_t> localRequests(m_preparedLights.size(), UINT32_MAX);
+    for (size_t i = 0; i < m_preparedLights.size(); ++i) {
+        const Light* light = m_preparedLights[i].light;
+        if (!light || !light->getCastShadows() ||
+            light->getType() == Light::Type::Directional || light->getType() == Light::Type::Point) {
+            continue;
+        }
+        float coverage = ComputeShadowScreenCoverage(m_preparedLights[i].positionWS, light->getRange(), camera);
+        ShadowAtlasRequest request;
+        request.key = ShadowAtlas::MakeKey(light, 0);
+        request.size = ResolveLocalShadowResolution(light->getShadowMapResolution(),
+                                                    coverage,
+                                                    m_shadowAtlas.getTileSize(request.key));
+        request.importance = coverage;
+        localRequests[i] = static_cast<uint32_t>(atlasRequests.size());
+        atlasRequests.push_back(request);
+    }
+    m_shadowAtlas.allocate(atlasRequests, m_shadowUpdateFrame);
+
     // Directional cascades
-    for (auto& slice : m_cascades) {
-        uint32_t res = std::max(256u, std::min<uint32_t>(8192u, slice.resolution));
-        slice.atlas = m_shadowAtlas.allocate(res);
+    for (size_t i = 0; i < m_cascades.size(); ++i) {
+        CascadedSlice& slice = m_cascades[i];
+        slice.atlas = atlasRequests[i].tile;
+        if (slice.atlas.valid && slice.atlas.size < atlasRequests[i].size) {
+            // Downgraded under atlas pressure: same coverage, coarser texels.
+            slice.texelWorldSize *= static_cast<float>(atlasRequests[i].size) / static_cast<float>(slice.atlas.size);
+            slice.resolution = slice.atlas.size;
+        }
+    }
+
+    m_shadowUpdateCandidates.clear();
+    for (size_t i = 0; i < m_cascades.size(); ++i) {
+        CascadedSlice& slice = m_cascades[i];
+        slice.updateInterval = m_cascadeUpdateIntervals[std::min<uint8_t>(slice.cascadeIndex, 3)];
+        if (!slice.atlas.valid) {
+            continue;
+        }
+        ShadowUpdateCandidate candidate;
+        candidate.key = ShadowAtlas::MakeKey(slice.owner, slice.cascadeIndex + 1u);
+        candidate.signature = HashShadowInput(HashShadowInput(kShadowInputSeed, slice.atlas.size), slice.pageCount);
+        candidate.interval = slice.updateInterval;
+        candidate.index = static_cast<uint32_t>(i);
+        candidate.cascade = true;
+        m_shadowUpdateCandidates.push_back(candidate);
     }
     
+    auto addLocalUpdateCandidate = [&](size_t lightIndex, uint64_t signature) {
+        PreparedLight& prepared = m_preparedLights[lightIndex];
+        prepared.shadowUpdateInterval = prepared.light->getShadowUpdateInterval();
+        ShadowUpdateCandidate candidate;
+        candidate.key = ShadowAtlas::MakeKey(prepared.light, 0);
+        candidate.signature = signature;
+        candidate.interval = prepared.shadowUpdateInterval;
+        candidate.index = static_cast<uint32_t>(lightIndex);
+        m_shadowUpdateCandidates.push_back(candidate);
+    };
+    
     // Per-light shadows
-    for (auto& prepared : m_preparedLights) {
+    for (size_t lightIndex = 0; lightIndex < m_preparedLights.size(); ++lightIndex) {
+        PreparedLight& prepared = m_preparedLights[lightIndex];
         Light* light = prepared.light;
         if (!light || !light->getCastShadows()) {
             continue;
@@ -391,12 +828,19 @@ void LightingSystem::allocateShadows() {
             gpuShadow.atlasUV = Math::Vector4((float)res, 0.0f, 0.0f, 0.0f); // store resolution
             m_gpuShadows.push_back(gpuShadow);
             m_pointCubeCounts[tier]++;
+
+            uint64_t signature = HashShadowInput(kShadowInputSeed, prepared.positionWS);
+            signature = HashShadowInput(signature, Math::Vector3(nearPlane, farPlane, static_cast<float>(res)));
+            addLocalUpdateCandidate(lightIndex, signature);
         } else {
-            const uint32_t resolution = light->getShadowMapResolution();
-            ShadowAtlasTile tile = m_shadowAtlas.allocate(resolution);
+            if (localRequests[lightIndex] == UINT32_MAX) {
+                continue;
+            }
+            const ShadowAtlasTile tile = atlasRequests[localRequests[lightIndex]].tile;
             if (!tile.valid) {
                 continue;
             }
+            const uint32_t resolution = tile.size;
             
             prepared.shadowStart = static_cast<uint32_t>(m_gpuShadows.size());
             prepared.shadowCount = 1;
@@ -467,8 +911,14 @@ void LightingSystem::allocateShadows() {
             }
             
             m_gpuShadows.push_back(gpuShadow);
+
+            uint64_t signature = HashShadowInput(kShadowInputSeed, gpuShadow.viewProj);
+            signature = HashShadowInput(signature, Math::Vector3(gpuShadow.depthRange.x, gpuShadow.depthRange.y, static_cast<float>(tile.size)));
+            addLocalUpdateCandidate(lightIndex, signature);
         }
     }
+
+    scheduleShadowUpdates();
     
     // Append cascade shadow entries after atlas allocation, preserve indices
     std::unordered_map<Light*, std::pair<uint32_t, uint32_t>> directionalShadowRanges;
@@ -521,6 +971,82 @@ void LightingSystem::allocateShadows() {
     }
 }
 
+void LightingSystem::scheduleShadowUpdates() {
+    // Intervals count engine frames, not views: a time-sliced view an earlier view of this frame
+    // refreshed is restored from that refresh instead of being rendered again.
+    const uint64_t frame = m_shadowUpdateFrame;
+
+    // Views that refresh every frame, changed since their last render, or are twice overdue
+    // always refresh; the rest wait for their interval and then share the draw budget.
+    uint64_t spent = 0;
+    m_dueShadowUpdates.clear();
+    for (uint32_t i = 0; i < m_shadowUpdateCandidates.size(); ++i) {
+        ShadowUpdateCandidate& candidate = m_shadowUpdateCandidates[i];
+        ShadowUpdateState& state = m_shadowUpdates[candidate.key];
+        state.lastSeenFrame = frame;
+        candidate.cost = std::max(1u, state.drawCount);
+        const uint64_t age = frame - state.lastRefreshFrame;
+        if (candidate.interval <= 1 || !state.valid || state.signature != candidate.signature ||
+            age >= 2ull * candidate.interval) {
+            candidate.refresh = true;
+            spent += candidate.cost;
+        } else if (age >= candidate.interval) {
+            candidate.refresh = false;
+            candidate.urgency = static_cast<float>(age) / static_cast<float>(candidate.interval);
+            m_dueShadowUpdates.push_back(i);
+        } else {
+            candidate.refresh = false;
+        }
+    }
+    // Most overdue first; at least one due view refreshes each frame so none starves.
+    std::sort(m_dueShadowUpdates.begin(), m_dueShadowUpdates.end(), [&](uint32_t a, uint32_t b) {
+        return m_shadowUpdateCandidates[a].urgency > m_shadowUpdateCandidates[b].urgency;
+    });
+    for (size_t i = 0; i < m_dueShadowUpdates.size(); ++i) {
+        ShadowUpdateCandidate& candidate = m_shadowUpdateCandidates[m_dueShadowUpdates[i]];
+        if (m_shadowDrawBudget == 0 || i == 0 || spent + candidate.cost <= m_shadowDrawBudget) {
+            candidate.refresh = true;
+            spent += candidate.cost;
+        }
+    }
+
+    for (const auto& candidate : m_shadowUpdateCandidates) {
+        ShadowUpdateState& state = m_shadowUpdates[candidate.key];
+        if (candidate.refresh) {
+            state.valid = true;
+            state.signature = candidate.signature;
+            state.lastRefreshFrame = frame;
+            if (candidate.cascade) {
+                state.slice = m_cascades[candidate.index];
+            }
+            continue;
+        }
+        ++m_deferredShadowViews;
+        if (candidate.cascade) {
+            // Sample with the projection the kept depth was rendered with; only the tile moves.
+            CascadedSlice& slice = m_cascades[candidate.index];
+            const ShadowAtlasTile tile = slice.atlas;
+            const uint32_t interval = slice.updateInterval;
+            slice = state.slice;
+            slice.atlas = tile;
+            slice.updateInterval = interval;
+            slice.refresh = false;
+        } else {
+            m_preparedLights[candidate.index].shadowRefresh = false;
+        }
+    }
+
+    // States of the other views of the frame (another scene's lights) survive until a frame passes
+    // without them.
+    for (auto it = m_shadowUpdates.begin(); it != m_shadowUpdates.end();) {
+        if (it->second.lastSeenFrame + 1 < frame) {
+            it = m_shadowUpdates.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 void LightingSystem::fillGPUBuffers() {
     for (const auto& prepared : m_preparedLights) {
         if (!prepared.light) {
@@ -576,6 +1102,8 @@ void LightingSystem::fillGPUBuffers() {
         if (m_bakeDirectLighting && prepared.light->getContributeToStaticBake()) flags |= kLightFlagBakedDirect;
         flags |= (static_cast<uint32_t>(prepared.light->getMobility()) & 0x3u) << kLightMobilityShift;
         flags |= (static_cast<uint32_t>(prepared.light->getShadowmaskChannel() + 1) & 0x7u) << kLightShadowmaskShift;
+        flags |= (static_cast<uint32_t>(prepared.light->getShadowQuality()) & 0x3u) << kLightShadowFilterShift;
+        if (m_shadowDepthBounds) flags |= kLightFlagShadowDepthBounds;
         
         float shadowIdx = prepared.shadowStart == UINT32_MAX ? -1.0f : static_cast<float>(prepared.shadowStart);
         float shadowCount = static_cast<float>(prepared.shadowCount);
@@ -662,31 +1190,7 @@ void LightingSystem::buildLightGizmos(DebugRenderer& debug, bool drawCascades) c
     if (drawCascades) {
         // Draw cascade boxes
         for (const auto& cascade : m_cascades) {
-            Math::Matrix4x4 inv = cascade.viewProj.inversed();
-            std::array<Math::Vector3, 8> corners{};
-            int idx = 0;
-            for (int z = 0; z <= 1; ++z) {
-                for (int y = 0; y <= 1; ++y) {
-                    for (int x = 0; x <= 1; ++x) {
-                        Math::Vector4 clip((float)x * 2.0f - 1.0f, (float)y * 2.0f - 1.0f, (float)z * 2.0f - 1.0f, 1.0f);
-                        Math::Vector4 world = inv * clip;
-                        world.x /= world.w;
-                        world.y /= world.w;
-                        world.z /= world.w;
-                        corners[idx++] = Math::Vector3(world.x, world.y, world.z);
-                    }
-                }
-            }
-            
-            // Draw edges of the frustum box
-            const int edges[12][2] = {
-                {0,1},{1,3},{3,2},{2,0}, // near
-                {4,5},{5,7},{7,6},{6,4}, // far
-                {0,4},{1,5},{2,6},{3,7}  // connect
-            };
-            for (auto& edge : edges) {
-                debug.drawLine(corners[edge[0]], corners[edge[1]], Math::Vector4(0.2f, 0.6f, 1.0f, 1.0f));
-            }
+            debug.drawFrustum(cascade.viewProj, Math::Vector4(0.2f, 0.6f, 1.0f, 1.0f));
         }
     }
     
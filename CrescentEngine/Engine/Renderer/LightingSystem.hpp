@@ -5,6 +5,7 @@
 #include <vector>
 #include <cstdint>
 #include <array>
+#include <unordered_map>
 
 namespace Crescent {
 
@@ -50,6 +51,16 @@ struct CascadedSlice {
     float depthSpan = 0.0f;
     float splitNear = 0.0f;
     float splitFar = 0.0f;
+    // Shadow page cache (Light::getShadowPageCache): pages per axis, 0 when off. The origin is the
+    // light-space page of the tile's top-left corner; depthOrigin moves when the depth snap does.
+    uint32_t pageCount = 0;
+    int32_t pageOriginX = 0;
+    int32_t pageOriginY = 0;
+    int32_t pageDepthOrigin = 0;
+    // Time slicing: frames between refreshes, and whether this frame re-renders the cascade. A
+    // cascade that is not refreshed carries the slice it was last rendered with.
+    uint32_t updateInterval = 1;
+    bool refresh = true;
 };
 
 struct PreparedLight {
@@ -61,44 +72,113 @@ struct PreparedLight {
     float range = 0.0f;
     uint32_t shadowStart = UINT32_MAX;
     uint32_t shadowCount = 0;
+    uint32_t shadowUpdateInterval = 1;
+    bool shadowRefresh = true;
 };
 
-// Simple frame-reset atlas allocator. Easily replaceable with bin-pack.
+struct ShadowAtlasRequest {
+    uint64_t key = 0;         // ShadowAtlas::MakeKey
+    uint32_t size = 0;
+    float importance = 0.0f;  // higher keeps its resolution first when the atlas is full
+    ShadowAtlasTile tile;     // written by ShadowAtlas::allocate
+};
+
+// Persistent quadtree atlas allocator. A key keeps its tile across frames while it asks for the
+// same size, so cached shadow contents stay addressable; keys not requested for a whole frame give
+// their tile back, so the views of one frame (each allocating for its own lights) keep each other's. New tiles are placed in importance order and drop a level at a time when
+// space runs out, moving back up once room frees. When fragmentation rather than free area
+// forced a downgrade, the atlas repacks (at most once per kRepackIntervalFrames).
 class ShadowAtlas {
 public:
+    static constexpr uint32_t kMinTileSize = 128;
+    static constexpr float kRepackFragmentation = 0.5f;
+    static constexpr uint32_t kRepackIntervalFrames = 60;
+
     ShadowAtlas(uint32_t resolution = 4096, uint32_t layers = 1);
     
-    void reset();
-    ShadowAtlasTile allocate(uint32_t size);
+    static uint64_t MakeKey(const Light* light, uint32_t view);
+
+    // frame is the engine frame; every view rendered in it allocates against the same tiles.
+    void allocate(std::vector<ShadowAtlasRequest>& requests, uint64_t frame);
+    // Size of the tile the key held after the last allocate, 0 if none.
+    uint32_t getTileSize(uint64_t key) const;
     uint32_t getResolution() const { return m_resolution; }
     uint32_t getLayerCount() const { return m_layers; }
     const std::vector<ShadowAtlasTile>& getTiles() const { return m_tiles; }
+    // 0 when the free area is one block, approaching 1 as it splinters.
+    float getFragmentation() const;
+    uint32_t getDowngradedCount() const { return m_downgradedCount; }
     
 private:
+    enum class NodeState : uint8_t { Free, Split, Used };
+    struct Allocation {
+        uint32_t node = 0;            // index into m_nodes (layer-major)
+        uint32_t level = 0;
+        uint32_t requestedLevel = 0;  // differs from level while downgraded
+        uint32_t size = 0;
+        uint64_t lastFrame = 0;       // engine frame of the last request
+        bool requested = false;       // by the current allocate() call
+    };
+
+    void clear();
+    uint32_t levelForSize(uint32_t size) const;
+    uint32_t nodeSize(uint32_t level) const { return m_resolution >> level; }
+    bool acquireNode(uint32_t level, uint32_t& outNode);
+    int32_t findNode(uint32_t base, uint32_t local, uint32_t level, uint32_t targetLevel) const;
+    void releaseNode(uint32_t node);
+    ShadowAtlasTile tileForNode(uint32_t node, uint32_t level, uint32_t size) const;
+    uint32_t largestFreeSize() const;
+
     uint32_t m_resolution;
     uint32_t m_layers;
-    uint32_t m_cursorX;
-    uint32_t m_cursorY;
-    uint32_t m_rowHeight;
+    uint32_t m_maxLevel;
+    uint32_t m_nodesPerLayer;
+    uint64_t m_freeArea;
+    bool m_repackPending;
+    uint32_t m_framesSinceRepack;
+    uint64_t m_lastFrame;
+    uint32_t m_downgradedCount;
+    std::vector<NodeState> m_nodes;
+    std::unordered_map<uint64_t, Allocation> m_allocations;
+    std::vector<uint32_t> m_order;
     std::vector<ShadowAtlasTile> m_tiles;
 };
 
 class LightingSystem {
 public:
+    static constexpr uint32_t kShadowPagesPerAxis = 16;
+    static constexpr uint32_t kMaxShadowUpdateInterval = 8;
+
     LightingSystem();
     
     void configureShadowAtlas(uint32_t resolution, uint32_t layers = 1);
+    // Cascade refresh intervals and the caster draws per frame time-sliced views may spend
+    // (0 = unlimited). Views refreshing every frame are never deferred.
+    void setShadowUpdateCadence(const std::array<int, 4>& cascadeIntervals, uint32_t drawBudget);
+    // Caster draws each shadow view issued when it last rendered, keyed by ShadowAtlas::MakeKey
+    // (cascade index + 1 for cascades, 0 for local lights).
+    void setShadowViewDrawCounts(const std::unordered_map<uint64_t, uint32_t>& drawCounts);
+    // Whether the shadow filters may read the atlas depth bounds; flagged on every light so the
+    // main pass falls back to searching texels without them.
+    void setShadowDepthBoundsAvailable(bool available) { m_shadowDepthBounds = available; }
     
-    void beginFrame(Scene* scene, Camera* camera, uint32_t viewportWidth, uint32_t viewportHeight);
+    // frame is the engine frame. Views rendered in the same frame share the shadow atlas and the
+    // time-slicing schedule: neither expires what another view of the frame still uses.
+    void beginFrame(Scene* scene, Camera* camera, uint32_t viewportWidth, uint32_t viewportHeight, uint64_t frame);
     
     // Accessors
     const std::vector<LightGPUData>& getGPULights() const { return m_gpuLights; }
     const std::vector<ShadowGPUData>& getGPUShadows() const { return m_gpuShadows; }
+    // Per-record versions, parallel to getGPULights()/getGPUShadows(). A version changes only when
+    // the record at that slot changed, so uploads can skip records a buffer already holds.
+    const std::vector<uint64_t>& getGPULightVersions() const { return m_gpuLightVersions; }
+    const std::vector<uint64_t>& getGPUShadowVersions() const { return m_gpuShadowVersions; }
     const std::vector<CascadedSlice>& getCascades() const { return m_cascades; }
     const ShadowAtlas& getShadowAtlas() const { return m_shadowAtlas; }
     uint32_t getVisibleLightCount() const { return static_cast<uint32_t>(m_preparedLights.size()); }
     const std::vector<PreparedLight>& getPreparedLights() const { return m_preparedLights; }
     const std::array<uint32_t, 4>& getPointCubeCounts() const { return m_pointCubeCounts; }
+    uint32_t getDeferredShadowViewCount() const { return m_deferredShadowViews; }
     
     // Editor gizmos
     void buildLightGizmos(DebugRenderer& debug, bool drawCascades = true) const;
@@ -108,7 +188,16 @@ public:
 private:
     void gatherLights(Scene* scene, Camera* camera);
     void buildDirectionalCascades(const PreparedLight& light, Camera* camera);
-    void allocateShadows();
+    void buildPagedCascade(const PreparedLight& light,
+                           uint8_t cascadeIdx,
+                           uint32_t cascadeRes,
+                           const Math::Vector3& center,
+                           float radius,
+                           const Math::Vector3& up,
+                           float cascadeNear,
+                           float cascadeFar);
+    void allocateShadows(Camera* camera);
+    void scheduleShadowUpdates();
     void fillGPUBuffers();
     
     // Helpers
@@ -116,18 +205,55 @@ private:
     void drawSpotGizmo(DebugRenderer& debug, const PreparedLight& light) const;
     void drawAreaGizmo(DebugRenderer& debug, const PreparedLight& light) const;
     
+private:
+    struct ShadowUpdateState {
+        CascadedSlice slice;       // cascades: the slice as last rendered
+        uint64_t signature = 0;    // what the view was rendered from; a change forces a refresh
+        uint64_t lastRefreshFrame = 0;
+        uint64_t lastSeenFrame = 0;
+        uint32_t drawCount = 0;
+        bool valid = false;
+    };
+    struct ShadowUpdateCandidate {
+        uint64_t key = 0;
+        uint64_t signature = 0;
+        uint32_t interval = 1;
+        uint32_t index = 0;        // into m_cascades or m_preparedLights
+        bool cascade = false;
+        bool refresh = true;
+        float urgency = 0.0f;
+        uint32_t cost = 0;
+    };
+
 private:
     ShadowAtlas m_shadowAtlas;
     uint32_t m_viewportWidth;
     uint32_t m_viewportHeight;
     bool m_debugDrawAtlas;
     bool m_bakeDirectLighting;
+    bool m_shadowDepthBounds;
     std::array<uint32_t, 4> m_pointCubeCounts;
     
     std::vector<PreparedLight> m_preparedLights;
     std::vector<CascadedSlice> m_cascades;
     std::vector<LightGPUData> m_gpuLights;
     std::vector<ShadowGPUData> m_gpuShadows;
+    // Last frame's records and the version of every slot.
+    std::vector<LightGPUData> m_lastGpuLights;
+    std::vector<ShadowGPUData> m_lastGpuShadows;
+    std::vector<uint64_t> m_gpuLightVersions;
+    std::vector<uint64_t> m_gpuShadowVersions;
+    uint64_t m_recordVersionCounter = 0;
+    std::vector<Math::Vector3> m_lightPositionsScratch;
+    std::vector<Math::Vector3> m_lightDirectionsScratch;
+
+    std::array<uint32_t, 4> m_cascadeUpdateIntervals;
+    uint32_t m_shadowDrawBudget;
+    uint64_t m_shadowUpdateFrame;   // engine frame passed to beginFrame
+    uint32_t m_deferredShadowViews;
+    std::unordered_map<uint64_t, ShadowUpdateState> m_shadowUpdates;
+    std::vector<ShadowUpdateCandidate> m_shadowUpdateCandidates;
+    std::vector<uint32_t> m_dueShadowUpdates;
 };
 
 } // namespace Crescent
@@ -0,0 +1,116 @@
+#include "MaterialTable.hpp"
+#include "SceneResidency.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace Crescent {
+
+namespace {
+    constexpr uint32_t kMinEntries = 64;
+}
+
+MaterialTable::MaterialTable()
+    : m_device(nullptr)
+    , m_frameSlot(0) {
+}
+
+MaterialTable::~MaterialTable() {
+    shutdown();
+}
+
+bool MaterialTable::initialize(MTL::Device* device) {
+    if (!device || !device->supportsFamily(MTL::GPUFamilyMetal3)) {
+        return false;
+    }
+    m_device = device;
+    return true;
+}
+
+void MaterialTable::shutdown() {
+    for (Slot& slot : m_slots) {
+        if (slot.buffer) { slot.buffer->release(); slot.buffer = nullptr; }
+        slot.capacity = 0;
+        slot.count = 0;
+        slot.lookup.clear();
+        slot.residentSet.clear();
+        slot.resident.clear();
+    }
+    m_device = nullptr;
+}
+
+void MaterialTable::beginFrame(uint32_t frameSlot) {
+    m_frameSlot = frameSlot % kMaxFramesInFlight;
+    Slot& slot = m_slots[m_frameSlot];
+    slot.count = 0;
+    slot.lookup.clear();
+    slot.residentSet.clear();
+    slot.resident.clear();
+}
+
+uint32_t MaterialTable::find(uint64_t key) const {
+    const Slot& slot = m_slots[m_frameSlot];
+    auto it = slot.lookup.find(key);
+    return it != slot.lookup.end() ? it->second : kInvalidEntry;
+}
+
+bool MaterialTable::reserve(Slot& slot, uint32_t entries) {
+    if (entries <= slot.capacity && slot.buffer) {
+        return true;
+    }
+    uint32_t capacity = std::max(slot.capacity, kMinEntries);
+    while (capacity < entries) {
+        capacity *= 2;
+    }
+    MTL::Buffer* buffer = m_device->newBuffer(static_cast<size_t>(capacity) * kEntryStride,
+                                              MTL::ResourceStorageModeShared);
+    if (!buffer) {
+        return false;
+    }
+    // Nothing is encoded against this frame's entries until they are all added, so moving them
+    // is safe; the old buffer's previous frame has completed (see beginFrame).
+    if (slot.buffer) {
+        std::memcpy(buffer->contents(), slot.buffer->contents(), static_cast<size_t>(slot.count) * kEntryStride);
+        slot.buffer->release();
+    }
+    slot.buffer = buffer;
+    slot.capacity = capacity;
+    return true;
+}
+
+uint32_t MaterialTable::add(uint64_t key, const void* uniforms, size_t uniformBytes, const Textures& textures) {
+    if (!m_device || uniformBytes > kUniformBytes) {
+        return kInvalidEntry;
+    }
+    Slot& slot = m_slots[m_frameSlot];
+    if (!reserve(slot, slot.count + 1)) {
+        return kInvalidEntry;
+    }
+    const uint32_t entry = slot.count++;
+    auto* bytes = static_cast<uint8_t*>(slot.buffer->contents()) + EntryOffset(entry);
+    std::memcpy(bytes, uniforms, uniformBytes);
+    auto* handles = reinterpret_cast<MTL::ResourceID*>(bytes + kTextureOffset);
+    for (size_t i = 0; i < kTextureCount; ++i) {
+        MTL::Texture* texture = textures[i];
+        handles[i] = texture ? texture->gpuResourceID() : MTL::ResourceID{0};
+        if (texture && slot.residentSet.insert(texture).second) {
+            slot.resident.push_back(texture);
+            if (m_residency) {
+                m_residency->use(texture);
+            }
+        }
+    }
+    slot.lookup.emplace(key, entry);
+    return entry;
+}
+
+void MaterialTable::makeResident(MTL::RenderCommandEncoder* encoder) const {
+    const Slot& slot = m_slots[m_frameSlot];
+    if (!encoder || slot.resident.empty() || m_residency) {
+        return;
+    }
+    encoder->useResources(slot.resident.data(), slot.resident.size(), MTL::ResourceUsageRead,
+                          MTL::RenderStageFragment);
+}
+
+} // namespace Crescent
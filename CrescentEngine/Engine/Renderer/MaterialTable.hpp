@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class Buffer;
+    class Resource;
+    class Texture;
+    class RenderCommandEncoder;
+}
+
+namespace Crescent {
+
+class SceneResidency;
+
+// Per-frame material table of the main pass. Each entry holds a material's uniforms followed by an
+// argument buffer of its texture handles (MaterialTextures in PBR.metal), so a main pass draw binds
+// an entry offset instead of its uniforms and every material texture. Entries are rebuilt each
+// frame in the frame slot's buffer; the textures they reference are only reachable through the
+// handles, so every encoder that draws with the table calls makeResident() first. With a scene
+// residency set the textures are marked resident as entries are added and makeResident() is free.
+class MaterialTable {
+public:
+    static constexpr uint32_t kMaxFramesInFlight = 4;
+    static constexpr uint32_t kInvalidEntry = 0xFFFFFFFFu;
+    // albedo, normal, metallic, roughness, AO, emission, height, ORM, terrain control, then the
+    // three terrain layers' albedo, normal and ORM maps.
+    static constexpr size_t kTextureCount = 18;
+    // Both halves of an entry are bound as constant buffers, so they start on 256-byte boundaries.
+    static constexpr size_t kUniformBytes = 512;
+    static constexpr size_t kTextureOffset = kUniformBytes;
+    static constexpr size_t kEntryStride = 768;
+
+    using Textures = std::array<MTL::Texture*, kTextureCount>;
+
+    MaterialTable();
+    ~MaterialTable();
+
+    // Texture handles are written with gpuResourceID(), which needs a Metal 3 device.
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_device != nullptr; }
+
+    // Drops the entries of the slot's previous use; its command buffer must have completed.
+    void beginFrame(uint32_t frameSlot);
+    uint32_t find(uint64_t key) const;
+    // Appends an entry; uniformBytes must not exceed kUniformBytes. Null textures read as unbound.
+    uint32_t add(uint64_t key, const void* uniforms, size_t uniformBytes, const Textures& textures);
+
+    // Valid once the frame's entries are added; adding may reallocate it.
+    MTL::Buffer* getBuffer() const { return m_slots[m_frameSlot].buffer; }
+    static size_t EntryOffset(uint32_t entry) { return static_cast<size_t>(entry) * kEntryStride; }
+    static size_t TextureOffset(uint32_t entry) { return EntryOffset(entry) + kTextureOffset; }
+
+    void setResidency(SceneResidency* residency) { m_residency = residency; }
+    void makeResident(MTL::RenderCommandEncoder* encoder) const;
+    size_t getEntryCount() const { return m_slots[m_frameSlot].count; }
+
+private:
+    struct Slot {
+        MTL::Buffer* buffer = nullptr;
+        uint32_t capacity = 0;
+        uint32_t count = 0;
+        std::unordered_map<uint64_t, uint32_t> lookup;
+        std::unordered_set<const MTL::Texture*> residentSet;
+        std::vector<const MTL::Resource*> resident;
+    };
+
+    bool reserve(Slot& slot, uint32_t entries);
+
+    MTL::Device* m_device;
+    SceneResidency* m_residency = nullptr;
+    std::array<Slot, kMaxFramesInFlight> m_slots;
+    uint32_t m_frameSlot;
+};
+
+} // namespace Crescent
@@ -0,0 +1,133 @@
+#include "ParallelPassEncoder.hpp"
+#include "../Core/JobScheduler.hpp"
+#include "../ECS/RenderSnapshot.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <array>
+
+namespace Crescent {
+
+ParallelPassEncoder::ParallelPassEncoder(MTL::CommandBuffer* commandBuffer,
+                                         MTL::RenderPassDescriptor* descriptor,
+                                         size_t drawCount,
+                                         SetupFn setup)
+    : m_setup(std::move(setup)) {
+    if (!commandBuffer || !descriptor) {
+        return;
+    }
+    JobScheduler& scheduler = JobScheduler::getInstance();
+    const size_t workers = scheduler.isRunning() ? scheduler.workerCount() : 0;
+    m_maxChunks = std::min(kMaxChunks, workers + 1);
+    if (workers > 0 && drawCount >= kMinParallelDraws) {
+        m_parallel = commandBuffer->parallelRenderCommandEncoder(descriptor);
+    }
+    if (!m_parallel) {
+        m_serial = commandBuffer->renderCommandEncoder(descriptor);
+        if (m_serial && m_setup) {
+            m_setup(m_serial);
+        }
+    }
+}
+
+ParallelPassEncoder::~ParallelPassEncoder() {
+    end();
+}
+
+MTL::RenderCommandEncoder* ParallelPassEncoder::openSubEncoder() {
+    MTL::RenderCommandEncoder* sub = m_parallel->renderCommandEncoder();
+    if (sub && m_setup) {
+        m_setup(sub);
+    }
+    return sub;
+}
+
+void ParallelPassEncoder::closeCurrent() {
+    if (m_current) {
+        m_current->endEncoding();
+        m_current = nullptr;
+    }
+}
+
+MTL::RenderCommandEncoder* ParallelPassEncoder::encoder() {
+    if (m_serial) {
+        return m_serial;
+    }
+    if (!m_parallel) {
+        return nullptr;
+    }
+    if (!m_current) {
+        m_current = openSubEncoder();
+    }
+    return m_current;
+}
+
+void ParallelPassEncoder::encodeRange(size_t count, const RangeFn& body) {
+    if (count == 0 || !body || m_ended) {
+        return;
+    }
+    if (!m_parallel) {
+        if (m_serial) {
+            body(m_serial, 0, count);
+        }
+        return;
+    }
+
+    // Work recorded before the range has to execute before it, so its sub-encoder is closed
+    // and the chunk encoders are created after it.
+    closeCurrent();
+
+    const size_t chunks = std::max<size_t>(1, std::min(m_maxChunks, count / kMinDrawsPerChunk));
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+    std::array<MTL::RenderCommandEncoder*, kMaxChunks> encoders{};
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        encoders[chunk] = m_parallel->renderCommandEncoder();
+    }
+
+    if (!m_fence) {
+        m_fence = std::make_shared<JobFence>();
+    }
+    JobScheduler& scheduler = JobScheduler::getInstance();
+    // Workers read the same published render state as the thread that opened the pass.
+    const bool readingSnapshot = RenderSnapshot::isReading();
+    auto runChunk = [this, &body, readingSnapshot](MTL::RenderCommandEncoder* sub, size_t begin, size_t end) {
+        if (!sub) {
+            return;
+        }
+        RenderSnapshot::ReadScope readScope(readingSnapshot);
+        if (m_setup) {
+            m_setup(sub);
+        }
+        body(sub, begin, end);
+        sub->endEncoding();
+    };
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        const size_t begin = chunk * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        MTL::RenderCommandEncoder* sub = encoders[chunk];
+        m_fence->remaining.fetch_add(1, std::memory_order_relaxed);
+        scheduler.schedule([&runChunk, sub, begin, end]() { runChunk(sub, begin, end); }, m_fence);
+    }
+    runChunk(encoders[0], 0, std::min(count, chunkSize));
+    // Only this range's chunks: a foreign job run from here would execute on top of the render
+    // job's stack, inside its snapshot read, while the other chunks still walk the render world.
+    scheduler.wait(*m_fence, true);
+    m_parallelEncoders += chunks;
+}
+
+void ParallelPassEncoder::end() {
+    if (m_ended) {
+        return;
+    }
+    m_ended = true;
+    closeCurrent();
+    if (m_parallel) {
+        m_parallel->endEncoding();
+        m_parallel = nullptr;
+    }
+    if (m_serial) {
+        m_serial->endEncoding();
+        m_serial = nullptr;
+    }
+}
+
+} // namespace Crescent
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace MTL {
+    class CommandBuffer;
+    class RenderPassDescriptor;
+    class RenderCommandEncoder;
+    class ParallelRenderCommandEncoder;
+}
+
+namespace Crescent {
+
+struct JobFence;
+
+// Encodes one render pass either through a single MTL::RenderCommandEncoder or, when the pass
+// has enough draws, through a MTL::ParallelRenderCommandEncoder whose sub-encoders are filled
+// by the shared JobScheduler. Sub-encoders are created in submission order, so the GPU sees the
+// same draw order as the serial path. Every sub-encoder starts from default state and is
+// initialised by the setup callback before any draw is recorded into it.
+class ParallelPassEncoder {
+public:
+    using SetupFn = std::function<void(MTL::RenderCommandEncoder*)>;
+    using RangeFn = std::function<void(MTL::RenderCommandEncoder*, size_t begin, size_t end)>;
+
+    static constexpr size_t kMinParallelDraws = 256;
+    static constexpr size_t kMinDrawsPerChunk = 64;
+    static constexpr size_t kMaxChunks = 8;
+
+    // drawCount is the size of the largest range the pass will encode; it decides up front
+    // whether the pass is opened as a parallel encoder.
+    ParallelPassEncoder(MTL::CommandBuffer* commandBuffer,
+                        MTL::RenderPassDescriptor* descriptor,
+                        size_t drawCount,
+                        SetupFn setup);
+    ~ParallelPassEncoder();
+    ParallelPassEncoder(const ParallelPassEncoder&) = delete;
+    ParallelPassEncoder& operator=(const ParallelPassEncoder&) = delete;
+
+    bool isValid() const { return m_serial || m_parallel; }
+    bool isParallel() const { return m_parallel != nullptr; }
+
+    // Encoder for serial work recorded between ranges (skybox, instanced batches, debug draws).
+    MTL::RenderCommandEncoder* encoder();
+
+    // Splits [0, count) into contiguous chunks, one sub-encoder each, and runs body over them
+    // on the job workers. Returns once every chunk has been recorded.
+    void encodeRange(size_t count, const RangeFn& body);
+
+    void end();
+
+    // Sub-encoders opened for parallel ranges so far.
+    size_t parallelEncoderCount() const { return m_parallelEncoders; }
+
+private:
+    MTL::RenderCommandEncoder* openSubEncoder();
+    void closeCurrent();
+
+    SetupFn m_setup;
+    MTL::RenderCommandEncoder* m_serial = nullptr;
+    MTL::ParallelRenderCommandEncoder* m_parallel = nullptr;
+    MTL::RenderCommandEncoder* m_current = nullptr;
+    std::shared_ptr<JobFence> m_fence;
+    size_t m_maxChunks = 1;
+    size_t m_parallelEncoders = 0;
+    bool m_ended = false;
+};
+
+} // namespace Crescent
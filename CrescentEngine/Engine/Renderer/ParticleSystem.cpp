@@ -0,0 +1,474 @@
+#include "ParticleSystem.hpp"
+#include "ShaderLibrary.hpp"
+#include "../Components/ParticleEmitter.hpp"
+#include "../ECS/Entity.hpp"
+#include "../Scene/RenderWorld.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    // Match kParticleGroupSize and kParticleSortBlock in Particles.metal.
+    constexpr uint32_t kGroupSize = 64;
+    constexpr uint32_t kSortBlock = 512;
+    constexpr size_t kDispatchArgsBytes = sizeof(uint32_t) * 3;
+    constexpr size_t kDrawArgsOffset = 32;
+    constexpr size_t kIndirectBytes = kDrawArgsOffset + sizeof(uint32_t) * 4;
+    // HZB level of the collision early-out: blocks of 8x8 depth samples.
+    constexpr uint32_t kCollisionHzbMip = 3;
+    // Surfaces are treated as this thick (plus the step's travel) so particles do not tunnel.
+    constexpr float kCollisionThickness = 0.25f;
+    constexpr uint64_t kEvictFrames = 300;
+
+    MTL::ComputePipelineState* NewComputePipeline(MTL::Device* device, MTL::Library* lib, const char* name) {
+        MTL::Function* func = lib->newFunction(NS::String::string(name, NS::UTF8StringEncoding));
+        if (!func) {
+            std::cerr << "ParticleSystem: missing " << name << " shader\n";
+            return nullptr;
+        }
+        NS::Error* error = nullptr;
+        MTL::ComputePipelineState* pipeline = device->newComputePipelineState(func, &error);
+        func->release();
+        if (!pipeline && error) {
+            std::cerr << "ParticleSystem: " << name << " pipeline error "
+                      << error->localizedDescription()->utf8String() << "\n";
+        }
+        return pipeline;
+    }
+
+    void ReleasePipeline(MTL::ComputePipelineState*& pipeline) {
+        if (pipeline) {
+            pipeline->release();
+            pipeline = nullptr;
+        }
+    }
+
+    void ReleaseBuffer(MTL::Buffer*& buffer) {
+        if (buffer) {
+            buffer->release();
+            buffer = nullptr;
+        }
+    }
+
+    uint32_t NextPowerOfTwo(uint32_t value) {
+        uint32_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    uint32_t HashEmitter(uint32_t seed, uint32_t serial) {
+        uint32_t h = seed * 0x9E3779B9u ^ serial * 0x85EBCA6Bu;
+        h ^= h >> 16;
+        h *= 0x7FEB352Du;
+        h ^= h >> 15;
+        return h;
+    }
+
+    uint32_t Groups(uint32_t threads) {
+        return (threads + kGroupSize - 1) / kGroupSize;
+    }
+}
+
+ParticleSystem::~ParticleSystem() {
+    shutdown();
+}
+
+bool ParticleSystem::initialize(MTL::Device* device) {
+    m_Device = device;
+    if (!m_Device) {
+        return false;
+    }
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_Device, ShaderLibrary::Module::Core);
+    if (!lib) {
+        std::cerr << "ParticleSystem: missing default Metal library\n";
+        return false;
+    }
+    m_ResetPipeline = NewComputePipeline(m_Device, lib, "particle_reset");
+    m_BeginPipeline = NewComputePipeline(m_Device, lib, "particle_begin");
+    m_EmitPipeline = NewComputePipeline(m_Device, lib, "particle_emit");
+    m_SimulatePipeline = NewComputePipeline(m_Device, lib, "particle_simulate");
+    m_FinishPipeline = NewComputePipeline(m_Device, lib, "particle_finish");
+    m_SortKeysPipeline = NewComputePipeline(m_Device, lib, "particle_sort_keys");
+    m_SortLocalPipeline = NewComputePipeline(m_Device, lib, "particle_sort_local");
+    m_SortStepPipeline = NewComputePipeline(m_Device, lib, "particle_sort_step");
+    lib->release();
+
+    MTL::SamplerDescriptor* samplerDesc = MTL::SamplerDescriptor::alloc()->init();
+    samplerDesc->setMinFilter(MTL::SamplerMinMagFilterLinear);
+    samplerDesc->setMagFilter(MTL::SamplerMinMagFilterLinear);
+    samplerDesc->setMipFilter(MTL::SamplerMipFilterLinear);
+    samplerDesc->setSAddressMode(MTL::SamplerAddressModeClampToEdge);
+    samplerDesc->setTAddressMode(MTL::SamplerAddressModeClampToEdge);
+    m_Sampler = m_Device->newSamplerState(samplerDesc);
+    samplerDesc->release();
+
+    if (!m_ResetPipeline || !m_BeginPipeline || !m_EmitPipeline || !m_SimulatePipeline || !m_FinishPipeline
+        || !m_SortKeysPipeline || !m_SortLocalPipeline || !m_SortStepPipeline || !m_Sampler) {
+        shutdown();
+        return false;
+    }
+    return true;
+}
+
+void ParticleSystem::shutdown() {
+    for (auto& [emitter, entry] : m_Entries) {
+        releaseEntry(entry);
+    }
+    m_Entries.clear();
+    m_Draws.clear();
+    for (auto& [key, pipeline] : m_RenderPipelines) {
+        if (pipeline) {
+            pipeline->release();
+        }
+    }
+    m_RenderPipelines.clear();
+    ReleasePipeline(m_ResetPipeline);
+    ReleasePipeline(m_BeginPipeline);
+    ReleasePipeline(m_EmitPipeline);
+    ReleasePipeline(m_SimulatePipeline);
+    ReleasePipeline(m_FinishPipeline);
+    ReleasePipeline(m_SortKeysPipeline);
+    ReleasePipeline(m_SortLocalPipeline);
+    ReleasePipeline(m_SortStepPipeline);
+    if (m_Sampler) {
+        m_Sampler->release();
+        m_Sampler = nullptr;
+    }
+    m_Device = nullptr;
+}
+
+void ParticleSystem::releaseEntry(Entry& entry) {
+    ReleaseBuffer(entry.particles);
+    ReleaseBuffer(entry.deadList);
+    ReleaseBuffer(entry.aliveLists);
+    ReleaseBuffer(entry.counters);
+    ReleaseBuffer(entry.indirect);
+    ReleaseBuffer(entry.sortKeys);
+    entry.memory.reset();
+    entry.capacity = 0;
+    entry.sortCount = 0;
+}
+
+bool ParticleSystem::allocate(Entry& entry, uint32_t capacity, bool sorted) {
+    if (entry.capacity != capacity) {
+        releaseEntry(entry);
+        const MTL::ResourceOptions options = MTL::ResourceStorageModePrivate;
+        entry.particles = m_Device->newBuffer(static_cast<size_t>(capacity) * sizeof(ParticleGPU), options);
+        entry.deadList = m_Device->newBuffer(static_cast<size_t>(capacity) * sizeof(uint32_t), options);
+        entry.aliveLists = m_Device->newBuffer(static_cast<size_t>(capacity) * 2 * sizeof(uint32_t), options);
+        entry.counters = m_Device->newBuffer(sizeof(CountersGPU), options);
+        entry.indirect = m_Device->newBuffer(kIndirectBytes, options);
+        if (!entry.particles || !entry.deadList || !entry.aliveLists || !entry.counters || !entry.indirect) {
+            releaseEntry(entry);
+            return false;
+        }
+        entry.capacity = capacity;
+        entry.current = 0;
+        entry.needsReset = true;
+    }
+    // Keys are only kept for alpha-blended emitters, padded to whole sort blocks.
+    const uint32_t sortCount = sorted ? std::max(kSortBlock, NextPowerOfTwo(capacity)) : 0;
+    if (entry.sortCount != sortCount) {
+        ReleaseBuffer(entry.sortKeys);
+        entry.sortCount = 0;
+        if (sortCount > 0) {
+            entry.sortKeys = m_Device->newBuffer(static_cast<size_t>(sortCount) * sizeof(uint32_t) * 2,
+                                                 MTL::ResourceStorageModePrivate);
+            if (!entry.sortKeys) {
+                return false;
+            }
+            entry.sortCount = sortCount;
+        }
+    }
+    entry.memory.reset(MemoryCategory::Instances,
+                       entry.particles->length() + entry.deadList->length() + entry.aliveLists->length()
+                       + entry.counters->length() + entry.indirect->length()
+                       + (entry.sortKeys ? entry.sortKeys->length() : 0));
+    return true;
+}
+
+void ParticleSystem::update(MTL::CommandBuffer* commandBuffer, const std::vector<ParticleRenderProxy>& proxies,
+                            const ViewInputs& inputs) {
+    m_Draws.clear();
+    m_CameraUniforms = inputs.cameraUniforms;
+    m_EmittersSimulated = 0;
+    m_Capacity = 0;
+    for (auto it = m_Entries.begin(); it != m_Entries.end();) {
+        if (it->second.lastUsedFrame + kEvictFrames < inputs.frame) {
+            releaseEntry(it->second);
+            it = m_Entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (!commandBuffer || !inputs.cameraUniforms || inputs.budget == 0 || proxies.empty()) {
+        return;
+    }
+
+    uint64_t requested = 0;
+    for (const ParticleRenderProxy& proxy : proxies) {
+        if (proxy.entity->isActiveInHierarchy() && proxy.emitter->isEnabled()) {
+            requested += proxy.emitter->getMaxParticles();
+        }
+    }
+    if (requested == 0) {
+        return;
+    }
+    // Every pool gets the same share of the budget, so adding an emitter only shrinks the others
+    // once the scene is over it.
+    const double share = std::min(1.0, static_cast<double>(inputs.budget) / static_cast<double>(requested));
+
+    const bool collisionInputs = inputs.collision && inputs.sceneDepth
+        && inputs.viewportWidth > 0.0f && inputs.viewportHeight > 0.0f;
+    const bool useHzb = collisionInputs && inputs.hzb && inputs.hzbMipCount > 0;
+    const float hzbMip = useHzb ? static_cast<float>(std::min(kCollisionHzbMip, inputs.hzbMipCount - 1)) : 0.0f;
+
+    MTL::ComputeCommandEncoder* encoder = nullptr;
+    for (const ParticleRenderProxy& proxy : proxies) {
+        ParticleEmitter* emitter = proxy.emitter;
+        if (!proxy.entity->isActiveInHierarchy() || !emitter->isEnabled()) {
+            continue;
+        }
+        const uint32_t capacity = std::max(1u, static_cast<uint32_t>(emitter->getMaxParticles() * share));
+        const bool sorted = emitter->getBlendMode() == ParticleEmitter::BlendMode::Alpha;
+        Entry& entry = m_Entries[emitter];
+        entry.lastUsedFrame = inputs.frame;
+        if (!allocate(entry, capacity, sorted)) {
+            std::cerr << "[Particles] Could not allocate " << capacity << " particles for "
+                      << proxy.entity->getName() << "\n";
+            releaseEntry(entry);
+            continue;
+        }
+        m_Capacity += entry.capacity;
+        if (emitter->getClearVersion() != entry.clearVersion) {
+            entry.clearVersion = emitter->getClearVersion();
+            entry.needsReset = true;
+        }
+
+        SimParamsGPU params{};
+        params.capacity = entry.capacity;
+        params.sortCount = entry.sortCount;
+        if (!encoder) {
+            encoder = commandBuffer->computeCommandEncoder();
+        }
+
+        const bool simulate = entry.lastSimulatedFrame != inputs.frame || entry.needsReset;
+        if (entry.needsReset) {
+            encoder->setComputePipelineState(m_ResetPipeline);
+            encoder->setBuffer(entry.counters, 0, 0);
+            encoder->setBuffer(entry.deadList, 0, 1);
+            encoder->setBytes(&params, sizeof(SimParamsGPU), 2);
+            encoder->dispatchThreadgroups(MTL::Size(Groups(entry.capacity), 1, 1), MTL::Size(kGroupSize, 1, 1));
+            entry.needsReset = false;
+            entry.current = 0;
+            entry.emitCarry = 0.0f;
+        }
+
+        if (simulate) {
+            entry.lastSimulatedFrame = inputs.frame;
+            const float dt = std::max(0.0f, inputs.deltaTime);
+            float emitCount = 0.0f;
+            if (emitter->isEmitting()) {
+                entry.emitCarry += emitter->getEmissionRate() * dt;
+                emitCount = std::floor(entry.emitCarry);
+                entry.emitCarry -= emitCount;
+            } else {
+                entry.emitCarry = 0.0f;
+            }
+            uint64_t emitRequest = static_cast<uint64_t>(emitCount);
+            if (emitter->getBurstVersion() != entry.burstVersion) {
+                entry.burstVersion = emitter->getBurstVersion();
+                emitRequest += emitter->getBurstCount();
+            }
+
+            const float cosCone = std::cos(emitter->getConeAngle() * 0.5f * (Math::PI / 180.0f));
+            const Math::Vector3 gravity = emitter->getGravity();
+            params.emitterToWorld = proxy.entity->getTransform()->getWorldMatrix();
+            params.lifetimeSpeed = Math::Vector4(emitter->getMinLifetime(), emitter->getMaxLifetime(),
+                                                 emitter->getMinSpeed(), emitter->getMaxSpeed());
+            params.shape = Math::Vector4(static_cast<float>(emitter->getShape()), emitter->getShapeRadius(), cosCone, 0.0f);
+            params.gravityDrag = Math::Vector4(gravity.x, gravity.y, gravity.z, emitter->getDrag());
+            const bool collide = collisionInputs && emitter->getCollision();
+            params.collision = Math::Vector4(emitter->getBounce(), emitter->getCollisionLifetimeLoss(),
+                                             kCollisionThickness + 0.5f * emitter->getStartSize(), collide ? 1.0f : 0.0f);
+            params.viewport = Math::Vector4(inputs.viewportWidth, inputs.viewportHeight, hzbMip, useHzb ? 1.0f : 0.0f);
+            params.deltaTime = dt;
+            params.emitRequest = static_cast<uint32_t>(std::min<uint64_t>(emitRequest, entry.capacity));
+            params.current = entry.current;
+            params.seed = HashEmitter(emitter->getSeed(), entry.emitSerial++);
+
+            encoder->setBuffer(entry.counters, 0, 0);
+            encoder->setBytes(&params, sizeof(SimParamsGPU), 2);
+            encoder->setComputePipelineState(m_BeginPipeline);
+            encoder->setBuffer(entry.indirect, 0, 1);
+            encoder->dispatchThreadgroups(MTL::Size(1, 1, 1), MTL::Size(1, 1, 1));
+
+            encoder->setBuffer(entry.deadList, 0, 1);
+            encoder->setBuffer(entry.particles, 0, 3);
+            encoder->setBuffer(entry.aliveLists, 0, 4);
+            encoder->setComputePipelineState(m_EmitPipeline);
+            encoder->dispatchThreadgroups(entry.indirect, 0, MTL::Size(kGroupSize, 1, 1));
+
+            encoder->setComputePipelineState(m_SimulatePipeline);
+            encoder->setBuffer(inputs.cameraUniforms, 0, 5);
+            if (collide) {
+                encoder->setTexture(inputs.sceneDepth, 0);
+                encoder->setTexture(useHzb ? inputs.hzb : nullptr, 1);
+            }
+            encoder->dispatchThreadgroups(entry.indirect, kDispatchArgsBytes, MTL::Size(kGroupSize, 1, 1));
+
+            encoder->setComputePipelineState(m_FinishPipeline);
+            encoder->setBuffer(entry.indirect, kDrawArgsOffset, 1);
+            encoder->dispatchThreadgroups(MTL::Size(1, 1, 1), MTL::Size(1, 1, 1));
+            entry.current = 1 - entry.current;
+            ++m_EmittersSimulated;
+        }
+
+        // Survivors are in the list the next simulation reads.
+        const uint32_t drawList = entry.current;
+        if (sorted && entry.sortKeys) {
+            params.current = 1 - drawList;
+            encoder->setComputePipelineState(m_SortKeysPipeline);
+            encoder->setBuffer(entry.counters, 0, 0);
+            encoder->setBuffer(entry.sortKeys, 0, 1);
+            encoder->setBytes(&params, sizeof(SimParamsGPU), 2);
+            encoder->setBuffer(entry.particles, 0, 3);
+            encoder->setBuffer(entry.aliveLists, 0, 4);
+            encoder->setBuffer(inputs.cameraUniforms, 0, 5);
+            encoder->dispatchThreadgroups(MTL::Size(Groups(entry.sortCount), 1, 1), MTL::Size(kGroupSize, 1, 1));
+
+            const uint32_t blocks = entry.sortCount / kSortBlock;
+            SortParamsGPU sort{0, 0};
+            encoder->setBuffer(entry.sortKeys, 0, 0);
+            encoder->setComputePipelineState(m_SortLocalPipeline);
+            encoder->setBytes(&sort, sizeof(SortParamsGPU), 1);
+            encoder->dispatchThreadgroups(MTL::Size(blocks, 1, 1), MTL::Size(kSortBlock / 2, 1, 1));
+            for (uint32_t k = kSortBlock * 2; k <= entry.sortCount; k <<= 1) {
+                sort.k = k;
+                encoder->setComputePipelineState(m_SortStepPipeline);
+                for (uint32_t j = k / 2; j >= kSortBlock; j >>= 1) {
+                    sort.j = j;
+                    encoder->setBytes(&sort, sizeof(SortParamsGPU), 1);
+                    encoder->dispatchThreadgroups(MTL::Size(Groups(entry.sortCount / 2), 1, 1),
+                                                  MTL::Size(kGroupSize, 1, 1));
+                }
+                encoder->setComputePipelineState(m_SortLocalPipeline);
+                encoder->setBytes(&sort, sizeof(SortParamsGPU), 1);
+                encoder->dispatchThreadgroups(MTL::Size(blocks, 1, 1), MTL::Size(kSortBlock / 2, 1, 1));
+            }
+        }
+
+        Draw draw;
+        draw.entry = &entry;
+        const std::shared_ptr<Texture2D>& texture = emitter->getTexture();
+        draw.texture = texture ? texture->getHandle() : nullptr;
+        draw.additive = !sorted;
+        const float intensity = emitter->getIntensity();
+        const Math::Vector4& start = emitter->getStartColor();
+        const Math::Vector4& end = emitter->getEndColor();
+        draw.params.startColor = Math::Vector4(start.x * intensity, start.y * intensity, start.z * intensity, start.w);
+        draw.params.endColor = Math::Vector4(end.x * intensity, end.y * intensity, end.z * intensity, end.w);
+        draw.params.sizeFlags = Math::Vector4(emitter->getStartSize(), emitter->getEndSize(),
+                                              emitter->isLit() ? 1.0f : 0.0f, draw.texture ? 1.0f : 0.0f);
+        if (sorted && entry.sortKeys) {
+            draw.params.listOffset = 0;
+            draw.params.listStride = 2;
+        } else {
+            draw.params.listOffset = drawList * entry.capacity;
+            draw.params.listStride = 1;
+        }
+        draw.params.additive = draw.additive ? 1u : 0u;
+        m_Draws.push_back(draw);
+    }
+    if (encoder) {
+        encoder->endEncoding();
+    }
+}
+
+MTL::RenderPipelineState* ParticleSystem::getRenderPipeline(uint32_t colorFormat, uint32_t sampleCount, bool additive) {
+    const uint64_t key = (static_cast<uint64_t>(colorFormat) << 16) | (sampleCount << 1) | (additive ? 1u : 0u);
+    auto it = m_RenderPipelines.find(key);
+    if (it != m_RenderPipelines.end()) {
+        return it->second;
+    }
+
+    MTL::RenderPipelineState* pipeline = nullptr;
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_Device, ShaderLibrary::Module::Core);
+    if (lib) {
+        MTL::Function* vertexFunc = lib->newFunction(NS::String::string("particle_vertex", NS::UTF8StringEncoding));
+        MTL::Function* fragmentFunc = lib->newFunction(NS::String::string("particle_fragment", NS::UTF8StringEncoding));
+        if (vertexFunc && fragmentFunc) {
+            MTL::RenderPipelineDescriptor* desc = MTL::RenderPipelineDescriptor::alloc()->init();
+            desc->setVertexFunction(vertexFunc);
+            desc->setFragmentFunction(fragmentFunc);
+            desc->setRasterSampleCount(std::max(1u, sampleCount));
+            desc->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
+            auto color = desc->colorAttachments()->object(0);
+            color->setPixelFormat(static_cast<MTL::PixelFormat>(colorFormat));
+            color->setBlendingEnabled(true);
+            color->setRgbBlendOperation(MTL::BlendOperationAdd);
+            color->setAlphaBlendOperation(MTL::BlendOperationAdd);
+            if (additive) {
+                // The fragment premultiplies, so additive sprites only ever brighten.
+                color->setSourceRGBBlendFactor(MTL::BlendFactorOne);
+                color->setDestinationRGBBlendFactor(MTL::BlendFactorOne);
+                color->setSourceAlphaBlendFactor(MTL::BlendFactorZero);
+                color->setDestinationAlphaBlendFactor(MTL::BlendFactorOne);
+            } else {
+                color->setSourceRGBBlendFactor(MTL::BlendFactorSourceAlpha);
+                color->setDestinationRGBBlendFactor(MTL::BlendFactorOneMinusSourceAlpha);
+                color->setSourceAlphaBlendFactor(MTL::BlendFactorOne);
+                color->setDestinationAlphaBlendFactor(MTL::BlendFactorOneMinusSourceAlpha);
+            }
+            NS::Error* error = nullptr;
+            pipeline = m_Device->newRenderPipelineState(desc, &error);
+            if (!pipeline && error) {
+                std::cerr << "ParticleSystem: render pipeline error " << error->localizedDescription()->utf8String() << "\n";
+            }
+            desc->release();
+        } else {
+            std::cerr << "ParticleSystem: missing particle_vertex or particle_fragment shader\n";
+        }
+        if (vertexFunc) vertexFunc->release();
+        if (fragmentFunc) fragmentFunc->release();
+        lib->release();
+    }
+    // Failures are cached too, so a missing shader is reported once.
+    m_RenderPipelines[key] = pipeline;
+    return pipeline;
+}
+
+void ParticleSystem::draw(MTL::RenderCommandEncoder* encoder, uint32_t colorFormat, uint32_t sampleCount,
+                          MTL::DepthStencilState* depthReadState) {
+    if (!encoder || m_Draws.empty()) {
+        return;
+    }
+    encoder->setDepthStencilState(depthReadState);
+    encoder->setCullMode(MTL::CullModeNone);
+    encoder->setFragmentSamplerState(m_Sampler, 0);
+    encoder->setVertexBuffer(m_CameraUniforms, 0, 2);
+    for (const Draw& draw : m_Draws) {
+        MTL::RenderPipelineState* pipeline = getRenderPipeline(colorFormat, sampleCount, draw.additive);
+        if (!pipeline) {
+            continue;
+        }
+        const Entry& entry = *draw.entry;
+        encoder->setRenderPipelineState(pipeline);
+        encoder->setVertexBuffer(entry.particles, 0, 0);
+        encoder->setVertexBuffer(draw.params.listStride == 2 ? entry.sortKeys : entry.aliveLists, 0, 1);
+        encoder->setVertexBytes(&draw.params, sizeof(DrawParamsGPU), 3);
+        encoder->setFragmentBytes(&draw.params, sizeof(DrawParamsGPU), 10);
+        if (draw.texture) {
+            encoder->setFragmentTexture(draw.texture, 0);
+        }
+        encoder->drawPrimitives(MTL::PrimitiveTypeTriangle, entry.indirect, kDrawArgsOffset);
+    }
+    encoder->setCullMode(MTL::CullModeBack);
+}
+
+} // namespace Crescent
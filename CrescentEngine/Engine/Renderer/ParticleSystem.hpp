@@ -0,0 +1,166 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include "../Math/Math.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class Buffer;
+    class Texture;
+    class CommandBuffer;
+    class ComputePipelineState;
+    class RenderPipelineState;
+    class RenderCommandEncoder;
+    class DepthStencilState;
+    class SamplerState;
+}
+
+namespace Crescent {
+
+class ParticleEmitter;
+struct ParticleRenderProxy;
+
+// GPU simulation and drawing for ParticleEmitter components (Particles.metal). Each emitter keeps a
+// private pool with a dead list and two alive lists; emission, simulation and the draw's instance
+// count all run from GPU-side counters through indirect dispatches and an indirect draw, so nothing
+// is read back. The CPU only decides how many particles to emit this frame. Pools are sized from
+// the emitters' maximum counts, cut proportionally when their sum exceeds the scene's particle
+// budget.
+//
+// An emitter is simulated once per frame, by the first view that draws it, and colliding
+// particles bounce off that view's prepass depth (with the HZB as an early-out). Alpha-blended
+// emitters are sorted back to front for every view with a bitonic sort; additive ones draw in
+// alive-list order.
+class ParticleSystem {
+public:
+    // What update() reads from the view about to draw the emitters.
+    struct ViewInputs {
+        MTL::Buffer* cameraUniforms = nullptr;
+        MTL::Texture* sceneDepth = nullptr; // prepass depth; null disables collision this frame
+        MTL::Texture* hzb = nullptr;        // built from sceneDepth this frame, or null
+        uint32_t hzbMipCount = 0;
+        float viewportWidth = 0.0f;
+        float viewportHeight = 0.0f;
+        uint32_t budget = 0;                // live particles across all emitters
+        bool collision = true;
+        float deltaTime = 0.0f;
+        uint64_t frame = 0;
+    };
+
+    ParticleSystem() = default;
+    ~ParticleSystem();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_SimulatePipeline != nullptr; }
+
+    // Simulates the frame's emitters that have not been simulated yet and sorts the ones to draw
+    // for this view. Encode after the prepass depth and HZB, before the main pass.
+    void update(MTL::CommandBuffer* commandBuffer, const std::vector<ParticleRenderProxy>& proxies,
+                const ViewInputs& inputs);
+    // Draws the emitters updated for this view into the main pass, after its opaque and sorted
+    // blended draws. The pass's shared camera, environment, light and cluster bindings are used as is.
+    void draw(MTL::RenderCommandEncoder* encoder, uint32_t colorFormat, uint32_t sampleCount,
+              MTL::DepthStencilState* depthReadState);
+
+    uint32_t getEmitterCount() const { return static_cast<uint32_t>(m_Draws.size()); }
+    uint32_t getEmittersSimulated() const { return m_EmittersSimulated; }
+    uint32_t getCapacity() const { return m_Capacity; }
+
+private:
+    // Matches Particle in Particles.metal.
+    struct ParticleGPU {
+        Math::Vector4 positionAge;
+        Math::Vector4 velocityLife;
+    };
+    // Matches ParticleCounters in Particles.metal.
+    struct CountersGPU {
+        uint32_t deadCount;
+        uint32_t aliveCount[2];
+        uint32_t emitCount;
+    };
+    // Matches ParticleSimParams in Particles.metal.
+    struct SimParamsGPU {
+        Math::Matrix4x4 emitterToWorld;
+        Math::Vector4 lifetimeSpeed;
+        Math::Vector4 shape;
+        Math::Vector4 gravityDrag;
+        Math::Vector4 collision;
+        Math::Vector4 viewport;
+        float deltaTime;
+        uint32_t capacity;
+        uint32_t emitRequest;
+        uint32_t current;
+        uint32_t seed;
+        uint32_t sortCount;
+        uint32_t _pad0;
+        uint32_t _pad1;
+    };
+    // Matches ParticleSortParams in Particles.metal.
+    struct SortParamsGPU {
+        uint32_t k;
+        uint32_t j;
+    };
+    // Matches ParticleDrawParams in Particles.metal.
+    struct DrawParamsGPU {
+        Math::Vector4 startColor;
+        Math::Vector4 endColor;
+        Math::Vector4 sizeFlags;
+        uint32_t listOffset;
+        uint32_t listStride;
+        uint32_t additive;
+        uint32_t _pad0;
+    };
+    struct Entry {
+        MTL::Buffer* particles = nullptr;
+        MTL::Buffer* deadList = nullptr;
+        MTL::Buffer* aliveLists = nullptr;
+        MTL::Buffer* counters = nullptr;
+        MTL::Buffer* indirect = nullptr; // emit and simulate dispatch arguments, then the draw's
+        MTL::Buffer* sortKeys = nullptr;
+        TrackedMemory memory;
+        uint32_t capacity = 0;
+        uint32_t sortCount = 0;
+        uint32_t current = 0;
+        bool needsReset = true;
+        float emitCarry = 0.0f;
+        uint64_t burstVersion = 0;
+        uint64_t clearVersion = 0;
+        uint32_t emitSerial = 0;
+        uint64_t lastSimulatedFrame = 0;
+        uint64_t lastUsedFrame = 0;
+    };
+    struct Draw {
+        Entry* entry = nullptr;
+        MTL::Texture* texture = nullptr;
+        DrawParamsGPU params;
+        bool additive = false;
+    };
+
+    bool allocate(Entry& entry, uint32_t capacity, bool sorted);
+    void releaseEntry(Entry& entry);
+    MTL::RenderPipelineState* getRenderPipeline(uint32_t colorFormat, uint32_t sampleCount, bool additive);
+
+    MTL::Device* m_Device = nullptr;
+    MTL::ComputePipelineState* m_ResetPipeline = nullptr;
+    MTL::ComputePipelineState* m_BeginPipeline = nullptr;
+    MTL::ComputePipelineState* m_EmitPipeline = nullptr;
+    MTL::ComputePipelineState* m_SimulatePipeline = nullptr;
+    MTL::ComputePipelineState* m_FinishPipeline = nullptr;
+    MTL::ComputePipelineState* m_SortKeysPipeline = nullptr;
+    MTL::ComputePipelineState* m_SortLocalPipeline = nullptr;
+    MTL::ComputePipelineState* m_SortStepPipeline = nullptr;
+    MTL::SamplerState* m_Sampler = nullptr;
+    std::unordered_map<uint64_t, MTL::RenderPipelineState*> m_RenderPipelines;
+    std::unordered_map<const ParticleEmitter*, Entry> m_Entries;
+    std::vector<Draw> m_Draws;
+    MTL::Buffer* m_CameraUniforms = nullptr;
+    uint32_t m_EmittersSimulated = 0;
+    uint32_t m_Capacity = 0;
+};
+
+} // namespace Crescent
@@ -0,0 +1,148 @@
+#include "PipelineArchive.hpp"
+#include <Metal/Metal.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    std::string KeyListPath(const std::string& archivePath) {
+        return archivePath + ".keys";
+    }
+
+    void LogArchiveError(const char* what, NS::Error* error) {
+        std::cerr << "PipelineArchive: " << what;
+        if (error) {
+            std::cerr << ": " << error->localizedDescription()->utf8String();
+        }
+        std::cerr << "\n";
+    }
+}
+
+PipelineArchive& PipelineArchive::getInstance() {
+    // Never destroyed, like GeometryBuffer: the renderer may still release pipelines during exit.
+    static PipelineArchive* instance = new PipelineArchive();
+    return *instance;
+}
+
+bool PipelineArchive::beginRecording(MTL::Device* device) {
+    shutdown();
+    if (!device) {
+        return false;
+    }
+    MTL::BinaryArchiveDescriptor* descriptor = MTL::BinaryArchiveDescriptor::alloc()->init();
+    NS::Error* error = nullptr;
+    m_archive = device->newBinaryArchive(descriptor, &error);
+    descriptor->release();
+    if (!m_archive) {
+        LogArchiveError("failed to create archive", error);
+        return false;
+    }
+    m_recording = true;
+    return true;
+}
+
+bool PipelineArchive::load(MTL::Device* device, const std::string& path) {
+    shutdown();
+    if (!device || path.empty()) {
+        return false;
+    }
+    std::ifstream keyFile(KeyListPath(path));
+    if (!keyFile.is_open()) {
+        std::cerr << "PipelineArchive: missing key list for " << path << "\n";
+        return false;
+    }
+
+    MTL::BinaryArchiveDescriptor* descriptor = MTL::BinaryArchiveDescriptor::alloc()->init();
+    descriptor->setUrl(NS::URL::fileURLWithPath(NS::String::string(path.c_str(), NS::UTF8StringEncoding)));
+    NS::Error* error = nullptr;
+    m_archive = device->newBinaryArchive(descriptor, &error);
+    descriptor->release();
+    if (!m_archive) {
+        LogArchiveError("failed to load archive", error);
+        return false;
+    }
+
+    std::vector<uint32_t> keys;
+    std::string line;
+    while (std::getline(keyFile, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        keys.push_back(static_cast<uint32_t>(std::strtoul(line.c_str(), nullptr, 16)));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_keyMutex);
+        m_keys = std::move(keys);
+    }
+    m_path = path;
+    return true;
+}
+
+bool PipelineArchive::write(const std::string& path) {
+    if (!m_archive || !m_recording || path.empty()) {
+        return false;
+    }
+    NS::Error* error = nullptr;
+    NS::URL* url = NS::URL::fileURLWithPath(NS::String::string(path.c_str(), NS::UTF8StringEncoding));
+    if (!m_archive->serializeToURL(url, &error)) {
+        LogArchiveError("failed to write archive", error);
+        return false;
+    }
+
+    std::ofstream keyFile(KeyListPath(path), std::ios::trunc);
+    if (!keyFile.is_open()) {
+        std::cerr << "PipelineArchive: failed to write key list for " << path << "\n";
+        return false;
+    }
+    for (uint32_t key : getKeys()) {
+        keyFile << std::hex << std::setw(8) << std::setfill('0') << key << "\n";
+    }
+    m_recording = false;
+    m_path = path;
+    return true;
+}
+
+void PipelineArchive::shutdown() {
+    if (m_archive) {
+        m_archive->release();
+        m_archive = nullptr;
+    }
+    m_recording = false;
+    m_path.clear();
+    std::lock_guard<std::mutex> lock(m_keyMutex);
+    m_keys.clear();
+}
+
+void PipelineArchive::attach(MTL::RenderPipelineDescriptor* descriptor) const {
+    if (!descriptor || !m_archive || m_recording) {
+        return;
+    }
+    descriptor->setBinaryArchives(NS::Array::array(m_archive));
+}
+
+bool PipelineArchive::record(MTL::RenderPipelineDescriptor* descriptor) {
+    if (!descriptor || !m_archive || !m_recording) {
+        return false;
+    }
+    NS::Error* error = nullptr;
+    if (!m_archive->addRenderPipelineFunctions(descriptor, &error)) {
+        LogArchiveError("failed to record pipeline", error);
+        return false;
+    }
+    return true;
+}
+
+void PipelineArchive::addKey(uint32_t key) {
+    std::lock_guard<std::mutex> lock(m_keyMutex);
+    m_keys.push_back(key);
+}
+
+std::vector<uint32_t> PipelineArchive::getKeys() const {
+    std::lock_guard<std::mutex> lock(m_keyMutex);
+    return m_keys;
+}
+
+} // namespace Crescent
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class BinaryArchive;
+    class RenderPipelineDescriptor;
+}
+
+namespace Crescent {
+
+// On-disk MTL::BinaryArchive of the mesh pipelines a packaged game needs. The cook step
+// (--cook-pipeline-archive) records the descriptor of every PipelineStateKey its scenes resolve to
+// and writes the archive next to a list of those keys (<archive>.keys). At runtime the archive is
+// attached to each pipeline descriptor so matching compiles become lookups, and the key list drives
+// a background pre-warm. Archives are GPU-family specific; on a mismatch Metal silently compiles
+// from source, so a stale archive costs time but never correctness.
+//
+// Render thread only, except the key accessors.
+class PipelineArchive {
+public:
+    static PipelineArchive& getInstance();
+
+    // Starts an empty archive that record() adds descriptors to.
+    bool beginRecording(MTL::Device* device);
+    // Opens a cooked archive and reads its key list.
+    bool load(MTL::Device* device, const std::string& path);
+    // Serializes the recorded archive and key list; stops recording.
+    bool write(const std::string& path);
+    void shutdown();
+
+    bool isRecording() const { return m_recording; }
+    bool isLoaded() const { return m_archive && !m_recording; }
+    const std::string& getPath() const { return m_path; }
+
+    // Points the descriptor at the loaded archive; no-op without one.
+    void attach(MTL::RenderPipelineDescriptor* descriptor) const;
+    // Adds the descriptor's compiled functions while recording; no-op otherwise.
+    bool record(MTL::RenderPipelineDescriptor* descriptor);
+
+    // Packed pipeline keys (see PipelineStateKey::pack) stored beside the archive.
+    void addKey(uint32_t key);
+    std::vector<uint32_t> getKeys() const;
+
+private:
+    PipelineArchive() = default;
+    PipelineArchive(const PipelineArchive&) = delete;
+    PipelineArchive& operator=(const PipelineArchive&) = delete;
+
+    MTL::BinaryArchive* m_archive = nullptr;
+    bool m_recording = false;
+    std::string m_path;
+    mutable std::mutex m_keyMutex;
+    std::vector<uint32_t> m_keys;
+};
+
+} // namespace Crescent
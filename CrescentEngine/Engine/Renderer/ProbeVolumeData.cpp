@@ -0,0 +1,195 @@
+#include "ProbeVolumeData.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+namespace Crescent {
+
+namespace {
+
+uint16_t FloatToHalfBits(float value) {
+    if (!std::isfinite(value)) {
+        value = 0.0f;
+    }
+    __fp16 halfValue = static_cast<__fp16>(std::clamp(value, -65504.0f, 65504.0f));
+    uint16_t bits = 0;
+    std::memcpy(&bits, &halfValue, sizeof(bits));
+    return bits;
+}
+
+bool HasProbeVolumeMagic(const ProbeVolumeFileHeader& header) {
+    return header.magic[0] == 'C' && header.magic[1] == 'P' && header.magic[2] == 'R' && header.magic[3] == 'B';
+}
+
+} // namespace
+
+uint32_t PackRGB9E5(float r, float g, float b) {
+    static constexpr float kMaxValue = 65408.0f; // (511 / 512) * 2^16
+    auto clampChannel = [](float value) { return value > 0.0f ? std::min(value, kMaxValue) : 0.0f; };
+    r = clampChannel(r);
+    g = clampChannel(g);
+    b = clampChannel(b);
+    const float maxChannel = std::max(r, std::max(g, b));
+    if (maxChannel <= 0.0f) {
+        return 0;
+    }
+    int exponent = 0;
+    std::frexp(maxChannel, &exponent);
+    int sharedExponent = std::max(exponent + 15, 0);
+    float scale = std::ldexp(1.0f, sharedExponent - 24);
+    if (std::round(maxChannel / scale) >= 512.0f) {
+        ++sharedExponent;
+        scale *= 2.0f;
+    }
+    auto quantize = [scale](float value) {
+        return std::min(static_cast<uint32_t>(std::round(value / scale)), 511u);
+    };
+    return quantize(r) | (quantize(g) << 9) | (quantize(b) << 18) | (static_cast<uint32_t>(sharedExponent) << 27);
+}
+
+PackedProbeRecord PackProbeVolumeRecord(const ProbeVolumeRecord& record) {
+    PackedProbeRecord packed;
+    for (int face = 0; face < 6; ++face) {
+        packed.ambientCube[face] = PackRGB9E5(record.ambientCube[face][0],
+                                              record.ambientCube[face][1],
+                                              record.ambientCube[face][2]);
+        packed.specularCube[face] = PackRGB9E5(record.specularCube[face][0],
+                                               record.specularCube[face][1],
+                                               record.specularCube[face][2]);
+    }
+    std::memcpy(packed.positionAndValidity, record.positionAndValidity, sizeof(packed.positionAndValidity));
+    for (int i = 0; i < 8; ++i) {
+        packed.visibility[i] = FloatToHalfBits(record.visibility[i / 4][i % 4]);
+    }
+    return packed;
+}
+
+bool WriteProbeVolumeFile(const std::string& path,
+                          const ProbeVolumeFileHeader& header,
+                          const std::vector<uint32_t>& denseBrickOfCell,
+                          const std::vector<ProbeVolumeRecord>& coarseProbes,
+                          const std::vector<ProbeVolumeRecord>& denseProbes) {
+    auto pack = [](const std::vector<ProbeVolumeRecord>& records) {
+        std::vector<PackedProbeRecord> packed;
+        packed.reserve(records.size());
+        for (const ProbeVolumeRecord& record : records) {
+            packed.push_back(PackProbeVolumeRecord(record));
+        }
+        return packed;
+    };
+    const std::vector<PackedProbeRecord> packedCoarse = pack(coarseProbes);
+    const std::vector<PackedProbeRecord> packedDense = pack(denseProbes);
+
+    ProbeVolumeFileHeader brickHeader = header;
+    brickHeader.version = kProbeVolumeBrickVersion;
+    const uint32_t denseBrickCount = static_cast<uint32_t>(denseProbes.size() / kProbeBrickDenseProbes);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&brickHeader), sizeof(brickHeader));
+    out.write(reinterpret_cast<const char*>(&denseBrickCount), sizeof(denseBrickCount));
+    out.write(reinterpret_cast<const char*>(denseBrickOfCell.data()),
+              static_cast<std::streamsize>(denseBrickOfCell.size() * sizeof(uint32_t)));
+    out.write(reinterpret_cast<const char*>(packedCoarse.data()),
+              static_cast<std::streamsize>(packedCoarse.size() * sizeof(PackedProbeRecord)));
+    out.write(reinterpret_cast<const char*>(packedDense.data()),
+              static_cast<std::streamsize>(packedDense.size() * sizeof(PackedProbeRecord)));
+    return out.good();
+}
+
+bool ReadProbeVolumeFile(const std::string& path, ProbeVolumeBricks& outBricks) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open()) {
+        return false;
+    }
+
+    ProbeVolumeFileHeader header{};
+    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!stream.good() || !HasProbeVolumeMagic(header) ||
+        (header.version != kProbeVolumeFloatVersion && header.version != kProbeVolumePackedVersion &&
+         header.version != kProbeVolumeBrickVersion)) {
+        return false;
+    }
+
+    const size_t count = static_cast<size_t>(header.countX) * static_cast<size_t>(header.countY) *
+                         static_cast<size_t>(header.countZ);
+    if (count == 0u) {
+        return false;
+    }
+
+    ProbeVolumeBricks bricks;
+    if (header.version == kProbeVolumeBrickVersion) {
+        uint32_t denseBrickCount = 0;
+        stream.read(reinterpret_cast<char*>(&denseBrickCount), sizeof(denseBrickCount));
+        if (!stream.good() || denseBrickCount > count) {
+            return false;
+        }
+        bricks.header = header;
+        bricks.denseBrickOfCell.resize(count);
+        bricks.coarseProbes.resize(bricks.coarseProbeCount());
+        bricks.denseProbes.resize(static_cast<size_t>(denseBrickCount) * kProbeBrickDenseProbes);
+        stream.read(reinterpret_cast<char*>(bricks.denseBrickOfCell.data()),
+                    static_cast<std::streamsize>(count * sizeof(uint32_t)));
+        stream.read(reinterpret_cast<char*>(bricks.coarseProbes.data()),
+                    static_cast<std::streamsize>(bricks.coarseProbes.size() * sizeof(PackedProbeRecord)));
+        stream.read(reinterpret_cast<char*>(bricks.denseProbes.data()),
+                    static_cast<std::streamsize>(bricks.denseProbes.size() * sizeof(PackedProbeRecord)));
+        if (!stream.good()) {
+            return false;
+        }
+        for (uint32_t& brick : bricks.denseBrickOfCell) {
+            if (brick != kProbeBrickNone && brick >= denseBrickCount) {
+                brick = kProbeBrickNone;
+            }
+        }
+        outBricks = std::move(bricks);
+        return true;
+    }
+
+    std::vector<PackedProbeRecord> grid(count);
+    if (header.version == kProbeVolumePackedVersion) {
+        stream.read(reinterpret_cast<char*>(grid.data()),
+                    static_cast<std::streamsize>(count * sizeof(PackedProbeRecord)));
+        if (!stream.good()) {
+            return false;
+        }
+    } else {
+        // Bakes from before the packed format; rebaking writes the brick version.
+        for (PackedProbeRecord& packed : grid) {
+            ProbeVolumeRecord record;
+            stream.read(reinterpret_cast<char*>(&record), sizeof(record));
+            if (!stream.good()) {
+                return false;
+            }
+            packed = PackProbeVolumeRecord(record);
+        }
+    }
+
+    // The grid's cells become the volume's; a single-probe axis gets one cell with the probe on
+    // both of its faces.
+    const uint32_t gridCounts[3] = {header.countX, header.countY, header.countZ};
+    header.countX = std::max(gridCounts[0], 2u) - 1u;
+    header.countY = std::max(gridCounts[1], 2u) - 1u;
+    header.countZ = std::max(gridCounts[2], 2u) - 1u;
+    bricks.header = header;
+    bricks.denseBrickOfCell.assign(bricks.cellCount(), kProbeBrickNone);
+    bricks.coarseProbes.reserve(bricks.coarseProbeCount());
+    for (uint32_t z = 0; z <= header.countZ; ++z) {
+        for (uint32_t y = 0; y <= header.countY; ++y) {
+            for (uint32_t x = 0; x <= header.countX; ++x) {
+                uint32_t gx = std::min(x, gridCounts[0] - 1u);
+                uint32_t gy = std::min(y, gridCounts[1] - 1u);
+                uint32_t gz = std::min(z, gridCounts[2] - 1u);
+                bricks.coarseProbes.push_back(grid[gx + gridCounts[0] * (gy + static_cast<size_t>(gridCounts[1]) * gz)]);
+            }
+        }
+    }
+    outBricks = std::move(bricks);
+    return true;
+}
+
+} // namespace Crescent
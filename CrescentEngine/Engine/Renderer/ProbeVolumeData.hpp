@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Crescent {
+
+// Baked probe volume file. Versions 3 (float records) and 4 (packed records) store a uniform grid
+// of countX * countY * countZ probes, x fastest, then y, then z. Version 5 stores a brick volume:
+// countX/Y/Z count cells over the bounds, and the header is followed by the dense brick count, the
+// dense brick index of every cell (kProbeBrickNone away from geometry), the coarse probe grid on
+// the cell corners and the dense bricks' probes.
+struct ProbeVolumeFileHeader {
+    char magic[4] = {'C', 'P', 'R', 'B'};
+    uint32_t version = 5u;
+    uint32_t countX = 0u;
+    uint32_t countY = 0u;
+    uint32_t countZ = 0u;
+    float boundsMin[3] = {0.0f, 0.0f, 0.0f};
+    float boundsMax[3] = {0.0f, 0.0f, 0.0f};
+};
+
+// What the baker computes for a probe, and the version 3 record.
+struct ProbeVolumeRecord {
+    float ambientCube[6][4] = {};
+    float specularCube[6][4] = {};
+    float positionAndValidity[4] = {};
+    float visibility[2][4] = {};
+};
+
+// ProbeAmbientCubeData in Common.metal.h. Cube colours are RGB9E5, visibility distances half
+// floats; the shaders decode only the faces they sample.
+struct PackedProbeRecord {
+    uint32_t ambientCube[6] = {};
+    uint32_t specularCube[6] = {};
+    float positionAndValidity[4] = {};
+    uint16_t visibility[8] = {};
+};
+static_assert(sizeof(PackedProbeRecord) == 80, "PackedProbeRecord must match ProbeAmbientCubeData in Common.metal.h");
+
+constexpr uint32_t kProbeVolumeFloatVersion = 3u;
+constexpr uint32_t kProbeVolumePackedVersion = 4u;
+constexpr uint32_t kProbeVolumeBrickVersion = 5u;
+
+// Every cell interpolates the coarse grid on its corners unless it has a dense brick: 4x4x4
+// probes spanning the cell, corners included, x fastest. Neighbouring bricks repeat the probes on
+// their shared faces, so a lookup never leaves the brick it lands in.
+constexpr uint32_t kProbeBrickDenseResolution = 4u;
+constexpr uint32_t kProbeBrickDenseProbes = 64u;
+constexpr uint32_t kProbeBrickNone = 0xffffffffu;
+
+// The GPU indirection entry of a cell (the first words of the probe buffer): the first probe of
+// its dense brick with kProbeBrickDenseBit set, or else the first probe of the coarse grid.
+constexpr uint32_t kProbeBrickDenseBit = 0x80000000u;
+
+struct ProbeVolumeBricks {
+    ProbeVolumeFileHeader header;
+    std::vector<uint32_t> denseBrickOfCell;
+    std::vector<PackedProbeRecord> coarseProbes; // (countX + 1) * (countY + 1) * (countZ + 1)
+    std::vector<PackedProbeRecord> denseProbes;  // kProbeBrickDenseProbes per dense brick
+
+    size_t cellCount() const {
+        return static_cast<size_t>(header.countX) * header.countY * header.countZ;
+    }
+    size_t coarseProbeCount() const {
+        return static_cast<size_t>(header.countX + 1u) * (header.countY + 1u) * (header.countZ + 1u);
+    }
+    size_t denseBrickCount() const { return denseProbes.size() / kProbeBrickDenseProbes; }
+};
+
+// Shared-exponent RGB9E5: a 9-bit mantissa per channel and one 5-bit exponent, biased by 15.
+// Negative and NaN channels become zero; larger ones saturate at the format's maximum.
+uint32_t PackRGB9E5(float r, float g, float b);
+
+PackedProbeRecord PackProbeVolumeRecord(const ProbeVolumeRecord& record);
+
+// Writes version 5; the header's counts are cell counts.
+bool WriteProbeVolumeFile(const std::string& path,
+                          const ProbeVolumeFileHeader& header,
+                          const std::vector<uint32_t>& denseBrickOfCell,
+                          const std::vector<ProbeVolumeRecord>& coarseProbes,
+                          const std::vector<ProbeVolumeRecord>& denseProbes);
+
+// Reads any version. A uniform grid becomes the coarse grid of a volume without dense bricks,
+// which samples exactly like the grid did.
+bool ReadProbeVolumeFile(const std::string& path, ProbeVolumeBricks& outBricks);
+
+} // namespace Crescent
@@ -0,0 +1,169 @@
+#include "RenderTargetHeap.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <numeric>
+
+namespace Crescent {
+
+namespace {
+    struct Placement {
+        size_t offset = 0;
+        size_t size = 0;
+        size_t align = 1;
+    };
+
+    size_t AlignUp(size_t value, size_t align) {
+        return align > 1 ? (value + align - 1) / align * align : value;
+    }
+
+    uint32_t BucketExtent(NS::UInteger extent) {
+        const uint32_t bucket = RenderTargetHeap::kBucketExtent;
+        return static_cast<uint32_t>((extent + bucket - 1) / bucket * bucket);
+    }
+}
+
+RenderTargetHeap::RenderTargetHeap()
+    : m_device(nullptr)
+    , m_heap(nullptr)
+    , m_heapSize(0)
+    , m_aliasedBytes(0) {
+}
+
+RenderTargetHeap::~RenderTargetHeap() {
+    shutdown();
+}
+
+bool RenderTargetHeap::initialize(MTL::Device* device) {
+    if (!device) {
+        return false;
+    }
+    m_device = device;
+    return true;
+}
+
+void RenderTargetHeap::shutdown() {
+    // Textures still placed on the heap keep its memory alive until they are released.
+    if (m_heap) {
+        m_heap->release();
+        m_heap = nullptr;
+    }
+    m_heapSize = 0;
+    m_aliasedBytes = 0;
+    m_device = nullptr;
+}
+
+bool RenderTargetHeap::reserve(size_t size) {
+    if (m_heap && size <= m_heapSize) {
+        return true;
+    }
+    MTL::HeapDescriptor* desc = MTL::HeapDescriptor::alloc()->init();
+    desc->setType(MTL::HeapTypePlacement);
+    desc->setStorageMode(MTL::StorageModePrivate);
+    desc->setHazardTrackingMode(MTL::HazardTrackingModeTracked);
+    desc->setSize(size);
+    MTL::Heap* heap = m_device->newHeap(desc);
+    desc->release();
+    if (!heap) {
+        return false;
+    }
+    // The other pools' targets keep the old heap alive and get re-placed once they see isStale().
+    if (m_heap) {
+        m_heap->release();
+    }
+    m_heap = heap;
+    m_heapSize = size;
+    return true;
+}
+
+bool RenderTargetHeap::place(const std::vector<Request>& requests) {
+    if (!m_device || requests.empty()) {
+        return false;
+    }
+
+    std::vector<Placement> placements(requests.size());
+    size_t requestedBytes = 0;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (!requests[i].descriptor || !requests[i].texture) {
+            return false;
+        }
+        // Sized at the bucket so the offsets hold for every extent within it.
+        MTL::TextureDescriptor* bucketDesc = requests[i].descriptor->copy();
+        bucketDesc->setWidth(BucketExtent(bucketDesc->width()));
+        bucketDesc->setHeight(BucketExtent(bucketDesc->height()));
+        MTL::SizeAndAlign sizeAndAlign = m_device->heapTextureSizeAndAlign(bucketDesc);
+        bucketDesc->release();
+        placements[i].size = sizeAndAlign.size;
+        placements[i].align = std::max<size_t>(1, sizeAndAlign.align);
+        requestedBytes += sizeAndAlign.size;
+    }
+
+    // Largest first, each at the lowest offset clear of every placed target it is alive with.
+    std::vector<size_t> order(requests.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return placements[a].size > placements[b].size;
+    });
+
+    std::vector<size_t> placed;
+    std::vector<size_t> live;
+    placed.reserve(order.size());
+    size_t layoutSize = 0;
+    for (size_t index : order) {
+        const Request& request = requests[index];
+        live.clear();
+        for (size_t other : placed) {
+            const Request& o = requests[other];
+            if (request.firstPass <= o.lastPass && o.firstPass <= request.lastPass) {
+                live.push_back(other);
+            }
+        }
+        std::sort(live.begin(), live.end(), [&](size_t a, size_t b) {
+            return placements[a].offset < placements[b].offset;
+        });
+
+        Placement& placement = placements[index];
+        size_t offset = 0;
+        for (size_t other : live) {
+            const Placement& o = placements[other];
+            if (offset + placement.size <= o.offset) {
+                break;
+            }
+            offset = std::max(offset, AlignUp(o.offset + o.size, placement.align));
+        }
+        placement.offset = offset;
+        layoutSize = std::max(layoutSize, offset + placement.size);
+        placed.push_back(index);
+    }
+
+    if (!reserve(layoutSize)) {
+        return false;
+    }
+
+    std::vector<MTL::Texture*> textures(requests.size(), nullptr);
+    for (size_t i = 0; i < requests.size(); ++i) {
+        textures[i] = m_heap->newTexture(requests[i].descriptor, placements[i].offset);
+        if (!textures[i]) {
+            for (MTL::Texture* texture : textures) {
+                if (texture) {
+                    texture->release();
+                }
+            }
+            return false;
+        }
+    }
+    for (size_t i = 0; i < requests.size(); ++i) {
+        *requests[i].texture = textures[i];
+    }
+    m_aliasedBytes = requestedBytes > layoutSize ? requestedBytes - layoutSize : 0;
+    return true;
+}
+
+bool RenderTargetHeap::isStale(const MTL::Texture* texture) const {
+    if (!texture) {
+        return false;
+    }
+    MTL::Heap* heap = texture->heap();
+    return heap && heap != m_heap;
+}
+
+} // namespace Crescent
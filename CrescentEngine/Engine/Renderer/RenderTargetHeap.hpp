@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class Heap;
+    class Texture;
+    class TextureDescriptor;
+}
+
+namespace Crescent {
+
+// Placement heap for render targets that only live within a frame (post chain targets, decal
+// G-buffer, SSAO, MSAA attachments). Each target declares the range of passes it is written and
+// read in; targets whose ranges do not overlap are placed on the same memory. Every target pool
+// places its targets from offset 0 of the one heap, so the Scene, Game and Preview pools share it
+// too; none of these targets carries contents into a later frame.
+//
+// The heap is hazard tracked as a whole, so Metal orders every encoder that touches it and the
+// aliased placements need no fences of their own.
+//
+// Layouts are computed at the size bucket of each target (its extent rounded up to kBucketExtent),
+// so a resize that stays within the bucket, as dragging a dock splitter or a dynamic resolution
+// step mostly does, re-places the targets in the memory the heap already has. The heap only grows.
+// The renderer also keeps one per target pool, with every target alive for the whole frame, for
+// the targets that carry contents into the next frame (scene color, depth, TAA history, HZB).
+class RenderTargetHeap {
+public:
+    static constexpr uint32_t kBucketExtent = 256;
+
+    struct Request {
+        MTL::TextureDescriptor* descriptor = nullptr; // private storage
+        uint32_t firstPass = 0;
+        uint32_t lastPass = 0; // inclusive
+        MTL::Texture** texture = nullptr;
+    };
+
+    RenderTargetHeap();
+    ~RenderTargetHeap();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_device != nullptr; }
+
+    // Packs the requests and creates their textures, growing the heap if the layout needs more
+    // room. On failure nothing is written and the caller allocates the targets itself.
+    bool place(const std::vector<Request>& requests);
+    // Targets placed before the heap last grew still sit on the old heap and should be re-placed.
+    bool isStale(const MTL::Texture* texture) const;
+
+    size_t getHeapSize() const { return m_heapSize; }
+    // Bytes of the last placed layout that share memory with another of its targets.
+    size_t getAliasedBytes() const { return m_aliasedBytes; }
+
+private:
+    bool reserve(size_t size);
+
+    MTL::Device* m_device;
+    MTL::Heap* m_heap;
+    size_t m_heapSize;
+    size_t m_aliasedBytes;
+};
+
+} // namespace Crescent
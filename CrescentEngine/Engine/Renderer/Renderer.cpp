@@ -1,4 +1,5 @@
 #include "Renderer.hpp"
+#include "ShaderLibrary.hpp"
 #include "../Rendering/Mesh.hpp"
 #include "../Rendering/Material.hpp"
 #include "../Rendering/Texture.hpp"
@@ -11,17 +12,51 @@
 #include "../Components/PrimitiveMesh.hpp"
 #include "../Components/Decal.hpp"
 #include "../Components/HLODProxy.hpp"
+#include "../Components/FoliageScatter.hpp"
+#include "../Components/TerrainRenderer.hpp"
 #include "../Scene/Scene.hpp"
 #include "../Scene/SceneManager.hpp"
 #include "../Core/Time.hpp"
+#include "../Core/SelectionSystem.hpp"
+#include "../Input/InputManager.hpp"
+#include "../Math/Frustum.hpp"
 #include "../ECS/Entity.hpp"
+#include "../ECS/EntityBitset.hpp"
 #include "../ECS/Transform.hpp"
 #include "../Assets/AssetDatabase.hpp"
 #include "DebugRenderer.hpp"
 #include "../IBL/IBLGenerator.hpp"
+#include "../IBL/CookedEnvironment.hpp"
+#include "EnvironmentProcessor.hpp"
 #include "LightingSystem.hpp"
 #include "ShadowRenderPass.hpp"
 #include "ClusteredLightingPass.hpp"
+#include "SkinningCache.hpp"
+#include "CrowdAnimation.hpp"
+#include "DynamicProbeGI.hpp"
+#include "MaterialTable.hpp"
+#include "SceneResidency.hpp"
+#include "UniformRing.hpp"
+#include "InstanceCache.hpp"
+#include "FoliageSystem.hpp"
+#include "TerrainSystem.hpp"
+#include "TerrainVirtualTexture.hpp"
+#include "TiledPostBlur.hpp"
+#include "ParticleSystem.hpp"
+#include "SkyAtmosphere.hpp"
+#include "RenderTargetHeap.hpp"
+#include "AsyncComputeQueue.hpp"
+#include "DynamicResolution.hpp"
+#include "TextureStreamer.hpp"
+#include "VariableRateShading.hpp"
+#include "WeightedTransparency.hpp"
+#include "ParallelPassEncoder.hpp"
+#include "GeometryBuffer.hpp"
+#include "PipelineArchive.hpp"
+#include "ProbeVolumeData.hpp"
+#include "../Core/StartupLog.hpp"
+#include "../Core/CPUProfiler.hpp"
+#include "../Core/StartupTrace.hpp"
 #include <algorithm>
 #include <cmath>
 #include <array>
@@ -32,6 +67,7 @@
 #include <cctype>
 #include <unordered_set>
 #include <limits>
+#include <cstddef>
 
 #define NS_PRIVATE_IMPLEMENTATION
 #define CA_PRIVATE_IMPLEMENTATION
@@ -46,7 +82,9 @@
 #include <cstdint>
 #include <algorithm>
 #include <cstring>
+#include <atomic>
 #include <utility>
+#include <mutex>
 
 namespace Crescent {
 
@@ -67,19 +105,15 @@ struct CubeLUTData {
     std::vector<Math::Vector3> values;
 };
 
-constexpr uint32_t kCookedEnvironmentVersion = 2;
-constexpr size_t kRGBA16FPixelBytes = sizeof(uint16_t) * 4;
-
-struct CookedEnvironmentHeader {
-    char magic[4];
-    uint32_t version;
-    uint32_t cubemapSize;
-    uint32_t cubemapMipLevels;
-    uint32_t prefilteredSize;
-    uint32_t prefilteredMipLevels;
-    uint32_t irradianceSize;
-    uint32_t irradianceMipLevels;
-};
+// Environment rotation as EnvironmentUniforms and the procedural sky's cubemaps apply it.
+Math::Matrix4x4 EnvironmentRotationMatrix(const Math::Vector3& eulerDegrees) {
+    Math::Vector3 eulerRad(
+        eulerDegrees.x * Math::DEG_TO_RAD,
+        eulerDegrees.y * Math::DEG_TO_RAD,
+        eulerDegrees.z * Math::DEG_TO_RAD
+    );
+    return Math::Matrix4x4::Rotate(Math::Quaternion::FromEulerAngles(eulerRad));
+}
 
 std::string ToUpper(std::string value) {
     for (char& c : value) {
@@ -97,36 +131,313 @@ bool EndsWithIgnoreCase(const std::string& value, const std::string& suffix) {
     });
 }
 
-void ResolveRendererBounds(Entity* entity,
-                           MeshRenderer* meshRenderer,
-                           Math::Vector3& outCenter,
-                           Math::Vector3& outSize) {
-    Math::Vector3 boundsMin = Math::Vector3::Zero;
-    Math::Vector3 boundsMax = Math::Vector3::Zero;
-    if (meshRenderer) {
-        meshRenderer->getWorldBounds(boundsMin, boundsMax);
+// Camera-frustum visibility for every MeshRenderer proxy, computed once per renderScene so the
+// bounds transforms and plane tests run as batches over contiguous arrays. Skinned renderers
+// with live bones already have world bounds, so they pass through an identity transform.
+// outSpheres, when given, receives the untightened world spheres for the occlusion test.
+void CullMeshProxies(const std::vector<MeshRenderProxy>& proxies,
+                     const Math::FrustumPlanes& planes,
+                     float cullTightness,
+                     FrameArena& arena,
+                     FrameVector<uint8_t>& outVisible,
+                     FrameVector<Math::Vector4>* outSpheres = nullptr) {
+    const size_t count = proxies.size();
+    FrameVector<Math::Matrix4x4> matrices(count, Math::Matrix4x4::Identity, arena);
+    FrameVector<Math::Vector3> localMin(count, Math::Vector3::Zero, arena);
+    FrameVector<Math::Vector3> localMax(count, Math::Vector3::Zero, arena);
+    for (size_t i = 0; i < count; ++i) {
+        const MeshRenderProxy& proxy = proxies[i];
+        MeshRenderer* meshRenderer = proxy.meshRenderer;
+        Mesh* mesh = meshRenderer ? meshRenderer->getMesh().get() : nullptr;
+        if (!mesh) {
+            continue;
+        }
+        SkinnedMeshRenderer* skinned = proxy.skinned;
+        if (skinned && skinned->isEnabled() && mesh->hasSkinWeights() && !skinned->getBoneMatrices().empty()) {
+            skinned->getWorldBounds(localMin[i], localMax[i]);
+            continue;
+        }
+        Transform* transform = proxy.entity ? proxy.entity->getTransform() : nullptr;
+        if (transform) {
+            matrices[i] = transform->getWorldMatrix();
+        }
+        localMin[i] = mesh->getBoundsMin();
+        localMax[i] = mesh->getBoundsMax();
+    }
+
+    FrameVector<Math::Vector3> worldMin(count, arena);
+    FrameVector<Math::Vector3> worldMax(count, arena);
+    Math::Matrix4x4::TransformAABBMany(matrices.data(), localMin.data(), localMax.data(),
+                                       worldMin.data(), worldMax.data(), count);
+
+    FrameVector<Math::Vector4> spheres(count, arena);
+    for (size_t i = 0; i < count; ++i) {
+        const Math::Vector3 center = (worldMin[i] + worldMax[i]) * 0.5f;
+        const Math::Vector3 size = worldMax[i] - worldMin[i];
+        float radius = 0.5f * std::sqrt(size.x * size.x + size.y * size.y + size.z * size.z);
+        if (radius <= 0.0f) {
+            radius = 0.001f;
+        }
+        spheres[i] = Math::Vector4(center.x, center.y, center.z, radius * cullTightness);
     }
-    outCenter = (boundsMin + boundsMax) * 0.5f;
-    outSize = boundsMax - boundsMin;
-    if (!entity) {
-        return;
+    if (outSpheres) {
+        outSpheres->resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            const Math::Vector4& s = spheres[i];
+            (*outSpheres)[i] = Math::Vector4(s.x, s.y, s.z, s.w / cullTightness);
+        }
     }
+    outVisible.resize(count);
+    Math::SpheresInFrustumMany(planes, spheres.data(), count, outVisible.data());
+}
+
+// World sphere around a decal's unit projection box.
+Math::Vector4 DecalWorldSphere(const Math::Matrix4x4& model) {
+    Math::Vector3 worldMin;
+    Math::Vector3 worldMax;
+    model.transformAABB(Math::Vector3(-0.5f, -0.5f, -0.5f), Math::Vector3(0.5f, 0.5f, 0.5f), worldMin, worldMax);
+    const Math::Vector3 center = (worldMin + worldMax) * 0.5f;
+    const float radius = std::max((worldMax - worldMin).length() * 0.5f, 0.001f);
+    return Math::Vector4(center.x, center.y, center.z, radius);
+}
+
+// One MeshRenderer draw gathered before its pass is encoded. Everything that allocates or
+// touches shared renderer state is resolved while gathering, so the encode itself can be
+// split across ParallelPassEncoder sub-encoders.
+struct PassDraw {
+    Entity* entity = nullptr;
+    MeshRenderer* meshRenderer = nullptr;
+    Mesh* mesh = nullptr;
+    std::shared_ptr<Material> material;
+    MTL::RenderPipelineState* pipeline = nullptr;
+    MTL::Buffer* vertexBuffer = nullptr;
+    MTL::Buffer* indexBuffer = nullptr;
+    MTL::Buffer* skinBuffer = nullptr;
+    const std::vector<Math::Matrix4x4>* boneMatrices = nullptr;
+    const std::vector<Math::Matrix4x4>* prevBoneMatrices = nullptr; // prepass motion; right after boneMatrices
+    size_t skinningOffset = 0;
+    Math::Matrix4x4 modelMatrix;
+    Math::Matrix4x4 prevModelMatrix; // prepass motion only
+    bool writesMotion = false;
+    bool isSkinned = false;
+    bool isTransparent = false; // blended; sorted back to front after the opaque draws
+    const SkinningCache::Entry* skinCache = nullptr; // pre-skinned streams, drawn as a static mesh
+    uint32_t lod = 0;
+    float lodDither = 0.0f; // see lodDitherDiscard in PBR.metal
+    uint32_t occlusionArg = Renderer::kNoOcclusionArg; // indirect args slot when deferred to the HZB test
+    // Main pass only.
+    uint32_t materialEntry = MaterialTable::kInvalidEntry; // this frame's material table entry, if any
+    std::shared_ptr<Texture2D> staticLightmap;
+    std::shared_ptr<Texture2D> directionalLightmap;
+    std::shared_ptr<Texture2D> shadowmaskLightmap;
+};
 
-    SkinnedMeshRenderer* skinned = entity->getComponent<SkinnedMeshRenderer>();
-    if (!skinned || !skinned->isEnabled()) {
+// Contiguous skinning slice reserved for a whole pass; draws write their bones at the
+// offsets assigned while gathering.
+struct PassSkinningBlock {
+    MTL::Buffer* buffer = nullptr;
+    size_t base = 0;
+};
+
+inline size_t AlignSkinningBytes(size_t bytes) {
+    constexpr size_t kAlignment = 256;
+    return (bytes + (kAlignment - 1)) & ~(kAlignment - 1);
+}
+
+// Skinning block bytes one draw writes: its palette, then last frame's when it writes motion.
+inline size_t DrawSkinningBytes(const PassDraw& draw) {
+    const size_t palette = AlignSkinningBytes(draw.boneMatrices->size() * sizeof(Math::Matrix4x4));
+    return draw.prevBoneMatrices ? palette * 2 : palette;
+}
+
+// Picks the draw's mesh LOD for this view. While the next coarser level fades in, a second draw of
+// that level is appended with the complementary dither (and its own bone slice when skinned).
+void AppendLodDraws(FrameVector<PassDraw>& draws,
+                    PassDraw draw,
+                    const Math::Vector4& lodView,
+                    float pixelError,
+                    size_t& skinningBytes) {
+    float fade = 0.0f;
+    draw.lod = draw.mesh->selectLod(draw.modelMatrix, lodView, pixelError, &fade);
+    if (fade <= 0.0f) {
+        draws.push_back(std::move(draw));
         return;
     }
+    const float keep = std::max(1.0f - fade, 1e-3f);
+    PassDraw next = draw;
+    next.lod = draw.lod + 1;
+    next.lodDither = -keep;
+    if (next.boneMatrices) {
+        next.skinningOffset = skinningBytes;
+        skinningBytes += DrawSkinningBytes(next);
+    }
+    draw.lodDither = keep;
+    draws.push_back(std::move(draw));
+    draws.push_back(std::move(next));
+}
 
-    std::shared_ptr<Mesh> mesh = meshRenderer ? meshRenderer->getMesh() : nullptr;
-    if (!mesh || !mesh->hasSkinWeights() || skinned->getBoneMatrices().empty()) {
+// Orders a pass's draws by a 64-bit key. Opaque keys hold the pipeline (15 bits), material (16),
+// mesh (16) and a front-to-back depth bucket (16), so pipeline, cull mode and texture changes
+// group together and each group still draws front to back. Blended keys set the top bit and put
+// the exact depth, descending, above pipeline and material for back-to-front compositing. The
+// radix sort is stable, so LOD fade pairs stay adjacent.
+void SortPassDraws(FrameVector<PassDraw>& draws, const Math::Vector3& eye, FrameArena& arena) {
+    if (draws.size() < 2) {
         return;
     }
+    // Dense ids in first-seen order; overflowing ids share the last value and only group worse.
+    FrameUnorderedMap<const void*, uint32_t> pipelineIds(arena);
+    FrameUnorderedMap<const void*, uint32_t> materialIds(arena);
+    FrameUnorderedMap<const void*, uint32_t> meshIds(arena);
+    auto denseId = [](FrameUnorderedMap<const void*, uint32_t>& ids, const void* object, uint32_t limit) {
+        auto it = ids.try_emplace(object, static_cast<uint32_t>(ids.size())).first;
+        return std::min(it->second, limit);
+    };
+
+    struct KeyedDraw {
+        uint64_t key;
+        uint32_t index;
+    };
+    FrameVector<KeyedDraw> keyed(arena);
+    keyed.resize(draws.size());
+    for (size_t i = 0; i < draws.size(); ++i) {
+        const PassDraw& draw = draws[i];
+        const Math::Vector3 center = draw.modelMatrix.transformPointAffine(draw.mesh->getBoundsCenter());
+        // Non-negative floats order like their bit patterns; the top 16 bits are log-spaced buckets.
+        const float distance = (center - eye).length();
+        uint32_t depthBits = 0;
+        std::memcpy(&depthBits, &distance, sizeof(depthBits));
+        depthBits &= 0x7FFFFFFFu;
+        const uint64_t pipeline = denseId(pipelineIds, draw.pipeline, 0x7FFFu);
+        const uint64_t material = denseId(materialIds, draw.material.get(), 0xFFFFu);
+        uint64_t key = 0;
+        if (draw.isTransparent) {
+            key = (1ull << 63) | (static_cast<uint64_t>(0x7FFFFFFFu - depthBits) << 32) | (pipeline << 16) | material;
+        } else {
+            const uint64_t mesh = denseId(meshIds, draw.mesh, 0xFFFFu);
+            key = (pipeline << 48) | (material << 32) | (mesh << 16) | (depthBits >> 15);
+        }
+        keyed[i] = {key, static_cast<uint32_t>(i)};
+    }
+
+    // LSD radix sort over 8-bit digits, skipping digits every key shares.
+    FrameVector<KeyedDraw> scratch(arena);
+    scratch.resize(keyed.size());
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        std::array<uint32_t, 256> counts{};
+        for (const KeyedDraw& entry : keyed) {
+            counts[(entry.key >> shift) & 0xFFu]++;
+        }
+        if (counts[(keyed[0].key >> shift) & 0xFFu] == keyed.size()) {
+            continue;
+        }
+        uint32_t offset = 0;
+        for (uint32_t& count : counts) {
+            const uint32_t bucket = count;
+            count = offset;
+            offset += bucket;
+        }
+        for (const KeyedDraw& entry : keyed) {
+            scratch[counts[(entry.key >> shift) & 0xFFu]++] = entry;
+        }
+        keyed.swap(scratch);
+    }
 
-    skinned->getWorldBounds(boundsMin, boundsMax);
-    outCenter = (boundsMin + boundsMax) * 0.5f;
-    outSize = boundsMax - boundsMin;
+    FrameVector<PassDraw> sorted(arena);
+    sorted.reserve(draws.size());
+    for (const KeyedDraw& entry : keyed) {
+        sorted.push_back(std::move(draws[entry.index]));
+    }
+    draws.swap(sorted);
 }
 
+// What a range of draws last set on its encoder, so sorted draws skip binds that would not change
+// anything. Sub-encoders start from default state, so every range keeps its own.
+struct PassEncodeState {
+    MTL::RenderPipelineState* pipeline = nullptr;
+    int cullMode = -1;
+    const Material* textureMaterial = nullptr; // material whose textures are bound
+    bool texturesBound = false;
+    uint32_t fragmentMaterialEntry = MaterialTable::kInvalidEntry;
+    uint32_t vertexMaterialEntry = MaterialTable::kInvalidEntry;
+    uint32_t binds = 0;
+    uint32_t skipped = 0;
+    GPUPassWork work; // every draw and bind recorded through this state
+    UniformRing::Binder uniforms; // per-draw bytes go to the frame's uniform ring when it has one
+
+    void setPipeline(MTL::RenderCommandEncoder* encoder, MTL::RenderPipelineState* state) {
+        if (state == pipeline) {
+            ++skipped;
+            return;
+        }
+        encoder->setRenderPipelineState(state);
+        pipeline = state;
+        ++binds;
+        ++work.pipelineBinds;
+    }
+
+    void setVertexBuffer(MTL::RenderCommandEncoder* encoder, MTL::Buffer* buffer, NS::UInteger offset, NS::UInteger index) {
+        encoder->setVertexBuffer(buffer, offset, index);
+        uniforms.forgetVertex(static_cast<uint32_t>(index));
+        ++work.bufferBinds;
+    }
+
+    void setFragmentBuffer(MTL::RenderCommandEncoder* encoder, MTL::Buffer* buffer, NS::UInteger offset, NS::UInteger index) {
+        encoder->setFragmentBuffer(buffer, offset, index);
+        uniforms.forgetFragment(static_cast<uint32_t>(index));
+        ++work.bufferBinds;
+    }
+
+    void setVertexBytes(MTL::RenderCommandEncoder* encoder, const void* bytes, NS::UInteger length, NS::UInteger index) {
+        ++work.bufferBinds;
+        if (uniforms.setVertexBytes(encoder, bytes, length, static_cast<uint32_t>(index))) {
+            work.ringBytes += length;
+            return;
+        }
+        encoder->setVertexBytes(bytes, length, index);
+        uniforms.forgetVertex(static_cast<uint32_t>(index));
+        work.inlineBytes += length;
+    }
+
+    void setFragmentBytes(MTL::RenderCommandEncoder* encoder, const void* bytes, NS::UInteger length, NS::UInteger index) {
+        ++work.bufferBinds;
+        if (uniforms.setFragmentBytes(encoder, bytes, length, static_cast<uint32_t>(index))) {
+            work.ringBytes += length;
+            return;
+        }
+        encoder->setFragmentBytes(bytes, length, index);
+        uniforms.forgetFragment(static_cast<uint32_t>(index));
+        work.inlineBytes += length;
+    }
+
+    void setFragmentTexture(MTL::RenderCommandEncoder* encoder, MTL::Texture* texture, NS::UInteger index) {
+        encoder->setFragmentTexture(texture, index);
+        ++work.textureBinds;
+    }
+
+    void setCullMode(MTL::RenderCommandEncoder* encoder, MTL::CullMode mode) {
+        if (static_cast<int>(mode) == cullMode) {
+            ++skipped;
+            return;
+        }
+        encoder->setCullMode(mode);
+        cullMode = static_cast<int>(mode);
+        ++binds;
+    }
+
+    // True when the material's textures are not bound yet; the caller then binds them.
+    bool needsTextures(const Material* material) {
+        if (texturesBound && textureMaterial == material) {
+            ++skipped;
+            return false;
+        }
+        textureMaterial = material;
+        texturesBound = true;
+        ++binds;
+        return true;
+    }
+};
+
 float ResolveStaticLightmapEncodingFlag(const std::string& path) {
     if (EndsWithIgnoreCase(path, ".exr") || EndsWithIgnoreCase(path, ".hdr")) {
         return 1.0f;
@@ -232,159 +543,6 @@ std::shared_ptr<Texture2D> CreateLUTTextureFromCube(TextureLoader* loader, const
     return loader->createTextureFromRGBA8(path, data.data(), width, height, false, false);
 }
 
-bool ReadExact(std::istream& stream, void* dst, size_t size) {
-    stream.read(static_cast<char*>(dst), static_cast<std::streamsize>(size));
-    return stream.good();
-}
-
-bool WriteExact(std::ostream& stream, const void* src, size_t size) {
-    stream.write(static_cast<const char*>(src), static_cast<std::streamsize>(size));
-    return stream.good();
-}
-
-bool WriteCubeTexture(std::ostream& stream, MTL::Texture* texture) {
-    if (!texture) {
-        return false;
-    }
-
-    const uint32_t mipLevels = static_cast<uint32_t>(texture->mipmapLevelCount());
-    for (uint32_t mip = 0; mip < mipLevels; ++mip) {
-        const uint32_t mipSize = std::max(1u, static_cast<uint32_t>(texture->width()) >> mip);
-        const size_t bytesPerRow = static_cast<size_t>(mipSize) * kRGBA16FPixelBytes;
-        const size_t bytesPerImage = bytesPerRow * mipSize;
-        std::vector<uint8_t> faceData(bytesPerImage);
-        MTL::Region region = MTL::Region::Make2D(0, 0, mipSize, mipSize);
-
-        for (uint32_t face = 0; face < 6; ++face) {
-            texture->getBytes(faceData.data(),
-                              static_cast<NS::UInteger>(bytesPerRow),
-                              static_cast<NS::UInteger>(bytesPerImage),
-                              region,
-                              static_cast<NS::UInteger>(mip),
-                              static_cast<NS::UInteger>(face));
-            if (!WriteExact(stream, faceData.data(), faceData.size())) {
-                return false;
-            }
-        }
-    }
-
-    return true;
-}
-
-MTL::Texture* ReadCubeTexture(std::istream& stream,
-                              MTL::Device* device,
-                              uint32_t size,
-                              uint32_t mipLevels) {
-    if (!device || size == 0 || mipLevels == 0) {
-        return nullptr;
-    }
-
-    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
-    desc->setTextureType(MTL::TextureTypeCube);
-    desc->setPixelFormat(MTL::PixelFormatRGBA16Float);
-    desc->setWidth(size);
-    desc->setHeight(size);
-    desc->setMipmapLevelCount(mipLevels);
-    desc->setUsage(MTL::TextureUsageShaderRead);
-    desc->setStorageMode(MTL::StorageModeShared);
-    MTL::Texture* texture = device->newTexture(desc);
-    desc->release();
-    if (!texture) {
-        return nullptr;
-    }
-
-    for (uint32_t mip = 0; mip < mipLevels; ++mip) {
-        const uint32_t mipSize = std::max(1u, size >> mip);
-        const size_t bytesPerRow = static_cast<size_t>(mipSize) * kRGBA16FPixelBytes;
-        const size_t bytesPerImage = bytesPerRow * mipSize;
-        std::vector<uint8_t> faceData(bytesPerImage);
-        MTL::Region region = MTL::Region::Make2D(0, 0, mipSize, mipSize);
-
-        for (uint32_t face = 0; face < 6; ++face) {
-            if (!ReadExact(stream, faceData.data(), faceData.size())) {
-                texture->release();
-                return nullptr;
-            }
-            texture->replaceRegion(region,
-                                   static_cast<NS::UInteger>(mip),
-                                   static_cast<NS::UInteger>(face),
-                                   faceData.data(),
-                                   static_cast<NS::UInteger>(bytesPerRow),
-                                   static_cast<NS::UInteger>(bytesPerImage));
-        }
-    }
-
-    return texture;
-}
-
-bool WriteCookedEnvironmentBlob(const std::string& outputPath,
-                                MTL::Texture* cubemap,
-                                MTL::Texture* prefiltered,
-                                MTL::Texture* irradiance) {
-    if (!cubemap || !prefiltered || !irradiance) {
-        return false;
-    }
-
-    std::filesystem::path output(outputPath);
-    std::error_code ec;
-    std::filesystem::create_directories(output.parent_path(), ec);
-
-    std::ofstream stream(output, std::ios::binary | std::ios::trunc);
-    if (!stream.is_open()) {
-        return false;
-    }
-
-    CookedEnvironmentHeader header{
-        {'C', 'E', 'N', 'V'},
-        kCookedEnvironmentVersion,
-        static_cast<uint32_t>(cubemap->width()),
-        static_cast<uint32_t>(cubemap->mipmapLevelCount()),
-        static_cast<uint32_t>(prefiltered->width()),
-        static_cast<uint32_t>(prefiltered->mipmapLevelCount()),
-        static_cast<uint32_t>(irradiance->width()),
-        static_cast<uint32_t>(irradiance->mipmapLevelCount())
-    };
-
-    return WriteExact(stream, &header, sizeof(header)) &&
-           WriteCubeTexture(stream, cubemap) &&
-           WriteCubeTexture(stream, prefiltered) &&
-           WriteCubeTexture(stream, irradiance) &&
-           stream.good();
-}
-
-bool LoadCookedEnvironmentBlob(const std::string& cookedPath,
-                               MTL::Device* device,
-                               MTL::Texture*& outCubemap,
-                               MTL::Texture*& outPrefiltered,
-                               MTL::Texture*& outIrradiance) {
-    std::ifstream stream(cookedPath, std::ios::binary);
-    if (!stream.is_open()) {
-        return false;
-    }
-
-    CookedEnvironmentHeader header{};
-    if (!ReadExact(stream, &header, sizeof(header))) {
-        return false;
-    }
-    if (std::memcmp(header.magic, "CENV", 4) != 0 || header.version != kCookedEnvironmentVersion) {
-        return false;
-    }
-
-    MTL::Texture* cubemap = ReadCubeTexture(stream, device, header.cubemapSize, header.cubemapMipLevels);
-    MTL::Texture* prefiltered = ReadCubeTexture(stream, device, header.prefilteredSize, header.prefilteredMipLevels);
-    MTL::Texture* irradiance = ReadCubeTexture(stream, device, header.irradianceSize, header.irradianceMipLevels);
-    if (!cubemap || !prefiltered || !irradiance) {
-        if (cubemap) cubemap->release();
-        if (prefiltered) prefiltered->release();
-        if (irradiance) irradiance->release();
-        return false;
-    }
-
-    outCubemap = cubemap;
-    outPrefiltered = prefiltered;
-    outIrradiance = irradiance;
-    return true;
-}
 } // namespace
 
 // Uniform structures matching Metal shader
@@ -405,29 +563,31 @@ struct CameraUniforms {
 };
 
 struct SSAOParamsGPU {
-    float radius;
-    float bias;
-    float intensity;
-    float power;
-    Math::Vector2 noiseScale;
-    Math::Vector2 texelSize;
+    Math::Vector4 settings;   // radius, intensity, power, frame index
+    Math::Vector4 resolution; // full-res pixels per SSAO pixel xy, unused zw
 };
 
-struct SSAOBlurParamsGPU {
-    Math::Vector2 texelSize;
-    float depthSharpness;
-    float normalSharpness;
+struct SSAOTemporalParamsGPU {
+    Math::Matrix4x4 prevViewProjection;
+    Math::Vector4 params0; // feedback, historyValid, useVelocity, depth rejection
+};
+
+struct SSAOUpsampleParamsGPU {
+    Math::Vector4 params0; // full-res pixels per SSAO pixel xy, depth sharpness, unused
 };
 
 struct SSRParamsGPU {
-    Math::Vector4 settings0; // texelSize.xy, thickness, maxSteps
+    Math::Matrix4x4 prevViewProjection;
+    Math::Vector4 settings0; // texelSize.xy, thickness, maxIterations
     Math::Vector4 settings1; // maxDistance, maxRoughness, fadeStart, fadeEnd
+    Math::Vector4 settings2; // frameIndex, hizMipCount, historyValid, feedback
+    Math::Vector4 settings3; // useVelocity, padding, padding, padding
 };
 
 struct DecalParamsGPU {
     Math::Vector4 colorOpacity;   // rgb + opacity
     Math::Vector4 uvTilingOffset; // xy tiling, zw offset
-    Math::Vector4 edgeParams;     // softness, padding
+    Math::Vector4 edgeParams;     // softness, 1 / viewport width, 1 / viewport height, padding
     Math::Vector4 mapFlags;       // hasAlbedo, hasNormal, hasOrm, hasMask
     Math::Matrix4x4 modelMatrix;
     Math::Matrix4x4 invModel;
@@ -446,6 +606,28 @@ struct BloomDownsampleParamsGPU {
     float pad1;
 };
 
+struct BloomDownsampleSPDParamsGPU {
+    float threshold;
+    float knee;
+    uint32_t mipCount;
+    uint32_t pad0;
+};
+
+struct HZBSpdParamsGPU {
+    uint32_t mipCount;
+    uint32_t groupCount;
+    uint32_t pad0;
+    uint32_t pad1;
+};
+
+// hzb_spd: 64x64 depth texels per threadgroup, and the last group reduces at most 64x64 of their
+// mip 6 texels, so one dispatch covers depth up to 4096 a side.
+static constexpr uint32_t kHzbSpdTile = 64;
+static constexpr uint32_t kHzbSpdMaxGroups = 64;
+static constexpr uint32_t kHzbSpdMaxMips = 15;
+static constexpr uint32_t kBloomSpdTile = 32;
+static constexpr uint32_t kBloomSpdMaxMips = 6;
+
 struct BloomUpsampleParamsGPU {
     Math::Vector2 texelSize;
     float radius;
@@ -492,12 +674,19 @@ struct FogParamsGPU {
     Math::Vector4 shadowParams;    // shadowIndex, cascadeCount, enabled, strength
     Math::Matrix4x4 prevViewProjection;
     Math::Matrix4x4 prevViewMatrix;
+    Math::Vector4 updateParams;    // froxel interleave (1, 2 or 4), refresh phase, padding, padding
 };
 
 struct VelocityUniformsGPU {
     Math::Matrix4x4 prevModelMatrix;
+    Math::Matrix4x4 prevViewProjection;
+};
+
+struct VelocityReconstructParamsGPU {
+    Math::Matrix4x4 inverseViewProjection;
     Math::Matrix4x4 currViewProjection;
     Math::Matrix4x4 prevViewProjection;
+    Math::Vector4 texelSize;
 };
 
 struct MaterialUniformsGPU {
@@ -507,7 +696,7 @@ struct MaterialUniformsGPU {
     Math::Vector4 uvTilingOffset;  // 16 bytes (tiling.xy, offset.xy)
     Math::Vector4 textureFlags;    // 16 bytes (albedo, normal, metallic, roughness)
     Math::Vector4 textureFlags2;   // 16 bytes (ao, emission, height, invertHeight)
-    Math::Vector4 textureFlags3;   // 16 bytes (packedORM, alphaClip, alphaCutoff, unused)
+    Math::Vector4 textureFlags3;   // 16 bytes (packedORM, alphaClip, alphaCutoff, normalLengthInAlpha)
     Math::Vector4 heightParams;    // 16 bytes (scale, minLayers, maxLayers, receiveShadows)
     Math::Vector4 foliageParams0;  // 16 bytes (windStrength, windSpeed, windScale, windGust)
     Math::Vector4 foliageParams1;  // 16 bytes (lodStart, lodEnd, billboardStart, billboardEnd)
@@ -515,7 +704,7 @@ struct MaterialUniformsGPU {
     Math::Vector4 foliageParams3;  // 16 bytes (windDir.xyz, padding)
     Math::Vector4 impostorParams0; // 16 bytes (enabled, rows, cols, padding)
     Math::Vector4 terrainParams0;  // 16 bytes (enabled, blendSharpness, heightStart, heightEnd)
-    Math::Vector4 terrainParams1;  // 16 bytes (slopeStart, slopeEnd, unused, unused)
+    Math::Vector4 terrainParams1;  // 16 bytes (slopeStart, slopeEnd, virtual texture slot, unused)
     Math::Vector4 terrainLayer0ST; // 16 bytes (tiling.xy, unused)
     Math::Vector4 terrainLayer1ST; // 16 bytes (tiling.xy, unused)
     Math::Vector4 terrainLayer2ST; // 16 bytes (tiling.xy, unused)
@@ -536,25 +725,11 @@ struct ProbeVolumeUniformsGPU {
     Math::Vector4 featureParams;
     Math::Vector4 blendParams;
     Math::Vector4 reflectionParams;
+    Math::Vector4 dynamicReflectionParams;
+    Math::Vector4 dynamicReflections[8];
 };
-
-struct ProbeAmbientCubeDataGPU {
-    Math::Vector4 px;
-    Math::Vector4 nx;
-    Math::Vector4 py;
-    Math::Vector4 ny;
-    Math::Vector4 pz;
-    Math::Vector4 nz;
-    Math::Vector4 specularPx;
-    Math::Vector4 specularNx;
-    Math::Vector4 specularPy;
-    Math::Vector4 specularNy;
-    Math::Vector4 specularPz;
-    Math::Vector4 specularNz;
-    Math::Vector4 positionAndValidity;
-    Math::Vector4 visibility0;
-    Math::Vector4 visibility1;
-};
+// The static scene bindings hold these in the 256 bytes ahead of their zeroed block.
+static_assert(sizeof(ProbeVolumeUniformsGPU) <= 256, "ProbeVolumeUniformsGPU outgrew its static binding slot");
 
 struct LightDataGPU {
     Math::Vector4 direction;       // 16 bytes (direction.xyz, intensity)
@@ -566,7 +741,7 @@ struct EnvironmentUniformsGPU {
     Math::Vector4 ambientColorIntensity; // ambient color rgb, ambient intensity
     Math::Vector4 colorControl;      // tint rgb, saturation
     Math::Vector4 toneControl;       // contrast, unused, skyboxVisible flag, padding
-    Math::Vector4 skyParams;         // skyMode, shadowDebugMode, reserved
+    Math::Vector4 skyParams;         // skyMode, shadowDebugMode, raw environment flag, sky-view LUT flag
     Math::Vector4 rot0;
     Math::Vector4 rot1;
     Math::Vector4 rot2;
@@ -598,10 +773,11 @@ struct InstanceCullParams {
     uint32_t inputOffset;
     uint32_t outputOffset;
     uint32_t instanceCount;
-    uint32_t _pad;
+    float lodMaxDistance;
     Math::Vector2 screenSize;
     uint32_t hzbMipCount;
     uint32_t _pad2;
+    Math::Vector4 lodCamera;
 };
 
 struct DrawIndexedIndirectArgs {
@@ -612,36 +788,309 @@ struct DrawIndexedIndirectArgs {
     uint32_t baseInstance;
 };
 
-static std::array<Math::Vector4, 6> ExtractFrustumPlanes(const Math::Matrix4x4& m) {
-    auto row = [&](int r) {
-        return Math::Vector4(m(r, 0), m(r, 1), m(r, 2), m(r, 3));
-    };
-    Math::Vector4 r0 = row(0);
-    Math::Vector4 r1 = row(1);
-    Math::Vector4 r2 = row(2);
-    Math::Vector4 r3 = row(3);
-
-    std::array<Math::Vector4, 6> planes = {
-        r3 + r0, // left
-        r3 - r0, // right
-        r3 + r1, // bottom
-        r3 - r1, // top
-        r3 + r2, // near
-        r3 - r2  // far
-    };
-    for (auto& p : planes) {
-        float len = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
-        if (len > 0.0f) {
-            p.x /= len;
-            p.y /= len;
-            p.z /= len;
-            p.w /= len;
-        }
+struct StaticBatchGPU {
+    Math::Vector4 boundsCenterRadius;
+    uint32_t inputOffset;
+    uint32_t instanceCount;
+    uint32_t outputOffset;
+    uint32_t indexCount;
+    uint64_t vertices;
+    uint64_t attributes;
+    uint64_t indices;
+    uint64_t material;
+    uint64_t mesh;
+    uint32_t meshletCount;
+    uint32_t lodCount;
+    Math::Vector4 lodErrors; // mesh-space error of levels 1-4
+};
+static_assert(sizeof(StaticBatchGPU) == 96, "StaticBatchGPU must match StaticBatchData in Common.metal.h");
+
+struct StaticFrameBindingsGPU {
+    uint64_t culledInstances;
+    uint64_t camera;
+    uint64_t light;
+    uint64_t environment;
+    uint64_t lights;
+    uint64_t shadows;
+    uint64_t lightCount;
+    uint64_t clusterHeaders;
+    uint64_t clusterIndices;
+    uint64_t clusterParams;
+    uint64_t probeVolume;
+    uint64_t probeData;
+};
+
+struct StaticCullParamsGPU {
+    Math::Vector4 frustumPlanes[6];
+    Math::Vector2 screenSize;
+    uint32_t instanceCount;
+    uint32_t hzbMipCount;
+    uint32_t batchCount;
+    uint32_t encodePrepass;
+    float lodPixelError;
+    uint32_t _pad;
+    Math::Vector4 lodView; // camera position, pixels per world unit at distance 1
+};
+static_assert(sizeof(StaticCullParamsGPU) == 144, "StaticCullParamsGPU must match StaticCullParams in Common.metal.h");
+
+struct OcclusionCullParamsGPU {
+    Math::Vector2 screenSize;
+    uint32_t candidateCount;
+    uint32_t hzbMipCount;
+    uint32_t argOffset;
+    uint32_t argCount;
+    uint32_t _pad0;
+    uint32_t _pad1;
+};
+static_assert(sizeof(OcclusionCullParamsGPU) == 32, "OcclusionCullParamsGPU must match OcclusionCullParams in Common.metal.h");
+
+struct MeshletCullParamsGPU {
+    Math::Vector4 frustumPlanes[6];
+    Math::Vector2 screenSize;
+    uint32_t meshletCount;
+    uint32_t hzbMipCount;
+    uint32_t useHzb;
+    uint32_t coneCulling;
+    uint32_t _pad0;
+    uint32_t _pad1;
+};
+static_assert(sizeof(MeshletCullParamsGPU) == 128, "MeshletCullParamsGPU must match MeshletCullParams in Common.metal.h");
+
+struct VisibilityShadeParamsGPU {
+    Math::Vector2 screenSize;
+    uint32_t tilesX;
+    uint32_t batchCount;
+    uint32_t firstBatch;
+    uint32_t batchRange;
+    uint32_t _pad0;
+    uint32_t _pad1;
+};
+static_assert(sizeof(VisibilityShadeParamsGPU) == 32, "VisibilityShadeParamsGPU must match VisibilityShadeParams in Common.metal.h");
+
+// Must match VISIBILITY_TILE_SIZE in PBR.metal; visibility_classify covers a tile with 16x16
+// threads of 2x2 pixels each.
+static constexpr uint32_t kVisibilityTileSize = 32;
+
+// Must match MESHLETS_PER_OBJECT / MESHLET_MESH_THREADS in PBR.metal.
+static constexpr uint32_t kMeshletsPerObjectThreadgroup = 32;
+static constexpr uint32_t kMeshletMeshThreads = 128;
+
+// Layout of StaticSceneFrame::batches: the batch table, then a kStaticUniformStride block per
+// batch holding its material uniforms and, at kStaticMeshUniformOffset, its mesh uniforms.
+static constexpr size_t kStaticUniformStride = 512;
+static constexpr size_t kStaticMeshUniformOffset = 384;
+static_assert(sizeof(MaterialUniformsGPU) <= kStaticMeshUniformOffset, "static material uniforms overlap mesh uniforms");
+static_assert(kStaticMeshUniformOffset + sizeof(MeshUniformsGPU) <= kStaticUniformStride, "static uniform stride too small");
+static_assert(sizeof(MaterialUniformsGPU) <= MaterialTable::kUniformBytes, "material uniforms overlap the table's texture handles");
+
+static size_t StaticBatchTableBytes(size_t batchCount) {
+    return (batchCount * sizeof(StaticBatchGPU) + 255) & ~size_t(255);
+}
+
+// Same packing the per-draw paths do inline; used where uniforms are written into GPU buffers.
+static MaterialUniformsGPU BuildMaterialUniforms(const Material* material, bool receiveShadows) {
+    MaterialUniformsGPU matUniforms{};
+    if (material) {
+        matUniforms.albedo = material->getAlbedo();
+        matUniforms.properties = Math::Vector4(
+            material->getMetallic(),
+            material->getRoughness(),
+            material->getAO(),
+            material->getNormalScale()
+        );
+        Math::Vector3 emis = material->getEmission();
+        matUniforms.emission = Math::Vector4(
+            emis.x, emis.y, emis.z,
+            material->getEmissionStrength()
+        );
+        Math::Vector2 tiling = material->getUVTiling();
+        Math::Vector2 offset = material->getUVOffset();
+        matUniforms.uvTilingOffset = Math::Vector4(tiling.x, tiling.y, offset.x, offset.y);
+
+        bool hasRoughnessTex = material->getRoughnessTexture() != nullptr;
+        bool hasORMTex = material->getORMTexture() != nullptr;
+        bool hasMetallicTex = material->getMetallicTexture() != nullptr;
+        if (hasORMTex) {
+            const auto& ormTex = material->getORMTexture();
+            if (material->getMetallicTexture() == ormTex) {
+                hasMetallicTex = false;
+            }
+            if (material->getRoughnessTexture() == ormTex) {
+                hasRoughnessTex = false;
+            }
+        }
+        bool hasTerrainControlTex = material->getTerrainControlTexture() != nullptr;
+        bool hasTerrainLayer0Tex = material->getTerrainLayer0Texture() != nullptr;
+        bool hasTerrainLayer1Tex = material->getTerrainLayer1Texture() != nullptr;
+        bool hasTerrainLayer2Tex = material->getTerrainLayer2Texture() != nullptr;
+        matUniforms.textureFlags = Math::Vector4(
+            material->getAlbedoTexture() ? 1.0f : 0.0f,
+            material->getNormalTexture() ? 1.0f : 0.0f,
+            hasMetallicTex ? 1.0f : 0.0f,
+            hasRoughnessTex ? 1.0f : 0.0f
+        );
+        matUniforms.textureFlags2 = Math::Vector4(
+            material->getAOTexture() ? 1.0f : 0.0f,
+            material->getEmissionTexture() ? 1.0f : 0.0f,
+            material->getHeightTexture() ? 1.0f : 0.0f,
+            material->getHeightInvert() ? 1.0f : 0.0f
+        );
+        bool alphaClip = material->getRenderMode() == Material::RenderMode::Cutout;
+        float alphaCutoff = material->getAlphaCutoff();
+        const auto& normalMapTex = material->getNormalTexture();
+        bool normalLengthInAlpha = normalMapTex && normalMapTex->hasNormalLengthInAlpha();
+        matUniforms.textureFlags3 = Math::Vector4(
+            hasORMTex ? 1.0f : 0.0f,
+            alphaClip ? 1.0f : 0.0f,
+            alphaCutoff,
+            normalLengthInAlpha ? 1.0f : 0.0f
+        );
+        matUniforms.heightParams = Math::Vector4(
+            material->getHeightScale(),
+            24.0f,
+            96.0f,
+            receiveShadows ? 1.0f : 0.0f
+        );
+        Math::Vector3 windDir = material->getWindDirection();
+        matUniforms.foliageParams0 = Math::Vector4(
+            material->getWindStrength(),
+            material->getWindSpeed(),
+            material->getWindScale(),
+            material->getWindGust()
+        );
+        matUniforms.foliageParams1 = Math::Vector4(
+            material->getLodFadeStart(),
+            material->getLodFadeEnd(),
+            material->getBillboardStart(),
+            material->getBillboardEnd()
+        );
+        matUniforms.foliageParams2 = Math::Vector4(
+            material->getWindEnabled() ? 1.0f : 0.0f,
+            material->getLodFadeEnabled() ? 1.0f : 0.0f,
+            material->getBillboardEnabled() ? 1.0f : 0.0f,
+            material->getDitherEnabled() ? 1.0f : 0.0f
+        );
+        matUniforms.foliageParams3 = Math::Vector4(
+            windDir.x, windDir.y, windDir.z, 0.0f
+        );
+        matUniforms.impostorParams0 = Math::Vector4(
+            material->getImpostorEnabled() ? 1.0f : 0.0f,
+            static_cast<float>(material->getImpostorRows()),
+            static_cast<float>(material->getImpostorCols()),
+            0.0f
+        );
+        matUniforms.terrainParams0 = Math::Vector4(
+            material->getTerrainEnabled() ? 1.0f : 0.0f,
+            material->getTerrainBlendSharpness(),
+            material->getTerrainHeightStart(),
+            material->getTerrainHeightEnd()
+        );
+        matUniforms.terrainParams1 = Math::Vector4(
+            material->getTerrainSlopeStart(),
+            material->getTerrainSlopeEnd(),
+            0.0f,
+            0.0f
+        );
+        Math::Vector2 terrain0ST = material->getTerrainLayer0Tiling();
+        Math::Vector2 terrain1ST = material->getTerrainLayer1Tiling();
+        Math::Vector2 terrain2ST = material->getTerrainLayer2Tiling();
+        matUniforms.terrainLayer0ST = Math::Vector4(terrain0ST.x, terrain0ST.y, 0.0f, 0.0f);
+        matUniforms.terrainLayer1ST = Math::Vector4(terrain1ST.x, terrain1ST.y, 0.0f, 0.0f);
+        matUniforms.terrainLayer2ST = Math::Vector4(terrain2ST.x, terrain2ST.y, 0.0f, 0.0f);
+        matUniforms.terrainFlags = Math::Vector4(
+            hasTerrainControlTex ? 1.0f : 0.0f,
+            hasTerrainLayer0Tex ? 1.0f : 0.0f,
+            hasTerrainLayer1Tex ? 1.0f : 0.0f,
+            hasTerrainLayer2Tex ? 1.0f : 0.0f
+        );
+    } else {
+        matUniforms.albedo = Math::Vector4(1.0f);
+        matUniforms.properties = Math::Vector4(0.0f, 1.0f, 1.0f, 1.0f);
+        matUniforms.emission = Math::Vector4(0.0f);
+        matUniforms.uvTilingOffset = Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
+        matUniforms.textureFlags = Math::Vector4(0.0f);
+        matUniforms.textureFlags2 = Math::Vector4(0.0f);
+        matUniforms.textureFlags3 = Math::Vector4(0.0f);
+        matUniforms.heightParams = Math::Vector4(0.0f);
+        matUniforms.foliageParams0 = Math::Vector4(0.0f);
+        matUniforms.foliageParams1 = Math::Vector4(0.0f);
+        matUniforms.foliageParams2 = Math::Vector4(0.0f);
+        matUniforms.foliageParams3 = Math::Vector4(0.0f);
+        matUniforms.impostorParams0 = Math::Vector4(0.0f);
+        matUniforms.terrainParams0 = Math::Vector4(0.0f);
+        matUniforms.terrainParams1 = Math::Vector4(0.0f);
+        matUniforms.terrainLayer0ST = Math::Vector4(0.0f);
+        matUniforms.terrainLayer1ST = Math::Vector4(0.0f);
+        matUniforms.terrainLayer2ST = Math::Vector4(0.0f);
+        matUniforms.terrainFlags = Math::Vector4(0.0f);
+    }
+    return matUniforms;
+}
+
+static MTL::CullMode ResolveCullMode(const Material* material) {
+    if (!material) {
+        return MTL::CullModeBack;
+    }
+    if (material->isTwoSided() || material->getCullMode() == Material::CullMode::Off) {
+        return MTL::CullModeNone;
     }
-    return planes;
+    if (material->getCullMode() == Material::CullMode::Front) {
+        return MTL::CullModeFront;
+    }
+    return MTL::CullModeBack;
+}
+
+// fragment_main features the material can reach (see PbrFeature); decals and probes come from
+// the scene.
+static uint8_t ResolvePbrMaterialFeatures(const Material* material, bool hasStaticLighting) {
+    uint8_t features = hasStaticLighting ? kPbrFeatureStaticLighting : 0;
+    if (!material) {
+        return features;
+    }
+    if (material->getTerrainEnabled() && (material->getTerrainLayer0Texture() || material->getTerrainLayer1Texture()
+                                          || material->getTerrainLayer2Texture())) {
+        features |= kPbrFeatureTerrain;
+    }
+    if (material->getHeightTexture()) {
+        features |= kPbrFeatureParallax;
+    }
+    if (material->getNormalTexture() || material->getMetallicTexture() || material->getRoughnessTexture()
+        || material->getAOTexture() || material->getORMTexture() || material->getEmissionTexture()) {
+        features |= kPbrFeatureSurfaceMaps;
+    }
+    if (material->getRenderMode() == Material::RenderMode::Cutout || material->getDitherEnabled()) {
+        features |= kPbrFeatureAlphaDiscard;
+    }
+    return features;
+}
+
+// Main pass pipeline of a MeshRenderer draw; shared with the pipeline archive cook so it records
+// exactly the keys the gather asks for.
+static PipelineStateKey ResolveMeshPipelineKey(const Material* material,
+                                               bool isSkinned,
+                                               bool hasStaticLighting,
+                                               uint8_t scenePbrFeatures,
+                                               bool hdrTarget,
+                                               uint8_t sampleCount,
+                                               bool materialTable) {
+    bool isTransparent = false;
+    if (material) {
+        isTransparent = material->getRenderMode() == Material::RenderMode::Transparent
+            || material->getAlpha() < 0.999f;
+    }
+    bool alphaToCoverage = material && material->getRenderMode() == Material::RenderMode::Cutout
+        && material->getAlphaToCoverage();
+    PipelineStateKey key{true, true, true, isTransparent, isSkinned, false, alphaToCoverage, hdrTarget, sampleCount};
+    key.pbrFeatures = ResolvePbrMaterialFeatures(material, hasStaticLighting) | scenePbrFeatures;
+    key.materialTable = materialTable;
+    return key;
 }
 
 static constexpr float kCullTightness = 0.85f;
+// Growth of a crowd mesh's bind pose bounds that animated poses are assumed to stay within.
+static constexpr float kCrowdBoundsScale = 1.25f;
+// Screen-space geometric error a mesh LOD may introduce at lodBias 0.
+static constexpr float kLodPixelError = 1.0f;
 
 static uint8_t CascadesForShadowQuality(int quality) {
     switch (quality) {
@@ -661,28 +1110,55 @@ static uint32_t ComputeShadowAtlasResolution(uint32_t requestedResolution, uint8
     return std::min<uint32_t>(8192u, std::max(base, doubled));
 }
 
-static bool IsSphereInFrustum(const std::array<Math::Vector4, 6>& planes,
-                              const Math::Vector3& center,
-                              float radius) {
-    for (const auto& p : planes) {
-        float dist = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
-        if (dist < -radius) {
-            return false;
-        }
+// Resident bytes the mip-streamed textures may hold per texture quality; Ultra is unbounded.
+static uint64_t TextureStreamingBudget(int textureQuality) {
+    switch (textureQuality) {
+    case 0: return 256ull << 20;
+    case 1: return 512ull << 20;
+    case 2: return 1024ull << 20;
+    default: return 0;
     }
-    return true;
 }
 
-static bool SphereInFrustum(const std::array<Math::Vector4, 6>& planes,
-                            const Math::Vector3& center,
-                            float radius) {
-    for (const auto& p : planes) {
-        float d = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
-        if (d < -radius) {
-            return false;
+// Reports the texel resolution a mesh's material textures need in this view (TextureStreamer):
+// lodView.w over the distance to the bounding sphere gives pixels per world unit, and the mesh's
+// UV density over its largest scale, times the material tiling, gives UV units per world unit.
+static void RequestMaterialTextureResolutions(TextureStreamer& streamer,
+                                              MeshRenderer* meshRenderer,
+                                              Mesh* mesh,
+                                              const Math::Matrix4x4& worldMatrix,
+                                              const Math::Vector4& sphere,
+                                              const Math::Vector4& lodView) {
+    const float uvDensity = mesh->getUVDensity();
+    if (uvDensity <= 0.0f || lodView.w <= 0.0f) {
+        return;
+    }
+    const float distance = std::max((Math::Vector3(sphere.x, sphere.y, sphere.z) -
+                                     Math::Vector3(lodView.x, lodView.y, lodView.z)).length() - sphere.w, 1e-3f);
+    const float scaleX = Math::Vector3(worldMatrix(0, 0), worldMatrix(1, 0), worldMatrix(2, 0)).length();
+    const float scaleY = Math::Vector3(worldMatrix(0, 1), worldMatrix(1, 1), worldMatrix(2, 1)).length();
+    const float scaleZ = Math::Vector3(worldMatrix(0, 2), worldMatrix(1, 2), worldMatrix(2, 2)).length();
+    const float maxScale = std::max(scaleX, std::max(scaleY, scaleZ));
+    for (const auto& material : meshRenderer->getMaterials()) {
+        if (!material) {
+            continue;
+        }
+        const Math::Vector2& tiling = material->getUVTiling();
+        const float uvPerUnit = uvDensity * std::max(std::abs(tiling.x), std::abs(tiling.y)) / std::max(maxScale, 1e-6f);
+        if (uvPerUnit <= 0.0f) {
+            continue;
         }
+        const float resolution = lodView.w / distance / uvPerUnit;
+        streamer.requestResolution(material->getAlbedoTexture(), resolution);
+        streamer.requestResolution(material->getNormalTexture(), resolution);
+        streamer.requestResolution(material->getMetallicTexture(), resolution);
+        streamer.requestResolution(material->getRoughnessTexture(), resolution);
+        streamer.requestResolution(material->getAOTexture(), resolution);
+        streamer.requestResolution(material->getEmissionTexture(), resolution);
+        streamer.requestResolution(material->getORMTexture(), resolution);
+        streamer.requestResolution(material->getHeightTexture(), resolution);
+        streamer.requestResolution(material->getOpacityTexture(), resolution);
     }
-    return true;
 }
 
 void Renderer::updateProbeVolume(const SceneStaticLightingSettings& staticLighting) {
@@ -692,6 +1168,7 @@ void Renderer::updateProbeVolume(const SceneStaticLightingSettings& staticLighti
             m_probeVolumeBuffer = nullptr;
         }
         m_probeVolumePath.clear();
+        resetProbeBrickStreaming();
         m_probeVolumeBoundsMin = Math::Vector4::Zero;
         m_probeVolumeBoundsMax = Math::Vector4::Zero;
         m_probeVolumeGridCounts = Math::Vector4::Zero;
@@ -719,6 +1196,13 @@ void Renderer::updateProbeVolume(const SceneStaticLightingSettings& staticLighti
         0.0f
     );
 
+    if (m_device && staticLighting.probeVolume && staticLighting.dynamicProbes &&
+        m_dynamicProbeGI && m_dynamicProbeGI->isAvailable()) {
+        updateDynamicProbeVolume(staticLighting);
+        return;
+    }
+    m_probeVolumeDynamic = false;
+
     if (!m_device || !staticLighting.probeVolume || staticLighting.probeDataPath.empty()) {
         clearProbeVolume();
         return;
@@ -728,99 +1212,68 @@ void Renderer::updateProbeVolume(const SceneStaticLightingSettings& staticLighti
         return;
     }
 
-    struct ProbeVolumeFileHeader {
-        char magic[4];
-        uint32_t version;
-        uint32_t countX;
-        uint32_t countY;
-        uint32_t countZ;
-        float boundsMin[3];
-        float boundsMax[3];
-    };
-    struct ProbeVolumeFileRecord {
-        float ambientCube[6][4];
-        float specularCube[6][4];
-        float positionAndValidity[4];
-        float visibility[2][4];
-    };
-
     std::filesystem::path probePath(staticLighting.probeDataPath);
     if (probePath.is_relative()) {
         probePath = std::filesystem::current_path() / probePath;
     }
 
-    std::ifstream stream(probePath, std::ios::binary);
-    if (!stream.is_open()) {
-        clearProbeVolume();
-        return;
-    }
-
-    ProbeVolumeFileHeader header{};
-    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
-    if (!stream.good() ||
-        header.magic[0] != 'C' ||
-        header.magic[1] != 'P' ||
-        header.magic[2] != 'R' ||
-        header.magic[3] != 'B' ||
-        header.version != 3u) {
+    ProbeVolumeBricks bricks;
+    if (!ReadProbeVolumeFile(probePath.string(), bricks)) {
         clearProbeVolume();
         return;
     }
 
-    size_t probeCount = static_cast<size_t>(header.countX) * static_cast<size_t>(header.countY) * static_cast<size_t>(header.countZ);
-    if (probeCount == 0u) {
+    // Buffer layout: the cell indirection table padded to whole records, the coarse grid, then a
+    // pool of dense brick slots that streamProbeBricks fills around the camera.
+    const size_t cellCount = bricks.cellCount();
+    const size_t denseBrickCount = bricks.denseBrickCount();
+    const size_t budget = static_cast<size_t>(std::max(0, staticLighting.probeStreamingBrickBudget));
+    const size_t slotCount = std::min(denseBrickCount, budget);
+    const size_t indirectionRecords = (cellCount * sizeof(uint32_t) + sizeof(PackedProbeRecord) - 1) / sizeof(PackedProbeRecord);
+    const size_t poolOffset = indirectionRecords + bricks.coarseProbes.size();
+    const size_t totalRecords = poolOffset + slotCount * kProbeBrickDenseProbes;
+    if (totalRecords >= kProbeBrickDenseBit) {
         clearProbeVolume();
         return;
     }
 
-    std::vector<ProbeAmbientCubeDataGPU> probes(probeCount);
-    for (size_t index = 0; index < probeCount; ++index) {
-        ProbeVolumeFileRecord record{};
-        stream.read(reinterpret_cast<char*>(&record), sizeof(record));
-        if (!stream.good()) {
-            clearProbeVolume();
-            return;
-        }
-        probes[index].px = Math::Vector4(record.ambientCube[0][0], record.ambientCube[0][1], record.ambientCube[0][2], record.ambientCube[0][3]);
-        probes[index].nx = Math::Vector4(record.ambientCube[1][0], record.ambientCube[1][1], record.ambientCube[1][2], record.ambientCube[1][3]);
-        probes[index].py = Math::Vector4(record.ambientCube[2][0], record.ambientCube[2][1], record.ambientCube[2][2], record.ambientCube[2][3]);
-        probes[index].ny = Math::Vector4(record.ambientCube[3][0], record.ambientCube[3][1], record.ambientCube[3][2], record.ambientCube[3][3]);
-        probes[index].pz = Math::Vector4(record.ambientCube[4][0], record.ambientCube[4][1], record.ambientCube[4][2], record.ambientCube[4][3]);
-        probes[index].nz = Math::Vector4(record.ambientCube[5][0], record.ambientCube[5][1], record.ambientCube[5][2], record.ambientCube[5][3]);
-        probes[index].specularPx = Math::Vector4(record.specularCube[0][0], record.specularCube[0][1], record.specularCube[0][2], record.specularCube[0][3]);
-        probes[index].specularNx = Math::Vector4(record.specularCube[1][0], record.specularCube[1][1], record.specularCube[1][2], record.specularCube[1][3]);
-        probes[index].specularPy = Math::Vector4(record.specularCube[2][0], record.specularCube[2][1], record.specularCube[2][2], record.specularCube[2][3]);
-        probes[index].specularNy = Math::Vector4(record.specularCube[3][0], record.specularCube[3][1], record.specularCube[3][2], record.specularCube[3][3]);
-        probes[index].specularPz = Math::Vector4(record.specularCube[4][0], record.specularCube[4][1], record.specularCube[4][2], record.specularCube[4][3]);
-        probes[index].specularNz = Math::Vector4(record.specularCube[5][0], record.specularCube[5][1], record.specularCube[5][2], record.specularCube[5][3]);
-        probes[index].positionAndValidity = Math::Vector4(record.positionAndValidity[0],
-                                                          record.positionAndValidity[1],
-                                                          record.positionAndValidity[2],
-                                                          record.positionAndValidity[3]);
-        probes[index].visibility0 = Math::Vector4(record.visibility[0][0],
-                                                  record.visibility[0][1],
-                                                  record.visibility[0][2],
-                                                  record.visibility[0][3]);
-        probes[index].visibility1 = Math::Vector4(record.visibility[1][0],
-                                                  record.visibility[1][1],
-                                                  record.visibility[1][2],
-                                                  record.visibility[1][3]);
-    }
-
+    resetProbeBrickStreaming();
     if (m_probeVolumeBuffer) {
         m_probeVolumeBuffer->release();
         m_probeVolumeBuffer = nullptr;
     }
-    m_probeVolumeBuffer = m_device->newBuffer(
-        probes.data(),
-        probes.size() * sizeof(ProbeAmbientCubeDataGPU),
-        MTL::ResourceStorageModeShared
-    );
+    m_probeVolumeBuffer = m_device->newBuffer(totalRecords * sizeof(PackedProbeRecord), MTL::ResourceStorageModeShared);
     if (!m_probeVolumeBuffer) {
         clearProbeVolume();
         return;
     }
 
+    auto* records = static_cast<PackedProbeRecord*>(m_probeVolumeBuffer->contents());
+    auto* indirection = reinterpret_cast<uint32_t*>(records);
+    std::memset(records, 0, indirectionRecords * sizeof(PackedProbeRecord));
+    std::memcpy(records + indirectionRecords, bricks.coarseProbes.data(),
+                bricks.coarseProbes.size() * sizeof(PackedProbeRecord));
+    std::fill(indirection, indirection + cellCount, static_cast<uint32_t>(indirectionRecords));
+
+    m_probeBricks = std::move(bricks);
+    m_probeBrickCoarseOffset = static_cast<uint32_t>(indirectionRecords);
+    m_probeBrickPoolOffset = static_cast<uint32_t>(poolOffset);
+    m_probeBrickSlotOfCell.assign(cellCount, kProbeBrickNone);
+    m_probeBrickCellOfSlot.assign(slotCount, kProbeBrickNone);
+    m_probeBrickSlotFreedFrame.assign(slotCount, m_frameIndex - kMaxFramesInFlight);
+    if (slotCount == denseBrickCount) {
+        // Everything fits the budget: no streaming, every dense brick stays resident.
+        uint32_t slot = 0;
+        for (size_t cell = 0; cell < cellCount; ++cell) {
+            if (m_probeBricks.denseBrickOfCell[cell] != kProbeBrickNone) {
+                loadProbeBrick(static_cast<uint32_t>(cell), slot++);
+            }
+        }
+        m_probeBricks.denseProbes.clear();
+        m_probeBricks.denseProbes.shrink_to_fit();
+    }
+
+    const ProbeVolumeFileHeader& header = m_probeBricks.header;
     m_probeVolumePath = probePath.lexically_normal().string();
     m_probeVolumeBoundsMin = Math::Vector4(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2], 0.0f);
     m_probeVolumeBoundsMax = Math::Vector4(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2], 0.0f);
@@ -832,11 +1285,198 @@ void Renderer::updateProbeVolume(const SceneStaticLightingSettings& staticLighti
     );
 }
 
-Renderer::Renderer()
-    : m_device(nullptr)
-    , m_commandQueue(nullptr)
-    , m_library(nullptr)
-    , m_metalLayer(nullptr)
+void Renderer::updateDynamicProbeVolume(const SceneStaticLightingSettings& staticLighting) {
+    // The grid is the coarse lattice of a brick volume with no dense bricks, so the main pass
+    // samples it like a baked one; DynamicProbeGI keeps its probes up to date.
+    const uint32_t latticeX = static_cast<uint32_t>(std::max(2, staticLighting.probeCountX));
+    const uint32_t latticeY = static_cast<uint32_t>(std::max(2, staticLighting.probeCountY));
+    const uint32_t latticeZ = static_cast<uint32_t>(std::max(2, staticLighting.probeCountZ));
+    const Math::Vector3 boundsMin = staticLighting.probeBoundsMin;
+    const Math::Vector3 boundsMax(std::max(staticLighting.probeBoundsMax.x, boundsMin.x + 0.01f),
+                                  std::max(staticLighting.probeBoundsMax.y, boundsMin.y + 0.01f),
+                                  std::max(staticLighting.probeBoundsMax.z, boundsMin.z + 0.01f));
+    std::ostringstream key;
+    key << "dynamic:" << latticeX << "x" << latticeY << "x" << latticeZ << ":"
+        << boundsMin.x << "," << boundsMin.y << "," << boundsMin.z << ":"
+        << boundsMax.x << "," << boundsMax.y << "," << boundsMax.z;
+    if (m_probeVolumeDynamic && m_probeVolumeBuffer && m_probeVolumePath == key.str()) {
+        return;
+    }
+
+    const size_t cellCount = static_cast<size_t>(latticeX - 1u) * (latticeY - 1u) * (latticeZ - 1u);
+    const size_t probeCount = static_cast<size_t>(latticeX) * latticeY * latticeZ;
+    const size_t indirectionRecords = (cellCount * sizeof(uint32_t) + sizeof(PackedProbeRecord) - 1) / sizeof(PackedProbeRecord);
+    resetProbeBrickStreaming();
+    if (m_probeVolumeBuffer) {
+        m_probeVolumeBuffer->release();
+        m_probeVolumeBuffer = nullptr;
+    }
+    m_probeVolumeDynamic = false;
+    m_probeVolumePath.clear();
+    m_probeVolumeBuffer = m_device->newBuffer((indirectionRecords + probeCount) * sizeof(PackedProbeRecord),
+                                              MTL::ResourceStorageModeShared);
+    if (!m_probeVolumeBuffer) {
+        m_probeVolumeGridCounts = Math::Vector4::Zero;
+        return;
+    }
+
+    auto* records = static_cast<PackedProbeRecord*>(m_probeVolumeBuffer->contents());
+    std::memset(records, 0, (indirectionRecords + probeCount) * sizeof(PackedProbeRecord));
+    auto* indirection = reinterpret_cast<uint32_t*>(records);
+    std::fill(indirection, indirection + cellCount, static_cast<uint32_t>(indirectionRecords));
+    const Math::Vector3 spacing((boundsMax.x - boundsMin.x) / static_cast<float>(latticeX - 1u),
+                                (boundsMax.y - boundsMin.y) / static_cast<float>(latticeY - 1u),
+                                (boundsMax.z - boundsMin.z) / static_cast<float>(latticeZ - 1u));
+    for (size_t index = 0; index < probeCount; ++index) {
+        PackedProbeRecord& probe = records[indirectionRecords + index];
+        probe.positionAndValidity[0] = boundsMin.x + spacing.x * static_cast<float>(index % latticeX);
+        probe.positionAndValidity[1] = boundsMin.y + spacing.y * static_cast<float>((index / latticeX) % latticeY);
+        probe.positionAndValidity[2] = boundsMin.z + spacing.z * static_cast<float>(index / (latticeX * latticeY));
+        probe.positionAndValidity[3] = 1.0f;
+    }
+
+    m_dynamicProbeGI->setGrid(boundsMin, boundsMax, latticeX, latticeY, latticeZ);
+    m_dynamicProbeFirstRecord = static_cast<uint32_t>(indirectionRecords);
+    m_probeVolumeDynamic = true;
+    m_probeVolumePath = key.str();
+    m_probeVolumeBoundsMin = Math::Vector4(boundsMin.x, boundsMin.y, boundsMin.z, 0.0f);
+    m_probeVolumeBoundsMax = Math::Vector4(boundsMax.x, boundsMax.y, boundsMax.z, 0.0f);
+    m_probeVolumeGridCounts = Math::Vector4(
+        static_cast<float>(latticeX - 1u),
+        static_cast<float>(latticeY - 1u),
+        static_cast<float>(latticeZ - 1u),
+        1.0f
+    );
+}
+
+void Renderer::resetProbeBrickStreaming() {
+    m_probeBricks = ProbeVolumeBricks{};
+    m_probeBrickSlotOfCell.clear();
+    m_probeBrickCellOfSlot.clear();
+    m_probeBrickSlotFreedFrame.clear();
+    m_probeBrickCoarseOffset = 0;
+    m_probeBrickPoolOffset = 0;
+    m_probeBrickStreamCell = kProbeBrickNone;
+    m_probeBrickStreamPending = false;
+}
+
+void Renderer::loadProbeBrick(uint32_t cell, uint32_t slot) {
+    auto* records = static_cast<PackedProbeRecord*>(m_probeVolumeBuffer->contents());
+    const uint32_t first = m_probeBrickPoolOffset + slot * kProbeBrickDenseProbes;
+    const size_t brick = m_probeBricks.denseBrickOfCell[cell];
+    std::memcpy(records + first, m_probeBricks.denseProbes.data() + brick * kProbeBrickDenseProbes,
+                kProbeBrickDenseProbes * sizeof(PackedProbeRecord));
+    // Probes first, then the entry: a frame already reading the table sees either brick whole.
+    reinterpret_cast<uint32_t*>(records)[cell] = first | kProbeBrickDenseBit;
+    m_probeBrickSlotOfCell[cell] = slot;
+    m_probeBrickCellOfSlot[slot] = cell;
+}
+
+void Renderer::fillProbeVolumeUniforms(ProbeVolumeUniformsGPU& uniforms) const {
+    uniforms.boundsMin = m_probeVolumeBoundsMin;
+    uniforms.boundsMax = m_probeVolumeBoundsMax;
+    uniforms.gridCounts = m_probeVolumeGridCounts;
+    uniforms.featureParams = m_probeVolumeFeatureParams;
+    uniforms.blendParams = m_probeVolumeBlendParams;
+    uniforms.reflectionParams = m_probeVolumeReflectionParams;
+    uniforms.dynamicReflectionParams = m_dynamicReflectionParams;
+    for (size_t i = 0; i < m_dynamicReflectionSlots.size(); ++i) {
+        uniforms.dynamicReflections[i] = m_dynamicReflectionSlots[i];
+    }
+}
+
+void Renderer::streamProbeBricks(const Math::Vector3& cameraPosition) {
+    // Only a volume with more dense bricks than slots streams; the rest loaded everything.
+    if (!m_probeVolumeBuffer || m_probeBricks.denseProbes.empty() || m_probeBrickCellOfSlot.empty()) {
+        return;
+    }
+
+    const ProbeVolumeFileHeader& header = m_probeBricks.header;
+    const Math::Vector3 boundsMin(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    const Math::Vector3 boundsMax(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    const Math::Vector3 cellSize(
+        std::max(boundsMax.x - boundsMin.x, 0.001f) / static_cast<float>(header.countX),
+        std::max(boundsMax.y - boundsMin.y, 0.001f) / static_cast<float>(header.countY),
+        std::max(boundsMax.z - boundsMin.z, 0.001f) / static_cast<float>(header.countZ));
+    auto axisCell = [](float position, float minimum, float size, uint32_t count) {
+        float cell = std::floor((position - minimum) / size);
+        return static_cast<uint32_t>(std::clamp(cell, 0.0f, static_cast<float>(count - 1)));
+    };
+    const uint32_t cameraCell = axisCell(cameraPosition.x, boundsMin.x, cellSize.x, header.countX)
+        + header.countX * (axisCell(cameraPosition.y, boundsMin.y, cellSize.y, header.countY)
+        + header.countY * axisCell(cameraPosition.z, boundsMin.z, cellSize.z, header.countZ));
+    if (cameraCell == m_probeBrickStreamCell && !m_probeBrickStreamPending) {
+        return;
+    }
+    m_probeBrickStreamCell = cameraCell;
+
+    // The slot budget goes to the dense bricks nearest the camera.
+    std::vector<std::pair<float, uint32_t>> wanted;
+    const size_t cellCount = m_probeBricks.cellCount();
+    for (size_t cell = 0; cell < cellCount; ++cell) {
+        if (m_probeBricks.denseBrickOfCell[cell] == kProbeBrickNone) {
+            continue;
+        }
+        uint32_t x = static_cast<uint32_t>(cell % header.countX);
+        uint32_t y = static_cast<uint32_t>((cell / header.countX) % header.countY);
+        uint32_t z = static_cast<uint32_t>(cell / (static_cast<size_t>(header.countX) * header.countY));
+        Math::Vector3 center(boundsMin.x + (static_cast<float>(x) + 0.5f) * cellSize.x,
+                             boundsMin.y + (static_cast<float>(y) + 0.5f) * cellSize.y,
+                             boundsMin.z + (static_cast<float>(z) + 0.5f) * cellSize.z);
+        wanted.emplace_back((center - cameraPosition).lengthSquared(), static_cast<uint32_t>(cell));
+    }
+    const size_t slotCount = m_probeBrickCellOfSlot.size();
+    if (wanted.size() > slotCount) {
+        std::nth_element(wanted.begin(), wanted.begin() + static_cast<std::ptrdiff_t>(slotCount), wanted.end());
+        wanted.resize(slotCount);
+    }
+    std::sort(wanted.begin(), wanted.end());
+
+    // Evicted cells fall back to the coarse grid now; their slots are reused only once no
+    // frame in flight can still be reading the old entry.
+    std::vector<uint8_t> keep(cellCount, 0);
+    for (const auto& entry : wanted) {
+        keep[entry.second] = 1;
+    }
+    auto* indirection = static_cast<uint32_t*>(m_probeVolumeBuffer->contents());
+    for (uint32_t slot = 0; slot < slotCount; ++slot) {
+        uint32_t cell = m_probeBrickCellOfSlot[slot];
+        if (cell != kProbeBrickNone && !keep[cell]) {
+            indirection[cell] = m_probeBrickCoarseOffset;
+            m_probeBrickSlotOfCell[cell] = kProbeBrickNone;
+            m_probeBrickCellOfSlot[slot] = kProbeBrickNone;
+            m_probeBrickSlotFreedFrame[slot] = m_frameIndex;
+        }
+    }
+
+    static constexpr uint32_t kMaxBrickUploadsPerFrame = 32;
+    uint32_t uploads = 0;
+    uint32_t nextSlot = 0;
+    m_probeBrickStreamPending = false;
+    for (const auto& entry : wanted) {
+        uint32_t cell = entry.second;
+        if (m_probeBrickSlotOfCell[cell] != kProbeBrickNone) {
+            continue;
+        }
+        while (nextSlot < slotCount
+               && (m_probeBrickCellOfSlot[nextSlot] != kProbeBrickNone
+                   || m_frameIndex - m_probeBrickSlotFreedFrame[nextSlot] < kMaxFramesInFlight)) {
+            ++nextSlot;
+        }
+        if (nextSlot >= slotCount || uploads >= kMaxBrickUploadsPerFrame) {
+            m_probeBrickStreamPending = true;
+            break;
+        }
+        loadProbeBrick(cell, nextSlot);
+        ++uploads;
+    }
+}
+
+Renderer::Renderer()
+    : m_device(nullptr)
+    , m_commandQueue(nullptr)
+    , m_library(nullptr)
+    , m_metalLayer(nullptr)
     , m_depthStencilState(nullptr)
     , m_skyboxDepthState(nullptr)
     , m_depthReadState(nullptr)
@@ -845,17 +1485,27 @@ Renderer::Renderer()
     , m_prepassPipelineState(nullptr)
     , m_prepassPipelineSkinned(nullptr)
     , m_prepassPipelineInstanced(nullptr)
+    , m_prepassPipelineInstancedSkinned(nullptr)
+    , m_prepassPipelineInstancedVat(nullptr)
+    , m_prepassPipelineInstancedTerrain(nullptr)
     , m_instanceCullPipeline(nullptr)
     , m_instanceCullHzbPipeline(nullptr)
     , m_instanceIndirectPipeline(nullptr)
+    , m_staticCullPipeline(nullptr)
+    , m_staticCullHzbPipeline(nullptr)
+    , m_staticEncodePipeline(nullptr)
     , m_hzbInitPipeline(nullptr)
     , m_hzbDownsamplePipeline(nullptr)
-    , m_velocityPipelineState(nullptr)
-    , m_velocityPipelineSkinned(nullptr)
+    , m_velocityReconstructPipeline(nullptr)
     , m_ssaoPipelineState(nullptr)
-    , m_ssaoBlurPipelineState(nullptr)
+    , m_ssaoTemporalPipelineState(nullptr)
+    , m_ssaoUpsamplePipelineState(nullptr)
     , m_impostorBakePipeline(nullptr)
     , m_ssrPipelineState(nullptr)
+    , m_ssrHizInitPipeline(nullptr)
+    , m_ssrHizDownsamplePipeline(nullptr)
+    , m_ssrTracePipeline(nullptr)
+    , m_ssrTemporalPipeline(nullptr)
     , m_decalPipelineState(nullptr)
     , m_bloomPrefilterPipelineState(nullptr)
     , m_bloomDownsamplePipelineState(nullptr)
@@ -864,6 +1514,7 @@ Renderer::Renderer()
     , m_taaPipelineState(nullptr)
     , m_dofPipelineState(nullptr)
     , m_fogPipelineState(nullptr)
+    , m_ssrFogPipelineState(nullptr)
     , m_fogVolumePipelineState(nullptr)
     , m_motionBlurPipelineState(nullptr)
     , m_depthTexture(nullptr)
@@ -873,8 +1524,22 @@ Renderer::Renderer()
     , m_hzbMipCount(0)
     , m_normalTexture(nullptr)
     , m_ssaoTexture(nullptr)
+    , m_ssaoHistoryTexture(nullptr)
+    , m_ssaoAccumTexture(nullptr)
     , m_ssaoBlurTexture(nullptr)
-    , m_ssaoNoiseTexture(nullptr)
+    , m_ssaoWidth(0)
+    , m_ssaoHeight(0)
+    , m_ssaoResolution(1)
+    , m_ssaoHistoryValid(false)
+    , m_ssrHizTexture(nullptr)
+    , m_ssrHizMipViews()
+    , m_ssrTraceTexture(nullptr)
+    , m_ssrHistoryTexture(nullptr)
+    , m_ssrAccumTexture(nullptr)
+    , m_visibilityTexture(nullptr)
+    , m_ssrWidth(0)
+    , m_ssrHeight(0)
+    , m_ssrHistoryValid(false)
     , m_velocityTexture(nullptr)
     , m_dofTexture(nullptr)
     , m_fogTexture(nullptr)
@@ -908,9 +1573,7 @@ Renderer::Renderer()
     , m_metalFXColorFormat(static_cast<int>(MTL::PixelFormatInvalid))
     , m_colorTexture(nullptr)
     , m_msaaColorTexture(nullptr)
-    , m_modelUniformBuffer(nullptr)
     , m_cameraUniformBuffer(nullptr)
-    , m_materialUniformBuffer(nullptr)
     , m_lightUniformBuffer(nullptr)
     , m_environmentUniformBuffer(nullptr)
     , m_lightGPUBuffer(nullptr)
@@ -922,9 +1585,7 @@ Renderer::Renderer()
     , m_probeVolumeBuffer(nullptr)
     , m_probeVolumeFallbackBuffer(nullptr)
     , m_skinningBuffer(nullptr)
-    , m_prevSkinningBuffer(nullptr)
     , m_skinningBufferCapacity(0)
-    , m_prevSkinningBufferCapacity(0)
     , m_instanceBuffer(nullptr)
     , m_instanceBufferCapacity(0)
     , m_instanceBufferOffset(0)
@@ -947,6 +1608,8 @@ Renderer::Renderer()
     , m_pointClampSampler(nullptr)
     , m_debugLibrary(nullptr)
     , m_debugLinePipelineState(nullptr)
+    , m_debugShapePipelineState(nullptr)
+    , m_debugMeshWirePipelineState(nullptr)
     , m_debugGridPipelineState(nullptr)
     , m_debugRenderer(nullptr)
     , m_skyboxPipelineState(nullptr)
@@ -961,6 +1624,10 @@ Renderer::Renderer()
     , m_hasIBL(false)
     , m_sceneColorFormat(static_cast<int>(MTL::PixelFormatBGRA8Unorm))
     , m_outputHDR(false)
+    , m_hdrColorFormat(static_cast<int>(MTL::PixelFormatRGBA16Float))
+    , m_bloomFormat(static_cast<int>(MTL::PixelFormatRGBA16Float))
+    , m_normalTargetFormat(static_cast<int>(MTL::PixelFormatRGBA16Float))
+    , m_decalTargetFormat(static_cast<int>(MTL::PixelFormatRGBA16Float))
     , m_prevViewProjection()
     , m_prevViewProjectionNoJitter()
     , m_prevFogViewMatrix()
@@ -980,10 +1647,37 @@ Renderer::Renderer()
     , m_debugDrawShadowAtlas(false)
     , m_debugDrawCascades(false)
     , m_debugDrawPointFrusta(false)
+    , m_debugDrawGPUPasses(false)
     , m_activePool(RenderTargetPool::Scene) {
     m_lightingSystem = std::make_unique<LightingSystem>();
     m_shadowPass = std::make_unique<ShadowRenderPass>();
     m_clusterPass = std::make_unique<ClusteredLightingPass>();
+    m_skinningCache = std::make_unique<SkinningCache>();
+    m_crowdAnimation = std::make_unique<CrowdAnimation>();
+    m_dynamicProbeGI = std::make_unique<DynamicProbeGI>();
+    m_materialTable = std::make_unique<MaterialTable>();
+    m_uniformRing = std::make_unique<UniformRing>();
+    m_sceneResidency = std::make_unique<SceneResidency>();
+    m_instanceCache = std::make_unique<InstanceCache>();
+    m_foliageSystem = std::make_unique<FoliageSystem>();
+    m_terrainSystem = std::make_unique<TerrainSystem>();
+    m_terrainVirtualTexture = std::make_unique<TerrainVirtualTexture>();
+    m_tiledPostBlur = std::make_unique<TiledPostBlur>();
+    m_particleSystem = std::make_unique<ParticleSystem>();
+    m_skyAtmosphere = std::make_unique<SkyAtmosphere>();
+    m_impostorBaker = std::make_unique<ImpostorBaker>();
+    m_entityPicker = std::make_unique<EntityPicker>();
+    m_environmentProcessor = std::make_unique<EnvironmentProcessor>();
+    m_renderTargetHeap = std::make_unique<RenderTargetHeap>();
+    m_asyncCompute = std::make_unique<AsyncComputeQueue>();
+    m_dynamicResolution = std::make_unique<DynamicResolution>();
+    m_textureStreamer = std::make_unique<TextureStreamer>();
+    m_variableRateShading = std::make_unique<VariableRateShading>();
+    m_weightedTransparency = std::make_unique<WeightedTransparency>();
+    m_gpuPassProfiler = std::make_unique<GPUPassProfiler>();
+    m_shadowPass->setPassProfiler(m_gpuPassProfiler.get());
+    m_clusterPass->setPassProfiler(m_gpuPassProfiler.get());
+    m_pipelineCompileQueue = std::make_shared<PipelineCompileQueue>();
     m_sceneTargets.sceneColorFormat = m_sceneColorFormat;
     m_gameTargets.sceneColorFormat = m_sceneColorFormat;
     m_previewTargets.sceneColorFormat = m_sceneColorFormat;
@@ -995,6 +1689,7 @@ Renderer::~Renderer() {
 }
 
 bool Renderer::initialize() {
+    StartupTraceScope trace("renderer", "Renderer::initialize");
     if (m_isInitialized) {
         return true;
     }
@@ -1018,7 +1713,7 @@ bool Renderer::initialize() {
     }
     
     // Load shader library
-    m_library = m_device->newDefaultLibrary();
+    m_library = ShaderLibrary::getInstance().acquire(m_device, ShaderLibrary::Module::Core);
     
     if (!m_library) {
         std::cerr << "Failed to load shader library!" << std::endl;
@@ -1028,9 +1723,14 @@ bool Renderer::initialize() {
     
     std::cout << "Shader library loaded" << std::endl;
     
+    if (!GeometryBuffer::getInstance().initialize(m_device)) {
+        std::cerr << "Failed to allocate geometry buffer!" << std::endl;
+        return false;
+    }
+    
+    m_frameEvent = m_device->newSharedEvent();
+
     // Create uniform buffers
-    m_modelUniformBuffer = m_device->newBuffer(sizeof(ModelUniforms), MTL::ResourceStorageModeShared);
-    m_materialUniformBuffer = m_device->newBuffer(sizeof(MaterialUniformsGPU), MTL::ResourceStorageModeShared);
     for (uint32_t i = 0; i < kMaxFramesInFlight; ++i) {
         m_cameraUniformBuffers[i] = m_device->newBuffer(sizeof(CameraUniforms), MTL::ResourceStorageModeShared);
         m_lightUniformBuffers[i] = m_device->newBuffer(sizeof(LightDataGPU), MTL::ResourceStorageModeShared);
@@ -1039,9 +1739,9 @@ bool Renderer::initialize() {
     m_cameraUniformBuffer = m_cameraUniformBuffers[0];
     m_lightUniformBuffer = m_lightUniformBuffers[0];
     m_environmentUniformBuffer = m_environmentUniformBuffers[0];
-    ProbeAmbientCubeDataGPU zeroProbe{};
+    PackedProbeRecord zeroProbe{};
     m_probeVolumeFallbackBuffer = m_device->newBuffer(&zeroProbe,
-                                                      sizeof(ProbeAmbientCubeDataGPU),
+                                                      sizeof(PackedProbeRecord),
                                                       MTL::ResourceStorageModeShared);
     
     rebuildSamplerState(8);
@@ -1082,6 +1782,7 @@ bool Renderer::initialize() {
     m_defaultWhiteTexture = m_textureLoader->createSolidTexture(1.0f, 1.0f, 1.0f, 1.0f, true);
     m_defaultNormalTexture = m_textureLoader->createFlatNormalTexture();
     m_defaultBlackTexture = m_textureLoader->createSolidTexture(0.0f, 0.0f, 0.0f, 1.0f, false);
+    m_defaultTransparentTexture = m_textureLoader->createSolidTexture(0.0f, 0.0f, 0.0f, 0.0f, false);
     m_defaultHeightTexture = m_textureLoader->createSolidTexture(0.5f, 0.5f, 0.5f, 1.0f, false); // mid-height
     m_defaultEnvironmentTexture = m_textureLoader->createSolidTexture(0.18f, 0.2f, 0.26f, 1.0f, false);
     m_environmentTexture = m_defaultEnvironmentTexture;
@@ -1116,18 +1817,21 @@ bool Renderer::initialize() {
     }
     
     // Build pipelines and depth stencil states
+    const auto pipelineStart = std::chrono::steady_clock::now();
     buildPipelines();
     buildDepthStencilStates();
     buildEnvironmentPipeline();
     buildBlitPipeline();
     buildPrepassPipeline();
     buildInstanceCullingPipeline();
+    buildStaticScenePipelines();
+    buildVisibilityPipelines();
     buildHZBPipelines();
     buildVelocityPipelines();
     buildSSAOPipelines();
-    buildSSAONoiseTexture();
     buildImpostorPipeline();
     buildSSRPipeline();
+    buildSSRTracePipelines();
     buildDecalPipeline();
     buildMotionBlurPipeline();
     buildBloomPipelines();
@@ -1135,6 +1839,9 @@ bool Renderer::initialize() {
     buildFogPipeline();
     buildFogVolumePipeline();
     buildTAAPipeline();
+    StartupLog("Renderer pipelines built in " + std::to_string(std::chrono::duration<float, std::milli>(
+        std::chrono::steady_clock::now() - pipelineStart).count()) + "ms");
+    StartupTrace::getInstance().addSpan("renderer", "Renderer pipelines", pipelineStart, std::chrono::steady_clock::now());
     
     // Initialize debug renderer
     m_debugRenderer = std::make_unique<DebugRenderer>();
@@ -1150,8 +1857,6 @@ bool Renderer::initialize() {
     m_iblGenerator = std::make_unique<IBLGenerator>();
     if (!m_iblGenerator->initialize(m_device, m_commandQueue)) {
         std::cerr << "Warning: IBL Generator failed to initialize - using fallback IBL" << std::endl;
-    } else {
-        m_iblBRDFLUT = m_iblGenerator->getBRDFLUT();
     }
     
     // Initialize shadow rendering
@@ -1168,6 +1873,74 @@ bool Renderer::initialize() {
             std::cerr << "Warning: ClusteredLightingPass failed to initialize" << std::endl;
         }
     }
+    if (m_skinningCache) {
+        if (!m_skinningCache->initialize(m_device)) {
+            std::cerr << "Warning: SkinningCache failed to initialize, skinning stays in the vertex shaders" << std::endl;
+        }
+    }
+    if (m_crowdAnimation && !m_crowdAnimation->initialize(m_device)) {
+        std::cerr << "Warning: CrowdAnimation failed to initialize, crowds draw in their bind pose" << std::endl;
+    }
+    if (m_dynamicProbeGI && !m_dynamicProbeGI->initialize(m_device)) {
+        std::cerr << "Warning: dynamic probe GI needs a ray tracing device, probe volumes stay baked" << std::endl;
+    }
+    if (m_materialTable && !m_materialTable->initialize(m_device)) {
+        std::cerr << "Warning: material table needs a Metal 3 device, main pass binds material textures per draw" << std::endl;
+    }
+    // Material table textures and static scene geometry stay resident on the queue instead of
+    // being declared to every encoder.
+    if (m_sceneResidency && m_sceneResidency->initialize(m_device, m_commandQueue)) {
+        if (m_materialTable) {
+            m_materialTable->setResidency(m_sceneResidency.get());
+        }
+    } else {
+        m_sceneResidency.reset();
+    }
+    if (m_uniformRing && !m_uniformRing->initialize(m_device)) {
+        std::cerr << "Warning: UniformRing failed to initialize, per-draw uniforms are passed inline" << std::endl;
+    }
+    if (m_instanceCache && !m_instanceCache->initialize(m_device)) {
+        std::cerr << "Warning: InstanceCache failed to initialize, instances are uploaded every frame" << std::endl;
+    }
+    if (m_foliageSystem && !m_foliageSystem->initialize(m_device)) {
+        std::cerr << "Warning: FoliageSystem failed to initialize, foliage scatters are not drawn" << std::endl;
+    }
+    if (m_terrainSystem && !m_terrainSystem->initialize(m_device)) {
+        std::cerr << "Warning: TerrainSystem failed to initialize, terrain renderers are not drawn" << std::endl;
+    }
+    if (m_terrainVirtualTexture && !m_terrainVirtualTexture->initialize(m_device)) {
+        std::cerr << "Warning: TerrainVirtualTexture failed to initialize, terrain layers are sampled directly" << std::endl;
+    }
+    if (m_tiledPostBlur && !m_tiledPostBlur->initialize(m_device)) {
+        std::cerr << "Warning: TiledPostBlur failed to initialize, motion blur and depth of field gather every pixel" << std::endl;
+    }
+    if (m_particleSystem && !m_particleSystem->initialize(m_device)) {
+        std::cerr << "Warning: ParticleSystem failed to initialize, particle emitters are not drawn" << std::endl;
+    }
+    if (m_skyAtmosphere && !m_skyAtmosphere->initialize(m_device)) {
+        std::cerr << "Warning: SkyAtmosphere failed to initialize, the procedural sky is evaluated per pixel" << std::endl;
+    }
+    if (m_entityPicker && !m_entityPicker->initialize(m_device)) {
+        std::cerr << "Warning: EntityPicker failed to initialize, scene view clicks fall back to raycasts" << std::endl;
+    }
+    if (m_environmentProcessor && !m_environmentProcessor->initialize(m_device, m_textureLoader.get())) {
+        std::cerr << "Warning: EnvironmentProcessor failed to initialize, environment maps load synchronously" << std::endl;
+    }
+    if (m_renderTargetHeap && !m_renderTargetHeap->initialize(m_device)) {
+        std::cerr << "Warning: RenderTargetHeap failed to initialize, render targets are allocated individually" << std::endl;
+    }
+    if (m_asyncCompute && !m_asyncCompute->initialize(m_device)) {
+        std::cerr << "Warning: async compute queue unavailable, compute passes stay on the main queue" << std::endl;
+    }
+    if (m_variableRateShading && !m_variableRateShading->initialize(m_device)) {
+        std::cerr << "Warning: variable rate shading unavailable, the main pass shades at full rate" << std::endl;
+    }
+    if (m_weightedTransparency && !m_weightedTransparency->initialize(m_device)) {
+        std::cerr << "Warning: weighted transparency unavailable, blended draws are sorted" << std::endl;
+    }
+    if (!m_gpuPassProfiler->initialize(m_device, kMaxFramesInFlight)) {
+        std::cerr << "Warning: GPU pass timing unavailable, per-pass GPU times read zero" << std::endl;
+    }
     
     resetEnvironment();
     
@@ -1246,6 +2019,30 @@ std::shared_ptr<Texture2D> Renderer::resolveStaticLightingTexture(const std::str
     return texture;
 }
 
+std::shared_ptr<Texture2D> Renderer::resolveVertexAnimationTexture(const std::string& texturePath) {
+    if (!m_textureLoader || texturePath.empty()) {
+        return nullptr;
+    }
+
+    auto it = m_vertexAnimationTextureCache.find(texturePath);
+    if (it != m_vertexAnimationTextureCache.end()) {
+        return it->second;
+    }
+
+    // Positions and normals are data: linear, unflipped, read texel by texel.
+    std::shared_ptr<Texture2D> texture = m_textureLoader->loadTexture(texturePath, false, false);
+    if (texture) {
+        m_vertexAnimationTextureCache[texturePath] = texture;
+    }
+    return texture;
+}
+
+void Renderer::invalidateTerrainVirtualTexture(const Material* material) {
+    if (m_terrainVirtualTexture) {
+        m_terrainVirtualTexture->invalidate(material);
+    }
+}
+
 void Renderer::invalidateStaticLightingResources() {
     if (m_textureLoader) {
         for (const auto& entry : m_staticLightingTextureCache) {
@@ -1263,6 +2060,7 @@ void Renderer::invalidateStaticLightingResources() {
         m_probeVolumeBuffer = nullptr;
     }
     m_probeVolumePath.clear();
+    resetProbeBrickStreaming();
     m_probeVolumeBoundsMin = Math::Vector4::Zero;
     m_probeVolumeBoundsMax = Math::Vector4::Zero;
     m_probeVolumeGridCounts = Math::Vector4::Zero;
@@ -1277,6 +2075,14 @@ void Renderer::buildDebugPipelines() {
         m_debugLinePipelineState->release();
         m_debugLinePipelineState = nullptr;
     }
+    if (m_debugShapePipelineState) {
+        m_debugShapePipelineState->release();
+        m_debugShapePipelineState = nullptr;
+    }
+    if (m_debugMeshWirePipelineState) {
+        m_debugMeshWirePipelineState->release();
+        m_debugMeshWirePipelineState = nullptr;
+    }
     if (m_debugGridPipelineState) {
         m_debugGridPipelineState->release();
         m_debugGridPipelineState = nullptr;
@@ -1305,31 +2111,22 @@ void Renderer::buildDebugPipelines() {
         std::cerr << "ERROR: debugLineFragmentShader NOT FOUND in library!" << std::endl;
     }
     
-    if (debugLineVertexFunc && debugLineFragmentFunc) {
+    MTL::Function* debugShapeVertexFunc = m_debugLibrary->newFunction(
+        NS::String::string("debugShapeVertexShader", NS::UTF8StringEncoding)
+    );
+    if (!debugShapeVertexFunc) {
+        std::cerr << "ERROR: debugShapeVertexShader NOT FOUND in library!" << std::endl;
+    }
+    
+    // Lines and instanced shapes read their records directly and expand each edge into a
+    // screen-space quad, and mesh wireframes read the position arena, so none of these pipelines
+    // has a vertex descriptor
+    auto buildDebugLinePipeline = [&](MTL::Function* vertexFunc, MTL::Function* fragmentFunc,
+                                      const char* name) -> MTL::RenderPipelineState* {
         MTL::RenderPipelineDescriptor* desc = MTL::RenderPipelineDescriptor::alloc()->init();
-        desc->setVertexFunction(debugLineVertexFunc);
-        desc->setFragmentFunction(debugLineFragmentFunc);
+        desc->setVertexFunction(vertexFunc);
+        desc->setFragmentFunction(fragmentFunc);
         desc->setSampleCount(m_msaaSamples);
-        
-        // Configure vertex descriptor for debug vertices
-        MTL::VertexDescriptor* vertexDesc = MTL::VertexDescriptor::alloc()->init();
-        
-        // Position (attribute 0) - float3
-        vertexDesc->attributes()->object(0)->setFormat(MTL::VertexFormatFloat3);
-        vertexDesc->attributes()->object(0)->setOffset(0);
-        vertexDesc->attributes()->object(0)->setBufferIndex(0);
-        
-        // Color (attribute 1) - float4
-        vertexDesc->attributes()->object(1)->setFormat(MTL::VertexFormatFloat4);
-        vertexDesc->attributes()->object(1)->setOffset(12);
-        vertexDesc->attributes()->object(1)->setBufferIndex(0);
-        
-        // Vertex buffer layout (stride = 3*float + 4*float = 28 bytes)
-        vertexDesc->layouts()->object(0)->setStride(28);
-        vertexDesc->layouts()->object(0)->setStepFunction(MTL::VertexStepFunctionPerVertex);
-        
-        desc->setVertexDescriptor(vertexDesc);
-        
         desc->colorAttachments()->object(0)->setPixelFormat(static_cast<MTL::PixelFormat>(m_sceneColorFormat));
         desc->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
         
@@ -1338,20 +2135,52 @@ void Renderer::buildDebugPipelines() {
         colorAttachment->setSourceRGBBlendFactor(MTL::BlendFactorSourceAlpha);
         colorAttachment->setDestinationRGBBlendFactor(MTL::BlendFactorOneMinusSourceAlpha);
         
-        m_debugLinePipelineState = m_device->newRenderPipelineState(desc, &error);
-        
-        if (error) {
-            std::cerr << "ERROR creating debug line pipeline: " << error->localizedDescription()->utf8String() << std::endl;
+        NS::Error* pipelineError = nullptr;
+        MTL::RenderPipelineState* pipeline = m_device->newRenderPipelineState(desc, &pipelineError);
+        if (pipelineError) {
+            std::cerr << "ERROR creating " << name << " pipeline: " << pipelineError->localizedDescription()->utf8String() << std::endl;
         }
-        
-        vertexDesc->release();
         desc->release();
+        if (pipeline) {
+            std::cout << "Debug " << name << " pipeline created" << std::endl;
+        }
+        return pipeline;
+    };
+    
+    if (debugLineVertexFunc && debugLineFragmentFunc) {
+        m_debugLinePipelineState = buildDebugLinePipeline(debugLineVertexFunc, debugLineFragmentFunc, "line");
+    }
+    if (debugShapeVertexFunc && debugLineFragmentFunc) {
+        m_debugShapePipelineState = buildDebugLinePipeline(debugShapeVertexFunc, debugLineFragmentFunc, "shape");
+    }
+    // Mesh wireframes need barycentric coordinates in the fragment shader; without them the
+    // gizmos fall back to CPU edge lists drawn as lines.
+    if (m_device->supportsShaderBarycentricCoordinates()) {
+        MTL::Function* meshWireVertexFunc = m_debugLibrary->newFunction(
+            NS::String::string("debugMeshWireVertexShader", NS::UTF8StringEncoding));
+        MTL::Function* meshWireFragmentFunc = m_debugLibrary->newFunction(
+            NS::String::string("debugMeshWireFragmentShader", NS::UTF8StringEncoding));
+        if (meshWireVertexFunc && meshWireFragmentFunc) {
+            m_debugMeshWirePipelineState = buildDebugLinePipeline(meshWireVertexFunc, meshWireFragmentFunc, "mesh wire");
+        }
+        if (meshWireVertexFunc) {
+            meshWireVertexFunc->release();
+        }
+        if (meshWireFragmentFunc) {
+            meshWireFragmentFunc->release();
+        }
+    }
+    if (m_debugRenderer) {
+        m_debugRenderer->setMeshWireframesSupported(m_debugMeshWirePipelineState != nullptr);
+    }
+    if (debugLineVertexFunc) {
         debugLineVertexFunc->release();
+    }
+    if (debugShapeVertexFunc) {
+        debugShapeVertexFunc->release();
+    }
+    if (debugLineFragmentFunc) {
         debugLineFragmentFunc->release();
-        
-        if (m_debugLinePipelineState) {
-            std::cout << "Debug line pipeline created" << std::endl;
-        }
     }
     
     // Grid pipeline
@@ -1386,11 +2215,11 @@ void Renderer::buildDebugPipelines() {
         
         // Color (attribute 1) - float4
         vertexDesc->attributes()->object(1)->setFormat(MTL::VertexFormatFloat4);
-        vertexDesc->attributes()->object(1)->setOffset(12);
+        vertexDesc->attributes()->object(1)->setOffset(offsetof(DebugVertex, color));
         vertexDesc->attributes()->object(1)->setBufferIndex(0);
         
-        // Vertex buffer layout (stride = 3*float + 4*float = 28 bytes)
-        vertexDesc->layouts()->object(0)->setStride(28);
+        // Vertex buffer layout (color is 16-byte aligned, so the stride includes padding)
+        vertexDesc->layouts()->object(0)->setStride(sizeof(DebugVertex));
         vertexDesc->layouts()->object(0)->setStepFunction(MTL::VertexStepFunctionPerVertex);
         
         desc->setVertexDescriptor(vertexDesc);
@@ -1530,18 +2359,21 @@ void Renderer::buildPrepassPipeline() {
         return;
     }
 
-    auto buildPipeline = [&](const char* vertexName, bool skinned, MTL::RenderPipelineState*& outState) {
+    // Every prepass pipeline carries the velocity target as attachment 1; only the motion variants
+    // write it; the rest leave their pixels to the camera-motion reconstruction.
+    auto buildPipeline = [&](const char* vertexName, bool skinned, bool motion, MTL::RenderPipelineState*& outState) {
         if (outState) {
             outState->release();
             outState = nullptr;
         }
 
+        const char* fragmentName = motion ? "fragment_prepass_motion" : "fragment_prepass";
         NS::String* vsName = NS::String::string(vertexName, NS::UTF8StringEncoding);
-        NS::String* fsName = NS::String::string("fragment_prepass", NS::UTF8StringEncoding);
+        NS::String* fsName = NS::String::string(fragmentName, NS::UTF8StringEncoding);
         MTL::Function* vertexFunction = m_library->newFunction(vsName);
         MTL::Function* fragmentFunction = m_library->newFunction(fsName);
         if (!vertexFunction || !fragmentFunction) {
-            std::cerr << "Missing prepass shader functions: " << vertexName << " / fragment_prepass\n";
+            std::cerr << "Missing prepass shader functions: " << vertexName << " / " << fragmentName << "\n";
             if (vertexFunction) vertexFunction->release();
             if (fragmentFunction) fragmentFunction->release();
             return;
@@ -1552,55 +2384,17 @@ void Renderer::buildPrepassPipeline() {
         descriptor->setFragmentFunction(fragmentFunction);
         descriptor->setSampleCount(1);
 
-        MTL::VertexDescriptor* vertexDescriptor = MTL::VertexDescriptor::alloc()->init();
-        vertexDescriptor->attributes()->object(0)->setFormat(MTL::VertexFormatFloat3);
-        vertexDescriptor->attributes()->object(0)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, position)));
-        vertexDescriptor->attributes()->object(0)->setBufferIndex(0);
-
-        vertexDescriptor->attributes()->object(1)->setFormat(MTL::VertexFormatFloat3);
-        vertexDescriptor->attributes()->object(1)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, normal)));
-        vertexDescriptor->attributes()->object(1)->setBufferIndex(0);
-
-        vertexDescriptor->attributes()->object(2)->setFormat(MTL::VertexFormatFloat2);
-        vertexDescriptor->attributes()->object(2)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, texCoord)));
-        vertexDescriptor->attributes()->object(2)->setBufferIndex(0);
-
-        vertexDescriptor->attributes()->object(6)->setFormat(MTL::VertexFormatFloat2);
-        vertexDescriptor->attributes()->object(6)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, texCoord1)));
-        vertexDescriptor->attributes()->object(6)->setBufferIndex(0);
-
-        vertexDescriptor->attributes()->object(3)->setFormat(MTL::VertexFormatFloat3);
-        vertexDescriptor->attributes()->object(3)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, tangent)));
-        vertexDescriptor->attributes()->object(3)->setBufferIndex(0);
-
-        vertexDescriptor->attributes()->object(4)->setFormat(MTL::VertexFormatFloat3);
-        vertexDescriptor->attributes()->object(4)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, bitangent)));
-        vertexDescriptor->attributes()->object(4)->setBufferIndex(0);
-
-        vertexDescriptor->attributes()->object(5)->setFormat(MTL::VertexFormatFloat4);
-        vertexDescriptor->attributes()->object(5)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, color)));
-        vertexDescriptor->attributes()->object(5)->setBufferIndex(0);
-
-        vertexDescriptor->layouts()->object(0)->setStride(static_cast<NS::UInteger>(sizeof(Vertex)));
-        vertexDescriptor->layouts()->object(0)->setStepFunction(MTL::VertexStepFunctionPerVertex);
-
-        if (skinned) {
-            vertexDescriptor->attributes()->object(7)->setFormat(MTL::VertexFormatUInt4);
-            vertexDescriptor->attributes()->object(7)->setOffset(0);
-            vertexDescriptor->attributes()->object(7)->setBufferIndex(4);
-
-            vertexDescriptor->attributes()->object(8)->setFormat(MTL::VertexFormatFloat4);
-            vertexDescriptor->attributes()->object(8)->setOffset(sizeof(uint32_t) * 4);
-            vertexDescriptor->attributes()->object(8)->setBufferIndex(4);
-
-            vertexDescriptor->layouts()->object(4)->setStride(sizeof(uint32_t) * 4 + sizeof(float) * 4);
-            vertexDescriptor->layouts()->object(4)->setStepFunction(MTL::VertexStepFunctionPerVertex);
-        }
-
+        MTL::VertexDescriptor* vertexDescriptor = GeometryBuffer::NewVertexDescriptor(GeometryBuffer::VertexStreams::Full, skinned);
         descriptor->setVertexDescriptor(vertexDescriptor);
-        descriptor->colorAttachments()->object(0)->setPixelFormat(MTL::PixelFormatRGBA16Float);
+        descriptor->colorAttachments()->object(0)->setPixelFormat(static_cast<MTL::PixelFormat>(m_normalTargetFormat));
+        descriptor->colorAttachments()->object(1)->setPixelFormat(MTL::PixelFormatRG16Float);
+        descriptor->colorAttachments()->object(1)->setWriteMask(motion ? MTL::ColorWriteMaskAll : MTL::ColorWriteMaskNone);
         descriptor->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
 
+        if (&outState == &m_prepassPipelineInstanced) {
+            descriptor->setSupportIndirectCommandBuffers(true);
+        }
+
         NS::Error* error = nullptr;
         outState = m_device->newRenderPipelineState(descriptor, &error);
         if (!outState) {
@@ -1616,9 +2410,15 @@ void Renderer::buildPrepassPipeline() {
         fragmentFunction->release();
     };
 
-    buildPipeline("vertex_prepass", false, m_prepassPipelineState);
-    buildPipeline("vertex_prepass_skinned", true, m_prepassPipelineSkinned);
-    buildPipeline("vertex_prepass_instanced", false, m_prepassPipelineInstanced);
+    buildPipeline("vertex_prepass", false, false, m_prepassPipelineState);
+    buildPipeline("vertex_prepass_skinned", true, false, m_prepassPipelineSkinned);
+    buildPipeline("vertex_prepass_instanced", false, false, m_prepassPipelineInstanced);
+    buildPipeline("vertex_prepass_skinned_instanced", true, false, m_prepassPipelineInstancedSkinned);
+    buildPipeline("vertex_prepass_vat_instanced", false, false, m_prepassPipelineInstancedVat);
+    buildPipeline("vertex_prepass_terrain_instanced", false, false, m_prepassPipelineInstancedTerrain);
+    buildPipeline("vertex_prepass_motion", false, true, m_prepassPipelineMotion);
+    buildPipeline("vertex_prepass_motion_skinned", true, true, m_prepassPipelineMotionSkinned);
+    buildPipeline("vertex_prepass_motion_cached", false, true, m_prepassPipelineMotionCached);
 }
 
 void Renderer::buildInstanceCullingPipeline() {
@@ -1675,6 +2475,96 @@ void Renderer::buildInstanceCullingPipeline() {
     indirectFn->release();
 }
 
+void Renderer::buildStaticScenePipelines() {
+    if (!m_device || !m_library) {
+        return;
+    }
+
+    MTL::ComputePipelineState** pipelines[] = {&m_staticCullPipeline, &m_staticCullHzbPipeline, &m_staticEncodePipeline};
+    for (MTL::ComputePipelineState** pipeline : pipelines) {
+        if (*pipeline) {
+            (*pipeline)->release();
+            *pipeline = nullptr;
+        }
+    }
+
+    // Indirect command buffers are filled with raw GPU addresses, which needs Metal 3.
+    m_meshletPipelineSupported = false;
+    if (!m_device->supportsFamily(MTL::GPUFamilyMetal3)) {
+        return;
+    }
+    // Metal 3 devices all run object and mesh shaders; the pipeline itself is built on first use.
+    m_meshletPipelineSupported = true;
+
+    const char* names[] = {"static_instance_cull", "static_instance_cull_hzb", "static_icb_encode"};
+    for (size_t i = 0; i < 3; ++i) {
+        MTL::Function* function = m_library->newFunction(NS::String::string(names[i], NS::UTF8StringEncoding));
+        if (!function) {
+            std::cerr << "Missing static scene shader: " << names[i] << "\n";
+            continue;
+        }
+        NS::Error* error = nullptr;
+        *pipelines[i] = m_device->newComputePipelineState(function, &error);
+        if (!*pipelines[i] && error) {
+            std::cerr << "Failed to create " << names[i] << " pipeline: " << error->localizedDescription()->utf8String() << std::endl;
+        }
+        function->release();
+    }
+}
+
+void Renderer::buildVisibilityPipelines() {
+    if (!m_device || !m_library) {
+        return;
+    }
+
+    if (m_visibilityPipeline) {
+        m_visibilityPipeline->release();
+        m_visibilityPipeline = nullptr;
+    }
+    if (m_visibilityClassifyPipeline) {
+        m_visibilityClassifyPipeline->release();
+        m_visibilityClassifyPipeline = nullptr;
+    }
+    // It executes the static scene's indirect command buffers, so it needs what they need.
+    if (!m_device->supportsFamily(MTL::GPUFamilyMetal3)) {
+        return;
+    }
+
+    MTL::Function* vertexFunction = m_library->newFunction(NS::String::string("vertex_visibility_instanced", NS::UTF8StringEncoding));
+    MTL::Function* fragmentFunction = m_library->newFunction(NS::String::string("fragment_visibility", NS::UTF8StringEncoding));
+    MTL::Function* classifyFunction = m_library->newFunction(NS::String::string("visibility_classify", NS::UTF8StringEncoding));
+    if (vertexFunction && fragmentFunction && classifyFunction) {
+        MTL::RenderPipelineDescriptor* descriptor = MTL::RenderPipelineDescriptor::alloc()->init();
+        descriptor->setVertexFunction(vertexFunction);
+        descriptor->setFragmentFunction(fragmentFunction);
+        descriptor->setSampleCount(1);
+        descriptor->setSupportIndirectCommandBuffers(true);
+        MTL::VertexDescriptor* vertexDescriptor = GeometryBuffer::NewVertexDescriptor(GeometryBuffer::VertexStreams::Full, false);
+        descriptor->setVertexDescriptor(vertexDescriptor);
+        vertexDescriptor->release();
+        descriptor->colorAttachments()->object(0)->setPixelFormat(MTL::PixelFormatRG32Uint);
+        descriptor->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
+
+        NS::Error* error = nullptr;
+        m_visibilityPipeline = m_device->newRenderPipelineState(descriptor, &error);
+        if (!m_visibilityPipeline && error) {
+            std::cerr << "Failed to create visibility pipeline: " << error->localizedDescription()->utf8String() << std::endl;
+        }
+        descriptor->release();
+
+        error = nullptr;
+        m_visibilityClassifyPipeline = m_device->newComputePipelineState(classifyFunction, &error);
+        if (!m_visibilityClassifyPipeline && error) {
+            std::cerr << "Failed to create visibility_classify pipeline: " << error->localizedDescription()->utf8String() << std::endl;
+        }
+    } else {
+        std::cerr << "Missing visibility buffer shaders\n";
+    }
+    if (vertexFunction) vertexFunction->release();
+    if (fragmentFunction) fragmentFunction->release();
+    if (classifyFunction) classifyFunction->release();
+}
+
 void Renderer::buildHZBPipelines() {
     if (!m_device || !m_library) {
         return;
@@ -1688,6 +2578,14 @@ void Renderer::buildHZBPipelines() {
         m_hzbDownsamplePipeline->release();
         m_hzbDownsamplePipeline = nullptr;
     }
+    if (m_occlusionCullPipeline) {
+        m_occlusionCullPipeline->release();
+        m_occlusionCullPipeline = nullptr;
+    }
+    if (m_occlusionArgsPipeline) {
+        m_occlusionArgsPipeline->release();
+        m_occlusionArgsPipeline = nullptr;
+    }
 
     NS::Error* error = nullptr;
     MTL::Function* initFn = m_library->newFunction(NS::String::string("hzb_init", NS::UTF8StringEncoding));
@@ -1711,6 +2609,48 @@ void Renderer::buildHZBPipelines() {
 
     initFn->release();
     downFn->release();
+
+    if (m_hzbSpdPipeline) {
+        m_hzbSpdPipeline->release();
+        m_hzbSpdPipeline = nullptr;
+    }
+    MTL::Function* spdFn = m_library->newFunction(NS::String::string("hzb_spd", NS::UTF8StringEncoding));
+    if (spdFn) {
+        error = nullptr;
+        m_hzbSpdPipeline = m_device->newComputePipelineState(spdFn, &error);
+        if (!m_hzbSpdPipeline && error) {
+            std::cerr << "Failed to create HZB SPD pipeline: " << error->localizedDescription()->utf8String() << std::endl;
+        }
+        spdFn->release();
+    }
+    if (m_hzbSpdPipeline && !m_hzbSpdBuffer) {
+        // Counter, then one mip 6 texel per threadgroup (at most 64x64 groups). The last group
+        // resets the counter, so it only needs zeroing once.
+        const size_t spdBufferSize = sizeof(uint32_t) * (1 + kHzbSpdMaxGroups * kHzbSpdMaxGroups);
+        m_hzbSpdBuffer = m_device->newBuffer(spdBufferSize, MTL::ResourceStorageModeShared);
+        if (m_hzbSpdBuffer) {
+            std::memset(m_hzbSpdBuffer->contents(), 0, spdBufferSize);
+        }
+    }
+
+    MTL::Function* occlusionFn = m_library->newFunction(NS::String::string("occlusion_cull", NS::UTF8StringEncoding));
+    MTL::Function* argsFn = m_library->newFunction(NS::String::string("occlusion_write_args", NS::UTF8StringEncoding));
+    if (occlusionFn && argsFn) {
+        error = nullptr;
+        m_occlusionCullPipeline = m_device->newComputePipelineState(occlusionFn, &error);
+        if (!m_occlusionCullPipeline && error) {
+            std::cerr << "Failed to create occlusion cull pipeline: " << error->localizedDescription()->utf8String() << std::endl;
+        }
+        error = nullptr;
+        m_occlusionArgsPipeline = m_device->newComputePipelineState(argsFn, &error);
+        if (!m_occlusionArgsPipeline && error) {
+            std::cerr << "Failed to create occlusion args pipeline: " << error->localizedDescription()->utf8String() << std::endl;
+        }
+    } else {
+        std::cerr << "Missing occlusion culling shaders (occlusion_cull / occlusion_write_args)\n";
+    }
+    if (occlusionFn) occlusionFn->release();
+    if (argsFn) argsFn->release();
 }
 
 void Renderer::buildVelocityPipelines() {
@@ -1718,182 +2658,115 @@ void Renderer::buildVelocityPipelines() {
         return;
     }
 
-    auto buildPipeline = [&](const char* vertexName, bool skinned, MTL::RenderPipelineState*& outState) {
+    if (m_velocityReconstructPipeline) {
+        m_velocityReconstructPipeline->release();
+        m_velocityReconstructPipeline = nullptr;
+    }
+
+    NS::String* vsName = NS::String::string("blit_vertex", NS::UTF8StringEncoding);
+    NS::String* fsName = NS::String::string("fragment_velocity_reconstruct", NS::UTF8StringEncoding);
+    MTL::Function* vertexFunction = m_library->newFunction(vsName);
+    MTL::Function* fragmentFunction = m_library->newFunction(fsName);
+    if (!vertexFunction || !fragmentFunction) {
+        std::cerr << "Missing velocity shader functions: blit_vertex / fragment_velocity_reconstruct\n";
+        if (vertexFunction) vertexFunction->release();
+        if (fragmentFunction) fragmentFunction->release();
+        return;
+    }
+
+    // Adds the camera's motion onto the object residuals the prepass left in the target.
+    MTL::RenderPipelineDescriptor* descriptor = MTL::RenderPipelineDescriptor::alloc()->init();
+    descriptor->setVertexFunction(vertexFunction);
+    descriptor->setFragmentFunction(fragmentFunction);
+    descriptor->setSampleCount(1);
+    auto* attachment = descriptor->colorAttachments()->object(0);
+    attachment->setPixelFormat(MTL::PixelFormatRG16Float);
+    attachment->setBlendingEnabled(true);
+    attachment->setSourceRGBBlendFactor(MTL::BlendFactorOne);
+    attachment->setDestinationRGBBlendFactor(MTL::BlendFactorOne);
+    descriptor->setDepthAttachmentPixelFormat(MTL::PixelFormatInvalid);
+
+    NS::Error* error = nullptr;
+    m_velocityReconstructPipeline = m_device->newRenderPipelineState(descriptor, &error);
+    if (!m_velocityReconstructPipeline) {
+        std::cerr << "Failed to create velocity reconstruction pipeline state" << std::endl;
+        if (error) {
+            std::cerr << "Error: " << error->localizedDescription()->utf8String() << std::endl;
+        }
+    }
+
+    descriptor->release();
+    vertexFunction->release();
+    fragmentFunction->release();
+}
+
+void Renderer::buildSSAOPipelines() {
+    if (!m_device || !m_library) {
+        return;
+    }
+
+    auto buildPipeline = [&](const char* kernelName, MTL::ComputePipelineState*& outState) {
         if (outState) {
             outState->release();
             outState = nullptr;
         }
 
-        NS::String* vsName = NS::String::string(vertexName, NS::UTF8StringEncoding);
-        NS::String* fsName = NS::String::string("fragment_velocity", NS::UTF8StringEncoding);
-        MTL::Function* vertexFunction = m_library->newFunction(vsName);
-        MTL::Function* fragmentFunction = m_library->newFunction(fsName);
-        if (!vertexFunction || !fragmentFunction) {
-            std::cerr << "Missing velocity shader functions: " << vertexName << " / fragment_velocity\n";
-            if (vertexFunction) vertexFunction->release();
-            if (fragmentFunction) fragmentFunction->release();
+        NS::String* csName = NS::String::string(kernelName, NS::UTF8StringEncoding);
+        MTL::Function* computeFunction = m_library->newFunction(csName);
+        if (!computeFunction) {
+            std::cerr << "Missing SSAO shader function: " << kernelName << "\n";
             return;
         }
 
-        MTL::RenderPipelineDescriptor* descriptor = MTL::RenderPipelineDescriptor::alloc()->init();
-        descriptor->setVertexFunction(vertexFunction);
-        descriptor->setFragmentFunction(fragmentFunction);
-        descriptor->setSampleCount(1);
+        NS::Error* error = nullptr;
+        outState = m_device->newComputePipelineState(computeFunction, &error);
+        computeFunction->release();
+        if (!outState) {
+            std::cerr << "Failed to create SSAO pipeline state: " << kernelName << std::endl;
+            if (error) {
+                std::cerr << "Error: " << error->localizedDescription()->utf8String() << std::endl;
+            }
+        }
+    };
 
-        MTL::VertexDescriptor* vertexDescriptor = MTL::VertexDescriptor::alloc()->init();
-        vertexDescriptor->attributes()->object(0)->setFormat(MTL::VertexFormatFloat3);
-        vertexDescriptor->attributes()->object(0)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, position)));
-        vertexDescriptor->attributes()->object(0)->setBufferIndex(0);
+    buildPipeline("ssao_trace", m_ssaoPipelineState);
+    buildPipeline("ssao_temporal", m_ssaoTemporalPipelineState);
+    buildPipeline("ssao_upsample", m_ssaoUpsamplePipelineState);
+}
 
-        vertexDescriptor->attributes()->object(1)->setFormat(MTL::VertexFormatFloat3);
-        vertexDescriptor->attributes()->object(1)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, normal)));
-        vertexDescriptor->attributes()->object(1)->setBufferIndex(0);
-
-        vertexDescriptor->attributes()->object(2)->setFormat(MTL::VertexFormatFloat2);
-        vertexDescriptor->attributes()->object(2)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, texCoord)));
-        vertexDescriptor->attributes()->object(2)->setBufferIndex(0);
-
-        vertexDescriptor->attributes()->object(6)->setFormat(MTL::VertexFormatFloat2);
-        vertexDescriptor->attributes()->object(6)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, texCoord1)));
-        vertexDescriptor->attributes()->object(6)->setBufferIndex(0);
-
-        vertexDescriptor->attributes()->object(3)->setFormat(MTL::VertexFormatFloat3);
-        vertexDescriptor->attributes()->object(3)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, tangent)));
-        vertexDescriptor->attributes()->object(3)->setBufferIndex(0);
-
-        vertexDescriptor->attributes()->object(4)->setFormat(MTL::VertexFormatFloat3);
-        vertexDescriptor->attributes()->object(4)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, bitangent)));
-        vertexDescriptor->attributes()->object(4)->setBufferIndex(0);
-
-        vertexDescriptor->attributes()->object(5)->setFormat(MTL::VertexFormatFloat4);
-        vertexDescriptor->attributes()->object(5)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, color)));
-        vertexDescriptor->attributes()->object(5)->setBufferIndex(0);
-
-        vertexDescriptor->layouts()->object(0)->setStride(static_cast<NS::UInteger>(sizeof(Vertex)));
-        vertexDescriptor->layouts()->object(0)->setStepFunction(MTL::VertexStepFunctionPerVertex);
-
-        if (skinned) {
-            vertexDescriptor->attributes()->object(7)->setFormat(MTL::VertexFormatUInt4);
-            vertexDescriptor->attributes()->object(7)->setOffset(0);
-            vertexDescriptor->attributes()->object(7)->setBufferIndex(4);
-
-            vertexDescriptor->attributes()->object(8)->setFormat(MTL::VertexFormatFloat4);
-            vertexDescriptor->attributes()->object(8)->setOffset(sizeof(uint32_t) * 4);
-            vertexDescriptor->attributes()->object(8)->setBufferIndex(4);
-
-            vertexDescriptor->layouts()->object(4)->setStride(sizeof(uint32_t) * 4 + sizeof(float) * 4);
-            vertexDescriptor->layouts()->object(4)->setStepFunction(MTL::VertexStepFunctionPerVertex);
-        }
-
-        descriptor->setVertexDescriptor(vertexDescriptor);
-        descriptor->colorAttachments()->object(0)->setPixelFormat(MTL::PixelFormatRG16Float);
-        descriptor->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
-
-        NS::Error* error = nullptr;
-        outState = m_device->newRenderPipelineState(descriptor, &error);
-        if (!outState) {
-            std::cerr << "Failed to create velocity pipeline state" << std::endl;
-            if (error) {
-                std::cerr << "Error: " << error->localizedDescription()->utf8String() << std::endl;
-            }
-        }
-
-        vertexDescriptor->release();
-        descriptor->release();
-        vertexFunction->release();
-        fragmentFunction->release();
-    };
-
-    buildPipeline("vertex_velocity", false, m_velocityPipelineState);
-    buildPipeline("vertex_velocity_skinned", true, m_velocityPipelineSkinned);
-}
-
-void Renderer::buildSSAOPipelines() {
+void Renderer::buildSSRTracePipelines() {
     if (!m_device || !m_library) {
         return;
     }
 
-    auto buildPipeline = [&](const char* fragmentName, MTL::RenderPipelineState*& outState) {
+    auto buildPipeline = [&](const char* kernelName, MTL::ComputePipelineState*& outState) {
         if (outState) {
             outState->release();
             outState = nullptr;
         }
 
-        NS::String* vsName = NS::String::string("blit_vertex", NS::UTF8StringEncoding);
-        NS::String* fsName = NS::String::string(fragmentName, NS::UTF8StringEncoding);
-        MTL::Function* vertexFunction = m_library->newFunction(vsName);
-        MTL::Function* fragmentFunction = m_library->newFunction(fsName);
-        if (!vertexFunction || !fragmentFunction) {
-            std::cerr << "Missing SSAO shader functions: blit_vertex / " << fragmentName << "\n";
-            if (vertexFunction) vertexFunction->release();
-            if (fragmentFunction) fragmentFunction->release();
+        NS::String* csName = NS::String::string(kernelName, NS::UTF8StringEncoding);
+        MTL::Function* computeFunction = m_library->newFunction(csName);
+        if (!computeFunction) {
+            std::cerr << "Missing SSR shader function: " << kernelName << "\n";
             return;
         }
 
-        MTL::RenderPipelineDescriptor* descriptor = MTL::RenderPipelineDescriptor::alloc()->init();
-        descriptor->setVertexFunction(vertexFunction);
-        descriptor->setFragmentFunction(fragmentFunction);
-        descriptor->setSampleCount(1);
-        descriptor->colorAttachments()->object(0)->setPixelFormat(MTL::PixelFormatR8Unorm);
-        descriptor->setDepthAttachmentPixelFormat(MTL::PixelFormatInvalid);
-
         NS::Error* error = nullptr;
-        outState = m_device->newRenderPipelineState(descriptor, &error);
+        outState = m_device->newComputePipelineState(computeFunction, &error);
+        computeFunction->release();
         if (!outState) {
-            std::cerr << "Failed to create SSAO pipeline state" << std::endl;
+            std::cerr << "Failed to create SSR pipeline state: " << kernelName << std::endl;
             if (error) {
                 std::cerr << "Error: " << error->localizedDescription()->utf8String() << std::endl;
             }
         }
-
-        descriptor->release();
-        vertexFunction->release();
-        fragmentFunction->release();
     };
 
-    buildPipeline("ssao_fragment", m_ssaoPipelineState);
-    buildPipeline("ssao_blur_fragment", m_ssaoBlurPipelineState);
-}
-
-void Renderer::buildSSAONoiseTexture() {
-    if (!m_device) {
-        return;
-    }
-    if (m_ssaoNoiseTexture) {
-        m_ssaoNoiseTexture->release();
-        m_ssaoNoiseTexture = nullptr;
-    }
-
-    constexpr uint32_t noiseSize = 4;
-    std::array<uint8_t, noiseSize * noiseSize * 4> data{};
-    std::mt19937 rng(1337);
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-
-    for (size_t i = 0; i < noiseSize * noiseSize; ++i) {
-        float x = dist(rng) * 2.0f - 1.0f;
-        float y = dist(rng) * 2.0f - 1.0f;
-        Math::Vector3 v(x, y, 0.0f);
-        v = v.length() > 0.0f ? v.normalized() : Math::Vector3(1.0f, 0.0f, 0.0f);
-        data[i * 4 + 0] = static_cast<uint8_t>((v.x * 0.5f + 0.5f) * 255.0f);
-        data[i * 4 + 1] = static_cast<uint8_t>((v.y * 0.5f + 0.5f) * 255.0f);
-        data[i * 4 + 2] = 0;
-        data[i * 4 + 3] = 255;
-    }
-
-    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
-    desc->setTextureType(MTL::TextureType2D);
-    desc->setWidth(noiseSize);
-    desc->setHeight(noiseSize);
-    desc->setPixelFormat(MTL::PixelFormatRGBA8Unorm);
-    desc->setUsage(MTL::TextureUsageShaderRead);
-    desc->setStorageMode(MTL::StorageModeShared);
-    m_ssaoNoiseTexture = m_device->newTexture(desc);
-    desc->release();
-
-    if (m_ssaoNoiseTexture) {
-        MTL::Region region = MTL::Region::Make2D(0, 0, noiseSize, noiseSize);
-        m_ssaoNoiseTexture->replaceRegion(region, 0, data.data(), noiseSize * 4);
-    }
+    buildPipeline("ssr_hiz_init", m_ssrHizInitPipeline);
+    buildPipeline("ssr_hiz_downsample", m_ssrHizDownsamplePipeline);
+    buildPipeline("ssr_trace", m_ssrTracePipeline);
+    buildPipeline("ssr_temporal", m_ssrTemporalPipeline);
 }
 
 void Renderer::buildImpostorPipeline() {
@@ -1920,6 +2793,8 @@ void Renderer::buildImpostorPipeline() {
     descriptor->setVertexFunction(vertexFunction);
     descriptor->setFragmentFunction(fragmentFunction);
     descriptor->setSampleCount(1);
+    MTL::VertexDescriptor* vertexDescriptor = GeometryBuffer::NewVertexDescriptor(GeometryBuffer::VertexStreams::Full, false);
+    descriptor->setVertexDescriptor(vertexDescriptor);
     descriptor->colorAttachments()->object(0)->setPixelFormat(MTL::PixelFormatRGBA8Unorm);
     descriptor->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
 
@@ -1932,6 +2807,7 @@ void Renderer::buildImpostorPipeline() {
         }
     }
 
+    vertexDescriptor->release();
     descriptor->release();
     vertexFunction->release();
     fragmentFunction->release();
@@ -1999,12 +2875,12 @@ void Renderer::buildDecalPipeline() {
         m_decalPipelineState = nullptr;
     }
 
-    NS::String* vsName = NS::String::string("blit_vertex", NS::UTF8StringEncoding);
+    NS::String* vsName = NS::String::string("decal_box_vertex", NS::UTF8StringEncoding);
     NS::String* fsName = NS::String::string("decal_fragment", NS::UTF8StringEncoding);
     MTL::Function* vertexFunction = m_library->newFunction(vsName);
     MTL::Function* fragmentFunction = m_library->newFunction(fsName);
     if (!vertexFunction || !fragmentFunction) {
-        std::cerr << "Missing Decal shader functions: blit_vertex / decal_fragment\n";
+        std::cerr << "Missing Decal shader functions: decal_box_vertex / decal_fragment\n";
         if (vertexFunction) vertexFunction->release();
         if (fragmentFunction) fragmentFunction->release();
         return;
@@ -2014,9 +2890,10 @@ void Renderer::buildDecalPipeline() {
     descriptor->setVertexFunction(vertexFunction);
     descriptor->setFragmentFunction(fragmentFunction);
     descriptor->setSampleCount(1);
-    descriptor->colorAttachments()->object(0)->setPixelFormat(MTL::PixelFormatRGBA16Float);
-    descriptor->colorAttachments()->object(1)->setPixelFormat(MTL::PixelFormatRGBA16Float);
-    descriptor->colorAttachments()->object(2)->setPixelFormat(MTL::PixelFormatRGBA16Float);
+    const MTL::PixelFormat decalFormat = static_cast<MTL::PixelFormat>(m_decalTargetFormat);
+    descriptor->colorAttachments()->object(0)->setPixelFormat(decalFormat);
+    descriptor->colorAttachments()->object(1)->setPixelFormat(decalFormat);
+    descriptor->colorAttachments()->object(2)->setPixelFormat(decalFormat);
     descriptor->setDepthAttachmentPixelFormat(MTL::PixelFormatInvalid);
 
     for (int i = 0; i < 3; ++i) {
@@ -2097,6 +2974,10 @@ void Renderer::buildFogPipeline() {
         m_fogPipelineState->release();
         m_fogPipelineState = nullptr;
     }
+    if (m_ssrFogPipelineState) {
+        m_ssrFogPipelineState->release();
+        m_ssrFogPipelineState = nullptr;
+    }
     if (m_fogVolumePipelineState) {
         m_fogVolumePipelineState->release();
         m_fogVolumePipelineState = nullptr;
@@ -2135,6 +3016,20 @@ void Renderer::buildFogPipeline() {
         }
     }
 
+    // Optional: without it SSR and fog keep their own passes.
+    NS::String* fusedName = NS::String::string("ssr_fog_fragment", NS::UTF8StringEncoding);
+    MTL::Function* fusedFunction = m_library->newFunction(fusedName);
+    if (fusedFunction) {
+        descriptor->setFragmentFunction(fusedFunction);
+        error = nullptr;
+        m_ssrFogPipelineState = m_device->newRenderPipelineState(descriptor, &error);
+        if (!m_ssrFogPipelineState && error) {
+            std::cerr << "Failed to create SSR fog pipeline state: "
+                      << error->localizedDescription()->utf8String() << std::endl;
+        }
+        fusedFunction->release();
+    }
+
     descriptor->release();
     vertexFunction->release();
     fragmentFunction->release();
@@ -2177,26 +3072,6 @@ void Renderer::buildMotionBlurPipeline() {
         m_motionBlurPipelineState->release();
         m_motionBlurPipelineState = nullptr;
     }
-    if (m_instanceCullPipeline) {
-        m_instanceCullPipeline->release();
-        m_instanceCullPipeline = nullptr;
-    }
-    if (m_instanceCullHzbPipeline) {
-        m_instanceCullHzbPipeline->release();
-        m_instanceCullHzbPipeline = nullptr;
-    }
-    if (m_instanceIndirectPipeline) {
-        m_instanceIndirectPipeline->release();
-        m_instanceIndirectPipeline = nullptr;
-    }
-    if (m_hzbInitPipeline) {
-        m_hzbInitPipeline->release();
-        m_hzbInitPipeline = nullptr;
-    }
-    if (m_hzbDownsamplePipeline) {
-        m_hzbDownsamplePipeline->release();
-        m_hzbDownsamplePipeline = nullptr;
-    }
 
     NS::String* vsName = NS::String::string("blit_vertex", NS::UTF8StringEncoding);
     NS::String* fsName = NS::String::string("motion_blur_fragment", NS::UTF8StringEncoding);
@@ -2288,10 +3163,25 @@ void Renderer::buildBloomPipelines() {
         fragmentFunction->release();
     };
 
-    buildPipeline("bloom_prefilter_fragment", MTL::PixelFormatRGBA16Float, false, m_bloomPrefilterPipelineState);
-    buildPipeline("bloom_downsample_fragment", MTL::PixelFormatRGBA16Float, false, m_bloomDownsamplePipelineState);
-    buildPipeline("bloom_upsample_fragment", MTL::PixelFormatRGBA16Float, true, m_bloomUpsamplePipelineState);
+    const MTL::PixelFormat bloomFormat = static_cast<MTL::PixelFormat>(m_bloomFormat);
+    buildPipeline("bloom_prefilter_fragment", bloomFormat, false, m_bloomPrefilterPipelineState);
+    buildPipeline("bloom_downsample_fragment", bloomFormat, false, m_bloomDownsamplePipelineState);
+    buildPipeline("bloom_upsample_fragment", bloomFormat, true, m_bloomUpsamplePipelineState);
     buildPipeline("bloom_combine_fragment", MTL::PixelFormatBGRA8Unorm, false, m_bloomCombinePipelineState);
+
+    if (m_bloomDownsampleSPDPipeline) {
+        m_bloomDownsampleSPDPipeline->release();
+        m_bloomDownsampleSPDPipeline = nullptr;
+    }
+    MTL::Function* spdFunction = m_library->newFunction(NS::String::string("bloom_downsample_spd", NS::UTF8StringEncoding));
+    if (spdFunction) {
+        NS::Error* error = nullptr;
+        m_bloomDownsampleSPDPipeline = m_device->newComputePipelineState(spdFunction, &error);
+        if (!m_bloomDownsampleSPDPipeline && error) {
+            std::cerr << "Failed to create bloom SPD pipeline: " << error->localizedDescription()->utf8String() << std::endl;
+        }
+        spdFunction->release();
+    }
 }
 
 void Renderer::buildTAAPipeline() {
@@ -2336,103 +3226,129 @@ void Renderer::buildTAAPipeline() {
     descriptor->release();
     vertexFunction->release();
     fragmentFunction->release();
+
+    if (m_taaResolvePipeline) {
+        m_taaResolvePipeline->release();
+        m_taaResolvePipeline = nullptr;
+    }
+    MTL::Function* resolveFunction = m_library->newFunction(NS::String::string("taa_resolve", NS::UTF8StringEncoding));
+    if (!resolveFunction) {
+        std::cerr << "Missing TAA shader function: taa_resolve, using taa_fragment\n";
+        return;
+    }
+    error = nullptr;
+    m_taaResolvePipeline = m_device->newComputePipelineState(resolveFunction, &error);
+    resolveFunction->release();
+    if (!m_taaResolvePipeline) {
+        std::cerr << "Failed to create TAA resolve pipeline state" << std::endl;
+        if (error) {
+            std::cerr << "Error: " << error->localizedDescription()->utf8String() << std::endl;
+        }
+    }
 }
 
-MTL::RenderPipelineState* Renderer::getPipelineState(const PipelineStateKey& key) {
-    // Check cache
-    auto it = m_pipelineStates.find(key);
-    if (it != m_pipelineStates.end()) {
-        return it->second;
+struct Renderer::PipelineCompileQueue {
+    struct Result {
+        PipelineStateKey key;
+        MTL::RenderPipelineState* state = nullptr;
+        uint32_t generation = 0;
+        bool prewarm = false;
+        float compileMs = 0.0f;
+    };
+    std::mutex mutex;
+    std::vector<Result> completed;
+
+    ~PipelineCompileQueue() {
+        for (Result& result : completed) {
+            if (result.state) {
+                result.state->release();
+            }
+        }
+    }
+};
+
+MTL::Function* Renderer::newPbrFragmentFunction(uint8_t features, bool materialTable, bool weightedBlended, bool visibility) {
+    MTL::FunctionConstantValues* constants = MTL::FunctionConstantValues::alloc()->init();
+    uint32_t featureBits = features;
+    constants->setConstantValue(&featureBits, MTL::DataTypeUInt, NS::UInteger(0));
+    constants->setConstantValue(&materialTable, MTL::DataTypeBool, NS::UInteger(1));
+    constants->setConstantValue(&weightedBlended, MTL::DataTypeBool, NS::UInteger(2));
+    constants->setConstantValue(&visibility, MTL::DataTypeBool, NS::UInteger(3));
+    NS::Error* error = nullptr;
+    MTL::Function* function = m_library->newFunction(NS::String::string("fragment_main", NS::UTF8StringEncoding),
+                                                     constants, &error);
+    constants->release();
+    if (!function) {
+        std::cerr << "Failed to specialize fragment_main for features 0x" << std::hex << uint32_t(features) << std::dec
+                  << (materialTable ? " (material table)" : "") << (visibility ? " (visibility)" : "");
+        if (error) {
+            std::cerr << ": " << error->localizedDescription()->utf8String();
+        }
+        std::cerr << std::endl;
     }
+    return function;
+}
 
-    if (key.isInstanced && key.isSkinned) {
-        std::cerr << "Invalid pipeline key: instanced + skinned not supported\n";
+MTL::RenderPipelineDescriptor* Renderer::newPipelineDescriptor(const PipelineStateKey& key) {
+    const char* vertexName = key.isInstanced
+        ? (key.isSkinned ? "vertex_skinned_instanced"
+            : (key.isVertexAnimated ? "vertex_vat_instanced"
+            : (key.isTerrain ? "vertex_terrain_instanced" : "vertex_main_instanced")))
+        : (key.isSkinned ? "vertex_skinned" : "vertex_main");
+    if (key.isVisibility) {
+        vertexName = "vertex_visibility_tile";
+    }
+    MTL::Function* vertexFunction = m_library->newFunction(NS::String::string(vertexName, NS::UTF8StringEncoding));
+    MTL::Function* fragmentFunction = newPbrFragmentFunction(key.pbrFeatures, key.materialTable, key.weightedBlended,
+                                                             key.isVisibility);
+    if (!vertexFunction || !fragmentFunction) {
+        std::cerr << "Missing PBR shader functions: " << vertexName << " / fragment_main\n";
+        if (vertexFunction) vertexFunction->release();
+        if (fragmentFunction) fragmentFunction->release();
         return nullptr;
     }
-    
-    // Create new pipeline state
+
     MTL::RenderPipelineDescriptor* descriptor = MTL::RenderPipelineDescriptor::alloc()->init();
-    
-    // Load shaders
-    const char* vertexName = key.isInstanced ? "vertex_main_instanced"
-        : (key.isSkinned ? "vertex_skinned" : "vertex_main");
-    NS::String* vertexFunctionName = NS::String::string(vertexName, NS::UTF8StringEncoding);
-    NS::String* fragmentFunctionName = NS::String::string("fragment_main", NS::UTF8StringEncoding);
-    
-    MTL::Function* vertexFunction = m_library->newFunction(vertexFunctionName);
-    MTL::Function* fragmentFunction = m_library->newFunction(fragmentFunctionName);
-    
     descriptor->setVertexFunction(vertexFunction);
     descriptor->setFragmentFunction(fragmentFunction);
     descriptor->setSampleCount(std::max<uint8_t>(1, key.sampleCount));
+    // Instanced pipelines also execute the static scene's indirect command buffers.
+    descriptor->setSupportIndirectCommandBuffers(key.isInstanced);
+    vertexFunction->release();
+    fragmentFunction->release();
     
-    // Configure vertex descriptor
-    MTL::VertexDescriptor* vertexDescriptor = MTL::VertexDescriptor::alloc()->init();
-    
-    // Position (attribute 0)
-    vertexDescriptor->attributes()->object(0)->setFormat(MTL::VertexFormatFloat3);
-    vertexDescriptor->attributes()->object(0)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, position)));
-    vertexDescriptor->attributes()->object(0)->setBufferIndex(0);
-    
-    // Normal (attribute 1)
-    vertexDescriptor->attributes()->object(1)->setFormat(MTL::VertexFormatFloat3);
-    vertexDescriptor->attributes()->object(1)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, normal)));
-    vertexDescriptor->attributes()->object(1)->setBufferIndex(0);
-    
-    // TexCoord (attribute 2)
-    vertexDescriptor->attributes()->object(2)->setFormat(MTL::VertexFormatFloat2);
-    vertexDescriptor->attributes()->object(2)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, texCoord)));
-    vertexDescriptor->attributes()->object(2)->setBufferIndex(0);
-
-    // Lightmap TexCoord (attribute 6)
-    vertexDescriptor->attributes()->object(6)->setFormat(MTL::VertexFormatFloat2);
-    vertexDescriptor->attributes()->object(6)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, texCoord1)));
-    vertexDescriptor->attributes()->object(6)->setBufferIndex(0);
-    
-    // Tangent (attribute 3)
-    vertexDescriptor->attributes()->object(3)->setFormat(MTL::VertexFormatFloat3);
-    vertexDescriptor->attributes()->object(3)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, tangent)));
-    vertexDescriptor->attributes()->object(3)->setBufferIndex(0);
-    
-    // Bitangent (attribute 4)
-    vertexDescriptor->attributes()->object(4)->setFormat(MTL::VertexFormatFloat3);
-    vertexDescriptor->attributes()->object(4)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, bitangent)));
-    vertexDescriptor->attributes()->object(4)->setBufferIndex(0);
-    
-    // Color (attribute 5)
-    vertexDescriptor->attributes()->object(5)->setFormat(MTL::VertexFormatFloat4);
-    vertexDescriptor->attributes()->object(5)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, color)));
-    vertexDescriptor->attributes()->object(5)->setBufferIndex(0);
-    
-    // Vertex buffer layout (stride = sizeof(Vertex))
-    vertexDescriptor->layouts()->object(0)->setStride(static_cast<NS::UInteger>(sizeof(Vertex)));
-    vertexDescriptor->layouts()->object(0)->setStepFunction(MTL::VertexStepFunctionPerVertex);
-
-    if (key.isSkinned) {
-        // Bone indices (attribute 7) - uint4
-        vertexDescriptor->attributes()->object(7)->setFormat(MTL::VertexFormatUInt4);
-        vertexDescriptor->attributes()->object(7)->setOffset(0);
-        vertexDescriptor->attributes()->object(7)->setBufferIndex(4);
-
-        // Bone weights (attribute 8) - float4
-        vertexDescriptor->attributes()->object(8)->setFormat(MTL::VertexFormatFloat4);
-        vertexDescriptor->attributes()->object(8)->setOffset(sizeof(uint32_t) * 4);
-        vertexDescriptor->attributes()->object(8)->setBufferIndex(4);
-
-        vertexDescriptor->layouts()->object(4)->setStride(sizeof(uint32_t) * 4 + sizeof(float) * 4);
-        vertexDescriptor->layouts()->object(4)->setStepFunction(MTL::VertexStepFunctionPerVertex);
+    // Configure vertex descriptor; visibility tile quads are generated from their ids.
+    if (!key.isVisibility) {
+        MTL::VertexDescriptor* vertexDescriptor = GeometryBuffer::NewVertexDescriptor(GeometryBuffer::VertexStreams::Full, key.isSkinned);
+        descriptor->setVertexDescriptor(vertexDescriptor);
+        vertexDescriptor->release();
     }
     
-    descriptor->setVertexDescriptor(vertexDescriptor);
-    
     if (key.alphaToCoverage && key.sampleCount > 1) {
         descriptor->setAlphaToCoverageEnabled(true);
     }
 
     // Color attachment
-    descriptor->colorAttachments()->object(0)->setPixelFormat(key.hdrTarget ? MTL::PixelFormatRGBA16Float : MTL::PixelFormatBGRA8Unorm);
-    
-    if (key.isTransparent) {
+    descriptor->colorAttachments()->object(0)->setPixelFormat(
+        key.hdrTarget ? static_cast<MTL::PixelFormat>(m_hdrColorFormat) : MTL::PixelFormatBGRA8Unorm);
+    
+    if (key.weightedBlended) {
+        // Weighted colour adds up in the accumulation target; revealage multiplies by 1 - alpha.
+        MTL::RenderPipelineColorAttachmentDescriptor* accumulation = descriptor->colorAttachments()->object(0);
+        accumulation->setPixelFormat(MTL::PixelFormatRGBA16Float);
+        accumulation->setBlendingEnabled(true);
+        accumulation->setSourceRGBBlendFactor(MTL::BlendFactorOne);
+        accumulation->setDestinationRGBBlendFactor(MTL::BlendFactorOne);
+        accumulation->setSourceAlphaBlendFactor(MTL::BlendFactorOne);
+        accumulation->setDestinationAlphaBlendFactor(MTL::BlendFactorOne);
+        MTL::RenderPipelineColorAttachmentDescriptor* revealage = descriptor->colorAttachments()->object(1);
+        revealage->setPixelFormat(MTL::PixelFormatR16Float);
+        revealage->setBlendingEnabled(true);
+        revealage->setSourceRGBBlendFactor(MTL::BlendFactorZero);
+        revealage->setDestinationRGBBlendFactor(MTL::BlendFactorOneMinusSourceColor);
+        revealage->setSourceAlphaBlendFactor(MTL::BlendFactorZero);
+        revealage->setDestinationAlphaBlendFactor(MTL::BlendFactorOneMinusSourceAlpha);
+    } else if (key.isTransparent) {
         // Enable blending for transparency
         descriptor->colorAttachments()->object(0)->setBlendingEnabled(true);
         descriptor->colorAttachments()->object(0)->setSourceRGBBlendFactor(MTL::BlendFactorSourceAlpha);
@@ -2445,84 +3361,539 @@ MTL::RenderPipelineState* Renderer::getPipelineState(const PipelineStateKey& key
     
     // Depth attachment
     descriptor->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
-    
-    // Create pipeline state
-    NS::Error* error = nullptr;
-    MTL::RenderPipelineState* pipelineState = m_device->newRenderPipelineState(descriptor, &error);
-    
-    if (!pipelineState) {
-        std::cerr << "Failed to create pipeline state!" << std::endl;
-        if (error) {
-            std::cerr << "Error: " << error->localizedDescription()->utf8String() << std::endl;
-        }
-    } else {
-        std::cout << "Pipeline state created" << std::endl;
+    PipelineArchive::getInstance().attach(descriptor);
+    return descriptor;
+}
+
+bool Renderer::requestPipelineCompile(const PipelineStateKey& key, bool prewarm) {
+    // A pipeline that failed to build stays pending, so it is not retried every frame.
+    if (!m_pendingPipelines.insert(key).second) {
+        return false;
     }
-    
-    // Cache it only on success
-    if (pipelineState) {
-        m_pipelineStates[key] = pipelineState;
+    MTL::RenderPipelineDescriptor* descriptor = newPipelineDescriptor(key);
+    if (!descriptor) {
+        return false;
     }
-    
-    // Cleanup
-    vertexDescriptor->release();
+    std::shared_ptr<PipelineCompileQueue> queue = m_pipelineCompileQueue;
+    const uint32_t generation = m_pipelineGeneration;
+    const auto compileStart = std::chrono::steady_clock::now();
+    ++m_pipelineCompilesInFlight;
+    m_device->newRenderPipelineState(descriptor, [queue, key, generation, prewarm, compileStart](MTL::RenderPipelineState* state, NS::Error* error) {
+        const float compileMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - compileStart).count();
+        if (!state) {
+            std::cerr << "Failed to create pipeline 0x" << std::hex << key.pack() << std::dec;
+            if (error) {
+                std::cerr << ": " << error->localizedDescription()->utf8String();
+            }
+            std::cerr << std::endl;
+        }
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->completed.push_back({key, state ? state->retain() : nullptr, generation, prewarm, compileMs});
+    });
     descriptor->release();
-    vertexFunction->release();
-    fragmentFunction->release();
-    
-    return pipelineState;
+    return true;
 }
 
-void Renderer::setMetalLayer(void* layer) {
-    setMetalLayer(layer, true);
+bool Renderer::serviceBackgroundWork() {
+    const uint32_t compilesBefore = m_pipelineCompilesInFlight;
+    const size_t bakesBefore = getPendingImpostorBakes();
+    size_t texturesStreamed = 0;
+    collectCompiledPipelines();
+    uploadPendingMeshes();
+    if (m_impostorBaker) {
+        m_impostorBaker->collect(m_textureLoader.get());
+    }
+    const bool environmentSwapped = collectEnvironment();
+    if (m_textureLoader) {
+        texturesStreamed = m_textureLoader->processStreamedTextures();
+        if (m_textureStreamer) {
+            m_textureStreamer->update(*m_textureLoader);
+        }
+    }
+    return texturesStreamed > 0
+        || environmentSwapped
+        || m_pipelineCompilesInFlight < compilesBefore
+        || getPendingImpostorBakes() < bakesBefore;
 }
 
-void Renderer::setMetalLayer(void* layer, bool applySize) {
-    m_metalLayer = static_cast<CA::MetalLayer*>(layer);
-    
-    if (m_metalLayer) {
-        m_metalLayer->setDevice(m_device);
-        m_metalLayer->setPixelFormat(MTL::PixelFormatBGRA8Unorm);
-        
-        if (applySize) {
-            // Get initial size
-            auto drawableSize = m_metalLayer->drawableSize();
-            float width = static_cast<float>(drawableSize.width);
-            float height = static_cast<float>(drawableSize.height);
-            
-            // Only resize if we have valid dimensions
-            if (width > 0 && height > 0) {
-                resize(width, height);
-            } else {
-                m_viewportWidth = 1920.0f;
-                m_viewportHeight = 1080.0f;
+bool Renderer::updateIdleFrame() {
+    if (m_viewFrame == m_engineFrame) {
+        return false;
+    }
+    return serviceBackgroundWork();
+}
+
+void Renderer::collectCompiledPipelines() {
+    std::vector<PipelineCompileQueue::Result> completed;
+    {
+        std::lock_guard<std::mutex> lock(m_pipelineCompileQueue->mutex);
+        completed.swap(m_pipelineCompileQueue->completed);
+    }
+    for (PipelineCompileQueue::Result& result : completed) {
+        if (m_pipelineCompilesInFlight > 0) {
+            --m_pipelineCompilesInFlight;
+        }
+        // Log4 buckets: <1, <4, <16, <64, <256 and >=256 ms.
+        size_t bucket = 0;
+        for (float limitMs = 1.0f; bucket + 1 < kPipelineCompileBuckets && result.compileMs >= limitMs; limitMs *= 4.0f) {
+            ++bucket;
+        }
+        ++m_pipelineCompileHistogram[bucket];
+        if (result.compileMs > m_slowestPipelineCompileMs) {
+            m_slowestPipelineCompileMs = result.compileMs;
+            m_slowestPipelineKey = result.key.pack();
+        }
+        if (result.prewarm && m_pipelinePrewarmRemaining > 0 && --m_pipelinePrewarmRemaining == 0) {
+            const float prewarmMs = std::chrono::duration<float, std::milli>(
+                std::chrono::steady_clock::now() - m_pipelinePrewarmStart).count();
+            StartupLog("Pipeline pre-warm finished in " + std::to_string(prewarmMs) + "ms");
+            StartupTrace::getInstance().addSpan("renderer", "Pipeline pre-warm", m_pipelinePrewarmStart,
+                                                std::chrono::steady_clock::now());
+        }
+        if (!result.state) {
+            continue;
+        }
+        if (result.generation != m_pipelineGeneration) {
+            result.state->release();
+            continue;
+        }
+        m_pendingPipelines.erase(result.key);
+        if (m_pipelineStates.count(result.key) > 0) {
+            result.state->release();
+            continue;
+        }
+        m_pipelineStates[result.key] = result.state;
+    }
+}
+
+uint8_t Renderer::resolveScenePbrFeatures(bool hasDecals) const {
+    // Keyed on whether the scene has decals or probes at all, not on this frame's visibility, so
+    // variants do not churn as the camera moves.
+    uint8_t features = hasDecals ? kPbrFeatureDecals : 0;
+    if (m_probeVolumeGridCounts.w > 0.5f
+        && (m_probeVolumeFeatureParams.x > 0.5f || m_probeVolumeFeatureParams.y > 0.5f)) {
+        features |= kPbrFeatureProbes;
+    }
+    return features;
+}
+
+bool Renderer::beginPipelineArchive() {
+    if (!m_device || !PipelineArchive::getInstance().beginRecording(m_device)) {
+        return false;
+    }
+    m_archivedPipelineKeys.clear();
+    // Rebuild the shadow variants so their descriptors are recorded as well; the next frame resizes
+    // the atlas again.
+    if (m_shadowPass) {
+        m_shadowPass->shutdown();
+        if (!m_shadowPass->initialize(m_device, 4096, 1)) {
+            std::cerr << "Warning: ShadowRenderPass failed to initialize" << std::endl;
+        }
+        m_shadowAtlasResolution = 0;
+    }
+    return true;
+}
+
+void Renderer::collectScenePipelineKeys(Scene* scene, std::vector<PipelineStateKey>& keys) {
+    const RenderWorld& world = scene->getRenderWorld();
+    const auto& post = scene->getSettings().postProcess;
+    const bool hdrTarget = post.enabled && (post.bloom || post.toneMapping || post.colorGrading);
+    const uint8_t sampleCount = static_cast<uint8_t>(resolveSampleCount(static_cast<uint32_t>(std::max(1, scene->getSettings().quality.msaaSamples))));
+    const uint8_t precisionFeatures = scene->getSettings().quality.halfPrecisionShading ? kPbrFeatureHalfPrecision : 0;
+    const uint8_t scenePbrFeatures = resolveScenePbrFeatures(!world.getDecals().empty()) | precisionFeatures;
+
+    const bool materialTable = m_materialTable && m_materialTable->isAvailable();
+    auto addInstancedKey = [&](const Material* material, bool isSkinned = false, bool isVertexAnimated = false,
+                               bool isTerrain = false) {
+        PipelineStateKey key = ResolveMeshPipelineKey(material, isSkinned, false, 0, hdrTarget, sampleCount, false);
+        key.isInstanced = true;
+        key.isVertexAnimated = isVertexAnimated;
+        key.isTerrain = isTerrain;
+        key.pbrFeatures = kPbrFeatureAll | precisionFeatures;
+        keys.push_back(key);
+    };
+    for (const auto& proxy : world.getMeshRenderers()) {
+        MeshRenderer* meshRenderer = proxy.meshRenderer;
+        std::shared_ptr<Mesh> mesh = meshRenderer ? meshRenderer->getMesh() : nullptr;
+        if (!mesh) {
+            continue;
+        }
+        std::shared_ptr<Material> material = meshRenderer->getMaterial(0);
+        if (proxy.skinned && mesh->hasSkinWeights()) {
+            // Skinning cache entries draw through the static pipeline; palette skinning is the
+            // fallback when the cache is unavailable.
+            keys.push_back(ResolveMeshPipelineKey(material.get(), false, false, scenePbrFeatures, hdrTarget, sampleCount, materialTable));
+            keys.push_back(ResolveMeshPipelineKey(material.get(), true, false, scenePbrFeatures, hdrTarget, sampleCount, materialTable));
+            continue;
+        }
+        const bool staticLighting = !meshRenderer->getStaticLighting().lightmapPath.empty()
+            || meshRenderer->getUseBakedVertexLighting();
+        keys.push_back(ResolveMeshPipelineKey(material.get(), false, staticLighting, scenePbrFeatures, hdrTarget, sampleCount, materialTable));
+        // Auto-instanced batches and the static scene draw through the instanced ubershader.
+        addInstancedKey(material.get());
+    }
+    for (const auto& proxy : world.getInstancedRenderers()) {
+        if (proxy.instanced && proxy.instanced->getMesh()) {
+            addInstancedKey(proxy.instanced->getMaterial(0).get());
+            if (proxy.instanced->hasCrowdAnimation()) {
+                addInstancedKey(proxy.instanced->getMaterial(0).get(), true);
+            } else if (proxy.instanced->hasVertexAnimation()) {
+                addInstancedKey(proxy.instanced->getMaterial(0).get(), false, true);
             }
         }
     }
+    for (const auto& proxy : world.getTerrains()) {
+        addInstancedKey(proxy.meshRenderer->getMaterial(0).get(), false, false, true);
+    }
+    if (scene->getSettings().quality.visibilityBuffer && !world.getMeshRenderers().empty()) {
+        // One pipeline shades every static scene group from the visibility buffer.
+        PipelineStateKey key{true, true, true, false, false, false, false, hdrTarget, 1};
+        key.pbrFeatures = kPbrFeatureAll | precisionFeatures;
+        key.isVisibility = true;
+        keys.push_back(key);
+    }
 }
 
-Renderer::RenderTargetState& Renderer::getRenderTargetState(RenderTargetPool pool) {
-    switch (pool) {
-    case RenderTargetPool::Scene:
-        return m_sceneTargets;
-    case RenderTargetPool::Game:
-        return m_gameTargets;
-    case RenderTargetPool::Preview:
-        return m_previewTargets;
+size_t Renderer::recordScenePipelines(Scene* scene) {
+    PipelineArchive& archive = PipelineArchive::getInstance();
+    if (!scene || !archive.isRecording()) {
+        return 0;
     }
-    return m_sceneTargets;
+    updateProbeVolume(scene->getSettings().staticLighting);
+    std::vector<PipelineStateKey> keys;
+    collectScenePipelineKeys(scene, keys);
+
+    size_t recorded = 0;
+    auto recordKey = [&](const PipelineStateKey& key) {
+        if (!m_archivedPipelineKeys.insert(key).second) {
+            return;
+        }
+        MTL::RenderPipelineDescriptor* descriptor = newPipelineDescriptor(key);
+        if (!descriptor) {
+            return;
+        }
+        if (archive.record(descriptor)) {
+            archive.addKey(key.pack());
+            ++recorded;
+        }
+        descriptor->release();
+    };
+    for (const PipelineStateKey& key : keys) {
+        recordKey(key);
+        // Variants fall back to their ubershader while compiling, so that one is needed too.
+        if (key.pbrFeatures != kPbrFeatureAll) {
+            PipelineStateKey uberKey = key;
+            uberKey.pbrFeatures = kPbrFeatureAll;
+            recordKey(uberKey);
+        }
+    }
+    return recorded;
 }
 
-void Renderer::storeRenderTargetState(RenderTargetState& state) {
-    state.depthTexture = m_depthTexture;
-    state.msaaDepthTexture = m_msaaDepthTexture;
-    state.hzbTexture = m_hzbTexture;
-    state.hzbMipViews = m_hzbMipViews;
+size_t Renderer::prepareSceneResources(Scene* scene) {
+    if (!scene || !m_device) {
+        return 0;
+    }
+    std::vector<PipelineStateKey> keys;
+    collectScenePipelineKeys(scene, keys);
+    auto request = [this](const PipelineStateKey& key) {
+        if (!key.isMeshlet && m_pipelineStates.count(key) == 0) {
+            requestPipelineCompile(key, false);
+        }
+    };
+    for (const PipelineStateKey& key : keys) {
+        request(key);
+        if (key.pbrFeatures != kPbrFeatureAll) {
+            PipelineStateKey uberKey = key;
+            uberKey.pbrFeatures = kPbrFeatureAll;
+            request(uberKey);
+        }
+    }
+
+    const RenderWorld& world = scene->getRenderWorld();
+    const size_t queuedBefore = m_pendingMeshUploads.size();
+    auto queue = [this](const std::shared_ptr<Mesh>& mesh) {
+        if (mesh && !mesh->isUploaded()) {
+            m_pendingMeshUploads.push_back(mesh);
+        }
+    };
+    for (const auto& proxy : world.getMeshRenderers()) {
+        if (proxy.meshRenderer) {
+            queue(proxy.meshRenderer->getMesh());
+        }
+    }
+    for (const auto& proxy : world.getInstancedRenderers()) {
+        if (proxy.instanced) {
+            queue(proxy.instanced->getMesh());
+        }
+    }
+    for (const auto& proxy : world.getTerrains()) {
+        if (proxy.meshRenderer) {
+            queue(proxy.meshRenderer->getMesh());
+        }
+    }
+    return m_pendingMeshUploads.size() - queuedBefore;
+}
+
+size_t Renderer::uploadPendingMeshes() {
+    // Enough to drain a level's worth over a second or so without showing in the frame time.
+    constexpr size_t kMeshUploadsPerFrame = 16;
+    size_t uploaded = 0;
+    while (!m_pendingMeshUploads.empty() && uploaded < kMeshUploadsPerFrame) {
+        std::shared_ptr<Mesh> mesh = m_pendingMeshUploads.back().lock();
+        m_pendingMeshUploads.pop_back();
+        if (!mesh || mesh->isUploaded()) {
+            continue;
+        }
+        uploadMesh(mesh.get());
+        ++uploaded;
+    }
+    return uploaded;
+}
+
+bool Renderer::writePipelineArchive(const std::string& path) {
+    const bool written = PipelineArchive::getInstance().write(path);
+    PipelineArchive::getInstance().shutdown();
+    m_archivedPipelineKeys.clear();
+    return written;
+}
+
+bool Renderer::loadPipelineArchive(const std::string& path) {
+    const auto loadStart = std::chrono::steady_clock::now();
+    PipelineArchive& archive = PipelineArchive::getInstance();
+    if (!m_device || !archive.load(m_device, path)) {
+        return false;
+    }
+    // Pre-warm every recorded key on Metal's compile queue; with the archive attached these are
+    // lookups rather than compiles, and the results are picked up at the start of a frame.
+    collectCompiledPipelines();
+    m_pipelinePrewarmStart = loadStart;
+    m_pipelinePrewarmRemaining = 0;
+    const std::vector<uint32_t> keys = archive.getKeys();
+    for (uint32_t bits : keys) {
+        PipelineStateKey key = PipelineStateKey::Unpack(bits);
+        if (key.isMeshlet || m_pipelineStates.count(key) > 0) {
+            continue;
+        }
+        if (requestPipelineCompile(key, true)) {
+            ++m_pipelinePrewarmRemaining;
+        }
+    }
+    const float loadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    StartupLog("PipelineArchive " + path + " keys=" + std::to_string(keys.size()) +
+               " prewarming=" + std::to_string(m_pipelinePrewarmRemaining) +
+               " opened in " + std::to_string(loadMs) + "ms");
+    return true;
+}
+
+MTL::RenderPipelineState* Renderer::getPipelineState(const PipelineStateKey& key) {
+    // Check cache
+    auto it = m_pipelineStates.find(key);
+    if (it != m_pipelineStates.end()) {
+        return it->second;
+    }
+
+    if (key.isMeshlet) {
+        // Meshlet batches only use the ubershader, built synchronously the first time.
+        if (key.pbrFeatures != kPbrFeatureAll) {
+            PipelineStateKey uberKey = key;
+            uberKey.pbrFeatures = kPbrFeatureAll;
+            return getPipelineState(uberKey);
+        }
+        MTL::RenderPipelineState* pipelineState = buildMeshletPipelineState(key);
+        if (pipelineState) {
+            m_pipelineStates[key] = pipelineState;
+        }
+        return pipelineState;
+    }
+
+    collectCompiledPipelines();
+    it = m_pipelineStates.find(key);
+    if (it != m_pipelineStates.end()) {
+        return it->second;
+    }
+    // Never compile on the render thread: start an async compile and draw with whatever cached
+    // pipeline is compatible until it lands. Variants also queue their ubershader, which is the
+    // fallback every later variant of the same layout can use.
+    requestPipelineCompile(key, false);
+    if (key.pbrFeatures != kPbrFeatureAll) {
+        PipelineStateKey uberKey = key;
+        uberKey.pbrFeatures = kPbrFeatureAll;
+        if (m_pipelineStates.count(uberKey) == 0) {
+            requestPipelineCompile(uberKey, false);
+        }
+    }
+    m_stats.pipelineFallbackDraws++;
+    return findFallbackPipeline(key);
+}
+
+MTL::RenderPipelineState* Renderer::findFallbackPipeline(const PipelineStateKey& key) const {
+    // Vertex layout, blending, attachments and the material binding model must match.
+    // fragment_main variants only compile paths out, so any pipeline whose features cover the
+    // key's shades it correctly; alpha-to-coverage and shading precision are matched when possible
+    // but only change edge quality and rounding.
+    const uint8_t requiredFeatures = key.pbrFeatures & kPbrFeatureAll;
+    MTL::RenderPipelineState* fallback = nullptr;
+    for (const auto& entry : m_pipelineStates) {
+        const PipelineStateKey& candidate = entry.first;
+        if (!entry.second || candidate.isMeshlet
+            || candidate.hasNormals != key.hasNormals
+            || candidate.hasTexCoords != key.hasTexCoords
+            || candidate.hasTangents != key.hasTangents
+            || candidate.isTransparent != key.isTransparent
+            || candidate.isSkinned != key.isSkinned
+            || candidate.isInstanced != key.isInstanced
+            || candidate.isVertexAnimated != key.isVertexAnimated
+            || candidate.isTerrain != key.isTerrain
+            || candidate.isVisibility != key.isVisibility
+            || candidate.hdrTarget != key.hdrTarget
+            || candidate.sampleCount != key.sampleCount
+            || candidate.materialTable != key.materialTable
+            || candidate.weightedBlended != key.weightedBlended
+            || (candidate.pbrFeatures & requiredFeatures) != requiredFeatures) {
+            continue;
+        }
+        if (candidate.alphaToCoverage == key.alphaToCoverage
+            && (candidate.pbrFeatures & kPbrFeatureHalfPrecision) == (key.pbrFeatures & kPbrFeatureHalfPrecision)) {
+            return entry.second;
+        }
+        if (!fallback) {
+            fallback = entry.second;
+        }
+    }
+    return fallback;
+}
+
+MTL::RenderPipelineState* Renderer::buildMeshletPipelineState(const PipelineStateKey& key) {
+    if (!m_meshletPipelineSupported || key.isSkinned || key.isTransparent) {
+        return nullptr;
+    }
+    MTL::Function* objectFunction = m_library->newFunction(NS::String::string("meshlet_object", NS::UTF8StringEncoding));
+    MTL::Function* meshFunction = m_library->newFunction(NS::String::string("meshlet_mesh", NS::UTF8StringEncoding));
+    MTL::Function* fragmentFunction = newPbrFragmentFunction(key.pbrFeatures, key.materialTable, key.weightedBlended, false);
+    MTL::RenderPipelineState* pipelineState = nullptr;
+    if (objectFunction && meshFunction && fragmentFunction) {
+        MTL::MeshRenderPipelineDescriptor* descriptor = MTL::MeshRenderPipelineDescriptor::alloc()->init();
+        descriptor->setObjectFunction(objectFunction);
+        descriptor->setMeshFunction(meshFunction);
+        descriptor->setFragmentFunction(fragmentFunction);
+        descriptor->setMaxTotalThreadsPerObjectThreadgroup(kMeshletsPerObjectThreadgroup);
+        descriptor->setMaxTotalThreadsPerMeshThreadgroup(kMeshletMeshThreads);
+        descriptor->setRasterSampleCount(std::max<uint8_t>(1, key.sampleCount));
+        if (key.alphaToCoverage && key.sampleCount > 1) {
+            descriptor->setAlphaToCoverageEnabled(true);
+        }
+        descriptor->colorAttachments()->object(0)->setPixelFormat(
+            key.hdrTarget ? static_cast<MTL::PixelFormat>(m_hdrColorFormat) : MTL::PixelFormatBGRA8Unorm);
+        descriptor->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
+
+        NS::Error* error = nullptr;
+        pipelineState = m_device->newRenderPipelineState(descriptor, MTL::PipelineOptionNone, nullptr, &error);
+        if (!pipelineState && error) {
+            std::cerr << "Failed to create meshlet pipeline: " << error->localizedDescription()->utf8String() << std::endl;
+        }
+        descriptor->release();
+    } else {
+        std::cerr << "Missing meshlet shaders\n";
+    }
+    if (!pipelineState) {
+        // Fall back to the indirect path: re-batch the static scene without meshlets.
+        m_meshletPipelineSupported = false;
+        m_staticScene.world = nullptr;
+    }
+    if (objectFunction) {
+        objectFunction->release();
+    }
+    if (meshFunction) {
+        meshFunction->release();
+    }
+    if (fragmentFunction) {
+        fragmentFunction->release();
+    }
+    return pipelineState;
+}
+
+void Renderer::setMetalLayer(void* layer) {
+    setMetalLayer(layer, true);
+}
+
+void Renderer::setMetalLayer(void* layer, bool applySize) {
+    m_metalLayer = static_cast<CA::MetalLayer*>(layer);
+    
+    if (m_metalLayer) {
+        m_metalLayer->setDevice(m_device);
+        m_metalLayer->setPixelFormat(MTL::PixelFormatBGRA8Unorm);
+
+        auto [entry, added] = m_layerPresentation.try_emplace(m_metalLayer);
+        LayerPresentation& presentation = entry->second;
+        if (added) {
+            presentation.defaultDrawableCount = m_metalLayer->maximumDrawableCount();
+        }
+        if (presentation.lowLatency != m_lowLatencyPresentation) {
+            // Display sync is left as the host set it (the benchmark turns it off to run uncapped).
+            m_metalLayer->setMaximumDrawableCount(m_lowLatencyPresentation ? 2 : presentation.defaultDrawableCount);
+            presentation.lowLatency = m_lowLatencyPresentation;
+        }
+        
+        if (applySize) {
+            // Get initial size
+            auto drawableSize = m_metalLayer->drawableSize();
+            float width = static_cast<float>(drawableSize.width);
+            float height = static_cast<float>(drawableSize.height);
+            
+            // Only resize if we have valid dimensions
+            if (width > 0 && height > 0) {
+                resize(width, height);
+            } else {
+                m_viewportWidth = 1920.0f;
+                m_viewportHeight = 1080.0f;
+            }
+        }
+    }
+}
+
+void Renderer::setLowLatencyPresentation(bool enabled) {
+    // Layers pick the change up the next time they are set for a view.
+    m_lowLatencyPresentation = enabled;
+    m_presentInterval = 0.0;
+}
+
+Renderer::RenderTargetState& Renderer::getRenderTargetState(RenderTargetPool pool) {
+    switch (pool) {
+    case RenderTargetPool::Scene:
+        return m_sceneTargets;
+    case RenderTargetPool::Game:
+        return m_gameTargets;
+    case RenderTargetPool::Preview:
+        return m_previewTargets;
+    }
+    return m_sceneTargets;
+}
+
+void Renderer::storeRenderTargetState(RenderTargetState& state) {
+    state.depthTexture = m_depthTexture;
+    state.msaaDepthTexture = m_msaaDepthTexture;
+    state.hzbTexture = m_hzbTexture;
+    state.hzbMipViews = m_hzbMipViews;
     state.hzbMipCount = m_hzbMipCount;
     state.normalTexture = m_normalTexture;
     state.ssaoTexture = m_ssaoTexture;
+    state.ssaoHistoryTexture = m_ssaoHistoryTexture;
+    state.ssaoAccumTexture = m_ssaoAccumTexture;
     state.ssaoBlurTexture = m_ssaoBlurTexture;
-    state.ssaoNoiseTexture = m_ssaoNoiseTexture;
+    state.ssaoWidth = m_ssaoWidth;
+    state.ssaoHeight = m_ssaoHeight;
+    state.ssaoResolution = m_ssaoResolution;
+    state.ssaoHistoryValid = m_ssaoHistoryValid;
+    state.ssrHizTexture = m_ssrHizTexture;
+    state.ssrHizMipViews = m_ssrHizMipViews;
+    state.ssrTraceTexture = m_ssrTraceTexture;
+    state.ssrHistoryTexture = m_ssrHistoryTexture;
+    state.ssrAccumTexture = m_ssrAccumTexture;
+    state.visibilityTexture = m_visibilityTexture;
+    state.ssrWidth = m_ssrWidth;
+    state.ssrHeight = m_ssrHeight;
+    state.ssrHistoryValid = m_ssrHistoryValid;
     state.velocityTexture = m_velocityTexture;
     state.dofTexture = m_dofTexture;
     state.fogTexture = m_fogTexture;
@@ -2548,6 +3919,7 @@ void Renderer::storeRenderTargetState(RenderTargetState& state) {
     state.bloomMipCount = m_bloomMipCount;
     state.taaHistoryTexture = m_taaHistoryTexture;
     state.taaCurrentTexture = m_taaCurrentTexture;
+    state.taaOutputTexture = m_taaOutputTexture;
     state.metalFXOutputTexture = m_metalFXOutputTexture;
     state.colorTexture = m_colorTexture;
     state.msaaColorTexture = m_msaaColorTexture;
@@ -2562,6 +3934,73 @@ void Renderer::storeRenderTargetState(RenderTargetState& state) {
     state.msaaSamples = m_msaaSamples;
 }
 
+void Renderer::updateMemoryUsage() {
+    // Heap placements are counted with the heap and views with the texture they view.
+    auto ownedBytes = [](const MTL::Texture* texture) -> uint64_t {
+        if (!texture || texture->heap() || texture->parentTexture()) {
+            return 0;
+        }
+        return texture->allocatedSize();
+    };
+    auto targetBytes = [&](const RenderTargetState& state) {
+        const MTL::Texture* textures[] = {
+            state.depthTexture, state.msaaDepthTexture, state.hzbTexture, state.normalTexture,
+            state.ssaoTexture, state.ssaoHistoryTexture, state.ssaoAccumTexture, state.ssaoBlurTexture,
+            state.ssrHizTexture, state.ssrTraceTexture, state.ssrHistoryTexture, state.ssrAccumTexture,
+            state.visibilityTexture,
+            state.velocityTexture, state.dofTexture, state.fogTexture, state.fogVolumeTexture,
+            state.fogVolumeHistoryTexture, state.postColorTexture, state.decalAlbedoTexture,
+            state.decalNormalTexture, state.decalOrmTexture, state.motionBlurTexture,
+            state.taaHistoryTexture, state.taaCurrentTexture, state.taaOutputTexture, state.metalFXOutputTexture,
+            state.colorTexture, state.msaaColorTexture
+        };
+        uint64_t bytes = 0;
+        for (const MTL::Texture* texture : textures) {
+            bytes += ownedBytes(texture);
+        }
+        for (const MTL::Texture* texture : state.bloomMipTextures) {
+            bytes += ownedBytes(texture);
+        }
+        return bytes;
+    };
+    // The active pool's targets live in the members until the next pool switch.
+    storeRenderTargetState(getRenderTargetState(m_activePool));
+    uint64_t renderTargetBytes = targetBytes(m_sceneTargets) + targetBytes(m_gameTargets) + targetBytes(m_previewTargets);
+    for (const RenderTargetState* state : {&m_sceneTargets, &m_gameTargets, &m_previewTargets}) {
+        if (state->persistentHeap) {
+            renderTargetBytes += state->persistentHeap->getHeapSize();
+        }
+    }
+    if (m_renderTargetHeap) {
+        renderTargetBytes += m_renderTargetHeap->getHeapSize();
+    }
+    m_renderTargetMemory.reset(MemoryCategory::RenderTargets, renderTargetBytes);
+
+    uint64_t instanceBytes = 0;
+    uint64_t skinningBytes = 0;
+    for (uint32_t slot = 0; slot < kMaxFramesInFlight; ++slot) {
+        instanceBytes += m_instanceBufferCapacities[slot] + m_instanceCullCapacities[slot]
+                       + m_instanceCountCapacities[slot] + m_instanceIndirectCapacities[slot];
+        skinningBytes += m_skinningBufferCapacities[slot];
+    }
+    m_instanceMemory.reset(MemoryCategory::Instances, instanceBytes);
+    m_skinningMemory.reset(MemoryCategory::Skinning, skinningBytes);
+    m_probeMemory.reset(MemoryCategory::Probes, m_probeVolumeBuffer ? m_probeVolumeBuffer->length() : 0);
+
+    MemoryTracker& tracker = MemoryTracker::getInstance();
+    tracker.setDeviceUsage(m_device->currentAllocatedSize(), m_device->recommendedMaxWorkingSetSize());
+    tracker.checkBudgets();
+
+    // Released textures and meshes kept for quick reloads are the first memory to give back.
+    const bool deviceOverBudget = tracker.isDeviceOverBudget();
+    if (m_textureLoader && (deviceOverBudget || tracker.isOverBudget(MemoryCategory::Textures))) {
+        m_textureLoader->purgeResidency();
+    }
+    if (deviceOverBudget || tracker.isOverBudget(MemoryCategory::Meshes)) {
+        Mesh::GetCookedResidency().purge();
+    }
+}
+
 void Renderer::loadRenderTargetState(const RenderTargetState& state) {
     m_depthTexture = state.depthTexture;
     m_msaaDepthTexture = state.msaaDepthTexture;
@@ -2570,8 +4009,22 @@ void Renderer::loadRenderTargetState(const RenderTargetState& state) {
     m_hzbMipCount = state.hzbMipCount;
     m_normalTexture = state.normalTexture;
     m_ssaoTexture = state.ssaoTexture;
+    m_ssaoHistoryTexture = state.ssaoHistoryTexture;
+    m_ssaoAccumTexture = state.ssaoAccumTexture;
     m_ssaoBlurTexture = state.ssaoBlurTexture;
-    m_ssaoNoiseTexture = state.ssaoNoiseTexture;
+    m_ssaoWidth = state.ssaoWidth;
+    m_ssaoHeight = state.ssaoHeight;
+    m_ssaoResolution = state.ssaoResolution;
+    m_ssaoHistoryValid = state.ssaoHistoryValid;
+    m_ssrHizTexture = state.ssrHizTexture;
+    m_ssrHizMipViews = state.ssrHizMipViews;
+    m_ssrTraceTexture = state.ssrTraceTexture;
+    m_ssrHistoryTexture = state.ssrHistoryTexture;
+    m_ssrAccumTexture = state.ssrAccumTexture;
+    m_visibilityTexture = state.visibilityTexture;
+    m_ssrWidth = state.ssrWidth;
+    m_ssrHeight = state.ssrHeight;
+    m_ssrHistoryValid = state.ssrHistoryValid;
     m_velocityTexture = state.velocityTexture;
     m_dofTexture = state.dofTexture;
     m_fogTexture = state.fogTexture;
@@ -2597,6 +4050,7 @@ void Renderer::loadRenderTargetState(const RenderTargetState& state) {
     m_bloomMipCount = state.bloomMipCount;
     m_taaHistoryTexture = state.taaHistoryTexture;
     m_taaCurrentTexture = state.taaCurrentTexture;
+    m_taaOutputTexture = state.taaOutputTexture;
     m_metalFXOutputTexture = state.metalFXOutputTexture;
     m_colorTexture = state.colorTexture;
     m_msaaColorTexture = state.msaaColorTexture;
@@ -2667,6 +4121,10 @@ void Renderer::releaseRenderTargetState(RenderTargetState& state) {
         state.taaCurrentTexture->release();
         state.taaCurrentTexture = nullptr;
     }
+    if (state.taaOutputTexture) {
+        state.taaOutputTexture->release();
+        state.taaOutputTexture = nullptr;
+    }
     if (state.metalFXOutputTexture) {
         state.metalFXOutputTexture->release();
         state.metalFXOutputTexture = nullptr;
@@ -2683,9 +4141,39 @@ void Renderer::releaseRenderTargetState(RenderTargetState& state) {
         state.ssaoBlurTexture->release();
         state.ssaoBlurTexture = nullptr;
     }
-    if (state.ssaoNoiseTexture) {
-        state.ssaoNoiseTexture->release();
-        state.ssaoNoiseTexture = nullptr;
+    if (state.ssaoHistoryTexture) {
+        state.ssaoHistoryTexture->release();
+        state.ssaoHistoryTexture = nullptr;
+    }
+    if (state.ssaoAccumTexture) {
+        state.ssaoAccumTexture->release();
+        state.ssaoAccumTexture = nullptr;
+    }
+    for (MTL::Texture* tex : state.ssrHizMipViews) {
+        if (tex) {
+            tex->release();
+        }
+    }
+    state.ssrHizMipViews.clear();
+    if (state.ssrHizTexture) {
+        state.ssrHizTexture->release();
+        state.ssrHizTexture = nullptr;
+    }
+    if (state.ssrTraceTexture) {
+        state.ssrTraceTexture->release();
+        state.ssrTraceTexture = nullptr;
+    }
+    if (state.ssrHistoryTexture) {
+        state.ssrHistoryTexture->release();
+        state.ssrHistoryTexture = nullptr;
+    }
+    if (state.ssrAccumTexture) {
+        state.ssrAccumTexture->release();
+        state.ssrAccumTexture = nullptr;
+    }
+    if (state.visibilityTexture) {
+        state.visibilityTexture->release();
+        state.visibilityTexture = nullptr;
     }
     if (state.velocityTexture) {
         state.velocityTexture->release();
@@ -2714,6 +4202,10 @@ void Renderer::releaseRenderTargetState(RenderTargetState& state) {
     }
     state.bloomMipTextures.clear();
     state.bloomMipCount = 0;
+    if (state.persistentHeap) {
+        state.persistentHeap->shutdown();
+        state.persistentHeap.reset();
+    }
     state.renderTargetWidth = 0;
     state.renderTargetHeight = 0;
     state.msaaSamples = 1;
@@ -2787,6 +4279,9 @@ void Renderer::setViewportSize(float width, float height, bool updateTargets) {
         return;
     }
     float scale = std::max(0.5f, std::min(2.0f, m_qualitySettings.renderScale));
+    if (m_activePool == RenderTargetPool::Game && m_dynamicResolution && m_dynamicResolution->isEnabled()) {
+        scale = m_dynamicResolution->getScale();
+    }
     uint32_t renderWidth = static_cast<uint32_t>(std::max(1.0f, std::round(width * scale)));
     uint32_t renderHeight = static_cast<uint32_t>(std::max(1.0f, std::round(height * scale)));
     ensureRenderTargets(renderWidth, renderHeight, m_qualitySettings.msaaSamples, m_sceneColorFormat);
@@ -2814,10 +4309,31 @@ void Renderer::rebuildSamplerState(int anisotropy) {
 }
 
 void Renderer::releaseMetalFXResources() {
+    if (m_metalFXFrameInterpolator) {
+        m_metalFXFrameInterpolator->release();
+        m_metalFXFrameInterpolator = nullptr;
+    }
     if (m_metalFXTemporalScaler) {
         m_metalFXTemporalScaler->release();
         m_metalFXTemporalScaler = nullptr;
     }
+    if (m_metalFXSpatialScaler) {
+        m_metalFXSpatialScaler->release();
+        m_metalFXSpatialScaler = nullptr;
+    }
+    MTL::Texture** inputs[] = {
+        &m_metalFXColorInput, &m_metalFXDepthInput, &m_metalFXMotionInput,
+        &m_metalFXPrevOutputTexture, &m_metalFXInterpolatedTexture
+    };
+    for (MTL::Texture** input : inputs) {
+        if (*input) {
+            (*input)->release();
+            *input = nullptr;
+        }
+    }
+    m_metalFXDynamicInput = false;
+    m_metalFXMinContentScale = 0.0f;
+    m_metalFXPrevOutputValid = false;
     m_metalFXInputWidth = 0;
     m_metalFXInputHeight = 0;
     m_metalFXOutputWidth = 0;
@@ -2829,7 +4345,8 @@ bool Renderer::ensureMetalFXResources(uint32_t inputWidth,
                                       uint32_t inputHeight,
                                       uint32_t outputWidth,
                                       uint32_t outputHeight,
-                                      int colorFormat) {
+                                      int colorFormat,
+                                      bool dynamicInput) {
     if (!m_device || inputWidth == 0 || inputHeight == 0 || outputWidth == 0 || outputHeight == 0) {
         return false;
     }
@@ -2838,12 +4355,18 @@ bool Renderer::ensureMetalFXResources(uint32_t inputWidth,
     }
 
     MTL::PixelFormat format = static_cast<MTL::PixelFormat>(colorFormat);
+    // Output-to-content scale of the smallest frame dynamic resolution can render.
+    float minContentScale = dynamicInput && m_dynamicResolution
+        ? std::max(0.5f, m_dynamicResolution->getMinScale())
+        : 0.0f;
     bool scalerMismatch = !m_metalFXTemporalScaler
         || m_metalFXInputWidth != inputWidth
         || m_metalFXInputHeight != inputHeight
         || m_metalFXOutputWidth != outputWidth
         || m_metalFXOutputHeight != outputHeight
-        || m_metalFXColorFormat != colorFormat;
+        || m_metalFXColorFormat != colorFormat
+        || m_metalFXDynamicInput != dynamicInput
+        || std::abs(m_metalFXMinContentScale - minContentScale) > 0.001f;
     if (scalerMismatch) {
         releaseMetalFXResources();
 
@@ -2857,7 +4380,12 @@ bool Renderer::ensureMetalFXResources(uint32_t inputWidth,
         descriptor->setOutputWidth(outputWidth);
         descriptor->setOutputHeight(outputHeight);
         descriptor->setAutoExposureEnabled(false);
-        descriptor->setInputContentPropertiesEnabled(false);
+        descriptor->setInputContentPropertiesEnabled(dynamicInput);
+        if (dynamicInput) {
+            descriptor->setInputContentMinScale(static_cast<float>(outputWidth) / static_cast<float>(inputWidth));
+            descriptor->setInputContentMaxScale(static_cast<float>(outputWidth)
+                                                / std::max(1.0f, std::floor(static_cast<float>(outputWidth) * minContentScale)));
+        }
         descriptor->setReactiveMaskTextureEnabled(false);
         descriptor->setRequiresSynchronousInitialization(true);
         m_metalFXTemporalScaler = descriptor->newTemporalScaler(m_device);
@@ -2873,38 +4401,204 @@ bool Renderer::ensureMetalFXResources(uint32_t inputWidth,
         m_metalFXOutputWidth = outputWidth;
         m_metalFXOutputHeight = outputHeight;
         m_metalFXColorFormat = colorFormat;
+        m_metalFXDynamicInput = dynamicInput;
+        m_metalFXMinContentScale = minContentScale;
         m_taaHistoryValid = false;
+
+        if (dynamicInput) {
+            struct InputTarget {
+                MTL::Texture** texture;
+                MTL::PixelFormat format;
+                MTL::TextureUsage usage;
+            };
+            const InputTarget inputTargets[] = {
+                { &m_metalFXColorInput, format, m_metalFXTemporalScaler->colorTextureUsage() },
+                { &m_metalFXDepthInput, MTL::PixelFormatDepth32Float, m_metalFXTemporalScaler->depthTextureUsage() },
+                { &m_metalFXMotionInput, MTL::PixelFormatRG16Float, m_metalFXTemporalScaler->motionTextureUsage() }
+            };
+            for (const InputTarget& target : inputTargets) {
+                MTL::TextureDescriptor* inputDesc = MTL::TextureDescriptor::alloc()->init();
+                inputDesc->setTextureType(MTL::TextureType2D);
+                inputDesc->setWidth(inputWidth);
+                inputDesc->setHeight(inputHeight);
+                inputDesc->setPixelFormat(target.format);
+                inputDesc->setUsage(target.usage);
+                inputDesc->setStorageMode(MTL::StorageModePrivate);
+                *target.texture = m_device->newTexture(inputDesc);
+                inputDesc->release();
+                if (!*target.texture) {
+                    releaseMetalFXResources();
+                    return false;
+                }
+            }
+        }
     }
 
-    bool outputMismatch = !m_metalFXOutputTexture
-        || m_metalFXOutputTexture->width() != outputWidth
-        || m_metalFXOutputTexture->height() != outputHeight
-        || m_metalFXOutputTexture->pixelFormat() != format;
-    if (outputMismatch) {
-        if (m_metalFXOutputTexture) {
-            m_metalFXOutputTexture->release();
-            m_metalFXOutputTexture = nullptr;
-        }
-
-        MTL::TextureDescriptor* outputDesc = MTL::TextureDescriptor::alloc()->init();
-        outputDesc->setTextureType(MTL::TextureType2D);
-        outputDesc->setWidth(outputWidth);
-        outputDesc->setHeight(outputHeight);
-        outputDesc->setPixelFormat(format);
-        MTL::TextureUsage usage = m_metalFXTemporalScaler->outputTextureUsage()
-            | MTL::TextureUsageShaderRead
-            | MTL::TextureUsageRenderTarget;
-        outputDesc->setUsage(usage);
-        outputDesc->setStorageMode(MTL::StorageModePrivate);
-        m_metalFXOutputTexture = m_device->newTexture(outputDesc);
-        outputDesc->release();
-        if (!m_metalFXOutputTexture) {
+    if (!ensureMetalFXOutputTexture(outputWidth, outputHeight, colorFormat,
+                                    m_metalFXTemporalScaler->outputTextureUsage())) {
+        releaseMetalFXResources();
+        return false;
+    }
+
+    return m_metalFXTemporalScaler && m_metalFXOutputTexture;
+}
+
+bool Renderer::ensureMetalFXSpatialResources(uint32_t inputWidth,
+                                             uint32_t inputHeight,
+                                             uint32_t outputWidth,
+                                             uint32_t outputHeight,
+                                             int colorFormat) {
+    if (!m_device || inputWidth == 0 || inputHeight == 0 || outputWidth == 0 || outputHeight == 0) {
+        return false;
+    }
+    if (!MTLFX::SpatialScalerDescriptor::supportsDevice(m_device)) {
+        return false;
+    }
+
+    MTL::PixelFormat format = static_cast<MTL::PixelFormat>(colorFormat);
+    bool scalerMismatch = !m_metalFXSpatialScaler
+        || m_metalFXInputWidth != inputWidth
+        || m_metalFXInputHeight != inputHeight
+        || m_metalFXOutputWidth != outputWidth
+        || m_metalFXOutputHeight != outputHeight
+        || m_metalFXColorFormat != colorFormat;
+    if (scalerMismatch) {
+        releaseMetalFXResources();
+
+        MTLFX::SpatialScalerDescriptor* descriptor = MTLFX::SpatialScalerDescriptor::alloc()->init();
+        descriptor->setColorTextureFormat(format);
+        descriptor->setOutputTextureFormat(format);
+        descriptor->setInputWidth(inputWidth);
+        descriptor->setInputHeight(inputHeight);
+        descriptor->setOutputWidth(outputWidth);
+        descriptor->setOutputHeight(outputHeight);
+        // Scene color reaches the upscaler before tone mapping when it is HDR.
+        descriptor->setColorProcessingMode(format == MTL::PixelFormatRGBA16Float
+            ? MTLFX::SpatialScalerColorProcessingModeHDR
+            : MTLFX::SpatialScalerColorProcessingModePerceptual);
+        m_metalFXSpatialScaler = descriptor->newSpatialScaler(m_device);
+        descriptor->release();
+
+        if (!m_metalFXSpatialScaler) {
             releaseMetalFXResources();
             return false;
         }
+
+        m_metalFXInputWidth = inputWidth;
+        m_metalFXInputHeight = inputHeight;
+        m_metalFXOutputWidth = outputWidth;
+        m_metalFXOutputHeight = outputHeight;
+        m_metalFXColorFormat = colorFormat;
     }
 
-    return m_metalFXTemporalScaler && m_metalFXOutputTexture;
+    if (!ensureMetalFXOutputTexture(outputWidth, outputHeight, colorFormat,
+                                    m_metalFXSpatialScaler->outputTextureUsage())) {
+        releaseMetalFXResources();
+        return false;
+    }
+
+    return m_metalFXSpatialScaler && m_metalFXOutputTexture;
+}
+
+bool Renderer::ensureMetalFXFrameInterpolator() {
+    if (!m_device || !m_metalFXTemporalScaler || !m_metalFXOutputTexture) {
+        return false;
+    }
+    if (!MTLFX::FrameInterpolatorDescriptor::supportsDevice(m_device)) {
+        return false;
+    }
+
+    MTL::PixelFormat format = static_cast<MTL::PixelFormat>(m_metalFXColorFormat);
+    if (!m_metalFXFrameInterpolator) {
+        // Attached to the temporal scaler: it reads the scaler's depth and motion inputs and
+        // interpolates between its last two outputs.
+        MTLFX::FrameInterpolatorDescriptor* descriptor = MTLFX::FrameInterpolatorDescriptor::alloc()->init();
+        descriptor->setColorTextureFormat(format);
+        descriptor->setOutputTextureFormat(format);
+        descriptor->setDepthTextureFormat(MTL::PixelFormatDepth32Float);
+        descriptor->setMotionTextureFormat(MTL::PixelFormatRG16Float);
+        descriptor->setScaler(m_metalFXTemporalScaler);
+        descriptor->setInputWidth(m_metalFXInputWidth);
+        descriptor->setInputHeight(m_metalFXInputHeight);
+        descriptor->setOutputWidth(m_metalFXOutputWidth);
+        descriptor->setOutputHeight(m_metalFXOutputHeight);
+        m_metalFXFrameInterpolator = descriptor->newFrameInterpolator(m_device);
+        descriptor->release();
+        if (!m_metalFXFrameInterpolator) {
+            return false;
+        }
+        m_metalFXPrevOutputValid = false;
+    }
+
+    if (!ensureMetalFXOutputTexture(m_metalFXOutputWidth, m_metalFXOutputHeight, m_metalFXColorFormat,
+                                    m_metalFXTemporalScaler->outputTextureUsage()
+                                        | m_metalFXFrameInterpolator->colorTextureUsage())) {
+        return false;
+    }
+
+    struct InterpolatorTarget {
+        MTL::Texture** texture;
+        MTL::TextureUsage usage;
+    };
+    const InterpolatorTarget targets[] = {
+        { &m_metalFXPrevOutputTexture, m_metalFXFrameInterpolator->colorTextureUsage() },
+        { &m_metalFXInterpolatedTexture, m_metalFXFrameInterpolator->outputTextureUsage() | MTL::TextureUsageShaderRead }
+    };
+    for (const InterpolatorTarget& target : targets) {
+        MTL::Texture* texture = *target.texture;
+        if (texture && texture->width() == m_metalFXOutputWidth && texture->height() == m_metalFXOutputHeight
+            && texture->pixelFormat() == format) {
+            continue;
+        }
+        if (texture) {
+            texture->release();
+            *target.texture = nullptr;
+        }
+        MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+        desc->setTextureType(MTL::TextureType2D);
+        desc->setWidth(m_metalFXOutputWidth);
+        desc->setHeight(m_metalFXOutputHeight);
+        desc->setPixelFormat(format);
+        desc->setUsage(target.usage);
+        desc->setStorageMode(MTL::StorageModePrivate);
+        *target.texture = m_device->newTexture(desc);
+        desc->release();
+        if (!*target.texture) {
+            return false;
+        }
+        m_metalFXPrevOutputValid = false;
+    }
+    return true;
+}
+
+bool Renderer::ensureMetalFXOutputTexture(uint32_t width, uint32_t height, int colorFormat, uint64_t usage) {
+    MTL::PixelFormat format = static_cast<MTL::PixelFormat>(colorFormat);
+    MTL::TextureUsage required = static_cast<MTL::TextureUsage>(usage)
+        | MTL::TextureUsageShaderRead
+        | MTL::TextureUsageRenderTarget;
+    bool outputMismatch = !m_metalFXOutputTexture
+        || m_metalFXOutputTexture->width() != width
+        || m_metalFXOutputTexture->height() != height
+        || m_metalFXOutputTexture->pixelFormat() != format
+        || (m_metalFXOutputTexture->usage() & required) != required;
+    if (!outputMismatch) {
+        return true;
+    }
+    if (m_metalFXOutputTexture) {
+        m_metalFXOutputTexture->release();
+        m_metalFXOutputTexture = nullptr;
+    }
+
+    MTL::TextureDescriptor* outputDesc = MTL::TextureDescriptor::alloc()->init();
+    outputDesc->setTextureType(MTL::TextureType2D);
+    outputDesc->setWidth(width);
+    outputDesc->setHeight(height);
+    outputDesc->setPixelFormat(format);
+    outputDesc->setUsage(required);
+    outputDesc->setStorageMode(MTL::StorageModePrivate);
+    m_metalFXOutputTexture = m_device->newTexture(outputDesc);
+    outputDesc->release();
+    return m_metalFXOutputTexture != nullptr;
 }
 
 void Renderer::clearPipelineCache() {
@@ -2914,6 +4608,29 @@ void Renderer::clearPipelineCache() {
         }
     }
     m_pipelineStates.clear();
+    // Variants still compiling were built for the old configuration; drop them when they land.
+    ++m_pipelineGeneration;
+    m_pendingPipelines.clear();
+    m_pipelinePrewarmRemaining = 0;
+}
+
+bool Renderer::updateTargetFormats(const SceneQualitySettings& quality) {
+    const bool compact = quality.compactRenderTargets;
+    // The MetalFX scalers are created for RGBA16Float HDR input, so with one selected the scene
+    // color keeps its alpha-carrying format; bloom never reaches them.
+    const int hdrColor = static_cast<int>(compact && quality.upscaler == 0 ? MTL::PixelFormatRG11B10Float
+                                                                           : MTL::PixelFormatRGBA16Float);
+    const int bloom = static_cast<int>(compact ? MTL::PixelFormatRG11B10Float : MTL::PixelFormatRGBA16Float);
+    // Both formats hold the same encoding (encodeNormalRoughness), so only the precision changes.
+    const int normal = static_cast<int>(compact ? MTL::PixelFormatRGB10A2Unorm : MTL::PixelFormatRGBA16Float);
+    const int decal = static_cast<int>(compact ? MTL::PixelFormatRGBA8Unorm : MTL::PixelFormatRGBA16Float);
+    const bool changed = hdrColor != m_hdrColorFormat || bloom != m_bloomFormat
+        || normal != m_normalTargetFormat || decal != m_decalTargetFormat;
+    m_hdrColorFormat = hdrColor;
+    m_bloomFormat = bloom;
+    m_normalTargetFormat = normal;
+    m_decalTargetFormat = decal;
+    return changed;
 }
 
 uint32_t Renderer::resolveSampleCount(uint32_t requested) const {
@@ -2930,6 +4647,24 @@ uint32_t Renderer::resolveSampleCount(uint32_t requested) const {
     return 1;
 }
 
+namespace {
+    // Passes of renderScene in encode order; the per-frame targets on the RenderTargetHeap declare
+    // the range they are alive in. Every target the post chain can leave in sceneColorForPost is
+    // read by the final blit, so those live until Present.
+    enum class TargetPass : uint32_t {
+        Decals,
+        SSAO,
+        Main,
+        SSR,
+        Fog,
+        TAA,
+        MotionBlur,
+        DOF,
+        Bloom,
+        Present
+    };
+}
+
 void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msaaSamples, int colorFormat) {
     if (!m_device || width == 0 || height == 0) {
         return;
@@ -2942,10 +4677,11 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
     bool formatChanged = colorFormat != m_sceneColorFormat;
     
     if (!sizeChanged && !samplesChanged && !formatChanged && m_colorTexture && m_depthTexture && m_normalTexture
-        && m_ssaoTexture && m_ssaoBlurTexture && m_velocityTexture && m_dofTexture && m_fogTexture && m_postColorTexture
+        && m_ssaoBlurTexture && m_velocityTexture && m_dofTexture && m_fogTexture && m_postColorTexture
         && m_decalAlbedoTexture && m_decalNormalTexture && m_decalOrmTexture && m_motionBlurTexture
-        && !m_bloomMipTextures.empty() && m_taaHistoryTexture && m_taaCurrentTexture
-        && m_hzbTexture && !m_hzbMipViews.empty()) {
+        && !m_bloomMipTextures.empty() && m_taaHistoryTexture && m_taaCurrentTexture && m_taaOutputTexture
+        && m_hzbTexture && !m_hzbMipViews.empty()
+        && !(m_renderTargetHeap && m_renderTargetHeap->isStale(m_postColorTexture))) {
         return;
     }
     
@@ -2992,6 +4728,10 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
         m_taaCurrentTexture->release();
         m_taaCurrentTexture = nullptr;
     }
+    if (m_taaOutputTexture) {
+        m_taaOutputTexture->release();
+        m_taaOutputTexture = nullptr;
+    }
     for (MTL::Texture* tex : m_bloomMipTextures) {
         if (tex) {
             tex->release();
@@ -3027,6 +4767,10 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
         m_taaCurrentTexture->release();
         m_taaCurrentTexture = nullptr;
     }
+    if (m_taaOutputTexture) {
+        m_taaOutputTexture->release();
+        m_taaOutputTexture = nullptr;
+    }
     for (MTL::Texture* tex : m_bloomMipTextures) {
         if (tex) {
             tex->release();
@@ -3065,11 +4809,44 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
         m_ssaoBlurTexture->release();
         m_ssaoBlurTexture = nullptr;
     }
-    if (m_ssaoNoiseTexture) {
-        m_ssaoNoiseTexture->release();
-        m_ssaoNoiseTexture = nullptr;
+    if (m_ssaoHistoryTexture) {
+        m_ssaoHistoryTexture->release();
+        m_ssaoHistoryTexture = nullptr;
     }
-    if (m_velocityTexture) {
+    if (m_ssaoAccumTexture) {
+        m_ssaoAccumTexture->release();
+        m_ssaoAccumTexture = nullptr;
+    }
+    for (MTL::Texture* tex : m_ssrHizMipViews) {
+        if (tex) {
+            tex->release();
+        }
+    }
+    m_ssrHizMipViews.clear();
+    if (m_ssrHizTexture) {
+        m_ssrHizTexture->release();
+        m_ssrHizTexture = nullptr;
+    }
+    if (m_ssrTraceTexture) {
+        m_ssrTraceTexture->release();
+        m_ssrTraceTexture = nullptr;
+    }
+    if (m_ssrHistoryTexture) {
+        m_ssrHistoryTexture->release();
+        m_ssrHistoryTexture = nullptr;
+    }
+    if (m_ssrAccumTexture) {
+        m_ssrAccumTexture->release();
+        m_ssrAccumTexture = nullptr;
+    }
+    m_ssrWidth = 0;
+    m_ssrHeight = 0;
+    m_ssrHistoryValid = false;
+    if (m_visibilityTexture) {
+        m_visibilityTexture->release();
+        m_visibilityTexture = nullptr;
+    }
+    if (m_velocityTexture) {
         m_velocityTexture->release();
         m_velocityTexture = nullptr;
     }
@@ -3093,6 +4870,22 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
         m_fogVolumeHistoryTexture->release();
         m_fogVolumeHistoryTexture = nullptr;
     }
+
+    // Targets that are dead by the end of the frame go on the shared RenderTargetHeap.
+    std::vector<RenderTargetHeap::Request> transientTargets;
+    auto addTransientTarget = [&](MTL::TextureDescriptor* desc, TargetPass firstPass, TargetPass lastPass,
+                                  MTL::Texture** texture) {
+        desc->retain();
+        transientTargets.push_back({desc, static_cast<uint32_t>(firstPass), static_cast<uint32_t>(lastPass), texture});
+    };
+    // Targets that carry contents into the next frame go on the pool's own heap, all alive
+    // together; resizing within the heap's size bucket re-places them without new memory.
+    std::vector<RenderTargetHeap::Request> persistentTargets;
+    auto addPersistentTarget = [&](MTL::TextureDescriptor* desc, MTL::Texture** texture) {
+        desc->retain();
+        persistentTargets.push_back({desc, 0u, static_cast<uint32_t>(TargetPass::Present), texture});
+    };
+
     MTL::TextureDescriptor* colorDesc = MTL::TextureDescriptor::alloc()->init();
     colorDesc->setTextureType(MTL::TextureType2D);
     colorDesc->setWidth(width);
@@ -3100,7 +4893,7 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
     colorDesc->setPixelFormat(format);
     colorDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
     colorDesc->setStorageMode(MTL::StorageModePrivate);
-    m_colorTexture = m_device->newTexture(colorDesc);
+    addPersistentTarget(colorDesc, &m_colorTexture);
     colorDesc->release();
 
     MTL::TextureDescriptor* postDesc = MTL::TextureDescriptor::alloc()->init();
@@ -3110,19 +4903,19 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
     postDesc->setPixelFormat(format);
     postDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
     postDesc->setStorageMode(MTL::StorageModePrivate);
-    m_postColorTexture = m_device->newTexture(postDesc);
+    addTransientTarget(postDesc, TargetPass::SSR, TargetPass::Present, &m_postColorTexture);
     postDesc->release();
 
     MTL::TextureDescriptor* decalDesc = MTL::TextureDescriptor::alloc()->init();
     decalDesc->setTextureType(MTL::TextureType2D);
     decalDesc->setWidth(width);
     decalDesc->setHeight(height);
-    decalDesc->setPixelFormat(MTL::PixelFormatRGBA16Float);
+    decalDesc->setPixelFormat(static_cast<MTL::PixelFormat>(m_decalTargetFormat));
     decalDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
     decalDesc->setStorageMode(MTL::StorageModePrivate);
-    m_decalAlbedoTexture = m_device->newTexture(decalDesc);
-    m_decalNormalTexture = m_device->newTexture(decalDesc);
-    m_decalOrmTexture = m_device->newTexture(decalDesc);
+    addTransientTarget(decalDesc, TargetPass::Decals, TargetPass::Main, &m_decalAlbedoTexture);
+    addTransientTarget(decalDesc, TargetPass::Decals, TargetPass::Main, &m_decalNormalTexture);
+    addTransientTarget(decalDesc, TargetPass::Decals, TargetPass::Main, &m_decalOrmTexture);
     decalDesc->release();
 
     MTL::TextureDescriptor* motionDesc = MTL::TextureDescriptor::alloc()->init();
@@ -3130,9 +4923,9 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
     motionDesc->setWidth(width);
     motionDesc->setHeight(height);
     motionDesc->setPixelFormat(format);
-    motionDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
+    motionDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
     motionDesc->setStorageMode(MTL::StorageModePrivate);
-    m_motionBlurTexture = m_device->newTexture(motionDesc);
+    addTransientTarget(motionDesc, TargetPass::MotionBlur, TargetPass::Present, &m_motionBlurTexture);
     motionDesc->release();
 
     MTL::TextureDescriptor* taaDesc = MTL::TextureDescriptor::alloc()->init();
@@ -3140,10 +4933,11 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
     taaDesc->setWidth(width);
     taaDesc->setHeight(height);
     taaDesc->setPixelFormat(format);
-    taaDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
+    taaDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
     taaDesc->setStorageMode(MTL::StorageModePrivate);
-    m_taaHistoryTexture = m_device->newTexture(taaDesc);
-    m_taaCurrentTexture = m_device->newTexture(taaDesc);
+    addPersistentTarget(taaDesc, &m_taaHistoryTexture);
+    addPersistentTarget(taaDesc, &m_taaCurrentTexture);
+    addTransientTarget(taaDesc, TargetPass::TAA, TargetPass::Present, &m_taaOutputTexture);
     taaDesc->release();
     
     MTL::TextureDescriptor* depthDesc = MTL::TextureDescriptor::alloc()->init();
@@ -3153,7 +4947,7 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
     depthDesc->setPixelFormat(MTL::PixelFormatDepth32Float);
     depthDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
     depthDesc->setStorageMode(MTL::StorageModePrivate);
-    m_depthTexture = m_device->newTexture(depthDesc);
+    addPersistentTarget(depthDesc, &m_depthTexture);
     depthDesc->release();
 
     auto calcHzbMipCount = [](uint32_t w, uint32_t h) -> uint32_t {
@@ -3174,34 +4968,17 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
     hzbDesc->setUsage(MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
     hzbDesc->setStorageMode(MTL::StorageModePrivate);
     hzbDesc->setMipmapLevelCount(m_hzbMipCount);
-    m_hzbTexture = m_device->newTexture(hzbDesc);
+    addPersistentTarget(hzbDesc, &m_hzbTexture);
     hzbDesc->release();
-    m_hzbMipViews.clear();
-    if (m_hzbTexture) {
-        m_hzbMipViews.reserve(m_hzbMipCount);
-        for (uint32_t mip = 0; mip < m_hzbMipCount; ++mip) {
-            NS::Range mipRange = NS::Range::Make(mip, 1);
-            NS::Range sliceRange = NS::Range::Make(0, 1);
-            MTL::Texture* view = m_hzbTexture->newTextureView(
-                MTL::PixelFormatR32Float,
-                MTL::TextureType2D,
-                mipRange,
-                sliceRange
-            );
-            if (view) {
-                m_hzbMipViews.push_back(view);
-            }
-        }
-    }
 
     MTL::TextureDescriptor* normalDesc = MTL::TextureDescriptor::alloc()->init();
     normalDesc->setTextureType(MTL::TextureType2D);
     normalDesc->setWidth(width);
     normalDesc->setHeight(height);
-    normalDesc->setPixelFormat(MTL::PixelFormatRGBA16Float);
+    normalDesc->setPixelFormat(static_cast<MTL::PixelFormat>(m_normalTargetFormat));
     normalDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
     normalDesc->setStorageMode(MTL::StorageModePrivate);
-    m_normalTexture = m_device->newTexture(normalDesc);
+    addPersistentTarget(normalDesc, &m_normalTexture);
     normalDesc->release();
 
     MTL::TextureDescriptor* velocityDesc = MTL::TextureDescriptor::alloc()->init();
@@ -3211,7 +4988,7 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
     velocityDesc->setPixelFormat(MTL::PixelFormatRG16Float);
     velocityDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
     velocityDesc->setStorageMode(MTL::StorageModePrivate);
-    m_velocityTexture = m_device->newTexture(velocityDesc);
+    addPersistentTarget(velocityDesc, &m_velocityTexture);
     velocityDesc->release();
 
     MTL::TextureDescriptor* dofDesc = MTL::TextureDescriptor::alloc()->init();
@@ -3219,9 +4996,9 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
     dofDesc->setWidth(width);
     dofDesc->setHeight(height);
     dofDesc->setPixelFormat(format);
-    dofDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
+    dofDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
     dofDesc->setStorageMode(MTL::StorageModePrivate);
-    m_dofTexture = m_device->newTexture(dofDesc);
+    addTransientTarget(dofDesc, TargetPass::DOF, TargetPass::Present, &m_dofTexture);
     dofDesc->release();
 
     MTL::TextureDescriptor* fogDesc = MTL::TextureDescriptor::alloc()->init();
@@ -3231,18 +5008,19 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
     fogDesc->setPixelFormat(format);
     fogDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
     fogDesc->setStorageMode(MTL::StorageModePrivate);
-    m_fogTexture = m_device->newTexture(fogDesc);
+    addTransientTarget(fogDesc, TargetPass::Fog, TargetPass::Present, &m_fogTexture);
     fogDesc->release();
 
+    // The SSAO trace and its history are sized by the quality setting in ensureSSAOTargets; only
+    // the upsampled result the main pass reads lives at render resolution.
     MTL::TextureDescriptor* ssaoDesc = MTL::TextureDescriptor::alloc()->init();
     ssaoDesc->setTextureType(MTL::TextureType2D);
     ssaoDesc->setWidth(width);
     ssaoDesc->setHeight(height);
     ssaoDesc->setPixelFormat(MTL::PixelFormatR8Unorm);
-    ssaoDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
+    ssaoDesc->setUsage(MTL::TextureUsageShaderWrite | MTL::TextureUsageShaderRead);
     ssaoDesc->setStorageMode(MTL::StorageModePrivate);
-    m_ssaoTexture = m_device->newTexture(ssaoDesc);
-    m_ssaoBlurTexture = m_device->newTexture(ssaoDesc);
+    addTransientTarget(ssaoDesc, TargetPass::SSAO, TargetPass::Main, &m_ssaoBlurTexture);
     ssaoDesc->release();
 
     uint32_t bloomWidth = std::max(1u, width / 2);
@@ -3257,23 +5035,36 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
         return levels;
     };
     m_bloomMipCount = calcMipCount(bloomWidth, bloomHeight);
-    m_bloomMipTextures.reserve(m_bloomMipCount);
+    // Sized up front: the placement requests point into the vector.
+    m_bloomMipTextures.assign(m_bloomMipCount, nullptr);
     for (uint32_t i = 0; i < m_bloomMipCount; ++i) {
         MTL::TextureDescriptor* bloomDesc = MTL::TextureDescriptor::alloc()->init();
         bloomDesc->setTextureType(MTL::TextureType2D);
         bloomDesc->setWidth(bloomWidth);
         bloomDesc->setHeight(bloomHeight);
-        bloomDesc->setPixelFormat(MTL::PixelFormatRGBA16Float);
-        bloomDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
+        bloomDesc->setPixelFormat(static_cast<MTL::PixelFormat>(m_bloomFormat));
+        bloomDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
         bloomDesc->setStorageMode(MTL::StorageModePrivate);
-        MTL::Texture* mipTex = m_device->newTexture(bloomDesc);
+        addTransientTarget(bloomDesc, TargetPass::Bloom, TargetPass::Present, &m_bloomMipTextures[i]);
         bloomDesc->release();
-        m_bloomMipTextures.push_back(mipTex);
         bloomWidth = std::max(1u, bloomWidth / 2);
         bloomHeight = std::max(1u, bloomHeight / 2);
     }
     
     if (clampedSamples > 1) {
+        // The main pass is the only pass on the MSAA attachments: it clears both, resolves color
+        // and discards depth. Apple GPUs keep them in tile memory with no system memory behind
+        // them at all; elsewhere they alias the post chain on the target heap.
+        const bool memoryless = m_device->supportsFamily(MTL::GPUFamilyApple1);
+        auto addMainPassAttachment = [&](MTL::TextureDescriptor* desc, MTL::Texture** texture) {
+            if (memoryless) {
+                desc->setStorageMode(MTL::StorageModeMemoryless);
+                *texture = m_device->newTexture(desc);
+            } else {
+                addTransientTarget(desc, TargetPass::Main, TargetPass::Main, texture);
+            }
+        };
+
         MTL::TextureDescriptor* msaaColor = MTL::TextureDescriptor::alloc()->init();
         msaaColor->setTextureType(MTL::TextureType2DMultisample);
         msaaColor->setWidth(width);
@@ -3282,7 +5073,7 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
         msaaColor->setSampleCount(clampedSamples);
         msaaColor->setUsage(MTL::TextureUsageRenderTarget);
         msaaColor->setStorageMode(MTL::StorageModePrivate);
-        m_msaaColorTexture = m_device->newTexture(msaaColor);
+        addMainPassAttachment(msaaColor, &m_msaaColorTexture);
         msaaColor->release();
         
         MTL::TextureDescriptor* msaaDepth = MTL::TextureDescriptor::alloc()->init();
@@ -3293,12 +5084,49 @@ void Renderer::ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msa
         msaaDepth->setSampleCount(clampedSamples);
         msaaDepth->setUsage(MTL::TextureUsageRenderTarget);
         msaaDepth->setStorageMode(MTL::StorageModePrivate);
-        m_msaaDepthTexture = m_device->newTexture(msaaDepth);
+        addMainPassAttachment(msaaDepth, &m_msaaDepthTexture);
         msaaDepth->release();
     }
 
-    if (!m_ssaoNoiseTexture) {
-        buildSSAONoiseTexture();
+    if (!m_renderTargetHeap || !m_renderTargetHeap->place(transientTargets)) {
+        for (const RenderTargetHeap::Request& request : transientTargets) {
+            *request.texture = m_device->newTexture(request.descriptor);
+        }
+    }
+    for (const RenderTargetHeap::Request& request : transientTargets) {
+        request.descriptor->release();
+    }
+
+    RenderTargetState& poolState = getRenderTargetState(m_activePool);
+    if (!poolState.persistentHeap) {
+        poolState.persistentHeap = std::make_unique<RenderTargetHeap>();
+        poolState.persistentHeap->initialize(m_device);
+    }
+    if (!poolState.persistentHeap->place(persistentTargets)) {
+        for (const RenderTargetHeap::Request& request : persistentTargets) {
+            *request.texture = m_device->newTexture(request.descriptor);
+        }
+    }
+    for (const RenderTargetHeap::Request& request : persistentTargets) {
+        request.descriptor->release();
+    }
+
+    m_hzbMipViews.clear();
+    if (m_hzbTexture) {
+        m_hzbMipViews.reserve(m_hzbMipCount);
+        for (uint32_t mip = 0; mip < m_hzbMipCount; ++mip) {
+            NS::Range mipRange = NS::Range::Make(mip, 1);
+            NS::Range sliceRange = NS::Range::Make(0, 1);
+            MTL::Texture* view = m_hzbTexture->newTextureView(
+                MTL::PixelFormatR32Float,
+                MTL::TextureType2D,
+                mipRange,
+                sliceRange
+            );
+            if (view) {
+                m_hzbMipViews.push_back(view);
+            }
+        }
     }
 
     if (formatChanged) {
@@ -3371,6 +5199,172 @@ void Renderer::ensureFogVolume(uint32_t width, uint32_t height, int quality) {
     fogVolumeDesc->release();
 }
 
+void Renderer::ensureSSAOTargets(uint32_t width, uint32_t height, int resolution) {
+    if (!m_device || width == 0 || height == 0) {
+        return;
+    }
+
+    int clampedResolution = std::max(0, std::min(2, resolution));
+    uint32_t divisor = 1u << clampedResolution;
+    uint32_t desiredWidth = std::max(1u, (width + divisor - 1) / divisor);
+    uint32_t desiredHeight = std::max(1u, (height + divisor - 1) / divisor);
+
+    bool sizeChanged = desiredWidth != m_ssaoWidth
+        || desiredHeight != m_ssaoHeight
+        || clampedResolution != m_ssaoResolution;
+
+    if (!sizeChanged && m_ssaoTexture && m_ssaoHistoryTexture && m_ssaoAccumTexture) {
+        return;
+    }
+
+    if (m_ssaoTexture) {
+        m_ssaoTexture->release();
+        m_ssaoTexture = nullptr;
+    }
+    if (m_ssaoHistoryTexture) {
+        m_ssaoHistoryTexture->release();
+        m_ssaoHistoryTexture = nullptr;
+    }
+    if (m_ssaoAccumTexture) {
+        m_ssaoAccumTexture->release();
+        m_ssaoAccumTexture = nullptr;
+    }
+
+    m_ssaoWidth = desiredWidth;
+    m_ssaoHeight = desiredHeight;
+    m_ssaoResolution = clampedResolution;
+    m_ssaoHistoryValid = false;
+
+    // R = occlusion, G = linear view depth for the temporal rejection and the bilateral upsample.
+    MTL::TextureDescriptor* ssaoDesc = MTL::TextureDescriptor::alloc()->init();
+    ssaoDesc->setTextureType(MTL::TextureType2D);
+    ssaoDesc->setWidth(m_ssaoWidth);
+    ssaoDesc->setHeight(m_ssaoHeight);
+    ssaoDesc->setPixelFormat(MTL::PixelFormatRG16Float);
+    ssaoDesc->setUsage(MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
+    ssaoDesc->setStorageMode(MTL::StorageModePrivate);
+    m_ssaoTexture = m_device->newTexture(ssaoDesc);
+    m_ssaoHistoryTexture = m_device->newTexture(ssaoDesc);
+    m_ssaoAccumTexture = m_device->newTexture(ssaoDesc);
+    ssaoDesc->release();
+}
+
+void Renderer::ensureSSRTargets(uint32_t width, uint32_t height) {
+    if (!m_device || width == 0 || height == 0) {
+        return;
+    }
+
+    uint32_t desiredWidth = std::max(1u, (width + 1) / 2);
+    uint32_t desiredHeight = std::max(1u, (height + 1) / 2);
+    if (desiredWidth == m_ssrWidth && desiredHeight == m_ssrHeight && m_ssrHizTexture && !m_ssrHizMipViews.empty()
+        && m_ssrTraceTexture && m_ssrHistoryTexture && m_ssrAccumTexture) {
+        return;
+    }
+
+    for (MTL::Texture* tex : m_ssrHizMipViews) {
+        if (tex) {
+            tex->release();
+        }
+    }
+    m_ssrHizMipViews.clear();
+    if (m_ssrHizTexture) {
+        m_ssrHizTexture->release();
+        m_ssrHizTexture = nullptr;
+    }
+    if (m_ssrTraceTexture) {
+        m_ssrTraceTexture->release();
+        m_ssrTraceTexture = nullptr;
+    }
+    if (m_ssrHistoryTexture) {
+        m_ssrHistoryTexture->release();
+        m_ssrHistoryTexture = nullptr;
+    }
+    if (m_ssrAccumTexture) {
+        m_ssrAccumTexture->release();
+        m_ssrAccumTexture = nullptr;
+    }
+
+    m_ssrWidth = desiredWidth;
+    m_ssrHeight = desiredHeight;
+    m_ssrHistoryValid = false;
+
+    // Past a 64x coarsening the cells are larger than most rays travel on screen.
+    uint32_t mipCount = 1;
+    for (uint32_t w = desiredWidth, h = desiredHeight; (w > 1 || h > 1) && mipCount < 7; ++mipCount) {
+        w = std::max(1u, w / 2);
+        h = std::max(1u, h / 2);
+    }
+    MTL::TextureDescriptor* hizDesc = MTL::TextureDescriptor::alloc()->init();
+    hizDesc->setTextureType(MTL::TextureType2D);
+    hizDesc->setWidth(m_ssrWidth);
+    hizDesc->setHeight(m_ssrHeight);
+    hizDesc->setPixelFormat(MTL::PixelFormatR32Float);
+    hizDesc->setUsage(MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
+    hizDesc->setStorageMode(MTL::StorageModePrivate);
+    hizDesc->setMipmapLevelCount(mipCount);
+    m_ssrHizTexture = m_device->newTexture(hizDesc);
+    hizDesc->release();
+    if (m_ssrHizTexture) {
+        m_ssrHizMipViews.reserve(mipCount);
+        for (uint32_t mip = 0; mip < mipCount; ++mip) {
+            MTL::Texture* view = m_ssrHizTexture->newTextureView(
+                MTL::PixelFormatR32Float,
+                MTL::TextureType2D,
+                NS::Range::Make(mip, 1),
+                NS::Range::Make(0, 1)
+            );
+            if (view) {
+                m_ssrHizMipViews.push_back(view);
+            }
+        }
+    }
+
+    MTL::TextureDescriptor* ssrDesc = MTL::TextureDescriptor::alloc()->init();
+    ssrDesc->setTextureType(MTL::TextureType2D);
+    ssrDesc->setWidth(m_ssrWidth);
+    ssrDesc->setHeight(m_ssrHeight);
+    ssrDesc->setPixelFormat(MTL::PixelFormatRGBA16Float);
+    ssrDesc->setUsage(MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
+    ssrDesc->setStorageMode(MTL::StorageModePrivate);
+    m_ssrTraceTexture = m_device->newTexture(ssrDesc);
+    m_ssrHistoryTexture = m_device->newTexture(ssrDesc);
+    m_ssrAccumTexture = m_device->newTexture(ssrDesc);
+    ssrDesc->release();
+}
+
+void Renderer::ensureVisibilityTargets(uint32_t width, uint32_t height) {
+    if (!m_device || width == 0 || height == 0) {
+        return;
+    }
+
+    if (!m_visibilityTexture || m_visibilityTexture->width() != width || m_visibilityTexture->height() != height) {
+        if (m_visibilityTexture) {
+            m_visibilityTexture->release();
+            m_visibilityTexture = nullptr;
+        }
+        MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+        desc->setTextureType(MTL::TextureType2D);
+        desc->setWidth(width);
+        desc->setHeight(height);
+        desc->setPixelFormat(MTL::PixelFormatRG32Uint);
+        desc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
+        desc->setStorageMode(MTL::StorageModePrivate);
+        m_visibilityTexture = m_device->newTexture(desc);
+        desc->release();
+    }
+
+    // Two words per tile; shared by every pool, so it only grows.
+    const size_t tiles = size_t((width + kVisibilityTileSize - 1) / kVisibilityTileSize)
+        * ((height + kVisibilityTileSize - 1) / kVisibilityTileSize);
+    const size_t bytes = tiles * 2 * sizeof(uint32_t);
+    if (!m_visibilityTileRanges || m_visibilityTileRanges->length() < bytes) {
+        if (m_visibilityTileRanges) {
+            m_visibilityTileRanges->release();
+        }
+        m_visibilityTileRanges = m_device->newBuffer(bytes, MTL::ResourceStorageModePrivate);
+    }
+}
+
 void Renderer::applyQualitySettings(const SceneQualitySettings& quality) {
     int shadowResolution = std::max(256, std::min(8192, quality.shadowResolution));
     uint32_t msaaSamples = resolveSampleCount(std::max(1, std::min(8, quality.msaaSamples)));
@@ -3382,14 +5376,40 @@ void Renderer::applyQualitySettings(const SceneQualitySettings& quality) {
     clamped.msaaSamples = static_cast<int>(msaaSamples);
     clamped.anisotropy = std::max(1, std::min(16, quality.anisotropy));
     clamped.renderScale = renderScale;
+    clamped.upscaler = std::max(0, std::min(2, quality.upscaler));
+    clamped.lodBias = std::max(-4.0f, std::min(4.0f, quality.lodBias));
+    clamped.textureQuality = std::max(0, std::min(3, quality.textureQuality));
+    for (int& interval : clamped.shadowCascadeUpdateIntervals) {
+        interval = std::max(1, std::min(static_cast<int>(LightingSystem::kMaxShadowUpdateInterval), interval));
+    }
+    clamped.shadowUpdateBudget = std::max(0, quality.shadowUpdateBudget);
+    clamped.ssaoResolution = std::max(0, std::min(2, quality.ssaoResolution));
+    clamped.dynamicResolutionTargetMs = std::max(4.0f, std::min(100.0f, quality.dynamicResolutionTargetMs));
+    clamped.dynamicResolutionMinScale = std::max(0.5f, std::min(renderScale, quality.dynamicResolutionMinScale));
+    clamped.variableRateShadingPeriphery = std::max(0.25f, std::min(1.0f, quality.variableRateShadingPeriphery));
+    clamped.particleBudget = std::max(0, std::min(1 << 22, quality.particleBudget));
     
     const bool shadowResolutionChanged = clamped.shadowResolution != m_qualitySettings.shadowResolution;
     const bool anisotropyChanged = quality.anisotropy != m_qualitySettings.anisotropy;
     const bool msaaChanged = msaaSamples != m_msaaSamples;
     const bool renderScaleChanged = std::abs(renderScale - m_qualitySettings.renderScale) > 0.001f;
     const bool upscalerChanged = clamped.upscaler != m_qualitySettings.upscaler;
+    const bool targetFormatsChanged = updateTargetFormats(clamped);
     
     m_qualitySettings = clamped;
+    if (m_dynamicResolution) {
+        m_dynamicResolution->configure(clamped.dynamicResolution,
+                                       clamped.dynamicResolutionTargetMs,
+                                       clamped.dynamicResolutionMinScale,
+                                       renderScale);
+    }
+    if (m_textureStreamer) {
+        m_textureStreamer->setBudget(TextureStreamingBudget(clamped.textureQuality));
+    }
+    if (m_lightingSystem) {
+        m_lightingSystem->setShadowUpdateCadence(clamped.shadowCascadeUpdateIntervals,
+                                                 static_cast<uint32_t>(clamped.shadowUpdateBudget));
+    }
     
     if (!m_device) {
         return;
@@ -3417,7 +5437,17 @@ void Renderer::applyQualitySettings(const SceneQualitySettings& quality) {
         m_taaHistoryValid = false;
     }
 
-    if (msaaChanged || renderScaleChanged || upscalerChanged) {
+    if (targetFormatsChanged) {
+        // PBR variants are keyed by hdrTarget, not by the format behind it.
+        clearPipelineCache();
+        buildPrepassPipeline();
+        buildBloomPipelines();
+        buildDecalPipeline();
+        m_renderTargetWidth = 0;
+        m_renderTargetHeight = 0;
+    }
+
+    if (msaaChanged || renderScaleChanged || upscalerChanged || targetFormatsChanged) {
         storeRenderTargetState(getRenderTargetState(m_activePool));
         invalidateRenderTargetState(m_sceneTargets, msaaSamples);
         invalidateRenderTargetState(m_gameTargets, msaaSamples);
@@ -3427,9 +5457,8 @@ void Renderer::applyQualitySettings(const SceneQualitySettings& quality) {
     
     if (shadowResolutionChanged || desiredAtlasResolution != m_shadowAtlasResolution) {
         if (m_shadowPass) {
-            m_shadowPass->shutdown();
-            if (!m_shadowPass->initialize(m_device, desiredAtlasResolution, 1)) {
-                std::cerr << "Warning: ShadowRenderPass failed to reinitialize\n";
+            if (!m_shadowPass->resizeAtlas(desiredAtlasResolution, 1)) {
+                std::cerr << "Warning: ShadowRenderPass failed to resize atlas\n";
             }
         }
         if (m_lightingSystem) {
@@ -3444,61 +5473,19 @@ void Renderer::uploadMesh(Mesh* mesh) {
         return;
     }
     
-    const auto& vertices = mesh->getVertices();
-    const auto& indices = mesh->getIndices();
-    
-    if (vertices.empty() || indices.empty()) {
+    if (mesh->getVertexCount() == 0 || mesh->getIndexCount() == 0) {
         std::cerr << "Cannot upload mesh: empty vertices or indices" << std::endl;
         return;
     }
 
-    if (MTL::Buffer* vertexBuffer = static_cast<MTL::Buffer*>(mesh->getVertexBuffer())) {
-        vertexBuffer->release();
-        mesh->setVertexBuffer(nullptr);
-    }
-    if (MTL::Buffer* indexBuffer = static_cast<MTL::Buffer*>(mesh->getIndexBuffer())) {
-        indexBuffer->release();
-        mesh->setIndexBuffer(nullptr);
-    }
-    if (MTL::Buffer* skinBuffer = static_cast<MTL::Buffer*>(mesh->getSkinWeightBuffer())) {
-        skinBuffer->release();
-        mesh->setSkinWeightBuffer(nullptr);
-    }
-    
-    // Create vertex buffer
-    size_t vertexBufferSize = vertices.size() * sizeof(Vertex);
-    MTL::Buffer* vertexBuffer = m_device->newBuffer(vertices.data(), vertexBufferSize, MTL::ResourceStorageModeShared);
-    mesh->setVertexBuffer(vertexBuffer);
-    
-    // Create index buffer
-    size_t indexBufferSize = indices.size() * sizeof(uint32_t);
-    MTL::Buffer* indexBuffer = m_device->newBuffer(indices.data(), indexBufferSize, MTL::ResourceStorageModeShared);
-    mesh->setIndexBuffer(indexBuffer);
-
-    if (mesh->hasSkinWeights()) {
-        const auto& skinWeights = mesh->getSkinWeights();
-        if (skinWeights.size() == vertices.size()) {
-            struct SkinWeightGPU {
-                uint32_t indices[4];
-                float weights[4];
-            };
-            std::vector<SkinWeightGPU> packed;
-            packed.resize(skinWeights.size());
-            for (size_t i = 0; i < skinWeights.size(); ++i) {
-                for (int j = 0; j < 4; ++j) {
-                    packed[i].indices[j] = skinWeights[i].indices[j];
-                    packed[i].weights[j] = skinWeights[i].weights[j];
-                }
-            }
-            size_t skinBufferSize = packed.size() * sizeof(SkinWeightGPU);
-            MTL::Buffer* skinBuffer = m_device->newBuffer(packed.data(), skinBufferSize, MTL::ResourceStorageModeShared);
-            mesh->setSkinWeightBuffer(skinBuffer);
-        } else {
-            std::cerr << "Skin weights size mismatch for mesh: " << mesh->getName() << std::endl;
-        }
+    // Vertices, indices and skin weights are sub-allocated in the shared geometry arenas.
+    if (!GeometryBuffer::getInstance().upload(mesh)) {
+        return;
     }
     
     mesh->setUploaded(true);
+    // Cooked runtime meshes stop carrying a CPU copy once the GPU has one.
+    mesh->releaseCpuData();
 }
 
 void Renderer::destroyMesh(Mesh* mesh) {
@@ -3506,25 +5493,8 @@ void Renderer::destroyMesh(Mesh* mesh) {
         return;
     }
     
-    MTL::Buffer* vertexBuffer = static_cast<MTL::Buffer*>(mesh->getVertexBuffer());
-    MTL::Buffer* indexBuffer = static_cast<MTL::Buffer*>(mesh->getIndexBuffer());
-    
-    if (vertexBuffer) {
-        vertexBuffer->release();
-        mesh->setVertexBuffer(nullptr);
-    }
-    
-    if (indexBuffer) {
-        indexBuffer->release();
-        mesh->setIndexBuffer(nullptr);
-    }
-
-    MTL::Buffer* skinBuffer = static_cast<MTL::Buffer*>(mesh->getSkinWeightBuffer());
-    if (skinBuffer) {
-        skinBuffer->release();
-        mesh->setSkinWeightBuffer(nullptr);
-    }
-    
+    // Frees the mesh's arena ranges; the arena compacts itself once enough of it is holes.
+    GeometryBuffer::getInstance().release(mesh);
     mesh->setUploaded(false);
 }
 
@@ -3555,7 +5525,28 @@ void Renderer::renderScene(Scene* scene) {
 
 void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOptions& options) {
     if (!scene) return;
+    CRESCENT_PROFILE_PHASE(profilePhase, "Renderer::prepareFrame");
+    // The editor can render several views a frame (scene or game, and the preview). Work that does
+    // not depend on the view runs for the first of them.
+    const uint64_t engineFrame = m_engineFrame;
+    if (engineFrame != m_viewFrame) {
+        m_viewFrame = engineFrame;
+        m_viewsThisFrame = 0;
+        m_lastFrameShadowAtlasRequest = m_frameShadowAtlasRequest;
+        m_frameShadowAtlasRequest = 0;
+    }
+    const bool firstViewOfFrame = m_viewsThisFrame++ == 0;
+    if (firstViewOfFrame) {
+        serviceBackgroundWork();
+    }
+    if (options.resetHistory) {
+        m_taaHistoryValid = false;
+        m_ssaoHistoryValid = false;
+        m_ssrHistoryValid = false;
+        m_fogVolumeHistoryValid = false;
+    }
     updateProbeVolume(scene->getSettings().staticLighting);
+    const RenderWorld& renderWorld = scene->getRenderWorld();
 
     // Get main camera
     Camera* camera = cameraOverride ? cameraOverride : Camera::getMainCamera();
@@ -3585,25 +5576,27 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 std::chrono::duration<float, std::milli>(endTime - start).count();
         }
     } statsScope(this);
+    m_stats.frameViews = m_viewsThisFrame;
 
     if (m_viewportHeight > 0.0f) {
         float aspectRatio = m_viewportWidth / m_viewportHeight;
         camera->setAspectRatio(aspectRatio);
     }
+    if (camera->getEntity()) {
+        streamProbeBricks(camera->getEntity()->getTransform()->getPosition());
+    }
 
     // Keep atlas resolution aligned with directional light requests so
     // per-light shadow resolution changes visibly affect quality.
     if (m_device && m_shadowPass && m_lightingSystem) {
         uint32_t desiredShadowAtlasRes = static_cast<uint32_t>(std::max(256, m_qualitySettings.shadowResolution));
         uint8_t maxCascadeCount = 1;
-        const auto& qualityProbeEntities = scene->getAllEntities();
-        for (const auto& entry : qualityProbeEntities) {
-            Entity* entity = entry.get();
-            if (!entity || !entity->isActiveInHierarchy()) {
+        for (const auto& lightProxy : renderWorld.getLights()) {
+            if (!lightProxy.entity->isActiveInHierarchy()) {
                 continue;
             }
-            Light* light = entity->getComponent<Light>();
-            if (!light || !light->getCastShadows() || light->getType() != Light::Type::Directional) {
+            Light* light = lightProxy.light;
+            if ( !light->getCastShadows() || light->getType() != Light::Type::Directional) {
                 continue;
             }
             uint32_t lightRes = std::max<uint32_t>(256u, std::min<uint32_t>(8192u, light->getShadowMapResolution()));
@@ -3611,10 +5604,11 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             maxCascadeCount = std::max<uint8_t>(maxCascadeCount, light->getCascadeCount());
         }
         desiredShadowAtlasRes = ComputeShadowAtlasResolution(desiredShadowAtlasRes, maxCascadeCount);
+        m_frameShadowAtlasRequest = std::max(m_frameShadowAtlasRequest, desiredShadowAtlasRes);
+        desiredShadowAtlasRes = std::max(m_frameShadowAtlasRequest, m_lastFrameShadowAtlasRequest);
 
         if (desiredShadowAtlasRes != m_shadowAtlasResolution) {
-            m_shadowPass->shutdown();
-            if (!m_shadowPass->initialize(m_device, desiredShadowAtlasRes, 1)) {
+            if (!m_shadowPass->resizeAtlas(desiredShadowAtlasRes, 1)) {
                 std::cerr << "Warning: ShadowRenderPass failed to upsize atlas\n";
             }
             m_lightingSystem->configureShadowAtlas(desiredShadowAtlasRes, 1);
@@ -3623,6 +5617,13 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     }
     
     float renderScale = std::max(0.5f, std::min(2.0f, m_qualitySettings.renderScale));
+    // Dynamic resolution only drives the game view, the one whose GPU time it measures.
+    bool dynamicResolution = m_activePool == RenderTargetPool::Game
+        && m_dynamicResolution && m_dynamicResolution->isEnabled();
+    float maxRenderScale = renderScale;
+    if (dynamicResolution) {
+        renderScale = m_dynamicResolution->getScale();
+    }
     const auto& post = scene->getSettings().postProcess;
     const auto& fog = scene->getSettings().fog;
     bool allowTemporal = options.allowTemporal;
@@ -3636,7 +5637,15 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     bool metalFXRequested = allowTemporal
         && m_activePool == RenderTargetPool::Game
         && m_qualitySettings.upscaler == 1
-        && renderScale < 0.999f;
+        && (dynamicResolution ? m_dynamicResolution->getMinScale() : renderScale) < 0.999f;
+    bool metalFXSpatialRequested = m_activePool == RenderTargetPool::Game
+        && m_qualitySettings.upscaler == 2
+        && (dynamicResolution ? m_dynamicResolution->getMinScale() : renderScale) < 0.999f;
+    if ((metalFXRequested || metalFXSpatialRequested) && dynamicResolution) {
+        // The scalers only upscale; keep every dynamic size at or below the output.
+        maxRenderScale = std::min(1.0f, maxRenderScale);
+        renderScale = std::min(maxRenderScale, renderScale);
+    }
     bool ssrEnabled = post.enabled && post.ssr;
     bool motionBlurEnabled = allowTemporal && post.enabled && post.motionBlur;
     bool dofEnabled = post.enabled && post.depthOfField;
@@ -3648,17 +5657,34 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     bool useOffscreen = bloomEnabled || toneMappingEnabled || colorGradingEnabled
         || vignetteEnabled || filmGrainEnabled
         || taaRequested || ssrEnabled || motionBlurEnabled || dofEnabled || fogEnabled
-        || std::abs(renderScale - 1.0f) > 0.001f;
+        || dynamicResolution || std::abs(renderScale - 1.0f) > 0.001f;
     bool hdrPost = bloomEnabled || toneMappingEnabled || colorGradingEnabled;
-    int desiredColorFormat = hdrPost ? static_cast<int>(MTL::PixelFormatRGBA16Float)
-                                     : static_cast<int>(MTL::PixelFormatBGRA8Unorm);
+    int desiredColorFormat = hdrPost ? m_hdrColorFormat : static_cast<int>(MTL::PixelFormatBGRA8Unorm);
     m_outputHDR = hdrPost;
     uint32_t renderWidth = static_cast<uint32_t>(std::max(1.0f, std::round(m_viewportWidth * renderScale)));
     uint32_t renderHeight = static_cast<uint32_t>(std::max(1.0f, std::round(m_viewportHeight * renderScale)));
+    m_stats.renderScale = renderScale;
+    if (m_activePool == RenderTargetPool::Game && m_dynamicResolution) {
+        m_stats.gpuFrameTimeMs = m_dynamicResolution->getGpuTimeMs();
+    }
+    m_stats.gpuPassTimeMs = m_gpuPassProfiler->getPassTimesMs(m_activePool == RenderTargetPool::Game);
     ensureRenderTargets(renderWidth, renderHeight, m_qualitySettings.msaaSamples, desiredColorFormat);
+    if (m_renderTargetHeap) {
+        m_stats.renderTargetHeapBytes = m_renderTargetHeap->getHeapSize();
+        m_stats.renderTargetAliasedBytes = m_renderTargetHeap->getAliasedBytes();
+    }
     if (fogEnabled) {
         ensureFogVolume(renderWidth, renderHeight, fog.volumetricQuality);
     }
+    if (post.enabled && post.ssao) {
+        ensureSSAOTargets(renderWidth, renderHeight, m_qualitySettings.ssaoResolution);
+    }
+    if (ssrEnabled) {
+        ensureSSRTargets(renderWidth, renderHeight);
+    }
+    if (m_qualitySettings.visibilityBuffer) {
+        ensureVisibilityTargets(renderWidth, renderHeight);
+    }
     bool useMSAA = m_msaaSamples > 1;
     bool resolveToDrawable = useMSAA && !useOffscreen;
     if ((useOffscreen || useMSAA) && !m_colorTexture) {
@@ -3674,17 +5700,41 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     if (metalFXRequested) {
         uint32_t outputWidth = static_cast<uint32_t>(std::max(1.0f, std::round(m_viewportWidth)));
         uint32_t outputHeight = static_cast<uint32_t>(std::max(1.0f, std::round(m_viewportHeight)));
-        metalFXEnabled = ensureMetalFXResources(renderWidth, renderHeight, outputWidth, outputHeight, desiredColorFormat);
+        if (dynamicResolution) {
+            // Sized once for the largest dynamic frame; each frame passes its own content size.
+            uint32_t inputWidth = static_cast<uint32_t>(std::max(1.0f, std::round(m_viewportWidth * maxRenderScale)));
+            uint32_t inputHeight = static_cast<uint32_t>(std::max(1.0f, std::round(m_viewportHeight * maxRenderScale)));
+            metalFXEnabled = ensureMetalFXResources(inputWidth, inputHeight, outputWidth, outputHeight,
+                                                    desiredColorFormat, true);
+        } else {
+            metalFXEnabled = ensureMetalFXResources(renderWidth, renderHeight, outputWidth, outputHeight,
+                                                    desiredColorFormat, false);
+        }
     }
     if (metalFXEnabled) {
         taaEnabled = false;
     }
+    // Spatial upscaling needs no jitter or history; TAA keeps running at render resolution.
+    bool metalFXSpatialEnabled = false;
+    if (metalFXSpatialRequested) {
+        uint32_t outputWidth = static_cast<uint32_t>(std::max(1.0f, std::round(m_viewportWidth)));
+        uint32_t outputHeight = static_cast<uint32_t>(std::max(1.0f, std::round(m_viewportHeight)));
+        metalFXSpatialEnabled = ensureMetalFXSpatialResources(renderWidth, renderHeight, outputWidth, outputHeight,
+                                                              desiredColorFormat);
+    }
+    bool frameInterpolationEnabled = metalFXEnabled
+        && m_qualitySettings.frameInterpolation
+        && options.updateHistory
+        && ensureMetalFXFrameInterpolator();
+    if (!frameInterpolationEnabled) {
+        m_metalFXPrevOutputValid = false;
+    }
 
     Math::Matrix4x4 viewMatrix = camera->getViewMatrix();
     Math::Matrix4x4 projectionMatrix = camera->getProjectionMatrix();
     Math::Matrix4x4 projectionMatrixNoJitter = projectionMatrix;
     Math::Matrix4x4 viewProjectionNoJitter = projectionMatrix * viewMatrix;
-    const auto frustumPlanes = ExtractFrustumPlanes(viewProjectionNoJitter);
+    const auto frustumPlanes = Math::ExtractFrustumPlanes(viewProjectionNoJitter);
     float temporalJitterX = 0.0f;
     float temporalJitterY = 0.0f;
     if (taaEnabled || metalFXEnabled) {
@@ -3701,24 +5751,106 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     }
     Math::Matrix4x4 viewProjection = projectionMatrix * viewMatrix;
     
-    // Get drawable
-    CA::MetalDrawable* drawable = m_metalLayer->nextDrawable();
-    if (!drawable) {
-        return;
-    }
     if (resolveToDrawable) {
-        MTL::Texture* drawableTex = drawable->texture();
-        if (!drawableTex || drawableTex->width() != renderWidth || drawableTex->height() != renderHeight) {
+        const CGSize drawableSize = m_metalLayer->drawableSize();
+        if (static_cast<uint32_t>(drawableSize.width) != renderWidth || static_cast<uint32_t>(drawableSize.height) != renderHeight) {
             resolveToDrawable = false;
         }
     }
 
+    // The drawable is acquired right before the first pass that writes it, so the layer's few
+    // drawables are not held while the CPU encodes shadows, the prepass and lighting.
+    CA::MetalDrawable* drawable = nullptr;
+    std::chrono::steady_clock::time_point drawableAcquiredAt;
+    auto acquireDrawable = [&]() -> CA::MetalDrawable* {
+        if (!drawable) {
+            const auto waitStart = std::chrono::steady_clock::now();
+            drawable = m_metalLayer->nextDrawable();
+            drawableAcquiredAt = std::chrono::steady_clock::now();
+            m_stats.drawableWaitMs += std::chrono::duration<float, std::milli>(drawableAcquiredAt - waitStart).count();
+        }
+        return drawable;
+    };
+
     const uint32_t bufferSlot = m_bufferFrameIndex % kMaxFramesInFlight;
     if (m_inFlightCommandBuffers[bufferSlot]) {
-        m_inFlightCommandBuffers[bufferSlot]->waitUntilCompleted();
+        MTL::CommandBuffer* finished = m_inFlightCommandBuffers[bufferSlot];
+        const uint64_t frameValue = m_inFlightFrameValues[bufferSlot];
+        const auto waitStart = std::chrono::steady_clock::now();
+        if (m_frameEvent && frameValue > 0) {
+            // A command buffer that failed never signals, so the wait also gives up once it errored.
+            while (m_frameEvent->signaledValue() < frameValue
+                   && !m_frameEvent->waitUntilSignaledValue(frameValue, 100)) {
+                if (finished->status() == MTL::CommandBufferStatusError) {
+                    break;
+                }
+            }
+        } else {
+            finished->waitUntilCompleted();
+        }
+        m_stats.frameSlotWaitMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+        // GPU times are filled in when the buffer completes, which can trail the signal slightly;
+        // such a frame is left out of the dynamic resolution history.
+        if (m_inFlightGameView[bufferSlot] && m_dynamicResolution
+            && finished->status() == MTL::CommandBufferStatusCompleted) {
+            double gpuSeconds = finished->GPUEndTime() - finished->GPUStartTime();
+            m_stats.gpuLastFrameTimeMs = static_cast<float>(gpuSeconds * 1000.0);
+            m_dynamicResolution->addGpuTime(m_stats.gpuLastFrameTimeMs);
+        }
+        m_gpuPassProfiler->resolve(bufferSlot, m_inFlightGameView[bufferSlot]);
         m_inFlightCommandBuffers[bufferSlot]->release();
         m_inFlightCommandBuffers[bufferSlot] = nullptr;
     }
+    m_gpuPassProfiler->beginFrame(bufferSlot);
+    GeometryBuffer::getInstance().beginFrame(m_bufferFrameIndex);
+    if (m_skinningCache) {
+        m_skinningCache->beginFrame(bufferSlot);
+    }
+    if (m_crowdAnimation) {
+        m_crowdAnimation->beginFrame(bufferSlot);
+    }
+    if (m_sceneResidency) {
+        m_sceneResidency->beginFrame(m_bufferFrameIndex);
+    }
+    if (m_materialTable) {
+        m_materialTable->beginFrame(bufferSlot);
+    }
+    if (m_uniformRing) {
+        m_uniformRing->beginFrame(bufferSlot);
+    }
+    if (m_instanceCache) {
+        m_instanceCache->beginFrame(bufferSlot);
+    }
+    if (m_foliageSystem) {
+        m_foliageSystem->beginFrame();
+    }
+    if (m_terrainSystem) {
+        m_terrainSystem->beginFrame(bufferSlot);
+    }
+    if (m_terrainVirtualTexture) {
+        m_terrainVirtualTexture->beginFrame(bufferSlot);
+    }
+    UniformRing* frameUniforms = m_uniformRing && m_uniformRing->isAvailable() ? m_uniformRing.get() : nullptr;
+    FrameArena& frameArena = m_frameArenas[bufferSlot];
+    frameArena.reset();
+
+    // Indexed like renderWorld.getMeshRenderers(); shared by the depth prepass and main pass.
+    FrameVector<uint8_t> meshInFrustum(frameArena);
+    FrameVector<Math::Vector4> meshSpheres(frameArena);
+    CullMeshProxies(renderWorld.getMeshRenderers(), frustumPlanes, kCullTightness, frameArena, meshInFrustum, &meshSpheres);
+    resolveOcclusionResults(bufferSlot);
+    m_stats.occlusionVisible = m_occlusionVisible;
+    m_stats.occlusionOccluded = m_occlusionOccluded;
+    m_stats.pipelineCompileHistogram = m_pipelineCompileHistogram;
+    m_stats.pipelinesCompiling = m_pipelineCompilesInFlight;
+    m_stats.texturesStreaming = m_textureLoader ? static_cast<uint32_t>(m_textureLoader->getStreamingCount()) : 0;
+    if (m_textureStreamer) {
+        m_stats.mipStreamedTextures = m_textureStreamer->getTrackedCount();
+        m_stats.mipStreamedBytes = m_textureStreamer->getResidentBytes();
+        m_stats.mipLoadsInFlight = m_textureStreamer->getMipLoadsInFlight();
+    }
+    m_stats.slowestPipelineKey = m_slowestPipelineKey;
+    m_stats.slowestPipelineCompileMs = m_slowestPipelineCompileMs;
 
     m_cameraUniformBuffer = m_cameraUniformBuffers[bufferSlot];
     m_lightUniformBuffer = m_lightUniformBuffers[bufferSlot];
@@ -3727,23 +5859,22 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     m_shadowGPUBuffer = m_shadowGPUBuffers[bufferSlot];
     m_clusterParamsBuffer = m_clusterParamsBuffers[bufferSlot];
     m_skinningBuffer = m_skinningBuffers[bufferSlot];
-    m_prevSkinningBuffer = m_prevSkinningBuffers[bufferSlot];
     m_instanceBuffer = m_instanceBuffers[bufferSlot];
     m_instanceCullBuffer = m_instanceCullBuffers[bufferSlot];
     m_instanceCountBuffer = m_instanceCountBuffers[bufferSlot];
     m_instanceIndirectBuffer = m_instanceIndirectBuffers[bufferSlot];
     m_skinningBufferCapacity = m_skinningBufferCapacities[bufferSlot];
-    m_prevSkinningBufferCapacity = m_prevSkinningBufferCapacities[bufferSlot];
     m_instanceBufferCapacity = m_instanceBufferCapacities[bufferSlot];
     m_instanceCullCapacity = m_instanceCullCapacities[bufferSlot];
     m_instanceCountCapacity = m_instanceCountCapacities[bufferSlot];
     m_instanceIndirectCapacity = m_instanceIndirectCapacities[bufferSlot];
+    updateMemoryUsage();
     
     // Create command buffer
     MTL::CommandBuffer* commandBuffer = m_commandQueue->commandBuffer();
+    m_stats.commandBuffers++;
 
     size_t skinningOffset = 0;
-    size_t prevSkinningOffset = 0;
     m_instanceBufferOffset = 0;
     auto allocateSkinningSlice = [&](MTL::Buffer*& buffer,
                                      size_t& capacity,
@@ -3763,9 +5894,6 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             if (&buffer == &m_skinningBuffer) {
                 m_skinningBuffers[bufferSlot] = buffer;
                 m_skinningBufferCapacities[bufferSlot] = capacity;
-            } else if (&buffer == &m_prevSkinningBuffer) {
-                m_prevSkinningBuffers[bufferSlot] = buffer;
-                m_prevSkinningBufferCapacities[bufferSlot] = capacity;
             }
             alignedOffset = 0;
             required = bytes;
@@ -3778,6 +5906,16 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         return true;
     };
 
+    auto reserveSkinningBlock = [&](size_t bytes) -> PassSkinningBlock {
+        PassSkinningBlock block;
+        if (bytes > 0 && allocateSkinningSlice(m_skinningBuffer, m_skinningBufferCapacity, skinningOffset, bytes, block.base)) {
+            block.buffer = m_skinningBuffer;
+            // The pass's draws fill the whole block with their palettes.
+            m_stats.skinningBytesUploaded += bytes;
+        }
+        return block;
+    };
+
     auto allocateInstanceSlice = [&](size_t bytes, size_t& outOffset) -> bool {
         constexpr size_t kAlignment = 256;
         size_t alignedOffset = (m_instanceBufferOffset + (kAlignment - 1)) & ~(kAlignment - 1);
@@ -3804,7 +5942,8 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     
     // Prepare lighting once so both shadow and clustered passes use fresh data
     if (m_lightingSystem) {
-        m_lightingSystem->beginFrame(scene, camera, renderWidth, renderHeight);
+        m_lightingSystem->setShadowDepthBoundsAvailable(m_shadowPass && m_shadowPass->hasDepthBounds());
+        m_lightingSystem->beginFrame(scene, camera, renderWidth, renderHeight, engineFrame);
         m_lightingSystem->setDebugDrawAtlas(m_debugDrawShadowAtlas);
         
         const auto& gpuLights = m_lightingSystem->getGPULights();
@@ -3827,24 +5966,56 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             }
         };
         
-        if (!gpuLights.empty()) {
-            ensureBuffer(m_lightGPUBuffer, gpuLights.size() * sizeof(LightGPUData), gpuLights.data());
-        } else {
-            // Keep a tiny dummy buffer bound to satisfy shader validation
-            ensureBuffer(m_lightGPUBuffer, sizeof(LightGPUData), nullptr);
-            if (m_lightGPUBuffer) {
-                std::memset(m_lightGPUBuffer->contents(), 0, m_lightGPUBuffer->length());
-            }
-        }
-        if (!gpuShadows.empty()) {
-            ensureBuffer(m_shadowGPUBuffer, gpuShadows.size() * sizeof(ShadowGPUData), gpuShadows.data());
-        } else {
-            // Bind a dummy shadow buffer so fragment binding slot 5 is always valid
-            ensureBuffer(m_shadowGPUBuffer, sizeof(ShadowGPUData), nullptr);
-            if (m_shadowGPUBuffer) {
-                std::memset(m_shadowGPUBuffer->contents(), 0, m_shadowGPUBuffer->length());
+        // Light and shadow records keep their slot across frames; each frame-slot buffer copies
+        // only the records whose version moved since it last received them.
+        auto uploadRecords = [&](MTL::Buffer*& buf, const void* src, size_t count, size_t stride,
+                                 const std::vector<uint64_t>& versions, RecordUploadState& uploaded) {
+            const size_t bytes = std::max<size_t>(1, count) * stride;
+            const bool reallocated = !buf || buf->length() < bytes;
+            ensureBuffer(buf, bytes, nullptr);
+            if (!buf) {
+                return;
+            }
+            // Untracked records (versions out of step with the data) are always copied.
+            const bool tracked = versions.size() == count;
+            if (reallocated || uploaded.buffer != buf || !tracked) {
+                uploaded.buffer = buf;
+                uploaded.versions.clear();
+            }
+            if (count == 0) {
+                // Keep a zeroed dummy record bound to satisfy shader validation
+                std::memset(buf->contents(), 0, stride);
+                uploaded.versions.clear();
+                return;
+            }
+            uploaded.versions.resize(count, 0);
+            auto stale = [&](size_t i) { return !tracked || uploaded.versions[i] != versions[i]; };
+            char* dst = static_cast<char*>(buf->contents());
+            const char* srcBytes = static_cast<const char*>(src);
+            for (size_t i = 0; i < count;) {
+                if (!stale(i)) {
+                    ++i;
+                    continue;
+                }
+                size_t end = i + 1;
+                while (end < count && stale(end)) {
+                    ++end;
+                }
+                std::memcpy(dst + i * stride, srcBytes + i * stride, (end - i) * stride);
+                m_stats.uniformBytesUploaded += (end - i) * stride;
+                if (tracked) {
+                    std::copy(versions.begin() + i, versions.begin() + end, uploaded.versions.begin() + i);
+                }
+                m_stats.lightRecordsUploaded += static_cast<uint32_t>(end - i);
+                i = end;
             }
-        }
+        };
+
+        uploadRecords(m_lightGPUBuffer, gpuLights.data(), gpuLights.size(), sizeof(LightGPUData),
+                      m_lightingSystem->getGPULightVersions(), m_lightRecordUploads[bufferSlot]);
+        // Bind a dummy shadow buffer when empty so fragment binding slot 5 is always valid
+        uploadRecords(m_shadowGPUBuffer, gpuShadows.data(), gpuShadows.size(), sizeof(ShadowGPUData),
+                      m_lightingSystem->getGPUShadowVersions(), m_shadowRecordUploads[bufferSlot]);
         uint32_t count = static_cast<uint32_t>(gpuLights.size());
         ensureBuffer(m_lightCountBuffer, sizeof(uint32_t), &count);
         
@@ -3855,7 +6026,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         clusterParams.clusterY = m_clusterPass ? m_clusterPass->getClusterY() : 9;
         clusterParams.clusterZ = m_clusterPass ? m_clusterPass->getClusterZ() : 24;
         clusterParams.lightCount = static_cast<uint32_t>(m_lightingSystem->getVisibleLightCount());
-        clusterParams.maxLightsPerCluster = 64;
+        clusterParams.maxLightsPerCluster = m_clusterPass ? m_clusterPass->getMaxLightsPerCluster() : 64;
         clusterParams.screenWidth = static_cast<float>(renderWidth);
         clusterParams.screenHeight = static_cast<float>(renderHeight);
         clusterParams.nearPlane = camera->getNearClip();
@@ -3863,23 +6034,6 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         ensureBuffer(m_clusterParamsBuffer, sizeof(ClusterParams), &clusterParams);
     }
     
-    // Build clustered light lists
-    if (m_clusterPass && m_lightGPUBuffer) {
-        m_clusterPass->setFrameSlot(bufferSlot);
-        m_clusterPass->dispatch(
-            commandBuffer,
-            *m_lightingSystem,
-            camera->getProjectionMatrix(),
-            camera->getNearClip(),
-            camera->getFarClip(),
-            renderWidth,
-            renderHeight,
-            m_lightGPUBuffer
-        );
-        m_clusterHeaderBuffer = m_clusterPass->getClusterHeaders();
-        m_clusterIndexBuffer = m_clusterPass->getClusterIndices();
-    }
-
     MTL::Viewport viewport = {
         0.0, 0.0,
         static_cast<double>(renderWidth), static_cast<double>(renderHeight),
@@ -3887,7 +6041,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     };
     
     // Collect lights
-    std::vector<Light*> lights;
+    FrameVector<Light*> lights(frameArena);
     Light* mainLight = Light::getMainLight();
     if (mainLight) {
         lights.push_back(mainLight);
@@ -3905,81 +6059,50 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     Math::Vector3 camPos = camera->getEntity()->getTransform()->getPosition();
     cameraUniforms->cameraPositionTime = Math::Vector4(camPos.x, camPos.y, camPos.z, Time::time());
 
-    std::unordered_set<std::string> hlodHidden;
-    std::unordered_set<std::string> hlodActiveProxies;
-    {
-        const auto& hlodEntities = scene->getAllEntities();
-        for (const auto& entityPtr : hlodEntities) {
-            Entity* entity = entityPtr.get();
-            if (!entity || !entity->isActiveInHierarchy()) {
-                continue;
-            }
-            HLODProxy* proxy = entity->getComponent<HLODProxy>();
-            if (!proxy || !proxy->isEnabled()) {
-                continue;
-            }
-            MeshRenderer* mr = entity->getComponent<MeshRenderer>();
-            if (!mr || !mr->isEnabled() || !mr->getMesh()) {
-                continue;
-            }
-            Math::Vector3 center = mr->getBoundsCenter();
-            float dist = (center - camPos).length();
-            float activationDistance = proxy->getLodEnd() > proxy->getLodStart() + 0.01f
-                ? proxy->getLodEnd()
-                : proxy->getLodStart();
-            bool active = dist >= activationDistance;
-            if (!active) {
-                continue;
-            }
-            std::string proxyId = entity->getUUID().toString();
-            hlodActiveProxies.insert(proxyId);
-            for (const auto& src : proxy->getSourceUuids()) {
-                hlodHidden.insert(src);
-            }
-        }
-    }
+    // Mesh LOD selection for this view (Mesh::selectLod): w is how many pixels one world unit
+    // covers at distance 1. Each step of lodBias doubles the tolerated error.
+    m_lodView = Math::Vector4(camPos.x, camPos.y, camPos.z,
+                              0.5f * static_cast<float>(renderHeight) * projectionMatrixNoJitter(1, 1));
+    m_lodPixelError = kLodPixelError * std::exp2(m_qualitySettings.lodBias);
 
-    auto shouldSkipEntity = [&](Entity* entity) -> bool {
-        if (!entity) {
-            return true;
+    // Entity sets of this frame, by dense entity index. HLOD proxies and the sources they hide
+    // come from the scene's switch, which only re-tests the proxies around the camera.
+    const uint32_t entityIndexCount = scene->getEntityIndexCount();
+    const HLODSwitch& hlodSwitch = scene->updateHLODSwitch(camPos);
+
+    auto shouldSkipEntity = [&](const MeshRenderProxy& proxy) -> bool {
+        if (!hlodSwitch.anyHidden() && !proxy.hlod) {
+            return false;
         }
-        std::string id = entity->getUUID().toString();
-        if (hlodHidden.find(id) != hlodHidden.end()) {
+        const uint32_t index = proxy.entity->getIndex();
+        if (hlodSwitch.isHidden(index)) {
             return true;
         }
-        if (auto* proxy = entity->getComponent<HLODProxy>()) {
-            return hlodActiveProxies.find(id) == hlodActiveProxies.end();
+        if (proxy.hlod) {
+            return !hlodSwitch.isProxyActive(index);
         }
         return false;
     };
 
     // Ensure meshes are uploaded before any pass uses them
-    const auto& entitiesPre = scene->getAllEntities();
-    for (const auto& entPtr : entitiesPre) {
-        if (shouldSkipEntity(entPtr.get())) {
+    for (const auto& proxy : renderWorld.getMeshRenderers()) {
+        if (shouldSkipEntity(proxy)) {
             continue;
         }
-        MeshRenderer* mr = entPtr->getComponent<MeshRenderer>();
-        if (!mr || !mr->isEnabled()) continue;
+        MeshRenderer* mr = proxy.meshRenderer;
+        if (!mr->isEnabled()) continue;
         std::shared_ptr<Mesh> mesh = mr->getMesh();
         if (mesh && !mesh->isUploaded()) {
             uploadMesh(mesh.get());
         }
     }
 
-    auto resolveCullMode = [](Material* material) -> MTL::CullMode {
-        if (!material) {
-            return MTL::CullModeBack;
-        }
-        if (material->isTwoSided() || material->getCullMode() == Material::CullMode::Off) {
-            return MTL::CullModeNone;
-        }
-        if (material->getCullMode() == Material::CullMode::Front) {
-            return MTL::CullModeFront;
-        }
-        return MTL::CullModeBack;
+    // Static opaque meshes are culled and drawn from the GPU scene; the CPU loops below skip them.
+    const bool useStaticScene = updateStaticScene(renderWorld, bufferSlot);
+    auto isStaticSceneProxy = [&](size_t proxyIndex) {
+        return useStaticScene && m_staticScene.proxyEntry[proxyIndex] != kNoStaticEntry;
     };
-    
+
     struct InstancedBatchKey {
         Mesh* mesh = nullptr;
         Mesh* sourceMesh = nullptr;
@@ -3987,6 +6110,8 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         bool isTransparent = false;
         bool receiveShadows = true;
         bool castShadows = true;
+        bool isSkinned = false;
+        Texture2D* vertexAnimation = nullptr;
 
         bool operator==(const InstancedBatchKey& other) const {
             return mesh == other.mesh &&
@@ -3994,7 +6119,9 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                    material == other.material &&
                    isTransparent == other.isTransparent &&
                    receiveShadows == other.receiveShadows &&
-                   castShadows == other.castShadows;
+                   castShadows == other.castShadows &&
+                   isSkinned == other.isSkinned &&
+                   vertexAnimation == other.vertexAnimation;
         }
     };
 
@@ -4006,16 +6133,21 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             h ^= static_cast<size_t>(key.isTransparent) << 1;
             h ^= static_cast<size_t>(key.receiveShadows) << 2;
             h ^= static_cast<size_t>(key.castShadows) << 3;
+            h ^= static_cast<size_t>(key.isSkinned) << 4;
+            h ^= reinterpret_cast<size_t>(key.vertexAnimation) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
             return h;
         }
     };
 
     struct InstancedBatch {
+        explicit InstancedBatch(FrameArena& arena) : instances(arena) {}
+
         InstancedBatchKey key;
         std::shared_ptr<Material> material;
-        std::vector<InstanceDataGPU> instances;
+        FrameVector<InstanceDataGPU> instances;
         Math::Vector3 boundsCenter;
         Math::Vector3 boundsSize;
+        VertexAnimationParamsGPU vertexAnimationParams;
     };
 
     struct InstancedDraw {
@@ -4023,11 +6155,17 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         std::shared_ptr<Material> material;
         bool isTransparent = false;
         bool receiveShadows = true;
+        MTL::Buffer* instanceBuffer = nullptr;
         size_t instanceOffset = 0;
         uint32_t instanceCount = 0;
         Math::Vector3 boundsCenter;
         Math::Vector3 boundsSize;
         bool isBillboard = false;
+        bool isSkinned = false;
+        Texture2D* vertexAnimation = nullptr;
+        VertexAnimationParamsGPU vertexAnimationParams;
+        MTL::Texture* terrainHeights = nullptr;
+        TerrainParamsGPU terrainParams;
     };
 
     struct InstanceBatchGPU {
@@ -4037,21 +6175,37 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         bool isTransparent = false;
         bool receiveShadows = true;
         bool castShadows = true;
+        // Persistent InstanceCache buffer the batch reads its instances from, from the start; null
+        // for batches in the frame's instance buffer at inputOffset.
+        MTL::Buffer* inputBuffer = nullptr;
         uint32_t inputOffset = 0;
         uint32_t inputCount = 0;
         uint32_t outputOffset = 0;
         Math::Vector3 boundsCenter;
         Math::Vector3 boundsSize;
         bool isBillboard = false;
+        // With lodMaxDistance set, the cull kernel keeps only the instances whose bounds centre is
+        // this far from the camera (foliage picks mesh or billboard per instance this way).
+        float lodMinDistance = 0.0f;
+        float lodMaxDistance = 0.0f;
+        // Crowd batch: instances skin from the CrowdAnimation palettes.
+        bool isSkinned = false;
+        // Vertex animation batch: instances play this baked clip (vertex_vat_instanced).
+        Texture2D* vertexAnimation = nullptr;
+        VertexAnimationParamsGPU vertexAnimationParams;
+        // Terrain batch: instances are patches displaced from this clipmap (vertex_terrain_instanced).
+        MTL::Texture* terrainHeights = nullptr;
+        TerrainParamsGPU terrainParams;
     };
 
-    std::unordered_map<InstancedBatchKey, InstancedBatch, InstancedBatchKeyHash> instancedVisible;
-    std::unordered_map<InstancedBatchKey, InstancedBatch, InstancedBatchKeyHash> instancedShadow;
-    std::vector<InstancedDraw> instancedDraws;
-    std::vector<InstancedShadowDraw> instancedShadowDraws;
-    std::vector<InstanceBatchGPU> instancedBatches;
-    std::unordered_set<Entity*> gpuCulledStatics;
-    std::unordered_set<std::string> gpuCulledStaticIds;
+    FrameUnorderedMap<InstancedBatchKey, InstancedBatch, InstancedBatchKeyHash> instancedVisible(frameArena);
+    FrameUnorderedMap<InstancedBatchKey, InstancedBatch, InstancedBatchKeyHash> instancedShadow(frameArena);
+    FrameVector<InstancedDraw> instancedDraws(frameArena);
+    FrameVector<InstancedShadowDraw> instancedShadowDraws(frameArena);
+    FrameVector<InstanceBatchGPU> instancedBatches(frameArena);
+    FrameVector<InstanceBatchGPU> cachedInstanceBatches(frameArena);
+    FrameUnorderedSet<Entity*> gpuCulledStatics(frameArena);
+    FrameVector<uint32_t> gpuCulledStaticIndices(frameArena);
     std::shared_ptr<Mesh> billboardMesh = m_billboardMesh;
     if (billboardMesh && !billboardMesh->isUploaded()) {
         uploadMesh(billboardMesh.get());
@@ -4059,14 +6213,13 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     Math::Vector3 cameraPos = camera->getEntity()->getTransform()->getPosition();
 
     {
-        const auto& instancedEntities = scene->getAllEntities();
-        for (const auto& entityPtr : instancedEntities) {
-            Entity* entity = entityPtr.get();
-            if (!entity || !entity->isActiveInHierarchy()) {
+        for (const auto& instancedProxy : renderWorld.getInstancedRenderers()) {
+            Entity* entity = instancedProxy.entity;
+            if (!entity->isActiveInHierarchy()) {
                 continue;
             }
-            InstancedMeshRenderer* instanced = entity->getComponent<InstancedMeshRenderer>();
-            if (!instanced || !instanced->isEnabled()) {
+            InstancedMeshRenderer* instanced = instancedProxy.instanced;
+            if (!instanced->isEnabled()) {
                 continue;
             }
             std::shared_ptr<Mesh> mesh = instanced->getMesh();
@@ -4098,12 +6251,76 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
 
             Math::Matrix4x4 parentMatrix = entity->getTransform()->getWorldMatrix();
 
-            for (const auto& local : instanceTransforms) {
-                Math::Matrix4x4 world = parentMatrix * local;
+            // Animated crowds skin each instance from its own palette (see CrowdAnimation), whose
+            // first matrix goes in normalMatrix[3].y. Poses reach outside the bind pose bounds, so
+            // culling uses larger ones, and there is no billboard for a skinned mesh.
+            const uint32_t crowdPalette = m_crowdAnimation ? m_crowdAnimation->add(instanced) : CrowdAnimation::kNoPalette;
+            const bool isCrowd = crowdPalette != CrowdAnimation::kNoPalette;
+            const uint32_t crowdBoneCount = isCrowd ? instanced->getSkeleton()->getBoneCount() : 0;
+            if (isCrowd) {
+                meshSize = meshSize * kCrowdBoundsScale;
+                billboardRangeValid = false;
+            }
+
+            // Without a crowd animation, a baked vertex animation plays instead. Each instance keeps
+            // its time offset and speed in normalMatrix[3].z and .w, and the batch culls with the
+            // bounds of every baked frame.
+            Texture2D* vertexAnimation = nullptr;
+            VertexAnimationParamsGPU vertexAnimationParams{};
+            if (!isCrowd && instanced->hasVertexAnimation()) {
+                const VertexAnimationTexture& vat = instanced->getVertexAnimation();
+                std::shared_ptr<Texture2D> texture = resolveVertexAnimationTexture(vat.texturePath);
+                if (texture && texture->getHandle()) {
+                    vertexAnimation = texture.get();
+                    Math::Vector3 extent = vat.boundsMax - vat.boundsMin;
+                    vertexAnimationParams.boundsMin = Math::Vector4(vat.boundsMin.x, vat.boundsMin.y, vat.boundsMin.z, Time::time());
+                    vertexAnimationParams.boundsExtent = Math::Vector4(extent.x, extent.y, extent.z, vat.durationSeconds);
+                    vertexAnimationParams.vertexColumns = vat.vertexColumns;
+                    vertexAnimationParams.rowsPerFrame = vat.rowsPerFrame;
+                    vertexAnimationParams.frameCount = vat.frameCount;
+                    vertexAnimationParams.looping = vat.looping ? 1u : 0u;
+                    meshCenter = (vat.boundsMin + vat.boundsMax) * 0.5f;
+                    meshSize = extent;
+                    billboardRangeValid = false;
+                }
+            }
+
+            // Without crowd poses or a billboard switch the instances need no per-frame CPU work:
+            // they stay resident in the InstanceCache, which uploads only what was edited, and
+            // the renderer draws as a batch of its own.
+            if (!isCrowd && !billboardRangeValid && m_instanceCache && m_instanceCache->isAvailable()) {
+                MTL::Buffer* cached = m_instanceCache->update(*instanced, parentMatrix, vertexAnimation != nullptr);
+                if (cached) {
+                    InstanceBatchGPU gpu{};
+                    gpu.mesh = mesh.get();
+                    gpu.sourceMesh = mesh.get();
+                    gpu.material = material;
+                    gpu.isTransparent = isTransparent;
+                    gpu.receiveShadows = instanced->getReceiveShadows();
+                    gpu.castShadows = instanced->getCastShadows();
+                    gpu.inputBuffer = cached;
+                    gpu.inputCount = static_cast<uint32_t>(instanceTransforms.size());
+                    gpu.boundsCenter = meshCenter;
+                    gpu.boundsSize = meshSize;
+                    gpu.vertexAnimation = vertexAnimation;
+                    gpu.vertexAnimationParams = vertexAnimationParams;
+                    cachedInstanceBatches.push_back(gpu);
+                    continue;
+                }
+            }
+
+            for (size_t instanceIndex = 0; instanceIndex < instanceTransforms.size(); ++instanceIndex) {
+                Math::Matrix4x4 world = parentMatrix * instanceTransforms[instanceIndex];
 
                 InstanceDataGPU data{};
                 data.modelMatrix = world;
                 data.normalMatrix = world.normalMatrix();
+                if (isCrowd) {
+                    data.normalMatrix(1, 3) = static_cast<float>(crowdPalette + static_cast<uint32_t>(instanceIndex) * crowdBoneCount);
+                } else if (vertexAnimation) {
+                    data.normalMatrix(2, 3) = instanced->getVertexAnimationOffset(instanceIndex);
+                    data.normalMatrix(3, 3) = instanced->getVertexAnimationSpeed();
+                }
 
                 if (instanced->getCastShadows()) {
                     auto addShadowInstance = [&](Mesh* drawMesh, Mesh* sourceMesh) {
@@ -4114,11 +6331,14 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                         key.isTransparent = isTransparent;
                         key.receiveShadows = instanced->getReceiveShadows();
                         key.castShadows = instanced->getCastShadows();
-                        auto& batch = instancedShadow[key];
+                        key.isSkinned = isCrowd;
+                        key.vertexAnimation = vertexAnimation;
+                        auto& batch = instancedShadow.try_emplace(key, frameArena).first->second;
                         batch.key = key;
                         batch.material = material;
                         batch.boundsCenter = meshCenter;
                         batch.boundsSize = meshSize;
+                        batch.vertexAnimationParams = vertexAnimationParams;
                         batch.instances.push_back(data);
                     };
 
@@ -4132,11 +6352,14 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                     key.isTransparent = isTransparent;
                     key.receiveShadows = instanced->getReceiveShadows();
                     key.castShadows = instanced->getCastShadows();
-                    auto& batch = instancedVisible[key];
+                    key.isSkinned = isCrowd;
+                    key.vertexAnimation = vertexAnimation;
+                    auto& batch = instancedVisible.try_emplace(key, frameArena).first->second;
                     batch.key = key;
                     batch.material = material;
                     batch.boundsCenter = meshCenter;
                     batch.boundsSize = meshSize;
+                    batch.vertexAnimationParams = vertexAnimationParams;
                     batch.instances.push_back(data);
                 };
 
@@ -4158,32 +6381,211 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         }
     }
 
-    constexpr bool kEnableAutoStaticMeshInstancing = false;
-    if (kEnableAutoStaticMeshInstancing) {
-        const auto& staticEntities = scene->getAllEntities();
-        for (const auto& entityPtr : staticEntities) {
-            Entity* entity = entityPtr.get();
-            if (!entity || !entity->isActiveInHierarchy()) {
+    // Foliage scatters grow their instances on the GPU (FoliageSystem) into buffers culled like the
+    // resident batches above. The mesh and the billboard quad share a scatter's buffer and split
+    // its instances by camera distance in the cull kernel; without GPU culling there is no split,
+    // so scatters are not drawn.
+    if (m_foliageSystem && m_foliageSystem->isAvailable() && m_instanceCullPipeline && m_instanceIndirectPipeline) {
+        for (const auto& foliageProxy : renderWorld.getFoliageScatters()) {
+            FoliageScatter* scatter = foliageProxy.scatter;
+            MeshRenderer* terrain = foliageProxy.terrain;
+            if (!foliageProxy.entity->isActiveInHierarchy() || !scatter->isEnabled() || !terrain) {
                 continue;
             }
-            if (shouldSkipEntity(entity)) {
+            std::shared_ptr<Mesh> mesh = scatter->getMesh();
+            std::shared_ptr<Mesh> terrainMesh = terrain->getMesh();
+            if (!mesh || !terrainMesh || scatter->getDensity() <= 0.0f) {
                 continue;
             }
-
-            if (auto* instanced = entity->getComponent<InstancedMeshRenderer>()) {
-                if (instanced->isEnabled()) {
-                    continue;
-                }
+            if (!mesh->isUploaded()) {
+                uploadMesh(mesh.get());
             }
 
-            MeshRenderer* mr = entity->getComponent<MeshRenderer>();
-            if (!mr || !mr->isEnabled()) {
+            uint32_t recordCount = 0;
+            MTL::Buffer* records = m_foliageSystem->update(*scatter, *terrainMesh,
+                                                           foliageProxy.entity->getTransform()->getWorldMatrix(),
+                                                           cameraPos, recordCount);
+            if (!records || recordCount == 0) {
                 continue;
             }
 
-            // Built-in editor primitives (Cube/Sphere/Cylinder...) are generated on-the-fly.
-            // Keep them on the regular MeshRenderer path instead of static instancing.
-            if (entity->getComponent<PrimitiveMesh>()) {
+            std::shared_ptr<Material> material = scatter->getMaterial();
+            const bool isTransparent = material && (material->getRenderMode() == Material::RenderMode::Transparent
+                || material->getAlpha() < 0.999f);
+            const float viewDistance = scatter->getViewDistance();
+            const bool billboardRangeValid = material && material->getBillboardEnabled() && billboardMesh
+                && material->getBillboardEnd() > material->getBillboardStart() + 0.01f
+                && material->getBillboardStart() < viewDistance;
+
+            InstanceBatchGPU gpu{};
+            gpu.mesh = mesh.get();
+            gpu.sourceMesh = mesh.get();
+            gpu.material = material;
+            gpu.isTransparent = isTransparent;
+            gpu.receiveShadows = scatter->getReceiveShadows();
+            gpu.castShadows = scatter->getCastShadows();
+            gpu.inputBuffer = records;
+            gpu.inputCount = recordCount;
+            gpu.boundsCenter = mesh->getBoundsCenter();
+            gpu.boundsSize = mesh->getBoundsSize();
+            gpu.lodMaxDistance = billboardRangeValid ? std::min(material->getBillboardEnd(), viewDistance) : viewDistance;
+            cachedInstanceBatches.push_back(gpu);
+            if (billboardRangeValid) {
+                gpu.mesh = billboardMesh.get();
+                gpu.isBillboard = true;
+                gpu.castShadows = false;
+                gpu.lodMinDistance = material->getBillboardStart();
+                gpu.lodMaxDistance = viewDistance;
+                cachedInstanceBatches.push_back(gpu);
+            }
+        }
+    }
+
+    // Terrain renderers draw the shared patch grid per selected quadtree node, displaced from the
+    // terrain's height clipmap (TerrainSystem). Selection runs once for the camera and once per sun
+    // cascade with a coarser floor; cascade patches skip the shadow culling of cached batches and
+    // go straight to their cascade.
+    if (m_terrainSystem && m_terrainSystem->isAvailable() && !renderWorld.getTerrains().empty()) {
+        // View 0 is the camera; the others are the valid cascades, with their index in
+        // getCascades() and their split within their light.
+        FrameVector<TerrainSystem::View> terrainViews(frameArena);
+        FrameVector<int32_t> terrainViewCascades(frameArena);
+        FrameVector<uint32_t> terrainViewSplits(frameArena);
+        terrainViews.push_back(TerrainSystem::View{frustumPlanes, 0});
+        terrainViewCascades.push_back(-1);
+        terrainViewSplits.push_back(0);
+        const size_t cascadeCount = m_lightingSystem ? m_lightingSystem->getCascades().size() : 0;
+        for (size_t i = 0; i < cascadeCount; ++i) {
+            const CascadedSlice& slice = m_lightingSystem->getCascades()[i];
+            if (slice.atlas.valid) {
+                terrainViews.push_back(TerrainSystem::View{Math::ExtractFrustumPlanes(slice.viewProj), 0});
+                terrainViewCascades.push_back(static_cast<int32_t>(i));
+                terrainViewSplits.push_back(slice.cascadeIndex);
+            }
+        }
+        FrameVector<TerrainSystem::Selection> selections(frameArena);
+        selections.resize(terrainViews.size());
+
+        struct TerrainDraw {
+            MeshRenderer* meshRenderer = nullptr;
+            MTL::Texture* heights = nullptr;
+            TerrainParamsGPU params;
+            uint32_t selectionStart = 0;
+        };
+        FrameVector<TerrainDraw> terrainDraws(frameArena);
+        FrameVector<TerrainSystem::Selection> terrainSelections(frameArena);
+        Mesh* patchMesh = m_terrainSystem->getPatchMesh();
+        if (!patchMesh->isUploaded()) {
+            uploadMesh(patchMesh);
+        }
+        for (const auto& terrainProxy : renderWorld.getTerrains()) {
+            TerrainRenderer* terrain = terrainProxy.terrain;
+            MeshRenderer* meshRenderer = terrainProxy.meshRenderer;
+            if (!terrainProxy.entity->isActiveInHierarchy() || !terrain->isEnabled() || !meshRenderer->isEnabled()) {
+                continue;
+            }
+            std::shared_ptr<Mesh> terrainMesh = meshRenderer->getMesh();
+            if (!terrainMesh) {
+                continue;
+            }
+            // Each cascade drops shadowLodBias more of the finest levels than the one before.
+            for (size_t v = 1; v < terrainViews.size(); ++v) {
+                terrainViews[v].minLod = (terrainViewSplits[v] + 1) * terrain->getShadowLodBias();
+            }
+            const size_t viewCount = terrain->getCastShadows() ? terrainViews.size() : 1;
+            const Math::Matrix4x4& world = terrainProxy.entity->getTransform()->getWorldMatrix();
+            TerrainDraw draw;
+            draw.meshRenderer = meshRenderer;
+            if (!m_terrainSystem->update(*terrain, *terrainMesh, world, cameraPos, terrainViews.data(), viewCount,
+                                         selections.data(), draw.params, draw.heights)) {
+                continue;
+            }
+            draw.selectionStart = static_cast<uint32_t>(terrainSelections.size());
+            for (size_t v = 0; v < terrainViews.size(); ++v) {
+                terrainSelections.push_back(v < viewCount ? selections[v] : TerrainSystem::Selection());
+            }
+            terrainDraws.push_back(draw);
+
+            if (m_textureStreamer) {
+                // Splat and layer textures stream like any material's; the terrain is as close as
+                // the camera gets to its bounds.
+                Math::Vector3 boundsMin;
+                Math::Vector3 boundsMax;
+                meshRenderer->getWorldBounds(boundsMin, boundsMax);
+                const Math::Vector3 center = (boundsMin + boundsMax) * 0.5f;
+                const Math::Vector4 sphere(center.x, center.y, center.z, (boundsMax - boundsMin).length() * 0.5f);
+                RequestMaterialTextureResolutions(*m_textureStreamer, meshRenderer, terrainMesh.get(), world, sphere, m_lodView);
+            }
+        }
+
+        MTL::Buffer* patches = terrainDraws.empty() ? nullptr : m_terrainSystem->uploadInstances();
+        for (size_t d = 0; patches && d < terrainDraws.size(); ++d) {
+            const TerrainDraw& draw = terrainDraws[d];
+            std::shared_ptr<Material> material = draw.meshRenderer->getMaterial(0);
+            acquireTerrainVirtualTexture(material.get());
+            const TerrainSystem::Selection& main = terrainSelections[draw.selectionStart];
+            if (main.count > 0) {
+                InstanceBatchGPU gpu{};
+                gpu.mesh = patchMesh;
+                gpu.sourceMesh = patchMesh;
+                gpu.material = material;
+                gpu.isTransparent = material && (material->getRenderMode() == Material::RenderMode::Transparent
+                    || material->getAlpha() < 0.999f);
+                gpu.receiveShadows = draw.meshRenderer->getReceiveShadows();
+                gpu.castShadows = false;
+                gpu.inputBuffer = patches;
+                gpu.inputOffset = main.offset;
+                gpu.inputCount = main.count;
+                gpu.boundsCenter = Math::Vector3(0.0f, 0.5f, 0.0f);
+                gpu.boundsSize = Math::Vector3(1.0f, 1.0f, 1.0f);
+                gpu.terrainHeights = draw.heights;
+                gpu.terrainParams = draw.params;
+                cachedInstanceBatches.push_back(gpu);
+            }
+            for (size_t v = 1; v < terrainViews.size(); ++v) {
+                const TerrainSystem::Selection& selection = terrainSelections[draw.selectionStart + v];
+                if (selection.count == 0) {
+                    continue;
+                }
+                InstancedShadowDraw shadowDraw{};
+                shadowDraw.mesh = patchMesh;
+                shadowDraw.instanceBuffer = patches;
+                shadowDraw.instanceOffset = static_cast<size_t>(selection.offset) * sizeof(InstanceDataGPU);
+                shadowDraw.instanceCount = selection.count;
+                shadowDraw.material = material;
+                shadowDraw.boundsCenter = Math::Vector3(0.0f, 0.5f, 0.0f);
+                shadowDraw.boundsSize = Math::Vector3(1.0f, 1.0f, 1.0f);
+                shadowDraw.terrainHeights = draw.heights;
+                shadowDraw.terrainParams = draw.params;
+                shadowDraw.shadowCascade = terrainViewCascades[v];
+                instancedShadowDraws.push_back(shadowDraw);
+            }
+        }
+    }
+
+    constexpr bool kEnableAutoStaticMeshInstancing = false;
+    if (kEnableAutoStaticMeshInstancing) {
+        for (const auto& proxy : renderWorld.getMeshRenderers()) {
+            Entity* entity = proxy.entity;
+            if (!entity->isActiveInHierarchy()) {
+                continue;
+            }
+            if (shouldSkipEntity(proxy)) {
+                continue;
+            }
+
+            if (proxy.instanced && proxy.instanced->isEnabled()) {
+                continue;
+            }
+
+            MeshRenderer* mr = proxy.meshRenderer;
+            if (!mr->isEnabled()) {
+                continue;
+            }
+
+            // Built-in editor primitives (Cube/Sphere/Cylinder...) are generated on-the-fly.
+            // Keep them on the regular MeshRenderer path instead of static instancing.
+            if (proxy.isPrimitive) {
                 continue;
             }
             std::shared_ptr<Mesh> mesh = mr->getMesh();
@@ -4191,7 +6593,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 continue;
             }
 
-            SkinnedMeshRenderer* skinned = entity->getComponent<SkinnedMeshRenderer>();
+            SkinnedMeshRenderer* skinned = proxy.skinned;
             bool wantsSkin = skinned && skinned->isEnabled() && mesh->hasSkinWeights() && !skinned->getBoneMatrices().empty();
             if (wantsSkin) {
                 continue;
@@ -4226,7 +6628,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 radius = 0.001f;
             }
             radius *= kCullTightness;
-            if (!IsSphereInFrustum(frustumPlanes, worldCenter, radius)) {
+            if (!Math::IsSphereInFrustum(frustumPlanes, worldCenter, radius)) {
                 continue;
             }
 
@@ -4242,7 +6644,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 key.isTransparent = isTransparent;
                 key.receiveShadows = mr->getReceiveShadows();
                 key.castShadows = mr->getCastShadows();
-                auto& batch = instancedVisible[key];
+                auto& batch = instancedVisible.try_emplace(key, frameArena).first->second;
                 batch.key = key;
                 batch.material = material;
                 batch.boundsCenter = meshCenter;
@@ -4258,7 +6660,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 key.isTransparent = isTransparent;
                 key.receiveShadows = mr->getReceiveShadows();
                 key.castShadows = mr->getCastShadows();
-                auto& batch = instancedShadow[key];
+                auto& batch = instancedShadow.try_emplace(key, frameArena).first->second;
                 batch.key = key;
                 batch.material = material;
                 batch.boundsCenter = meshCenter;
@@ -4284,7 +6686,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 }
 
             gpuCulledStatics.insert(entity);
-            gpuCulledStaticIds.insert(entity->getUUID().toString());
+            gpuCulledStaticIndices.push_back(entity->getIndex());
         }
     }
 
@@ -4313,10 +6715,12 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         gpu.boundsCenter = batch.boundsCenter;
         gpu.boundsSize = batch.boundsSize;
         gpu.isBillboard = billboardMesh && batch.key.mesh == billboardMesh.get();
+        gpu.isSkinned = batch.key.isSkinned;
+        gpu.vertexAnimation = batch.key.vertexAnimation;
+        gpu.vertexAnimationParams = batch.vertexAnimationParams;
         totalInputCount += gpu.inputCount;
         instancedBatches.push_back(gpu);
     }
-    m_stats.instanceInput = totalInputCount;
 
     size_t totalInputBytes = totalInputCount * sizeof(InstanceDataGPU);
     if (totalInputBytes > 0) {
@@ -4327,6 +6731,8 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             }
             m_instanceBuffer = m_device->newBuffer(newCapacity, MTL::ResourceStorageModeShared);
             m_instanceBufferCapacity = m_instanceBuffer ? m_instanceBuffer->length() : 0;
+            m_instanceBuffers[bufferSlot] = m_instanceBuffer;
+            m_instanceBufferCapacities[bufferSlot] = m_instanceBufferCapacity;
         }
     }
 
@@ -4342,7 +6748,9 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                     gpu.sourceMesh == batch.key.sourceMesh &&
                     gpu.isTransparent == batch.key.isTransparent &&
                     gpu.receiveShadows == batch.key.receiveShadows &&
-                    gpu.castShadows == batch.key.castShadows) {
+                    gpu.castShadows == batch.key.castShadows &&
+                    gpu.isSkinned == batch.key.isSkinned &&
+                    gpu.vertexAnimation == batch.key.vertexAnimation) {
                     offset = gpu.inputOffset;
                     break;
                 }
@@ -4351,9 +6759,16 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             std::memcpy(static_cast<uint8_t*>(m_instanceBuffer->contents()) + offset * sizeof(InstanceDataGPU),
                         batch.instances.data(),
                         bytes);
+            m_stats.instanceBytesUploaded += bytes;
         }
     }
 
+    // Crowd poses are sampled before any pass draws them; this may also grow the palette buffer.
+    if (m_crowdAnimation) {
+        m_crowdAnimation->dispatch(commandBuffer);
+        m_stats.crowdInstances = static_cast<uint32_t>(m_crowdAnimation->getInstanceCount());
+    }
+
     for (auto& entry : instancedShadow) {
         auto& batch = entry.second;
         if (batch.instances.empty()) {
@@ -4365,7 +6780,9 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 gpu.sourceMesh == batch.key.sourceMesh &&
                 gpu.isTransparent == batch.key.isTransparent &&
                 gpu.receiveShadows == batch.key.receiveShadows &&
-                gpu.castShadows == batch.key.castShadows) {
+                gpu.castShadows == batch.key.castShadows &&
+                gpu.isSkinned == batch.key.isSkinned &&
+                gpu.vertexAnimation == batch.key.vertexAnimation) {
                 offset = gpu.inputOffset;
                 break;
             }
@@ -4379,17 +6796,106 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         draw.boundsCenter = batch.boundsCenter;
         draw.boundsSize = batch.boundsSize;
         draw.isBillboard = billboardMesh && batch.key.mesh == billboardMesh.get();
+        draw.bonePalette = batch.key.isSkinned && m_crowdAnimation ? m_crowdAnimation->getPaletteBuffer() : nullptr;
+        draw.vertexAnimation = batch.key.vertexAnimation ? batch.key.vertexAnimation->getHandle() : nullptr;
+        draw.vertexAnimationParams = batch.vertexAnimationParams;
         instancedShadowDraws.push_back(draw);
     }
 
+    // Cached batches go last, so the lookups above only see batches of the frame's buffer. They
+    // are culled into the same output as the others, after them.
+    uint32_t totalOutputCount = totalInputCount;
+    for (InstanceBatchGPU& gpu : cachedInstanceBatches) {
+        gpu.outputOffset = totalOutputCount;
+        totalOutputCount += gpu.inputCount;
+        instancedBatches.push_back(gpu);
+        if (gpu.castShadows) {
+            InstancedShadowDraw draw{};
+            draw.mesh = gpu.mesh;
+            draw.instanceBuffer = gpu.inputBuffer;
+            draw.instanceCount = gpu.inputCount;
+            draw.material = gpu.material;
+            draw.boundsCenter = gpu.boundsCenter;
+            draw.boundsSize = gpu.boundsSize;
+            draw.vertexAnimation = gpu.vertexAnimation ? gpu.vertexAnimation->getHandle() : nullptr;
+            draw.vertexAnimationParams = gpu.vertexAnimationParams;
+            instancedShadowDraws.push_back(draw);
+        }
+    }
+    m_stats.instanceInput = totalOutputCount;
+    if (m_foliageSystem) {
+        m_foliageSystem->encode(commandBuffer);
+        m_stats.foliageTilesScattered = m_foliageSystem->getTilesScattered();
+        m_stats.foliageTilesResident = static_cast<uint32_t>(m_foliageSystem->getResidentTileCount());
+    }
+    if (m_terrainSystem) {
+        m_terrainSystem->encode(commandBuffer);
+    }
+    if (m_instanceCache) {
+        m_instanceCache->encodeUploads(commandBuffer);
+        m_stats.instanceBytesUploaded += m_instanceCache->getUploadedBytes();
+        m_stats.instancesCached = totalOutputCount - totalInputCount;
+    }
+
+    // Skin every animated mesh once for the frame; the shadow, prepass and main passes
+    // below draw the cached streams through their static pipelines. Meshes missing from the cache
+    // keep skinning in the vertex shaders.
+    if (m_skinningCache && m_skinningCache->isAvailable()) {
+        for (const auto& proxy : renderWorld.getMeshRenderers()) {
+            SkinnedMeshRenderer* skinned = proxy.skinned;
+            if (!skinned || !skinned->isEnabled() || skinned->getBoneMatrices().empty()) {
+                continue;
+            }
+            if (!proxy.entity->isActiveInHierarchy() || shouldSkipEntity(proxy)) {
+                continue;
+            }
+            MeshRenderer* meshRenderer = proxy.meshRenderer;
+            std::shared_ptr<Mesh> mesh = meshRenderer->isEnabled() ? meshRenderer->getMesh() : nullptr;
+            if (!mesh || !mesh->isUploaded() || !mesh->hasSkinWeights()) {
+                continue;
+            }
+            m_skinningCache->add(meshRenderer, *mesh, skinned->getBoneMatrices(), skinned->getPreviousBoneMatrices());
+        }
+        m_skinningCache->dispatch(commandBuffer);
+        m_stats.skinningCacheMeshes = static_cast<uint32_t>(m_skinningCache->getEntryCount());
+    }
+
+    CRESCENT_PROFILE_NEXT(profilePhase, "Renderer::shadows");
     // Render shadow maps first
     if (m_shadowPass && m_lightingSystem) {
-        m_shadowPass->setExtraHiddenEntities(gpuCulledStaticIds);
+        m_shadowPass->setExtraHiddenEntities(gpuCulledStaticIndices, entityIndexCount);
+        m_shadowPass->setSkinningCache(m_skinningCache.get());
+        m_shadowPass->setUniformRing(frameUniforms);
         m_shadowPass->setFrameSlot(bufferSlot);
+        m_shadowPass->setLodSelection(m_lodView, m_lodPixelError);
         m_shadowPass->execute(commandBuffer, scene, camera, *m_lightingSystem, instancedShadowDraws);
+        m_stats.parallelEncoders += static_cast<uint32_t>(m_shadowPass->getParallelEncoderCount());
+        m_stats.shadowViewsCached = static_cast<uint32_t>(m_shadowPass->getCachedViewCount());
+        m_stats.shadowViewsRefreshed = static_cast<uint32_t>(m_shadowPass->getRefreshedViewCount());
+        m_stats.shadowPagesCached = static_cast<uint32_t>(m_shadowPass->getCachedPageCount());
+        m_stats.shadowPagesRendered = static_cast<uint32_t>(m_shadowPass->getRenderedPageCount());
+        m_stats.shadowTilesDowngraded = m_lightingSystem->getShadowAtlas().getDowngradedCount();
+        m_stats.shadowViewsDeferred = m_lightingSystem->getDeferredShadowViewCount();
+        m_stats.shadowViewsRestored = static_cast<uint32_t>(m_shadowPass->getRestoredViewCount());
+        m_lightingSystem->setShadowViewDrawCounts(m_shadowPass->getViewDrawCounts());
+        m_stats.skinningBytesUploaded += m_shadowPass->getSkinningBytesUploaded();
+        for (const auto& [light, draws] : m_shadowPass->getLightDrawCounts()) {
+            if (light && light->getEntity()) {
+                m_stats.shadowLightDraws.push_back({light->getEntity()->getUUID(), draws});
+            }
+        }
+    }
+
+    // The fog volume only needs the shadow atlas and last frame's volume, so it can build on the
+    // async queue from here while the prepass and main pass render; it is joined before fog apply.
+    MTL::CommandBuffer* fogAsyncCommands = nullptr;
+    if (m_asyncCompute && m_qualitySettings.asyncFogVolume && fogEnabled && m_fogVolumePipelineState
+        && m_fogVolumeTexture && m_shadowPass && m_shadowPass->getShadowAtlas()) {
+        fogAsyncCommands = m_asyncCompute->begin(commandBuffer);
+        m_stats.commandBuffers += fogAsyncCommands ? 1 : 0;
     }
 
-    const bool useGpuInstanceCulling = m_instanceCullPipeline && m_instanceIndirectPipeline && totalInputCount > 0;
+    const bool useGpuInstanceCulling = m_instanceCullPipeline && m_instanceIndirectPipeline && totalOutputCount > 0;
     auto resetInstanceCullingBuffers = [&]() {
         if (m_instanceCountBuffer) {
             std::memset(m_instanceCountBuffer->contents(), 0, instancedBatches.size() * sizeof(uint32_t));
@@ -4397,7 +6903,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         if (m_instanceIndirectBuffer) {
             auto* args = static_cast<DrawIndexedIndirectArgs*>(m_instanceIndirectBuffer->contents());
             for (size_t i = 0; i < instancedBatches.size(); ++i) {
-                args[i].indexCount = instancedBatches[i].mesh ? instancedBatches[i].mesh->getIndices().size() : 0;
+                args[i].indexCount = instancedBatches[i].mesh ? instancedBatches[i].mesh->getIndexCount() : 0;
                 args[i].instanceCount = 0;
                 args[i].indexStart = 0;
                 args[i].baseVertex = 0;
@@ -4424,16 +6930,15 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
 
         resetInstanceCullingBuffers();
 
-        MTL::ComputeCommandEncoder* cullEncoder = commandBuffer->computeCommandEncoder();
+        MTL::ComputeCommandEncoder* cullEncoder = m_gpuPassProfiler->computeEncoder(commandBuffer, GPUPass::Culling);
         cullEncoder->setComputePipelineState(cullPipeline);
-        cullEncoder->setBuffer(m_instanceBuffer, 0, 0);
         cullEncoder->setBuffer(m_instanceCullBuffer, 0, 1);
         if (useHzb && m_hzbTexture) {
             cullEncoder->setTexture(m_hzbTexture, 0);
             cullEncoder->setBuffer(m_cameraUniformBuffer, 0, 4);
         }
 
-        const auto frustumPlanes = ExtractFrustumPlanes(viewProjectionNoJitter);
+        const auto frustumPlanes = Math::ExtractFrustumPlanes(viewProjectionNoJitter);
         Math::Vector2 screenSize(
             static_cast<float>(m_depthTexture ? m_depthTexture->width() : renderWidth),
             static_cast<float>(m_depthTexture ? m_depthTexture->height() : renderHeight)
@@ -4456,7 +6961,10 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             params.instanceCount = batch.inputCount;
             params.screenSize = screenSize;
             params.hzbMipCount = hzbMipCount;
+            params.lodMaxDistance = batch.lodMaxDistance;
+            params.lodCamera = Math::Vector4(cameraPos.x, cameraPos.y, cameraPos.z, batch.lodMinDistance);
 
+            cullEncoder->setBuffer(batch.inputBuffer ? batch.inputBuffer : m_instanceBuffer, 0, 0);
             cullEncoder->setBuffer(m_instanceCountBuffer, i * sizeof(uint32_t), 2);
             cullEncoder->setBytes(&params, sizeof(InstanceCullParams), 3);
 
@@ -4468,7 +6976,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         }
         cullEncoder->endEncoding();
 
-        MTL::ComputeCommandEncoder* indirectEncoder = commandBuffer->computeCommandEncoder();
+        MTL::ComputeCommandEncoder* indirectEncoder = m_gpuPassProfiler->computeEncoder(commandBuffer, GPUPass::Culling);
         indirectEncoder->setComputePipelineState(m_instanceIndirectPipeline);
         indirectEncoder->setBuffer(m_instanceCountBuffer, 0, 0);
         indirectEncoder->setBuffer(m_instanceIndirectBuffer, 0, 1);
@@ -4484,7 +6992,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     };
 
     if (useGpuInstanceCulling) {
-        size_t outputBytes = totalInputBytes;
+        size_t outputBytes = static_cast<size_t>(totalOutputCount) * sizeof(InstanceDataGPU);
         if (!m_instanceCullBuffer || m_instanceCullCapacity < outputBytes) {
             size_t newCapacity = std::max(outputBytes, m_instanceCullCapacity > 0 ? m_instanceCullCapacity * 2 : outputBytes);
             if (m_instanceCullBuffer) {
@@ -4530,11 +7038,17 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             draw.material = batch.material;
             draw.isTransparent = batch.isTransparent;
             draw.receiveShadows = batch.receiveShadows;
+            draw.instanceBuffer = batch.inputBuffer ? batch.inputBuffer : m_instanceBuffer;
             draw.instanceOffset = batch.inputOffset * sizeof(InstanceDataGPU);
             draw.instanceCount = batch.inputCount;
             draw.boundsCenter = batch.boundsCenter;
             draw.boundsSize = batch.boundsSize;
             draw.isBillboard = batch.isBillboard;
+            draw.isSkinned = batch.isSkinned;
+            draw.vertexAnimation = batch.vertexAnimation;
+            draw.vertexAnimationParams = batch.vertexAnimationParams;
+            draw.terrainHeights = batch.terrainHeights;
+            draw.terrainParams = batch.terrainParams;
             instancedDraws.push_back(draw);
         }
     }
@@ -4546,11 +7060,8 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         lightData->direction = Math::Vector4(dir.x, dir.y, dir.z, mainLight->getIntensity());
         Math::Vector3 col = mainLight->getColor();
         if (m_environmentSettings.autoSunColor) {
-            Math::Vector3 sunDir = Math::Vector3(-dir.x, -dir.y, -dir.z);
-            float sunHeight = std::max(0.0f, std::min(1.0f, sunDir.y * 0.5f + 0.5f));
-            Math::Vector3 sunWarm(1.0f, 0.55f, 0.35f);
-            Math::Vector3 sunCool(1.0f, 0.95f, 0.9f);
-            Math::Vector3 tint = sunWarm * (1.0f - sunHeight) + sunCool * sunHeight;
+            // Tinted by the procedural sky's atmosphere, so the light matches the sun disc and sky.
+            Math::Vector3 tint = SkyAtmosphere::SunTransmittance(Math::Vector3(-dir.x, -dir.y, -dir.z));
             col = Math::Vector3(col.x * tint.x, col.y * tint.y, col.z * tint.z);
         }
         lightData->color = Math::Vector4(col.x, col.y, col.z, 0.0f);
@@ -4559,40 +7070,133 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         lightData->color = Math::Vector4(1.0f, 1.0f, 1.0f, 0.0f);
     }
     
-    bool runPrepass = m_prepassPipelineState && m_normalTexture && m_depthTexture;
+    bool runPrepass = m_prepassPipelineState && m_normalTexture && m_velocityTexture && m_depthTexture;
+    // Motion vectors come out of the prepass itself: moving meshes write their motion beyond the
+    // camera's as a second target, and a full-screen pass then adds the camera's from depth.
+    bool runVelocity = (motionBlurEnabled || taaEnabled || metalFXEnabled)
+        && runPrepass && m_prepassPipelineMotion && m_velocityReconstructPipeline;
+    const Math::Matrix4x4 prevViewProjectionNoJitter = m_motionHistoryValid ? m_prevViewProjectionNoJitter : viewProjectionNoJitter;
+    const bool encodeStaticPrepass = useStaticScene && runPrepass && m_prepassPipelineInstanced;
+    const Math::Vector2 cullScreenSize(
+        static_cast<float>(m_depthTexture ? m_depthTexture->width() : renderWidth),
+        static_cast<float>(m_depthTexture ? m_depthTexture->height() : renderHeight)
+    );
+    if (useStaticScene) {
+        dispatchStaticSceneCulling(commandBuffer, bufferSlot, frustumPlanes, cullScreenSize, false, encodeStaticPrepass);
+    }
+
+    CRESCENT_PROFILE_NEXT(profilePhase, "Renderer::prepass");
+    // Occlusion candidates are every proxy the passes below may draw, then every decal. Entities
+    // the latest finished frame found occluded are left out of the first prepass phase; their
+    // draws are deferred to indirect args the HZB test fills in.
+    const auto& occlusionProxies = renderWorld.getMeshRenderers();
+    const auto& decalProxies = renderWorld.getDecals();
+    const bool useOcclusion = runPrepass && m_occlusionCullPipeline && m_occlusionArgsPipeline && m_hzbTexture
+        && m_hzbInitPipeline && m_hzbDownsamplePipeline && !m_hzbMipViews.empty()
+        && beginOcclusionFrame(bufferSlot, occlusionProxies.size() + decalProxies.size(),
+                               occlusionProxies.size() * 4 + decalProxies.size());
+    MTL::Buffer* occlusionArgs = useOcclusion ? m_occlusionFrames[bufferSlot].args : nullptr;
+    if (useOcclusion) {
+        OcclusionFrame& occlusion = m_occlusionFrames[bufferSlot];
+        auto* spheres = static_cast<Math::Vector4*>(occlusion.spheres->contents());
+        for (size_t proxyIndex = 0; proxyIndex < occlusionProxies.size(); ++proxyIndex) {
+            const auto& proxy = occlusionProxies[proxyIndex];
+            if (!meshInFrustum[proxyIndex] || !proxy.entity->isActiveInHierarchy() || shouldSkipEntity(proxy)
+                || gpuCulledStatics.find(proxy.entity) != gpuCulledStatics.end() || isStaticSceneProxy(proxyIndex)
+                || !proxy.meshRenderer->isEnabled() || !proxy.meshRenderer->getMesh()) {
+                continue;
+            }
+            spheres[proxyIndex] = meshSpheres[proxyIndex];
+            occlusion.entityIds[proxyIndex] = proxy.entity->getUUID();
+        }
+        for (size_t decalIndex = 0; decalIndex < decalProxies.size(); ++decalIndex) {
+            const auto& decalProxy = decalProxies[decalIndex];
+            if (!decalProxy.entity->isActiveInHierarchy() || !decalProxy.decal->isEnabled()) {
+                continue;
+            }
+            const Math::Vector4 sphere = DecalWorldSphere(decalProxy.entity->getTransform()->getWorldMatrix());
+            if (Math::IsSphereInFrustum(frustumPlanes, Math::Vector3(sphere.x, sphere.y, sphere.z), sphere.w)) {
+                spheres[occlusionProxies.size() + decalIndex] = sphere;
+            }
+        }
+    }
+    auto isOccludedLastFrame = [&](Entity* entity) {
+        return useOcclusion && m_occludedEntities.find(entity->getUUID()) != m_occludedEntities.end();
+    };
+
+    // Feed animation LOD from the game view: each skinned mesh's bounding radius in pixels, 0 when
+    // frustum culled or occluded last frame.
+    if (options.updateHistory && options.driveAnimationLod) {
+        const auto& meshProxies = renderWorld.getMeshRenderers();
+        for (size_t proxyIndex = 0; proxyIndex < meshProxies.size(); ++proxyIndex) {
+            SkinnedMeshRenderer* skinned = meshProxies[proxyIndex].skinned;
+            if (!skinned) {
+                continue;
+            }
+            float pixels = 0.0f;
+            if (meshInFrustum[proxyIndex] && !isOccludedLastFrame(meshProxies[proxyIndex].entity)) {
+                const Math::Vector4& sphere = meshSpheres[proxyIndex];
+                const float distance = (Math::Vector3(sphere.x, sphere.y, sphere.z) - camPos).length();
+                pixels = sphere.w * m_lodView.w / std::max(distance, std::max(sphere.w, 1e-3f));
+            }
+            skinned->reportScreenCoverage(pixels);
+        }
+    }
+
+    // Gives each draw appended from `first` on its own args slot.
+    auto deferToOcclusionTest = [&](FrameVector<PassDraw>& draws, size_t first, size_t proxyIndex) {
+        for (size_t i = first; i < draws.size(); ++i) {
+            draws[i].occlusionArg = appendOcclusionArg(bufferSlot, static_cast<uint32_t>(proxyIndex),
+                                                       draws[i].mesh->getLodIndexCount(draws[i].lod));
+        }
+    };
+    // Whether the HZB already holds this frame's complete prepass depth.
+    bool hzbCurrent = false;
+    // Pipeline, cull mode and material binds of the sorted MeshRenderer draws, summed over the
+    // encode ranges, which may run on job workers.
+    std::atomic<uint32_t> stateBinds{0};
+    std::atomic<uint32_t> stateBindsSkipped{0};
+
     if (runPrepass) {
         MTL::RenderPassDescriptor* prepass = MTL::RenderPassDescriptor::alloc()->init();
         prepass->colorAttachments()->object(0)->setTexture(m_normalTexture);
         prepass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
         prepass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
         prepass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.5, 0.5, 1.0, 1.0));
+        prepass->colorAttachments()->object(1)->setTexture(m_velocityTexture);
+        prepass->colorAttachments()->object(1)->setLoadAction(runVelocity ? MTL::LoadActionClear : MTL::LoadActionDontCare);
+        prepass->colorAttachments()->object(1)->setStoreAction(runVelocity ? MTL::StoreActionStore : MTL::StoreActionDontCare);
+        prepass->colorAttachments()->object(1)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 0.0));
         prepass->depthAttachment()->setTexture(m_depthTexture);
         prepass->depthAttachment()->setLoadAction(MTL::LoadActionClear);
         prepass->depthAttachment()->setStoreAction(MTL::StoreActionStore);
         prepass->depthAttachment()->setClearDepth(1.0);
         
-        MTL::RenderCommandEncoder* preEncoder = commandBuffer->renderCommandEncoder(prepass);
-        preEncoder->setDepthStencilState(m_depthStencilState);
-        preEncoder->setFrontFacingWinding(MTL::WindingCounterClockwise);
-        preEncoder->setCullMode(MTL::CullModeBack);
-        preEncoder->setViewport(viewport);
-        preEncoder->setVertexBuffer(m_cameraUniformBuffer, 0, 2);
-        
-        const auto& preEntities = scene->getAllEntities();
-        for (const auto& entityPtr : preEntities) {
-            Entity* entity = entityPtr.get();
+        // Gather the visible opaque draws first; everything that allocates or mutates renderer
+        // state happens here so the encode below can be split across workers.
+        FrameVector<PassDraw> prepassDraws(frameArena);
+        FrameVector<PassDraw> prepassLateDraws(frameArena);
+        prepassDraws.reserve(renderWorld.getMeshRenderers().size());
+        size_t prepassSkinningBytes = 0;
+        const auto& prepassProxies = renderWorld.getMeshRenderers();
+        for (size_t proxyIndex = 0; proxyIndex < prepassProxies.size(); ++proxyIndex) {
+            const auto& proxy = prepassProxies[proxyIndex];
+            Entity* entity = proxy.entity;
             if (!entity->isActiveInHierarchy()) {
                 continue;
             }
-            if (shouldSkipEntity(entity)) {
+            if (shouldSkipEntity(proxy)) {
                 continue;
             }
             if (gpuCulledStatics.find(entity) != gpuCulledStatics.end()) {
                 continue;
             }
+            if (isStaticSceneProxy(proxyIndex)) {
+                continue;
+            }
 
-            MeshRenderer* meshRenderer = entity->getComponent<MeshRenderer>();
-            if (!meshRenderer || !meshRenderer->isEnabled()) {
+            MeshRenderer* meshRenderer = proxy.meshRenderer;
+            if (!meshRenderer->isEnabled()) {
                 continue;
             }
             
@@ -4601,17 +7205,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 continue;
             }
 
-            Math::Vector3 boundsCenter;
-            Math::Vector3 boundsSize;
-            ResolveRendererBounds(entity, meshRenderer, boundsCenter, boundsSize);
-            float radius = 0.5f * std::sqrt(boundsSize.x * boundsSize.x
-                                            + boundsSize.y * boundsSize.y
-                                            + boundsSize.z * boundsSize.z);
-            if (radius <= 0.0f) {
-                radius = 0.001f;
-            }
-            radius *= kCullTightness;
-            if (!IsSphereInFrustum(frustumPlanes, boundsCenter, radius)) {
+            if (!meshInFrustum[proxyIndex]) {
                 continue;
             }
 
@@ -4631,38 +7225,131 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 continue;
             }
             
-            SkinnedMeshRenderer* skinned = entity->getComponent<SkinnedMeshRenderer>();
+            SkinnedMeshRenderer* skinned = proxy.skinned;
             bool wantsSkin = skinned && skinned->isEnabled() && mesh->hasSkinWeights() && !skinned->getBoneMatrices().empty();
             bool isSkinned = wantsSkin && (skinBuffer != nullptr);
-            MTL::RenderPipelineState* pipeline = isSkinned ? m_prepassPipelineSkinned : m_prepassPipelineState;
+            const SkinningCache::Entry* skinCache = (isSkinned && m_skinningCache)
+                ? m_skinningCache->find(meshRenderer)
+                : nullptr;
+            if (skinCache) {
+                isSkinned = false;
+            }
+            // Static meshes leave their motion to the reconstruction; anything animated or moved
+            // since last frame writes its own.
+            const Math::Matrix4x4 prevModelMatrix = entity->getTransform()->getPreviousWorldMatrix();
+            const Math::Matrix4x4 modelMatrix = entity->getTransform()->getWorldMatrix();
+            const bool moving = isSkinned || skinCache
+                || std::memcmp(&prevModelMatrix, &modelMatrix, sizeof(Math::Matrix4x4)) != 0;
+            MTL::RenderPipelineState* motionPipeline = nullptr;
+            if (runVelocity && moving) {
+                motionPipeline = skinCache ? m_prepassPipelineMotionCached
+                    : (isSkinned ? m_prepassPipelineMotionSkinned : m_prepassPipelineMotion);
+            }
+            MTL::RenderPipelineState* pipeline = motionPipeline
+                ? motionPipeline
+                : (isSkinned ? m_prepassPipelineSkinned : m_prepassPipelineState);
             if (!pipeline) {
                 continue;
             }
             
-            preEncoder->setRenderPipelineState(pipeline);
+            PassDraw draw;
+            draw.entity = entity;
+            draw.meshRenderer = meshRenderer;
+            draw.mesh = mesh.get();
+            draw.material = std::move(material);
+            draw.pipeline = pipeline;
+            draw.vertexBuffer = vertexBuffer;
+            draw.indexBuffer = indexBuffer;
+            draw.skinBuffer = skinBuffer;
+            draw.isSkinned = isSkinned;
+            draw.skinCache = skinCache;
+            draw.modelMatrix = modelMatrix;
+            draw.prevModelMatrix = prevModelMatrix;
+            draw.writesMotion = motionPipeline != nullptr;
+            if (isSkinned) {
+                draw.boneMatrices = &skinned->getBoneMatrices();
+                if (draw.writesMotion) {
+                    const auto& prevBones = skinned->getPreviousBoneMatrices();
+                    draw.prevBoneMatrices = prevBones.size() == draw.boneMatrices->size() ? &prevBones : draw.boneMatrices;
+                }
+                draw.skinningOffset = prepassSkinningBytes;
+                prepassSkinningBytes += DrawSkinningBytes(draw);
+            }
+            const bool deferred = isOccludedLastFrame(entity);
+            FrameVector<PassDraw>& target = deferred ? prepassLateDraws : prepassDraws;
+            const size_t firstDraw = target.size();
+            AppendLodDraws(target, std::move(draw), m_lodView, m_lodPixelError, prepassSkinningBytes);
+            if (deferred) {
+                deferToOcclusionTest(target, firstDraw, proxyIndex);
+            }
+        }
+
+        SortPassDraws(prepassDraws, cameraPos, frameArena);
+        SortPassDraws(prepassLateDraws, cameraPos, frameArena);
+        PassSkinningBlock prepassSkinning = reserveSkinningBlock(prepassSkinningBytes);
+
+        auto setupPrepassEncoder = [&](MTL::RenderCommandEncoder* enc) {
+            enc->setDepthStencilState(m_depthStencilState);
+            enc->setFrontFacingWinding(MTL::WindingCounterClockwise);
+            enc->setCullMode(MTL::CullModeBack);
+            enc->setViewport(viewport);
+            enc->setVertexBuffer(m_cameraUniformBuffer, 0, 2);
+        };
+
+        auto encodePrepassDraw = [&](MTL::RenderCommandEncoder* preEncoder, const PassDraw& draw, PassEncodeState& state) {
+            Mesh* mesh = draw.mesh;
+            MeshRenderer* meshRenderer = draw.meshRenderer;
+            const std::shared_ptr<Material>& material = draw.material;
+            MTL::RenderPipelineState* pipeline = draw.pipeline;
+            MTL::Buffer* vertexBuffer = draw.vertexBuffer;
+            MTL::Buffer* indexBuffer = draw.indexBuffer;
+            MTL::Buffer* skinBuffer = draw.skinBuffer;
+            bool isSkinned = draw.isSkinned;
+
+            state.setPipeline(preEncoder, pipeline);
             
             ModelUniforms modelUniforms;
-            modelUniforms.modelMatrix = entity->getTransform()->getWorldMatrix();
+            modelUniforms.modelMatrix = draw.modelMatrix;
             modelUniforms.normalMatrix = modelUniforms.modelMatrix.normalMatrix();
+            modelUniforms.normalMatrix(0, 3) = draw.lodDither;
             
-            preEncoder->setVertexBuffer(vertexBuffer, 0, 0);
+            if (draw.skinCache) {
+                SkinningCache::BindVertexStreams(preEncoder, *draw.skinCache);
+                state.work.bufferBinds += 2;
+            } else {
+                state.setVertexBuffer(preEncoder, vertexBuffer, mesh->getVertexBufferOffset(), 0);
+                state.setVertexBuffer(preEncoder, static_cast<MTL::Buffer*>(mesh->getAttributeBuffer()), mesh->getAttributeBufferOffset(),
+                                      GeometryBuffer::kAttributeBufferIndex);
+            }
             if (isSkinned) {
-                preEncoder->setVertexBuffer(skinBuffer, 0, 4);
+                state.setVertexBuffer(preEncoder, skinBuffer, mesh->getSkinWeightBufferOffset(), 4);
             }
-            preEncoder->setVertexBytes(&modelUniforms, sizeof(ModelUniforms), 1);
-            preEncoder->setVertexBuffer(m_cameraUniformBuffer, 0, 2);
+            state.setVertexBytes(preEncoder, &modelUniforms, sizeof(ModelUniforms), 1);
+            state.setVertexBuffer(preEncoder, m_cameraUniformBuffer, 0, 2);
             
-            if (isSkinned && skinned) {
-                const auto& boneMatrices = skinned->getBoneMatrices();
-                if (!boneMatrices.empty()) {
-                    size_t bytes = boneMatrices.size() * sizeof(Math::Matrix4x4);
-                    size_t bufferOffset = 0;
-                    if (allocateSkinningSlice(m_skinningBuffer, m_skinningBufferCapacity, skinningOffset, bytes, bufferOffset)) {
-                        std::memcpy(static_cast<uint8_t*>(m_skinningBuffer->contents()) + bufferOffset,
-                                    boneMatrices.data(),
-                                    bytes);
-                        preEncoder->setVertexBuffer(m_skinningBuffer, bufferOffset, 3);
-                    }
+            if (isSkinned && draw.boneMatrices && prepassSkinning.buffer) {
+                const size_t paletteBytes = draw.boneMatrices->size() * sizeof(Math::Matrix4x4);
+                size_t bufferOffset = prepassSkinning.base + draw.skinningOffset;
+                std::memcpy(static_cast<uint8_t*>(prepassSkinning.buffer->contents()) + bufferOffset,
+                            draw.boneMatrices->data(),
+                            paletteBytes);
+                state.setVertexBuffer(preEncoder, prepassSkinning.buffer, bufferOffset, 3);
+                if (draw.prevBoneMatrices) {
+                    const size_t prevOffset = bufferOffset + AlignSkinningBytes(paletteBytes);
+                    std::memcpy(static_cast<uint8_t*>(prepassSkinning.buffer->contents()) + prevOffset,
+                                draw.prevBoneMatrices->data(),
+                                paletteBytes);
+                    state.setVertexBuffer(preEncoder, prepassSkinning.buffer, prevOffset, 6);
+                }
+            }
+            if (draw.writesMotion) {
+                VelocityUniformsGPU velocityUniforms{};
+                velocityUniforms.prevModelMatrix = draw.prevModelMatrix;
+                velocityUniforms.prevViewProjection = prevViewProjectionNoJitter;
+                state.setVertexBytes(preEncoder, &velocityUniforms, sizeof(VelocityUniformsGPU), 5);
+                if (draw.skinCache) {
+                    state.setVertexBuffer(preEncoder, draw.skinCache->buffer, draw.skinCache->previousPositionOffset,
+                                          SkinningCache::kPreviousPositionBufferIndex);
                 }
             }
 
@@ -4714,11 +7401,13 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 );
                 bool alphaClip = material->getRenderMode() == Material::RenderMode::Cutout;
                 float alphaCutoff = material->getAlphaCutoff();
+                const auto& normalMapTex = material->getNormalTexture();
+                bool normalLengthInAlpha = normalMapTex && normalMapTex->hasNormalLengthInAlpha();
                 matUniforms.textureFlags3 = Math::Vector4(
                     hasORMTex ? 1.0f : 0.0f,
                     alphaClip ? 1.0f : 0.0f,
                     alphaCutoff,
-                    0.0f
+                    normalLengthInAlpha ? 1.0f : 0.0f
                 );
                 matUniforms.heightParams = Math::Vector4(
                     material->getHeightScale(),
@@ -4800,7 +7489,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 matUniforms.terrainFlags = Math::Vector4(0.0f);
             }
 
-            preEncoder->setFragmentBytes(&matUniforms, sizeof(MaterialUniformsGPU), 0);
+            state.setFragmentBytes(preEncoder, &matUniforms, sizeof(MaterialUniformsGPU), 0);
             if (!isSkinned) {
                 MeshUniformsGPU meshUniforms{};
                 Math::Vector3 boundsCenter = mesh->getBoundsCenter();
@@ -4809,42 +7498,51 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 meshUniforms.boundsSize = Math::Vector4(boundsSize.x, boundsSize.y, boundsSize.z, 0.0f);
                 meshUniforms.flags = Math::Vector4(0.0f);
                 meshUniforms.lightmapScaleOffset = Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
-                preEncoder->setVertexBytes(&matUniforms, sizeof(MaterialUniformsGPU), 3);
-                preEncoder->setVertexBytes(&meshUniforms, sizeof(MeshUniformsGPU), 4);
-            }
-            auto albedoTex = (material && material->getAlbedoTexture()) ? material->getAlbedoTexture() : m_defaultWhiteTexture;
-            auto roughnessTex = (material && material->getRoughnessTexture()) ? material->getRoughnessTexture() : m_defaultWhiteTexture;
-            auto ormTex = (material && material->getORMTexture()) ? material->getORMTexture() : m_defaultBlackTexture;
-            auto terrainControlTex = (material && material->getTerrainControlTexture()) ? material->getTerrainControlTexture() : m_defaultWhiteTexture;
-            auto terrainLayer0Tex = (material && material->getTerrainLayer0Texture()) ? material->getTerrainLayer0Texture() : albedoTex;
-            auto terrainLayer1Tex = (material && material->getTerrainLayer1Texture()) ? material->getTerrainLayer1Texture() : albedoTex;
-            auto terrainLayer2Tex = (material && material->getTerrainLayer2Texture()) ? material->getTerrainLayer2Texture() : albedoTex;
-            auto terrainLayer0OrmTex = (material && material->getTerrainLayer0ORMTexture()) ? material->getTerrainLayer0ORMTexture() : m_defaultWhiteTexture;
-            auto terrainLayer1OrmTex = (material && material->getTerrainLayer1ORMTexture()) ? material->getTerrainLayer1ORMTexture() : m_defaultWhiteTexture;
-            auto terrainLayer2OrmTex = (material && material->getTerrainLayer2ORMTexture()) ? material->getTerrainLayer2ORMTexture() : m_defaultWhiteTexture;
-            preEncoder->setFragmentTexture(albedoTex ? albedoTex->getHandle() : nullptr, 2);
-            preEncoder->setFragmentTexture(roughnessTex ? roughnessTex->getHandle() : nullptr, 0);
-            preEncoder->setFragmentTexture(ormTex ? ormTex->getHandle() : nullptr, 1);
-            preEncoder->setFragmentTexture(terrainControlTex ? terrainControlTex->getHandle() : nullptr, 3);
-            preEncoder->setFragmentTexture(terrainLayer0Tex ? terrainLayer0Tex->getHandle() : nullptr, 4);
-            preEncoder->setFragmentTexture(terrainLayer1Tex ? terrainLayer1Tex->getHandle() : nullptr, 5);
-            preEncoder->setFragmentTexture(terrainLayer2Tex ? terrainLayer2Tex->getHandle() : nullptr, 6);
-            preEncoder->setFragmentTexture(terrainLayer0OrmTex ? terrainLayer0OrmTex->getHandle() : nullptr, 7);
-            preEncoder->setFragmentTexture(terrainLayer1OrmTex ? terrainLayer1OrmTex->getHandle() : nullptr, 8);
-            preEncoder->setFragmentTexture(terrainLayer2OrmTex ? terrainLayer2OrmTex->getHandle() : nullptr, 9);
-            if (m_samplerState) {
-                preEncoder->setFragmentSamplerState(m_samplerState, 0);
-            }
-            preEncoder->setCullMode(resolveCullMode(material.get()));
+                state.setVertexBytes(preEncoder, &matUniforms, sizeof(MaterialUniformsGPU), 3);
+                state.setVertexBytes(preEncoder, &meshUniforms, sizeof(MeshUniformsGPU), 4);
+            }
+            if (state.needsTextures(material.get())) {
+                state.work.textureBinds += bindPrepassMaterialTextures(preEncoder, material.get());
+            }
+            state.setCullMode(preEncoder, ResolveCullMode(material.get()));
             
-            preEncoder->drawIndexedPrimitives(
-                MTL::PrimitiveTypeTriangle,
-                mesh->getIndices().size(),
-                MTL::IndexTypeUInt32,
-                indexBuffer,
-                0
-            );
-        }
+            ++state.work.draws;
+            if (draw.occlusionArg != kNoOcclusionArg) {
+                preEncoder->drawIndexedPrimitives(
+                    MTL::PrimitiveTypeTriangle,
+                    MTL::IndexTypeUInt32,
+                    indexBuffer,
+                    mesh->getLodIndexBufferOffset(draw.lod),
+                    occlusionArgs,
+                    draw.occlusionArg * sizeof(DrawIndexedIndirectArgs)
+                );
+            } else {
+                preEncoder->drawIndexedPrimitives(
+                    MTL::PrimitiveTypeTriangle,
+                    mesh->getLodIndexCount(draw.lod),
+                    MTL::IndexTypeUInt32,
+                    indexBuffer,
+                    mesh->getLodIndexBufferOffset(draw.lod)
+                );
+            }
+        };
+
+        m_gpuPassProfiler->attach(prepass, GPUPass::Prepass);
+        ParallelPassEncoder prepassEncoder(commandBuffer, prepass, prepassDraws.size(), setupPrepassEncoder);
+        m_gpuPassProfiler->detach(prepass);
+        prepassEncoder.encodeRange(prepassDraws.size(), [&](MTL::RenderCommandEncoder* enc, size_t begin, size_t end) {
+            PassEncodeState state;
+            state.uniforms = UniformRing::Binder(frameUniforms);
+            for (size_t i = begin; i < end; ++i) {
+                encodePrepassDraw(enc, prepassDraws[i], state);
+            }
+            m_gpuPassProfiler->recordWork(GPUPass::Prepass, state.work);
+            stateBinds.fetch_add(state.binds, std::memory_order_relaxed);
+            stateBindsSkipped.fetch_add(state.skipped, std::memory_order_relaxed);
+        });
+        m_stats.parallelEncoders += static_cast<uint32_t>(prepassEncoder.parallelEncoderCount());
+
+        MTL::RenderCommandEncoder* preEncoder = prepassEncoder.encoder();
 
         if (m_prepassPipelineInstanced) {
             if (useGpuInstanceCulling && m_instanceCullBuffer && m_instanceIndirectBuffer) {
@@ -4860,8 +7558,21 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                         continue;
                     }
 
-                    preEncoder->setRenderPipelineState(m_prepassPipelineInstanced);
-                    preEncoder->setVertexBuffer(vertexBuffer, 0, 0);
+                    MTL::Buffer* crowdWeights = (batch.isSkinned && m_prepassPipelineInstancedSkinned)
+                        ? static_cast<MTL::Buffer*>(batch.mesh->getSkinWeightBuffer()) : nullptr;
+                    Texture2D* vertexAnimation = m_prepassPipelineInstancedVat ? batch.vertexAnimation : nullptr;
+                    if (batch.terrainHeights) {
+                        if (!m_prepassPipelineInstancedTerrain) {
+                            continue;
+                        }
+                        preEncoder->setRenderPipelineState(m_prepassPipelineInstancedTerrain);
+                    } else {
+                        preEncoder->setRenderPipelineState(crowdWeights ? m_prepassPipelineInstancedSkinned
+                            : (vertexAnimation ? m_prepassPipelineInstancedVat : m_prepassPipelineInstanced));
+                    }
+                    preEncoder->setVertexBuffer(vertexBuffer, batch.mesh->getVertexBufferOffset(), 0);
+                    preEncoder->setVertexBuffer(static_cast<MTL::Buffer*>(batch.mesh->getAttributeBuffer()), batch.mesh->getAttributeBufferOffset(),
+                                                GeometryBuffer::kAttributeBufferIndex);
                     preEncoder->setVertexBuffer(m_instanceCullBuffer, batch.outputOffset * sizeof(InstanceDataGPU), 1);
                     preEncoder->setVertexBuffer(m_cameraUniformBuffer, 0, 2);
 
@@ -4913,11 +7624,13 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                         );
                         bool alphaClip = batch.material->getRenderMode() == Material::RenderMode::Cutout;
                         float alphaCutoff = batch.material->getAlphaCutoff();
+                        const auto& normalMapTex = batch.material->getNormalTexture();
+                        bool normalLengthInAlpha = normalMapTex && normalMapTex->hasNormalLengthInAlpha();
                         matUniforms.textureFlags3 = Math::Vector4(
                             hasORMTex ? 1.0f : 0.0f,
                             alphaClip ? 1.0f : 0.0f,
                             alphaCutoff,
-                            0.0f
+                            normalLengthInAlpha ? 1.0f : 0.0f
                         );
                         matUniforms.heightParams = Math::Vector4(
                             batch.material->getHeightScale(),
@@ -5007,6 +7720,16 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                     meshUniforms.lightmapScaleOffset = Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
                     preEncoder->setVertexBytes(&matUniforms, sizeof(MaterialUniformsGPU), 3);
                     preEncoder->setVertexBytes(&meshUniforms, sizeof(MeshUniformsGPU), 4);
+                    if (crowdWeights) {
+                        preEncoder->setVertexBuffer(crowdWeights, batch.mesh->getSkinWeightBufferOffset(), GeometryBuffer::kSkinWeightBufferIndex);
+                        preEncoder->setVertexBuffer(m_crowdAnimation->getPaletteBuffer(), 0, 3);
+                    } else if (vertexAnimation) {
+                        preEncoder->setVertexBytes(&batch.vertexAnimationParams, sizeof(VertexAnimationParamsGPU), 5);
+                        preEncoder->setVertexTexture(vertexAnimation->getHandle(), 0);
+                    } else if (batch.terrainHeights) {
+                        preEncoder->setVertexBytes(&batch.terrainParams, sizeof(TerrainParamsGPU), 5);
+                        preEncoder->setVertexTexture(batch.terrainHeights, 0);
+                    }
                     auto albedoTex = (batch.material && batch.material->getAlbedoTexture()) ? batch.material->getAlbedoTexture() : m_defaultWhiteTexture;
                     auto roughnessTex = (batch.material && batch.material->getRoughnessTexture()) ? batch.material->getRoughnessTexture() : m_defaultWhiteTexture;
                     auto ormTex = (batch.material && batch.material->getORMTexture()) ? batch.material->getORMTexture() : m_defaultBlackTexture;
@@ -5030,20 +7753,20 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                     if (m_samplerState) {
                         preEncoder->setFragmentSamplerState(m_samplerState, 0);
                     }
-                    preEncoder->setCullMode(resolveCullMode(batch.material.get()));
+                    preEncoder->setCullMode(ResolveCullMode(batch.material.get()));
 
                     preEncoder->drawIndexedPrimitives(
                         MTL::PrimitiveTypeTriangle,
                         MTL::IndexTypeUInt32,
                         indexBuffer,
-                        0,
+                        batch.mesh->getIndexBufferOffset(),
                         m_instanceIndirectBuffer,
                         i * sizeof(DrawIndexedIndirectArgs)
                     );
                 }
-            } else if (m_instanceBuffer) {
+            } else {
                 for (const auto& draw : instancedDraws) {
-                    if (!draw.mesh || draw.instanceCount == 0 || draw.isTransparent) {
+                    if (!draw.mesh || draw.instanceCount == 0 || draw.isTransparent || !draw.instanceBuffer) {
                         continue;
                     }
 
@@ -5053,9 +7776,22 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                         continue;
                     }
 
-                    preEncoder->setRenderPipelineState(m_prepassPipelineInstanced);
-                    preEncoder->setVertexBuffer(vertexBuffer, 0, 0);
-                    preEncoder->setVertexBuffer(m_instanceBuffer, draw.instanceOffset, 1);
+                    MTL::Buffer* crowdWeights = (draw.isSkinned && m_prepassPipelineInstancedSkinned)
+                        ? static_cast<MTL::Buffer*>(draw.mesh->getSkinWeightBuffer()) : nullptr;
+                    Texture2D* vertexAnimation = m_prepassPipelineInstancedVat ? draw.vertexAnimation : nullptr;
+                    if (draw.terrainHeights) {
+                        if (!m_prepassPipelineInstancedTerrain) {
+                            continue;
+                        }
+                        preEncoder->setRenderPipelineState(m_prepassPipelineInstancedTerrain);
+                    } else {
+                        preEncoder->setRenderPipelineState(crowdWeights ? m_prepassPipelineInstancedSkinned
+                            : (vertexAnimation ? m_prepassPipelineInstancedVat : m_prepassPipelineInstanced));
+                    }
+                    preEncoder->setVertexBuffer(vertexBuffer, draw.mesh->getVertexBufferOffset(), 0);
+                    preEncoder->setVertexBuffer(static_cast<MTL::Buffer*>(draw.mesh->getAttributeBuffer()), draw.mesh->getAttributeBufferOffset(),
+                                                GeometryBuffer::kAttributeBufferIndex);
+                    preEncoder->setVertexBuffer(draw.instanceBuffer, draw.instanceOffset, 1);
                     preEncoder->setVertexBuffer(m_cameraUniformBuffer, 0, 2);
 
                     MaterialUniformsGPU matUniforms{};
@@ -5106,11 +7842,13 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                         );
                         bool alphaClip = draw.material->getRenderMode() == Material::RenderMode::Cutout;
                         float alphaCutoff = draw.material->getAlphaCutoff();
+                        const auto& normalMapTex = draw.material->getNormalTexture();
+                        bool normalLengthInAlpha = normalMapTex && normalMapTex->hasNormalLengthInAlpha();
                         matUniforms.textureFlags3 = Math::Vector4(
                             hasORMTex ? 1.0f : 0.0f,
                             alphaClip ? 1.0f : 0.0f,
                             alphaCutoff,
-                            0.0f
+                            normalLengthInAlpha ? 1.0f : 0.0f
                         );
                         matUniforms.heightParams = Math::Vector4(
                             draw.material->getHeightScale(),
@@ -5200,6 +7938,16 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                     meshUniforms.lightmapScaleOffset = Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
                     preEncoder->setVertexBytes(&matUniforms, sizeof(MaterialUniformsGPU), 3);
                     preEncoder->setVertexBytes(&meshUniforms, sizeof(MeshUniformsGPU), 4);
+                    if (crowdWeights) {
+                        preEncoder->setVertexBuffer(crowdWeights, draw.mesh->getSkinWeightBufferOffset(), GeometryBuffer::kSkinWeightBufferIndex);
+                        preEncoder->setVertexBuffer(m_crowdAnimation->getPaletteBuffer(), 0, 3);
+                    } else if (vertexAnimation) {
+                        preEncoder->setVertexBytes(&draw.vertexAnimationParams, sizeof(VertexAnimationParamsGPU), 5);
+                        preEncoder->setVertexTexture(vertexAnimation->getHandle(), 0);
+                    } else if (draw.terrainHeights) {
+                        preEncoder->setVertexBytes(&draw.terrainParams, sizeof(TerrainParamsGPU), 5);
+                        preEncoder->setVertexTexture(draw.terrainHeights, 0);
+                    }
                     auto albedoTex = (draw.material && draw.material->getAlbedoTexture()) ? draw.material->getAlbedoTexture() : m_defaultWhiteTexture;
                     auto roughnessTex = (draw.material && draw.material->getRoughnessTexture()) ? draw.material->getRoughnessTexture() : m_defaultWhiteTexture;
                     auto ormTex = (draw.material && draw.material->getORMTexture()) ? draw.material->getORMTexture() : m_defaultBlackTexture;
@@ -5223,91 +7971,240 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                     if (m_samplerState) {
                         preEncoder->setFragmentSamplerState(m_samplerState, 0);
                     }
-                    preEncoder->setCullMode(resolveCullMode(draw.material.get()));
+                    preEncoder->setCullMode(ResolveCullMode(draw.material.get()));
 
                     preEncoder->drawIndexedPrimitives(
                         MTL::PrimitiveTypeTriangle,
-                        draw.mesh->getIndices().size(),
+                        draw.mesh->getIndexCount(),
                         MTL::IndexTypeUInt32,
                         indexBuffer,
-                        0,
+                        draw.mesh->getIndexBufferOffset(),
                         draw.instanceCount
                     );
                 }
             }
         }
         
-        preEncoder->endEncoding();
+        if (encodeStaticPrepass) {
+            useStaticSceneResources(preEncoder, bufferSlot, false);
+            preEncoder->setRenderPipelineState(m_prepassPipelineInstanced);
+            preEncoder->setVertexBuffer(m_cameraUniformBuffer, 0, 2);
+            const StaticSceneFrame& staticFrame = m_staticSceneFrames[bufferSlot];
+            GPUPassWork staticWork;
+            staticWork.pipelineBinds = 1;
+            staticWork.bufferBinds = 1;
+            for (const auto& group : m_staticScene.groups) {
+                staticWork.textureBinds += bindPrepassMaterialTextures(preEncoder, group.material.get());
+                preEncoder->setCullMode(ResolveCullMode(group.material.get()));
+                preEncoder->executeCommandsInBuffer(staticFrame.prepassCommands,
+                                                    NS::Range::Make(group.firstBatch, group.batchCount));
+                ++staticWork.draws;
+            }
+            m_gpuPassProfiler->recordWork(GPUPass::Prepass, staticWork);
+        }
+        
+        prepassEncoder.end();
+
+        // Second phase: test everything against the depth of the first, then draw the deferred
+        // entities that turned out visible on top of it.
+        if (useOcclusion) {
+            buildHzb(commandBuffer);
+            dispatchOcclusionCulling(commandBuffer, bufferSlot, cullScreenSize);
+            if (!prepassLateDraws.empty()) {
+                prepass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionLoad);
+                if (runVelocity) {
+                    prepass->colorAttachments()->object(1)->setLoadAction(MTL::LoadActionLoad);
+                }
+                prepass->depthAttachment()->setLoadAction(MTL::LoadActionLoad);
+                m_gpuPassProfiler->attach(prepass, GPUPass::Prepass);
+                ParallelPassEncoder lateEncoder(commandBuffer, prepass, prepassLateDraws.size(), setupPrepassEncoder);
+                m_gpuPassProfiler->detach(prepass);
+                lateEncoder.encodeRange(prepassLateDraws.size(), [&](MTL::RenderCommandEncoder* enc, size_t begin, size_t end) {
+                    PassEncodeState state;
+                    state.uniforms = UniformRing::Binder(frameUniforms);
+                    for (size_t i = begin; i < end; ++i) {
+                        encodePrepassDraw(enc, prepassLateDraws[i], state);
+                    }
+                    m_gpuPassProfiler->recordWork(GPUPass::Prepass, state.work);
+                    stateBinds.fetch_add(state.binds, std::memory_order_relaxed);
+                    stateBindsSkipped.fetch_add(state.skipped, std::memory_order_relaxed);
+                });
+                m_stats.parallelEncoders += static_cast<uint32_t>(lateEncoder.parallelEncoderCount());
+                lateEncoder.end();
+            }
+            hzbCurrent = prepassLateDraws.empty();
+        }
         prepass->release();
     }
 
-    bool canBuildHzb = runPrepass && useGpuInstanceCulling && m_instanceCullHzbPipeline && m_hzbTexture
+    // Editor pick: the scene view's pickable mesh renderers into the picker's entity-ID target,
+    // scissored to the requested rectangle. Each is drawn on its own, including those the main
+    // passes batch into GPU-driven static draws. Instanced renderers and foliage scatters are
+    // not mesh renderer proxies and stay out of it; clicks on them fall back to the bounds raycast
+    // (see Engine::applyPickResults).
+    if (m_activePool == RenderTargetPool::Scene && m_entityPicker && m_entityPicker->hasPendingRequest()) {
+        MTL::RenderCommandEncoder* pickEncoder = m_entityPicker->begin(commandBuffer, renderWidth, renderHeight);
+        if (pickEncoder) {
+            pickEncoder->setVertexBuffer(m_cameraUniformBuffer, 0, 2);
+            MaterialUniformsGPU pickMaterial{};
+            pickMaterial.uvTilingOffset = Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
+            pickEncoder->setVertexBytes(&pickMaterial, sizeof(MaterialUniformsGPU), 3);
+            const auto& pickProxies = renderWorld.getMeshRenderers();
+            for (size_t proxyIndex = 0; proxyIndex < pickProxies.size(); ++proxyIndex) {
+                const auto& proxy = pickProxies[proxyIndex];
+                Entity* entity = proxy.entity;
+                if (!meshInFrustum[proxyIndex] || shouldSkipEntity(proxy) || !SelectionSystem::isPickable(entity)) {
+                    continue;
+                }
+                MeshRenderer* meshRenderer = proxy.meshRenderer;
+                std::shared_ptr<Mesh> mesh = meshRenderer->isEnabled() ? meshRenderer->getMesh() : nullptr;
+                MTL::Buffer* vertexBuffer = mesh ? static_cast<MTL::Buffer*>(mesh->getVertexBuffer()) : nullptr;
+                MTL::Buffer* indexBuffer = mesh ? static_cast<MTL::Buffer*>(mesh->getIndexBuffer()) : nullptr;
+                if (!vertexBuffer || !indexBuffer) {
+                    continue;
+                }
+                // Skinned meshes pick in their animated pose from the skinning cache, otherwise
+                // in bind pose.
+                const SkinningCache::Entry* skinCache = m_skinningCache ? m_skinningCache->find(meshRenderer) : nullptr;
+                if (skinCache) {
+                    SkinningCache::BindVertexStreams(pickEncoder, *skinCache);
+                } else {
+                    pickEncoder->setVertexBuffer(vertexBuffer, mesh->getVertexBufferOffset(), 0);
+                    pickEncoder->setVertexBuffer(static_cast<MTL::Buffer*>(mesh->getAttributeBuffer()), mesh->getAttributeBufferOffset(),
+                                                 GeometryBuffer::kAttributeBufferIndex);
+                }
+                ModelUniforms modelUniforms;
+                modelUniforms.modelMatrix = entity->getTransform()->getWorldMatrix();
+                modelUniforms.normalMatrix = modelUniforms.modelMatrix.normalMatrix();
+                pickEncoder->setVertexBytes(&modelUniforms, sizeof(ModelUniforms), 1);
+                MeshUniformsGPU meshUniforms{};
+                Math::Vector3 boundsCenter = mesh->getBoundsCenter();
+                Math::Vector3 boundsSize = mesh->getBoundsSize();
+                meshUniforms.boundsCenter = Math::Vector4(boundsCenter.x, boundsCenter.y, boundsCenter.z, 0.0f);
+                meshUniforms.boundsSize = Math::Vector4(boundsSize.x, boundsSize.y, boundsSize.z, 0.0f);
+                meshUniforms.lightmapScaleOffset = Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
+                pickEncoder->setVertexBytes(&meshUniforms, sizeof(MeshUniformsGPU), 4);
+                const uint32_t entityId = entity->getIndex() + 1;
+                pickEncoder->setFragmentBytes(&entityId, sizeof(entityId), 0);
+                pickEncoder->drawIndexedPrimitives(MTL::PrimitiveTypeTriangle,
+                                                   mesh->getLodIndexCount(0),
+                                                   MTL::IndexTypeUInt32,
+                                                   indexBuffer,
+                                                   mesh->getLodIndexBufferOffset(0));
+                ++m_stats.pickDraws;
+            }
+            m_entityPicker->end(commandBuffer, pickEncoder);
+        }
+    }
+
+    CRESCENT_PROFILE_NEXT(profilePhase, "Renderer::lightingPasses");
+    // Build clustered light lists once the prepass depth is final, so cluster depth ranges can be
+    // clipped to what each screen tile actually shows.
+    // On the async queue it overlaps HZB, decals, velocity and SSAO; joined before the main pass.
+    MTL::CommandBuffer* clusterAsyncCommands = nullptr;
+    if (m_clusterPass && m_lightGPUBuffer) {
+        if (m_asyncCompute && m_qualitySettings.asyncClusterBuild) {
+            clusterAsyncCommands = m_asyncCompute->begin(commandBuffer);
+            m_stats.commandBuffers += clusterAsyncCommands ? 1 : 0;
+        }
+        m_clusterPass->setFrameSlot(bufferSlot);
+        m_clusterPass->dispatch(
+            clusterAsyncCommands ? clusterAsyncCommands : commandBuffer,
+            *m_lightingSystem,
+            camera->getProjectionMatrix(),
+            camera->getNearClip(),
+            camera->getFarClip(),
+            renderWidth,
+            renderHeight,
+            m_lightGPUBuffer,
+            runPrepass ? m_depthTexture : nullptr
+        );
+        m_clusterHeaderBuffer = m_clusterPass->getClusterHeaders();
+        m_clusterIndexBuffer = m_clusterPass->getClusterIndices();
+        m_stats.clustersActive = m_clusterPass->getActiveClusterCount();
+        m_stats.clustersOverflowed = m_clusterPass->getOverflowClusterCount();
+        m_stats.clusterLightsDropped = m_clusterPass->getOverflowLightCount();
+        m_stats.clusterTileLightsDropped = m_clusterPass->getTileOverflowLightCount();
+    }
+
+    const bool hzbCullInstances = useGpuInstanceCulling && m_instanceCullHzbPipeline;
+    const bool hzbCullStatics = useStaticScene && m_staticCullHzbPipeline;
+    bool canBuildHzb = runPrepass && (hzbCullInstances || hzbCullStatics) && m_hzbTexture
         && m_hzbInitPipeline && m_hzbDownsamplePipeline && !m_hzbMipViews.empty();
     if (canBuildHzb) {
-        MTL::ComputeCommandEncoder* hzbInit = commandBuffer->computeCommandEncoder();
-        hzbInit->setComputePipelineState(m_hzbInitPipeline);
-        hzbInit->setTexture(m_depthTexture, 0);
-        hzbInit->setTexture(m_hzbMipViews[0], 1);
-        if (m_pointClampSampler) {
-            hzbInit->setSamplerState(m_pointClampSampler, 0);
-        } else if (m_linearClampSampler) {
-            hzbInit->setSamplerState(m_linearClampSampler, 0);
-        }
-        const uint32_t hzbWidth = m_hzbMipViews[0]->width();
-        const uint32_t hzbHeight = m_hzbMipViews[0]->height();
-        const uint32_t threads = 8;
-        MTL::Size tgSize = MTL::Size(threads, threads, 1);
-        MTL::Size gridSize = MTL::Size((hzbWidth + threads - 1) / threads * threads,
-                                       (hzbHeight + threads - 1) / threads * threads,
-                                       1);
-        hzbInit->dispatchThreads(gridSize, tgSize);
-        hzbInit->endEncoding();
-
-        for (size_t mip = 1; mip < m_hzbMipViews.size(); ++mip) {
-            MTL::Texture* src = m_hzbMipViews[mip - 1];
-            MTL::Texture* dst = m_hzbMipViews[mip];
-            if (!src || !dst) {
-                continue;
-            }
-            MTL::ComputeCommandEncoder* downEncoder = commandBuffer->computeCommandEncoder();
-            downEncoder->setComputePipelineState(m_hzbDownsamplePipeline);
-            downEncoder->setTexture(src, 0);
-            downEncoder->setTexture(dst, 1);
-            const uint32_t mipWidth = dst->width();
-            const uint32_t mipHeight = dst->height();
-            MTL::Size downGrid = MTL::Size((mipWidth + threads - 1) / threads * threads,
-                                           (mipHeight + threads - 1) / threads * threads,
-                                           1);
-            downEncoder->dispatchThreads(downGrid, tgSize);
-            downEncoder->endEncoding();
+        if (!hzbCurrent) {
+            buildHzb(commandBuffer);
         }
 
-        if (m_instanceCullHzbPipeline) {
+        if (hzbCullInstances) {
             dispatchInstanceCulling(m_instanceCullHzbPipeline, true);
         }
+        if (hzbCullStatics) {
+            // The prepass already consumed its commands; only the main pass ICB is re-encoded.
+            dispatchStaticSceneCulling(commandBuffer, bufferSlot, frustumPlanes, cullScreenSize, true, false);
+        }
+    }
+
+    // Particles simulate against this frame's prepass depth, and are sorted for this view, before
+    // the main pass draws them.
+    if (m_particleSystem && m_particleSystem->isAvailable()) {
+        ParticleSystem::ViewInputs particleInputs;
+        particleInputs.cameraUniforms = m_cameraUniformBuffer;
+        particleInputs.sceneDepth = runPrepass ? m_depthTexture : nullptr;
+        particleInputs.hzb = canBuildHzb ? m_hzbTexture : nullptr;
+        particleInputs.hzbMipCount = canBuildHzb ? static_cast<uint32_t>(m_hzbMipViews.size()) : 0;
+        particleInputs.viewportWidth = static_cast<float>(viewport.width);
+        particleInputs.viewportHeight = static_cast<float>(viewport.height);
+        particleInputs.budget = static_cast<uint32_t>(m_qualitySettings.particleBudget);
+        particleInputs.collision = m_qualitySettings.particleCollision;
+        particleInputs.deltaTime = Time::deltaTime();
+        particleInputs.frame = engineFrame;
+        m_particleSystem->update(commandBuffer, renderWorld.getParticleEmitters(), particleInputs);
+        m_stats.particleEmitters = m_particleSystem->getEmitterCount();
+        m_stats.particleEmittersSimulated = m_particleSystem->getEmittersSimulated();
+        m_stats.particleCapacity = m_particleSystem->getCapacity();
     }
 
     bool useDecals = runPrepass && m_decalPipelineState && m_decalAlbedoTexture && m_decalNormalTexture
         && m_decalOrmTexture && m_depthTexture;
+    struct DecalDraw {
+        Decal* decal;
+        Transform* transform;
+        uint32_t occlusionArg;
+    };
+    FrameVector<DecalDraw> decalDraws(frameArena);
     if (useDecals) {
-        struct DecalDraw {
-            Decal* decal;
-            Transform* transform;
-        };
-        std::vector<DecalDraw> decalDraws;
         decalDraws.reserve(16);
-        const auto& decalEntities = scene->getAllEntities();
-        for (const auto& entityPtr : decalEntities) {
-            Entity* entity = entityPtr.get();
-            if (!entity || !entity->isActiveInHierarchy()) {
+        for (size_t decalIndex = 0; decalIndex < decalProxies.size(); ++decalIndex) {
+            const auto& decalProxy = decalProxies[decalIndex];
+            Entity* entity = decalProxy.entity;
+            if (!entity->isActiveInHierarchy()) {
+                continue;
+            }
+            Decal* decal = decalProxy.decal;
+            if (!decal->isEnabled()) {
                 continue;
             }
-            Decal* decal = entity->getComponent<Decal>();
-            if (!decal || !decal->isEnabled()) {
+            Transform* transform = entity->getTransform();
+            const Math::Vector4 sphere = DecalWorldSphere(transform->getWorldMatrix());
+            if (!Math::IsSphereInFrustum(frustumPlanes, Math::Vector3(sphere.x, sphere.y, sphere.z), sphere.w)) {
                 continue;
             }
-            decalDraws.push_back({decal, entity->getTransform()});
+            // A box behind the depth buffer has no surface to project onto.
+            const uint32_t occlusionArg = useOcclusion
+                ? appendOcclusionArg(bufferSlot, static_cast<uint32_t>(occlusionProxies.size() + decalIndex),
+                                     kDecalBoxVertexCount)
+                : kNoOcclusionArg;
+            decalDraws.push_back({decal, transform, occlusionArg});
+        }
+        if (useOcclusion) {
+            dispatchOcclusionArgs(commandBuffer, bufferSlot);
         }
+    }
+    // With nothing visible the targets are not even cleared; the main pass binds transparent
+    // defaults instead.
+    const bool decalsDrawn = useDecals && !decalDraws.empty();
+    if (decalsDrawn) {
 
         MTL::RenderPassDescriptor* decalPass = MTL::RenderPassDescriptor::alloc()->init();
         auto color0 = decalPass->colorAttachments()->object(0);
@@ -5326,9 +8223,16 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         color1->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 0.0));
         color2->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 0.0));
 
-        MTL::RenderCommandEncoder* decalEncoder = commandBuffer->renderCommandEncoder(decalPass);
+        // Each decal rasterizes its box rather than the whole screen, so its cost follows its
+        // screen footprint. There is no depth attachment to test against (the pass samples the
+        // depth texture instead), so the box is clamped rather than clipped at the far plane and
+        // the fragment rejects depths outside it.
+        MTL::RenderCommandEncoder* decalEncoder = m_gpuPassProfiler->renderEncoder(commandBuffer, decalPass, GPUPass::Decals);
         decalEncoder->setViewport(viewport);
         decalEncoder->setRenderPipelineState(m_decalPipelineState);
+        decalEncoder->setCullMode(MTL::CullModeFront);
+        decalEncoder->setDepthClipMode(MTL::DepthClipModeClamp);
+        decalEncoder->setVertexBuffer(m_cameraUniformBuffer, 0, 0);
         decalEncoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
         decalEncoder->setFragmentTexture(m_depthTexture, 0);
         if (m_samplerState) {
@@ -5355,7 +8259,10 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             Math::Vector2 tiling = decal->getTiling();
             Math::Vector2 offset = decal->getOffset();
             decalParams.uvTilingOffset = Math::Vector4(tiling.x, tiling.y, offset.x, offset.y);
-            decalParams.edgeParams = Math::Vector4(decal->getEdgeSoftness(), 0.0f, 0.0f, 0.0f);
+            decalParams.edgeParams = Math::Vector4(decal->getEdgeSoftness(),
+                                                   1.0f / static_cast<float>(viewport.width),
+                                                   1.0f / static_cast<float>(viewport.height),
+                                                   0.0f);
 
             bool hasNormal = decal->getNormalTexture() != nullptr;
             bool hasOrm = decal->getORMTexture() != nullptr;
@@ -5364,6 +8271,10 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             decalParams.modelMatrix = transform->getWorldMatrix();
             decalParams.invModel = decalParams.modelMatrix.inversed();
 
+            // A mirrored box turns its faces inside out.
+            decalEncoder->setFrontFacingWinding(decalParams.modelMatrix.determinant() < 0.0f
+                ? MTL::WindingClockwise : MTL::WindingCounterClockwise);
+            decalEncoder->setVertexBytes(&decalParams, sizeof(DecalParamsGPU), 1);
             decalEncoder->setFragmentBytes(&decalParams, sizeof(DecalParamsGPU), 1);
 
             std::shared_ptr<Texture2D> albedoTex = decal->getAlbedoTexture();
@@ -5394,235 +8305,181 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             decalEncoder->setFragmentTexture(ormHandle, 3);
             decalEncoder->setFragmentTexture(maskHandle, 4);
 
-            decalEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
+            if (draw.occlusionArg != kNoOcclusionArg) {
+                decalEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, occlusionArgs,
+                                             draw.occlusionArg * sizeof(DrawIndexedIndirectArgs));
+            } else {
+                decalEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(kDecalBoxVertexCount));
+            }
         }
 
         decalEncoder->endEncoding();
         decalPass->release();
     }
 
-    bool runVelocity = (motionBlurEnabled || taaEnabled || metalFXEnabled)
-        && runPrepass && m_velocityPipelineState && m_velocityTexture && m_depthTexture;
     if (runVelocity) {
+        VelocityReconstructParamsGPU reconstructParams{};
+        reconstructParams.inverseViewProjection = viewProjection.inversed();
+        reconstructParams.currViewProjection = viewProjectionNoJitter;
+        reconstructParams.prevViewProjection = prevViewProjectionNoJitter;
+        reconstructParams.texelSize = Math::Vector4(
+            1.0f / static_cast<float>(renderWidth),
+            1.0f / static_cast<float>(renderHeight),
+            0.0f,
+            0.0f
+        );
+
         MTL::RenderPassDescriptor* velocityPass = MTL::RenderPassDescriptor::alloc()->init();
         velocityPass->colorAttachments()->object(0)->setTexture(m_velocityTexture);
-        velocityPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
+        velocityPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionLoad);
         velocityPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
-        velocityPass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 1.0));
-        velocityPass->depthAttachment()->setTexture(m_depthTexture);
-        velocityPass->depthAttachment()->setLoadAction(MTL::LoadActionLoad);
-        velocityPass->depthAttachment()->setStoreAction(MTL::StoreActionDontCare);
-
-        MTL::RenderCommandEncoder* velEncoder = commandBuffer->renderCommandEncoder(velocityPass);
-        velEncoder->setDepthStencilState(m_depthReadState ? m_depthReadState : m_depthStencilState);
-        velEncoder->setFrontFacingWinding(MTL::WindingCounterClockwise);
-        velEncoder->setCullMode(MTL::CullModeBack);
-        velEncoder->setViewport(viewport);
-
-        Math::Matrix4x4 currViewProjection = viewProjectionNoJitter;
-        Math::Matrix4x4 prevViewProjection = m_motionHistoryValid ? m_prevViewProjectionNoJitter : viewProjectionNoJitter;
-
-        const auto& velEntities = scene->getAllEntities();
-        for (const auto& entityPtr : velEntities) {
-            Entity* entity = entityPtr.get();
-            if (!entity->isActiveInHierarchy()) {
-                continue;
-            }
-            if (shouldSkipEntity(entity)) {
-                continue;
-            }
-
-            MeshRenderer* meshRenderer = entity->getComponent<MeshRenderer>();
-            if (!meshRenderer || !meshRenderer->isEnabled()) {
-                continue;
-            }
-
-            std::shared_ptr<Mesh> mesh = meshRenderer->getMesh();
-            if (!mesh) {
-                continue;
-            }
-            std::shared_ptr<Material> material = meshRenderer->getMaterial(0);
 
-            MTL::Buffer* vertexBuffer = static_cast<MTL::Buffer*>(mesh->getVertexBuffer());
-            MTL::Buffer* indexBuffer = static_cast<MTL::Buffer*>(mesh->getIndexBuffer());
-            MTL::Buffer* skinBuffer = static_cast<MTL::Buffer*>(mesh->getSkinWeightBuffer());
-            if (!vertexBuffer || !indexBuffer) {
-                continue;
-            }
+        MTL::RenderCommandEncoder* velEncoder = m_gpuPassProfiler->renderEncoder(commandBuffer, velocityPass, GPUPass::Velocity);
+        velEncoder->setRenderPipelineState(m_velocityReconstructPipeline);
+        velEncoder->setViewport(viewport);
+        velEncoder->setFragmentBytes(&reconstructParams, sizeof(VelocityReconstructParamsGPU), 0);
+        velEncoder->setFragmentTexture(m_depthTexture, 0);
+        velEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
+        velEncoder->endEncoding();
+        velocityPass->release();
+    }
 
-            SkinnedMeshRenderer* skinned = entity->getComponent<SkinnedMeshRenderer>();
-            bool wantsSkin = skinned && skinned->isEnabled() && mesh->hasSkinWeights() && !skinned->getBoneMatrices().empty();
-            bool isSkinned = wantsSkin && (skinBuffer != nullptr);
-            MTL::RenderPipelineState* pipeline = isSkinned ? m_velocityPipelineSkinned : m_velocityPipelineState;
-            if (!pipeline) {
-                continue;
-            }
+    bool useSSAO = post.enabled && post.ssao && runPrepass && m_ssaoPipelineState && m_ssaoTemporalPipelineState
+        && m_ssaoUpsamplePipelineState && m_ssaoTexture && m_ssaoHistoryTexture && m_ssaoAccumTexture
+        && m_ssaoBlurTexture && m_depthTexture && m_normalTexture;
+    if (useSSAO) {
+        // Trace at the SSAO resolution with a few horizon steps per pixel, rotated every frame,
+        // accumulate along the reprojection, then upsample with depth-aware weights.
+        const float scaleX = static_cast<float>(renderWidth) / static_cast<float>(m_ssaoWidth);
+        const float scaleY = static_cast<float>(renderHeight) / static_cast<float>(m_ssaoHeight);
+        MTL::Size threadsPerGroup = MTL::Size::Make(8, 8, 1);
+        MTL::Size ssaoGroups = MTL::Size::Make((m_ssaoWidth + 7) / 8, (m_ssaoHeight + 7) / 8, 1);
+        MTL::Size fullGroups = MTL::Size::Make((renderWidth + 7) / 8, (renderHeight + 7) / 8, 1);
 
-            velEncoder->setRenderPipelineState(pipeline);
+        SSAOParamsGPU ssaoParams{};
+        ssaoParams.settings = Math::Vector4(
+            std::max(0.05f, post.ssaoRadius),
+            std::max(0.0f, std::min(post.ssaoStrength, 3.0f)),
+            1.5f,
+            static_cast<float>(m_frameIndex % 64)
+        );
+        ssaoParams.resolution = Math::Vector4(scaleX, scaleY, 0.0f, 0.0f);
+
+        SSAOTemporalParamsGPU temporalParams{};
+        temporalParams.prevViewProjection = m_prevViewProjectionNoJitter;
+        temporalParams.params0 = Math::Vector4(
+            0.9f,
+            (m_ssaoHistoryValid && m_motionHistoryValid) ? 1.0f : 0.0f,
+            runVelocity ? 1.0f : 0.0f,
+            0.1f
+        );
 
-            ModelUniforms modelUniforms;
-            modelUniforms.modelMatrix = entity->getTransform()->getWorldMatrix();
-            modelUniforms.normalMatrix = modelUniforms.modelMatrix.normalMatrix();
+        SSAOUpsampleParamsGPU upsampleParams{};
+        upsampleParams.params0 = Math::Vector4(scaleX, scaleY, 24.0f, 0.0f);
+
+        MTL::ComputeCommandEncoder* ssaoCompute = m_gpuPassProfiler->computeEncoder(commandBuffer, GPUPass::SSAO);
+        ssaoCompute->setBuffer(m_cameraUniformBuffer, 0, 0);
+
+        ssaoCompute->setComputePipelineState(m_ssaoPipelineState);
+        ssaoCompute->setBytes(&ssaoParams, sizeof(SSAOParamsGPU), 1);
+        ssaoCompute->setTexture(m_depthTexture, 0);
+        ssaoCompute->setTexture(m_normalTexture, 1);
+        ssaoCompute->setTexture(m_ssaoTexture, 2);
+        ssaoCompute->dispatchThreadgroups(ssaoGroups, threadsPerGroup);
+
+        ssaoCompute->setComputePipelineState(m_ssaoTemporalPipelineState);
+        ssaoCompute->setBytes(&temporalParams, sizeof(SSAOTemporalParamsGPU), 1);
+        ssaoCompute->setTexture(m_ssaoTexture, 0);
+        ssaoCompute->setTexture(m_ssaoHistoryTexture, 1);
+        ssaoCompute->setTexture(runVelocity ? m_velocityTexture : m_ssaoTexture, 2);
+        ssaoCompute->setTexture(m_ssaoAccumTexture, 3);
+        ssaoCompute->setTexture(m_depthTexture, 4);
+        if (m_linearClampSampler) {
+            ssaoCompute->setSamplerState(m_linearClampSampler, 0);
+        }
+        ssaoCompute->dispatchThreadgroups(ssaoGroups, threadsPerGroup);
 
-            VelocityUniformsGPU velocityUniforms{};
-            velocityUniforms.prevModelMatrix = entity->getTransform()->getPreviousWorldMatrix();
-            velocityUniforms.currViewProjection = currViewProjection;
-            velocityUniforms.prevViewProjection = prevViewProjection;
-            MaterialUniformsGPU materialUniforms{};
-            MeshUniformsGPU meshUniforms{};
-            if (material) {
-                Math::Vector3 windDir = material->getWindDirection();
-                materialUniforms.foliageParams0 = Math::Vector4(
-                    material->getWindStrength(),
-                    material->getWindSpeed(),
-                    material->getWindScale(),
-                    material->getWindGust()
-                );
-                materialUniforms.foliageParams1 = Math::Vector4(
-                    material->getLodFadeStart(),
-                    material->getLodFadeEnd(),
-                    material->getBillboardStart(),
-                    material->getBillboardEnd()
-                );
-                materialUniforms.foliageParams2 = Math::Vector4(
-                    material->getWindEnabled() ? 1.0f : 0.0f,
-                    material->getLodFadeEnabled() ? 1.0f : 0.0f,
-                    material->getBillboardEnabled() ? 1.0f : 0.0f,
-                    material->getDitherEnabled() ? 1.0f : 0.0f
-                );
-                materialUniforms.foliageParams3 = Math::Vector4(windDir.x, windDir.y, windDir.z, 0.0f);
-            }
-            Math::Vector3 boundsCenter = mesh->getBoundsCenter();
-            Math::Vector3 boundsSize = mesh->getBoundsSize();
-            meshUniforms.boundsCenter = Math::Vector4(boundsCenter.x, boundsCenter.y, boundsCenter.z, 0.0f);
-            meshUniforms.boundsSize = Math::Vector4(boundsSize.x, boundsSize.y, boundsSize.z, 0.0f);
-            meshUniforms.flags = Math::Vector4((material && material->getBillboardEnabled()) ? 1.0f : 0.0f, 0.0f, 0.0f, 0.0f);
-            meshUniforms.lightmapScaleOffset = Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
+        ssaoCompute->setComputePipelineState(m_ssaoUpsamplePipelineState);
+        ssaoCompute->setBytes(&upsampleParams, sizeof(SSAOUpsampleParamsGPU), 1);
+        ssaoCompute->setTexture(m_ssaoAccumTexture, 0);
+        ssaoCompute->setTexture(m_depthTexture, 1);
+        ssaoCompute->setTexture(m_ssaoBlurTexture, 2);
+        ssaoCompute->dispatchThreadgroups(fullGroups, threadsPerGroup);
+        ssaoCompute->endEncoding();
 
-            velEncoder->setVertexBuffer(vertexBuffer, 0, 0);
-            velEncoder->setVertexBuffer(m_cameraUniformBuffer, 0, 2);
-            if (isSkinned) {
-                velEncoder->setVertexBuffer(skinBuffer, 0, 4);
-            }
-            velEncoder->setVertexBytes(&modelUniforms, sizeof(ModelUniforms), 1);
-            if (isSkinned) {
-                velEncoder->setVertexBytes(&materialUniforms, sizeof(MaterialUniformsGPU), 7);
-            } else {
-                velEncoder->setVertexBytes(&materialUniforms, sizeof(MaterialUniformsGPU), 3);
-                velEncoder->setVertexBytes(&meshUniforms, sizeof(MeshUniformsGPU), 4);
-            }
-            velEncoder->setVertexBytes(&velocityUniforms, sizeof(VelocityUniformsGPU), 5);
-
-            if (isSkinned && skinned) {
-                const auto& boneMatrices = skinned->getBoneMatrices();
-                if (!boneMatrices.empty()) {
-                    size_t bytes = boneMatrices.size() * sizeof(Math::Matrix4x4);
-                    size_t bufferOffset = 0;
-                    if (allocateSkinningSlice(m_skinningBuffer, m_skinningBufferCapacity, skinningOffset, bytes, bufferOffset)) {
-                        std::memcpy(static_cast<uint8_t*>(m_skinningBuffer->contents()) + bufferOffset,
-                                    boneMatrices.data(),
-                                    bytes);
-                        velEncoder->setVertexBuffer(m_skinningBuffer, bufferOffset, 3);
-                    }
+        if (options.updateHistory) {
+            std::swap(m_ssaoAccumTexture, m_ssaoHistoryTexture);
+            m_ssaoHistoryValid = true;
+        }
+    } else {
+        m_ssaoHistoryValid = false;
+    }
+    
+    CRESCENT_PROFILE_NEXT(profilePhase, "Renderer::mainPass");
+    // Rasterization rate map for the game view's main pass: shading falls off toward the screen
+    // edges, further while the camera turns under motion blur, and in the periphery under depth of
+    // field, which is assumed to keep its subject near the center.
+    bool useRateMap = false;
+    if (m_activePool == RenderTargetPool::Game && m_qualitySettings.variableRateShading
+        && useOffscreen && !useMSAA && m_colorTexture
+        && m_variableRateShading && m_variableRateShading->isAvailable()) {
+        VariableRateShading::Rates rates;
+        rates.periphery = m_qualitySettings.variableRateShadingPeriphery;
+        if (dofEnabled) {
+            rates.periphery *= Math::Clamp(post.dofAperture / 5.6f, 0.5f, 1.0f);
+        }
+        Math::Vector3 camForward = camera->getEntity()
+            ? camera->getEntity()->getTransform()->forward().normalized()
+            : m_rateMapPrevCameraForward;
+        if (motionBlurEnabled && m_rateMapPrevCameraValid) {
+            // Fraction of the view the camera turned this frame; motion blur smears that far.
+            float turn = std::acos(Math::Clamp(camForward.dot(m_rateMapPrevCameraForward), -1.0f, 1.0f));
+            float screenMotion = turn / std::max(0.1f, camera->getFieldOfView());
+            float velocityScale = 1.0f / (1.0f + 8.0f * screenMotion * post.motionBlurStrength);
+            rates.center *= std::max(0.5f, velocityScale);
+            rates.periphery *= std::max(0.5f, velocityScale);
+        }
+        m_rateMapPrevCameraForward = camForward;
+        m_rateMapPrevCameraValid = true;
+        useRateMap = m_variableRateShading->update(m_colorTexture->width(), m_colorTexture->height(),
+                                                   static_cast<uint32_t>(m_colorTexture->pixelFormat()), rates);
+    } else if (m_activePool == RenderTargetPool::Game) {
+        m_rateMapPrevCameraValid = false;
+    }
+    m_stats.shadedPixelRatio = useRateMap ? m_variableRateShading->getShadedPixelRatio() : 1.0f;
+
+    // Visibility buffer: the static scene's ids against the finished prepass depth, shaded per
+    // material group in the main pass. Multisampled and rate-mapped passes keep the indirect draws.
+    const bool useVisibility = useStaticScene && m_qualitySettings.visibilityBuffer && runPrepass && !useMSAA
+        && !useRateMap && m_visibilityPipeline && m_visibilityClassifyPipeline && m_visibilityTexture
+        && m_visibilityTileRanges;
+    if (useVisibility) {
+        encodeVisibilityBuffer(commandBuffer, bufferSlot, viewport);
+    }
 
-                    const auto& prevBones = skinned->getPreviousBoneMatrices();
-                    const auto& usePrevBones = (prevBones.size() == boneMatrices.size() && !prevBones.empty())
-                        ? prevBones
-                        : boneMatrices;
-                    size_t prevBufferOffset = 0;
-                    if (allocateSkinningSlice(m_prevSkinningBuffer, m_prevSkinningBufferCapacity, prevSkinningOffset, bytes, prevBufferOffset)) {
-                        std::memcpy(static_cast<uint8_t*>(m_prevSkinningBuffer->contents()) + prevBufferOffset,
-                                    usePrevBones.data(),
-                                    bytes);
-                        velEncoder->setVertexBuffer(m_prevSkinningBuffer, prevBufferOffset, 6);
-                    }
-                }
-            }
-
-            velEncoder->drawIndexedPrimitives(
-                MTL::PrimitiveTypeTriangle,
-                mesh->getIndices().size(),
-                MTL::IndexTypeUInt32,
-                indexBuffer,
-                0
-            );
-        }
-
-        velEncoder->endEncoding();
-        velocityPass->release();
-    }
-
-    bool useSSAO = post.enabled && post.ssao && runPrepass && m_ssaoPipelineState && m_ssaoBlurPipelineState
-        && m_ssaoTexture && m_ssaoBlurTexture && m_depthTexture && m_normalTexture && m_ssaoNoiseTexture;
-    if (useSSAO) {
-        SSAOParamsGPU ssaoParams{};
-        ssaoParams.radius = std::max(0.05f, post.ssaoRadius);
-        ssaoParams.bias = std::max(0.0025f, post.ssaoRadius * 0.01f);
-        ssaoParams.intensity = std::max(0.0f, std::min(post.ssaoStrength, 3.0f));
-        ssaoParams.power = 1.5f;
-        ssaoParams.noiseScale = Math::Vector2(renderWidth / 4.0f, renderHeight / 4.0f);
-        ssaoParams.texelSize = Math::Vector2(1.0f / renderWidth, 1.0f / renderHeight);
-
-        MTL::RenderPassDescriptor* ssaoPass = MTL::RenderPassDescriptor::alloc()->init();
-        ssaoPass->colorAttachments()->object(0)->setTexture(m_ssaoTexture);
-        ssaoPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
-        ssaoPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
-        ssaoPass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(1.0, 1.0, 1.0, 1.0));
-
-        MTL::RenderCommandEncoder* ssaoEncoder = commandBuffer->renderCommandEncoder(ssaoPass);
-        ssaoEncoder->setRenderPipelineState(m_ssaoPipelineState);
-        ssaoEncoder->setViewport(viewport);
-        ssaoEncoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
-        ssaoEncoder->setFragmentBytes(&ssaoParams, sizeof(SSAOParamsGPU), 1);
-        ssaoEncoder->setFragmentTexture(m_depthTexture, 0);
-        ssaoEncoder->setFragmentTexture(m_normalTexture, 1);
-        ssaoEncoder->setFragmentTexture(m_ssaoNoiseTexture, 2);
-        if (m_linearClampSampler) {
-            ssaoEncoder->setFragmentSamplerState(m_linearClampSampler, 0);
-        }
-        ssaoEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
-        ssaoEncoder->endEncoding();
-        ssaoPass->release();
-
-        SSAOBlurParamsGPU blurParams{};
-        blurParams.texelSize = ssaoParams.texelSize;
-        blurParams.depthSharpness = 72.0f;
-        blurParams.normalSharpness = 48.0f;
-
-        MTL::RenderPassDescriptor* blurPass = MTL::RenderPassDescriptor::alloc()->init();
-        blurPass->colorAttachments()->object(0)->setTexture(m_ssaoBlurTexture);
-        blurPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
-        blurPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
-        blurPass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(1.0, 1.0, 1.0, 1.0));
-
-        MTL::RenderCommandEncoder* blurEncoder = commandBuffer->renderCommandEncoder(blurPass);
-        blurEncoder->setRenderPipelineState(m_ssaoBlurPipelineState);
-        blurEncoder->setViewport(viewport);
-        blurEncoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
-        blurEncoder->setFragmentBytes(&blurParams, sizeof(SSAOBlurParamsGPU), 1);
-        blurEncoder->setFragmentTexture(m_ssaoTexture, 0);
-        blurEncoder->setFragmentTexture(m_depthTexture, 1);
-        blurEncoder->setFragmentTexture(m_normalTexture, 2);
-        if (m_linearClampSampler) {
-            blurEncoder->setFragmentSamplerState(m_linearClampSampler, 0);
-        }
-        blurEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
-        blurEncoder->endEncoding();
-        blurPass->release();
-    }
-    
     // Setup render pass
     MTL::RenderPassDescriptor* renderPass = MTL::RenderPassDescriptor::alloc()->init();
     
     // Color attachment
-    if (useMSAA) {
+    if (useRateMap) {
+        renderPass->colorAttachments()->object(0)->setTexture(m_variableRateShading->getColorTarget());
+        renderPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
+        renderPass->setRasterizationRateMap(m_variableRateShading->getRateMap());
+    } else if (useMSAA) {
         renderPass->colorAttachments()->object(0)->setTexture(m_msaaColorTexture);
+        if (resolveToDrawable && !acquireDrawable()) {
+            resolveToDrawable = false;
+        }
         renderPass->colorAttachments()->object(0)->setResolveTexture(resolveToDrawable ? drawable->texture() : m_colorTexture);
         renderPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionMultisampleResolve);
     } else if (useOffscreen) {
         renderPass->colorAttachments()->object(0)->setTexture(m_colorTexture);
         renderPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
     } else {
+        if (!acquireDrawable()) {
+            renderPass->release();
+            return;
+        }
         renderPass->colorAttachments()->object(0)->setTexture(drawable->texture());
         renderPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
     }
@@ -5634,7 +8491,8 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     );
     
     // Depth attachment
-    MTL::Texture* depthTarget = useMSAA ? m_msaaDepthTexture : m_depthTexture;
+    MTL::Texture* depthTarget = useRateMap ? m_variableRateShading->getDepthTarget()
+                              : (useMSAA ? m_msaaDepthTexture : m_depthTexture);
     if (!depthTarget) {
         std::cerr << "Failed to create depth texture!" << std::endl;
         renderPass->release();
@@ -5643,7 +8501,8 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     
     renderPass->depthAttachment()->setTexture(depthTarget);
     bool usePrepassDepth = runPrepass && !useMSAA;
-    if (usePrepassDepth) {
+    // The rate-mapped depth target is primed from the prepass depth by the pass's first draw.
+    if (usePrepassDepth && !useRateMap) {
         renderPass->depthAttachment()->setLoadAction(MTL::LoadActionLoad);
     } else {
         renderPass->depthAttachment()->setLoadAction(MTL::LoadActionClear);
@@ -5651,72 +8510,51 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     }
     renderPass->depthAttachment()->setStoreAction(MTL::StoreActionDontCare);
     
-    // Create render encoder
-    MTL::RenderCommandEncoder* encoder = commandBuffer->renderCommandEncoder(renderPass);
-    encoder->setDepthStencilState(m_depthStencilState);
-    encoder->setFrontFacingWinding(MTL::WindingCounterClockwise);
-    encoder->setCullMode(MTL::CullModeBack);  
-    
-    // Set viewport
-    encoder->setViewport(viewport);
-    
-    // Environment uniforms
-    updateEnvironmentUniforms();
-    
-    // Bind environment once for all draws
-    if (m_samplerState) {
-        encoder->setFragmentSamplerState(m_samplerState, 1);
-    }
-    if (m_environmentUniformBuffer) {
-        encoder->setFragmentBuffer(m_environmentUniformBuffer, 0, 3);
-    }
-    auto envTexHandle = (m_environmentTexture ? m_environmentTexture : m_defaultEnvironmentTexture);
-    encoder->setFragmentTexture(envTexHandle ? envTexHandle->getHandle() : nullptr, 7);
-    MTL::Texture* ssaoTexture = (useSSAO && m_ssaoBlurTexture) ? m_ssaoBlurTexture : nullptr;
-    if (!ssaoTexture && m_defaultWhiteTexture) {
-        ssaoTexture = m_defaultWhiteTexture->getHandle();
-    }
-    encoder->setFragmentTexture(ssaoTexture, 17);
-
-    MTL::Texture* decalAlbedo = useDecals ? m_decalAlbedoTexture : nullptr;
-    MTL::Texture* decalNormal = useDecals ? m_decalNormalTexture : nullptr;
-    MTL::Texture* decalOrm = useDecals ? m_decalOrmTexture : nullptr;
-    if (!decalAlbedo && m_defaultBlackTexture) {
-        decalAlbedo = m_defaultBlackTexture->getHandle();
-    }
-    if (!decalNormal && m_defaultNormalTexture) {
-        decalNormal = m_defaultNormalTexture->getHandle();
-    }
-    if (!decalOrm && m_defaultBlackTexture) {
-        decalOrm = m_defaultBlackTexture->getHandle();
-    }
-    encoder->setFragmentTexture(decalAlbedo, 18);
-    encoder->setFragmentTexture(decalNormal, 19);
-    encoder->setFragmentTexture(decalOrm, 20);
-    
-    // Draw skybox first
-    renderSkybox(encoder, camera);
-    encoder->setDepthStencilState(m_depthStencilState);
-    encoder->setCullMode(MTL::CullModeBack);
-    
-    // Render all mesh renderers
-    const auto& entities = scene->getAllEntities();
+    // Gather the visible MeshRenderer draws first; uploads, pipeline lookups, skinning slices and
+    // static lighting textures are resolved here so the encode below can be split across workers.
+    const auto& meshProxies = renderWorld.getMeshRenderers();
+    FrameVector<PassDraw> mainDraws(frameArena);
+    // Scene-wide fragment_main features; keyed on whether the scene has decals or probes at all,
+    // not on this frame's visibility, so variants do not churn as the camera moves.
+    const uint8_t scenePbrFeatures = resolveScenePbrFeatures(useDecals && !decalProxies.empty()) | pbrPrecisionFeatures();
+    mainDraws.reserve(meshProxies.size());
+    size_t mainSkinningBytes = 0;
+    // Blended draws whose material composites order-independently, accumulated after the main
+    // pass at full and half resolution. The accumulation passes test against the stored main pass
+    // depth and composite into the offscreen colour target, so other main pass setups draw every
+    // blended layer sorted.
+    FrameVector<PassDraw> weightedDraws(frameArena);
+    FrameVector<PassDraw> lowResDraws(frameArena);
+    const bool useWeightedTransparency = m_weightedTransparency && m_weightedTransparency->isAvailable()
+        && useOffscreen && !useMSAA && !useRateMap && m_colorTexture && depthTarget == m_depthTexture;
     
     int renderedCount = 0;
-    for (const auto& entityPtr : entities) {
-        Entity* entity = entityPtr.get();
+    for (size_t proxyIndex = 0; proxyIndex < meshProxies.size(); ++proxyIndex) {
+        const auto& proxy = meshProxies[proxyIndex];
+        Entity* entity = proxy.entity;
         if (!entity->isActiveInHierarchy()) {
             continue;
         }
-        if (shouldSkipEntity(entity)) {
+        if (shouldSkipEntity(proxy)) {
             continue;
         }
+        MeshRenderer* meshRenderer = proxy.meshRenderer;
+        // Mip requests cover the GPU-driven statics skipped below as well.
+        if (m_textureStreamer && meshInFrustum[proxyIndex] && meshRenderer->isEnabled()) {
+            if (Mesh* streamedMesh = meshRenderer->getMesh().get()) {
+                RequestMaterialTextureResolutions(*m_textureStreamer, meshRenderer, streamedMesh,
+                                                  entity->getTransform()->getWorldMatrix(),
+                                                  meshSpheres[proxyIndex], m_lodView);
+            }
+        }
         if (gpuCulledStatics.find(entity) != gpuCulledStatics.end()) {
             continue;
         }
+        if (isStaticSceneProxy(proxyIndex)) {
+            continue;
+        }
         
-        MeshRenderer* meshRenderer = entity->getComponent<MeshRenderer>();
-        if (!meshRenderer || !meshRenderer->isEnabled()) {
+        if (!meshRenderer->isEnabled()) {
             continue;
         }
         
@@ -5724,21 +8562,13 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         std::shared_ptr<Mesh> mesh = meshRenderer->getMesh();
         if (!mesh) continue;
 
-        Math::Vector3 boundsCenter;
-        Math::Vector3 boundsSize;
-        ResolveRendererBounds(entity, meshRenderer, boundsCenter, boundsSize);
-        float radius = 0.5f * std::sqrt(boundsSize.x * boundsSize.x
-                                        + boundsSize.y * boundsSize.y
-                                        + boundsSize.z * boundsSize.z);
-        if (radius <= 0.0f) {
-            radius = 0.001f;
-        }
-        radius *= kCullTightness;
-        if (!IsSphereInFrustum(frustumPlanes, boundsCenter, radius)) {
+        m_stats.cullCandidates++;
+        if (!meshInFrustum[proxyIndex]) {
             continue;
         }
+        m_stats.cullFrustumVisible++;
 
-        SkinnedMeshRenderer* skinned = entity->getComponent<SkinnedMeshRenderer>();
+        SkinnedMeshRenderer* skinned = proxy.skinned;
         bool wantsSkin = skinned && skinned->isEnabled() && mesh->hasSkinWeights() && !skinned->getBoneMatrices().empty();
 
         // Upload mesh if needed
@@ -5753,30 +8583,382 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         if (!vertexBuffer || !indexBuffer) continue;
 
         bool isSkinned = wantsSkin && (skinBuffer != nullptr);
+        const SkinningCache::Entry* skinCache = (isSkinned && m_skinningCache)
+            ? m_skinningCache->find(meshRenderer)
+            : nullptr;
+        if (skinCache) {
+            isSkinned = false;
+        }
 
         renderMeshRenderer(meshRenderer, camera, lights);
         std::shared_ptr<Material> material = meshRenderer->getMaterial(0);
-        bool isTransparent = false;
-        if (material) {
-            isTransparent = material->getRenderMode() == Material::RenderMode::Transparent
-                || material->getAlpha() < 0.999f;
-        }
-        bool alphaToCoverage = material && material->getRenderMode() == Material::RenderMode::Cutout
-            && material->getAlphaToCoverage();
-        PipelineStateKey pipelineKey{true, true, true, isTransparent, isSkinned, false, alphaToCoverage, m_outputHDR, static_cast<uint8_t>(m_msaaSamples)};
-        MTL::RenderPipelineState* pipelineState = getPipelineState(pipelineKey);
-        if (!pipelineState) {
+
+        PassDraw draw;
+        draw.entity = entity;
+        draw.meshRenderer = meshRenderer;
+        draw.mesh = mesh.get();
+        draw.material = std::move(material);
+        draw.vertexBuffer = vertexBuffer;
+        draw.indexBuffer = indexBuffer;
+        draw.skinBuffer = skinBuffer;
+        draw.isSkinned = isSkinned;
+        draw.skinCache = skinCache;
+        draw.modelMatrix = entity->getTransform()->getWorldMatrix();
+        if (isSkinned) {
+            draw.boneMatrices = &skinned->getBoneMatrices();
+            draw.skinningOffset = mainSkinningBytes;
+            mainSkinningBytes += AlignSkinningBytes(draw.boneMatrices->size() * sizeof(Math::Matrix4x4));
+        } else if (draw.material && !skinCache) {
+            // The static lighting cache may load textures, so resolve it here rather than in the encoder.
+            const auto& staticLighting = meshRenderer->getStaticLighting();
+            draw.staticLightmap = resolveStaticLightingTexture(staticLighting.lightmapPath, false);
+            draw.directionalLightmap = resolveStaticLightingTexture(staticLighting.directionalLightmapPath, false);
+            draw.shadowmaskLightmap = resolveStaticLightingTexture(staticLighting.shadowmaskPath, false);
+        }
+        const bool staticLighting = draw.staticLightmap
+            || (!isSkinned && !skinCache && meshRenderer->getUseBakedVertexLighting());
+        acquireTerrainVirtualTexture(draw.material.get());
+        if (m_materialTable && m_materialTable->isAvailable()) {
+            draw.materialEntry = acquireMaterialTableEntry(draw.material.get(), meshRenderer->getReceiveShadows());
+        }
+        PipelineStateKey pipelineKey = ResolveMeshPipelineKey(draw.material.get(), isSkinned, staticLighting,
+                                                              scenePbrFeatures, m_outputHDR,
+                                                              static_cast<uint8_t>(m_msaaSamples),
+                                                              draw.materialEntry != MaterialTable::kInvalidEntry);
+        draw.pipeline = getPipelineState(pipelineKey);
+        if (!draw.pipeline) {
             continue;
         }
-        encoder->setRenderPipelineState(pipelineState);
+        draw.isTransparent = pipelineKey.isTransparent;
+        FrameVector<PassDraw>* drawList = &mainDraws;
+        const Material::TransparencyMode transparency = (useWeightedTransparency && draw.isTransparent)
+            ? draw.material->getTransparencyMode()
+            : Material::TransparencyMode::Sorted;
+        if (transparency != Material::TransparencyMode::Sorted) {
+            PipelineStateKey weightedKey = pipelineKey;
+            weightedKey.weightedBlended = true;
+            // Until its variant compiles, the draw stays in the sorted path.
+            if (MTL::RenderPipelineState* weightedPipeline = getPipelineState(weightedKey)) {
+                draw.pipeline = weightedPipeline;
+                // The layers need no depth order, so they sort like opaque draws for state changes.
+                draw.isTransparent = false;
+                drawList = transparency == Material::TransparencyMode::LowResolution ? &lowResDraws : &weightedDraws;
+            }
+        }
+        const size_t firstDraw = drawList->size();
+        AppendLodDraws(*drawList, std::move(draw), m_lodView, m_lodPixelError, mainSkinningBytes);
+        for (size_t i = firstDraw; i < drawList->size(); ++i) {
+            m_stats.cullLodDraws[std::min<size_t>((*drawList)[i].lod, kLodStatLevels - 1)]++;
+        }
+        if (isOccludedLastFrame(entity)) {
+            deferToOcclusionTest(*drawList, firstDraw, proxyIndex);
+            m_stats.cullOcclusionTested++;
+        }
+
+        renderedCount++;
+        m_stats.drawCalls++;
+        m_stats.triangles += mesh->getLodIndexCount(drawList->back().lod) / 3;
+        m_stats.vertices += mesh->getVertexCount();
+    }
+
+    SortPassDraws(mainDraws, cameraPos, frameArena);
+    SortPassDraws(weightedDraws, cameraPos, frameArena);
+    SortPassDraws(lowResDraws, cameraPos, frameArena);
+    m_stats.weightedTransparentDraws = static_cast<uint32_t>(weightedDraws.size());
+    m_stats.lowResTransparentDraws = static_cast<uint32_t>(lowResDraws.size());
+    if (!weightedDraws.empty() || !lowResDraws.empty()) {
+        renderPass->depthAttachment()->setStoreAction(MTL::StoreActionStore);
+    }
+    PassSkinningBlock mainSkinning = reserveSkinningBlock(mainSkinningBytes);
+    MTL::Buffer* materialTableBuffer = m_materialTable ? m_materialTable->getBuffer() : nullptr;
+    if (m_materialTable) {
+        m_stats.materialTableEntries = static_cast<uint32_t>(m_materialTable->getEntryCount());
+    }
+
+    // The procedural sky re-bakes its sky-view LUT only when the sun changes. While no environment
+    // map lights the scene, the sky's cubemaps do, refreshed a face per frame after such a change.
+    if (m_skyAtmosphere && m_skyAtmosphere->isAvailable() && m_environmentSettings.skyMode == 0) {
+        SkyAtmosphere::Inputs skyInputs;
+        if (mainLight && mainLight->getIntensity() > 0.0f) {
+            Math::Vector3 dir = mainLight->getDirection();
+            skyInputs.sunDirection = Math::Vector3(-dir.x, -dir.y, -dir.z);
+            skyInputs.sunColor = mainLight->getColor();
+        } else {
+            // No sun: light the sky from mid-morning rather than leave it black.
+            skyInputs.sunDirection = Math::Vector3(0.0f, 0.5f, 0.866f);
+        }
+        skyInputs.environmentRotation = EnvironmentRotationMatrix(m_environmentSettings.rotation);
+        skyInputs.bakeLighting = !m_hasIBL;
+        skyInputs.frame = engineFrame;
+        m_skyAtmosphere->update(commandBuffer, skyInputs);
+        m_stats.skyLutBakes = m_skyAtmosphere->getLUTBakes();
+        m_stats.skyLightingFaces = m_skyAtmosphere->getLightingFacesBaked();
+        if (skyInputs.bakeLighting && m_skyAtmosphere->hasLighting() && !m_iblBRDFLUT
+            && m_iblGenerator && m_iblGenerator->isInitialized()) {
+            m_iblBRDFLUT = m_iblGenerator->getBRDFLUT();
+        }
+    }
+
+    // Environment uniforms
+    updateEnvironmentUniforms();
+
+    // Dynamic probes re-trace a slice of the grid before the main pass samples it.
+    if (m_probeVolumeDynamic && m_dynamicProbeGI && m_probeVolumeBuffer) {
+        const SceneStaticLightingSettings& staticLighting = scene->getSettings().staticLighting;
+        std::vector<DynamicProbeGI::Instance> probeInstances;
+        std::vector<DynamicProbeGI::Material> probeMaterials;
+        for (const auto& proxy : renderWorld.getMeshRenderers()) {
+            // Skinned and instanced renderers have no single static mesh to trace.
+            if (proxy.skinned || proxy.instanced || shouldSkipEntity(proxy)) {
+                continue;
+            }
+            MeshRenderer* mr = proxy.meshRenderer;
+            if (!mr->isEnabled() || !proxy.entity->isActiveInHierarchy() || !mr->getMesh()) {
+                continue;
+            }
+            DynamicProbeGI::Instance instance;
+            instance.mesh = mr->getMesh();
+            instance.worldMatrix = proxy.entity->getTransform()->getWorldMatrix();
+            instance.castShadows = mr->getCastShadows();
+            instance.materialOffset = static_cast<uint32_t>(probeMaterials.size());
+            for (const auto& material : mr->getMaterials()) {
+                DynamicProbeGI::Material probeMaterial;
+                if (material) {
+                    const Math::Vector4 albedo = material->getAlbedo();
+                    const Math::Vector3 emission = material->getEmission() * material->getEmissionStrength();
+                    probeMaterial.albedo[0] = albedo.x;
+                    probeMaterial.albedo[1] = albedo.y;
+                    probeMaterial.albedo[2] = albedo.z;
+                    probeMaterial.emission[0] = emission.x;
+                    probeMaterial.emission[1] = emission.y;
+                    probeMaterial.emission[2] = emission.z;
+                }
+                probeMaterials.push_back(probeMaterial);
+            }
+            instance.materialCount = static_cast<uint32_t>(probeMaterials.size()) - instance.materialOffset;
+            probeInstances.push_back(std::move(instance));
+        }
+        m_dynamicProbeGI->updateScene(commandBuffer, probeInstances, probeMaterials);
+
+        ProbeVolumeUniformsGPU probeUniforms{};
+        fillProbeVolumeUniforms(probeUniforms);
+        auto probeEnvironment = (m_environmentTexture ? m_environmentTexture : m_defaultEnvironmentTexture);
+        DynamicProbeGI::FrameInputs inputs;
+        inputs.probes = m_probeVolumeBuffer;
+        inputs.firstProbeRecord = m_dynamicProbeFirstRecord;
+        inputs.probeVolumeUniforms = &probeUniforms;
+        inputs.probeVolumeUniformsSize = sizeof(ProbeVolumeUniformsGPU);
+        inputs.camera = m_cameraUniformBuffer;
+        inputs.lights = m_lightGPUBuffer;
+        inputs.lightCount = m_lightCountBuffer ? *static_cast<const uint32_t*>(m_lightCountBuffer->contents()) : 0u;
+        inputs.shadows = m_shadowGPUBuffer;
+        inputs.shadowAtlas = m_shadowPass ? m_shadowPass->getShadowAtlas() : nullptr;
+        inputs.environment = m_environmentUniformBuffer;
+        inputs.environmentMap = probeEnvironment ? probeEnvironment->getHandle() : nullptr;
+        inputs.linearSampler = m_linearClampSampler;
+        inputs.probesPerFrame = static_cast<uint32_t>(std::max(1, staticLighting.dynamicProbesPerFrame));
+        inputs.raysPerProbe = static_cast<uint32_t>(std::max(1, staticLighting.dynamicProbeRays));
+        inputs.hysteresis = staticLighting.dynamicProbeHysteresis;
+        m_stats.dynamicProbesUpdated = m_dynamicProbeGI->dispatch(commandBuffer, inputs);
+
+        // Reflection captures trace through the same scene, a few cube faces a frame.
+        if (staticLighting.dynamicReflections && m_iblGenerator && m_iblGenerator->isInitialized()) {
+            m_stats.dynamicReflectionFaces = m_dynamicProbeGI->dispatchReflections(
+                commandBuffer, inputs, *m_iblGenerator, camera->getEntity()->getTransform()->getPosition(),
+                static_cast<uint32_t>(staticLighting.dynamicReflectionProbes),
+                static_cast<uint32_t>(staticLighting.dynamicReflectionResolution),
+                static_cast<uint32_t>(staticLighting.dynamicReflectionFacesPerFrame));
+        } else {
+            m_dynamicProbeGI->releaseReflections();
+        }
+        if (m_dynamicProbeGI->getReflectionCaptures()) {
+            m_dynamicReflectionParams = Math::Vector4(static_cast<float>(m_dynamicProbeGI->getReflectionSlotCount()),
+                                                      static_cast<float>(m_dynamicProbeGI->getReflectionMipCount() - 1),
+                                                      m_dynamicProbeGI->getReflectionRadius(), 0.0f);
+            m_dynamicReflectionSlots = m_dynamicProbeGI->getReflectionSlots();
+        } else {
+            m_dynamicReflectionParams = Math::Vector4::Zero;
+        }
+    } else {
+        m_dynamicReflectionParams = Math::Vector4::Zero;
+        if (m_dynamicProbeGI) {
+            m_dynamicProbeGI->releaseReflections();
+        }
+    }
+    // Terrain pages the main pass reads, once every terrain material it draws was acquired.
+    if (m_terrainVirtualTexture) {
+        m_terrainVirtualTexture->encode(commandBuffer);
+        m_stats.terrainVirtualPagesComposited = m_terrainVirtualTexture->getPagesComposited();
+        m_stats.terrainVirtualPagesResident = m_terrainVirtualTexture->getResidentPageCount();
+    }
+
+    // Pass-constant state; re-applied to every sub-encoder when the pass is encoded in parallel.
+    auto setupMainEncoder = [&](MTL::RenderCommandEncoder* enc) {
+        enc->setDepthStencilState(m_depthStencilState);
+        enc->setFrontFacingWinding(MTL::WindingCounterClockwise);
+        enc->setCullMode(MTL::CullModeBack);
+        enc->setViewport(viewport);
+
+        // Bind environment once for all draws
+        if (m_samplerState) {
+            enc->setFragmentSamplerState(m_samplerState, 0);
+            enc->setFragmentSamplerState(m_samplerState, 1);
+        }
+        if (m_environmentUniformBuffer) {
+            enc->setFragmentBuffer(m_environmentUniformBuffer, 0, 3);
+        }
+        // Material table draws reach their textures only through the entry's handles.
+        if (materialTableBuffer) {
+            m_materialTable->makeResident(enc);
+        }
+        auto envTexHandle = (m_environmentTexture ? m_environmentTexture : m_defaultEnvironmentTexture);
+        enc->setFragmentTexture(envTexHandle ? envTexHandle->getHandle() : nullptr, 7);
+        MTL::Texture* ssaoTexture = (useSSAO && m_ssaoBlurTexture) ? m_ssaoBlurTexture : nullptr;
+        if (!ssaoTexture && m_defaultWhiteTexture) {
+            ssaoTexture = m_defaultWhiteTexture->getHandle();
+        }
+        enc->setFragmentTexture(ssaoTexture, 17);
+
+        // Decal coverage is in alpha, so the stand-ins must be fully transparent.
+        MTL::Texture* decalDefault = m_defaultTransparentTexture ? m_defaultTransparentTexture->getHandle() : nullptr;
+        MTL::Texture* decalAlbedo = decalsDrawn ? m_decalAlbedoTexture : decalDefault;
+        MTL::Texture* decalNormal = decalsDrawn ? m_decalNormalTexture : decalDefault;
+        MTL::Texture* decalOrm = decalsDrawn ? m_decalOrmTexture : decalDefault;
+        enc->setFragmentTexture(decalAlbedo, 18);
+        enc->setFragmentTexture(decalNormal, 19);
+        enc->setFragmentTexture(decalOrm, 20);
+
+        // IBL textures (slots 8, 9, 10)
+        bindEnvironmentLighting(enc);
+
+        // Lighting, shadow and cluster inputs are the same for every draw in the pass.
+        enc->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
+        enc->setFragmentBuffer(m_lightUniformBuffer, 0, 2);
+
+        // New clustered light/shadow buffers
+        if (m_lightGPUBuffer) {
+            enc->setFragmentBuffer(m_lightGPUBuffer, 0, 4);
+        }
+        if (m_shadowGPUBuffer) {
+            enc->setFragmentBuffer(m_shadowGPUBuffer, 0, 5);
+        }
+        if (m_lightCountBuffer) {
+            enc->setFragmentBuffer(m_lightCountBuffer, 0, 6);
+        } else {
+            uint32_t zero = 0;
+            enc->setFragmentBytes(&zero, sizeof(uint32_t), 6);
+        }
+        if (m_shadowPass) {
+            enc->setFragmentTexture(m_shadowPass->getShadowAtlas(), 11);
+            enc->setFragmentTexture(m_shadowPass->getDepthBounds(), 37);
+            const auto& cubes = m_shadowPass->getPointCubeTextures();
+            for (size_t i = 0; i < cubes.size() && i < 4; ++i) {
+                if (cubes[i]) {
+                    enc->setFragmentTexture(cubes[i], 12 + i);
+                }
+            }
+        }
+        if (m_dynamicProbeGI) {
+            enc->setFragmentTexture(m_dynamicProbeGI->getReflectionCaptures(), 38);
+        }
+        if (m_shadowSampler) {
+            enc->setFragmentSamplerState(m_shadowSampler, 2);
+        }
+        if (m_clusterHeaderBuffer) {
+            enc->setFragmentBuffer(m_clusterHeaderBuffer, 0, 7);
+        }
+        if (m_clusterIndexBuffer) {
+            enc->setFragmentBuffer(m_clusterIndexBuffer, 0, 8);
+        }
+        if (m_clusterParamsBuffer) {
+            enc->setFragmentBuffer(m_clusterParamsBuffer, 0, 9);
+        }
+        ProbeVolumeUniformsGPU probeUniforms{};
+        fillProbeVolumeUniforms(probeUniforms);
+        enc->setFragmentBytes(&probeUniforms, sizeof(ProbeVolumeUniformsGPU), 10);
+        MTL::Buffer* probeBuffer = m_probeVolumeBuffer ? m_probeVolumeBuffer : m_probeVolumeFallbackBuffer;
+        enc->setFragmentBuffer(probeBuffer, 0, 11);
+        if (m_terrainVirtualTexture) {
+            m_terrainVirtualTexture->bind(enc);
+        }
+    };
+
+    // Per-object lighting inputs: mesh uniforms and lightmaps for static draws, neutral lightmaps
+    // for palette-skinned ones.
+    auto bindMeshLighting = [&](MTL::RenderCommandEncoder* encoder, const PassDraw& draw, PassEncodeState& state) {
+        if (!draw.isSkinned) {
+            MeshRenderer* meshRenderer = draw.meshRenderer;
+            Mesh* mesh = draw.mesh;
+            const auto& staticLighting = meshRenderer->getStaticLighting();
+            const std::shared_ptr<Texture2D>& staticLightmapTex = draw.staticLightmap;
+            const std::shared_ptr<Texture2D>& directionalLightmapTex = draw.directionalLightmap;
+            const std::shared_ptr<Texture2D>& shadowmaskLightmapTex = draw.shadowmaskLightmap;
+            bool hasStaticLightmap = staticLightmapTex && !staticLighting.lightmapPath.empty();
+            MeshUniformsGPU meshUniforms{};
+            Math::Vector3 boundsCenter = mesh->getBoundsCenter();
+            Math::Vector3 boundsSize = mesh->getBoundsSize();
+            meshUniforms.boundsCenter = Math::Vector4(boundsCenter.x, boundsCenter.y, boundsCenter.z, 0.0f);
+            meshUniforms.boundsSize = Math::Vector4(boundsSize.x, boundsSize.y, boundsSize.z, 0.0f);
+            // Baked vertex lighting does not follow a deforming mesh, so cached skinned draws skip it.
+            meshUniforms.flags = Math::Vector4(
+                0.0f,
+                (meshRenderer->getUseBakedVertexLighting() && !draw.skinCache) ? 1.0f : 0.0f,
+                hasStaticLightmap ? 1.0f : 0.0f,
+                EncodeStaticLightmapModeFlag(
+                    ResolveStaticLightmapEncodingFlag(staticLighting.lightmapPath),
+                    scene->getSettings().staticLighting.bakeDirectLighting
+                )
+            );
+            meshUniforms.lightmapScaleOffset = hasStaticLightmap
+                ? staticLighting.lightmapScaleOffset
+                : Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
+            state.setVertexBytes(encoder, &meshUniforms, sizeof(MeshUniformsGPU), 4);
+            state.setFragmentTexture(encoder, (hasStaticLightmap ? staticLightmapTex : m_defaultBlackTexture) ? (hasStaticLightmap ? staticLightmapTex : m_defaultBlackTexture)->getHandle() : nullptr, 31);
+            state.setFragmentTexture(encoder, (directionalLightmapTex ? directionalLightmapTex : m_defaultHeightTexture) ? (directionalLightmapTex ? directionalLightmapTex : m_defaultHeightTexture)->getHandle() : nullptr, 32);
+            state.setFragmentTexture(encoder, (shadowmaskLightmapTex ? shadowmaskLightmapTex : m_defaultWhiteTexture) ? (shadowmaskLightmapTex ? shadowmaskLightmapTex : m_defaultWhiteTexture)->getHandle() : nullptr, 33);
+        } else {
+            state.setFragmentTexture(encoder, m_defaultBlackTexture ? m_defaultBlackTexture->getHandle() : nullptr, 31);
+            state.setFragmentTexture(encoder, m_defaultHeightTexture ? m_defaultHeightTexture->getHandle() : nullptr, 32);
+            state.setFragmentTexture(encoder, m_defaultWhiteTexture ? m_defaultWhiteTexture->getHandle() : nullptr, 33);
+        }
+    };
+
+    auto encodeMainDraw = [&](MTL::RenderCommandEncoder* encoder, const PassDraw& draw, PassEncodeState& state) {
+        MeshRenderer* meshRenderer = draw.meshRenderer;
+        Mesh* mesh = draw.mesh;
+        const std::shared_ptr<Material>& material = draw.material;
+        MTL::RenderPipelineState* pipelineState = draw.pipeline;
+        MTL::Buffer* vertexBuffer = draw.vertexBuffer;
+        MTL::Buffer* indexBuffer = draw.indexBuffer;
+        MTL::Buffer* skinBuffer = draw.skinBuffer;
+        bool isSkinned = draw.isSkinned;
+
+        state.setPipeline(encoder, pipelineState);
         
         // Setup model uniforms
         ModelUniforms modelUniforms;
-        modelUniforms.modelMatrix = entity->getTransform()->getWorldMatrix();
+        modelUniforms.modelMatrix = draw.modelMatrix;
         modelUniforms.normalMatrix = modelUniforms.modelMatrix.normalMatrix();
+        modelUniforms.normalMatrix(0, 3) = draw.lodDither;
         
         // Setup material uniforms
-        if (material) {
+        if (draw.materialEntry != MaterialTable::kInvalidEntry) {
+            // Uniforms and texture handles come from the entry built while gathering.
+            const size_t entryOffset = MaterialTable::EntryOffset(draw.materialEntry);
+            if (state.fragmentMaterialEntry != draw.materialEntry) {
+                state.setFragmentBuffer(encoder, materialTableBuffer, entryOffset, 1);
+                state.setFragmentBuffer(encoder, materialTableBuffer, MaterialTable::TextureOffset(draw.materialEntry), 12);
+                state.fragmentMaterialEntry = draw.materialEntry;
+                ++state.binds;
+            } else {
+                ++state.skipped;
+            }
+            if (!isSkinned && state.vertexMaterialEntry != draw.materialEntry) {
+                state.setVertexBuffer(encoder, materialTableBuffer, entryOffset, 3);
+                state.vertexMaterialEntry = draw.materialEntry;
+            }
+            bindMeshLighting(encoder, draw, state);
+        } else if (material) {
             MaterialUniformsGPU matUniforms;
             matUniforms.albedo = material->getAlbedo();
             matUniforms.properties = Math::Vector4(
@@ -5832,11 +9014,13 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             );
             bool alphaClip = material->getRenderMode() == Material::RenderMode::Cutout;
             float alphaCutoff = material->getAlphaCutoff();
+            const auto& normalMapTex = material->getNormalTexture();
+            bool normalLengthInAlpha = normalMapTex && normalMapTex->hasNormalLengthInAlpha();
             matUniforms.textureFlags3 = Math::Vector4(
                 hasORMTex ? 1.0f : 0.0f,
                 alphaClip ? 1.0f : 0.0f,
                 alphaCutoff,
-                0.0f
+                normalLengthInAlpha ? 1.0f : 0.0f
             );
             matUniforms.heightParams = Math::Vector4(
                 material->getHeightScale(),
@@ -5881,7 +9065,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             matUniforms.terrainParams1 = Math::Vector4(
                 material->getTerrainSlopeStart(),
                 material->getTerrainSlopeEnd(),
-                0.0f,
+                terrainVirtualTextureSlot(material.get()),
                 0.0f
             );
             Math::Vector2 terrain0ST = material->getTerrainLayer0Tiling();
@@ -5897,177 +9081,170 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 hasTerrainLayer2Tex ? 1.0f : 0.0f
             );
             
-            encoder->setFragmentBytes(&matUniforms, sizeof(MaterialUniformsGPU), 1);
+            state.setFragmentBytes(encoder, &matUniforms, sizeof(MaterialUniformsGPU), 1);
             if (!isSkinned) {
-                const auto& staticLighting = meshRenderer->getStaticLighting();
-                std::shared_ptr<Texture2D> staticLightmapTex = resolveStaticLightingTexture(staticLighting.lightmapPath, false);
-                std::shared_ptr<Texture2D> directionalLightmapTex = resolveStaticLightingTexture(staticLighting.directionalLightmapPath, false);
-                std::shared_ptr<Texture2D> shadowmaskLightmapTex = resolveStaticLightingTexture(staticLighting.shadowmaskPath, false);
-                bool hasStaticLightmap = staticLightmapTex && !staticLighting.lightmapPath.empty();
-                MeshUniformsGPU meshUniforms{};
-                Math::Vector3 boundsCenter = mesh->getBoundsCenter();
-                Math::Vector3 boundsSize = mesh->getBoundsSize();
-                meshUniforms.boundsCenter = Math::Vector4(boundsCenter.x, boundsCenter.y, boundsCenter.z, 0.0f);
-                meshUniforms.boundsSize = Math::Vector4(boundsSize.x, boundsSize.y, boundsSize.z, 0.0f);
-                meshUniforms.flags = Math::Vector4(
-                    0.0f,
-                    meshRenderer->getUseBakedVertexLighting() ? 1.0f : 0.0f,
-                    hasStaticLightmap ? 1.0f : 0.0f,
-                    EncodeStaticLightmapModeFlag(
-                        ResolveStaticLightmapEncodingFlag(staticLighting.lightmapPath),
-                        scene->getSettings().staticLighting.bakeDirectLighting
-                    )
-                );
-                meshUniforms.lightmapScaleOffset = hasStaticLightmap
-                    ? staticLighting.lightmapScaleOffset
-                    : Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
-                encoder->setVertexBytes(&matUniforms, sizeof(MaterialUniformsGPU), 3);
-                encoder->setVertexBytes(&meshUniforms, sizeof(MeshUniformsGPU), 4);
-                encoder->setFragmentTexture((hasStaticLightmap ? staticLightmapTex : m_defaultBlackTexture) ? (hasStaticLightmap ? staticLightmapTex : m_defaultBlackTexture)->getHandle() : nullptr, 31);
-                encoder->setFragmentTexture((directionalLightmapTex ? directionalLightmapTex : m_defaultHeightTexture) ? (directionalLightmapTex ? directionalLightmapTex : m_defaultHeightTexture)->getHandle() : nullptr, 32);
-                encoder->setFragmentTexture((shadowmaskLightmapTex ? shadowmaskLightmapTex : m_defaultWhiteTexture) ? (shadowmaskLightmapTex ? shadowmaskLightmapTex : m_defaultWhiteTexture)->getHandle() : nullptr, 33);
-            } else {
-                encoder->setFragmentTexture(m_defaultBlackTexture ? m_defaultBlackTexture->getHandle() : nullptr, 31);
-                encoder->setFragmentTexture(m_defaultHeightTexture ? m_defaultHeightTexture->getHandle() : nullptr, 32);
-                encoder->setFragmentTexture(m_defaultWhiteTexture ? m_defaultWhiteTexture->getHandle() : nullptr, 33);
+                state.setVertexBytes(encoder, &matUniforms, sizeof(MaterialUniformsGPU), 3);
             }
-            
-            // Bind textures (fall back to engine defaults)
-            auto albedoTex = hasAlbedoTex ? material->getAlbedoTexture() : m_defaultWhiteTexture;
-            auto normalTex = hasNormalTex ? material->getNormalTexture() : m_defaultNormalTexture;
-            auto metallicTex = hasMetallicTex ? material->getMetallicTexture() : m_defaultBlackTexture;
-            auto roughnessTex = hasRoughnessTex ? material->getRoughnessTexture() : m_defaultWhiteTexture;
-            auto aoTex = hasAOTex ? material->getAOTexture() : m_defaultWhiteTexture;
-            auto emissionTex = hasEmissionTex ? material->getEmissionTexture() : m_defaultBlackTexture;
-            auto heightTex = hasHeightTex ? material->getHeightTexture() : m_defaultHeightTexture;
-            auto ormTex = hasORMTex ? material->getORMTexture() : m_defaultBlackTexture;
-            auto terrainControlTex = hasTerrainControlTex ? material->getTerrainControlTexture() : m_defaultWhiteTexture;
-            auto terrainLayer0Tex = hasTerrainLayer0Tex ? material->getTerrainLayer0Texture() : albedoTex;
-            auto terrainLayer1Tex = hasTerrainLayer1Tex ? material->getTerrainLayer1Texture() : albedoTex;
-            auto terrainLayer2Tex = hasTerrainLayer2Tex ? material->getTerrainLayer2Texture() : albedoTex;
-            auto terrainLayer0NormalTex = material->getTerrainLayer0NormalTexture() ? material->getTerrainLayer0NormalTexture() : m_defaultNormalTexture;
-            auto terrainLayer1NormalTex = material->getTerrainLayer1NormalTexture() ? material->getTerrainLayer1NormalTexture() : m_defaultNormalTexture;
-            auto terrainLayer2NormalTex = material->getTerrainLayer2NormalTexture() ? material->getTerrainLayer2NormalTexture() : m_defaultNormalTexture;
-            auto terrainLayer0OrmTex = material->getTerrainLayer0ORMTexture() ? material->getTerrainLayer0ORMTexture() : m_defaultWhiteTexture;
-            auto terrainLayer1OrmTex = material->getTerrainLayer1ORMTexture() ? material->getTerrainLayer1ORMTexture() : m_defaultWhiteTexture;
-            auto terrainLayer2OrmTex = material->getTerrainLayer2ORMTexture() ? material->getTerrainLayer2ORMTexture() : m_defaultWhiteTexture;
-            
-            encoder->setFragmentTexture(albedoTex ? albedoTex->getHandle() : nullptr, 0);
-            encoder->setFragmentTexture(normalTex ? normalTex->getHandle() : nullptr, 1);
-            encoder->setFragmentTexture(metallicTex ? metallicTex->getHandle() : nullptr, 2);
-            encoder->setFragmentTexture(roughnessTex ? roughnessTex->getHandle() : nullptr, 3);
-            encoder->setFragmentTexture(aoTex ? aoTex->getHandle() : nullptr, 4);
-            encoder->setFragmentTexture(emissionTex ? emissionTex->getHandle() : nullptr, 5);
-            encoder->setFragmentTexture(heightTex ? heightTex->getHandle() : nullptr, 6);
-            encoder->setFragmentTexture(ormTex ? ormTex->getHandle() : nullptr, 16);
-            encoder->setFragmentTexture(terrainControlTex ? terrainControlTex->getHandle() : nullptr, 21);
-            encoder->setFragmentTexture(terrainLayer0Tex ? terrainLayer0Tex->getHandle() : nullptr, 22);
-            encoder->setFragmentTexture(terrainLayer1Tex ? terrainLayer1Tex->getHandle() : nullptr, 23);
-            encoder->setFragmentTexture(terrainLayer2Tex ? terrainLayer2Tex->getHandle() : nullptr, 24);
-            encoder->setFragmentTexture(terrainLayer0NormalTex ? terrainLayer0NormalTex->getHandle() : nullptr, 25);
-            encoder->setFragmentTexture(terrainLayer1NormalTex ? terrainLayer1NormalTex->getHandle() : nullptr, 26);
-            encoder->setFragmentTexture(terrainLayer2NormalTex ? terrainLayer2NormalTex->getHandle() : nullptr, 27);
-            encoder->setFragmentTexture(terrainLayer0OrmTex ? terrainLayer0OrmTex->getHandle() : nullptr, 28);
-            encoder->setFragmentTexture(terrainLayer1OrmTex ? terrainLayer1OrmTex->getHandle() : nullptr, 29);
-            encoder->setFragmentTexture(terrainLayer2OrmTex ? terrainLayer2OrmTex->getHandle() : nullptr, 30);
-            
-            // IBL textures (slots 8, 9, 10)
-            if (m_hasIBL && m_iblIrradiance && m_iblPrefiltered && m_iblBRDFLUT) {
-                encoder->setFragmentTexture(m_iblIrradiance, 8);
-                encoder->setFragmentTexture(m_iblPrefiltered, 9);
-                encoder->setFragmentTexture(m_iblBRDFLUT, 10);
+            state.fragmentMaterialEntry = MaterialTable::kInvalidEntry;
+            state.vertexMaterialEntry = MaterialTable::kInvalidEntry;
+            // Textures only depend on the material; this also resets the lightmap slots, which
+            // bindMeshLighting fills right after.
+            if (state.needsTextures(material.get())) {
+                state.work.textureBinds += bindMainMaterialTextures(encoder, material.get());
             }
-            
-            if (m_samplerState) {
-                encoder->setFragmentSamplerState(m_samplerState, 0);
+            bindMeshLighting(encoder, draw, state);
+        } else {
+            // A sub-encoder starts without bindings, so material-less draws bind neutral defaults
+            // instead of relying on whatever the previous draw left behind.
+            MaterialUniformsGPU matUniforms{};
+            matUniforms.albedo = Math::Vector4(1.0f);
+            matUniforms.properties = Math::Vector4(0.0f, 1.0f, 1.0f, 1.0f);
+            matUniforms.uvTilingOffset = Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
+            state.setFragmentBytes(encoder, &matUniforms, sizeof(MaterialUniformsGPU), 1);
+            if (!isSkinned) {
+                MeshUniformsGPU meshUniforms{};
+                meshUniforms.lightmapScaleOffset = Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
+                state.setVertexBytes(encoder, &matUniforms, sizeof(MaterialUniformsGPU), 3);
+                state.setVertexBytes(encoder, &meshUniforms, sizeof(MeshUniformsGPU), 4);
             }
+            state.fragmentMaterialEntry = MaterialTable::kInvalidEntry;
+            state.vertexMaterialEntry = MaterialTable::kInvalidEntry;
         }
         
         // Bind buffers
-        encoder->setVertexBuffer(vertexBuffer, 0, 0);
+        if (draw.skinCache) {
+            SkinningCache::BindVertexStreams(encoder, *draw.skinCache);
+            state.work.bufferBinds += 2;
+        } else {
+            state.setVertexBuffer(encoder, vertexBuffer, mesh->getVertexBufferOffset(), 0);
+            state.setVertexBuffer(encoder, static_cast<MTL::Buffer*>(mesh->getAttributeBuffer()), mesh->getAttributeBufferOffset(),
+                                  GeometryBuffer::kAttributeBufferIndex);
+        }
         if (isSkinned) {
-            encoder->setVertexBuffer(skinBuffer, 0, 4);
-        }
-        encoder->setVertexBytes(&modelUniforms, sizeof(ModelUniforms), 1);
-        encoder->setVertexBuffer(m_cameraUniformBuffer, 0, 2);
-        if (isSkinned && skinned) {
-            const auto& boneMatrices = skinned->getBoneMatrices();
-            if (!boneMatrices.empty()) {
-                size_t bytes = boneMatrices.size() * sizeof(Math::Matrix4x4);
-                size_t bufferOffset = 0;
-                if (allocateSkinningSlice(m_skinningBuffer, m_skinningBufferCapacity, skinningOffset, bytes, bufferOffset)) {
-                    std::memcpy(static_cast<uint8_t*>(m_skinningBuffer->contents()) + bufferOffset,
-                                boneMatrices.data(),
-                                bytes);
-                    encoder->setVertexBuffer(m_skinningBuffer, bufferOffset, 3);
-                }
-            }
+            state.setVertexBuffer(encoder, skinBuffer, mesh->getSkinWeightBufferOffset(), 4);
+        }
+        state.setVertexBytes(encoder, &modelUniforms, sizeof(ModelUniforms), 1);
+        state.setVertexBuffer(encoder, m_cameraUniformBuffer, 0, 2);
+        if (isSkinned && draw.boneMatrices && mainSkinning.buffer) {
+            size_t bufferOffset = mainSkinning.base + draw.skinningOffset;
+            std::memcpy(static_cast<uint8_t*>(mainSkinning.buffer->contents()) + bufferOffset,
+                        draw.boneMatrices->data(),
+                        draw.boneMatrices->size() * sizeof(Math::Matrix4x4));
+            state.setVertexBuffer(encoder, mainSkinning.buffer, bufferOffset, 3);
+            state.vertexMaterialEntry = MaterialTable::kInvalidEntry;
         }
         
-        encoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
-        encoder->setFragmentBuffer(m_lightUniformBuffer, 0, 2);
+        state.setCullMode(encoder, ResolveCullMode(material.get()));
         
-        // New clustered light/shadow buffers
-        if (m_lightGPUBuffer) {
-            encoder->setFragmentBuffer(m_lightGPUBuffer, 0, 4);
-        }
-        if (m_shadowGPUBuffer) {
-            encoder->setFragmentBuffer(m_shadowGPUBuffer, 0, 5);
-        }
-        if (m_lightCountBuffer) {
-            encoder->setFragmentBuffer(m_lightCountBuffer, 0, 6);
+        // Draw
+        ++state.work.draws;
+        if (draw.occlusionArg != kNoOcclusionArg) {
+            encoder->drawIndexedPrimitives(
+                MTL::PrimitiveTypeTriangle,
+                MTL::IndexTypeUInt32,
+                indexBuffer,
+                mesh->getLodIndexBufferOffset(draw.lod),
+                occlusionArgs,
+                draw.occlusionArg * sizeof(DrawIndexedIndirectArgs)
+            );
         } else {
-            uint32_t zero = 0;
-            encoder->setFragmentBytes(&zero, sizeof(uint32_t), 6);
-        }
-    if (m_shadowPass) {
-        encoder->setFragmentTexture(m_shadowPass->getShadowAtlas(), 11);
-        const auto& cubes = m_shadowPass->getPointCubeTextures();
-        for (size_t i = 0; i < cubes.size() && i < 4; ++i) {
-            if (cubes[i]) {
-                encoder->setFragmentTexture(cubes[i], 12 + i);
-            }
+            encoder->drawIndexedPrimitives(
+                MTL::PrimitiveTypeTriangle,
+                mesh->getLodIndexCount(draw.lod),
+                MTL::IndexTypeUInt32,
+                indexBuffer,
+                mesh->getLodIndexBufferOffset(draw.lod)
+            );
         }
+    };
+
+    if (useOcclusion) {
+        dispatchOcclusionArgs(commandBuffer, bufferSlot);
     }
-        if (m_shadowSampler) {
-            encoder->setFragmentSamplerState(m_shadowSampler, 2);
-        }
-        if (m_clusterHeaderBuffer) {
-            encoder->setFragmentBuffer(m_clusterHeaderBuffer, 0, 7);
-        }
-        if (m_clusterIndexBuffer) {
-            encoder->setFragmentBuffer(m_clusterIndexBuffer, 0, 8);
-        }
-        if (m_clusterParamsBuffer) {
-            encoder->setFragmentBuffer(m_clusterParamsBuffer, 0, 9);
+    if (clusterAsyncCommands) {
+        m_asyncCompute->join(clusterAsyncCommands, commandBuffer);
+        m_stats.asyncComputePasses++;
+    }
+    m_gpuPassProfiler->attach(renderPass, GPUPass::Main);
+    ParallelPassEncoder mainPassEncoder(commandBuffer, renderPass, mainDraws.size(), setupMainEncoder);
+    m_gpuPassProfiler->detach(renderPass);
+    MTL::RenderCommandEncoder* encoder = mainPassEncoder.encoder();
+    if (useRateMap && usePrepassDepth) {
+        m_variableRateShading->encodeDepthPrime(encoder, m_depthTexture);
+        encoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
+    }
+
+    // Draw skybox first
+    renderSkybox(encoder, camera);
+    encoder->setDepthStencilState(m_depthStencilState);
+    encoder->setCullMode(MTL::CullModeBack);
+
+    // Static opaque geometry: one indirect range per material, ahead of anything blended.
+    if (useStaticScene) {
+        writeStaticSceneBindings(bufferSlot);
+        useStaticSceneResources(encoder, bufferSlot, true);
+        const StaticSceneFrame& staticFrame = m_staticSceneFrames[bufferSlot];
+        if (useVisibility && !m_sceneResidency && !m_staticScene.meshResources.empty()) {
+            // visibilitySurface fetches the batches' vertices from the fragment stage.
+            encoder->useResources(m_staticScene.meshResources.data(), m_staticScene.meshResources.size(),
+                                  MTL::ResourceUsageRead, MTL::RenderStageFragment);
+        }
+        for (size_t groupIndex = 0; groupIndex < m_staticScene.groups.size(); ++groupIndex) {
+            const StaticSceneGroup& group = m_staticScene.groups[groupIndex];
+            Material* material = group.material.get();
+            if (useVisibility) {
+                // Bound first: the group's meshlets sample the same textures.
+                const uint32_t textureBinds = bindMainMaterialTextures(encoder, material);
+                if (encodeStaticVisibility(encoder, bufferSlot, groupIndex, viewport)) {
+                    GPUPassWork groupWork;
+                    groupWork.draws = 1;
+                    groupWork.pipelineBinds = 1;
+                    groupWork.textureBinds = textureBinds;
+                    m_gpuPassProfiler->recordWork(GPUPass::Main, groupWork);
+                    encoder->setCullMode(ResolveCullMode(material));
+                    encodeStaticMeshlets(encoder, bufferSlot, groupIndex, frustumPlanes, cullScreenSize, canBuildHzb);
+                    continue;
+                }
+            }
+            bool alphaToCoverage = material && material->getRenderMode() == Material::RenderMode::Cutout
+                && material->getAlphaToCoverage();
+            PipelineStateKey pipelineKey{true, true, true, false, false, true, alphaToCoverage, m_outputHDR, static_cast<uint8_t>(m_msaaSamples)};
+            pipelineKey.pbrFeatures |= pbrPrecisionFeatures();
+            MTL::RenderPipelineState* pipelineState = getPipelineState(pipelineKey);
+            if (!pipelineState) {
+                continue;
+            }
+            encoder->setRenderPipelineState(pipelineState);
+            GPUPassWork groupWork;
+            groupWork.draws = 1;
+            groupWork.pipelineBinds = 1;
+            groupWork.textureBinds = bindMainMaterialTextures(encoder, material);
+            m_gpuPassProfiler->recordWork(GPUPass::Main, groupWork);
+            encoder->setCullMode(ResolveCullMode(material));
+            encoder->executeCommandsInBuffer(staticFrame.mainCommands,
+                                             NS::Range::Make(group.firstBatch, group.batchCount));
+            m_stats.drawCalls++;
+            encodeStaticMeshlets(encoder, bufferSlot, groupIndex, frustumPlanes, cullScreenSize, canBuildHzb);
         }
-        ProbeVolumeUniformsGPU probeUniforms{};
-        probeUniforms.boundsMin = m_probeVolumeBoundsMin;
-        probeUniforms.boundsMax = m_probeVolumeBoundsMax;
-        probeUniforms.gridCounts = m_probeVolumeGridCounts;
-        probeUniforms.featureParams = m_probeVolumeFeatureParams;
-        probeUniforms.blendParams = m_probeVolumeBlendParams;
-        probeUniforms.reflectionParams = m_probeVolumeReflectionParams;
-        encoder->setFragmentBytes(&probeUniforms, sizeof(ProbeVolumeUniformsGPU), 10);
-        MTL::Buffer* probeBuffer = m_probeVolumeBuffer ? m_probeVolumeBuffer : m_probeVolumeFallbackBuffer;
-        encoder->setFragmentBuffer(probeBuffer, 0, 11);
-        encoder->setCullMode(resolveCullMode(material.get()));
-        
-        // Draw
-        encoder->drawIndexedPrimitives(
-            MTL::PrimitiveTypeTriangle,
-            mesh->getIndices().size(),
-            MTL::IndexTypeUInt32,
-            indexBuffer,
-            0
-        );
-        
-        renderedCount++;
-        m_stats.drawCalls++;
-        m_stats.triangles += mesh->getIndices().size() / 3;
-        m_stats.vertices += mesh->getVertices().size();
+        encoder->setCullMode(MTL::CullModeBack);
     }
 
+    // Render all mesh renderers
+    mainPassEncoder.encodeRange(mainDraws.size(), [&](MTL::RenderCommandEncoder* enc, size_t begin, size_t end) {
+        PassEncodeState state;
+        state.uniforms = UniformRing::Binder(frameUniforms);
+        for (size_t i = begin; i < end; ++i) {
+            encodeMainDraw(enc, mainDraws[i], state);
+        }
+        m_gpuPassProfiler->recordWork(GPUPass::Main, state.work);
+        stateBinds.fetch_add(state.binds, std::memory_order_relaxed);
+        stateBindsSkipped.fetch_add(state.skipped, std::memory_order_relaxed);
+    });
+    m_stats.parallelEncoders += static_cast<uint32_t>(mainPassEncoder.parallelEncoderCount());
+    m_stats.drawStateBinds += stateBinds.load(std::memory_order_relaxed);
+    m_stats.drawStateBindsSkipped += stateBindsSkipped.load(std::memory_order_relaxed);
+    encoder = mainPassEncoder.encoder();
+
     if (useGpuInstanceCulling && m_instanceCullBuffer && m_instanceIndirectBuffer) {
         for (size_t i = 0; i < instancedBatches.size(); ++i) {
             const auto& batch = instancedBatches[i];
@@ -6083,7 +9260,12 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
 
             bool alphaToCoverage = batch.material && batch.material->getRenderMode() == Material::RenderMode::Cutout
                 && batch.material->getAlphaToCoverage();
-            PipelineStateKey pipelineKey{true, true, true, batch.isTransparent, false, true, alphaToCoverage, m_outputHDR, static_cast<uint8_t>(m_msaaSamples)};
+            MTL::Buffer* crowdWeights = batch.isSkinned ? static_cast<MTL::Buffer*>(batch.mesh->getSkinWeightBuffer()) : nullptr;
+            Texture2D* vertexAnimation = crowdWeights ? nullptr : batch.vertexAnimation;
+            PipelineStateKey pipelineKey{true, true, true, batch.isTransparent, crowdWeights != nullptr, true, alphaToCoverage, m_outputHDR, static_cast<uint8_t>(m_msaaSamples)};
+            pipelineKey.isVertexAnimated = vertexAnimation != nullptr;
+            pipelineKey.pbrFeatures |= pbrPrecisionFeatures();
+            pipelineKey.isTerrain = batch.terrainHeights != nullptr;
             MTL::RenderPipelineState* pipelineState = getPipelineState(pipelineKey);
             if (!pipelineState) {
                 continue;
@@ -6146,11 +9328,13 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 );
                 bool alphaClip = batch.material->getRenderMode() == Material::RenderMode::Cutout;
                 float alphaCutoff = batch.material->getAlphaCutoff();
+                const auto& normalMapTex = batch.material->getNormalTexture();
+                bool normalLengthInAlpha = normalMapTex && normalMapTex->hasNormalLengthInAlpha();
                 matUniforms.textureFlags3 = Math::Vector4(
                     hasORMTex ? 1.0f : 0.0f,
                     alphaClip ? 1.0f : 0.0f,
                     alphaCutoff,
-                    0.0f
+                    normalLengthInAlpha ? 1.0f : 0.0f
                 );
                 matUniforms.heightParams = Math::Vector4(
                     batch.material->getHeightScale(),
@@ -6195,7 +9379,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 matUniforms.terrainParams1 = Math::Vector4(
                     batch.material->getTerrainSlopeStart(),
                     batch.material->getTerrainSlopeEnd(),
-                    0.0f,
+                    terrainVirtualTextureSlot(batch.material.get()),
                     0.0f
                 );
                 Math::Vector2 terrain0ST = batch.material->getTerrainLayer0Tiling();
@@ -6261,18 +9445,16 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 encoder->setFragmentTexture(m_defaultHeightTexture ? m_defaultHeightTexture->getHandle() : nullptr, 32);
                 encoder->setFragmentTexture(m_defaultWhiteTexture ? m_defaultWhiteTexture->getHandle() : nullptr, 33);
 
-                if (m_hasIBL && m_iblIrradiance && m_iblPrefiltered && m_iblBRDFLUT) {
-                    encoder->setFragmentTexture(m_iblIrradiance, 8);
-                    encoder->setFragmentTexture(m_iblPrefiltered, 9);
-                    encoder->setFragmentTexture(m_iblBRDFLUT, 10);
-                }
+                bindEnvironmentLighting(encoder);
 
                 if (m_samplerState) {
                     encoder->setFragmentSamplerState(m_samplerState, 0);
                 }
             }
 
-            encoder->setVertexBuffer(vertexBuffer, 0, 0);
+            encoder->setVertexBuffer(vertexBuffer, batch.mesh->getVertexBufferOffset(), 0);
+            encoder->setVertexBuffer(static_cast<MTL::Buffer*>(batch.mesh->getAttributeBuffer()), batch.mesh->getAttributeBufferOffset(),
+                                     GeometryBuffer::kAttributeBufferIndex);
             encoder->setVertexBuffer(m_instanceCullBuffer, batch.outputOffset * sizeof(InstanceDataGPU), 1);
             encoder->setVertexBuffer(m_cameraUniformBuffer, 0, 2);
 
@@ -6293,6 +9475,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             }
             if (m_shadowPass) {
                 encoder->setFragmentTexture(m_shadowPass->getShadowAtlas(), 11);
+                encoder->setFragmentTexture(m_shadowPass->getDepthBounds(), 37);
                 const auto& cubes = m_shadowPass->getPointCubeTextures();
                 for (size_t j = 0; j < cubes.size() && j < 4; ++j) {
                     if (cubes[j]) {
@@ -6300,16 +9483,14 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                     }
                 }
             }
+            if (m_dynamicProbeGI) {
+                encoder->setFragmentTexture(m_dynamicProbeGI->getReflectionCaptures(), 38);
+            }
             if (m_shadowSampler) {
                 encoder->setFragmentSamplerState(m_shadowSampler, 2);
             }
             ProbeVolumeUniformsGPU probeUniforms{};
-            probeUniforms.boundsMin = m_probeVolumeBoundsMin;
-            probeUniforms.boundsMax = m_probeVolumeBoundsMax;
-            probeUniforms.gridCounts = m_probeVolumeGridCounts;
-            probeUniforms.featureParams = m_probeVolumeFeatureParams;
-            probeUniforms.blendParams = m_probeVolumeBlendParams;
-            probeUniforms.reflectionParams = m_probeVolumeReflectionParams;
+            fillProbeVolumeUniforms(probeUniforms);
             encoder->setFragmentBytes(&probeUniforms, sizeof(ProbeVolumeUniformsGPU), 10);
             MTL::Buffer* probeBuffer = m_probeVolumeBuffer ? m_probeVolumeBuffer : m_probeVolumeFallbackBuffer;
             encoder->setFragmentBuffer(probeBuffer, 0, 11);
@@ -6322,25 +9503,35 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             if (m_clusterParamsBuffer) {
                 encoder->setFragmentBuffer(m_clusterParamsBuffer, 0, 9);
             }
-            encoder->setCullMode(resolveCullMode(batch.material.get()));
+            encoder->setCullMode(ResolveCullMode(batch.material.get()));
+            if (crowdWeights) {
+                encoder->setVertexBuffer(crowdWeights, batch.mesh->getSkinWeightBufferOffset(), GeometryBuffer::kSkinWeightBufferIndex);
+                encoder->setVertexBuffer(m_crowdAnimation->getPaletteBuffer(), 0, 3);
+            } else if (vertexAnimation) {
+                encoder->setVertexBytes(&batch.vertexAnimationParams, sizeof(VertexAnimationParamsGPU), 5);
+                encoder->setVertexTexture(vertexAnimation->getHandle(), 0);
+            } else if (batch.terrainHeights) {
+                encoder->setVertexBytes(&batch.terrainParams, sizeof(TerrainParamsGPU), 5);
+                encoder->setVertexTexture(batch.terrainHeights, 0);
+            }
 
             encoder->drawIndexedPrimitives(
                 MTL::PrimitiveTypeTriangle,
                 MTL::IndexTypeUInt32,
                 indexBuffer,
-                0,
+                batch.mesh->getIndexBufferOffset(),
                 m_instanceIndirectBuffer,
                 i * sizeof(DrawIndexedIndirectArgs)
             );
 
             renderedCount += static_cast<int>(batch.inputCount);
             m_stats.drawCalls++;
-            m_stats.triangles += (batch.mesh->getIndices().size() / 3) * batch.inputCount;
-            m_stats.vertices += batch.mesh->getVertices().size() * batch.inputCount;
+            m_stats.triangles += (batch.mesh->getIndexCount() / 3) * batch.inputCount;
+            m_stats.vertices += batch.mesh->getVertexCount() * batch.inputCount;
         }
     } else {
         for (const auto& draw : instancedDraws) {
-            if (!draw.mesh || draw.instanceCount == 0) {
+            if (!draw.mesh || draw.instanceCount == 0 || !draw.instanceBuffer) {
                 continue;
             }
 
@@ -6352,7 +9543,12 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
 
             bool alphaToCoverage = draw.material && draw.material->getRenderMode() == Material::RenderMode::Cutout
                 && draw.material->getAlphaToCoverage();
-            PipelineStateKey pipelineKey{true, true, true, draw.isTransparent, false, true, alphaToCoverage, m_outputHDR, static_cast<uint8_t>(m_msaaSamples)};
+            MTL::Buffer* crowdWeights = draw.isSkinned ? static_cast<MTL::Buffer*>(draw.mesh->getSkinWeightBuffer()) : nullptr;
+            Texture2D* vertexAnimation = crowdWeights ? nullptr : draw.vertexAnimation;
+            PipelineStateKey pipelineKey{true, true, true, draw.isTransparent, crowdWeights != nullptr, true, alphaToCoverage, m_outputHDR, static_cast<uint8_t>(m_msaaSamples)};
+            pipelineKey.isVertexAnimated = vertexAnimation != nullptr;
+            pipelineKey.pbrFeatures |= pbrPrecisionFeatures();
+            pipelineKey.isTerrain = draw.terrainHeights != nullptr;
             MTL::RenderPipelineState* pipelineState = getPipelineState(pipelineKey);
             if (!pipelineState) {
                 continue;
@@ -6415,11 +9611,13 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 );
                 bool alphaClip = draw.material->getRenderMode() == Material::RenderMode::Cutout;
                 float alphaCutoff = draw.material->getAlphaCutoff();
+                const auto& normalMapTex = draw.material->getNormalTexture();
+                bool normalLengthInAlpha = normalMapTex && normalMapTex->hasNormalLengthInAlpha();
                 matUniforms.textureFlags3 = Math::Vector4(
                     hasORMTex ? 1.0f : 0.0f,
                     alphaClip ? 1.0f : 0.0f,
                     alphaCutoff,
-                    0.0f
+                    normalLengthInAlpha ? 1.0f : 0.0f
                 );
                 matUniforms.heightParams = Math::Vector4(
                     draw.material->getHeightScale(),
@@ -6464,7 +9662,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 matUniforms.terrainParams1 = Math::Vector4(
                     draw.material->getTerrainSlopeStart(),
                     draw.material->getTerrainSlopeEnd(),
-                    0.0f,
+                    terrainVirtualTextureSlot(draw.material.get()),
                     0.0f
                 );
                 Math::Vector2 terrain0ST = draw.material->getTerrainLayer0Tiling();
@@ -6530,19 +9728,17 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 encoder->setFragmentTexture(m_defaultHeightTexture ? m_defaultHeightTexture->getHandle() : nullptr, 32);
                 encoder->setFragmentTexture(m_defaultWhiteTexture ? m_defaultWhiteTexture->getHandle() : nullptr, 33);
 
-                if (m_hasIBL && m_iblIrradiance && m_iblPrefiltered && m_iblBRDFLUT) {
-                    encoder->setFragmentTexture(m_iblIrradiance, 8);
-                    encoder->setFragmentTexture(m_iblPrefiltered, 9);
-                    encoder->setFragmentTexture(m_iblBRDFLUT, 10);
-                }
+                bindEnvironmentLighting(encoder);
 
                 if (m_samplerState) {
                     encoder->setFragmentSamplerState(m_samplerState, 0);
                 }
             }
 
-            encoder->setVertexBuffer(vertexBuffer, 0, 0);
-            encoder->setVertexBuffer(m_instanceBuffer, draw.instanceOffset, 1);
+            encoder->setVertexBuffer(vertexBuffer, draw.mesh->getVertexBufferOffset(), 0);
+            encoder->setVertexBuffer(static_cast<MTL::Buffer*>(draw.mesh->getAttributeBuffer()), draw.mesh->getAttributeBufferOffset(),
+                                     GeometryBuffer::kAttributeBufferIndex);
+            encoder->setVertexBuffer(draw.instanceBuffer, draw.instanceOffset, 1);
             encoder->setVertexBuffer(m_cameraUniformBuffer, 0, 2);
 
             encoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
@@ -6562,6 +9758,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             }
             if (m_shadowPass) {
                 encoder->setFragmentTexture(m_shadowPass->getShadowAtlas(), 11);
+                encoder->setFragmentTexture(m_shadowPass->getDepthBounds(), 37);
                 const auto& cubes = m_shadowPass->getPointCubeTextures();
                 for (size_t i = 0; i < cubes.size() && i < 4; ++i) {
                     if (cubes[i]) {
@@ -6569,16 +9766,14 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                     }
                 }
             }
+            if (m_dynamicProbeGI) {
+                encoder->setFragmentTexture(m_dynamicProbeGI->getReflectionCaptures(), 38);
+            }
             if (m_shadowSampler) {
                 encoder->setFragmentSamplerState(m_shadowSampler, 2);
             }
             ProbeVolumeUniformsGPU probeUniforms{};
-            probeUniforms.boundsMin = m_probeVolumeBoundsMin;
-            probeUniforms.boundsMax = m_probeVolumeBoundsMax;
-            probeUniforms.gridCounts = m_probeVolumeGridCounts;
-            probeUniforms.featureParams = m_probeVolumeFeatureParams;
-            probeUniforms.blendParams = m_probeVolumeBlendParams;
-            probeUniforms.reflectionParams = m_probeVolumeReflectionParams;
+            fillProbeVolumeUniforms(probeUniforms);
             encoder->setFragmentBytes(&probeUniforms, sizeof(ProbeVolumeUniformsGPU), 10);
             MTL::Buffer* probeBuffer = m_probeVolumeBuffer ? m_probeVolumeBuffer : m_probeVolumeFallbackBuffer;
             encoder->setFragmentBuffer(probeBuffer, 0, 11);
@@ -6591,24 +9786,41 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             if (m_clusterParamsBuffer) {
                 encoder->setFragmentBuffer(m_clusterParamsBuffer, 0, 9);
             }
-            encoder->setCullMode(resolveCullMode(draw.material.get()));
+            encoder->setCullMode(ResolveCullMode(draw.material.get()));
+            if (crowdWeights) {
+                encoder->setVertexBuffer(crowdWeights, draw.mesh->getSkinWeightBufferOffset(), GeometryBuffer::kSkinWeightBufferIndex);
+                encoder->setVertexBuffer(m_crowdAnimation->getPaletteBuffer(), 0, 3);
+            } else if (vertexAnimation) {
+                encoder->setVertexBytes(&draw.vertexAnimationParams, sizeof(VertexAnimationParamsGPU), 5);
+                encoder->setVertexTexture(vertexAnimation->getHandle(), 0);
+            } else if (draw.terrainHeights) {
+                encoder->setVertexBytes(&draw.terrainParams, sizeof(TerrainParamsGPU), 5);
+                encoder->setVertexTexture(draw.terrainHeights, 0);
+            }
 
             encoder->drawIndexedPrimitives(
                 MTL::PrimitiveTypeTriangle,
-                draw.mesh->getIndices().size(),
+                draw.mesh->getIndexCount(),
                 MTL::IndexTypeUInt32,
                 indexBuffer,
-                0,
+                draw.mesh->getIndexBufferOffset(),
                 draw.instanceCount
             );
 
             renderedCount += static_cast<int>(draw.instanceCount);
             m_stats.drawCalls++;
-            m_stats.triangles += (draw.mesh->getIndices().size() / 3) * draw.instanceCount;
-            m_stats.vertices += draw.mesh->getVertices().size() * draw.instanceCount;
+            m_stats.triangles += (draw.mesh->getIndexCount() / 3) * draw.instanceCount;
+            m_stats.vertices += draw.mesh->getVertexCount() * draw.instanceCount;
         }
     }
     
+    // Particles blend over everything else the pass draws, tested against its depth without writing it.
+    if (m_particleSystem && m_particleSystem->isAvailable()) {
+        MTL::Texture* colorAttachment = renderPass->colorAttachments()->object(0)->texture();
+        m_particleSystem->draw(encoder, static_cast<uint32_t>(colorAttachment->pixelFormat()),
+                               static_cast<uint32_t>(colorAttachment->sampleCount()), m_depthReadState);
+    }
+
     // === DEBUG RENDERING ===
     // NOTE: Wire/gizmo now drawn by Engine::render() BEFORE this function
     // Only selected entities get wireframe - drawn in Engine, not here!
@@ -6618,87 +9830,151 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             m_lightingSystem->buildLightGizmos(*m_debugRenderer, m_debugDrawCascades);
         }
         #endif
-        // Update debug uniforms and buffers
+        if (m_debugDrawGPUPasses) {
+            drawGPUPassBars(camera);
+        }
+        // Upload this view's debug uniforms and geometry into the frame slot's buffer
         m_debugRenderer->render(
-            nullptr,
+            bufferSlot,
             camera->getViewMatrix(),
             camera->getProjectionMatrix(),
-            camera->getEntity()->getTransform()->getPosition()
+            camera->getEntity()->getTransform()->getPosition(),
+            static_cast<float>(viewport.width),
+            static_cast<float>(viewport.height)
         );
+        MTL::Buffer* debugBuffer = m_debugRenderer->getFrameBuffer();
+        const size_t debugUniformOffset = m_debugRenderer->getUniformOffset();
         
         // Render grid (disable depth write, always pass depth test)
-        if (m_debugRenderer->isGridEnabled() && m_debugGridPipelineState && m_debugRenderer->getGridVertexCount() > 0) {
+        if (debugBuffer && m_debugRenderer->isGridEnabled() && m_debugGridPipelineState && m_debugRenderer->getGridVertexCount() > 0) {
             encoder->setRenderPipelineState(m_debugGridPipelineState);
             encoder->setDepthStencilState(m_debugGridDepthState);
             encoder->setCullMode(MTL::CullModeNone);  
-            encoder->setVertexBuffer((MTL::Buffer*)m_debugRenderer->getGridBuffer(), 0, 0);
-            encoder->setVertexBuffer((MTL::Buffer*)m_debugRenderer->getUniformBuffer(), 0, 1);
-            encoder->setFragmentBuffer((MTL::Buffer*)m_debugRenderer->getUniformBuffer(), 0, 1);
+            encoder->setVertexBuffer(debugBuffer, m_debugRenderer->getGridOffset(), 0);
+            encoder->setVertexBuffer(debugBuffer, debugUniformOffset, 1);
+            encoder->setFragmentBuffer(debugBuffer, debugUniformOffset, 1);
             encoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), 
                                    NS::UInteger(m_debugRenderer->getGridVertexCount()));
         }
         
-        // Render debug lines (disable depth write, always pass depth test)
-        if (m_debugRenderer->getLineCount() > 0 && m_debugLinePipelineState) {
-            encoder->setRenderPipelineState(m_debugLinePipelineState);
+        // Render debug lines and shapes as screen-space quads (no depth write, biased towards the camera)
+        const auto& debugBoxes = m_debugRenderer->getShapeBatch(DebugRenderer::ShapeKind::Box);
+        const auto& debugSpheres = m_debugRenderer->getShapeBatch(DebugRenderer::ShapeKind::Sphere);
+        const bool drawDebugLines = m_debugRenderer->getLineCount() > 0 && m_debugLinePipelineState;
+        const bool drawDebugShapes = (debugBoxes.instanceCount > 0 || debugSpheres.instanceCount > 0)
+            && m_debugShapePipelineState;
+        if (debugBuffer && (drawDebugLines || drawDebugShapes)) {
             encoder->setDepthStencilState(m_debugLineDepthState);
             encoder->setDepthBias(-1.0f, -1.0f, -1.0f);
             encoder->setCullMode(MTL::CullModeNone);  
-            encoder->setVertexBuffer((MTL::Buffer*)m_debugRenderer->getLineBuffer(), 0, 0);
-            encoder->setVertexBuffer((MTL::Buffer*)m_debugRenderer->getUniformBuffer(), 0, 1);
-            encoder->drawPrimitives(MTL::PrimitiveTypeLine, NS::UInteger(0), 
-                                   NS::UInteger(m_debugRenderer->getLineCount()));
+            encoder->setVertexBuffer(debugBuffer, debugUniformOffset, 1);
+            if (drawDebugLines) {
+                encoder->setRenderPipelineState(m_debugLinePipelineState);
+                encoder->setVertexBuffer(debugBuffer, m_debugRenderer->getLineOffset(), 0);
+                encoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(6),
+                                        NS::UInteger(m_debugRenderer->getLineCount()));
+            }
+            if (drawDebugShapes) {
+                encoder->setRenderPipelineState(m_debugShapePipelineState);
+                encoder->setVertexBuffer(debugBuffer, m_debugRenderer->getShapeOffset(), 0);
+                for (DebugRenderer::ShapeKind kind : {DebugRenderer::ShapeKind::Box, DebugRenderer::ShapeKind::Sphere}) {
+                    const auto& batch = m_debugRenderer->getShapeBatch(kind);
+                    if (batch.instanceCount == 0 || batch.edgesPerInstance == 0) {
+                        continue;
+                    }
+                    const uint32_t kindValue = static_cast<uint32_t>(kind);
+                    encoder->setVertexBytes(&kindValue, sizeof(kindValue), 2);
+                    encoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0),
+                                            NS::UInteger(batch.edgesPerInstance * 6),
+                                            NS::UInteger(batch.instanceCount),
+                                            NS::UInteger(batch.firstInstance));
+                }
+            }
+            encoder->setDepthBias(0.0f, 0.0f, 0.0f);
+        }
+
+        // Mesh wireframes redraw the selected meshes' triangles, shading only near their edges
+        const auto& meshWires = m_debugRenderer->getMeshWires();
+        if (debugBuffer && !meshWires.empty() && m_debugMeshWirePipelineState) {
+            encoder->setRenderPipelineState(m_debugMeshWirePipelineState);
+            encoder->setDepthStencilState(m_debugLineDepthState);
+            encoder->setDepthBias(-1.0f, -1.0f, -1.0f);
+            encoder->setCullMode(MTL::CullModeNone);
+            encoder->setVertexBuffer(debugBuffer, debugUniformOffset, 1);
+            encoder->setFragmentBuffer(debugBuffer, debugUniformOffset, 1);
+            for (const DebugRenderer::MeshWire& wire : meshWires) {
+                Mesh* mesh = wire.mesh.get();
+                MTL::Buffer* indexBuffer = static_cast<MTL::Buffer*>(mesh->getIndexBuffer());
+                if (!mesh->isUploaded() || !indexBuffer || mesh->getIndexCount() == 0) {
+                    continue;
+                }
+                encoder->setVertexBuffer(static_cast<MTL::Buffer*>(mesh->getVertexBuffer()),
+                                         mesh->getVertexBufferOffset(), 0);
+                encoder->setVertexBytes(&wire.params, sizeof(wire.params), 2);
+                encoder->drawIndexedPrimitives(MTL::PrimitiveTypeTriangle, mesh->getIndexCount(),
+                                               MTL::IndexTypeUInt32, indexBuffer, mesh->getIndexBufferOffset());
+            }
             encoder->setDepthBias(0.0f, 0.0f, 0.0f);
         }
     }
     
-    encoder->endEncoding();
-
-    MTL::Texture* sceneColorForPost = m_colorTexture;
-    bool useSSR = ssrEnabled && runPrepass && m_ssrPipelineState
-        && m_postColorTexture && m_colorTexture && m_depthTexture && m_normalTexture;
-    if (useSSR) {
-        float maxDistance = std::min(100.0f, camera->getFarClip() * 0.5f);
-        float thickness = std::max(0.001f, post.ssrThickness);
-        SSRParamsGPU ssrParams{};
-        ssrParams.settings0 = Math::Vector4(
-            1.0f / static_cast<float>(renderWidth),
-            1.0f / static_cast<float>(renderHeight),
-            thickness,
-            64.0f
-        );
-        ssrParams.settings1 = Math::Vector4(
-            maxDistance,
-            std::max(0.0f, std::min(1.0f, post.ssrMaxRoughness)),
-            0.0f,
-            maxDistance
-        );
-
-        MTL::RenderPassDescriptor* ssrPass = MTL::RenderPassDescriptor::alloc()->init();
-        ssrPass->colorAttachments()->object(0)->setTexture(m_postColorTexture);
-        ssrPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
-        ssrPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
-        ssrPass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 1.0));
+    mainPassEncoder.end();
+    if (useRateMap) {
+        m_variableRateShading->encodeResolve(commandBuffer, m_colorTexture);
+    }
 
-        MTL::RenderCommandEncoder* ssrEncoder = commandBuffer->renderCommandEncoder(ssrPass);
-        ssrEncoder->setRenderPipelineState(m_ssrPipelineState);
-        ssrEncoder->setViewport(viewport);
-        ssrEncoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
-        ssrEncoder->setFragmentBytes(&ssrParams, sizeof(SSRParamsGPU), 1);
-        ssrEncoder->setFragmentTexture(m_colorTexture, 0);
-        ssrEncoder->setFragmentTexture(m_depthTexture, 1);
-        ssrEncoder->setFragmentTexture(m_normalTexture, 2);
-        if (m_linearClampSampler) {
-            ssrEncoder->setFragmentSamplerState(m_linearClampSampler, 0);
+    // Order-independent layers: accumulate each set against the main pass depth, then blend them
+    // over the scene colour. Should the targets fail to allocate, the layers are skipped this frame.
+    const bool drawWeighted = !weightedDraws.empty();
+    const bool drawLowRes = !lowResDraws.empty();
+    if ((drawWeighted || drawLowRes)
+        && m_weightedTransparency->prepare(static_cast<uint32_t>(m_colorTexture->width()),
+                                           static_cast<uint32_t>(m_colorTexture->height()),
+                                           static_cast<uint32_t>(m_colorTexture->pixelFormat()),
+                                           drawWeighted, drawLowRes)) {
+        if (drawLowRes) {
+            m_weightedTransparency->encodeDepthDownsample(commandBuffer, m_depthTexture, viewport);
         }
-        ssrEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
-        ssrEncoder->endEncoding();
-        ssrPass->release();
-
-        sceneColorForPost = m_postColorTexture;
+        auto encodeWeightedLayers = [&](FrameVector<PassDraw>& draws, bool lowResolution) {
+            if (draws.empty()) {
+                return;
+            }
+            MTL::RenderPassDescriptor* layerPass = m_weightedTransparency->newAccumulationPass(lowResolution, m_depthTexture);
+            if (!layerPass) {
+                return;
+            }
+            const MTL::Viewport layerViewport = lowResolution
+                ? WeightedTransparency::LowResolutionViewport(viewport)
+                : viewport;
+            auto setupLayerEncoder = [&](MTL::RenderCommandEncoder* enc) {
+                setupMainEncoder(enc);
+                enc->setDepthStencilState(m_depthReadState);
+                enc->setViewport(layerViewport);
+            };
+            ParallelPassEncoder layerEncoder(commandBuffer, layerPass, draws.size(), setupLayerEncoder);
+            layerPass->release();
+            layerEncoder.encodeRange(draws.size(), [&](MTL::RenderCommandEncoder* enc, size_t begin, size_t end) {
+                PassEncodeState state;
+                state.uniforms = UniformRing::Binder(frameUniforms);
+                for (size_t i = begin; i < end; ++i) {
+                    encodeMainDraw(enc, draws[i], state);
+                }
+                m_gpuPassProfiler->recordWork(GPUPass::Main, state.work);
+            });
+            m_stats.parallelEncoders += static_cast<uint32_t>(layerEncoder.parallelEncoderCount());
+            layerEncoder.end();
+        };
+        encodeWeightedLayers(lowResDraws, true);
+        encodeWeightedLayers(weightedDraws, false);
+        m_weightedTransparency->encodeComposite(commandBuffer, m_colorTexture, m_depthTexture, viewport,
+                                                camera->getNearClip(), camera->getFarClip(),
+                                                drawWeighted, drawLowRes);
     }
 
+    CRESCENT_PROFILE_NEXT(profilePhase, "Renderer::postProcess");
+    MTL::Texture* sceneColorForPost = m_colorTexture;
     FogParamsGPU fogParams{};
+    uint32_t fogInterleave = 1;
     if (fogEnabled) {
         fogParams.fogColorDensity = Math::Vector4(
             fog.color.x,
@@ -6774,6 +10050,18 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             m_prevFogViewMatrix = viewMatrix;
         }
 
+        // Interleaved updates light each froxel every fogInterleave frames; compounding the blend
+        // keeps the history response per frame. Without history every froxel is lit.
+        if (historyValid > 0.5f) {
+            fogInterleave = 1u << std::max(0, std::min(2, fog.volumetricUpdateRate));
+            historyWeight = std::pow(historyWeight, static_cast<float>(fogInterleave));
+        }
+        fogParams.updateParams = Math::Vector4(
+            static_cast<float>(fogInterleave),
+            static_cast<float>(m_frameIndex % fogInterleave),
+            0.0f,
+            0.0f
+        );
         fogParams.volumeParams = Math::Vector4(
             nearPlane,
             farPlane,
@@ -6808,7 +10096,8 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
 
     bool buildFogVolume = fogEnabled && m_fogVolumePipelineState && m_fogVolumeTexture;
     if (buildFogVolume) {
-        MTL::ComputeCommandEncoder* fogCompute = commandBuffer->computeCommandEncoder();
+        MTL::CommandBuffer* fogCommands = fogAsyncCommands ? fogAsyncCommands : commandBuffer;
+        MTL::ComputeCommandEncoder* fogCompute = m_gpuPassProfiler->computeEncoder(fogCommands, GPUPass::Fog);
         fogCompute->setComputePipelineState(m_fogVolumePipelineState);
         fogCompute->setTexture(m_fogVolumeTexture, 0);
         fogCompute->setTexture(m_fogVolumeHistoryTexture, 1);
@@ -6834,18 +10123,132 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         );
         fogCompute->dispatchThreadgroups(threadgroups, threadsPerGroup);
         fogCompute->endEncoding();
+        m_stats.fogFroxels = m_fogVolumeWidth * m_fogVolumeHeight * m_fogVolumeDepth;
+        m_stats.fogFroxelsLit = (m_stats.fogFroxels + fogInterleave - 1) / fogInterleave;
+        if (fogAsyncCommands) {
+            m_stats.asyncComputePasses++;
+        }
+    }
+    if (fogAsyncCommands) {
+        m_asyncCompute->join(fogAsyncCommands, commandBuffer);
     }
 
+    bool useSSR = ssrEnabled && runPrepass && m_ssrPipelineState && m_ssrHizInitPipeline && m_ssrHizDownsamplePipeline
+        && m_ssrTracePipeline && m_ssrTemporalPipeline && m_ssrHizTexture && !m_ssrHizMipViews.empty()
+        && m_ssrTraceTexture && m_ssrHistoryTexture && m_ssrAccumTexture
+        && m_postColorTexture && m_colorTexture && m_depthTexture && m_normalTexture;
     bool useFog = buildFogVolume && runPrepass && m_fogPipelineState && m_fogTexture
         && sceneColorForPost && m_depthTexture;
-    if (useFog) {
+    // Both only shade the pixel they write, so SSR applies the fog itself when both run.
+    bool fuseFogIntoSSR = useSSR && useFog && m_ssrFogPipelineState;
+    if (useSSR) {
+        float maxDistance = std::min(100.0f, camera->getFarClip() * 0.5f);
+        float thickness = std::max(0.001f, post.ssrThickness);
+        SSRParamsGPU ssrParams{};
+        ssrParams.prevViewProjection = m_prevViewProjectionNoJitter;
+        ssrParams.settings0 = Math::Vector4(
+            1.0f / static_cast<float>(renderWidth),
+            1.0f / static_cast<float>(renderHeight),
+            thickness,
+            64.0f
+        );
+        ssrParams.settings1 = Math::Vector4(
+            maxDistance,
+            std::max(0.0f, std::min(1.0f, post.ssrMaxRoughness)),
+            0.0f,
+            maxDistance
+        );
+        ssrParams.settings2 = Math::Vector4(
+            static_cast<float>(m_frameIndex % 1024),
+            static_cast<float>(m_ssrHizMipViews.size()),
+            (m_ssrHistoryValid && m_motionHistoryValid) ? 1.0f : 0.0f,
+            0.9f
+        );
+        ssrParams.settings3 = Math::Vector4(runVelocity ? 1.0f : 0.0f, 0.0f, 0.0f, 0.0f);
+
+        // Closest-depth pyramid, one traced ray per 2x2 quad at half resolution, then the temporal
+        // accumulation the composite below filters and upsamples.
+        MTL::Size threadsPerGroup = MTL::Size::Make(8, 8, 1);
+        MTL::Size ssrGroups = MTL::Size::Make((m_ssrWidth + 7) / 8, (m_ssrHeight + 7) / 8, 1);
+        MTL::ComputeCommandEncoder* ssrCompute = m_gpuPassProfiler->computeEncoder(commandBuffer, GPUPass::SSR);
+        ssrCompute->setComputePipelineState(m_ssrHizInitPipeline);
+        ssrCompute->setTexture(m_depthTexture, 0);
+        ssrCompute->setTexture(m_ssrHizMipViews[0], 1);
+        ssrCompute->dispatchThreadgroups(ssrGroups, threadsPerGroup);
+        ssrCompute->setComputePipelineState(m_ssrHizDownsamplePipeline);
+        for (size_t mip = 1; mip < m_ssrHizMipViews.size(); ++mip) {
+            MTL::Texture* dst = m_ssrHizMipViews[mip];
+            ssrCompute->setTexture(m_ssrHizMipViews[mip - 1], 0);
+            ssrCompute->setTexture(dst, 1);
+            ssrCompute->dispatchThreadgroups(
+                MTL::Size::Make((dst->width() + 7) / 8, (dst->height() + 7) / 8, 1), threadsPerGroup);
+        }
+
+        ssrCompute->setComputePipelineState(m_ssrTracePipeline);
+        ssrCompute->setBuffer(m_cameraUniformBuffer, 0, 0);
+        ssrCompute->setBytes(&ssrParams, sizeof(SSRParamsGPU), 1);
+        ssrCompute->setTexture(m_colorTexture, 0);
+        ssrCompute->setTexture(m_depthTexture, 1);
+        ssrCompute->setTexture(m_normalTexture, 2);
+        ssrCompute->setTexture(m_ssrHizTexture, 3);
+        ssrCompute->setTexture(m_ssrTraceTexture, 4);
+        if (m_linearClampSampler) {
+            ssrCompute->setSamplerState(m_linearClampSampler, 0);
+        }
+        ssrCompute->dispatchThreadgroups(ssrGroups, threadsPerGroup);
+
+        ssrCompute->setComputePipelineState(m_ssrTemporalPipeline);
+        ssrCompute->setTexture(m_ssrTraceTexture, 0);
+        ssrCompute->setTexture(m_ssrHistoryTexture, 1);
+        ssrCompute->setTexture(runVelocity ? m_velocityTexture : m_ssrTraceTexture, 2);
+        ssrCompute->setTexture(m_ssrAccumTexture, 3);
+        ssrCompute->setTexture(m_depthTexture, 4);
+        ssrCompute->dispatchThreadgroups(ssrGroups, threadsPerGroup);
+        ssrCompute->endEncoding();
+
+        MTL::RenderPassDescriptor* ssrPass = MTL::RenderPassDescriptor::alloc()->init();
+        ssrPass->colorAttachments()->object(0)->setTexture(m_postColorTexture);
+        ssrPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
+        ssrPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
+        ssrPass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 1.0));
+
+        MTL::RenderCommandEncoder* ssrEncoder = m_gpuPassProfiler->renderEncoder(commandBuffer, ssrPass, GPUPass::SSR);
+        ssrEncoder->setRenderPipelineState(fuseFogIntoSSR ? m_ssrFogPipelineState : m_ssrPipelineState);
+        ssrEncoder->setViewport(viewport);
+        ssrEncoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
+        ssrEncoder->setFragmentBytes(&ssrParams, sizeof(SSRParamsGPU), 1);
+        ssrEncoder->setFragmentTexture(m_colorTexture, 0);
+        ssrEncoder->setFragmentTexture(m_depthTexture, 1);
+        ssrEncoder->setFragmentTexture(m_normalTexture, 2);
+        ssrEncoder->setFragmentTexture(m_ssrAccumTexture, 4);
+        if (fuseFogIntoSSR) {
+            ssrEncoder->setFragmentBytes(&fogParams, sizeof(FogParamsGPU), 2);
+            ssrEncoder->setFragmentTexture(m_fogVolumeTexture, 3);
+        }
+        if (m_linearClampSampler) {
+            ssrEncoder->setFragmentSamplerState(m_linearClampSampler, 0);
+        }
+        ssrEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
+        ssrEncoder->endEncoding();
+        ssrPass->release();
+
+        if (options.updateHistory) {
+            std::swap(m_ssrAccumTexture, m_ssrHistoryTexture);
+            m_ssrHistoryValid = true;
+        }
+        sceneColorForPost = m_postColorTexture;
+    } else {
+        m_ssrHistoryValid = false;
+    }
+
+    if (useFog && !fuseFogIntoSSR) {
         MTL::RenderPassDescriptor* fogPass = MTL::RenderPassDescriptor::alloc()->init();
         fogPass->colorAttachments()->object(0)->setTexture(m_fogTexture);
         fogPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
         fogPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
         fogPass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 1.0));
 
-        MTL::RenderCommandEncoder* fogEncoder = commandBuffer->renderCommandEncoder(fogPass);
+        MTL::RenderCommandEncoder* fogEncoder = m_gpuPassProfiler->renderEncoder(commandBuffer, fogPass, GPUPass::Fog);
         fogEncoder->setRenderPipelineState(m_fogPipelineState);
         fogEncoder->setViewport(viewport);
         fogEncoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
@@ -6863,11 +10266,13 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         fogPass->release();
 
         sceneColorForPost = m_fogTexture;
+    }
+    if (useFog) {
         m_fogVolumeHistoryValid = true;
         std::swap(m_fogVolumeTexture, m_fogVolumeHistoryTexture);
     }
 
-    bool useTAA = taaEnabled && runPrepass && m_taaPipelineState && m_depthTexture
+    bool useTAA = taaEnabled && runPrepass && (m_taaResolvePipeline || m_taaPipelineState) && m_depthTexture
         && m_taaHistoryTexture && m_taaCurrentTexture && sceneColorForPost;
     if (useTAA) {
         TAAParamsGPU taaParams{};
@@ -6882,44 +10287,104 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         );
         float useVelocity = runVelocity ? 1.0f : 0.0f;
         taaParams.params1 = Math::Vector4(sharpness, useVelocity, 0.04f, 0.55f);
+        // The compute resolve sharpens with RCAS instead of blending back towards the current frame.
+        const bool fusedSharpen = m_taaResolvePipeline && m_taaOutputTexture && sharpness > 0.001f;
         taaParams.params2 = Math::Vector4(
             post.taaSpecularStability ? 1.0f : 0.0f,
             Math::Clamp(post.taaSpecularStabilityStrength, 0.0f, 2.0f),
-            0.0f,
+            fusedSharpen ? sharpness : 0.0f,
             0.0f
         );
 
-        MTL::RenderPassDescriptor* taaPass = MTL::RenderPassDescriptor::alloc()->init();
-        taaPass->colorAttachments()->object(0)->setTexture(m_taaCurrentTexture);
-        taaPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
-        taaPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
-        taaPass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 1.0));
-
-        MTL::RenderCommandEncoder* taaEncoder = commandBuffer->renderCommandEncoder(taaPass);
-        taaEncoder->setRenderPipelineState(m_taaPipelineState);
-        taaEncoder->setViewport(viewport);
-        taaEncoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
-        taaEncoder->setFragmentBytes(&taaParams, sizeof(TAAParamsGPU), 1);
-        taaEncoder->setFragmentTexture(sceneColorForPost, 0);
-        taaEncoder->setFragmentTexture(m_taaHistoryTexture, 1);
-        taaEncoder->setFragmentTexture(m_depthTexture, 2);
-        taaEncoder->setFragmentTexture(m_velocityTexture, 3);
-        taaEncoder->setFragmentTexture(m_normalTexture, 4);
-        if (m_linearClampSampler) {
-            taaEncoder->setFragmentSamplerState(m_linearClampSampler, 0);
-        }
-        taaEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
-        taaEncoder->endEncoding();
-        taaPass->release();
+        if (m_taaResolvePipeline) {
+            MTL::ComputeCommandEncoder* taaCompute = m_gpuPassProfiler->computeEncoder(commandBuffer, GPUPass::Upscale);
+            taaCompute->setComputePipelineState(m_taaResolvePipeline);
+            taaCompute->setBuffer(m_cameraUniformBuffer, 0, 0);
+            taaCompute->setBytes(&taaParams, sizeof(TAAParamsGPU), 1);
+            taaCompute->setTexture(sceneColorForPost, 0);
+            taaCompute->setTexture(m_taaHistoryTexture, 1);
+            taaCompute->setTexture(m_depthTexture, 2);
+            taaCompute->setTexture(m_velocityTexture, 3);
+            taaCompute->setTexture(m_normalTexture, 4);
+            taaCompute->setTexture(m_taaCurrentTexture, 5);
+            taaCompute->setTexture(fusedSharpen ? m_taaOutputTexture : m_taaCurrentTexture, 6);
+            if (m_linearClampSampler) {
+                taaCompute->setSamplerState(m_linearClampSampler, 0);
+            }
+            taaCompute->dispatchThreadgroups(MTL::Size::Make((renderWidth + 15) / 16, (renderHeight + 15) / 16, 1),
+                                             MTL::Size::Make(16, 16, 1));
+            taaCompute->endEncoding();
 
-        std::swap(m_taaHistoryTexture, m_taaCurrentTexture);
-        sceneColorForPost = m_taaHistoryTexture;
-        m_taaHistoryValid = true;
+            std::swap(m_taaHistoryTexture, m_taaCurrentTexture);
+            sceneColorForPost = fusedSharpen ? m_taaOutputTexture : m_taaHistoryTexture;
+            m_taaHistoryValid = true;
+        } else {
+            MTL::RenderPassDescriptor* taaPass = MTL::RenderPassDescriptor::alloc()->init();
+            taaPass->colorAttachments()->object(0)->setTexture(m_taaCurrentTexture);
+            taaPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
+            taaPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
+            taaPass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 1.0));
+
+            MTL::RenderCommandEncoder* taaEncoder = m_gpuPassProfiler->renderEncoder(commandBuffer, taaPass, GPUPass::Upscale);
+            taaEncoder->setRenderPipelineState(m_taaPipelineState);
+            taaEncoder->setViewport(viewport);
+            taaEncoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
+            taaEncoder->setFragmentBytes(&taaParams, sizeof(TAAParamsGPU), 1);
+            taaEncoder->setFragmentTexture(sceneColorForPost, 0);
+            taaEncoder->setFragmentTexture(m_taaHistoryTexture, 1);
+            taaEncoder->setFragmentTexture(m_depthTexture, 2);
+            taaEncoder->setFragmentTexture(m_velocityTexture, 3);
+            taaEncoder->setFragmentTexture(m_normalTexture, 4);
+            if (m_linearClampSampler) {
+                taaEncoder->setFragmentSamplerState(m_linearClampSampler, 0);
+            }
+            taaEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
+            taaEncoder->endEncoding();
+            taaPass->release();
+
+            std::swap(m_taaHistoryTexture, m_taaCurrentTexture);
+            sceneColorForPost = m_taaHistoryTexture;
+            m_taaHistoryValid = true;
+        }
     }
 
     bool useMotionBlur = motionBlurEnabled && m_motionHistoryValid
-        && m_motionBlurPipelineState && m_motionBlurTexture && m_velocityTexture && sceneColorForPost && m_depthTexture;
-    if (useMotionBlur) {
+        && m_motionBlurTexture && m_velocityTexture && sceneColorForPost && m_depthTexture;
+    bool useDOF = dofEnabled && runPrepass && m_dofTexture && sceneColorForPost && m_depthTexture;
+    // Both effects share one tile classification and dispatch only the tiles that blur; the
+    // full-screen fragment passes below remain for when the tile kernels are unavailable.
+    bool tiledBlur = false;
+    if ((useMotionBlur || useDOF) && m_tiledPostBlur && m_tiledPostBlur->isAvailable()) {
+        TiledPostBlur::Frame blurFrame;
+        blurFrame.cameraUniforms = m_cameraUniformBuffer;
+        blurFrame.depth = m_depthTexture;
+        blurFrame.velocity = m_velocityTexture;
+        blurFrame.width = renderWidth;
+        blurFrame.height = renderHeight;
+        blurFrame.motionBlur = useMotionBlur;
+        blurFrame.motionStrength = post.motionBlurStrength;
+        blurFrame.depthOfField = useDOF;
+        blurFrame.focusDistance = post.dofFocusDistance;
+        blurFrame.aperture = post.dofAperture;
+        blurFrame.maxBlur = 12.0f;
+
+        MTL::ComputeCommandEncoder* blurCompute = m_gpuPassProfiler->computeEncoder(
+            commandBuffer, useMotionBlur ? GPUPass::MotionBlur : GPUPass::DepthOfField);
+        tiledBlur = m_tiledPostBlur->classify(blurCompute, blurFrame);
+        if (tiledBlur && useMotionBlur) {
+            m_tiledPostBlur->encodeMotionBlur(blurCompute, sceneColorForPost, m_motionBlurTexture);
+            sceneColorForPost = m_motionBlurTexture;
+        }
+        blurCompute->endEncoding();
+        if (tiledBlur && useDOF) {
+            MTL::ComputeCommandEncoder* dofCompute = m_gpuPassProfiler->computeEncoder(commandBuffer, GPUPass::DepthOfField);
+            m_tiledPostBlur->encodeDepthOfField(dofCompute, sceneColorForPost, m_dofTexture);
+            dofCompute->endEncoding();
+            sceneColorForPost = m_dofTexture;
+        }
+    }
+
+    if (useMotionBlur && !tiledBlur && m_motionBlurPipelineState) {
         MotionBlurParamsGPU blurParams{};
         blurParams.prevViewProjection = m_prevViewProjectionNoJitter;
         blurParams.currViewProjection = viewProjectionNoJitter;
@@ -6937,7 +10402,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         blurPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
         blurPass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 1.0));
 
-        MTL::RenderCommandEncoder* blurEncoder = commandBuffer->renderCommandEncoder(blurPass);
+        MTL::RenderCommandEncoder* blurEncoder = m_gpuPassProfiler->renderEncoder(commandBuffer, blurPass, GPUPass::MotionBlur);
         blurEncoder->setRenderPipelineState(m_motionBlurPipelineState);
         blurEncoder->setViewport(viewport);
         blurEncoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
@@ -6955,8 +10420,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         sceneColorForPost = m_motionBlurTexture;
     }
 
-    bool useDOF = dofEnabled && runPrepass && m_dofPipelineState && m_dofTexture && sceneColorForPost && m_depthTexture;
-    if (useDOF) {
+    if (useDOF && !tiledBlur && m_dofPipelineState) {
         DofParamsGPU dofParams{};
         float focusDistance = std::max(0.01f, post.dofFocusDistance);
         float aperture = std::max(0.1f, post.dofAperture);
@@ -6974,7 +10438,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         dofPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
         dofPass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 1.0));
 
-        MTL::RenderCommandEncoder* dofEncoder = commandBuffer->renderCommandEncoder(dofPass);
+        MTL::RenderCommandEncoder* dofEncoder = m_gpuPassProfiler->renderEncoder(commandBuffer, dofPass, GPUPass::DepthOfField);
         dofEncoder->setRenderPipelineState(m_dofPipelineState);
         dofEncoder->setViewport(viewport);
         dofEncoder->setFragmentBuffer(m_cameraUniformBuffer, 0, 0);
@@ -7011,58 +10475,80 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
             preParams.threshold = threshold;
             preParams.knee = knee;
 
-            MTL::RenderPassDescriptor* prePass = MTL::RenderPassDescriptor::alloc()->init();
-            prePass->colorAttachments()->object(0)->setTexture(mip0);
-            prePass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
-            prePass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
-            prePass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 1.0));
-
-            MTL::RenderCommandEncoder* preEncoder = commandBuffer->renderCommandEncoder(prePass);
-            preEncoder->setRenderPipelineState(m_bloomPrefilterPipelineState);
-            preEncoder->setViewport(mipViewport);
-            preEncoder->setFragmentBytes(&preParams, sizeof(BloomPrefilterParamsGPU), 0);
-            preEncoder->setFragmentTexture(sceneColorForPost, 0);
-            if (m_linearClampSampler) {
-                preEncoder->setFragmentSamplerState(m_linearClampSampler, 0);
-            }
-            preEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
-            preEncoder->endEncoding();
-            prePass->release();
-
-            for (size_t i = 1; i < m_bloomMipTextures.size(); ++i) {
-                MTL::Texture* src = m_bloomMipTextures[i - 1];
-                MTL::Texture* dst = m_bloomMipTextures[i];
-                if (!src || !dst) {
-                    continue;
+            if (m_bloomDownsampleSPDPipeline && m_bloomMipTextures.size() <= kBloomSpdMaxMips) {
+                BloomDownsampleSPDParamsGPU spdParams{};
+                spdParams.threshold = threshold;
+                spdParams.knee = knee;
+                spdParams.mipCount = static_cast<uint32_t>(m_bloomMipTextures.size());
+
+                MTL::ComputeCommandEncoder* spdEncoder = m_gpuPassProfiler->computeEncoder(commandBuffer, GPUPass::Bloom);
+                spdEncoder->setComputePipelineState(m_bloomDownsampleSPDPipeline);
+                spdEncoder->setBytes(&spdParams, sizeof(BloomDownsampleSPDParamsGPU), 0);
+                spdEncoder->setTexture(sceneColorForPost, 0);
+                for (size_t i = 0; i < m_bloomMipTextures.size(); ++i) {
+                    spdEncoder->setTexture(m_bloomMipTextures[i], 1 + i);
                 }
-                uint32_t dstWidth = dst->width();
-                uint32_t dstHeight = dst->height();
-                MTL::Viewport downViewport = {
-                    0.0, 0.0,
-                    static_cast<double>(dstWidth), static_cast<double>(dstHeight),
-                    0.0, 1.0
-                };
-
-                BloomDownsampleParamsGPU downParams{};
-                downParams.texelSize = Math::Vector2(1.0f / src->width(), 1.0f / src->height());
-
-                MTL::RenderPassDescriptor* downPass = MTL::RenderPassDescriptor::alloc()->init();
-                downPass->colorAttachments()->object(0)->setTexture(dst);
-                downPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
-                downPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
-                downPass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 1.0));
-
-                MTL::RenderCommandEncoder* downEncoder = commandBuffer->renderCommandEncoder(downPass);
-                downEncoder->setRenderPipelineState(m_bloomDownsamplePipelineState);
-                downEncoder->setViewport(downViewport);
-                downEncoder->setFragmentBytes(&downParams, sizeof(BloomDownsampleParamsGPU), 0);
-                downEncoder->setFragmentTexture(src, 0);
                 if (m_linearClampSampler) {
-                    downEncoder->setFragmentSamplerState(m_linearClampSampler, 0);
+                    spdEncoder->setSamplerState(m_linearClampSampler, 0);
+                }
+                spdEncoder->dispatchThreadgroups(
+                    MTL::Size((mipWidth + kBloomSpdTile - 1) / kBloomSpdTile, (mipHeight + kBloomSpdTile - 1) / kBloomSpdTile, 1),
+                    MTL::Size(16, 16, 1));
+                spdEncoder->endEncoding();
+            } else {
+                MTL::RenderPassDescriptor* prePass = MTL::RenderPassDescriptor::alloc()->init();
+                prePass->colorAttachments()->object(0)->setTexture(mip0);
+                prePass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
+                prePass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
+                prePass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 1.0));
+
+                MTL::RenderCommandEncoder* preEncoder = m_gpuPassProfiler->renderEncoder(commandBuffer, prePass, GPUPass::Bloom);
+                preEncoder->setRenderPipelineState(m_bloomPrefilterPipelineState);
+                preEncoder->setViewport(mipViewport);
+                preEncoder->setFragmentBytes(&preParams, sizeof(BloomPrefilterParamsGPU), 0);
+                preEncoder->setFragmentTexture(sceneColorForPost, 0);
+                if (m_linearClampSampler) {
+                    preEncoder->setFragmentSamplerState(m_linearClampSampler, 0);
+                }
+                preEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
+                preEncoder->endEncoding();
+                prePass->release();
+
+                for (size_t i = 1; i < m_bloomMipTextures.size(); ++i) {
+                    MTL::Texture* src = m_bloomMipTextures[i - 1];
+                    MTL::Texture* dst = m_bloomMipTextures[i];
+                    if (!src || !dst) {
+                        continue;
+                    }
+                    uint32_t dstWidth = dst->width();
+                    uint32_t dstHeight = dst->height();
+                    MTL::Viewport downViewport = {
+                        0.0, 0.0,
+                        static_cast<double>(dstWidth), static_cast<double>(dstHeight),
+                        0.0, 1.0
+                    };
+
+                    BloomDownsampleParamsGPU downParams{};
+                    downParams.texelSize = Math::Vector2(1.0f / src->width(), 1.0f / src->height());
+
+                    MTL::RenderPassDescriptor* downPass = MTL::RenderPassDescriptor::alloc()->init();
+                    downPass->colorAttachments()->object(0)->setTexture(dst);
+                    downPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
+                    downPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
+                    downPass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 1.0));
+
+                    MTL::RenderCommandEncoder* downEncoder = m_gpuPassProfiler->renderEncoder(commandBuffer, downPass, GPUPass::Bloom);
+                    downEncoder->setRenderPipelineState(m_bloomDownsamplePipelineState);
+                    downEncoder->setViewport(downViewport);
+                    downEncoder->setFragmentBytes(&downParams, sizeof(BloomDownsampleParamsGPU), 0);
+                    downEncoder->setFragmentTexture(src, 0);
+                    if (m_linearClampSampler) {
+                        downEncoder->setFragmentSamplerState(m_linearClampSampler, 0);
+                    }
+                    downEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
+                    downEncoder->endEncoding();
+                    downPass->release();
                 }
-                downEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
-                downEncoder->endEncoding();
-                downPass->release();
             }
 
             for (size_t i = m_bloomMipTextures.size(); i-- > 1; ) {
@@ -7088,7 +10574,7 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
                 upPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionLoad);
                 upPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
 
-                MTL::RenderCommandEncoder* upEncoder = commandBuffer->renderCommandEncoder(upPass);
+                MTL::RenderCommandEncoder* upEncoder = m_gpuPassProfiler->renderEncoder(commandBuffer, upPass, GPUPass::Bloom);
                 upEncoder->setRenderPipelineState(m_bloomUpsamplePipelineState);
                 upEncoder->setViewport(upViewport);
                 upEncoder->setFragmentBytes(&upParams, sizeof(BloomUpsampleParamsGPU), 0);
@@ -7104,12 +10590,37 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
     }
 
     MTL::Texture* presentSourceTexture = sceneColorForPost;
+    MTL::Texture* interpolatedSourceTexture = nullptr;
     bool useMetalFX = metalFXEnabled && sceneColorForPost && runPrepass
         && m_depthTexture && m_velocityTexture && m_metalFXTemporalScaler && m_metalFXOutputTexture;
+    if (useMetalFX && m_metalFXDynamicInput) {
+        useMetalFX = m_metalFXColorInput && m_metalFXDepthInput && m_metalFXMotionInput
+            && sceneColorForPost->pixelFormat() == m_metalFXColorInput->pixelFormat()
+            && renderWidth <= m_metalFXInputWidth && renderHeight <= m_metalFXInputHeight;
+    }
+    if (!useMetalFX) {
+        m_metalFXPrevOutputValid = false;
+    }
     if (useMetalFX) {
-        m_metalFXTemporalScaler->setColorTexture(sceneColorForPost);
-        m_metalFXTemporalScaler->setDepthTexture(m_depthTexture);
-        m_metalFXTemporalScaler->setMotionTexture(m_velocityTexture);
+        MTL::Texture* metalFXColor = sceneColorForPost;
+        MTL::Texture* metalFXDepth = m_depthTexture;
+        MTL::Texture* metalFXMotion = m_velocityTexture;
+        if (m_metalFXDynamicInput) {
+            // Frame content goes into the top-left of the max-size inputs.
+            MTL::BlitCommandEncoder* inputBlit = m_gpuPassProfiler->blitEncoder(commandBuffer, GPUPass::Upscale);
+            const MTL::Origin origin = MTL::Origin::Make(0, 0, 0);
+            const MTL::Size size = MTL::Size::Make(renderWidth, renderHeight, 1);
+            inputBlit->copyFromTexture(sceneColorForPost, 0, 0, origin, size, m_metalFXColorInput, 0, 0, origin);
+            inputBlit->copyFromTexture(m_depthTexture, 0, 0, origin, size, m_metalFXDepthInput, 0, 0, origin);
+            inputBlit->copyFromTexture(m_velocityTexture, 0, 0, origin, size, m_metalFXMotionInput, 0, 0, origin);
+            inputBlit->endEncoding();
+            metalFXColor = m_metalFXColorInput;
+            metalFXDepth = m_metalFXDepthInput;
+            metalFXMotion = m_metalFXMotionInput;
+        }
+        m_metalFXTemporalScaler->setColorTexture(metalFXColor);
+        m_metalFXTemporalScaler->setDepthTexture(metalFXDepth);
+        m_metalFXTemporalScaler->setMotionTexture(metalFXMotion);
         m_metalFXTemporalScaler->setOutputTexture(m_metalFXOutputTexture);
         m_metalFXTemporalScaler->setInputContentWidth(renderWidth);
         m_metalFXTemporalScaler->setInputContentHeight(renderHeight);
@@ -7122,87 +10633,168 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         m_metalFXTemporalScaler->setReset(!m_taaHistoryValid);
         m_metalFXTemporalScaler->encodeToCommandBuffer(commandBuffer);
         presentSourceTexture = m_metalFXOutputTexture;
+
+        if (frameInterpolationEnabled && m_metalFXPrevOutputValid) {
+            // Halfway between the previous upscaled frame and this one.
+            float deltaTime = std::max(1.0f / 240.0f, std::min(0.1f, Time::unscaledDeltaTime()));
+            m_metalFXFrameInterpolator->setColorTexture(m_metalFXOutputTexture);
+            m_metalFXFrameInterpolator->setPrevColorTexture(m_metalFXPrevOutputTexture);
+            m_metalFXFrameInterpolator->setDepthTexture(metalFXDepth);
+            m_metalFXFrameInterpolator->setMotionTexture(metalFXMotion);
+            m_metalFXFrameInterpolator->setMotionVectorScaleX(static_cast<float>(renderWidth));
+            m_metalFXFrameInterpolator->setMotionVectorScaleY(static_cast<float>(renderHeight));
+            m_metalFXFrameInterpolator->setJitterOffsetX(temporalJitterX);
+            m_metalFXFrameInterpolator->setJitterOffsetY(temporalJitterY);
+            m_metalFXFrameInterpolator->setDeltaTime(deltaTime);
+            m_metalFXFrameInterpolator->setNearPlane(camera->getNearClip());
+            m_metalFXFrameInterpolator->setFarPlane(camera->getFarClip());
+            m_metalFXFrameInterpolator->setFieldOfView(camera->getFieldOfView());
+            m_metalFXFrameInterpolator->setAspectRatio(m_viewportWidth / std::max(1.0f, m_viewportHeight));
+            m_metalFXFrameInterpolator->setDepthReversed(false);
+            m_metalFXFrameInterpolator->setShouldResetHistory(!m_taaHistoryValid);
+            m_metalFXFrameInterpolator->setOutputTexture(m_metalFXInterpolatedTexture);
+            m_metalFXFrameInterpolator->encodeToCommandBuffer(commandBuffer);
+            interpolatedSourceTexture = m_metalFXInterpolatedTexture;
+        }
+        if (frameInterpolationEnabled) {
+            MTL::BlitCommandEncoder* historyBlit = m_gpuPassProfiler->blitEncoder(commandBuffer, GPUPass::Upscale);
+            historyBlit->copyFromTexture(m_metalFXOutputTexture, m_metalFXPrevOutputTexture);
+            historyBlit->endEncoding();
+            m_metalFXPrevOutputValid = true;
+        }
         m_taaHistoryValid = true;
     }
 
+    bool useMetalFXSpatial = metalFXSpatialEnabled && sceneColorForPost
+        && m_metalFXSpatialScaler && m_metalFXOutputTexture;
+    if (useMetalFXSpatial) {
+        m_metalFXSpatialScaler->setColorTexture(sceneColorForPost);
+        m_metalFXSpatialScaler->setOutputTexture(m_metalFXOutputTexture);
+        m_metalFXSpatialScaler->setInputContentWidth(renderWidth);
+        m_metalFXSpatialScaler->setInputContentHeight(renderHeight);
+        m_metalFXSpatialScaler->encodeToCommandBuffer(commandBuffer);
+        presentSourceTexture = m_metalFXOutputTexture;
+    }
+
+    CA::MetalDrawable* interpolatedDrawable = nullptr;
     if (useOffscreen || (useMSAA && !resolveToDrawable)) {
-        if (!m_blitPipelineState || !presentSourceTexture) {
+        if (!acquireDrawable()) {
+            // Nothing to present into; the frame's work is still committed below.
+        } else if (!m_blitPipelineState || !presentSourceTexture) {
             std::cerr << "Blit pass skipped: missing pipeline or source texture\n";
         } else {
-            MTL::RenderPassDescriptor* blitPass = MTL::RenderPassDescriptor::alloc()->init();
-            blitPass->colorAttachments()->object(0)->setTexture(drawable->texture());
-            blitPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionDontCare);
-            blitPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
+            auto encodePresentBlit = [&](MTL::Texture* source, MTL::Texture* target) {
+                MTL::RenderPassDescriptor* blitPass = MTL::RenderPassDescriptor::alloc()->init();
+                blitPass->colorAttachments()->object(0)->setTexture(target);
+                blitPass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionDontCare);
+                blitPass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
             
-            MTL::RenderCommandEncoder* blitEncoder = commandBuffer->renderCommandEncoder(blitPass);
-            float vignetteIntensity = (post.enabled && post.vignette) ? std::max(0.0f, std::min(1.0f, post.vignetteIntensity)) : 0.0f;
-            float grainIntensity = (post.enabled && post.filmGrain) ? std::max(0.0f, std::min(1.0f, post.filmGrainIntensity)) : 0.0f;
-            float gradingIntensity = (post.enabled && post.colorGrading)
-                ? std::max(0.0f, std::min(1.0f, post.colorGradingIntensity))
-                : 0.0f;
-            float toneMapping = 0.0f;
-            if (post.enabled && post.toneMapping) {
-                toneMapping = (post.toneMappingMode == 2) ? 2.0f : 1.0f;
-            }
-            PostProcessParamsGPU postParams{};
-            postParams.params0 = Math::Vector4(
-                vignetteIntensity,
-                grainIntensity,
-                160.0f,
-                static_cast<float>(m_frameIndex) * 0.013f
-            );
-            postParams.params1 = Math::Vector4(
-                gradingIntensity,
-                toneMapping,
-                m_outputHDR ? 1.0f : 0.0f,
-                0.0f
-            );
-            bool lutValid = (m_colorGradingLUT != nullptr) || (m_colorGradingNeutralLUT != nullptr);
-            MTL::Texture* lutTexture = m_colorGradingLUT ? m_colorGradingLUT->getHandle() : nullptr;
-            if (!lutTexture && m_colorGradingNeutralLUT) {
-                lutTexture = m_colorGradingNeutralLUT->getHandle();
-            }
-            if (!lutTexture && m_defaultWhiteTexture) {
-                lutTexture = m_defaultWhiteTexture->getHandle();
-            }
-            if (!lutValid || !lutTexture) {
-                postParams.params1.x = 0.0f;
-            }
-
-            if (useBloom && m_bloomCombinePipelineState && !m_bloomMipTextures.empty()) {
-                BloomCombineParamsGPU combineParams{};
-                combineParams.intensity = std::max(0.0f, post.bloomIntensity);
-                blitEncoder->setRenderPipelineState(m_bloomCombinePipelineState);
-                blitEncoder->setFragmentBytes(&combineParams, sizeof(BloomCombineParamsGPU), 0);
-                blitEncoder->setFragmentBytes(&postParams, sizeof(PostProcessParamsGPU), 1);
-                blitEncoder->setFragmentTexture(presentSourceTexture, 0);
-                blitEncoder->setFragmentTexture(m_bloomMipTextures[0], 1);
-                if (lutTexture) {
-                    blitEncoder->setFragmentTexture(lutTexture, 2);
+                MTL::RenderCommandEncoder* blitEncoder = m_gpuPassProfiler->renderEncoder(commandBuffer, blitPass, GPUPass::Post);
+                float vignetteIntensity = (post.enabled && post.vignette) ? std::max(0.0f, std::min(1.0f, post.vignetteIntensity)) : 0.0f;
+                float grainIntensity = (post.enabled && post.filmGrain) ? std::max(0.0f, std::min(1.0f, post.filmGrainIntensity)) : 0.0f;
+                float gradingIntensity = (post.enabled && post.colorGrading)
+                    ? std::max(0.0f, std::min(1.0f, post.colorGradingIntensity))
+                    : 0.0f;
+                float toneMapping = 0.0f;
+                if (post.enabled && post.toneMapping) {
+                    toneMapping = (post.toneMappingMode == 2) ? 2.0f : 1.0f;
                 }
-            } else {
-                blitEncoder->setRenderPipelineState(m_blitPipelineState);
-                blitEncoder->setFragmentBytes(&postParams, sizeof(PostProcessParamsGPU), 0);
-                blitEncoder->setFragmentTexture(presentSourceTexture, 0);
-                if (lutTexture) {
-                    blitEncoder->setFragmentTexture(lutTexture, 1);
+                PostProcessParamsGPU postParams{};
+                postParams.params0 = Math::Vector4(
+                    vignetteIntensity,
+                    grainIntensity,
+                    160.0f,
+                    static_cast<float>(m_frameIndex) * 0.013f
+                );
+                postParams.params1 = Math::Vector4(
+                    gradingIntensity,
+                    toneMapping,
+                    m_outputHDR ? 1.0f : 0.0f,
+                    0.0f
+                );
+                bool lutValid = (m_colorGradingLUT != nullptr) || (m_colorGradingNeutralLUT != nullptr);
+                MTL::Texture* lutTexture = m_colorGradingLUT ? m_colorGradingLUT->getHandle() : nullptr;
+                if (!lutTexture && m_colorGradingNeutralLUT) {
+                    lutTexture = m_colorGradingNeutralLUT->getHandle();
                 }
-            }
-            if (m_linearClampSampler) {
-                blitEncoder->setFragmentSamplerState(m_linearClampSampler, 0);
-            } else if (m_samplerState) {
-                blitEncoder->setFragmentSamplerState(m_samplerState, 0);
-            }
-            MTL::Viewport blitViewport = {
-                0.0, 0.0,
-                m_viewportWidth, m_viewportHeight,
-                0.0, 1.0
-            };
-            blitEncoder->setViewport(blitViewport);
-            blitEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
-            blitEncoder->endEncoding();
+                if (!lutTexture && m_defaultWhiteTexture) {
+                    lutTexture = m_defaultWhiteTexture->getHandle();
+                }
+                if (!lutValid || !lutTexture) {
+                    postParams.params1.x = 0.0f;
+                }
+
+                if (useBloom && m_bloomCombinePipelineState && !m_bloomMipTextures.empty()) {
+                    BloomCombineParamsGPU combineParams{};
+                    combineParams.intensity = std::max(0.0f, post.bloomIntensity);
+                    blitEncoder->setRenderPipelineState(m_bloomCombinePipelineState);
+                    blitEncoder->setFragmentBytes(&combineParams, sizeof(BloomCombineParamsGPU), 0);
+                    blitEncoder->setFragmentBytes(&postParams, sizeof(PostProcessParamsGPU), 1);
+                    blitEncoder->setFragmentTexture(source, 0);
+                    blitEncoder->setFragmentTexture(m_bloomMipTextures[0], 1);
+                    if (lutTexture) {
+                        blitEncoder->setFragmentTexture(lutTexture, 2);
+                    }
+                } else {
+                    blitEncoder->setRenderPipelineState(m_blitPipelineState);
+                    blitEncoder->setFragmentBytes(&postParams, sizeof(PostProcessParamsGPU), 0);
+                    blitEncoder->setFragmentTexture(source, 0);
+                    if (lutTexture) {
+                        blitEncoder->setFragmentTexture(lutTexture, 1);
+                    }
+                }
+                if (m_linearClampSampler) {
+                    blitEncoder->setFragmentSamplerState(m_linearClampSampler, 0);
+                } else if (m_samplerState) {
+                    blitEncoder->setFragmentSamplerState(m_samplerState, 0);
+                }
+                MTL::Viewport blitViewport = {
+                    0.0, 0.0,
+                    m_viewportWidth, m_viewportHeight,
+                    0.0, 1.0
+                };
+                blitEncoder->setViewport(blitViewport);
+                blitEncoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
+                blitEncoder->endEncoding();
             
-            blitPass->release();
+                blitPass->release();
+            };
+            if (interpolatedSourceTexture) {
+                // The in-between frame goes to its own drawable, presented ahead of this one.
+                interpolatedDrawable = m_metalLayer->nextDrawable();
+                if (interpolatedDrawable) {
+                    encodePresentBlit(interpolatedSourceTexture, interpolatedDrawable->texture());
+                }
+            }
+            encodePresentBlit(presentSourceTexture, drawable->texture());
+        }
+    }
+
+    if (options.lateLatch.enabled) {
+        // Re-aim the frame at the mouse motion that arrived while it was simulated and encoded. Only
+        // the camera uniforms move, which the GPU reads after commit; culling, shadows and anything
+        // copied at encode time keep the simulated view, which the few degrees of a late turn hide.
+        const RenderOptions::LateLatch& latch = options.lateLatch;
+        Math::Vector2 motion = InputManager::getInstance().getMotionSince(latch.appliedMotionX, latch.appliedMotionY);
+        float yaw = motion.x * latch.yawPerUnit;
+        float pitch = Math::Clamp(latch.pitch + motion.y * latch.pitchPerUnit, latch.minPitch, latch.maxPitch) - latch.pitch;
+        if (yaw != 0.0f || pitch != 0.0f) {
+            // The view matrix holds the camera's right, up and -forward in its rows.
+            Math::Vector3 right(viewMatrix.m[0], viewMatrix.m[4], viewMatrix.m[8]);
+            Math::Vector3 up(viewMatrix.m[1], viewMatrix.m[5], viewMatrix.m[9]);
+            Math::Vector3 forward(-viewMatrix.m[2], -viewMatrix.m[6], -viewMatrix.m[10]);
+            Math::Quaternion pitchTurn = Math::Quaternion::FromAxisAngle(right, pitch);
+            Math::Quaternion yawTurn = Math::Quaternion::FromAxisAngle(Math::Vector3::Up, yaw);
+            forward = yawTurn * (pitchTurn * forward);
+            up = yawTurn * (pitchTurn * up);
+
+            viewMatrix = Math::Matrix4x4::LookAt(camPos, camPos + forward, up);
+            viewProjection = projectionMatrix * viewMatrix;
+            viewProjectionNoJitter = projectionMatrixNoJitter * viewMatrix;
+            cameraUniforms->viewMatrix = viewMatrix;
+            cameraUniforms->viewProjectionMatrix = viewProjection;
+            cameraUniforms->viewMatrixInverse = viewMatrix.inversed();
+            m_stats.lateLatchedFrames++;
         }
     }
 
@@ -7219,69 +10811,81 @@ void Renderer::renderScene(Scene* scene, Camera* cameraOverride, const RenderOpt
         m_frameIndex++;
     }
 
+    CRESCENT_PROFILE_NEXT(profilePhase, "Renderer::present");
     // Present
-    commandBuffer->presentDrawable(drawable);
+    if (interpolatedDrawable) {
+        // Hold the rendered frame for half a frame so both land evenly between renders.
+        float deltaTime = std::max(1.0f / 240.0f, std::min(0.1f, Time::unscaledDeltaTime()));
+        commandBuffer->presentDrawable(interpolatedDrawable);
+        commandBuffer->presentDrawableAfterMinimumDuration(drawable, 0.5 * deltaTime);
+        m_stats.interpolatedFrames++;
+    } else if (drawable && m_lowLatencyPresentation && m_activePool == RenderTargetPool::Game) {
+        // Hold each frame for the frame interval, snapped to the 120 Hz grid ProMotion displays
+        // refresh on, so frames that finish early do not shorten the one before them.
+        double frameInterval = std::max(1.0 / 240.0, std::min(0.1, static_cast<double>(Time::unscaledDeltaTime())));
+        m_presentInterval = m_presentInterval > 0.0 ? m_presentInterval + (frameInterval - m_presentInterval) * 0.1 : frameInterval;
+        double minimumDuration = std::max(1.0, std::round(m_presentInterval * 120.0)) / 120.0;
+        commandBuffer->presentDrawableAfterMinimumDuration(drawable, minimumDuration);
+    } else if (drawable) {
+        commandBuffer->presentDrawable(drawable);
+    }
+    if (drawable) {
+        // Input-to-photon latency: from the oldest input this frame applied to the frame on screen.
+        double inputTime = InputManager::getInstance().takePresentInputTime();
+        if (inputTime > 0.0) {
+            drawable->addPresentedHandler([inputTime](MTL::Drawable* presented) {
+                InputManager::getInstance().recordPresented(inputTime, presented->presentedTime());
+            });
+        }
+    }
+    m_gpuPassProfiler->endFrame(commandBuffer);
+    m_stats.passWork = m_gpuPassProfiler->getWork();
+    for (const GPUPassWork& work : m_stats.passWork) {
+        m_stats.uniformBytesUploaded += work.inlineBytes + work.ringBytes;
+    }
+    if (m_uniformRing) {
+        m_stats.uniformRingOverflows = m_uniformRing->getOverflowCount();
+    }
+    if (m_frameEvent) {
+        commandBuffer->encodeSignalEvent(m_frameEvent, ++m_frameEventValue);
+        m_inFlightFrameValues[bufferSlot] = m_frameEventValue;
+    }
     commandBuffer->retain();
     m_inFlightCommandBuffers[bufferSlot] = commandBuffer;
+    m_inFlightGameView[bufferSlot] = m_activePool == RenderTargetPool::Game;
+    if (StartupTrace::getInstance().isRecording()) {
+        // Time-to-first-frame ends when the GPU has finished the frame, not when it was encoded.
+        commandBuffer->addCompletedHandler([](MTL::CommandBuffer*) {
+            StartupTrace::getInstance().markFirstFrame();
+        });
+    }
+    if (m_sceneResidency) {
+        m_sceneResidency->commit();
+        m_stats.residentResources = static_cast<uint32_t>(m_sceneResidency->getResidentCount());
+    }
     commandBuffer->commit();
+    if (drawable) {
+        m_stats.drawableHoldMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - drawableAcquiredAt).count();
+    }
+    OcclusionFrame& occlusionFrame = m_occlusionFrames[bufferSlot];
+    occlusionFrame.pending = occlusionFrame.tested;
+    occlusionFrame.frameIndex = static_cast<uint64_t>(m_bufferFrameIndex) + 1;
     m_bufferFrameIndex++;
+    m_stats.transientAllocations += frameArena.heapAllocations();
     
     // Cleanup
     renderPass->release();
 }
 
-std::shared_ptr<Texture2D> Renderer::bakeImpostorAtlas(Mesh* mesh,
-                                                       Material* material,
-                                                       uint32_t rows,
-                                                       uint32_t cols,
-                                                       uint32_t tileSize,
-                                                       std::string* outPath) {
-    if (!m_device || !m_commandQueue || !mesh || rows == 0 || cols == 0 || tileSize == 0) {
-        return nullptr;
+uint32_t Renderer::bakeImpostorAtlases(std::vector<ImpostorBakeRequest> requests) {
+    if (!m_device || !m_commandQueue || !m_impostorBaker || requests.empty()) {
+        return 0;
     }
     if (!m_impostorBakePipeline) {
         buildImpostorPipeline();
     }
     if (!m_impostorBakePipeline) {
-        return nullptr;
-    }
-    if (!mesh->isUploaded()) {
-        uploadMesh(mesh);
-    }
-
-    MTL::Buffer* vertexBuffer = static_cast<MTL::Buffer*>(mesh->getVertexBuffer());
-    MTL::Buffer* indexBuffer = static_cast<MTL::Buffer*>(mesh->getIndexBuffer());
-    if (!vertexBuffer || !indexBuffer) {
-        return nullptr;
-    }
-
-    uint32_t width = cols * tileSize;
-    uint32_t height = rows * tileSize;
-
-    MTL::TextureDescriptor* colorDesc = MTL::TextureDescriptor::alloc()->init();
-    colorDesc->setTextureType(MTL::TextureType2D);
-    colorDesc->setWidth(width);
-    colorDesc->setHeight(height);
-    colorDesc->setPixelFormat(MTL::PixelFormatRGBA8Unorm);
-    colorDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
-    colorDesc->setStorageMode(MTL::StorageModeShared);
-    MTL::Texture* colorTex = m_device->newTexture(colorDesc);
-    colorDesc->release();
-
-    MTL::TextureDescriptor* depthDesc = MTL::TextureDescriptor::alloc()->init();
-    depthDesc->setTextureType(MTL::TextureType2D);
-    depthDesc->setWidth(width);
-    depthDesc->setHeight(height);
-    depthDesc->setPixelFormat(MTL::PixelFormatDepth32Float);
-    depthDesc->setUsage(MTL::TextureUsageRenderTarget);
-    depthDesc->setStorageMode(MTL::StorageModeShared);
-    MTL::Texture* depthTex = m_device->newTexture(depthDesc);
-    depthDesc->release();
-
-    if (!colorTex || !depthTex) {
-        if (colorTex) colorTex->release();
-        if (depthTex) depthTex->release();
-        return nullptr;
+        return 0;
     }
 
     struct BakeParams {
@@ -7291,107 +10895,6 @@ std::shared_ptr<Texture2D> Renderer::bakeImpostorAtlas(Mesh* mesh,
         Math::Vector4 lightDirHasTex;
     };
 
-    Math::Vector3 boundsCenter = mesh->getBoundsCenter();
-    Math::Vector3 boundsSize = mesh->getBoundsSize();
-    float radius = std::max(0.1f, std::max(boundsSize.x, std::max(boundsSize.y, boundsSize.z)) * 0.5f);
-    float orthoSize = radius * 1.2f;
-    float nearZ = 0.01f;
-    float farZ = radius * 6.0f;
-
-    MTL::RenderPassDescriptor* pass = MTL::RenderPassDescriptor::alloc()->init();
-    pass->colorAttachments()->object(0)->setTexture(colorTex);
-    pass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
-    pass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
-    pass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 0.0));
-    pass->depthAttachment()->setTexture(depthTex);
-    pass->depthAttachment()->setLoadAction(MTL::LoadActionClear);
-    pass->depthAttachment()->setStoreAction(MTL::StoreActionDontCare);
-    pass->depthAttachment()->setClearDepth(1.0);
-
-    MTL::CommandBuffer* commandBuffer = m_commandQueue->commandBuffer();
-    MTL::RenderCommandEncoder* encoder = commandBuffer->renderCommandEncoder(pass);
-    encoder->setRenderPipelineState(m_impostorBakePipeline);
-    if (m_depthStencilState) {
-        encoder->setDepthStencilState(m_depthStencilState);
-    }
-    encoder->setCullMode(MTL::CullModeBack);
-
-    BakeParams params{};
-    if (material) {
-        params.albedo = material->getAlbedo();
-        Math::Vector2 tiling = material->getUVTiling();
-        Math::Vector2 offset = material->getUVOffset();
-        params.uvTilingOffset = Math::Vector4(tiling.x, tiling.y, offset.x, offset.y);
-    } else {
-        params.albedo = Math::Vector4(1.0f);
-        params.uvTilingOffset = Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
-    }
-    params.lightDirHasTex = Math::Vector4(0.3f, 0.8f, 0.4f, material && material->getAlbedoTexture() ? 1.0f : 0.0f);
-
-    auto albedoTex = material && material->getAlbedoTexture() ? material->getAlbedoTexture() : m_defaultWhiteTexture;
-    encoder->setFragmentTexture(albedoTex ? albedoTex->getHandle() : nullptr, 0);
-    if (m_samplerState) {
-        encoder->setFragmentSamplerState(m_samplerState, 0);
-    }
-    encoder->setVertexBuffer(vertexBuffer, 0, 0);
-
-    MTL::ScissorRect scissor{};
-    for (uint32_t row = 0; row < rows; ++row) {
-        for (uint32_t col = 0; col < cols; ++col) {
-            float azimuth = (static_cast<float>(col) + 0.5f) / static_cast<float>(cols) * Math::TWO_PI - Math::PI;
-            float elevation = (static_cast<float>(row) + 0.5f) / static_cast<float>(rows) * Math::PI - Math::HALF_PI;
-            float cosEl = std::cos(elevation);
-            Math::Vector3 dir(
-                std::sin(azimuth) * cosEl,
-                std::sin(elevation),
-                std::cos(azimuth) * cosEl
-            );
-            Math::Vector3 cameraPos = boundsCenter + dir * (radius * 2.5f);
-            Math::Matrix4x4 view = Math::Matrix4x4::LookAt(cameraPos, boundsCenter, Math::Vector3::Up);
-            Math::Matrix4x4 proj = Math::Matrix4x4::Orthographic(-orthoSize, orthoSize, -orthoSize, orthoSize, nearZ, farZ);
-            params.viewProjection = proj * view;
-
-            MTL::Viewport vp = {
-                static_cast<double>(col * tileSize),
-                static_cast<double>(row * tileSize),
-                static_cast<double>(tileSize),
-                static_cast<double>(tileSize),
-                0.0,
-                1.0
-            };
-            encoder->setViewport(vp);
-            scissor.x = col * tileSize;
-            scissor.y = row * tileSize;
-            scissor.width = tileSize;
-            scissor.height = tileSize;
-            encoder->setScissorRect(scissor);
-            encoder->setVertexBytes(&params, sizeof(BakeParams), 1);
-            encoder->setFragmentBytes(&params, sizeof(BakeParams), 0);
-            encoder->drawIndexedPrimitives(MTL::PrimitiveTypeTriangle,
-                                           mesh->getIndices().size(),
-                                           MTL::IndexTypeUInt32,
-                                           indexBuffer,
-                                           0);
-        }
-    }
-
-    encoder->endEncoding();
-    pass->release();
-    commandBuffer->commit();
-    commandBuffer->waitUntilCompleted();
-
-    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
-    MTL::Region region = MTL::Region::Make2D(0, 0, width, height);
-    colorTex->getBytes(pixels.data(), width * 4, region, 0);
-
-    std::string outputPath;
-    AssetDatabase& db = AssetDatabase::getInstance();
-    std::string root = db.getRootPath();
-    if (root.empty()) {
-        root = std::filesystem::current_path().string();
-    }
-    std::filesystem::path outDir = std::filesystem::path(root) / "Assets" / "Generated" / "Impostors";
-    std::filesystem::create_directories(outDir);
     auto sanitize = [](std::string name) {
         for (char& c : name) {
             if (!(std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-')) {
@@ -7400,23 +10903,194 @@ std::shared_ptr<Texture2D> Renderer::bakeImpostorAtlas(Mesh* mesh,
         }
         return name;
     };
-    std::string meshName = sanitize(mesh->getName().empty() ? "Mesh" : mesh->getName());
-    std::string matName = sanitize(material ? material->getName() : "Material");
-    outputPath = (outDir / (meshName + "_" + matName + "_impostor.png")).string();
+    std::filesystem::path outDir;
 
-    stbi_write_png(outputPath.c_str(), static_cast<int>(width), static_cast<int>(height), 4, pixels.data(), static_cast<int>(width * 4));
-
-    if (outPath) {
-        *outPath = outputPath;
+    // Bakes can run right after a load, before any frame has flushed the material's mips.
+    if (m_textureLoader) {
+        m_textureLoader->flushPendingMipmaps();
     }
-
-    if (depthTex) depthTex->release();
-    if (colorTex) colorTex->release();
-
-    if (!m_textureLoader) {
-        return nullptr;
+    MTL::CommandBuffer* commandBuffer = m_commandQueue->commandBuffer();
+    std::vector<ImpostorBaker::Atlas> atlases;
+    atlases.reserve(requests.size());
+    for (ImpostorBakeRequest& request : requests) {
+        Mesh* mesh = request.mesh.get();
+        Material* material = request.material.get();
+        const uint32_t rows = request.rows;
+        const uint32_t cols = request.cols;
+        const uint32_t tileSize = request.tileSize;
+        if (!mesh || rows == 0 || cols == 0 || tileSize == 0) {
+            continue;
+        }
+        if (!mesh->isUploaded()) {
+            uploadMesh(mesh);
+        }
+        MTL::Buffer* vertexBuffer = static_cast<MTL::Buffer*>(mesh->getVertexBuffer());
+        MTL::Buffer* indexBuffer = static_cast<MTL::Buffer*>(mesh->getIndexBuffer());
+        if (!vertexBuffer || !indexBuffer) {
+            continue;
+        }
+
+        uint32_t width = cols * tileSize;
+        uint32_t height = rows * tileSize;
+
+        // The atlas stays in private memory; saving reads it back through ImpostorBaker.
+        MTL::TextureDescriptor* colorDesc = MTL::TextureDescriptor::alloc()->init();
+        colorDesc->setTextureType(MTL::TextureType2D);
+        colorDesc->setWidth(width);
+        colorDesc->setHeight(height);
+        colorDesc->setPixelFormat(MTL::PixelFormatRGBA8Unorm);
+        colorDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead | MTL::TextureUsagePixelFormatView);
+        colorDesc->setStorageMode(MTL::StorageModePrivate);
+        MTL::Texture* colorTex = m_device->newTexture(colorDesc);
+        colorDesc->release();
+
+        MTL::TextureDescriptor* depthDesc = MTL::TextureDescriptor::alloc()->init();
+        depthDesc->setTextureType(MTL::TextureType2D);
+        depthDesc->setWidth(width);
+        depthDesc->setHeight(height);
+        depthDesc->setPixelFormat(MTL::PixelFormatDepth32Float);
+        depthDesc->setUsage(MTL::TextureUsageRenderTarget);
+        depthDesc->setStorageMode(MTL::StorageModePrivate);
+        MTL::Texture* depthTex = m_device->newTexture(depthDesc);
+        depthDesc->release();
+
+        if (!colorTex || !depthTex) {
+            if (colorTex) colorTex->release();
+            if (depthTex) depthTex->release();
+            continue;
+        }
+
+        Math::Vector3 boundsCenter = mesh->getBoundsCenter();
+        Math::Vector3 boundsSize = mesh->getBoundsSize();
+        float radius = std::max(0.1f, std::max(boundsSize.x, std::max(boundsSize.y, boundsSize.z)) * 0.5f);
+        float orthoSize = radius * 1.2f;
+        float nearZ = 0.01f;
+        float farZ = radius * 6.0f;
+
+        MTL::RenderPassDescriptor* pass = MTL::RenderPassDescriptor::alloc()->init();
+        pass->colorAttachments()->object(0)->setTexture(colorTex);
+        pass->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
+        pass->colorAttachments()->object(0)->setStoreAction(MTL::StoreActionStore);
+        pass->colorAttachments()->object(0)->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 0.0));
+        pass->depthAttachment()->setTexture(depthTex);
+        pass->depthAttachment()->setLoadAction(MTL::LoadActionClear);
+        pass->depthAttachment()->setStoreAction(MTL::StoreActionDontCare);
+        pass->depthAttachment()->setClearDepth(1.0);
+
+        MTL::RenderCommandEncoder* encoder = commandBuffer->renderCommandEncoder(pass);
+        encoder->setRenderPipelineState(m_impostorBakePipeline);
+        if (m_depthStencilState) {
+            encoder->setDepthStencilState(m_depthStencilState);
+        }
+        encoder->setCullMode(MTL::CullModeBack);
+
+        BakeParams params{};
+        if (material) {
+            params.albedo = material->getAlbedo();
+            Math::Vector2 tiling = material->getUVTiling();
+            Math::Vector2 offset = material->getUVOffset();
+            params.uvTilingOffset = Math::Vector4(tiling.x, tiling.y, offset.x, offset.y);
+        } else {
+            params.albedo = Math::Vector4(1.0f);
+            params.uvTilingOffset = Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
+        }
+        params.lightDirHasTex = Math::Vector4(0.3f, 0.8f, 0.4f, material && material->getAlbedoTexture() ? 1.0f : 0.0f);
+
+        auto albedoTex = material && material->getAlbedoTexture() ? material->getAlbedoTexture() : m_defaultWhiteTexture;
+        encoder->setFragmentTexture(albedoTex ? albedoTex->getHandle() : nullptr, 0);
+        if (m_samplerState) {
+            encoder->setFragmentSamplerState(m_samplerState, 0);
+        }
+        encoder->setVertexBuffer(vertexBuffer, mesh->getVertexBufferOffset(), 0);
+        encoder->setVertexBuffer(static_cast<MTL::Buffer*>(mesh->getAttributeBuffer()), mesh->getAttributeBufferOffset(),
+                                 GeometryBuffer::kAttributeBufferIndex);
+
+        MTL::ScissorRect scissor{};
+        for (uint32_t row = 0; row < rows; ++row) {
+            for (uint32_t col = 0; col < cols; ++col) {
+                float azimuth = (static_cast<float>(col) + 0.5f) / static_cast<float>(cols) * Math::TWO_PI - Math::PI;
+                float elevation = (static_cast<float>(row) + 0.5f) / static_cast<float>(rows) * Math::PI - Math::HALF_PI;
+                float cosEl = std::cos(elevation);
+                Math::Vector3 dir(
+                    std::sin(azimuth) * cosEl,
+                    std::sin(elevation),
+                    std::cos(azimuth) * cosEl
+                );
+                Math::Vector3 cameraPos = boundsCenter + dir * (radius * 2.5f);
+                Math::Matrix4x4 view = Math::Matrix4x4::LookAt(cameraPos, boundsCenter, Math::Vector3::Up);
+                Math::Matrix4x4 proj = Math::Matrix4x4::Orthographic(-orthoSize, orthoSize, -orthoSize, orthoSize, nearZ, farZ);
+                params.viewProjection = proj * view;
+
+                MTL::Viewport vp = {
+                    static_cast<double>(col * tileSize),
+                    static_cast<double>(row * tileSize),
+                    static_cast<double>(tileSize),
+                    static_cast<double>(tileSize),
+                    0.0,
+                    1.0
+                };
+                encoder->setViewport(vp);
+                scissor.x = col * tileSize;
+                scissor.y = row * tileSize;
+                scissor.width = tileSize;
+                scissor.height = tileSize;
+                encoder->setScissorRect(scissor);
+                encoder->setVertexBytes(&params, sizeof(BakeParams), 1);
+                encoder->setFragmentBytes(&params, sizeof(BakeParams), 0);
+                encoder->drawIndexedPrimitives(MTL::PrimitiveTypeTriangle,
+                                               mesh->getIndexCount(),
+                                               MTL::IndexTypeUInt32,
+                                               indexBuffer,
+                                               mesh->getIndexBufferOffset());
+            }
+        }
+
+        encoder->endEncoding();
+        pass->release();
+        // The command buffer keeps the depth target alive until it completes.
+        depthTex->release();
+
+        ImpostorBaker::Atlas atlas;
+        atlas.texture = colorTex;
+        atlas.width = width;
+        atlas.height = height;
+        if (request.saveToDisk) {
+            if (outDir.empty()) {
+                std::string root = AssetDatabase::getInstance().getRootPath();
+                if (root.empty()) {
+                    root = std::filesystem::current_path().string();
+                }
+                outDir = std::filesystem::path(root) / "Assets" / "Generated" / "Impostors";
+                std::filesystem::create_directories(outDir);
+            }
+            std::string meshName = sanitize(mesh->getName().empty() ? "Mesh" : mesh->getName());
+            std::string matName = sanitize(material ? material->getName() : "Material");
+            atlas.outputPath = (outDir / (meshName + "_" + matName + "_impostor.png")).string();
+        }
+        atlas.request = std::move(request);
+        atlases.push_back(std::move(atlas));
     }
-    return m_textureLoader->loadTexture(outputPath, true, false);
+
+    const uint32_t submitted = static_cast<uint32_t>(atlases.size());
+    m_impostorBaker->submit(m_device, commandBuffer, std::move(atlases));
+    commandBuffer->commit();
+    return submitted;
+}
+
+size_t Renderer::getPendingImpostorBakes() const {
+    return m_impostorBaker ? m_impostorBaker->getPendingCount() : 0;
+}
+
+bool Renderer::isPickingAvailable() const {
+    return m_entityPicker && m_entityPicker->isAvailable();
+}
+
+uint64_t Renderer::requestPick(const EntityPicker::Request& request) {
+    return isPickingAvailable() ? m_entityPicker->request(request) : 0;
+}
+
+bool Renderer::takePickResult(EntityPicker::Result& out) {
+    return m_entityPicker && m_entityPicker->takeResult(out);
 }
 
 void Renderer::renderSkybox(MTL::RenderCommandEncoder* encoder, Camera* camera) {
@@ -7447,6 +11121,7 @@ void Renderer::renderSkybox(MTL::RenderCommandEncoder* encoder, Camera* camera)
     auto envTex = (m_environmentTexture ? m_environmentTexture : m_defaultEnvironmentTexture);
     encoder->setFragmentTexture(envTex ? envTex->getHandle() : nullptr, 0);
     encoder->setFragmentTexture(m_iblCubemap, 1);
+    encoder->setFragmentTexture(m_skyAtmosphere ? m_skyAtmosphere->getSkyViewLUT() : nullptr, 2);
     if (m_samplerState) {
         encoder->setFragmentSamplerState(m_samplerState, 0);
     }
@@ -7459,12 +11134,15 @@ void Renderer::renderSkybox(MTL::RenderCommandEncoder* encoder, Camera* camera)
     );
 }
 
+// Built every frame but only written when a setting changed, which leaves the buffer alone while the
+// environment is steady.
 void Renderer::updateEnvironmentUniforms() {
     if (!m_environmentUniformBuffer) {
         return;
     }
     
-    EnvironmentUniformsGPU* env = static_cast<EnvironmentUniformsGPU*>(m_environmentUniformBuffer->contents());
+    EnvironmentUniformsGPU uniforms{};
+    EnvironmentUniformsGPU* env = &uniforms;
     env->exposureIntensity = Math::Vector4(
         m_environmentSettings.exposureEV,
         m_environmentSettings.iblIntensity,
@@ -7487,7 +11165,7 @@ void Renderer::updateEnvironmentUniforms() {
     
     env->toneControl = Math::Vector4(
         Math::Clamp(m_environmentSettings.contrast, 0.1f, 3.0f),
-        m_hasIBL ? 1.0f : 0.0f,  // hasProperIBL flag
+        (m_hasIBL || usesSkyLighting()) ? 1.0f : 0.0f,  // hasProperIBL flag
         m_environmentSettings.skyboxVisible ? 1.0f : 0.0f,
         m_outputHDR ? 1.0f : 0.0f
     );
@@ -7501,19 +11179,36 @@ void Renderer::updateEnvironmentUniforms() {
         static_cast<float>(m_environmentSettings.skyMode),
         static_cast<float>(m_environmentSettings.shadowDebugMode),
         hasRawEnvironment ? 1.0f : 0.0f,
-        0.0f
+        (m_environmentSettings.skyMode == 0 && m_skyAtmosphere && m_skyAtmosphere->hasSkyView()) ? 1.0f : 0.0f
     );
     
-    Math::Vector3 eulerRad(
-        m_environmentSettings.rotation.x * Math::DEG_TO_RAD,
-        m_environmentSettings.rotation.y * Math::DEG_TO_RAD,
-        m_environmentSettings.rotation.z * Math::DEG_TO_RAD
-    );
-    Math::Quaternion q = Math::Quaternion::FromEulerAngles(eulerRad);
-    Math::Matrix4x4 rot = Math::Matrix4x4::Rotate(q);
+    Math::Matrix4x4 rot = EnvironmentRotationMatrix(m_environmentSettings.rotation);
     env->rot0 = Math::Vector4(rot(0, 0), rot(1, 0), rot(2, 0), 0.0f);
     env->rot1 = Math::Vector4(rot(0, 1), rot(1, 1), rot(2, 1), 0.0f);
     env->rot2 = Math::Vector4(rot(0, 2), rot(1, 2), rot(2, 2), 0.0f);
+
+    void* contents = m_environmentUniformBuffer->contents();
+    if (std::memcmp(contents, &uniforms, sizeof(uniforms)) != 0) {
+        std::memcpy(contents, &uniforms, sizeof(uniforms));
+    }
+}
+
+// The procedural sky lights the scene while it is shown and no environment map provides lighting.
+bool Renderer::usesSkyLighting() const {
+    return !m_hasIBL && m_environmentSettings.skyMode == 0 && m_skyAtmosphere && m_skyAtmosphere->hasLighting()
+        && m_iblBRDFLUT;
+}
+
+void Renderer::bindEnvironmentLighting(MTL::RenderCommandEncoder* encoder) const {
+    if (m_hasIBL && m_iblIrradiance && m_iblPrefiltered && m_iblBRDFLUT) {
+        encoder->setFragmentTexture(m_iblIrradiance, 8);
+        encoder->setFragmentTexture(m_iblPrefiltered, 9);
+        encoder->setFragmentTexture(m_iblBRDFLUT, 10);
+    } else if (usesSkyLighting()) {
+        encoder->setFragmentTexture(m_skyAtmosphere->getIrradiance(), 8);
+        encoder->setFragmentTexture(m_skyAtmosphere->getPrefiltered(), 9);
+        encoder->setFragmentTexture(m_iblBRDFLUT, 10);
+    }
 }
 
 bool Renderer::saveCookedEnvironmentMap(const std::string& path, const std::string& outputPath) {
@@ -7536,6 +11231,12 @@ bool Renderer::saveCookedEnvironmentMap(const std::string& path, const std::stri
                                          iblTextures.cubemap,
                                          iblTextures.prefiltered,
                                          iblTextures.irradiance);
+    // Players load the LUT next to their cooked environments instead of generating it.
+    const std::filesystem::path lutPath = std::filesystem::path(outputPath).parent_path() / IBLGenerator::kCookedBRDFLUTFileName;
+    std::error_code ec;
+    if (ok && !std::filesystem::exists(lutPath, ec)) {
+        ok = m_iblGenerator->saveBRDFLUT(lutPath.string());
+    }
     if (iblTextures.cubemap) {
         iblTextures.cubemap->release();
     }
@@ -7552,6 +11253,7 @@ bool Renderer::loadEnvironmentMap(const std::string& path, const std::string& co
     if (!m_textureLoader) {
         return false;
     }
+    StartupTraceScope trace("ibl", "Renderer::loadEnvironmentMap");
 
     std::shared_ptr<Texture2D> texture;
     std::string resolvedCookedPath = cookedIBLPath;
@@ -7564,34 +11266,33 @@ bool Renderer::loadEnvironmentMap(const std::string& path, const std::string& co
         texture = m_textureLoader->loadTexture(path, false, false);
     }
 
+    if (m_environmentProcessor) {
+        m_environmentProcessor->cancel();
+    }
     m_environmentTexture = texture ? texture
                                    : (m_defaultEnvironmentTexture ? m_defaultEnvironmentTexture : m_defaultWhiteTexture);
     m_environmentSettings.sourcePath = path;
     m_environmentSettings.cookedIBLPath = resolvedCookedPath;
-    
-    if (m_iblCubemap) {
-        m_iblCubemap->release();
-        m_iblCubemap = nullptr;
-    }
-    if (m_iblPrefiltered) {
-        m_iblPrefiltered->release();
-        m_iblPrefiltered = nullptr;
-    }
-    if (m_iblIrradiance) {
-        m_iblIrradiance->release();
-        m_iblIrradiance = nullptr;
-    }
-    m_hasIBL = false;
+    releaseEnvironmentLighting();
 
     if (!resolvedCookedPath.empty()) {
         MTL::Texture* cubemap = nullptr;
         MTL::Texture* prefiltered = nullptr;
         MTL::Texture* irradiance = nullptr;
+        StartupTraceScope cookedTrace("ibl", "Load cooked IBL", resolvedCookedPath);
         if (LoadCookedEnvironmentBlob(resolvedCookedPath, m_device, cubemap, prefiltered, irradiance)) {
             m_iblCubemap = cubemap;
             m_iblPrefiltered = prefiltered;
             m_iblIrradiance = irradiance;
             m_hasIBL = true;
+            if (m_iblGenerator && !m_iblGenerator->hasBRDFLUT()) {
+                const std::filesystem::path lutPath =
+                    std::filesystem::path(resolvedCookedPath).parent_path() / IBLGenerator::kCookedBRDFLUTFileName;
+                m_iblGenerator->loadBRDFLUT(lutPath.string());
+            }
+            if (m_iblGenerator) {
+                m_iblBRDFLUT = m_iblGenerator->getBRDFLUT();
+            }
             std::cout << "Loaded cooked IBL: " << resolvedCookedPath << std::endl;
             return texture != nullptr || sourcePath.extension() == ".cenv";
         }
@@ -7608,11 +11309,13 @@ bool Renderer::loadEnvironmentMap(const std::string& path, const std::string& co
 
         MTL::Texture* equirectTex = static_cast<MTL::Texture*>(texture->getHandle());
         if (equirectTex) {
+            StartupTraceScope generateTrace("ibl", "Generate IBL", path);
             auto iblTextures = m_iblGenerator->processEnvironmentMap(equirectTex);
             m_iblCubemap = iblTextures.cubemap;
             m_iblPrefiltered = iblTextures.prefiltered;
             m_iblIrradiance = iblTextures.irradiance;
             m_hasIBL = (m_iblCubemap && m_iblPrefiltered && m_iblIrradiance);
+            m_iblBRDFLUT = m_iblGenerator->getBRDFLUT();
 
             if (m_hasIBL) {
                 std::cout << "IBL processing complete - high quality IBL enabled" << std::endl;
@@ -7625,8 +11328,72 @@ bool Renderer::loadEnvironmentMap(const std::string& path, const std::string& co
     return true;
 }
 
-void Renderer::resetEnvironment() {
-    // Release IBL textures
+bool Renderer::requestEnvironmentMap(const std::string& path, const std::string& cookedIBLPath) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    // Cooked environments and LDR maps load in milliseconds; only raw HDR sources take seconds.
+    if (!m_environmentProcessor || !m_environmentProcessor->isAvailable() || !cookedIBLPath.empty() ||
+        (extension != ".hdr" && extension != ".exr")) {
+        return loadEnvironmentMap(path, cookedIBLPath);
+    }
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec)) {
+        return false;
+    }
+
+    EnvironmentProcessor::Request request;
+    request.path = path;
+    AssetDatabase& db = AssetDatabase::getInstance();
+    AssetRecord record;
+    if (db.getRecordForPath(path, record)) {
+        request.settings = record.hdriSettings;
+    }
+    if (!db.getLibraryPath().empty()) {
+        request.cacheDirectory = (std::filesystem::path(db.getLibraryPath()) / "ImportCache").string();
+    }
+    if (!m_environmentProcessor->getPendingId()) {
+        m_environmentFallbackPath = m_environmentSettings.sourcePath;
+        m_environmentFallbackCookedPath = m_environmentSettings.cookedIBLPath;
+    }
+    m_environmentSettings.sourcePath = path;
+    m_environmentSettings.cookedIBLPath.clear();
+    m_environmentProcessor->request(std::move(request));
+    return true;
+}
+
+bool Renderer::isEnvironmentLoading() const {
+    return m_environmentProcessor && m_environmentProcessor->getPendingId() != 0;
+}
+
+bool Renderer::collectEnvironment() {
+    EnvironmentProcessor::Result result;
+    if (!m_environmentProcessor || !m_environmentProcessor->collect(result)) {
+        return false;
+    }
+    if (!result.isComplete()) {
+        std::cerr << "Warning: environment map " << result.path << " failed to load, keeping the previous one" << std::endl;
+        m_environmentSettings.sourcePath = m_environmentFallbackPath;
+        m_environmentSettings.cookedIBLPath = m_environmentFallbackCookedPath;
+        return false;
+    }
+
+    releaseEnvironmentLighting();
+    // A cached result has no equirect; the skybox then samples the cubemap like a cooked one.
+    m_environmentTexture = result.equirect ? result.equirect
+                                           : (m_defaultEnvironmentTexture ? m_defaultEnvironmentTexture : m_defaultWhiteTexture);
+    m_iblCubemap = result.cubemap;
+    m_iblPrefiltered = result.prefiltered;
+    m_iblIrradiance = result.irradiance;
+    m_hasIBL = true;
+    if (m_iblGenerator) {
+        m_iblBRDFLUT = m_iblGenerator->getBRDFLUT();
+    }
+    std::cout << "Loaded environment " << result.path << (result.fromCache ? " from the IBL cache" : "") << std::endl;
+    return true;
+}
+
+void Renderer::releaseEnvironmentLighting() {
     if (m_iblCubemap) {
         m_iblCubemap->release();
         m_iblCubemap = nullptr;
@@ -7640,7 +11407,14 @@ void Renderer::resetEnvironment() {
         m_iblIrradiance = nullptr;
     }
     m_hasIBL = false;
-    
+}
+
+void Renderer::resetEnvironment() {
+    if (m_environmentProcessor) {
+        m_environmentProcessor->cancel();
+    }
+    releaseEnvironmentLighting();
+
     m_environmentTexture = m_defaultEnvironmentTexture ? m_defaultEnvironmentTexture : m_defaultWhiteTexture;
     m_environmentSettings = EnvironmentSettings(); // resets to defaults
 }
@@ -7742,13 +11516,1121 @@ void Renderer::setDebugDrawPointFrusta(bool enabled) {
     m_debugDrawPointFrusta = enabled;
 }
 
-void Renderer::renderMeshRenderer(MeshRenderer* renderer, Camera* camera, const std::vector<Light*>& lights) {
+void Renderer::setDebugDrawGPUPasses(bool enabled) {
+    m_debugDrawGPUPasses = enabled;
+}
+
+// One bar per GPUPass down the left edge of the view, 16.6 ms wide at the marker line. The debug
+// renderer only draws world-space lines, so the bars are unprojected onto a plane just past the
+// near clip; its line state ignores depth.
+void Renderer::drawGPUPassBars(Camera* camera) {
+    static const Math::Vector4 kPalette[6] = {
+        Math::Vector4(0.95f, 0.35f, 0.30f, 1.0f), Math::Vector4(0.95f, 0.70f, 0.25f, 1.0f),
+        Math::Vector4(0.45f, 0.85f, 0.35f, 1.0f), Math::Vector4(0.30f, 0.75f, 0.95f, 1.0f),
+        Math::Vector4(0.60f, 0.45f, 0.95f, 1.0f), Math::Vector4(0.90f, 0.45f, 0.80f, 1.0f)
+    };
+    constexpr float kLeft = -0.95f;
+    constexpr float kTop = 0.9f;
+    constexpr float kRowHeight = 0.05f;
+    constexpr float kBudgetWidth = 0.6f;
+    constexpr float kBudgetMs = 16.6f;
+    constexpr float kDepth = 0.01f;
+    const Math::Matrix4x4 inverseViewProjection = (camera->getProjectionMatrix() * camera->getViewMatrix()).inversed();
+    auto toWorld = [&](float x, float y) {
+        return inverseViewProjection.transformPoint(Math::Vector3(x, y, kDepth));
+    };
+
+    const float bottom = kTop - kRowHeight * static_cast<float>(kGPUPassCount);
+    m_debugRenderer->drawLine(toWorld(kLeft + kBudgetWidth, kTop + kRowHeight * 0.5f),
+                              toWorld(kLeft + kBudgetWidth, bottom), Math::Vector4(1.0f, 1.0f, 1.0f, 0.6f));
+    for (size_t pass = 0; pass < kGPUPassCount; ++pass) {
+        const float width = std::min(0.9f, m_stats.gpuPassTimeMs[pass] / kBudgetMs * kBudgetWidth);
+        if (width <= 0.001f) {
+            continue;
+        }
+        const float y = kTop - kRowHeight * static_cast<float>(pass);
+        const Math::Vector4& color = kPalette[pass % 6];
+        for (int line = 0; line < 4; ++line) {
+            const float lineY = y - 0.006f * static_cast<float>(line);
+            m_debugRenderer->drawLine(toWorld(kLeft, lineY), toWorld(kLeft + width, lineY), color);
+        }
+    }
+}
+
+// Static scene candidates: plain opaque MeshRenderers whose draw needs nothing per-object beyond
+// a world matrix. Skinned, lightmapped, vertex-lit, primitive, HLOD and transparent meshes stay
+// on the per-draw CPU path.
+static bool IsStaticSceneCandidate(const MeshRenderProxy& proxy,
+                                   const std::unordered_set<uint64_t>& hlodSources,
+                                   Mesh** outMesh,
+                                   Material** outMaterial) {
+    if (proxy.skinned || proxy.instanced || proxy.hlod || proxy.isPrimitive) {
+        return false;
+    }
+    Entity* entity = proxy.entity;
+    MeshRenderer* meshRenderer = proxy.meshRenderer;
+    if (!entity->isActiveInHierarchy() || !meshRenderer->isEnabled()) {
+        return false;
+    }
+    std::shared_ptr<Mesh> mesh = meshRenderer->getMesh();
+    if (!mesh || !mesh->getVertexBuffer() || !mesh->getIndexBuffer() || mesh->getIndexCount() == 0) {
+        return false;
+    }
+    std::shared_ptr<Material> material = meshRenderer->getMaterial(0);
+    if (!material || material->getRenderMode() == Material::RenderMode::Transparent || material->getAlpha() < 0.999f) {
+        return false;
+    }
+    if (meshRenderer->getUseBakedVertexLighting() || !meshRenderer->getStaticLighting().lightmapPath.empty()) {
+        return false;
+    }
+    if (!hlodSources.empty() && hlodSources.count(static_cast<uint64_t>(entity->getUUID())) > 0) {
+        return false;
+    }
+    *outMesh = mesh.get();
+    *outMaterial = material.get();
+    return true;
+}
+
+void Renderer::rebuildStaticScene(const RenderWorld& world) {
+    StaticSceneState& scene = m_staticScene;
+    scene.world = &world;
+    scene.worldVersion = world.getVersion();
+    scene.entries.clear();
+    scene.batches.clear();
+    scene.groups.clear();
+    scene.instanceData.clear();
+    scene.instanceBatches.clear();
+    scene.hlodSources.clear();
+
+    for (const auto& hlodProxy : world.getHLODProxies()) {
+        for (UUID src : hlodProxy.proxy->getSourceUuids()) {
+            scene.hlodSources.insert(static_cast<uint64_t>(src));
+        }
+    }
+
+    const auto& proxies = world.getMeshRenderers();
+    scene.proxyEntry.assign(proxies.size(), kNoStaticEntry);
+
+    struct Candidate {
+        uint32_t proxyIndex;
+        Mesh* mesh;
+        Material* material;
+        bool receiveShadows;
+    };
+    std::vector<Candidate> candidates;
+    candidates.reserve(proxies.size());
+    for (size_t i = 0; i < proxies.size(); ++i) {
+        Mesh* mesh = nullptr;
+        Material* material = nullptr;
+        if (IsStaticSceneCandidate(proxies[i], scene.hlodSources, &mesh, &material)) {
+            candidates.push_back({static_cast<uint32_t>(i), mesh, material, proxies[i].meshRenderer->getReceiveShadows()});
+        }
+    }
+
+    // Sort so batches sharing a material are adjacent; each material is then one ICB range.
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.material != b.material) {
+            return std::less<Material*>()(a.material, b.material);
+        }
+        if (a.receiveShadows != b.receiveShadows) {
+            return a.receiveShadows < b.receiveShadows;
+        }
+        return std::less<Mesh*>()(a.mesh, b.mesh);
+    });
+
+    scene.entries.reserve(candidates.size());
+    scene.instanceData.resize(candidates.size() * 2);
+    scene.instanceBatches.reserve(candidates.size());
+    for (const Candidate& candidate : candidates) {
+        const MeshRenderProxy& proxy = proxies[candidate.proxyIndex];
+        bool newGroup = scene.groups.empty()
+            || scene.groups.back().material.get() != candidate.material
+            || scene.groups.back().receiveShadows != candidate.receiveShadows;
+        if (newGroup) {
+            StaticSceneGroup group;
+            group.material = proxy.meshRenderer->getMaterial(0);
+            group.receiveShadows = candidate.receiveShadows;
+            group.firstBatch = static_cast<uint32_t>(scene.batches.size());
+            scene.groups.push_back(std::move(group));
+        }
+        if (newGroup || scene.batches.back().mesh != candidate.mesh) {
+            StaticSceneBatch batch;
+            batch.mesh = candidate.mesh;
+            batch.material = scene.groups.back().material;
+            batch.receiveShadows = candidate.receiveShadows;
+            batch.inputOffset = static_cast<uint32_t>(scene.entries.size());
+            batch.meshlets = m_meshletPipelineSupported && candidate.mesh->hasMeshlets();
+            scene.batches.push_back(std::move(batch));
+            scene.groups.back().batchCount++;
+        }
+        scene.batches.back().instanceCount++;
+
+        StaticSceneEntry entry;
+        entry.entity = proxy.entity;
+        entry.meshRenderer = proxy.meshRenderer;
+        entry.mesh = candidate.mesh;
+        entry.material = candidate.material;
+        entry.receiveShadows = candidate.receiveShadows;
+        entry.instanceIndex = static_cast<uint32_t>(scene.entries.size());
+        entry.worldMatrix = proxy.entity->getTransform()->getWorldMatrix();
+        scene.instanceData[entry.instanceIndex * 2] = entry.worldMatrix;
+        scene.instanceData[entry.instanceIndex * 2 + 1] = entry.worldMatrix.normalMatrix();
+        scene.instanceBatches.push_back(static_cast<uint32_t>(scene.batches.size() - 1));
+        scene.proxyEntry[candidate.proxyIndex] = entry.instanceIndex;
+        scene.entries.push_back(entry);
+    }
+
+    // Meshes with a LOD chain get one batch per level right after level 0; the cull kernel moves
+    // each instance into the level it selects, so every level needs its own culled range. The
+    // meshlet path always draws level 0.
+    std::vector<StaticSceneBatch> expanded;
+    std::vector<uint32_t> levelZero(scene.batches.size());
+    expanded.reserve(scene.batches.size());
+    for (StaticSceneGroup& group : scene.groups) {
+        const uint32_t firstBatch = group.firstBatch;
+        const uint32_t batchCount = group.batchCount;
+        group.firstBatch = static_cast<uint32_t>(expanded.size());
+        group.batchCount = 0;
+        for (uint32_t b = firstBatch; b < firstBatch + batchCount; ++b) {
+            StaticSceneBatch& batch = scene.batches[b];
+            const uint32_t lodCount = batch.meshlets ? 1u : batch.mesh->getLodCount();
+            levelZero[b] = static_cast<uint32_t>(expanded.size());
+            for (uint32_t lod = 0; lod < lodCount; ++lod) {
+                StaticSceneBatch level = batch;
+                level.lod = lod;
+                level.lodCount = lod == 0 ? lodCount : 1u;
+                expanded.push_back(std::move(level));
+            }
+            group.batchCount += lodCount;
+        }
+    }
+    for (uint32_t& batchIndex : scene.instanceBatches) {
+        batchIndex = levelZero[batchIndex];
+    }
+    scene.batches = std::move(expanded);
+    scene.culledCapacity = 0;
+    for (StaticSceneBatch& batch : scene.batches) {
+        batch.outputOffset = scene.culledCapacity;
+        scene.culledCapacity += batch.instanceCount;
+    }
+
+    scene.layoutVersion++;
+    scene.instanceVersion++;
+}
+
+bool Renderer::updateStaticScene(const RenderWorld& world, uint32_t bufferSlot) {
+    if (!m_staticCullPipeline || !m_staticEncodePipeline) {
+        return false;
+    }
+
+    StaticSceneState& scene = m_staticScene;
+    bool rebuild = scene.world != &world || scene.worldVersion != world.getVersion();
+    if (!rebuild) {
+        // Eligibility, mesh, material or shadow changes re-batch; moved entities only rewrite
+        // their matrices.
+        const auto& proxies = world.getMeshRenderers();
+        bool instancesChanged = false;
+        for (size_t i = 0; i < proxies.size() && !rebuild; ++i) {
+            Mesh* mesh = nullptr;
+            Material* material = nullptr;
+            bool candidate = IsStaticSceneCandidate(proxies[i], scene.hlodSources, &mesh, &material);
+            uint32_t entryIndex = scene.proxyEntry[i];
+            if (candidate != (entryIndex != kNoStaticEntry)) {
+                rebuild = true;
+                break;
+            }
+            if (!candidate) {
+                continue;
+            }
+            StaticSceneEntry& entry = scene.entries[entryIndex];
+            if (entry.mesh != mesh || entry.material != material
+                || entry.receiveShadows != proxies[i].meshRenderer->getReceiveShadows()) {
+                rebuild = true;
+                break;
+            }
+            const Math::Matrix4x4& worldMatrix = entry.entity->getTransform()->getWorldMatrix();
+            if (std::memcmp(&worldMatrix, &entry.worldMatrix, sizeof(Math::Matrix4x4)) != 0) {
+                entry.worldMatrix = worldMatrix;
+                scene.instanceData[entry.instanceIndex * 2] = worldMatrix;
+                scene.instanceData[entry.instanceIndex * 2 + 1] = worldMatrix.normalMatrix();
+                instancesChanged = true;
+            }
+        }
+        if (instancesChanged && !rebuild) {
+            scene.instanceVersion++;
+        }
+    }
+    if (rebuild) {
+        rebuildStaticScene(world);
+    }
+
+    if (scene.entries.empty()) {
+        return false;
+    }
+    return ensureStaticSceneFrame(bufferSlot);
+}
+
+bool Renderer::ensureStaticSceneFrame(uint32_t bufferSlot) {
+    StaticSceneState& scene = m_staticScene;
+    StaticSceneFrame& frame = m_staticSceneFrames[bufferSlot];
+    const size_t instanceCount = scene.entries.size();
+    const size_t batchCount = scene.batches.size();
+
+    auto ensure = [&](MTL::Buffer*& buffer, size_t bytes) {
+        if (!buffer || buffer->length() < bytes) {
+            if (buffer) {
+                buffer->release();
+            }
+            buffer = m_device->newBuffer(std::max<size_t>(bytes, 256), MTL::ResourceStorageModeShared);
+        }
+        return buffer != nullptr;
+    };
+
+    if (frame.instanceCapacity < instanceCount) {
+        size_t capacity = std::max(instanceCount, frame.instanceCapacity * 2);
+        if (!ensure(frame.instances, capacity * sizeof(InstanceDataGPU))
+            || !ensure(frame.instanceBatches, capacity * sizeof(uint32_t))) {
+            return false;
+        }
+        frame.instanceCapacity = capacity;
+        frame.instanceVersion = 0;
+        frame.layoutVersion = 0;
+    }
+    if (frame.culledCapacity < scene.culledCapacity) {
+        size_t capacity = std::max<size_t>(scene.culledCapacity, frame.culledCapacity * 2);
+        if (!ensure(frame.culledInstances, capacity * sizeof(InstanceDataGPU))) {
+            return false;
+        }
+        frame.culledCapacity = capacity;
+    }
+
+    if (frame.batchCapacity < batchCount) {
+        size_t capacity = std::max(batchCount, frame.batchCapacity * 2);
+        if (!ensure(frame.batches, StaticBatchTableBytes(capacity) + capacity * kStaticUniformStride)
+            || !ensure(frame.counts, capacity * sizeof(uint32_t))) {
+            return false;
+        }
+        if (frame.mainCommands) {
+            frame.mainCommands->release();
+            frame.mainCommands = nullptr;
+        }
+        if (frame.prepassCommands) {
+            frame.prepassCommands->release();
+            frame.prepassCommands = nullptr;
+        }
+        MTL::IndirectCommandBufferDescriptor* icbDesc = MTL::IndirectCommandBufferDescriptor::alloc()->init();
+        icbDesc->setCommandTypes(MTL::IndirectCommandTypeDrawIndexed);
+        icbDesc->setInheritPipelineState(true);
+        icbDesc->setInheritBuffers(false);
+        icbDesc->setMaxVertexBufferBindCount(GeometryBuffer::kAttributeBufferIndex + 1);
+        icbDesc->setMaxFragmentBufferBindCount(12);
+        frame.mainCommands = m_device->newIndirectCommandBuffer(icbDesc, capacity, MTL::ResourceStorageModePrivate);
+        frame.prepassCommands = m_device->newIndirectCommandBuffer(icbDesc, capacity, MTL::ResourceStorageModePrivate);
+        icbDesc->release();
+        if (!frame.mainCommands || !frame.prepassCommands) {
+            std::cerr << "Failed to create static scene indirect command buffers\n";
+            return false;
+        }
+        if (!ensure(frame.icbArguments, sizeof(MTL::ResourceID) * 2)) {
+            return false;
+        }
+        auto* icbIds = static_cast<MTL::ResourceID*>(frame.icbArguments->contents());
+        icbIds[0] = frame.mainCommands->gpuResourceID();
+        icbIds[1] = frame.prepassCommands->gpuResourceID();
+        frame.batchCapacity = capacity;
+    }
+
+    if (!frame.bindings && !ensure(frame.bindings, 1024)) {
+        return false;
+    }
+
+    if (frame.layoutVersion != scene.layoutVersion) {
+        std::memcpy(frame.instanceBatches->contents(), scene.instanceBatches.data(), instanceCount * sizeof(uint32_t));
+        frame.layoutVersion = scene.layoutVersion;
+        m_stats.instanceBytesUploaded += instanceCount * sizeof(uint32_t);
+    }
+    if (frame.instanceVersion != scene.instanceVersion) {
+        static_assert(sizeof(InstanceDataGPU) == sizeof(Math::Matrix4x4) * 2, "InstanceDataGPU layout changed");
+        std::memcpy(frame.instances->contents(), scene.instanceData.data(), instanceCount * sizeof(InstanceDataGPU));
+        frame.instanceVersion = scene.instanceVersion;
+        m_stats.instanceBytesUploaded += instanceCount * sizeof(InstanceDataGPU);
+    }
+
+    // Material parameters are edited live, so the batch table and its uniforms are written every
+    // frame; it is one small block per batch rather than per instance.
+    auto* batchBytes = static_cast<uint8_t*>(frame.batches->contents());
+    auto* batchTable = reinterpret_cast<StaticBatchGPU*>(batchBytes);
+    const size_t uniformBase = StaticBatchTableBytes(frame.batchCapacity);
+    const uint64_t batchesAddress = frame.batches->gpuAddress();
+    scene.meshResources.clear();
+    for (size_t i = 0; i < batchCount; ++i) {
+        const StaticSceneBatch& batch = scene.batches[i];
+        MTL::Buffer* vertexBuffer = static_cast<MTL::Buffer*>(batch.mesh->getVertexBuffer());
+        MTL::Buffer* attributeBuffer = static_cast<MTL::Buffer*>(batch.mesh->getAttributeBuffer());
+        MTL::Buffer* indexBuffer = static_cast<MTL::Buffer*>(batch.mesh->getIndexBuffer());
+        const size_t uniformOffset = uniformBase + i * kStaticUniformStride;
+        Math::Vector3 boundsCenter = batch.mesh->getBoundsCenter();
+        Math::Vector3 boundsSize = batch.mesh->getBoundsSize();
+
+        MaterialUniformsGPU matUniforms = BuildMaterialUniforms(batch.material.get(), batch.receiveShadows);
+        MeshUniformsGPU meshUniforms{};
+        meshUniforms.boundsCenter = Math::Vector4(boundsCenter.x, boundsCenter.y, boundsCenter.z, 0.0f);
+        meshUniforms.boundsSize = Math::Vector4(boundsSize.x, boundsSize.y, boundsSize.z, 0.0f);
+        meshUniforms.flags = Math::Vector4(0.0f);
+        meshUniforms.lightmapScaleOffset = Math::Vector4(1.0f, 1.0f, 0.0f, 0.0f);
+        std::memcpy(batchBytes + uniformOffset, &matUniforms, sizeof(MaterialUniformsGPU));
+        std::memcpy(batchBytes + uniformOffset + kStaticMeshUniformOffset, &meshUniforms, sizeof(MeshUniformsGPU));
+
+        StaticBatchGPU& gpu = batchTable[i];
+        gpu.boundsCenterRadius = Math::Vector4(boundsCenter.x, boundsCenter.y, boundsCenter.z,
+                                               0.5f * boundsSize.length() * kCullTightness);
+        gpu.inputOffset = batch.inputOffset;
+        gpu.instanceCount = batch.instanceCount;
+        gpu.outputOffset = batch.outputOffset;
+        gpu.indexCount = batch.mesh->getLodIndexCount(batch.lod);
+        gpu.vertices = vertexBuffer->gpuAddress() + batch.mesh->getVertexBufferOffset();
+        gpu.attributes = attributeBuffer->gpuAddress() + batch.mesh->getAttributeBufferOffset();
+        gpu.indices = indexBuffer->gpuAddress() + batch.mesh->getLodIndexBufferOffset(batch.lod);
+        gpu.material = batchesAddress + uniformOffset;
+        gpu.mesh = batchesAddress + uniformOffset + kStaticMeshUniformOffset;
+        gpu.meshletCount = batch.drawsMeshlets() ? static_cast<uint32_t>(batch.mesh->getMeshlets().size()) : 0u;
+        gpu.lodCount = batch.lodCount;
+        gpu.lodErrors = Math::Vector4(batch.mesh->getLodError(1), batch.mesh->getLodError(2),
+                                      batch.mesh->getLodError(3), batch.mesh->getLodError(4));
+
+        // Every mesh lives in the shared geometry arenas, so this is usually just three entries.
+        for (const MTL::Resource* resource : {static_cast<const MTL::Resource*>(vertexBuffer),
+                                              static_cast<const MTL::Resource*>(attributeBuffer),
+                                              static_cast<const MTL::Resource*>(indexBuffer)}) {
+            if (std::find(scene.meshResources.begin(), scene.meshResources.end(), resource) == scene.meshResources.end()) {
+                scene.meshResources.push_back(resource);
+            }
+        }
+    }
+    if (m_sceneResidency) {
+        m_sceneResidency->use(scene.meshResources.data(), scene.meshResources.size());
+    }
+    return true;
+}
+
+void Renderer::dispatchStaticSceneCulling(MTL::CommandBuffer* commandBuffer,
+                                          uint32_t bufferSlot,
+                                          const Math::FrustumPlanes& frustumPlanes,
+                                          const Math::Vector2& screenSize,
+                                          bool useHzb,
+                                          bool encodePrepass) {
+    StaticSceneFrame& frame = m_staticSceneFrames[bufferSlot];
+    MTL::ComputePipelineState* cullPipeline = useHzb ? m_staticCullHzbPipeline : m_staticCullPipeline;
+    if (!cullPipeline || (useHzb && !m_hzbTexture)) {
+        return;
+    }
+    const uint32_t instanceCount = static_cast<uint32_t>(m_staticScene.entries.size());
+    const uint32_t batchCount = static_cast<uint32_t>(m_staticScene.batches.size());
+
+    MTL::BlitCommandEncoder* blit = commandBuffer->blitCommandEncoder();
+    blit->fillBuffer(frame.counts, NS::Range::Make(0, batchCount * sizeof(uint32_t)), 0);
+    blit->endEncoding();
+
+    StaticCullParamsGPU params{};
+    for (int p = 0; p < 6; ++p) {
+        params.frustumPlanes[p] = frustumPlanes[p];
+    }
+    params.screenSize = screenSize;
+    params.instanceCount = instanceCount;
+    params.hzbMipCount = std::max(1u, m_hzbMipCount);
+    params.batchCount = batchCount;
+    params.encodePrepass = encodePrepass ? 1u : 0u;
+    params.lodPixelError = m_lodPixelError;
+    params.lodView = m_lodView;
+
+    // Serial dispatch: the encode pass sees every count the cull pass wrote.
+    MTL::ComputeCommandEncoder* encoder = commandBuffer->computeCommandEncoder();
+    encoder->setComputePipelineState(cullPipeline);
+    encoder->setBuffer(frame.instances, 0, 0);
+    encoder->setBuffer(frame.instanceBatches, 0, 1);
+    encoder->setBuffer(frame.batches, 0, 2);
+    encoder->setBuffer(frame.culledInstances, 0, 3);
+    encoder->setBuffer(frame.counts, 0, 4);
+    encoder->setBytes(&params, sizeof(StaticCullParamsGPU), 5);
+    if (useHzb) {
+        encoder->setBuffer(m_cameraUniformBuffer, 0, 6);
+        encoder->setTexture(m_hzbTexture, 0);
+    }
+    const uint32_t threads = 64;
+    encoder->dispatchThreads(MTL::Size((instanceCount + threads - 1) / threads * threads, 1, 1),
+                             MTL::Size(threads, 1, 1));
+
+    encoder->setComputePipelineState(m_staticEncodePipeline);
+    encoder->setBuffer(frame.batches, 0, 0);
+    encoder->setBuffer(frame.counts, 0, 1);
+    encoder->setBuffer(frame.bindings, 0, 2);
+    encoder->setBuffer(frame.icbArguments, 0, 3);
+    encoder->setBytes(&params, sizeof(StaticCullParamsGPU), 4);
+    encoder->useResource(frame.mainCommands, MTL::ResourceUsageWrite);
+    if (encodePrepass) {
+        encoder->useResource(frame.prepassCommands, MTL::ResourceUsageWrite);
+    }
+    encoder->dispatchThreads(MTL::Size((batchCount + threads - 1) / threads * threads, 1, 1),
+                             MTL::Size(threads, 1, 1));
+    encoder->endEncoding();
+}
+
+void Renderer::writeStaticSceneBindings(uint32_t bufferSlot) {
+    StaticSceneFrame& frame = m_staticSceneFrames[bufferSlot];
+    // Layout: bindings table, probe volume uniforms at 256, a zeroed block at 512 standing in for
+    // optional inputs (light count, clusters) that are not allocated this frame.
+    auto* bytes = static_cast<uint8_t*>(frame.bindings->contents());
+    const uint64_t base = frame.bindings->gpuAddress();
+    const uint64_t zeroBlock = base + 512;
+    std::memset(bytes + 512, 0, 512);
+
+    ProbeVolumeUniformsGPU probeUniforms{};
+    fillProbeVolumeUniforms(probeUniforms);
+    std::memcpy(bytes + 256, &probeUniforms, sizeof(ProbeVolumeUniformsGPU));
+
+    auto address = [&](MTL::Buffer* buffer) {
+        return buffer ? buffer->gpuAddress() : zeroBlock;
+    };
+    MTL::Buffer* probeBuffer = m_probeVolumeBuffer ? m_probeVolumeBuffer : m_probeVolumeFallbackBuffer;
+    auto* bindings = reinterpret_cast<StaticFrameBindingsGPU*>(bytes);
+    bindings->culledInstances = frame.culledInstances->gpuAddress();
+    bindings->camera = address(m_cameraUniformBuffer);
+    bindings->light = address(m_lightUniformBuffer);
+    bindings->environment = address(m_environmentUniformBuffer);
+    bindings->lights = address(m_lightGPUBuffer);
+    bindings->shadows = address(m_shadowGPUBuffer);
+    bindings->lightCount = address(m_lightCountBuffer);
+    bindings->clusterHeaders = address(m_clusterHeaderBuffer);
+    bindings->clusterIndices = address(m_clusterIndexBuffer);
+    bindings->clusterParams = address(m_clusterParamsBuffer);
+    bindings->probeVolume = base + 256;
+    bindings->probeData = address(probeBuffer);
+}
+
+void Renderer::useStaticSceneResources(MTL::RenderCommandEncoder* encoder, uint32_t bufferSlot, bool mainPass) {
+    StaticSceneFrame& frame = m_staticSceneFrames[bufferSlot];
+    const auto stages = static_cast<MTL::RenderStages>(MTL::RenderStageVertex | MTL::RenderStageFragment);
+    if (!m_staticScene.meshResources.empty() && !m_sceneResidency) {
+        encoder->useResources(m_staticScene.meshResources.data(), m_staticScene.meshResources.size(),
+                              MTL::ResourceUsageRead, MTL::RenderStageVertex);
+    }
+
+    MTL::Buffer* probeBuffer = m_probeVolumeBuffer ? m_probeVolumeBuffer : m_probeVolumeFallbackBuffer;
+    std::array<const MTL::Resource*, 14> resources{};
+    size_t count = 0;
+    auto add = [&](MTL::Buffer* buffer) {
+        if (buffer) {
+            resources[count++] = buffer;
+        }
+    };
+    add(frame.culledInstances);
+    add(frame.batches);
+    add(m_cameraUniformBuffer);
+    if (mainPass) {
+        add(frame.bindings);
+        add(m_lightUniformBuffer);
+        add(m_environmentUniformBuffer);
+        add(m_lightGPUBuffer);
+        add(m_shadowGPUBuffer);
+        add(m_lightCountBuffer);
+        add(m_clusterHeaderBuffer);
+        add(m_clusterIndexBuffer);
+        add(m_clusterParamsBuffer);
+        add(probeBuffer);
+    }
+    encoder->useResources(resources.data(), count, MTL::ResourceUsageRead, stages);
+}
+
+bool Renderer::StaticSceneBatch::drawsMeshlets() const {
+    return meshlets && mesh && mesh->getMeshletBuffer();
+}
+
+void Renderer::encodeStaticMeshlets(MTL::RenderCommandEncoder* encoder,
+                                    uint32_t bufferSlot,
+                                    size_t groupIndex,
+                                    const Math::FrustumPlanes& frustumPlanes,
+                                    const Math::Vector2& screenSize,
+                                    bool useHzb) {
+    const StaticSceneGroup& group = m_staticScene.groups[groupIndex];
+    bool anyMeshlets = false;
+    for (uint32_t i = 0; i < group.batchCount && !anyMeshlets; ++i) {
+        anyMeshlets = m_staticScene.batches[group.firstBatch + i].drawsMeshlets();
+    }
+    if (!anyMeshlets) {
+        return;
+    }
+
+    Material* material = group.material.get();
+    bool alphaToCoverage = material && material->getRenderMode() == Material::RenderMode::Cutout
+        && material->getAlphaToCoverage();
+    PipelineStateKey pipelineKey{true, true, true, false, false, true, alphaToCoverage, m_outputHDR, static_cast<uint8_t>(m_msaaSamples)};
+    pipelineKey.isMeshlet = true;
+    MTL::RenderPipelineState* pipelineState = getPipelineState(pipelineKey);
+    if (!pipelineState) {
+        return;
+    }
+    encoder->setRenderPipelineState(pipelineState);
+
+    const StaticSceneFrame& frame = m_staticSceneFrames[bufferSlot];
+    bindStaticSceneFragmentInputs(encoder, bufferSlot);
+
+    MeshletCullParamsGPU params{};
+    for (int p = 0; p < 6; ++p) {
+        params.frustumPlanes[p] = frustumPlanes[p];
+    }
+    params.screenSize = screenSize;
+    params.hzbMipCount = std::max(1u, m_hzbMipCount);
+    params.useHzb = (useHzb && m_hzbTexture) ? 1u : 0u;
+    // The cone test assumes back faces are the culled ones.
+    params.coneCulling = (material && (material->isTwoSided() || material->getCullMode() != Material::CullMode::Back)) ? 0u : 1u;
+
+    encoder->setObjectBuffer(m_cameraUniformBuffer, 0, 2);
+    encoder->setMeshBuffer(m_cameraUniformBuffer, 0, 2);
+    if (m_hzbTexture) {
+        encoder->setObjectTexture(m_hzbTexture, 0);
+    }
+
+    const size_t uniformBase = StaticBatchTableBytes(frame.batchCapacity);
+    for (uint32_t i = 0; i < group.batchCount; ++i) {
+        const uint32_t batchIndex = group.firstBatch + i;
+        const StaticSceneBatch& batch = m_staticScene.batches[batchIndex];
+        if (!batch.drawsMeshlets() || batch.instanceCount == 0) {
+            continue;
+        }
+        Mesh* mesh = batch.mesh;
+        MTL::Buffer* meshletBuffer = static_cast<MTL::Buffer*>(mesh->getMeshletBuffer());
+        const size_t instanceOffset = static_cast<size_t>(batch.inputOffset) * sizeof(InstanceDataGPU);
+        const size_t uniformOffset = uniformBase + batchIndex * kStaticUniformStride;
+        params.meshletCount = static_cast<uint32_t>(mesh->getMeshlets().size());
+
+        encoder->setObjectBuffer(meshletBuffer, mesh->getMeshletBufferOffset(), 0);
+        encoder->setObjectBuffer(frame.instances, instanceOffset, 1);
+        encoder->setObjectBytes(&params, sizeof(MeshletCullParamsGPU), 3);
+
+        encoder->setMeshBuffer(meshletBuffer, mesh->getMeshletBufferOffset(), 0);
+        encoder->setMeshBuffer(frame.instances, instanceOffset, 1);
+        encoder->setMeshBuffer(frame.batches, uniformOffset, 3);
+        encoder->setMeshBuffer(frame.batches, uniformOffset + kStaticMeshUniformOffset, 4);
+        encoder->setMeshBuffer(meshletBuffer, mesh->getMeshletVertexBufferOffset(), 5);
+        encoder->setMeshBuffer(meshletBuffer, mesh->getMeshletTriangleBufferOffset(), 6);
+        encoder->setMeshBuffer(static_cast<MTL::Buffer*>(mesh->getVertexBuffer()), mesh->getVertexBufferOffset(), 7);
+        encoder->setMeshBuffer(static_cast<MTL::Buffer*>(mesh->getAttributeBuffer()), mesh->getAttributeBufferOffset(), 8);
+        encoder->setFragmentBuffer(frame.batches, uniformOffset, 1);
+
+        const uint32_t objectGroups = (params.meshletCount + kMeshletsPerObjectThreadgroup - 1) / kMeshletsPerObjectThreadgroup;
+        encoder->drawMeshThreadgroups(MTL::Size(objectGroups, batch.instanceCount, 1),
+                                      MTL::Size(kMeshletsPerObjectThreadgroup, 1, 1),
+                                      MTL::Size(kMeshletMeshThreads, 1, 1));
+        m_stats.drawCalls++;
+    }
+}
+
+void Renderer::bindStaticSceneFragmentInputs(MTL::RenderCommandEncoder* encoder, uint32_t bufferSlot) {
+    const StaticSceneFrame& frame = m_staticSceneFrames[bufferSlot];
+    // Fragment inputs mirror encodeStaticDraw; missing optional buffers read the zeroed block.
+    auto bindFragment = [&](MTL::Buffer* buffer, NS::UInteger index) {
+        if (buffer) {
+            encoder->setFragmentBuffer(buffer, 0, index);
+        } else {
+            encoder->setFragmentBuffer(frame.bindings, 512, index);
+        }
+    };
+    MTL::Buffer* probeBuffer = m_probeVolumeBuffer ? m_probeVolumeBuffer : m_probeVolumeFallbackBuffer;
+    bindFragment(m_cameraUniformBuffer, 0);
+    bindFragment(m_lightUniformBuffer, 2);
+    bindFragment(m_environmentUniformBuffer, 3);
+    bindFragment(m_lightGPUBuffer, 4);
+    bindFragment(m_shadowGPUBuffer, 5);
+    bindFragment(m_lightCountBuffer, 6);
+    bindFragment(m_clusterHeaderBuffer, 7);
+    bindFragment(m_clusterIndexBuffer, 8);
+    bindFragment(m_clusterParamsBuffer, 9);
+    encoder->setFragmentBuffer(frame.bindings, 256, 10);
+    bindFragment(probeBuffer, 11);
+}
+
+void Renderer::encodeVisibilityBuffer(MTL::CommandBuffer* commandBuffer, uint32_t bufferSlot, const MTL::Viewport& viewport) {
+    const StaticSceneFrame& frame = m_staticSceneFrames[bufferSlot];
+    const uint32_t tilesX = (static_cast<uint32_t>(viewport.width) + kVisibilityTileSize - 1) / kVisibilityTileSize;
+    const uint32_t tilesY = (static_cast<uint32_t>(viewport.height) + kVisibilityTileSize - 1) / kVisibilityTileSize;
+
+    // Pixels no static batch wins keep the all-ones id. Depth is only tested, but the main pass
+    // loads it again, so it is stored.
+    MTL::RenderPassDescriptor* pass = MTL::RenderPassDescriptor::alloc()->init();
+    MTL::RenderPassColorAttachmentDescriptor* ids = pass->colorAttachments()->object(0);
+    ids->setTexture(m_visibilityTexture);
+    ids->setLoadAction(MTL::LoadActionClear);
+    ids->setClearColor(MTL::ClearColor::Make(4294967295.0, 4294967295.0, 0.0, 0.0));
+    ids->setStoreAction(MTL::StoreActionStore);
+    pass->depthAttachment()->setTexture(m_depthTexture);
+    pass->depthAttachment()->setLoadAction(MTL::LoadActionLoad);
+    pass->depthAttachment()->setStoreAction(MTL::StoreActionStore);
+    MTL::RenderCommandEncoder* encoder = commandBuffer->renderCommandEncoder(pass);
+    pass->release();
+
+    encoder->setRenderPipelineState(m_visibilityPipeline);
+    encoder->setDepthStencilState(m_depthReadState);
+    encoder->setFrontFacingWinding(MTL::WindingCounterClockwise);
+    encoder->setViewport(viewport);
+    // The main pass commands bind its lighting inputs too, so they have to be resident.
+    useStaticSceneResources(encoder, bufferSlot, true);
+    for (const auto& group : m_staticScene.groups) {
+        bindPrepassMaterialTextures(encoder, group.material.get());
+        encoder->setCullMode(ResolveCullMode(group.material.get()));
+        encoder->executeCommandsInBuffer(frame.mainCommands, NS::Range::Make(group.firstBatch, group.batchCount));
+    }
+    encoder->endEncoding();
+
+    VisibilityShadeParamsGPU params{};
+    params.screenSize = Math::Vector2(static_cast<float>(viewport.width), static_cast<float>(viewport.height));
+    params.tilesX = tilesX;
+    params.batchCount = static_cast<uint32_t>(m_staticScene.batches.size());
+
+    MTL::BlitCommandEncoder* blit = commandBuffer->blitCommandEncoder();
+    blit->fillBuffer(m_visibilityTileRanges, NS::Range::Make(0, size_t(tilesX) * tilesY * 2 * sizeof(uint32_t)), 0xFF);
+    blit->endEncoding();
+
+    MTL::ComputeCommandEncoder* compute = commandBuffer->computeCommandEncoder();
+    compute->setComputePipelineState(m_visibilityClassifyPipeline);
+    compute->setTexture(m_visibilityTexture, 0);
+    compute->setBuffer(frame.batches, 0, 0);
+    compute->setBuffer(m_visibilityTileRanges, 0, 1);
+    compute->setBytes(&params, sizeof(VisibilityShadeParamsGPU), 2);
+    const uint32_t threadsPerSide = kVisibilityTileSize / 2;
+    compute->dispatchThreadgroups(MTL::Size(tilesX, tilesY, 1), MTL::Size(threadsPerSide, threadsPerSide, 1));
+    compute->endEncoding();
+}
+
+bool Renderer::encodeStaticVisibility(MTL::RenderCommandEncoder* encoder,
+                                      uint32_t bufferSlot,
+                                      size_t groupIndex,
+                                      const MTL::Viewport& viewport) {
+    PipelineStateKey pipelineKey{true, true, true, false, false, false, false, m_outputHDR, 1};
+    pipelineKey.pbrFeatures = kPbrFeatureAll | pbrPrecisionFeatures();
+    pipelineKey.isVisibility = true;
+    MTL::RenderPipelineState* pipelineState = getPipelineState(pipelineKey);
+    if (!pipelineState) {
+        return false;
+    }
+
+    const StaticSceneFrame& frame = m_staticSceneFrames[bufferSlot];
+    const StaticSceneGroup& group = m_staticScene.groups[groupIndex];
+    const uint32_t tilesX = (static_cast<uint32_t>(viewport.width) + kVisibilityTileSize - 1) / kVisibilityTileSize;
+    const uint32_t tilesY = (static_cast<uint32_t>(viewport.height) + kVisibilityTileSize - 1) / kVisibilityTileSize;
+    VisibilityShadeParamsGPU params{};
+    params.screenSize = Math::Vector2(static_cast<float>(viewport.width), static_cast<float>(viewport.height));
+    params.tilesX = tilesX;
+    params.batchCount = static_cast<uint32_t>(m_staticScene.batches.size());
+    params.firstBatch = group.firstBatch;
+    params.batchRange = group.batchCount;
+
+    encoder->setRenderPipelineState(pipelineState);
+    encoder->setCullMode(MTL::CullModeNone);
+    encoder->setDepthStencilState(m_depthReadState);
+    bindStaticSceneFragmentInputs(encoder, bufferSlot);
+    // Every batch of the group shares its material uniforms.
+    encoder->setFragmentBuffer(frame.batches, StaticBatchTableBytes(frame.batchCapacity) + group.firstBatch * kStaticUniformStride, 1);
+    encoder->setFragmentBytes(&params, sizeof(VisibilityShadeParamsGPU), 15);
+    encoder->setFragmentBuffer(frame.batches, 0, 16);
+    encoder->setFragmentBuffer(frame.culledInstances, 0, 17);
+    encoder->setFragmentTexture(m_visibilityTexture, 39);
+    encoder->setVertexBytes(&params, sizeof(VisibilityShadeParamsGPU), 0);
+    encoder->setVertexBuffer(m_visibilityTileRanges, 0, 1);
+    encoder->drawPrimitives(MTL::PrimitiveTypeTriangleStrip, NS::UInteger(0), NS::UInteger(4), NS::UInteger(tilesX * tilesY));
+    encoder->setDepthStencilState(m_depthStencilState);
+    m_stats.drawCalls++;
+    m_stats.visibilityGroups++;
+    return true;
+}
+
+uint32_t Renderer::bindPrepassMaterialTextures(MTL::RenderCommandEncoder* encoder, const Material* material) {
+    auto albedoTex = (material && material->getAlbedoTexture()) ? material->getAlbedoTexture() : m_defaultWhiteTexture;
+    auto roughnessTex = (material && material->getRoughnessTexture()) ? material->getRoughnessTexture() : m_defaultWhiteTexture;
+    auto ormTex = (material && material->getORMTexture()) ? material->getORMTexture() : m_defaultBlackTexture;
+    auto terrainControlTex = (material && material->getTerrainControlTexture()) ? material->getTerrainControlTexture() : m_defaultWhiteTexture;
+    auto terrainLayer0Tex = (material && material->getTerrainLayer0Texture()) ? material->getTerrainLayer0Texture() : albedoTex;
+    auto terrainLayer1Tex = (material && material->getTerrainLayer1Texture()) ? material->getTerrainLayer1Texture() : albedoTex;
+    auto terrainLayer2Tex = (material && material->getTerrainLayer2Texture()) ? material->getTerrainLayer2Texture() : albedoTex;
+    auto terrainLayer0OrmTex = (material && material->getTerrainLayer0ORMTexture()) ? material->getTerrainLayer0ORMTexture() : m_defaultWhiteTexture;
+    auto terrainLayer1OrmTex = (material && material->getTerrainLayer1ORMTexture()) ? material->getTerrainLayer1ORMTexture() : m_defaultWhiteTexture;
+    auto terrainLayer2OrmTex = (material && material->getTerrainLayer2ORMTexture()) ? material->getTerrainLayer2ORMTexture() : m_defaultWhiteTexture;
+    encoder->setFragmentTexture(albedoTex ? albedoTex->getHandle() : nullptr, 2);
+    encoder->setFragmentTexture(roughnessTex ? roughnessTex->getHandle() : nullptr, 0);
+    encoder->setFragmentTexture(ormTex ? ormTex->getHandle() : nullptr, 1);
+    encoder->setFragmentTexture(terrainControlTex ? terrainControlTex->getHandle() : nullptr, 3);
+    encoder->setFragmentTexture(terrainLayer0Tex ? terrainLayer0Tex->getHandle() : nullptr, 4);
+    encoder->setFragmentTexture(terrainLayer1Tex ? terrainLayer1Tex->getHandle() : nullptr, 5);
+    encoder->setFragmentTexture(terrainLayer2Tex ? terrainLayer2Tex->getHandle() : nullptr, 6);
+    encoder->setFragmentTexture(terrainLayer0OrmTex ? terrainLayer0OrmTex->getHandle() : nullptr, 7);
+    encoder->setFragmentTexture(terrainLayer1OrmTex ? terrainLayer1OrmTex->getHandle() : nullptr, 8);
+    encoder->setFragmentTexture(terrainLayer2OrmTex ? terrainLayer2OrmTex->getHandle() : nullptr, 9);
+    if (m_samplerState) {
+        encoder->setFragmentSamplerState(m_samplerState, 0);
+    }
+    return 10;
+}
+
+void Renderer::resolveMainMaterialTextures(const Material* material, MTL::Texture** textures) const {
+    auto pick = [](const std::shared_ptr<Texture2D>& texture, const std::shared_ptr<Texture2D>& fallback) {
+        const std::shared_ptr<Texture2D>& chosen = texture ? texture : fallback;
+        return chosen ? chosen->getHandle() : nullptr;
+    };
+    std::shared_ptr<Texture2D> none;
+    bool hasORMTex = material && material->getORMTexture();
+    const auto& ormTex = hasORMTex ? material->getORMTexture() : none;
+    auto metallicTex = material ? material->getMetallicTexture() : none;
+    auto roughnessTex = material ? material->getRoughnessTexture() : none;
+    if (hasORMTex && metallicTex == ormTex) {
+        metallicTex.reset();
+    }
+    if (hasORMTex && roughnessTex == ormTex) {
+        roughnessTex.reset();
+    }
+    const auto& albedoTex = (material && material->getAlbedoTexture()) ? material->getAlbedoTexture() : m_defaultWhiteTexture;
+    MTL::Texture* const resolved[MaterialTable::kTextureCount] = {
+        albedoTex ? albedoTex->getHandle() : nullptr,
+        pick(material ? material->getNormalTexture() : none, m_defaultNormalTexture),
+        pick(metallicTex, m_defaultBlackTexture),
+        pick(roughnessTex, m_defaultWhiteTexture),
+        pick(material ? material->getAOTexture() : none, m_defaultWhiteTexture),
+        pick(material ? material->getEmissionTexture() : none, m_defaultBlackTexture),
+        pick(material ? material->getHeightTexture() : none, m_defaultHeightTexture),
+        pick(ormTex, m_defaultBlackTexture),
+        pick(material ? material->getTerrainControlTexture() : none, m_defaultWhiteTexture),
+        pick(material ? material->getTerrainLayer0Texture() : none, albedoTex),
+        pick(material ? material->getTerrainLayer1Texture() : none, albedoTex),
+        pick(material ? material->getTerrainLayer2Texture() : none, albedoTex),
+        pick(material ? material->getTerrainLayer0NormalTexture() : none, m_defaultNormalTexture),
+        pick(material ? material->getTerrainLayer1NormalTexture() : none, m_defaultNormalTexture),
+        pick(material ? material->getTerrainLayer2NormalTexture() : none, m_defaultNormalTexture),
+        pick(material ? material->getTerrainLayer0ORMTexture() : none, m_defaultWhiteTexture),
+        pick(material ? material->getTerrainLayer1ORMTexture() : none, m_defaultWhiteTexture),
+        pick(material ? material->getTerrainLayer2ORMTexture() : none, m_defaultWhiteTexture),
+    };
+    std::copy(std::begin(resolved), std::end(resolved), textures);
+}
+
+uint32_t Renderer::bindMainMaterialTextures(MTL::RenderCommandEncoder* encoder, const Material* material) {
+    // fragment_main texture slots, in material table order.
+    static constexpr NS::UInteger kSlots[MaterialTable::kTextureCount] = {
+        0, 1, 2, 3, 4, 5, 6, 16, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30
+    };
+    MTL::Texture* textures[MaterialTable::kTextureCount];
+    resolveMainMaterialTextures(material, textures);
+    for (size_t i = 0; i < MaterialTable::kTextureCount; ++i) {
+        encoder->setFragmentTexture(textures[i], kSlots[i]);
+    }
+    // Static lighting slots: the static scene only holds meshes without baked lighting.
+    encoder->setFragmentTexture(m_defaultBlackTexture ? m_defaultBlackTexture->getHandle() : nullptr, 31);
+    encoder->setFragmentTexture(m_defaultHeightTexture ? m_defaultHeightTexture->getHandle() : nullptr, 32);
+    encoder->setFragmentTexture(m_defaultWhiteTexture ? m_defaultWhiteTexture->getHandle() : nullptr, 33);
+    if (m_samplerState) {
+        encoder->setFragmentSamplerState(m_samplerState, 0);
+    }
+    return static_cast<uint32_t>(MaterialTable::kTextureCount) + 3;
+}
+
+uint32_t Renderer::acquireMaterialTableEntry(const Material* material, bool receiveShadows) {
+    // The same material draws with and without shadow receiving, so the flag is part of the key.
+    const uint64_t key = (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(material)) << 1) | (receiveShadows ? 1u : 0u);
+    uint32_t entry = m_materialTable->find(key);
+    if (entry != MaterialTable::kInvalidEntry) {
+        return entry;
+    }
+    MaterialUniformsGPU uniforms = BuildMaterialUniforms(material, receiveShadows);
+    uniforms.terrainParams1.z = terrainVirtualTextureSlot(material);
+    MaterialTable::Textures textures{};
+    resolveMainMaterialTextures(material, textures.data());
+    return m_materialTable->add(key, &uniforms, sizeof(MaterialUniformsGPU), textures);
+}
+
+void Renderer::acquireTerrainVirtualTexture(const Material* material) {
+    if (!m_terrainVirtualTexture || !TerrainVirtualTexture::IsEligible(material)) {
+        return;
+    }
+    // The control map and the nine layer maps, the tail of the material table's textures.
+    MTL::Texture* textures[MaterialTable::kTextureCount];
+    resolveMainMaterialTextures(material, textures);
+    TerrainVirtualTexture::Sources sources{};
+    std::copy(std::end(textures) - sources.size(), std::end(textures), sources.begin());
+    m_terrainVirtualTexture->acquire(*material, sources);
+}
+
+float Renderer::terrainVirtualTextureSlot(const Material* material) const {
+    return m_terrainVirtualTexture ? static_cast<float>(m_terrainVirtualTexture->find(material)) : 0.0f;
+}
+
+void Renderer::releaseStaticScene() {
+    for (StaticSceneFrame& frame : m_staticSceneFrames) {
+        MTL::Buffer** buffers[] = {&frame.instances, &frame.instanceBatches, &frame.culledInstances,
+                                   &frame.batches, &frame.counts, &frame.bindings, &frame.icbArguments};
+        for (MTL::Buffer** buffer : buffers) {
+            if (*buffer) {
+                (*buffer)->release();
+                *buffer = nullptr;
+            }
+        }
+        if (frame.mainCommands) {
+            frame.mainCommands->release();
+        }
+        if (frame.prepassCommands) {
+            frame.prepassCommands->release();
+        }
+        frame = StaticSceneFrame{};
+    }
+    m_staticScene = StaticSceneState{};
+}
+
+bool Renderer::beginOcclusionFrame(uint32_t bufferSlot, size_t candidateCount, size_t argCapacity) {
+    OcclusionFrame& frame = m_occlusionFrames[bufferSlot];
+    frame.candidateCount = 0;
+    frame.argCount = 0;
+    frame.argsDispatched = 0;
+    frame.entityIds.clear();
+    if (candidateCount == 0) {
+        return false;
+    }
+
+    auto ensure = [&](MTL::Buffer*& buffer, size_t bytes) {
+        if (!buffer || buffer->length() < bytes) {
+            if (buffer) {
+                buffer->release();
+            }
+            buffer = m_device->newBuffer(std::max<size_t>(bytes, 256), MTL::ResourceStorageModeShared);
+        }
+        return buffer != nullptr;
+    };
+
+    if (frame.candidateCapacity < candidateCount) {
+        size_t capacity = std::max(candidateCount, frame.candidateCapacity * 2);
+        if (!ensure(frame.spheres, capacity * sizeof(Math::Vector4))
+            || !ensure(frame.visibility, capacity * sizeof(uint32_t))) {
+            frame.candidateCapacity = 0;
+            return false;
+        }
+        frame.candidateCapacity = capacity;
+    }
+    if (frame.argCapacity < argCapacity) {
+        size_t capacity = std::max(argCapacity, frame.argCapacity * 2);
+        if (!ensure(frame.args, capacity * sizeof(DrawIndexedIndirectArgs))
+            || !ensure(frame.argCandidates, capacity * sizeof(uint32_t))) {
+            frame.argCapacity = 0;
+            return false;
+        }
+        frame.argCapacity = capacity;
+    }
+    if (!ensure(frame.counters, 2 * sizeof(uint32_t))) {
+        return false;
+    }
+
+    // The slot's previous frame has completed, so its buffers can be rewritten from the CPU.
+    std::memset(frame.spheres->contents(), 0, candidateCount * sizeof(Math::Vector4));
+    std::memset(frame.counters->contents(), 0, 2 * sizeof(uint32_t));
+    frame.entityIds.assign(candidateCount, 0);
+    frame.candidateCount = static_cast<uint32_t>(candidateCount);
+    return true;
+}
+
+void Renderer::resolveOcclusionResults(uint32_t bufferSlot) {
+    OcclusionFrame* latest = nullptr;
+    for (uint32_t slot = 0; slot < kMaxFramesInFlight; ++slot) {
+        OcclusionFrame& frame = m_occlusionFrames[slot];
+        if (!frame.pending) {
+            continue;
+        }
+        MTL::CommandBuffer* commandBuffer = m_inFlightCommandBuffers[slot];
+        if (commandBuffer && commandBuffer->status() != MTL::CommandBufferStatusCompleted) {
+            continue;
+        }
+        frame.pending = false;
+        if (!latest || frame.frameIndex > latest->frameIndex) {
+            latest = &frame;
+        }
+    }
+
+    if (latest && latest->frameIndex > m_occlusionResolvedFrame) {
+        m_occlusionResolvedFrame = latest->frameIndex;
+        const auto* visibility = static_cast<const uint32_t*>(latest->visibility->contents());
+        const auto* counters = static_cast<const uint32_t*>(latest->counters->contents());
+        m_occludedEntities.clear();
+        for (size_t i = 0; i < latest->entityIds.size(); ++i) {
+            if (latest->entityIds[i] != 0 && visibility[i] == 0) {
+                m_occludedEntities.insert(latest->entityIds[i]);
+            }
+        }
+        m_occlusionVisible = counters[0];
+        m_occlusionOccluded = counters[1];
+    }
+
+    OcclusionFrame& current = m_occlusionFrames[bufferSlot];
+    current.tested = false;
+    current.pending = false;
+}
+
+uint32_t Renderer::appendOcclusionArg(uint32_t bufferSlot, uint32_t candidate, uint32_t elementCount) {
+    OcclusionFrame& frame = m_occlusionFrames[bufferSlot];
+    if (frame.argCount >= frame.argCapacity || candidate >= frame.candidateCount) {
+        return kNoOcclusionArg;
+    }
+    // Candidates that will not be tested would read a zero visibility and vanish.
+    const auto* spheres = static_cast<const Math::Vector4*>(frame.spheres->contents());
+    if (spheres[candidate].w <= 0.0f) {
+        return kNoOcclusionArg;
+    }
+
+    const uint32_t arg = frame.argCount++;
+    static_cast<DrawIndexedIndirectArgs*>(frame.args->contents())[arg] = DrawIndexedIndirectArgs{elementCount, 0, 0, 0, 0};
+    static_cast<uint32_t*>(frame.argCandidates->contents())[arg] = candidate;
+    return arg;
+}
+
+void Renderer::dispatchOcclusionCulling(MTL::CommandBuffer* commandBuffer,
+                                        uint32_t bufferSlot,
+                                        const Math::Vector2& screenSize) {
+    OcclusionFrame& frame = m_occlusionFrames[bufferSlot];
+    if (!m_occlusionCullPipeline || !m_hzbTexture || frame.candidateCount == 0) {
+        return;
+    }
+
+    OcclusionCullParamsGPU params{};
+    params.screenSize = screenSize;
+    params.candidateCount = frame.candidateCount;
+    params.hzbMipCount = std::max(1u, m_hzbMipCount);
+
+    MTL::ComputeCommandEncoder* encoder = m_gpuPassProfiler->computeEncoder(commandBuffer, GPUPass::Culling);
+    encoder->setComputePipelineState(m_occlusionCullPipeline);
+    encoder->setBuffer(frame.spheres, 0, 0);
+    encoder->setBuffer(frame.visibility, 0, 1);
+    encoder->setBuffer(frame.counters, 0, 2);
+    encoder->setBytes(&params, sizeof(OcclusionCullParamsGPU), 3);
+    encoder->setBuffer(m_cameraUniformBuffer, 0, 4);
+    encoder->setTexture(m_hzbTexture, 0);
+    const uint32_t threads = 64;
+    encoder->dispatchThreads(MTL::Size((frame.candidateCount + threads - 1) / threads * threads, 1, 1),
+                             MTL::Size(threads, 1, 1));
+    encoder->endEncoding();
+    frame.tested = true;
+
+    dispatchOcclusionArgs(commandBuffer, bufferSlot);
+}
+
+void Renderer::dispatchOcclusionArgs(MTL::CommandBuffer* commandBuffer, uint32_t bufferSlot) {
+    OcclusionFrame& frame = m_occlusionFrames[bufferSlot];
+    if (!m_occlusionArgsPipeline || !frame.tested || frame.argsDispatched >= frame.argCount) {
+        return;
+    }
+
+    OcclusionCullParamsGPU params{};
+    params.candidateCount = frame.candidateCount;
+    params.argOffset = frame.argsDispatched;
+    params.argCount = frame.argCount - frame.argsDispatched;
+
+    MTL::ComputeCommandEncoder* encoder = m_gpuPassProfiler->computeEncoder(commandBuffer, GPUPass::Culling);
+    encoder->setComputePipelineState(m_occlusionArgsPipeline);
+    encoder->setBuffer(frame.visibility, 0, 0);
+    encoder->setBuffer(frame.argCandidates, 0, 1);
+    encoder->setBuffer(frame.args, 0, 2);
+    encoder->setBytes(&params, sizeof(OcclusionCullParamsGPU), 3);
+    const uint32_t threads = 64;
+    encoder->dispatchThreads(MTL::Size((params.argCount + threads - 1) / threads * threads, 1, 1),
+                             MTL::Size(threads, 1, 1));
+    encoder->endEncoding();
+    frame.argsDispatched = frame.argCount;
+}
+
+void Renderer::releaseOcclusionCulling() {
+    for (OcclusionFrame& frame : m_occlusionFrames) {
+        MTL::Buffer** buffers[] = {&frame.spheres, &frame.visibility, &frame.counters, &frame.args, &frame.argCandidates};
+        for (MTL::Buffer** buffer : buffers) {
+            if (*buffer) {
+                (*buffer)->release();
+                *buffer = nullptr;
+            }
+        }
+        frame = OcclusionFrame{};
+    }
+    m_occludedEntities.clear();
+    m_occlusionResolvedFrame = 0;
+}
+
+void Renderer::buildHzb(MTL::CommandBuffer* commandBuffer) {
+    const uint32_t spdGroupsX = (m_hzbMipViews[0]->width() + kHzbSpdTile - 1) / kHzbSpdTile;
+    const uint32_t spdGroupsY = (m_hzbMipViews[0]->height() + kHzbSpdTile - 1) / kHzbSpdTile;
+    if (m_hzbSpdPipeline && m_hzbSpdBuffer && m_hzbMipViews.size() <= kHzbSpdMaxMips
+        && spdGroupsX <= kHzbSpdMaxGroups && spdGroupsY <= kHzbSpdMaxGroups) {
+        HZBSpdParamsGPU params{};
+        params.mipCount = static_cast<uint32_t>(m_hzbMipViews.size());
+        params.groupCount = spdGroupsX * spdGroupsY;
+
+        MTL::ComputeCommandEncoder* spdEncoder = m_gpuPassProfiler->computeEncoder(commandBuffer, GPUPass::HZB);
+        spdEncoder->setComputePipelineState(m_hzbSpdPipeline);
+        spdEncoder->setTexture(m_depthTexture, 0);
+        for (size_t mip = 0; mip < m_hzbMipViews.size(); ++mip) {
+            spdEncoder->setTexture(m_hzbMipViews[mip], 1 + mip);
+        }
+        spdEncoder->setBytes(&params, sizeof(HZBSpdParamsGPU), 0);
+        spdEncoder->setBuffer(m_hzbSpdBuffer, 0, 1);
+        if (m_pointClampSampler) {
+            spdEncoder->setSamplerState(m_pointClampSampler, 0);
+        } else if (m_linearClampSampler) {
+            spdEncoder->setSamplerState(m_linearClampSampler, 0);
+        }
+        spdEncoder->dispatchThreadgroups(MTL::Size(spdGroupsX, spdGroupsY, 1), MTL::Size(16, 16, 1));
+        spdEncoder->endEncoding();
+        return;
+    }
+
+    MTL::ComputeCommandEncoder* hzbInit = m_gpuPassProfiler->computeEncoder(commandBuffer, GPUPass::HZB);
+    hzbInit->setComputePipelineState(m_hzbInitPipeline);
+    hzbInit->setTexture(m_depthTexture, 0);
+    hzbInit->setTexture(m_hzbMipViews[0], 1);
+    if (m_pointClampSampler) {
+        hzbInit->setSamplerState(m_pointClampSampler, 0);
+    } else if (m_linearClampSampler) {
+        hzbInit->setSamplerState(m_linearClampSampler, 0);
+    }
+    const uint32_t hzbWidth = m_hzbMipViews[0]->width();
+    const uint32_t hzbHeight = m_hzbMipViews[0]->height();
+    const uint32_t threads = 8;
+    MTL::Size tgSize = MTL::Size(threads, threads, 1);
+    MTL::Size gridSize = MTL::Size((hzbWidth + threads - 1) / threads * threads,
+                                   (hzbHeight + threads - 1) / threads * threads,
+                                   1);
+    hzbInit->dispatchThreads(gridSize, tgSize);
+    hzbInit->endEncoding();
+
+    for (size_t mip = 1; mip < m_hzbMipViews.size(); ++mip) {
+        MTL::Texture* src = m_hzbMipViews[mip - 1];
+        MTL::Texture* dst = m_hzbMipViews[mip];
+        if (!src || !dst) {
+            continue;
+        }
+        MTL::ComputeCommandEncoder* downEncoder = m_gpuPassProfiler->computeEncoder(commandBuffer, GPUPass::HZB);
+        downEncoder->setComputePipelineState(m_hzbDownsamplePipeline);
+        downEncoder->setTexture(src, 0);
+        downEncoder->setTexture(dst, 1);
+        const uint32_t mipWidth = dst->width();
+        const uint32_t mipHeight = dst->height();
+        MTL::Size downGrid = MTL::Size((mipWidth + threads - 1) / threads * threads,
+                                       (mipHeight + threads - 1) / threads * threads,
+                                       1);
+        downEncoder->dispatchThreads(downGrid, tgSize);
+        downEncoder->endEncoding();
+    }
+}
+
+void Renderer::renderMeshRenderer(MeshRenderer* renderer, Camera* camera, const FrameVector<Light*>& lights) {
     // This is called per mesh renderer - we could do culling here
 }
 
 void Renderer::shutdown() {
     releaseMetalFXResources();
 
+    // Its worker decodes through the texture loader and owns its own IBL generator.
+    if (m_environmentProcessor) {
+        m_environmentProcessor->shutdown();
+    }
+
     // Shutdown IBL generator
     if (m_iblGenerator) {
         m_iblGenerator->shutdown();
@@ -7788,12 +12670,46 @@ void Renderer::shutdown() {
         m_clusterPass->shutdown();
         m_clusterPass.reset();
     }
+    if (m_skinningCache) {
+        m_skinningCache->shutdown();
+        m_skinningCache.reset();
+    }
+    if (m_crowdAnimation) {
+        m_crowdAnimation->shutdown();
+        m_crowdAnimation.reset();
+    }
+    if (m_dynamicProbeGI) {
+        m_dynamicProbeGI->shutdown();
+        m_dynamicProbeGI.reset();
+    }
+    if (m_asyncCompute) {
+        m_asyncCompute->shutdown();
+        m_asyncCompute.reset();
+    }
+    m_dynamicResolution.reset();
+    m_textureStreamer.reset();
+    if (m_variableRateShading) {
+        m_variableRateShading->shutdown();
+        m_variableRateShading.reset();
+    }
+    // Kept alive: the shadow and cluster passes may still hold it.
+    m_gpuPassProfiler->shutdown();
     
     if (m_debugLinePipelineState) {
         m_debugLinePipelineState->release();
         m_debugLinePipelineState = nullptr;
     }
     
+    if (m_debugShapePipelineState) {
+        m_debugShapePipelineState->release();
+        m_debugShapePipelineState = nullptr;
+    }
+
+    if (m_debugMeshWirePipelineState) {
+        m_debugMeshWirePipelineState->release();
+        m_debugMeshWirePipelineState = nullptr;
+    }
+    
     if (m_debugGridPipelineState) {
         m_debugGridPipelineState->release();
         m_debugGridPipelineState = nullptr;
@@ -7811,6 +12727,22 @@ void Renderer::shutdown() {
         m_ssrPipelineState->release();
         m_ssrPipelineState = nullptr;
     }
+    if (m_ssrHizInitPipeline) {
+        m_ssrHizInitPipeline->release();
+        m_ssrHizInitPipeline = nullptr;
+    }
+    if (m_ssrHizDownsamplePipeline) {
+        m_ssrHizDownsamplePipeline->release();
+        m_ssrHizDownsamplePipeline = nullptr;
+    }
+    if (m_ssrTracePipeline) {
+        m_ssrTracePipeline->release();
+        m_ssrTracePipeline = nullptr;
+    }
+    if (m_ssrTemporalPipeline) {
+        m_ssrTemporalPipeline->release();
+        m_ssrTemporalPipeline = nullptr;
+    }
     if (m_bloomPrefilterPipelineState) {
         m_bloomPrefilterPipelineState->release();
         m_bloomPrefilterPipelineState = nullptr;
@@ -7827,10 +12759,18 @@ void Renderer::shutdown() {
         m_bloomCombinePipelineState->release();
         m_bloomCombinePipelineState = nullptr;
     }
+    if (m_bloomDownsampleSPDPipeline) {
+        m_bloomDownsampleSPDPipeline->release();
+        m_bloomDownsampleSPDPipeline = nullptr;
+    }
     if (m_taaPipelineState) {
         m_taaPipelineState->release();
         m_taaPipelineState = nullptr;
     }
+    if (m_taaResolvePipeline) {
+        m_taaResolvePipeline->release();
+        m_taaResolvePipeline = nullptr;
+    }
     if (m_dofPipelineState) {
         m_dofPipelineState->release();
         m_dofPipelineState = nullptr;
@@ -7839,17 +12779,65 @@ void Renderer::shutdown() {
         m_fogPipelineState->release();
         m_fogPipelineState = nullptr;
     }
+    if (m_ssrFogPipelineState) {
+        m_ssrFogPipelineState->release();
+        m_ssrFogPipelineState = nullptr;
+    }
     if (m_motionBlurPipelineState) {
         m_motionBlurPipelineState->release();
         m_motionBlurPipelineState = nullptr;
     }
-    if (m_velocityPipelineState) {
-        m_velocityPipelineState->release();
-        m_velocityPipelineState = nullptr;
+    if (m_instanceCullPipeline) {
+        m_instanceCullPipeline->release();
+        m_instanceCullPipeline = nullptr;
+    }
+    if (m_instanceCullHzbPipeline) {
+        m_instanceCullHzbPipeline->release();
+        m_instanceCullHzbPipeline = nullptr;
+    }
+    if (m_instanceIndirectPipeline) {
+        m_instanceIndirectPipeline->release();
+        m_instanceIndirectPipeline = nullptr;
+    }
+    if (m_visibilityPipeline) {
+        m_visibilityPipeline->release();
+        m_visibilityPipeline = nullptr;
+    }
+    if (m_visibilityClassifyPipeline) {
+        m_visibilityClassifyPipeline->release();
+        m_visibilityClassifyPipeline = nullptr;
+    }
+    if (m_visibilityTileRanges) {
+        m_visibilityTileRanges->release();
+        m_visibilityTileRanges = nullptr;
+    }
+    if (m_hzbInitPipeline) {
+        m_hzbInitPipeline->release();
+        m_hzbInitPipeline = nullptr;
+    }
+    if (m_hzbDownsamplePipeline) {
+        m_hzbDownsamplePipeline->release();
+        m_hzbDownsamplePipeline = nullptr;
+    }
+    if (m_hzbSpdPipeline) {
+        m_hzbSpdPipeline->release();
+        m_hzbSpdPipeline = nullptr;
     }
-    if (m_velocityPipelineSkinned) {
-        m_velocityPipelineSkinned->release();
-        m_velocityPipelineSkinned = nullptr;
+    if (m_hzbSpdBuffer) {
+        m_hzbSpdBuffer->release();
+        m_hzbSpdBuffer = nullptr;
+    }
+    if (m_occlusionCullPipeline) {
+        m_occlusionCullPipeline->release();
+        m_occlusionCullPipeline = nullptr;
+    }
+    if (m_occlusionArgsPipeline) {
+        m_occlusionArgsPipeline->release();
+        m_occlusionArgsPipeline = nullptr;
+    }
+    if (m_velocityReconstructPipeline) {
+        m_velocityReconstructPipeline->release();
+        m_velocityReconstructPipeline = nullptr;
     }
     
     if (m_debugLibrary && m_debugLibrary != m_library) {
@@ -7868,6 +12856,12 @@ void Renderer::shutdown() {
         }
     }
     m_pipelineStates.clear();
+    ++m_pipelineGeneration;
+    collectCompiledPipelines();
+    m_pendingPipelines.clear();
+    m_pipelinePrewarmRemaining = 0;
+    m_archivedPipelineKeys.clear();
+    PipelineArchive::getInstance().shutdown();
     
     // Release depth stencil state
     if (m_depthStencilState) {
@@ -7888,16 +12882,51 @@ void Renderer::shutdown() {
     releaseRenderTargetState(m_gameTargets);
     releaseRenderTargetState(m_previewTargets);
     loadRenderTargetState(getRenderTargetState(m_activePool));
-    
-    // Release uniform buffers
-    if (m_modelUniformBuffer) {
-        m_modelUniformBuffer->release();
-        m_modelUniformBuffer = nullptr;
+    if (m_renderTargetHeap) {
+        m_renderTargetHeap->shutdown();
+        m_renderTargetHeap.reset();
+    }
+
+    if (m_uniformRing) {
+        m_uniformRing->shutdown();
+    }
+    if (m_materialTable) {
+        m_materialTable->setResidency(nullptr);
+    }
+    if (m_sceneResidency) {
+        m_sceneResidency->shutdown();
+    }
+    if (m_instanceCache) {
+        m_instanceCache->shutdown();
+    }
+    if (m_foliageSystem) {
+        m_foliageSystem->shutdown();
+    }
+    if (m_terrainSystem) {
+        m_terrainSystem->shutdown();
+    }
+    if (m_terrainVirtualTexture) {
+        m_terrainVirtualTexture->shutdown();
     }
-    if (m_materialUniformBuffer) {
-        m_materialUniformBuffer->release();
-        m_materialUniformBuffer = nullptr;
+    if (m_tiledPostBlur) {
+        m_tiledPostBlur->shutdown();
     }
+    if (m_particleSystem) {
+        m_particleSystem->shutdown();
+    }
+    if (m_skyAtmosphere) {
+        m_skyAtmosphere->shutdown();
+    }
+    if (m_entityPicker) {
+        m_entityPicker->shutdown();
+    }
+    // Waits for bakes still in flight before their textures go.
+    m_impostorBaker.reset();
+    if (m_weightedTransparency) {
+        m_weightedTransparency->shutdown();
+    }
+
+    // Release uniform buffers
     if (m_lightCountBuffer) {
         m_lightCountBuffer->release();
         m_lightCountBuffer = nullptr;
@@ -7925,18 +12954,29 @@ void Renderer::shutdown() {
         if (m_shadowGPUBuffers[i]) { m_shadowGPUBuffers[i]->release(); m_shadowGPUBuffers[i] = nullptr; }
         if (m_clusterParamsBuffers[i]) { m_clusterParamsBuffers[i]->release(); m_clusterParamsBuffers[i] = nullptr; }
         if (m_skinningBuffers[i]) { m_skinningBuffers[i]->release(); m_skinningBuffers[i] = nullptr; }
-        if (m_prevSkinningBuffers[i]) { m_prevSkinningBuffers[i]->release(); m_prevSkinningBuffers[i] = nullptr; }
         if (m_instanceBuffers[i]) { m_instanceBuffers[i]->release(); m_instanceBuffers[i] = nullptr; }
         if (m_instanceCullBuffers[i]) { m_instanceCullBuffers[i]->release(); m_instanceCullBuffers[i] = nullptr; }
         if (m_instanceCountBuffers[i]) { m_instanceCountBuffers[i]->release(); m_instanceCountBuffers[i] = nullptr; }
         if (m_instanceIndirectBuffers[i]) { m_instanceIndirectBuffers[i]->release(); m_instanceIndirectBuffers[i] = nullptr; }
         m_skinningBufferCapacities[i] = 0;
-        m_prevSkinningBufferCapacities[i] = 0;
         m_instanceBufferCapacities[i] = 0;
         m_instanceCullCapacities[i] = 0;
         m_instanceCountCapacities[i] = 0;
         m_instanceIndirectCapacities[i] = 0;
     }
+    m_inFlightFrameValues.fill(0);
+    if (m_frameEvent) {
+        m_frameEvent->release();
+        m_frameEvent = nullptr;
+    }
+    releaseStaticScene();
+    releaseOcclusionCulling();
+    Mesh::GetCookedResidency().clear();
+    GeometryBuffer::getInstance().shutdown();
+    m_renderTargetMemory.reset();
+    m_instanceMemory.reset();
+    m_skinningMemory.reset();
+    m_probeMemory.reset();
     m_cameraUniformBuffer = nullptr;
     m_lightUniformBuffer = nullptr;
     m_environmentUniformBuffer = nullptr;
@@ -7944,13 +12984,11 @@ void Renderer::shutdown() {
     m_shadowGPUBuffer = nullptr;
     m_clusterParamsBuffer = nullptr;
     m_skinningBuffer = nullptr;
-    m_prevSkinningBuffer = nullptr;
     m_instanceBuffer = nullptr;
     m_instanceCullBuffer = nullptr;
     m_instanceCountBuffer = nullptr;
     m_instanceIndirectBuffer = nullptr;
     m_skinningBufferCapacity = 0;
-    m_prevSkinningBufferCapacity = 0;
     m_instanceBufferCapacity = 0;
     m_instanceBufferOffset = 0;
     if (m_instanceCullBuffer) {
@@ -7998,6 +13036,7 @@ void Renderer::shutdown() {
     m_defaultWhiteTexture.reset();
     m_defaultNormalTexture.reset();
     m_defaultBlackTexture.reset();
+    m_defaultTransparentTexture.reset();
     m_defaultHeightTexture.reset();
     m_defaultEnvironmentTexture.reset();
     m_environmentTexture.reset();
@@ -8005,6 +13044,7 @@ void Renderer::shutdown() {
     m_colorGradingNeutralLUT.reset();
     m_colorGradingLUTPath.clear();
     m_staticLightingTextureCache.clear();
+    m_vertexAnimationTextureCache.clear();
     m_textureLoader.reset();
     
     // Release library
@@ -8012,6 +13052,7 @@ void Renderer::shutdown() {
         m_library->release();
         m_library = nullptr;
     }
+    ShaderLibrary::getInstance().shutdown();
     
     // Release command queue
     if (m_commandQueue) {
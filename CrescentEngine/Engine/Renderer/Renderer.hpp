@@ -4,10 +4,19 @@
 #include <array>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <cstdint>
+#include <chrono>
 #include "../Math/Math.hpp"
+#include "../Core/FrameArena.hpp"
+#include "../Core/MemoryTracker.hpp"
+#include "../Core/UUID.hpp"
 #include "../Scene/SceneSettings.hpp"
+#include "ProbeVolumeData.hpp"
+#include "GPUPassProfiler.hpp"
+#include "ImpostorBaker.hpp"
+#include "EntityPicker.hpp"
 
 // Forward declarations to avoid including metal-cpp in header
 namespace MTL {
@@ -15,17 +24,25 @@ namespace MTL {
     class CommandQueue;
     class CommandBuffer;
     class RenderPipelineState;
+    class RenderPipelineDescriptor;
+    class Function;
     class ComputePipelineState;
     class RenderCommandEncoder;
     class Buffer;
+    class Resource;
+    class IndirectCommandBuffer;
     class Library;
     class DepthStencilState;
     class SamplerState;
     class Texture;
+    class SharedEvent;
+    struct Viewport;
 }
 
 namespace MTLFX {
     class TemporalScaler;
+    class SpatialScaler;
+    class FrameInterpolator;
 }
 
 namespace CA {
@@ -35,6 +52,7 @@ namespace CA {
 namespace Crescent {
 
 // Forward declarations
+class Entity;
 class Mesh;
 class Material;
 class Camera;
@@ -46,9 +64,31 @@ class DebugRenderer;
 class Texture2D;
 class TextureLoader;
 class IBLGenerator;
+class EnvironmentProcessor;
 class LightingSystem;
 class ShadowRenderPass;
 class ClusteredLightingPass;
+class SkinningCache;
+class CrowdAnimation;
+class DynamicProbeGI;
+class MaterialTable;
+class UniformRing;
+class SceneResidency;
+class InstanceCache;
+class FoliageSystem;
+class TerrainSystem;
+class TerrainVirtualTexture;
+class TiledPostBlur;
+class ParticleSystem;
+class SkyAtmosphere;
+class RenderTargetHeap;
+class AsyncComputeQueue;
+class DynamicResolution;
+class TextureStreamer;
+class VariableRateShading;
+class WeightedTransparency;
+class RenderWorld;
+struct ProbeVolumeUniformsGPU;
 
 // GPU Buffer wrapper
 struct GPUBuffer {
@@ -59,6 +99,23 @@ struct GPUBuffer {
 };
 
 // Pipeline state cache key
+// Material features fragment_main is specialized on through function constant 0 (kPbrFeatures in
+// PBR.metal). Draws whose material and scene leave a feature unused get a variant with that path
+// compiled out; kPbrFeatureAll is the runtime-branching ubershader.
+enum PbrFeature : uint8_t {
+    kPbrFeatureTerrain = 1u << 0,
+    kPbrFeatureParallax = 1u << 1,
+    kPbrFeatureSurfaceMaps = 1u << 2,     // normal, ORM, metallic, roughness, AO and emission maps
+    kPbrFeatureAlphaDiscard = 1u << 3,    // alpha cutoff and foliage dither fades
+    kPbrFeatureDecals = 1u << 4,
+    kPbrFeatureProbes = 1u << 5,
+    kPbrFeatureStaticLighting = 1u << 6,  // lightmaps, shadowmask and baked vertex lighting
+    kPbrFeatureAll = 0x7Fu,
+    // Not a material feature and not in kPbrFeatureAll: the halfPrecisionShading quality setting,
+    // which evaluates the light loop's BRDF in half.
+    kPbrFeatureHalfPrecision = 1u << 7
+};
+
 struct PipelineStateKey {
     bool hasNormals;
     bool hasTexCoords;
@@ -69,6 +126,16 @@ struct PipelineStateKey {
     bool alphaToCoverage;
     bool hdrTarget;
     uint8_t sampleCount;
+    bool isMeshlet = false; // object/mesh shader pipeline for static meshlet batches
+    uint8_t pbrFeatures = kPbrFeatureAll;
+    bool materialTable = false; // fragment_main reads its material from the MaterialTable (function constant 1)
+    bool isVertexAnimated = false; // instanced batch playing a baked vertex animation texture
+    // Blended draw accumulating into the WeightedTransparency targets (function constant 2).
+    bool weightedBlended = false;
+    bool isTerrain = false; // instanced TerrainSystem patches displaced by vertex_terrain_instanced
+    // Static scene group shaded from the visibility buffer by vertex_visibility_tile quads
+    // (function constant 3).
+    bool isVisibility = false;
     
     bool operator==(const PipelineStateKey& other) const {
         return hasNormals == other.hasNormals &&
@@ -79,28 +146,74 @@ struct PipelineStateKey {
                isInstanced == other.isInstanced &&
                alphaToCoverage == other.alphaToCoverage &&
                hdrTarget == other.hdrTarget &&
-               sampleCount == other.sampleCount;
+               sampleCount == other.sampleCount &&
+               isMeshlet == other.isMeshlet &&
+               pbrFeatures == other.pbrFeatures &&
+               materialTable == other.materialTable &&
+               isVertexAnimated == other.isVertexAnimated &&
+               weightedBlended == other.weightedBlended &&
+               isTerrain == other.isTerrain &&
+               isVisibility == other.isVisibility;
+    }
+
+    // Stable 30-bit encoding, also the hash; the pipeline archive stores keys in this form.
+    uint32_t pack() const {
+        return (hasNormals ? 1u : 0u) |
+               (hasTexCoords ? 2u : 0u) |
+               (hasTangents ? 4u : 0u) |
+               (isTransparent ? 8u : 0u) |
+               (isSkinned ? 16u : 0u) |
+               (isInstanced ? 32u : 0u) |
+               (alphaToCoverage ? 64u : 0u) |
+               (hdrTarget ? 128u : 0u) |
+               (isMeshlet ? 256u : 0u) |
+               (static_cast<uint32_t>(sampleCount) << 9) |
+               (static_cast<uint32_t>(pbrFeatures) << 17) |
+               (materialTable ? (1u << 25) : 0u) |
+               (isVertexAnimated ? (1u << 26) : 0u) |
+               (weightedBlended ? (1u << 27) : 0u) |
+               (isTerrain ? (1u << 28) : 0u) |
+               (isVisibility ? (1u << 29) : 0u);
+    }
+
+    static PipelineStateKey Unpack(uint32_t bits) {
+        PipelineStateKey key{};
+        key.hasNormals = (bits & 1u) != 0;
+        key.hasTexCoords = (bits & 2u) != 0;
+        key.hasTangents = (bits & 4u) != 0;
+        key.isTransparent = (bits & 8u) != 0;
+        key.isSkinned = (bits & 16u) != 0;
+        key.isInstanced = (bits & 32u) != 0;
+        key.alphaToCoverage = (bits & 64u) != 0;
+        key.hdrTarget = (bits & 128u) != 0;
+        key.isMeshlet = (bits & 256u) != 0;
+        key.sampleCount = static_cast<uint8_t>((bits >> 9) & 0xFFu);
+        key.pbrFeatures = static_cast<uint8_t>((bits >> 17) & 0xFFu);
+        key.materialTable = (bits & (1u << 25)) != 0;
+        key.isVertexAnimated = (bits & (1u << 26)) != 0;
+        key.weightedBlended = (bits & (1u << 27)) != 0;
+        key.isTerrain = (bits & (1u << 28)) != 0;
+        key.isVisibility = (bits & (1u << 29)) != 0;
+        return key;
     }
 };
 
 // Hash function for pipeline key
 struct PipelineStateKeyHash {
     size_t operator()(const PipelineStateKey& key) const {
-        return (key.hasNormals ? 1 : 0) |
-               (key.hasTexCoords ? 2 : 0) |
-               (key.hasTangents ? 4 : 0) |
-               (key.isTransparent ? 8 : 0) |
-               (key.isSkinned ? 16 : 0) |
-               (key.isInstanced ? 32 : 0) |
-               (key.alphaToCoverage ? 64 : 0) |
-               (key.hdrTarget ? 128 : 0) |
-               (static_cast<size_t>(key.sampleCount) << 9);
+        return key.pack();
     }
 };
 
 class Renderer {
 public:
     static constexpr uint32_t kMaxFramesInFlight = 4;
+    // Draw not deferred to the occlusion test (see beginOcclusionFrame).
+    static constexpr uint32_t kNoOcclusionArg = 0xFFFFFFFFu;
+    // decal_box_vertex draws the unit box as a non-indexed triangle list.
+    static constexpr uint32_t kDecalBoxVertexCount = 36;
+    static constexpr size_t kPipelineCompileBuckets = 6;
+    static constexpr size_t kLodStatLevels = 5; // MeshLod::kMaxLods
     enum class RenderTargetPool {
         Scene,
         Game,
@@ -116,6 +229,12 @@ public:
     // Set the Metal layer from Swift (as void* to avoid type conflicts)
     void setMetalLayer(void* layer);
     void setMetalLayer(void* layer, bool applySize);
+
+    // Low-latency presentation: layers keep two drawables instead of the default three, so at most
+    // one frame waits for the display, and game view frames are held on screen for the smoothed frame
+    // interval (presentAfterMinimumDuration) so a variable refresh display paces them evenly.
+    void setLowLatencyPresentation(bool enabled);
+    bool isLowLatencyPresentation() const { return m_lowLatencyPresentation; }
     
     // Shutdown renderer
     void shutdown();
@@ -128,9 +247,32 @@ public:
     struct RenderOptions {
         bool allowTemporal = true;
         bool updateHistory = true;
+        // Drop the pool's temporal history first, as after frames rendered without it.
+        bool resetHistory = false;
+        // Whether this view's skinned mesh sizes drive animation LOD (the game view's do).
+        bool driveAnimationLod = true;
+        // Low-latency presentation: just before commit, the view is turned by the mouse motion that
+        // arrived after the update, as the camera's controller would have turned it (Camera::LookLatch).
+        struct LateLatch {
+            bool enabled = false;
+            float yawPerUnit = 0.0f;
+            float pitchPerUnit = 0.0f;
+            float pitch = 0.0f;
+            float minPitch = 0.0f;
+            float maxPitch = 0.0f;
+            double appliedMotionX = 0.0; // InputManager::getAppliedMotion() after the update
+            double appliedMotionY = 0.0;
+        } lateLatch;
     };
     void renderScene(Scene* scene, Camera* cameraOverride, const RenderOptions& options);
 
+    // Starts an engine frame: views rendered until the next call share its view-independent work.
+    void beginEngineFrame() { ++m_engineFrame; }
+    // For frames that render no view: runs the view-independent work (pipeline, impostor and
+    // texture streaming completions) that renderScene would have. Returns whether any of it
+    // finished, so the views may look different once redrawn.
+    bool updateIdleFrame();
+
     void setRenderTargetPool(RenderTargetPool pool);
     
     // Get Metal device (return as void* to avoid type conflicts)
@@ -153,23 +295,126 @@ public:
     
     TextureLoader* getTextureLoader() const { return m_textureLoader.get(); }
     void invalidateStaticLightingResources();
+    // Recomposites the material's terrain virtual texture; call after changing one of its terrain
+    // textures in place, such as painting the control map.
+    void invalidateTerrainVirtualTexture(const Material* material);
 
-    std::shared_ptr<Texture2D> bakeImpostorAtlas(Mesh* mesh,
-                                                 Material* material,
-                                                 uint32_t rows,
-                                                 uint32_t cols,
-                                                 uint32_t tileSize,
-                                                 std::string* outPath = nullptr);
+    // Renders every request's atlas in one command buffer and returns how many were submitted.
+    // Never waits: each request's onComplete runs from a later renderScene once its atlas is ready.
+    uint32_t bakeImpostorAtlases(std::vector<ImpostorBakeRequest> requests);
+    size_t getPendingImpostorBakes() const;
+
+    // GPU picking in the scene view: the next scene-view frame draws the request's rectangle into
+    // an entity-ID target and the result arrives through takePickResult() a frame or two later.
+    bool isPickingAvailable() const;
+    uint64_t requestPick(const EntityPicker::Request& request);
+    bool takePickResult(EntityPicker::Result& out);
     
     // Quality controls (shadow atlas, anisotropy, etc.)
     
     // Statistics
+    struct ShadowLightStats {
+        UUID light; // entity of the light
+        uint32_t draws = 0; // caster draws over all of its cascades or cube faces
+    };
     struct RenderStats {
         uint32_t drawCalls;
         uint32_t triangles;
         uint32_t vertices;
         uint32_t instanceInput;
         uint32_t instanceVisible;
+        uint32_t instancesCached; // of instanceInput, read from resident GPU buffers (InstanceCache, foliage)
+        uint32_t foliageTilesScattered;
+        uint32_t foliageTilesResident;
+        // Terrain virtual texture pages composited this frame and resident in its atlases.
+        uint32_t terrainVirtualPagesComposited;
+        uint32_t terrainVirtualPagesResident;
+        // Particle emitters drawn by the view, simulated this frame, and their pools' total size.
+        uint32_t particleEmitters;
+        uint32_t particleEmittersSimulated;
+        uint32_t particleCapacity;
+        // Procedural sky LUTs re-baked, and faces of its lighting cubemaps refreshed, this frame.
+        uint32_t skyLutBakes;
+        uint32_t skyLightingFaces;
+        // Views rendered so far this engine frame, this one included; only the first runs the
+        // frame's view-independent housekeeping.
+        uint32_t frameViews;
+        // Mesh renderers drawn into the entity-ID target for an editor pick this frame.
+        uint32_t pickDraws;
+        // Blended main pass draws accumulated order-independently, at full and half resolution.
+        uint32_t weightedTransparentDraws;
+        uint32_t lowResTransparentDraws;
+        // Main pass culling funnel of the CPU-submitted mesh renderers; the occlusion results of
+        // the tested ones arrive in occlusionVisible/occlusionOccluded.
+        uint32_t cullCandidates; // active, enabled mesh renderers with a mesh
+        uint32_t cullFrustumVisible;
+        uint32_t cullOcclusionTested; // visible ones occluded last frame, re-tested against this frame's HZB
+        std::array<uint32_t, kLodStatLevels> cullLodDraws; // draws per selected LOD; a fade adds one at the next LOD
+        // Encoders, draws and binds per pass, indexed by GPUPass. Draws and binds come from the
+        // per-draw loops of the prepass, main pass and shadow casters; full-screen passes only
+        // report their encoders.
+        std::array<GPUPassWork, kGPUPassCount> passWork;
+        std::vector<ShadowLightStats> shadowLightDraws;
+        uint32_t commandBuffers; // frame and async compute command buffers
+        uint64_t uniformBytesUploaded; // inline and ring draw uniforms and light/shadow records
+        uint32_t uniformRingOverflows; // per-draw uniforms that did not fit the frame's ring and went inline
+        uint64_t skinningBytesUploaded; // bone palettes copied for the prepass (with last frame's for motion), main and shadow passes
+        uint64_t instanceBytesUploaded; // instance records copied for instanced and static scene draws
+        // HZB test results of the CPU-submitted draws and decals, from the latest frame the GPU
+        // has finished (a few frames behind).
+        uint32_t occlusionVisible;
+        uint32_t occlusionOccluded;
+        uint32_t skinningCacheMeshes; // skinned meshes pre-skinned by the compute cache this frame
+        uint32_t crowdInstances; // crowd instances posed on the GPU this frame
+        uint32_t parallelEncoders; // sub-encoders recorded on job workers this frame
+        uint32_t asyncComputePasses; // compute passes run on the async queue this frame
+        uint32_t fogFroxels; // froxels in the fog volume
+        uint32_t fogFroxelsLit; // froxels scheduled for scattering and shadows; newly visible ones add to it
+        uint32_t interpolatedFrames; // MetalFX-interpolated frames presented this frame
+        uint32_t lateLatchedFrames; // views re-aimed at late input before commit this frame
+        uint32_t drawStateBinds; // pipeline, cull mode and material binds of the sorted MeshRenderer draws
+        uint32_t drawStateBindsSkipped; // binds those draws skipped because the state was already set
+        uint32_t shadowViewsCached; // shadow views whose static casters were copied from the cache
+        uint32_t shadowViewsRefreshed; // shadow views whose static cache was re-rendered
+        uint32_t shadowPagesCached; // paged cascade pages reused from the page cache
+        uint32_t shadowPagesRendered; // paged cascade pages that scrolled in or were invalidated
+        uint32_t shadowTilesDowngraded; // atlas tiles placed below their requested size
+        uint32_t shadowViewsDeferred; // time-sliced shadow views not due this frame
+        uint32_t shadowViewsRestored; // deferred views copied from their last refresh
+        // Light cluster build of the latest finished frame on this frame slot.
+        uint32_t clustersActive; // clusters holding at least one light
+        uint32_t clustersOverflowed; // clusters that hit maxLightsPerCluster
+        uint32_t clusterLightsDropped; // light entries lost to full clusters
+        uint32_t clusterTileLightsDropped; // light entries lost to full coarse tiles
+        uint32_t lightRecordsUploaded; // light/shadow GPU records copied into this frame's buffers
+        uint32_t materialTableEntries; // materials the main pass drew through the material table
+        uint32_t residentResources; // scene resources held resident by the queue's residency set
+        uint32_t dynamicProbesUpdated; // probes re-traced by the dynamic probe GI this frame
+        uint32_t dynamicReflectionFaces; // reflection capture cube faces traced this frame
+        uint32_t visibilityGroups; // static material groups shaded from the visibility buffer
+        uint64_t renderTargetHeapBytes; // heap holding every pool's per-frame render targets
+        uint64_t renderTargetAliasedBytes; // bytes of the last placed target layout that share memory
+        uint32_t transientAllocations; // heap blocks the frame arenas had to request this frame
+        // Async pipeline compiles since startup, bucketed <1, <4, <16, <64, <256 and >=256 ms.
+        std::array<uint32_t, kPipelineCompileBuckets> pipelineCompileHistogram;
+        uint32_t pipelinesCompiling; // async compiles still in flight
+        uint32_t texturesStreaming; // textures still showing their placeholder
+        uint32_t mipStreamedTextures; // cooked textures whose resident mips follow screen coverage
+        uint64_t mipStreamedBytes; // resident bytes of those textures
+        uint32_t mipLoadsInFlight; // mip reloads issued but not yet swapped in
+        uint32_t pipelineFallbackDraws; // draws this frame that used a fallback pipeline or were skipped
+        uint32_t slowestPipelineKey; // packed PipelineStateKey of the slowest compile so far
+        float slowestPipelineCompileMs;
+        float gpuFrameTimeMs; // smoothed GPU time of the game view's finished frames
+        float gpuLastFrameTimeMs; // unsmoothed GPU time of the game view frame that finished this frame, 0 if none
+        float frameSlotWaitMs; // CPU blocked until the GPU finished the frame that last used this frame slot
+        float drawableWaitMs; // CPU blocked in nextDrawable
+        float drawableHoldMs; // from acquiring the drawable to committing the frame that presents it
+        // Smoothed GPU time per pass of this view's finished frames, indexed by GPUPass; zero on
+        // devices without timestamp sampling.
+        std::array<float, kGPUPassCount> gpuPassTimeMs;
+        float renderScale; // render scale of this frame, after dynamic resolution
+        float shadedPixelRatio; // main pass pixels shaded over pixels covered, below 1 with a rate map
         float frameTime;
         
         void reset() {
@@ -178,6 +423,80 @@ public:
             vertices = 0;
             instanceInput = 0;
             instanceVisible = 0;
+            instancesCached = 0;
+            foliageTilesScattered = 0;
+            foliageTilesResident = 0;
+            terrainVirtualPagesComposited = 0;
+            terrainVirtualPagesResident = 0;
+            particleEmitters = 0;
+            particleEmittersSimulated = 0;
+            particleCapacity = 0;
+            skyLutBakes = 0;
+            skyLightingFaces = 0;
+            frameViews = 0;
+            pickDraws = 0;
+            weightedTransparentDraws = 0;
+            lowResTransparentDraws = 0;
+            cullCandidates = 0;
+            cullFrustumVisible = 0;
+            cullOcclusionTested = 0;
+            cullLodDraws.fill(0);
+            passWork.fill(GPUPassWork{});
+            shadowLightDraws.clear();
+            commandBuffers = 0;
+            uniformBytesUploaded = 0;
+            uniformRingOverflows = 0;
+            skinningBytesUploaded = 0;
+            instanceBytesUploaded = 0;
+            occlusionVisible = 0;
+            occlusionOccluded = 0;
+            skinningCacheMeshes = 0;
+            crowdInstances = 0;
+            parallelEncoders = 0;
+            asyncComputePasses = 0;
+            fogFroxels = 0;
+            fogFroxelsLit = 0;
+            interpolatedFrames = 0;
+            lateLatchedFrames = 0;
+            drawStateBinds = 0;
+            drawStateBindsSkipped = 0;
+            shadowViewsCached = 0;
+            shadowViewsRefreshed = 0;
+            shadowPagesCached = 0;
+            shadowPagesRendered = 0;
+            shadowTilesDowngraded = 0;
+            shadowViewsDeferred = 0;
+            shadowViewsRestored = 0;
+            clustersActive = 0;
+            clustersOverflowed = 0;
+            clusterLightsDropped = 0;
+            clusterTileLightsDropped = 0;
+            lightRecordsUploaded = 0;
+            materialTableEntries = 0;
+            residentResources = 0;
+            dynamicProbesUpdated = 0;
+            dynamicReflectionFaces = 0;
+            visibilityGroups = 0;
+            renderTargetHeapBytes = 0;
+            renderTargetAliasedBytes = 0;
+            transientAllocations = 0;
+            pipelineCompileHistogram.fill(0);
+            pipelinesCompiling = 0;
+            texturesStreaming = 0;
+            mipStreamedTextures = 0;
+            mipStreamedBytes = 0;
+            mipLoadsInFlight = 0;
+            pipelineFallbackDraws = 0;
+            slowestPipelineKey = 0;
+            slowestPipelineCompileMs = 0.0f;
+            gpuFrameTimeMs = 0.0f;
+            gpuLastFrameTimeMs = 0.0f;
+            frameSlotWaitMs = 0.0f;
+            drawableWaitMs = 0.0f;
+            drawableHoldMs = 0.0f;
+            gpuPassTimeMs.fill(0.0f);
+            renderScale = 1.0f;
+            shadedPixelRatio = 1.0f;
             frameTime = 0.0f;
         }
     };
@@ -208,6 +527,11 @@ public:
     const EnvironmentSettings& getEnvironmentSettings() const { return m_environmentSettings; }
     
     bool loadEnvironmentMap(const std::string& path, const std::string& cookedIBLPath = "");
+    // Editor path: raw HDR/EXR sources decode and prefilter on a background thread while the
+    // current environment stays bound; everything else loads at once. The settings report the new
+    // path right away. False when the source cannot be loaded at all.
+    bool requestEnvironmentMap(const std::string& path, const std::string& cookedIBLPath = "");
+    bool isEnvironmentLoading() const;
     bool saveCookedEnvironmentMap(const std::string& path, const std::string& outputPath);
     void resetEnvironment();
     void setEnvironmentRotation(const Math::Vector3& eulerDegrees);
@@ -227,26 +551,43 @@ public:
     void setColorGradingLUT(const std::string& path);
     std::string getEnvironmentPath() const { return m_environmentSettings.sourcePath; }
 
+    // Pipeline archive cook: begin, record each loaded scene, then write (see PipelineArchive).
+    bool beginPipelineArchive();
+    size_t recordScenePipelines(Scene* scene);
+    bool writePipelineArchive(const std::string& path);
+    // Opens a cooked archive and pre-warms its pipelines in the background.
+    bool loadPipelineArchive(const std::string& path);
+    // For a scene loaded ahead of activation (SceneManager::preloadScene): compiles the pipelines
+    // its renderers need that are not built yet and queues its meshes for upload, a few per frame,
+    // so its first frame neither compiles nor uploads. Returns the number of meshes queued.
+    size_t prepareSceneResources(Scene* scene);
+    size_t getPendingMeshUploads() const { return m_pendingMeshUploads.size(); }
+
     // Debug toggles (editor-only use)
     void setDebugDrawShadowAtlas(bool enabled);
     void setDebugDrawCascades(bool enabled);
     void setDebugDrawPointFrusta(bool enabled);
+    // Bars of the per-pass GPU times along the left edge of the view.
+    void setDebugDrawGPUPasses(bool enabled);
     
 private:
     void buildPipelines();
+    void drawGPUPassBars(Camera* camera);
     void buildDepthStencilStates();
     void buildDebugPipelines();
     void buildEnvironmentPipeline();
     void buildBlitPipeline();
     void buildPrepassPipeline();
     void buildInstanceCullingPipeline();
+    void buildStaticScenePipelines();
+    void buildVisibilityPipelines();
     void buildHZBPipelines();
     void buildVelocityPipelines();
     void buildSSAOPipelines();
-    void buildSSAONoiseTexture();
     void buildBloomPipelines();
     void buildImpostorPipeline();
     void buildSSRPipeline();
+    void buildSSRTracePipelines();
     void buildDecalPipeline();
     void buildDOFPipeline();
     void buildFogPipeline();
@@ -254,8 +595,16 @@ private:
     void buildTAAPipeline();
     void buildMotionBlurPipeline();
     void updateProbeVolume(const SceneStaticLightingSettings& staticLighting);
+    void updateDynamicProbeVolume(const SceneStaticLightingSettings& staticLighting);
+    void resetProbeBrickStreaming();
+    void loadProbeBrick(uint32_t cell, uint32_t slot);
+    void streamProbeBricks(const Math::Vector3& cameraPosition);
+    void fillProbeVolumeUniforms(ProbeVolumeUniformsGPU& uniforms) const;
     void updateEnvironmentUniforms();
+    bool usesSkyLighting() const;
+    void bindEnvironmentLighting(MTL::RenderCommandEncoder* encoder) const;
     std::shared_ptr<Texture2D> resolveStaticLightingTexture(const std::string& texturePath, bool srgb);
+    std::shared_ptr<Texture2D> resolveVertexAnimationTexture(const std::string& texturePath);
     void renderSkybox(MTL::RenderCommandEncoder* encoder, Camera* camera);
     void rebuildSamplerState(int anisotropy);
     void releaseMetalFXResources();
@@ -263,18 +612,118 @@ private:
                                 uint32_t inputHeight,
                                 uint32_t outputWidth,
                                 uint32_t outputHeight,
-                                int colorFormat);
+                                int colorFormat,
+                                bool dynamicInput);
+    bool ensureMetalFXSpatialResources(uint32_t inputWidth,
+                                       uint32_t inputHeight,
+                                       uint32_t outputWidth,
+                                       uint32_t outputHeight,
+                                       int colorFormat);
+    bool ensureMetalFXFrameInterpolator();
+    bool ensureMetalFXOutputTexture(uint32_t width, uint32_t height, int colorFormat, uint64_t usage);
     void ensureRenderTargets(uint32_t width, uint32_t height, uint32_t msaaSamples, int colorFormat);
     void ensureFogVolume(uint32_t width, uint32_t height, int quality);
+    void ensureSSAOTargets(uint32_t width, uint32_t height, int resolution);
+    void ensureSSRTargets(uint32_t width, uint32_t height);
+    void ensureVisibilityTargets(uint32_t width, uint32_t height);
     void clearPipelineCache();
+    // Picks the intermediate formats for compactRenderTargets; true when any of them changed.
+    bool updateTargetFormats(const SceneQualitySettings& quality);
     uint32_t resolveSampleCount(uint32_t requested) const;
     
+    // Variants with a reduced pbrFeatures set compile in the background on first use; until they
+    // land the ubershader variant of the same key is returned.
     MTL::RenderPipelineState* getPipelineState(const PipelineStateKey& key);
+    MTL::RenderPipelineState* buildMeshletPipelineState(const PipelineStateKey& key);
+    MTL::RenderPipelineDescriptor* newPipelineDescriptor(const PipelineStateKey& key);
+    MTL::Function* newPbrFragmentFunction(uint8_t features, bool materialTable, bool weightedBlended, bool visibility);
+    // Starts an async compile unless the key is already pending; results land in m_pipelineStates
+    // through collectCompiledPipelines.
+    bool requestPipelineCompile(const PipelineStateKey& key, bool prewarm);
+    void collectCompiledPipelines();
+    // Every pipeline key the scene's renderers resolve to, for the archive cook and preloads.
+    void collectScenePipelineKeys(Scene* scene, std::vector<PipelineStateKey>& keys);
+    size_t uploadPendingMeshes();
+    // The first view of an engine frame's housekeeping; true when something finished.
+    bool serviceBackgroundWork();
+    // Swaps a finished background environment in; true when one was.
+    bool collectEnvironment();
+    void releaseEnvironmentLighting();
+    // Cached pipeline that can draw the key while it compiles, or null to skip the draw.
+    MTL::RenderPipelineState* findFallbackPipeline(const PipelineStateKey& key) const;
+    uint8_t resolveScenePbrFeatures(bool hasDecals) const;
+    uint8_t pbrPrecisionFeatures() const {
+        return m_qualitySettings.halfPrecisionShading ? kPbrFeatureHalfPrecision : 0;
+    }
     
-    void renderMeshRenderer(MeshRenderer* renderer, Camera* camera, const std::vector<Light*>& lights);
+    void renderMeshRenderer(MeshRenderer* renderer, Camera* camera, const FrameVector<Light*>& lights);
     void renderDebugGeometry(Camera* camera);
     
     void setupUniforms(Camera* camera, Light* light);
+
+    // GPU-driven static geometry: eligible MeshRenderers live in a persistent per-slot instance
+    // buffer that is culled on the GPU and drawn through indirect command buffers.
+    bool updateStaticScene(const RenderWorld& world, uint32_t bufferSlot);
+    void rebuildStaticScene(const RenderWorld& world);
+    bool ensureStaticSceneFrame(uint32_t bufferSlot);
+    void dispatchStaticSceneCulling(MTL::CommandBuffer* commandBuffer,
+                                    uint32_t bufferSlot,
+                                    const Math::FrustumPlanes& frustumPlanes,
+                                    const Math::Vector2& screenSize,
+                                    bool useHzb,
+                                    bool encodePrepass);
+    void writeStaticSceneBindings(uint32_t bufferSlot);
+    void useStaticSceneResources(MTL::RenderCommandEncoder* encoder, uint32_t bufferSlot, bool mainPass);
+    // Main-pass draw of a group's meshlet batches through the object/mesh pipeline; the object
+    // stage culls each meshlet against the frustum, its backface cone and, when built, the HZB.
+    void encodeStaticMeshlets(MTL::RenderCommandEncoder* encoder,
+                              uint32_t bufferSlot,
+                              size_t groupIndex,
+                              const Math::FrustumPlanes& frustumPlanes,
+                              const Math::Vector2& screenSize,
+                              bool useHzb);
+    // Rasterizes the static scene's main pass commands into m_visibilityTexture against the
+    // prepass depth, then classifies each tile's batch range for encodeStaticVisibility.
+    void encodeVisibilityBuffer(MTL::CommandBuffer* commandBuffer, uint32_t bufferSlot, const MTL::Viewport& viewport);
+    // Main-pass shading of one group's pixels from the visibility buffer. Returns false when its
+    // pipeline is not ready, and the caller draws the group's indirect commands instead.
+    bool encodeStaticVisibility(MTL::RenderCommandEncoder* encoder,
+                                uint32_t bufferSlot,
+                                size_t groupIndex,
+                                const MTL::Viewport& viewport);
+    // Lighting inputs of the static scene's main pass draws at fragment slots 0 and 2-11.
+    void bindStaticSceneFragmentInputs(MTL::RenderCommandEncoder* encoder, uint32_t bufferSlot);
+    void releaseStaticScene();
+
+    // Two-phase occlusion culling of the CPU-submitted draws: entities the latest finished frame
+    // found occluded skip the first prepass phase, everything frustum-visible is then tested
+    // against the HZB of that phase, and the skipped draws go out as indirect draws whose
+    // instance count the test writes.
+    bool beginOcclusionFrame(uint32_t bufferSlot, size_t candidateCount, size_t argCapacity);
+    // Reads back the newest finished frame, then clears bufferSlot for this frame.
+    void resolveOcclusionResults(uint32_t bufferSlot);
+    // Returns kNoOcclusionArg when the frame's arg table is full; the draw then goes out directly.
+    uint32_t appendOcclusionArg(uint32_t bufferSlot, uint32_t candidate, uint32_t elementCount);
+    void dispatchOcclusionCulling(MTL::CommandBuffer* commandBuffer,
+                                  uint32_t bufferSlot,
+                                  const Math::Vector2& screenSize);
+    // Writes the instance counts of the args appended since the last call.
+    void dispatchOcclusionArgs(MTL::CommandBuffer* commandBuffer, uint32_t bufferSlot);
+    void releaseOcclusionCulling();
+    // Rebuilds every HZB mip from the current contents of m_depthTexture.
+    void buildHzb(MTL::CommandBuffer* commandBuffer);
+    // Both return the number of textures they bound.
+    uint32_t bindPrepassMaterialTextures(MTL::RenderCommandEncoder* encoder, const Material* material);
+    uint32_t bindMainMaterialTextures(MTL::RenderCommandEncoder* encoder, const Material* material);
+    // Fills MaterialTable::kTextureCount handles in table order, engine defaults for missing maps.
+    void resolveMainMaterialTextures(const Material* material, MTL::Texture** textures) const;
+    // Entry of (material, receiveShadows) in this frame's material table, added on first use.
+    uint32_t acquireMaterialTableEntry(const Material* material, bool receiveShadows);
+    // Keeps the material's terrain virtual texture for this frame when it can draw from one.
+    void acquireTerrainVirtualTexture(const Material* material);
+    // terrainParams1.z of the material's main pass uniforms: its terrain virtual texture, one
+    // based, or 0 for direct layer sampling.
+    float terrainVirtualTextureSlot(const Material* material) const;
     
 private:
     struct RenderTargetState {
@@ -285,8 +734,22 @@ private:
         uint32_t hzbMipCount = 0;
         MTL::Texture* normalTexture = nullptr;
         MTL::Texture* ssaoTexture = nullptr;
+        MTL::Texture* ssaoHistoryTexture = nullptr;
+        MTL::Texture* ssaoAccumTexture = nullptr;
         MTL::Texture* ssaoBlurTexture = nullptr;
-        MTL::Texture* ssaoNoiseTexture = nullptr;
+        uint32_t ssaoWidth = 0;
+        uint32_t ssaoHeight = 0;
+        int ssaoResolution = 1;
+        bool ssaoHistoryValid = false;
+        MTL::Texture* ssrHizTexture = nullptr;
+        std::vector<MTL::Texture*> ssrHizMipViews;
+        MTL::Texture* ssrTraceTexture = nullptr;
+        MTL::Texture* ssrHistoryTexture = nullptr;
+        MTL::Texture* ssrAccumTexture = nullptr;
+        MTL::Texture* visibilityTexture = nullptr;
+        uint32_t ssrWidth = 0;
+        uint32_t ssrHeight = 0;
+        bool ssrHistoryValid = false;
         MTL::Texture* velocityTexture = nullptr;
         MTL::Texture* dofTexture = nullptr;
         MTL::Texture* fogTexture = nullptr;
@@ -312,6 +775,7 @@ private:
         uint32_t bloomMipCount = 0;
         MTL::Texture* taaHistoryTexture = nullptr;
         MTL::Texture* taaCurrentTexture = nullptr;
+        MTL::Texture* taaOutputTexture = nullptr;
         MTL::Texture* metalFXOutputTexture = nullptr;
         MTL::Texture* colorTexture = nullptr;
         MTL::Texture* msaaColorTexture = nullptr;
@@ -324,6 +788,95 @@ private:
         uint32_t renderTargetWidth = 0;
         uint32_t renderTargetHeight = 0;
         uint32_t msaaSamples = 1;
+        // Placement heap of the targets above that carry contents across frames.
+        std::unique_ptr<RenderTargetHeap> persistentHeap;
+    };
+
+    static constexpr uint32_t kNoStaticEntry = 0xFFFFFFFFu;
+
+    struct StaticSceneEntry {
+        Entity* entity = nullptr;
+        MeshRenderer* meshRenderer = nullptr;
+        Mesh* mesh = nullptr;
+        Material* material = nullptr;
+        bool receiveShadows = true;
+        uint32_t instanceIndex = 0;
+        Math::Matrix4x4 worldMatrix;
+    };
+
+    struct StaticSceneBatch {
+        Mesh* mesh = nullptr;
+        std::shared_ptr<Material> material;
+        bool receiveShadows = true;
+        uint32_t inputOffset = 0;
+        uint32_t instanceCount = 0;
+        uint32_t outputOffset = 0; // culled instance slots; every LOD level has its own range
+        uint32_t lod = 0;
+        uint32_t lodCount = 1;     // on level 0: how many consecutive batches hold this mesh's LODs
+        bool meshlets = false; // cooked meshlets and a device that runs mesh shaders
+
+        // Uploads can fail or be released between rebuilds, so this is checked when drawing.
+        bool drawsMeshlets() const;
+    };
+
+    // Consecutive batches sharing a material; each is one executeCommandsInBuffer range.
+    struct StaticSceneGroup {
+        std::shared_ptr<Material> material;
+        bool receiveShadows = true;
+        uint32_t firstBatch = 0;
+        uint32_t batchCount = 0;
+    };
+
+    struct StaticSceneState {
+        const RenderWorld* world = nullptr;
+        uint64_t worldVersion = 0;
+        std::vector<StaticSceneEntry> entries;
+        std::vector<StaticSceneBatch> batches;
+        std::vector<StaticSceneGroup> groups;
+        // Indexed like RenderWorld::getMeshRenderers(); kNoStaticEntry for proxies left on the CPU path.
+        std::vector<uint32_t> proxyEntry;
+        std::vector<Math::Matrix4x4> instanceData; // model, normal per instance, batch-contiguous
+        std::vector<uint32_t> instanceBatches;     // level 0 batch of each instance
+        uint32_t culledCapacity = 0;               // culled slots across every batch and LOD level
+        std::vector<const MTL::Resource*> meshResources;
+        // HLOD source entities are switched per frame on the CPU, so they never go static.
+        std::unordered_set<uint64_t> hlodSources;
+        uint64_t instanceVersion = 0;              // bumped when instanceData changes
+        uint64_t layoutVersion = 0;                // bumped on rebuild
+    };
+
+    struct OcclusionFrame {
+        MTL::Buffer* spheres = nullptr;       // float4 per candidate: proxies, then decals
+        MTL::Buffer* visibility = nullptr;    // uint per candidate
+        MTL::Buffer* counters = nullptr;      // visible, occluded
+        MTL::Buffer* args = nullptr;          // DrawIndexedIndirectArgs per deferred draw
+        MTL::Buffer* argCandidates = nullptr; // candidate index per deferred draw
+        size_t candidateCapacity = 0;
+        size_t argCapacity = 0;
+        uint32_t candidateCount = 0;
+        uint32_t argCount = 0;
+        uint32_t argsDispatched = 0;          // args already covered by an occlusion_write_args
+        std::vector<uint64_t> entityIds;      // per proxy candidate, 0 when untested
+        uint64_t frameIndex = 0;
+        bool tested = false;                  // occlusion_cull encoded for this frame
+        bool pending = false;                 // committed, results not read back yet
+    };
+
+    struct StaticSceneFrame {
+        MTL::Buffer* instances = nullptr;
+        MTL::Buffer* instanceBatches = nullptr;
+        MTL::Buffer* culledInstances = nullptr;
+        MTL::Buffer* batches = nullptr;     // StaticBatchGPU table, then material and mesh uniforms
+        MTL::Buffer* counts = nullptr;
+        MTL::Buffer* bindings = nullptr;    // StaticFrameBindingsGPU, probe uniforms, zero light count
+        MTL::Buffer* icbArguments = nullptr;
+        MTL::IndirectCommandBuffer* mainCommands = nullptr;
+        MTL::IndirectCommandBuffer* prepassCommands = nullptr;
+        size_t instanceCapacity = 0;
+        size_t culledCapacity = 0;
+        size_t batchCapacity = 0;
+        uint64_t instanceVersion = 0;
+        uint64_t layoutVersion = 0;
     };
 
     RenderTargetState& getRenderTargetState(RenderTargetPool pool);
@@ -331,6 +884,9 @@ private:
     void loadRenderTargetState(const RenderTargetState& state);
     void releaseRenderTargetState(RenderTargetState& state);
     void invalidateRenderTargetState(RenderTargetState& state, uint32_t msaaSamples);
+    // Recounts the buffers and targets the renderer owns itself, samples the device total and
+    // checks the memory budgets; once per frame.
+    void updateMemoryUsage();
 
     // Metal objects
     MTL::Device* m_device;
@@ -338,12 +894,37 @@ private:
     MTL::Library* m_library;
     MTL::Library* m_debugLibrary;
     CA::MetalLayer* m_metalLayer;
+    // Drawable count each layer had before low-latency presentation changed it, to restore.
+    struct LayerPresentation {
+        uint64_t defaultDrawableCount = 0;
+        bool lowLatency = false;
+    };
+    std::unordered_map<void*, LayerPresentation> m_layerPresentation;
+    bool m_lowLatencyPresentation = false;
+    double m_presentInterval = 0.0; // smoothed game view frame interval, seconds
     
     // Pipeline states (cached)
     std::unordered_map<PipelineStateKey, MTL::RenderPipelineState*, PipelineStateKeyHash> m_pipelineStates;
+    // Filled by Metal's compile completion handlers; shared so late handlers outlive the renderer.
+    struct PipelineCompileQueue;
+    std::shared_ptr<PipelineCompileQueue> m_pipelineCompileQueue;
+    std::unordered_set<PipelineStateKey, PipelineStateKeyHash> m_pendingPipelines;
+    uint32_t m_pipelineGeneration = 0;
+    uint32_t m_pipelineCompilesInFlight = 0;
+    std::array<uint32_t, kPipelineCompileBuckets> m_pipelineCompileHistogram{};
+    uint32_t m_slowestPipelineKey = 0;
+    float m_slowestPipelineCompileMs = 0.0f;
+    // Pipeline archive cook and pre-warm (see PipelineArchive).
+    std::unordered_set<PipelineStateKey, PipelineStateKeyHash> m_archivedPipelineKeys;
+    size_t m_pipelinePrewarmRemaining = 0;
+    std::chrono::steady_clock::time_point m_pipelinePrewarmStart{};
+    // Meshes of preloaded scenes still to upload; weak so a preload dropped meanwhile frees them.
+    std::vector<std::weak_ptr<Mesh>> m_pendingMeshUploads;
     
     // Debug pipeline states
     MTL::RenderPipelineState* m_debugLinePipelineState;
+    MTL::RenderPipelineState* m_debugShapePipelineState;
+    MTL::RenderPipelineState* m_debugMeshWirePipelineState;
     MTL::RenderPipelineState* m_debugGridPipelineState;
     
     // Depth stencil states
@@ -357,25 +938,57 @@ private:
     MTL::RenderPipelineState* m_prepassPipelineState;
     MTL::RenderPipelineState* m_prepassPipelineSkinned;
     MTL::RenderPipelineState* m_prepassPipelineInstanced;
+    MTL::RenderPipelineState* m_prepassPipelineInstancedSkinned;
+    MTL::RenderPipelineState* m_prepassPipelineInstancedVat;
+    MTL::RenderPipelineState* m_prepassPipelineInstancedTerrain;
+    // Moving meshes also write their motion, as the velocity target's second attachment.
+    MTL::RenderPipelineState* m_prepassPipelineMotion = nullptr;
+    MTL::RenderPipelineState* m_prepassPipelineMotionSkinned = nullptr;
+    MTL::RenderPipelineState* m_prepassPipelineMotionCached = nullptr;
     MTL::ComputePipelineState* m_instanceCullPipeline;
     MTL::ComputePipelineState* m_instanceCullHzbPipeline;
     MTL::RenderPipelineState* m_impostorBakePipeline;
     MTL::ComputePipelineState* m_instanceIndirectPipeline;
+    MTL::ComputePipelineState* m_staticCullPipeline;
+    MTL::ComputePipelineState* m_staticCullHzbPipeline;
+    MTL::ComputePipelineState* m_staticEncodePipeline;
+    // Visibility buffer (SceneQualitySettings::visibilityBuffer): the static scene's main pass
+    // commands re-rasterized after the prepass into instance and triangle ids, and the per-tile
+    // batch ranges the shading quads are culled by.
+    MTL::RenderPipelineState* m_visibilityPipeline = nullptr;
+    MTL::ComputePipelineState* m_visibilityClassifyPipeline = nullptr;
+    MTL::Buffer* m_visibilityTileRanges = nullptr;
+    bool m_meshletPipelineSupported = false;
+    // Camera position and pixel scale of the current view for mesh LOD selection, plus the
+    // tolerated error in pixels after lodBias.
+    Math::Vector4 m_lodView = Math::Vector4::Zero;
+    float m_lodPixelError = 1.0f;
     MTL::ComputePipelineState* m_hzbInitPipeline;
     MTL::ComputePipelineState* m_hzbDownsamplePipeline;
-    MTL::RenderPipelineState* m_velocityPipelineState;
-    MTL::RenderPipelineState* m_velocityPipelineSkinned;
-    MTL::RenderPipelineState* m_ssaoPipelineState;
-    MTL::RenderPipelineState* m_ssaoBlurPipelineState;
+    MTL::ComputePipelineState* m_hzbSpdPipeline = nullptr; // every HZB mip in one dispatch
+    MTL::Buffer* m_hzbSpdBuffer = nullptr; // hzb_spd group counter + per-group mip 6 texels
+    MTL::ComputePipelineState* m_occlusionCullPipeline = nullptr;
+    MTL::ComputePipelineState* m_occlusionArgsPipeline = nullptr;
+    MTL::RenderPipelineState* m_velocityReconstructPipeline;
+    MTL::ComputePipelineState* m_ssaoPipelineState;
+    MTL::ComputePipelineState* m_ssaoTemporalPipelineState;
+    MTL::ComputePipelineState* m_ssaoUpsamplePipelineState;
     MTL::RenderPipelineState* m_ssrPipelineState;
+    MTL::ComputePipelineState* m_ssrHizInitPipeline;
+    MTL::ComputePipelineState* m_ssrHizDownsamplePipeline;
+    MTL::ComputePipelineState* m_ssrTracePipeline;
+    MTL::ComputePipelineState* m_ssrTemporalPipeline;
     MTL::RenderPipelineState* m_decalPipelineState;
     MTL::RenderPipelineState* m_bloomPrefilterPipelineState;
     MTL::RenderPipelineState* m_bloomDownsamplePipelineState;
     MTL::RenderPipelineState* m_bloomUpsamplePipelineState;
     MTL::RenderPipelineState* m_bloomCombinePipelineState;
+    MTL::ComputePipelineState* m_bloomDownsampleSPDPipeline = nullptr; // prefilter + downsample chain in one dispatch
     MTL::RenderPipelineState* m_taaPipelineState;
+    MTL::ComputePipelineState* m_taaResolvePipeline = nullptr; // tiled compute TAA with fused sharpening
     MTL::RenderPipelineState* m_dofPipelineState;
     MTL::RenderPipelineState* m_fogPipelineState;
+    MTL::RenderPipelineState* m_ssrFogPipelineState; // SSR with the fog apply folded in
     MTL::ComputePipelineState* m_fogVolumePipelineState;
     MTL::RenderPipelineState* m_motionBlurPipelineState;
     
@@ -386,9 +999,23 @@ private:
     std::vector<MTL::Texture*> m_hzbMipViews;
     uint32_t m_hzbMipCount;
     MTL::Texture* m_normalTexture;
-    MTL::Texture* m_ssaoTexture;
-    MTL::Texture* m_ssaoBlurTexture;
-    MTL::Texture* m_ssaoNoiseTexture;
+    MTL::Texture* m_ssaoTexture;        // AO and view depth at SSAO resolution, this frame's trace
+    MTL::Texture* m_ssaoHistoryTexture; // last frame's accumulated AO
+    MTL::Texture* m_ssaoAccumTexture;   // this frame's accumulated AO, swapped into history
+    MTL::Texture* m_ssaoBlurTexture;    // full-resolution AO read by the main pass
+    uint32_t m_ssaoWidth;
+    uint32_t m_ssaoHeight;
+    int m_ssaoResolution;
+    bool m_ssaoHistoryValid;
+    MTL::Texture* m_ssrHizTexture;              // half-res closest depth pyramid the SSR rays march
+    std::vector<MTL::Texture*> m_ssrHizMipViews;
+    MTL::Texture* m_ssrTraceTexture;            // this frame's half-res reflections, premultiplied
+    MTL::Texture* m_ssrHistoryTexture;          // last frame's accumulated reflections
+    MTL::Texture* m_ssrAccumTexture;            // this frame's accumulated reflections, swapped into history
+    MTL::Texture* m_visibilityTexture;          // RG32Uint culled static instance slot and triangle per pixel
+    uint32_t m_ssrWidth;
+    uint32_t m_ssrHeight;
+    bool m_ssrHistoryValid;
     MTL::Texture* m_velocityTexture;
     MTL::Texture* m_dofTexture;
     MTL::Texture* m_fogTexture;
@@ -413,6 +1040,7 @@ private:
     uint32_t m_bloomMipCount;
     MTL::Texture* m_taaHistoryTexture;
     MTL::Texture* m_taaCurrentTexture;
+    MTL::Texture* m_taaOutputTexture = nullptr; // sharpened resolve; history stays unsharpened
     MTL::Texture* m_metalFXOutputTexture;
     MTLFX::TemporalScaler* m_metalFXTemporalScaler;
     uint32_t m_metalFXInputWidth;
@@ -420,15 +1048,26 @@ private:
     uint32_t m_metalFXOutputWidth;
     uint32_t m_metalFXOutputHeight;
     int m_metalFXColorFormat;
+    // With dynamic resolution the scaler is sized for the largest render size and each frame's
+    // inputs are copied into these, with the frame's size passed as the input content size.
+    bool m_metalFXDynamicInput = false;
+    float m_metalFXMinContentScale = 0.0f;
+    MTL::Texture* m_metalFXColorInput = nullptr;
+    MTL::Texture* m_metalFXDepthInput = nullptr;
+    MTL::Texture* m_metalFXMotionInput = nullptr;
+    MTLFX::SpatialScaler* m_metalFXSpatialScaler = nullptr;
+    // Frame interpolation: the previous upscaled frame and the in-between frame made from it.
+    MTLFX::FrameInterpolator* m_metalFXFrameInterpolator = nullptr;
+    MTL::Texture* m_metalFXPrevOutputTexture = nullptr;
+    MTL::Texture* m_metalFXInterpolatedTexture = nullptr;
+    bool m_metalFXPrevOutputValid = false;
     
     // Offscreen color targets
     MTL::Texture* m_colorTexture;
     MTL::Texture* m_msaaColorTexture;
     
     // Uniform buffers
-    MTL::Buffer* m_modelUniformBuffer;
     MTL::Buffer* m_cameraUniformBuffer;
-    MTL::Buffer* m_materialUniformBuffer;
     MTL::Buffer* m_lightUniformBuffer;
     MTL::Buffer* m_environmentUniformBuffer;
     MTL::Buffer* m_lightGPUBuffer;
@@ -440,9 +1079,7 @@ private:
     MTL::Buffer* m_probeVolumeBuffer;
     MTL::Buffer* m_probeVolumeFallbackBuffer;
     MTL::Buffer* m_skinningBuffer;
-    MTL::Buffer* m_prevSkinningBuffer;
     size_t m_skinningBufferCapacity;
-    size_t m_prevSkinningBufferCapacity;
     MTL::Buffer* m_instanceBuffer;
     size_t m_instanceBufferCapacity;
     size_t m_instanceBufferOffset;
@@ -459,6 +1096,24 @@ private:
     Math::Vector4 m_probeVolumeFeatureParams;
     Math::Vector4 m_probeVolumeBlendParams;
     Math::Vector4 m_probeVolumeReflectionParams;
+    // Brick streaming: when the dense bricks exceed the slot budget they stay here and stream
+    // into the pool around the camera; cells without a resident one use the coarse grid.
+    ProbeVolumeBricks m_probeBricks;
+    std::vector<uint32_t> m_probeBrickSlotOfCell;
+    std::vector<uint32_t> m_probeBrickCellOfSlot;
+    std::vector<uint32_t> m_probeBrickSlotFreedFrame;
+    uint32_t m_probeBrickCoarseOffset = 0;
+    uint32_t m_probeBrickPoolOffset = 0;
+    uint32_t m_probeBrickStreamCell = kProbeBrickNone;
+    bool m_probeBrickStreamPending = false;
+    // Dynamic probes: the grid in m_probeVolumeBuffer is re-traced at runtime instead of read
+    // from the bake; every cell points at the coarse grid starting at this record.
+    bool m_probeVolumeDynamic = false;
+    uint32_t m_dynamicProbeFirstRecord = 0;
+    // Runtime reflection captures at lattice points near the camera: x capture count, y last
+    // prefiltered mip, z influence radius; per slot xyz capture point, w 1 once prefiltered.
+    Math::Vector4 m_dynamicReflectionParams = Math::Vector4::Zero;
+    std::array<Math::Vector4, 8> m_dynamicReflectionSlots{};
     
     // Sampling and textures
     MTL::SamplerState* m_samplerState;
@@ -466,9 +1121,11 @@ private:
     MTL::SamplerState* m_linearClampSampler;
     MTL::SamplerState* m_pointClampSampler;
     std::unique_ptr<TextureLoader> m_textureLoader;
+    std::unique_ptr<TextureStreamer> m_textureStreamer;
     std::shared_ptr<Texture2D> m_defaultWhiteTexture;
     std::shared_ptr<Texture2D> m_defaultNormalTexture;
     std::shared_ptr<Texture2D> m_defaultBlackTexture;
+    std::shared_ptr<Texture2D> m_defaultTransparentTexture;
     std::shared_ptr<Texture2D> m_defaultHeightTexture;
     std::shared_ptr<Texture2D> m_defaultEnvironmentTexture;
     std::shared_ptr<Texture2D> m_environmentTexture;
@@ -477,6 +1134,7 @@ private:
     std::shared_ptr<Texture2D> m_colorGradingNeutralLUT;
     std::string m_colorGradingLUTPath;
     std::unordered_map<std::string, std::shared_ptr<Texture2D>> m_staticLightingTextureCache;
+    std::unordered_map<std::string, std::shared_ptr<Texture2D>> m_vertexAnimationTextureCache;
     
     // Environment rendering
     MTL::RenderPipelineState* m_skyboxPipelineState;
@@ -493,9 +1151,19 @@ private:
     MTL::Texture* m_iblIrradiance;        // Irradiance diffuse
     MTL::Texture* m_iblBRDFLUT;           // BRDF lookup table
     bool m_hasIBL;                        // True if IBL textures are ready
+    std::unique_ptr<EnvironmentProcessor> m_environmentProcessor;
+    // What the settings go back to when a background load fails.
+    std::string m_environmentFallbackPath;
+    std::string m_environmentFallbackCookedPath;
 
     int m_sceneColorFormat;
     bool m_outputHDR;
+    // Intermediate formats (MTL::PixelFormat) chosen by updateTargetFormats. The HDR color format
+    // is what m_sceneColorFormat takes when post processing needs HDR.
+    int m_hdrColorFormat;
+    int m_bloomFormat;
+    int m_normalTargetFormat;
+    int m_decalTargetFormat;
     Math::Matrix4x4 m_prevViewProjection;
     Math::Matrix4x4 m_prevViewProjectionNoJitter;
     Math::Matrix4x4 m_prevFogViewMatrix;
@@ -508,6 +1176,14 @@ private:
     // Active quality settings
     SceneQualitySettings m_qualitySettings;
     uint32_t m_shadowAtlasResolution;
+    // Engine frame of the last renderScene and the views rendered in it. The shadow atlas is sized
+    // for the largest request of this frame's views and the last frame's, so views wanting
+    // different sizes do not reallocate it under each other.
+    uint64_t m_engineFrame = 0;
+    uint64_t m_viewFrame = ~0ull;
+    uint32_t m_viewsThisFrame = 0;
+    uint32_t m_frameShadowAtlasRequest = 0;
+    uint32_t m_lastFrameShadowAtlasRequest = 0;
     uint32_t m_renderTargetWidth;
     uint32_t m_renderTargetHeight;
     uint32_t m_msaaSamples;
@@ -516,9 +1192,34 @@ private:
     std::unique_ptr<LightingSystem> m_lightingSystem;
     std::unique_ptr<ShadowRenderPass> m_shadowPass;
     std::unique_ptr<ClusteredLightingPass> m_clusterPass;
+    std::unique_ptr<SkinningCache> m_skinningCache;
+    std::unique_ptr<CrowdAnimation> m_crowdAnimation;
+    std::unique_ptr<DynamicProbeGI> m_dynamicProbeGI;
+    std::unique_ptr<MaterialTable> m_materialTable;
+    std::unique_ptr<UniformRing> m_uniformRing;
+    std::unique_ptr<SceneResidency> m_sceneResidency;
+    std::unique_ptr<InstanceCache> m_instanceCache;
+    std::unique_ptr<FoliageSystem> m_foliageSystem;
+    std::unique_ptr<TerrainSystem> m_terrainSystem;
+    std::unique_ptr<TerrainVirtualTexture> m_terrainVirtualTexture;
+    std::unique_ptr<TiledPostBlur> m_tiledPostBlur;
+    std::unique_ptr<ParticleSystem> m_particleSystem;
+    std::unique_ptr<SkyAtmosphere> m_skyAtmosphere;
+    std::unique_ptr<ImpostorBaker> m_impostorBaker;
+    std::unique_ptr<EntityPicker> m_entityPicker;
+    std::unique_ptr<RenderTargetHeap> m_renderTargetHeap;
+    std::unique_ptr<AsyncComputeQueue> m_asyncCompute;
+    std::unique_ptr<DynamicResolution> m_dynamicResolution;
+    std::unique_ptr<VariableRateShading> m_variableRateShading;
+    std::unique_ptr<WeightedTransparency> m_weightedTransparency;
+    // Game camera forward of the previous frame, for the rate map's velocity term.
+    Math::Vector3 m_rateMapPrevCameraForward = Math::Vector3(0.0f, 0.0f, -1.0f);
+    bool m_rateMapPrevCameraValid = false;
     bool m_debugDrawShadowAtlas;
     bool m_debugDrawCascades;
     bool m_debugDrawPointFrusta;
+    bool m_debugDrawGPUPasses;
+    std::unique_ptr<GPUPassProfiler> m_gpuPassProfiler;
     
     // Debug renderer
     std::unique_ptr<DebugRenderer> m_debugRenderer;
@@ -536,26 +1237,52 @@ private:
     RenderTargetState m_gameTargets;
     RenderTargetState m_previewTargets;
     RenderTargetPool m_activePool;
+    TrackedMemory m_renderTargetMemory;
+    TrackedMemory m_instanceMemory;
+    TrackedMemory m_skinningMemory;
+    TrackedMemory m_probeMemory;
 
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_cameraUniformBuffers{};
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_lightUniformBuffers{};
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_environmentUniformBuffers{};
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_lightGPUBuffers{};
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_shadowGPUBuffers{};
+    // Record versions each frame-slot light/shadow buffer currently holds.
+    struct RecordUploadState {
+        MTL::Buffer* buffer = nullptr;
+        std::vector<uint64_t> versions;
+    };
+    std::array<RecordUploadState, kMaxFramesInFlight> m_lightRecordUploads{};
+    std::array<RecordUploadState, kMaxFramesInFlight> m_shadowRecordUploads{};
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_clusterParamsBuffers{};
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_skinningBuffers{};
-    std::array<MTL::Buffer*, kMaxFramesInFlight> m_prevSkinningBuffers{};
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_instanceBuffers{};
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_instanceCullBuffers{};
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_instanceCountBuffers{};
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_instanceIndirectBuffers{};
     std::array<size_t, kMaxFramesInFlight> m_skinningBufferCapacities{};
-    std::array<size_t, kMaxFramesInFlight> m_prevSkinningBufferCapacities{};
     std::array<size_t, kMaxFramesInFlight> m_instanceBufferCapacities{};
     std::array<size_t, kMaxFramesInFlight> m_instanceCullCapacities{};
     std::array<size_t, kMaxFramesInFlight> m_instanceCountCapacities{};
     std::array<size_t, kMaxFramesInFlight> m_instanceIndirectCapacities{};
     std::array<MTL::CommandBuffer*, kMaxFramesInFlight> m_inFlightCommandBuffers{};
+    // Each frame's command buffer signals m_frameEvent with the frame's value once its GPU work is
+    // done; a frame slot is reused after its value was reached, without waiting on the buffer.
+    MTL::SharedEvent* m_frameEvent = nullptr;
+    uint64_t m_frameEventValue = 0;
+    std::array<uint64_t, kMaxFramesInFlight> m_inFlightFrameValues{};
+    // Whether the slot's command buffer rendered the game view; its GPU time drives dynamic resolution.
+    std::array<bool, kMaxFramesInFlight> m_inFlightGameView{};
+    StaticSceneState m_staticScene;
+    std::array<StaticSceneFrame, kMaxFramesInFlight> m_staticSceneFrames{};
+    std::array<OcclusionFrame, kMaxFramesInFlight> m_occlusionFrames{};
+    // Entity UUIDs the latest resolved frame found occluded, and that frame's test counts.
+    std::unordered_set<uint64_t> m_occludedEntities;
+    uint64_t m_occlusionResolvedFrame = 0;
+    uint32_t m_occlusionVisible = 0;
+    uint32_t m_occlusionOccluded = 0;
+    // Transient CPU containers for renderScene, rewound when their slot is reused.
+    std::array<FrameArena, kMaxFramesInFlight> m_frameArenas;
 };
 
 } // namespace Crescent
@@ -0,0 +1,112 @@
+#include "SceneResidency.hpp"
+#include <Metal/Metal.hpp>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    constexpr NS::UInteger kInitialCapacity = 1024;
+}
+
+SceneResidency::SceneResidency()
+    : m_queue(nullptr)
+    , m_set(nullptr)
+    , m_frame(0)
+    , m_dirty(false)
+    , m_commitCount(0) {
+}
+
+SceneResidency::~SceneResidency() {
+    shutdown();
+}
+
+bool SceneResidency::initialize(MTL::Device* device, MTL::CommandQueue* queue) {
+    shutdown();
+    if (!device || !queue) {
+        return false;
+    }
+    // Residency sets arrived with macOS 15; older systems do not know the selectors.
+    NS::OperatingSystemVersion required{15, 0, 0};
+    if (!NS::ProcessInfo::processInfo()->isOperatingSystemAtLeastVersion(required)) {
+        return false;
+    }
+    MTL::ResidencySetDescriptor* desc = MTL::ResidencySetDescriptor::alloc()->init();
+    desc->setInitialCapacity(kInitialCapacity);
+    desc->setLabel(NS::String::string("Scene Residency", NS::UTF8StringEncoding));
+    NS::Error* error = nullptr;
+    m_set = device->newResidencySet(desc, &error);
+    desc->release();
+    if (!m_set) {
+        if (error) {
+            std::cerr << "SceneResidency: " << error->localizedDescription()->utf8String() << "\n";
+        }
+        return false;
+    }
+    m_queue = queue;
+    m_queue->addResidencySet(m_set);
+    return true;
+}
+
+void SceneResidency::shutdown() {
+    if (m_set) {
+        m_set->removeAllAllocations();
+        m_set->commit();
+        if (m_queue) {
+            m_queue->removeResidencySet(m_set);
+        }
+        m_set->release();
+        m_set = nullptr;
+    }
+    for (const auto& [resource, lastUsed] : m_lastUsed) {
+        resource->release();
+    }
+    m_lastUsed.clear();
+    m_queue = nullptr;
+    m_dirty = false;
+}
+
+void SceneResidency::use(const MTL::Resource* resource) {
+    if (!m_set || !resource) {
+        return;
+    }
+    auto [it, inserted] = m_lastUsed.emplace(const_cast<MTL::Resource*>(resource), m_frame);
+    if (!inserted) {
+        it->second = m_frame;
+        return;
+    }
+    it->first->retain();
+    m_set->addAllocation(resource);
+    m_dirty = true;
+}
+
+void SceneResidency::use(const MTL::Resource* const* resources, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        use(resources[i]);
+    }
+}
+
+void SceneResidency::commit() {
+    if (!m_set) {
+        return;
+    }
+    // kRetireFrames exceeds the frames in flight, so every frame that used a retired resource has
+    // completed before it leaves the set.
+    for (auto it = m_lastUsed.begin(); it != m_lastUsed.end();) {
+        if (m_frame - it->second <= kRetireFrames) {
+            ++it;
+            continue;
+        }
+        m_set->removeAllocation(it->first);
+        it->first->release();
+        it = m_lastUsed.erase(it);
+        m_dirty = true;
+    }
+    if (m_dirty) {
+        m_set->commit();
+        m_set->requestResidency();
+        ++m_commitCount;
+        m_dirty = false;
+    }
+}
+
+} // namespace Crescent
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace MTL {
+    class Device;
+    class CommandQueue;
+    class Resource;
+    class ResidencySet;
+}
+
+namespace Crescent {
+
+// Scene resources kept resident through an MTL::ResidencySet attached to the command queue, so
+// encoders no longer repeat useResources() for what they reach only through argument buffers and
+// texture handles (material table textures, static scene geometry). Callers mark the resources a
+// frame uses; ones unused for longer than the frames in flight are retired. Residency carries no
+// hazard tracking, so only resources the GPU never writes belong here. Needs macOS 15; without it
+// isAvailable() is false and callers keep their useResources() path.
+class SceneResidency {
+public:
+    static constexpr uint64_t kRetireFrames = 5;
+
+    SceneResidency();
+    ~SceneResidency();
+
+    bool initialize(MTL::Device* device, MTL::CommandQueue* queue);
+    void shutdown();
+    bool isAvailable() const { return m_set != nullptr; }
+
+    void beginFrame(uint64_t frame) { m_frame = frame; }
+    // Main thread only; each resource is retained while it is in the set.
+    void use(const MTL::Resource* resource);
+    void use(const MTL::Resource* const* resources, size_t count);
+    // Retires stale resources and commits the set if it changed; call before the frame's command
+    // buffer is committed so it sees this frame's additions.
+    void commit();
+
+    size_t getResidentCount() const { return m_lastUsed.size(); }
+    uint32_t getCommitCount() const { return m_commitCount; }
+
+private:
+    MTL::CommandQueue* m_queue;
+    MTL::ResidencySet* m_set;
+    std::unordered_map<MTL::Resource*, uint64_t> m_lastUsed;
+    uint64_t m_frame;
+    bool m_dirty;
+    uint32_t m_commitCount;
+};
+
+} // namespace Crescent
@@ -0,0 +1,106 @@
+#include "ShaderLibrary.hpp"
+#include <Metal/Metal.hpp>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+namespace Crescent {
+
+namespace {
+    const char* ModuleFileName(ShaderLibrary::Module module) {
+        switch (module) {
+            case ShaderLibrary::Module::Core: return "Core.metallib";
+            case ShaderLibrary::Module::Shadows: return "Shadows.metallib";
+            case ShaderLibrary::Module::Lighting: return "Lighting.metallib";
+            case ShaderLibrary::Module::Tools: return "Tools.metallib";
+            default: return nullptr;
+        }
+    }
+
+    MTL::Library* LoadModuleLibrary(MTL::Device* device, ShaderLibrary::Module module) {
+        const char* fileName = ModuleFileName(module);
+        NS::String* resources = NS::Bundle::mainBundle() ? NS::Bundle::mainBundle()->resourcePath() : nullptr;
+        if (!fileName || !resources) {
+            return nullptr;
+        }
+        const std::string path = (std::filesystem::path(resources->utf8String()) / fileName).string();
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec)) {
+            return nullptr;
+        }
+        NS::Error* error = nullptr;
+        MTL::Library* library = device->newLibrary(NS::String::string(path.c_str(), NS::UTF8StringEncoding), &error);
+        if (!library && error) {
+            std::cerr << "ShaderLibrary: failed to load " << path << ": "
+                      << error->localizedDescription()->utf8String() << "\n";
+        }
+        return library;
+    }
+}
+
+ShaderLibrary& ShaderLibrary::getInstance() {
+    // Never destroyed, like PipelineArchive: subsystems may still acquire during exit.
+    static ShaderLibrary* instance = new ShaderLibrary();
+    return *instance;
+}
+
+MTL::Library* ShaderLibrary::acquire(MTL::Device* device, Module module) {
+    const size_t index = static_cast<size_t>(module);
+    if (!device || index >= kModuleCount) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (device != m_device) {
+        releaseLocked();
+        m_device = device;
+    }
+    MTL::Library*& library = m_modules[index];
+    if (!library) {
+        library = LoadModuleLibrary(device, module);
+    }
+    if (!library) {
+        if (!m_default) {
+            m_default = device->newDefaultLibrary();
+        }
+        if (m_default) {
+            library = m_default;
+            library->retain();
+        }
+    }
+    if (library) {
+        library->retain();
+    }
+    return library;
+}
+
+void ShaderLibrary::shutdown() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    releaseLocked();
+}
+
+void ShaderLibrary::releaseLocked() {
+    for (MTL::Library*& library : m_modules) {
+        if (library) {
+            library->release();
+            library = nullptr;
+        }
+    }
+    if (m_default) {
+        m_default->release();
+        m_default = nullptr;
+    }
+    m_device = nullptr;
+}
+
+size_t ShaderLibrary::getLoadedCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t count = m_default ? 1 : 0;
+    for (MTL::Library* library : m_modules) {
+        if (library && library != m_default) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace Crescent
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace MTL {
+    class Device;
+    class Library;
+}
+
+namespace Crescent {
+
+// Shared shader libraries. Subsystems acquire their library here instead of each calling
+// newDefaultLibrary(), which loaded the whole default metallib once per caller. A module loads on
+// its first acquire: from <Module>.metallib in the bundle's resources when the build splits it out
+// (so a player build can leave Tools.metallib out), otherwise as the default library, which is
+// loaded once and shared by every module without a file of its own.
+class ShaderLibrary {
+public:
+    enum class Module : uint8_t {
+        Core,     // PBR, post-processing and the renderer's own passes
+        Shadows,  // Shadow.metal
+        Lighting, // IBL, sky, clustered lighting and probe GI
+        Tools,    // editor-only kernels: light baking, picking
+        Count
+    };
+
+    static ShaderLibrary& getInstance();
+
+    // Retained for the caller, who releases it as it would a newDefaultLibrary() result. Null when
+    // neither the module's metallib nor the default library loads.
+    MTL::Library* acquire(MTL::Device* device, Module module);
+    // Drops the cached libraries; pipelines already built keep their functions alive.
+    void shutdown();
+
+    size_t getLoadedCount() const;
+
+private:
+    ShaderLibrary() = default;
+    ShaderLibrary(const ShaderLibrary&) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+    static constexpr size_t kModuleCount = static_cast<size_t>(Module::Count);
+
+    void releaseLocked();
+
+    mutable std::mutex m_mutex;
+    MTL::Device* m_device = nullptr;
+    MTL::Library* m_default = nullptr;
+    std::array<MTL::Library*, kModuleCount> m_modules{};
+};
+
+} // namespace Crescent
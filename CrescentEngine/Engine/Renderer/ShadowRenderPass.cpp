@@ -1,13 +1,19 @@
 #include "ShadowRenderPass.hpp"
+#include "ShaderLibrary.hpp"
 #include "LightingSystem.hpp"
 #include "../Scene/Scene.hpp"
 #include "../Components/Camera.hpp"
 #include "../Components/MeshRenderer.hpp"
 #include "../Components/SkinnedMeshRenderer.hpp"
-#include "../Components/HLODProxy.hpp"
 #include "../Rendering/Mesh.hpp"
 #include "../Rendering/Material.hpp"
+#include "../Core/CPUProfiler.hpp"
 #include "../Core/Time.hpp"
+#include "../Core/JobScheduler.hpp"
+#include "../Math/Frustum.hpp"
+#include "ParallelPassEncoder.hpp"
+#include "GeometryBuffer.hpp"
+#include "PipelineArchive.hpp"
 #include <Metal/Metal.hpp>
 #include <QuartzCore/QuartzCore.hpp>
 #include <algorithm>
@@ -27,6 +33,35 @@ inline void ApplyShadowDepthBias(MTL::RenderCommandEncoder* enc) {
     enc->setDepthBias(2.0f, 2.5f, 0.0f);
 }
 
+// Runs body(begin, end) over [0, count) split across the shared scheduler's workers; the calling
+// thread takes the first chunk and waits for the rest.
+template <typename Body>
+void ParallelShadowRanges(size_t count, size_t minChunk, const Body& body) {
+    if (count == 0) {
+        return;
+    }
+    Crescent::JobScheduler& scheduler = Crescent::JobScheduler::getInstance();
+    const size_t workers = scheduler.isRunning() ? scheduler.workerCount() : 0;
+    const size_t chunks = std::max<size_t>(1, std::min(workers + 1, count / std::max<size_t>(1, minChunk)));
+    if (chunks == 1) {
+        body(size_t(0), count);
+        return;
+    }
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+    auto fence = std::make_shared<Crescent::JobFence>();
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        const size_t begin = chunk * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        if (begin >= end) {
+            break;
+        }
+        fence->remaining.fetch_add(1, std::memory_order_relaxed);
+        scheduler.schedule([&body, begin, end]() { body(begin, end); }, fence);
+    }
+    body(size_t(0), std::min(count, chunkSize));
+    scheduler.wait(*fence);
+}
+
 inline float ComputeShadowInstanceCullRadius(const Crescent::Math::Vector3& meshSize) {
     // Keep a safety margin so dense-instance casters do not pop while camera/cascade moves.
     float sphereRadius = 0.5f * meshSize.length();
@@ -39,30 +74,10 @@ inline float ComputeShadowInstanceCullRadius(const Crescent::Math::Vector3& mesh
 namespace Crescent {
 
 namespace {
-    // Vertex layout matches Engine vertex: position/normal/uv/tangent/bitangent/color
     inline MTL::VertexDescriptor* buildShadowVertexDescriptor(bool skinned, bool includeUV) {
-        MTL::VertexDescriptor* vd = MTL::VertexDescriptor::alloc()->init();
-        vd->attributes()->object(0)->setFormat(MTL::VertexFormatFloat3);
-        vd->attributes()->object(0)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, position)));
-        vd->attributes()->object(0)->setBufferIndex(0);
-        if (includeUV) {
-            vd->attributes()->object(2)->setFormat(MTL::VertexFormatFloat2);
-            vd->attributes()->object(2)->setOffset(static_cast<NS::UInteger>(offsetof(Vertex, texCoord)));
-            vd->attributes()->object(2)->setBufferIndex(0);
-        }
-        vd->layouts()->object(0)->setStride(static_cast<NS::UInteger>(sizeof(Vertex)));
-        vd->layouts()->object(0)->setStepFunction(MTL::VertexStepFunctionPerVertex);
-        if (skinned) {
-            vd->attributes()->object(7)->setFormat(MTL::VertexFormatUInt4);
-            vd->attributes()->object(7)->setOffset(0);
-            vd->attributes()->object(7)->setBufferIndex(4);
-            vd->attributes()->object(8)->setFormat(MTL::VertexFormatFloat4);
-            vd->attributes()->object(8)->setOffset(sizeof(uint32_t) * 4);
-            vd->attributes()->object(8)->setBufferIndex(4);
-            vd->layouts()->object(4)->setStride(sizeof(uint32_t) * 4 + sizeof(float) * 4);
-            vd->layouts()->object(4)->setStepFunction(MTL::VertexStepFunctionPerVertex);
-        }
-        return vd;
+        return GeometryBuffer::NewVertexDescriptor(includeUV ? GeometryBuffer::VertexStreams::PositionUV
+                                                             : GeometryBuffer::VertexStreams::Position,
+                                                   skinned);
     }
 
     struct DrawIndexedIndirectArgs {
@@ -84,10 +99,11 @@ namespace {
         uint32_t inputOffset;
         uint32_t outputOffset;
         uint32_t instanceCount;
-        uint32_t pad;
+        float lodMaxDistance;
         Math::Vector2 screenSize;
         uint32_t hzbMipCount;
         uint32_t pad2;
+        Math::Vector4 lodCamera;
     };
 
     struct ShadowAlphaParamsCPU {
@@ -114,32 +130,28 @@ namespace {
         Math::Vector4 pointFarParams;
     };
 
-    static std::array<Math::Vector4, 6> extractFrustumPlanes(const Math::Matrix4x4& m) {
-        auto row = [&](int r) {
-            return Math::Vector4(m(r, 0), m(r, 1), m(r, 2), m(r, 3));
-        };
-        Math::Vector4 r0 = row(0);
-        Math::Vector4 r1 = row(1);
-        Math::Vector4 r2 = row(2);
-        Math::Vector4 r3 = row(3);
-        std::array<Math::Vector4, 6> planes = {
-            r3 + r0,
-            r3 - r0,
-            r3 + r1,
-            r3 - r1,
-            r3 + r2,
-            r3 - r2
-        };
-        for (auto& p : planes) {
-            float len = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
-            if (len > 0.0f) {
-                p.x /= len;
-                p.y /= len;
-                p.z /= len;
-                p.w /= len;
-            }
+    // Match ShadowLayeredViews / ShadowLayeredSelection in Shadow.metal.
+    struct ShadowLayeredViewsCPU {
+        Math::Matrix4x4 viewProj[6];
+        uint32_t layer[6];
+        uint32_t pad0;
+        uint32_t pad1;
+        Math::Vector4 pointLightPosNear;
+        Math::Vector4 pointFarParams;
+    };
+
+    struct ShadowLayeredSelectionCPU {
+        uint32_t view[6];
+        uint32_t pad0;
+        uint32_t pad1;
+    };
+
+    inline uint32_t CountViewBits(uint32_t mask) {
+        uint32_t count = 0;
+        for (; mask; mask &= mask - 1) {
+            ++count;
         }
-        return planes;
+        return count;
     }
 
     inline bool IsCutoutMaterial(const std::shared_ptr<Material>& material) {
@@ -244,6 +256,55 @@ namespace {
         params.flags = Math::Vector4(0.0f);
         return params;
     }
+
+    constexpr uint64_t kShadowHashSeed = 14695981039346656037ull;
+
+    inline uint64_t HashShadowBytes(uint64_t hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<uint64_t>(bytes[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template <typename T>
+    inline uint64_t HashShadowValue(uint64_t hash, const T& value) {
+        return HashShadowBytes(hash, &value, sizeof(T));
+    }
+
+    // Wind, LOD fade, billboards and dithering move with time or the camera, so these casters
+    // are redrawn every frame even when their transform is still.
+    inline bool IsAnimatedShadowMaterial(const std::shared_ptr<Material>& material) {
+        return material && (material->getWindEnabled() || material->getLodFadeEnabled() ||
+                            material->getBillboardEnabled() || material->getDitherEnabled());
+    }
+
+    // Everything that ends up in the depth of a still caster.
+    inline uint64_t HashShadowCaster(uint64_t id, const Mesh* mesh, uint32_t lod,
+                                     const std::shared_ptr<Material>& material,
+                                     const Math::Matrix4x4& modelMatrix) {
+        uint64_t hash = HashShadowValue(kShadowHashSeed, id);
+        hash = HashShadowValue(hash, mesh);
+        hash = HashShadowValue(hash, lod);
+        hash = HashShadowValue(hash, modelMatrix);
+        const Material* mat = material.get();
+        hash = HashShadowValue(hash, mat);
+        if (mat) {
+            const void* albedoTex = mat->getAlbedoTexture().get();
+            const void* opacityTex = mat->getOpacityTexture().get();
+            hash = HashShadowValue(hash, mat->getRenderMode());
+            hash = HashShadowValue(hash, mat->getCullMode());
+            hash = HashShadowValue(hash, mat->isTwoSided());
+            hash = HashShadowValue(hash, mat->getAlphaCutoff());
+            hash = HashShadowValue(hash, mat->getAlbedo());
+            hash = HashShadowValue(hash, mat->getUVTiling());
+            hash = HashShadowValue(hash, mat->getUVOffset());
+            hash = HashShadowValue(hash, albedoTex);
+            hash = HashShadowValue(hash, opacityTex);
+        }
+        return hash;
+    }
 }
 
 ShadowRenderPass::ShadowRenderPass()
@@ -274,6 +335,15 @@ ShadowRenderPass::ShadowRenderPass()
     , m_spotPipelineInstancedCutout(nullptr)
     , m_pointPipelineInstancedCutout(nullptr)
     , m_areaPipelineInstancedCutout(nullptr)
+    , m_dirPipelineInstancedSkinned(nullptr)
+    , m_spotPipelineInstancedSkinned(nullptr)
+    , m_pointPipelineInstancedSkinned(nullptr)
+    , m_areaPipelineInstancedSkinned(nullptr)
+    , m_dirPipelineInstancedVat(nullptr)
+    , m_spotPipelineInstancedVat(nullptr)
+    , m_pointPipelineInstancedVat(nullptr)
+    , m_areaPipelineInstancedVat(nullptr)
+    , m_dirPipelineInstancedTerrain(nullptr)
     , m_instanceCullPipeline(nullptr)
     , m_instanceIndirectPipeline(nullptr)
     , m_instanceCullBuffer(nullptr)
@@ -304,21 +374,7 @@ bool ShadowRenderPass::initialize(MTL::Device* device, uint32_t atlasResolution,
         return false;
     }
     
-    // Create atlas texture (depth-only)
-    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
-    desc->setTextureType(atlasLayers > 1 ? MTL::TextureType2DArray : MTL::TextureType2D);
-    desc->setWidth(atlasResolution);
-    desc->setHeight(atlasResolution);
-    desc->setArrayLength(atlasLayers);
-    desc->setPixelFormat(MTL::PixelFormatDepth32Float);
-    desc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
-    desc->setStorageMode(MTL::StorageModePrivate);
-    
-    m_shadowAtlas = m_device->newTexture(desc);
-    desc->release();
-    
-    if (!m_shadowAtlas) {
-        std::cerr << "Failed to create shadow atlas texture\n";
+    if (!createAtlas()) {
         return false;
     }
     
@@ -342,8 +398,115 @@ bool ShadowRenderPass::initialize(MTL::Device* device, uint32_t atlasResolution,
     return m_dirPipeline && m_spotPipeline && m_pointPipeline && m_areaPipeline;
 }
 
+bool ShadowRenderPass::createAtlas() {
+    if (m_shadowAtlas) {
+        m_shadowAtlas->release();
+        m_shadowAtlas = nullptr;
+    }
+
+    // Create atlas texture (depth-only)
+    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+    desc->setTextureType(m_atlasLayers > 1 ? MTL::TextureType2DArray : MTL::TextureType2D);
+    desc->setWidth(m_atlasResolution);
+    desc->setHeight(m_atlasResolution);
+    desc->setArrayLength(m_atlasLayers);
+    desc->setPixelFormat(MTL::PixelFormatDepth32Float);
+    desc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
+    desc->setStorageMode(MTL::StorageModePrivate);
+    
+    m_shadowAtlas = m_device->newTexture(desc);
+    desc->release();
+    
+    if (!m_shadowAtlas) {
+        std::cerr << "Failed to create shadow atlas texture\n";
+        releaseDepthBounds();
+        return false;
+    }
+    createDepthBounds();
+    return true;
+}
+
+void ShadowRenderPass::createDepthBounds() {
+    releaseDepthBounds();
+    // The main pass samples the atlas as a single 2D texture, so a layered atlas has no bounds.
+    if (!m_shadowAtlas || m_atlasLayers > 1) {
+        return;
+    }
+    const uint32_t size = std::max<uint32_t>(1u, m_atlasResolution / 2u);
+    uint32_t mipCount = 1;
+    while ((size >> mipCount) > 0) {
+        ++mipCount;
+    }
+    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::texture2DDescriptor(MTL::PixelFormatRG32Float,
+                                                                               size, size, true);
+    desc->setMipmapLevelCount(mipCount);
+    desc->setUsage(MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
+    desc->setStorageMode(MTL::StorageModePrivate);
+    m_depthBounds = m_device->newTexture(desc);
+    if (!m_depthBounds) {
+        std::cerr << "ShadowRenderPass: failed to create shadow depth bounds\n";
+        return;
+    }
+    m_depthBoundsMips.reserve(mipCount);
+    for (uint32_t mip = 0; mip < mipCount; ++mip) {
+        MTL::Texture* view = m_depthBounds->newTextureView(MTL::PixelFormatRG32Float, MTL::TextureType2D,
+                                                           NS::Range::Make(mip, 1), NS::Range::Make(0, 1));
+        if (!view) {
+            releaseDepthBounds();
+            return;
+        }
+        m_depthBoundsMips.push_back(view);
+    }
+}
+
+void ShadowRenderPass::releaseDepthBounds() {
+    for (MTL::Texture* view : m_depthBoundsMips) {
+        view->release();
+    }
+    m_depthBoundsMips.clear();
+    if (m_depthBounds) {
+        m_depthBounds->release();
+        m_depthBounds = nullptr;
+    }
+}
+
+void ShadowRenderPass::buildDepthBounds(MTL::CommandBuffer* cmdBuffer) {
+    if (!hasDepthBounds()) {
+        return;
+    }
+    // One encoder: its dispatches run in order, each reading the level the previous one wrote.
+    MTL::ComputeCommandEncoder* enc = beginComputeEncoder(cmdBuffer);
+    const MTL::Size threadgroup(8, 8, 1);
+    auto dispatch = [&](MTL::Texture* target) {
+        enc->dispatchThreads(MTL::Size(target->width(), target->height(), 1), threadgroup);
+    };
+    enc->setComputePipelineState(m_boundsInitPipeline);
+    enc->setTexture(m_shadowAtlas, 0);
+    enc->setTexture(m_depthBoundsMips[0], 1);
+    dispatch(m_depthBoundsMips[0]);
+    enc->setComputePipelineState(m_boundsDownsamplePipeline);
+    for (size_t mip = 1; mip < m_depthBoundsMips.size(); ++mip) {
+        enc->setTexture(m_depthBoundsMips[mip - 1], 0);
+        enc->setTexture(m_depthBoundsMips[mip], 1);
+        dispatch(m_depthBoundsMips[mip]);
+    }
+    enc->endEncoding();
+}
+
+bool ShadowRenderPass::resizeAtlas(uint32_t atlasResolution, uint32_t atlasLayers) {
+    if (!m_device) {
+        return false;
+    }
+    m_atlasResolution = atlasResolution;
+    m_atlasLayers = atlasLayers;
+    return createAtlas();
+}
+
 void ShadowRenderPass::shutdown() {
     if (m_shadowAtlas) { m_shadowAtlas->release(); m_shadowAtlas = nullptr; }
+    releaseDepthBounds();
+    if (m_boundsInitPipeline) { m_boundsInitPipeline->release(); m_boundsInitPipeline = nullptr; }
+    if (m_boundsDownsamplePipeline) { m_boundsDownsamplePipeline->release(); m_boundsDownsamplePipeline = nullptr; }
     for (auto& tex : m_pointCubeTextures) {
         if (tex) tex->release();
     }
@@ -373,6 +536,24 @@ void ShadowRenderPass::shutdown() {
     if (m_spotPipelineInstancedCutout) { m_spotPipelineInstancedCutout->release(); m_spotPipelineInstancedCutout = nullptr; }
     if (m_pointPipelineInstancedCutout) { m_pointPipelineInstancedCutout->release(); m_pointPipelineInstancedCutout = nullptr; }
     if (m_areaPipelineInstancedCutout) { m_areaPipelineInstancedCutout->release(); m_areaPipelineInstancedCutout = nullptr; }
+    if (m_dirPipelineInstancedSkinned) { m_dirPipelineInstancedSkinned->release(); m_dirPipelineInstancedSkinned = nullptr; }
+    if (m_spotPipelineInstancedSkinned) { m_spotPipelineInstancedSkinned->release(); m_spotPipelineInstancedSkinned = nullptr; }
+    if (m_pointPipelineInstancedSkinned) { m_pointPipelineInstancedSkinned->release(); m_pointPipelineInstancedSkinned = nullptr; }
+    if (m_areaPipelineInstancedSkinned) { m_areaPipelineInstancedSkinned->release(); m_areaPipelineInstancedSkinned = nullptr; }
+    if (m_dirPipelineInstancedVat) { m_dirPipelineInstancedVat->release(); m_dirPipelineInstancedVat = nullptr; }
+    if (m_spotPipelineInstancedVat) { m_spotPipelineInstancedVat->release(); m_spotPipelineInstancedVat = nullptr; }
+    if (m_pointPipelineInstancedVat) { m_pointPipelineInstancedVat->release(); m_pointPipelineInstancedVat = nullptr; }
+    if (m_areaPipelineInstancedVat) { m_areaPipelineInstancedVat->release(); m_areaPipelineInstancedVat = nullptr; }
+    if (m_dirPipelineInstancedTerrain) { m_dirPipelineInstancedTerrain->release(); m_dirPipelineInstancedTerrain = nullptr; }
+    if (m_dirPipelineLayered) { m_dirPipelineLayered->release(); m_dirPipelineLayered = nullptr; }
+    if (m_dirPipelineLayeredSkinned) { m_dirPipelineLayeredSkinned->release(); m_dirPipelineLayeredSkinned = nullptr; }
+    if (m_dirPipelineLayeredCutout) { m_dirPipelineLayeredCutout->release(); m_dirPipelineLayeredCutout = nullptr; }
+    if (m_dirPipelineLayeredSkinnedCutout) { m_dirPipelineLayeredSkinnedCutout->release(); m_dirPipelineLayeredSkinnedCutout = nullptr; }
+    if (m_pointPipelineLayered) { m_pointPipelineLayered->release(); m_pointPipelineLayered = nullptr; }
+    if (m_pointPipelineLayeredSkinned) { m_pointPipelineLayeredSkinned->release(); m_pointPipelineLayeredSkinned = nullptr; }
+    if (m_pointPipelineLayeredCutout) { m_pointPipelineLayeredCutout->release(); m_pointPipelineLayeredCutout = nullptr; }
+    if (m_pointPipelineLayeredSkinnedCutout) { m_pointPipelineLayeredSkinnedCutout->release(); m_pointPipelineLayeredSkinnedCutout = nullptr; }
+    m_maxAmplification = 1;
     if (m_instanceCullPipeline) { m_instanceCullPipeline->release(); m_instanceCullPipeline = nullptr; }
     if (m_instanceIndirectPipeline) { m_instanceIndirectPipeline->release(); m_instanceIndirectPipeline = nullptr; }
     for (uint32_t i = 0; i < kMaxFramesInFlight; ++i) {
@@ -394,6 +575,15 @@ void ShadowRenderPass::shutdown() {
     if (m_alphaSampler) { m_alphaSampler->release(); m_alphaSampler = nullptr; }
     m_skinningBufferCapacity = 0;
     m_skinningBufferOffset = 0;
+    releaseShadowCache();
+    if (m_clearPage) { m_clearPage->release(); m_clearPage = nullptr; }
+    m_casterHistory.clear();
+    m_memory.reset();
+}
+
+void ShadowRenderPass::setLodSelection(const Math::Vector4& lodView, float pixelError) {
+    m_lodView = lodView;
+    m_lodPixelError = pixelError;
 }
 
 void ShadowRenderPass::setFrameSlot(uint32_t frameSlot) {
@@ -406,6 +596,28 @@ void ShadowRenderPass::setFrameSlot(uint32_t frameSlot) {
     m_instanceCullCapacity = m_instanceCullCapacities[m_frameSlot];
     m_instanceCountCapacity = m_instanceCountCapacities[m_frameSlot];
     m_instanceIndirectCapacity = m_instanceIndirectCapacities[m_frameSlot];
+    updateMemoryUsage();
+}
+
+void ShadowRenderPass::updateMemoryUsage() {
+    uint64_t bytes = m_shadowCacheBytes;
+    if (m_shadowAtlas) {
+        bytes += m_shadowAtlas->allocatedSize();
+    }
+    if (m_depthBounds) {
+        bytes += m_depthBounds->allocatedSize();
+    }
+    for (MTL::Texture* cube : m_pointCubeTextures) {
+        bytes += cube ? cube->allocatedSize() : 0;
+    }
+    if (m_clearPage) {
+        bytes += m_clearPage->allocatedSize();
+    }
+    for (uint32_t slot = 0; slot < kMaxFramesInFlight; ++slot) {
+        bytes += m_skinningBufferCapacities[slot] + m_instanceCullCapacities[slot]
+               + m_instanceCountCapacities[slot] + m_instanceIndirectCapacities[slot];
+    }
+    m_memory.reset(MemoryCategory::Shadows, bytes);
 }
 
 void ShadowRenderPass::buildDepthState() {
@@ -442,13 +654,14 @@ bool ShadowRenderPass::allocateSkinningSlice(size_t bytes, size_t& outOffset) {
 
 void ShadowRenderPass::buildPipelines() {
     NS::Error* error = nullptr;
-    MTL::Library* lib = m_device->newDefaultLibrary();
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_device, ShaderLibrary::Module::Shadows);
     if (!lib) {
         std::cerr << "ShadowRenderPass: missing default Metal library\n";
         return;
     }
     
-    auto buildPipeline = [&](const char* vsName, MTL::RenderPipelineState** out, bool skinned, bool includeUV, const char* fsName) {
+    auto buildPipeline = [&](const char* vsName, MTL::RenderPipelineState** out, bool skinned, bool includeUV, const char* fsName,
+                             uint32_t amplification = 1) {
         MTL::Function* vs = lib->newFunction(NS::String::string(vsName, NS::UTF8StringEncoding));
         if (!vs) { std::cerr << "ShadowRenderPass: missing shader " << vsName << "\n"; return; }
         MTL::Function* fs = nullptr;
@@ -468,6 +681,13 @@ void ShadowRenderPass::buildPipelines() {
         desc->setVertexDescriptor(vd);
         desc->colorAttachments()->object(0)->setPixelFormat(MTL::PixelFormatInvalid);
         desc->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
+        if (amplification > 1) {
+            // Layered rendering picks the array slice per primitive.
+            desc->setInputPrimitiveTopology(MTL::PrimitiveTopologyClassTriangle);
+            desc->setMaxVertexAmplificationCount(amplification);
+        }
+        PipelineArchive::getInstance().attach(desc);
+        PipelineArchive::getInstance().record(desc);
         
         *out = m_device->newRenderPipelineState(desc, &error);
         if (error) {
@@ -493,6 +713,15 @@ void ShadowRenderPass::buildPipelines() {
     buildPipeline("shadow_spot_vertex_instanced", &m_spotPipelineInstanced, false, false, nullptr);
     buildPipeline("shadow_point_vertex_instanced", &m_pointPipelineInstanced, false, false, nullptr);
     buildPipeline("shadow_area_vertex_instanced", &m_areaPipelineInstanced, false, false, nullptr);
+    buildPipeline("shadow_dir_vertex_skinned_instanced", &m_dirPipelineInstancedSkinned, true, false, nullptr);
+    buildPipeline("shadow_spot_vertex_skinned_instanced", &m_spotPipelineInstancedSkinned, true, false, nullptr);
+    buildPipeline("shadow_point_vertex_skinned_instanced", &m_pointPipelineInstancedSkinned, true, false, nullptr);
+    buildPipeline("shadow_area_vertex_skinned_instanced", &m_areaPipelineInstancedSkinned, true, false, nullptr);
+    buildPipeline("shadow_dir_vertex_vat_instanced", &m_dirPipelineInstancedVat, false, false, nullptr);
+    buildPipeline("shadow_spot_vertex_vat_instanced", &m_spotPipelineInstancedVat, false, false, nullptr);
+    buildPipeline("shadow_point_vertex_vat_instanced", &m_pointPipelineInstancedVat, false, false, nullptr);
+    buildPipeline("shadow_area_vertex_vat_instanced", &m_areaPipelineInstancedVat, false, false, nullptr);
+    buildPipeline("shadow_dir_vertex_terrain_instanced", &m_dirPipelineInstancedTerrain, false, false, nullptr);
 
     buildPipeline("shadow_dir_vertex_cutout", &m_dirPipelineCutout, false, true, "shadow_alpha_fragment");
     buildPipeline("shadow_spot_vertex_cutout", &m_spotPipelineCutout, false, true, "shadow_alpha_fragment");
@@ -507,6 +736,33 @@ void ShadowRenderPass::buildPipelines() {
     buildPipeline("shadow_point_vertex_cutout_instanced", &m_pointPipelineInstancedCutout, false, true, "shadow_alpha_fragment");
     buildPipeline("shadow_area_vertex_cutout_instanced", &m_areaPipelineInstancedCutout, false, true, "shadow_alpha_fragment");
 
+    // Cube faces and cascades render layered when a caster draw can be amplified into several
+    // views; devices that amplify fewer than a cube's six split the views over more draws.
+    m_maxAmplification = 1;
+    for (uint32_t count = kMaxLayeredViews; count > 1; --count) {
+        if (m_device->supportsVertexAmplificationCount(count)) {
+            m_maxAmplification = count;
+            break;
+        }
+    }
+    if (m_maxAmplification > 1) {
+        const uint32_t amp = m_maxAmplification;
+        buildPipeline("shadow_dir_vertex_layered", &m_dirPipelineLayered, false, false, nullptr, amp);
+        buildPipeline("shadow_dir_vertex_skinned_layered", &m_dirPipelineLayeredSkinned, true, false, nullptr, amp);
+        buildPipeline("shadow_dir_vertex_cutout_layered", &m_dirPipelineLayeredCutout, false, true,
+                      "shadow_alpha_fragment_layered", amp);
+        buildPipeline("shadow_dir_vertex_cutout_skinned_layered", &m_dirPipelineLayeredSkinnedCutout, true, true,
+                      "shadow_alpha_fragment_layered", amp);
+        buildPipeline("shadow_point_vertex_layered", &m_pointPipelineLayered, false, false,
+                      "shadow_point_fragment_layered", amp);
+        buildPipeline("shadow_point_vertex_skinned_layered", &m_pointPipelineLayeredSkinned, true, false,
+                      "shadow_point_fragment_layered", amp);
+        buildPipeline("shadow_point_vertex_cutout_layered", &m_pointPipelineLayeredCutout, false, true,
+                      "shadow_point_fragment_cutout_layered", amp);
+        buildPipeline("shadow_point_vertex_cutout_skinned_layered", &m_pointPipelineLayeredSkinnedCutout, true, true,
+                      "shadow_point_fragment_cutout_layered", amp);
+    }
+
     MTL::Function* cullFn = lib->newFunction(NS::String::string("instance_cull", NS::UTF8StringEncoding));
     MTL::Function* indirectFn = lib->newFunction(NS::String::string("instance_build_indirect", NS::UTF8StringEncoding));
     if (cullFn && indirectFn) {
@@ -525,6 +781,25 @@ void ShadowRenderPass::buildPipelines() {
     }
     if (cullFn) cullFn->release();
     if (indirectFn) indirectFn->release();
+
+    MTL::Function* boundsInitFn = lib->newFunction(NS::String::string("shadow_bounds_init", NS::UTF8StringEncoding));
+    MTL::Function* boundsDownFn = lib->newFunction(NS::String::string("shadow_bounds_downsample", NS::UTF8StringEncoding));
+    if (boundsInitFn && boundsDownFn) {
+        NS::Error* computeErr = nullptr;
+        m_boundsInitPipeline = m_device->newComputePipelineState(boundsInitFn, &computeErr);
+        if (!m_boundsInitPipeline && computeErr) {
+            std::cerr << "ShadowRenderPass: depth bounds compute error " << computeErr->localizedDescription()->utf8String() << "\n";
+        }
+        computeErr = nullptr;
+        m_boundsDownsamplePipeline = m_device->newComputePipelineState(boundsDownFn, &computeErr);
+        if (!m_boundsDownsamplePipeline && computeErr) {
+            std::cerr << "ShadowRenderPass: depth bounds compute error " << computeErr->localizedDescription()->utf8String() << "\n";
+        }
+    } else {
+        std::cerr << "ShadowRenderPass: missing depth bounds compute shaders; soft shadows search every texel\n";
+    }
+    if (boundsInitFn) boundsInitFn->release();
+    if (boundsDownFn) boundsDownFn->release();
     
     lib->release();
 }
@@ -533,82 +808,75 @@ void ShadowRenderPass::execute(MTL::CommandBuffer* cmdBuffer,
                                Scene* scene,
                                Camera* camera,
                                const LightingSystem& lighting,
-                               const std::vector<InstancedShadowDraw>& instancedDraws) {
+                               const FrameVector<InstancedShadowDraw>& instancedDraws) {
     if (!cmdBuffer || !scene || !camera || !m_shadowAtlas) {
         return;
     }
+    CRESCENT_PROFILE_SCOPE("ShadowRenderPass::execute");
 
     m_cameraPosition = camera->getEntity()->getTransform()->getPosition();
     m_timeSeconds = Time::time();
     m_skinningBufferOffset = 0;
-
-    m_hlodHidden.clear();
-    m_hlodActiveProxies.clear();
-    {
-        const auto& hlodEntities = scene->getAllEntities();
-        for (const auto& entityPtr : hlodEntities) {
-            Entity* entity = entityPtr.get();
-            if (!entity || !entity->isActiveInHierarchy()) {
-                continue;
-            }
-            HLODProxy* proxy = entity->getComponent<HLODProxy>();
-            if (!proxy || !proxy->isEnabled()) {
-                continue;
-            }
-            MeshRenderer* mr = entity->getComponent<MeshRenderer>();
-            if (!mr || !mr->isEnabled() || !mr->getMesh()) {
-                continue;
-            }
-            Math::Vector3 center = mr->getBoundsCenter();
-            float dist = (center - m_cameraPosition).length();
-            float activationDistance = proxy->getLodEnd() > proxy->getLodStart() + 0.01f
-                ? proxy->getLodEnd()
-                : proxy->getLodStart();
-            if (dist < activationDistance) {
-                continue;
-            }
-            std::string proxyId = entity->getUUID().toString();
-            m_hlodActiveProxies.insert(proxyId);
-            for (const auto& src : proxy->getSourceUuids()) {
-                m_hlodHidden.insert(src);
-            }
-        }
-    }
+    m_parallelEncoderCount = 0;
+    m_cachedViewCount = 0;
+    m_refreshedViewCount = 0;
+    m_cachedPageCount = 0;
+    m_renderedPageCount = 0;
+    m_restoredViewCount = 0;
+    m_viewDrawCounts.clear();
+    m_lightDrawCounts.clear();
+    m_casterSkinningBytes = 0;
+    m_historyCaptures.clear();
+    ++m_frameIndex;
+
+    m_hlodSwitch = &scene->updateHLODSwitch(m_cameraPosition);
+    
+    gatherCasters(scene);
+    cullShadowViews(lighting);
     
     // Clear atlas once
+    m_profiledPass = GPUPass::ShadowDirectional;
     {
         MTL::RenderPassDescriptor* clearDesc = MTL::RenderPassDescriptor::alloc()->init();
         clearDesc->depthAttachment()->setTexture(m_shadowAtlas);
         clearDesc->depthAttachment()->setLoadAction(MTL::LoadActionClear);
         clearDesc->depthAttachment()->setStoreAction(MTL::StoreActionStore);
         clearDesc->depthAttachment()->setClearDepth(1.0);
-        MTL::RenderCommandEncoder* clearEnc = cmdBuffer->renderCommandEncoder(clearDesc);
+        MTL::RenderCommandEncoder* clearEnc = beginRenderEncoder(cmdBuffer, clearDesc);
         clearEnc->endEncoding();
         clearDesc->release();
     }
     
     renderDirectional(cmdBuffer, scene, lighting);
+    m_profiledPass = GPUPass::ShadowLocal;
     renderLocal(cmdBuffer, scene, lighting);
+    m_profiledPass = GPUPass::ShadowPoint;
     renderPointCubes(cmdBuffer, scene, lighting);
 
     if (!instancedDraws.empty()) {
         const auto& cascades = lighting.getCascades();
+        m_profiledPass = GPUPass::ShadowDirectional;
         if (!cascades.empty()) {
             for (size_t i = 0; i < cascades.size(); ++i) {
                 const auto& slice = cascades[i];
-                if (!slice.atlas.valid || !m_dirPipelineInstanced) {
+                if (!slice.atlas.valid || !m_dirPipelineInstanced ||
+                    wasShadowViewRestored(ShadowCacheKey{slice.owner, static_cast<uint32_t>(i)})) {
                     continue;
                 }
                 ShadowGPUData tempShadow{};
                 tempShadow.viewProj = slice.viewProj;
                 ShadowAtlasTile tile = slice.atlas;
-                renderInstancedRange(cmdBuffer, tempShadow, tile, m_dirPipelineInstanced, m_dirPipelineInstancedCutout, instancedDraws);
+                renderInstancedRange(cmdBuffer, tempShadow, tile, m_dirPipelineInstanced, m_dirPipelineInstancedCutout,
+                                     m_dirPipelineInstancedSkinned, m_dirPipelineInstancedVat,
+                                     m_dirPipelineInstancedTerrain, static_cast<int32_t>(i), instancedDraws);
             }
         }
 
         // Render instanced local shadows
+        m_profiledPass = GPUPass::ShadowLocal;
         const auto& lights = lighting.getGPULights();
         const auto& shadows = lighting.getGPUShadows();
+        const auto& preparedLights = lighting.getPreparedLights();
         for (size_t i = 0; i < lights.size(); ++i) {
             const LightGPUData& lgpu = lights[i];
             int shadowIdx = static_cast<int>(lgpu.shadowCookie.x);
@@ -619,6 +887,10 @@ void ShadowRenderPass::execute(MTL::CommandBuffer* cmdBuffer,
             if (type == 1) {
                 continue;
             }
+            const Light* light = i < preparedLights.size() ? preparedLights[i].light : nullptr;
+            if (wasShadowViewRestored(ShadowCacheKey{light, 0})) {
+                continue;
+            }
             const ShadowGPUData& s = shadows[shadowIdx];
             ShadowAtlasTile tile{};
             tile.valid = true;
@@ -644,10 +916,16 @@ void ShadowRenderPass::execute(MTL::CommandBuffer* cmdBuffer,
                 case 4: pipelineInstancedCutout = m_areaPipelineInstancedCutout; break;
                 default: pipelineInstancedCutout = nullptr; break;
             }
-            renderInstancedRange(cmdBuffer, s, tile, pipelineInstanced, pipelineInstancedCutout, instancedDraws);
+            MTL::RenderPipelineState* pipelineInstancedSkinned =
+                type == 2 ? m_spotPipelineInstancedSkinned : m_areaPipelineInstancedSkinned;
+            MTL::RenderPipelineState* pipelineInstancedVat =
+                type == 2 ? m_spotPipelineInstancedVat : m_areaPipelineInstancedVat;
+            renderInstancedRange(cmdBuffer, s, tile, pipelineInstanced, pipelineInstancedCutout, pipelineInstancedSkinned,
+                                 pipelineInstancedVat, nullptr, -1, instancedDraws);
         }
 
         // Render instanced point shadows
+        m_profiledPass = GPUPass::ShadowPoint;
         if (m_pointPipelineInstanced) {
             const auto& prepared = lighting.getPreparedLights();
             for (size_t i = 0; i < prepared.size(); ++i) {
@@ -676,24 +954,52 @@ void ShadowRenderPass::execute(MTL::CommandBuffer* cmdBuffer,
                 };
 
                 for (int face = 0; face < 6; ++face) {
+                    if (wasShadowViewRestored(ShadowCacheKey{prepared[i].light, static_cast<uint32_t>(face)})) {
+                        continue;
+                    }
                     Math::Vector3 lightPos = prepared[i].positionWS;
                     Math::Matrix4x4 view = Math::Matrix4x4::LookAt(lightPos, lightPos + faceDirs[face], faceUps[face]);
                     Math::Matrix4x4 proj = Math::Matrix4x4::Perspective(Math::HALF_PI, 1.0f, s.depthRange.x, s.depthRange.y);
                     Math::Matrix4x4 vp = proj * view;
                     Math::Vector4 pointLightPosNear(lightPos.x, lightPos.y, lightPos.z, s.depthRange.x);
                     Math::Vector4 pointFarParams(s.depthRange.y, 0.0f, 0.0f, 0.0f);
-                    renderInstancedCubeFace(cmdBuffer, cubeTex, cubeIndex * 6 + face, res, vp, &pointLightPosNear, &pointFarParams, m_pointPipelineInstanced, m_pointPipelineInstancedCutout, instancedDraws);
+                    renderInstancedCubeFace(cmdBuffer, cubeTex, cubeIndex * 6 + face, res, vp, &pointLightPosNear, &pointFarParams, m_pointPipelineInstanced, m_pointPipelineInstancedCutout,
+                                            m_pointPipelineInstancedSkinned, m_pointPipelineInstancedVat, instancedDraws);
                 }
             }
         }
     }
+
+    captureShadowHistory(cmdBuffer);
+    m_profiledPass = GPUPass::ShadowDirectional;
+    buildDepthBounds(cmdBuffer);
+    evictShadowCache();
+}
+
+MTL::RenderCommandEncoder* ShadowRenderPass::beginRenderEncoder(MTL::CommandBuffer* cmdBuffer, MTL::RenderPassDescriptor* rp) {
+    return m_passProfiler ? m_passProfiler->renderEncoder(cmdBuffer, rp, m_profiledPass)
+                          : cmdBuffer->renderCommandEncoder(rp);
+}
+
+MTL::ComputeCommandEncoder* ShadowRenderPass::beginComputeEncoder(MTL::CommandBuffer* cmdBuffer) {
+    return m_passProfiler ? m_passProfiler->computeEncoder(cmdBuffer, m_profiledPass)
+                          : cmdBuffer->computeCommandEncoder();
+}
+
+MTL::BlitCommandEncoder* ShadowRenderPass::beginBlitEncoder(MTL::CommandBuffer* cmdBuffer) {
+    return m_passProfiler ? m_passProfiler->blitEncoder(cmdBuffer, m_profiledPass)
+                          : cmdBuffer->blitCommandEncoder();
 }
 
-void ShadowRenderPass::setExtraHiddenEntities(const std::unordered_set<std::string>& hidden) {
-    m_extraHidden = hidden;
+void ShadowRenderPass::setExtraHiddenEntities(const FrameVector<uint32_t>& hidden, uint32_t entityIndexCount) {
+    m_extraHidden.reset(entityIndexCount);
+    for (uint32_t index : hidden) {
+        m_extraHidden.set(index);
+    }
 }
 
 void ShadowRenderPass::renderDirectional(MTL::CommandBuffer* cmdBuffer, Scene* scene, const LightingSystem& lighting) {
+    CRESCENT_PROFILE_SCOPE("ShadowRenderPass::renderDirectional");
     const auto& cascades = lighting.getCascades();
     if (cascades.empty()) {
         SHADOW_DEBUG_LOG("[SHADOW DEBUG] No cascades!");
@@ -701,7 +1007,26 @@ void ShadowRenderPass::renderDirectional(MTL::CommandBuffer* cmdBuffer, Scene* s
     }
     
     SHADOW_DEBUG_LOG("[SHADOW DEBUG] Rendering " << cascades.size() << " cascades");
-    
+
+    // Unpaged cascades share one layered pass over the atlas, each through its tile's viewport.
+    const bool layered = m_maxAmplification > 1 && m_dirPipelineLayered;
+    CasterPassParams layeredParams;
+    layeredParams.pipeline = m_dirPipelineLayered;
+    layeredParams.pipelineSkinned = m_dirPipelineLayeredSkinned;
+    layeredParams.pipelineCutout = m_dirPipelineLayeredCutout;
+    layeredParams.pipelineSkinnedCutout = m_dirPipelineLayeredSkinnedCutout;
+    auto recordDraws = [this](const Light* owner, uint32_t cascadeIndex, uint32_t draws, uint32_t submissions) {
+        m_viewDrawCounts[ShadowAtlas::MakeKey(owner, cascadeIndex + 1u)] = draws;
+        m_lightDrawCounts[owner] += submissions;
+    };
+    auto flushLayered = [&]() {
+        flushLayeredViews(cmdBuffer, layeredParams, 0, m_atlasLayers);
+        for (const LayeredShadowView& view : m_layeredViews) {
+            recordDraws(view.key.light, cascades[view.key.view].cascadeIndex, view.draws, view.submissions);
+        }
+        m_layeredViews.clear();
+    };
+
     for (size_t i = 0; i < cascades.size(); ++i) {
         const auto& slice = cascades[i];
         if (!slice.atlas.valid) {
@@ -712,106 +1037,50 @@ void ShadowRenderPass::renderDirectional(MTL::CommandBuffer* cmdBuffer, Scene* s
         SHADOW_DEBUG_LOG("[SHADOW DEBUG] Cascade " << i << " atlas: x=" << slice.atlas.x
                          << " y=" << slice.atlas.y << " size=" << slice.atlas.size);
         
-        MTL::RenderPassDescriptor* rp = MTL::RenderPassDescriptor::alloc()->init();
-        rp->depthAttachment()->setTexture(m_shadowAtlas);
-        rp->depthAttachment()->setLevel(0);
-        rp->depthAttachment()->setSlice(slice.atlas.layer);
-        // Atlas already cleared once per frame; keep other tiles intact.
-        rp->depthAttachment()->setLoadAction(MTL::LoadActionLoad);
-        rp->depthAttachment()->setStoreAction(MTL::StoreActionStore);
-        rp->depthAttachment()->setClearDepth(1.0);
-        
-        // Set viewport to atlas rect
-        MTL::RenderCommandEncoder* enc = cmdBuffer->renderCommandEncoder(rp);
-        enc->setDepthStencilState(m_depthState);
-        enc->setFrontFacingWinding(MTL::WindingCounterClockwise);
-        ApplyShadowDepthBias(enc);
-        enc->setViewport({double(slice.atlas.x), double(slice.atlas.y), double(slice.atlas.size), double(slice.atlas.size), 0.0, 1.0});
-        
-        // Iterate meshes
-        int meshCount = 0;
-        MTL::RenderPipelineState* currentPipeline = nullptr;
-        const auto& entities = scene->getAllEntities();
-        for (const auto& entPtr : entities) {
-            Entity* e = entPtr.get();
-            if (!e->isActiveInHierarchy()) continue;
-            if (shouldSkipEntity(e)) continue;
-            MeshRenderer* mr = e->getComponent<MeshRenderer>();
-            if (!mr || !mr->isEnabled()) continue;
-            if (!mr->getCastShadows()) {
-                SHADOW_DEBUG_LOG("[SHADOW DEBUG] Entity '" << e->getName() << "' doesn't cast shadows");
-                continue;
-            }
-            std::shared_ptr<Mesh> mesh = mr->getMesh();
-            if (!mesh) {
-                SHADOW_DEBUG_LOG("[SHADOW DEBUG] Entity '" << e->getName() << "' has no mesh");
-                continue;
-            }
-            if (!mesh->isUploaded()) {
-                SHADOW_DEBUG_LOG("[SHADOW DEBUG] Entity '" << e->getName() << "' mesh not uploaded");
-                continue;
-            }
-            
-            meshCount++;
-
-            SkinnedMeshRenderer* skinned = e->getComponent<SkinnedMeshRenderer>();
-            bool wantsSkin = skinned && skinned->isEnabled() && mesh->hasSkinWeights() && !skinned->getBoneMatrices().empty();
-            MTL::Buffer* skinBuffer = static_cast<MTL::Buffer*>(mesh->getSkinWeightBuffer());
-            bool useSkinned = wantsSkin && skinBuffer && m_dirPipelineSkinned;
-
-            std::shared_ptr<Material> material = mr->getMaterial(0);
-            bool isCutout = IsCutoutMaterial(material);
-            enc->setCullMode(ResolveCullMode(material));
-            MTL::RenderPipelineState* desiredPipeline = useSkinned
-                ? (isCutout && m_dirPipelineSkinnedCutout ? m_dirPipelineSkinnedCutout : m_dirPipelineSkinned)
-                : (isCutout && m_dirPipelineCutout ? m_dirPipelineCutout : m_dirPipeline);
-            if (!desiredPipeline) {
-                continue;
-            }
-            if (desiredPipeline != currentPipeline) {
-                enc->setRenderPipelineState(desiredPipeline);
-                currentPipeline = desiredPipeline;
-            }
-            
-            Math::Matrix4x4 model = e->getTransform()->getWorldMatrix();
-            ShadowObjectUniformsCPU objectUniforms{};
-            objectUniforms.viewProj = slice.viewProj;
-            objectUniforms.modelMatrix = model;
-            ShadowFoliageParamsCPU foliage = BuildShadowFoliageParams(material, m_cameraPosition, m_timeSeconds);
-            enc->setVertexBuffer(static_cast<MTL::Buffer*>(mesh->getVertexBuffer()), 0, 0);
-            if (useSkinned) {
-                enc->setVertexBuffer(skinBuffer, 0, 4);
-                const auto& boneMatrices = skinned->getBoneMatrices();
-                size_t bytes = boneMatrices.size() * sizeof(Math::Matrix4x4);
-                size_t bufferOffset = 0;
-                if (allocateSkinningSlice(bytes, bufferOffset)) {
-                    std::memcpy(static_cast<char*>(m_skinningBuffer->contents()) + bufferOffset,
-                                boneMatrices.data(),
-                                bytes);
-                    enc->setVertexBuffer(m_skinningBuffer, bufferOffset, 2);
-                }
-            }
-            if (isCutout && (desiredPipeline == m_dirPipelineCutout || desiredPipeline == m_dirPipelineSkinnedCutout)) {
-                BindShadowAlpha(enc, material, m_alphaSampler);
+        CasterPassParams params;
+        params.viewProj = slice.viewProj;
+        params.viewportX = double(slice.atlas.x);
+        params.viewportY = double(slice.atlas.y);
+        params.viewportSize = double(slice.atlas.size);
+        params.pipeline = m_dirPipeline;
+        params.pipelineSkinned = m_dirPipelineSkinned;
+        params.pipelineCutout = m_dirPipelineCutout;
+        params.pipelineSkinnedCutout = m_dirPipelineSkinnedCutout;
+
+        ShadowViewTarget target;
+        target.texture = m_shadowAtlas;
+        target.slice = slice.atlas.layer;
+        target.x = slice.atlas.x;
+        target.y = slice.atlas.y;
+        target.size = slice.atlas.size;
+        const ShadowCacheKey cacheKey{slice.owner, static_cast<uint32_t>(i)};
+        if (!beginShadowView(cmdBuffer, cacheKey, target, slice.updateInterval, slice.refresh)) {
+            continue;
+        }
+        const size_t drawsBefore = m_casterDrawCount;
+        const bool paged = slice.pageCount > 0 && renderShadowPages(cmdBuffer, cacheKey, target, params, slice);
+        if (!paged && layered) {
+            if (m_layeredViews.size() == kMaxLayeredViews) {
+                flushLayered();
             }
-            enc->setVertexBytes(&objectUniforms, sizeof(ShadowObjectUniformsCPU), 1);
-            enc->setVertexBytes(&foliage, sizeof(ShadowFoliageParamsCPU), 3);
-            enc->drawIndexedPrimitives(MTL::PrimitiveTypeTriangle,
-                                       mesh->getIndices().size(),
-                                       MTL::IndexTypeUInt32,
-                                       static_cast<MTL::Buffer*>(mesh->getIndexBuffer()),
-                                       0);
+            queueLayeredView(cmdBuffer, cacheKey, target, params);
+            continue;
         }
+        if (!paged) {
+            renderShadowView(cmdBuffer, cacheKey, target, params);
+        }
+        const uint32_t draws = static_cast<uint32_t>(m_casterDrawCount - drawsBefore);
+        recordDraws(slice.owner, slice.cascadeIndex, draws, draws);
         
-        SHADOW_DEBUG_LOG("[SHADOW DEBUG] Cascade " << i << " rendered " << meshCount << " meshes");
-        
-        enc->endEncoding();
-        rp->release();
+        SHADOW_DEBUG_LOG("[SHADOW DEBUG] Cascade " << i << " rendered " << m_casters.size() << " casters");
     }
+    flushLayered();
 }
 
 void ShadowRenderPass::renderLocal(MTL::CommandBuffer* cmdBuffer, Scene* scene, const LightingSystem& lighting) {
+    CRESCENT_PROFILE_SCOPE("ShadowRenderPass::renderLocal");
     const auto& lights = lighting.getGPULights();
+    const auto& prepared = lighting.getPreparedLights();
     const auto& shadows = lighting.getGPUShadows();
     const auto& tiles = lighting.getShadowAtlas().getTiles();
     (void)tiles; // reserved for debugging
@@ -854,7 +1123,10 @@ void ShadowRenderPass::renderLocal(MTL::CommandBuffer* cmdBuffer, Scene* scene,
             case 4: pipelineSkinned = m_areaPipelineSkinned; break;
             default: pipelineSkinned = nullptr; break;
         }
-        renderLightRange(cmdBuffer, scene, s, dummyTile, pipeline, pipelineSkinned,
+        if (i >= prepared.size()) {
+            continue;
+        }
+        renderLightRange(cmdBuffer, scene, prepared[i], s, dummyTile, pipeline, pipelineSkinned,
                          pipeline == m_spotPipeline ? m_spotPipelineCutout : m_areaPipelineCutout,
                          pipeline == m_spotPipeline ? m_spotPipelineSkinnedCutout : m_areaPipelineSkinnedCutout);
     }
@@ -862,6 +1134,7 @@ void ShadowRenderPass::renderLocal(MTL::CommandBuffer* cmdBuffer, Scene* scene,
 
 void ShadowRenderPass::renderLightRange(MTL::CommandBuffer* cmdBuffer,
                                         Scene* scene,
+                                        const PreparedLight& prepared,
                                         const ShadowGPUData& shadow,
                                         const ShadowAtlasTile& tile,
                                         MTL::RenderPipelineState* pipeline,
@@ -875,145 +1148,1021 @@ void ShadowRenderPass::renderLightRange(MTL::CommandBuffer* cmdBuffer,
     
     SHADOW_DEBUG_LOG("[SHADOW DEBUG] renderLightRange: tile x=" << tile.x << " y=" << tile.y << " size=" << tile.size);
     
-    MTL::RenderPassDescriptor* rp = MTL::RenderPassDescriptor::alloc()->init();
-    rp->depthAttachment()->setTexture(m_shadowAtlas);
-    rp->depthAttachment()->setSlice(tile.layer);
-    // Atlas already cleared once per frame; keep other tiles intact.
-    rp->depthAttachment()->setLoadAction(MTL::LoadActionLoad);
-    rp->depthAttachment()->setStoreAction(MTL::StoreActionStore);
-    rp->depthAttachment()->setClearDepth(1.0);
-    
-    MTL::RenderCommandEncoder* enc = cmdBuffer->renderCommandEncoder(rp);
-    enc->setDepthStencilState(m_depthState);
-    enc->setFrontFacingWinding(MTL::WindingCounterClockwise);
-    ApplyShadowDepthBias(enc);
-    enc->setViewport({double(tile.x), double(tile.y), double(tile.size), double(tile.size), 0.0, 1.0});
-    
-        const auto& entities = scene->getAllEntities();
-        MTL::RenderPipelineState* currentPipeline = nullptr;
-        for (const auto& entPtr : entities) {
-            Entity* e = entPtr.get();
-            if (!e->isActiveInHierarchy()) continue;
-            if (shouldSkipEntity(e)) continue;
-            MeshRenderer* mr = e->getComponent<MeshRenderer>();
-            if (!mr || !mr->isEnabled() || !mr->getCastShadows()) continue;
-            std::shared_ptr<Mesh> mesh = mr->getMesh();
-            if (!mesh || !mesh->isUploaded()) continue;
-
-            SkinnedMeshRenderer* skinned = e->getComponent<SkinnedMeshRenderer>();
-            bool wantsSkin = skinned && skinned->isEnabled() && mesh->hasSkinWeights() && !skinned->getBoneMatrices().empty();
-            MTL::Buffer* skinBuffer = static_cast<MTL::Buffer*>(mesh->getSkinWeightBuffer());
-            bool useSkinned = wantsSkin && skinBuffer && pipelineSkinned;
-            std::shared_ptr<Material> material = mr->getMaterial(0);
-            bool isCutout = IsCutoutMaterial(material);
-            enc->setCullMode(ResolveCullMode(material));
-            MTL::RenderPipelineState* desiredPipeline = useSkinned
-                ? (isCutout && pipelineSkinnedCutout ? pipelineSkinnedCutout : pipelineSkinned)
-                : (isCutout && pipelineCutout ? pipelineCutout : pipeline);
-            if (!desiredPipeline) {
-                continue;
-            }
-            if (desiredPipeline != currentPipeline) {
-                enc->setRenderPipelineState(desiredPipeline);
-                currentPipeline = desiredPipeline;
-            }
-        
-        Math::Matrix4x4 model = e->getTransform()->getWorldMatrix();
-        ShadowObjectUniformsCPU objectUniforms{};
-        objectUniforms.viewProj = shadow.viewProj;
-        objectUniforms.modelMatrix = model;
-        ShadowFoliageParamsCPU foliage = BuildShadowFoliageParams(material, m_cameraPosition, m_timeSeconds);
-        enc->setVertexBuffer(static_cast<MTL::Buffer*>(mesh->getVertexBuffer()), 0, 0);
-            if (useSkinned) {
-                enc->setVertexBuffer(skinBuffer, 0, 4);
-                const auto& boneMatrices = skinned->getBoneMatrices();
-                size_t bytes = boneMatrices.size() * sizeof(Math::Matrix4x4);
-                size_t bufferOffset = 0;
-                if (allocateSkinningSlice(bytes, bufferOffset)) {
-                    std::memcpy(static_cast<char*>(m_skinningBuffer->contents()) + bufferOffset,
-                                boneMatrices.data(),
-                                bytes);
-                    enc->setVertexBuffer(m_skinningBuffer, bufferOffset, 2);
-                }
-            }
-            if (isCutout && (desiredPipeline == pipelineCutout || desiredPipeline == pipelineSkinnedCutout)) {
-                BindShadowAlpha(enc, material, m_alphaSampler);
-            }
-            enc->setVertexBytes(&objectUniforms, sizeof(ShadowObjectUniformsCPU), 1);
-            enc->setVertexBytes(&foliage, sizeof(ShadowFoliageParamsCPU), 3);
-            enc->drawIndexedPrimitives(MTL::PrimitiveTypeTriangle,
-                                       mesh->getIndices().size(),
-                                       MTL::IndexTypeUInt32,
-                                       static_cast<MTL::Buffer*>(mesh->getIndexBuffer()),
-                                       0);
+    CasterPassParams params;
+    params.viewProj = shadow.viewProj;
+    params.viewportX = double(tile.x);
+    params.viewportY = double(tile.y);
+    params.viewportSize = double(tile.size);
+    params.pipeline = pipeline;
+    params.pipelineSkinned = pipelineSkinned;
+    params.pipelineCutout = pipelineCutout;
+    params.pipelineSkinnedCutout = pipelineSkinnedCutout;
+
+    ShadowViewTarget target;
+    target.texture = m_shadowAtlas;
+    target.slice = tile.layer;
+    target.x = tile.x;
+    target.y = tile.y;
+    target.size = tile.size;
+    const ShadowCacheKey cacheKey{prepared.light, 0};
+    if (!beginShadowView(cmdBuffer, cacheKey, target, prepared.shadowUpdateInterval, prepared.shadowRefresh)) {
+        return;
     }
-    
-    enc->endEncoding();
-    rp->release();
+    const size_t drawsBefore = m_casterDrawCount;
+    renderShadowView(cmdBuffer, cacheKey, target, params);
+    m_viewDrawCounts[ShadowAtlas::MakeKey(prepared.light, 0)] = static_cast<uint32_t>(m_casterDrawCount - drawsBefore);
+    m_lightDrawCounts[prepared.light] += static_cast<uint32_t>(m_casterDrawCount - drawsBefore);
 }
 
-bool ShadowRenderPass::shouldSkipEntity(Entity* entity) const {
-    if (!entity) {
-        return true;
-    }
-    std::string id = entity->getUUID().toString();
-    if (m_extraHidden.find(id) != m_extraHidden.end()) {
-        return true;
+bool ShadowRenderPass::shouldSkipEntity(const MeshRenderProxy& proxy) const {
+    if (!m_extraHidden.any() && !m_hlodSwitch->anyHidden() && !proxy.hlod) {
+        return false;
     }
-    if (m_hlodHidden.find(id) != m_hlodHidden.end()) {
+    const uint32_t index = proxy.entity->getIndex();
+    if (m_extraHidden.test(index) || m_hlodSwitch->isHidden(index)) {
         return true;
     }
-    if (entity->getComponent<HLODProxy>()) {
-        return m_hlodActiveProxies.find(id) == m_hlodActiveProxies.end();
+    if (proxy.hlod) {
+        return !m_hlodSwitch->isProxyActive(index);
     }
     return false;
 }
 
-void ShadowRenderPass::renderInstancedRange(MTL::CommandBuffer* cmdBuffer,
-                                            const ShadowGPUData& shadow,
-                                            const ShadowAtlasTile& tile,
-                                            MTL::RenderPipelineState* pipeline,
-                                            MTL::RenderPipelineState* pipelineCutout,
-                                            const std::vector<InstancedShadowDraw>& instancedDraws) {
-    if (!tile.valid || !pipeline || instancedDraws.empty()) {
-        return;
-    }
+void ShadowRenderPass::gatherCasters(Scene* scene) {
+    CRESCENT_PROFILE_SCOPE("ShadowRenderPass::gatherCasters");
+    m_casters.clear();
+    m_casterSpheres.clear();
+    m_casterSkinningBuffer = nullptr;
+    m_casterSkinningBase = 0;
 
-    auto buildFoliageParams = [&](const InstancedShadowDraw& draw) {
-        ShadowFoliageParamsCPU params{};
-        if (draw.material) {
-            Math::Vector3 windDir = draw.material->getWindDirection();
-            params.foliageParams0 = Math::Vector4(
-                draw.material->getWindStrength(),
-                draw.material->getWindSpeed(),
-                draw.material->getWindScale(),
-                draw.material->getWindGust()
-            );
-            params.foliageParams1 = Math::Vector4(
-                draw.material->getLodFadeStart(),
-                draw.material->getLodFadeEnd(),
-                draw.material->getBillboardStart(),
-                draw.material->getBillboardEnd()
-            );
-            params.foliageParams2 = Math::Vector4(
-                draw.material->getWindEnabled() ? 1.0f : 0.0f,
-                draw.material->getLodFadeEnabled() ? 1.0f : 0.0f,
-                draw.material->getBillboardEnabled() ? 1.0f : 0.0f,
-                draw.material->getDitherEnabled() ? 1.0f : 0.0f
-            );
-            params.foliageParams3 = Math::Vector4(windDir.x, windDir.y, windDir.z, 0.0f);
+    constexpr size_t kAlignment = 256;
+    size_t skinningBytes = 0;
+    const auto& meshProxies = scene->getRenderWorld().getMeshRenderers();
+    m_casters.reserve(meshProxies.size());
+    for (const auto& proxy : meshProxies) {
+        Entity* e = proxy.entity;
+        if (!e->isActiveInHierarchy()) continue;
+        if (shouldSkipEntity(proxy)) continue;
+        MeshRenderer* mr = proxy.meshRenderer;
+        if (!mr->isEnabled() || !mr->getCastShadows()) continue;
+        std::shared_ptr<Mesh> mesh = mr->getMesh();
+        if (!mesh || !mesh->isUploaded()) continue;
+
+        ShadowCaster caster;
+        caster.mesh = mesh.get();
+        caster.material = mr->getMaterial(0);
+        caster.modelMatrix = e->getTransform()->getWorldMatrix();
+        // Shadow maps are lower resolution than the view and hide silhouette changes well.
+        caster.lod = std::min(mesh->selectLod(caster.modelMatrix, m_lodView, m_lodPixelError) + 1,
+                              mesh->getLodCount() - 1);
+        SkinnedMeshRenderer* skinned = proxy.skinned;
+        bool wantsSkin = skinned && skinned->isEnabled() && mesh->hasSkinWeights() && !skinned->getBoneMatrices().empty();
+        MTL::Buffer* skinBuffer = static_cast<MTL::Buffer*>(mesh->getSkinWeightBuffer());
+        if (wantsSkin && skinBuffer && m_skinningCache) {
+            caster.skinCache = m_skinningCache->find(mr);
+        }
+        if (wantsSkin && skinBuffer && !caster.skinCache) {
+            caster.skinWeightBuffer = skinBuffer;
+            caster.boneMatrices = &skinned->getBoneMatrices();
+            caster.skinningOffset = skinningBytes;
+            size_t bytes = caster.boneMatrices->size() * sizeof(Math::Matrix4x4);
+            skinningBytes += (bytes + (kAlignment - 1)) & ~(kAlignment - 1);
+        }
+
+        Math::Vector3 worldMin;
+        Math::Vector3 worldMax;
+        if (wantsSkin) {
+            skinned->getWorldBounds(worldMin, worldMax);
         } else {
-            params.foliageParams0 = Math::Vector4(0.0f);
-            params.foliageParams1 = Math::Vector4(0.0f);
-            params.foliageParams2 = Math::Vector4(0.0f);
-            params.foliageParams3 = Math::Vector4(0.0f);
+            caster.modelMatrix.transformAABB(mesh->getBoundsMin(), mesh->getBoundsMax(), worldMin, worldMax);
         }
-        params.cameraTime = Math::Vector4(m_cameraPosition.x, m_cameraPosition.y, m_cameraPosition.z, m_timeSeconds);
-        params.boundsCenter = Math::Vector4(draw.boundsCenter.x, draw.boundsCenter.y, draw.boundsCenter.z, 0.0f);
-        params.boundsSize = Math::Vector4(draw.boundsSize.x, draw.boundsSize.y, draw.boundsSize.z, 0.0f);
-        params.flags = Math::Vector4(draw.isBillboard ? 1.0f : 0.0f, 0.0f, 0.0f, 0.0f);
-        return params;
-    };
+        Math::Vector3 center = (worldMin + worldMax) * 0.5f;
+        m_casterSpheres.push_back(Math::Vector4(center.x, center.y, center.z, (worldMax - worldMin).length() * 0.5f));
+
+        // A caster turns static once its transform has held for a few frames; skinned and
+        // animated-material casters never do.
+        const uint64_t id = static_cast<uint64_t>(e->getUUID());
+        CasterHistory& history = m_casterHistory[id];
+        if (history.lastSeenFrame == 0 ||
+            std::memcmp(&history.modelMatrix, &caster.modelMatrix, sizeof(Math::Matrix4x4)) != 0) {
+            history.modelMatrix = caster.modelMatrix;
+            history.stillFrames = 0;
+        } else if (history.stillFrames < kStaticSettleFrames) {
+            ++history.stillFrames;
+        }
+        history.lastSeenFrame = m_frameIndex;
+        caster.isStatic = !wantsSkin && history.stillFrames >= kStaticSettleFrames &&
+                          !IsAnimatedShadowMaterial(caster.material);
+        if (caster.isStatic) {
+            caster.contentHash = HashShadowCaster(id, caster.mesh, caster.lod, caster.material, caster.modelMatrix);
+        }
+        m_casters.push_back(std::move(caster));
+    }
+    m_casterVisible.resize(m_casters.size());
+    m_casterLayeredMasks.assign(m_casters.size(), 0);
+
+    // Bones are uploaded once here and shared by every cascade, light and cube face below.
+    if (skinningBytes > 0 && allocateSkinningSlice(skinningBytes, m_casterSkinningBase)) {
+        m_casterSkinningBuffer = m_skinningBuffer;
+        m_casterSkinningBytes = skinningBytes;
+        char* base = static_cast<char*>(m_casterSkinningBuffer->contents()) + m_casterSkinningBase;
+        for (const ShadowCaster& caster : m_casters) {
+            if (caster.boneMatrices) {
+                std::memcpy(base + caster.skinningOffset,
+                            caster.boneMatrices->data(),
+                            caster.boneMatrices->size() * sizeof(Math::Matrix4x4));
+            }
+        }
+    }
+}
+
+void ShadowRenderPass::renderCasters(MTL::CommandBuffer* cmdBuffer,
+                                     MTL::RenderPassDescriptor* rp,
+                                     const CasterPassParams& params,
+                                     const std::vector<uint32_t>& casterIndices) {
+    // Layered passes give every view its own viewport and array slice.
+    ShadowLayeredViewsCPU layeredViews{};
+    std::array<MTL::Viewport, kMaxLayeredViews> viewports{};
+    const size_t viewCount = params.casterViewMasks ? std::min<size_t>(m_layeredViews.size(), kMaxLayeredViews) : 0;
+    for (size_t v = 0; v < viewCount; ++v) {
+        const LayeredShadowView& view = m_layeredViews[v];
+        layeredViews.viewProj[v] = view.viewProj;
+        layeredViews.layer[v] = view.target.slice - params.baseSlice;
+        viewports[v] = {double(view.target.x), double(view.target.y), double(view.target.size), double(view.target.size), 0.0, 1.0};
+    }
+    layeredViews.pointLightPosNear = params.pointLightPosNear;
+    layeredViews.pointFarParams = params.pointFarParams;
+
+    auto setup = [this, &params, &layeredViews, &viewports, viewCount](MTL::RenderCommandEncoder* enc) {
+        enc->setDepthStencilState(m_depthState);
+        enc->setFrontFacingWinding(MTL::WindingCounterClockwise);
+        ApplyShadowDepthBias(enc);
+        if (viewCount > 0) {
+            enc->setViewports(viewports.data(), viewCount);
+            enc->setVertexBytes(&layeredViews, sizeof(ShadowLayeredViewsCPU), 5);
+            return;
+        }
+        enc->setViewport({params.viewportX, params.viewportY, params.viewportSize, params.viewportSize, 0.0, 1.0});
+    };
+    if (m_passProfiler) {
+        m_passProfiler->attach(rp, m_profiledPass);
+    }
+    ParallelPassEncoder pass(cmdBuffer, rp, casterIndices.size(), setup);
+    if (m_passProfiler) {
+        m_passProfiler->detach(rp);
+    }
+    const GPUPass profiledPass = m_profiledPass;
+    pass.encodeRange(casterIndices.size(), [this, &params, &casterIndices, profiledPass](MTL::RenderCommandEncoder* enc, size_t begin, size_t end) {
+        GPUPassWork work;
+        encodeCasters(enc, params, casterIndices, begin, end, work);
+        recordCasterWork(profiledPass, work);
+    });
+    m_parallelEncoderCount += pass.parallelEncoderCount();
+    pass.end();
+}
+
+void ShadowRenderPass::encodeCasters(MTL::RenderCommandEncoder* enc,
+                                     const CasterPassParams& params,
+                                     const std::vector<uint32_t>& casterIndices,
+                                     size_t begin,
+                                     size_t end,
+                                     GPUPassWork& work) const {
+    MTL::RenderPipelineState* currentPipeline = nullptr;
+    UniformRing::Binder uniforms(m_uniformRing);
+    for (size_t i = begin; i < end; ++i) {
+        const uint32_t viewMask = params.casterViewMasks ? (*params.casterViewMasks)[i] : 0u;
+        encodeCaster(enc, params, m_casters[casterIndices[i]], viewMask, currentPipeline, uniforms, work);
+    }
+}
+
+void ShadowRenderPass::recordCasterWork(GPUPass pass, const GPUPassWork& work) const {
+    if (m_passProfiler) {
+        m_passProfiler->recordWork(pass, work);
+    }
+}
+
+void ShadowRenderPass::encodeCaster(MTL::RenderCommandEncoder* enc,
+                                    const CasterPassParams& params,
+                                    const ShadowCaster& caster,
+                                    uint32_t viewMask,
+                                    MTL::RenderPipelineState*& currentPipeline,
+                                    UniformRing::Binder& uniforms,
+                                    GPUPassWork& work) const {
+    bool useSkinned = caster.boneMatrices && params.pipelineSkinned;
+    bool isCutout = IsCutoutMaterial(caster.material);
+    enc->setCullMode(ResolveCullMode(caster.material));
+    MTL::RenderPipelineState* desiredPipeline = useSkinned
+        ? (isCutout && params.pipelineSkinnedCutout ? params.pipelineSkinnedCutout : params.pipelineSkinned)
+        : (isCutout && params.pipelineCutout ? params.pipelineCutout : params.pipeline);
+    if (!desiredPipeline) {
+        return;
+    }
+    if (desiredPipeline != currentPipeline) {
+        enc->setRenderPipelineState(desiredPipeline);
+        currentPipeline = desiredPipeline;
+        ++work.pipelineBinds;
+    }
+
+    ShadowObjectUniformsCPU objectUniforms{};
+    objectUniforms.viewProj = params.viewProj;
+    objectUniforms.modelMatrix = caster.modelMatrix;
+    objectUniforms.pointLightPosNear = params.pointLightPosNear;
+    objectUniforms.pointFarParams = params.pointFarParams;
+    ShadowFoliageParamsCPU foliage = BuildShadowFoliageParams(caster.material, m_cameraPosition, m_timeSeconds);
+    if (caster.skinCache) {
+        SkinningCache::BindVertexStreams(enc, *caster.skinCache);
+    } else {
+        enc->setVertexBuffer(static_cast<MTL::Buffer*>(caster.mesh->getVertexBuffer()), caster.mesh->getVertexBufferOffset(), 0);
+        enc->setVertexBuffer(static_cast<MTL::Buffer*>(caster.mesh->getAttributeBuffer()), caster.mesh->getAttributeBufferOffset(),
+                             GeometryBuffer::kAttributeBufferIndex);
+    }
+    work.bufferBinds += 2;
+    if (useSkinned) {
+        enc->setVertexBuffer(caster.skinWeightBuffer, caster.mesh->getSkinWeightBufferOffset(), 4);
+        ++work.bufferBinds;
+        if (m_casterSkinningBuffer) {
+            enc->setVertexBuffer(m_casterSkinningBuffer, m_casterSkinningBase + caster.skinningOffset, 2);
+            ++work.bufferBinds;
+        }
+    }
+    if (isCutout && (desiredPipeline == params.pipelineCutout || desiredPipeline == params.pipelineSkinnedCutout)) {
+        BindShadowAlpha(enc, caster.material, m_alphaSampler);
+        ++work.bufferBinds;
+        work.textureBinds += 2;
+        work.inlineBytes += sizeof(ShadowAlphaParamsCPU);
+    }
+    auto setCasterBytes = [&](const void* bytes, size_t length, uint32_t index) {
+        ++work.bufferBinds;
+        if (uniforms.setVertexBytes(enc, bytes, length, index)) {
+            work.ringBytes += length;
+            return;
+        }
+        enc->setVertexBytes(bytes, length, index);
+        uniforms.forgetVertex(index);
+        work.inlineBytes += length;
+    };
+    setCasterBytes(&objectUniforms, sizeof(ShadowObjectUniformsCPU), 1);
+    setCasterBytes(&foliage, sizeof(ShadowFoliageParamsCPU), 3);
+    auto draw = [&]() {
+        ++work.draws;
+        enc->drawIndexedPrimitives(MTL::PrimitiveTypeTriangle,
+                                   caster.mesh->getLodIndexCount(caster.lod),
+                                   MTL::IndexTypeUInt32,
+                                   static_cast<MTL::Buffer*>(caster.mesh->getIndexBuffer()),
+                                   caster.mesh->getLodIndexBufferOffset(caster.lod));
+    };
+    if (viewMask == 0) {
+        draw();
+        return;
+    }
+
+    // One amplified draw per m_maxAmplification of the views the caster overlaps.
+    ShadowLayeredSelectionCPU selection{};
+    uint32_t count = 0;
+    for (uint32_t view = 0; view < kMaxLayeredViews; ++view) {
+        if ((viewMask & (1u << view)) == 0) {
+            continue;
+        }
+        selection.view[count++] = view;
+        if (count == m_maxAmplification || (viewMask >> (view + 1)) == 0) {
+            setCasterBytes(&selection, sizeof(ShadowLayeredSelectionCPU), 6);
+            enc->setVertexAmplificationCount(count, nullptr);
+            draw();
+            count = 0;
+        }
+    }
+}
+
+void ShadowRenderPass::renderCasterList(MTL::CommandBuffer* cmdBuffer,
+                                        const ShadowViewTarget& target,
+                                        bool clear,
+                                        const CasterPassParams& params,
+                                        const std::vector<uint32_t>& casterIndices) {
+    MTL::RenderPassDescriptor* rp = MTL::RenderPassDescriptor::alloc()->init();
+    rp->depthAttachment()->setTexture(target.texture);
+    rp->depthAttachment()->setSlice(target.slice);
+    rp->depthAttachment()->setLoadAction(clear ? MTL::LoadActionClear : MTL::LoadActionLoad);
+    rp->depthAttachment()->setStoreAction(MTL::StoreActionStore);
+    rp->depthAttachment()->setClearDepth(1.0);
+    renderCasters(cmdBuffer, rp, params, casterIndices);
+    rp->release();
+    m_casterDrawCount += casterIndices.size();
+}
+
+void ShadowRenderPass::renderShadowView(MTL::CommandBuffer* cmdBuffer,
+                                        const ShadowCacheKey& cacheKey,
+                                        const ShadowViewTarget& target,
+                                        const CasterPassParams& params) {
+    if (!target.texture || target.size == 0) {
+        return;
+    }
+    if (!resolveShadowViewCache(cmdBuffer, cacheKey, target, params)) {
+        renderCasterList(cmdBuffer, target, target.clear, params, m_viewDynamicCasters);
+    } else if (!m_viewDynamicCasters.empty()) {
+        renderCasterList(cmdBuffer, target, false, params, m_viewDynamicCasters);
+    }
+}
+
+bool ShadowRenderPass::resolveShadowViewCache(MTL::CommandBuffer* cmdBuffer,
+                                              const ShadowCacheKey& cacheKey,
+                                              const ShadowViewTarget& target,
+                                              const CasterPassParams& params) {
+    classifyViewCasters(cacheKey, params);
+    uint64_t viewHash = HashShadowValue(kShadowHashSeed, params.viewProj);
+    viewHash = HashShadowValue(viewHash, params.pointLightPosNear);
+    viewHash = HashShadowValue(viewHash, params.pointFarParams);
+    viewHash = HashShadowValue(viewHash, params.pipeline);
+    viewHash = HashShadowValue(viewHash, target.size);
+    for (uint32_t casterIndex : m_viewStaticCasters) {
+        viewHash = HashShadowValue(viewHash, m_casters[casterIndex].contentHash);
+    }
+
+    ShadowCacheEntry* entry = nullptr;
+    if (cacheKey.light && !m_viewStaticCasters.empty()) {
+        entry = &m_shadowCache[cacheKey];
+        entry->lastUsedFrame = m_frameIndex;
+        // Views whose static content changes every frame (e.g. cascades following the camera)
+        // would only pay for an extra copy; cache once the content held for one frame.
+        if (entry->contentHash != viewHash) {
+            entry->contentHash = viewHash;
+            entry->valid = false;
+            entry = nullptr;
+        }
+    }
+    MTL::Texture* cacheTexture = nullptr;
+    if (entry) {
+        MTL::Texture* previous = entry->texture;
+        cacheTexture = acquireCacheTexture(entry->texture, target.size);
+        entry->valid = entry->valid && cacheTexture == previous;
+    }
+    if (!cacheTexture) {
+        m_viewStaticCasters.insert(m_viewStaticCasters.end(), m_viewDynamicCasters.begin(), m_viewDynamicCasters.end());
+        m_viewDynamicCasters.swap(m_viewStaticCasters);
+        return false;
+    }
+
+    if (!entry->valid) {
+        ShadowViewTarget cacheTarget;
+        cacheTarget.texture = cacheTexture;
+        cacheTarget.size = target.size;
+        CasterPassParams cacheParams = params;
+        cacheParams.viewportX = 0.0;
+        cacheParams.viewportY = 0.0;
+        renderCasterList(cmdBuffer, cacheTarget, true, cacheParams, m_viewStaticCasters);
+        entry->valid = true;
+        ++m_refreshedViewCount;
+    } else {
+        ++m_cachedViewCount;
+    }
+
+    // The copy overwrites the whole tile, so the target needs no clear of its own.
+    MTL::BlitCommandEncoder* blit = beginBlitEncoder(cmdBuffer);
+    blit->copyFromTexture(cacheTexture, 0, 0, MTL::Origin(0, 0, 0), MTL::Size(target.size, target.size, 1),
+                          target.texture, target.slice, 0, MTL::Origin(target.x, target.y, 0));
+    blit->endEncoding();
+    return true;
+}
+
+void ShadowRenderPass::queueLayeredView(MTL::CommandBuffer* cmdBuffer,
+                                        const ShadowCacheKey& cacheKey,
+                                        const ShadowViewTarget& target,
+                                        const CasterPassParams& params) {
+    if (!target.texture || target.size == 0 || m_layeredViews.size() >= kMaxLayeredViews) {
+        return;
+    }
+    const size_t drawsBefore = m_casterDrawCount;
+    LayeredShadowView view;
+    view.key = cacheKey;
+    view.target = target;
+    view.viewProj = params.viewProj;
+    view.filled = resolveShadowViewCache(cmdBuffer, cacheKey, target, params);
+    view.draws = static_cast<uint32_t>(m_casterDrawCount - drawsBefore);
+    view.submissions = view.draws;
+
+    const uint8_t bit = static_cast<uint8_t>(1u << m_layeredViews.size());
+    for (uint32_t casterIndex : m_viewDynamicCasters) {
+        uint8_t& mask = m_casterLayeredMasks[casterIndex];
+        if (mask == 0) {
+            m_layeredCasters.push_back(casterIndex);
+        }
+        mask |= bit;
+    }
+    m_layeredViews.push_back(view);
+}
+
+void ShadowRenderPass::flushLayeredViews(MTL::CommandBuffer* cmdBuffer,
+                                         const CasterPassParams& params,
+                                         uint32_t baseSlice,
+                                         uint32_t sliceCount) {
+    if (m_layeredViews.empty()) {
+        return;
+    }
+    // Caster order as the per-view lists have it, so pipeline changes stay as rare.
+    std::sort(m_layeredCasters.begin(), m_layeredCasters.end());
+    m_layeredCasterMasks.clear();
+    size_t submissions = 0;
+    for (uint32_t casterIndex : m_layeredCasters) {
+        const uint8_t mask = m_casterLayeredMasks[casterIndex];
+        m_casterLayeredMasks[casterIndex] = 0;
+        m_layeredCasterMasks.push_back(mask);
+        submissions += (CountViewBits(mask) + m_maxAmplification - 1) / m_maxAmplification;
+        uint32_t chunk = 0;
+        for (uint32_t v = 0; v < m_layeredViews.size(); ++v) {
+            if (mask & (1u << v)) {
+                ++m_layeredViews[v].draws;
+                if (chunk++ % m_maxAmplification == 0) {
+                    ++m_layeredViews[v].submissions;
+                }
+            }
+        }
+    }
+
+    // One clear covers the slices when every one of them is a view drawn from scratch; otherwise
+    // the views without cached content are cleared on their own and the pass loads.
+    bool clearAll = m_layeredViews.size() == sliceCount;
+    for (const LayeredShadowView& view : m_layeredViews) {
+        clearAll = clearAll && view.target.clear && !view.filled;
+    }
+    if (!clearAll) {
+        for (const LayeredShadowView& view : m_layeredViews) {
+            if (view.target.clear && !view.filled) {
+                renderCasterList(cmdBuffer, view.target, true, params, {});
+            }
+        }
+    }
+
+    MTL::Texture* texture = m_layeredViews.front().target.texture;
+    MTL::RenderPassDescriptor* rp = MTL::RenderPassDescriptor::alloc()->init();
+    rp->depthAttachment()->setTexture(texture);
+    rp->depthAttachment()->setSlice(baseSlice);
+    rp->depthAttachment()->setLoadAction(clearAll ? MTL::LoadActionClear : MTL::LoadActionLoad);
+    rp->depthAttachment()->setStoreAction(MTL::StoreActionStore);
+    rp->depthAttachment()->setClearDepth(1.0);
+    if (texture->textureType() == MTL::TextureType2DArray) {
+        rp->setRenderTargetArrayLength(sliceCount);
+    }
+    CasterPassParams layeredParams = params;
+    layeredParams.casterViewMasks = &m_layeredCasterMasks;
+    layeredParams.baseSlice = baseSlice;
+    renderCasters(cmdBuffer, rp, layeredParams, m_layeredCasters);
+    rp->release();
+    m_casterDrawCount += submissions;
+    m_layeredCasters.clear();
+}
+
+void ShadowRenderPass::addCullView(const ShadowCacheKey& key, const Math::Matrix4x4& viewProj) {
+    if (!key.light || !m_cullViewIndex.emplace(key, static_cast<uint32_t>(m_cullViews.size())).second) {
+        return;
+    }
+    m_cullViews.push_back(ShadowCullView{key, viewProj, Math::ExtractFrustumPlanes(viewProj)});
+}
+
+void ShadowRenderPass::cullShadowViews(const LightingSystem& lighting) {
+    CRESCENT_PROFILE_SCOPE("ShadowRenderPass::cullShadowViews");
+    m_cullViews.clear();
+    m_cullViewIndex.clear();
+
+    // Mirrors the views renderDirectional/renderLocal/renderPointCubes draw this frame. Views
+    // restored from history skip the cull; if one renders anyway it falls back to its own test.
+    const auto& cascades = lighting.getCascades();
+    for (size_t i = 0; i < cascades.size(); ++i) {
+        const auto& slice = cascades[i];
+        if (slice.atlas.valid && slice.refresh) {
+            addCullView(ShadowCacheKey{slice.owner, static_cast<uint32_t>(i)}, slice.viewProj);
+        }
+    }
+    const auto& lights = lighting.getGPULights();
+    const auto& prepared = lighting.getPreparedLights();
+    const auto& shadows = lighting.getGPUShadows();
+    for (size_t i = 0; i < lights.size() && i < prepared.size(); ++i) {
+        const int shadowIdx = static_cast<int>(lights[i].shadowCookie.x);
+        if (shadowIdx < 0 || shadowIdx >= static_cast<int>(shadows.size()) || !prepared[i].shadowRefresh) {
+            continue;
+        }
+        const ShadowGPUData& s = shadows[shadowIdx];
+        const int type = static_cast<int>(lights[i].directionType.w);
+        if (type == 2 || type == 3 || type == 4) {
+            addCullView(ShadowCacheKey{prepared[i].light, 0}, s.viewProj);
+        } else if (type == 1 && prepared[i].light && prepared[i].light->getType() == Light::Type::Point) {
+            static const Math::Vector3 faceDirs[6] = {
+                Math::Vector3(1,0,0), Math::Vector3(-1,0,0),
+                Math::Vector3(0,1,0), Math::Vector3(0,-1,0),
+                Math::Vector3(0,0,1), Math::Vector3(0,0,-1)
+            };
+            static const Math::Vector3 faceUps[6] = {
+                Math::Vector3(0,-1,0), Math::Vector3(0,-1,0),
+                Math::Vector3(0,0,1), Math::Vector3(0,0,-1),
+                Math::Vector3(0,-1,0), Math::Vector3(0,-1,0)
+            };
+            const Math::Vector3 lightPos = prepared[i].positionWS;
+            const Math::Matrix4x4 proj = Math::Matrix4x4::Perspective(Math::HALF_PI, 1.0f, s.depthRange.x, s.depthRange.y);
+            for (uint32_t face = 0; face < 6; ++face) {
+                const Math::Matrix4x4 view = Math::Matrix4x4::LookAt(lightPos, lightPos + faceDirs[face], faceUps[face]);
+                addCullView(ShadowCacheKey{prepared[i].light, face}, proj * view);
+            }
+        }
+    }
+
+    const size_t casterCount = m_casters.size();
+    const size_t viewCount = m_cullViews.size();
+    m_cullMaskWords = (viewCount + 63) / 64;
+    m_casterViewMasks.assign(casterCount * m_cullMaskWords, 0);
+    if (m_cullViewCasters.size() < viewCount) {
+        m_cullViewCasters.resize(viewCount);
+    }
+    if (casterCount == 0 || viewCount == 0) {
+        for (size_t v = 0; v < viewCount; ++v) {
+            m_cullViewCasters[v].clear();
+        }
+        return;
+    }
+
+    // Every caster against every view, one bit per caster per view. Chunks own disjoint caster
+    // ranges, so the visibility scratch and the masks need no synchronisation.
+    constexpr size_t kMinCastersPerChunk = 256;
+    ParallelShadowRanges(casterCount, kMinCastersPerChunk, [this, viewCount](size_t begin, size_t end) {
+        uint8_t* visible = m_casterVisible.data() + begin;
+        const size_t count = end - begin;
+        for (size_t v = 0; v < viewCount; ++v) {
+            Math::SpheresInFrustumMany(m_cullViews[v].planes, m_casterSpheres.data() + begin, count, visible);
+            const size_t word = v >> 6;
+            const uint64_t bit = 1ull << (v & 63);
+            for (size_t i = 0; i < count; ++i) {
+                if (visible[i]) {
+                    m_casterViewMasks[(begin + i) * m_cullMaskWords + word] |= bit;
+                }
+            }
+        }
+    });
+
+    // Compact the bit columns into per-view caster lists, one view per task.
+    ParallelShadowRanges(viewCount, 1, [this, casterCount](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            std::vector<uint32_t>& list = m_cullViewCasters[v];
+            list.clear();
+            const size_t word = v >> 6;
+            const uint64_t bit = 1ull << (v & 63);
+            for (size_t i = 0; i < casterCount; ++i) {
+                if (m_casterViewMasks[i * m_cullMaskWords + word] & bit) {
+                    list.push_back(static_cast<uint32_t>(i));
+                }
+            }
+        }
+    });
+}
+
+void ShadowRenderPass::classifyViewCasters(const ShadowCacheKey& key, const CasterPassParams& params) {
+    m_viewStaticCasters.clear();
+    m_viewDynamicCasters.clear();
+    auto pushCaster = [this](uint32_t casterIndex) {
+        if (m_casters[casterIndex].isStatic) {
+            m_viewStaticCasters.push_back(casterIndex);
+        } else {
+            m_viewDynamicCasters.push_back(casterIndex);
+        }
+    };
+
+    auto it = m_cullViewIndex.find(key);
+    if (it != m_cullViewIndex.end() &&
+        std::memcmp(&m_cullViews[it->second].viewProj, &params.viewProj, sizeof(Math::Matrix4x4)) == 0) {
+        for (uint32_t casterIndex : m_cullViewCasters[it->second]) {
+            pushCaster(casterIndex);
+        }
+        return;
+    }
+
+    // Casters outside the view frustum never touch this view's depth.
+    const Math::FrustumPlanes planes = Math::ExtractFrustumPlanes(params.viewProj);
+    Math::SpheresInFrustumMany(planes, m_casterSpheres.data(), m_casterSpheres.size(), m_casterVisible.data());
+    for (size_t i = 0; i < m_casters.size(); ++i) {
+        if (m_casterVisible[i]) {
+            pushCaster(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+bool ShadowRenderPass::renderShadowPages(MTL::CommandBuffer* cmdBuffer,
+                                         const ShadowCacheKey& cacheKey,
+                                         const ShadowViewTarget& target,
+                                         const CasterPassParams& params,
+                                         const CascadedSlice& slice) {
+    const uint32_t pageCount = slice.pageCount;
+    if (!cacheKey.light || !target.texture || pageCount == 0 ||
+        target.size != slice.resolution || target.size % pageCount != 0) {
+        return false;
+    }
+    ShadowPageCache& cache = m_shadowPageCaches[cacheKey];
+    cache.lastUsedFrame = m_frameIndex;
+    MTL::Texture* previous = cache.texture;
+    if (!acquireCacheTexture(cache.texture, target.size)) {
+        return false;
+    }
+    const uint32_t pageSize = target.size / pageCount;
+    if (!ensureClearPage(cmdBuffer, pageSize)) {
+        return false;
+    }
+
+    // Anything that moves every page at once restarts the cache: light direction, extent,
+    // depth snap, resolution or pipeline.
+    uint64_t frameHash = HashShadowValue(kShadowHashSeed, slice.proj);
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            frameHash = HashShadowValue(frameHash, slice.view(row, col));
+        }
+    }
+    frameHash = HashShadowValue(frameHash, slice.pageDepthOrigin);
+    frameHash = HashShadowValue(frameHash, target.size);
+    frameHash = HashShadowValue(frameHash, params.pipeline);
+    const size_t slotCount = size_t(pageCount) * size_t(pageCount);
+    if (cache.frameHash != frameHash || cache.texture != previous || cache.slots.size() != slotCount) {
+        cache.frameHash = frameHash;
+        cache.slots.assign(slotCount, ShadowPageSlot{});
+    }
+
+    classifyViewCasters(cacheKey, params);
+
+    // Tile-local page footprint of every static caster, folded into the hash of each page it covers.
+    const int32_t lastPage = static_cast<int32_t>(pageCount) - 1;
+    const float halfPages = static_cast<float>(pageCount) * 0.5f;
+    const float pageWorldSize = slice.texelWorldSize * static_cast<float>(pageSize);
+    auto toPage = [&](float lightSpace) {
+        int32_t page = static_cast<int32_t>(std::floor(lightSpace / pageWorldSize + halfPages));
+        return std::max(0, std::min(lastPage, page));
+    };
+    m_pageHashes.assign(slotCount, frameHash);
+    m_viewCasterPages.resize(m_viewStaticCasters.size());
+    for (size_t i = 0; i < m_viewStaticCasters.size(); ++i) {
+        const uint32_t casterIndex = m_viewStaticCasters[i];
+        const Math::Vector4& sphere = m_casterSpheres[casterIndex];
+        const Math::Vector3 centerLS = slice.view.transformPoint(Math::Vector3(sphere.x, sphere.y, sphere.z));
+        // Texture rows run along light-space -y.
+        std::array<int32_t, 4>& rect = m_viewCasterPages[i];
+        rect = {toPage(centerLS.x - sphere.w), toPage(-centerLS.y - sphere.w),
+                toPage(centerLS.x + sphere.w), toPage(-centerLS.y + sphere.w)};
+        for (int32_t y = rect[1]; y <= rect[3]; ++y) {
+            for (int32_t x = rect[0]; x <= rect[2]; ++x) {
+                uint64_t& hash = m_pageHashes[size_t(y) * pageCount + size_t(x)];
+                hash = HashShadowValue(hash, m_casters[casterIndex].contentHash);
+            }
+        }
+    }
+
+    auto wrapPage = [pageCount](int32_t page) {
+        int32_t wrapped = page % static_cast<int32_t>(pageCount);
+        return static_cast<uint32_t>(wrapped < 0 ? wrapped + static_cast<int32_t>(pageCount) : wrapped);
+    };
+
+    // A slot is reusable when it still holds this absolute page with the same static content.
+    m_pageDirty.assign(slotCount, 0);
+    size_t dirtyCount = 0;
+    MTL::BlitCommandEncoder* clearBlit = nullptr;
+    for (uint32_t ly = 0; ly < pageCount; ++ly) {
+        for (uint32_t lx = 0; lx < pageCount; ++lx) {
+            const size_t local = size_t(ly) * pageCount + lx;
+            const int32_t pageX = slice.pageOriginX + static_cast<int32_t>(lx);
+            const int32_t pageY = slice.pageOriginY + static_cast<int32_t>(ly);
+            const uint32_t slotX = wrapPage(pageX);
+            const uint32_t slotY = wrapPage(pageY);
+            ShadowPageSlot& slot = cache.slots[size_t(slotY) * pageCount + slotX];
+            if (slot.valid && slot.pageX == pageX && slot.pageY == pageY && slot.contentHash == m_pageHashes[local]) {
+                continue;
+            }
+            slot.pageX = pageX;
+            slot.pageY = pageY;
+            slot.contentHash = m_pageHashes[local];
+            slot.valid = true;
+            m_pageDirty[local] = 1;
+            ++dirtyCount;
+            if (!clearBlit) {
+                clearBlit = beginBlitEncoder(cmdBuffer);
+            }
+            clearBlit->copyFromTexture(m_clearPage, 0, 0, MTL::Origin(0, 0, 0), MTL::Size(pageSize, pageSize, 1),
+                                       cache.texture, 0, 0, MTL::Origin(slotX * pageSize, slotY * pageSize, 0));
+        }
+    }
+    if (clearBlit) {
+        clearBlit->endEncoding();
+    }
+    m_cachedPageCount += slotCount - dirtyCount;
+    m_renderedPageCount += dirtyCount;
+
+    m_pageDraws.clear();
+    for (size_t i = 0; i < m_viewStaticCasters.size(); ++i) {
+        const std::array<int32_t, 4>& rect = m_viewCasterPages[i];
+        for (int32_t y = rect[1]; y <= rect[3]; ++y) {
+            for (int32_t x = rect[0]; x <= rect[2]; ++x) {
+                const uint32_t local = static_cast<uint32_t>(y) * pageCount + static_cast<uint32_t>(x);
+                if (m_pageDirty[local]) {
+                    m_pageDraws.push_back(ShadowPageDraw{local, m_viewStaticCasters[i]});
+                }
+            }
+        }
+    }
+
+    if (!m_pageDraws.empty()) {
+        std::sort(m_pageDraws.begin(), m_pageDraws.end(), [](const ShadowPageDraw& a, const ShadowPageDraw& b) {
+            return a.page != b.page ? a.page < b.page : a.caster < b.caster;
+        });
+
+        MTL::RenderPassDescriptor* rp = MTL::RenderPassDescriptor::alloc()->init();
+        rp->depthAttachment()->setTexture(cache.texture);
+        rp->depthAttachment()->setLoadAction(MTL::LoadActionLoad);
+        rp->depthAttachment()->setStoreAction(MTL::StoreActionStore);
+        const double cacheSize = double(target.size);
+        auto setup = [this, cacheSize](MTL::RenderCommandEncoder* enc) {
+            enc->setDepthStencilState(m_depthState);
+            enc->setFrontFacingWinding(MTL::WindingCounterClockwise);
+            ApplyShadowDepthBias(enc);
+            enc->setViewport({0.0, 0.0, cacheSize, cacheSize, 0.0, 1.0});
+        };
+        m_casterDrawCount += m_pageDraws.size();
+        if (m_passProfiler) {
+            m_passProfiler->attach(rp, m_profiledPass);
+        }
+        ParallelPassEncoder pass(cmdBuffer, rp, m_pageDraws.size(), setup);
+        if (m_passProfiler) {
+            m_passProfiler->detach(rp);
+        }
+        const GPUPass profiledPass = m_profiledPass;
+        pass.encodeRange(m_pageDraws.size(), [&](MTL::RenderCommandEncoder* enc, size_t begin, size_t end) {
+            GPUPassWork work;
+            CasterPassParams pageParams = params;
+            MTL::RenderPipelineState* currentPipeline = nullptr;
+            UniformRing::Binder uniforms(m_uniformRing);
+            uint32_t currentPage = UINT32_MAX;
+            for (size_t i = begin; i < end; ++i) {
+                const ShadowPageDraw& draw = m_pageDraws[i];
+                if (draw.page != currentPage) {
+                    currentPage = draw.page;
+                    const uint32_t lx = draw.page % pageCount;
+                    const uint32_t ly = draw.page / pageCount;
+                    const uint32_t slotX = wrapPage(slice.pageOriginX + static_cast<int32_t>(lx));
+                    const uint32_t slotY = wrapPage(slice.pageOriginY + static_cast<int32_t>(ly));
+                    // Shift clip space by whole pages so the tile page lands on its slot.
+                    const float shiftX = 2.0f * (float(slotX) - float(lx)) / float(pageCount);
+                    const float shiftY = -2.0f * (float(slotY) - float(ly)) / float(pageCount);
+                    pageParams.viewProj = Math::Matrix4x4::Translate(Math::Vector3(shiftX, shiftY, 0.0f)) * params.viewProj;
+                    enc->setScissorRect({slotX * pageSize, slotY * pageSize, pageSize, pageSize});
+                }
+                encodeCaster(enc, pageParams, m_casters[draw.caster], 0u, currentPipeline, uniforms, work);
+            }
+            recordCasterWork(profiledPass, work);
+        });
+        m_parallelEncoderCount += pass.parallelEncoderCount();
+        pass.end();
+        rp->release();
+    }
+
+    // Unwrap the toroidal cache into the tile: at most two spans per axis.
+    const uint32_t wrapX = wrapPage(slice.pageOriginX);
+    const uint32_t wrapY = wrapPage(slice.pageOriginY);
+    const uint32_t spansX[2][3] = {{wrapX, 0, pageCount - wrapX}, {0, pageCount - wrapX, wrapX}};
+    const uint32_t spansY[2][3] = {{wrapY, 0, pageCount - wrapY}, {0, pageCount - wrapY, wrapY}};
+    MTL::BlitCommandEncoder* blit = beginBlitEncoder(cmdBuffer);
+    for (const auto& spanY : spansY) {
+        for (const auto& spanX : spansX) {
+            if (spanX[2] == 0 || spanY[2] == 0) {
+                continue;
+            }
+            blit->copyFromTexture(cache.texture, 0, 0,
+                                  MTL::Origin(spanX[0] * pageSize, spanY[0] * pageSize, 0),
+                                  MTL::Size(spanX[2] * pageSize, spanY[2] * pageSize, 1),
+                                  target.texture, target.slice, 0,
+                                  MTL::Origin(target.x + spanX[1] * pageSize, target.y + spanY[1] * pageSize, 0));
+        }
+    }
+    blit->endEncoding();
+
+    if (!m_viewDynamicCasters.empty()) {
+        renderCasterList(cmdBuffer, target, false, params, m_viewDynamicCasters);
+    }
+    return true;
+}
+
+bool ShadowRenderPass::beginShadowView(MTL::CommandBuffer* cmdBuffer,
+                                       const ShadowCacheKey& key,
+                                       const ShadowViewTarget& target,
+                                       uint32_t interval,
+                                       bool refresh) {
+    if (interval <= 1 || !key.light || !target.texture || target.size == 0) {
+        return true;
+    }
+    ShadowHistoryEntry& entry = m_shadowHistory[key];
+    entry.lastUsedFrame = m_frameIndex;
+    // A deferred view without usable history renders anyway; LightingSystem already gave it the
+    // projection its history would have been sampled with.
+    if (!refresh && entry.valid && entry.texture && entry.texture->width() == target.size) {
+        MTL::BlitCommandEncoder* blit = beginBlitEncoder(cmdBuffer);
+        blit->copyFromTexture(entry.texture, 0, 0, MTL::Origin(0, 0, 0), MTL::Size(target.size, target.size, 1),
+                              target.texture, target.slice, 0, MTL::Origin(target.x, target.y, 0));
+        blit->endEncoding();
+        entry.restoredFrame = m_frameIndex;
+        ++m_restoredViewCount;
+        return false;
+    }
+    m_historyCaptures.push_back(ShadowHistoryCapture{key, target});
+    return true;
+}
+
+bool ShadowRenderPass::wasShadowViewRestored(const ShadowCacheKey& key) const {
+    auto it = m_shadowHistory.find(key);
+    return it != m_shadowHistory.end() && it->second.restoredFrame == m_frameIndex;
+}
+
+void ShadowRenderPass::captureShadowHistory(MTL::CommandBuffer* cmdBuffer) {
+    if (m_historyCaptures.empty()) {
+        return;
+    }
+    MTL::BlitCommandEncoder* blit = cmdBuffer->blitCommandEncoder();
+    for (const auto& capture : m_historyCaptures) {
+        ShadowHistoryEntry& entry = m_shadowHistory[capture.key];
+        const ShadowViewTarget& target = capture.target;
+        entry.valid = acquireCacheTexture(entry.texture, target.size) != nullptr;
+        if (!entry.valid) {
+            continue;
+        }
+        blit->copyFromTexture(target.texture, target.slice, 0, MTL::Origin(target.x, target.y, 0),
+                              MTL::Size(target.size, target.size, 1),
+                              entry.texture, 0, 0, MTL::Origin(0, 0, 0));
+    }
+    blit->endEncoding();
+    m_historyCaptures.clear();
+}
+
+bool ShadowRenderPass::ensureClearPage(MTL::CommandBuffer* cmdBuffer, uint32_t pageSize) {
+    if (m_clearPage && m_clearPage->width() >= pageSize) {
+        return true;
+    }
+    if (m_clearPage) {
+        m_clearPage->release();
+        m_clearPage = nullptr;
+    }
+    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+    desc->setTextureType(MTL::TextureType2D);
+    desc->setWidth(pageSize);
+    desc->setHeight(pageSize);
+    desc->setPixelFormat(MTL::PixelFormatDepth32Float);
+    desc->setUsage(MTL::TextureUsageRenderTarget);
+    desc->setStorageMode(MTL::StorageModePrivate);
+    m_clearPage = m_device->newTexture(desc);
+    desc->release();
+    if (!m_clearPage) {
+        return false;
+    }
+    MTL::RenderPassDescriptor* clearDesc = MTL::RenderPassDescriptor::alloc()->init();
+    clearDesc->depthAttachment()->setTexture(m_clearPage);
+    clearDesc->depthAttachment()->setLoadAction(MTL::LoadActionClear);
+    clearDesc->depthAttachment()->setStoreAction(MTL::StoreActionStore);
+    clearDesc->depthAttachment()->setClearDepth(1.0);
+    MTL::RenderCommandEncoder* clearEnc = beginRenderEncoder(cmdBuffer, clearDesc);
+    clearEnc->endEncoding();
+    clearDesc->release();
+    return true;
+}
+
+MTL::Texture* ShadowRenderPass::acquireCacheTexture(MTL::Texture*& texture, uint32_t size) {
+    if (texture && texture->width() == size) {
+        return texture;
+    }
+    releaseCacheTexture(texture);
+    const size_t bytes = size_t(size) * size_t(size) * sizeof(float);
+    if (m_shadowCacheBytes + bytes > kMaxShadowCacheBytes) {
+        return nullptr;
+    }
+
+    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+    desc->setTextureType(MTL::TextureType2D);
+    desc->setWidth(size);
+    desc->setHeight(size);
+    desc->setPixelFormat(MTL::PixelFormatDepth32Float);
+    desc->setUsage(MTL::TextureUsageRenderTarget);
+    desc->setStorageMode(MTL::StorageModePrivate);
+    texture = m_device->newTexture(desc);
+    desc->release();
+    if (texture) {
+        m_shadowCacheBytes += bytes;
+    }
+    return texture;
+}
+
+void ShadowRenderPass::releaseCacheTexture(MTL::Texture*& texture) {
+    if (!texture) {
+        return;
+    }
+    m_shadowCacheBytes -= size_t(texture->width()) * size_t(texture->height()) * sizeof(float);
+    texture->release();
+    texture = nullptr;
+}
+
+void ShadowRenderPass::evictShadowCache() {
+    if (m_frameIndex % kShadowCacheEvictFrames != 0) {
+        return;
+    }
+    for (auto it = m_shadowCache.begin(); it != m_shadowCache.end();) {
+        ShadowCacheEntry& entry = it->second;
+        if (entry.lastUsedFrame + kShadowCacheEvictFrames >= m_frameIndex) {
+            ++it;
+            continue;
+        }
+        releaseCacheTexture(entry.texture);
+        it = m_shadowCache.erase(it);
+    }
+    for (auto it = m_shadowPageCaches.begin(); it != m_shadowPageCaches.end();) {
+        if (it->second.lastUsedFrame + kShadowCacheEvictFrames >= m_frameIndex) {
+            ++it;
+            continue;
+        }
+        releaseCacheTexture(it->second.texture);
+        it = m_shadowPageCaches.erase(it);
+    }
+    for (auto it = m_shadowHistory.begin(); it != m_shadowHistory.end();) {
+        if (it->second.lastUsedFrame + kShadowCacheEvictFrames >= m_frameIndex) {
+            ++it;
+            continue;
+        }
+        releaseCacheTexture(it->second.texture);
+        it = m_shadowHistory.erase(it);
+    }
+    for (auto it = m_casterHistory.begin(); it != m_casterHistory.end();) {
+        if (it->second.lastSeenFrame + kShadowCacheEvictFrames < m_frameIndex) {
+            it = m_casterHistory.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ShadowRenderPass::releaseShadowCache() {
+    for (auto& [key, entry] : m_shadowCache) {
+        releaseCacheTexture(entry.texture);
+    }
+    for (auto& [key, cache] : m_shadowPageCaches) {
+        releaseCacheTexture(cache.texture);
+    }
+    for (auto& [key, entry] : m_shadowHistory) {
+        releaseCacheTexture(entry.texture);
+    }
+    m_shadowCache.clear();
+    m_shadowPageCaches.clear();
+    m_shadowHistory.clear();
+    m_shadowCacheBytes = 0;
+}
+
+void ShadowRenderPass::renderInstancedRange(MTL::CommandBuffer* cmdBuffer,
+                                            const ShadowGPUData& shadow,
+                                            const ShadowAtlasTile& tile,
+                                            MTL::RenderPipelineState* pipeline,
+                                            MTL::RenderPipelineState* pipelineCutout,
+                                            MTL::RenderPipelineState* pipelineSkinned,
+                                            MTL::RenderPipelineState* pipelineVat,
+                                            MTL::RenderPipelineState* pipelineTerrain,
+                                            int32_t cascade,
+                                            const FrameVector<InstancedShadowDraw>& instancedDraws) {
+    if (!tile.valid || !pipeline || instancedDraws.empty()) {
+        return;
+    }
+
+    // Terrain patches are selected per cascade (TerrainSystem), so each cascade draws only its own.
+    auto skipDraw = [&](const InstancedShadowDraw& draw) {
+        return !draw.mesh || draw.instanceCount == 0
+            || (draw.terrainHeights && (!pipelineTerrain || draw.shadowCascade != cascade));
+    };
+
+    auto buildFoliageParams = [&](const InstancedShadowDraw& draw) {
+        ShadowFoliageParamsCPU params{};
+        if (draw.material) {
+            Math::Vector3 windDir = draw.material->getWindDirection();
+            params.foliageParams0 = Math::Vector4(
+                draw.material->getWindStrength(),
+                draw.material->getWindSpeed(),
+                draw.material->getWindScale(),
+                draw.material->getWindGust()
+            );
+            params.foliageParams1 = Math::Vector4(
+                draw.material->getLodFadeStart(),
+                draw.material->getLodFadeEnd(),
+                draw.material->getBillboardStart(),
+                draw.material->getBillboardEnd()
+            );
+            params.foliageParams2 = Math::Vector4(
+                draw.material->getWindEnabled() ? 1.0f : 0.0f,
+                draw.material->getLodFadeEnabled() ? 1.0f : 0.0f,
+                draw.material->getBillboardEnabled() ? 1.0f : 0.0f,
+                draw.material->getDitherEnabled() ? 1.0f : 0.0f
+            );
+            params.foliageParams3 = Math::Vector4(windDir.x, windDir.y, windDir.z, 0.0f);
+        } else {
+            params.foliageParams0 = Math::Vector4(0.0f);
+            params.foliageParams1 = Math::Vector4(0.0f);
+            params.foliageParams2 = Math::Vector4(0.0f);
+            params.foliageParams3 = Math::Vector4(0.0f);
+        }
+        params.cameraTime = Math::Vector4(m_cameraPosition.x, m_cameraPosition.y, m_cameraPosition.z, m_timeSeconds);
+        params.boundsCenter = Math::Vector4(draw.boundsCenter.x, draw.boundsCenter.y, draw.boundsCenter.z, 0.0f);
+        params.boundsSize = Math::Vector4(draw.boundsSize.x, draw.boundsSize.y, draw.boundsSize.z, 0.0f);
+        params.flags = Math::Vector4(draw.isBillboard ? 1.0f : 0.0f, 0.0f, 0.0f, 0.0f);
+        return params;
+    };
 
     if (!m_instanceCullPipeline || !m_instanceIndirectPipeline) {
         // Fall back to non-culled draw path
@@ -1024,7 +2173,7 @@ void ShadowRenderPass::renderInstancedRange(MTL::CommandBuffer* cmdBuffer,
         rp->depthAttachment()->setStoreAction(MTL::StoreActionStore);
         rp->depthAttachment()->setClearDepth(1.0);
 
-        MTL::RenderCommandEncoder* enc = cmdBuffer->renderCommandEncoder(rp);
+        MTL::RenderCommandEncoder* enc = beginRenderEncoder(cmdBuffer, rp);
         enc->setDepthStencilState(m_depthState);
         enc->setFrontFacingWinding(MTL::WindingCounterClockwise);
         ApplyShadowDepthBias(enc);
@@ -1034,11 +2183,29 @@ void ShadowRenderPass::renderInstancedRange(MTL::CommandBuffer* cmdBuffer,
         enc->setVertexBytes(&shadow.viewProj, sizeof(Math::Matrix4x4), 1);
 
         for (const auto& draw : instancedDraws) {
-            if (!draw.mesh || draw.instanceCount == 0 || !draw.instanceBuffer) {
+            if (skipDraw(draw) || !draw.instanceBuffer) {
                 continue;
             }
-            bool isCutout = IsCutoutMaterial(draw.material);
-            if (isCutout && pipelineCutout) {
+            MTL::Buffer* crowdWeights = draw.bonePalette && pipelineSkinned
+                ? static_cast<MTL::Buffer*>(draw.mesh->getSkinWeightBuffer()) : nullptr;
+            MTL::Texture* vertexAnimation = !crowdWeights && pipelineVat ? draw.vertexAnimation : nullptr;
+            bool isCutout = !crowdWeights && !vertexAnimation && !draw.terrainHeights && IsCutoutMaterial(draw.material);
+            if (draw.terrainHeights) {
+                if (currentPipeline != pipelineTerrain) {
+                    enc->setRenderPipelineState(pipelineTerrain);
+                    currentPipeline = pipelineTerrain;
+                }
+            } else if (crowdWeights) {
+                if (currentPipeline != pipelineSkinned) {
+                    enc->setRenderPipelineState(pipelineSkinned);
+                    currentPipeline = pipelineSkinned;
+                }
+            } else if (vertexAnimation) {
+                if (currentPipeline != pipelineVat) {
+                    enc->setRenderPipelineState(pipelineVat);
+                    currentPipeline = pipelineVat;
+                }
+            } else if (isCutout && pipelineCutout) {
                 if (currentPipeline != pipelineCutout) {
                     enc->setRenderPipelineState(pipelineCutout);
                     currentPipeline = pipelineCutout;
@@ -1054,15 +2221,29 @@ void ShadowRenderPass::renderInstancedRange(MTL::CommandBuffer* cmdBuffer,
             if (!vertexBuffer || !indexBuffer) {
                 continue;
             }
-            enc->setVertexBuffer(vertexBuffer, 0, 0);
+            enc->setVertexBuffer(vertexBuffer, draw.mesh->getVertexBufferOffset(), 0);
+            enc->setVertexBuffer(static_cast<MTL::Buffer*>(draw.mesh->getAttributeBuffer()), draw.mesh->getAttributeBufferOffset(),
+                                 GeometryBuffer::kAttributeBufferIndex);
+            if (crowdWeights) {
+                enc->setVertexBuffer(crowdWeights, draw.mesh->getSkinWeightBufferOffset(), GeometryBuffer::kSkinWeightBufferIndex);
+                enc->setVertexBuffer(draw.bonePalette, 0, 5);
+            }
             enc->setVertexBuffer(draw.instanceBuffer, draw.instanceOffset, 2);
-            ShadowFoliageParamsCPU foliage = buildFoliageParams(draw);
-            enc->setVertexBytes(&foliage, sizeof(ShadowFoliageParamsCPU), 3);
+            if (draw.terrainHeights) {
+                enc->setVertexBytes(&draw.terrainParams, sizeof(TerrainParamsGPU), 3);
+                enc->setVertexTexture(draw.terrainHeights, 0);
+            } else if (vertexAnimation) {
+                enc->setVertexBytes(&draw.vertexAnimationParams, sizeof(VertexAnimationParamsGPU), 3);
+                enc->setVertexTexture(vertexAnimation, 0);
+            } else {
+                ShadowFoliageParamsCPU foliage = buildFoliageParams(draw);
+                enc->setVertexBytes(&foliage, sizeof(ShadowFoliageParamsCPU), 3);
+            }
             enc->drawIndexedPrimitives(MTL::PrimitiveTypeTriangle,
-                                       draw.mesh->getIndices().size(),
+                                       draw.mesh->getIndexCount(),
                                        MTL::IndexTypeUInt32,
                                        indexBuffer,
-                                       0,
+                                       draw.mesh->getIndexBufferOffset(),
                                        draw.instanceCount);
         }
 
@@ -1121,22 +2302,22 @@ void ShadowRenderPass::renderInstancedRange(MTL::CommandBuffer* cmdBuffer,
     std::memset(m_instanceCountBuffer->contents(), 0, drawCount * sizeof(uint32_t));
     auto* args = static_cast<DrawIndexedIndirectArgs*>(m_instanceIndirectBuffer->contents());
     for (size_t i = 0; i < drawCount; ++i) {
-        args[i].indexCount = instancedDraws[i].mesh ? instancedDraws[i].mesh->getIndices().size() : 0;
+        args[i].indexCount = instancedDraws[i].mesh ? instancedDraws[i].mesh->getIndexCount() : 0;
         args[i].instanceCount = 0;
         args[i].indexStart = 0;
         args[i].baseVertex = 0;
         args[i].baseInstance = 0;
     }
 
-    auto planes = extractFrustumPlanes(shadow.viewProj);
+    auto planes = Math::ExtractFrustumPlanes(shadow.viewProj);
 
-    MTL::ComputeCommandEncoder* cullEncoder = cmdBuffer->computeCommandEncoder();
+    MTL::ComputeCommandEncoder* cullEncoder = beginComputeEncoder(cmdBuffer);
     cullEncoder->setComputePipelineState(m_instanceCullPipeline);
 
     uint32_t outputOffset = 0;
     for (size_t i = 0; i < drawCount; ++i) {
         const auto& draw = instancedDraws[i];
-        if (!draw.mesh || draw.instanceCount == 0 || !draw.instanceBuffer) {
+        if (skipDraw(draw) || !draw.instanceBuffer) {
             continue;
         }
 
@@ -1166,7 +2347,7 @@ void ShadowRenderPass::renderInstancedRange(MTL::CommandBuffer* cmdBuffer,
     }
     cullEncoder->endEncoding();
 
-    MTL::ComputeCommandEncoder* indirectEncoder = cmdBuffer->computeCommandEncoder();
+    MTL::ComputeCommandEncoder* indirectEncoder = beginComputeEncoder(cmdBuffer);
     indirectEncoder->setComputePipelineState(m_instanceIndirectPipeline);
     indirectEncoder->setBuffer(m_instanceCountBuffer, 0, 0);
     indirectEncoder->setBuffer(m_instanceIndirectBuffer, 0, 1);
@@ -1182,7 +2363,7 @@ void ShadowRenderPass::renderInstancedRange(MTL::CommandBuffer* cmdBuffer,
     rp->depthAttachment()->setStoreAction(MTL::StoreActionStore);
     rp->depthAttachment()->setClearDepth(1.0);
 
-    MTL::RenderCommandEncoder* enc = cmdBuffer->renderCommandEncoder(rp);
+    MTL::RenderCommandEncoder* enc = beginRenderEncoder(cmdBuffer, rp);
     enc->setDepthStencilState(m_depthState);
     enc->setFrontFacingWinding(MTL::WindingCounterClockwise);
     ApplyShadowDepthBias(enc);
@@ -1194,11 +2375,29 @@ void ShadowRenderPass::renderInstancedRange(MTL::CommandBuffer* cmdBuffer,
     outputOffset = 0;
     for (size_t i = 0; i < drawCount; ++i) {
         const auto& draw = instancedDraws[i];
-        if (!draw.mesh || draw.instanceCount == 0) {
+        if (skipDraw(draw)) {
             continue;
         }
-        bool isCutout = IsCutoutMaterial(draw.material);
-        if (isCutout && pipelineCutout) {
+        MTL::Buffer* crowdWeights = draw.bonePalette && pipelineSkinned
+            ? static_cast<MTL::Buffer*>(draw.mesh->getSkinWeightBuffer()) : nullptr;
+        MTL::Texture* vertexAnimation = !crowdWeights && pipelineVat ? draw.vertexAnimation : nullptr;
+        bool isCutout = !crowdWeights && !vertexAnimation && !draw.terrainHeights && IsCutoutMaterial(draw.material);
+        if (draw.terrainHeights) {
+            if (currentPipeline != pipelineTerrain) {
+                enc->setRenderPipelineState(pipelineTerrain);
+                currentPipeline = pipelineTerrain;
+            }
+        } else if (crowdWeights) {
+            if (currentPipeline != pipelineSkinned) {
+                enc->setRenderPipelineState(pipelineSkinned);
+                currentPipeline = pipelineSkinned;
+            }
+        } else if (vertexAnimation) {
+            if (currentPipeline != pipelineVat) {
+                enc->setRenderPipelineState(pipelineVat);
+                currentPipeline = pipelineVat;
+            }
+        } else if (isCutout && pipelineCutout) {
             if (currentPipeline != pipelineCutout) {
                 enc->setRenderPipelineState(pipelineCutout);
                 currentPipeline = pipelineCutout;
@@ -1214,15 +2413,29 @@ void ShadowRenderPass::renderInstancedRange(MTL::CommandBuffer* cmdBuffer,
         if (!vertexBuffer || !indexBuffer) {
             continue;
         }
-        enc->setVertexBuffer(vertexBuffer, 0, 0);
+        enc->setVertexBuffer(vertexBuffer, draw.mesh->getVertexBufferOffset(), 0);
+        enc->setVertexBuffer(static_cast<MTL::Buffer*>(draw.mesh->getAttributeBuffer()), draw.mesh->getAttributeBufferOffset(),
+                             GeometryBuffer::kAttributeBufferIndex);
+        if (crowdWeights) {
+            enc->setVertexBuffer(crowdWeights, draw.mesh->getSkinWeightBufferOffset(), GeometryBuffer::kSkinWeightBufferIndex);
+            enc->setVertexBuffer(draw.bonePalette, 0, 5);
+        }
         enc->setVertexBuffer(m_instanceCullBuffer, outputOffset * sizeof(InstanceDataCPU), 2);
-        ShadowFoliageParamsCPU foliage = buildFoliageParams(draw);
-        enc->setVertexBytes(&foliage, sizeof(ShadowFoliageParamsCPU), 3);
+        if (draw.terrainHeights) {
+            enc->setVertexBytes(&draw.terrainParams, sizeof(TerrainParamsGPU), 3);
+            enc->setVertexTexture(draw.terrainHeights, 0);
+        } else if (vertexAnimation) {
+            enc->setVertexBytes(&draw.vertexAnimationParams, sizeof(VertexAnimationParamsGPU), 3);
+            enc->setVertexTexture(vertexAnimation, 0);
+        } else {
+            ShadowFoliageParamsCPU foliage = buildFoliageParams(draw);
+            enc->setVertexBytes(&foliage, sizeof(ShadowFoliageParamsCPU), 3);
+        }
         enc->drawIndexedPrimitives(
             MTL::PrimitiveTypeTriangle,
             MTL::IndexTypeUInt32,
             indexBuffer,
-            0,
+            draw.mesh->getIndexBufferOffset(),
             m_instanceIndirectBuffer,
             i * sizeof(DrawIndexedIndirectArgs)
         );
@@ -1242,7 +2455,9 @@ void ShadowRenderPass::renderInstancedCubeFace(MTL::CommandBuffer* cmdBuffer,
                                                const Math::Vector4* pointFarParams,
                                                MTL::RenderPipelineState* pipeline,
                                                MTL::RenderPipelineState* pipelineCutout,
-                                               const std::vector<InstancedShadowDraw>& instancedDraws) {
+                                               MTL::RenderPipelineState* pipelineSkinned,
+                                               MTL::RenderPipelineState* pipelineVat,
+                                               const FrameVector<InstancedShadowDraw>& instancedDraws) {
     if (!target || !pipeline || instancedDraws.empty()) {
         return;
     }
@@ -1290,7 +2505,7 @@ void ShadowRenderPass::renderInstancedCubeFace(MTL::CommandBuffer* cmdBuffer,
         rp->depthAttachment()->setLoadAction(MTL::LoadActionLoad);
         rp->depthAttachment()->setStoreAction(MTL::StoreActionStore);
 
-        MTL::RenderCommandEncoder* enc = cmdBuffer->renderCommandEncoder(rp);
+        MTL::RenderCommandEncoder* enc = beginRenderEncoder(cmdBuffer, rp);
         enc->setDepthStencilState(m_depthState);
         enc->setFrontFacingWinding(MTL::WindingCounterClockwise);
         ApplyShadowDepthBias(enc);
@@ -1304,13 +2519,34 @@ void ShadowRenderPass::renderInstancedCubeFace(MTL::CommandBuffer* cmdBuffer,
         if (pointFarParams) {
             enc->setVertexBytes(pointFarParams, sizeof(Math::Vector4), 5);
         }
+        // Crowd draws take slots 4 and 5 for skin weights and palettes and read these from 6 and 7.
+        if (pointLightPosNear) {
+            enc->setVertexBytes(pointLightPosNear, sizeof(Math::Vector4), 6);
+        }
+        if (pointFarParams) {
+            enc->setVertexBytes(pointFarParams, sizeof(Math::Vector4), 7);
+        }
+        bool pointParamsReplaced = false;
 
         for (const auto& draw : instancedDraws) {
-            if (!draw.mesh || draw.instanceCount == 0 || !draw.instanceBuffer) {
+            if (!draw.mesh || draw.instanceCount == 0 || !draw.instanceBuffer || draw.terrainHeights) {
                 continue;
             }
-            bool isCutout = IsCutoutMaterial(draw.material);
-            if (isCutout && pipelineCutout) {
+            MTL::Buffer* crowdWeights = draw.bonePalette && pipelineSkinned
+                ? static_cast<MTL::Buffer*>(draw.mesh->getSkinWeightBuffer()) : nullptr;
+            MTL::Texture* vertexAnimation = !crowdWeights && pipelineVat ? draw.vertexAnimation : nullptr;
+            bool isCutout = !crowdWeights && !vertexAnimation && IsCutoutMaterial(draw.material);
+            if (crowdWeights) {
+                if (currentPipeline != pipelineSkinned) {
+                    enc->setRenderPipelineState(pipelineSkinned);
+                    currentPipeline = pipelineSkinned;
+                }
+            } else if (vertexAnimation) {
+                if (currentPipeline != pipelineVat) {
+                    enc->setRenderPipelineState(pipelineVat);
+                    currentPipeline = pipelineVat;
+                }
+            } else if (isCutout && pipelineCutout) {
                 if (currentPipeline != pipelineCutout) {
                     enc->setRenderPipelineState(pipelineCutout);
                     currentPipeline = pipelineCutout;
@@ -1326,15 +2562,35 @@ void ShadowRenderPass::renderInstancedCubeFace(MTL::CommandBuffer* cmdBuffer,
             if (!vertexBuffer || !indexBuffer) {
                 continue;
             }
-            enc->setVertexBuffer(vertexBuffer, 0, 0);
+            enc->setVertexBuffer(vertexBuffer, draw.mesh->getVertexBufferOffset(), 0);
+            enc->setVertexBuffer(static_cast<MTL::Buffer*>(draw.mesh->getAttributeBuffer()), draw.mesh->getAttributeBufferOffset(),
+                                 GeometryBuffer::kAttributeBufferIndex);
+            if (crowdWeights) {
+                enc->setVertexBuffer(crowdWeights, draw.mesh->getSkinWeightBufferOffset(), GeometryBuffer::kSkinWeightBufferIndex);
+                enc->setVertexBuffer(draw.bonePalette, 0, 5);
+                pointParamsReplaced = true;
+            } else if (pointParamsReplaced) {
+                if (pointLightPosNear) {
+                    enc->setVertexBytes(pointLightPosNear, sizeof(Math::Vector4), 4);
+                }
+                if (pointFarParams) {
+                    enc->setVertexBytes(pointFarParams, sizeof(Math::Vector4), 5);
+                }
+                pointParamsReplaced = false;
+            }
             enc->setVertexBuffer(draw.instanceBuffer, draw.instanceOffset, 2);
-            ShadowFoliageParamsCPU foliage = buildFoliageParams(draw);
-            enc->setVertexBytes(&foliage, sizeof(ShadowFoliageParamsCPU), 3);
+            if (vertexAnimation) {
+                enc->setVertexBytes(&draw.vertexAnimationParams, sizeof(VertexAnimationParamsGPU), 3);
+                enc->setVertexTexture(vertexAnimation, 0);
+            } else {
+                ShadowFoliageParamsCPU foliage = buildFoliageParams(draw);
+                enc->setVertexBytes(&foliage, sizeof(ShadowFoliageParamsCPU), 3);
+            }
             enc->drawIndexedPrimitives(MTL::PrimitiveTypeTriangle,
-                                       draw.mesh->getIndices().size(),
+                                       draw.mesh->getIndexCount(),
                                        MTL::IndexTypeUInt32,
                                        indexBuffer,
-                                       0,
+                                       draw.mesh->getIndexBufferOffset(),
                                        draw.instanceCount);
         }
 
@@ -1389,22 +2645,22 @@ void ShadowRenderPass::renderInstancedCubeFace(MTL::CommandBuffer* cmdBuffer,
     std::memset(m_instanceCountBuffer->contents(), 0, drawCount * sizeof(uint32_t));
     auto* args = static_cast<DrawIndexedIndirectArgs*>(m_instanceIndirectBuffer->contents());
     for (size_t i = 0; i < drawCount; ++i) {
-        args[i].indexCount = instancedDraws[i].mesh ? instancedDraws[i].mesh->getIndices().size() : 0;
+        args[i].indexCount = instancedDraws[i].mesh ? instancedDraws[i].mesh->getIndexCount() : 0;
         args[i].instanceCount = 0;
         args[i].indexStart = 0;
         args[i].baseVertex = 0;
         args[i].baseInstance = 0;
     }
 
-    auto planes = extractFrustumPlanes(viewProj);
+    auto planes = Math::ExtractFrustumPlanes(viewProj);
 
-    MTL::ComputeCommandEncoder* cullEncoder = cmdBuffer->computeCommandEncoder();
+    MTL::ComputeCommandEncoder* cullEncoder = beginComputeEncoder(cmdBuffer);
     cullEncoder->setComputePipelineState(m_instanceCullPipeline);
 
     uint32_t outputOffset = 0;
     for (size_t i = 0; i < drawCount; ++i) {
         const auto& draw = instancedDraws[i];
-        if (!draw.mesh || draw.instanceCount == 0 || !draw.instanceBuffer) {
+        if (!draw.mesh || draw.instanceCount == 0 || !draw.instanceBuffer || draw.terrainHeights) {
             continue;
         }
 
@@ -1434,7 +2690,7 @@ void ShadowRenderPass::renderInstancedCubeFace(MTL::CommandBuffer* cmdBuffer,
     }
     cullEncoder->endEncoding();
 
-    MTL::ComputeCommandEncoder* indirectEncoder = cmdBuffer->computeCommandEncoder();
+    MTL::ComputeCommandEncoder* indirectEncoder = beginComputeEncoder(cmdBuffer);
     indirectEncoder->setComputePipelineState(m_instanceIndirectPipeline);
     indirectEncoder->setBuffer(m_instanceCountBuffer, 0, 0);
     indirectEncoder->setBuffer(m_instanceIndirectBuffer, 0, 1);
@@ -1449,7 +2705,7 @@ void ShadowRenderPass::renderInstancedCubeFace(MTL::CommandBuffer* cmdBuffer,
     rp->depthAttachment()->setLoadAction(MTL::LoadActionLoad);
     rp->depthAttachment()->setStoreAction(MTL::StoreActionStore);
 
-    MTL::RenderCommandEncoder* enc = cmdBuffer->renderCommandEncoder(rp);
+    MTL::RenderCommandEncoder* enc = beginRenderEncoder(cmdBuffer, rp);
     enc->setDepthStencilState(m_depthState);
     enc->setFrontFacingWinding(MTL::WindingCounterClockwise);
     ApplyShadowDepthBias(enc);
@@ -1463,15 +2719,36 @@ void ShadowRenderPass::renderInstancedCubeFace(MTL::CommandBuffer* cmdBuffer,
     if (pointFarParams) {
         enc->setVertexBytes(pointFarParams, sizeof(Math::Vector4), 5);
     }
+    // Crowd draws take slots 4 and 5 for skin weights and palettes and read these from 6 and 7.
+    if (pointLightPosNear) {
+        enc->setVertexBytes(pointLightPosNear, sizeof(Math::Vector4), 6);
+    }
+    if (pointFarParams) {
+        enc->setVertexBytes(pointFarParams, sizeof(Math::Vector4), 7);
+    }
+    bool pointParamsReplaced = false;
 
     outputOffset = 0;
     for (size_t i = 0; i < drawCount; ++i) {
         const auto& draw = instancedDraws[i];
-        if (!draw.mesh || draw.instanceCount == 0) {
+        if (!draw.mesh || draw.instanceCount == 0 || draw.terrainHeights) {
             continue;
         }
-        bool isCutout = IsCutoutMaterial(draw.material);
-        if (isCutout && pipelineCutout) {
+        MTL::Buffer* crowdWeights = draw.bonePalette && pipelineSkinned
+            ? static_cast<MTL::Buffer*>(draw.mesh->getSkinWeightBuffer()) : nullptr;
+        MTL::Texture* vertexAnimation = !crowdWeights && pipelineVat ? draw.vertexAnimation : nullptr;
+        bool isCutout = !crowdWeights && !vertexAnimation && IsCutoutMaterial(draw.material);
+        if (crowdWeights) {
+            if (currentPipeline != pipelineSkinned) {
+                enc->setRenderPipelineState(pipelineSkinned);
+                currentPipeline = pipelineSkinned;
+            }
+        } else if (vertexAnimation) {
+            if (currentPipeline != pipelineVat) {
+                enc->setRenderPipelineState(pipelineVat);
+                currentPipeline = pipelineVat;
+            }
+        } else if (isCutout && pipelineCutout) {
             if (currentPipeline != pipelineCutout) {
                 enc->setRenderPipelineState(pipelineCutout);
                 currentPipeline = pipelineCutout;
@@ -1487,15 +2764,35 @@ void ShadowRenderPass::renderInstancedCubeFace(MTL::CommandBuffer* cmdBuffer,
         if (!vertexBuffer || !indexBuffer) {
             continue;
         }
-        enc->setVertexBuffer(vertexBuffer, 0, 0);
+        enc->setVertexBuffer(vertexBuffer, draw.mesh->getVertexBufferOffset(), 0);
+        enc->setVertexBuffer(static_cast<MTL::Buffer*>(draw.mesh->getAttributeBuffer()), draw.mesh->getAttributeBufferOffset(),
+                             GeometryBuffer::kAttributeBufferIndex);
+        if (crowdWeights) {
+            enc->setVertexBuffer(crowdWeights, draw.mesh->getSkinWeightBufferOffset(), GeometryBuffer::kSkinWeightBufferIndex);
+            enc->setVertexBuffer(draw.bonePalette, 0, 5);
+            pointParamsReplaced = true;
+        } else if (pointParamsReplaced) {
+            if (pointLightPosNear) {
+                enc->setVertexBytes(pointLightPosNear, sizeof(Math::Vector4), 4);
+            }
+            if (pointFarParams) {
+                enc->setVertexBytes(pointFarParams, sizeof(Math::Vector4), 5);
+            }
+            pointParamsReplaced = false;
+        }
         enc->setVertexBuffer(m_instanceCullBuffer, outputOffset * sizeof(InstanceDataCPU), 2);
-        ShadowFoliageParamsCPU foliage = buildFoliageParams(draw);
-        enc->setVertexBytes(&foliage, sizeof(ShadowFoliageParamsCPU), 3);
+        if (vertexAnimation) {
+            enc->setVertexBytes(&draw.vertexAnimationParams, sizeof(VertexAnimationParamsGPU), 3);
+            enc->setVertexTexture(vertexAnimation, 0);
+        } else {
+            ShadowFoliageParamsCPU foliage = buildFoliageParams(draw);
+            enc->setVertexBytes(&foliage, sizeof(ShadowFoliageParamsCPU), 3);
+        }
         enc->drawIndexedPrimitives(
             MTL::PrimitiveTypeTriangle,
             MTL::IndexTypeUInt32,
             indexBuffer,
-            0,
+            draw.mesh->getIndexBufferOffset(),
             m_instanceIndirectBuffer,
             i * sizeof(DrawIndexedIndirectArgs)
         );
@@ -1584,6 +2881,9 @@ void ShadowRenderPass::renderPointCubes(MTL::CommandBuffer* cmdBuffer, Scene* sc
         MTL::Texture* cubeTex = (tier < (int)m_pointCubeTextures.size()) ? m_pointCubeTextures[tier] : nullptr;
         if (!cubeTex) continue;
         uint32_t cubeIndex = (uint32_t)std::max(0.0f, s.depthRange.z);
+        const size_t drawsBefore = m_casterDrawCount;
+        // All faces due this frame draw in one layered pass over the cube's six slices.
+        const bool layered = m_maxAmplification > 1 && m_pointPipelineLayered;
         if ((s_pointShadowDebugFrame % 120u) == 1u) {
             std::cout << "[POINT SHADOW DEBUG] light=" << i
                       << " pos=(" << prepared[i].positionWS.x << ", " << prepared[i].positionWS.y << ", " << prepared[i].positionWS.z << ")"
@@ -1595,100 +2895,63 @@ void ShadowRenderPass::renderPointCubes(MTL::CommandBuffer* cmdBuffer, Scene* sc
                       << std::endl;
         }
         
-        // Clear all faces for this cube
         for (int face = 0; face < 6; ++face) {
-            MTL::RenderPassDescriptor* rp = MTL::RenderPassDescriptor::alloc()->init();
-            rp->depthAttachment()->setTexture(cubeTex);
-            // For cube arrays, slices are laid out as 6 faces per cube
-            rp->depthAttachment()->setSlice(cubeIndex * 6 + face);
-            rp->depthAttachment()->setLoadAction(MTL::LoadActionClear);
-            rp->depthAttachment()->setStoreAction(MTL::StoreActionStore);
-            rp->depthAttachment()->setClearDepth(1.0);
-            
-            MTL::RenderCommandEncoder* enc = cmdBuffer->renderCommandEncoder(rp);
-            enc->setDepthStencilState(m_depthState);
-            enc->setFrontFacingWinding(MTL::WindingCounterClockwise);
-            ApplyShadowDepthBias(enc);
-            enc->setViewport({0.0, 0.0, (double)res, (double)res, 0.0, 1.0});
-            MTL::RenderPipelineState* currentPipeline = nullptr;
-            
             Math::Vector3 lightPos = prepared[i].positionWS;
             Math::Matrix4x4 view = Math::Matrix4x4::LookAt(lightPos, lightPos + faceDirs[face], faceUps[face]);
             // Cubemap face FOV must be 90 degrees (HALF_PI), not 180!
             Math::Matrix4x4 proj = Math::Matrix4x4::Perspective(Math::HALF_PI, 1.0f, s.depthRange.x, s.depthRange.y);
-            Math::Matrix4x4 vp = proj * view;
-            uint32_t faceDrawCount = 0;
             
-        const auto& entities = scene->getAllEntities();
-        for (const auto& entPtr : entities) {
-            Entity* e = entPtr.get();
-            if (!e->isActiveInHierarchy()) continue;
-            if (shouldSkipEntity(e)) continue;
-            MeshRenderer* mr = e->getComponent<MeshRenderer>();
-            if (!mr || !mr->isEnabled() || !mr->getCastShadows()) continue;
-            std::shared_ptr<Mesh> mesh = mr->getMesh();
-            if (!mesh || !mesh->isUploaded()) continue;
-                
-                Math::Matrix4x4 model = e->getTransform()->getWorldMatrix();
-                ShadowObjectUniformsCPU objectUniforms{};
-                objectUniforms.viewProj = vp;
-                objectUniforms.modelMatrix = model;
-                objectUniforms.pointLightPosNear = Math::Vector4(lightPos.x, lightPos.y, lightPos.z, s.depthRange.x);
-                objectUniforms.pointFarParams = Math::Vector4(s.depthRange.y, 0.0f, 0.0f, 0.0f);
-                enc->setVertexBuffer(static_cast<MTL::Buffer*>(mesh->getVertexBuffer()), 0, 0);
-                SkinnedMeshRenderer* skinned = e->getComponent<SkinnedMeshRenderer>();
-                bool wantsSkin = skinned && skinned->isEnabled() && mesh->hasSkinWeights() && !skinned->getBoneMatrices().empty();
-                MTL::Buffer* skinBuffer = static_cast<MTL::Buffer*>(mesh->getSkinWeightBuffer());
-                bool useSkinned = wantsSkin && skinBuffer && m_pointPipelineSkinned;
-                std::shared_ptr<Material> material = mr->getMaterial(0);
-                ShadowFoliageParamsCPU foliage = BuildShadowFoliageParams(material, m_cameraPosition, m_timeSeconds);
-                bool isCutout = IsCutoutMaterial(material);
-                enc->setCullMode(ResolveCullMode(material));
-                MTL::RenderPipelineState* desiredPipeline = useSkinned
-                    ? (isCutout && m_pointPipelineSkinnedCutout ? m_pointPipelineSkinnedCutout : m_pointPipelineSkinned)
-                    : (isCutout && m_pointPipelineCutout ? m_pointPipelineCutout : m_pointPipeline);
-                if (!desiredPipeline) {
-                    continue;
-                }
-                if (desiredPipeline != currentPipeline) {
-                    enc->setRenderPipelineState(desiredPipeline);
-                    currentPipeline = desiredPipeline;
-                }
-                if (useSkinned) {
-                    enc->setVertexBuffer(skinBuffer, 0, 4);
-                    const auto& boneMatrices = skinned->getBoneMatrices();
-                    size_t bytes = boneMatrices.size() * sizeof(Math::Matrix4x4);
-                    size_t bufferOffset = 0;
-                    if (allocateSkinningSlice(bytes, bufferOffset)) {
-                        std::memcpy(static_cast<char*>(m_skinningBuffer->contents()) + bufferOffset,
-                                    boneMatrices.data(),
-                                    bytes);
-                        enc->setVertexBuffer(m_skinningBuffer, bufferOffset, 2);
-                    }
-                }
-                if (isCutout && (desiredPipeline == m_pointPipelineCutout || desiredPipeline == m_pointPipelineSkinnedCutout)) {
-                    BindShadowAlpha(enc, material, m_alphaSampler);
-                }
-                enc->setVertexBytes(&objectUniforms, sizeof(ShadowObjectUniformsCPU), 1);
-                enc->setVertexBytes(&foliage, sizeof(ShadowFoliageParamsCPU), 3);
-                enc->drawIndexedPrimitives(MTL::PrimitiveTypeTriangle,
-                                           mesh->getIndices().size(),
-                                           MTL::IndexTypeUInt32,
-                                           static_cast<MTL::Buffer*>(mesh->getIndexBuffer()),
-                                           0);
-                ++faceDrawCount;
+            CasterPassParams params;
+            params.viewProj = proj * view;
+            params.pointLightPosNear = Math::Vector4(lightPos.x, lightPos.y, lightPos.z, s.depthRange.x);
+            params.pointFarParams = Math::Vector4(s.depthRange.y, 0.0f, 0.0f, 0.0f);
+            params.viewportX = 0.0;
+            params.viewportY = 0.0;
+            params.viewportSize = double(res);
+            params.pipeline = m_pointPipeline;
+            params.pipelineSkinned = m_pointPipelineSkinned;
+            params.pipelineCutout = m_pointPipelineCutout;
+            params.pipelineSkinnedCutout = m_pointPipelineSkinnedCutout;
+
+            ShadowViewTarget target;
+            target.texture = cubeTex;
+            // For cube arrays, slices are laid out as 6 faces per cube
+            target.slice = cubeIndex * 6 + face;
+            target.size = res;
+            target.clear = true;
+            const ShadowCacheKey cacheKey{prepared[i].light, static_cast<uint32_t>(face)};
+            if (!beginShadowView(cmdBuffer, cacheKey, target, prepared[i].shadowUpdateInterval, prepared[i].shadowRefresh)) {
+                continue;
             }
+            if (layered) {
+                queueLayeredView(cmdBuffer, cacheKey, target, params);
+                continue;
+            }
+            renderShadowView(cmdBuffer, cacheKey, target, params);
             if ((s_pointShadowDebugFrame % 120u) == 1u) {
                 std::cout << "[POINT SHADOW DEBUG] light=" << i
                           << " face=" << face
-                          << " drawCount=" << faceDrawCount
+                          << " drawCount=" << m_casters.size()
                           << std::endl;
             }
-            
-            enc->endEncoding();
-            rp->release();
         }
-        
+        if (layered && !m_layeredViews.empty()) {
+            const Math::Vector3 lightPos = prepared[i].positionWS;
+            CasterPassParams layeredParams;
+            layeredParams.pointLightPosNear = Math::Vector4(lightPos.x, lightPos.y, lightPos.z, s.depthRange.x);
+            layeredParams.pointFarParams = Math::Vector4(s.depthRange.y, 0.0f, 0.0f, 0.0f);
+            layeredParams.viewportSize = double(res);
+            layeredParams.pipeline = m_pointPipelineLayered;
+            layeredParams.pipelineSkinned = m_pointPipelineLayeredSkinned;
+            layeredParams.pipelineCutout = m_pointPipelineLayeredCutout;
+            layeredParams.pipelineSkinnedCutout = m_pointPipelineLayeredSkinnedCutout;
+            flushLayeredViews(cmdBuffer, layeredParams, cubeIndex * 6, 6);
+            m_layeredViews.clear();
+        }
+        if (m_casterDrawCount != drawsBefore) {
+            m_viewDrawCounts[ShadowAtlas::MakeKey(prepared[i].light, 0)] = static_cast<uint32_t>(m_casterDrawCount - drawsBefore);
+            m_lightDrawCounts[prepared[i].light] += static_cast<uint32_t>(m_casterDrawCount - drawsBefore);
+        }
     }
 }
 
@@ -2,10 +2,18 @@
 
 #include "../Math/Math.hpp"
 #include "LightingSystem.hpp"
+#include "SkinningCache.hpp"
+#include "GPUPassProfiler.hpp"
+#include "UniformRing.hpp"
+#include "TerrainSystem.hpp"
+#include "../Core/FrameArena.hpp"
+#include "../Core/MemoryTracker.hpp"
+#include "../ECS/EntityBitset.hpp"
 #include <array>
 #include <vector>
 #include <memory>
 #include <cstddef>
+#include <unordered_map>
 #include <unordered_set>
 #include <string>
 
@@ -13,6 +21,9 @@ namespace MTL {
     class Device;
     class CommandBuffer;
     class RenderCommandEncoder;
+    class ComputeCommandEncoder;
+    class BlitCommandEncoder;
+    class RenderPassDescriptor;
     class Texture;
     class Buffer;
     class DepthStencilState;
@@ -24,9 +35,21 @@ namespace MTL {
 namespace Crescent {
 
 class Scene;
+class HLODSwitch;
 class Camera;
 class Mesh;
 class Material;
+struct MeshRenderProxy;
+
+// Matches VertexAnimationParams in Common.metal.h.
+struct VertexAnimationParamsGPU {
+    Math::Vector4 boundsMin;    // w scene time in seconds
+    Math::Vector4 boundsExtent; // w clip duration in seconds
+    uint32_t vertexColumns = 0;
+    uint32_t rowsPerFrame = 0;
+    uint32_t frameCount = 0;
+    uint32_t looping = 0;
+};
 
 struct InstancedShadowDraw {
     Mesh* mesh = nullptr;
@@ -37,6 +60,16 @@ struct InstancedShadowDraw {
     Math::Vector3 boundsCenter = Math::Vector3::Zero;
     Math::Vector3 boundsSize = Math::Vector3::Zero;
     bool isBillboard = false;
+    // CrowdAnimation palettes when the batch is a skinned crowd; instances index it from their data.
+    MTL::Buffer* bonePalette = nullptr;
+    // Baked vertex animation (VertexAnimationTexture) the batch plays instead of its vertex stream.
+    MTL::Texture* vertexAnimation = nullptr;
+    VertexAnimationParamsGPU vertexAnimationParams;
+    // Terrain patches (TerrainSystem) displaced from this clipmap; they were selected for one sun
+    // cascade, the index into LightingSystem::getCascades(), and draw only into it.
+    MTL::Texture* terrainHeights = nullptr;
+    TerrainParamsGPU terrainParams;
+    int32_t shadowCascade = -1;
 };
 
 // Handles rendering shadow maps into atlas textures using LightingSystem prepared data.
@@ -48,25 +81,270 @@ public:
     
     bool initialize(MTL::Device* device, uint32_t atlasResolution, uint32_t atlasLayers = 1);
     void shutdown();
+    // Recreates only the atlas texture; pipelines and shadow caches stay alive.
+    bool resizeAtlas(uint32_t atlasResolution, uint32_t atlasLayers = 1);
     
     // Runs shadow rendering for the frame. Expects LightingSystem::beginFrame already called.
     void execute(MTL::CommandBuffer* cmdBuffer,
                  Scene* scene,
                  Camera* camera,
                  const LightingSystem& lighting,
-                 const std::vector<InstancedShadowDraw>& instancedDraws);
+                 const FrameVector<InstancedShadowDraw>& instancedDraws);
     void setFrameSlot(uint32_t frameSlot);
+    // Main view LOD inputs (see Mesh::selectLod); casters draw one level coarser than the view.
+    void setLodSelection(const Math::Vector4& lodView, float pixelError);
+    // Casters found in the (already dispatched) cache draw through the static pipelines.
+    void setSkinningCache(const SkinningCache* cache) { m_skinningCache = cache; }
+    // Times the directional, local and point light passes separately.
+    void setPassProfiler(GPUPassProfiler* profiler) { m_passProfiler = profiler; }
+    // Per-caster uniforms go through the frame's ring when set; null passes them inline.
+    void setUniformRing(UniformRing* ring) { m_uniformRing = ring; }
 
-    void setExtraHiddenEntities(const std::unordered_set<std::string>& hidden);
+    // Dense indices (Entity::getIndex) of entities the pass skips this frame.
+    void setExtraHiddenEntities(const FrameVector<uint32_t>& hidden, uint32_t entityIndexCount);
     
     // Atlas texture exposed to main renderer for sampling.
     MTL::Texture* getShadowAtlas() const { return m_shadowAtlas; }
+    // RG32Float min/max depth mips of the atlas (shadow_bounds_* in Shadow.metal), rebuilt at the
+    // end of every execute(). Null when the kernels are missing or the atlas is layered.
+    MTL::Texture* getDepthBounds() const { return hasDepthBounds() ? m_depthBounds : nullptr; }
+    bool hasDepthBounds() const {
+        return m_depthBounds && m_boundsInitPipeline && m_boundsDownsamplePipeline && !m_depthBoundsMips.empty();
+    }
     const std::vector<MTL::Texture*>& getPointCubeTextures() const { return m_pointCubeTextures; }
+
+    // Sub-encoders recorded on job workers during the last execute().
+    size_t getParallelEncoderCount() const { return m_parallelEncoderCount; }
+    // Shadow views (cascades, local tiles, cube faces) of the last execute() whose static casters
+    // came from the cache, and those whose cache had to be re-rendered.
+    size_t getCachedViewCount() const { return m_cachedViewCount; }
+    size_t getRefreshedViewCount() const { return m_refreshedViewCount; }
+    // Pages of paged cascades (Light::getShadowPageCache) reused and re-rendered in the last execute().
+    size_t getCachedPageCount() const { return m_cachedPageCount; }
+    size_t getRenderedPageCount() const { return m_renderedPageCount; }
+    // Time-sliced views of the last execute() copied from their previous refresh instead of drawn.
+    size_t getRestoredViewCount() const { return m_restoredViewCount; }
+    // Caster draws per view rendered in the last execute(), keyed like LightingSystem's update
+    // schedule (ShadowAtlas::MakeKey with cascade index + 1, or 0 for local and point lights). A
+    // layered cascade draw counts for every cascade it covers.
+    const std::unordered_map<uint64_t, uint32_t>& getViewDrawCounts() const { return m_viewDrawCounts; }
+    // Caster draws per light in the last execute(), summed over its cascades or cube faces; a
+    // layered draw covering several of them counts once.
+    const std::unordered_map<const Light*, uint32_t>& getLightDrawCounts() const { return m_lightDrawCounts; }
+    // Bone palette bytes the casters uploaded in the last execute().
+    size_t getSkinningBytesUploaded() const { return m_casterSkinningBytes; }
     
 private:
+    // Caster gathered once per execute() and shared by every cascade, local light and cube face.
+    struct ShadowCaster {
+        Mesh* mesh = nullptr;
+        std::shared_ptr<Material> material;
+        Math::Matrix4x4 modelMatrix;
+        MTL::Buffer* skinWeightBuffer = nullptr;
+        const std::vector<Math::Matrix4x4>* boneMatrices = nullptr;
+        size_t skinningOffset = 0;
+        const SkinningCache::Entry* skinCache = nullptr;
+        uint32_t lod = 0;
+        // Static casters are drawn into the per-view caches; contentHash covers everything that
+        // ends up in their depth.
+        bool isStatic = false;
+        uint64_t contentHash = 0;
+    };
+
+    // Last seen transform of a caster; casters still this many frames count as static.
+    static constexpr uint32_t kStaticSettleFrames = 8;
+    struct CasterHistory {
+        Math::Matrix4x4 modelMatrix;
+        uint32_t stillFrames = 0;
+        uint64_t lastSeenFrame = 0;
+    };
+
+    // Depth of the static casters of one shadow view, copied into the atlas or cube slice each
+    // frame before the dynamic casters are drawn over it.
+    struct ShadowCacheKey {
+        const Light* light = nullptr;
+        uint32_t view = 0; // cascade index or cube face
+        bool operator==(const ShadowCacheKey& other) const { return light == other.light && view == other.view; }
+    };
+    struct ShadowCacheKeyHash {
+        size_t operator()(const ShadowCacheKey& key) const {
+            return std::hash<const void*>()(key.light) ^ (static_cast<size_t>(key.view) * 0x9e3779b97f4a7c15ULL);
+        }
+    };
+    struct ShadowCacheEntry {
+        MTL::Texture* texture = nullptr;
+        uint64_t contentHash = 0;
+        uint64_t lastUsedFrame = 0;
+        bool valid = false;
+    };
+    static constexpr size_t kMaxShadowCacheBytes = 256ull * 1024ull * 1024ull;
+    static constexpr uint64_t kShadowCacheEvictFrames = 120;
+
+    // Toroidal page cache of a paged cascade: absolute page (x, y) lives in slot (x mod N, y mod N),
+    // so a camera move only re-renders the pages that scrolled in.
+    struct ShadowPageSlot {
+        int32_t pageX = 0;
+        int32_t pageY = 0;
+        uint64_t contentHash = 0;
+        bool valid = false;
+    };
+    struct ShadowPageCache {
+        MTL::Texture* texture = nullptr;
+        uint64_t frameHash = 0;
+        uint64_t lastUsedFrame = 0;
+        std::vector<ShadowPageSlot> slots;
+    };
+    struct ShadowPageDraw {
+        uint32_t page = 0; // tile-local page index
+        uint32_t caster = 0;
+    };
+
+    // Render target of one shadow view.
+    struct ShadowViewTarget {
+        MTL::Texture* texture = nullptr;
+        uint32_t slice = 0;
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t size = 0;
+        bool clear = false; // atlas tiles are cleared once per frame, cube faces per view
+    };
+
+    // Last refresh of a time-sliced view, copied back on the frames LightingSystem defers it.
+    struct ShadowHistoryEntry {
+        MTL::Texture* texture = nullptr;
+        uint64_t lastUsedFrame = 0;
+        uint64_t restoredFrame = 0;
+        bool valid = false;
+    };
+    struct ShadowHistoryCapture {
+        ShadowCacheKey key;
+        ShadowViewTarget target;
+    };
+
+    struct ShadowCullView {
+        ShadowCacheKey key;
+        Math::Matrix4x4 viewProj;
+        Math::FrustumPlanes planes;
+    };
+
+    struct CasterPassParams {
+        Math::Matrix4x4 viewProj;
+        Math::Vector4 pointLightPosNear = Math::Vector4::Zero;
+        Math::Vector4 pointFarParams = Math::Vector4::Zero;
+        double viewportX = 0.0;
+        double viewportY = 0.0;
+        double viewportSize = 0.0;
+        MTL::RenderPipelineState* pipeline = nullptr;
+        MTL::RenderPipelineState* pipelineSkinned = nullptr;
+        MTL::RenderPipelineState* pipelineCutout = nullptr;
+        MTL::RenderPipelineState* pipelineSkinnedCutout = nullptr;
+        // Layered passes draw every view in m_layeredViews at once: casterViewMasks (parallel to
+        // the caster list) holds the views each caster overlaps, their slices counted from
+        // baseSlice.
+        const std::vector<uint8_t>* casterViewMasks = nullptr;
+        uint32_t baseSlice = 0;
+    };
+
+    // View queued for the next layered pass, with the caster draws it cost this frame.
+    static constexpr uint32_t kMaxLayeredViews = 6;
+    struct LayeredShadowView {
+        ShadowCacheKey key;
+        ShadowViewTarget target;
+        Math::Matrix4x4 viewProj;
+        bool filled = false; // the cached static casters were copied in already
+        uint32_t draws = 0;        // casters drawn into it, counting its cache refresh
+        uint32_t submissions = 0;  // draws it issued; layered draws count for their first view
+    };
+
     void buildPipelines();
     void buildDepthState();
     bool allocateSkinningSlice(size_t bytes, size_t& outOffset);
+    void gatherCasters(Scene* scene);
+    void renderCasters(MTL::CommandBuffer* cmdBuffer,
+                       MTL::RenderPassDescriptor* rp,
+                       const CasterPassParams& params,
+                       const std::vector<uint32_t>& casterIndices);
+    void encodeCasters(MTL::RenderCommandEncoder* enc,
+                       const CasterPassParams& params,
+                       const std::vector<uint32_t>& casterIndices,
+                       size_t begin,
+                       size_t end,
+                       GPUPassWork& work) const;
+    // viewMask selects the layered views the caster is amplified into; 0 outside layered passes.
+    void encodeCaster(MTL::RenderCommandEncoder* enc,
+                      const CasterPassParams& params,
+                      const ShadowCaster& caster,
+                      uint32_t viewMask,
+                      MTL::RenderPipelineState*& currentPipeline,
+                      UniformRing::Binder& uniforms,
+                      GPUPassWork& work) const;
+    // Reports the draws and binds of one encoded range under the pass being rendered.
+    void recordCasterWork(GPUPass pass, const GPUPassWork& work) const;
+    bool createAtlas();
+    // The depth bounds chain sized for the current atlas; released for layered atlases.
+    void createDepthBounds();
+    void releaseDepthBounds();
+    void buildDepthBounds(MTL::CommandBuffer* cmdBuffer);
+    // Collects every shadow view rendered this frame and culls all casters against all of them
+    // in one parallel pass; classifyViewCasters() then reads the per-view lists.
+    void cullShadowViews(const LightingSystem& lighting);
+    void addCullView(const ShadowCacheKey& key, const Math::Matrix4x4& viewProj);
+    // Splits the casters overlapping the view frustum into m_viewStaticCasters/m_viewDynamicCasters.
+    void classifyViewCasters(const ShadowCacheKey& key, const CasterPassParams& params);
+    void renderShadowView(MTL::CommandBuffer* cmdBuffer,
+                          const ShadowCacheKey& cacheKey,
+                          const ShadowViewTarget& target,
+                          const CasterPassParams& params);
+    // Classifies the view's casters and copies its cached static casters into target, returning
+    // true on a cache hit. m_viewDynamicCasters is left holding what still has to be drawn, which
+    // is every caster when the view has no cache.
+    bool resolveShadowViewCache(MTL::CommandBuffer* cmdBuffer,
+                                const ShadowCacheKey& cacheKey,
+                                const ShadowViewTarget& target,
+                                const CasterPassParams& params);
+    // Layered rendering: views of one texture are queued (their caches resolved right away) and
+    // flushed as a single pass, each caster drawn once for all the queued views it overlaps.
+    // params supplies the layered pipelines; the pass covers sliceCount slices from baseSlice.
+    void queueLayeredView(MTL::CommandBuffer* cmdBuffer,
+                          const ShadowCacheKey& cacheKey,
+                          const ShadowViewTarget& target,
+                          const CasterPassParams& params);
+    void flushLayeredViews(MTL::CommandBuffer* cmdBuffer,
+                           const CasterPassParams& params,
+                           uint32_t baseSlice,
+                           uint32_t sliceCount);
+    void renderCasterList(MTL::CommandBuffer* cmdBuffer,
+                          const ShadowViewTarget& target,
+                          bool clear,
+                          const CasterPassParams& params,
+                          const std::vector<uint32_t>& casterIndices);
+    // Returns false when the cascade cannot be paged and should go through renderShadowView.
+    bool renderShadowPages(MTL::CommandBuffer* cmdBuffer,
+                           const ShadowCacheKey& cacheKey,
+                           const ShadowViewTarget& target,
+                           const CasterPassParams& params,
+                           const CascadedSlice& slice);
+    bool ensureClearPage(MTL::CommandBuffer* cmdBuffer, uint32_t pageSize);
+    // Views updating every interval > 1 frames: restores the last refresh into target and returns
+    // false when the view is not due, otherwise queues a history capture and returns true.
+    bool beginShadowView(MTL::CommandBuffer* cmdBuffer,
+                         const ShadowCacheKey& key,
+                         const ShadowViewTarget& target,
+                         uint32_t interval,
+                         bool refresh);
+    bool wasShadowViewRestored(const ShadowCacheKey& key) const;
+    // Copies this frame's refreshed time-sliced views into their history, after instanced draws.
+    void captureShadowHistory(MTL::CommandBuffer* cmdBuffer);
+    // (Re)allocates texture at size x size within the cache budget; null when over budget.
+    MTL::Texture* acquireCacheTexture(MTL::Texture*& texture, uint32_t size);
+    void releaseCacheTexture(MTL::Texture*& texture);
+    void releaseShadowCache();
+    void updateMemoryUsage();
+    void evictShadowCache();
+    // Encoders of the light type being rendered, timed as m_profiledPass.
+    MTL::RenderCommandEncoder* beginRenderEncoder(MTL::CommandBuffer* cmdBuffer, MTL::RenderPassDescriptor* rp);
+    MTL::ComputeCommandEncoder* beginComputeEncoder(MTL::CommandBuffer* cmdBuffer);
+    MTL::BlitCommandEncoder* beginBlitEncoder(MTL::CommandBuffer* cmdBuffer);
     void renderDirectional(MTL::CommandBuffer* cmdBuffer, Scene* scene, const LightingSystem& lighting);
     void renderLocal(MTL::CommandBuffer* cmdBuffer, Scene* scene, const LightingSystem& lighting);
     void renderPointCubes(MTL::CommandBuffer* cmdBuffer, Scene* scene, const LightingSystem& lighting);
@@ -75,7 +353,11 @@ private:
                               const ShadowAtlasTile& tile,
                               MTL::RenderPipelineState* pipeline,
                               MTL::RenderPipelineState* pipelineCutout,
-                              const std::vector<InstancedShadowDraw>& instancedDraws);
+                              MTL::RenderPipelineState* pipelineSkinned,
+                              MTL::RenderPipelineState* pipelineVat,
+                              MTL::RenderPipelineState* pipelineTerrain,
+                              int32_t cascade,
+                              const FrameVector<InstancedShadowDraw>& instancedDraws);
     void renderInstancedCubeFace(MTL::CommandBuffer* cmdBuffer,
                                  MTL::Texture* target,
                                  uint32_t slice,
@@ -85,17 +367,20 @@ private:
                                  const Math::Vector4* pointFarParams,
                                  MTL::RenderPipelineState* pipeline,
                                  MTL::RenderPipelineState* pipelineCutout,
-                                 const std::vector<InstancedShadowDraw>& instancedDraws);
+                                 MTL::RenderPipelineState* pipelineSkinned,
+                                 MTL::RenderPipelineState* pipelineVat,
+                                 const FrameVector<InstancedShadowDraw>& instancedDraws);
     
     void renderLightRange(MTL::CommandBuffer* cmdBuffer,
                           Scene* scene,
+                          const PreparedLight& prepared,
                           const ShadowGPUData& shadow,
                           const ShadowAtlasTile& tile,
                           MTL::RenderPipelineState* pipeline,
                           MTL::RenderPipelineState* pipelineSkinned,
                           MTL::RenderPipelineState* pipelineCutout,
                           MTL::RenderPipelineState* pipelineSkinnedCutout);
-    bool shouldSkipEntity(Entity* entity) const;
+    bool shouldSkipEntity(const MeshRenderProxy& proxy) const;
     
 private:
     MTL::Device* m_device;
@@ -126,6 +411,30 @@ private:
     MTL::RenderPipelineState* m_spotPipelineInstancedCutout;
     MTL::RenderPipelineState* m_pointPipelineInstancedCutout;
     MTL::RenderPipelineState* m_areaPipelineInstancedCutout;
+    MTL::RenderPipelineState* m_dirPipelineInstancedSkinned;
+    MTL::RenderPipelineState* m_spotPipelineInstancedSkinned;
+    MTL::RenderPipelineState* m_pointPipelineInstancedSkinned;
+    MTL::RenderPipelineState* m_areaPipelineInstancedSkinned;
+    MTL::RenderPipelineState* m_dirPipelineInstancedVat;
+    MTL::RenderPipelineState* m_spotPipelineInstancedVat;
+    MTL::RenderPipelineState* m_pointPipelineInstancedVat;
+    MTL::RenderPipelineState* m_areaPipelineInstancedVat;
+    MTL::RenderPipelineState* m_dirPipelineInstancedTerrain;
+    // Vertex-amplified pipelines of the layered passes; null when the device cannot amplify.
+    MTL::RenderPipelineState* m_dirPipelineLayered = nullptr;
+    MTL::RenderPipelineState* m_dirPipelineLayeredSkinned = nullptr;
+    MTL::RenderPipelineState* m_dirPipelineLayeredCutout = nullptr;
+    MTL::RenderPipelineState* m_dirPipelineLayeredSkinnedCutout = nullptr;
+    MTL::RenderPipelineState* m_pointPipelineLayered = nullptr;
+    MTL::RenderPipelineState* m_pointPipelineLayeredSkinned = nullptr;
+    MTL::RenderPipelineState* m_pointPipelineLayeredCutout = nullptr;
+    MTL::RenderPipelineState* m_pointPipelineLayeredSkinnedCutout = nullptr;
+    // Views one amplified draw can cover; casters overlapping more split over several draws.
+    uint32_t m_maxAmplification = 1;
+    MTL::ComputePipelineState* m_boundsInitPipeline = nullptr;
+    MTL::ComputePipelineState* m_boundsDownsamplePipeline = nullptr;
+    MTL::Texture* m_depthBounds = nullptr;
+    std::vector<MTL::Texture*> m_depthBoundsMips; // one 2D view per level
     MTL::ComputePipelineState* m_instanceCullPipeline;
     MTL::ComputePipelineState* m_instanceIndirectPipeline;
     MTL::Buffer* m_instanceCullBuffer;
@@ -139,6 +448,12 @@ private:
     size_t m_skinningBufferCapacity;
     size_t m_skinningBufferOffset;
     uint32_t m_frameSlot;
+    Math::Vector4 m_lodView = Math::Vector4::Zero;
+    float m_lodPixelError = 1.0f;
+    const SkinningCache* m_skinningCache = nullptr;
+    GPUPassProfiler* m_passProfiler = nullptr;
+    UniformRing* m_uniformRing = nullptr;
+    GPUPass m_profiledPass = GPUPass::ShadowDirectional;
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_skinningBuffers{};
     std::array<size_t, kMaxFramesInFlight> m_skinningBufferCapacities{};
     std::array<MTL::Buffer*, kMaxFramesInFlight> m_instanceCullBuffers{};
@@ -148,9 +463,56 @@ private:
     std::array<size_t, kMaxFramesInFlight> m_instanceCountCapacities{};
     std::array<size_t, kMaxFramesInFlight> m_instanceIndirectCapacities{};
 
-    std::unordered_set<std::string> m_hlodHidden;
-    std::unordered_set<std::string> m_hlodActiveProxies;
-    std::unordered_set<std::string> m_extraHidden;
+    // The scene's HLOD switch for this frame's camera, and the static entities drawn on the GPU,
+    // rebuilt every frame keeping its capacity.
+    const HLODSwitch* m_hlodSwitch = nullptr;
+    EntityBitset<> m_extraHidden;
+
+    std::vector<ShadowCaster> m_casters;
+    MTL::Buffer* m_casterSkinningBuffer = nullptr;
+    size_t m_casterSkinningBase = 0;
+    size_t m_parallelEncoderCount = 0;
+    // Per-view caster lists; reused by every view.
+    std::vector<uint32_t> m_viewStaticCasters;
+    std::vector<uint32_t> m_viewDynamicCasters;
+    std::vector<Math::Vector4> m_casterSpheres; // parallel to m_casters
+    std::vector<uint8_t> m_casterVisible;
+    // Batched cull: one bit per caster per view, then the caster list of every view.
+    std::vector<ShadowCullView> m_cullViews;
+    std::unordered_map<ShadowCacheKey, uint32_t, ShadowCacheKeyHash> m_cullViewIndex;
+    std::vector<uint64_t> m_casterViewMasks; // m_cullMaskWords words per caster
+    size_t m_cullMaskWords = 0;
+    std::vector<std::vector<uint32_t>> m_cullViewCasters; // parallel to m_cullViews
+    // Layered pass being gathered: its views, the casters overlapping any of them and their view
+    // masks. m_casterLayeredMasks is indexed by caster and zero between passes.
+    std::vector<LayeredShadowView> m_layeredViews;
+    std::vector<uint32_t> m_layeredCasters;
+    std::vector<uint8_t> m_layeredCasterMasks; // parallel to m_layeredCasters
+    std::vector<uint8_t> m_casterLayeredMasks;
+
+    std::unordered_map<uint64_t, CasterHistory> m_casterHistory;
+    std::unordered_map<ShadowCacheKey, ShadowCacheEntry, ShadowCacheKeyHash> m_shadowCache;
+    std::unordered_map<ShadowCacheKey, ShadowPageCache, ShadowCacheKeyHash> m_shadowPageCaches;
+    std::unordered_map<ShadowCacheKey, ShadowHistoryEntry, ShadowCacheKeyHash> m_shadowHistory;
+    std::vector<ShadowHistoryCapture> m_historyCaptures;
+    std::unordered_map<uint64_t, uint32_t> m_viewDrawCounts;
+    std::unordered_map<const Light*, uint32_t> m_lightDrawCounts;
+    size_t m_casterSkinningBytes = 0;
+    size_t m_casterDrawCount = 0; // running count; views take the difference
+    MTL::Texture* m_clearPage = nullptr; // cleared once; copied over dirty page slots
+    size_t m_shadowCacheBytes = 0;
+    TrackedMemory m_memory; // recounted once per frame by updateMemoryUsage
+    uint64_t m_frameIndex = 0;
+    size_t m_cachedViewCount = 0;
+    size_t m_refreshedViewCount = 0;
+    size_t m_cachedPageCount = 0;
+    size_t m_renderedPageCount = 0;
+    size_t m_restoredViewCount = 0;
+    // Per paged-view scratch; reused by every view.
+    std::vector<uint64_t> m_pageHashes;
+    std::vector<uint8_t> m_pageDirty;
+    std::vector<std::array<int32_t, 4>> m_viewCasterPages; // parallel to m_viewStaticCasters
+    std::vector<ShadowPageDraw> m_pageDraws;
     
     uint32_t m_atlasResolution;
     uint32_t m_atlasLayers;
@@ -0,0 +1,229 @@
+#include "SkinningCache.hpp"
+#include "ShaderLibrary.hpp"
+#include "GeometryBuffer.hpp"
+#include "../Rendering/Mesh.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    // Matches SkinningParams in PBR.metal.
+    struct SkinningParamsGPU {
+        uint32_t vertexCount;
+        uint32_t _pad0;
+        uint32_t _pad1;
+        uint32_t _pad2;
+    };
+    static_assert(sizeof(SkinningParamsGPU) == 16, "SkinningParamsGPU must match the Metal layout");
+
+    constexpr size_t kPositionStride = sizeof(float) * 3;
+    constexpr size_t kAttributeStride = 20;
+    constexpr size_t kMinStreamBytes = 1u << 20;
+    constexpr size_t kMinBoneBytes = 64u * 1024u;
+
+    size_t AlignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    size_t GrowCapacity(size_t current, size_t required, size_t minimum) {
+        size_t capacity = std::max(current, minimum);
+        while (capacity < required) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+}
+
+SkinningCache::SkinningCache()
+    : m_device(nullptr)
+    , m_pipeline(nullptr)
+    , m_frameSlot(0) {
+}
+
+SkinningCache::~SkinningCache() {
+    shutdown();
+}
+
+bool SkinningCache::initialize(MTL::Device* device) {
+    m_device = device;
+    if (!m_device) {
+        return false;
+    }
+
+    NS::Error* error = nullptr;
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_device, ShaderLibrary::Module::Core);
+    if (!lib) {
+        std::cerr << "SkinningCache: missing default Metal library\n";
+        return false;
+    }
+
+    MTL::Function* func = lib->newFunction(NS::String::string("skin_vertices", NS::UTF8StringEncoding));
+    if (!func) {
+        std::cerr << "SkinningCache: missing skin_vertices shader\n";
+        lib->release();
+        return false;
+    }
+
+    m_pipeline = m_device->newComputePipelineState(func, &error);
+    func->release();
+    lib->release();
+
+    if (!m_pipeline) {
+        if (error) {
+            std::cerr << "SkinningCache: pipeline error " << error->localizedDescription()->utf8String() << "\n";
+        }
+        return false;
+    }
+    return true;
+}
+
+void SkinningCache::shutdown() {
+    for (Slot& slot : m_slots) {
+        if (slot.streams) { slot.streams->release(); slot.streams = nullptr; }
+        if (slot.bones) { slot.bones->release(); slot.bones = nullptr; }
+        slot.jobs.clear();
+        slot.lookup.clear();
+        slot.streamBytes = 0;
+        slot.boneBytes = 0;
+        slot.dispatched = false;
+        slot.memory.reset();
+    }
+    if (m_pipeline) { m_pipeline->release(); m_pipeline = nullptr; }
+    m_device = nullptr;
+}
+
+void SkinningCache::beginFrame(uint32_t frameSlot) {
+    m_frameSlot = frameSlot % kMaxFramesInFlight;
+    Slot& slot = m_slots[m_frameSlot];
+    slot.jobs.clear();
+    slot.lookup.clear();
+    slot.streamBytes = 0;
+    slot.boneBytes = 0;
+    slot.dispatched = false;
+}
+
+bool SkinningCache::add(const MeshRenderer* renderer,
+                        const Mesh& mesh,
+                        const std::vector<Math::Matrix4x4>& bones,
+                        const std::vector<Math::Matrix4x4>& previousBones) {
+    if (!m_pipeline || !renderer || bones.empty()) {
+        return false;
+    }
+    Slot& slot = m_slots[m_frameSlot];
+    if (slot.dispatched || slot.lookup.count(renderer) > 0) {
+        return false;
+    }
+    if (!mesh.getVertexBuffer() || !mesh.getAttributeBuffer() || !mesh.getSkinWeightBuffer()) {
+        return false;
+    }
+    const uint32_t vertexCount = static_cast<uint32_t>(mesh.getVertexCount());
+    if (vertexCount == 0) {
+        return false;
+    }
+
+    const std::vector<Math::Matrix4x4>& previous =
+        previousBones.size() == bones.size() ? previousBones : bones;
+    const size_t paletteBytes = bones.size() * sizeof(Math::Matrix4x4);
+
+    Job job;
+    job.mesh = &mesh;
+    job.bones = &bones;
+    job.previousBones = &previous;
+    job.vertexCount = vertexCount;
+    job.boneOffset = AlignUp(slot.boneBytes, GeometryBuffer::kAlignment);
+    job.previousBoneOffset = AlignUp(job.boneOffset + paletteBytes, GeometryBuffer::kAlignment);
+    slot.boneBytes = job.previousBoneOffset + paletteBytes;
+
+    job.entry.positionOffset = AlignUp(slot.streamBytes, GeometryBuffer::kAlignment);
+    job.entry.attributeOffset = AlignUp(job.entry.positionOffset + vertexCount * kPositionStride,
+                                        GeometryBuffer::kAlignment);
+    job.entry.previousPositionOffset = AlignUp(job.entry.attributeOffset + vertexCount * kAttributeStride,
+                                               GeometryBuffer::kAlignment);
+    slot.streamBytes = job.entry.previousPositionOffset + vertexCount * kPositionStride;
+
+    slot.lookup.emplace(renderer, slot.jobs.size());
+    slot.jobs.push_back(job);
+    return true;
+}
+
+void SkinningCache::dispatch(MTL::CommandBuffer* cmdBuffer) {
+    Slot& slot = m_slots[m_frameSlot];
+    if (!cmdBuffer || !m_pipeline || slot.dispatched || slot.jobs.empty()) {
+        return;
+    }
+
+    // The slot's previous command buffer has completed (beginFrame), so its buffers can be
+    // replaced or rewritten in place.
+    if (!slot.streams || slot.streams->length() < slot.streamBytes) {
+        size_t capacity = GrowCapacity(slot.streams ? slot.streams->length() : 0, slot.streamBytes, kMinStreamBytes);
+        if (slot.streams) { slot.streams->release(); }
+        slot.streams = m_device->newBuffer(capacity, MTL::ResourceStorageModePrivate);
+        if (slot.streams) {
+            slot.streams->setLabel(NS::String::string("Skinning Cache", NS::UTF8StringEncoding));
+        }
+    }
+    if (!slot.bones || slot.bones->length() < slot.boneBytes) {
+        size_t capacity = GrowCapacity(slot.bones ? slot.bones->length() : 0, slot.boneBytes, kMinBoneBytes);
+        if (slot.bones) { slot.bones->release(); }
+        slot.bones = m_device->newBuffer(capacity, MTL::ResourceStorageModeShared);
+    }
+    slot.memory.reset(MemoryCategory::Skinning, (slot.streams ? slot.streams->length() : 0)
+                                                + (slot.bones ? slot.bones->length() : 0));
+    if (!slot.streams || !slot.bones) {
+        slot.jobs.clear();
+        slot.lookup.clear();
+        return;
+    }
+
+    uint8_t* boneData = static_cast<uint8_t*>(slot.bones->contents());
+    for (const Job& job : slot.jobs) {
+        const size_t paletteBytes = job.bones->size() * sizeof(Math::Matrix4x4);
+        std::memcpy(boneData + job.boneOffset, job.bones->data(), paletteBytes);
+        std::memcpy(boneData + job.previousBoneOffset, job.previousBones->data(), paletteBytes);
+    }
+
+    MTL::ComputeCommandEncoder* enc = cmdBuffer->computeCommandEncoder();
+    enc->setLabel(NS::String::string("Skinning Cache", NS::UTF8StringEncoding));
+    enc->setComputePipelineState(m_pipeline);
+    const NS::UInteger threadWidth = std::min<NS::UInteger>(64, m_pipeline->maxTotalThreadsPerThreadgroup());
+    for (Job& job : slot.jobs) {
+        const Mesh& mesh = *job.mesh;
+        enc->setBuffer(static_cast<MTL::Buffer*>(mesh.getVertexBuffer()), mesh.getVertexBufferOffset(), 0);
+        enc->setBuffer(static_cast<MTL::Buffer*>(mesh.getAttributeBuffer()), mesh.getAttributeBufferOffset(), 1);
+        enc->setBuffer(static_cast<MTL::Buffer*>(mesh.getSkinWeightBuffer()), mesh.getSkinWeightBufferOffset(), 2);
+        enc->setBuffer(slot.bones, job.boneOffset, 3);
+        enc->setBuffer(slot.bones, job.previousBoneOffset, 4);
+        enc->setBuffer(slot.streams, job.entry.positionOffset, 5);
+        enc->setBuffer(slot.streams, job.entry.attributeOffset, 6);
+        enc->setBuffer(slot.streams, job.entry.previousPositionOffset, 7);
+        SkinningParamsGPU params{job.vertexCount, 0, 0, 0};
+        enc->setBytes(&params, sizeof(params), 8);
+        enc->dispatchThreads(MTL::Size(job.vertexCount, 1, 1), MTL::Size(threadWidth, 1, 1));
+        job.entry.buffer = slot.streams;
+    }
+    enc->endEncoding();
+    slot.dispatched = true;
+}
+
+const SkinningCache::Entry* SkinningCache::find(const MeshRenderer* renderer) const {
+    const Slot& slot = m_slots[m_frameSlot];
+    if (!slot.dispatched || !renderer) {
+        return nullptr;
+    }
+    auto it = slot.lookup.find(renderer);
+    if (it == slot.lookup.end()) {
+        return nullptr;
+    }
+    const Entry& entry = slot.jobs[it->second].entry;
+    return entry.buffer ? &entry : nullptr;
+}
+
+void SkinningCache::BindVertexStreams(MTL::RenderCommandEncoder* encoder, const Entry& entry) {
+    encoder->setVertexBuffer(entry.buffer, entry.positionOffset, GeometryBuffer::kPositionBufferIndex);
+    encoder->setVertexBuffer(entry.buffer, entry.attributeOffset, GeometryBuffer::kAttributeBufferIndex);
+}
+
+} // namespace Crescent
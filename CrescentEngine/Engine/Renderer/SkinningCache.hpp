@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include "../Math/Math.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class CommandBuffer;
+    class ComputePipelineState;
+    class RenderCommandEncoder;
+    class Buffer;
+}
+
+namespace Crescent {
+
+class Mesh;
+class MeshRenderer;
+
+// Compute skinning pre-pass. Every skinned MeshRenderer that may be drawn this frame is skinned
+// once into a per-frame-slot cache laid out like the GeometryBuffer streams (float3 positions,
+// PackedVertexAttributes), plus last frame's positions for the prepass's motion vectors. The
+// prepass, main and shadow passes bind an entry's streams and draw the mesh through their static
+// pipelines instead of re-skinning it in every vertex shader.
+class SkinningCache {
+public:
+    static constexpr uint32_t kMaxFramesInFlight = 4;
+    // Vertex buffer slot of the previous-position stream in vertex_prepass_motion_cached.
+    static constexpr uint32_t kPreviousPositionBufferIndex = 6;
+
+    struct Entry {
+        MTL::Buffer* buffer = nullptr;
+        size_t positionOffset = 0;
+        size_t attributeOffset = 0;
+        size_t previousPositionOffset = 0;
+    };
+
+    SkinningCache();
+    ~SkinningCache();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_pipeline != nullptr; }
+
+    // Drops the entries of the slot's previous use; its command buffer must have completed.
+    void beginFrame(uint32_t frameSlot);
+    // Queues the renderer's uploaded, skin-weighted mesh. previousBones falls back to bones when its
+    // size does not match. The bone vectors must stay alive until dispatch().
+    bool add(const MeshRenderer* renderer,
+             const Mesh& mesh,
+             const std::vector<Math::Matrix4x4>& bones,
+             const std::vector<Math::Matrix4x4>& previousBones);
+    // Uploads the palettes and encodes one compute pass over every queued mesh. Entries are only
+    // returned by find() once dispatched.
+    void dispatch(MTL::CommandBuffer* cmdBuffer);
+    const Entry* find(const MeshRenderer* renderer) const;
+    size_t getEntryCount() const { return m_slots[m_frameSlot].jobs.size(); }
+
+    // Binds the entry's position and attribute streams where the static mesh pipelines read them.
+    static void BindVertexStreams(MTL::RenderCommandEncoder* encoder, const Entry& entry);
+
+private:
+    struct Job {
+        const Mesh* mesh = nullptr;
+        const std::vector<Math::Matrix4x4>* bones = nullptr;
+        const std::vector<Math::Matrix4x4>* previousBones = nullptr;
+        size_t boneOffset = 0;
+        size_t previousBoneOffset = 0;
+        uint32_t vertexCount = 0;
+        Entry entry;
+    };
+
+    struct Slot {
+        MTL::Buffer* streams = nullptr; // GPU-only skinned output
+        MTL::Buffer* bones = nullptr;   // current and previous palettes of every job
+        std::vector<Job> jobs;
+        std::unordered_map<const MeshRenderer*, size_t> lookup;
+        size_t streamBytes = 0;
+        size_t boneBytes = 0;
+        bool dispatched = false;
+        TrackedMemory memory; // streams and bones
+    };
+
+    MTL::Device* m_device;
+    MTL::ComputePipelineState* m_pipeline;
+    std::array<Slot, kMaxFramesInFlight> m_slots;
+    uint32_t m_frameSlot;
+};
+
+} // namespace Crescent
@@ -0,0 +1,330 @@
+#include "SkyAtmosphere.hpp"
+#include "ShaderLibrary.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    constexpr uint32_t kTransmittanceWidth = 256;
+    constexpr uint32_t kTransmittanceHeight = 64;
+    constexpr uint32_t kMultiScatteringSize = 32;
+    constexpr uint32_t kSkyViewWidth = 192;
+    constexpr uint32_t kSkyViewHeight = 108;
+    constexpr uint32_t kIrradianceSize = 32;
+    constexpr uint32_t kPrefilteredSize = 128;
+    // Roughness reaches mip 5, like MAX_REFLECTION_LOD in PBR.metal and IBLGenerator's cubemaps.
+    constexpr uint32_t kPrefilteredMips = 6;
+    constexpr uint32_t kIrradianceSamples = 256;
+    constexpr uint32_t kPrefilterSamples = 128;
+    constexpr uint32_t kBytesPerTexel = 8; // RGBA16Float
+    // Sun illuminance the sky is baked for; puts a midday zenith near the brightness of the skybox's
+    // gradient fallback.
+    constexpr float kSkyIlluminance = 24.0f;
+    // Re-bake the sky-view LUT once the sun has moved by about a tenth of a degree.
+    constexpr float kSunDirectionEpsilon = 0.999998f;
+    constexpr float kSunColorEpsilon = 1e-3f;
+
+    // Match Sky.metal; kilometres.
+    constexpr float kBottomRadius = 6360.0f;
+    constexpr float kTopRadius = 6460.0f;
+    constexpr float kViewRadius = 6360.2f;
+    constexpr float kRayleighScaleHeight = 8.0f;
+    constexpr float kMieExtinction = 4.440e-3f;
+    constexpr float kMieScaleHeight = 1.2f;
+    const Math::Vector3 kRayleighScattering(5.802e-3f, 13.558e-3f, 33.1e-3f);
+    const Math::Vector3 kOzoneAbsorption(0.650e-3f, 1.881e-3f, 0.085e-3f);
+    // sin(3 degrees)
+    constexpr float kMinSunElevation = 0.0523f;
+
+    MTL::ComputePipelineState* NewComputePipeline(MTL::Device* device, MTL::Library* lib, const char* name) {
+        MTL::Function* func = lib->newFunction(NS::String::string(name, NS::UTF8StringEncoding));
+        if (!func) {
+            std::cerr << "SkyAtmosphere: missing " << name << " shader\n";
+            return nullptr;
+        }
+        NS::Error* error = nullptr;
+        MTL::ComputePipelineState* pipeline = device->newComputePipelineState(func, &error);
+        func->release();
+        if (!pipeline && error) {
+            std::cerr << "SkyAtmosphere: " << name << " pipeline error "
+                      << error->localizedDescription()->utf8String() << "\n";
+        }
+        return pipeline;
+    }
+
+    void ReleasePipeline(MTL::ComputePipelineState*& pipeline) {
+        if (pipeline) {
+            pipeline->release();
+            pipeline = nullptr;
+        }
+    }
+
+    void ReleaseTexture(MTL::Texture*& texture) {
+        if (texture) {
+            texture->release();
+            texture = nullptr;
+        }
+    }
+
+    MTL::Texture* NewTexture(MTL::Device* device, MTL::TextureType type, uint32_t width, uint32_t height,
+                             uint32_t mips) {
+        MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+        desc->setTextureType(type);
+        desc->setPixelFormat(MTL::PixelFormatRGBA16Float);
+        desc->setWidth(width);
+        desc->setHeight(height);
+        desc->setMipmapLevelCount(mips);
+        desc->setStorageMode(MTL::StorageModePrivate);
+        desc->setUsage(MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
+        MTL::Texture* texture = device->newTexture(desc);
+        desc->release();
+        return texture;
+    }
+
+    void Dispatch(MTL::ComputeCommandEncoder* encoder, uint32_t width, uint32_t height) {
+        encoder->dispatchThreads(MTL::Size::Make(width, height, 1), MTL::Size::Make(8, 8, 1));
+    }
+
+    Math::Vector3 OpticalDepthToTop(const Math::Vector3& dir) {
+        const Math::Vector3 origin(0.0f, kViewRadius, 0.0f);
+        float b = origin.dot(dir);
+        float c = origin.dot(origin) - kTopRadius * kTopRadius;
+        float rayLength = -b + std::sqrt(std::max(b * b - c, 0.0f));
+
+        constexpr int kSteps = 32;
+        float dt = rayLength / static_cast<float>(kSteps);
+        Math::Vector3 depth(0.0f);
+        for (int i = 0; i < kSteps; ++i) {
+            Math::Vector3 p = origin + dir * ((static_cast<float>(i) + 0.5f) * dt);
+            float height = std::max(p.length() - kBottomRadius, 0.0f);
+            float rayleigh = std::exp(-height / kRayleighScaleHeight);
+            float mie = std::exp(-height / kMieScaleHeight);
+            float ozone = std::max(0.0f, 1.0f - std::abs(height - 25.0f) / 15.0f);
+            depth += (kRayleighScattering * rayleigh + Math::Vector3(kMieExtinction * mie)
+                      + kOzoneAbsorption * ozone) * dt;
+        }
+        return depth;
+    }
+}
+
+SkyAtmosphere::~SkyAtmosphere() {
+    shutdown();
+}
+
+bool SkyAtmosphere::initialize(MTL::Device* device) {
+    m_Device = device;
+    if (!m_Device) {
+        return false;
+    }
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_Device, ShaderLibrary::Module::Lighting);
+    if (!lib) {
+        std::cerr << "SkyAtmosphere: missing default Metal library\n";
+        return false;
+    }
+    m_TransmittancePipeline = NewComputePipeline(m_Device, lib, "sky_transmittance_lut");
+    m_MultiScatteringPipeline = NewComputePipeline(m_Device, lib, "sky_multiscattering_lut");
+    m_SkyViewPipeline = NewComputePipeline(m_Device, lib, "sky_view_lut");
+    m_PrefilterPipeline = NewComputePipeline(m_Device, lib, "sky_prefilter_face");
+    m_IrradiancePipeline = NewComputePipeline(m_Device, lib, "sky_irradiance_face");
+    lib->release();
+
+    if (!m_TransmittancePipeline || !m_MultiScatteringPipeline || !m_SkyViewPipeline
+        || !m_PrefilterPipeline || !m_IrradiancePipeline) {
+        shutdown();
+        return false;
+    }
+    return true;
+}
+
+void SkyAtmosphere::shutdown() {
+    releaseTextures();
+    ReleasePipeline(m_TransmittancePipeline);
+    ReleasePipeline(m_MultiScatteringPipeline);
+    ReleasePipeline(m_SkyViewPipeline);
+    ReleasePipeline(m_PrefilterPipeline);
+    ReleasePipeline(m_IrradiancePipeline);
+    m_Device = nullptr;
+}
+
+bool SkyAtmosphere::allocate() {
+    m_TransmittanceLUT = NewTexture(m_Device, MTL::TextureType2D, kTransmittanceWidth, kTransmittanceHeight, 1);
+    m_MultiScatteringLUT = NewTexture(m_Device, MTL::TextureType2D, kMultiScatteringSize, kMultiScatteringSize, 1);
+    m_SkyViewLUT = NewTexture(m_Device, MTL::TextureType2D, kSkyViewWidth, kSkyViewHeight, 1);
+    uint64_t bytes = (static_cast<uint64_t>(kTransmittanceWidth) * kTransmittanceHeight
+                      + kMultiScatteringSize * kMultiScatteringSize
+                      + kSkyViewWidth * kSkyViewHeight) * kBytesPerTexel;
+    bool ok = m_TransmittanceLUT && m_MultiScatteringLUT && m_SkyViewLUT;
+
+    for (LightingSet& set : m_Lighting) {
+        set.irradiance = NewTexture(m_Device, MTL::TextureTypeCube, kIrradianceSize, kIrradianceSize, 1);
+        set.prefiltered = NewTexture(m_Device, MTL::TextureTypeCube, kPrefilteredSize, kPrefilteredSize,
+                                     kPrefilteredMips);
+        if (!set.irradiance || !set.prefiltered) {
+            ok = false;
+            continue;
+        }
+        bytes += static_cast<uint64_t>(kIrradianceSize) * kIrradianceSize * 6 * kBytesPerTexel;
+        for (uint32_t mip = 0; mip < kPrefilteredMips; ++mip) {
+            uint32_t size = std::max(kPrefilteredSize >> mip, 1u);
+            bytes += static_cast<uint64_t>(size) * size * 6 * kBytesPerTexel;
+            set.prefilteredMips.push_back(set.prefiltered->newTextureView(
+                MTL::PixelFormatRGBA16Float, MTL::TextureTypeCube, NS::Range::Make(mip, 1), NS::Range::Make(0, 6)));
+        }
+    }
+    if (!ok) {
+        std::cerr << "SkyAtmosphere: failed to allocate the sky LUTs\n";
+        releaseTextures();
+        return false;
+    }
+    m_Memory.reset(MemoryCategory::Textures, bytes);
+    return true;
+}
+
+void SkyAtmosphere::releaseTextures() {
+    ReleaseTexture(m_TransmittanceLUT);
+    ReleaseTexture(m_MultiScatteringLUT);
+    ReleaseTexture(m_SkyViewLUT);
+    for (LightingSet& set : m_Lighting) {
+        for (MTL::Texture*& view : set.prefilteredMips) {
+            ReleaseTexture(view);
+        }
+        set.prefilteredMips.clear();
+        ReleaseTexture(set.irradiance);
+        ReleaseTexture(set.prefiltered);
+        set.valid = false;
+    }
+    m_Memory.reset();
+    m_FrontLighting = 0;
+    m_AtmosphereBaked = false;
+    m_SkyViewValid = false;
+    m_LightingDirty = true;
+    m_LightingFace = -1;
+}
+
+void SkyAtmosphere::update(MTL::CommandBuffer* commandBuffer, const Inputs& inputs) {
+    m_LUTBakes = 0;
+    m_LightingFacesBaked = 0;
+    if (!isAvailable() || !commandBuffer) {
+        return;
+    }
+    if (!m_SkyViewLUT && !allocate()) {
+        return;
+    }
+
+    const Math::Vector3 sunDirection = inputs.sunDirection.normalized();
+    const Math::Matrix4x4& rot = inputs.environmentRotation;
+    ParamsGPU params{};
+    params.sunDirection = Math::Vector4(sunDirection.x, sunDirection.y, sunDirection.z, 0.0f);
+    params.sunIlluminance = Math::Vector4(inputs.sunColor.x * kSkyIlluminance, inputs.sunColor.y * kSkyIlluminance,
+                                          inputs.sunColor.z * kSkyIlluminance, 0.0f);
+    params.rot0 = Math::Vector4(rot(0, 0), rot(1, 0), rot(2, 0), 0.0f);
+    params.rot1 = Math::Vector4(rot(0, 1), rot(1, 1), rot(2, 1), 0.0f);
+    params.rot2 = Math::Vector4(rot(0, 2), rot(1, 2), rot(2, 2), 0.0f);
+
+    const bool sunChanged = !m_SkyViewValid
+        || sunDirection.dot(m_BakedSunDirection) < kSunDirectionEpsilon
+        || (inputs.sunColor - m_BakedSunColor).length() > kSunColorEpsilon;
+    if (std::memcmp(rot.m, m_BakedRotation.m, sizeof(rot.m)) != 0) {
+        m_BakedRotation = rot;
+        m_LightingDirty = true;
+    }
+
+    const bool advanceLighting = inputs.bakeLighting && inputs.frame != m_LastLightingFrame
+        && (m_LightingFace >= 0 || m_LightingDirty || sunChanged);
+    if (m_AtmosphereBaked && !sunChanged && !advanceLighting) {
+        return;
+    }
+
+    MTL::ComputeCommandEncoder* encoder = commandBuffer->computeCommandEncoder();
+    if (!m_AtmosphereBaked) {
+        encoder->setComputePipelineState(m_TransmittancePipeline);
+        encoder->setTexture(m_TransmittanceLUT, 0);
+        Dispatch(encoder, kTransmittanceWidth, kTransmittanceHeight);
+
+        encoder->setComputePipelineState(m_MultiScatteringPipeline);
+        encoder->setTexture(m_TransmittanceLUT, 0);
+        encoder->setTexture(m_MultiScatteringLUT, 1);
+        Dispatch(encoder, kMultiScatteringSize, kMultiScatteringSize);
+        m_AtmosphereBaked = true;
+        m_LUTBakes += 2;
+    }
+    if (sunChanged) {
+        encoder->setComputePipelineState(m_SkyViewPipeline);
+        encoder->setTexture(m_TransmittanceLUT, 0);
+        encoder->setTexture(m_MultiScatteringLUT, 1);
+        encoder->setTexture(m_SkyViewLUT, 2);
+        encoder->setBytes(&params, sizeof(params), 0);
+        Dispatch(encoder, kSkyViewWidth, kSkyViewHeight);
+        m_BakedSunDirection = sunDirection;
+        m_BakedSunColor = inputs.sunColor;
+        m_SkyViewValid = true;
+        m_LightingDirty = true;
+        ++m_LUTBakes;
+    }
+
+    // A change mid-refresh lets the current one finish and starts another, so a sun that keeps
+    // moving still gets complete cubes every six frames.
+    if (advanceLighting) {
+        m_LastLightingFrame = inputs.frame;
+        if (m_LightingFace < 0 && m_LightingDirty) {
+            m_LightingDirty = false;
+            m_LightingFace = 0;
+        }
+        if (m_LightingFace >= 0) {
+            encodeLightingFace(encoder, params, static_cast<uint32_t>(m_LightingFace));
+            ++m_LightingFacesBaked;
+            if (++m_LightingFace == 6) {
+                m_FrontLighting = 1 - m_FrontLighting;
+                m_Lighting[m_FrontLighting].valid = true;
+                m_LightingFace = -1;
+            }
+        }
+    }
+    encoder->endEncoding();
+}
+
+void SkyAtmosphere::encodeLightingFace(MTL::ComputeCommandEncoder* encoder, ParamsGPU params, uint32_t face) {
+    const LightingSet& target = m_Lighting[1 - m_FrontLighting];
+    params.face = face;
+
+    encoder->setComputePipelineState(m_IrradiancePipeline);
+    encoder->setTexture(m_SkyViewLUT, 0);
+    encoder->setTexture(target.irradiance, 1);
+    params.resolution = kIrradianceSize;
+    params.roughness = 1.0f;
+    params.sampleCount = kIrradianceSamples;
+    encoder->setBytes(&params, sizeof(params), 0);
+    Dispatch(encoder, kIrradianceSize, kIrradianceSize);
+
+    encoder->setComputePipelineState(m_PrefilterPipeline);
+    for (uint32_t mip = 0; mip < kPrefilteredMips; ++mip) {
+        uint32_t size = std::max(kPrefilteredSize >> mip, 1u);
+        params.resolution = size;
+        params.roughness = static_cast<float>(mip) / static_cast<float>(kPrefilteredMips - 1);
+        params.sampleCount = kPrefilterSamples;
+        encoder->setTexture(target.prefilteredMips[mip], 1);
+        encoder->setBytes(&params, sizeof(params), 0);
+        Dispatch(encoder, size, size);
+    }
+}
+
+Math::Vector3 SkyAtmosphere::SunTransmittance(const Math::Vector3& sunDirection) {
+    Math::Vector3 dir = sunDirection.normalized();
+    if (dir.y < kMinSunElevation) {
+        float horizontal = std::sqrt(dir.x * dir.x + dir.z * dir.z);
+        Math::Vector3 flat = horizontal > 1e-4f ? Math::Vector3(dir.x / horizontal, 0.0f, dir.z / horizontal)
+                                                : Math::Vector3(1.0f, 0.0f, 0.0f);
+        dir = flat * std::sqrt(1.0f - kMinSunElevation * kMinSunElevation)
+            + Math::Vector3(0.0f, kMinSunElevation, 0.0f);
+    }
+    Math::Vector3 depth = OpticalDepthToTop(dir);
+    Math::Vector3 transmittance(std::exp(-depth.x), std::exp(-depth.y), std::exp(-depth.z));
+    float peak = std::max(transmittance.x, std::max(transmittance.y, transmittance.z));
+    return peak > 0.0f ? transmittance * (1.0f / peak) : Math::Vector3(1.0f);
+}
+
+} // namespace Crescent
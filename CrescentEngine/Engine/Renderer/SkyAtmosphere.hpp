@@ -0,0 +1,109 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include "../Math/Math.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class CommandBuffer;
+    class ComputeCommandEncoder;
+    class ComputePipelineState;
+    class Texture;
+}
+
+namespace Crescent {
+
+// Precomputed atmosphere behind the procedural sky (Sky.metal). The transmittance and
+// multiple-scattering LUTs depend only on the atmosphere and are baked once; the small sky-view LUT
+// the skybox samples is re-baked only when the sun's direction or colour changes.
+//
+// While the scene has no environment lighting of its own, the sky also provides it: a diffuse and a
+// prefiltered specular cubemap filtered from the sky-view LUT. They refresh one face per frame into
+// a second set, which replaces the one the passes sample once all six faces are done, so a moving
+// sun costs a few small dispatches a frame and the lighting never shows a half-updated cube.
+class SkyAtmosphere {
+public:
+    struct Inputs {
+        Math::Vector3 sunDirection = Math::Vector3(0.0f, 1.0f, 0.0f); // towards the sun
+        Math::Vector3 sunColor = Math::Vector3(1.0f);                 // before the atmosphere's tint
+        Math::Matrix4x4 environmentRotation = Math::Matrix4x4::Identity;
+        bool bakeLighting = false;
+        uint64_t frame = 0;
+    };
+
+    SkyAtmosphere() = default;
+    ~SkyAtmosphere();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_SkyViewPipeline != nullptr; }
+
+    // Bakes whatever the inputs invalidated and advances the lighting refresh by a face; views after
+    // the first in a frame only re-bake for a changed sun. Encode before the passes that sample them.
+    void update(MTL::CommandBuffer* commandBuffer, const Inputs& inputs);
+
+    bool hasSkyView() const { return m_SkyViewValid; }
+    MTL::Texture* getSkyViewLUT() const { return m_SkyViewLUT; }
+    bool hasLighting() const { return m_Lighting[m_FrontLighting].valid; }
+    MTL::Texture* getIrradiance() const { return m_Lighting[m_FrontLighting].irradiance; }
+    MTL::Texture* getPrefiltered() const { return m_Lighting[m_FrontLighting].prefiltered; }
+
+    uint32_t getLUTBakes() const { return m_LUTBakes; }
+    uint32_t getLightingFacesBaked() const { return m_LightingFacesBaked; }
+
+    // Tint of sunlight through the same atmosphere, scaled so its brightest channel is 1. The sun is
+    // held a few degrees above the horizon, so a light that has set keeps its sunset colour.
+    static Math::Vector3 SunTransmittance(const Math::Vector3& sunDirection);
+
+private:
+    // Matches SkyAtmosphereParams in Sky.metal.
+    struct ParamsGPU {
+        Math::Vector4 sunDirection;
+        Math::Vector4 sunIlluminance;
+        Math::Vector4 rot0;
+        Math::Vector4 rot1;
+        Math::Vector4 rot2;
+        uint32_t face;
+        uint32_t resolution;
+        float roughness;
+        uint32_t sampleCount;
+    };
+    struct LightingSet {
+        MTL::Texture* irradiance = nullptr;
+        MTL::Texture* prefiltered = nullptr;
+        std::vector<MTL::Texture*> prefilteredMips;
+        bool valid = false;
+    };
+
+    bool allocate();
+    void releaseTextures();
+    void encodeLightingFace(MTL::ComputeCommandEncoder* encoder, ParamsGPU params, uint32_t face);
+
+    MTL::Device* m_Device = nullptr;
+    MTL::ComputePipelineState* m_TransmittancePipeline = nullptr;
+    MTL::ComputePipelineState* m_MultiScatteringPipeline = nullptr;
+    MTL::ComputePipelineState* m_SkyViewPipeline = nullptr;
+    MTL::ComputePipelineState* m_PrefilterPipeline = nullptr;
+    MTL::ComputePipelineState* m_IrradiancePipeline = nullptr;
+    MTL::Texture* m_TransmittanceLUT = nullptr;
+    MTL::Texture* m_MultiScatteringLUT = nullptr;
+    MTL::Texture* m_SkyViewLUT = nullptr;
+    LightingSet m_Lighting[2];
+    uint32_t m_FrontLighting = 0;
+    TrackedMemory m_Memory;
+
+    bool m_AtmosphereBaked = false;
+    bool m_SkyViewValid = false;
+    Math::Vector3 m_BakedSunDirection;
+    Math::Vector3 m_BakedSunColor;
+    Math::Matrix4x4 m_BakedRotation;
+    bool m_LightingDirty = true;
+    int32_t m_LightingFace = -1; // next face of the refresh, -1 while idle
+    uint64_t m_LastLightingFrame = ~0ull;
+    uint32_t m_LUTBakes = 0;
+    uint32_t m_LightingFacesBaked = 0;
+};
+
+} // namespace Crescent
@@ -0,0 +1,484 @@
+#include "TerrainSystem.hpp"
+#include "../Components/TerrainRenderer.hpp"
+#include "../Rendering/Mesh.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace Crescent {
+
+namespace {
+    constexpr uint64_t kEvictFrames = 300;
+    // A window recentres once the camera is this many texels of its level off centre, so a
+    // camera wandering about one spot streams nothing.
+    constexpr int32_t kRecentreTexels = 8;
+    // Patches start morphing onto the coarser grid at this part of their range. With ranges of at
+    // least three patches a patch cannot still be morphing where it meets the next level.
+    constexpr float kMorphStart = 0.8f;
+
+    static_assert(sizeof(TerrainParamsGPU::windowOrigins) / sizeof(Math::Vector4) * 2 == TerrainSystem::kMaxLevels,
+                  "TerrainParams holds two window origins per float4");
+
+    float MaxAxisScale(const Math::Matrix4x4& m) {
+        const float x = Math::Vector3(m.m[0], m.m[1], m.m[2]).length();
+        const float y = Math::Vector3(m.m[4], m.m[5], m.m[6]).length();
+        const float z = Math::Vector3(m.m[8], m.m[9], m.m[10]).length();
+        return std::max(x, std::max(y, z));
+    }
+
+    int32_t FloorDiv(int32_t value, int32_t divisor) {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+}
+
+TerrainSystem::~TerrainSystem() {
+    shutdown();
+}
+
+bool TerrainSystem::initialize(MTL::Device* device) {
+    m_Device = device;
+    if (!m_Device) {
+        return false;
+    }
+    m_PatchMesh = Mesh::CreatePlane(1.0f, 1.0f, kPatchQuads, kPatchQuads);
+    if (!m_PatchMesh) {
+        std::cerr << "TerrainSystem: failed to build the patch grid\n";
+        m_Device = nullptr;
+        return false;
+    }
+    m_PatchMesh->setName("TerrainPatch");
+    return true;
+}
+
+void TerrainSystem::shutdown() {
+    for (auto& [terrain, entry] : m_Entries) {
+        releaseEntry(entry);
+    }
+    m_Entries.clear();
+    for (Slot& slot : m_Slots) {
+        if (slot.instances) {
+            slot.instances->release();
+            slot.instances = nullptr;
+        }
+        if (slot.staging) {
+            slot.staging->release();
+            slot.staging = nullptr;
+        }
+        slot.instanceMemory.reset();
+        slot.stagingMemory.reset();
+    }
+    m_Records.clear();
+    m_Staging.clear();
+    m_Uploads.clear();
+    m_PatchMesh.reset();
+    m_Device = nullptr;
+}
+
+void TerrainSystem::releaseEntry(Entry& entry) {
+    if (entry.heights) {
+        entry.heights->release();
+        entry.heights = nullptr;
+    }
+    entry.heightMemory.reset();
+    entry.field = TerrainHeightField();
+    entry.nodeBounds.clear();
+    entry.nodesPerSide.clear();
+    entry.levelCount = 0;
+    entry.windowsValid = false;
+}
+
+void TerrainSystem::beginFrame(uint32_t frameSlot) {
+    ++m_Frame;
+    m_FrameSlot = frameSlot % kMaxFramesInFlight;
+    m_Records.clear();
+    m_Staging.clear();
+    m_Uploads.clear();
+    m_TexelsStreamed = 0;
+    for (auto it = m_Entries.begin(); it != m_Entries.end();) {
+        if (it->second.lastUsedFrame + kEvictFrames < m_Frame) {
+            releaseEntry(it->second);
+            it = m_Entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool TerrainSystem::rebuild(Entry& entry, const Mesh& terrainMesh) {
+    entry.terrainMesh = &terrainMesh;
+    entry.terrainVertexCount = terrainMesh.getVertices().size();
+    entry.windowsValid = false;
+
+    TerrainHeightField field;
+    if (!BuildTerrainHeightField(terrainMesh, Math::Matrix4x4::Identity, field)) {
+        releaseEntry(entry);
+        return false;
+    }
+    const uint32_t cells = field.sampleCount - 1;
+    uint32_t levelCount = 1;
+    while (levelCount < kMaxLevels && (kPatchQuads << (levelCount - 1)) < cells) {
+        ++levelCount;
+    }
+
+    // Height range of every node, finest level from the samples, the others from their children.
+    entry.nodeBounds.assign(levelCount, {});
+    entry.nodesPerSide.assign(levelCount, 0);
+    entry.nodesPerSide[0] = (cells + kPatchQuads - 1) / kPatchQuads;
+    const uint32_t finest = entry.nodesPerSide[0];
+    entry.nodeBounds[0].resize(static_cast<size_t>(finest) * finest);
+    for (uint32_t nz = 0; nz < finest; ++nz) {
+        for (uint32_t nx = 0; nx < finest; ++nx) {
+            float minHeight = std::numeric_limits<float>::max();
+            float maxHeight = -std::numeric_limits<float>::max();
+            const uint32_t z1 = std::min((nz + 1) * kPatchQuads, cells);
+            const uint32_t x1 = std::min((nx + 1) * kPatchQuads, cells);
+            for (uint32_t z = nz * kPatchQuads; z <= z1; ++z) {
+                const float* row = field.heights.data() + static_cast<size_t>(z) * field.sampleCount;
+                for (uint32_t x = nx * kPatchQuads; x <= x1; ++x) {
+                    minHeight = std::min(minHeight, row[x]);
+                    maxHeight = std::max(maxHeight, row[x]);
+                }
+            }
+            entry.nodeBounds[0][static_cast<size_t>(nz) * finest + nx] = Math::Vector2(minHeight, maxHeight);
+        }
+    }
+    for (uint32_t level = 1; level < levelCount; ++level) {
+        const uint32_t childSide = entry.nodesPerSide[level - 1];
+        const uint32_t side = (childSide + 1) / 2;
+        entry.nodesPerSide[level] = side;
+        entry.nodeBounds[level].resize(static_cast<size_t>(side) * side);
+        for (uint32_t nz = 0; nz < side; ++nz) {
+            for (uint32_t nx = 0; nx < side; ++nx) {
+                Math::Vector2 bounds(std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+                for (uint32_t cz = nz * 2; cz < std::min(nz * 2 + 2, childSide); ++cz) {
+                    for (uint32_t cx = nx * 2; cx < std::min(nx * 2 + 2, childSide); ++cx) {
+                        const Math::Vector2& child = entry.nodeBounds[level - 1][static_cast<size_t>(cz) * childSide + cx];
+                        bounds.x = std::min(bounds.x, child.x);
+                        bounds.y = std::max(bounds.y, child.y);
+                    }
+                }
+                entry.nodeBounds[level][static_cast<size_t>(nz) * side + nx] = bounds;
+            }
+        }
+    }
+
+    if (!entry.heights || entry.levelCount != levelCount) {
+        if (entry.heights) {
+            entry.heights->release();
+            entry.heights = nullptr;
+        }
+        MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+        desc->setTextureType(MTL::TextureType2DArray);
+        desc->setPixelFormat(MTL::PixelFormatR32Float);
+        desc->setWidth(kClipmapSize);
+        desc->setHeight(kClipmapSize);
+        desc->setArrayLength(levelCount);
+        desc->setUsage(MTL::TextureUsageShaderRead);
+        desc->setStorageMode(MTL::StorageModePrivate);
+        entry.heights = m_Device->newTexture(desc);
+        desc->release();
+        if (!entry.heights) {
+            releaseEntry(entry);
+            return false;
+        }
+        entry.heightMemory.reset(MemoryCategory::Textures,
+                                 static_cast<uint64_t>(kClipmapSize) * kClipmapSize * levelCount * sizeof(float));
+    }
+    entry.levelCount = levelCount;
+    entry.field = std::move(field);
+    return true;
+}
+
+void TerrainSystem::stageRegion(Entry& entry, uint32_t level, int32_t x, int32_t z, uint32_t width, uint32_t height) {
+    // The window wraps, so a region splits into up to four rectangles of the texture.
+    const int32_t size = static_cast<int32_t>(kClipmapSize);
+    const int64_t last = static_cast<int64_t>(entry.field.sampleCount) - 1;
+    const int64_t step = int64_t(1) << level;
+    uint32_t rowsDone = 0;
+    while (rowsDone < height) {
+        const int32_t gz = z + static_cast<int32_t>(rowsDone);
+        const uint32_t tz = static_cast<uint32_t>(gz - FloorDiv(gz, size) * size);
+        const uint32_t rows = std::min(height - rowsDone, kClipmapSize - tz);
+        uint32_t columnsDone = 0;
+        while (columnsDone < width) {
+            const int32_t gx = x + static_cast<int32_t>(columnsDone);
+            const uint32_t tx = static_cast<uint32_t>(gx - FloorDiv(gx, size) * size);
+            const uint32_t columns = std::min(width - columnsDone, kClipmapSize - tx);
+            Upload upload;
+            upload.target = entry.heights;
+            upload.level = level;
+            upload.x = tx;
+            upload.z = tz;
+            upload.width = columns;
+            upload.height = rows;
+            upload.stagingOffset = m_Staging.size();
+            m_Staging.reserve(m_Staging.size() + static_cast<size_t>(columns) * rows);
+            for (uint32_t r = 0; r < rows; ++r) {
+                const int64_t sampleZ = std::clamp(static_cast<int64_t>(gz + static_cast<int32_t>(r)) * step,
+                                                   int64_t(0), last);
+                const float* row = entry.field.heights.data() + sampleZ * entry.field.sampleCount;
+                for (uint32_t c = 0; c < columns; ++c) {
+                    const int64_t sampleX = std::clamp(static_cast<int64_t>(gx + static_cast<int32_t>(c)) * step,
+                                                       int64_t(0), last);
+                    m_Staging.push_back(row[sampleX]);
+                }
+            }
+            m_Uploads.push_back(upload);
+            m_TexelsStreamed += columns * rows;
+            columnsDone += columns;
+        }
+        rowsDone += rows;
+    }
+}
+
+void TerrainSystem::streamWindows(Entry& entry, const Math::Vector3& cameraGrid) {
+    const int32_t size = static_cast<int32_t>(kClipmapSize);
+    for (uint32_t level = 0; level < entry.levelCount; ++level) {
+        const float texel = static_cast<float>(1u << level);
+        const int32_t wantX = static_cast<int32_t>(std::floor(cameraGrid.x / texel)) - size / 2;
+        const int32_t wantZ = static_cast<int32_t>(std::floor(cameraGrid.z / texel)) - size / 2;
+        int32_t& originX = entry.windows[level * 2];
+        int32_t& originZ = entry.windows[level * 2 + 1];
+        if (!entry.windowsValid) {
+            originX = wantX;
+            originZ = wantZ;
+            stageRegion(entry, level, originX, originZ, kClipmapSize, kClipmapSize);
+            continue;
+        }
+        const int32_t dx = wantX - originX;
+        const int32_t dz = wantZ - originZ;
+        if (std::abs(dx) <= kRecentreTexels && std::abs(dz) <= kRecentreTexels) {
+            continue;
+        }
+        const int32_t oldX = originX;
+        const int32_t oldZ = originZ;
+        originX = wantX;
+        originZ = wantZ;
+        if (std::abs(dx) >= size || std::abs(dz) >= size) {
+            stageRegion(entry, level, originX, originZ, kClipmapSize, kClipmapSize);
+            continue;
+        }
+        // Texels kept by both windows stay where they are; only the columns and rows that
+        // entered are written (their overlap twice).
+        if (dx != 0) {
+            const int32_t x = dx > 0 ? oldX + size : originX;
+            stageRegion(entry, level, x, originZ, static_cast<uint32_t>(std::abs(dx)), kClipmapSize);
+        }
+        if (dz != 0) {
+            const int32_t z = dz > 0 ? oldZ + size : originZ;
+            stageRegion(entry, level, originX, z, kClipmapSize, static_cast<uint32_t>(std::abs(dz)));
+        }
+    }
+    entry.windowsValid = true;
+}
+
+void TerrainSystem::nodeBox(const Entry& entry, uint32_t level, uint32_t x, uint32_t z,
+                            Math::Vector3& outMin, Math::Vector3& outMax) const {
+    const float cells = static_cast<float>(entry.field.sampleCount - 1);
+    const float side = static_cast<float>(kPatchQuads << level);
+    const Math::Vector2& bounds = entry.nodeBounds[level][static_cast<size_t>(z) * entry.nodesPerSide[level] + x];
+    const float x0 = static_cast<float>(x) * side;
+    const float z0 = static_cast<float>(z) * side;
+    outMin = Math::Vector3(entry.field.origin.x + x0 * entry.field.spacingX, bounds.x,
+                           entry.field.origin.z + z0 * entry.field.spacingZ);
+    outMax = Math::Vector3(entry.field.origin.x + std::min(x0 + side, cells) * entry.field.spacingX, bounds.y,
+                           entry.field.origin.z + std::min(z0 + side, cells) * entry.field.spacingZ);
+}
+
+bool TerrainSystem::nodeVisible(const SelectContext& context, uint32_t level, uint32_t x, uint32_t z) const {
+    Math::Vector3 boxMin;
+    Math::Vector3 boxMax;
+    nodeBox(*context.entry, level, x, z, boxMin, boxMax);
+    const Math::Vector3 center = context.terrainWorld.transformPointAffine((boxMin + boxMax) * 0.5f);
+    const float radius = ((boxMax - boxMin) * 0.5f).length() * context.worldScale;
+    return Math::IsSphereInFrustum(context.view->frustum, center, radius);
+}
+
+float TerrainSystem::nodeDistanceSq(const SelectContext& context, uint32_t level, uint32_t x, uint32_t z) const {
+    const Entry& entry = *context.entry;
+    Math::Vector3 boxMin;
+    Math::Vector3 boxMax;
+    nodeBox(entry, level, x, z, boxMin, boxMax);
+    const float minX = (boxMin.x - entry.field.origin.x) / entry.field.spacingX;
+    const float maxX = (boxMax.x - entry.field.origin.x) / entry.field.spacingX;
+    const float minZ = (boxMin.z - entry.field.origin.z) / entry.field.spacingZ;
+    const float maxZ = (boxMax.z - entry.field.origin.z) / entry.field.spacingZ;
+    const Math::Vector3& camera = context.camera;
+    const float dx = std::max(0.0f, std::max(minX - camera.x, camera.x - maxX));
+    const float dy = std::max(0.0f, std::max(boxMin.y * context.heightScale - camera.y,
+                                             camera.y - boxMax.y * context.heightScale));
+    const float dz = std::max(0.0f, std::max(minZ - camera.z, camera.z - maxZ));
+    return dx * dx + dy * dy + dz * dz;
+}
+
+void TerrainSystem::emitPatch(const SelectContext& context, uint32_t level, uint32_t x, uint32_t z, uint32_t lod) {
+    Math::Vector3 boxMin;
+    Math::Vector3 boxMax;
+    nodeBox(*context.entry, level, x, z, boxMin, boxMax);
+    const Math::Vector3 extent(boxMax.x - boxMin.x, std::max(boxMax.y - boxMin.y, 1e-3f), boxMax.z - boxMin.z);
+    const Math::Vector3 base((boxMin.x + boxMax.x) * 0.5f, boxMin.y, (boxMin.z + boxMax.z) * 0.5f);
+
+    const float side = static_cast<float>(kPatchQuads << level);
+    PatchRecord record;
+    record.modelMatrix = context.terrainWorld * Math::Matrix4x4::Translate(base) * Math::Matrix4x4::Scale(extent);
+    record.normalMatrix.m[12] = static_cast<float>(x) * side;
+    record.normalMatrix.m[13] = static_cast<float>(z) * side;
+    record.normalMatrix.m[14] = side;
+    record.normalMatrix.m[15] = static_cast<float>(lod);
+    m_Records.push_back(record);
+}
+
+void TerrainSystem::selectNode(const SelectContext& context, uint32_t level, uint32_t x, uint32_t z) {
+    if (!nodeVisible(context, level, x, z)) {
+        return;
+    }
+    const Entry& entry = *context.entry;
+    const uint32_t minLod = std::min(context.view->minLod, entry.levelCount - 1);
+    if (level <= minLod) {
+        emitPatch(context, level, x, z, level);
+        return;
+    }
+    // Out of reach of the finer level: drawn whole at this one.
+    const float childRange = context.range0 * static_cast<float>(1u << (level - 1));
+    const float childRangeSq = childRange * childRange;
+    if (nodeDistanceSq(context, level, x, z) > childRangeSq) {
+        emitPatch(context, level, x, z, level);
+        return;
+    }
+    // Children out of reach keep this level's heights on their quarter of the node.
+    const uint32_t childSide = entry.nodesPerSide[level - 1];
+    for (uint32_t cz = z * 2; cz < std::min(z * 2 + 2, childSide); ++cz) {
+        for (uint32_t cx = x * 2; cx < std::min(x * 2 + 2, childSide); ++cx) {
+            if (nodeDistanceSq(context, level - 1, cx, cz) <= childRangeSq) {
+                selectNode(context, level - 1, cx, cz);
+            } else if (nodeVisible(context, level - 1, cx, cz)) {
+                emitPatch(context, level - 1, cx, cz, level);
+            }
+        }
+    }
+}
+
+bool TerrainSystem::update(TerrainRenderer& terrain, const Mesh& terrainMesh, const Math::Matrix4x4& terrainWorld,
+                           const Math::Vector3& cameraPosition, const View* views, size_t viewCount,
+                           Selection* outSelections, TerrainParamsGPU& outParams, MTL::Texture*& outHeights) {
+    outHeights = nullptr;
+    for (size_t i = 0; i < viewCount; ++i) {
+        outSelections[i] = Selection();
+    }
+    if (!isAvailable()) {
+        return false;
+    }
+    Entry& entry = m_Entries[&terrain];
+    entry.lastUsedFrame = m_Frame;
+    if (entry.version != terrain.getVersion() || entry.terrainMesh != &terrainMesh
+        || entry.terrainVertexCount != terrainMesh.getVertices().size()) {
+        entry.version = terrain.getVersion();
+        if (!rebuild(entry, terrainMesh)) {
+            return false;
+        }
+    }
+    if (!entry.heights) {
+        return false;
+    }
+
+    const TerrainHeightField& field = entry.field;
+    const float heightScale = 2.0f / std::max(field.spacingX + field.spacingZ, 1e-6f);
+    const Math::Vector3 local = terrainWorld.inversed().transformPoint(cameraPosition);
+    const Math::Vector3 cameraGrid((local.x - field.origin.x) / field.spacingX, local.y * heightScale,
+                                   (local.z - field.origin.z) / field.spacingZ);
+    streamWindows(entry, cameraGrid);
+
+    SelectContext context;
+    context.entry = &entry;
+    context.terrainWorld = terrainWorld;
+    context.worldScale = MaxAxisScale(terrainWorld);
+    context.camera = cameraGrid;
+    context.heightScale = heightScale;
+    context.range0 = terrain.getLodDistance() * static_cast<float>(kPatchQuads);
+    const uint32_t top = entry.levelCount - 1;
+    const uint32_t roots = entry.nodesPerSide[top];
+    for (size_t i = 0; i < viewCount; ++i) {
+        context.view = &views[i];
+        outSelections[i].offset = static_cast<uint32_t>(m_Records.size());
+        for (uint32_t z = 0; z < roots; ++z) {
+            for (uint32_t x = 0; x < roots; ++x) {
+                selectNode(context, top, x, z);
+            }
+        }
+        outSelections[i].count = static_cast<uint32_t>(m_Records.size()) - outSelections[i].offset;
+    }
+
+    outParams.terrainToWorld = terrainWorld;
+    outParams.fieldOrigin = Math::Vector4(field.origin.x, field.origin.y, field.origin.z, field.spacingX);
+    outParams.fieldInfo = Math::Vector4(field.spacingZ, static_cast<float>(field.sampleCount),
+                                        static_cast<float>(kClipmapSize), static_cast<float>(entry.levelCount));
+    outParams.cameraGrid = Math::Vector4(cameraGrid.x, cameraGrid.y, cameraGrid.z, static_cast<float>(kPatchQuads));
+    outParams.lodRanges = Math::Vector4(context.range0, kMorphStart, heightScale, 0.0f);
+    for (uint32_t i = 0; i < kMaxLevels / 2; ++i) {
+        outParams.windowOrigins[i] = Math::Vector4(
+            static_cast<float>(entry.windows[i * 4]), static_cast<float>(entry.windows[i * 4 + 1]),
+            static_cast<float>(entry.windows[i * 4 + 2]), static_cast<float>(entry.windows[i * 4 + 3]));
+    }
+    outHeights = entry.heights;
+    return true;
+}
+
+MTL::Buffer* TerrainSystem::uploadInstances() {
+    if (m_Records.empty() || !m_Device) {
+        return nullptr;
+    }
+    Slot& slot = m_Slots[m_FrameSlot];
+    const size_t bytes = m_Records.size() * sizeof(PatchRecord);
+    if (!slot.instances || slot.instances->length() < bytes) {
+        if (slot.instances) {
+            slot.instances->release();
+        }
+        slot.instances = m_Device->newBuffer(std::max<size_t>(bytes * 2, 64 * 1024), MTL::ResourceStorageModeShared);
+        if (!slot.instances) {
+            slot.instanceMemory.reset();
+            return nullptr;
+        }
+        slot.instanceMemory.reset(MemoryCategory::Instances, slot.instances->length());
+    }
+    std::memcpy(slot.instances->contents(), m_Records.data(), bytes);
+    return slot.instances;
+}
+
+void TerrainSystem::encode(MTL::CommandBuffer* commandBuffer) {
+    if (!commandBuffer || m_Uploads.empty() || !m_Device) {
+        return;
+    }
+    Slot& slot = m_Slots[m_FrameSlot];
+    const size_t bytes = m_Staging.size() * sizeof(float);
+    if (!slot.staging || slot.staging->length() < bytes) {
+        if (slot.staging) {
+            slot.staging->release();
+        }
+        slot.staging = m_Device->newBuffer(bytes, MTL::ResourceStorageModeShared);
+        if (!slot.staging) {
+            slot.stagingMemory.reset();
+            std::cerr << "TerrainSystem: failed to allocate " << bytes << " bytes of height staging\n";
+            m_Uploads.clear();
+            m_Staging.clear();
+            return;
+        }
+        slot.stagingMemory.reset(MemoryCategory::Textures, slot.staging->length());
+    }
+    std::memcpy(slot.staging->contents(), m_Staging.data(), bytes);
+
+    MTL::BlitCommandEncoder* blit = commandBuffer->blitCommandEncoder();
+    for (const Upload& upload : m_Uploads) {
+        const NS::UInteger rowBytes = upload.width * sizeof(float);
+        blit->copyFromBuffer(slot.staging, upload.stagingOffset * sizeof(float), rowBytes, rowBytes * upload.height,
+                             MTL::Size(upload.width, upload.height, 1), upload.target, upload.level, 0,
+                             MTL::Origin(upload.x, upload.z, 0));
+    }
+    blit->endEncoding();
+    m_Uploads.clear();
+    m_Staging.clear();
+}
+
+} // namespace Crescent
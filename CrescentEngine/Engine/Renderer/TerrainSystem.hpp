@@ -0,0 +1,166 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include "../Math/Math.hpp"
+#include "../Math/Frustum.hpp"
+#include "../Physics/TerrainHeightField.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class Buffer;
+    class Texture;
+    class CommandBuffer;
+}
+
+namespace Crescent {
+
+class TerrainRenderer;
+class Mesh;
+
+// Matches TerrainParams in Common.metal.h. Grid units are height field samples: x and z divide by
+// the sample spacing, heights by the mean of the two spacings.
+struct TerrainParamsGPU {
+    Math::Matrix4x4 terrainToWorld;
+    Math::Vector4 fieldOrigin; // xyz height field origin, w spacing X
+    Math::Vector4 fieldInfo;   // x spacing Z, y sample count, z clipmap size, w level count
+    Math::Vector4 cameraGrid;  // xyz camera in grid units, w quads per patch side
+    Math::Vector4 lodRanges;   // x range of level 0 in grid units, y morph start in parts of a range, z grid units per height unit
+    // Clipmap window corners in texels of their level: xy level 2i, zw level 2i + 1.
+    Math::Vector4 windowOrigins[6];
+};
+
+// Heights and patch selection for TerrainRenderer components (CDLOD over a height clipmap).
+//
+// A terrain's heights live in a texture array of kClipmapSize-square levels; level k holds every
+// 2^k-th sample of the field in a window around the camera, addressed toroidally, so moving the
+// camera only streams the strips of texels that entered each window (staged per frame slot and
+// blitted in encode). Point sampling keeps every level exact on the samples it shares with the
+// finer ones. Patches are picked every frame from a quadtree over the field whose nodes carry
+// their height range: a node is drawn whole once it is out of reach of the next finer level, and
+// one shared kPatchQuads grid is displaced per patch in vertex_terrain_instanced (PBR.metal),
+// which morphs the odd vertices of a patch onto the coarser grid as it nears the end of its range
+// so neighbouring levels meet without cracks. Shadow views select again with a coarser floor.
+class TerrainSystem {
+public:
+    static constexpr uint32_t kMaxFramesInFlight = 4;
+    static constexpr uint32_t kMaxLevels = 12;
+    static constexpr uint32_t kClipmapSize = 256;
+    static constexpr uint32_t kPatchQuads = 16;
+
+    // One view to select patches for; levels below minLod are not drawn in it.
+    struct View {
+        Math::FrustumPlanes frustum;
+        uint32_t minLod = 0;
+    };
+    // Patches of one view in the frame's instance buffer.
+    struct Selection {
+        uint32_t offset = 0;
+        uint32_t count = 0;
+    };
+
+    TerrainSystem() = default;
+    ~TerrainSystem();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_Device != nullptr && m_PatchMesh != nullptr; }
+
+    // The slot's previous command buffer must have completed. Drops terrains not drawn for a while.
+    void beginFrame(uint32_t frameSlot);
+    // Streams the terrain's clipmap around the camera and selects its patches for each view, one
+    // selection per view. False when the mesh is not a height field or its texture failed.
+    bool update(TerrainRenderer& terrain, const Mesh& terrainMesh, const Math::Matrix4x4& terrainWorld,
+                const Math::Vector3& cameraPosition, const View* views, size_t viewCount,
+                Selection* outSelections, TerrainParamsGPU& outParams, MTL::Texture*& outHeights);
+    // Copies every selection of the frame into the slot's instance buffer and returns it; call
+    // once after the updates. Null when nothing was selected.
+    MTL::Buffer* uploadInstances();
+    // Blits the texels streamed this frame. Encode before anything draws the terrains.
+    void encode(MTL::CommandBuffer* commandBuffer);
+
+    // The grid every patch displaces: kPatchQuads square over -0.5..0.5 on XZ. The renderer
+    // uploads it like any other mesh.
+    Mesh* getPatchMesh() const { return m_PatchMesh.get(); }
+    uint32_t getPatchesSelected() const { return static_cast<uint32_t>(m_Records.size()); }
+    uint32_t getTexelsStreamed() const { return m_TexelsStreamed; }
+
+private:
+    // Matches InstanceData in Common.metal.h. The model matrix maps the unit box to the patch's
+    // bounds, for culling; normalMatrix[3] holds the patch corner and side in grid units and its
+    // level.
+    struct PatchRecord {
+        Math::Matrix4x4 modelMatrix;
+        Math::Matrix4x4 normalMatrix;
+    };
+    struct Upload {
+        MTL::Texture* target = nullptr;
+        uint32_t level = 0;
+        uint32_t x = 0;
+        uint32_t z = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        size_t stagingOffset = 0; // in floats
+    };
+    struct Entry {
+        MTL::Texture* heights = nullptr;
+        TrackedMemory heightMemory;
+        uint64_t version = 0;
+        const Mesh* terrainMesh = nullptr;
+        size_t terrainVertexCount = 0;
+        TerrainHeightField field;
+        uint32_t levelCount = 0;
+        // Min and max height of every quadtree node, row-major per level.
+        std::vector<std::vector<Math::Vector2>> nodeBounds;
+        std::vector<uint32_t> nodesPerSide;
+        std::array<int32_t, kMaxLevels * 2> windows{};
+        bool windowsValid = false;
+        uint64_t lastUsedFrame = 0;
+    };
+    struct Slot {
+        MTL::Buffer* instances = nullptr;
+        MTL::Buffer* staging = nullptr;
+        TrackedMemory instanceMemory;
+        TrackedMemory stagingMemory;
+    };
+    // What one selection pass walks the quadtree with, in grid units.
+    struct SelectContext {
+        const Entry* entry = nullptr;
+        const View* view = nullptr;
+        Math::Matrix4x4 terrainWorld;
+        float worldScale = 1.0f;
+        Math::Vector3 camera;
+        float heightScale = 1.0f;
+        float range0 = 1.0f;
+    };
+
+    bool rebuild(Entry& entry, const Mesh& terrainMesh);
+    void releaseEntry(Entry& entry);
+    void streamWindows(Entry& entry, const Math::Vector3& cameraGrid);
+    void stageRegion(Entry& entry, uint32_t level, int32_t x, int32_t z, uint32_t width, uint32_t height);
+    void selectNode(const SelectContext& context, uint32_t level, uint32_t x, uint32_t z);
+    // Node bounds in terrain space: XZ clipped to the field, Y its height range.
+    void nodeBox(const Entry& entry, uint32_t level, uint32_t x, uint32_t z,
+                 Math::Vector3& outMin, Math::Vector3& outMax) const;
+    bool nodeVisible(const SelectContext& context, uint32_t level, uint32_t x, uint32_t z) const;
+    float nodeDistanceSq(const SelectContext& context, uint32_t level, uint32_t x, uint32_t z) const;
+    void emitPatch(const SelectContext& context, uint32_t level, uint32_t x, uint32_t z, uint32_t lod);
+
+    MTL::Device* m_Device = nullptr;
+    std::shared_ptr<Mesh> m_PatchMesh;
+    std::unordered_map<const TerrainRenderer*, Entry> m_Entries;
+    std::array<Slot, kMaxFramesInFlight> m_Slots;
+    uint32_t m_FrameSlot = 0;
+    uint64_t m_Frame = 0;
+    std::vector<PatchRecord> m_Records;
+    std::vector<float> m_Staging;
+    std::vector<Upload> m_Uploads;
+    uint32_t m_TexelsStreamed = 0;
+};
+
+} // namespace Crescent
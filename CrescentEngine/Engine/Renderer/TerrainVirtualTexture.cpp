@@ -0,0 +1,537 @@
+#include "TerrainVirtualTexture.hpp"
+#include "ShaderLibrary.hpp"
+#include "../Rendering/Material.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    constexpr uint64_t kEvictFrames = 300;
+    // Pixels of a 4x4 block take turns writing feedback, one per frame.
+    constexpr uint32_t kFeedbackPhases = 16;
+
+    constexpr std::array<uint32_t, TerrainVirtualTexture::kMipCount + 1> MakeMipOffsets() {
+        std::array<uint32_t, TerrainVirtualTexture::kMipCount + 1> offsets{};
+        for (uint32_t mip = 0; mip < TerrainVirtualTexture::kMipCount; ++mip) {
+            const uint32_t pages = TerrainVirtualTexture::kPagesPerSide >> mip;
+            offsets[mip + 1] = offsets[mip] + pages * pages;
+        }
+        return offsets;
+    }
+    // First page of every mip in a texture's page list, then the page count.
+    constexpr auto kMipOffsets = MakeMipOffsets();
+    constexpr uint32_t kPageCount = kMipOffsets[TerrainVirtualTexture::kMipCount];
+    constexpr uint32_t kTopPage = kMipOffsets[TerrainVirtualTexture::kMipCount - 1];
+    constexpr uint32_t kFeedbackWords = (kPageCount + 31) / 32;
+
+    static_assert((TerrainVirtualTexture::kPagesPerSide >> (TerrainVirtualTexture::kMipCount - 1)) == 1,
+                  "the top mip is a single page");
+
+    uint64_t HashCombine(uint64_t hash, uint64_t value) {
+        return (hash ^ value) * 1099511628211ull;
+    }
+
+    uint64_t HashFloat(uint64_t hash, float value) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return HashCombine(hash, bits);
+    }
+}
+
+TerrainVirtualTexture::~TerrainVirtualTexture() {
+    shutdown();
+}
+
+bool TerrainVirtualTexture::initialize(MTL::Device* device) {
+    m_Device = device;
+    if (!m_Device) {
+        return false;
+    }
+
+    NS::Error* error = nullptr;
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_Device, ShaderLibrary::Module::Core);
+    if (!lib) {
+        std::cerr << "TerrainVirtualTexture: missing default Metal library\n";
+        return false;
+    }
+    MTL::Function* func = lib->newFunction(NS::String::string("terrain_vt_composite", NS::UTF8StringEncoding));
+    if (!func) {
+        std::cerr << "TerrainVirtualTexture: missing terrain_vt_composite shader\n";
+        lib->release();
+        return false;
+    }
+    m_Pipeline = m_Device->newComputePipelineState(func, &error);
+    func->release();
+    lib->release();
+    if (!m_Pipeline) {
+        if (error) {
+            std::cerr << "TerrainVirtualTexture: pipeline error " << error->localizedDescription()->utf8String() << "\n";
+        }
+        return false;
+    }
+
+    // Layers repeat across the terrain; the composite passes its own gradients.
+    MTL::SamplerDescriptor* samplerDesc = MTL::SamplerDescriptor::alloc()->init();
+    samplerDesc->setMinFilter(MTL::SamplerMinMagFilterLinear);
+    samplerDesc->setMagFilter(MTL::SamplerMinMagFilterLinear);
+    samplerDesc->setMipFilter(MTL::SamplerMipFilterLinear);
+    samplerDesc->setSAddressMode(MTL::SamplerAddressModeRepeat);
+    samplerDesc->setTAddressMode(MTL::SamplerAddressModeRepeat);
+    m_Sampler = m_Device->newSamplerState(samplerDesc);
+    samplerDesc->release();
+
+    const uint32_t atlasSize = kAtlasPagesPerSide * kPageStride;
+    MTL::TextureDescriptor* atlasDesc = MTL::TextureDescriptor::texture2DDescriptor(
+        MTL::PixelFormatRGBA8Unorm, atlasSize, atlasSize, false);
+    atlasDesc->setUsage(MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
+    atlasDesc->setStorageMode(MTL::StorageModePrivate);
+    m_AlbedoAtlas = m_Device->newTexture(atlasDesc);
+    m_SurfaceAtlas = m_Device->newTexture(atlasDesc);
+
+    MTL::TextureDescriptor* indirectionDesc = MTL::TextureDescriptor::alloc()->init();
+    indirectionDesc->setTextureType(MTL::TextureType2DArray);
+    indirectionDesc->setPixelFormat(MTL::PixelFormatRGBA8Uint);
+    indirectionDesc->setWidth(kPagesPerSide);
+    indirectionDesc->setHeight(kPagesPerSide);
+    indirectionDesc->setMipmapLevelCount(kMipCount);
+    indirectionDesc->setArrayLength(kMaxTextures);
+    indirectionDesc->setUsage(MTL::TextureUsageShaderRead);
+    indirectionDesc->setStorageMode(MTL::StorageModePrivate);
+    m_Indirection = m_Device->newTexture(indirectionDesc);
+    indirectionDesc->release();
+
+    const size_t feedbackBytes = static_cast<size_t>(kMaxTextures) * kFeedbackWords * sizeof(uint32_t);
+    bool feedbackAllocated = true;
+    for (Slot& slot : m_Slots) {
+        slot.feedback = m_Device->newBuffer(feedbackBytes, MTL::ResourceStorageModeShared);
+        if (!slot.feedback) {
+            feedbackAllocated = false;
+            break;
+        }
+        std::memset(slot.feedback->contents(), 0, feedbackBytes);
+        slot.feedbackMemory.reset(MemoryCategory::Textures, feedbackBytes);
+    }
+
+    if (!m_Sampler || !m_AlbedoAtlas || !m_SurfaceAtlas || !m_Indirection || !feedbackAllocated) {
+        std::cerr << "TerrainVirtualTexture: failed to allocate the page cache\n";
+        shutdown();
+        return false;
+    }
+    m_AtlasMemory.reset(MemoryCategory::Textures, static_cast<uint64_t>(atlasSize) * atlasSize * 4 * 2);
+    m_IndirectionMemory.reset(MemoryCategory::Textures, static_cast<uint64_t>(kPageCount) * kMaxTextures * 4);
+
+    const uint32_t slotCount = kAtlasPagesPerSide * kAtlasPagesPerSide;
+    m_PageSlots.assign(slotCount, PageSlot());
+    m_FreeSlots.clear();
+    for (uint32_t i = slotCount; i-- > 0;) {
+        m_FreeSlots.push_back(static_cast<int32_t>(i));
+    }
+    return true;
+}
+
+void TerrainVirtualTexture::shutdown() {
+    m_Entries.clear();
+    m_PageSlots.clear();
+    m_FreeSlots.clear();
+    m_Requests.clear();
+    for (Slot& slot : m_Slots) {
+        if (slot.feedback) {
+            slot.feedback->release();
+            slot.feedback = nullptr;
+        }
+        if (slot.staging) {
+            slot.staging->release();
+            slot.staging = nullptr;
+        }
+        slot.feedbackMemory.reset();
+        slot.stagingMemory.reset();
+    }
+    MTL::Texture** textures[] = {&m_AlbedoAtlas, &m_SurfaceAtlas, &m_Indirection};
+    for (MTL::Texture** texture : textures) {
+        if (*texture) {
+            (*texture)->release();
+            *texture = nullptr;
+        }
+    }
+    m_AtlasMemory.reset();
+    m_IndirectionMemory.reset();
+    if (m_Sampler) {
+        m_Sampler->release();
+        m_Sampler = nullptr;
+    }
+    if (m_Pipeline) {
+        m_Pipeline->release();
+        m_Pipeline = nullptr;
+    }
+    m_Device = nullptr;
+}
+
+bool TerrainVirtualTexture::IsEligible(const Material* material) {
+    if (!material || !material->getTerrainEnabled() || !material->getTerrainControlTexture()) {
+        return false;
+    }
+    if (material->getRenderMode() != Material::RenderMode::Opaque || material->getAlpha() < 0.999f) {
+        return false;
+    }
+    return material->getTerrainLayer0Texture() || material->getTerrainLayer1Texture()
+        || material->getTerrainLayer2Texture();
+}
+
+uint32_t TerrainVirtualTexture::PageMip(uint32_t page) {
+    uint32_t mip = 0;
+    while (mip + 1 < kMipCount && page >= kMipOffsets[mip + 1]) {
+        ++mip;
+    }
+    return mip;
+}
+
+uint64_t TerrainVirtualTexture::Signature(const Material& material, const Sources& sources) {
+    uint64_t hash = 1469598103934665603ull;
+    for (MTL::Texture* texture : sources) {
+        hash = HashCombine(hash, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(texture)));
+    }
+    const Math::Vector2 tiling = material.getUVTiling();
+    const Math::Vector2 offset = material.getUVOffset();
+    const Math::Vector2 layers[] = {material.getTerrainLayer0Tiling(), material.getTerrainLayer1Tiling(),
+                                    material.getTerrainLayer2Tiling()};
+    hash = HashFloat(HashFloat(hash, tiling.x), tiling.y);
+    hash = HashFloat(HashFloat(hash, offset.x), offset.y);
+    for (const Math::Vector2& layer : layers) {
+        hash = HashFloat(HashFloat(hash, layer.x), layer.y);
+    }
+    return HashFloat(hash, material.getTerrainBlendSharpness());
+}
+
+void TerrainVirtualTexture::releaseEntry(Entry& entry) {
+    for (int32_t& slot : entry.pageSlots) {
+        if (slot >= 0) {
+            m_PageSlots[slot] = PageSlot();
+            m_FreeSlots.push_back(slot);
+            slot = -1;
+        }
+    }
+    entry.ready = false;
+    entry.indirectionDirty = true;
+}
+
+void TerrainVirtualTexture::beginFrame(uint32_t frameSlot) {
+    ++m_Frame;
+    m_FrameSlot = frameSlot % kMaxFramesInFlight;
+    m_Requests.clear();
+    m_PagesComposited = 0;
+    for (auto it = m_Entries.begin(); it != m_Entries.end();) {
+        if (it->second.lastUsedFrame + kEvictFrames < m_Frame) {
+            releaseEntry(it->second);
+            it = m_Entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    Slot& slot = m_Slots[m_FrameSlot];
+    if (!slot.feedback) {
+        return;
+    }
+    uint32_t* bits = static_cast<uint32_t*>(slot.feedback->contents());
+    for (auto& [material, entry] : m_Entries) {
+        if (!entry.ready) {
+            continue;
+        }
+        const uint32_t* words = bits + static_cast<size_t>(entry.index) * kFeedbackWords;
+        for (uint32_t w = 0; w < kFeedbackWords; ++w) {
+            for (uint32_t word = words[w]; word != 0; word &= word - 1) {
+                const uint32_t page = w * 32 + static_cast<uint32_t>(std::countr_zero(word));
+                if (page >= kPageCount) {
+                    break;
+                }
+                const uint32_t mip = PageMip(page);
+                const uint32_t pages = kPagesPerSide >> mip;
+                const uint32_t local = page - kMipOffsets[mip];
+                requestPage(material, entry, mip, local % pages, local / pages);
+            }
+        }
+    }
+    std::memset(bits, 0, slot.feedback->length());
+}
+
+void TerrainVirtualTexture::requestPage(const Material* material, Entry& entry, uint32_t mip, uint32_t x, uint32_t y) {
+    // The wanted page and every missing ancestor, so the fallback sharpens one mip at a time; the
+    // resident page the pixels fall back to counts as used.
+    for (; mip < kMipCount; ++mip, x >>= 1, y >>= 1) {
+        const uint32_t page = kMipOffsets[mip] + y * (kPagesPerSide >> mip) + x;
+        const int32_t slot = entry.pageSlots[page];
+        if (slot >= 0) {
+            m_PageSlots[slot].lastUsedFrame = m_Frame;
+            return;
+        }
+        m_Requests.push_back(Request{material, page, mip});
+    }
+}
+
+bool TerrainVirtualTexture::acquire(const Material& material, const Sources& sources) {
+    if (!isAvailable() || !IsEligible(&material)) {
+        return false;
+    }
+    auto it = m_Entries.find(&material);
+    if (it == m_Entries.end()) {
+        bool used[kMaxTextures] = {};
+        for (const auto& [owner, entry] : m_Entries) {
+            used[entry.index] = true;
+        }
+        const bool* freeIndex = std::find(std::begin(used), std::end(used), false);
+        if (freeIndex == std::end(used)) {
+            return false;
+        }
+        Entry entry;
+        entry.index = static_cast<uint32_t>(freeIndex - std::begin(used));
+        entry.pageSlots.assign(kPageCount, -1);
+        it = m_Entries.emplace(&material, std::move(entry)).first;
+    }
+    Entry& entry = it->second;
+    entry.lastUsedFrame = m_Frame;
+    const uint64_t signature = Signature(material, sources);
+    if (signature == entry.signature && entry.ready) {
+        return true;
+    }
+    releaseEntry(entry);
+    entry.signature = signature;
+    entry.sources = sources;
+
+    CompositeParamsGPU& params = entry.params;
+    params = CompositeParamsGPU{};
+    const Math::Vector2 tiling = material.getUVTiling();
+    const Math::Vector2 offset = material.getUVOffset();
+    const Math::Vector2 layers[] = {material.getTerrainLayer0Tiling(), material.getTerrainLayer1Tiling(),
+                                    material.getTerrainLayer2Tiling()};
+    params.uvTilingOffset[0] = tiling.x;
+    params.uvTilingOffset[1] = tiling.y;
+    params.uvTilingOffset[2] = offset.x;
+    params.uvTilingOffset[3] = offset.y;
+    for (size_t i = 0; i < 3; ++i) {
+        params.layerTiling[i][0] = layers[i].x;
+        params.layerTiling[i][1] = layers[i].y;
+    }
+    params.blend[0] = material.getTerrainBlendSharpness();
+    return true;
+}
+
+uint32_t TerrainVirtualTexture::find(const Material* material) const {
+    auto it = m_Entries.find(material);
+    if (it == m_Entries.end() || !it->second.ready || it->second.lastUsedFrame != m_Frame) {
+        return 0;
+    }
+    return it->second.index + 1;
+}
+
+void TerrainVirtualTexture::invalidate(const Material* material) {
+    auto it = m_Entries.find(material);
+    if (it != m_Entries.end()) {
+        releaseEntry(it->second);
+        it->second.signature = 0;
+    }
+}
+
+uint32_t TerrainVirtualTexture::getResidentPageCount() const {
+    return static_cast<uint32_t>(m_PageSlots.size() - m_FreeSlots.size());
+}
+
+int32_t TerrainVirtualTexture::allocateSlot() {
+    if (!m_FreeSlots.empty()) {
+        const int32_t slot = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+        return slot;
+    }
+    // The least recently wanted page that no pixel asked for this frame; top pages stay.
+    int32_t victim = -1;
+    for (size_t i = 0; i < m_PageSlots.size(); ++i) {
+        const PageSlot& slot = m_PageSlots[i];
+        if (!slot.owner || slot.page == kTopPage || slot.lastUsedFrame >= m_Frame) {
+            continue;
+        }
+        if (victim < 0 || slot.lastUsedFrame < m_PageSlots[victim].lastUsedFrame) {
+            victim = static_cast<int32_t>(i);
+        }
+    }
+    if (victim < 0) {
+        return -1;
+    }
+    PageSlot& slot = m_PageSlots[victim];
+    auto owner = m_Entries.find(slot.owner);
+    if (owner != m_Entries.end()) {
+        owner->second.pageSlots[slot.page] = -1;
+        owner->second.indirectionDirty = true;
+    }
+    slot = PageSlot();
+    return victim;
+}
+
+void TerrainVirtualTexture::compositePage(MTL::ComputeCommandEncoder* encoder, const Material* material, Entry& entry,
+                                          uint32_t page, int32_t slot) {
+    const uint32_t mip = PageMip(page);
+    const uint32_t pages = kPagesPerSide >> mip;
+    const uint32_t local = page - kMipOffsets[mip];
+    const float uvPerTexel = 1.0f / static_cast<float>(pages * kPageSize);
+
+    CompositeParamsGPU params = entry.params;
+    params.pageRect[0] = (static_cast<float>((local % pages) * kPageSize) - kPageBorder) * uvPerTexel;
+    params.pageRect[1] = (static_cast<float>((local / pages) * kPageSize) - kPageBorder) * uvPerTexel;
+    params.pageRect[2] = uvPerTexel;
+    params.pageRect[3] = uvPerTexel;
+    params.atlasOrigin[0] = (static_cast<uint32_t>(slot) % kAtlasPagesPerSide) * kPageStride;
+    params.atlasOrigin[1] = (static_cast<uint32_t>(slot) / kAtlasPagesPerSide) * kPageStride;
+
+    encoder->setTextures(entry.sources.data(), NS::Range(0, entry.sources.size()));
+    encoder->setBytes(&params, sizeof(CompositeParamsGPU), 0);
+    encoder->dispatchThreads(MTL::Size(kPageStride, kPageStride, 1), MTL::Size(8, 8, 1));
+
+    PageSlot& pageSlot = m_PageSlots[slot];
+    pageSlot.owner = material;
+    pageSlot.page = page;
+    pageSlot.lastUsedFrame = m_Frame;
+    entry.pageSlots[page] = slot;
+    entry.indirectionDirty = true;
+    if (page == kTopPage) {
+        entry.ready = true;
+    }
+}
+
+void TerrainVirtualTexture::buildIndirection(const Entry& entry, uint32_t* out) const {
+    // RGBA8Uint texels: atlas slot x and y, the mip of the page that is resident, and 1. Missing
+    // pages take their parent's texel, so walk from the top mip down.
+    for (uint32_t mip = kMipCount; mip-- > 0;) {
+        const uint32_t pages = kPagesPerSide >> mip;
+        for (uint32_t y = 0; y < pages; ++y) {
+            for (uint32_t x = 0; x < pages; ++x) {
+                const uint32_t page = kMipOffsets[mip] + y * pages + x;
+                const int32_t slot = entry.pageSlots[page];
+                if (slot >= 0) {
+                    const uint32_t slotX = static_cast<uint32_t>(slot) % kAtlasPagesPerSide;
+                    const uint32_t slotY = static_cast<uint32_t>(slot) / kAtlasPagesPerSide;
+                    out[page] = slotX | (slotY << 8) | (mip << 16) | (1u << 24);
+                } else if (mip + 1 < kMipCount) {
+                    out[page] = out[kMipOffsets[mip + 1] + (y >> 1) * (pages >> 1) + (x >> 1)];
+                } else {
+                    out[page] = mip << 16;
+                }
+            }
+        }
+    }
+}
+
+void TerrainVirtualTexture::encode(MTL::CommandBuffer* commandBuffer) {
+    if (!commandBuffer || !isAvailable()) {
+        return;
+    }
+    // A material acquired this frame needs its top page before it can draw from its pages.
+    for (auto& [material, entry] : m_Entries) {
+        if (!entry.ready && entry.lastUsedFrame == m_Frame) {
+            m_Requests.push_back(Request{material, kTopPage, kMipCount - 1});
+        }
+    }
+    std::sort(m_Requests.begin(), m_Requests.end(), [](const Request& a, const Request& b) {
+        if (a.mip != b.mip) {
+            return a.mip > b.mip;
+        }
+        if (a.material != b.material) {
+            return std::less<const Material*>()(a.material, b.material);
+        }
+        return a.page < b.page;
+    });
+    m_Requests.erase(std::unique(m_Requests.begin(), m_Requests.end(), [](const Request& a, const Request& b) {
+        return a.material == b.material && a.page == b.page;
+    }), m_Requests.end());
+
+    MTL::ComputeCommandEncoder* encoder = nullptr;
+    for (const Request& request : m_Requests) {
+        if (m_PagesComposited >= kPagesPerFrame) {
+            break;
+        }
+        auto it = m_Entries.find(request.material);
+        // Sources are only current for materials acquired this frame.
+        if (it == m_Entries.end() || it->second.lastUsedFrame != m_Frame || it->second.pageSlots[request.page] >= 0) {
+            continue;
+        }
+        const int32_t slot = allocateSlot();
+        if (slot < 0) {
+            break;
+        }
+        if (!encoder) {
+            encoder = commandBuffer->computeCommandEncoder();
+            encoder->setComputePipelineState(m_Pipeline);
+            encoder->setSamplerState(m_Sampler, 0);
+            encoder->setTexture(m_AlbedoAtlas, 10);
+            encoder->setTexture(m_SurfaceAtlas, 11);
+        }
+        compositePage(encoder, request.material, it->second, request.page, slot);
+        ++m_PagesComposited;
+    }
+    if (encoder) {
+        encoder->endEncoding();
+    }
+    m_Requests.clear();
+
+    bool anyDirty = false;
+    for (const auto& [material, entry] : m_Entries) {
+        anyDirty = anyDirty || (entry.ready && entry.indirectionDirty);
+    }
+    if (!anyDirty) {
+        return;
+    }
+    Slot& slot = m_Slots[m_FrameSlot];
+    const size_t bytes = static_cast<size_t>(kMaxTextures) * kPageCount * sizeof(uint32_t);
+    if (!slot.staging) {
+        slot.staging = m_Device->newBuffer(bytes, MTL::ResourceStorageModeShared);
+        if (!slot.staging) {
+            std::cerr << "TerrainVirtualTexture: failed to allocate " << bytes << " bytes of indirection staging\n";
+            // Keep them off their pages until an upload succeeds.
+            for (auto& [material, entry] : m_Entries) {
+                entry.ready = entry.ready && !entry.indirectionDirty;
+            }
+            return;
+        }
+        slot.stagingMemory.reset(MemoryCategory::Textures, bytes);
+    }
+    uint32_t* staging = static_cast<uint32_t*>(slot.staging->contents());
+    MTL::BlitCommandEncoder* blit = commandBuffer->blitCommandEncoder();
+    for (auto& [material, entry] : m_Entries) {
+        if (!entry.ready || !entry.indirectionDirty) {
+            continue;
+        }
+        const size_t base = static_cast<size_t>(entry.index) * kPageCount;
+        buildIndirection(entry, staging + base);
+        for (uint32_t mip = 0; mip < kMipCount; ++mip) {
+            const uint32_t pages = kPagesPerSide >> mip;
+            const NS::UInteger rowBytes = pages * sizeof(uint32_t);
+            blit->copyFromBuffer(slot.staging, (base + kMipOffsets[mip]) * sizeof(uint32_t), rowBytes,
+                                 rowBytes * pages, MTL::Size(pages, pages, 1), m_Indirection, entry.index, mip,
+                                 MTL::Origin(0, 0, 0));
+        }
+        entry.indirectionDirty = false;
+    }
+    blit->endEncoding();
+}
+
+void TerrainVirtualTexture::bind(MTL::RenderCommandEncoder* encoder) const {
+    if (!encoder || !isAvailable()) {
+        return;
+    }
+    ParamsGPU params{};
+    params.pagesPerSide = kPagesPerSide;
+    params.mipCount = kMipCount;
+    params.atlasPagesPerSide = kAtlasPagesPerSide;
+    params.feedbackPhase = static_cast<uint32_t>(m_Frame % kFeedbackPhases);
+    params.feedbackBitsPerTexture = kFeedbackWords * 32;
+    std::copy(kMipOffsets.begin(), kMipOffsets.begin() + kMipCount, params.mipOffsets);
+    encoder->setFragmentBytes(&params, sizeof(ParamsGPU), 13);
+    encoder->setFragmentBuffer(m_Slots[m_FrameSlot].feedback, 0, 14);
+    encoder->setFragmentTexture(m_Indirection, 34);
+    encoder->setFragmentTexture(m_AlbedoAtlas, 35);
+    encoder->setFragmentTexture(m_SurfaceAtlas, 36);
+}
+
+} // namespace Crescent
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace MTL {
+    class Device;
+    class Buffer;
+    class Texture;
+    class CommandBuffer;
+    class ComputeCommandEncoder;
+    class ComputePipelineState;
+    class RenderCommandEncoder;
+    class SamplerState;
+}
+
+namespace Crescent {
+
+class Material;
+
+// Runtime virtual texture for control-mapped terrain materials.
+//
+// Each registered material gets a virtual texture of kPagesPerSide pages across its terrain UV at
+// mip 0 and a full mip chain of pages above it. Pages are composited on demand by
+// terrain_vt_composite (TerrainVirtualTexture.metal), which blends the three layers by the control
+// map into two shared atlases of kAtlasPagesPerSide square page slots, so fragment_main reads one
+// indirection texel and two atlas texels per pixel instead of the control map and nine layers. A
+// sparse set of main pass pixels reports the page it wanted in a feedback bitset per frame slot;
+// beginFrame reads the slot's bits back once its frame completed and encode composites the missing
+// pages, coarse first and a few per frame, evicting the least recently wanted. The single page of
+// the top mip stays resident, and the indirection (one texture array slice per material, rebuilt
+// on the CPU when pages come or go) maps every page to its nearest resident ancestor, so a missing
+// page only shows blurrier for a few frames.
+class TerrainVirtualTexture {
+public:
+    static constexpr uint32_t kMaxFramesInFlight = 4;
+    static constexpr uint32_t kMaxTextures = 4;
+    static constexpr uint32_t kPageSize = 128;
+    static constexpr uint32_t kPageBorder = 4;
+    static constexpr uint32_t kPageStride = kPageSize + 2 * kPageBorder;
+    static constexpr uint32_t kPagesPerSide = 128;
+    static constexpr uint32_t kMipCount = 8;
+    static constexpr uint32_t kAtlasPagesPerSide = 16;
+    static constexpr uint32_t kPagesPerFrame = 8;
+
+    // The material's control map and layers as fragment_main binds them (Renderer's material
+    // table order), fallbacks resolved.
+    using Sources = std::array<MTL::Texture*, 10>;
+
+    TerrainVirtualTexture() = default;
+    ~TerrainVirtualTexture();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_Pipeline != nullptr; }
+
+    // Whether the material can draw from a virtual texture: opaque terrains blended by a control
+    // map. Height and slope blends depend on the world position and stay on direct sampling.
+    static bool IsEligible(const Material* material);
+
+    // The slot's previous command buffer must have completed. Collects the pages its feedback
+    // asked for and drops the materials not drawn for a while.
+    void beginFrame(uint32_t frameSlot);
+    // Keeps the material's virtual texture this frame; a material whose sources or blend changed
+    // starts over. False when the material is not eligible or every texture is taken.
+    bool acquire(const Material& material, const Sources& sources);
+    // One-based texture index for the material's uniforms (terrainParams1.z), 0 while it has no
+    // composited pages or was not acquired this frame.
+    uint32_t find(const Material* material) const;
+    // Drops the material's pages, for edits the signature cannot see, such as painting the
+    // control map in place.
+    void invalidate(const Material* material);
+    // Composites this frame's pages and uploads the changed indirection. Encode before the main pass.
+    void encode(MTL::CommandBuffer* commandBuffer);
+    // Binds the indirection, atlases, params and the slot's feedback for fragment_main.
+    void bind(MTL::RenderCommandEncoder* encoder) const;
+
+    uint32_t getPagesComposited() const { return m_PagesComposited; }
+    uint32_t getResidentPageCount() const;
+
+private:
+    // Matches TerrainVirtualTextureParams in Common.metal.h.
+    struct ParamsGPU {
+        uint32_t pagesPerSide;
+        uint32_t mipCount;
+        uint32_t atlasPagesPerSide;
+        uint32_t feedbackPhase;
+        uint32_t feedbackBitsPerTexture;
+        uint32_t pad[3];
+        uint32_t mipOffsets[kMipCount];
+    };
+    // Matches TerrainVTCompositeParams in TerrainVirtualTexture.metal.
+    struct CompositeParamsGPU {
+        float pageRect[4];
+        float uvTilingOffset[4];
+        float layerTiling[3][4];
+        float blend[4];
+        uint32_t atlasOrigin[2];
+        uint32_t pad[2];
+    };
+    struct Entry {
+        uint32_t index = 0;
+        uint64_t signature = 0;
+        Sources sources{};
+        CompositeParamsGPU params{};
+        // Atlas slot of every page, mips one after another (kMipOffsets), -1 when not resident.
+        std::vector<int32_t> pageSlots;
+        bool ready = false;
+        bool indirectionDirty = true;
+        uint64_t lastUsedFrame = 0;
+    };
+    struct PageSlot {
+        const Material* owner = nullptr;
+        uint32_t page = 0; // index into the owner's pageSlots
+        uint64_t lastUsedFrame = 0;
+    };
+    struct Request {
+        const Material* material = nullptr;
+        uint32_t page = 0;
+        uint32_t mip = 0;
+    };
+    struct Slot {
+        MTL::Buffer* feedback = nullptr;
+        MTL::Buffer* staging = nullptr;
+        TrackedMemory feedbackMemory;
+        TrackedMemory stagingMemory;
+    };
+
+    static uint32_t PageMip(uint32_t page);
+    static uint64_t Signature(const Material& material, const Sources& sources);
+    void releaseEntry(Entry& entry);
+    void requestPage(const Material* material, Entry& entry, uint32_t mip, uint32_t x, uint32_t y);
+    int32_t allocateSlot();
+    void compositePage(MTL::ComputeCommandEncoder* encoder, const Material* material, Entry& entry,
+                       uint32_t page, int32_t slot);
+    void buildIndirection(const Entry& entry, uint32_t* out) const;
+
+    MTL::Device* m_Device = nullptr;
+    MTL::ComputePipelineState* m_Pipeline = nullptr;
+    MTL::SamplerState* m_Sampler = nullptr;
+    MTL::Texture* m_AlbedoAtlas = nullptr;
+    MTL::Texture* m_SurfaceAtlas = nullptr;
+    MTL::Texture* m_Indirection = nullptr;
+    TrackedMemory m_AtlasMemory;
+    TrackedMemory m_IndirectionMemory;
+    std::array<Slot, kMaxFramesInFlight> m_Slots;
+    uint32_t m_FrameSlot = 0;
+    uint64_t m_Frame = 0;
+    std::unordered_map<const Material*, Entry> m_Entries;
+    std::vector<PageSlot> m_PageSlots;
+    std::vector<int32_t> m_FreeSlots;
+    std::vector<Request> m_Requests;
+    uint32_t m_PagesComposited = 0;
+};
+
+} // namespace Crescent
@@ -0,0 +1,150 @@
+#include "TextureStreamer.hpp"
+#include "../Rendering/Texture.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Crescent {
+
+namespace {
+
+// Windows a texture counts as recently used after its last request. The scene and game views
+// close a window each, so a texture only one of them shows is still recent.
+constexpr uint64_t kRecentWindows = 4;
+
+uint32_t CoarsestMip(const Texture2D& texture) {
+    const uint32_t size = std::max(texture.getWidth(), texture.getHeight());
+    uint32_t mip = 0;
+    while (mip + 1 < texture.getFullMipCount() && (size >> (mip + 1)) >= TextureStreamer::kMinResidentSize) {
+        ++mip;
+    }
+    return mip;
+}
+
+// Each level holds about a quarter of the one above it, so a chain starting at mip holds about
+// 4^-mip of the full chain.
+uint64_t BytesFromMip(const Texture2D& texture, uint32_t mip) {
+    return texture.getFullBytes() >> std::min(62u, 2u * mip);
+}
+
+// Rounds toward the finer level so a texel never covers more than a pixel.
+uint32_t MipForResolution(const Texture2D& texture, float resolution, uint32_t coarsest) {
+    if (resolution <= 0.0f) {
+        return coarsest;
+    }
+    const float size = static_cast<float>(std::max(texture.getWidth(), texture.getHeight()));
+    const float mip = std::floor(std::log2(size / resolution));
+    return static_cast<uint32_t>(std::max(0.0f, std::min(static_cast<float>(coarsest), mip)));
+}
+
+} // namespace
+
+TextureStreamer::TextureStreamer()
+    : m_budget(0)
+    , m_window(1)
+    , m_residentBytes(0)
+    , m_loadsInFlight(0) {
+}
+
+void TextureStreamer::requestResolution(const std::shared_ptr<Texture2D>& texture, float resolution) {
+    if (!texture || !texture->isMipStreamable()) {
+        return;
+    }
+    Entry& entry = m_entries[texture.get()];
+    if (entry.texture.expired()) {
+        // New, or a texture reallocated at the address of a released one.
+        entry = Entry();
+        entry.texture = texture;
+        entry.wantedMip = texture->getResidentMip();
+    }
+    entry.resolution = std::max(entry.resolution, resolution);
+    entry.lastUsed = m_window;
+}
+
+void TextureStreamer::update(TextureLoader& loader) {
+    const uint64_t window = m_window++;
+    m_slots.clear();
+    m_residentBytes = 0;
+    m_loadsInFlight = 0;
+    uint64_t total = 0;
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        std::shared_ptr<Texture2D> texture = it->second.texture.lock();
+        if (!texture) {
+            it = m_entries.erase(it);
+            continue;
+        }
+        Entry& entry = it->second;
+        Slot slot;
+        slot.entry = &entry;
+        slot.coarsest = CoarsestMip(*texture);
+        if (entry.lastUsed == window) {
+            entry.wantedMip = MipForResolution(*texture, entry.resolution, slot.coarsest);
+            entry.resolution = 0.0f;
+        }
+        const bool pending = texture->getPendingMip() != Texture2D::kNoPendingMip;
+        slot.current = pending ? texture->getPendingMip() : texture->getResidentMip();
+        slot.target = std::min(slot.current, entry.wantedMip);
+        m_residentBytes += texture->getApproximateBytes();
+        m_loadsInFlight += pending ? 1 : 0;
+        total += BytesFromMip(*texture, slot.target);
+        slot.texture = std::move(texture);
+        m_slots.push_back(std::move(slot));
+        ++it;
+    }
+
+    std::stable_sort(m_slots.begin(), m_slots.end(), [](const Slot& a, const Slot& b) {
+        return a.entry->lastUsed < b.entry->lastUsed;
+    });
+    if (m_budget > 0 && total > m_budget) {
+        auto coarsen = [&](Slot& slot, uint32_t mip) {
+            if (mip <= slot.target) {
+                return;
+            }
+            total -= BytesFromMip(*slot.texture, slot.target) - BytesFromMip(*slot.texture, mip);
+            slot.target = mip;
+        };
+        // Levels finer than needed, least recently used first.
+        for (Slot& slot : m_slots) {
+            if (total <= m_budget) break;
+            coarsen(slot, slot.entry->wantedMip);
+        }
+        // Textures not seen lately drop to their coarsest level.
+        for (Slot& slot : m_slots) {
+            if (total <= m_budget) break;
+            if (slot.entry->lastUsed + kRecentWindows <= window) {
+                coarsen(slot, slot.coarsest);
+            }
+        }
+        // Still over: everything gives up one level per round.
+        bool changed = true;
+        while (total > m_budget && changed) {
+            changed = false;
+            for (Slot& slot : m_slots) {
+                if (total <= m_budget) break;
+                if (slot.target < slot.coarsest) {
+                    coarsen(slot, slot.target + 1);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // Evictions go first so memory is freed before it is spent; sharper levels go to the most
+    // recently used textures first.
+    uint32_t loads = m_loadsInFlight;
+    for (Slot& slot : m_slots) {
+        if (loads >= kMaxLoadsPerUpdate) break;
+        if (slot.target > slot.current && loader.requestResidentMip(slot.texture, slot.target)) {
+            ++loads;
+        }
+    }
+    for (auto it = m_slots.rbegin(); it != m_slots.rend(); ++it) {
+        if (loads >= kMaxLoadsPerUpdate) break;
+        if (it->target < it->current && loader.requestResidentMip(it->texture, it->target)) {
+            ++loads;
+        }
+    }
+    m_loadsInFlight = loads;
+    m_slots.clear();
+}
+
+} // namespace Crescent
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Crescent {
+
+class Texture2D;
+class TextureLoader;
+
+// Decides how many mip levels each cooked texture keeps resident. Draw gathering reports the
+// resolution every sampled texture needs from the screen size of its mesh and the mesh's UV
+// density; update() turns that into a wanted first mip per texture and reloads the ones whose
+// resident range differs. Resident levels finer than wanted are kept like a cache until the
+// budget is exceeded; they are then trimmed least recently used first, followed by textures
+// not seen lately and finally by coarsening everything one level at a time.
+class TextureStreamer {
+public:
+    static constexpr uint32_t kMinResidentSize = 64; // coarsest top level kept resident, in texels
+    static constexpr uint32_t kMaxLoadsPerUpdate = 4;
+
+    TextureStreamer();
+
+    // Bytes the streamed textures may keep resident; 0 means unlimited.
+    void setBudget(uint64_t bytes) { m_budget = bytes; }
+    uint64_t getBudget() const { return m_budget; }
+
+    // resolution is the texel count across one UV unit that keeps one texel per pixel. Textures
+    // that cannot stream mips are ignored.
+    void requestResolution(const std::shared_ptr<Texture2D>& texture, float resolution);
+    // Closes the current request window and issues mip loads. Call once per rendered view, on the
+    // thread that calls TextureLoader::processStreamedTextures.
+    void update(TextureLoader& loader);
+
+    uint32_t getTrackedCount() const { return static_cast<uint32_t>(m_entries.size()); }
+    uint64_t getResidentBytes() const { return m_residentBytes; }
+    uint32_t getMipLoadsInFlight() const { return m_loadsInFlight; }
+
+private:
+    struct Entry {
+        std::weak_ptr<Texture2D> texture;
+        float resolution = 0.0f; // largest request of the open window
+        uint32_t wantedMip = 0;
+        uint64_t lastUsed = 0;
+    };
+
+    struct Slot {
+        Entry* entry = nullptr;
+        std::shared_ptr<Texture2D> texture;
+        uint32_t current = 0; // resident first mip, or the one being loaded
+        uint32_t target = 0;
+        uint32_t coarsest = 0;
+    };
+
+    std::unordered_map<const Texture2D*, Entry> m_entries;
+    std::vector<Slot> m_slots; // scratch for update()
+    uint64_t m_budget;
+    uint64_t m_window;
+    uint64_t m_residentBytes;
+    uint32_t m_loadsInFlight;
+};
+
+} // namespace Crescent
@@ -0,0 +1,266 @@
+#include "TiledPostBlur.hpp"
+#include "ShaderLibrary.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    constexpr size_t kDispatchArgsBytes = sizeof(uint32_t) * 3;
+    constexpr uint32_t kHalfTileSize = TiledPostBlur::kTileSize / 2;
+}
+
+TiledPostBlur::~TiledPostBlur() {
+    shutdown();
+}
+
+bool TiledPostBlur::initialize(MTL::Device* device) {
+    m_Device = device;
+    if (!m_Device) {
+        return false;
+    }
+
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_Device, ShaderLibrary::Module::Core);
+    if (!lib) {
+        std::cerr << "TiledPostBlur: missing default Metal library\n";
+        return false;
+    }
+    bool built = true;
+    auto buildPipeline = [&](const char* kernelName, MTL::ComputePipelineState*& outState) {
+        MTL::Function* func = lib->newFunction(NS::String::string(kernelName, NS::UTF8StringEncoding));
+        if (!func) {
+            std::cerr << "TiledPostBlur: missing " << kernelName << " shader\n";
+            built = false;
+            return;
+        }
+        NS::Error* error = nullptr;
+        outState = m_Device->newComputePipelineState(func, &error);
+        func->release();
+        if (!outState) {
+            std::cerr << "TiledPostBlur: pipeline error for " << kernelName;
+            if (error) {
+                std::cerr << ": " << error->localizedDescription()->utf8String();
+            }
+            std::cerr << "\n";
+            built = false;
+        }
+    };
+    buildPipeline("post_blur_tile_reduce", m_ReducePipeline);
+    buildPipeline("post_blur_tile_classify", m_ClassifyPipeline);
+    buildPipeline("post_blur_tile_copy", m_CopyPipeline);
+    buildPipeline("motion_blur_tile_cheap", m_MotionCheapPipeline);
+    buildPipeline("motion_blur_tile_full", m_MotionFullPipeline);
+    buildPipeline("dof_tile_gather_cheap", m_DofGatherCheapPipeline);
+    buildPipeline("dof_tile_gather_full", m_DofGatherFullPipeline);
+    buildPipeline("dof_tile_composite", m_DofCompositePipeline);
+    // Built last: isAvailable() checks it.
+    if (built) {
+        buildPipeline("post_blur_tile_args", m_ArgsPipeline);
+    }
+    lib->release();
+
+    const size_t argsBytes = kDispatchArgsBytes * ListCount;
+    m_Counters = m_Device->newBuffer(sizeof(uint32_t) * ListCount, MTL::ResourceStorageModePrivate);
+    m_DispatchArgs = m_Device->newBuffer(argsBytes, MTL::ResourceStorageModePrivate);
+    if (!built || !m_Counters || !m_DispatchArgs) {
+        shutdown();
+        return false;
+    }
+    return true;
+}
+
+void TiledPostBlur::shutdown() {
+    MTL::Buffer** buffers[] = {&m_Tiles, &m_Counters, &m_Lists, &m_DispatchArgs};
+    for (MTL::Buffer** buffer : buffers) {
+        if (*buffer) {
+            (*buffer)->release();
+            *buffer = nullptr;
+        }
+    }
+    if (m_HalfTarget) {
+        m_HalfTarget->release();
+        m_HalfTarget = nullptr;
+    }
+    m_BufferMemory.reset();
+    m_HalfTargetMemory.reset();
+    m_TileCapacity = 0;
+    MTL::ComputePipelineState** pipelines[] = {
+        &m_ReducePipeline, &m_ClassifyPipeline, &m_ArgsPipeline, &m_CopyPipeline,
+        &m_MotionCheapPipeline, &m_MotionFullPipeline, &m_DofGatherCheapPipeline,
+        &m_DofGatherFullPipeline, &m_DofCompositePipeline
+    };
+    for (MTL::ComputePipelineState** pipeline : pipelines) {
+        if (*pipeline) {
+            (*pipeline)->release();
+            *pipeline = nullptr;
+        }
+    }
+    m_Device = nullptr;
+}
+
+bool TiledPostBlur::reserve(uint32_t tileCount, uint32_t halfWidth, uint32_t halfHeight) {
+    if (tileCount > m_TileCapacity) {
+        if (m_Tiles) {
+            m_Tiles->release();
+            m_Tiles = nullptr;
+        }
+        if (m_Lists) {
+            m_Lists->release();
+            m_Lists = nullptr;
+        }
+        m_BufferMemory.reset();
+        m_TileCapacity = 0;
+        const size_t tileBytes = sizeof(TileGPU) * tileCount;
+        const size_t listBytes = sizeof(uint32_t) * tileCount * ListCount;
+        m_Tiles = m_Device->newBuffer(tileBytes, MTL::ResourceStorageModePrivate);
+        m_Lists = m_Device->newBuffer(listBytes, MTL::ResourceStorageModePrivate);
+        if (!m_Tiles || !m_Lists) {
+            std::cerr << "TiledPostBlur: failed to allocate tile buffers for " << tileCount << " tiles\n";
+            return false;
+        }
+        m_BufferMemory.reset(MemoryCategory::RenderTargets, tileBytes + listBytes);
+        m_TileCapacity = tileCount;
+    }
+
+    if (!m_HalfTarget || m_HalfTarget->width() < halfWidth || m_HalfTarget->height() < halfHeight) {
+        const uint32_t width = std::max(halfWidth, m_HalfTarget ? static_cast<uint32_t>(m_HalfTarget->width()) : 0u);
+        const uint32_t height = std::max(halfHeight, m_HalfTarget ? static_cast<uint32_t>(m_HalfTarget->height()) : 0u);
+        if (m_HalfTarget) {
+            m_HalfTarget->release();
+            m_HalfTarget = nullptr;
+        }
+        m_HalfTargetMemory.reset();
+        MTL::TextureDescriptor* desc = MTL::TextureDescriptor::texture2DDescriptor(
+            MTL::PixelFormatRGBA16Float, width, height, false);
+        desc->setUsage(MTL::TextureUsageShaderRead | MTL::TextureUsageShaderWrite);
+        desc->setStorageMode(MTL::StorageModePrivate);
+        m_HalfTarget = m_Device->newTexture(desc);
+        if (!m_HalfTarget) {
+            std::cerr << "TiledPostBlur: failed to allocate the half-res target\n";
+            return false;
+        }
+        m_HalfTargetMemory.reset(MemoryCategory::RenderTargets, static_cast<uint64_t>(width) * height * 8);
+    }
+    return true;
+}
+
+bool TiledPostBlur::classify(MTL::ComputeCommandEncoder* encoder, const Frame& frame) {
+    if (!isAvailable() || !encoder || !frame.cameraUniforms || !frame.depth || frame.width == 0 || frame.height == 0) {
+        return false;
+    }
+    const bool motionBlur = frame.motionBlur && frame.velocity;
+    const uint32_t tilesX = (frame.width + kTileSize - 1) / kTileSize;
+    const uint32_t tilesY = (frame.height + kTileSize - 1) / kTileSize;
+    const uint32_t halfWidth = (frame.width + 1) / 2;
+    const uint32_t halfHeight = (frame.height + 1) / 2;
+    if (!reserve(tilesX * tilesY, halfWidth, halfHeight)) {
+        return false;
+    }
+
+    m_Frame = frame;
+    m_Frame.motionBlur = motionBlur;
+    ParamsGPU& params = m_Params;
+    params = ParamsGPU{};
+    params.viewport[0] = static_cast<float>(frame.width);
+    params.viewport[1] = static_cast<float>(frame.height);
+    params.viewport[2] = 1.0f / static_cast<float>(frame.width);
+    params.viewport[3] = 1.0f / static_cast<float>(frame.height);
+    params.motion[0] = std::max(0.0f, std::min(1.0f, frame.motionStrength));
+    params.motion[1] = motionBlur ? 1.0f : 0.0f;
+    params.dof[0] = std::max(0.01f, frame.focusDistance);
+    params.dof[1] = std::max(0.1f, frame.aperture);
+    params.dof[2] = std::max(1.0f, frame.maxBlur);
+    params.dof[3] = frame.depthOfField ? 1.0f : 0.0f;
+    params.halfRes[0] = static_cast<float>(halfWidth);
+    params.halfRes[1] = static_cast<float>(halfHeight);
+    params.halfRes[2] = 1.0f / static_cast<float>(m_HalfTarget->width());
+    params.halfRes[3] = 1.0f / static_cast<float>(m_HalfTarget->height());
+    params.tiles[0] = tilesX;
+    params.tiles[1] = tilesY;
+    params.tiles[2] = m_TileCapacity;
+
+    encoder->setComputePipelineState(m_ReducePipeline);
+    encoder->setBuffer(frame.cameraUniforms, 0, 0);
+    encoder->setBytes(&params, sizeof(ParamsGPU), 1);
+    encoder->setBuffer(m_Tiles, 0, 2);
+    encoder->setBuffer(m_Counters, 0, 3);
+    encoder->setTexture(frame.depth, 0);
+    // Unread while motion blur is off, but the argument must be bound.
+    encoder->setTexture(motionBlur ? frame.velocity : frame.depth, 1);
+    encoder->dispatchThreadgroups(MTL::Size::Make(tilesX, tilesY, 1), MTL::Size::Make(kTileSize, kTileSize, 1));
+
+    encoder->setComputePipelineState(m_ClassifyPipeline);
+    encoder->setBytes(&params, sizeof(ParamsGPU), 0);
+    encoder->setBuffer(m_Tiles, 0, 1);
+    encoder->setBuffer(m_Counters, 0, 2);
+    encoder->setBuffer(m_Lists, 0, 3);
+    encoder->dispatchThreadgroups(MTL::Size::Make((tilesX + 7) / 8, (tilesY + 7) / 8, 1), MTL::Size::Make(8, 8, 1));
+
+    encoder->setComputePipelineState(m_ArgsPipeline);
+    encoder->setBuffer(m_Counters, 0, 0);
+    encoder->setBuffer(m_DispatchArgs, 0, 1);
+    encoder->dispatchThreadgroups(MTL::Size::Make(1, 1, 1), MTL::Size::Make(ListCount, 1, 1));
+    return true;
+}
+
+void TiledPostBlur::dispatchList(MTL::ComputeCommandEncoder* encoder, List list, uint32_t listBufferIndex,
+                                 uint32_t threadsPerSide) const {
+    encoder->setBuffer(m_Lists, sizeof(uint32_t) * m_TileCapacity * list, listBufferIndex);
+    encoder->dispatchThreadgroups(m_DispatchArgs, kDispatchArgsBytes * list,
+                                  MTL::Size::Make(threadsPerSide, threadsPerSide, 1));
+}
+
+void TiledPostBlur::encodeMotionBlur(MTL::ComputeCommandEncoder* encoder, MTL::Texture* source,
+                                     MTL::Texture* target) const {
+    if (!encoder || !source || !target || !m_Frame.motionBlur || m_TileCapacity == 0) {
+        return;
+    }
+    encoder->setComputePipelineState(m_CopyPipeline);
+    encoder->setBytes(&m_Params, sizeof(ParamsGPU), 0);
+    encoder->setTexture(source, 0);
+    encoder->setTexture(target, 1);
+    dispatchList(encoder, MotionCopy, 1, kTileSize);
+
+    encoder->setComputePipelineState(m_MotionCheapPipeline);
+    encoder->setBytes(&m_Params, sizeof(ParamsGPU), 0);
+    encoder->setTexture(source, 0);
+    encoder->setTexture(m_Frame.depth, 1);
+    encoder->setTexture(m_Frame.velocity, 2);
+    encoder->setTexture(target, 3);
+    dispatchList(encoder, MotionCheap, 1, kTileSize);
+
+    encoder->setComputePipelineState(m_MotionFullPipeline);
+    encoder->setBuffer(m_Frame.cameraUniforms, 0, 0);
+    encoder->setBytes(&m_Params, sizeof(ParamsGPU), 1);
+    encoder->setBuffer(m_Tiles, 0, 3);
+    dispatchList(encoder, MotionFull, 2, kTileSize);
+}
+
+void TiledPostBlur::encodeDepthOfField(MTL::ComputeCommandEncoder* encoder, MTL::Texture* source,
+                                       MTL::Texture* target) const {
+    if (!encoder || !source || !target || !m_Frame.depthOfField || m_TileCapacity == 0) {
+        return;
+    }
+    encoder->setComputePipelineState(m_CopyPipeline);
+    encoder->setBytes(&m_Params, sizeof(ParamsGPU), 0);
+    encoder->setTexture(source, 0);
+    encoder->setTexture(target, 1);
+    dispatchList(encoder, DofCopy, 1, kTileSize);
+
+    encoder->setBuffer(m_Frame.cameraUniforms, 0, 0);
+    encoder->setBytes(&m_Params, sizeof(ParamsGPU), 1);
+    encoder->setTexture(source, 0);
+    encoder->setTexture(m_Frame.depth, 1);
+    encoder->setTexture(m_HalfTarget, 2);
+    encoder->setComputePipelineState(m_DofGatherCheapPipeline);
+    dispatchList(encoder, DofGatherCheap, 2, kHalfTileSize);
+    encoder->setComputePipelineState(m_DofGatherFullPipeline);
+    dispatchList(encoder, DofGatherFull, 2, kHalfTileSize);
+
+    encoder->setComputePipelineState(m_DofCompositePipeline);
+    encoder->setTexture(target, 3);
+    dispatchList(encoder, DofComposite, 2, kTileSize);
+}
+
+} // namespace Crescent
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace MTL {
+    class Device;
+    class Buffer;
+    class Texture;
+    class ComputeCommandEncoder;
+    class ComputePipelineState;
+}
+
+namespace Crescent {
+
+// Tile-classified motion blur and depth of field (PostBlur.metal).
+//
+// classify reduces every kTileSize-square tile of the view to its velocity and circle of confusion
+// ranges, widens them to the tile's 3x3 neighbourhood (blur reaches across tile edges) and sorts
+// the tiles into per-effect lists: tiles nothing blurs are copied through, uniform ones take a
+// cheap gather without depth weighting and the rest the full one. Each list is an indirect
+// dispatch of one threadgroup per tile, sized on the GPU, so the cost follows how much of the
+// screen is blurred. Depth of field gathers at half resolution and composites by each pixel's own
+// CoC. The renderer keeps motion_blur_fragment and dof_fragment for when the kernels are missing.
+class TiledPostBlur {
+public:
+    static constexpr uint32_t kTileSize = 16;
+
+    // What classify reads from the view. Radii and speeds are in pixels of the view.
+    struct Frame {
+        MTL::Buffer* cameraUniforms = nullptr;
+        MTL::Texture* depth = nullptr;
+        MTL::Texture* velocity = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        bool motionBlur = false;
+        float motionStrength = 0.0f;
+        bool depthOfField = false;
+        float focusDistance = 1.0f;
+        float aperture = 2.8f;
+        float maxBlur = 12.0f;
+    };
+
+    TiledPostBlur() = default;
+    ~TiledPostBlur();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_ArgsPipeline != nullptr; }
+
+    // Sizes the tile buffers and half-res target for the frame and classifies its tiles for the
+    // effects it enables. Encode before either effect; false when the buffers could not be grown.
+    bool classify(MTL::ComputeCommandEncoder* encoder, const Frame& frame);
+    // Writes every pixel of target from source, blurred where the tiles move.
+    void encodeMotionBlur(MTL::ComputeCommandEncoder* encoder, MTL::Texture* source, MTL::Texture* target) const;
+    // Writes every pixel of target from source, blurred where the tiles are out of focus.
+    void encodeDepthOfField(MTL::ComputeCommandEncoder* encoder, MTL::Texture* source, MTL::Texture* target) const;
+
+private:
+    // Matches the list constants in PostBlur.metal.
+    enum List : uint32_t {
+        MotionCopy,
+        MotionCheap,
+        MotionFull,
+        DofCopy,
+        DofComposite,
+        DofGatherCheap,
+        DofGatherFull,
+        ListCount
+    };
+    // Matches PostBlurParams in PostBlur.metal.
+    struct ParamsGPU {
+        float viewport[4];
+        float motion[4];
+        float dof[4];
+        float halfRes[4];
+        uint32_t tiles[4];
+    };
+    // Matches PostBlurTile in PostBlur.metal.
+    struct TileGPU {
+        float motion[4];
+        float dof[4];
+    };
+
+    bool reserve(uint32_t tileCount, uint32_t halfWidth, uint32_t halfHeight);
+    void dispatchList(MTL::ComputeCommandEncoder* encoder, List list, uint32_t listBufferIndex,
+                      uint32_t threadsPerSide) const;
+
+    MTL::Device* m_Device = nullptr;
+    MTL::ComputePipelineState* m_ReducePipeline = nullptr;
+    MTL::ComputePipelineState* m_ClassifyPipeline = nullptr;
+    MTL::ComputePipelineState* m_ArgsPipeline = nullptr;
+    MTL::ComputePipelineState* m_CopyPipeline = nullptr;
+    MTL::ComputePipelineState* m_MotionCheapPipeline = nullptr;
+    MTL::ComputePipelineState* m_MotionFullPipeline = nullptr;
+    MTL::ComputePipelineState* m_DofGatherCheapPipeline = nullptr;
+    MTL::ComputePipelineState* m_DofGatherFullPipeline = nullptr;
+    MTL::ComputePipelineState* m_DofCompositePipeline = nullptr;
+    // Tiles, list counters, lists and dispatch arguments grow to the largest view seen, as does the
+    // half-res target, so the editor and game views alternating sizes do not reallocate.
+    MTL::Buffer* m_Tiles = nullptr;
+    MTL::Buffer* m_Counters = nullptr;
+    MTL::Buffer* m_Lists = nullptr;
+    MTL::Buffer* m_DispatchArgs = nullptr;
+    MTL::Texture* m_HalfTarget = nullptr;
+    TrackedMemory m_BufferMemory;
+    TrackedMemory m_HalfTargetMemory;
+    uint32_t m_TileCapacity = 0;
+    // The classified frame, for the effects encoded after it.
+    ParamsGPU m_Params{};
+    Frame m_Frame;
+};
+
+} // namespace Crescent
@@ -0,0 +1,123 @@
+#include "UniformRing.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace Crescent {
+
+namespace {
+    constexpr size_t kMinCapacity = 1u << 20;
+
+    size_t AlignUniform(size_t bytes) {
+        return (bytes + (UniformRing::kAlignment - 1)) & ~(UniformRing::kAlignment - 1);
+    }
+}
+
+UniformRing::~UniformRing() {
+    shutdown();
+}
+
+bool UniformRing::initialize(MTL::Device* device) {
+    if (!device) {
+        return false;
+    }
+    m_Device = device;
+    return true;
+}
+
+void UniformRing::shutdown() {
+    for (Slot& slot : m_Slots) {
+        if (slot.buffer) { slot.buffer->release(); slot.buffer = nullptr; }
+        slot.capacity = 0;
+        slot.memory.reset();
+    }
+    m_Device = nullptr;
+    m_Offset.store(0, std::memory_order_relaxed);
+    m_Demand.store(0, std::memory_order_relaxed);
+    m_PeakDemand = 0;
+}
+
+void UniformRing::beginFrame(uint32_t frameSlot) {
+    // The peak decays slowly so one heavy frame does not keep every slot oversized for good.
+    m_PeakDemand = std::max(m_Demand.load(std::memory_order_relaxed), m_PeakDemand - m_PeakDemand / 64);
+    m_FrameSlot = frameSlot % kMaxFramesInFlight;
+    m_Offset.store(0, std::memory_order_relaxed);
+    m_Demand.store(0, std::memory_order_relaxed);
+    m_Overflows.store(0, std::memory_order_relaxed);
+    if (!m_Device) {
+        return;
+    }
+
+    Slot& slot = m_Slots[m_FrameSlot];
+    const size_t wanted = std::max(kMinCapacity, m_PeakDemand + m_PeakDemand / 4);
+    if (slot.buffer && slot.capacity >= wanted) {
+        return;
+    }
+    MTL::Buffer* buffer = m_Device->newBuffer(wanted, MTL::ResourceStorageModeShared);
+    if (!buffer) {
+        return;
+    }
+    if (slot.buffer) {
+        slot.buffer->release();
+    }
+    slot.buffer = buffer;
+    slot.capacity = buffer->length();
+    slot.memory.reset(MemoryCategory::Instances, slot.capacity);
+}
+
+size_t UniformRing::write(const void* bytes, size_t length) {
+    const Slot& slot = m_Slots[m_FrameSlot];
+    const size_t aligned = AlignUniform(length);
+    m_Demand.fetch_add(aligned, std::memory_order_relaxed);
+    if (!slot.buffer) {
+        return std::numeric_limits<size_t>::max();
+    }
+    const size_t offset = m_Offset.fetch_add(aligned, std::memory_order_relaxed);
+    if (offset + length > slot.capacity) {
+        m_Overflows.fetch_add(1, std::memory_order_relaxed);
+        return std::numeric_limits<size_t>::max();
+    }
+    std::memcpy(static_cast<uint8_t*>(slot.buffer->contents()) + offset, bytes, length);
+    return offset;
+}
+
+bool UniformRing::Binder::setVertexBytes(MTL::RenderCommandEncoder* encoder, const void* bytes, size_t length,
+                                         uint32_t index) {
+    if (!m_Ring) {
+        return false;
+    }
+    const size_t offset = m_Ring->write(bytes, length);
+    if (offset == std::numeric_limits<size_t>::max()) {
+        return false;
+    }
+    if (m_VertexBound & IndexBit(index)) {
+        encoder->setVertexBufferOffset(offset, index);
+    } else {
+        encoder->setVertexBuffer(m_Ring->getBuffer(), offset, index);
+        m_VertexBound |= IndexBit(index);
+    }
+    m_BytesWritten += length;
+    return true;
+}
+
+bool UniformRing::Binder::setFragmentBytes(MTL::RenderCommandEncoder* encoder, const void* bytes, size_t length,
+                                           uint32_t index) {
+    if (!m_Ring) {
+        return false;
+    }
+    const size_t offset = m_Ring->write(bytes, length);
+    if (offset == std::numeric_limits<size_t>::max()) {
+        return false;
+    }
+    if (m_FragmentBound & IndexBit(index)) {
+        encoder->setFragmentBufferOffset(offset, index);
+    } else {
+        encoder->setFragmentBuffer(m_Ring->getBuffer(), offset, index);
+        m_FragmentBound |= IndexBit(index);
+    }
+    m_BytesWritten += length;
+    return true;
+}
+
+} // namespace Crescent
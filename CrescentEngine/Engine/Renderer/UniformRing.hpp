@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../Core/MemoryTracker.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace MTL {
+    class Device;
+    class Buffer;
+    class RenderCommandEncoder;
+}
+
+namespace Crescent {
+
+// Per-frame ring for per-draw constants (model, material and mesh uniforms, shadow caster
+// parameters). Each frame slot owns one shared buffer that draws suballocate with an atomic bump,
+// so parallel sub-encoders write into it without locking. An encoder binds the slot buffer once
+// per argument index through a Binder and moves only its offset for each further draw. The buffer
+// is never replaced mid-frame: a write that does not fit fails and the caller falls back to inline
+// bytes, and the next beginFrame of that slot grows it to the demand seen.
+class UniformRing {
+public:
+    static constexpr uint32_t kMaxFramesInFlight = 4;
+    // Constant buffer offsets must be 256-byte aligned on macOS.
+    static constexpr size_t kAlignment = 256;
+
+    // Tracks which argument indices of one encoder hold the ring, so later writes to the same
+    // index only update the offset. Anything else bound to a tracked index must be reported with
+    // forgetVertex/forgetFragment.
+    class Binder {
+    public:
+        Binder() = default;
+        explicit Binder(UniformRing* ring) : m_Ring(ring) {}
+
+        // False when there is no ring or it is full; nothing is bound then.
+        bool setVertexBytes(MTL::RenderCommandEncoder* encoder, const void* bytes, size_t length, uint32_t index);
+        bool setFragmentBytes(MTL::RenderCommandEncoder* encoder, const void* bytes, size_t length, uint32_t index);
+        void forgetVertex(uint32_t index) { m_VertexBound &= ~IndexBit(index); }
+        void forgetFragment(uint32_t index) { m_FragmentBound &= ~IndexBit(index); }
+
+        uint64_t bytesWritten() const { return m_BytesWritten; }
+
+    private:
+        static uint32_t IndexBit(uint32_t index) { return index < 32 ? (1u << index) : 0u; }
+
+        UniformRing* m_Ring = nullptr;
+        uint32_t m_VertexBound = 0;
+        uint32_t m_FragmentBound = 0;
+        uint64_t m_BytesWritten = 0;
+    };
+
+    UniformRing() = default;
+    ~UniformRing();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_Device != nullptr; }
+
+    // Rewinds the slot, growing it to the largest demand of its recent frames; the slot's previous
+    // command buffer must have completed.
+    void beginFrame(uint32_t frameSlot);
+    // Copies length bytes into the current slot. Returns the offset, or SIZE_MAX when full.
+    size_t write(const void* bytes, size_t length);
+    MTL::Buffer* getBuffer() const { return m_Slots[m_FrameSlot].buffer; }
+
+    uint64_t getUsedBytes() const { return m_Offset.load(std::memory_order_relaxed); }
+    uint32_t getOverflowCount() const { return m_Overflows.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        MTL::Buffer* buffer = nullptr;
+        size_t capacity = 0;
+        TrackedMemory memory;
+    };
+
+    MTL::Device* m_Device = nullptr;
+    std::array<Slot, kMaxFramesInFlight> m_Slots;
+    uint32_t m_FrameSlot = 0;
+    std::atomic<size_t> m_Offset{0};
+    std::atomic<size_t> m_Demand{0}; // bytes asked for this frame, including failed writes
+    std::atomic<uint32_t> m_Overflows{0};
+    size_t m_PeakDemand = 0;
+};
+
+} // namespace Crescent
@@ -0,0 +1,260 @@
+#include "VariableRateShading.hpp"
+#include "ShaderLibrary.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    // Rates are quantized so small camera-driven changes do not rebuild the map every frame.
+    constexpr float kRateStep = 0.125f;
+    constexpr float kMinRate = 0.25f;
+
+    float QuantizeRate(float rate) {
+        const float clamped = std::max(kMinRate, std::min(1.0f, rate));
+        return std::round(clamped / kRateStep) * kRateStep;
+    }
+
+    MTL::Function* LoadFunction(MTL::Library* lib, const char* name) {
+        MTL::Function* func = lib->newFunction(NS::String::string(name, NS::UTF8StringEncoding));
+        if (!func) {
+            std::cerr << "VariableRateShading: missing " << name << " shader\n";
+        }
+        return func;
+    }
+}
+
+VariableRateShading::VariableRateShading()
+    : m_device(nullptr)
+    , m_depthPrimePipeline(nullptr)
+    , m_resolvePipeline(nullptr)
+    , m_depthPrimeState(nullptr)
+    , m_rateMap(nullptr)
+    , m_rateMapParams(nullptr)
+    , m_colorTarget(nullptr)
+    , m_depthTarget(nullptr)
+    , m_width(0)
+    , m_height(0)
+    , m_colorFormat(0)
+    , m_pipelineFormat(0)
+    , m_shadedPixelRatio(1.0f)
+    , m_memorylessDepth(false) {
+}
+
+VariableRateShading::~VariableRateShading() {
+    shutdown();
+}
+
+bool VariableRateShading::initialize(MTL::Device* device) {
+    m_device = device;
+    if (!m_device) {
+        return false;
+    }
+    if (!m_device->supportsRasterizationRateMap(1)) {
+        std::cerr << "VariableRateShading: rasterization rate maps are not supported on this device\n";
+        return false;
+    }
+    m_memorylessDepth = m_device->supportsFamily(MTL::GPUFamilyApple1);
+
+    MTL::DepthStencilDescriptor* depthDesc = MTL::DepthStencilDescriptor::alloc()->init();
+    depthDesc->setDepthCompareFunction(MTL::CompareFunctionAlways);
+    depthDesc->setDepthWriteEnabled(true);
+    m_depthPrimeState = m_device->newDepthStencilState(depthDesc);
+    depthDesc->release();
+    return m_depthPrimeState != nullptr;
+}
+
+void VariableRateShading::shutdown() {
+    releaseMap();
+    if (m_depthPrimePipeline) { m_depthPrimePipeline->release(); m_depthPrimePipeline = nullptr; }
+    if (m_resolvePipeline) { m_resolvePipeline->release(); m_resolvePipeline = nullptr; }
+    if (m_depthPrimeState) { m_depthPrimeState->release(); m_depthPrimeState = nullptr; }
+    m_pipelineFormat = 0;
+    m_device = nullptr;
+}
+
+void VariableRateShading::releaseMap() {
+    if (m_rateMap) { m_rateMap->release(); m_rateMap = nullptr; }
+    if (m_rateMapParams) { m_rateMapParams->release(); m_rateMapParams = nullptr; }
+    if (m_colorTarget) { m_colorTarget->release(); m_colorTarget = nullptr; }
+    if (m_depthTarget) { m_depthTarget->release(); m_depthTarget = nullptr; }
+    m_width = 0;
+    m_height = 0;
+    m_colorFormat = 0;
+    m_shadedPixelRatio = 1.0f;
+}
+
+bool VariableRateShading::buildPipelines(uint32_t colorFormat) {
+    if (m_pipelineFormat == colorFormat && m_depthPrimePipeline && m_resolvePipeline) {
+        return true;
+    }
+    if (m_depthPrimePipeline) { m_depthPrimePipeline->release(); m_depthPrimePipeline = nullptr; }
+    if (m_resolvePipeline) { m_resolvePipeline->release(); m_resolvePipeline = nullptr; }
+    m_pipelineFormat = 0;
+
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_device, ShaderLibrary::Module::Core);
+    if (!lib) {
+        std::cerr << "VariableRateShading: missing default Metal library\n";
+        return false;
+    }
+    MTL::Function* vertexFunc = LoadFunction(lib, "rate_map_vertex");
+    MTL::Function* depthFunc = LoadFunction(lib, "rate_map_depth_prime_fragment");
+    MTL::Function* resolveFunc = LoadFunction(lib, "rate_map_resolve_fragment");
+    lib->release();
+
+    NS::Error* error = nullptr;
+    if (vertexFunc && depthFunc && resolveFunc) {
+        const MTL::PixelFormat format = static_cast<MTL::PixelFormat>(colorFormat);
+
+        MTL::RenderPipelineDescriptor* desc = MTL::RenderPipelineDescriptor::alloc()->init();
+        desc->setVertexFunction(vertexFunc);
+        desc->setFragmentFunction(depthFunc);
+        desc->colorAttachments()->object(0)->setPixelFormat(format);
+        desc->colorAttachments()->object(0)->setWriteMask(MTL::ColorWriteMaskNone);
+        desc->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
+        m_depthPrimePipeline = m_device->newRenderPipelineState(desc, &error);
+        if (!m_depthPrimePipeline && error) {
+            std::cerr << "VariableRateShading: depth prime pipeline error "
+                      << error->localizedDescription()->utf8String() << "\n";
+        }
+        desc->release();
+
+        error = nullptr;
+        desc = MTL::RenderPipelineDescriptor::alloc()->init();
+        desc->setVertexFunction(vertexFunc);
+        desc->setFragmentFunction(resolveFunc);
+        desc->colorAttachments()->object(0)->setPixelFormat(format);
+        m_resolvePipeline = m_device->newRenderPipelineState(desc, &error);
+        if (!m_resolvePipeline && error) {
+            std::cerr << "VariableRateShading: resolve pipeline error "
+                      << error->localizedDescription()->utf8String() << "\n";
+        }
+        desc->release();
+    }
+    if (vertexFunc) vertexFunc->release();
+    if (depthFunc) depthFunc->release();
+    if (resolveFunc) resolveFunc->release();
+
+    if (!m_depthPrimePipeline || !m_resolvePipeline) {
+        return false;
+    }
+    m_pipelineFormat = colorFormat;
+    return true;
+}
+
+bool VariableRateShading::update(uint32_t width, uint32_t height, uint32_t colorFormat, const Rates& rates) {
+    if (!isAvailable() || width == 0 || height == 0) {
+        return false;
+    }
+    Rates quantized;
+    quantized.center = QuantizeRate(rates.center);
+    quantized.periphery = std::min(quantized.center, QuantizeRate(rates.periphery));
+
+    if (m_rateMap && width == m_width && height == m_height && colorFormat == m_colorFormat &&
+        quantized.center == m_rates.center && quantized.periphery == m_rates.periphery) {
+        return true;
+    }
+    releaseMap();
+    if (!buildPipelines(colorFormat)) {
+        return false;
+    }
+
+    // Zones: edge, falloff, center, falloff, edge. The map interpolates between samples, so the
+    // falloff zones keep the rate change gradual.
+    const float mid = 0.5f * (quantized.center + quantized.periphery);
+    const float samples[5] = { quantized.periphery, mid, quantized.center, mid, quantized.periphery };
+    MTL::RasterizationRateLayerDescriptor* layer =
+        MTL::RasterizationRateLayerDescriptor::alloc()->init(MTL::Size(5, 5, 0), samples, samples);
+    MTL::RasterizationRateMapDescriptor* mapDesc = MTL::RasterizationRateMapDescriptor::alloc()->init();
+    mapDesc->setScreenSize(MTL::Size(width, height, 0));
+    mapDesc->setLayer(layer, 0);
+    mapDesc->setLabel(NS::String::string("Main Pass Rate Map", NS::UTF8StringEncoding));
+    m_rateMap = m_device->newRasterizationRateMap(mapDesc);
+    mapDesc->release();
+    layer->release();
+    if (!m_rateMap) {
+        std::cerr << "VariableRateShading: failed to create rasterization rate map\n";
+        return false;
+    }
+
+    const MTL::SizeAndAlign paramsSize = m_rateMap->parameterBufferSizeAndAlign();
+    m_rateMapParams = m_device->newBuffer(paramsSize.size, MTL::ResourceStorageModeShared);
+    if (m_rateMapParams) {
+        m_rateMap->copyParameterDataToBuffer(m_rateMapParams, 0);
+    }
+
+    const MTL::Size physical = m_rateMap->physicalSize(0);
+    MTL::TextureDescriptor* colorDesc = MTL::TextureDescriptor::alloc()->init();
+    colorDesc->setTextureType(MTL::TextureType2D);
+    colorDesc->setPixelFormat(static_cast<MTL::PixelFormat>(colorFormat));
+    colorDesc->setWidth(physical.width);
+    colorDesc->setHeight(physical.height);
+    colorDesc->setStorageMode(MTL::StorageModePrivate);
+    colorDesc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
+    m_colorTarget = m_device->newTexture(colorDesc);
+    colorDesc->release();
+
+    MTL::TextureDescriptor* depthDesc = MTL::TextureDescriptor::alloc()->init();
+    depthDesc->setTextureType(MTL::TextureType2D);
+    depthDesc->setPixelFormat(MTL::PixelFormatDepth32Float);
+    depthDesc->setWidth(physical.width);
+    depthDesc->setHeight(physical.height);
+    depthDesc->setStorageMode(m_memorylessDepth ? MTL::StorageModeMemoryless : MTL::StorageModePrivate);
+    depthDesc->setUsage(MTL::TextureUsageRenderTarget);
+    m_depthTarget = m_device->newTexture(depthDesc);
+    depthDesc->release();
+
+    if (!m_rateMapParams || !m_colorTarget || !m_depthTarget) {
+        std::cerr << "VariableRateShading: failed to allocate rate map targets\n";
+        releaseMap();
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_colorFormat = colorFormat;
+    m_rates = quantized;
+    m_shadedPixelRatio = static_cast<float>(physical.width * physical.height) /
+        static_cast<float>(static_cast<uint64_t>(width) * height);
+    return true;
+}
+
+void VariableRateShading::encodeDepthPrime(MTL::RenderCommandEncoder* encoder, MTL::Texture* screenDepth) const {
+    if (!encoder || !screenDepth || !m_rateMap) {
+        return;
+    }
+    encoder->pushDebugGroup(NS::String::string("Rate Map Depth Prime", NS::UTF8StringEncoding));
+    encoder->setRenderPipelineState(m_depthPrimePipeline);
+    encoder->setDepthStencilState(m_depthPrimeState);
+    encoder->setCullMode(MTL::CullModeNone);
+    encoder->setFragmentBuffer(m_rateMapParams, 0, 0);
+    encoder->setFragmentTexture(screenDepth, 0);
+    encoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
+    encoder->popDebugGroup();
+}
+
+void VariableRateShading::encodeResolve(MTL::CommandBuffer* commandBuffer, MTL::Texture* target) const {
+    if (!commandBuffer || !target || !m_rateMap) {
+        return;
+    }
+    MTL::RenderPassDescriptor* pass = MTL::RenderPassDescriptor::alloc()->init();
+    MTL::RenderPassColorAttachmentDescriptor* color = pass->colorAttachments()->object(0);
+    color->setTexture(target);
+    color->setLoadAction(MTL::LoadActionDontCare);
+    color->setStoreAction(MTL::StoreActionStore);
+    MTL::RenderCommandEncoder* encoder = commandBuffer->renderCommandEncoder(pass);
+    pass->release();
+    if (!encoder) {
+        return;
+    }
+    encoder->setLabel(NS::String::string("Rate Map Resolve", NS::UTF8StringEncoding));
+    encoder->setRenderPipelineState(m_resolvePipeline);
+    encoder->setFragmentBuffer(m_rateMapParams, 0, 0);
+    encoder->setFragmentTexture(m_colorTarget, 0);
+    encoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
+    encoder->endEncoding();
+}
+
+} // namespace Crescent
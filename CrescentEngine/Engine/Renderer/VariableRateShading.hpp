@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+namespace MTL {
+    class Device;
+    class Buffer;
+    class CommandBuffer;
+    class DepthStencilState;
+    class RasterizationRateMap;
+    class RenderCommandEncoder;
+    class RenderPipelineState;
+    class Texture;
+}
+
+namespace Crescent {
+
+// Rasterization-rate-map mode for the game view's main pass. The screen is split into a 5x5 grid
+// whose rows and columns fall off from the center rate to the edge rate; the main pass renders into
+// physical-size color/depth targets through the map, is primed with the prepass depth, and is
+// expanded back into the screen-size HDR target before any post pass reads it.
+class VariableRateShading {
+public:
+    // Shading rates per axis in (0, 1]; 1 shades every pixel.
+    struct Rates {
+        float center = 1.0f;
+        float periphery = 1.0f;
+    };
+
+    VariableRateShading();
+    ~VariableRateShading();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_depthPrimeState != nullptr; }
+
+    // Rebuilds the map and the physical targets when the screen size, color format or quantized
+    // rates change. Returns false when the map could not be built; the pass then runs at full rate.
+    bool update(uint32_t width, uint32_t height, uint32_t colorFormat, const Rates& rates);
+
+    MTL::RasterizationRateMap* getRateMap() const { return m_rateMap; }
+    MTL::Texture* getColorTarget() const { return m_colorTarget; }
+    MTL::Texture* getDepthTarget() const { return m_depthTarget; }
+    // Physical over screen pixel count of the current map.
+    float getShadedPixelRatio() const { return m_shadedPixelRatio; }
+
+    // First draw of the rate-mapped pass: writes the screen-space prepass depth into the physical
+    // depth target.
+    void encodeDepthPrime(MTL::RenderCommandEncoder* encoder, MTL::Texture* screenDepth) const;
+    // Expands the physical color target into the screen-size target.
+    void encodeResolve(MTL::CommandBuffer* commandBuffer, MTL::Texture* target) const;
+
+private:
+    bool buildPipelines(uint32_t colorFormat);
+    void releaseMap();
+
+    MTL::Device* m_device;
+    MTL::RenderPipelineState* m_depthPrimePipeline;
+    MTL::RenderPipelineState* m_resolvePipeline;
+    MTL::DepthStencilState* m_depthPrimeState;
+    MTL::RasterizationRateMap* m_rateMap;
+    MTL::Buffer* m_rateMapParams;
+    MTL::Texture* m_colorTarget;
+    MTL::Texture* m_depthTarget;
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_colorFormat;
+    uint32_t m_pipelineFormat;
+    Rates m_rates;
+    float m_shadedPixelRatio;
+    bool m_memorylessDepth;
+};
+
+} // namespace Crescent
@@ -0,0 +1,304 @@
+#include "WeightedTransparency.hpp"
+#include "ShaderLibrary.hpp"
+#include <Metal/Metal.hpp>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    MTL::Function* LoadFunction(MTL::Library* lib, const char* name) {
+        MTL::Function* func = lib->newFunction(NS::String::string(name, NS::UTF8StringEncoding));
+        if (!func) {
+            std::cerr << "WeightedTransparency: missing " << name << " shader\n";
+        }
+        return func;
+    }
+
+    MTL::Texture* NewTarget(MTL::Device* device, MTL::PixelFormat format, uint32_t width, uint32_t height) {
+        MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+        desc->setTextureType(MTL::TextureType2D);
+        desc->setPixelFormat(format);
+        desc->setWidth(width);
+        desc->setHeight(height);
+        desc->setStorageMode(MTL::StorageModePrivate);
+        desc->setUsage(MTL::TextureUsageRenderTarget | MTL::TextureUsageShaderRead);
+        MTL::Texture* texture = device->newTexture(desc);
+        desc->release();
+        return texture;
+    }
+
+    void ReleaseTexture(MTL::Texture*& texture) {
+        if (texture) {
+            texture->release();
+            texture = nullptr;
+        }
+    }
+}
+
+WeightedTransparency::WeightedTransparency()
+    : m_device(nullptr)
+    , m_depthDownsamplePipeline(nullptr)
+    , m_compositePipeline(nullptr)
+    , m_upsamplePipeline(nullptr)
+    , m_depthWriteState(nullptr)
+    , m_accumulation(nullptr)
+    , m_revealage(nullptr)
+    , m_lowAccumulation(nullptr)
+    , m_lowRevealage(nullptr)
+    , m_lowDepth(nullptr)
+    , m_width(0)
+    , m_height(0)
+    , m_pipelineFormat(0) {
+}
+
+WeightedTransparency::~WeightedTransparency() {
+    shutdown();
+}
+
+bool WeightedTransparency::initialize(MTL::Device* device) {
+    m_device = device;
+    if (!m_device) {
+        return false;
+    }
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_device, ShaderLibrary::Module::Core);
+    if (!lib) {
+        std::cerr << "WeightedTransparency: missing default Metal library\n";
+        return false;
+    }
+    MTL::Function* vertexFunc = LoadFunction(lib, "transparency_vertex");
+    MTL::Function* depthFunc = LoadFunction(lib, "transparency_depth_downsample_fragment");
+    lib->release();
+
+    if (vertexFunc && depthFunc) {
+        NS::Error* error = nullptr;
+        MTL::RenderPipelineDescriptor* desc = MTL::RenderPipelineDescriptor::alloc()->init();
+        desc->setVertexFunction(vertexFunc);
+        desc->setFragmentFunction(depthFunc);
+        desc->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
+        m_depthDownsamplePipeline = m_device->newRenderPipelineState(desc, &error);
+        if (!m_depthDownsamplePipeline && error) {
+            std::cerr << "WeightedTransparency: depth downsample pipeline error "
+                      << error->localizedDescription()->utf8String() << "\n";
+        }
+        desc->release();
+    }
+    if (vertexFunc) vertexFunc->release();
+    if (depthFunc) depthFunc->release();
+
+    MTL::DepthStencilDescriptor* depthDesc = MTL::DepthStencilDescriptor::alloc()->init();
+    depthDesc->setDepthCompareFunction(MTL::CompareFunctionAlways);
+    depthDesc->setDepthWriteEnabled(true);
+    m_depthWriteState = m_device->newDepthStencilState(depthDesc);
+    depthDesc->release();
+
+    if (!m_depthDownsamplePipeline || !m_depthWriteState) {
+        shutdown();
+        return false;
+    }
+    return true;
+}
+
+void WeightedTransparency::shutdown() {
+    releaseTargets();
+    if (m_depthDownsamplePipeline) { m_depthDownsamplePipeline->release(); m_depthDownsamplePipeline = nullptr; }
+    if (m_compositePipeline) { m_compositePipeline->release(); m_compositePipeline = nullptr; }
+    if (m_upsamplePipeline) { m_upsamplePipeline->release(); m_upsamplePipeline = nullptr; }
+    if (m_depthWriteState) { m_depthWriteState->release(); m_depthWriteState = nullptr; }
+    m_pipelineFormat = 0;
+    m_device = nullptr;
+}
+
+void WeightedTransparency::releaseTargets() {
+    ReleaseTexture(m_accumulation);
+    ReleaseTexture(m_revealage);
+    ReleaseTexture(m_lowAccumulation);
+    ReleaseTexture(m_lowRevealage);
+    ReleaseTexture(m_lowDepth);
+    m_width = 0;
+    m_height = 0;
+}
+
+bool WeightedTransparency::buildCompositePipelines(uint32_t colorFormat) {
+    if (m_pipelineFormat == colorFormat && m_compositePipeline && m_upsamplePipeline) {
+        return true;
+    }
+    if (m_compositePipeline) { m_compositePipeline->release(); m_compositePipeline = nullptr; }
+    if (m_upsamplePipeline) { m_upsamplePipeline->release(); m_upsamplePipeline = nullptr; }
+    m_pipelineFormat = 0;
+
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_device, ShaderLibrary::Module::Core);
+    if (!lib) {
+        std::cerr << "WeightedTransparency: missing default Metal library\n";
+        return false;
+    }
+    MTL::Function* vertexFunc = LoadFunction(lib, "transparency_vertex");
+    MTL::Function* compositeFunc = LoadFunction(lib, "transparency_composite_fragment");
+    MTL::Function* upsampleFunc = LoadFunction(lib, "transparency_upsample_fragment");
+    lib->release();
+
+    auto build = [&](MTL::Function* fragmentFunc, const char* label) -> MTL::RenderPipelineState* {
+        NS::Error* error = nullptr;
+        MTL::RenderPipelineDescriptor* desc = MTL::RenderPipelineDescriptor::alloc()->init();
+        desc->setVertexFunction(vertexFunc);
+        desc->setFragmentFunction(fragmentFunc);
+        MTL::RenderPipelineColorAttachmentDescriptor* color = desc->colorAttachments()->object(0);
+        color->setPixelFormat(static_cast<MTL::PixelFormat>(colorFormat));
+        color->setBlendingEnabled(true);
+        color->setSourceRGBBlendFactor(MTL::BlendFactorSourceAlpha);
+        color->setDestinationRGBBlendFactor(MTL::BlendFactorOneMinusSourceAlpha);
+        color->setSourceAlphaBlendFactor(MTL::BlendFactorOne);
+        color->setDestinationAlphaBlendFactor(MTL::BlendFactorOneMinusSourceAlpha);
+        MTL::RenderPipelineState* state = m_device->newRenderPipelineState(desc, &error);
+        if (!state && error) {
+            std::cerr << "WeightedTransparency: " << label << " pipeline error "
+                      << error->localizedDescription()->utf8String() << "\n";
+        }
+        desc->release();
+        return state;
+    };
+    if (vertexFunc && compositeFunc && upsampleFunc) {
+        m_compositePipeline = build(compositeFunc, "composite");
+        m_upsamplePipeline = build(upsampleFunc, "upsample");
+    }
+    if (vertexFunc) vertexFunc->release();
+    if (compositeFunc) compositeFunc->release();
+    if (upsampleFunc) upsampleFunc->release();
+
+    if (!m_compositePipeline || !m_upsamplePipeline) {
+        return false;
+    }
+    m_pipelineFormat = colorFormat;
+    return true;
+}
+
+bool WeightedTransparency::prepare(uint32_t width, uint32_t height, uint32_t colorFormat,
+                                   bool fullResolution, bool lowResolution) {
+    if (!isAvailable() || width == 0 || height == 0 || !buildCompositePipelines(colorFormat)) {
+        return false;
+    }
+    if (width != m_width || height != m_height) {
+        releaseTargets();
+        m_width = width;
+        m_height = height;
+    }
+    // Each set is allocated the first frame it is used at this size and kept after.
+    if (fullResolution && !m_accumulation) {
+        m_accumulation = NewTarget(m_device, MTL::PixelFormatRGBA16Float, width, height);
+        m_revealage = NewTarget(m_device, MTL::PixelFormatR16Float, width, height);
+    }
+    if (lowResolution && !m_lowAccumulation) {
+        const uint32_t lowWidth = (width + 1) / 2;
+        const uint32_t lowHeight = (height + 1) / 2;
+        m_lowAccumulation = NewTarget(m_device, MTL::PixelFormatRGBA16Float, lowWidth, lowHeight);
+        m_lowRevealage = NewTarget(m_device, MTL::PixelFormatR16Float, lowWidth, lowHeight);
+        m_lowDepth = NewTarget(m_device, MTL::PixelFormatDepth32Float, lowWidth, lowHeight);
+    }
+    if ((fullResolution && (!m_accumulation || !m_revealage))
+        || (lowResolution && (!m_lowAccumulation || !m_lowRevealage || !m_lowDepth))) {
+        std::cerr << "WeightedTransparency: failed to allocate accumulation targets\n";
+        releaseTargets();
+        return false;
+    }
+    return true;
+}
+
+MTL::Viewport WeightedTransparency::LowResolutionViewport(const MTL::Viewport& viewport) {
+    return MTL::Viewport{
+        viewport.originX * 0.5, viewport.originY * 0.5,
+        viewport.width * 0.5, viewport.height * 0.5,
+        viewport.znear, viewport.zfar
+    };
+}
+
+void WeightedTransparency::encodeDepthDownsample(MTL::CommandBuffer* commandBuffer, MTL::Texture* sceneDepth,
+                                                 const MTL::Viewport& viewport) const {
+    if (!commandBuffer || !sceneDepth || !m_lowDepth) {
+        return;
+    }
+    MTL::RenderPassDescriptor* pass = MTL::RenderPassDescriptor::alloc()->init();
+    pass->depthAttachment()->setTexture(m_lowDepth);
+    pass->depthAttachment()->setLoadAction(MTL::LoadActionDontCare);
+    pass->depthAttachment()->setStoreAction(MTL::StoreActionStore);
+    MTL::RenderCommandEncoder* encoder = commandBuffer->renderCommandEncoder(pass);
+    pass->release();
+    if (!encoder) {
+        return;
+    }
+    encoder->setLabel(NS::String::string("Transparency Depth Downsample", NS::UTF8StringEncoding));
+    encoder->setRenderPipelineState(m_depthDownsamplePipeline);
+    encoder->setDepthStencilState(m_depthWriteState);
+    encoder->setViewport(LowResolutionViewport(viewport));
+    encoder->setFragmentTexture(sceneDepth, 0);
+    encoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
+    encoder->endEncoding();
+}
+
+MTL::RenderPassDescriptor* WeightedTransparency::newAccumulationPass(bool lowResolution, MTL::Texture* sceneDepth) const {
+    MTL::Texture* accumulation = lowResolution ? m_lowAccumulation : m_accumulation;
+    MTL::Texture* revealage = lowResolution ? m_lowRevealage : m_revealage;
+    MTL::Texture* depth = lowResolution ? m_lowDepth : sceneDepth;
+    if (!accumulation || !revealage || !depth) {
+        return nullptr;
+    }
+    MTL::RenderPassDescriptor* pass = MTL::RenderPassDescriptor::alloc()->init();
+    MTL::RenderPassColorAttachmentDescriptor* accum = pass->colorAttachments()->object(0);
+    accum->setTexture(accumulation);
+    accum->setLoadAction(MTL::LoadActionClear);
+    accum->setStoreAction(MTL::StoreActionStore);
+    accum->setClearColor(MTL::ClearColor::Make(0.0, 0.0, 0.0, 0.0));
+    MTL::RenderPassColorAttachmentDescriptor* reveal = pass->colorAttachments()->object(1);
+    reveal->setTexture(revealage);
+    reveal->setLoadAction(MTL::LoadActionClear);
+    reveal->setStoreAction(MTL::StoreActionStore);
+    reveal->setClearColor(MTL::ClearColor::Make(1.0, 0.0, 0.0, 0.0));
+    pass->depthAttachment()->setTexture(depth);
+    pass->depthAttachment()->setLoadAction(MTL::LoadActionLoad);
+    pass->depthAttachment()->setStoreAction(MTL::StoreActionDontCare);
+    return pass;
+}
+
+void WeightedTransparency::encodeComposite(MTL::CommandBuffer* commandBuffer, MTL::Texture* target,
+                                           MTL::Texture* sceneDepth, const MTL::Viewport& viewport,
+                                           float nearPlane, float farPlane,
+                                           bool fullResolution, bool lowResolution) const {
+    if (!commandBuffer || !target || !m_compositePipeline) {
+        return;
+    }
+    fullResolution = fullResolution && m_accumulation;
+    lowResolution = lowResolution && m_lowAccumulation && sceneDepth;
+    if (!fullResolution && !lowResolution) {
+        return;
+    }
+    MTL::RenderPassDescriptor* pass = MTL::RenderPassDescriptor::alloc()->init();
+    MTL::RenderPassColorAttachmentDescriptor* color = pass->colorAttachments()->object(0);
+    color->setTexture(target);
+    color->setLoadAction(MTL::LoadActionLoad);
+    color->setStoreAction(MTL::StoreActionStore);
+    MTL::RenderCommandEncoder* encoder = commandBuffer->renderCommandEncoder(pass);
+    pass->release();
+    if (!encoder) {
+        return;
+    }
+    encoder->setLabel(NS::String::string("Transparency Composite", NS::UTF8StringEncoding));
+    encoder->setViewport(viewport);
+    // Low-resolution layers are the heavy, diffuse effects; the sharper full-resolution ones go on top.
+    if (lowResolution) {
+        const float params[4] = { nearPlane, farPlane, 0.0f, 0.0f };
+        encoder->setRenderPipelineState(m_upsamplePipeline);
+        encoder->setFragmentBytes(params, sizeof(params), 0);
+        encoder->setFragmentTexture(m_lowAccumulation, 0);
+        encoder->setFragmentTexture(m_lowRevealage, 1);
+        encoder->setFragmentTexture(m_lowDepth, 2);
+        encoder->setFragmentTexture(sceneDepth, 3);
+        encoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
+    }
+    if (fullResolution) {
+        encoder->setRenderPipelineState(m_compositePipeline);
+        encoder->setFragmentTexture(m_accumulation, 0);
+        encoder->setFragmentTexture(m_revealage, 1);
+        encoder->drawPrimitives(MTL::PrimitiveTypeTriangle, NS::UInteger(0), NS::UInteger(3));
+    }
+    encoder->endEncoding();
+}
+
+} // namespace Crescent
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+
+namespace MTL {
+    class Device;
+    class CommandBuffer;
+    class DepthStencilState;
+    class RenderPassDescriptor;
+    class RenderPipelineState;
+    class Texture;
+    struct Viewport;
+}
+
+namespace Crescent {
+
+// Weighted blended order-independent transparency for the main pass's blended draws whose material
+// asks for it (Material::TransparencyMode). After the opaque main pass, those draws accumulate
+// premultiplied, depth-weighted colour into an RGBA16F target and the product of their
+// transmittance into an R16F revealage target, depth tested against the scene depth without
+// writing it, so they need no back-to-front sort. The composite then blends the average colour over
+// the scene colour by the total coverage.
+//
+// LowResolution draws accumulate into a second, half-size pair of targets tested against the
+// farthest scene depth of each 2x2 block, and are composited with a bilateral upsample that
+// prefers the low-resolution samples whose depth matches the full-resolution pixel.
+class WeightedTransparency {
+public:
+    WeightedTransparency();
+    ~WeightedTransparency();
+
+    bool initialize(MTL::Device* device);
+    void shutdown();
+    bool isAvailable() const { return m_depthDownsamplePipeline != nullptr; }
+
+    // Sizes the targets the frame needs for a scene colour target of width x height; the half-size
+    // set rounds up. Returns false when they could not be allocated or the composite pipelines for
+    // colorFormat could not be built, and the caller draws the layers sorted instead.
+    bool prepare(uint32_t width, uint32_t height, uint32_t colorFormat, bool fullResolution, bool lowResolution);
+
+    // Writes the farthest scene depth of each 2x2 block into the half-size depth target.
+    void encodeDepthDownsample(MTL::CommandBuffer* commandBuffer, MTL::Texture* sceneDepth,
+                               const MTL::Viewport& viewport) const;
+    // Pass that clears and accumulates into the full- or half-size targets, testing against
+    // sceneDepth or the downsampled depth. The caller releases it.
+    MTL::RenderPassDescriptor* newAccumulationPass(bool lowResolution, MTL::Texture* sceneDepth) const;
+    // Blends the accumulated layers over target. depthRange holds the camera's near and far planes,
+    // which the upsample uses to compare depths linearly.
+    void encodeComposite(MTL::CommandBuffer* commandBuffer, MTL::Texture* target, MTL::Texture* sceneDepth,
+                         const MTL::Viewport& viewport, float nearPlane, float farPlane,
+                         bool fullResolution, bool lowResolution) const;
+
+    // Half of a full-resolution viewport, for the low-resolution passes.
+    static MTL::Viewport LowResolutionViewport(const MTL::Viewport& viewport);
+
+private:
+    bool buildCompositePipelines(uint32_t colorFormat);
+    void releaseTargets();
+
+    MTL::Device* m_device;
+    MTL::RenderPipelineState* m_depthDownsamplePipeline;
+    MTL::RenderPipelineState* m_compositePipeline;
+    MTL::RenderPipelineState* m_upsamplePipeline;
+    MTL::DepthStencilState* m_depthWriteState;
+    MTL::Texture* m_accumulation;
+    MTL::Texture* m_revealage;
+    MTL::Texture* m_lowAccumulation;
+    MTL::Texture* m_lowRevealage;
+    MTL::Texture* m_lowDepth;
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_pipelineFormat;
+};
+
+} // namespace Crescent
@@ -12,6 +12,7 @@ Material::Material(const std::string& name)
     , m_EmissionStrength(0.0f)
     , m_RenderMode(RenderMode::Opaque)
     , m_AlphaCutoff(0.5f)
+    , m_TransparencyMode(TransparencyMode::Sorted)
     , m_CullMode(CullMode::Back)
     , m_TwoSided(false)
     , m_AlphaToCoverage(false)
@@ -75,6 +75,19 @@ public:
     
     float getAlphaCutoff() const { return m_AlphaCutoff; }
     void setAlphaCutoff(float cutoff) { m_AlphaCutoff = Math::Clamp(cutoff, 0.0f, 1.0f); }
+
+    // How a blended material composites. Sorted draws back to front in the main pass; the weighted
+    // modes accumulate order-independently after it, LowResolution at half size with a
+    // depth-aware upsample for heavy overdraw. The weighted modes fall back to Sorted where the
+    // main pass does not render into the offscreen target (MSAA, rate-mapped or drawable passes).
+    enum class TransparencyMode {
+        Sorted,
+        WeightedBlended,
+        LowResolution
+    };
+
+    TransparencyMode getTransparencyMode() const { return m_TransparencyMode; }
+    void setTransparencyMode(TransparencyMode mode) { m_TransparencyMode = mode; }
     
     // Culling
     enum class CullMode {
@@ -257,6 +270,7 @@ private:
     // Rendering
     RenderMode m_RenderMode;
     float m_AlphaCutoff;
+    TransparencyMode m_TransparencyMode;
     CullMode m_CullMode;
     bool m_TwoSided;
     bool m_AlphaToCoverage;
@@ -1,12 +1,224 @@
 #include "Mesh.hpp"
-#include <Metal/Metal.hpp>
+#include "../Core/JobScheduler.hpp"
+#include "../Renderer/GeometryBuffer.hpp"
 #include <limits>
 #include <cmath>
 #include <unordered_set>
 #include <algorithm>
+#include <cstring>
 
 namespace Crescent {
 
+namespace {
+
+uint16_t FloatToHalf(float value) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xffu) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffffu;
+    if (((bits >> 23) & 0xffu) == 0xffu) {
+        return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+    }
+    if (exponent >= 31) {
+        return static_cast<uint16_t>(sign | 0x7c00u);
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return static_cast<uint16_t>(sign);
+        }
+        mantissa |= 0x800000u;
+        const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1u) {
+            half += 1;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+    uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000u) {
+        half += 1; // round half up; a carry into the exponent is still the correct result
+    }
+    return static_cast<uint16_t>(half);
+}
+
+float HalfToFloat(uint16_t value) {
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1fu;
+    uint32_t mantissa = value & 0x3ffu;
+    uint32_t bits = 0;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400u) == 0) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+        }
+    } else if (exponent == 31) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+    float result = 0.0f;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+int32_t QuantizeSnorm(float value, int bits) {
+    const float scale = static_cast<float>((1 << (bits - 1)) - 1);
+    return static_cast<int32_t>(std::round(std::clamp(value, -1.0f, 1.0f) * scale));
+}
+
+float DequantizeSnorm(int32_t value, int bits) {
+    const float scale = static_cast<float>((1 << (bits - 1)) - 1);
+    return std::max(-1.0f, static_cast<float>(value) / scale);
+}
+
+// Octahedral mapping of a unit vector onto [-1, 1]^2.
+Math::Vector2 OctEncode(const Math::Vector3& n) {
+    const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1 <= 0.0f) {
+        return Math::Vector2(0.0f, 0.0f);
+    }
+    float x = n.x / l1;
+    float y = n.y / l1;
+    if (n.z < 0.0f) {
+        const float ox = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float oy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = ox;
+        y = oy;
+    }
+    return Math::Vector2(x, y);
+}
+
+Math::Vector3 OctDecode(float x, float y) {
+    Math::Vector3 n(x, y, 1.0f - std::abs(x) - std::abs(y));
+    const float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return n.normalized();
+}
+
+// Below these a mesh is processed on the calling thread.
+constexpr size_t kTrianglesPerChunk = 16384;
+constexpr size_t kVerticesPerChunk = 16384;
+
+// Runs body(begin, end) over [0, count) split across the shared scheduler's workers; the calling
+// thread takes the first chunk and waits for the rest.
+template <typename Body>
+void ParallelMeshRanges(size_t count, size_t minChunk, const Body& body) {
+    if (count == 0) {
+        return;
+    }
+    JobScheduler& scheduler = JobScheduler::getInstance();
+    const size_t workers = scheduler.isRunning() ? scheduler.workerCount() : 0;
+    const size_t chunks = std::max<size_t>(1, std::min(workers + 1, count / std::max<size_t>(1, minChunk)));
+    if (chunks == 1) {
+        body(size_t(0), count);
+        return;
+    }
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+    auto fence = std::make_shared<JobFence>();
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        const size_t begin = chunk * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        if (begin >= end) {
+            break;
+        }
+        fence->remaining.fetch_add(1, std::memory_order_relaxed);
+        scheduler.schedule([&body, begin, end]() { body(begin, end); }, fence);
+    }
+    body(size_t(0), std::min(count, chunkSize));
+    scheduler.wait(*fence);
+}
+
+// The triangle corners (triangle * 3 + corner) at each vertex, in triangle order. Per-vertex sums
+// gather through it in parallel without atomics and add up in the order a serial scatter would.
+// Triangles with an index past the vertices are left out.
+struct VertexCorners {
+    std::vector<uint32_t> offsets; // vertexCount + 1
+    std::vector<uint32_t> corners;
+};
+
+VertexCorners BuildVertexCorners(const std::vector<uint32_t>& indices, size_t vertexCount) {
+    VertexCorners result;
+    result.offsets.assign(vertexCount + 1, 0);
+    const size_t cornerCount = indices.size() / 3 * 3;
+    auto valid = [&](size_t triangle) {
+        return indices[triangle * 3] < vertexCount && indices[triangle * 3 + 1] < vertexCount &&
+               indices[triangle * 3 + 2] < vertexCount;
+    };
+    for (size_t corner = 0; corner < cornerCount; ++corner) {
+        if (valid(corner / 3)) {
+            ++result.offsets[indices[corner] + 1];
+        }
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        result.offsets[v + 1] += result.offsets[v];
+    }
+    result.corners.resize(result.offsets[vertexCount]);
+    std::vector<uint32_t> cursor(result.offsets.begin(), result.offsets.end() - 1);
+    for (size_t corner = 0; corner < cornerCount; ++corner) {
+        if (valid(corner / 3)) {
+            result.corners[cursor[indices[corner]]++] = static_cast<uint32_t>(corner);
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+PackedVertexAttributes PackedVertexAttributes::Pack(const Vertex& vertex) {
+    PackedVertexAttributes packed{};
+    packed.texCoord[0] = FloatToHalf(vertex.texCoord.x);
+    packed.texCoord[1] = FloatToHalf(vertex.texCoord.y);
+    packed.texCoord1[0] = FloatToHalf(vertex.texCoord1.x);
+    packed.texCoord1[1] = FloatToHalf(vertex.texCoord1.y);
+
+    const Math::Vector2 octNormal = OctEncode(vertex.normal);
+    packed.normal[0] = static_cast<int16_t>(QuantizeSnorm(octNormal.x, 16));
+    packed.normal[1] = static_cast<int16_t>(QuantizeSnorm(octNormal.y, 16));
+
+    // The bitangent is rebuilt in the shader as cross(normal, tangent) * sign.
+    Math::Vector3 tangent = vertex.tangent;
+    if (tangent.lengthSquared() > 1e-12f) {
+        tangent.normalize();
+    }
+    const float handedness = vertex.normal.cross(vertex.tangent).dot(vertex.bitangent) < 0.0f ? -1.0f : 1.0f;
+    const uint32_t tx = static_cast<uint32_t>(QuantizeSnorm(tangent.x, 10)) & 0x3ffu;
+    const uint32_t ty = static_cast<uint32_t>(QuantizeSnorm(tangent.y, 10)) & 0x3ffu;
+    const uint32_t tz = static_cast<uint32_t>(QuantizeSnorm(tangent.z, 10)) & 0x3ffu;
+    const uint32_t tw = static_cast<uint32_t>(QuantizeSnorm(handedness, 2)) & 0x3u;
+    packed.tangent = tx | (ty << 10) | (tz << 20) | (tw << 30);
+
+    packed.color[0] = static_cast<uint8_t>(std::round(std::clamp(vertex.color.x, 0.0f, 1.0f) * 255.0f));
+    packed.color[1] = static_cast<uint8_t>(std::round(std::clamp(vertex.color.y, 0.0f, 1.0f) * 255.0f));
+    packed.color[2] = static_cast<uint8_t>(std::round(std::clamp(vertex.color.z, 0.0f, 1.0f) * 255.0f));
+    packed.color[3] = static_cast<uint8_t>(std::round(std::clamp(vertex.color.w, 0.0f, 1.0f) * 255.0f));
+    return packed;
+}
+
+void PackedVertexAttributes::unpack(Vertex& vertex) const {
+    auto signExtend = [](uint32_t value, int bits) {
+        const int32_t shift = 32 - bits;
+        return static_cast<int32_t>(value << shift) >> shift;
+    };
+
+    vertex.texCoord = Math::Vector2(HalfToFloat(texCoord[0]), HalfToFloat(texCoord[1]));
+    vertex.texCoord1 = Math::Vector2(HalfToFloat(texCoord1[0]), HalfToFloat(texCoord1[1]));
+    vertex.normal = OctDecode(DequantizeSnorm(normal[0], 16), DequantizeSnorm(normal[1], 16));
+    vertex.tangent = Math::Vector3(DequantizeSnorm(signExtend(tangent & 0x3ffu, 10), 10),
+                                   DequantizeSnorm(signExtend((tangent >> 10) & 0x3ffu, 10), 10),
+                                   DequantizeSnorm(signExtend((tangent >> 20) & 0x3ffu, 10), 10));
+    const float handedness = signExtend(tangent >> 30, 2) < 0 ? -1.0f : 1.0f;
+    vertex.bitangent = vertex.normal.cross(vertex.tangent) * handedness;
+    vertex.color = Math::Vector4(color[0] / 255.0f, color[1] / 255.0f, color[2] / 255.0f, color[3] / 255.0f);
+}
+
 Mesh::Mesh()
     : m_Name("Mesh")
     , m_WireEdgesDirty(true)
@@ -21,22 +233,122 @@ Mesh::Mesh()
 }
 
 Mesh::~Mesh() {
-    if (m_VertexBuffer) {
-        static_cast<MTL::Buffer*>(m_VertexBuffer)->release();
-        m_VertexBuffer = nullptr;
+    GeometryBuffer::getInstance().release(this);
+}
+
+ResidencyCache<Mesh>& Mesh::GetCookedResidency() {
+    static ResidencyCache<Mesh> residency(kDefaultCookedResidencyBudget,
+                                          [](const Mesh& mesh) { return mesh.getGpuBytes(); });
+    return residency;
+}
+
+uint64_t Mesh::getGpuBytes() const {
+    uint64_t indexCount = m_IndexCount;
+    for (const MeshLod& lod : m_Lods) {
+        indexCount += lod.indexCount;
     }
-    if (m_IndexBuffer) {
-        static_cast<MTL::Buffer*>(m_IndexBuffer)->release();
-        m_IndexBuffer = nullptr;
+    return static_cast<uint64_t>(m_VertexCount) * (sizeof(float) * 3 + sizeof(PackedVertexAttributes))
+         + indexCount * sizeof(uint32_t);
+}
+
+const std::vector<Vertex>& Mesh::getVertices() const {
+    buildCpuData();
+    return m_Vertices;
+}
+
+const std::vector<uint32_t>& Mesh::getIndices() const {
+    buildCpuData();
+    return m_Indices;
+}
+
+const std::vector<uint32_t>& Mesh::getLodIndices() const {
+    buildCpuData();
+    return m_LodIndices;
+}
+
+bool Mesh::setStreamSource(MeshStreamSource source) {
+    if (!source.storage || !source.positions || !source.attributes || !source.indices ||
+        source.vertexCount == 0 || source.indexCount == 0) {
+        return false;
     }
-    if (m_SkinWeightBuffer) {
-        static_cast<MTL::Buffer*>(m_SkinWeightBuffer)->release();
-        m_SkinWeightBuffer = nullptr;
+    std::lock_guard<std::mutex> lock(m_CpuDataMutex);
+    m_VertexCount = source.vertexCount;
+    m_IndexCount = source.indexCount;
+    m_Streams = std::move(source);
+    m_Vertices.clear();
+    m_Indices.clear();
+    m_PackedAttributes.clear();
+    m_Meshlets.clear();
+    m_MeshletVertices.clear();
+    m_MeshletTriangles.clear();
+    m_Lods.clear();
+    m_LodIndices.clear();
+    m_CpuDataPending.store(true, std::memory_order_release);
+    GeometryBuffer::getInstance().release(this);
+    m_IsUploaded = false;
+    m_WireEdgesDirty = true;
+    m_UVDensityDirty = true;
+    return true;
+}
+
+void Mesh::buildCpuData() const {
+    if (!m_CpuDataPending.load(std::memory_order_acquire)) {
+        return;
     }
+    std::lock_guard<std::mutex> lock(m_CpuDataMutex);
+    if (!m_CpuDataPending.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const MeshStreamSource& streams = m_Streams;
+    m_Vertices.resize(streams.vertexCount);
+    for (size_t i = 0; i < m_Vertices.size(); ++i) {
+        Vertex& vertex = m_Vertices[i];
+        vertex.position = Math::Vector3(streams.positions[i * 3 + 0],
+                                        streams.positions[i * 3 + 1],
+                                        streams.positions[i * 3 + 2]);
+        streams.attributes[i].unpack(vertex);
+    }
+    m_Indices.assign(streams.indices, streams.indices + streams.indexCount);
+    m_LodIndices.assign(streams.indices + streams.indexCount,
+                        streams.indices + streams.indexCount + streams.lodIndexCount);
+    m_CpuDataPending.store(false, std::memory_order_release);
+}
+
+void Mesh::releaseCpuData() {
+    if (m_Residency == MeshResidency::Full || !m_IsUploaded) {
+        return;
+    }
+    if (m_Residency == MeshResidency::Reloadable && !m_Streams.storage) {
+        return;
+    }
+    // Texture streaming asks for the density every frame; keep it past the vertices.
+    getUVDensity();
+    std::lock_guard<std::mutex> lock(m_CpuDataMutex);
+    std::vector<Vertex>().swap(m_Vertices);
+    std::vector<uint32_t>().swap(m_Indices);
+    std::vector<uint32_t>().swap(m_LodIndices);
+    std::vector<PackedVertexAttributes>().swap(m_PackedAttributes);
+    std::vector<std::pair<uint32_t, uint32_t>>().swap(m_WireEdges);
+    m_WireEdgesDirty = true;
+    if (m_Residency == MeshResidency::GpuOnly) {
+        // m_HasSkinWeights stays set: the GPU copy is still bound for skinning.
+        std::vector<SkinWeight>().swap(m_SkinWeights);
+        m_Streams = MeshStreamSource();
+        m_CpuDataPending.store(false, std::memory_order_release);
+    } else {
+        m_CpuDataPending.store(true, std::memory_order_release);
+    }
+}
+
+void Mesh::detachStreams() {
+    buildCpuData();
+    m_Streams = MeshStreamSource();
 }
 
 void Mesh::setVertices(const std::vector<Vertex>& vertices) {
+    detachStreams();
     m_Vertices = vertices;
+    m_VertexCount = m_Vertices.size();
     bool hasSecondaryUV = false;
     for (const auto& vertex : m_Vertices) {
         if (std::abs(vertex.texCoord1.x) > 0.0001f || std::abs(vertex.texCoord1.y) > 0.0001f) {
@@ -50,30 +362,168 @@ void Mesh::setVertices(const std::vector<Vertex>& vertices) {
         }
     }
     calculateBounds();
-    if (m_VertexBuffer) {
-        static_cast<MTL::Buffer*>(m_VertexBuffer)->release();
-        m_VertexBuffer = nullptr;
-    }
-    if (m_IndexBuffer) {
-        static_cast<MTL::Buffer*>(m_IndexBuffer)->release();
-        m_IndexBuffer = nullptr;
-    }
-    if (m_SkinWeightBuffer) {
-        static_cast<MTL::Buffer*>(m_SkinWeightBuffer)->release();
-        m_SkinWeightBuffer = nullptr;
-    }
+    m_PackedAttributes.clear();
+    m_Meshlets.clear();
+    m_MeshletVertices.clear();
+    m_MeshletTriangles.clear();
+    m_Lods.clear();
+    m_LodIndices.clear();
+    GeometryBuffer::getInstance().release(this);
     m_IsUploaded = false;
     m_WireEdgesDirty = true;
+    m_UVDensityDirty = true;
 }
 
 void Mesh::setIndices(const std::vector<uint32_t>& indices) {
+    detachStreams();
     m_Indices = indices;
-    if (m_IndexBuffer) {
-        static_cast<MTL::Buffer*>(m_IndexBuffer)->release();
-        m_IndexBuffer = nullptr;
-    }
+    m_IndexCount = m_Indices.size();
+    m_Meshlets.clear();
+    m_MeshletVertices.clear();
+    m_MeshletTriangles.clear();
+    m_Lods.clear();
+    m_LodIndices.clear();
+    GeometryBuffer::getInstance().release(this);
     m_IsUploaded = false;
     m_WireEdgesDirty = true;
+    m_UVDensityDirty = true;
+}
+
+const std::vector<PackedVertexAttributes>& Mesh::getPackedAttributes() {
+    buildCpuData();
+    if (m_PackedAttributes.size() != m_Vertices.size()) {
+        m_PackedAttributes.resize(m_Vertices.size());
+        for (size_t i = 0; i < m_Vertices.size(); ++i) {
+            m_PackedAttributes[i] = PackedVertexAttributes::Pack(m_Vertices[i]);
+        }
+    }
+    return m_PackedAttributes;
+}
+
+void Mesh::setPackedAttributes(std::vector<PackedVertexAttributes> packed) {
+    if (packed.size() != m_Vertices.size()) {
+        return;
+    }
+    m_PackedAttributes = std::move(packed);
+}
+
+void Mesh::setMeshlets(std::vector<Meshlet> meshlets,
+                       std::vector<uint32_t> meshletVertices,
+                       std::vector<uint8_t> meshletTriangles) {
+    // Reject clusters that reference data outside the lists; the mesh then draws without them.
+    for (const Meshlet& meshlet : meshlets) {
+        if (meshlet.vertexCount > Meshlet::kMaxVertices || meshlet.triangleCount > Meshlet::kMaxTriangles ||
+            static_cast<size_t>(meshlet.vertexOffset) + meshlet.vertexCount > meshletVertices.size() ||
+            static_cast<size_t>(meshlet.triangleOffset) + meshlet.triangleCount * 3 > meshletTriangles.size()) {
+            return;
+        }
+    }
+    const size_t vertexCount = getVertexCount();
+    for (uint32_t vertex : meshletVertices) {
+        if (vertex >= vertexCount) {
+            return;
+        }
+    }
+    m_Meshlets = std::move(meshlets);
+    m_MeshletVertices = std::move(meshletVertices);
+    m_MeshletTriangles = std::move(meshletTriangles);
+    GeometryBuffer::getInstance().release(this);
+    m_IsUploaded = false;
+}
+
+void Mesh::setLods(std::vector<MeshLod> lods, std::vector<uint32_t> lodIndices) {
+    // Stream-backed meshes already carry their LOD lists after the base indices.
+    if (!lodIndices.empty()) {
+        detachStreams();
+    }
+    const size_t baseCount = getIndexCount();
+    const size_t lodIndexCount = m_Streams.storage ? m_Streams.lodIndexCount : lodIndices.size();
+    if (lods.size() >= MeshLod::kMaxLods) {
+        lods.resize(MeshLod::kMaxLods - 1);
+    }
+    for (const MeshLod& lod : lods) {
+        if (lod.indexStart < baseCount || lod.indexCount == 0 || lod.indexCount % 3 != 0 ||
+            static_cast<size_t>(lod.indexStart) + lod.indexCount > baseCount + lodIndexCount) {
+            return;
+        }
+    }
+    const size_t vertexCount = getVertexCount();
+    for (uint32_t index : lodIndices) {
+        if (index >= vertexCount) {
+            return;
+        }
+    }
+    m_Lods = std::move(lods);
+    if (!m_Streams.storage) {
+        m_LodIndices = std::move(lodIndices);
+    }
+    GeometryBuffer::getInstance().release(this);
+    m_IsUploaded = false;
+}
+
+uint32_t Mesh::getLodIndexCount(uint32_t lod) const {
+    if (lod == 0 || lod > m_Lods.size()) {
+        return static_cast<uint32_t>(getIndexCount());
+    }
+    return m_Lods[lod - 1].indexCount;
+}
+
+size_t Mesh::getLodIndexBufferOffset(uint32_t lod) const {
+    if (lod == 0 || lod > m_Lods.size()) {
+        return m_IndexBufferOffset;
+    }
+    return m_IndexBufferOffset + static_cast<size_t>(m_Lods[lod - 1].indexStart) * sizeof(uint32_t);
+}
+
+float Mesh::getLodError(uint32_t lod) const {
+    if (lod == 0 || lod > m_Lods.size()) {
+        return 0.0f;
+    }
+    return m_Lods[lod - 1].error;
+}
+
+uint32_t Mesh::selectLod(float pixelsPerUnit, float pixelError, float* outFade) const {
+    // The next coarser level fades in while its error is within kFadeBand of the budget, so it is
+    // fully blended in by the time it gets selected.
+    constexpr float kFadeBand = 1.5f;
+    if (outFade) {
+        *outFade = 0.0f;
+    }
+    if (m_Lods.empty() || pixelsPerUnit <= 0.0f || pixelError <= 0.0f) {
+        return 0;
+    }
+    uint32_t lod = 0;
+    for (uint32_t i = 1; i <= m_Lods.size(); ++i) {
+        if (m_Lods[i - 1].error * pixelsPerUnit > pixelError) {
+            break;
+        }
+        lod = i;
+    }
+    if (outFade && lod < m_Lods.size()) {
+        float next = m_Lods[lod].error * pixelsPerUnit;
+        float fadeStart = pixelError * kFadeBand;
+        if (next < fadeStart) {
+            *outFade = std::clamp((fadeStart - next) / (fadeStart - pixelError), 0.0f, 1.0f);
+        }
+    }
+    return lod;
+}
+
+uint32_t Mesh::selectLod(const Math::Matrix4x4& worldMatrix, const Math::Vector4& lodView, float pixelError,
+                         float* outFade) const {
+    if (outFade) {
+        *outFade = 0.0f;
+    }
+    if (m_Lods.empty() || lodView.w <= 0.0f) {
+        return 0;
+    }
+    const Math::Vector3 center = worldMatrix.transformPointAffine(getBoundsCenter());
+    const float distance = std::max((center - Math::Vector3(lodView.x, lodView.y, lodView.z)).length(), 1e-3f);
+    const float scaleX = Math::Vector3(worldMatrix(0, 0), worldMatrix(1, 0), worldMatrix(2, 0)).length();
+    const float scaleY = Math::Vector3(worldMatrix(0, 1), worldMatrix(1, 1), worldMatrix(2, 1)).length();
+    const float scaleZ = Math::Vector3(worldMatrix(0, 2), worldMatrix(1, 2), worldMatrix(2, 2)).length();
+    const float maxScale = std::max(scaleX, std::max(scaleY, scaleZ));
+    return selectLod(lodView.w * maxScale / distance, pixelError, outFade);
 }
 
 void Mesh::setSubmeshes(const std::vector<Submesh>& submeshes) {
@@ -83,10 +533,7 @@ void Mesh::setSubmeshes(const std::vector<Submesh>& submeshes) {
 void Mesh::setSkinWeights(const std::vector<SkinWeight>& weights) {
     m_SkinWeights = weights;
     m_HasSkinWeights = !m_SkinWeights.empty();
-    if (m_SkinWeightBuffer) {
-        static_cast<MTL::Buffer*>(m_SkinWeightBuffer)->release();
-        m_SkinWeightBuffer = nullptr;
-    }
+    GeometryBuffer::getInstance().release(this);
     m_IsUploaded = false;
 }
 
@@ -95,45 +542,100 @@ const std::vector<std::pair<uint32_t, uint32_t>>& Mesh::getWireframeEdges() {
         return m_WireEdges;
     }
 
+    buildCpuData();
     m_WireEdges.clear();
     if (m_Indices.empty()) {
         m_WireEdgesDirty = false;
         return m_WireEdges;
     }
 
-    struct EdgeHash {
-        size_t operator()(const std::pair<uint32_t, uint32_t>& e) const {
-            return (static_cast<size_t>(e.first) << 32) ^ e.second;
-        }
+    // Every triangle edge as (min << 32 | max), sorted and deduplicated: chunks sort in parallel,
+    // then merge pairwise. Degenerate triangles write the sentinel and drop out at the end.
+    constexpr uint64_t kNoEdge = std::numeric_limits<uint64_t>::max();
+    const size_t triangleCount = m_Indices.size() / 3;
+    std::vector<uint64_t> keys(triangleCount * 3);
+    auto edgeKey = [](uint32_t a, uint32_t b) {
+        return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
     };
-
-    std::unordered_set<std::pair<uint32_t, uint32_t>, EdgeHash> edges;
-    edges.reserve(m_Indices.size());
-
-    for (size_t i = 0; i + 2 < m_Indices.size(); i += 3) {
-        uint32_t a = m_Indices[i];
-        uint32_t b = m_Indices[i + 1];
-        uint32_t c = m_Indices[i + 2];
-
-        if (a == b || b == c || c == a) {
-            continue;
+    ParallelMeshRanges(triangleCount, kTrianglesPerChunk, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            const uint32_t a = m_Indices[t * 3];
+            const uint32_t b = m_Indices[t * 3 + 1];
+            const uint32_t c = m_Indices[t * 3 + 2];
+            const bool degenerate = a == b || b == c || c == a;
+            keys[t * 3] = degenerate ? kNoEdge : edgeKey(a, b);
+            keys[t * 3 + 1] = degenerate ? kNoEdge : edgeKey(b, c);
+            keys[t * 3 + 2] = degenerate ? kNoEdge : edgeKey(c, a);
         }
+    });
 
-        edges.insert(std::minmax(a, b));
-        edges.insert(std::minmax(b, c));
-        edges.insert(std::minmax(c, a));
+    const size_t keyCount = keys.size();
+    size_t run = std::max<size_t>(kTrianglesPerChunk * 3, (keyCount + 15) / 16);
+    const size_t runCount = (keyCount + run - 1) / run;
+    ParallelMeshRanges(runCount, 1, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            std::sort(keys.begin() + r * run, keys.begin() + std::min(keyCount, (r + 1) * run));
+        }
+    });
+    for (; run < keyCount; run *= 2) {
+        const size_t pairs = (keyCount + 2 * run - 1) / (2 * run);
+        ParallelMeshRanges(pairs, 1, [&](size_t begin, size_t end) {
+            for (size_t pair = begin; pair < end; ++pair) {
+                const size_t first = pair * 2 * run;
+                const size_t middle = std::min(keyCount, first + run);
+                const size_t last = std::min(keyCount, first + 2 * run);
+                std::inplace_merge(keys.begin() + first, keys.begin() + middle, keys.begin() + last);
+            }
+        });
     }
-
-    m_WireEdges.reserve(edges.size());
-    for (const auto& edge : edges) {
-        m_WireEdges.push_back(edge);
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    if (!keys.empty() && keys.back() == kNoEdge) {
+        keys.pop_back();
     }
 
+    m_WireEdges.resize(keys.size());
+    ParallelMeshRanges(keys.size(), kVerticesPerChunk, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            m_WireEdges[i] = {static_cast<uint32_t>(keys[i] >> 32), static_cast<uint32_t>(keys[i])};
+        }
+    });
+
     m_WireEdgesDirty = false;
     return m_WireEdges;
 }
 
+float Mesh::getUVDensity() {
+    if (!m_UVDensityDirty) {
+        return m_UVDensity;
+    }
+    buildCpuData();
+    double uvArea = 0.0;
+    double surfaceArea = 0.0;
+    const size_t vertexCount = m_Vertices.size();
+    for (size_t i = 0; i + 2 < m_Indices.size(); i += 3) {
+        const uint32_t a = m_Indices[i];
+        const uint32_t b = m_Indices[i + 1];
+        const uint32_t c = m_Indices[i + 2];
+        if (a >= vertexCount || b >= vertexCount || c >= vertexCount) {
+            continue;
+        }
+        const Vertex& va = m_Vertices[a];
+        const Vertex& vb = m_Vertices[b];
+        const Vertex& vc = m_Vertices[c];
+        surfaceArea += 0.5 * (vb.position - va.position).cross(vc.position - va.position).length();
+        const Math::Vector2 uv1 = vb.texCoord - va.texCoord;
+        const Math::Vector2 uv2 = vc.texCoord - va.texCoord;
+        uvArea += 0.5 * std::abs(uv1.x * uv2.y - uv1.y * uv2.x);
+    }
+    m_UVDensity = (surfaceArea > 1e-12 && uvArea > 1e-12)
+        ? static_cast<float>(std::sqrt(uvArea / surfaceArea))
+        : 0.0f;
+    m_UVDensityDirty = false;
+    return m_UVDensity;
+}
+
 void Mesh::calculateBounds() {
+    buildCpuData();
     if (m_Vertices.empty()) {
         m_BoundsMin = Math::Vector3::Zero;
         m_BoundsMax = Math::Vector3::Zero;
@@ -150,110 +652,134 @@ void Mesh::calculateBounds() {
 }
 
 void Mesh::calculateNormals() {
+    detachStreams();
     if (m_Vertices.empty() || m_Indices.empty()) return;
+    const size_t triangleCount = m_Indices.size() / 3;
+    const size_t vertexCount = m_Vertices.size();
+
+    // Face normals, area weighted (the cross product is left unnormalised).
+    std::vector<Math::Vector3> faceNormals(triangleCount);
+    ParallelMeshRanges(triangleCount, kTrianglesPerChunk, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            const uint32_t i0 = m_Indices[t * 3];
+            const uint32_t i1 = m_Indices[t * 3 + 1];
+            const uint32_t i2 = m_Indices[t * 3 + 2];
+            if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount) {
+                continue;
+            }
+            const Math::Vector3& v0 = m_Vertices[i0].position;
+            faceNormals[t] = (m_Vertices[i1].position - v0).cross(m_Vertices[i2].position - v0);
+        }
+    });
+
+    // Each vertex sums the faces around it and normalizes.
+    const VertexCorners corners = BuildVertexCorners(m_Indices, vertexCount);
+    ParallelMeshRanges(vertexCount, kVerticesPerChunk, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            Math::Vector3 normal = Math::Vector3::Zero;
+            for (uint32_t k = corners.offsets[v]; k < corners.offsets[v + 1]; ++k) {
+                normal += faceNormals[corners.corners[k] / 3];
+            }
+            normal.normalize();
+            m_Vertices[v].normal = normal;
+        }
+    });
     
-    // Reset normals
-    for (auto& vertex : m_Vertices) {
-        vertex.normal = Math::Vector3::Zero;
-    }
-    
-    // Calculate face normals and accumulate
-    for (size_t i = 0; i + 2 < m_Indices.size(); i += 3) {
-        uint32_t i0 = m_Indices[i];
-        uint32_t i1 = m_Indices[i + 1];
-        uint32_t i2 = m_Indices[i + 2];
-        
-        Math::Vector3 v0 = m_Vertices[i0].position;
-        Math::Vector3 v1 = m_Vertices[i1].position;
-        Math::Vector3 v2 = m_Vertices[i2].position;
-        
-        Math::Vector3 edge1 = v1 - v0;
-        Math::Vector3 edge2 = v2 - v0;
-        Math::Vector3 normal = edge1.cross(edge2);
-        
-        m_Vertices[i0].normal += normal;
-        m_Vertices[i1].normal += normal;
-        m_Vertices[i2].normal += normal;
-    }
-    
-    // Normalize
-    for (auto& vertex : m_Vertices) {
-        vertex.normal.normalize();
-    }
-    
+    m_PackedAttributes.clear();
     m_IsUploaded = false;
 }
 
 void Mesh::calculateTangents() {
+    detachStreams();
     if (m_Vertices.empty() || m_Indices.empty()) return;
     constexpr float kMinDenominator = 1e-8f;
     constexpr float kMinVectorLenSq = 1e-10f;
-    
-    // Reset tangents and bitangents
-    for (auto& vertex : m_Vertices) {
-        vertex.tangent = Math::Vector3::Zero;
-        vertex.bitangent = Math::Vector3::Zero;
-    }
-    
-    // Calculate tangents using texture coordinates
-    for (size_t i = 0; i + 2 < m_Indices.size(); i += 3) {
-        uint32_t i0 = m_Indices[i];
-        uint32_t i1 = m_Indices[i + 1];
-        uint32_t i2 = m_Indices[i + 2];
-        
-        const Vertex& v0 = m_Vertices[i0];
-        const Vertex& v1 = m_Vertices[i1];
-        const Vertex& v2 = m_Vertices[i2];
-        
-        Math::Vector3 edge1 = v1.position - v0.position;
-        Math::Vector3 edge2 = v2.position - v0.position;
-        
-        Math::Vector2 deltaUV1 = v1.texCoord - v0.texCoord;
-        Math::Vector2 deltaUV2 = v2.texCoord - v0.texCoord;
-        
-        float denominator = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
-        if (std::abs(denominator) <= kMinDenominator) {
-            continue;
-        }
-        float f = 1.0f / denominator;
-        
+    const size_t triangleCount = m_Indices.size() / 3;
+    const size_t vertexCount = m_Vertices.size();
+
+    // Per face: the UV-derived tangent and bitangent, and the angle at each corner.
+    struct FaceFrame {
         Math::Vector3 tangent;
-        tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-        tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-        tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-        
         Math::Vector3 bitangent;
-        bitangent.x = f * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x);
-        bitangent.y = f * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y);
-        bitangent.z = f * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
-        
-        m_Vertices[i0].tangent += tangent;
-        m_Vertices[i1].tangent += tangent;
-        m_Vertices[i2].tangent += tangent;
-        
-        m_Vertices[i0].bitangent += bitangent;
-        m_Vertices[i1].bitangent += bitangent;
-        m_Vertices[i2].bitangent += bitangent;
-    }
-    
-    // Normalize and orthogonalize
-    for (auto& vertex : m_Vertices) {
-        // Gram-Schmidt orthogonalization
-        vertex.tangent = vertex.tangent - vertex.normal * vertex.normal.dot(vertex.tangent);
-        if (vertex.tangent.lengthSquared() <= kMinVectorLenSq) {
-            Math::Vector3 reference = std::abs(vertex.normal.y) < 0.999f
-                ? Math::Vector3::Up
-                : Math::Vector3::Right;
-            vertex.tangent = reference.cross(vertex.normal);
+        float angles[3] = {0.0f, 0.0f, 0.0f};
+        bool valid = false;
+    };
+    std::vector<FaceFrame> faces(triangleCount);
+    ParallelMeshRanges(triangleCount, kTrianglesPerChunk, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            const uint32_t index[3] = {m_Indices[t * 3], m_Indices[t * 3 + 1], m_Indices[t * 3 + 2]};
+            if (index[0] >= vertexCount || index[1] >= vertexCount || index[2] >= vertexCount) {
+                continue;
+            }
+            const Vertex& v0 = m_Vertices[index[0]];
+            const Vertex& v1 = m_Vertices[index[1]];
+            const Vertex& v2 = m_Vertices[index[2]];
+
+            const Math::Vector3 edge1 = v1.position - v0.position;
+            const Math::Vector3 edge2 = v2.position - v0.position;
+            const Math::Vector2 deltaUV1 = v1.texCoord - v0.texCoord;
+            const Math::Vector2 deltaUV2 = v2.texCoord - v0.texCoord;
+            const float denominator = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+            if (std::abs(denominator) <= kMinDenominator) {
+                continue;
+            }
+            const float f = 1.0f / denominator;
+            FaceFrame& face = faces[t];
+            face.tangent = (edge1 * deltaUV2.y - edge2 * deltaUV1.y) * f;
+            face.bitangent = (edge2 * deltaUV1.x - edge1 * deltaUV2.x) * f;
+            for (int corner = 0; corner < 3; ++corner) {
+                const Math::Vector3& p = m_Vertices[index[corner]].position;
+                Math::Vector3 a = m_Vertices[index[(corner + 1) % 3]].position - p;
+                Math::Vector3 b = m_Vertices[index[(corner + 2) % 3]].position - p;
+                a.normalize();
+                b.normalize();
+                face.angles[corner] = std::acos(std::clamp(a.dot(b), -1.0f, 1.0f));
+            }
+            face.valid = true;
         }
-        vertex.tangent.normalize();
+    });
 
-        if (vertex.bitangent.lengthSquared() <= kMinVectorLenSq) {
-            vertex.bitangent = vertex.normal.cross(vertex.tangent);
+    // MikkTSpace's accumulation: each corner's face tangent and bitangent are projected into the
+    // vertex's tangent plane, normalized and weighted by the corner angle, so the frame does not
+    // depend on how the surface around the vertex is triangulated. The handedness comes from the
+    // summed bitangent. Vertices are not split where the frames of their faces disagree.
+    const VertexCorners corners = BuildVertexCorners(m_Indices, vertexCount);
+    ParallelMeshRanges(vertexCount, kVerticesPerChunk, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            Vertex& vertex = m_Vertices[v];
+            const Math::Vector3& normal = vertex.normal;
+            Math::Vector3 tangent = Math::Vector3::Zero;
+            Math::Vector3 bitangent = Math::Vector3::Zero;
+            for (uint32_t k = corners.offsets[v]; k < corners.offsets[v + 1]; ++k) {
+                const FaceFrame& face = faces[corners.corners[k] / 3];
+                if (!face.valid) {
+                    continue;
+                }
+                const float weight = face.angles[corners.corners[k] % 3];
+                Math::Vector3 t = face.tangent - normal * normal.dot(face.tangent);
+                Math::Vector3 b = face.bitangent - normal * normal.dot(face.bitangent);
+                t.normalize();
+                b.normalize();
+                tangent += t * weight;
+                bitangent += b * weight;
+            }
+
+            tangent = tangent - normal * normal.dot(tangent);
+            if (tangent.lengthSquared() <= kMinVectorLenSq) {
+                Math::Vector3 reference = std::abs(normal.y) < 0.999f
+                    ? Math::Vector3::Up
+                    : Math::Vector3::Right;
+                tangent = reference.cross(normal);
+            }
+            tangent.normalize();
+            const float handedness = normal.cross(tangent).dot(bitangent) < 0.0f ? -1.0f : 1.0f;
+            vertex.tangent = tangent;
+            vertex.bitangent = normal.cross(tangent) * handedness;
+            vertex.bitangent.normalize();
         }
-        vertex.bitangent.normalize();
-    }
+    });
     
+    m_PackedAttributes.clear();
     m_IsUploaded = false;
 }
 
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "../Math/Math.hpp"
+#include "../Core/ResidencyCache.hpp"
 #include <vector>
 #include <string>
 #include <memory>
 #include <utility>
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 
 namespace Crescent {
 
@@ -29,6 +33,21 @@ struct Vertex {
         , color(Math::Vector4::One) {}
 };
 
+// GPU layout of everything but position. Positions are uploaded as a separate float3 stream so
+// depth-only passes fetch 12 bytes per vertex; this stream is only bound where shading needs it.
+struct PackedVertexAttributes {
+    uint16_t texCoord[2];  // half
+    uint16_t texCoord1[2]; // half
+    int16_t normal[2];     // snorm16 octahedral
+    uint32_t tangent;      // snorm 10:10:10:2, w = bitangent sign
+    uint8_t color[4];      // unorm8
+
+    static PackedVertexAttributes Pack(const Vertex& vertex);
+    // Restores normal, UVs, tangent frame and color; position is left untouched.
+    void unpack(Vertex& vertex) const;
+};
+static_assert(sizeof(PackedVertexAttributes) == 20, "PackedVertexAttributes must match the GPU vertex descriptor");
+
 // Bone influences per vertex (up to 4)
 struct SkinWeight {
     std::array<uint32_t, 4> indices;
@@ -39,6 +58,35 @@ struct SkinWeight {
         , weights{0.0f, 0.0f, 0.0f, 0.0f} {}
 };
 
+// Cluster of up to kMaxVertices vertices / kMaxTriangles triangles, built when a mesh is cooked.
+// Bounds and the backface cone are in mesh space. Layout matches MeshletData in Common.metal.h.
+struct Meshlet {
+    static constexpr uint32_t kMaxVertices = 64;
+    static constexpr uint32_t kMaxTriangles = 124;
+
+    uint32_t vertexOffset;   // first entry in the meshlet vertex list
+    uint32_t triangleOffset; // first byte in the meshlet triangle list (3 local indices per triangle)
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+    float center[3];
+    float radius;
+    float coneAxis[3];
+    float coneCutoff;        // cos of the cone half angle; >= 1 means the cone never culls
+    float coneApex[3];
+    uint32_t submesh;
+};
+static_assert(sizeof(Meshlet) == 64, "Meshlet must match MeshletData in Common.metal.h");
+
+// Simplified version of the whole index list. Level 0 is the mesh's own indices; coarser levels
+// live after them in the GPU index range. error is the simplifier's deviation in mesh units.
+struct MeshLod {
+    static constexpr uint32_t kMaxLods = 5;
+
+    uint32_t indexStart; // first index in the combined base + LOD index list
+    uint32_t indexCount;
+    float error;
+};
+
 // Submesh - a part of a mesh with its own material
 struct Submesh {
     uint32_t indexStart;
@@ -56,6 +104,26 @@ struct Submesh {
         , materialIndex(matIndex) {}
 };
 
+// GPU-layout streams a cooked mesh was loaded from, usually a mapped .cmesh file. Upload copies
+// them into the geometry arenas as they are; the CPU vertex and index lists are only rebuilt from
+// them when something (physics, picking, the editor) asks for them.
+struct MeshStreamSource {
+    std::shared_ptr<const void> storage; // keeps the pointed-to bytes alive
+    const float* positions = nullptr;    // float3 per vertex
+    const PackedVertexAttributes* attributes = nullptr;
+    const uint32_t* indices = nullptr;   // base indices, then the LOD index lists
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    uint32_t lodIndexCount = 0;
+};
+
+// What a mesh keeps on the CPU once it is uploaded.
+enum class MeshResidency {
+    Full,       // CPU lists stay; anything that edits or bakes geometry needs this
+    Reloadable, // CPU lists are dropped and rebuilt from the stream source when asked for
+    GpuOnly     // CPU lists, skin weights and stream source are dropped; the mesh cannot be re-uploaded
+};
+
 // Mesh - contains geometry data
 class Mesh {
 public:
@@ -67,11 +135,61 @@ public:
     void setIndices(const std::vector<uint32_t>& indices);
     void setSubmeshes(const std::vector<Submesh>& submeshes);
     
-    const std::vector<Vertex>& getVertices() const { return m_Vertices; }
-    const std::vector<uint32_t>& getIndices() const { return m_Indices; }
+    // Both build the CPU lists on first use for meshes loaded from GPU streams.
+    const std::vector<Vertex>& getVertices() const;
+    const std::vector<uint32_t>& getIndices() const;
+    // Counts without touching the CPU lists; still valid once they are released.
+    size_t getVertexCount() const { return m_VertexCount; }
+    size_t getIndexCount() const { return m_IndexCount; }
+    // Adopts cooked GPU streams in place of the CPU lists. Bounds are not derived from the streams;
+    // set them with setBounds. Any later geometry edit builds the CPU lists and drops the streams.
+    bool setStreamSource(MeshStreamSource source);
+    const MeshStreamSource* getStreamSource() const { return m_Streams.storage ? &m_Streams : nullptr; }
+    // Reloadable falls back to Full behaviour for meshes without a stream source.
+    void setResidency(MeshResidency residency) { m_Residency = residency; }
+    MeshResidency getResidency() const { return m_Residency; }
+    // Drops the CPU lists of an uploaded mesh when its residency allows it. Called after upload and
+    // by one-off readers (physics shape cooking, bone bounds) once they are done; references from
+    // getVertices()/getIndices() do not survive it.
+    void releaseCpuData();
     const std::vector<Submesh>& getSubmeshes() const { return m_Submeshes; }
     const std::vector<std::pair<uint32_t, uint32_t>>& getWireframeEdges();
+    // Average UV units per mesh unit, sqrt(UV area / surface area) over the triangles; computed on
+    // first use. 0 when the mesh has no usable UVs.
+    float getUVDensity();
+    // GPU attribute stream for the current vertices, packed on first use.
+    const std::vector<PackedVertexAttributes>& getPackedAttributes();
+    // Adopts an already packed stream (cooked meshes) so upload copies it verbatim. Ignored when the
+    // count does not match the vertices.
+    void setPackedAttributes(std::vector<PackedVertexAttributes> packed);
     const std::vector<SkinWeight>& getSkinWeights() const { return m_SkinWeights; }
+    // Cluster data from the cook step. meshletVertices index the mesh vertices, meshletTriangles
+    // hold three meshlet-local indices per triangle. Cleared whenever the geometry changes.
+    void setMeshlets(std::vector<Meshlet> meshlets,
+                     std::vector<uint32_t> meshletVertices,
+                     std::vector<uint8_t> meshletTriangles);
+    const std::vector<Meshlet>& getMeshlets() const { return m_Meshlets; }
+    const std::vector<uint32_t>& getMeshletVertices() const { return m_MeshletVertices; }
+    const std::vector<uint8_t>& getMeshletTriangles() const { return m_MeshletTriangles; }
+    bool hasMeshlets() const { return !m_Meshlets.empty(); }
+    // Coarser index lists generated at import (level 1 and up). lodIndices is laid out after the
+    // base indices, so each MeshLod::indexStart is >= getIndices().size(). Cleared whenever the
+    // geometry changes.
+    void setLods(std::vector<MeshLod> lods, std::vector<uint32_t> lodIndices);
+    const std::vector<MeshLod>& getLods() const { return m_Lods; }
+    const std::vector<uint32_t>& getLodIndices() const;
+    uint32_t getLodCount() const { return static_cast<uint32_t>(m_Lods.size()) + 1; }
+    uint32_t getLodIndexCount(uint32_t lod) const;
+    size_t getLodIndexBufferOffset(uint32_t lod) const;
+    float getLodError(uint32_t lod) const;
+    // Picks the coarsest level whose error projects to at most pixelError pixels, given how many
+    // pixels one mesh unit covers. outFade receives the cross-fade weight toward the next coarser
+    // level (0 = only the returned level is drawn).
+    uint32_t selectLod(float pixelsPerUnit, float pixelError, float* outFade = nullptr) const;
+    // Same for an instance: lodView is the camera position in xyz and, in w, the pixels one world
+    // unit covers at distance 1 (0 disables LOD selection).
+    uint32_t selectLod(const Math::Matrix4x4& worldMatrix, const Math::Vector4& lodView, float pixelError,
+                       float* outFade = nullptr) const;
     void setSkinWeights(const std::vector<SkinWeight>& weights);
     bool hasSkinWeights() const { return m_HasSkinWeights; }
     
@@ -85,18 +203,36 @@ public:
     Math::Vector3 getBoundsCenter() const { return (m_BoundsMin + m_BoundsMax) * 0.5f; }
     Math::Vector3 getBoundsSize() const { return m_BoundsMax - m_BoundsMin; }
     
+    void setBounds(const Math::Vector3& boundsMin, const Math::Vector3& boundsMax) {
+        m_BoundsMin = boundsMin;
+        m_BoundsMax = boundsMax;
+    }
     void calculateBounds();
     void calculateNormals();
     void calculateTangents();
     
-    // GPU resources (void* to avoid Metal types in header)
+    // GPU resources (void* to avoid Metal types in header). The buffers are shared GeometryBuffer
+    // arenas; bind them at the matching byte offset. The vertex buffer holds positions only, the
+    // attribute buffer the PackedVertexAttributes stream.
     void* getVertexBuffer() const { return m_VertexBuffer; }
+    void* getAttributeBuffer() const { return m_AttributeBuffer; }
     void* getIndexBuffer() const { return m_IndexBuffer; }
     void* getSkinWeightBuffer() const { return m_SkinWeightBuffer; }
+    // Meshlet table, then the meshlet vertex list, then the triangle list, in one range.
+    void* getMeshletBuffer() const { return m_MeshletBuffer; }
+    size_t getVertexBufferOffset() const { return m_VertexBufferOffset; }
+    size_t getAttributeBufferOffset() const { return m_AttributeBufferOffset; }
+    size_t getIndexBufferOffset() const { return m_IndexBufferOffset; }
+    size_t getSkinWeightBufferOffset() const { return m_SkinWeightBufferOffset; }
+    size_t getMeshletBufferOffset() const { return m_MeshletBufferOffset; }
+    size_t getMeshletVertexBufferOffset() const { return m_MeshletBufferOffset + m_Meshlets.size() * sizeof(Meshlet); }
+    size_t getMeshletTriangleBufferOffset() const { return getMeshletVertexBufferOffset() + m_MeshletVertices.size() * sizeof(uint32_t); }
     
-    void setVertexBuffer(void* buffer) { m_VertexBuffer = buffer; }
-    void setIndexBuffer(void* buffer) { m_IndexBuffer = buffer; }
-    void setSkinWeightBuffer(void* buffer) { m_SkinWeightBuffer = buffer; }
+    void setVertexBuffer(void* buffer, size_t offset = 0) { m_VertexBuffer = buffer; m_VertexBufferOffset = offset; }
+    void setAttributeBuffer(void* buffer, size_t offset = 0) { m_AttributeBuffer = buffer; m_AttributeBufferOffset = offset; }
+    void setIndexBuffer(void* buffer, size_t offset = 0) { m_IndexBuffer = buffer; m_IndexBufferOffset = offset; }
+    void setSkinWeightBuffer(void* buffer, size_t offset = 0) { m_SkinWeightBuffer = buffer; m_SkinWeightBufferOffset = offset; }
+    void setMeshletBuffer(void* buffer, size_t offset = 0) { m_MeshletBuffer = buffer; m_MeshletBufferOffset = offset; }
     
     bool isUploaded() const { return m_IsUploaded; }
     void setUploaded(bool uploaded) { m_IsUploaded = uploaded; }
@@ -113,16 +249,43 @@ public:
     static std::shared_ptr<Mesh> CreateCone(float radius = 0.5f, float height = 1.0f, uint32_t segments = 32);
     static std::shared_ptr<Mesh> CreateTorus(float majorRadius = 0.75f, float minorRadius = 0.25f, uint32_t majorSegments = 32, uint32_t minorSegments = 16);
     static std::shared_ptr<Mesh> CreateCapsule(float radius = 0.5f, float height = 1.0f, uint32_t segments = 16);
+
+    // Cooked meshes loaded recently, kept uploaded after the scene that loaded them lets go so a
+    // reload of the same file (play mode, switching back to a level) skips decode and upload.
+    // Sized by GPU stream bytes.
+    static constexpr uint64_t kDefaultCookedResidencyBudget = 128ull << 20;
+    static ResidencyCache<Mesh>& GetCookedResidency();
+    // Positions, attributes and every index list as uploaded.
+    uint64_t getGpuBytes() const;
     
 private:
+    // Fills the CPU lists from m_Streams if not done yet; the streams stay the upload source.
+    void buildCpuData() const;
+    // Builds the CPU lists and drops the streams ahead of an edit to the geometry.
+    void detachStreams();
+
     std::string m_Name;
     
-    std::vector<Vertex> m_Vertices;
-    std::vector<uint32_t> m_Indices;
+    MeshStreamSource m_Streams;
+    MeshResidency m_Residency = MeshResidency::Full;
+    size_t m_VertexCount = 0;
+    size_t m_IndexCount = 0;
+    mutable std::mutex m_CpuDataMutex;
+    mutable std::atomic<bool> m_CpuDataPending{false};
+    mutable std::vector<Vertex> m_Vertices;
+    mutable std::vector<uint32_t> m_Indices;
     std::vector<Submesh> m_Submeshes;
     std::vector<std::pair<uint32_t, uint32_t>> m_WireEdges;
     std::vector<SkinWeight> m_SkinWeights;
+    std::vector<PackedVertexAttributes> m_PackedAttributes;
+    std::vector<Meshlet> m_Meshlets;
+    std::vector<uint32_t> m_MeshletVertices;
+    std::vector<uint8_t> m_MeshletTriangles;
+    std::vector<MeshLod> m_Lods;
+    mutable std::vector<uint32_t> m_LodIndices;
     bool m_WireEdgesDirty;
+    float m_UVDensity = 0.0f;
+    bool m_UVDensityDirty = true;
     
     // Bounds
     Math::Vector3 m_BoundsMin;
@@ -130,8 +293,15 @@ private:
     
     // GPU resources
     void* m_VertexBuffer;
+    void* m_AttributeBuffer = nullptr;
     void* m_IndexBuffer;
     void* m_SkinWeightBuffer;
+    void* m_MeshletBuffer = nullptr;
+    size_t m_VertexBufferOffset = 0;
+    size_t m_AttributeBufferOffset = 0;
+    size_t m_IndexBufferOffset = 0;
+    size_t m_SkinWeightBufferOffset = 0;
+    size_t m_MeshletBufferOffset = 0;
     bool m_IsUploaded;
     bool m_IsDoubleSided;
     bool m_HasSkinWeights;
@@ -0,0 +1,237 @@
+#include "MipmapGenerator.hpp"
+#include "../Renderer/ShaderLibrary.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <iostream>
+
+namespace Crescent {
+
+namespace {
+    // Matches MipDownsampleParams in Mipmaps.metal.
+    struct MipDownsampleParams {
+        uint32_t srgb;
+        uint32_t level;
+        float alphaCutoff;
+        uint32_t pad;
+    };
+
+    // One coverage slot per level: slot 0 holds level 0's coverage, the rest each level's scale.
+    constexpr size_t kCoverageSlots = 16;
+    constexpr NS::UInteger kGroupSize = 8;
+    constexpr NS::UInteger kCoverageThreads = 256;
+
+    MTL::ComputePipelineState* BuildPipeline(MTL::Device* device, MTL::Library* lib, const char* name) {
+        MTL::Function* func = lib->newFunction(NS::String::string(name, NS::UTF8StringEncoding));
+        if (!func) {
+            std::cerr << "MipmapGenerator: missing " << name << " shader\n";
+            return nullptr;
+        }
+        NS::Error* error = nullptr;
+        MTL::ComputePipelineState* pipeline = device->newComputePipelineState(func, &error);
+        func->release();
+        if (!pipeline && error) {
+            std::cerr << "MipmapGenerator: " << name << " pipeline error "
+                      << error->localizedDescription()->utf8String() << "\n";
+        }
+        return pipeline;
+    }
+
+    MTL::Size GroupsFor(NS::UInteger width, NS::UInteger height) {
+        return MTL::Size((width + kGroupSize - 1) / kGroupSize, (height + kGroupSize - 1) / kGroupSize, 1);
+    }
+}
+
+MipmapGenerator::MipmapGenerator()
+    : m_device(nullptr)
+    , m_queue(nullptr)
+    , m_normalPipeline(nullptr)
+    , m_coverageMeasurePipeline(nullptr)
+    , m_coverageDownsamplePipeline(nullptr) {
+}
+
+MipmapGenerator::~MipmapGenerator() {
+    shutdown();
+}
+
+bool MipmapGenerator::initialize(MTL::Device* device, MTL::CommandQueue* queue) {
+    m_device = device;
+    m_queue = queue;
+    if (!m_device || !m_queue) {
+        return false;
+    }
+    // Without the pipelines every texture still gets a box-filtered chain from the blit encoder.
+    MTL::Library* lib = ShaderLibrary::getInstance().acquire(m_device, ShaderLibrary::Module::Core);
+    if (!lib) {
+        std::cerr << "MipmapGenerator: missing default Metal library, using box filtering only\n";
+        return true;
+    }
+    m_normalPipeline = BuildPipeline(m_device, lib, "mip_downsample_normal");
+    m_coverageMeasurePipeline = BuildPipeline(m_device, lib, "mip_measure_alpha_coverage");
+    m_coverageDownsamplePipeline = BuildPipeline(m_device, lib, "mip_downsample_alpha_coverage");
+    lib->release();
+    return true;
+}
+
+void MipmapGenerator::shutdown() {
+    flush();
+    if (m_normalPipeline) { m_normalPipeline->release(); m_normalPipeline = nullptr; }
+    if (m_coverageMeasurePipeline) { m_coverageMeasurePipeline->release(); m_coverageMeasurePipeline = nullptr; }
+    if (m_coverageDownsamplePipeline) { m_coverageDownsamplePipeline->release(); m_coverageDownsamplePipeline = nullptr; }
+    m_queue = nullptr;
+    m_device = nullptr;
+}
+
+bool MipmapGenerator::canFilter(MTL::Texture* texture) const {
+    const MTL::PixelFormat format = texture->pixelFormat();
+    const MTL::TextureUsage usage = texture->usage();
+    if (format != MTL::PixelFormatRGBA8Unorm && format != MTL::PixelFormatRGBA8Unorm_sRGB) {
+        return false;
+    }
+    if (!(usage & MTL::TextureUsageShaderWrite)) {
+        return false;
+    }
+    return format == MTL::PixelFormatRGBA8Unorm || (usage & MTL::TextureUsagePixelFormatView);
+}
+
+MipmapGenerator::Filter MipmapGenerator::queue(MTL::Texture* texture, Filter filter) {
+    if (!texture || texture->mipmapLevelCount() <= 1) {
+        return Filter::Box;
+    }
+    Job job;
+    job.texture = texture->retain();
+    job.filter = filter;
+    if (job.filter == Filter::NormalMap && !m_normalPipeline) {
+        job.filter = Filter::Box;
+    }
+    if (job.filter == Filter::AlphaCoverage && (!m_coverageMeasurePipeline || !m_coverageDownsamplePipeline)) {
+        job.filter = Filter::Box;
+    }
+    if (job.filter != Filter::Box && (!canFilter(texture) || texture->mipmapLevelCount() > kCoverageSlots)) {
+        job.filter = Filter::Box;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.push_back(job);
+    return job.filter;
+}
+
+size_t MipmapGenerator::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending.size();
+}
+
+size_t MipmapGenerator::flush() {
+    std::vector<Job> jobs;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        jobs.swap(m_pending);
+    }
+    if (jobs.empty()) {
+        return 0;
+    }
+    MTL::CommandBuffer* commandBuffer = m_queue ? m_queue->commandBuffer() : nullptr;
+    if (!commandBuffer) {
+        for (const Job& job : jobs) {
+            job.texture->release();
+        }
+        return 0;
+    }
+    commandBuffer->setLabel(NS::String::string("Texture Mipmaps", NS::UTF8StringEncoding));
+
+    size_t filtered = 0;
+    MTL::BlitCommandEncoder* blit = nullptr;
+    for (const Job& job : jobs) {
+        if (job.filter != Filter::Box) {
+            ++filtered;
+            continue;
+        }
+        if (!blit) {
+            blit = commandBuffer->blitCommandEncoder();
+        }
+        blit->generateMipmaps(job.texture);
+    }
+    if (blit) {
+        blit->endEncoding();
+    }
+
+    if (filtered > 0) {
+        MTL::Buffer* coverage = m_device->newBuffer(sizeof(float) * kCoverageSlots * filtered, MTL::ResourceStorageModePrivate);
+        MTL::ComputeCommandEncoder* encoder = coverage ? commandBuffer->computeCommandEncoder() : nullptr;
+        if (encoder) {
+            encoder->setLabel(NS::String::string("Filtered Mipmaps", NS::UTF8StringEncoding));
+            size_t slot = 0;
+            for (const Job& job : jobs) {
+                if (job.filter != Filter::Box) {
+                    encodeFiltered(encoder, job, coverage, sizeof(float) * kCoverageSlots * slot++);
+                }
+            }
+            encoder->endEncoding();
+        } else {
+            std::cerr << "MipmapGenerator: failed to encode filtered mipmaps\n";
+        }
+        if (coverage) {
+            coverage->release();
+        }
+    }
+
+    // No wait: later command buffers on the queue run after this one.
+    commandBuffer->commit();
+    for (const Job& job : jobs) {
+        job.texture->release();
+    }
+    return jobs.size();
+}
+
+void MipmapGenerator::encodeFiltered(MTL::ComputeCommandEncoder* encoder,
+                                     const Job& job,
+                                     MTL::Buffer* coverage,
+                                     size_t coverageOffset) {
+    // Levels are written through unorm views; the shaders handle sRGB themselves since not every
+    // GPU can write sRGB textures.
+    MTL::Texture* texture = job.texture;
+    const NS::UInteger levels = texture->mipmapLevelCount();
+    std::vector<MTL::Texture*> views(levels, nullptr);
+    for (NS::UInteger level = 0; level < levels; ++level) {
+        views[level] = texture->newTextureView(MTL::PixelFormatRGBA8Unorm, MTL::TextureType2D,
+                                               NS::Range::Make(level, 1), NS::Range::Make(0, 1));
+        if (!views[level]) {
+            std::cerr << "MipmapGenerator: failed to create mip view\n";
+            for (MTL::Texture* view : views) {
+                if (view) view->release();
+            }
+            return;
+        }
+    }
+
+    MipDownsampleParams params{};
+    params.srgb = texture->pixelFormat() == MTL::PixelFormatRGBA8Unorm_sRGB ? 1u : 0u;
+    params.alphaCutoff = kAlphaCutoff;
+    const bool alphaCoverage = job.filter == Filter::AlphaCoverage;
+    encoder->setBuffer(coverage, coverageOffset, 1);
+    if (alphaCoverage) {
+        params.level = 0;
+        encoder->setComputePipelineState(m_coverageMeasurePipeline);
+        encoder->setTexture(views[0], 0);
+        encoder->setBytes(&params, sizeof(params), 0);
+        encoder->dispatchThreadgroups(MTL::Size(1, 1, 1), MTL::Size(kCoverageThreads, 1, 1));
+    }
+    for (NS::UInteger level = 1; level < levels; ++level) {
+        params.level = static_cast<uint32_t>(level);
+        encoder->setBytes(&params, sizeof(params), 0);
+        encoder->setTexture(views[level - 1], 0);
+        if (alphaCoverage) {
+            encoder->setComputePipelineState(m_coverageMeasurePipeline);
+            encoder->dispatchThreadgroups(MTL::Size(1, 1, 1), MTL::Size(kCoverageThreads, 1, 1));
+            encoder->setComputePipelineState(m_coverageDownsamplePipeline);
+        } else {
+            encoder->setComputePipelineState(m_normalPipeline);
+        }
+        encoder->setTexture(views[level], 1);
+        encoder->dispatchThreadgroups(GroupsFor(views[level]->width(), views[level]->height()),
+                                      MTL::Size(kGroupSize, kGroupSize, 1));
+    }
+    for (MTL::Texture* view : views) {
+        view->release();
+    }
+}
+
+} // namespace Crescent
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace MTL {
+class Device;
+class CommandQueue;
+class ComputePipelineState;
+class ComputeCommandEncoder;
+class Buffer;
+class Texture;
+}
+
+namespace Crescent {
+
+// Builds mip chains for imported RGBA8 textures in batches. Loads queue their textures from any
+// thread and flush() encodes the whole batch into one command buffer and commits it without
+// waiting; the queue runs it ahead of any work committed later, so a frame committed after the
+// flush samples complete chains.
+//
+// Box filtering goes through the blit encoder. Normal maps are averaged as vectors and
+// renormalized, with the averaged length kept in alpha so shading can widen roughness where the
+// normals diverge (Toksvig). Alpha-tested textures rescale each level's alpha so the share of
+// texels passing the cutoff matches level 0, which keeps foliage from thinning out with distance.
+class MipmapGenerator {
+public:
+    enum class Filter {
+        Box,
+        NormalMap,
+        AlphaCoverage
+    };
+
+    static constexpr float kAlphaCutoff = 0.5f; // Material's default alpha cutoff
+
+    MipmapGenerator();
+    ~MipmapGenerator();
+
+    bool initialize(MTL::Device* device, MTL::CommandQueue* queue);
+    void shutdown();
+
+    // Filters other than Box write levels from a shader, so their textures need ShaderWrite
+    // usage, plus PixelFormatView when sRGB.
+    static bool needsShaderWrite(Filter filter) { return filter != Filter::Box; }
+
+    // Retains the texture until the batch is flushed and returns the filter it will get; textures
+    // the compute filters cannot write fall back to Box.
+    Filter queue(MTL::Texture* texture, Filter filter);
+    // Returns the number of textures in the committed batch.
+    size_t flush();
+    size_t getPendingCount() const;
+
+private:
+    struct Job {
+        MTL::Texture* texture = nullptr;
+        Filter filter = Filter::Box;
+    };
+
+    bool canFilter(MTL::Texture* texture) const;
+    void encodeFiltered(MTL::ComputeCommandEncoder* encoder, const Job& job, MTL::Buffer* coverage, size_t coverageOffset);
+
+    MTL::Device* m_device;
+    MTL::CommandQueue* m_queue;
+    MTL::ComputePipelineState* m_normalPipeline;
+    MTL::ComputePipelineState* m_coverageMeasurePipeline;
+    MTL::ComputePipelineState* m_coverageDownsamplePipeline;
+    mutable std::mutex m_mutex;
+    std::vector<Job> m_pending;
+};
+
+} // namespace Crescent
@@ -1,5 +1,6 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "Texture.hpp"
+#include "MipmapGenerator.hpp"
 #include "stb_image.h"
 
 // stb_image_write provides stbi_zlib_compress used by tinyexr when STB zlib is enabled
@@ -13,19 +14,27 @@
 #include "tinyexr.h"
 
 #include "../Assets/AssetDatabase.hpp"
+#include "../Core/CPUProfiler.hpp"
+#include "../Core/StartupTrace.hpp"
+#include "../Core/ThreadQoS.hpp"
 #include "../../../ThirdParty/nlohmann/json.hpp"
 #include <filesystem>
 #include <Metal/Metal.hpp>
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <mach-o/dyld.h>
 #include <iomanip>
 #include <fstream>
 #include <mutex>
 #include <sstream>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 #include <iostream>
 #include <vector>
@@ -172,22 +181,33 @@ std::string GetExecutablePath() {
     return ec ? buffer : resolved.string();
 }
 
-std::filesystem::path ResolveBasisuPath() {
-    const char* envPath = std::getenv("CRESCENT_BASISU_PATH");
+// Command line tools come from the environment override, the app bundle's Resources, then the
+// ThirdParty checkout relative to the working directory.
+std::filesystem::path ResolveToolPath(const char* envVar, const char* bundleName, const std::filesystem::path& checkoutPath) {
+    const char* envPath = std::getenv(envVar);
     if (envPath && *envPath) {
         return envPath;
     }
 
     std::string exePath = GetExecutablePath();
     if (!exePath.empty()) {
-        std::filesystem::path bundlePath = std::filesystem::path(exePath).parent_path() / ".." / "Resources" / "basisu";
+        std::filesystem::path bundlePath = std::filesystem::path(exePath).parent_path() / ".." / "Resources" / bundleName;
         std::error_code ec;
         if (std::filesystem::exists(bundlePath, ec)) {
             return bundlePath;
         }
     }
 
-    return std::filesystem::current_path() / "ThirdParty" / "basisu" / "basisu";
+    return std::filesystem::current_path() / "ThirdParty" / checkoutPath;
+}
+
+std::filesystem::path ResolveBasisuPath() {
+    return ResolveToolPath("CRESCENT_BASISU_PATH", "basisu", std::filesystem::path("basisu") / "basisu");
+}
+
+std::filesystem::path ResolveAstcencPath() {
+    return ResolveToolPath("CRESCENT_ASTCENC_PATH", "astcenc",
+                           std::filesystem::path("astc-encoder-build") / "Source" / "astcenc-native");
 }
 
 } // namespace
@@ -204,15 +224,44 @@ void EnsureBasisuInitialized() {
     });
 }
 
-basist::transcoder_texture_format SelectAstcFormat(bool normalMap) {
-    (void)normalMap;
-    // BasisU KTX2 transcoder only supports ASTC LDR 4x4 for ETC1S/UASTC.
-    return basist::transcoder_texture_format::cTFASTC_LDR_4x4_RGBA;
-}
+std::once_flag g_astcencMissingFlag;
 
-MTL::PixelFormat SelectAstcPixelFormat(bool srgb, bool normalMap) {
-    (void)normalMap;
-    return srgb ? MTL::PixelFormatASTC_4x4_sRGB : MTL::PixelFormatASTC_4x4_LDR;
+// What cooked textures become on the GPU. BasisU transcodes ETC1S/UASTC straight to ASTC 4x4 and
+// BC7 only; larger ASTC footprints are encoded with astcenc from the decoded levels.
+struct TranscodeTarget {
+    basist::transcoder_texture_format format = basist::transcoder_texture_format::cTFASTC_LDR_4x4_RGBA;
+    MTL::PixelFormat pixelFormat = MTL::PixelFormatInvalid;
+    uint32_t blockSize = 4;
+    const char* label = "ASTC4x4";
+
+    bool needsAstcenc() const { return blockSize > 4; }
+};
+
+// GPUs without ASTC (Intel and AMD Macs) get BC7, which has no footprint choice.
+TranscodeTarget SelectTranscodeTarget(bool supportsAstc, bool srgb, uint32_t blockSize) {
+    TranscodeTarget target;
+    if (!supportsAstc) {
+        target.format = basist::transcoder_texture_format::cTFBC7_RGBA;
+        target.pixelFormat = srgb ? MTL::PixelFormatBC7_RGBAUnorm_sRGB : MTL::PixelFormatBC7_RGBAUnorm;
+        target.label = "BC7";
+        return target;
+    }
+    target.blockSize = blockSize;
+    switch (blockSize) {
+    case 6:
+        target.pixelFormat = srgb ? MTL::PixelFormatASTC_6x6_sRGB : MTL::PixelFormatASTC_6x6_LDR;
+        target.label = "ASTC6x6";
+        break;
+    case 8:
+        target.pixelFormat = srgb ? MTL::PixelFormatASTC_8x8_sRGB : MTL::PixelFormatASTC_8x8_LDR;
+        target.label = "ASTC8x8";
+        break;
+    default:
+        target.blockSize = 4;
+        target.pixelFormat = srgb ? MTL::PixelFormatASTC_4x4_sRGB : MTL::PixelFormatASTC_4x4_LDR;
+        break;
+    }
+    return target;
 }
 
 uint32_t ComputeBlocksX(uint32_t width, uint32_t blockWidth) {
@@ -461,6 +510,24 @@ std::string GetEmbeddedTempSourcePath(const std::string& cacheKey) {
     return (sourceDir / ("embedded_" + HashPathStable(NormalizeEmbeddedCacheKey(cacheKey)) + ".png")).string();
 }
 
+// ASTC footprint for a cooked texture. The import setting wins; otherwise tangent-space normals
+// keep 4x4 since their error lands directly in the lighting, linear data maps (ORM, masks) take
+// 6x6, and color maps take 6x6 once they are large enough that a block covers little surface.
+uint32_t ResolveAstcBlockSize(const std::string& sourcePath, bool srgb, bool normalMap, uint32_t width, uint32_t height) {
+    AssetRecord record;
+    if (!IsEmbeddedTextureCacheKey(sourcePath) && AssetDatabase::getInstance().getRecordForPath(sourcePath, record)) {
+        const int requested = record.textureSettings.blockSize;
+        if (requested == 4 || requested == 6 || requested == 8) {
+            return static_cast<uint32_t>(requested);
+        }
+        normalMap = normalMap || record.textureSettings.normalMap;
+    }
+    if (!srgb) {
+        return normalMap ? 4u : 6u;
+    }
+    return std::max(width, height) >= 1024 ? 6u : 4u;
+}
+
 bool WriteRGBA8PNG(const std::string& path, const unsigned char* rgba, int width, int height) {
     if (path.empty() || !rgba || width <= 0 || height <= 0) {
         return false;
@@ -487,6 +554,111 @@ bool IsCacheValid(const std::string& sourcePath, const std::string& cachePath) {
     return cacheTime >= sourceTime;
 }
 
+thread_local bool t_textureStreamThread = false;
+// The heap of the request a streaming thread is working on.
+thread_local std::shared_ptr<TextureHeap> t_streamPlacementHeap;
+
+// stb keeps the flip flag in a global; streaming threads set their own so a load on another
+// thread cannot flip their image.
+void SetFlipVerticallyOnLoad(bool flipVertical) {
+    if (t_textureStreamThread) {
+        stbi_set_flip_vertically_on_load_thread(flipVertical ? 1 : 0);
+    } else {
+        stbi_set_flip_vertically_on_load(flipVertical ? 1 : 0);
+    }
+}
+
+// Transcoded ASTC stored as-is so the IO queue can load it straight into a texture: header, level
+// table, then every level's blocks at its offset from the start of the file.
+constexpr uint32_t kRawTextureMagic = 0x58545243u; // "CRTX"
+constexpr uint32_t kRawTextureVersion = 1;
+constexpr uint32_t kRawTextureMaxLevels = 16;
+constexpr uint64_t kRawTextureDataAlignment = 16;
+
+struct RawTextureHeader {
+    uint32_t magic = kRawTextureMagic;
+    uint32_t version = kRawTextureVersion;
+    uint32_t pixelFormat = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t levels = 0;
+};
+
+struct RawTextureLevel {
+    uint64_t offset = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t bytesPerRow = 0;
+    uint32_t bytesPerImage = 0;
+};
+
+std::string GetRawTexturePath(const std::string& ktx2Path) {
+    return ktx2Path + ".astc";
+}
+
+// Level offsets come in relative to data and are written relative to the file. The file is
+// renamed into place so a concurrent reader never sees it half written.
+bool WriteRawTextureFile(const std::string& path,
+                         uint32_t pixelFormat,
+                         uint32_t width,
+                         uint32_t height,
+                         std::vector<RawTextureLevel> levels,
+                         const std::vector<uint8_t>& data) {
+    if (path.empty() || levels.empty() || levels.size() > kRawTextureMaxLevels) {
+        return false;
+    }
+    RawTextureHeader header;
+    header.pixelFormat = pixelFormat;
+    header.width = width;
+    header.height = height;
+    header.levels = static_cast<uint32_t>(levels.size());
+    uint64_t dataStart = sizeof(RawTextureHeader) + sizeof(RawTextureLevel) * levels.size();
+    dataStart = (dataStart + kRawTextureDataAlignment - 1) / kRawTextureDataAlignment * kRawTextureDataAlignment;
+    for (RawTextureLevel& level : levels) {
+        level.offset += dataStart;
+    }
+
+    // Per process: parallel cook processes can transcode the same cached texture.
+    const std::string tempPath = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(levels.data()),
+                   static_cast<std::streamsize>(sizeof(RawTextureLevel) * levels.size()));
+        const uint64_t tableEnd = sizeof(RawTextureHeader) + sizeof(RawTextureLevel) * levels.size();
+        const char padding[kRawTextureDataAlignment] = {};
+        file.write(padding, static_cast<std::streamsize>(dataStart - tableEnd));
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool ReadRawTextureHeader(const std::string& path, RawTextureHeader& header, std::vector<RawTextureLevel>& levels) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open() || !file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+    }
+    if (header.magic != kRawTextureMagic || header.version != kRawTextureVersion ||
+        header.levels == 0 || header.levels > kRawTextureMaxLevels || header.width == 0 || header.height == 0) {
+        return false;
+    }
+    levels.resize(header.levels);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(levels.data()),
+                                       static_cast<std::streamsize>(sizeof(RawTextureLevel) * levels.size())));
+}
+
 bool FileLikelyHasAlphaChannel(const std::string& path) {
     int width = 0;
     int height = 0;
@@ -510,6 +682,42 @@ bool RGBAHasMeaningfulAlpha(const unsigned char* rgba, int width, int height) {
     return false;
 }
 
+// Cutout alpha is mostly fully opaque or fully clear. Blended alpha spreads over partial values
+// and keeps the plain box average, which is what blending wants at a distance.
+bool RGBALooksAlphaTested(const unsigned char* rgba, int width, int height) {
+    const size_t pixelCount = static_cast<size_t>(width) * static_cast<size_t>(height);
+    size_t clear = 0;
+    size_t partial = 0;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const unsigned char alpha = rgba[i * 4 + 3];
+        if (alpha <= 5) {
+            ++clear;
+        } else if (alpha < 250) {
+            ++partial;
+        }
+    }
+    return clear > 0 && partial <= clear / 4;
+}
+
+MipmapGenerator::Filter SelectMipFilter(bool srgb, bool normalMap, const unsigned char* rgba, int width, int height) {
+    // Albedo maps are requested with normalMap set as well, so only linear ones are normals.
+    if (normalMap && !srgb) {
+        return MipmapGenerator::Filter::NormalMap;
+    }
+    if (srgb && rgba && RGBALooksAlphaTested(rgba, width, height)) {
+        return MipmapGenerator::Filter::AlphaCoverage;
+    }
+    return MipmapGenerator::Filter::Box;
+}
+
+MTL::TextureUsage MipFilterUsage(MipmapGenerator::Filter filter) {
+    MTL::TextureUsage usage = MTL::TextureUsageShaderRead;
+    if (MipmapGenerator::needsShaderWrite(filter)) {
+        usage |= MTL::TextureUsageShaderWrite | MTL::TextureUsagePixelFormatView;
+    }
+    return usage;
+}
+
 bool EncodeKtx2WithBasisuCLI(const std::string& sourcePath,
                              const std::string& outputPath,
                              bool srgb,
@@ -526,6 +734,12 @@ bool EncodeKtx2WithBasisuCLI(const std::string& sourcePath,
 
     std::filesystem::create_directories(std::filesystem::path(outputPath).parent_path(), ec);
 
+    // Streaming threads encode concurrently and may load the cache the moment it exists, so the
+    // encoder writes a per-thread temporary that is renamed into place once complete.
+    std::ostringstream tempName;
+    tempName << outputPath << "." << std::hex << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp.ktx2";
+    const std::string tempPath = tempName.str();
+
     std::string cmd;
     cmd.reserve(512);
     cmd += QuoteShellArg(basisuPath.string());
@@ -546,7 +760,7 @@ bool EncodeKtx2WithBasisuCLI(const std::string& sourcePath,
     cmd += " -file ";
     cmd += QuoteShellArg(sourcePath);
     cmd += " -output_file ";
-    cmd += QuoteShellArg(outputPath);
+    cmd += QuoteShellArg(tempPath);
     cmd += " -no_status_output";
 
     if (isKtx2DebugEnabled()) {
@@ -556,11 +770,101 @@ bool EncodeKtx2WithBasisuCLI(const std::string& sourcePath,
     int result = std::system(cmd.c_str());
     if (result != 0) {
         std::cerr << "[TextureLoader] BasisU encode failed (" << result << "): " << sourcePath << std::endl;
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    std::filesystem::rename(tempPath, outputPath, ec);
+    if (ec) {
+        std::cerr << "[TextureLoader] Failed to move encoded KTX2 into place: " << outputPath << std::endl;
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+// Encodes one decoded level with the astcenc CLI and returns its blocks in row-major order.
+bool EncodeAstcLevelWithCLI(const std::vector<uint8_t>& rgba,
+                            uint32_t width,
+                            uint32_t height,
+                            uint32_t blockSize,
+                            bool srgb,
+                            std::vector<uint8_t>& outBlocks) {
+    std::error_code ec;
+    std::ostringstream tempName;
+    tempName << "crescent_astc_" << std::hex << std::hash<std::thread::id>()(std::this_thread::get_id());
+    const std::filesystem::path tempBase = std::filesystem::temp_directory_path(ec) / tempName.str();
+    const std::string pngPath = tempBase.string() + ".png";
+    const std::string astcPath = tempBase.string() + ".astc";
+    if (ec || !WriteRGBA8PNG(pngPath, rgba.data(), static_cast<int>(width), static_cast<int>(height))) {
+        return false;
+    }
+
+    std::string cmd;
+    cmd.reserve(512);
+    cmd += QuoteShellArg(ResolveAstcencPath().string());
+    cmd += srgb ? " -cs " : " -cl ";
+    cmd += QuoteShellArg(pngPath);
+    cmd += " ";
+    cmd += QuoteShellArg(astcPath);
+    cmd += " " + std::to_string(blockSize) + "x" + std::to_string(blockSize);
+    cmd += " -fast -silent";
+    const int result = std::system(cmd.c_str());
+
+    std::vector<uint8_t> file;
+    const bool read = result == 0 && ReadFileBytes(astcPath, file);
+    std::filesystem::remove(pngPath, ec);
+    std::filesystem::remove(astcPath, ec);
+    if (!read) {
+        std::cerr << "[TextureLoader] astcenc failed (" << result << ") for a "
+                  << width << "x" << height << " level" << std::endl;
+        return false;
     }
-    return result == 0;
+
+    // .astc files: magic, block footprint, 24-bit little-endian extents, then 16-byte blocks.
+    constexpr size_t kAstcHeaderSize = 16;
+    const size_t blockBytes = static_cast<size_t>(ComputeBlocksX(width, blockSize)) *
+        ComputeBlocksX(height, blockSize) * 16;
+    const uint32_t magic = file.size() >= kAstcHeaderSize
+        ? (file[0] | (file[1] << 8) | (file[2] << 16) | (static_cast<uint32_t>(file[3]) << 24))
+        : 0;
+    if (magic != 0x5CA1AB13u || file[4] != blockSize || file[5] != blockSize ||
+        file.size() < kAstcHeaderSize + blockBytes) {
+        std::cerr << "[TextureLoader] astcenc wrote an unexpected file for a "
+                  << width << "x" << height << " level" << std::endl;
+        return false;
+    }
+    outBlocks.assign(file.begin() + kAstcHeaderSize, file.begin() + kAstcHeaderSize + blockBytes);
+    return true;
 }
 
-bool LoadHDRPixelsForCooking(const std::string& sourcePath,
+// Halves an RGBA float image with a 2x2 box filter; odd edges repeat their last texel.
+void HalveRGBA32F(std::vector<float>& pixels, int& width, int& height) {
+    const int halfWidth = std::max(1, width / 2);
+    const int halfHeight = std::max(1, height / 2);
+    std::vector<float> halved(static_cast<size_t>(halfWidth) * static_cast<size_t>(halfHeight) * 4u);
+    for (int y = 0; y < halfHeight; ++y) {
+        const int y0 = std::min(y * 2, height - 1);
+        const int y1 = std::min(y * 2 + 1, height - 1);
+        for (int x = 0; x < halfWidth; ++x) {
+            const int x0 = std::min(x * 2, width - 1);
+            const int x1 = std::min(x * 2 + 1, width - 1);
+            const size_t taps[4] = {
+                (static_cast<size_t>(y0) * width + x0) * 4u, (static_cast<size_t>(y0) * width + x1) * 4u,
+                (static_cast<size_t>(y1) * width + x0) * 4u, (static_cast<size_t>(y1) * width + x1) * 4u
+            };
+            float* out = halved.data() + (static_cast<size_t>(y) * halfWidth + x) * 4u;
+            for (int c = 0; c < 4; ++c) {
+                out[c] = 0.25f * (pixels[taps[0] + c] + pixels[taps[1] + c] + pixels[taps[2] + c] + pixels[taps[3] + c]);
+            }
+        }
+    }
+    pixels.swap(halved);
+    width = halfWidth;
+    height = halfHeight;
+}
+
+// RGBA float pixels of an HDR or EXR source, top row first.
+bool LoadHDRPixels(const std::string& sourcePath,
                              std::vector<float>& outPixels,
                              int& outWidth,
                              int& outHeight) {
@@ -575,7 +879,7 @@ bool LoadHDRPixelsForCooking(const std::string& sourcePath,
         int height = 0;
         int ret = LoadEXR(&imageData, &width, &height, sourcePath.c_str(), &err);
         if (ret != TINYEXR_SUCCESS || !imageData) {
-            std::cerr << "[TextureLoader] Failed to load EXR for static lightmap cook: " << sourcePath;
+            std::cerr << "[TextureLoader] Failed to load EXR: " << sourcePath;
             if (err) {
                 std::cerr << " reason: " << err;
                 FreeEXRErrorMessage(err);
@@ -603,7 +907,7 @@ bool LoadHDRPixelsForCooking(const std::string& sourcePath,
     int channels = 0;
     float* imageData = stbi_loadf(sourcePath.c_str(), &width, &height, &channels, 4);
     if (!imageData) {
-        std::cerr << "[TextureLoader] Failed to load HDR for static lightmap cook: " << sourcePath
+        std::cerr << "[TextureLoader] Failed to load HDR: " << sourcePath
                   << " reason: " << stbi_failure_reason() << std::endl;
         return false;
     }
@@ -623,7 +927,13 @@ Texture2D::Texture2D()
     , m_Height(0)
     , m_MipLevelCount(1)
     , m_ApproximateBytes(0)
-    , m_ColorSpace(ColorSpace::SRGB) {
+    , m_ColorSpace(ColorSpace::SRGB)
+    , m_Streaming(false)
+    , m_FullMipCount(0)
+    , m_FullBytes(0)
+    , m_ResidentMip(0)
+    , m_PendingMip(kNoPendingMip)
+    , m_NormalLengthInAlpha(false) {
     updateDebugRegistry();
 }
 
@@ -719,13 +1029,328 @@ void Texture2D::logLiveStats(const std::string& reason, size_t maxEntries) {
     }
 }
 
+struct TextureLoader::StreamQueue {
+    struct Request {
+        std::weak_ptr<Texture2D> target;
+        std::string path;
+        std::string cacheKey;
+        bool srgb = true;
+        bool flipVertical = true;
+        bool normalMap = false;
+        // Mip loads reload levels firstMip.. of the sidecar at path instead of the whole texture.
+        bool mipLoad = false;
+        uint32_t firstMip = 0;
+        // The placement heap when the request was made, so a level's late loads still land in it.
+        std::shared_ptr<TextureHeap> placementHeap;
+    };
+    struct Result {
+        std::weak_ptr<Texture2D> target;
+        std::string cacheKey;
+        std::shared_ptr<Texture2D> loaded;
+        bool mipLoad = false;
+    };
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Request> pending;
+    std::vector<Result> completed;
+    std::unordered_map<std::string, std::vector<LoadedCallback>> callbacks; // by cache key
+    std::vector<std::thread> threads;
+    bool stopping = false;
+};
+
+namespace {
+// Decodes mostly wait on the BasisU encoder process or the disk, so two threads keep both busy
+// without taking cores from the frame's jobs.
+constexpr size_t kStreamWorkerCount = 2;
+}
+
 TextureLoader::TextureLoader(MTL::Device* device, MTL::CommandQueue* commandQueue)
     : m_Device(device)
-    , m_CommandQueue(commandQueue) {
+    , m_CommandQueue(commandQueue)
+    , m_IOQueue(nullptr)
+    , m_Residency(kDefaultResidencyBudget, [](const Texture2D& texture) { return texture.getApproximateBytes(); })
+    , m_Stream(std::make_unique<StreamQueue>())
+    , m_Mipmaps(std::make_unique<MipmapGenerator>())
+    , m_StreamingCount(0)
+    , m_SupportsASTC(device && device->supportsFamily(MTL::GPUFamilyApple2)) {
+    m_Mipmaps->initialize(m_Device, m_CommandQueue);
+    if (m_Device) {
+        MTL::IOCommandQueueDescriptor* ioDesc = MTL::IOCommandQueueDescriptor::alloc()->init();
+        ioDesc->setType(MTL::IOCommandQueueTypeConcurrent);
+        ioDesc->setPriority(MTL::IOPriorityNormal);
+        NS::Error* error = nullptr;
+        m_IOQueue = m_Device->newIOCommandQueue(ioDesc, &error);
+        ioDesc->release();
+        if (!m_IOQueue) {
+            std::cerr << "[TextureLoader] IO command queue unavailable, cooked textures will be transcoded on load";
+            if (error) {
+                std::cerr << ": " << error->localizedDescription()->utf8String();
+            }
+            std::cerr << std::endl;
+        }
+    }
 }
 
 TextureLoader::~TextureLoader() {
+    stopStreamWorkers();
+    m_Mipmaps->shutdown();
+    m_Residency.clear();
     m_Cache.clear();
+    if (m_IOQueue) {
+        m_IOQueue->release();
+        m_IOQueue = nullptr;
+    }
+}
+
+void TextureLoader::startStreamWorkers() {
+    if (!m_Stream->threads.empty()) {
+        return;
+    }
+    m_Stream->stopping = false;
+    for (size_t i = 0; i < kStreamWorkerCount; ++i) {
+        m_Stream->threads.emplace_back([this]() { streamWorkerLoop(); });
+    }
+}
+
+void TextureLoader::stopStreamWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(m_Stream->mutex);
+        m_Stream->stopping = true;
+        m_Stream->pending.clear();
+    }
+    m_Stream->wake.notify_all();
+    for (std::thread& thread : m_Stream->threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    m_Stream->threads.clear();
+    m_Stream->completed.clear();
+    m_Stream->callbacks.clear();
+    m_StreamingCount = 0;
+}
+
+void TextureLoader::markLoadingThread() {
+    t_textureStreamThread = true;
+}
+
+void TextureLoader::streamWorkerLoop() {
+    markLoadingThread();
+    SetCurrentThreadQoS(ThreadQoS::Utility);
+    CRESCENT_PROFILE_THREAD("Texture Stream");
+    while (true) {
+        StreamQueue::Request request;
+        {
+            std::unique_lock<std::mutex> lock(m_Stream->mutex);
+            m_Stream->wake.wait(lock, [this]() { return m_Stream->stopping || !m_Stream->pending.empty(); });
+            if (m_Stream->stopping) {
+                return;
+            }
+            request = std::move(m_Stream->pending.front());
+            m_Stream->pending.pop_front();
+        }
+
+        StreamQueue::Result result{request.target, request.cacheKey, nullptr, request.mipLoad};
+        if (!request.target.expired()) {
+            NS::AutoreleasePool* pool = NS::AutoreleasePool::alloc()->init();
+            CRESCENT_PROFILE_SCOPE("TextureLoader::streamRequest");
+            t_streamPlacementHeap = std::move(request.placementHeap);
+            if (request.mipLoad) {
+                result.loaded = loadRawAstcTexture(request.path, request.srgb, request.normalMap,
+                                                   request.cacheKey, request.firstMip);
+            } else {
+                result.loaded = loadTextureUncached(request.path, request.srgb, request.flipVertical, request.normalMap);
+            }
+            t_streamPlacementHeap.reset();
+            pool->release();
+        }
+        std::lock_guard<std::mutex> lock(m_Stream->mutex);
+        m_Stream->completed.push_back(std::move(result));
+    }
+}
+
+std::shared_ptr<Texture2D> TextureLoader::loadTextureAsync(const std::string& path,
+                                                           bool srgb,
+                                                           bool flipVertical,
+                                                           bool normalMap,
+                                                           LoadedCallback onLoaded) {
+    auto loadNow = [&]() {
+        auto tex = loadTexture(path, srgb, flipVertical, normalMap);
+        if (onLoaded && tex) {
+            onLoaded(tex, true);
+        }
+        return tex;
+    };
+    if (!m_Device || isEXRFile(path) || isHDRFile(path)) {
+        return loadNow();
+    }
+
+    const std::string cacheKey = BuildTextureLoadCacheKey(path, srgb, flipVertical, normalMap);
+    if (auto cached = findCached(cacheKey)) {
+        if (onLoaded) {
+            // processStreamedTextures clears the flag before it takes the callbacks under
+            // the same lock, so the callback either joins them or the load has landed.
+            std::unique_lock<std::mutex> lock(m_Stream->mutex);
+            if (cached->isStreaming()) {
+                m_Stream->callbacks[cacheKey].push_back(std::move(onLoaded));
+            } else {
+                lock.unlock();
+                onLoaded(cached, true);
+            }
+        }
+        return cached;
+    }
+
+    std::shared_ptr<Texture2D>& placeholder = normalMap ? m_PlaceholderNormal : m_PlaceholderWhite;
+    if (!placeholder) {
+        placeholder = normalMap ? createFlatNormalTexture() : createSolidTexture(1.0f, 1.0f, 1.0f, 1.0f, false);
+    }
+    if (!placeholder || !placeholder->getHandle()) {
+        return loadNow();
+    }
+
+    auto tex = std::make_shared<Texture2D>();
+    tex->setHandle(placeholder->getHandle()->retain());
+    tex->setDimensions(1, 1);
+    tex->setColorSpace(srgb ? Texture2D::ColorSpace::SRGB : Texture2D::ColorSpace::Linear);
+    tex->setPath(path);
+    tex->setStreaming(true);
+    cacheTexture(cacheKey, tex);
+
+    startStreamWorkers();
+    m_StreamingCount.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_Stream->mutex);
+        if (onLoaded) {
+            m_Stream->callbacks[cacheKey].push_back(std::move(onLoaded));
+        }
+        m_Stream->pending.push_back({tex, path, cacheKey, srgb, flipVertical, normalMap, false, 0, currentPlacementHeap()});
+    }
+    m_Stream->wake.notify_one();
+    return tex;
+}
+
+bool TextureLoader::requestResidentMip(const std::shared_ptr<Texture2D>& texture, uint32_t firstMip) {
+    if (!texture || !texture->isMipStreamable() || texture->isStreaming() ||
+        texture->getPendingMip() != Texture2D::kNoPendingMip || !m_IOQueue) {
+        return false;
+    }
+    firstMip = std::min(firstMip, texture->getFullMipCount() - 1);
+    if (firstMip == texture->getResidentMip()) {
+        return false;
+    }
+    texture->setPendingMip(firstMip);
+
+    StreamQueue::Request request;
+    request.target = texture;
+    request.path = texture->getMipSource();
+    request.cacheKey = texture->getPath();
+    request.srgb = texture->isSRGB();
+    request.mipLoad = true;
+    request.firstMip = firstMip;
+    request.placementHeap = currentPlacementHeap();
+    startStreamWorkers();
+    {
+        std::lock_guard<std::mutex> lock(m_Stream->mutex);
+        m_Stream->pending.push_back(std::move(request));
+    }
+    m_Stream->wake.notify_one();
+    return true;
+}
+
+size_t TextureLoader::processStreamedTextures() {
+    CRESCENT_PROFILE_SCOPE("TextureLoader::processStreamedTextures");
+    std::vector<StreamQueue::Result> completed;
+    {
+        std::lock_guard<std::mutex> lock(m_Stream->mutex);
+        completed.swap(m_Stream->completed);
+    }
+    // Once a frame is often enough to catch the textures released since the last one.
+    m_Residency.trim();
+    const auto publishStart = std::chrono::steady_clock::now();
+    // Workers queue a texture's mips before they publish it, so this batch covers every result
+    // taken above.
+    flushPendingMipmaps();
+    for (StreamQueue::Result& result : completed) {
+        std::shared_ptr<Texture2D> target = result.target.lock();
+        if (result.mipLoad) {
+            if (!target) {
+                continue;
+            }
+            // Only the handle and its resident range change; the texture keeps its level-0 size.
+            if (result.loaded && result.loaded->getHandle()) {
+                target->setHandle(result.loaded->getHandle()->retain());
+                target->setResidentMip(result.loaded->getResidentMip());
+                target->setMipLevelCount(result.loaded->getMipLevelCount());
+                target->setApproximateBytes(result.loaded->getApproximateBytes());
+            } else {
+                std::cerr << "[TextureLoader] Mip load failed, keeping resident levels: " << target->getPath() << std::endl;
+            }
+            target->setPendingMip(Texture2D::kNoPendingMip);
+            continue;
+        }
+
+        m_StreamingCount.fetch_sub(1, std::memory_order_relaxed);
+        bool loaded = false;
+        if (target && result.loaded && result.loaded->getHandle()) {
+            // The path stays the requested one; the loaded texture may carry a cache path.
+            target->setHandle(result.loaded->getHandle()->retain());
+            target->setDimensions(result.loaded->getWidth(), result.loaded->getHeight());
+            target->setMipLevelCount(result.loaded->getMipLevelCount());
+            target->setApproximateBytes(result.loaded->getApproximateBytes());
+            target->setColorSpace(result.loaded->isSRGB() ? Texture2D::ColorSpace::SRGB : Texture2D::ColorSpace::Linear);
+            target->setMipSource(result.loaded->getMipSource(), result.loaded->getFullMipCount(),
+                                 result.loaded->getFullBytes());
+            target->setResidentMip(result.loaded->getResidentMip());
+            target->setNormalLengthInAlpha(result.loaded->hasNormalLengthInAlpha());
+            loaded = true;
+        } else if (target) {
+            std::cerr << "[TextureLoader] Streamed load failed, keeping placeholder: " << target->getPath() << std::endl;
+        }
+        if (target) {
+            target->setStreaming(false);
+        }
+
+        std::vector<LoadedCallback> pending;
+        {
+            std::lock_guard<std::mutex> lock(m_Stream->mutex);
+            auto callbacks = m_Stream->callbacks.find(result.cacheKey);
+            if (callbacks == m_Stream->callbacks.end()) {
+                continue;
+            }
+            pending = std::move(callbacks->second);
+            m_Stream->callbacks.erase(callbacks);
+        }
+        if (target) {
+            for (LoadedCallback& callback : pending) {
+                callback(target, loaded);
+            }
+        }
+    }
+    if (!completed.empty()) {
+        StartupTrace::getInstance().addSpan("texture", "Publish streamed textures", publishStart,
+                                            std::chrono::steady_clock::now(),
+                                            std::to_string(completed.size()) + " textures");
+    }
+    return completed.size();
+}
+
+std::shared_ptr<Texture2D> TextureLoader::findCached(const std::string& cacheKey) {
+    auto it = m_Cache.find(cacheKey);
+    if (it == m_Cache.end()) {
+        return nullptr;
+    }
+    std::shared_ptr<Texture2D> cached = it->second.lock();
+    if (cached) {
+        m_Residency.retain(cacheKey, cached);
+    }
+    return cached;
+}
+
+void TextureLoader::cacheTexture(const std::string& cacheKey, const std::shared_ptr<Texture2D>& texture) {
+    m_Cache[cacheKey] = texture;
+    m_Residency.retain(cacheKey, texture);
 }
 
 void TextureLoader::invalidateTexture(const std::string& path) {
@@ -739,6 +1364,7 @@ void TextureLoader::invalidateTexture(const std::string& path) {
             matches = true;
         }
         if (matches) {
+            m_Residency.erase(key);
             it = m_Cache.erase(it);
         } else {
             ++it;
@@ -755,10 +1381,8 @@ std::shared_ptr<Texture2D> TextureLoader::loadTextureUncompressed(const std::str
     }
 
     std::string cacheKey = BuildTextureLoadCacheKey(path, srgb, flipVertical, false) + "#raw";
-    if (auto it = m_Cache.find(cacheKey); it != m_Cache.end()) {
-        if (auto cached = it->second.lock()) {
-            return cached;
-        }
+    if (auto cached = findCached(cacheKey)) {
+        return cached;
     }
 
     if (isEXRFile(path)) {
@@ -769,8 +1393,16 @@ std::shared_ptr<Texture2D> TextureLoader::loadTextureUncompressed(const std::str
         return loadHDRTexture(path, flipVertical);
     }
 
+    auto tex = createUncompressedTexture(path, srgb, flipVertical);
+    if (tex) {
+        cacheTexture(cacheKey, tex);
+    }
+    return tex;
+}
+
+std::shared_ptr<Texture2D> TextureLoader::createUncompressedTexture(const std::string& path, bool srgb, bool flipVertical, bool normalMap) {
     int width = 0, height = 0, channels = 0;
-    stbi_set_flip_vertically_on_load(flipVertical ? 1 : 0);
+    SetFlipVerticallyOnLoad(flipVertical);
     stbi_uc* data = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
 
     if (!data) {
@@ -780,13 +1412,14 @@ std::shared_ptr<Texture2D> TextureLoader::loadTextureUncompressed(const std::str
     }
 
     MTL::PixelFormat format = srgb ? MTL::PixelFormatRGBA8Unorm_sRGB : MTL::PixelFormatRGBA8Unorm;
+    const MipmapGenerator::Filter mipFilter = SelectMipFilter(srgb, normalMap, data, width, height);
 
     MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
     desc->setTextureType(MTL::TextureType2D);
     desc->setWidth(static_cast<NS::UInteger>(width));
     desc->setHeight(static_cast<NS::UInteger>(height));
     desc->setPixelFormat(format);
-    desc->setUsage(MTL::TextureUsageShaderRead);
+    desc->setUsage(MipFilterUsage(mipFilter));
     desc->setStorageMode(MTL::StorageModeShared);
     uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
     desc->setMipmapLevelCount(static_cast<NS::UInteger>(mipLevels));
@@ -804,7 +1437,7 @@ std::shared_ptr<Texture2D> TextureLoader::loadTextureUncompressed(const std::str
     texture->replaceRegion(region, 0, data, static_cast<NS::UInteger>(width * 4));
     stbi_image_free(data);
 
-    generateMipmaps(texture);
+    const bool normalLengthInAlpha = m_Mipmaps->queue(texture, mipFilter) == MipmapGenerator::Filter::NormalMap;
     LogTextureMemory("RGBA8", static_cast<uint32_t>(width), static_cast<uint32_t>(height),
                      ComputeMipLevels(static_cast<uint32_t>(width), static_cast<uint32_t>(height)),
                      ComputeRGBA8MipChainBytes(static_cast<uint32_t>(width), static_cast<uint32_t>(height)));
@@ -815,9 +1448,9 @@ std::shared_ptr<Texture2D> TextureLoader::loadTextureUncompressed(const std::str
     tex->setMipLevelCount(ComputeMipLevels(static_cast<uint32_t>(width), static_cast<uint32_t>(height)));
     tex->setApproximateBytes(ComputeRGBA8MipChainBytes(static_cast<uint32_t>(width), static_cast<uint32_t>(height)));
     tex->setColorSpace(srgb ? Texture2D::ColorSpace::SRGB : Texture2D::ColorSpace::Linear);
+    tex->setNormalLengthInAlpha(normalLengthInAlpha);
     tex->setPath(path);
 
-    m_Cache[cacheKey] = tex;
     return tex;
 }
 
@@ -830,21 +1463,30 @@ std::shared_ptr<Texture2D> TextureLoader::loadTexture(const std::string& path, b
     const std::string cacheKey = BuildTextureLoadCacheKey(path, srgb, flipVertical, normalMap);
 
     // Cache lookup
-    if (auto it = m_Cache.find(cacheKey); it != m_Cache.end()) {
-        if (auto cached = it->second.lock()) {
-            return cached;
-        }
+    if (auto cached = findCached(cacheKey)) {
+        return cached;
+    }
+
+    std::shared_ptr<Texture2D> tex;
+    if (isEXRFile(path) || (!isKTX2File(path) && stbi_is_hdr(path.c_str()))) {
+        tex = loadTextureUncompressed(path, srgb, flipVertical);
+    } else {
+        tex = loadTextureUncached(path, srgb, flipVertical, normalMap);
+    }
+    if (tex) {
+        cacheTexture(cacheKey, tex);
     }
+    return tex;
+}
 
+std::shared_ptr<Texture2D> TextureLoader::loadTextureUncached(const std::string& path, bool srgb, bool flipVertical, bool normalMap) {
+    StartupTraceScope trace("texture", "Load texture", path);
+    CRESCENT_PROFILE_SCOPE("TextureLoader::loadTexture");
     if (!isKtx2Disabled() && isKTX2File(path)) {
         if (isKtx2DebugEnabled()) {
             std::cerr << "[TextureLoader] KTX2 debug: Loading KTX2 source " << path << std::endl;
         }
-        auto tex = loadKTX2Texture(path, srgb, normalMap, path);
-        if (tex) {
-            m_Cache[cacheKey] = tex;
-        }
-        return tex;
+        return loadKTX2Texture(path, srgb, normalMap, path);
     }
 
     if (!isKtx2Disabled() && isLdrTextureFile(path)) {
@@ -857,9 +1499,7 @@ std::shared_ptr<Texture2D> TextureLoader::loadTexture(const std::string& path, b
                 if (isKtx2DebugEnabled()) {
                     std::cerr << "[TextureLoader] KTX2 debug: Using cached KTX2 " << cachePath << std::endl;
                 }
-                auto tex = loadKTX2Texture(cachePath, srgb, normalMap, path);
-                if (tex) {
-                    m_Cache[cacheKey] = tex;
+                if (auto tex = loadCookedKTX2Texture(cachePath, srgb, normalMap, path)) {
                     return tex;
                 }
             }
@@ -876,20 +1516,14 @@ std::shared_ptr<Texture2D> TextureLoader::loadTexture(const std::string& path, b
                 std::cerr << "[TextureLoader] KTX2 debug: Encode result for " << path << " = " << (generated ? "ok" : "fail") << std::endl;
             }
             if (generated) {
-                auto tex = loadKTX2Texture(cachePath, srgb, normalMap, path);
-                if (tex) {
-                    m_Cache[cacheKey] = tex;
+                if (auto tex = loadCookedKTX2Texture(cachePath, srgb, normalMap, path)) {
                     return tex;
                 }
             }
         }
     }
 
-    auto tex = loadTextureUncompressed(path, srgb, flipVertical);
-    if (tex) {
-        m_Cache[cacheKey] = tex;
-    }
-    return tex;
+    return createUncompressedTexture(path, srgb, flipVertical, normalMap);
 }
 
 std::shared_ptr<Texture2D> TextureLoader::loadEmbeddedCookedTexture(const std::string& cacheKey, bool srgb, bool normalMap) {
@@ -899,10 +1533,8 @@ std::shared_ptr<Texture2D> TextureLoader::loadEmbeddedCookedTexture(const std::s
 
     const std::string variantCacheKey = BuildTextureLoadCacheKey(cacheKey, srgb, false, normalMap);
 
-    if (auto it = m_Cache.find(variantCacheKey); it != m_Cache.end()) {
-        if (auto cached = it->second.lock()) {
-            return cached;
-        }
+    if (auto cached = findCached(variantCacheKey)) {
+        return cached;
     }
 
     if (isKtx2Disabled()) {
@@ -933,9 +1565,9 @@ std::shared_ptr<Texture2D> TextureLoader::loadEmbeddedCookedTexture(const std::s
         return nullptr;
     }
 
-    auto tex = loadKTX2Texture(cachePath, srgb, normalMap, cacheKey);
+    auto tex = loadCookedKTX2Texture(cachePath, srgb, normalMap, cacheKey);
     if (tex) {
-        m_Cache[variantCacheKey] = tex;
+        cacheTexture(variantCacheKey, tex);
     }
     return tex;
 }
@@ -974,10 +1606,8 @@ std::shared_ptr<Texture2D> TextureLoader::createTextureFromRGBA8(const std::stri
     
     if (!cacheKey.empty()) {
         const std::string variantCacheKey = BuildTextureLoadCacheKey(cacheKey, srgb, flipVertical, normalMap);
-        if (auto it = m_Cache.find(variantCacheKey); it != m_Cache.end()) {
-            if (auto cached = it->second.lock()) {
-                return cached;
-            }
+        if (auto cached = findCached(variantCacheKey)) {
+            return cached;
         }
     }
     
@@ -1019,8 +1649,8 @@ std::shared_ptr<Texture2D> TextureLoader::createTextureFromRGBA8(const std::stri
                 if (isKtx2DebugEnabled()) {
                     std::cerr << "[TextureLoader] KTX2 debug: Using cached embedded KTX2 " << cachePath << std::endl;
                 }
-                if (auto tex = loadKTX2Texture(cachePath, srgb, normalMap, cacheKey)) {
-                    m_Cache[BuildTextureLoadCacheKey(cacheKey, srgb, flipVertical, normalMap)] = tex;
+                if (auto tex = loadCookedKTX2Texture(cachePath, srgb, normalMap, cacheKey)) {
+                    cacheTexture(BuildTextureLoadCacheKey(cacheKey, srgb, flipVertical, normalMap), tex);
                     return tex;
                 }
             }
@@ -1042,8 +1672,8 @@ std::shared_ptr<Texture2D> TextureLoader::createTextureFromRGBA8(const std::stri
                               << " = " << (generated ? "ok" : "fail") << std::endl;
                 }
                 if (generated) {
-                    if (auto tex = loadKTX2Texture(cachePath, srgb, normalMap, cacheKey)) {
-                        m_Cache[BuildTextureLoadCacheKey(cacheKey, srgb, flipVertical, normalMap)] = tex;
+                    if (auto tex = loadCookedKTX2Texture(cachePath, srgb, normalMap, cacheKey)) {
+                        cacheTexture(BuildTextureLoadCacheKey(cacheKey, srgb, flipVertical, normalMap), tex);
                         return tex;
                     }
                 }
@@ -1054,13 +1684,14 @@ std::shared_ptr<Texture2D> TextureLoader::createTextureFromRGBA8(const std::stri
     }
     
     MTL::PixelFormat format = srgb ? MTL::PixelFormatRGBA8Unorm_sRGB : MTL::PixelFormatRGBA8Unorm;
+    const MipmapGenerator::Filter mipFilter = SelectMipFilter(srgb, normalMap, uploadData, width, height);
     
     MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
     desc->setTextureType(MTL::TextureType2D);
     desc->setWidth(static_cast<NS::UInteger>(width));
     desc->setHeight(static_cast<NS::UInteger>(height));
     desc->setPixelFormat(format);
-    desc->setUsage(MTL::TextureUsageShaderRead);
+    desc->setUsage(MipFilterUsage(mipFilter));
     desc->setStorageMode(MTL::StorageModeShared);
     uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
     desc->setMipmapLevelCount(static_cast<NS::UInteger>(mipLevels));
@@ -1076,7 +1707,7 @@ std::shared_ptr<Texture2D> TextureLoader::createTextureFromRGBA8(const std::stri
     MTL::Region region = MTL::Region::Make2D(0, 0, static_cast<NS::UInteger>(width), static_cast<NS::UInteger>(height));
     texture->replaceRegion(region, 0, uploadData, static_cast<NS::UInteger>(width * 4));
     
-    generateMipmaps(texture);
+    const bool normalLengthInAlpha = m_Mipmaps->queue(texture, mipFilter) == MipmapGenerator::Filter::NormalMap;
     
     auto tex = std::make_shared<Texture2D>();
     tex->setHandle(texture);
@@ -1084,9 +1715,10 @@ std::shared_ptr<Texture2D> TextureLoader::createTextureFromRGBA8(const std::stri
     tex->setMipLevelCount(ComputeMipLevels(static_cast<uint32_t>(width), static_cast<uint32_t>(height)));
     tex->setApproximateBytes(ComputeRGBA8MipChainBytes(static_cast<uint32_t>(width), static_cast<uint32_t>(height)));
     tex->setColorSpace(srgb ? Texture2D::ColorSpace::SRGB : Texture2D::ColorSpace::Linear);
+    tex->setNormalLengthInAlpha(normalLengthInAlpha);
     if (!cacheKey.empty()) {
         tex->setPath(cacheKey);
-        m_Cache[BuildTextureLoadCacheKey(cacheKey, srgb, flipVertical, normalMap)] = tex;
+        cacheTexture(BuildTextureLoadCacheKey(cacheKey, srgb, flipVertical, normalMap), tex);
     }
     return tex;
 }
@@ -1096,7 +1728,7 @@ bool TextureLoader::updateTextureFromRGBA8(const std::shared_ptr<Texture2D>& tex
                                            int width,
                                            int height,
                                            bool flipVertical) {
-    if (!texture || !texture->getHandle() || !rgba || width <= 0 || height <= 0) {
+    if (!texture || !texture->getHandle() || texture->isStreaming() || !rgba || width <= 0 || height <= 0) {
         return false;
     }
     if (static_cast<int>(texture->getWidth()) != width || static_cast<int>(texture->getHeight()) != height) {
@@ -1126,7 +1758,10 @@ bool TextureLoader::updateTextureFromRGBA8(const std::shared_ptr<Texture2D>& tex
     }
     MTL::Region region = MTL::Region::Make2D(0, 0, static_cast<NS::UInteger>(width), static_cast<NS::UInteger>(height));
     handle->replaceRegion(region, 0, uploadData, static_cast<NS::UInteger>(width * 4));
-    generateMipmaps(handle);
+    const MipmapGenerator::Filter mipFilter = texture->hasNormalLengthInAlpha()
+        ? MipmapGenerator::Filter::NormalMap
+        : SelectMipFilter(texture->isSRGB(), false, uploadData, width, height);
+    texture->setNormalLengthInAlpha(m_Mipmaps->queue(handle, mipFilter) == MipmapGenerator::Filter::NormalMap);
     return true;
 }
 
@@ -1136,10 +1771,8 @@ std::shared_ptr<Texture2D> TextureLoader::loadEXRTexture(const std::string& path
     }
 
     // Cache lookup (EXR textures share same cache)
-    if (auto it = m_Cache.find(path); it != m_Cache.end()) {
-        if (auto cached = it->second.lock()) {
-            return cached;
-        }
+    if (auto cached = findCached(path)) {
+        return cached;
     }
 
     const char* err = nullptr;
@@ -1212,14 +1845,202 @@ std::shared_ptr<Texture2D> TextureLoader::loadEXRTexture(const std::string& path
     tex->setColorSpace(Texture2D::ColorSpace::Linear); // EXR is always linear
     tex->setPath(path);
 
-    m_Cache[path] = tex;
+    cacheTexture(path, tex);
+    return tex;
+}
+
+std::shared_ptr<Texture2D> TextureLoader::loadCookedKTX2Texture(const std::string& ktx2Path,
+                                                                bool srgb,
+                                                                bool normalMap,
+                                                                const std::string& cacheKey) {
+    if (!m_IOQueue) {
+        return loadKTX2Texture(ktx2Path, srgb, normalMap, cacheKey);
+    }
+    const std::string rawPath = GetRawTexturePath(ktx2Path);
+    if (IsCacheValid(ktx2Path, rawPath)) {
+        if (auto tex = loadRawAstcTexture(rawPath, srgb, normalMap, cacheKey)) {
+            return tex;
+        }
+    }
+    return loadKTX2Texture(ktx2Path, srgb, normalMap, cacheKey, rawPath);
+}
+
+std::shared_ptr<TextureHeap> TextureHeap::create(MTL::Device* device, size_t size) {
+    if (!device || size == 0) {
+        return nullptr;
+    }
+    MTL::HeapDescriptor* desc = MTL::HeapDescriptor::alloc()->init();
+    desc->setType(MTL::HeapTypeAutomatic);
+    desc->setStorageMode(MTL::StorageModePrivate);
+    desc->setHazardTrackingMode(MTL::HazardTrackingModeTracked);
+    desc->setSize(size);
+    MTL::Heap* heap = device->newHeap(desc);
+    desc->release();
+    if (!heap) {
+        std::cerr << "[TextureLoader] Failed to create a " << (size >> 20) << " MB texture heap" << std::endl;
+        return nullptr;
+    }
+    return std::shared_ptr<TextureHeap>(new TextureHeap(heap));
+}
+
+TextureHeap::~TextureHeap() {
+    m_Heap->release();
+}
+
+MTL::Texture* TextureHeap::newTexture(MTL::TextureDescriptor* descriptor) const {
+    if (!descriptor || descriptor->storageMode() != MTL::StorageModePrivate) {
+        return nullptr;
+    }
+    const MTL::SizeAndAlign sizeAndAlign = m_Heap->device()->heapTextureSizeAndAlign(descriptor);
+    if (m_Heap->maxAvailableSize(sizeAndAlign.align) < sizeAndAlign.size) {
+        return nullptr;
+    }
+    return m_Heap->newTexture(descriptor);
+}
+
+size_t TextureHeap::getSize() const {
+    return m_Heap->size();
+}
+
+size_t TextureHeap::getUsedSize() const {
+    return m_Heap->usedSize();
+}
+
+void TextureLoader::setPlacementHeap(std::shared_ptr<TextureHeap> heap) {
+    std::lock_guard<std::mutex> lock(m_PlacementHeapMutex);
+    m_PlacementHeap = std::move(heap);
+}
+
+std::shared_ptr<TextureHeap> TextureLoader::currentPlacementHeap() const {
+    if (t_textureStreamThread) {
+        return t_streamPlacementHeap;
+    }
+    std::lock_guard<std::mutex> lock(m_PlacementHeapMutex);
+    return m_PlacementHeap;
+}
+
+size_t TextureLoader::getPlacementSize(const Texture2D& texture) const {
+    MTL::Texture* handle = texture.getHandle();
+    if (!m_Device || !handle || handle->storageMode() != MTL::StorageModePrivate ||
+        handle->textureType() != MTL::TextureType2D) {
+        return 0;
+    }
+    // Mip-streamed textures are measured with their whole chain resident.
+    const bool fullChain = texture.isMipStreamable() && texture.getWidth() > 0 && texture.getHeight() > 0;
+    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+    desc->setTextureType(MTL::TextureType2D);
+    desc->setWidth(fullChain ? texture.getWidth() : handle->width());
+    desc->setHeight(fullChain ? texture.getHeight() : handle->height());
+    desc->setPixelFormat(handle->pixelFormat());
+    desc->setUsage(handle->usage());
+    desc->setStorageMode(MTL::StorageModePrivate);
+    desc->setMipmapLevelCount(fullChain ? texture.getFullMipCount() : handle->mipmapLevelCount());
+    const MTL::SizeAndAlign sizeAndAlign = m_Device->heapTextureSizeAndAlign(desc);
+    desc->release();
+    return static_cast<size_t>((sizeAndAlign.size + sizeAndAlign.align - 1) / sizeAndAlign.align * sizeAndAlign.align);
+}
+
+std::shared_ptr<Texture2D> TextureLoader::loadRawAstcTexture(const std::string& rawPath,
+                                                             bool srgb,
+                                                             bool normalMap,
+                                                             const std::string& cacheKey,
+                                                             uint32_t firstMip) {
+    if (!m_Device || !m_IOQueue) {
+        return nullptr;
+    }
+    RawTextureHeader header;
+    std::vector<RawTextureLevel> levels;
+    if (!ReadRawTextureHeader(rawPath, header, levels)) {
+        return nullptr;
+    }
+    // The 4x4 fallback stays valid so a missing astcenc does not re-transcode on every load.
+    const uint32_t blockSize = ResolveAstcBlockSize(cacheKey, srgb, normalMap, header.width, header.height);
+    const TranscodeTarget wanted = SelectTranscodeTarget(m_SupportsASTC, srgb, blockSize);
+    const TranscodeTarget fallback = SelectTranscodeTarget(m_SupportsASTC, srgb, 4);
+    const MTL::PixelFormat pixelFormat = static_cast<MTL::PixelFormat>(header.pixelFormat);
+    if (pixelFormat != wanted.pixelFormat && pixelFormat != fallback.pixelFormat) {
+        return nullptr;
+    }
+    firstMip = std::min(firstMip, header.levels - 1);
+    const uint32_t residentLevels = header.levels - firstMip;
+
+    NS::Error* error = nullptr;
+    NS::URL* url = NS::URL::fileURLWithPath(NS::String::string(rawPath.c_str(), NS::UTF8StringEncoding));
+    MTL::IOFileHandle* fileHandle = m_Device->newIOFileHandle(url, &error);
+    if (!fileHandle) {
+        std::cerr << "[TextureLoader] Failed to open cooked texture for IO: " << rawPath;
+        if (error) {
+            std::cerr << ": " << error->localizedDescription()->utf8String();
+        }
+        std::cerr << std::endl;
+        return nullptr;
+    }
+
+    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+    desc->setTextureType(MTL::TextureType2D);
+    desc->setWidth(static_cast<NS::UInteger>(levels[firstMip].width));
+    desc->setHeight(static_cast<NS::UInteger>(levels[firstMip].height));
+    desc->setPixelFormat(pixelFormat);
+    desc->setUsage(MTL::TextureUsageShaderRead);
+    desc->setStorageMode(MTL::StorageModePrivate);
+    desc->setMipmapLevelCount(static_cast<NS::UInteger>(residentLevels));
+    std::shared_ptr<TextureHeap> heap = currentPlacementHeap();
+    MTL::Texture* texture = heap ? heap->newTexture(desc) : nullptr;
+    if (!texture) {
+        texture = m_Device->newTexture(desc);
+    }
+    desc->release();
+    if (!texture) {
+        fileHandle->release();
+        return nullptr;
+    }
+
+    // The blocks go from the file straight into the private texture; nothing is staged in memory.
+    MTL::IOCommandBuffer* ioCommands = m_IOQueue->commandBuffer();
+    uint64_t totalBytes = 0;
+    uint64_t fullBytes = 0;
+    for (uint32_t level = 0; level < header.levels; ++level) {
+        const RawTextureLevel& info = levels[level];
+        fullBytes += info.bytesPerImage;
+        if (level < firstMip) {
+            continue;
+        }
+        ioCommands->loadTexture(texture, 0, level - firstMip,
+                                MTL::Size(info.width, info.height, 1),
+                                info.bytesPerRow, info.bytesPerImage,
+                                MTL::Origin(0, 0, 0),
+                                fileHandle, static_cast<NS::UInteger>(info.offset));
+        totalBytes += info.bytesPerImage;
+    }
+    ioCommands->commit();
+    ioCommands->waitUntilCompleted();
+    const bool complete = ioCommands->status() == MTL::IOStatusComplete;
+    fileHandle->release();
+    if (!complete) {
+        std::cerr << "[TextureLoader] IO load failed for cooked texture: " << rawPath << std::endl;
+        texture->release();
+        return nullptr;
+    }
+    LogTextureMemory(std::string("Raw/") + (pixelFormat == wanted.pixelFormat ? wanted.label : fallback.label),
+                     levels[firstMip].width, levels[firstMip].height, residentLevels, totalBytes);
+
+    auto tex = std::make_shared<Texture2D>();
+    tex->setHandle(texture);
+    tex->setDimensions(header.width, header.height);
+    tex->setMipLevelCount(residentLevels);
+    tex->setApproximateBytes(totalBytes);
+    tex->setMipSource(rawPath, header.levels, fullBytes);
+    tex->setResidentMip(firstMip);
+    tex->setColorSpace(srgb ? Texture2D::ColorSpace::SRGB : Texture2D::ColorSpace::Linear);
+    tex->setPath(cacheKey.empty() ? rawPath : cacheKey);
     return tex;
 }
 
 std::shared_ptr<Texture2D> TextureLoader::loadKTX2Texture(const std::string& path,
                                                           bool srgb,
                                                           bool normalMap,
-                                                          const std::string& cacheKey) {
+                                                          const std::string& cacheKey,
+                                                          const std::string& rawSidecarPath) {
     if (!m_Device) {
         return nullptr;
     }
@@ -1255,14 +2076,110 @@ std::shared_ptr<Texture2D> TextureLoader::loadKTX2Texture(const std::string& pat
     uint32_t height = transcoder.get_height();
     uint32_t levels = std::max(1u, transcoder.get_levels());
 
-    basist::transcoder_texture_format fmt = SelectAstcFormat(normalMap);
-    MTL::PixelFormat pixelFormat = SelectAstcPixelFormat(srgb, normalMap);
+    // Larger footprints cost an astcenc run per level, so they are only produced when the result
+    // is kept in the sidecar; everything else transcodes straight to 4x4 or BC7.
+    const bool writeRaw = !rawSidecarPath.empty() && levels <= kRawTextureMaxLevels;
+    const uint32_t blockSize = writeRaw ? ResolveAstcBlockSize(cacheKey, srgb, normalMap, width, height) : 4;
+    TranscodeTarget target = SelectTranscodeTarget(m_SupportsASTC, srgb, blockSize);
+    if (target.needsAstcenc()) {
+        std::error_code ec;
+        const std::filesystem::path astcencPath = ResolveAstcencPath();
+        if (!std::filesystem::exists(astcencPath, ec)) {
+            std::call_once(g_astcencMissingFlag, [&]() {
+                std::cerr << "[TextureLoader] astcenc not found at " << astcencPath
+                          << ", cooked textures stay at ASTC 4x4" << std::endl;
+            });
+            target = SelectTranscodeTarget(m_SupportsASTC, srgb, 4);
+        }
+    }
+
+    // Levels are gathered in the sidecar layout first so a failed astcenc run can fall back to
+    // 4x4 before the texture is created.
+    std::vector<uint8_t> rgba;
+    std::vector<uint8_t> levelData;
+    std::vector<uint8_t> rawData;
+    std::vector<RawTextureLevel> rawLevels;
+    uint64_t totalBytes = 0;
+    auto transcodeLevels = [&](const TranscodeTarget& t) -> bool {
+        rawData.clear();
+        rawLevels.clear();
+        totalBytes = 0;
+        const basist::transcoder_texture_format fmt = t.format;
+        const uint32_t blockWidth = t.needsAstcenc() ? t.blockSize : basist::basis_get_block_width(fmt);
+        const uint32_t blockHeight = t.needsAstcenc() ? t.blockSize : basist::basis_get_block_height(fmt);
+        const uint32_t bytesPerBlock = t.needsAstcenc() ? 16u : basist::basis_get_bytes_per_block_or_pixel(fmt);
+        for (uint32_t level = 0; level < levels; ++level) {
+            basist::ktx2_image_level_info levelInfo{};
+            if (!transcoder.get_image_level_info(levelInfo, level, 0, 0)) {
+                std::cerr << "[TextureLoader] Failed to query KTX2 level info for level " << level << ": " << path << std::endl;
+                return false;
+            }
+
+            uint32_t levelWidth = std::max(1u, levelInfo.m_orig_width);
+            uint32_t levelHeight = std::max(1u, levelInfo.m_orig_height);
+            uint32_t blocksX = ComputeBlocksX(levelWidth, blockWidth);
+            uint32_t blocksY = ComputeBlocksX(levelHeight, blockHeight);
+            uint32_t totalBlocks = std::max(1u, blocksX * blocksY);
+            if (t.needsAstcenc()) {
+                rgba.resize(static_cast<size_t>(levelWidth) * levelHeight * 4);
+                if (!transcoder.transcode_image_level(level, 0, 0,
+                                                      rgba.data(), levelWidth * levelHeight,
+                                                      basist::transcoder_texture_format::cTFRGBA32,
+                                                      0, levelWidth, nullptr, levelHeight)) {
+                    std::cerr << "[TextureLoader] KTX2 decode failed for level " << level << ": " << path << std::endl;
+                    return false;
+                }
+                if (!EncodeAstcLevelWithCLI(rgba, levelWidth, levelHeight, t.blockSize, srgb, levelData)) {
+                    return false;
+                }
+            } else {
+                uint32_t dataSize = basist::basis_compute_transcoded_image_size_in_bytes(fmt, levelWidth, levelHeight);
+                uint32_t expectedSize = totalBlocks * bytesPerBlock;
+                if (dataSize < expectedSize) {
+                    dataSize = expectedSize;
+                }
+                uint32_t bufferBlocks = dataSize / bytesPerBlock;
+                if (bufferBlocks < totalBlocks) {
+                    bufferBlocks = totalBlocks;
+                    dataSize = bufferBlocks * bytesPerBlock;
+                }
+                levelData.resize(dataSize);
+                if (!transcoder.transcode_image_level(level, 0, 0,
+                                                      levelData.data(), bufferBlocks, fmt,
+                                                      0, blocksX)) {
+                    std::cerr << "[TextureLoader] KTX2 transcode failed for level " << level << ": " << path << std::endl;
+                    return false;
+                }
+            }
+
+            RawTextureLevel rawLevel;
+            rawLevel.offset = rawData.size();
+            rawLevel.width = levelWidth;
+            rawLevel.height = levelHeight;
+            rawLevel.bytesPerRow = blocksX * bytesPerBlock;
+            rawLevel.bytesPerImage = rawLevel.bytesPerRow * blocksY;
+            rawLevels.push_back(rawLevel);
+            rawData.insert(rawData.end(), levelData.begin(), levelData.begin() + rawLevel.bytesPerImage);
+            rawData.resize((rawData.size() + kRawTextureDataAlignment - 1) / kRawTextureDataAlignment * kRawTextureDataAlignment);
+            totalBytes += rawLevel.bytesPerImage;
+        }
+        return true;
+    };
+    if (!transcodeLevels(target)) {
+        if (!target.needsAstcenc()) {
+            return nullptr;
+        }
+        target = SelectTranscodeTarget(m_SupportsASTC, srgb, 4);
+        if (!transcodeLevels(target)) {
+            return nullptr;
+        }
+    }
 
     MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
     desc->setTextureType(MTL::TextureType2D);
     desc->setWidth(static_cast<NS::UInteger>(width));
     desc->setHeight(static_cast<NS::UInteger>(height));
-    desc->setPixelFormat(pixelFormat);
+    desc->setPixelFormat(target.pixelFormat);
     desc->setUsage(MTL::TextureUsageShaderRead);
     desc->setStorageMode(MTL::StorageModeShared);
     desc->setMipmapLevelCount(static_cast<NS::UInteger>(levels));
@@ -1273,56 +2190,24 @@ std::shared_ptr<Texture2D> TextureLoader::loadKTX2Texture(const std::string& pat
         std::cerr << "[TextureLoader] Failed to create KTX2 Metal texture: " << path << std::endl;
         return nullptr;
     }
-
-    const uint32_t blockWidth = basist::basis_get_block_width(fmt);
-    const uint32_t blockHeight = basist::basis_get_block_height(fmt);
-    const uint32_t bytesPerBlock = basist::basis_get_bytes_per_block_or_pixel(fmt);
-
-    std::vector<uint8_t> levelData;
-    uint64_t totalBytes = 0;
     for (uint32_t level = 0; level < levels; ++level) {
-        basist::ktx2_image_level_info levelInfo{};
-        if (!transcoder.get_image_level_info(levelInfo, level, 0, 0)) {
-            std::cerr << "[TextureLoader] Failed to query KTX2 level info for level " << level << ": " << path << std::endl;
-            texture->release();
-            return nullptr;
-        }
-
-        uint32_t levelWidth = std::max(1u, levelInfo.m_orig_width);
-        uint32_t levelHeight = std::max(1u, levelInfo.m_orig_height);
-        uint32_t blocksX = ComputeBlocksX(levelWidth, blockWidth);
-        uint32_t blocksY = ComputeBlocksX(levelHeight, blockHeight);
-        uint32_t totalBlocks = std::max(1u, blocksX * blocksY);
-        uint32_t dataSize = basist::basis_compute_transcoded_image_size_in_bytes(fmt, levelWidth, levelHeight);
-        uint32_t expectedSize = totalBlocks * bytesPerBlock;
-        if (dataSize < expectedSize) {
-            dataSize = expectedSize;
-        }
-        uint32_t bufferBlocks = dataSize / bytesPerBlock;
-        if (bufferBlocks < totalBlocks) {
-            bufferBlocks = totalBlocks;
-            dataSize = bufferBlocks * bytesPerBlock;
-        }
-        levelData.resize(dataSize);
-        totalBytes += static_cast<uint64_t>(dataSize);
-
-        if (!transcoder.transcode_image_level(level, 0, 0,
-                                              levelData.data(), bufferBlocks, fmt,
-                                              0, blocksX)) {
-            std::cerr << "[TextureLoader] KTX2 transcode failed for level " << level << ": " << path << std::endl;
-            texture->release();
-            return nullptr;
-        }
-
-        uint32_t bytesPerRow = blocksX * bytesPerBlock;
+        const RawTextureLevel& info = rawLevels[level];
         MTL::Region region = MTL::Region::Make2D(0, 0,
-                                                 static_cast<NS::UInteger>(levelWidth),
-                                                 static_cast<NS::UInteger>(levelHeight));
+                                                 static_cast<NS::UInteger>(info.width),
+                                                 static_cast<NS::UInteger>(info.height));
         texture->replaceRegion(region, static_cast<NS::UInteger>(level),
-                               levelData.data(),
-                               static_cast<NS::UInteger>(bytesPerRow));
+                               rawData.data() + info.offset,
+                               static_cast<NS::UInteger>(info.bytesPerRow));
+    }
+    LogTextureMemory(std::string("KTX2/") + target.label, width, height, levels, totalBytes);
+    bool rawWritten = false;
+    if (writeRaw) {
+        rawWritten = WriteRawTextureFile(rawSidecarPath, static_cast<uint32_t>(target.pixelFormat), width, height,
+                                         std::move(rawLevels), rawData);
+        if (!rawWritten) {
+            std::cerr << "[TextureLoader] Failed to write cooked texture blocks: " << rawSidecarPath << std::endl;
+        }
     }
-    LogTextureMemory("KTX2/ASTC4x4", width, height, levels, totalBytes);
 
     auto tex = std::make_shared<Texture2D>();
     tex->setHandle(texture);
@@ -1331,6 +2216,9 @@ std::shared_ptr<Texture2D> TextureLoader::loadKTX2Texture(const std::string& pat
     tex->setApproximateBytes(totalBytes);
     tex->setColorSpace(srgb ? Texture2D::ColorSpace::SRGB : Texture2D::ColorSpace::Linear);
     tex->setPath(cacheKey.empty() ? path : cacheKey);
+    if (rawWritten) {
+        tex->setMipSource(rawSidecarPath, levels, totalBytes);
+    }
 
     return tex;
 }
@@ -1341,10 +2229,8 @@ std::shared_ptr<Texture2D> TextureLoader::loadHDRTexture(const std::string& path
     }
     
     // Cache lookup (HDR textures share same cache as LDR)
-    if (auto it = m_Cache.find(path); it != m_Cache.end()) {
-        if (auto cached = it->second.lock()) {
-            return cached;
-        }
+    if (auto cached = findCached(path)) {
+        return cached;
     }
     
     int width = 0, height = 0, channels = 0;
@@ -1392,10 +2278,74 @@ std::shared_ptr<Texture2D> TextureLoader::loadHDRTexture(const std::string& path
     tex->setColorSpace(Texture2D::ColorSpace::Linear);
     tex->setPath(path);
     
-    m_Cache[path] = tex;
+    cacheTexture(path, tex);
     return tex;
 }
 
+std::shared_ptr<Texture2D> TextureLoader::decodeEnvironmentTexture(const std::string& path,
+                                                                   bool flipVertical,
+                                                                   uint32_t maxWidth) {
+    if (!m_Device) {
+        return nullptr;
+    }
+    CRESCENT_PROFILE_SCOPE("TextureLoader::decodeEnvironmentTexture");
+
+    std::vector<float> pixels;
+    int width = 0;
+    int height = 0;
+    SetFlipVerticallyOnLoad(false);
+    if (!LoadHDRPixels(path, pixels, width, height) || width <= 0 || height <= 0) {
+        return nullptr;
+    }
+    if (flipVertical && height > 1) {
+        const size_t rowFloats = static_cast<size_t>(width) * 4u;
+        for (int y = 0; y < height / 2; ++y) {
+            std::swap_ranges(pixels.begin() + rowFloats * static_cast<size_t>(y),
+                             pixels.begin() + rowFloats * static_cast<size_t>(y + 1),
+                             pixels.begin() + rowFloats * static_cast<size_t>(height - 1 - y));
+        }
+    }
+    while (maxWidth > 0 && static_cast<uint32_t>(width) > maxWidth && height > 1) {
+        HalveRGBA32F(pixels, width, height);
+    }
+
+    std::vector<uint16_t> uploadData16 = ConvertRGBA32FToRGBA16F(pixels.data(), static_cast<size_t>(width) * static_cast<size_t>(height));
+
+    MTL::TextureDescriptor* desc = MTL::TextureDescriptor::alloc()->init();
+    desc->setTextureType(MTL::TextureType2D);
+    desc->setWidth(static_cast<NS::UInteger>(width));
+    desc->setHeight(static_cast<NS::UInteger>(height));
+    desc->setPixelFormat(MTL::PixelFormatRGBA16Float);
+    desc->setUsage(MTL::TextureUsageShaderRead);
+    desc->setStorageMode(MTL::StorageModeShared);
+    uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+    desc->setMipmapLevelCount(static_cast<NS::UInteger>(mipLevels));
+
+    MTL::Texture* texture = m_Device->newTexture(desc);
+    desc->release();
+    if (!texture) {
+        std::cerr << "[TextureLoader] Failed to create Metal texture for environment: " << path << std::endl;
+        return nullptr;
+    }
+
+    MTL::Region region = MTL::Region::Make2D(0, 0, static_cast<NS::UInteger>(width), static_cast<NS::UInteger>(height));
+    texture->replaceRegion(region, 0, uploadData16.data(), static_cast<NS::UInteger>(width * 4 * sizeof(uint16_t)));
+    generateMipmaps(texture);
+
+    auto tex = std::make_shared<Texture2D>();
+    tex->setHandle(texture);
+    tex->setDimensions(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+    tex->setMipLevelCount(mipLevels);
+    tex->setApproximateBytes(ComputeMipChainBytes(static_cast<uint32_t>(width), static_cast<uint32_t>(height), sizeof(uint16_t) * 4u));
+    tex->setColorSpace(Texture2D::ColorSpace::Linear);
+    tex->setPath(path);
+    return tex;
+}
+
+size_t TextureLoader::flushPendingMipmaps() {
+    return m_Mipmaps->flush();
+}
+
 void TextureLoader::generateMipmaps(MTL::Texture* texture) {
     if (!texture || texture->mipmapLevelCount() <= 1 || !m_CommandQueue) {
         return;
@@ -1476,7 +2426,7 @@ bool CookStaticLightmapToKTX2(const std::string& sourcePath, const std::string&
     std::vector<float> pixels;
     int width = 0;
     int height = 0;
-    if (!LoadHDRPixelsForCooking(sourcePath, pixels, width, height) || width <= 0 || height <= 0) {
+    if (!LoadHDRPixels(sourcePath, pixels, width, height) || width <= 0 || height <= 0) {
         return false;
     }
 
@@ -1516,6 +2466,41 @@ bool CookStaticLightmapToKTX2(const std::string& sourcePath, const std::string&
     return encoded;
 }
 
+bool CookDataTextureToKTX2(const unsigned char* rgba, int width, int height, const std::string& outputPath) {
+    if (!rgba || width <= 0 || height <= 0 || outputPath.empty()) {
+        return false;
+    }
+
+    std::filesystem::path cookedPath(outputPath);
+    std::error_code ec;
+    std::filesystem::create_directories(cookedPath.parent_path(), ec);
+
+    std::filesystem::path tempPngPath = std::filesystem::temp_directory_path(ec);
+    if (ec) {
+        tempPngPath = cookedPath.parent_path();
+        ec.clear();
+    }
+    tempPngPath /= "crescent_data_" + HashPathStable(cookedPath.lexically_normal().string()) + ".png";
+
+    if (!WriteRGBA8PNG(tempPngPath.string(), rgba, width, height)) {
+        std::cerr << "[TextureLoader] Failed to write temporary data texture: " << tempPngPath << std::endl;
+        return false;
+    }
+
+    bool encoded = EncodeKtx2WithBasisuCLI(
+        tempPngPath.string(),
+        cookedPath.lexically_normal().string(),
+        false,
+        false,
+        true,
+        false,
+        false
+    );
+
+    std::filesystem::remove(tempPngPath, ec);
+    return encoded;
+}
+
 } // namespace Crescent
 
 // Include BasisU transcoder implementation directly to avoid build system changes.
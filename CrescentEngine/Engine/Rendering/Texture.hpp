@@ -1,18 +1,29 @@
 #pragma once
 
+#include "../Core/MemoryTracker.hpp"
+#include "../Core/ResidencyCache.hpp"
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 // Forward declare Metal types to avoid pulling metal-cpp into headers
 namespace MTL {
     class Texture;
+    class TextureDescriptor;
     class Device;
+    class Heap;
     class CommandQueue;
+    class IOCommandQueue;
 }
 
 namespace Crescent {
 
+class MipmapGenerator;
+
 struct TextureLiveStats {
     size_t liveTextureCount = 0;
     uint64_t approximateBytes = 0;
@@ -46,7 +57,37 @@ public:
     uint32_t getMipLevelCount() const { return m_MipLevelCount; }
     void setMipLevelCount(uint32_t mipLevelCount) { m_MipLevelCount = mipLevelCount; updateDebugRegistry(); }
     uint64_t getApproximateBytes() const { return m_ApproximateBytes; }
-    void setApproximateBytes(uint64_t approximateBytes) { m_ApproximateBytes = approximateBytes; updateDebugRegistry(); }
+    void setApproximateBytes(uint64_t approximateBytes) {
+        m_ApproximateBytes = approximateBytes;
+        m_Memory.reset(MemoryCategory::Textures, approximateBytes);
+        updateDebugRegistry();
+    }
+    // True while the handle is a placeholder and the texture loads in the background.
+    bool isStreaming() const { return m_Streaming; }
+    void setStreaming(bool streaming) { m_Streaming = streaming; }
+
+    // Mip streaming (TextureStreamer). Only textures backed by a cooked ASTC sidecar can drop
+    // their finest levels; the handle then holds levels residentMip.. of the full chain while the
+    // dimensions above stay those of level 0.
+    bool isMipStreamable() const { return !m_MipSource.empty(); }
+    const std::string& getMipSource() const { return m_MipSource; }
+    uint32_t getFullMipCount() const { return m_FullMipCount; }
+    uint64_t getFullBytes() const { return m_FullBytes; }
+    void setMipSource(const std::string& rawPath, uint32_t fullMipCount, uint64_t fullBytes) {
+        m_MipSource = rawPath;
+        m_FullMipCount = fullMipCount;
+        m_FullBytes = fullBytes;
+    }
+    uint32_t getResidentMip() const { return m_ResidentMip; }
+    void setResidentMip(uint32_t mip) { m_ResidentMip = mip; }
+    // First level of an in-flight mip load, or kNoPendingMip.
+    static constexpr uint32_t kNoPendingMip = ~0u;
+    uint32_t getPendingMip() const { return m_PendingMip; }
+    void setPendingMip(uint32_t mip) { m_PendingMip = mip; }
+    // Normal maps whose mips came from MipmapGenerator's normal filter keep the averaged normal
+    // length in alpha below level 0.
+    bool hasNormalLengthInAlpha() const { return m_NormalLengthInAlpha; }
+    void setNormalLengthInAlpha(bool value) { m_NormalLengthInAlpha = value; }
 
     static TextureLiveStats getLiveStats();
     static void logLiveStats(const std::string& reason, size_t maxEntries = 8);
@@ -59,17 +100,81 @@ private:
     uint32_t m_Height;
     uint32_t m_MipLevelCount;
     uint64_t m_ApproximateBytes;
+    TrackedMemory m_Memory;
     ColorSpace m_ColorSpace;
     std::string m_Path;
+    bool m_Streaming;
+    std::string m_MipSource;
+    uint32_t m_FullMipCount;
+    uint64_t m_FullBytes;
+    uint32_t m_ResidentMip;
+    uint32_t m_PendingMip;
+    bool m_NormalLengthInAlpha;
+};
+
+// One heap a cooked level's textures are placed in, sized from the footprint the cook recorded
+// (SceneSerializer's gpuFootprint). The level's textures then cost one device allocation instead
+// of one each, and its memory goes back as one block once the last of them is released; every
+// placed texture retains the heap. Metal sub-allocates within it (automatic placement) and hazard
+// tracks it as a whole, like any texture of its own.
+class TextureHeap {
+public:
+    // Null when the device cannot make a heap of that size.
+    static std::shared_ptr<TextureHeap> create(MTL::Device* device, size_t size);
+    ~TextureHeap();
+    TextureHeap(const TextureHeap&) = delete;
+    TextureHeap& operator=(const TextureHeap&) = delete;
+
+    // A private texture in the heap, or null once it has no room left for it; the caller then
+    // allocates from the device. Safe on any thread.
+    MTL::Texture* newTexture(MTL::TextureDescriptor* descriptor) const;
+    size_t getSize() const;
+    size_t getUsedSize() const;
+
+private:
+    explicit TextureHeap(MTL::Heap* heap) : m_Heap(heap) {}
+
+    MTL::Heap* m_Heap;
 };
 
 // Loader/cache for textures using stb_image + Metal
 class TextureLoader {
 public:
+    // loaded is false when the load failed and the texture keeps its placeholder.
+    using LoadedCallback = std::function<void(const std::shared_ptr<Texture2D>& texture, bool loaded)>;
+
     TextureLoader(MTL::Device* device, MTL::CommandQueue* commandQueue = nullptr);
     ~TextureLoader();
     
     std::shared_ptr<Texture2D> loadTexture(const std::string& path, bool srgb = true, bool flipVertical = true, bool normalMap = false);
+    // Returns at once with a streaming texture that shares loadTexture's cache entry and shows a
+    // placeholder (white, or a flat normal for normal maps) until a streaming thread has decoded,
+    // transcoded or encoded the file; processStreamedTextures then swaps the real handle in and
+    // runs onLoaded. HDR and EXR sources load synchronously.
+    std::shared_ptr<Texture2D> loadTextureAsync(const std::string& path,
+                                                bool srgb = true,
+                                                bool flipVertical = true,
+                                                bool normalMap = false,
+                                                LoadedCallback onLoaded = {});
+    // Swaps finished streamed loads into their textures and runs their callbacks. Call once per
+    // frame on the thread that encodes rendering, so no encoder sees a handle change mid-frame.
+    size_t processStreamedTextures();
+    size_t getStreamingCount() const { return m_StreamingCount.load(std::memory_order_relaxed); }
+    // Reloads a mip-streamable texture with levels firstMip.. from its sidecar on a streaming
+    // thread; processStreamedTextures swaps the smaller or larger handle in. Returns false when
+    // the texture cannot stream mips or already has a load in flight.
+    bool requestResidentMip(const std::shared_ptr<Texture2D>& texture, uint32_t firstMip);
+    // RGBA8 loads queue their mip generation; this commits the queued batch as one command
+    // buffer on the loader's queue without waiting. processStreamedTextures flushes every frame,
+    // so only work that samples fresh textures outside the frame loop needs to call it.
+    size_t flushPendingMipmaps();
+    // Decodes an HDR or EXR environment into a linear RGBA16F texture with mips, halved until it
+    // is at most maxWidth wide (0 keeps the source size). Bypasses the cache and is safe on any
+    // thread marked with markLoadingThread.
+    std::shared_ptr<Texture2D> decodeEnvironmentTexture(const std::string& path, bool flipVertical, uint32_t maxWidth);
+    // stb keeps its vertical flip flag in a global; a marked thread keeps its own, so its loads
+    // cannot race another thread's. Streaming workers mark themselves.
+    static void markLoadingThread();
     std::shared_ptr<Texture2D> loadEmbeddedCookedTexture(const std::string& cacheKey, bool srgb = true, bool normalMap = false);
     std::shared_ptr<Texture2D> loadTextureUncompressed(const std::string& path, bool srgb = true, bool flipVertical = true);
     std::shared_ptr<Texture2D> loadTextureFromMemory(const unsigned char* data, size_t size, bool srgb, bool flipVertical, const std::string& cacheKey, bool normalMap = false);
@@ -80,22 +185,84 @@ public:
                                 int height,
                                 bool flipVertical = false);
     void invalidateTexture(const std::string& path);
+
+    // Textures the loader hands out stay resident after their last user drops them, until
+    // more than the budget's worth of released ones is held; the least recently used go first, so
+    // leaving play mode or switching back to a level finds its textures still uploaded.
+    static constexpr uint64_t kDefaultResidencyBudget = 256ull << 20;
+    void setResidencyBudget(uint64_t bytes) { m_Residency.setBudget(bytes); }
+    uint64_t getResidencyBudget() const { return m_Residency.getBudget(); }
+    uint64_t getReleasedResidentBytes() const { return m_Residency.getReleasedBytes(); }
+    // Frees every released texture now; the renderer calls it when textures or the device go
+    // over their memory budget.
+    uint64_t purgeResidency() { return m_Residency.purge(); }
+
+    // Cooked ASTC textures loaded from now on, streamed ones included, are placed in heap while it
+    // has room; null goes back to device allocations. A cooked level sets its own as it loads.
+    void setPlacementHeap(std::shared_ptr<TextureHeap> heap);
+    // Bytes the texture takes placed in a heap, 0 for textures that are not placed (anything but
+    // private storage), for a cook to record its level's footprint.
+    size_t getPlacementSize(const Texture2D& texture) const;
     
     // Utility textures for defaults/fallbacks
     std::shared_ptr<Texture2D> createSolidTexture(float r, float g, float b, float a = 1.0f, bool srgb = true);
     std::shared_ptr<Texture2D> createFlatNormalTexture();
     
 private:
+    struct StreamQueue;
+
+    // loadTexture without the cache, safe to call from a streaming thread. HDR and EXR sources
+    // are not handled.
+    std::shared_ptr<Texture2D> loadTextureUncached(const std::string& path, bool srgb, bool flipVertical, bool normalMap);
+    std::shared_ptr<Texture2D> createUncompressedTexture(const std::string& path, bool srgb, bool flipVertical, bool normalMap = false);
     std::shared_ptr<Texture2D> loadHDRTexture(const std::string& path, bool flipVertical);
     std::shared_ptr<Texture2D> loadEXRTexture(const std::string& path, bool flipVertical);
-    std::shared_ptr<Texture2D> loadKTX2Texture(const std::string& path, bool srgb, bool normalMap, const std::string& cacheKey);
+    // Writes the transcoded levels to rawSidecarPath when it is not empty. Only then are larger
+    // ASTC footprints than 4x4 encoded, since they take an astcenc run per level.
+    std::shared_ptr<Texture2D> loadKTX2Texture(const std::string& path,
+                                               bool srgb,
+                                               bool normalMap,
+                                               const std::string& cacheKey,
+                                               const std::string& rawSidecarPath = std::string());
+    // A KTX2 from the texture cache. Its first load also writes the transcoded ASTC next to it,
+    // which later loads stream straight from the file into a private texture on the IO queue.
+    std::shared_ptr<Texture2D> loadCookedKTX2Texture(const std::string& ktx2Path, bool srgb, bool normalMap, const std::string& cacheKey);
+    // Loads levels firstMip.. into a texture sized for firstMip. Sidecars in another format than
+    // this device and the texture's block size call for are rejected.
+    std::shared_ptr<Texture2D> loadRawAstcTexture(const std::string& rawPath,
+                                                  bool srgb,
+                                                  bool normalMap,
+                                                  const std::string& cacheKey,
+                                                  uint32_t firstMip = 0);
+    // The request's heap on a streaming thread, the loader's otherwise.
+    std::shared_ptr<TextureHeap> currentPlacementHeap() const;
+    // Cache lookups and inserts; both mark the texture most recently used in m_Residency.
+    std::shared_ptr<Texture2D> findCached(const std::string& cacheKey);
+    void cacheTexture(const std::string& cacheKey, const std::shared_ptr<Texture2D>& texture);
+    // Blits the chain and waits; HDR sources are read by IBL generation right after loading.
     void generateMipmaps(MTL::Texture* texture);
+    void startStreamWorkers();
+    void stopStreamWorkers();
+    void streamWorkerLoop();
     
     MTL::Device* m_Device;
     MTL::CommandQueue* m_CommandQueue;
+    MTL::IOCommandQueue* m_IOQueue;
     std::unordered_map<std::string, std::weak_ptr<Texture2D>> m_Cache;
+    ResidencyCache<Texture2D> m_Residency; // strong references to recently used m_Cache entries
+    std::unique_ptr<StreamQueue> m_Stream;
+    std::unique_ptr<MipmapGenerator> m_Mipmaps;
+    std::shared_ptr<Texture2D> m_PlaceholderWhite;
+    std::shared_ptr<Texture2D> m_PlaceholderNormal;
+    std::shared_ptr<TextureHeap> m_PlacementHeap;
+    mutable std::mutex m_PlacementHeapMutex;
+    std::atomic<size_t> m_StreamingCount;
+    bool m_SupportsASTC; // cooked textures transcode to BC7 otherwise
 };
 
 bool CookStaticLightmapToKTX2(const std::string& sourcePath, const std::string& outputPath);
+// Cooks linear RGBA8 data that shaders read texel by texel (vertex animation textures): UASTC,
+// no mips, no flip.
+bool CookDataTextureToKTX2(const unsigned char* rgba, int width, int height, const std::string& outputPath);
 
 } // namespace Crescent
@@ -0,0 +1,160 @@
+#include "AIUpdateScheduler.hpp"
+#include "Scene.hpp"
+#include "../Components/Camera.hpp"
+#include "../Components/ThirdPersonController.hpp"
+#include "../Core/Time.hpp"
+#include "../ECS/Entity.hpp"
+#include "../ECS/Transform.hpp"
+#include <algorithm>
+
+namespace Crescent {
+
+namespace {
+    constexpr float kPlayerRescanSeconds = 0.35f;
+}
+
+AIUpdateScheduler& AIUpdateScheduler::getInstance() {
+    static AIUpdateScheduler instance;
+    return instance;
+}
+
+AIUpdateScheduler::AgentId AIUpdateScheduler::registerAgent() {
+    AgentId id = kInvalidAgent;
+    if (!m_FreeIds.empty()) {
+        id = m_FreeIds.back();
+        m_FreeIds.pop_back();
+    } else {
+        m_Agents.emplace_back();
+        id = static_cast<AgentId>(m_Agents.size());
+    }
+    Agent& agent = m_Agents[id - 1];
+    agent.alive = true;
+    // Staggered start: successive agents become due on successive frames.
+    agent.framesSinceTick = m_NextPhase++ % std::max(1u, m_Settings.maxInterval);
+    ++m_AgentCount;
+    return id;
+}
+
+void AIUpdateScheduler::unregisterAgent(AgentId id) {
+    if (id == kInvalidAgent || id > m_Agents.size() || !m_Agents[id - 1].alive) {
+        return;
+    }
+    m_Agents[id - 1] = Agent{};
+    m_FreeIds.push_back(id);
+    --m_AgentCount;
+}
+
+void AIUpdateScheduler::setSettings(const Settings& settings) {
+    m_Settings = settings;
+    m_Settings.budgetMs = std::max(0.0f, m_Settings.budgetMs);
+    m_Settings.fullRateDistance = std::max(0.0f, m_Settings.fullRateDistance);
+    m_Settings.maxInterval = std::max(1u, m_Settings.maxInterval);
+}
+
+void AIUpdateScheduler::refreshFrame(Scene* scene) {
+    const uint64_t frame = Time::frameCount();
+    if (frame == m_Frame && scene == m_Scene) {
+        return;
+    }
+    if (frame != m_Frame) {
+        m_LastFrameStats = m_FrameStats;
+        m_FrameStats = FrameStats{};
+        m_FrameStats.agents = m_AgentCount;
+        m_SpentMs = 0.0;
+    }
+    if (scene != m_Scene) {
+        m_Player = nullptr;
+        m_PlayerId = UUID::Invalid();
+        m_PlayerRescanTime = 0.0f;
+    }
+    m_Frame = frame;
+    m_Scene = scene;
+
+    m_Player = scene && m_PlayerId.isValid() ? scene->findEntity(m_PlayerId) : nullptr;
+    if (m_Player && !m_Player->isActiveInHierarchy()) {
+        m_Player = nullptr;
+    }
+    const float now = Time::unscaledTime();
+    if (!m_Player && scene && now >= m_PlayerRescanTime) {
+        m_PlayerRescanTime = now + kPlayerRescanSeconds;
+        for (const auto& handle : scene->getAllEntities()) {
+            Entity* entity = handle.get();
+            if (entity && entity->isActiveInHierarchy() && entity->getComponent<ThirdPersonController>()) {
+                m_Player = entity;
+                break;
+            }
+        }
+    }
+    m_PlayerId = m_Player ? m_Player->getUUID() : UUID::Invalid();
+
+    // Distance is measured from the player, or from the camera when there is none.
+    Camera* camera = Camera::getMainCamera();
+    Transform* cameraTransform = camera && camera->getEntity() ? camera->getEntity()->getTransform() : nullptr;
+    Transform* viewer = m_Player ? m_Player->getTransform() : cameraTransform;
+    m_HasViewer = viewer != nullptr;
+    m_ViewerPosition = viewer ? viewer->getPosition() : Math::Vector3::Zero;
+    m_HasFrustum = cameraTransform != nullptr;
+    if (m_HasFrustum) {
+        m_Frustum = Math::ExtractFrustumPlanes(camera->getViewProjectionMatrix());
+    }
+}
+
+uint32_t AIUpdateScheduler::intervalFor(const Math::Vector3& position, float radius, bool engaged) const {
+    if (engaged || !m_HasViewer) {
+        return 1;
+    }
+    const float fullRate = std::max(m_Settings.fullRateDistance, 1.0f);
+    float distance = position.distance(m_ViewerPosition);
+    uint32_t interval = 1;
+    while (distance > fullRate && interval < m_Settings.maxInterval) {
+        interval *= 2;
+        distance *= 0.5f;
+    }
+    if (interval > 1 && m_HasFrustum && !Math::IsSphereInFrustum(m_Frustum, position, radius)) {
+        interval *= 2;
+    }
+    return std::min(interval, m_Settings.maxInterval);
+}
+
+bool AIUpdateScheduler::beginTick(AgentId id, Scene* scene, const Math::Vector3& position, float radius, bool engaged) {
+    refreshFrame(scene);
+    if (id == kInvalidAgent || id > m_Agents.size() || !m_Agents[id - 1].alive) {
+        ++m_FrameStats.ticked;
+        m_TickStart = std::chrono::steady_clock::now();
+        return true;
+    }
+    Agent& agent = m_Agents[id - 1];
+    const uint32_t interval = intervalFor(position, radius, engaged);
+    const uint32_t waited = agent.framesSinceTick + 1;
+    const bool due = waited >= interval;
+    const bool forced = interval == 1 || waited >= interval * 2;
+    if (!due || (!forced && m_SpentMs >= m_Settings.budgetMs)) {
+        agent.framesSinceTick = waited;
+        if (due) {
+            ++m_FrameStats.deferred;
+        }
+        return false;
+    }
+    agent.framesSinceTick = 0;
+    ++m_FrameStats.ticked;
+    m_TickStart = std::chrono::steady_clock::now();
+    return true;
+}
+
+void AIUpdateScheduler::endTick(AgentId) {
+    const double ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_TickStart).count();
+    m_SpentMs += ms;
+    m_FrameStats.thinkMs = static_cast<float>(m_SpentMs);
+}
+
+Entity* AIUpdateScheduler::findPlayer(Scene* scene) {
+    refreshFrame(scene);
+    // Destroyed since the frame started.
+    if (m_Player && scene && scene->findEntity(m_PlayerId) != m_Player) {
+        m_Player = nullptr;
+    }
+    return m_Player;
+}
+
+} // namespace Crescent
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../Core/UUID.hpp"
+#include "../Math/Frustum.hpp"
+#include "../Math/Math.hpp"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Crescent {
+
+class Entity;
+class Scene;
+
+// Spreads AI thinking over frames so a crowd of agents costs a bounded slice of each one.
+// Agents ask beginTick from their update. An engaged agent (chasing, attacking, reacting) or one
+// within fullRateDistance of the player thinks every frame. Further out the interval doubles per
+// doubling of the distance, up to maxInterval, and doubles once more while the agent is outside
+// the main camera's frustum. Agents start at staggered phases so equal intervals do not land on
+// the same frame. Beyond the engaged ones, agents that are due stop being granted once the frame
+// has spent budgetMs thinking; a deferred agent is due again the next frame and forced after it
+// has waited twice its interval, so the order of the update list cannot starve one. A skipped
+// agent keeps the frames it missed and spends them as one longer step on its next tick.
+//
+// The player is also found here once per frame for every agent, instead of each agent scanning
+// the scene for it.
+class AIUpdateScheduler {
+public:
+    using AgentId = uint32_t;
+    static constexpr AgentId kInvalidAgent = 0;
+
+    struct Settings {
+        float budgetMs = 1.0f;
+        float fullRateDistance = 20.0f;
+        uint32_t maxInterval = 8;
+    };
+
+    struct FrameStats {
+        uint32_t agents = 0;
+        uint32_t ticked = 0;
+        uint32_t deferred = 0;
+        float thinkMs = 0.0f;
+    };
+
+    static AIUpdateScheduler& getInstance();
+
+    AgentId registerAgent();
+    void unregisterAgent(AgentId id);
+
+    // True when the agent should think this frame; then endTick must follow its update.
+    bool beginTick(AgentId id, Scene* scene, const Math::Vector3& position, float radius, bool engaged);
+    void endTick(AgentId id);
+
+    // Active entity with a ThirdPersonController in the scene, looked up by UUID and rescanned at
+    // most every 0.35s while there is none.
+    Entity* findPlayer(Scene* scene);
+
+    const Settings& getSettings() const { return m_Settings; }
+    void setSettings(const Settings& settings);
+    const FrameStats& getLastFrameStats() const { return m_LastFrameStats; }
+
+private:
+    struct Agent {
+        bool alive = false;
+        uint32_t framesSinceTick = 0;
+    };
+
+    void refreshFrame(Scene* scene);
+    uint32_t intervalFor(const Math::Vector3& position, float radius, bool engaged) const;
+
+    Settings m_Settings;
+    std::vector<Agent> m_Agents;
+    std::vector<AgentId> m_FreeIds;
+    uint32_t m_AgentCount = 0;
+    uint32_t m_NextPhase = 0;
+
+    uint64_t m_Frame = ~uint64_t(0);
+    Scene* m_Scene = nullptr;
+    Entity* m_Player = nullptr;
+    UUID m_PlayerId = UUID::Invalid();
+    float m_PlayerRescanTime = 0.0f;
+    bool m_HasViewer = false;
+    Math::Vector3 m_ViewerPosition = Math::Vector3::Zero;
+    bool m_HasFrustum = false;
+    Math::FrustumPlanes m_Frustum{};
+
+    double m_SpentMs = 0.0;
+    std::chrono::steady_clock::time_point m_TickStart;
+    FrameStats m_FrameStats;
+    FrameStats m_LastFrameStats;
+};
+
+} // namespace Crescent
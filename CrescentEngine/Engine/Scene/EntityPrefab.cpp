@@ -0,0 +1,50 @@
+#include "EntityPrefab.hpp"
+#include "../ECS/Entity.hpp"
+#include "../ECS/Transform.hpp"
+#include <iostream>
+
+namespace Crescent {
+
+std::shared_ptr<EntityPrefab> EntityPrefab::Capture(const Entity& root) {
+    auto prefab = std::make_shared<EntityPrefab>();
+    std::vector<const Entity*> sources{&root};
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const Entity* source = sources[i];
+        const Transform* transform = source->getTransform();
+
+        Node node;
+        node.name = source->getName();
+        node.tag = source->getTag();
+        node.layer = source->getLayer();
+        node.active = source->isActiveSelf();
+        node.localPosition = transform->getLocalPosition();
+        node.localRotation = transform->getLocalRotation();
+        node.localScale = transform->getLocalScale();
+        if (i > 0) {
+            const Entity* parent = transform->getParent()->getEntity();
+            node.parent = static_cast<int>(std::find(sources.begin(), sources.begin() + i, parent) - sources.begin());
+        }
+        for (const auto& component : source->getAllComponents()) {
+            if (component.get() == transform) {
+                continue;
+            }
+            std::unique_ptr<Component> copy = component->clone();
+            if (!copy) {
+                std::cerr << "EntityPrefab: " << component->getTypeName() << " on " << source->getName()
+                          << " cannot be cloned\n";
+                return nullptr;
+            }
+            node.components.push_back(std::move(copy));
+        }
+        prefab->m_Nodes.push_back(std::move(node));
+
+        for (const Transform* child : transform->getChildren()) {
+            if (child && child->getEntity()) {
+                sources.push_back(child->getEntity());
+            }
+        }
+    }
+    return prefab;
+}
+
+} // namespace Crescent
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../ECS/Component.hpp"
+#include "../Math/Math.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Crescent {
+
+class Entity;
+
+// A spawnable template captured from an entity and its children. Components are held as clones
+// (see Component::clone), so assets are already resolved and instancing copies settings and shared
+// pointers instead of loading or parsing anything. Instances come from Scene::instantiate, which
+// also pools released instances for reuse.
+class EntityPrefab {
+public:
+    // Null if some component of the hierarchy cannot be cloned.
+    static std::shared_ptr<EntityPrefab> Capture(const Entity& root);
+
+    const std::string& getName() const { return m_Nodes.front().name; }
+    size_t getNodeCount() const { return m_Nodes.size(); }
+
+private:
+    friend class Scene;
+
+    // Parents before children; the root is node 0.
+    struct Node {
+        std::string name;
+        std::string tag;
+        int layer = 0;
+        bool active = true;
+        int parent = -1;
+        Math::Vector3 localPosition = Math::Vector3::Zero;
+        Math::Quaternion localRotation = Math::Quaternion::Identity;
+        Math::Vector3 localScale = Math::Vector3::One;
+        std::vector<std::unique_ptr<Component>> components;
+    };
+
+    std::vector<Node> m_Nodes;
+};
+
+} // namespace Crescent
@@ -0,0 +1,155 @@
+#include "HLODSwitch.hpp"
+#include "RenderWorld.hpp"
+#include "Scene.hpp"
+#include "../ECS/Entity.hpp"
+#include "../Components/HLODProxy.hpp"
+#include "../Components/MeshRenderer.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Crescent {
+
+namespace {
+    constexpr float kMinCellSize = 8.0f;
+    constexpr float kMaxCellSize = 1024.0f;
+    // A proxy covering more cells than this per axis goes to the list tested on every update.
+    constexpr int32_t kMaxCellSpan = 16;
+
+    int32_t CellCoord(float value, float cellSize) {
+        return static_cast<int32_t>(std::floor(value / cellSize));
+    }
+}
+
+void HLODSwitch::update(const Scene& scene, const RenderWorld& world, uint64_t stateVersion,
+                        const Math::Vector3& cameraPosition) {
+    if (!m_Built || m_Scene != &scene || m_WorldVersion != world.getVersion() || m_StateVersion != stateVersion) {
+        m_Scene = &scene;
+        m_WorldVersion = world.getVersion();
+        m_StateVersion = stateVersion;
+        rebuild(scene, world);
+    }
+    if (m_Proxies.empty()) {
+        return;
+    }
+
+    m_Scratch.clear();
+    auto collect = [&](const std::vector<uint32_t>& candidates) {
+        for (uint32_t index : candidates) {
+            const Proxy& proxy = m_Proxies[index];
+            if ((proxy.center - cameraPosition).lengthSquared() < proxy.activationDistance * proxy.activationDistance) {
+                m_Scratch.push_back(index);
+            }
+        }
+    };
+    auto cell = m_Cells.find(cellKey(CellCoord(cameraPosition.x, m_CellSize), CellCoord(cameraPosition.z, m_CellSize)));
+    if (cell != m_Cells.end()) {
+        collect(cell->second);
+    }
+    collect(m_Wide);
+    std::sort(m_Scratch.begin(), m_Scratch.end());
+
+    // Proxies the camera entered switch back to their sources, the ones it left take over.
+    size_t oldIndex = 0;
+    size_t newIndex = 0;
+    while (oldIndex < m_Inside.size() || newIndex < m_Scratch.size()) {
+        if (newIndex == m_Scratch.size() || (oldIndex < m_Inside.size() && m_Inside[oldIndex] < m_Scratch[newIndex])) {
+            setActive(m_Proxies[m_Inside[oldIndex++]], true);
+        } else if (oldIndex == m_Inside.size() || m_Scratch[newIndex] < m_Inside[oldIndex]) {
+            setActive(m_Proxies[m_Scratch[newIndex++]], false);
+        } else {
+            ++oldIndex;
+            ++newIndex;
+        }
+    }
+    m_Inside.swap(m_Scratch);
+}
+
+void HLODSwitch::rebuild(const Scene& scene, const RenderWorld& world) {
+    m_Built = true;
+    m_Proxies.clear();
+    m_Cells.clear();
+    m_Wide.clear();
+    m_Inside.clear();
+    const uint32_t indexCount = scene.getEntityIndexCount();
+    m_HiddenRefs.assign(indexCount, 0);
+    m_ActiveProxies.assign(indexCount, 0);
+    m_HiddenCount = 0;
+
+    for (const HLODRenderProxy& hlodProxy : world.getHLODProxies()) {
+        Entity* entity = hlodProxy.entity;
+        HLODProxy* component = hlodProxy.proxy;
+        MeshRenderer* meshRenderer = hlodProxy.meshRenderer;
+        if (!entity->isActiveInHierarchy() || !component->isEnabled()
+            || !meshRenderer || !meshRenderer->isEnabled() || !meshRenderer->getMesh()) {
+            continue;
+        }
+        Proxy proxy;
+        proxy.entityIndex = entity->getIndex();
+        proxy.center = meshRenderer->getBoundsCenter();
+        proxy.activationDistance = std::max(component->getActivationDistance(), 0.0f);
+        proxy.sources.reserve(component->getSourceUuids().size());
+        for (UUID uuid : component->getSourceUuids()) {
+            if (const Entity* source = scene.findEntity(uuid)) {
+                proxy.sources.push_back(source->getIndex());
+            }
+        }
+        m_Proxies.push_back(std::move(proxy));
+    }
+    if (m_Proxies.empty()) {
+        return;
+    }
+
+    // Cells about the size of a typical activation radius keep each proxy in a few of them.
+    std::vector<float> distances;
+    distances.reserve(m_Proxies.size());
+    for (const Proxy& proxy : m_Proxies) {
+        distances.push_back(proxy.activationDistance);
+    }
+    std::nth_element(distances.begin(), distances.begin() + distances.size() / 2, distances.end());
+    m_CellSize = std::clamp(distances[distances.size() / 2], kMinCellSize, kMaxCellSize);
+
+    for (uint32_t index = 0; index < m_Proxies.size(); ++index) {
+        const Proxy& proxy = m_Proxies[index];
+        const float radius = proxy.activationDistance;
+        const int32_t minX = CellCoord(proxy.center.x - radius, m_CellSize);
+        const int32_t maxX = CellCoord(proxy.center.x + radius, m_CellSize);
+        const int32_t minZ = CellCoord(proxy.center.z - radius, m_CellSize);
+        const int32_t maxZ = CellCoord(proxy.center.z + radius, m_CellSize);
+        if (maxX - minX >= kMaxCellSpan || maxZ - minZ >= kMaxCellSpan) {
+            m_Wide.push_back(index);
+            continue;
+        }
+        for (int32_t x = minX; x <= maxX; ++x) {
+            for (int32_t z = minZ; z <= maxZ; ++z) {
+                m_Cells[cellKey(x, z)].push_back(index);
+            }
+        }
+    }
+
+    // Everything starts active, as seen from infinitely far away; update then switches the
+    // proxies around the camera back off.
+    for (const Proxy& proxy : m_Proxies) {
+        setActive(proxy, true);
+    }
+}
+
+void HLODSwitch::setActive(const Proxy& proxy, bool active) {
+    if (proxy.entityIndex < m_ActiveProxies.size()) {
+        m_ActiveProxies[proxy.entityIndex] = active ? 1 : 0;
+    }
+    for (uint32_t source : proxy.sources) {
+        if (source >= m_HiddenRefs.size()) {
+            continue;
+        }
+        uint16_t& refs = m_HiddenRefs[source];
+        if (active) {
+            if (refs++ == 0) {
+                ++m_HiddenCount;
+            }
+        } else if (refs > 0 && --refs == 0) {
+            --m_HiddenCount;
+        }
+    }
+}
+
+} // namespace Crescent
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../Math/Math.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Crescent {
+
+class Scene;
+class RenderWorld;
+
+// Which HLOD proxies replace their sources for a camera. A proxy is active while the camera is at
+// least HLODProxy::getActivationDistance from its mesh bounds centre, and every source of an
+// active proxy is hidden. Rather than measuring each proxy every frame, the activation spheres are
+// binned into a grid on the XZ plane: an update looks up the cell under the camera for the proxies
+// it is inside and flips only those entering or leaving that set, so a frame costs the proxies
+// near the camera. Proxies, their resolved sources and the grid are rebuilt when the render world
+// changes or the scene's HLOD state version moves (entity activation, component enable and proxy
+// edits, see Scene::markHLODDirty); proxies are expected not to move in between.
+class HLODSwitch {
+public:
+    void update(const Scene& scene, const RenderWorld& world, uint64_t stateVersion,
+                const Math::Vector3& cameraPosition);
+
+    bool anyHidden() const { return m_HiddenCount > 0; }
+    // By dense entity index (Entity::getIndex).
+    bool isHidden(uint32_t entityIndex) const {
+        return entityIndex < m_HiddenRefs.size() && m_HiddenRefs[entityIndex] > 0;
+    }
+    bool isProxyActive(uint32_t entityIndex) const {
+        return entityIndex < m_ActiveProxies.size() && m_ActiveProxies[entityIndex] != 0;
+    }
+
+    size_t getProxyCount() const { return m_Proxies.size(); }
+
+private:
+    struct Proxy {
+        uint32_t entityIndex = 0;
+        Math::Vector3 center;
+        float activationDistance = 0.0f;
+        std::vector<uint32_t> sources; // entity indices
+    };
+
+    void rebuild(const Scene& scene, const RenderWorld& world);
+    void setActive(const Proxy& proxy, bool active);
+    int64_t cellKey(int32_t x, int32_t z) const {
+        return (static_cast<int64_t>(x) << 32) ^ static_cast<uint32_t>(z);
+    }
+
+    const Scene* m_Scene = nullptr;
+    uint64_t m_WorldVersion = 0;
+    uint64_t m_StateVersion = 0;
+    bool m_Built = false;
+
+    std::vector<Proxy> m_Proxies;
+    float m_CellSize = 32.0f;
+    std::unordered_map<int64_t, std::vector<uint32_t>> m_Cells; // proxy indices per XZ cell
+    std::vector<uint32_t> m_Wide;     // proxies spanning too many cells, tested every update
+    std::vector<uint32_t> m_Inside;   // sorted proxy indices the camera is inside, i.e. inactive
+    std::vector<uint32_t> m_Scratch;
+
+    std::vector<uint16_t> m_HiddenRefs; // active proxies hiding each entity
+    std::vector<uint8_t> m_ActiveProxies;
+    size_t m_HiddenCount = 0;           // entities with a non-zero count
+};
+
+} // namespace Crescent
@@ -0,0 +1,541 @@
+#include "LightBakeBVH.hpp"
+#include "../Rendering/Mesh.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Crescent {
+
+namespace {
+
+constexpr int kSAHBins = 12;
+constexpr size_t kMaxLeafTriangles = 4;
+constexpr int kMaxDepth = 48;
+// Each level pops one node and pushes at most four.
+constexpr int kTraversalStackSize = kMaxDepth * 3 + 8;
+
+float SurfaceArea(const Math::Vector3& boundsMin, const Math::Vector3& boundsMax) {
+    Math::Vector3 extent = boundsMax - boundsMin;
+    if (extent.x < 0.0f || extent.y < 0.0f || extent.z < 0.0f) {
+        return 0.0f;
+    }
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+// Moller-Trumbore; u and v weight the second and third vertices.
+bool IntersectTriangle(const Math::Vector3& origin,
+                       const Math::Vector3& direction,
+                       const Math::Vector3& v0,
+                       const Math::Vector3& edge1,
+                       const Math::Vector3& edge2,
+                       float maxDistance,
+                       float& outDistance,
+                       float& outU,
+                       float& outV) {
+    Math::Vector3 p = direction.cross(edge2);
+    float det = edge1.dot(p);
+    if (std::abs(det) < 1e-12f) {
+        return false;
+    }
+    float invDet = 1.0f / det;
+    Math::Vector3 s = origin - v0;
+    float u = s.dot(p) * invDet;
+    if (u < 0.0f || u > 1.0f) {
+        return false;
+    }
+    Math::Vector3 q = s.cross(edge1);
+    float v = direction.dot(q) * invDet;
+    if (v < 0.0f || u + v > 1.0f) {
+        return false;
+    }
+    float t = edge2.dot(q) * invDet;
+    if (t <= 0.0f || t >= maxDistance) {
+        return false;
+    }
+    outDistance = t;
+    outU = u;
+    outV = v;
+    return true;
+}
+
+Math::Vector3 ClosestPointOnTriangle(const Math::Vector3& point,
+                                     const Math::Vector3& a,
+                                     const Math::Vector3& b,
+                                     const Math::Vector3& c) {
+    Math::Vector3 ab = b - a;
+    Math::Vector3 ac = c - a;
+    Math::Vector3 ap = point - a;
+    float d1 = ab.dot(ap);
+    float d2 = ac.dot(ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        return a;
+    }
+    Math::Vector3 bp = point - b;
+    float d3 = ab.dot(bp);
+    float d4 = ac.dot(bp);
+    if (d3 >= 0.0f && d4 <= d3) {
+        return b;
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        return a + ab * (d1 / (d1 - d3));
+    }
+    Math::Vector3 cp = point - c;
+    float d5 = ab.dot(cp);
+    float d6 = ac.dot(cp);
+    if (d6 >= 0.0f && d5 <= d6) {
+        return c;
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        return a + ac * (d2 / (d2 - d6));
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+    float denom = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+float SampleAlpha(const LightBakeAlphaMask::Image& image, const Math::Vector2& uv, int channel) {
+    if (!image.rgba || image.width <= 0 || image.height <= 0) {
+        return 1.0f;
+    }
+    float u = uv.x - std::floor(uv.x);
+    float v = uv.y - std::floor(uv.y);
+    int x = std::min(image.width - 1, static_cast<int>(u * static_cast<float>(image.width)));
+    int y = std::min(image.height - 1, static_cast<int>((1.0f - v) * static_cast<float>(image.height)));
+    size_t offset = (static_cast<size_t>(y) * static_cast<size_t>(image.width) + static_cast<size_t>(x)) * 4u;
+    return static_cast<float>(image.rgba[offset + static_cast<size_t>(channel)]) / 255.0f;
+}
+
+} // namespace
+
+struct LightBakeBVH::BuildRef {
+    Math::Vector3 boundsMin;
+    Math::Vector3 boundsMax;
+    Math::Vector3 centroid;
+    uint32_t triangle = 0;
+};
+
+void LightBakeBVH::clear() {
+    m_Nodes.clear();
+    m_Triangles.clear();
+    m_Attributes.clear();
+    m_Instances.clear();
+}
+
+void LightBakeBVH::build(const std::vector<LightBakeMeshInstance>& instances) {
+    clear();
+
+    std::vector<Triangle> triangles;
+    std::vector<BuildRef> refs;
+    for (const LightBakeMeshInstance& instance : instances) {
+        if (!instance.mesh) {
+            continue;
+        }
+        const auto& vertices = instance.mesh->getVertices();
+        const auto& indices = instance.mesh->getIndices();
+        const auto& submeshes = instance.mesh->getSubmeshes();
+        if (vertices.empty() || indices.size() < 3) {
+            continue;
+        }
+
+        const uint32_t instanceIndex = static_cast<uint32_t>(m_Instances.size());
+        m_Instances.push_back({instance.entity, instance.castShadows, instance.alphaMasks});
+        for (size_t tri = 0; tri + 2 < indices.size(); tri += 3) {
+            uint32_t i0 = indices[tri + 0];
+            uint32_t i1 = indices[tri + 1];
+            uint32_t i2 = indices[tri + 2];
+            if (i0 >= vertices.size() || i1 >= vertices.size() || i2 >= vertices.size()) {
+                continue;
+            }
+            Math::Vector3 p0 = instance.worldMatrix.transformPoint(vertices[i0].position);
+            Math::Vector3 p1 = instance.worldMatrix.transformPoint(vertices[i1].position);
+            Math::Vector3 p2 = instance.worldMatrix.transformPoint(vertices[i2].position);
+            Triangle triangle;
+            triangle.v0 = p0;
+            triangle.edge1 = p1 - p0;
+            triangle.edge2 = p2 - p0;
+            if (triangle.edge1.cross(triangle.edge2).lengthSquared() <= 1e-20f) {
+                continue;
+            }
+
+            TriangleAttributes attributes;
+            attributes.uv0 = vertices[i0].texCoord;
+            attributes.uv1 = vertices[i1].texCoord;
+            attributes.uv2 = vertices[i2].texCoord;
+            for (const Submesh& submesh : submeshes) {
+                if (tri >= submesh.indexStart && tri < static_cast<size_t>(submesh.indexStart + submesh.indexCount)) {
+                    attributes.materialIndex = static_cast<int>(submesh.materialIndex);
+                    break;
+                }
+            }
+            triangle.instance = instanceIndex;
+            triangle.attributes = static_cast<uint32_t>(m_Attributes.size());
+            m_Attributes.push_back(attributes);
+
+            BuildRef ref;
+            ref.boundsMin = Math::Vector3::Min(p0, Math::Vector3::Min(p1, p2));
+            ref.boundsMax = Math::Vector3::Max(p0, Math::Vector3::Max(p1, p2));
+            ref.centroid = (ref.boundsMin + ref.boundsMax) * 0.5f;
+            ref.triangle = static_cast<uint32_t>(triangles.size());
+            triangles.push_back(triangle);
+            refs.push_back(ref);
+        }
+    }
+    if (refs.empty()) {
+        clear();
+        return;
+    }
+
+    m_Nodes.reserve(refs.size() / 2 + 1);
+    buildNode(refs, 0, refs.size(), 0);
+
+    // Leaves address triangles in build order.
+    m_Triangles.reserve(refs.size());
+    for (const BuildRef& ref : refs) {
+        m_Triangles.push_back(triangles[ref.triangle]);
+    }
+}
+
+size_t LightBakeBVH::partition(std::vector<BuildRef>& refs, size_t begin, size_t end) {
+    const size_t count = end - begin;
+    Math::Vector3 boundsMin(std::numeric_limits<float>::max());
+    Math::Vector3 boundsMax(std::numeric_limits<float>::lowest());
+    Math::Vector3 centroidMin(std::numeric_limits<float>::max());
+    Math::Vector3 centroidMax(std::numeric_limits<float>::lowest());
+    for (size_t i = begin; i < end; ++i) {
+        boundsMin = Math::Vector3::Min(boundsMin, refs[i].boundsMin);
+        boundsMax = Math::Vector3::Max(boundsMax, refs[i].boundsMax);
+        centroidMin = Math::Vector3::Min(centroidMin, refs[i].centroid);
+        centroidMax = Math::Vector3::Max(centroidMax, refs[i].centroid);
+    }
+
+    Math::Vector3 centroidExtent = centroidMax - centroidMin;
+    int axis = 0;
+    if (centroidExtent.y > centroidExtent[axis]) {
+        axis = 1;
+    }
+    if (centroidExtent.z > centroidExtent[axis]) {
+        axis = 2;
+    }
+    auto medianSplit = [&]() {
+        const size_t mid = begin + count / 2;
+        std::nth_element(refs.begin() + static_cast<std::ptrdiff_t>(begin),
+                         refs.begin() + static_cast<std::ptrdiff_t>(mid),
+                         refs.begin() + static_cast<std::ptrdiff_t>(end),
+                         [axis](const BuildRef& a, const BuildRef& b) { return a.centroid[axis] < b.centroid[axis]; });
+        return mid;
+    };
+    if (centroidExtent[axis] <= 1e-6f) {
+        return count > kMaxLeafTriangles ? medianSplit() : begin;
+    }
+
+    struct Bin {
+        Math::Vector3 boundsMin = Math::Vector3(std::numeric_limits<float>::max());
+        Math::Vector3 boundsMax = Math::Vector3(std::numeric_limits<float>::lowest());
+        size_t count = 0;
+    };
+    Bin bins[kSAHBins];
+    const float binScale = static_cast<float>(kSAHBins) / centroidExtent[axis];
+    auto binIndex = [&](const BuildRef& ref) {
+        int index = static_cast<int>((ref.centroid[axis] - centroidMin[axis]) * binScale);
+        return std::max(0, std::min(kSAHBins - 1, index));
+    };
+    for (size_t i = begin; i < end; ++i) {
+        Bin& bin = bins[binIndex(refs[i])];
+        bin.boundsMin = Math::Vector3::Min(bin.boundsMin, refs[i].boundsMin);
+        bin.boundsMax = Math::Vector3::Max(bin.boundsMax, refs[i].boundsMax);
+        bin.count += 1;
+    }
+
+    // Right-to-left sweep for the right side's area, then pick the cheapest plane on the way back.
+    float rightCost[kSAHBins] = {};
+    Math::Vector3 sweepMin(std::numeric_limits<float>::max());
+    Math::Vector3 sweepMax(std::numeric_limits<float>::lowest());
+    size_t sweepCount = 0;
+    for (int i = kSAHBins - 1; i > 0; --i) {
+        sweepMin = Math::Vector3::Min(sweepMin, bins[i].boundsMin);
+        sweepMax = Math::Vector3::Max(sweepMax, bins[i].boundsMax);
+        sweepCount += bins[i].count;
+        rightCost[i] = static_cast<float>(sweepCount) * SurfaceArea(sweepMin, sweepMax);
+    }
+    int bestSplit = -1;
+    float bestCost = std::numeric_limits<float>::max();
+    sweepMin = Math::Vector3(std::numeric_limits<float>::max());
+    sweepMax = Math::Vector3(std::numeric_limits<float>::lowest());
+    sweepCount = 0;
+    for (int i = 1; i < kSAHBins; ++i) {
+        sweepMin = Math::Vector3::Min(sweepMin, bins[i - 1].boundsMin);
+        sweepMax = Math::Vector3::Max(sweepMax, bins[i - 1].boundsMax);
+        sweepCount += bins[i - 1].count;
+        if (sweepCount == 0 || sweepCount == count) {
+            continue;
+        }
+        float cost = static_cast<float>(sweepCount) * SurfaceArea(sweepMin, sweepMax) + rightCost[i];
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestSplit = i;
+        }
+    }
+
+    const float leafCost = static_cast<float>(count) * SurfaceArea(boundsMin, boundsMax);
+    if (count <= kMaxLeafTriangles && (bestSplit < 0 || bestCost >= leafCost)) {
+        return begin;
+    }
+    if (bestSplit < 0) {
+        return medianSplit();
+    }
+    auto midIt = std::partition(refs.begin() + static_cast<std::ptrdiff_t>(begin),
+                                refs.begin() + static_cast<std::ptrdiff_t>(end),
+                                [&](const BuildRef& ref) { return binIndex(ref) < bestSplit; });
+    return static_cast<size_t>(midIt - refs.begin());
+}
+
+uint32_t LightBakeBVH::buildNode(std::vector<BuildRef>& refs, size_t begin, size_t end, int depth) {
+    const uint32_t nodeIndex = static_cast<uint32_t>(m_Nodes.size());
+    m_Nodes.emplace_back();
+
+    // Split the largest range until there are four children, which collapses two levels of a
+    // binary SAH tree into one node.
+    size_t rangeBegin[kWidth] = {begin};
+    size_t rangeEnd[kWidth] = {end};
+    bool rangeFinal[kWidth] = {};
+    int rangeCount = 1;
+    while (rangeCount < kWidth && depth < kMaxDepth) {
+        int pick = -1;
+        size_t largest = 0;
+        for (int i = 0; i < rangeCount; ++i) {
+            size_t size = rangeEnd[i] - rangeBegin[i];
+            if (!rangeFinal[i] && size > 1 && size > largest) {
+                largest = size;
+                pick = i;
+            }
+        }
+        if (pick < 0) {
+            break;
+        }
+        size_t mid = partition(refs, rangeBegin[pick], rangeEnd[pick]);
+        if (mid <= rangeBegin[pick] || mid >= rangeEnd[pick]) {
+            rangeFinal[pick] = true;
+            continue;
+        }
+        rangeBegin[rangeCount] = mid;
+        rangeEnd[rangeCount] = rangeEnd[pick];
+        rangeEnd[pick] = mid;
+        rangeCount += 1;
+    }
+
+    Node node;
+    for (int lane = 0; lane < kWidth; ++lane) {
+        node.minX[lane] = node.minY[lane] = node.minZ[lane] = std::numeric_limits<float>::max();
+        node.maxX[lane] = node.maxY[lane] = node.maxZ[lane] = std::numeric_limits<float>::lowest();
+        node.child[lane] = kEmptyChild;
+        node.count[lane] = 0;
+        if (lane >= rangeCount) {
+            continue;
+        }
+
+        Math::Vector3 boundsMin(std::numeric_limits<float>::max());
+        Math::Vector3 boundsMax(std::numeric_limits<float>::lowest());
+        for (size_t i = rangeBegin[lane]; i < rangeEnd[lane]; ++i) {
+            boundsMin = Math::Vector3::Min(boundsMin, refs[i].boundsMin);
+            boundsMax = Math::Vector3::Max(boundsMax, refs[i].boundsMax);
+        }
+        node.minX[lane] = boundsMin.x;
+        node.minY[lane] = boundsMin.y;
+        node.minZ[lane] = boundsMin.z;
+        node.maxX[lane] = boundsMax.x;
+        node.maxY[lane] = boundsMax.y;
+        node.maxZ[lane] = boundsMax.z;
+
+        const size_t size = rangeEnd[lane] - rangeBegin[lane];
+        if (size <= kMaxLeafTriangles || rangeFinal[lane] || depth + 1 >= kMaxDepth) {
+            node.child[lane] = static_cast<uint32_t>(rangeBegin[lane]);
+            node.count[lane] = static_cast<uint32_t>(size);
+        } else {
+            node.child[lane] = buildNode(refs, rangeBegin[lane], rangeEnd[lane], depth + 1);
+        }
+    }
+    m_Nodes[nodeIndex] = node;
+    return nodeIndex;
+}
+
+bool LightBakeBVH::passesAlphaTest(const Triangle& triangle, float u, float v) const {
+    const InstanceInfo& instance = m_Instances[triangle.instance];
+    const TriangleAttributes& attributes = m_Attributes[triangle.attributes];
+    if (attributes.materialIndex < 0 || static_cast<size_t>(attributes.materialIndex) >= instance.alphaMasks.size()) {
+        return true;
+    }
+    const LightBakeAlphaMask& mask = instance.alphaMasks[static_cast<size_t>(attributes.materialIndex)];
+    if (mask.cutoff <= 0.0f) {
+        return true;
+    }
+    Math::Vector2 uv = attributes.uv0 * (1.0f - u - v) + attributes.uv1 * u + attributes.uv2 * v;
+    uv = Math::Vector2(uv.x * mask.uvTiling.x, uv.y * mask.uvTiling.y) + mask.uvOffset;
+    float alpha = mask.alphaScale * SampleAlpha(mask.albedo, uv, 3) * SampleAlpha(mask.opacity, uv, 0);
+    return alpha >= mask.cutoff;
+}
+
+template <bool AnyHit>
+bool LightBakeBVH::traverse(const Math::Vector3& origin, const Math::Vector3& direction, float maxDistance,
+                            uint32_t& outTriangle, float& outDistance, float& outU, float& outV) const {
+    if (m_Nodes.empty() || !(maxDistance > 0.0f)) {
+        return false;
+    }
+
+    // Tiny components keep the slab products finite, so empty lanes never turn into NaN hits.
+    float invDir[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        float d = direction[axis];
+        if (std::abs(d) < 1e-12f) {
+            d = std::copysign(1e-12f, d);
+        }
+        invDir[axis] = 1.0f / d;
+    }
+
+    uint32_t stack[kTraversalStackSize];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    float closest = maxDistance;
+    bool found = false;
+    while (stackSize > 0) {
+        const Node& node = m_Nodes[stack[--stackSize]];
+
+        float tNear[kWidth];
+        bool laneHit[kWidth];
+        for (int lane = 0; lane < kWidth; ++lane) {
+            float tx0 = (node.minX[lane] - origin.x) * invDir[0];
+            float tx1 = (node.maxX[lane] - origin.x) * invDir[0];
+            float ty0 = (node.minY[lane] - origin.y) * invDir[1];
+            float ty1 = (node.maxY[lane] - origin.y) * invDir[1];
+            float tz0 = (node.minZ[lane] - origin.z) * invDir[2];
+            float tz1 = (node.maxZ[lane] - origin.z) * invDir[2];
+            float tMin = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+            float tMax = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), closest));
+            tNear[lane] = tMin;
+            laneHit[lane] = tMin <= tMax;
+        }
+
+        // Leaves are tested straight away; inner children go on the stack far to near.
+        int pushOrder[kWidth];
+        int pushCount = 0;
+        for (int lane = 0; lane < kWidth; ++lane) {
+            if (!laneHit[lane] || node.child[lane] == kEmptyChild) {
+                continue;
+            }
+            if (node.count[lane] == 0) {
+                int slot = pushCount++;
+                while (slot > 0 && tNear[pushOrder[slot - 1]] < tNear[lane]) {
+                    pushOrder[slot] = pushOrder[slot - 1];
+                    --slot;
+                }
+                pushOrder[slot] = lane;
+                continue;
+            }
+            const uint32_t first = node.child[lane];
+            const uint32_t last = first + node.count[lane];
+            for (uint32_t index = first; index < last; ++index) {
+                const Triangle& triangle = m_Triangles[index];
+                if (AnyHit && !m_Instances[triangle.instance].castShadows) {
+                    continue;
+                }
+                float t = 0.0f;
+                float u = 0.0f;
+                float v = 0.0f;
+                if (!IntersectTriangle(origin, direction, triangle.v0, triangle.edge1, triangle.edge2, closest, t, u, v) ||
+                    !passesAlphaTest(triangle, u, v)) {
+                    continue;
+                }
+                closest = t;
+                outTriangle = index;
+                outDistance = t;
+                outU = u;
+                outV = v;
+                found = true;
+                if (AnyHit) {
+                    return true;
+                }
+            }
+        }
+        for (int i = 0; i < pushCount; ++i) {
+            stack[stackSize++] = node.child[pushOrder[i]];
+        }
+    }
+    return found;
+}
+
+bool LightBakeBVH::intersect(const Math::Vector3& origin, const Math::Vector3& direction, float maxDistance,
+                             Hit& outHit) const {
+    uint32_t triangleIndex = 0;
+    float distance = 0.0f;
+    float u = 0.0f;
+    float v = 0.0f;
+    if (!traverse<false>(origin, direction, maxDistance, triangleIndex, distance, u, v)) {
+        return false;
+    }
+
+    const Triangle& triangle = m_Triangles[triangleIndex];
+    const TriangleAttributes& attributes = m_Attributes[triangle.attributes];
+    outHit.entity = m_Instances[triangle.instance].entity;
+    outHit.distance = distance;
+    outHit.point = origin + direction * distance;
+    outHit.normal = triangle.edge1.cross(triangle.edge2).normalized();
+    outHit.uv = attributes.uv0 * (1.0f - u - v) + attributes.uv1 * u + attributes.uv2 * v;
+    outHit.materialIndex = attributes.materialIndex;
+    return true;
+}
+
+bool LightBakeBVH::occluded(const Math::Vector3& origin, const Math::Vector3& direction, float maxDistance) const {
+    uint32_t triangleIndex = 0;
+    float distance = 0.0f;
+    float u = 0.0f;
+    float v = 0.0f;
+    return traverse<true>(origin, direction, maxDistance, triangleIndex, distance, u, v);
+}
+
+bool LightBakeBVH::overlapsSphere(const Math::Vector3& center, float radius) const {
+    if (m_Nodes.empty() || radius <= 0.0f) {
+        return false;
+    }
+
+    const float radiusSq = radius * radius;
+    uint32_t stack[kTraversalStackSize];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node& node = m_Nodes[stack[--stackSize]];
+        for (int lane = 0; lane < kWidth; ++lane) {
+            if (node.child[lane] == kEmptyChild) {
+                continue;
+            }
+            float dx = std::max({node.minX[lane] - center.x, 0.0f, center.x - node.maxX[lane]});
+            float dy = std::max({node.minY[lane] - center.y, 0.0f, center.y - node.maxY[lane]});
+            float dz = std::max({node.minZ[lane] - center.z, 0.0f, center.z - node.maxZ[lane]});
+            if (dx * dx + dy * dy + dz * dz > radiusSq) {
+                continue;
+            }
+            if (node.count[lane] == 0) {
+                stack[stackSize++] = node.child[lane];
+                continue;
+            }
+            const uint32_t first = node.child[lane];
+            const uint32_t last = first + node.count[lane];
+            for (uint32_t index = first; index < last; ++index) {
+                const Triangle& triangle = m_Triangles[index];
+                Math::Vector3 closest = ClosestPointOnTriangle(center,
+                                                               triangle.v0,
+                                                               triangle.v0 + triangle.edge1,
+                                                               triangle.v0 + triangle.edge2);
+                if ((closest - center).lengthSquared() <= radiusSq) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace Crescent
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../Math/Math.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Crescent {
+
+class Entity;
+class Mesh;
+
+// Cutout coverage for one material slot, as the shadow pass computes it: albedo alpha times the
+// albedo texture's alpha times the opacity texture's red channel, clipped at the cutoff. A zero
+// cutoff leaves the slot opaque. The RGBA8 pixels are borrowed and must outlive the BVH.
+struct LightBakeAlphaMask {
+    struct Image {
+        const unsigned char* rgba = nullptr;
+        int width = 0;
+        int height = 0;
+    };
+    Image albedo;
+    Image opacity;
+    float alphaScale = 1.0f;
+    float cutoff = 0.0f;
+    Math::Vector2 uvTiling = Math::Vector2(1.0f, 1.0f);
+    Math::Vector2 uvOffset = Math::Vector2(0.0f, 0.0f);
+};
+
+struct LightBakeMeshInstance {
+    Entity* entity = nullptr;
+    std::shared_ptr<Mesh> mesh;
+    Math::Matrix4x4 worldMatrix;
+    bool castShadows = true;
+    // Indexed by submesh material index; slots without a mask are opaque.
+    std::vector<LightBakeAlphaMask> alphaMasks;
+};
+
+// Triangle BVH over the render meshes, built once per bake and traced by the lightmap and probe
+// bakers in place of physics raycasts. Nodes are four wide with their child bounds stored as
+// float[4] lanes, so a ray tests all four children in one vectorised slab test. Read-only after
+// build(), so any number of bake workers may trace it at once.
+class LightBakeBVH {
+public:
+    struct Hit {
+        Entity* entity = nullptr;
+        float distance = 0.0f;
+        Math::Vector3 point = Math::Vector3::Zero;
+        Math::Vector3 normal = Math::Vector3::Up; // geometric, unflipped
+        Math::Vector2 uv = Math::Vector2::Zero;
+        int materialIndex = 0;
+    };
+
+    void build(const std::vector<LightBakeMeshInstance>& instances);
+    void clear();
+
+    bool empty() const { return m_Nodes.empty(); }
+    size_t getTriangleCount() const { return m_Triangles.size(); }
+
+    // Nearest hit along direction (normalised) within maxDistance.
+    bool intersect(const Math::Vector3& origin, const Math::Vector3& direction, float maxDistance, Hit& outHit) const;
+    // Any hit within maxDistance; instances that do not cast shadows are skipped.
+    bool occluded(const Math::Vector3& origin, const Math::Vector3& direction, float maxDistance) const;
+    // Whether any triangle passes within radius of center.
+    bool overlapsSphere(const Math::Vector3& center, float radius) const;
+
+private:
+    static constexpr int kWidth = 4;
+    static constexpr uint32_t kEmptyChild = 0xffffffffu;
+
+    struct Node {
+        float minX[kWidth];
+        float minY[kWidth];
+        float minZ[kWidth];
+        float maxX[kWidth];
+        float maxY[kWidth];
+        float maxZ[kWidth];
+        // Internal children index m_Nodes; leaves (count > 0) index m_Triangles.
+        uint32_t child[kWidth];
+        uint32_t count[kWidth];
+    };
+
+    struct Triangle {
+        Math::Vector3 v0;
+        Math::Vector3 edge1;
+        Math::Vector3 edge2;
+        uint32_t instance = 0;
+        uint32_t attributes = 0;
+    };
+
+    struct TriangleAttributes {
+        Math::Vector2 uv0;
+        Math::Vector2 uv1;
+        Math::Vector2 uv2;
+        int materialIndex = 0;
+    };
+
+    struct InstanceInfo {
+        Entity* entity = nullptr;
+        bool castShadows = true;
+        std::vector<LightBakeAlphaMask> alphaMasks;
+    };
+
+    struct BuildRef;
+
+    static size_t partition(std::vector<BuildRef>& refs, size_t begin, size_t end);
+    uint32_t buildNode(std::vector<BuildRef>& refs, size_t begin, size_t end, int depth);
+    bool passesAlphaTest(const Triangle& triangle, float u, float v) const;
+    template <bool AnyHit>
+    bool traverse(const Math::Vector3& origin, const Math::Vector3& direction, float maxDistance,
+                  uint32_t& outTriangle, float& outDistance, float& outU, float& outV) const;
+
+    std::vector<Node> m_Nodes;
+    std::vector<Triangle> m_Triangles;
+    std::vector<TriangleAttributes> m_Attributes;
+    std::vector<InstanceInfo> m_Instances;
+};
+
+} // namespace Crescent
@@ -0,0 +1,81 @@
+#include "RenderWorld.hpp"
+#include "../ECS/Entity.hpp"
+#include "../Components/MeshRenderer.hpp"
+#include "../Components/SkinnedMeshRenderer.hpp"
+#include "../Components/InstancedMeshRenderer.hpp"
+#include "../Components/PrimitiveMesh.hpp"
+#include "../Components/Light.hpp"
+#include "../Components/Decal.hpp"
+#include "../Components/HLODProxy.hpp"
+#include "../Components/FoliageScatter.hpp"
+#include "../Components/TerrainRenderer.hpp"
+#include "../Components/ParticleEmitter.hpp"
+
+namespace Crescent {
+
+void RenderWorld::sync(const std::vector<std::unique_ptr<Entity>>& entities) {
+    if (!m_Dirty) {
+        return;
+    }
+    m_Dirty = false;
+    m_Version++;
+
+    m_MeshRenderers.clear();
+    m_InstancedRenderers.clear();
+    m_SkinnedRenderers.clear();
+    m_Lights.clear();
+    m_Decals.clear();
+    m_HLODProxies.clear();
+    m_FoliageScatters.clear();
+    m_Terrains.clear();
+    m_ParticleEmitters.clear();
+
+    for (const auto& entityPtr : entities) {
+        Entity* entity = entityPtr.get();
+        if (!entity) {
+            continue;
+        }
+        MeshRenderer* meshRenderer = entity->getComponent<MeshRenderer>();
+        SkinnedMeshRenderer* skinned = entity->getComponent<SkinnedMeshRenderer>();
+        InstancedMeshRenderer* instanced = entity->getComponent<InstancedMeshRenderer>();
+        HLODProxy* hlod = entity->getComponent<HLODProxy>();
+        // An enabled TerrainRenderer draws the mesh itself; TerrainRenderer::OnEnable/OnDisable
+        // mark the world dirty so the mesh comes back when it is turned off.
+        TerrainRenderer* terrain = entity->getComponent<TerrainRenderer>();
+        if (terrain && meshRenderer && terrain->isEnabled()) {
+            m_Terrains.push_back({entity, terrain, meshRenderer});
+        } else if (meshRenderer) {
+            MeshRenderProxy proxy;
+            proxy.entity = entity;
+            proxy.meshRenderer = meshRenderer;
+            proxy.skinned = skinned;
+            proxy.instanced = instanced;
+            proxy.hlod = hlod;
+            proxy.isPrimitive = entity->getComponent<PrimitiveMesh>() != nullptr;
+            m_MeshRenderers.push_back(proxy);
+        }
+        if (instanced) {
+            m_InstancedRenderers.push_back({entity, instanced});
+        }
+        if (skinned) {
+            m_SkinnedRenderers.push_back({entity, skinned});
+        }
+        if (Light* light = entity->getComponent<Light>()) {
+            m_Lights.push_back({entity, light});
+        }
+        if (Decal* decal = entity->getComponent<Decal>()) {
+            m_Decals.push_back({entity, decal});
+        }
+        if (hlod) {
+            m_HLODProxies.push_back({entity, hlod, meshRenderer});
+        }
+        if (FoliageScatter* scatter = entity->getComponent<FoliageScatter>()) {
+            m_FoliageScatters.push_back({entity, scatter, meshRenderer});
+        }
+        if (ParticleEmitter* emitter = entity->getComponent<ParticleEmitter>()) {
+            m_ParticleEmitters.push_back({entity, emitter});
+        }
+    }
+}
+
+} // namespace Crescent
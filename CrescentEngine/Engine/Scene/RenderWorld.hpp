@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Crescent {
+
+class Entity;
+class MeshRenderer;
+class SkinnedMeshRenderer;
+class InstancedMeshRenderer;
+class PrimitiveMesh;
+class Light;
+class Decal;
+class HLODProxy;
+class FoliageScatter;
+class TerrainRenderer;
+class ParticleEmitter;
+
+// Render-facing view of a scene: flat arrays holding the entities that carry each renderable
+// component, with the component pointers already resolved. The arrays are rebuilt only after a
+// structural change (entity created/destroyed, component added/removed), so the renderer's
+// per-frame passes iterate renderables instead of scanning every entity and doing a type_index
+// lookup per component. Enabled and active state are still read live each frame; proxies stay
+// registered while disabled so pipelined frames and inactive preview scenes see the same set.
+// Arrays preserve scene entity order, which keeps draw order identical to a full scan.
+
+struct MeshRenderProxy {
+    Entity* entity = nullptr;
+    MeshRenderer* meshRenderer = nullptr;
+    SkinnedMeshRenderer* skinned = nullptr;
+    InstancedMeshRenderer* instanced = nullptr;
+    HLODProxy* hlod = nullptr;
+    bool isPrimitive = false;
+};
+
+struct InstancedRenderProxy {
+    Entity* entity = nullptr;
+    InstancedMeshRenderer* instanced = nullptr;
+};
+
+struct LightRenderProxy {
+    Entity* entity = nullptr;
+    Light* light = nullptr;
+};
+
+struct DecalRenderProxy {
+    Entity* entity = nullptr;
+    Decal* decal = nullptr;
+};
+
+struct HLODRenderProxy {
+    Entity* entity = nullptr;
+    HLODProxy* proxy = nullptr;
+    MeshRenderer* meshRenderer = nullptr;
+};
+
+struct FoliageRenderProxy {
+    Entity* entity = nullptr;
+    FoliageScatter* scatter = nullptr;
+    MeshRenderer* terrain = nullptr;
+};
+
+// The terrain's mesh is not in getMeshRenderers() while its TerrainRenderer is enabled.
+struct TerrainRenderProxy {
+    Entity* entity = nullptr;
+    TerrainRenderer* terrain = nullptr;
+    MeshRenderer* meshRenderer = nullptr;
+};
+
+struct ParticleRenderProxy {
+    Entity* entity = nullptr;
+    ParticleEmitter* emitter = nullptr;
+};
+
+struct SkinnedRenderProxy {
+    Entity* entity = nullptr;
+    SkinnedMeshRenderer* skinned = nullptr;
+};
+
+class RenderWorld {
+public:
+    void markDirty() { m_Dirty = true; }
+    bool isDirty() const { return m_Dirty; }
+
+    // Re-registers every renderable if the scene changed structurally since the last call.
+    void sync(const std::vector<std::unique_ptr<Entity>>& entities);
+
+    const std::vector<MeshRenderProxy>& getMeshRenderers() const { return m_MeshRenderers; }
+    const std::vector<InstancedRenderProxy>& getInstancedRenderers() const { return m_InstancedRenderers; }
+    const std::vector<SkinnedRenderProxy>& getSkinnedRenderers() const { return m_SkinnedRenderers; }
+    const std::vector<LightRenderProxy>& getLights() const { return m_Lights; }
+    const std::vector<DecalRenderProxy>& getDecals() const { return m_Decals; }
+    const std::vector<HLODRenderProxy>& getHLODProxies() const { return m_HLODProxies; }
+    const std::vector<FoliageRenderProxy>& getFoliageScatters() const { return m_FoliageScatters; }
+    const std::vector<TerrainRenderProxy>& getTerrains() const { return m_Terrains; }
+    const std::vector<ParticleRenderProxy>& getParticleEmitters() const { return m_ParticleEmitters; }
+
+    // Bumped on every rebuild; lets caches keyed on the proxy arrays detect changes.
+    uint64_t getVersion() const { return m_Version; }
+
+private:
+    std::vector<MeshRenderProxy> m_MeshRenderers;
+    std::vector<InstancedRenderProxy> m_InstancedRenderers;
+    std::vector<SkinnedRenderProxy> m_SkinnedRenderers;
+    std::vector<LightRenderProxy> m_Lights;
+    std::vector<DecalRenderProxy> m_Decals;
+    std::vector<HLODRenderProxy> m_HLODProxies;
+    std::vector<FoliageRenderProxy> m_FoliageScatters;
+    std::vector<TerrainRenderProxy> m_Terrains;
+    std::vector<ParticleRenderProxy> m_ParticleEmitters;
+    uint64_t m_Version = 0;
+    bool m_Dirty = true;
+};
+
+} // namespace Crescent
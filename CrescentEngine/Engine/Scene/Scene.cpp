@@ -1,10 +1,15 @@
 #include "Scene.hpp"
 #include "SceneSerializer.hpp"
 #include "SceneManager.hpp"
+#include "SceneStreamer.hpp"
 #include "../Core/Engine.hpp"
+#include "../Core/JobScheduler.hpp"
 #include "../Core/SelectionSystem.hpp"
 #include "../Renderer/Renderer.hpp"
+#include "../Components/Camera.hpp"
 #include "../Components/Light.hpp"
+#include "../Components/MeshRenderer.hpp"
+#include "../Components/SkinnedMeshRenderer.hpp"
 #include "../Physics/PhysicsWorld.hpp"
 #include "../Project/Project.hpp"
 #include <algorithm>
@@ -54,7 +59,8 @@ Scene::Scene(const std::string& name)
     : m_UUID()
     , m_Name(name)
     , m_IsActive(true)
-    , m_PhysicsWorld(std::make_unique<PhysicsWorld>(this)) {
+    , m_PhysicsWorld(std::make_unique<PhysicsWorld>(this))
+    , m_Streamer(std::make_unique<SceneStreamer>(this)) {
     if (m_PhysicsWorld) {
         m_PhysicsWorld->initialize();
     }
@@ -70,27 +76,26 @@ Scene::~Scene() {
 }
 
 Entity* Scene::createEntity(const std::string& name) {
-    auto entity = std::make_unique<Entity>(name);
-    Entity* entityPtr = entity.get();
-    
-    entity->setScene(this);
-    m_EntityMap[entity->getUUID()] = entityPtr;
-    m_Entities.push_back(std::move(entity));
-    
-    if (m_IsActive) {
-        entityPtr->onSceneActivated();
-    }
-    
-    return entityPtr;
+    return addEntity(std::make_unique<Entity>(name));
 }
 
 Entity* Scene::createEntityWithUUID(UUID uuid, const std::string& name) {
-    auto entity = std::make_unique<Entity>(uuid, name);
+    return addEntity(std::make_unique<Entity>(uuid, name));
+}
+
+Entity* Scene::addEntity(std::unique_ptr<Entity> entity) {
+    RenderSnapshot::syncStructuralChange();
     Entity* entityPtr = entity.get();
     
     entity->setScene(this);
+    assignEntityIndex(entityPtr);
     m_EntityMap[entity->getUUID()] = entityPtr;
     m_Entities.push_back(std::move(entity));
+    m_RenderWorld.markDirty();
+    m_UpdateListsDirty = true;
+    m_TransformHierarchy.markStructureDirty();
+    m_SpatialIndex.track(entityPtr);
+    m_ChangeLog.record(SceneChangeLog::Kind::Created, entityPtr->getUUID());
     
     if (m_IsActive) {
         entityPtr->onSceneActivated();
@@ -99,8 +104,143 @@ Entity* Scene::createEntityWithUUID(UUID uuid, const std::string& name) {
     return entityPtr;
 }
 
+Entity* Scene::instantiate(const std::shared_ptr<const EntityPrefab>& prefab,
+                           const Math::Vector3& position, const Math::Quaternion& rotation) {
+    if (!prefab) {
+        return nullptr;
+    }
+    Entity* root = takePooledInstance(*prefab);
+    if (!root) {
+        root = spawnInstance(prefab);
+    }
+    root->getTransform()->setPositionAndRotation(position, rotation);
+    activateInstance(root, *prefab);
+    return root;
+}
+
+void Scene::instantiateBatch(const std::shared_ptr<const EntityPrefab>& prefab,
+                             const std::vector<Math::Vector3>& positions, std::vector<Entity*>& out) {
+    if (!prefab || positions.empty()) {
+        return;
+    }
+    // Everything is placed before anything activates, so OnCreate/OnEnable of the first
+    // instance already sees the whole wave.
+    RenderSnapshot::syncStructuralChange();
+    m_Entities.reserve(m_Entities.size() + positions.size() * prefab->getNodeCount());
+    const size_t first = out.size();
+    for (const Math::Vector3& position : positions) {
+        Entity* root = takePooledInstance(*prefab);
+        if (!root) {
+            root = spawnInstance(prefab);
+        }
+        root->getTransform()->setPosition(position);
+        out.push_back(root);
+    }
+    for (size_t i = first; i < out.size(); ++i) {
+        activateInstance(out[i], *prefab);
+    }
+}
+
+void Scene::prewarm(const std::shared_ptr<const EntityPrefab>& prefab, size_t count) {
+    if (!prefab) {
+        return;
+    }
+    PrefabPool& pool = m_PrefabPools[prefab.get()];
+    pool.prefab = prefab;
+    while (pool.free.size() < count) {
+        Entity* root = spawnInstance(prefab);
+        root->m_Pooled = true;
+        pool.free.push_back(root);
+    }
+}
+
+void Scene::release(Entity* root) {
+    if (!root || root->m_Pooled) {
+        return;
+    }
+    auto pool = root->m_Prefab ? m_PrefabPools.find(root->m_Prefab) : m_PrefabPools.end();
+    if (pool == m_PrefabPools.end()) {
+        destroyEntity(root);
+        return;
+    }
+    // Every node goes inactive, not just the root: the update passes check each entity's own flag.
+    std::vector<Transform*> subtree{root->getTransform()};
+    for (size_t i = 0; i < subtree.size(); ++i) {
+        for (Transform* child : subtree[i]->getChildren()) {
+            subtree.push_back(child);
+        }
+        subtree[i]->getEntity()->setActive(false);
+    }
+    if (root->getTransform()->getParent()) {
+        root->getTransform()->setParent(nullptr, true);
+    }
+    root->m_Pooled = true;
+    pool->second.free.push_back(root);
+}
+
+Entity* Scene::spawnInstance(const std::shared_ptr<const EntityPrefab>& prefab) {
+    PrefabPool& pool = m_PrefabPools[prefab.get()];
+    pool.prefab = prefab;
+
+    std::vector<Entity*> nodes;
+    nodes.reserve(prefab->m_Nodes.size());
+    for (const EntityPrefab::Node& node : prefab->m_Nodes) {
+        auto entity = std::make_unique<Entity>(node.name);
+        // Created inactive; activateInstance brings the instance up once it is placed.
+        entity->m_IsActive = false;
+        entity->m_KeepName = true;
+        Entity* entityPtr = addEntity(std::move(entity));
+        entityPtr->setTag(node.tag);
+        entityPtr->setLayer(node.layer);
+        Transform* transform = entityPtr->getTransform();
+        if (node.parent >= 0) {
+            transform->setParent(nodes[static_cast<size_t>(node.parent)]->getTransform(), false);
+        }
+        transform->setLocalPosition(node.localPosition);
+        transform->setLocalRotation(node.localRotation);
+        transform->setLocalScale(node.localScale);
+        for (const auto& component : node.components) {
+            entityPtr->adoptComponent(component->clone());
+        }
+        nodes.push_back(entityPtr);
+    }
+    nodes.front()->m_Prefab = prefab.get();
+    return nodes.front();
+}
+
+Entity* Scene::takePooledInstance(const EntityPrefab& prefab) {
+    auto pool = m_PrefabPools.find(&prefab);
+    if (pool == m_PrefabPools.end() || pool->second.free.empty()) {
+        return nullptr;
+    }
+    Entity* root = pool->second.free.back();
+    pool->second.free.pop_back();
+    root->m_Pooled = false;
+    // Placement is relative to the prefab's own rotation and scale.
+    const EntityPrefab::Node& rootNode = prefab.m_Nodes.front();
+    root->getTransform()->setLocalRotation(rootNode.localRotation);
+    root->getTransform()->setLocalScale(rootNode.localScale);
+    return root;
+}
+
+void Scene::activateInstance(Entity* root, const EntityPrefab& prefab) {
+    // Nodes are in prefab order, parents first, in both the prefab and the spawned subtree as long
+    // as gameplay has not reparented anything under the root.
+    std::vector<Transform*> subtree{root->getTransform()};
+    for (size_t i = 0; i < subtree.size(); ++i) {
+        for (Transform* child : subtree[i]->getChildren()) {
+            subtree.push_back(child);
+        }
+    }
+    for (size_t i = 0; i < subtree.size(); ++i) {
+        const bool active = i < prefab.m_Nodes.size() ? prefab.m_Nodes[i].active : true;
+        subtree[i]->getEntity()->setActive(active);
+    }
+}
+
 void Scene::destroyEntity(Entity* entity) {
     if (!entity) return;
+    RenderSnapshot::syncStructuralChange();
 
     Transform* transform = entity->getTransform();
     if (transform) {
@@ -130,6 +270,7 @@ void Scene::destroyEntity(Entity* entity) {
     
     // Remove from map
     m_EntityMap.erase(uuid);
+    m_ChangeLog.record(SceneChangeLog::Kind::Destroyed, uuid);
     
     queueDestroyEntity(entity);
     if (m_IterationDepth == 0) {
@@ -145,13 +286,51 @@ void Scene::destroyEntity(UUID uuid) {
 }
 
 void Scene::destroyAllEntities() {
+    RenderSnapshot::syncStructuralChange();
+    // Streamed cells only ever hold entities of this set.
+    m_Streamer->reset();
+    // Everything goes at once, so nothing is undone piecemeal: physics drops its bodies in one
+    // batch, components get OnDestroy without OnDisable, transforms skip unlinking from
+    // hierarchies that are going too, and the scene's name and tag registries go whole instead
+    // of an entry per entity.
+    m_TearingDown = true;
+    if (m_PhysicsWorld) {
+        m_PhysicsWorld->removeAllBodies();
+    }
+    // The renderers' meshes and materials outlive their entities until a background worker
+    // drops them, so freeing geometry, vertex data and textures does not stall the unload.
+    auto resources = std::make_shared<std::vector<std::shared_ptr<void>>>();
     for (auto& entity : m_Entities) {
         SelectionSystem::removeEntity(entity.get());
-        entity->OnDestroy();
+        if (auto* renderer = entity->getComponent<MeshRenderer>()) {
+            resources->push_back(renderer->getMesh());
+            resources->insert(resources->end(), renderer->getMaterials().begin(), renderer->getMaterials().end());
+        }
+        if (auto* skinned = entity->getComponent<SkinnedMeshRenderer>()) {
+            resources->push_back(skinned->getMesh());
+            resources->insert(resources->end(), skinned->getMaterials().begin(), skinned->getMaterials().end());
+        }
+        entity->destroyForTeardown();
     }
-    
+    Entity::releaseRegistries(this);
     m_Entities.clear();
+    m_TearingDown = false;
+    if (!resources->empty()) {
+        JobScheduler::getInstance().schedule(JobFunction([resources = std::move(resources)]() mutable {
+            resources.reset();
+        }), nullptr, JobPriority::Background);
+    }
     m_EntityMap.clear();
+    m_NextEntityIndex = 0;
+    m_FreeEntityIndices.clear();
+    m_CommandBuffer.clear();
+    m_PrefabPools.clear();
+    m_SpatialIndex.clear();
+    m_SpatialIndex.markDirty();
+    m_RenderWorld.markDirty();
+    m_UpdateListsDirty = true;
+    m_TransformHierarchy.markStructureDirty();
+    m_ChangeLog.reset();
 }
 
 Entity* Scene::findEntity(UUID uuid) const {
@@ -191,6 +370,77 @@ std::vector<Entity*> Scene::getRootEntities() const {
     return roots;
 }
 
+bool Scene::cloneFrom(const Scene& source, bool includeEditorOnly) {
+    if (&source == this) {
+        return true;
+    }
+    const bool wasActive = m_IsActive;
+    if (wasActive) {
+        setActive(false);
+    }
+    destroyAllEntities();
+    m_Name = source.m_Name;
+    m_Settings = source.m_Settings;
+
+    std::vector<std::pair<const Entity*, Entity*>> clones;
+    clones.reserve(source.m_Entities.size());
+    m_Entities.reserve(source.m_Entities.size());
+    bool complete = true;
+    for (const auto& sourcePtr : source.m_Entities) {
+        const Entity* sourceEntity = sourcePtr.get();
+        if (!sourceEntity || (!includeEditorOnly && sourceEntity->isEditorOnly())) {
+            continue;
+        }
+        Entity* entity = createEntityWithUUID(sourceEntity->getUUID(), sourceEntity->getName());
+        entity->setEditorOnly(sourceEntity->isEditorOnly());
+        entity->setTag(sourceEntity->getTag());
+        entity->setLayer(sourceEntity->getLayer());
+
+        const Transform* sourceTransform = sourceEntity->getTransform();
+        Transform* transform = entity->getTransform();
+        transform->setLocalPosition(sourceTransform->getLocalPosition());
+        transform->setLocalRotation(sourceTransform->getLocalRotation());
+        transform->setLocalScale(sourceTransform->getLocalScale());
+
+        for (const auto& component : sourceEntity->getAllComponents()) {
+            if (component.get() == sourceTransform) {
+                continue;
+            }
+            std::unique_ptr<Component> copy = component->clone();
+            if (!copy) {
+                std::cerr << "Scene: " << component->getTypeName() << " on " << sourceEntity->getName()
+                          << " cannot be cloned\n";
+                complete = false;
+                continue;
+            }
+            entity->adoptComponent(std::move(copy));
+        }
+        clones.emplace_back(sourceEntity, entity);
+    }
+
+    // Parents are linked once every entity exists; an editor-only parent leaves its child a root,
+    // as it would in a saved runtime scene.
+    for (const auto& [sourceEntity, entity] : clones) {
+        Transform* sourceParent = sourceEntity->getTransform()->getParent();
+        if (!sourceParent || !sourceParent->getEntity()) {
+            continue;
+        }
+        if (Entity* parent = findEntity(sourceParent->getEntity()->getUUID())) {
+            entity->getTransform()->setParent(parent->getTransform(), false);
+        }
+    }
+
+    if (wasActive) {
+        setActive(true);
+    }
+    for (const auto& [sourceEntity, entity] : clones) {
+        if (!sourceEntity->isActiveSelf()) {
+            entity->setActive(false);
+        }
+    }
+    return complete;
+}
+
 void Scene::setActive(bool active) {
     if (m_IsActive == active) return;
     
@@ -236,31 +486,98 @@ void Scene::OnStart() {
     endIteration();
 }
 
-void Scene::OnUpdate(float deltaTime) {
+namespace {
+
+bool isRuntimeUpdatable(const Component* component) {
+    if (!component || !component->isEnabled()) {
+        return false;
+    }
+    const Entity* entity = component->getEntity();
+    return entity && entity->isActive() && !entity->isEditorOnly();
+}
+
+} // namespace
+
+void Scene::OnUpdate(float deltaTime, bool skipParallel) {
     if (!m_IsActive) return;
     
+    refreshUpdateLists();
     beginIteration();
-    for (auto& entity : m_Entities) {
-        if (entity->isActive() && !entity->isEditorOnly()) {
-            entity->OnUpdate(deltaTime);
+    // One type at a time, so a batch runs the same OnUpdate back to back. Components created
+    // during the walk join on the next frame.
+    for (size_t list = 0; list < m_UpdateLists.size(); ++list) {
+        if ((m_UpdateLists[list].hooks & kComponentHookUpdate) == 0) {
+            continue;
+        }
+        const size_t count = m_UpdateLists[list].components.size();
+        for (size_t i = 0; i < count; ++i) {
+            Component* component = m_UpdateLists[list].components[i];
+            if (isRuntimeUpdatable(component) &&
+                !(skipParallel && (component->supportsParallelUpdate() || component->hasAnimationPhase()))) {
+                component->OnUpdate(deltaTime);
+            }
         }
     }
     endIteration();
 }
 
-void Scene::OnFixedUpdate(float deltaTime) {
+void Scene::OnFixedUpdate(float deltaTime, bool skipParallel) {
     if (!m_IsActive) {
         return;
     }
+    refreshUpdateLists();
     beginIteration();
-    for (auto& entity : m_Entities) {
-        if (entity->isActive() && !entity->isEditorOnly()) {
-            entity->OnFixedUpdate(deltaTime);
+    for (size_t list = 0; list < m_UpdateLists.size(); ++list) {
+        if ((m_UpdateLists[list].hooks & kComponentHookFixedUpdate) == 0) {
+            continue;
+        }
+        const size_t count = m_UpdateLists[list].components.size();
+        for (size_t i = 0; i < count; ++i) {
+            Component* component = m_UpdateLists[list].components[i];
+            if (isRuntimeUpdatable(component) && !(skipParallel && component->supportsParallelUpdate())) {
+                component->OnFixedUpdate(deltaTime);
+            }
         }
     }
     endIteration();
 }
 
+void Scene::collectParallelComponents(std::vector<Component*>& out, uint32_t hook) {
+    out.clear();
+    if (!m_IsActive) {
+        return;
+    }
+    refreshUpdateLists();
+    for (const ComponentUpdateList& list : m_UpdateLists) {
+        if ((list.hooks & hook) == 0) {
+            continue;
+        }
+        for (Component* component : list.components) {
+            if (isRuntimeUpdatable(component) && component->supportsParallelUpdate()) {
+                out.push_back(component);
+            }
+        }
+    }
+}
+
+void Scene::collectAnimationComponents(std::vector<Component*>& out) {
+    out.clear();
+    if (!m_IsActive) {
+        return;
+    }
+    refreshUpdateLists();
+    for (const ComponentUpdateList& list : m_UpdateLists) {
+        if ((list.hooks & kComponentHookAnimation) == 0) {
+            continue;
+        }
+        for (Component* component : list.components) {
+            if (isRuntimeUpdatable(component) && component->hasAnimationPhase()) {
+                out.push_back(component);
+            }
+        }
+    }
+}
+
 void Scene::OnFixedPhysicsUpdate(float deltaTime) {
     if (!m_IsActive) {
         return;
@@ -277,10 +594,22 @@ void Scene::OnEditorUpdate(float deltaTime) {
     if (m_PhysicsWorld && !SceneManager::getInstance().isPlaying()) {
         m_PhysicsWorld->update(deltaTime, false);
     }
+    refreshUpdateLists();
     beginIteration();
-    for (auto& entity : m_Entities) {
-        if (entity->isActive() && entity->isEditorOnly()) {
-            entity->OnEditorUpdate(deltaTime);
+    for (size_t list = 0; list < m_UpdateLists.size(); ++list) {
+        if ((m_UpdateLists[list].hooks & kComponentHookEditorUpdate) == 0) {
+            continue;
+        }
+        const size_t count = m_UpdateLists[list].components.size();
+        for (size_t i = 0; i < count; ++i) {
+            Component* component = m_UpdateLists[list].components[i];
+            if (!component || !component->isEnabled()) {
+                continue;
+            }
+            const Entity* entity = component->getEntity();
+            if (entity && entity->isActive() && entity->isEditorOnly()) {
+                component->OnEditorUpdate(deltaTime);
+            }
         }
     }
     endIteration();
@@ -291,17 +620,54 @@ void Scene::beginFrame() {
         return;
     }
     if (m_IterationDepth == 0) {
+        playbackCommands();
         flushPendingDestroys();
     }
     beginIteration();
-    for (auto& entity : m_Entities) {
-        if (entity->isActive()) {
-            entity->getTransform()->capturePreviousWorldMatrix();
+    view<Transform>().each([](Entity& entity, Transform& transform) {
+        if (entity.isActive()) {
+            transform.capturePreviousWorldMatrix();
         }
-    }
+    });
     endIteration();
 }
 
+void Scene::updateTransforms() {
+    m_TransformHierarchy.update(m_Entities);
+    m_SpatialIndex.update(m_Entities, m_TransformHierarchy);
+}
+
+void Scene::publishRenderState() {
+    // Inactive entities are published too: update may activate them while the frame encodes.
+    for (const auto& entity : m_Entities) {
+        entity->publishRenderState();
+    }
+    view<Transform>().each([](Entity&, Transform& transform) {
+        transform.publishRenderState();
+    });
+    view<Camera>().each([](Entity&, Camera& camera) {
+        camera.publishRenderState();
+    });
+    const RenderWorld& renderWorld = getRenderWorld();
+    for (const auto& proxy : renderWorld.getSkinnedRenderers()) {
+        proxy.skinned->publishRenderState();
+    }
+    for (const auto& proxy : renderWorld.getLights()) {
+        proxy.light->publishRenderState();
+    }
+}
+
+const RenderWorld& Scene::getRenderWorld() {
+    m_RenderWorld.sync(m_Entities);
+    return m_RenderWorld;
+}
+
+const HLODSwitch& Scene::updateHLODSwitch(const Math::Vector3& cameraPosition) {
+    const RenderWorld& world = getRenderWorld();
+    m_HLODSwitch.update(*this, world, m_HLODStateVersion.load(std::memory_order_relaxed), cameraPosition);
+    return m_HLODSwitch;
+}
+
 void Scene::queueDestroyEntity(Entity* entity) {
     if (!entity) {
         return;
@@ -311,20 +677,88 @@ void Scene::queueDestroyEntity(Entity* entity) {
     }
 }
 
+void Scene::assignEntityIndex(Entity* entity) {
+    if (!m_FreeEntityIndices.empty()) {
+        entity->m_Index = m_FreeEntityIndices.back();
+        m_FreeEntityIndices.pop_back();
+    } else {
+        entity->m_Index = m_NextEntityIndex++;
+    }
+}
+
 void Scene::flushPendingDestroys() {
     if (m_PendingDestroy.empty()) {
         return;
     }
+    RenderSnapshot::syncStructuralChange();
     for (Entity* entity : m_PendingDestroy) {
         auto it = std::find_if(m_Entities.begin(), m_Entities.end(),
             [entity](const std::unique_ptr<Entity>& e) {
                 return e.get() == entity;
             });
         if (it != m_Entities.end()) {
+            if (entity->m_Pooled) {
+                auto& pool = m_PrefabPools[entity->m_Prefab].free;
+                pool.erase(std::find(pool.begin(), pool.end(), entity));
+            }
+            const uint32_t index = entity->m_Index;
+            m_FreeEntityIndices.push_back(index);
             m_Entities.erase(it);
+            m_SpatialIndex.remove(entity, index);
         }
     }
     m_PendingDestroy.clear();
+    m_RenderWorld.markDirty();
+    m_UpdateListsDirty = true;
+    m_TransformHierarchy.markStructureDirty();
+}
+
+void Scene::playbackCommands() {
+    if (m_IterationDepth > 0) {
+        return;
+    }
+    m_CommandBuffer.playback(*this);
+}
+
+void Scene::forgetComponent(Component* component) {
+    for (ComponentUpdateList& list : m_UpdateLists) {
+        if (list.type != component->getTypeIndex()) {
+            continue;
+        }
+        auto it = std::find(list.components.begin(), list.components.end(), component);
+        if (it != list.components.end()) {
+            *it = nullptr;
+        }
+        return;
+    }
+}
+
+void Scene::refreshUpdateLists() {
+    // Never under a walk of the lists; a nested call keeps using them as they are.
+    if (!m_UpdateListsDirty || m_IterationDepth > 0) {
+        return;
+    }
+    for (ComponentUpdateList& list : m_UpdateLists) {
+        list.components.clear();
+    }
+    for (const auto& entity : m_Entities) {
+        for (const auto& component : entity->getAllComponents()) {
+            const uint32_t hooks = component->getUpdateHooks();
+            if (hooks == 0) {
+                continue;
+            }
+            const std::type_index type = component->getTypeIndex();
+            auto it = std::find_if(m_UpdateLists.begin(), m_UpdateLists.end(),
+                [&type](const ComponentUpdateList& list) { return list.type == type; });
+            if (it == m_UpdateLists.end()) {
+                m_UpdateLists.push_back(ComponentUpdateList{type, hooks, {}});
+                it = m_UpdateLists.end() - 1;
+            }
+            it->components.push_back(component.get());
+        }
+    }
+    // Types that left the scene keep their list (and its capacity) empty.
+    m_UpdateListsDirty = false;
 }
 
 void Scene::endIteration() {
@@ -385,7 +819,7 @@ void Scene::applySettings() {
         }
     } else if (currentEnv.sourcePath != env.skyboxPath ||
                currentEnv.cookedIBLPath != env.cookedSkyboxPath) {
-        if (!renderer->loadEnvironmentMap(env.skyboxPath, env.cookedSkyboxPath)) {
+        if (!renderer->requestEnvironmentMap(env.skyboxPath, env.cookedSkyboxPath)) {
             renderer->resetEnvironment();
         }
     }
@@ -2,8 +2,18 @@
 
 #include "../Core/UUID.hpp"
 #include "../ECS/Entity.hpp"
+#include "../ECS/ComponentView.hpp"
+#include "../ECS/EntityCommandBuffer.hpp"
+#include "../ECS/TransformHierarchy.hpp"
 #include "SceneSettings.hpp"
+#include "RenderWorld.hpp"
+#include "EntityPrefab.hpp"
+#include "SceneSpatialIndex.hpp"
+#include "SceneChangeLog.hpp"
+#include "HLODSwitch.hpp"
+#include <atomic>
 #include <string>
+#include <typeindex>
 #include <vector>
 #include <memory>
 #include <unordered_map>
@@ -11,6 +21,7 @@
 namespace Crescent {
 
 class PhysicsWorld;
+class SceneStreamer;
 
 // Scene - container for entities
 class Scene {
@@ -27,6 +38,19 @@ public:
     // Entity management
     Entity* createEntity(const std::string& name = "Entity");
     Entity* createEntityWithUUID(UUID uuid, const std::string& name = "Entity");
+
+    // Prefab instances (see EntityPrefab). Instances keep the prefab's names rather than getting
+    // unique ones, and release parks an instance deactivated for the next instantiate instead of
+    // destroying it; pooled components come back through OnEnable with their old state.
+    Entity* instantiate(const std::shared_ptr<const EntityPrefab>& prefab, const Math::Vector3& position,
+                        const Math::Quaternion& rotation = Math::Quaternion::Identity);
+    // A whole wave: every instance is placed before any of them activates.
+    void instantiateBatch(const std::shared_ptr<const EntityPrefab>& prefab,
+                          const std::vector<Math::Vector3>& positions, std::vector<Entity*>& out);
+    // Fills the pool up to count parked instances ahead of a spawn-heavy section.
+    void prewarm(const std::shared_ptr<const EntityPrefab>& prefab, size_t count);
+    // Pools a prefab instance; any other entity is destroyed.
+    void release(Entity* root);
     
     void destroyEntity(Entity* entity);
     void destroyEntity(UUID uuid);
@@ -41,16 +65,59 @@ public:
     }
     
     int getEntityCount() const { return static_cast<int>(m_Entities.size()); }
+    // Upper bound of the entities' dense indices (Entity::getIndex), for sizing entity sets.
+    uint32_t getEntityIndexCount() const { return m_NextEntityIndex; }
+
+    // Cache-linear iteration over a pooled component type and its siblings (see ComponentView).
+    template <typename T, typename... Others>
+    ComponentView<T, Others...> view() const { return ComponentView<T, Others...>(this); }
     
     // Scene lifecycle
     void OnCreate();
     void OnDestroy();
     void OnStart();
-    void OnUpdate(float deltaTime);
+    void OnUpdate(float deltaTime, bool skipParallel = false);
     void OnFixedPhysicsUpdate(float deltaTime);
-    void OnFixedUpdate(float deltaTime);
+    void OnFixedUpdate(float deltaTime, bool skipParallel = false);
+    // Gathers enabled components that opted into parallel update and override hook, a
+    // ComponentUpdateHook (see Component).
+    void collectParallelComponents(std::vector<Component*>& out, uint32_t hook);
+    void collectAnimationComponents(std::vector<Component*>& out);
     void OnEditorUpdate(float deltaTime);
     void beginFrame();
+    // Resolves every dirty world matrix in one parent-first sweep (see TransformHierarchy), then
+    // refits the spatial index around whatever moved.
+    void updateTransforms();
+    // Refreshes the render snapshot of every entity, inactive ones included (see RenderSnapshot).
+    void publishRenderState();
+
+    // Renderable proxies, rebuilt lazily after structural changes (see RenderWorld).
+    const RenderWorld& getRenderWorld();
+    void markRenderWorldDirty() { m_RenderWorld.markDirty(); }
+
+    // Entity bounds for spatial queries, as of the last updateTransforms (see SceneSpatialIndex).
+    const SceneSpatialIndex& getSpatialIndex() const { return m_SpatialIndex; }
+    // The entity's bounds changed other than by moving, e.g. a mesh was attached.
+    void markSpatialBoundsDirty(Entity* entity) { m_SpatialIndex.track(entity); }
+
+    // HLOD proxies switched in for a camera position (see HLODSwitch). Called by each pass that
+    // draws the scene; repeated calls for the same camera only look up one grid cell.
+    const HLODSwitch& updateHLODSwitch(const Math::Vector3& cameraPosition);
+    // Entity activation, component enable and proxy edits: the switch rebuilds on its next update.
+    void markHLODDirty() { m_HLODStateVersion.fetch_add(1, std::memory_order_relaxed); }
+
+    // Hierarchy edits since a version, for the editor's hierarchy (see SceneChangeLog).
+    SceneChangeLog& getChangeLog() { return m_ChangeLog; }
+    const SceneChangeLog& getChangeLog() const { return m_ChangeLog; }
+
+    // Structural changes recorded from jobs; playbackCommands applies them at a sync point.
+    EntityCommandBuffer& getCommandBuffer() { return m_CommandBuffer; }
+    void playbackCommands();
+
+    // Per-type update lists, rebuilt lazily like the render world. A component removed while the
+    // lists are being walked is dropped from them right away.
+    void markUpdateListsDirty() { m_UpdateListsDirty = true; }
+    void forgetComponent(Component* component);
     
     // Scene root entities (entities without parent)
     std::vector<Entity*> getRootEntities() const;
@@ -58,11 +125,20 @@ public:
     // Active state
     bool isActive() const { return m_IsActive; }
     void setActive(bool active);
+    // True while destroyAllEntities tears every entity down; components skip the bookkeeping
+    // that only matters to entities that stay.
+    bool isTearingDown() const { return m_TearingDown; }
     
     // Serialization
     void serialize(const std::string& filepath);
     void deserialize(const std::string& filepath);
 
+    // Replaces this scene's name, settings and entities with copies of source's, keeping UUIDs.
+    // Components come from Component::clone(), so assets are shared and nothing is reloaded or
+    // parsed. Returns false if some component could not be cloned; the scene is then incomplete
+    // and the caller should fall back to the serializer.
+    bool cloneFrom(const Scene& source, bool includeEditorOnly = false);
+
     // Settings
     SceneSettings& getSettings() { return m_Settings; }
     const SceneSettings& getSettings() const { return m_Settings; }
@@ -71,6 +147,9 @@ public:
 
     // Physics
     class PhysicsWorld* getPhysicsWorld() const { return m_PhysicsWorld.get(); }
+
+    // World partition cells of a cooked scene (see SceneStreamer).
+    SceneStreamer* getStreamer() const { return m_Streamer.get(); }
     
 private:
     UUID m_UUID;
@@ -78,14 +157,46 @@ private:
     bool m_IsActive;
     SceneSettings m_Settings;
     std::unique_ptr<class PhysicsWorld> m_PhysicsWorld;
+    std::unique_ptr<SceneStreamer> m_Streamer;
     
     std::vector<std::unique_ptr<Entity>> m_Entities;
     std::unordered_map<UUID, Entity*> m_EntityMap;
+    uint32_t m_NextEntityIndex = 0;
+    std::vector<uint32_t> m_FreeEntityIndices;
+    RenderWorld m_RenderWorld;
+    TransformHierarchy m_TransformHierarchy;
+    SceneSpatialIndex m_SpatialIndex;
+    HLODSwitch m_HLODSwitch;
+    std::atomic<uint64_t> m_HLODStateVersion{0};
+    SceneChangeLog m_ChangeLog;
     std::vector<Entity*> m_PendingDestroy;
+    struct PrefabPool {
+        std::shared_ptr<const EntityPrefab> prefab;
+        std::vector<Entity*> free;
+    };
+    std::unordered_map<const EntityPrefab*, PrefabPool> m_PrefabPools;
+    EntityCommandBuffer m_CommandBuffer;
     int m_IterationDepth = 0;
+    bool m_TearingDown = false;
+
+    // The components of one type with a per-frame hook, in entity order. Slots of removed
+    // components are null until the next rebuild.
+    struct ComponentUpdateList {
+        std::type_index type;
+        uint32_t hooks = 0;
+        std::vector<Component*> components;
+    };
+    std::vector<ComponentUpdateList> m_UpdateLists;
+    bool m_UpdateListsDirty = true;
 
+    Entity* addEntity(std::unique_ptr<Entity> entity);
+    Entity* spawnInstance(const std::shared_ptr<const EntityPrefab>& prefab);
+    Entity* takePooledInstance(const EntityPrefab& prefab);
+    void activateInstance(Entity* root, const EntityPrefab& prefab);
+    void assignEntityIndex(Entity* entity);
     void queueDestroyEntity(Entity* entity);
     void flushPendingDestroys();
+    void refreshUpdateLists();
     void beginIteration() { ++m_IterationDepth; }
     void endIteration();
 };
@@ -0,0 +1,299 @@
+#include "SceneAnalyzer.hpp"
+#include "Scene.hpp"
+#include "../ECS/Entity.hpp"
+#include "../ECS/Transform.hpp"
+#include "../Components/MeshRenderer.hpp"
+#include "../Components/SkinnedMeshRenderer.hpp"
+#include "../Components/InstancedMeshRenderer.hpp"
+#include "../Components/Light.hpp"
+#include "../Components/Rigidbody.hpp"
+#include "../Components/PhysicsCollider.hpp"
+#include "../Rendering/Texture.hpp"
+#include <Metal/Metal.hpp>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+namespace Crescent {
+
+namespace {
+    constexpr const char* kKindNames[kSceneIssueKindCount] = {
+        "HighPolyWithoutLods",
+        "InstancingCandidate",
+        "OverlappingPointShadows",
+        "UncompressedTexture",
+        "OversizedTexture",
+        "DynamicMeshCollider",
+        "ExcessiveBones"
+    };
+
+    constexpr double kErrorFactor = 4.0;
+
+    SceneIssueSeverity SeverityFor(double cost, double limit) {
+        return cost >= limit * kErrorFactor ? SceneIssueSeverity::Error : SceneIssueSeverity::Warning;
+    }
+
+    // BC, PVRTC, EAC/ETC and ASTC all sit between BC1 and the last ASTC format.
+    bool IsBlockCompressed(MTL::PixelFormat format) {
+        return format >= MTL::PixelFormatBC1_RGBA && format <= MTL::PixelFormatASTC_12x12_HDR;
+    }
+
+    struct Usage {
+        Entity* first = nullptr;
+        Entity* last = nullptr;
+        uint32_t users = 0;
+    };
+
+    // Counts each entity once per asset, however many of its slots use it.
+    void NoteUsage(Usage& usage, Entity* entity) {
+        if (usage.last == entity) {
+            return;
+        }
+        if (!usage.first) {
+            usage.first = entity;
+        }
+        usage.last = entity;
+        ++usage.users;
+    }
+
+    void NoteMaterialTextures(const std::vector<std::shared_ptr<Material>>& materials, Entity* entity,
+                              std::unordered_map<const Texture2D*, Usage>& textures) {
+        for (const std::shared_ptr<Material>& material : materials) {
+            if (!material) {
+                continue;
+            }
+            const std::shared_ptr<Texture2D> slots[] = {
+                material->getAlbedoTexture(),
+                material->getNormalTexture(),
+                material->getMetallicTexture(),
+                material->getRoughnessTexture(),
+                material->getAOTexture(),
+                material->getEmissionTexture(),
+                material->getORMTexture(),
+                material->getHeightTexture(),
+                material->getOpacityTexture(),
+                material->getTerrainControlTexture(),
+                material->getTerrainLayer0Texture(),
+                material->getTerrainLayer1Texture(),
+                material->getTerrainLayer2Texture(),
+                material->getTerrainLayer0NormalTexture(),
+                material->getTerrainLayer1NormalTexture(),
+                material->getTerrainLayer2NormalTexture(),
+                material->getTerrainLayer0ORMTexture(),
+                material->getTerrainLayer1ORMTexture(),
+                material->getTerrainLayer2ORMTexture()
+            };
+            for (const std::shared_ptr<Texture2D>& texture : slots) {
+                if (texture) {
+                    NoteUsage(textures[texture.get()], entity);
+                }
+            }
+        }
+    }
+
+    SceneIssue MakeIssue(SceneIssueKind kind, SceneIssueSeverity severity, double cost,
+                         const Entity* entity, std::string asset, uint32_t occurrences, std::string message) {
+        SceneIssue issue;
+        issue.kind = kind;
+        issue.severity = severity;
+        issue.cost = cost;
+        issue.entity = entity->getUUID();
+        issue.entityName = entity->getName();
+        issue.asset = std::move(asset);
+        issue.occurrences = occurrences;
+        issue.message = std::move(message);
+        return issue;
+    }
+
+    std::string UsersSuffix(uint32_t users) {
+        return users > 1 ? " (" + std::to_string(users) + " entities)" : std::string();
+    }
+
+    struct ShadowedPointLight {
+        Entity* entity = nullptr;
+        Math::Vector3 position;
+        float range = 0.0f;
+    };
+}
+
+const char* SceneIssueKindName(SceneIssueKind kind) {
+    const size_t index = static_cast<size_t>(kind);
+    return index < kSceneIssueKindCount ? kKindNames[index] : "Unknown";
+}
+
+const char* SceneIssueSeverityName(SceneIssueSeverity severity) {
+    return severity == SceneIssueSeverity::Error ? "Error" : "Warning";
+}
+
+std::vector<SceneIssue> SceneAnalyzer::analyze(const Scene& scene, const SceneAnalysisSettings& settings) {
+    std::unordered_map<const Mesh*, Usage> meshes;
+    std::map<std::pair<const Mesh*, std::vector<const Material*>>, Usage> duplicates;
+    std::unordered_map<const Texture2D*, Usage> textures;
+    std::unordered_map<const Skeleton*, Usage> skeletons;
+    std::vector<ShadowedPointLight> pointLights;
+    std::vector<SceneIssue> issues;
+
+    for (const std::unique_ptr<Entity>& owned : scene.getAllEntities()) {
+        Entity* entity = owned.get();
+        if (!entity || !entity->isActiveInHierarchy()) {
+            continue;
+        }
+
+        MeshRenderer* meshRenderer = entity->getComponent<MeshRenderer>();
+        if (meshRenderer && meshRenderer->isEnabled() && meshRenderer->getMesh()) {
+            const Mesh* mesh = meshRenderer->getMesh().get();
+            NoteUsage(meshes[mesh], entity);
+            std::vector<const Material*> materials;
+            materials.reserve(meshRenderer->getMaterials().size());
+            for (const std::shared_ptr<Material>& material : meshRenderer->getMaterials()) {
+                materials.push_back(material.get());
+            }
+            NoteUsage(duplicates[{mesh, std::move(materials)}], entity);
+            NoteMaterialTextures(meshRenderer->getMaterials(), entity, textures);
+        }
+
+        SkinnedMeshRenderer* skinned = entity->getComponent<SkinnedMeshRenderer>();
+        if (skinned && skinned->isEnabled()) {
+            if (skinned->getMesh()) {
+                NoteUsage(meshes[skinned->getMesh().get()], entity);
+            }
+            if (skinned->getSkeleton()) {
+                NoteUsage(skeletons[skinned->getSkeleton().get()], entity);
+            }
+            NoteMaterialTextures(skinned->getMaterials(), entity, textures);
+        }
+
+        InstancedMeshRenderer* instanced = entity->getComponent<InstancedMeshRenderer>();
+        if (instanced && instanced->isEnabled()) {
+            if (instanced->getMesh()) {
+                NoteUsage(meshes[instanced->getMesh().get()], entity);
+            }
+            if (instanced->getSkeleton()) {
+                NoteUsage(skeletons[instanced->getSkeleton().get()], entity);
+            }
+            NoteMaterialTextures(instanced->getMaterials(), entity, textures);
+        }
+
+        Light* light = entity->getComponent<Light>();
+        if (light && light->isEnabled() && light->getType() == Light::Type::Point && light->getCastShadows()
+            && light->getRange() > 0.0f) {
+            pointLights.push_back({entity, entity->getTransform()->getPosition(), light->getRange()});
+        }
+
+        Rigidbody* rigidbody = entity->getComponent<Rigidbody>();
+        PhysicsCollider* collider = entity->getComponent<PhysicsCollider>();
+        if (rigidbody && collider && rigidbody->getType() == RigidbodyType::Dynamic
+            && (collider->getShapeType() == PhysicsCollider::ShapeType::Mesh
+                || collider->getShapeType() == PhysicsCollider::ShapeType::Terrain)) {
+            const size_t vertices = meshRenderer && meshRenderer->getMesh() ? meshRenderer->getMesh()->getVertexCount() : 0;
+            issues.push_back(MakeIssue(SceneIssueKind::DynamicMeshCollider, SceneIssueSeverity::Warning,
+                                       static_cast<double>(vertices), entity,
+                                       meshRenderer && meshRenderer->getMesh() ? meshRenderer->getMesh()->getName() : std::string(), 1,
+                                       "Dynamic body with a mesh collider is simulated as a convex hull of "
+                                       + std::to_string(vertices) + " vertices; use box, sphere or capsule colliders"));
+        }
+    }
+
+    for (const auto& [mesh, usage] : meshes) {
+        const uint64_t triangles = mesh->getIndexCount() / 3;
+        if (triangles > settings.maxTrianglesWithoutLods && mesh->getLods().empty()) {
+            issues.push_back(MakeIssue(SceneIssueKind::HighPolyWithoutLods,
+                                       SeverityFor(static_cast<double>(triangles), settings.maxTrianglesWithoutLods),
+                                       static_cast<double>(triangles), usage.first, mesh->getName(), usage.users,
+                                       std::to_string(triangles) + " triangles without LODs" + UsersSuffix(usage.users)));
+        }
+    }
+
+    for (const auto& [key, usage] : duplicates) {
+        if (usage.users >= settings.minInstancingDuplicates) {
+            issues.push_back(MakeIssue(SceneIssueKind::InstancingCandidate,
+                                       SeverityFor(usage.users, settings.minInstancingDuplicates),
+                                       usage.users, usage.first, key.first->getName(), usage.users,
+                                       std::to_string(usage.users) + " MeshRenderers share this mesh and materials; "
+                                       "an InstancedMeshRenderer draws them in one batch"));
+        }
+    }
+
+    for (size_t a = 0; a < pointLights.size(); ++a) {
+        for (size_t b = a + 1; b < pointLights.size(); ++b) {
+            const ShadowedPointLight& first = pointLights[a];
+            const ShadowedPointLight& second = pointLights[b];
+            const float distance = first.position.distance(second.position);
+            const float smaller = std::min(first.range, second.range);
+            const float overlap = std::min((first.range + second.range - distance) / (2.0f * smaller), 1.0f);
+            if (overlap <= settings.maxPointShadowOverlap) {
+                continue;
+            }
+            // A volume inside the other one shadows nothing the larger light could not.
+            const bool contained = distance + smaller <= std::max(first.range, second.range);
+            SceneIssue issue = MakeIssue(SceneIssueKind::OverlappingPointShadows,
+                                         contained ? SceneIssueSeverity::Error : SceneIssueSeverity::Warning,
+                                         overlap, first.entity, std::string(), 1,
+                                         "Shadow-casting point light overlaps " + second.entity->getName() + " by "
+                                         + std::to_string(static_cast<int>(overlap * 100.0f)) + "%; each renders six shadow faces");
+            issue.related = second.entity->getUUID();
+            issues.push_back(std::move(issue));
+        }
+    }
+
+    const double maxTexels = static_cast<double>(settings.maxTextureSize) * settings.maxTextureSize;
+    for (const auto& [texture, usage] : textures) {
+        const std::string size = std::to_string(texture->getWidth()) + "x" + std::to_string(texture->getHeight());
+        // A streaming texture's handle is a placeholder until it loads.
+        if (!texture->isStreaming() && texture->getHandle() && !IsBlockCompressed(texture->getHandle()->pixelFormat())) {
+            issues.push_back(MakeIssue(SceneIssueKind::UncompressedTexture, SceneIssueSeverity::Warning,
+                                       static_cast<double>(texture->getApproximateBytes()), usage.first,
+                                       texture->getPath(), usage.users,
+                                       size + " texture is uncompressed; cook it to ASTC or BC7" + UsersSuffix(usage.users)));
+        }
+        if (std::max(texture->getWidth(), texture->getHeight()) > settings.maxTextureSize) {
+            const double texels = static_cast<double>(texture->getWidth()) * texture->getHeight();
+            issues.push_back(MakeIssue(SceneIssueKind::OversizedTexture, SeverityFor(texels, maxTexels),
+                                       texels, usage.first, texture->getPath(), usage.users,
+                                       size + " texture exceeds " + std::to_string(settings.maxTextureSize)
+                                       + " pixels" + UsersSuffix(usage.users)));
+        }
+    }
+
+    for (const auto& [skeleton, usage] : skeletons) {
+        const uint32_t bones = skeleton->getBoneCount();
+        if (bones > settings.maxBones) {
+            issues.push_back(MakeIssue(SceneIssueKind::ExcessiveBones, SeverityFor(bones, settings.maxBones),
+                                       bones, usage.first, std::string(), usage.users,
+                                       std::to_string(bones) + " bones skinned and uploaded every frame"
+                                       + UsersSuffix(usage.users)));
+        }
+    }
+
+    sort(issues, SceneIssueSortKey::Severity);
+    return issues;
+}
+
+void SceneAnalyzer::sort(std::vector<SceneIssue>& issues, SceneIssueSortKey key) {
+    const auto byKindAndCost = [](const SceneIssue& a, const SceneIssue& b) {
+        if (a.kind != b.kind) {
+            return a.kind < b.kind;
+        }
+        return a.cost > b.cost;
+    };
+    switch (key) {
+    case SceneIssueSortKey::Severity:
+        std::stable_sort(issues.begin(), issues.end(), [&](const SceneIssue& a, const SceneIssue& b) {
+            if (a.severity != b.severity) {
+                return a.severity > b.severity;
+            }
+            return byKindAndCost(a, b);
+        });
+        break;
+    case SceneIssueSortKey::Kind:
+        std::stable_sort(issues.begin(), issues.end(), byKindAndCost);
+        break;
+    case SceneIssueSortKey::Entity:
+        std::stable_sort(issues.begin(), issues.end(), [](const SceneIssue& a, const SceneIssue& b) {
+            return a.entityName < b.entityName;
+        });
+        break;
+    }
+}
+
+} // namespace Crescent
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../Core/UUID.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Crescent {
+
+class Scene;
+
+enum class SceneIssueKind : uint8_t {
+    HighPolyWithoutLods,     // a mesh over the triangle limit that has no LOD chain
+    InstancingCandidate,     // MeshRenderers repeating one mesh and material set
+    OverlappingPointShadows, // two shadow-casting point lights whose volumes overlap
+    UncompressedTexture,     // a texture resident in a pixel format without block compression
+    OversizedTexture,        // a texture above the dimension limit
+    DynamicMeshCollider,     // a dynamic body whose mesh collider is cooked into a convex hull
+    ExcessiveBones,          // a skeleton over the bone limit
+    Count
+};
+constexpr size_t kSceneIssueKindCount = static_cast<size_t>(SceneIssueKind::Count);
+
+const char* SceneIssueKindName(SceneIssueKind kind);
+
+enum class SceneIssueSeverity : uint8_t {
+    Warning,
+    Error
+};
+
+const char* SceneIssueSeverityName(SceneIssueSeverity severity);
+
+// One finding. cost is the measure the rule checks, in the rule's own unit (triangles, renderers,
+// overlap fraction, bytes, hull vertices, bones), so it only orders issues of the same kind.
+struct SceneIssue {
+    SceneIssueKind kind = SceneIssueKind::HighPolyWithoutLods;
+    SceneIssueSeverity severity = SceneIssueSeverity::Warning;
+    double cost = 0.0;
+    UUID entity = UUID::Invalid();  // first entity showing the issue
+    UUID related = UUID::Invalid(); // the other light of an overlapping pair
+    std::string entityName;
+    std::string asset;              // mesh name or texture path, when there is one
+    uint32_t occurrences = 1;       // entities sharing the asset the issue is about
+    std::string message;
+};
+
+struct SceneAnalysisSettings {
+    uint32_t maxTrianglesWithoutLods = 20000;
+    uint32_t minInstancingDuplicates = 8;
+    float maxPointShadowOverlap = 0.5f; // of the smaller light's diameter
+    uint32_t maxTextureSize = 4096;
+    uint32_t maxBones = 128;
+};
+
+enum class SceneIssueSortKey : uint8_t {
+    Severity, // most severe first, then as Kind
+    Kind,     // by kind, highest cost first
+    Entity    // by entity name
+};
+
+// Performance lint over a scene's active entities. Meshes, textures and skeletons are reported once
+// each, on the first entity using them, with the number of users in occurrences. An issue becomes
+// an Error at four times its limit, or for a point light volume inside another; dynamic mesh
+// colliders are always Warnings. Reads the scene only, on the main thread.
+class SceneAnalyzer {
+public:
+    static std::vector<SceneIssue> analyze(const Scene& scene, const SceneAnalysisSettings& settings = {});
+    static void sort(std::vector<SceneIssue>& issues, SceneIssueSortKey key);
+};
+
+} // namespace Crescent
@@ -0,0 +1,44 @@
+#include "SceneChangeLog.hpp"
+
+namespace Crescent {
+
+void SceneChangeLog::record(Kind kind, UUID entity) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Change change;
+    change.version = ++m_Version;
+    change.kind = kind;
+    change.entity = entity;
+    m_Changes.push_back(change);
+    if (m_Changes.size() > kCapacity) {
+        m_OldestVersion = m_Changes.front().version;
+        m_Changes.pop_front();
+    }
+}
+
+void SceneChangeLog::reset() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Changes.clear();
+    m_OldestVersion = ++m_Version;
+}
+
+uint64_t SceneChangeLog::getVersion() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Version;
+}
+
+bool SceneChangeLog::collect(uint64_t version, std::vector<Change>& out) const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (version < m_OldestVersion || version > m_Version) {
+        return false;
+    }
+    // Versions are consecutive, so the first change after version sits at a known offset.
+    const size_t skip = m_Changes.empty()
+        ? 0
+        : static_cast<size_t>(version + 1 > m_Changes.front().version ? version + 1 - m_Changes.front().version : 0);
+    for (size_t i = skip; i < m_Changes.size(); ++i) {
+        out.push_back(m_Changes[i]);
+    }
+    return true;
+}
+
+} // namespace Crescent
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../Core/UUID.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace Crescent {
+
+// Versioned record of the hierarchy edits the editor mirrors: entities created, destroyed, renamed
+// or reparented, and components added or removed. Every edit bumps the version, so a reader asks
+// for the entities touched since the version it last saw instead of re-reading the whole scene.
+// Only the newest kCapacity edits are kept; a reader further behind than that, or behind a reset
+// (every entity replaced at once, as on load), has to resync from the scene.
+class SceneChangeLog {
+public:
+    enum class Kind : uint8_t {
+        Created,
+        Destroyed,
+        Renamed,
+        Reparented,
+        ComponentsChanged
+    };
+    struct Change {
+        uint64_t version = 0;
+        Kind kind = Kind::Created;
+        UUID entity;
+    };
+    static constexpr size_t kCapacity = 65536;
+
+    void record(Kind kind, UUID entity);
+    void reset();
+    uint64_t getVersion() const;
+    // Appends the changes made after version, oldest first. Returns false when some of them are no
+    // longer held; out is then left as it was.
+    bool collect(uint64_t version, std::vector<Change>& out) const;
+
+private:
+    mutable std::mutex m_Mutex;
+    std::deque<Change> m_Changes;
+    uint64_t m_Version = 0;
+    uint64_t m_OldestVersion = 0; // readers at or past this version can catch up
+};
+
+} // namespace Crescent
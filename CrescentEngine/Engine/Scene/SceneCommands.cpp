@@ -1,7 +1,12 @@
 #include "SceneCommands.hpp"
 #include "SceneSerializer.hpp"
+#include "LightBakeBVH.hpp"
 #include "../Core/Engine.hpp"
+#include "../Core/JobScheduler.hpp"
+#include "../Core/ThreadQoS.hpp"
 #include "../Renderer/Renderer.hpp"
+#include "../Renderer/GPULightBaker.hpp"
+#include "../Renderer/ProbeVolumeData.hpp"
 #include "../Rendering/Texture.hpp"
 #include "../Animation/Skeleton.hpp"
 #include "../Animation/AnimationClip.hpp"
@@ -11,9 +16,9 @@
 #include "../Components/PrimitiveMesh.hpp"
 #include "../Components/ModelMeshReference.hpp"
 #include "../Components/HLODProxy.hpp"
+#include "../Components/Rigidbody.hpp"
 #include "../Assets/AssetDatabase.hpp"
 #include "../ECS/Transform.hpp"
-#include "../Physics/PhysicsWorld.hpp"
 #include "../Rendering/stb_image.h"
 #include "../Rendering/stb_image_write.h"
 #include "../Rendering/tinyexr.h"
@@ -22,16 +27,26 @@
 #include <assimp/GltfMaterial.h>
 #include <assimp/material.h>
 #include <assimp/postprocess.h>
+#include <assimp/ProgressHandler.hpp>
 #include <assimp/quaternion.h>
 #include <assimp/scene.h>
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cctype>
+#include <chrono>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <iomanip>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -133,21 +148,21 @@ static float ComputeHLODRatio(size_t triangleCount, size_t sourceCount) {
     return std::max(0.12f, std::min(0.85f, ratio));
 }
 
-static bool SimplifyHLODBucketInPlace(HLODBucketBuildResult& bucket, size_t sourceCount) {
-    if (bucket.vertices.empty() || bucket.indices.size() < 192 || (bucket.indices.size() % 3) != 0) {
-        return false;
-    }
-
-    const size_t triangleCount = bucket.indices.size() / 3;
-    const float ratio = ComputeHLODRatio(triangleCount, sourceCount);
-    const size_t targetIndexCount = std::max<size_t>(96, RoundIndexCountToTriangleMultiple(static_cast<size_t>(std::round(bucket.indices.size() * ratio))));
-    if (targetIndexCount >= bucket.indices.size() || targetIndexCount < 3) {
-        return false;
-    }
+// Per-vertex attributes the simplifier weighs against position error, in Vertex order.
+constexpr size_t kSimplifierAttributeCount = 17;
+constexpr float kSimplifierAttributeWeights[kSimplifierAttributeCount] = {
+    0.35f, 0.35f, 0.35f,
+    0.75f, 0.75f,
+    0.35f, 0.35f,
+    0.2f, 0.2f, 0.2f,
+    0.1f, 0.1f, 0.1f,
+    0.05f, 0.05f, 0.05f, 0.05f
+};
 
+static std::vector<float> BuildSimplifierAttributes(const std::vector<Vertex>& vertices) {
     std::vector<float> attributes;
-    attributes.reserve(bucket.vertices.size() * 17);
-    for (const Vertex& v : bucket.vertices) {
+    attributes.reserve(vertices.size() * kSimplifierAttributeCount);
+    for (const Vertex& v : vertices) {
         attributes.push_back(v.normal.x);
         attributes.push_back(v.normal.y);
         attributes.push_back(v.normal.z);
@@ -166,15 +181,24 @@ static bool SimplifyHLODBucketInPlace(HLODBucketBuildResult& bucket, size_t sour
         attributes.push_back(v.color.z);
         attributes.push_back(v.color.w);
     }
+    return attributes;
+}
 
-    constexpr float kWeights[17] = {
-        0.35f, 0.35f, 0.35f,
-        0.75f, 0.75f,
-        0.35f, 0.35f,
-        0.2f, 0.2f, 0.2f,
-        0.1f, 0.1f, 0.1f,
-        0.05f, 0.05f, 0.05f, 0.05f
-    };
+// ratioScale < 1 simplifies further for the coarser levels of a cluster hierarchy, trading error
+// for triangles in the same proportion.
+static bool SimplifyHLODBucketInPlace(HLODBucketBuildResult& bucket, size_t sourceCount, float ratioScale = 1.0f) {
+    if (bucket.vertices.empty() || bucket.indices.size() < 192 || (bucket.indices.size() % 3) != 0) {
+        return false;
+    }
+
+    const size_t triangleCount = bucket.indices.size() / 3;
+    const float ratio = std::max(0.02f, ComputeHLODRatio(triangleCount, sourceCount) * ratioScale);
+    const size_t targetIndexCount = std::max<size_t>(96, RoundIndexCountToTriangleMultiple(static_cast<size_t>(std::round(bucket.indices.size() * ratio))));
+    if (targetIndexCount >= bucket.indices.size() || targetIndexCount < 3) {
+        return false;
+    }
+
+    std::vector<float> attributes = BuildSimplifierAttributes(bucket.vertices);
 
     std::vector<uint32_t> simplified(bucket.indices.size());
     float resultError = 0.0f;
@@ -185,12 +209,12 @@ static bool SimplifyHLODBucketInPlace(HLODBucketBuildResult& bucket, size_t sour
                                                             bucket.vertices.size(),
                                                             sizeof(Vertex),
                                                             attributes.data(),
-                                                            sizeof(float) * 17,
-                                                            kWeights,
-                                                            17,
+                                                            sizeof(float) * kSimplifierAttributeCount,
+                                                            kSimplifierAttributeWeights,
+                                                            kSimplifierAttributeCount,
                                                             nullptr,
                                                             targetIndexCount,
-                                                            0.02f,
+                                                            0.02f / ratioScale,
                                                             meshopt_SimplifyLockBorder,
                                                             &resultError);
     if (simplifiedCount == 0 || simplifiedCount >= bucket.indices.size()) {
@@ -231,6 +255,108 @@ static bool SimplifyHLODBucketInPlace(HLODBucketBuildResult& bucket, size_t sour
     bucket.indices = std::move(compactIndices);
     return true;
 }
+
+// Builds the mesh's LOD chain: each level halves the previous one per submesh (so materials keep
+// their ranges) until the reduction stalls or the mesh gets too small. Errors are accumulated along
+// the chain and stored in mesh units for screen-space selection.
+static void GenerateMeshLods(Mesh& mesh) {
+    constexpr size_t kMinSourceIndices = 256 * 3;
+    constexpr size_t kMinLodIndices = 32 * 3;
+    constexpr float kLevelRatio = 0.5f;
+    constexpr float kMinReduction = 0.85f;
+    constexpr float kTargetError = 0.05f;
+
+    const auto& vertices = mesh.getVertices();
+    const auto& indices = mesh.getIndices();
+    if (vertices.empty() || indices.size() < kMinSourceIndices || (indices.size() % 3) != 0) {
+        return;
+    }
+
+    std::vector<std::vector<uint32_t>> current;
+    const auto& submeshes = mesh.getSubmeshes();
+    for (const Submesh& submesh : submeshes) {
+        if (static_cast<size_t>(submesh.indexStart) + submesh.indexCount <= indices.size()) {
+            current.emplace_back(indices.begin() + submesh.indexStart,
+                                 indices.begin() + submesh.indexStart + submesh.indexCount);
+        }
+    }
+    if (current.empty()) {
+        current.emplace_back(indices);
+    }
+    // Shared seams between submeshes must not move, or neighbouring ranges crack apart.
+    const unsigned int options = current.size() > 1 ? meshopt_SimplifyLockBorder : 0;
+
+    const std::vector<float> attributes = BuildSimplifierAttributes(vertices);
+    const float scale = meshopt_simplifyScale(&vertices[0].position.x, vertices.size(), sizeof(Vertex));
+
+    std::vector<MeshLod> lods;
+    std::vector<uint32_t> lodIndices;
+    size_t previousCount = indices.size();
+    float accumulatedError = 0.0f;
+    for (uint32_t level = 1; level < MeshLod::kMaxLods; ++level) {
+        std::vector<std::vector<uint32_t>> next(current.size());
+        size_t levelCount = 0;
+        float levelError = 0.0f;
+        for (size_t r = 0; r < current.size(); ++r) {
+            const std::vector<uint32_t>& source = current[r];
+            const size_t targetIndexCount = RoundIndexCountToTriangleMultiple(
+                static_cast<size_t>(std::round(source.size() * kLevelRatio)));
+            if (source.size() < kMinLodIndices || targetIndexCount < 3) {
+                next[r] = source;
+                levelCount += source.size();
+                continue;
+            }
+            std::vector<uint32_t> simplified(source.size());
+            float resultError = 0.0f;
+            size_t simplifiedCount = meshopt_simplifyWithAttributes(simplified.data(),
+                                                                    source.data(),
+                                                                    source.size(),
+                                                                    &vertices[0].position.x,
+                                                                    vertices.size(),
+                                                                    sizeof(Vertex),
+                                                                    attributes.data(),
+                                                                    sizeof(float) * kSimplifierAttributeCount,
+                                                                    kSimplifierAttributeWeights,
+                                                                    kSimplifierAttributeCount,
+                                                                    nullptr,
+                                                                    targetIndexCount,
+                                                                    kTargetError,
+                                                                    options,
+                                                                    &resultError);
+            simplified.resize(RoundIndexCountToTriangleMultiple(simplifiedCount));
+            if (simplified.empty()) {
+                simplified = source;
+                resultError = 0.0f;
+            }
+            levelError = std::max(levelError, resultError);
+            levelCount += simplified.size();
+            next[r] = std::move(simplified);
+        }
+
+        if (levelCount == 0 || static_cast<float>(levelCount) > static_cast<float>(previousCount) * kMinReduction) {
+            break;
+        }
+
+        accumulatedError += levelError * scale;
+        MeshLod lod;
+        lod.indexStart = static_cast<uint32_t>(indices.size() + lodIndices.size());
+        lod.indexCount = static_cast<uint32_t>(levelCount);
+        lod.error = accumulatedError;
+        for (const std::vector<uint32_t>& range : next) {
+            lodIndices.insert(lodIndices.end(), range.begin(), range.end());
+        }
+        lods.push_back(lod);
+        previousCount = levelCount;
+        current = std::move(next);
+        if (levelCount < kMinLodIndices) {
+            break;
+        }
+    }
+
+    if (!lods.empty()) {
+        mesh.setLods(std::move(lods), std::move(lodIndices));
+    }
+}
 #endif
 
 struct ModelCacheEntry {
@@ -264,7 +390,6 @@ struct SurfaceSample {
     Math::Vector3 normalWS = Math::Vector3::Up;
     Math::Vector2 uv = Math::Vector2::Zero;
     int materialIndex = 0;
-    float distanceSq = std::numeric_limits<float>::max();
 };
 
 struct EmissiveTriangleSurface {
@@ -303,6 +428,38 @@ struct EmissiveSurfaceSample {
     bool twoSided = false;
 };
 
+// Vose alias table entry: a slot keeps its own surface with this probability, else takes alias.
+struct EmissiveAliasEntry {
+    float probability = 1.0f;
+    uint32_t alias = 0;
+};
+
+// Light tree node over the emissive triangles. Bounds, normal cone and summed weight bound what
+// the subtree can send to a shading point; leaves hold one surface.
+struct EmissiveLightNode {
+    Math::Vector3 boundsMin = Math::Vector3::Zero;
+    Math::Vector3 boundsMax = Math::Vector3::Zero;
+    Math::Vector3 coneAxis = Math::Vector3::Up;
+    float coneAngle = 0.0f; // pi for two-sided emitters
+    float weight = 0.0f;
+    uint32_t child = 0;     // first child (the second follows it), or the surface for leaves
+    bool leaf = false;
+};
+
+// Emissive triangles of a bake, built once with their samplers: the alias table picks a surface
+// by weight in O(1), the light tree by its estimated contribution at the shading point.
+struct EmissiveLightSet {
+    std::vector<EmissiveTriangleSurface> surfaces;
+    std::vector<EmissiveAliasEntry> aliasTable;
+    std::vector<EmissiveLightNode> lightTree;
+    float totalWeight = 0.0f;
+
+    bool empty() const { return surfaces.empty(); }
+};
+
+// Below this many emitters the alias table's unguided picks are cheap enough to keep.
+constexpr size_t kEmissiveLightTreeMinSurfaces = 32;
+
 struct StaticLightingLayoutCandidate {
     Entity* entity = nullptr;
     MeshRenderer* renderer = nullptr;
@@ -321,13 +478,73 @@ struct StaticLightingBakeCandidate {
     MeshRenderer::StaticLightingData staticLighting;
 };
 
-struct ShelfAtlasState {
+// Lightmap texels are baked in square tiles, one worker per tile at a time.
+constexpr int kLightmapBakeTileSize = 32;
+
+struct LightmapBakeTriangle {
+    const StaticLightingBakeCandidate* candidate = nullptr;
+    size_t tri = 0;
+    uint32_t i0 = 0;
+    uint32_t i1 = 0;
+    uint32_t i2 = 0;
+    std::shared_ptr<Material> material;
+    Math::Vector2 uv0;
+    Math::Vector2 uv1;
+    Math::Vector2 uv2;
+    int minX = 0;
+    int minY = 0;
+    int maxX = -1;
+    int maxY = -1;
+};
+
+// The point a texel centre maps to on one of its triangles, with what lighting it needs.
+struct LightmapTexelSample {
+    size_t pixelIndex = 0;
+    Math::Vector3 positionWS = Math::Vector3::Zero;
+    Math::Vector3 geometryNormalWS = Math::Vector3::Up;
+    Math::Vector3 shadingNormalWS = Math::Vector3::Up;
+    Math::Vector3 primaryEmission = Math::Vector3::Zero;
+    float primaryAO = 1.0f;
+    bool receiveGI = false;
+    uint32_t emissiveSeed = 0;
+    uint32_t indirectSeed = 0;
+};
+
+struct LightmapTexelLighting {
+    Math::Vector3 direct = Math::Vector3::Zero;
+    Math::Vector3 indirect = Math::Vector3::Zero;
+    Math::Vector3 dominantDirection = Math::Vector3::Zero;
+    float referenceNoL = 0.0f;
+    bool hasDominant = false;
+    // Shadowmask channel visibility; negative for channels no stationary light traced.
+    float shadowmask[4] = {-1.0f, -1.0f, -1.0f, -1.0f};
+};
+
+// Texel samples handed to the GPU baker at a time, bounding the query and result lists.
+constexpr size_t kGPULightmapQueryChunk = 1u << 18;
+// Texels of the first GPU chunk the CPU relights to log the backends' parity.
+constexpr size_t kGPULightmapParitySamples = 256;
+
+std::atomic<bool> g_StaticLightmapBakeActive{false};
+std::atomic<bool> g_StaticLightmapBakeCancel{false};
+std::atomic<float> g_StaticLightmapBakeProgress{0.0f};
+// Scene triangles for the bake in progress; the lighting helpers below trace nothing without it.
+const LightBakeBVH* g_LightBakeBVH = nullptr;
+
+// Bottom-left skyline packer state: the top edge of everything packed so far, as runs of
+// constant height from left to right covering the atlas width.
+struct SkylineAtlasState {
+    struct Segment {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+    };
+
     int atlasIndex = 0;
     int width = 0;
     int height = 0;
-    int cursorX = 0;
-    int cursorY = 0;
-    int rowHeight = 0;
+    int64_t usedArea = 0;
+    std::vector<Segment> skyline;
 };
 
 struct LightmapChart {
@@ -337,7 +554,10 @@ struct LightmapChart {
     std::unordered_map<uint32_t, Math::Vector2> projectedUVs;
     Math::Vector2 boundsMin = Math::Vector2::Zero;
     Math::Vector2 boundsMax = Math::Vector2::One;
-    Math::Vector2 packedOffset = Math::Vector2::Zero;
+    // Page position in pack cells; rotated charts swap their u and v extents.
+    int packedX = 0;
+    int packedY = 0;
+    bool packedRotated = false;
 };
 
 static std::shared_ptr<Mesh> CloneMeshGeometry(const std::shared_ptr<Mesh>& source) {
@@ -348,6 +568,7 @@ static std::shared_ptr<Mesh> CloneMeshGeometry(const std::shared_ptr<Mesh>& sour
     clone->setName(source->getName());
     clone->setVertices(source->getVertices());
     clone->setIndices(source->getIndices());
+    clone->setLods(source->getLods(), source->getLodIndices());
     clone->setSubmeshes(source->getSubmeshes());
     clone->setSkinWeights(source->getSkinWeights());
     clone->setDoubleSided(source->isDoubleSided());
@@ -425,8 +646,20 @@ struct CPUImageCacheEntry {
     std::vector<unsigned char> rgba;
 };
 
+// Called from every lightmap bake worker; entries are never erased, so returned pointers stay valid.
+// Lookups of loaded images share the lock, so workers sampling textures do not serialize on it.
 static const CPUImageCacheEntry* LoadCPUImage(const std::string& path) {
+    static std::shared_mutex cacheMutex;
     static std::unordered_map<std::string, CPUImageCacheEntry> cache;
+    {
+        std::shared_lock<std::shared_mutex> lock(cacheMutex);
+        auto it = cache.find(path);
+        if (it != cache.end()) {
+            return it->second.rgba.empty() ? nullptr : &it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(cacheMutex);
     auto it = cache.find(path);
     if (it != cache.end()) {
         return it->second.rgba.empty() ? nullptr : &it->second;
@@ -452,6 +685,20 @@ static const CPUImageCacheEntry* LoadCPUImage(const std::string& path) {
     return insertedIt->second.rgba.empty() ? nullptr : &insertedIt->second;
 }
 
+// 8-bit channel to float, linear or through SRGBToLinear, so sampling never calls pow per texel.
+static const float* CPUImageDecodeTable(bool srgb) {
+    static const auto tables = []() {
+        std::array<std::array<float, 256>, 2> decode{};
+        for (int value = 0; value < 256; ++value) {
+            const float unorm = static_cast<float>(value) / 255.0f;
+            decode[0][value] = unorm;
+            decode[1][value] = SRGBToLinear(Math::Vector3(unorm, unorm, unorm)).x;
+        }
+        return decode;
+    }();
+    return tables[srgb ? 1 : 0].data();
+}
+
 static Math::Vector3 SampleCPUImageRGB(const CPUImageCacheEntry* image,
                                        const Math::Vector2& uv,
                                        bool srgb) {
@@ -470,14 +717,11 @@ static Math::Vector3 SampleCPUImageRGB(const CPUImageCacheEntry* image,
     float tx = x - static_cast<float>(x0);
     float ty = y - static_cast<float>(y0);
 
+    const float* decode = CPUImageDecodeTable(srgb);
+    const unsigned char* rgba = image->rgba.data();
     auto readPixel = [&](int px, int py) {
-        size_t offset = (static_cast<size_t>(py) * static_cast<size_t>(image->width) + static_cast<size_t>(px)) * 4u;
-        Math::Vector3 color(
-            static_cast<float>(image->rgba[offset + 0]) / 255.0f,
-            static_cast<float>(image->rgba[offset + 1]) / 255.0f,
-            static_cast<float>(image->rgba[offset + 2]) / 255.0f
-        );
-        return srgb ? SRGBToLinear(color) : color;
+        const unsigned char* texel = rgba + (static_cast<size_t>(py) * static_cast<size_t>(image->width) + static_cast<size_t>(px)) * 4u;
+        return Math::Vector3(decode[texel[0]], decode[texel[1]], decode[texel[2]]);
     };
 
     Math::Vector3 c00 = readPixel(x0, y0);
@@ -627,7 +871,175 @@ static Math::Vector2 ProjectLightmapUV(const Math::Vector3& position, int axis,
     }
 }
 
-static std::shared_ptr<Mesh> CreateChartedLightmapMesh(const std::shared_ptr<Mesh>& source) {
+static void ResetSkylineAtlas(SkylineAtlasState& atlas, int width, int height) {
+    atlas.width = width;
+    atlas.height = height;
+    atlas.usedArea = 0;
+    atlas.skyline.assign(1, SkylineAtlasState::Segment{0, 0, width});
+}
+
+// Lowest y a rect can rest at with its left edge on skyline segment `index`, or -1 if it does
+// not fit there.
+static int FitSkylineRect(const SkylineAtlasState& atlas, size_t index, int rectWidth, int rectHeight) {
+    if (atlas.skyline[index].x + rectWidth > atlas.width) {
+        return -1;
+    }
+    int y = 0;
+    int remaining = rectWidth;
+    for (size_t segment = index; remaining > 0 && segment < atlas.skyline.size(); ++segment) {
+        y = std::max(y, atlas.skyline[segment].y);
+        if (y + rectHeight > atlas.height) {
+            return -1;
+        }
+        remaining -= atlas.skyline[segment].width;
+    }
+    return y;
+}
+
+static void PlaceSkylineRect(SkylineAtlasState& atlas, size_t index, int x, int y, int rectWidth, int rectHeight) {
+    auto& skyline = atlas.skyline;
+    skyline.insert(skyline.begin() + static_cast<std::ptrdiff_t>(index),
+                   SkylineAtlasState::Segment{x, y + rectHeight, rectWidth});
+    for (size_t segment = index + 1; segment < skyline.size();) {
+        const int previousEnd = skyline[segment - 1].x + skyline[segment - 1].width;
+        if (skyline[segment].x >= previousEnd) {
+            break;
+        }
+        const int shrink = previousEnd - skyline[segment].x;
+        skyline[segment].x += shrink;
+        skyline[segment].width -= shrink;
+        if (skyline[segment].width > 0) {
+            break;
+        }
+        skyline.erase(skyline.begin() + static_cast<std::ptrdiff_t>(segment));
+    }
+    for (size_t segment = 0; segment + 1 < skyline.size();) {
+        if (skyline[segment].y == skyline[segment + 1].y) {
+            skyline[segment].width += skyline[segment + 1].width;
+            skyline.erase(skyline.begin() + static_cast<std::ptrdiff_t>(segment + 1));
+        } else {
+            ++segment;
+        }
+    }
+    atlas.usedArea += static_cast<int64_t>(rectWidth) * static_cast<int64_t>(rectHeight);
+}
+
+// Bottom-left placement: the spot whose top edge ends lowest, leftmost on ties. With
+// allowRotation the rect may also go in turned by 90 degrees.
+static bool TryPackSkylineRect(SkylineAtlasState& atlas,
+                               int rectWidth,
+                               int rectHeight,
+                               bool allowRotation,
+                               int& outX,
+                               int& outY,
+                               bool& outRotated) {
+    int bestTop = std::numeric_limits<int>::max();
+    int bestX = std::numeric_limits<int>::max();
+    int bestY = 0;
+    size_t bestIndex = 0;
+    bool bestRotated = false;
+    bool found = false;
+    const int orientationCount = allowRotation && rectWidth != rectHeight ? 2 : 1;
+    for (int orientation = 0; orientation < orientationCount; ++orientation) {
+        const int width = orientation == 0 ? rectWidth : rectHeight;
+        const int height = orientation == 0 ? rectHeight : rectWidth;
+        for (size_t index = 0; index < atlas.skyline.size(); ++index) {
+            const int y = FitSkylineRect(atlas, index, width, height);
+            if (y < 0) {
+                continue;
+            }
+            const int x = atlas.skyline[index].x;
+            if (y + height < bestTop || (y + height == bestTop && x < bestX)) {
+                bestTop = y + height;
+                bestX = x;
+                bestY = y;
+                bestIndex = index;
+                bestRotated = orientation == 1;
+                found = true;
+            }
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    PlaceSkylineRect(atlas, bestIndex, bestX, bestY,
+                     bestRotated ? rectHeight : rectWidth,
+                     bestRotated ? rectWidth : rectHeight);
+    outX = bestX;
+    outY = bestY;
+    outRotated = bestRotated;
+    return true;
+}
+
+// Angle that turns the points' minimum-area bounding rectangle axis aligned (that rectangle has
+// a side on the convex hull), or 0 when it is within a few percent of the axis-aligned box, so
+// charts that already line up with the texel grid keep doing so.
+static float ComputeMinimumAreaBoundsAngle(std::vector<Math::Vector2> points) {
+    if (points.size() < 3) {
+        return 0.0f;
+    }
+    std::sort(points.begin(), points.end(), [](const Math::Vector2& a, const Math::Vector2& b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+    auto cross = [](const Math::Vector2& o, const Math::Vector2& a, const Math::Vector2& b) {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    };
+    std::vector<Math::Vector2> hull(points.size() * 2);
+    size_t hullSize = 0;
+    for (const Math::Vector2& point : points) {
+        while (hullSize >= 2 && cross(hull[hullSize - 2], hull[hullSize - 1], point) <= 0.0f) {
+            --hullSize;
+        }
+        hull[hullSize++] = point;
+    }
+    const size_t lowerSize = hullSize + 1;
+    for (size_t index = points.size() - 1; index-- > 0;) {
+        while (hullSize >= lowerSize && cross(hull[hullSize - 2], hull[hullSize - 1], points[index]) <= 0.0f) {
+            --hullSize;
+        }
+        hull[hullSize++] = points[index];
+    }
+    hull.resize(hullSize - 1);
+    if (hull.size() < 3) {
+        return 0.0f;
+    }
+
+    auto boundsArea = [&](const Math::Vector2& axisU) {
+        const Math::Vector2 axisV(-axisU.y, axisU.x);
+        float minU = std::numeric_limits<float>::max();
+        float maxU = std::numeric_limits<float>::lowest();
+        float minV = std::numeric_limits<float>::max();
+        float maxV = std::numeric_limits<float>::lowest();
+        for (const Math::Vector2& point : hull) {
+            minU = std::min(minU, point.dot(axisU));
+            maxU = std::max(maxU, point.dot(axisU));
+            minV = std::min(minV, point.dot(axisV));
+            maxV = std::max(maxV, point.dot(axisV));
+        }
+        return (maxU - minU) * (maxV - minV);
+    };
+    const float alignedArea = boundsArea(Math::Vector2(1.0f, 0.0f));
+    float bestArea = alignedArea;
+    float bestAngle = 0.0f;
+    for (size_t index = 0; index < hull.size(); ++index) {
+        Math::Vector2 edge = hull[(index + 1) % hull.size()] - hull[index];
+        const float length = edge.length();
+        if (length <= 1e-8f) {
+            continue;
+        }
+        edge /= length;
+        const float area = boundsArea(edge);
+        if (area < bestArea) {
+            bestArea = area;
+            bestAngle = -std::atan2(edge.y, edge.x);
+        }
+    }
+    return bestArea < alignedArea * 0.95f ? bestAngle : 0.0f;
+}
+
+// Splits the mesh into charts of connected triangles facing the same axis and packs them into a
+// square page. texelsPerUnit sizes the gutters between charts for the mesh at unit scale.
+static std::shared_ptr<Mesh> CreateChartedLightmapMesh(const std::shared_ptr<Mesh>& source, float texelsPerUnit) {
     if (!source) {
         return nullptr;
     }
@@ -645,6 +1057,7 @@ static std::shared_ptr<Mesh> CreateChartedLightmapMesh(const std::shared_ptr<Mes
     std::vector<int> triangleSigns(triangleCount, 1);
     std::unordered_map<uint64_t, std::vector<uint32_t>> edgeToTriangles;
     edgeToTriangles.reserve(triangleCount * 3);
+    float meshArea = 0.0f;
 
     for (size_t tri = 0; tri < triangleCount; ++tri) {
         uint32_t i0 = sourceIndices[tri * 3 + 0];
@@ -658,6 +1071,7 @@ static std::shared_ptr<Mesh> CreateChartedLightmapMesh(const std::shared_ptr<Mes
         const Math::Vector3& p1 = sourceVertices[i1].position;
         const Math::Vector3& p2 = sourceVertices[i2].position;
         Math::Vector3 faceNormal = (p1 - p0).cross(p2 - p0);
+        meshArea += faceNormal.length() * 0.5f;
         if (faceNormal.lengthSquared() <= Math::EPSILON) {
             faceNormal = sourceVertices[i0].normal + sourceVertices[i1].normal + sourceVertices[i2].normal;
         }
@@ -726,72 +1140,128 @@ static std::shared_ptr<Mesh> CreateChartedLightmapMesh(const std::shared_ptr<Mes
             }
         }
 
-        Math::Vector2 chartMin(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
-        Math::Vector2 chartMax(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
         for (uint32_t triIndex : chart.triangleIndices) {
             uint32_t baseIndex = triIndex * 3;
             for (int corner = 0; corner < 3; ++corner) {
                 uint32_t srcIndex = sourceIndices[baseIndex + corner];
-                auto projectedIt = chart.projectedUVs.find(srcIndex);
-                if (projectedIt == chart.projectedUVs.end()) {
+                if (chart.projectedUVs.find(srcIndex) == chart.projectedUVs.end()) {
                     Math::Vector2 projected = ProjectLightmapUV(sourceVertices[srcIndex].position, chart.axis, chart.axisSign);
-                    projectedIt = chart.projectedUVs.emplace(srcIndex, projected).first;
+                    chart.projectedUVs.emplace(srcIndex, projected);
                 }
-                chartMin = Math::Vector2::Min(chartMin, projectedIt->second);
-                chartMax = Math::Vector2::Max(chartMax, projectedIt->second);
             }
         }
+
+        // Charts slanted against the projection axes get turned to their tightest bounds.
+        std::vector<Math::Vector2> chartPoints;
+        chartPoints.reserve(chart.projectedUVs.size());
+        for (const auto& projected : chart.projectedUVs) {
+            chartPoints.push_back(projected.second);
+        }
+        const float chartAngle = ComputeMinimumAreaBoundsAngle(std::move(chartPoints));
+        const float cosAngle = std::cos(chartAngle);
+        const float sinAngle = std::sin(chartAngle);
+        Math::Vector2 chartMin(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        Math::Vector2 chartMax(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+        for (auto& projected : chart.projectedUVs) {
+            if (chartAngle != 0.0f) {
+                const Math::Vector2 uv = projected.second;
+                projected.second = Math::Vector2(uv.x * cosAngle - uv.y * sinAngle, uv.x * sinAngle + uv.y * cosAngle);
+            }
+            chartMin = Math::Vector2::Min(chartMin, projected.second);
+            chartMax = Math::Vector2::Max(chartMax, projected.second);
+        }
         chart.boundsMin = chartMin;
         chart.boundsMax = chartMax;
         charts.push_back(std::move(chart));
     }
 
+    // Charts are packed on a grid of cells, kChartPackCells across the square their bounds would
+    // fill. Gutters hold about two texels at the resolution EstimateLightmapInnerResolution gives
+    // the mesh at unit scale.
+    constexpr float kChartPackCells = 512.0f;
+    constexpr float kChartGutterTexels = 2.5f;
+    const float texelSize = std::min(std::sqrt(std::max(meshArea, 0.0f)) / 32.0f,
+                                     1.0f / std::max(texelsPerUnit, 1.0f));
+    const float gutter = texelSize * kChartGutterTexels;
+    float paddedChartArea = 0.0f;
+    for (const auto& chart : charts) {
+        Math::Vector2 size = chart.boundsMax - chart.boundsMin;
+        paddedChartArea += (size.x + gutter) * (size.y + gutter);
+    }
+    const float cellSize = std::sqrt(std::max(paddedChartArea, 1e-12f)) / kChartPackCells;
+
+    std::vector<int> chartCellWidths(charts.size());
+    std::vector<int> chartCellHeights(charts.size());
+    int64_t chartCellArea = 0;
+    int minimumPageWidth = 1;
+    for (size_t i = 0; i < charts.size(); ++i) {
+        Math::Vector2 size = charts[i].boundsMax - charts[i].boundsMin;
+        chartCellWidths[i] = std::max(1, static_cast<int>(std::ceil((size.x + gutter) / cellSize)));
+        chartCellHeights[i] = std::max(1, static_cast<int>(std::ceil((size.y + gutter) / cellSize)));
+        chartCellArea += static_cast<int64_t>(chartCellWidths[i]) * static_cast<int64_t>(chartCellHeights[i]);
+        minimumPageWidth = std::max(minimumPageWidth, std::min(chartCellWidths[i], chartCellHeights[i]));
+    }
+
     std::vector<size_t> chartOrder(charts.size());
     for (size_t i = 0; i < charts.size(); ++i) {
         chartOrder[i] = i;
     }
     std::sort(chartOrder.begin(), chartOrder.end(), [&](size_t a, size_t b) {
-        Math::Vector2 sizeA = charts[a].boundsMax - charts[a].boundsMin;
-        Math::Vector2 sizeB = charts[b].boundsMax - charts[b].boundsMin;
-        float areaA = sizeA.x * sizeA.y;
-        float areaB = sizeB.x * sizeB.y;
-        return areaA > areaB;
+        const int longA = std::max(chartCellWidths[a], chartCellHeights[a]);
+        const int longB = std::max(chartCellWidths[b], chartCellHeights[b]);
+        if (longA != longB) {
+            return longA > longB;
+        }
+        return chartCellWidths[a] * chartCellHeights[a] > chartCellWidths[b] * chartCellHeights[b];
     });
 
-    float packedCursorX = 0.0f;
-    float packedCursorY = 0.0f;
-    float packedRowHeight = 0.0f;
-    float packedWidthLimit = 0.0f;
-    for (size_t chartIndex : chartOrder) {
-        const auto& chart = charts[chartIndex];
-        Math::Vector2 size = chart.boundsMax - chart.boundsMin;
-        packedWidthLimit += std::max(size.x, 0.001f) * std::max(size.y, 0.001f);
-    }
-    packedWidthLimit = std::max(std::sqrt(std::max(packedWidthLimit, 0.0001f)), 1.0f);
-
-    float packedPageWidth = 0.0f;
-    float packedPageHeight = 0.0f;
-    for (size_t chartIndex : chartOrder) {
-        auto& chart = charts[chartIndex];
-        Math::Vector2 size = chart.boundsMax - chart.boundsMin;
-        size.x = std::max(size.x, 0.001f);
-        size.y = std::max(size.y, 0.001f);
-        float chartPadding = std::max(std::max(size.x, size.y) * 0.05f, 0.01f);
-        if (packedCursorX > 0.0f && packedCursorX + size.x + chartPadding > packedWidthLimit) {
-            packedCursorX = 0.0f;
-            packedCursorY += packedRowHeight;
-            packedRowHeight = 0.0f;
+    // The page is square, so a few page widths are tried and the one needing the smallest
+    // square wins; the first is enough for most meshes.
+    const float idealSide = std::sqrt(static_cast<float>(chartCellArea));
+    int pageSideCells = std::numeric_limits<int>::max();
+    struct ChartPlacement {
+        int x = 0;
+        int y = 0;
+        bool rotated = false;
+    };
+    std::vector<ChartPlacement> bestPlacements(charts.size());
+    for (float widthFactor : {1.0f, 1.05f, 1.12f, 1.25f}) {
+        const int pageWidth = std::max(minimumPageWidth, static_cast<int>(std::ceil(idealSide * widthFactor)));
+        if (pageWidth >= pageSideCells) {
+            break;
+        }
+        SkylineAtlasState page;
+        ResetSkylineAtlas(page, pageWidth, std::numeric_limits<int>::max() / 2);
+        int pageHeight = 0;
+        for (size_t chartIndex : chartOrder) {
+            auto& chart = charts[chartIndex];
+            int packedX = 0;
+            int packedY = 0;
+            bool rotated = false;
+            TryPackSkylineRect(page, chartCellWidths[chartIndex], chartCellHeights[chartIndex], true,
+                               packedX, packedY, rotated);
+            chart.packedX = packedX;
+            chart.packedY = packedY;
+            chart.packedRotated = rotated;
+            pageHeight = std::max(pageHeight, packedY + (rotated ? chartCellWidths[chartIndex] : chartCellHeights[chartIndex]));
+        }
+        const int side = std::max(pageWidth, pageHeight);
+        if (side < pageSideCells) {
+            pageSideCells = side;
+            for (size_t i = 0; i < charts.size(); ++i) {
+                bestPlacements[i] = {charts[i].packedX, charts[i].packedY, charts[i].packedRotated};
+            }
+        }
+        if (static_cast<float>(side) <= idealSide * 1.06f) {
+            break;
         }
-        chart.packedOffset = Math::Vector2(packedCursorX + chartPadding * 0.5f,
-                                           packedCursorY + chartPadding * 0.5f);
-        packedCursorX += size.x + chartPadding;
-        packedRowHeight = std::max(packedRowHeight, size.y + chartPadding);
-        packedPageWidth = std::max(packedPageWidth, packedCursorX);
-        packedPageHeight = std::max(packedPageHeight, packedCursorY + packedRowHeight);
     }
-
-    packedPageWidth = std::max(packedPageWidth, 1.0f);
-    packedPageHeight = std::max(packedPageHeight, 1.0f);
+    for (size_t i = 0; i < charts.size(); ++i) {
+        charts[i].packedX = bestPlacements[i].x;
+        charts[i].packedY = bestPlacements[i].y;
+        charts[i].packedRotated = bestPlacements[i].rotated;
+    }
+    const float pageSide = static_cast<float>(pageSideCells) * cellSize;
 
     auto clone = std::make_shared<Mesh>();
     clone->setName(source->getName());
@@ -825,9 +1295,13 @@ static std::shared_ptr<Mesh> CreateChartedLightmapMesh(const std::shared_ptr<Mes
                 auto remapIt = remappedVertices.find(remapKey);
                 if (remapIt == remappedVertices.end()) {
                     Vertex vertex = sourceVertices[srcIndex];
-                    Math::Vector2 projected = chart.projectedUVs.at(srcIndex);
-                    Math::Vector2 local = projected - chart.boundsMin + chart.packedOffset;
-                    vertex.texCoord1 = Math::Vector2(local.x / packedPageWidth, local.y / packedPageHeight);
+                    Math::Vector2 local = chart.projectedUVs.at(srcIndex) - chart.boundsMin;
+                    if (chart.packedRotated) {
+                        local = Math::Vector2(chart.boundsMax.y - chart.boundsMin.y - local.y, local.x);
+                    }
+                    Math::Vector2 paged(static_cast<float>(chart.packedX) * cellSize + gutter * 0.5f + local.x,
+                                        static_cast<float>(chart.packedY) * cellSize + gutter * 0.5f + local.y);
+                    vertex.texCoord1 = paged / pageSide;
                     uint32_t newIndex = static_cast<uint32_t>(newVertices.size());
                     newVertices.push_back(vertex);
                     remappedVertices.emplace(remapKey, newIndex);
@@ -853,18 +1327,17 @@ static std::shared_ptr<Mesh> CreateChartedLightmapMesh(const std::shared_ptr<Mes
     return clone;
 }
 
-static std::shared_ptr<Mesh> CreateFallbackLightmapMesh(const std::shared_ptr<Mesh>& source) {
-    return CreateChartedLightmapMesh(source);
+static std::shared_ptr<Mesh> CreateFallbackLightmapMesh(const std::shared_ptr<Mesh>& source, float texelsPerUnit) {
+    return CreateChartedLightmapMesh(source, texelsPerUnit);
 }
 
-static float ComputeWorldSurfaceArea(const Mesh& mesh, const Transform& transform) {
+static float ComputeWorldSurfaceArea(const Mesh& mesh, const Math::Matrix4x4& world) {
     const auto& vertices = mesh.getVertices();
     const auto& indices = mesh.getIndices();
     if (vertices.empty() || indices.size() < 3) {
         return 0.0f;
     }
 
-    Math::Matrix4x4 world = transform.getWorldMatrix();
     float area = 0.0f;
     for (size_t i = 0; i + 2 < indices.size(); i += 3) {
         uint32_t i0 = indices[i];
@@ -896,33 +1369,12 @@ static int EstimateLightmapInnerResolution(float surfaceAreaWS, const SceneStati
     return std::min(resolution, maxInner);
 }
 
-static bool TryPackShelfRect(ShelfAtlasState& atlas, int rectWidth, int rectHeight, int& outX, int& outY) {
-    if (rectWidth > atlas.width || rectHeight > atlas.height) {
-        return false;
-    }
-
-    if (atlas.cursorX + rectWidth > atlas.width) {
-        atlas.cursorX = 0;
-        atlas.cursorY += atlas.rowHeight;
-        atlas.rowHeight = 0;
-    }
-    if (atlas.cursorY + rectHeight > atlas.height) {
-        return false;
-    }
-
-    outX = atlas.cursorX;
-    outY = atlas.cursorY;
-    atlas.cursorX += rectWidth;
-    atlas.rowHeight = std::max(atlas.rowHeight, rectHeight);
-    return true;
-}
-
 static bool CanPackStaticLightingCandidates(const std::vector<StaticLightingLayoutCandidate>& candidates,
                                             int atlasSize,
                                             int padding,
                                             int maxAtlasCount,
                                             float resolutionScale) {
-    std::vector<ShelfAtlasState> atlases;
+    std::vector<SkylineAtlasState> atlases;
     atlases.reserve(std::max(maxAtlasCount, 1));
 
     for (const auto& candidate : candidates) {
@@ -935,9 +1387,10 @@ static bool CanPackStaticLightingCandidates(const std::vector<StaticLightingLayo
 
         int packedX = 0;
         int packedY = 0;
+        bool packedRotated = false;
         bool packed = false;
         for (auto& atlas : atlases) {
-            if (TryPackShelfRect(atlas, slotResolution, slotResolution, packedX, packedY)) {
+            if (TryPackSkylineRect(atlas, slotResolution, slotResolution, false, packedX, packedY, packedRotated)) {
                 packed = true;
                 break;
             }
@@ -951,11 +1404,10 @@ static bool CanPackStaticLightingCandidates(const std::vector<StaticLightingLayo
             return false;
         }
 
-        ShelfAtlasState atlas;
+        SkylineAtlasState atlas;
         atlas.atlasIndex = static_cast<int>(atlases.size());
-        atlas.width = atlasSize;
-        atlas.height = atlasSize;
-        if (!TryPackShelfRect(atlas, slotResolution, slotResolution, packedX, packedY)) {
+        ResetSkylineAtlas(atlas, atlasSize, atlasSize);
+        if (!TryPackSkylineRect(atlas, slotResolution, slotResolution, false, packedX, packedY, packedRotated)) {
             return false;
         }
         atlases.push_back(atlas);
@@ -1025,66 +1477,6 @@ static bool ComputeBarycentrics(const Math::Vector2& p,
     return u >= kEpsilon && v >= kEpsilon && w >= kEpsilon;
 }
 
-static Math::Vector3 ClosestPointOnTriangle(const Math::Vector3& p,
-                                            const Math::Vector3& a,
-                                            const Math::Vector3& b,
-                                            const Math::Vector3& c,
-                                            Math::Vector3& outBary) {
-    Math::Vector3 ab = b - a;
-    Math::Vector3 ac = c - a;
-    Math::Vector3 ap = p - a;
-    float d1 = ab.dot(ap);
-    float d2 = ac.dot(ap);
-    if (d1 <= 0.0f && d2 <= 0.0f) {
-        outBary = Math::Vector3(1.0f, 0.0f, 0.0f);
-        return a;
-    }
-
-    Math::Vector3 bp = p - b;
-    float d3 = ab.dot(bp);
-    float d4 = ac.dot(bp);
-    if (d3 >= 0.0f && d4 <= d3) {
-        outBary = Math::Vector3(0.0f, 1.0f, 0.0f);
-        return b;
-    }
-
-    float vc = d1 * d4 - d3 * d2;
-    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
-        float v = d1 / std::max(d1 - d3, Math::EPSILON);
-        outBary = Math::Vector3(1.0f - v, v, 0.0f);
-        return a + ab * v;
-    }
-
-    Math::Vector3 cp = p - c;
-    float d5 = ab.dot(cp);
-    float d6 = ac.dot(cp);
-    if (d6 >= 0.0f && d5 <= d6) {
-        outBary = Math::Vector3(0.0f, 0.0f, 1.0f);
-        return c;
-    }
-
-    float vb = d5 * d2 - d1 * d6;
-    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
-        float w = d2 / std::max(d2 - d6, Math::EPSILON);
-        outBary = Math::Vector3(1.0f - w, 0.0f, w);
-        return a + ac * w;
-    }
-
-    float va = d3 * d6 - d5 * d4;
-    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
-        float denom = std::max((d4 - d3) + (d5 - d6), Math::EPSILON);
-        float w = (d4 - d3) / denom;
-        outBary = Math::Vector3(0.0f, 1.0f - w, w);
-        return b + (c - b) * w;
-    }
-
-    float denom = 1.0f / std::max(va + vb + vc, Math::EPSILON);
-    float v = vb * denom;
-    float w = vc * denom;
-    outBary = Math::Vector3(1.0f - v - w, v, w);
-    return a + ab * v + ac * w;
-}
-
 static int ResolveTriangleMaterialIndex(const Mesh& mesh, size_t triangleFirstIndex) {
     const auto& submeshes = mesh.getSubmeshes();
     for (const Submesh& submesh : submeshes) {
@@ -1095,67 +1487,6 @@ static int ResolveTriangleMaterialIndex(const Mesh& mesh, size_t triangleFirstIn
     return 0;
 }
 
-static bool FindClosestSurfaceSample(Entity* entity,
-                                     const Math::Vector3& pointWS,
-                                     SurfaceSample& outSample) {
-    outSample = SurfaceSample();
-    if (!entity) {
-        return false;
-    }
-
-    MeshRenderer* renderer = entity->getComponent<MeshRenderer>();
-    if (!renderer) {
-        return false;
-    }
-    std::shared_ptr<Mesh> mesh = renderer->getMesh();
-    if (!mesh || mesh->getVertices().empty() || mesh->getIndices().size() < 3) {
-        return false;
-    }
-
-    const auto& vertices = mesh->getVertices();
-    const auto& indices = mesh->getIndices();
-    Math::Matrix4x4 worldMatrix = entity->getTransform()->getWorldMatrix();
-    Math::Matrix4x4 normalMatrix = worldMatrix.normalMatrix();
-
-    for (size_t tri = 0; tri + 2 < indices.size(); tri += 3) {
-        uint32_t i0 = indices[tri + 0];
-        uint32_t i1 = indices[tri + 1];
-        uint32_t i2 = indices[tri + 2];
-        if (i0 >= vertices.size() || i1 >= vertices.size() || i2 >= vertices.size()) {
-            continue;
-        }
-
-        const Vertex& v0 = vertices[i0];
-        const Vertex& v1 = vertices[i1];
-        const Vertex& v2 = vertices[i2];
-        Math::Vector3 p0 = worldMatrix.transformPoint(v0.position);
-        Math::Vector3 p1 = worldMatrix.transformPoint(v1.position);
-        Math::Vector3 p2 = worldMatrix.transformPoint(v2.position);
-
-        Math::Vector3 bary;
-        Math::Vector3 closest = ClosestPointOnTriangle(pointWS, p0, p1, p2, bary);
-        float distanceSq = (closest - pointWS).lengthSquared();
-        if (distanceSq >= outSample.distanceSq) {
-            continue;
-        }
-
-        Math::Vector3 localNormal = (v0.normal * bary.x + v1.normal * bary.y + v2.normal * bary.z).normalized();
-        Math::Vector3 worldNormal = normalMatrix.transformDirection(localNormal).normalized();
-        if (worldNormal.lengthSquared() <= Math::EPSILON) {
-            worldNormal = (p1 - p0).cross(p2 - p0).normalized();
-        }
-
-        outSample.valid = true;
-        outSample.positionWS = closest;
-        outSample.normalWS = worldNormal.lengthSquared() > Math::EPSILON ? worldNormal : Math::Vector3::Up;
-        outSample.uv = v0.texCoord * bary.x + v1.texCoord * bary.y + v2.texCoord * bary.z;
-        outSample.materialIndex = ResolveTriangleMaterialIndex(*mesh, tri);
-        outSample.distanceSq = distanceSq;
-    }
-
-    return outSample.valid;
-}
-
 static void ResolveMaterialSample(std::shared_ptr<Material> material,
                                   const Math::Vector2& uv,
                                   Math::Vector3& outAlbedo,
@@ -1376,29 +1707,190 @@ static std::vector<EmissiveTriangleSurface> BuildEmissiveTriangleSurfaces(Scene*
     return surfaces;
 }
 
-static bool SampleEmissiveTriangleSurface(const std::vector<EmissiveTriangleSurface>& surfaces,
-                                          uint32_t sampleSeed,
-                                          int sampleIndex,
-                                          EmissiveSurfaceSample& outSample) {
-    outSample = EmissiveSurfaceSample();
-    if (surfaces.empty()) {
-        return false;
+static void BuildEmissiveAliasTable(EmissiveLightSet& lights) {
+    const size_t count = lights.surfaces.size();
+    lights.aliasTable.assign(count, EmissiveAliasEntry());
+    if (count == 0 || lights.totalWeight <= 0.0f) {
+        return;
     }
 
-    float totalWeight = std::max(surfaces.back().cumulativeWeight, 1e-5f);
-    float selection = HashToUnitFloat(sampleSeed + static_cast<uint32_t>(sampleIndex * 92821 + 17)) * totalWeight;
-    auto it = std::lower_bound(
-        surfaces.begin(),
-        surfaces.end(),
-        selection,
-        [](const EmissiveTriangleSurface& surface, float value) {
-            return surface.cumulativeWeight < value;
+    std::vector<float> scaled(count);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+    for (size_t i = 0; i < count; ++i) {
+        scaled[i] = lights.surfaces[i].weight * static_cast<float>(count) / lights.totalWeight;
+        (scaled[i] < 1.0f ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+    while (!small.empty() && !large.empty()) {
+        const uint32_t less = small.back();
+        small.pop_back();
+        const uint32_t more = large.back();
+        lights.aliasTable[less].probability = scaled[less];
+        lights.aliasTable[less].alias = more;
+        scaled[more] = (scaled[more] + scaled[less]) - 1.0f;
+        if (scaled[more] < 1.0f) {
+            large.pop_back();
+            small.push_back(more);
         }
-    );
-    if (it == surfaces.end()) {
-        it = surfaces.end() - 1;
     }
+    // Whatever is left is 1 up to rounding.
+    for (uint32_t index : small) {
+        lights.aliasTable[index] = EmissiveAliasEntry{1.0f, index};
+    }
+    for (uint32_t index : large) {
+        lights.aliasTable[index] = EmissiveAliasEntry{1.0f, index};
+    }
+}
+
+// Smallest cone holding both; an angle of pi or more is the whole sphere.
+static void MergeEmissiveCones(Math::Vector3& axis, float& angle, const Math::Vector3& otherAxis, float otherAngle) {
+    if (angle >= Math::PI || otherAngle >= Math::PI) {
+        angle = Math::PI;
+        return;
+    }
+    const float between = std::acos(Math::Clamp(axis.dot(otherAxis), -1.0f, 1.0f));
+    if (between + otherAngle <= angle) {
+        return;
+    }
+    if (between + angle <= otherAngle) {
+        axis = otherAxis;
+        angle = otherAngle;
+        return;
+    }
+    const float merged = 0.5f * (angle + between + otherAngle);
+    if (merged >= Math::PI) {
+        angle = Math::PI;
+        return;
+    }
+    const Math::Vector3 ortho = otherAxis - axis * axis.dot(otherAxis);
+    if (ortho.lengthSquared() > 1e-12f) {
+        const float rotation = merged - angle;
+        axis = (axis * std::cos(rotation) + ortho.normalized() * std::sin(rotation)).normalized();
+    }
+    angle = merged;
+}
+
+static void BuildEmissiveLightTree(EmissiveLightSet& lights) {
+    lights.lightTree.clear();
+    const size_t count = lights.surfaces.size();
+    if (count < kEmissiveLightTreeMinSurfaces) {
+        return;
+    }
+
+    std::vector<uint32_t> order(count);
+    std::vector<Math::Vector3> centroids(count);
+    for (size_t i = 0; i < count; ++i) {
+        const EmissiveTriangleSurface& surface = lights.surfaces[i];
+        order[i] = static_cast<uint32_t>(i);
+        centroids[i] = (surface.p0 + surface.p1 + surface.p2) / 3.0f;
+    }
+    lights.lightTree.reserve(count * 2 - 1);
+    lights.lightTree.emplace_back();
+
+    // Median splits along the widest centroid axis; children are written as pairs.
+    std::function<void(uint32_t, size_t, size_t)> build = [&](uint32_t nodeIndex, size_t begin, size_t end) {
+        if (end - begin == 1) {
+            const EmissiveTriangleSurface& surface = lights.surfaces[order[begin]];
+            EmissiveLightNode& node = lights.lightTree[nodeIndex];
+            node.boundsMin = Math::Vector3::Min(Math::Vector3::Min(surface.p0, surface.p1), surface.p2);
+            node.boundsMax = Math::Vector3::Max(Math::Vector3::Max(surface.p0, surface.p1), surface.p2);
+            // The cone bounds the interpolated normals the sample's emitter cosine uses.
+            Math::Vector3 normal = (surface.p1 - surface.p0).cross(surface.p2 - surface.p0).normalized();
+            float angle = 0.0f;
+            for (const Math::Vector3* vertexNormal : {&surface.n0, &surface.n1, &surface.n2}) {
+                angle = std::max(angle, std::acos(Math::Clamp(normal.dot(*vertexNormal), -1.0f, 1.0f)));
+            }
+            node.coneAxis = normal;
+            node.coneAngle = surface.twoSided ? Math::PI : angle;
+            node.weight = surface.weight;
+            node.child = order[begin];
+            node.leaf = true;
+            return;
+        }
+
+        Math::Vector3 centroidMin = centroids[order[begin]];
+        Math::Vector3 centroidMax = centroidMin;
+        for (size_t i = begin + 1; i < end; ++i) {
+            centroidMin = Math::Vector3::Min(centroidMin, centroids[order[i]]);
+            centroidMax = Math::Vector3::Max(centroidMax, centroids[order[i]]);
+        }
+        const Math::Vector3 extent = centroidMax - centroidMin;
+        const int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+        const size_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + static_cast<std::ptrdiff_t>(begin),
+                         order.begin() + static_cast<std::ptrdiff_t>(middle),
+                         order.begin() + static_cast<std::ptrdiff_t>(end),
+                         [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+        const uint32_t left = static_cast<uint32_t>(lights.lightTree.size());
+        lights.lightTree.emplace_back();
+        lights.lightTree.emplace_back();
+        build(left, begin, middle);
+        build(left + 1, middle, end);
+
+        const EmissiveLightNode& a = lights.lightTree[left];
+        const EmissiveLightNode& b = lights.lightTree[left + 1];
+        EmissiveLightNode node;
+        node.boundsMin = Math::Vector3::Min(a.boundsMin, b.boundsMin);
+        node.boundsMax = Math::Vector3::Max(a.boundsMax, b.boundsMax);
+        node.coneAxis = a.coneAxis;
+        node.coneAngle = a.coneAngle;
+        MergeEmissiveCones(node.coneAxis, node.coneAngle, b.coneAxis, b.coneAngle);
+        node.weight = a.weight + b.weight;
+        node.child = left;
+        lights.lightTree[nodeIndex] = node;
+    };
+    build(0, 0, count);
+}
+
+static EmissiveLightSet BuildEmissiveLightSet(Scene* scene) {
+    EmissiveLightSet lights;
+    lights.surfaces = BuildEmissiveTriangleSurfaces(scene);
+    lights.totalWeight = lights.surfaces.empty() ? 0.0f : lights.surfaces.back().cumulativeWeight;
+    BuildEmissiveAliasTable(lights);
+    BuildEmissiveLightTree(lights);
+    return lights;
+}
+
+// Upper bound of what a light tree node sends to a point with the given normal: its weight over
+// the squared distance, scaled by the best emitter and receiver cosines its bounds allow.
+static float EmissiveLightNodeImportance(const EmissiveLightNode& node,
+                                         const Math::Vector3& positionWS,
+                                         const Math::Vector3& normalWS) {
+    const Math::Vector3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+    const float radiusSq = (node.boundsMax - center).lengthSquared();
+    const Math::Vector3 toPoint = positionWS - center;
+    const float distanceSq = toPoint.lengthSquared();
+    if (distanceSq <= radiusSq) {
+        return node.weight / std::max(radiusSq, 1e-4f);
+    }
+
+    const float distance = std::sqrt(distanceSq);
+    const Math::Vector3 direction = toPoint / distance;
+    const float boundsAngle = std::asin(Math::Clamp(std::sqrt(radiusSq) / distance, 0.0f, 1.0f));
+    float emitterCos = 1.0f;
+    if (node.coneAngle < Math::PI) {
+        const float angle = std::acos(Math::Clamp(node.coneAxis.dot(direction), -1.0f, 1.0f));
+        const float reduced = std::max(0.0f, angle - node.coneAngle - boundsAngle);
+        if (reduced >= Math::HALF_PI) {
+            return 0.0f;
+        }
+        emitterCos = std::cos(reduced);
+    }
+    const float receiverAngle = std::acos(Math::Clamp(normalWS.dot(-direction), -1.0f, 1.0f));
+    const float receiverReduced = std::max(0.0f, receiverAngle - boundsAngle);
+    if (receiverReduced >= Math::HALF_PI) {
+        return 0.0f;
+    }
+    return node.weight * emitterCos * std::cos(receiverReduced) / distanceSq;
+}
 
+// Point on the chosen triangle, with the triangle's selection probability turned into an area pdf.
+static bool SampleEmissiveTrianglePoint(const EmissiveTriangleSurface& surface,
+                                        float selectionPdf,
+                                        uint32_t sampleSeed,
+                                        int sampleIndex,
+                                        EmissiveSurfaceSample& outSample) {
     Math::Vector2 random = Random2D(
         sampleSeed + static_cast<uint32_t>(sampleIndex * 2 + 101),
         sampleSeed + static_cast<uint32_t>(sampleIndex * 2 + 102)
@@ -1408,15 +1900,15 @@ static bool SampleEmissiveTriangleSurface(const std::vector<EmissiveTriangleSurf
     float bary1 = sqrtU * (1.0f - random.y);
     float bary2 = 1.0f - bary0 - bary1;
 
-    Math::Vector3 positionWS = it->p0 * bary0 + it->p1 * bary1 + it->p2 * bary2;
-    Math::Vector3 normalWS = (it->n0 * bary0 + it->n1 * bary1 + it->n2 * bary2).normalized();
+    Math::Vector3 positionWS = surface.p0 * bary0 + surface.p1 * bary1 + surface.p2 * bary2;
+    Math::Vector3 normalWS = (surface.n0 * bary0 + surface.n1 * bary1 + surface.n2 * bary2).normalized();
     if (normalWS.lengthSquared() <= Math::EPSILON) {
-        normalWS = (it->p1 - it->p0).cross(it->p2 - it->p0).normalized();
+        normalWS = (surface.p1 - surface.p0).cross(surface.p2 - surface.p0).normalized();
     }
-    Math::Vector2 uv = it->uv0 * bary0 + it->uv1 * bary1 + it->uv2 * bary2;
+    Math::Vector2 uv = surface.uv0 * bary0 + surface.uv1 * bary1 + surface.uv2 * bary2;
 
-    std::shared_ptr<Material> material = it->renderer
-        ? it->renderer->getMaterial(static_cast<uint32_t>(std::max(it->materialIndex, 0)))
+    std::shared_ptr<Material> material = surface.renderer
+        ? surface.renderer->getMaterial(static_cast<uint32_t>(std::max(surface.materialIndex, 0)))
         : nullptr;
     Math::Vector3 sampledAlbedo;
     Math::Vector3 sampledEmission;
@@ -1426,34 +1918,95 @@ static bool SampleEmissiveTriangleSurface(const std::vector<EmissiveTriangleSurf
         return false;
     }
 
-    outSample.surface = &(*it);
+    outSample.surface = &surface;
     outSample.positionWS = positionWS;
     outSample.normalWS = normalWS.lengthSquared() > Math::EPSILON ? normalWS : Math::Vector3::Up;
     outSample.uv = uv;
     outSample.emission = sampledEmission;
-    outSample.pdfArea = std::max((it->weight / totalWeight) / std::max(it->area, 1e-5f), 1e-5f);
-    outSample.twoSided = it->twoSided;
+    outSample.pdfArea = std::max(selectionPdf / std::max(surface.area, 1e-5f), 1e-5f);
+    outSample.twoSided = surface.twoSided;
     return true;
 }
 
-static EmissiveLightingEstimate EstimateEmissiveSurfaceLighting(Scene* scene,
-                                                                const std::vector<EmissiveTriangleSurface>& surfaces,
-                                                                const Math::Vector3& positionWS,
-                                                                const Math::Vector3& normalWS,
-                                                                uint32_t sampleSeed,
-                                                                int sampleCount) {
-    EmissiveLightingEstimate estimate;
-    if (!scene || surfaces.empty()) {
-        return estimate;
+// Picks a surface by weight through the alias table.
+static bool SampleEmissiveTriangleSurface(const EmissiveLightSet& lights,
+                                          uint32_t sampleSeed,
+                                          int sampleIndex,
+                                          EmissiveSurfaceSample& outSample) {
+    outSample = EmissiveSurfaceSample();
+    if (lights.empty() || lights.aliasTable.size() != lights.surfaces.size()) {
+        return false;
     }
 
-    PhysicsWorld* physicsWorld = scene->getPhysicsWorld();
-    sampleCount = std::max(1, std::min(16, sampleCount));
-    Math::Vector3 origin = positionWS + normalWS * 0.0035f;
+    const size_t count = lights.surfaces.size();
+    float selection = HashToUnitFloat(sampleSeed + static_cast<uint32_t>(sampleIndex * 92821 + 17)) * static_cast<float>(count);
+    size_t slot = std::min(count - 1, static_cast<size_t>(selection));
+    const EmissiveAliasEntry& entry = lights.aliasTable[slot];
+    const size_t index = (selection - static_cast<float>(slot) < entry.probability) ? slot : entry.alias;
+    const EmissiveTriangleSurface& surface = lights.surfaces[index];
+    const float selectionPdf = surface.weight / std::max(lights.totalWeight, 1e-5f);
+    return SampleEmissiveTrianglePoint(surface, selectionPdf, sampleSeed, sampleIndex, outSample);
+}
+
+// Walks the light tree from the root, taking each child in proportion to its importance at the
+// shading point, so nearby and facing emitters get the samples.
+static bool SampleEmissiveLightTree(const EmissiveLightSet& lights,
+                                    const Math::Vector3& positionWS,
+                                    const Math::Vector3& normalWS,
+                                    uint32_t sampleSeed,
+                                    int sampleIndex,
+                                    EmissiveSurfaceSample& outSample) {
+    outSample = EmissiveSurfaceSample();
+    if (lights.lightTree.empty()) {
+        return false;
+    }
+
+    float selection = HashToUnitFloat(sampleSeed + static_cast<uint32_t>(sampleIndex * 92821 + 17));
+    float selectionPdf = 1.0f;
+    uint32_t nodeIndex = 0;
+    while (!lights.lightTree[nodeIndex].leaf) {
+        const uint32_t left = lights.lightTree[nodeIndex].child;
+        const float leftImportance = EmissiveLightNodeImportance(lights.lightTree[left], positionWS, normalWS);
+        const float rightImportance = EmissiveLightNodeImportance(lights.lightTree[left + 1], positionWS, normalWS);
+        const float total = leftImportance + rightImportance;
+        if (total <= 0.0f) {
+            return false;
+        }
+        const float leftProbability = leftImportance / total;
+        if (selection < leftProbability) {
+            selection = std::min(selection / leftProbability, 0.99999994f);
+            selectionPdf *= leftProbability;
+            nodeIndex = left;
+        } else {
+            selection = std::min((selection - leftProbability) / (1.0f - leftProbability), 0.99999994f);
+            selectionPdf *= 1.0f - leftProbability;
+            nodeIndex = left + 1;
+        }
+    }
+    const EmissiveTriangleSurface& surface = lights.surfaces[lights.lightTree[nodeIndex].child];
+    return SampleEmissiveTrianglePoint(surface, selectionPdf, sampleSeed, sampleIndex, outSample);
+}
+
+static EmissiveLightingEstimate EstimateEmissiveSurfaceLighting(Scene* scene,
+                                                                const EmissiveLightSet& surfaces,
+                                                                const Math::Vector3& positionWS,
+                                                                const Math::Vector3& normalWS,
+                                                                uint32_t sampleSeed,
+                                                                int sampleCount) {
+    EmissiveLightingEstimate estimate;
+    if (!scene || surfaces.empty()) {
+        return estimate;
+    }
+
+    sampleCount = std::max(1, std::min(16, sampleCount));
+    Math::Vector3 origin = positionWS + normalWS * 0.0035f;
 
     for (int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex) {
         EmissiveSurfaceSample sample;
-        if (!SampleEmissiveTriangleSurface(surfaces, sampleSeed, sampleIndex, sample)) {
+        const bool sampled = surfaces.lightTree.empty()
+            ? SampleEmissiveTriangleSurface(surfaces, sampleSeed, sampleIndex, sample)
+            : SampleEmissiveLightTree(surfaces, origin, normalWS, sampleSeed, sampleIndex, sample);
+        if (!sampled) {
             continue;
         }
 
@@ -1476,18 +2029,9 @@ static EmissiveLightingEstimate EstimateEmissiveSurfaceLighting(Scene* scene,
             continue;
         }
 
-        if (physicsWorld) {
-            constexpr float kHitTolerance = 0.01f;
-            PhysicsRaycastHit hit;
-            if (physicsWorld->raycast(origin,
-                                      lightDir,
-                                      std::max(0.0f, distance - kHitTolerance),
-                                      hit,
-                                      PhysicsWorld::kAllLayersMask,
-                                      false,
-                                      nullptr)) {
-                continue;
-            }
+        constexpr float kHitTolerance = 0.01f;
+        if (g_LightBakeBVH && g_LightBakeBVH->occluded(origin, lightDir, std::max(0.0f, distance - kHitTolerance))) {
+            continue;
         }
 
         float geometry = (nDotL * emitterCos) / std::max(distanceSq, 0.01f);
@@ -1626,8 +2170,7 @@ static bool IsDirectLightVisible(Scene* scene,
         return true;
     }
 
-    PhysicsWorld* physicsWorld = scene->getPhysicsWorld();
-    if (!physicsWorld) {
+    if (!g_LightBakeBVH) {
         return true;
     }
 
@@ -1666,22 +2209,12 @@ static bool IsDirectLightVisible(Scene* scene,
         }
     }
 
+    // Hits within the tolerance of the origin are the receiver itself.
+    maxDistance -= hitTolerance;
     if (maxDistance <= Math::EPSILON) {
         return true;
     }
-
-    PhysicsRaycastHit hit;
-    if (!physicsWorld->raycast(origin,
-                               rayDirection,
-                               maxDistance,
-                               hit,
-                               PhysicsWorld::kAllLayersMask,
-                               false,
-                               nullptr)) {
-        return true;
-    }
-
-    return hit.distance <= hitTolerance;
+    return !g_LightBakeBVH->occluded(origin + rayDirection * hitTolerance, rayDirection, maxDistance);
 }
 
 static Math::Vector3 SampleBakeEnvironmentRadiance(const SceneEnvironmentSettings& environment,
@@ -1726,7 +2259,7 @@ static Math::Vector3 SampleCosineHemisphere(const Math::Vector3& normalWS, const
 }
 
 static void ResolveIndirectSurfaceProperties(Entity* entity,
-                                             const Math::Vector3& pointWS,
+                                             const SurfaceSample& surface,
                                              Math::Vector3& outAlbedo,
                                              Math::Vector3& outEmission,
                                              float& outAO,
@@ -1747,8 +2280,7 @@ static void ResolveIndirectSurfaceProperties(Entity* entity,
 
     const auto& staticLighting = renderer->getStaticLighting();
     outContributeGI = staticLighting.contributeGI;
-    SurfaceSample surface;
-    if (FindClosestSurfaceSample(entity, pointWS, surface)) {
+    if (surface.valid) {
         ResolveMaterialSample(renderer->getMaterial(static_cast<uint32_t>(std::max(surface.materialIndex, 0))),
                               surface.uv,
                               outAlbedo,
@@ -1775,7 +2307,7 @@ static int ComputeAdaptiveIndirectSampleCount(const SceneSettings& bakeSettings,
 static Math::Vector3 EstimateIndirectLighting(Scene* scene,
                                               const SceneSettings& bakeSettings,
                                               const std::vector<BakedDirectLight>& bakedLights,
-                                              const std::vector<EmissiveTriangleSurface>& emissiveSurfaces,
+                                              const EmissiveLightSet& emissiveSurfaces,
                                               const Math::Vector3& positionWS,
                                               const Math::Vector3& normalWS,
                                               uint32_t sampleSeed,
@@ -1784,8 +2316,7 @@ static Math::Vector3 EstimateIndirectLighting(Scene* scene,
         return Math::Vector3::Zero;
     }
 
-    PhysicsWorld* physicsWorld = scene->getPhysicsWorld();
-    if (!physicsWorld) {
+    if (!g_LightBakeBVH) {
         return Math::Vector3::Zero;
     }
 
@@ -1805,15 +2336,8 @@ static Math::Vector3 EstimateIndirectLighting(Scene* scene,
         );
 
         for (int bounceIndex = 0; bounceIndex < bounceCount; ++bounceIndex) {
-            PhysicsRaycastHit hit;
-            bool hitScene = physicsWorld->raycast(bounceOrigin,
-                                                  bounceDirection,
-                                                  512.0f,
-                                                  hit,
-                                                  PhysicsWorld::kAllLayersMask,
-                                                  false,
-                                                  nullptr);
-            if (!hitScene || !hit.hit) {
+            LightBakeBVH::Hit hit;
+            if (!g_LightBakeBVH->intersect(bounceOrigin, bounceDirection, 512.0f, hit)) {
                 accumulatedIndirect += MultiplyColor(throughput, SampleBakeEnvironmentRadiance(bakeSettings.environment, bounceDirection));
                 break;
             }
@@ -1829,7 +2353,13 @@ static Math::Vector3 EstimateIndirectLighting(Scene* scene,
             Math::Vector3 surfaceEmission;
             float surfaceAO = 1.0f;
             bool contributeGI = true;
-            ResolveIndirectSurfaceProperties(hit.entity, hit.point, surfaceAlbedo, surfaceEmission, surfaceAO, contributeGI);
+            SurfaceSample hitSurface;
+            hitSurface.valid = true;
+            hitSurface.positionWS = hit.point;
+            hitSurface.normalWS = hitNormal;
+            hitSurface.uv = hit.uv;
+            hitSurface.materialIndex = hit.materialIndex;
+            ResolveIndirectSurfaceProperties(hit.entity, hitSurface, surfaceAlbedo, surfaceEmission, surfaceAO, contributeGI);
             if (!contributeGI) {
                 break;
             }
@@ -1888,23 +2418,6 @@ static Math::Vector3 EstimateIndirectLighting(Scene* scene,
     return ClampColor(accumulatedIndirect / static_cast<float>(sampleCount), 12.0f);
 }
 
-struct ProbeVolumeFileHeader {
-    char magic[4];
-    uint32_t version = 3u;
-    uint32_t countX = 0u;
-    uint32_t countY = 0u;
-    uint32_t countZ = 0u;
-    float boundsMin[3] = {0.0f, 0.0f, 0.0f};
-    float boundsMax[3] = {0.0f, 0.0f, 0.0f};
-};
-
-struct ProbeVolumeFileRecord {
-    float ambientCube[6][4] = {};
-    float specularCube[6][4] = {};
-    float positionAndValidity[4] = {};
-    float visibility[2][4] = {};
-};
-
 static std::string SanitizeLightingArtifactStem(std::string value) {
     if (value.empty()) {
         value = "Scene";
@@ -1917,6 +2430,581 @@ static std::string SanitizeLightingArtifactStem(std::string value) {
     return value;
 }
 
+// Static geometry as the bake traces it, with cutout materials masked the way the shadow pass
+// clips them.
+static void BuildLightBakeBVH(Scene* scene, LightBakeBVH& outBVH) {
+    auto loadAlphaImage = [](const std::shared_ptr<Texture2D>& texture) {
+        LightBakeAlphaMask::Image image;
+        if (const CPUImageCacheEntry* entry = texture ? LoadCPUImage(texture->getPath()) : nullptr) {
+            image.rgba = entry->rgba.data();
+            image.width = entry->width;
+            image.height = entry->height;
+        }
+        return image;
+    };
+
+    std::vector<LightBakeMeshInstance> instances;
+    for (const auto& entityPtr : scene->getAllEntities()) {
+        Entity* entity = entityPtr.get();
+        if (!entity || !entity->isActiveInHierarchy() || entity->isEditorOnly()) {
+            continue;
+        }
+
+        MeshRenderer* renderer = entity->getComponent<MeshRenderer>();
+        if (!renderer || entity->getComponent<SkinnedMeshRenderer>() || !renderer->getStaticLighting().staticGeometry) {
+            continue;
+        }
+
+        std::shared_ptr<Mesh> mesh = renderer->getMesh();
+        if (!mesh || mesh->getVertices().empty() || mesh->getIndices().size() < 3) {
+            continue;
+        }
+
+        LightBakeMeshInstance instance;
+        instance.entity = entity;
+        instance.mesh = mesh;
+        instance.worldMatrix = entity->getTransform()->getWorldMatrix();
+        instance.castShadows = renderer->getCastShadows();
+        const auto& materials = renderer->getMaterials();
+        for (size_t slot = 0; slot < materials.size(); ++slot) {
+            const std::shared_ptr<Material>& material = materials[slot];
+            if (!material || material->getRenderMode() != Material::RenderMode::Cutout || material->getAlphaCutoff() <= 0.0f) {
+                continue;
+            }
+            instance.alphaMasks.resize(std::max(instance.alphaMasks.size(), slot + 1));
+            LightBakeAlphaMask& mask = instance.alphaMasks[slot];
+            mask.albedo = loadAlphaImage(material->getAlbedoTexture());
+            mask.opacity = loadAlphaImage(material->getOpacityTexture());
+            mask.alphaScale = material->getAlbedo().w;
+            mask.cutoff = material->getAlphaCutoff();
+            mask.uvTiling = material->getUVTiling();
+            mask.uvOffset = material->getUVOffset();
+        }
+        instances.push_back(std::move(instance));
+    }
+    outBVH.build(instances);
+}
+
+// Mirrors BuildLightBakeBVH's instances, lights and emissive triangles for the GPU baker, with
+// materials resolved to the values ResolveMaterialSample starts from.
+static void BuildGPULightBakeScene(Scene* scene,
+                                   const SceneSettings& bakeSettings,
+                                   const std::vector<BakedDirectLight>& bakedLights,
+                                   const EmissiveLightSet& emissiveSurfaces,
+                                   GPULightBaker::SceneDesc& outScene) {
+    const SceneEnvironmentSettings& environment = bakeSettings.environment;
+    Math::Vector3 ambient = environment.ambientColor * std::max(environment.ambientIntensity, 0.0f);
+    outScene.params.ambient[0] = ambient.x;
+    outScene.params.ambient[1] = ambient.y;
+    outScene.params.ambient[2] = ambient.z;
+    outScene.params.tint[0] = environment.tint.x;
+    outScene.params.tint[1] = environment.tint.y;
+    outScene.params.tint[2] = environment.tint.z;
+    outScene.params.intensities[0] = std::max(environment.skyIntensity, 0.0f);
+    outScene.params.intensities[1] = std::max(environment.iblIntensity, 0.0f);
+    outScene.params.indirectBounces = bakeSettings.staticLighting.indirectBounces;
+    outScene.params.samplesPerTexel = bakeSettings.staticLighting.samplesPerTexel;
+
+    for (const BakedDirectLight& light : bakedLights) {
+        GPULightBakeLight gpuLight;
+        gpuLight.positionRange[0] = light.positionWS.x;
+        gpuLight.positionRange[1] = light.positionWS.y;
+        gpuLight.positionRange[2] = light.positionWS.z;
+        gpuLight.positionRange[3] = light.range;
+        gpuLight.directionIntensity[0] = light.directionWS.x;
+        gpuLight.directionIntensity[1] = light.directionWS.y;
+        gpuLight.directionIntensity[2] = light.directionWS.z;
+        gpuLight.directionIntensity[3] = light.intensity;
+        gpuLight.color[0] = light.color.x;
+        gpuLight.color[1] = light.color.y;
+        gpuLight.color[2] = light.color.z;
+        gpuLight.shadow[0] = light.shadowBias;
+        gpuLight.shadow[1] = light.shadowNormalBias;
+        gpuLight.shadow[2] = light.shadowDistance;
+        gpuLight.spot[0] = light.cosInner;
+        gpuLight.spot[1] = light.cosOuter;
+        gpuLight.flags[0] = static_cast<int32_t>(light.type);
+        gpuLight.flags[1] = light.mobility == Light::Mobility::Stationary ? 1 : 0;
+        gpuLight.flags[2] = light.castShadows ? 1 : 0;
+        gpuLight.flags[3] = light.shadowmaskChannel;
+        outScene.lights.push_back(gpuLight);
+    }
+
+    std::unordered_map<std::string, int32_t> textureIndices;
+    auto textureIndex = [&](const std::shared_ptr<Texture2D>& texture) -> int32_t {
+        if (!texture) {
+            return -1;
+        }
+        auto [it, inserted] = textureIndices.emplace(texture->getPath(), static_cast<int32_t>(outScene.textures.size()));
+        if (inserted) {
+            GPULightBaker::Texture gpuTexture;
+            if (const CPUImageCacheEntry* image = LoadCPUImage(texture->getPath())) {
+                gpuTexture.rgba = image->rgba.data();
+                gpuTexture.width = image->width;
+                gpuTexture.height = image->height;
+            }
+            outScene.textures.push_back(gpuTexture);
+        }
+        return it->second;
+    };
+
+    std::unordered_map<const MeshRenderer*, size_t> instanceIndices;
+    for (const auto& entityPtr : scene->getAllEntities()) {
+        Entity* entity = entityPtr.get();
+        if (!entity || !entity->isActiveInHierarchy() || entity->isEditorOnly()) {
+            continue;
+        }
+
+        MeshRenderer* renderer = entity->getComponent<MeshRenderer>();
+        if (!renderer || entity->getComponent<SkinnedMeshRenderer>() || !renderer->getStaticLighting().staticGeometry) {
+            continue;
+        }
+
+        std::shared_ptr<Mesh> mesh = renderer->getMesh();
+        if (!mesh || mesh->getVertices().empty() || mesh->getIndices().size() < 3) {
+            continue;
+        }
+
+        GPULightBaker::Instance instance;
+        instance.mesh = mesh;
+        instance.worldMatrix = entity->getTransform()->getWorldMatrix();
+        instance.castShadows = renderer->getCastShadows();
+        instance.contributeGI = renderer->getStaticLighting().contributeGI;
+        instance.materialOffset = static_cast<uint32_t>(outScene.materials.size());
+        for (const std::shared_ptr<Material>& material : renderer->getMaterials()) {
+            GPULightBakeMaterial gpuMaterial;
+            if (material) {
+                const Math::Vector4& albedo = material->getAlbedo();
+                Math::Vector3 albedoColor = ClampColor(Math::Vector3(albedo.x, albedo.y, albedo.z), 1.0f);
+                Math::Vector3 emission = ClampColor(material->getEmission() * material->getEmissionStrength(), 16.0f);
+                gpuMaterial.albedo[0] = albedoColor.x;
+                gpuMaterial.albedo[1] = albedoColor.y;
+                gpuMaterial.albedo[2] = albedoColor.z;
+                gpuMaterial.albedo[3] = albedo.w;
+                gpuMaterial.emission[0] = emission.x;
+                gpuMaterial.emission[1] = emission.y;
+                gpuMaterial.emission[2] = emission.z;
+                gpuMaterial.emission[3] = Math::Clamp(material->getAO(), 0.05f, 1.0f);
+                gpuMaterial.uvTransform[0] = material->getUVTiling().x;
+                gpuMaterial.uvTransform[1] = material->getUVTiling().y;
+                gpuMaterial.uvTransform[2] = material->getUVOffset().x;
+                gpuMaterial.uvTransform[3] = material->getUVOffset().y;
+                gpuMaterial.textures[0] = textureIndex(material->getAlbedoTexture());
+                gpuMaterial.textures[1] = textureIndex(material->getEmissionTexture());
+                gpuMaterial.textures[2] = textureIndex(material->getAOTexture());
+                if (material->getRenderMode() == Material::RenderMode::Cutout && material->getAlphaCutoff() > 0.0f) {
+                    gpuMaterial.textures[3] = textureIndex(material->getOpacityTexture());
+                    gpuMaterial.alpha[0] = material->getAlphaCutoff();
+                }
+            }
+            outScene.materials.push_back(gpuMaterial);
+        }
+        instance.materialCount = static_cast<uint32_t>(outScene.materials.size()) - instance.materialOffset;
+        instanceIndices[renderer] = outScene.instances.size();
+        outScene.instances.push_back(std::move(instance));
+    }
+
+    for (const EmissiveTriangleSurface& surface : emissiveSurfaces.surfaces) {
+        GPULightBakeEmitter emitter;
+        const Math::Vector3* positions[3] = {&surface.p0, &surface.p1, &surface.p2};
+        const Math::Vector3* normals[3] = {&surface.n0, &surface.n1, &surface.n2};
+        float* gpuPositions[3] = {emitter.p0, emitter.p1, emitter.p2};
+        float* gpuNormals[3] = {emitter.n0, emitter.n1, emitter.n2};
+        for (int corner = 0; corner < 3; ++corner) {
+            gpuPositions[corner][0] = positions[corner]->x;
+            gpuPositions[corner][1] = positions[corner]->y;
+            gpuPositions[corner][2] = positions[corner]->z;
+            gpuNormals[corner][0] = normals[corner]->x;
+            gpuNormals[corner][1] = normals[corner]->y;
+            gpuNormals[corner][2] = normals[corner]->z;
+        }
+        emitter.p0[3] = surface.area;
+        emitter.p1[3] = surface.weight;
+        emitter.p2[3] = surface.cumulativeWeight;
+        emitter.n0[3] = surface.twoSided ? 1.0f : 0.0f;
+        emitter.uv01[0] = surface.uv0.x;
+        emitter.uv01[1] = surface.uv0.y;
+        emitter.uv01[2] = surface.uv1.x;
+        emitter.uv01[3] = surface.uv1.y;
+        emitter.uv2[0] = surface.uv2.x;
+        emitter.uv2[1] = surface.uv2.y;
+        auto instanceIt = instanceIndices.find(surface.renderer);
+        if (instanceIt != instanceIndices.end()) {
+            const GPULightBaker::Instance& instance = outScene.instances[instanceIt->second];
+            uint32_t slot = static_cast<uint32_t>(std::max(surface.materialIndex, 0));
+            if (slot < instance.materialCount) {
+                emitter.material = instance.materialOffset + slot;
+            }
+        }
+        outScene.emitters.push_back(emitter);
+    }
+
+    // The kernel picks emitters with the same alias table and light tree as the CPU baker.
+    for (const EmissiveAliasEntry& entry : emissiveSurfaces.aliasTable) {
+        GPULightBakeAliasEntry gpuEntry;
+        gpuEntry.probability = entry.probability;
+        gpuEntry.alias = entry.alias;
+        outScene.aliasTable.push_back(gpuEntry);
+    }
+    for (const EmissiveLightNode& node : emissiveSurfaces.lightTree) {
+        GPULightBakeLightNode gpuNode;
+        for (int axis = 0; axis < 3; ++axis) {
+            gpuNode.boundsMin[axis] = node.boundsMin[axis];
+            gpuNode.boundsMax[axis] = node.boundsMax[axis];
+            gpuNode.coneAxis[axis] = node.coneAxis[axis];
+        }
+        gpuNode.boundsMin[3] = node.weight;
+        gpuNode.boundsMax[3] = node.coneAngle;
+        gpuNode.child = node.child;
+        gpuNode.leaf = node.leaf ? 1u : 0u;
+        outScene.lightTree.push_back(gpuNode);
+    }
+}
+
+static GPULightBakeQuery BuildLightmapTexelQuery(const LightmapTexelSample& sample) {
+    GPULightBakeQuery query;
+    query.position[0] = sample.positionWS.x;
+    query.position[1] = sample.positionWS.y;
+    query.position[2] = sample.positionWS.z;
+    query.position[3] = ComputeLuminance(sample.primaryEmission);
+    query.geometryNormal[0] = sample.geometryNormalWS.x;
+    query.geometryNormal[1] = sample.geometryNormalWS.y;
+    query.geometryNormal[2] = sample.geometryNormalWS.z;
+    query.geometryNormal[3] = sample.primaryAO;
+    query.shadingNormal[0] = sample.shadingNormalWS.x;
+    query.shadingNormal[1] = sample.shadingNormalWS.y;
+    query.shadingNormal[2] = sample.shadingNormalWS.z;
+    query.control[0] = GPULightBakeQuery::Texel;
+    query.control[1] = sample.receiveGI ? 1u : 0u;
+    query.seeds[0] = sample.emissiveSeed;
+    query.seeds[1] = sample.indirectSeed;
+    return query;
+}
+
+static LightmapTexelLighting ReadLightmapTexelResult(const GPULightBakeResult& result) {
+    LightmapTexelLighting lighting;
+    lighting.direct = Math::Vector3(result.direct[0], result.direct[1], result.direct[2]);
+    lighting.indirect = Math::Vector3(result.indirect[0], result.indirect[1], result.indirect[2]);
+    lighting.hasDominant = result.indirect[3] > 0.5f;
+    lighting.dominantDirection = Math::Vector3(result.dominant[0], result.dominant[1], result.dominant[2]);
+    lighting.referenceNoL = result.dominant[3];
+    for (int channel = 0; channel < 4; ++channel) {
+        lighting.shadowmask[channel] = result.shadowmask[channel];
+    }
+    return lighting;
+}
+
+static GPULightBakeQuery BuildProbeQuery(GPULightBakeQuery::Mode mode,
+                                         const Math::Vector3& positionWS,
+                                         const Math::Vector3& normalWS,
+                                         uint32_t sampleSeed,
+                                         int sampleCount) {
+    GPULightBakeQuery query;
+    query.position[0] = positionWS.x;
+    query.position[1] = positionWS.y;
+    query.position[2] = positionWS.z;
+    query.geometryNormal[0] = normalWS.x;
+    query.geometryNormal[1] = normalWS.y;
+    query.geometryNormal[2] = normalWS.z;
+    query.control[0] = mode;
+    query.control[2] = static_cast<uint32_t>(sampleCount);
+    query.seeds[0] = sampleSeed;
+    return query;
+}
+
+static LightmapTexelLighting ComputeLightmapTexelLighting(Scene* scene,
+                                                           const SceneSettings& bakeSettings,
+                                                           const std::vector<BakedDirectLight>& bakedLights,
+                                                           const EmissiveLightSet& emissiveSurfaces,
+                                                           const LightmapTexelSample& sample) {
+    LightmapTexelLighting lighting;
+    Math::Vector3 accumulated = Math::Vector3::Zero;
+    Math::Vector3 dominantDirection = Math::Vector3::Zero;
+    float dominantWeight = 0.0f;
+    float referenceNoL = 0.0f;
+    for (const BakedDirectLight& light : bakedLights) {
+        Math::Vector3 contribution = BakeLightContribution(light, sample.positionWS, sample.shadingNormalWS);
+        if (contribution.lengthSquared() <= Math::EPSILON) {
+            continue;
+        }
+        bool visible = IsDirectLightVisible(scene, light, sample.positionWS, sample.geometryNormalWS);
+        if (light.mobility == Light::Mobility::Stationary && light.shadowmaskChannel >= 0) {
+            lighting.shadowmask[light.shadowmaskChannel] = visible ? 1.0f : 0.0f;
+        }
+        if (!visible) {
+            continue;
+        }
+        if (light.mobility == Light::Mobility::Stationary) {
+            continue;
+        }
+        accumulated += contribution;
+
+        Math::Vector3 lightDir = Math::Vector3::Zero;
+        float sampleNoL = 0.0f;
+        if (ComputeIncidentLightDirection(light, sample.positionWS, sample.shadingNormalWS, lightDir, sampleNoL)) {
+            float weight = std::max(ComputeLuminance(contribution), 0.0f);
+            dominantDirection += lightDir * weight;
+            dominantWeight += weight;
+            referenceNoL += sampleNoL * weight;
+        }
+    }
+    if (!emissiveSurfaces.empty()) {
+        EmissiveLightingEstimate emissiveDirect = EstimateEmissiveSurfaceLighting(
+            scene,
+            emissiveSurfaces,
+            sample.positionWS,
+            sample.shadingNormalWS,
+            sample.emissiveSeed,
+            std::max(1, std::min(8, bakeSettings.staticLighting.samplesPerTexel / 32))
+        );
+        accumulated += emissiveDirect.irradiance;
+        dominantDirection += emissiveDirect.weightedDirection;
+        dominantWeight += emissiveDirect.directionWeight;
+        referenceNoL += emissiveDirect.referenceNoL;
+    }
+    lighting.direct = ClampColor(accumulated, 16.0f);
+    if (sample.receiveGI && bakeSettings.staticLighting.indirectBounces > 0) {
+        int adaptiveSampleCount = ComputeAdaptiveIndirectSampleCount(
+            bakeSettings,
+            lighting.direct,
+            sample.primaryEmission,
+            sample.primaryAO
+        );
+        lighting.indirect = EstimateIndirectLighting(
+            scene,
+            bakeSettings,
+            bakedLights,
+            emissiveSurfaces,
+            sample.positionWS,
+            sample.geometryNormalWS,
+            sample.indirectSeed,
+            adaptiveSampleCount
+        );
+    }
+    if (dominantWeight > Math::EPSILON) {
+        lighting.hasDominant = true;
+        lighting.dominantDirection = dominantDirection / dominantWeight;
+        lighting.referenceNoL = referenceNoL / dominantWeight;
+    }
+    return lighting;
+}
+
+// Relights a spread of the GPU's texel samples on the CPU and logs how far the two backends
+// disagree. Both use the same seeds and emitter samplers, so the gap should sit at noise level.
+static void LogGPULightmapParity(Scene* scene,
+                                 const SceneSettings& bakeSettings,
+                                 const std::vector<BakedDirectLight>& bakedLights,
+                                 const EmissiveLightSet& emissiveSurfaces,
+                                 const std::vector<LightmapTexelSample>& samples,
+                                 const std::vector<GPULightBakeResult>& results) {
+    const size_t count = std::min(samples.size(), results.size());
+    if (count == 0) {
+        return;
+    }
+    const size_t stride = std::max<size_t>(1, count / kGPULightmapParitySamples);
+    double cpuDirect = 0.0;
+    double cpuIndirect = 0.0;
+    double directError = 0.0;
+    double indirectError = 0.0;
+    size_t compared = 0;
+    size_t shadowmaskMismatches = 0;
+    for (size_t index = 0; index < count; index += stride) {
+        LightmapTexelLighting cpu = ComputeLightmapTexelLighting(scene, bakeSettings, bakedLights,
+                                                                 emissiveSurfaces, samples[index]);
+        LightmapTexelLighting gpu = ReadLightmapTexelResult(results[index]);
+        cpuDirect += ComputeLuminance(cpu.direct);
+        cpuIndirect += ComputeLuminance(cpu.indirect);
+        directError += std::abs(ComputeLuminance(gpu.direct) - ComputeLuminance(cpu.direct));
+        indirectError += std::abs(ComputeLuminance(gpu.indirect) - ComputeLuminance(cpu.indirect));
+        for (int channel = 0; channel < 4; ++channel) {
+            if ((cpu.shadowmask[channel] < 0.0f) != (gpu.shadowmask[channel] < 0.0f) ||
+                (cpu.shadowmask[channel] >= 0.0f && std::abs(cpu.shadowmask[channel] - gpu.shadowmask[channel]) > 0.5f)) {
+                ++shadowmaskMismatches;
+            }
+        }
+        ++compared;
+    }
+    std::cout << "[StaticLighting] GPU/CPU parity over " << compared << " texels: direct "
+              << (100.0 * directError / std::max(cpuDirect, 1e-6)) << "%, indirect "
+              << (100.0 * indirectError / std::max(cpuIndirect, 1e-6)) << "% mean luminance difference, "
+              << shadowmaskMismatches << " shadowmask mismatches" << std::endl;
+}
+
+static uint64_t HashLightBakeBytes(uint64_t hash, const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Per-atlas hashes of what each atlas bake reads, so a re-bake redoes only the atlases whose inputs
+// changed. An atlas depends on the environment and bake settings, its own renderers, the lights
+// whose range reaches it, and the static renderers that can shadow it from one of those lights or
+// lie within indirectInfluenceRadius, where they bounce or block its indirect light. Changes
+// farther away are ignored. Edits to texture files on disk are not detected.
+static std::unordered_map<int, uint64_t> HashLightmapBakeInputs(Scene* scene,
+                                                                const std::unordered_map<int, std::vector<StaticLightingBakeCandidate>>& atlasCandidates,
+                                                                StaticLightingContentHashes& outContents) {
+    // Settings that only steer the bake session or record its output stay out of the hash.
+    const SceneStaticLightingSettings savedSettings = scene->getSettings().staticLighting;
+    const SceneStaticLightingSettings defaults;
+    SceneStaticLightingSettings hashedSettings = savedSettings;
+    hashedSettings.gpuBake = defaults.gpuBake;
+    hashedSettings.progressivePreviewSeconds = defaults.progressivePreviewSeconds;
+    hashedSettings.progressiveFrameBudgetMs = defaults.progressiveFrameBudgetMs;
+    if (!hashedSettings.progressiveBake) {
+        hashedSettings.progressivePasses = defaults.progressivePasses;
+    }
+    hashedSettings.indirectInfluenceRadius = defaults.indirectInfluenceRadius;
+    hashedSettings.lastBakeHash.clear();
+    hashedSettings.atlasBakeHashes.clear();
+    // The probe volume is baked after the atlases and reads nothing back from them.
+    hashedSettings.probeVolume = defaults.probeVolume;
+    hashedSettings.probeCountX = defaults.probeCountX;
+    hashedSettings.probeCountY = defaults.probeCountY;
+    hashedSettings.probeCountZ = defaults.probeCountZ;
+    hashedSettings.probeSamples = defaults.probeSamples;
+    hashedSettings.probeStreamingBrickBudget = defaults.probeStreamingBrickBudget;
+    hashedSettings.dynamicProbes = defaults.dynamicProbes;
+    hashedSettings.dynamicProbesPerFrame = defaults.dynamicProbesPerFrame;
+    hashedSettings.dynamicProbeRays = defaults.dynamicProbeRays;
+    hashedSettings.dynamicProbeHysteresis = defaults.dynamicProbeHysteresis;
+    hashedSettings.dynamicReflections = defaults.dynamicReflections;
+    hashedSettings.dynamicReflectionProbes = defaults.dynamicReflectionProbes;
+    hashedSettings.dynamicReflectionResolution = defaults.dynamicReflectionResolution;
+    hashedSettings.dynamicReflectionFacesPerFrame = defaults.dynamicReflectionFacesPerFrame;
+    hashedSettings.probeBoundsMin = defaults.probeBoundsMin;
+    hashedSettings.probeBoundsMax = defaults.probeBoundsMax;
+    hashedSettings.probeDataPath.clear();
+    const float influenceRadius = std::max(0.0f, savedSettings.indirectInfluenceRadius);
+    outContents = SceneSerializer::HashStaticLightingContents(scene, hashedSettings);
+
+    struct Influencer {
+        std::string uuid;
+        Math::Vector3 boundsMin;
+        Math::Vector3 boundsMax;
+    };
+    struct InfluencingLight {
+        std::string uuid;
+        bool directional = false;
+        Math::Vector3 position;
+        Math::Vector3 direction;
+        float range = 0.0f; // zero when unbounded
+    };
+    std::vector<Influencer> renderers;
+    std::vector<InfluencingLight> lights;
+    Math::Vector3 sceneMin(std::numeric_limits<float>::max());
+    Math::Vector3 sceneMax(std::numeric_limits<float>::lowest());
+    for (const auto& entityPtr : scene->getAllEntities()) {
+        Entity* entity = entityPtr.get();
+        if (!entity || !entity->isActiveInHierarchy() || entity->isEditorOnly()) {
+            continue;
+        }
+        if (Light* light = entity->getComponent<Light>()) {
+            if (light->getContributeToStaticBake()) {
+                InfluencingLight influence;
+                influence.uuid = entity->getUUID().toString();
+                influence.directional = light->getType() == Light::Type::Directional;
+                influence.position = entity->getTransform()->getPosition();
+                influence.direction = entity->getTransform()->forward().normalized();
+                influence.range = std::max(0.0f, light->getRange());
+                lights.push_back(influence);
+            }
+        }
+        MeshRenderer* renderer = entity->getComponent<MeshRenderer>();
+        if (!renderer || entity->getComponent<SkinnedMeshRenderer>() || !renderer->getStaticLighting().staticGeometry) {
+            continue;
+        }
+        std::shared_ptr<Mesh> mesh = renderer->getMesh();
+        if (!mesh || mesh->getVertices().empty() || mesh->getIndices().size() < 3) {
+            continue;
+        }
+        renderers.push_back({entity->getUUID().toString(), renderer->getBoundsMin(), renderer->getBoundsMax()});
+        sceneMin = Math::Vector3::Min(sceneMin, renderers.back().boundsMin);
+        sceneMax = Math::Vector3::Max(sceneMax, renderers.back().boundsMax);
+    }
+    const float sceneDiagonal = renderers.empty() ? 0.0f : (sceneMax - sceneMin).length();
+
+    auto boxesOverlap = [](const Math::Vector3& minA, const Math::Vector3& maxA,
+                           const Math::Vector3& minB, const Math::Vector3& maxB) {
+        return minA.x <= maxB.x && maxA.x >= minB.x
+            && minA.y <= maxB.y && maxA.y >= minB.y
+            && minA.z <= maxB.z && maxA.z >= minB.z;
+    };
+    auto sphereOverlapsBox = [](const Math::Vector3& center, float radius,
+                                const Math::Vector3& boxMin, const Math::Vector3& boxMax) {
+        Math::Vector3 closest = Math::Vector3::Min(Math::Vector3::Max(center, boxMin), boxMax);
+        return (closest - center).lengthSquared() <= radius * radius;
+    };
+
+    std::unordered_map<int, uint64_t> atlasHashes;
+    for (const auto& entry : atlasCandidates) {
+        std::unordered_set<std::string> contributors;
+        Math::Vector3 atlasMin(std::numeric_limits<float>::max());
+        Math::Vector3 atlasMax(std::numeric_limits<float>::lowest());
+        for (const StaticLightingBakeCandidate& candidate : entry.second) {
+            contributors.insert(candidate.entity->getUUID().toString());
+            atlasMin = Math::Vector3::Min(atlasMin, candidate.renderer->getBoundsMin());
+            atlasMax = Math::Vector3::Max(atlasMax, candidate.renderer->getBoundsMax());
+        }
+        const Math::Vector3 reach(influenceRadius, influenceRadius, influenceRadius);
+        const Math::Vector3 nearMin = atlasMin - reach;
+        const Math::Vector3 nearMax = atlasMax + reach;
+
+        // Lights count when they reach the atlas or the surfaces bouncing light onto it. Each
+        // one also gives the region its shadow casters can occupy: the atlas bounds swept toward
+        // a directional light, or stretched to a local light's position.
+        std::vector<std::string> influences(contributors.begin(), contributors.end());
+        std::vector<std::pair<Math::Vector3, Math::Vector3>> shadowRegions;
+        for (const InfluencingLight& light : lights) {
+            if (light.directional) {
+                Math::Vector3 toLight = -light.direction * sceneDiagonal;
+                shadowRegions.emplace_back(Math::Vector3::Min(atlasMin, atlasMin + toLight),
+                                           Math::Vector3::Max(atlasMax, atlasMax + toLight));
+            } else if (light.range <= 0.0f || sphereOverlapsBox(light.position, light.range, nearMin, nearMax)) {
+                shadowRegions.emplace_back(Math::Vector3::Min(atlasMin, light.position),
+                                           Math::Vector3::Max(atlasMax, light.position));
+            } else {
+                continue;
+            }
+            influences.push_back(light.uuid);
+        }
+        for (const Influencer& renderer : renderers) {
+            if (contributors.count(renderer.uuid) != 0) {
+                continue;
+            }
+            bool influencesAtlas = boxesOverlap(renderer.boundsMin, renderer.boundsMax, nearMin, nearMax);
+            for (size_t i = 0; !influencesAtlas && i < shadowRegions.size(); ++i) {
+                influencesAtlas = boxesOverlap(renderer.boundsMin, renderer.boundsMax,
+                                                shadowRegions[i].first, shadowRegions[i].second);
+            }
+            if (influencesAtlas) {
+                influences.push_back(renderer.uuid);
+            }
+        }
+
+        // Sorted so the hash does not depend on scene order; a removed influence changes the set.
+        std::sort(influences.begin(), influences.end());
+        uint64_t hash = HashLightBakeBytes(outContents.settings, &entry.first, sizeof(entry.first));
+        for (const std::string& uuid : influences) {
+            auto contentIt = outContents.entities.find(uuid);
+            uint64_t content = contentIt != outContents.entities.end() ? contentIt->second : 0u;
+            hash = HashLightBakeBytes(hash, uuid.data(), uuid.size());
+            hash = HashLightBakeBytes(hash, &content, sizeof(content));
+        }
+        atlasHashes[entry.first] = hash;
+    }
+    return atlasHashes;
+}
+
+static std::string FormatLightBakeHash(uint64_t hash) {
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return oss.str();
+}
+
 static bool ComputeStaticGeometryBounds(Scene* scene,
                                         Math::Vector3& outMin,
                                         Math::Vector3& outMax) {
@@ -1987,25 +3075,18 @@ static float TraceProbeVisibilityDistance(Scene* scene,
                                           const Math::Vector3& origin,
                                           const Math::Vector3& direction,
                                           float maxDistance) {
-    PhysicsWorld* physicsWorld = scene ? scene->getPhysicsWorld() : nullptr;
-    if (!physicsWorld || maxDistance <= Math::EPSILON) {
+    if (!g_LightBakeBVH || maxDistance <= Math::EPSILON) {
         return maxDistance;
     }
 
-    PhysicsRaycastHit hit;
+    LightBakeBVH::Hit hit;
     Math::Vector3 rayDirection = direction.normalized();
     if (rayDirection.lengthSquared() <= Math::EPSILON) {
         return maxDistance;
     }
 
     Math::Vector3 rayOrigin = origin + rayDirection * 0.02f;
-    if (!physicsWorld->raycast(rayOrigin,
-                               rayDirection,
-                               maxDistance,
-                               hit,
-                               PhysicsWorld::kAllLayersMask,
-                               false,
-                               nullptr)) {
+    if (!g_LightBakeBVH->intersect(rayOrigin, rayDirection, maxDistance, hit)) {
         return maxDistance;
     }
 
@@ -2031,8 +3112,7 @@ static Math::Vector3 RelocateProbePosition(Scene* scene,
     Math::Vector3 position = Math::Vector3::Clamp(candidatePosition, boundsMin, boundsMax);
     outValidity = 1.0f;
 
-    PhysicsWorld* physicsWorld = scene ? scene->getPhysicsWorld() : nullptr;
-    if (!physicsWorld) {
+    if (!g_LightBakeBVH) {
         return position;
     }
 
@@ -2055,13 +3135,7 @@ static Math::Vector3 RelocateProbePosition(Scene* scene,
 
         outValidity = Math::Clamp(openness / 6.0f, 0.08f, 1.0f);
 
-        std::vector<PhysicsOverlapHit> overlaps;
-        bool embeddedInGeometry = physicsWorld->overlapSphere(position,
-                                                              clearanceDistance * 0.35f,
-                                                              overlaps,
-                                                              PhysicsWorld::kAllLayersMask,
-                                                              false,
-                                                              nullptr) > 0;
+        bool embeddedInGeometry = g_LightBakeBVH->overlapsSphere(position, clearanceDistance * 0.35f);
         if (!embeddedInGeometry && push.lengthSquared() <= Math::EPSILON) {
             break;
         }
@@ -2087,7 +3161,7 @@ static Math::Vector3 RelocateProbePosition(Scene* scene,
 static Math::Vector3 EvaluateBakedLightingAtPoint(Scene* scene,
                                                   const SceneSettings& bakeSettings,
                                                   const std::vector<BakedDirectLight>& bakedLights,
-                                                  const std::vector<EmissiveTriangleSurface>& emissiveSurfaces,
+                                                  const EmissiveLightSet& emissiveSurfaces,
                                                   const Math::Vector3& positionWS,
                                                   const Math::Vector3& normalWS,
                                                   uint32_t sampleSeed,
@@ -2132,7 +3206,7 @@ static Math::Vector3 EvaluateBakedLightingAtPoint(Scene* scene,
 static Math::Vector3 EvaluateSpecularProbeLightingAtPoint(Scene* scene,
                                                           const SceneSettings& bakeSettings,
                                                           const std::vector<BakedDirectLight>& bakedLights,
-                                                          const std::vector<EmissiveTriangleSurface>& emissiveSurfaces,
+                                                          const EmissiveLightSet& emissiveSurfaces,
                                                           const Math::Vector3& positionWS,
                                                           const Math::Vector3& sampleDirectionWS,
                                                           uint32_t sampleSeed,
@@ -2210,7 +3284,8 @@ static bool BakeProbeVolume(Scene* scene,
                             const std::string& scenePath,
                             const SceneSettings& bakeSettings,
                             const std::vector<BakedDirectLight>& bakedLights,
-                            const std::vector<EmissiveTriangleSurface>& emissiveSurfaces) {
+                            const EmissiveLightSet& emissiveSurfaces,
+                            GPULightBaker* gpuBaker) {
     if (!scene || !bakeSettings.staticLighting.probeVolume) {
         return false;
     }
@@ -2226,19 +3301,92 @@ static bool BakeProbeVolume(Scene* scene,
         return false;
     }
 
+    // The probe counts give the coarse grid, one cell between neighbouring probes. Cells near
+    // static geometry also get a dense brick three times finer; open space and solid interiors
+    // keep only the coarse corners.
+    const int cellsX = std::max(1, countX - 1);
+    const int cellsY = std::max(1, countY - 1);
+    const int cellsZ = std::max(1, countZ - 1);
+    const int denseSteps = static_cast<int>(kProbeBrickDenseResolution) - 1;
+    const int latticeX = cellsX * denseSteps + 1;
+    const int latticeY = cellsY * denseSteps + 1;
+    const int latticeZ = cellsZ * denseSteps + 1;
     Math::Vector3 extent = Math::Vector3::Max(boundsMax - boundsMin, Math::Vector3(0.5f, 0.5f, 0.5f));
-    auto axisSpacing = [](float axisExtent, int count) -> float {
-        return (count > 1) ? (axisExtent / static_cast<float>(count - 1)) : axisExtent;
+    Math::Vector3 cellSize(extent.x / static_cast<float>(cellsX),
+                           extent.y / static_cast<float>(cellsY),
+                           extent.z / static_cast<float>(cellsZ));
+    float coarseMinSpacing = std::max(0.25f, std::min(cellSize.x, std::min(cellSize.y, cellSize.z)));
+    float coarseMaxSpacing = std::max(cellSize.x, std::max(cellSize.y, cellSize.z));
+    float denseSpacing = coarseMaxSpacing / static_cast<float>(denseSteps);
+
+    const size_t cellCount = static_cast<size_t>(cellsX) * static_cast<size_t>(cellsY) * static_cast<size_t>(cellsZ);
+    std::vector<uint32_t> denseBrickOfCell(cellCount, kProbeBrickNone);
+    uint32_t denseBrickCount = 0;
+    float cellRadius = cellSize.length() * 0.5f + denseSpacing;
+    for (int z = 0; z < cellsZ; ++z) {
+        for (int y = 0; y < cellsY; ++y) {
+            for (int x = 0; x < cellsX; ++x) {
+                Math::Vector3 center = boundsMin + Math::Vector3((static_cast<float>(x) + 0.5f) * cellSize.x,
+                                                                 (static_cast<float>(y) + 0.5f) * cellSize.y,
+                                                                 (static_cast<float>(z) + 0.5f) * cellSize.z);
+                if (g_LightBakeBVH && g_LightBakeBVH->overlapsSphere(center, cellRadius)) {
+                    denseBrickOfCell[static_cast<size_t>(x) + static_cast<size_t>(cellsX) * (y + static_cast<size_t>(cellsY) * z)] =
+                        denseBrickCount++;
+                }
+            }
+        }
+    }
+
+    // Bricks repeat the probes on their shared faces and coarse corners sit on the dense lattice,
+    // so each distinct lattice point is baked once and copied to every brick that uses it.
+    struct LatticeProbe {
+        int x = 0;
+        int y = 0;
+        int z = 0;
+        bool dense = false;
     };
-    float spacingX = axisSpacing(extent.x, countX);
-    float spacingY = axisSpacing(extent.y, countY);
-    float spacingZ = axisSpacing(extent.z, countZ);
-    float minSpacing = std::max(0.25f, std::min(spacingX, std::min(spacingY, spacingZ)));
-    float maxSpacing = std::max(spacingX, std::max(spacingY, spacingZ));
-    float relocationClearance = std::max(0.12f, minSpacing * 0.3f);
-    float visibilityDistance = std::max(1.5f, maxSpacing * 1.75f);
-
-    std::vector<ProbeVolumeFileRecord> records(static_cast<size_t>(countX) * static_cast<size_t>(countY) * static_cast<size_t>(countZ));
+    std::vector<LatticeProbe> latticeProbes;
+    std::unordered_map<uint64_t, uint32_t> latticeIndex;
+    auto addLatticeProbe = [&](int x, int y, int z, bool dense) {
+        uint64_t key = static_cast<uint64_t>(x) + static_cast<uint64_t>(latticeX) *
+            (static_cast<uint64_t>(y) + static_cast<uint64_t>(latticeY) * static_cast<uint64_t>(z));
+        auto inserted = latticeIndex.emplace(key, static_cast<uint32_t>(latticeProbes.size()));
+        if (inserted.second) {
+            latticeProbes.push_back({x, y, z, dense});
+        } else if (dense) {
+            latticeProbes[inserted.first->second].dense = true;
+        }
+        return inserted.first->second;
+    };
+    std::vector<uint32_t> coarseProbeIndices;
+    coarseProbeIndices.reserve(static_cast<size_t>(cellsX + 1) * (cellsY + 1) * (cellsZ + 1));
+    for (int z = 0; z <= cellsZ; ++z) {
+        for (int y = 0; y <= cellsY; ++y) {
+            for (int x = 0; x <= cellsX; ++x) {
+                coarseProbeIndices.push_back(addLatticeProbe(x * denseSteps, y * denseSteps, z * denseSteps, false));
+            }
+        }
+    }
+    std::vector<uint32_t> denseProbeIndices;
+    denseProbeIndices.reserve(static_cast<size_t>(denseBrickCount) * kProbeBrickDenseProbes);
+    for (int z = 0; z < cellsZ; ++z) {
+        for (int y = 0; y < cellsY; ++y) {
+            for (int x = 0; x < cellsX; ++x) {
+                if (denseBrickOfCell[static_cast<size_t>(x) + static_cast<size_t>(cellsX) * (y + static_cast<size_t>(cellsY) * z)] == kProbeBrickNone) {
+                    continue;
+                }
+                for (int bz = 0; bz <= denseSteps; ++bz) {
+                    for (int by = 0; by <= denseSteps; ++by) {
+                        for (int bx = 0; bx <= denseSteps; ++bx) {
+                            denseProbeIndices.push_back(addLatticeProbe(x * denseSteps + bx, y * denseSteps + by, z * denseSteps + bz, true));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<ProbeVolumeRecord> records(latticeProbes.size());
     const Math::Vector3 probeNormals[6] = {
         Math::Vector3::Right,
         -Math::Vector3::Right,
@@ -2248,108 +3396,174 @@ static bool BakeProbeVolume(Scene* scene,
         -Math::Vector3::Forward
     };
 
-    size_t probeIndex = 0;
-    for (int z = 0; z < countZ; ++z) {
-        for (int y = 0; y < countY; ++y) {
-            for (int x = 0; x < countX; ++x) {
-                Math::Vector3 gridPositionWS = ComputeProbeGridPosition(boundsMin, boundsMax, x, y, z, countX, countY, countZ);
-                float probeValidity = 1.0f;
-                Math::Vector3 positionWS = RelocateProbePosition(scene,
-                                                                 gridPositionWS,
-                                                                 boundsMin,
-                                                                 boundsMax,
-                                                                 relocationClearance,
-                                                                 visibilityDistance,
-                                                                 probeValidity);
-                ProbeVolumeFileRecord& record = records[probeIndex++];
-                record.positionAndValidity[0] = positionWS.x;
-                record.positionAndValidity[1] = positionWS.y;
-                record.positionAndValidity[2] = positionWS.z;
-                record.positionAndValidity[3] = probeValidity;
-
-                float probeVisibility[6] = {};
+    // Probes are placed and their visibility traced against the BVH first, then lit on the GPU
+    // when there is one, with the seeds the CPU path uses.
+    auto irradianceSeed = [](int x, int y, int z, int faceIndex) {
+        return static_cast<uint32_t>((x + 1) * 73856093u)
+            ^ static_cast<uint32_t>((y + 1) * 19349663u)
+            ^ static_cast<uint32_t>((z + 1) * 83492791u)
+            ^ static_cast<uint32_t>((faceIndex + 1) * 2654435761u);
+    };
+    auto specularSeed = [](int x, int y, int z, int faceIndex) {
+        return static_cast<uint32_t>((x + 1) * 2166136261u)
+            ^ static_cast<uint32_t>((y + 1) * 16777619u)
+            ^ static_cast<uint32_t>((z + 1) * 709607u)
+            ^ static_cast<uint32_t>((faceIndex + 1) * 40503u);
+    };
+
+    for (size_t probeIndex = 0; probeIndex < latticeProbes.size(); ++probeIndex) {
+        const LatticeProbe& lattice = latticeProbes[probeIndex];
+        // Probes in a dense brick relocate and trace visibility at the dense spacing.
+        float minSpacing = lattice.dense ? std::max(0.25f, coarseMinSpacing / static_cast<float>(denseSteps)) : coarseMinSpacing;
+        float maxSpacing = lattice.dense ? denseSpacing : coarseMaxSpacing;
+        float relocationClearance = std::max(0.12f, minSpacing * 0.3f);
+        float visibilityDistance = std::max(1.5f, maxSpacing * 1.75f);
+
+        Math::Vector3 gridPositionWS = ComputeProbeGridPosition(boundsMin, boundsMin + extent,
+                                                                lattice.x, lattice.y, lattice.z,
+                                                                latticeX, latticeY, latticeZ);
+        float probeValidity = 1.0f;
+        Math::Vector3 positionWS = RelocateProbePosition(scene,
+                                                         gridPositionWS,
+                                                         boundsMin,
+                                                         boundsMax,
+                                                         relocationClearance,
+                                                         visibilityDistance,
+                                                         probeValidity);
+        ProbeVolumeRecord& record = records[probeIndex];
+        record.positionAndValidity[0] = positionWS.x;
+        record.positionAndValidity[1] = positionWS.y;
+        record.positionAndValidity[2] = positionWS.z;
+        record.positionAndValidity[3] = probeValidity;
+
+        float probeVisibility[6] = {};
+        for (int faceIndex = 0; faceIndex < 6; ++faceIndex) {
+            probeVisibility[faceIndex] = TraceProbeVisibilityDistance(scene,
+                                                                      positionWS,
+                                                                      probeNormals[faceIndex],
+                                                                      visibilityDistance);
+        }
+        record.visibility[0][0] = probeVisibility[0];
+        record.visibility[0][1] = probeVisibility[1];
+        record.visibility[0][2] = probeVisibility[2];
+        record.visibility[0][3] = probeVisibility[3];
+        record.visibility[1][0] = probeVisibility[4];
+        record.visibility[1][1] = probeVisibility[5];
+        record.visibility[1][2] = visibilityDistance;
+        record.visibility[1][3] = 0.0f;
+    }
+
+    auto storeFace = [&](ProbeVolumeRecord& record, int faceIndex, const Math::Vector3& lighting, const Math::Vector3& specularLighting) {
+        record.ambientCube[faceIndex][0] = lighting.x;
+        record.ambientCube[faceIndex][1] = lighting.y;
+        record.ambientCube[faceIndex][2] = lighting.z;
+        record.ambientCube[faceIndex][3] = 1.0f;
+        record.specularCube[faceIndex][0] = specularLighting.x;
+        record.specularCube[faceIndex][1] = specularLighting.y;
+        record.specularCube[faceIndex][2] = specularLighting.z;
+        record.specularCube[faceIndex][3] = 1.0f;
+    };
+
+    bool litOnGPU = false;
+    if (gpuBaker) {
+        std::vector<GPULightBakeQuery> queries;
+        queries.reserve(records.size() * 12u);
+        for (size_t probeIndex = 0; probeIndex < records.size(); ++probeIndex) {
+            const LatticeProbe& lattice = latticeProbes[probeIndex];
+            const ProbeVolumeRecord& record = records[probeIndex];
+            Math::Vector3 positionWS(record.positionAndValidity[0], record.positionAndValidity[1], record.positionAndValidity[2]);
+            for (int faceIndex = 0; faceIndex < 6; ++faceIndex) {
+                Math::Vector3 samplePositionWS = positionWS + probeNormals[faceIndex] * 0.02f;
+                queries.push_back(BuildProbeQuery(GPULightBakeQuery::ProbeIrradiance, samplePositionWS, probeNormals[faceIndex],
+                                                  irradianceSeed(lattice.x, lattice.y, lattice.z, faceIndex), probeSamples));
+                queries.push_back(BuildProbeQuery(GPULightBakeQuery::ProbeSpecular, samplePositionWS, probeNormals[faceIndex],
+                                                  specularSeed(lattice.x, lattice.y, lattice.z, faceIndex), probeSamples));
+            }
+        }
+
+        std::vector<GPULightBakeResult> results;
+        litOnGPU = gpuBaker->trace(queries, results, [](size_t) {
+            return !g_StaticLightmapBakeCancel.load(std::memory_order_relaxed);
+        });
+        if (g_StaticLightmapBakeCancel.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (litOnGPU) {
+            for (size_t index = 0; index < records.size(); ++index) {
                 for (int faceIndex = 0; faceIndex < 6; ++faceIndex) {
-                    probeVisibility[faceIndex] = TraceProbeVisibilityDistance(scene,
-                                                                              positionWS,
-                                                                              probeNormals[faceIndex],
-                                                                              visibilityDistance);
-                    Math::Vector3 lighting = EvaluateBakedLightingAtPoint(
-                        scene,
-                        bakeSettings,
-                        bakedLights,
-                        emissiveSurfaces,
-                        positionWS + probeNormals[faceIndex] * 0.02f,
-                        probeNormals[faceIndex],
-                        static_cast<uint32_t>((x + 1) * 73856093u)
-                            ^ static_cast<uint32_t>((y + 1) * 19349663u)
-                            ^ static_cast<uint32_t>((z + 1) * 83492791u)
-                            ^ static_cast<uint32_t>((faceIndex + 1) * 2654435761u),
-                        probeSamples
-                    );
-                    record.ambientCube[faceIndex][0] = lighting.x;
-                    record.ambientCube[faceIndex][1] = lighting.y;
-                    record.ambientCube[faceIndex][2] = lighting.z;
-                    record.ambientCube[faceIndex][3] = 1.0f;
-
-                    Math::Vector3 specularLighting = EvaluateSpecularProbeLightingAtPoint(
-                        scene,
-                        bakeSettings,
-                        bakedLights,
-                        emissiveSurfaces,
-                        positionWS + probeNormals[faceIndex] * 0.02f,
-                        probeNormals[faceIndex],
-                        static_cast<uint32_t>((x + 1) * 2166136261u)
-                            ^ static_cast<uint32_t>((y + 1) * 16777619u)
-                            ^ static_cast<uint32_t>((z + 1) * 709607u)
-                            ^ static_cast<uint32_t>((faceIndex + 1) * 40503u),
-                        probeSamples
-                    );
-                    record.specularCube[faceIndex][0] = specularLighting.x;
-                    record.specularCube[faceIndex][1] = specularLighting.y;
-                    record.specularCube[faceIndex][2] = specularLighting.z;
-                    record.specularCube[faceIndex][3] = 1.0f;
+                    const GPULightBakeResult& irradiance = results[index * 12u + static_cast<size_t>(faceIndex) * 2u];
+                    const GPULightBakeResult& specular = results[index * 12u + static_cast<size_t>(faceIndex) * 2u + 1u];
+                    storeFace(records[index], faceIndex,
+                              Math::Vector3(irradiance.direct[0], irradiance.direct[1], irradiance.direct[2]),
+                              Math::Vector3(specular.direct[0], specular.direct[1], specular.direct[2]));
                 }
-                record.visibility[0][0] = probeVisibility[0];
-                record.visibility[0][1] = probeVisibility[1];
-                record.visibility[0][2] = probeVisibility[2];
-                record.visibility[0][3] = probeVisibility[3];
-                record.visibility[1][0] = probeVisibility[4];
-                record.visibility[1][1] = probeVisibility[5];
-                record.visibility[1][2] = visibilityDistance;
-                record.visibility[1][3] = 0.0f;
             }
+        } else {
+            std::cerr << "[StaticLighting] GPU probe bake failed; baking probes on the CPU" << std::endl;
+        }
+    }
+
+    for (size_t probeIndex = 0; !litOnGPU && probeIndex < records.size(); ++probeIndex) {
+        const LatticeProbe& lattice = latticeProbes[probeIndex];
+        ProbeVolumeRecord& record = records[probeIndex];
+        Math::Vector3 positionWS(record.positionAndValidity[0], record.positionAndValidity[1], record.positionAndValidity[2]);
+        for (int faceIndex = 0; faceIndex < 6; ++faceIndex) {
+            Math::Vector3 lighting = EvaluateBakedLightingAtPoint(
+                scene,
+                bakeSettings,
+                bakedLights,
+                emissiveSurfaces,
+                positionWS + probeNormals[faceIndex] * 0.02f,
+                probeNormals[faceIndex],
+                irradianceSeed(lattice.x, lattice.y, lattice.z, faceIndex),
+                probeSamples
+            );
+            Math::Vector3 specularLighting = EvaluateSpecularProbeLightingAtPoint(
+                scene,
+                bakeSettings,
+                bakedLights,
+                emissiveSurfaces,
+                positionWS + probeNormals[faceIndex] * 0.02f,
+                probeNormals[faceIndex],
+                specularSeed(lattice.x, lattice.y, lattice.z, faceIndex),
+                probeSamples
+            );
+            storeFace(record, faceIndex, lighting, specularLighting);
         }
     }
 
+    std::vector<ProbeVolumeRecord> coarseProbes;
+    coarseProbes.reserve(coarseProbeIndices.size());
+    for (uint32_t index : coarseProbeIndices) {
+        coarseProbes.push_back(records[index]);
+    }
+    std::vector<ProbeVolumeRecord> denseProbes;
+    denseProbes.reserve(denseProbeIndices.size());
+    for (uint32_t index : denseProbeIndices) {
+        denseProbes.push_back(records[index]);
+    }
+
     std::string outputPath = BuildProbeVolumeArtifactPath(scene, bakeSettings, scenePath);
     std::error_code ec;
     std::filesystem::create_directories(std::filesystem::path(outputPath).parent_path(), ec);
 
     ProbeVolumeFileHeader header{};
-    header.magic[0] = 'C';
-    header.magic[1] = 'P';
-    header.magic[2] = 'R';
-    header.magic[3] = 'B';
-    header.version = 3u;
-    header.countX = static_cast<uint32_t>(countX);
-    header.countY = static_cast<uint32_t>(countY);
-    header.countZ = static_cast<uint32_t>(countZ);
+    header.countX = static_cast<uint32_t>(cellsX);
+    header.countY = static_cast<uint32_t>(cellsY);
+    header.countZ = static_cast<uint32_t>(cellsZ);
     header.boundsMin[0] = boundsMin.x;
     header.boundsMin[1] = boundsMin.y;
     header.boundsMin[2] = boundsMin.z;
-    header.boundsMax[0] = boundsMax.x;
-    header.boundsMax[1] = boundsMax.y;
-    header.boundsMax[2] = boundsMax.z;
+    header.boundsMax[0] = boundsMin.x + extent.x;
+    header.boundsMax[1] = boundsMin.y + extent.y;
+    header.boundsMax[2] = boundsMin.z + extent.z;
 
-    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
-    if (!out.is_open()) {
-        return false;
-    }
-    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
-    out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(ProbeVolumeFileRecord)));
-    if (!out.good()) {
+    if (!WriteProbeVolumeFile(outputPath, header, denseBrickOfCell, coarseProbes, denseProbes)) {
         return false;
     }
+    std::cout << "[StaticLighting] Baked " << records.size() << " probes: " << denseBrickCount << "/" << cellCount
+              << " cells dense, " << static_cast<size_t>(latticeX) * latticeY * latticeZ
+              << " for a uniform grid at the dense spacing" << std::endl;
 
     SceneSettings updatedSettings = scene->getSettings();
     updatedSettings.staticLighting.probeVolume = true;
@@ -2364,6 +3578,9 @@ static bool BakeProbeVolume(Scene* scene,
     return true;
 }
 
+// Edge-aware a-trous filter over the indirect lighting, guided by the direct lighting's
+// luminance. Each pass splits the atlas into bands of kLightmapBakeTileSize rows that the job
+// workers filter in parallel; the three edge-stopping terms share one exp per tap.
 static void DenoiseIndirectAtlas(const std::vector<float>& guideDirectLighting,
                                  const std::vector<uint16_t>& coverage,
                                  int width,
@@ -2373,6 +3590,14 @@ static void DenoiseIndirectAtlas(const std::vector<float>& guideDirectLighting,
         return;
     }
 
+    const size_t pixelCount = static_cast<size_t>(width) * static_cast<size_t>(height);
+    std::vector<float> guide(pixelCount);
+    for (size_t pixelIndex = 0; pixelIndex < pixelCount; ++pixelIndex) {
+        guide[pixelIndex] = ComputeLuminance(Math::Vector3(guideDirectLighting[pixelIndex * 3 + 0],
+                                                           guideDirectLighting[pixelIndex * 3 + 1],
+                                                           guideDirectLighting[pixelIndex * 3 + 2]));
+    }
+
     std::vector<float> ping = indirectLighting;
     std::vector<float> pong(indirectLighting.size(), 0.0f);
     const int stepWidths[3] = {1, 2, 4};
@@ -2383,17 +3608,21 @@ static void DenoiseIndirectAtlas(const std::vector<float>& guideDirectLighting,
     };
 
     auto loadVec3 = [](const std::vector<float>& buffer, size_t pixelIndex) {
-        return Math::Vector3(buffer[pixelIndex * 3 + 0], buffer[pixelIndex * 3 + 1], buffer[pixelIndex * 3 + 2]);
+        const float* value = buffer.data() + pixelIndex * 3;
+        return Math::Vector3(value[0], value[1], value[2]);
     };
     auto storeVec3 = [](std::vector<float>& buffer, size_t pixelIndex, const Math::Vector3& value) {
-        buffer[pixelIndex * 3 + 0] = value.x;
-        buffer[pixelIndex * 3 + 1] = value.y;
-        buffer[pixelIndex * 3 + 2] = value.z;
+        float* target = buffer.data() + pixelIndex * 3;
+        target[0] = value.x;
+        target[1] = value.y;
+        target[2] = value.z;
     };
 
-    for (int pass = 0; pass < 3; ++pass) {
-        int step = stepWidths[pass];
-        for (int y = 0; y < height; ++y) {
+    int step = 1;
+    auto filterRows = [&](int rowBegin, int rowEnd) {
+        const float guideFalloff = 2.8f / static_cast<float>(step);
+        const float colorFalloff = 2.0f / static_cast<float>(step);
+        for (int y = rowBegin; y < rowEnd; ++y) {
             for (int x = 0; x < width; ++x) {
                 size_t pixelIndex = static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x);
                 if (coverage[pixelIndex] == 0u) {
@@ -2401,8 +3630,9 @@ static void DenoiseIndirectAtlas(const std::vector<float>& guideDirectLighting,
                     continue;
                 }
 
-                Math::Vector3 centerIndirect = loadVec3(ping, pixelIndex);
-                float centerGuide = ComputeLuminance(loadVec3(guideDirectLighting, pixelIndex));
+                const Math::Vector3 centerIndirect = loadVec3(ping, pixelIndex);
+                const float centerGuide = guide[pixelIndex];
+                const float centerCoverage = static_cast<float>(coverage[pixelIndex]);
                 Math::Vector3 filtered = Math::Vector3::Zero;
                 float totalWeight = 0.0f;
 
@@ -2422,28 +3652,43 @@ static void DenoiseIndirectAtlas(const std::vector<float>& guideDirectLighting,
                             continue;
                         }
 
-                        Math::Vector3 sampleIndirect = loadVec3(ping, sampleIndex);
-                        float sampleGuide = ComputeLuminance(loadVec3(guideDirectLighting, sampleIndex));
-                        float guideDelta = std::abs(sampleGuide - centerGuide);
+                        const Math::Vector3 sampleIndirect = loadVec3(ping, sampleIndex);
+                        float guideDelta = std::abs(guide[sampleIndex] - centerGuide);
                         float colorDelta = (sampleIndirect - centerIndirect).length();
-                        float coverageSimilarity = std::abs(static_cast<float>(coverage[sampleIndex]) - static_cast<float>(coverage[pixelIndex]));
+                        float coverageSimilarity = std::abs(static_cast<float>(coverage[sampleIndex]) - centerCoverage);
                         float weight = spatialWeights[oy + 1][ox + 1]
-                            * std::exp(-guideDelta * (2.8f / static_cast<float>(step)))
-                            * std::exp(-colorDelta * (2.0f / static_cast<float>(step)))
-                            * std::exp(-coverageSimilarity * 0.08f);
+                            * std::exp(-(guideDelta * guideFalloff + colorDelta * colorFalloff + coverageSimilarity * 0.08f));
                         filtered += sampleIndirect * weight;
                         totalWeight += weight;
                     }
                 }
 
-                if (totalWeight > Math::EPSILON) {
-                    filtered /= totalWeight;
-                } else {
-                    filtered = centerIndirect;
-                }
-                storeVec3(pong, pixelIndex, filtered);
+                storeVec3(pong, pixelIndex, totalWeight > Math::EPSILON ? filtered / totalWeight : centerIndirect);
             }
         }
+    };
+
+    const int bandCount = (height + kLightmapBakeTileSize - 1) / kLightmapBakeTileSize;
+    std::atomic<int> nextBand{0};
+    auto filterBands = [&]() {
+        for (int band = nextBand++; band < bandCount; band = nextBand++) {
+            const int rowBegin = band * kLightmapBakeTileSize;
+            filterRows(rowBegin, std::min(height, rowBegin + kLightmapBakeTileSize));
+        }
+    };
+    JobScheduler& scheduler = JobScheduler::getInstance();
+    const size_t workerCount = scheduler.isRunning() ? scheduler.workerCount() : 0;
+    for (int pass = 0; pass < 3; ++pass) {
+        step = stepWidths[pass];
+        nextBand.store(0);
+        auto fence = std::make_shared<JobFence>();
+        const size_t helperCount = std::min(workerCount, static_cast<size_t>(bandCount));
+        for (size_t helper = 0; helper < helperCount; ++helper) {
+            fence->remaining.fetch_add(1, std::memory_order_relaxed);
+            scheduler.schedule([&filterBands]() { filterBands(); }, fence);
+        }
+        filterBands();
+        scheduler.wait(*fence);
         ping.swap(pong);
     }
 
@@ -3658,6 +4903,10 @@ static std::shared_ptr<Mesh> BuildMesh(const aiMesh* mesh, const Skeleton* skele
     if (skeleton && mesh->HasBones()) {
         ApplySkinWeights(mesh, *result, *skeleton);
     }
+
+#if CRESCENT_HAS_MESHOPTIMIZER
+    GenerateMeshLods(*result);
+#endif
     
     return result;
 }
@@ -3848,41 +5097,327 @@ static void ImportNodeRecursive(const aiNode* node,
     }
 }
 
-} // namespace
+// Reading and mesh processing shares of an import's progress; instancing takes the rest.
+constexpr float kImportReadShare = 0.6f;
+constexpr float kImportMeshShare = 0.35f;
 
-Entity* SceneCommands::createCube(Scene* scene, const std::string& name) {
-    if (!scene) return nullptr;
-    
-    Entity* entity = scene->createEntity(name);
-    
-    // Add MeshRenderer
-    MeshRenderer* renderer = entity->addComponent<MeshRenderer>();
-    renderer->setMesh(Mesh::CreateCube(1.0f));
-    renderer->setMaterial(Material::CreateDefault());
-    ConfigurePrimitiveStaticLighting(renderer);
-    entity->addComponent<PrimitiveMesh>()->setType(PrimitiveType::Cube);
-    
-    return entity;
-}
+enum class ModelImportStage {
+    Reading,
+    ProcessingMeshes,
+    CreatingEntities
+};
 
-Entity* SceneCommands::createSphere(Scene* scene, const std::string& name) {
-    if (!scene) return nullptr;
-    
-    Entity* entity = scene->createEntity(name);
-    
-    MeshRenderer* renderer = entity->addComponent<MeshRenderer>();
-    renderer->setMesh(Mesh::CreateSphere(0.5f, 32, 16));
-    renderer->setMaterial(Material::CreateDefault());
-    ConfigurePrimitiveStaticLighting(renderer);
-    entity->addComponent<PrimitiveMesh>()->setType(PrimitiveType::Sphere);
-    
-    return entity;
-}
+struct ModelImportState {
+    std::atomic<int> stage{static_cast<int>(ModelImportStage::Reading)};
+    std::atomic<float> progress{0.0f};
 
-Entity* SceneCommands::createPlane(Scene* scene, const std::string& name) {
-    if (!scene) return nullptr;
-    
-    Entity* entity = scene->createEntity(name);
+    void set(ModelImportStage value, float fraction) {
+        stage.store(static_cast<int>(value), std::memory_order_relaxed);
+        progress.store(fraction, std::memory_order_relaxed);
+    }
+};
+
+class ModelImportProgressHandler : public Assimp::ProgressHandler {
+public:
+    explicit ModelImportProgressHandler(std::shared_ptr<ModelImportState> state)
+        : m_state(std::move(state)) {
+    }
+
+    bool Update(float percentage) override {
+        if (percentage >= 0.0f) {
+            m_state->progress.store(std::min(percentage, 1.0f) * kImportReadShare, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+private:
+    std::shared_ptr<ModelImportState> m_state;
+};
+
+// Everything an import takes from Assimp before it touches the scene. Building it loads no
+// textures and creates no entities, so it can run off the engine thread.
+struct ModelSource {
+    std::unique_ptr<Assimp::Importer> importer;
+    const aiScene* aiScene = nullptr;
+    std::shared_ptr<Skeleton> skeleton;
+    std::vector<std::shared_ptr<AnimationClip>> animations;
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    std::vector<bool> meshIsSkinned;
+};
+
+// Runs fn(i) for every i below count on the calling thread and up to hardware_concurrency - 1
+// helpers.
+template <typename Fn>
+static void ParallelFor(size_t count, const Fn& fn) {
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            fn(i);
+        }
+    };
+    const size_t threadCount = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < threadCount; ++i) {
+        helpers.emplace_back(work);
+    }
+    work();
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+}
+
+static std::unique_ptr<ModelSource> LoadModelSource(const std::string& path,
+                                                    const SceneCommands::ModelImportOptions& options,
+                                                    const std::shared_ptr<ModelImportState>& state) {
+    auto source = std::make_unique<ModelSource>();
+    source->importer = std::make_unique<Assimp::Importer>();
+    Assimp::Importer& importer = *source->importer;
+    importer.SetPropertyBool(AI_CONFIG_IMPORT_FBX_PRESERVE_PIVOTS, false);
+    if (options.scale > 0.0f && options.scale != 1.0f) {
+        importer.SetPropertyFloat(AI_CONFIG_GLOBAL_SCALE_FACTOR_KEY, options.scale);
+    }
+    if (state) {
+        // The importer owns the handler and deletes it.
+        importer.SetProgressHandler(new ModelImportProgressHandler(state));
+    }
+    unsigned int flags = aiProcess_Triangulate |
+                         aiProcess_GenSmoothNormals |
+                         aiProcess_CalcTangentSpace |
+                         aiProcess_JoinIdenticalVertices |
+                         aiProcess_ImproveCacheLocality |
+                         aiProcess_OptimizeMeshes |
+                         aiProcess_OptimizeGraph |
+                         aiProcess_GlobalScale;
+    if (options.flipUVs) {
+        flags |= aiProcess_FlipUVs;
+    }
+
+    const aiScene* scene = importer.ReadFile(path, flags);
+    if (!scene || !scene->mRootNode) {
+        std::cerr << "[ModelImporter] Failed to read: " << path << " (" << importer.GetErrorString() << ")" << std::endl;
+        return nullptr;
+    }
+    source->aiScene = scene;
+    if (state) {
+        state->set(ModelImportStage::ProcessingMeshes, kImportReadShare);
+    }
+
+    source->skeleton = BuildSkeleton(scene);
+    if (source->skeleton) {
+        source->animations = BuildAnimations(scene, *source->skeleton, std::filesystem::path(path).stem().string());
+    }
+
+    // Skin weights, tangent fixups and LOD simplification only read their own aiMesh, and they
+    // are most of an import's time on large models.
+    const size_t meshCount = scene->mNumMeshes;
+    source->meshes.resize(meshCount);
+    std::atomic<size_t> built{0};
+    ParallelFor(meshCount, [&](size_t i) {
+        source->meshes[i] = BuildMesh(scene->mMeshes[i], source->skeleton.get());
+        if (state) {
+            const float fraction = static_cast<float>(++built) / static_cast<float>(meshCount);
+            state->progress.store(kImportReadShare + kImportMeshShare * fraction, std::memory_order_relaxed);
+        }
+    });
+    source->meshIsSkinned.reserve(meshCount);
+    for (size_t i = 0; i < meshCount; ++i) {
+        const aiMesh* mesh = scene->mMeshes[i];
+        source->meshIsSkinned.push_back(mesh && mesh->HasBones());
+    }
+    return source;
+}
+
+static Entity* InstantiateModel(Scene* scene,
+                                ModelSource& source,
+                                const std::string& path,
+                                const SceneCommands::ModelImportOptions& options,
+                                const std::string& name) {
+    const aiScene* aiScene = source.aiScene;
+    ImportContext context;
+    context.scene = scene;
+    context.aiScene = aiScene;
+    context.baseDir = std::filesystem::path(path).parent_path().string();
+    context.sourcePath = path;
+    context.options = options;
+    if (context.baseDir.empty()) {
+        context.baseDir = ".";
+    }
+
+    std::string guid = AssetDatabase::getInstance().registerAsset(path, "model");
+    if (!guid.empty()) {
+        AssetDatabase::getInstance().updateModelImportSettings(guid, options);
+    }
+    
+    Renderer* renderer = Engine::getInstance().getRenderer();
+    context.textureLoader = renderer ? renderer->getTextureLoader() : nullptr;
+    if (!context.textureLoader) {
+        std::cerr << "[ModelImporter] Texture loader unavailable; importing without textures" << std::endl;
+    }
+
+    context.skeleton = source.skeleton;
+    context.animations = source.animations;
+    context.meshes = source.meshes;
+    const std::vector<bool>& meshIsSkinned = source.meshIsSkinned;
+
+    context.materials.reserve(aiScene->mNumMaterials);
+    for (unsigned int i = 0; i < aiScene->mNumMaterials; ++i) {
+        context.materials.push_back(BuildMaterial(context, aiScene->mMaterials[i]));
+    }
+    if (context.materials.empty()) {
+        context.materials.push_back(Material::CreateDefault());
+    }
+    
+    std::string rootName = name;
+    if (rootName.empty()) {
+        rootName = std::filesystem::path(path).stem().string();
+        if (rootName.empty()) {
+            rootName = SafeName(aiScene->mRootNode->mName, "Model");
+        }
+    }
+    
+    Entity* root = scene->createEntity(rootName);
+    std::unordered_map<const aiNode*, bool> skinnedNodeCache;
+    ImportNodeRecursive(aiScene->mRootNode, context, nullptr, root, &meshIsSkinned, &skinnedNodeCache);
+
+    if (context.skeleton && !context.animations.empty()) {
+        Animator* animator = root->addComponent<Animator>();
+        std::vector<AnimatorState> states;
+        states.reserve(context.animations.size());
+        for (size_t clipIndex = 0; clipIndex < context.animations.size(); ++clipIndex) {
+            std::string clipName = context.animations[clipIndex]
+                ? context.animations[clipIndex]->getName()
+                : "";
+            if (clipName.empty()) {
+                clipName = "Clip " + std::to_string(clipIndex);
+            }
+            AnimatorState state;
+            state.name = clipName;
+            state.clipIndex = static_cast<int>(clipIndex);
+            state.speed = 1.0f;
+            states.push_back(state);
+        }
+        animator->setStates(states);
+        animator->setDefaultBlendDuration(0.25f);
+        animator->setAutoPlay(true);
+    }
+
+    if (context.options.mergeStaticMeshes) {
+        std::unordered_map<unsigned int, MergedStaticMesh> merged;
+        Math::Matrix4x4 rootWorld = ToMatrix(GetNodeWorldTransform(aiScene->mRootNode));
+        Math::Matrix4x4 rootInverse = rootWorld.inversed();
+        BuildStaticMergeRecursive(aiScene->mRootNode,
+                                  Math::Matrix4x4::Identity,
+                                  rootInverse,
+                                  context,
+                                  meshIsSkinned,
+                                  merged);
+
+        std::vector<MergedStaticMesh*> mergedMeshes;
+        for (auto& entry : merged) {
+            if (!entry.second.vertices.empty() && !entry.second.indices.empty()) {
+                mergedMeshes.push_back(&entry.second);
+            }
+        }
+        std::vector<std::shared_ptr<Mesh>> combinedMeshes(mergedMeshes.size());
+        ParallelFor(mergedMeshes.size(), [&](size_t i) {
+            auto combined = std::make_shared<Mesh>();
+            combined->setName(rootName + "_Static");
+            combined->setVertices(mergedMeshes[i]->vertices);
+            combined->setIndices(mergedMeshes[i]->indices);
+#if CRESCENT_HAS_MESHOPTIMIZER
+            GenerateMeshLods(*combined);
+#endif
+            combinedMeshes[i] = std::move(combined);
+        });
+
+        for (size_t mergedIndex = 0; mergedIndex < mergedMeshes.size(); ++mergedIndex) {
+            MergedStaticMesh& mergedMesh = *mergedMeshes[mergedIndex];
+            std::shared_ptr<Mesh> combined = combinedMeshes[mergedIndex];
+
+            std::shared_ptr<Material> material = Material::CreateDefault();
+            if (mergedMesh.materialIndex < context.materials.size()) {
+                material = context.materials[mergedMesh.materialIndex];
+            }
+
+            std::string entityName = rootName + " Static";
+            if (material && !material->getName().empty()) {
+                entityName = rootName + " " + material->getName();
+            }
+            Entity* mergedEntity = scene->createEntity(entityName);
+            mergedEntity->getTransform()->setParent(root->getTransform(), false);
+            MeshRenderer* renderer = mergedEntity->addComponent<MeshRenderer>();
+            renderer->setMesh(combined);
+            renderer->setMaterial(material);
+            ModelMeshReference* reference = mergedEntity->addComponent<ModelMeshReference>();
+            reference->setSourcePath(context.sourcePath);
+            reference->setSourceGuid(AssetDatabase::getInstance().registerAsset(context.sourcePath, "model"));
+            reference->setMeshIndex(-1);
+            reference->setMaterialIndex(static_cast<int>(mergedMesh.materialIndex));
+            reference->setMeshName(combined->getName());
+            reference->setSkinned(false);
+            reference->setMerged(true);
+            reference->setImportOptions(context.options);
+        }
+    }
+    
+    std::cout << "[ModelImporter] Imported " << context.meshes.size() << " mesh(es) from " << path << std::endl;
+    if (!guid.empty()) {
+        AssetDatabase::getInstance().recordImportForGuid(guid);
+    }
+    return root;
+}
+
+// Background imports in flight. A worker fills in source, then sets finished; the engine thread
+// takes finished jobs out in processModelImports.
+struct PendingModelImport {
+    uint64_t id = 0;
+    std::string path;
+    SceneCommands::ModelImportOptions options;
+    std::string name;
+    std::shared_ptr<ModelImportState> state;
+    std::unique_ptr<ModelSource> source;
+    std::atomic<bool> finished{false};
+};
+
+std::mutex g_ModelImportMutex;
+std::vector<std::shared_ptr<PendingModelImport>> g_ModelImports;
+uint64_t g_NextModelImportId = 1;
+
+} // namespace
+
+Entity* SceneCommands::createCube(Scene* scene, const std::string& name) {
+    if (!scene) return nullptr;
+    
+    Entity* entity = scene->createEntity(name);
+    
+    // Add MeshRenderer
+    MeshRenderer* renderer = entity->addComponent<MeshRenderer>();
+    renderer->setMesh(Mesh::CreateCube(1.0f));
+    renderer->setMaterial(Material::CreateDefault());
+    ConfigurePrimitiveStaticLighting(renderer);
+    entity->addComponent<PrimitiveMesh>()->setType(PrimitiveType::Cube);
+    
+    return entity;
+}
+
+Entity* SceneCommands::createSphere(Scene* scene, const std::string& name) {
+    if (!scene) return nullptr;
+    
+    Entity* entity = scene->createEntity(name);
+    
+    MeshRenderer* renderer = entity->addComponent<MeshRenderer>();
+    renderer->setMesh(Mesh::CreateSphere(0.5f, 32, 16));
+    renderer->setMaterial(Material::CreateDefault());
+    ConfigurePrimitiveStaticLighting(renderer);
+    entity->addComponent<PrimitiveMesh>()->setType(PrimitiveType::Sphere);
+    
+    return entity;
+}
+
+Entity* SceneCommands::createPlane(Scene* scene, const std::string& name) {
+    if (!scene) return nullptr;
+    
+    Entity* entity = scene->createEntity(name);
     
     MeshRenderer* renderer = entity->addComponent<MeshRenderer>();
     renderer->setMesh(Mesh::CreatePlane(10.0f, 10.0f, 1, 1));
@@ -4051,159 +5586,85 @@ Entity* SceneCommands::importModel(Scene* scene, const std::string& path, const
         std::cerr << "[ModelImporter] Empty model path" << std::endl;
         return nullptr;
     }
-    
-    Assimp::Importer importer;
-    importer.SetPropertyBool(AI_CONFIG_IMPORT_FBX_PRESERVE_PIVOTS, false);
-    if (options.scale > 0.0f && options.scale != 1.0f) {
-        importer.SetPropertyFloat(AI_CONFIG_GLOBAL_SCALE_FACTOR_KEY, options.scale);
-    }
-    unsigned int flags = aiProcess_Triangulate |
-                         aiProcess_GenSmoothNormals |
-                         aiProcess_CalcTangentSpace |
-                         aiProcess_JoinIdenticalVertices |
-                         aiProcess_ImproveCacheLocality |
-                         aiProcess_OptimizeMeshes |
-                         aiProcess_OptimizeGraph |
-                         aiProcess_GlobalScale;
-    if (options.flipUVs) {
-        flags |= aiProcess_FlipUVs;
-    }
-    
-    const aiScene* aiScene = importer.ReadFile(path, flags);
-    if (!aiScene || !aiScene->mRootNode) {
-        std::cerr << "[ModelImporter] Failed to read: " << path << " (" << importer.GetErrorString() << ")" << std::endl;
+    std::unique_ptr<ModelSource> source = LoadModelSource(path, options, nullptr);
+    if (!source) {
         return nullptr;
     }
-    
-    ImportContext context;
-    context.scene = scene;
-    context.aiScene = aiScene;
-    context.baseDir = std::filesystem::path(path).parent_path().string();
-    context.sourcePath = path;
-    context.options = options;
-    if (context.baseDir.empty()) {
-        context.baseDir = ".";
-    }
+    return InstantiateModel(scene, *source, path, options, name);
+}
 
-    std::string guid = AssetDatabase::getInstance().registerAsset(path, "model");
-    if (!guid.empty()) {
-        AssetDatabase::getInstance().updateModelImportSettings(guid, options);
-    }
-    
-    Renderer* renderer = Engine::getInstance().getRenderer();
-    context.textureLoader = renderer ? renderer->getTextureLoader() : nullptr;
-    if (!context.textureLoader) {
-        std::cerr << "[ModelImporter] Texture loader unavailable; importing without textures" << std::endl;
+uint64_t SceneCommands::importModelAsync(const std::string& path, const ModelImportOptions& options, const std::string& name) {
+    if (path.empty()) {
+        std::cerr << "[ModelImporter] Empty model path" << std::endl;
+        return 0;
     }
+    auto job = std::make_shared<PendingModelImport>();
+    job->path = path;
+    job->options = options;
+    job->name = name;
+    job->state = std::make_shared<ModelImportState>();
+    {
+        std::lock_guard<std::mutex> lock(g_ModelImportMutex);
+        job->id = g_NextModelImportId++;
+        g_ModelImports.push_back(job);
+    }
+    // Detached: the job is shared with the registry, which hands the result to the engine thread.
+    std::thread([job]() {
+        // The editor stays responsive while the import runs; its helper threads inherit this.
+        SetCurrentThreadQoS(ThreadQoS::UserInitiated);
+        job->source = LoadModelSource(job->path, job->options, job->state);
+        job->state->set(ModelImportStage::CreatingEntities, kImportReadShare + kImportMeshShare);
+        job->finished.store(true, std::memory_order_release);
+    }).detach();
+    return job->id;
+}
 
-    context.skeleton = BuildSkeleton(aiScene);
-    if (context.skeleton) {
-        context.animations = BuildAnimations(aiScene, *context.skeleton, std::filesystem::path(path).stem().string());
-    }
-    
-    context.meshes.reserve(aiScene->mNumMeshes);
-    std::vector<bool> meshIsSkinned;
-    meshIsSkinned.reserve(aiScene->mNumMeshes);
-    for (unsigned int i = 0; i < aiScene->mNumMeshes; ++i) {
-        aiMesh* aiMeshPtr = aiScene->mMeshes[i];
-        context.meshes.push_back(BuildMesh(aiMeshPtr, context.skeleton.get()));
-        meshIsSkinned.push_back(aiMeshPtr && aiMeshPtr->HasBones());
-    }
-    
-    context.materials.reserve(aiScene->mNumMaterials);
-    for (unsigned int i = 0; i < aiScene->mNumMaterials; ++i) {
-        context.materials.push_back(BuildMaterial(context, aiScene->mMaterials[i]));
-    }
-    if (context.materials.empty()) {
-        context.materials.push_back(Material::CreateDefault());
-    }
-    
-    std::string rootName = name;
-    if (rootName.empty()) {
-        rootName = std::filesystem::path(path).stem().string();
-        if (rootName.empty()) {
-            rootName = SafeName(aiScene->mRootNode->mName, "Model");
-        }
+size_t SceneCommands::processModelImports(Scene* scene) {
+    if (!scene) {
+        return 0;
     }
-    
-    Entity* root = scene->createEntity(rootName);
-    std::unordered_map<const aiNode*, bool> skinnedNodeCache;
-    ImportNodeRecursive(aiScene->mRootNode, context, nullptr, root, &meshIsSkinned, &skinnedNodeCache);
-
-    if (context.skeleton && !context.animations.empty()) {
-        Animator* animator = root->addComponent<Animator>();
-        std::vector<AnimatorState> states;
-        states.reserve(context.animations.size());
-        for (size_t clipIndex = 0; clipIndex < context.animations.size(); ++clipIndex) {
-            std::string clipName = context.animations[clipIndex]
-                ? context.animations[clipIndex]->getName()
-                : "";
-            if (clipName.empty()) {
-                clipName = "Clip " + std::to_string(clipIndex);
+    std::vector<std::shared_ptr<PendingModelImport>> finished;
+    {
+        std::lock_guard<std::mutex> lock(g_ModelImportMutex);
+        for (auto it = g_ModelImports.begin(); it != g_ModelImports.end();) {
+            if ((*it)->finished.load(std::memory_order_acquire)) {
+                finished.push_back(std::move(*it));
+                it = g_ModelImports.erase(it);
+            } else {
+                ++it;
             }
-            AnimatorState state;
-            state.name = clipName;
-            state.clipIndex = static_cast<int>(clipIndex);
-            state.speed = 1.0f;
-            states.push_back(state);
         }
-        animator->setStates(states);
-        animator->setDefaultBlendDuration(0.25f);
-        animator->setAutoPlay(true);
     }
-
-    if (context.options.mergeStaticMeshes) {
-        std::unordered_map<unsigned int, MergedStaticMesh> merged;
-        Math::Matrix4x4 rootWorld = ToMatrix(GetNodeWorldTransform(aiScene->mRootNode));
-        Math::Matrix4x4 rootInverse = rootWorld.inversed();
-        BuildStaticMergeRecursive(aiScene->mRootNode,
-                                  Math::Matrix4x4::Identity,
-                                  rootInverse,
-                                  context,
-                                  meshIsSkinned,
-                                  merged);
-
-        for (auto& entry : merged) {
-            MergedStaticMesh& mergedMesh = entry.second;
-            if (mergedMesh.vertices.empty() || mergedMesh.indices.empty()) {
-                continue;
-            }
-            auto combined = std::make_shared<Mesh>();
-            combined->setName(rootName + "_Static");
-            combined->setVertices(mergedMesh.vertices);
-            combined->setIndices(mergedMesh.indices);
-
-            std::shared_ptr<Material> material = Material::CreateDefault();
-            if (mergedMesh.materialIndex < context.materials.size()) {
-                material = context.materials[mergedMesh.materialIndex];
-            }
-
-            std::string entityName = rootName + " Static";
-            if (material && !material->getName().empty()) {
-                entityName = rootName + " " + material->getName();
-            }
-            Entity* mergedEntity = scene->createEntity(entityName);
-            mergedEntity->getTransform()->setParent(root->getTransform(), false);
-            MeshRenderer* renderer = mergedEntity->addComponent<MeshRenderer>();
-            renderer->setMesh(combined);
-            renderer->setMaterial(material);
-            ModelMeshReference* reference = mergedEntity->addComponent<ModelMeshReference>();
-            reference->setSourcePath(context.sourcePath);
-            reference->setSourceGuid(AssetDatabase::getInstance().registerAsset(context.sourcePath, "model"));
-            reference->setMeshIndex(-1);
-            reference->setMaterialIndex(static_cast<int>(mergedMesh.materialIndex));
-            reference->setMeshName(combined->getName());
-            reference->setSkinned(false);
-            reference->setMerged(true);
-            reference->setImportOptions(context.options);
+    size_t instantiated = 0;
+    for (const auto& job : finished) {
+        if (!job->source) {
+            std::cerr << "[ModelImporter] Background import failed: " << job->path << std::endl;
+            continue;
+        }
+        if (InstantiateModel(scene, *job->source, job->path, job->options, job->name)) {
+            ++instantiated;
         }
     }
-    
-    std::cout << "[ModelImporter] Imported " << context.meshes.size() << " mesh(es) from " << path << std::endl;
-    if (!guid.empty()) {
-        AssetDatabase::getInstance().recordImportForGuid(guid);
-    }
-    return root;
+    return instantiated;
+}
+
+std::vector<SceneCommands::ModelImportProgress> SceneCommands::getModelImportProgress() {
+    std::lock_guard<std::mutex> lock(g_ModelImportMutex);
+    std::vector<ModelImportProgress> progress;
+    progress.reserve(g_ModelImports.size());
+    for (const auto& job : g_ModelImports) {
+        ModelImportProgress entry;
+        entry.id = job->id;
+        entry.path = job->path;
+        switch (static_cast<ModelImportStage>(job->state->stage.load(std::memory_order_relaxed))) {
+            case ModelImportStage::Reading: entry.stage = "Reading"; break;
+            case ModelImportStage::ProcessingMeshes: entry.stage = "Processing meshes"; break;
+            case ModelImportStage::CreatingEntities: entry.stage = "Creating entities"; break;
+        }
+        entry.progress = job->state->progress.load(std::memory_order_relaxed);
+        progress.push_back(std::move(entry));
+    }
+    return progress;
 }
 
 std::vector<std::shared_ptr<AnimationClip>> SceneCommands::importAnimationClipsForSkeleton(
@@ -4456,7 +5917,8 @@ bool SceneCommands::reimportHdriAsset(Scene* scene, const std::string& guid) {
         AssetDatabase::getInstance().recordImportForGuid(guid);
         return true;
     }
-    bool loaded = renderer->loadEnvironmentMap(path);
+    // Import settings are part of the IBL cache key, so changed ones reprocess in the background.
+    bool loaded = renderer->requestEnvironmentMap(path);
     if (loaded) {
         AssetDatabase::getInstance().recordImportForGuid(guid);
     }
@@ -4539,164 +6001,316 @@ bool SceneCommands::setParent(Scene* scene, const std::string& childUuid, const
     return true;
 }
 
-Entity* SceneCommands::buildHLOD(Scene* scene, const std::vector<std::string>& uuids, float lodStart, float lodEnd) {
-    if (!scene || uuids.empty()) {
-        return nullptr;
+// One mesh merged into an HLOD, its materials taken from renderer by submesh material index.
+struct HLODMergeSource {
+    std::shared_ptr<Mesh> mesh;
+    const MeshRenderer* renderer = nullptr;
+    Math::Matrix4x4 world;
+};
+
+// Untextured opaque materials folded into one material that samples a row of flat swatches, so a
+// cluster of differently tinted meshes draws as a single submesh. Each swatch is kPaletteSwatch
+// pixels square and sampled at its centre; only v = 0.5 is used, so the row reads the same flipped.
+struct HLODMaterialPalette {
+    static constexpr uint32_t kPaletteSwatch = 4;
+    static constexpr uint32_t kMaxSlots = 256;
+
+    std::shared_ptr<Material> material;
+    std::unordered_map<const Material*, uint32_t> slots;
+    uint32_t slotCount = 0;
+
+    Math::Vector2 uv(uint32_t slot) const {
+        return Math::Vector2((static_cast<float>(slot) + 0.5f) / static_cast<float>(slotCount), 0.5f);
     }
+};
 
-    std::vector<Entity*> sources;
-    sources.reserve(uuids.size());
-    for (const auto& uuid : uuids) {
-        if (auto* entity = getEntityByUUID(scene, uuid)) {
-            sources.push_back(entity);
+struct HLODMergeResult {
+    std::shared_ptr<Mesh> mesh;
+    std::vector<std::shared_ptr<Material>> materials;
+    size_t sourceTriangles = 0;
+};
+
+static bool QualifiesForHLODPalette(const Material& material) {
+    return !material.getAlbedoTexture() && !material.getNormalTexture() && !material.getMetallicTexture() &&
+           !material.getRoughnessTexture() && !material.getAOTexture() && !material.getEmissionTexture() &&
+           !material.getORMTexture() && !material.getHeightTexture() && !material.getOpacityTexture() &&
+           material.getRenderMode() == Material::RenderMode::Opaque && material.getAlpha() >= 0.999f &&
+           !material.isTwoSided() && material.getCullMode() == Material::CullMode::Back &&
+           !material.getWindEnabled() && !material.getBillboardEnabled() && !material.getImpostorEnabled() &&
+           !material.getTerrainEnabled() && !material.getDitherEnabled() && !material.getLodFadeEnabled() &&
+           (material.getEmissionStrength() <= 0.0f ||
+            (material.getEmission().x <= 0.0f && material.getEmission().y <= 0.0f && material.getEmission().z <= 0.0f));
+}
+
+static uint8_t EncodeSRGB8(float linear) {
+    linear = std::max(0.0f, std::min(1.0f, linear));
+    const float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+    return static_cast<uint8_t>(std::round(srgb * 255.0f));
+}
+
+static uint8_t EncodeUnorm8(float value) {
+    return static_cast<uint8_t>(std::round(std::max(0.0f, std::min(1.0f, value)) * 255.0f));
+}
+
+// Writes the albedo and ORM swatch rows to Library/HLOD and loads them through the renderer.
+// Returns false, leaving palette empty, when there are fewer than two materials to fold or the
+// textures cannot be written or loaded.
+static bool BuildHLODMaterialPalette(Scene* scene,
+                                     const std::string& scenePath,
+                                     const std::vector<std::shared_ptr<Material>>& materials,
+                                     HLODMaterialPalette& palette) {
+    palette = HLODMaterialPalette{};
+    if (materials.size() < 2) {
+        return false;
+    }
+    Renderer* renderer = Engine::getInstance().getRenderer();
+    TextureLoader* loader = renderer ? renderer->getTextureLoader() : nullptr;
+    if (!loader) {
+        return false;
+    }
+
+    const uint32_t slotCount = static_cast<uint32_t>(std::min<size_t>(materials.size(), HLODMaterialPalette::kMaxSlots));
+    const uint32_t swatch = HLODMaterialPalette::kPaletteSwatch;
+    const int width = static_cast<int>(slotCount * swatch);
+    const int height = static_cast<int>(swatch);
+    std::vector<uint8_t> albedo(static_cast<size_t>(width) * height * 4);
+    std::vector<uint8_t> orm(static_cast<size_t>(width) * height * 4);
+    for (uint32_t slot = 0; slot < slotCount; ++slot) {
+        const Material& material = *materials[slot];
+        const Math::Vector4& color = material.getAlbedo();
+        const uint8_t albedoTexel[4] = {EncodeSRGB8(color.x), EncodeSRGB8(color.y), EncodeSRGB8(color.z), 255};
+        const uint8_t ormTexel[4] = {EncodeUnorm8(material.getAO()), EncodeUnorm8(material.getRoughness()),
+                                     EncodeUnorm8(material.getMetallic()), 255};
+        for (int y = 0; y < height; ++y) {
+            for (uint32_t x = slot * swatch; x < (slot + 1) * swatch; ++x) {
+                const size_t offset = (static_cast<size_t>(y) * width + x) * 4;
+                std::copy(albedoTexel, albedoTexel + 4, albedo.begin() + offset);
+                std::copy(ormTexel, ormTexel + 4, orm.begin() + offset);
+            }
         }
     }
-    if (sources.empty()) {
-        return nullptr;
+
+    std::filesystem::path outputDir = std::filesystem::current_path() / "Library/HLOD";
+    std::error_code ec;
+    std::filesystem::create_directories(outputDir, ec);
+    const std::string stem = SanitizeLightingArtifactStem(!scenePath.empty()
+        ? std::filesystem::path(scenePath).stem().string()
+        : scene->getName());
+    const std::string albedoPath = (outputDir / (stem + "_hlod_albedo.png")).string();
+    const std::string ormPath = (outputDir / (stem + "_hlod_orm.png")).string();
+    if (!stbi_write_png(albedoPath.c_str(), width, height, 4, albedo.data(), width * 4) ||
+        !stbi_write_png(ormPath.c_str(), width, height, 4, orm.data(), width * 4)) {
+        std::cerr << "[HLOD] Failed to write material palette to " << outputDir.string() << std::endl;
+        return false;
     }
 
-    std::vector<Vertex> mergedVertices;
-    std::vector<uint32_t> mergedIndices;
-    std::vector<Submesh> mergedSubmeshes;
-    std::vector<std::shared_ptr<Material>> materials;
-    std::unordered_map<const Material*, uint32_t> materialMap;
+    auto albedoTexture = loader->loadTexture(albedoPath, true, false);
+    auto ormTexture = loader->loadTexture(ormPath, false, false);
+    if (!albedoTexture || !ormTexture) {
+        return false;
+    }
+
+    auto material = Material::CreateDefault();
+    material->setName("HLOD_Palette");
+    material->setAlbedo(Math::Vector4(1.0f, 1.0f, 1.0f, 1.0f));
+    material->setMetallic(1.0f);
+    material->setRoughness(1.0f);
+    material->setAO(1.0f);
+    material->setAlbedoTexture(albedoTexture);
+    material->setORMTexture(ormTexture);
+
+    palette.material = material;
+    palette.slotCount = slotCount;
+    for (uint32_t slot = 0; slot < slotCount; ++slot) {
+        palette.slots[materials[slot].get()] = slot;
+    }
+    return true;
+}
+
+// Bakes sources into one world-space mesh with a submesh per material: triangles are bucketed by
+// material, each bucket compacted and, with meshoptimizer, simplified. Materials found in palette
+// have their UVs pointed at their swatch and share the palette's submesh.
+static bool MergeHLODSources(const std::vector<HLODMergeSource>& sources,
+                             float ratioScale,
+                             const HLODMaterialPalette* palette,
+                             HLODMergeResult& out) {
+    out = HLODMergeResult{};
 
     struct Bucket {
-        uint32_t materialIndex = 0;
+        uint32_t outputIndex = 0;
+        int32_t paletteSlot = -1;
         std::vector<uint32_t> indices;
     };
+    std::vector<Vertex> mergedVertices;
     std::vector<Bucket> buckets;
-
-    auto getMaterialIndex = [&](const std::shared_ptr<Material>& mat) -> uint32_t {
-        const Material* key = mat.get();
-        auto it = materialMap.find(key);
-        if (it != materialMap.end()) {
-            return it->second;
+    std::unordered_map<const Material*, uint32_t> bucketMap;
+    int32_t paletteOutput = -1;
+
+    auto getBucket = [&](const std::shared_ptr<Material>& mat) -> Bucket& {
+        auto it = bucketMap.find(mat.get());
+        if (it != bucketMap.end()) {
+            return buckets[it->second];
+        }
+        Bucket bucket;
+        if (palette && mat) {
+            auto slot = palette->slots.find(mat.get());
+            if (slot != palette->slots.end()) {
+                if (paletteOutput < 0) {
+                    paletteOutput = static_cast<int32_t>(out.materials.size());
+                    out.materials.push_back(palette->material);
+                }
+                bucket.outputIndex = static_cast<uint32_t>(paletteOutput);
+                bucket.paletteSlot = static_cast<int32_t>(slot->second);
+            }
         }
-        uint32_t idx = static_cast<uint32_t>(materials.size());
-        materials.push_back(mat ? mat : Material::CreateDefault());
-        materialMap[key] = idx;
-        buckets.push_back(Bucket{idx, {}});
-        return idx;
+        if (bucket.paletteSlot < 0) {
+            bucket.outputIndex = static_cast<uint32_t>(out.materials.size());
+            out.materials.push_back(mat ? mat : Material::CreateDefault());
+        }
+        bucketMap[mat.get()] = static_cast<uint32_t>(buckets.size());
+        buckets.push_back(std::move(bucket));
+        return buckets.back();
     };
 
-    for (Entity* entity : sources) {
-        if (!entity || !entity->isActiveInHierarchy()) {
-            continue;
-        }
-        if (entity->getComponent<SkinnedMeshRenderer>() || entity->getComponent<InstancedMeshRenderer>()) {
+    for (const HLODMergeSource& source : sources) {
+        if (!source.mesh || !source.renderer) {
             continue;
         }
-        MeshRenderer* renderer = entity->getComponent<MeshRenderer>();
-        if (!renderer || !renderer->isEnabled()) {
-            continue;
-        }
-        std::shared_ptr<Mesh> mesh = renderer->getMesh();
-        if (!mesh) {
-            continue;
-        }
-
-        const auto& vertices = mesh->getVertices();
-        const auto& indices = mesh->getIndices();
+        const auto& vertices = source.mesh->getVertices();
+        const auto& indices = source.mesh->getIndices();
         if (vertices.empty() || indices.empty()) {
             continue;
         }
 
-        Math::Matrix4x4 world = entity->getTransform()->getWorldMatrix();
+        const Math::Matrix4x4& world = source.world;
         Math::Matrix4x4 normalMatrix = world.normalMatrix();
 
         uint32_t baseVertex = static_cast<uint32_t>(mergedVertices.size());
         mergedVertices.reserve(mergedVertices.size() + vertices.size());
         for (const auto& v : vertices) {
-            Vertex out = v;
-            out.position = world.transformPoint(v.position);
-            out.normal = normalMatrix.transformDirection(v.normal);
-            out.normal.normalize();
-            out.tangent = normalMatrix.transformDirection(v.tangent);
-            out.tangent.normalize();
-            out.bitangent = normalMatrix.transformDirection(v.bitangent);
-            out.bitangent.normalize();
-            mergedVertices.push_back(out);
-        }
-
-        const auto& submeshes = mesh->getSubmeshes();
+            Vertex vertex = v;
+            vertex.position = world.transformPoint(v.position);
+            vertex.normal = normalMatrix.transformDirection(v.normal);
+            vertex.normal.normalize();
+            vertex.tangent = normalMatrix.transformDirection(v.tangent);
+            vertex.tangent.normalize();
+            vertex.bitangent = normalMatrix.transformDirection(v.bitangent);
+            vertex.bitangent.normalize();
+            mergedVertices.push_back(vertex);
+        }
+
+        const auto& submeshes = source.mesh->getSubmeshes();
         if (submeshes.empty()) {
-            auto mat = renderer->getMaterial(0);
-            uint32_t matIndex = getMaterialIndex(mat);
-            Bucket& bucket = buckets[matIndex];
+            Bucket& bucket = getBucket(source.renderer->getMaterial(0));
             bucket.indices.reserve(bucket.indices.size() + indices.size());
             for (uint32_t idx : indices) {
                 bucket.indices.push_back(baseVertex + idx);
             }
+            out.sourceTriangles += indices.size() / 3;
         } else {
             for (const auto& sub : submeshes) {
-                auto mat = renderer->getMaterial(sub.materialIndex);
-                uint32_t matIndex = getMaterialIndex(mat);
-                Bucket& bucket = buckets[matIndex];
+                Bucket& bucket = getBucket(source.renderer->getMaterial(sub.materialIndex));
                 uint32_t end = sub.indexStart + sub.indexCount;
                 bucket.indices.reserve(bucket.indices.size() + sub.indexCount);
                 for (uint32_t i = sub.indexStart; i < end; ++i) {
                     if (i >= indices.size()) break;
                     bucket.indices.push_back(baseVertex + indices[i]);
                 }
+                out.sourceTriangles += sub.indexCount / 3;
             }
         }
     }
 
-    if (mergedVertices.empty() || buckets.empty()) {
-        return nullptr;
-    }
-
-    mergedIndices.clear();
-    mergedSubmeshes.clear();
-
+    if (mergedVertices.empty() || buckets.empty()) {
+        return false;
+    }
+
+    // Buckets sharing an output material (the palette) are concatenated before simplifying.
+    std::vector<HLODBucketBuildResult> groups(out.materials.size());
+    for (const auto& bucket : buckets) {
+        if (bucket.indices.empty()) {
+            continue;
+        }
+
+        HLODBucketBuildResult bucketMesh = BuildCompactHLODBucket(mergedVertices, bucket.indices);
+        if (bucketMesh.vertices.empty() || bucketMesh.indices.empty()) {
+            continue;
+        }
+        if (bucket.paletteSlot >= 0) {
+            const Math::Vector2 swatchUV = palette->uv(static_cast<uint32_t>(bucket.paletteSlot));
+            for (Vertex& vertex : bucketMesh.vertices) {
+                vertex.texCoord = swatchUV;
+            }
+        }
+
+        HLODBucketBuildResult& group = groups[bucket.outputIndex];
+        if (group.vertices.empty()) {
+            group = std::move(bucketMesh);
+            continue;
+        }
+        const uint32_t baseVertex = static_cast<uint32_t>(group.vertices.size());
+        group.vertices.insert(group.vertices.end(), bucketMesh.vertices.begin(), bucketMesh.vertices.end());
+        for (uint32_t index : bucketMesh.indices) {
+            group.indices.push_back(baseVertex + index);
+        }
+    }
+
     uint32_t indexStart = 0;
     std::vector<Vertex> hlodVertices;
     std::vector<uint32_t> hlodIndices;
-    for (const auto& bucket : buckets) {
-        if (bucket.indices.empty()) {
-            continue;
-        }
-
-        HLODBucketBuildResult bucketMesh = BuildCompactHLODBucket(mergedVertices, bucket.indices);
-        if (bucketMesh.vertices.empty() || bucketMesh.indices.empty()) {
+    std::vector<Submesh> hlodSubmeshes;
+    for (uint32_t materialIndex = 0; materialIndex < groups.size(); ++materialIndex) {
+        HLODBucketBuildResult& group = groups[materialIndex];
+        if (group.vertices.empty() || group.indices.empty()) {
             continue;
         }
 
 #if CRESCENT_HAS_MESHOPTIMIZER
-        SimplifyHLODBucketInPlace(bucketMesh, sources.size());
+        SimplifyHLODBucketInPlace(group, sources.size(), ratioScale);
+#else
+        (void)ratioScale;
 #endif
 
         const uint32_t baseVertex = static_cast<uint32_t>(hlodVertices.size());
-        hlodVertices.insert(hlodVertices.end(), bucketMesh.vertices.begin(), bucketMesh.vertices.end());
+        hlodVertices.insert(hlodVertices.end(), group.vertices.begin(), group.vertices.end());
 
-        mergedSubmeshes.emplace_back(indexStart, static_cast<uint32_t>(bucketMesh.indices.size()), bucket.materialIndex);
-        for (uint32_t index : bucketMesh.indices) {
+        hlodSubmeshes.emplace_back(indexStart, static_cast<uint32_t>(group.indices.size()), materialIndex);
+        for (uint32_t index : group.indices) {
             hlodIndices.push_back(baseVertex + index);
         }
-        indexStart += static_cast<uint32_t>(bucketMesh.indices.size());
+        indexStart += static_cast<uint32_t>(group.indices.size());
     }
 
     if (hlodVertices.empty() || hlodIndices.empty()) {
-        return nullptr;
+        return false;
     }
 
-    auto mergedMesh = std::make_shared<Mesh>();
-    mergedMesh->setName("HLOD_Mesh");
-    mergedMesh->setVertices(hlodVertices);
-    mergedMesh->setIndices(hlodIndices);
-    if (!mergedSubmeshes.empty()) {
-        mergedMesh->setSubmeshes(mergedSubmeshes);
+    out.mesh = std::make_shared<Mesh>();
+    out.mesh->setName("HLOD_Mesh");
+    out.mesh->setVertices(hlodVertices);
+    out.mesh->setIndices(hlodIndices);
+    if (!hlodSubmeshes.empty()) {
+        out.mesh->setSubmeshes(hlodSubmeshes);
     }
+    return true;
+}
 
-    Math::Vector3 boundsSize = mergedMesh->getBoundsSize();
+// Distances derived from the proxy's size when not given: four times its largest extent, at
+// least 30 units.
+static Entity* CreateHLODProxyEntity(Scene* scene,
+                                     const std::string& name,
+                                     const HLODMergeResult& merged,
+                                     const std::vector<UUID>& sourceUuids,
+                                     float lodStart,
+                                     float lodEnd) {
+    Math::Vector3 boundsSize = merged.mesh->getBoundsSize();
     float size = std::max(0.1f, std::max(boundsSize.x, std::max(boundsSize.y, boundsSize.z)));
     float autoStart = std::max(size * 4.0f, 30.0f);
     float autoEnd = std::max(autoStart * 1.2f, autoStart + size * 2.0f);
     if (lodStart < 0.0f) lodStart = autoStart;
     if (lodEnd < 0.0f) lodEnd = autoEnd;
 
-    Entity* hlodEntity = scene->createEntity("HLOD_Proxy");
+    Entity* hlodEntity = scene->createEntity(name);
     if (!hlodEntity) {
         return nullptr;
     }
@@ -4705,15 +6319,15 @@ Entity* SceneCommands::buildHLOD(Scene* scene, const std::vector<std::string>& u
     hlodEntity->getTransform()->setLocalScale(Math::Vector3(1.0f, 1.0f, 1.0f));
 
     auto* mr = hlodEntity->addComponent<MeshRenderer>();
-    mr->setMesh(mergedMesh);
-    for (uint32_t i = 0; i < materials.size(); ++i) {
-        mr->setMaterial(i, materials[i] ? materials[i] : Material::CreateDefault());
+    mr->setMesh(merged.mesh);
+    for (uint32_t i = 0; i < merged.materials.size(); ++i) {
+        mr->setMaterial(i, merged.materials[i] ? merged.materials[i] : Material::CreateDefault());
     }
     mr->setCastShadows(true);
     mr->setReceiveShadows(true);
 
     auto* proxy = hlodEntity->addComponent<HLODProxy>();
-    proxy->setSourceUuids(uuids);
+    proxy->setSourceUuids(sourceUuids);
     proxy->setLodStart(lodStart);
     proxy->setLodEnd(lodEnd);
     proxy->setEnabled(true);
@@ -4721,6 +6335,229 @@ Entity* SceneCommands::buildHLOD(Scene* scene, const std::vector<std::string>& u
     return hlodEntity;
 }
 
+Entity* SceneCommands::buildHLOD(Scene* scene, const std::vector<std::string>& uuids, float lodStart, float lodEnd) {
+    if (!scene || uuids.empty()) {
+        return nullptr;
+    }
+
+    std::vector<Entity*> sources;
+    sources.reserve(uuids.size());
+    for (const auto& uuid : uuids) {
+        if (auto* entity = getEntityByUUID(scene, uuid)) {
+            sources.push_back(entity);
+        }
+    }
+    if (sources.empty()) {
+        return nullptr;
+    }
+
+    std::vector<HLODMergeSource> mergeSources;
+    mergeSources.reserve(sources.size());
+    for (Entity* entity : sources) {
+        if (!entity || !entity->isActiveInHierarchy()) {
+            continue;
+        }
+        if (entity->getComponent<SkinnedMeshRenderer>() || entity->getComponent<InstancedMeshRenderer>()) {
+            continue;
+        }
+        MeshRenderer* renderer = entity->getComponent<MeshRenderer>();
+        if (!renderer || !renderer->isEnabled() || !renderer->getMesh()) {
+            continue;
+        }
+        mergeSources.push_back(HLODMergeSource{renderer->getMesh(), renderer, entity->getTransform()->getWorldMatrix()});
+    }
+
+    HLODMergeResult merged;
+    if (!MergeHLODSources(mergeSources, 1.0f, nullptr, merged)) {
+        return nullptr;
+    }
+
+    std::vector<UUID> sourceUuids;
+    sourceUuids.reserve(sources.size());
+    for (Entity* source : sources) {
+        sourceUuids.push_back(source->getUUID());
+    }
+    return CreateHLODProxyEntity(scene, "HLOD_Proxy", merged, sourceUuids, lodStart, lodEnd);
+}
+
+SceneCommands::HLODClusterStats SceneCommands::buildHLODClusters(Scene* scene,
+                                                                const HLODClusterSettings& settings,
+                                                                const std::string& scenePath) {
+    HLODClusterStats stats;
+    if (!scene) {
+        return stats;
+    }
+
+    // Generated proxies are rebuilt from scratch; hand-built ones stay and keep their sources.
+    std::vector<UUID> generated;
+    std::unordered_set<UUID> handBuiltSources;
+    for (const auto& entityPtr : scene->getAllEntities()) {
+        const HLODProxy* proxy = entityPtr ? entityPtr->getComponent<HLODProxy>() : nullptr;
+        if (!proxy) {
+            continue;
+        }
+        if (proxy->getLevel() > 0) {
+            generated.push_back(entityPtr->getUUID());
+        } else {
+            handBuiltSources.insert(proxy->getSourceUuids().begin(), proxy->getSourceUuids().end());
+        }
+    }
+    for (const UUID& uuid : generated) {
+        scene->destroyEntity(uuid);
+    }
+    stats.removedProxyCount = static_cast<int>(generated.size());
+
+    struct ClusterItem {
+        HLODMergeSource source;
+        UUID uuid;
+        Math::Vector3 center;
+        float activationDistance = 0.0f;
+    };
+    std::vector<ClusterItem> items;
+    for (const auto& entityPtr : scene->getAllEntities()) {
+        Entity* entity = entityPtr.get();
+        if (!entity || !entity->isActiveInHierarchy() || handBuiltSources.count(entity->getUUID())) {
+            continue;
+        }
+        if (entity->getComponent<SkinnedMeshRenderer>() || entity->getComponent<InstancedMeshRenderer>() ||
+            entity->getComponent<HLODProxy>()) {
+            continue;
+        }
+        const Rigidbody* body = entity->getComponent<Rigidbody>();
+        if (body && body->isEnabled() && body->getType() != RigidbodyType::Static) {
+            continue;
+        }
+        MeshRenderer* renderer = entity->getComponent<MeshRenderer>();
+        if (!renderer || !renderer->isEnabled()) {
+            continue;
+        }
+        if (settings.staticOnly && !renderer->getStaticLighting().staticGeometry) {
+            continue;
+        }
+        std::shared_ptr<Mesh> mesh = renderer->getMesh();
+        if (!mesh || mesh->getVertices().empty() || mesh->getIndices().empty()) {
+            continue;
+        }
+        ClusterItem item;
+        item.source = HLODMergeSource{mesh, renderer, entity->getTransform()->getWorldMatrix()};
+        item.uuid = entity->getUUID();
+        item.center = item.source.world.transformPoint(mesh->getBoundsCenter());
+        items.push_back(std::move(item));
+    }
+    stats.sourceRendererCount = static_cast<int>(items.size());
+
+    HLODMaterialPalette palette;
+    bool hasPalette = false;
+    if (settings.atlasMaterials) {
+        std::vector<std::shared_ptr<Material>> paletteMaterials;
+        std::unordered_set<const Material*> seen;
+        for (const ClusterItem& item : items) {
+            const auto& submeshes = item.source.mesh->getSubmeshes();
+            const size_t materialCount = std::max<size_t>(1, submeshes.size());
+            for (size_t i = 0; i < materialCount; ++i) {
+                const uint32_t materialIndex = submeshes.empty() ? 0 : submeshes[i].materialIndex;
+                std::shared_ptr<Material> material = item.source.renderer->getMaterial(materialIndex);
+                if (material && seen.insert(material.get()).second && QualifiesForHLODPalette(*material) &&
+                    paletteMaterials.size() < HLODMaterialPalette::kMaxSlots) {
+                    paletteMaterials.push_back(material);
+                }
+            }
+        }
+        hasPalette = BuildHLODMaterialPalette(scene, scenePath, paletteMaterials, palette);
+        stats.atlasedMaterialCount = hasPalette ? static_cast<int>(palette.slotCount) : 0;
+    }
+
+    // Each level clusters the one below on a grid twice as coarse: level 1 groups renderers, level
+    // 2 the level 1 proxies, and so on. A cluster's sources are hidden while it is active, so a
+    // parent must switch in beyond the distance its children do.
+    const uint32_t minSources = std::max<uint32_t>(2, settings.minSources);
+    std::vector<ClusterItem> level = std::move(items);
+    for (uint32_t levelIndex = 1; levelIndex <= settings.levels && level.size() >= minSources; ++levelIndex) {
+        const float cellSize = std::max(1.0f, settings.cellSize) * static_cast<float>(1u << std::min(levelIndex - 1, 16u));
+        std::map<std::pair<int32_t, int32_t>, std::vector<uint32_t>> cells;
+        for (uint32_t i = 0; i < level.size(); ++i) {
+            const int32_t x = static_cast<int32_t>(std::floor(level[i].center.x / cellSize));
+            const int32_t z = static_cast<int32_t>(std::floor(level[i].center.z / cellSize));
+            cells[{x, z}].push_back(i);
+        }
+
+        struct Cluster {
+            int32_t x = 0;
+            int32_t z = 0;
+            const std::vector<uint32_t>* members = nullptr;
+            HLODMergeResult merged;
+            bool built = false;
+        };
+        std::vector<Cluster> clusters;
+        for (const auto& [cell, members] : cells) {
+            if (members.size() >= minSources) {
+                Cluster cluster;
+                cluster.x = cell.first;
+                cluster.z = cell.second;
+                cluster.members = &members;
+                clusters.push_back(std::move(cluster));
+            }
+        }
+        if (clusters.empty()) {
+            break;
+        }
+
+        const float ratioScale = std::pow(0.5f, static_cast<float>(levelIndex - 1));
+        ParallelFor(clusters.size(), [&](size_t index) {
+            Cluster& cluster = clusters[index];
+            std::vector<HLODMergeSource> sources;
+            sources.reserve(cluster.members->size());
+            for (uint32_t member : *cluster.members) {
+                sources.push_back(level[member].source);
+            }
+            cluster.built = MergeHLODSources(sources, ratioScale, hasPalette ? &palette : nullptr, cluster.merged);
+        });
+
+        std::vector<ClusterItem> next;
+        next.reserve(clusters.size());
+        for (const Cluster& cluster : clusters) {
+            if (!cluster.built) {
+                continue;
+            }
+            std::vector<UUID> sourceUuids;
+            sourceUuids.reserve(cluster.members->size());
+            float childDistance = 0.0f;
+            for (uint32_t member : *cluster.members) {
+                sourceUuids.push_back(level[member].uuid);
+                childDistance = std::max(childDistance, level[member].activationDistance);
+            }
+
+            const Math::Vector3 boundsSize = cluster.merged.mesh->getBoundsSize();
+            const float size = std::max(0.1f, std::max(boundsSize.x, std::max(boundsSize.y, boundsSize.z)));
+            const float lodStart = std::max(std::max(size * 4.0f, 30.0f), childDistance * 1.5f);
+            const float lodEnd = lodStart * 1.2f;
+            const std::string name = "HLOD_L" + std::to_string(levelIndex) + "_" +
+                                     std::to_string(cluster.x) + "_" + std::to_string(cluster.z);
+            Entity* proxyEntity = CreateHLODProxyEntity(scene, name, cluster.merged, sourceUuids, lodStart, lodEnd);
+            if (!proxyEntity) {
+                continue;
+            }
+            proxyEntity->getComponent<HLODProxy>()->setLevel(levelIndex);
+
+            ++stats.proxyCount;
+            stats.proxyTriangles += cluster.merged.mesh->getIndices().size() / 3;
+            if (levelIndex == 1) {
+                stats.sourceTriangles += cluster.merged.sourceTriangles;
+            }
+
+            ClusterItem item;
+            item.source = HLODMergeSource{cluster.merged.mesh, proxyEntity->getComponent<MeshRenderer>(), Math::Matrix4x4::Identity};
+            item.uuid = proxyEntity->getUUID();
+            item.center = cluster.merged.mesh->getBoundsCenter();
+            item.activationDistance = lodEnd;
+            next.push_back(std::move(item));
+        }
+        level = std::move(next);
+    }
+
+    return stats;
+}
+
 SceneCommands::StaticLightingLayoutStats SceneCommands::buildStaticLightingLayout(Scene* scene, const std::string& scenePath) {
     StaticLightingLayoutStats stats;
     if (!scene) {
@@ -4736,6 +6573,26 @@ SceneCommands::StaticLightingLayoutStats SceneCommands::buildStaticLightingLayou
     std::vector<StaticLightingLayoutCandidate> candidates;
     candidates.reserve(scene->getEntityCount());
 
+    struct PendingLayoutRenderer {
+        Entity* entity = nullptr;
+        MeshRenderer* renderer = nullptr;
+        MeshRenderer::StaticLightingData metadata;
+        // Resolved up front; transforms update their world matrix lazily, which is not thread safe.
+        Math::Matrix4x4 worldMatrix = Math::Matrix4x4::Identity;
+        size_t layoutMesh = 0;
+        float surfaceAreaWS = 0.0f;
+    };
+    // One unwrap per distinct mesh; renderers that share a mesh share its lightmap UVs too.
+    struct LayoutMesh {
+        std::shared_ptr<Mesh> source;
+        std::shared_ptr<Mesh> result;
+        bool generatedFallback = false;
+        bool usable = false;
+    };
+    std::vector<PendingLayoutRenderer> pending;
+    std::vector<LayoutMesh> layoutMeshes;
+    std::unordered_map<const Mesh*, size_t> layoutMeshIndices;
+
     for (const auto& entityPtr : scene->getAllEntities()) {
         Entity* entity = entityPtr.get();
         if (!entity || !entity->isActiveInHierarchy() || entity->isEditorOnly()) {
@@ -4759,6 +6616,7 @@ SceneCommands::StaticLightingLayoutStats SceneCommands::buildStaticLightingLayou
         metadata.lightmapPath.clear();
         metadata.directionalLightmapPath.clear();
         metadata.shadowmaskPath.clear();
+        metadata.bakeHash.clear();
 
         if (!metadata.staticGeometry) {
             renderer->setStaticLighting(metadata);
@@ -4766,42 +6624,72 @@ SceneCommands::StaticLightingLayoutStats SceneCommands::buildStaticLightingLayou
         }
         stats.staticGeometryRendererCount += 1;
 
-        bool generatedFallback = false;
-        std::shared_ptr<Mesh> layoutMesh = mesh;
-        if (!HasUsableLightmapUVs(*layoutMesh)) {
-            if (!staticLightingSettings.autoUnwrap) {
-                renderer->setStaticLighting(metadata);
-                stats.skippedRendererCount += 1;
-                continue;
+        PendingLayoutRenderer entry;
+        entry.entity = entity;
+        entry.renderer = renderer;
+        entry.metadata = metadata;
+        entry.worldMatrix = entity->getTransform()->getWorldMatrix();
+        auto meshIt = layoutMeshIndices.find(mesh.get());
+        if (meshIt == layoutMeshIndices.end()) {
+            meshIt = layoutMeshIndices.emplace(mesh.get(), layoutMeshes.size()).first;
+            LayoutMesh layoutMesh;
+            layoutMesh.source = mesh;
+            layoutMeshes.push_back(std::move(layoutMesh));
+        }
+        entry.layoutMesh = meshIt->second;
+        pending.push_back(std::move(entry));
+    }
+
+    // Charting and the world-space areas only read the scene, so they run across threads.
+    const bool autoUnwrap = staticLightingSettings.autoUnwrap;
+    const float texelsPerUnit = staticLightingSettings.texelsPerUnit;
+    ParallelFor(layoutMeshes.size(), [&](size_t index) {
+        LayoutMesh& layoutMesh = layoutMeshes[index];
+        std::shared_ptr<Mesh> mesh = layoutMesh.source;
+        if (!HasUsableLightmapUVs(*mesh)) {
+            if (!autoUnwrap) {
+                return;
             }
-            layoutMesh = CreateFallbackLightmapMesh(layoutMesh);
-            generatedFallback = true;
+            mesh = CreateFallbackLightmapMesh(mesh, texelsPerUnit);
+            layoutMesh.generatedFallback = true;
         }
-        layoutMesh = CreateNormalizedLightmapMesh(layoutMesh);
-        if (!layoutMesh || !HasUsableLightmapUVs(*layoutMesh)) {
-            renderer->setStaticLighting(metadata);
+        mesh = CreateNormalizedLightmapMesh(mesh);
+        layoutMesh.usable = mesh && HasUsableLightmapUVs(*mesh);
+        layoutMesh.result = mesh;
+    });
+    ParallelFor(pending.size(), [&](size_t index) {
+        PendingLayoutRenderer& entry = pending[index];
+        const LayoutMesh& layoutMesh = layoutMeshes[entry.layoutMesh];
+        if (layoutMesh.usable) {
+            entry.surfaceAreaWS = ComputeWorldSurfaceArea(*layoutMesh.result, entry.worldMatrix);
+        }
+    });
+
+    for (const PendingLayoutRenderer& entry : pending) {
+        const LayoutMesh& layoutMesh = layoutMeshes[entry.layoutMesh];
+        if (!layoutMesh.usable) {
+            entry.renderer->setStaticLighting(entry.metadata);
             stats.skippedRendererCount += 1;
             continue;
         }
 
-        if (layoutMesh != mesh) {
-            renderer->setMesh(layoutMesh);
+        if (layoutMesh.result != layoutMesh.source) {
+            entry.renderer->setMesh(layoutMesh.result);
         }
 
-        float surfaceAreaWS = ComputeWorldSurfaceArea(*layoutMesh, *entity->getTransform());
-        if (surfaceAreaWS <= 0.0001f) {
-            renderer->setStaticLighting(metadata);
+        if (entry.surfaceAreaWS <= 0.0001f) {
+            entry.renderer->setStaticLighting(entry.metadata);
             stats.skippedRendererCount += 1;
             continue;
         }
 
         StaticLightingLayoutCandidate candidate;
-        candidate.entity = entity;
-        candidate.renderer = renderer;
-        candidate.mesh = layoutMesh;
-        candidate.surfaceAreaWS = surfaceAreaWS;
-        candidate.requestedInnerResolution = EstimateLightmapInnerResolution(surfaceAreaWS, staticLightingSettings);
-        candidate.generatedFallbackUVs = generatedFallback;
+        candidate.entity = entry.entity;
+        candidate.renderer = entry.renderer;
+        candidate.mesh = layoutMesh.result;
+        candidate.surfaceAreaWS = entry.surfaceAreaWS;
+        candidate.requestedInnerResolution = EstimateLightmapInnerResolution(entry.surfaceAreaWS, staticLightingSettings);
+        candidate.generatedFallbackUVs = layoutMesh.generatedFallback;
         candidates.push_back(candidate);
     }
 
@@ -4813,7 +6701,7 @@ SceneCommands::StaticLightingLayoutStats SceneCommands::buildStaticLightingLayou
         return a.surfaceAreaWS > b.surfaceAreaWS;
     });
 
-    std::vector<ShelfAtlasState> atlases;
+    std::vector<SkylineAtlasState> atlases;
     atlases.reserve(std::max(staticLightingSettings.maxAtlasCount, 1));
     const int atlasSize = std::max(256, staticLightingSettings.atlasSize);
     const int padding = std::max(1, staticLightingSettings.unwrapPadding);
@@ -4835,10 +6723,11 @@ SceneCommands::StaticLightingLayoutStats SceneCommands::buildStaticLightingLayou
 
         int packedX = 0;
         int packedY = 0;
+        bool packedRotated = false;
         int assignedAtlasIndex = -1;
 
         for (auto& atlas : atlases) {
-            if (TryPackShelfRect(atlas, slotResolution, slotResolution, packedX, packedY)) {
+            if (TryPackSkylineRect(atlas, slotResolution, slotResolution, false, packedX, packedY, packedRotated)) {
                 assignedAtlasIndex = atlas.atlasIndex;
                 break;
             }
@@ -4854,11 +6743,10 @@ SceneCommands::StaticLightingLayoutStats SceneCommands::buildStaticLightingLayou
                 continue;
             }
 
-            ShelfAtlasState atlas;
+            SkylineAtlasState atlas;
             atlas.atlasIndex = static_cast<int>(atlases.size());
-            atlas.width = atlasSize;
-            atlas.height = atlasSize;
-            if (!TryPackShelfRect(atlas, slotResolution, slotResolution, packedX, packedY)) {
+            ResetSkylineAtlas(atlas, atlasSize, atlasSize);
+            if (!TryPackSkylineRect(atlas, slotResolution, slotResolution, false, packedX, packedY, packedRotated)) {
                 stats.skippedRendererCount += 1;
                 continue;
             }
@@ -4878,6 +6766,7 @@ SceneCommands::StaticLightingLayoutStats SceneCommands::buildStaticLightingLayou
         metadata.lightmapPath.clear();
         metadata.directionalLightmapPath.clear();
         metadata.shadowmaskPath.clear();
+        metadata.bakeHash.clear();
         candidate.renderer->setStaticLighting(metadata);
 
         stats.rendererCount += 1;
@@ -4889,18 +6778,58 @@ SceneCommands::StaticLightingLayoutStats SceneCommands::buildStaticLightingLayou
     }
 
     stats.atlasCount = static_cast<int>(atlases.size());
+    if (!atlases.empty()) {
+        int64_t usedArea = 0;
+        for (const auto& atlas : atlases) {
+            usedArea += atlas.usedArea;
+        }
+        stats.atlasUtilization = static_cast<float>(static_cast<double>(usedArea)
+            / (static_cast<double>(atlasSize) * static_cast<double>(atlasSize) * static_cast<double>(atlases.size())));
+        std::cout << "[StaticLighting] Packed " << stats.rendererCount << " renderers into " << stats.atlasCount
+                  << " atlases, " << static_cast<int>(stats.atlasUtilization * 100.0f) << "% used" << std::endl;
+    }
     if (stats.rendererCount > 0) {
         SceneSerializer::SaveStaticLightingManifest(scene, scenePath);
     }
     return stats;
 }
 
-SceneCommands::StaticLightmapBakeStats SceneCommands::bakeStaticLightmaps(Scene* scene, const std::string& scenePath) {
+SceneCommands::StaticLightmapBakeProgress SceneCommands::getStaticLightmapBakeProgress() {
+    StaticLightmapBakeProgress progress;
+    progress.active = g_StaticLightmapBakeActive.load(std::memory_order_relaxed);
+    progress.progress = g_StaticLightmapBakeProgress.load(std::memory_order_relaxed);
+    return progress;
+}
+
+void SceneCommands::cancelStaticLightmapBake() {
+    if (g_StaticLightmapBakeActive.load()) {
+        g_StaticLightmapBakeCancel.store(true);
+    }
+}
+
+SceneCommands::StaticLightmapBakeStats SceneCommands::bakeStaticLightmaps(Scene* scene, const std::string& scenePath,
+                                                                          const StaticLightmapBakeHooks& hooks) {
     StaticLightmapBakeStats stats;
     if (!scene) {
         return stats;
     }
 
+    // Keeps the shared workers up for the texel tiles, also in the cooker where nothing else has.
+    struct BakeSession {
+        BakeSession() {
+            g_StaticLightmapBakeCancel.store(false);
+            g_StaticLightmapBakeProgress.store(0.0f);
+            g_StaticLightmapBakeActive.store(true);
+            JobScheduler::getInstance().acquire();
+        }
+        ~BakeSession() {
+            g_LightBakeBVH = nullptr;
+            JobScheduler::getInstance().release();
+            g_StaticLightmapBakeActive.store(false);
+            g_StaticLightmapBakeCancel.store(false);
+        }
+    } session;
+
     std::vector<Light*> stationaryShadowmaskLights;
     stationaryShadowmaskLights.reserve(4);
     int markedStaticLightCount = 0;
@@ -4980,12 +6909,30 @@ SceneCommands::StaticLightmapBakeStats SceneCommands::bakeStaticLightmaps(Scene*
         baked.cosInner = std::cos(innerRadians);
         bakedLights.push_back(baked);
     }
-    std::vector<EmissiveTriangleSurface> emissiveSurfaces = BuildEmissiveTriangleSurfaces(scene);
+    EmissiveLightSet emissiveSurfaces = BuildEmissiveLightSet(scene);
     stats.bakedLightCount = static_cast<int>(bakedLights.size()) + (emissiveSurfaces.empty() ? 0 : 1);
     if (bakedLights.empty() && emissiveSurfaces.empty()) {
         return stats;
     }
 
+    LightBakeBVH bakeBVH;
+    BuildLightBakeBVH(scene, bakeBVH);
+    g_LightBakeBVH = &bakeBVH;
+    std::cout << "[StaticLighting] Tracing " << bakeBVH.getTriangleCount() << " static triangles" << std::endl;
+
+    // The BVH stays built for probe relocation and as the fallback when the GPU bake fails.
+    std::unique_ptr<GPULightBaker> gpuBaker;
+    if (bakeSettings.staticLighting.gpuBake) {
+        gpuBaker = std::make_unique<GPULightBaker>();
+        GPULightBaker::SceneDesc gpuScene;
+        BuildGPULightBakeScene(scene, bakeSettings, bakedLights, emissiveSurfaces, gpuScene);
+        if (!gpuBaker->initialize() || !gpuBaker->buildScene(gpuScene)) {
+            gpuBaker.reset();
+        }
+    }
+    std::cout << "[StaticLighting] Baking on the " << (gpuBaker ? "GPU" : "CPU") << std::endl;
+    bool gpuParityLogged = false;
+
     std::unordered_map<int, std::vector<StaticLightingBakeCandidate>> atlasCandidates;
     atlasCandidates.reserve(manifest.atlases.size());
     for (const auto& entityPtr : scene->getAllEntities()) {
@@ -5020,10 +6967,103 @@ SceneCommands::StaticLightmapBakeStats SceneCommands::bakeStaticLightmaps(Scene*
         stats.bakedRendererCount += 1;
     }
 
+    // Atlases the last bake produced from the same inputs are kept, so editing one corner of a
+    // level only rebakes the atlases that corner can light or shadow.
+    StaticLightingContentHashes contentHashes;
+    const std::unordered_map<int, uint64_t> bakeInputHashes = HashLightmapBakeInputs(scene, atlasCandidates, contentHashes);
+    const std::vector<std::string> previousAtlasHashes = scene->getSettings().staticLighting.atlasBakeHashes;
+    int atlasSlotCount = 0;
+    for (const auto& atlasRecord : manifest.atlases) {
+        atlasSlotCount = std::max(atlasSlotCount, atlasRecord.index + 1);
+    }
+    std::vector<std::string> atlasHashes = previousAtlasHashes;
+    atlasHashes.resize(static_cast<size_t>(atlasSlotCount));
+    auto storeAtlasHash = [&](int atlasIndex, const std::string& hash) {
+        atlasHashes[static_cast<size_t>(atlasIndex)] = hash;
+        SceneSettings settings = scene->getSettings();
+        settings.staticLighting.atlasBakeHashes = atlasHashes;
+        scene->setSettings(settings);
+    };
+    auto assignAtlasPaths = [&](const StaticLightingAtlasRecord& atlasRecord) {
+        auto atlasIt = atlasCandidates.find(atlasRecord.index);
+        if (atlasIt == atlasCandidates.end()) {
+            return;
+        }
+        for (const auto& candidate : atlasIt->second) {
+            MeshRenderer::StaticLightingData metadata = candidate.renderer->getStaticLighting();
+            metadata.lightmapPath = atlasRecord.lightmapPath;
+            metadata.directionalLightmapPath = atlasRecord.directionalLightmapPath;
+            metadata.shadowmaskPath = atlasRecord.shadowmaskPath;
+            auto contentIt = contentHashes.entities.find(candidate.entity->getUUID().toString());
+            metadata.bakeHash = contentIt != contentHashes.entities.end() ? FormatLightBakeHash(contentIt->second) : std::string();
+            candidate.renderer->setStaticLighting(metadata);
+        }
+    };
+
+    // A progressive bake traces the texel samples in passes with their own seeds and averages
+    // them, so each pass refines what the previews already show.
+    const bool progressive = bakeSettings.staticLighting.progressiveBake;
+    const int passCount = progressive ? std::max(1, bakeSettings.staticLighting.progressivePasses) : 1;
+    SceneSettings passSettings = bakeSettings;
+    if (bakeSettings.staticLighting.samplesPerTexel > 0) {
+        passSettings.staticLighting.samplesPerTexel =
+            std::max(1, (bakeSettings.staticLighting.samplesPerTexel + passCount - 1) / passCount);
+    }
+    if (gpuBaker) {
+        gpuBaker->setSamplesPerTexel(passSettings.staticLighting.samplesPerTexel);
+    }
+
+    using BakeClock = std::chrono::steady_clock;
+    const auto frameBudget = std::chrono::duration<float, std::milli>(
+        std::max(1.0f, bakeSettings.staticLighting.progressiveFrameBudgetMs));
+    const auto previewInterval = std::chrono::duration<float>(
+        std::max(0.0f, bakeSettings.staticLighting.progressivePreviewSeconds));
+    auto lastFrame = BakeClock::now();
+    auto lastPreview = lastFrame;
+    auto yieldFrame = [&]() {
+        if (!hooks.onFrame || BakeClock::now() - lastFrame < frameBudget) {
+            return;
+        }
+        hooks.onFrame();
+        lastFrame = BakeClock::now();
+    };
+
+    size_t atlasOrdinal = 0;
     for (auto& atlasRecord : manifest.atlases) {
         const int atlasIndex = atlasRecord.index;
         const int width = std::max(1, atlasRecord.width);
         const int height = std::max(1, atlasRecord.height);
+        auto inputHashIt = bakeInputHashes.find(atlasIndex);
+        const std::string atlasHash = FormatLightBakeHash(inputHashIt != bakeInputHashes.end()
+            ? inputHashIt->second
+            : HashLightBakeBytes(contentHashes.settings, &atlasIndex, sizeof(atlasIndex)));
+
+        auto artifactExists = [](const std::string& path) {
+            std::error_code ec;
+            return path.empty() || std::filesystem::exists(path, ec);
+        };
+        if (static_cast<size_t>(atlasIndex) < previousAtlasHashes.size()
+            && previousAtlasHashes[static_cast<size_t>(atlasIndex)] == atlasHash
+            && !atlasRecord.expectedLightmapPath.empty()
+            && artifactExists(atlasRecord.expectedLightmapPath)
+            && artifactExists(atlasRecord.expectedDirectionalLightmapPath)
+            && artifactExists(atlasRecord.expectedShadowmaskPath)) {
+            atlasRecord.lightmapPath = atlasRecord.expectedLightmapPath;
+            atlasRecord.directionalLightmapPath = atlasRecord.expectedDirectionalLightmapPath;
+            atlasRecord.shadowmaskPath = atlasRecord.expectedShadowmaskPath;
+            assignAtlasPaths(atlasRecord);
+            stats.atlasCount += 1;
+            stats.skippedAtlasCount += 1;
+            ++atlasOrdinal;
+            g_StaticLightmapBakeProgress.store(
+                static_cast<float>(atlasOrdinal) / static_cast<float>(manifest.atlases.size()),
+                std::memory_order_relaxed);
+            std::cout << "[StaticLighting] Kept unchanged atlas " << atlasOrdinal << "/" << manifest.atlases.size() << std::endl;
+            continue;
+        }
+        // Previews overwrite the atlas files, so the old hash goes before the first one does.
+        storeAtlasHash(atlasIndex, std::string());
+
         std::vector<float> atlasDirectLighting(static_cast<size_t>(width) * static_cast<size_t>(height) * 3u, 0.0f);
         std::vector<float> atlasIndirectLighting(static_cast<size_t>(width) * static_cast<size_t>(height) * 3u, 0.0f);
         std::vector<float> atlasDirectional(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u, 0.0f);
@@ -5031,294 +7071,438 @@ SceneCommands::StaticLightmapBakeStats SceneCommands::bakeStaticLightmaps(Scene*
         std::vector<uint16_t> atlasCoverage(static_cast<size_t>(width) * static_cast<size_t>(height), 0u);
         std::vector<uint16_t> atlasShadowmaskCoverage(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u, 0u);
 
+        // Triangles in candidate order, each clipped to its texel bounds; a texel covered by several
+        // accumulates them in this order whichever tile runs it.
+        std::vector<LightmapBakeTriangle> triangles;
         auto atlasIt = atlasCandidates.find(atlasIndex);
         if (atlasIt != atlasCandidates.end()) {
             for (const auto& candidate : atlasIt->second) {
                 const auto& vertices = candidate.mesh->getVertices();
                 const auto& indices = candidate.mesh->getIndices();
                 for (size_t tri = 0; tri + 2 < indices.size(); tri += 3) {
-                    uint32_t i0 = indices[tri + 0];
-                    uint32_t i1 = indices[tri + 1];
-                    uint32_t i2 = indices[tri + 2];
-                    if (i0 >= vertices.size() || i1 >= vertices.size() || i2 >= vertices.size()) {
+                    LightmapBakeTriangle triangle;
+                    triangle.candidate = &candidate;
+                    triangle.tri = tri;
+                    triangle.i0 = indices[tri + 0];
+                    triangle.i1 = indices[tri + 1];
+                    triangle.i2 = indices[tri + 2];
+                    if (triangle.i0 >= vertices.size() || triangle.i1 >= vertices.size() || triangle.i2 >= vertices.size()) {
                         continue;
                     }
 
-                    const Vertex& v0 = vertices[i0];
-                    const Vertex& v1 = vertices[i1];
-                    const Vertex& v2 = vertices[i2];
                     const int materialIndex = ResolveTriangleMaterialIndex(*candidate.mesh, tri);
-                    std::shared_ptr<Material> material = candidate.renderer->getMaterial(static_cast<uint32_t>(std::max(materialIndex, 0)));
+                    triangle.material = candidate.renderer->getMaterial(static_cast<uint32_t>(std::max(materialIndex, 0)));
 
-                    Math::Vector2 uv0 = TransformLightmapUVToAtlas(v0.texCoord1, candidate.staticLighting.lightmapScaleOffset);
-                    Math::Vector2 uv1 = TransformLightmapUVToAtlas(v1.texCoord1, candidate.staticLighting.lightmapScaleOffset);
-                    Math::Vector2 uv2 = TransformLightmapUVToAtlas(v2.texCoord1, candidate.staticLighting.lightmapScaleOffset);
+                    triangle.uv0 = TransformLightmapUVToAtlas(vertices[triangle.i0].texCoord1, candidate.staticLighting.lightmapScaleOffset);
+                    triangle.uv1 = TransformLightmapUVToAtlas(vertices[triangle.i1].texCoord1, candidate.staticLighting.lightmapScaleOffset);
+                    triangle.uv2 = TransformLightmapUVToAtlas(vertices[triangle.i2].texCoord1, candidate.staticLighting.lightmapScaleOffset);
 
-                    Math::Vector2 p0(uv0.x * static_cast<float>(width), uv0.y * static_cast<float>(height));
-                    Math::Vector2 p1(uv1.x * static_cast<float>(width), uv1.y * static_cast<float>(height));
-                    Math::Vector2 p2(uv2.x * static_cast<float>(width), uv2.y * static_cast<float>(height));
+                    Math::Vector2 p0(triangle.uv0.x * static_cast<float>(width), triangle.uv0.y * static_cast<float>(height));
+                    Math::Vector2 p1(triangle.uv1.x * static_cast<float>(width), triangle.uv1.y * static_cast<float>(height));
+                    Math::Vector2 p2(triangle.uv2.x * static_cast<float>(width), triangle.uv2.y * static_cast<float>(height));
 
                     float minXf = std::floor(std::min(p0.x, std::min(p1.x, p2.x)));
                     float minYf = std::floor(std::min(p0.y, std::min(p1.y, p2.y)));
                     float maxXf = std::ceil(std::max(p0.x, std::max(p1.x, p2.x)));
                     float maxYf = std::ceil(std::max(p0.y, std::max(p1.y, p2.y)));
 
-                    int minX = std::max(0, static_cast<int>(minXf));
-                    int minY = std::max(0, static_cast<int>(minYf));
-                    int maxX = std::min(width - 1, static_cast<int>(maxXf));
-                    int maxY = std::min(height - 1, static_cast<int>(maxYf));
-
-                    for (int y = minY; y <= maxY; ++y) {
-                        for (int x = minX; x <= maxX; ++x) {
-                            Math::Vector2 sampleUV((static_cast<float>(x) + 0.5f) / static_cast<float>(width),
-                                                   (static_cast<float>(y) + 0.5f) / static_cast<float>(height));
-                            Math::Vector3 bary;
-                            if (!ComputeBarycentrics(sampleUV, uv0, uv1, uv2, bary)) {
-                                continue;
-                            }
-
-                            Math::Vector3 localPos = v0.position * bary.x + v1.position * bary.y + v2.position * bary.z;
-                            Math::Vector2 surfaceUV = v0.texCoord * bary.x + v1.texCoord * bary.y + v2.texCoord * bary.z;
-                            Math::Vector3 localNormal = (v0.normal * bary.x + v1.normal * bary.y + v2.normal * bary.z).normalized();
-                            if (localNormal.lengthSquared() <= Math::EPSILON) {
-                                localNormal = Math::Vector3::Up;
-                            }
-                            Math::Vector3 localTangent = v0.tangent * bary.x + v1.tangent * bary.y + v2.tangent * bary.z;
-                            Math::Vector3 localBitangent = v0.bitangent * bary.x + v1.bitangent * bary.y + v2.bitangent * bary.z;
-
-                            Math::Vector3 positionWS = candidate.worldMatrix.transformPoint(localPos);
-                            Math::Vector3 geometryNormalWS = candidate.normalMatrix.transformDirection(localNormal).normalized();
-                            if (geometryNormalWS.lengthSquared() <= Math::EPSILON) {
-                                geometryNormalWS = candidate.worldMatrix.transformDirection(localNormal).normalized();
-                            }
-                            if (geometryNormalWS.lengthSquared() <= Math::EPSILON) {
-                                geometryNormalWS = Math::Vector3::Up;
-                            }
-                            Math::Vector3 tangentWS = candidate.normalMatrix.transformDirection(localTangent).normalized();
-                            Math::Vector3 bitangentWS = candidate.normalMatrix.transformDirection(localBitangent).normalized();
-                            Math::Vector3 shadingNormalWS = ResolveBakeShadingNormal(
-                                material,
-                                surfaceUV,
-                                geometryNormalWS,
-                                tangentWS,
-                                bitangentWS
-                            );
-
-                            Math::Vector3 accumulated = Math::Vector3::Zero;
-                            Math::Vector3 indirect = Math::Vector3::Zero;
-                            Math::Vector3 dominantDirection = Math::Vector3::Zero;
-                            float dominantWeight = 0.0f;
-                            float referenceNoL = 0.0f;
-                            for (const BakedDirectLight& light : bakedLights) {
-                                Math::Vector3 contribution = BakeLightContribution(light, positionWS, shadingNormalWS);
-                                if (contribution.lengthSquared() <= Math::EPSILON) {
-                                    continue;
-                                }
-                                bool visible = IsDirectLightVisible(scene, light, positionWS, geometryNormalWS);
-                                if (light.mobility == Light::Mobility::Stationary && light.shadowmaskChannel >= 0) {
-                                    size_t shadowmaskIndex = (static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)) * 4u
-                                        + static_cast<size_t>(light.shadowmaskChannel);
-                                    atlasShadowmask[shadowmaskIndex] += visible ? 1.0f : 0.0f;
-                                    atlasShadowmaskCoverage[shadowmaskIndex] += 1u;
-                                }
-                                if (!visible) {
-                                    continue;
-                                }
-                                if (light.mobility == Light::Mobility::Stationary) {
-                                    continue;
-                                }
-                                accumulated += contribution;
-
-                                Math::Vector3 lightDir = Math::Vector3::Zero;
-                                float sampleNoL = 0.0f;
-                                if (ComputeIncidentLightDirection(light, positionWS, shadingNormalWS, lightDir, sampleNoL)) {
-                                    float weight = std::max(ComputeLuminance(contribution), 0.0f);
-                                    dominantDirection += lightDir * weight;
-                                    dominantWeight += weight;
-                                    referenceNoL += sampleNoL * weight;
-                                }
-                            }
-                            if (!emissiveSurfaces.empty()) {
-                                EmissiveLightingEstimate emissiveDirect = EstimateEmissiveSurfaceLighting(
-                                    scene,
-                                    emissiveSurfaces,
-                                    positionWS,
-                                    shadingNormalWS,
-                                    static_cast<uint32_t>((atlasIndex + 1) * 2166136261u)
-                                        ^ static_cast<uint32_t>((x + 1) * 16777619u)
-                                        ^ static_cast<uint32_t>((y + 1) * 374761393u)
-                                        ^ static_cast<uint32_t>(tri * 668265263u),
-                                    std::max(1, std::min(8, bakeSettings.staticLighting.samplesPerTexel / 32))
-                                );
-                                accumulated += emissiveDirect.irradiance;
-                                dominantDirection += emissiveDirect.weightedDirection;
-                                dominantWeight += emissiveDirect.directionWeight;
-                                referenceNoL += emissiveDirect.referenceNoL;
-                            }
-                            accumulated = ClampColor(accumulated, 16.0f);
-                            if (candidate.staticLighting.receiveGI && bakeSettings.staticLighting.indirectBounces > 0) {
-                                Math::Vector3 primaryAlbedo = Math::Vector3::One;
-                                Math::Vector3 primaryEmission = Math::Vector3::Zero;
-                                float primaryAO = 1.0f;
-                                bool primaryContributeGI = true;
-                                ResolveIndirectSurfaceProperties(candidate.entity,
-                                                                 positionWS,
-                                                                 primaryAlbedo,
-                                                                 primaryEmission,
-                                                                 primaryAO,
-                                                                 primaryContributeGI);
-                                uint32_t sampleSeed = static_cast<uint32_t>((atlasIndex + 1) * 73856093)
-                                    ^ static_cast<uint32_t>((x + 1) * 19349663)
-                                    ^ static_cast<uint32_t>((y + 1) * 83492791)
-                                    ^ static_cast<uint32_t>(tri * 2654435761u);
-                                int adaptiveSampleCount = ComputeAdaptiveIndirectSampleCount(
-                                    bakeSettings,
-                                    accumulated,
-                                    primaryEmission,
-                                    primaryAO
-                                );
-                                indirect = EstimateIndirectLighting(
-                                    scene,
-                                    bakeSettings,
-                                    bakedLights,
-                                    emissiveSurfaces,
-                                    positionWS,
-                                    geometryNormalWS,
-                                    sampleSeed,
-                                    adaptiveSampleCount
-                                );
-                            }
-
-                            size_t pixelIndex = static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x);
-                            atlasDirectLighting[pixelIndex * 3 + 0] += accumulated.x;
-                            atlasDirectLighting[pixelIndex * 3 + 1] += accumulated.y;
-                            atlasDirectLighting[pixelIndex * 3 + 2] += accumulated.z;
-                            atlasIndirectLighting[pixelIndex * 3 + 0] += indirect.x;
-                            atlasIndirectLighting[pixelIndex * 3 + 1] += indirect.y;
-                            atlasIndirectLighting[pixelIndex * 3 + 2] += indirect.z;
-                            if (dominantWeight > Math::EPSILON) {
-                                Math::Vector3 encodedDominant = dominantDirection / dominantWeight;
-                                float encodedReference = referenceNoL / dominantWeight;
-                                atlasDirectional[pixelIndex * 4 + 0] += encodedDominant.x;
-                                atlasDirectional[pixelIndex * 4 + 1] += encodedDominant.y;
-                                atlasDirectional[pixelIndex * 4 + 2] += encodedDominant.z;
-                                atlasDirectional[pixelIndex * 4 + 3] += encodedReference;
-                            }
-                            atlasCoverage[pixelIndex] += 1;
-                        }
+                    triangle.minX = std::max(0, static_cast<int>(minXf));
+                    triangle.minY = std::max(0, static_cast<int>(minYf));
+                    triangle.maxX = std::min(width - 1, static_cast<int>(maxXf));
+                    triangle.maxY = std::min(height - 1, static_cast<int>(maxYf));
+                    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) {
+                        continue;
                     }
+                    triangles.push_back(std::move(triangle));
                 }
             }
         }
 
-        std::vector<float> atlasPixelsHDR(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u, 0.0f);
-        std::vector<unsigned char> directionalPixels(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u, 0u);
-        std::vector<unsigned char> shadowmaskPixels(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u, 255u);
-        for (size_t pixelIndex = 0; pixelIndex < atlasCoverage.size(); ++pixelIndex) {
-            uint16_t coverage = atlasCoverage[pixelIndex];
-            if (coverage == 0u) {
-                continue;
+        const int tilesX = (width + kLightmapBakeTileSize - 1) / kLightmapBakeTileSize;
+        const int tilesY = (height + kLightmapBakeTileSize - 1) / kLightmapBakeTileSize;
+        std::vector<std::vector<uint32_t>> tileTriangles(static_cast<size_t>(tilesX) * static_cast<size_t>(tilesY));
+        for (uint32_t triangleIndex = 0; triangleIndex < triangles.size(); ++triangleIndex) {
+            const LightmapBakeTriangle& triangle = triangles[triangleIndex];
+            for (int tileY = triangle.minY / kLightmapBakeTileSize; tileY <= triangle.maxY / kLightmapBakeTileSize; ++tileY) {
+                for (int tileX = triangle.minX / kLightmapBakeTileSize; tileX <= triangle.maxX / kLightmapBakeTileSize; ++tileX) {
+                    tileTriangles[static_cast<size_t>(tileY) * static_cast<size_t>(tilesX) + static_cast<size_t>(tileX)].push_back(triangleIndex);
+                }
             }
-            float invCoverage = 1.0f / static_cast<float>(coverage);
-            atlasDirectLighting[pixelIndex * 3 + 0] *= invCoverage;
-            atlasDirectLighting[pixelIndex * 3 + 1] *= invCoverage;
-            atlasDirectLighting[pixelIndex * 3 + 2] *= invCoverage;
-            atlasIndirectLighting[pixelIndex * 3 + 0] *= invCoverage;
-            atlasIndirectLighting[pixelIndex * 3 + 1] *= invCoverage;
-            atlasIndirectLighting[pixelIndex * 3 + 2] *= invCoverage;
-            atlasDirectional[pixelIndex * 4 + 0] *= invCoverage;
-            atlasDirectional[pixelIndex * 4 + 1] *= invCoverage;
-            atlasDirectional[pixelIndex * 4 + 2] *= invCoverage;
-            atlasDirectional[pixelIndex * 4 + 3] *= invCoverage;
-        }
-        if (bakeSettings.staticLighting.denoise && bakeSettings.staticLighting.indirectBounces > 0) {
-            DenoiseIndirectAtlas(atlasDirectLighting, atlasCoverage, width, height, atlasIndirectLighting);
-        }
-        for (size_t pixelIndex = 0; pixelIndex < atlasCoverage.size(); ++pixelIndex) {
-            uint16_t coverage = atlasCoverage[pixelIndex];
-            if (coverage == 0) {
-                continue;
+        }
+
+        // Every seed is derived from the atlas, texel, triangle and pass, so the result does not
+        // depend on which worker or backend bakes a texel, or when. Pass 0 keeps the plain seeds.
+        uint32_t passSeed = 0u;
+        int pass = 0;
+        auto prepareTexel = [&](const LightmapBakeTriangle& triangle, int x, int y, LightmapTexelSample& outSample) {
+            const StaticLightingBakeCandidate& candidate = *triangle.candidate;
+            const auto& vertices = candidate.mesh->getVertices();
+            const Vertex& v0 = vertices[triangle.i0];
+            const Vertex& v1 = vertices[triangle.i1];
+            const Vertex& v2 = vertices[triangle.i2];
+            Math::Vector2 sampleUV((static_cast<float>(x) + 0.5f) / static_cast<float>(width),
+                                   (static_cast<float>(y) + 0.5f) / static_cast<float>(height));
+            Math::Vector3 bary;
+            if (!ComputeBarycentrics(sampleUV, triangle.uv0, triangle.uv1, triangle.uv2, bary)) {
+                return false;
+            }
+
+            Math::Vector3 localPos = v0.position * bary.x + v1.position * bary.y + v2.position * bary.z;
+            Math::Vector2 surfaceUV = v0.texCoord * bary.x + v1.texCoord * bary.y + v2.texCoord * bary.z;
+            Math::Vector3 localNormal = (v0.normal * bary.x + v1.normal * bary.y + v2.normal * bary.z).normalized();
+            if (localNormal.lengthSquared() <= Math::EPSILON) {
+                localNormal = Math::Vector3::Up;
+            }
+            Math::Vector3 localTangent = v0.tangent * bary.x + v1.tangent * bary.y + v2.tangent * bary.z;
+            Math::Vector3 localBitangent = v0.bitangent * bary.x + v1.bitangent * bary.y + v2.bitangent * bary.z;
+
+            outSample.pixelIndex = static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x);
+            outSample.positionWS = candidate.worldMatrix.transformPoint(localPos);
+            Math::Vector3 geometryNormalWS = candidate.normalMatrix.transformDirection(localNormal).normalized();
+            if (geometryNormalWS.lengthSquared() <= Math::EPSILON) {
+                geometryNormalWS = candidate.worldMatrix.transformDirection(localNormal).normalized();
+            }
+            if (geometryNormalWS.lengthSquared() <= Math::EPSILON) {
+                geometryNormalWS = Math::Vector3::Up;
+            }
+            outSample.geometryNormalWS = geometryNormalWS;
+            Math::Vector3 tangentWS = candidate.normalMatrix.transformDirection(localTangent).normalized();
+            Math::Vector3 bitangentWS = candidate.normalMatrix.transformDirection(localBitangent).normalized();
+            outSample.shadingNormalWS = ResolveBakeShadingNormal(
+                triangle.material,
+                surfaceUV,
+                geometryNormalWS,
+                tangentWS,
+                bitangentWS
+            );
+            outSample.emissiveSeed = static_cast<uint32_t>((atlasIndex + 1) * 2166136261u)
+                ^ static_cast<uint32_t>((x + 1) * 16777619u)
+                ^ static_cast<uint32_t>((y + 1) * 374761393u)
+                ^ static_cast<uint32_t>(triangle.tri * 668265263u)
+                ^ passSeed;
+            outSample.receiveGI = candidate.staticLighting.receiveGI;
+            if (outSample.receiveGI && bakeSettings.staticLighting.indirectBounces > 0) {
+                // The texel's own surface sets how many bounce paths it gets.
+                Math::Vector3 primaryAlbedo;
+                ResolveMaterialSample(triangle.material, surfaceUV, primaryAlbedo, outSample.primaryEmission, outSample.primaryAO);
+                outSample.indirectSeed = static_cast<uint32_t>((atlasIndex + 1) * 73856093)
+                    ^ static_cast<uint32_t>((x + 1) * 19349663)
+                    ^ static_cast<uint32_t>((y + 1) * 83492791)
+                    ^ static_cast<uint32_t>(triangle.tri * 2654435761u)
+                    ^ passSeed;
+            }
+            return true;
+        };
+
+        auto accumulateTexel = [&](const LightmapTexelSample& sample, const LightmapTexelLighting& lighting) {
+            const size_t pixelIndex = sample.pixelIndex;
+            atlasDirectLighting[pixelIndex * 3 + 0] += lighting.direct.x;
+            atlasDirectLighting[pixelIndex * 3 + 1] += lighting.direct.y;
+            atlasDirectLighting[pixelIndex * 3 + 2] += lighting.direct.z;
+            atlasIndirectLighting[pixelIndex * 3 + 0] += lighting.indirect.x;
+            atlasIndirectLighting[pixelIndex * 3 + 1] += lighting.indirect.y;
+            atlasIndirectLighting[pixelIndex * 3 + 2] += lighting.indirect.z;
+            if (lighting.hasDominant) {
+                atlasDirectional[pixelIndex * 4 + 0] += lighting.dominantDirection.x;
+                atlasDirectional[pixelIndex * 4 + 1] += lighting.dominantDirection.y;
+                atlasDirectional[pixelIndex * 4 + 2] += lighting.dominantDirection.z;
+                atlasDirectional[pixelIndex * 4 + 3] += lighting.referenceNoL;
             }
-            float r = bakeSettings.staticLighting.bakeDirectLighting
-                ? std::max(atlasDirectLighting[pixelIndex * 3 + 0] + atlasIndirectLighting[pixelIndex * 3 + 0], 0.0f)
-                : std::max(atlasIndirectLighting[pixelIndex * 3 + 0], 0.0f);
-            float g = bakeSettings.staticLighting.bakeDirectLighting
-                ? std::max(atlasDirectLighting[pixelIndex * 3 + 1] + atlasIndirectLighting[pixelIndex * 3 + 1], 0.0f)
-                : std::max(atlasIndirectLighting[pixelIndex * 3 + 1], 0.0f);
-            float b = bakeSettings.staticLighting.bakeDirectLighting
-                ? std::max(atlasDirectLighting[pixelIndex * 3 + 2] + atlasIndirectLighting[pixelIndex * 3 + 2], 0.0f)
-                : std::max(atlasIndirectLighting[pixelIndex * 3 + 2], 0.0f);
-
-            atlasPixelsHDR[pixelIndex * 4 + 0] = r;
-            atlasPixelsHDR[pixelIndex * 4 + 1] = g;
-            atlasPixelsHDR[pixelIndex * 4 + 2] = b;
-            atlasPixelsHDR[pixelIndex * 4 + 3] = 1.0f;
-
-            Math::Vector3 directionalVec(atlasDirectional[pixelIndex * 4 + 0],
-                                         atlasDirectional[pixelIndex * 4 + 1],
-                                         atlasDirectional[pixelIndex * 4 + 2]);
-            directionalVec = Math::Vector3::Clamp(directionalVec,
-                                                  Math::Vector3(-1.0f, -1.0f, -1.0f),
-                                                  Math::Vector3(1.0f, 1.0f, 1.0f));
-            float encodedReference = Math::Clamp(atlasDirectional[pixelIndex * 4 + 3], 0.0f, 1.0f);
-            directionalPixels[pixelIndex * 4 + 0] = static_cast<unsigned char>(Math::Clamp(directionalVec.x * 0.5f + 0.5f, 0.0f, 1.0f) * 255.0f);
-            directionalPixels[pixelIndex * 4 + 1] = static_cast<unsigned char>(Math::Clamp(directionalVec.y * 0.5f + 0.5f, 0.0f, 1.0f) * 255.0f);
-            directionalPixels[pixelIndex * 4 + 2] = static_cast<unsigned char>(Math::Clamp(directionalVec.z * 0.5f + 0.5f, 0.0f, 1.0f) * 255.0f);
-            directionalPixels[pixelIndex * 4 + 3] = static_cast<unsigned char>(encodedReference * 255.0f);
             for (size_t channel = 0; channel < 4u; ++channel) {
-                size_t shadowmaskIndex = pixelIndex * 4u + channel;
-                uint16_t shadowmaskCoverage = atlasShadowmaskCoverage[shadowmaskIndex];
-                if (shadowmaskCoverage == 0u) {
+                if (lighting.shadowmask[channel] >= 0.0f) {
+                    atlasShadowmask[pixelIndex * 4u + channel] += lighting.shadowmask[channel];
+                    atlasShadowmaskCoverage[pixelIndex * 4u + channel] += 1u;
+                }
+            }
+            atlasCoverage[pixelIndex] += 1;
+        };
+
+        auto reportProgress = [&](float passFraction) {
+            const float atlasFraction = (static_cast<float>(pass) + passFraction) / static_cast<float>(passCount);
+            g_StaticLightmapBakeProgress.store(
+                (static_cast<float>(atlasOrdinal) + atlasFraction) / static_cast<float>(manifest.atlases.size()),
+                std::memory_order_relaxed);
+        };
+
+        // Resolves the sums so far into the atlas files and points the renderers at them. Previews
+        // work on copies so the passes after them keep accumulating.
+        auto writeAtlas = [&](bool preview) {
+            std::vector<float> previewDirectLighting;
+            std::vector<float> previewIndirectLighting;
+            std::vector<float> previewDirectional;
+            if (preview) {
+                previewDirectLighting = atlasDirectLighting;
+                previewIndirectLighting = atlasIndirectLighting;
+                previewDirectional = atlasDirectional;
+            }
+            std::vector<float>& directLighting = preview ? previewDirectLighting : atlasDirectLighting;
+            std::vector<float>& indirectLighting = preview ? previewIndirectLighting : atlasIndirectLighting;
+            std::vector<float>& directional = preview ? previewDirectional : atlasDirectional;
+
+            std::vector<float> atlasPixelsHDR(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u, 0.0f);
+            std::vector<unsigned char> directionalPixels(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u, 0u);
+            std::vector<unsigned char> shadowmaskPixels(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u, 255u);
+            for (size_t pixelIndex = 0; pixelIndex < atlasCoverage.size(); ++pixelIndex) {
+                uint16_t coverage = atlasCoverage[pixelIndex];
+                if (coverage == 0u) {
                     continue;
                 }
-                float visibility = atlasShadowmask[shadowmaskIndex] / static_cast<float>(shadowmaskCoverage);
-                shadowmaskPixels[shadowmaskIndex] = static_cast<unsigned char>(Math::Clamp(visibility, 0.0f, 1.0f) * 255.0f);
+                float invCoverage = 1.0f / static_cast<float>(coverage);
+                directLighting[pixelIndex * 3 + 0] *= invCoverage;
+                directLighting[pixelIndex * 3 + 1] *= invCoverage;
+                directLighting[pixelIndex * 3 + 2] *= invCoverage;
+                indirectLighting[pixelIndex * 3 + 0] *= invCoverage;
+                indirectLighting[pixelIndex * 3 + 1] *= invCoverage;
+                indirectLighting[pixelIndex * 3 + 2] *= invCoverage;
+                directional[pixelIndex * 4 + 0] *= invCoverage;
+                directional[pixelIndex * 4 + 1] *= invCoverage;
+                directional[pixelIndex * 4 + 2] *= invCoverage;
+                directional[pixelIndex * 4 + 3] *= invCoverage;
+            }
+            if (bakeSettings.staticLighting.denoise && bakeSettings.staticLighting.indirectBounces > 0) {
+                const auto denoiseStart = BakeClock::now();
+                DenoiseIndirectAtlas(directLighting, atlasCoverage, width, height, indirectLighting);
+                if (!preview) {
+                    std::cout << "[StaticLighting] Denoised " << width << "x" << height << " atlas in "
+                              << std::chrono::duration<float, std::milli>(BakeClock::now() - denoiseStart).count()
+                              << " ms" << std::endl;
+                }
+            }
+            int texelCount = 0;
+            for (size_t pixelIndex = 0; pixelIndex < atlasCoverage.size(); ++pixelIndex) {
+                uint16_t coverage = atlasCoverage[pixelIndex];
+                if (coverage == 0) {
+                    continue;
+                }
+                float r = bakeSettings.staticLighting.bakeDirectLighting
+                    ? std::max(directLighting[pixelIndex * 3 + 0] + indirectLighting[pixelIndex * 3 + 0], 0.0f)
+                    : std::max(indirectLighting[pixelIndex * 3 + 0], 0.0f);
+                float g = bakeSettings.staticLighting.bakeDirectLighting
+                    ? std::max(directLighting[pixelIndex * 3 + 1] + indirectLighting[pixelIndex * 3 + 1], 0.0f)
+                    : std::max(indirectLighting[pixelIndex * 3 + 1], 0.0f);
+                float b = bakeSettings.staticLighting.bakeDirectLighting
+                    ? std::max(directLighting[pixelIndex * 3 + 2] + indirectLighting[pixelIndex * 3 + 2], 0.0f)
+                    : std::max(indirectLighting[pixelIndex * 3 + 2], 0.0f);
+
+                atlasPixelsHDR[pixelIndex * 4 + 0] = r;
+                atlasPixelsHDR[pixelIndex * 4 + 1] = g;
+                atlasPixelsHDR[pixelIndex * 4 + 2] = b;
+                atlasPixelsHDR[pixelIndex * 4 + 3] = 1.0f;
+
+                Math::Vector3 directionalVec(directional[pixelIndex * 4 + 0],
+                                             directional[pixelIndex * 4 + 1],
+                                             directional[pixelIndex * 4 + 2]);
+                directionalVec = Math::Vector3::Clamp(directionalVec,
+                                                      Math::Vector3(-1.0f, -1.0f, -1.0f),
+                                                      Math::Vector3(1.0f, 1.0f, 1.0f));
+                float encodedReference = Math::Clamp(directional[pixelIndex * 4 + 3], 0.0f, 1.0f);
+                directionalPixels[pixelIndex * 4 + 0] = static_cast<unsigned char>(Math::Clamp(directionalVec.x * 0.5f + 0.5f, 0.0f, 1.0f) * 255.0f);
+                directionalPixels[pixelIndex * 4 + 1] = static_cast<unsigned char>(Math::Clamp(directionalVec.y * 0.5f + 0.5f, 0.0f, 1.0f) * 255.0f);
+                directionalPixels[pixelIndex * 4 + 2] = static_cast<unsigned char>(Math::Clamp(directionalVec.z * 0.5f + 0.5f, 0.0f, 1.0f) * 255.0f);
+                directionalPixels[pixelIndex * 4 + 3] = static_cast<unsigned char>(encodedReference * 255.0f);
+                for (size_t channel = 0; channel < 4u; ++channel) {
+                    size_t shadowmaskIndex = pixelIndex * 4u + channel;
+                    uint16_t shadowmaskCoverage = atlasShadowmaskCoverage[shadowmaskIndex];
+                    if (shadowmaskCoverage == 0u) {
+                        continue;
+                    }
+                    float visibility = atlasShadowmask[shadowmaskIndex] / static_cast<float>(shadowmaskCoverage);
+                    shadowmaskPixels[shadowmaskIndex] = static_cast<unsigned char>(Math::Clamp(visibility, 0.0f, 1.0f) * 255.0f);
+                }
+                texelCount += 1;
             }
-            stats.bakedTexelCount += 1;
-        }
 
-        std::string lightmapPath = atlasRecord.expectedLightmapPath;
-        if (lightmapPath.empty()) {
-            continue;
-        }
-        std::error_code ec;
-        std::filesystem::create_directories(std::filesystem::path(lightmapPath).parent_path(), ec);
-        if (!WriteEXRImage(lightmapPath, width, height, atlasPixelsHDR, true)) {
-            continue;
-        }
+            std::string lightmapPath = atlasRecord.expectedLightmapPath;
+            if (lightmapPath.empty()) {
+                return false;
+            }
+            std::error_code ec;
+            std::filesystem::create_directories(std::filesystem::path(lightmapPath).parent_path(), ec);
+            if (!WriteEXRImage(lightmapPath, width, height, atlasPixelsHDR, true)) {
+                return false;
+            }
 
-        atlasRecord.lightmapPath = lightmapPath;
-        std::string directionalPath = atlasRecord.expectedDirectionalLightmapPath;
-        if (!directionalPath.empty()) {
-            std::error_code directionalEc;
-            std::filesystem::create_directories(std::filesystem::path(directionalPath).parent_path(), directionalEc);
-            if (stbi_write_png(directionalPath.c_str(), width, height, 4, directionalPixels.data(), width * 4) != 0) {
-                atlasRecord.directionalLightmapPath = directionalPath;
+            atlasRecord.lightmapPath = lightmapPath;
+            std::string directionalPath = atlasRecord.expectedDirectionalLightmapPath;
+            if (!directionalPath.empty()) {
+                std::error_code directionalEc;
+                std::filesystem::create_directories(std::filesystem::path(directionalPath).parent_path(), directionalEc);
+                if (stbi_write_png(directionalPath.c_str(), width, height, 4, directionalPixels.data(), width * 4) != 0) {
+                    atlasRecord.directionalLightmapPath = directionalPath;
+                }
             }
-        }
-        std::string shadowmaskPath = atlasRecord.expectedShadowmaskPath;
-        if (!shadowmaskPath.empty()) {
-            std::error_code shadowmaskEc;
-            std::filesystem::create_directories(std::filesystem::path(shadowmaskPath).parent_path(), shadowmaskEc);
-            if (stbi_write_png(shadowmaskPath.c_str(), width, height, 4, shadowmaskPixels.data(), width * 4) != 0) {
-                atlasRecord.shadowmaskPath = shadowmaskPath;
+            std::string shadowmaskPath = atlasRecord.expectedShadowmaskPath;
+            if (!shadowmaskPath.empty()) {
+                std::error_code shadowmaskEc;
+                std::filesystem::create_directories(std::filesystem::path(shadowmaskPath).parent_path(), shadowmaskEc);
+                if (stbi_write_png(shadowmaskPath.c_str(), width, height, 4, shadowmaskPixels.data(), width * 4) != 0) {
+                    atlasRecord.shadowmaskPath = shadowmaskPath;
+                }
             }
-        }
-        stats.atlasCount += 1;
+            assignAtlasPaths(atlasRecord);
+            if (!preview) {
+                stats.bakedTexelCount += texelCount;
+            }
+            return true;
+        };
 
-        if (atlasIt != atlasCandidates.end()) {
-            for (const auto& candidate : atlasIt->second) {
-                MeshRenderer::StaticLightingData metadata = candidate.renderer->getStaticLighting();
-                metadata.lightmapPath = lightmapPath;
-                metadata.directionalLightmapPath = atlasRecord.directionalLightmapPath;
-                metadata.shadowmaskPath = atlasRecord.shadowmaskPath;
-                candidate.renderer->setStaticLighting(metadata);
+        auto clearAtlas = [&]() {
+            std::fill(atlasDirectLighting.begin(), atlasDirectLighting.end(), 0.0f);
+            std::fill(atlasIndirectLighting.begin(), atlasIndirectLighting.end(), 0.0f);
+            std::fill(atlasDirectional.begin(), atlasDirectional.end(), 0.0f);
+            std::fill(atlasShadowmask.begin(), atlasShadowmask.end(), 0.0f);
+            std::fill(atlasCoverage.begin(), atlasCoverage.end(), static_cast<uint16_t>(0));
+            std::fill(atlasShadowmaskCoverage.begin(), atlasShadowmaskCoverage.end(), static_cast<uint16_t>(0));
+        };
+
+        for (pass = 0; pass < passCount; ++pass) {
+            passSeed = pass == 0 ? 0u : HashUint(static_cast<uint32_t>(pass) * 0x9e3779b9u);
+
+            // Texel samples go to the GPU in triangle order and come back in it, so each texel
+            // accumulates its triangles in the same order as the CPU tiles do.
+            bool bakedOnGPU = false;
+            if (gpuBaker) {
+                std::vector<LightmapTexelSample> samples;
+                std::vector<GPULightBakeQuery> queries;
+                std::vector<GPULightBakeResult> results;
+                size_t preparedTriangles = 0;
+                auto flushSamples = [&]() {
+                    const size_t chunkBegin = preparedTriangles;
+                    bool traced = gpuBaker->trace(queries, results, [&](size_t) {
+                        yieldFrame();
+                        return !g_StaticLightmapBakeCancel.load(std::memory_order_relaxed);
+                    });
+                    if (!traced) {
+                        return false;
+                    }
+                    if (!gpuParityLogged) {
+                        LogGPULightmapParity(scene, passSettings, bakedLights, emissiveSurfaces, samples, results);
+                        gpuParityLogged = true;
+                    }
+                    for (size_t index = 0; index < samples.size(); ++index) {
+                        accumulateTexel(samples[index], ReadLightmapTexelResult(results[index]));
+                    }
+                    samples.clear();
+                    queries.clear();
+                    reportProgress(triangles.empty() ? 1.0f : static_cast<float>(chunkBegin) / static_cast<float>(triangles.size()));
+                    return true;
+                };
+
+                bakedOnGPU = true;
+                for (const LightmapBakeTriangle& triangle : triangles) {
+                    for (int y = triangle.minY; bakedOnGPU && y <= triangle.maxY; ++y) {
+                        for (int x = triangle.minX; x <= triangle.maxX; ++x) {
+                            LightmapTexelSample sample;
+                            if (!prepareTexel(triangle, x, y, sample)) {
+                                continue;
+                            }
+                            queries.push_back(BuildLightmapTexelQuery(sample));
+                            samples.push_back(sample);
+                            if (samples.size() >= kGPULightmapQueryChunk && !flushSamples()) {
+                                bakedOnGPU = false;
+                                break;
+                            }
+                        }
+                    }
+                    if (!bakedOnGPU) {
+                        break;
+                    }
+                    ++preparedTriangles;
+                    yieldFrame();
+                }
+                bakedOnGPU = bakedOnGPU && flushSamples();
+                if (g_StaticLightmapBakeCancel.load(std::memory_order_relaxed)) {
+                    stats.cancelled = true;
+                    return stats;
+                }
+                if (!bakedOnGPU) {
+                    // Earlier passes came from the GPU too; the CPU starts the atlas over.
+                    std::cerr << "[StaticLighting] GPU bake failed; baking on the CPU" << std::endl;
+                    gpuBaker.reset();
+                    clearAtlas();
+                    pass = -1;
+                    continue;
+                }
+            }
+
+            // Tiles own disjoint texels, so workers never write the same atlas entry. With an
+            // onFrame hook the tiles go out in rounds, and the editor gets its frames between
+            // rounds, when the workers are free for its own jobs.
+            if (!bakedOnGPU) {
+                std::atomic<size_t> nextTile{0};
+                std::atomic<size_t> finishedTiles{0};
+                size_t roundEnd = 0;
+                const size_t tileCount = tileTriangles.size();
+                auto bakeTiles = [&]() {
+                    for (size_t tile = nextTile++; tile < roundEnd; tile = nextTile++) {
+                        if (g_StaticLightmapBakeCancel.load(std::memory_order_relaxed)) {
+                            return;
+                        }
+                        const int x0 = static_cast<int>(tile % static_cast<size_t>(tilesX)) * kLightmapBakeTileSize;
+                        const int y0 = static_cast<int>(tile / static_cast<size_t>(tilesX)) * kLightmapBakeTileSize;
+                        const int x1 = std::min(width - 1, x0 + kLightmapBakeTileSize - 1);
+                        const int y1 = std::min(height - 1, y0 + kLightmapBakeTileSize - 1);
+                        for (uint32_t triangleIndex : tileTriangles[tile]) {
+                            const LightmapBakeTriangle& triangle = triangles[triangleIndex];
+                            for (int y = std::max(triangle.minY, y0); y <= std::min(triangle.maxY, y1); ++y) {
+                                for (int x = std::max(triangle.minX, x0); x <= std::min(triangle.maxX, x1); ++x) {
+                                    LightmapTexelSample sample;
+                                    if (prepareTexel(triangle, x, y, sample)) {
+                                        accumulateTexel(sample, ComputeLightmapTexelLighting(scene, passSettings, bakedLights,
+                                                                                             emissiveSurfaces, sample));
+                                    }
+                                }
+                            }
+                        }
+                        const size_t finished = ++finishedTiles;
+                        reportProgress(static_cast<float>(finished) / static_cast<float>(tileCount));
+                    }
+                };
+                JobScheduler& scheduler = JobScheduler::getInstance();
+                const size_t workerCount = scheduler.isRunning() ? scheduler.workerCount() : 0;
+                const size_t roundSize = hooks.onFrame ? (workerCount + 1) * 4 : tileCount;
+                while (roundEnd < tileCount) {
+                    // Tiles a round's last claims past its end belong to the next round.
+                    nextTile.store(roundEnd);
+                    roundEnd = std::min(tileCount, roundEnd + roundSize);
+                    const size_t helperCount = std::min(workerCount, roundEnd - nextTile.load());
+                    auto fence = std::make_shared<JobFence>();
+                    for (size_t helper = 0; helper < helperCount; ++helper) {
+                        fence->remaining.fetch_add(1, std::memory_order_relaxed);
+                        scheduler.schedule([&bakeTiles]() { bakeTiles(); }, fence);
+                    }
+                    bakeTiles();
+                    scheduler.wait(*fence);
+                    if (g_StaticLightmapBakeCancel.load(std::memory_order_relaxed)) {
+                        stats.cancelled = true;
+                        return stats;
+                    }
+                    yieldFrame();
+                }
             }
+
+            if (progressive && pass + 1 < passCount && BakeClock::now() - lastPreview >= previewInterval) {
+                if (writeAtlas(true) && hooks.onPreview) {
+                    hooks.onPreview();
+                }
+                lastPreview = BakeClock::now();
+            }
+        }
+        ++atlasOrdinal;
+        std::cout << "[StaticLighting] Baked atlas " << atlasOrdinal << "/" << manifest.atlases.size() << std::endl;
+
+        if (!writeAtlas(false)) {
+            continue;
         }
+        storeAtlasHash(atlasIndex, atlasHash);
+        stats.atlasCount += 1;
     }
 
         if (stats.atlasCount > 0) {
-            BakeProbeVolume(scene, scenePath, bakeSettings, bakedLights, emissiveSurfaces);
+            if (gpuBaker) {
+                gpuBaker->setSamplesPerTexel(bakeSettings.staticLighting.samplesPerTexel);
+            }
+            BakeProbeVolume(scene, scenePath, bakeSettings, bakedLights, emissiveSurfaces, gpuBaker.get());
             SceneSettings updatedSettings = scene->getSettings();
             updatedSettings.staticLighting.enabled = true;
             updatedSettings.staticLighting.directionalLightmaps = bakeSettings.staticLighting.bakeDirectLighting;
@@ -10,6 +10,8 @@
 #include "../Components/Decal.hpp"
 #include "../Animation/Skeleton.hpp"
 #include "../Animation/AnimationClip.hpp"
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -27,6 +29,26 @@ public:
         int generatedUVRendererCount = 0;
         int reusedUVRendererCount = 0;
         int skippedRendererCount = 0;
+        float atlasUtilization = 0.0f; // share of the atlases' texels covered by renderer slots
+    };
+
+    // Scene-wide HLOD generation. Level 1 clusters renderers on an XZ grid of cellSize, each further
+    // level clusters the proxies below on a grid twice as coarse.
+    struct HLODClusterSettings {
+        float cellSize = 32.0f;
+        uint32_t levels = 2;
+        uint32_t minSources = 2;   // smaller clusters are left to draw their sources
+        bool staticOnly = true;    // only renderers marked static geometry
+        bool atlasMaterials = true; // fold untextured opaque materials into one palette material
+    };
+
+    struct HLODClusterStats {
+        int sourceRendererCount = 0;
+        int proxyCount = 0;
+        int removedProxyCount = 0;   // generated proxies replaced by this build
+        int atlasedMaterialCount = 0;
+        uint64_t sourceTriangles = 0; // of the renderers clustered into level 1
+        uint64_t proxyTriangles = 0;  // over all levels
     };
 
     struct StaticLightmapBakeStats {
@@ -39,6 +61,28 @@ public:
         int layoutSkippedRendererCount = 0;
         int generatedUVRendererCount = 0;
         int reusedUVRendererCount = 0;
+        int skippedAtlasCount = 0; // kept from the last bake because their inputs did not change
+        bool cancelled = false;
+    };
+
+    // Lets an editor stay interactive while it bakes on the engine thread. Both run on the baking
+    // thread: onFrame about once per progressiveFrameBudgetMs of tracing, onPreview after partial
+    // atlases of a progressive bake were written to their renderers' lightmap paths.
+    struct StaticLightmapBakeHooks {
+        std::function<void()> onFrame;
+        std::function<void()> onPreview;
+    };
+
+    struct StaticLightmapBakeProgress {
+        bool active = false;
+        float progress = 0.0f; // 0..1 across the scene's atlases
+    };
+
+    struct ModelImportProgress {
+        uint64_t id = 0;
+        std::string path;
+        std::string stage;
+        float progress = 0.0f; // 0..1 across reading, mesh processing and instancing
     };
 
     // Create primitive objects
@@ -64,6 +108,12 @@ public:
 
     // Import a model file (static meshes + materials)
     static Entity* importModel(Scene* scene, const std::string& path, const ModelImportOptions& options = ModelImportOptions(), const std::string& name = "");
+    // Reads the model and processes its meshes on a background thread; processModelImports
+    // creates the entities once that is done. Returns the import id, or 0 if nothing was queued.
+    static uint64_t importModelAsync(const std::string& path, const ModelImportOptions& options = ModelImportOptions(), const std::string& name = "");
+    // Call on the engine thread; instantiates finished imports into the scene and returns how many.
+    static size_t processModelImports(Scene* scene);
+    static std::vector<ModelImportProgress> getModelImportProgress();
     static std::vector<std::shared_ptr<AnimationClip>> importAnimationClipsForSkeleton(
         const std::string& path,
         const Skeleton& skeleton,
@@ -88,13 +138,25 @@ public:
 
     // HLOD (automatic bake)
     static Entity* buildHLOD(Scene* scene, const std::vector<std::string>& uuids, float lodStart = -1.0f, float lodEnd = -1.0f);
+    // Replaces every generated proxy (HLODProxy level > 0) with a fresh hierarchy built from the
+    // scene's renderers; clusters merge in parallel. Renderers already behind a hand-built proxy,
+    // skinned, instanced and non-static physics bodies are left out.
+    static HLODClusterStats buildHLODClusters(Scene* scene, const HLODClusterSettings& settings,
+                                              const std::string& scenePath = "");
 
     // Prepares static meshes for UV lightmap baking: validates/generates UV1, estimates resolution,
     // assigns atlases, and writes per-renderer lightmap index + scale/offset metadata.
     static StaticLightingLayoutStats buildStaticLightingLayout(Scene* scene, const std::string& scenePath = "");
 
-    // Bakes direct static lighting into atlas textures using UV1/lightmap layout.
-    static StaticLightmapBakeStats bakeStaticLightmaps(Scene* scene, const std::string& scenePath = "");
+    // Bakes direct static lighting into atlas textures using UV1/lightmap layout. Texels are baked
+    // in tiles across the shared job scheduler; the result is the same for any worker count.
+    // Atlases whose input hash matches the last bake and whose files still exist are kept as is.
+    static StaticLightmapBakeStats bakeStaticLightmaps(Scene* scene, const std::string& scenePath = "",
+                                                       const StaticLightmapBakeHooks& hooks = {});
+    // Both are safe to call from any thread while a bake runs. A cancelled bake stops at its next
+    // tile, keeps the atlases it already finished and saves no manifest or probe volume.
+    static StaticLightmapBakeProgress getStaticLightmapBakeProgress();
+    static void cancelStaticLightmapBake();
 };
 
 } // namespace Crescent
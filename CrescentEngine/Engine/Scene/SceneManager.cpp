@@ -1,25 +1,58 @@
 #include "SceneManager.hpp"
 #include "SceneSerializer.hpp"
+#include "../Components/Animator.hpp"
 #include "../Components/Camera.hpp"
 #include "../Components/CameraController.hpp"
 #include "../Components/Light.hpp"
+#include "../Core/Engine.hpp"
+#include "../Core/JobScheduler.hpp"
 #include "../Core/SelectionSystem.hpp"
 #include "../Core/Time.hpp"
+#include "../Input/InputManager.hpp"
 #include "../Physics/PhysicsWorld.hpp"
+#include "../Renderer/Renderer.hpp"
 #include "../ECS/Transform.hpp"
 #include "../Math/Math.hpp"
 #include "SceneCommands.hpp"
 #include <algorithm>
 #include <cstdlib>
+#include <filesystem>
 #include <iostream>
 
 namespace Crescent {
 
+// The preload moves through its stages one updatePreload at a time. Reading and Bodies run on a
+// background job the fence tracks; the scene is not touched on the main thread meanwhile.
+struct SceneManager::Preload {
+    enum class Stage {
+        Reading,
+        Building,
+        Bodies,
+        Resources,
+        Ready,
+        Failed
+    };
+    // What the read job hands back.
+    struct Read {
+        std::string path;
+        std::shared_ptr<SceneCellPayload> payload;
+        size_t memoryBytes = 0;
+    };
+
+    std::string path;
+    Scene* scene = nullptr;
+    Stage stage = Stage::Reading;
+    std::shared_ptr<Read> read;
+    std::shared_ptr<JobFence> fence = std::make_shared<JobFence>();
+};
+
 SceneManager& SceneManager::getInstance() {
     static SceneManager instance;
     return instance;
 }
 
+SceneManager::~SceneManager() = default;
+
 Scene* SceneManager::createScene(const std::string& name) {
     auto scene = std::make_unique<Scene>(name);
     Scene* scenePtr = scene.get();
@@ -36,6 +69,10 @@ Scene* SceneManager::createScene(const std::string& name) {
 
 void SceneManager::destroyScene(Scene* scene) {
     if (!scene) return;
+    if (m_Preload && m_Preload->scene == scene) {
+        cancelPreload();
+        return;
+    }
     
     // If this is the active scene, deactivate it
     if (m_ActiveScene == scene) {
@@ -54,6 +91,7 @@ void SceneManager::destroyScene(Scene* scene) {
 }
 
 void SceneManager::destroyAllScenes() {
+    cancelPreload();
     m_ActiveScene = nullptr;
     m_EditorScene = nullptr;
     m_RuntimeScene = nullptr;
@@ -84,6 +122,138 @@ void SceneManager::setActiveScene(Scene* scene) {
     Light::setMainLight(findFirstMainLight(m_ActiveScene));
 }
 
+bool SceneManager::preloadScene(const std::string& path) {
+    cancelPreload();
+    if (path.empty()) {
+        return false;
+    }
+    // A background save of this path may still be writing it.
+    SceneSerializer::WaitForPendingSaves();
+
+    // Added directly rather than through createScene, which would activate a first scene.
+    auto scene = std::make_unique<Scene>(std::filesystem::path(path).stem().string());
+    scene->setActive(false);
+    m_Preload = std::make_unique<Preload>();
+    m_Preload->path = path;
+    m_Preload->scene = scene.get();
+    m_Scenes.push_back(std::move(scene));
+
+    auto read = std::make_shared<Preload::Read>();
+    read->path = path;
+    m_Preload->read = read;
+    m_Preload->fence->remaining.fetch_add(1, std::memory_order_relaxed);
+    JobScheduler::getInstance().schedule(JobFunction([read]() {
+        read->payload = SceneSerializer::ReadScene(read->path, &read->memoryBytes);
+    }), m_Preload->fence, JobPriority::Background);
+    return true;
+}
+
+void SceneManager::updatePreload() {
+    if (!m_Preload || !m_Preload->fence->isComplete()) {
+        return;
+    }
+    Preload& preload = *m_Preload;
+    Scene* scene = preload.scene;
+    switch (preload.stage) {
+        case Preload::Stage::Reading: {
+            const Preload::Read& read = *preload.read;
+            const size_t budget = m_PreloadSettings.memoryBudgetBytes;
+            if (!read.payload) {
+                std::cerr << "SceneManager: failed to preload " << preload.path << std::endl;
+                preload.stage = Preload::Stage::Failed;
+            } else if (budget > 0 && read.memoryBytes > budget) {
+                std::cerr << "SceneManager: preloading " << preload.path << " needs "
+                          << (read.memoryBytes >> 20) << " MB, over the " << (budget >> 20)
+                          << " MB budget" << std::endl;
+                preload.stage = Preload::Stage::Failed;
+            } else {
+                preload.stage = Preload::Stage::Building;
+            }
+            if (preload.stage == Preload::Stage::Failed) {
+                preload.read.reset();
+                auto it = std::find_if(m_Scenes.begin(), m_Scenes.end(),
+                    [scene](const std::unique_ptr<Scene>& s) { return s.get() == scene; });
+                if (it != m_Scenes.end()) {
+                    m_Scenes.erase(it);
+                }
+                preload.scene = nullptr;
+            }
+            break;
+        }
+        case Preload::Stage::Building:
+            if (SceneSerializer::ActivateScenePayload(scene, *preload.read->payload,
+                                                      m_PreloadSettings.activationBudgetMs)) {
+                preload.read.reset();
+                preload.stage = Preload::Stage::Bodies;
+                // The scene's world is its own and nothing else touches the scene until the
+                // fence completes, so its bodies are built beside the running simulation.
+                if (PhysicsWorld* physics = scene->getPhysicsWorld()) {
+                    preload.fence->remaining.fetch_add(1, std::memory_order_relaxed);
+                    JobScheduler::getInstance().schedule(JobFunction([physics]() {
+                        physics->createPendingBodies();
+                    }), preload.fence, JobPriority::Background);
+                }
+            }
+            break;
+        case Preload::Stage::Bodies:
+            // Waits for the frame in flight; the renderer's pipeline and mesh queues are its own.
+            if (Renderer* renderer = Engine::getInstance().getRenderer()) {
+                renderer->prepareSceneResources(scene);
+            }
+            preload.stage = Preload::Stage::Resources;
+            break;
+        case Preload::Stage::Resources:
+            if (Renderer* renderer = Engine::getInstance().getRenderer();
+                !renderer || renderer->getPendingMeshUploads() == 0) {
+                preload.stage = Preload::Stage::Ready;
+            }
+            break;
+        case Preload::Stage::Ready:
+        case Preload::Stage::Failed:
+            break;
+    }
+}
+
+SceneManager::PreloadState SceneManager::getPreloadState() const {
+    if (!m_Preload) {
+        return PreloadState::None;
+    }
+    switch (m_Preload->stage) {
+        case Preload::Stage::Ready: return PreloadState::Ready;
+        case Preload::Stage::Failed: return PreloadState::Failed;
+        default: return PreloadState::Loading;
+    }
+}
+
+Scene* SceneManager::activatePreloadedScene() {
+    if (getPreloadState() != PreloadState::Ready) {
+        return nullptr;
+    }
+    Scene* scene = m_Preload->scene;
+    m_Preload.reset();
+    Scene* previous = m_ActiveScene;
+    setActiveScene(scene);
+    if (previous == m_RuntimeScene) {
+        m_RuntimeScene = scene;
+    }
+    if (previous && previous != m_EditorScene) {
+        destroyScene(previous);
+    }
+    return scene;
+}
+
+void SceneManager::cancelPreload() {
+    if (!m_Preload) {
+        return;
+    }
+    JobScheduler::getInstance().wait(*m_Preload->fence);
+    Scene* scene = m_Preload->scene;
+    m_Preload.reset();
+    if (scene) {
+        destroyScene(scene);
+    }
+}
+
 Scene* SceneManager::getSceneByName(const std::string& name) const {
     for (const auto& scene : m_Scenes) {
         if (scene->getName() == name) {
@@ -150,20 +320,105 @@ void SceneManager::updateFixedPhysics(float fixedStep, int steps) {
     }
 }
 
-void SceneManager::updateFixedComponents(float fixedStep, int steps) {
+void SceneManager::interpolatePhysics(float alpha) {
+    if (!m_ActiveScene || !m_IsPlaying) {
+        return;
+    }
+    if (auto* physics = m_ActiveScene->getPhysicsWorld()) {
+        physics->interpolateBodies(alpha);
+    }
+}
+
+void SceneManager::updateCharacters() {
+    if (!m_ActiveScene || !m_IsPlaying) {
+        return;
+    }
+    if (auto* physics = m_ActiveScene->getPhysicsWorld()) {
+        physics->updateCharacters();
+    }
+}
+
+void SceneManager::updateFixedComponents(float fixedStep, int steps, JobSystem* parallelJobs) {
     if (!m_ActiveScene || !m_IsPlaying || steps <= 0) {
         return;
     }
     for (int i = 0; i < steps; ++i) {
-        m_ActiveScene->OnFixedUpdate(fixedStep);
+        InputManager::setFixedStep(i);
+        m_ActiveScene->OnFixedUpdate(fixedStep, parallelJobs != nullptr);
+        // Every step finishes its parallel components before the next step's serial pass, so
+        // serial components observe them one step at a time, as they would without the split.
+        if (parallelJobs) {
+            updateParallelFixedComponents(fixedStep, *parallelJobs);
+        }
+    }
+    InputManager::setFixedStep(-1);
+}
+
+void SceneManager::updateParallelFixedComponents(float fixedStep, JobSystem& jobs) {
+    // Collected per step: the serial pass may have enabled or disabled some of them.
+    m_ActiveScene->collectParallelComponents(m_DeferredFixed, kComponentHookFixedUpdate);
+    const size_t count = m_DeferredFixed.size();
+    if (count == 0) {
+        return;
+    }
+    if (!m_FixedParallelHandle.valid()) {
+        m_FixedParallelHandle = jobs.createHandle();
+    }
+    const size_t maxChunks = jobs.workerCount() + 1;
+    const size_t chunkSize = std::max(kParallelFixedGrain, (count + maxChunks - 1) / maxChunks);
+    for (size_t begin = chunkSize; begin < count; begin += chunkSize) {
+        const size_t end = std::min(count, begin + chunkSize);
+        jobs.submit([this, fixedStep, begin, end]() {
+            for (size_t i = begin; i < end; ++i) {
+                m_DeferredFixed[i]->OnFixedUpdate(fixedStep);
+            }
+        }, m_FixedParallelHandle);
     }
+    for (size_t i = 0; i < std::min(count, chunkSize); ++i) {
+        m_DeferredFixed[i]->OnFixedUpdate(fixedStep);
+    }
+    jobs.wait(m_FixedParallelHandle);
 }
 
-void SceneManager::updateVariable(float deltaTime) {
+void SceneManager::updateVariable(float deltaTime, bool deferParallel) {
+    m_DeferredVariable.clear();
+    m_DeferredAnimation.clear();
     if (!m_ActiveScene || !m_IsPlaying) {
         return;
     }
-    m_ActiveScene->OnUpdate(deltaTime);
+    m_ActiveScene->OnUpdate(deltaTime, deferParallel);
+    if (deferParallel) {
+        m_ActiveScene->collectParallelComponents(m_DeferredVariable, kComponentHookUpdate);
+        m_ActiveScene->collectAnimationComponents(m_DeferredAnimation);
+        m_DeferredDeltaTime = deltaTime;
+    }
+}
+
+void SceneManager::updateDeferredVariable(size_t begin, size_t end) {
+    end = std::min(end, m_DeferredVariable.size());
+    for (size_t i = begin; i < end; ++i) {
+        m_DeferredVariable[i]->OnUpdate(m_DeferredDeltaTime);
+    }
+}
+
+void SceneManager::updateDeferredAnimation(size_t begin, size_t end) {
+    end = std::min(end, m_DeferredAnimation.size());
+    for (size_t i = begin; i < end; ++i) {
+        m_DeferredAnimation[i]->OnAnimationEvaluate(m_DeferredDeltaTime);
+    }
+}
+
+void SceneManager::finalizeDeferredAnimation() {
+    for (Component* component : m_DeferredAnimation) {
+        component->OnAnimationFinalize();
+    }
+    Animator::SolvePendingIK();
+}
+
+void SceneManager::playbackStructuralChanges() {
+    if (m_ActiveScene) {
+        m_ActiveScene->playbackCommands();
+    }
 }
 
 float SceneManager::getFixedTimeStep() const {
@@ -213,8 +468,12 @@ void SceneManager::update(float deltaTime) {
         updateFixedPhysics(fixedStep, 0);
         updateFixedComponents(fixedStep, 0);
     }
+    playbackStructuralChanges();
+    interpolatePhysics(m_FixedAccumulator / fixedStep);
+    updateCharacters();
 
     updateVariable(Time::deltaTime());
+    playbackStructuralChanges();
 }
 
 void SceneManager::enterPlayMode() {
@@ -245,7 +504,8 @@ void SceneManager::enterPlayMode() {
         if (preserveCookedRuntimePayloads) {
             std::vector<uint8_t> snapshot = SceneSerializer::SerializeCookedRuntimeSceneBinary(m_EditorScene, false);
             SceneSerializer::DeserializeSceneBinary(runtimeScene, snapshot);
-        } else {
+        } else if (!runtimeScene->cloneFrom(*m_EditorScene)) {
+            // A component without clone() support; the serializer still knows every type.
             std::string snapshot = SceneSerializer::SerializeScene(m_EditorScene, false);
             SceneSerializer::DeserializeScene(runtimeScene, snapshot);
         }
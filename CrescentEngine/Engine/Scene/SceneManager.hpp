@@ -1,8 +1,10 @@
 #pragma once
 
 #include "Scene.hpp"
+#include "../Core/JobSystem.hpp"
 #include "../Core/UUID.hpp"
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace Crescent {
@@ -16,6 +18,24 @@ public:
         Scene = 0,
         Game = 1
     };
+
+    // Level transitions without a loading screen: preloadScene reads the next scene on a worker
+    // and builds it into an inactive scene of its own (entities a slice per frame, physics bodies
+    // in its own world, pipelines and meshes ahead of its first draw) while the active scene keeps
+    // running; activatePreloadedScene then swaps it in within one frame.
+    struct PreloadSettings {
+        // What a preload may hold on top of the active scene, its file plus the GPU footprint it
+        // was cooked with; a larger scene is refused. 0 disables the limit.
+        size_t memoryBudgetBytes = 512ull * 1024 * 1024;
+        // Main thread time per frame spent creating the preloaded scene's entities.
+        double activationBudgetMs = 2.0;
+    };
+    enum class PreloadState {
+        None,
+        Loading,
+        Ready,
+        Failed
+    };
     
     // Scene management
     Scene* createScene(const std::string& name = "New Scene");
@@ -25,6 +45,18 @@ public:
     // Active scene
     Scene* getActiveScene() const { return m_ActiveScene; }
     void setActiveScene(Scene* scene);
+
+    // Scene preloading. A new preload replaces the one in progress. activatePreloadedScene makes
+    // a ready preload the active scene and destroys the one it replaces (the editor's scene during
+    // play mode excepted); it returns null while the preload is not ready.
+    const PreloadSettings& getPreloadSettings() const { return m_PreloadSettings; }
+    void setPreloadSettings(const PreloadSettings& settings) { m_PreloadSettings = settings; }
+    bool preloadScene(const std::string& path);
+    void updatePreload();
+    PreloadState getPreloadState() const;
+    bool isPreloadReady() const { return getPreloadState() == PreloadState::Ready; }
+    Scene* activatePreloadedScene();
+    void cancelPreload();
     
     // Scene access
     Scene* getSceneByName(const std::string& name) const;
@@ -45,8 +77,29 @@ public:
     void updateEditor(float deltaTime);
     void updateFixed(float fixedStep, int steps);
     void updateFixedPhysics(float fixedStep, int steps);
-    void updateFixedComponents(float fixedStep, int steps);
-    void updateVariable(float deltaTime);
+    // With parallelJobs, each step runs the serial components and then fans the components that
+    // opted into parallel update out across the jobs, waiting for them before the next step.
+    void updateFixedComponents(float fixedStep, int steps, JobSystem* parallelJobs = nullptr);
+    // Blends dynamic bodies between their last two physics steps; alpha is the step fraction the
+    // fixed-step clock carries over.
+    void interpolatePhysics(float alpha);
+    // Carries out the character moves queued by last frame's update, before this frame's.
+    void updateCharacters();
+    void updateVariable(float deltaTime, bool deferParallel = false);
+
+    // Deferred parallel phase. With deferParallel, updateVariable skips components that opted
+    // into parallel update and collects them instead; updateDeferredVariable then runs slices of
+    // that list, so the frame graph can fan them out across workers.
+    size_t getDeferredVariableCount() const { return m_DeferredVariable.size(); }
+    void updateDeferredVariable(size_t begin, size_t end);
+    // Animation phase: pose evaluation of every animated component as independent slices, then
+    // root motion, IK and events applied serially.
+    size_t getDeferredAnimationCount() const { return m_DeferredAnimation.size(); }
+    void updateDeferredAnimation(size_t begin, size_t end);
+    void finalizeDeferredAnimation();
+    // Sync point: applies the structural changes the active scene's parallel components recorded
+    // (see EntityCommandBuffer).
+    void playbackStructuralChanges();
     float getFixedTimeStep() const;
 
     // Play mode
@@ -63,7 +116,7 @@ public:
     
 private:
     SceneManager() = default;
-    ~SceneManager() = default;
+    ~SceneManager();
     
     SceneManager(const SceneManager&) = delete;
     SceneManager& operator=(const SceneManager&) = delete;
@@ -73,6 +126,12 @@ private:
     class Light* findFirstMainLight(Scene* scene) const;
     void applySelectionForScene(Scene* scene, const std::vector<UUID>& selection);
     void ensureEditorCamera(Scene* scene);
+    void updateParallelFixedComponents(float fixedStep, JobSystem& jobs);
+
+    // Smallest slice of parallel fixed-update components handed to one job.
+    static constexpr size_t kParallelFixedGrain = 32;
+
+    struct Preload;
 
     std::vector<std::unique_ptr<Scene>> m_Scenes;
     Scene* m_ActiveScene = nullptr;
@@ -84,6 +143,13 @@ private:
     float m_FixedAccumulator = 0.0f;
     ViewMode m_ViewMode = ViewMode::Scene;
     std::vector<UUID> m_EditorSelection;
+    std::vector<Component*> m_DeferredFixed;
+    std::vector<Component*> m_DeferredVariable;
+    std::vector<Component*> m_DeferredAnimation;
+    JobSystem::JobHandle m_FixedParallelHandle;
+    float m_DeferredDeltaTime = 0.0f;
+    PreloadSettings m_PreloadSettings;
+    std::unique_ptr<Preload> m_Preload;
 };
 
 } // namespace Crescent
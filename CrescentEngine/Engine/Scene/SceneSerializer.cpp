@@ -1,7 +1,11 @@
 #include "SceneSerializer.hpp"
 #include "SceneCommands.hpp"
+#include "SceneStreamer.hpp"
 #include "../Assets/AssetDatabase.hpp"
 #include "../Core/Engine.hpp"
+#include "../Core/JobScheduler.hpp"
+#include "../Core/StartupLog.hpp"
+#include "../Core/StartupTrace.hpp"
 #include "../Project/Project.hpp"
 #include "../Renderer/Renderer.hpp"
 #include "../Rendering/Texture.hpp"
@@ -19,12 +23,16 @@
 #include "../Components/Health.hpp"
 #include "../Components/AudioSource.hpp"
 #include "../Input/InputManager.hpp"
+#include "../Physics/PhysicsWorld.hpp"
+#include "../Navigation/NavigationSystem.hpp"
 #include "../Animation/AnimationClip.hpp"
+#include "../Animation/AnimationCompression.hpp"
 #include "../Components/ModelMeshReference.hpp"
 #include "../Components/HLODProxy.hpp"
 #include "../Components/PrimitiveMesh.hpp"
 #include "../Components/Light.hpp"
 #include "../Components/Decal.hpp"
+#include "../Components/ParticleEmitter.hpp"
 #include "../Components/Camera.hpp"
 #include "../Components/CameraController.hpp"
 #include "SceneSettings.hpp"
@@ -34,22 +42,34 @@
 #include "../ECS/Transform.hpp"
 #include "../../../ThirdParty/nlohmann/json.hpp"
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cctype>
+#include <cmath>
 #include <cstring>
 #include <cstdlib>
 #include <ctime>
 #include <fstream>
+#include <functional>
 #include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 #include <unordered_set>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #if __has_include("../../../ThirdParty/meshoptimizer/src/meshoptimizer.h")
 #define CRESCENT_HAS_MESHOPTIMIZER 1
 #include "../../../ThirdParty/meshoptimizer/src/meshoptimizer.h"
 #include "../../../ThirdParty/meshoptimizer/src/allocator.cpp"
+#include "../../../ThirdParty/meshoptimizer/src/clusterizer.cpp"
 #include "../../../ThirdParty/meshoptimizer/src/indexcodec.cpp"
 #include "../../../ThirdParty/meshoptimizer/src/indexgenerator.cpp"
 #include "../../../ThirdParty/meshoptimizer/src/overdrawoptimizer.cpp"
@@ -306,6 +326,7 @@ std::string ColliderShapeToString(PhysicsCollider::ShapeType type) {
     case PhysicsCollider::ShapeType::Sphere: return "Sphere";
     case PhysicsCollider::ShapeType::Capsule: return "Capsule";
     case PhysicsCollider::ShapeType::Mesh: return "Mesh";
+    case PhysicsCollider::ShapeType::Terrain: return "Terrain";
     case PhysicsCollider::ShapeType::Box:
     default:
         return "Box";
@@ -327,6 +348,7 @@ PhysicsCollider::ShapeType ColliderShapeFromString(const std::string& value) {
     if (value == "Sphere") return PhysicsCollider::ShapeType::Sphere;
     if (value == "Capsule") return PhysicsCollider::ShapeType::Capsule;
     if (value == "Mesh") return PhysicsCollider::ShapeType::Mesh;
+    if (value == "Terrain") return PhysicsCollider::ShapeType::Terrain;
     return PhysicsCollider::ShapeType::Box;
 }
 
@@ -418,6 +440,9 @@ struct BuildSceneOptions {
     bool includeEditorOnly = true;
     bool embedRuntimePayloads = false;
     bool externalizeRuntimeMeshes = false;
+    // Writes runtime bank clips through CompressAnimationClip; binary outputs only, since the
+    // clips travel as msgpack binaries.
+    bool compressAnimationClips = false;
     std::string cookedScenePath;
     struct CookedMeshWriter* cookedMeshWriter = nullptr;
 };
@@ -425,6 +450,7 @@ struct BuildSceneOptions {
 using RuntimeSkinnedBankMap = std::unordered_map<std::string, json>;
 
 json BuildSceneJson(Scene* scene, const std::string& scenePath, const BuildSceneOptions& options);
+void PrepareTexturePlacement(const json& metadata, TextureLoader* loader);
 json SerializeMeshData(const Mesh& mesh);
 std::shared_ptr<Mesh> DeserializeMeshData(const json& j);
 
@@ -613,7 +639,7 @@ std::string BuildCookedEnvironmentRelativePath(const std::string& path) {
     if (path.empty() || path == "Builtin Sky") {
         return "";
     }
-    return "Library/ImportCache/hdri_" + HashRuntimeCookKey(NormalizeCookedEnvironmentKey(path)) + "_v2.cenv";
+    return "Library/ImportCache/hdri_" + HashRuntimeCookKey(NormalizeCookedEnvironmentKey(path)) + "_v3.cenv";
 }
 
 struct CookedMeshWriter {
@@ -649,6 +675,10 @@ public:
         writeBytes(value.data(), value.size());
     }
 
+    void alignTo(size_t alignment) {
+        m_bytes.resize((m_bytes.size() + alignment - 1) / alignment * alignment, 0);
+    }
+
     const std::vector<uint8_t>& bytes() const {
         return m_bytes;
     }
@@ -657,40 +687,25 @@ private:
     std::vector<uint8_t> m_bytes;
 };
 
-std::vector<uint8_t> SerializeCookedMeshBinary(const Mesh& mesh) {
+// Sections of a version 7 cooked mesh start at multiples of this, so a mapped file can be read
+// in place.
+constexpr size_t kCookedMeshSectionAlignment = 16;
+
+enum class CookedMeshEncoding {
+    Compressed, // meshopt-encoded streams, smallest on disk (version 6)
+    GpuLayout   // streams as the geometry arenas hold them, mapped and copied without decoding (version 7)
+};
+
+std::vector<uint8_t> SerializeCookedMeshBinary(const Mesh& mesh,
+                                               CookedMeshEncoding encoding = CookedMeshEncoding::Compressed) {
 #if CRESCENT_HAS_MESHOPTIMIZER
     struct OptimizedCookedMeshData {
         std::vector<Vertex> vertices;
         std::vector<uint32_t> indices;
         std::vector<Submesh> submeshes;
         std::vector<SkinWeight> skinWeights;
-    };
-
-    struct QuantizedVertex {
-        uint16_t position[3];
-        int16_t normal[3];
-        uint16_t texCoord[2];
-        uint16_t texCoord1[2];
-        int16_t tangent[3];
-        int16_t bitangent[3];
-        uint8_t color[4];
-    };
-
-    auto quantizePosition = [](float value, float minValue, float maxValue) -> uint16_t {
-        float extent = maxValue - minValue;
-        if (extent <= 1e-8f) {
-            return 0;
-        }
-        float normalized = (value - minValue) / extent;
-        return static_cast<uint16_t>(meshopt_quantizeUnorm(normalized, 16));
-    };
-
-    auto quantizeSnorm16 = [](float value) -> int16_t {
-        return static_cast<int16_t>(meshopt_quantizeSnorm(value, 16));
-    };
-
-    auto quantizeColor8 = [](float value) -> uint8_t {
-        return static_cast<uint8_t>(meshopt_quantizeUnorm(value, 8));
+        std::vector<MeshLod> lods;
+        std::vector<uint32_t> lodIndices;
     };
 
     auto optimizeRange = [](std::vector<uint32_t>& indices,
@@ -723,7 +738,9 @@ std::vector<uint8_t> SerializeCookedMeshBinary(const Mesh& mesh) {
             mesh.getVertices(),
             mesh.getIndices(),
             mesh.getSubmeshes(),
-            mesh.getSkinWeights()
+            mesh.getSkinWeights(),
+            mesh.getLods(),
+            mesh.getLodIndices()
         };
 
         if (result.vertices.empty()) {
@@ -762,6 +779,15 @@ std::vector<uint8_t> SerializeCookedMeshBinary(const Mesh& mesh) {
 
                 result.vertices = std::move(dedupedVertices);
                 result.indices = std::move(dedupedIndices);
+                // LOD indices only reference vertices the base indices use, so the remap covers them.
+                if (!result.lodIndices.empty()) {
+                    std::vector<uint32_t> dedupedLodIndices(result.lodIndices.size());
+                    meshopt_remapIndexBuffer(dedupedLodIndices.data(),
+                                             result.lodIndices.data(),
+                                             result.lodIndices.size(),
+                                             dedupeRemap.data());
+                    result.lodIndices = std::move(dedupedLodIndices);
+                }
 
                 if (!result.skinWeights.empty()) {
                     std::vector<SkinWeight> dedupedWeights(uniqueVertexCount);
@@ -795,6 +821,14 @@ std::vector<uint8_t> SerializeCookedMeshBinary(const Mesh& mesh) {
 
                 result.vertices = std::move(compactVertices);
                 result.indices = std::move(compactIndices);
+                if (!result.lodIndices.empty()) {
+                    std::vector<uint32_t> compactLodIndices(result.lodIndices.size());
+                    meshopt_remapIndexBuffer(compactLodIndices.data(),
+                                             result.lodIndices.data(),
+                                             result.lodIndices.size(),
+                                             fetchRemap.data());
+                    result.lodIndices = std::move(compactLodIndices);
+                }
 
                 if (!result.skinWeights.empty()) {
                     std::vector<SkinWeight> compactWeights(compactVertexCount);
@@ -806,6 +840,22 @@ std::vector<uint8_t> SerializeCookedMeshBinary(const Mesh& mesh) {
                     result.skinWeights = std::move(compactWeights);
                 }
             }
+
+            // LOD ranges are stored relative to the combined list; optimize each level in place.
+            const size_t baseCount = result.indices.size();
+            for (const MeshLod& lod : result.lods) {
+                const size_t start = static_cast<size_t>(lod.indexStart) - baseCount;
+                if (lod.indexStart < baseCount || lod.indexCount < 3 || start + lod.indexCount > result.lodIndices.size()) {
+                    continue;
+                }
+                std::vector<uint32_t> cacheOptimized(lod.indexCount);
+                meshopt_optimizeVertexCache(cacheOptimized.data(),
+                                            result.lodIndices.data() + start,
+                                            lod.indexCount,
+                                            result.vertices.size());
+                std::copy(cacheOptimized.begin(), cacheOptimized.end(),
+                          result.lodIndices.begin() + static_cast<std::ptrdiff_t>(start));
+            }
         }
 
         return result;
@@ -831,44 +881,150 @@ std::vector<uint8_t> SerializeCookedMeshBinary(const Mesh& mesh) {
         return true;
     };
 
+    // Version 4 stores the GPU streams as uploaded (float3 positions + PackedVertexAttributes), so
+    // loading hands them to the geometry buffer without re-packing. Version 5 appends meshlets,
+    // version 6 the LOD table and the encoded LOD index lists.
     OptimizedCookedMeshData optimized = buildOptimizedMesh();
-    std::vector<QuantizedVertex> quantizedVertices;
-    quantizedVertices.reserve(optimized.vertices.size());
-    const Math::Vector3 boundsMin = mesh.getBoundsMin();
-    const Math::Vector3 boundsMax = mesh.getBoundsMax();
+    std::vector<float> positions;
+    std::vector<PackedVertexAttributes> packedAttributes;
+    positions.reserve(optimized.vertices.size() * 3);
+    packedAttributes.reserve(optimized.vertices.size());
     for (const Vertex& vertex : optimized.vertices) {
-        QuantizedVertex q{};
-        q.position[0] = quantizePosition(vertex.position.x, boundsMin.x, boundsMax.x);
-        q.position[1] = quantizePosition(vertex.position.y, boundsMin.y, boundsMax.y);
-        q.position[2] = quantizePosition(vertex.position.z, boundsMin.z, boundsMax.z);
-        q.normal[0] = quantizeSnorm16(vertex.normal.x);
-        q.normal[1] = quantizeSnorm16(vertex.normal.y);
-        q.normal[2] = quantizeSnorm16(vertex.normal.z);
-        q.texCoord[0] = meshopt_quantizeHalf(vertex.texCoord.x);
-        q.texCoord[1] = meshopt_quantizeHalf(vertex.texCoord.y);
-        q.texCoord1[0] = meshopt_quantizeHalf(vertex.texCoord1.x);
-        q.texCoord1[1] = meshopt_quantizeHalf(vertex.texCoord1.y);
-        q.tangent[0] = quantizeSnorm16(vertex.tangent.x);
-        q.tangent[1] = quantizeSnorm16(vertex.tangent.y);
-        q.tangent[2] = quantizeSnorm16(vertex.tangent.z);
-        q.bitangent[0] = quantizeSnorm16(vertex.bitangent.x);
-        q.bitangent[1] = quantizeSnorm16(vertex.bitangent.y);
-        q.bitangent[2] = quantizeSnorm16(vertex.bitangent.z);
-        q.color[0] = quantizeColor8(vertex.color.x);
-        q.color[1] = quantizeColor8(vertex.color.y);
-        q.color[2] = quantizeColor8(vertex.color.z);
-        q.color[3] = quantizeColor8(vertex.color.w);
-        quantizedVertices.push_back(q);
+        positions.push_back(vertex.position.x);
+        positions.push_back(vertex.position.y);
+        positions.push_back(vertex.position.z);
+        packedAttributes.push_back(PackedVertexAttributes::Pack(vertex));
+    }
+
+    // Clusters for the mesh shader path, built per submesh so no meshlet mixes materials.
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t> meshletTriangles;
+    auto buildMeshlets = [&](uint32_t submeshIndex, size_t start, size_t count) {
+        if (count < 3 || start + count > optimized.indices.size()) {
+            return;
+        }
+        const size_t maxMeshlets = meshopt_buildMeshletsBound(count, Meshlet::kMaxVertices, Meshlet::kMaxTriangles);
+        std::vector<meshopt_Meshlet> built(maxMeshlets);
+        std::vector<unsigned int> builtVertices(maxMeshlets * Meshlet::kMaxVertices);
+        std::vector<unsigned char> builtTriangles(maxMeshlets * Meshlet::kMaxTriangles * 3);
+        const size_t builtCount = meshopt_buildMeshlets(built.data(),
+                                                        builtVertices.data(),
+                                                        builtTriangles.data(),
+                                                        optimized.indices.data() + start,
+                                                        count,
+                                                        positions.data(),
+                                                        optimized.vertices.size(),
+                                                        sizeof(float) * 3,
+                                                        Meshlet::kMaxVertices,
+                                                        Meshlet::kMaxTriangles,
+                                                        0.25f);
+        const uint32_t vertexBase = static_cast<uint32_t>(meshletVertices.size());
+        const uint32_t triangleBase = static_cast<uint32_t>(meshletTriangles.size());
+        uint32_t vertexEnd = 0;
+        uint32_t triangleEnd = 0;
+        for (size_t i = 0; i < builtCount; ++i) {
+            const meshopt_Meshlet& source = built[i];
+            meshopt_optimizeMeshlet(&builtVertices[source.vertex_offset],
+                                    &builtTriangles[source.triangle_offset],
+                                    source.triangle_count,
+                                    source.vertex_count);
+            const meshopt_Bounds bounds = meshopt_computeMeshletBounds(&builtVertices[source.vertex_offset],
+                                                                       &builtTriangles[source.triangle_offset],
+                                                                       source.triangle_count,
+                                                                       positions.data(),
+                                                                       optimized.vertices.size(),
+                                                                       sizeof(float) * 3);
+            Meshlet meshlet{};
+            meshlet.vertexOffset = vertexBase + source.vertex_offset;
+            meshlet.triangleOffset = triangleBase + source.triangle_offset;
+            meshlet.vertexCount = source.vertex_count;
+            meshlet.triangleCount = source.triangle_count;
+            std::copy(bounds.center, bounds.center + 3, meshlet.center);
+            meshlet.radius = bounds.radius;
+            std::copy(bounds.cone_axis, bounds.cone_axis + 3, meshlet.coneAxis);
+            meshlet.coneCutoff = bounds.cone_cutoff;
+            std::copy(bounds.cone_apex, bounds.cone_apex + 3, meshlet.coneApex);
+            meshlet.submesh = submeshIndex;
+            meshlets.push_back(meshlet);
+            vertexEnd = std::max(vertexEnd, source.vertex_offset + source.vertex_count);
+            triangleEnd = std::max(triangleEnd, source.triangle_offset + ((source.triangle_count * 3 + 3) & ~3u));
+        }
+        meshletVertices.insert(meshletVertices.end(), builtVertices.begin(), builtVertices.begin() + vertexEnd);
+        meshletTriangles.insert(meshletTriangles.end(), builtTriangles.begin(), builtTriangles.begin() + triangleEnd);
+    };
+    // Skinned meshes never take the mesh shader path.
+    if (optimized.skinWeights.empty()) {
+        if (!optimized.submeshes.empty()) {
+            for (size_t i = 0; i < optimized.submeshes.size(); ++i) {
+                buildMeshlets(static_cast<uint32_t>(i), optimized.submeshes[i].indexStart, optimized.submeshes[i].indexCount);
+            }
+        } else {
+            buildMeshlets(0, 0, optimized.indices.size());
+        }
+    }
+
+    if (encoding == CookedMeshEncoding::GpuLayout) {
+        // Same header as version 6 with raw byte sizes. Base and LOD indices share one section so
+        // they upload as one range.
+        CookedMeshBinaryWriter writer;
+        writer.writeBytes("CMSH", 4);
+        writer.writeU32(7);
+        writer.writeU32(static_cast<uint32_t>(optimized.vertices.size()));
+        writer.writeU32(static_cast<uint32_t>(optimized.indices.size()));
+        writer.writeU32(static_cast<uint32_t>(optimized.submeshes.size()));
+        writer.writeU32(static_cast<uint32_t>(optimized.skinWeights.size()));
+        writer.writeU32(static_cast<uint32_t>(mesh.getName().size()));
+        writer.writeU32(static_cast<uint32_t>(positions.size() * sizeof(float)));
+        writer.writeU32(static_cast<uint32_t>(optimized.indices.size() * sizeof(uint32_t)));
+        writer.writeU32(static_cast<uint32_t>(optimized.submeshes.size() * sizeof(Submesh)));
+        writer.writeU32(static_cast<uint32_t>(optimized.skinWeights.size() * sizeof(SkinWeight)));
+        writer.writeU32(mesh.isDoubleSided() ? 1u : 0u);
+        writer.writeF32(mesh.getBoundsMin().x);
+        writer.writeF32(mesh.getBoundsMin().y);
+        writer.writeF32(mesh.getBoundsMin().z);
+        writer.writeF32(mesh.getBoundsMax().x);
+        writer.writeF32(mesh.getBoundsMax().y);
+        writer.writeF32(mesh.getBoundsMax().z);
+        writer.writeU32(static_cast<uint32_t>(packedAttributes.size() * sizeof(PackedVertexAttributes)));
+        writer.writeU32(static_cast<uint32_t>(meshlets.size()));
+        writer.writeU32(static_cast<uint32_t>(meshletVertices.size()));
+        writer.writeU32(static_cast<uint32_t>(meshletTriangles.size()));
+        writer.writeU32(static_cast<uint32_t>(optimized.lods.size()));
+        writer.writeU32(static_cast<uint32_t>(optimized.lodIndices.size()));
+        writer.writeU32(static_cast<uint32_t>(optimized.lodIndices.size() * sizeof(uint32_t)));
+        auto writeSection = [&writer](const void* data, size_t size) {
+            writer.alignTo(kCookedMeshSectionAlignment);
+            writer.writeBytes(data, size);
+        };
+        writeSection(mesh.getName().data(), mesh.getName().size());
+        writeSection(positions.data(), positions.size() * sizeof(float));
+        writeSection(packedAttributes.data(), packedAttributes.size() * sizeof(PackedVertexAttributes));
+        writeSection(optimized.indices.data(), optimized.indices.size() * sizeof(uint32_t));
+        writer.writeBytes(optimized.lodIndices.data(), optimized.lodIndices.size() * sizeof(uint32_t));
+        writeSection(optimized.submeshes.data(), optimized.submeshes.size() * sizeof(Submesh));
+        writeSection(optimized.skinWeights.data(), optimized.skinWeights.size() * sizeof(SkinWeight));
+        writeSection(meshlets.data(), meshlets.size() * sizeof(Meshlet));
+        writeSection(meshletVertices.data(), meshletVertices.size() * sizeof(uint32_t));
+        writeSection(meshletTriangles.data(), meshletTriangles.size());
+        writeSection(optimized.lods.data(), optimized.lods.size() * sizeof(MeshLod));
+        return writer.bytes();
     }
 
     std::vector<uint8_t> encodedVertices;
+    std::vector<uint8_t> encodedAttributes;
     std::vector<uint8_t> encodedIndices;
     std::vector<uint8_t> encodedSkinWeights;
-
-    bool vertexEncoded = encodeVertexLikeBuffer(quantizedVertices.data(),
-                                                quantizedVertices.size(),
-                                                sizeof(QuantizedVertex),
-                                                encodedVertices);
+    std::vector<uint8_t> encodedLodIndices;
+
+    bool vertexEncoded = encodeVertexLikeBuffer(positions.data(),
+                                                optimized.vertices.size(),
+                                                sizeof(float) * 3,
+                                                encodedVertices) &&
+                         encodeVertexLikeBuffer(packedAttributes.data(),
+                                                packedAttributes.size(),
+                                                sizeof(PackedVertexAttributes),
+                                                encodedAttributes);
     bool skinWeightEncoded = encodeVertexLikeBuffer(optimized.skinWeights.data(),
                                                     optimized.skinWeights.size(),
                                                     sizeof(SkinWeight),
@@ -890,10 +1046,27 @@ std::vector<uint8_t> SerializeCookedMeshBinary(const Mesh& mesh) {
         }
     }
 
+    if (indexEncoded && !optimized.lodIndices.empty()) {
+        size_t bound = meshopt_encodeIndexBufferBound(optimized.lodIndices.size(), optimized.vertices.size());
+        encodedLodIndices.resize(bound);
+        size_t encodedSize = meshopt_encodeIndexBuffer(encodedLodIndices.data(),
+                                                       encodedLodIndices.size(),
+                                                       optimized.lodIndices.data(),
+                                                       optimized.lodIndices.size());
+        if (encodedSize == 0) {
+            // Drop the LOD chain rather than the whole cook.
+            optimized.lods.clear();
+            optimized.lodIndices.clear();
+            encodedLodIndices.clear();
+        } else {
+            encodedLodIndices.resize(encodedSize);
+        }
+    }
+
     if (vertexEncoded && skinWeightEncoded && indexEncoded) {
         CookedMeshBinaryWriter writer;
         writer.writeBytes("CMSH", 4);
-        writer.writeU32(3);
+        writer.writeU32(6);
         writer.writeU32(static_cast<uint32_t>(optimized.vertices.size()));
         writer.writeU32(static_cast<uint32_t>(optimized.indices.size()));
         writer.writeU32(static_cast<uint32_t>(optimized.submeshes.size()));
@@ -910,11 +1083,24 @@ std::vector<uint8_t> SerializeCookedMeshBinary(const Mesh& mesh) {
         writer.writeF32(mesh.getBoundsMax().x);
         writer.writeF32(mesh.getBoundsMax().y);
         writer.writeF32(mesh.getBoundsMax().z);
+        writer.writeU32(static_cast<uint32_t>(encodedAttributes.size()));
+        writer.writeU32(static_cast<uint32_t>(meshlets.size()));
+        writer.writeU32(static_cast<uint32_t>(meshletVertices.size()));
+        writer.writeU32(static_cast<uint32_t>(meshletTriangles.size()));
+        writer.writeU32(static_cast<uint32_t>(optimized.lods.size()));
+        writer.writeU32(static_cast<uint32_t>(optimized.lodIndices.size()));
+        writer.writeU32(static_cast<uint32_t>(encodedLodIndices.size()));
         writer.writeBytes(mesh.getName().data(), mesh.getName().size());
         writer.writeBytes(encodedVertices.data(), encodedVertices.size());
+        writer.writeBytes(encodedAttributes.data(), encodedAttributes.size());
         writer.writeBytes(encodedIndices.data(), encodedIndices.size());
         writer.writeBytes(optimized.submeshes.data(), optimized.submeshes.size() * sizeof(Submesh));
         writer.writeBytes(encodedSkinWeights.data(), encodedSkinWeights.size());
+        writer.writeBytes(meshlets.data(), meshlets.size() * sizeof(Meshlet));
+        writer.writeBytes(meshletVertices.data(), meshletVertices.size() * sizeof(uint32_t));
+        writer.writeBytes(meshletTriangles.data(), meshletTriangles.size());
+        writer.writeBytes(optimized.lods.data(), optimized.lods.size() * sizeof(MeshLod));
+        writer.writeBytes(encodedLodIndices.data(), encodedLodIndices.size());
         return writer.bytes();
     }
 #endif
@@ -930,45 +1116,90 @@ std::vector<uint8_t> SerializeCookedMeshBinary(const Mesh& mesh) {
     return writer.bytes();
 }
 
+bool SaveCookedBytes(const std::filesystem::path& outputPath, const std::vector<uint8_t>& bytes) {
+    std::error_code ec;
+    std::filesystem::create_directories(outputPath.parent_path(), ec);
+    // Written aside and renamed: a running game may have the old file mapped, and truncating a
+    // mapped file faults its readers.
+    std::filesystem::path tempPath = outputPath;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!out.good()) {
+            return false;
+        }
+    }
+    std::filesystem::rename(tempPath, outputPath, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
 bool SaveCookedMeshBinary(const std::filesystem::path& outputPath, const Mesh& mesh) {
-    std::vector<uint8_t> bytes = SerializeCookedMeshBinary(mesh);
+    std::vector<uint8_t> bytes = SerializeCookedMeshBinary(mesh, CookedMeshEncoding::GpuLayout);
     if (bytes.empty()) {
         return false;
     }
+    return SaveCookedBytes(outputPath, bytes);
+}
 
-    std::error_code ec;
-    std::filesystem::create_directories(outputPath.parent_path(), ec);
-    std::ofstream out(outputPath, std::ios::binary);
-    if (!out.is_open()) {
-        return false;
+// Maps a file read-only; the mapping lives as long as the returned pointer.
+std::shared_ptr<const uint8_t> MapFileReadOnly(const std::string& path, size_t& outSize) {
+    outSize = 0;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
     }
-    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
-    return out.good();
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+    outSize = size;
+    return std::shared_ptr<const uint8_t>(static_cast<const uint8_t*>(mapped), [size](const uint8_t* data) {
+        munmap(const_cast<uint8_t*>(data), size);
+    });
 }
 
-std::shared_ptr<Mesh> DeserializeCookedMeshBinary(const std::vector<uint8_t>& bytes) {
-    if (bytes.size() < 12) {
+// storage must own data for version 7 meshes, which keep pointing into it; older versions are
+// decoded and do not need it.
+std::shared_ptr<Mesh> DeserializeCookedMeshBinary(const uint8_t* data,
+                                                  size_t size,
+                                                  const std::shared_ptr<const void>& storage) {
+    if (!data || size < 12) {
         return nullptr;
     }
-    if (std::memcmp(bytes.data(), "CMSH", 4) != 0) {
+    if (std::memcmp(data, "CMSH", 4) != 0) {
         return nullptr;
     }
 
-    auto readU32 = [&bytes](size_t offset) -> uint32_t {
-        return static_cast<uint32_t>(bytes[offset]) |
-               (static_cast<uint32_t>(bytes[offset + 1]) << 8u) |
-               (static_cast<uint32_t>(bytes[offset + 2]) << 16u) |
-               (static_cast<uint32_t>(bytes[offset + 3]) << 24u);
+    auto readU32 = [data](size_t offset) -> uint32_t {
+        return static_cast<uint32_t>(data[offset]) |
+               (static_cast<uint32_t>(data[offset + 1]) << 8u) |
+               (static_cast<uint32_t>(data[offset + 2]) << 16u) |
+               (static_cast<uint32_t>(data[offset + 3]) << 24u);
     };
 
     uint32_t version = readU32(4);
     if (version == 1) {
         uint32_t payloadSize = readU32(8);
-        if (bytes.size() < 12ull + payloadSize) {
+        if (size < 12ull + payloadSize) {
             return nullptr;
         }
 
-        std::vector<uint8_t> payload(bytes.begin() + 12, bytes.begin() + 12 + payloadSize);
+        std::vector<uint8_t> payload(data + 12, data + 12 + payloadSize);
         json root = json::from_msgpack(payload, true, false);
         if (root.is_discarded() || !root.is_object()) {
             return nullptr;
@@ -977,16 +1208,19 @@ std::shared_ptr<Mesh> DeserializeCookedMeshBinary(const std::vector<uint8_t>& by
     }
 
 #if CRESCENT_HAS_MESHOPTIMIZER
-    constexpr size_t kHeaderSize = 72;
-    if ((version != 2 && version != 3) || bytes.size() < kHeaderSize) {
+    // Version 4 appends the packed attribute stream size to the version 2/3 header, version 5 the
+    // meshlet, meshlet vertex and meshlet triangle byte counts, version 6 the LOD level count, LOD
+    // index count and encoded LOD index size. Version 7 keeps the version 6 header.
+    const size_t kHeaderSize = version >= 6 ? 100 : (version >= 5 ? 88 : (version >= 4 ? 76 : 72));
+    if (version < 2 || version > 7 || size < kHeaderSize) {
         return nullptr;
     }
 
-    auto readF32 = [&bytes](size_t offset) -> float {
-        uint32_t bits = static_cast<uint32_t>(bytes[offset]) |
-                        (static_cast<uint32_t>(bytes[offset + 1]) << 8u) |
-                        (static_cast<uint32_t>(bytes[offset + 2]) << 16u) |
-                        (static_cast<uint32_t>(bytes[offset + 3]) << 24u);
+    auto readF32 = [data](size_t offset) -> float {
+        uint32_t bits = static_cast<uint32_t>(data[offset]) |
+                        (static_cast<uint32_t>(data[offset + 1]) << 8u) |
+                        (static_cast<uint32_t>(data[offset + 2]) << 16u) |
+                        (static_cast<uint32_t>(data[offset + 3]) << 24u);
         float value = 0.0f;
         std::memcpy(&value, &bits, sizeof(float));
         return value;
@@ -1002,39 +1236,156 @@ std::shared_ptr<Mesh> DeserializeCookedMeshBinary(const std::vector<uint8_t>& by
     const uint32_t submeshDataSize = readU32(36);
     const uint32_t skinWeightDataSize = readU32(40);
     const bool doubleSided = readU32(44) != 0;
+    const uint32_t attributeDataSize = version >= 4 ? readU32(72) : 0;
+    const uint32_t meshletCount = version >= 5 ? readU32(76) : 0;
+    const uint32_t meshletVertexCount = version >= 5 ? readU32(80) : 0;
+    const uint32_t meshletTriangleSize = version >= 5 ? readU32(84) : 0;
+    const uint32_t lodCount = version >= 6 ? readU32(88) : 0;
+    const uint32_t lodIndexCount = version >= 6 ? readU32(92) : 0;
+    const uint32_t lodIndexDataSize = version >= 6 ? readU32(96) : 0;
 
     const size_t expectedSubmeshBytes = static_cast<size_t>(submeshCount) * sizeof(Submesh);
     if (submeshDataSize != expectedSubmeshBytes) {
         return nullptr;
     }
 
+    if (version == 7) {
+        if (!storage ||
+            vertexDataSize != static_cast<size_t>(vertexCount) * sizeof(float) * 3 ||
+            attributeDataSize != static_cast<size_t>(vertexCount) * sizeof(PackedVertexAttributes) ||
+            indexDataSize != static_cast<size_t>(indexCount) * sizeof(uint32_t) ||
+            lodIndexDataSize != static_cast<size_t>(lodIndexCount) * sizeof(uint32_t) ||
+            skinWeightDataSize != static_cast<size_t>(skinWeightCount) * sizeof(SkinWeight)) {
+            return nullptr;
+        }
+        size_t cursor = kHeaderSize;
+        bool inBounds = true;
+        auto section = [&](size_t bytes) -> const uint8_t* {
+            cursor = (cursor + kCookedMeshSectionAlignment - 1) / kCookedMeshSectionAlignment * kCookedMeshSectionAlignment;
+            if (!inBounds || cursor + bytes > size) {
+                inBounds = false;
+                return nullptr;
+            }
+            const uint8_t* section = data + cursor;
+            cursor += bytes;
+            return section;
+        };
+        const uint8_t* nameData = section(nameSize);
+        const uint8_t* positionData = section(vertexDataSize);
+        const uint8_t* attributeData = section(attributeDataSize);
+        const uint8_t* indexData = section(static_cast<size_t>(indexDataSize) + lodIndexDataSize);
+        const uint8_t* submeshData = section(submeshDataSize);
+        const uint8_t* skinWeightData = section(skinWeightDataSize);
+        const uint8_t* meshletData = section(static_cast<size_t>(meshletCount) * sizeof(Meshlet));
+        const uint8_t* meshletVertexData = section(static_cast<size_t>(meshletVertexCount) * sizeof(uint32_t));
+        const uint8_t* meshletTriangleData = section(meshletTriangleSize);
+        const uint8_t* lodData = section(static_cast<size_t>(lodCount) * sizeof(MeshLod));
+        if (!inBounds) {
+            return nullptr;
+        }
+
+        // Positions, attributes and indices stay in storage; the small tables are copied.
+        MeshStreamSource streams;
+        streams.storage = storage;
+        streams.positions = reinterpret_cast<const float*>(positionData);
+        streams.attributes = reinterpret_cast<const PackedVertexAttributes*>(attributeData);
+        streams.indices = reinterpret_cast<const uint32_t*>(indexData);
+        streams.vertexCount = vertexCount;
+        streams.indexCount = indexCount;
+        streams.lodIndexCount = lodIndexCount;
+
+        auto mesh = std::make_shared<Mesh>();
+        if (!mesh->setStreamSource(std::move(streams))) {
+            return nullptr;
+        }
+        mesh->setBounds(Math::Vector3(readF32(48), readF32(52), readF32(56)),
+                        Math::Vector3(readF32(60), readF32(64), readF32(68)));
+        if (submeshCount > 0) {
+            std::vector<Submesh> submeshes(submeshCount);
+            std::memcpy(submeshes.data(), submeshData, submeshDataSize);
+            mesh->setSubmeshes(submeshes);
+        }
+        if (skinWeightCount > 0) {
+            std::vector<SkinWeight> skinWeights(skinWeightCount);
+            std::memcpy(skinWeights.data(), skinWeightData, skinWeightDataSize);
+            mesh->setSkinWeights(skinWeights);
+        }
+        if (meshletCount > 0) {
+            std::vector<Meshlet> meshlets(meshletCount);
+            std::vector<uint32_t> meshletVertices(meshletVertexCount);
+            std::vector<uint8_t> meshletTriangles(meshletTriangleData, meshletTriangleData + meshletTriangleSize);
+            std::memcpy(meshlets.data(), meshletData, meshlets.size() * sizeof(Meshlet));
+            std::memcpy(meshletVertices.data(), meshletVertexData, meshletVertices.size() * sizeof(uint32_t));
+            mesh->setMeshlets(std::move(meshlets), std::move(meshletVertices), std::move(meshletTriangles));
+        }
+        if (lodCount > 0) {
+            std::vector<MeshLod> lods(lodCount);
+            std::memcpy(lods.data(), lodData, lods.size() * sizeof(MeshLod));
+            mesh->setLods(std::move(lods), {});
+        }
+        mesh->setName(std::string(reinterpret_cast<const char*>(nameData), nameSize));
+        mesh->setDoubleSided(doubleSided);
+        return mesh;
+    }
+
     const size_t totalPayloadSize = static_cast<size_t>(nameSize)
         + static_cast<size_t>(vertexDataSize)
+        + static_cast<size_t>(attributeDataSize)
         + static_cast<size_t>(indexDataSize)
         + static_cast<size_t>(submeshDataSize)
-        + static_cast<size_t>(skinWeightDataSize);
-    if (bytes.size() < kHeaderSize + totalPayloadSize) {
+        + static_cast<size_t>(skinWeightDataSize)
+        + static_cast<size_t>(meshletCount) * sizeof(Meshlet)
+        + static_cast<size_t>(meshletVertexCount) * sizeof(uint32_t)
+        + static_cast<size_t>(meshletTriangleSize)
+        + static_cast<size_t>(lodCount) * sizeof(MeshLod)
+        + static_cast<size_t>(lodIndexDataSize);
+    if (size < kHeaderSize + totalPayloadSize) {
         return nullptr;
     }
 
     size_t cursor = kHeaderSize;
     std::string name;
     if (nameSize > 0) {
-        name.assign(reinterpret_cast<const char*>(bytes.data() + cursor), nameSize);
+        name.assign(reinterpret_cast<const char*>(data + cursor), nameSize);
         cursor += nameSize;
     }
 
     std::vector<Vertex> vertices(vertexCount);
+    std::vector<PackedVertexAttributes> packedAttributes;
     if (vertexCount > 0) {
         if (vertexDataSize == 0) {
             return nullptr;
         }
 
-        if (version == 2) {
+        if (version >= 4) {
+            std::vector<float> positions(static_cast<size_t>(vertexCount) * 3);
+            packedAttributes.resize(vertexCount);
+            if (attributeDataSize == 0 ||
+                meshopt_decodeVertexBuffer(positions.data(),
+                                           vertexCount,
+                                           sizeof(float) * 3,
+                                           data + cursor,
+                                           vertexDataSize) != 0 ||
+                meshopt_decodeVertexBuffer(packedAttributes.data(),
+                                           vertexCount,
+                                           sizeof(PackedVertexAttributes),
+                                           data + cursor + vertexDataSize,
+                                           attributeDataSize) != 0) {
+                return nullptr;
+            }
+            // CPU consumers (physics, picking, lightmapping) still read Vertex; the GPU keeps the
+            // packed stream as loaded.
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                Vertex& v = vertices[i];
+                v.position = Math::Vector3(positions[i * 3 + 0], positions[i * 3 + 1], positions[i * 3 + 2]);
+                packedAttributes[i].unpack(v);
+            }
+            cursor += attributeDataSize;
+        } else if (version == 2) {
             if (meshopt_decodeVertexBuffer(vertices.data(),
                                            vertexCount,
                                            sizeof(Vertex),
-                                           bytes.data() + cursor,
+                                           data + cursor,
                                            vertexDataSize) != 0) {
                 return nullptr;
             }
@@ -1071,7 +1422,7 @@ std::shared_ptr<Mesh> DeserializeCookedMeshBinary(const std::vector<uint8_t>& by
             if (meshopt_decodeVertexBuffer(quantizedVertices.data(),
                                            vertexCount,
                                            sizeof(QuantizedVertex),
-                                           bytes.data() + cursor,
+                                           data + cursor,
                                            vertexDataSize) != 0) {
                 return nullptr;
             }
@@ -1117,7 +1468,7 @@ std::shared_ptr<Mesh> DeserializeCookedMeshBinary(const std::vector<uint8_t>& by
             meshopt_decodeIndexBuffer(indices.data(),
                                       indexCount,
                                       sizeof(uint32_t),
-                                      bytes.data() + cursor,
+                                      data + cursor,
                                       indexDataSize) != 0) {
             return nullptr;
         }
@@ -1126,7 +1477,7 @@ std::shared_ptr<Mesh> DeserializeCookedMeshBinary(const std::vector<uint8_t>& by
 
     std::vector<Submesh> submeshes(submeshCount);
     if (submeshCount > 0) {
-        std::memcpy(submeshes.data(), bytes.data() + cursor, submeshDataSize);
+        std::memcpy(submeshes.data(), data + cursor, submeshDataSize);
         cursor += submeshDataSize;
     }
 
@@ -1136,15 +1487,48 @@ std::shared_ptr<Mesh> DeserializeCookedMeshBinary(const std::vector<uint8_t>& by
             meshopt_decodeVertexBuffer(skinWeights.data(),
                                        skinWeightCount,
                                        sizeof(SkinWeight),
-                                       bytes.data() + cursor,
+                                       data + cursor,
                                        skinWeightDataSize) != 0) {
             return nullptr;
         }
         cursor += skinWeightDataSize;
     }
 
+    std::vector<Meshlet> meshlets(meshletCount);
+    std::vector<uint32_t> meshletVertices(meshletVertexCount);
+    std::vector<uint8_t> meshletTriangles(meshletTriangleSize);
+    if (meshletCount > 0) {
+        std::memcpy(meshlets.data(), data + cursor, meshlets.size() * sizeof(Meshlet));
+        cursor += meshlets.size() * sizeof(Meshlet);
+        std::memcpy(meshletVertices.data(), data + cursor, meshletVertices.size() * sizeof(uint32_t));
+        cursor += meshletVertices.size() * sizeof(uint32_t);
+        std::memcpy(meshletTriangles.data(), data + cursor, meshletTriangles.size());
+        cursor += meshletTriangles.size();
+    }
+
+    std::vector<MeshLod> lods(lodCount);
+    std::vector<uint32_t> lodIndices(lodIndexCount);
+    if (lodCount > 0) {
+        std::memcpy(lods.data(), data + cursor, lods.size() * sizeof(MeshLod));
+        cursor += lods.size() * sizeof(MeshLod);
+        // A corrupt LOD chain only costs the LODs.
+        if (lodIndexCount == 0 || lodIndexDataSize == 0 ||
+            meshopt_decodeIndexBuffer(lodIndices.data(),
+                                      lodIndexCount,
+                                      sizeof(uint32_t),
+                                      data + cursor,
+                                      lodIndexDataSize) != 0) {
+            lods.clear();
+            lodIndices.clear();
+        }
+        cursor += lodIndexDataSize;
+    }
+
     auto mesh = std::make_shared<Mesh>();
     mesh->setVertices(vertices);
+    if (!packedAttributes.empty()) {
+        mesh->setPackedAttributes(std::move(packedAttributes));
+    }
     mesh->setIndices(indices);
     if (!submeshes.empty()) {
         mesh->setSubmeshes(submeshes);
@@ -1152,6 +1536,12 @@ std::shared_ptr<Mesh> DeserializeCookedMeshBinary(const std::vector<uint8_t>& by
     if (!skinWeights.empty()) {
         mesh->setSkinWeights(skinWeights);
     }
+    if (!meshlets.empty()) {
+        mesh->setMeshlets(std::move(meshlets), std::move(meshletVertices), std::move(meshletTriangles));
+    }
+    if (!lods.empty()) {
+        mesh->setLods(std::move(lods), std::move(lodIndices));
+    }
     mesh->setName(name);
     mesh->setDoubleSided(doubleSided);
 
@@ -1161,11 +1551,17 @@ std::shared_ptr<Mesh> DeserializeCookedMeshBinary(const std::vector<uint8_t>& by
     (void)expectedBoundsMax;
     return mesh;
 #else
-    (void)bytes;
+    (void)storage;
     return nullptr;
 #endif
 }
 
+std::shared_ptr<Mesh> DeserializeCookedMeshBinary(const std::vector<uint8_t>& bytes) {
+    // Version 7 meshes point into their bytes, so they get a copy that lives with the mesh.
+    auto storage = std::make_shared<const std::vector<uint8_t>>(bytes);
+    return DeserializeCookedMeshBinary(storage->data(), storage->size(), storage);
+}
+
 std::string BuildCookedSceneMeshRelativePath(const std::filesystem::path& cookedScenePath,
                                              const std::string& meshKey) {
     if (meshKey.empty()) {
@@ -1233,6 +1629,68 @@ std::string EmitCookedMeshRef(Entity* entity,
     return relativePath;
 }
 
+// Mesh colliders cook to a Jolt shape blob beside the scene's meshes, so the runtime restores the
+// collider instead of building a mesh BVH or convex hull and never reads the mesh back for it.
+// Blobs are named by their contents; identical props share one file.
+bool CanEmitCookedPhysics(Scene* scene, const BuildSceneOptions& options) {
+    return scene && scene->getPhysicsWorld() && options.externalizeRuntimeMeshes &&
+           options.cookedMeshWriter && !options.cookedMeshWriter->sceneOutputPath.empty();
+}
+
+// Writes a cooked physics blob next to the cooked meshes, once per distinct content, and returns
+// its scene-relative path; empty on failure.
+std::string EmitCookedPhysicsBlob(const std::vector<uint8_t>& blob,
+                                  const char* extension,
+                                  const BuildSceneOptions& options) {
+    const std::string blobHash = HashRuntimeCookKey(std::string(blob.begin(), blob.end()));
+    const std::string blobKey = std::string(extension) + "|" + blobHash;
+    auto existing = options.cookedMeshWriter->emittedPaths.find(blobKey);
+    if (existing != options.cookedMeshWriter->emittedPaths.end()) {
+        return existing->second;
+    }
+    const std::filesystem::path& scenePath = options.cookedMeshWriter->sceneOutputPath;
+    const std::string relativePath = (std::filesystem::path(scenePath.stem().string() + ".meshes") /
+                                      (blobHash + extension)).generic_string();
+    if (!SaveCookedBytes(scenePath.parent_path() / relativePath, blob)) {
+        return std::string();
+    }
+    options.cookedMeshWriter->emittedPaths[blobKey] = relativePath;
+    return relativePath;
+}
+
+json EmitCookedColliderShape(Scene* scene, Entity* entity, const BuildSceneOptions& options) {
+    if (!CanEmitCookedPhysics(scene, options)) {
+        return json();
+    }
+    Math::Matrix4x4 transform;
+    bool convex = false;
+    std::vector<uint8_t> blob = scene->getPhysicsWorld()->cookMeshColliderShape(entity, transform, convex);
+    if (blob.empty()) {
+        return json();
+    }
+    const std::string relativePath = EmitCookedPhysicsBlob(blob, ".jshape", options);
+    if (relativePath.empty()) {
+        return json();
+    }
+    return {
+        {"path", relativePath},
+        {"convex", convex},
+        {"transform", MatrixToJson(transform)}
+    };
+}
+
+// The cooked height texture of a terrain collider; empty when the terrain is not a height grid.
+std::string EmitCookedTerrainHeightField(Scene* scene, Entity* entity, const BuildSceneOptions& options) {
+    if (!CanEmitCookedPhysics(scene, options)) {
+        return std::string();
+    }
+    std::vector<uint8_t> bytes = scene->getPhysicsWorld()->cookTerrainHeightField(entity);
+    if (bytes.empty()) {
+        return std::string();
+    }
+    return EmitCookedPhysicsBlob(bytes, ".jheight", options);
+}
+
 std::string ResolveSceneRelativePath(const std::string& scenePath, const std::string& storedPath) {
     if (storedPath.empty()) {
         return "";
@@ -1244,36 +1702,101 @@ std::string ResolveSceneRelativePath(const std::string& scenePath, const std::st
     return (std::filesystem::path(scenePath).parent_path() / path).lexically_normal().string();
 }
 
-std::shared_ptr<Mesh> LoadCookedMeshRef(const json& meshRef,
-                                        const std::string& scenePath,
-                                        std::unordered_map<std::string, std::shared_ptr<Mesh>>& cookedMeshCache) {
+bool ParseCookedMeshRef(const json& meshRef,
+                        const std::string& scenePath,
+                        std::string& outPath,
+                        MeshResidency& outResidency) {
     std::string storedPath;
+    // Cooked meshes drop their CPU lists after upload and rebuild them from the mapped file when
+    // physics or bone bounds ask; refs the cook marked "gpu" are never read back at all.
+    outResidency = MeshResidency::Reloadable;
     if (meshRef.is_string()) {
         storedPath = meshRef.get<std::string>();
     } else if (meshRef.is_object()) {
         storedPath = meshRef.value("path", std::string());
+        if (meshRef.value("residency", std::string()) == "gpu") {
+            outResidency = MeshResidency::GpuOnly;
+        }
     }
     if (storedPath.empty()) {
+        return false;
+    }
+    outPath = ResolveSceneRelativePath(scenePath, storedPath);
+    return !outPath.empty();
+}
+
+// Mapped rather than read: GPU-layout meshes upload straight from the mapping and only page in
+// what is touched.
+std::shared_ptr<Mesh> DecodeCookedMeshFile(const std::string& resolvedPath, MeshResidency residency) {
+    size_t size = 0;
+    std::shared_ptr<const uint8_t> mapped = MapFileReadOnly(resolvedPath, size);
+    if (!mapped) {
         return nullptr;
     }
+    auto mesh = DeserializeCookedMeshBinary(mapped.get(), size, mapped);
+    if (mesh) {
+        mesh->setResidency(residency);
+    }
+    return mesh;
+}
 
-    std::string resolvedPath = ResolveSceneRelativePath(scenePath, storedPath);
-    if (resolvedPath.empty()) {
+// DecodeCookedMeshFile through Mesh::GetCookedResidency, so a file a recent scene already
+// loaded comes back uploaded. Keyed by the file's size and write time as well, so a recook is
+// decoded afresh. Safe on loading jobs.
+std::shared_ptr<Mesh> AcquireCookedMesh(const std::string& resolvedPath, MeshResidency residency) {
+    std::error_code ec;
+    const auto writeTime = std::filesystem::last_write_time(resolvedPath, ec);
+    if (ec) {
+        return nullptr;
+    }
+    const auto fileSize = std::filesystem::file_size(resolvedPath, ec);
+    if (ec) {
         return nullptr;
     }
+    const std::string key = resolvedPath + "|" + std::to_string(writeTime.time_since_epoch().count()) +
+                            "|" + std::to_string(fileSize);
 
-    auto it = cookedMeshCache.find(resolvedPath);
-    if (it != cookedMeshCache.end()) {
-        return it->second;
+    ResidencyCache<Mesh>& resident = Mesh::GetCookedResidency();
+    if (auto mesh = resident.find(key)) {
+        // A GpuOnly mesh that dropped its streams cannot serve a ref that reads geometry back.
+        if (residency == MeshResidency::GpuOnly) {
+            return mesh;
+        }
+        if (mesh->getResidency() != MeshResidency::GpuOnly) {
+            return mesh;
+        }
+        if (mesh->getStreamSource()) {
+            mesh->setResidency(residency);
+            return mesh;
+        }
     }
+    auto mesh = DecodeCookedMeshFile(resolvedPath, residency);
+    if (mesh) {
+        resident.retain(key, mesh);
+        resident.trim();
+    }
+    return mesh;
+}
 
-    std::ifstream in(resolvedPath, std::ios::binary);
-    if (!in.is_open()) {
+std::shared_ptr<Mesh> LoadCookedMeshRef(const json& meshRef,
+                                        const std::string& scenePath,
+                                        std::unordered_map<std::string, std::shared_ptr<Mesh>>& cookedMeshCache) {
+    std::string resolvedPath;
+    MeshResidency residency = MeshResidency::Reloadable;
+    if (!ParseCookedMeshRef(meshRef, scenePath, resolvedPath, residency)) {
         return nullptr;
     }
 
-    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
-    auto mesh = DeserializeCookedMeshBinary(bytes);
+    auto it = cookedMeshCache.find(resolvedPath);
+    if (it != cookedMeshCache.end()) {
+        // A mesh shared with a ref that may read it back stays reloadable.
+        if (residency != MeshResidency::GpuOnly) {
+            it->second->setResidency(residency);
+        }
+        return it->second;
+    }
+
+    auto mesh = AcquireCookedMesh(resolvedPath, residency);
     if (mesh) {
         cookedMeshCache[resolvedPath] = mesh;
     }
@@ -1347,6 +1870,7 @@ json SerializeMaterial(const Material& material, bool includeCookedTexturePaths
     j["heightInvert"] = material.getHeightInvert();
     j["renderMode"] = static_cast<int>(material.getRenderMode());
     j["alphaCutoff"] = material.getAlphaCutoff();
+    j["transparencyMode"] = static_cast<int>(material.getTransparencyMode());
     j["cullMode"] = static_cast<int>(material.getCullMode());
     j["twoSided"] = material.isTwoSided();
     j["alphaToCoverage"] = material.getAlphaToCoverage();
@@ -1586,8 +2110,13 @@ std::shared_ptr<Skeleton> DeserializeSkeletonData(const json& j) {
 }
 
 json SerializeAnimationClipData(const AnimationClip& clip) {
+    // Compressed clips keep their binary; their channels hold no keys to write.
+    std::vector<uint8_t> compressed = WriteCompressedClipBinary(clip);
     json channels = json::array();
     for (const AnimationChannel& channel : clip.getChannels()) {
+        if (!compressed.empty()) {
+            break;
+        }
         json positions = json::array();
         for (const VectorKeyframe& key : channel.positionKeys) {
             positions.push_back({key.time, key.value.x, key.value.y, key.value.z});
@@ -1624,13 +2153,18 @@ json SerializeAnimationClipData(const AnimationClip& clip) {
         });
     }
 
-    return {
+    json result = {
         {"name", clip.getName()},
         {"durationTicks", clip.getDurationTicks()},
         {"ticksPerSecond", clip.getTicksPerSecond()},
-        {"channels", channels},
         {"events", events}
     };
+    if (!compressed.empty()) {
+        result["compressed"] = json::binary(std::move(compressed));
+    } else {
+        result["channels"] = std::move(channels);
+    }
+    return result;
 }
 
 std::shared_ptr<AnimationClip> DeserializeAnimationClipData(const json& j) {
@@ -1643,7 +2177,12 @@ std::shared_ptr<AnimationClip> DeserializeAnimationClipData(const json& j) {
     clip->setDurationTicks(j.value("durationTicks", clip->getDurationTicks()));
     clip->setTicksPerSecond(j.value("ticksPerSecond", clip->getTicksPerSecond()));
 
-    if (j.contains("channels") && j["channels"].is_array()) {
+    if (j.contains("compressed") && j["compressed"].is_binary()) {
+        const auto& compressed = j["compressed"].get_binary();
+        if (!ReadCompressedClipBinary(compressed.data(), compressed.size(), *clip)) {
+            return nullptr;
+        }
+    } else if (j.contains("channels") && j["channels"].is_array()) {
         for (const auto& entry : j["channels"]) {
             if (!entry.is_object()) {
                 continue;
@@ -1796,7 +2335,8 @@ json SerializeFogSettings(const SceneFogSettings& fog) {
         {"volumetricScattering", fog.volumetricScattering},
         {"volumetricAnisotropy", fog.volumetricAnisotropy},
         {"volumetricHistoryWeight", fog.volumetricHistoryWeight},
-        {"volumetricQuality", fog.volumetricQuality}
+        {"volumetricQuality", fog.volumetricQuality},
+        {"volumetricUpdateRate", fog.volumetricUpdateRate}
     };
 }
 
@@ -1853,7 +2393,48 @@ json SerializeQualitySettings(const SceneQualitySettings& quality) {
         {"renderScale", quality.renderScale},
         {"lodBias", quality.lodBias},
         {"textureQuality", quality.textureQuality},
-        {"upscaler", quality.upscaler}
+        {"upscaler", quality.upscaler},
+        {"frameInterpolation", quality.frameInterpolation},
+        {"shadowCascadeUpdateIntervals", json::array({
+            quality.shadowCascadeUpdateIntervals[0], quality.shadowCascadeUpdateIntervals[1],
+            quality.shadowCascadeUpdateIntervals[2], quality.shadowCascadeUpdateIntervals[3]})},
+        {"shadowUpdateBudget", quality.shadowUpdateBudget},
+        {"asyncClusterBuild", quality.asyncClusterBuild},
+        {"asyncFogVolume", quality.asyncFogVolume},
+        {"ssaoResolution", quality.ssaoResolution},
+        {"dynamicResolution", quality.dynamicResolution},
+        {"dynamicResolutionTargetMs", quality.dynamicResolutionTargetMs},
+        {"dynamicResolutionMinScale", quality.dynamicResolutionMinScale},
+        {"variableRateShading", quality.variableRateShading},
+        {"variableRateShadingPeriphery", quality.variableRateShadingPeriphery},
+        {"particleBudget", quality.particleBudget},
+        {"particleCollision", quality.particleCollision},
+        {"halfPrecisionShading", quality.halfPrecisionShading},
+        {"visibilityBuffer", quality.visibilityBuffer},
+        {"compactRenderTargets", quality.compactRenderTargets},
+        {"uniformAnimationClips", quality.uniformAnimationClips}
+    };
+}
+
+json SerializeStreamingSettings(const SceneStreamingSettings& streaming) {
+    return {
+        {"enabled", streaming.enabled},
+        {"cellSize", streaming.cellSize},
+        {"loadRadius", streaming.loadRadius},
+        {"unloadRadius", streaming.unloadRadius},
+        {"activationBudgetMs", streaming.activationBudgetMs}
+    };
+}
+
+// The cooked grid path is not a setting: the cook writes it into the cooked scene only.
+json SerializeNavigationSettings(const SceneNavigationSettings& navigation) {
+    return {
+        {"enabled", navigation.enabled},
+        {"cellSize", navigation.cellSize},
+        {"agentRadius", navigation.agentRadius},
+        {"agentHeight", navigation.agentHeight},
+        {"maxSlopeDegrees", navigation.maxSlopeDegrees},
+        {"stepHeight", navigation.stepHeight}
     };
 }
 
@@ -1873,6 +2454,12 @@ json SerializeStaticLightingSettings(const SceneStaticLightingSettings& staticLi
         {"samplesPerTexel", staticLighting.samplesPerTexel},
         {"indirectBounces", staticLighting.indirectBounces},
         {"denoise", staticLighting.denoise},
+        {"gpuBake", staticLighting.gpuBake},
+        {"progressiveBake", staticLighting.progressiveBake},
+        {"progressivePasses", staticLighting.progressivePasses},
+        {"progressivePreviewSeconds", staticLighting.progressivePreviewSeconds},
+        {"progressiveFrameBudgetMs", staticLighting.progressiveFrameBudgetMs},
+        {"indirectInfluenceRadius", staticLighting.indirectInfluenceRadius},
         {"bakeDirectLighting", staticLighting.bakeDirectLighting},
         {"directionalLightmaps", staticLighting.directionalLightmaps},
         {"shadowmask", staticLighting.shadowmask},
@@ -1884,6 +2471,15 @@ json SerializeStaticLightingSettings(const SceneStaticLightingSettings& staticLi
         {"probeCountY", staticLighting.probeCountY},
         {"probeCountZ", staticLighting.probeCountZ},
         {"probeSamples", staticLighting.probeSamples},
+        {"probeStreamingBrickBudget", staticLighting.probeStreamingBrickBudget},
+        {"dynamicProbes", staticLighting.dynamicProbes},
+        {"dynamicProbesPerFrame", staticLighting.dynamicProbesPerFrame},
+        {"dynamicProbeRays", staticLighting.dynamicProbeRays},
+        {"dynamicProbeHysteresis", staticLighting.dynamicProbeHysteresis},
+        {"dynamicReflections", staticLighting.dynamicReflections},
+        {"dynamicReflectionProbes", staticLighting.dynamicReflectionProbes},
+        {"dynamicReflectionResolution", staticLighting.dynamicReflectionResolution},
+        {"dynamicReflectionFacesPerFrame", staticLighting.dynamicReflectionFacesPerFrame},
         {"reflectionProbeIntensity", staticLighting.reflectionProbeIntensity},
         {"reflectionProbeBlendSharpness", staticLighting.reflectionProbeBlendSharpness},
         {"reflectionProbeFilterStrength", staticLighting.reflectionProbeFilterStrength},
@@ -1896,7 +2492,8 @@ json SerializeStaticLightingSettings(const SceneStaticLightingSettings& staticLi
         {"outputDirectory", outputDirectory},
         {"bakeManifestPath", bakeManifestPath},
         {"probeDataPath", staticLighting.probeDataPath.empty() ? std::string() : MakeProjectRelativePath(ResolveProjectPath(staticLighting.probeDataPath))},
-        {"lastBakeHash", staticLighting.lastBakeHash}
+        {"lastBakeHash", staticLighting.lastBakeHash},
+        {"atlasBakeHashes", staticLighting.atlasBakeHashes}
     };
 }
 
@@ -1959,6 +2556,7 @@ SceneFogSettings DeserializeFogSettings(const json& j) {
     fog.volumetricAnisotropy = j.value("volumetricAnisotropy", fog.volumetricAnisotropy);
     fog.volumetricHistoryWeight = j.value("volumetricHistoryWeight", fog.volumetricHistoryWeight);
     fog.volumetricQuality = j.value("volumetricQuality", fog.volumetricQuality);
+    fog.volumetricUpdateRate = j.value("volumetricUpdateRate", fog.volumetricUpdateRate);
     return fog;
 }
 
@@ -2021,9 +2619,59 @@ SceneQualitySettings DeserializeQualitySettings(const json& j) {
     quality.lodBias = j.value("lodBias", quality.lodBias);
     quality.textureQuality = j.value("textureQuality", quality.textureQuality);
     quality.upscaler = j.value("upscaler", quality.upscaler);
+    quality.frameInterpolation = j.value("frameInterpolation", quality.frameInterpolation);
+    if (j.contains("shadowCascadeUpdateIntervals") && j["shadowCascadeUpdateIntervals"].is_array() &&
+        j["shadowCascadeUpdateIntervals"].size() == 4) {
+        for (size_t i = 0; i < 4; ++i) {
+            quality.shadowCascadeUpdateIntervals[i] = j["shadowCascadeUpdateIntervals"][i].get<int>();
+        }
+    }
+    quality.shadowUpdateBudget = j.value("shadowUpdateBudget", quality.shadowUpdateBudget);
+    quality.asyncClusterBuild = j.value("asyncClusterBuild", quality.asyncClusterBuild);
+    quality.asyncFogVolume = j.value("asyncFogVolume", quality.asyncFogVolume);
+    quality.ssaoResolution = j.value("ssaoResolution", quality.ssaoResolution);
+    quality.dynamicResolution = j.value("dynamicResolution", quality.dynamicResolution);
+    quality.dynamicResolutionTargetMs = j.value("dynamicResolutionTargetMs", quality.dynamicResolutionTargetMs);
+    quality.dynamicResolutionMinScale = j.value("dynamicResolutionMinScale", quality.dynamicResolutionMinScale);
+    quality.variableRateShading = j.value("variableRateShading", quality.variableRateShading);
+    quality.variableRateShadingPeriphery = j.value("variableRateShadingPeriphery", quality.variableRateShadingPeriphery);
+    quality.particleBudget = j.value("particleBudget", quality.particleBudget);
+    quality.particleCollision = j.value("particleCollision", quality.particleCollision);
+    quality.halfPrecisionShading = j.value("halfPrecisionShading", quality.halfPrecisionShading);
+    quality.visibilityBuffer = j.value("visibilityBuffer", quality.visibilityBuffer);
+    quality.compactRenderTargets = j.value("compactRenderTargets", quality.compactRenderTargets);
+    quality.uniformAnimationClips = j.value("uniformAnimationClips", quality.uniformAnimationClips);
     return quality;
 }
 
+SceneStreamingSettings DeserializeStreamingSettings(const json& j) {
+    SceneStreamingSettings streaming;
+    if (!j.is_object()) {
+        return streaming;
+    }
+    streaming.enabled = j.value("enabled", streaming.enabled);
+    streaming.cellSize = std::max(1.0f, j.value("cellSize", streaming.cellSize));
+    streaming.loadRadius = std::max(0.0f, j.value("loadRadius", streaming.loadRadius));
+    streaming.unloadRadius = std::max(streaming.loadRadius, j.value("unloadRadius", streaming.unloadRadius));
+    streaming.activationBudgetMs = std::max(0.1f, j.value("activationBudgetMs", streaming.activationBudgetMs));
+    return streaming;
+}
+
+SceneNavigationSettings DeserializeNavigationSettings(const json& j, const std::string& scenePath) {
+    SceneNavigationSettings navigation;
+    if (!j.is_object()) {
+        return navigation;
+    }
+    navigation.enabled = j.value("enabled", navigation.enabled);
+    navigation.cellSize = std::max(0.05f, j.value("cellSize", navigation.cellSize));
+    navigation.agentRadius = std::max(0.05f, j.value("agentRadius", navigation.agentRadius));
+    navigation.agentHeight = std::max(navigation.agentRadius * 2.0f, j.value("agentHeight", navigation.agentHeight));
+    navigation.maxSlopeDegrees = std::clamp(j.value("maxSlopeDegrees", navigation.maxSlopeDegrees), 0.0f, 89.0f);
+    navigation.stepHeight = std::max(0.0f, j.value("stepHeight", navigation.stepHeight));
+    navigation.cookedGridPath = ResolveSceneRelativePath(scenePath, j.value("cookedGrid", std::string()));
+    return navigation;
+}
+
 SceneStaticLightingSettings DeserializeStaticLightingSettings(const json& j) {
     SceneStaticLightingSettings staticLighting;
     if (!j.is_object()) {
@@ -2037,6 +2685,12 @@ SceneStaticLightingSettings DeserializeStaticLightingSettings(const json& j) {
     staticLighting.samplesPerTexel = j.value("samplesPerTexel", staticLighting.samplesPerTexel);
     staticLighting.indirectBounces = j.value("indirectBounces", staticLighting.indirectBounces);
     staticLighting.denoise = j.value("denoise", staticLighting.denoise);
+    staticLighting.gpuBake = j.value("gpuBake", staticLighting.gpuBake);
+    staticLighting.progressiveBake = j.value("progressiveBake", staticLighting.progressiveBake);
+    staticLighting.progressivePasses = std::max(1, j.value("progressivePasses", staticLighting.progressivePasses));
+    staticLighting.progressivePreviewSeconds = std::max(0.0f, j.value("progressivePreviewSeconds", staticLighting.progressivePreviewSeconds));
+    staticLighting.progressiveFrameBudgetMs = std::max(1.0f, j.value("progressiveFrameBudgetMs", staticLighting.progressiveFrameBudgetMs));
+    staticLighting.indirectInfluenceRadius = std::max(0.0f, j.value("indirectInfluenceRadius", staticLighting.indirectInfluenceRadius));
     staticLighting.bakeDirectLighting = j.value("bakeDirectLighting", staticLighting.bakeDirectLighting);
     staticLighting.directionalLightmaps = j.value("directionalLightmaps", staticLighting.directionalLightmaps);
     staticLighting.shadowmask = j.value("shadowmask", staticLighting.shadowmask);
@@ -2048,6 +2702,15 @@ SceneStaticLightingSettings DeserializeStaticLightingSettings(const json& j) {
     staticLighting.probeCountY = j.value("probeCountY", staticLighting.probeCountY);
     staticLighting.probeCountZ = j.value("probeCountZ", staticLighting.probeCountZ);
     staticLighting.probeSamples = j.value("probeSamples", staticLighting.probeSamples);
+    staticLighting.probeStreamingBrickBudget = std::max(0, j.value("probeStreamingBrickBudget", staticLighting.probeStreamingBrickBudget));
+    staticLighting.dynamicProbes = j.value("dynamicProbes", staticLighting.dynamicProbes);
+    staticLighting.dynamicProbesPerFrame = std::max(1, j.value("dynamicProbesPerFrame", staticLighting.dynamicProbesPerFrame));
+    staticLighting.dynamicProbeRays = std::max(1, std::min(256, j.value("dynamicProbeRays", staticLighting.dynamicProbeRays)));
+    staticLighting.dynamicProbeHysteresis = std::max(0.0f, std::min(0.99f, j.value("dynamicProbeHysteresis", staticLighting.dynamicProbeHysteresis)));
+    staticLighting.dynamicReflections = j.value("dynamicReflections", staticLighting.dynamicReflections);
+    staticLighting.dynamicReflectionProbes = std::max(1, std::min(8, j.value("dynamicReflectionProbes", staticLighting.dynamicReflectionProbes)));
+    staticLighting.dynamicReflectionResolution = std::max(16, std::min(256, j.value("dynamicReflectionResolution", staticLighting.dynamicReflectionResolution)));
+    staticLighting.dynamicReflectionFacesPerFrame = std::max(1, std::min(48, j.value("dynamicReflectionFacesPerFrame", staticLighting.dynamicReflectionFacesPerFrame)));
     staticLighting.reflectionProbeIntensity = j.value("reflectionProbeIntensity", staticLighting.reflectionProbeIntensity);
     staticLighting.reflectionProbeBlendSharpness = j.value("reflectionProbeBlendSharpness", staticLighting.reflectionProbeBlendSharpness);
     staticLighting.reflectionProbeFilterStrength = j.value("reflectionProbeFilterStrength", staticLighting.reflectionProbeFilterStrength);
@@ -2065,6 +2728,12 @@ SceneStaticLightingSettings DeserializeStaticLightingSettings(const json& j) {
     staticLighting.bakeManifestPath = j.value("bakeManifestPath", staticLighting.bakeManifestPath);
     staticLighting.probeDataPath = j.value("probeDataPath", staticLighting.probeDataPath);
     staticLighting.lastBakeHash = j.value("lastBakeHash", staticLighting.lastBakeHash);
+    if (j.contains("atlasBakeHashes") && j["atlasBakeHashes"].is_array()) {
+        staticLighting.atlasBakeHashes.clear();
+        for (const auto& hash : j["atlasBakeHashes"]) {
+            staticLighting.atlasBakeHashes.push_back(hash.is_string() ? hash.get<std::string>() : std::string());
+        }
+    }
     return staticLighting;
 }
 
@@ -2075,6 +2744,9 @@ json SerializeStaticLightingAtlasRecord(const StaticLightingAtlasRecord& atlas)
         {"height", atlas.height},
         {"rendererCount", atlas.rendererCount}
     };
+    if (!atlas.bakeHash.empty()) {
+        j["bakeHash"] = atlas.bakeHash;
+    }
     if (!atlas.lightmapPath.empty()) {
         j["lightmap"] = SerializeProjectPathRef(atlas.lightmapPath);
     }
@@ -2105,6 +2777,7 @@ StaticLightingAtlasRecord DeserializeStaticLightingAtlasRecord(const json& j) {
     atlas.width = j.value("width", atlas.width);
     atlas.height = j.value("height", atlas.height);
     atlas.rendererCount = j.value("rendererCount", atlas.rendererCount);
+    atlas.bakeHash = j.value("bakeHash", atlas.bakeHash);
     if (j.contains("lightmap")) {
         atlas.lightmapPath = ResolveTextureEntryPath(j["lightmap"]);
     }
@@ -2146,6 +2819,9 @@ json SerializeStaticLightingRendererRecord(const StaticLightingRendererRecord& r
     if (!renderer.shadowmaskPath.empty()) {
         j["shadowmask"] = SerializeProjectPathRef(renderer.shadowmaskPath);
     }
+    if (!renderer.contentHash.empty()) {
+        j["contentHash"] = renderer.contentHash;
+    }
     return j;
 }
 
@@ -2173,6 +2849,7 @@ StaticLightingRendererRecord DeserializeStaticLightingRendererRecord(const json&
     if (j.contains("shadowmask")) {
         renderer.shadowmaskPath = ResolveTextureEntryPath(j["shadowmask"]);
     }
+    renderer.contentHash = j.value("contentHash", renderer.contentHash);
     return renderer;
 }
 
@@ -2373,7 +3050,8 @@ std::shared_ptr<Texture2D> LoadTexturePath(TextureLoader* loader,
         }
         return LoadEmbeddedTextureFromModel(loader, path, info, srgb, normalMap);
     }
-    return loader->loadTexture(path, srgb, true, normalMap);
+    // Scene loads do not wait on decodes; the material shows a placeholder until the data lands.
+    return loader->loadTextureAsync(path, srgb, true, normalMap);
 }
 
 std::shared_ptr<Texture2D> LoadTerrainControlTexturePath(TextureLoader* loader,
@@ -2417,6 +3095,8 @@ std::shared_ptr<Material> DeserializeMaterial(const json& j, TextureLoader* load
     material->setHeightInvert(j.value("heightInvert", material->getHeightInvert()));
     material->setRenderMode(static_cast<Material::RenderMode>(j.value("renderMode", static_cast<int>(material->getRenderMode()))));
     material->setAlphaCutoff(j.value("alphaCutoff", material->getAlphaCutoff()));
+    material->setTransparencyMode(static_cast<Material::TransparencyMode>(
+        std::max(0, std::min(2, j.value("transparencyMode", static_cast<int>(material->getTransparencyMode()))))));
     material->setCullMode(static_cast<Material::CullMode>(j.value("cullMode", static_cast<int>(material->getCullMode()))));
     material->setTwoSided(j.value("twoSided", material->isTwoSided()));
     material->setAlphaToCoverage(j.value("alphaToCoverage", material->getAlphaToCoverage()));
@@ -2527,46 +3207,246 @@ std::string MakeModelCacheKey(const std::string& path, const SceneCommands::Mode
            (options.mergeStaticMeshes ? "1" : "0");
 }
 
-ModelCacheEntry BuildModelCache(const std::string& path, const SceneCommands::ModelImportOptions& options) {
-    Scene temp("ModelCache");
-    SceneCommands::importModel(&temp, path, options, "ModelCache");
+// Processed imports live in Library/ModelCache, keyed on the model's project path, the contents
+// of its source file and its import settings, so reopening a scene only goes through Assimp for
+// models that changed. Bump the version when the importer's output changes.
+constexpr uint32_t kModelCacheVersion = 1;
 
-    ModelCacheEntry entry;
-    for (const auto& entityPtr : temp.getAllEntities()) {
-        Entity* entity = entityPtr.get();
-        if (!entity) {
-            continue;
-        }
-        ModelMeshReference* reference = entity->getComponent<ModelMeshReference>();
-        if (!reference) {
-            continue;
+std::string HashFileContents(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        return "";
+    }
+    uint64_t hash = 14695981039346656037ull;
+    std::vector<char> buffer(1 << 20);
+    while (in) {
+        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        const std::streamsize count = in.gcount();
+        for (std::streamsize i = 0; i < count; ++i) {
+            hash ^= static_cast<uint64_t>(static_cast<unsigned char>(buffer[static_cast<size_t>(i)]));
+            hash *= 1099511628211ull;
         }
-        MeshRenderer* renderer = entity->getComponent<MeshRenderer>();
-        if (!renderer) {
-            continue;
+    }
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return oss.str();
+}
+
+std::filesystem::path ResolveModelCachePath(const std::string& sourcePath, const SceneCommands::ModelImportOptions& options) {
+    AssetDatabase& db = AssetDatabase::getInstance();
+    const std::string libraryPath = db.getLibraryPath();
+    if (libraryPath.empty() || sourcePath.empty()) {
+        return {};
+    }
+    // The path is part of the key because materials resolve textures next to the model.
+    const std::string contentHash = HashFileContents(sourcePath);
+    if (contentHash.empty()) {
+        return {};
+    }
+    const std::string key = HashRuntimeCookKey(MakeModelCacheKey(db.getRelativePath(sourcePath), options) + "|" + contentHash);
+    return std::filesystem::path(libraryPath) / "ModelCache" /
+           (key + "_v" + std::to_string(kModelCacheVersion) + ".cmodel");
+}
+
+bool SaveModelCache(const std::filesystem::path& cachePath, const ModelCacheEntry& entry) {
+    json materials = json::array();
+    std::unordered_map<const Material*, int> materialIndices;
+    auto materialIndex = [&](const std::shared_ptr<Material>& material) -> int {
+        if (!material) {
+            return -1;
         }
-        MeshCacheEntry meshEntry;
-        meshEntry.mesh = renderer->getMesh();
-        meshEntry.material = renderer->getMaterial(0);
-        if (reference->isMerged()) {
-            entry.mergedByMaterial[reference->getMaterialIndex()] = meshEntry;
-        } else {
-            entry.meshesByIndex[reference->getMeshIndex()] = meshEntry;
+        auto [it, inserted] = materialIndices.emplace(material.get(), static_cast<int>(materials.size()));
+        if (inserted) {
+            materials.push_back(SerializeMaterial(*material));
         }
+        return it->second;
+    };
 
-        if (reference->isSkinned()) {
-            SkinnedMeshRenderer* skinned = entity->getComponent<SkinnedMeshRenderer>();
-            if (skinned && !entry.skeleton) {
-                entry.skeleton = skinned->getSkeleton();
-                entry.animations = skinned->getAnimationClips();
+    json meshes = json::array();
+    auto pushMeshes = [&](const std::unordered_map<int, MeshCacheEntry>& source, bool merged) {
+        for (const auto& [index, meshEntry] : source) {
+            if (!meshEntry.mesh) {
+                continue;
+            }
+            std::vector<uint8_t> bytes = SerializeCookedMeshBinary(*meshEntry.mesh);
+            if (bytes.empty()) {
+                return false;
             }
+            meshes.push_back({
+                {"index", index},
+                {"merged", merged},
+                {"material", materialIndex(meshEntry.material)},
+                {"data", json::binary(std::move(bytes))}
+            });
         }
+        return true;
+    };
+    if (!pushMeshes(entry.meshesByIndex, false) || !pushMeshes(entry.mergedByMaterial, true)) {
+        return false;
     }
-    return entry;
-}
 
-bool ParseUUID(const std::string& value, UUID& outUUID) {
-    try {
+    json root;
+    root["meshes"] = std::move(meshes);
+    root["materials"] = std::move(materials);
+    if (entry.skeleton) {
+        root["skeleton"] = SerializeSkeletonData(*entry.skeleton);
+    }
+    json animations = json::array();
+    for (const auto& clip : entry.animations) {
+        if (clip) {
+            animations.push_back(SerializeAnimationClipData(*clip));
+        }
+    }
+    root["animations"] = std::move(animations);
+
+    std::vector<uint8_t> payload = json::to_msgpack(root);
+    CookedMeshBinaryWriter writer;
+    writer.writeBytes("CMDL", 4);
+    writer.writeU32(kModelCacheVersion);
+    writer.writeU32(static_cast<uint32_t>(payload.size()));
+    writer.writeBytes(payload.data(), payload.size());
+
+    std::error_code ec;
+    std::filesystem::create_directories(cachePath.parent_path(), ec);
+    // Per process, since the build's scene cooks run side by side and can import the same model.
+    const std::filesystem::path tempPath = cachePath.string() + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        const std::vector<uint8_t>& bytes = writer.bytes();
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!out.good()) {
+            return false;
+        }
+    }
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool LoadModelCache(const std::filesystem::path& cachePath, TextureLoader* loader, ModelCacheEntry& outEntry) {
+    std::ifstream in(cachePath, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (bytes.size() < 12 || std::memcmp(bytes.data(), "CMDL", 4) != 0) {
+        return false;
+    }
+    auto readU32 = [&bytes](size_t offset) -> uint32_t {
+        return static_cast<uint32_t>(bytes[offset]) |
+               (static_cast<uint32_t>(bytes[offset + 1]) << 8u) |
+               (static_cast<uint32_t>(bytes[offset + 2]) << 16u) |
+               (static_cast<uint32_t>(bytes[offset + 3]) << 24u);
+    };
+    const uint32_t payloadSize = readU32(8);
+    if (readU32(4) != kModelCacheVersion || bytes.size() < 12ull + payloadSize) {
+        return false;
+    }
+    json root = json::from_msgpack(bytes.begin() + 12, bytes.begin() + 12 + payloadSize, true, false);
+    if (root.is_discarded() || !root.is_object() || !root.contains("meshes") || !root["meshes"].is_array()) {
+        return false;
+    }
+
+    std::vector<std::shared_ptr<Material>> materials;
+    if (root.contains("materials") && root["materials"].is_array()) {
+        for (const auto& material : root["materials"]) {
+            materials.push_back(DeserializeMaterial(material, loader));
+        }
+    }
+
+    ModelCacheEntry entry;
+    for (const auto& meshJson : root["meshes"]) {
+        if (!meshJson.is_object() || !meshJson.contains("data") || !meshJson["data"].is_binary()) {
+            return false;
+        }
+        MeshCacheEntry meshEntry;
+        meshEntry.mesh = DeserializeCookedMeshBinary(meshJson["data"].get_binary());
+        if (!meshEntry.mesh) {
+            return false;
+        }
+        const int material = meshJson.value("material", -1);
+        if (material >= 0 && material < static_cast<int>(materials.size())) {
+            meshEntry.material = materials[static_cast<size_t>(material)];
+        }
+        const int index = meshJson.value("index", -1);
+        if (meshJson.value("merged", false)) {
+            entry.mergedByMaterial[index] = meshEntry;
+        } else {
+            entry.meshesByIndex[index] = meshEntry;
+        }
+    }
+    if (root.contains("skeleton")) {
+        entry.skeleton = DeserializeSkeletonData(root["skeleton"]);
+    }
+    if (root.contains("animations") && root["animations"].is_array()) {
+        for (const auto& clip : root["animations"]) {
+            if (auto animation = DeserializeAnimationClipData(clip)) {
+                entry.animations.push_back(animation);
+            }
+        }
+    }
+    outEntry = std::move(entry);
+    return true;
+}
+
+ModelCacheEntry BuildModelCache(const std::string& path,
+                                const SceneCommands::ModelImportOptions& options,
+                                TextureLoader* loader) {
+    const std::filesystem::path cachePath = ResolveModelCachePath(path, options);
+    ModelCacheEntry cached;
+    if (!cachePath.empty() && LoadModelCache(cachePath, loader, cached)) {
+        return cached;
+    }
+
+    Scene temp("ModelCache");
+    SceneCommands::importModel(&temp, path, options, "ModelCache");
+
+    ModelCacheEntry entry;
+    for (const auto& entityPtr : temp.getAllEntities()) {
+        Entity* entity = entityPtr.get();
+        if (!entity) {
+            continue;
+        }
+        ModelMeshReference* reference = entity->getComponent<ModelMeshReference>();
+        if (!reference) {
+            continue;
+        }
+        MeshRenderer* renderer = entity->getComponent<MeshRenderer>();
+        if (!renderer) {
+            continue;
+        }
+        MeshCacheEntry meshEntry;
+        meshEntry.mesh = renderer->getMesh();
+        meshEntry.material = renderer->getMaterial(0);
+        if (reference->isMerged()) {
+            entry.mergedByMaterial[reference->getMaterialIndex()] = meshEntry;
+        } else {
+            entry.meshesByIndex[reference->getMeshIndex()] = meshEntry;
+        }
+
+        if (reference->isSkinned()) {
+            SkinnedMeshRenderer* skinned = entity->getComponent<SkinnedMeshRenderer>();
+            if (skinned && !entry.skeleton) {
+                entry.skeleton = skinned->getSkeleton();
+                entry.animations = skinned->getAnimationClips();
+            }
+        }
+    }
+    const bool imported = !entry.meshesByIndex.empty() || !entry.mergedByMaterial.empty();
+    if (imported && !cachePath.empty() && !SaveModelCache(cachePath, entry)) {
+        StartupLog("ModelCache write failed for " + path);
+    }
+    return entry;
+}
+
+bool ParseUUID(const std::string& value, UUID& outUUID) {
+    try {
         uint64_t uuidValue = std::stoull(value, nullptr, 16);
         outUUID = UUID(uuidValue);
         return true;
@@ -2579,6 +3459,32 @@ std::unordered_map<std::string, EntityRecord> BuildEntityRecords(Scene* scene,
                                                                  const json& entities,
                                                                  bool preserveUUIDs);
 void ResolveEntityParents(Scene* scene, std::unordered_map<std::string, EntityRecord>& records);
+
+// Inline payloads of one entity's components, decoded ahead of ApplyEntityComponents (see
+// StageScenePayloads). A null or missing entry is decoded in place as before.
+struct StagedEntityPayloads {
+    std::shared_ptr<Mesh> meshRendererMesh;
+    std::shared_ptr<Mesh> hlodMesh;
+    std::shared_ptr<Mesh> skinnedMesh;
+    std::shared_ptr<Skeleton> skeleton;
+    std::vector<std::shared_ptr<AnimationClip>> clips;
+    bool hasClips = false;
+};
+
+// The "assets" table of a cooked scene or cell (see BuildCookedAssetTable), decoded once per file.
+// Meshes, skeletons and clip sets decode while the payloads stage; materials reach the texture
+// loader, so each is built on the engine thread the first time a renderer indexes it and then
+// shared by every renderer that does.
+struct SceneAssetTable {
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    std::vector<std::shared_ptr<Skeleton>> skeletons;
+    std::vector<std::vector<std::shared_ptr<AnimationClip>>> clipSets;
+    json clipData = json::array();
+    json textures = json::array();
+    json materialData = json::array();
+    std::vector<std::shared_ptr<Material>> materials;
+};
+
 void ApplyEntityComponents(Entity* entity,
                            const json& components,
                            Scene* scene,
@@ -2586,7 +3492,9 @@ void ApplyEntityComponents(Entity* entity,
                            TextureLoader* textureLoader,
                            std::unordered_map<std::string, ModelCacheEntry>& modelCache,
                            std::unordered_map<std::string, std::shared_ptr<Mesh>>& cookedMeshCache,
-                           const RuntimeSkinnedBankMap* runtimeSkinnedBanks);
+                           const RuntimeSkinnedBankMap* runtimeSkinnedBanks,
+                           const StagedEntityPayloads* staged = nullptr,
+                           SceneAssetTable* assets = nullptr);
 
 bool EnvEnabled(const char* key) {
     const char* value = std::getenv(key);
@@ -2596,12 +3504,6 @@ bool EnvEnabled(const char* key) {
     return !(value[0] == '0' && value[1] == '\0');
 }
 
-void StartupLog(const std::string& message) {
-    if (EnvEnabled("CRESCENT_RUNTIME_STARTUP_LOG")) {
-        std::cout << "[RuntimeStartup] " << message << std::endl;
-    }
-}
-
 bool HasCookedMeshPayload(const json& components) {
     if (!components.is_object()) {
         return false;
@@ -2629,12 +3531,8 @@ bool HasCookedMeshPayload(const json& components) {
     return false;
 }
 
-bool DeserializeSceneRoot(Scene* scene, const json& root, const std::string& scenePath) {
-    if (!scene || !root.is_object()) {
-        return false;
-    }
-    auto deserializeStart = std::chrono::steady_clock::now();
-
+// Asset root and scene settings, shared by the JSON and flat loaders.
+void ApplySceneMetadata(Scene* scene, const json& root, const std::string& scenePath) {
     if (root.contains("assetRoot")) {
         AssetDatabase& db = AssetDatabase::getInstance();
         std::string rootPath;
@@ -2682,8 +3580,295 @@ bool DeserializeSceneRoot(Scene* scene, const json& root, const std::string& sce
         if (s.contains("staticLighting")) {
             sceneSettings.staticLighting = DeserializeStaticLightingSettings(s["staticLighting"]);
         }
+        if (s.contains("streaming")) {
+            sceneSettings.streaming = DeserializeStreamingSettings(s["streaming"]);
+        }
+        if (s.contains("navigation")) {
+            sceneSettings.navigation = DeserializeNavigationSettings(s["navigation"], scenePath);
+        }
     }
     scene->setSettings(sceneSettings);
+}
+
+RuntimeSkinnedBankMap ReadRuntimeSkinnedBanks(const json& root) {
+    RuntimeSkinnedBankMap banks;
+    if (root.contains("runtimeSkinnedBanks") && root["runtimeSkinnedBanks"].is_object()) {
+        for (auto it = root["runtimeSkinnedBanks"].begin(); it != root["runtimeSkinnedBanks"].end(); ++it) {
+            banks[it.key()] = it.value();
+        }
+    }
+    return banks;
+}
+
+// Partitioned scenes only hold their persistent entities; the cells stream in from the first
+// update. Returns the number of cells.
+size_t ConfigureSceneStreaming(Scene* scene, const json& root, const std::string& scenePath) {
+    if (!root.contains("worldPartition") || !root["worldPartition"].is_object()) {
+        return 0;
+    }
+    const json& partition = root["worldPartition"];
+    SceneStreamingSettings streaming = DeserializeStreamingSettings(partition);
+    streaming.enabled = true;
+    std::vector<SceneStreamingCell> cells;
+    if (partition.contains("cells") && partition["cells"].is_array()) {
+        for (const auto& c : partition["cells"]) {
+            SceneStreamingCell cell;
+            cell.x = c.value("x", 0);
+            cell.z = c.value("z", 0);
+            cell.path = c.value("path", std::string());
+            cell.boundsMin = JsonToVec3(c.value("boundsMin", json::array()));
+            cell.boundsMax = JsonToVec3(c.value("boundsMax", json::array()));
+            cell.entityCount = c.value("entityCount", 0u);
+            if (!cell.path.empty()) {
+                cells.push_back(std::move(cell));
+            }
+        }
+    }
+    scene->getStreamer()->configure(streaming, cells, scenePath);
+    return cells.size();
+}
+
+// Splits [0, count) across the shared scheduler's workers; the calling thread takes the first
+// chunk and waits for the rest.
+template <typename Body>
+void ParallelRanges(size_t count, size_t minChunk, const Body& body) {
+    if (count == 0) {
+        return;
+    }
+    JobScheduler& scheduler = JobScheduler::getInstance();
+    const size_t workers = scheduler.isRunning() ? scheduler.workerCount() : 0;
+    const size_t chunks = std::max<size_t>(1, std::min(workers + 1, count / std::max<size_t>(1, minChunk)));
+    if (chunks == 1) {
+        body(size_t(0), count);
+        return;
+    }
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+    auto fence = std::make_shared<JobFence>();
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        const size_t begin = chunk * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        if (begin >= end) {
+            break;
+        }
+        fence->remaining.fetch_add(1, std::memory_order_relaxed);
+        scheduler.schedule([&body, begin, end]() { body(begin, end); }, fence);
+    }
+    body(size_t(0), std::min(count, chunkSize));
+    scheduler.wait(*fence);
+}
+
+// Maps and decodes every cooked mesh the components reference into cookedMeshCache, one mesh
+// per job, so ApplyEntityComponents only finds them there. Each mesh takes the residency of its
+// first ref, as LoadCookedMeshRef would have given it.
+void PrefetchCookedMeshes(const std::vector<const json*>& components,
+                          const std::string& scenePath,
+                          std::unordered_map<std::string, std::shared_ptr<Mesh>>& cookedMeshCache) {
+    std::vector<std::pair<std::string, MeshResidency>> pending;
+    std::unordered_set<std::string> seen;
+    for (const json* entity : components) {
+        if (!entity || !entity->is_object()) {
+            continue;
+        }
+        for (const char* key : {"MeshRenderer", "HLODProxy", "SkinnedMeshRenderer"}) {
+            if (!entity->contains(key) || !(*entity)[key].is_object() || !(*entity)[key].contains("meshRef")) {
+                continue;
+            }
+            std::string path;
+            MeshResidency residency = MeshResidency::Reloadable;
+            if (ParseCookedMeshRef((*entity)[key]["meshRef"], scenePath, path, residency) &&
+                cookedMeshCache.find(path) == cookedMeshCache.end() && seen.insert(path).second) {
+                pending.emplace_back(std::move(path), residency);
+            }
+        }
+    }
+
+    std::vector<std::shared_ptr<Mesh>> meshes(pending.size());
+    ParallelRanges(pending.size(), 1, [&pending, &meshes](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            meshes[i] = AcquireCookedMesh(pending[i].first, pending[i].second);
+        }
+    });
+    for (size_t i = 0; i < pending.size(); ++i) {
+        if (meshes[i]) {
+            cookedMeshCache[pending[i].first] = meshes[i];
+        }
+    }
+}
+
+bool AssetTableIndex(const json& value, size_t count, size_t& outIndex) {
+    if (!value.is_number_unsigned()) {
+        return false;
+    }
+    outIndex = value.get<size_t>();
+    return outIndex < count;
+}
+
+std::vector<std::shared_ptr<AnimationClip>> DecodeClipSet(const json& clips) {
+    std::vector<std::shared_ptr<AnimationClip>> decoded;
+    if (!clips.is_array()) {
+        return decoded;
+    }
+    decoded.reserve(clips.size());
+    for (const auto& clipData : clips) {
+        decoded.push_back(DeserializeAnimationClipData(clipData));
+    }
+    return decoded;
+}
+
+// Decodes the table's meshes, skeletons and clip sets, one job per entry.
+void ReadSceneAssetTable(const json& root, const std::string& scenePath, SceneAssetTable& table) {
+    if (!root.contains("assets") || !root["assets"].is_object()) {
+        return;
+    }
+    const json& assets = root["assets"];
+    static const json kEmpty = json::array();
+    auto section = [&assets](const char* key) -> const json& {
+        return assets.contains(key) && assets[key].is_array() ? assets[key] : kEmpty;
+    };
+    const json& meshRefs = section("meshes");
+    const json& skeletons = section("skeletons");
+    table.clipData = section("clipSets");
+    table.textures = section("textures");
+    table.materialData = section("materials");
+    table.meshes.assign(meshRefs.size(), nullptr);
+    table.skeletons.assign(skeletons.size(), nullptr);
+    table.clipSets.assign(table.clipData.size(), {});
+    table.materials.assign(table.materialData.size(), nullptr);
+
+    const size_t meshCount = meshRefs.size();
+    const size_t skeletonEnd = meshCount + skeletons.size();
+    ParallelRanges(skeletonEnd + table.clipData.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (i < meshCount) {
+                std::string path;
+                MeshResidency residency = MeshResidency::Reloadable;
+                if (ParseCookedMeshRef(meshRefs[i], scenePath, path, residency)) {
+                    table.meshes[i] = AcquireCookedMesh(path, residency);
+                }
+            } else if (i < skeletonEnd) {
+                table.skeletons[i - meshCount] = DeserializeSkeletonData(skeletons[i - meshCount]);
+            } else {
+                table.clipSets[i - skeletonEnd] = DecodeClipSet(table.clipData[i - skeletonEnd]);
+            }
+        }
+    });
+}
+
+std::shared_ptr<Mesh> AssetTableMesh(const SceneAssetTable* assets, const json& component) {
+    size_t index = 0;
+    if (!assets || !component.contains("meshAsset") ||
+        !AssetTableIndex(component["meshAsset"], assets->meshes.size(), index)) {
+        return nullptr;
+    }
+    return assets->meshes[index];
+}
+
+std::shared_ptr<Material> AssetTableMaterial(SceneAssetTable* assets, const json& value, TextureLoader* loader) {
+    size_t index = 0;
+    if (!assets || !AssetTableIndex(value, assets->materials.size(), index)) {
+        return Material::CreateDefault();
+    }
+    if (!assets->materials[index]) {
+        // Texture slots hold indices into the table; DeserializeMaterial takes the entries back.
+        json material = assets->materialData[index];
+        if (material.contains("textures") && material["textures"].is_object()) {
+            json textures = json::object();
+            for (auto it = material["textures"].begin(); it != material["textures"].end(); ++it) {
+                size_t texture = 0;
+                if (AssetTableIndex(it.value(), assets->textures.size(), texture)) {
+                    textures[it.key()] = assets->textures[texture];
+                }
+            }
+            material["textures"] = std::move(textures);
+        }
+        assets->materials[index] = DeserializeMaterial(material, loader);
+    }
+    return assets->materials[index];
+}
+
+StagedEntityPayloads StageEntityPayloads(const json& components,
+                                         const RuntimeSkinnedBankMap* runtimeSkinnedBanks,
+                                         const SceneAssetTable* assets) {
+    StagedEntityPayloads staged;
+    if (!components.is_object()) {
+        return staged;
+    }
+    if (components.contains("MeshRenderer")) {
+        const json& r = components["MeshRenderer"];
+        if (!r.contains("meshRef") && r.contains("mesh")) {
+            staged.meshRendererMesh = DeserializeMeshData(r["mesh"]);
+        }
+    }
+    if (components.contains("HLODProxy")) {
+        const json& h = components["HLODProxy"];
+        if (!h.contains("meshRef") && h.contains("mesh")) {
+            staged.hlodMesh = DeserializeMeshData(h["mesh"]);
+        }
+    }
+    if (components.contains("SkinnedMeshRenderer")) {
+        const json& s = components["SkinnedMeshRenderer"];
+        if (!s.contains("meshRef") && s.contains("mesh")) {
+            staged.skinnedMesh = DeserializeMeshData(s["mesh"]);
+        }
+        size_t index = 0;
+        if (assets && s.contains("skeletonAsset") &&
+            AssetTableIndex(s["skeletonAsset"], assets->skeletons.size(), index)) {
+            staged.skeleton = assets->skeletons[index];
+        }
+        if (assets && s.contains("clipsAsset") && AssetTableIndex(s["clipsAsset"], assets->clipSets.size(), index)) {
+            // Clip events are written into the clips, so an entity that sets any decodes its own.
+            staged.clips = s.contains("clipEvents") ? DecodeClipSet(assets->clipData[index]) : assets->clipSets[index];
+            staged.hasClips = true;
+        }
+        const json* payload = &s;
+        if (s.contains("runtimeBankRef") && runtimeSkinnedBanks) {
+            auto bankIt = runtimeSkinnedBanks->find(s.value("runtimeBankRef", std::string()));
+            if (bankIt != runtimeSkinnedBanks->end()) {
+                payload = &bankIt->second;
+            }
+        }
+        // Banks from before the asset table give every entity its own skeleton and clips, as in
+        // place.
+        if (payload->contains("skeleton")) {
+            staged.skeleton = DeserializeSkeletonData((*payload)["skeleton"]);
+        }
+        if (payload->contains("animationClips") && (*payload)["animationClips"].is_array()) {
+            staged.clips = DecodeClipSet((*payload)["animationClips"]);
+            staged.hasClips = true;
+        }
+    }
+    return staged;
+}
+
+// Phase one of a scene load: decodes what the components carry without touching the scene or the
+// texture loader, spread over the job scheduler. Cooked meshes land in cookedMeshCache and inline
+// meshes, skeletons and clips in one stage per entity; phase two, ApplyEntityComponents on the
+// engine thread, only attaches them. Materials stay in phase two since their textures already
+// load asynchronously. A cooked file's asset table is read first with ReadSceneAssetTable.
+std::vector<StagedEntityPayloads> StageScenePayloads(const std::vector<const json*>& components,
+                                                     const std::string& scenePath,
+                                                     std::unordered_map<std::string, std::shared_ptr<Mesh>>& cookedMeshCache,
+                                                     const RuntimeSkinnedBankMap* runtimeSkinnedBanks,
+                                                     const SceneAssetTable* assets) {
+    PrefetchCookedMeshes(components, scenePath, cookedMeshCache);
+    std::vector<StagedEntityPayloads> staged(components.size());
+    ParallelRanges(components.size(), 32, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (components[i]) {
+                staged[i] = StageEntityPayloads(*components[i], runtimeSkinnedBanks, assets);
+            }
+        }
+    });
+    return staged;
+}
+
+bool DeserializeSceneRoot(Scene* scene, const json& root, const std::string& scenePath) {
+    if (!scene || !root.is_object()) {
+        return false;
+    }
+    auto deserializeStart = std::chrono::steady_clock::now();
+
+    ApplySceneMetadata(scene, root, scenePath);
 
     bool wasActive = scene->isActive();
     if (wasActive) {
@@ -2694,6 +3879,10 @@ bool DeserializeSceneRoot(Scene* scene, const json& root, const std::string& sce
     if (root.contains("name")) {
         scene->setName(root.value("name", scene->getName()));
     }
+    {
+        Renderer* renderer = Engine::getInstance().getRenderer();
+        PrepareTexturePlacement(root, renderer ? renderer->getTextureLoader() : nullptr);
+    }
 
     auto records = BuildEntityRecords(scene,
                                       root.contains("entities") && root["entities"].is_array()
@@ -2702,71 +3891,1004 @@ bool DeserializeSceneRoot(Scene* scene, const json& root, const std::string& sce
                                       true);
     ResolveEntityParents(scene, records);
 
-    Renderer* renderer = Engine::getInstance().getRenderer();
-    TextureLoader* textureLoader = renderer ? renderer->getTextureLoader() : nullptr;
-    std::unordered_map<std::string, ModelCacheEntry> modelCache;
-    std::unordered_map<std::string, std::shared_ptr<Mesh>> cookedMeshCache;
-    RuntimeSkinnedBankMap runtimeSkinnedBanks;
+    Renderer* renderer = Engine::getInstance().getRenderer();
+    TextureLoader* textureLoader = renderer ? renderer->getTextureLoader() : nullptr;
+    std::unordered_map<std::string, ModelCacheEntry> modelCache;
+    std::unordered_map<std::string, std::shared_ptr<Mesh>> cookedMeshCache;
+    RuntimeSkinnedBankMap runtimeSkinnedBanks = ReadRuntimeSkinnedBanks(root);
+
+    std::vector<EntityRecord*> ordered;
+    std::vector<const json*> components;
+    ordered.reserve(records.size());
+    components.reserve(records.size());
+    for (auto& [uuid, record] : records) {
+        if (record.entity) {
+            ordered.push_back(&record);
+            components.push_back(&record.components);
+        }
+    }
+    auto stageStart = std::chrono::steady_clock::now();
+    SceneAssetTable assets;
+    ReadSceneAssetTable(root, scenePath, assets);
+    std::vector<StagedEntityPayloads> staged = StageScenePayloads(components, scenePath, cookedMeshCache,
+                                                                  &runtimeSkinnedBanks, &assets);
+    const auto applyStart = std::chrono::steady_clock::now();
+    auto stageMs = std::chrono::duration_cast<std::chrono::milliseconds>(applyStart - stageStart).count();
+    StartupTrace::getInstance().addSpan("scene", "Stage scene payloads", stageStart, applyStart);
+
+    for (size_t i = 0; i < ordered.size(); ++i) {
+        EntityRecord& record = *ordered[i];
+        record.entity->setEditorOnly(record.editorOnly);
+        ApplyEntityComponents(record.entity, record.components, scene, scenePath, textureLoader, modelCache, cookedMeshCache,
+                              &runtimeSkinnedBanks, &staged[i], &assets);
+    }
+    StartupTrace::getInstance().addSpan("scene", "Apply scene components", applyStart, std::chrono::steady_clock::now(),
+                                        std::to_string(ordered.size()) + " entities");
+    const size_t appliedEntityCount = ordered.size();
+
+    if (wasActive) {
+        scene->setActive(true);
+    }
+
+    for (auto& [uuid, record] : records) {
+        if (record.entity && !record.active) {
+            record.entity->setActive(false);
+        }
+    }
+
+    const size_t streamedCells = ConfigureSceneStreaming(scene, root, scenePath);
+
+    auto deserializeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - deserializeStart).count();
+    StartupLog("DeserializeSceneRoot entities=" + std::to_string(appliedEntityCount) +
+               " stage=" + std::to_string(stageMs) + "ms" +
+               " modelCaches=" + std::to_string(modelCache.size()) +
+               " cookedMeshes=" + std::to_string(cookedMeshCache.size() + assets.meshes.size()) +
+               " sharedMaterials=" + std::to_string(assets.materials.size()) +
+               " streamedCells=" + std::to_string(streamedCells) +
+               " in " + std::to_string(deserializeMs) + "ms");
+    return true;
+}
+
+// Cooked runtime scenes and world partition cells are stored flat so they can be read in place
+// from a mapping: a header, a table of fixed-size entity records holding the hierarchy and the
+// local transform, a string table of names, one msgpack blob per entity with its remaining
+// components, and one blob of scene-level data (settings, asset root, asset table, partition).
+// Only the blobs are decoded, each on its own and in parallel, so a load never builds a DOM of
+// the whole scene. Bump the version when a record changes.
+constexpr char kFlatSceneMagic[4] = {'C', 'S', 'C', 'N'};
+constexpr uint32_t kFlatSceneVersion = 1;
+
+struct FlatSceneHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entityCount;
+    uint32_t reserved;
+    uint64_t entityTableOffset;
+    uint64_t stringTableOffset;
+    uint64_t stringTableSize;
+    uint64_t metadataOffset;
+    uint64_t metadataSize;
+    uint64_t fileSize;
+};
+static_assert(sizeof(FlatSceneHeader) == 64, "FlatSceneHeader layout is part of the file format");
+
+enum FlatSceneEntityFlags : uint32_t {
+    FlatEntityActive = 1u << 0,
+    FlatEntityEditorOnly = 1u << 1,
+    FlatEntityHasParent = 1u << 2,
+    FlatEntityHasTransform = 1u << 3
+};
+
+struct FlatSceneEntity {
+    uint64_t uuid;             // 0 lets the loader assign one
+    uint64_t parentUUID;
+    int32_t parentIndex;       // -1 when the parent is not in this table
+    uint32_t flags;            // FlatSceneEntityFlags
+    uint32_t nameOffset;
+    uint32_t nameSize;
+    float position[3];
+    float rotation[4];
+    float scale[3];
+    uint64_t componentsOffset; // 0 for entities with nothing but a transform
+    uint64_t componentsSize;
+};
+static_assert(sizeof(FlatSceneEntity) == 88, "FlatSceneEntity layout is part of the file format");
+
+bool IsFlatScene(const uint8_t* data, size_t size) {
+    return data && size >= sizeof(FlatSceneHeader) && std::memcmp(data, kFlatSceneMagic, 4) == 0;
+}
+
+// Takes the scene JSON by value: entity components are moved into their blobs.
+std::vector<uint8_t> EncodeFlatScene(json root) {
+    json entities = json::array();
+    if (root.contains("entities") && root["entities"].is_array()) {
+        entities = std::move(root["entities"]);
+    }
+    root.erase("entities");
+
+    std::unordered_map<std::string, int32_t> indexByUUID;
+    for (size_t i = 0; i < entities.size(); ++i) {
+        indexByUUID[entities[i].value("uuid", std::string())] = static_cast<int32_t>(i);
+    }
+
+    std::vector<FlatSceneEntity> records(entities.size());
+    std::string strings;
+    std::vector<std::vector<uint8_t>> blobs(entities.size());
+    for (size_t i = 0; i < entities.size(); ++i) {
+        json& e = entities[i];
+        FlatSceneEntity& record = records[i];
+        std::memset(&record, 0, sizeof(record));
+        record.parentIndex = -1;
+        if (!e.is_object()) {
+            continue;
+        }
+        record.uuid = static_cast<uint64_t>(UUID::fromString(e.value("uuid", std::string())));
+        const std::string parent = e.value("parent", std::string());
+        if (!parent.empty()) {
+            record.flags |= FlatEntityHasParent;
+            record.parentUUID = static_cast<uint64_t>(UUID::fromString(parent));
+            auto parentIt = indexByUUID.find(parent);
+            if (parentIt != indexByUUID.end()) {
+                record.parentIndex = parentIt->second;
+            }
+        }
+        if (e.value("active", true)) {
+            record.flags |= FlatEntityActive;
+        }
+        if (e.value("editorOnly", false)) {
+            record.flags |= FlatEntityEditorOnly;
+        }
+        const std::string name = e.value("name", std::string("Entity"));
+        record.nameOffset = static_cast<uint32_t>(strings.size());
+        record.nameSize = static_cast<uint32_t>(name.size());
+        strings += name;
+
+        json components = e.contains("components") && e["components"].is_object()
+            ? std::move(e["components"])
+            : json::object();
+        if (components.contains("Transform")) {
+            const json& t = components["Transform"];
+            const Math::Vector3 position = JsonToVec3(t.value("position", json::array()));
+            const Math::Quaternion rotation = JsonToQuat(t.value("rotation", json::array()));
+            const Math::Vector3 scale = JsonToVec3(t.value("scale", json::array()), Math::Vector3(1.0f));
+            const float values[] = {position.x, position.y, position.z,
+                                    rotation.x, rotation.y, rotation.z, rotation.w,
+                                    scale.x, scale.y, scale.z};
+            std::memcpy(record.position, values, sizeof(values));
+            record.flags |= FlatEntityHasTransform;
+            components.erase("Transform");
+        }
+        if (!components.empty()) {
+            blobs[i] = json::to_msgpack(components);
+        }
+    }
+    std::vector<uint8_t> metadata = json::to_msgpack(root);
+
+    // Sections are 16-byte aligned; the entity table only needs 8.
+    FlatSceneHeader header{};
+    std::memcpy(header.magic, kFlatSceneMagic, 4);
+    header.version = kFlatSceneVersion;
+    header.entityCount = static_cast<uint32_t>(records.size());
+    CookedMeshBinaryWriter writer;
+    writer.writeBytes(&header, sizeof(header));
+    writer.alignTo(16);
+    header.entityTableOffset = writer.bytes().size();
+    const size_t tableSize = records.size() * sizeof(FlatSceneEntity);
+    std::vector<uint8_t> placeholder(tableSize, 0);
+    writer.writeBytes(placeholder.data(), placeholder.size());
+    writer.alignTo(16);
+    header.stringTableOffset = writer.bytes().size();
+    header.stringTableSize = strings.size();
+    writer.writeBytes(strings.data(), strings.size());
+    for (size_t i = 0; i < blobs.size(); ++i) {
+        if (blobs[i].empty()) {
+            continue;
+        }
+        writer.alignTo(16);
+        records[i].componentsOffset = writer.bytes().size();
+        records[i].componentsSize = blobs[i].size();
+        writer.writeBytes(blobs[i].data(), blobs[i].size());
+    }
+    writer.alignTo(16);
+    header.metadataOffset = writer.bytes().size();
+    header.metadataSize = metadata.size();
+    writer.writeBytes(metadata.data(), metadata.size());
+
+    std::vector<uint8_t> bytes = writer.bytes();
+    header.fileSize = bytes.size();
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    if (tableSize > 0) {
+        std::memcpy(bytes.data() + header.entityTableOffset, records.data(), tableSize);
+    }
+    return bytes;
+}
+
+// A validated flat scene, pointing into bytes owned by the caller.
+struct FlatSceneView {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    const FlatSceneHeader* header = nullptr;
+    const FlatSceneEntity* entities = nullptr;
+    const char* strings = nullptr;
+
+    size_t entityCount() const { return header ? header->entityCount : 0; }
+    std::string name(const FlatSceneEntity& entity) const {
+        return std::string(strings + entity.nameOffset, entity.nameSize);
+    }
+};
+
+bool OpenFlatScene(const uint8_t* data, size_t size, FlatSceneView& outView) {
+    if (!IsFlatScene(data, size) || reinterpret_cast<uintptr_t>(data) % alignof(FlatSceneEntity) != 0) {
+        return false;
+    }
+    const FlatSceneHeader* header = reinterpret_cast<const FlatSceneHeader*>(data);
+    if (header->version != kFlatSceneVersion || header->fileSize != size) {
+        StartupLog("OpenFlatScene unsupported version " + std::to_string(header->version));
+        return false;
+    }
+    auto inRange = [size](uint64_t offset, uint64_t length) {
+        return offset <= size && length <= size - offset;
+    };
+    const uint64_t tableSize = static_cast<uint64_t>(header->entityCount) * sizeof(FlatSceneEntity);
+    if (!inRange(header->entityTableOffset, tableSize) || header->entityTableOffset % alignof(FlatSceneEntity) != 0 ||
+        !inRange(header->stringTableOffset, header->stringTableSize) ||
+        !inRange(header->metadataOffset, header->metadataSize)) {
+        return false;
+    }
+    const FlatSceneEntity* entities = reinterpret_cast<const FlatSceneEntity*>(data + header->entityTableOffset);
+    for (uint32_t i = 0; i < header->entityCount; ++i) {
+        const FlatSceneEntity& entity = entities[i];
+        if (static_cast<uint64_t>(entity.nameOffset) + entity.nameSize > header->stringTableSize ||
+            !inRange(entity.componentsOffset, entity.componentsSize) ||
+            entity.parentIndex >= static_cast<int32_t>(header->entityCount)) {
+            return false;
+        }
+    }
+    outView.data = data;
+    outView.size = size;
+    outView.header = header;
+    outView.entities = entities;
+    outView.strings = reinterpret_cast<const char*>(data + header->stringTableOffset);
+    return true;
+}
+
+json DecodeFlatSceneMetadata(const FlatSceneView& view) {
+    if (view.header->metadataSize == 0) {
+        return json::object();
+    }
+    const uint8_t* begin = view.data + view.header->metadataOffset;
+    return json::from_msgpack(begin, begin + view.header->metadataSize, true, false);
+}
+
+// Entities without a blob, or with one that fails to decode, get an empty object.
+std::vector<json> DecodeFlatSceneComponents(const FlatSceneView& view) {
+    std::vector<json> components(view.entityCount());
+    ParallelRanges(components.size(), 64, [&view, &components](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const FlatSceneEntity& entity = view.entities[i];
+            if (entity.componentsSize == 0) {
+                components[i] = json::object();
+                continue;
+            }
+            const uint8_t* blob = view.data + entity.componentsOffset;
+            json decoded = json::from_msgpack(blob, blob + entity.componentsSize, true, false);
+            components[i] = decoded.is_object() ? std::move(decoded) : json::object();
+        }
+    });
+    return components;
+}
+
+void ApplyFlatTransform(Entity* entity, const FlatSceneEntity& record) {
+    if (!(record.flags & FlatEntityHasTransform)) {
+        return;
+    }
+    Transform* transform = entity->getTransform();
+    transform->setLocalPosition(Math::Vector3(record.position[0], record.position[1], record.position[2]));
+    transform->setLocalRotation(Math::Quaternion(record.rotation[0], record.rotation[1], record.rotation[2], record.rotation[3]));
+    transform->setLocalScale(Math::Vector3(record.scale[0], record.scale[1], record.scale[2]));
+}
+
+Entity* CreateFlatSceneEntity(Scene* scene, const FlatSceneView& view, const FlatSceneEntity& record) {
+    const std::string name = view.name(record);
+    return record.uuid != 0 ? scene->createEntityWithUUID(UUID(record.uuid), name) : scene->createEntity(name);
+}
+
+bool DeserializeFlatScene(Scene* scene, const uint8_t* data, size_t size, const std::string& scenePath) {
+    FlatSceneView view;
+    if (!scene || !OpenFlatScene(data, size, view)) {
+        return false;
+    }
+    auto deserializeStart = std::chrono::steady_clock::now();
+    json metadata = DecodeFlatSceneMetadata(view);
+    if (metadata.is_discarded() || !metadata.is_object()) {
+        return false;
+    }
+    std::vector<json> components = DecodeFlatSceneComponents(view);
+    const auto decodeEnd = std::chrono::steady_clock::now();
+    auto decodeMs = std::chrono::duration_cast<std::chrono::milliseconds>(decodeEnd - deserializeStart).count();
+    StartupTrace::getInstance().addSpan("scene", "Decode flat scene", deserializeStart, decodeEnd);
+
+    ApplySceneMetadata(scene, metadata, scenePath);
+
+    bool wasActive = scene->isActive();
+    if (wasActive) {
+        scene->setActive(false);
+    }
+    scene->destroyAllEntities();
+    if (metadata.contains("name")) {
+        scene->setName(metadata.value("name", scene->getName()));
+    }
+    {
+        Renderer* renderer = Engine::getInstance().getRenderer();
+        PrepareTexturePlacement(metadata, renderer ? renderer->getTextureLoader() : nullptr);
+    }
+
+    const size_t count = view.entityCount();
+    std::vector<Entity*> entities(count, nullptr);
+    for (size_t i = 0; i < count; ++i) {
+        entities[i] = CreateFlatSceneEntity(scene, view, view.entities[i]);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const FlatSceneEntity& record = view.entities[i];
+        if (!entities[i] || !(record.flags & FlatEntityHasParent)) {
+            continue;
+        }
+        Entity* parent = record.parentIndex >= 0 ? entities[static_cast<size_t>(record.parentIndex)]
+                                                 : scene->findEntity(UUID(record.parentUUID));
+        if (parent) {
+            entities[i]->getTransform()->setParent(parent->getTransform(), false);
+        }
+    }
+
+    Renderer* renderer = Engine::getInstance().getRenderer();
+    TextureLoader* textureLoader = renderer ? renderer->getTextureLoader() : nullptr;
+    std::unordered_map<std::string, ModelCacheEntry> modelCache;
+    std::unordered_map<std::string, std::shared_ptr<Mesh>> cookedMeshCache;
+    RuntimeSkinnedBankMap runtimeSkinnedBanks = ReadRuntimeSkinnedBanks(metadata);
+    std::vector<const json*> componentRefs(count, nullptr);
+    for (size_t i = 0; i < count; ++i) {
+        if (entities[i]) {
+            componentRefs[i] = &components[i];
+        }
+    }
+    auto stageStart = std::chrono::steady_clock::now();
+    SceneAssetTable assets;
+    ReadSceneAssetTable(metadata, scenePath, assets);
+    std::vector<StagedEntityPayloads> staged = StageScenePayloads(componentRefs, scenePath, cookedMeshCache,
+                                                                  &runtimeSkinnedBanks, &assets);
+    const auto applyStart = std::chrono::steady_clock::now();
+    auto stageMs = std::chrono::duration_cast<std::chrono::milliseconds>(applyStart - stageStart).count();
+    StartupTrace::getInstance().addSpan("scene", "Stage scene payloads", stageStart, applyStart);
+    for (size_t i = 0; i < count; ++i) {
+        if (!entities[i]) {
+            continue;
+        }
+        entities[i]->setEditorOnly((view.entities[i].flags & FlatEntityEditorOnly) != 0);
+        ApplyFlatTransform(entities[i], view.entities[i]);
+        ApplyEntityComponents(entities[i], components[i], scene, scenePath, textureLoader, modelCache, cookedMeshCache,
+                              &runtimeSkinnedBanks, &staged[i], &assets);
+    }
+    StartupTrace::getInstance().addSpan("scene", "Apply scene components", applyStart, std::chrono::steady_clock::now(),
+                                        std::to_string(count) + " entities");
+
+    if (wasActive) {
+        scene->setActive(true);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (entities[i] && !(view.entities[i].flags & FlatEntityActive)) {
+            entities[i]->setActive(false);
+        }
+    }
+
+    const size_t streamedCells = ConfigureSceneStreaming(scene, metadata, scenePath);
+
+    auto deserializeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - deserializeStart).count();
+    StartupLog("DeserializeFlatScene entities=" + std::to_string(count) +
+               " decode=" + std::to_string(decodeMs) + "ms" +
+               " stage=" + std::to_string(stageMs) + "ms" +
+               " cookedMeshes=" + std::to_string(cookedMeshCache.size() + assets.meshes.size()) +
+               " sharedMaterials=" + std::to_string(assets.materials.size()) +
+               " streamedCells=" + std::to_string(streamedCells) +
+               " in " + std::to_string(deserializeMs) + "ms");
+    return true;
+}
+
+std::string ResolveSceneLoadPath(const std::string& path) {
+    if (path.empty()) {
+        return path;
+    }
+
+    std::filesystem::path source(path);
+    if (source.extension() == ".ccscene") {
+        return path;
+    }
+
+    if (!EnvEnabled("CRESCENT_PREFER_COOKED_SCENES") && !EnvEnabled("CRESCENT_REQUIRE_COOKED_SCENES")) {
+        return path;
+    }
+
+    std::filesystem::path cooked = source;
+    cooked.replace_extension(".ccscene");
+    std::error_code ec;
+    if (std::filesystem::exists(cooked, ec)) {
+        return cooked.string();
+    }
+
+    if (EnvEnabled("CRESCENT_REQUIRE_COOKED_SCENES")) {
+        return "";
+    }
+    return path;
+}
+
+// Gathers what BuildSceneJson writes per component into one table per cooked file. Mesh refs are
+// keyed on their path and textures and materials on their contents, so renderers that share an
+// asset share one entry; skinned banks split into a skeleton and a clip set.
+struct CookedAssetTableBuilder {
+    json meshes = json::array();
+    json textures = json::array();
+    json materials = json::array();
+    json skeletons = json::array();
+    json clipSets = json::array();
+    std::unordered_map<std::string, size_t> meshIndex;
+    std::unordered_map<std::string, size_t> textureIndex;
+    std::unordered_map<std::string, size_t> materialIndex;
+    std::unordered_map<std::string, std::pair<json, json>> bankIndex;
+
+    size_t addMesh(const json& meshRef) {
+        std::string path = meshRef.is_object() ? meshRef.value("path", std::string())
+                                               : meshRef.is_string() ? meshRef.get<std::string>() : std::string();
+        const bool gpuOnly = meshRef.is_object() && meshRef.value("residency", std::string()) == "gpu";
+        auto it = meshIndex.find(path);
+        if (it != meshIndex.end()) {
+            // A mesh shared with a ref that may read it back stays reloadable.
+            if (!gpuOnly) {
+                meshes[it->second].erase("residency");
+            }
+            return it->second;
+        }
+        json entry = {{"path", path}};
+        if (gpuOnly) {
+            entry["residency"] = "gpu";
+        }
+        meshIndex.emplace(std::move(path), meshes.size());
+        meshes.push_back(std::move(entry));
+        return meshes.size() - 1;
+    }
+
+    size_t addTexture(const json& ref) {
+        auto [it, inserted] = textureIndex.emplace(ref.dump(), textures.size());
+        if (inserted) {
+            textures.push_back(ref);
+        }
+        return it->second;
+    }
+
+    size_t addMaterial(json material) {
+        if (material.contains("textures") && material["textures"].is_object()) {
+            for (auto it = material["textures"].begin(); it != material["textures"].end(); ++it) {
+                it.value() = addTexture(it.value());
+            }
+        }
+        auto [it, inserted] = materialIndex.emplace(material.dump(), materials.size());
+        if (inserted) {
+            materials.push_back(std::move(material));
+        }
+        return it->second;
+    }
+
+    // Returns the skeleton and clip set indices of a bank, null where it has none.
+    const std::pair<json, json>& addBank(const std::string& key, const json& bank) {
+        auto it = bankIndex.find(key);
+        if (it != bankIndex.end()) {
+            return it->second;
+        }
+        std::pair<json, json> entry;
+        if (bank.contains("skeleton")) {
+            entry.first = skeletons.size();
+            skeletons.push_back(bank["skeleton"]);
+        }
+        if (bank.contains("animationClips") && bank["animationClips"].is_array()) {
+            entry.second = clipSets.size();
+            clipSets.push_back(bank["animationClips"]);
+        }
+        return bankIndex.emplace(key, std::move(entry)).first->second;
+    }
+};
+
+// Moves the cooked mesh refs, materials and skinned banks of root["entities"] into root["assets"]
+// and points the components at them by index ("meshAsset", "materialAssets", "skeletonAsset",
+// "clipsAsset"), so each shared asset is stored once and decoded once at load. Runs on the scene
+// and on every partition cell, which get tables of their own.
+void BuildCookedAssetTable(json& root) {
+    if (!root.contains("entities") || !root["entities"].is_array()) {
+        return;
+    }
+    CookedAssetTableBuilder table;
+    const json banks = root.contains("runtimeSkinnedBanks") ? root["runtimeSkinnedBanks"] : json::object();
+    for (json& entity : root["entities"]) {
+        if (!entity.contains("components") || !entity["components"].is_object()) {
+            continue;
+        }
+        json& components = entity["components"];
+        for (const char* key : {"MeshRenderer", "HLODProxy", "SkinnedMeshRenderer"}) {
+            if (components.contains(key) && components[key].is_object() && components[key].contains("meshRef")) {
+                json& component = components[key];
+                component["meshAsset"] = table.addMesh(component["meshRef"]);
+                component.erase("meshRef");
+            }
+        }
+        if (components.contains("MeshRenderer") && components["MeshRenderer"].contains("materials") &&
+            components["MeshRenderer"]["materials"].is_array()) {
+            json& renderer = components["MeshRenderer"];
+            json indices = json::array();
+            for (json& material : renderer["materials"]) {
+                indices.push_back(table.addMaterial(std::move(material)));
+            }
+            renderer["materialAssets"] = std::move(indices);
+            renderer.erase("materials");
+        }
+        if (components.contains("SkinnedMeshRenderer") && components["SkinnedMeshRenderer"].contains("runtimeBankRef")) {
+            json& skinned = components["SkinnedMeshRenderer"];
+            const std::string key = skinned.value("runtimeBankRef", std::string());
+            if (banks.contains(key)) {
+                const auto& [skeleton, clips] = table.addBank(key, banks[key]);
+                if (!skeleton.is_null()) {
+                    skinned["skeletonAsset"] = skeleton;
+                }
+                if (!clips.is_null()) {
+                    skinned["clipsAsset"] = clips;
+                }
+                skinned.erase("runtimeBankRef");
+            }
+        }
+    }
+    root.erase("runtimeSkinnedBanks");
+    if (table.meshes.empty() && table.materials.empty() && table.skeletons.empty() && table.clipSets.empty()) {
+        return;
+    }
+    root["assets"] = {
+        {"meshes", std::move(table.meshes)},
+        {"textures", std::move(table.textures)},
+        {"materials", std::move(table.materials)},
+        {"skeletons", std::move(table.skeletons)},
+        {"clipSets", std::move(table.clipSets)}
+    };
+}
+
+// Hierarchies with any of these stay in the scene file: gameplay and cameras may be looked up
+// from anywhere, skinned meshes share the scene's bone banks, and HLOD proxies stand in for the
+// cells that are not loaded.
+bool IsStreamableEntity(const json& components) {
+    static const char* const kPinnedComponents[] = {
+        "Camera", "CameraController", "CharacterController", "FirstPersonController",
+        "ThirdPersonController", "EnemyController", "Health", "Animator", "SkinnedMeshRenderer",
+        "IKConstraint", "BoneAttachment", "HLODProxy"
+    };
+    for (const char* name : kPinnedComponents) {
+        if (components.contains(name)) {
+            return false;
+        }
+    }
+    if (components.contains("Light") &&
+        components["Light"].value("type", 0) == static_cast<int>(Light::Type::Directional)) {
+        return false;
+    }
+    if (components.contains("Rigidbody") &&
+        components["Rigidbody"].value("type", std::string("Dynamic")) != "Static") {
+        return false;
+    }
+    return true;
+}
+
+struct SceneCellBuild {
+    json entities = json::array();
+    Math::Vector3 boundsMin = Math::Vector3(std::numeric_limits<float>::max());
+    Math::Vector3 boundsMax = Math::Vector3(std::numeric_limits<float>::lowest());
+};
+
+// Moves streamable root hierarchies out of root["entities"] into one payload per XZ grid cell,
+// keyed on the root's world position, and lists the cells under root["worldPartition"]. Cell
+// entities are written parent-first so activation can attach each one as it is created.
+bool PartitionCookedScene(Scene* scene, json& root, const std::string& scenePath, const SceneStreamingSettings& settings) {
+    if (!root.contains("entities") || !root["entities"].is_array()) {
+        return true;
+    }
+    json& entities = root["entities"];
+    std::unordered_map<std::string, size_t> indexByUUID;
+    for (size_t i = 0; i < entities.size(); ++i) {
+        indexByUUID[entities[i].value("uuid", std::string())] = i;
+    }
+    std::unordered_map<size_t, std::vector<size_t>> children;
+    std::vector<size_t> roots;
+    for (size_t i = 0; i < entities.size(); ++i) {
+        auto parentIt = indexByUUID.find(entities[i].value("parent", std::string()));
+        if (parentIt == indexByUUID.end()) {
+            roots.push_back(i);
+        } else {
+            children[parentIt->second].push_back(i);
+        }
+    }
+
+    const float cellSize = std::max(1.0f, settings.cellSize);
+    std::map<std::pair<int, int>, SceneCellBuild> cells;
+    std::vector<bool> moved(entities.size(), false);
+    for (size_t rootIndex : roots) {
+        std::vector<size_t> hierarchy{rootIndex};
+        bool streamable = true;
+        bool renders = false;
+        for (size_t i = 0; i < hierarchy.size() && streamable; ++i) {
+            const json& components = entities[hierarchy[i]].value("components", json::object());
+            streamable = IsStreamableEntity(components);
+            renders = renders || components.contains("MeshRenderer") || components.contains("PrimitiveMesh");
+            auto childIt = children.find(hierarchy[i]);
+            if (childIt != children.end()) {
+                hierarchy.insert(hierarchy.end(), childIt->second.begin(), childIt->second.end());
+            }
+        }
+        UUID rootUUID;
+        Entity* rootEntity = nullptr;
+        if (ParseUUID(entities[rootIndex].value("uuid", std::string()), rootUUID)) {
+            rootEntity = scene->findEntity(rootUUID);
+        }
+        if (!streamable || !renders || !rootEntity) {
+            continue;
+        }
+
+        const Math::Vector3 position = rootEntity->getTransform()->getPosition();
+        const std::pair<int, int> key(static_cast<int>(std::floor(position.x / cellSize)),
+                                      static_cast<int>(std::floor(position.z / cellSize)));
+        SceneCellBuild& cell = cells[key];
+        for (size_t index : hierarchy) {
+            Math::Vector3 boundsMin = position;
+            Math::Vector3 boundsMax = position;
+            UUID uuid;
+            Entity* entity = ParseUUID(entities[index].value("uuid", std::string()), uuid) ? scene->findEntity(uuid) : nullptr;
+            if (entity) {
+                boundsMin = boundsMax = entity->getTransform()->getPosition();
+                if (MeshRenderer* renderer = entity->getComponent<MeshRenderer>()) {
+                    renderer->getWorldBounds(boundsMin, boundsMax);
+                }
+            }
+            cell.boundsMin = Math::Vector3::Min(cell.boundsMin, boundsMin);
+            cell.boundsMax = Math::Vector3::Max(cell.boundsMax, boundsMax);
+            cell.entities.push_back(std::move(entities[index]));
+            moved[index] = true;
+        }
+    }
+
+    const std::filesystem::path sceneFile(scenePath);
+    const std::string cellDirName = sceneFile.stem().string() + ".cells";
+    const std::filesystem::path cellDir = sceneFile.parent_path() / cellDirName;
+    std::error_code ec;
+    std::filesystem::remove_all(cellDir, ec);
+    if (cells.empty()) {
+        return true;
+    }
+    std::filesystem::create_directories(cellDir, ec);
+
+    json cellList = json::array();
+    for (auto& [key, cell] : cells) {
+        const std::string fileName = std::to_string(key.first) + "_" + std::to_string(key.second) + ".ccell";
+        // The grid square bounds the cell even where its meshes end short of it.
+        const Math::Vector3 squareMin(key.first * cellSize, cell.boundsMin.y, key.second * cellSize);
+        const Math::Vector3 squareMax((key.first + 1) * cellSize, cell.boundsMax.y, (key.second + 1) * cellSize);
+        const size_t entityCount = cell.entities.size();
+
+        json payload;
+        payload["entities"] = std::move(cell.entities);
+        BuildCookedAssetTable(payload);
+        std::vector<uint8_t> bytes = EncodeFlatScene(std::move(payload));
+        std::ofstream out(cellDir / fileName, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!out.good()) {
+            return false;
+        }
+        cellList.push_back({
+            {"x", key.first},
+            {"z", key.second},
+            {"path", (std::filesystem::path(cellDirName) / fileName).generic_string()},
+            {"boundsMin", Vec3ToJson(Math::Vector3::Min(cell.boundsMin, squareMin))},
+            {"boundsMax", Vec3ToJson(Math::Vector3::Max(cell.boundsMax, squareMax))},
+            {"entityCount", entityCount}
+        });
+    }
+
+    json persistent = json::array();
+    for (size_t i = 0; i < entities.size(); ++i) {
+        if (!moved[i]) {
+            persistent.push_back(std::move(entities[i]));
+        }
+    }
+    StartupLog("PartitionCookedScene cells=" + std::to_string(cellList.size()) +
+               " persistentEntities=" + std::to_string(persistent.size()));
+    entities = std::move(persistent);
+    root["worldPartition"] = {
+        {"cellSize", cellSize},
+        {"loadRadius", settings.loadRadius},
+        {"unloadRadius", std::max(settings.unloadRadius, settings.loadRadius)},
+        {"activationBudgetMs", settings.activationBudgetMs},
+        {"cells", std::move(cellList)}
+    };
+    return true;
+}
+
+} // namespace
+
+// Component blobs are decoded and their payloads staged while the cell is read, so activation
+// only builds entities and components.
+struct SceneCellPayload {
+    std::string scenePath;
+    std::shared_ptr<const uint8_t> mapping;
+    FlatSceneView view;
+    std::vector<json> components;
+    std::vector<StagedEntityPayloads> staged;
+    SceneAssetTable assets;
+    size_t next = 0;
+    std::unordered_map<std::string, ModelCacheEntry> modelCache;
+    std::unordered_map<std::string, std::shared_ptr<Mesh>> cookedMeshCache;
+    // Whole scenes only (ReadScene): the metadata applied before the first entity, and for scenes
+    // that are not flat the parsed document instead of the view.
+    bool wholeScene = false;
+    bool begun = false;
+    json metadata;
+    json root;
+    RuntimeSkinnedBankMap runtimeSkinnedBanks;
+    std::vector<Entity*> entities;
+};
+
+namespace {
+
+// A save writes the whole document to a sibling file and renames it over the scene, so a crash or
+// a full disk mid-write leaves the previous save intact instead of a truncated one.
+bool WriteSceneFileAtomically(const std::string& path, const std::string& text) {
+    const std::filesystem::path target(path);
+    std::error_code ec;
+    std::filesystem::create_directories(target.parent_path(), ec);
+    std::filesystem::path temp = target;
+    temp += ".saving";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        out.flush();
+        if (!out.good()) {
+            out.close();
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(temp, target, ec);
+    if (ec) {
+        std::error_code removeError;
+        std::filesystem::remove(temp, removeError);
+        return false;
+    }
+    return true;
+}
+
+// One entity's text as the last save of its path wrote it, indented for the entities array.
+struct SceneSaveFragment {
+    size_t hash = 0;
+    std::string text;
+};
+
+// Saves of one path. The mutex orders their writes and guards the fragments; generation is the
+// newest snapshot taken, so a queued save that a newer one overtook skips its write.
+struct SceneSaveTarget {
+    std::mutex mutex;
+    std::atomic<uint64_t> generation{0};
+    std::unordered_map<std::string, SceneSaveFragment> fragments; // by entity UUID
+};
+
+struct SceneSaveRequest {
+    std::shared_ptr<SceneSaveTarget> target;
+    std::string path;
+    json root;
+    uint64_t generation = 0;
+    std::function<void(bool)> onDone;
+};
+
+std::mutex g_SceneSaveTargetsMutex;
+std::unordered_map<std::string, std::shared_ptr<SceneSaveTarget>> g_SceneSaveTargets;
+// Every queued background save, for WaitForPendingSaves.
+const std::shared_ptr<JobFence> g_SceneSaveFence = std::make_shared<JobFence>();
 
-    if (root.contains("runtimeSkinnedBanks") && root["runtimeSkinnedBanks"].is_object()) {
-        for (auto it = root["runtimeSkinnedBanks"].begin(); it != root["runtimeSkinnedBanks"].end(); ++it) {
-            runtimeSkinnedBanks[it.key()] = it.value();
-        }
+std::shared_ptr<SceneSaveTarget> AcquireSceneSaveTarget(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::path key = std::filesystem::weakly_canonical(path, ec);
+    if (ec) {
+        key = std::filesystem::path(path).lexically_normal();
     }
-
-    size_t appliedEntityCount = 0;
-    for (auto& [uuid, record] : records) {
-        if (!record.entity) {
-            continue;
-        }
-        record.entity->setEditorOnly(record.editorOnly);
-        ApplyEntityComponents(record.entity, record.components, scene, scenePath, textureLoader, modelCache, cookedMeshCache, &runtimeSkinnedBanks);
-        ++appliedEntityCount;
+    std::lock_guard<std::mutex> lock(g_SceneSaveTargetsMutex);
+    std::shared_ptr<SceneSaveTarget>& target = g_SceneSaveTargets[key.string()];
+    if (!target) {
+        target = std::make_shared<SceneSaveTarget>();
     }
+    return target;
+}
 
-    if (wasActive) {
-        scene->setActive(true);
+void AppendIndented(std::string& out, const std::string& text, const char* indent) {
+    out += indent;
+    for (char c : text) {
+        out += c;
+        if (c == '\n') {
+            out += indent;
+        }
     }
+}
 
-    for (auto& [uuid, record] : records) {
-        if (record.entity && !record.active) {
-            record.entity->setActive(false);
+// root.dump(2), byte for byte, with each entity's text taken from the fragments when its json
+// hashes as it did last save. Hashing walks the tree without formatting a single number, which is
+// most of what dump costs. The fragments are swapped for this save's, so deleted entities drop out.
+std::string ComposeSceneDocument(json& root, SceneSaveTarget& target) {
+    json entities = std::move(root["entities"]);
+    root["entities"] = json::array();
+    std::string document = root.dump(2);
+    static constexpr char kPlaceholder[] = "\n  \"entities\": []";
+    const size_t splice = document.find(kPlaceholder);
+    if (splice == std::string::npos || !entities.is_array() || entities.empty()) {
+        const bool asWritten = entities.is_array() && entities.empty();
+        root["entities"] = std::move(entities);
+        return asWritten ? document : root.dump(2);
+    }
+
+    std::unordered_map<std::string, SceneSaveFragment> fragments;
+    fragments.reserve(entities.size());
+    std::string text = "\n  \"entities\": [\n";
+    for (size_t i = 0; i < entities.size(); ++i) {
+        const json& entity = entities[i];
+        const size_t hash = std::hash<json>{}(entity);
+        const std::string uuid = entity.value("uuid", std::string());
+        auto cached = uuid.empty() ? target.fragments.end() : target.fragments.find(uuid);
+        SceneSaveFragment fragment;
+        if (cached != target.fragments.end() && cached->second.hash == hash) {
+            fragment = std::move(cached->second);
+        } else {
+            fragment.hash = hash;
+            AppendIndented(fragment.text, entity.dump(2), "    ");
+        }
+        text += fragment.text;
+        text += i + 1 < entities.size() ? ",\n" : "\n";
+        if (!uuid.empty()) {
+            fragments[uuid] = std::move(fragment);
         }
     }
+    text += "  ]";
+    target.fragments = std::move(fragments);
+    document.replace(splice, sizeof(kPlaceholder) - 1, text);
+    return document;
+}
 
-    auto deserializeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - deserializeStart).count();
-    StartupLog("DeserializeSceneRoot entities=" + std::to_string(appliedEntityCount) +
-               " modelCaches=" + std::to_string(modelCache.size()) +
-               " cookedMeshes=" + std::to_string(cookedMeshCache.size()) +
-               " in " + std::to_string(deserializeMs) + "ms");
+bool WriteSceneSnapshot(SceneSaveRequest& request) {
+    SceneSaveTarget& target = *request.target;
+    std::lock_guard<std::mutex> lock(target.mutex);
+    if (request.generation != target.generation.load(std::memory_order_acquire)) {
+        return true; // a newer snapshot of the path writes after this one
+    }
+    const std::string document = ComposeSceneDocument(request.root, target);
+    if (!WriteSceneFileAtomically(request.path, document)) {
+        std::cerr << "SceneSerializer: failed to write scene " << request.path << std::endl;
+        return false;
+    }
     return true;
 }
 
-std::string ResolveSceneLoadPath(const std::string& path) {
-    if (path.empty()) {
-        return path;
+// Points the scene at the manifest its lighting will be saved to before the scene is serialized.
+void PrepareSceneSave(Scene* scene, const std::string& path) {
+    if (!ShouldPersistStaticLightingManifest(scene)) {
+        return;
     }
-
-    std::filesystem::path source(path);
-    if (source.extension() == ".ccscene") {
-        return path;
+    SceneSettings updatedSettings = scene->getSettings();
+    std::string manifestPath = SceneSerializer::ResolveStaticLightingManifestPath(scene, path);
+    if (!manifestPath.empty()) {
+        updatedSettings.staticLighting.bakeManifestPath = MakeProjectRelativePath(manifestPath);
+        scene->setSettings(updatedSettings);
     }
+}
 
-    if (!EnvEnabled("CRESCENT_PREFER_COOKED_SCENES") && !EnvEnabled("CRESCENT_REQUIRE_COOKED_SCENES")) {
-        return path;
-    }
+// Builds the scene's json on the calling thread, the only part that reads live components.
+std::shared_ptr<SceneSaveRequest> SnapshotScene(Scene* scene, const std::string& path) {
+    PrepareSceneSave(scene, path);
+    auto request = std::make_shared<SceneSaveRequest>();
+    request->target = AcquireSceneSaveTarget(path);
+    request->path = path;
+    BuildSceneOptions options;
+    options.includeAssetRoot = true;
+    request->root = BuildSceneJson(scene, path, options);
+    request->generation = request->target->generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+    return request;
+}
 
-    std::filesystem::path cooked = source;
-    cooked.replace_extension(".ccscene");
-    std::error_code ec;
-    if (std::filesystem::exists(cooked, ec)) {
-        return cooked.string();
+// What a cooked level's placed textures take in a heap (TextureHeap), summed over the textures its
+// renderers and decals hold now. The runtime sizes the level's heap from it; anything past it
+// falls back to device allocations, so an estimate off by a little costs nothing.
+json BuildGpuFootprint(Scene* scene, bool includeEditorOnly) {
+    Renderer* renderer = Engine::getInstance().getRenderer();
+    TextureLoader* loader = renderer ? renderer->getTextureLoader() : nullptr;
+    if (!scene || !loader) {
+        return json();
+    }
+    std::unordered_set<const Texture2D*> seen;
+    size_t textureBytes = 0;
+    auto note = [&](const std::shared_ptr<Texture2D>& texture) {
+        if (!texture || !seen.insert(texture.get()).second) {
+            return;
+        }
+        textureBytes += loader->getPlacementSize(*texture);
+    };
+    auto noteMaterials = [&](const std::vector<std::shared_ptr<Material>>& materials) {
+        for (const std::shared_ptr<Material>& material : materials) {
+            if (!material) {
+                continue;
+            }
+            note(material->getAlbedoTexture());
+            note(material->getNormalTexture());
+            note(material->getMetallicTexture());
+            note(material->getRoughnessTexture());
+            note(material->getAOTexture());
+            note(material->getEmissionTexture());
+            note(material->getORMTexture());
+            note(material->getHeightTexture());
+            note(material->getOpacityTexture());
+            note(material->getTerrainControlTexture());
+            note(material->getTerrainLayer0Texture());
+            note(material->getTerrainLayer1Texture());
+            note(material->getTerrainLayer2Texture());
+            note(material->getTerrainLayer0NormalTexture());
+            note(material->getTerrainLayer1NormalTexture());
+            note(material->getTerrainLayer2NormalTexture());
+            note(material->getTerrainLayer0ORMTexture());
+            note(material->getTerrainLayer1ORMTexture());
+            note(material->getTerrainLayer2ORMTexture());
+        }
+    };
+    for (const auto& entityPtr : scene->getAllEntities()) {
+        Entity* entity = entityPtr.get();
+        if (!entity || (!includeEditorOnly && entity->isEditorOnly())) {
+            continue;
+        }
+        if (auto* meshRenderer = entity->getComponent<MeshRenderer>()) {
+            noteMaterials(meshRenderer->getMaterials());
+        }
+        if (auto* skinned = entity->getComponent<SkinnedMeshRenderer>()) {
+            noteMaterials(skinned->getMaterials());
+        }
+        if (auto* decal = entity->getComponent<Decal>()) {
+            note(decal->getAlbedoTexture());
+            note(decal->getNormalTexture());
+            note(decal->getORMTexture());
+            note(decal->getMaskTexture());
+        }
+    }
+    size_t placedTextures = 0;
+    for (const Texture2D* texture : seen) {
+        placedTextures += loader->getPlacementSize(*texture) > 0 ? 1 : 0;
     }
+    return json{{"placedTextureBytes", textureBytes}, {"placedTextures", placedTextures}};
+}
 
-    if (EnvEnabled("CRESCENT_REQUIRE_COOKED_SCENES")) {
-        return "";
+// Gives a cooked level's textures a heap of the footprint it recorded; any other scene puts the
+// loader back on device allocations. The previous level's heap stays alive until its last
+// texture goes, then is freed whole.
+void PrepareTexturePlacement(const json& metadata, TextureLoader* loader) {
+    if (!loader) {
+        return;
     }
-    return path;
+    // A little over the recorded bytes: the heap loses some to alignment between textures.
+    constexpr double kHeapSlack = 1.0625;
+    size_t bytes = 0;
+    if (metadata.contains("gpuFootprint") && metadata["gpuFootprint"].is_object()) {
+        bytes = metadata["gpuFootprint"].value("placedTextureBytes", static_cast<size_t>(0));
+    }
+    Renderer* renderer = Engine::getInstance().getRenderer();
+    MTL::Device* device = renderer ? static_cast<MTL::Device*>(renderer->getDevice()) : nullptr;
+    loader->setPlacementHeap(bytes > 0 ? TextureHeap::create(device, static_cast<size_t>(bytes * kHeapSlack))
+                                       : nullptr);
 }
 
 } // namespace
@@ -2775,22 +4897,8 @@ bool SceneSerializer::SaveScene(Scene* scene, const std::string& path) {
     if (!scene) {
         return false;
     }
-    if (ShouldPersistStaticLightingManifest(scene)) {
-        SceneSettings updatedSettings = scene->getSettings();
-        std::string manifestPath = SceneSerializer::ResolveStaticLightingManifestPath(scene, path);
-        if (!manifestPath.empty()) {
-            updatedSettings.staticLighting.bakeManifestPath = MakeProjectRelativePath(manifestPath);
-            scene->setSettings(updatedSettings);
-        }
-    }
-    std::error_code ec;
-    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
-    std::ofstream out(path);
-    if (!out.is_open()) {
-        return false;
-    }
-    out << SerializeScene(scene, path);
-    if (!out.good()) {
+    std::shared_ptr<SceneSaveRequest> request = SnapshotScene(scene, path);
+    if (!WriteSceneSnapshot(*request)) {
         return false;
     }
     if (ShouldPersistStaticLightingManifest(scene)) {
@@ -2799,6 +4907,31 @@ bool SceneSerializer::SaveScene(Scene* scene, const std::string& path) {
     return true;
 }
 
+bool SceneSerializer::SaveSceneAsync(Scene* scene, const std::string& path, std::function<void(bool)> onDone) {
+    if (!scene) {
+        return false;
+    }
+    std::shared_ptr<SceneSaveRequest> request = SnapshotScene(scene, path);
+    request->onDone = std::move(onDone);
+    // The manifest is small and reads the scene, so it is written here with the snapshot.
+    bool manifestSaved = true;
+    if (ShouldPersistStaticLightingManifest(scene)) {
+        manifestSaved = SceneSerializer::SaveStaticLightingManifest(scene, path);
+    }
+    g_SceneSaveFence->remaining.fetch_add(1, std::memory_order_relaxed);
+    JobScheduler::getInstance().schedule(JobFunction([request]() {
+        const bool saved = WriteSceneSnapshot(*request);
+        if (request->onDone) {
+            request->onDone(saved);
+        }
+    }), g_SceneSaveFence, JobPriority::Background);
+    return manifestSaved;
+}
+
+void SceneSerializer::WaitForPendingSaves() {
+    JobScheduler::getInstance().wait(*g_SceneSaveFence);
+}
+
 bool SceneSerializer::SaveCookedRuntimeScene(Scene* scene, const std::string& path, bool includeEditorOnly) {
     if (!scene) {
         return false;
@@ -2813,13 +4946,30 @@ bool SceneSerializer::SaveCookedRuntimeScene(Scene* scene, const std::string& pa
     options.includeEditorOnly = includeEditorOnly;
     options.embedRuntimePayloads = true;
     options.externalizeRuntimeMeshes = true;
+    options.compressAnimationClips = true;
     options.cookedScenePath = path;
     CookedMeshWriter writer;
     writer.sceneOutputPath = path;
     options.cookedMeshWriter = &writer;
 
     json root = BuildSceneJson(scene, "", options);
-    std::vector<uint8_t> payload = json::to_msgpack(root);
+    json footprint = BuildGpuFootprint(scene, includeEditorOnly);
+    if (!footprint.is_null()) {
+        root["gpuFootprint"] = std::move(footprint);
+    }
+    // The navigation grid ships beside the scene and is mapped in when it loads.
+    if (scene->getSettings().navigation.enabled) {
+        const std::filesystem::path gridPath = std::filesystem::path(path).replace_extension(".navgrid");
+        if (NavigationSystem::CookSceneNavGrid(scene, gridPath.string())) {
+            root["sceneSettings"]["navigation"]["cookedGrid"] = gridPath.filename().string();
+        }
+    }
+    const SceneStreamingSettings& streaming = scene->getSettings().streaming;
+    if (streaming.enabled && !PartitionCookedScene(scene, root, path, streaming)) {
+        return false;
+    }
+    BuildCookedAssetTable(root);
+    std::vector<uint8_t> payload = EncodeFlatScene(std::move(root));
     if (payload.empty()) {
         return false;
     }
@@ -2831,21 +4981,28 @@ bool SceneSerializer::LoadScene(Scene* scene, const std::string& path) {
     if (!scene) {
         return false;
     }
+    // A background save of this path may still be writing it.
+    WaitForPendingSaves();
     auto loadStart = std::chrono::steady_clock::now();
+    StartupTraceScope trace("scene", "SceneSerializer::LoadScene", path);
     std::string resolvedPath = ResolveSceneLoadPath(path);
     if (resolvedPath.empty()) {
         StartupLog("LoadScene resolve failed for path: " + path);
         return false;
     }
     StartupLog("LoadScene path: " + resolvedPath);
+    trace.setDetail(resolvedPath);
     std::filesystem::path scenePath(resolvedPath);
     if (scenePath.extension() == ".ccscene") {
-        std::ifstream in(resolvedPath, std::ios::binary);
-        if (!in.is_open()) {
+        size_t size = 0;
+        std::shared_ptr<const uint8_t> mapped = MapFileReadOnly(resolvedPath, size);
+        if (!mapped) {
             return false;
         }
-        std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
-        bool ok = DeserializeSceneBinary(scene, data, resolvedPath);
+        // Flat scenes are read straight from the mapping; older msgpack ones need a copy to parse.
+        bool ok = IsFlatScene(mapped.get(), size)
+            ? DeserializeFlatScene(scene, mapped.get(), size, resolvedPath)
+            : DeserializeSceneBinary(scene, std::vector<uint8_t>(mapped.get(), mapped.get() + size), resolvedPath);
         auto loadMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - loadStart).count();
         StartupLog("LoadSceneBinary done in " + std::to_string(loadMs) + "ms");
         return ok;
@@ -2861,6 +5018,207 @@ bool SceneSerializer::LoadScene(Scene* scene, const std::string& path) {
     return ok;
 }
 
+std::shared_ptr<SceneCellPayload> SceneSerializer::ReadSceneCell(const std::string& cellPath, const std::string& scenePath) {
+    const std::string resolvedPath = ResolveSceneRelativePath(scenePath, cellPath);
+    auto payload = std::make_shared<SceneCellPayload>();
+    size_t size = 0;
+    payload->mapping = MapFileReadOnly(resolvedPath, size);
+    if (!payload->mapping || !OpenFlatScene(payload->mapping.get(), size, payload->view)) {
+        return nullptr;
+    }
+    payload->scenePath = scenePath;
+    json metadata = DecodeFlatSceneMetadata(payload->view);
+    if (metadata.is_object()) {
+        ReadSceneAssetTable(metadata, scenePath, payload->assets);
+    }
+    payload->components = DecodeFlatSceneComponents(payload->view);
+    std::vector<const json*> components;
+    components.reserve(payload->components.size());
+    for (const json& entity : payload->components) {
+        components.push_back(&entity);
+    }
+    payload->staged = StageScenePayloads(components, scenePath, payload->cookedMeshCache, nullptr, &payload->assets);
+    return payload;
+}
+
+bool SceneSerializer::ActivateSceneCell(Scene* scene, SceneCellPayload& payload, double budgetMs, std::vector<UUID>& outRoots) {
+    const size_t count = payload.view.entityCount();
+    if (!scene) {
+        return true;
+    }
+    Renderer* renderer = Engine::getInstance().getRenderer();
+    TextureLoader* textureLoader = renderer ? renderer->getTextureLoader() : nullptr;
+    const auto start = std::chrono::steady_clock::now();
+    while (payload.next < count) {
+        const size_t index = payload.next++;
+        const FlatSceneEntity& record = payload.view.entities[index];
+        Entity* entity = CreateFlatSceneEntity(scene, payload.view, record);
+        if (!entity) {
+            continue;
+        }
+        // Parents come first in a cell, so any parent is already there.
+        Entity* parent = (record.flags & FlatEntityHasParent) ? scene->findEntity(UUID(record.parentUUID)) : nullptr;
+        if (parent) {
+            entity->getTransform()->setParent(parent->getTransform(), false);
+        } else {
+            outRoots.push_back(entity->getUUID());
+        }
+        entity->setEditorOnly((record.flags & FlatEntityEditorOnly) != 0);
+        ApplyFlatTransform(entity, record);
+        ApplyEntityComponents(entity, payload.components[index], scene, payload.scenePath, textureLoader,
+                              payload.modelCache, payload.cookedMeshCache, nullptr, &payload.staged[index],
+                              &payload.assets);
+        if (!(record.flags & FlatEntityActive)) {
+            entity->setActive(false);
+        }
+        const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= budgetMs) {
+            break;
+        }
+    }
+    return payload.next >= count;
+}
+
+std::shared_ptr<SceneCellPayload> SceneSerializer::ReadScene(const std::string& path, size_t* outMemoryBytes) {
+    const std::string resolvedPath = ResolveSceneLoadPath(path);
+    if (resolvedPath.empty()) {
+        return nullptr;
+    }
+    StartupTraceScope trace("scene", "SceneSerializer::ReadScene", resolvedPath);
+    auto payload = std::make_shared<SceneCellPayload>();
+    payload->scenePath = resolvedPath;
+    payload->wholeScene = true;
+    size_t size = 0;
+    if (std::filesystem::path(resolvedPath).extension() == ".ccscene") {
+        payload->mapping = MapFileReadOnly(resolvedPath, size);
+        if (!payload->mapping) {
+            return nullptr;
+        }
+        if (IsFlatScene(payload->mapping.get(), size)) {
+            if (!OpenFlatScene(payload->mapping.get(), size, payload->view)) {
+                return nullptr;
+            }
+            payload->metadata = DecodeFlatSceneMetadata(payload->view);
+        } else {
+            payload->root = json::from_msgpack(payload->mapping.get(), payload->mapping.get() + size, true, false);
+            payload->mapping.reset();
+        }
+    } else {
+        std::ifstream in(resolvedPath);
+        if (!in.is_open()) {
+            return nullptr;
+        }
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        size = data.size();
+        payload->root = json::parse(data, nullptr, false);
+    }
+
+    if (!payload->view.header) {
+        if (payload->root.is_discarded() || !payload->root.is_object()) {
+            return nullptr;
+        }
+        if (outMemoryBytes) {
+            *outMemoryBytes = size;
+        }
+        return payload;
+    }
+    if (payload->metadata.is_discarded() || !payload->metadata.is_object()) {
+        return nullptr;
+    }
+    ReadSceneAssetTable(payload->metadata, resolvedPath, payload->assets);
+    payload->runtimeSkinnedBanks = ReadRuntimeSkinnedBanks(payload->metadata);
+    payload->components = DecodeFlatSceneComponents(payload->view);
+    std::vector<const json*> components;
+    components.reserve(payload->components.size());
+    for (const json& entity : payload->components) {
+        components.push_back(&entity);
+    }
+    payload->staged = StageScenePayloads(components, resolvedPath, payload->cookedMeshCache,
+                                         &payload->runtimeSkinnedBanks, &payload->assets);
+    if (outMemoryBytes) {
+        size_t gpuBytes = 0;
+        if (payload->metadata.contains("gpuFootprint") && payload->metadata["gpuFootprint"].is_object()) {
+            gpuBytes = payload->metadata["gpuFootprint"].value("placedTextureBytes", static_cast<size_t>(0));
+        }
+        *outMemoryBytes = size + gpuBytes;
+    }
+    return payload;
+}
+
+bool SceneSerializer::ActivateScenePayload(Scene* scene, SceneCellPayload& payload, double budgetMs) {
+    if (!scene || !payload.wholeScene) {
+        return true;
+    }
+    if (!payload.view.header) {
+        if (!payload.begun) {
+            payload.begun = true;
+            DeserializeSceneRoot(scene, payload.root, payload.scenePath);
+            payload.root = json();
+        }
+        return true;
+    }
+
+    const size_t count = payload.view.entityCount();
+    const auto start = std::chrono::steady_clock::now();
+    Renderer* renderer = Engine::getInstance().getRenderer();
+    TextureLoader* textureLoader = renderer ? renderer->getTextureLoader() : nullptr;
+    if (!payload.begun) {
+        payload.begun = true;
+        ApplySceneMetadata(scene, payload.metadata, payload.scenePath);
+        if (payload.metadata.contains("name")) {
+            scene->setName(payload.metadata.value("name", scene->getName()));
+        }
+        // The running scene's later texture loads land in this heap too until it is replaced;
+        // they fall back to device allocations once it is full.
+        PrepareTexturePlacement(payload.metadata, textureLoader);
+        payload.entities.assign(count, nullptr);
+    }
+    while (payload.next < count) {
+        const size_t index = payload.next++;
+        const FlatSceneEntity& record = payload.view.entities[index];
+        Entity* entity = CreateFlatSceneEntity(scene, payload.view, record);
+        payload.entities[index] = entity;
+        if (!entity) {
+            continue;
+        }
+        // A parent written after its child is attached once every entity exists.
+        if ((record.flags & FlatEntityHasParent) && record.parentIndex >= 0 &&
+            static_cast<size_t>(record.parentIndex) < index && payload.entities[record.parentIndex]) {
+            entity->getTransform()->setParent(payload.entities[record.parentIndex]->getTransform(), false);
+        }
+        entity->setEditorOnly((record.flags & FlatEntityEditorOnly) != 0);
+        ApplyFlatTransform(entity, record);
+        ApplyEntityComponents(entity, payload.components[index], scene, payload.scenePath, textureLoader,
+                              payload.modelCache, payload.cookedMeshCache, &payload.runtimeSkinnedBanks,
+                              &payload.staged[index], &payload.assets);
+        if (!(record.flags & FlatEntityActive)) {
+            entity->setActive(false);
+        }
+        const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= budgetMs && payload.next < count) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const FlatSceneEntity& record = payload.view.entities[i];
+        Entity* entity = payload.entities[i];
+        if (!entity || !(record.flags & FlatEntityHasParent) || entity->getTransform()->getParent()) {
+            continue;
+        }
+        Entity* parent = record.parentIndex >= 0 ? payload.entities[static_cast<size_t>(record.parentIndex)]
+                                                 : scene->findEntity(UUID(record.parentUUID));
+        if (parent) {
+            entity->getTransform()->setParent(parent->getTransform(), false);
+        }
+    }
+    ConfigureSceneStreaming(scene, payload.metadata, payload.scenePath);
+    payload.entities.clear();
+    payload.components.clear();
+    payload.staged.clear();
+    return true;
+}
+
 namespace {
 
 std::unordered_map<std::string, EntityRecord> BuildEntityRecords(Scene* scene,
@@ -2930,7 +5288,9 @@ void ApplyEntityComponents(Entity* entity,
                            TextureLoader* textureLoader,
                            std::unordered_map<std::string, ModelCacheEntry>& modelCache,
                            std::unordered_map<std::string, std::shared_ptr<Mesh>>& cookedMeshCache,
-                           const RuntimeSkinnedBankMap* runtimeSkinnedBanks) {
+                           const RuntimeSkinnedBankMap* runtimeSkinnedBanks,
+                           const StagedEntityPayloads* staged,
+                           SceneAssetTable* assets) {
     if (!entity) {
         return;
     }
@@ -2999,7 +5359,9 @@ void ApplyEntityComponents(Entity* entity,
         auto it = modelCache.find(cacheKey);
         if (it == modelCache.end()) {
             auto modelCacheStart = std::chrono::steady_clock::now();
-            modelCache[cacheKey] = BuildModelCache(modelMeshReference->getSourcePath(), modelMeshReference->getImportOptions());
+            modelCache[cacheKey] = BuildModelCache(modelMeshReference->getSourcePath(),
+                                                   modelMeshReference->getImportOptions(),
+                                                   textureLoader);
             auto modelCacheMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - modelCacheStart).count();
             StartupLog("BuildModelCache " + modelMeshReference->getSourcePath() + " in " + std::to_string(modelCacheMs) + "ms");
             it = modelCache.find(cacheKey);
@@ -3070,29 +5432,30 @@ void ApplyEntityComponents(Entity* entity,
         if (!meshRenderer) {
             meshRenderer = entity->addComponent<MeshRenderer>();
         }
-        if (r.contains("meshRef")) {
-            if (auto mesh = LoadCookedMeshRef(r["meshRef"], scenePath, cookedMeshCache)) {
-                meshRenderer->setMesh(mesh);
-                if (skinnedRenderer) {
-                    skinnedRenderer->setMesh(mesh);
-                }
-            }
+        std::shared_ptr<Mesh> mesh;
+        if (r.contains("meshAsset")) {
+            mesh = AssetTableMesh(assets, r);
+        } else if (r.contains("meshRef")) {
+            mesh = LoadCookedMeshRef(r["meshRef"], scenePath, cookedMeshCache);
         } else if (r.contains("mesh")) {
-            if (auto mesh = DeserializeMeshData(r["mesh"])) {
-                meshRenderer->setMesh(mesh);
-                if (skinnedRenderer) {
-                    skinnedRenderer->setMesh(mesh);
-                }
+            mesh = staged && staged->meshRendererMesh ? staged->meshRendererMesh : DeserializeMeshData(r["mesh"]);
+        }
+        if (mesh) {
+            meshRenderer->setMesh(mesh);
+            if (skinnedRenderer) {
+                skinnedRenderer->setMesh(mesh);
             }
         }
         meshRenderer->setCastShadows(r.value("castShadows", meshRenderer->getCastShadows()));
         meshRenderer->setReceiveShadows(r.value("receiveShadows", meshRenderer->getReceiveShadows()));
         meshRenderer->setUseBakedVertexLighting(r.value("useBakedVertexLighting", meshRenderer->getUseBakedVertexLighting()));
 
-        if (r.contains("materials") && r["materials"].is_array()) {
-            const json& mats = r["materials"];
+        const bool tableMaterials = r.contains("materialAssets") && r["materialAssets"].is_array();
+        if (tableMaterials || (r.contains("materials") && r["materials"].is_array())) {
+            const json& mats = tableMaterials ? r["materialAssets"] : r["materials"];
             for (size_t i = 0; i < mats.size(); ++i) {
-                auto material = DeserializeMaterial(mats[i], textureLoader);
+                auto material = tableMaterials ? AssetTableMaterial(assets, mats[i], textureLoader)
+                                               : DeserializeMaterial(mats[i], textureLoader);
                 meshRenderer->setMaterial(static_cast<uint32_t>(i), material);
                 if (skinnedRenderer) {
                     skinnedRenderer->setMaterial(static_cast<uint32_t>(i), material);
@@ -3128,6 +5491,7 @@ void ApplyEntityComponents(Entity* entity,
             if (sl.contains("shadowmask")) {
                 staticLighting.shadowmaskPath = ResolveTextureEntryPath(sl["shadowmask"]);
             }
+            staticLighting.bakeHash = sl.value("bakeHash", staticLighting.bakeHash);
             meshRenderer->setStaticLighting(staticLighting);
             if (sl.contains("lightmapUVs") && sl["lightmapUVs"].is_array()) {
                 if (auto mesh = meshRenderer->getMesh()) {
@@ -3165,54 +5529,54 @@ void ApplyEntityComponents(Entity* entity,
         proxy->setEnabled(h.value("enabled", proxy->isEnabled()));
         proxy->setLodStart(h.value("lodStart", proxy->getLodStart()));
         proxy->setLodEnd(h.value("lodEnd", proxy->getLodEnd()));
+        proxy->setLevel(h.value("level", proxy->getLevel()));
         if (h.contains("sources") && h["sources"].is_array()) {
-            std::vector<std::string> sources;
+            std::vector<UUID> sources;
             for (const auto& entry : h["sources"]) {
-                sources.push_back(entry.get<std::string>());
+                if (entry.is_string()) {
+                    sources.push_back(UUID::fromString(entry.get<std::string>()));
+                }
             }
             proxy->setSourceUuids(sources);
         }
-        if (h.contains("meshRef")) {
-            if (auto mesh = LoadCookedMeshRef(h["meshRef"], scenePath, cookedMeshCache)) {
-                if (!meshRenderer) {
-                    meshRenderer = entity->addComponent<MeshRenderer>();
-                }
-                meshRenderer->setMesh(mesh);
-            }
+        std::shared_ptr<Mesh> mesh;
+        if (h.contains("meshAsset")) {
+            mesh = AssetTableMesh(assets, h);
+        } else if (h.contains("meshRef")) {
+            mesh = LoadCookedMeshRef(h["meshRef"], scenePath, cookedMeshCache);
         } else if (h.contains("mesh")) {
-            auto mesh = DeserializeMeshData(h["mesh"]);
-            if (mesh) {
-                if (!meshRenderer) {
-                    meshRenderer = entity->addComponent<MeshRenderer>();
-                }
-                meshRenderer->setMesh(mesh);
+            mesh = staged && staged->hlodMesh ? staged->hlodMesh : DeserializeMeshData(h["mesh"]);
+        }
+        if (mesh) {
+            if (!meshRenderer) {
+                meshRenderer = entity->addComponent<MeshRenderer>();
             }
+            meshRenderer->setMesh(mesh);
         }
     }
 
     if (components.contains("SkinnedMeshRenderer")) {
         const json& s = components["SkinnedMeshRenderer"];
-        if (!skinnedRenderer && (s.contains("mesh") || s.contains("meshRef") ||
+        if (!skinnedRenderer && (s.contains("mesh") || s.contains("meshRef") || s.contains("meshAsset") ||
                                  s.contains("skeleton") || s.contains("animationClips") ||
-                                 s.contains("runtimeBankRef"))) {
+                                 s.contains("runtimeBankRef") || s.contains("skeletonAsset") ||
+                                 s.contains("clipsAsset"))) {
             skinnedRenderer = entity->addComponent<SkinnedMeshRenderer>();
         }
-        if (skinnedRenderer && s.contains("meshRef")) {
-            if (auto mesh = LoadCookedMeshRef(s["meshRef"], scenePath, cookedMeshCache)) {
-                skinnedRenderer->setMesh(mesh);
-                if (!meshRenderer) {
-                    meshRenderer = entity->addComponent<MeshRenderer>();
-                }
-                meshRenderer->setMesh(mesh);
-            }
+        std::shared_ptr<Mesh> mesh;
+        if (skinnedRenderer && s.contains("meshAsset")) {
+            mesh = AssetTableMesh(assets, s);
+        } else if (skinnedRenderer && s.contains("meshRef")) {
+            mesh = LoadCookedMeshRef(s["meshRef"], scenePath, cookedMeshCache);
         } else if (skinnedRenderer && s.contains("mesh")) {
-            if (auto mesh = DeserializeMeshData(s["mesh"])) {
-                skinnedRenderer->setMesh(mesh);
-                if (!meshRenderer) {
-                    meshRenderer = entity->addComponent<MeshRenderer>();
-                }
-                meshRenderer->setMesh(mesh);
+            mesh = staged && staged->skinnedMesh ? staged->skinnedMesh : DeserializeMeshData(s["mesh"]);
+        }
+        if (mesh) {
+            skinnedRenderer->setMesh(mesh);
+            if (!meshRenderer) {
+                meshRenderer = entity->addComponent<MeshRenderer>();
             }
+            meshRenderer->setMesh(mesh);
         }
         const json* skinnedPayload = &s;
         json resolvedRuntimeBank;
@@ -3226,12 +5590,17 @@ void ApplyEntityComponents(Entity* entity,
                 }
             }
         }
-        if (skinnedRenderer && skinnedPayload->contains("skeleton")) {
+        // Skeletons and clips from the asset table only arrive staged.
+        if (skinnedRenderer && staged && staged->skeleton) {
+            skinnedRenderer->setSkeleton(staged->skeleton);
+        } else if (skinnedRenderer && skinnedPayload->contains("skeleton")) {
             if (auto skeleton = DeserializeSkeletonData((*skinnedPayload)["skeleton"])) {
                 skinnedRenderer->setSkeleton(skeleton);
             }
         }
-        if (skinnedRenderer && skinnedPayload->contains("animationClips") && (*skinnedPayload)["animationClips"].is_array()) {
+        if (skinnedRenderer && staged && staged->hasClips) {
+            skinnedRenderer->setAnimationClips(staged->clips);
+        } else if (skinnedRenderer && skinnedPayload->contains("animationClips") && (*skinnedPayload)["animationClips"].is_array()) {
             std::vector<std::shared_ptr<AnimationClip>> clips;
             clips.reserve((*skinnedPayload)["animationClips"].size());
             for (const auto& clipData : (*skinnedPayload)["animationClips"]) {
@@ -3302,6 +5671,16 @@ void ApplyEntityComponents(Entity* entity,
         skinnedRenderer->setRootMotionEnabled(s.value("rootMotionEnabled", skinnedRenderer->getRootMotionEnabled()));
         skinnedRenderer->setApplyRootMotionPosition(s.value("rootMotionPosition", skinnedRenderer->getApplyRootMotionPosition()));
         skinnedRenderer->setApplyRootMotionRotation(s.value("rootMotionRotation", skinnedRenderer->getApplyRootMotionRotation()));
+        if (s.contains("animationLod") && s["animationLod"].is_object()) {
+            const json& lodJson = s["animationLod"];
+            AnimationLodSettings lod = skinnedRenderer->getAnimationLod();
+            lod.enabled = lodJson.value("enabled", lod.enabled);
+            lod.fullRatePixels = std::max(0.0f, lodJson.value("fullRatePixels", lod.fullRatePixels));
+            lod.reducedBonePixels = std::max(0.0f, lodJson.value("reducedBonePixels", lod.reducedBonePixels));
+            lod.reducedBoneDepth = std::max(0, lodJson.value("reducedBoneDepth", lod.reducedBoneDepth));
+            lod.updateWhenCulled = lodJson.value("updateWhenCulled", lod.updateWhenCulled);
+            skinnedRenderer->setAnimationLod(lod);
+        }
         if (s.contains("clipEvents") && s["clipEvents"].is_array()) {
             const auto& clips = skinnedRenderer->getAnimationClips();
             for (const auto& entry : s["clipEvents"]) {
@@ -3488,6 +5867,21 @@ void ApplyEntityComponents(Entity* entity,
         collider->setRestitutionCombine(CombineModeFromString(c.value("restitutionCombine", std::string("Average"))));
         collider->setCollisionLayer(c.value("collisionLayer", collider->getCollisionLayer()));
         collider->setCollisionMask(c.value("collisionMask", collider->getCollisionMask()));
+        if (c.contains("cookedShape") && c["cookedShape"].is_object()) {
+            const json& cooked = c["cookedShape"];
+            std::string cookedPath = ResolveSceneRelativePath(scenePath, cooked.value("path", std::string()));
+            if (!cookedPath.empty()) {
+                collider->setCookedShape(cookedPath,
+                                         cooked.value("convex", false),
+                                         JsonToMatrix(cooked.value("transform", json::array())));
+            }
+        }
+        if (c.contains("cookedHeightField") && c["cookedHeightField"].is_string()) {
+            std::string heightFieldPath = ResolveSceneRelativePath(scenePath, c["cookedHeightField"].get<std::string>());
+            if (!heightFieldPath.empty()) {
+                collider->setCookedHeightField(heightFieldPath);
+            }
+        }
     }
 
     if (components.contains("Health")) {
@@ -3659,7 +6053,11 @@ void ApplyEntityComponents(Entity* entity,
         if (!audio) {
             audio = entity->addComponent<AudioSource>();
         }
-        audio->setStreaming(a.value("stream", audio->isStreaming()));
+        if (a.contains("loadMode") && a["loadMode"].is_string()) {
+            audio->setLoadMode(AudioSystem::audioLoadModeFromString(a["loadMode"].get<std::string>()));
+        } else {
+            audio->setStreaming(a.value("stream", audio->isStreaming()));
+        }
         if (a.contains("file")) {
             std::string resolved = ResolveTextureEntryPath(a["file"]);
             if (!resolved.empty()) {
@@ -3715,6 +6113,8 @@ void ApplyEntityComponents(Entity* entity,
         light->setPenumbra(l.value("penumbra", light->getPenumbra()));
         light->setContactShadows(l.value("contactShadows", light->getContactShadows()));
         light->setCascadeCount(static_cast<uint8_t>(l.value("cascadeCount", light->getCascadeCount())));
+        light->setShadowPageCache(l.value("shadowPageCache", light->getShadowPageCache()));
+        light->setShadowUpdateInterval(l.value("shadowUpdateInterval", light->getShadowUpdateInterval()));
         if (l.contains("cascadeSplits") && l["cascadeSplits"].is_array() && l["cascadeSplits"].size() == 4) {
             std::array<float, 4> splits = {
                 l["cascadeSplits"][0].get<float>(),
@@ -3781,6 +6181,48 @@ void ApplyEntityComponents(Entity* entity,
                   [&](const std::shared_ptr<Texture2D>& tex){ decal->setMaskTexture(tex); });
     }
 
+    if (components.contains("ParticleEmitter")) {
+        const json& p = components["ParticleEmitter"];
+        ParticleEmitter* emitter = entity->addComponent<ParticleEmitter>();
+        emitter->setMaxParticles(p.value("maxParticles", emitter->getMaxParticles()));
+        emitter->setEmissionRate(p.value("emissionRate", emitter->getEmissionRate()));
+        emitter->setBurstCount(p.value("burstCount", emitter->getBurstCount()));
+        emitter->setEmitting(p.value("emitting", emitter->isEmitting()));
+        emitter->setLifetimeRange(p.value("minLifetime", emitter->getMinLifetime()),
+                                  p.value("maxLifetime", emitter->getMaxLifetime()));
+        emitter->setSpeedRange(p.value("minSpeed", emitter->getMinSpeed()), p.value("maxSpeed", emitter->getMaxSpeed()));
+        emitter->setSizeRange(p.value("startSize", emitter->getStartSize()), p.value("endSize", emitter->getEndSize()));
+        if (p.contains("startColor")) {
+            emitter->setStartColor(JsonToVec4(p["startColor"], emitter->getStartColor()));
+        }
+        if (p.contains("endColor")) {
+            emitter->setEndColor(JsonToVec4(p["endColor"], emitter->getEndColor()));
+        }
+        emitter->setIntensity(p.value("intensity", emitter->getIntensity()));
+        emitter->setLit(p.value("lit", emitter->isLit()));
+        if (p.contains("gravity")) {
+            emitter->setGravity(JsonToVec3(p["gravity"], emitter->getGravity()));
+        }
+        emitter->setDrag(p.value("drag", emitter->getDrag()));
+        emitter->setShape(static_cast<ParticleEmitter::Shape>(p.value("shape", static_cast<int>(emitter->getShape()))));
+        emitter->setShapeRadius(p.value("shapeRadius", emitter->getShapeRadius()));
+        emitter->setConeAngle(p.value("coneAngle", emitter->getConeAngle()));
+        emitter->setCollision(p.value("collision", emitter->getCollision()));
+        emitter->setBounce(p.value("bounce", emitter->getBounce()));
+        emitter->setCollisionLifetimeLoss(p.value("collisionLifetimeLoss", emitter->getCollisionLifetimeLoss()));
+        emitter->setBlendMode(static_cast<ParticleEmitter::BlendMode>(p.value("blendMode", static_cast<int>(emitter->getBlendMode()))));
+        emitter->setSeed(p.value("seed", emitter->getSeed()));
+        if (p.contains("texture")) {
+            std::string resolved = ResolveTextureEntryPath(p["texture"]);
+            if (!resolved.empty()) {
+                emitter->setTexturePath(resolved);
+                if (auto tex = LoadTexturePath(textureLoader, resolved, true, false)) {
+                    emitter->setTexture(tex);
+                }
+            }
+        }
+    }
+
     if (components.contains("Camera")) {
         const json& c = components["Camera"];
         Camera* camera = entity->addComponent<Camera>();
@@ -3961,6 +6403,9 @@ json BuildSceneJson(Scene* scene, const std::string& scenePath, const BuildScene
                         staticLightingJson["shadowmask"] = ref;
                     }
                 }
+                if (!staticLighting.bakeHash.empty() && !options.embedRuntimePayloads) {
+                    staticLightingJson["bakeHash"] = staticLighting.bakeHash;
+                }
                 if (!options.embedRuntimePayloads) {
                     if (auto mesh = renderer->getMesh()) {
                         const auto& vertices = mesh->getVertices();
@@ -3988,6 +6433,14 @@ json BuildSceneJson(Scene* scene, const std::string& scenePath, const BuildScene
                 {"rootMotionPosition", skinned->getApplyRootMotionPosition()},
                 {"rootMotionRotation", skinned->getApplyRootMotionRotation()}
             };
+            const AnimationLodSettings& animationLod = skinned->getAnimationLod();
+            skinnedData["animationLod"] = {
+                {"enabled", animationLod.enabled},
+                {"fullRatePixels", animationLod.fullRatePixels},
+                {"reducedBonePixels", animationLod.reducedBonePixels},
+                {"reducedBoneDepth", animationLod.reducedBoneDepth},
+                {"updateWhenCulled", animationLod.updateWhenCulled}
+            };
             if (options.embedRuntimePayloads) {
                 if (auto mesh = skinned->getMesh()) {
                     if (options.externalizeRuntimeMeshes) {
@@ -4017,8 +6470,13 @@ json BuildSceneJson(Scene* scene, const std::string& scenePath, const BuildScene
                     const auto& clips = skinned->getAnimationClips();
                     if (!clips.empty()) {
                         json clipData = json::array();
+                        const Skeleton* skeleton = skinned->getSkeleton().get();
+                        AnimationCompressionSettings compression;
+                        compression.uniform = scene->getSettings().quality.uniformAnimationClips;
                         for (const auto& clip : clips) {
-                            if (clip) {
+                            if (clip && options.compressAnimationClips && !clip->getCompressedData()) {
+                                clipData.push_back(SerializeAnimationClipData(*CompressAnimationClip(*clip, skeleton, compression)));
+                            } else if (clip) {
                                 clipData.push_back(SerializeAnimationClipData(*clip));
                             } else {
                                 clipData.push_back(json::object());
@@ -4082,11 +6540,16 @@ json BuildSceneJson(Scene* scene, const std::string& scenePath, const BuildScene
         }
 
         if (auto* hlod = entity->getComponent<HLODProxy>()) {
+            json sources = json::array();
+            for (UUID source : hlod->getSourceUuids()) {
+                sources.push_back(source.toString());
+            }
             json hlodData = {
                 {"enabled", hlod->isEnabled()},
                 {"lodStart", hlod->getLodStart()},
                 {"lodEnd", hlod->getLodEnd()},
-                {"sources", hlod->getSourceUuids()}
+                {"level", hlod->getLevel()},
+                {"sources", sources}
             };
 
             if (auto* renderer = entity->getComponent<MeshRenderer>()) {
@@ -4094,7 +6557,8 @@ json BuildSceneJson(Scene* scene, const std::string& scenePath, const BuildScene
                     if (options.externalizeRuntimeMeshes) {
                         std::string meshRef = EmitCookedMeshRef(entity, mesh, modelMeshReference, "hlod_mesh", options);
                         if (!meshRef.empty()) {
-                            hlodData["meshRef"] = meshRef;
+                            // Proxies are only ever drawn, so the runtime keeps no CPU copy.
+                            hlodData["meshRef"] = {{"path", meshRef}, {"residency", "gpu"}};
                         } else {
                             hlodData["mesh"] = SerializeMeshData(*mesh);
                         }
@@ -4239,6 +6703,17 @@ json BuildSceneJson(Scene* scene, const std::string& scenePath, const BuildScene
                 {"collisionLayer", collider->getCollisionLayer()},
                 {"collisionMask", collider->getCollisionMask()}
             };
+            if (collider->getShapeType() == PhysicsCollider::ShapeType::Mesh) {
+                json cookedShape = EmitCookedColliderShape(scene, entity, options);
+                if (!cookedShape.is_null()) {
+                    components["PhysicsCollider"]["cookedShape"] = cookedShape;
+                }
+            } else if (collider->getShapeType() == PhysicsCollider::ShapeType::Terrain) {
+                std::string heightField = EmitCookedTerrainHeightField(scene, entity, options);
+                if (!heightField.empty()) {
+                    components["PhysicsCollider"]["cookedHeightField"] = heightField;
+                }
+            }
         }
 
         if (auto* health = entity->getComponent<Health>()) {
@@ -4378,7 +6853,7 @@ json BuildSceneJson(Scene* scene, const std::string& scenePath, const BuildScene
                 {"playOnStart", audio->getPlayOnStart()},
                 {"spatial", audio->isSpatial()},
                 {"bus", AudioSystem::audioBusToString(audio->getBus())},
-                {"stream", audio->isStreaming()},
+                {"loadMode", AudioSystem::audioLoadModeToString(audio->getLoadMode())},
                 {"minDistance", audio->getMinDistance()},
                 {"maxDistance", audio->getMaxDistance()},
                 {"rolloff", audio->getRolloff()}
@@ -4417,6 +6892,8 @@ json BuildSceneJson(Scene* scene, const std::string& scenePath, const BuildScene
                 {"contactShadows", light->getContactShadows()},
                 {"cascadeCount", light->getCascadeCount()},
                 {"cascadeSplits", json::array({light->getCascadeSplits()[0], light->getCascadeSplits()[1], light->getCascadeSplits()[2], light->getCascadeSplits()[3]})},
+                {"shadowPageCache", light->getShadowPageCache()},
+                {"shadowUpdateInterval", light->getShadowUpdateInterval()},
                 {"volumetric", light->getVolumetric()},
                 {"contributeToStaticBake", light->getContributeToStaticBake()},
                 {"mobility", static_cast<int>(light->getMobility())},
@@ -4471,6 +6948,45 @@ json BuildSceneJson(Scene* scene, const std::string& scenePath, const BuildScene
             components["Decal"] = decalData;
         }
 
+        if (auto* emitter = entity->getComponent<ParticleEmitter>()) {
+            json emitterData = {
+                {"maxParticles", emitter->getMaxParticles()},
+                {"emissionRate", emitter->getEmissionRate()},
+                {"burstCount", emitter->getBurstCount()},
+                {"emitting", emitter->isEmitting()},
+                {"minLifetime", emitter->getMinLifetime()},
+                {"maxLifetime", emitter->getMaxLifetime()},
+                {"minSpeed", emitter->getMinSpeed()},
+                {"maxSpeed", emitter->getMaxSpeed()},
+                {"startSize", emitter->getStartSize()},
+                {"endSize", emitter->getEndSize()},
+                {"startColor", Vec4ToJson(emitter->getStartColor())},
+                {"endColor", Vec4ToJson(emitter->getEndColor())},
+                {"intensity", emitter->getIntensity()},
+                {"lit", emitter->isLit()},
+                {"gravity", Vec3ToJson(emitter->getGravity())},
+                {"drag", emitter->getDrag()},
+                {"shape", static_cast<int>(emitter->getShape())},
+                {"shapeRadius", emitter->getShapeRadius()},
+                {"coneAngle", emitter->getConeAngle()},
+                {"collision", emitter->getCollision()},
+                {"bounce", emitter->getBounce()},
+                {"collisionLifetimeLoss", emitter->getCollisionLifetimeLoss()},
+                {"blendMode", static_cast<int>(emitter->getBlendMode())},
+                {"seed", emitter->getSeed()}
+            };
+            json textureRef = SerializeTextureRef(emitter->getTexture(), "texture", options.embedRuntimePayloads);
+            if (!textureRef.is_null() && !textureRef.empty()) {
+                emitterData["texture"] = textureRef;
+            } else if (!emitter->getTexturePath().empty()) {
+                json pathRef = SerializeAssetPath(emitter->getTexturePath(), "texture", options.embedRuntimePayloads);
+                if (!pathRef.is_null() && !pathRef.empty()) {
+                    emitterData["texture"] = pathRef;
+                }
+            }
+            components["ParticleEmitter"] = emitterData;
+        }
+
         if (auto* camera = entity->getComponent<Camera>()) {
             components["Camera"] = {
                 {"projection", static_cast<int>(camera->getProjectionType())},
@@ -4493,11 +7009,12 @@ json BuildSceneJson(Scene* scene, const std::string& scenePath, const BuildScene
             };
         }
 
-        e["components"] = components;
-        entities.push_back(e);
+        // Moved rather than copied: a scene's components are most of the document.
+        e["components"] = std::move(components);
+        entities.push_back(std::move(e));
     }
 
-    root["entities"] = entities;
+    root["entities"] = std::move(entities);
     if (!runtimeSkinnedBanks.empty()) {
         json banks = json::object();
         for (const auto& [key, value] : runtimeSkinnedBanks) {
@@ -4543,7 +7060,9 @@ json BuildSceneJson(Scene* scene, const std::string& scenePath, const BuildScene
     sceneSettings["postProcess"] = SerializePostProcessSettings(settings.postProcess);
     sceneSettings["quality"] = SerializeQualitySettings(settings.quality);
     sceneSettings["staticLighting"] = SerializeStaticLightingSettings(settings.staticLighting);
-    root["sceneSettings"] = sceneSettings;
+    sceneSettings["streaming"] = SerializeStreamingSettings(settings.streaming);
+    sceneSettings["navigation"] = SerializeNavigationSettings(settings.navigation);
+    root["sceneSettings"] = std::move(sceneSettings);
 
     return root;
 }
@@ -4575,6 +7094,7 @@ std::string SceneSerializer::SerializeCookedRuntimeScene(Scene* scene, bool incl
     options.includeEditorOnly = includeEditorOnly;
     options.embedRuntimePayloads = true;
     json root = BuildSceneJson(scene, "", options);
+    BuildCookedAssetTable(root);
     return root.dump();
 }
 
@@ -4583,8 +7103,10 @@ std::vector<uint8_t> SceneSerializer::SerializeCookedRuntimeSceneBinary(Scene* s
     options.includeEditorOnly = includeEditorOnly;
     options.embedRuntimePayloads = true;
     options.externalizeRuntimeMeshes = true;
+    options.compressAnimationClips = true;
     json root = BuildSceneJson(scene, "", options);
-    return json::to_msgpack(root);
+    BuildCookedAssetTable(root);
+    return EncodeFlatScene(std::move(root));
 }
 
 bool SceneSerializer::DeserializeScene(Scene* scene, const std::string& data) {
@@ -4603,15 +7125,28 @@ bool SceneSerializer::DeserializeScene(Scene* scene, const std::string& data, co
     return DeserializeSceneRoot(scene, root, scenePath);
 }
 
+std::vector<uint8_t> SceneSerializer::SerializeCookedMesh(const Mesh& mesh, bool gpuLayout) {
+    return SerializeCookedMeshBinary(mesh, gpuLayout ? CookedMeshEncoding::GpuLayout : CookedMeshEncoding::Compressed);
+}
+
+std::shared_ptr<Mesh> SceneSerializer::DeserializeCookedMesh(const std::vector<uint8_t>& bytes) {
+    return DeserializeCookedMeshBinary(bytes);
+}
+
 bool SceneSerializer::DeserializeSceneBinary(Scene* scene, const std::vector<uint8_t>& data, const std::string& scenePath) {
     if (!scene || data.empty()) {
         return false;
     }
-    auto parseStart = std::chrono::steady_clock::now();
     StartupLog("DeserializeSceneBinary bytes=" + std::to_string(data.size()));
+    if (IsFlatScene(data.data(), data.size())) {
+        return DeserializeFlatScene(scene, data.data(), data.size(), scenePath);
+    }
+    auto parseStart = std::chrono::steady_clock::now();
     json root = json::from_msgpack(data, true, false);
-    auto parseMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - parseStart).count();
+    const auto parseEnd = std::chrono::steady_clock::now();
+    auto parseMs = std::chrono::duration_cast<std::chrono::milliseconds>(parseEnd - parseStart).count();
     StartupLog("ParseSceneBinary msgpack in " + std::to_string(parseMs) + "ms");
+    StartupTrace::getInstance().addSpan("scene", "Parse scene msgpack", parseStart, parseEnd);
     if (root.is_discarded() || !root.is_object()) {
         return false;
     }
@@ -4673,6 +7208,7 @@ StaticLightingManifest SceneSerializer::BuildStaticLightingManifest(Scene* scene
         rendererRecord.lightmapPath = staticLighting.lightmapPath;
         rendererRecord.directionalLightmapPath = staticLighting.directionalLightmapPath;
         rendererRecord.shadowmaskPath = staticLighting.shadowmaskPath;
+        rendererRecord.contentHash = staticLighting.bakeHash;
         manifest.renderers.push_back(rendererRecord);
 
         if (staticLighting.lightmapIndex < 0) {
@@ -4686,6 +7222,9 @@ StaticLightingManifest SceneSerializer::BuildStaticLightingManifest(Scene* scene
             atlas.index = staticLighting.lightmapIndex;
             atlas.width = manifest.settings.atlasSize;
             atlas.height = manifest.settings.atlasSize;
+            if (atlas.index < static_cast<int>(manifest.settings.atlasBakeHashes.size())) {
+                atlas.bakeHash = manifest.settings.atlasBakeHashes[static_cast<size_t>(atlas.index)];
+            }
             atlas.expectedLightmapPath = BuildStaticLightingArtifactPath(scene, scenePath, atlas.index, "_light.exr");
             if (manifest.settings.directionalLightmaps) {
                 atlas.expectedDirectionalLightmapPath = BuildStaticLightingArtifactPath(scene, scenePath, atlas.index, "_dir.png");
@@ -4777,6 +7316,87 @@ bool SceneSerializer::LoadStaticLightingManifest(const std::string& manifestPath
     return true;
 }
 
+StaticLightingContentHashes SceneSerializer::HashStaticLightingContents(Scene* scene,
+                                                                       const SceneStaticLightingSettings& bakeSettings) {
+    StaticLightingContentHashes hashes;
+    if (!scene) {
+        return hashes;
+    }
+
+    auto hashBytes = [](uint64_t hash, const void* data, size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    };
+    auto hashString = [&](uint64_t hash, const std::string& value) {
+        return hashBytes(hash, value.data(), value.size());
+    };
+    const uint64_t seed = 14695981039346656037ull;
+
+    BuildSceneOptions options;
+    options.includeEditorOnly = false;
+    json root = BuildSceneJson(scene, "", options);
+    json settings = {
+        {"environment", root["sceneSettings"]["environment"]},
+        {"staticLighting", SerializeStaticLightingSettings(bakeSettings)}
+    };
+    hashes.settings = hashString(seed, settings.dump());
+
+    std::unordered_map<std::string, json*> recordByUUID;
+    if (root.contains("entities") && root["entities"].is_array()) {
+        for (json& record : root["entities"]) {
+            // Renaming does not change the lighting, and the bake's own outputs must not feed back.
+            record.erase("name");
+            if (record.contains("components") && record["components"].contains("MeshRenderer")) {
+                json& meshRenderer = record["components"]["MeshRenderer"];
+                if (meshRenderer.contains("staticLighting") && meshRenderer["staticLighting"].is_object()) {
+                    json& staticLighting = meshRenderer["staticLighting"];
+                    staticLighting.erase("lightmap");
+                    staticLighting.erase("directionalLightmap");
+                    staticLighting.erase("shadowmask");
+                    staticLighting.erase("bakeHash");
+                }
+            }
+            recordByUUID[record.value("uuid", std::string())] = &record;
+        }
+    }
+
+    std::unordered_map<const Mesh*, uint64_t> meshHashes;
+    for (const auto& entityPtr : scene->getAllEntities()) {
+        Entity* entity = entityPtr.get();
+        if (!entity) {
+            continue;
+        }
+        const std::string uuid = entity->getUUID().toString();
+        auto recordIt = recordByUUID.find(uuid);
+        if (recordIt == recordByUUID.end()) {
+            continue;
+        }
+
+        uint64_t hash = hashString(seed, recordIt->second->dump());
+        // A parent's move changes the world matrix without touching the entity's own record.
+        const Math::Matrix4x4 worldMatrix = entity->getTransform()->getWorldMatrix();
+        hash = hashBytes(hash, &worldMatrix, sizeof(worldMatrix));
+        auto* renderer = entity->getComponent<MeshRenderer>();
+        if (std::shared_ptr<Mesh> mesh = renderer ? renderer->getMesh() : nullptr) {
+            auto meshIt = meshHashes.find(mesh.get());
+            if (meshIt == meshHashes.end()) {
+                const auto& vertices = mesh->getVertices();
+                const auto& indices = mesh->getIndices();
+                uint64_t meshHash = hashBytes(seed, vertices.data(), vertices.size() * sizeof(Vertex));
+                meshHash = hashBytes(meshHash, indices.data(), indices.size() * sizeof(indices[0]));
+                meshIt = meshHashes.emplace(mesh.get(), meshHash).first;
+            }
+            hash = hashBytes(hash, &meshIt->second, sizeof(meshIt->second));
+        }
+        hashes.entities[uuid] = hash;
+    }
+    return hashes;
+}
+
 std::vector<Entity*> SceneSerializer::DuplicateEntities(Scene* scene, const std::vector<Entity*>& entities) {
     using json = nlohmann::json;
     std::vector<Entity*> duplicates;
@@ -1,7 +1,11 @@
 #pragma once
 
 #include "Scene.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace Crescent {
@@ -11,6 +15,7 @@ struct StaticLightingAtlasRecord {
     int width = 0;
     int height = 0;
     int rendererCount = 0;
+    std::string bakeHash; // inputs the atlas was baked from; see SceneStaticLightingSettings::atlasBakeHashes
     std::string lightmapPath;
     std::string directionalLightmapPath;
     std::string shadowmaskPath;
@@ -31,6 +36,7 @@ struct StaticLightingRendererRecord {
     std::string lightmapPath;
     std::string directionalLightmapPath;
     std::string shadowmaskPath;
+    std::string contentHash; // the renderer's content hash when its atlas was baked
 };
 
 struct StaticLightingManifest {
@@ -44,9 +50,29 @@ struct StaticLightingManifest {
     std::vector<StaticLightingRendererRecord> renderers;
 };
 
+// Content hashes for incremental static lighting bakes. `settings` covers the environment and the
+// bake settings passed in. An entity's hash covers its serialized components (less the lightmap
+// paths and hash a bake writes back), its world matrix and its mesh data.
+struct StaticLightingContentHashes {
+    uint64_t settings = 0;
+    std::unordered_map<std::string, uint64_t> entities; // by entity UUID
+};
+
+// A world partition cell or a whole scene read off the main thread, waiting to be activated (see
+// SceneStreamer and SceneManager::preloadScene).
+struct SceneCellPayload;
+class Mesh;
+
 class SceneSerializer {
 public:
     static bool SaveScene(Scene* scene, const std::string& path);
+    // SaveScene with only the snapshot on the calling thread: the scene's json is built there,
+    // then formatted and written on a background worker, reusing the text of every entity that
+    // did not change since the last save of the path. onDone runs on that worker. Returns false
+    // when nothing was queued or the lighting manifest (written with the snapshot) failed.
+    static bool SaveSceneAsync(Scene* scene, const std::string& path, std::function<void(bool)> onDone = {});
+    // Blocks until every queued SaveSceneAsync has written its file.
+    static void WaitForPendingSaves();
     static bool SaveCookedRuntimeScene(Scene* scene, const std::string& path, bool includeEditorOnly = false);
     static bool LoadScene(Scene* scene, const std::string& path);
 
@@ -63,6 +89,27 @@ public:
     static StaticLightingManifest BuildStaticLightingManifest(Scene* scene, const std::string& scenePath = "");
     static bool SaveStaticLightingManifest(Scene* scene, const std::string& scenePath = "");
     static bool LoadStaticLightingManifest(const std::string& manifestPath, StaticLightingManifest& outManifest);
+    static StaticLightingContentHashes HashStaticLightingContents(Scene* scene,
+                                                                  const SceneStaticLightingSettings& bakeSettings);
+
+    // World partition cells. ReadSceneCell only touches files and may run on any thread; it
+    // returns null when the cell cannot be read. ActivateSceneCell creates the cell's entities on
+    // the main thread until budgetMs is spent, appending the UUIDs of its root entities, and
+    // returns true once the last one exists.
+    static std::shared_ptr<SceneCellPayload> ReadSceneCell(const std::string& cellPath, const std::string& scenePath);
+    static bool ActivateSceneCell(Scene* scene, SceneCellPayload& payload, double budgetMs, std::vector<UUID>& outRoots);
+    // Whole scenes loaded ahead of activation. ReadScene is ReadSceneCell for a scene file and may
+    // run on any thread; outMemoryBytes receives what the loaded scene will hold, its file plus the
+    // GPU footprint it was cooked with. ActivateScenePayload fills an empty, inactive scene on the
+    // main thread until budgetMs is spent and returns true once the scene is complete. Scenes that
+    // are not flat are parsed by ReadScene and built in one call.
+    static std::shared_ptr<SceneCellPayload> ReadScene(const std::string& path, size_t* outMemoryBytes = nullptr);
+    static bool ActivateScenePayload(Scene* scene, SceneCellPayload& payload, double budgetMs);
+
+    // The cooked mesh codec on its own, for tools. gpuLayout writes the version 7 streams the
+    // geometry arenas map directly instead of the meshopt-compressed ones; decode takes either.
+    static std::vector<uint8_t> SerializeCookedMesh(const Mesh& mesh, bool gpuLayout = false);
+    static std::shared_ptr<Mesh> DeserializeCookedMesh(const std::vector<uint8_t>& bytes);
 };
 
 } // namespace Crescent
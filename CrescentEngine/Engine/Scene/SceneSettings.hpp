@@ -1,7 +1,9 @@
 #pragma once
 
 #include "../Math/Vector3.hpp"
+#include <array>
 #include <string>
+#include <vector>
 
 namespace Crescent {
 
@@ -36,6 +38,8 @@ struct SceneFogSettings {
     float volumetricAnisotropy = 0.4f;
     float volumetricHistoryWeight = 0.9f;
     int volumetricQuality = 1; // 0 = Low, 1 = Medium, 2 = High
+    // Froxels lit per frame, the rest reproject last frame's volume: 0 = All, 1 = Half, 2 = Quarter.
+    int volumetricUpdateRate = 1;
 };
 
 struct ScenePostProcessSettings {
@@ -82,7 +86,44 @@ struct SceneQualitySettings {
     float renderScale = 1.0f;
     float lodBias = 0.0f;
     int textureQuality = 2;
-    int upscaler = 0; // 0 = Off, 1 = MetalFX Temporal
+    int upscaler = 0; // 0 = Off, 1 = MetalFX Temporal, 2 = MetalFX Spatial
+    // Present a MetalFX-interpolated frame between rendered frames (needs the temporal upscaler).
+    bool frameInterpolation = false;
+    // Frames between shadow refreshes per cascade (1-8); skipped frames reuse the last render.
+    std::array<int, 4> shadowCascadeUpdateIntervals = {1, 1, 1, 1};
+    int shadowUpdateBudget = 0; // caster draws per frame for time-sliced shadow views, 0 = unlimited
+    // Run these compute passes on the async compute queue, overlapping the frame's raster work.
+    bool asyncClusterBuild = true;
+    bool asyncFogVolume = true;
+    int ssaoResolution = 1; // 0 = Full, 1 = Half, 2 = Quarter
+    // Lower the game view's render scale (down to the minimum) while its GPU time misses the target.
+    bool dynamicResolution = false;
+    float dynamicResolutionTargetMs = 16.6f;
+    float dynamicResolutionMinScale = 0.5f;
+    // Render the game view's main pass through a rasterization rate map that shades the screen
+    // edges at the periphery rate (per axis, 0.25-1).
+    bool variableRateShading = false;
+    float variableRateShadingPeriphery = 0.5f;
+    // Live GPU particles across all emitters; each emitter's pool is cut to its share. 0 draws none.
+    int particleBudget = 262144;
+    // Particles of emitters that collide bounce off the depth buffer.
+    bool particleCollision = true;
+    // Evaluate the main pass light loop's BRDF in half precision (fragment_main variants): cheaper
+    // on register-bound GPUs, with positions, depth, shadows and light accumulation still in float.
+    bool halfPrecisionShading = false;
+    // Shade the GPU-driven static scene from a visibility buffer: after the depth prepass its
+    // batches write instance and triangle ids, and the main pass shades each material's pixels
+    // once from them instead of rasterizing the batches again. Ignored with MSAA or variable rate
+    // shading.
+    bool visibilityBuffer = false;
+    // Narrower intermediates to save bandwidth: RG11B10Float HDR color and bloom, octahedral
+    // RGB10A2 prepass normals and RGBA8 decal targets. HDR color stays RGBA16Float while a
+    // MetalFX upscaler is selected. Unmeasured: no before/after pass timings exist yet, so it
+    // stays opt-in.
+    bool compactRenderTargets = false;
+    // Cook animation clips with every frame of their resampled grid kept: larger clips, but
+    // sampling indexes frames directly instead of searching the reduced keys.
+    bool uniformAnimationClips = false;
 };
 
 struct SceneStaticLightingSettings {
@@ -94,6 +135,20 @@ struct SceneStaticLightingSettings {
     int samplesPerTexel = 256;
     int indirectBounces = 3;
     bool denoise = true;
+    // Trace on the GPU when the device supports ray tracing; falls back to the CPU baker otherwise.
+    // Opt-in until the lightBakeKernel output has been checked against the CPU baker; GPU bakes log
+    // their parity with it for a spread of the first pass's texels.
+    bool gpuBake = false;
+    // Trace samplesPerTexel over progressivePasses passes and write the partial atlases to the
+    // lightmap paths at most every progressivePreviewSeconds, so the viewport shows the bake
+    // converge. progressiveFrameBudgetMs is how long the bake traces before the editor gets a frame.
+    bool progressiveBake = false;
+    int progressivePasses = 4;
+    float progressivePreviewSeconds = 2.0f;
+    float progressiveFrameBudgetMs = 50.0f;
+    // A re-bake redoes an atlas when static objects within this distance of it change, besides
+    // its own renderers and whatever can shadow it from its lights.
+    float indirectInfluenceRadius = 16.0f;
     bool bakeDirectLighting = false;
     bool directionalLightmaps = false;
     bool shadowmask = false;
@@ -105,6 +160,23 @@ struct SceneStaticLightingSettings {
     int probeCountY = 4;
     int probeCountZ = 8;
     int probeSamples = 96;
+    // Dense probe bricks the renderer keeps resident, nearest the camera first.
+    int probeStreamingBrickBudget = 512;
+    // Re-trace the probe grid on the GPU at runtime instead of reading the bake, so moving objects
+    // and lights bounce. dynamicProbesPerFrame probes take dynamicProbeRays rays each per frame and
+    // keep dynamicProbeHysteresis of their previous value.
+    bool dynamicProbes = false;
+    int dynamicProbesPerFrame = 32;
+    int dynamicProbeRays = 64;
+    float dynamicProbeHysteresis = 0.9f;
+    // Runtime reflection cubes on the dynamic probe path: the dynamicReflectionProbes lattice
+    // points nearest the camera keep a dynamicReflectionResolution capture each, of which
+    // dynamicReflectionFacesPerFrame faces are re-traced per frame before the cube is prefiltered
+    // and blended over the baked reflections.
+    bool dynamicReflections = false;
+    int dynamicReflectionProbes = 8;
+    int dynamicReflectionResolution = 64;
+    int dynamicReflectionFacesPerFrame = 1;
     float reflectionProbeIntensity = 1.0f;
     float reflectionProbeBlendSharpness = 3.0f;
     float reflectionProbeFilterStrength = 1.0f;
@@ -118,6 +190,32 @@ struct SceneStaticLightingSettings {
     std::string bakeManifestPath;
     std::string probeDataPath;
     std::string lastBakeHash;
+    // Input hash of each atlas at its last bake, by atlas index; a re-bake keeps atlases that match.
+    std::vector<std::string> atlasBakeHashes;
+};
+
+// World partition for cooked runtime scenes. The cook splits static mesh hierarchies into XZ
+// grid cells with their own payloads; the runtime reads a cell in the background once the camera
+// comes within loadRadius of it and drops it again past unloadRadius.
+struct SceneStreamingSettings {
+    bool enabled = false;
+    float cellSize = 64.0f;
+    float loadRadius = 160.0f;
+    float unloadRadius = 200.0f;
+    // Main-thread time per frame spent creating and destroying streamed entities.
+    float activationBudgetMs = 2.0f;
+};
+
+// Navigation grid for AI movement, baked from the static colliders (see NavigationSystem).
+struct SceneNavigationSettings {
+    bool enabled = false;
+    float cellSize = 0.5f;
+    float agentRadius = 0.4f;
+    float agentHeight = 1.8f;
+    float maxSlopeDegrees = 45.0f;
+    float stepHeight = 0.4f;
+    // Set when a cooked scene carrying a grid loads: the grid file it was cooked with.
+    std::string cookedGridPath;
 };
 
 struct SceneSettings {
@@ -126,6 +224,8 @@ struct SceneSettings {
     ScenePostProcessSettings postProcess;
     SceneQualitySettings quality;
     SceneStaticLightingSettings staticLighting;
+    SceneStreamingSettings streaming;
+    SceneNavigationSettings navigation;
 };
 
 } // namespace Crescent
@@ -0,0 +1,497 @@
+#include "SceneSpatialIndex.hpp"
+#include "../ECS/Entity.hpp"
+#include "../ECS/Transform.hpp"
+#include "../ECS/TransformHierarchy.hpp"
+#include "../Components/MeshRenderer.hpp"
+#include "../Components/SkinnedMeshRenderer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace Crescent {
+
+namespace {
+
+SpatialBounds Union(const SpatialBounds& a, const SpatialBounds& b) {
+    return SpatialBounds{Math::Vector3::Min(a.min, b.min), Math::Vector3::Max(a.max, b.max)};
+}
+
+// Half the surface area, the insertion cost.
+float HalfArea(const SpatialBounds& b) {
+    const Math::Vector3 d = b.max - b.min;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+bool Contains(const SpatialBounds& outer, const SpatialBounds& inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+bool Overlaps(const SpatialBounds& a, const SpatialBounds& b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+float DistanceSquared(const SpatialBounds& b, const Math::Vector3& p) {
+    const float dx = std::max({b.min.x - p.x, 0.0f, p.x - b.max.x});
+    const float dy = std::max({b.min.y - p.y, 0.0f, p.y - b.max.y});
+    const float dz = std::max({b.min.z - p.z, 0.0f, p.z - b.max.z});
+    return dx * dx + dy * dy + dz * dz;
+}
+
+bool InFrustum(const Math::FrustumPlanes& planes, const SpatialBounds& b) {
+    for (const auto& p : planes) {
+        // The corner furthest along the plane normal.
+        const float x = p.x >= 0.0f ? b.max.x : b.min.x;
+        const float y = p.y >= 0.0f ? b.max.y : b.min.y;
+        const float z = p.z >= 0.0f ? b.max.z : b.min.z;
+        if (p.x * x + p.y * y + p.z * z + p.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Slab test; entry distance clamped to zero for rays that start inside.
+bool RayHits(const SpatialBounds& b, const Math::Vector3& origin, const Math::Vector3& invDirection,
+             float maxDistance, float& outDistance) {
+    float tmin = 0.0f;
+    float tmax = maxDistance;
+    const float o[3] = {origin.x, origin.y, origin.z};
+    const float inv[3] = {invDirection.x, invDirection.y, invDirection.z};
+    const float lo[3] = {b.min.x, b.min.y, b.min.z};
+    const float hi[3] = {b.max.x, b.max.y, b.max.z};
+    for (int axis = 0; axis < 3; ++axis) {
+        float t1 = (lo[axis] - o[axis]) * inv[axis];
+        float t2 = (hi[axis] - o[axis]) * inv[axis];
+        if (t1 > t2) {
+            std::swap(t1, t2);
+        }
+        // NaN from a zero direction on a slab face compares false and leaves the range alone.
+        tmin = t1 > tmin ? t1 : tmin;
+        tmax = t2 < tmax ? t2 : tmax;
+        if (tmin > tmax) {
+            return false;
+        }
+    }
+    outDistance = tmin;
+    return true;
+}
+
+// Per-thread traversal stack, so concurrent queries need no lock.
+std::vector<int32_t>& TraversalStack() {
+    thread_local std::vector<int32_t> stack;
+    stack.clear();
+    return stack;
+}
+
+} // namespace
+
+SpatialBounds SceneSpatialIndex::ComputeEntityBounds(const Entity* entity) {
+    SpatialBounds bounds;
+    if (auto* meshRenderer = entity->getComponent<MeshRenderer>(); meshRenderer && meshRenderer->getMesh()) {
+        meshRenderer->getWorldBounds(bounds.min, bounds.max);
+        return bounds;
+    }
+    if (auto* skinned = entity->getComponent<SkinnedMeshRenderer>()) {
+        skinned->getWorldBounds(bounds.min, bounds.max);
+        if (bounds.min.x <= bounds.max.x) {
+            return bounds;
+        }
+    }
+    const Transform* transform = entity->getTransform();
+    const Math::Vector3 position = transform ? transform->getPosition() : Math::Vector3::Zero;
+    const Math::Vector3 extent(kPointExtent, kPointExtent, kPointExtent);
+    bounds.min = position - extent;
+    bounds.max = position + extent;
+    return bounds;
+}
+
+void SceneSpatialIndex::track(Entity* entity) {
+    if (entity && std::find(m_Pending.begin(), m_Pending.end(), entity) == m_Pending.end()) {
+        m_Pending.push_back(entity);
+    }
+}
+
+void SceneSpatialIndex::remove(const Entity* entity, uint32_t index) {
+    auto pending = std::find(m_Pending.begin(), m_Pending.end(), entity);
+    if (pending != m_Pending.end()) {
+        m_Pending.erase(pending);
+    }
+    if (index >= m_Leaves.size() || m_Leaves[index] == kNull || m_Nodes[m_Leaves[index]].entity != entity) {
+        return;
+    }
+    const int32_t leaf = m_Leaves[index];
+    removeLeaf(leaf);
+    freeNode(leaf);
+    m_Leaves[index] = kNull;
+    --m_LeafCount;
+}
+
+void SceneSpatialIndex::clear() {
+    m_Nodes.clear();
+    m_Root = kNull;
+    m_FreeList = kNull;
+    m_LeafCount = 0;
+    m_Leaves.clear();
+    m_Tight.clear();
+    m_Pending.clear();
+}
+
+void SceneSpatialIndex::update(const std::vector<std::unique_ptr<Entity>>& entities, TransformHierarchy& hierarchy) {
+    if (m_Dirty) {
+        rebuild(entities);
+        hierarchy.consumeMoved([](Transform*) {});
+        m_Dirty = false;
+        return;
+    }
+    for (Entity* entity : m_Pending) {
+        place(entity);
+    }
+    m_Pending.clear();
+    hierarchy.consumeMoved([this](Transform* transform) {
+        if (Entity* entity = transform->getEntity()) {
+            place(entity);
+        }
+    });
+}
+
+void SceneSpatialIndex::rebuild(const std::vector<std::unique_ptr<Entity>>& entities) {
+    clear();
+    m_Nodes.reserve(entities.size() * 2);
+    for (const auto& entity : entities) {
+        place(entity.get());
+    }
+}
+
+void SceneSpatialIndex::place(Entity* entity) {
+    const uint32_t index = entity->getIndex();
+    if (index == Entity::kNoIndex) {
+        return;
+    }
+    if (index >= m_Leaves.size()) {
+        m_Leaves.resize(index + 1, kNull);
+        m_Tight.resize(index + 1);
+    }
+    const SpatialBounds tight = ComputeEntityBounds(entity);
+    m_Tight[index] = tight;
+
+    int32_t leaf = m_Leaves[index];
+    if (leaf != kNull) {
+        if (Contains(m_Nodes[leaf].bounds, tight)) {
+            return;
+        }
+        removeLeaf(leaf);
+    } else {
+        leaf = allocateNode();
+        m_Nodes[leaf].entity = entity;
+        m_Nodes[leaf].height = 0;
+        m_Leaves[index] = leaf;
+        ++m_LeafCount;
+    }
+    const Math::Vector3 margin(kMargin, kMargin, kMargin);
+    m_Nodes[leaf].bounds = SpatialBounds{tight.min - margin, tight.max + margin};
+    insertLeaf(leaf);
+}
+
+int32_t SceneSpatialIndex::allocateNode() {
+    int32_t node = m_FreeList;
+    if (node != kNull) {
+        m_FreeList = m_Nodes[node].parent;
+    } else {
+        node = static_cast<int32_t>(m_Nodes.size());
+        m_Nodes.emplace_back();
+    }
+    m_Nodes[node] = Node{};
+    m_Nodes[node].height = 0;
+    return node;
+}
+
+void SceneSpatialIndex::freeNode(int32_t node) {
+    m_Nodes[node] = Node{};
+    m_Nodes[node].parent = m_FreeList;
+    m_FreeList = node;
+}
+
+void SceneSpatialIndex::insertLeaf(int32_t leaf) {
+    if (m_Root == kNull) {
+        m_Root = leaf;
+        m_Nodes[leaf].parent = kNull;
+        return;
+    }
+
+    // Descend towards the sibling that grows the tree's surface area least.
+    const SpatialBounds leafBounds = m_Nodes[leaf].bounds;
+    int32_t index = m_Root;
+    while (!m_Nodes[index].isLeaf()) {
+        const Node& node = m_Nodes[index];
+        const float area = HalfArea(node.bounds);
+        const float combinedArea = HalfArea(Union(node.bounds, leafBounds));
+        const float cost = 2.0f * combinedArea;
+        const float inheritance = 2.0f * (combinedArea - area);
+        auto descendCost = [&](int32_t child) {
+            const SpatialBounds merged = Union(leafBounds, m_Nodes[child].bounds);
+            if (m_Nodes[child].isLeaf()) {
+                return HalfArea(merged) + inheritance;
+            }
+            return HalfArea(merged) - HalfArea(m_Nodes[child].bounds) + inheritance;
+        };
+        const float cost1 = descendCost(node.child1);
+        const float cost2 = descendCost(node.child2);
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const int32_t sibling = index;
+    const int32_t oldParent = m_Nodes[sibling].parent;
+    const int32_t newParent = allocateNode();
+    m_Nodes[newParent].parent = oldParent;
+    m_Nodes[newParent].bounds = Union(leafBounds, m_Nodes[sibling].bounds);
+    m_Nodes[newParent].height = m_Nodes[sibling].height + 1;
+    m_Nodes[newParent].child1 = sibling;
+    m_Nodes[newParent].child2 = leaf;
+    m_Nodes[sibling].parent = newParent;
+    m_Nodes[leaf].parent = newParent;
+    if (oldParent == kNull) {
+        m_Root = newParent;
+    } else if (m_Nodes[oldParent].child1 == sibling) {
+        m_Nodes[oldParent].child1 = newParent;
+    } else {
+        m_Nodes[oldParent].child2 = newParent;
+    }
+    refitUpwards(m_Nodes[leaf].parent);
+}
+
+void SceneSpatialIndex::removeLeaf(int32_t leaf) {
+    if (leaf == m_Root) {
+        m_Root = kNull;
+        return;
+    }
+    const int32_t parent = m_Nodes[leaf].parent;
+    const int32_t grandParent = m_Nodes[parent].parent;
+    const int32_t sibling = m_Nodes[parent].child1 == leaf ? m_Nodes[parent].child2 : m_Nodes[parent].child1;
+    if (grandParent == kNull) {
+        m_Root = sibling;
+        m_Nodes[sibling].parent = kNull;
+        freeNode(parent);
+        return;
+    }
+    if (m_Nodes[grandParent].child1 == parent) {
+        m_Nodes[grandParent].child1 = sibling;
+    } else {
+        m_Nodes[grandParent].child2 = sibling;
+    }
+    m_Nodes[sibling].parent = grandParent;
+    freeNode(parent);
+    refitUpwards(grandParent);
+}
+
+void SceneSpatialIndex::refitUpwards(int32_t index) {
+    while (index != kNull) {
+        index = balance(index);
+        Node& node = m_Nodes[index];
+        node.height = 1 + std::max(m_Nodes[node.child1].height, m_Nodes[node.child2].height);
+        node.bounds = Union(m_Nodes[node.child1].bounds, m_Nodes[node.child2].bounds);
+        index = node.parent;
+    }
+}
+
+// Rotates the taller grandchild up when the subtree heights differ by more than one, the AVL step
+// of the classic dynamic AABB tree. Returns the node now at a's position.
+int32_t SceneSpatialIndex::balance(int32_t a) {
+    if (m_Nodes[a].isLeaf() || m_Nodes[a].height < 2) {
+        return a;
+    }
+    const int32_t b = m_Nodes[a].child1;
+    const int32_t c = m_Nodes[a].child2;
+    const int32_t diff = m_Nodes[c].height - m_Nodes[b].height;
+
+    auto rotateUp = [&](int32_t up, int32_t stay, bool upIsChild2) {
+        const int32_t f = m_Nodes[up].child1;
+        const int32_t g = m_Nodes[up].child2;
+        m_Nodes[up].child1 = a;
+        m_Nodes[up].parent = m_Nodes[a].parent;
+        m_Nodes[a].parent = up;
+        const int32_t upParent = m_Nodes[up].parent;
+        if (upParent == kNull) {
+            m_Root = up;
+        } else if (m_Nodes[upParent].child1 == a) {
+            m_Nodes[upParent].child1 = up;
+        } else {
+            m_Nodes[upParent].child2 = up;
+        }
+        // The taller grandchild stays under up, the other takes up's old slot under a.
+        const int32_t keep = m_Nodes[f].height > m_Nodes[g].height ? f : g;
+        const int32_t move = keep == f ? g : f;
+        m_Nodes[up].child2 = keep;
+        if (upIsChild2) {
+            m_Nodes[a].child2 = move;
+        } else {
+            m_Nodes[a].child1 = move;
+        }
+        m_Nodes[move].parent = a;
+        m_Nodes[a].bounds = Union(m_Nodes[stay].bounds, m_Nodes[move].bounds);
+        m_Nodes[a].height = 1 + std::max(m_Nodes[stay].height, m_Nodes[move].height);
+        m_Nodes[up].bounds = Union(m_Nodes[a].bounds, m_Nodes[keep].bounds);
+        m_Nodes[up].height = 1 + std::max(m_Nodes[a].height, m_Nodes[keep].height);
+        return up;
+    };
+
+    if (diff > 1) {
+        return rotateUp(c, b, true);
+    }
+    if (diff < -1) {
+        return rotateUp(b, c, false);
+    }
+    return a;
+}
+
+bool SceneSpatialIndex::getBounds(const Entity* entity, SpatialBounds& out) const {
+    const uint32_t index = entity ? entity->getIndex() : Entity::kNoIndex;
+    if (index >= m_Leaves.size() || m_Leaves[index] == kNull || m_Nodes[m_Leaves[index]].entity != entity) {
+        return false;
+    }
+    out = m_Tight[index];
+    return true;
+}
+
+void SceneSpatialIndex::queryAABB(const SpatialBounds& bounds, std::vector<Entity*>& out) const {
+    if (m_Root == kNull) {
+        return;
+    }
+    std::vector<int32_t>& stack = TraversalStack();
+    stack.push_back(m_Root);
+    while (!stack.empty()) {
+        const Node& node = m_Nodes[stack.back()];
+        stack.pop_back();
+        if (!Overlaps(node.bounds, bounds)) {
+            continue;
+        }
+        if (node.isLeaf()) {
+            if (Overlaps(m_Tight[node.entity->getIndex()], bounds)) {
+                out.push_back(node.entity);
+            }
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void SceneSpatialIndex::querySphere(const Math::Vector3& center, float radius, std::vector<Entity*>& out) const {
+    if (m_Root == kNull) {
+        return;
+    }
+    const float radiusSq = radius * radius;
+    std::vector<int32_t>& stack = TraversalStack();
+    stack.push_back(m_Root);
+    while (!stack.empty()) {
+        const Node& node = m_Nodes[stack.back()];
+        stack.pop_back();
+        if (DistanceSquared(node.bounds, center) > radiusSq) {
+            continue;
+        }
+        if (node.isLeaf()) {
+            if (DistanceSquared(m_Tight[node.entity->getIndex()], center) <= radiusSq) {
+                out.push_back(node.entity);
+            }
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void SceneSpatialIndex::queryFrustum(const Math::FrustumPlanes& planes, std::vector<Entity*>& out) const {
+    if (m_Root == kNull) {
+        return;
+    }
+    std::vector<int32_t>& stack = TraversalStack();
+    stack.push_back(m_Root);
+    while (!stack.empty()) {
+        const Node& node = m_Nodes[stack.back()];
+        stack.pop_back();
+        if (!InFrustum(planes, node.bounds)) {
+            continue;
+        }
+        if (node.isLeaf()) {
+            if (InFrustum(planes, m_Tight[node.entity->getIndex()])) {
+                out.push_back(node.entity);
+            }
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void SceneSpatialIndex::raycast(const Math::Vector3& origin, const Math::Vector3& direction, float maxDistance,
+                                std::vector<SpatialRayHit>& out) const {
+    if (m_Root == kNull) {
+        return;
+    }
+    const size_t first = out.size();
+    const Math::Vector3 invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    std::vector<int32_t>& stack = TraversalStack();
+    stack.push_back(m_Root);
+    while (!stack.empty()) {
+        const Node& node = m_Nodes[stack.back()];
+        stack.pop_back();
+        float distance = 0.0f;
+        if (!RayHits(node.bounds, origin, invDirection, maxDistance, distance)) {
+            continue;
+        }
+        if (node.isLeaf()) {
+            if (RayHits(m_Tight[node.entity->getIndex()], origin, invDirection, maxDistance, distance)) {
+                out.push_back(SpatialRayHit{node.entity, distance});
+            }
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+    std::sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(),
+              [](const SpatialRayHit& a, const SpatialRayHit& b) { return a.distance < b.distance; });
+}
+
+void SceneSpatialIndex::nearest(const Math::Vector3& point, size_t k, std::vector<Entity*>& out,
+                                float maxDistance) const {
+    if (m_Root == kNull || k == 0) {
+        return;
+    }
+    // Best-first: nodes and leaves share one queue keyed on their box distance, so leaves come
+    // off it in distance order and the walk stops after k of them.
+    using Entry = std::pair<float, int32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    const float maxDistanceSq = maxDistance < std::sqrt(std::numeric_limits<float>::max())
+        ? maxDistance * maxDistance
+        : std::numeric_limits<float>::max();
+    queue.emplace(DistanceSquared(m_Nodes[m_Root].bounds, point), m_Root);
+    size_t found = 0;
+    while (!queue.empty() && found < k) {
+        const Entry entry = queue.top();
+        queue.pop();
+        if (entry.first > maxDistanceSq) {
+            break;
+        }
+        // Leaves come off twice: first keyed on their loose box, then re-queued (as -2 - index)
+        // on their tight one, which is final.
+        if (entry.second < 0) {
+            out.push_back(m_Nodes[-2 - entry.second].entity);
+            ++found;
+            continue;
+        }
+        const Node& node = m_Nodes[entry.second];
+        if (node.isLeaf()) {
+            queue.emplace(DistanceSquared(m_Tight[node.entity->getIndex()], point), -2 - entry.second);
+        } else {
+            queue.emplace(DistanceSquared(m_Nodes[node.child1].bounds, point), node.child1);
+            queue.emplace(DistanceSquared(m_Nodes[node.child2].bounds, point), node.child2);
+        }
+    }
+}
+
+} // namespace Crescent
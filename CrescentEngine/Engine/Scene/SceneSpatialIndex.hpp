@@ -0,0 +1,100 @@
+#pragma once
+
+#include "../Math/Math.hpp"
+#include "../Math/Frustum.hpp"
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace Crescent {
+
+class Entity;
+class TransformHierarchy;
+
+struct SpatialBounds {
+    Math::Vector3 min = Math::Vector3::Zero;
+    Math::Vector3 max = Math::Vector3::Zero;
+};
+
+struct SpatialRayHit {
+    Entity* entity = nullptr;
+    // Where the ray enters the entity's bounds; zero when it starts inside.
+    float distance = 0.0f;
+};
+
+// Dynamic AABB tree over the world bounds of a scene's entities: the mesh bounds of renderable
+// entities and a small box around the position of everything else. Leaves store their bounds
+// grown by kMargin, so a transform that moves within its margin only refreshes the tight box.
+// Scene::updateTransforms keeps the tree current once a frame from the hierarchy's moved record
+// and the entities queued with track. Queries are read-only, may run on several threads at once
+// and report inactive entities too, the caller filters; they see bounds as of the last update.
+class SceneSpatialIndex {
+public:
+    static constexpr float kMargin = 0.25f;
+    // Half extent of the box given to entities without renderable bounds.
+    static constexpr float kPointExtent = 0.5f;
+
+    // Rebuilds everything on the next update.
+    void markDirty() { m_Dirty = true; }
+    // Re-places the entity on the next update: new entities and changed component sets.
+    void track(Entity* entity);
+    // Drops a destroyed entity right away; entity is only compared, never read.
+    void remove(const Entity* entity, uint32_t index);
+    void clear();
+    void update(const std::vector<std::unique_ptr<Entity>>& entities, TransformHierarchy& hierarchy);
+
+    size_t size() const { return m_LeafCount; }
+
+    // Tight world bounds of an entity as of the last update; false if it is not indexed.
+    bool getBounds(const Entity* entity, SpatialBounds& out) const;
+
+    void queryAABB(const SpatialBounds& bounds, std::vector<Entity*>& out) const;
+    void querySphere(const Math::Vector3& center, float radius, std::vector<Entity*>& out) const;
+    void queryFrustum(const Math::FrustumPlanes& planes, std::vector<Entity*>& out) const;
+    // Entities whose bounds the ray crosses within maxDistance, nearest first. The direction
+    // must be normalized.
+    void raycast(const Math::Vector3& origin, const Math::Vector3& direction, float maxDistance,
+                 std::vector<SpatialRayHit>& out) const;
+    // Up to k entities whose bounds are closest to point, nearest first.
+    void nearest(const Math::Vector3& point, size_t k, std::vector<Entity*>& out,
+                 float maxDistance = std::numeric_limits<float>::max()) const;
+
+    static SpatialBounds ComputeEntityBounds(const Entity* entity);
+
+private:
+    static constexpr int32_t kNull = -1;
+
+    struct Node {
+        SpatialBounds bounds;
+        int32_t parent = kNull;
+        int32_t child1 = kNull;
+        int32_t child2 = kNull;
+        // Leaf is 0; free nodes are -1 and chain through parent.
+        int32_t height = -1;
+        Entity* entity = nullptr;
+
+        bool isLeaf() const { return child1 == kNull; }
+    };
+
+    void rebuild(const std::vector<std::unique_ptr<Entity>>& entities);
+    void place(Entity* entity);
+    int32_t allocateNode();
+    void freeNode(int32_t node);
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    int32_t balance(int32_t node);
+    void refitUpwards(int32_t node);
+
+    std::vector<Node> m_Nodes;
+    int32_t m_Root = kNull;
+    int32_t m_FreeList = kNull;
+    size_t m_LeafCount = 0;
+    // By entity index (Entity::getIndex): the leaf and the tight bounds.
+    std::vector<int32_t> m_Leaves;
+    std::vector<SpatialBounds> m_Tight;
+    std::vector<Entity*> m_Pending;
+    bool m_Dirty = true;
+};
+
+} // namespace Crescent
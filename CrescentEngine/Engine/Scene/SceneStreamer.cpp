@@ -0,0 +1,276 @@
+#include "SceneStreamer.hpp"
+#include "Scene.hpp"
+#include "SceneSerializer.hpp"
+#include "../Physics/PhysicsWorld.hpp"
+#include "../Core/StartupTrace.hpp"
+#include "../Core/ThreadQoS.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace Crescent {
+
+struct SceneStreamer::ReadQueue {
+    struct Request {
+        size_t cell = 0;
+        std::string path;
+        uint64_t generation = 0;
+    };
+    struct Result {
+        size_t cell = 0;
+        uint64_t generation = 0;
+        std::shared_ptr<SceneCellPayload> payload;
+    };
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Request> pending;
+    std::vector<Result> completed;
+    std::thread thread;
+    std::string scenePath;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
+
+SceneStreamer::SceneStreamer(Scene* scene)
+    : m_Scene(scene)
+    , m_Reads(std::make_unique<ReadQueue>()) {
+}
+
+SceneStreamer::~SceneStreamer() {
+    stopReader();
+}
+
+void SceneStreamer::configure(const SceneStreamingSettings& settings,
+                              const std::vector<SceneStreamingCell>& cells,
+                              const std::string& scenePath) {
+    reset();
+    m_Settings = settings;
+    m_Settings.unloadRadius = std::max(m_Settings.unloadRadius, m_Settings.loadRadius);
+    m_ScenePath = scenePath;
+    m_Cells.reserve(cells.size());
+    for (const SceneStreamingCell& desc : cells) {
+        Cell cell;
+        cell.desc = desc;
+        m_Cells.push_back(std::move(cell));
+    }
+    if (!m_Cells.empty()) {
+        startReader();
+    }
+}
+
+void SceneStreamer::reset() {
+    stopReader();
+    m_Cells.clear();
+    m_ScenePath.clear();
+}
+
+void SceneStreamer::startReader() {
+    if (m_Reads->thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_Reads->mutex);
+        m_Reads->stopping = false;
+        m_Reads->scenePath = m_ScenePath;
+        ++m_Reads->generation;
+    }
+    m_Reads->thread = std::thread([this]() { readerLoop(); });
+}
+
+void SceneStreamer::stopReader() {
+    {
+        std::lock_guard<std::mutex> lock(m_Reads->mutex);
+        m_Reads->stopping = true;
+        m_Reads->pending.clear();
+    }
+    m_Reads->wake.notify_all();
+    if (m_Reads->thread.joinable()) {
+        m_Reads->thread.join();
+    }
+    // Payloads own meshes, which must go away on this thread.
+    std::lock_guard<std::mutex> lock(m_Reads->mutex);
+    m_Reads->completed.clear();
+}
+
+void SceneStreamer::readerLoop() {
+    SetCurrentThreadQoS(ThreadQoS::Utility);
+    while (true) {
+        ReadQueue::Request request;
+        std::string scenePath;
+        {
+            std::unique_lock<std::mutex> lock(m_Reads->mutex);
+            m_Reads->wake.wait(lock, [this]() { return m_Reads->stopping || !m_Reads->pending.empty(); });
+            if (m_Reads->stopping) {
+                return;
+            }
+            request = std::move(m_Reads->pending.front());
+            m_Reads->pending.pop_front();
+            scenePath = m_Reads->scenePath;
+        }
+        std::shared_ptr<SceneCellPayload> payload;
+        {
+            StartupTraceScope trace("scene", "Read scene cell", request.path);
+            payload = SceneSerializer::ReadSceneCell(request.path, scenePath);
+        }
+        std::lock_guard<std::mutex> lock(m_Reads->mutex);
+        m_Reads->completed.push_back({request.cell, request.generation, std::move(payload)});
+    }
+}
+
+void SceneStreamer::collectReads() {
+    std::vector<ReadQueue::Result> completed;
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_Reads->mutex);
+        completed.swap(m_Reads->completed);
+        generation = m_Reads->generation;
+    }
+    for (ReadQueue::Result& result : completed) {
+        if (result.generation != generation || result.cell >= m_Cells.size()) {
+            continue;
+        }
+        Cell& cell = m_Cells[result.cell];
+        if (cell.state != CellState::Reading) {
+            continue; // left the unload radius while it was read
+        }
+        if (!result.payload) {
+            // Parked as loaded so a missing file is not read again every frame.
+            std::cerr << "SceneStreamer: failed to read cell " << cell.desc.path << "\n";
+            cell.state = CellState::Loaded;
+            continue;
+        }
+        cell.payload = std::move(result.payload);
+        cell.state = CellState::Activating;
+    }
+}
+
+float SceneStreamer::distanceTo(const Cell& cell, const Math::Vector3& focus) const {
+    const float dx = std::max({cell.desc.boundsMin.x - focus.x, 0.0f, focus.x - cell.desc.boundsMax.x});
+    const float dz = std::max({cell.desc.boundsMin.z - focus.z, 0.0f, focus.z - cell.desc.boundsMax.z});
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+void SceneStreamer::update(const Math::Vector3& focus) {
+    if (m_Cells.empty() || !m_Scene) {
+        return;
+    }
+    collectReads();
+    if (PhysicsWorld* physics = m_Scene->getPhysicsWorld()) {
+        physics->setStreamingFocus(focus, m_Settings.loadRadius, m_Settings.unloadRadius);
+    }
+
+    std::vector<std::pair<float, size_t>> toRead;
+    std::vector<std::pair<float, size_t>> toActivate;
+    std::vector<size_t> toUnload;
+    std::vector<size_t> cancelled;
+    for (size_t i = 0; i < m_Cells.size(); ++i) {
+        Cell& cell = m_Cells[i];
+        const float distance = distanceTo(cell, focus);
+        const bool inside = distance <= m_Settings.loadRadius;
+        const bool outside = distance > m_Settings.unloadRadius;
+        switch (cell.state) {
+        case CellState::Unloaded:
+            if (inside) {
+                cell.state = CellState::Reading;
+                toRead.emplace_back(distance, i);
+            }
+            break;
+        case CellState::Reading:
+            if (outside) {
+                cell.state = CellState::Unloaded;
+                cancelled.push_back(i);
+            }
+            break;
+        case CellState::Activating:
+            if (outside) {
+                cell.payload.reset();
+                cell.state = CellState::Unloading;
+                toUnload.push_back(i);
+            } else {
+                toActivate.emplace_back(distance, i);
+            }
+            break;
+        case CellState::Loaded:
+            if (outside) {
+                cell.state = CellState::Unloading;
+                toUnload.push_back(i);
+            }
+            break;
+        case CellState::Unloading:
+            // Finishes even if the camera turned back; a reload recreates the same UUIDs.
+            toUnload.push_back(i);
+            break;
+        }
+    }
+
+    if (!toRead.empty() || !cancelled.empty()) {
+        std::sort(toRead.begin(), toRead.end());
+        std::lock_guard<std::mutex> lock(m_Reads->mutex);
+        if (!cancelled.empty()) {
+            auto& pending = m_Reads->pending;
+            pending.erase(std::remove_if(pending.begin(), pending.end(), [&cancelled](const ReadQueue::Request& request) {
+                return std::find(cancelled.begin(), cancelled.end(), request.cell) != cancelled.end();
+            }), pending.end());
+        }
+        for (const auto& [distance, index] : toRead) {
+            m_Reads->pending.push_back({index, m_Cells[index].desc.path, m_Reads->generation});
+        }
+    }
+    if (!toRead.empty()) {
+        m_Reads->wake.notify_one();
+    }
+
+    // Unloads go first so memory is given back before more is taken, then the nearest cells
+    // activate until the frame's budget is spent.
+    const auto start = std::chrono::steady_clock::now();
+    auto remainingMs = [&]() {
+        const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(m_Settings.activationBudgetMs) - elapsed;
+    };
+    for (size_t index : toUnload) {
+        Cell& cell = m_Cells[index];
+        while (!cell.roots.empty() && remainingMs() > 0.0) {
+            m_Scene->destroyEntity(cell.roots.back());
+            cell.roots.pop_back();
+        }
+        if (!cell.roots.empty()) {
+            return;
+        }
+        cell.state = CellState::Unloaded;
+    }
+    std::sort(toActivate.begin(), toActivate.end());
+    for (const auto& [distance, index] : toActivate) {
+        const double budget = remainingMs();
+        if (budget <= 0.0) {
+            return;
+        }
+        Cell& cell = m_Cells[index];
+        if (!SceneSerializer::ActivateSceneCell(m_Scene, *cell.payload, budget, cell.roots)) {
+            return;
+        }
+        cell.payload.reset();
+        cell.state = CellState::Loaded;
+    }
+}
+
+size_t SceneStreamer::getLoadedCellCount() const {
+    return static_cast<size_t>(std::count_if(m_Cells.begin(), m_Cells.end(), [](const Cell& cell) {
+        return cell.state == CellState::Loaded;
+    }));
+}
+
+size_t SceneStreamer::getPendingCellCount() const {
+    return static_cast<size_t>(std::count_if(m_Cells.begin(), m_Cells.end(), [](const Cell& cell) {
+        return cell.state == CellState::Reading || cell.state == CellState::Activating ||
+               cell.state == CellState::Unloading;
+    }));
+}
+
+} // namespace Crescent
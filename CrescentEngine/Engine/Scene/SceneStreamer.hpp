@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../Core/UUID.hpp"
+#include "../Math/Vector3.hpp"
+#include "SceneSettings.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Crescent {
+
+class Scene;
+struct SceneCellPayload;
+
+// One world partition cell of a cooked scene, as listed in its "worldPartition" block.
+struct SceneStreamingCell {
+    int x = 0;
+    int z = 0;
+    std::string path; // relative to the scene file
+    Math::Vector3 boundsMin = Math::Vector3(0.0f);
+    Math::Vector3 boundsMax = Math::Vector3(0.0f);
+    uint32_t entityCount = 0;
+};
+
+// Streams the world partition cells of a cooked runtime scene around a focus point. Cells inside
+// the load radius are read and parsed on a background thread, cooked meshes included, then their
+// entities are created on the main thread a few at a time within the activation budget; Jolt
+// bodies follow through the physics world's pending rebuilds. Cells past the unload radius are
+// destroyed under the same budget, and the gap between the radii keeps a camera on a cell border
+// from loading and unloading it every frame.
+class SceneStreamer {
+public:
+    enum class CellState {
+        Unloaded,
+        Reading,
+        Activating,
+        Loaded,
+        Unloading
+    };
+
+    explicit SceneStreamer(Scene* scene);
+    ~SceneStreamer();
+
+    void configure(const SceneStreamingSettings& settings,
+                   const std::vector<SceneStreamingCell>& cells,
+                   const std::string& scenePath);
+    // Forgets every cell without destroying its entities; the scene calls this when it clears.
+    void reset();
+    // Main thread, once per frame.
+    void update(const Math::Vector3& focus);
+
+    bool isConfigured() const { return !m_Cells.empty(); }
+    size_t getCellCount() const { return m_Cells.size(); }
+    size_t getLoadedCellCount() const;
+    // Cells being read, activated or unloaded.
+    size_t getPendingCellCount() const;
+
+private:
+    struct Cell {
+        SceneStreamingCell desc;
+        CellState state = CellState::Unloaded;
+        std::shared_ptr<SceneCellPayload> payload;
+        std::vector<UUID> roots;
+    };
+    struct ReadQueue;
+
+    void startReader();
+    void stopReader();
+    void readerLoop();
+    void collectReads();
+    float distanceTo(const Cell& cell, const Math::Vector3& focus) const;
+
+    Scene* m_Scene;
+    SceneStreamingSettings m_Settings;
+    std::string m_ScenePath;
+    std::vector<Cell> m_Cells;
+    std::unique_ptr<ReadQueue> m_Reads;
+};
+
+} // namespace Crescent
@@ -75,6 +75,39 @@ private enum PlayerCommandLine {
             return 0
         }
 
+        if arguments[1] == "--cook-pipeline-archive" {
+            guard arguments.count >= 5 else {
+                fputs("Usage: CrescentPlayer --cook-pipeline-archive <Project.cproj> <Output.metalarchive> <Scene.cscene>...\n", stderr)
+                return 2
+            }
+
+            let projectPath = arguments[2]
+            let outputPath = arguments[3]
+            let scenePaths = Array(arguments[4...])
+            let bridge = RuntimeBridge.shared()
+
+            guard bridge.initialize() else {
+                fputs("Failed to initialize runtime bridge for pipeline archive cooking.\n", stderr)
+                return 1
+            }
+            defer {
+                bridge.shutdown()
+            }
+
+            guard bridge.openProject(path: projectPath) else {
+                fputs("Failed to open project for pipeline archive cooking.\n", stderr)
+                return 1
+            }
+
+            guard bridge.cookPipelineArchive(scenePaths: scenePaths, outputPath: outputPath) else {
+                fputs("Failed to cook pipeline archive.\n", stderr)
+                return 1
+            }
+
+            fputs("Cooked pipeline archive: \(outputPath)\n", stdout)
+            return 0
+        }
+
         if arguments[1] == "--bake-scene-lighting" {
             guard arguments.count >= 5 else {
                 fputs("Usage: CrescentPlayer --bake-scene-lighting <Project.cproj> <SourceScene.cscene> <OutputScene.cscene>\n", stderr)
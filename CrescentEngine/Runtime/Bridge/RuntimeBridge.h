@@ -10,6 +10,7 @@ NS_ASSUME_NONNULL_BEGIN
 - (BOOL)initialize;
 - (void)shutdown;
 - (BOOL)tick:(float)deltaTime NS_SWIFT_NAME(tick(deltaTime:));
+- (BOOL)tick:(float)deltaTime targetTimestamp:(CFTimeInterval)targetTimestamp NS_SWIFT_NAME(tick(deltaTime:targetTimestamp:));
 - (void)setSceneMetalLayer:(CAMetalLayer *)layer;
 - (void)setGameMetalLayer:(CAMetalLayer *)layer;
 - (void)setPreviewMetalLayer:(CAMetalLayer *)layer;
@@ -18,10 +19,10 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)resizePreviewWithWidth:(float)width height:(float)height NS_SWIFT_NAME(resizePreview(withWidth:height:));
 - (void)setAnimationPreviewTargetUUID:(NSString *)uuid NS_SWIFT_NAME(setAnimationPreviewTarget(uuid:));
 
-- (void)handleKeyDown:(unsigned short)keyCode;
-- (void)handleKeyUp:(unsigned short)keyCode;
-- (void)handleMouseMoveWithDeltaX:(float)deltaX deltaY:(float)deltaY;
-- (void)handleMouseButton:(int)button pressed:(BOOL)pressed;
+- (void)handleKeyDown:(unsigned short)keyCode timestamp:(NSTimeInterval)timestamp;
+- (void)handleKeyUp:(unsigned short)keyCode timestamp:(NSTimeInterval)timestamp;
+- (void)handleMouseMoveWithDeltaX:(float)deltaX deltaY:(float)deltaY timestamp:(NSTimeInterval)timestamp;
+- (void)handleMouseButton:(int)button pressed:(BOOL)pressed timestamp:(NSTimeInterval)timestamp;
 
 - (BOOL)openProjectAtPath:(NSString *)path NS_SWIFT_NAME(openProject(path:));
 - (NSDictionary *)getProjectSettings NS_SWIFT_NAME(getProjectSettings());
@@ -33,9 +34,16 @@ NS_ASSUME_NONNULL_BEGIN
 - (NSDictionary *)bakeSceneStaticLighting NS_SWIFT_NAME(bakeSceneStaticLighting());
 - (BOOL)cookEnvironmentMapAtPath:(NSString *)path outputPath:(NSString *)outputPath NS_SWIFT_NAME(cookEnvironmentMap(path:outputPath:));
 - (BOOL)cookStaticLightmapAtPath:(NSString *)path outputPath:(NSString *)outputPath NS_SWIFT_NAME(cookStaticLightmap(path:outputPath:));
+- (BOOL)cookPipelineArchiveWithScenePaths:(NSArray<NSString *> *)scenePaths outputPath:(NSString *)outputPath NS_SWIFT_NAME(cookPipelineArchive(scenePaths:outputPath:));
+- (BOOL)loadPipelineArchiveAtPath:(NSString *)path NS_SWIFT_NAME(loadPipelineArchive(path:));
 - (BOOL)saveSceneAtPath:(NSString *)path NS_SWIFT_NAME(saveScene(path:));
 - (BOOL)saveCookedRuntimeSceneAtPath:(NSString *)path includeEditorOnly:(BOOL)includeEditorOnly NS_SWIFT_NAME(saveCookedRuntimeScene(path:includeEditorOnly:));
 - (BOOL)loadSceneAtPath:(NSString *)path NS_SWIFT_NAME(loadScene(path:));
+// Level transitions without a loading screen: the scene loads beside the active one, and once
+// preloadedSceneState reports ready (0 none, 1 loading, 2 ready, 3 failed) replaces it in a frame.
+- (BOOL)preloadSceneAtPath:(NSString *)path NS_SWIFT_NAME(preloadScene(path:));
+- (int)preloadedSceneState NS_SWIFT_NAME(preloadedSceneState());
+- (BOOL)activatePreloadedScene NS_SWIFT_NAME(activatePreloadedScene());
 - (void)setViewMode:(int)mode NS_SWIFT_NAME(setViewMode(_:));
 - (void)enterPlayMode NS_SWIFT_NAME(enterPlayMode());
 - (void)exitPlayMode NS_SWIFT_NAME(exitPlayMode());
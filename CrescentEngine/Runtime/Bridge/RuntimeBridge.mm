@@ -20,6 +20,9 @@
 - (BOOL)initialize { return [[self bridge] initialize]; }
 - (void)shutdown { [[self bridge] shutdown]; }
 - (BOOL)tick:(float)deltaTime { return [[self bridge] tick:deltaTime]; }
+- (BOOL)tick:(float)deltaTime targetTimestamp:(CFTimeInterval)targetTimestamp {
+    return [[self bridge] tick:deltaTime targetTimestamp:targetTimestamp];
+}
 - (void)setSceneMetalLayer:(CAMetalLayer *)layer { [[self bridge] setSceneMetalLayer:layer]; }
 - (void)setGameMetalLayer:(CAMetalLayer *)layer { [[self bridge] setGameMetalLayer:layer]; }
 - (void)setPreviewMetalLayer:(CAMetalLayer *)layer { (void)layer; }
@@ -27,10 +30,14 @@
 - (void)resizeGameWithWidth:(float)width height:(float)height { [[self bridge] resizeGameWithWidth:width height:height]; }
 - (void)resizePreviewWithWidth:(float)width height:(float)height { (void)width; (void)height; }
 - (void)setAnimationPreviewTargetUUID:(NSString *)uuid { (void)uuid; }
-- (void)handleKeyDown:(unsigned short)keyCode { [[self bridge] handleKeyDown:keyCode]; }
-- (void)handleKeyUp:(unsigned short)keyCode { [[self bridge] handleKeyUp:keyCode]; }
-- (void)handleMouseMoveWithDeltaX:(float)deltaX deltaY:(float)deltaY { [[self bridge] handleMouseMoveWithDeltaX:deltaX deltaY:deltaY]; }
-- (void)handleMouseButton:(int)button pressed:(BOOL)pressed { [[self bridge] handleMouseButton:button pressed:pressed]; }
+- (void)handleKeyDown:(unsigned short)keyCode timestamp:(NSTimeInterval)timestamp { [[self bridge] handleKeyDown:keyCode timestamp:timestamp]; }
+- (void)handleKeyUp:(unsigned short)keyCode timestamp:(NSTimeInterval)timestamp { [[self bridge] handleKeyUp:keyCode timestamp:timestamp]; }
+- (void)handleMouseMoveWithDeltaX:(float)deltaX deltaY:(float)deltaY timestamp:(NSTimeInterval)timestamp {
+    [[self bridge] handleMouseMoveWithDeltaX:deltaX deltaY:deltaY timestamp:timestamp];
+}
+- (void)handleMouseButton:(int)button pressed:(BOOL)pressed timestamp:(NSTimeInterval)timestamp {
+    [[self bridge] handleMouseButton:button pressed:pressed timestamp:timestamp];
+}
 - (BOOL)openProjectAtPath:(NSString *)path { return [[self bridge] openProjectAtPath:path]; }
 - (NSDictionary *)getProjectSettings { return [[self bridge] getProjectSettings]; }
 - (NSDictionary *)getProjectInfo { return [[self bridge] getProjectInfo]; }
@@ -41,11 +48,18 @@
 - (NSDictionary *)bakeSceneStaticLighting { return [[self bridge] bakeSceneStaticLighting]; }
 - (BOOL)cookEnvironmentMapAtPath:(NSString *)path outputPath:(NSString *)outputPath { return [[self bridge] cookEnvironmentMap:path outputPath:outputPath]; }
 - (BOOL)cookStaticLightmapAtPath:(NSString *)path outputPath:(NSString *)outputPath { return [[self bridge] cookStaticLightmap:path outputPath:outputPath]; }
+- (BOOL)cookPipelineArchiveWithScenePaths:(NSArray<NSString *> *)scenePaths outputPath:(NSString *)outputPath {
+    return [[self bridge] cookPipelineArchive:scenePaths outputPath:outputPath];
+}
+- (BOOL)loadPipelineArchiveAtPath:(NSString *)path { return [[self bridge] loadPipelineArchive:path]; }
 - (BOOL)saveSceneAtPath:(NSString *)path { return [[self bridge] saveSceneAtPath:path]; }
 - (BOOL)saveCookedRuntimeSceneAtPath:(NSString *)path includeEditorOnly:(BOOL)includeEditorOnly {
     return [[self bridge] saveCookedRuntimeSceneAtPath:path includeEditorOnly:includeEditorOnly];
 }
 - (BOOL)loadSceneAtPath:(NSString *)path { return [[self bridge] loadSceneAtPath:path]; }
+- (BOOL)preloadSceneAtPath:(NSString *)path { return [[self bridge] preloadSceneAtPath:path]; }
+- (int)preloadedSceneState { return [[self bridge] preloadedSceneState]; }
+- (BOOL)activatePreloadedScene { return [[self bridge] activatePreloadedScene]; }
 - (void)setViewMode:(int)mode { [[self bridge] setViewMode:mode]; }
 - (void)enterPlayMode { [[self bridge] enterPlayMode]; }
 - (void)exitPlayMode { [[self bridge] exitPlayMode]; }
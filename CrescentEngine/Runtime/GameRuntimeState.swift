@@ -13,6 +13,7 @@ enum RuntimeAntiAliasingMode: String, Codable, CaseIterable, Identifiable {
 enum RuntimeUpscalerMode: String, Codable, CaseIterable, Identifiable {
     case off = "Off"
     case metalFX = "MetalFX"
+    case metalFXSpatial = "MetalFX Spatial"
 
     var id: String { rawValue }
 }
@@ -128,6 +129,14 @@ struct RuntimeGraphicsSettings: Codable, Equatable {
     var vignetteIntensity: Double = 0.3
     var filmGrain: Bool = false
     var filmGrainIntensity: Double = 0.15
+    // Optional so settings stored before it existed still decode.
+    var frameRateCap: Int?
+
+    // Frames per second the player's display link runs at; 0 follows the display.
+    var frameRateLimit: Int {
+        get { frameRateCap ?? 0 }
+        set { frameRateCap = newValue }
+    }
 
     init() {}
 
@@ -166,9 +175,12 @@ struct RuntimeGraphicsSettings: Codable, Equatable {
             renderScale = quality["renderScale"] as? Double ?? renderScale
             lodBias = quality["lodBias"] as? Double ?? lodBias
             textureQuality = quality["textureQuality"] as? Int ?? textureQuality
-            if let upscalerValue = quality["upscaler"] as? Int, upscalerValue == 1 {
+            switch quality["upscaler"] as? Int {
+            case 1:
                 upscaler = .metalFX
-            } else {
+            case 2:
+                upscaler = .metalFXSpatial
+            default:
                 upscaler = .off
             }
         }
@@ -195,6 +207,7 @@ struct RuntimeGraphicsSettings: Codable, Equatable {
         dofAperture = min(max(dofAperture, 1.2), 16.0)
         vignetteIntensity = min(max(vignetteIntensity, 0.0), 1.0)
         filmGrainIntensity = min(max(filmGrainIntensity, 0.0), 1.0)
+        frameRateLimit = [0, 30, 60, 120].contains(frameRateLimit) ? frameRateLimit : 0
     }
 
     func toSceneSettingsPayload() -> [String: Any] {
@@ -231,7 +244,7 @@ struct RuntimeGraphicsSettings: Codable, Equatable {
                 "renderScale": renderScale,
                 "lodBias": lodBias,
                 "textureQuality": textureQuality,
-                "upscaler": upscaler == .metalFX ? 1 : 0
+                "upscaler": upscaler == .metalFX ? 1 : (upscaler == .metalFXSpatial ? 2 : 0)
             ]
         ]
     }
@@ -292,6 +305,16 @@ final class GameRuntimeState: ObservableObject {
         }
         startupLog(String(format: "openProject %.3fs", ProcessInfo.processInfo.systemUptime - openProjectStart))
 
+        let pipelineArchiveURL = gameDataURL.appendingPathComponent("Pipelines.metalarchive")
+        if FileManager.default.fileExists(atPath: pipelineArchiveURL.path) {
+            let pipelineArchiveStart = ProcessInfo.processInfo.systemUptime
+            if bridge.loadPipelineArchive(path: pipelineArchiveURL.path) {
+                startupLog(String(format: "loadPipelineArchive %.3fs", ProcessInfo.processInfo.systemUptime - pipelineArchiveStart))
+            } else {
+                startupLog("loadPipelineArchive failed; pipelines compile on demand")
+            }
+        }
+
         let settings = bridge.getProjectSettings() as? [String: Any] ?? [:]
         if let productName = settings["productName"] as? String, !productName.isEmpty {
             gameTitle = productName
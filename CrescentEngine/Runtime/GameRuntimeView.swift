@@ -13,6 +13,7 @@ struct GameRuntimeView: View {
                 viewKind: .game,
                 isActive: runtimeState.isRunning && !runtimeState.isSettingsMenuPresented,
                 drivesLoop: true,
+                frameRateCap: runtimeState.graphicsSettings.frameRateLimit,
                 onKeyDownIntercept: { keyCode in
                     guard keyCode == 53 else {
                         return false
@@ -219,6 +220,12 @@ private struct RuntimeSettingsPanel: View {
                                 selection: binding(\.upscaler),
                                 options: RuntimeUpscalerMode.allCases
                             )
+                            RuntimePickerRow(
+                                title: "Frame Rate",
+                                selection: binding(\.frameRateLimit),
+                                options: [0, 30, 60, 120],
+                                label: { $0 == 0 ? "Display" : "\($0) FPS" }
+                            )
                         }
                     }
 
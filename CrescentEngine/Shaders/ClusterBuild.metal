@@ -1,85 +1,225 @@
 #include "Common.metal.h"
 using namespace metal;
 
+// Cluster build constants; ClusterParams is shared with the lighting shaders, the rest is
+// build-only.
+struct ClusterCullParams {
+    ClusterParams cluster;
+    uint maxLightsPerTile;
+    uint hasDepthBounds;
+    uint _pad0;
+    uint _pad1;
+};
+
+struct ClusterCullStats {
+    atomic_uint indexCursor;      // next free slot in the compacted index list
+    atomic_uint activeClusters;   // clusters with at least one light
+    atomic_uint overflowLights;   // lights dropped by full clusters
+    atomic_uint overflowClusters; // clusters that hit maxLightsPerCluster
+    atomic_uint tileOverflowLights; // lights dropped by full coarse tiles
+    uint _pad0;
+    uint _pad1;
+    uint _pad2;
+};
+
 inline float3 unproject(float2 uv, float depth, float4x4 invProj) {
     float4 clip = float4(uv * 2.0 - 1.0, depth, 1.0);
     float4 view = invProj * clip;
     return view.xyz / view.w;
 }
 
+inline float linearViewDepth(float depth, float4x4 invProj) {
+    float4 view = invProj * float4(0.0, 0.0, depth, 1.0);
+    return -view.z / view.w;
+}
+
+// View-space AABB of the screen rect [ndcMin, ndcMax] between view depths zNear and zFar.
+// Depth 1 unprojects onto the far plane in both clip conventions, so the tile's corner rays come
+// from there and get rescaled to the requested depths.
+inline void tileViewAABB(float2 ndcMin, float2 ndcMax, float zNear, float zFar, float4x4 invProj,
+                         thread float3& aabbMin, thread float3& aabbMax) {
+    aabbMin = float3(INFINITY);
+    aabbMax = float3(-INFINITY);
+    for (int y = 0; y < 2; ++y) {
+        for (int x = 0; x < 2; ++x) {
+            float2 uv = float2(x ? ndcMax.x : ndcMin.x, y ? ndcMax.y : ndcMin.y) * 0.5 + 0.5;
+            float3 farPoint = unproject(uv, 1.0, invProj);
+            float3 ray = farPoint / max(-farPoint.z, 1e-6);
+            aabbMin = min(aabbMin, min(ray * zNear, ray * zFar));
+            aabbMax = max(aabbMax, max(ray * zNear, ray * zFar));
+        }
+    }
+}
+
+inline bool lightTouchesAABB(LightGPUData L, float3 aabbMin, float3 aabbMax) {
+    int type = (int)round(L.directionType.w);
+    if (type == 0) {
+        return true; // directional affects everything
+    }
+    float3 posVS = L.positionRange.xyz;
+    float radius = (L.positionRange.w > 0.0f) ? 1.0f / L.positionRange.w : 0.0f;
+    float3 closest = clamp(posVS, aabbMin, aabbMax);
+    float3 d = posVS - closest;
+    return dot(d, d) <= radius * radius;
+}
+
+inline void tileNdcBounds(uint2 tile, constant ClusterParams& params, thread float2& ndcMin, thread float2& ndcMax) {
+    ndcMin = float2(float(tile.x) / float(params.clusterX), float(tile.y) / float(params.clusterY)) * 2.0 - 1.0;
+    ndcMax = float2(float(tile.x + 1) / float(params.clusterX), float(tile.y + 1) / float(params.clusterY)) * 2.0 - 1.0;
+}
+
+// Farthest prepass depth of each screen tile, as view depth. One threadgroup per tile; the
+// tile's pixel rect is grown by one pixel so fractional tile edges stay conservative.
+kernel void cluster_tile_depth(depth2d<float, access::read> depthTex [[texture(0)]],
+                               device float* tileMaxDepth            [[buffer(0)]],
+                               constant ClusterCullParams& cull      [[buffer(1)]],
+                               uint2 tile [[threadgroup_position_in_grid]],
+                               uint2 lane [[thread_position_in_threadgroup]],
+                               uint2 laneCount [[threads_per_threadgroup]]) {
+    threadgroup atomic_uint groupMax;
+    if (lane.x == 0 && lane.y == 0) {
+        atomic_store_explicit(&groupMax, 0u, memory_order_relaxed);
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    constant ClusterParams& params = cull.cluster;
+    const uint width = depthTex.get_width();
+    const uint height = depthTex.get_height();
+    const float tileW = float(width) / float(params.clusterX);
+    const float tileH = float(height) / float(params.clusterY);
+    // Cluster rows count up from the bottom of the screen; texture rows from the top.
+    const uint flippedY = params.clusterY - 1 - tile.y;
+    const uint x0 = uint(max(0.0, floor(float(tile.x) * tileW) - 1.0));
+    const uint x1 = min(width, uint(ceil(float(tile.x + 1) * tileW)) + 1);
+    const uint y0 = uint(max(0.0, floor(float(flippedY) * tileH) - 1.0));
+    const uint y1 = min(height, uint(ceil(float(flippedY + 1) * tileH)) + 1);
+
+    float localMax = 0.0;
+    for (uint y = y0 + lane.y; y < y1; y += laneCount.y) {
+        for (uint x = x0 + lane.x; x < x1; x += laneCount.x) {
+            localMax = max(localMax, depthTex.read(uint2(x, y)));
+        }
+    }
+    // Non-negative floats order the same as their bit patterns.
+    atomic_fetch_max_explicit(&groupMax, as_type<uint>(localMax), memory_order_relaxed);
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    if (lane.x == 0 && lane.y == 0) {
+        const float maxDepth = as_type<float>(atomic_load_explicit(&groupMax, memory_order_relaxed));
+        const float viewDepth = maxDepth >= 1.0 ? params.farPlane : linearViewDepth(maxDepth, params.projectionInv);
+        // Small margin for the prepass jitter.
+        tileMaxDepth[tile.y * params.clusterX + tile.x] = clamp(viewDepth * 1.01, params.nearPlane, params.farPlane);
+    }
+}
+
+// Coarse level: every light against each screen tile's frustum, from the near plane to the
+// tile's farthest depth. Clusters then only test the lights of their tile.
+kernel void cluster_tile_lights(const device LightGPUData* lights   [[buffer(0)]],
+                                const device float* tileMaxDepth    [[buffer(1)]],
+                                device uint* tileIndices            [[buffer(2)]],
+                                device uint* tileCounts             [[buffer(3)]],
+                                device ClusterCullStats& stats      [[buffer(4)]],
+                                constant ClusterCullParams& cull    [[buffer(5)]],
+                                uint2 tid [[thread_position_in_grid]]) {
+    constant ClusterParams& params = cull.cluster;
+    if (tid.x >= params.clusterX || tid.y >= params.clusterY) {
+        return;
+    }
+    const uint tileId = tid.y * params.clusterX + tid.x;
+    const float zFar = cull.hasDepthBounds ? tileMaxDepth[tileId] : params.farPlane;
+
+    float2 ndcMin;
+    float2 ndcMax;
+    tileNdcBounds(tid, params, ndcMin, ndcMax);
+    float3 aabbMin;
+    float3 aabbMax;
+    tileViewAABB(ndcMin, ndcMax, params.nearPlane, zFar, params.projectionInv, aabbMin, aabbMax);
+
+    const uint base = tileId * cull.maxLightsPerTile;
+    uint count = 0;
+    for (uint i = 0; i < params.lightCount; ++i) {
+        if (!lightTouchesAABB(lights[i], aabbMin, aabbMax)) {
+            continue;
+        }
+        if (count < cull.maxLightsPerTile) {
+            tileIndices[base + count] = i;
+            ++count;
+        } else {
+            atomic_fetch_add_explicit(&stats.tileOverflowLights, 1, memory_order_relaxed);
+        }
+    }
+    tileCounts[tileId] = count;
+}
+
+// Fine level: each cluster tests its tile's lights and takes a compacted slot range in the index
+// list, so empty clusters (including every slice behind the tile's depth) take no space.
+// Only the far side is tightened: transparent surfaces still shade in front of the prepass depth.
 kernel void cluster_build(const device LightGPUData* lights        [[buffer(0)]],
                           device ClusterHeader* clusterHeaders     [[buffer(1)]],
                           device uint* clusterIndices              [[buffer(2)]],
-                          device atomic_uint* overflowCounter      [[buffer(3)]],
-                          constant ClusterParams& params           [[buffer(4)]],
+                          device ClusterCullStats& stats           [[buffer(3)]],
+                          constant ClusterCullParams& cull         [[buffer(4)]],
+                          const device float* tileMaxDepth         [[buffer(5)]],
+                          const device uint* tileIndices           [[buffer(6)]],
+                          const device uint* tileCounts            [[buffer(7)]],
                           uint3 tid [[thread_position_in_grid]]) {
+    constant ClusterParams& params = cull.cluster;
     if (tid.x >= params.clusterX || tid.y >= params.clusterY || tid.z >= params.clusterZ) {
         return;
     }
     uint clusterId = tid.z * (params.clusterX * params.clusterY) + tid.y * params.clusterX + tid.x;
-    
+    const uint tileId = tid.y * params.clusterX + tid.x;
+    clusterHeaders[clusterId].offset = 0;
+    clusterHeaders[clusterId].count = 0;
+
     // Compute depth slice bounds (log distribution)
     float slice = float(tid.z);
     float sliceCount = float(params.clusterZ);
     float zNear = params.nearPlane * pow(params.farPlane / params.nearPlane, slice / sliceCount);
     float zFar  = params.nearPlane * pow(params.farPlane / params.nearPlane, (slice + 1.0) / sliceCount);
-    
-    // Screen tile bounds in NDC
-    float2 ndcMin = float2(float(tid.x) / float(params.clusterX), float(tid.y) / float(params.clusterY));
-    float2 ndcMax = float2(float(tid.x + 1) / float(params.clusterX), float(tid.y + 1) / float(params.clusterY));
-    ndcMin = ndcMin * 2.0 - 1.0;
-    ndcMax = ndcMax * 2.0 - 1.0;
-    
-    // Build conservative AABB in view space
-    float3 corners[8];
-    uint c = 0;
-    for (int z = 0; z < 2; ++z) {
-        float depth = (z == 0) ? (zNear / params.farPlane * 2.0 - 1.0) : (zFar / params.farPlane * 2.0 - 1.0);
-        for (int y = 0; y < 2; ++y) {
-            for (int x = 0; x < 2; ++x) {
-                float2 uv = float2(x ? ndcMax.x : ndcMin.x, y ? ndcMax.y : ndcMin.y) * 0.5 + 0.5;
-                corners[c++] = unproject(uv, depth, params.projectionInv);
-            }
+    if (cull.hasDepthBounds) {
+        const float tileFar = tileMaxDepth[tileId];
+        if (zNear > tileFar) {
+            return; // nothing opaque reaches this slice and nothing behind it is visible
         }
+        zFar = min(zFar, tileFar);
     }
-    float3 aabbMin = corners[0];
-    float3 aabbMax = corners[0];
-    for (uint i = 1; i < 8; ++i) {
-        aabbMin = min(aabbMin, corners[i]);
-        aabbMax = max(aabbMax, corners[i]);
-    }
-    
-    // Offset for this cluster in index buffer
-    uint base = clusterId * params.maxLightsPerCluster;
-    uint count = 0;
-    
-    // Cull lights
-    for (uint i = 0; i < params.lightCount; ++i) {
-        LightGPUData L = lights[i];
-        int type = (int)round(L.directionType.w);
-        if (type == 0) {
-            // Directional affects all clusters
-        } else {
-            float3 posVS = L.positionRange.xyz;
-            float range = (L.positionRange.w > 0.0f) ? 1.0f / L.positionRange.w : 0.0f;
-            float radius = range;
-            // Sphere-AABB test
-            float3 closest = clamp(posVS, aabbMin, aabbMax);
-            float3 d = posVS - closest;
-            float dist2 = dot(d, d);
-            if (dist2 > radius * radius) {
-                continue;
-            }
+
+    float2 ndcMin;
+    float2 ndcMax;
+    tileNdcBounds(tid.xy, params, ndcMin, ndcMax);
+    float3 aabbMin;
+    float3 aabbMax;
+    tileViewAABB(ndcMin, ndcMax, zNear, zFar, params.projectionInv, aabbMin, aabbMax);
+
+    // Count first so the slot range can be reserved in one atomic.
+    const uint tileBase = tileId * cull.maxLightsPerTile;
+    const uint tileCount = tileCounts[tileId];
+    uint hits = 0;
+    for (uint i = 0; i < tileCount; ++i) {
+        if (lightTouchesAABB(lights[tileIndices[tileBase + i]], aabbMin, aabbMax)) {
+            ++hits;
         }
-        
-        if (count < params.maxLightsPerCluster) {
-            clusterIndices[base + count] = i;
-            ++count;
-        } else {
-            atomic_fetch_add_explicit(overflowCounter, 1, memory_order_relaxed);
+    }
+    if (hits == 0) {
+        return;
+    }
+    const uint count = min(hits, params.maxLightsPerCluster);
+    if (hits > count) {
+        atomic_fetch_add_explicit(&stats.overflowClusters, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats.overflowLights, hits - count, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&stats.activeClusters, 1, memory_order_relaxed);
+    const uint base = atomic_fetch_add_explicit(&stats.indexCursor, count, memory_order_relaxed);
+
+    uint written = 0;
+    for (uint i = 0; i < tileCount && written < count; ++i) {
+        const uint lightIndex = tileIndices[tileBase + i];
+        if (lightTouchesAABB(lights[lightIndex], aabbMin, aabbMax)) {
+            clusterIndices[base + written] = lightIndex;
+            ++written;
         }
     }
-    
     clusterHeaders[clusterId].offset = base;
     clusterHeaders[clusterId].count = count;
 }
@@ -23,10 +23,92 @@ static inline float2 directionToEquirectUV(float3 dir) {
     return uv;
 }
 
+// Sky-view LUT of the procedural sky (Sky.metal): world azimuth across, latitude down, with the
+// rows packed towards the horizon, where the sky changes fastest.
+static inline float2 skyViewLutUV(float3 dir) {
+    float latitude = asin(clamp(dir.y, -1.0, 1.0));
+    float v = 0.5 - 0.5 * sign(latitude) * sqrt(abs(latitude) / HALF_PI);
+    return float2(atan2(dir.z, dir.x) / TWO_PI + 0.5, v);
+}
+
+// Packed vertex stream (PackedVertexAttributes in Mesh.hpp): the normal arrives as an octahedral
+// snorm16 pair, the tangent as snorm 10:10:10 with the bitangent sign in w.
+static inline float3 decodeOctNormal(float2 e) {
+    float3 n = float3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += select(float2(t), float2(-t), n.xy >= 0.0);
+    return normalize(n);
+}
+
+static inline float3 decodeBitangent(float3 normal, float4 tangent) {
+    return cross(normal, tangent.xyz) * (tangent.w < 0.0 ? -1.0 : 1.0);
+}
+
+static inline float2 encodeOctNormal(float3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    float2 e = n.xy;
+    if (n.z < 0.0) {
+        e = (1.0 - abs(n.yx)) * select(float2(-1.0), float2(1.0), n.xy >= 0.0);
+    }
+    return e;
+}
+
+// Prepass normal target: the octahedral view-space normal in xy and the roughness in z, unorm
+// ranged so RGB10A2Unorm (compactRenderTargets) holds it as well as RGBA16Float. View-space
+// normals stay on the camera-facing half of the octahedron, so filtered reads do not cross its
+// folds.
+static inline float4 encodeNormalRoughness(float3 n, float roughness) {
+    return float4(encodeOctNormal(n) * 0.5 + 0.5, roughness, 1.0);
+}
+
+static inline float3 decodeTargetNormal(float4 encoded) {
+    return decodeOctNormal(encoded.xy * 2.0 - 1.0);
+}
+
+static inline float decodeTargetRoughness(float4 encoded) {
+    return clamp(encoded.z, 0.0, 1.0);
+}
+
+// Raw PackedVertexAttributes as read by the mesh shaders, which fetch without a vertex descriptor.
+struct PackedVertexData {
+    packed_half2 texCoord;
+    packed_half2 texCoord1;
+    packed_short2 normal;
+    uint tangent;
+    uchar4 color;
+};
+
+static inline float2 decodePackedNormal(packed_short2 normal) {
+    return max(float2(short2(normal)) / 32767.0, float2(-1.0));
+}
+
+// Same result as the Int1010102Normalized vertex format.
+static inline float4 decodePackedTangent(uint tangent) {
+    int3 t = int3(int(tangent << 22), int(tangent << 12), int(tangent << 2)) >> 22;
+    float w = float(int(tangent) >> 30);
+    return float4(max(float3(t) / 511.0, float3(-1.0)), max(w, -1.0));
+}
+
+// Inverses of the two decoders above, for kernels that write the packed stream (skin_vertices).
+static inline packed_short2 encodePackedNormal(float3 n) {
+    n /= max(abs(n.x) + abs(n.y) + abs(n.z), 1e-6);
+    float2 e = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * select(float2(-1.0), float2(1.0), n.xy >= 0.0);
+    short2 q = short2(round(clamp(e, -1.0, 1.0) * 32767.0));
+    return packed_short2(q);
+}
+
+static inline uint encodePackedTangent(float4 tangent) {
+    int3 t = int3(round(clamp(tangent.xyz, -1.0, 1.0) * 511.0));
+    uint w = tangent.w < 0.0 ? 3u : 1u;
+    return (uint(t.x) & 0x3ffu) | ((uint(t.y) & 0x3ffu) << 10) | ((uint(t.z) & 0x3ffu) << 20) | (w << 30);
+}
+
 // ============================================================================
 // SHARED UNIFORM STRUCTURES
 // ============================================================================
 
+// normalMatrix only ever transforms directions, so its translation column is free: [3].x carries
+// the LOD cross-fade dither (see lodDitherDiscard in PBR.metal), 0 when the draw is not fading.
 struct ModelUniforms {
     float4x4 modelMatrix;
     float4x4 normalMatrix;
@@ -37,16 +119,193 @@ struct InstanceData {
     float4x4 normalMatrix;
 };
 
+// Vertex animation textures (VertexAnimationTexture.hpp). normalMatrix[3].z of an instance holds
+// its time offset in seconds and [3].w its playback speed.
+struct VertexAnimationParams {
+    float4 boundsMin;    // w scene time in seconds
+    float4 boundsExtent; // w clip duration in seconds
+    uint4 layout;        // x vertex columns, y rows per frame, z frame count, w 1 when the clip loops
+};
+
+static inline void vatFetchFrame(texture2d<float> vat, constant VertexAnimationParams& params,
+                                 uint frame, uint vertexId, thread float3& position, thread float3& normal) {
+    uint columns = params.layout.x;
+    uint2 texel = uint2(vertexId % columns, frame * params.layout.y + vertexId / columns);
+    position = params.boundsMin.xyz + vat.read(texel).xyz * params.boundsExtent.xyz;
+    normal = decodeOctNormal(vat.read(texel + uint2(columns, 0)).xy * 2.0 - 1.0);
+}
+
+// Object-space position and normal of a vertex at the instance's point in the clip, blended
+// between the two nearest baked frames.
+static inline void vatSample(texture2d<float> vat, constant VertexAnimationParams& params, InstanceData inst,
+                             uint vertexId, thread float3& position, thread float3& normal) {
+    float duration = max(params.boundsExtent.w, 1e-4);
+    float t = (params.boundsMin.w * inst.normalMatrix[3].w + inst.normalMatrix[3].z) / duration;
+    float phase = params.layout.w != 0 ? fract(t) : saturate(t);
+    uint lastFrame = params.layout.z - 1;
+    float frame = phase * float(lastFrame);
+    uint frame0 = min(uint(frame), lastFrame);
+    uint frame1 = min(frame0 + 1, lastFrame);
+    float3 p0, n0, p1, n1;
+    vatFetchFrame(vat, params, frame0, vertexId, p0, n0);
+    vatFetchFrame(vat, params, frame1, vertexId, p1, n1);
+    float blend = frame - float(frame0);
+    position = mix(p0, p1, blend);
+    normal = normalize(mix(n0, n1, blend));
+}
+
+// Terrain patches (Renderer/TerrainSystem.hpp). Every instance displaces the same grid patch over
+// -0.5..0.5 on XZ; normalMatrix[3] of the instance holds the patch corner (xy) and side (z) in
+// height field samples ("grid units") and the clipmap level it reads (w).
+struct TerrainParams {
+    float4x4 terrainToWorld;
+    float4 fieldOrigin;      // xyz height field origin, w spacing X
+    float4 fieldInfo;        // x spacing Z, y sample count, z clipmap size, w level count
+    float4 cameraGrid;       // xyz camera in grid units, w quads per patch side
+    float4 lodRanges;        // x range of level 0 in grid units, y morph start in parts of a range, z grid units per height unit
+    float4 windowOrigins[6]; // clipmap window corners in texels of their level: xy level 2i, zw level 2i + 1
+};
+
+struct TerrainVertex {
+    float3 worldPosition;
+    float3 worldNormal;
+    float3 worldTangent;
+    float2 uv; // across the whole terrain, like the texCoord of the sculpted plane
+};
+
+// A texel of a clipmap level, kept inside the level's window and addressed toroidally.
+static inline float terrainTexel(texture2d_array<float, access::read> heights, constant TerrainParams& params,
+                                 uint level, int2 texel) {
+    float4 origins = params.windowOrigins[level >> 1];
+    int2 origin = int2((level & 1) != 0 ? origins.zw : origins.xy);
+    int size = int(params.fieldInfo.z);
+    texel = clamp(texel, origin, origin + size - 1);
+    uint2 wrapped = uint2(((texel % size) + size) % size);
+    return heights.read(wrapped, level).r;
+}
+
+// Bilinear height of a clipmap level at a point in grid units.
+static inline float terrainLevelHeight(texture2d_array<float, access::read> heights, constant TerrainParams& params,
+                                       uint level, float2 grid) {
+    float2 t = grid / float(1u << level);
+    float2 base = floor(t);
+    float2 f = t - base;
+    int2 i0 = int2(base);
+    float h00 = terrainTexel(heights, params, level, i0);
+    float h10 = terrainTexel(heights, params, level, i0 + int2(1, 0));
+    float h01 = terrainTexel(heights, params, level, i0 + int2(0, 1));
+    float h11 = terrainTexel(heights, params, level, i0 + int2(1, 1));
+    return mix(mix(h00, h10, f.x), mix(h01, h11, f.x), f.y);
+}
+
+// Height of a patch of the given level, blended towards the next coarser level as it morphs.
+static inline float terrainHeight(texture2d_array<float, access::read> heights, constant TerrainParams& params,
+                                  uint lod, uint coarser, float morph, float2 grid) {
+    float last = params.fieldInfo.y - 1.0;
+    grid = clamp(grid, float2(0.0), float2(last));
+    float fine = terrainLevelHeight(heights, params, lod, grid);
+    return morph > 0.0 ? mix(fine, terrainLevelHeight(heights, params, coarser, grid), morph) : fine;
+}
+
+// Places a vertex of the patch grid on the terrain. The morph factor comes from the distance of
+// the unmorphed vertex, so vertices shared by two patches move alike; towards the end of the
+// patch's range its odd vertices slide onto the coarser grid, which the neighbouring coarser patch
+// meets exactly. Patches that keep their parent's level on a quarter of it snap onto that level's
+// grid first.
+static inline TerrainVertex terrainVertex(float3 patchPosition, InstanceData inst,
+                                          texture2d_array<float, access::read> heights,
+                                          constant TerrainParams& params, bool withFrame) {
+    float4 node = inst.normalMatrix[3];
+    uint lod = uint(node.w);
+    uint levels = uint(params.fieldInfo.w);
+    uint coarser = min(lod + 1, levels - 1);
+    float last = params.fieldInfo.y - 1.0;
+    float heightScale = params.lodRanges.z;
+
+    float fine = float(1u << lod);
+    float2 grid = node.xy + (patchPosition.xz + 0.5) * node.z;
+    grid = floor(grid / fine + 0.001) * fine;
+
+    float h = terrainLevelHeight(heights, params, lod, clamp(grid, float2(0.0), float2(last)));
+    float dist = distance(float3(grid.x, h * heightScale, grid.y), params.cameraGrid.xyz);
+    float range = params.lodRanges.x * fine;
+    float morphStart = range * params.lodRanges.y;
+    float morph = lod < coarser ? saturate((dist - morphStart) / max(range - morphStart, 1e-4)) : 0.0;
+    float cell = fine * 2.0;
+    grid -= (grid - floor(grid / cell + 0.001) * cell) * morph;
+    grid = clamp(grid, float2(0.0), float2(last));
+
+    float2 spacing = float2(params.fieldOrigin.w, params.fieldInfo.x);
+    float height = terrainHeight(heights, params, lod, coarser, morph, grid);
+    float3 local = float3(params.fieldOrigin.x + grid.x * spacing.x, height, params.fieldOrigin.z + grid.y * spacing.y);
+
+    TerrainVertex out;
+    out.worldPosition = (params.terrainToWorld * float4(local, 1.0)).xyz;
+    out.uv = grid / max(last, 1.0);
+    out.worldNormal = float3(0.0, 1.0, 0.0);
+    out.worldTangent = float3(1.0, 0.0, 0.0);
+    if (withFrame) {
+        // Central differences over one texel of the patch's level, on the same blended surface.
+        float hl = terrainHeight(heights, params, lod, coarser, morph, grid - float2(fine, 0.0));
+        float hr = terrainHeight(heights, params, lod, coarser, morph, grid + float2(fine, 0.0));
+        float hd = terrainHeight(heights, params, lod, coarser, morph, grid - float2(0.0, fine));
+        float hu = terrainHeight(heights, params, lod, coarser, morph, grid + float2(0.0, fine));
+        float2 slope = float2(hr - hl, hu - hd) / (2.0 * fine * spacing);
+        float3 localNormal = normalize(float3(-slope.x, 1.0, -slope.y));
+        float3 localTangent = float3(1.0, slope.x, 0.0);
+
+        float3 axisX = params.terrainToWorld[0].xyz;
+        float3 axisY = params.terrainToWorld[1].xyz;
+        float3 axisZ = params.terrainToWorld[2].xyz;
+        float3x3 normalTransform = float3x3(cross(axisY, axisZ), cross(axisZ, axisX), cross(axisX, axisY));
+        out.worldNormal = normalize(normalTransform * localNormal);
+        float3 tangent = float3x3(axisX, axisY, axisZ) * localTangent;
+        tangent -= out.worldNormal * dot(out.worldNormal, tangent);
+        out.worldTangent = length_squared(tangent) > 1e-8 ? normalize(tangent) : float3(1.0, 0.0, 0.0);
+    }
+    return out;
+}
+
+inline float3 normalizedTerrainWeights(float3 weights, float sharpness) {
+    weights = max(weights, float3(0.0));
+    weights = pow(weights, float3(max(sharpness, 0.1)));
+    float sum = weights.x + weights.y + weights.z;
+    if (sum <= 0.0001) {
+        return float3(1.0, 0.0, 0.0);
+    }
+    return weights / sum;
+}
+
+// Runtime virtual texture of blended terrain layers (Renderer/TerrainVirtualTexture.hpp). A page
+// is kTerrainVTPageSize texels square plus a kTerrainVTPageBorder texel border on every side, so
+// bilinear taps near its edge stay inside it in the atlas.
+constant uint kTerrainVTPageSize = 128;
+constant uint kTerrainVTPageBorder = 4;
+constant uint kTerrainVTMaxMips = 8;
+
+struct TerrainVirtualTextureParams {
+    uint pagesPerSide;            // pages across mip 0
+    uint mipCount;
+    uint atlasPagesPerSide;
+    uint feedbackPhase;           // which pixel of each 4x4 block reports its page this frame
+    uint feedbackBitsPerTexture;
+    uint pad0;
+    uint pad1;
+    uint pad2;
+    uint mipOffsets[kTerrainVTMaxMips]; // first page of each mip in a texture's feedback bits
+};
+
 struct InstanceCullParams {
     float4 frustumPlanes[6];
     float4 boundsCenterRadius; // xyz center, w radius
     uint inputOffset;
     uint outputOffset;
     uint instanceCount;
-    uint _pad;
+    float lodMaxDistance;      // instances whose bounds centre is farther from lodCamera are culled; 0 keeps all
     float2 screenSize;
     uint hzbMipCount;
     uint _pad2;
+    float4 lodCamera;          // xyz camera position, w distance below which instances are culled
 };
 
 struct DrawIndexedIndirectArgs {
@@ -57,6 +316,110 @@ struct DrawIndexedIndirectArgs {
     uint baseInstance;
 };
 
+// GPU-driven static geometry: one entry per (mesh, material) batch. Pointers are GPU addresses
+// the encode kernel hands straight to the indirect command buffer.
+struct StaticBatchData {
+    float4 boundsCenterRadius; // xyz center, w radius (mesh space)
+    uint inputOffset;
+    uint instanceCount;
+    uint outputOffset;
+    uint indexCount;
+    const device uchar* vertices;   // float3 positions
+    const device uchar* attributes; // PackedVertexAttributes
+    const device uint* indices;
+    const device uchar* material;
+    const device uchar* mesh;
+    uint meshletCount;              // non-zero: drawn by the meshlet pipeline, not the ICB
+    uint lodCount;                  // level 0 only: this batch and the next lodCount - 1 hold the LODs
+    float4 lodErrors;               // mesh-space error of levels 1-4
+};
+
+// Meshlet in Mesh.hpp: a cluster of at most 64 vertices / 124 triangles with its mesh-space
+// bounding sphere and backface cone.
+struct MeshletData {
+    uint vertexOffset;
+    uint triangleOffset;
+    uint vertexCount;
+    uint triangleCount;
+    float4 centerRadius;
+    float4 coneAxisCutoff;
+    packed_float3 coneApex;
+    uint submesh;
+};
+
+struct MeshletCullParams {
+    float4 frustumPlanes[6];
+    float2 screenSize;
+    uint meshletCount;
+    uint hzbMipCount;
+    uint useHzb;
+    uint coneCulling;
+    uint _pad0;
+    uint _pad1;
+};
+
+// Buffers shared by every static draw in a frame, in vertex/fragment slot order.
+struct StaticFrameBindings {
+    const device InstanceData* culledInstances;
+    const device uchar* camera;
+    const device uchar* light;
+    const device uchar* environment;
+    const device uchar* lights;
+    const device uchar* shadows;
+    const device uchar* lightCount;
+    const device uchar* clusterHeaders;
+    const device uchar* clusterIndices;
+    const device uchar* clusterParams;
+    const device uchar* probeVolume;
+    const device uchar* probeData;
+};
+
+struct StaticCullParams {
+    float4 frustumPlanes[6];
+    float2 screenSize;
+    uint instanceCount;
+    uint hzbMipCount;
+    uint batchCount;
+    uint encodePrepass;
+    float lodPixelError;
+    uint _pad;
+    float4 lodView; // xyz camera position, w pixels per world unit at distance 1
+};
+
+// Visibility-buffer shading of the static scene (see visibility_classify in PBR.metal). Each
+// VISIBILITY_TILE_SIZE square tile holds the lowest batch and the complement of the highest batch its
+// pixels resolved to; a group's quads cover only tiles whose range overlaps
+// [firstBatch, firstBatch + batchRange).
+struct VisibilityShadeParams {
+    float2 screenSize;
+    uint tilesX;
+    uint batchCount;
+    uint firstBatch;
+    uint batchRange;
+    uint _pad0;
+    uint _pad1;
+};
+
+// Two-phase occlusion culling of the CPU-submitted draws. Candidates are world spheres (w <= 0
+// for ones outside the frustum); each deferred draw owns one DrawIndexedIndirectArgs slot whose
+// instanceCount is written from its candidate's visibility.
+struct SkinningParams {
+    uint vertexCount;
+    uint _pad0;
+    uint _pad1;
+    uint _pad2;
+};
+
+struct OcclusionCullParams {
+    float2 screenSize;
+    uint candidateCount;
+    uint hzbMipCount;
+    uint argOffset;
+    uint argCount;
+    uint _pad0;
+    uint _pad1;
+};
+
 struct CameraUniforms {
     float4x4 viewMatrix;
     float4x4 projectionMatrix;
@@ -83,7 +446,7 @@ struct MaterialUniforms {
     float4 foliageParams3; // windDir.xyz, padding
     float4 impostorParams0; // enabled, rows, cols, padding
     float4 terrainParams0; // enabled, blendSharpness, heightStart, heightEnd
-    float4 terrainParams1; // slopeStart, slopeEnd, unused, unused
+    float4 terrainParams1; // slopeStart, slopeEnd, virtual texture (one based, 0 samples the layers), unused
     float4 terrainLayer0ST; // tiling.xy, unused
     float4 terrainLayer1ST; // tiling.xy, unused
     float4 terrainLayer2ST; // tiling.xy, unused
@@ -100,28 +463,22 @@ struct MeshUniforms {
 struct ProbeVolumeUniforms {
     float4 boundsMin;
     float4 boundsMax;
-    float4 gridCounts; // xyz counts, w enabled
+    float4 gridCounts; // xyz brick cell counts, w enabled
     float4 featureParams; // x diffuse probes, y local reflections, z reflection intensity, w box projection
     float4 blendParams; // x blend sharpness, y max blend count, z occlusion enabled, w specular occlusion strength
     float4 reflectionParams; // x roughness filter strength
+    float4 dynamicReflectionParams; // x capture count, y last prefiltered mip, z influence radius
+    float4 dynamicReflections[8];   // xyz capture point, w 1 once the capture was prefiltered
 };
 
+// ProbeVolumeData.hpp's PackedProbeRecord: cube faces +x, -x, +y, -y, +z, -z as RGB9E5, and the
+// visibility distances per face as halves (the seventh is the trace distance).
 struct ProbeAmbientCubeData {
-    float4 px;
-    float4 nx;
-    float4 py;
-    float4 ny;
-    float4 pz;
-    float4 nz;
-    float4 specularPx;
-    float4 specularNx;
-    float4 specularPy;
-    float4 specularNy;
-    float4 specularPz;
-    float4 specularNz;
+    uint ambientCube[6];
+    uint specularCube[6];
     float4 positionAndValidity;
-    float4 visibility0;
-    float4 visibility1;
+    half4 visibility0;
+    half4 visibility1;
 };
 
 struct LightData {
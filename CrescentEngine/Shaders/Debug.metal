@@ -24,22 +24,134 @@ struct DebugUniforms {
     float4 cameraPosition; // w unused
     float4 gridParams;     // (gridSize, gridFadeStart, gridFadeEnd, gridCellSize)
     float2 gridOrigin;     // snapped origin in XZ
-    float2 padding;        // keep 128-byte size (matches C++)
+    float2 padding;
+    float4 lineParams;     // (viewportWidth, viewportHeight, lineWidth, unused)
 };
 
+// Line segment record (matches DebugLineGPU)
+struct DebugLine {
+    float4 start;
+    float4 end;
+    float4 color;
+};
+
+// Box, sphere or frustum instance (matches DebugShapeGPU)
+struct DebugShape {
+    float4x4 transform;
+    float4 color;
+    float4 params; // x = ring segments for spheres
+};
+
+// Shape kind of an instanced draw (DebugRenderer::ShapeKind)
+constant uint kDebugShapeBox = 0;
+constant uint kDebugShapeSphere = 1;
+
+constant uint2 kDebugBoxEdges[12] = {
+    uint2(0, 1), uint2(1, 3), uint2(3, 2), uint2(2, 0), // z = -1
+    uint2(4, 5), uint2(5, 7), uint2(7, 6), uint2(6, 4), // z = +1
+    uint2(0, 4), uint2(1, 5), uint2(2, 6), uint2(3, 7)
+};
+
+// Expands a clip-space segment into a screen-space quad of lineParams.z pixels. Corner 0-5 walks
+// two triangles; endpoints behind the near plane are clipped to it first.
+static DebugVertexOut debugExpandSegment(float4 a, float4 b, float4 color, uint corner,
+                                         constant DebugUniforms& uniforms) {
+    DebugVertexOut out;
+    out.color = color;
+    out.worldPosition = float3(0.0);
+    if (a.z < 0.0 && b.z < 0.0) {
+        out.position = float4(0.0, 0.0, 2.0, 1.0); // outside the depth range, culled
+        return out;
+    }
+    if (a.z < 0.0) {
+        a = mix(a, b, a.z / (a.z - b.z));
+    } else if (b.z < 0.0) {
+        b = mix(b, a, b.z / (b.z - a.z));
+    }
+    float2 viewport = uniforms.lineParams.xy;
+    float2 screenA = a.xy / max(a.w, 1e-6) * 0.5 * viewport;
+    float2 screenB = b.xy / max(b.w, 1e-6) * 0.5 * viewport;
+    float2 dir = screenB - screenA;
+    float len = length(dir);
+    dir = len > 1e-4 ? dir / len : float2(1.0, 0.0);
+    float2 normal = float2(-dir.y, dir.x) * (uniforms.lineParams.z * 0.5);
+
+    const uint kCorners[6] = { 0, 1, 2, 2, 1, 3 };
+    uint c = kCorners[corner];
+    float4 p = (c & 1) ? b : a;
+    float side = (c & 2) ? 1.0 : -1.0;
+    // Pixels to NDC, scaled by w so depth still interpolates perspective-correctly
+    p.xy += normal * side * 2.0 / viewport * p.w;
+    out.position = p;
+    return out;
+}
+
 // ============================================================================
 // DEBUG LINE SHADER
 // ============================================================================
 
+// One instance per segment, six vertices each
 vertex DebugVertexOut debugLineVertexShader(
-    DebugVertexIn in [[stage_in]],
+    uint vertexId [[vertex_id]],
+    uint instanceId [[instance_id]],
+    const device DebugLine* lines [[buffer(0)]],
     constant DebugUniforms& uniforms [[buffer(1)]]
 ) {
-    DebugVertexOut out;
-    out.position = uniforms.viewProjectionMatrix * float4(in.position, 1.0);
-    out.color = in.color;
-    out.worldPosition = in.position;
-    return out;
+    DebugLine line = lines[instanceId];
+    float4 a = uniforms.viewProjectionMatrix * float4(line.start.xyz, 1.0);
+    float4 b = uniforms.viewProjectionMatrix * float4(line.end.xyz, 1.0);
+    return debugExpandSegment(a, b, line.color, vertexId, uniforms);
+}
+
+// One instance per shape, six vertices per template edge
+vertex DebugVertexOut debugShapeVertexShader(
+    uint vertexId [[vertex_id]],
+    uint instanceId [[instance_id]],
+    const device DebugShape* shapes [[buffer(0)]],
+    constant DebugUniforms& uniforms [[buffer(1)]],
+    constant uint& kind [[buffer(2)]]
+) {
+    DebugShape shape = shapes[instanceId];
+    uint edge = vertexId / 6;
+    float3 p0;
+    float3 p1;
+    if (kind == kDebugShapeBox) {
+        uint2 e = kDebugBoxEdges[min(edge, 11u)];
+        p0 = float3((e.x & 1) ? 1.0 : -1.0, (e.x & 2) ? 1.0 : -1.0, (e.x & 4) ? 1.0 : -1.0);
+        p1 = float3((e.y & 1) ? 1.0 : -1.0, (e.y & 2) ? 1.0 : -1.0, (e.y & 4) ? 1.0 : -1.0);
+    } else {
+        uint segments = max(uint(shape.params.x), 3u);
+        if (edge >= segments * 3) {
+            DebugVertexOut out;
+            out.position = float4(0.0, 0.0, 2.0, 1.0);
+            out.color = float4(0.0);
+            out.worldPosition = float3(0.0);
+            return out;
+        }
+        uint ring = edge / segments;
+        float step = 2.0 * M_PI_F / float(segments);
+        float a0 = float(edge % segments) * step;
+        float a1 = a0 + step;
+        float2 c0 = float2(cos(a0), sin(a0));
+        float2 c1 = float2(cos(a1), sin(a1));
+        if (ring == 0) {
+            p0 = float3(c0.x, c0.y, 0.0);
+            p1 = float3(c1.x, c1.y, 0.0);
+        } else if (ring == 1) {
+            p0 = float3(c0.x, 0.0, c0.y);
+            p1 = float3(c1.x, 0.0, c1.y);
+        } else {
+            p0 = float3(0.0, c0.x, c0.y);
+            p1 = float3(0.0, c1.x, c1.y);
+        }
+    }
+    // Homogeneous through the shape transform, so frusta (inverse projections) need no divide;
+    // only w's sign is normalised for the near-plane clip
+    float4 w0 = shape.transform * float4(p0, 1.0);
+    float4 w1 = shape.transform * float4(p1, 1.0);
+    float4 a = uniforms.viewProjectionMatrix * (w0.w < 0.0 ? -w0 : w0);
+    float4 b = uniforms.viewProjectionMatrix * (w1.w < 0.0 ? -w1 : w1);
+    return debugExpandSegment(a, b, shape.color, vertexId % 6, uniforms);
 }
 
 fragment float4 debugLineFragmentShader(
@@ -48,6 +160,50 @@ fragment float4 debugLineFragmentShader(
     return in.color;
 }
 
+// ============================================================================
+// MESH WIREFRAME SHADER
+// ============================================================================
+
+// Per-draw data (matches DebugMeshWireGPU)
+struct DebugMeshWire {
+    float4x4 transform;
+    float4 color;
+};
+
+struct DebugMeshWireOut {
+    float4 position [[position]];
+    float4 color [[flat]];
+};
+
+// Indexed draw of the mesh's own triangles from the geometry arena's position stream
+vertex DebugMeshWireOut debugMeshWireVertexShader(
+    uint vertexId [[vertex_id]],
+    const device packed_float3* positions [[buffer(0)]],
+    constant DebugUniforms& uniforms [[buffer(1)]],
+    constant DebugMeshWire& wire [[buffer(2)]]
+) {
+    DebugMeshWireOut out;
+    out.position = uniforms.viewProjectionMatrix * (wire.transform * float4(float3(positions[vertexId]), 1.0));
+    out.color = wire.color;
+    return out;
+}
+
+// Keeps the pixels within half a line width of a triangle edge, measured in pixels through the
+// barycentrics' screen derivatives; neighbouring triangles draw the other half
+fragment float4 debugMeshWireFragmentShader(
+    DebugMeshWireOut in [[stage_in]],
+    float3 barycentric [[barycentric_coord]],
+    constant DebugUniforms& uniforms [[buffer(1)]]
+) {
+    float3 pixels = barycentric / max(fwidth(barycentric), float3(1e-6));
+    float distance = min(min(pixels.x, pixels.y), pixels.z);
+    float coverage = 1.0 - smoothstep(uniforms.lineParams.z * 0.5 - 0.5, uniforms.lineParams.z * 0.5 + 0.5, distance);
+    if (coverage <= 0.01) {
+        discard_fragment();
+    }
+    return float4(in.color.rgb, in.color.a * coverage);
+}
+
 // ============================================================================
 // INFINITE GRID SHADER
 // ============================================================================
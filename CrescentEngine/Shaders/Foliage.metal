@@ -0,0 +1,119 @@
+#include "Common.metal.h"
+
+// GPU foliage scattering (Renderer/FoliageSystem.hpp). One thread per cell of a tile writes the
+// cell's record in the tile's slot: an instance placed on the terrain, or zero matrices when the
+// candidate is rejected, which the instance cull kernels skip.
+struct FoliageScatterParams {
+    float4x4 terrainToWorld;
+    float4 tileOrigin;  // xy tile corner on the terrain XZ, z cell size, w keep probability
+    float4 fieldOrigin; // xyz height field origin, w spacing X
+    float4 fieldInfo;   // x spacing Z, y sample count
+    float4 placement;   // x min scale, y max scale, z cos of the max slope, w normal alignment
+    uint tileHash;
+    uint cellsPerSide;
+    uint outputOffset;
+    uint hasDensityMap;
+};
+
+static inline uint foliageHash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static inline float foliageRandom(thread uint& state) {
+    state = foliageHash(state);
+    return float(state >> 8) * (1.0 / 16777216.0);
+}
+
+// Bilinear height at a fractional sample coordinate, clamped to the field.
+static inline float foliageHeight(texture2d<float, access::read> heights, float2 grid, uint sampleCount) {
+    float last = float(sampleCount - 1);
+    float2 c = clamp(grid, float2(0.0), float2(last));
+    uint2 i0 = uint2(floor(c));
+    uint2 i1 = min(i0 + 1, uint2(sampleCount - 1));
+    float2 f = c - float2(i0);
+    float h00 = heights.read(i0).r;
+    float h10 = heights.read(uint2(i1.x, i0.y)).r;
+    float h01 = heights.read(uint2(i0.x, i1.y)).r;
+    float h11 = heights.read(i1).r;
+    return mix(mix(h00, h10, f.x), mix(h01, h11, f.x), f.y);
+}
+
+kernel void foliage_scatter(texture2d<float, access::read> heights [[texture(0)]],
+                            texture2d<float> densityMap [[texture(1)]],
+                            device InstanceData* outInstances [[buffer(0)]],
+                            constant FoliageScatterParams& params [[buffer(1)]],
+                            uint2 cell [[thread_position_in_grid]]) {
+    uint cells = params.cellsPerSide;
+    if (cell.x >= cells || cell.y >= cells) {
+        return;
+    }
+    uint index = params.outputOffset + cell.y * cells + cell.x;
+    InstanceData inst;
+    inst.modelMatrix = float4x4(0.0);
+    inst.normalMatrix = float4x4(0.0);
+
+    uint state = foliageHash(params.tileHash ^ foliageHash(cell.y * cells + cell.x));
+    float2 jitter = float2(foliageRandom(state), foliageRandom(state));
+    float keep = foliageRandom(state);
+    float yaw = foliageRandom(state) * 6.28318530718;
+    float scale = mix(params.placement.x, params.placement.y, foliageRandom(state));
+
+    float2 local = params.tileOrigin.xy + (float2(cell) + jitter) * params.tileOrigin.z;
+    float2 spacing = float2(params.fieldOrigin.w, params.fieldInfo.x);
+    uint sampleCount = uint(params.fieldInfo.y);
+    float last = float(sampleCount - 1);
+    float2 grid = (local - params.fieldOrigin.xz) / spacing;
+    float density = params.tileOrigin.w;
+    if (params.hasDensityMap != 0) {
+        constexpr sampler densitySampler(filter::linear, address::clamp_to_edge);
+        density *= densityMap.sample(densitySampler, grid / last).r;
+    }
+    if (any(grid < float2(0.0)) || any(grid > float2(last)) || keep >= density) {
+        outInstances[index] = inst;
+        return;
+    }
+
+    float height = foliageHeight(heights, grid, sampleCount);
+    float dhdx = (foliageHeight(heights, grid + float2(1.0, 0.0), sampleCount)
+                - foliageHeight(heights, grid - float2(1.0, 0.0), sampleCount)) / (2.0 * spacing.x);
+    float dhdz = (foliageHeight(heights, grid + float2(0.0, 1.0), sampleCount)
+                - foliageHeight(heights, grid - float2(0.0, 1.0), sampleCount)) / (2.0 * spacing.y);
+    float3 normal = normalize(float3(-dhdx, 1.0, -dhdz));
+    if (normal.y < params.placement.z) {
+        outInstances[index] = inst;
+        return;
+    }
+
+    float3 up = normalize(mix(float3(0.0, 1.0, 0.0), normal, params.placement.w));
+    float3 reference = abs(up.z) < 0.99 ? float3(0.0, 0.0, 1.0) : float3(1.0, 0.0, 0.0);
+    float3 right = normalize(cross(reference, up));
+    float3 forward = cross(right, up);
+    float s = sin(yaw);
+    float c = cos(yaw);
+    float3 axisX = right * c - forward * s;
+    float3 axisZ = right * s + forward * c;
+
+    float4x4 placement = float4x4(float4(axisX * scale, 0.0),
+                                  float4(up * scale, 0.0),
+                                  float4(axisZ * scale, 0.0),
+                                  float4(local.x, height, local.y, 1.0));
+    float4x4 model = params.terrainToWorld * placement;
+
+    // Inverse transpose of the upper 3x3 through its cofactors.
+    float3 a = model[0].xyz;
+    float3 b = model[1].xyz;
+    float3 d = model[2].xyz;
+    float det = dot(a, cross(b, d));
+    float invDet = abs(det) > 1e-12 ? 1.0 / det : 0.0;
+    inst.modelMatrix = model;
+    inst.normalMatrix = float4x4(float4(cross(b, d) * invDet, 0.0),
+                                 float4(cross(d, a) * invDet, 0.0),
+                                 float4(cross(a, b) * invDet, 0.0),
+                                 float4(0.0, 0.0, 0.0, 1.0));
+    outInstances[index] = inst;
+}
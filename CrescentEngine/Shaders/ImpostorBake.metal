@@ -2,10 +2,8 @@
 
 struct BakeVertexIn {
     float3 position [[attribute(0)]];
-    float3 normal [[attribute(1)]];
+    float2 normalOct [[attribute(1)]];
     float2 texCoord [[attribute(2)]];
-    float3 tangent [[attribute(3)]];
-    float3 bitangent [[attribute(4)]];
     float4 color [[attribute(5)]];
 };
 
@@ -30,7 +28,7 @@ vertex BakeVertexOut impostor_bake_vertex(
     BakeVertexOut out;
     out.position = params.viewProjection * float4(in.position, 1.0);
     out.uv = in.texCoord * params.uvTilingOffset.xy + params.uvTilingOffset.zw;
-    out.normal = normalize(in.normal);
+    out.normal = decodeOctNormal(in.normalOct);
     out.color = in.color;
     return out;
 }
@@ -0,0 +1,960 @@
+#include <metal_stdlib>
+#include <metal_raytracing>
+#include "Common.metal.h"
+using namespace metal;
+using namespace metal::raytracing;
+
+// =============================================================================
+// GPU LIGHTMAP / PROBE BAKE
+// =============================================================================
+// Port of the CPU baker's lighting in SceneCommands.cpp: same lights, emitter samplers, bounce
+// path, hashes and seeds, so the two backends converge on the same result. The CPU prepares one
+// query per lightmap texel sample or probe face and accumulates the results; structs mirror
+// GPULightBaker.hpp.
+
+struct LightBakeQuery {
+    float4 position;       // w: primary emission luminance (texels)
+    float4 geometryNormal; // w: primary AO (texels)
+    float4 shadingNormal;
+    uint4 control;         // x mode, y receive GI, z probe sample count
+    uint4 seeds;           // x emissive, y indirect
+};
+
+struct LightBakeResult {
+    float4 direct;      // texels: direct irradiance; probes: the evaluated lighting
+    float4 indirect;    // w: 1 when dominant holds a direction
+    float4 dominant;    // xyz dominant direction, w reference NdotL
+    float4 shadowmask;  // visibility per shadowmask channel, negative when not traced
+};
+
+struct LightBakeParams {
+    float4 ambient;     // ambient colour * intensity
+    float4 tint;
+    float4 intensities; // x sky, y IBL
+    uint lightCount;
+    uint emitterCount;
+    int indirectBounces;
+    int samplesPerTexel;
+    float totalEmitterWeight;
+    uint queryOffset;
+    uint queryCount;
+    uint hasCutout;
+    uint lightNodeCount; // zero: emitters are picked through the alias table
+    uint pad0;
+    uint pad1;
+    uint pad2;
+};
+
+struct LightBakeLight {
+    float4 positionRange;
+    float4 directionIntensity;
+    float4 color;
+    float4 shadow;      // x bias, y normal bias, z distance
+    float4 spot;        // x cos inner, y cos outer
+    int4 flags;         // x type, y stationary, z casts shadows, w shadowmask channel
+};
+
+struct LightBakeEmitter {
+    float4 p0;          // w area
+    float4 p1;          // w weight
+    float4 p2;          // w cumulative weight
+    float4 n0;          // w two-sided
+    float4 n1;
+    float4 n2;
+    float4 uv01;
+    float4 uv2;
+    uint material;
+    uint pad0;
+    uint pad1;
+    uint pad2;
+};
+
+struct LightBakeAliasEntry {
+    float probability;
+    uint alias;
+    uint pad0;
+    uint pad1;
+};
+
+struct LightBakeLightNode {
+    float4 boundsMin;   // w weight
+    float4 boundsMax;   // w cone angle, pi for two-sided emitters
+    float4 coneAxis;
+    uint child;         // first child (the second follows it), or the emitter for leaves
+    uint leaf;
+    uint pad0;
+    uint pad1;
+};
+
+struct LightBakeInstance {
+    float4 normalMatrix[3];
+    uint triangleOffset;
+    uint materialOffset;
+    uint materialCount;
+    uint contributeGI;
+};
+
+struct LightBakeTriangle {
+    float4 normal;      // object-space face normal
+    float2 uv0;
+    float2 uv1;
+    float2 uv2;
+    uint material;
+    uint pad;
+};
+
+struct LightBakeMaterial {
+    float4 albedo;      // rgb clamped albedo, a alpha
+    float4 emission;    // rgb clamped emission * strength, w AO
+    float4 uvTransform; // xy tiling, zw offset
+    int4 textures;      // albedo, emission, AO, opacity; negative when absent
+    float4 alpha;       // x cutoff, zero when opaque
+};
+
+struct LightBakeTexture {
+    uint offset;
+    uint width;
+    uint height;
+    uint pad;
+};
+
+struct LightBakeSceneData {
+    constant LightBakeParams* params;
+    device const LightBakeLight* lights;
+    device const LightBakeEmitter* emitters;
+    device const LightBakeAliasEntry* aliasTable;
+    device const LightBakeLightNode* lightTree;
+    device const LightBakeInstance* instances;
+    device const LightBakeTriangle* triangles;
+    device const LightBakeMaterial* materials;
+    device const LightBakeTexture* textures;
+    device const uchar4* texels;
+};
+
+constant uint kBakeModeTexel = 0;
+constant uint kBakeModeProbeIrradiance = 1;
+constant uint kBakeModeProbeSpecular = 2;
+
+constant int kLightDirectional = 0;
+constant int kLightSpot = 2;
+
+// Shadow rays only see instances that cast shadows; bounce rays see everything.
+constant uint kBakeMaskShadow = 1u;
+constant uint kBakeMaskAll = 2u;
+constant int kMaxCutoutLayers = 16;
+constant float kBakeEpsilon = 1e-6f;
+
+static float3 bake_normalize(float3 v) {
+    float lengthSq = dot(v, v);
+    return lengthSq > 0.0f ? v * rsqrt(lengthSq) : float3(0.0f);
+}
+
+static float3 bake_clamp_color(float3 value, float maxValue) {
+    return clamp(value, 0.0f, maxValue);
+}
+
+static float bake_luminance(float3 color) {
+    return color.x * 0.2126f + color.y * 0.7152f + color.z * 0.0722f;
+}
+
+static uint bake_hash(uint value) {
+    value ^= value >> 16u;
+    value *= 0x7feb352du;
+    value ^= value >> 15u;
+    value *= 0x846ca68bu;
+    value ^= value >> 16u;
+    return value;
+}
+
+static float bake_hash_to_unit(uint value) {
+    return float(bake_hash(value) & 0x00ffffffu) / float(0x01000000u);
+}
+
+static float2 bake_random2(uint seedA, uint seedB) {
+    return float2(bake_hash_to_unit(seedA), bake_hash_to_unit(seedB));
+}
+
+// -----------------------------------------------------------------------------
+// Materials
+// -----------------------------------------------------------------------------
+
+static float4 bake_read_texel(thread const LightBakeSceneData& data, LightBakeTexture texture, int x, int y) {
+    return float4(data.texels[texture.offset + uint(y) * texture.width + uint(x)]) / 255.0f;
+}
+
+// Bilinear, converting each tap like SampleCPUImageRGB.
+static float3 bake_sample_rgb(thread const LightBakeSceneData& data, int textureIndex, float2 uv, bool srgb) {
+    if (textureIndex < 0) {
+        return float3(1.0f);
+    }
+    LightBakeTexture texture = data.textures[textureIndex];
+    int width = int(texture.width);
+    int height = int(texture.height);
+    float u = uv.x - floor(uv.x);
+    float v = uv.y - floor(uv.y);
+    float x = u * float(width - 1);
+    float y = (1.0f - v) * float(height - 1);
+    int x0 = clamp(int(floor(x)), 0, width - 1);
+    int y0 = clamp(int(floor(y)), 0, height - 1);
+    int x1 = clamp(x0 + 1, 0, width - 1);
+    int y1 = clamp(y0 + 1, 0, height - 1);
+    float tx = x - float(x0);
+    float ty = y - float(y0);
+
+    float3 c00 = bake_read_texel(data, texture, x0, y0).rgb;
+    float3 c10 = bake_read_texel(data, texture, x1, y0).rgb;
+    float3 c01 = bake_read_texel(data, texture, x0, y1).rgb;
+    float3 c11 = bake_read_texel(data, texture, x1, y1).rgb;
+    if (srgb) {
+        c00 = pow(saturate(c00), 2.2f);
+        c10 = pow(saturate(c10), 2.2f);
+        c01 = pow(saturate(c01), 2.2f);
+        c11 = pow(saturate(c11), 2.2f);
+    }
+    float3 c0 = c00 * (1.0f - tx) + c10 * tx;
+    float3 c1 = c01 * (1.0f - tx) + c11 * tx;
+    return c0 * (1.0f - ty) + c1 * ty;
+}
+
+// Nearest texel, as the CPU BVH's alpha test reads it.
+static float bake_sample_alpha(thread const LightBakeSceneData& data, int textureIndex, float2 uv, int channel) {
+    if (textureIndex < 0) {
+        return 1.0f;
+    }
+    LightBakeTexture texture = data.textures[textureIndex];
+    float u = uv.x - floor(uv.x);
+    float v = uv.y - floor(uv.y);
+    int x = min(int(texture.width) - 1, int(u * float(texture.width)));
+    int y = min(int(texture.height) - 1, int((1.0f - v) * float(texture.height)));
+    return bake_read_texel(data, texture, x, y)[channel];
+}
+
+static float2 bake_material_uv(LightBakeMaterial material, float2 uv) {
+    return uv * material.uvTransform.xy + material.uvTransform.zw;
+}
+
+struct BakeMaterialSample {
+    float3 albedo;
+    float3 emission;
+    float ao;
+};
+
+static BakeMaterialSample bake_resolve_material(thread const LightBakeSceneData& data, int materialIndex, float2 uv) {
+    BakeMaterialSample result;
+    result.albedo = float3(0.7f);
+    result.emission = float3(0.0f);
+    result.ao = 1.0f;
+    if (materialIndex < 0) {
+        return result;
+    }
+    LightBakeMaterial material = data.materials[materialIndex];
+    float2 tiledUV = bake_material_uv(material, uv);
+    result.albedo = material.albedo.rgb;
+    if (material.textures.x >= 0) {
+        result.albedo *= bake_clamp_color(bake_sample_rgb(data, material.textures.x, tiledUV, true), 1.0f);
+    }
+    result.emission = material.emission.rgb;
+    if (material.textures.y >= 0) {
+        result.emission *= bake_clamp_color(bake_sample_rgb(data, material.textures.y, tiledUV, true), 8.0f);
+    }
+    result.ao = material.emission.w;
+    if (material.textures.z >= 0) {
+        result.ao *= clamp(bake_sample_rgb(data, material.textures.z, tiledUV, false).x, 0.05f, 1.0f);
+    }
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Ray queries
+// -----------------------------------------------------------------------------
+
+struct BakeHit {
+    bool hit;
+    float distance;
+    uint instance;
+    uint primitive;
+    float2 barycentrics;
+};
+
+static int bake_hit_material(thread const LightBakeSceneData& data, uint instanceIndex, uint primitive) {
+    LightBakeInstance instance = data.instances[instanceIndex];
+    uint slot = data.triangles[instance.triangleOffset + primitive].material;
+    return slot < instance.materialCount ? int(instance.materialOffset + slot) : -1;
+}
+
+static float2 bake_hit_uv(thread const LightBakeSceneData& data, uint instanceIndex, uint primitive, float2 barycentrics) {
+    LightBakeTriangle triangle = data.triangles[data.instances[instanceIndex].triangleOffset + primitive];
+    return triangle.uv0 * (1.0f - barycentrics.x - barycentrics.y) + triangle.uv1 * barycentrics.x +
+           triangle.uv2 * barycentrics.y;
+}
+
+static bool bake_passes_alpha(thread const LightBakeSceneData& data, uint instanceIndex, uint primitive, float2 barycentrics) {
+    int materialIndex = bake_hit_material(data, instanceIndex, primitive);
+    if (materialIndex < 0) {
+        return true;
+    }
+    LightBakeMaterial material = data.materials[materialIndex];
+    if (material.alpha.x <= 0.0f) {
+        return true;
+    }
+    float2 uv = bake_material_uv(material, bake_hit_uv(data, instanceIndex, primitive, barycentrics));
+    float alpha = material.albedo.a * bake_sample_alpha(data, material.textures.x, uv, 3) *
+                  bake_sample_alpha(data, material.textures.w, uv, 0);
+    return alpha >= material.alpha.x;
+}
+
+// Cutout texels are skipped by re-tracing past them. Any-hit would step over a closer opaque
+// surface that way, so scenes with cutouts trace shadow rays to the closest hit.
+static BakeHit bake_trace(thread const LightBakeSceneData& data,
+                          instance_acceleration_structure scene,
+                          float3 origin,
+                          float3 direction,
+                          float maxDistance,
+                          uint mask,
+                          bool anyHit) {
+    BakeHit result;
+    result.hit = false;
+    result.distance = maxDistance;
+    result.instance = 0;
+    result.primitive = 0;
+    result.barycentrics = float2(0.0f);
+    if (!(maxDistance > 0.0f)) {
+        return result;
+    }
+
+    intersector<triangle_data, instancing> tracer;
+    tracer.assume_geometry_type(geometry_type::triangle);
+    tracer.force_opacity(forced_opacity::opaque);
+    tracer.accept_any_intersection(anyHit && data.params->hasCutout == 0u);
+
+    ray query;
+    query.origin = origin;
+    query.direction = direction;
+    query.min_distance = 0.0f;
+    query.max_distance = maxDistance;
+    for (int layer = 0; layer < kMaxCutoutLayers; ++layer) {
+        intersection_result<triangle_data, instancing> hit = tracer.intersect(query, scene, mask);
+        if (hit.type != intersection_type::triangle) {
+            return result;
+        }
+        if (data.params->hasCutout == 0u ||
+            bake_passes_alpha(data, hit.instance_id, hit.primitive_id, hit.triangle_barycentric_coord)) {
+            result.hit = true;
+            result.distance = hit.distance;
+            result.instance = hit.instance_id;
+            result.primitive = hit.primitive_id;
+            result.barycentrics = hit.triangle_barycentric_coord;
+            return result;
+        }
+        query.min_distance = hit.distance + 1e-4f;
+    }
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Lights
+// -----------------------------------------------------------------------------
+
+static float3 bake_light_contribution(LightBakeLight light, float3 positionWS, float3 normalWS) {
+    int type = light.flags.x;
+    float range = light.positionRange.w;
+    float3 L = float3(0.0f);
+    float attenuation = 1.0f;
+    if (type == kLightDirectional) {
+        L = bake_normalize(-light.directionIntensity.xyz);
+    } else {
+        float3 toLight = light.positionRange.xyz - positionWS;
+        float distance = length(toLight);
+        if (distance <= kBakeEpsilon || (range > 0.0f && distance > range)) {
+            return float3(0.0f);
+        }
+        L = toLight / distance;
+        float rangeNorm = range > 0.0f ? clamp(distance / range, 0.0f, 1.0f) : 0.0f;
+        float smoothFalloff = pow(max(0.0f, 1.0f - pow(rangeNorm, 4.0f)), 2.0f);
+        attenuation = smoothFalloff / max(distance * distance, 0.001f);
+        if (type == kLightSpot) {
+            float cosTheta = dot(bake_normalize(light.directionIntensity.xyz), -L);
+            if (cosTheta <= light.spot.y) {
+                return float3(0.0f);
+            }
+            float denom = max(light.spot.x - light.spot.y, 0.0001f);
+            attenuation *= clamp((cosTheta - light.spot.y) / denom, 0.0f, 1.0f);
+        } else if (type != 1) {
+            // Area and emissive-mesh lights.
+            attenuation *= 1.0f / max(distance, 0.1f);
+        }
+    }
+
+    float nDotL = max(dot(normalWS, L), 0.0f);
+    if (nDotL <= 0.0f || attenuation <= 0.0f) {
+        return float3(0.0f);
+    }
+
+    float intensity = light.directionIntensity.w;
+    if (type == 1) {
+        intensity = intensity / (4.0f * PI);
+    } else if (type == kLightSpot) {
+        float solidAngle = 2.0f * PI * (1.0f - light.spot.y);
+        intensity = solidAngle > kBakeEpsilon ? intensity / solidAngle : intensity;
+    }
+    return light.color.rgb * (intensity * attenuation * nDotL);
+}
+
+static bool bake_incident_direction(LightBakeLight light, float3 positionWS, float3 normalWS,
+                                    thread float3& outLightDir, thread float& outReferenceNdotL) {
+    if (light.flags.x == kLightDirectional) {
+        outLightDir = bake_normalize(-light.directionIntensity.xyz);
+    } else {
+        float3 toLight = light.positionRange.xyz - positionWS;
+        float distance = length(toLight);
+        if (distance <= kBakeEpsilon) {
+            return false;
+        }
+        outLightDir = toLight / distance;
+    }
+    if (dot(outLightDir, outLightDir) <= kBakeEpsilon) {
+        return false;
+    }
+    outReferenceNdotL = max(dot(normalWS, outLightDir), 0.0f);
+    return outReferenceNdotL > 0.0f;
+}
+
+static bool bake_light_visible(thread const LightBakeSceneData& data,
+                               instance_acceleration_structure scene,
+                               LightBakeLight light,
+                               float3 positionWS,
+                               float3 normalWS) {
+    if (light.flags.z == 0) {
+        return true;
+    }
+    float normalBias = max(0.0025f, light.shadow.y * 8.0f);
+    float hitTolerance = max(0.01f, light.shadow.x * 32.0f);
+    float3 origin = positionWS + normalWS * normalBias;
+
+    float3 rayDirection;
+    float maxDistance;
+    if (light.flags.x == kLightDirectional) {
+        rayDirection = bake_normalize(-light.directionIntensity.xyz);
+        if (dot(rayDirection, rayDirection) <= kBakeEpsilon) {
+            return true;
+        }
+        maxDistance = max(light.shadow.z, 200.0f);
+    } else {
+        float3 toLight = light.positionRange.xyz - origin;
+        float distance = length(toLight);
+        if (distance <= kBakeEpsilon) {
+            return true;
+        }
+        rayDirection = toLight / distance;
+        maxDistance = max(0.0f, distance - hitTolerance);
+    }
+
+    maxDistance -= hitTolerance;
+    if (maxDistance <= kBakeEpsilon) {
+        return true;
+    }
+    return !bake_trace(data, scene, origin + rayDirection * hitTolerance, rayDirection, maxDistance,
+                       kBakeMaskShadow, true).hit;
+}
+
+// -----------------------------------------------------------------------------
+// Emissive surfaces
+// -----------------------------------------------------------------------------
+
+struct BakeEmissiveEstimate {
+    float3 irradiance;
+    float3 weightedDirection;
+    float directionWeight;
+    float referenceNoL;
+};
+
+struct BakeEmitterSample {
+    float3 positionWS;
+    float3 normalWS;
+    float3 emission;
+    float pdfArea;
+    bool twoSided;
+};
+
+// Point on the chosen emitter, with its selection probability turned into an area pdf.
+static bool bake_sample_emitter_point(thread const LightBakeSceneData& data, LightBakeEmitter emitter,
+                                      float selectionPdf, uint sampleSeed, int sampleIndex,
+                                      thread BakeEmitterSample& outSample) {
+    float2 random = bake_random2(sampleSeed + uint(sampleIndex * 2 + 101), sampleSeed + uint(sampleIndex * 2 + 102));
+    float sqrtU = sqrt(clamp(random.x, 0.0f, 1.0f));
+    float bary0 = 1.0f - sqrtU;
+    float bary1 = sqrtU * (1.0f - random.y);
+    float bary2 = 1.0f - bary0 - bary1;
+
+    float3 positionWS = emitter.p0.xyz * bary0 + emitter.p1.xyz * bary1 + emitter.p2.xyz * bary2;
+    float3 normalWS = bake_normalize(emitter.n0.xyz * bary0 + emitter.n1.xyz * bary1 + emitter.n2.xyz * bary2);
+    if (dot(normalWS, normalWS) <= kBakeEpsilon) {
+        normalWS = bake_normalize(cross(emitter.p1.xyz - emitter.p0.xyz, emitter.p2.xyz - emitter.p0.xyz));
+    }
+    float2 uv = emitter.uv01.xy * bary0 + emitter.uv01.zw * bary1 + emitter.uv2.xy * bary2;
+    BakeMaterialSample material = bake_resolve_material(data, int(emitter.material), uv);
+    if (bake_luminance(material.emission) <= 0.001f) {
+        return false;
+    }
+
+    outSample.positionWS = positionWS;
+    outSample.normalWS = dot(normalWS, normalWS) > kBakeEpsilon ? normalWS : float3(0.0f, 1.0f, 0.0f);
+    outSample.emission = material.emission;
+    outSample.pdfArea = max(selectionPdf / max(emitter.p0.w, 1e-5f), 1e-5f);
+    outSample.twoSided = emitter.n0.w > 0.5f;
+    return true;
+}
+
+// Picks an emitter by weight through the alias table (SampleEmissiveTriangleSurface).
+static bool bake_sample_emitter_alias(thread const LightBakeSceneData& data, uint sampleSeed, int sampleIndex,
+                                      thread BakeEmitterSample& outSample) {
+    uint emitterCount = data.params->emitterCount;
+    float selection = bake_hash_to_unit(sampleSeed + uint(sampleIndex * 92821 + 17)) * float(emitterCount);
+    uint slot = min(emitterCount - 1u, uint(selection));
+    LightBakeAliasEntry entry = data.aliasTable[slot];
+    uint index = (selection - float(slot) < entry.probability) ? slot : entry.alias;
+    LightBakeEmitter emitter = data.emitters[index];
+    float selectionPdf = emitter.p1.w / max(data.params->totalEmitterWeight, 1e-5f);
+    return bake_sample_emitter_point(data, emitter, selectionPdf, sampleSeed, sampleIndex, outSample);
+}
+
+// Upper bound of what a light tree node sends to the point (EmissiveLightNodeImportance).
+static float bake_light_node_importance(LightBakeLightNode node, float3 positionWS, float3 normalWS) {
+    float3 center = (node.boundsMin.xyz + node.boundsMax.xyz) * 0.5f;
+    float3 halfExtent = node.boundsMax.xyz - center;
+    float radiusSq = dot(halfExtent, halfExtent);
+    float3 toPoint = positionWS - center;
+    float distanceSq = dot(toPoint, toPoint);
+    float weight = node.boundsMin.w;
+    if (distanceSq <= radiusSq) {
+        return weight / max(radiusSq, 1e-4f);
+    }
+
+    float distance = sqrt(distanceSq);
+    float3 direction = toPoint / distance;
+    float boundsAngle = asin(clamp(sqrt(radiusSq) / distance, 0.0f, 1.0f));
+    float emitterCos = 1.0f;
+    float coneAngle = node.boundsMax.w;
+    if (coneAngle < PI) {
+        float angle = acos(clamp(dot(node.coneAxis.xyz, direction), -1.0f, 1.0f));
+        float reduced = max(0.0f, angle - coneAngle - boundsAngle);
+        if (reduced >= HALF_PI) {
+            return 0.0f;
+        }
+        emitterCos = cos(reduced);
+    }
+    float receiverAngle = acos(clamp(dot(normalWS, -direction), -1.0f, 1.0f));
+    float receiverReduced = max(0.0f, receiverAngle - boundsAngle);
+    if (receiverReduced >= HALF_PI) {
+        return 0.0f;
+    }
+    return weight * emitterCos * cos(receiverReduced) / distanceSq;
+}
+
+// Walks the light tree from the root by child importance (SampleEmissiveLightTree).
+static bool bake_sample_emitter_tree(thread const LightBakeSceneData& data, float3 positionWS, float3 normalWS,
+                                     uint sampleSeed, int sampleIndex, thread BakeEmitterSample& outSample) {
+    float selection = bake_hash_to_unit(sampleSeed + uint(sampleIndex * 92821 + 17));
+    float selectionPdf = 1.0f;
+    uint nodeIndex = 0u;
+    while (data.lightTree[nodeIndex].leaf == 0u) {
+        uint left = data.lightTree[nodeIndex].child;
+        float leftImportance = bake_light_node_importance(data.lightTree[left], positionWS, normalWS);
+        float rightImportance = bake_light_node_importance(data.lightTree[left + 1u], positionWS, normalWS);
+        float total = leftImportance + rightImportance;
+        if (total <= 0.0f) {
+            return false;
+        }
+        float leftProbability = leftImportance / total;
+        if (selection < leftProbability) {
+            selection = min(selection / leftProbability, 0.99999994f);
+            selectionPdf *= leftProbability;
+            nodeIndex = left;
+        } else {
+            selection = min((selection - leftProbability) / (1.0f - leftProbability), 0.99999994f);
+            selectionPdf *= 1.0f - leftProbability;
+            nodeIndex = left + 1u;
+        }
+    }
+    LightBakeEmitter emitter = data.emitters[data.lightTree[nodeIndex].child];
+    return bake_sample_emitter_point(data, emitter, selectionPdf, sampleSeed, sampleIndex, outSample);
+}
+
+static BakeEmissiveEstimate bake_emissive_lighting(thread const LightBakeSceneData& data,
+                                                   instance_acceleration_structure scene,
+                                                   float3 positionWS,
+                                                   float3 normalWS,
+                                                   uint sampleSeed,
+                                                   int sampleCount) {
+    BakeEmissiveEstimate estimate;
+    estimate.irradiance = float3(0.0f);
+    estimate.weightedDirection = float3(0.0f);
+    estimate.directionWeight = 0.0f;
+    estimate.referenceNoL = 0.0f;
+    if (data.params->emitterCount == 0u) {
+        return estimate;
+    }
+
+    sampleCount = clamp(sampleCount, 1, 16);
+    float3 origin = positionWS + normalWS * 0.0035f;
+    for (int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex) {
+        BakeEmitterSample sample;
+        bool sampled = data.params->lightNodeCount == 0u
+            ? bake_sample_emitter_alias(data, sampleSeed, sampleIndex, sample)
+            : bake_sample_emitter_tree(data, origin, normalWS, sampleSeed, sampleIndex, sample);
+        if (!sampled) {
+            continue;
+        }
+        float3 toEmitter = sample.positionWS - origin;
+        float distanceSq = dot(toEmitter, toEmitter);
+        if (distanceSq <= 1e-4f) {
+            continue;
+        }
+        float distance = sqrt(distanceSq);
+        float3 lightDir = toEmitter / distance;
+        float nDotL = max(dot(normalWS, lightDir), 0.0f);
+        if (nDotL <= 0.0f) {
+            continue;
+        }
+        float emitterCos = sample.twoSided ? abs(dot(sample.normalWS, -lightDir)) : max(dot(sample.normalWS, -lightDir), 0.0f);
+        if (emitterCos <= 0.0f) {
+            continue;
+        }
+        if (bake_trace(data, scene, origin, lightDir, max(0.0f, distance - 0.01f), kBakeMaskShadow, true).hit) {
+            continue;
+        }
+
+        float geometry = (nDotL * emitterCos) / max(distanceSq, 0.01f);
+        float3 contribution = bake_clamp_color(sample.emission * (geometry / max(sample.pdfArea, 1e-5f)), 32.0f);
+        estimate.irradiance += contribution;
+        float weight = max(bake_luminance(contribution), 0.0f);
+        estimate.weightedDirection += lightDir * weight;
+        estimate.directionWeight += weight;
+        estimate.referenceNoL += nDotL * weight;
+    }
+
+    float invSampleCount = 1.0f / float(sampleCount);
+    estimate.irradiance *= invSampleCount;
+    estimate.weightedDirection *= invSampleCount;
+    estimate.directionWeight *= invSampleCount;
+    estimate.referenceNoL *= invSampleCount;
+    return estimate;
+}
+
+// -----------------------------------------------------------------------------
+// Indirect
+// -----------------------------------------------------------------------------
+
+static float3 bake_environment(thread const LightBakeSceneData& data, float3 directionWS) {
+    constant LightBakeParams& params = *data.params;
+    float up = clamp(directionWS.y * 0.5f + 0.5f, 0.0f, 1.0f);
+    float3 skyTint = params.tint.rgb * float3(0.55f, 0.65f, 0.8f);
+    float3 horizonTint = params.tint.rgb * float3(0.45f, 0.47f, 0.5f);
+    float3 groundTint = params.tint.rgb * float3(0.14f, 0.12f, 0.1f);
+    float skyWeight = pow(up, 0.35f);
+    float groundWeight = pow(1.0f - up, 1.75f);
+    float3 sky = (skyTint * skyWeight + horizonTint * (1.0f - skyWeight)) * params.intensities.x;
+    float3 ground = groundTint * (groundWeight * 0.35f);
+    float3 ibl = sky * params.intensities.y;
+    return bake_clamp_color(params.ambient.rgb + ibl + ground, 8.0f);
+}
+
+static float3 bake_cosine_hemisphere(float3 normalWS, float2 random) {
+    float r = sqrt(clamp(random.x, 0.0f, 1.0f));
+    float phi = 2.0f * PI * random.y;
+    float x = r * cos(phi);
+    float y = r * sin(phi);
+    float z = sqrt(clamp(1.0f - random.x, 0.0f, 1.0f));
+
+    float3 reference = abs(normalWS.y) < 0.999f ? float3(0.0f, 1.0f, 0.0f) : float3(1.0f, 0.0f, 0.0f);
+    float3 tangent = bake_normalize(cross(normalWS, reference));
+    if (dot(tangent, tangent) <= kBakeEpsilon) {
+        tangent = bake_normalize(cross(normalWS, float3(0.0f, 0.0f, -1.0f)));
+    }
+    float3 bitangent = bake_normalize(cross(tangent, normalWS));
+    return bake_normalize(tangent * x + bitangent * y + normalWS * z);
+}
+
+static float3 bake_direct_at(thread const LightBakeSceneData& data,
+                             instance_acceleration_structure scene,
+                             float3 positionWS,
+                             float3 normalWS) {
+    float3 direct = float3(0.0f);
+    for (uint lightIndex = 0; lightIndex < data.params->lightCount; ++lightIndex) {
+        LightBakeLight light = data.lights[lightIndex];
+        float3 contribution = bake_light_contribution(light, positionWS, normalWS);
+        if (dot(contribution, contribution) <= kBakeEpsilon) {
+            continue;
+        }
+        if (!bake_light_visible(data, scene, light, positionWS, normalWS)) {
+            continue;
+        }
+        direct += contribution;
+    }
+    return direct;
+}
+
+static float3 bake_indirect_lighting(thread const LightBakeSceneData& data,
+                                     instance_acceleration_structure scene,
+                                     float3 positionWS,
+                                     float3 normalWS,
+                                     uint sampleSeed,
+                                     int sampleCount) {
+    constant LightBakeParams& params = *data.params;
+    if (params.indirectBounces <= 0 || params.samplesPerTexel <= 0) {
+        return float3(0.0f);
+    }
+
+    sampleCount = clamp(sampleCount, 1, 64);
+    const int bounceCount = clamp(params.indirectBounces, 1, 4);
+    const float3 environmentFallback = bake_environment(data, normalWS);
+
+    float3 accumulatedIndirect = float3(0.0f);
+    for (int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex) {
+        float3 throughput = float3(1.0f);
+        float3 bounceOrigin = positionWS + normalWS * 0.005f;
+        float3 bounceDirection = bake_cosine_hemisphere(
+            normalWS,
+            bake_random2(sampleSeed + uint(sampleIndex * 2 + 1), sampleSeed + uint(sampleIndex * 2 + 2)));
+
+        for (int bounceIndex = 0; bounceIndex < bounceCount; ++bounceIndex) {
+            BakeHit hit = bake_trace(data, scene, bounceOrigin, bounceDirection, 512.0f, kBakeMaskAll, false);
+            if (!hit.hit) {
+                accumulatedIndirect += throughput * bake_environment(data, bounceDirection);
+                break;
+            }
+
+            LightBakeInstance instance = data.instances[hit.instance];
+            LightBakeTriangle triangle = data.triangles[instance.triangleOffset + hit.primitive];
+            float3x3 normalMatrix = float3x3(instance.normalMatrix[0].xyz, instance.normalMatrix[1].xyz,
+                                             instance.normalMatrix[2].xyz);
+            float3 hitNormal = bake_normalize(normalMatrix * triangle.normal.xyz);
+            if (dot(hitNormal, hitNormal) <= kBakeEpsilon) {
+                hitNormal = bake_normalize(-bounceDirection);
+            } else if (dot(hitNormal, bounceDirection) > 0.0f) {
+                hitNormal = -hitNormal;
+            }
+            if (instance.contributeGI == 0u) {
+                break;
+            }
+
+            float3 hitPoint = bounceOrigin + bounceDirection * hit.distance;
+            BakeMaterialSample surface = bake_resolve_material(
+                data, bake_hit_material(data, hit.instance, hit.primitive),
+                bake_hit_uv(data, hit.instance, hit.primitive, hit.barycentrics));
+
+            float3 shadingPoint = hitPoint + hitNormal * 0.0035f;
+            float3 directBounce = bake_direct_at(data, scene, shadingPoint, hitNormal);
+            if (params.emitterCount > 0u) {
+                directBounce += bake_emissive_lighting(data, scene, shadingPoint, hitNormal,
+                                                       sampleSeed + uint(sampleIndex * 271 + bounceIndex * 3571 + 911),
+                                                       max(1, min(4, sampleCount / 4))).irradiance;
+            }
+
+            float3 lambert = surface.albedo * (surface.ao / PI);
+            accumulatedIndirect += throughput * (lambert * (directBounce + surface.emission));
+            if (bounceIndex == bounceCount - 1) {
+                accumulatedIndirect += throughput * (lambert * (environmentFallback * 0.35f));
+                break;
+            }
+
+            throughput *= surface.albedo * (surface.ao * 0.82f);
+            float rrProbability = clamp(max(throughput.x, max(throughput.y, throughput.z)), 0.1f, 0.95f);
+            if (bounceIndex > 0 && bake_hash_to_unit(sampleSeed + uint(sampleIndex * 17 + bounceIndex * 131)) > rrProbability) {
+                break;
+            }
+            if (bounceIndex > 0) {
+                throughput /= rrProbability;
+            }
+
+            bounceOrigin = hitPoint + hitNormal * 0.005f;
+            bounceDirection = bake_cosine_hemisphere(
+                hitNormal,
+                bake_random2(sampleSeed + uint((sampleIndex + 1) * 193 + bounceIndex * 37),
+                             sampleSeed + uint((sampleIndex + 1) * 389 + bounceIndex * 53)));
+        }
+    }
+
+    return bake_clamp_color(accumulatedIndirect / float(sampleCount), 12.0f);
+}
+
+static int bake_adaptive_sample_count(thread const LightBakeSceneData& data, float3 directLighting,
+                                      float emissionLuminance, float ao) {
+    int baseSamples = max(1, min(48, data.params->samplesPerTexel / 32));
+    float directComplexity = clamp(bake_luminance(directLighting) / 1.5f, 0.0f, 1.0f);
+    float emissiveComplexity = clamp(emissionLuminance / 2.0f, 0.0f, 1.0f);
+    float occlusionComplexity = 1.0f - clamp(ao, 0.0f, 1.0f);
+    float complexity = clamp(directComplexity * 0.5f + emissiveComplexity * 0.3f + occlusionComplexity * 0.2f, 0.0f, 1.0f);
+    float multiplier = 0.7f + complexity * 1.7f;
+    return max(1, min(64, int(round(float(baseSamples) * multiplier))));
+}
+
+// -----------------------------------------------------------------------------
+// Queries
+// -----------------------------------------------------------------------------
+
+static LightBakeResult bake_texel(thread const LightBakeSceneData& data,
+                                  instance_acceleration_structure scene,
+                                  LightBakeQuery query) {
+    float3 positionWS = query.position.xyz;
+    float3 geometryNormalWS = query.geometryNormal.xyz;
+    float3 shadingNormalWS = query.shadingNormal.xyz;
+
+    LightBakeResult result;
+    result.indirect = float4(0.0f);
+    result.dominant = float4(0.0f);
+    result.shadowmask = float4(-1.0f);
+
+    float3 accumulated = float3(0.0f);
+    float3 dominantDirection = float3(0.0f);
+    float dominantWeight = 0.0f;
+    float referenceNoL = 0.0f;
+    for (uint lightIndex = 0; lightIndex < data.params->lightCount; ++lightIndex) {
+        LightBakeLight light = data.lights[lightIndex];
+        float3 contribution = bake_light_contribution(light, positionWS, shadingNormalWS);
+        if (dot(contribution, contribution) <= kBakeEpsilon) {
+            continue;
+        }
+        bool visible = bake_light_visible(data, scene, light, positionWS, geometryNormalWS);
+        if (light.flags.y != 0 && light.flags.w >= 0) {
+            result.shadowmask[light.flags.w] = visible ? 1.0f : 0.0f;
+        }
+        if (!visible || light.flags.y != 0) {
+            continue;
+        }
+        accumulated += contribution;
+
+        float3 lightDir;
+        float sampleNoL = 0.0f;
+        if (bake_incident_direction(light, positionWS, shadingNormalWS, lightDir, sampleNoL)) {
+            float weight = max(bake_luminance(contribution), 0.0f);
+            dominantDirection += lightDir * weight;
+            dominantWeight += weight;
+            referenceNoL += sampleNoL * weight;
+        }
+    }
+    if (data.params->emitterCount > 0u) {
+        BakeEmissiveEstimate emissive = bake_emissive_lighting(
+            data, scene, positionWS, shadingNormalWS, query.seeds.x,
+            max(1, min(8, data.params->samplesPerTexel / 32)));
+        accumulated += emissive.irradiance;
+        dominantDirection += emissive.weightedDirection;
+        dominantWeight += emissive.directionWeight;
+        referenceNoL += emissive.referenceNoL;
+    }
+    accumulated = bake_clamp_color(accumulated, 16.0f);
+
+    if (query.control.y != 0u && data.params->indirectBounces > 0) {
+        int sampleCount = bake_adaptive_sample_count(data, accumulated, query.position.w, query.geometryNormal.w);
+        result.indirect.xyz = bake_indirect_lighting(data, scene, positionWS, geometryNormalWS, query.seeds.y, sampleCount);
+    }
+    result.direct = float4(accumulated, 0.0f);
+    if (dominantWeight > kBakeEpsilon) {
+        result.dominant = float4(dominantDirection / dominantWeight, referenceNoL / dominantWeight);
+        result.indirect.w = 1.0f;
+    }
+    return result;
+}
+
+static float3 bake_probe_irradiance(thread const LightBakeSceneData& data,
+                                    instance_acceleration_structure scene,
+                                    float3 positionWS,
+                                    float3 normalWS,
+                                    uint sampleSeed,
+                                    int indirectSamples) {
+    float3 direct = bake_direct_at(data, scene, positionWS, normalWS);
+    if (data.params->emitterCount > 0u) {
+        direct += bake_emissive_lighting(data, scene, positionWS, normalWS, sampleSeed ^ 0x9e3779b9u,
+                                         max(1, min(8, indirectSamples / 12))).irradiance;
+    }
+    float3 indirect = bake_indirect_lighting(data, scene, positionWS, normalWS, sampleSeed, indirectSamples);
+    return bake_clamp_color(direct + indirect, 16.0f);
+}
+
+static float3 bake_probe_specular(thread const LightBakeSceneData& data,
+                                  instance_acceleration_structure scene,
+                                  float3 positionWS,
+                                  float3 sampleDirectionWS,
+                                  uint sampleSeed,
+                                  int indirectSamples) {
+    float3 directionWS = bake_normalize(sampleDirectionWS);
+    if (dot(directionWS, directionWS) <= kBakeEpsilon) {
+        return float3(0.0f);
+    }
+
+    float3 radiance = bake_environment(data, directionWS);
+    for (uint lightIndex = 0; lightIndex < data.params->lightCount; ++lightIndex) {
+        LightBakeLight light = data.lights[lightIndex];
+        float3 incidentDir;
+        float referenceNoL = 0.0f;
+        if (!bake_incident_direction(light, positionWS, directionWS, incidentDir, referenceNoL)) {
+            continue;
+        }
+        if (!bake_light_visible(data, scene, light, positionWS, directionWS)) {
+            continue;
+        }
+        float3 contribution = bake_light_contribution(light, positionWS, directionWS);
+        if (dot(contribution, contribution) <= kBakeEpsilon) {
+            continue;
+        }
+        float alignment = clamp(dot(directionWS, incidentDir), 0.0f, 1.0f);
+        float lobe = 0.15f + 0.85f * alignment * alignment;
+        radiance += contribution * lobe * 1.35f;
+    }
+    if (data.params->emitterCount > 0u) {
+        radiance += bake_emissive_lighting(data, scene, positionWS, directionWS, sampleSeed ^ 0x6a09e667u,
+                                           max(1, min(8, indirectSamples / 10))).irradiance;
+    }
+    float3 indirect = bake_indirect_lighting(data, scene, positionWS, directionWS, sampleSeed ^ 0xbb67ae85u,
+                                             max(1, indirectSamples / 2));
+    radiance += indirect * 0.65f;
+    return bake_clamp_color(radiance, 24.0f);
+}
+
+kernel void lightBakeKernel(device const LightBakeQuery* queries [[buffer(0)]],
+                            device LightBakeResult* results [[buffer(1)]],
+                            constant LightBakeParams& params [[buffer(2)]],
+                            device const LightBakeLight* lights [[buffer(3)]],
+                            device const LightBakeEmitter* emitters [[buffer(4)]],
+                            device const LightBakeInstance* instances [[buffer(5)]],
+                            device const LightBakeTriangle* triangles [[buffer(6)]],
+                            device const LightBakeMaterial* materials [[buffer(7)]],
+                            device const LightBakeTexture* textures [[buffer(8)]],
+                            device const uchar4* texels [[buffer(9)]],
+                            instance_acceleration_structure scene [[buffer(10)]],
+                            device const LightBakeAliasEntry* aliasTable [[buffer(11)]],
+                            device const LightBakeLightNode* lightTree [[buffer(12)]],
+                            uint gid [[thread_position_in_grid]]) {
+    if (gid >= params.queryCount) {
+        return;
+    }
+    LightBakeSceneData data;
+    data.params = &params;
+    data.lights = lights;
+    data.emitters = emitters;
+    data.aliasTable = aliasTable;
+    data.lightTree = lightTree;
+    data.instances = instances;
+    data.triangles = triangles;
+    data.materials = materials;
+    data.textures = textures;
+    data.texels = texels;
+
+    const uint index = params.queryOffset + gid;
+    LightBakeQuery query = queries[index];
+    LightBakeResult result;
+    if (query.control.x == kBakeModeTexel) {
+        result = bake_texel(data, scene, query);
+    } else {
+        float3 lighting = query.control.x == kBakeModeProbeSpecular
+            ? bake_probe_specular(data, scene, query.position.xyz, query.geometryNormal.xyz, query.seeds.x,
+                                  int(query.control.z))
+            : bake_probe_irradiance(data, scene, query.position.xyz, query.geometryNormal.xyz, query.seeds.x,
+                                    int(query.control.z));
+        result.direct = float4(lighting, 0.0f);
+        result.indirect = float4(0.0f);
+        result.dominant = float4(0.0f);
+        result.shadowmask = float4(-1.0f);
+    }
+    results[index] = result;
+}
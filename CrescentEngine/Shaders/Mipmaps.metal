@@ -0,0 +1,146 @@
+#include "Common.metal.h"
+using namespace metal;
+
+// Filtered mip generation for imported RGBA8 textures (MipmapGenerator). Each level is built from
+// the one above it, read and written through unorm views, so sRGB data is converted here.
+
+struct MipDownsampleParams {
+    uint srgb;
+    uint level;       // level being built; 0 measures level 0 itself
+    float alphaCutoff;
+    uint _pad0;
+};
+
+constant uint kCoverageBins = 256;
+
+inline float3 mipSrgbToLinear(float3 c) {
+    return select(pow((c + 0.055) / 1.055, 2.4), c / 12.92, c <= 0.04045);
+}
+
+inline float3 mipLinearToSrgb(float3 c) {
+    return select(1.055 * pow(c, 1.0 / 2.4) - 0.055, c * 12.92, c <= 0.0031308);
+}
+
+// One of the four source texels under dst texel coord; odd edges repeat the last texel.
+inline float4 mipTap(texture2d<float, access::read> src, uint2 coord, uint tap) {
+    uint2 maxCoord = uint2(src.get_width() - 1, src.get_height() - 1);
+    return src.read(min(coord * 2 + uint2(tap & 1, tap >> 1), maxCoord));
+}
+
+// Averages normals as vectors. Level 0 holds unit normals as authored; below it alpha carries
+// the averaged length, which the surface shader turns into extra roughness (Toksvig).
+kernel void mip_downsample_normal(
+    texture2d<float, access::read> src [[texture(0)]],
+    texture2d<float, access::write> dst [[texture(1)]],
+    constant MipDownsampleParams& params [[buffer(0)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    if (gid.x >= dst.get_width() || gid.y >= dst.get_height()) {
+        return;
+    }
+    float3 sum = float3(0.0);
+    for (uint tap = 0; tap < 4; ++tap) {
+        float4 c = mipTap(src, gid, tap);
+        float3 n = c.xyz * 2.0 - 1.0;
+        float len = length(n);
+        float storedLength = params.level == 1 ? 1.0 : c.w;
+        sum += len > 1e-5 ? n * (storedLength / len) : float3(0.0);
+    }
+    float3 average = sum * 0.25;
+    float len = length(average);
+    float3 n = len > 1e-5 ? average / len : float3(0.0, 0.0, 1.0);
+    dst.write(float4(n * 0.5 + 0.5, len), gid);
+}
+
+inline float mipBoxAlpha(texture2d<float, access::read> src, uint2 coord) {
+    float sum = 0.0;
+    for (uint tap = 0; tap < 4; ++tap) {
+        sum += mipTap(src, coord, tap).w;
+    }
+    return sum * 0.25;
+}
+
+// Run as a single threadgroup. For level 0 it stores the share of texels passing the cutoff in
+// coverage[0]; for a coarser level it histograms the box-filtered alpha that level would get
+// from src and stores the scale that brings its passing share back to coverage[0].
+kernel void mip_measure_alpha_coverage(
+    texture2d<float, access::read> src [[texture(0)]],
+    constant MipDownsampleParams& params [[buffer(0)]],
+    device float* coverage [[buffer(1)]],
+    uint tid [[thread_index_in_threadgroup]],
+    uint threadCount [[threads_per_threadgroup]]
+) {
+    threadgroup atomic_uint histogram[kCoverageBins];
+    for (uint i = tid; i < kCoverageBins; i += threadCount) {
+        atomic_store_explicit(&histogram[i], 0u, memory_order_relaxed);
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    uint2 srcSize = uint2(src.get_width(), src.get_height());
+    uint2 size = params.level == 0 ? srcSize : max(srcSize / 2, uint2(1));
+    uint count = size.x * size.y;
+    for (uint i = tid; i < count; i += threadCount) {
+        uint2 coord = uint2(i % size.x, i / size.x);
+        float alpha = params.level == 0 ? src.read(coord).w : mipBoxAlpha(src, coord);
+        uint bin = min(uint(saturate(alpha) * float(kCoverageBins - 1) + 0.5), kCoverageBins - 1);
+        atomic_fetch_add_explicit(&histogram[bin], 1u, memory_order_relaxed);
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    if (tid != 0) {
+        return;
+    }
+
+    uint cutoffBin = uint(ceil(params.alphaCutoff * float(kCoverageBins - 1)));
+    if (params.level == 0) {
+        uint passing = 0;
+        for (uint bin = cutoffBin; bin < kCoverageBins; ++bin) {
+            passing += atomic_load_explicit(&histogram[bin], memory_order_relaxed);
+        }
+        coverage[0] = float(passing) / float(max(count, 1u));
+        return;
+    }
+
+    // Fully cut or fully kept textures have nothing to preserve.
+    float target = coverage[0] * float(count);
+    float scale = 1.0;
+    if (coverage[0] > 0.0 && coverage[0] < 1.0) {
+        uint passing = 0;
+        uint thresholdBin = 0;
+        for (int bin = int(kCoverageBins) - 1; bin >= 0; --bin) {
+            passing += atomic_load_explicit(&histogram[bin], memory_order_relaxed);
+            if (float(passing) >= target) {
+                thresholdBin = uint(bin);
+                break;
+            }
+        }
+        float threshold = max(float(thresholdBin), 1.0) / float(kCoverageBins - 1);
+        scale = params.alphaCutoff / threshold;
+    }
+    coverage[params.level] = scale;
+}
+
+kernel void mip_downsample_alpha_coverage(
+    texture2d<float, access::read> src [[texture(0)]],
+    texture2d<float, access::write> dst [[texture(1)]],
+    constant MipDownsampleParams& params [[buffer(0)]],
+    const device float* coverage [[buffer(1)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    if (gid.x >= dst.get_width() || gid.y >= dst.get_height()) {
+        return;
+    }
+    float4 sum = float4(0.0);
+    for (uint tap = 0; tap < 4; ++tap) {
+        float4 c = mipTap(src, gid, tap);
+        if (params.srgb != 0) {
+            c.rgb = mipSrgbToLinear(c.rgb);
+        }
+        sum += c;
+    }
+    float4 average = sum * 0.25;
+    if (params.srgb != 0) {
+        average.rgb = mipLinearToSrgb(average.rgb);
+    }
+    average.a = saturate(average.a * coverage[params.level]);
+    dst.write(average, gid);
+}
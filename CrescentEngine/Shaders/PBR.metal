@@ -1,3 +1,4 @@
+#include <metal_raytracing>
 #include "Common.metal.h"
 #include "PBRFunctions.metal.h"
 
@@ -5,23 +6,22 @@
 // PBR-SPECIFIC STRUCTURES
 // ============================================================================
 
-// Vertex input structure
+// Vertex input structure. Position comes from its own stream; everything else is the packed
+// attribute stream (see decodeOctNormal / decodeBitangent).
 struct VertexIn {
     float3 position [[attribute(0)]];
-    float3 normal [[attribute(1)]];
+    float2 normalOct [[attribute(1)]];
     float2 texCoord [[attribute(2)]];
-    float3 tangent [[attribute(3)]];
-    float3 bitangent [[attribute(4)]];
+    float4 tangent [[attribute(3)]];
     float4 color [[attribute(5)]];
     float2 texCoord1 [[attribute(6)]];
 };
 
 struct VertexInSkinned {
     float3 position [[attribute(0)]];
-    float3 normal [[attribute(1)]];
+    float2 normalOct [[attribute(1)]];
     float2 texCoord [[attribute(2)]];
-    float3 tangent [[attribute(3)]];
-    float3 bitangent [[attribute(4)]];
+    float4 tangent [[attribute(3)]];
     float4 color [[attribute(5)]];
     float2 texCoord1 [[attribute(6)]];
     uint4 boneIndices [[attribute(7)]];
@@ -39,6 +39,7 @@ struct VertexOut {
     float3 bitangent;
     float4 color;
     float lodFade;
+    float lodDither;
     float billboardFade;
     float billboardFlag;
     float bakedLightingFlag;
@@ -52,14 +53,29 @@ struct PrepassOut {
     float2 texCoord;
     float2 lightmapTexCoord;
     float lodFade;
+    float lodDither;
     float billboardFade;
     float billboardFlag;
 };
 
-struct VelocityOut {
+// Prepass varyings of draws that also write motion: where the vertex was last frame, and where the
+// camera alone would have put it, both through last frame's unjittered view-projection.
+struct PrepassMotionOut {
     float4 position [[position]];
-    float4 currClip;
+    float3 normalVS;
+    float2 texCoord;
+    float2 lightmapTexCoord;
+    float lodFade;
+    float lodDither;
+    float billboardFade;
+    float billboardFlag;
     float4 prevClip;
+    float4 cameraPrevClip;
+};
+
+struct PrepassTargets {
+    float4 normalRoughness [[color(0)]];
+    float4 velocity [[color(1)]];
 };
 
 struct BlitVertexOut {
@@ -68,26 +84,31 @@ struct BlitVertexOut {
 };
 
 struct SSAOParams {
-    float4 settings;     // x radius, y bias, z intensity, w power
-    float2 noiseScale;
-    float2 texelSize;
+    float4 settings;   // x radius, y intensity, z power, w frame index
+    float4 resolution; // xy full-res pixels per SSAO pixel
 };
 
-struct SSAOBlurParams {
-    float2 texelSize;
-    float depthSharpness;
-    float normalSharpness;
+struct SSAOTemporalParams {
+    float4x4 prevViewProjection;
+    float4 params0; // x feedback, y historyValid, z useVelocity, w depth rejection
+};
+
+struct SSAOUpsampleParams {
+    float4 params0; // xy full-res pixels per SSAO pixel, z depth sharpness
 };
 
 struct SSRParams {
-    float4 settings0; // texelSize.xy, thickness, maxSteps
+    float4x4 prevViewProjection;
+    float4 settings0; // texelSize.xy, thickness, maxIterations
     float4 settings1; // maxDistance, maxRoughness, fadeStart, fadeEnd
+    float4 settings2; // frameIndex, hizMipCount, historyValid, feedback
+    float4 settings3; // useVelocity, padding, padding, padding
 };
 
 struct DecalParams {
     float4 colorOpacity;   // rgb + opacity
     float4 uvTilingOffset; // xy tiling, zw offset
-    float4 edgeParams;     // softness, padding
+    float4 edgeParams;     // softness, 1 / viewport width, 1 / viewport height, padding
     float4 mapFlags;       // hasAlbedo, hasNormal, hasOrm, hasMask
     float4x4 modelMatrix;
     float4x4 invModel;
@@ -179,12 +200,19 @@ struct FogParams {
     float4 shadowParams;    // shadowIndex, cascadeCount, enabled, strength
     float4x4 prevViewProjection;
     float4x4 prevViewMatrix;
+    float4 updateParams;    // froxel interleave (1, 2 or 4), refresh phase, padding, padding
 };
 
 struct VelocityUniforms {
     float4x4 prevModelMatrix;
+    float4x4 prevViewProjection;
+};
+
+struct VelocityReconstructParams {
+    float4x4 inverseViewProjection; // jittered, as the prepass rasterized depth
     float4x4 currViewProjection;
     float4x4 prevViewProjection;
+    float4 texelSize;               // 1 / viewport width, 1 / viewport height, padding, padding
 };
 
 // Environment helpers
@@ -196,6 +224,11 @@ inline float2 uvToNdc(float2 uv) {
     return float2(uv.x * 2.0 - 1.0, (1.0 - uv.y) * 2.0 - 1.0);
 }
 
+inline float2 clipToUv(float4 clip) {
+    float2 ndc = clip.xy / clip.w;
+    return float2(ndc.x * 0.5 + 0.5, 1.0 - (ndc.y * 0.5 + 0.5));
+}
+
 inline float3 reconstructViewPosition(float2 uv,
                                       float depth,
                                       constant CameraUniforms& camera) {
@@ -367,16 +400,6 @@ inline float3 applyWindOffset(float3 worldPos,
     return worldPos + dir * offset;
 }
 
-inline float3 normalizedTerrainWeights(float3 weights, float sharpness) {
-    weights = max(weights, float3(0.0));
-    weights = pow(weights, float3(max(sharpness, 0.1)));
-    float sum = weights.x + weights.y + weights.z;
-    if (sum <= 0.0001) {
-        return float3(1.0, 0.0, 0.0);
-    }
-    return weights / sum;
-}
-
 inline float3 computeTerrainWeights(float2 uv,
                                     float3 worldPos,
                                     float3 normalWS,
@@ -510,29 +533,21 @@ constant float2 kPoissonDisk16[16] = {
     float2(0.14383161, -0.14100790)
 };
 
-constant float3 kSSAOKernel[16] = {
-    float3(0.5381, 0.1856, 0.4319),
-    float3(0.1379, 0.2486, 0.4430),
-    float3(0.3371, 0.5679, 0.0057),
-    float3(-0.6999, -0.0451, 0.0019),
-    float3(0.0689, -0.1598, 0.8547),
-    float3(0.0560, 0.0069, 0.1843),
-    float3(-0.0146, 0.1402, 0.0762),
-    float3(0.0100, -0.1924, 0.0344),
-    float3(-0.3577, -0.5301, 0.4358),
-    float3(-0.3169, 0.1063, 0.0158),
-    float3(0.0103, -0.5869, 0.0046),
-    float3(-0.0897, -0.4940, 0.3287),
-    float3(0.7119, -0.0154, 0.0918),
-    float3(-0.0533, 0.0596, 0.5411),
-    float3(0.0352, -0.0631, 0.5460),
-    float3(-0.4776, 0.2847, 0.0271)
-};
-
 inline float hash21(float2 p) {
     return fract(sin(dot(p, float2(12.9898, 78.233))) * 43758.5453);
 }
 
+// Screen-door cross-fade between mesh LOD levels. Both levels are drawn during a transition with
+// opposite signs so they keep complementary pixels: x > 0 keeps noise <= x (outgoing level),
+// x < 0 keeps noise > -x (incoming level), 0 keeps everything.
+inline bool lodDitherDiscard(float lodDither, float2 pixel) {
+    if (lodDither == 0.0) {
+        return false;
+    }
+    float noise = hash21(floor(pixel));
+    return lodDither > 0.0 ? noise > lodDither : noise <= -lodDither;
+}
+
 constant bool kDebugPointShadowView = false;
 
 inline float2 rotate2(float2 v, float2 r) {
@@ -640,7 +655,8 @@ float pcfSampleManual(depth2d<float> atlas,
                       float2 tileMin,
                       float2 tileMax,
                       float2 rot,
-                      float radius) {
+                      float radius,
+                      int sampleCount = 16) {
     constexpr sampler shadowDepthSampler(filter::nearest, address::clamp_to_edge);
     float2 texel = 1.0 / float2(atlas.get_width(), atlas.get_height());
     float shadow = 0.0;
@@ -651,7 +667,7 @@ float pcfSampleManual(depth2d<float> atlas,
     tileMin += margin;
     tileMax -= margin;
 
-    for (int i = 0; i < 16; ++i) {
+    for (int i = 0; i < sampleCount; ++i) {
         float2 offset = rotate2(kPoissonDisk16[i], rot) * radius;
         float2 uvOffset = uv + offset * texel;
         if (uvOffset.x >= tileMin.x && uvOffset.x <= tileMax.x &&
@@ -666,6 +682,73 @@ float pcfSampleManual(depth2d<float> atlas,
     return (weightSum > 0.0) ? (shadow / weightSum) : 1.0;
 }
 
+// Light::ShadowQuality tiers (light flags bits 9-10) as PCF taps of kPoissonDisk16.
+inline int shadowFilterSampleCount(uint tier) {
+    return tier == 0u ? 8 : (tier == 1u ? 12 : 16);
+}
+
+// Depth range of the atlas over [uvMin, uvMax] from the shadow depth bounds
+// (shadow_bounds_* in Shadow.metal), read at the finest level where the rectangle spans at most
+// 2x2 texels. z is a blocker depth estimate for receiver: per texel holding anything closer, the
+// middle of its range in front of the receiver, averaged; w counts those texels.
+inline float4 shadowDepthBounds(texture2d<float> bounds, float2 uvMin, float2 uvMax, float receiver) {
+    float2 baseSize = float2(bounds.get_width(), bounds.get_height());
+    float2 extent = (uvMax - uvMin) * baseSize;
+    uint level = min(uint(ceil(log2(max(max(extent.x, extent.y), 1.0)))), bounds.get_num_mip_levels() - 1u);
+    int2 levelSize = int2(max(bounds.get_width(level), 1u), max(bounds.get_height(level), 1u));
+    int2 lo = clamp(int2(floor(uvMin * float2(levelSize))), int2(0), levelSize - 1);
+    int2 hi = clamp(int2(floor(uvMax * float2(levelSize))), int2(0), levelSize - 1);
+    float4 result = float4(1.0, 0.0, 0.0, 0.0);
+    for (int y = lo.y; y <= hi.y; ++y) {
+        for (int x = lo.x; x <= hi.x; ++x) {
+            float2 range = bounds.read(uint2(x, y), level).xy;
+            result.x = min(result.x, range.x);
+            result.y = max(result.y, range.y);
+            if (range.x < receiver) {
+                result.z += 0.5 * (range.x + min(range.y, receiver));
+                result.w += 1.0;
+            }
+        }
+    }
+    result.z = result.w > 0.0 ? result.z / result.w : 0.0;
+    return result;
+}
+
+// PCF with a bounds pre-pass: a footprint entirely in front of or behind every occluder in it
+// returns without sampling. Shadowed only counts when no tap would fall outside the tile, as
+// those are skipped and an empty filter reads lit.
+float pcfSampleBounded(depth2d<float> atlas,
+                       texture2d<float> bounds,
+                       bool hasBounds,
+                       float2 uv,
+                       float depth,
+                       float bias,
+                       float2 tileMin,
+                       float2 tileMax,
+                       float2 rot,
+                       float radius,
+                       int sampleCount) {
+    if (hasBounds) {
+        float2 texel = 1.0 / float2(atlas.get_width(), atlas.get_height());
+        float2 margin = texel * (radius + 1.0);
+        float2 footprintMin = uv - texel * radius;
+        float2 footprintMax = uv + texel * radius;
+        float2 rectMin = max(footprintMin, tileMin + margin);
+        float2 rectMax = min(footprintMax, tileMax - margin);
+        if (all(rectMin <= rectMax)) {
+            float receiver = depth - bias;
+            float4 range = shadowDepthBounds(bounds, rectMin, rectMax, receiver);
+            if (range.x >= receiver) {
+                return 1.0;
+            }
+            if (range.y < receiver && all(rectMin == footprintMin) && all(rectMax == footprintMax)) {
+                return 0.0;
+            }
+        }
+    }
+    return pcfSampleManual(atlas, uv, depth, bias, tileMin, tileMax, rot, radius, sampleCount);
+}
+
 float pcssSample(depth2d<float> atlas,
                  sampler shadowSampler,
                  float2 uv,
@@ -675,13 +758,36 @@ float pcssSample(depth2d<float> atlas,
                  float2 tileMax,
                  float penumbra,
                  float2 rot,
-                 float baseRadius) {
+                 float baseRadius,
+                 texture2d<float> bounds,
+                 bool hasBounds,
+                 uint filterTier) {
     constexpr sampler shadowDepthSampler(filter::nearest, address::clamp_to_edge);
     float2 texel = 1.0 / float2(atlas.get_width(), atlas.get_height());
     float searchRadius = max(baseRadius * 2.0, 2.0);
     float2 margin = texel * (searchRadius + 1.0);
     float2 minBounds = tileMin + margin;
     float2 maxBounds = tileMax - margin;
+    int sampleCount = shadowFilterSampleCount(filterTier);
+
+    // Hierarchical blocker search: the search region's depth range says whether anything blocks
+    // at all, and below Ultra its few coarse texels stand in for the sixteen-tap search.
+    if (hasBounds) {
+        float2 rectMin = max(uv - texel * searchRadius, minBounds);
+        float2 rectMax = min(uv + texel * searchRadius, maxBounds);
+        if (any(rectMin > rectMax)) {
+            return 1.0;
+        }
+        float4 range = shadowDepthBounds(bounds, rectMin, rectMax, depth - bias);
+        if (range.x >= depth - bias) {
+            return 1.0;
+        }
+        if (filterTier < 3u) {
+            float penumbraRatio = saturate((depth - range.z) / max(range.z, 0.0001));
+            float radius = clamp(baseRadius + penumbraRatio * penumbra * 24.0, baseRadius, 32.0);
+            return pcfSampleBounded(atlas, bounds, true, uv, depth, bias, tileMin, tileMax, rot, radius, sampleCount);
+        }
+    }
 
     // Blocker search
     float blockerDepth = 0.0;
@@ -705,7 +811,7 @@ float pcssSample(depth2d<float> atlas,
     float avgBlocker = blockerDepth / blockers;
     float penumbraRatio = saturate((depth - avgBlocker) / max(avgBlocker, 0.0001));
     float radius = clamp(baseRadius + penumbraRatio * penumbra * 24.0, baseRadius, 32.0);
-    return pcfSampleManual(atlas, uv, depth, bias, tileMin, tileMax, rot, radius);
+    return pcfSampleBounded(atlas, bounds, hasBounds, uv, depth, bias, tileMin, tileMax, rot, radius, sampleCount);
 }
 
 inline float sampleShadowCascade(const device ShadowGPUData* shadowData,
@@ -718,7 +824,10 @@ inline float sampleShadowCascade(const device ShadowGPUData* shadowData,
                                  bool usePCSS,
                                  bool useContact,
                                  float baseTexelWorld,
-                                 bool isCascade) {
+                                 bool isCascade,
+                                 texture2d<float> depthBounds,
+                                 bool hasBounds,
+                                 uint filterTier) {
     ShadowGPUData s = shadowData[idx];
     float3 n = normalize(normalWS);
     float nDotLPre = saturate(dot(n, normalize(lightDirWS)));
@@ -787,12 +896,15 @@ inline float sampleShadowCascade(const device ShadowGPUData* shadowData,
             shadow = sampleShadowDepthPCF(atlas, shadowSampler, uv, depth, bias, tileMin, tileMax, float2(1.0, 0.0), 0.0);
         } else {
             float cascadeRadius = clamp(kernelRadius, 0.7, 2.2);
-            shadow = pcfSampleManual(atlas, uv, depth, bias, tileMin, tileMax, rot, cascadeRadius);
+            shadow = pcfSampleBounded(atlas, depthBounds, hasBounds, uv, depth, bias, tileMin, tileMax, rot,
+                                      cascadeRadius, shadowFilterSampleCount(filterTier));
         }
     } else if (usePCSSLocal && penumbra > 0.0) {
-        shadow = pcssSample(atlas, shadowSampler, uv, depth, bias, tileMin, tileMax, penumbra, rot, kernelRadius);
+        shadow = pcssSample(atlas, shadowSampler, uv, depth, bias, tileMin, tileMax, penumbra, rot, kernelRadius,
+                            depthBounds, hasBounds, filterTier);
     } else {
-        shadow = pcfSampleManual(atlas, uv, depth, bias, tileMin, tileMax, rot, kernelRadius);
+        shadow = pcfSampleBounded(atlas, depthBounds, hasBounds, uv, depth, bias, tileMin, tileMax, rot,
+                                  kernelRadius, shadowFilterSampleCount(filterTier));
     }
 
     if (useContact) {
@@ -816,13 +928,17 @@ float sampleShadow(const device ShadowGPUData* shadowData,
                    depth2d<float> atlas,
                    sampler shadowSampler,
                    bool usePCSS,
-                   bool useContact) {
+                   bool useContact,
+                   texture2d<float> depthBounds,
+                   bool hasBounds,
+                   uint filterTier) {
     if (shadowIdx < 0) return 1.0;
     float baseTexelWorld = max(shadowData[shadowIdx].depthRange.z, 1e-5);
     bool usePCSSForThisLight = usePCSS;
 
     if (cascadeCount <= 1) {
-        return sampleShadowCascade(shadowData, shadowIdx, worldPos, normalWS, lightDirWS, atlas, shadowSampler, usePCSSForThisLight, useContact, baseTexelWorld, false);
+        return sampleShadowCascade(shadowData, shadowIdx, worldPos, normalWS, lightDirWS, atlas, shadowSampler, usePCSSForThisLight, useContact, baseTexelWorld, false,
+                                   depthBounds, hasBounds, filterTier);
     }
 
     float farLimit = shadowData[shadowIdx + cascadeCount - 1].depthRange.y;
@@ -872,10 +988,12 @@ float sampleShadow(const device ShadowGPUData* shadowData,
     }
 
     bool allowPCSS_A = usePCSSForThisLight;
-    float shadowA = sampleShadowCascade(shadowData, shadowIdx + cascadeA, worldPos, normalWS, lightDirWS, atlas, shadowSampler, allowPCSS_A, useContact, baseTexelWorld, true);
+    float shadowA = sampleShadowCascade(shadowData, shadowIdx + cascadeA, worldPos, normalWS, lightDirWS, atlas, shadowSampler, allowPCSS_A, useContact, baseTexelWorld, true,
+                                        depthBounds, hasBounds, filterTier);
     if (blend < 0.001) return shadowA;  // Skip second sample if blend is negligible
     bool allowPCSS_B = usePCSSForThisLight;
-    float shadowB = sampleShadowCascade(shadowData, shadowIdx + cascadeB, worldPos, normalWS, lightDirWS, atlas, shadowSampler, allowPCSS_B, useContact, baseTexelWorld, true);
+    float shadowB = sampleShadowCascade(shadowData, shadowIdx + cascadeB, worldPos, normalWS, lightDirWS, atlas, shadowSampler, allowPCSS_B, useContact, baseTexelWorld, true,
+                                        depthBounds, hasBounds, filterTier);
     return mix(shadowA, shadowB, blend);
 }
 
@@ -958,33 +1076,35 @@ float samplePointShadow(const device ShadowGPUData* shadowData,
 // VERTEX SHADER
 // ============================================================================
 
-vertex PrepassOut vertex_prepass(
-    VertexIn in [[stage_in]],
-    constant ModelUniforms& model [[buffer(1)]],
-    constant CameraUniforms& camera [[buffer(2)]],
-    constant MaterialUniforms& material [[buffer(3)]],
-    constant MeshUniforms& mesh [[buffer(4)]]
-) {
+// Wind-displaced or billboarded prepass vertex under the given model matrix. worldPos returns the
+// displaced position, which the motion variants reproject through last frame's view-projection.
+inline PrepassOut prepassVertex(VertexIn in,
+                                float4x4 modelMatrix,
+                                float4x4 normalMatrix,
+                                constant CameraUniforms& camera,
+                                constant MaterialUniforms& material,
+                                constant MeshUniforms& mesh,
+                                thread float3& worldPos) {
     PrepassOut out;
     float3 boundsCenter = mesh.boundsCenter.xyz;
     float3 boundsSize = mesh.boundsSize.xyz;
-    float3 centerWS = (model.modelMatrix * float4(boundsCenter, 1.0)).xyz;
+    float3 centerWS = (modelMatrix * float4(boundsCenter, 1.0)).xyz;
     float dist = distance(camera.cameraPositionTime.xyz, centerWS);
     float lodFade = (material.foliageParams2.y > 0.5) ? computeFade(dist, material.foliageParams1.x, material.foliageParams1.y) : 0.0;
     float billboardFade = (material.foliageParams2.z > 0.5) ? computeFade(dist, material.foliageParams1.z, material.foliageParams1.w) : 0.0;
 
     float weight = saturate(in.color.a);
     float3 worldNormal = float3(0.0, 1.0, 0.0);
-    float3 worldPos = float3(0.0);
+    worldPos = float3(0.0);
     if (mesh.flags.x > 0.5 && material.foliageParams2.z > 0.5) {
         float3 windCenter = applyWindOffset(centerWS, weight, material, camera);
         float3 toCam = normalize(camera.cameraPositionTime.xyz - windCenter);
         float3 upRef = (abs(toCam.y) < 0.98) ? float3(0.0, 1.0, 0.0) : float3(0.0, 0.0, 1.0);
         float3 right = normalize(cross(upRef, toCam));
         float3 billUp = normalize(cross(toCam, right));
-        float3 axisX = model.modelMatrix[0].xyz;
-        float3 axisY = model.modelMatrix[1].xyz;
-        float3 axisZ = model.modelMatrix[2].xyz;
+        float3 axisX = modelMatrix[0].xyz;
+        float3 axisY = modelMatrix[1].xyz;
+        float3 axisZ = modelMatrix[2].xyz;
         float uniformScale = max(length(axisX), max(length(axisY), length(axisZ)));
         float width = max(boundsSize.x, boundsSize.z) * uniformScale;
         float height = max(boundsSize.y, 0.0001) * uniformScale;
@@ -992,10 +1112,10 @@ vertex PrepassOut vertex_prepass(
         worldPos = windCenter + right * (quad.x * width) + billUp * (quad.y * height);
         worldNormal = normalize(toCam);
     } else {
-        float4 wp = model.modelMatrix * float4(in.position, 1.0);
+        float4 wp = modelMatrix * float4(in.position, 1.0);
         wp.xyz = applyWindOffset(wp.xyz, weight, material, camera);
         worldPos = wp.xyz;
-        worldNormal = normalize((model.normalMatrix * float4(in.normal, 0.0)).xyz);
+        worldNormal = normalize((normalMatrix * float4(decodeOctNormal(in.normalOct), 0.0)).xyz);
     }
 
     out.position = camera.viewProjectionMatrix * float4(worldPos, 1.0);
@@ -1003,11 +1123,76 @@ vertex PrepassOut vertex_prepass(
     out.texCoord = in.texCoord;
     out.lightmapTexCoord = in.texCoord1 * mesh.lightmapScaleOffset.xy + mesh.lightmapScaleOffset.zw;
     out.lodFade = lodFade;
+    out.lodDither = normalMatrix[3].x;
     out.billboardFade = billboardFade;
     out.billboardFlag = mesh.flags.x;
     return out;
 }
 
+vertex PrepassOut vertex_prepass(
+    VertexIn in [[stage_in]],
+    constant ModelUniforms& model [[buffer(1)]],
+    constant CameraUniforms& camera [[buffer(2)]],
+    constant MaterialUniforms& material [[buffer(3)]],
+    constant MeshUniforms& mesh [[buffer(4)]]
+) {
+    float3 worldPos;
+    return prepassVertex(in, model.modelMatrix, model.normalMatrix, camera, material, mesh, worldPos);
+}
+
+inline PrepassMotionOut prepassMotion(PrepassOut surface,
+                                      float3 worldPos,
+                                      float3 prevWorldPos,
+                                      constant VelocityUniforms& velocity) {
+    PrepassMotionOut out;
+    out.position = surface.position;
+    out.normalVS = surface.normalVS;
+    out.texCoord = surface.texCoord;
+    out.lightmapTexCoord = surface.lightmapTexCoord;
+    out.lodFade = surface.lodFade;
+    out.lodDither = surface.lodDither;
+    out.billboardFade = surface.billboardFade;
+    out.billboardFlag = surface.billboardFlag;
+    out.prevClip = velocity.prevViewProjection * float4(prevWorldPos, 1.0);
+    out.cameraPrevClip = velocity.prevViewProjection * float4(worldPos, 1.0);
+    return out;
+}
+
+// Moving meshes: the same vertex as vertex_prepass, plus where it was last frame.
+vertex PrepassMotionOut vertex_prepass_motion(
+    VertexIn in [[stage_in]],
+    constant ModelUniforms& model [[buffer(1)]],
+    constant CameraUniforms& camera [[buffer(2)]],
+    constant MaterialUniforms& material [[buffer(3)]],
+    constant MeshUniforms& mesh [[buffer(4)]],
+    constant VelocityUniforms& velocity [[buffer(5)]]
+) {
+    float3 worldPos;
+    float3 prevWorldPos;
+    PrepassOut surface = prepassVertex(in, model.modelMatrix, model.normalMatrix, camera, material, mesh, worldPos);
+    prepassVertex(in, velocity.prevModelMatrix, model.normalMatrix, camera, material, mesh, prevWorldPos);
+    return prepassMotion(surface, worldPos, prevWorldPos, velocity);
+}
+
+// Skinning-cache variant: stage_in carries already-skinned positions and previous positions come
+// from the cache's third stream, so no palette is read here.
+vertex PrepassMotionOut vertex_prepass_motion_cached(
+    VertexIn in [[stage_in]],
+    constant ModelUniforms& model [[buffer(1)]],
+    constant CameraUniforms& camera [[buffer(2)]],
+    constant MaterialUniforms& material [[buffer(3)]],
+    constant MeshUniforms& mesh [[buffer(4)]],
+    constant VelocityUniforms& velocity [[buffer(5)]],
+    const device packed_float3* prevPositions [[buffer(6)]],
+    uint vid [[vertex_id]]
+) {
+    float3 worldPos;
+    PrepassOut surface = prepassVertex(in, model.modelMatrix, model.normalMatrix, camera, material, mesh, worldPos);
+    float4 prevWorldPos = velocity.prevModelMatrix * float4(float3(prevPositions[vid]), 1.0);
+    prevWorldPos.xyz = applyWindOffset(prevWorldPos.xyz, saturate(in.color.a), material, camera);
+    return prepassMotion(surface, worldPos, prevWorldPos.xyz, velocity);
+}
+
 vertex PrepassOut vertex_prepass_instanced(
     VertexIn in [[stage_in]],
     const device InstanceData* instances [[buffer(1)]],
@@ -1016,47 +1201,41 @@ vertex PrepassOut vertex_prepass_instanced(
     constant MeshUniforms& mesh [[buffer(4)]],
     uint instanceId [[instance_id]]
 ) {
-    PrepassOut out;
     InstanceData inst = instances[instanceId];
-    float3 boundsCenter = mesh.boundsCenter.xyz;
-    float3 boundsSize = mesh.boundsSize.xyz;
-    float3 centerWS = (inst.modelMatrix * float4(boundsCenter, 1.0)).xyz;
-    float dist = distance(camera.cameraPositionTime.xyz, centerWS);
-    float lodFade = (material.foliageParams2.y > 0.5) ? computeFade(dist, material.foliageParams1.x, material.foliageParams1.y) : 0.0;
-    float billboardFade = (material.foliageParams2.z > 0.5) ? computeFade(dist, material.foliageParams1.z, material.foliageParams1.w) : 0.0;
+    float3 worldPos;
+    return prepassVertex(in, inst.modelMatrix, inst.normalMatrix, camera, material, mesh, worldPos);
+}
 
-    float weight = saturate(in.color.a);
-    float3 worldNormal = float3(0.0, 1.0, 0.0);
-    float3 worldPos = float3(0.0);
-    if (mesh.flags.x > 0.5 && material.foliageParams2.z > 0.5) {
-        float3 windCenter = applyWindOffset(centerWS, weight, material, camera);
-        float3 toCam = normalize(camera.cameraPositionTime.xyz - windCenter);
-        float3 upRef = (abs(toCam.y) < 0.98) ? float3(0.0, 1.0, 0.0) : float3(0.0, 0.0, 1.0);
-        float3 right = normalize(cross(upRef, toCam));
-        float3 billUp = normalize(cross(toCam, right));
-        float3 axisX = inst.modelMatrix[0].xyz;
-        float3 axisY = inst.modelMatrix[1].xyz;
-        float3 axisZ = inst.modelMatrix[2].xyz;
-        float uniformScale = max(length(axisX), max(length(axisY), length(axisZ)));
-        float width = max(boundsSize.x, boundsSize.z) * uniformScale;
-        float height = max(boundsSize.y, 0.0001) * uniformScale;
-        float2 quad = float2(in.position.x, in.position.z);
-        worldPos = windCenter + right * (quad.x * width) + billUp * (quad.y * height);
-        worldNormal = normalize(toCam);
-    } else {
-        float4 wp = inst.modelMatrix * float4(in.position, 1.0);
-        wp.xyz = applyWindOffset(wp.xyz, weight, material, camera);
-        worldPos = wp.xyz;
-        worldNormal = normalize((inst.normalMatrix * float4(in.normal, 0.0)).xyz);
-    }
+inline float4x4 paletteSkin(VertexInSkinned in, const device float4x4* bones) {
+    float totalWeight = in.boneWeights.x + in.boneWeights.y + in.boneWeights.z + in.boneWeights.w;
+    if (totalWeight <= 0.0) {
+        return float4x4(1.0);
+    }
+    float4 weights = in.boneWeights / totalWeight;
+    return bones[in.boneIndices.x] * weights.x +
+           bones[in.boneIndices.y] * weights.y +
+           bones[in.boneIndices.z] * weights.z +
+           bones[in.boneIndices.w] * weights.w;
+}
 
+inline PrepassOut prepassSkinnedVertex(VertexInSkinned in,
+                                       float4x4 skin,
+                                       constant ModelUniforms& model,
+                                       constant CameraUniforms& camera,
+                                       thread float3& worldPos) {
+    PrepassOut out;
+    worldPos = (model.modelMatrix * (skin * float4(in.position, 1.0))).xyz;
     out.position = camera.viewProjectionMatrix * float4(worldPos, 1.0);
+
+    float3x3 skin3 = float3x3(skin[0].xyz, skin[1].xyz, skin[2].xyz);
+    float3 worldNormal = normalize((model.normalMatrix * float4(skin3 * decodeOctNormal(in.normalOct), 0.0)).xyz);
     out.normalVS = normalize((camera.viewMatrix * float4(worldNormal, 0.0)).xyz);
     out.texCoord = in.texCoord;
-    out.lightmapTexCoord = in.texCoord1 * mesh.lightmapScaleOffset.xy + mesh.lightmapScaleOffset.zw;
-    out.lodFade = lodFade;
-    out.billboardFade = billboardFade;
-    out.billboardFlag = mesh.flags.x;
+    out.lightmapTexCoord = in.texCoord1;
+    out.lodFade = 0.0;
+    out.lodDither = model.normalMatrix[3].x;
+    out.billboardFade = 0.0;
+    out.billboardFlag = 0.0;
     return out;
 }
 
@@ -1066,128 +1245,110 @@ vertex PrepassOut vertex_prepass_skinned(
     constant CameraUniforms& camera [[buffer(2)]],
     const device float4x4* bones [[buffer(3)]]
 ) {
-    PrepassOut out;
-    float4x4 skin = float4x4(1.0);
+    float3 worldPos;
+    return prepassSkinnedVertex(in, paletteSkin(in, bones), model, camera, worldPos);
+}
+
+vertex PrepassMotionOut vertex_prepass_motion_skinned(
+    VertexInSkinned in [[stage_in]],
+    constant ModelUniforms& model [[buffer(1)]],
+    constant CameraUniforms& camera [[buffer(2)]],
+    const device float4x4* bones [[buffer(3)]],
+    constant VelocityUniforms& velocity [[buffer(5)]],
+    const device float4x4* prevBones [[buffer(6)]]
+) {
+    float3 worldPos;
+    PrepassOut surface = prepassSkinnedVertex(in, paletteSkin(in, bones), model, camera, worldPos);
+    float4 prevSkinnedPos = paletteSkin(in, prevBones) * float4(in.position, 1.0);
+    float3 prevWorldPos = (velocity.prevModelMatrix * prevSkinnedPos).xyz;
+    return prepassMotion(surface, worldPos, prevWorldPos, velocity);
+}
+
+// Crowd instances (CrowdAnimation.cpp): each instance skins with its own palette, which starts at
+// the matrix index stored in normalMatrix[3].y.
+inline float4x4 crowdInstanceSkin(VertexInSkinned in, InstanceData inst, const device float4x4* palettes) {
     float totalWeight = in.boneWeights.x + in.boneWeights.y + in.boneWeights.z + in.boneWeights.w;
-    if (totalWeight > 0.0) {
-        float4 weights = in.boneWeights / totalWeight;
-        skin = bones[in.boneIndices.x] * weights.x +
-               bones[in.boneIndices.y] * weights.y +
-               bones[in.boneIndices.z] * weights.z +
-               bones[in.boneIndices.w] * weights.w;
-    }
+    if (totalWeight <= 0.0) {
+        return float4x4(1.0);
+    }
+    const device float4x4* bones = palettes + uint(inst.normalMatrix[3].y);
+    float4 weights = in.boneWeights / totalWeight;
+    return bones[in.boneIndices.x] * weights.x +
+           bones[in.boneIndices.y] * weights.y +
+           bones[in.boneIndices.z] * weights.z +
+           bones[in.boneIndices.w] * weights.w;
+}
 
-    float4 skinnedPos = skin * float4(in.position, 1.0);
-    float4 worldPos = model.modelMatrix * skinnedPos;
+vertex PrepassOut vertex_prepass_skinned_instanced(
+    VertexInSkinned in [[stage_in]],
+    const device InstanceData* instances [[buffer(1)]],
+    constant CameraUniforms& camera [[buffer(2)]],
+    const device float4x4* palettes [[buffer(3)]],
+    uint instanceId [[instance_id]]
+) {
+    PrepassOut out;
+    InstanceData inst = instances[instanceId];
+    float4x4 skin = crowdInstanceSkin(in, inst, palettes);
+    float4 worldPos = inst.modelMatrix * (skin * float4(in.position, 1.0));
     out.position = camera.viewProjectionMatrix * worldPos;
 
     float3x3 skin3 = float3x3(skin[0].xyz, skin[1].xyz, skin[2].xyz);
-    float3 worldNormal = normalize((model.normalMatrix * float4(skin3 * in.normal, 0.0)).xyz);
+    float3 worldNormal = normalize((inst.normalMatrix * float4(skin3 * decodeOctNormal(in.normalOct), 0.0)).xyz);
     out.normalVS = normalize((camera.viewMatrix * float4(worldNormal, 0.0)).xyz);
     out.texCoord = in.texCoord;
     out.lightmapTexCoord = in.texCoord1;
     out.lodFade = 0.0;
+    out.lodDither = inst.normalMatrix[3].x;
     out.billboardFade = 0.0;
     out.billboardFlag = 0.0;
     return out;
 }
 
-vertex VelocityOut vertex_velocity(
+vertex PrepassOut vertex_prepass_vat_instanced(
     VertexIn in [[stage_in]],
-    constant ModelUniforms& model [[buffer(1)]],
+    const device InstanceData* instances [[buffer(1)]],
     constant CameraUniforms& camera [[buffer(2)]],
-    constant MaterialUniforms& material [[buffer(3)]],
-    constant MeshUniforms& mesh [[buffer(4)]],
-    constant VelocityUniforms& velocity [[buffer(5)]]
+    constant VertexAnimationParams& vat [[buffer(5)]],
+    texture2d<float> vatTexture [[texture(0)]],
+    uint vertexId [[vertex_id]],
+    uint instanceId [[instance_id]]
 ) {
-    VelocityOut out;
-    float weight = saturate(in.color.a);
-    float3 worldPos = float3(0.0);
-    float3 prevWorldPos = float3(0.0);
-    if (mesh.flags.x > 0.5 && material.foliageParams2.z > 0.5) {
-        float3 boundsCenter = mesh.boundsCenter.xyz;
-        float3 boundsSize = mesh.boundsSize.xyz;
-        float3 centerWS = (model.modelMatrix * float4(boundsCenter, 1.0)).xyz;
-        float3 prevCenterWS = (velocity.prevModelMatrix * float4(boundsCenter, 1.0)).xyz;
-        float3 windCenter = applyWindOffset(centerWS, weight, material, camera);
-        float3 prevWindCenter = applyWindOffset(prevCenterWS, weight, material, camera);
-        float3 toCam = normalize(camera.cameraPositionTime.xyz - windCenter);
-        float3 prevToCam = normalize(camera.cameraPositionTime.xyz - prevWindCenter);
-        float3 upRef = (abs(toCam.y) < 0.98) ? float3(0.0, 1.0, 0.0) : float3(0.0, 0.0, 1.0);
-        float3 prevUpRef = (abs(prevToCam.y) < 0.98) ? float3(0.0, 1.0, 0.0) : float3(0.0, 0.0, 1.0);
-        float3 right = normalize(cross(upRef, toCam));
-        float3 billUp = normalize(cross(toCam, right));
-        float3 prevRight = normalize(cross(prevUpRef, prevToCam));
-        float3 prevBillUp = normalize(cross(prevToCam, prevRight));
-        float3 axisX = model.modelMatrix[0].xyz;
-        float3 axisY = model.modelMatrix[1].xyz;
-        float3 axisZ = model.modelMatrix[2].xyz;
-        float3 prevAxisX = velocity.prevModelMatrix[0].xyz;
-        float3 prevAxisY = velocity.prevModelMatrix[1].xyz;
-        float3 prevAxisZ = velocity.prevModelMatrix[2].xyz;
-        float uniformScale = max(length(axisX), max(length(axisY), length(axisZ)));
-        float prevUniformScale = max(length(prevAxisX), max(length(prevAxisY), length(prevAxisZ)));
-        float width = max(boundsSize.x, boundsSize.z) * uniformScale;
-        float height = max(boundsSize.y, 0.0001) * uniformScale;
-        float prevWidth = max(boundsSize.x, boundsSize.z) * prevUniformScale;
-        float prevHeight = max(boundsSize.y, 0.0001) * prevUniformScale;
-        float2 quad = float2(in.position.x, in.position.z);
-        worldPos = windCenter + right * (quad.x * width) + billUp * (quad.y * height);
-        prevWorldPos = prevWindCenter + prevRight * (quad.x * prevWidth) + prevBillUp * (quad.y * prevHeight);
-    } else {
-        float4 wp = model.modelMatrix * float4(in.position, 1.0);
-        float4 prevWp = velocity.prevModelMatrix * float4(in.position, 1.0);
-        wp.xyz = applyWindOffset(wp.xyz, weight, material, camera);
-        prevWp.xyz = applyWindOffset(prevWp.xyz, weight, material, camera);
-        worldPos = wp.xyz;
-        prevWorldPos = prevWp.xyz;
-    }
-    float4 currClip = velocity.currViewProjection * float4(worldPos, 1.0);
-    float4 prevClip = velocity.prevViewProjection * float4(prevWorldPos, 1.0);
-    out.position = currClip;
-    out.currClip = currClip;
-    out.prevClip = prevClip;
+    PrepassOut out;
+    InstanceData inst = instances[instanceId];
+    float3 objectPos;
+    float3 objectNormal;
+    vatSample(vatTexture, vat, inst, vertexId, objectPos, objectNormal);
+    out.position = camera.viewProjectionMatrix * (inst.modelMatrix * float4(objectPos, 1.0));
+
+    float3 worldNormal = normalize((inst.normalMatrix * float4(objectNormal, 0.0)).xyz);
+    out.normalVS = normalize((camera.viewMatrix * float4(worldNormal, 0.0)).xyz);
+    out.texCoord = in.texCoord;
+    out.lightmapTexCoord = in.texCoord1;
+    out.lodFade = 0.0;
+    out.lodDither = inst.normalMatrix[3].x;
+    out.billboardFade = 0.0;
+    out.billboardFlag = 0.0;
     return out;
 }
 
-vertex VelocityOut vertex_velocity_skinned(
-    VertexInSkinned in [[stage_in]],
-    constant ModelUniforms& model [[buffer(1)]],
+vertex PrepassOut vertex_prepass_terrain_instanced(
+    VertexIn in [[stage_in]],
+    const device InstanceData* instances [[buffer(1)]],
     constant CameraUniforms& camera [[buffer(2)]],
-    const device float4x4* bones [[buffer(3)]],
-    constant VelocityUniforms& velocity [[buffer(5)]],
-    const device float4x4* prevBones [[buffer(6)]],
-    constant MaterialUniforms& material [[buffer(7)]]
+    constant TerrainParams& terrain [[buffer(5)]],
+    texture2d_array<float, access::read> terrainHeights [[texture(0)]],
+    uint instanceId [[instance_id]]
 ) {
-    VelocityOut out;
-    float4x4 skin = float4x4(1.0);
-    float4x4 skinPrev = float4x4(1.0);
-    float totalWeight = in.boneWeights.x + in.boneWeights.y + in.boneWeights.z + in.boneWeights.w;
-    if (totalWeight > 0.0) {
-        float4 weights = in.boneWeights / totalWeight;
-        skin = bones[in.boneIndices.x] * weights.x +
-               bones[in.boneIndices.y] * weights.y +
-               bones[in.boneIndices.z] * weights.z +
-               bones[in.boneIndices.w] * weights.w;
-        skinPrev = prevBones[in.boneIndices.x] * weights.x +
-                   prevBones[in.boneIndices.y] * weights.y +
-                   prevBones[in.boneIndices.z] * weights.z +
-                   prevBones[in.boneIndices.w] * weights.w;
-    }
-
-    float4 skinnedPos = skin * float4(in.position, 1.0);
-    float4 prevSkinnedPos = skinPrev * float4(in.position, 1.0);
-    float4 worldPos = model.modelMatrix * skinnedPos;
-    float4 prevWorldPos = velocity.prevModelMatrix * prevSkinnedPos;
-    float weight = saturate(in.color.a);
-    worldPos.xyz = applyWindOffset(worldPos.xyz, weight, material, camera);
-    prevWorldPos.xyz = applyWindOffset(prevWorldPos.xyz, weight, material, camera);
-
-    float4 currClip = velocity.currViewProjection * worldPos;
-    float4 prevClip = velocity.prevViewProjection * prevWorldPos;
-    out.position = currClip;
-    out.currClip = currClip;
-    out.prevClip = prevClip;
+    PrepassOut out;
+    TerrainVertex surface = terrainVertex(in.position, instances[instanceId], terrainHeights, terrain, true);
+    out.position = camera.viewProjectionMatrix * float4(surface.worldPosition, 1.0);
+    out.normalVS = normalize((camera.viewMatrix * float4(surface.worldNormal, 0.0)).xyz);
+    out.texCoord = surface.uv;
+    out.lightmapTexCoord = surface.uv;
+    out.lodFade = 0.0;
+    out.lodDither = 0.0;
+    out.billboardFade = 0.0;
+    out.billboardFlag = 0.0;
     return out;
 }
 
@@ -1234,9 +1395,10 @@ vertex VertexOut vertex_main(
         float4 wp = model.modelMatrix * float4(in.position, 1.0);
         wp.xyz = applyWindOffset(wp.xyz, weight, material, camera);
         worldPos = wp.xyz;
-        worldNormal = normalize((model.normalMatrix * float4(in.normal, 0.0)).xyz);
-        tangent = normalize((model.normalMatrix * float4(in.tangent, 0.0)).xyz);
-        bitangent = normalize((model.normalMatrix * float4(in.bitangent, 0.0)).xyz);
+        float3 objectNormal = decodeOctNormal(in.normalOct);
+        worldNormal = normalize((model.normalMatrix * float4(objectNormal, 0.0)).xyz);
+        tangent = normalize((model.normalMatrix * float4(in.tangent.xyz, 0.0)).xyz);
+        bitangent = normalize((model.normalMatrix * float4(decodeBitangent(objectNormal, in.tangent), 0.0)).xyz);
     }
 
     out.worldPosition = worldPos;
@@ -1257,6 +1419,7 @@ vertex VertexOut vertex_main(
     out.lightmapTexCoord = in.texCoord1 * mesh.lightmapScaleOffset.xy + mesh.lightmapScaleOffset.zw;
     out.color = in.color;
     out.lodFade = lodFade;
+    out.lodDither = model.normalMatrix[3].x;
     out.billboardFade = billboardFade;
     out.billboardFlag = mesh.flags.x;
     out.bakedLightingFlag = mesh.flags.y;
@@ -1311,9 +1474,10 @@ vertex VertexOut vertex_main_instanced(
         float4 wp = inst.modelMatrix * float4(in.position, 1.0);
         wp.xyz = applyWindOffset(wp.xyz, weight, material, camera);
         worldPos = wp.xyz;
-        worldNormal = normalize((inst.normalMatrix * float4(in.normal, 0.0)).xyz);
-        tangent = normalize((inst.normalMatrix * float4(in.tangent, 0.0)).xyz);
-        bitangent = normalize((inst.normalMatrix * float4(in.bitangent, 0.0)).xyz);
+        float3 objectNormal = decodeOctNormal(in.normalOct);
+        worldNormal = normalize((inst.normalMatrix * float4(objectNormal, 0.0)).xyz);
+        tangent = normalize((inst.normalMatrix * float4(in.tangent.xyz, 0.0)).xyz);
+        bitangent = normalize((inst.normalMatrix * float4(decodeBitangent(objectNormal, in.tangent), 0.0)).xyz);
     }
 
     out.worldPosition = worldPos;
@@ -1334,6 +1498,7 @@ vertex VertexOut vertex_main_instanced(
     out.lightmapTexCoord = in.texCoord1 * mesh.lightmapScaleOffset.xy + mesh.lightmapScaleOffset.zw;
     out.color = in.color;
     out.lodFade = lodFade;
+    out.lodDither = inst.normalMatrix[3].x;
     out.billboardFade = billboardFade;
     out.billboardFlag = mesh.flags.x;
     out.bakedLightingFlag = mesh.flags.y;
@@ -1367,14 +1532,16 @@ vertex VertexOut vertex_skinned(
 
     float3x3 skin3 = float3x3(skin[0].xyz, skin[1].xyz, skin[2].xyz);
 
-    out.normal = normalize((model.normalMatrix * float4(skin3 * in.normal, 0.0)).xyz);
-    out.tangent = normalize((model.normalMatrix * float4(skin3 * in.tangent, 0.0)).xyz);
-    out.bitangent = normalize((model.normalMatrix * float4(skin3 * in.bitangent, 0.0)).xyz);
+    float3 objectNormal = decodeOctNormal(in.normalOct);
+    out.normal = normalize((model.normalMatrix * float4(skin3 * objectNormal, 0.0)).xyz);
+    out.tangent = normalize((model.normalMatrix * float4(skin3 * in.tangent.xyz, 0.0)).xyz);
+    out.bitangent = normalize((model.normalMatrix * float4(skin3 * decodeBitangent(objectNormal, in.tangent), 0.0)).xyz);
 
     out.texCoord = in.texCoord;
     out.lightmapTexCoord = in.texCoord1;
     out.color = in.color;
     out.lodFade = 0.0;
+    out.lodDither = model.normalMatrix[3].x;
     out.billboardFade = 0.0;
     out.billboardFlag = 0.0;
     out.bakedLightingFlag = 0.0;
@@ -1384,36 +1551,142 @@ vertex VertexOut vertex_skinned(
     return out;
 }
 
-// ============================================================================
-// FRAGMENT SHADER
-// ============================================================================
-
-fragment float4 fragment_prepass(
-    PrepassOut in [[stage_in]],
-    constant MaterialUniforms& material [[buffer(0)]],
-    texture2d<float> roughnessMap [[texture(0)]],
-    texture2d<float> ormMap [[texture(1)]],
-    texture2d<float> albedoMap [[texture(2)]],
-    texture2d<float> terrainControlMap [[texture(3)]],
-    texture2d<float> terrainLayer0Map [[texture(4)]],
-    texture2d<float> terrainLayer1Map [[texture(5)]],
-    texture2d<float> terrainLayer2Map [[texture(6)]],
-    texture2d<float> terrainLayer0OrmMap [[texture(7)]],
-    texture2d<float> terrainLayer1OrmMap [[texture(8)]],
-    texture2d<float> terrainLayer2OrmMap [[texture(9)]],
-    sampler textureSampler [[sampler(0)]]
+vertex VertexOut vertex_skinned_instanced(
+    VertexInSkinned in [[stage_in]],
+    const device InstanceData* instances [[buffer(1)]],
+    constant CameraUniforms& camera [[buffer(2)]],
+    const device float4x4* palettes [[buffer(3)]],
+    uint instanceId [[instance_id]]
 ) {
-    float3 n = normalize(in.normalVS);
-    float2 controlUV = clamp(in.texCoord, float2(0.0), float2(1.0));
-    float2 uv = in.texCoord * material.uvTilingOffset.xy + material.uvTilingOffset.zw;
-    bool terrainEnabled = material.terrainParams0.x > 0.5 &&
-        (material.terrainFlags.y + material.terrainFlags.z + material.terrainFlags.w) > 0.5;
-    float alpha = material.albedo.a;
-    if (terrainEnabled) {
-        float2 uv0 = uv * max(material.terrainLayer0ST.xy, float2(0.001));
-        float2 uv1 = uv * max(material.terrainLayer1ST.xy, float2(0.001));
-        float2 uv2 = uv * max(material.terrainLayer2ST.xy, float2(0.001));
-        float3 weights = float3(1.0, 0.0, 0.0);
+    VertexOut out;
+    InstanceData inst = instances[instanceId];
+    float4x4 skin = crowdInstanceSkin(in, inst, palettes);
+
+    float4 worldPos = inst.modelMatrix * (skin * float4(in.position, 1.0));
+    out.worldPosition = worldPos.xyz;
+    out.position = camera.viewProjectionMatrix * worldPos;
+
+    float3x3 skin3 = float3x3(skin[0].xyz, skin[1].xyz, skin[2].xyz);
+    float3 objectNormal = decodeOctNormal(in.normalOct);
+    out.normal = normalize((inst.normalMatrix * float4(skin3 * objectNormal, 0.0)).xyz);
+    out.tangent = normalize((inst.normalMatrix * float4(skin3 * in.tangent.xyz, 0.0)).xyz);
+    out.bitangent = normalize((inst.normalMatrix * float4(skin3 * decodeBitangent(objectNormal, in.tangent), 0.0)).xyz);
+
+    out.texCoord = in.texCoord;
+    out.lightmapTexCoord = in.texCoord1;
+    out.color = in.color;
+    out.lodFade = 0.0;
+    out.lodDither = inst.normalMatrix[3].x;
+    out.billboardFade = 0.0;
+    out.billboardFlag = 0.0;
+    out.bakedLightingFlag = 0.0;
+    out.staticLightmapFlag = 0.0;
+    out.hdrStaticLightmapFlag = 0.0;
+    return out;
+}
+
+// Instanced playback of a baked vertex animation texture: vertex_main_instanced without wind or
+// billboards, with the position and normal fetched from the clip instead of the vertex stream.
+vertex VertexOut vertex_vat_instanced(
+    VertexIn in [[stage_in]],
+    const device InstanceData* instances [[buffer(1)]],
+    constant CameraUniforms& camera [[buffer(2)]],
+    constant VertexAnimationParams& vat [[buffer(5)]],
+    texture2d<float> vatTexture [[texture(0)]],
+    uint vertexId [[vertex_id]],
+    uint instanceId [[instance_id]]
+) {
+    VertexOut out;
+    InstanceData inst = instances[instanceId];
+    float3 objectPos;
+    float3 objectNormal;
+    vatSample(vatTexture, vat, inst, vertexId, objectPos, objectNormal);
+
+    float4 worldPos = inst.modelMatrix * float4(objectPos, 1.0);
+    out.worldPosition = worldPos.xyz;
+    out.position = camera.viewProjectionMatrix * worldPos;
+
+    // The baked normal replaces the rest pose one, so the rest tangent is re-orthogonalized to it.
+    float3 objectTangent = in.tangent.xyz - objectNormal * dot(objectNormal, in.tangent.xyz);
+    objectTangent = length_squared(objectTangent) > 1e-8 ? normalize(objectTangent) : float3(1.0, 0.0, 0.0);
+    out.normal = normalize((inst.normalMatrix * float4(objectNormal, 0.0)).xyz);
+    out.tangent = normalize((inst.normalMatrix * float4(objectTangent, 0.0)).xyz);
+    out.bitangent = normalize((inst.normalMatrix * float4(decodeBitangent(objectNormal, float4(objectTangent, in.tangent.w)), 0.0)).xyz);
+
+    out.texCoord = in.texCoord;
+    out.lightmapTexCoord = in.texCoord1;
+    out.color = in.color;
+    out.lodFade = 0.0;
+    out.lodDither = inst.normalMatrix[3].x;
+    out.billboardFade = 0.0;
+    out.billboardFlag = 0.0;
+    out.bakedLightingFlag = 0.0;
+    out.staticLightmapFlag = 0.0;
+    out.hdrStaticLightmapFlag = 0.0;
+    return out;
+}
+
+// Terrain patches (TerrainSystem): the grid patch displaced by the height clipmap, with the
+// terrain-wide texCoord the terrain material's control map expects.
+vertex VertexOut vertex_terrain_instanced(
+    VertexIn in [[stage_in]],
+    const device InstanceData* instances [[buffer(1)]],
+    constant CameraUniforms& camera [[buffer(2)]],
+    constant TerrainParams& terrain [[buffer(5)]],
+    texture2d_array<float, access::read> terrainHeights [[texture(0)]],
+    uint instanceId [[instance_id]]
+) {
+    VertexOut out;
+    TerrainVertex surface = terrainVertex(in.position, instances[instanceId], terrainHeights, terrain, true);
+    out.worldPosition = surface.worldPosition;
+    out.position = camera.viewProjectionMatrix * float4(surface.worldPosition, 1.0);
+    out.normal = surface.worldNormal;
+    out.tangent = surface.worldTangent;
+    out.bitangent = normalize(cross(surface.worldTangent, surface.worldNormal));
+
+    out.texCoord = surface.uv;
+    out.lightmapTexCoord = surface.uv;
+    out.color = in.color;
+    out.lodFade = 0.0;
+    out.lodDither = 0.0;
+    out.billboardFade = 0.0;
+    out.billboardFlag = 0.0;
+    out.bakedLightingFlag = 0.0;
+    out.staticLightmapFlag = 0.0;
+    out.hdrStaticLightmapFlag = 0.0;
+    return out;
+}
+
+// ============================================================================
+// FRAGMENT SHADER
+// ============================================================================
+
+// Alpha-tested, dithered normal and roughness of a prepass fragment, for either varyings struct.
+template <typename PrepassVaryings>
+inline float4 prepassNormalRoughness(PrepassVaryings in,
+                                     constant MaterialUniforms& material,
+                                     texture2d<float> roughnessMap,
+                                     texture2d<float> ormMap,
+                                     texture2d<float> albedoMap,
+                                     texture2d<float> terrainControlMap,
+                                     texture2d<float> terrainLayer0Map,
+                                     texture2d<float> terrainLayer1Map,
+                                     texture2d<float> terrainLayer2Map,
+                                     texture2d<float> terrainLayer0OrmMap,
+                                     texture2d<float> terrainLayer1OrmMap,
+                                     texture2d<float> terrainLayer2OrmMap,
+                                     sampler textureSampler) {
+    float3 n = normalize(in.normalVS);
+    float2 controlUV = clamp(in.texCoord, float2(0.0), float2(1.0));
+    float2 uv = in.texCoord * material.uvTilingOffset.xy + material.uvTilingOffset.zw;
+    bool terrainEnabled = material.terrainParams0.x > 0.5 &&
+        (material.terrainFlags.y + material.terrainFlags.z + material.terrainFlags.w) > 0.5;
+    float alpha = material.albedo.a;
+    if (terrainEnabled) {
+        float2 uv0 = uv * max(material.terrainLayer0ST.xy, float2(0.001));
+        float2 uv1 = uv * max(material.terrainLayer1ST.xy, float2(0.001));
+        float2 uv2 = uv * max(material.terrainLayer2ST.xy, float2(0.001));
+        float3 weights = float3(1.0, 0.0, 0.0);
         if (material.terrainFlags.x > 0.5) {
             weights = normalizedTerrainWeights(terrainControlMap.sample(textureSampler, controlUV).rgb, material.terrainParams0.y);
         }
@@ -1443,6 +1716,9 @@ fragment float4 fragment_prepass(
             }
         }
     }
+    if (lodDitherDiscard(in.lodDither, in.position.xy)) {
+        discard_fragment();
+    }
     float roughness = clamp(material.properties.y, 0.04, 1.0);
     if (terrainEnabled) {
         float2 uv0 = uv * max(material.terrainLayer0ST.xy, float2(0.001));
@@ -1466,24 +1742,85 @@ fragment float4 fragment_prepass(
     } else if (material.textureFlags.w > 0.5) {
         roughness = clamp(roughness * roughnessMap.sample(textureSampler, uv).r, 0.04, 1.0);
     }
-    return float4(n * 0.5 + 0.5, roughness);
+    return encodeNormalRoughness(n, roughness);
 }
 
-fragment float4 fragment_velocity(
-    VelocityOut in [[stage_in]]
+fragment float4 fragment_prepass(
+    PrepassOut in [[stage_in]],
+    constant MaterialUniforms& material [[buffer(0)]],
+    texture2d<float> roughnessMap [[texture(0)]],
+    texture2d<float> ormMap [[texture(1)]],
+    texture2d<float> albedoMap [[texture(2)]],
+    texture2d<float> terrainControlMap [[texture(3)]],
+    texture2d<float> terrainLayer0Map [[texture(4)]],
+    texture2d<float> terrainLayer1Map [[texture(5)]],
+    texture2d<float> terrainLayer2Map [[texture(6)]],
+    texture2d<float> terrainLayer0OrmMap [[texture(7)]],
+    texture2d<float> terrainLayer1OrmMap [[texture(8)]],
+    texture2d<float> terrainLayer2OrmMap [[texture(9)]],
+    sampler textureSampler [[sampler(0)]]
 ) {
-    if (in.currClip.w <= 0.0001 || in.prevClip.w <= 0.0001) {
-        return float4(0.0);
+    return prepassNormalRoughness(in, material, roughnessMap, ormMap, albedoMap, terrainControlMap,
+                                  terrainLayer0Map, terrainLayer1Map, terrainLayer2Map,
+                                  terrainLayer0OrmMap, terrainLayer1OrmMap, terrainLayer2OrmMap, textureSampler);
+}
+
+// Writes only the motion the camera does not explain: fragment_velocity_reconstruct adds the
+// camera's part from depth afterwards, for these pixels and the static ones alike.
+fragment PrepassTargets fragment_prepass_motion(
+    PrepassMotionOut in [[stage_in]],
+    constant MaterialUniforms& material [[buffer(0)]],
+    texture2d<float> roughnessMap [[texture(0)]],
+    texture2d<float> ormMap [[texture(1)]],
+    texture2d<float> albedoMap [[texture(2)]],
+    texture2d<float> terrainControlMap [[texture(3)]],
+    texture2d<float> terrainLayer0Map [[texture(4)]],
+    texture2d<float> terrainLayer1Map [[texture(5)]],
+    texture2d<float> terrainLayer2Map [[texture(6)]],
+    texture2d<float> terrainLayer0OrmMap [[texture(7)]],
+    texture2d<float> terrainLayer1OrmMap [[texture(8)]],
+    texture2d<float> terrainLayer2OrmMap [[texture(9)]],
+    sampler textureSampler [[sampler(0)]]
+) {
+    PrepassTargets out;
+    out.normalRoughness = prepassNormalRoughness(in, material, roughnessMap, ormMap, albedoMap, terrainControlMap,
+                                                 terrainLayer0Map, terrainLayer1Map, terrainLayer2Map,
+                                                 terrainLayer0OrmMap, terrainLayer1OrmMap, terrainLayer2OrmMap, textureSampler);
+    out.velocity = float4(0.0);
+    if (in.prevClip.w > 0.0001 && in.cameraPrevClip.w > 0.0001) {
+        out.velocity.xy = clipToUv(in.cameraPrevClip) - clipToUv(in.prevClip);
     }
+    return out;
+}
 
-    float2 currNdc = in.currClip.xy / in.currClip.w;
-    float2 prevNdc = in.prevClip.xy / in.prevClip.w;
-    float2 currUV = float2(currNdc.x * 0.5 + 0.5,
-                           1.0 - (currNdc.y * 0.5 + 0.5));
-    float2 prevUV = float2(prevNdc.x * 0.5 + 0.5,
-                           1.0 - (prevNdc.y * 0.5 + 0.5));
-    float2 velocity = currUV - prevUV;
-    return float4(velocity, 0.0, 1.0);
+// Editor picking (EntityPicker): every covered pixel takes the drawn entity's index + 1.
+fragment uint fragment_pick(
+    PrepassOut in [[stage_in]],
+    constant uint& entityId [[buffer(0)]]
+) {
+    return entityId;
+}
+
+// Camera motion of every covered pixel, reprojected from its depth and added on top of the
+// prepass's object residuals. The sky keeps zero motion.
+fragment float4 fragment_velocity_reconstruct(
+    BlitVertexOut in [[stage_in]],
+    constant VelocityReconstructParams& params [[buffer(0)]],
+    depth2d<float> depthTex [[texture(0)]]
+) {
+    float depth = depthTex.read(uint2(in.position.xy));
+    if (depth >= 1.0) {
+        return float4(0.0);
+    }
+    float2 uv = in.position.xy * params.texelSize.xy;
+    float4 world = params.inverseViewProjection * float4(uvToNdc(uv), depth, 1.0);
+    world /= world.w;
+    float4 currClip = params.currViewProjection * world;
+    float4 prevClip = params.prevViewProjection * world;
+    if (currClip.w <= 0.0001 || prevClip.w <= 0.0001) {
+        return float4(0.0);
+    }
+    return float4(clipToUv(currClip) - clipToUv(prevClip), 0.0, 0.0);
 }
 
 // ========================================================================
@@ -1527,43 +1864,158 @@ kernel void hzb_downsample(texture2d<float, access::read> srcTex [[texture(0)]],
     dstTex.write(maxDepth, gid);
 }
 
-kernel void instance_cull(const device InstanceData* inInstances [[buffer(0)]],
-                          device InstanceData* outInstances [[buffer(1)]],
-                          device atomic_uint* counters [[buffer(2)]],
-                          constant InstanceCullParams& params [[buffer(3)]],
-                          uint tid [[thread_position_in_grid]]) {
-    if (tid >= params.instanceCount) {
-        return;
+// Single-dispatch HZB build in the manner of AMD's SPD. Each 256-thread group reduces a 64x64
+// tile of depth into mips 0-6 through threadgroup memory and leaves its mip 6 texel in spdState;
+// the last group to finish, found through the atomic counter in spdState[0], reduces those into
+// the remaining mips and resets the counter. Covers depth up to 4096 texels a side.
+#define HZB_SPD_MAX_MIPS 15
+#define HZB_SPD_GROUP 16
+
+struct HZBSpdParams {
+    uint mipCount;
+    uint groupCount;
+    uint pad0;
+    uint pad1;
+};
+
+static inline float hzbSpdReduce(threadgroup float* reduced, uint2 lid, uint size) {
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    float value = 0.0;
+    if (lid.x < size && lid.y < size) {
+        uint2 s = lid * 2;
+        value = max(max(reduced[s.y * HZB_SPD_GROUP + s.x], reduced[s.y * HZB_SPD_GROUP + s.x + 1]),
+                    max(reduced[(s.y + 1) * HZB_SPD_GROUP + s.x], reduced[(s.y + 1) * HZB_SPD_GROUP + s.x + 1]));
     }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    if (lid.x < size && lid.y < size) {
+        reduced[lid.y * HZB_SPD_GROUP + lid.x] = value;
+    }
+    return value;
+}
 
-    InstanceData inst = inInstances[params.inputOffset + tid];
-    float3 worldCenter = (inst.modelMatrix * float4(params.boundsCenterRadius.xyz, 1.0)).xyz;
+static inline void hzbSpdWrite(texture2d<float, access::write> mip, float value, uint2 coord) {
+    if (coord.x < mip.get_width() && coord.y < mip.get_height()) {
+        mip.write(value, coord);
+    }
+}
 
-    float3 axisX = inst.modelMatrix[0].xyz;
-    float3 axisY = inst.modelMatrix[1].xyz;
-    float3 axisZ = inst.modelMatrix[2].xyz;
-    float maxScale = max(length(axisX), max(length(axisY), length(axisZ)));
-    float radius = params.boundsCenterRadius.w * maxScale;
+kernel void hzb_spd(depth2d<float, access::sample> depthTex [[texture(0)]],
+                    array<texture2d<float, access::write>, HZB_SPD_MAX_MIPS> mips [[texture(1)]],
+                    constant HZBSpdParams& params [[buffer(0)]],
+                    device atomic_uint* spdState [[buffer(1)]],
+                    sampler depthSampler [[sampler(0)]],
+                    uint2 groupId [[threadgroup_position_in_grid]],
+                    uint2 groups [[threadgroups_per_grid]],
+                    uint2 lid [[thread_position_in_threadgroup]]) {
+    threadgroup float reduced[HZB_SPD_GROUP * HZB_SPD_GROUP];
+    threadgroup bool lastGroup;
+
+    // Mips 0-2: each thread reduces a 4x4 block of depth on its own.
+    uint2 mip0Size = uint2(mips[0].get_width(), mips[0].get_height());
+    float2 invMip0Size = 1.0 / float2(mip0Size);
+    float m2 = 0.0;
+    for (uint by = 0; by < 2; ++by) {
+        for (uint bx = 0; bx < 2; ++bx) {
+            float m1 = 0.0;
+            for (uint y = 0; y < 2; ++y) {
+                for (uint x = 0; x < 2; ++x) {
+                    uint2 p = groupId * 64 + lid * 4 + uint2(bx * 2 + x, by * 2 + y);
+                    if (p.x >= mip0Size.x || p.y >= mip0Size.y) {
+                        continue;
+                    }
+                    float depth = depthTex.sample(depthSampler, (float2(p) + 0.5) * invMip0Size);
+                    mips[0].write(depth, p);
+                    m1 = max(m1, depth);
+                }
+            }
+            if (params.mipCount > 1) {
+                hzbSpdWrite(mips[1], m1, groupId * 32 + lid * 2 + uint2(bx, by));
+            }
+            m2 = max(m2, m1);
+        }
+    }
+    if (params.mipCount > 2) {
+        hzbSpdWrite(mips[2], m2, groupId * HZB_SPD_GROUP + lid);
+    }
+    reduced[lid.y * HZB_SPD_GROUP + lid.x] = m2;
 
-    for (uint i = 0; i < 6; ++i) {
-        float4 p = params.frustumPlanes[i];
-        float d = dot(p, float4(worldCenter, 1.0));
-        if (d < -radius) {
-            return;
+    // Mips 3-6 through threadgroup memory.
+    uint size = HZB_SPD_GROUP / 2;
+    for (uint mip = 3; mip <= 6; ++mip, size /= 2) {
+        float value = hzbSpdReduce(reduced, lid, size);
+        if (lid.x < size && lid.y < size && mip < params.mipCount) {
+            hzbSpdWrite(mips[mip], value, groupId * size + lid);
         }
     }
 
-    uint idx = atomic_fetch_add_explicit(&counters[0], 1, memory_order_relaxed);
-    outInstances[params.outputOffset + idx] = inst;
+    if (all(lid == uint2(0))) {
+        uint groupIndex = groupId.y * groups.x + groupId.x;
+        atomic_store_explicit(&spdState[1 + groupIndex], as_type<uint>(reduced[0]), memory_order_relaxed);
+        uint finished = atomic_fetch_add_explicit(&spdState[0], 1u, memory_order_relaxed);
+        lastGroup = finished + 1 == params.groupCount;
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    if (!lastGroup) {
+        return;
+    }
+    if (all(lid == uint2(0))) {
+        atomic_store_explicit(&spdState[0], 0u, memory_order_relaxed);
+    }
+    if (params.mipCount <= 7) {
+        return;
+    }
+
+    // Mips 7-12 from the mip 6 texels of every group.
+    float m8 = 0.0;
+    for (uint by = 0; by < 2; ++by) {
+        for (uint bx = 0; bx < 2; ++bx) {
+            float m7 = 0.0;
+            for (uint y = 0; y < 2; ++y) {
+                for (uint x = 0; x < 2; ++x) {
+                    uint2 p = lid * 4 + uint2(bx * 2 + x, by * 2 + y);
+                    if (p.x >= groups.x || p.y >= groups.y) {
+                        continue;
+                    }
+                    uint bits = atomic_load_explicit(&spdState[1 + p.y * groups.x + p.x], memory_order_relaxed);
+                    m7 = max(m7, as_type<float>(bits));
+                }
+            }
+            hzbSpdWrite(mips[7], m7, lid * 2 + uint2(bx, by));
+            m8 = max(m8, m7);
+        }
+    }
+    if (params.mipCount > 8) {
+        hzbSpdWrite(mips[8], m8, lid);
+    }
+    reduced[lid.y * HZB_SPD_GROUP + lid.x] = m8;
+
+    size = HZB_SPD_GROUP / 2;
+    for (uint mip = 9; mip <= 12; ++mip, size /= 2) {
+        float value = hzbSpdReduce(reduced, lid, size);
+        if (lid.x < size && lid.y < size && mip < params.mipCount) {
+            hzbSpdWrite(mips[mip], value, lid);
+        }
+    }
 }
 
-kernel void instance_cull_hzb(const device InstanceData* inInstances [[buffer(0)]],
-                              device InstanceData* outInstances [[buffer(1)]],
-                              device atomic_uint* counters [[buffer(2)]],
-                              constant InstanceCullParams& params [[buffer(3)]],
-                              constant CameraUniforms& camera [[buffer(4)]],
-                              texture2d<float, access::read> hzbTex [[texture(0)]],
-                              uint tid [[thread_position_in_grid]]) {
+// Zero matrices mark empty records of GPU-filled inputs (foliage tiles). A distance range keeps
+// one LOD of a batch whose instances switch between the mesh and its billboard on the GPU.
+inline bool instanceCullKeep(float3 worldCenter, float maxScale, constant InstanceCullParams& params) {
+    if (maxScale <= 0.0) {
+        return false;
+    }
+    if (params.lodMaxDistance > 0.0) {
+        float dist = distance(worldCenter, params.lodCamera.xyz);
+        return dist >= params.lodCamera.w && dist <= params.lodMaxDistance;
+    }
+    return true;
+}
+
+kernel void instance_cull(const device InstanceData* inInstances [[buffer(0)]],
+                          device InstanceData* outInstances [[buffer(1)]],
+                          device atomic_uint* counters [[buffer(2)]],
+                          constant InstanceCullParams& params [[buffer(3)]],
+                          uint tid [[thread_position_in_grid]]) {
     if (tid >= params.instanceCount) {
         return;
     }
@@ -1576,6 +2028,9 @@ kernel void instance_cull_hzb(const device InstanceData* inInstances [[buffer(0)
     float3 axisZ = inst.modelMatrix[2].xyz;
     float maxScale = max(length(axisX), max(length(axisY), length(axisZ)));
     float radius = params.boundsCenterRadius.w * maxScale;
+    if (!instanceCullKeep(worldCenter, maxScale, params)) {
+        return;
+    }
 
     for (uint i = 0; i < 6; ++i) {
         float4 p = params.frustumPlanes[i];
@@ -1585,17 +2040,27 @@ kernel void instance_cull_hzb(const device InstanceData* inInstances [[buffer(0)
         }
     }
 
+    uint idx = atomic_fetch_add_explicit(&counters[0], 1, memory_order_relaxed);
+    outInstances[params.outputOffset + idx] = inst;
+}
+
+// Conservative HZB test for a world-space sphere that already passed the frustum test.
+// Spheres whose center projects off screen are kept.
+inline bool hzbSphereVisible(float3 worldCenter,
+                             float radius,
+                             constant CameraUniforms& camera,
+                             texture2d<float, access::read> hzbTex,
+                             float2 screenSize,
+                             uint hzbMipCount) {
     float4 clipCenter = camera.viewProjectionMatrix * float4(worldCenter, 1.0);
     if (clipCenter.w <= 0.0001) {
-        return;
+        return false;
     }
 
     float3 ndc = clipCenter.xyz / clipCenter.w;
     float2 uv = float2(ndc.x * 0.5 + 0.5, 1.0 - (ndc.y * 0.5 + 0.5));
     if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) {
-        uint idx = atomic_fetch_add_explicit(&counters[0], 1, memory_order_relaxed);
-        outInstances[params.outputOffset + idx] = inst;
-        return;
+        return true;
     }
 
     float3 viewPos = (camera.viewMatrix * float4(worldCenter, 1.0)).xyz;
@@ -1606,12 +2071,12 @@ kernel void instance_cull_hzb(const device InstanceData* inInstances [[buffer(0)
 
     float2 projScale = float2(camera.projectionMatrix[0][0], camera.projectionMatrix[1][1]);
     float2 ndcRadius = abs((radius / viewZ) * projScale);
-    float2 uvRadius = ndcRadius * 0.5 + float2(1.5) / max(params.screenSize, float2(1.0));
+    float2 uvRadius = ndcRadius * 0.5 + float2(1.5) / max(screenSize, float2(1.0));
     float2 uvMin = clamp(uv - uvRadius, float2(0.0), float2(1.0));
     float2 uvMax = clamp(uv + uvRadius, float2(0.0), float2(1.0));
-    float2 rectPixels = max((uvMax - uvMin) * params.screenSize, float2(1.0));
+    float2 rectPixels = max((uvMax - uvMin) * screenSize, float2(1.0));
     float rectExtent = max(rectPixels.x, rectPixels.y);
-    float lod = clamp(floor(log2(max(rectExtent, 1.0))), 0.0, float(max(params.hzbMipCount, 1u) - 1));
+    float lod = clamp(floor(log2(max(rectExtent, 1.0))), 0.0, float(max(hzbMipCount, 1u) - 1));
     uint mipLevel = uint(lod);
 
     uint mipWidth = max(1u, hzbTex.get_width(mipLevel));
@@ -1627,7 +2092,41 @@ kernel void instance_cull_hzb(const device InstanceData* inInstances [[buffer(0)
     hzbDepth = max(hzbDepth, hzbTex.read(uint2(texelMax.x, texelMax.y), mipLevel).r);
 
     float kDepthBias = 0.0015 + float(mipLevel) * 0.00075;
-    if (depthNear > hzbDepth + kDepthBias) {
+    return depthNear <= hzbDepth + kDepthBias;
+}
+
+kernel void instance_cull_hzb(const device InstanceData* inInstances [[buffer(0)]],
+                              device InstanceData* outInstances [[buffer(1)]],
+                              device atomic_uint* counters [[buffer(2)]],
+                              constant InstanceCullParams& params [[buffer(3)]],
+                              constant CameraUniforms& camera [[buffer(4)]],
+                              texture2d<float, access::read> hzbTex [[texture(0)]],
+                              uint tid [[thread_position_in_grid]]) {
+    if (tid >= params.instanceCount) {
+        return;
+    }
+
+    InstanceData inst = inInstances[params.inputOffset + tid];
+    float3 worldCenter = (inst.modelMatrix * float4(params.boundsCenterRadius.xyz, 1.0)).xyz;
+
+    float3 axisX = inst.modelMatrix[0].xyz;
+    float3 axisY = inst.modelMatrix[1].xyz;
+    float3 axisZ = inst.modelMatrix[2].xyz;
+    float maxScale = max(length(axisX), max(length(axisY), length(axisZ)));
+    float radius = params.boundsCenterRadius.w * maxScale;
+    if (!instanceCullKeep(worldCenter, maxScale, params)) {
+        return;
+    }
+
+    for (uint i = 0; i < 6; ++i) {
+        float4 p = params.frustumPlanes[i];
+        float d = dot(p, float4(worldCenter, 1.0));
+        if (d < -radius) {
+            return;
+        }
+    }
+
+    if (!hzbSphereVisible(worldCenter, radius, camera, hzbTex, params.screenSize, params.hzbMipCount)) {
         return;
     }
 
@@ -1642,131 +2141,1082 @@ kernel void instance_build_indirect(const device atomic_uint* counters [[buffer(
     args[gid].instanceCount = count;
 }
 
-fragment float4 ssao_fragment(
-    BlitVertexOut in [[stage_in]],
+// Tests every occlusion candidate against the HZB of the first prepass phase. Spheres crossing
+// the camera plane are kept, since hzbSphereVisible projects the center. counters[0] / [1] tally
+// the visible and occluded candidates for RenderStats.
+kernel void occlusion_cull(const device float4* spheres [[buffer(0)]],
+                           device uint* visibility [[buffer(1)]],
+                           device atomic_uint* counters [[buffer(2)]],
+                           constant OcclusionCullParams& params [[buffer(3)]],
+                           constant CameraUniforms& camera [[buffer(4)]],
+                           texture2d<float, access::read> hzbTex [[texture(0)]],
+                           uint tid [[thread_position_in_grid]]) {
+    if (tid >= params.candidateCount) {
+        return;
+    }
+
+    float4 sphere = spheres[tid];
+    if (sphere.w <= 0.0) {
+        visibility[tid] = 0;
+        return;
+    }
+
+    float viewZ = -(camera.viewMatrix * float4(sphere.xyz, 1.0)).z;
+    bool visible = viewZ <= sphere.w
+        || hzbSphereVisible(sphere.xyz, sphere.w, camera, hzbTex, params.screenSize, params.hzbMipCount);
+    visibility[tid] = visible ? 1u : 0u;
+    atomic_fetch_add_explicit(&counters[visible ? 0 : 1], 1, memory_order_relaxed);
+}
+
+// Non-indexed decal args share the slot layout; instanceCount sits at the same offset in both.
+kernel void occlusion_write_args(const device uint* visibility [[buffer(0)]],
+                                 const device uint* argCandidates [[buffer(1)]],
+                                 device DrawIndexedIndirectArgs* args [[buffer(2)]],
+                                 constant OcclusionCullParams& params [[buffer(3)]],
+                                 uint tid [[thread_position_in_grid]]) {
+    if (tid >= params.argCount) {
+        return;
+    }
+    uint arg = params.argOffset + tid;
+    args[arg].instanceCount = visibility[argCandidates[arg]];
+}
+
+// Compute skinning cache (SkinningCache.cpp): skins a mesh once per frame into streams with the
+// static layout (float3 positions + PackedVertexData) plus last frame's positions, so every pass
+// can draw the result through its static pipeline.
+struct SkinWeightData {
+    uint4 indices;
+    float4 weights;
+};
+
+kernel void skin_vertices(const device packed_float3* positions [[buffer(0)]],
+                          const device PackedVertexData* attributes [[buffer(1)]],
+                          const device SkinWeightData* skinWeights [[buffer(2)]],
+                          const device float4x4* bones [[buffer(3)]],
+                          const device float4x4* prevBones [[buffer(4)]],
+                          device packed_float3* outPositions [[buffer(5)]],
+                          device PackedVertexData* outAttributes [[buffer(6)]],
+                          device packed_float3* outPrevPositions [[buffer(7)]],
+                          constant SkinningParams& params [[buffer(8)]],
+                          uint vid [[thread_position_in_grid]]) {
+    if (vid >= params.vertexCount) {
+        return;
+    }
+
+    SkinWeightData sw = skinWeights[vid];
+    float4x4 skin = float4x4(1.0);
+    float4x4 skinPrev = float4x4(1.0);
+    float totalWeight = sw.weights.x + sw.weights.y + sw.weights.z + sw.weights.w;
+    if (totalWeight > 0.0) {
+        float4 weights = sw.weights / totalWeight;
+        skin = bones[sw.indices.x] * weights.x +
+               bones[sw.indices.y] * weights.y +
+               bones[sw.indices.z] * weights.z +
+               bones[sw.indices.w] * weights.w;
+        skinPrev = prevBones[sw.indices.x] * weights.x +
+                   prevBones[sw.indices.y] * weights.y +
+                   prevBones[sw.indices.z] * weights.z +
+                   prevBones[sw.indices.w] * weights.w;
+    }
+
+    float3 position = float3(positions[vid]);
+    outPositions[vid] = packed_float3((skin * float4(position, 1.0)).xyz);
+    outPrevPositions[vid] = packed_float3((skinPrev * float4(position, 1.0)).xyz);
+
+    PackedVertexData packed = attributes[vid];
+    float3x3 skin3 = float3x3(skin[0].xyz, skin[1].xyz, skin[2].xyz);
+    float3 normal = normalize(skin3 * decodeOctNormal(decodePackedNormal(packed.normal)));
+    float4 tangent = decodePackedTangent(packed.tangent);
+    float3 skinnedTangent = skin3 * tangent.xyz;
+    tangent.xyz = length_squared(skinnedTangent) > 1e-12 ? normalize(skinnedTangent) : tangent.xyz;
+    packed.normal = encodePackedNormal(normal);
+    packed.tangent = encodePackedTangent(tangent);
+    outAttributes[vid] = packed;
+}
+
+// GPU crowd animation (CrowdAnimation.cpp): samples each instance's compressed clips, cross-fades
+// them and writes its skin matrices to the palette the instanced skinned vertex functions read.
+// The library holds skeletons (a header then the bones) and clips (a track table per skeleton bone,
+// then the keys); every offset is in bytes from its start.
+#define CROWD_NO_CLIP 0xFFFFFFFFu
+
+struct CrowdSkeletonHeader {
+    float4x4 globalInverse;
+    uint boneCount;
+    uint3 _pad;
+};
+
+struct CrowdBone {
+    float4x4 inverseBind;
+    float4 bindPosition;
+    float4 bindRotation;
+    float4 bindScale;
+    int4 parent;
+};
+
+// x frames offset, y values offset, z key count (0 keeps the bind pose).
+struct CrowdTrack {
+    uint4 position;
+    uint4 rotation;
+    uint4 scale;
+    float4 positionMin;
+    float4 positionExtent;
+    float4 scaleMin;
+    float4 scaleExtent;
+};
+
+struct CrowdInstanceData {
+    uint skeleton;
+    uint clip;
+    uint previousClip;
+    uint palette;
+    float frame;
+    float previousFrame;
+    float fade;
+    uint _pad;
+};
+
+// Last kept frame at or before the given one and the blend to the next (FindFrameKey on the CPU).
+inline uint crowdFindKey(const device ushort* frames, uint count, float frame, thread float& blend) {
+    blend = 0.0;
+    if (count <= 1 || frame <= float(frames[0])) {
+        return 0;
+    }
+    if (frame >= float(frames[count - 1])) {
+        return count - 1;
+    }
+    if (uint(frames[count - 1]) + 1 == count) {
+        uint index = uint(frame);
+        blend = frame - float(index);
+        return index;
+    }
+    uint lo = 0;
+    uint hi = count - 1;
+    while (hi - lo > 1) {
+        uint mid = (lo + hi) >> 1;
+        if (float(frames[mid]) <= frame) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    blend = (frame - float(frames[lo])) / float(frames[lo + 1] - frames[lo]);
+    return lo;
+}
+
+inline float3 crowdDecodeVector(const device ushort* values, uint key, float4 rangeMin, float4 rangeExtent) {
+    float3 unit = float3(values[key * 3], values[key * 3 + 1], values[key * 3 + 2]) / 65535.0;
+    return rangeMin.xyz + rangeExtent.xyz * unit;
+}
+
+// Smallest-three rotation: the dropped component's index in two bits, the others in 20 bits each.
+inline float4 crowdDecodeRotation(uint2 bits) {
+    const float scale = 1.0 / 1048575.0;
+    const float range = 0.70710678;
+    uint largest = bits.x & 3u;
+    float3 small = float3(float((bits.x >> 2) & 0xFFFFFu),
+                          float(((bits.x >> 22) | (bits.y << 10)) & 0xFFFFFu),
+                          float((bits.y >> 10) & 0xFFFFFu));
+    small = (small * scale * 2.0 - 1.0) * range;
+    float dropped = sqrt(max(0.0, 1.0 - dot(small, small)));
+    float4 q;
+    uint next = 0;
+    for (uint i = 0; i < 4; ++i) {
+        q[i] = (i == largest) ? dropped : small[next];
+        next += (i == largest) ? 0 : 1;
+    }
+    return q;
+}
+
+// Normalized lerp through the shorter arc; close enough to slerp for neighbouring keys and fades.
+inline float4 crowdBlendRotation(float4 a, float4 b, float t) {
+    b = dot(a, b) < 0.0 ? -b : b;
+    return normalize(mix(a, b, t));
+}
+
+inline float3 crowdSampleVector(const device uchar* library, uint4 track, float4 rangeMin, float4 rangeExtent,
+                                float frame, float3 fallback) {
+    if (track.z == 0) {
+        return fallback;
+    }
+    const device ushort* frames = (const device ushort*)(library + track.x);
+    const device ushort* values = (const device ushort*)(library + track.y);
+    float blend;
+    uint key = crowdFindKey(frames, track.z, frame, blend);
+    float3 value = crowdDecodeVector(values, key, rangeMin, rangeExtent);
+    if (blend > 0.0) {
+        value = mix(value, crowdDecodeVector(values, key + 1, rangeMin, rangeExtent), blend);
+    }
+    return value;
+}
+
+inline float4 crowdSampleRotation(const device uchar* library, uint4 track, float frame, float4 fallback) {
+    if (track.z == 0) {
+        return fallback;
+    }
+    const device ushort* frames = (const device ushort*)(library + track.x);
+    const device uint2* values = (const device uint2*)(library + track.y);
+    float blend;
+    uint key = crowdFindKey(frames, track.z, frame, blend);
+    float4 value = crowdDecodeRotation(values[key]);
+    if (blend > 0.0) {
+        value = crowdBlendRotation(value, crowdDecodeRotation(values[key + 1]), blend);
+    }
+    return value;
+}
+
+inline void crowdSampleBone(const device uchar* library, uint clip, uint bone, float frame, CrowdBone bind,
+                            thread float3& position, thread float4& rotation, thread float3& scale) {
+    position = bind.bindPosition.xyz;
+    rotation = bind.bindRotation;
+    scale = bind.bindScale.xyz;
+    if (clip == CROWD_NO_CLIP) {
+        return;
+    }
+    CrowdTrack track = ((const device CrowdTrack*)(library + clip))[bone];
+    position = crowdSampleVector(library, track.position, track.positionMin, track.positionExtent, frame, position);
+    rotation = crowdSampleRotation(library, track.rotation, frame, rotation);
+    scale = crowdSampleVector(library, track.scale, track.scaleMin, track.scaleExtent, frame, scale);
+}
+
+inline float4x4 crowdTRS(float3 t, float4 q, float3 s) {
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    return float4x4(float4((1.0 - 2.0 * (yy + zz)) * s.x, 2.0 * (xy + wz) * s.x, 2.0 * (xz - wy) * s.x, 0.0),
+                    float4(2.0 * (xy - wz) * s.y, (1.0 - 2.0 * (xx + zz)) * s.y, 2.0 * (yz + wx) * s.y, 0.0),
+                    float4(2.0 * (xz + wy) * s.z, 2.0 * (yz - wx) * s.z, (1.0 - 2.0 * (xx + yy)) * s.z, 0.0),
+                    float4(t, 1.0));
+}
+
+// One thread per instance. As in BuildSkinMatrices, the globals are built in the palette (bones
+// come parents first) and turned into skin matrices in place.
+kernel void crowd_sample_pose(const device uchar* library [[buffer(0)]],
+                              const device CrowdInstanceData* instances [[buffer(1)]],
+                              device float4x4* palettes [[buffer(2)]],
+                              constant uint& instanceCount [[buffer(3)]],
+                              uint tid [[thread_position_in_grid]]) {
+    if (tid >= instanceCount) {
+        return;
+    }
+    CrowdInstanceData inst = instances[tid];
+    const device CrowdSkeletonHeader* header = (const device CrowdSkeletonHeader*)(library + inst.skeleton);
+    const device CrowdBone* bones = (const device CrowdBone*)(library + inst.skeleton + sizeof(CrowdSkeletonHeader));
+    device float4x4* palette = palettes + inst.palette;
+    uint boneCount = header->boneCount;
+    bool fading = inst.previousClip != CROWD_NO_CLIP && inst.fade < 1.0;
+
+    for (uint b = 0; b < boneCount; ++b) {
+        CrowdBone bone = bones[b];
+        float3 position;
+        float4 rotation;
+        float3 scale;
+        crowdSampleBone(library, inst.clip, b, inst.frame, bone, position, rotation, scale);
+        if (fading) {
+            float3 fromPosition;
+            float4 fromRotation;
+            float3 fromScale;
+            crowdSampleBone(library, inst.previousClip, b, inst.previousFrame, bone, fromPosition, fromRotation, fromScale);
+            position = mix(fromPosition, position, inst.fade);
+            rotation = crowdBlendRotation(fromRotation, rotation, inst.fade);
+            scale = mix(fromScale, scale, inst.fade);
+        }
+        float4x4 local = crowdTRS(position, rotation, scale);
+        int parent = bone.parent.x;
+        palette[b] = parent >= 0 ? palette[parent] * local : local;
+    }
+    float4x4 globalInverse = header->globalInverse;
+    for (uint b = 0; b < boneCount; ++b) {
+        palette[b] = globalInverse * (palette[b] * bones[b].inverseBind);
+    }
+}
+
+struct StaticICBArguments {
+    command_buffer mainCommands;
+    command_buffer prepassCommands;
+};
+
+// Frustum-tests static instance tid against its batch bounds; on success returns the world
+// sphere so the HZB variant can test it further.
+inline bool staticInstanceInFrustum(const device InstanceData* inInstances,
+                                    const device uint* instanceBatches,
+                                    const device StaticBatchData* batches,
+                                    constant StaticCullParams& params,
+                                    uint tid,
+                                    thread uint& batchIndex,
+                                    thread float3& worldCenter,
+                                    thread float& radius) {
+    if (tid >= params.instanceCount) {
+        return false;
+    }
+
+    batchIndex = instanceBatches[tid];
+    float4 boundsCenterRadius = batches[batchIndex].boundsCenterRadius;
+    float4x4 model = inInstances[tid].modelMatrix;
+    worldCenter = (model * float4(boundsCenterRadius.xyz, 1.0)).xyz;
+
+    float maxScale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+    radius = boundsCenterRadius.w * maxScale;
+
+    for (uint i = 0; i < 6; ++i) {
+        float4 p = params.frustumPlanes[i];
+        float d = dot(p, float4(worldCenter, 1.0));
+        if (d < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#define LOD_FADE_BAND 1.5
+
+// Appends a visible static instance to the batch of the LOD it selects (Mesh::selectLod). While
+// the next coarser level fades in, that level gets the instance too, with the complementary
+// dither in normalMatrix[3].x.
+inline void appendStaticInstance(const device InstanceData* inInstances,
+                                 const device StaticBatchData* batches,
+                                 device InstanceData* outInstances,
+                                 device atomic_uint* counters,
+                                 constant StaticCullParams& params,
+                                 uint tid,
+                                 uint batchIndex,
+                                 float3 worldCenter) {
+    const device StaticBatchData& batch = batches[batchIndex];
+    InstanceData inst = inInstances[tid];
+    uint lod = 0;
+    float fade = 0.0;
+    if (batch.lodCount > 1 && params.lodView.w > 0.0) {
+        float4x4 model = inst.modelMatrix;
+        float maxScale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+        float dist = max(distance(params.lodView.xyz, worldCenter), 1e-3);
+        float pixelsPerUnit = params.lodView.w * maxScale / dist;
+        for (uint l = 1; l < batch.lodCount; ++l) {
+            if (batch.lodErrors[l - 1] * pixelsPerUnit > params.lodPixelError) {
+                break;
+            }
+            lod = l;
+        }
+        if (lod + 1 < batch.lodCount) {
+            float next = batch.lodErrors[lod] * pixelsPerUnit;
+            float fadeStart = params.lodPixelError * LOD_FADE_BAND;
+            if (next < fadeStart) {
+                fade = saturate((fadeStart - next) / (fadeStart - params.lodPixelError));
+            }
+        }
+    }
+
+    if (fade > 0.0) {
+        float keep = max(1.0 - fade, 1e-3);
+        InstanceData coarse = inst;
+        coarse.normalMatrix[3].x = -keep;
+        uint coarseIdx = atomic_fetch_add_explicit(&counters[batchIndex + lod + 1], 1, memory_order_relaxed);
+        outInstances[batches[batchIndex + lod + 1].outputOffset + coarseIdx] = coarse;
+        inst.normalMatrix[3].x = keep;
+    }
+    uint idx = atomic_fetch_add_explicit(&counters[batchIndex + lod], 1, memory_order_relaxed);
+    outInstances[batches[batchIndex + lod].outputOffset + idx] = inst;
+}
+
+// Culls every static instance in one dispatch; survivors are compacted per batch and LOD.
+kernel void static_instance_cull(const device InstanceData* inInstances [[buffer(0)]],
+                                 const device uint* instanceBatches [[buffer(1)]],
+                                 const device StaticBatchData* batches [[buffer(2)]],
+                                 device InstanceData* outInstances [[buffer(3)]],
+                                 device atomic_uint* counters [[buffer(4)]],
+                                 constant StaticCullParams& params [[buffer(5)]],
+                                 uint tid [[thread_position_in_grid]]) {
+    uint batchIndex = 0;
+    float3 worldCenter;
+    float radius;
+    if (!staticInstanceInFrustum(inInstances, instanceBatches, batches, params, tid, batchIndex, worldCenter, radius)) {
+        return;
+    }
+
+    appendStaticInstance(inInstances, batches, outInstances, counters, params, tid, batchIndex, worldCenter);
+}
+
+kernel void static_instance_cull_hzb(const device InstanceData* inInstances [[buffer(0)]],
+                                     const device uint* instanceBatches [[buffer(1)]],
+                                     const device StaticBatchData* batches [[buffer(2)]],
+                                     device InstanceData* outInstances [[buffer(3)]],
+                                     device atomic_uint* counters [[buffer(4)]],
+                                     constant StaticCullParams& params [[buffer(5)]],
+                                     constant CameraUniforms& camera [[buffer(6)]],
+                                     texture2d<float, access::read> hzbTex [[texture(0)]],
+                                     uint tid [[thread_position_in_grid]]) {
+    uint batchIndex = 0;
+    float3 worldCenter;
+    float radius;
+    if (!staticInstanceInFrustum(inInstances, instanceBatches, batches, params, tid, batchIndex, worldCenter, radius)) {
+        return;
+    }
+    if (!hzbSphereVisible(worldCenter, radius, camera, hzbTex, params.screenSize, params.hzbMipCount)) {
+        return;
+    }
+
+    appendStaticInstance(inInstances, batches, outInstances, counters, params, tid, batchIndex, worldCenter);
+}
+
+inline void encodeStaticDraw(render_command cmd,
+                             const device StaticBatchData& batch,
+                             constant StaticFrameBindings& frame,
+                             uint instanceCount,
+                             bool prepass) {
+    // The whole culled array is bound and the batch's slots start at the base instance, so
+    // instance_id is the instance's culled slot, which the visibility buffer records.
+    cmd.set_vertex_buffer(batch.vertices, 0);
+    cmd.set_vertex_buffer(frame.culledInstances, 1);
+    cmd.set_vertex_buffer(frame.camera, 2);
+    cmd.set_vertex_buffer(batch.material, 3);
+    cmd.set_vertex_buffer(batch.mesh, 4);
+    cmd.set_vertex_buffer(batch.attributes, 8);
+    if (prepass) {
+        cmd.set_fragment_buffer(batch.material, 0);
+    } else {
+        cmd.set_fragment_buffer(frame.camera, 0);
+        cmd.set_fragment_buffer(batch.material, 1);
+        cmd.set_fragment_buffer(frame.light, 2);
+        cmd.set_fragment_buffer(frame.environment, 3);
+        cmd.set_fragment_buffer(frame.lights, 4);
+        cmd.set_fragment_buffer(frame.shadows, 5);
+        cmd.set_fragment_buffer(frame.lightCount, 6);
+        cmd.set_fragment_buffer(frame.clusterHeaders, 7);
+        cmd.set_fragment_buffer(frame.clusterIndices, 8);
+        cmd.set_fragment_buffer(frame.clusterParams, 9);
+        cmd.set_fragment_buffer(frame.probeVolume, 10);
+        cmd.set_fragment_buffer(frame.probeData, 11);
+    }
+    cmd.draw_indexed_primitives(primitive_type::triangle, batch.indexCount, batch.indices, instanceCount, 0,
+                                batch.outputOffset);
+}
+
+// One thread per batch: writes (or clears) the batch's draw in the main and, optionally,
+// the depth prepass indirect command buffers from the culled counts.
+kernel void static_icb_encode(const device StaticBatchData* batches [[buffer(0)]],
+                              const device uint* counters [[buffer(1)]],
+                              constant StaticFrameBindings& frame [[buffer(2)]],
+                              device StaticICBArguments& icbs [[buffer(3)]],
+                              constant StaticCullParams& params [[buffer(4)]],
+                              uint bid [[thread_position_in_grid]]) {
+    if (bid >= params.batchCount) {
+        return;
+    }
+
+    uint count = counters[bid];
+    const device StaticBatchData& batch = batches[bid];
+    render_command mainCmd(icbs.mainCommands, bid);
+    // Meshlet batches are shaded by the mesh pipeline; the depth prepass still draws them here.
+    if (count == 0 || batch.meshletCount != 0) {
+        mainCmd.reset();
+    } else {
+        encodeStaticDraw(mainCmd, batch, frame, count, false);
+    }
+
+    if (params.encodePrepass != 0) {
+        render_command prepassCmd(icbs.prepassCommands, bid);
+        if (count == 0) {
+            prepassCmd.reset();
+        } else {
+            encodeStaticDraw(prepassCmd, batch, frame, count, true);
+        }
+    }
+}
+
+// ========================================================================
+// VISIBILITY BUFFER
+// ========================================================================
+
+// The static scene's opaque batches can be rasterized once more after the depth prepass into an
+// RG32Uint visibility target holding, per pixel, the culled instance slot and the triangle that
+// won the depth test. Main pass shading then reconstructs each pixel's varyings from those ids
+// (visibilitySurface) in fragment_main instead of running the vertex stage over every batch again.
+#define VISIBILITY_TILE_SIZE 32
+#define VISIBILITY_INVALID 0xFFFFFFFFu
+
+struct VisibilityOut {
+    float4 position [[position]];
+    float3 normalVS;
+    float2 texCoord;
+    float2 lightmapTexCoord;
+    float lodFade;
+    float lodDither;
+    float billboardFade;
+    float billboardFlag;
+    uint instance [[flat]];
+};
+
+// Executes the main pass indirect commands, so material is at fragment buffer 1 and the vertex is
+// the prepass one, which lays down exactly the depth the pass tests against.
+vertex VisibilityOut vertex_visibility_instanced(
+    VertexIn in [[stage_in]],
+    const device InstanceData* instances [[buffer(1)]],
+    constant CameraUniforms& camera [[buffer(2)]],
+    constant MaterialUniforms& material [[buffer(3)]],
+    constant MeshUniforms& mesh [[buffer(4)]],
+    uint instanceId [[instance_id]]
+) {
+    InstanceData inst = instances[instanceId];
+    float3 worldPos;
+    PrepassOut surface = prepassVertex(in, inst.modelMatrix, inst.normalMatrix, camera, material, mesh, worldPos);
+    VisibilityOut out;
+    out.position = surface.position;
+    out.normalVS = surface.normalVS;
+    out.texCoord = surface.texCoord;
+    out.lightmapTexCoord = surface.lightmapTexCoord;
+    out.lodFade = surface.lodFade;
+    out.lodDither = surface.lodDither;
+    out.billboardFade = surface.billboardFade;
+    out.billboardFlag = surface.billboardFlag;
+    out.instance = instanceId;
+    return out;
+}
+
+// The prepass's alpha, foliage and LOD dither discards decide which surface a pixel keeps.
+fragment uint2 fragment_visibility(
+    VisibilityOut in [[stage_in]],
+    constant MaterialUniforms& material [[buffer(1)]],
+    texture2d<float> roughnessMap [[texture(0)]],
+    texture2d<float> ormMap [[texture(1)]],
+    texture2d<float> albedoMap [[texture(2)]],
+    texture2d<float> terrainControlMap [[texture(3)]],
+    texture2d<float> terrainLayer0Map [[texture(4)]],
+    texture2d<float> terrainLayer1Map [[texture(5)]],
+    texture2d<float> terrainLayer2Map [[texture(6)]],
+    texture2d<float> terrainLayer0OrmMap [[texture(7)]],
+    texture2d<float> terrainLayer1OrmMap [[texture(8)]],
+    texture2d<float> terrainLayer2OrmMap [[texture(9)]],
+    sampler textureSampler [[sampler(0)]],
+    uint primitive [[primitive_id]]
+) {
+    prepassNormalRoughness(in, material, roughnessMap, ormMap, albedoMap, terrainControlMap,
+                           terrainLayer0Map, terrainLayer1Map, terrainLayer2Map,
+                           terrainLayer0OrmMap, terrainLayer1OrmMap, terrainLayer2OrmMap, textureSampler);
+    return uint2(in.instance, primitive);
+}
+
+// Batches own consecutive ranges of the culled array in order, so a slot's batch is the last one
+// starting at or before it.
+inline uint visibilityBatch(const device StaticBatchData* batches, uint batchCount, uint slot) {
+    uint lo = 0;
+    uint hi = batchCount;
+    while (hi - lo > 1) {
+        uint mid = (lo + hi) >> 1;
+        if (batches[mid].outputOffset <= slot) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// One threadgroup per tile, each thread covering 2x2 pixels: records the lowest batch and the
+// complement of the highest batch the tile's pixels hold, both with atomic min so the buffer can
+// be cleared to all ones. Batches of one material group are contiguous, so the range is enough
+// for vertex_visibility_tile to skip tiles a group has no pixels in.
+kernel void visibility_classify(texture2d<uint, access::read> ids [[texture(0)]],
+                                const device StaticBatchData* batches [[buffer(0)]],
+                                device atomic_uint* tileRanges [[buffer(1)]],
+                                constant VisibilityShadeParams& params [[buffer(2)]],
+                                uint2 gid [[thread_position_in_grid]],
+                                uint2 tile [[threadgroup_position_in_grid]],
+                                uint lane [[thread_index_in_simdgroup]]) {
+    uint2 size = uint2(params.screenSize);
+    uint lowest = VISIBILITY_INVALID;
+    uint highestComplement = VISIBILITY_INVALID;
+    for (uint i = 0; i < 4; ++i) {
+        uint2 pixel = gid * 2 + uint2(i & 1u, i >> 1);
+        if (pixel.x >= size.x || pixel.y >= size.y) {
+            continue;
+        }
+        uint slot = ids.read(pixel).x;
+        if (slot == VISIBILITY_INVALID) {
+            continue;
+        }
+        uint batch = visibilityBatch(batches, params.batchCount, slot);
+        lowest = min(lowest, batch);
+        highestComplement = min(highestComplement, ~batch);
+    }
+    lowest = simd_min(lowest);
+    highestComplement = simd_min(highestComplement);
+    if (lane == 0 && lowest != VISIBILITY_INVALID) {
+        uint index = (tile.y * params.tilesX + tile.x) * 2;
+        atomic_fetch_min_explicit(&tileRanges[index], lowest, memory_order_relaxed);
+        atomic_fetch_min_explicit(&tileRanges[index + 1], highestComplement, memory_order_relaxed);
+    }
+}
+
+// One triangle strip quad per tile at the near plane, collapsed off screen when the tile holds
+// none of the drawn group's batches. The varyings are rebuilt per pixel by fragment_main.
+vertex VertexOut vertex_visibility_tile(
+    constant VisibilityShadeParams& params [[buffer(0)]],
+    const device uint* tileRanges [[buffer(1)]],
+    uint vertexId [[vertex_id]],
+    uint tileId [[instance_id]]
+) {
+    VertexOut out = {};
+    uint lowest = tileRanges[tileId * 2];
+    uint highest = ~tileRanges[tileId * 2 + 1];
+    bool covered = lowest < params.firstBatch + params.batchRange && highest >= params.firstBatch;
+    uint2 tile = uint2(tileId % params.tilesX, tileId / params.tilesX);
+    float2 corner = float2((tile + uint2(vertexId & 1u, vertexId >> 1)) * VISIBILITY_TILE_SIZE);
+    float2 uv = min(corner / params.screenSize, float2(1.0));
+    out.position = covered ? float4(uvToNdc(uv), 0.0, 1.0) : float4(-2.0, -2.0, 0.0, 1.0);
+    return out;
+}
+
+// The varyings vertex_main_instanced would have interpolated at pixel for the recorded triangle of
+// a static batch. The pixel's (jittered) view ray is intersected with the triangle's world-space
+// vertices, camera relative for precision, and its barycentrics weight the vertex attributes;
+// they are not clamped, so helper pixels past the edge extrapolate smoothly for derivatives. Like
+// meshlet_mesh there is no billboard or impostor path, which the static scene does not batch.
+inline VertexOut visibilitySurface(float4 position,
+                                   uint slot,
+                                   uint primitive,
+                                   const device StaticBatchData& batch,
+                                   const device InstanceData* instances,
+                                   constant CameraUniforms& camera,
+                                   constant MaterialUniforms& material,
+                                   constant VisibilityShadeParams& params) {
+    InstanceData inst = instances[slot];
+    const device MeshUniforms& mesh = *reinterpret_cast<const device MeshUniforms*>(batch.mesh);
+    const device packed_float3* positions = reinterpret_cast<const device packed_float3*>(batch.vertices);
+    const device PackedVertexData* attributes = reinterpret_cast<const device PackedVertexData*>(batch.attributes);
+
+    float3 eye = camera.cameraPositionTime.xyz;
+    float3 points[3];
+    PackedVertexData packed[3];
+    float4 colors[3];
+    for (uint i = 0; i < 3; ++i) {
+        uint vertexIndex = batch.indices[primitive * 3 + i];
+        packed[i] = attributes[vertexIndex];
+        colors[i] = float4(packed[i].color) / 255.0;
+        float4 wp = inst.modelMatrix * float4(float3(positions[vertexIndex]), 1.0);
+        points[i] = applyWindOffset(wp.xyz, saturate(colors[i].a), material, camera) - eye;
+    }
+
+    float4 viewPoint = camera.projectionMatrixInverse * float4(uvToNdc(position.xy / params.screenSize), 0.5, 1.0);
+    float3 dir = normalize((camera.viewMatrixInverse * float4(viewPoint.xyz / viewPoint.w, 0.0)).xyz);
+    float3 e1 = points[1] - points[0];
+    float3 e2 = points[2] - points[0];
+    float3 pv = cross(dir, e2);
+    float det = dot(e1, pv);
+    float invDet = abs(det) > 1e-12 ? 1.0 / det : 0.0;
+    float3 tv = -points[0];
+    float b1 = dot(tv, pv) * invDet;
+    float b2 = dot(dir, cross(tv, e1)) * invDet;
+    float3 bary = float3(1.0 - b1 - b2, b1, b2);
+
+    float3 centerWS = (inst.modelMatrix * float4(mesh.boundsCenter.xyz, 1.0)).xyz;
+    float dist = distance(eye, centerWS);
+
+    VertexOut out;
+    out.position = position;
+    out.worldPosition = eye + points[0] * bary.x + points[1] * bary.y + points[2] * bary.z;
+    out.normal = float3(0.0);
+    out.tangent = float3(0.0);
+    out.bitangent = float3(0.0);
+    out.texCoord = float2(0.0);
+    out.lightmapTexCoord = float2(0.0);
+    out.color = float4(0.0);
+    for (uint i = 0; i < 3; ++i) {
+        float4 tangentIn = decodePackedTangent(packed[i].tangent);
+        float3 objectNormal = decodeOctNormal(decodePackedNormal(packed[i].normal));
+        out.normal += normalize((inst.normalMatrix * float4(objectNormal, 0.0)).xyz) * bary[i];
+        out.tangent += normalize((inst.normalMatrix * float4(tangentIn.xyz, 0.0)).xyz) * bary[i];
+        out.bitangent += normalize((inst.normalMatrix * float4(decodeBitangent(objectNormal, tangentIn), 0.0)).xyz) * bary[i];
+        out.texCoord += float2(half2(packed[i].texCoord)) * bary[i];
+        out.lightmapTexCoord += float2(half2(packed[i].texCoord1)) * bary[i];
+        out.color += colors[i] * bary[i];
+    }
+    out.lightmapTexCoord = out.lightmapTexCoord * mesh.lightmapScaleOffset.xy + mesh.lightmapScaleOffset.zw;
+    out.lodFade = (material.foliageParams2.y > 0.5) ? computeFade(dist, material.foliageParams1.x, material.foliageParams1.y) : 0.0;
+    out.lodDither = inst.normalMatrix[3].x;
+    out.billboardFade = (material.foliageParams2.z > 0.5) ? computeFade(dist, material.foliageParams1.z, material.foliageParams1.w) : 0.0;
+    out.billboardFlag = mesh.flags.x;
+    out.bakedLightingFlag = mesh.flags.y;
+    out.staticLightmapFlag = mesh.flags.z;
+    out.hdrStaticLightmapFlag = mesh.flags.w;
+    return out;
+}
+
+// ========================================================================
+// MESHLET RENDERING
+// ========================================================================
+
+#define MESHLETS_PER_OBJECT 32
+#define MESHLET_MESH_THREADS 128
+
+struct MeshletPayload {
+    uint instanceIndex;
+    uint meshletIndices[MESHLETS_PER_OBJECT];
+};
+
+using MeshletMesh = metal::mesh<VertexOut, void, 64, 124, topology::triangle>;
+
+// One threadgroup per MESHLETS_PER_OBJECT meshlets of one static instance (grid y). Each thread
+// tests one meshlet against the frustum, its backface cone and, once built, this frame's HZB, and
+// the survivors are compacted into the payload.
+[[object]] void meshlet_object(object_data MeshletPayload& payload [[payload]],
+                               mesh_grid_properties grid,
+                               const device MeshletData* meshlets [[buffer(0)]],
+                               const device InstanceData* instances [[buffer(1)]],
+                               constant CameraUniforms& camera [[buffer(2)]],
+                               constant MeshletCullParams& params [[buffer(3)]],
+                               texture2d<float, access::read> hzbTex [[texture(0)]],
+                               uint3 tgid [[threadgroup_position_in_grid]],
+                               uint lane [[thread_index_in_threadgroup]]) {
+    uint meshletIndex = tgid.x * MESHLETS_PER_OBJECT + lane;
+    bool visible = meshletIndex < params.meshletCount;
+    if (visible) {
+        float4x4 model = instances[tgid.y].modelMatrix;
+        MeshletData meshlet = meshlets[meshletIndex];
+        float maxScale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+        float3 worldCenter = (model * float4(meshlet.centerRadius.xyz, 1.0)).xyz;
+        float radius = meshlet.centerRadius.w * maxScale;
+
+        for (uint i = 0; i < 6 && visible; ++i) {
+            visible = dot(params.frustumPlanes[i], float4(worldCenter, 1.0)) >= -radius;
+        }
+
+        // Every triangle faces away from the camera when the view ray lies inside the cone.
+        // Mirrored instances flip the winding the cone was built for, so they skip the test.
+        bool mirrored = determinant(float3x3(model[0].xyz, model[1].xyz, model[2].xyz)) < 0.0;
+        if (visible && params.coneCulling != 0 && !mirrored && meshlet.coneAxisCutoff.w < 1.0) {
+            float3 apex = (model * float4(float3(meshlet.coneApex), 1.0)).xyz;
+            float3 axis = normalize((instances[tgid.y].normalMatrix * float4(meshlet.coneAxisCutoff.xyz, 0.0)).xyz);
+            float3 view = normalize(apex - camera.cameraPositionTime.xyz);
+            visible = dot(view, axis) < meshlet.coneAxisCutoff.w;
+        }
+
+        if (visible && params.useHzb != 0) {
+            visible = hzbSphereVisible(worldCenter, radius, camera, hzbTex, params.screenSize, params.hzbMipCount);
+        }
+    }
+
+    uint slot = simd_prefix_exclusive_sum(visible ? 1u : 0u);
+    if (visible) {
+        payload.meshletIndices[slot] = meshletIndex;
+    }
+    uint visibleCount = simd_sum(visible ? 1u : 0u);
+    if (lane == 0) {
+        payload.instanceIndex = tgid.y;
+        grid.set_threadgroups_per_grid(uint3(visibleCount, 1, 1));
+    }
+}
+
+// Expands one surviving meshlet. Vertex shading matches vertex_main_instanced for the static
+// scene (no billboard or impostor path), so the depth prepass output still lines up.
+[[mesh]] void meshlet_mesh(MeshletMesh output,
+                           const object_data MeshletPayload& payload [[payload]],
+                           const device MeshletData* meshlets [[buffer(0)]],
+                           const device InstanceData* instances [[buffer(1)]],
+                           constant CameraUniforms& camera [[buffer(2)]],
+                           constant MaterialUniforms& material [[buffer(3)]],
+                           constant MeshUniforms& meshUniforms [[buffer(4)]],
+                           const device uint* meshletVertices [[buffer(5)]],
+                           const device uchar* meshletTriangles [[buffer(6)]],
+                           const device packed_float3* positions [[buffer(7)]],
+                           const device PackedVertexData* attributes [[buffer(8)]],
+                           uint lane [[thread_index_in_threadgroup]],
+                           uint3 tgid [[threadgroup_position_in_grid]]) {
+    MeshletData meshlet = meshlets[payload.meshletIndices[tgid.x]];
+    InstanceData inst = instances[payload.instanceIndex];
+    if (lane == 0) {
+        output.set_primitive_count(meshlet.triangleCount);
+    }
+
+    float3 centerWS = (inst.modelMatrix * float4(meshUniforms.boundsCenter.xyz, 1.0)).xyz;
+    float dist = distance(camera.cameraPositionTime.xyz, centerWS);
+    float lodFade = (material.foliageParams2.y > 0.5) ? computeFade(dist, material.foliageParams1.x, material.foliageParams1.y) : 0.0;
+    float billboardFade = (material.foliageParams2.z > 0.5) ? computeFade(dist, material.foliageParams1.z, material.foliageParams1.w) : 0.0;
+
+    for (uint v = lane; v < meshlet.vertexCount; v += MESHLET_MESH_THREADS) {
+        uint vertexIndex = meshletVertices[meshlet.vertexOffset + v];
+        PackedVertexData packed = attributes[vertexIndex];
+        float4 color = float4(packed.color) / 255.0;
+        float4 tangentIn = decodePackedTangent(packed.tangent);
+        float3 objectNormal = decodeOctNormal(decodePackedNormal(packed.normal));
+
+        float4 wp = inst.modelMatrix * float4(float3(positions[vertexIndex]), 1.0);
+        wp.xyz = applyWindOffset(wp.xyz, saturate(color.a), material, camera);
+
+        VertexOut out;
+        out.worldPosition = wp.xyz;
+        out.position = camera.viewProjectionMatrix * float4(wp.xyz, 1.0);
+        out.normal = normalize((inst.normalMatrix * float4(objectNormal, 0.0)).xyz);
+        out.tangent = normalize((inst.normalMatrix * float4(tangentIn.xyz, 0.0)).xyz);
+        out.bitangent = normalize((inst.normalMatrix * float4(decodeBitangent(objectNormal, tangentIn), 0.0)).xyz);
+        out.texCoord = float2(half2(packed.texCoord));
+        out.lightmapTexCoord = float2(half2(packed.texCoord1)) * meshUniforms.lightmapScaleOffset.xy + meshUniforms.lightmapScaleOffset.zw;
+        out.color = color;
+        out.lodFade = lodFade;
+        out.lodDither = inst.normalMatrix[3].x;
+        out.billboardFade = billboardFade;
+        out.billboardFlag = meshUniforms.flags.x;
+        out.bakedLightingFlag = meshUniforms.flags.y;
+        out.staticLightmapFlag = meshUniforms.flags.z;
+        out.hdrStaticLightmapFlag = meshUniforms.flags.w;
+        output.set_vertex(v, out);
+    }
+
+    for (uint t = lane; t < meshlet.triangleCount; t += MESHLET_MESH_THREADS) {
+        uint base = meshlet.triangleOffset + t * 3;
+        output.set_index(t * 3 + 0, meshletTriangles[base + 0]);
+        output.set_index(t * 3 + 1, meshletTriangles[base + 1]);
+        output.set_index(t * 3 + 2, meshletTriangles[base + 2]);
+    }
+}
+
+// SSAO runs as three compute passes at full, half or quarter resolution: a GTAO-style horizon
+// trace, temporal accumulation along the reprojection, and a depth-aware upsample to the target
+// the main pass samples.
+#define SSAO_GROUP_SIZE 8
+#define SSAO_APRON 4
+#define SSAO_TILE_SIZE (SSAO_GROUP_SIZE + SSAO_APRON * 2)
+#define SSAO_SLICES 2
+#define SSAO_STEPS 4
+
+inline uint2 ssaoFullResPixel(int2 ssaoPixel, float2 scale, uint2 fullSize) {
+    int2 pixel = int2((float2(ssaoPixel) + 0.5) * scale);
+    return uint2(clamp(pixel, int2(0), int2(fullSize) - 1));
+}
+
+inline float3 ssaoViewPosition(int2 ssaoPixel,
+                               float2 scale,
+                               depth2d<float, access::read> depthTex,
+                               constant CameraUniforms& camera) {
+    uint2 fullSize = uint2(depthTex.get_width(), depthTex.get_height());
+    uint2 pixel = ssaoFullResPixel(ssaoPixel, scale, fullSize);
+    float2 uv = (float2(pixel) + 0.5) / float2(fullSize);
+    return reconstructViewPosition(uv, depthTex.read(pixel), camera);
+}
+
+// Each threadgroup stages the view positions of its tile plus an apron of SSAO_APRON pixels;
+// horizon steps that land outside the staged tile read the depth texture instead.
+kernel void ssao_trace(
     constant CameraUniforms& camera [[buffer(0)]],
     constant SSAOParams& params [[buffer(1)]],
-    depth2d<float> depthTex [[texture(0)]],
-    texture2d<float> normalTex [[texture(1)]],
-    texture2d<float> noiseTex [[texture(2)]],
-    sampler ssaoSampler [[sampler(0)]]
+    depth2d<float, access::read> depthTex [[texture(0)]],
+    texture2d<float, access::read> normalTex [[texture(1)]],
+    texture2d<float, access::write> aoTex [[texture(2)]],
+    uint2 gid [[thread_position_in_grid]],
+    uint2 lid [[thread_position_in_threadgroup]],
+    uint2 groupId [[threadgroup_position_in_grid]]
 ) {
-    float depth = depthTex.sample(ssaoSampler, in.uv);
+    threadgroup float3 tile[SSAO_TILE_SIZE][SSAO_TILE_SIZE];
+
+    float2 scale = params.resolution.xy;
+    int2 aoSize = int2(aoTex.get_width(), aoTex.get_height());
+    int2 tileOrigin = int2(groupId * SSAO_GROUP_SIZE) - SSAO_APRON;
+    for (uint i = lid.y * SSAO_GROUP_SIZE + lid.x; i < SSAO_TILE_SIZE * SSAO_TILE_SIZE;
+         i += SSAO_GROUP_SIZE * SSAO_GROUP_SIZE) {
+        int2 local = int2(i % SSAO_TILE_SIZE, i / SSAO_TILE_SIZE);
+        tile[local.y][local.x] = ssaoViewPosition(tileOrigin + local, scale, depthTex, camera);
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    if (int(gid.x) >= aoSize.x || int(gid.y) >= aoSize.y) {
+        return;
+    }
+
+    uint2 fullSize = uint2(depthTex.get_width(), depthTex.get_height());
+    uint2 fullPixel = ssaoFullResPixel(int2(gid), scale, fullSize);
+    float depth = depthTex.read(fullPixel);
     if (depth >= 1.0) {
-        return float4(1.0);
+        aoTex.write(float4(1.0, 0.0, 0.0, 0.0), gid);
+        return;
     }
 
-    float3 viewPos = reconstructViewPosition(in.uv, depth, camera);
-    float3 normalVS = normalize(normalTex.sample(ssaoSampler, in.uv).xyz * 2.0 - 1.0);
-    float3 worldPos = (camera.viewMatrixInverse * float4(viewPos, 1.0)).xyz;
-    float2 worldCell = floor(worldPos.xz / max(params.settings.x * 2.5, 0.2));
-    float noiseSeed = hash21(worldCell + worldPos.y * 0.173);
-    float angle = noiseSeed * TWO_PI;
-
-    float3 upRef = (abs(normalVS.y) < 0.98) ? float3(0.0, 1.0, 0.0) : float3(1.0, 0.0, 0.0);
-    float3 tangentBase = normalize(cross(upRef, normalVS));
-    float3 bitangentBase = cross(normalVS, tangentBase);
-    float sinA = sin(angle);
-    float cosA = cos(angle);
-    float3 tangent = tangentBase * cosA + bitangentBase * sinA;
-    float3 bitangent = cross(normalVS, tangent);
-    float3x3 TBN = float3x3(tangent, bitangent, normalVS);
+    float3 viewPos = tile[lid.y + SSAO_APRON][lid.x + SSAO_APRON];
+    float3 normalVS = decodeTargetNormal(normalTex.read(fullPixel));
+    float3 viewDir = normalize(-viewPos);
+    float radius = params.settings.x;
+    float viewDepth = linearizeDepth(depth, camera);
 
-    float occlusion = 0.0;
-    float distanceFade = clamp(abs(viewPos.z) * 0.035, 0.65, 1.0);
-    float radius = params.settings.x * distanceFade;
-    float bias = params.settings.y;
+    float radiusPixels = radius * camera.projectionMatrix[1][1] * 0.5 * float(aoSize.y) / max(viewDepth, 0.0001);
+    if (radiusPixels < 1.0) {
+        aoTex.write(float4(1.0, viewDepth, 0.0, 0.0), gid);
+        return;
+    }
+    float stepPixels = radiusPixels / float(SSAO_STEPS);
+
+    // Interleaved gradient noise, advanced every frame so the accumulation sees new slice angles.
+    float frame = params.settings.w;
+    float noise = fract(52.9829189 * fract(dot(float2(gid) + frame * 5.588238, float2(0.06711056, 0.00583715))));
+    float jitter = hash21(float2(gid) + frame);
+
+    float visibility = 0.0;
+    for (int slice = 0; slice < SSAO_SLICES; ++slice) {
+        float phi = (float(slice) + noise) * (PI / float(SSAO_SLICES));
+        float2 screenDir = float2(cos(phi), sin(phi));
+        float3 direction = float3(screenDir.x, -screenDir.y, 0.0);
+        float3 orthoDirection = direction - dot(direction, viewDir) * viewDir;
+        float3 axis = normalize(cross(orthoDirection, viewDir));
+        float3 projectedNormal = normalVS - axis * dot(normalVS, axis);
+        float projectedLength = length(projectedNormal);
+        if (projectedLength < 0.0001) {
+            visibility += 1.0;
+            continue;
+        }
+        float cosNormal = saturate(dot(projectedNormal, viewDir) / projectedLength);
+        float n = sign(dot(orthoDirection, projectedNormal)) * acos(cosNormal);
+
+        float horizonCos[2] = { -1.0, -1.0 };
+        for (int side = 0; side < 2; ++side) {
+            float2 sideDir = side == 0 ? screenDir : -screenDir;
+            for (int stepIndex = 0; stepIndex < SSAO_STEPS; ++stepIndex) {
+                float2 offset = sideDir * (float(stepIndex) + jitter) * stepPixels;
+                int2 samplePixel = int2(gid) + int2(round(offset));
+                if (all(samplePixel == int2(gid))) {
+                    continue;
+                }
+                if (any(samplePixel < int2(0)) || any(samplePixel >= aoSize)) {
+                    break;
+                }
+                int2 local = samplePixel - tileOrigin;
+                float3 samplePos = (all(local >= int2(0)) && all(local < int2(SSAO_TILE_SIZE)))
+                    ? tile[local.y][local.x]
+                    : ssaoViewPosition(samplePixel, scale, depthTex, camera);
+                float3 delta = samplePos - viewPos;
+                float distanceSq = dot(delta, delta);
+                float sampleCos = dot(delta * rsqrt(max(distanceSq, 1e-8)), viewDir);
+                float falloff = saturate(1.0 - distanceSq / (radius * radius));
+                horizonCos[side] = max(horizonCos[side], mix(-1.0, sampleCos, falloff));
+            }
+        }
 
-    (void)noiseTex;
-    (void)params.noiseScale;
+        float h0 = -acos(clamp(horizonCos[1], -1.0, 1.0));
+        float h1 = acos(clamp(horizonCos[0], -1.0, 1.0));
+        h0 = n + clamp(h0 - n, -HALF_PI, HALF_PI);
+        h1 = n + clamp(h1 - n, -HALF_PI, HALF_PI);
+        float arc0 = cosNormal + 2.0 * h0 * sin(n) - cos(2.0 * h0 - n);
+        float arc1 = cosNormal + 2.0 * h1 * sin(n) - cos(2.0 * h1 - n);
+        visibility += projectedLength * 0.25 * (arc0 + arc1);
+    }
 
-    for (int i = 0; i < 16; ++i) {
-        float scale = float(i) / 16.0;
-        float3 sampleVec = TBN * kSSAOKernel[i];
-        scale = mix(0.1, 1.0, scale * scale);
-        float3 samplePos = viewPos + sampleVec * radius * scale;
+    float occlusion = saturate(visibility / float(SSAO_SLICES));
+    occlusion = pow(occlusion, params.settings.z);
+    occlusion = saturate(mix(1.0, occlusion, params.settings.y));
+    aoTex.write(float4(occlusion, viewDepth, 0.0, 0.0), gid);
+}
 
-        float4 offset = camera.projectionMatrix * float4(samplePos, 1.0);
-        float2 ndc = offset.xy / max(offset.w, 0.0001);
-        float2 sampleUV = float2(ndc.x * 0.5 + 0.5, 1.0 - (ndc.y * 0.5 + 0.5));
+kernel void ssao_temporal(
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant SSAOTemporalParams& params [[buffer(1)]],
+    texture2d<float, access::read> currentTex [[texture(0)]],
+    texture2d<float> historyTex [[texture(1)]],
+    texture2d<float> velocityTex [[texture(2)]],
+    texture2d<float, access::write> outTex [[texture(3)]],
+    depth2d<float> depthTex [[texture(4)]],
+    sampler linearSampler [[sampler(0)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    int2 size = int2(outTex.get_width(), outTex.get_height());
+    if (int(gid.x) >= size.x || int(gid.y) >= size.y) {
+        return;
+    }
 
-        if (sampleUV.x < 0.0 || sampleUV.x > 1.0 || sampleUV.y < 0.0 || sampleUV.y > 1.0) {
-            continue;
-        }
+    float2 current = currentTex.read(gid).rg;
+    if (current.g <= 0.0 || params.params0.y < 0.5) {
+        outTex.write(float4(current, 0.0, 0.0), gid);
+        return;
+    }
 
-        float sampleDepth = depthTex.sample(ssaoSampler, sampleUV);
-        if (sampleDepth >= 1.0) {
-            continue;
+    float2 uv = (float2(gid) + 0.5) / float2(size);
+    float2 prevUV = uv;
+    if (params.params0.z > 0.5) {
+        prevUV = uv - velocityTex.sample(linearSampler, uv).rg;
+    } else {
+        float depth = depthTex.sample(linearSampler, uv);
+        float3 viewPos = reconstructViewPosition(uv, depth, camera);
+        float4 worldPos = camera.viewMatrixInverse * float4(viewPos, 1.0);
+        float4 prevClip = params.prevViewProjection * worldPos;
+        if (prevClip.w <= 0.0001) {
+            outTex.write(float4(current, 0.0, 0.0), gid);
+            return;
         }
+        float2 prevNdc = prevClip.xy / prevClip.w;
+        prevUV = float2(prevNdc.x * 0.5 + 0.5, 1.0 - (prevNdc.y * 0.5 + 0.5));
+    }
+    if (prevUV.x < 0.0 || prevUV.x > 1.0 || prevUV.y < 0.0 || prevUV.y > 1.0) {
+        outTex.write(float4(current, 0.0, 0.0), gid);
+        return;
+    }
 
-        float3 sampleView = reconstructViewPosition(sampleUV, sampleDepth, camera);
-        float range = smoothstep(0.0, 1.0, radius / max(abs(viewPos.z - sampleView.z), 0.0001));
-        float occluded = sampleView.z >= (samplePos.z + bias) ? 1.0 : 0.0;
-        occlusion += occluded * range;
+    // Reject history from a different surface, then clamp it to the local range of this frame.
+    float2 history = historyTex.sample(linearSampler, prevUV).rg;
+    if (history.g <= 0.0 || abs(history.g - current.g) > params.params0.w * current.g) {
+        outTex.write(float4(current, 0.0, 0.0), gid);
+        return;
+    }
+
+    float minAO = current.r;
+    float maxAO = current.r;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            int2 p = clamp(int2(gid) + int2(x, y), int2(0), size - 1);
+            float ao = currentTex.read(uint2(p)).r;
+            minAO = min(minAO, ao);
+            maxAO = max(maxAO, ao);
+        }
     }
 
-    occlusion = 1.0 - (occlusion / 16.0);
-    occlusion = pow(occlusion, params.settings.w);
-    occlusion = mix(1.0, occlusion, params.settings.z);
-    return float4(occlusion, occlusion, occlusion, 1.0);
+    float accumulated = mix(current.r, clamp(history.r, minAO, maxAO), params.params0.x);
+    outTex.write(float4(accumulated, current.g, 0.0, 0.0), gid);
 }
 
-fragment float4 ssao_blur_fragment(
-    BlitVertexOut in [[stage_in]],
+kernel void ssao_upsample(
     constant CameraUniforms& camera [[buffer(0)]],
-    constant SSAOBlurParams& params [[buffer(1)]],
-    texture2d<float> ssaoTex [[texture(0)]],
-    depth2d<float> depthTex [[texture(1)]],
-    texture2d<float> normalTex [[texture(2)]],
-    sampler ssaoSampler [[sampler(0)]]
+    constant SSAOUpsampleParams& params [[buffer(1)]],
+    texture2d<float, access::read> aoTex [[texture(0)]],
+    depth2d<float, access::read> depthTex [[texture(1)]],
+    texture2d<float, access::write> outTex [[texture(2)]],
+    uint2 gid [[thread_position_in_grid]]
 ) {
-    float centerDepth = depthTex.sample(ssaoSampler, in.uv);
-    if (centerDepth >= 1.0) {
-        return float4(1.0);
+    if (gid.x >= outTex.get_width() || gid.y >= outTex.get_height()) {
+        return;
     }
-    float centerLinear = linearizeDepth(centerDepth, camera);
-    float3 centerNormal = normalize(normalTex.sample(ssaoSampler, in.uv).xyz * 2.0 - 1.0);
 
-    float2 offsets[9] = {
-        float2(0.0, 0.0),
-        float2(1.0, 0.0), float2(-1.0, 0.0),
-        float2(0.0, 1.0), float2(0.0, -1.0),
-        float2(1.0, 1.0), float2(-1.0, 1.0),
-        float2(1.0, -1.0), float2(-1.0, -1.0)
-    };
+    float depth = depthTex.read(gid);
+    if (depth >= 1.0) {
+        outTex.write(float4(1.0), gid);
+        return;
+    }
+    float viewDepth = linearizeDepth(depth, camera);
 
+    // 3x3 SSAO pixels around this pixel, weighted by distance and by how close their depth is.
+    float2 aoPos = (float2(gid) + 0.5) / params.params0.xy - 0.5;
+    int2 center = int2(round(aoPos));
+    int2 aoMax = int2(aoTex.get_width(), aoTex.get_height()) - 1;
     float sum = 0.0;
     float weightSum = 0.0;
-    for (int i = 0; i < 9; ++i) {
-        float2 uv = in.uv + offsets[i] * params.texelSize;
-        float sampleDepth = depthTex.sample(ssaoSampler, uv);
-        if (sampleDepth >= 1.0) {
-            continue;
+    float nearest = 1.0;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            int2 p = clamp(center + int2(x, y), int2(0), aoMax);
+            float2 sample = aoTex.read(uint2(p)).rg;
+            if (x == 0 && y == 0) {
+                nearest = sample.r;
+            }
+            if (sample.g <= 0.0) {
+                continue;
+            }
+            float2 d = float2(p) - aoPos;
+            float spatialWeight = exp(-dot(d, d) * 0.75);
+            float depthWeight = exp(-abs(sample.g - viewDepth) / max(viewDepth, 0.0001) * params.params0.z);
+            float weight = spatialWeight * depthWeight;
+            sum += sample.r * weight;
+            weightSum += weight;
         }
-        float sampleLinear = linearizeDepth(sampleDepth, camera);
-        float depthWeight = exp(-abs(sampleLinear - centerLinear) * params.depthSharpness);
-        float3 sampleNormal = normalize(normalTex.sample(ssaoSampler, uv).xyz * 2.0 - 1.0);
-        float normalWeight = pow(saturate(dot(sampleNormal, centerNormal)), params.normalSharpness);
-        float weight = depthWeight * normalWeight;
-        float sample = ssaoTex.sample(ssaoSampler, uv).r;
-        sum += sample * weight;
-        weightSum += weight;
     }
 
-    float result = (weightSum > 0.0) ? (sum / weightSum) : 1.0;
-    return float4(result, result, result, 1.0);
+    float result = (weightSum > 1e-4) ? (sum / weightSum) : nearest;
+    outTex.write(float4(result), gid);
 }
 
-fragment float4 bloom_prefilter_fragment(
-    BlitVertexOut in [[stage_in]],
-    constant BloomPrefilterParams& params [[buffer(0)]],
-    texture2d<float> source [[texture(0)]],
-    sampler sourceSampler [[sampler(0)]]
-) {
-    float3 color = source.sample(sourceSampler, in.uv).rgb;
+inline float3 bloomPrefilter(float3 color, float threshold, float knee) {
     float brightness = max(max(color.r, color.g), color.b);
-    float threshold = params.threshold;
-    float knee = params.knee;
     float contrib = max(brightness - threshold, 0.0);
     if (knee > 0.0) {
         float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
@@ -1774,7 +3224,17 @@ fragment float4 bloom_prefilter_fragment(
         contrib = max(contrib, soft);
     }
     float scale = (brightness > 1e-5) ? (contrib / brightness) : 0.0;
-    return float4(color * scale, 1.0);
+    return color * scale;
+}
+
+fragment float4 bloom_prefilter_fragment(
+    BlitVertexOut in [[stage_in]],
+    constant BloomPrefilterParams& params [[buffer(0)]],
+    texture2d<float> source [[texture(0)]],
+    sampler sourceSampler [[sampler(0)]]
+) {
+    float3 color = source.sample(sourceSampler, in.uv).rgb;
+    return float4(bloomPrefilter(color, params.threshold, params.knee), 1.0);
 }
 
 fragment float4 bloom_blur_fragment(
@@ -1808,6 +3268,67 @@ fragment float4 bloom_downsample_fragment(
     return float4(color, 1.0);
 }
 
+// Prefilter and the whole downsample chain in one dispatch: each 256-thread group prefilters a
+// 32x32 tile of bloom mip 0 and box-reduces it through threadgroup memory down to its mip 5 texel.
+#define BLOOM_SPD_MAX_MIPS 6
+#define BLOOM_SPD_GROUP 16
+
+struct BloomDownsampleSPDParams {
+    float threshold;
+    float knee;
+    uint mipCount;
+    uint pad0;
+};
+
+kernel void bloom_downsample_spd(texture2d<float> source [[texture(0)]],
+                                 array<texture2d<float, access::write>, BLOOM_SPD_MAX_MIPS> mips [[texture(1)]],
+                                 constant BloomDownsampleSPDParams& params [[buffer(0)]],
+                                 sampler sourceSampler [[sampler(0)]],
+                                 uint2 groupId [[threadgroup_position_in_grid]],
+                                 uint2 lid [[thread_position_in_threadgroup]]) {
+    threadgroup float3 reduced[BLOOM_SPD_GROUP * BLOOM_SPD_GROUP];
+
+    uint2 mip0Size = uint2(mips[0].get_width(), mips[0].get_height());
+    float2 invMip0Size = 1.0 / float2(mip0Size);
+    float3 m1 = float3(0.0);
+    for (uint y = 0; y < 2; ++y) {
+        for (uint x = 0; x < 2; ++x) {
+            uint2 p = groupId * 32 + lid * 2 + uint2(x, y);
+            float3 color = bloomPrefilter(source.sample(sourceSampler, (float2(p) + 0.5) * invMip0Size).rgb,
+                                          params.threshold, params.knee);
+            if (p.x < mip0Size.x && p.y < mip0Size.y) {
+                mips[0].write(float4(color, 1.0), p);
+            }
+            m1 += color;
+        }
+    }
+    m1 *= 0.25;
+    uint2 coord = groupId * BLOOM_SPD_GROUP + lid;
+    if (params.mipCount > 1 && coord.x < mips[1].get_width() && coord.y < mips[1].get_height()) {
+        mips[1].write(float4(m1, 1.0), coord);
+    }
+    reduced[lid.y * BLOOM_SPD_GROUP + lid.x] = m1;
+
+    uint size = BLOOM_SPD_GROUP / 2;
+    for (uint mip = 2; mip < params.mipCount; ++mip, size /= 2) {
+        threadgroup_barrier(mem_flags::mem_threadgroup);
+        float3 value = float3(0.0);
+        if (lid.x < size && lid.y < size) {
+            uint2 s = lid * 2;
+            value = (reduced[s.y * BLOOM_SPD_GROUP + s.x] + reduced[s.y * BLOOM_SPD_GROUP + s.x + 1]
+                   + reduced[(s.y + 1) * BLOOM_SPD_GROUP + s.x] + reduced[(s.y + 1) * BLOOM_SPD_GROUP + s.x + 1]) * 0.25;
+        }
+        threadgroup_barrier(mem_flags::mem_threadgroup);
+        if (lid.x < size && lid.y < size) {
+            reduced[lid.y * BLOOM_SPD_GROUP + lid.x] = value;
+            coord = groupId * size + lid;
+            if (coord.x < mips[mip].get_width() && coord.y < mips[mip].get_height()) {
+                mips[mip].write(float4(value, 1.0), coord);
+            }
+        }
+    }
+}
+
 fragment float4 bloom_upsample_fragment(
     BlitVertexOut in [[stage_in]],
     constant BloomUpsampleParams& params [[buffer(0)]],
@@ -1883,124 +3404,307 @@ fragment float4 bloom_combine_fragment(
     return float4(color, 1.0);
 }
 
-fragment float4 ssr_fragment(
-    BlitVertexOut in [[stage_in]],
+// Hierarchical SSR. Rays are traced at half resolution, one pixel of each 2x2 quad per frame, with
+// a GGX-distributed direction, through a closest-depth pyramid of the prepass depth; ssr_temporal
+// accumulates them along the reprojection and the SSR composite filters and upsamples the result.
+// The results are premultiplied: rgb is the reflected color times its confidence in a.
+kernel void ssr_hiz_init(
+    depth2d<float, access::read> depthTex [[texture(0)]],
+    texture2d<float, access::write> hizTex [[texture(1)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    if (gid.x >= hizTex.get_width() || gid.y >= hizTex.get_height()) {
+        return;
+    }
+    uint2 maxPixel = uint2(depthTex.get_width() - 1, depthTex.get_height() - 1);
+    uint2 base = gid * 2;
+    float d0 = depthTex.read(min(base, maxPixel));
+    float d1 = depthTex.read(min(base + uint2(1, 0), maxPixel));
+    float d2 = depthTex.read(min(base + uint2(0, 1), maxPixel));
+    float d3 = depthTex.read(min(base + uint2(1, 1), maxPixel));
+    hizTex.write(min(min(d0, d1), min(d2, d3)), gid);
+}
+
+kernel void ssr_hiz_downsample(
+    texture2d<float, access::read> srcTex [[texture(0)]],
+    texture2d<float, access::write> dstTex [[texture(1)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    if (gid.x >= dstTex.get_width() || gid.y >= dstTex.get_height()) {
+        return;
+    }
+    uint2 maxPixel = uint2(srcTex.get_width() - 1, srcTex.get_height() - 1);
+    uint2 base = gid * 2;
+    float d0 = srcTex.read(min(base, maxPixel)).r;
+    float d1 = srcTex.read(min(base + uint2(1, 0), maxPixel)).r;
+    float d2 = srcTex.read(min(base + uint2(0, 1), maxPixel)).r;
+    float d3 = srcTex.read(min(base + uint2(1, 1), maxPixel)).r;
+    dstTex.write(min(min(d0, d1), min(d2, d3)), gid);
+}
+
+// uv and NDC depth of a view-space point; both vary linearly along a projected ray.
+static inline float3 ssrProjectToScreen(float3 viewPos, constant CameraUniforms& camera) {
+    float4 clip = camera.projectionMatrix * float4(viewPos, 1.0);
+    float3 ndc = clip.xyz / clip.w;
+    return float3(ndc.x * 0.5 + 0.5, 1.0 - (ndc.y * 0.5 + 0.5), ndc.z);
+}
+
+kernel void ssr_trace(
     constant CameraUniforms& camera [[buffer(0)]],
     constant SSRParams& params [[buffer(1)]],
     texture2d<float> sceneTex [[texture(0)]],
-    depth2d<float> depthTex [[texture(1)]],
-    texture2d<float> normalTex [[texture(2)]],
-    sampler sourceSampler [[sampler(0)]]
+    depth2d<float, access::read> depthTex [[texture(1)]],
+    texture2d<float, access::read> normalTex [[texture(2)]],
+    texture2d<float, access::read> hizTex [[texture(3)]],
+    texture2d<float, access::write> outTex [[texture(4)]],
+    sampler linearSampler [[sampler(0)]],
+    uint2 gid [[thread_position_in_grid]]
 ) {
-    float depth = depthTex.sample(sourceSampler, in.uv);
-    float3 current = sceneTex.sample(sourceSampler, in.uv).rgb;
-    if (depth >= 1.0) {
-        return float4(current, 1.0);
+    if (gid.x >= outTex.get_width() || gid.y >= outTex.get_height()) {
+        return;
     }
 
-    float3 viewPos = reconstructViewPosition(in.uv, depth, camera);
-    float4 normalSample = normalTex.sample(sourceSampler, in.uv);
-    float3 normalVS = normalize(normalSample.xyz * 2.0 - 1.0);
-    float roughness = clamp(normalSample.w, 0.0, 1.0);
+    const uint2 quadOffsets[4] = { uint2(0, 0), uint2(1, 1), uint2(1, 0), uint2(0, 1) };
+    uint frame = uint(params.settings2.x);
+    uint2 fullSize = uint2(depthTex.get_width(), depthTex.get_height());
+    uint2 pixel = min(gid * 2 + quadOffsets[frame & 3u], fullSize - 1);
+    float2 pixelUV = (float2(pixel) + 0.5) / float2(fullSize);
+
+    float depth = depthTex.read(pixel);
+    float4 normalSample = normalTex.read(pixel);
+    float roughness = decodeTargetRoughness(normalSample);
+    float maxRoughness = params.settings1.y;
+    if (depth >= 1.0 || maxRoughness <= 0.0 || roughness > maxRoughness) {
+        outTex.write(float4(0.0), gid);
+        return;
+    }
+
+    float3 viewPos = reconstructViewPosition(pixelUV, depth, camera);
+    float3 normalVS = decodeTargetNormal(normalSample);
     float3 viewDir = normalize(viewPos);
-    float3 reflDir = reflect(viewDir, normalVS);
-    if (reflDir.z > -0.01) {
-        return float4(current, 1.0);
+
+    // GGX half vector around the normal, with noise that changes every frame.
+    float2 xi = float2(hash21(float2(pixel) + float(frame % 64u) * 17.0),
+                       hash21(float2(pixel.yx) + float(frame % 64u) * 31.0 + 7.0));
+    float alpha = roughness * roughness;
+    float phi = TWO_PI * xi.x;
+    float cosTheta = sqrt((1.0 - xi.y) / (1.0 + (alpha * alpha - 1.0) * xi.y));
+    float sinTheta = sqrt(max(0.0, 1.0 - cosTheta * cosTheta));
+    float3 up = abs(normalVS.z) < 0.999 ? float3(0.0, 0.0, 1.0) : float3(1.0, 0.0, 0.0);
+    float3 tangent = normalize(cross(up, normalVS));
+    float3 bitangent = cross(normalVS, tangent);
+    float3 halfVector = normalize(tangent * (sinTheta * cos(phi)) + bitangent * (sinTheta * sin(phi))
+                                  + normalVS * cosTheta);
+    float3 reflDir = reflect(viewDir, halfVector);
+    if (reflDir.z > -0.01 || dot(reflDir, normalVS) <= 0.0) {
+        outTex.write(float4(0.0), gid);
+        return;
     }
 
-    float maxSteps = max(params.settings0.w, 1.0);
     float maxDistance = max(params.settings1.x, 0.1);
-    float maxRoughness = params.settings1.y;
-    if (maxRoughness <= 0.0 || roughness > maxRoughness) {
-        return float4(current, 1.0);
-    }
     float thickness = params.settings0.z;
-    float stepSize = maxDistance / maxSteps;
-    float3 prevPos = viewPos;
-    float2 hitUV = float2(-1.0);
-    float3 hitView = float3(0.0);
-    float hit = 0.0;
-
-    float pixelJitter = hash21(floor(in.uv * float2(sceneTex.get_width(), sceneTex.get_height())));
-    for (int i = 0; i < 128; ++i) {
-        if (float(i) >= maxSteps) {
-            break;
+    float3 start = ssrProjectToScreen(viewPos, camera);
+    float3 delta = ssrProjectToScreen(viewPos + reflDir * maxDistance, camera) - start;
+
+    // Stop at the screen border.
+    float tMax = 1.0;
+    if (delta.x > 0.0) tMax = min(tMax, (1.0 - start.x) / delta.x);
+    if (delta.x < 0.0) tMax = min(tMax, -start.x / delta.x);
+    if (delta.y > 0.0) tMax = min(tMax, (1.0 - start.y) / delta.y);
+    if (delta.y < 0.0) tMax = min(tMax, -start.y / delta.y);
+
+    float2 hizSize = float2(hizTex.get_width(), hizTex.get_height());
+    float texelsAlongRay = max(length(delta.xy * hizSize), 0.0001);
+    float tEpsilon = 0.05 / texelsAlongRay;
+    float2 invDelta = float2(abs(delta.x) > 1e-6 ? 1.0 / delta.x : 1e6,
+                             abs(delta.y) > 1e-6 ? 1.0 / delta.y : 1e6);
+    float2 boundaryStep = step(0.0, delta.xy);
+
+    int maxMip = max(int(params.settings2.y) - 1, 0);
+    int mip = 0;
+    float t = 1.5 / texelsAlongRay; // leave the starting texel
+    float3 rayPos = start;
+    bool hit = false;
+    int maxIterations = int(max(params.settings0.w, 1.0));
+    for (int i = 0; i < maxIterations && t < tMax; ++i) {
+        rayPos = start + delta * t;
+        float2 levelSize = float2(hizTex.get_width(mip), hizTex.get_height(mip));
+        float2 cell = floor(rayPos.xy * levelSize);
+        float closestDepth = hizTex.read(uint2(clamp(cell, float2(0.0), levelSize - 1.0)), uint(mip)).r;
+        float2 tBoundary = ((cell + boundaryStep) / levelSize - start.xy) * invDelta;
+        float tExit = min(abs(tBoundary.x), abs(tBoundary.y));
+
+        if (rayPos.z < closestDepth) {
+            // In front of everything in the cell: skip it, or move to where the ray reaches the
+            // cell's closest depth and look closer.
+            float tDepth = delta.z > 0.0 ? t + (closestDepth - rayPos.z) / delta.z : tExit + 1.0;
+            if (tDepth >= tExit) {
+                t = tExit + tEpsilon;
+                mip = min(mip + 1, maxMip);
+            } else {
+                t = tDepth + tEpsilon;
+                mip = max(mip - 1, 0);
+            }
+            continue;
         }
-        float3 rayPos = viewPos + reflDir * (stepSize * (float(i) + 0.5 + pixelJitter));
-        float4 clip = camera.projectionMatrix * float4(rayPos, 1.0);
-        if (clip.w <= 0.0001) {
-            break;
+        if (mip > 0) {
+            mip--;
+            continue;
         }
-        float2 uv = float2(clip.x / clip.w * 0.5 + 0.5, 1.0 - (clip.y / clip.w * 0.5 + 0.5));
-        if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) {
+        // Behind the closest surface at full detail: a hit unless the surface is thinner than
+        // the ray's depth past it.
+        float sceneDepth = linearizeDepth(closestDepth, camera);
+        float rayDepth = linearizeDepth(rayPos.z, camera);
+        if (rayDepth - sceneDepth <= max(thickness, 0.05)) {
+            hit = true;
             break;
         }
-        float sampleDepth = depthTex.sample(sourceSampler, uv);
-        if (sampleDepth < 1.0) {
-            float3 sampleView = reconstructViewPosition(uv, sampleDepth, camera);
-            float depthDelta = abs(sampleView.z - rayPos.z);
-            if (rayPos.z <= sampleView.z + thickness && depthDelta <= max(thickness * 2.0, 0.05)) {
-                float3 start = prevPos;
-                float3 end = rayPos;
-                float2 refineUV = uv;
-                float3 refineView = sampleView;
-                for (int j = 0; j < 4; ++j) {
-                    float3 mid = (start + end) * 0.5;
-                    float4 midClip = camera.projectionMatrix * float4(mid, 1.0);
-                    if (midClip.w <= 0.0001) {
-                        break;
-                    }
-                    float2 midUV = float2(midClip.x / midClip.w * 0.5 + 0.5,
-                                          1.0 - (midClip.y / midClip.w * 0.5 + 0.5));
-                    if (midUV.x < 0.0 || midUV.x > 1.0 || midUV.y < 0.0 || midUV.y > 1.0) {
-                        break;
-                    }
-                    float midDepth = depthTex.sample(sourceSampler, midUV);
-                    if (midDepth >= 1.0) {
-                        start = mid;
-                        continue;
-                    }
-                    float3 midView = reconstructViewPosition(midUV, midDepth, camera);
-                    float midDelta = abs(midView.z - mid.z);
-                    if (mid.z <= midView.z + thickness && midDelta <= max(thickness * 2.0, 0.05)) {
-                        end = mid;
-                        refineUV = midUV;
-                        refineView = midView;
-                    } else {
-                        start = mid;
-                    }
-                }
-                float4 hitNormalSample = normalTex.sample(sourceSampler, refineUV);
-                float3 hitNormalVS = normalize(hitNormalSample.xyz * 2.0 - 1.0);
-                float facing = dot(hitNormalVS, normalize(-reflDir));
-                float hitDistance = length(refineView - viewPos);
-                float facingFade = smoothstep(0.08, 0.3, facing);
-                if (facingFade > 0.0 && hitDistance <= maxDistance) {
-                    hitUV = refineUV;
-                    hitView = refineView;
-                    hit = facingFade;
-                    break;
-                }
-            }
-        }
-        prevPos = rayPos;
+        t = tExit + tEpsilon;
     }
 
-    if (hit < 0.5) {
-        return float4(current, 1.0);
+    // A miss keeps the IBL/probe reflection already in the shaded color.
+    if (!hit) {
+        outTex.write(float4(0.0), gid);
+        return;
     }
 
-    float3 reflection = sceneTex.sample(sourceSampler, hitUV).rgb;
-    float fresnel = pow(1.0 - saturate(dot(normalVS, normalize(-viewDir))), 5.0);
+    float2 hitUV = rayPos.xy;
+    uint2 hitPixel = min(uint2(hitUV * float2(fullSize)), fullSize - 1);
+    float3 hitNormalVS = decodeTargetNormal(normalTex.read(hitPixel));
+    float facingFade = smoothstep(0.08, 0.3, dot(hitNormalVS, -reflDir));
+    float3 hitView = reconstructViewPosition(hitUV, depthTex.read(hitPixel), camera);
+    float distFade = saturate(1.0 - length(hitView - viewPos) / max(params.settings1.w, 0.0001));
     float2 edge = abs(hitUV - 0.5) * 2.0;
     float edgeFade = saturate((0.94 - max(edge.x, edge.y)) / 0.18);
+    float confidence = facingFade * distFade * edgeFade;
+
+    float3 reflection = sceneTex.sample(linearSampler, hitUV, level(0.0)).rgb;
+    outTex.write(float4(reflection * confidence, confidence), gid);
+}
+
+kernel void ssr_temporal(
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant SSRParams& params [[buffer(1)]],
+    texture2d<float, access::read> currentTex [[texture(0)]],
+    texture2d<float> historyTex [[texture(1)]],
+    texture2d<float> velocityTex [[texture(2)]],
+    texture2d<float, access::write> outTex [[texture(3)]],
+    depth2d<float> depthTex [[texture(4)]],
+    sampler linearSampler [[sampler(0)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    int2 size = int2(outTex.get_width(), outTex.get_height());
+    if (int(gid.x) >= size.x || int(gid.y) >= size.y) {
+        return;
+    }
+
+    float4 current = currentTex.read(gid);
+    if (params.settings2.z < 0.5) {
+        outTex.write(current, gid);
+        return;
+    }
+
+    float2 uv = (float2(gid) + 0.5) / float2(size);
+    float2 prevUV = uv;
+    if (params.settings3.x > 0.5) {
+        prevUV = uv - velocityTex.sample(linearSampler, uv).rg;
+    } else {
+        float depth = depthTex.sample(linearSampler, uv);
+        float3 viewPos = reconstructViewPosition(uv, depth, camera);
+        float4 prevClip = params.prevViewProjection * (camera.viewMatrixInverse * float4(viewPos, 1.0));
+        if (prevClip.w <= 0.0001) {
+            outTex.write(current, gid);
+            return;
+        }
+        float2 prevNdc = prevClip.xy / prevClip.w;
+        prevUV = float2(prevNdc.x * 0.5 + 0.5, 1.0 - (prevNdc.y * 0.5 + 0.5));
+    }
+    if (prevUV.x < 0.0 || prevUV.x > 1.0 || prevUV.y < 0.0 || prevUV.y > 1.0) {
+        outTex.write(current, gid);
+        return;
+    }
+
+    // Each frame traces one pixel per quad, so the neighborhood that bounds the history is 3x3.
+    float4 minValue = current;
+    float4 maxValue = current;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            int2 p = clamp(int2(gid) + int2(x, y), int2(0), size - 1);
+            float4 value = currentTex.read(uint2(p));
+            minValue = min(minValue, value);
+            maxValue = max(maxValue, value);
+        }
+    }
+    float4 history = clamp(historyTex.sample(linearSampler, prevUV), minValue, maxValue);
+    outTex.write(mix(current, history, params.settings2.w), gid);
+}
+
+// Scene color at the pixel plus its resolved screen-space reflection. A few taps of the
+// half-resolution accumulation, spread wider on rougher surfaces and weighted by depth similarity,
+// form the spatial part of the resolve.
+static inline float3 shadeSSR(
+    float2 pixelUV,
+    float depth,
+    float3 current,
+    constant CameraUniforms& camera,
+    constant SSRParams& params,
+    depth2d<float> depthTex,
+    texture2d<float> normalTex,
+    texture2d<float> reflectionTex,
+    sampler sourceSampler
+) {
+    if (depth >= 1.0) {
+        return current;
+    }
+
+    float4 normalSample = normalTex.sample(sourceSampler, pixelUV);
+    float roughness = decodeTargetRoughness(normalSample);
+    float maxRoughness = params.settings1.y;
+    if (maxRoughness <= 0.0 || roughness > maxRoughness) {
+        return current;
+    }
+    float3 viewPos = reconstructViewPosition(pixelUV, depth, camera);
+    float3 normalVS = decodeTargetNormal(normalSample);
+    float3 viewDir = normalize(viewPos);
+    float3 reflDir = reflect(viewDir, normalVS);
+    if (reflDir.z > -0.01) {
+        return current;
+    }
+
+    const float2 taps[5] = { float2(0.0), float2(1.0, 0.5), float2(-0.5, 1.0), float2(-1.0, -0.5), float2(0.5, -1.0) };
+    float2 reflectionTexel = 1.0 / float2(reflectionTex.get_width(), reflectionTex.get_height());
+    float radius = 1.0 + roughness * 3.0;
+    float centerDepth = -viewPos.z;
+    float4 reflection = float4(0.0);
+    float weightSum = 0.0;
+    for (int i = 0; i < 5; ++i) {
+        float2 uv = pixelUV + taps[i] * radius * reflectionTexel;
+        float tapDepth = linearizeDepth(depthTex.sample(sourceSampler, uv), camera);
+        float w = exp(-abs(tapDepth - centerDepth) / max(centerDepth * 0.02, 0.01));
+        reflection += reflectionTex.sample(sourceSampler, uv) * w;
+        weightSum += w;
+    }
+    reflection /= max(weightSum, 0.0001);
+
+    float fresnel = pow(1.0 - saturate(dot(normalVS, normalize(-viewDir))), 5.0);
     float roughnessScale = saturate((maxRoughness - roughness) / max(maxRoughness, 0.0001));
-    float dist = length(hitView - viewPos);
-    float distFade = saturate(1.0 - dist / max(params.settings1.w, 0.0001));
     float grazingFade = saturate((-reflDir.z - 0.05) / 0.2);
-    float weight = hit * fresnel * edgeFade * distFade * roughnessScale * grazingFade;
+    return current + reflection.rgb * (fresnel * roughnessScale * grazingFade);
+}
 
-    float3 color = current + reflection * weight;
+fragment float4 ssr_fragment(
+    BlitVertexOut in [[stage_in]],
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant SSRParams& params [[buffer(1)]],
+    texture2d<float> sceneTex [[texture(0)]],
+    depth2d<float> depthTex [[texture(1)]],
+    texture2d<float> normalTex [[texture(2)]],
+    texture2d<float> reflectionTex [[texture(4)]],
+    sampler sourceSampler [[sampler(0)]]
+) {
+    float depth = depthTex.sample(sourceSampler, in.uv);
+    float3 current = sceneTex.sample(sourceSampler, in.uv).rgb;
+    float3 color = shadeSSR(in.uv, depth, current, camera, params, depthTex, normalTex, reflectionTex, sourceSampler);
     return float4(color, 1.0);
 }
 
@@ -2010,8 +3714,31 @@ struct DecalOut {
     float4 orm [[color(2)]];
 };
 
+struct DecalVertexOut {
+    float4 position [[position]];
+};
+
+// The decal's unit box, outward faces counter-clockwise. The pass culls front faces, so each pixel
+// is shaded once through the box's far side, also with the camera inside the box.
+constant ushort kDecalBoxIndices[36] = {
+    0, 4, 6, 0, 6, 2, 1, 3, 7, 1, 7, 5, 0, 1, 5, 0, 5, 4,
+    2, 6, 7, 2, 7, 3, 0, 2, 3, 0, 3, 1, 4, 5, 7, 4, 7, 6
+};
+
+vertex DecalVertexOut decal_box_vertex(
+    uint vertexId [[vertex_id]],
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant DecalParams& decal [[buffer(1)]]
+) {
+    ushort corner = kDecalBoxIndices[vertexId];
+    float3 local = float3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) - 0.5;
+    DecalVertexOut out;
+    out.position = camera.viewProjectionMatrix * (decal.modelMatrix * float4(local, 1.0));
+    return out;
+}
+
 fragment DecalOut decal_fragment(
-    BlitVertexOut in [[stage_in]],
+    DecalVertexOut in [[stage_in]],
     constant CameraUniforms& camera [[buffer(0)]],
     constant DecalParams& decal [[buffer(1)]],
     depth2d<float> depthTex [[texture(0)]],
@@ -2026,12 +3753,13 @@ fragment DecalOut decal_fragment(
     out.normal = float4(0.0);
     out.orm = float4(0.0);
 
-    float depth = depthTex.sample(decalSampler, in.uv);
+    float2 screenUV = in.position.xy * decal.edgeParams.yz;
+    float depth = depthTex.sample(decalSampler, screenUV);
     if (depth >= 1.0) {
         return out;
     }
 
-    float3 viewPos = reconstructViewPosition(in.uv, depth, camera);
+    float3 viewPos = reconstructViewPosition(screenUV, depth, camera);
     float3 worldPos = (camera.viewMatrixInverse * float4(viewPos, 1.0)).xyz;
     float3 local = (decal.invModel * float4(worldPos, 1.0)).xyz;
     float3 absLocal = abs(local);
@@ -2148,51 +3876,274 @@ fragment float4 taa_fragment(
     float speedPx = length(velocity / texel);
     float motionFactor = saturate(1.0 - speedPx * 0.15);
     float stabilized = mix(feedback, 0.28, motionFactor);
-    float prevDepth = depthTex.sample(sourceSampler, prevUV);
+    float prevDepth = depthTex.sample(sourceSampler, prevUV);
+    float currentLinear = linearizeDepth(depth, camera);
+    float prevLinear = (prevDepth < 1.0) ? linearizeDepth(prevDepth, camera) : currentLinear + 1e6;
+    float depthThreshold = max(params.params1.z * max(currentLinear, 1.0), 0.02);
+    float depthDiff = abs(prevLinear - currentLinear);
+    float depthWeight = 1.0 - smoothstep(0.0, depthThreshold, depthDiff);
+    float4 normalNowSample = normalTex.sample(sourceSampler, in.uv);
+    float4 normalPrevSample = normalTex.sample(sourceSampler, prevUV);
+    float3 normalNow = decodeTargetNormal(normalNowSample);
+    float3 normalPrev = decodeTargetNormal(normalPrevSample);
+    float normalDot = clamp(dot(normalNow, normalPrev), 0.0, 1.0);
+    float normalWeight = smoothstep(params.params1.w, 1.0, normalDot);
+    float roughnessNow = decodeTargetRoughness(normalNowSample);
+    float roughnessPrev = decodeTargetRoughness(normalPrevSample);
+    float roughnessMax = max(roughnessNow, roughnessPrev);
+    float roughnessWeight = smoothstep(0.12, 0.45, min(roughnessNow, roughnessPrev));
+    float roughnessDelta = abs(roughnessNow - roughnessPrev);
+    float glossyFactor = 1.0 - smoothstep(0.05, 0.35, roughnessMax);
+    float specularStabilityEnabled = params.params2.x;
+    float specularStabilityStrength = clamp(params.params2.y, 0.0, 2.0);
+    float specularStability = 0.0;
+    if (specularStabilityEnabled > 0.5) {
+        float roughnessConsistency = 1.0 - smoothstep(0.03, 0.18, roughnessDelta);
+        specularStability = glossyFactor * motionFactor * depthWeight * normalWeight * roughnessConsistency;
+        specularStability *= saturate(specularStabilityStrength);
+    }
+    float3 sigma = sqrt(max(sqMeanC - meanC * meanC, float3(0.0))) * 1.25;
+    float clipScale = mix(1.0, 1.65, specularStability);
+    float3 clipMin = max(minC, meanC - sigma * clipScale);
+    float3 clipMax = min(maxC, meanC + sigma * clipScale);
+    history = clamp(history, clipMin, clipMax);
+    float currLuma = luminance709(current);
+    float histLuma = luminance709(history);
+    float lumaDelta = abs(currLuma - histLuma) / max(max(currLuma, histLuma), 0.2);
+    float lumaWeight = 1.0 - smoothstep(0.05, 0.35, lumaDelta);
+    float specularLumaWeight = 1.0 - smoothstep(0.02, 0.18, lumaDelta);
+    float baseFeedback = stabilized * depthWeight * normalWeight * roughnessWeight * lumaWeight;
+    float specularFeedback = (0.18 + 0.22 * motionFactor) * specularStability * specularLumaWeight;
+    feedback = max(baseFeedback, specularFeedback);
+    feedback = clamp(feedback, 0.0, 0.92);
+    float3 color = mix(current, history, feedback);
+    float sharpness = clamp(params.params1.x, 0.0, 1.0);
+    sharpness *= 1.0 - 0.45 * specularStability;
+    color = mix(color, current, sharpness);
+    return float4(color, 1.0);
+}
+
+// Compute TAA. Each threadgroup resolves a 16x16 tile: the tile, its 1-pixel sharpening apron and
+// their 3x3 neighbourhoods are loaded into threadgroup memory once (color in YCoCg with depth, and
+// velocity), the resolve clips history against the neighbourhood's variance box in YCoCg and
+// reprojects with the velocity of the closest depth in it, and the optional RCAS-style sharpening
+// reads the resolved apron from threadgroup memory. History keeps the unsharpened resolve; the
+// sharpened copy goes to its own target for the post chain. taa_fragment remains the fallback.
+constant uint kTaaTileSize = 16;
+constant uint kTaaResolveSide = kTaaTileSize + 2;
+constant uint kTaaLoadSide = kTaaTileSize + 4;
+
+inline float3 rgbToYCoCg(float3 c) {
+    return float3(0.25 * c.r + 0.5 * c.g + 0.25 * c.b,
+                  0.5 * c.r - 0.5 * c.b,
+                  -0.25 * c.r + 0.5 * c.g - 0.25 * c.b);
+}
+
+inline float3 yCoCgToRgb(float3 c) {
+    return float3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+// Pulls history towards the box's center until it lies inside, rather than clamping per channel,
+// so clipped history keeps its hue.
+inline float3 clipToBox(float3 history, float3 boxMin, float3 boxMax) {
+    float3 center = 0.5 * (boxMax + boxMin);
+    float3 extent = 0.5 * (boxMax - boxMin) + 1e-5;
+    float3 offset = history - center;
+    float3 units = abs(offset / extent);
+    float outside = max(units.x, max(units.y, units.z));
+    return (outside > 1.0) ? center + offset / outside : history;
+}
+
+// RCAS works on [0, 1]; this tonemap is inverted exactly after sharpening.
+inline float3 taaCompress(float3 c) {
+    return c / (1.0 + max(c.r, max(c.g, c.b)));
+}
+
+inline float3 taaDecompress(float3 c) {
+    return c / max(1.0 - max(c.r, max(c.g, c.b)), 1e-4);
+}
+
+static float3 taaResolvePixel(
+    uint2 pixel,
+    uint2 load,
+    constant CameraUniforms& camera,
+    constant TAAParams& params,
+    texture2d<float> historyTex,
+    depth2d<float> depthTex,
+    texture2d<float> normalTex,
+    sampler sourceSampler,
+    threadgroup const float4* colorDepth,
+    threadgroup const float2* velocities
+) {
+    float4 centerSample = colorDepth[load.y * kTaaLoadSide + load.x];
+    float3 currentY = centerSample.rgb;
+    float3 current = yCoCgToRgb(currentY);
+    float depth = centerSample.a;
+    if (params.params0.w < 0.5 || depth >= 1.0) {
+        return current;
+    }
+
+    // Neighbourhood moments and the closest depth, all from threadgroup memory.
+    float3 minC = currentY;
+    float3 maxC = currentY;
+    float3 meanC = float3(0.0);
+    float3 sqMeanC = float3(0.0);
+    float closestDepth = depth;
+    uint closest = load.y * kTaaLoadSide + load.x;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            uint index = uint(int(load.y) + y) * kTaaLoadSide + uint(int(load.x) + x);
+            float4 s = colorDepth[index];
+            minC = min(minC, s.rgb);
+            maxC = max(maxC, s.rgb);
+            meanC += s.rgb;
+            sqMeanC += s.rgb * s.rgb;
+            if (s.a < closestDepth) {
+                closestDepth = s.a;
+                closest = index;
+            }
+        }
+    }
+    meanC *= (1.0 / 9.0);
+    sqMeanC *= (1.0 / 9.0);
+
+    float2 texel = max(params.params0.xy, float2(0.000001));
+    float2 uv = (float2(pixel) + 0.5) * texel;
+    float2 prevUV;
+    float2 velocity;
+    if (params.params1.y > 0.5) {
+        // Velocity of the closest neighbour, so edges of moving objects reproject with the object.
+        velocity = velocities[closest];
+        prevUV = uv - velocity;
+    } else {
+        float3 viewPos = reconstructViewPosition(uv, depth, camera);
+        float4 worldPos = camera.viewMatrixInverse * float4(viewPos, 1.0);
+        float4 prevClip = params.prevViewProjection * worldPos;
+        if (prevClip.w <= 0.0001) {
+            return current;
+        }
+        float2 prevNdc = prevClip.xy / prevClip.w;
+        prevUV = float2(prevNdc.x * 0.5 + 0.5, 1.0 - (prevNdc.y * 0.5 + 0.5));
+        velocity = uv - prevUV;
+    }
+    if (prevUV.x < 0.0 || prevUV.x > 1.0 || prevUV.y < 0.0 || prevUV.y > 1.0) {
+        return current;
+    }
+
+    float3 history = rgbToYCoCg(historyTex.sample(sourceSampler, prevUV, level(0.0)).rgb);
+
+    float feedback = clamp(params.params0.z, 0.02, 0.25);
+    float speedPx = length(velocity / texel);
+    float motionFactor = saturate(1.0 - speedPx * 0.15);
+    float stabilized = mix(feedback, 0.28, motionFactor);
+    float prevDepth = depthTex.sample(sourceSampler, prevUV, level(0.0));
     float currentLinear = linearizeDepth(depth, camera);
     float prevLinear = (prevDepth < 1.0) ? linearizeDepth(prevDepth, camera) : currentLinear + 1e6;
     float depthThreshold = max(params.params1.z * max(currentLinear, 1.0), 0.02);
-    float depthDiff = abs(prevLinear - currentLinear);
-    float depthWeight = 1.0 - smoothstep(0.0, depthThreshold, depthDiff);
-    float4 normalNowSample = normalTex.sample(sourceSampler, in.uv);
-    float4 normalPrevSample = normalTex.sample(sourceSampler, prevUV);
-    float3 normalNow = normalize(normalNowSample.xyz * 2.0 - 1.0);
-    float3 normalPrev = normalize(normalPrevSample.xyz * 2.0 - 1.0);
-    float normalDot = clamp(dot(normalNow, normalPrev), 0.0, 1.0);
-    float normalWeight = smoothstep(params.params1.w, 1.0, normalDot);
-    float roughnessNow = clamp(normalNowSample.w, 0.0, 1.0);
-    float roughnessPrev = clamp(normalPrevSample.w, 0.0, 1.0);
-    float roughnessMax = max(roughnessNow, roughnessPrev);
+    float depthWeight = 1.0 - smoothstep(0.0, depthThreshold, abs(prevLinear - currentLinear));
+    float4 normalNowSample = normalTex.sample(sourceSampler, uv, level(0.0));
+    float4 normalPrevSample = normalTex.sample(sourceSampler, prevUV, level(0.0));
+    float3 normalNow = decodeTargetNormal(normalNowSample);
+    float3 normalPrev = decodeTargetNormal(normalPrevSample);
+    float normalWeight = smoothstep(params.params1.w, 1.0, clamp(dot(normalNow, normalPrev), 0.0, 1.0));
+    float roughnessNow = decodeTargetRoughness(normalNowSample);
+    float roughnessPrev = decodeTargetRoughness(normalPrevSample);
     float roughnessWeight = smoothstep(0.12, 0.45, min(roughnessNow, roughnessPrev));
-    float roughnessDelta = abs(roughnessNow - roughnessPrev);
-    float glossyFactor = 1.0 - smoothstep(0.05, 0.35, roughnessMax);
-    float specularStabilityEnabled = params.params2.x;
-    float specularStabilityStrength = clamp(params.params2.y, 0.0, 2.0);
+    float glossyFactor = 1.0 - smoothstep(0.05, 0.35, max(roughnessNow, roughnessPrev));
     float specularStability = 0.0;
-    if (specularStabilityEnabled > 0.5) {
-        float roughnessConsistency = 1.0 - smoothstep(0.03, 0.18, roughnessDelta);
+    if (params.params2.x > 0.5) {
+        float roughnessConsistency = 1.0 - smoothstep(0.03, 0.18, abs(roughnessNow - roughnessPrev));
         specularStability = glossyFactor * motionFactor * depthWeight * normalWeight * roughnessConsistency;
-        specularStability *= saturate(specularStabilityStrength);
+        specularStability *= saturate(clamp(params.params2.y, 0.0, 2.0));
     }
+
     float3 sigma = sqrt(max(sqMeanC - meanC * meanC, float3(0.0))) * 1.25;
     float clipScale = mix(1.0, 1.65, specularStability);
-    float3 clipMin = max(minC, meanC - sigma * clipScale);
-    float3 clipMax = min(maxC, meanC + sigma * clipScale);
-    history = clamp(history, clipMin, clipMax);
-    float currLuma = luminance709(current);
-    float histLuma = luminance709(history);
-    float lumaDelta = abs(currLuma - histLuma) / max(max(currLuma, histLuma), 0.2);
+    history = clipToBox(history, max(minC, meanC - sigma * clipScale), min(maxC, meanC + sigma * clipScale));
+
+    // Y is the luma of YCoCg.
+    float lumaDelta = abs(currentY.x - history.x) / max(max(currentY.x, history.x), 0.2);
     float lumaWeight = 1.0 - smoothstep(0.05, 0.35, lumaDelta);
     float specularLumaWeight = 1.0 - smoothstep(0.02, 0.18, lumaDelta);
     float baseFeedback = stabilized * depthWeight * normalWeight * roughnessWeight * lumaWeight;
     float specularFeedback = (0.18 + 0.22 * motionFactor) * specularStability * specularLumaWeight;
-    feedback = max(baseFeedback, specularFeedback);
-    feedback = clamp(feedback, 0.0, 0.92);
-    float3 color = mix(current, history, feedback);
-    float sharpness = clamp(params.params1.x, 0.0, 1.0);
-    sharpness *= 1.0 - 0.45 * specularStability;
-    color = mix(color, current, sharpness);
-    return float4(color, 1.0);
+    feedback = clamp(max(baseFeedback, specularFeedback), 0.0, 0.92);
+    return max(yCoCgToRgb(mix(currentY, history, feedback)), float3(0.0));
+}
+
+kernel void taa_resolve(
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant TAAParams& params [[buffer(1)]],
+    texture2d<float> currentTex [[texture(0)]],
+    texture2d<float> historyTex [[texture(1)]],
+    depth2d<float> depthTex [[texture(2)]],
+    texture2d<float> velocityTex [[texture(3)]],
+    texture2d<float> normalTex [[texture(4)]],
+    texture2d<float, access::write> historyOut [[texture(5)]],
+    texture2d<float, access::write> sharpenedOut [[texture(6)]],
+    sampler sourceSampler [[sampler(0)]],
+    uint2 tgid [[threadgroup_position_in_grid]],
+    uint2 lid [[thread_position_in_threadgroup]],
+    uint lindex [[thread_index_in_threadgroup]]
+) {
+    threadgroup float4 colorDepth[kTaaLoadSide * kTaaLoadSide];
+    threadgroup float2 velocities[kTaaLoadSide * kTaaLoadSide];
+    threadgroup float4 resolved[kTaaResolveSide * kTaaResolveSide];
+
+    const int2 size = int2(currentTex.get_width(), currentTex.get_height());
+    const int2 tileOrigin = int2(tgid * kTaaTileSize);
+    const int2 loadOrigin = tileOrigin - 2;
+    const bool useVelocity = params.params1.y > 0.5;
+    const bool sharpen = params.params2.z > 0.0;
+    const uint threadCount = kTaaTileSize * kTaaTileSize;
+
+    for (uint i = lindex; i < kTaaLoadSide * kTaaLoadSide; i += threadCount) {
+        uint2 coord = uint2(clamp(loadOrigin + int2(i % kTaaLoadSide, i / kTaaLoadSide), int2(0), size - 1));
+        colorDepth[i] = float4(rgbToYCoCg(currentTex.read(coord).rgb), depthTex.read(coord));
+        velocities[i] = useVelocity ? velocityTex.read(coord).rg : float2(0.0);
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    // The tile, plus the apron around it when sharpening reads it.
+    const uint apron = sharpen ? 1u : 0u;
+    const uint side = kTaaTileSize + 2 * apron;
+    for (uint i = lindex; i < side * side; i += threadCount) {
+        uint2 r = uint2(i % side, i / side) + (1u - apron);
+        int2 pixel = clamp(tileOrigin - 1 + int2(r), int2(0), size - 1);
+        uint2 load = uint2(pixel - loadOrigin);
+        float3 color = taaResolvePixel(uint2(pixel), load, camera, params, historyTex, depthTex, normalTex,
+                                       sourceSampler, colorDepth, velocities);
+        resolved[r.y * kTaaResolveSide + r.x] = float4(color, 1.0);
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    uint2 pixel = uint2(tileOrigin) + lid;
+    if (int(pixel.x) >= size.x || int(pixel.y) >= size.y) {
+        return;
+    }
+    uint center = (lid.y + 1) * kTaaResolveSide + (lid.x + 1);
+    float3 color = resolved[center].rgb;
+    historyOut.write(float4(color, 1.0), pixel);
+    if (!sharpen) {
+        return;
+    }
+
+    // RCAS: the strongest negative lobe that keeps the cross of neighbours inside [0, 1], scaled
+    // by the sharpness.
+    float3 e = taaCompress(color);
+    float3 b = taaCompress(resolved[center - kTaaResolveSide].rgb);
+    float3 d = taaCompress(resolved[center - 1].rgb);
+    float3 f = taaCompress(resolved[center + 1].rgb);
+    float3 h = taaCompress(resolved[center + kTaaResolveSide].rgb);
+    float3 minRing = min(min(b, d), min(f, h));
+    float3 maxRing = max(max(b, d), max(f, h));
+    float3 hitMin = minRing / max(4.0 * maxRing, float3(1e-4));
+    float3 hitMax = (1.0 - maxRing) / min(4.0 * minRing - 4.0, float3(-1e-4));
+    float3 lobeRGB = max(-hitMin, hitMax);
+    const float rcasLimit = 0.25 - 1.0 / 16.0;
+    float lobe = max(-rcasLimit, min(max(lobeRGB.r, max(lobeRGB.g, lobeRGB.b)), 0.0)) * params.params2.z;
+    float3 sharpened = (lobe * (b + d + f + h) + e) / (4.0 * lobe + 1.0);
+    sharpenedOut.write(float4(taaDecompress(clamp(sharpened, 0.0, 0.999)), 1.0), pixel);
 }
 
 fragment float4 motion_blur_fragment(
@@ -2322,6 +4273,33 @@ fragment float4 dof_fragment(
     return float4(color, 1.0);
 }
 
+// Last frame's froxel at worldPos, if it was inside the previous view's volume.
+static inline bool reprojectFogHistory(
+    float3 worldPos,
+    float nearPlane,
+    float farPlane,
+    constant FogParams& params,
+    texture3d<float, access::sample> historyTex,
+    sampler linearSampler,
+    thread float4& previous
+) {
+    float logDepth = log(farPlane / nearPlane);
+    float4 prevClip = params.prevViewProjection * float4(worldPos, 1.0);
+    float3 prevViewPos = (params.prevViewMatrix * float4(worldPos, 1.0)).xyz;
+    if (prevClip.w <= 0.0001 || prevViewPos.z >= -nearPlane || logDepth <= 0.0001) {
+        return false;
+    }
+    float2 prevNdc = prevClip.xy / prevClip.w;
+    float2 prevUv = float2(prevNdc.x * 0.5 + 0.5, 0.5 - prevNdc.y * 0.5);
+    float prevViewZ = max(-prevViewPos.z, nearPlane);
+    float prevSlice = log(prevViewZ / nearPlane) / logDepth;
+    if (any(prevUv < float2(0.0)) || any(prevUv > float2(1.0)) || prevSlice < 0.0 || prevSlice > 1.0) {
+        return false;
+    }
+    previous = historyTex.sample(linearSampler, float3(prevUv, prevSlice));
+    return true;
+}
+
 kernel void fog_volume_build(
     texture3d<float, access::write> volumeTex [[texture(0)]],
     texture3d<float, access::sample> historyTex [[texture(1)]],
@@ -2357,6 +4335,20 @@ kernel void fog_volume_build(
     float3 viewPos = viewDir * rayDepth;
     float3 worldPos = (camera.viewMatrixInverse * float4(viewPos, 1.0)).xyz;
 
+    // Interleaved updates: only one froxel in each 2 or 4 is lit this frame, the rest carry
+    // their reprojected history forward. Froxels that were off-screen last frame are always lit.
+    uint interleave = uint(params.updateParams.x);
+    if (interleave > 1 && params.misc.z > 0.5) {
+        uint phase = uint(params.updateParams.y);
+        uint cell = interleave == 2 ? ((tid.x + tid.y + tid.z) & 1u)
+                                    : (((tid.x & 1u) + ((tid.y & 1u) << 1) + tid.z) & 3u);
+        float4 carried;
+        if (cell != phase && reprojectFogHistory(worldPos, nearPlane, farPlane, params, historyTex, linearSampler, carried)) {
+            volumeTex.write(carried, tid);
+            return;
+        }
+    }
+
     float startDist = max(params.distanceParams.x, 0.0);
     float endDist = max(params.distanceParams.y, startDist + 0.001);
     float distanceFadeIn = smoothstep(startDist, startDist + max(1.0, startDist * 0.1 + 2.0), rayDepth);
@@ -2442,21 +4434,8 @@ kernel void fog_volume_build(
     float4 current = float4(scattering, extinction);
     float historyWeight = clamp(params.volumeParams.w, 0.0, 0.98);
     if (params.misc.z > 0.5 && historyWeight > 0.0) {
-        float logDepth = log(farPlane / nearPlane);
         float4 previous = current;
-        bool hasHistorySample = false;
-        float4 prevClip = params.prevViewProjection * float4(worldPos, 1.0);
-        float3 prevViewPos = (params.prevViewMatrix * float4(worldPos, 1.0)).xyz;
-        if (prevClip.w > 0.0001 && prevViewPos.z < -nearPlane && logDepth > 0.0001) {
-            float2 prevNdc = prevClip.xy / prevClip.w;
-            float2 prevUv = float2(prevNdc.x * 0.5 + 0.5, 0.5 - prevNdc.y * 0.5);
-            float prevViewZ = max(-prevViewPos.z, nearPlane);
-            float prevSlice = log(prevViewZ / nearPlane) / logDepth;
-            if (all(prevUv >= float2(0.0)) && all(prevUv <= float2(1.0)) && prevSlice >= 0.0 && prevSlice <= 1.0) {
-                previous = historyTex.sample(linearSampler, float3(prevUv, prevSlice));
-                hasHistorySample = true;
-            }
-        }
+        bool hasHistorySample = reprojectFogHistory(worldPos, nearPlane, farPlane, params, historyTex, linearSampler, previous);
 
         if (hasHistorySample) {
         float4 lowClamp = current * float4(0.65, 0.65, 0.65, 0.7);
@@ -2475,18 +4454,16 @@ kernel void fog_volume_build(
     volumeTex.write(current, tid);
 }
 
-fragment float4 fog_fragment(
-    BlitVertexOut in [[stage_in]],
-    constant CameraUniforms& camera [[buffer(0)]],
-    constant FogParams& params [[buffer(1)]],
-    texture2d<float> sceneTex [[texture(0)]],
-    depth2d<float> depthTex [[texture(1)]],
-    texture3d<float> volumeTex [[texture(2)]],
-    sampler sourceSampler [[sampler(0)]]
+// Scene color at the pixel seen through the froxel fog volume up to its depth.
+static inline float3 applyVolumetricFog(
+    float2 pixelUV,
+    float depth,
+    float3 current,
+    constant CameraUniforms& camera,
+    constant FogParams& params,
+    texture3d<float> volumeTex,
+    sampler sourceSampler
 ) {
-    float3 current = sceneTex.sample(sourceSampler, in.uv).rgb;
-    float depth = depthTex.sample(sourceSampler, in.uv);
-
     float startDist = max(params.distanceParams.x, 0.0);
     float endDist = max(params.distanceParams.y, startDist + 0.001);
     float nearPlane = max(params.volumeParams.x, 0.001);
@@ -2494,22 +4471,22 @@ fragment float4 fog_fragment(
     float sliceCount = max(params.volumeParams.z, 1.0);
     float logDepth = log(farPlane / nearPlane);
     if (logDepth <= 0.0001) {
-        return float4(current, 1.0);
+        return current;
     }
 
     float distance = min(endDist, farPlane);
     if (depth < 1.0) {
-        float3 viewPos = reconstructViewPosition(in.uv, depth, camera);
+        float3 viewPos = reconstructViewPosition(pixelUV, depth, camera);
         distance = min(length(viewPos), distance);
     }
 
     float segmentStart = clamp(startDist, 0.0, distance);
     float segmentEnd = clamp(endDist, segmentStart, distance);
     if (segmentEnd <= segmentStart + 0.0001) {
-        return float4(current, 1.0);
+        return current;
     }
 
-    float2 ndc = uvToNdc(in.uv);
+    float2 ndc = uvToNdc(pixelUV);
     float4 clip = float4(ndc, 1.0, 1.0);
     float4 view = camera.projectionMatrixNoJitterInverse * clip;
     float3 viewDir = normalize(view.xyz / max(view.w, 0.0001));
@@ -2530,7 +4507,7 @@ fragment float4 fog_fragment(
         float viewZ = max(dist * viewZScale, nearPlane);
         float slice = log(viewZ / nearPlane) / logDepth;
         float w = clamp(slice, 0.0, 1.0);
-        float3 uvw = float3(in.uv, w);
+        float3 uvw = float3(pixelUV, w);
         float4 fogSample = volumeTex.sample(sourceSampler, uvw);
         float3 scattering = fogSample.rgb;
         float extinction = max(fogSample.a, 0.000001);
@@ -2541,42 +4518,120 @@ fragment float4 fog_fragment(
         transmittance *= att;
     }
 
-    float3 color = current * transmittance + accum;
+    return current * transmittance + accum;
+}
+
+fragment float4 fog_fragment(
+    BlitVertexOut in [[stage_in]],
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant FogParams& params [[buffer(1)]],
+    texture2d<float> sceneTex [[texture(0)]],
+    depth2d<float> depthTex [[texture(1)]],
+    texture3d<float> volumeTex [[texture(2)]],
+    sampler sourceSampler [[sampler(0)]]
+) {
+    float3 current = sceneTex.sample(sourceSampler, in.uv).rgb;
+    float depth = depthTex.sample(sourceSampler, in.uv);
+    float3 color = applyVolumetricFog(in.uv, depth, current, camera, params, volumeTex, sourceSampler);
+    return float4(color, 1.0);
+}
+
+// SSR and the fog apply both only change the pixel they shade, so when both run they share one
+// full-screen pass instead of round-tripping the SSR result through memory.
+fragment float4 ssr_fog_fragment(
+    BlitVertexOut in [[stage_in]],
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant SSRParams& ssrParams [[buffer(1)]],
+    constant FogParams& fogParams [[buffer(2)]],
+    texture2d<float> sceneTex [[texture(0)]],
+    depth2d<float> depthTex [[texture(1)]],
+    texture2d<float> normalTex [[texture(2)]],
+    texture3d<float> volumeTex [[texture(3)]],
+    texture2d<float> reflectionTex [[texture(4)]],
+    sampler sourceSampler [[sampler(0)]]
+) {
+    float depth = depthTex.sample(sourceSampler, in.uv);
+    float3 current = sceneTex.sample(sourceSampler, in.uv).rgb;
+    float3 color = shadeSSR(in.uv, depth, current, camera, ssrParams, depthTex, normalTex, reflectionTex, sourceSampler);
+    color = applyVolumetricFog(in.uv, depth, color, camera, fogParams, volumeTex, sourceSampler);
     return float4(color, 1.0);
 }
 
-static inline uint probe_volume_index(uint x, uint y, uint z, uint3 counts) {
-    return z * counts.x * counts.y + y * counts.x + x;
+// The probe buffer opens with ProbeVolumeData.hpp's indirection table, one word per cell of
+// probeVolume.gridCounts: the first probe of the cell's dense 4x4x4 brick with the top bit set,
+// or else the first probe of the coarse grid on the cell corners.
+struct ProbeBrickLookup {
+    uint corners[8];
+    float3 frac;
+    float3 spacing; // world distance between the probes interpolated
+};
+
+static inline ProbeBrickLookup probe_brick_lookup(const device ProbeAmbientCubeData* probes,
+                                                  constant ProbeVolumeUniforms& probeVolume,
+                                                  float3 worldPosition) {
+    uint3 counts = uint3(max(probeVolume.gridCounts.xyz + 0.5, float3(1.0)));
+    float3 extent = max(probeVolume.boundsMax.xyz - probeVolume.boundsMin.xyz, float3(0.001));
+    float3 cellPosition = clamp((worldPosition - probeVolume.boundsMin.xyz) / extent, 0.0, 1.0) * float3(counts);
+    uint3 cell = min(uint3(cellPosition), counts - 1u);
+    float3 local = saturate(cellPosition - float3(cell));
+
+    const device uint* indirection = reinterpret_cast<const device uint*>(probes);
+    uint entry = indirection[(cell.z * counts.y + cell.y) * counts.x + cell.x];
+    uint first = entry & 0x7FFFFFFFu;
+
+    ProbeBrickLookup lookup;
+    uint3 base;
+    uint3 stride;
+    if ((entry & 0x80000000u) != 0u) {
+        float3 grid = local * 3.0;
+        base = min(uint3(grid), uint3(2u));
+        stride = uint3(1u, 4u, 16u);
+        lookup.frac = saturate(grid - float3(base));
+        lookup.spacing = extent / (float3(counts) * 3.0);
+    } else {
+        base = cell;
+        stride = uint3(1u, counts.x + 1u, (counts.x + 1u) * (counts.y + 1u));
+        lookup.frac = local;
+        lookup.spacing = extent / float3(counts);
+    }
+    for (uint corner = 0; corner < 8u; ++corner) {
+        uint3 probe = base + uint3(corner & 1u, (corner >> 1) & 1u, (corner >> 2) & 1u);
+        lookup.corners[corner] = first + probe.x * stride.x + probe.y * stride.y + probe.z * stride.z;
+    }
+    return lookup;
+}
+
+static inline float3 decode_rgb9e5(uint packed) {
+    float scale = exp2(float(packed >> 27) - 24.0);
+    return float3(packed & 0x1FFu, (packed >> 9) & 0x1FFu, (packed >> 18) & 0x1FFu) * scale;
+}
+
+// Only the three faces facing the direction are decoded.
+static inline float3 sample_packed_cube(const device uint* faces, float3 direction) {
+    float3 dir = normalize(direction);
+    float3 sq = dir * dir;
+    float3 result = decode_rgb9e5(faces[dir.x >= 0.0 ? 0 : 1]) * sq.x;
+    result += decode_rgb9e5(faces[dir.y >= 0.0 ? 2 : 3]) * sq.y;
+    result += decode_rgb9e5(faces[dir.z >= 0.0 ? 4 : 5]) * sq.z;
+    return result;
 }
 
 static inline float3 sample_probe_ambient_cube(const device ProbeAmbientCubeData& probe, float3 normal) {
-    float3 n = normalize(normal);
-    float3 sq = n * n;
-    float3 result = float3(0.0);
-    result += (n.x >= 0.0 ? probe.px.rgb : probe.nx.rgb) * sq.x;
-    result += (n.y >= 0.0 ? probe.py.rgb : probe.ny.rgb) * sq.y;
-    result += (n.z >= 0.0 ? probe.pz.rgb : probe.nz.rgb) * sq.z;
-    return max(result, float3(0.0));
+    return sample_packed_cube(probe.ambientCube, normal);
 }
 
 static inline float sample_probe_visibility_cube(const device ProbeAmbientCubeData& probe, float3 direction) {
     float3 dir = normalize(direction);
     float3 sq = dir * dir;
     float result = 0.0;
-    result += (dir.x >= 0.0 ? probe.visibility0.x : probe.visibility0.y) * sq.x;
-    result += (dir.y >= 0.0 ? probe.visibility0.z : probe.visibility0.w) * sq.y;
-    result += (dir.z >= 0.0 ? probe.visibility1.x : probe.visibility1.y) * sq.z;
+    result += float(dir.x >= 0.0 ? probe.visibility0.x : probe.visibility0.y) * sq.x;
+    result += float(dir.y >= 0.0 ? probe.visibility0.z : probe.visibility0.w) * sq.y;
+    result += float(dir.z >= 0.0 ? probe.visibility1.x : probe.visibility1.y) * sq.z;
     return max(result, 0.0);
 }
 
 static inline float3 sample_probe_specular_cube(const device ProbeAmbientCubeData& probe, float3 direction) {
-    float3 dir = normalize(direction);
-    float3 sq = dir * dir;
-    float3 result = float3(0.0);
-    result += (dir.x >= 0.0 ? probe.specularPx.rgb : probe.specularNx.rgb) * sq.x;
-    result += (dir.y >= 0.0 ? probe.specularPy.rgb : probe.specularNy.rgb) * sq.y;
-    result += (dir.z >= 0.0 ? probe.specularPz.rgb : probe.specularNz.rgb) * sq.z;
-    return max(result, float3(0.0));
+    return sample_packed_cube(probe.specularCube, direction);
 }
 
 static inline float3 sample_probe_specular_filtered_cube(const device ProbeAmbientCubeData& probe,
@@ -2634,10 +4689,10 @@ static inline float compute_probe_directional_occlusion(const device ProbeAmbien
     return mix(0.2, 1.0, softened);
 }
 
-static inline float3 parallax_correct_probe_direction(const device ProbeAmbientCubeData& probe,
-                                                      constant ProbeVolumeUniforms& probeVolume,
-                                                      float3 worldPosition,
-                                                      float3 reflectionDirection) {
+static inline float3 parallax_correct_direction(float3 capturePosition,
+                                                constant ProbeVolumeUniforms& probeVolume,
+                                                float3 worldPosition,
+                                                float3 reflectionDirection) {
     float3 dir = normalize(reflectionDirection);
     if (probeVolume.featureParams.w < 0.5) {
         return dir;
@@ -2651,13 +4706,20 @@ static inline float3 parallax_correct_probe_direction(const device ProbeAmbientC
     float3 t = (targetPlane - clampedPosition) / safeDir;
     float hitDistance = max(min(t.x, min(t.y, t.z)), 0.0);
     float3 hitPoint = clampedPosition + dir * hitDistance;
-    float3 corrected = hitPoint - probe.positionAndValidity.xyz;
+    float3 corrected = hitPoint - capturePosition;
     if (length_squared(corrected) <= 1e-6) {
         return dir;
     }
     return normalize(corrected);
 }
 
+static inline float3 parallax_correct_probe_direction(const device ProbeAmbientCubeData& probe,
+                                                      constant ProbeVolumeUniforms& probeVolume,
+                                                      float3 worldPosition,
+                                                      float3 reflectionDirection) {
+    return parallax_correct_direction(probe.positionAndValidity.xyz, probeVolume, worldPosition, reflectionDirection);
+}
+
 static inline float3 sample_probe_volume_irradiance(const device ProbeAmbientCubeData* probes,
                                                     constant ProbeVolumeUniforms& probeVolume,
                                                     float3 worldPosition,
@@ -2666,36 +4728,19 @@ static inline float3 sample_probe_volume_irradiance(const device ProbeAmbientCub
         return float3(0.0);
     }
 
-    uint3 counts = uint3(
-        max(uint(probeVolume.gridCounts.x + 0.5), 1u),
-        max(uint(probeVolume.gridCounts.y + 0.5), 1u),
-        max(uint(probeVolume.gridCounts.z + 0.5), 1u)
-    );
-    float3 extent = max(probeVolume.boundsMax.xyz - probeVolume.boundsMin.xyz, float3(0.001));
-    float3 uvw = clamp((worldPosition - probeVolume.boundsMin.xyz) / extent, 0.0, 1.0);
-    float3 grid = uvw * float3(
-        counts.x > 1 ? float(counts.x - 1) : 1.0,
-        counts.y > 1 ? float(counts.y - 1) : 1.0,
-        counts.z > 1 ? float(counts.z - 1) : 1.0
-    );
-
-    uint3 base = uint3(floor(grid));
-    uint3 next = min(base + 1u, counts - 1u);
-    float3 frac = fract(grid);
+    ProbeBrickLookup lookup = probe_brick_lookup(probes, probeVolume, worldPosition);
+    float3 frac = lookup.frac;
 
     float3 accum = float3(0.0);
     float accumWeight = 0.0;
     float3 fallbackAccum = float3(0.0);
     float fallbackWeight = 0.0;
     for (uint corner = 0; corner < 8u; ++corner) {
-        uint sx = (corner & 1u) != 0u ? next.x : base.x;
-        uint sy = (corner & 2u) != 0u ? next.y : base.y;
-        uint sz = (corner & 4u) != 0u ? next.z : base.z;
         float wx = (corner & 1u) != 0u ? frac.x : (1.0 - frac.x);
         float wy = (corner & 2u) != 0u ? frac.y : (1.0 - frac.y);
         float wz = (corner & 4u) != 0u ? frac.z : (1.0 - frac.z);
         float baseWeight = wx * wy * wz;
-        const device ProbeAmbientCubeData& probe = probes[probe_volume_index(sx, sy, sz, counts)];
+        const device ProbeAmbientCubeData& probe = probes[lookup.corners[corner]];
         float3 probeIrradiance = sample_probe_ambient_cube(probe, normal);
         fallbackAccum += probeIrradiance * baseWeight;
         fallbackWeight += baseWeight;
@@ -2735,28 +4780,9 @@ static inline float4 sample_probe_volume_reflection(const device ProbeAmbientCub
         return float4(0.0);
     }
 
-    uint3 counts = uint3(
-        max(uint(probeVolume.gridCounts.x + 0.5), 1u),
-        max(uint(probeVolume.gridCounts.y + 0.5), 1u),
-        max(uint(probeVolume.gridCounts.z + 0.5), 1u)
-    );
-    float3 extent = max(probeVolume.boundsMax.xyz - probeVolume.boundsMin.xyz, float3(0.001));
-    float3 uvw = clamp((worldPosition - probeVolume.boundsMin.xyz) / extent, 0.0, 1.0);
-    float3 grid = uvw * float3(
-        counts.x > 1 ? float(counts.x - 1) : 1.0,
-        counts.y > 1 ? float(counts.y - 1) : 1.0,
-        counts.z > 1 ? float(counts.z - 1) : 1.0
-    );
-    float3 cellExtent = extent / float3(
-        counts.x > 1 ? float(counts.x - 1) : 1.0,
-        counts.y > 1 ? float(counts.y - 1) : 1.0,
-        counts.z > 1 ? float(counts.z - 1) : 1.0
-    );
-    float localityRadius = max(length(cellExtent) * 1.1, 0.35);
-
-    uint3 base = uint3(floor(grid));
-    uint3 next = min(base + 1u, counts - 1u);
-    float3 frac = fract(grid);
+    ProbeBrickLookup lookup = probe_brick_lookup(probes, probeVolume, worldPosition);
+    float localityRadius = max(length(lookup.spacing) * 1.1, 0.35);
+    float3 frac = lookup.frac;
     float roughnessBlend = saturate(roughness * roughness);
     float roughnessFilterStrength = max(probeVolume.reflectionParams.x, 0.0);
     float roughnessFilterAmount = saturate(roughness * roughnessFilterStrength);
@@ -2771,15 +4797,12 @@ static inline float4 sample_probe_volume_reflection(const device ProbeAmbientCub
     float accumWeight = 0.0;
     float accumOcclusion = 0.0;
     for (uint corner = 0; corner < 8u; ++corner) {
-        uint sx = (corner & 1u) != 0u ? next.x : base.x;
-        uint sy = (corner & 2u) != 0u ? next.y : base.y;
-        uint sz = (corner & 4u) != 0u ? next.z : base.z;
         float wx = (corner & 1u) != 0u ? frac.x : (1.0 - frac.x);
         float wy = (corner & 2u) != 0u ? frac.y : (1.0 - frac.y);
         float wz = (corner & 4u) != 0u ? frac.z : (1.0 - frac.z);
         float baseWeight = wx * wy * wz;
 
-        const device ProbeAmbientCubeData& probe = probes[probe_volume_index(sx, sy, sz, counts)];
+        const device ProbeAmbientCubeData& probe = probes[lookup.corners[corner]];
         float visibilityWeight = max(probe.positionAndValidity.w, 0.05);
         float3 probeToPoint = worldPosition - probe.positionAndValidity.xyz;
         float probeDistance = length(probeToPoint);
@@ -2860,8 +4883,572 @@ static inline float4 sample_probe_volume_reflection(const device ProbeAmbientCub
     return float4(max(accum / accumWeight, float3(0.0)), saturate(accumWeight * reflectionOcclusion));
 }
 
-fragment float4 fragment_main(
-    VertexOut in [[stage_in]],
+// Runtime reflection captures near the camera (dynamic_reflection_capture below): every
+// prefiltered cube within its influence radius weighs in by distance, box projected like the baked
+// probes. w is how much the result replaces the reflections underneath: full within half the
+// radius of a capture, fading out to its edge.
+static inline float4 sample_dynamic_reflections(texturecube_array<float> captures,
+                                                sampler captureSampler,
+                                                constant ProbeVolumeUniforms& probeVolume,
+                                                float3 worldPosition,
+                                                float3 reflectionDirection,
+                                                float roughness) {
+    uint captureCount = min(uint(probeVolume.dynamicReflectionParams.x + 0.5), 8u);
+    float radius = max(probeVolume.dynamicReflectionParams.z, 1e-3);
+    float lod = roughness * probeVolume.dynamicReflectionParams.y;
+    float roughnessBlend = saturate(roughness * roughness);
+    float3 accum = float3(0.0);
+    float accumWeight = 0.0;
+    float coverage = 0.0;
+    for (uint index = 0; index < captureCount; ++index) {
+        float4 capture = probeVolume.dynamicReflections[index];
+        if (capture.w < 0.5) {
+            continue;
+        }
+        float falloff = saturate(1.0 - length(worldPosition - capture.xyz) / radius);
+        if (falloff <= 0.0) {
+            continue;
+        }
+        float3 corrected = parallax_correct_direction(capture.xyz, probeVolume, worldPosition, reflectionDirection);
+        float3 direction = normalize(mix(corrected, reflectionDirection, roughnessBlend));
+        float weight = falloff * falloff;
+        accum += captures.sample(captureSampler, direction, index, level(lod)).rgb * weight;
+        accumWeight += weight;
+        coverage = max(coverage, smoothstep(0.0, 0.5, falloff));
+    }
+    if (accumWeight <= 1e-5) {
+        return float4(0.0);
+    }
+    return float4(max(accum / accumWeight, float3(0.0)), coverage);
+}
+
+// ============================================================================
+// DYNAMIC PROBES
+// ============================================================================
+// Runtime relighting of the probe volume's coarse grid (DynamicProbeGI.hpp). One threadgroup
+// updates one probe: its threads trace a randomly rotated spherical Fibonacci set of rays against
+// the scene, light the hits with the frame's lights, the shadow atlas and the probes themselves
+// (further bounces), then fold the rays into the six cube faces and blend them into the probe's
+// float history. Probes only hold indirect light; dynamic lights stay in the main pass.
+
+struct DynamicProbeParams {
+    float4 boundsMin;
+    float4 boundsMax;
+    uint4 counts;   // xyz probes per axis, w probe count
+    uint4 update;   // x first probe of this update, y probes updated, z rays per probe, w seed
+    uint4 records;  // x first grid record in the probe buffer, y light count
+    float4 blend;   // x hysteresis, y max ray distance
+};
+
+struct DynamicProbeInstance {
+    float4 normalMatrix[3];
+    uint triangleOffset;
+    uint materialOffset;
+    uint materialCount;
+    uint pad;
+};
+
+struct DynamicProbeMaterial {
+    float4 albedo;
+    float4 emission;
+};
+
+constant uint kDynamicProbeThreads = 64u;
+constant uint kDynamicProbeMaxRays = 256u;
+// Per probe: six irradiance faces, six radiance faces, six visibility distances; w is 1 once set.
+constant uint kDynamicProbeHistoryStride = 18u;
+// Probe rays see every instance, shadow rays only the shadow casters.
+constant uint kDynamicProbeMaskShadow = 1u;
+constant uint kDynamicProbeMaskAll = 2u;
+
+constant float3 kDynamicProbeFaceAxes[6] = {
+    float3(1.0, 0.0, 0.0), float3(-1.0, 0.0, 0.0),
+    float3(0.0, 1.0, 0.0), float3(0.0, -1.0, 0.0),
+    float3(0.0, 0.0, 1.0), float3(0.0, 0.0, -1.0)
+};
+
+// Inverse of decode_rgb9e5; matches PackRGB9E5 in ProbeVolumeData.cpp.
+static inline uint encode_rgb9e5(float3 color) {
+    float3 clamped = select(float3(0.0), min(color, float3(65408.0)), color > 0.0);
+    float maxChannel = max(clamped.x, max(clamped.y, clamped.z));
+    if (maxChannel <= 0.0) {
+        return 0u;
+    }
+    int exponent = max(int(floor(log2(maxChannel))) + 16, 0);
+    float scale = exp2(float(exponent) - 24.0);
+    if (round(maxChannel / scale) >= 512.0) {
+        exponent += 1;
+        scale *= 2.0;
+    }
+    uint3 quantized = min(uint3(round(clamped / scale)), uint3(511u));
+    return quantized.x | (quantized.y << 9) | (quantized.z << 18) | (uint(exponent) << 27);
+}
+
+static inline uint dynamic_probe_hash(uint value) {
+    uint state = value * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+static inline float dynamic_probe_unit(uint value) {
+    return float(dynamic_probe_hash(value) & 0x00FFFFFFu) / 16777216.0;
+}
+
+// Uniformly random rotation, so successive updates of a probe trace different directions.
+static inline float3x3 dynamic_probe_rotation(uint seed) {
+    float u1 = dynamic_probe_unit(seed);
+    float u2 = dynamic_probe_unit(seed ^ 0x68bc21ebu) * TWO_PI;
+    float u3 = dynamic_probe_unit(seed ^ 0x02e5be93u) * TWO_PI;
+    float a = sqrt(1.0 - u1);
+    float b = sqrt(u1);
+    float4 q = float4(a * sin(u2), a * cos(u2), b * sin(u3), b * cos(u3));
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    return float3x3(float3(1.0 - 2.0 * (yy + zz), 2.0 * (xy + wz), 2.0 * (xz - wy)),
+                    float3(2.0 * (xy - wz), 1.0 - 2.0 * (xx + zz), 2.0 * (yz + wx)),
+                    float3(2.0 * (xz + wy), 2.0 * (yz - wx), 1.0 - 2.0 * (xx + yy)));
+}
+
+static inline float3 dynamic_probe_ray_direction(uint index, uint count) {
+    float z = 1.0 - (2.0 * float(index) + 1.0) / float(count);
+    float radius = sqrt(saturate(1.0 - z * z));
+    float phi = float(index) * 2.39996323;
+    return float3(cos(phi) * radius, sin(phi) * radius, z);
+}
+
+// Shadow atlas visibility of a world position, or -1 when it falls outside the view's tile.
+static inline float dynamic_probe_atlas_shadow(ShadowGPUData s,
+                                               float3 position,
+                                               float3 normal,
+                                               depth2d<float> atlas,
+                                               sampler shadowSampler) {
+    float3 samplePosition = position + normal * max(s.depthRange.z, 1e-4) * 1.5;
+    float4 clip = s.viewProj * float4(samplePosition, 1.0);
+    if (clip.w <= 1e-5) {
+        return -1.0;
+    }
+    float3 ndc = clip.xyz / clip.w;
+    if (any(abs(ndc.xy) > 1.0) || ndc.z < 0.0 || ndc.z > 1.0) {
+        return -1.0;
+    }
+    float2 uv = float2(ndc.x * 0.5 + 0.5, 0.5 - ndc.y * 0.5) * s.atlasUV.zw + s.atlasUV.xy;
+    return sampleShadowDepthPCF(atlas, shadowSampler, uv, ndc.z, s.params.x + s.params.y,
+                                s.atlasUV.xy, s.atlasUV.xy + s.atlasUV.zw, float2(1.0, 0.0), 1.0);
+}
+
+// Irradiance of the frame's lights at a ray hit, attenuated like fragment_main. Shadowed lights
+// read the shadow atlas where it covers the hit; point lights and hits outside every tile trace a
+// shadow ray instead, since most probe rays land away from the camera.
+static inline float3 dynamic_probe_direct(float3 position,
+                                          float3 normal,
+                                          uint lightCount,
+                                          float maxDistance,
+                                          constant CameraUniforms& camera,
+                                          const device LightGPUData* lights,
+                                          const device ShadowGPUData* shadowData,
+                                          depth2d<float> shadowAtlas,
+                                          sampler shadowSampler,
+                                          raytracing::instance_acceleration_structure scene) {
+    raytracing::intersector<raytracing::instancing> occlusion;
+    occlusion.assume_geometry_type(raytracing::geometry_type::triangle);
+    occlusion.force_opacity(raytracing::forced_opacity::opaque);
+    occlusion.accept_any_intersection(true);
+
+    float3 viewPosition = (camera.viewMatrix * float4(position, 1.0)).xyz;
+    float3 direct = float3(0.0);
+    for (uint index = 0; index < lightCount; ++index) {
+        LightGPUData light = lights[index];
+        int type = (int)round(light.directionType.w);
+        float3 lightDirVS;
+        float distance = maxDistance;
+        float attenuation = 1.0;
+        if (type == 0) {
+            lightDirVS = normalize(-light.directionType.xyz);
+        } else {
+            float3 toLight = light.positionRange.xyz - viewPosition;
+            distance = length(toLight);
+            if (distance < 1e-4) {
+                continue;
+            }
+            lightDirVS = toLight / distance;
+            float range = (light.positionRange.w > 0.0) ? (1.0 / light.positionRange.w) : 0.0;
+            float smooth = pow(saturate(1.0 - pow(distance / max(range, 0.0001), 4.0)), 2.0);
+            attenuation = smooth / max(distance * distance, 0.001);
+            if (type == 2) {
+                float cosTheta = dot(normalize(light.directionType.xyz), -lightDirVS);
+                if (cosTheta < light.misc.y) {
+                    continue;
+                }
+                attenuation *= smoothstep(light.misc.y, light.misc.x, cosTheta);
+            } else if (type == 3 || type == 4) {
+                attenuation *= 1.0 / max(distance, 0.1);
+            }
+        }
+        float3 lightDir = normalize((camera.viewMatrixInverse * float4(lightDirVS, 0.0)).xyz);
+        float NdotL = dot(normal, lightDir);
+        if (NdotL <= 0.0 || attenuation <= 0.0) {
+            continue;
+        }
+
+        float shadow = 1.0;
+        int shadowIdx = (int)round(light.shadowCookie.x);
+        if (shadowIdx >= 0) {
+            shadow = -1.0;
+            if (type == 0 || type == 2) {
+                int cascadeCount = (type == 0 && light.shadowCookie.z >= 1.0) ? (int)round(light.shadowCookie.z) : 1;
+                int cascade = resolveDirectionalCascadeIndex(shadowData, shadowIdx, cascadeCount, max(-viewPosition.z, 0.0));
+                shadow = dynamic_probe_atlas_shadow(shadowData[shadowIdx + cascade], position, normal, shadowAtlas, shadowSampler);
+            }
+            if (shadow < 0.0) {
+                raytracing::ray shadowRay(position + normal * 0.02, lightDir, 0.0, max(distance - 0.05, 0.0));
+                shadow = occlusion.intersect(shadowRay, scene, kDynamicProbeMaskShadow).type
+                    == raytracing::intersection_type::none ? 1.0 : 0.0;
+            }
+        }
+        direct += light.colorIntensity.rgb * light.colorIntensity.w * attenuation * NdotL * shadow;
+    }
+    return direct;
+}
+
+kernel void dynamic_probe_update(device ProbeAmbientCubeData* probes [[buffer(0)]],
+                                 device float4* history [[buffer(1)]],
+                                 constant DynamicProbeParams& params [[buffer(2)]],
+                                 constant CameraUniforms& camera [[buffer(3)]],
+                                 const device LightGPUData* lights [[buffer(4)]],
+                                 const device ShadowGPUData* shadowData [[buffer(5)]],
+                                 constant EnvironmentUniforms& environment [[buffer(6)]],
+                                 constant ProbeVolumeUniforms& probeVolume [[buffer(7)]],
+                                 const device DynamicProbeInstance* instances [[buffer(8)]],
+                                 const device float4* triangles [[buffer(9)]],
+                                 const device DynamicProbeMaterial* materials [[buffer(10)]],
+                                 raytracing::instance_acceleration_structure scene [[buffer(11)]],
+                                 depth2d<float> shadowAtlas [[texture(0)]],
+                                 texture2d<float> environmentMap [[texture(1)]],
+                                 sampler shadowSampler [[sampler(0)]],
+                                 sampler environmentSampler [[sampler(1)]],
+                                 uint group [[threadgroup_position_in_grid]],
+                                 uint lane [[thread_index_in_threadgroup]]) {
+    threadgroup float4 rayRadiance[kDynamicProbeMaxRays];  // w 1 for a back face hit
+    threadgroup float4 rayDirection[kDynamicProbeMaxRays]; // w hit distance
+
+    uint probeCount = params.counts.w;
+    if (group >= params.update.y || probeCount == 0u) {
+        return;
+    }
+    uint probeIndex = (params.update.x + group) % probeCount;
+    uint3 counts = params.counts.xyz;
+    uint3 coord = uint3(probeIndex % counts.x, (probeIndex / counts.x) % counts.y, probeIndex / (counts.x * counts.y));
+    float3 spacing = (params.boundsMax.xyz - params.boundsMin.xyz) / float3(max(counts, uint3(2u)) - 1u);
+    float3 probePosition = params.boundsMin.xyz + float3(coord) * spacing;
+
+    uint rayCount = clamp(params.update.z, 1u, kDynamicProbeMaxRays);
+    float maxDistance = params.blend.y;
+    float3x3 rotation = dynamic_probe_rotation(params.update.w ^ (probeIndex * 0x9e3779b9u));
+    raytracing::intersector<raytracing::instancing> intersector;
+    intersector.assume_geometry_type(raytracing::geometry_type::triangle);
+    intersector.force_opacity(raytracing::forced_opacity::opaque);
+
+    for (uint rayIndex = lane; rayIndex < rayCount; rayIndex += kDynamicProbeThreads) {
+        float3 direction = rotation * dynamic_probe_ray_direction(rayIndex, rayCount);
+        raytracing::ray probeRay(probePosition, direction, 0.0, maxDistance);
+        auto hit = intersector.intersect(probeRay, scene, kDynamicProbeMaskAll);
+        float4 radiance = float4(0.0);
+        float distance = maxDistance;
+        if (hit.type == raytracing::intersection_type::none) {
+            radiance.rgb = sampleEnvironment(environmentMap, environmentSampler, direction, 4.0, environment)
+                * environment.exposureIntensity.y;
+        } else {
+            distance = hit.distance;
+            DynamicProbeInstance instance = instances[hit.instance_id];
+            float4 triangle = triangles[instance.triangleOffset + hit.primitive_id];
+            float3x3 normalMatrix = float3x3(instance.normalMatrix[0].xyz, instance.normalMatrix[1].xyz,
+                                             instance.normalMatrix[2].xyz);
+            float3 normal = normalize(normalMatrix * triangle.xyz);
+            if (dot(normal, direction) > 0.0) {
+                // Back faces mean the probe sits inside geometry; they add no light and pull the
+                // visibility in so the probe stops leaking through the wall.
+                radiance.w = 1.0;
+                distance *= 0.2;
+            } else {
+                uint slot = min(uint(triangle.w), max(instance.materialCount, 1u) - 1u);
+                DynamicProbeMaterial material = materials[instance.materialOffset + slot];
+                float3 hitPosition = probePosition + direction * hit.distance + normal * 0.02;
+                float3 irradiance = dynamic_probe_direct(hitPosition, normal, params.records.y, maxDistance, camera,
+                                                         lights, shadowData, shadowAtlas, shadowSampler, scene);
+                // Last update's probes stand in for the remaining bounces.
+                irradiance += sample_probe_volume_irradiance(probes, probeVolume, hitPosition, normal);
+                radiance.rgb = material.albedo.rgb * (irradiance / PI) + material.emission.rgb;
+            }
+        }
+        rayRadiance[rayIndex] = radiance;
+        rayDirection[rayIndex] = float4(direction, distance);
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    if (lane >= 6u) {
+        return;
+    }
+    float3 axis = kDynamicProbeFaceAxes[lane];
+    float3 irradiance = float3(0.0);
+    float3 radiance = float3(0.0);
+    float radianceWeight = 0.0;
+    float distance = 0.0;
+    float distanceWeight = 0.0;
+    float backFaces = 0.0;
+    for (uint rayIndex = 0; rayIndex < rayCount; ++rayIndex) {
+        float4 rayLight = rayRadiance[rayIndex];
+        float4 ray = rayDirection[rayIndex];
+        backFaces += rayLight.w;
+        float cosine = dot(ray.xyz, axis);
+        if (cosine <= 0.0) {
+            continue;
+        }
+        irradiance += rayLight.rgb * cosine;
+        float lobe = pow(cosine, 4.0);
+        radiance += rayLight.rgb * lobe;
+        radianceWeight += lobe;
+        float visibilityLobe = pow(cosine, 8.0);
+        distance += ray.w * visibilityLobe;
+        distanceWeight += visibilityLobe;
+    }
+    irradiance *= 4.0 * PI / float(rayCount);
+    radiance /= max(radianceWeight, 1e-4);
+    distance = distanceWeight > 1e-4 ? distance / distanceWeight : maxDistance;
+
+    device float4* probeHistory = history + probeIndex * kDynamicProbeHistoryStride;
+    float4 previousIrradiance = probeHistory[lane];
+    float hysteresis = previousIrradiance.w > 0.5 ? saturate(params.blend.x) : 0.0;
+    irradiance = mix(irradiance, previousIrradiance.rgb, hysteresis);
+    radiance = mix(radiance, probeHistory[6u + lane].rgb, hysteresis);
+    distance = mix(distance, probeHistory[12u + lane].x, hysteresis);
+    probeHistory[lane] = float4(irradiance, 1.0);
+    probeHistory[6u + lane] = float4(radiance, 1.0);
+    probeHistory[12u + lane] = float4(distance, 0.0, 0.0, 1.0);
+
+    device ProbeAmbientCubeData& probe = probes[params.records.x + probeIndex];
+    probe.ambientCube[lane] = encode_rgb9e5(irradiance);
+    probe.specularCube[lane] = encode_rgb9e5(radiance);
+    if (lane < 4u) {
+        probe.visibility0[lane] = half(distance);
+    } else {
+        probe.visibility1[lane - 4u] = half(distance);
+    }
+    if (lane == 0u) {
+        float validity = backFaces > float(rayCount) * 0.25 ? 0.05 : 1.0;
+        probe.positionAndValidity = float4(probePosition, validity);
+        probe.visibility1.z = half(maxDistance);
+    }
+}
+
+// Runtime reflection captures (DynamicProbeGI::dispatchReflections): one face of one capture per
+// dispatch, a ray per texel from the capture point, shaded like the probe rays above (material
+// color, the frame's lights, the probe grid for the bounces) so a face costs one trace per texel
+// instead of a scene render. The renderer prefilters the cube with the IBL kernels afterwards.
+
+struct DynamicReflectionParams {
+    float4 position; // xyz capture point, w max ray distance
+    uint4 face;      // x cube face, y resolution, z light count
+};
+
+// getCubeDirection's face layout (IBL.metal), which the prefilter reads the capture with.
+static inline float3 dynamic_reflection_direction(uint face, float2 uv) {
+    float2 st = uv * 2.0 - 1.0;
+    float3 dir;
+    switch (face) {
+        case 0: dir = float3( 1.0, -st.y, -st.x); break;
+        case 1: dir = float3(-1.0, -st.y,  st.x); break;
+        case 2: dir = float3( st.x,  1.0,  st.y); break;
+        case 3: dir = float3( st.x, -1.0, -st.y); break;
+        case 4: dir = float3( st.x, -st.y,  1.0); break;
+        default: dir = float3(-st.x, -st.y, -1.0); break;
+    }
+    return normalize(dir);
+}
+
+kernel void dynamic_reflection_capture(texturecube<float, access::write> capture [[texture(0)]],
+                                       depth2d<float> shadowAtlas [[texture(1)]],
+                                       texture2d<float> environmentMap [[texture(2)]],
+                                       constant DynamicReflectionParams& params [[buffer(0)]],
+                                       constant CameraUniforms& camera [[buffer(1)]],
+                                       const device LightGPUData* lights [[buffer(2)]],
+                                       const device ShadowGPUData* shadowData [[buffer(3)]],
+                                       constant EnvironmentUniforms& environment [[buffer(4)]],
+                                       const device ProbeAmbientCubeData* probes [[buffer(5)]],
+                                       constant ProbeVolumeUniforms& probeVolume [[buffer(6)]],
+                                       const device DynamicProbeInstance* instances [[buffer(7)]],
+                                       const device float4* triangles [[buffer(8)]],
+                                       const device DynamicProbeMaterial* materials [[buffer(9)]],
+                                       raytracing::instance_acceleration_structure scene [[buffer(10)]],
+                                       sampler shadowSampler [[sampler(0)]],
+                                       sampler environmentSampler [[sampler(1)]],
+                                       uint2 gid [[thread_position_in_grid]]) {
+    uint resolution = params.face.y;
+    if (gid.x >= resolution || gid.y >= resolution) {
+        return;
+    }
+    float3 origin = params.position.xyz;
+    float maxDistance = params.position.w;
+    float3 direction = dynamic_reflection_direction(params.face.x, (float2(gid) + 0.5) / float(resolution));
+
+    raytracing::intersector<raytracing::instancing> intersector;
+    intersector.assume_geometry_type(raytracing::geometry_type::triangle);
+    intersector.force_opacity(raytracing::forced_opacity::opaque);
+    raytracing::ray captureRay(origin, direction, 0.0, maxDistance);
+    auto hit = intersector.intersect(captureRay, scene, kDynamicProbeMaskAll);
+
+    float3 radiance;
+    if (hit.type == raytracing::intersection_type::none) {
+        radiance = sampleEnvironment(environmentMap, environmentSampler, direction, 0.0, environment)
+            * environment.exposureIntensity.y;
+    } else {
+        DynamicProbeInstance instance = instances[hit.instance_id];
+        float4 triangle = triangles[instance.triangleOffset + hit.primitive_id];
+        float3x3 normalMatrix = float3x3(instance.normalMatrix[0].xyz, instance.normalMatrix[1].xyz,
+                                         instance.normalMatrix[2].xyz);
+        float3 normal = normalize(normalMatrix * triangle.xyz);
+        if (dot(normal, direction) > 0.0) {
+            // A capture point inside geometry sees its back faces; black keeps it from glowing.
+            radiance = float3(0.0);
+        } else {
+            uint slot = min(uint(triangle.w), max(instance.materialCount, 1u) - 1u);
+            DynamicProbeMaterial material = materials[instance.materialOffset + slot];
+            float3 hitPosition = origin + direction * hit.distance + normal * 0.02;
+            float3 irradiance = dynamic_probe_direct(hitPosition, normal, params.face.z, maxDistance, camera,
+                                                     lights, shadowData, shadowAtlas, shadowSampler, scene);
+            irradiance += sample_probe_volume_irradiance(probes, probeVolume, hitPosition, normal);
+            radiance = material.albedo.rgb * (irradiance / PI) + material.emission.rgb;
+        }
+    }
+    capture.write(float4(max(radiance, float3(0.0)), 1.0), gid, params.face.x);
+}
+
+// Material features fragment_main is specialized on (PbrFeature in Renderer.hpp). The renderer
+// always sets the constant; kPbrFeatureAll gives the ubershader that branches on the material
+// flags at runtime, leaner sets compile the unused paths out.
+constant uint kPbrFeatures [[function_constant(0)]];
+constant bool kPbrTerrain = (kPbrFeatures & 0x01u) != 0u;
+constant bool kPbrParallax = (kPbrFeatures & 0x02u) != 0u;
+constant bool kPbrSurfaceMaps = (kPbrFeatures & 0x04u) != 0u;
+constant bool kPbrAlphaDiscard = (kPbrFeatures & 0x08u) != 0u;
+constant bool kPbrDecals = (kPbrFeatures & 0x10u) != 0u;
+constant bool kPbrProbes = (kPbrFeatures & 0x20u) != 0u;
+constant bool kPbrStaticLighting = (kPbrFeatures & 0x40u) != 0u;
+// Not a material feature: the quality setting that evaluates the light loop's BRDF in half
+// precision (evaluateBRDFHalf), for register pressure. Positions, depths, shadows and radiance
+// stay in float.
+constant bool kPbrHalfPrecision = (kPbrFeatures & 0x80u) != 0u;
+
+// Main pass draws read their material from the frame's material table (MaterialTable.hpp):
+// buffer 1 points at the entry's uniforms and buffer 12 at its texture handles, in this order.
+// Other fragment_main pipelines keep the bound texture slots.
+constant bool kPbrMaterialTable [[function_constant(1)]];
+constant bool kPbrBoundMaterial = !kPbrMaterialTable;
+
+// Weighted blended transparency (WeightedTransparency.hpp): instead of its colour, fragment_main
+// writes the premultiplied colour scaled by a view depth weight to attachment 0 and its coverage to
+// the revealage attachment 1, so overlapping surfaces composite without being sorted.
+constant bool kPbrWeightedBlended [[function_constant(2)]];
+
+// Visibility-buffer shading of the static scene: the draw is a vertex_visibility_tile quad and
+// fragment_main rebuilds its varyings from the pixel's visibility ids (visibilitySurface),
+// discarding pixels of batches outside the drawn material group.
+constant bool kPbrVisibility [[function_constant(3)]];
+
+struct PbrFragmentOut {
+    float4 color [[color(0)]];
+    float revealage [[color(1), function_constant(kPbrWeightedBlended)]];
+};
+
+static inline PbrFragmentOut pbrFragmentOut(float4 color, float viewDepth) {
+    PbrFragmentOut out;
+    if (kPbrWeightedBlended) {
+        // McGuire and Bavoil's distance weight; bounded so 16-bit accumulation does not overflow.
+        float alpha = saturate(color.a);
+        float z = max(viewDepth, 0.0);
+        float weight = clamp(10.0 / (1e-5 + pow(z / 5.0, 2.0) + pow(z / 200.0, 6.0)), 1e-2, 3e3);
+        out.color = float4(color.rgb * alpha, alpha) * weight;
+        out.revealage = alpha;
+    } else {
+        out.color = color;
+    }
+    return out;
+}
+
+struct MaterialTextures {
+    texture2d<float> albedoMap;
+    texture2d<float> normalMap;
+    texture2d<float> metallicMap;
+    texture2d<float> roughnessMap;
+    texture2d<float> aoMap;
+    texture2d<float> emissionMap;
+    texture2d<float> heightMap;
+    texture2d<float> ormMap;
+    texture2d<float> terrainControlMap;
+    texture2d<float> terrainLayer0Map;
+    texture2d<float> terrainLayer1Map;
+    texture2d<float> terrainLayer2Map;
+    texture2d<float> terrainLayer0NormalMap;
+    texture2d<float> terrainLayer1NormalMap;
+    texture2d<float> terrainLayer2NormalMap;
+    texture2d<float> terrainLayer0OrmMap;
+    texture2d<float> terrainLayer1OrmMap;
+    texture2d<float> terrainLayer2OrmMap;
+};
+
+// Blended terrain layers from the runtime virtual texture (TerrainVirtualTexture.hpp): one
+// indirection read and two atlas samples stand in for the control map and nine layer samples.
+// The page mip follows the footprint of the terrain UV; the indirection holds the nearest resident
+// page for every page, so a page still waiting to be composited shows a coarser one. One pixel of
+// every 4x4 block, rotating each frame, reports the page it wanted in the feedback bits the
+// renderer composites from.
+struct TerrainVirtualSample {
+    float3 albedo;
+    float3 orm;
+    float3 normalTS;
+};
+
+static inline TerrainVirtualSample sampleTerrainVirtualTexture(
+    float2 virtualUV, uint textureIndex, float2 pixel,
+    constant TerrainVirtualTextureParams& vt, device atomic_uint* feedback,
+    texture2d_array<uint, access::read> indirection,
+    texture2d<float> albedoAtlas, texture2d<float> surfaceAtlas, sampler textureSampler) {
+    float2 uv = clamp(virtualUV, float2(0.0), float2(1.0));
+    float texels = float(vt.pagesPerSide * kTerrainVTPageSize);
+    float2 dx = dfdx(virtualUV) * texels;
+    float2 dy = dfdy(virtualUV) * texels;
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+    uint mip = uint(clamp(floor(lod), 0.0, float(vt.mipCount - 1)));
+    uint pages = vt.pagesPerSide >> mip;
+    uint2 page = min(uint2(uv * float(pages)), uint2(pages - 1));
+
+    uint2 cell = uint2(pixel) & 3u;
+    if (cell.x + cell.y * 4u == vt.feedbackPhase) {
+        uint bit = textureIndex * vt.feedbackBitsPerTexture + vt.mipOffsets[mip] + page.y * pages + page.x;
+        atomic_fetch_or_explicit(&feedback[bit >> 5], 1u << (bit & 31u), memory_order_relaxed);
+    }
+
+    // xy the page's slot in the atlases, z the mip of the resident page.
+    uint4 entry = indirection.read(page, textureIndex, mip);
+    float residentPages = float(vt.pagesPerSide >> entry.z);
+    float2 local = clamp(uv * residentPages - min(floor(uv * residentPages), float2(residentPages - 1.0)),
+                         float2(0.0), float2(1.0));
+    float stride = float(kTerrainVTPageSize + 2 * kTerrainVTPageBorder);
+    float2 atlasUV = (float2(entry.xy) * stride + float(kTerrainVTPageBorder) + local * float(kTerrainVTPageSize))
+                   / (stride * float(vt.atlasPagesPerSide));
+    float4 a = albedoAtlas.sample(textureSampler, atlasUV, level(0.0));
+    float4 s = surfaceAtlas.sample(textureSampler, atlasUV, level(0.0));
+
+    TerrainVirtualSample out;
+    out.albedo = a.rgb * a.rgb;
+    out.orm = float3(a.a, s.b, s.a);
+    float2 nxy = s.rg * 2.0 - 1.0;
+    out.normalTS = float3(nxy, sqrt(saturate(1.0 - dot(nxy, nxy))));
+    return out;
+}
+
+fragment PbrFragmentOut fragment_main(
+    VertexOut stageIn [[stage_in]],
     constant CameraUniforms& camera [[buffer(0)]],
     constant MaterialUniforms& material [[buffer(1)]],
     constant LightData& light [[buffer(2)]],
@@ -2874,13 +5461,20 @@ fragment float4 fragment_main(
     constant ClusterParams& clusterParams [[buffer(9)]],
     constant ProbeVolumeUniforms& probeVolume [[buffer(10)]],
     const device ProbeAmbientCubeData* probeData [[buffer(11)]],
-    texture2d<float> albedoMap [[texture(0)]],
-    texture2d<float> normalMap [[texture(1)]],
-    texture2d<float> metallicMap [[texture(2)]],
-    texture2d<float> roughnessMap [[texture(3)]],
-    texture2d<float> aoMap [[texture(4)]],
-    texture2d<float> emissionMap [[texture(5)]],
-    texture2d<float> heightMap [[texture(6)]],
+    constant MaterialTextures& materialTextures [[buffer(12), function_constant(kPbrMaterialTable)]],
+    // Only terrain pipelines write feedback, so only they give up hidden surface removal for it.
+    constant TerrainVirtualTextureParams& terrainVT [[buffer(13), function_constant(kPbrTerrain)]],
+    device atomic_uint* terrainVTFeedback [[buffer(14), function_constant(kPbrTerrain)]],
+    constant VisibilityShadeParams& visibilityParams [[buffer(15), function_constant(kPbrVisibility)]],
+    const device StaticBatchData* visibilityBatches [[buffer(16), function_constant(kPbrVisibility)]],
+    const device InstanceData* visibilityInstances [[buffer(17), function_constant(kPbrVisibility)]],
+    texture2d<float> albedoMapSlot [[texture(0), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> normalMapSlot [[texture(1), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> metallicMapSlot [[texture(2), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> roughnessMapSlot [[texture(3), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> aoMapSlot [[texture(4), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> emissionMapSlot [[texture(5), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> heightMapSlot [[texture(6), function_constant(kPbrBoundMaterial)]],
     texture2d<float> environmentMap [[texture(7)]],
     texturecube<float> irradianceMap [[texture(8)]],
     texturecube<float> prefilteredMap [[texture(9)]],
@@ -2890,28 +5484,66 @@ fragment float4 fragment_main(
     depth2d_array<float> pointShadowCube1 [[texture(13)]],
     depth2d_array<float> pointShadowCube2 [[texture(14)]],
     depth2d_array<float> pointShadowCube3 [[texture(15)]],
-    texture2d<float> ormMap [[texture(16)]],
+    texture2d<float> ormMapSlot [[texture(16), function_constant(kPbrBoundMaterial)]],
     texture2d<float> ssaoMap [[texture(17)]],
     texture2d<float> decalAlbedoMap [[texture(18)]],
     texture2d<float> decalNormalMap [[texture(19)]],
     texture2d<float> decalOrmMap [[texture(20)]],
-    texture2d<float> terrainControlMap [[texture(21)]],
-    texture2d<float> terrainLayer0Map [[texture(22)]],
-    texture2d<float> terrainLayer1Map [[texture(23)]],
-    texture2d<float> terrainLayer2Map [[texture(24)]],
-    texture2d<float> terrainLayer0NormalMap [[texture(25)]],
-    texture2d<float> terrainLayer1NormalMap [[texture(26)]],
-    texture2d<float> terrainLayer2NormalMap [[texture(27)]],
-    texture2d<float> terrainLayer0OrmMap [[texture(28)]],
-    texture2d<float> terrainLayer1OrmMap [[texture(29)]],
-    texture2d<float> terrainLayer2OrmMap [[texture(30)]],
+    texture2d<float> terrainControlMapSlot [[texture(21), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> terrainLayer0MapSlot [[texture(22), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> terrainLayer1MapSlot [[texture(23), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> terrainLayer2MapSlot [[texture(24), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> terrainLayer0NormalMapSlot [[texture(25), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> terrainLayer1NormalMapSlot [[texture(26), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> terrainLayer2NormalMapSlot [[texture(27), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> terrainLayer0OrmMapSlot [[texture(28), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> terrainLayer1OrmMapSlot [[texture(29), function_constant(kPbrBoundMaterial)]],
+    texture2d<float> terrainLayer2OrmMapSlot [[texture(30), function_constant(kPbrBoundMaterial)]],
     texture2d<float> staticLightmap [[texture(31)]],
     texture2d<float> directionalStaticLightmap [[texture(32)]],
     texture2d<float> shadowmaskStaticLightmap [[texture(33)]],
+    texture2d_array<uint, access::read> terrainVTIndirection [[texture(34), function_constant(kPbrTerrain)]],
+    texture2d<float> terrainVTAlbedoAtlas [[texture(35), function_constant(kPbrTerrain)]],
+    texture2d<float> terrainVTSurfaceAtlas [[texture(36), function_constant(kPbrTerrain)]],
+    texture2d<float> shadowDepthBounds [[texture(37)]],
+    texturecube_array<float> dynamicReflectionCaptures [[texture(38)]],
+    texture2d<uint, access::read> visibilityIds [[texture(39), function_constant(kPbrVisibility)]],
     sampler textureSampler [[sampler(0)]],
     sampler environmentSampler [[sampler(1)]],
     sampler shadowSampler [[sampler(2)]]
 ) {
+    VertexOut in = stageIn;
+    if (kPbrVisibility) {
+        uint2 id = visibilityIds.read(uint2(stageIn.position.xy)).xy;
+        uint batch = id.x == VISIBILITY_INVALID
+            ? visibilityParams.batchCount
+            : visibilityBatch(visibilityBatches, visibilityParams.batchCount, id.x);
+        if (batch < visibilityParams.firstBatch || batch >= visibilityParams.firstBatch + visibilityParams.batchRange) {
+            discard_fragment();
+            return pbrFragmentOut(float4(0.0), 0.0);
+        }
+        in = visibilitySurface(stageIn.position, id.x, id.y, visibilityBatches[batch], visibilityInstances,
+                               camera, material, visibilityParams);
+    }
+    // Material maps come from the table entry or the bound slots; only one of them exists.
+    texture2d<float> albedoMap = kPbrMaterialTable ? materialTextures.albedoMap : albedoMapSlot;
+    texture2d<float> normalMap = kPbrMaterialTable ? materialTextures.normalMap : normalMapSlot;
+    texture2d<float> metallicMap = kPbrMaterialTable ? materialTextures.metallicMap : metallicMapSlot;
+    texture2d<float> roughnessMap = kPbrMaterialTable ? materialTextures.roughnessMap : roughnessMapSlot;
+    texture2d<float> aoMap = kPbrMaterialTable ? materialTextures.aoMap : aoMapSlot;
+    texture2d<float> emissionMap = kPbrMaterialTable ? materialTextures.emissionMap : emissionMapSlot;
+    texture2d<float> heightMap = kPbrMaterialTable ? materialTextures.heightMap : heightMapSlot;
+    texture2d<float> ormMap = kPbrMaterialTable ? materialTextures.ormMap : ormMapSlot;
+    texture2d<float> terrainControlMap = kPbrMaterialTable ? materialTextures.terrainControlMap : terrainControlMapSlot;
+    texture2d<float> terrainLayer0Map = kPbrMaterialTable ? materialTextures.terrainLayer0Map : terrainLayer0MapSlot;
+    texture2d<float> terrainLayer1Map = kPbrMaterialTable ? materialTextures.terrainLayer1Map : terrainLayer1MapSlot;
+    texture2d<float> terrainLayer2Map = kPbrMaterialTable ? materialTextures.terrainLayer2Map : terrainLayer2MapSlot;
+    texture2d<float> terrainLayer0NormalMap = kPbrMaterialTable ? materialTextures.terrainLayer0NormalMap : terrainLayer0NormalMapSlot;
+    texture2d<float> terrainLayer1NormalMap = kPbrMaterialTable ? materialTextures.terrainLayer1NormalMap : terrainLayer1NormalMapSlot;
+    texture2d<float> terrainLayer2NormalMap = kPbrMaterialTable ? materialTextures.terrainLayer2NormalMap : terrainLayer2NormalMapSlot;
+    texture2d<float> terrainLayer0OrmMap = kPbrMaterialTable ? materialTextures.terrainLayer0OrmMap : terrainLayer0OrmMapSlot;
+    texture2d<float> terrainLayer1OrmMap = kPbrMaterialTable ? materialTextures.terrainLayer1OrmMap : terrainLayer1OrmMapSlot;
+    texture2d<float> terrainLayer2OrmMap = kPbrMaterialTable ? materialTextures.terrainLayer2OrmMap : terrainLayer2OrmMapSlot;
     float3 Vworld = normalize(camera.cameraPositionTime.xyz - in.worldPosition);
     float3 viewPos = (camera.viewMatrix * float4(in.worldPosition, 1.0)).xyz;
     float3 Vview = normalize(-viewPos);
@@ -2928,17 +5560,27 @@ fragment float4 fragment_main(
     float2 uv = in.texCoord * material.uvTilingOffset.xy + material.uvTilingOffset.zw;
     
     // Parallax occlusion mapping with ray march + binary refinement
-    if (material.textureFlags2.z > 0.5) {
+    if (kPbrParallax && material.textureFlags2.z > 0.5) {
         uv = applyParallaxOcclusionMapping(heightMap, textureSampler, uv, viewDirTS, material);
     }
     
     // Albedo
     float4 albedoSample = albedoMap.sample(textureSampler, uv);
-    float3 vertexTint = (in.bakedLightingFlag > 0.5) ? float3(1.0) : in.color.rgb;
+    float3 vertexTint = (kPbrStaticLighting && in.bakedLightingFlag > 0.5) ? float3(1.0) : in.color.rgb;
     float3 albedo = material.albedo.rgb * vertexTint;
-    bool terrainEnabled = material.terrainParams0.x > 0.5 &&
+    bool terrainEnabled = kPbrTerrain && material.terrainParams0.x > 0.5 &&
         (material.terrainFlags.y + material.terrainFlags.z + material.terrainFlags.w) > 0.5;
-    if (terrainEnabled) {
+    // terrainParams1.z is the material's virtual texture, one based; the renderer only sets it on
+    // opaque control-mapped terrains, whose alpha is the material's.
+    bool terrainVirtual = terrainEnabled && material.terrainParams1.z > 0.5;
+    TerrainVirtualSample terrainSample = {};
+    if (terrainVirtual) {
+        terrainSample = sampleTerrainVirtualTexture(in.texCoord, uint(material.terrainParams1.z) - 1u, in.position.xy,
+                                                    terrainVT, terrainVTFeedback, terrainVTIndirection,
+                                                    terrainVTAlbedoAtlas, terrainVTSurfaceAtlas, textureSampler);
+        albedo *= terrainSample.albedo;
+        albedoSample = float4(terrainSample.albedo, 1.0);
+    } else if (terrainEnabled) {
         float2 uv0 = uv * max(material.terrainLayer0ST.xy, float2(0.001));
         float2 uv1 = uv * max(material.terrainLayer1ST.xy, float2(0.001));
         float2 uv2 = uv * max(material.terrainLayer2ST.xy, float2(0.001));
@@ -2953,10 +5595,10 @@ fragment float4 fragment_main(
         albedo *= albedoSample.rgb;
     }
     float alpha = material.albedo.a * ((terrainEnabled || material.textureFlags.x > 0.5) ? albedoSample.a : 1.0);
-    if (material.textureFlags3.y > 0.5 && alpha < material.textureFlags3.z) {
+    if (kPbrAlphaDiscard && material.textureFlags3.y > 0.5 && alpha < material.textureFlags3.z) {
         discard_fragment();
     }
-    if (material.foliageParams2.w > 0.5) {
+    if (kPbrAlphaDiscard && material.foliageParams2.w > 0.5) {
         float fade = 1.0;
         if (material.foliageParams2.z > 0.5) {
             fade *= (in.billboardFlag > 0.5) ? in.billboardFade : (1.0 - in.billboardFade);
@@ -2972,20 +5614,28 @@ fragment float4 fragment_main(
             }
         }
     }
+    if (lodDitherDiscard(in.lodDither, in.position.xy)) {
+        discard_fragment();
+    }
     
     // Metallic/Roughness/AO
     float metallic = material.properties.x;
     float roughness = max(material.properties.y, 0.04);
     float ao = material.properties.z;
-    float2 ndc = in.position.xy / in.position.w;
+    // Screen position from the view position rather than [[position]], which is in physical
+    // pixels when the pass renders through a rasterization rate map.
+    float4 screenClip = camera.projectionMatrixNoJitter * float4(viewPos, 1.0);
+    float2 ndc = screenClip.xy / screenClip.w;
     float2 ssaoUV = float2(ndc.x * 0.5 + 0.5, 1.0 - (ndc.y * 0.5 + 0.5));
-    float4 decalClip = camera.projectionMatrixNoJitter * float4(viewPos, 1.0);
-    float2 decalUV = float2(decalClip.x / decalClip.w * 0.5 + 0.5,
-                            1.0 - (decalClip.y / decalClip.w * 0.5 + 0.5));
+    float2 decalUV = ssaoUV;
     float ssao = ssaoMap.sample(textureSampler, ssaoUV).r;
     ao = clamp(ao * ssao, 0.0, 1.0);
     
-    if (terrainEnabled) {
+    if (terrainVirtual) {
+        metallic = clamp(metallic * terrainSample.orm.b, 0.0, 1.0);
+        roughness = clamp(roughness * terrainSample.orm.g, 0.04, 1.0);
+        ao = clamp(ao * terrainSample.orm.r, 0.0, 1.0);
+    } else if (terrainEnabled) {
         float2 uv0 = uv * max(material.terrainLayer0ST.xy, float2(0.001));
         float2 uv1 = uv * max(material.terrainLayer1ST.xy, float2(0.001));
         float2 uv2 = uv * max(material.terrainLayer2ST.xy, float2(0.001));
@@ -2997,7 +5647,7 @@ fragment float4 fragment_main(
         metallic = clamp(metallic * terrainOrm.b, 0.0, 1.0);
         roughness = clamp(roughness * terrainOrm.g, 0.04, 1.0);
         ao = clamp(ao * terrainOrm.r, 0.0, 1.0);
-    } else if (material.textureFlags3.x > 0.5) {
+    } else if (kPbrSurfaceMaps && material.textureFlags3.x > 0.5) {
         float3 orm = ormMap.sample(textureSampler, uv).rgb;
         if (material.textureFlags.z > 0.5) {
             metallic = clamp(metallic * metallicMap.sample(textureSampler, uv).r, 0.0, 1.0);
@@ -3014,7 +5664,7 @@ fragment float4 fragment_main(
         } else {
             ao = clamp(ao * orm.r, 0.0, 1.0);
         }
-    } else {
+    } else if (kPbrSurfaceMaps) {
         if (material.textureFlags.z > 0.5) {
             metallic = clamp(metallic * metallicMap.sample(textureSampler, uv).r, 0.0, 1.0);
         }
@@ -3027,7 +5677,10 @@ fragment float4 fragment_main(
     }
     
     // Normalize vectors
-    if (terrainEnabled) {
+    if (terrainVirtual) {
+        float3 terrainTN = normalize(float3(terrainSample.normalTS.xy * material.properties.w, terrainSample.normalTS.z));
+        N = normalize(TBN * terrainTN);
+    } else if (terrainEnabled) {
         float2 uv0 = uv * max(material.terrainLayer0ST.xy, float2(0.001));
         float2 uv1 = uv * max(material.terrainLayer1ST.xy, float2(0.001));
         float2 uv2 = uv * max(material.terrainLayer2ST.xy, float2(0.001));
@@ -3038,28 +5691,41 @@ fragment float4 fragment_main(
         float3 terrainTN = normalize(tn0 * weights.x + tn1 * weights.y + tn2 * weights.z);
         terrainTN = normalize(float3(terrainTN.xy * material.properties.w, terrainTN.z));
         N = normalize(TBN * terrainTN);
-    } else if (material.textureFlags.y > 0.5) {
-        float3 tangentNormal = normalMap.sample(textureSampler, uv).xyz * 2.0 - 1.0;
+    } else if (kPbrSurfaceMaps && material.textureFlags.y > 0.5) {
+        float4 normalSample = normalMap.sample(textureSampler, uv);
+        float3 tangentNormal = normalSample.xyz * 2.0 - 1.0;
         tangentNormal = normalize(float3(tangentNormal.xy * material.properties.w, tangentNormal.z));
         N = normalize(TBN * tangentNormal);
+        if (material.textureFlags3.w > 0.5) {
+            // Toksvig: the mips keep the averaged normal length in alpha, and a short average
+            // means the normals under the footprint disagree. Scale the Blinn-Phong power that
+            // matches the GGX alpha by |n| / (|n| + s(1 - |n|)) and convert back.
+            float normalLength = clamp(normalSample.w, 0.05, 1.0);
+            float ggxAlpha = roughness * roughness;
+            float power = 2.0 / max(ggxAlpha * ggxAlpha, 1e-4) - 2.0;
+            float filteredPower = normalLength * power / (normalLength + power * (1.0 - normalLength));
+            roughness = clamp(sqrt(sqrt(2.0 / (filteredPower + 2.0))), roughness, 1.0);
+        }
     }
 
-    float4 decalAlbedoSample = decalAlbedoMap.sample(textureSampler, decalUV);
-    if (decalAlbedoSample.a > 0.001) {
-        albedo = mix(albedo, decalAlbedoSample.rgb, decalAlbedoSample.a);
-    }
+    if (kPbrDecals) {
+        float4 decalAlbedoSample = decalAlbedoMap.sample(textureSampler, decalUV);
+        if (decalAlbedoSample.a > 0.001) {
+            albedo = mix(albedo, decalAlbedoSample.rgb, decalAlbedoSample.a);
+        }
 
-    float4 decalNormalSample = decalNormalMap.sample(textureSampler, decalUV);
-    if (decalNormalSample.a > 0.001) {
-        float3 decalNormal = normalize(decalNormalSample.xyz * 2.0 - 1.0);
-        N = normalize(mix(N, decalNormal, decalNormalSample.a));
-    }
+        float4 decalNormalSample = decalNormalMap.sample(textureSampler, decalUV);
+        if (decalNormalSample.a > 0.001) {
+            float3 decalNormal = normalize(decalNormalSample.xyz * 2.0 - 1.0);
+            N = normalize(mix(N, decalNormal, decalNormalSample.a));
+        }
 
-    float4 decalOrmSample = decalOrmMap.sample(textureSampler, decalUV);
-    if (decalOrmSample.a > 0.001) {
-        ao = mix(ao, decalOrmSample.r, decalOrmSample.a);
-        roughness = mix(roughness, clamp(decalOrmSample.g, 0.04, 1.0), decalOrmSample.a);
-        metallic = mix(metallic, clamp(decalOrmSample.b, 0.0, 1.0), decalOrmSample.a);
+        float4 decalOrmSample = decalOrmMap.sample(textureSampler, decalUV);
+        if (decalOrmSample.a > 0.001) {
+            ao = mix(ao, decalOrmSample.r, decalOrmSample.a);
+            roughness = mix(roughness, clamp(decalOrmSample.g, 0.04, 1.0), decalOrmSample.a);
+            metallic = mix(metallic, clamp(decalOrmSample.b, 0.0, 1.0), decalOrmSample.a);
+        }
     }
 
     float3 Nview = normalize((camera.viewMatrix * float4(N, 0.0)).xyz);
@@ -3081,7 +5747,7 @@ fragment float4 fragment_main(
     // Reflectance equation
     float3 Lo = float3(0.0);
     float4 shadowmaskSample = float4(1.0);
-    if (in.staticLightmapFlag > 0.5) {
+    if (kPbrStaticLighting && in.staticLightmapFlag > 0.5) {
         shadowmaskSample = shadowmaskStaticLightmap.sample(textureSampler, saturate(in.lightmapTexCoord));
     }
     
@@ -3132,17 +5798,10 @@ fragment float4 fragment_main(
                 continue;
             }
             
-            float3 H = normalize(Vview + LdirVS);
-            float NDF = DistributionGGX(Nview, H, roughness);
-            float G = GeometrySmith(Nview, Vview, LdirVS, roughness);
-            float3 F = fresnelSchlick(max(dot(H, Vview), 0.0), F0);
-            
-            float3 numerator = NDF * G * F;
-            float denom = 4.0 * max(dot(Nview, Vview), 0.0) * max(NdotL, 0.0) + 0.001;
-            float3 specular = numerator / denom;
-            
-            float3 kS = F;
-            float3 kD = (float3(1.0) - kS) * (1.0 - metallic);
+            float3 brdf = kPbrHalfPrecision
+                ? float3(evaluateBRDFHalf(half3(Nview), half3(Vview), half3(LdirVS), half(NdotL), half(roughness),
+                                          half(metallic), half3(albedo), half3(F0)))
+                : evaluateBRDF(Nview, Vview, LdirVS, NdotL, roughness, metallic, albedo, F0);
             
             uint lightFlags = (uint)round(Ld.shadowCookie.w);
             bool usePCSS = (lightFlags & 1u) != 0u;
@@ -3150,6 +5809,8 @@ fragment float4 fragment_main(
             bool bakedDirect = (lightFlags & 8u) != 0u;
             uint mobility = (lightFlags >> 4u) & 0x3u;
             int shadowmaskChannel = int((lightFlags >> 6u) & 0x7u) - 1;
+            uint shadowFilterTier = (lightFlags >> 9u) & 0x3u;
+            bool shadowBounds = (lightFlags & (1u << 11u)) != 0u;
             int shadowIdx = (int)round(Ld.shadowCookie.x);
             int cascadeCount = (type == 0 && Ld.shadowCookie.z >= 1.0) ? (int)round(Ld.shadowCookie.z) : 1;
             float3 LdirWorld = normalize((camera.viewMatrixInverse * float4(LdirVS, 0.0)).xyz);
@@ -3180,13 +5841,14 @@ fragment float4 fragment_main(
                         float sampleDepthDbg = cubeDbg.sample(shadowSampler, projDbg.uv, sliceDbg);
                         float shadowDbg = (refDbg <= sampleDepthDbg) ? 1.0 : 0.0;
                         float faceDbg = float(projDbg.face) / 5.0;
-                        return float4(refDbg, sampleDepthDbg, faceDbg * 0.85 + shadowDbg * 0.15, 1.0);
+                        return pbrFragmentOut(float4(refDbg, sampleDepthDbg, faceDbg * 0.85 + shadowDbg * 0.15, 1.0), -viewPos.z);
                     }
                     shadow = samplePointShadow(shadowData, shadowIdx, in.worldPosition, N, lightPosWS, LdirWorld, sLocal.depthRange.w, pointShadowCube0, pointShadowCube1, pointShadowCube2, pointShadowCube3, shadowSampler);
                 } else {
                     float viewDepth = max(-viewPos.z, 0.0);
                     debugCascadeIndex = resolveDirectionalCascadeIndex(shadowData, shadowIdx, cascadeCount, viewDepth);
-                    shadow = sampleShadow(shadowData, shadowIdx, cascadeCount, viewDepth, in.worldPosition, N, LdirWorld, shadowAtlas, shadowSampler, usePCSS, useContact);
+                    shadow = sampleShadow(shadowData, shadowIdx, cascadeCount, viewDepth, in.worldPosition, N, LdirWorld, shadowAtlas, shadowSampler, usePCSS, useContact,
+                                          shadowDepthBounds, shadowBounds, shadowFilterTier);
                 }
                 rawShadowAccum += shadow;
                 rawShadowWeight += 1.0;
@@ -3200,7 +5862,7 @@ fragment float4 fragment_main(
             }
 
             bool directBakedLightmap = in.hdrStaticLightmapFlag >= 10.0;
-            bool bakedStaticReceiver = in.staticLightmapFlag > 0.5 && directBakedLightmap && bakedDirect;
+            bool bakedStaticReceiver = kPbrStaticLighting && in.staticLightmapFlag > 0.5 && directBakedLightmap && bakedDirect;
             if (bakedStaticReceiver) {
                 if (mobility == 0u) {
                     continue;
@@ -3221,27 +5883,19 @@ fragment float4 fragment_main(
             }
             
             float3 radiance = Ld.colorIntensity.rgb * Ld.colorIntensity.w * attenuation * shadow;
-            Lo += (kD * albedo / PI + specular) * radiance * NdotL;
+            Lo += brdf * radiance * NdotL;
         }
     } else {
         // Legacy single directional light
         float3 L = normalize(-light.direction.xyz);
-        float3 H = normalize(V + L);
-        
         float NdotL = max(dot(N, L), 0.0);
-        float NDF = DistributionGGX(N, H, roughness);
-        float G = GeometrySmith(N, V, L, roughness);
-        float3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
-        
-        float3 numerator = NDF * G * F;
-        float denom = 4.0 * max(dot(N, V), 0.0) * max(NdotL, 0.0) + 0.001;
-        float3 specular = numerator / denom;
-        
-        float3 kS = F;
-        float3 kD = (float3(1.0) - kS) * (1.0 - metallic);
+        float3 brdf = kPbrHalfPrecision
+            ? float3(evaluateBRDFHalf(half3(N), half3(V), half3(L), half(NdotL), half(roughness),
+                                      half(metallic), half3(albedo), half3(F0)))
+            : evaluateBRDF(N, V, L, NdotL, roughness, metallic, albedo, F0);
         
         float3 radiance = light.color.xyz * light.direction.w;
-        Lo = (kD * albedo / PI + specular) * radiance * NdotL;
+        Lo = brdf * radiance * NdotL;
     }
     
     // ========================================
@@ -3321,7 +5975,7 @@ fragment float4 fragment_main(
     float ambientAO = mix(1.0, ao, 0.65);
     float3 ambientLighting = ambientRadiance * (kD_ambient * albedo / PI) * ambientAO;
     float3 probeLighting = float3(0.0);
-    if (in.staticLightmapFlag < 0.5 && probeVolume.gridCounts.w > 0.5 && probeVolume.featureParams.x > 0.5) {
+    if (kPbrProbes && in.staticLightmapFlag < 0.5 && probeVolume.gridCounts.w > 0.5 && probeVolume.featureParams.x > 0.5) {
         probeLighting = sample_probe_volume_irradiance(probeData, probeVolume, in.worldPosition, N);
     }
     float probeAO = mix(1.0, ao, 0.72);
@@ -3329,7 +5983,9 @@ fragment float4 fragment_main(
     float2 probeBRDF = hasProperIBL
         ? brdfLUT.sample(environmentSampler, float2(NdotV, roughness)).rg
         : float2(1.0 - roughness, 0.0);
-    float4 localReflectionSample = sample_probe_volume_reflection(probeData, probeVolume, in.worldPosition, R, N, roughness);
+    float4 localReflectionSample = kPbrProbes
+        ? sample_probe_volume_reflection(probeData, probeVolume, in.worldPosition, R, N, roughness)
+        : float4(0.0);
     float localReflectionWeight = localReflectionSample.a * saturate(probeVolume.featureParams.z);
     float specularOcclusionStrength = clamp(probeVolume.blendParams.w, 0.0, 2.0);
     float specularAO = mix(1.0, compute_specular_occlusion(ao, NdotV, roughness), saturate(specularOcclusionStrength));
@@ -3344,14 +6000,22 @@ fragment float4 fragment_main(
     localReflectionLighting *= probeSpecularOcclusion;
     environmentSpecularLighting *= specularAO * probeSpecularOcclusion;
     environmentSpecularLighting = mix(environmentSpecularLighting, localReflectionLighting, saturate(localReflectionWeight));
+    if (kPbrProbes && probeVolume.dynamicReflectionParams.x > 0.5) {
+        // Runtime captures see the scene as it is now, so they win over the baked reflections.
+        float4 dynamicReflection = sample_dynamic_reflections(dynamicReflectionCaptures, environmentSampler, probeVolume,
+                                                              in.worldPosition, R, roughness);
+        float3 dynamicReflectionLighting = dynamicReflection.rgb * (F0 * probeBRDF.x + probeBRDF.y) * specularAO;
+        environmentSpecularLighting = mix(environmentSpecularLighting, dynamicReflectionLighting,
+                                          saturate(dynamicReflection.a * probeVolume.featureParams.z));
+    }
     environmentLighting = environmentDiffuseLighting + environmentSpecularLighting;
     
     float3 bakedDirect = float3(0.0);
-    if (in.bakedLightingFlag > 0.5) {
+    if (kPbrStaticLighting && in.bakedLightingFlag > 0.5) {
         float3 bakedKD = (float3(1.0) - F0) * (1.0 - metallic);
         bakedDirect = bakedKD * albedo / PI * max(in.color.rgb, float3(0.0));
     }
-    if (in.staticLightmapFlag > 0.5) {
+    if (kPbrStaticLighting && in.staticLightmapFlag > 0.5) {
         float2 lightmapUV = clamp(in.lightmapTexCoord, float2(0.0), float2(1.0));
         float lightmapEncoding = in.hdrStaticLightmapFlag;
         bool directBakedLightmap = lightmapEncoding >= 10.0;
@@ -3402,7 +6066,7 @@ fragment float4 fragment_main(
 
     // Add emission (unpack from Vector4)
     float3 emission = material.emission.xyz;
-    if (material.textureFlags2.y > 0.5) {
+    if (kPbrSurfaceMaps && material.textureFlags2.y > 0.5) {
         emission *= emissionMap.sample(textureSampler, uv).rgb;
     }
     emission *= material.emission.w; // emissionStrength in w
@@ -3413,7 +6077,7 @@ fragment float4 fragment_main(
     // ========== DEBUG: Check shadow map content ==========
     #if 0
     if (lightCount > 0 && clusterHeaders && clusterIndices) {
-        float2 ndcDbg = in.position.xy / in.position.w;
+        float2 ndcDbg = ndc;
         float2 screenDbg = (ndcDbg * 0.5 + 0.5) * float2(clusterParams.screenWidth, clusterParams.screenHeight);
         uint cxDbg = min((uint)(screenDbg.x / (clusterParams.screenWidth / clusterParams.clusterX)), clusterParams.clusterX - 1);
         uint cyDbg = min((uint)(screenDbg.y / (clusterParams.screenHeight / clusterParams.clusterY)), clusterParams.clusterY - 1);
@@ -3449,7 +6113,7 @@ fragment float4 fragment_main(
                     // Show sampled depth as grayscale
                     // If shadow map is empty, this will be 1.0 (white)
                     // If something was rendered, we should see darker values
-                    return float4(sampledDepth, sampledDepth, sampledDepth, 1.0);
+                    return pbrFragmentOut(float4(sampledDepth, sampledDepth, sampledDepth, 1.0), -viewPos.z);
                     
                     // Alternative: show fragDepth vs sampledDepth
                     // Red = fragDepth, Green = sampledDepth
@@ -3457,33 +6121,33 @@ fragment float4 fragment_main(
                 }
                 
                 // Out of bounds - show cyan
-                return float4(0.0, 1.0, 1.0, 1.0);
+                return pbrFragmentOut(float4(0.0, 1.0, 1.0, 1.0), -viewPos.z);
             }
         }
     }
     // No shadow light - magenta
-    return float4(1.0, 0.0, 1.0, 1.0);
+    return pbrFragmentOut(float4(1.0, 0.0, 1.0, 1.0), -viewPos.z);
     #endif
     // ========== END DEBUG ==========
     
     if (shadowDebugMode > 0) {
         if (shadowDebugMode == 1) {
             float v = (rawShadowWeight > 0.0) ? (rawShadowAccum / rawShadowWeight) : 1.0;
-            return float4(v, v, v, 1.0);
+            return pbrFragmentOut(float4(v, v, v, 1.0), -viewPos.z);
         }
         if (shadowDebugMode == 2) {
             float v = (directionalShadowWeight > 0.0) ? (directionalShadowAccum / directionalShadowWeight) : 1.0;
-            return float4(v, v, v, 1.0);
+            return pbrFragmentOut(float4(v, v, v, 1.0), -viewPos.z);
         }
         if (shadowDebugMode == 3) {
             float v = (pointShadowWeight > 0.0) ? (pointShadowAccum / pointShadowWeight) : 1.0;
-            return float4(v, v, v, 1.0);
+            return pbrFragmentOut(float4(v, v, v, 1.0), -viewPos.z);
         }
         if (shadowDebugMode == 4) {
-            return float4((debugCascadeIndex >= 0) ? shadowDebugCascadeColor(debugCascadeIndex) : float3(0.0), 1.0);
+            return pbrFragmentOut(float4((debugCascadeIndex >= 0) ? shadowDebugCascadeColor(debugCascadeIndex) : float3(0.0), 1.0), -viewPos.z);
         }
         if (shadowDebugMode == 5) {
-            return float4((debugPointFace >= 0) ? shadowDebugPointFaceColor(debugPointFace) : float3(0.0), 1.0);
+            return pbrFragmentOut(float4((debugPointFace >= 0) ? shadowDebugPointFaceColor(debugPointFace) : float3(0.0), 1.0), -viewPos.z);
         }
     }
 
@@ -3499,7 +6163,7 @@ fragment float4 fragment_main(
         color = pow(color, float3(1.0/2.2));
     }
     
-    return float4(color, alpha);
+    return pbrFragmentOut(float4(color, alpha), -viewPos.z);
 }
 
 // ============================================================================
@@ -3544,6 +6208,7 @@ fragment float4 skybox_fragment(
     constant LightData& sun [[buffer(2)]],
     texture2d<float> environmentMap [[texture(0)]],
     texturecube<float> environmentCubemap [[texture(1)]],
+    texture2d<float> skyViewLut [[texture(2)]],
     sampler environmentSampler [[sampler(0)]]
 ) {
     if (environment.toneControl.z < 0.5) {
@@ -3585,6 +6250,22 @@ fragment float4 skybox_fragment(
         } else {
             color = sampleEnvironment(environmentMap, environmentSampler, worldDir, 0.0, environment);
         }
+    } else if (environment.skyParams.w > 0.5) {
+        // Precomputed atmosphere (Sky.metal): the low-resolution sky-view LUT is upsampled by the
+        // bilinear fetch, and only the sun disc is evaluated per pixel. sun.color already carries the
+        // atmosphere's transmittance when the sun colour is automatic.
+        constexpr sampler skyLutSampler(filter::linear, s_address::repeat, t_address::clamp_to_edge);
+        float3 skyColor = skyViewLut.sample(skyLutSampler, skyViewLutUV(worldDir)).rgb;
+
+        float3 sunDir = normalize(-sun.direction.xyz);
+        float sunIntensity = max(sun.direction.w, 0.0);
+        float sunDot = max(dot(worldDir, sunDir), 0.0);
+        float sunAngularRadius = 0.004675f;
+        float sunCore = smoothstep(cos(sunAngularRadius * 1.5), cos(sunAngularRadius * 0.75), sunDot);
+        float aboveHorizon = smoothstep(-0.01, 0.0, worldDir.y);
+        float3 sunRadiance = sun.color.xyz * sunCore * 8.0 * sunIntensity * aboveHorizon;
+
+        color = applyEnvironmentGrading(skyColor + sunRadiance, environment);
     } else {
         float3 sunDir = normalize(-sun.direction.xyz);
         float sunIntensity = max(sun.direction.w, 0.0);
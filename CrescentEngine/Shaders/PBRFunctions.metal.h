@@ -52,4 +52,54 @@ float3 fresnelSchlickRoughness(float cosTheta, float3 F0, float roughness) {
     return F0 + (max(float3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }
 
+// Diffuse and specular reflectance of one light; scale by its radiance and NdotL.
+float3 evaluateBRDF(float3 N, float3 V, float3 L, float NdotL, float roughness, float metallic,
+                    float3 albedo, float3 F0) {
+    float3 H = normalize(V + L);
+    float NDF = DistributionGGX(N, H, roughness);
+    float G = GeometrySmith(N, V, L, roughness);
+    float3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+    float3 numerator = NDF * G * F;
+    float denom = 4.0 * max(dot(N, V), 0.0) * max(NdotL, 0.0) + 0.001;
+    float3 specular = numerator / denom;
+
+    float3 kD = (float3(1.0) - F) * (1.0 - metallic);
+    return kD * albedo / PI + specular;
+}
+
+// ============================================================================
+// HALF PRECISION
+// ============================================================================
+
+// Below this roughness a^2 leaves the normal half range and the GGX peak overflows.
+constant half kHalfMinRoughness = 0.089h;
+
+// evaluateBRDF in half. The NDF takes 1 - NdotH^2 as |N x H|^2, which keeps its precision where
+// NdotH is close to 1, and both it and the specular ratio saturate at HALF_MAX instead of reaching
+// infinity. Radiance and its accumulation stay in float: light intensities and the inverse square
+// falloff near a light leave the half range.
+half3 evaluateBRDFHalf(half3 N, half3 V, half3 L, half NdotL, half roughness, half metallic,
+                       half3 albedo, half3 F0) {
+    half3 H = normalize(V + L);
+    half NdotH = saturate(dot(N, H));
+    half NdotV = saturate(dot(N, V));
+    roughness = max(roughness, kHalfMinRoughness);
+
+    half a = roughness * roughness;
+    half3 NxH = cross(N, H);
+    half aNdotH = NdotH * a;
+    half k = a / (dot(NxH, NxH) + aNdotH * aNdotH);
+    half NDF = min(k * k * M_1_PI_H, HALF_MAX);
+
+    half r = roughness + 1.0h;
+    half kG = r * r * 0.125h;
+    half G = NdotV / max(NdotV * (1.0h - kG) + kG, 0.001h) * NdotL / max(NdotL * (1.0h - kG) + kG, 0.001h);
+    half3 F = F0 + (1.0h - F0) * pow(1.0h - saturate(dot(H, V)), 5.0h);
+
+    half3 specular = F * min(NDF * G / (4.0h * NdotV * NdotL + 0.001h), HALF_MAX);
+    half3 kD = (1.0h - F) * (1.0h - metallic);
+    return kD * albedo * M_1_PI_H + specular;
+}
+
 #endif // PBR_FUNCTIONS_METAL_H
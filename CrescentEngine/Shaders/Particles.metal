@@ -0,0 +1,473 @@
+#include "Common.metal.h"
+using namespace metal;
+
+// GPU particles for ParticleEmitter components (ParticleSystem). Every emitter owns a pool of
+// particles, a dead list of free pool slots and two alive lists that swap each frame: emission
+// pops dead slots onto the current alive list, the simulation writes survivors to the other one
+// and pushes the rest back onto the dead list. Counts never leave the GPU; the kernels that size
+// the following dispatches and the draw write them as indirect arguments.
+
+// Matches ParticleSystem::ParticleGPU.
+struct Particle {
+    float4 positionAge;  // xyz world position, w age in seconds
+    float4 velocityLife; // xyz world velocity, w lifetime in seconds
+};
+
+// Matches ParticleSystem::CountersGPU.
+struct ParticleCounters {
+    atomic_uint deadCount;
+    atomic_uint aliveCount[2];
+    uint emitCount;
+};
+
+// Matches ParticleSystem::SimParamsGPU.
+struct ParticleSimParams {
+    float4x4 emitterToWorld;
+    float4 lifetimeSpeed; // x min lifetime, y max lifetime, z min speed, w max speed
+    float4 shape;         // x 0 point, 1 sphere, 2 cone; y radius; z cos of the cone half-angle
+    float4 gravityDrag;   // xyz gravity, w drag per second
+    float4 collision;     // x bounce, y lifetime lost per bounce, z surface thickness, w 1 when colliding
+    float4 viewport;      // xy viewport size in pixels, z HZB mip for the early-out, w 1 when the HZB is bound
+    float deltaTime;
+    uint capacity;
+    uint emitRequest;
+    uint current;         // alive list read this frame; survivors go to the other one
+    uint seed;
+    uint sortCount;
+    uint _pad0;
+    uint _pad1;
+};
+
+// Matches ParticleSystem::SortParamsGPU.
+struct ParticleSortParams {
+    uint k; // bitonic stage; 0 sorts each block from scratch
+    uint j; // compare distance of a global step
+};
+
+// Matches ParticleSystem::DrawParamsGPU.
+struct ParticleDrawParams {
+    float4 startColor;   // linear rgb times intensity, a opacity
+    float4 endColor;
+    float4 sizeFlags;    // x start size, y end size, z 1 when lit, w 1 when textured
+    uint listOffset;     // first entry of the draw list
+    uint listStride;     // uints per entry; the particle index is the entry's last uint
+    uint additive;
+    uint _pad0;
+};
+
+constant uint kParticleGroupSize = 64;
+constant uint kParticleSortBlock = 512;
+
+static inline uint particleHash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static inline float particleRandom(thread uint& state) {
+    state = particleHash(state + 0x9E3779B9u);
+    return float(state >> 8) * (1.0 / 16777216.0);
+}
+
+kernel void particle_reset(
+    device ParticleCounters& counters [[buffer(0)]],
+    device uint* deadList [[buffer(1)]],
+    constant ParticleSimParams& params [[buffer(2)]],
+    uint gid [[thread_position_in_grid]]
+) {
+    if (gid < params.capacity) {
+        deadList[gid] = gid;
+    }
+    if (gid == 0) {
+        atomic_store_explicit(&counters.deadCount, params.capacity, memory_order_relaxed);
+        atomic_store_explicit(&counters.aliveCount[0], 0u, memory_order_relaxed);
+        atomic_store_explicit(&counters.aliveCount[1], 0u, memory_order_relaxed);
+        counters.emitCount = 0;
+    }
+}
+
+// Clamps this frame's emission to the free slots and sizes the emit and simulate dispatches.
+kernel void particle_begin(
+    device ParticleCounters& counters [[buffer(0)]],
+    device MTLDispatchThreadgroupsIndirectArguments* dispatchArgs [[buffer(1)]],
+    constant ParticleSimParams& params [[buffer(2)]]
+) {
+    uint dead = atomic_load_explicit(&counters.deadCount, memory_order_relaxed);
+    uint emit = min(params.emitRequest, dead);
+    uint alive = atomic_load_explicit(&counters.aliveCount[params.current], memory_order_relaxed);
+    counters.emitCount = emit;
+    atomic_store_explicit(&counters.aliveCount[1 - params.current], 0u, memory_order_relaxed);
+
+    uint emitGroups = (emit + kParticleGroupSize - 1) / kParticleGroupSize;
+    uint simulateGroups = (alive + emit + kParticleGroupSize - 1) / kParticleGroupSize;
+    dispatchArgs[0].threadgroupsPerGrid[0] = emitGroups;
+    dispatchArgs[0].threadgroupsPerGrid[1] = 1;
+    dispatchArgs[0].threadgroupsPerGrid[2] = 1;
+    dispatchArgs[1].threadgroupsPerGrid[0] = simulateGroups;
+    dispatchArgs[1].threadgroupsPerGrid[1] = 1;
+    dispatchArgs[1].threadgroupsPerGrid[2] = 1;
+}
+
+kernel void particle_emit(
+    device ParticleCounters& counters [[buffer(0)]],
+    device uint* deadList [[buffer(1)]],
+    constant ParticleSimParams& params [[buffer(2)]],
+    device Particle* particles [[buffer(3)]],
+    device uint* aliveLists [[buffer(4)]],
+    uint gid [[thread_position_in_grid]]
+) {
+    if (gid >= counters.emitCount) {
+        return;
+    }
+    uint deadIndex = atomic_fetch_sub_explicit(&counters.deadCount, 1u, memory_order_relaxed) - 1;
+    uint index = deadList[deadIndex];
+
+    uint rng = particleHash(params.seed ^ (gid * 0x85EBCA6Bu));
+    float3 direction = float3(0.0, 0.0, -1.0);
+    float3 offset = float3(0.0);
+    int shape = int(params.shape.x);
+    if (shape == 1) {
+        float z = particleRandom(rng) * 2.0 - 1.0;
+        float phi = particleRandom(rng) * 6.2831853;
+        float r = sqrt(max(1.0 - z * z, 0.0));
+        direction = float3(r * cos(phi), r * sin(phi), z);
+        offset = direction * params.shape.y * pow(particleRandom(rng), 1.0 / 3.0);
+    } else if (shape == 2) {
+        float cosAngle = mix(1.0, params.shape.z, particleRandom(rng));
+        float sinAngle = sqrt(max(1.0 - cosAngle * cosAngle, 0.0));
+        float phi = particleRandom(rng) * 6.2831853;
+        direction = float3(sinAngle * cos(phi), sinAngle * sin(phi), -cosAngle);
+        float discRadius = params.shape.y * sqrt(particleRandom(rng));
+        float discAngle = particleRandom(rng) * 6.2831853;
+        offset = float3(cos(discAngle), sin(discAngle), 0.0) * discRadius;
+    }
+
+    float speed = mix(params.lifetimeSpeed.z, params.lifetimeSpeed.w, particleRandom(rng));
+    float lifetime = mix(params.lifetimeSpeed.x, params.lifetimeSpeed.y, particleRandom(rng));
+    float3 worldDirection = normalize((params.emitterToWorld * float4(direction, 0.0)).xyz);
+    Particle particle;
+    particle.positionAge = float4((params.emitterToWorld * float4(offset, 1.0)).xyz, 0.0);
+    particle.velocityLife = float4(worldDirection * speed, lifetime);
+    // Spread the births over the frame so a steady stream does not leave in bands.
+    float spawnAge = particleRandom(rng) * params.deltaTime;
+    particle.positionAge.xyz += particle.velocityLife.xyz * spawnAge;
+    particle.positionAge.w = spawnAge;
+    particles[index] = particle;
+
+    uint slot = atomic_fetch_add_explicit(&counters.aliveCount[params.current], 1u, memory_order_relaxed);
+    aliveLists[params.current * params.capacity + slot] = index;
+}
+
+static inline float particleViewDepth(constant CameraUniforms& camera, float2 ndc, float depth) {
+    float4 view = camera.projectionMatrixInverse * float4(ndc, depth, 1.0);
+    return -view.z / view.w;
+}
+
+static inline float3 particleViewPosition(constant CameraUniforms& camera, uint2 pixel, float2 viewportSize,
+                                          depth2d<float> sceneDepth) {
+    float2 uv = (float2(pixel) + 0.5) / viewportSize;
+    float2 ndc = float2(uv.x * 2.0 - 1.0, 1.0 - uv.y * 2.0);
+    float4 view = camera.projectionMatrixInverse * float4(ndc, sceneDepth.read(pixel), 1.0);
+    return view.xyz / view.w;
+}
+
+// Bounces the particle off the opaque surface it moved behind this step. The surface is the prepass
+// depth under the particle, and a particle only collides within the thickness behind it, so it
+// still passes behind foreground objects. The HZB holds the farthest depth of each block; a
+// particle beyond it by more than the thickness is behind every surface there and skips the
+// full-resolution reads.
+static inline void particleCollide(thread float3& position, thread float3& velocity, thread float& age,
+                                   float lifetime, constant ParticleSimParams& params,
+                                   constant CameraUniforms& camera, depth2d<float> sceneDepth,
+                                   texture2d<float> hzb) {
+    float4 clip = camera.viewProjectionMatrix * float4(position, 1.0);
+    if (clip.w <= 1e-4) {
+        return;
+    }
+    float2 ndc = clip.xy / clip.w;
+    if (any(abs(ndc) >= 1.0)) {
+        return;
+    }
+    float2 viewportSize = params.viewport.xy;
+    uint2 pixel = uint2(min(float2(ndc.x * 0.5 + 0.5, 0.5 - ndc.y * 0.5) * viewportSize, viewportSize - 1.0));
+    float particleDepth = -(camera.viewMatrix * float4(position, 1.0)).z;
+    float thickness = params.collision.z + length(velocity) * params.deltaTime;
+
+    if (params.viewport.w > 0.5) {
+        uint mip = uint(params.viewport.z);
+        uint2 hzbPixel = min(pixel >> mip, uint2(hzb.get_width(mip) - 1, hzb.get_height(mip) - 1));
+        float farthest = hzb.read(hzbPixel, mip).r;
+        if (farthest < 1.0 && particleDepth > particleViewDepth(camera, ndc, farthest) + thickness) {
+            return;
+        }
+    }
+
+    float depth = sceneDepth.read(pixel);
+    if (depth >= 1.0) {
+        return;
+    }
+    float surfaceDepth = particleViewDepth(camera, ndc, depth);
+    if (particleDepth < surfaceDepth || particleDepth > surfaceDepth + thickness) {
+        return;
+    }
+
+    uint2 maxPixel = uint2(viewportSize) - 1;
+    int2 step = int2(pixel.x < maxPixel.x ? 1 : -1, pixel.y < maxPixel.y ? 1 : -1);
+    float3 center = particleViewPosition(camera, pixel, viewportSize, sceneDepth);
+    float3 alongX = particleViewPosition(camera, uint2(int2(pixel) + int2(step.x, 0)), viewportSize, sceneDepth) - center;
+    float3 alongY = particleViewPosition(camera, uint2(int2(pixel) + int2(0, step.y)), viewportSize, sceneDepth) - center;
+    float3 viewNormal = cross(alongX, alongY);
+    if (length_squared(viewNormal) < 1e-12) {
+        return;
+    }
+    viewNormal = normalize(viewNormal);
+    if (dot(viewNormal, center) > 0.0) {
+        viewNormal = -viewNormal;
+    }
+    float3 normal = normalize((camera.viewMatrixInverse * float4(viewNormal, 0.0)).xyz);
+    float3 surface = (camera.viewMatrixInverse * float4(center, 1.0)).xyz;
+
+    float normalSpeed = dot(velocity, normal);
+    if (normalSpeed < 0.0) {
+        velocity -= (1.0 + params.collision.x) * normalSpeed * normal;
+        age += params.collision.y * lifetime;
+    }
+    position += normal * (max(dot(surface - position, normal), 0.0) + 1e-3);
+}
+
+kernel void particle_simulate(
+    device ParticleCounters& counters [[buffer(0)]],
+    device uint* deadList [[buffer(1)]],
+    constant ParticleSimParams& params [[buffer(2)]],
+    device Particle* particles [[buffer(3)]],
+    device uint* aliveLists [[buffer(4)]],
+    constant CameraUniforms& camera [[buffer(5)]],
+    depth2d<float> sceneDepth [[texture(0)]],
+    texture2d<float> hzb [[texture(1)]],
+    uint gid [[thread_position_in_grid]]
+) {
+    uint current = params.current;
+    if (gid >= atomic_load_explicit(&counters.aliveCount[current], memory_order_relaxed)) {
+        return;
+    }
+    uint index = aliveLists[current * params.capacity + gid];
+    Particle particle = particles[index];
+    float dt = params.deltaTime;
+    float age = particle.positionAge.w + dt;
+    float lifetime = particle.velocityLife.w;
+
+    float3 velocity = particle.velocityLife.xyz + params.gravityDrag.xyz * dt;
+    velocity *= max(1.0 - params.gravityDrag.w * dt, 0.0);
+    float3 position = particle.positionAge.xyz + velocity * dt;
+    if (params.collision.w > 0.5) {
+        particleCollide(position, velocity, age, lifetime, params, camera, sceneDepth, hzb);
+    }
+
+    if (age >= lifetime) {
+        uint deadIndex = atomic_fetch_add_explicit(&counters.deadCount, 1u, memory_order_relaxed);
+        deadList[deadIndex] = index;
+        return;
+    }
+    particle.positionAge = float4(position, age);
+    particle.velocityLife = float4(velocity, lifetime);
+    particles[index] = particle;
+    uint next = 1 - current;
+    uint slot = atomic_fetch_add_explicit(&counters.aliveCount[next], 1u, memory_order_relaxed);
+    aliveLists[next * params.capacity + slot] = index;
+}
+
+// Draws one camera-facing quad per survivor.
+kernel void particle_finish(
+    device ParticleCounters& counters [[buffer(0)]],
+    device MTLDrawPrimitivesIndirectArguments* drawArgs [[buffer(1)]],
+    constant ParticleSimParams& params [[buffer(2)]]
+) {
+    drawArgs->vertexCount = 6;
+    drawArgs->instanceCount = atomic_load_explicit(&counters.aliveCount[1 - params.current], memory_order_relaxed);
+    drawArgs->vertexStart = 0;
+    drawArgs->baseInstance = 0;
+}
+
+// One key per sort slot: the bit-inverted camera distance of a survivor, so an ascending sort is
+// back to front, or an all-ones key past the survivors that sorts to the end.
+kernel void particle_sort_keys(
+    device ParticleCounters& counters [[buffer(0)]],
+    device uint2* keys [[buffer(1)]],
+    constant ParticleSimParams& params [[buffer(2)]],
+    const device Particle* particles [[buffer(3)]],
+    const device uint* aliveLists [[buffer(4)]],
+    constant CameraUniforms& camera [[buffer(5)]],
+    uint gid [[thread_position_in_grid]]
+) {
+    if (gid >= params.sortCount) {
+        return;
+    }
+    uint next = 1 - params.current;
+    if (gid >= atomic_load_explicit(&counters.aliveCount[next], memory_order_relaxed)) {
+        keys[gid] = uint2(0xFFFFFFFFu, 0u);
+        return;
+    }
+    uint index = aliveLists[next * params.capacity + gid];
+    float distanceToCamera = distance(particles[index].positionAge.xyz, camera.cameraPositionTime.xyz);
+    keys[gid] = uint2(~as_type<uint>(distanceToCamera), index);
+}
+
+// Bitonic steps with a compare distance below the block size, in threadgroup memory. With k = 0
+// every block is sorted from scratch (stages 2 to 512); otherwise this finishes stage k after the
+// global steps have brought each block's pairs together.
+kernel void particle_sort_local(
+    device uint2* keys [[buffer(0)]],
+    constant ParticleSortParams& sort [[buffer(1)]],
+    uint tid [[thread_index_in_threadgroup]],
+    uint group [[threadgroup_position_in_grid]]
+) {
+    threadgroup uint2 block[kParticleSortBlock];
+    uint base = group * kParticleSortBlock;
+    uint halfBlock = kParticleSortBlock / 2;
+    block[tid] = keys[base + tid];
+    block[tid + halfBlock] = keys[base + tid + halfBlock];
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    uint firstStage = sort.k == 0 ? 2 : sort.k;
+    uint lastStage = sort.k == 0 ? kParticleSortBlock : sort.k;
+    for (uint k = firstStage; k <= lastStage; k <<= 1) {
+        for (uint j = min(k >> 1, halfBlock); j > 0; j >>= 1) {
+            uint i = 2 * j * (tid / j) + (tid % j);
+            bool ascending = ((base + i) & k) == 0;
+            uint2 a = block[i];
+            uint2 b = block[i + j];
+            if ((a.x > b.x) == ascending) {
+                block[i] = b;
+                block[i + j] = a;
+            }
+            threadgroup_barrier(mem_flags::mem_threadgroup);
+        }
+    }
+
+    keys[base + tid] = block[tid];
+    keys[base + tid + halfBlock] = block[tid + halfBlock];
+}
+
+kernel void particle_sort_step(
+    device uint2* keys [[buffer(0)]],
+    constant ParticleSortParams& sort [[buffer(1)]],
+    uint gid [[thread_position_in_grid]]
+) {
+    uint i = 2 * sort.j * (gid / sort.j) + (gid % sort.j);
+    bool ascending = (i & sort.k) == 0;
+    uint2 a = keys[i];
+    uint2 b = keys[i + sort.j];
+    if ((a.x > b.x) == ascending) {
+        keys[i] = b;
+        keys[i + sort.j] = a;
+    }
+}
+
+struct ParticleVertexOut {
+    float4 position [[position]];
+    float3 viewPosition;
+    float2 uv;
+    float4 color;
+};
+
+vertex ParticleVertexOut particle_vertex(
+    uint vertexId [[vertex_id]],
+    uint instanceId [[instance_id]],
+    const device Particle* particles [[buffer(0)]],
+    const device uint* drawList [[buffer(1)]],
+    constant CameraUniforms& camera [[buffer(2)]],
+    constant ParticleDrawParams& draw [[buffer(3)]]
+) {
+    const float2 corners[6] = {
+        float2(-1.0, -1.0), float2(1.0, -1.0), float2(1.0, 1.0),
+        float2(-1.0, -1.0), float2(1.0, 1.0), float2(-1.0, 1.0)
+    };
+    uint index = drawList[draw.listOffset + instanceId * draw.listStride + draw.listStride - 1];
+    Particle particle = particles[index];
+    float t = saturate(particle.positionAge.w / max(particle.velocityLife.w, 1e-4));
+    float2 corner = corners[vertexId];
+    float size = mix(draw.sizeFlags.x, draw.sizeFlags.y, t);
+
+    ParticleVertexOut out;
+    float3 viewPosition = (camera.viewMatrix * float4(particle.positionAge.xyz, 1.0)).xyz;
+    viewPosition.xy += corner * (0.5 * size);
+    out.position = camera.projectionMatrix * float4(viewPosition, 1.0);
+    out.viewPosition = viewPosition;
+    out.uv = float2(corner.x * 0.5 + 0.5, 0.5 - corner.y * 0.5);
+    out.color = mix(draw.startColor, draw.endColor, t);
+    return out;
+}
+
+// Sprites take the pass's camera, environment and clustered light bindings. Lit sprites scatter
+// ambient and every light of their cluster evenly, with no facing term or shadows; the result is
+// exposed and tonemapped like fragment_main's.
+fragment float4 particle_fragment(
+    ParticleVertexOut in [[stage_in]],
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant EnvironmentUniforms& environment [[buffer(3)]],
+    const device LightGPUData* lights [[buffer(4)]],
+    constant uint& lightCount [[buffer(6)]],
+    const device ClusterHeader* clusterHeaders [[buffer(7)]],
+    const device uint* clusterIndices [[buffer(8)]],
+    constant ClusterParams& clusterParams [[buffer(9)]],
+    constant ParticleDrawParams& draw [[buffer(10)]],
+    texture2d<float> sprite [[texture(0)]],
+    sampler spriteSampler [[sampler(0)]]
+) {
+    float4 color = in.color;
+    if (draw.sizeFlags.w > 0.5) {
+        color *= sprite.sample(spriteSampler, in.uv);
+    } else {
+        float2 centered = in.uv * 2.0 - 1.0;
+        color.a *= saturate(1.0 - dot(centered, centered));
+    }
+    if (color.a <= 1e-3) {
+        discard_fragment();
+    }
+
+    if (draw.sizeFlags.z > 0.5) {
+        float3 lighting = environment.ambientColorIntensity.rgb * environment.ambientColorIntensity.w;
+        if (lightCount > 0 && clusterHeaders && clusterIndices) {
+            float3 viewPos = in.viewPosition;
+            float4 screenClip = camera.projectionMatrixNoJitter * float4(viewPos, 1.0);
+            float2 ndc = screenClip.xy / screenClip.w;
+            float2 screen = (ndc * 0.5 + 0.5) * float2(clusterParams.screenWidth, clusterParams.screenHeight);
+            uint cx = min((uint)(screen.x / (clusterParams.screenWidth / clusterParams.clusterX)), clusterParams.clusterX - 1);
+            uint cy = min((uint)(screen.y / (clusterParams.screenHeight / clusterParams.clusterY)), clusterParams.clusterY - 1);
+            float logDepth = log2(-viewPos.z / clusterParams.nearPlane) / log2(clusterParams.farPlane / clusterParams.nearPlane);
+            uint cz = (uint)clamp(logDepth * clusterParams.clusterZ, 0.0, float(clusterParams.clusterZ - 1));
+            ClusterHeader header = clusterHeaders[cz * (clusterParams.clusterX * clusterParams.clusterY) + cy * clusterParams.clusterX + cx];
+            for (uint idx = 0; idx < header.count; ++idx) {
+                LightGPUData Ld = lights[clusterIndices[header.offset + idx]];
+                int type = (int)round(Ld.directionType.w);
+                float attenuation = 1.0;
+                if (type != 0) {
+                    float3 toLight = Ld.positionRange.xyz - viewPos;
+                    float distance = length(toLight);
+                    float range = (Ld.positionRange.w > 0.0) ? (1.0 / Ld.positionRange.w) : 0.0;
+                    float smooth = pow(saturate(1.0 - pow(distance / max(range, 0.0001), 4.0)), 2.0);
+                    attenuation = smooth / max(distance * distance, 0.001);
+                    if (type == 2) {
+                        float cosTheta = dot(normalize(Ld.directionType.xyz), -toLight / max(distance, 1e-4));
+                        attenuation *= smoothstep(Ld.misc.y, Ld.misc.x, cosTheta);
+                    }
+                }
+                lighting += Ld.colorIntensity.rgb * Ld.colorIntensity.w * attenuation;
+            }
+        }
+        color.rgb *= lighting;
+    }
+
+    color.rgb *= pow(2.0, environment.exposureIntensity.x);
+    if (environment.toneControl.w < 0.5) {
+        color.rgb = color.rgb / (color.rgb + float3(0.6));
+        color.rgb = pow(color.rgb * 1.4, float3(1.0 / 2.2));
+    }
+    if (draw.additive != 0) {
+        return float4(color.rgb * color.a, 1.0);
+    }
+    return color;
+}
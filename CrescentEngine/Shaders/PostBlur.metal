@@ -0,0 +1,468 @@
+#include "Common.metal.h"
+using namespace metal;
+
+// Tile-classified motion blur and depth of field (Renderer/TiledPostBlur.hpp). post_blur_tile_reduce
+// folds every kPostBlurTileSize-square tile into its velocity and circle of confusion ranges,
+// post_blur_tile_classify widens them to the 3x3 tile neighbourhood and appends each tile to one
+// list per effect and class, and post_blur_tile_args turns the list lengths into indirect
+// dispatches of one threadgroup per tile. Tiles nothing blurs are copied through; the cheap
+// classes skip the depth-aware weighting where the tile's blur is uniform.
+constant uint kPostBlurTileSize = 16;
+constant uint kPostBlurHalfTileSize = kPostBlurTileSize / 2;
+constant float kPostBlurMinRadius = 0.25;   // pixels; below it a pixel stays sharp
+constant float kPostBlurUniformSpread = 1.0; // pixels of speed or radius a cheap tile may vary by
+constant int kPostBlurMaxSamples = 16;
+
+// Lists, in the order of TiledPostBlur::List.
+constant uint kPostBlurListMotionCopy = 0;
+constant uint kPostBlurListMotionCheap = 1;
+constant uint kPostBlurListMotionFull = 2;
+constant uint kPostBlurListDofCopy = 3;
+constant uint kPostBlurListDofComposite = 4;
+constant uint kPostBlurListDofGatherCheap = 5;
+constant uint kPostBlurListDofGatherFull = 6;
+constant uint kPostBlurListCount = 7;
+
+// Matches TiledPostBlur::ParamsGPU.
+struct PostBlurParams {
+    float4 viewport; // xy size in pixels, zw texel size
+    float4 motion;   // x velocity scale (strength), y 1 when motion blur runs
+    float4 dof;      // x focus distance, y aperture, z max blur radius in pixels, w 1 when depth of field runs
+    float4 halfRes;  // xy half-res extent in texels, zw 1 / half-res texture size
+    uint4 tiles;     // xy tile count, z entries per list
+};
+
+// Matches TiledPostBlur::TileGPU. Speeds and radii are in pixels; velocities are the blur's full
+// extent, of which each pixel spreads half either way.
+struct PostBlurTile {
+    float4 motion; // xy largest velocity, z smallest speed
+    float4 dof;    // x smallest radius, y largest radius
+};
+
+struct PostBlurCounters {
+    atomic_uint count[kPostBlurListCount];
+};
+
+constexpr sampler postBlurSampler(filter::linear, address::clamp_to_edge);
+
+static inline float postBlurLinearDepth(float depth, constant CameraUniforms& camera) {
+    float a = camera.projectionMatrix[2][2];
+    float b = camera.projectionMatrix[3][2];
+    return b / (depth + a);
+}
+
+static inline float postBlurCocRadius(float viewDepth, constant PostBlurParams& params) {
+    float focusDistance = max(params.dof.x, 0.01);
+    float apertureScale = clamp(2.8 / max(params.dof.y, 0.1), 0.25, 4.0);
+    float maxBlur = max(params.dof.z, 1.0);
+    float coc = abs(viewDepth - focusDistance) / focusDistance;
+    return clamp(coc * apertureScale * maxBlur, 0.0, maxBlur);
+}
+
+static inline uint2 postBlurTileOf(device const uint* list, uint group) {
+    uint packed = list[group];
+    return uint2(packed & 0xFFFFu, packed >> 16);
+}
+
+static inline void postBlurAppend(device PostBlurCounters& counters, device uint* lists, uint capacity,
+                                  uint list, uint packed) {
+    uint index = atomic_fetch_add_explicit(&counters.count[list], 1u, memory_order_relaxed);
+    lists[list * capacity + index] = packed;
+}
+
+// One threadgroup per tile, one thread per pixel. Sky pixels neither move nor blur.
+kernel void post_blur_tile_reduce(
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant PostBlurParams& params [[buffer(1)]],
+    device PostBlurTile* tiles [[buffer(2)]],
+    device PostBlurCounters& counters [[buffer(3)]],
+    depth2d<float, access::read> depthTex [[texture(0)]],
+    texture2d<float, access::read> velocityTex [[texture(1)]],
+    uint2 gid [[thread_position_in_grid]],
+    uint2 tgid [[threadgroup_position_in_grid]],
+    uint lid [[thread_index_in_threadgroup]]
+) {
+    threadgroup float4 motion[kPostBlurTileSize * kPostBlurTileSize];
+    threadgroup float2 dof[kPostBlurTileSize * kPostBlurTileSize];
+
+    // The lists of the previous frame were consumed by its dispatches; classify appends anew.
+    if (all(tgid == 0) && lid < kPostBlurListCount) {
+        atomic_store_explicit(&counters.count[lid], 0u, memory_order_relaxed);
+    }
+
+    float2 velocity = float2(0.0);
+    float speed = 0.0;
+    float radius = 0.0;
+    bool inside = gid.x < uint(params.viewport.x) && gid.y < uint(params.viewport.y);
+    if (inside) {
+        float depth = depthTex.read(gid);
+        if (depth < 1.0) {
+            if (params.motion.y > 0.5) {
+                velocity = velocityTex.read(gid).rg * params.motion.x * params.viewport.xy;
+                speed = length(velocity);
+            }
+            if (params.dof.w > 0.5) {
+                radius = postBlurCocRadius(postBlurLinearDepth(depth, camera), params);
+            }
+        }
+    }
+    // Pixels past the screen edge leave the minimums alone.
+    motion[lid] = float4(velocity, speed, inside ? speed : INFINITY);
+    dof[lid] = float2(inside ? radius : INFINITY, radius);
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    for (uint stride = (kPostBlurTileSize * kPostBlurTileSize) / 2; stride > 0; stride >>= 1) {
+        if (lid < stride) {
+            float4 a = motion[lid];
+            float4 b = motion[lid + stride];
+            float4 largest = (b.z > a.z) ? b : a;
+            motion[lid] = float4(largest.xyz, min(a.w, b.w));
+            dof[lid] = float2(min(dof[lid].x, dof[lid + stride].x), max(dof[lid].y, dof[lid + stride].y));
+        }
+        threadgroup_barrier(mem_flags::mem_threadgroup);
+    }
+
+    if (lid == 0) {
+        PostBlurTile tile;
+        tile.motion = float4(motion[0].xy, motion[0].w, 0.0);
+        tile.dof = float4(dof[0], 0.0, 0.0);
+        tiles[tgid.y * params.tiles.x + tgid.x] = tile;
+    }
+}
+
+// One thread per tile. The neighbourhood decides what the tile's pixels gather from, since blur
+// reaches across tile edges; the tile's own range decides whether anything in it changes.
+kernel void post_blur_tile_classify(
+    constant PostBlurParams& params [[buffer(0)]],
+    device const PostBlurTile* tiles [[buffer(1)]],
+    device PostBlurCounters& counters [[buffer(2)]],
+    device uint* lists [[buffer(3)]],
+    uint2 tid [[thread_position_in_grid]]
+) {
+    uint2 tileCount = params.tiles.xy;
+    if (tid.x >= tileCount.x || tid.y >= tileCount.y) {
+        return;
+    }
+
+    PostBlurTile own = tiles[tid.y * tileCount.x + tid.x];
+    float2 maxVelocity = own.motion.xy;
+    float minSpeed = own.motion.z;
+    float minRadius = own.dof.x;
+    float maxRadius = own.dof.y;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            int2 n = int2(tid) + int2(x, y);
+            if ((x == 0 && y == 0) || n.x < 0 || n.y < 0 || n.x >= int(tileCount.x) || n.y >= int(tileCount.y)) {
+                continue;
+            }
+            PostBlurTile neighbour = tiles[uint(n.y) * tileCount.x + uint(n.x)];
+            if (length_squared(neighbour.motion.xy) > length_squared(maxVelocity)) {
+                maxVelocity = neighbour.motion.xy;
+            }
+            minSpeed = min(minSpeed, neighbour.motion.z);
+            minRadius = min(minRadius, neighbour.dof.x);
+            maxRadius = max(maxRadius, neighbour.dof.y);
+        }
+    }
+
+    uint packed = tid.x | (tid.y << 16);
+    uint capacity = params.tiles.z;
+    if (params.motion.y > 0.5) {
+        float maxSpeed = length(maxVelocity);
+        uint list = kPostBlurListMotionFull;
+        if (maxSpeed < kPostBlurMinRadius) {
+            list = kPostBlurListMotionCopy;
+        } else if (maxSpeed - minSpeed < kPostBlurUniformSpread) {
+            list = kPostBlurListMotionCheap;
+        }
+        postBlurAppend(counters, lists, capacity, list, packed);
+    }
+    if (params.dof.w > 0.5) {
+        // The composite filters the half-res blur bilinearly across tile edges, so every tile next
+        // to a blurred one gathers too.
+        postBlurAppend(counters, lists, capacity,
+                       own.dof.y < kPostBlurMinRadius ? kPostBlurListDofCopy : kPostBlurListDofComposite, packed);
+        if (maxRadius >= kPostBlurMinRadius) {
+            postBlurAppend(counters, lists, capacity,
+                           maxRadius - minRadius < kPostBlurUniformSpread ? kPostBlurListDofGatherCheap
+                                                                           : kPostBlurListDofGatherFull,
+                           packed);
+        }
+    }
+}
+
+// Sizes one dispatch per list, a threadgroup per listed tile.
+kernel void post_blur_tile_args(
+    device PostBlurCounters& counters [[buffer(0)]],
+    device MTLDispatchThreadgroupsIndirectArguments* dispatchArgs [[buffer(1)]],
+    uint tid [[thread_position_in_grid]]
+) {
+    if (tid >= kPostBlurListCount) {
+        return;
+    }
+    dispatchArgs[tid].threadgroupsPerGrid[0] = atomic_load_explicit(&counters.count[tid], memory_order_relaxed);
+    dispatchArgs[tid].threadgroupsPerGrid[1] = 1;
+    dispatchArgs[tid].threadgroupsPerGrid[2] = 1;
+}
+
+// Tiles nothing blurs: the source passes through unchanged.
+kernel void post_blur_tile_copy(
+    constant PostBlurParams& params [[buffer(0)]],
+    device const uint* list [[buffer(1)]],
+    texture2d<float, access::read> source [[texture(0)]],
+    texture2d<float, access::write> target [[texture(1)]],
+    uint group [[threadgroup_position_in_grid]],
+    uint2 lid [[thread_position_in_threadgroup]]
+) {
+    uint2 pixel = postBlurTileOf(list, group) * kPostBlurTileSize + lid;
+    if (pixel.x >= uint(params.viewport.x) || pixel.y >= uint(params.viewport.y)) {
+        return;
+    }
+    target.write(source.read(pixel), pixel);
+}
+
+// Velocity coherent across the neighbourhood: a tent along the pixel's own velocity, with no depth
+// test since nothing moving differently can be in front of it.
+kernel void motion_blur_tile_cheap(
+    constant PostBlurParams& params [[buffer(0)]],
+    device const uint* list [[buffer(1)]],
+    texture2d<float> sceneTex [[texture(0)]],
+    depth2d<float, access::read> depthTex [[texture(1)]],
+    texture2d<float, access::read> velocityTex [[texture(2)]],
+    texture2d<float, access::write> target [[texture(3)]],
+    uint group [[threadgroup_position_in_grid]],
+    uint2 lid [[thread_position_in_threadgroup]]
+) {
+    uint2 pixel = postBlurTileOf(list, group) * kPostBlurTileSize + lid;
+    if (pixel.x >= uint(params.viewport.x) || pixel.y >= uint(params.viewport.y)) {
+        return;
+    }
+    float2 uv = (float2(pixel) + 0.5) * params.viewport.zw;
+    float4 current = sceneTex.read(pixel);
+    float2 velocity = velocityTex.read(pixel).rg * params.motion.x;
+    float speed = length(velocity * params.viewport.xy);
+    if (depthTex.read(pixel) >= 1.0 || speed < kPostBlurMinRadius) {
+        target.write(current, pixel);
+        return;
+    }
+
+    int sampleCount = clamp(int(ceil(speed * 0.5)), 4, kPostBlurMaxSamples);
+    float3 accum = float3(0.0);
+    float weightSum = 0.0;
+    for (int i = 0; i < sampleCount; ++i) {
+        float t = (float(i) / float(sampleCount - 1)) - 0.5;
+        float2 sampleUV = uv + velocity * t;
+        if (any(sampleUV < 0.0) || any(sampleUV > 1.0)) {
+            continue;
+        }
+        float w = max(0.0, 1.0 - abs(t) * 2.0);
+        accum += sceneTex.sample(postBlurSampler, sampleUV, level(0.0)).rgb * w;
+        weightSum += w;
+    }
+    float3 color = (weightSum > 0.0) ? (accum / weightSum) : current.rgb;
+    target.write(float4(color, current.a), pixel);
+}
+
+// Differing velocities nearby: samples along the neighbourhood's largest velocity, so fast objects
+// smear over the slower pixels around them, and weighs each sample by whether it lies in front of
+// the pixel and whose blur covers the distance between them.
+kernel void motion_blur_tile_full(
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant PostBlurParams& params [[buffer(1)]],
+    device const uint* list [[buffer(2)]],
+    device const PostBlurTile* tiles [[buffer(3)]],
+    texture2d<float> sceneTex [[texture(0)]],
+    depth2d<float> depthTex [[texture(1)]],
+    texture2d<float> velocityTex [[texture(2)]],
+    texture2d<float, access::write> target [[texture(3)]],
+    uint group [[threadgroup_position_in_grid]],
+    uint2 lid [[thread_position_in_threadgroup]]
+) {
+    uint2 tile = postBlurTileOf(list, group);
+    uint2 pixel = tile * kPostBlurTileSize + lid;
+    if (pixel.x >= uint(params.viewport.x) || pixel.y >= uint(params.viewport.y)) {
+        return;
+    }
+    float4 current = sceneTex.read(pixel);
+    float depth = depthTex.read(pixel);
+    if (depth >= 1.0) {
+        target.write(current, pixel);
+        return;
+    }
+
+    // The neighbourhood's largest velocity, found again rather than stored by classify.
+    float2 maxVelocity = float2(0.0);
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            int2 n = clamp(int2(tile) + int2(x, y), int2(0), int2(params.tiles.xy) - 1);
+            float2 v = tiles[uint(n.y) * params.tiles.x + uint(n.x)].motion.xy;
+            maxVelocity = (length_squared(v) > length_squared(maxVelocity)) ? v : maxVelocity;
+        }
+    }
+
+    float2 uv = (float2(pixel) + 0.5) * params.viewport.zw;
+    float centerLinear = postBlurLinearDepth(depth, camera);
+    float centerRadius = length(velocityTex.read(pixel).rg * params.motion.x * params.viewport.xy) * 0.5;
+    float softZ = max(0.35, centerLinear * 0.08);
+    float maxSpeed = length(maxVelocity);
+    int sampleCount = clamp(int(ceil(maxSpeed * 0.5)), 4, kPostBlurMaxSamples);
+
+    float centerWeight = 1.0 / max(centerRadius, 1.0);
+    float3 accum = current.rgb * centerWeight;
+    float weightSum = centerWeight;
+    for (int i = 0; i < sampleCount; ++i) {
+        float t = (float(i) / float(sampleCount - 1)) - 0.5;
+        float2 offset = maxVelocity * t;
+        float distance = length(offset);
+        if (distance < 0.5) {
+            continue;
+        }
+        float2 sampleUV = uv + offset * params.viewport.zw;
+        if (any(sampleUV < 0.0) || any(sampleUV > 1.0)) {
+            continue;
+        }
+        float sampleDepth = depthTex.sample(postBlurSampler, sampleUV, level(0.0));
+        if (sampleDepth >= 1.0) {
+            continue;
+        }
+        float sampleLinear = postBlurLinearDepth(sampleDepth, camera);
+        float sampleRadius = length(velocityTex.sample(postBlurSampler, sampleUV, level(0.0)).rg
+                                    * params.motion.x * params.viewport.xy) * 0.5;
+        float inFront = saturate(1.0 - (sampleLinear - centerLinear) / softZ);
+        float behind = saturate(1.0 - (centerLinear - sampleLinear) / softZ);
+        float coneSample = saturate(1.0 - distance / max(sampleRadius, 0.001));
+        float coneCenter = saturate(1.0 - distance / max(centerRadius, 0.001));
+        float cylinders = (1.0 - smoothstep(0.95 * sampleRadius, 1.05 * sampleRadius, distance))
+                        * (1.0 - smoothstep(0.95 * centerRadius, 1.05 * centerRadius, distance));
+        float w = inFront * coneSample + behind * coneCenter + cylinders * 2.0;
+        if (w <= 0.0001) {
+            continue;
+        }
+        accum += sceneTex.sample(postBlurSampler, sampleUV, level(0.0)).rgb * w;
+        weightSum += w;
+    }
+    target.write(float4(accum / weightSum, current.a), pixel);
+}
+
+// Half-res depth of field gather, one thread per half-res texel of the tile. The full class keeps
+// dof_fragment's depth and CoC weights; the cheap one, for neighbourhoods of one blur radius,
+// averages the disk without reading depth.
+static inline void dofTileGather(
+    bool weighted,
+    constant CameraUniforms& camera,
+    constant PostBlurParams& params,
+    device const uint* list,
+    texture2d<float> sceneTex,
+    depth2d<float> depthTex,
+    texture2d<float, access::write> halfTarget,
+    uint group,
+    uint2 lid
+) {
+    uint2 texel = postBlurTileOf(list, group) * kPostBlurHalfTileSize + lid;
+    if (texel.x >= uint(params.halfRes.x) || texel.y >= uint(params.halfRes.y)) {
+        return;
+    }
+    // The 2x2 block's center, so the bilinear taps average the block.
+    float2 uv = min((float2(texel) * 2.0 + 1.0) * params.viewport.zw, float2(1.0));
+    float3 current = sceneTex.sample(postBlurSampler, uv, level(0.0)).rgb;
+    float depth = depthTex.sample(postBlurSampler, uv, level(0.0));
+    if (depth >= 1.0) {
+        halfTarget.write(float4(current, 1.0), texel);
+        return;
+    }
+
+    float viewDepth = postBlurLinearDepth(depth, camera);
+    float maxBlur = max(params.dof.z, 1.0);
+    float radius = postBlurCocRadius(viewDepth, params);
+    if (radius < kPostBlurMinRadius) {
+        halfTarget.write(float4(current, 1.0), texel);
+        return;
+    }
+
+    int sampleCount = clamp(int(ceil(radius * 0.75)), 4, kPostBlurMaxSamples);
+    float3 accum = current;
+    float weightSum = 1.0;
+    const float golden = 2.399963;
+    for (int i = 0; i < sampleCount; ++i) {
+        float t = (float(i) + 0.5) / float(sampleCount);
+        float r = radius * sqrt(t);
+        float theta = float(i) * golden;
+        float2 sampleUV = uv + float2(cos(theta), sin(theta)) * r * params.viewport.zw;
+        if (any(sampleUV < 0.0) || any(sampleUV > 1.0)) {
+            continue;
+        }
+        float w = 1.0 - t * 0.5;
+        if (weighted) {
+            float sampleDepth = depthTex.sample(postBlurSampler, sampleUV, level(0.0));
+            if (sampleDepth >= 1.0) {
+                continue;
+            }
+            float sampleViewDepth = postBlurLinearDepth(sampleDepth, camera);
+            float sampleRadius = postBlurCocRadius(sampleViewDepth, params);
+            float cocWeight = 1.0 - smoothstep(maxBlur * 0.1, maxBlur, abs(sampleRadius - radius));
+            float depthWeight = 1.0 - smoothstep(max(0.5, radius * 0.5), max(1.5, radius * 2.0),
+                                                 abs(sampleViewDepth - viewDepth));
+            w *= max(cocWeight, 0.1) * max(depthWeight, 0.05);
+        }
+        accum += sceneTex.sample(postBlurSampler, sampleUV, level(0.0)).rgb * w;
+        weightSum += w;
+    }
+    halfTarget.write(float4(accum / weightSum, 1.0), texel);
+}
+
+kernel void dof_tile_gather_cheap(
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant PostBlurParams& params [[buffer(1)]],
+    device const uint* list [[buffer(2)]],
+    texture2d<float> sceneTex [[texture(0)]],
+    depth2d<float> depthTex [[texture(1)]],
+    texture2d<float, access::write> halfTarget [[texture(2)]],
+    uint group [[threadgroup_position_in_grid]],
+    uint2 lid [[thread_position_in_threadgroup]]
+) {
+    dofTileGather(false, camera, params, list, sceneTex, depthTex, halfTarget, group, lid);
+}
+
+kernel void dof_tile_gather_full(
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant PostBlurParams& params [[buffer(1)]],
+    device const uint* list [[buffer(2)]],
+    texture2d<float> sceneTex [[texture(0)]],
+    depth2d<float> depthTex [[texture(1)]],
+    texture2d<float, access::write> halfTarget [[texture(2)]],
+    uint group [[threadgroup_position_in_grid]],
+    uint2 lid [[thread_position_in_threadgroup]]
+) {
+    dofTileGather(true, camera, params, list, sceneTex, depthTex, halfTarget, group, lid);
+}
+
+// Full-res pixels of blurred tiles: the half-res gather, upsampled bilinearly, blended in by the
+// pixel's own CoC so in-focus pixels keep their full-res detail.
+kernel void dof_tile_composite(
+    constant CameraUniforms& camera [[buffer(0)]],
+    constant PostBlurParams& params [[buffer(1)]],
+    device const uint* list [[buffer(2)]],
+    texture2d<float, access::read> sceneTex [[texture(0)]],
+    depth2d<float, access::read> depthTex [[texture(1)]],
+    texture2d<float> halfBlur [[texture(2)]],
+    texture2d<float, access::write> target [[texture(3)]],
+    uint group [[threadgroup_position_in_grid]],
+    uint2 lid [[thread_position_in_threadgroup]]
+) {
+    uint2 pixel = postBlurTileOf(list, group) * kPostBlurTileSize + lid;
+    if (pixel.x >= uint(params.viewport.x) || pixel.y >= uint(params.viewport.y)) {
+        return;
+    }
+    float4 current = sceneTex.read(pixel);
+    float depth = depthTex.read(pixel);
+    float radius = (depth < 1.0) ? postBlurCocRadius(postBlurLinearDepth(depth, camera), params) : 0.0;
+    if (radius < kPostBlurMinRadius) {
+        target.write(current, pixel);
+        return;
+    }
+    // The half-res texture may be larger than this view's extent; stay inside the written part.
+    float2 halfCoord = clamp((float2(pixel) + 0.5) * 0.5, float2(0.5), params.halfRes.xy - 0.5);
+    float3 blurred = halfBlur.sample(postBlurSampler, halfCoord * params.halfRes.zw, level(0.0)).rgb;
+    float blend = smoothstep(kPostBlurMinRadius, 1.5, radius);
+    target.write(float4(mix(current.rgb, blurred, blend), current.a), pixel);
+}
@@ -0,0 +1,52 @@
+#include "Common.metal.h"
+using namespace metal;
+
+// Passes of the rate-mapped main pass (VariableRateShading). The main pass rasterizes into
+// physical-size targets through a rasterization rate map; these move data between that
+// compressed space and screen space.
+
+struct RateMapVertexOut {
+    float4 position [[position]];
+};
+
+vertex RateMapVertexOut rate_map_vertex(uint vertexId [[vertex_id]]) {
+    RateMapVertexOut out;
+    float2 pos = float2((vertexId << 1) & 2, vertexId & 2) * 2.0 - 1.0;
+    out.position = float4(pos, 0.0, 1.0);
+    return out;
+}
+
+struct RateMapDepthOut {
+    float depth [[depth(any)]];
+};
+
+// Drawn first in the rate-mapped pass, so [[position]] is in physical pixels. A physical pixel
+// stands for a block of screen pixels; priming it with the farthest of the four prepass texels
+// around its screen position keeps the main pass's LessEqual test from rejecting the surface the
+// prepass found there.
+fragment RateMapDepthOut rate_map_depth_prime_fragment(
+    RateMapVertexOut in [[stage_in]],
+    constant rasterization_rate_map_data& rateMap [[buffer(0)]],
+    depth2d<float> screenDepth [[texture(0)]]
+) {
+    constexpr sampler pointSampler(coord::normalized, filter::nearest, address::clamp_to_edge);
+    rasterization_rate_map_decoder decoder(rateMap);
+    float2 screen = decoder.map_physical_to_screen_coordinates(in.position.xy);
+    float2 screenSize = float2(screenDepth.get_width(), screenDepth.get_height());
+    float4 depths = screenDepth.gather(pointSampler, screen / screenSize);
+    RateMapDepthOut out;
+    out.depth = max(max(depths.x, depths.y), max(depths.z, depths.w));
+    return out;
+}
+
+// Expands the physical color target back to screen size.
+fragment float4 rate_map_resolve_fragment(
+    RateMapVertexOut in [[stage_in]],
+    constant rasterization_rate_map_data& rateMap [[buffer(0)]],
+    texture2d<float> physicalColor [[texture(0)]]
+) {
+    constexpr sampler linearSampler(coord::pixel, filter::linear, address::clamp_to_edge);
+    rasterization_rate_map_decoder decoder(rateMap);
+    float2 physical = decoder.map_screen_to_physical_coordinates(in.position.xy);
+    return physicalColor.sample(linearSampler, physical);
+}
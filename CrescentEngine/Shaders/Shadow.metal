@@ -72,6 +72,41 @@ struct PointShadowDepthOut {
     float depth [[depth(any)]];
 };
 
+// Views of a layered pass (ShadowRenderPass::flushLayeredViews): each caster draw is amplified
+// into the views it overlaps, and its selection maps the amplification ids to those views. A view
+// renders into its own array slice through the viewport of the same index.
+struct ShadowLayeredViews {
+    float4x4 viewProj[6];
+    uint layer[6];
+    uint pad0;
+    uint pad1;
+    float4 pointLightPosNear;
+    float4 pointFarParams;
+};
+
+struct ShadowLayeredSelection {
+    uint view[6];
+    uint pad0;
+    uint pad1;
+};
+
+struct ShadowLayeredOut {
+    float4 position [[position]];
+    float2 uv;
+    uint layer [[render_target_array_index]];
+    uint viewport [[viewport_array_index]];
+};
+
+struct PointShadowLayeredOut {
+    float4 position [[position]];
+    float2 uv;
+    float3 worldPos;
+    float3 lightPos;
+    float2 nearFar;
+    uint layer [[render_target_array_index]];
+    uint viewport [[viewport_array_index]];
+};
+
 inline void shadowAlphaClip(float alpha, float cutoff) {
     float aa = max(fwidth(alpha) * 0.85, 0.004);
     float coverage = smoothstep(cutoff - aa, cutoff + aa, alpha);
@@ -97,12 +132,48 @@ inline float3 applyWindOffsetShadow(float3 worldPos,
     return worldPos + dir * (sway + gust);
 }
 
+inline float3 shadowObjectWorld(float3 localPos,
+                                constant ShadowObjectUniforms& object,
+                                constant ShadowFoliageParams& foliage) {
+    float3 worldPos = (object.modelMatrix * float4(localPos, 1.0)).xyz;
+    return applyWindOffsetShadow(worldPos, foliage);
+}
+
 inline float4 shadowObjectVertex(float3 localPos,
                                  constant ShadowObjectUniforms& object,
                                  constant ShadowFoliageParams& foliage) {
-    float3 worldPos = (object.modelMatrix * float4(localPos, 1.0)).xyz;
-    worldPos = applyWindOffsetShadow(worldPos, foliage);
-    return object.viewProj * float4(worldPos, 1.0);
+    return object.viewProj * float4(shadowObjectWorld(localPos, object, foliage), 1.0);
+}
+
+inline ShadowLayeredOut shadowLayeredVertex(float3 worldPos,
+                                            float2 uv,
+                                            constant ShadowLayeredViews& views,
+                                            constant ShadowLayeredSelection& selection,
+                                            uint amplificationId) {
+    uint view = selection.view[amplificationId];
+    ShadowLayeredOut out;
+    out.position = views.viewProj[view] * float4(worldPos, 1.0);
+    out.uv = uv;
+    out.layer = views.layer[view];
+    out.viewport = view;
+    return out;
+}
+
+inline PointShadowLayeredOut pointShadowLayeredVertex(float3 worldPos,
+                                                      float2 uv,
+                                                      constant ShadowLayeredViews& views,
+                                                      constant ShadowLayeredSelection& selection,
+                                                      uint amplificationId) {
+    uint view = selection.view[amplificationId];
+    PointShadowLayeredOut out;
+    out.position = views.viewProj[view] * float4(worldPos, 1.0);
+    out.uv = uv;
+    out.worldPos = worldPos;
+    out.lightPos = views.pointLightPosNear.xyz;
+    out.nearFar = float2(views.pointLightPosNear.w, views.pointFarParams.x);
+    out.layer = views.layer[view];
+    out.viewport = view;
+    return out;
 }
 
 inline float4 applySkinning(ShadowVertexInSkinned in, const device float4x4* bones) {
@@ -133,15 +204,15 @@ inline float4 applySkinning(ShadowVertexInSkinnedUV in, const device float4x4* b
     return skin * localPos;
 }
 
-fragment void shadow_alpha_fragment(ShadowOut in [[stage_in]],
-                                    constant ShadowMaterial& material [[buffer(0)]],
-                                    texture2d<float> albedoMap [[texture(0)]],
-                                    texture2d<float> opacityMap [[texture(1)]],
-                                    sampler alphaSampler [[sampler(0)]]) {
+inline void shadowAlphaTest(float2 texCoord,
+                            constant ShadowMaterial& material,
+                            texture2d<float> albedoMap,
+                            texture2d<float> opacityMap,
+                            sampler alphaSampler) {
     if (material.alphaParams.z < 0.5) {
         return;
     }
-    float2 uv = in.uv * material.uvTilingOffset.xy + material.uvTilingOffset.zw;
+    float2 uv = texCoord * material.uvTilingOffset.xy + material.uvTilingOffset.zw;
     float alpha = material.albedo.a;
     if (material.alphaParams.y > 0.5) {
         float2 texSize = float2(albedoMap.get_width(), albedoMap.get_height());
@@ -170,6 +241,27 @@ fragment void shadow_alpha_fragment(ShadowOut in [[stage_in]],
     shadowAlphaClip(alpha, material.alphaParams.x);
 }
 
+inline float pointShadowDepth(float3 worldPos, float3 lightPos, float2 nearFar) {
+    float dist = length(worldPos - lightPos);
+    return saturate((dist - nearFar.x) / max(nearFar.y - nearFar.x, 1e-5));
+}
+
+fragment void shadow_alpha_fragment(ShadowOut in [[stage_in]],
+                                    constant ShadowMaterial& material [[buffer(0)]],
+                                    texture2d<float> albedoMap [[texture(0)]],
+                                    texture2d<float> opacityMap [[texture(1)]],
+                                    sampler alphaSampler [[sampler(0)]]) {
+    shadowAlphaTest(in.uv, material, albedoMap, opacityMap, alphaSampler);
+}
+
+fragment void shadow_alpha_fragment_layered(ShadowLayeredOut in [[stage_in]],
+                                            constant ShadowMaterial& material [[buffer(0)]],
+                                            texture2d<float> albedoMap [[texture(0)]],
+                                            texture2d<float> opacityMap [[texture(1)]],
+                                            sampler alphaSampler [[sampler(0)]]) {
+    shadowAlphaTest(in.uv, material, albedoMap, opacityMap, alphaSampler);
+}
+
 // Depth-only vertex for directional cascades and projected shadows.
 vertex float4 shadow_dir_vertex(ShadowVertexIn in [[stage_in]],
                                 constant ShadowObjectUniforms& object [[buffer(1)]],
@@ -509,10 +601,7 @@ vertex PointShadowOutUV shadow_point_vertex_cutout_skinned(ShadowVertexInSkinned
 
 fragment PointShadowDepthOut shadow_point_fragment(PointShadowOut in [[stage_in]]) {
     PointShadowDepthOut out;
-    float nearP = in.nearFar.x;
-    float farP = in.nearFar.y;
-    float dist = length(in.worldPos - in.lightPos);
-    out.depth = saturate((dist - nearP) / max(farP - nearP, 1e-5));
+    out.depth = pointShadowDepth(in.worldPos, in.lightPos, in.nearFar);
     return out;
 }
 
@@ -521,35 +610,113 @@ fragment PointShadowDepthOut shadow_point_fragment_cutout(PointShadowOutUV in [[
                                                           texture2d<float> albedoMap [[texture(0)]],
                                                           texture2d<float> opacityMap [[texture(1)]],
                                                           sampler alphaSampler [[sampler(0)]]) {
-    if (material.alphaParams.z >= 0.5) {
-        float2 uv = in.uv * material.uvTilingOffset.xy + material.uvTilingOffset.zw;
-        float alpha = material.albedo.a;
-        if (material.alphaParams.y > 0.5) {
-            float2 texSize = float2(albedoMap.get_width(), albedoMap.get_height());
-            float2 duvDx = dfdx(uv) * texSize;
-            float2 duvDy = dfdy(uv) * texSize;
-            float footprint = max(length(duvDx), length(duvDy));
-            float mipLevel = clamp(log2(max(footprint, 1.0)), 0.0, 4.0);
-            float shadowMip = max(mipLevel - 0.35, 0.0);
-            alpha *= albedoMap.sample(alphaSampler, uv, level(shadowMip)).a;
-            float cutoffScale = mix(1.0, 0.80, saturate(mipLevel / 4.0));
-            float cutoff = material.alphaParams.x * cutoffScale;
-            if (material.alphaParams.w > 0.5) {
-                alpha *= opacityMap.sample(alphaSampler, uv, level(shadowMip)).r;
-            }
-            shadowAlphaClip(alpha, cutoff);
-        } else {
-            if (material.alphaParams.w > 0.5) {
-                alpha *= opacityMap.sample(alphaSampler, uv).r;
-            }
-            shadowAlphaClip(alpha, material.alphaParams.x);
-        }
-    }
+    shadowAlphaTest(in.uv, material, albedoMap, opacityMap, alphaSampler);
     PointShadowDepthOut out;
-    float nearP = in.nearFar.x;
-    float farP = in.nearFar.y;
-    float dist = length(in.worldPos - in.lightPos);
-    out.depth = saturate((dist - nearP) / max(farP - nearP, 1e-5));
+    out.depth = pointShadowDepth(in.worldPos, in.lightPos, in.nearFar);
+    return out;
+}
+
+// Layered variants: one draw covers every cascade or cube face the caster overlaps, each
+// amplified copy picking its view from the draw's selection (buffer 6) and the pass's views
+// (buffer 5).
+vertex ShadowLayeredOut shadow_dir_vertex_layered(ShadowVertexIn in [[stage_in]],
+                                                  constant ShadowObjectUniforms& object [[buffer(1)]],
+                                                  constant ShadowFoliageParams& foliage [[buffer(3)]],
+                                                  constant ShadowLayeredViews& views [[buffer(5)]],
+                                                  constant ShadowLayeredSelection& selection [[buffer(6)]],
+                                                  uint amplificationId [[amplification_id]]) {
+    return shadowLayeredVertex(shadowObjectWorld(in.position, object, foliage), float2(0.0),
+                               views, selection, amplificationId);
+}
+
+vertex ShadowLayeredOut shadow_dir_vertex_cutout_layered(ShadowVertexInUV in [[stage_in]],
+                                                         constant ShadowObjectUniforms& object [[buffer(1)]],
+                                                         constant ShadowFoliageParams& foliage [[buffer(3)]],
+                                                         constant ShadowLayeredViews& views [[buffer(5)]],
+                                                         constant ShadowLayeredSelection& selection [[buffer(6)]],
+                                                         uint amplificationId [[amplification_id]]) {
+    return shadowLayeredVertex(shadowObjectWorld(in.position, object, foliage), in.texCoord,
+                               views, selection, amplificationId);
+}
+
+vertex ShadowLayeredOut shadow_dir_vertex_skinned_layered(ShadowVertexInSkinned in [[stage_in]],
+                                                          constant ShadowObjectUniforms& object [[buffer(1)]],
+                                                          const device float4x4* bones [[buffer(2)]],
+                                                          constant ShadowFoliageParams& foliage [[buffer(3)]],
+                                                          constant ShadowLayeredViews& views [[buffer(5)]],
+                                                          constant ShadowLayeredSelection& selection [[buffer(6)]],
+                                                          uint amplificationId [[amplification_id]]) {
+    return shadowLayeredVertex(shadowObjectWorld(applySkinning(in, bones).xyz, object, foliage), float2(0.0),
+                               views, selection, amplificationId);
+}
+
+vertex ShadowLayeredOut shadow_dir_vertex_cutout_skinned_layered(ShadowVertexInSkinnedUV in [[stage_in]],
+                                                                 constant ShadowObjectUniforms& object [[buffer(1)]],
+                                                                 const device float4x4* bones [[buffer(2)]],
+                                                                 constant ShadowFoliageParams& foliage [[buffer(3)]],
+                                                                 constant ShadowLayeredViews& views [[buffer(5)]],
+                                                                 constant ShadowLayeredSelection& selection [[buffer(6)]],
+                                                                 uint amplificationId [[amplification_id]]) {
+    return shadowLayeredVertex(shadowObjectWorld(applySkinning(in, bones).xyz, object, foliage), in.texCoord,
+                               views, selection, amplificationId);
+}
+
+vertex PointShadowLayeredOut shadow_point_vertex_layered(ShadowVertexIn in [[stage_in]],
+                                                         constant ShadowObjectUniforms& object [[buffer(1)]],
+                                                         constant ShadowFoliageParams& foliage [[buffer(3)]],
+                                                         constant ShadowLayeredViews& views [[buffer(5)]],
+                                                         constant ShadowLayeredSelection& selection [[buffer(6)]],
+                                                         uint amplificationId [[amplification_id]]) {
+    return pointShadowLayeredVertex(shadowObjectWorld(in.position, object, foliage), float2(0.0),
+                                    views, selection, amplificationId);
+}
+
+vertex PointShadowLayeredOut shadow_point_vertex_cutout_layered(ShadowVertexInUV in [[stage_in]],
+                                                                constant ShadowObjectUniforms& object [[buffer(1)]],
+                                                                constant ShadowFoliageParams& foliage [[buffer(3)]],
+                                                                constant ShadowLayeredViews& views [[buffer(5)]],
+                                                                constant ShadowLayeredSelection& selection [[buffer(6)]],
+                                                                uint amplificationId [[amplification_id]]) {
+    return pointShadowLayeredVertex(shadowObjectWorld(in.position, object, foliage), in.texCoord,
+                                    views, selection, amplificationId);
+}
+
+vertex PointShadowLayeredOut shadow_point_vertex_skinned_layered(ShadowVertexInSkinned in [[stage_in]],
+                                                                 constant ShadowObjectUniforms& object [[buffer(1)]],
+                                                                 const device float4x4* bones [[buffer(2)]],
+                                                                 constant ShadowFoliageParams& foliage [[buffer(3)]],
+                                                                 constant ShadowLayeredViews& views [[buffer(5)]],
+                                                                 constant ShadowLayeredSelection& selection [[buffer(6)]],
+                                                                 uint amplificationId [[amplification_id]]) {
+    return pointShadowLayeredVertex(shadowObjectWorld(applySkinning(in, bones).xyz, object, foliage), float2(0.0),
+                                    views, selection, amplificationId);
+}
+
+vertex PointShadowLayeredOut shadow_point_vertex_cutout_skinned_layered(ShadowVertexInSkinnedUV in [[stage_in]],
+                                                                        constant ShadowObjectUniforms& object [[buffer(1)]],
+                                                                        const device float4x4* bones [[buffer(2)]],
+                                                                        constant ShadowFoliageParams& foliage [[buffer(3)]],
+                                                                        constant ShadowLayeredViews& views [[buffer(5)]],
+                                                                        constant ShadowLayeredSelection& selection [[buffer(6)]],
+                                                                        uint amplificationId [[amplification_id]]) {
+    return pointShadowLayeredVertex(shadowObjectWorld(applySkinning(in, bones).xyz, object, foliage), in.texCoord,
+                                    views, selection, amplificationId);
+}
+
+fragment PointShadowDepthOut shadow_point_fragment_layered(PointShadowLayeredOut in [[stage_in]]) {
+    PointShadowDepthOut out;
+    out.depth = pointShadowDepth(in.worldPos, in.lightPos, in.nearFar);
+    return out;
+}
+
+fragment PointShadowDepthOut shadow_point_fragment_cutout_layered(PointShadowLayeredOut in [[stage_in]],
+                                                                  constant ShadowMaterial& material [[buffer(0)]],
+                                                                  texture2d<float> albedoMap [[texture(0)]],
+                                                                  texture2d<float> opacityMap [[texture(1)]],
+                                                                  sampler alphaSampler [[sampler(0)]]) {
+    shadowAlphaTest(in.uv, material, albedoMap, opacityMap, alphaSampler);
+    PointShadowDepthOut out;
+    out.depth = pointShadowDepth(in.worldPos, in.lightPos, in.nearFar);
     return out;
 }
 
@@ -650,3 +817,175 @@ vertex ShadowOut shadow_area_vertex_cutout_skinned(ShadowVertexInSkinnedUV in [[
     out.uv = in.texCoord;
     return out;
 }
+
+// Crowd instances (CrowdAnimation.cpp) skin with their own palette, starting at the matrix index
+// in normalMatrix[3].y. The skin weights stream takes buffer 4, so the point light parameters
+// move to 6 and 7.
+inline float3 shadowCrowdWorldPosition(ShadowVertexInSkinned in,
+                                       const device InstanceData* instances,
+                                       const device float4x4* palettes,
+                                       uint instanceId) {
+    InstanceData inst = instances[instanceId];
+    const device float4x4* bones = palettes + uint(inst.normalMatrix[3].y);
+    return (inst.modelMatrix * applySkinning(in, bones)).xyz;
+}
+
+vertex float4 shadow_dir_vertex_skinned_instanced(ShadowVertexInSkinned in [[stage_in]],
+                                                  constant float4x4& viewProj [[buffer(1)]],
+                                                  const device InstanceData* instances [[buffer(2)]],
+                                                  const device float4x4* palettes [[buffer(5)]],
+                                                  uint instanceId [[instance_id]]) {
+    return viewProj * float4(shadowCrowdWorldPosition(in, instances, palettes, instanceId), 1.0);
+}
+
+vertex float4 shadow_spot_vertex_skinned_instanced(ShadowVertexInSkinned in [[stage_in]],
+                                                   constant float4x4& viewProj [[buffer(1)]],
+                                                   const device InstanceData* instances [[buffer(2)]],
+                                                   const device float4x4* palettes [[buffer(5)]],
+                                                   uint instanceId [[instance_id]]) {
+    return viewProj * float4(shadowCrowdWorldPosition(in, instances, palettes, instanceId), 1.0);
+}
+
+vertex float4 shadow_area_vertex_skinned_instanced(ShadowVertexInSkinned in [[stage_in]],
+                                                   constant float4x4& viewProj [[buffer(1)]],
+                                                   const device InstanceData* instances [[buffer(2)]],
+                                                   const device float4x4* palettes [[buffer(5)]],
+                                                   uint instanceId [[instance_id]]) {
+    return viewProj * float4(shadowCrowdWorldPosition(in, instances, palettes, instanceId), 1.0);
+}
+
+vertex PointShadowOut shadow_point_vertex_skinned_instanced(ShadowVertexInSkinned in [[stage_in]],
+                                                            constant float4x4& viewProj [[buffer(1)]],
+                                                            const device InstanceData* instances [[buffer(2)]],
+                                                            const device float4x4* palettes [[buffer(5)]],
+                                                            constant float4& pointLightPosNear [[buffer(6)]],
+                                                            constant float4& pointFarParams [[buffer(7)]],
+                                                            uint instanceId [[instance_id]]) {
+    PointShadowOut out;
+    float3 worldPos = shadowCrowdWorldPosition(in, instances, palettes, instanceId);
+    out.position = viewProj * float4(worldPos, 1.0);
+    out.worldPos = worldPos;
+    out.lightPos = pointLightPosNear.xyz;
+    out.nearFar = float2(pointLightPosNear.w, pointFarParams.x);
+    return out;
+}
+
+// Vertex animation texture playback (vertex_vat_instanced in PBR.metal). The clip parameters take
+// the foliage slot, which these draws do not use.
+inline float3 shadowVatWorldPosition(const device InstanceData* instances,
+                                     constant VertexAnimationParams& vat,
+                                     texture2d<float> vatTexture,
+                                     uint vertexId,
+                                     uint instanceId) {
+    InstanceData inst = instances[instanceId];
+    float3 position;
+    float3 normal;
+    vatSample(vatTexture, vat, inst, vertexId, position, normal);
+    return (inst.modelMatrix * float4(position, 1.0)).xyz;
+}
+
+vertex float4 shadow_dir_vertex_vat_instanced(ShadowVertexIn in [[stage_in]],
+                                              constant float4x4& viewProj [[buffer(1)]],
+                                              const device InstanceData* instances [[buffer(2)]],
+                                              constant VertexAnimationParams& vat [[buffer(3)]],
+                                              texture2d<float> vatTexture [[texture(0)]],
+                                              uint vertexId [[vertex_id]],
+                                              uint instanceId [[instance_id]]) {
+    return viewProj * float4(shadowVatWorldPosition(instances, vat, vatTexture, vertexId, instanceId), 1.0);
+}
+
+// Terrain patches cast into the sun cascades only; each cascade selects its own, coarser patches.
+vertex float4 shadow_dir_vertex_terrain_instanced(ShadowVertexIn in [[stage_in]],
+                                                  constant float4x4& viewProj [[buffer(1)]],
+                                                  const device InstanceData* instances [[buffer(2)]],
+                                                  constant TerrainParams& terrain [[buffer(3)]],
+                                                  texture2d_array<float, access::read> terrainHeights [[texture(0)]],
+                                                  uint instanceId [[instance_id]]) {
+    TerrainVertex surface = terrainVertex(in.position, instances[instanceId], terrainHeights, terrain, false);
+    return viewProj * float4(surface.worldPosition, 1.0);
+}
+
+vertex float4 shadow_spot_vertex_vat_instanced(ShadowVertexIn in [[stage_in]],
+                                               constant float4x4& viewProj [[buffer(1)]],
+                                               const device InstanceData* instances [[buffer(2)]],
+                                               constant VertexAnimationParams& vat [[buffer(3)]],
+                                               texture2d<float> vatTexture [[texture(0)]],
+                                               uint vertexId [[vertex_id]],
+                                               uint instanceId [[instance_id]]) {
+    return viewProj * float4(shadowVatWorldPosition(instances, vat, vatTexture, vertexId, instanceId), 1.0);
+}
+
+vertex float4 shadow_area_vertex_vat_instanced(ShadowVertexIn in [[stage_in]],
+                                               constant float4x4& viewProj [[buffer(1)]],
+                                               const device InstanceData* instances [[buffer(2)]],
+                                               constant VertexAnimationParams& vat [[buffer(3)]],
+                                               texture2d<float> vatTexture [[texture(0)]],
+                                               uint vertexId [[vertex_id]],
+                                               uint instanceId [[instance_id]]) {
+    return viewProj * float4(shadowVatWorldPosition(instances, vat, vatTexture, vertexId, instanceId), 1.0);
+}
+
+vertex PointShadowOut shadow_point_vertex_vat_instanced(ShadowVertexIn in [[stage_in]],
+                                                        constant float4x4& viewProj [[buffer(1)]],
+                                                        const device InstanceData* instances [[buffer(2)]],
+                                                        constant VertexAnimationParams& vat [[buffer(3)]],
+                                                        constant float4& pointLightPosNear [[buffer(4)]],
+                                                        constant float4& pointFarParams [[buffer(5)]],
+                                                        texture2d<float> vatTexture [[texture(0)]],
+                                                        uint vertexId [[vertex_id]],
+                                                        uint instanceId [[instance_id]]) {
+    PointShadowOut out;
+    float3 worldPos = shadowVatWorldPosition(instances, vat, vatTexture, vertexId, instanceId);
+    out.position = viewProj * float4(worldPos, 1.0);
+    out.worldPos = worldPos;
+    out.lightPos = pointLightPosNear.xyz;
+    out.nearFar = float2(pointLightPosNear.w, pointFarParams.x);
+    return out;
+}
+
+// Min/max depth mips of the shadow atlas, rebuilt after every ShadowRenderPass::execute. Level 0
+// holds the depth range of each 2x2 atlas block and every level above it halves the previous
+// one; a source with an odd size folds its last row or column into the last texel, so every
+// level covers the whole atlas and the ranges stay conservative. PBR.metal's filters read them to
+// skip fully lit or fully shadowed footprints and to estimate the PCSS blocker depth.
+kernel void shadow_bounds_init(depth2d<float, access::read> atlas [[texture(0)]],
+                               texture2d<float, access::write> bounds [[texture(1)]],
+                               uint2 gid [[thread_position_in_grid]]) {
+    uint2 size = uint2(bounds.get_width(), bounds.get_height());
+    if (gid.x >= size.x || gid.y >= size.y) {
+        return;
+    }
+    uint2 srcSize = uint2(atlas.get_width(), atlas.get_height());
+    uint2 begin = gid * 2u;
+    uint2 end = select(min(begin + 2u, srcSize), srcSize, gid == size - 1u);
+    float lo = 1.0;
+    float hi = 0.0;
+    for (uint y = begin.y; y < end.y; ++y) {
+        for (uint x = begin.x; x < end.x; ++x) {
+            float d = atlas.read(uint2(x, y));
+            lo = min(lo, d);
+            hi = max(hi, d);
+        }
+    }
+    bounds.write(float4(lo, hi, 0.0, 0.0), gid);
+}
+
+kernel void shadow_bounds_downsample(texture2d<float, access::read> src [[texture(0)]],
+                                     texture2d<float, access::write> dst [[texture(1)]],
+                                     uint2 gid [[thread_position_in_grid]]) {
+    uint2 size = uint2(dst.get_width(), dst.get_height());
+    if (gid.x >= size.x || gid.y >= size.y) {
+        return;
+    }
+    uint2 srcSize = uint2(src.get_width(), src.get_height());
+    uint2 begin = gid * 2u;
+    uint2 end = select(min(begin + 2u, srcSize), srcSize, gid == size - 1u);
+    float2 range = float2(1.0, 0.0);
+    for (uint y = begin.y; y < end.y; ++y) {
+        for (uint x = begin.x; x < end.x; ++x) {
+            float2 texel = src.read(uint2(x, y)).xy;
+            range = float2(min(range.x, texel.x), max(range.y, texel.y));
+        }
+    }
+    dst.write(float4(range, 0.0, 0.0), gid);
+}
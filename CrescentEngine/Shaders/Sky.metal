@@ -0,0 +1,387 @@
+#include "Common.metal.h"
+using namespace metal;
+
+// Precomputed atmosphere of the procedural sky (SkyAtmosphere), after Hillaire's LUT model:
+// transmittance to the top of the atmosphere, an isotropic estimate of multiple scattering, and a
+// low-resolution sky-view LUT of the radiance seen from the ground. The skybox samples the sky-view
+// LUT instead of evaluating the sky per pixel, and the procedural sky's lighting cubemaps are
+// prefiltered from it a face at a time. Distances are in kilometres; the constants match
+// SkyAtmosphere.cpp, which evaluates the sun's transmittance on the CPU.
+
+constant float kSkyBottomRadius = 6360.0;
+constant float kSkyTopRadius = 6460.0;
+constant float kSkyViewRadius = 6360.2; // the viewer stands 200 m above the ground
+constant float3 kSkyRayleighScattering = float3(5.802e-3, 13.558e-3, 33.1e-3);
+constant float kSkyRayleighScaleHeight = 8.0;
+constant float kSkyMieScattering = 3.996e-3;
+constant float kSkyMieExtinction = 4.440e-3;
+constant float kSkyMieScaleHeight = 1.2;
+constant float kSkyMieG = 0.8;
+constant float3 kSkyOzoneAbsorption = float3(0.650e-3, 1.881e-3, 0.085e-3);
+constant float3 kSkyGroundAlbedo = float3(0.3);
+
+// Matches SkyAtmosphere::ParamsGPU.
+struct SkyAtmosphereParams {
+    float4 sunDirection;   // xyz towards the sun
+    float4 sunIlluminance; // rgb the sky-view LUT is scaled by
+    float4 rot0;           // environment rotation, as in EnvironmentUniforms
+    float4 rot1;
+    float4 rot2;
+    uint face;
+    uint resolution;
+    float roughness;
+    uint sampleCount;
+};
+
+struct SkyMedium {
+    float3 rayleigh;
+    float mie;
+    float3 scattering;
+    float3 extinction;
+};
+
+static SkyMedium sampleSkyMedium(float height) {
+    height = max(height, 0.0);
+    float rayleighDensity = exp(-height / kSkyRayleighScaleHeight);
+    float mieDensity = exp(-height / kSkyMieScaleHeight);
+    float ozoneDensity = max(0.0, 1.0 - abs(height - 25.0) / 15.0);
+    SkyMedium medium;
+    medium.rayleigh = kSkyRayleighScattering * rayleighDensity;
+    medium.mie = kSkyMieScattering * mieDensity;
+    medium.scattering = medium.rayleigh + medium.mie;
+    medium.extinction = medium.rayleigh + kSkyMieExtinction * mieDensity + kSkyOzoneAbsorption * ozoneDensity;
+    return medium;
+}
+
+// Distance along the ray to the nearest intersection with the sphere in front of the origin, or -1.
+static float skyRaySphere(float3 origin, float3 dir, float radius) {
+    float b = dot(origin, dir);
+    float c = dot(origin, origin) - radius * radius;
+    float disc = b * b - c;
+    if (disc < 0.0) {
+        return -1.0;
+    }
+    float s = sqrt(disc);
+    float nearT = -b - s;
+    if (nearT > 0.0) {
+        return nearT;
+    }
+    float farT = -b + s;
+    return farT > 0.0 ? farT : -1.0;
+}
+
+static float skyRayleighPhase(float cosTheta) {
+    return 3.0 / (16.0 * PI) * (1.0 + cosTheta * cosTheta);
+}
+
+static float skyMiePhase(float cosTheta) {
+    float g2 = kSkyMieG * kSkyMieG;
+    float denom = max(1.0 + g2 - 2.0 * kSkyMieG * cosTheta, 1e-4);
+    return (1.0 - g2) / (4.0 * PI * denom * sqrt(denom));
+}
+
+// Transmittance LUT: distance to the top of the atmosphere across, height down (Bruneton), so the
+// rays grazing the horizon get most of the columns.
+static float2 transmittanceLutUV(float r, float mu) {
+    float H = sqrt(kSkyTopRadius * kSkyTopRadius - kSkyBottomRadius * kSkyBottomRadius);
+    float rho = sqrt(max(r * r - kSkyBottomRadius * kSkyBottomRadius, 0.0));
+    float disc = r * r * (mu * mu - 1.0) + kSkyTopRadius * kSkyTopRadius;
+    float d = max(-r * mu + sqrt(max(disc, 0.0)), 0.0);
+    float dMin = kSkyTopRadius - r;
+    float dMax = rho + H;
+    return float2((d - dMin) / max(dMax - dMin, 1e-4), rho / H);
+}
+
+static void transmittanceLutRMu(float2 uv, thread float& r, thread float& mu) {
+    float H = sqrt(kSkyTopRadius * kSkyTopRadius - kSkyBottomRadius * kSkyBottomRadius);
+    float rho = H * uv.y;
+    r = sqrt(rho * rho + kSkyBottomRadius * kSkyBottomRadius);
+    float dMin = kSkyTopRadius - r;
+    float dMax = rho + H;
+    float d = dMin + uv.x * (dMax - dMin);
+    mu = (d <= 0.0) ? 1.0 : (H * H - rho * rho - d * d) / (2.0 * r * d);
+    mu = clamp(mu, -1.0, 1.0);
+}
+
+static float3 sampleSkyTransmittance(texture2d<float> lut, float3 position, float3 toSun) {
+    constexpr sampler lutSampler(filter::linear, address::clamp_to_edge);
+    float r = length(position);
+    float mu = dot(position / r, toSun);
+    return lut.sample(lutSampler, transmittanceLutUV(r, mu), level(0.0)).rgb;
+}
+
+// Sun light reaching a point of the atmosphere, zero inside the planet's shadow.
+static float3 skySunTransmittance(texture2d<float> lut, float3 position, float3 toSun) {
+    if (skyRaySphere(position, toSun, kSkyBottomRadius) > 0.0) {
+        return float3(0.0);
+    }
+    return sampleSkyTransmittance(lut, position, toSun);
+}
+
+static float3 sampleSkyMultiScattering(texture2d<float> lut, float r, float cosSun) {
+    constexpr sampler lutSampler(filter::linear, address::clamp_to_edge);
+    float2 uv = float2(cosSun * 0.5 + 0.5,
+                       saturate((r - kSkyBottomRadius) / (kSkyTopRadius - kSkyBottomRadius)));
+    return lut.sample(lutSampler, uv, level(0.0)).rgb;
+}
+
+// Inverse of skyViewLutUV (Common.metal.h).
+static float3 skyViewLutDirection(float2 uv) {
+    float azimuth = (uv.x - 0.5) * TWO_PI;
+    float centered = 1.0 - 2.0 * uv.y;
+    float latitude = sign(centered) * centered * centered * HALF_PI;
+    float cosLatitude = cos(latitude);
+    return float3(cosLatitude * cos(azimuth), sin(latitude), cosLatitude * sin(azimuth));
+}
+
+static float3 sampleSkyView(texture2d<float> skyView, float3 worldDir) {
+    constexpr sampler lutSampler(filter::linear, s_address::repeat, t_address::clamp_to_edge);
+    return skyView.sample(lutSampler, skyViewLutUV(worldDir), level(0.0)).rgb;
+}
+
+// Same face layout as getCubeDirection in IBL.metal, so the cubemaps read like the baked ones.
+static float3 skyCubeDirection(uint face, float2 uv) {
+    float2 st = uv * 2.0 - 1.0;
+    float3 dir;
+    switch (face) {
+        case 0: dir = float3( 1.0, -st.y, -st.x); break;
+        case 1: dir = float3(-1.0, -st.y,  st.x); break;
+        case 2: dir = float3( st.x,  1.0,  st.y); break;
+        case 3: dir = float3( st.x, -1.0, -st.y); break;
+        case 4: dir = float3( st.x, -st.y,  1.0); break;
+        default: dir = float3(-st.x, -st.y, -1.0); break;
+    }
+    return normalize(dir);
+}
+
+static float2 skyHammersley(uint i, uint count) {
+    return float2(float(i) / float(count), float(reverse_bits(i)) * 2.3283064365386963e-10);
+}
+
+static float3x3 skyTangentFrame(float3 N) {
+    float3 up = abs(N.z) < 0.999 ? float3(0.0, 0.0, 1.0) : float3(1.0, 0.0, 0.0);
+    float3 tangent = normalize(cross(up, N));
+    float3 bitangent = cross(N, tangent);
+    return float3x3(tangent, bitangent, N);
+}
+
+// Cubemap texels hold environment-space directions, which the lit shaders reach by rotating world
+// directions with the environment rotation; the sky-view LUT is in world space.
+static float3x3 skyEnvironmentToWorld(constant SkyAtmosphereParams& params) {
+    return transpose(float3x3(params.rot0.xyz, params.rot1.xyz, params.rot2.xyz));
+}
+
+// ============================================================================
+// LUTS
+// ============================================================================
+
+kernel void sky_transmittance_lut(
+    texture2d<float, access::write> lut [[texture(0)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    uint width = lut.get_width();
+    uint height = lut.get_height();
+    if (gid.x >= width || gid.y >= height) {
+        return;
+    }
+    float2 uv = (float2(gid) + 0.5) / float2(width, height);
+    float r;
+    float mu;
+    transmittanceLutRMu(uv, r, mu);
+    float3 origin = float3(0.0, r, 0.0);
+    float3 dir = float3(sqrt(max(1.0 - mu * mu, 0.0)), mu, 0.0);
+    float rayLength = max(skyRaySphere(origin, dir, kSkyTopRadius), 0.0);
+
+    const uint kSteps = 40;
+    float dt = rayLength / float(kSteps);
+    float3 opticalDepth = float3(0.0);
+    for (uint i = 0; i < kSteps; ++i) {
+        float3 p = origin + dir * ((float(i) + 0.5) * dt);
+        opticalDepth += sampleSkyMedium(length(p) - kSkyBottomRadius).extinction * dt;
+    }
+    lut.write(float4(exp(-opticalDepth), 1.0), gid);
+}
+
+// Light scattered once more towards a point, from the sun lighting every direction around it, and
+// the fraction of it that keeps scattering; their geometric series stands in for every order above
+// the second. Indexed by the sun's zenith cosine across and the height down.
+kernel void sky_multiscattering_lut(
+    texture2d<float> transmittanceLut [[texture(0)]],
+    texture2d<float, access::write> lut [[texture(1)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    uint width = lut.get_width();
+    uint height = lut.get_height();
+    if (gid.x >= width || gid.y >= height) {
+        return;
+    }
+    float2 uv = (float2(gid) + 0.5) / float2(width, height);
+    float cosSun = uv.x * 2.0 - 1.0;
+    float r = clamp(kSkyBottomRadius + uv.y * (kSkyTopRadius - kSkyBottomRadius),
+                    kSkyBottomRadius + 0.01, kSkyTopRadius - 0.01);
+    float3 origin = float3(0.0, r, 0.0);
+    float3 toSun = float3(sqrt(max(1.0 - cosSun * cosSun, 0.0)), cosSun, 0.0);
+
+    const uint kSqrtDirections = 8;
+    const uint kSteps = 20;
+    const float isotropicPhase = 1.0 / (4.0 * PI);
+    float3 secondOrder = float3(0.0);
+    float3 transfer = float3(0.0);
+    for (uint i = 0; i < kSqrtDirections; ++i) {
+        for (uint j = 0; j < kSqrtDirections; ++j) {
+            float cosTheta = 1.0 - 2.0 * (float(i) + 0.5) / float(kSqrtDirections);
+            float sinTheta = sqrt(max(1.0 - cosTheta * cosTheta, 0.0));
+            float phi = TWO_PI * (float(j) + 0.5) / float(kSqrtDirections);
+            float3 dir = float3(sinTheta * cos(phi), cosTheta, sinTheta * sin(phi));
+
+            float groundT = skyRaySphere(origin, dir, kSkyBottomRadius);
+            float rayLength = groundT > 0.0 ? groundT : max(skyRaySphere(origin, dir, kSkyTopRadius), 0.0);
+            float dt = rayLength / float(kSteps);
+            float3 throughput = float3(1.0);
+            for (uint s = 0; s < kSteps; ++s) {
+                float3 p = origin + dir * ((float(s) + 0.5) * dt);
+                SkyMedium medium = sampleSkyMedium(length(p) - kSkyBottomRadius);
+                float3 extinction = max(medium.extinction, float3(1e-6));
+                float3 stepTransmittance = exp(-medium.extinction * dt);
+                float3 scattered = medium.scattering * skySunTransmittance(transmittanceLut, p, toSun) * isotropicPhase;
+                secondOrder += throughput * (scattered - scattered * stepTransmittance) / extinction;
+                transfer += throughput * (medium.scattering - medium.scattering * stepTransmittance) / extinction;
+                throughput *= stepTransmittance;
+            }
+            if (groundT > 0.0) {
+                float3 p = origin + dir * groundT;
+                float3 normal = normalize(p);
+                secondOrder += throughput * sampleSkyTransmittance(transmittanceLut, p, toSun)
+                    * saturate(dot(normal, toSun)) * kSkyGroundAlbedo / PI;
+            }
+        }
+    }
+    // Uniform directions with an isotropic phase: both integrals are plain averages.
+    float invCount = 1.0 / float(kSqrtDirections * kSqrtDirections);
+    secondOrder *= invCount;
+    transfer *= invCount;
+    float3 multiScattering = secondOrder / max(float3(1.0) - transfer, float3(1e-3));
+    lut.write(float4(multiScattering, 1.0), gid);
+}
+
+// Radiance towards a viewer on the ground, for the sun in params, around the whole sphere.
+kernel void sky_view_lut(
+    texture2d<float> transmittanceLut [[texture(0)]],
+    texture2d<float> multiScatteringLut [[texture(1)]],
+    texture2d<float, access::write> lut [[texture(2)]],
+    constant SkyAtmosphereParams& params [[buffer(0)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    uint width = lut.get_width();
+    uint height = lut.get_height();
+    if (gid.x >= width || gid.y >= height) {
+        return;
+    }
+    float2 uv = (float2(gid) + 0.5) / float2(width, height);
+    float3 dir = skyViewLutDirection(uv);
+    float3 origin = float3(0.0, kSkyViewRadius, 0.0);
+    float3 toSun = normalize(params.sunDirection.xyz);
+    float cosTheta = dot(dir, toSun);
+    float rayleighPhase = skyRayleighPhase(cosTheta);
+    float miePhase = skyMiePhase(cosTheta);
+
+    float groundT = skyRaySphere(origin, dir, kSkyBottomRadius);
+    float rayLength = groundT > 0.0 ? groundT : max(skyRaySphere(origin, dir, kSkyTopRadius), 0.0);
+    const uint kSteps = 32;
+    float dt = rayLength / float(kSteps);
+    float3 radiance = float3(0.0);
+    float3 throughput = float3(1.0);
+    for (uint s = 0; s < kSteps; ++s) {
+        float3 p = origin + dir * ((float(s) + 0.5) * dt);
+        float r = length(p);
+        SkyMedium medium = sampleSkyMedium(r - kSkyBottomRadius);
+        float3 extinction = max(medium.extinction, float3(1e-6));
+        float3 stepTransmittance = exp(-medium.extinction * dt);
+        float3 sunTransmittance = skySunTransmittance(transmittanceLut, p, toSun);
+        float3 multiScattering = sampleSkyMultiScattering(multiScatteringLut, r, dot(p / r, toSun));
+        float3 scattered = (medium.rayleigh * rayleighPhase + medium.mie * miePhase) * sunTransmittance
+            + medium.scattering * multiScattering;
+        radiance += throughput * (scattered - scattered * stepTransmittance) / extinction;
+        throughput *= stepTransmittance;
+    }
+    if (groundT > 0.0) {
+        float3 p = origin + dir * groundT;
+        radiance += throughput * sampleSkyTransmittance(transmittanceLut, p, toSun)
+            * saturate(dot(normalize(p), toSun)) * kSkyGroundAlbedo / PI;
+    }
+    lut.write(float4(radiance * params.sunIlluminance.rgb, 1.0), gid);
+}
+
+// ============================================================================
+// LIGHTING CUBEMAPS
+// ============================================================================
+
+// One face of one mip of the specular cubemap, GGX-filtered from the sky-view LUT. The sun disc is
+// left out; the directional light covers it.
+kernel void sky_prefilter_face(
+    texture2d<float> skyView [[texture(0)]],
+    texturecube<float, access::write> prefiltered [[texture(1)]],
+    constant SkyAtmosphereParams& params [[buffer(0)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    uint size = params.resolution;
+    if (gid.x >= size || gid.y >= size) {
+        return;
+    }
+    float2 uv = (float2(gid) + 0.5) / float(size);
+    float3 N = skyCubeDirection(params.face, uv);
+    float3x3 toWorld = skyEnvironmentToWorld(params);
+
+    float3 color = float3(0.0);
+    if (params.roughness <= 0.0) {
+        color = sampleSkyView(skyView, toWorld * N);
+    } else {
+        float a = params.roughness * params.roughness;
+        float3x3 frame = skyTangentFrame(N);
+        float totalWeight = 0.0;
+        for (uint i = 0; i < params.sampleCount; ++i) {
+            float2 xi = skyHammersley(i, params.sampleCount);
+            float phi = TWO_PI * xi.x;
+            float cosTheta = sqrt((1.0 - xi.y) / (1.0 + (a * a - 1.0) * xi.y));
+            float sinTheta = sqrt(max(1.0 - cosTheta * cosTheta, 0.0));
+            float3 H = normalize(frame * float3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta));
+            float3 L = normalize(2.0 * dot(N, H) * H - N);
+            float NdotL = dot(N, L);
+            if (NdotL > 0.0) {
+                color += sampleSkyView(skyView, toWorld * L) * NdotL;
+                totalWeight += NdotL;
+            }
+        }
+        color /= max(totalWeight, 1e-3);
+    }
+    prefiltered.write(float4(color, 1.0), gid, params.face);
+}
+
+// One face of the diffuse cubemap, cosine-weighted from the sky-view LUT. Holds irradiance over pi,
+// like irradianceKernel in IBL.metal.
+kernel void sky_irradiance_face(
+    texture2d<float> skyView [[texture(0)]],
+    texturecube<float, access::write> irradiance [[texture(1)]],
+    constant SkyAtmosphereParams& params [[buffer(0)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    uint size = params.resolution;
+    if (gid.x >= size || gid.y >= size) {
+        return;
+    }
+    float2 uv = (float2(gid) + 0.5) / float(size);
+    float3 N = skyCubeDirection(params.face, uv);
+    float3x3 toWorld = skyEnvironmentToWorld(params);
+    float3x3 frame = skyTangentFrame(N);
+
+    float3 color = float3(0.0);
+    for (uint i = 0; i < params.sampleCount; ++i) {
+        float2 xi = skyHammersley(i, params.sampleCount);
+        float phi = TWO_PI * xi.x;
+        float sinTheta = sqrt(xi.y);
+        float cosTheta = sqrt(1.0 - xi.y);
+        float3 L = frame * float3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta);
+        color += sampleSkyView(skyView, toWorld * L);
+    }
+    irradiance.write(float4(color / float(max(params.sampleCount, 1u)), 1.0), gid, params.face);
+}
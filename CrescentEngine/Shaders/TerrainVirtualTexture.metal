@@ -0,0 +1,71 @@
+#include "Common.metal.h"
+
+// Page compositing for the terrain runtime virtual texture (Renderer/TerrainVirtualTexture.hpp).
+// One thread per texel of a page, border included, blends the terrain's three layers by its
+// control map once, the way fragment_main would, and writes the result to both atlases:
+//   albedo atlas:  rgb sqrt of the blended albedo, a blended occlusion
+//   surface atlas: rg blended tangent normal xy, b blended roughness, a blended metallic
+// Material scalars (tint, metallic, roughness, normal strength) stay out of the pages, so
+// fragment_main applies them as it does to directly sampled layers.
+struct TerrainVTCompositeParams {
+    float4 pageRect;       // xy virtual UV of the page's corner, border included; zw virtual UV per texel
+    float4 uvTilingOffset; // the material's UV tiling and offset
+    float4 layerTiling[3]; // xy layer tiling
+    float4 blend;          // x blend sharpness
+    uint2 atlasOrigin;     // the page's corner in the atlases
+    uint2 pad;
+};
+
+// A box footprint of one page texel, so each page mip filters the layers like the sampler would.
+static inline float4 terrainVTSample(texture2d<float> map, sampler s, float2 uv, float2 texelUV) {
+    return map.sample(s, uv, gradient2d(float2(texelUV.x, 0.0), float2(0.0, texelUV.y)));
+}
+
+kernel void terrain_vt_composite(
+    constant TerrainVTCompositeParams& params [[buffer(0)]],
+    texture2d<float> controlMap [[texture(0)]],
+    texture2d<float> layer0Map [[texture(1)]],
+    texture2d<float> layer1Map [[texture(2)]],
+    texture2d<float> layer2Map [[texture(3)]],
+    texture2d<float> layer0NormalMap [[texture(4)]],
+    texture2d<float> layer1NormalMap [[texture(5)]],
+    texture2d<float> layer2NormalMap [[texture(6)]],
+    texture2d<float> layer0OrmMap [[texture(7)]],
+    texture2d<float> layer1OrmMap [[texture(8)]],
+    texture2d<float> layer2OrmMap [[texture(9)]],
+    texture2d<float, access::write> albedoAtlas [[texture(10)]],
+    texture2d<float, access::write> surfaceAtlas [[texture(11)]],
+    sampler textureSampler [[sampler(0)]],
+    uint2 tid [[thread_position_in_grid]]
+) {
+    const uint stride = kTerrainVTPageSize + 2 * kTerrainVTPageBorder;
+    if (tid.x >= stride || tid.y >= stride) {
+        return;
+    }
+    float2 virtualUV = params.pageRect.xy + (float2(tid) + 0.5) * params.pageRect.zw;
+    float2 controlUV = clamp(virtualUV, float2(0.0), float2(1.0));
+    float2 uv = virtualUV * params.uvTilingOffset.xy + params.uvTilingOffset.zw;
+    float2 texelUV = params.pageRect.zw * abs(params.uvTilingOffset.xy);
+
+    float3 weights = normalizedTerrainWeights(
+        terrainVTSample(controlMap, textureSampler, controlUV, params.pageRect.zw).rgb, params.blend.x);
+    float2 st0 = max(params.layerTiling[0].xy, float2(0.001));
+    float2 st1 = max(params.layerTiling[1].xy, float2(0.001));
+    float2 st2 = max(params.layerTiling[2].xy, float2(0.001));
+
+    float3 albedo = terrainVTSample(layer0Map, textureSampler, uv * st0, texelUV * st0).rgb * weights.x
+                  + terrainVTSample(layer1Map, textureSampler, uv * st1, texelUV * st1).rgb * weights.y
+                  + terrainVTSample(layer2Map, textureSampler, uv * st2, texelUV * st2).rgb * weights.z;
+    float3 orm = terrainVTSample(layer0OrmMap, textureSampler, uv * st0, texelUV * st0).rgb * weights.x
+               + terrainVTSample(layer1OrmMap, textureSampler, uv * st1, texelUV * st1).rgb * weights.y
+               + terrainVTSample(layer2OrmMap, textureSampler, uv * st2, texelUV * st2).rgb * weights.z;
+    float3 tn0 = terrainVTSample(layer0NormalMap, textureSampler, uv * st0, texelUV * st0).xyz * 2.0 - 1.0;
+    float3 tn1 = terrainVTSample(layer1NormalMap, textureSampler, uv * st1, texelUV * st1).xyz * 2.0 - 1.0;
+    float3 tn2 = terrainVTSample(layer2NormalMap, textureSampler, uv * st2, texelUV * st2).xyz * 2.0 - 1.0;
+    float3 normal = normalize(tn0 * weights.x + tn1 * weights.y + tn2 * weights.z);
+
+    // sqrt keeps 8 bits enough for dark albedo without needing sRGB writes.
+    uint2 texel = params.atlasOrigin + tid;
+    albedoAtlas.write(float4(sqrt(saturate(albedo)), saturate(orm.r)), texel);
+    surfaceAtlas.write(float4(normal.xy * 0.5 + 0.5, saturate(orm.g), saturate(orm.b)), texel);
+}
@@ -0,0 +1,93 @@
+#include "Common.metal.h"
+using namespace metal;
+
+// Passes of weighted blended transparency (WeightedTransparency). The blended draws themselves go
+// through fragment_main with kPbrWeightedBlended set; these prepare their low-resolution depth and
+// composite the accumulated layers over the scene colour.
+
+struct TransparencyVertexOut {
+    float4 position [[position]];
+};
+
+vertex TransparencyVertexOut transparency_vertex(uint vertexId [[vertex_id]]) {
+    TransparencyVertexOut out;
+    float2 pos = float2((vertexId << 1) & 2, vertexId & 2) * 2.0 - 1.0;
+    out.position = float4(pos, 0.0, 1.0);
+    return out;
+}
+
+struct TransparencyDepthOut {
+    float depth [[depth(any)]];
+};
+
+// Farthest scene depth of the 2x2 block under a half-resolution pixel, so a layer in front of any
+// of the four opaque samples survives the low-resolution depth test; the upsample sorts out which
+// full-resolution pixels it belongs to.
+fragment TransparencyDepthOut transparency_depth_downsample_fragment(
+    TransparencyVertexOut in [[stage_in]],
+    depth2d<float> sceneDepth [[texture(0)]]
+) {
+    constexpr sampler pointSampler(coord::normalized, filter::nearest, address::clamp_to_edge);
+    float2 sceneSize = float2(sceneDepth.get_width(), sceneDepth.get_height());
+    float4 depths = sceneDepth.gather(pointSampler, (in.position.xy * 2.0) / sceneSize);
+    TransparencyDepthOut out;
+    out.depth = max(max(depths.x, depths.y), max(depths.z, depths.w));
+    return out;
+}
+
+// Average colour of the layers, blended over the scene by one minus their total transmittance.
+fragment float4 transparency_composite_fragment(
+    TransparencyVertexOut in [[stage_in]],
+    texture2d<float> accumulation [[texture(0)]],
+    texture2d<float> revealage [[texture(1)]]
+) {
+    uint2 pixel = uint2(in.position.xy);
+    float reveal = revealage.read(pixel).r;
+    if (reveal >= 0.9999) {
+        discard_fragment();
+    }
+    float4 accum = accumulation.read(pixel);
+    return float4(accum.rgb / max(accum.a, 1e-5), 1.0 - reveal);
+}
+
+static inline float transparencyLinearDepth(float depth, float2 nearFar) {
+    return nearFar.x * nearFar.y / max(nearFar.y - depth * (nearFar.y - nearFar.x), 1e-6);
+}
+
+// Bilateral upsample of the half-resolution layers: the four surrounding low-resolution samples are
+// weighted bilinearly and by how closely their depth matches this pixel's, so layers do not bleed
+// across silhouettes of the opaque scene.
+fragment float4 transparency_upsample_fragment(
+    TransparencyVertexOut in [[stage_in]],
+    constant float4& params [[buffer(0)]], // xy near and far plane
+    texture2d<float> accumulation [[texture(0)]],
+    texture2d<float> revealage [[texture(1)]],
+    depth2d<float> lowDepth [[texture(2)]],
+    depth2d<float> sceneDepth [[texture(3)]]
+) {
+    int2 lowSize = int2(accumulation.get_width(), accumulation.get_height());
+    float depth = transparencyLinearDepth(sceneDepth.read(uint2(in.position.xy)), params.xy);
+    float2 lowPos = in.position.xy * 0.5 - 0.5;
+    int2 base = int2(floor(lowPos));
+    float2 f = lowPos - float2(base);
+
+    float4 accum = float4(0.0);
+    float reveal = 0.0;
+    float total = 0.0;
+    for (int y = 0; y < 2; ++y) {
+        for (int x = 0; x < 2; ++x) {
+            uint2 texel = uint2(clamp(base + int2(x, y), int2(0), lowSize - 1));
+            float bilinear = (x == 0 ? 1.0 - f.x : f.x) * (y == 0 ? 1.0 - f.y : f.y);
+            float sampleDepth = transparencyLinearDepth(lowDepth.read(texel), params.xy);
+            float weight = bilinear / (1e-3 + abs(sampleDepth - depth) / depth);
+            accum += accumulation.read(texel) * weight;
+            reveal += revealage.read(texel).r * weight;
+            total += weight;
+        }
+    }
+    reveal /= max(total, 1e-6);
+    if (reveal >= 0.9999) {
+        discard_fragment();
+    }
+    return float4(accum.rgb / max(accum.a, 1e-5), 1.0 - reveal);
+}
@@ -10,10 +10,10 @@ enum RenderViewKind {
 
 // Protocol for input
 protocol InputDelegate: AnyObject {
-    func handleKeyDown(_ keyCode: UInt16)
-    func handleKeyUp(_ keyCode: UInt16)
-    func handleMouseMove(deltaX: Float, deltaY: Float)
-    func handleMouseButton(_ button: Int, pressed: Bool)
+    func handleKeyDown(_ keyCode: UInt16, timestamp: TimeInterval)
+    func handleKeyUp(_ keyCode: UInt16, timestamp: TimeInterval)
+    func handleMouseMove(deltaX: Float, deltaY: Float, timestamp: TimeInterval)
+    func handleMouseButton(_ button: Int, pressed: Bool, timestamp: TimeInterval)
 }
 
 struct MetalView: NSViewRepresentable {
@@ -22,6 +22,9 @@ struct MetalView: NSViewRepresentable {
     let viewKind: RenderViewKind
     let isActive: Bool
     let drivesLoop: Bool
+    // Frames per second the driving display link is limited to; 0 follows the display (up to 120 Hz
+    // on ProMotion panels).
+    let frameRateCap: Int
     let terrainPaintConfig: TerrainPaintConfig
     let onKeyDownIntercept: ((UInt16) -> Bool)?
     let onEngineReady: (() -> Void)?
@@ -29,12 +32,14 @@ struct MetalView: NSViewRepresentable {
     init(viewKind: RenderViewKind,
          isActive: Bool,
          drivesLoop: Bool = false,
+         frameRateCap: Int = 0,
          terrainPaintConfig: TerrainPaintConfig = TerrainPaintConfig(),
          onKeyDownIntercept: ((UInt16) -> Bool)? = nil,
          onEngineReady: (() -> Void)? = nil) {
         self.viewKind = viewKind
         self.isActive = isActive
         self.drivesLoop = drivesLoop
+        self.frameRateCap = frameRateCap
         self.terrainPaintConfig = terrainPaintConfig
         self.onKeyDownIntercept = onKeyDownIntercept
         self.onEngineReady = onEngineReady
@@ -80,6 +85,7 @@ struct MetalView: NSViewRepresentable {
     
     func updateNSView(_ nsView: MetalDisplayView, context: Context) {
         context.coordinator.applyMetalLayerIfNeeded()
+        context.coordinator.setFrameRateCap(frameRateCap)
         nsView.allowsPicking = (viewKind == .scene) && isActive
         nsView.allowsCameraControl = (viewKind != .preview) && isActive
         nsView.inputDelegate = isActive ? context.coordinator : nil
@@ -110,6 +116,8 @@ struct MetalView: NSViewRepresentable {
         private var lastDrawableHeight: Float = 0
         private var pendingResizeWorkItem: DispatchWorkItem?
         private var lastTime: CFTimeInterval = 0
+        private var lastTargetTimestamp: CFTimeInterval = 0
+        private var frameRateCap: Int = 0
         private var isEngineInitialized = false
         private let viewKind: RenderViewKind
         private let drivesLoop: Bool
@@ -234,6 +242,7 @@ struct MetalView: NSViewRepresentable {
             if #available(macOS 15.0, *) {
                 guard let metalView = metalView else { return }
                 let link = metalView.displayLink(target: self, selector: #selector(renderFrameFromDisplayLink(_:)))
+                link.preferredFrameRateRange = frameRateRange()
                 link.add(to: .main, forMode: .common)
                 self.displayLink = link
             } else {
@@ -245,7 +254,10 @@ struct MetalView: NSViewRepresentable {
                 
                 CVDisplayLinkSetOutputCallback(link, { (displayLink, inNow, inOutputTime, flagsIn, flagsOut, displayLinkContext) -> CVReturn in
                     let coordinator = Unmanaged<Coordinator>.fromOpaque(displayLinkContext!).takeUnretainedValue()
-                    coordinator.renderFrame()
+                    // Output time is when this frame reaches the display, in the host clock
+                    // CACurrentMediaTime reads.
+                    let targetTimestamp = CFTimeInterval(inOutputTime.pointee.hostTime) / CVGetHostClockFrequency()
+                    coordinator.renderFrame(targetTimestamp: targetTimestamp)
                     return kCVReturnSuccess
                 }, Unmanaged.passUnretained(self).toOpaque())
                 
@@ -255,18 +267,47 @@ struct MetalView: NSViewRepresentable {
         }
         
         @objc func renderFrameFromDisplayLink(_ displayLink: CADisplayLink) {
-            renderFrame()
+            renderFrame(targetTimestamp: displayLink.targetTimestamp)
         }
-        
-        func renderFrame() {
+
+        func setFrameRateCap(_ cap: Int) {
+            guard cap != frameRateCap else { return }
+            frameRateCap = cap
+            if #available(macOS 15.0, *), let link = displayLink as? CADisplayLink {
+                link.preferredFrameRateRange = frameRateRange()
+            }
+        }
+
+        // The display link itself skips the callbacks a capped rate does not need, so the main
+        // thread sleeps in its run loop between frames instead of polling.
+        private func frameRateRange() -> CAFrameRateRange {
+            if frameRateCap > 0 {
+                let rate = Float(frameRateCap)
+                return CAFrameRateRange(minimum: rate, maximum: rate, preferred: rate)
+            }
+            return CAFrameRateRange(minimum: 60, maximum: 120, preferred: 120)
+        }
+
+        // targetTimestamp is when the frame will be presented; the engine steps the simulation by
+        // the interval between those rather than by when the callbacks happened to run.
+        func renderFrame(targetTimestamp: CFTimeInterval = 0) {
             guard drivesLoop, let bridge = bridge, isEngineInitialized else { return }
-            
+
+            // CVDisplayLink has no frame rate range; drop the vsyncs that come early for the cap.
+            if frameRateCap > 0, targetTimestamp > 0, lastTargetTimestamp > 0 {
+                let minimumInterval = 1.0 / Double(frameRateCap)
+                if targetTimestamp - lastTargetTimestamp < minimumInterval * 0.9 {
+                    return
+                }
+            }
+
             let currentTime = CACurrentMediaTime()
             let deltaTime = lastTime == 0 ? 0.016 : Float(currentTime - lastTime)
-            
+
             // Update and render
-            if bridge.tick(deltaTime: deltaTime) {
+            if bridge.tick(deltaTime: deltaTime, targetTimestamp: targetTimestamp) {
                 lastTime = currentTime
+                lastTargetTimestamp = targetTimestamp
             }
         }
         
@@ -287,23 +328,25 @@ struct MetalView: NSViewRepresentable {
         
         // MARK: - InputDelegate
         
-        func handleKeyDown(_ keyCode: UInt16) {
+        // Timestamps are the NSEvents' own, so the engine sees when input happened rather than
+        // when it reached the bridge.
+        func handleKeyDown(_ keyCode: UInt16, timestamp: TimeInterval) {
             if onKeyDownIntercept?(keyCode) == true {
                 return
             }
-            bridge?.handleKeyDown(keyCode)
+            bridge?.handleKeyDown(keyCode, timestamp: timestamp)
         }
         
-        func handleKeyUp(_ keyCode: UInt16) {
-            bridge?.handleKeyUp(keyCode)
+        func handleKeyUp(_ keyCode: UInt16, timestamp: TimeInterval) {
+            bridge?.handleKeyUp(keyCode, timestamp: timestamp)
         }
         
-        func handleMouseMove(deltaX: Float, deltaY: Float) {
-            bridge?.handleMouseMove(withDeltaX: deltaX, deltaY: deltaY)
+        func handleMouseMove(deltaX: Float, deltaY: Float, timestamp: TimeInterval) {
+            bridge?.handleMouseMove(withDeltaX: deltaX, deltaY: deltaY, timestamp: timestamp)
         }
         
-        func handleMouseButton(_ button: Int, pressed: Bool) {
-            bridge?.handleMouseButton(Int32(button), pressed: pressed)
+        func handleMouseButton(_ button: Int, pressed: Bool, timestamp: TimeInterval) {
+            bridge?.handleMouseButton(Int32(button), pressed: pressed, timestamp: timestamp)
         }
         
         #if EDITOR_APP
@@ -333,6 +376,21 @@ struct MetalView: NSViewRepresentable {
             bridge?.handleMouseUpEvent()
         }
 
+        func isGizmoManipulating() -> Bool {
+            return bridge?.isGizmoManipulating() ?? false
+        }
+
+        func handleMarqueeSelect(from start: CGPoint, to end: CGPoint, viewSize: CGSize, additive: Bool) {
+            guard let metalView = metalView else { return }
+            let scale = metalView.layer?.contentsScale ?? 2.0
+            let width = Float(viewSize.width * scale)
+            let height = Float(viewSize.height * scale)
+
+            bridge?.handleMarqueeSelectFrom(x: Float(start.x * scale), y: Float(start.y * scale),
+                                            toX: Float(end.x * scale), y: Float(end.y * scale),
+                                            screenWidth: width, screenHeight: height, additive: additive)
+        }
+
         func beginTerrainPaint(at point: CGPoint,
                                viewSize: CGSize,
                                entityUUID: String,
@@ -471,7 +529,7 @@ struct MetalView: NSViewRepresentable {
                 keyDownMonitor = NSEvent.addLocalMonitorForEvents(matching: [.keyDown]) { [weak self] event in
                     guard let self = self else { return event }
                     guard self.shouldCaptureKeyboardEvent() else { return event }
-                    self.handleKeyDown(event.keyCode)
+                    self.handleKeyDown(event.keyCode, timestamp: event.timestamp)
                     return nil
                 }
             }
@@ -479,7 +537,7 @@ struct MetalView: NSViewRepresentable {
                 keyUpMonitor = NSEvent.addLocalMonitorForEvents(matching: [.keyUp]) { [weak self] event in
                     guard let self = self else { return event }
                     guard self.shouldCaptureKeyboardEvent() else { return event }
-                    self.handleKeyUp(event.keyCode)
+                    self.handleKeyUp(event.keyCode, timestamp: event.timestamp)
                     return nil
                 }
             }
@@ -526,27 +584,27 @@ struct MetalView: NSViewRepresentable {
             switch event.keyCode {
             case 56, 60:
                 if event.modifierFlags.contains(.shift) {
-                    handleKeyDown(event.keyCode)
+                    handleKeyDown(event.keyCode, timestamp: event.timestamp)
                 } else {
-                    handleKeyUp(event.keyCode)
+                    handleKeyUp(event.keyCode, timestamp: event.timestamp)
                 }
             case 59, 62:
                 if event.modifierFlags.contains(.control) {
-                    handleKeyDown(event.keyCode)
+                    handleKeyDown(event.keyCode, timestamp: event.timestamp)
                 } else {
-                    handleKeyUp(event.keyCode)
+                    handleKeyUp(event.keyCode, timestamp: event.timestamp)
                 }
             case 58, 61:
                 if event.modifierFlags.contains(.option) {
-                    handleKeyDown(event.keyCode)
+                    handleKeyDown(event.keyCode, timestamp: event.timestamp)
                 } else {
-                    handleKeyUp(event.keyCode)
+                    handleKeyUp(event.keyCode, timestamp: event.timestamp)
                 }
             case 55, 54:
                 if event.modifierFlags.contains(.command) {
-                    handleKeyDown(event.keyCode)
+                    handleKeyDown(event.keyCode, timestamp: event.timestamp)
                 } else {
-                    handleKeyUp(event.keyCode)
+                    handleKeyUp(event.keyCode, timestamp: event.timestamp)
                 }
             default:
                 break
@@ -596,6 +654,15 @@ class MetalDisplayView: NSView {
     private var trackingArea: NSTrackingArea?
     private var isRightMouseDown: Bool = false
     private var isLeftMouseDown: Bool = false
+    #if EDITOR_APP
+    // Left-drag marquee: where the press landed, and the rectangle drawn once the drag is
+    // long enough to not be a click. A drag that grabbed the gizmo never becomes one.
+    private var marqueeStart: CGPoint?
+    private var marqueeChecked: Bool = false
+    private var marqueeAdditive: Bool = false
+    private var marqueeLayer: CAShapeLayer?
+    private let marqueeThreshold: CGFloat = 4.0
+    #endif
     private var lastTerrainPreviewDispatchTime: CFTimeInterval = 0
     private var lastTerrainPaintDispatchTime: CFTimeInterval = 0
     private let terrainPreviewDispatchInterval: CFTimeInterval = 1.0 / 90.0
@@ -738,14 +805,47 @@ class MetalDisplayView: NSView {
         if coordinator?.onKeyDownIntercept?(event.keyCode) == true {
             return
         }
-        inputDelegate?.handleKeyDown(event.keyCode)
+        inputDelegate?.handleKeyDown(event.keyCode, timestamp: event.timestamp)
     }
     
     override func keyUp(with event: NSEvent) {
-        inputDelegate?.handleKeyUp(event.keyCode)
+        inputDelegate?.handleKeyUp(event.keyCode, timestamp: event.timestamp)
     }
 
     #if EDITOR_APP
+    private func marqueeRect(to point: CGPoint) -> CGRect? {
+        guard let start = marqueeStart else { return nil }
+        let rect = CGRect(x: min(start.x, point.x), y: min(start.y, point.y),
+                          width: abs(point.x - start.x), height: abs(point.y - start.y))
+        guard max(rect.width, rect.height) >= marqueeThreshold else { return nil }
+        if !marqueeChecked {
+            marqueeChecked = true
+            if coordinator?.isGizmoManipulating() == true {
+                marqueeStart = nil
+                return nil
+            }
+        }
+        return rect
+    }
+
+    private func showMarquee(_ rect: CGRect) {
+        if marqueeLayer == nil {
+            let shape = CAShapeLayer()
+            shape.fillColor = NSColor.controlAccentColor.withAlphaComponent(0.15).cgColor
+            shape.strokeColor = NSColor.controlAccentColor.cgColor
+            shape.lineWidth = 1.0
+            layer?.addSublayer(shape)
+            marqueeLayer = shape
+        }
+        marqueeLayer?.frame = bounds
+        marqueeLayer?.path = CGPath(rect: rect, transform: nil)
+    }
+
+    private func hideMarquee() {
+        marqueeLayer?.removeFromSuperlayer()
+        marqueeLayer = nil
+    }
+
     private func shouldDispatchTerrainPreview(now: CFTimeInterval, force: Bool = false) -> Bool {
         if force || (now - lastTerrainPreviewDispatchTime) >= terrainPreviewDispatchInterval {
             lastTerrainPreviewDispatchTime = now
@@ -768,7 +868,7 @@ class MetalDisplayView: NSView {
     override func rightMouseDragged(with event: NSEvent) {
         guard inputDelegate != nil else { return }
         // Send mouse movement to camera controller
-        inputDelegate?.handleMouseMove(deltaX: Float(event.deltaX), deltaY: Float(event.deltaY))
+        inputDelegate?.handleMouseMove(deltaX: Float(event.deltaX), deltaY: Float(event.deltaY), timestamp: event.timestamp)
     }
     
     override func mouseDown(with event: NSEvent) {
@@ -805,12 +905,15 @@ class MetalDisplayView: NSView {
         }
         #endif
 
-        inputDelegate?.handleMouseButton(0, pressed: true)
+        inputDelegate?.handleMouseButton(0, pressed: true, timestamp: event.timestamp)
         #if EDITOR_APP
         guard allowsPicking else { return }
         
         // Get click position
         let additive = event.modifierFlags.contains(.command)
+        marqueeStart = point
+        marqueeChecked = false
+        marqueeAdditive = additive
         coordinator?.handleMouseClick(at: point, viewSize: bounds.size, additive: additive)
         #endif
     }
@@ -861,6 +964,9 @@ class MetalDisplayView: NSView {
             // Get current position
             let point = convert(event.locationInWindow, from: nil)
             coordinator?.handleMouseDrag(at: point, viewSize: bounds.size)
+            if let rect = marqueeRect(to: point) {
+                showMarquee(rect)
+            }
         }
         #endif
     }
@@ -875,9 +981,16 @@ class MetalDisplayView: NSView {
             return
         }
         #endif
-        inputDelegate?.handleMouseButton(0, pressed: false)
+        inputDelegate?.handleMouseButton(0, pressed: false, timestamp: event.timestamp)
         #if EDITOR_APP
         guard allowsPicking else { return }
+        // Sent before the mouse-up so the engine still knows whether the drag moved the gizmo.
+        let point = convert(event.locationInWindow, from: nil)
+        if let start = marqueeStart, marqueeRect(to: point) != nil {
+            coordinator?.handleMarqueeSelect(from: start, to: point, viewSize: bounds.size, additive: marqueeAdditive)
+        }
+        marqueeStart = nil
+        hideMarquee()
         coordinator?.handleMouseUpEvent()
         #endif
     }
@@ -919,7 +1032,7 @@ class MetalDisplayView: NSView {
         if allowsCameraControl {
             NSCursor.hide()
         }
-        inputDelegate?.handleMouseButton(1, pressed: true)
+        inputDelegate?.handleMouseButton(1, pressed: true, timestamp: event.timestamp)
     }
     
     override func rightMouseUp(with event: NSEvent) {
@@ -930,6 +1043,6 @@ class MetalDisplayView: NSView {
         if allowsCameraControl {
             NSCursor.unhide()
         }
-        inputDelegate?.handleMouseButton(1, pressed: false)
+        inputDelegate?.handleMouseButton(1, pressed: false, timestamp: event.timestamp)
     }
 }
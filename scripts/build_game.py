@@ -2,14 +2,17 @@
 import argparse
 import hashlib
 import json
+import os
 import plistlib
 import shutil
 import subprocess
 import sys
 import tempfile
+import threading
+from concurrent.futures import ThreadPoolExecutor
 from datetime import datetime, timezone
 from pathlib import Path
-from typing import Optional
+from typing import Callable, NamedTuple, Optional
 
 LDR_EXTS = {".png", ".jpg", ".jpeg", ".tga", ".bmp", ".gif", ".tif", ".tiff"}
 MODEL_EXTS = {
@@ -18,9 +21,16 @@ MODEL_EXTS = {
 }
 RUNTIME_RAW_ASSET_EXTS = {".hdr", ".exr", ".wav", ".mp3", ".ogg", ".flac", ".ktx", ".ktx2", ".dds", ".cube", ".cmat"}
 KTX2_CACHE_VERSION = "v2a"
-ENV_CACHE_VERSION = "v1"
+ENV_CACHE_VERSION = "v3"
 STATIC_LIGHTMAP_COOK_VERSION = "v1"
 EMBEDDED_MARKER = "#embedded:"
+# Cooked outputs by content key (see encode_textures.py); never packaged.
+CONTENT_CACHE_DIR = "Content"
+COOK_GRAPH_FILE = "CookGraph.json"
+COOK_GRAPH_VERSION = 1
+# Project files whose own references count as dependencies of the scenes using them.
+NESTED_REF_EXTS = {".cmat"}
+DEFAULT_BAKED_LIGHTING_DIR = "Library/BakedLighting"
 FNV64_OFFSET = 14695981039346656037
 FNV64_PRIME = 1099511628211
 
@@ -154,10 +164,11 @@ def collect_environment_refs(scene_files: list[Path], project_root: Path, projec
     return sorted(refs)
 
 
-def bake_source_scenes(player_app: Path,
+def bake_source_scenes(graph: "CookGraph",
+                       player_app: Path,
                        project_file: Path,
-                       scene_files: list[Path],
-                       baked_root: Path) -> tuple[dict[Path, Path], dict[str, int]]:
+                       project_data: dict,
+                       scene_files: list[Path]) -> tuple[dict[Path, Path], dict[str, int]]:
     if not scene_files:
         return {}, {
             "bakedSceneCount": 0,
@@ -167,10 +178,7 @@ def bake_source_scenes(player_app: Path,
             "bakedLightCount": 0,
         }
 
-    executable = player_app / "Contents" / "MacOS" / "CrescentPlayer"
-    if not executable.exists():
-        raise FileNotFoundError(f"Cooker executable not found: {executable}")
-
+    executable = cooker_executable(player_app)
     project_root = project_file.parent
     baked_scene_map: dict[Path, Path] = {}
     stats = {
@@ -214,19 +222,45 @@ def bake_source_scenes(player_app: Path,
 
         return scene_baked_renderers, len(scene_atlas_paths), scene_baked_lights
 
+    def lightmaps_present(baked_scene: Path) -> bool:
+        # Bakes write their lightmaps into the project; a cached bake only holds if they are still there.
+        try:
+            scene_data = json.loads(baked_scene.read_text(encoding="utf-8"))
+        except (OSError, json.JSONDecodeError):
+            return False
+        for entity in scene_data.get("entities", []):
+            renderer = entity.get("components", {}).get("MeshRenderer")
+            static_lighting = renderer.get("staticLighting") if isinstance(renderer, dict) else None
+            if not isinstance(static_lighting, dict):
+                continue
+            for key in ("lightmap", "directionalLightmap", "shadowmask"):
+                artifact_ref = extract_asset_ref(static_lighting.get(key))
+                if artifact_ref and not (project_root / artifact_ref).exists():
+                    return False
+        return True
+
+    jobs: list[CookJob] = []
     for scene_path in scene_files:
-        baked_output = baked_root / scene_path.relative_to(project_root)
-        baked_output.parent.mkdir(parents=True, exist_ok=True)
-        run(
-            [
-                str(executable),
-                "--bake-scene-lighting",
-                str(project_file),
-                str(scene_path),
-                str(baked_output),
-            ],
-            cwd=project_root,
-        )
+        output_dir = baked_lighting_dir(project_root, scene_path)
+        dependencies = [
+            path for path in scene_dependencies(scene_path, project_root, project_data)
+            if not path.is_relative_to(output_dir)
+        ]
+        jobs.append(CookJob(
+            artifact=f"bake:{graph.label(scene_path)}",
+            dependencies=dependencies,
+            settings={**cook_settings(graph, project_data), "cook": "bake-scene-lighting", "scene": graph.label(scene_path)},
+            output_name=scene_path.name,
+            command=[str(executable), "--bake-scene-lighting", str(project_file), str(scene_path), "{output}"],
+            # Artifacts are named after the scene, so scenes sharing a name and output directory
+            # cannot bake side by side.
+            lane=f"bake:{output_dir / scene_path.stem}",
+            reusable=lightmaps_present,
+        ))
+    outputs = graph.cook_all(jobs)
+
+    for scene_path, job in zip(scene_files, jobs):
+        baked_output = outputs[job.artifact]
         stats["bakedSceneCount"] += 1
         baked_renderer_count, baked_atlas_count, baked_light_count = scene_bake_stats(baked_output)
         effective_scene = baked_output
@@ -278,36 +312,29 @@ def collect_baked_lighting_artifacts(scene_sources: list[Path], project_root: Pa
     return sorted(hdr_refs), sorted(ldr_refs)
 
 
-def cook_static_lightmaps(player_app: Path,
+def cook_static_lightmaps(graph: "CookGraph",
+                          player_app: Path,
                           repo_root: Path,
                           project_file: Path,
+                          project_data: dict,
                           baked_scene_sources: list[Path],
                           cooked_root: Path) -> dict[Path, Path]:
     static_lightmaps, ldr_artifacts = collect_baked_lighting_artifacts(baked_scene_sources, project_file.parent)
     if not static_lightmaps and not ldr_artifacts:
         return {}
 
-    executable = player_app / "Contents" / "MacOS" / "CrescentPlayer"
-    if not executable.exists():
-        raise FileNotFoundError(f"Cooker executable not found: {executable}")
-
-    project_root = project_file.parent
-    cooked_map: dict[Path, Path] = {}
+    executable = cooker_executable(player_app)
+    # (source, cooked output, job)
+    cooks: list[tuple[Path, Path, CookJob]] = []
     for source_path in static_lightmaps:
-        cooked_relative = relative_cooked_static_lightmap_path(project_root, source_path)
-        cooked_output = cooked_root / cooked_relative
-        cooked_output.parent.mkdir(parents=True, exist_ok=True)
-        run(
-            [
-                str(executable),
-                "--cook-static-lightmap",
-                str(project_file),
-                str(source_path),
-                str(cooked_output),
-            ],
-            cwd=project_root,
-        )
-        cooked_map[source_path] = cooked_output
+        cooked_relative = relative_cooked_static_lightmap_path(project_file.parent, source_path)
+        cooks.append((source_path, cooked_root / cooked_relative, CookJob(
+            artifact=f"static-lightmap:{graph.label(source_path)}",
+            dependencies=[source_path],
+            settings={**cook_settings(graph, project_data), "cook": "static-lightmap", "version": STATIC_LIGHTMAP_COOK_VERSION},
+            output_name=cooked_relative.name,
+            command=[str(executable), "--cook-static-lightmap", str(project_file), str(source_path), "{output}"],
+        )))
 
     basisu = basisu_path(repo_root)
     if ldr_artifacts:
@@ -315,25 +342,34 @@ def cook_static_lightmaps(player_app: Path,
             raise FileNotFoundError(f"basisu binary not found: {basisu}")
         for source_path in ldr_artifacts:
             cooked_relative = relative_baked_texture_cache_path(source_path)
-            cooked_output = cooked_root / cooked_relative
-            cooked_output.parent.mkdir(parents=True, exist_ok=True)
-            run(
-                build_basisu_command(
-                    basisu,
-                    source_path,
-                    cooked_output,
-                    srgb=False,
-                    normal_map=False,
-                    generate_mips=True,
-                ),
-                cwd=project_root,
+            command = build_basisu_command(
+                basisu,
+                source_path,
+                Path("{output}"),
+                srgb=False,
+                normal_map=False,
+                generate_mips=True,
             )
-            cooked_map[source_path] = cooked_output
-
-    return cooked_map
+            args = [arg for arg in command[1:] if arg not in (str(source_path), "{output}")]
+            cooks.append((source_path, cooked_root / cooked_relative, CookJob(
+                artifact=f"baked-texture:{graph.label(source_path)}",
+                dependencies=[source_path],
+                settings={"cook": "basisu", "version": KTX2_CACHE_VERSION, "args": args},
+                output_name=cooked_relative.name,
+                command=command,
+            )))
+
+    # Bakes reproduce identical lightmaps for unchanged scenes, so most of these come straight
+    # from the cache.
+    outputs = graph.cook_all([job for _, _, job in cooks])
+    for _, cooked_output, job in cooks:
+        cooked_output.parent.mkdir(parents=True, exist_ok=True)
+        shutil.copyfile(outputs[job.artifact], cooked_output)
+    return {source_path: cooked_output for source_path, cooked_output, _ in cooks}
 
 
-def cook_runtime_environments(player_app: Path,
+def cook_runtime_environments(graph: "CookGraph",
+                              player_app: Path,
                               project_file: Path,
                               project_data: dict,
                               environment_files: list[Path],
@@ -341,64 +377,94 @@ def cook_runtime_environments(player_app: Path,
     if not environment_files:
         return {}
 
-    executable = player_app / "Contents" / "MacOS" / "CrescentPlayer"
-    if not executable.exists():
-        raise FileNotFoundError(f"Cooker executable not found: {executable}")
-
+    executable = cooker_executable(player_app)
     project_root = project_file.parent
-    cooked_map: dict[Path, Path] = {}
+    cooks: list[tuple[Path, Path, CookJob]] = []
     for source_path in environment_files:
         cooked_relative = relative_cooked_environment_path(project_root, source_path, project_data)
-        cooked_output = cooked_root / cooked_relative
-        cooked_output.parent.mkdir(parents=True, exist_ok=True)
-        run(
-            [
-                str(executable),
-                "--cook-environment",
-                str(project_file),
-                str(source_path),
-                str(cooked_output),
-            ],
-            cwd=project_root,
-        )
+        cooks.append((source_path, cooked_root / cooked_relative, CookJob(
+            artifact=f"environment:{graph.label(source_path)}",
+            dependencies=[source_path],
+            settings={**cook_settings(graph, project_data), "cook": "environment", "version": ENV_CACHE_VERSION},
+            output_name=cooked_relative.name,
+            command=[str(executable), "--cook-environment", str(project_file), str(source_path), "{output}"],
+        )))
+
+    outputs = graph.cook_all([job for _, _, job in cooks])
+    cooked_map: dict[Path, Path] = {}
+    for source_path, cooked_output, job in cooks:
+        # The cook also leaves the BRDF LUT next to the environment.
+        copy_tree_if_exists(outputs[job.artifact].parent, cooked_output.parent)
         cooked_map[source_path] = cooked_output
     return cooked_map
 
 
-def cook_runtime_scenes(player_app: Path,
+def cook_runtime_scenes(graph: "CookGraph",
+                        player_app: Path,
                         project_file: Path,
+                        project_data: dict,
                         scene_files: list[Path],
                         source_scene_lookup: Optional[dict[Path, Path]],
                         cooked_root: Path) -> dict[str, str]:
     if not scene_files:
         return {}
 
-    executable = player_app / "Contents" / "MacOS" / "CrescentPlayer"
-    if not executable.exists():
-        raise FileNotFoundError(f"Cooker executable not found: {executable}")
-
+    executable = cooker_executable(player_app)
     project_root = project_file.parent
-    cooked_map: dict[str, str] = {}
+    cooks: list[tuple[Path, Path, CookJob]] = []
     for scene_path in scene_files:
         source_scene_path = source_scene_lookup.get(scene_path, scene_path) if source_scene_lookup else scene_path
         cooked_relative = relative_cooked_scene_path(project_root, scene_path)
-        cooked_output = cooked_root / cooked_relative
-        cooked_output.parent.mkdir(parents=True, exist_ok=True)
-        run(
-            [
-                str(executable),
-                "--cook-scene",
-                str(project_file),
-                str(source_scene_path),
-                str(cooked_output),
-            ],
-            cwd=project_root,
-        )
+        cooks.append((scene_path, cooked_relative, CookJob(
+            artifact=f"scene:{graph.label(scene_path)}",
+            dependencies=scene_dependencies(source_scene_path, project_root, project_data),
+            settings={**cook_settings(graph, project_data), "cook": "scene", "scene": graph.label(scene_path)},
+            output_name=cooked_relative.name,
+            command=[str(executable), "--cook-scene", str(project_file), str(source_scene_path), "{output}"],
+        )))
+
+    # Each scene cooks into its own directory, so its mesh and cell sidecars come along.
+    outputs = graph.cook_all([job for _, _, job in cooks])
+    cooked_map: dict[str, str] = {}
+    for scene_path, cooked_relative, job in cooks:
+        copy_tree_if_exists(outputs[job.artifact].parent, (cooked_root / cooked_relative).parent)
         cooked_map[scene_path.relative_to(project_root).as_posix()] = cooked_relative.as_posix()
 
     return cooked_map
 
 
+def cook_pipeline_archive(graph: "CookGraph",
+                          player_app: Path,
+                          project_file: Path,
+                          project_data: dict,
+                          scene_files: list[Path],
+                          source_scene_lookup: Optional[dict[Path, Path]],
+                          cooked_root: Path) -> Optional[Path]:
+    if not scene_files:
+        return None
+
+    executable = cooker_executable(player_app)
+    source_scene_paths = [
+        source_scene_lookup.get(scene_path, scene_path) if source_scene_lookup else scene_path
+        for scene_path in scene_files
+    ]
+    dependencies: set[Path] = set()
+    for path in source_scene_paths:
+        dependencies.update(scene_dependencies(path, project_file.parent, project_data))
+    job = CookJob(
+        artifact="pipeline-archive",
+        dependencies=sorted(dependencies),
+        settings={**cook_settings(graph, project_data), "cook": "pipeline-archive",
+                  "scenes": [graph.label(path) for path in source_scene_paths]},
+        output_name="Pipelines.metalarchive",
+        command=[str(executable), "--cook-pipeline-archive", str(project_file), "{output}",
+                 *[str(path) for path in source_scene_paths]],
+    )
+    cached_archive = graph.cook(job)
+    copy_tree_if_exists(cached_archive.parent, cooked_root)
+    return cooked_root / cached_archive.name
+
+
 def sha256_file(path: Path) -> str:
     digest = hashlib.sha256()
     with path.open("rb") as handle:
@@ -407,12 +473,235 @@ def sha256_file(path: Path) -> str:
     return digest.hexdigest()
 
 
+def write_atomically(output_path: Path, write) -> None:
+    # write(tmp_path) fills a temporary file next to the output, which then replaces it in one
+    # rename so no reader sees a partial file.
+    output_path.parent.mkdir(parents=True, exist_ok=True)
+    fd, tmp_name = tempfile.mkstemp(prefix=f".{output_path.name}.", suffix=".tmp" + output_path.suffix, dir=output_path.parent)
+    os.close(fd)
+    tmp_path = Path(tmp_name)
+    try:
+        write(tmp_path)
+        os.replace(tmp_path, output_path)
+    finally:
+        if tmp_path.exists():
+            tmp_path.unlink()
+
+
 def run(cmd: list[str], cwd: Optional[Path] = None) -> None:
     result = subprocess.run(cmd, cwd=cwd, text=True)
     if result.returncode != 0:
         raise RuntimeError(f"Command failed ({result.returncode}): {' '.join(cmd)}")
 
 
+class CookJob(NamedTuple):
+    artifact: str
+    dependencies: list[Path]
+    settings: dict
+    output_name: str
+    # Writes the artifact to "{output}"; the other files it leaves next to it are kept with it.
+    command: list[str]
+    # Jobs sharing a lane run one after another, in order.
+    lane: str = ""
+    # Decides whether a cached output still holds, for cooks with effects outside their output.
+    reusable: Optional[Callable[[Path], bool]] = None
+
+
+class CookGraph:
+    """Cooked artifacts keyed by the content of everything they were cooked from.
+
+    Each job's key hashes its settings and the files it depends on, and its outputs live in
+    Content/<key>/ in the project's import cache, so an unchanged artifact is never cooked twice
+    and the same inputs always give the same bytes. CookGraph.json remembers the file hashes by
+    size and mtime, and which keys the last build used so stale ones can be pruned.
+    """
+
+    def __init__(self, project_root: Path, content_dir: Path, cooker: str, jobs: int) -> None:
+        self.project_root = project_root
+        self.content_dir = content_dir
+        self.cooker = cooker
+        self.jobs = max(1, jobs)
+        self.cooked = 0
+        self.reused = 0
+        self._lock = threading.Lock()
+        self._files: dict[str, dict] = {}
+        self._artifacts: dict[str, dict] = {}
+        self._touched: set[str] = set()
+        try:
+            data = json.loads((content_dir / COOK_GRAPH_FILE).read_text(encoding="utf-8"))
+        except (OSError, json.JSONDecodeError):
+            data = {}
+        if data.get("version") == COOK_GRAPH_VERSION:
+            self._files = data.get("files", {})
+            self._artifacts = data.get("artifacts", {})
+
+    def label(self, path: Path) -> str:
+        try:
+            return path.resolve().relative_to(self.project_root.resolve()).as_posix()
+        except ValueError:
+            return path.resolve().as_posix()
+
+    def file_hash(self, path: Path) -> str:
+        label = self.label(path)
+        try:
+            stat = path.stat()
+        except OSError:
+            return "missing"
+        with self._lock:
+            entry = self._files.get(label)
+        if entry and entry.get("size") == stat.st_size and entry.get("mtimeNs") == stat.st_mtime_ns:
+            return entry["sha256"]
+        digest = sha256_file(path)
+        with self._lock:
+            self._files[label] = {"size": stat.st_size, "mtimeNs": stat.st_mtime_ns, "sha256": digest}
+        return digest
+
+    def content_key(self, job: CookJob) -> str:
+        dependencies = {self.label(path): self.file_hash(path) for path in job.dependencies}
+        payload = {"settings": job.settings, "dependencies": dependencies}
+        return hashlib.sha256(json.dumps(payload, sort_keys=True).encode("utf-8")).hexdigest()
+
+    def cook(self, job: CookJob) -> Path:
+        key = self.content_key(job)
+        cached_dir = self.content_dir / key
+        cached_output = cached_dir / job.output_name
+        if cached_output.exists() and (job.reusable is None or job.reusable(cached_output)):
+            with self._lock:
+                self.reused += 1
+        else:
+            # Cooked into a staging directory that replaces the cached one in a single rename.
+            self.content_dir.mkdir(parents=True, exist_ok=True)
+            staging_dir = Path(tempfile.mkdtemp(prefix=f".{key}.", dir=self.content_dir))
+            try:
+                staged_output = staging_dir / job.output_name
+                run([str(staged_output) if arg == "{output}" else arg for arg in job.command], cwd=self.project_root)
+                if not staged_output.exists():
+                    raise RuntimeError(f"Cook produced no output for {job.artifact}")
+                if cached_dir.exists():
+                    shutil.rmtree(cached_dir)
+                os.replace(staging_dir, cached_dir)
+            finally:
+                if staging_dir.exists():
+                    shutil.rmtree(staging_dir)
+            with self._lock:
+                self.cooked += 1
+        with self._lock:
+            self._artifacts[job.artifact] = {"key": key, "output": job.output_name}
+            self._touched.add(job.artifact)
+        return cached_output
+
+    def cook_all(self, jobs: list[CookJob]) -> dict[str, Path]:
+        # Independent jobs run side by side as separate processes.
+        lanes: dict[str, list[CookJob]] = {}
+        for index, job in enumerate(jobs):
+            lanes.setdefault(job.lane or f"#{index}", []).append(job)
+
+        def cook_lane(lane_jobs: list[CookJob]) -> list[tuple[str, Path]]:
+            return [(job.artifact, self.cook(job)) for job in lane_jobs]
+
+        outputs: dict[str, Path] = {}
+        with ThreadPoolExecutor(max_workers=self.jobs) as pool:
+            for results in pool.map(cook_lane, lanes.values()):
+                outputs.update(results)
+        return outputs
+
+    def save(self, prune: bool) -> None:
+        # Only a complete build knows every artifact still in use; a failed one keeps them all.
+        if prune:
+            self._artifacts = {name: entry for name, entry in self._artifacts.items() if name in self._touched}
+            live_keys = {entry["key"] for entry in self._artifacts.values()}
+            if self.content_dir.exists():
+                for path in self.content_dir.iterdir():
+                    # Directories only: Content also holds encode_textures.py's <key>.ktx2 files.
+                    if path.is_dir() and len(path.name) == 64 and path.name not in live_keys:
+                        shutil.rmtree(path, ignore_errors=True)
+        data = {"version": COOK_GRAPH_VERSION, "files": self._files, "artifacts": self._artifacts}
+        write_atomically(
+            self.content_dir / COOK_GRAPH_FILE,
+            lambda tmp: tmp.write_text(json.dumps(data, indent=2, sort_keys=True) + "\n", encoding="utf-8"),
+        )
+
+
+def cooker_executable(player_app: Path) -> Path:
+    executable = player_app / "Contents" / "MacOS" / "CrescentPlayer"
+    if not executable.exists():
+        raise FileNotFoundError(f"Cooker executable not found: {executable}")
+    return executable
+
+
+def cooker_fingerprint(player_app: Path) -> str:
+    # Everything the cooker runs: a rebuilt engine or shader library invalidates its cooks.
+    contents = player_app / "Contents"
+    paths = [path for root in (contents / "MacOS", contents / "Frameworks") if root.exists()
+             for path in root.rglob("*") if path.is_file() and not path.is_symlink()]
+    paths += (contents / "Resources").glob("*.metallib")
+    digest = hashlib.sha256()
+    for path in sorted(paths):
+        digest.update(path.relative_to(contents).as_posix().encode("utf-8"))
+        digest.update(sha256_file(path).encode("utf-8"))
+    return digest.hexdigest()
+
+
+def cook_settings(graph: CookGraph, project_data: dict) -> dict:
+    return {"cooker": graph.cooker, "project": project_data}
+
+
+def baked_lighting_dir(project_root: Path, scene_path: Path) -> Path:
+    try:
+        scene_data = json.loads(scene_path.read_text(encoding="utf-8"))
+    except (OSError, json.JSONDecodeError):
+        scene_data = {}
+    static_lighting = scene_data.get("sceneSettings", {}).get("staticLighting", {})
+    output_dir = static_lighting.get("outputDirectory") if isinstance(static_lighting, dict) else None
+    return (project_root / (output_dir or DEFAULT_BAKED_LIGHTING_DIR)).resolve()
+
+
+def collect_file_refs(value, search_roots: list[Path], out_paths: set[Path]) -> None:
+    if isinstance(value, dict):
+        for child in value.values():
+            collect_file_refs(child, search_roots, out_paths)
+        return
+
+    if isinstance(value, list):
+        for child in value:
+            collect_file_refs(child, search_roots, out_paths)
+        return
+
+    if isinstance(value, str) and value and len(value) < 1024 and ("/" in value or "." in value):
+        reference = value.split(EMBEDDED_MARKER, 1)[0]
+        for root in search_roots:
+            candidate = (root / reference).resolve()
+            if candidate.is_file():
+                out_paths.add(candidate)
+                break
+
+
+def scene_dependencies(scene_path: Path, project_root: Path, project_data: dict) -> list[Path]:
+    """The scene and every project file it references, through materials, with their import settings."""
+    asset_roots = [project_root / relative for relative in (project_data.get("assetPaths") or [project_data.get("assets", "Assets")])]
+    search_roots = [project_root, *asset_roots]
+    dependencies: set[Path] = {scene_path.resolve()}
+    pending = [scene_path.resolve()]
+    while pending:
+        path = pending.pop()
+        try:
+            data = json.loads(path.read_text(encoding="utf-8"))
+        except (OSError, UnicodeDecodeError, json.JSONDecodeError):
+            continue
+        refs: set[Path] = set()
+        collect_file_refs(data, search_roots, refs)
+        for ref in refs - dependencies:
+            dependencies.add(ref)
+            if ref.suffix.lower() in NESTED_REF_EXTS:
+                pending.append(ref)
+
+    for path in list(dependencies):
+        meta_path = path.with_name(path.name + ".cmeta")
+        if meta_path.exists():
+            dependencies.add(meta_path)
+    return sorted(dependencies)
+
+
 def basisu_path(repo_root: Path) -> Path:
     return repo_root / "ThirdParty" / "basisu" / "basisu"
 
@@ -613,9 +902,11 @@ def copy_packaged_import_cache(project_root: Path, project_data: dict, game_data
     for source_path in source_cache_dir.rglob("*"):
         if not source_path.is_file():
             continue
-        if source_path.suffix.lower() not in {".ktx2", ".cenv"}:
+        if source_path.suffix.lower() not in {".ktx2", ".cenv", ".cbrdf"}:
             continue
         relative_path = source_path.relative_to(source_cache_dir)
+        if relative_path.parts[0] == CONTENT_CACHE_DIR:
+            continue
         destination = packaged_cache_dir / relative_path
         destination.parent.mkdir(parents=True, exist_ok=True)
         shutil.copy2(source_path, destination)
@@ -834,7 +1125,8 @@ def package_game(repo_root: Path,
                  configuration: str,
                  output_dir: Path,
                  startup_scene_override: Optional[str],
-                 encode_textures: bool) -> Path:
+                 encode_textures: bool,
+                 jobs: int) -> Path:
     project_root = project_file.parent
     project_data = load_project(project_file)
     build_target = project_data.get("buildTarget", "macOS")
@@ -853,49 +1145,73 @@ def package_game(repo_root: Path,
         maybe_encode_textures(repo_root, project_file)
         validate_texture_caches(project_file, project_data)
 
+    library_dir = project_root / project_data.get("library", "Library")
     with tempfile.TemporaryDirectory(prefix="crescent-build-") as tmp_dir:
-        derived_data = Path(tmp_dir) / "DerivedData"
+        # Kept between builds so an unchanged engine builds to the same cooker, whose cooks stay valid.
+        derived_data = library_dir / "DerivedData"
         built_app = build_app(repo_root, configuration, derived_data)
-        cooked_environment_root = Path(tmp_dir) / "CookedEnvironment"
-        cooked_environment_map = cook_runtime_environments(
-            built_app,
-            project_file,
-            project_data,
-            environment_files,
-            cooked_environment_root,
-        )
-        print(f"Cooked environments: {len(cooked_environment_map)}")
-        baked_scenes_root = Path(tmp_dir) / "BakedScenes"
-        baked_source_scene_map, baked_stats = bake_source_scenes(
-            built_app,
-            project_file,
-            scene_files,
-            baked_scenes_root,
-        )
-        print(
-            "Baked lighting: "
-            f"{baked_stats['bakedAtlasCount']} atlases, "
-            f"{baked_stats['bakedRendererCount']} renderers, "
-            f"{baked_stats['bakedLightCount']} baked lights across "
-            f"{baked_stats['bakedSceneCount']} scenes."
-        )
-        cooked_static_lightmaps_root = Path(tmp_dir) / "CookedStaticLightmaps"
-        cooked_static_lightmap_map = cook_static_lightmaps(
-            built_app,
-            repo_root,
-            project_file,
-            list(baked_source_scene_map.values()),
-            cooked_static_lightmaps_root,
-        )
-        print(f"Cooked static lightmaps: {len(cooked_static_lightmap_map)}")
-        cooked_scenes_root = Path(tmp_dir) / "CookedScenes"
-        cooked_scene_map = cook_runtime_scenes(
-            built_app,
-            project_file,
-            scene_files,
-            baked_source_scene_map,
-            cooked_scenes_root,
-        )
+        graph = CookGraph(project_root, library_dir / "ImportCache" / CONTENT_CACHE_DIR, cooker_fingerprint(built_app), jobs)
+        cook_succeeded = False
+        try:
+            cooked_environment_root = Path(tmp_dir) / "CookedEnvironment"
+            cooked_environment_map = cook_runtime_environments(
+                graph,
+                built_app,
+                project_file,
+                project_data,
+                environment_files,
+                cooked_environment_root,
+            )
+            print(f"Cooked environments: {len(cooked_environment_map)}")
+            baked_source_scene_map, baked_stats = bake_source_scenes(
+                graph,
+                built_app,
+                project_file,
+                project_data,
+                scene_files,
+            )
+            print(
+                "Baked lighting: "
+                f"{baked_stats['bakedAtlasCount']} atlases, "
+                f"{baked_stats['bakedRendererCount']} renderers, "
+                f"{baked_stats['bakedLightCount']} baked lights across "
+                f"{baked_stats['bakedSceneCount']} scenes."
+            )
+            cooked_static_lightmaps_root = Path(tmp_dir) / "CookedStaticLightmaps"
+            cooked_static_lightmap_map = cook_static_lightmaps(
+                graph,
+                built_app,
+                repo_root,
+                project_file,
+                project_data,
+                list(baked_source_scene_map.values()),
+                cooked_static_lightmaps_root,
+            )
+            print(f"Cooked static lightmaps: {len(cooked_static_lightmap_map)}")
+            cooked_scenes_root = Path(tmp_dir) / "CookedScenes"
+            cooked_scene_map = cook_runtime_scenes(
+                graph,
+                built_app,
+                project_file,
+                project_data,
+                scene_files,
+                baked_source_scene_map,
+                cooked_scenes_root,
+            )
+            cooked_pipeline_archive = cook_pipeline_archive(
+                graph,
+                built_app,
+                project_file,
+                project_data,
+                scene_files,
+                baked_source_scene_map,
+                Path(tmp_dir) / "CookedPipelines",
+            )
+            cook_succeeded = True
+        finally:
+            graph.save(prune=cook_succeeded)
+        print(f"Cook graph: cooked {graph.cooked}, up to date {graph.reused}")
+        print(f"Cooked pipeline archive: {'yes' if cooked_pipeline_archive else 'no'}")
 
         output_dir.mkdir(parents=True, exist_ok=True)
         packaged_app = output_dir / f"{product_name}.app"
@@ -918,9 +1234,9 @@ def package_game(repo_root: Path,
         packaged_project_data["textureCookFormat"] = "KTX2_ASTC4x4"
         packaged_project_data["requireCookedScenes"] = bool(cooked_scene_map)
         packaged_project_data["sceneCookFormat"] = "MessagePackExternalMeshV1" if cooked_scene_map else ""
-        packaged_project_data["lightingBakeFormat"] = "LightmapRGBMKTX2DirectionalShadowmaskProbeReflections_V18"
+        packaged_project_data["lightingBakeFormat"] = "LightmapRGBMKTX2DirectionalShadowmaskProbeReflections_V19"
         packaged_project_data["requireCookedEnvironmentIBL"] = bool(cooked_environment_map)
-        packaged_project_data["environmentCookFormat"] = "CENV_RGBA16F_V1" if cooked_environment_map else ""
+        packaged_project_data["environmentCookFormat"] = "CENV_RGB9E5_V3" if cooked_environment_map else ""
         packaged_project_data["cookedScenes"] = cooked_scene_map
         with (game_data_dir / "Project.cproj").open("w", encoding="utf-8") as handle:
             json.dump(packaged_project_data, handle, indent=2)
@@ -935,6 +1251,10 @@ def package_game(repo_root: Path,
         )
         copy_tree_if_exists(cooked_static_lightmaps_root / "Library" / "ImportCache", game_data_dir / "Library" / "ImportCache")
         copy_tree_if_exists(cooked_environment_root / "Library" / "ImportCache", game_data_dir / "Library" / "ImportCache")
+        if cooked_pipeline_archive and cooked_pipeline_archive.exists():
+            shutil.copy2(cooked_pipeline_archive, game_data_dir / cooked_pipeline_archive.name)
+            shutil.copy2(cooked_pipeline_archive.with_name(cooked_pipeline_archive.name + ".keys"),
+                         game_data_dir / (cooked_pipeline_archive.name + ".keys"))
 
         manifest = build_manifest(game_data_dir, project_data, packaged_startup_scene)
         manifest_path = game_data_dir / "BuildManifest.json"
@@ -952,6 +1272,7 @@ def main() -> int:
     parser.add_argument("--output", default="", help="Output directory. Defaults to <Project>/Build/<Configuration>")
     parser.add_argument("--startup-scene", default="", help="Override startup scene relative to project root")
     parser.add_argument("--encode-textures", action="store_true", help="Run texture encoding before packaging")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1, help="Cook processes to run at once")
     args = parser.parse_args()
 
     repo_root = Path(__file__).resolve().parent.parent
@@ -972,6 +1293,7 @@ def main() -> int:
             output_dir=output_dir,
             startup_scene_override=args.startup_scene or None,
             encode_textures=args.encode_textures,
+            jobs=args.jobs,
         )
     except Exception as exc:
         print(str(exc), file=sys.stderr)
@@ -1,15 +1,22 @@
 #!/usr/bin/env python3
 import argparse
+import hashlib
 import json
 import os
+import shutil
 import subprocess
 import sys
+import tempfile
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
+from typing import NamedTuple, Optional
 
 
 LDR_EXTS = {".png", ".jpg", ".jpeg", ".tga", ".bmp", ".gif", ".tif", ".tiff"}
 KTX2_CACHE_VERSION = "v2a"
 EMBEDDED_MARKER = "#embedded:"
+# Encoded textures by content key, shared by every output with the same source and settings.
+CONTENT_CACHE_DIR = "Content"
 FNV64_OFFSET = 14695981039346656037
 FNV64_PRIME = 1099511628211
 
@@ -115,13 +122,88 @@ def ensure_embedded_sources(model_path: Path, embedded_sources_dir: Path, script
         raise RuntimeError(f"Failed to extract embedded textures for {model_path}:\n{result.stderr}")
 
 
-def should_encode(asset_path: Path, output_path: Path) -> bool:
+class EncodeJob(NamedTuple):
+    asset_path: Path
+    source_path: Path
+    output_path: Path
+    content_key: str
+    command: list[str]
+
+
+def content_key(source_path: Path, settings: dict) -> str:
+    # Source bytes plus everything that changes the encoded output, so a cooked texture is
+    # reused whenever both match, whatever the file times say.
+    digest = hashlib.sha256()
+    digest.update(json.dumps(settings, sort_keys=True).encode("utf-8"))
+    with source_path.open("rb") as handle:
+        for chunk in iter(lambda: handle.read(1024 * 1024), b""):
+            digest.update(chunk)
+    return digest.hexdigest()
+
+
+def key_path(output_path: Path) -> Path:
+    return output_path.with_name(output_path.name + ".key")
+
+
+def content_store_path(cache_dir: Path, key: str) -> Path:
+    return cache_dir / CONTENT_CACHE_DIR / f"{key}.ktx2"
+
+
+def write_atomically(output_path: Path, write) -> None:
+    # write(tmp_path) fills a temporary file in the destination directory, which then replaces
+    # the output in one rename, so readers never see a partial file.
+    output_path.parent.mkdir(parents=True, exist_ok=True)
+    fd, tmp_name = tempfile.mkstemp(prefix=f".{output_path.name}.", suffix=".tmp" + output_path.suffix, dir=output_path.parent)
+    os.close(fd)
+    tmp_path = Path(tmp_name)
+    try:
+        write(tmp_path)
+        os.replace(tmp_path, output_path)
+    finally:
+        if tmp_path.exists():
+            tmp_path.unlink()
+
+
+def is_cache_current(source_path: Path, output_path: Path, key: str) -> bool:
     if not output_path.exists():
-        return True
+        return False
+    recorded = key_path(output_path)
+    if recorded.exists():
+        if recorded.read_text(encoding="utf-8").strip() != key:
+            return False
+    else:
+        # Cooked before content keys existed: trust the file times once and adopt the key.
+        try:
+            if output_path.stat().st_mtime < source_path.stat().st_mtime:
+                return False
+        except OSError:
+            return False
+        write_atomically(recorded, lambda tmp: tmp.write_text(key, encoding="utf-8"))
+    # The engine still checks file times; keep the reused output newer than its source.
     try:
-        return output_path.stat().st_mtime < asset_path.stat().st_mtime
+        if output_path.stat().st_mtime < source_path.stat().st_mtime:
+            os.utime(output_path)
     except OSError:
-        return True
+        pass
+    return True
+
+
+def run_encode_job(job: EncodeJob, cache_dir: Path) -> Optional[str]:
+    store_path = content_store_path(cache_dir, job.content_key)
+    if not store_path.exists():
+        def encode(tmp_path: Path) -> None:
+            cmd = list(job.command)
+            cmd[cmd.index("-output_file") + 1] = str(tmp_path)
+            result = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+            if result.returncode != 0:
+                raise RuntimeError(result.stderr)
+        try:
+            write_atomically(store_path, encode)
+        except RuntimeError as exc:
+            return f"Failed: {job.asset_path}\n{exc}"
+    write_atomically(job.output_path, lambda tmp: shutil.copyfile(store_path, tmp))
+    write_atomically(key_path(job.output_path), lambda tmp: tmp.write_text(job.content_key, encoding="utf-8"))
+    return None
 
 
 def build_command(basisu: Path,
@@ -161,6 +243,7 @@ def main() -> int:
     parser = argparse.ArgumentParser(description="Encode CrescentEngine textures to KTX2 (ASTC-ready).")
     parser.add_argument("project", nargs="?", default=".", help="Project root or Project.cproj path")
     parser.add_argument("--basisu", default=os.environ.get("CRESCENT_BASISU_PATH", ""), help="Path to basisu binary")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1, help="Textures encoded in parallel")
     args = parser.parse_args()
 
     project_arg = Path(args.project).resolve()
@@ -181,8 +264,8 @@ def main() -> int:
         print(f"basisu binary not found: {basisu}", file=sys.stderr)
         return 1
 
-    encoded = 0
     skipped = 0
+    jobs: list[EncodeJob] = []
     extracted_models: set[Path] = set()
 
     for assets_dir in assets_dirs:
@@ -204,6 +287,11 @@ def main() -> int:
             normal_map = bool(import_settings.get("normalMap", False))
             flip_y = bool(import_settings.get("flipY", False))
             generate_mips = bool(import_settings.get("generateMipmaps", True))
+            settings = {
+                "version": KTX2_CACHE_VERSION,
+                "maxSize": import_settings.get("maxSize", 4096),
+                "args": build_command(basisu, Path("in"), Path("out"), srgb, normal_map, flip_y, generate_mips)[1:],
+            }
 
             source_path = asset_path
             if EMBEDDED_MARKER in asset_path.as_posix():
@@ -211,7 +299,9 @@ def main() -> int:
                 model_source = Path(asset_path.as_posix().split(EMBEDDED_MARKER, 1)[0])
                 if not model_source.exists():
                     continue
-                if not should_encode(model_source, output_path):
+                # Keyed on the model so unchanged models are not extracted again.
+                key = content_key(model_source, {**settings, "embedded": normalize_embedded_key(assets_dir, asset_path)})
+                if is_cache_current(model_source, output_path, key):
                     skipped += 1
                     continue
                 if model_source not in extracted_models:
@@ -227,16 +317,22 @@ def main() -> int:
                 if not asset_path.exists():
                     continue
                 output_path = cache_dir / f"{guid}_{KTX2_CACHE_VERSION}.ktx2"
-                if not should_encode(asset_path, output_path):
+                key = content_key(asset_path, settings)
+                if is_cache_current(asset_path, output_path, key):
                     skipped += 1
                     continue
 
             cmd = build_command(basisu, source_path, output_path, srgb, normal_map, flip_y, generate_mips)
-            result = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
-            if result.returncode != 0:
-                print(f"Failed: {asset_path}\n{result.stderr}", file=sys.stderr)
-                continue
-            encoded += 1
+            jobs.append(EncodeJob(asset_path, source_path, output_path, key, cmd))
+
+    # basisu runs as a separate process per texture, so threads are enough to fill every core.
+    encoded = 0
+    with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        for error in pool.map(lambda job: run_encode_job(job, cache_dir), jobs):
+            if error:
+                print(error, file=sys.stderr)
+            else:
+                encoded += 1
 
     print(f"Encoded {encoded} texture(s), skipped {skipped}.")
     return 0
@@ -65,6 +65,11 @@ build_cmake "$DEPS_DIR/assimp" "$DEPS_DIR/assimp-build-release" Release \
   -DASSIMP_INJECT_DEBUG_POSTFIX=OFF \
   -DBUILD_SHARED_LIBS=OFF
 
+# astcenc re-encodes cooked textures to ASTC footprints larger than the 4x4 BasisU transcodes to.
+build_cmake "$DEPS_DIR/astc-encoder" "$DEPS_DIR/astc-encoder-build" Release \
+  -DASTCENC_ISA_NATIVE=ON \
+  -DASTCENC_CLI=ON
+
 ASSIMP_CONFIG_SRC="$DEPS_DIR/assimp-build-release/include/assimp/config.h"
 ASSIMP_CONFIG_DST="$DEPS_DIR/assimp/include/assimp/config.h"
 if [ -f "$ASSIMP_CONFIG_SRC" ]; then